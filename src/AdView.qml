@@ -20,6 +20,15 @@ WebEngineView {
     settings.localStorageEnabled: true
     settings.autoLoadImages: true
 
+    // Chromium fetches the banner itself, so it keeps its own disk cache;
+    // unchanged scripts and images are revalidated instead of downloaded
+    profile: WebEngineProfile {
+        storageName: "AdBanner"
+        offTheRecord: false
+        httpCacheType: WebEngineProfile.DiskHttpCache
+        httpCacheMaximumSize: 32 * 1024 * 1024
+    }
+
     property string adHtml: `
         <!DOCTYPE html>
         <html>
@@ -46,9 +55,9 @@ WebEngineView {
     `
 
     function loadAd() {
-        console.log("--- AdView.qml: Loading Ad HTML ---");
-        console.log(adHtml);
-        console.log("--- AdView.qml: End Ad HTML ---");
+        // A refresh while the last one is still loading would only start it again
+        if (loading)
+            return;
         // Ensure webView context is used if calling methods on self
         webView.loadHtml(adHtml, "https://netpack.pt");
     }
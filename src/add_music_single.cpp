@@ -18,6 +18,10 @@
 #include "add_music_single.h"
 #include "ui_add_music_single.h"
 #include "addgenre.h"
+#include "services/ContentHash.h"
+#include "services/ExifToolPool.h"
+#include "services/MediaProbe.h"
+#include "services/TableChangeBus.h"
 #include <QFileDialog>
 //#include "connect.h"
 #include <QMessageBox>
@@ -66,11 +70,32 @@ add_music_single::add_music_single(QWidget *parent) :
 }
 
 
+void add_music_single::setGenreModel(QAbstractItemModel *model, int column)
+{
+    genreModel = model;
+    for (QComboBox *box : {ui->cbox_g1, ui->cbox_g2}) {
+        box->setModel(model);
+        box->setModelColumn(column);
+    }
+}
+
+void add_music_single::reset()
+{
+    ui->txt_file->clear();
+    ui->txt_artist->clear();
+    ui->txt_song->clear();
+}
+
 void add_music_single::updateGenres()
 {
+    // A shared genre model follows the table by itself
+    if (genreModel)
+        return;
+
 QSqlDatabase db = QSqlDatabase::database("xfb_connection");
-    QSqlQueryModel * model=new QSqlQueryModel();
-    QSqlQueryModel * model2=new QSqlQueryModel();
+    // Owned by the boxes, which delete them when given another model
+    QSqlQueryModel * model=new QSqlQueryModel(ui->cbox_g1);
+    QSqlQueryModel * model2=new QSqlQueryModel(ui->cbox_g2);
 
     QSqlQuery* qry=new QSqlQuery(db);
 
@@ -213,40 +238,47 @@ void add_music_single::on_pushButton_clicked()
 
     qDebug()<<"g1 is "<< g1 << " g2 is "<< g2<<" contry is "<<country;
 
-    QProcess cmd;
     QString time;
-    QString cmdtmpstr = "exiftool \""+file+"\" | grep Duration";
-    cmd.start("sh",QStringList()<<"-c"<<cmdtmpstr);
-    cmd.waitForFinished();
-    QString cmdOut = cmd.readAll();
-    qDebug()<<"Output of exiftool from youtubedownloader: "<<cmdOut;
-    cmd.close();
-
-    QStringList arraycmd = cmdOut.split(" ");
-    if(arraycmd.count()>25){
-        QStringList splitarray = arraycmd[25].split("\n");
-        qDebug()<<"Total track time is: "<<splitarray[0];
-        time = splitarray[0];
-
+    MediaProbe::ProbeResult probe = MediaProbe::probe(file);
+    if(probe.isValid){
+        time = probe.durationString();
     } else {
-        qDebug()<<"-------------->>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>     !!!!!!!!    An exception happend !? ... outputing details of this track: ";
-        for(int i=0;i<arraycmd.count();i++){
-            qDebug()<< "The array position "<<i<<" has: "<<arraycmd[i];
-        }
-
-
-
-}
+        //a format the probe does not know; asked to the exiftool that stays running
+        time = ExifToolPool::instance()->duration(file);
+    }
+    qDebug()<<"Total track time is: "<<time;
     QSqlDatabase db = QSqlDatabase::database("xfb_connection");
-    QSqlQuery sql(db);
-
 
-        QString sqlquery = "insert into musics values(NULL,'"+artist+"','"+song+"','"+g1+"','"+g2+"','"+country+"','"+data_ano+"','"+file+"','"+time+"',0,'-')";
+    //the same audio may already be in the db under another path or with other tags
+    QString contentHash = ContentHash::ofFile(file);
+    if(!contentHash.isEmpty()){
+        QSqlQuery copy(db);
+        copy.prepare("SELECT artist, song, path FROM musics WHERE content_hash=:hash LIMIT 1");
+        copy.bindValue(":hash",contentHash);
+        if(copy.exec() && copy.next()){
+            QMessageBox::information(this,tr("Save"),tr("This track is already in the database as %1 - %2\n\n%3")
+                                     .arg(copy.value(0).toString(),copy.value(1).toString(),copy.value(2).toString()));
+            return;
+        }
+    }
 
+    QSqlQuery sql(db);
+        sql.prepare("insert into musics (artist,song,genre1,genre2,country,published_date,path,time,played_times,last_played,content_hash) "
+                    "values(:artist,:song,:g1,:g2,:country,:pub_date,:file,:time,0,'-',:hash)");
+        sql.bindValue(":artist",artist);
+        sql.bindValue(":song",song);
+        sql.bindValue(":g1",g1);
+        sql.bindValue(":g2",g2);
+        sql.bindValue(":country",country);
+        sql.bindValue(":pub_date",data_ano);
+        sql.bindValue(":file",file);
+        sql.bindValue(":time",time);
+        sql.bindValue(":hash",contentHash.isEmpty() ? QVariant() : QVariant(contentHash));
 
-        if(sql.exec(sqlquery))
+        if(sql.exec())
         {
             qDebug() << "last sql: " << sql.lastQuery();
+            TableChangeBus::instance()->notifyChanged("musics", {sql.lastInsertId().toLongLong()});
             QMessageBox::information(this,tr("Save"),tr("Music Added!"));
             connClose();
             this->hide();
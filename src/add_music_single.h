@@ -22,6 +22,10 @@
 #include <QtSql>
 #include <QtDebug>
 #include <QFileInfo>
+#include <QPointer>
+
+class QAbstractItemModel;
+
 namespace Ui {
 class add_music_single;
 }
@@ -39,6 +43,11 @@ public:
 
     explicit add_music_single(QWidget *parent = 0);
     ~add_music_single();
+
+    // Genre lists from a model kept up to date elsewhere, instead of a query per opening
+    void setGenreModel(QAbstractItemModel *model, int column);
+    // Clears the file and tags, for the next track; the dialog is kept between openings
+    void reset();
     
 private slots:
     void on_toolButton_clicked();
@@ -49,6 +58,7 @@ private slots:
 
 private:
     Ui::add_music_single *ui;
+    QPointer<QAbstractItemModel> genreModel;
 };
 
 #endif // ADD_MUSIC_SINGLE_H
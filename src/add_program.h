@@ -4,6 +4,9 @@
 #include <QDialog>
 #include <QtSql>
 
+class SchedulerEngine;
+struct ScheduleRule;
+
 namespace Ui {
 class add_program;
 }
@@ -16,6 +19,9 @@ public:
     explicit add_program(QWidget *parent = 0);
     ~add_program();
 
+    /// Rules added are checked against this engine's, and reloaded into it
+    void setSchedulerEngine(SchedulerEngine* engine) { schedulerEngine = engine; }
+
 private slots:
     void on_pushButton_3_clicked();
     void updateScheduleTable();
@@ -27,8 +33,11 @@ private slots:
     void on_pushButton_5_clicked();
 
 private:
+    bool confirmSchedule(const ScheduleRule& rule);
+
     Ui::add_program *ui;
     QString pub_id;
+    SchedulerEngine* schedulerEngine = nullptr;
 };
 
 #endif // ADD_PROGRAM_H
@@ -21,6 +21,7 @@
 #include <QMessageBox>
 #include "add_pub.h"
 #include "ui_add_pub.h"
+#include "services/SchedulerEngine.h"
 
 add_pub::add_pub(QWidget *parent) :
     QDialog(parent),
@@ -133,6 +134,17 @@ void add_pub::on_pushButton_4_clicked()
 
             qDebug () << "hora1: " << hora1 << "min1: "<< min1;
 
+        //warn if it would air over another pub or program
+            ScheduleRule rule;
+            rule.type = ScheduleRule::Type::Once;
+            rule.at = QDateTime(QDate(ano1.toInt(), mes1.toInt(), dia1.toInt()),
+                                QTime(hora1.toInt(), min1.toInt()));
+            rule.isProgram = false;
+            rule.path = ui->txt_selected_file->text();
+            if (!confirmSchedule(rule)) {
+                return;
+            }
+
 
 
         //prepare the query
@@ -143,6 +155,9 @@ void add_pub::on_pushButton_4_clicked()
 
         //add to scheduler
             qry_add.exec();
+            if (schedulerEngine) {
+                schedulerEngine->reload();
+            }
 
             qDebug () << qry_add.lastQuery();
 
@@ -245,10 +260,24 @@ QSqlQuery Q(db);
 
     qDebug()<<"Array splitted hours: "<<hora<<" and minutes: "<<min;
 
+    ScheduleRule rule;
+    rule.type = ScheduleRule::Type::Weekly;
+    rule.dayOfWeek = SchedulerEngine::dayOfWeekFromName(dayOfTheWeek);
+    rule.hour = hora.toInt();
+    rule.minute = min.toInt();
+    rule.isProgram = false;
+    rule.path = ui->txt_selected_file->text();
+    if (!confirmSchedule(rule)) {
+        return;
+    }
+
     QSqlQuery Qr_add(db);
     Qr_add.prepare("insert into scheduler values ('"+thisPubId+"',NULL,NULL,NULL,'"+hora+"','"+min+"','2','"+dayOfTheWeek+"',NULL,NULL,NULL,NULL,NULL,NULL,'0')");
 
     Qr_add.exec();
+    if (schedulerEngine) {
+        schedulerEngine->reload();
+    }
     qDebug()<<"Last Query: "<<Qr_add.lastQuery();
     QString str = dayOfTheWeek + " at " + hourMinute;
     ui->listWidget->addItem(str);
@@ -311,3 +340,28 @@ void add_pub::on_pushButton_5_clicked()
     delete ui->listWidget->item(g);
 
 }
+
+bool add_pub::confirmSchedule(const ScheduleRule& rule)
+{
+    if (!schedulerEngine) {
+        return true;
+    }
+    const QList<ScheduleRule> others = schedulerEngine->conflicts(rule);
+    if (others.isEmpty()) {
+        return true;
+    }
+
+    const int shown = 10;
+    QStringList lines;
+    for (int i = 0; i < others.size() && i < shown; ++i) {
+        lines << SchedulerEngine::describe(others[i]);
+    }
+    if (others.size() > shown) {
+        lines << QString("and %1 more").arg(others.size() - shown);
+    }
+    const QString message = QString("%1 would air over:\n\n%2\n\nSchedule it anyway?")
+                                .arg(SchedulerEngine::describe(rule), lines.join("\n"));
+    return QMessageBox::warning(this, "Schedule conflict", message,
+                                QMessageBox::Yes | QMessageBox::No, QMessageBox::No)
+           == QMessageBox::Yes;
+}
@@ -21,6 +21,9 @@
 #include <QDialog>
 #include <QtSql>
 
+class SchedulerEngine;
+struct ScheduleRule;
+
 namespace Ui {
 class add_pub;
 }
@@ -33,6 +36,9 @@ public:
     explicit add_pub(QWidget *parent = 0);
     ~add_pub();
 
+    /// Rules added are checked against this engine's, and reloaded into it
+    void setSchedulerEngine(SchedulerEngine* engine) { schedulerEngine = engine; }
+
 private slots:
     void on_pushButton_3_clicked();
     void updateScheduleTable();
@@ -44,8 +50,11 @@ private slots:
     void on_pushButton_5_clicked();
 
 private:
+    bool confirmSchedule(const ScheduleRule& rule);
+
     Ui::add_pub *ui;
     QString pub_id;
+    SchedulerEngine* schedulerEngine = nullptr;
 
 };
 
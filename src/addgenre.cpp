@@ -17,6 +17,7 @@
     */
 #include "addgenre.h"
 #include "ui_addgenre.h"
+#include "services/TableChangeBus.h"
 #include <QFileDialog>
 #include <QFile>
 #include <QMessageBox>
@@ -28,6 +29,7 @@
 #include <QDragEnterEvent>
 #include <QDragMoveEvent>
 #include <QtSql>
+#include <QCompleter>
 
 addgenre::addgenre(QWidget *parent) :
     QDialog(parent),
@@ -65,6 +67,11 @@ QSqlDatabase db = QSqlDatabase::database("xfb_connection");
     model->setQuery(*qry);
     ui->listGenres->setModel(model);
 
+    // Suggest the genres already listed while a new one is typed, so near-duplicates stand out
+    QCompleter* completer = new QCompleter(model, this);
+    completer->setCaseSensitivity(Qt::CaseInsensitive);
+    ui->txtNewGenre->setCompleter(completer);
+
 
 }
 
@@ -83,6 +90,7 @@ QSqlDatabase db = QSqlDatabase::database("xfb_connection");
     qry->exec();
     model->setQuery(*qry);
     ui->listGenres->setModel(model);
+    ui->txtNewGenre->completer()->setModel(model);
 }
 
 void addgenre::on_btDelGenre_clicked()
@@ -99,6 +107,7 @@ void addgenre::on_btDelGenre_clicked()
 
        if(qry->exec()){
             qDebug() << "Genre deleted from genres1";
+            TableChangeBus::instance()->notifyReset("genres1");
        } else {
            qDebug() << "Genre *NOT* deleted from genres1"<< qry->lastError() << qry->lastQuery();
        }
@@ -129,7 +138,9 @@ QSqlDatabase db = QSqlDatabase::database("xfb_connection");
 
         qry->prepare("insert into genres1 values (NULL,:thgName)");
         qry->bindValue(":thgName",genreName);
-        qry->exec();
+        if(qry->exec())
+            TableChangeBus::instance()->notifyChanged("genres1",
+                                                      {qry->lastInsertId().toLongLong()});
 
     QMessageBox::information(this,"Add genre","Genre Added!");
 }
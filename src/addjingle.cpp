@@ -17,6 +17,7 @@
     */
 #include "addjingle.h"
 #include "ui_addjingle.h"
+#include "services/TableChangeBus.h"
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QtSql>
@@ -87,6 +88,7 @@ void addJingle::on_pushButton_clicked()
     if(sql.exec())
     {
         qDebug() << "Sql for insert is: " << sql.lastQuery();
+        TableChangeBus::instance()->notifyChanged("jingles", {sql.lastInsertId().toLongLong()});
         QMessageBox::information(this,tr("Save"),tr("Jingle Added!"));
         adb.close();
         this->hide();
@@ -44,12 +44,12 @@
 #include <QDateTime>
 #include <QDebug>
 #include <QPainter>
+#include <QTimer>
 #include <QVBoxLayout>
 #include <QMediaDevices> // Qt6 replacement for QAudioDeviceInfo
 #include <QAudioDevice> // Qt6 audio device representation
 #include <QAudioInput>
 #include <QAudioSource>
-#include <qendian.h>
 
 #include "audioinput.h"
 
@@ -59,44 +59,13 @@
 #define RESUME_LABEL    "Resume recording"
 
 const int BufferSize = 4096;
+const int DisplayIntervalMs = 40; // 25 frames per second
 
 AudioInfo::AudioInfo(const QAudioFormat &format, QObject *parent)
     :   QIODevice(parent)
     ,   m_format(format)
-    ,   m_maxAmplitude(0)
-    ,   m_level(0.0)
-
+    ,   m_meter(format)
 {
-    // In Qt6, sample format handling has changed
-    // We need to determine max amplitude based on sample format
-    
-    int sampleSize = m_format.bytesPerSample() * 8; // Get sample size in bits
-    QAudioFormat::SampleFormat sampleFormat = m_format.sampleFormat();
-    
-    switch (sampleSize) {
-    case 8:
-        if (sampleFormat == QAudioFormat::UInt8)
-            m_maxAmplitude = 255;
-        // Qt6 doesn't have Int8 format
-        break;
-        
-    case 16:
-        if (sampleFormat == QAudioFormat::Int16)
-            m_maxAmplitude = 32767;
-        // Qt6 doesn't have UInt16 format
-        break;
-
-    case 32:
-        if (sampleFormat == QAudioFormat::Int32)
-            m_maxAmplitude = 0x7fffffff;
-        else if (sampleFormat == QAudioFormat::Float)
-            m_maxAmplitude = 0x7fffffff; // Kind of
-        // Qt6 doesn't have UInt32 format
-        break;
-
-    default:
-        break;
-    }
 }
 
 AudioInfo::~AudioInfo()
@@ -111,6 +80,7 @@ void AudioInfo::start()
 void AudioInfo::stop()
 {
     QIODevice::close();
+    m_meter.reset();
 }
 
 qint64 AudioInfo::readData(char *data, qint64 maxlen)
@@ -123,45 +93,9 @@ qint64 AudioInfo::readData(char *data, qint64 maxlen)
 
 qint64 AudioInfo::writeData(const char *data, qint64 len)
 {
-    if (m_maxAmplitude) {
-        // In Qt6, we use bytesPerSample() instead of sampleSize()/8
-        const int channelBytes = m_format.bytesPerSample();
-        const int sampleBytes = m_format.channelCount() * channelBytes;
-        Q_ASSERT(len % sampleBytes == 0);
-        const int numSamples = len / sampleBytes;
-
-        quint32 maxValue = 0;
-        const unsigned char *ptr = reinterpret_cast<const unsigned char *>(data);
-
-        for (int i = 0; i < numSamples; ++i) {
-            for (int j = 0; j < m_format.channelCount(); ++j) {
-                quint32 value = 0;
-                QAudioFormat::SampleFormat sampleFormat = m_format.sampleFormat();
-                int sampleSize = m_format.bytesPerSample() * 8; // Get sample size in bits
-                
-                // Handle different sample formats in Qt6
-                if (sampleSize == 8 && sampleFormat == QAudioFormat::UInt8) {
-                    value = *reinterpret_cast<const quint8*>(ptr);
-                } else if (sampleSize == 16 && sampleFormat == QAudioFormat::Int16) {
-                    // In Qt6, we always use native endianness
-                    value = qAbs(*reinterpret_cast<const qint16*>(ptr));
-                } else if (sampleSize == 32 && sampleFormat == QAudioFormat::Int32) {
-                    // In Qt6, we always use native endianness
-                    value = qAbs(*reinterpret_cast<const qint32*>(ptr));
-                } else if (sampleSize == 32 && sampleFormat == QAudioFormat::Float) {
-                    value = qAbs(*reinterpret_cast<const float*>(ptr) * 0x7fffffff); // assumes 0-1.0
-                }
-
-                maxValue = qMax(value, maxValue);
-                ptr += channelBytes;
-            }
-        }
-
-        maxValue = qMin(maxValue, m_maxAmplitude);
-        m_level = qreal(maxValue) / m_maxAmplitude;
-    }
-
-    emit update();
+    // UInt8, Int16, Int32 and Float, any number of channels, vectorized
+    // where the CPU allows; the levels are published through atomics
+    m_meter.process(data, len);
     return len;
 }
 
@@ -198,6 +132,8 @@ void RenderArea::paintEvent(QPaintEvent * /* event */)
 
 void RenderArea::setLevel(qreal value)
 {
+    if (value == m_level)
+        return;
     m_level = value;
     update();
 }
@@ -215,6 +151,7 @@ InputTest::InputTest()
     ,   m_input(0)
     ,   m_pullMode(false)
     ,   m_buffer(BufferSize, 0)
+    ,   m_displayTimer(new QTimer(this))
 {
     initializeWindow();
     initializeAudio();
@@ -282,7 +219,9 @@ void InputTest::initializeAudio()
     }
 
     m_audioInfo  = new AudioInfo(m_format, this);
-    connect(m_audioInfo, SIGNAL(update()), SLOT(refreshDisplay()));
+    m_displayTimer->setInterval(DisplayIntervalMs);
+    connect(m_displayTimer, SIGNAL(timeout()), SLOT(refreshDisplay()));
+    m_displayTimer->start();
 
     createAudioInput();
 }
@@ -361,7 +300,7 @@ void InputTest::toggleSuspend()
 
 void InputTest::refreshDisplay()
 {
-    m_canvas->setLevel(m_audioInfo->level());
+    m_canvas->setLevel(m_audioInfo->takeLevel());
 }
 
 void InputTest::deviceChanged(int index)
@@ -55,6 +55,10 @@
 #include <QIODevice> // Explicitly include QIODevice
 #include <QSlider>
 #include <QWidget>
+
+#include "services/LevelMeter.h"
+
+class QTimer;
 /*
 template<T>
 T add(T a, Tb)
@@ -73,18 +77,18 @@ public:
     void start();
     void stop();
 
-    qreal level() const { return m_level; }
+    // Peak of the last buffer, 0.0 <= level() <= 1.0; safe to call from any thread
+    qreal level() const { return qMin(1.0f, m_meter.peak()); }
+    // Highest peak since the last call, for a display polled at its frame rate
+    qreal takeLevel() { return qMin(1.0f, m_meter.takePeak()); }
+    const LevelMeter &meter() const { return m_meter; }
 
     qint64 readData(char *data, qint64 maxlen);
     qint64 writeData(const char *data, qint64 len);
 
 private:
     const QAudioFormat m_format;
-    quint32 m_maxAmplitude;
-    qreal m_level; // 0.0 <= m_level <= 1.0
-
-signals:
-    void update();
+    LevelMeter m_meter;
 };
 
 
@@ -143,6 +147,7 @@ private:
     QIODevice *m_input;
     bool m_pullMode;
     QByteArray m_buffer;
+    QTimer *m_displayTimer; // Repaints the meter; the audio never waits for it
 };
 
 #endif // AUDIOINPUT_H
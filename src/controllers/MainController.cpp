@@ -4,6 +4,10 @@
 #include "../services/DatabaseService.h"
 #include "../services/ConfigurationService.h"
 #include "../services/AccessibilityManager.h"
+#include "../services/AudioFeedbackService.h"
+#include "../services/LiveRegionManager.h"
+#include "../services/PlaybackStatusAnnouncer.h"
+#include "../services/SystemStatusAnnouncer.h"
 #include "../repositories/MusicRepository.h"
 #include "../repositories/PlaylistRepository.h"
 #include "../repositories/GenreRepository.h"
@@ -83,6 +87,7 @@ void MainController::shutdown()
 
     hideProgressDialog();
     
+    BaseService::stopHealthChecks();
     if (m_serviceContainer) {
         m_serviceContainer->shutdownServices();
     }
@@ -404,37 +409,33 @@ void MainController::setupServices()
     m_serviceContainer->registerSingleton<ConfigurationService>();
     m_serviceContainer->registerSingleton<AudioService>();
     m_serviceContainer->registerSingleton<AccessibilityManager>();
+    // Made by AccessibilityManager::activate() only, once an assistive technology connects
+    m_serviceContainer->registerSingleton<AudioFeedbackService>();
+    m_serviceContainer->registerSingleton<LiveRegionManager>();
+    m_serviceContainer->registerSingleton<PlaybackStatusAnnouncer>();
+    m_serviceContainer->registerSingleton<SystemStatusAnnouncer>();
     
-    // Initialize critical services first
-    qDebug() << "MainController: Initializing critical services...";
+    // ConfigurationService only touches QSettings under its own lock, so it loads
+    // on a worker thread while the database opens its connection on this one
+    m_serviceContainer->initializeConcurrently<ConfigurationService>();
     
-    // Initialize database and configuration services synchronously (they're fast)
+    // Initialize critical services first; AccessibilityManager is cheap until
+    // an assistive technology connects
+    qDebug() << "MainController: Initializing critical services...";
+    m_serviceContainer->initializeServicesFor<DatabaseService, ConfigurationService,
+                                              AccessibilityManager>();
     auto* dbService = m_serviceContainer->resolve<DatabaseService>();
-    auto* configService = m_serviceContainer->resolve<ConfigurationService>();
-    
-    if (dbService) {
-        dbService->initialize();
-    }
-    if (configService) {
-        configService->initialize();
-    }
     
-    // Initialize accessibility manager (important but should be fast)
-    auto* accessibilityMgr = m_serviceContainer->resolve<AccessibilityManager>();
-    if (accessibilityMgr) {
-        accessibilityMgr->initialize();
-    }
-    
-    // Initialize AudioService asynchronously to avoid blocking startup
+    // Initialize AudioService from the event loop to avoid blocking startup
     qDebug() << "MainController: Starting AudioService initialization in background...";
-    QTimer::singleShot(100, this, [this]() {
-        auto* audioSvc = m_serviceContainer->resolve<AudioService>();
-        if (audioSvc) {
-            qDebug() << "MainController: Initializing AudioService asynchronously...";
-            audioSvc->initialize();
-            qDebug() << "MainController: AudioService initialization completed";
-        }
-    });
+    connect(m_serviceContainer, &ServiceContainer::servicesInitialized, this,
+            [](bool success) {
+                qDebug() << "MainController: Background service initialization completed."
+                         << "Success:" << success;
+            });
+    m_serviceContainer->initializeServicesInBackground<AudioService>();
+    // Checks the services as they come up, AudioService included
+    BaseService::startHealthChecks();
     
     // Create repositories manually since they don't inherit from IService
     // Reuse the dbService already declared above
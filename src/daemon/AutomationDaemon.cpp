@@ -0,0 +1,520 @@
+#include "AutomationDaemon.h"
+#include "../repositories/LibraryChangeLog.h"
+#include "../repositories/NowPlayingStatus.h"
+#include "../services/AutomationClock.h"
+#include "../services/BroadcastWorker.h"
+#include "../services/HourGenreSchedule.h"
+#include "../services/LibraryReplica.h"
+#include "../services/LogCategories.h"
+#include "../services/Logger.h"
+#include "../services/MetricsRegistry.h"
+#include "../services/MetricsServer.h"
+#include "../services/PlayHistoryWriter.h"
+#include "../services/PlaybackEngine.h"
+#include "../services/RemoteControlServer.h"
+#include "../services/RotationEngine.h"
+#include "../services/SchedulerEngine.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSettings>
+#include <QSqlError>
+#include <QStandardPaths>
+#include <QTimer>
+#include <csignal>
+#include <cstring>
+
+namespace {
+
+volatile std::sig_atomic_t stopRequested = 0;
+
+extern "C" void requestStop(int)
+{
+    stopRequested = 1;
+}
+
+const char* stateName(PlaybackEngine::State state)
+{
+    switch (state) {
+    case PlaybackEngine::State::Playing:
+        return "playing";
+    case PlaybackEngine::State::Paused:
+        return "paused";
+    case PlaybackEngine::State::Stopped:
+        break;
+    }
+    return "stopped";
+}
+
+} // namespace
+
+bool AutomationDaemon::isRequested(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], DAEMON_OPTION) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int AutomationDaemon::exec(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    // Same names as the window, so QStandardPaths finds the same files
+    QCoreApplication::setApplicationName("XFB");
+    QCoreApplication::setOrganizationName("Netpack - Online Solutions");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        QCoreApplication::translate("AutomationDaemon", "XFB automation without the window"));
+    parser.addHelpOption();
+    parser.addOption(QCommandLineOption(
+        QStringLiteral("daemon"),
+        QCoreApplication::translate("AutomationDaemon", "Run headless (implied by xfbd)")));
+    QCommandLineOption configOption(
+        QStringLiteral("config"),
+        QCoreApplication::translate("AutomationDaemon", "Settings file to use instead of xfb.conf"),
+        QStringLiteral("file"), defaultConfigFile());
+    parser.addOption(configOption);
+    parser.process(app);
+
+    AutomationDaemon daemon;
+    if (!daemon.start(parser.value(configOption))) {
+        return 1;
+    }
+
+    // Signal handlers may only set a flag; the event loop looks at it
+    std::signal(SIGINT, requestStop);
+    std::signal(SIGTERM, requestStop);
+    QTimer signalPoll;
+    QObject::connect(&signalPoll, &QTimer::timeout, &app, [&daemon]() {
+        if (stopRequested) {
+            qCInfo(xfbPlayer) << "Stop requested, leaving the air";
+            daemon.stop();
+            QCoreApplication::quit();
+        }
+    });
+    signalPoll.start(SIGNAL_POLL_MS);
+
+    return app.exec();
+}
+
+QString AutomationDaemon::defaultConfigFile()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppConfigLocation) + "/xfb.conf";
+}
+
+QString AutomationDaemon::defaultDatabaseFile()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/"
+           + QCoreApplication::applicationName() + "/adb.db";
+}
+
+AutomationDaemon::AutomationDaemon(QObject* parent)
+    : QObject(parent)
+{
+}
+
+AutomationDaemon::~AutomationDaemon()
+{
+    stop();
+    // The worker and the engines query the connection; they go first
+    delete m_broadcast;
+    delete m_history;
+    delete m_nowPlaying;
+    delete m_scheduler;
+    delete m_rotation;
+    delete m_hourGenres;
+    delete m_engine;
+    m_broadcast = nullptr;
+    m_history = nullptr;
+    m_nowPlaying = nullptr;
+    m_scheduler = nullptr;
+    m_rotation = nullptr;
+    m_hourGenres = nullptr;
+    m_engine = nullptr;
+
+    if (m_database.isValid()) {
+        const QString connection = m_database.connectionName();
+        m_database.close();
+        m_database = QSqlDatabase();
+        QSqlDatabase::removeDatabase(connection);
+    }
+}
+
+AutomationClock* AutomationDaemon::clock() const
+{
+    return m_clock ? m_clock.data() : AutomationClock::wallClock();
+}
+
+bool AutomationDaemon::start(const QString& configFilePath)
+{
+    startLogging();
+
+    if (!QFileInfo::exists(configFilePath)) {
+        qCCritical(xfbPlayer) << "Settings file" << configFilePath
+                              << "does not exist; run XFB once to create it";
+        return false;
+    }
+    QSettings settings(configFilePath, QSettings::IniFormat);
+
+    if (!openDatabase(defaultDatabaseFile())) {
+        return false;
+    }
+
+    m_role = settings.value("Role", "Client").toString();
+    m_startedAt = clock()->now();
+
+    m_engine = new PlaybackEngine(this);
+    m_engine->setCrossfadeDuration(settings.value("Crossfade_Ms", 3000).toInt());
+    m_engine->setPrefetchSeconds(settings.value("Prefetch_Seconds", 20).toInt());
+    m_engine->setOutputDevice(settings.value("OnAir_Device").toString());
+    if (settings.value("Native_Audio", false).toBool()) {
+        NativeAudioOutput::Config native;
+        native.device = settings.value("Native_Audio_Device", "default").toString();
+        native.periodFrames = settings
+                                  .value("Native_Audio_Period_Frames",
+                                         NativeAudioOutput::DEFAULT_PERIOD_FRAMES)
+                                  .toInt();
+        native.periods =
+            settings.value("Native_Audio_Periods", NativeAudioOutput::DEFAULT_PERIODS).toInt();
+        m_engine->setNativeOutput(native);
+    }
+    connect(m_engine, &PlaybackEngine::trackStarted, this, &AutomationDaemon::onTrackStarted);
+    connect(m_engine, &PlaybackEngine::nextTrackRequested, this,
+            &AutomationDaemon::onNextTrackRequested);
+    connect(m_engine, &PlaybackEngine::playbackFinished, this,
+            &AutomationDaemon::onPlaybackFinished);
+    connect(m_engine, &PlaybackEngine::errorOccurred, this, [](const QString& message) {
+        qCWarning(xfbPlayback) << "Playback error:" << message;
+    });
+
+    m_history = new PlayHistoryWriter(m_database, this);
+    m_nowPlaying = new NowPlayingStatus(m_database);
+    m_nowPlaying->ensureTable();
+    m_hourGenres = new HourGenreSchedule(m_database, this);
+    m_rotation = new RotationEngine(m_database, this);
+    m_rotation->setClock(m_clock);
+    m_rotation->setSeparation(
+        settings.value("Rotation_Separation", RotationEngine::DEFAULT_SEPARATION).toInt());
+    m_rotation->setArtistSeparation(settings.value("Rotation_Artist_Separation_Min", 60).toInt());
+    m_rotation->setTitleSeparation(settings.value("Rotation_Title_Separation_Min", 180).toInt());
+
+    m_scheduler = new SchedulerEngine(m_database, this);
+    m_scheduler->setClock(m_clock);
+    connect(m_scheduler, &SchedulerEngine::eventDue, this, &AutomationDaemon::onScheduledEvent);
+    if (!m_scheduler->start()) {
+        qCWarning(xfbScheduler) << "Scheduler table could not be read; only music will play";
+    }
+
+    // Program ingest runs on a thread of its own, as in the window
+    m_broadcast = new BroadcastWorker(this);
+    connect(m_broadcast, &BroadcastWorker::programsChanged, this, [this](int added) {
+        qCInfo(xfbScheduler) << added << "programs added to the database";
+        m_scheduler->reload();
+        m_rotation->invalidate();
+    });
+    connect(m_broadcast, &BroadcastWorker::takeOverRequested, this,
+            [](const QString& ip, const QString& stream) {
+                qCWarning(xfbScheduler) << "Takeover by" << ip << "of" << stream
+                                        << "ignored: takeovers need the XFB window";
+            });
+    m_broadcast->setClock(m_clock);
+    m_broadcast->start(m_database.databaseName(), settings.value("ProgramsPath").toString(),
+                       settings.value("TakeOverPath").toString());
+    if (m_role == "Server") {
+        m_broadcast->watch();
+    }
+
+    m_retryTimer = new ClockTimer(m_clock, this);
+    m_retryTimer->setSingleShot(true);
+    connect(m_retryTimer, &ClockTimer::timeout, this, &AutomationDaemon::onPlaybackFinished);
+
+    startMetrics(settings.value("MetricsPort", 0).toInt());
+    startRemoteControl(settings.value("RemotePort", 0).toInt(),
+                       settings.value("RemoteToken").toString());
+    startLibrarySync(settings);
+
+    qCInfo(xfbPlayer) << "Automation started as" << m_role << "with" << m_database.databaseName();
+    onPlaybackFinished();
+    return true;
+}
+
+void AutomationDaemon::stop()
+{
+    m_stopped = true;
+    if (m_retryTimer) {
+        m_retryTimer->stop();
+    }
+    if (m_scheduler) {
+        m_scheduler->stop();
+    }
+    if (m_engine) {
+        m_engine->stop();
+    }
+    if (m_history) {
+        m_history->flush();
+    }
+    if (m_nowPlaying) {
+        m_nowPlaying->write(NowPlayingStatus::Entry());
+    }
+    if (m_logger) {
+        m_logger->flush();
+    }
+}
+
+QByteArray AutomationDaemon::statusJson() const
+{
+    QJsonObject status;
+    status["role"] = m_role;
+    status["startedAt"] = m_startedAt.toString(Qt::ISODate);
+    if (m_engine) {
+        status["state"] = QString::fromLatin1(stateName(m_engine->state()));
+        status["current"] = m_engine->currentSource();
+        status["positionMs"] = double(m_engine->position());
+        status["durationMs"] = double(m_engine->duration());
+        status["queued"] = m_engine->queuedSource();
+    }
+    status["scheduled"] = QJsonArray::fromStringList(m_scheduled);
+    if (m_scheduler) {
+        status["nextEvent"] = m_scheduler->nextFireTime().toString(Qt::ISODate);
+    }
+    return QJsonDocument(status).toJson(QJsonDocument::Compact);
+}
+
+bool AutomationDaemon::openDatabase(const QString& databasePath)
+{
+    // Never create an empty library; the window sets adb.db up on first run
+    if (!QFileInfo::exists(databasePath)) {
+        qCCritical(xfbPlayer) << "Database" << databasePath
+                              << "does not exist; run XFB once to create it";
+        return false;
+    }
+
+    m_database = QSqlDatabase::addDatabase("QSQLITE", "xfb_connection");
+    m_database.setDatabaseName(databasePath);
+    if (!m_database.open()) {
+        qCCritical(xfbPlayer) << "Could not open" << databasePath << ":"
+                              << m_database.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+void AutomationDaemon::startLogging()
+{
+    QString logDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    if (logDir.isEmpty()) {
+        logDir = QStandardPaths::writableLocation(QStandardPaths::TempLocation);
+    }
+    logDir += "/logs";
+    if (!QDir().mkpath(logDir)) {
+        qWarning() << "Failed to create log directory:" << logDir;
+        return;
+    }
+
+    m_logger = new Logger(this);
+    m_logger->setFileNames("xfbd", ".log");
+    if (!m_logger->initialize(logDir)) {
+        qWarning() << "Failed to initialize logger";
+        return;
+    }
+    m_logger->captureCategories("xfb.player");
+}
+
+void AutomationDaemon::startMetrics(int port)
+{
+    if (port <= 0 || port > 65535) {
+        return;
+    }
+    m_metricsServer = new MetricsServer(&MetricsRegistry::instance(), this);
+    MetricsRegistry::instance().addCollector(m_engine, [this](MetricsRegistry& registry) {
+        const NativeAudioOutput::Statistics output = m_engine->nativeOutputStatistics();
+        registry.counter("xfb_audio_xruns_total", "Underruns of the native output")
+            ->set(output.xruns);
+        registry.counter("xfb_audio_periods_total", "Periods written to the native output")
+            ->set(output.periodsWritten);
+        registry.gauge("xfb_audio_period_frames", "Frames per period, 0 without native output")
+            ->set(output.periodFrames);
+        registry.gauge("xfb_audio_output_latency_milliseconds",
+                       "Buffered output of the native device")
+            ->set(output.latencyMs);
+    });
+    // The server lives on this thread, so the document is built between playout events
+    m_metricsServer->addPath("/status.json", "application/json",
+                             [this]() { return statusJson(); });
+    if (!m_metricsServer->listen(quint16(port))) {
+        qCWarning(xfbPlayer) << "Could not serve status on port" << port;
+    }
+}
+
+void AutomationDaemon::startRemoteControl(int port, const QString& token)
+{
+    if (port <= 0 || port > 65535) {
+        return;
+    }
+    m_remote = new RemoteControlServer(this);
+    m_remote->setToken(token);
+    m_remote->addCommand("next", [this](const QJsonObject&) {
+        if (m_engine->state() == PlaybackEngine::State::Stopped) {
+            return QString("Nothing is on air");
+        }
+        onNextTrackRequested();
+        m_engine->skipToNext();
+        return QString();
+    });
+    m_remote->addCommand("queue.append", [this](const QJsonObject& args) {
+        const QString path = args.value("path").toString();
+        if (!QFileInfo::exists(path)) {
+            return QString("No such file: %1").arg(path);
+        }
+        m_scheduled.append(path);
+        publishState();
+        return QString();
+    });
+    m_remote->addDocument("metrics", []() { return MetricsRegistry::instance().toJson(); });
+
+    connect(m_engine, &PlaybackEngine::positionChanged, this, &AutomationDaemon::publishState);
+    connect(m_engine, &PlaybackEngine::stateChanged, this, &AutomationDaemon::publishState);
+    connect(m_engine, &PlaybackEngine::trackStarted, this, &AutomationDaemon::publishState);
+    publishState();
+
+    // As in the window, only this machine may connect without a token
+    m_remote->listen(quint16(port), token.isEmpty() ? QHostAddress(QHostAddress::LocalHost)
+                                                    : QHostAddress(QHostAddress::Any));
+}
+
+void AutomationDaemon::startLibrarySync(const QSettings& settings)
+{
+    // The window's settings; see LibraryChangeLog
+    if (settings.value("LibraryFeed", false).toBool() && m_remote) {
+        if (LibraryChangeLog(m_database).ensure()) {
+            m_remote->addQuery(LibraryReplica::QUERY_NAME, [this](const QJsonObject& args) {
+                return QJsonValue(LibraryChangeLog(m_database).changesSince(
+                    args.value("since").toVariant().toLongLong(),
+                    args.value("limit").toVariant().toInt()));
+            });
+        } else {
+            qCWarning(xfbPlayer) << "Cannot create the library change log for LibraryFeed";
+        }
+    }
+
+    const QString primary = settings.value("LibraryPrimary").toString();
+    if (primary.isEmpty()) {
+        return;
+    }
+    m_replica = new LibraryReplica(m_database, this);
+    m_replica->setSource(QUrl::fromUserInput(primary),
+                         settings.value("LibraryPrimaryToken").toString());
+    m_replica->setPathMapping(settings.value("LibraryPathFrom").toString(),
+                              settings.value("LibraryPathTo").toString());
+    connect(m_replica, &LibraryReplica::changesApplied, this, [this](int rows) {
+        qCInfo(xfbPlayer) << rows << "library rows replicated";
+        m_rotation->invalidate();
+        m_hourGenres->invalidate();
+    });
+    m_replica->start();
+}
+
+void AutomationDaemon::publishState()
+{
+    if (!m_remote) {
+        return;
+    }
+    m_remote->publish("transport",
+                      QJsonObject{{"state", QString::fromLatin1(stateName(m_engine->state()))},
+                                  {"nowPlaying", m_engine->currentSource()},
+                                  {"next", m_engine->queuedSource()},
+                                  {"positionMs", double(m_engine->position())},
+                                  {"durationMs", double(m_engine->duration())}});
+    m_remote->publish("queue", QJsonArray::fromStringList(m_scheduled));
+}
+
+void AutomationDaemon::onScheduledEvent(const ScheduledEvent& event)
+{
+    if (event.rule.path.isEmpty()) {
+        qCDebug(xfbScheduler) << "Scheduled event" << event.rule.itemId
+                              << "has no pub/program path, skipping";
+        return;
+    }
+
+    qCInfo(xfbScheduler) << "Scheduled" << event.rule.path << "for" << event.fireAt.toString();
+    m_scheduled.append(event.rule.path);
+
+    if (m_engine->state() == PlaybackEngine::State::Stopped) {
+        onPlaybackFinished();
+        return;
+    }
+    // What is due goes on next, in place of music already queued; a pub or
+    // program already queued keeps its place
+    if (m_engine->hasQueuedTrack() && m_musicQueued) {
+        m_engine->clearNext();
+    }
+    onNextTrackRequested();
+}
+
+void AutomationDaemon::onTrackStarted(const QString& filePath)
+{
+    qCInfo(xfbPlayback) << "On air:" << filePath;
+    m_history->recordPlay(filePath);
+    m_rotation->markPlayed(filePath);
+
+    // What lobby displays show; the pubs and programs due come before the music queued
+    NowPlayingStatus::Entry entry;
+    entry.path = filePath;
+    entry.title = NowPlayingStatus::titleOf(filePath);
+    entry.startedAt = clock()->now();
+    entry.durationMs = m_engine->duration() > 0 ? m_engine->duration() : -1;
+    entry.upcoming = m_scheduled;
+    if (m_engine->hasQueuedTrack()) {
+        entry.upcoming.append(m_engine->queuedSource());
+    }
+    m_nowPlaying->write(entry);
+}
+
+void AutomationDaemon::onNextTrackRequested()
+{
+    if (m_stopped || m_engine->hasQueuedTrack()) {
+        return;
+    }
+    const bool scheduled = !m_scheduled.isEmpty();
+    const QString next = takeNextTrack();
+    if (!next.isEmpty()) {
+        m_engine->queueNext(next);
+        m_musicQueued = !scheduled;
+    }
+}
+
+void AutomationDaemon::onPlaybackFinished()
+{
+    if (m_stopped || m_engine->state() != PlaybackEngine::State::Stopped) {
+        return;
+    }
+    const QString next = takeNextTrack();
+    if (next.isEmpty()) {
+        qCWarning(xfbPlayback) << "Nothing to play, trying again in" << EMPTY_RETRY_MS / 1000
+                               << "seconds";
+        m_retryTimer->start(EMPTY_RETRY_MS);
+        return;
+    }
+    m_engine->play(next);
+}
+
+QString AutomationDaemon::takeNextTrack()
+{
+    if (!m_scheduled.isEmpty()) {
+        return m_scheduled.takeFirst();
+    }
+    // Music from the genre programmed for this hour, whole library otherwise
+    const QString genre = m_hourGenres->genreAt(clock()->now());
+    const QString path = m_rotation->nextTrack(genre);
+    if (path.isEmpty() && !genre.isEmpty()) {
+        return m_rotation->nextTrack();
+    }
+    return path;
+}
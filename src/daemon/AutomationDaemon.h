@@ -0,0 +1,166 @@
+#ifndef AUTOMATIONDAEMON_H
+#define AUTOMATIONDAEMON_H
+
+#include <QDateTime>
+#include <QObject>
+#include <QPointer>
+#include <QSqlDatabase>
+#include <QString>
+#include <QStringList>
+
+class AutomationClock;
+class BroadcastWorker;
+class ClockTimer;
+class HourGenreSchedule;
+class LibraryReplica;
+class Logger;
+class MetricsServer;
+class NowPlayingStatus;
+class PlayHistoryWriter;
+class PlaybackEngine;
+class QSettings;
+class RemoteControlServer;
+class RotationEngine;
+class SchedulerEngine;
+struct ScheduledEvent;
+
+/**
+ * @brief Runs a station's automation without the main window
+ *
+ * Sites that use XFB only as a 24/7 automation box had to keep the whole
+ * player window, and QtWidgets with it, running on a machine nobody looks
+ * at. AutomationDaemon puts the same layers that sit under the window on
+ * air from a QCoreApplication:
+ *
+ * - the library in adb.db, opened as the window opens it;
+ * - PlaybackEngine playing out with the window's crossfade, prefetch and
+ *   output device settings from xfb.conf;
+ * - SchedulerEngine, whose pubs and programs go on air next, ahead of the
+ *   music;
+ * - RotationEngine and HourGenreSchedule picking the music for the hour;
+ * - PlayHistoryWriter recording what was played;
+ * - on a Server, BroadcastWorker ingesting program uploads.
+ *
+ * Nothing else is started: no live assist, no streaming, no recording.
+ * Takeover requests are logged, as putting a client's stream on air still
+ * needs the window.
+ *
+ * A GUI or a monitoring system can follow the daemon remotely: with
+ * MetricsPort set it serves the usual /metrics, and /status.json with what
+ * is on air and what is next. With RemotePort set it serves the remote
+ * API of the window (RemoteControlServer), with the "transport" and
+ * "queue" topics and the "next" and "queue.append" commands.
+ *
+ * The library is shared between studios as by the window: with
+ * LibraryFeed set the daemon serves its LibraryChangeLog, and with
+ * LibraryPrimary set it replicates another studio's (LibraryReplica).
+ *
+ * exec() is what both `XFB --daemon` and `xfbd` run. SIGINT and SIGTERM
+ * stop the playout and quit cleanly, flushing the play history.
+ *
+ * @example
+ * @code
+ * int main(int argc, char* argv[])
+ * {
+ *     return AutomationDaemon::exec(argc, argv);
+ * }
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class AutomationDaemon : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr const char* DAEMON_OPTION = "--daemon";
+    static constexpr int SIGNAL_POLL_MS = 250;     ///< How often SIGINT and SIGTERM are checked
+    static constexpr int EMPTY_RETRY_MS = 30000;   ///< Retry while there is nothing to play
+
+    /**
+     * @brief Check a command line for DAEMON_OPTION
+     *
+     * Used before any QCoreApplication exists, so the window's
+     * QApplication is never created in daemon mode.
+     */
+    static bool isRequested(int argc, char* argv[]);
+
+    /**
+     * @brief Create the application, start the daemon and run until it is stopped
+     * @return Exit code of the process
+     */
+    static int exec(int argc, char* argv[]);
+
+    explicit AutomationDaemon(QObject* parent = nullptr);
+    ~AutomationDaemon() override;
+
+    /**
+     * @brief Run the schedule, the rotation and the retries on another clock; before start()
+     * @param clock Clock to run on, nullptr for the wall clock
+     */
+    void setClock(AutomationClock* clock) { m_clock = clock; }
+    AutomationClock* clock() const;
+
+    /**
+     * @brief Open the library and start the playout
+     * @param configFilePath xfb.conf to read the settings from
+     * @return false if the settings or the database could not be opened
+     */
+    bool start(const QString& configFilePath);
+
+    /**
+     * @brief Stop the playout and flush the play history
+     */
+    void stop();
+
+    /**
+     * @brief Describe what is on air, as served at /status.json
+     */
+    QByteArray statusJson() const;
+
+    /**
+     * @brief Location of xfb.conf the window uses
+     */
+    static QString defaultConfigFile();
+
+    /**
+     * @brief Location of adb.db the window uses
+     */
+    static QString defaultDatabaseFile();
+
+private:
+    bool openDatabase(const QString& databasePath);
+    void startLogging();
+    void startMetrics(int port);
+    void startRemoteControl(int port, const QString& token);
+    void startLibrarySync(const QSettings& settings);
+    void publishState();
+    void onScheduledEvent(const ScheduledEvent& event);
+    void onTrackStarted(const QString& filePath);
+    void onNextTrackRequested();
+    void onPlaybackFinished();
+    QString takeNextTrack();
+
+    QSqlDatabase m_database;
+    QString m_role;
+    Logger* m_logger = nullptr;
+    PlaybackEngine* m_engine = nullptr;
+    SchedulerEngine* m_scheduler = nullptr;
+    RotationEngine* m_rotation = nullptr;
+    HourGenreSchedule* m_hourGenres = nullptr;
+    PlayHistoryWriter* m_history = nullptr;
+    NowPlayingStatus* m_nowPlaying = nullptr;   ///< Row read by xfb --display
+    BroadcastWorker* m_broadcast = nullptr;
+    MetricsServer* m_metricsServer = nullptr;
+    RemoteControlServer* m_remote = nullptr;
+    LibraryReplica* m_replica = nullptr;
+    ClockTimer* m_retryTimer = nullptr;
+    QPointer<AutomationClock> m_clock;
+
+    QStringList m_scheduled;    ///< Pubs and programs due, played before the music
+    bool m_musicQueued = false; ///< The queued track came from the rotation
+    bool m_stopped = false;
+    QDateTime m_startedAt;
+};
+
+#endif // AUTOMATIONDAEMON_H
@@ -0,0 +1,7 @@
+#include "AutomationDaemon.h"
+
+// xfbd: the automation without the window, built without QtWidgets
+int main(int argc, char* argv[])
+{
+    return AutomationDaemon::exec(argc, argv);
+}
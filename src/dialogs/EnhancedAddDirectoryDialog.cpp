@@ -1,114 +1,1137 @@
 #include "EnhancedAddDirectoryDialog.h"
 #include "../repositories/MusicRepository.h"
+#include "../services/ContentHash.h"
+#include "../services/DurationCache.h"
 #include "../services/InputValidator.h"
+#include "../services/MediaProbe.h"
+#include "../services/TagReader.h"
+#include <QComboBox>
+#include <QDebug>
+#include <QDirIterator>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QFormLayout>
+#include <QGroupBox>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QLineEdit>
+#include <QMessageBox>
+#include <QProgressBar>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QSplitter>
+#include <QThread>
+#include <QTreeWidgetItemIterator>
+#include <QVBoxLayout>
+#include <QtConcurrent>
+
+namespace {
+
+// Data of the file items in the tree; folder items have no path
+constexpr int PATH_ROLE = Qt::UserRole;
+constexpr int SIZE_ROLE = Qt::UserRole + 1;
+
+} // namespace
 
 EnhancedAddDirectoryDialog::EnhancedAddDirectoryDialog(MusicRepository* repository, QWidget *parent)
     : QDialog(parent)
     , m_repository(repository)
+    , m_validator(std::make_unique<InputValidator>())
+    , m_progressTimer(new QTimer(this))
+    , m_scanWatcher(new QFutureWatcher<QStringList>(this))
+    , m_processor(new BatchImportProcessor(repository, this))
 {
-    // TODO: Implement enhanced directory dialog
+    setWindowTitle(tr("Add Music Directory"));
+    resize(700, 600);
+
+    m_progressTimer->setInterval(1000);
+
+    setupUI();
+    setupConnections();
+    resetDialog();
 }
 
 EnhancedAddDirectoryDialog::~EnhancedAddDirectoryDialog()
 {
+    if (m_scanWatcher->isRunning()) {
+        m_scanWatcher->waitForFinished();
+    }
+}
+
+void EnhancedAddDirectoryDialog::setupUI()
+{
+    m_mainLayout = new QVBoxLayout(this);
+    m_mainLayout->setSpacing(10);
+    m_mainLayout->setContentsMargins(15, 15, 15, 15);
+
+    // Directory selection group
+    m_directoryGroup = new QGroupBox(tr("Directory"), this);
+    auto* directoryLayout = new QVBoxLayout(m_directoryGroup);
+    auto* pathLayout = new QHBoxLayout();
+    m_directoryPathEdit = new QLineEdit(this);
+    m_directoryPathEdit->setPlaceholderText(tr("Select a directory to import..."));
+    m_browseDirectoryButton = new QPushButton(tr("Browse..."), this);
+    m_scanDirectoryButton = new QPushButton(tr("Scan"), this);
+    m_scanDirectoryButton->setToolTip(tr("List the audio files first, to choose which to import"));
+    pathLayout->addWidget(m_directoryPathEdit);
+    pathLayout->addWidget(m_browseDirectoryButton);
+    pathLayout->addWidget(m_scanDirectoryButton);
+    directoryLayout->addLayout(pathLayout);
+    m_directoryInfoLabel = new QLabel(this);
+    m_directoryInfoLabel->setStyleSheet("color: #666666; font-size: 11px;");
+    directoryLayout->addWidget(m_directoryInfoLabel);
+    m_mainLayout->addWidget(m_directoryGroup);
+
+    // File tree group
+    m_fileTreeGroup = new QGroupBox(tr("Files"), this);
+    auto* fileTreeLayout = new QVBoxLayout(m_fileTreeGroup);
+    m_fileTreeWidget = new QTreeWidget(this);
+    m_fileTreeWidget->setHeaderLabels({tr("Name"), tr("Size")});
+    m_fileTreeWidget->header()->setSectionResizeMode(0, QHeaderView::Stretch);
+    m_fileTreeWidget->header()->setStretchLastSection(false);
+    m_fileTreeWidget->setUniformRowHeights(true);
+    fileTreeLayout->addWidget(m_fileTreeWidget);
+    auto* selectionLayout = new QHBoxLayout();
+    m_fileTreeStatsLabel = new QLabel(this);
+    m_fileTreeStatsLabel->setStyleSheet("color: #666666; font-size: 11px;");
+    m_selectAllButton = new QPushButton(tr("Select All"), this);
+    m_selectNoneButton = new QPushButton(tr("Select None"), this);
+    selectionLayout->addWidget(m_fileTreeStatsLabel);
+    selectionLayout->addStretch();
+    selectionLayout->addWidget(m_selectAllButton);
+    selectionLayout->addWidget(m_selectNoneButton);
+    fileTreeLayout->addLayout(selectionLayout);
+
+    setupOptionsUI();
+
+    m_mainSplitter = new QSplitter(Qt::Vertical, this);
+    m_mainSplitter->addWidget(m_fileTreeGroup);
+    m_mainSplitter->addWidget(m_optionsGroup);
+    m_mainSplitter->setStretchFactor(0, 1);
+    m_mainSplitter->setChildrenCollapsible(false);
+    m_mainLayout->addWidget(m_mainSplitter, 1);
+
+    // Progress group
+    m_progressGroup = new QGroupBox(tr("Progress"), this);
+    auto* progressLayout = new QVBoxLayout(m_progressGroup);
+    m_progressBar = new QProgressBar(this);
+    m_progressLabel = new QLabel(this);
+    m_statisticsLabel = new QLabel(this);
+    m_timeLabel = new QLabel(this);
+    for (QLabel* label : {m_progressLabel, m_statisticsLabel, m_timeLabel}) {
+        label->setStyleSheet("color: #666666; font-size: 11px;");
+    }
+    progressLayout->addWidget(m_progressBar);
+    progressLayout->addWidget(m_progressLabel);
+    progressLayout->addWidget(m_statisticsLabel);
+    progressLayout->addWidget(m_timeLabel);
+    m_mainLayout->addWidget(m_progressGroup);
+
+    // Buttons
+    m_buttonLayout = new QHBoxLayout();
+    m_buttonLayout->addStretch();
+    m_pauseResumeButton = new QPushButton(tr("Pause"), this);
+    m_cancelButton = new QPushButton(tr("Cancel"), this);
+    m_importButton = new QPushButton(tr("Import"), this);
+    m_importButton->setDefault(true);
+    m_buttonLayout->addWidget(m_pauseResumeButton);
+    m_buttonLayout->addWidget(m_cancelButton);
+    m_buttonLayout->addWidget(m_importButton);
+    m_mainLayout->addLayout(m_buttonLayout);
+
+    setTabOrder(m_directoryPathEdit, m_browseDirectoryButton);
+    setTabOrder(m_browseDirectoryButton, m_scanDirectoryButton);
+    setTabOrder(m_scanDirectoryButton, m_fileTreeWidget);
+    setTabOrder(m_fileTreeWidget, m_includeSubdirectoriesCheck);
+    setTabOrder(m_batchSizeSpin, m_importButton);
+}
+
+void EnhancedAddDirectoryDialog::setupOptionsUI()
+{
+    m_optionsGroup = new QGroupBox(tr("Options"), this);
+    auto* optionsLayout = new QFormLayout(m_optionsGroup);
+
+    m_includeSubdirectoriesCheck = new QCheckBox(tr("Include subdirectories"), this);
+    m_extractMetadataCheck = new QCheckBox(tr("Read artist, title and genre from the tags"), this);
+    m_skipDuplicatesCheck = new QCheckBox(tr("Skip tracks the library already has"), this);
+    m_skipDuplicatesCheck->setToolTip(tr("By path, and by audio content for copies elsewhere"));
+    m_validateFilesCheck = new QCheckBox(tr("Skip files whose duration cannot be read"), this);
+    optionsLayout->addRow(m_includeSubdirectoriesCheck);
+    optionsLayout->addRow(m_extractMetadataCheck);
+    optionsLayout->addRow(m_skipDuplicatesCheck);
+    optionsLayout->addRow(m_validateFilesCheck);
+
+    m_fileExtensionsEdit = new QLineEdit(this);
+    m_fileExtensionsEdit->setPlaceholderText(tr("mp3, ogg, flac..."));
+    optionsLayout->addRow(tr("File types:"), m_fileExtensionsEdit);
+
+    m_defaultGenreCombo = new QComboBox(this);
+    m_defaultGenreCombo->setEditable(true);
+    m_defaultGenreCombo->setToolTip(tr("Genre of the tracks whose tags have none"));
+    optionsLayout->addRow(tr("Default genre:"), m_defaultGenreCombo);
+
+    m_defaultArtistEdit = new QLineEdit(this);
+    m_defaultArtistEdit->setPlaceholderText(tr("From the tags or the file name"));
+    optionsLayout->addRow(tr("Artist:"), m_defaultArtistEdit);
+
+    m_batchSizeSpin = new QSpinBox(this);
+    m_batchSizeSpin->setRange(1, 1000);
+    m_batchSizeSpin->setToolTip(tr("Tracks written to the library per transaction"));
+    optionsLayout->addRow(tr("Batch size:"), m_batchSizeSpin);
+}
+
+void EnhancedAddDirectoryDialog::setupConnections()
+{
+    connect(m_progressTimer, &QTimer::timeout, this, &EnhancedAddDirectoryDialog::onProgressTimer);
+    connect(m_scanWatcher, &QFutureWatcher<QStringList>::finished,
+            this, &EnhancedAddDirectoryDialog::onDirectoryScanCompleted);
+    connect(m_processor, &BatchImportProcessor::progressChanged,
+            this, &EnhancedAddDirectoryDialog::onImportProgressUpdate);
+    connect(m_processor, &BatchImportProcessor::finished,
+            this, &EnhancedAddDirectoryDialog::onImportFinished);
+
+    connect(m_browseDirectoryButton, &QPushButton::clicked,
+            this, &EnhancedAddDirectoryDialog::onBrowseDirectoryClicked);
+    connect(m_scanDirectoryButton, &QPushButton::clicked,
+            this, &EnhancedAddDirectoryDialog::onScanDirectoryClicked);
+    connect(m_directoryPathEdit, &QLineEdit::editingFinished,
+            this, &EnhancedAddDirectoryDialog::onDirectoryPathChanged);
+    connect(m_fileTreeWidget, &QTreeWidget::itemChanged,
+            this, &EnhancedAddDirectoryDialog::onFileTreeItemChanged);
+    connect(m_selectAllButton, &QPushButton::clicked,
+            this, &EnhancedAddDirectoryDialog::onSelectAllClicked);
+    connect(m_selectNoneButton, &QPushButton::clicked,
+            this, &EnhancedAddDirectoryDialog::onSelectNoneClicked);
+    connect(m_importButton, &QPushButton::clicked,
+            this, &EnhancedAddDirectoryDialog::onImportButtonClicked);
+    connect(m_cancelButton, &QPushButton::clicked,
+            this, &EnhancedAddDirectoryDialog::onCancelButtonClicked);
+    connect(m_pauseResumeButton, &QPushButton::clicked,
+            this, &EnhancedAddDirectoryDialog::onPauseResumeButtonClicked);
+
+    for (QCheckBox* check : {m_includeSubdirectoriesCheck, m_extractMetadataCheck,
+                             m_skipDuplicatesCheck, m_validateFilesCheck}) {
+        connect(check, &QCheckBox::toggled, this, &EnhancedAddDirectoryDialog::onOptionsChanged);
+    }
+    for (QLineEdit* edit : {m_fileExtensionsEdit, m_defaultArtistEdit}) {
+        connect(edit, &QLineEdit::editingFinished,
+                this, &EnhancedAddDirectoryDialog::onOptionsChanged);
+    }
+    connect(m_defaultGenreCombo, &QComboBox::currentTextChanged,
+            this, &EnhancedAddDirectoryDialog::onOptionsChanged);
+    connect(m_batchSizeSpin, &QSpinBox::valueChanged,
+            this, &EnhancedAddDirectoryDialog::onOptionsChanged);
+}
+
+void EnhancedAddDirectoryDialog::setDirectoryPath(const QString& directoryPath)
+{
+    m_directoryPath = directoryPath;
+    if (m_directoryPathEdit && m_directoryPathEdit->text() != directoryPath) {
+        m_directoryPathEdit->setText(directoryPath);
+    }
+    m_scannedFiles.clear();
+    m_selectedFiles.clear();
+    populateFileTree(QStringList());
+    if (m_directoryInfoLabel) {
+        m_directoryInfoLabel->setText(
+            directoryPath.isEmpty()
+                ? QString()
+                : tr("Scan to choose the files, or import the whole directory"));
+    }
+}
+
+const EnhancedAddDirectoryDialog::ImportStatistics&
+EnhancedAddDirectoryDialog::importStatistics() const
+{
+    return m_importStatistics;
+}
+
+void EnhancedAddDirectoryDialog::setImportOptions(const ImportOptions& options)
+{
+    m_importOptions = options;
+
+    // Shown without reading them back through onOptionsChanged()
+    const QSignalBlocker subdirectoriesBlocker(m_includeSubdirectoriesCheck);
+    const QSignalBlocker metadataBlocker(m_extractMetadataCheck);
+    const QSignalBlocker duplicatesBlocker(m_skipDuplicatesCheck);
+    const QSignalBlocker validateBlocker(m_validateFilesCheck);
+    const QSignalBlocker genreBlocker(m_defaultGenreCombo);
+    const QSignalBlocker batchSizeBlocker(m_batchSizeSpin);
+    m_includeSubdirectoriesCheck->setChecked(options.includeSubdirectories);
+    m_extractMetadataCheck->setChecked(options.extractMetadata);
+    m_skipDuplicatesCheck->setChecked(options.skipDuplicates);
+    m_validateFilesCheck->setChecked(options.validateFiles);
+    m_fileExtensionsEdit->setText(options.fileExtensions.join(", "));
+    m_defaultGenreCombo->setCurrentText(options.defaultGenre);
+    m_defaultArtistEdit->setText(options.defaultArtist);
+    m_batchSizeSpin->setValue(options.batchSize);
+}
+
+EnhancedAddDirectoryDialog::ImportOptions EnhancedAddDirectoryDialog::importOptions() const
+{
+    return m_importOptions;
+}
+
+void EnhancedAddDirectoryDialog::setGenreModel(QAbstractItemModel* model, int column)
+{
+    const QSignalBlocker blocker(m_defaultGenreCombo);
+    m_defaultGenreCombo->setModel(model);
+    m_defaultGenreCombo->setModelColumn(column);
+    m_defaultGenreCombo->setCurrentText(m_importOptions.defaultGenre);
+}
+
+void EnhancedAddDirectoryDialog::setDurationCache(DurationCache* cache)
+{
+    m_processor->setDurationCache(cache);
+}
+
+void EnhancedAddDirectoryDialog::resetDialog()
+{
+    if (m_isImporting || m_isScanning) {
+        return;
+    }
+
+    setDirectoryPath(QString());
+    setImportOptions(m_importOptions);
+    m_importStatistics = ImportStatistics();
+    m_progressHistory.clear();
+    m_progressBar->setRange(0, 1);
+    m_progressBar->setValue(0);
+    m_progressLabel->clear();
+    m_statisticsLabel->clear();
+    m_timeLabel->clear();
+    m_pauseResumeButton->setText(tr("Pause"));
+    setControlsEnabled(true);
 }
 
-// Slot implementations - TODO: Implement these methods
 void EnhancedAddDirectoryDialog::startImport()
 {
-    // TODO: Implement start import functionality
+    if (m_isImporting || m_isScanning || !validateImportSettings()) {
+        return;
+    }
+
+    // A scanned tree imports what was left checked; otherwise the
+    // directory is walked while the first tracks are already written
+    if (!m_scannedFiles.isEmpty()) {
+        if (m_selectedFiles.isEmpty()) {
+            emit errorOccurred(tr("No files are selected for import"));
+            return;
+        }
+        startImportAsync(m_selectedFiles, m_importOptions);
+        return;
+    }
+
+    if (!m_processor->start(m_directoryPath, m_importOptions)) {
+        emit errorOccurred(tr("Cannot import %1").arg(m_directoryPath));
+        return;
+    }
+    m_isImporting = true;
+    m_isPaused = false;
+    m_isCancelled = false;
+    m_importStartTime = QDateTime::currentDateTime();
+    m_progressHistory.clear();
+    m_progressTimer->start();
+    setControlsEnabled(false);
 }
 
 void EnhancedAddDirectoryDialog::pauseImport()
 {
-    // TODO: Implement pause import functionality
+    if (!m_isImporting || m_isPaused) {
+        return;
+    }
+    m_processor->setPaused(true);
+    m_isPaused = true;
+    if (m_pauseResumeButton) {
+        m_pauseResumeButton->setText(tr("Resume"));
+    }
 }
 
 void EnhancedAddDirectoryDialog::cancelImport()
 {
-    // TODO: Implement cancel import functionality
+    if (m_isScanning) {
+        m_isCancelled = true;
+    }
+    if (m_isImporting) {
+        m_isCancelled = true;
+        m_processor->cancel();
+    }
 }
 
 void EnhancedAddDirectoryDialog::resumeImport()
 {
-    // TODO: Implement resume import functionality
+    if (!m_isImporting || !m_isPaused) {
+        return;
+    }
+    m_processor->setPaused(false);
+    m_isPaused = false;
+    if (m_pauseResumeButton) {
+        m_pauseResumeButton->setText(tr("Pause"));
+    }
+}
+
+void EnhancedAddDirectoryDialog::reject()
+{
+    // Escape and the window's close button land here too
+    cancelImport();
+    QDialog::reject();
 }
 
 void EnhancedAddDirectoryDialog::onProgressTimer()
 {
-    // TODO: Implement progress timer functionality
+    if (!m_isImporting || !m_timeLabel) {
+        return;
+    }
+
+    const qint64 elapsed = m_importStartTime.msecsTo(QDateTime::currentDateTime());
+    QString text = tr("Elapsed: %1").arg(formatDuration(elapsed));
+    const qint64 remaining = calculateEstimatedTime();
+    if (remaining > 0) {
+        text += tr(", remaining: %1").arg(formatDuration(remaining));
+    }
+    m_timeLabel->setText(text);
 }
 
 void EnhancedAddDirectoryDialog::onImportFinished()
 {
-    // TODO: Implement import finished functionality
+    const bool cancelled = m_isCancelled;
+    m_importStatistics = m_processor->statistics();
+    m_isImporting = false;
+    m_isPaused = false;
+    m_isCancelled = false;
+    m_progressTimer->stop();
+    m_pauseResumeButton->setText(tr("Pause"));
+    setControlsEnabled(true);
+    onImportProgressUpdate();
+
+    if (cancelled) {
+        m_timeLabel->setText(tr("Cancelled; the tracks written so far stay in the library"));
+        emit importCancelled();
+    } else {
+        emit importCompleted(m_importStatistics);
+        if (isVisible()) {
+            showImportResults(m_importStatistics);
+            accept();
+        }
+    }
 }
 
 void EnhancedAddDirectoryDialog::onOptionsChanged()
 {
-    // TODO: Implement options changed functionality
+    ImportOptions options = m_importOptions;
+    options.includeSubdirectories = m_includeSubdirectoriesCheck->isChecked();
+    options.extractMetadata = m_extractMetadataCheck->isChecked();
+    options.skipDuplicates = m_skipDuplicatesCheck->isChecked();
+    options.validateFiles = m_validateFilesCheck->isChecked();
+    options.defaultGenre = m_defaultGenreCombo->currentText().trimmed();
+    options.defaultArtist = m_defaultArtistEdit->text().trimmed();
+    options.batchSize = m_batchSizeSpin->value();
+
+    QStringList extensions;
+    for (const QString& extension : m_fileExtensionsEdit->text().split(',', Qt::SkipEmptyParts)) {
+        const QString cleaned = extension.trimmed().remove(QChar('.')).remove(QChar('*'));
+        if (!cleaned.isEmpty()) {
+            extensions.append(cleaned.toLower());
+        }
+    }
+    options.fileExtensions = extensions;
+
+    // A scan made with other filters no longer lists what would be imported
+    const bool filtersChanged = options.includeSubdirectories !=
+                                    m_importOptions.includeSubdirectories ||
+                                options.fileExtensions != m_importOptions.fileExtensions;
+    m_importOptions = options;
+    if (filtersChanged && !m_scannedFiles.isEmpty()) {
+        setDirectoryPath(m_directoryPath);
+        m_directoryInfoLabel->setText(tr("The file types changed; scan again to choose the files"));
+    }
 }
 
 void EnhancedAddDirectoryDialog::onSelectAllClicked()
 {
-    // TODO: Implement select all functionality
+    for (int i = 0; i < m_fileTreeWidget->topLevelItemCount(); ++i) {
+        m_fileTreeWidget->topLevelItem(i)->setCheckState(0, Qt::Checked);
+    }
 }
 
 void EnhancedAddDirectoryDialog::onSelectNoneClicked()
 {
-    // TODO: Implement select none functionality
+    for (int i = 0; i < m_fileTreeWidget->topLevelItemCount(); ++i) {
+        m_fileTreeWidget->topLevelItem(i)->setCheckState(0, Qt::Unchecked);
+    }
 }
 
 void EnhancedAddDirectoryDialog::onCancelButtonClicked()
 {
-    // TODO: Implement cancel button functionality
+    if (m_isImporting || m_isScanning) {
+        cancelImport();
+    } else {
+        reject();
+    }
 }
 
 void EnhancedAddDirectoryDialog::onFileTreeItemChanged(QTreeWidgetItem* item, int column)
 {
     Q_UNUSED(item)
-    Q_UNUSED(column)
-    // TODO: Implement file tree item changed functionality
+    if (column != 0 || m_selectionUpdatePending) {
+        return;
+    }
+
+    // Checking a folder changes every item under it; they are counted once
+    m_selectionUpdatePending = true;
+    QTimer::singleShot(0, this, [this]() {
+        m_selectionUpdatePending = false;
+        m_selectedFiles = getSelectedFiles();
+        updateFileTreeStatistics();
+    });
 }
 
 void EnhancedAddDirectoryDialog::onImportButtonClicked()
 {
-    // TODO: Implement import button functionality
+    onDirectoryPathChanged();
+    onOptionsChanged();
+    startImport();
 }
 
 void EnhancedAddDirectoryDialog::onDirectoryPathChanged()
 {
-    // TODO: Implement directory path changed functionality
+    const QString path = m_directoryPathEdit->text().trimmed();
+    if (path != m_directoryPath) {
+        setDirectoryPath(path);
+    }
 }
 
 void EnhancedAddDirectoryDialog::onImportProgressUpdate()
 {
-    // TODO: Implement import progress update functionality
+    const ImportStatistics& statistics = m_processor->statistics();
+    updateProgress(statistics.processedFiles, statistics.totalFiles,
+                   tr("%1 imported, %2 skipped, %3 failed")
+                       .arg(statistics.successfulImports)
+                       .arg(statistics.skippedFiles)
+                       .arg(statistics.errorFiles));
 }
 
 void EnhancedAddDirectoryDialog::onScanDirectoryClicked()
 {
-    // TODO: Implement scan directory functionality
+    onDirectoryPathChanged();
+    onOptionsChanged();
+    if (m_directoryPath.isEmpty() || !QFileInfo(m_directoryPath).isDir()) {
+        emit errorOccurred(tr("Please select an existing directory to import"));
+        return;
+    }
+    scanDirectoryAsync(m_directoryPath, m_importOptions);
+    if (m_isScanning) {
+        m_directoryInfoLabel->setText(tr("Scanning..."));
+        setControlsEnabled(false);
+    }
 }
 
 void EnhancedAddDirectoryDialog::onBrowseDirectoryClicked()
 {
-    // TODO: Implement browse directory functionality
+    const QString directory = QFileDialog::getExistingDirectory(
+        this, tr("Select a directory to import"), m_directoryPath);
+    if (directory.isEmpty()) {
+        return;
+    }
+    setDirectoryPath(QDir::toNativeSeparators(directory));
 }
 
 void EnhancedAddDirectoryDialog::onDirectoryScanCompleted()
 {
-    // TODO: Implement directory scan completed functionality
+    m_isScanning = false;
+    setControlsEnabled(true);
+    if (m_isCancelled) {
+        m_isCancelled = false;
+        m_directoryInfoLabel->setText(tr("Scan cancelled"));
+        return;
+    }
+
+    m_scannedFiles = m_scanWatcher->result();
+    m_importStatistics = ImportStatistics();
+    m_importStatistics.totalFiles = m_scannedFiles.size();
+    populateFileTree(m_scannedFiles);
+    m_selectedFiles = m_scannedFiles;
+    updateFileTreeStatistics();
+    m_directoryInfoLabel->setText(tr("%1 audio files found").arg(m_scannedFiles.size()));
+    updateProgress(0, m_scannedFiles.size(), tr("%1 audio files found").arg(m_scannedFiles.size()));
 }
 
 void EnhancedAddDirectoryDialog::onPauseResumeButtonClicked()
 {
-    // TODO: Implement pause/resume button functionality
+    if (m_isPaused) {
+        resumeImport();
+    } else {
+        pauseImport();
+    }
+}
+
+void EnhancedAddDirectoryDialog::scanDirectory(const QString& directoryPath)
+{
+    m_scannedFiles = DirectoryScanner::scanDirectory(directoryPath, m_importOptions);
+    m_selectedFiles = m_scannedFiles;
+}
+
+void EnhancedAddDirectoryDialog::scanDirectoryAsync(const QString& directoryPath,
+                                                    const ImportOptions& options)
+{
+    if (m_isScanning || m_isImporting || directoryPath.isEmpty()) {
+        return;
+    }
+    m_isScanning = true;
+    m_isCancelled = false;
+    m_scanWatcher->setFuture(QtConcurrent::run(&DirectoryScanner::scanDirectory, directoryPath,
+                                               options));
+}
+
+void EnhancedAddDirectoryDialog::populateFileTree(const QStringList& files)
+{
+    const QSignalBlocker blocker(m_fileTreeWidget);
+    m_fileTreeWidget->clear();
+
+    // Folders by their path relative to the directory, created as files need them
+    const QDir root(m_directoryPath);
+    QHash<QString, QTreeWidgetItem*> folders;
+    std::function<QTreeWidgetItem*(const QString&)> folderItem =
+        [&](const QString& relativeDir) -> QTreeWidgetItem* {
+        if (relativeDir.isEmpty() || relativeDir == ".") {
+            return nullptr;
+        }
+        if (QTreeWidgetItem* known = folders.value(relativeDir)) {
+            return known;
+        }
+        const int slash = relativeDir.lastIndexOf('/');
+        QTreeWidgetItem* parent = folderItem(slash < 0 ? QString() : relativeDir.left(slash));
+        auto* item = parent ? new QTreeWidgetItem(parent) : new QTreeWidgetItem(m_fileTreeWidget);
+        item->setText(0, relativeDir.mid(slash + 1));
+        item->setFlags(item->flags() | Qt::ItemIsUserCheckable | Qt::ItemIsAutoTristate);
+        item->setCheckState(0, Qt::Checked);
+        folders.insert(relativeDir, item);
+        return item;
+    };
+
+    for (const QString& file : files) {
+        const QString relativeDir = QFileInfo(root.relativeFilePath(file)).path();
+        createFileTreeItem(file, folderItem(relativeDir));
+    }
+    m_fileTreeWidget->resizeColumnToContents(1);
+    updateFileTreeStatistics();
+}
+
+QStringList EnhancedAddDirectoryDialog::getSelectedFiles() const
+{
+    QStringList files;
+    QTreeWidgetItemIterator it(m_fileTreeWidget, QTreeWidgetItemIterator::Checked);
+    for (; *it; ++it) {
+        const QString path = (*it)->data(0, PATH_ROLE).toString();
+        if (!path.isEmpty()) {
+            files.append(path);
+        }
+    }
+    return files;
+}
+
+void EnhancedAddDirectoryDialog::updateFileTreeStatistics()
+{
+    if (m_scannedFiles.isEmpty()) {
+        m_fileTreeStatsLabel->clear();
+        return;
+    }
+
+    qint64 selectedSize = 0;
+    QTreeWidgetItemIterator it(m_fileTreeWidget, QTreeWidgetItemIterator::Checked);
+    for (; *it; ++it) {
+        selectedSize += (*it)->data(0, SIZE_ROLE).toLongLong();
+    }
+    m_fileTreeStatsLabel->setText(tr("%1 of %2 files selected, %3")
+                                      .arg(m_selectedFiles.size())
+                                      .arg(m_scannedFiles.size())
+                                      .arg(formatFileSize(selectedSize)));
+}
+
+QTreeWidgetItem* EnhancedAddDirectoryDialog::createFileTreeItem(const QString& filePath,
+                                                                QTreeWidgetItem* parent)
+{
+    auto* item = parent ? new QTreeWidgetItem(parent) : new QTreeWidgetItem(m_fileTreeWidget);
+    item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
+    item->setCheckState(0, Qt::Checked);
+    updateTreeItemInfo(item, filePath);
+    return item;
+}
+
+void EnhancedAddDirectoryDialog::updateTreeItemInfo(QTreeWidgetItem* item, const QString& filePath)
+{
+    const QFileInfo info(filePath);
+    item->setText(0, info.fileName());
+    item->setText(1, formatFileSize(info.size()));
+    item->setTextAlignment(1, Qt::AlignRight | Qt::AlignVCenter);
+    item->setToolTip(0, QDir::toNativeSeparators(filePath));
+    item->setData(0, PATH_ROLE, filePath);
+    item->setData(0, SIZE_ROLE, info.size());
+}
+
+bool EnhancedAddDirectoryDialog::validateImportSettings()
+{
+    if (!m_repository) {
+        emit errorOccurred(tr("No music repository to import into"));
+        return false;
+    }
+    if (m_directoryPath.isEmpty() || !QFileInfo(m_directoryPath).isDir()) {
+        emit errorOccurred(tr("Please select an existing directory to import"));
+        return false;
+    }
+    if (m_importOptions.fileExtensions.isEmpty()) {
+        emit errorOccurred(tr("Please give at least one file extension to import"));
+        return false;
+    }
+    return true;
+}
+
+void EnhancedAddDirectoryDialog::startImportAsync(const QStringList& files,
+                                                  const ImportOptions& options)
+{
+    if (!m_processor->start(files, options)) {
+        return;
+    }
+    m_isImporting = true;
+    m_isPaused = false;
+    m_isCancelled = false;
+    m_importStartTime = QDateTime::currentDateTime();
+    m_progressHistory.clear();
+    m_progressTimer->start();
+    setControlsEnabled(false);
+}
+
+void EnhancedAddDirectoryDialog::updateProgress(int current, int total, const QString& message)
+{
+    m_progressHistory.append(qMakePair(QDateTime::currentMSecsSinceEpoch(), current));
+    while (m_progressHistory.size() > MAX_PROGRESS_HISTORY) {
+        m_progressHistory.removeFirst();
+    }
+
+    if (m_progressBar) {
+        m_progressBar->setRange(0, qMax(total, 1));
+        m_progressBar->setValue(current);
+    }
+    if (m_progressLabel) {
+        m_progressLabel->setText(tr("%1 of %2 files").arg(current).arg(total));
+    }
+    if (m_statisticsLabel) {
+        m_statisticsLabel->setText(message);
+    }
+    emit importProgress(current, total, message);
+}
+
+void EnhancedAddDirectoryDialog::showImportResults(const ImportStatistics& statistics)
+{
+    QMessageBox box(statistics.errorFiles > 0 ? QMessageBox::Warning : QMessageBox::Information,
+                    tr("Add directory"),
+                    tr("%1 tracks imported, %2 already in the library, %3 could not be read.")
+                        .arg(statistics.successfulImports)
+                        .arg(statistics.skippedFiles)
+                        .arg(statistics.errorFiles),
+                    QMessageBox::Ok, this);
+    box.setInformativeText(
+        tr("%1 in %2")
+            .arg(formatFileSize(statistics.processedSize),
+                 formatDuration(statistics.startTime.msecsTo(statistics.endTime))));
+    if (!statistics.errorMessages.isEmpty()) {
+        box.setDetailedText(statistics.errorMessages.join('\n'));
+    }
+    box.exec();
+}
+
+void EnhancedAddDirectoryDialog::setControlsEnabled(bool enabled)
+{
+    for (QWidget* widget : {static_cast<QWidget*>(m_directoryGroup),
+                            static_cast<QWidget*>(m_fileTreeGroup),
+                            static_cast<QWidget*>(m_optionsGroup),
+                            static_cast<QWidget*>(m_importButton)}) {
+        if (widget) {
+            widget->setEnabled(enabled);
+        }
+    }
+    if (m_pauseResumeButton) {
+        m_pauseResumeButton->setEnabled(!enabled && m_isImporting);
+    }
+}
+
+QString EnhancedAddDirectoryDialog::formatFileSize(qint64 bytes) const
+{
+    return locale().formattedDataSize(bytes, 1);
+}
+
+QString EnhancedAddDirectoryDialog::formatDuration(qint64 milliseconds) const
+{
+    const qint64 seconds = milliseconds / 1000;
+    return QString("%1:%2:%3")
+        .arg(seconds / 3600)
+        .arg((seconds % 3600) / 60, 2, 10, QChar('0'))
+        .arg(seconds % 60, 2, 10, QChar('0'));
+}
+
+qint64 EnhancedAddDirectoryDialog::calculateEstimatedTime() const
+{
+    if (m_progressHistory.size() < 2) {
+        return -1;
+    }
+
+    // Rate over the last few updates, while the walk may still be adding files
+    const auto& first = m_progressHistory.first();
+    const auto& last = m_progressHistory.last();
+    const qint64 elapsed = last.first - first.first;
+    const int done = last.second - first.second;
+    const int remaining = m_processor->statistics().totalFiles - last.second;
+    if (elapsed <= 0 || done <= 0 || remaining <= 0) {
+        return -1;
+    }
+    return qint64(double(remaining) * elapsed / done);
 }
 
 // DirectoryScanner implementation
 DirectoryScanner::DirectoryScanner(QObject* parent)
     : QObject(parent)
 {
-    // TODO: Implement DirectoryScanner constructor
-}
\ No newline at end of file
+}
+
+QStringList DirectoryScanner::scanDirectory(
+    const QString& directoryPath, const EnhancedAddDirectoryDialog::ImportOptions& options)
+{
+    QStringList files;
+    const QDir directory(directoryPath);
+    if (directory.exists()) {
+        scanDirectoryRecursive(directory, options, files);
+    }
+    return files;
+}
+
+void DirectoryScanner::scanDirectoryRecursive(
+    const QDir& directory, const EnhancedAddDirectoryDialog::ImportOptions& options,
+    QStringList& files)
+{
+    const QFileInfoList entries =
+        directory.entryInfoList(QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
+    for (const QFileInfo& entry : entries) {
+        if (entry.isDir()) {
+            if (options.includeSubdirectories && !entry.isSymLink()) {
+                scanDirectoryRecursive(QDir(entry.filePath()), options, files);
+            }
+        } else if (isSupportedAudioFile(entry.filePath(), options.fileExtensions)) {
+            files.append(entry.filePath());
+        }
+    }
+}
+
+bool DirectoryScanner::isSupportedAudioFile(const QString& filePath, const QStringList& extensions)
+{
+    return extensions.contains(QFileInfo(filePath).suffix(), Qt::CaseInsensitive);
+}
+
+// BatchImportProcessor implementation
+BatchImportProcessor::BatchImportProcessor(MusicRepository* repository, QObject* parent)
+    : QObject(parent)
+    , m_repository(repository)
+    , m_maxWorkers(qMax(1, QThread::idealThreadCount() * 2))
+    , m_writeTimer(new QTimer(this))
+{
+    m_pool.setThreadPriority(QThread::LowPriority);
+    m_pool.setMaxThreadCount(m_maxWorkers + 1);
+    m_writeTimer->setInterval(WRITE_INTERVAL_MS);
+    connect(m_writeTimer, &QTimer::timeout, this, &BatchImportProcessor::writeReady);
+}
+
+BatchImportProcessor::~BatchImportProcessor()
+{
+    stopStages();
+}
+
+void BatchImportProcessor::setMaxWorkers(int workers)
+{
+    // Takes effect from the next import; the walker has a thread of its own
+    m_maxWorkers = qMax(1, workers);
+}
+
+int BatchImportProcessor::queueCapacity(const EnhancedAddDirectoryDialog::ImportOptions& options)
+{
+    return qMax(1, options.batchSize) * 4;
+}
+
+bool BatchImportProcessor::start(const QString& directoryPath,
+                                 const EnhancedAddDirectoryDialog::ImportOptions& options)
+{
+    if (m_running || !QFileInfo(directoryPath).isDir()) {
+        return false;
+    }
+
+    run([this, directoryPath, options]() { walkDirectory(directoryPath, options); }, options);
+    return true;
+}
+
+bool BatchImportProcessor::start(const QStringList& paths,
+                                 const EnhancedAddDirectoryDialog::ImportOptions& options)
+{
+    if (m_running) {
+        return false;
+    }
+
+    run([this, paths, options]() {
+        for (const QString& path : paths) {
+            const QFileInfo info(path);
+            if (!(info.isDir() ? walkDirectory(path, options) : offer(path, info.size()))) {
+                break;
+            }
+        }
+    }, options);
+    return true;
+}
+
+bool BatchImportProcessor::walkDirectory(const QString& directoryPath,
+                                         const EnhancedAddDirectoryDialog::ImportOptions& options)
+{
+    const QDirIterator::IteratorFlags flags = options.includeSubdirectories
+                                                  ? QDirIterator::Subdirectories
+                                                  : QDirIterator::NoIteratorFlags;
+    QDirIterator it(directoryPath, QDir::Files, flags);
+    while (it.hasNext() && !m_cancelled) {
+        const QString filePath = it.next();
+        if (DirectoryScanner::isSupportedAudioFile(filePath, options.fileExtensions) &&
+            !offer(filePath, it.fileInfo().size())) {
+            return false;
+        }
+    }
+    return !m_cancelled;
+}
+
+bool BatchImportProcessor::offer(const QString& filePath, qint64 size)
+{
+    if (m_cancelled) {
+        return false;
+    }
+
+    // Listed before it is queued, so filesFound() always comes ahead of its batch
+    {
+        QMutexLocker locker(&m_foundMutex);
+        m_newlyFound.append(filePath);
+    }
+    m_foundSize += size;
+    ++m_found;
+    return m_paths.push(filePath);
+}
+
+void BatchImportProcessor::cancel()
+{
+    if (!m_running) {
+        return;
+    }
+
+    m_cancelled = true;
+    stopStages();
+    finish(true);
+}
+
+void BatchImportProcessor::setPaused(bool paused)
+{
+    // The stages before the writer stop on their own once the queues fill
+    m_paused = paused;
+}
+
+void BatchImportProcessor::run(std::function<void()> walk,
+                               const EnhancedAddDirectoryDialog::ImportOptions& options)
+{
+    m_options = options;
+    m_statistics = EnhancedAddDirectoryDialog::ImportStatistics();
+    m_statistics.startTime = QDateTime::currentDateTime();
+    m_paths.reset(queueCapacity(options));
+    m_extracted.reset(queueCapacity(options));
+    m_found = 0;
+    m_foundSize = 0;
+    m_newlyFound.clear();
+    m_cancelled = false;
+    m_paused = false;
+    m_running = true;
+
+    m_pool.setMaxThreadCount(m_maxWorkers + 1);
+    m_pool.start([this, walk = std::move(walk)]() {
+        walk();
+        m_paths.close();
+    });
+    m_extractorsLeft = m_maxWorkers;
+    for (int i = 0; i < m_maxWorkers; ++i) {
+        m_pool.start([this]() { extract(); });
+    }
+
+    qInfo() << "BatchImportProcessor: importing with" << m_maxWorkers << "workers in batches of"
+            << qMax(1, options.batchSize);
+    m_writeTimer->start();
+}
+
+void BatchImportProcessor::extract()
+{
+    QString filePath;
+    while (m_paths.pop(filePath)) {
+        Extracted extracted;
+        extracted.path = filePath;
+        extracted.size = QFileInfo(filePath).size();
+        MusicItem item =
+            createMusicItemFromFile(filePath, m_options, &extracted.error, &extracted.durationUs);
+        if (extracted.error.isEmpty()) {
+            extracted.item = std::make_shared<MusicItem>(std::move(item));
+        } else {
+            extracted.error = QString("%1: %2").arg(filePath, extracted.error);
+        }
+        if (!m_extracted.push(std::move(extracted))) {
+            break;
+        }
+    }
+
+    // The last extractor out tells the writer that nothing more is coming
+    if (--m_extractorsLeft == 0) {
+        m_extracted.close();
+    }
+}
+
+void BatchImportProcessor::writeReady()
+{
+    if (!m_running || m_paused) {
+        return;
+    }
+
+    QStringList found;
+    {
+        QMutexLocker locker(&m_foundMutex);
+        found.swap(m_newlyFound);
+    }
+    if (!found.isEmpty()) {
+        emit filesFound(found);
+    }
+
+    // A short batch is only written once extraction is over; at most one
+    // queue's worth per tick, so the GUI thread keeps breathing
+    const int batchSize = qMax(1, m_options.batchSize);
+    bool wrote = false;
+    for (int written = 0; written < queueCapacity(m_options); written += batchSize) {
+        const int ready = m_extracted.size();
+        if (ready == 0 || (ready < batchSize && !m_extracted.isClosed())) {
+            break;
+        }
+
+        QList<MusicItem> items;
+        QHash<QString, QString> failed;
+        for (const Extracted& extracted : m_extracted.take(batchSize)) {
+            ++m_statistics.processedFiles;
+            m_statistics.processedSize += extracted.size;
+            if (extracted.item) {
+                items.append(*extracted.item);
+                if (m_durationCache) {
+                    m_durationCache->store(extracted.path, extracted.durationUs);
+                }
+            } else {
+                ++m_statistics.errorFiles;
+                m_statistics.errorMessages.append(extracted.error);
+                failed.insert(extracted.path, extracted.error);
+                qWarning() << "BatchImportProcessor::writeReady -" << extracted.error;
+            }
+        }
+
+        // addMusicBatch() turns away tracks already in the library by path or audio
+        const int added = items.isEmpty() || !m_repository ? 0 : m_repository->addMusicBatch(items);
+        m_statistics.successfulImports += added;
+        m_statistics.skippedFiles += items.size() - added;
+        wrote = true;
+        emit batchWritten(items, failed);
+    }
+
+    m_statistics.totalFiles = m_found;
+    m_statistics.totalSize = m_foundSize;
+    if (wrote) {
+        emit progressChanged(m_statistics.processedFiles, m_statistics.totalFiles,
+                             QString("%1 imported, %2 skipped, %3 failed")
+                                 .arg(m_statistics.successfulImports)
+                                 .arg(m_statistics.skippedFiles)
+                                 .arg(m_statistics.errorFiles));
+    }
+
+    if (m_extracted.isDrained()) {
+        finish(false);
+    }
+}
+
+void BatchImportProcessor::finish(bool cancelled)
+{
+    m_writeTimer->stop();
+    m_pool.waitForDone();
+    m_running = false;
+    m_paused = false;
+    m_statistics.totalFiles = m_found;
+    m_statistics.totalSize = m_foundSize;
+    m_statistics.endTime = QDateTime::currentDateTime();
+
+    qInfo() << "BatchImportProcessor: import" << (cancelled ? "cancelled," : "finished,")
+            << m_statistics.successfulImports << "imported," << m_statistics.skippedFiles
+            << "skipped," << m_statistics.errorFiles << "failed of"
+            << m_statistics.totalFiles << "files in"
+            << m_statistics.startTime.msecsTo(m_statistics.endTime) << "ms";
+    emit finished(m_statistics, cancelled);
+}
+
+void BatchImportProcessor::stopStages()
+{
+    m_cancelled = true;
+    m_paths.abort();
+    m_extracted.abort();
+    m_pool.waitForDone();
+}
+
+MusicItem BatchImportProcessor::createMusicItemFromFile(
+    const QString& filePath, const EnhancedAddDirectoryDialog::ImportOptions& options,
+    QString* error, qint64* durationUs)
+{
+    MusicItem music;
+    *durationUs = -1;
+    const QFileInfo fileInfo(filePath);
+    if (!fileInfo.isFile()) {
+        *error = "File does not exist";
+        return music;
+    }
+    if (options.validateFiles && fileInfo.size() == 0) {
+        *error = "File is empty";
+        return music;
+    }
+
+    // Tags when asked for, then the defaults, then "Artist - Song" file names
+    TagReader::Tags tags;
+    if (options.extractMetadata) {
+        tags = TagReader::read(filePath);
+    } else if (options.validateFiles) {
+        tags.durationUs = MediaProbe::durationUs(filePath);
+    }
+    if (options.validateFiles && tags.durationUs < 0) {
+        *error = "Cannot read the duration";
+        return music;
+    }
+
+    const QString baseName = fileInfo.completeBaseName();
+    const QStringList parts = baseName.split(" - ", Qt::SkipEmptyParts);
+    QString fileArtist = parts.size() >= 2 ? parts.at(0).trimmed() : QString("Unknown Artist");
+    if (!options.defaultArtist.isEmpty()) {
+        fileArtist = options.defaultArtist;
+    }
+    music.artist = tags.artist.isEmpty() ? fileArtist : tags.artist;
+    music.song = !tags.title.isEmpty() ? tags.title
+                 : parts.size() >= 2   ? parts.at(1).trimmed()
+                                       : baseName;
+    if (!tags.genre.isEmpty()) {
+        music.genre1 = tags.genre;
+    } else {
+        music.genre1 = options.defaultGenre.isEmpty() ? QString("Unknown") : options.defaultGenre;
+    }
+    music.publishedDate = tags.year;
+    music.time = tags.durationString();
+    music.path = filePath;
+    *durationUs = tags.durationUs;
+
+    // Hashed here, on a pool thread, so addMusicBatch() does not read the file again
+    if (options.skipDuplicates) {
+        music.contentHash = ContentHash::ofFile(filePath);
+    }
+    return music;
+}
@@ -1,6 +1,7 @@
 #ifndef ENHANCEDADDDIRECTORYDIALOG_H
 #define ENHANCEDADDDIRECTORYDIALOG_H
 
+#include "../repositories/MusicRepository.h"
 #include <QDialog>
 #include <QProgressBar>
 #include <QLabel>
@@ -10,20 +11,27 @@
 #include <QCheckBox>
 #include <QDateTime>
 #include <QDir>
+#include <QHash>
+#include <QMutex>
+#include <QQueue>
+#include <QThreadPool>
+#include <QWaitCondition>
+#include <atomic>
+#include <functional>
 #include <memory>
 
 // Forward declarations
-class MusicRepository;
+class BatchImportProcessor;
+class DurationCache;
 class InputValidator;
-struct MusicItem;
+class QAbstractItemModel;
 class QLineEdit;
 class QComboBox;
 class QPushButton;
-class QTextEdit;
+class QSpinBox;
 class QGroupBox;
 class QVBoxLayout;
 class QHBoxLayout;
-class QFormLayout;
 class QSplitter;
 class QTreeWidgetItem;
 
@@ -36,12 +44,15 @@ class QTreeWidgetItem;
  * 
  * Features:
  * - Directory tree preview with file filtering
- * - Real-time progress tracking with cancellation
+ * - Real-time progress tracking with pause and cancellation
  * - Batch processing with error handling
  * - File type filtering and validation
  * - Duplicate detection and handling
  * - Metadata extraction for all files
- * - Resume capability for interrupted imports
+ *
+ * The import runs on BatchImportProcessor: without a scan the directory is
+ * walked while the first tracks are already written, after a scan only the
+ * files left checked in the tree are imported.
  * 
  * @since XFB 2.0
  */
@@ -109,6 +120,25 @@ public:
      */
     ImportOptions importOptions() const;
 
+    /**
+     * @brief Offer the genres of a model, kept up to date elsewhere, as the default genre
+     * @param model Genre model
+     * @param column Column of the genre names
+     */
+    void setGenreModel(QAbstractItemModel* model, int column);
+
+    /**
+     * @brief Hand the durations read by the import to a cache, see BatchImportProcessor
+     */
+    void setDurationCache(DurationCache* cache);
+
+    /**
+     * @brief Clear the directory, the scan and the progress, for the next import
+     *
+     * The options are kept; the dialog is kept between openings.
+     */
+    void resetDialog();
+
 public slots:
     /**
      * @brief Start the import process
@@ -130,6 +160,11 @@ public slots:
      */
     void resumeImport();
 
+    /**
+     * @brief Cancel a running import or scan, then close
+     */
+    void reject() override;
+
 signals:
     /**
      * @brief Emitted when import is completed
@@ -306,11 +341,6 @@ private:
      */
     void setControlsEnabled(bool enabled);
 
-    /**
-     * @brief Reset dialog to initial state
-     */
-    void resetDialog();
-
     /**
      * @brief Format file size for display
      * @param bytes File size in bytes
@@ -346,74 +376,66 @@ private:
      */
     void updateTreeItemInfo(QTreeWidgetItem* item, const QString& filePath);
 
-    /**
-     * @brief Check if file should be included based on options
-     * @param filePath Path to the file
-     * @param options Import options
-     * @return true if file should be included
-     */
-    bool shouldIncludeFile(const QString& filePath, const ImportOptions& options) const;
-
 private:
     // Core components
     MusicRepository* m_repository;
     std::unique_ptr<InputValidator> m_validator;
     
     // UI components - Directory selection
-    QGroupBox* m_directoryGroup;
-    QLineEdit* m_directoryPathEdit;
-    QPushButton* m_browseDirectoryButton;
-    QPushButton* m_scanDirectoryButton;
-    QLabel* m_directoryInfoLabel;
+    QGroupBox* m_directoryGroup = nullptr;
+    QLineEdit* m_directoryPathEdit = nullptr;
+    QPushButton* m_browseDirectoryButton = nullptr;
+    QPushButton* m_scanDirectoryButton = nullptr;
+    QLabel* m_directoryInfoLabel = nullptr;
     
     // UI components - File tree
-    QGroupBox* m_fileTreeGroup;
-    QTreeWidget* m_fileTreeWidget;
-    QLabel* m_fileTreeStatsLabel;
-    QPushButton* m_selectAllButton;
-    QPushButton* m_selectNoneButton;
+    QGroupBox* m_fileTreeGroup = nullptr;
+    QTreeWidget* m_fileTreeWidget = nullptr;
+    QLabel* m_fileTreeStatsLabel = nullptr;
+    QPushButton* m_selectAllButton = nullptr;
+    QPushButton* m_selectNoneButton = nullptr;
     
     // UI components - Import options
-    QGroupBox* m_optionsGroup;
-    QCheckBox* m_includeSubdirectoriesCheck;
-    QCheckBox* m_extractMetadataCheck;
-    QCheckBox* m_skipDuplicatesCheck;
-    QCheckBox* m_overwriteExistingCheck;
-    QCheckBox* m_validateFilesCheck;
-    QLineEdit* m_fileExtensionsEdit;
-    QLineEdit* m_defaultGenreEdit;
-    QLineEdit* m_defaultArtistEdit;
-    QLineEdit* m_batchSizeEdit;
+    QGroupBox* m_optionsGroup = nullptr;
+    QCheckBox* m_includeSubdirectoriesCheck = nullptr;
+    QCheckBox* m_extractMetadataCheck = nullptr;
+    QCheckBox* m_skipDuplicatesCheck = nullptr;
+    QCheckBox* m_validateFilesCheck = nullptr;
+    QLineEdit* m_fileExtensionsEdit = nullptr;
+    QComboBox* m_defaultGenreCombo = nullptr;
+    QLineEdit* m_defaultArtistEdit = nullptr;
+    QSpinBox* m_batchSizeSpin = nullptr;
     
     // UI components - Progress
-    QGroupBox* m_progressGroup;
-    QProgressBar* m_progressBar;
-    QLabel* m_progressLabel;
-    QLabel* m_statisticsLabel;
-    QLabel* m_timeLabel;
+    QGroupBox* m_progressGroup = nullptr;
+    QProgressBar* m_progressBar = nullptr;
+    QLabel* m_progressLabel = nullptr;
+    QLabel* m_statisticsLabel = nullptr;
+    QLabel* m_timeLabel = nullptr;
     
     // UI components - Buttons
-    QPushButton* m_importButton;
-    QPushButton* m_cancelButton;
-    QPushButton* m_pauseResumeButton;
-    QPushButton* m_closeButton;
+    QPushButton* m_importButton = nullptr;
+    QPushButton* m_cancelButton = nullptr;
+    QPushButton* m_pauseResumeButton = nullptr;
     
     // Layouts
-    QVBoxLayout* m_mainLayout;
-    QSplitter* m_mainSplitter;
-    QHBoxLayout* m_buttonLayout;
+    QVBoxLayout* m_mainLayout = nullptr;
+    QSplitter* m_mainSplitter = nullptr;
+    QHBoxLayout* m_buttonLayout = nullptr;
     
     // State management
-    QTimer* m_progressTimer;
-    QFutureWatcher<QStringList>* m_scanWatcher;
-    QFutureWatcher<ImportStatistics>* m_importWatcher;
+    QTimer* m_progressTimer = nullptr;
+    QFutureWatcher<QStringList>* m_scanWatcher = nullptr;
+    BatchImportProcessor* m_processor = nullptr;
     
-    bool m_isScanning;
-    bool m_isImporting;
-    bool m_isPaused;
-    bool m_isCancelled;
+    bool m_isScanning = false;
+    bool m_isImporting = false;
+    bool m_isPaused = false;
+    bool m_isCancelled = false;
+    bool m_selectionUpdatePending = false;   ///< Checks changed; counted once they settle
     
     // Import data
+    QString m_directoryPath;
     ImportOptions m_importOptions;
     ImportStatistics m_importStatistics;
     QStringList m_scannedFiles;
@@ -444,6 +466,14 @@ public:
     static QStringList scanDirectory(const QString& directoryPath, 
                                    const EnhancedAddDirectoryDialog::ImportOptions& options);
 
+    /**
+     * @brief Check if file is a supported audio file
+     * @param filePath Path to the file
+     * @param extensions List of supported extensions
+     * @return true if file is supported
+     */
+    static bool isSupportedAudioFile(const QString& filePath, const QStringList& extensions);
+
 private:
     /**
      * @brief Recursively scan directory
@@ -454,79 +484,290 @@ private:
     static void scanDirectoryRecursive(const QDir& directory,
                                      const EnhancedAddDirectoryDialog::ImportOptions& options,
                                      QStringList& files);
-    
-    /**
-     * @brief Check if file is a supported audio file
-     * @param filePath Path to the file
-     * @param extensions List of supported extensions
-     * @return true if file is supported
-     */
-    static bool isSupportedAudioFile(const QString& filePath, const QStringList& extensions);
 };
 
 /**
- * @brief Batch import processor
+ * @brief Staged import of a directory or a list of files
+ *
+ * The import runs as three stages connected by bounded queues:
+ * - a walker that lists the audio files under a directory (or hands over
+ *   a given list, walking the directories in it) on a pool thread;
+ * - maxWorkers() extractors that read each file's duration, content hash
+ *   and file name tags on pool threads;
+ * - a writer on the processor's own thread that adds the tracks with
+ *   MusicRepository::addMusicBatch() in ImportOptions::batchSize chunks.
+ *
+ * The queues hold at most queueCapacity() items, so a stage that runs
+ * ahead waits for the next one and memory stays flat however large the
+ * import. The writer stays on the processor's thread because the
+ * repository's connection belongs to it. pause() stops the writer and, by
+ * back pressure, the stages before it; cancel() takes effect after the
+ * files being read.
+ *
+ * @example
+ * @code
+ * BatchImportProcessor* processor = new BatchImportProcessor(repository, this);
+ * connect(processor, &BatchImportProcessor::finished, this, [](const auto& statistics) {
+ *     qDebug() << statistics.successfulImports << "tracks imported";
+ * });
+ * processor->start("/mnt/nas/music", options);
+ * @endcode
+ *
+ * @since XFB 2.0
  */
 class BatchImportProcessor : public QObject
 {
     Q_OBJECT
 
 public:
+    static constexpr int WRITE_INTERVAL_MS = 100;
+
     explicit BatchImportProcessor(MusicRepository* repository, QObject* parent = nullptr);
-    
+    ~BatchImportProcessor() override;
+
+    /**
+     * @brief Set how many files are read at once
+     * @param workers Worker count; twice the number of cores by default,
+     *        since the workers mostly wait for the disk
+     */
+    void setMaxWorkers(int workers);
+    int maxWorkers() const { return m_maxWorkers; }
+
     /**
-     * @brief Process files in batches
-     * @param files List of files to process
+     * @brief Get how many items each queue holds at most
+     * @param options Options of the import
+     * @return Four batches, so the writer always has a full one waiting
+     */
+    static int queueCapacity(const EnhancedAddDirectoryDialog::ImportOptions& options);
+
+    /**
+     * @brief Import the audio files under a directory
+     *
+     * Files are imported while the directory is still being walked, so the
+     * first tracks arrive before a large tree is fully listed.
+     * @param directoryPath Directory to walk
      * @param options Import options
-     * @return Import statistics
+     * @return false if an import is running or the directory does not exist
      */
-    EnhancedAddDirectoryDialog::ImportStatistics processFiles(
-        const QStringList& files,
-        const EnhancedAddDirectoryDialog::ImportOptions& options);
+    bool start(const QString& directoryPath,
+               const EnhancedAddDirectoryDialog::ImportOptions& options);
+
+    /**
+     * @brief Import a list of files and directories, such as a drop on the window
+     *
+     * Directories are walked like start(const QString&, const ImportOptions&)
+     * does, in the order given; files are taken as they are.
+     * @param paths Paths of the files and directories
+     * @param options Import options
+     * @return false if an import is running
+     */
+    bool start(const QStringList& paths, const EnhancedAddDirectoryDialog::ImportOptions& options);
+
+    /**
+     * @brief Hand the durations read by the extractors to a cache
+     *
+     * The playlist then finds the duration of an imported track without
+     * probing the file again.
+     * @param cache Cache, or nullptr to keep none
+     */
+    void setDurationCache(DurationCache* cache) { m_durationCache = cache; }
+
+    /**
+     * @brief Stop after the files being read; tracks already written stay
+     */
+    void cancel();
+
+    void setPaused(bool paused);
+    bool isPaused() const { return m_paused; }
+    bool isRunning() const { return m_running; }
+
+    /**
+     * @brief Get the statistics of the running or last import
+     */
+    const EnhancedAddDirectoryDialog::ImportStatistics& statistics() const { return m_statistics; }
 
 signals:
     /**
-     * @brief Emitted when progress changes
-     * @param current Current progress
-     * @param total Total items
+     * @brief Emitted after each batch is written
+     * @param current Files done, including skipped and failed ones
+     * @param total Files found so far
      * @param message Progress message
      */
     void progressChanged(int current, int total, const QString& message);
 
     /**
-     * @brief Emitted when processing should be cancelled
+     * @brief Emitted as files are found, before any of them is written
+     * @param files Audio files found since the last signal
      */
-    void cancellationRequested();
+    void filesFound(const QStringList& files);
 
-private:
     /**
-     * @brief Process a single file
-     * @param filePath Path to the file
-     * @param options Import options
-     * @return true if file was processed successfully
+     * @brief Emitted after each batch is written
+     * @param items Tracks read from the batch's files, including those
+     *              the library already had
+     * @param failed Error message by path of the files that could not be read
      */
-    bool processSingleFile(const QString& filePath, 
-                          const EnhancedAddDirectoryDialog::ImportOptions& options);
-    
+    void batchWritten(const QList<MusicItem>& items, const QHash<QString, QString>& failed);
+
     /**
-     * @brief Check if file already exists in database
-     * @param filePath Path to the file
-     * @return true if file exists
+     * @brief Emitted when the last file is done, or after cancel()
+     * @param statistics Import statistics
+     * @param cancelled Whether the import was cancelled
      */
-    bool fileExistsInDatabase(const QString& filePath);
-    
+    void finished(const EnhancedAddDirectoryDialog::ImportStatistics& statistics, bool cancelled);
+
+private:
+    /**
+     * @brief Queue that blocks producers when full and consumers when empty
+     */
+    template <typename T>
+    class BoundedQueue
+    {
+    public:
+        void reset(int capacity)
+        {
+            QMutexLocker locker(&m_mutex);
+            m_items.clear();
+            m_capacity = qMax(1, capacity);
+            m_closed = false;
+            m_aborted = false;
+        }
+
+        /// Waits while full; false once aborted
+        bool push(T item)
+        {
+            QMutexLocker locker(&m_mutex);
+            while (!m_aborted && m_items.size() >= m_capacity) {
+                m_notFull.wait(&m_mutex);
+            }
+            if (m_aborted) {
+                return false;
+            }
+            m_items.enqueue(std::move(item));
+            m_notEmpty.wakeOne();
+            return true;
+        }
+
+        /// Waits while empty; false once closed and drained, or aborted
+        bool pop(T& item)
+        {
+            QMutexLocker locker(&m_mutex);
+            while (!m_aborted && !m_closed && m_items.isEmpty()) {
+                m_notEmpty.wait(&m_mutex);
+            }
+            if (m_aborted || m_items.isEmpty()) {
+                return false;
+            }
+            item = m_items.dequeue();
+            m_notFull.wakeOne();
+            return true;
+        }
+
+        /// Never waits
+        QList<T> take(int count)
+        {
+            QMutexLocker locker(&m_mutex);
+            QList<T> items;
+            while (!m_items.isEmpty() && items.size() < count) {
+                items.append(m_items.dequeue());
+            }
+            m_notFull.wakeAll();
+            return items;
+        }
+
+        /// No more items will be pushed
+        void close()
+        {
+            QMutexLocker locker(&m_mutex);
+            m_closed = true;
+            m_notEmpty.wakeAll();
+        }
+
+        /// Wake every waiting thread and drop what is queued
+        void abort()
+        {
+            QMutexLocker locker(&m_mutex);
+            m_aborted = true;
+            m_items.clear();
+            m_notEmpty.wakeAll();
+            m_notFull.wakeAll();
+        }
+
+        bool isClosed() const
+        {
+            QMutexLocker locker(&m_mutex);
+            return m_closed;
+        }
+
+        bool isDrained() const
+        {
+            QMutexLocker locker(&m_mutex);
+            return m_closed && m_items.isEmpty();
+        }
+
+        int size() const
+        {
+            QMutexLocker locker(&m_mutex);
+            return m_items.size();
+        }
+
+    private:
+        mutable QMutex m_mutex;
+        QWaitCondition m_notEmpty;
+        QWaitCondition m_notFull;
+        QQueue<T> m_items;
+        int m_capacity = 1;
+        bool m_closed = false;
+        bool m_aborted = false;
+    };
+
+    struct Extracted {
+        QString path;
+        std::shared_ptr<MusicItem> item;   ///< Null if the file cannot be imported
+        qint64 size = 0;
+        qint64 durationUs = -1;
+        QString error;
+    };
+
+    void run(std::function<void()> walk, const EnhancedAddDirectoryDialog::ImportOptions& options);
+    bool walkDirectory(const QString& directoryPath,
+                       const EnhancedAddDirectoryDialog::ImportOptions& options);
+    bool offer(const QString& filePath, qint64 size);
+    void extract();
+    void writeReady();
+    void finish(bool cancelled);
+    void stopStages();
+
     /**
-     * @brief Create music item from file
+     * @brief Build the library entry of a file; runs on a pool thread
      * @param filePath Path to the file
      * @param options Import options
-     * @return Music item
+     * @param error Set when the file cannot be imported
+     * @param durationUs Set to the duration read, or -1
+     * @return Music item, with an empty path on error
      */
-    MusicItem createMusicItemFromFile(const QString& filePath,
-                                    const EnhancedAddDirectoryDialog::ImportOptions& options);
+    static MusicItem createMusicItemFromFile(
+        const QString& filePath, const EnhancedAddDirectoryDialog::ImportOptions& options,
+        QString* error, qint64* durationUs);
 
-private:
     MusicRepository* m_repository;
-    std::atomic<bool> m_cancelled;
+    DurationCache* m_durationCache = nullptr;
+    QThreadPool m_pool;
+    int m_maxWorkers;
+    QTimer* m_writeTimer;
+
+    EnhancedAddDirectoryDialog::ImportOptions m_options;
+    EnhancedAddDirectoryDialog::ImportStatistics m_statistics;
+    BoundedQueue<QString> m_paths;
+    BoundedQueue<Extracted> m_extracted;
+    QMutex m_foundMutex;
+    QStringList m_newlyFound;   ///< Found by the walker, not yet in filesFound()
+    std::atomic<int> m_found{0};
+    std::atomic<qint64> m_foundSize{0};
+    std::atomic<int> m_extractorsLeft{0};
+    std::atomic<bool> m_cancelled{false};
+    bool m_running = false;
+    bool m_paused = false;
 };
 
 #endif // ENHANCEDADDDIRECTORYDIALOG_H
\ No newline at end of file
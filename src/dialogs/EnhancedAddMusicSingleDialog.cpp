@@ -1,6 +1,8 @@
 #include "EnhancedAddMusicSingleDialog.h"
 #include "../repositories/MusicRepository.h"
 #include "../services/InputValidator.h"
+#include "../services/MediaProbe.h"
+#include "../services/TagReader.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QFormLayout>
@@ -879,6 +881,12 @@ MetadataExtractionResult MetadataExtractor::extractMetadata(const QString& fileP
         return result;
     }
     
+    // The built-in reader needs no process; the tools only cover files it cannot read
+    MetadataExtractionResult native = extractNatively(filePath);
+    if (native.success) {
+        return native;
+    }
+    
     // Try different extraction methods in order of preference
     QStringList availableTools = getAvailableTools();
     
@@ -898,7 +906,8 @@ MetadataExtractionResult MetadataExtractor::extractMetadata(const QString& fileP
 
 bool MetadataExtractor::isMetadataExtractionAvailable()
 {
-    return !getAvailableTools().isEmpty();
+    // TagReader is built in, so there is always a way to read tags
+    return true;
 }
 
 QStringList MetadataExtractor::getAvailableTools()
@@ -916,6 +925,35 @@ QStringList MetadataExtractor::getAvailableTools()
     return tools;
 }
 
+MetadataExtractionResult MetadataExtractor::extractNatively(const QString& filePath)
+{
+    MetadataExtractionResult result;
+    
+    const TagReader::Tags tags = TagReader::read(filePath, &result.errorMessage);
+    const MediaProbe::ProbeResult probe = MediaProbe::probe(filePath);
+    if (!tags.hasTags() && !probe.isValid) {
+        if (result.errorMessage.isEmpty()) {
+            result.errorMessage = probe.errorMessage;
+        }
+        return result;
+    }
+    
+    result.title = tags.title;
+    result.artist = tags.artist;
+    result.album = tags.album;
+    result.genre = tags.genre;
+    result.duration = probe.isValid ? probe.durationMs() : 0;
+    result.bitrate = probe.bitrateKbps;
+    result.sampleRate = probe.sampleRate;
+    
+    QFileInfo fileInfo(filePath);
+    result.fileSize = fileInfo.size();
+    result.format = fileInfo.suffix().toUpper();
+    result.success = true;
+    
+    return result;
+}
+
 MetadataExtractionResult MetadataExtractor::extractWithExifTool(const QString& filePath)
 {
     MetadataExtractionResult result;
@@ -401,6 +401,13 @@ public:
     static QStringList getAvailableTools();
 
 private:
+    /**
+     * @brief Extract metadata with the built-in TagReader and MediaProbe
+     * @param filePath Path to the audio file
+     * @return Extraction result; not successful if neither tags nor a duration were found
+     */
+    static MetadataExtractionResult extractNatively(const QString& filePath);
+    
     /**
      * @brief Extract metadata using exiftool
      * @param filePath Path to the audio file
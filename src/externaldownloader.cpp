@@ -1,21 +1,26 @@
 #include "externaldownloader.h"
 #include "ui_externaldownloader.h"
-#include "QProcess"
 #include <QMessageBox>
 #include <QtSql>
 #include <QDir>
 #include "addgenre.h"
 #include "player.h"
-#include <QtConcurrent>
+#include "services/DownloadQueue.h"
 
 //#include "permission_utils.h"
 
 
-externaldownloader::externaldownloader(QWidget *parent) :
+externaldownloader::externaldownloader(DownloadQueue *downloads, QWidget *parent) :
     QWidget(parent),
-    ui(new Ui::externaldownloader)
+    ui(new Ui::externaldownloader),
+    downloads(downloads)
 {
     ui->setupUi(this);
+    ui->txt_videoLink->setPlaceholderText(
+        tr("Paste one or more links, separated by spaces or new lines"));
+    ui->txt_artist->setPlaceholderText(tr("From the video if left empty"));
+    ui->txt_song->setPlaceholderText(tr("From the video if left empty"));
+    connectQueue();
 
     /*
     // --- Check Permissions Early ---
@@ -172,485 +177,85 @@ externaldownloader::~externaldownloader()
     delete ui;
 }
 
-void externaldownloader::showLoadingFrame(){
-    ui->frame_loading->show();
-    //this down here allows us to show the splash sreen
-    QTime dieTime= QTime::currentTime().addSecs(1);
-       while( QTime::currentTime() < dieTime )
-       QCoreApplication::processEvents(QEventLoop::AllEvents, 100);
-    getFile();
-}
-
-// --- Helper Function (Consider placing in a utility class or namespace) ---
-// Basic sanitization for potentially problematic filename characters *if needed*
-// beyond what yt-dlp does. Often, relying on yt-dlp is sufficient.
-QString sanitizeFilenameComponent(QString component) {
-    // Remove characters problematic for *most* filesystems. Adjust as needed.
-    // Using QRegularExpression for cleaner removal.
-    component.remove(QRegularExpression(R"([\\/:*?"<>|])")); // Common Windows/Unix problematic chars
-    component.replace(".", ""); // Keep the dot removal if specifically required
-    component.replace("'", "");
-    component.replace("\"", "");
-    return component.trimmed(); // Remove leading/trailing whitespace
-}
-// --- Database Parameters Struct (Optional but good practice) ---
-struct DatabaseCredentials {
-    QString driver;        // e.g., "QSQLITE", "QPSQL"
-    QString databaseName; // e.g., path for SQLite, name for PostgreSQL
-    QString hostName;      // Optional, depends on driver
-    QString userName;      // Optional
-    QString password;      // Optional
-    QString connectionName; // The *original* main connection name
-};
-
-// --- Function to run in a separate thread ---
-struct DownloadResult {
-    bool success = false;
-    QString message;
-    QString consoleOutput;
-};
-
-DownloadResult processDownloadTask(
-    QString ylink,
-    QString yartist,
-    QString ysong,
-    QString g1,
-    QString g2,
-    QString country,
-    QString pub_date,
-    DatabaseCredentials dbCreds
-    ) {
-    DownloadResult result;
-    QStringList consoleLines; // Accumulate console output
-
-    auto appendOutput = [&](const QString& line) {
-        qDebug().noquote() << "[Worker]" << line; // Log worker output
-        consoleLines.append(line);
-    };
-
-    appendOutput("Starting download task in thread: " + QString::number((quintptr)QThread::currentThreadId()));
-
-    // Generate a unique connection name for this worker thread
-    QString workerConnectionName = QString("worker_%1").arg(QUuid::createUuid().toString(QUuid::WithoutBraces));
-
-    // --- Database Connection Handling ---
-    QSqlDatabase db; // Declare here to manage scope for cleanup
-
-    { // Scope to ensure db object is accessible for cleanup if addDatabase fails
-        db = QSqlDatabase::addDatabase(dbCreds.driver, workerConnectionName);
-        if (!db.isValid()) {
-            result.success = false;
-            result.message = "Error: Failed to add database driver '" + dbCreds.driver + "' in worker thread.";
-            appendOutput(result.message);
-            result.consoleOutput = consoleLines.join("\n");
-            // No need to removeDatabase yet as it wasn't successfully added
-            return result;
-        }
-
-        db.setDatabaseName(dbCreds.databaseName);
-        if (!dbCreds.hostName.isEmpty()) db.setHostName(dbCreds.hostName);
-        if (!dbCreds.userName.isEmpty()) db.setUserName(dbCreds.userName);
-        if (!dbCreds.password.isEmpty()) db.setPassword(dbCreds.password);
-        // Set other parameters like port if needed
-
-        if (!db.open()) {
-            result.success = false;
-            result.message = "Error: Could not open database connection '" + workerConnectionName + "' in worker thread. Error: " + db.lastError().text();
-            appendOutput(result.message);
-            db.close(); // Attempt to close
-            QSqlDatabase::removeDatabase(workerConnectionName); // Clean up
-            result.consoleOutput = consoleLines.join("\n");
-            return result;
-        }
-        appendOutput("Database connection '" + workerConnectionName + "' opened successfully in worker thread.");
-
-    } // End of initial scope, db object persists
-
-    // 1. Sanitize Artist/Song for Filename (Optional - yt-dlp's template often handles this)
-    // If you still want manual sanitization:
-    // QString safeArtist = sanitizeFilenameComponent(yartist);
-    // QString safeSong = sanitizeFilenameComponent(ysong);
-    // If relying on yt-dlp:
-    QString safeArtist = yartist; // Use original for metadata, yt-dlp handles filename
-    QString safeSong = ysong;
-
-    if (safeArtist.isEmpty() || safeSong.isEmpty()) {
-        result.success = false;
-        result.message = "Error: Artist and Song name cannot be empty.";
-        appendOutput(result.message);
-        result.consoleOutput = consoleLines.join("\n");
-        return result;
-    }
-
-    // 2. Determine Music Directory (More Robustly)
-    // Option A: Relative to executable
-    QString musicBaseDir = QCoreApplication::applicationDirPath() + "/../music";
-    // Option B: Standard Music Location (Recommended for user data)
-    // QString musicBaseDir = QStandardPaths::writableLocation(QStandardPaths::MusicLocation) + "/" + QCoreApplication::applicationName() + "/music";
-    // Option C: Make it configurable
-
-    QDir musicDir(musicBaseDir);
-    if (!musicDir.exists()) {
-        if (!musicDir.mkpath(".")) {
-            result.success = false;
-            result.message = "Error: Cannot create music directory: " + musicDir.absolutePath();
-            appendOutput(result.message);
-            result.consoleOutput = consoleLines.join("\n");
-            return result;
-        }
-        appendOutput("Created music directory: " + musicDir.absolutePath());
-    }
-    QString targetBaseFilename = safeArtist + " - " + safeSong;
-    // Let yt-dlp add the extension based on format
-    QString outputPathTemplate = musicDir.absoluteFilePath(targetBaseFilename + ".%(ext)s");
-
-
-    // 3. Find yt-dlp executable
-    QString ytdlpPath = QStandardPaths::findExecutable("yt-dlp");
-    
-#ifdef Q_OS_WIN
-    // On Windows, check common extensions if findExecutable fails without them
-    if (ytdlpPath.isEmpty()) ytdlpPath = QStandardPaths::findExecutable("yt-dlp.exe");
-    if (ytdlpPath.isEmpty()) ytdlpPath = QStandardPaths::findExecutable("yt-dlp.cmd");
-    if (ytdlpPath.isEmpty()) ytdlpPath = QStandardPaths::findExecutable("yt-dlp.bat");
-#endif
-
-#ifdef Q_OS_MACOS
-    // On macOS, GUI apps don't inherit shell PATH, so check common installation locations
-    if (ytdlpPath.isEmpty()) {
-        QStringList commonPaths = {
-            "/opt/homebrew/bin/yt-dlp",     // Homebrew on Apple Silicon
-            "/usr/local/bin/yt-dlp",        // Homebrew on Intel Macs
-            "/opt/local/bin/yt-dlp",        // MacPorts
-            QDir::homePath() + "/.local/bin/yt-dlp",  // pip user install
-            "/usr/bin/yt-dlp"               // System install
-        };
-        
-        for (const QString& path : commonPaths) {
-            if (QFile::exists(path)) {
-                ytdlpPath = path;
-                break;
-            }
-        }
-    }
-#endif
-
-    if (ytdlpPath.isEmpty()) {
-        result.success = false;
-        result.message = "Error: 'yt-dlp' executable not found in PATH or common installation locations. Please install yt-dlp and ensure it's accessible.";
-        appendOutput(result.message);
-        result.consoleOutput = consoleLines.join("\n");
-        return result;
-    }
-    appendOutput("Found yt-dlp at: " + ytdlpPath);
-
-    // 4. Prepare and Run yt-dlp command
-    QStringList ytdlpArgs;
-    ytdlpArgs << "--extract-audio"
-              << "--audio-format" << "m4a"  // Use M4A/AAC format for better Qt6 compatibility on macOS
-              << "--audio-quality" << "0"   // Best quality
-              << "-o" << outputPathTemplate // Output template
-              << "--ffmpeg-location" << QStandardPaths::findExecutable("ffmpeg") // Explicitly provide ffmpeg path if needed
-              << ylink;                        // The URL
-
-    appendOutput("Executing: " + ytdlpPath + " " + ytdlpArgs.join(" "));
-
-    QProcess ytdlpProcess;
-    ytdlpProcess.setProcessChannelMode(QProcess::MergedChannels); // Combine stdout and stderr
-    ytdlpProcess.setProgram(ytdlpPath);
-    ytdlpProcess.setArguments(ytdlpArgs);
-
-    QEventLoop loopYtdlp;
-    QObject::connect(&ytdlpProcess, &QProcess::finished, &loopYtdlp, &QEventLoop::quit);
-    QObject::connect(&ytdlpProcess, &QProcess::readyRead, [&]() {
-        appendOutput(QString::fromUtf8(ytdlpProcess.readAll())); // Read output as it comes
+void externaldownloader::connectQueue()
+{
+    // The window only shows what the queue is doing; closing it stops nothing
+    connect(downloads, &DownloadQueue::jobStarted, this, [this](const QString &url, int attempt) {
+        ui->txt_teminal_yd1->appendPlainText(
+            attempt == 1 ? tr("Downloading %1").arg(url)
+                         : tr("Downloading %1, attempt %2").arg(url).arg(attempt));
+    });
+    connect(downloads, &DownloadQueue::outputReceived, this,
+            [this](const QString &, const QString &line) {
+                ui->txt_teminal_yd1->appendPlainText(line);
+            });
+    connect(downloads, &DownloadQueue::jobFinished, this,
+            [this](const QString &url, const QString &filePath, bool ok, const QString &error,
+                   bool willRetry) {
+                if (ok) {
+                    ui->txt_teminal_yd1->appendPlainText(tr("Downloaded %1").arg(filePath));
+                } else if (willRetry) {
+                    ui->txt_teminal_yd1->appendPlainText(
+                        tr("%1 failed, trying again shortly: %2").arg(url, error));
+                } else {
+                    ui->txt_teminal_yd1->appendPlainText(tr("Gave up on %1: %2").arg(url, error));
+                }
+            });
+    connect(downloads, &DownloadQueue::tracksAdded, this, [this](int count) {
+        ui->txt_teminal_yd1->appendPlainText(tr("%n track(s) added to the database", "", count));
+    });
+    connect(downloads, &DownloadQueue::finished, this, [this](int added, int failed) {
+        ui->txt_teminal_yd1->appendPlainText(
+            tr("--- Queue finished: %1 added, %2 failed ---").arg(added).arg(failed));
     });
-
-    ytdlpProcess.start();
-    appendOutput("Putting hamsters on the job... hold on... *a tribute to torrentz");
-    loopYtdlp.exec(); // Wait for finished signal
-
-    // Read any remaining output
-    appendOutput(QString::fromUtf8(ytdlpProcess.readAll()));
-
-    if (ytdlpProcess.exitStatus() != QProcess::NormalExit || ytdlpProcess.exitCode() != 0) {
-        result.success = false;
-        result.message = "Error: yt-dlp failed (Exit code: " + QString::number(ytdlpProcess.exitCode()) + "). Check console output for details.";
-        appendOutput(result.message);
-        result.consoleOutput = consoleLines.join("\n");
-        return result;
-    }
-
-    appendOutput("yt-dlp finished successfully.");
-
-    // Find the downloaded file (yt-dlp replaces %(ext)s with actual extension)
-    // Check common audio extensions that yt-dlp might use, prioritizing M4A
-    QStringList possibleExtensions = {"m4a", "aac", "mp3", "ogg", "opus", "webm"};
-    QString finalFilepath;
-    QString finalFilename;
-    QFileInfo fileInfo;
-    bool fileFound = false;
-    
-    for (const QString& ext : possibleExtensions) {
-        finalFilename = targetBaseFilename + "." + ext;
-        finalFilepath = musicDir.absoluteFilePath(finalFilename);
-        fileInfo.setFile(finalFilepath);
-        if (fileInfo.exists()) {
-            fileFound = true;
-            break;
-        }
-    }
-
-    if (!fileFound) {
-        result.success = false;
-        result.message = "Error: Expected output file not found after download. Checked extensions: " + possibleExtensions.join(", ");
-        appendOutput(result.message);
-        result.consoleOutput = consoleLines.join("\n");
-        return result;
-    }
-    appendOutput("Downloaded file seems to be at: " + finalFilepath);
-
-    bool dbhasmusic = false;
-    { // Scope for QSqlQuery
-        QSqlQuery queryCheck(db);
-        queryCheck.prepare("SELECT id FROM musics WHERE path = :path");
-        queryCheck.bindValue(":path", finalFilepath);
-        if (!queryCheck.exec()) {
-            result.success = false;
-            result.message = "Error checking database: " + queryCheck.lastError().text();
-            appendOutput(result.message);
-            appendOutput("Failing query: " + queryCheck.lastQuery());
-            result.consoleOutput = consoleLines.join("\n");
-            db.close();
-            return result;
-        }
-        if (queryCheck.next()) {
-            dbhasmusic = true;
-            appendOutput("Skipping: " + finalFilepath + " (Already in DB)");
-        }
-    } // QSqlQuery queryCheck goes out of scope
-
-
-    if (dbhasmusic) {
-        result.success = true; // Not an error, just already exists
-        result.message = "This song is already in the database.";
-        result.consoleOutput = consoleLines.join("\n");
-        db.close();
-        QSqlDatabase::removeDatabase(workerConnectionName);
-        appendOutput("Database connection '" + workerConnectionName + "' closed and removed.");
-        result.consoleOutput = consoleLines.join("\n");
-        return result;
-    }
-
-    // 6. Get Duration using exiftool (if not already in DB)
-    QString trackDuration = "-"; // Default value
-
-    QString exiftoolPath = QStandardPaths::findExecutable("exiftool");
-#ifdef Q_OS_WIN
-    if (exiftoolPath.isEmpty()) exiftoolPath = QStandardPaths::findExecutable("exiftool.exe");
-#endif
-
-    if (exiftoolPath.isEmpty()) {
-        appendOutput("Warning: 'exiftool' not found. Cannot get track duration.");
-    } else {
-        appendOutput("Found exiftool at: " + exiftoolPath);
-        QStringList exifArgs;
-        exifArgs << "-T" << "-Duration" << finalFilepath; // -T for tab-separated, -Duration for just duration
-
-        appendOutput("Executing: " + exiftoolPath + " " + exifArgs.join(" "));
-
-        QProcess exiftoolProcess;
-        exiftoolProcess.setProcessChannelMode(QProcess::MergedChannels);
-        exiftoolProcess.setProgram(exiftoolPath);
-        exiftoolProcess.setArguments(exifArgs);
-
-        QEventLoop loopExif;
-        QString exifOutput;
-        QObject::connect(&exiftoolProcess, &QProcess::finished, &loopExif, &QEventLoop::quit);
-        QObject::connect(&exiftoolProcess, &QProcess::readyRead, [&]() {
-            exifOutput += QString::fromUtf8(exiftoolProcess.readAllStandardOutput());
-        });
-
-        exiftoolProcess.start();
-        loopExif.exec(); // Wait for finished
-
-        exifOutput += QString::fromUtf8(exiftoolProcess.readAllStandardOutput()); // Get remaining
-
-        if (exiftoolProcess.exitStatus() == QProcess::NormalExit && exiftoolProcess.exitCode() == 0 && !exifOutput.trimmed().isEmpty()) {
-            // Expected output is just the duration string, e.g., "0:03:45.67" or "3.5 s"
-            trackDuration = exifOutput.trimmed();
-                // Optional: Normalize duration format here if needed (e.g., always to HH:MM:SS)
-            appendOutput("Track duration found: " + trackDuration);
-        } else {
-            appendOutput("Warning: exiftool failed or returned no duration. Exit code: " + QString::number(exiftoolProcess.exitCode()));
-            appendOutput("exiftool output: " + exifOutput);
-        }
-    }
-
-
-    // 7. Add to Database
-    { // Scope for QSqlQuery
-        QSqlQuery queryInsert(db);
-        queryInsert.prepare("INSERT INTO musics (id, artist, song, genre1, genre2, country, published_date, path, time, played_times, last_played) "
-                            "VALUES (NULL, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
-        queryInsert.addBindValue(yartist); // Use original non-sanitized for DB metadata
-        queryInsert.addBindValue(ysong);
-        queryInsert.addBindValue(g1);
-        queryInsert.addBindValue(g2);
-        queryInsert.addBindValue(country);
-        queryInsert.addBindValue(pub_date);
-        queryInsert.addBindValue(finalFilepath);
-        queryInsert.addBindValue(trackDuration); // Use fetched or default duration
-        queryInsert.addBindValue(0);       // Bind the integer 0
-        queryInsert.addBindValue("-");    // Bind the string "-"
-
-        // Add extra debug output right before exec()
-        appendOutput("--- Binding Values (Positional) ---");
-        appendOutput("SQL: " + queryInsert.lastQuery()); // See the prepared query
-        QList<QVariant> boundValues = queryInsert.boundValues();
-        appendOutput("Bound Value Count: " + QString::number(boundValues.size()));
-        for(int i = 0; i < boundValues.size(); ++i) {
-            appendOutput(QString("Bound Value %1: %2").arg(i).arg(boundValues.at(i).toString()));
-        }
-        appendOutput("--- Attempting exec() ---");
-
-
-        if (!queryInsert.exec()) {
-            result.success = false;
-            result.message = "Error adding to database: " + queryInsert.lastError().text();
-            appendOutput(result.message);
-            appendOutput("Failing query: " + queryInsert.lastQuery());
-            db.close();
-            QSqlDatabase::removeDatabase(workerConnectionName);
-            appendOutput("Database connection '" + workerConnectionName + "' closed and removed.");
-            result.consoleOutput = consoleLines.join("\n");
-            return result;
-        } else {
-            appendOutput("Successfully added to database.");
-            result.success = true;
-            result.message = "Video downloaded, converted, and added to database!";
-        }
-    } // QSqlQuery queryInsert goes out of scope
-
-    appendOutput("All Done in worker thread!");
-    db.close();
-    QSqlDatabase::removeDatabase(workerConnectionName);
-    appendOutput("Database connection '" + workerConnectionName + "' closed and removed.");
-    result.consoleOutput = consoleLines.join("\n");
-    return result;
 }
 
-
-// --- The method in your externaldownloader class ---
-void externaldownloader::getFile() {
-    ui->bt_youtube_getIt->setEnabled(false); // Disable button immediately
-    ui->txt_teminal_yd1->clear(); // Clear previous output
-    ui->txt_teminal_yd1->appendPlainText("Preparing download...");
-    ui->frame_loading->show(); // Show loading indicator
-
-    // 1. Gather UI Data (in the UI thread)
-    QString ylink = ui->txt_videoLink->text().trimmed();
-    QStringList ylinkparts = ylink.split('&'); // Basic cleaning of tracking params
-    ylink = ylinkparts[0];
-
-    QString yartist = ui->txt_artist->text().trimmed();
-    QString ysong = ui->txt_song->text().trimmed();
-    QString g1 = ui->cbox_g1->currentText();
-    QString g2 = ui->cbox_g2->currentText();
-    QString country = ui->checkBox_cplp->isChecked() ? "PT" : "Other country / language";
-    QString pub_date = ui->dateEdit_publishedDate->text(); // Assumes QDateEdit format is suitable
-
-    if (ylink.isEmpty() || yartist.isEmpty() || ysong.isEmpty()) {
-        QMessageBox::warning(this, tr("Input Missing"), tr("Please provide a Video Link, Artist, and Song title."));
-        ui->bt_youtube_getIt->setEnabled(true);
-        ui->frame_loading->hide();
-        ui->txt_teminal_yd1->appendPlainText("Operation cancelled: Missing input.");
+void externaldownloader::on_bt_youtube_getIt_clicked()
+{
+    const QStringList urls = DownloadQueue::splitUrls(ui->txt_videoLink->text());
+    if (urls.isEmpty()) {
+        QMessageBox::information(this, tr("yt-dlp Downloader"),
+                                 tr("Paste the link of at least one video."));
         return;
     }
 
-
-    // 2. DB
-    DatabaseCredentials creds;
-    QSqlDatabase mainDb = QSqlDatabase::database("xfb_connection"); // Get handle to main connection
-    if (!mainDb.isValid()) {
-        QMessageBox::critical(this, tr("Database Error"), tr("Main database connection 'xfb_connection' is not valid. Cannot proceed."));
-        ui->bt_youtube_getIt->setEnabled(true);
-        ui->frame_loading->hide();
+    if (downloads->program().isEmpty())
+        downloads->setProgram(DownloadQueue::findProgram());
+    if (downloads->program().isEmpty()) {
+        QMessageBox::critical(this, tr("yt-dlp Downloader Error"),
+                              tr("'yt-dlp' was not found in PATH or the usual installation "
+                                 "places. Please install yt-dlp and try again."));
         return;
     }
-    creds.driver = mainDb.driverName();
-    creds.databaseName = mainDb.databaseName();
-    creds.hostName = mainDb.hostName();     // May be empty depending on driver
-    creds.userName = mainDb.userName();     // May be empty
-    creds.password = mainDb.password();     // May be empty
-    creds.connectionName = mainDb.connectionName(); // Store original
-
-    // Create a watcher to monitor the background task
-    QFutureWatcher<DownloadResult> *watcher = new QFutureWatcher<DownloadResult>(this);
-
-    // Connect the watcher's finished signal to a slot in this class (the UI thread)
-    connect(watcher, &QFutureWatcher<DownloadResult>::finished, this, [this, watcher]() {
-        DownloadResult result = watcher->result(); // Get the result from the future
-
-        // Update UI safely from the main thread
-        ui->txt_teminal_yd1->appendPlainText("--- Task Finished ---");
-        ui->txt_teminal_yd1->appendPlainText(result.consoleOutput); // Append all console output at the end
-
-        if (result.success) {
-            QMessageBox::information(this, tr("yt-dlp Downloader"), result.message);
-            emit musicAdded(); // Emit signal to notify that music was added to database
-        } else {
-            QMessageBox::critical(this, tr("yt-dlp Downloader Error"), result.message);
-        }
-
-        ui->bt_youtube_getIt->setEnabled(true); // Re-enable button
-        ui->frame_loading->hide(); // Hide loading indicator
-        watcher->deleteLater(); // Clean up the watcher
-    });
-
-    // 3. Run the task in a separate thread from Qt's global thread pool
-    QFuture<DownloadResult> future = QtConcurrent::run(
-        processDownloadTask,
-        ylink, yartist, ysong, g1, g2, country, pub_date,
-        creds // Pass the credentials struct
-        );
-
-    // Set the future for the watcher to monitor
-    watcher->setFuture(future);
-
-    ui->txt_teminal_yd1->appendPlainText("Download task submitted to background thread...");
-    // The function returns immediately, UI remains responsive
-}
-
-void externaldownloader::on_bt_youtube_getIt_clicked()
-{
-    QString ylink = ui->txt_videoLink->text();
-
-
-
-    QStringList ylistparts = ylink.split("&");
-
-    /*
-    for(int i=0;i<ylistparts.count();i++){
-        qDebug()<<"ylistpart"<<i<<" has the value: "<<ylistparts[i];
-    }*/
-
-    ylink = ylistparts[0];
-
-    qDebug()<<"ylink is now: "<<ylink;
 
-    QString yartist = ui->txt_artist->text();
-    QString ysong = ui->txt_song->text();
-
-    if(ylink.isEmpty() || yartist.isEmpty() || ysong.isEmpty()){
-        QMessageBox::information(this,tr("yt-dlp Downloader"),tr("The link, the artist name and the song title are mandatory..."));
-    } else {
-        showLoadingFrame();
+    // Artist and song only make sense for a single link; the rest are named
+    // from their metadata
+    DownloadQueue::Request details;
+    if (urls.size() == 1) {
+        details.artist = ui->txt_artist->text().trimmed();
+        details.song = ui->txt_song->text().trimmed();
     }
-
-
-
+    details.genre1 = ui->cbox_g1->currentText();
+    details.genre2 = ui->cbox_g2->currentText();
+    details.country = ui->checkBox_cplp->isChecked() ? "PT" : "Other country / language";
+    details.publishedDate = ui->dateEdit_publishedDate->text();
+
+    const int queued = downloads->enqueue(DownloadQueue::requestsFor(urls, details));
+    ui->txt_teminal_yd1->appendPlainText(
+        tr("Queued %1 of %2 links; %3 downloads pending")
+            .arg(queued)
+            .arg(urls.size())
+            .arg(downloads->pendingCount()));
+    if (urls.size() > 1 && (!ui->txt_artist->text().isEmpty() || !ui->txt_song->text().isEmpty()))
+        ui->txt_teminal_yd1->appendPlainText(
+            tr("Artist and song are taken from each video when several links are queued."));
+
+    // Ready for the next links straight away
+    ui->txt_videoLink->clear();
+    ui->txt_artist->clear();
+    ui->txt_song->clear();
 }
+
 void externaldownloader::on_pushButton_clicked()
 {
 //manage genres
@@ -6,7 +6,7 @@
 #include <QtDebug>
 #include <QFileInfo>
 
-
+class DownloadQueue;
 
 namespace Ui {
 class externaldownloader;
@@ -17,23 +17,22 @@ class externaldownloader : public QWidget
     Q_OBJECT
 
 public:
-    explicit externaldownloader(QWidget *parent = 0);
+    // Downloads run in the queue, which outlives the window
+    explicit externaldownloader(DownloadQueue *downloads, QWidget *parent = 0);
     ~externaldownloader();
      QSqlDatabase adb;
 
-signals:
-    void musicAdded(); // Signal emitted when music is successfully added to database
-
 private slots:
     void on_bt_youtube_getIt_clicked();
     void on_pushButton_clicked();
-    void getFile();
-    void showLoadingFrame();
     void on_bt_close_clicked();
     void on_bt_clear_clicked();
 
 private:
+    void connectQueue();
+
     Ui::externaldownloader *ui;
+    DownloadQueue *downloads;
 };
 
 #endif // EXTERNALDOWNLOADER_H
@@ -1,4 +1,8 @@
 #include "player.h" // Your main window class
+#include "daemon/AutomationDaemon.h"
+#include "tools/pgo/TrainingWorkload.h"
+#include "services/ErrorHandler.h"
+#include "ui/NowPlayingDisplay.h"
 
 #include <QApplication>
 #include <QSettings>      // For reading/writing application settings
@@ -16,6 +20,16 @@
 #include <QApplication>
 int main(int argc, char *argv[])
 {
+    // Headless automation: no QApplication, no window
+    if (AutomationDaemon::isRequested(argc, argv)) {
+        return AutomationDaemon::exec(argc, argv);
+    }
+
+    // Training run of profile-guided builds, see the xfb_pgo_train target
+    if (TrainingWorkload::isRequested(argc, argv)) {
+        return TrainingWorkload::exec(argc, argv);
+    }
+
     // Set up multimedia environment before QApplication
     qputenv("QT_MULTIMEDIA_PREFERRED_PLUGINS", "gstreamer");
     qputenv("QT_ACCESSIBILITY", "1");
@@ -44,6 +58,19 @@ int main(int argc, char *argv[])
     QCoreApplication::setApplicationName("XFB");
     QCoreApplication::setOrganizationName("Netpack - Online Solutions");
 
+    // Start the log file early; it also receives the player's logging categories
+    ErrorHandler::instance().initialize();
+
+    // Lobby and studio screens: the board alone, following the station read-only
+    QString displayDatabase;
+    if (NowPlayingDisplay::isRequested(argc, argv, &displayDatabase)) {
+        NowPlayingDisplay display(displayDatabase.isEmpty()
+                                      ? AutomationDaemon::defaultDatabaseFile()
+                                      : displayDatabase);
+        display.showFullScreen();
+        return a.exec();
+    }
+
     QApplication::setStyle(QStyleFactory::create("Fusion"));
 
     // --- Splash Screen Initialization ---
@@ -206,7 +233,6 @@ int main(int argc, char *argv[])
 
     // --- Show Main Window & Finish Splash ---
     splash.showMessage(QObject::tr("XFB is Ready!"), alignit, msgColor);
-    QThread::msleep(300); // Optional short delay to ensure final message is seen
 
     if (fullScreen) {
         w.showFullScreen();
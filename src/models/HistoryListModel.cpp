@@ -0,0 +1,133 @@
+#include "HistoryListModel.h"
+#include <QFileInfo>
+#include <algorithm>
+
+HistoryListModel::HistoryListModel(int capacity, QObject* parent)
+    : QAbstractListModel(parent)
+    , m_capacity(std::max(1, capacity))
+{
+}
+
+int HistoryListModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : count();
+}
+
+QVariant HistoryListModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() >= count()) {
+        return QVariant();
+    }
+
+    const Entry& item = entry(index.row());
+    switch (role) {
+    case Qt::DisplayRole:
+        return formatLine(item.time, item.text);
+    case TimeRole:
+        return item.time;
+    case TextRole:
+        return item.text;
+    default:
+        return QVariant();
+    }
+}
+
+QString HistoryListModel::formatLine(const QDateTime& time, const QString& text)
+{
+    return time.toString("yyyy-MM-dd || hh:mm:ss ||") + " " + text;
+}
+
+void HistoryListModel::append(const QDateTime& time, const QString& text)
+{
+    if (count() < m_capacity) {
+        beginInsertRows(QModelIndex(), count(), count());
+        push({time, text});
+        endInsertRows();
+        return;
+    }
+
+    // The oldest row goes first so the view never holds more than the capacity
+    beginRemoveRows(QModelIndex(), 0, 0);
+    dropOldest();
+    endRemoveRows();
+    beginInsertRows(QModelIndex(), count() - 1, count() - 1);
+    push({time, text});
+    endInsertRows();
+}
+
+bool HistoryListModel::appendEvent(const EventJournal::Event& event)
+{
+    Entry item;
+    if (!entryFor(event, &item)) {
+        return false;
+    }
+    append(item.time, item.text);
+    return true;
+}
+
+int HistoryListModel::load(const QList<EventJournal::Event>& events)
+{
+    beginResetModel();
+    m_entries.clear();
+    m_first = 0;
+    m_count = 0;
+    for (const EventJournal::Event& event : events) {
+        Entry item;
+        if (entryFor(event, &item)) {
+            push(std::move(item));
+        }
+    }
+    endResetModel();
+    return count();
+}
+
+void HistoryListModel::clear()
+{
+    beginResetModel();
+    m_entries.clear();
+    m_first = 0;
+    m_count = 0;
+    endResetModel();
+}
+
+bool HistoryListModel::entryFor(const EventJournal::Event& event, Entry* entry)
+{
+    switch (event.type) {
+    case EventJournal::Type::TrackStart: {
+        const QString title = event.fields.value("title").toString();
+        entry->text = title.isEmpty() ? QFileInfo(event.fields.value("path").toString()).fileName()
+                                      : title;
+        break;
+    }
+    case EventJournal::Type::TakeOver:
+        if (event.fields.value("state").toString() != "started") {
+            return false;
+        }
+        entry->text = event.fields.value("stream").toString();
+        break;
+    default:
+        return false;
+    }
+    entry->time = event.time;
+    return !entry->text.isEmpty();
+}
+
+void HistoryListModel::push(Entry entry)
+{
+    if (m_count == m_capacity) {
+        dropOldest();
+    }
+    if (m_entries.size() < size_t(m_capacity)) {
+        m_entries.push_back(std::move(entry));
+    } else {
+        m_entries[slot(m_count)] = std::move(entry);
+    }
+    ++m_count;
+}
+
+void HistoryListModel::dropOldest()
+{
+    m_entries[m_first] = Entry();
+    m_first = (m_first + 1) % size_t(m_capacity);
+    --m_count;
+}
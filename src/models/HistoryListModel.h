@@ -0,0 +1,112 @@
+#ifndef HISTORYLISTMODEL_H
+#define HISTORYLISTMODEL_H
+
+#include "../services/EventJournal.h"
+#include <QAbstractListModel>
+#include <QDateTime>
+#include <QList>
+#include <QString>
+#include <vector>
+
+/**
+ * @brief What went on air, oldest first, for the history list
+ *
+ * The history list used to be a QListWidget that dropped its first item
+ * once it held 100, so it covered a few hours at most, and each of its
+ * items was a widget of its own. HistoryListModel keeps its entries in a
+ * ring of a fixed capacity: until the ring is full an entry is added at
+ * the end, then it takes the place of the oldest. Adding is O(1) either
+ * way and the memory used never grows past the capacity, which at
+ * DEFAULT_CAPACITY holds a whole day of airplay.
+ *
+ * At start up the list is filled from the EventJournal with what went on
+ * air earlier in the day, see load().
+ *
+ * @example
+ * @code
+ * HistoryListModel* history = new HistoryListModel(HistoryListModel::DEFAULT_CAPACITY, this);
+ * const QDateTime midnight(QDate::currentDate(), QTime(0, 0));
+ * history->load(EventJournal::read(journal->directory(), midnight, QDateTime::currentDateTime()));
+ * historyView->setModel(history);
+ * history->append(QDateTime::currentDateTime(), "song.ogg");
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class HistoryListModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    static constexpr int DEFAULT_CAPACITY = 2000;
+
+    enum Role {
+        TimeRole = Qt::UserRole,
+        TextRole
+    };
+
+    struct Entry {
+        QDateTime time;
+        QString text;   ///< What went on air, without the time
+    };
+
+    /**
+     * @param capacity Entries kept; the oldest go once there are more
+     * @param parent Parent object
+     */
+    explicit HistoryListModel(int capacity = DEFAULT_CAPACITY, QObject* parent = nullptr);
+
+    // QAbstractItemModel interface
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+    int capacity() const { return m_capacity; }
+    int count() const { return m_count; }
+    bool isEmpty() const { return m_count == 0; }
+
+    /**
+     * @brief An entry, oldest first; row must exist
+     */
+    const Entry& entry(int row) const { return m_entries[slot(row)]; }
+
+    /**
+     * @brief Line shown for an entry, e.g. "2026-10-14 || 12:00:00 || song.ogg"
+     */
+    static QString formatLine(const QDateTime& time, const QString& text);
+
+    /**
+     * @brief Add an entry at the end, in the place of the oldest once full
+     */
+    void append(const QDateTime& time, const QString& text);
+
+    /**
+     * @brief Add the entry for a journal event, if it is one the list shows
+     *
+     * Track starts are shown by title, or by file name without one, and
+     * TakeOvers that started by their stream; other events are skipped.
+     * @return true if an entry was added
+     */
+    bool appendEvent(const EventJournal::Event& event);
+
+    /**
+     * @brief Replace the entries with those of journal events
+     * @param events Events in the order they were written, as EventJournal::read() gives them
+     * @return Entries kept, at most the capacity
+     */
+    int load(const QList<EventJournal::Event>& events);
+
+    void clear();
+
+private:
+    static bool entryFor(const EventJournal::Event& event, Entry* entry);
+    size_t slot(int row) const { return (m_first + size_t(row)) % size_t(m_capacity); }
+    void push(Entry entry);
+    void dropOldest();
+
+    int m_capacity;
+    std::vector<Entry> m_entries;   ///< Grows to the capacity, then slots are reused
+    size_t m_first = 0;             ///< Slot of the oldest entry
+    int m_count = 0;
+};
+
+#endif // HISTORYLISTMODEL_H
@@ -0,0 +1,621 @@
+#include "LiveTableModel.h"
+#include <QDebug>
+#include <QSet>
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <algorithm>
+#include <functional>
+
+namespace {
+
+QString quoteIdentifier(const QString& name)
+{
+    QString quoted = name;
+    quoted.replace('"', "\"\"");
+    return QString("\"%1\"").arg(quoted);
+}
+
+// Storage class rank in SQLite's ORDER BY: NULL, numbers, text, blobs
+int storageRank(const QVariant& value)
+{
+    if (value.isNull()) {
+        return 0;
+    }
+    switch (value.typeId()) {
+    case QMetaType::Int:
+    case QMetaType::UInt:
+    case QMetaType::LongLong:
+    case QMetaType::ULongLong:
+    case QMetaType::Double:
+    case QMetaType::Bool:
+        return 1;
+    case QMetaType::QByteArray:
+        return 3;
+    default:
+        return 2;
+    }
+}
+
+// Heap behind a value: the variant, and the text or bytes it shares
+qint64 valueBytes(const QVariant& value)
+{
+    qint64 bytes = sizeof(QVariant);
+    switch (value.typeId()) {
+    case QMetaType::QString:
+        bytes += 16 + value.toString().capacity() * qint64(sizeof(QChar));
+        break;
+    case QMetaType::QByteArray:
+        bytes += 16 + value.toByteArray().capacity();
+        break;
+    default:
+        break;
+    }
+    return bytes;
+}
+
+int compareValues(const QVariant& left, const QVariant& right)
+{
+    const int leftRank = storageRank(left);
+    const int rightRank = storageRank(right);
+    if (leftRank != rightRank) {
+        return leftRank < rightRank ? -1 : 1;
+    }
+
+    switch (leftRank) {
+    case 0:
+        return 0;
+    case 1: {
+        const double a = left.toDouble();
+        const double b = right.toDouble();
+        return a < b ? -1 : (b < a ? 1 : 0);
+    }
+    case 3: {
+        const QByteArray a = left.toByteArray();
+        const QByteArray b = right.toByteArray();
+        return a < b ? -1 : (b < a ? 1 : 0);
+    }
+    default:
+        // BINARY collation compares UTF-8 bytes, which orders like UTF-16
+        // code units outside the surrogate range
+        return QString::compare(left.toString(), right.toString(), Qt::CaseSensitive);
+    }
+}
+
+} // namespace
+
+LiveTableModel::LiveTableModel(const QString& table, const QString& connectionName, QObject* parent)
+    : QAbstractTableModel(parent)
+    , m_table(table)
+    , m_connectionName(connectionName)
+{
+}
+
+int LiveTableModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : static_cast<int>(m_rows.size());
+}
+
+int LiveTableModel::columnCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : static_cast<int>(m_fields.size());
+}
+
+QVariant LiveTableModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_rows.size() || index.column() >= m_fields.size()) {
+        return QVariant();
+    }
+
+    if (role == Qt::DisplayRole || role == Qt::EditRole) {
+        return m_rows.at(index.row()).values.at(index.column());
+    }
+    return QVariant();
+}
+
+bool LiveTableModel::setData(const QModelIndex& index, const QVariant& value, int role)
+{
+    if (role != Qt::EditRole || !index.isValid() || index.row() >= m_rows.size()
+        || index.column() >= m_fields.size()) {
+        return false;
+    }
+
+    const Row& row = m_rows.at(index.row());
+    if (row.values.at(index.column()) == value) {
+        return true;
+    }
+
+    QSqlQuery query(QSqlDatabase::database(m_connectionName));
+    query.prepare(QString("UPDATE %1 SET %2 = ? WHERE rowid = ?")
+                      .arg(quoteIdentifier(m_table), quoteIdentifier(m_fields.at(index.column()))));
+    query.addBindValue(value);
+    query.addBindValue(row.key);
+    if (!query.exec()) {
+        m_lastError = query.lastError();
+        QString error = QString("SQL Error: %1").arg(m_lastError.text());
+        logError("setData", error, query.lastQuery());
+        emit operationError("setData", error);
+        return false;
+    }
+
+    // Read it back: the column affinity may have converted the value and the
+    // row may now sort elsewhere
+    return refreshRow(row.key);
+}
+
+QVariant LiveTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation == Qt::Horizontal && role == Qt::DisplayRole && section >= 0 && section < m_fields.size()) {
+        return m_fields.at(section);
+    }
+    return QAbstractTableModel::headerData(section, orientation, role);
+}
+
+Qt::ItemFlags LiveTableModel::flags(const QModelIndex& index) const
+{
+    if (!index.isValid()) {
+        return Qt::NoItemFlags;
+    }
+    return QAbstractTableModel::flags(index) | Qt::ItemIsEditable;
+}
+
+void LiveTableModel::sort(int column, Qt::SortOrder order)
+{
+    m_sortColumn = column >= 0 && column < m_fields.size() ? column : -1;
+    m_sortOrder = order;
+    refresh();
+}
+
+qint64 LiveTableModel::keyOf(int row) const
+{
+    return row >= 0 && row < m_rows.size() ? m_rows.at(row).key : -1;
+}
+
+qint64 LiveTableModel::memoryUsage() const
+{
+    const qint64 rows = m_rows.size();
+    // A hash node holds the key, the row and the next pointer
+    qint64 bytes = m_rows.capacity() * qint64(sizeof(Row))
+                   + m_rowOfKey.capacity() * qint64(sizeof(qint64) + sizeof(int) + sizeof(void*));
+    if (rows == 0) {
+        return bytes;
+    }
+
+    const qint64 step = qMax<qint64>(1, rows / MEMORY_SAMPLE_ROWS);
+    qint64 sampled = 0;
+    qint64 sampledRows = 0;
+    for (qint64 row = 0; row < rows; row += step) {
+        const QVariantList& values = m_rows.at(row).values;
+        sampled += (values.capacity() - values.size()) * qint64(sizeof(QVariant));
+        for (const QVariant& value : values) {
+            sampled += valueBytes(value);
+        }
+        ++sampledRows;
+    }
+    return bytes + sampled * rows / sampledRows;
+}
+
+bool LiveTableModel::select()
+{
+    QList<Row> rows;
+    if (!loadFields() || !readRows(QString(), QVariantList(), rows)) {
+        return false;
+    }
+
+    beginResetModel();
+    m_rows = rows;
+    rebuildKeyIndex();
+    endResetModel();
+    return true;
+}
+
+bool LiveTableModel::assignRows(const QStringList& fields, const QList<qint64>& keys,
+                                const QList<QVariantList>& values)
+{
+    if (keys.size() != values.size()) {
+        return false;
+    }
+    // The columns may have changed since the last read, as refresh() checks
+    if (fields != m_fields && (!loadFields() || fields != m_fields)) {
+        return false;
+    }
+
+    QList<Row> rows;
+    rows.reserve(keys.size());
+    for (int i = 0; i < keys.size(); ++i) {
+        rows.append({keys.at(i), values.at(i)});
+    }
+    if (m_sortColumn >= 0) {
+        std::sort(rows.begin(), rows.end(),
+                  [this](const Row& left, const Row& right) { return lessThan(left, right); });
+    } else {
+        std::sort(rows.begin(), rows.end(),
+                  [](const Row& left, const Row& right) { return left.key < right.key; });
+    }
+
+    beginResetModel();
+    m_rows = rows;
+    rebuildKeyIndex();
+    endResetModel();
+    return true;
+}
+
+bool LiveTableModel::refresh()
+{
+    // A schema change moves columns around; only a reset can express that
+    const QStringList previousFields = m_fields;
+    if (!loadFields()) {
+        return false;
+    }
+    if (m_fields != previousFields) {
+        return select();
+    }
+
+    QList<Row> rows;
+    if (!readRows(QString(), QVariantList(), rows)) {
+        return false;
+    }
+
+    emit batchStarted();
+    const Changes changes = applyRows(rows);
+    emit batchFinished(changes.inserted, changes.removed, changes.updated);
+    return true;
+}
+
+bool LiveTableModel::refreshRow(qint64 key)
+{
+    if (m_fields.isEmpty()) {
+        return select();
+    }
+
+    QList<Row> rows;
+    if (!readRows("rowid = ?", QVariantList{key}, rows)) {
+        return false;
+    }
+    if (rows.isEmpty()) {
+        removeKey(key); // Deleted, or no longer matches the filter
+        return true;
+    }
+
+    const Row& fresh = rows.first();
+    const int row = rowOfKey(key);
+    if (row < 0) {
+        const int position = insertPosition(fresh);
+        beginInsertRows(QModelIndex(), position, position);
+        m_rows.insert(position, fresh);
+        endInsertRows();
+        rebuildKeyIndex();
+        return true;
+    }
+
+    if (m_rows.at(row).values != fresh.values) {
+        m_rows[row].values = fresh.values;
+        emit dataChanged(index(row, 0), index(row, m_fields.size() - 1));
+    }
+
+    // Find where the row belongs among the others and move it there
+    const Row moved = m_rows.takeAt(row);
+    const int position = insertPosition(moved);
+    m_rows.insert(row, moved);
+    if (position != row) {
+        const int destination = position > row ? position + 1 : position;
+        if (beginMoveRows(QModelIndex(), row, row, QModelIndex(), destination)) {
+            m_rows.move(row, position);
+            endMoveRows();
+            rebuildKeyIndex();
+        }
+    }
+    return true;
+}
+
+void LiveTableModel::removeKey(qint64 key)
+{
+    const int row = rowOfKey(key);
+    if (row < 0) {
+        return;
+    }
+
+    beginRemoveRows(QModelIndex(), row, row);
+    m_rows.removeAt(row);
+    endRemoveRows();
+    rebuildKeyIndex();
+}
+
+void LiveTableModel::removeKeys(const QList<qint64>& keys)
+{
+    QList<int> rows;
+    for (qint64 key : keys) {
+        const int row = rowOfKey(key);
+        if (row >= 0) {
+            rows.append(row);
+        }
+    }
+    if (rows.isEmpty()) {
+        return;
+    }
+
+    // From the bottom up, so the rows still to remove keep their numbers
+    std::sort(rows.begin(), rows.end(), std::greater<int>());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+    int index = 0;
+    while (index < rows.size()) {
+        const int last = rows.at(index);
+        int first = last;
+        while (index + 1 < rows.size() && rows.at(index + 1) == first - 1) {
+            first = rows.at(++index);
+        }
+        ++index;
+
+        beginRemoveRows(QModelIndex(), first, last);
+        m_rows.remove(first, last - first + 1);
+        endRemoveRows();
+    }
+    rebuildKeyIndex();
+}
+
+bool LiveTableModel::applyChange(const TableChangeBus::Change& change)
+{
+    if (change.table != m_table) {
+        return true;
+    }
+    if (change.reset || m_fields.isEmpty()) {
+        return refresh();
+    }
+
+    removeKeys(change.removed);
+    bool read = true;
+    for (qint64 key : change.changed) {
+        read = refreshRow(key) && read;
+    }
+    return read;
+}
+
+bool LiveTableModel::readRows(const QString& condition, const QVariantList& bindings, QList<Row>& rows)
+{
+    QSqlQuery query(QSqlDatabase::database(m_connectionName));
+    query.setForwardOnly(true);
+    if (!query.prepare(selectStatement(condition))) {
+        m_lastError = query.lastError();
+        QString error = QString("SQL Error: %1").arg(m_lastError.text());
+        logError("readRows", error, query.lastQuery());
+        emit operationError("readRows", error);
+        return false;
+    }
+    // The filter comes first in the statement, so do its values
+    for (const QVariant& value : std::as_const(m_filterValues)) {
+        query.addBindValue(value);
+    }
+    for (const QVariant& value : bindings) {
+        query.addBindValue(value);
+    }
+    if (!query.exec()) {
+        m_lastError = query.lastError();
+        QString error = QString("SQL Error: %1").arg(m_lastError.text());
+        logError("readRows", error, query.lastQuery());
+        emit operationError("readRows", error);
+        return false;
+    }
+
+    const int fieldCount = static_cast<int>(m_fields.size());
+    while (query.next()) {
+        Row row;
+        row.key = query.value(0).toLongLong();
+        row.values.reserve(fieldCount);
+        for (int i = 0; i < fieldCount; ++i) {
+            row.values.append(query.value(i + 1));
+        }
+        rows.append(row);
+    }
+    return true;
+}
+
+bool LiveTableModel::loadFields()
+{
+    const QSqlRecord record = QSqlDatabase::database(m_connectionName).record(m_table);
+    if (record.isEmpty()) {
+        QString error = QString("Table %1 not found").arg(m_table);
+        logError("loadFields", error);
+        emit operationError("loadFields", error);
+        return false;
+    }
+
+    QStringList fields;
+    for (int i = 0; i < record.count(); ++i) {
+        fields.append(record.fieldName(i));
+    }
+    m_fields = fields;
+    if (m_sortColumn >= m_fields.size()) {
+        m_sortColumn = -1;
+    }
+    return true;
+}
+
+QString LiveTableModel::selectStatement(const QString& condition) const
+{
+    QStringList columns;
+    columns.reserve(m_fields.size() + 1);
+    columns.append("rowid");
+    for (const QString& field : m_fields) {
+        columns.append(quoteIdentifier(field));
+    }
+
+    QStringList conditions;
+    if (!m_filter.isEmpty()) {
+        conditions.append(QString("(%1)").arg(m_filter));
+    }
+    if (!condition.isEmpty()) {
+        conditions.append(QString("(%1)").arg(condition));
+    }
+
+    QString sql = QString("SELECT %1 FROM %2").arg(columns.join(", "), quoteIdentifier(m_table));
+    if (!conditions.isEmpty()) {
+        sql += " WHERE " + conditions.join(" AND ");
+    }
+
+    // Ties go by rowid so that lessThan() agrees with the query
+    const QString direction = m_sortOrder == Qt::AscendingOrder ? "ASC" : "DESC";
+    if (m_sortColumn >= 0) {
+        sql += QString(" ORDER BY %1 %2, rowid %2").arg(quoteIdentifier(m_fields.at(m_sortColumn)), direction);
+    } else {
+        sql += " ORDER BY rowid";
+    }
+    return sql;
+}
+
+bool LiveTableModel::lessThan(const Row& left, const Row& right) const
+{
+    int order = 0;
+    if (m_sortColumn >= 0) {
+        order = compareValues(left.values.at(m_sortColumn), right.values.at(m_sortColumn));
+    }
+    if (order == 0) {
+        if (m_sortColumn < 0) {
+            return left.key < right.key;
+        }
+        order = left.key < right.key ? -1 : (right.key < left.key ? 1 : 0);
+    }
+    return m_sortOrder == Qt::AscendingOrder ? order < 0 : order > 0;
+}
+
+int LiveTableModel::insertPosition(const Row& row) const
+{
+    auto it = std::upper_bound(m_rows.cbegin(), m_rows.cend(), row,
+                               [this](const Row& left, const Row& right) { return lessThan(left, right); });
+    return static_cast<int>(it - m_rows.cbegin());
+}
+
+LiveTableModel::Changes LiveTableModel::applyRows(QList<Row> rows)
+{
+    Changes changes;
+    QHash<qint64, int> newRowOfKey;
+    newRowOfKey.reserve(rows.size());
+    for (int i = 0; i < rows.size(); ++i) {
+        newRowOfKey.insert(rows.at(i).key, i);
+    }
+
+    // Remove rows that are gone, bottom up, one contiguous block at a time
+    for (int last = static_cast<int>(m_rows.size()) - 1; last >= 0; --last) {
+        if (newRowOfKey.contains(m_rows.at(last).key)) {
+            continue;
+        }
+        int first = last;
+        while (first > 0 && !newRowOfKey.contains(m_rows.at(first - 1).key)) {
+            --first;
+        }
+        beginRemoveRows(QModelIndex(), first, last);
+        m_rows.remove(first, last - first + 1);
+        endRemoveRows();
+        changes.removed += last - first + 1;
+        last = first;
+    }
+    rebuildKeyIndex();
+
+    QSet<qint64> keptKeys;
+    keptKeys.reserve(m_rows.size());
+    for (const Row& row : std::as_const(m_rows)) {
+        keptKeys.insert(row.key);
+    }
+
+    // Put the remaining rows in their new order
+    QList<Row> ordered;
+    ordered.reserve(m_rows.size());
+    for (const Row& row : std::as_const(rows)) {
+        if (keptKeys.contains(row.key)) {
+            ordered.append(m_rows.at(m_rowOfKey.value(row.key)));
+        }
+    }
+    moveRows(ordered);
+
+    // Update rows whose values changed, one contiguous block at a time
+    for (int row = 0; row < m_rows.size(); ++row) {
+        const QVariantList& values = rows.at(newRowOfKey.value(m_rows.at(row).key)).values;
+        if (m_rows.at(row).values == values) {
+            continue;
+        }
+        int last = row;
+        m_rows[row].values = values;
+        while (last + 1 < m_rows.size()) {
+            const QVariantList& next = rows.at(newRowOfKey.value(m_rows.at(last + 1).key)).values;
+            if (m_rows.at(last + 1).values == next) {
+                break;
+            }
+            m_rows[++last].values = next;
+        }
+        emit dataChanged(index(row, 0), index(last, m_fields.size() - 1));
+        changes.updated += last - row + 1;
+        row = last;
+    }
+
+    // Insert new rows where they sort, one contiguous block at a time
+    for (int row = 0; row < rows.size(); ++row) {
+        if (keptKeys.contains(rows.at(row).key)) {
+            continue;
+        }
+        int last = row;
+        while (last + 1 < rows.size() && !keptKeys.contains(rows.at(last + 1).key)) {
+            ++last;
+        }
+        beginInsertRows(QModelIndex(), row, last);
+        for (int i = row; i <= last; ++i) {
+            m_rows.insert(i, rows.at(i));
+        }
+        endInsertRows();
+        changes.inserted += last - row + 1;
+        row = last;
+    }
+
+    rebuildKeyIndex();
+    return changes;
+}
+
+void LiveTableModel::moveRows(const QList<Row>& ordered)
+{
+    bool changed = false;
+    for (int row = 0; row < ordered.size() && !changed; ++row) {
+        changed = ordered.at(row).key != m_rows.at(row).key;
+    }
+    if (!changed) {
+        return;
+    }
+
+    emit layoutAboutToBeChanged();
+
+    QHash<qint64, int> orderedRowOfKey;
+    orderedRowOfKey.reserve(ordered.size());
+    for (int row = 0; row < ordered.size(); ++row) {
+        orderedRowOfKey.insert(ordered.at(row).key, row);
+    }
+
+    // Selection and the current index follow their rows
+    const QModelIndexList from = persistentIndexList();
+    QModelIndexList to;
+    to.reserve(from.size());
+    for (const QModelIndex& index : from) {
+        const int row = orderedRowOfKey.value(m_rows.at(index.row()).key);
+        to.append(this->index(row, index.column()));
+    }
+
+    m_rows = ordered;
+    rebuildKeyIndex();
+    changePersistentIndexList(from, to);
+
+    emit layoutChanged();
+}
+
+void LiveTableModel::rebuildKeyIndex()
+{
+    m_rowOfKey.clear();
+    m_rowOfKey.reserve(m_rows.size());
+    for (int row = 0; row < m_rows.size(); ++row) {
+        m_rowOfKey.insert(m_rows.at(row).key, row);
+    }
+}
+
+void LiveTableModel::logError(const QString& operation, const QString& error, const QString& query)
+{
+    QString logMessage = QString("LiveTableModel(%1)::%2 - %3").arg(m_table, operation, error);
+    if (!query.isEmpty()) {
+        logMessage += QString(" (Query: %1)").arg(query);
+    }
+
+    qWarning() << logMessage;
+}
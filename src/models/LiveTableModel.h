@@ -0,0 +1,252 @@
+#ifndef LIVETABLEMODEL_H
+#define LIVETABLEMODEL_H
+
+#include "../services/TableChangeBus.h"
+#include <QAbstractTableModel>
+#include <QHash>
+#include <QList>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+
+/**
+ * @brief Editable model of one database table that refreshes without a reset
+ *
+ * LiveTableModel shows the same columns as a QSqlTableModel on the table,
+ * so code that reads cells by column index keeps working, but a refresh
+ * re-reads the table and applies only the difference to the view: rows that
+ * disappeared are removed, new rows are inserted where they sort, changed
+ * rows emit dataChanged() and rows that moved are rearranged with a layout
+ * change. Selection, current index and scroll position survive the refresh.
+ *
+ * Rows are identified by the table's rowid. When the caller knows which row
+ * changed, refreshRow() and removeKey() update that row alone without reading
+ * the rest of the table; applyChange() does the same for what TableChangeBus
+ * delivers.
+ *
+ * Edits through setData() are written to the table straight away.
+ *
+ * @example
+ * @code
+ * LiveTableModel* musics = new LiveTableModel("musics", "xfb_connection", this);
+ * musics->select();
+ * view->setModel(musics);
+ * connect(TableChangeBus::instance(), &TableChangeBus::tableChanged, musics,
+ *         &LiveTableModel::applyChange);
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class LiveTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @param table Table to show
+     * @param connectionName Name of the database connection to read it through
+     * @param parent Parent object
+     */
+    LiveTableModel(const QString& table, const QString& connectionName, QObject* parent = nullptr);
+
+    // QAbstractItemModel interface
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    bool setData(const QModelIndex& index, const QVariant& value, int role = Qt::EditRole) override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    Qt::ItemFlags flags(const QModelIndex& index) const override;
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+    /**
+     * @brief Get the table shown by the model
+     * @return Table name
+     */
+    QString tableName() const { return m_table; }
+
+    /**
+     * @brief Get the column of a table field
+     * @param fieldName Field name
+     * @return Column index, or -1 if the table has no such field
+     */
+    int fieldIndex(const QString& fieldName) const { return m_fields.indexOf(fieldName); }
+
+    /**
+     * @brief Restrict the rows to an SQL condition
+     *
+     * Takes effect at the next select() or refresh().
+     * @param filter WHERE condition without the keyword, or empty for all rows
+     * @param bindValues Values for the ? placeholders in filter, in order
+     */
+    void setFilter(const QString& filter, const QVariantList& bindValues = QVariantList())
+    {
+        m_filter = filter;
+        m_filterValues = bindValues;
+    }
+
+    /**
+     * @brief Get the current row condition
+     * @return WHERE condition, empty if none
+     */
+    QString filter() const { return m_filter; }
+
+    /**
+     * @brief Get the values bound to the placeholders of the row condition
+     * @return Values, in order
+     */
+    QVariantList filterValues() const { return m_filterValues; }
+
+    /**
+     * @brief Get the error of the last failed read or write
+     * @return Last error
+     */
+    QSqlError lastError() const { return m_lastError; }
+
+    /**
+     * @brief Get the rowid of a row
+     * @param row Model row
+     * @return rowid, or -1 if the row does not exist
+     */
+    qint64 keyOf(int row) const;
+
+    /**
+     * @brief Get the row showing a rowid
+     * @param key rowid
+     * @return Model row, or -1 if the row is not shown
+     */
+    int rowOfKey(qint64 key) const { return m_rowOfKey.value(key, -1); }
+
+    /**
+     * @brief Estimate the memory held by the rows
+     *
+     * Values are measured on at most MEMORY_SAMPLE_ROWS rows spread over the
+     * model and scaled up, so the estimate costs the same for any table.
+     * @return Bytes of the rows and of the rowid index
+     */
+    qint64 memoryUsage() const;
+
+    static constexpr int MEMORY_SAMPLE_ROWS = 256;
+
+public slots:
+    /**
+     * @brief Load the table from scratch, resetting the model
+     *
+     * Use this for the first load or when the filter changed so much that a
+     * diff would touch most rows anyway.
+     * @return true if the table was read
+     */
+    bool select();
+
+    /**
+     * @brief Show rows read elsewhere, resetting the model
+     *
+     * For rows read on another thread, such as a search's matches, through
+     * "SELECT rowid, * FROM" the table. They should be the rows the current
+     * filter matches, so that the next refresh() only applies what changed
+     * since. The rows are put in the model's sort order.
+     * @param fields Columns of the rows, in table order
+     * @param keys rowid of each row
+     * @param values Values of each row, in fields order
+     * @return false if fields are not the table's columns; nothing changes then
+     */
+    bool assignRows(const QStringList& fields, const QList<qint64>& keys,
+                    const QList<QVariantList>& values);
+
+    /**
+     * @brief Re-read the table and apply only what changed
+     * @return true if the table was read
+     */
+    bool refresh();
+
+    /**
+     * @brief Re-read one row and insert, update or remove it as needed
+     * @param key rowid of the row
+     * @return true if the row was read
+     */
+    bool refreshRow(qint64 key);
+
+    /**
+     * @brief Remove a row known to be deleted from the table
+     * @param key rowid of the row
+     */
+    void removeKey(qint64 key);
+
+    /**
+     * @brief Remove rows known to be deleted from the table
+     *
+     * Adjacent rows are removed together, so the view gets one removal per
+     * run of rows rather than one per row.
+     * @param keys rowids of the rows; those not shown are ignored
+     */
+    void removeKeys(const QList<qint64>& keys);
+
+    /**
+     * @brief Apply a change posted to TableChangeBus
+     *
+     * Changes of other tables are ignored. Removed rows go, changed rows are
+     * re-read one by one, and a reset is a refresh().
+     * @return true if the rows could be read
+     */
+    bool applyChange(const TableChangeBus::Change& change);
+
+signals:
+    /**
+     * @brief Emitted when a read or write fails
+     * @param operation Name of the operation
+     * @param error Error message
+     */
+    void operationError(const QString& operation, const QString& error);
+
+    /**
+     * @brief Emitted before refresh() applies the difference to the view
+     *
+     * Every row change up to the matching batchFinished() belongs to the
+     * same refresh, so listeners can treat them as one.
+     */
+    void batchStarted();
+
+    /**
+     * @brief Emitted after refresh() applied the difference to the view
+     * @param inserted Rows inserted
+     * @param removed Rows removed
+     * @param updated Rows whose values changed
+     */
+    void batchFinished(int inserted, int removed, int updated);
+
+private:
+    struct Row {
+        qint64 key = -1;
+        QVariantList values;
+    };
+
+    struct Changes {
+        int inserted = 0;
+        int removed = 0;
+        int updated = 0;
+    };
+
+    bool readRows(const QString& condition, const QVariantList& bindings, QList<Row>& rows);
+    bool loadFields();
+    QString selectStatement(const QString& condition) const;
+    bool lessThan(const Row& left, const Row& right) const;
+    int insertPosition(const Row& row) const;
+    Changes applyRows(QList<Row> rows);
+    void moveRows(const QList<Row>& ordered);
+    void rebuildKeyIndex();
+    void logError(const QString& operation, const QString& error, const QString& query = QString());
+
+    QString m_table;
+    QString m_connectionName;
+    QStringList m_fields;
+    QString m_filter;
+    QVariantList m_filterValues;
+    int m_sortColumn = -1;
+    Qt::SortOrder m_sortOrder = Qt::AscendingOrder;
+    QList<Row> m_rows;
+    QHash<qint64, int> m_rowOfKey;
+    QSqlError m_lastError;
+};
+
+#endif // LIVETABLEMODEL_H
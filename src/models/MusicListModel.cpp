@@ -1,5 +1,6 @@
 #include "MusicListModel.h"
 #include "../repositories/MusicRepository.h"
+#include "../services/DatabaseService.h"
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QDateTime>
@@ -23,23 +24,24 @@ const QStringList MusicListModel::s_columnHeaders = {
     QObject::tr("Last Played")
 };
 
+// Columns without a musics column of their own are empty: they can be
+// neither searched nor sorted on
 const QStringList MusicListModel::s_sqlColumnNames = {
     "id",
     "song",
     "artist",
-    "album",
+    "",
     "genre1",
-    "duration",
+    "time",
     "path",
-    "date_added",
-    "play_count",
+    "",
+    "played_times",
     "last_played"
 };
 
 MusicListModel::MusicListModel(MusicRepository* repository, QObject* parent)
     : QAbstractTableModel(parent)
     , m_repository(repository)
-    , m_itemCache(1000) // Default cache size
     , m_totalCount(0)
     , m_loadedCount(0)
     , m_batchSize(100)
@@ -53,9 +55,6 @@ MusicListModel::MusicListModel(MusicRepository* repository, QObject* parent)
     , m_preloadRadius(50)
     , m_cacheCleanupInterval(30000) // 30 seconds
 {
-    // Setup cache
-    m_itemCache.setMaxCost(m_maxCacheSize);
-    
     // Setup timers
     m_cacheCleanupTimer->setInterval(m_cacheCleanupInterval);
     m_cacheCleanupTimer->setSingleShot(false);
@@ -96,6 +95,11 @@ MusicListModel::~MusicListModel()
     }
 }
 
+void MusicListModel::setDatabaseService(DatabaseService* service)
+{
+    m_databaseService = service;
+}
+
 int MusicListModel::rowCount(const QModelIndex& parent) const
 {
     Q_UNUSED(parent)
@@ -114,11 +118,13 @@ QVariant MusicListModel::data(const QModelIndex& index, int role) const
         return QVariant();
     }
     
+    const int row = index.row();
+    
     // Check if we need to load more data
-    if (!isItemCached(index.row())) {
+    if (!m_rows.isLoaded(row)) {
         // Trigger loading for this range
         const_cast<MusicListModel*>(this)->loadDataBatch(
-            (index.row() / m_batchSize) * m_batchSize, 
+            (row / m_batchSize) * m_batchSize, 
             m_batchSize
         );
         
@@ -131,27 +137,24 @@ QVariant MusicListModel::data(const QModelIndex& index, int role) const
         return QVariant();
     }
     
-    auto item = getCachedItem(index.row());
-    if (!item) {
-        return QVariant();
-    }
+    touchRow(row);
     
     switch (role) {
     case Qt::DisplayRole:
     case Qt::EditRole:
-        return getDisplayData(*item, index.column());
+        return getDisplayData(row, index.column());
         
     case Qt::ToolTipRole:
-        return getTooltipData(*item, index.column());
+        return getTooltipData(row, index.column());
         
     case Qt::TextAlignmentRole:
         return getAlignmentData(index.column());
         
     case Qt::UserRole:
-        return QVariant::fromValue(*item);
+        return QVariant::fromValue(m_rows.item(row));
         
     case Qt::UserRole + 1: // Music ID role
-        return item->id;
+        return m_rows.id(row);
         
     default:
         return QVariant();
@@ -210,9 +213,7 @@ void MusicListModel::sort(int column, Qt::SortOrder order)
     m_sortOrder = order;
     
     // Clear cache and reload data with new sorting
-    m_itemCache.clear();
-    m_loadedRanges.clear();
-    m_loadedCount = 0;
+    invalidateRows();
     
     emit layoutChanged();
     
@@ -226,6 +227,7 @@ void MusicListModel::setBatchSize(int batchSize)
 {
     if (batchSize > 0 && batchSize != m_batchSize) {
         m_batchSize = batchSize;
+        resetPageAccess();
         qDebug() << "MusicListModel: Batch size set to" << batchSize;
     }
 }
@@ -239,7 +241,6 @@ void MusicListModel::setCacheSize(int maxItems)
 {
     if (maxItems > 0 && maxItems != m_maxCacheSize) {
         m_maxCacheSize = maxItems;
-        m_itemCache.setMaxCost(maxItems);
         qDebug() << "MusicListModel: Cache size set to" << maxItems;
     }
 }
@@ -261,9 +262,7 @@ void MusicListModel::setSearchFilter(const QString& searchText, const QList<int>
     m_searchColumns = columns;
     
     // Clear cache and reload
-    m_itemCache.clear();
-    m_loadedRanges.clear();
-    m_loadedCount = 0;
+    invalidateRows();
     
     updateTotalCount();
     
@@ -291,9 +290,7 @@ void MusicListModel::setGenreFilter(const QString& genre)
     m_genreFilter = genre;
     
     // Clear cache and reload
-    m_itemCache.clear();
-    m_loadedRanges.clear();
-    m_loadedCount = 0;
+    invalidateRows();
     
     updateTotalCount();
     
@@ -310,9 +307,44 @@ void MusicListModel::setGenreFilter(const QString& genre)
              << "- found" << m_totalCount << "results";
 }
 
+void MusicListModel::setMinPlayCountFilter(int minPlayCount)
+{
+    minPlayCount = std::max(0, minPlayCount);
+    if (m_minPlayCount == minPlayCount) {
+        return; // No change
+    }
+    
+    m_minPlayCount = minPlayCount;
+    applyFilterChange("Play count");
+}
+
+void MusicListModel::setDateRangeFilter(const QDate& startDate, const QDate& endDate)
+{
+    if (m_startDate == startDate && m_endDate == endDate) {
+        return; // No change
+    }
+    
+    m_startDate = startDate;
+    m_endDate = endDate;
+    applyFilterChange("Date range");
+}
+
+void MusicListModel::setDurationRangeFilter(int minDuration, int maxDuration)
+{
+    minDuration = std::max(0, minDuration);
+    maxDuration = std::max(0, maxDuration);
+    if (m_minDuration == minDuration && m_maxDuration == maxDuration) {
+        return; // No change
+    }
+    
+    m_minDuration = minDuration;
+    m_maxDuration = maxDuration;
+    applyFilterChange("Duration range");
+}
+
 void MusicListModel::clearFilters()
 {
-    if (m_searchText.isEmpty() && m_genreFilter.isEmpty()) {
+    if (!hasFilters()) {
         return; // No filters to clear
     }
     
@@ -321,11 +353,14 @@ void MusicListModel::clearFilters()
     m_searchText.clear();
     m_searchColumns.clear();
     m_genreFilter.clear();
+    m_minPlayCount = 0;
+    m_startDate = QDate();
+    m_endDate = QDate();
+    m_minDuration = 0;
+    m_maxDuration = 0;
     
     // Clear cache and reload
-    m_itemCache.clear();
-    m_loadedRanges.clear();
-    m_loadedCount = 0;
+    invalidateRows();
     
     updateTotalCount();
     
@@ -346,9 +381,7 @@ void MusicListModel::refresh()
     beginResetModel();
     
     // Clear all cached data
-    m_itemCache.clear();
-    m_loadedRanges.clear();
-    m_loadedCount = 0;
+    invalidateRows();
     
     updateTotalCount();
     
@@ -383,7 +416,10 @@ std::shared_ptr<MusicItem> MusicListModel::getMusicItem(const QModelIndex& index
         return nullptr;
     }
     
-    return getCachedItem(index.row());
+    if (!m_rows.isLoaded(index.row())) {
+        return nullptr;
+    }
+    return std::make_shared<MusicItem>(m_rows.item(index.row()));
 }
 
 std::shared_ptr<MusicItem> MusicListModel::getMusicItemById(int musicId) const
@@ -455,9 +491,8 @@ void MusicListModel::onMusicItemUpdated(const MusicItem& musicItem)
     // In a real implementation, you'd maintain a separate index for ID-based lookups
     // For now, just refresh the entire model
     // Clear cache and reload data
-    m_itemCache.clear();
-    m_loadedRanges.clear();
     beginResetModel();
+    invalidateRows();
     endResetModel();
 }
 
@@ -465,8 +500,6 @@ void MusicListModel::onMusicItemRemoved(int musicId)
 {
     // QCache doesn't support iteration, so we'll clear the cache and refresh
     // In a real implementation, you'd maintain a separate index for ID-based lookups
-    m_itemCache.clear();
-    
     // Refresh to get accurate count
     refresh();
 }
@@ -477,22 +510,41 @@ void MusicListModel::onDataLoadingFinished()
         return;
     }
     
+    const int startIndex = m_loadingOffset;
+    const bool stale = m_loadingGeneration != m_generation;
+    m_loadingOffset = -1;
+    
     try {
         QList<MusicItem> items = m_loadingWatcher->result();
+        if (stale) {
+            items.clear(); // Loaded for rows that no longer exist
+        }
         
-        // Cache the loaded items
-        int startIndex = m_loadedCount;
+        // Store the loaded items
         for (int i = 0; i < items.size(); ++i) {
-            auto item = std::make_shared<MusicItem>(items.at(i));
-            cacheItem(startIndex + i, item);
+            m_rows.setRow(startIndex + i, items.at(i));
         }
         
-        // Update loaded count
-        int oldLoadedCount = m_loadedCount;
-        m_loadedCount += items.size();
+        // Remember where the page ended so the next one can seek past it
+        if (!items.isEmpty()) {
+            m_lastArtist = items.last().artist;
+            m_lastSong = items.last().song;
+            m_lastId = items.last().id;
+            m_lastPageEnd = startIndex + items.size();
+        }
+        
+        // Rows loaded without a gap from the top
+        if (startIndex <= m_loadedCount) {
+            m_loadedCount = std::max(m_loadedCount, startIndex + static_cast<int>(items.size()));
+        }
         
-        // Mark range as loaded
-        markRangeLoaded(startIndex, startIndex + items.size() - 1);
+        // Count the page as read, then make room for it
+        if (!items.isEmpty()) {
+            const int endIndex = startIndex + items.size() - 1;
+            touchRow(startIndex);
+            touchRow(endIndex);
+            evictPages(startIndex, endIndex);
+        }
         
         // Emit data changed for the loaded range
         if (items.size() > 0) {
@@ -514,6 +566,13 @@ void MusicListModel::onDataLoadingFinished()
         
         qWarning() << "MusicListModel: Loading error:" << e.what();
     }
+    
+    // Move on to the page the view asked for last
+    if (m_pendingOffset >= 0) {
+        const int pendingOffset = m_pendingOffset;
+        m_pendingOffset = -1;
+        loadDataBatch(pendingOffset, m_batchSize);
+    }
 }
 
 void MusicListModel::onCacheCleanupTimer()
@@ -529,12 +588,21 @@ void MusicListModel::onPreloadTimer()
 
 void MusicListModel::loadDataBatch(int offset, int count)
 {
-    if (m_loadingState == Loading || !m_repository) {
+    if (!m_repository || offset < 0 || offset >= m_totalCount) {
+        return;
+    }
+    
+    // Check if this range is already loaded; the last page may be short
+    const int endIndex = std::min(offset + count, m_totalCount) - 1;
+    if (isRangeLoaded(offset, endIndex)) {
         return;
     }
     
-    // Check if this range is already loaded
-    if (isRangeLoaded(offset, offset + count - 1)) {
+    if (m_loadingState == Loading) {
+        // Only the newest request waits; older ones were scrolled past
+        if (offset != m_loadingOffset) {
+            m_pendingOffset = offset;
+        }
         return;
     }
     
@@ -547,19 +615,45 @@ void MusicListModel::loadDataBatch(int offset, int count)
 
 void MusicListModel::loadDataAsync(int offset, int count)
 {
-    // Create the query in the main thread
-    QString query = buildQuery();
-    query += QString(" LIMIT %1 OFFSET %2").arg(count).arg(offset);
+    // Build the clauses in the main thread; they read the filters
+    QVariantList bindValues;
+    const QString whereClause = buildWhereClause(bindValues);
+    const QString orderByClause = buildOrderByClause();
+    
+    // Unfiltered artist order is the repository's own order, which it can
+    // page by key: the next batch seeks past the last row already loaded
+    // instead of skipping offset rows on every scroll.
+    const bool repositoryOrder = !hasFilters() && m_sortColumn == ColumnArtist && m_sortOrder == Qt::AscendingOrder;
+    const bool continuesLastPage = offset > 0 && offset == m_lastPageEnd && m_lastId >= 0;
+    
+    MusicRepository::MusicSortKey lastKey;
+    int lastId = -1;
+    if (continuesLastPage) {
+        lastKey = {m_lastArtist, m_lastSong};
+        lastId = m_lastId;
+    }
+    
+    m_loadingOffset = offset;
+    m_loadingGeneration = m_generation;
+    
+    MusicRepository* repository = m_repository;
+    DatabaseService* databaseService = m_databaseService;
     
     // Run the query in a separate thread
-    QFuture<QList<MusicItem>> future = QtConcurrent::run([this, query]() -> QList<MusicItem> {
-        if (!m_repository) {
-            return QList<MusicItem>();
+    QFuture<QList<MusicItem>> future = QtConcurrent::run([repository, databaseService, whereClause, bindValues,
+                                                          orderByClause, repositoryOrder, continuesLastPage,
+                                                          lastKey, lastId, offset, count]() -> QList<MusicItem> {
+        if (repositoryOrder) {
+            if (offset == 0 || continuesLastPage) {
+                return repository->getMusicAfter(lastKey, lastId, count);
+            }
+            return repository->getAllMusic(count, offset);
         }
         
-        // This would need to be implemented in MusicRepository
-        // For now, return empty list
-        return QList<MusicItem>();
+        // Each pool thread keeps its own connection, so a page never waits
+        // for the repository lock held by the main thread
+        const QSqlDatabase connection = databaseService ? databaseService->threadConnection() : QSqlDatabase();
+        return repository->getMusicPage(whereClause, bindValues, orderByClause, count, offset, connection);
     });
     
     m_loadingWatcher->setFuture(future);
@@ -572,47 +666,72 @@ void MusicListModel::updateTotalCount()
         return;
     }
     
-    // Build count query
-    QString countQuery = "SELECT COUNT(*) FROM musics";
-    QString whereClause = buildWhereClause();
-    if (!whereClause.isEmpty()) {
-        countQuery += " WHERE " + whereClause;
-    }
-    
-    // Execute count query (this should be done asynchronously in production)
-    // For now, we'll use a placeholder value
     int oldCount = m_totalCount;
-    // m_totalCount = m_repository->getCount(countQuery);
-    m_totalCount = 1000; // Placeholder
+    QVariantList bindValues;
+    const QString whereClause = buildWhereClause(bindValues);
+    m_totalCount = std::max(0, m_repository->countMusic(whereClause, bindValues));
+    
+    // Row positions only hold for the query they were loaded with
+    m_rows.resize(m_totalCount);
+    resetPageAccess();
     
     if (oldCount != m_totalCount) {
         emit totalCountChanged(m_totalCount);
     }
 }
 
-QString MusicListModel::buildQuery() const
+void MusicListModel::invalidateRows()
 {
-    QString query = "SELECT " + s_sqlColumnNames.join(", ") + " FROM musics";
+    m_rows.clear();
+    m_pageAccess.fill(0);
+    m_loadedCount = 0;
+    m_lastId = -1;
+    m_lastPageEnd = -1;
+    m_pendingOffset = -1;
+    ++m_generation;
+}
+
+void MusicListModel::applyFilterChange(const char* description)
+{
+    beginResetModel();
     
-    QString whereClause = buildWhereClause();
-    if (!whereClause.isEmpty()) {
-        query += " WHERE " + whereClause;
-    }
+    // Clear cache and reload
+    invalidateRows();
+    
+    updateTotalCount();
+    
+    endResetModel();
     
-    QString orderByClause = buildOrderByClause();
-    if (!orderByClause.isEmpty()) {
-        query += " ORDER BY " + orderByClause;
+    // Load first batch with new filter
+    if (m_totalCount > 0) {
+        loadDataBatch(0, m_batchSize);
     }
     
-    return query;
+    emit filterResultsChanged(m_totalCount);
+    
+    qDebug() << "MusicListModel:" << description << "filter changed - found" << m_totalCount << "results";
+}
+
+bool MusicListModel::hasFilters() const
+{
+    return !m_searchText.isEmpty() || !m_genreFilter.isEmpty() || m_minPlayCount > 0
+           || m_startDate.isValid() || m_endDate.isValid() || m_minDuration > 0 || m_maxDuration > 0;
 }
 
-QString MusicListModel::buildWhereClause() const
+QString MusicListModel::buildWhereClause(QVariantList& bindValues) const
 {
     QStringList conditions;
     
     // Search filter
-    if (!m_searchText.isEmpty()) {
+    const QString matchExpression = (!m_searchText.isEmpty() && m_searchColumns.isEmpty())
+                                        ? MusicRepository::fullTextQuery(m_searchText)
+                                        : QString();
+    
+    if (!matchExpression.isEmpty() && m_repository && m_repository->isFullTextSearchAvailable()) {
+        // Searching all columns goes through the full-text index
+        conditions << "rowid IN (SELECT rowid FROM musics_fts WHERE musics_fts MATCH ?)";
+        bindValues << matchExpression;
+    } else if (!m_searchText.isEmpty()) {
         QStringList searchConditions;
         QList<int> columnsToSearch = m_searchColumns.isEmpty() ? 
             QList<int>{ColumnTitle, ColumnArtist, ColumnAlbum} : m_searchColumns;
@@ -620,7 +739,8 @@ QString MusicListModel::buildWhereClause() const
         for (int column : columnsToSearch) {
             QString columnName = getSqlColumnName(column);
             if (!columnName.isEmpty()) {
-                searchConditions << QString("%1 LIKE '%%2%'").arg(columnName, m_searchText);
+                searchConditions << QString("%1 LIKE ?").arg(columnName);
+                bindValues << QString("%%1%").arg(m_searchText);
             }
         }
         
@@ -629,9 +749,35 @@ QString MusicListModel::buildWhereClause() const
         }
     }
     
-    // Genre filter
+    // Genre filter; ignores case like the genre combo boxes, and so can use idx_musics_genre1
     if (!m_genreFilter.isEmpty()) {
-        conditions << QString("genre1 = '%1'").arg(m_genreFilter);
+        conditions << "genre1 = ? COLLATE NOCASE";
+        bindValues << m_genreFilter;
+    }
+    
+    // Range filters; each has an index (see MusicRepository::countMusic)
+    if (m_minPlayCount > 0) {
+        conditions << "played_times >= ?";
+        bindValues << m_minPlayCount;
+    }
+    
+    // last_played is ISO text, so whole days compare as prefixes
+    if (m_startDate.isValid()) {
+        conditions << "last_played >= ?";
+        bindValues << m_startDate.toString(Qt::ISODate);
+    }
+    if (m_endDate.isValid()) {
+        conditions << "last_played > '' AND last_played < ?";
+        bindValues << m_endDate.addDays(1).toString(Qt::ISODate);
+    }
+    
+    if (m_minDuration > 0) {
+        conditions << MusicRepository::durationSecondsSql() + " >= ?";
+        bindValues << m_minDuration;
+    }
+    if (m_maxDuration > 0) {
+        conditions << MusicRepository::durationSecondsSql() + " <= ?";
+        bindValues << m_maxDuration;
     }
     
     return conditions.join(" AND ");
@@ -656,34 +802,55 @@ QString MusicListModel::getSqlColumnName(int column) const
     return QString();
 }
 
-void MusicListModel::cacheItem(int index, std::shared_ptr<MusicItem> item)
+void MusicListModel::touchRow(int row) const
 {
-    if (item) {
-        m_itemCache.insert(index, new MusicItem(*item));
+    const int page = row / m_batchSize;
+    if (page < m_pageAccess.size()) {
+        m_pageAccess[page] = ++m_accessClock;
     }
 }
 
-std::shared_ptr<MusicItem> MusicListModel::getCachedItem(int index) const
+void MusicListModel::evictPages(int keepFirst, int keepLast)
 {
-    MusicItem* item = m_itemCache.object(index);
-    if (item) {
-        return std::make_shared<MusicItem>(*item);
+    const int keepFirstPage = keepFirst / m_batchSize;
+    const int keepLastPage = keepLast / m_batchSize;
+    
+    while (m_rows.loadedCount() > m_maxCacheSize) {
+        int oldest = -1;
+        for (int page = 0; page < m_pageAccess.size(); ++page) {
+            const quint64 access = m_pageAccess.at(page);
+            if (access != 0 && (page < keepFirstPage || page > keepLastPage)
+                && (oldest < 0 || access < m_pageAccess.at(oldest))) {
+                oldest = page;
+            }
+        }
+        if (oldest < 0) {
+            break; // Only the page just loaded is left
+        }
+        
+        m_rows.unloadRows(oldest * m_batchSize, (oldest + 1) * m_batchSize - 1);
+        m_pageAccess[oldest] = 0;
     }
-    return nullptr;
 }
 
-bool MusicListModel::isItemCached(int index) const
+void MusicListModel::resetPageAccess()
 {
-    return m_itemCache.contains(index);
+    const int pageCount = (m_totalCount + m_batchSize - 1) / m_batchSize;
+    m_pageAccess.fill(0, pageCount);
+    
+    // Pages that already hold rows stay eviction candidates
+    for (int row = 0; row < m_rows.rowCount(); ++row) {
+        if (m_rows.isLoaded(row)) {
+            m_pageAccess[row / m_batchSize] = 1;
+        }
+    }
 }
 
 void MusicListModel::cleanupCache()
 {
-    // The QCache will automatically remove least recently used items
-    // when it exceeds the maximum cost. This method could implement
-    // additional cleanup logic if needed.
-    
-    qDebug() << "MusicListModel: Cache cleanup - current size:" << m_itemCache.size();
+    // Pages are unloaded as new ones arrive; this only reports the usage
+    qDebug() << "MusicListModel: Cache cleanup - loaded rows:" << m_rows.loadedCount()
+             << "memory:" << m_rows.memoryUsage() << "bytes";
 }
 
 QString MusicListModel::formatDuration(qint64 durationMs) const
@@ -712,58 +879,50 @@ bool MusicListModel::isRangeLoaded(int startIndex, int endIndex) const
 {
     // Simplified check - in practice this would be more sophisticated
     for (int i = startIndex; i <= endIndex; ++i) {
-        if (!isItemCached(i)) {
+        if (!m_rows.isLoaded(i)) {
             return false;
         }
     }
     return true;
 }
 
-void MusicListModel::markRangeLoaded(int startIndex, int endIndex)
-{
-    // Mark the range as loaded in our tracking set
-    for (int i = startIndex; i <= endIndex; ++i) {
-        m_loadedRanges.insert(i);
-    }
-}
-
-QVariant MusicListModel::getDisplayData(const MusicItem& item, int column) const
+QVariant MusicListModel::getDisplayData(int row, int column) const
 {
     switch (column) {
     case ColumnId:
-        return item.id;
+        return m_rows.id(row);
     case ColumnTitle:
-        return item.song;
+        return m_rows.song(row);
     case ColumnArtist:
-        return item.artist;
+        return m_rows.artist(row);
     case ColumnAlbum:
         return QString(); // Album not available in current MusicItem structure
     case ColumnGenre:
-        return item.genre1;
+        return m_rows.genre1(row);
     case ColumnDuration:
-        return item.time; // Use time field instead of duration
+        return m_rows.time(row); // Use time field instead of duration
     case ColumnPath:
-        return item.path;
+        return m_rows.path(row);
     case ColumnDateAdded:
         return QString(); // Date added not available in current MusicItem structure
     case ColumnPlayCount:
-        return item.playedTimes;
+        return m_rows.playedTimes(row);
     case ColumnLastPlayed:
-        return item.lastPlayed; // lastPlayed is already a QString
+        return m_rows.lastPlayed(row);
     default:
         return QVariant();
     }
 }
 
-QVariant MusicListModel::getTooltipData(const MusicItem& item, int column) const
+QVariant MusicListModel::getTooltipData(int row, int column) const
 {
     switch (column) {
     case ColumnPath:
-        return item.path;
+        return m_rows.path(row);
     case ColumnTitle:
-        return QString("%1\nArtist: %2\nGenre: %3").arg(item.song, item.artist, item.genre1);
+        return QString("%1\nArtist: %2\nGenre: %3").arg(m_rows.song(row), m_rows.artist(row), m_rows.genre1(row));
     default:
-        return getDisplayData(item, column);
+        return getDisplayData(row, column);
     }
 }
 
@@ -823,6 +982,11 @@ MusicFilterProxyModel::MusicFilterProxyModel(QObject* parent)
 
 void MusicFilterProxyModel::setMinPlayCountFilter(int minPlayCount)
 {
+    if (auto* musicModel = qobject_cast<MusicListModel*>(sourceModel())) {
+        musicModel->setMinPlayCountFilter(minPlayCount);
+        return;
+    }
+    
     if (m_minPlayCount != minPlayCount) {
         m_minPlayCount = minPlayCount;
         invalidateFilter();
@@ -831,6 +995,11 @@ void MusicFilterProxyModel::setMinPlayCountFilter(int minPlayCount)
 
 void MusicFilterProxyModel::setDateRangeFilter(const QDate& startDate, const QDate& endDate)
 {
+    if (auto* musicModel = qobject_cast<MusicListModel*>(sourceModel())) {
+        musicModel->setDateRangeFilter(startDate, endDate);
+        return;
+    }
+    
     if (m_startDate != startDate || m_endDate != endDate) {
         m_startDate = startDate;
         m_endDate = endDate;
@@ -840,6 +1009,11 @@ void MusicFilterProxyModel::setDateRangeFilter(const QDate& startDate, const QDa
 
 void MusicFilterProxyModel::setDurationRangeFilter(int minDuration, int maxDuration)
 {
+    if (auto* musicModel = qobject_cast<MusicListModel*>(sourceModel())) {
+        musicModel->setDurationRangeFilter(minDuration, maxDuration);
+        return;
+    }
+    
     if (m_minDuration != minDuration || m_maxDuration != maxDuration) {
         m_minDuration = minDuration;
         m_maxDuration = maxDuration;
@@ -849,6 +1023,12 @@ void MusicFilterProxyModel::setDurationRangeFilter(int minDuration, int maxDurat
 
 bool MusicFilterProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex& sourceParent) const
 {
+    // MusicListModel already filtered in SQL; reading the row here would
+    // force every page to load
+    if (qobject_cast<const MusicListModel*>(sourceModel())) {
+        return true;
+    }
+    
     QModelIndex index = sourceModel()->index(sourceRow, 0, sourceParent);
     if (!index.isValid()) {
         return false;
@@ -867,15 +1047,22 @@ bool MusicFilterProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex& s
         return false;
     }
     
-    // Date filtering not available with current MusicItem structure
-    // Duration filtering not available with current MusicItem structure
-    int durationSeconds = 0; // Placeholder since duration is not available as integer
+    // Same rules as MusicListModel::buildWhereClause()
+    const QString lastPlayedDay = item.lastPlayed.left(10);
+    if (m_startDate.isValid() && lastPlayedDay < m_startDate.toString(Qt::ISODate)) {
+        return false;
+    }
+    if (m_endDate.isValid() && (lastPlayedDay.isEmpty() || lastPlayedDay > m_endDate.toString(Qt::ISODate))) {
+        return false;
+    }
+    
+    const int durationSeconds = MusicRowStore::parseDuration(item.time);
     if (m_minDuration > 0 && durationSeconds < m_minDuration) {
         return false;
     }
-    if (m_maxDuration > 0 && durationSeconds > m_maxDuration) {
+    if (m_maxDuration > 0 && (durationSeconds < 0 || durationSeconds > m_maxDuration)) {
         return false;
     }
     
     return true;
-}
\ No newline at end of file
+}
@@ -1,17 +1,19 @@
 #ifndef MUSICLISTMODEL_H
 #define MUSICLISTMODEL_H
 
+#include "MusicRowStore.h"
 #include <QAbstractTableModel>
 #include <QTimer>
-#include <QCache>
 #include <QFuture>
 #include <QFutureWatcher>
+#include <QPointer>
 #include <QSortFilterProxyModel>
 #include <QDate>
 #include <memory>
 
 // Forward declarations
 class MusicRepository;
+class DatabaseService;
 struct MusicItem;
 class QSqlDatabase;
 
@@ -30,6 +32,18 @@ class QSqlDatabase;
  * - Search and filtering support
  * - Sort support for all columns
  * 
+ * Pages are read on a QtConcurrent worker and handed back through
+ * m_loadingWatcher, one page at a time. A page requested while another is
+ * loading waits in a single pending slot, so when the view scrolls quickly
+ * only the page it stopped on is loaded; pages it scrolled past are
+ * dropped. Pages that arrive after a filter, sort or refresh invalidated
+ * them are discarded.
+ * 
+ * Loaded rows are kept in a MusicRowStore, so data() reads a few arrays
+ * instead of copying a MusicItem. Once more than cacheSize() rows are
+ * loaded, the pages of batchSize() rows that were read least recently are
+ * unloaded.
+ * 
  * @since XFB 2.0
  */
 class MusicListModel : public QAbstractTableModel
@@ -66,6 +80,15 @@ public:
     explicit MusicListModel(MusicRepository* repository, QObject* parent = nullptr);
     ~MusicListModel();
 
+    /**
+     * @brief Read pages on the loader thread's own database connection
+     *
+     * Without a service, pages run on the repository's connection and wait
+     * for its lock.
+     * @param service Database service, or nullptr to use the repository's connection
+     */
+    void setDatabaseService(DatabaseService* service);
+
     // QAbstractTableModel interface
     int rowCount(const QModelIndex& parent = QModelIndex()) const override;
     int columnCount(const QModelIndex& parent = QModelIndex()) const override;
@@ -112,6 +135,26 @@ public:
      */
     void setGenreFilter(const QString& genre);
 
+    /**
+     * @brief Only show items played at least a number of times
+     * @param minPlayCount Minimum play count (0 = no filter)
+     */
+    void setMinPlayCountFilter(int minPlayCount);
+
+    /**
+     * @brief Only show items last played within a range of days
+     * @param startDate First day (invalid = no lower bound)
+     * @param endDate Last day, inclusive (invalid = no upper bound)
+     */
+    void setDateRangeFilter(const QDate& startDate, const QDate& endDate);
+
+    /**
+     * @brief Only show items within a range of durations
+     * @param minDuration Minimum duration in seconds (0 = no filter)
+     * @param maxDuration Maximum duration in seconds (0 = no filter)
+     */
+    void setDurationRangeFilter(int minDuration, int maxDuration);
+
     /**
      * @brief Clear all filters
      */
@@ -267,16 +310,33 @@ private:
     void updateTotalCount();
 
     /**
-     * @brief Build SQL query with current filters and sorting
-     * @return SQL query string
+     * @brief Drop all loaded rows after the filters or sorting changed
+     *
+     * Pages still loading for the old rows are discarded when they arrive.
+     */
+    void invalidateRows();
+
+    /**
+     * @brief Reload the rows after a filter changed
+     * @param description Filter name for the log
      */
-    QString buildQuery() const;
+    void applyFilterChange(const char* description);
+
+    /**
+     * @brief Check if any filter is set
+     * @return true if rows are filtered
+     */
+    bool hasFilters() const;
 
     /**
      * @brief Build WHERE clause for current filters
+     *
+     * Filter values are never part of the clause; each has a ? placeholder
+     * and is appended to bindValues.
+     * @param bindValues Receives the values for the placeholders, in order
      * @return WHERE clause string
      */
-    QString buildWhereClause() const;
+    QString buildWhereClause(QVariantList& bindValues) const;
 
     /**
      * @brief Build ORDER BY clause for current sorting
@@ -292,25 +352,22 @@ private:
     QString getSqlColumnName(int column) const;
 
     /**
-     * @brief Cache music item
-     * @param index Row index
-     * @param item Music item to cache
+     * @brief Record a read of a row for page eviction
+     * @param row Loaded row
      */
-    void cacheItem(int index, std::shared_ptr<MusicItem> item);
+    void touchRow(int row) const;
 
     /**
-     * @brief Get cached music item
-     * @param index Row index
-     * @return Cached music item (null if not cached)
+     * @brief Unload least recently read pages until the cache size is respected
+     * @param keepFirst First row of the page just loaded, never unloaded
+     * @param keepLast Last row of the page just loaded
      */
-    std::shared_ptr<MusicItem> getCachedItem(int index) const;
+    void evictPages(int keepFirst, int keepLast);
 
     /**
-     * @brief Check if item is cached
-     * @param index Row index
-     * @return true if item is cached
+     * @brief Size the page access list for the current row count and batch size
      */
-    bool isItemCached(int index) const;
+    void resetPageAccess();
 
     /**
      * @brief Clean up old cache entries
@@ -340,21 +397,14 @@ private:
     bool isRangeLoaded(int startIndex, int endIndex) const;
 
     /**
-     * @brief Mark range as loaded
-     * @param startIndex Start index
-     * @param endIndex End index
-     */
-    void markRangeLoaded(int startIndex, int endIndex);
-    
-    /**
-     * @brief Get display data for a specific item and column
+     * @brief Get display data for a loaded row and column
      */
-    QVariant getDisplayData(const MusicItem& item, int column) const;
+    QVariant getDisplayData(int row, int column) const;
     
     /**
-     * @brief Get tooltip data for a specific item and column
+     * @brief Get tooltip data for a loaded row and column
      */
-    QVariant getTooltipData(const MusicItem& item, int column) const;
+    QVariant getTooltipData(int row, int column) const;
     
     /**
      * @brief Get alignment data for a specific column
@@ -370,12 +420,26 @@ private:
     MusicRepository* m_repository;
     
     // Data management
-    mutable QCache<int, MusicItem> m_itemCache;
-    QSet<int> m_loadedRanges; // Tracks which ranges have been loaded
+    MusicRowStore m_rows;
+    mutable QList<quint64> m_pageAccess; // Last read of each page, 0 while unloaded
+    mutable quint64 m_accessClock = 0;
     int m_totalCount;
     int m_loadedCount;
     int m_batchSize;
     
+    // Last row of the most recent repository page, for keyset paging
+    QString m_lastArtist;
+    QString m_lastSong;
+    int m_lastId = -1;
+    int m_lastPageEnd = -1; // Row after that page
+    
+    // Page requests
+    QPointer<DatabaseService> m_databaseService;
+    int m_loadingOffset = -1;   // First row of the page being loaded
+    int m_pendingOffset = -1;   // Newest page requested while loading
+    int m_generation = 0;       // Bumped by invalidateRows()
+    int m_loadingGeneration = 0;
+    
     // Loading state
     LoadingState m_loadingState;
     QFutureWatcher<QList<MusicItem>>* m_loadingWatcher;
@@ -386,6 +450,11 @@ private:
     QString m_searchText;
     QList<int> m_searchColumns;
     QString m_genreFilter;
+    int m_minPlayCount = 0;
+    QDate m_startDate;
+    QDate m_endDate;
+    int m_minDuration = 0;
+    int m_maxDuration = 0;
     int m_sortColumn;
     Qt::SortOrder m_sortOrder;
     
@@ -404,6 +473,10 @@ private:
  * 
  * This proxy model provides additional filtering capabilities
  * on top of the base MusicListModel.
+ * 
+ * When the source is a MusicListModel, the filters are handed to it and
+ * run in SQL, so only matching rows are ever loaded. Other sources are
+ * filtered row by row in filterAcceptsRow().
  */
 class MusicFilterProxyModel : public QSortFilterProxyModel
 {
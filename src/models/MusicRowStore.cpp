@@ -0,0 +1,217 @@
+#include "MusicRowStore.h"
+#include "../repositories/MusicRepository.h"
+#include <QStringList>
+#include <algorithm>
+
+MusicRowStore::MusicRowStore()
+{
+    m_symbols.append(QString());
+    m_symbolIds.insert(QString(), 0);
+}
+
+void MusicRowStore::resize(int rowCount)
+{
+    m_slotOfRow.fill(-1, std::max(0, rowCount));
+    m_slots.clear();
+    m_freeSlots.clear();
+    m_pool.clear();
+    m_unusedPoolChars = 0;
+}
+
+void MusicRowStore::clear()
+{
+    resize(rowCount());
+}
+
+void MusicRowStore::setRow(int row, const MusicItem& item)
+{
+    if (row < 0 || row >= rowCount()) {
+        return;
+    }
+
+    if (m_slotOfRow.at(row) >= 0) {
+        releaseSlot(m_slotOfRow.at(row));
+    }
+
+    Record record;
+    record.id = item.id;
+    record.artist = intern(item.artist);
+    record.genre1 = intern(item.genre1);
+    record.genre2 = intern(item.genre2);
+    record.country = intern(item.country);
+    record.publishedDate = intern(item.publishedDate);
+    record.playedTimes = item.playedTimes;
+    record.song = appendToPool(item.song);
+    record.path = appendToPool(item.path);
+    record.lastPlayed = appendToPool(item.lastPlayed);
+
+    // Keep the original text only when it would not come back the same
+    record.durationSecs = parseDuration(item.time);
+    const bool roundTrips = record.durationSecs >= 0 ? formatDuration(record.durationSecs) == item.time
+                                                     : item.time.isEmpty();
+    if (!roundTrips) {
+        record.rawTime = appendToPool(item.time);
+    }
+
+    qint32 slot;
+    if (!m_freeSlots.isEmpty()) {
+        slot = m_freeSlots.takeLast();
+        m_slots[slot] = record;
+    } else {
+        slot = static_cast<qint32>(m_slots.size());
+        m_slots.append(record);
+    }
+    m_slotOfRow[row] = slot;
+}
+
+void MusicRowStore::unloadRows(int first, int last)
+{
+    first = std::max(0, first);
+    last = std::min(last, rowCount() - 1);
+
+    for (int row = first; row <= last; ++row) {
+        const qint32 slot = m_slotOfRow.at(row);
+        if (slot >= 0) {
+            releaseSlot(slot);
+            m_slotOfRow[row] = -1;
+        }
+    }
+
+    if (m_unusedPoolChars >= MIN_COMPACT_CHARS && m_unusedPoolChars * 2 >= m_pool.size()) {
+        compactPool();
+    }
+}
+
+MusicItem MusicRowStore::item(int row) const
+{
+    MusicItem music;
+    music.id = id(row);
+    music.artist = artist(row);
+    music.song = song(row);
+    music.genre1 = genre1(row);
+    music.genre2 = genre2(row);
+    music.country = country(row);
+    music.publishedDate = publishedDate(row);
+    music.path = path(row);
+    music.time = time(row);
+    music.playedTimes = playedTimes(row);
+    music.lastPlayed = lastPlayed(row);
+    return music;
+}
+
+QString MusicRowStore::time(int row) const
+{
+    const Record& entry = record(row);
+    if (entry.rawTime.length > 0) {
+        return poolString(entry.rawTime);
+    }
+    return entry.durationSecs >= 0 ? formatDuration(entry.durationSecs) : QString();
+}
+
+qint64 MusicRowStore::memoryUsage() const
+{
+    qint64 bytes = m_slotOfRow.capacity() * qint64(sizeof(qint32))
+                   + m_slots.capacity() * qint64(sizeof(Record))
+                   + m_freeSlots.capacity() * qint64(sizeof(qint32))
+                   + m_pool.capacity() * qint64(sizeof(QChar));
+
+    // Symbol text is shared between the list and the hash keys
+    for (const QString& symbol : m_symbols) {
+        bytes += qint64(sizeof(QString)) + symbol.capacity() * qint64(sizeof(QChar));
+    }
+    bytes += m_symbolIds.size() * qint64(sizeof(QString) + sizeof(quint32) + sizeof(void*));
+    return bytes;
+}
+
+int MusicRowStore::parseDuration(const QString& time)
+{
+    const QStringList parts = time.split(':');
+    if (parts.size() < 2 || parts.size() > 3) {
+        return -1;
+    }
+
+    int seconds = 0;
+    for (int i = 0; i < parts.size(); ++i) {
+        bool ok = false;
+        const int value = parts.at(i).toInt(&ok);
+        // Every field after the first is a two-digit 0-59 value
+        if (!ok || value < 0 || (i > 0 && (parts.at(i).size() != 2 || value > 59))) {
+            return -1;
+        }
+        seconds = seconds * 60 + value;
+    }
+    return seconds;
+}
+
+QString MusicRowStore::formatDuration(int seconds)
+{
+    const int hours = seconds / 3600;
+    const int minutes = (seconds / 60) % 60;
+    const int secs = seconds % 60;
+
+    if (hours > 0) {
+        return QString("%1:%2:%3").arg(hours).arg(minutes, 2, 10, QChar('0')).arg(secs, 2, 10, QChar('0'));
+    }
+    return QString("%1:%2").arg(minutes).arg(secs, 2, 10, QChar('0'));
+}
+
+QString MusicRowStore::poolString(const Span& span) const
+{
+    return span.length > 0 ? m_pool.mid(span.offset, span.length) : QString();
+}
+
+MusicRowStore::Span MusicRowStore::appendToPool(const QString& text)
+{
+    Span span;
+    span.offset = static_cast<quint32>(m_pool.size());
+    span.length = static_cast<quint32>(text.size());
+    m_pool.append(text);
+    return span;
+}
+
+quint32 MusicRowStore::intern(const QString& text)
+{
+    auto it = m_symbolIds.constFind(text);
+    if (it != m_symbolIds.constEnd()) {
+        return it.value();
+    }
+
+    const quint32 symbol = static_cast<quint32>(m_symbols.size());
+    m_symbols.append(text);
+    m_symbolIds.insert(text, symbol);
+    return symbol;
+}
+
+void MusicRowStore::releaseSlot(int slot)
+{
+    const Record& entry = m_slots.at(slot);
+    m_unusedPoolChars += entry.song.length + entry.path.length + entry.lastPlayed.length + entry.rawTime.length;
+    m_freeSlots.append(slot);
+}
+
+void MusicRowStore::compactPool()
+{
+    QString pool;
+    pool.reserve(m_pool.size() - m_unusedPoolChars);
+
+    auto move = [this, &pool](Span& span) {
+        if (span.length > 0) {
+            const quint32 offset = static_cast<quint32>(pool.size());
+            pool.append(QStringView(m_pool).mid(span.offset, span.length));
+            span.offset = offset;
+        }
+    };
+
+    for (qint32 slot : std::as_const(m_slotOfRow)) {
+        if (slot >= 0) {
+            Record& entry = m_slots[slot];
+            move(entry.song);
+            move(entry.path);
+            move(entry.lastPlayed);
+            move(entry.rawTime);
+        }
+    }
+
+    m_pool = pool;
+    m_unusedPoolChars = 0;
+}
@@ -0,0 +1,186 @@
+#ifndef MUSICROWSTORE_H
+#define MUSICROWSTORE_H
+
+#include <QHash>
+#include <QList>
+#include <QString>
+
+struct MusicItem;
+
+/**
+ * @brief Compact, column-oriented storage for the rows of MusicListModel
+ *
+ * A MusicItem holds nine QStrings, each with its own heap block. For the
+ * model's table of loaded rows that meant one allocation per field and a
+ * full copy on every data() call. MusicRowStore keeps each row as a small
+ * fixed-size record instead:
+ *
+ * - artist, genres, country and published date, which repeat across a
+ *   library, are interned once and referenced by a 32-bit symbol ID
+ * - song, path and last played time are kept in a single UTF-16 pool and
+ *   referenced by offset and length
+ * - duration and play count are plain integers
+ *
+ * Rows are addressed by model row. Each model row costs one slot index
+ * while unloaded; loaded rows live in recycled slots. Unloading rows leaves
+ * their text in the pool until it is compacted, which happens once more
+ * than half of the pool is unused.
+ *
+ * Not thread-safe; used from the model's thread only.
+ *
+ * @example
+ * @code
+ * MusicRowStore rows;
+ * rows.resize(totalCount);
+ * rows.setRow(0, item);
+ * QString artist = rows.artist(0);
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class MusicRowStore
+{
+public:
+    MusicRowStore();
+
+    /**
+     * @brief Change the number of model rows, unloading all of them
+     * @param rowCount Number of rows in the model
+     */
+    void resize(int rowCount);
+
+    /**
+     * @brief Unload all rows, keeping the row count
+     */
+    void clear();
+
+    /**
+     * @brief Get the number of model rows
+     * @return Row count passed to resize()
+     */
+    int rowCount() const { return static_cast<int>(m_slotOfRow.size()); }
+
+    /**
+     * @brief Get the number of loaded rows
+     * @return Loaded row count
+     */
+    int loadedCount() const { return static_cast<int>(m_slots.size() - m_freeSlots.size()); }
+
+    /**
+     * @brief Check if a row is loaded
+     * @param row Model row
+     * @return true if setRow() stored the row and it was not unloaded since
+     */
+    bool isLoaded(int row) const
+    {
+        return row >= 0 && row < rowCount() && m_slotOfRow.at(row) >= 0;
+    }
+
+    /**
+     * @brief Store a row, replacing any row already loaded there
+     * @param row Model row
+     * @param item Music item for the row
+     */
+    void setRow(int row, const MusicItem& item);
+
+    /**
+     * @brief Unload a range of rows
+     * @param first First row
+     * @param last Last row, inclusive
+     */
+    void unloadRows(int first, int last);
+
+    /**
+     * @brief Rebuild the full music item of a loaded row
+     * @param row Loaded model row
+     * @return Music item
+     */
+    MusicItem item(int row) const;
+
+    // Field access; the row must be loaded
+    int id(int row) const { return record(row).id; }
+    QString song(int row) const { return poolString(record(row).song); }
+    QString artist(int row) const { return m_symbols.at(record(row).artist); }
+    QString genre1(int row) const { return m_symbols.at(record(row).genre1); }
+    QString genre2(int row) const { return m_symbols.at(record(row).genre2); }
+    QString country(int row) const { return m_symbols.at(record(row).country); }
+    QString publishedDate(int row) const { return m_symbols.at(record(row).publishedDate); }
+    QString path(int row) const { return poolString(record(row).path); }
+    QString lastPlayed(int row) const { return poolString(record(row).lastPlayed); }
+    int durationSecs(int row) const { return record(row).durationSecs; }
+    int playedTimes(int row) const { return record(row).playedTimes; }
+
+    /**
+     * @brief Get the duration of a row as stored in the musics table
+     * @param row Loaded model row
+     * @return Duration text, such as "3:45"
+     */
+    QString time(int row) const;
+
+    /**
+     * @brief Estimate the memory held by the store
+     * @return Bytes in use, including unused pool space and symbols
+     */
+    qint64 memoryUsage() const;
+
+    /**
+     * @brief Parse a duration in "m:ss" or "h:mm:ss" form
+     * @param time Duration text
+     * @return Duration in seconds, or -1 if the text is not in either form
+     */
+    static int parseDuration(const QString& time);
+
+    /**
+     * @brief Format a duration the way parseDuration() reads it
+     * @param seconds Duration in seconds
+     * @return "m:ss", or "h:mm:ss" from one hour on
+     */
+    static QString formatDuration(int seconds);
+
+private:
+    /**
+     * @brief Text in the string pool
+     */
+    struct Span {
+        quint32 offset = 0;
+        quint32 length = 0;
+    };
+
+    /**
+     * @brief Fixed-size record of one loaded row
+     */
+    struct Record {
+        int id = -1;
+        quint32 artist = 0;
+        quint32 genre1 = 0;
+        quint32 genre2 = 0;
+        quint32 country = 0;
+        quint32 publishedDate = 0;
+        qint32 durationSecs = -1;
+        qint32 playedTimes = 0;
+        Span song;
+        Span path;
+        Span lastPlayed;
+        Span rawTime; ///< Only set when the duration text does not round-trip
+    };
+
+    const Record& record(int row) const { return m_slots.at(m_slotOfRow.at(row)); }
+    QString poolString(const Span& span) const;
+    Span appendToPool(const QString& text);
+    quint32 intern(const QString& text);
+    void releaseSlot(int slot);
+    void compactPool();
+
+    QList<qint32> m_slotOfRow;   ///< Slot of each model row, -1 while unloaded
+    QList<Record> m_slots;
+    QList<qint32> m_freeSlots;
+    QString m_pool;
+    qint64 m_unusedPoolChars = 0;
+    QList<QString> m_symbols;    ///< Symbol 0 is the empty string
+    QHash<QString, quint32> m_symbolIds;
+
+    /// The pool is compacted once it is at least this large and half unused
+    static constexpr qint64 MIN_COMPACT_CHARS = 64 * 1024;
+};
+
+#endif // MUSICROWSTORE_H
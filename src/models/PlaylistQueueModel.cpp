@@ -0,0 +1,361 @@
+#include "PlaylistQueueModel.h"
+#include <QColor>
+#include <QGuiApplication>
+#include <QPalette>
+#include <algorithm>
+#include <iterator>
+
+qint64 PlaylistQueueModel::Entry::airTimeUs() const
+{
+    if (durationUs < 0) {
+        return -1;
+    }
+    const qint64 endUs = cueOutMs >= 0 ? std::min(cueOutMs * 1000, durationUs) : durationUs;
+    return std::max<qint64>(0, endUs - cueInMs * 1000);
+}
+
+PlaylistQueueModel::PlaylistQueueModel(QObject* parent)
+    : QAbstractListModel(parent)
+{
+}
+
+void PlaylistQueueModel::setResolver(Resolver resolver)
+{
+    m_resolver = std::move(resolver);
+}
+
+int PlaylistQueueModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : count();
+}
+
+QVariant PlaylistQueueModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() >= count()) {
+        return QVariant();
+    }
+
+    const Entry& item = entry(index.row());
+    switch (role) {
+    case Qt::DisplayRole:
+    case PathRole:
+        return item.path;
+    case Qt::ToolTipRole:
+        if (!item.problem.isEmpty()) {
+            return item.problem;
+        }
+        return item.toolTip.isEmpty() ? QVariant() : QVariant(item.toolTip);
+    case Qt::ForegroundRole:
+        if (!item.problem.isEmpty()) {
+            return QColor(Qt::red);
+        }
+        if (item.pending) {
+            return QGuiApplication::palette().color(QPalette::Disabled, QPalette::Text);
+        }
+        return QVariant();
+    case MusicIdRole:
+        return item.musicId;
+    case DurationRole:
+        return item.durationUs;
+    case PendingRole:
+        return item.pending;
+    case ProblemRole:
+        return item.problem;
+    default:
+        return QVariant();
+    }
+}
+
+Qt::ItemFlags PlaylistQueueModel::flags(const QModelIndex& index) const
+{
+    // Entries are dropped between others, never onto one
+    if (!index.isValid()) {
+        return Qt::ItemIsDropEnabled;
+    }
+    return Qt::ItemIsEnabled | Qt::ItemIsSelectable | Qt::ItemIsDragEnabled
+           | Qt::ItemNeverHasChildren;
+}
+
+Qt::DropActions PlaylistQueueModel::supportedDropActions() const
+{
+    return Qt::MoveAction;
+}
+
+bool PlaylistQueueModel::moveRows(const QModelIndex& sourceParent, int sourceRow, int count,
+                                  const QModelIndex& destinationParent, int destinationChild)
+{
+    if (sourceParent.isValid() || destinationParent.isValid() || count <= 0 || sourceRow < 0
+        || sourceRow + count > this->count() || destinationChild < 0
+        || destinationChild > this->count()) {
+        return false;
+    }
+    if (!beginMoveRows(QModelIndex(), sourceRow, sourceRow + count - 1, QModelIndex(),
+                       destinationChild)) {
+        return false;
+    }
+
+    const auto first = m_entries.begin() + sourceRow;
+    std::vector<Entry> moving(std::make_move_iterator(first),
+                              std::make_move_iterator(first + count));
+    m_entries.erase(first, first + count);
+    const int target = destinationChild > sourceRow ? destinationChild - count : destinationChild;
+    m_entries.insert(m_entries.begin() + target, std::make_move_iterator(moving.begin()),
+                     std::make_move_iterator(moving.end()));
+
+    endMoveRows();
+    return true;
+}
+
+bool PlaylistQueueModel::removeRows(int row, int count, const QModelIndex& parent)
+{
+    if (parent.isValid() || count <= 0 || row < 0 || row + count > this->count()) {
+        return false;
+    }
+
+    const qint64 oldTotalUs = m_totalUs;
+    const int oldUnknownCount = m_unknownCount;
+    beginRemoveRows(QModelIndex(), row, row + count - 1);
+    const auto first = m_entries.begin() + row;
+    std::for_each(first, first + count, [this](const Entry& item) { account(item, -1); });
+    m_entries.erase(first, first + count);
+    endRemoveRows();
+    emitTotalIfChanged(oldTotalUs, oldUnknownCount);
+    return true;
+}
+
+QString PlaylistQueueModel::path(int row) const
+{
+    return row >= 0 && row < count() ? entry(row).path : QString();
+}
+
+QStringList PlaylistQueueModel::paths(int maxCount) const
+{
+    const int total = maxCount < 0 ? count() : std::min(maxCount, count());
+    QStringList result;
+    result.reserve(total);
+    for (int row = 0; row < total; ++row) {
+        result << entry(row).path;
+    }
+    return result;
+}
+
+void PlaylistQueueModel::append(const QString& path)
+{
+    insert(count(), path);
+}
+
+void PlaylistQueueModel::append(const QStringList& paths)
+{
+    if (paths.isEmpty()) {
+        return;
+    }
+
+    const qint64 oldTotalUs = m_totalUs;
+    const int oldUnknownCount = m_unknownCount;
+    beginInsertRows(QModelIndex(), count(), count() + int(paths.size()) - 1);
+    for (const QString& path : paths) {
+        m_entries.push_back(makeEntry(path));
+        account(m_entries.back(), 1);
+    }
+    endInsertRows();
+    emitTotalIfChanged(oldTotalUs, oldUnknownCount);
+}
+
+void PlaylistQueueModel::append(std::vector<Entry> entries)
+{
+    if (entries.empty()) {
+        return;
+    }
+
+    const qint64 oldTotalUs = m_totalUs;
+    const int oldUnknownCount = m_unknownCount;
+    beginInsertRows(QModelIndex(), count(), count() + int(entries.size()) - 1);
+    for (Entry& item : entries) {
+        item.pending = false;
+        if (m_resolver) {
+            m_resolver(item);
+        }
+        account(item, 1);
+        m_entries.push_back(std::move(item));
+    }
+    endInsertRows();
+    emitTotalIfChanged(oldTotalUs, oldUnknownCount);
+}
+
+void PlaylistQueueModel::insert(int row, const QString& path)
+{
+    row = std::clamp(row, 0, count());
+
+    const qint64 oldTotalUs = m_totalUs;
+    const int oldUnknownCount = m_unknownCount;
+    beginInsertRows(QModelIndex(), row, row);
+    const auto inserted = m_entries.insert(m_entries.begin() + row, makeEntry(path));
+    account(*inserted, 1);
+    endInsertRows();
+    emitTotalIfChanged(oldTotalUs, oldUnknownCount);
+}
+
+void PlaylistQueueModel::appendPending(const QString& path, const QString& toolTip)
+{
+    Entry item;
+    item.path = path;
+    item.pending = true;
+    item.toolTip = toolTip;
+
+    beginInsertRows(QModelIndex(), count(), count());
+    m_entries.push_back(item);
+    endInsertRows();
+}
+
+int PlaylistQueueModel::settle(const QHash<QString, QString>& toolTips)
+{
+    const qint64 oldTotalUs = m_totalUs;
+    const int oldUnknownCount = m_unknownCount;
+    int settled = 0;
+    for (int row = 0; row < count(); ++row) {
+        Entry& item = m_entries[size_t(row)];
+        if (!item.pending) {
+            continue;
+        }
+        const auto toolTip = toolTips.constFind(item.path);
+        if (toolTip == toolTips.cend()) {
+            continue;
+        }
+        item = makeEntry(item.path);
+        item.toolTip = toolTip.value();
+        account(item, 1);
+        emit dataChanged(index(row), index(row));
+        ++settled;
+    }
+    emitTotalIfChanged(oldTotalUs, oldUnknownCount);
+    return settled;
+}
+
+PlaylistQueueModel::Entry PlaylistQueueModel::takeFirst()
+{
+    const qint64 oldTotalUs = m_totalUs;
+    const int oldUnknownCount = m_unknownCount;
+    beginRemoveRows(QModelIndex(), 0, 0);
+    Entry head = std::move(m_entries.front());
+    m_entries.pop_front();
+    account(head, -1);
+    endRemoveRows();
+    emitTotalIfChanged(oldTotalUs, oldUnknownCount);
+    return head;
+}
+
+void PlaylistQueueModel::removeAt(int row)
+{
+    removeRows(row, 1);
+}
+
+bool PlaylistQueueModel::move(int from, int to)
+{
+    if (from < 0 || from >= count() || to < 0 || to >= count()) {
+        return false;
+    }
+    if (from == to) {
+        return true;
+    }
+    return moveRows(QModelIndex(), from, 1, QModelIndex(), to > from ? to + 1 : to);
+}
+
+void PlaylistQueueModel::clear()
+{
+    const qint64 oldTotalUs = m_totalUs;
+    const int oldUnknownCount = m_unknownCount;
+    beginResetModel();
+    m_entries.clear();
+    m_totalUs = 0;
+    m_unknownCount = 0;
+    endResetModel();
+    emitTotalIfChanged(oldTotalUs, oldUnknownCount);
+}
+
+int PlaylistQueueModel::flagProblem(const QString& path, const QString& problem)
+{
+    int flagged = 0;
+    for (int row = 0; row < count(); ++row) {
+        Entry& item = m_entries[size_t(row)];
+        if (item.path != path || item.problem == problem) {
+            continue;
+        }
+        item.problem = problem;
+        emit dataChanged(index(row), index(row));
+        ++flagged;
+    }
+    return flagged;
+}
+
+bool PlaylistQueueModel::replaceAt(int row, const QString& path)
+{
+    if (row < 0 || row >= count()) {
+        return false;
+    }
+
+    const qint64 oldTotalUs = m_totalUs;
+    const int oldUnknownCount = m_unknownCount;
+    Entry& item = m_entries[size_t(row)];
+    account(item, -1);
+    item = makeEntry(path);
+    account(item, 1);
+    emit dataChanged(index(row), index(row));
+    emitTotalIfChanged(oldTotalUs, oldUnknownCount);
+    return true;
+}
+
+int PlaylistQueueModel::relocate(const QString& from, const QString& to)
+{
+    const qint64 oldTotalUs = m_totalUs;
+    const int oldUnknownCount = m_unknownCount;
+    int changed = 0;
+    for (int row = 0; row < count(); ++row) {
+        Entry& item = m_entries[size_t(row)];
+        if (item.path != from) {
+            continue;
+        }
+        account(item, -1);
+        if (item.pending) {
+            item.path = to;
+        } else {
+            const QString toolTip = item.toolTip;
+            item = makeEntry(to);
+            item.toolTip = toolTip;
+        }
+        account(item, 1);
+        emit dataChanged(index(row), index(row));
+        ++changed;
+    }
+    emitTotalIfChanged(oldTotalUs, oldUnknownCount);
+    return changed;
+}
+
+PlaylistQueueModel::Entry PlaylistQueueModel::makeEntry(const QString& path) const
+{
+    Entry item;
+    item.path = path;
+    if (m_resolver) {
+        m_resolver(item);
+    }
+    return item;
+}
+
+void PlaylistQueueModel::account(const Entry& entry, int direction)
+{
+    if (entry.pending) {
+        return;
+    }
+    const qint64 airTimeUs = entry.airTimeUs();
+    if (airTimeUs < 0) {
+        m_unknownCount += direction;
+    } else {
+        m_totalUs += direction * airTimeUs;
+    }
+}
+
+void PlaylistQueueModel::emitTotalIfChanged(qint64 oldTotalUs, int oldUnknownCount)
+{
+    if (m_totalUs != oldTotalUs || m_unknownCount != oldUnknownCount) {
+        emit totalChanged(m_totalUs, m_unknownCount);
+    }
+}
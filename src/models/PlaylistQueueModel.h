@@ -0,0 +1,206 @@
+#ifndef PLAYLISTQUEUEMODEL_H
+#define PLAYLISTQUEUEMODEL_H
+
+#include <QAbstractListModel>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <deque>
+#include <functional>
+#include <vector>
+
+/**
+ * @brief The on-air queue: what plays next, in order
+ *
+ * The playlist used to be a QListWidget whose items held nothing but the
+ * file path, so everything that looked at the queue, from the total time
+ * to the next song, to saving it or making a program of it, had to work
+ * out the rest from the path again. Each entry here keeps what is known
+ * about its track next to the path: the library id, the duration and the
+ * cue points. They are looked up once, by the resolver, when the entry is
+ * queued.
+ *
+ * The entries are held in a deque, so taking the head for playback is
+ * O(1). The running total of the air time is kept as entries come and go
+ * and is shared by everything that shows it. Moving an entry, which is
+ * what drag and drop in the view does, only moves that entry.
+ *
+ * Entries of a drop whose tags are still being read can be queued as
+ * pending; they are greyed out and left out of the total until settle().
+ *
+ * @example
+ * @code
+ * PlaylistQueueModel* queue = new PlaylistQueueModel(this);
+ * queue->setResolver([this](PlaylistQueueModel::Entry& entry) {
+ *     entry.durationUs = durationCache->durationUs(entry.path);
+ * });
+ * playlistView->setModel(queue);
+ * queue->append("/music/song.ogg");
+ * const PlaylistQueueModel::Entry next = queue->takeFirst();
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class PlaylistQueueModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    enum Role {
+        PathRole = Qt::UserRole,
+        MusicIdRole,
+        DurationRole,   ///< Microseconds, -1 if unknown
+        PendingRole,
+        ProblemRole     ///< Why the file cannot be played, empty if none was found
+    };
+
+    struct Entry {
+        QString path;
+        qint64 musicId = -1;      ///< Id in the musics table, -1 for other files
+        qint64 durationUs = -1;   ///< Length of the file, -1 if it could not be read
+        qint64 cueInMs = 0;       ///< Where playback starts
+        qint64 cueOutMs = -1;     ///< Where playback ends; -1 for the end of the file
+        bool pending = false;     ///< Tags still being read; not resolved or counted yet
+        QString toolTip;
+        QString problem;          ///< Set by flagProblem(); shown instead of the tool tip
+
+        /**
+         * @brief Time on air between the cue points, -1 if the duration is unknown
+         */
+        qint64 airTimeUs() const;
+    };
+
+    /**
+     * @brief Fills in what is not yet known about an entry from its path
+     *
+     * Values already set, such as those read from a saved playlist, are
+     * left as they are; fresh entries have all of them unknown.
+     */
+    using Resolver = std::function<void(Entry&)>;
+
+    explicit PlaylistQueueModel(QObject* parent = nullptr);
+
+    /**
+     * @brief Set the function that looks up new entries; entries already queued keep theirs
+     */
+    void setResolver(Resolver resolver);
+
+    // QAbstractItemModel interface
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    Qt::ItemFlags flags(const QModelIndex& index) const override;
+    Qt::DropActions supportedDropActions() const override;
+    bool moveRows(const QModelIndex& sourceParent, int sourceRow, int count,
+                  const QModelIndex& destinationParent, int destinationChild) override;
+    bool removeRows(int row, int count, const QModelIndex& parent = QModelIndex()) override;
+
+    int count() const { return static_cast<int>(m_entries.size()); }
+    bool isEmpty() const { return m_entries.empty(); }
+
+    /**
+     * @brief Path of an entry, empty if the row does not exist
+     */
+    QString path(int row) const;
+
+    /**
+     * @brief An entry; row must exist
+     */
+    const Entry& entry(int row) const { return m_entries[size_t(row)]; }
+
+    /**
+     * @brief Paths of up to maxCount entries from the head, or of all when negative
+     */
+    QStringList paths(int maxCount = -1) const;
+
+    /**
+     * @brief Queue tracks at the end
+     */
+    void append(const QString& path);
+    void append(const QStringList& paths);
+
+    /**
+     * @brief Queue entries at the end in one insert, resolving what they leave unknown
+     */
+    void append(std::vector<Entry> entries);
+
+    /**
+     * @brief Queue a track before a row; rows past the end append
+     */
+    void insert(int row, const QString& path);
+    void prepend(const QString& path) { insert(0, path); }
+
+    /**
+     * @brief Queue a track of a drop at the end, to be settled when its tags are read
+     */
+    void appendPending(const QString& path, const QString& toolTip);
+
+    /**
+     * @brief Resolve and count pending entries whose tags have been read
+     * @param toolTips Tool tip to show from now on, keyed by the path of the entries
+     * @return Entries settled
+     */
+    int settle(const QHash<QString, QString>& toolTips);
+
+    /**
+     * @brief Take the head of the queue; the queue must not be empty
+     */
+    Entry takeFirst();
+
+    void removeAt(int row);
+
+    /**
+     * @brief Move an entry so that it ends up at row to
+     * @return false if either row does not exist
+     */
+    bool move(int from, int to);
+
+    void clear();
+
+    /**
+     * @brief Mark the entries of a file that cannot be played
+     * @param path File of the entries
+     * @param problem Why it cannot be played
+     * @return Entries marked
+     */
+    int flagProblem(const QString& path, const QString& problem);
+
+    /**
+     * @brief Put another track in the place of one entry
+     * @return false if the row does not exist
+     */
+    bool replaceAt(int row, const QString& path);
+
+    /**
+     * @brief Point the entries of a file that was replaced at the new one and look them up again
+     * @return Entries changed
+     */
+    int relocate(const QString& from, const QString& to);
+
+    /**
+     * @brief Air time of the counted entries, microseconds
+     */
+    qint64 totalAirTimeUs() const { return m_totalUs; }
+
+    /**
+     * @brief Counted entries whose duration could not be read
+     */
+    int unknownDurationCount() const { return m_unknownCount; }
+
+signals:
+    /**
+     * @brief Emitted when the total air time or the unknown count changed
+     */
+    void totalChanged(qint64 totalAirTimeUs, int unknownDurationCount);
+
+private:
+    Entry makeEntry(const QString& path) const;
+    void account(const Entry& entry, int direction);
+    void emitTotalIfChanged(qint64 oldTotalUs, int oldUnknownCount);
+
+    std::deque<Entry> m_entries;
+    Resolver m_resolver;
+    qint64 m_totalUs = 0;
+    int m_unknownCount = 0;
+};
+
+#endif // PLAYLISTQUEUEMODEL_H
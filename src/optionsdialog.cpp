@@ -34,13 +34,6 @@ optionsDialog::optionsDialog(QWidget *parent) :
 
     audioRecorder = new QMediaRecorder(this);
 
-    //Audio devices
-    const QList<QAudioDevice> inputDevices = QMediaDevices::audioInputs();
-    for (const QAudioDevice &device : inputDevices) {
-            ui->cboxRecDev->addItem(device.description(), QVariant(device.id()));
-            qDebug()<<"Audio Hardware detected on this system (optionsdialog.cpp): "<<device.description();
-        }
-
     //Audio codecs
     foreach (const QMediaFormat::AudioCodec &codec, audioRecorder->mediaFormat().supportedAudioCodecs(QMediaFormat::Encode)) {
             QString codecName = QMediaFormat::audioCodecName(codec);
@@ -54,6 +47,20 @@ optionsDialog::optionsDialog(QWidget *parent) :
             ui->comboBox_container->addItem(containerName, QVariant(containerName));
             qDebug()<<"Audio Containers on this system (optionsdialog.cpp): "<<QVariant(containerName);
         }
+
+    loadSettings();
+}
+
+void optionsDialog::loadSettings()
+{
+    //Audio devices, listed again since one may have been plugged in
+    const QList<QAudioDevice> inputDevices = QMediaDevices::audioInputs();
+    ui->cboxRecDev->clear();
+    for (const QAudioDevice &device : inputDevices) {
+            ui->cboxRecDev->addItem(device.description(), QVariant(device.id()));
+            qDebug()<<"Audio Hardware detected on this system (optionsdialog.cpp): "<<device.description();
+        }
+
     // --- Load Settings using QSettings from WRITABLE Location ---
     qDebug() << "Loading settings using QSettings...";
     QString configFileName = "xfb.conf";
@@ -150,8 +157,6 @@ optionsDialog::optionsDialog(QWidget *parent) :
     } else {
         this->setStyleSheet("QDialog { background-color: #ffffff; color: #333333; }");
     }
-
-
 }
 
 
@@ -30,6 +30,9 @@ public:
     ~optionsDialog();
     QSqlDatabase adb;
 
+    // Shows the saved settings again; the dialog is kept between openings
+    void loadSettings();
+
 
 private slots:
 
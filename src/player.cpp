@@ -6,7 +6,6 @@ Enjoy! . Frédéric Bogaerts 2015 @ Netpack - Online Solutions!.
 
 #include "player.h"
 #include "aboutus.h"
-#include "add_full_dir.h"
 #include "add_music_single.h"
 #include "add_program.h"
 #include "add_pub.h"
@@ -31,14 +30,13 @@ Enjoy! . Frédéric Bogaerts 2015 @ Netpack - Online Solutions!.
 #include <QDragMoveEvent>
 #include <QFileInfo>
 #include <QList>
-#include <QSqlTableModel>
 #include <QTableWidgetItem>
 // QAudioRecorder is deprecated in Qt6
-#include <QAudioInput>  // Qt6 replacement for audio recording
 #include <QAudioOutput> // Qt6 for audio output
 #include <QDesktopServices>
 #include <QGraphicsScene>
 #include <QGraphicsView>
+#include <QHostInfo>
 #include <QHttpPart>
 #include <QMediaDevices> // Qt6 replacement for QAudioDeviceInfo
 #include <QMouseEvent>
@@ -46,7 +44,7 @@ Enjoy! . Frédéric Bogaerts 2015 @ Netpack - Online Solutions!.
 #include <QNetworkAccessManager>
 #include <QNetworkInformation> // Qt6 replacement for QNetworkConfigurationManager
 #include <QPointF>
-#include <QProgressDialog>
+#include <QShowEvent>
 #include <QTextBrowser>
 #include <QUrl>
 #include <QVector>
@@ -58,12 +56,274 @@ Enjoy! . Frédéric Bogaerts 2015 @ Netpack - Online Solutions!.
 
 #include <QSizeGrip>
 #include <QtCore>
+#include <QtConcurrent/QtConcurrentRun>
 #include <QtGlobal>
-
+#include <algorithm>
+#include <cmath>
+
+#include "dialogs/EnhancedAddDirectoryDialog.h"
+#include "models/HistoryListModel.h"
+#include "models/LiveTableModel.h"
+#include "models/PlaylistQueueModel.h"
+#include "repositories/LibraryChangeLog.h"
+#include "repositories/MusicRepository.h"
+#include "repositories/NowPlayingStatus.h"
+#include "repositories/PlayHistory.h"
+#include "repositories/ProofOfPlay.h"
+#include "repositories/TrackRanking.h"
+#include "services/AccessibilityEventBatcher.h"
 #include "services/AccessibilityManager.h"
+#include "services/AdBreakPacker.h"
+#include "services/AirCheckRecorder.h"
+#include "services/AnalysisIndex.h"
+#include "services/AnalysisPipeline.h"
+#include "services/ArchiveRetention.h"
+#include "services/AudioDeck.h"
+#include "services/AudioDeviceRegistry.h"
+#include "services/BackTimer.h"
+#include "services/BackgroundOperationFeedback.h"
+#include "services/BackgroundThrottle.h"
+#include "services/BroadcastWorker.h"
+#include "services/BulkTrackOperations.h"
+#include "services/CartWall.h"
+#include "services/ConfigReloader.h"
+#include "services/ContentHash.h"
+#include "services/ContentHashScanner.h"
+#include "services/ContributionLink.h"
+#include "services/CuePointStore.h"
+#include "services/DatabaseService.h"
+#include "services/DatabaseOptimizer.h"
+#include "services/DayLogGenerator.h"
+#include "services/DeadAirDetector.h"
+#include "services/DownloadQueue.h"
+#include "services/DurationCache.h"
+#include "services/ErrorHandler.h"
+#include "services/EventJournal.h"
+#include "services/ExifToolPool.h"
+#include "services/FailoverStandby.h"
+#include "services/FtpClient.h"
+#include "services/FtpSyncEngine.h"
+#include "services/HourGenreSchedule.h"
+#include "services/IcecastMetadata.h"
+#include "services/IcecastSource.h"
+#include "services/LibraryChecker.h"
+#include "services/LibraryReplica.h"
+#include "services/LibraryRescanner.h"
+#include "services/LibrarySnapshot.h"
+#include "services/LibraryWatcher.h"
+#include "services/LiveCapture.h"
+#include "services/MicDucker.h"
+#include "services/LogCategories.h"
+#include "services/LoudnessScanner.h"
+#include "services/MaintenanceScheduler.h"
+#include "services/MediaCache.h"
+#include "services/MediaInfoLoader.h"
+#include "services/MediaProbe.h"
+#include "services/MemoryBudget.h"
+#include "services/MetricsRegistry.h"
+#include "services/MetricsServer.h"
+#include "services/MusicCache.h"
+#include "services/RemoteControlServer.h"
+#include "services/PeakFileGenerator.h"
+#include "services/NativeAudioOutput.h"
+#include "services/NetworkMaintenance.h"
+#include "services/PlayHistoryWriter.h"
+#include "services/QueueJournal.h"
+#include "services/PlaybackClock.h"
+#include "services/PlaybackEngine.h"
+#include "services/PlaylistFile.h"
+#include "services/PlaylistValidator.h"
+#include "services/ProcessSupervisor.h"
+#include "services/ProgramBuilder.h"
+#include "services/QmlHttpCache.h"
+#include "services/ReachabilityMonitor.h"
+#include "services/ReplayGainStore.h"
+#include "services/RotationEngine.h"
+#include "services/SchedulerEngine.h"
+#include "services/SearchController.h"
+#include "services/SegmentRecorder.h"
+#include "services/ServerPresenceCache.h"
 #include "services/ServiceContainer.h"
+#include "services/ShutdownCoordinator.h"
+#include "services/SilenceScanner.h"
+#include "services/SpotPool.h"
+#include "services/StallWatchdog.h"
+#include "services/StartupProfiler.h"
+#include "services/StreamOutput.h"
+#include "services/StreamingExporter.h"
+#include "services/SystemStatusAnnouncer.h"
+#include "services/TableChangeBus.h"
+#include "services/TagReader.h"
+#include "services/Tracer.h"
+#include "services/TaskRunner.h"
+#include "services/TranscodeCache.h"
+#include "services/TranscodeEngine.h"
+#include "services/TransferQueue.h"
+#include "ui/ElidedTextDelegate.h"
+#include "ui/ProgressIndicatorWidget.h"
+#include "ui/WaveformWidget.h"
 #include <QQuickWidget>
 #include <QtWebEngineQuick>
+#include <filesystem>
+
+// Set by CMake from the install prefix
+#ifndef XFB_SCRIPTS_DIR
+#define XFB_SCRIPTS_DIR "/usr/share/xfb/scripts"
+#endif
+
+namespace {
+
+// Icecast port the TakeOver stream is served on when its URL does not say
+constexpr int TAKEOVER_STREAM_PORT = 8888;
+
+// Scheme of the TakeOver "stream" when the client sends over the contribution link
+constexpr const char* CONTRIBUTION_SCHEME = "xfblink";
+
+// The server reacts to takeover.xml as soon as the upload settles, so the
+// client can look for the confirmation early and often
+constexpr int TAKEOVER_CHECK_DELAY_MS = 1000;
+constexpr int TAKEOVER_CHECK_RETRY_MS = 2000;
+
+// Local playback fades out when a takeover starts and back in when it ends
+// or the stream fails; the fade runs from 100% to 5% or the other way
+constexpr int MAIN_FADE_MS = 3000;
+
+// Finds an audio input by the description saved in RecDevice, without enumerating the devices
+QAudioDevice audioInput(const AudioDeviceRegistry* devices, const QString& description) {
+    const QAudioDevice device = devices->findInput(description);
+    return device.isNull() ? devices->defaultInput() : device;
+}
+
+// How often the public IP is checked when a DDNS record has to follow it
+constexpr int DDNS_REFRESH_MS = 5 * 60 * 1000;
+
+// Old programs are removed a while after startup, once everything has
+// settled, and then every few hours
+constexpr int RETENTION_FIRST_RUN_MS = 10 * 60 * 1000;
+constexpr int RETENTION_INTERVAL_MS = 6 * 60 * 60 * 1000;
+// Programs scheduled this far ahead are never removed
+constexpr int RETENTION_SCHEDULE_DAYS = 7;
+
+// Playlist items converted ahead for the decks; a conversion takes seconds,
+// so a few tracks ahead is plenty even with short jingles in between
+constexpr int TRANSCODE_LOOKAHEAD = 5;
+
+// The media cache copies what is due within the horizon: the pubs and
+// programs scheduled, and the likely rotation picks of the hours' genres
+constexpr int MEDIA_CACHE_HORIZON_MS = 2 * 60 * 60 * 1000;
+constexpr int MEDIA_CACHE_PLAN_MS = 10 * 60 * 1000;
+constexpr int MEDIA_CACHE_ROTATION_PICKS = 15;
+
+// While a drop is imported the music view is refreshed at most this often,
+// so a large folder reloads the table a few times rather than every batch
+constexpr int DROP_REFRESH_INTERVAL_MS = 1000;
+
+// The now_playing row is written this long after the track or the queue
+// changed, so a drop of a hundred files is one write
+constexpr int NOW_PLAYING_DELAY_MS = 250;
+
+// A journal written longer ago than this restores the queue but does not
+// start playing, since the show it was playing is over
+constexpr qint64 RESUME_WINDOW_MS = 10 * 60 * 1000;
+
+// File suffix of the recording container chosen in the options; ffmpeg
+// picks the muxer from it
+QString recordingSuffix(QMediaFormat::FileFormat container) {
+    switch (container) {
+    case QMediaFormat::Matroska:
+        return "mkv";
+    case QMediaFormat::MPEG4:
+        return "mp4";
+    case QMediaFormat::Mpeg4Audio:
+        return "m4a";
+    case QMediaFormat::QuickTime:
+        return "mov";
+    case QMediaFormat::Wave:
+        return "wav";
+    case QMediaFormat::MP3:
+        return "mp3";
+    case QMediaFormat::FLAC:
+        return "flac";
+    default:
+        return "ogg";
+    }
+}
+
+// ffmpeg encoder of the recording codec chosen in the options; empty keeps
+// the container's usual one
+QString recordingEncoder(QMediaFormat::AudioCodec codec) {
+    switch (codec) {
+    case QMediaFormat::AudioCodec::Vorbis:
+        return "libvorbis";
+    case QMediaFormat::AudioCodec::Opus:
+        return "libopus";
+    case QMediaFormat::AudioCodec::MP3:
+        return "libmp3lame";
+    case QMediaFormat::AudioCodec::AAC:
+        return "aac";
+    case QMediaFormat::AudioCodec::FLAC:
+        return "flac";
+    case QMediaFormat::AudioCodec::Wave:
+        return "pcm_s16le";
+    default:
+        return QString();
+    }
+}
+
+// sox has this long to trim one file, and is looked at this often for a cancel
+constexpr int TRIM_TIMEOUT_MS = 5 * 60 * 1000;
+constexpr int TRIM_POLL_MS = 200;
+
+// Trims the silence at the start of a file with sox; the trimmed copy is
+// written next to the file and replaces it in one step
+bool trimSilenceOf(const QString& soxPath, const QString& path, const QString& stopSeconds,
+                   const TaskRunner::Context& context, QString* error) {
+    if (!QFileInfo(path).isFile()) {
+        *error = "the file does not exist";
+        return false;
+    }
+
+    const QString partPath = TranscodeEngine::partPathFor(path);
+    QProcess sox;
+    sox.start(soxPath, {path, partPath, "silence", "1", stopSeconds, "1%"});
+    QElapsedTimer elapsed;
+    elapsed.start();
+    while (!sox.waitForFinished(TRIM_POLL_MS)) {
+        if (sox.state() == QProcess::NotRunning)
+            break;
+        if (context.isCancelled() || elapsed.hasExpired(TRIM_TIMEOUT_MS)) {
+            sox.kill();
+            sox.waitForFinished(1000);
+            QFile::remove(partPath);
+            *error = context.isCancelled() ? "cancelled" : "sox timed out";
+            return false;
+        }
+    }
+    if (sox.error() == QProcess::FailedToStart || sox.exitStatus() != QProcess::NormalExit
+        || sox.exitCode() != 0) {
+        const QString output = QString::fromLocal8Bit(sox.readAllStandardError()).trimmed();
+        *error = output.isEmpty() ? sox.errorString() : output;
+        QFile::remove(partPath);
+        return false;
+    }
+    if (QFileInfo(partPath).size() == 0) {
+        *error = "sox wrote an empty file";
+        QFile::remove(partPath);
+        return false;
+    }
+
+    std::error_code renameError;
+    std::filesystem::rename(QFile(partPath).filesystemFileName(),
+                            QFile(path).filesystemFileName(), renameError);
+    if (renameError) {
+        *error = QString::fromStdString(renameError.message());
+        QFile::remove(partPath);
+        return false;
+    }
+    return true;
+}
+
+} // namespace
 
 class ClickableTextBrowser : public QTextBrowser {
   public:
@@ -120,13 +380,65 @@ class CustomMessageBox : public QDialog {
 };
 
 player::player(QWidget* parent) : QMainWindow(parent), ui(new Ui::player) {
-    qDebug() << "\nStarting XFB :: Developed by Frédéric Bogaerts @ Netpack - Online Solutions! "
-                "www.netpack.pt";
-
+    qCDebug(xfbPlayer)
+        << "\nStarting XFB :: Developed by Frédéric Bogaerts @ Netpack - Online Solutions! "
+           "www.netpack.pt";
+
+    // Only what the first paint needs runs here; see finishStartup()
+    startupProfiler = new StartupProfiler;
+    startupProfiler->begin("ui");
+    // adb.db is put in place while the window is built; openDatabase() waits for it
+    QString appDirName = QCoreApplication::applicationName();
+    if (appDirName.isEmpty())
+        appDirName = "XFB";
+    databasePath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/" +
+                   appDirName + "/adb.db";
+    databaseProvisioning = QtConcurrent::run([path = databasePath]() {
+        QString error;
+        DatabaseService::provisionDatabaseFile(":/adb.db", path, &error);
+        return error;
+    });
+    databaseProvisioningPending = true;
     ui->setupUi(this);
 
     QSqlDatabase db = QSqlDatabase::database("xfb_connection");
     networkManager = new QNetworkAccessManager(this);
+    networkMaintenance = new NetworkMaintenance(networkManager, this);
+    connect(networkMaintenance, &NetworkMaintenance::publicAddressChanged, this,
+            [this](const QHostAddress& address) { ui->lbl_ddns->setText(address.toString()); });
+
+    // Program uploads and server checks wait their turn instead of all
+    // running at once; progress goes to the screen reader announcements
+    serverTransfers = new TransferQueue(this);
+    connect(serverTransfers, &TransferQueue::progressChanged, this, [this](int finished, int total) {
+        BackgroundOperationFeedback* feedback = backgroundFeedback();
+        if (!feedback)
+            return;
+        if (transferOperation < 0)
+            transferOperation = feedback->startOperation(
+                tr("Server transfers"), tr("Sending to the server"),
+                BackgroundOperationFeedback::OperationType::NetworkOperation);
+        if (transferOperation >= 0 && total > 0)
+            feedback->updateProgress(transferOperation, finished * 100 / total,
+                                     tr("%1 of %2 transfers done").arg(finished).arg(total));
+    });
+    connect(serverTransfers, &TransferQueue::jobRetrying, this,
+            [this](int, const QString& error, int delayMs) {
+                BackgroundOperationFeedback* feedback = backgroundFeedback();
+                if (feedback && transferOperation >= 0)
+                    feedback->reportError(transferOperation,
+                                          tr("%1; retrying in %2 seconds").arg(error).arg(delayMs / 1000));
+            });
+    connect(serverTransfers, &TransferQueue::drained, this, [this](int succeeded, int failed) {
+        BackgroundOperationFeedback* feedback = backgroundFeedback();
+        if (feedback && transferOperation >= 0)
+            feedback->completeOperation(transferOperation, failed == 0,
+                                        failed == 0 ? tr("%1 transfers done").arg(succeeded)
+                                                    : tr("%1 of %2 transfers failed")
+                                                          .arg(failed)
+                                                          .arg(succeeded + failed));
+        transferOperation = -1;
+    });
     /*
         // Only needs to be done once per application run
         QtWebEngineQuick::initialize();
@@ -136,6 +448,10 @@ player::player(QWidget* parent) : QMainWindow(parent), ui(new Ui::player) {
         // Set a minimum width based on Google's requirement (or your layout needs)
         adBanner->setMinimumWidth(728);
         adBanner->setResizeMode(QQuickWidget::SizeRootObjectToView);
+        // Revalidated from disk rather than downloaded again on every refresh
+        adBannerCache = new QmlHttpCache(
+            QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/ad-banner");
+        adBanner->engine()->setNetworkAccessManagerFactory(adBannerCache);
         adBanner->setSource(QUrl("qrc:/AdView.qml")); // Load from resource
 
         ui->gridLayout_2->addWidget(adBanner, 25, 0, 1, 1);
@@ -143,22 +459,31 @@ player::player(QWidget* parent) : QMainWindow(parent), ui(new Ui::player) {
         // Keep refresh logic if needed, but call the QML function
         adRefreshTimer = new QTimer(this); // Assuming adRefreshTimer is a member
         adRefreshTimer->setInterval(60000); // Refresh less often? e.g., 60 seconds
+        adRefreshTimer->setTimerType(Qt::VeryCoarseTimer);
         connect(adRefreshTimer, &QTimer::timeout, this, &player::refreshAdBanner);
         adRefreshTimer->start();*/
 
+    startupProfiler->begin("config");
     updateConfig();
-    checkDbOpen();
+    openDatabase();
+    databaseHealthTimer = new QTimer(this);
+    databaseHealthTimer->setInterval(DB_HEALTH_CHECK_MS);
+    connect(databaseHealthTimer, &QTimer::timeout, this, &player::checkDatabaseHealth);
+    databaseHealthTimer->start();
     // on_actionUpdate_Dinamic_Server_s_IP_triggered();
 
+    startupProfiler->begin("audio");
     // Initialize audio outputs for Qt6
-    XplayerOutput = new QAudioOutput(this);
     lp1_XplayerOutput = new QAudioOutput(this);
     lp2_XplayerOutput = new QAudioOutput(this);
 
-    // Initialize media players with audio outputs
-    Xplayer = new QMediaPlayer(this);
-    Xplayer->setAudioOutput(XplayerOutput);
-    XplaylistIndex = 0;
+    // On-air playback runs on the dual-deck engine so transitions are gapless
+    playbackEngine = new PlaybackEngine(this);
+    playbackEngine->setCrossfadeDuration(crossfadeMs);
+    playbackEngine->setPrefetchSeconds(prefetchSeconds);
+    playbackEngine->setOutputDevice(onAirDevice);
+    applyNativeAudio();
+    playbackEngine->setCueDevice(cueDevice);
 
     lp1_Xplayer = new QMediaPlayer(this);
     lp1_Xplayer->setAudioOutput(lp1_XplayerOutput);
@@ -169,7 +494,6 @@ player::player(QWidget* parent) : QMainWindow(parent), ui(new Ui::player) {
     lp2_XplaylistIndex = 0;
 
     indexcanal = 4;
-    onAbout2Finish = 0;
     autoMode = 1;
     recMode = 0;
     PlayMode = "stopped";
@@ -186,53 +510,119 @@ player::player(QWidget* parent) : QMainWindow(parent), ui(new Ui::player) {
     ui->led_rec->hide();
     ui->txt_loading->hide();
 
-    // Initialize Qt6 media recording components
-    captureSession = new QMediaCaptureSession(this);
-    audioRecorder = new QMediaRecorder(this);
-    audioInput = new QAudioInput(this);
+    // Shows are recorded in rolling segments, so a crash loses seconds of
+    // audio; the segments are joined into saveFile when recording stops
+    recorder = new SegmentRecorder(this);
+    // Opened once for the recorder and a live stream alike, so both can run
+    liveCapture = new LiveCapture(this);
+    // Enumerated here once, and again only when the system's devices change
+    audioDevices = new AudioDeviceRegistry(this);
+
+    // Measures on the audio threads; as a child created after the engine it
+    // is deleted after the engine has stopped feeding it
+    deadAirDetector = new DeadAirDetector(this);
+    playbackEngine->setDeadAirDetector(deadAirDetector);
+    liveCapture->addListener([this](const float* samples, int count) {
+        deadAirDetector->process(DeadAirDetector::Source::Input, samples, count);
+    });
+    connect(playbackEngine, &PlaybackEngine::stateChanged, this, [this]() { applyDeadAir(); });
+    connect(liveCapture, &LiveCapture::capturingChanged, this, [this]() { applyDeadAir(); });
+    connect(deadAirDetector, &DeadAirDetector::deadAir, this,
+            [this](DeadAirDetector::Source source, qint64 silentMs) {
+                const bool output = source == DeadAirDetector::Source::Output;
+                const QString message =
+                    tr("Dead air: %1 has been silent for %2 seconds")
+                        .arg(output ? tr("the output") : tr("the live input"))
+                        .arg(silentMs / 1000);
+                QJsonObject fields{
+                    {"component", "DeadAir"}, {"message", message}, {"silent_ms", silentMs}};
+                // Keep the timeline of the seconds before the gap
+                if (Tracer::isEnabled()) {
+                    const QString stamp =
+                        QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss");
+                    const QString tracePath = traceDirectory() + "/deadair_" + stamp + ".json";
+                    if (Tracer::writeChromeTrace(tracePath))
+                        fields.insert("trace", tracePath);
+                }
+                eventJournal->record(EventJournal::Type::Error, fields);
+                auto* announcer = ServiceContainer::instance()->resolve<SystemStatusAnnouncer>();
+                if (announcer)
+                    announcer->announceCriticalAlert(message, "DeadAir");
+                // A silent mic needs a person; a silent deck can be skipped
+                if (!output)
+                    return;
+                if (deadAirAction == "next")
+                    playNextSong();
+                else if (deadAirAction == "recovery")
+                    recoveryStreamTakeOverPlay();
+            });
+    connect(deadAirDetector, &DeadAirDetector::recovered, this,
+            [](DeadAirDetector::Source source, qint64 silentMs) {
+                auto* announcer = ServiceContainer::instance()->resolve<SystemStatusAnnouncer>();
+                if (!announcer)
+                    return;
+                announcer->announceSystemStatus(
+                    tr("Dead air"),
+                    tr("%1 is back after %2 seconds")
+                        .arg(source == DeadAirDetector::Source::Output ? tr("The output")
+                                                                        : tr("The live input"))
+                        .arg(silentMs / 1000),
+                    SystemStatusAnnouncer::Priority::High);
+            });
+    applyDeadAir();
 
-    captureSession->setRecorder(audioRecorder);
-    captureSession->setAudioInput(audioInput);
+    // Follows the same capture as the input meter, on the capture thread
+    micDucker = new MicDucker(this);
+    playbackEngine->setDucker(micDucker);
+    liveCapture->addListener([this](const float* samples, int count) {
+        micDucker->processInput(samples, count, LiveCapture::CHANNELS, liveCapture->sampleRate());
+    });
+    connect(liveCapture, &LiveCapture::capturingChanged, this, [this](bool capturing) {
+        if (!capturing)
+            micDucker->reset();
+    });
+    applyDucking();
+    connect(recorder, &SegmentRecorder::segmentWritten, this,
+            [](const QString& segment) { qCDebug(xfbPlayer) << "Recording segment saved: "
+                                                            << segment; });
+    connect(recorder, &SegmentRecorder::finished, this,
+            [this](const QString& file, bool success, const QString& error) {
+                if (!recorder->isRecording()) {
+                    liveCapture->closeReader(recordReader);
+                    recordReader = -1;
+                }
+                if (!success)
+                    QMessageBox::warning(this, tr("Recording Error"),
+                                         tr("%1 could not be saved: %2").arg(file, error));
+            });
 
     // List available audio input devices
-    const QList<QAudioDevice> inputDevices = QMediaDevices::audioInputs();
+    const QList<QAudioDevice> inputDevices = audioDevices->inputs();
     for (const QAudioDevice& device : inputDevices) {
-        qDebug() << "Audio Hardware on this system: " << device.description();
-    }
-
-    // Get supported audio codecs using mediaFormat() in Qt6
-    const QList<QMediaFormat::AudioCodec> supportedCodecs =
-        audioRecorder->mediaFormat().supportedAudioCodecs(QMediaFormat::Encode);
-    for (const QMediaFormat::AudioCodec& codec : supportedCodecs) {
-        qDebug() << "Audio Codecs on this system: " << QMediaFormat::audioCodecName(codec);
+        qCDebug(xfbPlayer) << "Audio Hardware on this system: " << device.description();
     }
 
-    // Get supported containers (file formats) in Qt6
-    const QList<QMediaFormat::FileFormat> supportedContainers =
-        audioRecorder->mediaFormat().supportedFileFormats(QMediaFormat::Encode);
-    for (const QMediaFormat::FileFormat& format : supportedContainers) {
-        qDebug() << "Audio Containers on this system: " << QMediaFormat::fileFormatName(format);
+    // Recordings cut short by a crash are joined next to where they were saved
+    for (const QString& interrupted : SegmentRecorder::interruptedRecordings(SavePath)) {
+        qInfo() << "Recovering interrupted recording into"
+                << SegmentRecorder::recoveredFile(interrupted);
+        recorder->recover(interrupted);
     }
 
-    // Get supported sample rates - in Qt6 we need to check available quality settings
-    QMediaRecorder::EncodingMode mode = audioRecorder->encodingMode();
-    QMediaRecorder::Quality quality = audioRecorder->quality();
-    qDebug() << "Current encoding mode: " << mode << ", quality: " << quality;
-    qDebug() << "Audio Sample Rates are handled through quality settings in Qt6";
+    connect(playbackEngine, &PlaybackEngine::positionChanged, this, &player::onPositionChanged);
 
-    connect(Xplayer, &QMediaPlayer::positionChanged, this, &player::onPositionChanged);
-    connect(Xplayer, &QMediaPlayer::durationChanged, this, &player::durationChanged);
-    connect(Xplayer, &QMediaPlayer::sourceChanged, this, &player::currentMediaChanged);
-    connect(Xplayer->audioOutput(), &QAudioOutput::volumeChanged, this, &player::volumeChanged);
+    // The clock publishes the position at a fixed low rate, with the time strings made once
+    PlaybackClock* clock = PlaybackClock::instance();
+    connect(clock, &PlaybackClock::positionChanged, this, &player::refreshPositionDisplay);
+    connect(clock, &PlaybackClock::timeChanged, this, &player::refreshTimeDisplay);
+    connect(playbackEngine, &PlaybackEngine::durationChanged, this, &player::durationChanged);
 
-    // Connect media player signals for playlist management
-    connect(Xplayer, &QMediaPlayer::playbackStateChanged,
-            [this](QMediaPlayer::PlaybackState state) {
-                if (state == QMediaPlayer::StoppedState && PlayMode == "Playing_Segue") {
-                    // When playback stops, play the next media if in segue mode
-                    QTimer::singleShot(100, this, &player::playNextMedia);
-                }
-            });
+    // Connect engine signals for playlist management
+    connect(playbackEngine, &PlaybackEngine::trackStarted, this, &player::onEngineTrackStarted);
+    connect(playbackEngine, &PlaybackEngine::nextTrackRequested, this,
+            &player::onEngineNextTrackRequested);
+    connect(playbackEngine, &PlaybackEngine::playbackFinished, this,
+            &player::onEnginePlaybackFinished);
 
     connect(lp1_Xplayer, &QMediaPlayer::positionChanged, this, &player::lp1_onPositionChanged);
     connect(lp1_Xplayer, &QMediaPlayer::durationChanged, this, &player::lp1_durationChanged);
@@ -256,72 +646,36 @@ player::player(QWidget* parent) : QMainWindow(parent), ui(new Ui::player) {
     timer->start(1000);
     showTime();
 
+    startupProfiler->begin("scheduler");
     if (Role == "Server") {
-        QTimer* schedulerTimer = new QTimer(this);
-        connect(schedulerTimer, SIGNAL(timeout()), this, SLOT(run_scheduler()));
-        schedulerTimer->start(60000);
-
-        run_server_scheduler(); // run at startup
-
+        // Scheduled pubs and programs fire from a timer armed for the next event
+        schedulerEngine = new SchedulerEngine(adb, this);
+        connect(schedulerEngine, &SchedulerEngine::eventDue, this, &player::onScheduledEvent);
+        connect(schedulerEngine, &SchedulerEngine::pubRemoved, this,
+                [this](int pubId) {
+                    qCDebug(xfbPlayer) << "Pub" << pubId
+                                       << "has no scheduler rules left and was deleted";
+                    update_music_table();
+                });
+        schedulerEngine->start();
         server_this_day_of_the_week = QDate::currentDate().dayOfWeek();
-        QTimer* schedulerTimerh = new QTimer(this);
-        connect(schedulerTimerh, SIGNAL(timeout()), this, SLOT(run_server_scheduler()));
-        schedulerTimerh->start(3600000); // once per hour
-
-        QTimer* schedulerTimerMT = new QTimer(this);
-        connect(schedulerTimerMT, SIGNAL(timeout()), this, SLOT(monitorTakeOver()));
-        schedulerTimerMT->start(25000);
     }
 
-    /*Populate music table with an editable table field on double-click*/
-    checkDbOpen();
-    QSqlTableModel* model = new QSqlTableModel(this, db);
-    model->setTable("musics");
-    model->select();
-
-    ui->musicView->setModel(model);
-    ui->musicView->setSortingEnabled(true);
-    ui->musicView->hideColumn(0);
-    ui->musicView->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
-    ui->musicView->setColumnWidth(1, 150);
-    ui->musicView->setColumnWidth(2, 150);
-    ui->musicView->setColumnWidth(3, 80);
-    ui->musicView->setColumnWidth(4, 80);
-    ui->musicView->setColumnWidth(5, 60);
-    ui->musicView->setColumnWidth(6, 100);
-    ui->musicView->setColumnWidth(7, 300);
-    ui->musicView->setColumnWidth(8, 50);
-    ui->musicView->setColumnWidth(9, 80);
-    ui->musicView->setColumnWidth(10, 100);
-    checkDbOpen();
-    /*Populate jingles table with an editable table field on double-click*/
-    QSqlTableModel* jinglesmodel = new QSqlTableModel(this, db);
-    jinglesmodel->setTable("jingles");
-    jinglesmodel->select();
-    ui->jinglesView->setModel(jinglesmodel);
-    ui->jinglesView->setSortingEnabled(true);
-    ui->jinglesView->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
-
-    /*Populate Pub table*/
-
-    QSqlTableModel* pubmodel = new QSqlTableModel(this, db);
-    pubmodel->setTable("pub");
-    pubmodel->select();
-    ui->pubView->setModel(pubmodel);
-    ui->pubView->setSortingEnabled(true);
-    ui->pubView->hideColumn(0);
-    ui->pubView->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
-
-    /*Populate Programs table*/
-
-    QSqlTableModel* programsmodel = new QSqlTableModel(this, db);
-    programsmodel->setTable("programs");
-    programsmodel->select();
-    ui->programsView->setModel(programsmodel);
-    ui->programsView->setSortingEnabled(true);
-    ui->programsView->hideColumn(0);
-    ui->programsView->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+    // Program ingest and TakeOver requests are handled on a thread of their
+    // own, with its own database connection; only the results come back here
+    broadcastWorker = new BroadcastWorker(this);
+    connect(broadcastWorker, &BroadcastWorker::programsChanged, this, [this](int added) {
+        qCDebug(xfbScheduler) << added << "programs added to the database";
+        update_music_table();
+    });
+    connect(broadcastWorker, &BroadcastWorker::takeOverRequested, this, &player::startTakeOver);
+    connect(broadcastWorker, &BroadcastWorker::takeOverReturned, this, &player::endTakeOver);
+    broadcastWorker->start(adb.databaseName(), ProgramsPath, TakeOverPath);
+    if (Role == "Server") {
+        broadcastWorker->watch();
+    }
 
+    startupProfiler->begin("window");
     /*Drag & Drop Set*/
 
     /*player*/
@@ -337,6 +691,324 @@ player::player(QWidget* parent) : QMainWindow(parent), ui(new Ui::player) {
     // Accessibility improvements for playlist
     ui->playlist->setFocusPolicy(Qt::StrongFocus);
     ui->playlist->setAttribute(Qt::WA_KeyboardFocusChange, true);
+
+    startupProfiler->begin("services");
+    // Time every query the services and repositories run so slow ones show up
+    // in the log and feed the optimizer's index recommendations
+    dbOptimizer = new DatabaseOptimizer(adb, this);
+    if (dbOptimizer->initialize()) {
+        dbOptimizer->startQueryMonitoring();
+        dbOptimizer->setAutomaticQueryTiming(true);
+        connect(dbOptimizer, &DatabaseOptimizer::slowQueryDetected, this,
+                [](const QString& query, qint64 executionTime) {
+                    qWarning() << "Slow query (" << executionTime << "ms):" << query;
+                });
+    }
+    // Keep the database tidy in short slices, never right before a pub or program
+    maintenance = new MaintenanceScheduler(adb, this);
+    maintenance->setSchedulerEngine(schedulerEngine);
+    if (maintenance->start())
+        dbOptimizer->setWholeDatabaseMaintenance(false);
+
+    // TakeOver failover reacts to the client's stream server going away
+    reachability = new ReachabilityMonitor(this);
+    connect(reachability, &ReachabilityMonitor::statusChanged, this,
+            [this](const QString& name, ReachabilityMonitor::Status status) {
+                if (name != "takeover")
+                    return;
+                if (status == ReachabilityMonitor::Status::Unreachable) {
+                    qWarning() << "ERROR reaching TakeOver Client!! Taking recovery actions...";
+                    triggerPingFailureActions();
+                } else if (status == ReachabilityMonitor::Status::Reachable) {
+                    qInfo() << "TakeOver Client reachable |<- " << takeOverIP << "("
+                            << reachability->averageRtt("takeover") << "ms average)";
+                }
+            });
+
+    // The playlist head is kept prefetched while a TakeOver is on air, and
+    // each failover is timed from the first failed probe to local audio
+    failoverStandby = new FailoverStandby(this);
+    failoverStandby->setPrefetcher(
+        [this](const QString& filePath) { playbackEngine->prefetch(filePath); });
+    connect(failoverStandby, &FailoverStandby::standbyMissing, this, [this]() {
+        qWarning() << "TakeOver standby: the playlist is empty, nothing to fail over to";
+        if (autoMode == 1)
+            playlistAboutToFinish();
+    });
+    connect(failoverStandby, &FailoverStandby::failoverCompleted, this,
+            [this](qint64 detectionMs, qint64 switchMs) {
+                historyModel->append(QDateTime::currentDateTime(),
+                                     QString("FAILOVER to local playlist after %1 ms "
+                                             "(%2 ms detection, %3 ms switch)")
+                                         .arg(detectionMs + switchMs)
+                                         .arg(detectionMs)
+                                         .arg(switchMs));
+            });
+    connect(reachability, &ReachabilityMonitor::probeFinished, this,
+            [this](const QString& name, bool reachable, int rttMs) {
+                if (name != "takeover")
+                    return;
+                if (reachable)
+                    failoverStandby->probeSucceeded();
+                else
+                    failoverStandby->probeFailed(rttMs);
+            });
+    connect(playbackEngine, &PlaybackEngine::trackStarted, failoverStandby,
+            &FailoverStandby::completeFailover);
+
+    // New programs from the FTP server, downloaded without blocking the UI
+    programSync = new FtpSyncEngine(this);
+    connect(programSync, &FtpSyncEngine::fileDownloaded, this,
+            [this](const QString& fileName, const QString&) {
+                broadcastWorker->addDownloadedProgram(fileName);
+            });
+    connect(programSync, &FtpSyncEngine::syncFinished, this,
+            [](bool ok, int downloaded, int failed) {
+                qCDebug(xfbPlayer)
+                    << "server_ftp_check() :: SERVER: Finished looking for programs on the FTP"
+                    << (ok ? "" : "(server not reachable)") << downloaded << "new," << failed
+                    << "failed";
+            });
+
+    // icecast and butt run as supervised children; the status labels follow
+    // their state instead of polling pgrep
+    streamSupervisor = new ProcessSupervisor(this);
+    connect(streamSupervisor, &ProcessSupervisor::stateChanged, this,
+            [this](const QString& name, ProcessSupervisor::State) {
+                if (name == "icecast")
+                    ice_timmer();
+                else if (name == "butt")
+                    butt_timmer();
+            });
+    // Stops the helpers in parallel and by process group, never by blocking
+    processShutdown = new ShutdownCoordinator(streamSupervisor, this);
+    streamOutput = new StreamOutput(this);
+    connect(streamOutput, &StreamOutput::mountStateChanged, this, [this]() { butt_timmer(); });
+    icecastMetadata = new IcecastMetadata(this);
+    applyStreamMetadata();
+    // A source that reconnects starts without a title
+    connect(streamOutput, &StreamOutput::mountStateChanged, icecastMetadata,
+            [this](const QString&, IcecastSource::State state) {
+                if (state == IcecastSource::State::Streaming)
+                    icecastMetadata->resend();
+            });
+    // A TakeOver from a client with the contribution link plays from it, and
+    // the link going quiet is what fails over, instead of probing the stream
+    contributionLink = new ContributionLink(this);
+    contributionLink->setOutputDevice(DeckMixer::findOutput(onAirDevice));
+    connect(contributionLink, &ContributionLink::receivingChanged, this, [this](bool receiving) {
+        if (!contributionOnAir)
+            return;
+        if (receiving) {
+            qInfo() << "TakeOver Client audio arriving |<- " << takeOverIP;
+        } else {
+            qWarning() << "ERROR receiving the TakeOver Client!! Taking recovery actions...";
+            triggerPingFailureActions();
+        }
+    });
+    airCheck = new AirCheckRecorder(this);
+    applyAirCheck();
+
+    // Library searches go through the FTS index when this SQLite has FTS5
+    fullTextSearch = MusicRepository::ensureFullTextIndex(adb);
+    // Popularity scores for ranking the matches, kept by playHistory
+    TrackRanking(adb).ensure();
+    // Proof of play of the scheduled pubs and programs, written by playHistory
+    ProofOfPlay(adb).ensure();
+    durationCache = new DurationCache(adb, this);
+    durationCache->initialize();
+    setupTasks();
+    setupCuePoints();
+    setupLoudness();
+    setupProgramBuilder();
+    setupWaveform();
+    setupAnalysis();
+    setupTranscoder();
+    setupDownloads();
+    setupTableChanges();
+    setupDeduplication();
+    setupMediaCache();
+    setupTranscodeCache();
+    setupMediaInfo();
+    setupServerPresence();
+    setupSearch();
+    setupLibraryCheck();
+    setupLibraryRescan();
+    setupRetention();
+    setupMemoryBudget();
+    setupMetrics();
+    // Logs what the GUI thread was doing whenever its event loop freezes
+    stallWatchdog = new StallWatchdog(this);
+    connect(stallWatchdog, &StallWatchdog::stalled, this,
+            [this](const StallWatchdog::Stall& stall) {
+                qCWarning(xfbPlayer).noquote()
+                    << "GUI thread froze for" << stall.durationMs << "ms at"
+                    << stall.started.toString(Qt::ISODateWithMs) << "in"
+                    << (stall.spans.isEmpty() ? QString("untraced code")
+                                              : stall.spans.join(" > "));
+                eventJournal->record(EventJournal::Type::Error,
+                                     {{"component", "StallWatchdog"},
+                                      {"message", "GUI thread froze"},
+                                      {"duration_ms", stall.durationMs},
+                                      {"spans", QJsonArray::fromStringList(stall.spans)},
+                                      {"stack", QJsonArray::fromStringList(stall.stack)}},
+                                     stall.started);
+            });
+    playHistory = new PlayHistoryWriter(adb, this);
+    eventJournal = new EventJournal(this);
+    eventJournal->open(EventJournal::defaultLocation());
+    // The history list starts with what went on air earlier today
+    historyModel = new HistoryListModel(HistoryListModel::DEFAULT_CAPACITY, this);
+    historyModel->load(EventJournal::read(eventJournal->directory(),
+                                          QDateTime(QDate::currentDate(), QTime(0, 0)),
+                                          QDateTime::currentDateTime()));
+    ui->historyList->setModel(historyModel);
+    ui->historyList->scrollToBottom();
+    connect(playbackEngine, &PlaybackEngine::stateChanged, this, [this](DeckMixer::State state) {
+        if (state == DeckMixer::State::Stopped)
+            journalTrackEnded("stopped");
+    });
+    connect(playbackEngine, &PlaybackEngine::errorOccurred, this, [this](const QString& message) {
+        eventJournal->record(EventJournal::Type::Error,
+                             {{"component", "PlaybackEngine"}, {"message", message}});
+    });
+    connect(&ErrorHandler::instance(), &ErrorHandler::errorOccurred, this,
+            [this](ErrorHandler::ErrorSeverity severity, const QString& component,
+                   const QString& message, const QString& details,
+                   ErrorHandler::ErrorCategory category) {
+                eventJournal->record(EventJournal::Type::Error,
+                                     {{"severity", ErrorHandler::severityToString(severity)},
+                                      {"category", ErrorHandler::categoryToString(category)},
+                                      {"component", component},
+                                      {"message", message},
+                                      {"details", details}});
+            });
+    hourGenreSchedule = new HourGenreSchedule(adb, this);
+    rotationEngine = new RotationEngine(adb, this);
+    rotationEngine->setSeparation(rotationSeparation);
+    rotationEngine->setArtistSeparation(rotationArtistSeparationMin);
+    rotationEngine->setTitleSeparation(rotationTitleSeparationMin);
+    // Tracks edited through the repository reach the pools before the snapshot is rebuilt
+    connect(musicRepository, &MusicRepository::musicAdded, rotationEngine,
+            &RotationEngine::addTrack);
+    connect(musicRepository, &MusicRepository::musicUpdated, rotationEngine,
+            &RotationEngine::updateTrack);
+    connect(musicRepository, &MusicRepository::musicDeleted, rotationEngine,
+            &RotationEngine::removeTrack);
+    // The library is read on a worker thread; auto mode and the day log pick from the copy
+    librarySnapshots = new LibrarySnapshotStore(databasePath, this);
+    rotationEngine->setSnapshots(librarySnapshots);
+    // After a failed rebuild the rotation reads the table, which has the change
+    connect(librarySnapshots, &LibrarySnapshotStore::rebuilt, rotationEngine,
+            &RotationEngine::invalidate);
+    connect(librarySnapshots, &LibrarySnapshotStore::rebuildFailed, rotationEngine,
+            &RotationEngine::invalidate);
+    librarySnapshots->rebuild();
+    jinglePool = new SpotPool(adb, "jingles", this);
+    jinglePool->setDurationLookup(
+        [this](const QString& filePath) { return durationCache->durationUs(filePath); });
+    adBreaks = new AdBreakPacker(adb, this);
+    adBreaks->setDurationLookup(
+        [this](const QString& filePath) { return durationCache->durationUs(filePath); });
+    if (schedulerEngine) {
+        // Rules are checked for overlaps with the length of what they air
+        schedulerEngine->setDurationLookup(
+            [this](const QString& filePath) { return durationCache->durationUs(filePath); });
+    }
+    applyAdBreaks();
+    // Jingles fired from the library play from memory, over the music
+    cartWall = new CartWall(this);
+    playbackEngine->setCartWall(cartWall);
+    loadCartWall();
+    // The on-air queue; each entry is looked up once, when it is queued, and
+    // keeps its duration and cue points so the total follows without probing
+    playlistQueue = new PlaylistQueueModel(this);
+    playlistQueue->setResolver([this](PlaylistQueueModel::Entry& entry) {
+        if (durationCache && entry.durationUs < 0) {
+            entry.durationUs = durationCache->durationUs(entry.path);
+            if (entry.durationUs < 0)
+                qWarning() << "Could not determine duration for:" << entry.path;
+        }
+        if (cuePoints) {
+            const CuePoints cue = cuePoints->cuePoints(entry.path);
+            entry.cueInMs = cue.inMs;
+            entry.cueOutMs = cue.outMs;
+        }
+        if (musicRepository && entry.musicId < 0)
+            entry.musicId = musicRepository->getMusicIdByPath(entry.path);
+    });
+    ui->playlist->setModel(playlistQueue);
+    connect(playlistQueue, &QAbstractItemModel::rowsInserted, this,
+            [this](const QModelIndex&, int first, int last) {
+                QStringList added;
+                for (int row = first; row <= last; ++row)
+                    added << playlistQueue->path(row);
+                peakGenerator->generate(added);
+                if (first < TRANSCODE_LOOKAHEAD)
+                    transcodeCache->prepare(added.mid(0, TRANSCODE_LOOKAHEAD - first));
+                mediaCache->prepare(added);
+                if (first == 0 && PlayMode != "stopped")
+                    playbackEngine->prefetch(playlistQueue->path(0));
+            });
+    connect(playlistQueue, &QAbstractItemModel::rowsInserted, this, &player::updateFailoverStandby);
+    connect(playlistQueue, &QAbstractItemModel::rowsRemoved, this, &player::updateFailoverStandby);
+    connect(playlistQueue, &QAbstractItemModel::rowsMoved, this, &player::updateFailoverStandby);
+    connect(playlistQueue, &QAbstractItemModel::modelReset, this, &player::updateFailoverStandby);
+    setupQueueJournal();
+
+    // Lobby displays follow the station from one row, read-only
+    nowPlayingStatus = new NowPlayingStatus(adb);
+    nowPlayingStatus->ensureTable();
+    nowPlayingTimer = new QTimer(this);
+    nowPlayingTimer->setSingleShot(true);
+    nowPlayingTimer->setInterval(NOW_PLAYING_DELAY_MS);
+    connect(nowPlayingTimer, &QTimer::timeout, this, &player::writeNowPlaying);
+    const auto scheduleNowPlaying = [this]() { nowPlayingTimer->start(); };
+    connect(playbackEngine, &PlaybackEngine::trackStarted, this, scheduleNowPlaying);
+    connect(playbackEngine, &PlaybackEngine::durationChanged, this, scheduleNowPlaying);
+    connect(playbackEngine, &PlaybackEngine::stateChanged, this, scheduleNowPlaying);
+    connect(playlistQueue, &QAbstractItemModel::rowsInserted, this, scheduleNowPlaying);
+    connect(playlistQueue, &QAbstractItemModel::rowsRemoved, this, scheduleNowPlaying);
+    connect(playlistQueue, &QAbstractItemModel::rowsMoved, this, scheduleNowPlaying);
+    connect(playlistQueue, &QAbstractItemModel::modelReset, this, scheduleNowPlaying);
+    connect(playlistQueue, &PlaylistQueueModel::totalChanged, this,
+            [this]() { calculate_playlist_total_time(); });
+    setupBackTiming();
+    // Broken files of the next entries are swapped for a song of the same genre
+    playlistValidator = new PlaylistValidator(playlistQueue, this);
+    playlistValidator->setReplacementPicker([this](const PlaylistQueueModel::Entry& entry) {
+        if (entry.musicId < 0 || !musicRepository)
+            return QString();
+        const QString genre = musicRepository->getMusicById(int(entry.musicId)).genre1;
+        return genre.isEmpty() ? QString() : rotationEngine->nextTrack(genre);
+    });
+    connect(playlistValidator, &PlaylistValidator::problemFound, this,
+            [this](const QString& filePath, PlaylistValidator::Problem problem,
+                   const QString& detail) {
+                const QString message = PlaylistValidator::describe(problem, detail);
+                qCWarning(xfbPlaylist) << "Queued file" << filePath << "-" << message;
+                eventJournal->record(EventJournal::Type::Error, {{"component", "PlaylistValidator"},
+                                                                 {"message", message},
+                                                                 {"path", filePath}});
+            });
+    connect(playlistValidator, &PlaylistValidator::replaced, this,
+            [this](int row, const QString& oldPath, const QString& newPath) {
+                qCInfo(xfbPlaylist) << "Replaced" << oldPath << "with" << newPath << "at" << row;
+                peakGenerator->generate({newPath});
+                if (row < TRANSCODE_LOOKAHEAD)
+                    transcodeCache->prepare({newPath});
+                mediaCache->prepare({newPath});
+                if (row == 0) {
+                    updateFailoverStandby();
+                    if (PlayMode != "stopped")
+                        playbackEngine->prefetch(newPath);
+                }
+            });
+    // Needs the queue, the engine and the scheduler
+    setupRemoteControl();
+    setupLibrarySync();
+    setupConfigReload();
+    startupProfiler->begin("widgets");
     /*Music list*/
     ui->musicView->setSelectionMode(QAbstractItemView::ExtendedSelection);
     ui->musicView->setDragEnabled(true);
@@ -383,18 +1055,6 @@ player::player(QWidget* parent) : QMainWindow(parent), ui(new Ui::player) {
     connect(ui->programsView, SIGNAL(customContextMenuRequested(const QPoint&)), this,
             SLOT(programsViewContextMenu(const QPoint&)));
 
-    /*Populate genre1 and 2 filters*/
-
-    QSqlQueryModel* model_genre1 = new QSqlQueryModel();
-    QSqlQuery* qry = new QSqlQuery(db);
-    QString sqlq = "select name from genres1";
-    qry->exec(sqlq);
-    model_genre1->setQuery(std::move(*qry));
-    ui->cBoxGenre1->setModel(model_genre1);
-    ui->cBoxGenre2->setModel(model_genre1);
-
-    update_music_table();
-
     /*Bottom info*/
     QDir dir;
     QString cpath = dir.absolutePath();
@@ -407,47 +1067,163 @@ player::player(QWidget* parent) : QMainWindow(parent), ui(new Ui::player) {
 
     if (Role == "Server") {
         autoMode = 1;
-        qDebug() << "Role is set to Server, so autoMode is ON by default";
+        qCDebug(xfbPlayer) << "Role is set to Server, so autoMode is ON by default";
         ui->bt_autoMode->setStyleSheet("background-color: rgb(175, 227, 59)");
         ui->bt_takeOver->setHidden(true);
         ui->menuClient_3->setEnabled(false);
 
     } else {
-        qDebug("XFB is now running in client mode!");
+        qCDebug(xfbPlayer, "XFB is now running in client mode!");
 
         autoMode = 0;
-        qDebug() << "autoMode is OFF";
+        qCDebug(xfbPlayer) << "autoMode is OFF";
         ui->bt_autoMode->setStyleSheet("");
         ui->menuServer->setEnabled(false);
     }
 
-    QPixmap pixmap(":/images/donate.png");
-    CustomMessageBox msgBox(
-        tr("Donate to the Developer!"),
-        tr("Please support the development of XFB!<br>If you appreciate this software, kindly "
-           "consider making a donation to support the developer!<br><a "
-           "href=\"https://www.paypal.com/donate/?hosted_button_id=TFDSZU78WLMC6\">Donate via "
-           "PayPal!</a><br>Contact for professional support and custom development!<br><br>Why did "
-           "the computer get a little emotional when using WinRAR?<br>_Because even after all the "
-           "\"evaluation\", it still felt unzipped!"),
-        pixmap);
-    msgBox.exec();
-
     // Directly set style on the status bar
     if (darkMode) {
-        qDebug("Loading darkmode");
+        qCDebug(xfbPlayer, "Loading darkmode");
         ui->statusBar->setStyleSheet("background-color: #353535 !important; color: #ffffff; "
                                      "border: none; margin: 0; padding: 0;");
 
     } else {
-        qDebug("Loading lightmode");
+        qCDebug(xfbPlayer, "Loading lightmode");
         this->setStyleSheet("background-color: #ffffff");
         ui->statusBar->setStyleSheet("background-color: #ffffff !important; color: #303030; "
                                      "border: none; margin: 0; padding: 0;");
     }
+    startupProfiler->end();
+}
+
+void player::showEvent(QShowEvent* event) {
+    QMainWindow::showEvent(event);
+    // Queued behind the paint events of the first show
+    if (!startupFinished) {
+        startupFinished = true;
+        QTimer::singleShot(0, this, &player::finishStartup);
+    }
+}
+
+void player::setupTableModels() {
+    if (musicsModel)
+        return;
+    /*Populate music table with an editable table field on double-click*/
+    checkDbOpen();
+    // The table models live as long as the window; the changes posted to
+    // TableChangeBus reach them row by row, so selection and scroll position survive
+    musicsModel = new LiveTableModel("musics", "xfb_connection", this);
+    musicsModel->select();
+
+    ui->musicView->setModel(musicsModel);
+    ui->musicView->setSortingEnabled(true);
+    // Read ahead the info of the track under the cursor; moving on supersedes the read
+    connect(ui->musicView->selectionModel(), &QItemSelectionModel::currentRowChanged, this,
+            [this](const QModelIndex& current) {
+                if (current.isValid() && mediaInfoLoader)
+                    mediaInfoLoader->request(
+                        musicsModel->index(current.row(), 7).data().toString());
+            });
+    ui->musicView->hideColumn(0);
+    if (musicsModel->fieldIndex("rank_score") >= 0)
+        ui->musicView->hideColumn(musicsModel->fieldIndex("rank_score"));
+    ui->musicView->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+    ui->musicView->setColumnWidth(1, 150);
+    ui->musicView->setColumnWidth(2, 150);
+    ui->musicView->setColumnWidth(3, 80);
+    ui->musicView->setColumnWidth(4, 80);
+    ui->musicView->setColumnWidth(5, 60);
+    ui->musicView->setColumnWidth(6, 100);
+    ui->musicView->setColumnWidth(7, 300);
+    ui->musicView->setColumnWidth(8, 50);
+    ui->musicView->setColumnWidth(9, 80);
+    ui->musicView->setColumnWidth(10, 100);
+    checkDbOpen();
+    /*Populate jingles table with an editable table field on double-click*/
+    jinglesModel = new LiveTableModel("jingles", "xfb_connection", this);
+    jinglesModel->select();
+    ui->jinglesView->setModel(jinglesModel);
+    ui->jinglesView->setSortingEnabled(true);
+    ui->jinglesView->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+
+    /*Populate Pub table*/
+
+    pubModel = new LiveTableModel("pub", "xfb_connection", this);
+    pubModel->select();
+    ui->pubView->setModel(pubModel);
+    ui->pubView->setSortingEnabled(true);
+    ui->pubView->hideColumn(0);
+    ui->pubView->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+
+    /*Populate Programs table*/
+
+    programsModel = new LiveTableModel("programs", "xfb_connection", this);
+    programsModel->select();
+    ui->programsView->setModel(programsModel);
+    ui->programsView->setSortingEnabled(true);
+    ui->programsView->hideColumn(0);
+    ui->programsView->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+
+    // Rows of one height, and cell text laid out once rather than on every scroll
+    for (QTableView* view : {ui->musicView, ui->jinglesView, ui->pubView, ui->programsView})
+        ElidedTextDelegate::install(view);
+
+    /*Populate genre1 and 2 filters*/
+
+    genresModel = new LiveTableModel("genres1", "xfb_connection", this);
+    genresModel->select();
+    genresModel->sort(genresModel->fieldIndex("name"), Qt::AscendingOrder);
+    for (QComboBox* box : {ui->cBoxGenre1, ui->cBoxGenre2, ui->comboBox_random_add_genre}) {
+        box->setModel(genresModel);
+        box->setModelColumn(std::max(0, genresModel->fieldIndex("name")));
+    }
+
+    // A refresh after an import reaches a screen reader as one change and one sentence
+    const auto batchRefreshes = [this](LiveTableModel* model, const QString& singular,
+                                       const QString& plural) {
+        connect(model, &LiveTableModel::batchStarted, this,
+                [model]() { AccessibilityEventBatcher::instance()->beginBatch(model); });
+        connect(model, &LiveTableModel::batchFinished, this,
+                [model, singular, plural](int inserted, int removed, int updated) {
+                    AccessibilityEventBatcher::instance()->endBatch(
+                        model, AccessibilityEventBatcher::summarize(inserted, removed, updated,
+                                                                    singular, plural));
+                });
+    };
+    batchRefreshes(musicsModel, tr("track"), tr("tracks"));
+    batchRefreshes(jinglesModel, tr("jingle"), tr("jingles"));
+    batchRefreshes(pubModel, tr("advert"), tr("adverts"));
+    batchRefreshes(programsModel, tr("program"), tr("programs"));
+}
 
+void player::finishStartup() {
+    startupProfiler->begin("tables");
+    setupTableModels();
+    startupProfiler->begin("accessibility");
     // Initialize accessibility features for the player interface
     initializeAccessibility();
+    startupProfiler->end();
+    qCInfo(xfbPlayer).noquote() << "Startup:" << startupProfiler->summary();
+    MetricsRegistry::instance()
+        .gauge("xfb_startup_milliseconds", "Time from creating the main window to a usable one")
+        ->set(startupProfiler->totalNs() / 1000000);
+    delete startupProfiler;
+    startupProfiler = nullptr;
+
+    // Started only now, so the deferred start-up is not reported as a stall
+    applyStallWatchdog();
+
+    QPixmap pixmap(":/images/donate.png");
+    CustomMessageBox msgBox(
+        tr("Donate to the Developer!"),
+        tr("Please support the development of XFB!<br>If you appreciate this software, kindly "
+           "consider making a donation to support the developer!<br><a "
+           "href=\"https://www.paypal.com/donate/?hosted_button_id=TFDSZU78WLMC6\">Donate via "
+           "PayPal!</a><br>Contact for professional support and custom development!<br><br>Why did "
+           "the computer get a little emotional when using WinRAR?<br>_Because even after all the "
+           "\"evaluation\", it still felt unzipped!"),
+        pixmap);
+    msgBox.exec();
 }
 
 void player::initializeAccessibility() {
@@ -459,7 +1235,7 @@ void player::initializeAccessibility() {
         if (accessibilityManager) {
             // Initialize player-specific accessibility enhancements
             if (accessibilityManager->initializePlayerAccessibility(this)) {
-                qDebug() << "Player accessibility initialized successfully";
+                qCDebug(xfbPlayer) << "Player accessibility initialized successfully";
             } else {
                 qWarning() << "Failed to initialize player accessibility";
             }
@@ -471,15 +1247,41 @@ void player::initializeAccessibility() {
     }
 }
 
+BackgroundOperationFeedback* player::backgroundFeedback() const {
+    auto* accessibilityManager = ServiceContainer::instance()->resolve<AccessibilityManager>();
+    return accessibilityManager ? accessibilityManager->backgroundOperationFeedback() : nullptr;
+}
+
 player::~player() {
+    // The playlist bookkeeping and the history writer use adb, which goes
+    // away before QObject children are deleted, so tear them down first
+    playlistQueue->disconnect(this);
+    // Written out before the engine stops, so a restart resumes where this left off
+    delete queueJournal;
+    queueJournal = nullptr;
+    journalTrackEnded("shutdown");
+    delete startupProfiler;
+    delete playHistory;
+    delete nowPlayingStatus;
+    delete durationCache;
+    delete rotationEngine;
+    delete librarySnapshots;
+    delete hourGenreSchedule;
+    delete maintenance;
+    backgroundThrottle->stop();
+    delete schedulerEngine;
+    delete dbOptimizer;
+
+    // They pull audio on threads of their own; stop them while their sources are alive
+    delete airCheck;
+    delete recorder;
+    delete contributionLink;
+    delete liveCapture;
     delete ui;
-    delete audioRecorder;
-    delete captureSession;
-    delete audioInput;
-    delete XplayerOutput;
     delete lp1_XplayerOutput;
     delete lp2_XplayerOutput;
     delete adBanner;
+    delete adBannerCache;
 }
 
 // Generic helper to launch an external GUI application safely
@@ -515,113 +1317,129 @@ void player::launchExternalApplication(const QString& appName, const QString& fi
     }
 }
 
-// Generic helper to get MediaInfo (ASYNC) - Requires modification
-// TODO: Implement proper parsing of MediaInfo output (JSON is best)
+void player::setupSearch() {
+    // Matches are read on a worker and shown without another query; typing
+    // on narrows the last matches, and recent ones are cached
+    searchCache = new MusicCache(this);
+    searchCache->setMaxMemoryUsage(SEARCH_CACHE_BYTES);
+    searchCache->setWarmupStrategy(MusicCache::NoWarmup);
+    searchCache->initialize();
+    searchCache->attachRepository(musicRepository);
+    searchController = new SearchController(adb.databaseName(), searchCache, this);
+    searchController->setFullTextSearch(fullTextSearch);
+    connect(searchController, &SearchController::resultsReady, this,
+            [this](const SearchController::Result& result) {
+                if (!musicsModel)
+                    return;
+                // A refresh after an import keeps to the same matches
+                musicsModel->setFilter(result.condition, result.bindValues);
+                if (!musicsModel->assignRows(result.fields, result.keys, result.rows))
+                    musicsModel->select();
+                // The operator lands on the most played, best matching version
+                const int best =
+                    result.ranked.isEmpty() ? -1 : musicsModel->rowOfKey(result.ranked.first());
+                if (best >= 0) {
+                    const QModelIndex index = musicsModel->index(best, 1);
+                    ui->musicView->setCurrentIndex(index);
+                    ui->musicView->scrollTo(index);
+                }
+            });
+}
+
+void player::setupServerPresence() {
+    // Whether programs reached the server is cached, so the programs menu
+    // shows it at once; the check script runs on the transfer queue
+    serverPresenceCache = new MusicCache(this);
+    serverPresenceCache->setMaxMemoryUsage(SERVER_PRESENCE_CACHE_BYTES);
+    serverPresenceCache->setWarmupStrategy(MusicCache::NoWarmup);
+    serverPresenceCache->initialize();
+    serverPresence = new ServerPresenceCache(serverPresenceCache, serverTransfers, this);
+    const QString scriptPath = serverScriptPath("serverFtpCmdsCHKProgram.sh");
+    TransferQueue::Job listing;
+    listing.key = "check:" + scriptPath;
+    listing.description = tr("Checking the programs on the server");
+    listing.program = scriptPath;
+    serverPresence->setListingJob(listing);
+}
+
+void player::setupMediaInfo() {
+    mediaInfoCache = new MusicCache(this);
+    mediaInfoCache->setMaxMemoryUsage(MEDIA_INFO_CACHE_BYTES);
+    mediaInfoCache->setWarmupStrategy(MusicCache::NoWarmup);
+    mediaInfoCache->initialize();
+    mediaInfoLoader = new MediaInfoLoader(mediaInfoCache, this);
+    connect(mediaInfoLoader, &MediaInfoLoader::loaded, this,
+            [this](const MediaInfoLoader::Info& info) {
+                if (info.path != mediaInfoShowPath)
+                    return; // Read ahead for a selected track
+                mediaInfoShowPath.clear();
+                applyMediaInfo(info.toVariant());
+            });
+}
+
 void player::getMediaInfoForFile(const QString& filePath) {
-    QString mediaInfoPath = QStandardPaths::findExecutable("mediainfo");
-    if (mediaInfoPath.isEmpty()) {
-        QMessageBox::warning(
-            this, tr("Dependency Missing"),
-            tr("'mediainfo' command not found. Please install it to retrieve metadata."));
+    // Served from the cache when the track was selected before, else read in the background
+    mediaInfoShowPath = filePath;
+    mediaInfoLoader->request(filePath);
+}
+
+void player::applyMediaInfo(const QVariant& value) {
+    const MediaInfoLoader::Info info = MediaInfoLoader::Info::fromVariant(value);
+    const QString& filePath = info.path;
+    if (!info.error.isEmpty()) {
+        qWarning() << "Cannot read the tags of" << filePath << "-" << info.error;
+        QMessageBox::warning(this, tr("Metadata Error"),
+                             tr("Failed to read the file's metadata.\n%1").arg(info.error));
+        return;
+    }
+    if (!info.hasTags()) {
+        QMessageBox::information(this, tr("No Metadata"),
+                                 tr("The file has no artist, title or genre tags."));
         return;
     }
 
-    QProcess* mediaInfoProcess = new QProcess(this);
-    QStringList args;
-    // Request specific tags for easier parsing, or use --Output=JSON
-    args << "--Inform=General;%Artist%\\n%Title%\\n%Album%\\n%Genre%\\n%Duration/"
-            "String3%\\n%FileSize/String%\\n%Format%\\n%OverallBitRate/String%"
-         << filePath;
-
-    qInfo() << "Getting MediaInfo:" << mediaInfoPath << args;
-
-    connect(
-        mediaInfoProcess, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
-        [this, mediaInfoProcess, filePath](int exitCode, QProcess::ExitStatus exitStatus) {
-            QString output =
-                QString::fromLocal8Bit(mediaInfoProcess->readAllStandardOutput()).trimmed();
-            QString errorOutput =
-                QString::fromLocal8Bit(mediaInfoProcess->readAllStandardError()).trimmed();
-
-            if (exitStatus != QProcess::NormalExit || exitCode != 0) {
-                qWarning() << "mediainfo failed for" << filePath << "Exit:" << exitCode;
-                if (!errorOutput.isEmpty())
-                    qWarning() << "mediainfo STDERR:" << errorOutput;
-                QMessageBox::warning(
-                    this, tr("Metadata Error"),
-                    tr("Failed to get metadata using 'mediainfo'.\n%1").arg(errorOutput));
-            } else {
-                qDebug() << "mediainfo output:\n" << output;
-                // ** TODO: Parse the 'output' string here! **
-                // The original parsing was extremely fragile (fixed indices).
-                // Need to parse based on the requested format or, better, use JSON.
-                // Example (NEEDS PROPER IMPLEMENTATION):
-                QStringList lines = output.split('\n');
-                if (lines.count() >= 8) { // Based on the requested format
-                    QString artist = lines[0];
-                    QString song = lines[1];
-                    QString album = lines[2];
-                    QString genre = lines[3];
-                    QString duration = lines[4];
-                    QString size = lines[5];
-                    QString format = lines[6];
-                    QString bitrate = lines[7];
-
-                    QString msg4box =
-                        tr("Artist: %1\nSong: %2\nAlbum: %3\nGenre: %4\nDuration: %5\nSize: "
-                           "%6\nFormat: %7\nBitrate: %8")
-                            .arg(artist, song, album, genre, duration, size, format, bitrate);
-
-                    QMessageBox::StandardButton rpl =
-                        QMessageBox::question(this, tr("Apply this info to the database?"), msg4box,
-                                              QMessageBox::Yes | QMessageBox::No);
-
-                    if (rpl == QMessageBox::Yes) {
-                        // Update Database (Use Prepared Statements!)
-                        QSqlDatabase db = QSqlDatabase::database("xfb_connection");
-                        QSqlQuery query(db);
-                        query.prepare("UPDATE musics SET artist = :artist, song = :song, genre1 = "
-                                      ":genre, genre2 = :genre " // Assuming genre1/2 same here
-                                      "WHERE path = :path");
-                        query.bindValue(":artist", artist);
-                        query.bindValue(":song", song);
-                        query.bindValue(":genre", genre); // Or more complex genre mapping
-                        query.bindValue(":path", filePath);
-
-                        if (!query.exec()) {
-                            qWarning()
-                                << "Failed to update metadata in DB:" << query.lastError().text();
-                            QMessageBox::warning(this, tr("Database Error"),
-                                                 tr("Failed to update metadata in the database."));
-                        } else {
-                            qInfo() << "Metadata updated in DB for:" << filePath;
-                            update_music_table();
-                        }
-                    }
-                } else {
-                    qWarning() << "Could not parse mediainfo output:" << output;
-                    QMessageBox::warning(
-                        this, tr("Metadata Error"),
-                        tr("Could not parse the metadata received from 'mediainfo'."));
-                }
-            }
-            mediaInfoProcess->deleteLater();
-        });
+    const QString bitrate =
+        info.bitrateKbps > 0 ? tr("%1 kb/s").arg(info.bitrateKbps) : QString();
+    const QString msg4box =
+        tr("Artist: %1\nSong: %2\nAlbum: %3\nGenre: %4\nDuration: %5\nSize: "
+           "%6\nFormat: %7\nBitrate: %8")
+            .arg(info.artist, info.title, info.album, info.genre, info.duration,
+                 QLocale().formattedDataSize(info.size), info.container, bitrate);
 
-    connect(mediaInfoProcess, &QProcess::errorOccurred, this,
-            [this, mediaInfoProcess](QProcess::ProcessError error) {
-                qWarning() << "Failed to start mediainfo. Error:" << error << "-"
-                           << mediaInfoProcess->errorString();
-                QMessageBox::critical(this, tr("Process Error"),
-                                      tr("Could not start the 'mediainfo' process."));
-                mediaInfoProcess->deleteLater();
-            });
+    QMessageBox::StandardButton rpl = QMessageBox::question(
+        this, tr("Apply this info to the database?"), msg4box, QMessageBox::Yes | QMessageBox::No);
+    if (rpl != QMessageBox::Yes) {
+        return;
+    }
 
-    mediaInfoProcess->start(mediaInfoPath, args);
+    // Fields the tags leave empty keep what the database has
+    QSqlDatabase db = QSqlDatabase::database("xfb_connection");
+    QSqlQuery query(db);
+    query.prepare("UPDATE musics SET artist = COALESCE(NULLIF(:artist, ''), artist), "
+                  "song = COALESCE(NULLIF(:song, ''), song), "
+                  "genre1 = COALESCE(NULLIF(:genre, ''), genre1), "
+                  "published_date = COALESCE(NULLIF(:year, ''), published_date), "
+                  "time = COALESCE(NULLIF(:time, ''), time) "
+                  "WHERE path = :path");
+    query.bindValue(":artist", info.artist);
+    query.bindValue(":song", info.title);
+    query.bindValue(":genre", info.genre);
+    query.bindValue(":year", info.year);
+    query.bindValue(":time", info.duration);
+    query.bindValue(":path", filePath);
+
+    if (!query.exec()) {
+        qWarning() << "Failed to update metadata in DB:" << query.lastError().text();
+        QMessageBox::warning(this, tr("Database Error"),
+                             tr("Failed to update metadata in the database."));
+    } else {
+        qInfo() << "Metadata updated in DB for:" << filePath;
+        update_music_table();
+    }
 }
 
 void player::updateConfig() {
-    qDebug() << "Updating player configuration using QSettings...";
+    qCDebug(xfbPlayer) << "Updating player configuration using QSettings...";
 
     // --- Use QSettings with the WRITABLE configuration file path ---
     QString configFileName = "xfb.conf";
@@ -634,7 +1452,7 @@ void player::updateConfig() {
     QString configFilePath = writableConfigPath + "/" + configFileName;
 
     QSettings settings(configFilePath, QSettings::IniFormat);
-    qDebug() << "Reading configuration from:" << settings.fileName();
+    qCDebug(xfbPlayer) << "Reading configuration from:" << settings.fileName();
 
     // --- Read values using settings.value() and assign to member variables ---
 
@@ -649,6 +1467,122 @@ void player::updateConfig() {
     FTPPath = settings.value("FTPPath").toString();
     TakeOverPath = settings.value("TakeOverPath").toString();
     ComHour = settings.value("ComHour", "00:00:00").toString(); // Provide default
+    // The FTP scripts are installed with XFB; ScriptsPath points to others
+    serverScriptsPath = settings.value("ScriptsPath", XFB_SCRIPTS_DIR).toString();
+
+    // Folders kept in sync with the library, and when to rescan them; an
+    // empty LibraryRescanTime turns the nightly rescan off, and LibraryWatch
+    // the adding of tracks as soon as they are dropped in
+    libraryRoots = settings.value("LibraryRoots", QStringList{MusicPath}).toStringList();
+    libraryRescanTime =
+        QTime::fromString(settings.value("LibraryRescanTime", "03:30").toString(), "HH:mm");
+    libraryWatch = settings.value("LibraryWatch", true).toBool();
+
+    // Built-in streaming replaces butt: the mixer's output is encoded and sent
+    // to the local Icecast, one mount per "<mount>=<codec>:<kbps>" entry
+    builtinStream = settings.value("BuiltinStream", false).toBool();
+    streamMounts = settings.value("StreamMounts", "/live.ogg=opus:96").toString();
+    streamPassword = settings.value("StreamPassword", "hackme").toString();
+    // "input" streams the live input, such as a studio mic, rather than the decks
+    streamSource = settings.value("StreamSource", "output").toString();
+    // HLS for web and mobile players, alongside the mounts or on its own: AAC
+    // or Opus segments and a rolling live.m3u8 in HlsTarget, a directory or an
+    // http(s) URL they are PUT under
+    hlsTarget = settings.value("HlsTarget", "").toString().trimmed();
+    hlsCodec = settings.value("HlsCodec", "aac").toString();
+    hlsBitrate = settings.value("HlsBitrate", 128).toInt();
+    hlsSegmentSeconds = settings.value("HlsSegmentSeconds", 6).toInt();
+    // Titles go to Icecast's admin endpoint as each track starts. Icecast only
+    // takes them for MP3 and AAC mounts: by default the built-in stream's MP3
+    // ones, or the comma separated StreamMetadataMounts, such as butt's
+    streamMetadata = settings.value("StreamMetadata", true).toBool();
+    streamMetadataMounts = settings.value("StreamMetadataMounts", "").toString();
+    // A client's TakeOver goes to the server as Opus over UDP, under 200 ms to
+    // air instead of the seconds of the Icecast stream. The server listens on
+    // ContributionPort for the time of the TakeOver, and needs it forwarded
+    contributionEnabled = settings.value("ContributionLink", false).toBool();
+    contributionPort = settings.value("ContributionPort", ContributionLink::DEFAULT_PORT).toInt();
+
+    // Air-check: everything that goes to air, in hourly Opus files with a
+    // daily index of the tracks; AirCheckRetentionDays 0 keeps them all
+    // The queue and the place in the track on air are journaled and resumed after a restart
+    resumeAfterRestart = settings.value("ResumeAfterRestart", true).toBool();
+
+    airCheckEnabled = settings.value("AirCheck", false).toBool();
+    airCheckPath = settings.value("AirCheckPath", SavePath + "/aircheck").toString();
+    airCheckBitrate = settings.value("AirCheckBitrate", 48).toInt();
+    airCheckRetentionDays = settings.value("AirCheckRetentionDays", 0).toInt();
+
+    // Programs in ProgramsPath older than ProgramsKeepDays, beyond the newest
+    // ProgramsKeepCount or the newest ProgramsQuotaGB are removed, with their
+    // rows; all 0, the default, keeps every program
+    programsKeepDays = settings.value("ProgramsKeepDays", 0).toInt();
+    programsKeepCount = settings.value("ProgramsKeepCount", 0).toInt();
+    programsQuotaGb = settings.value("ProgramsQuotaGB", 0).toInt();
+
+    // Dead air: silence on the output or the live input for DeadAirSeconds
+    // raises an alert; DeadAirAction "next" or "recovery" also acts on the output
+    deadAirSeconds = settings.value("DeadAirSeconds", 10).toInt();
+    deadAirThresholdDb = settings.value("DeadAirThresholdDb", -50.0).toDouble();
+    deadAirAction = settings.value("DeadAirAction", "alert").toString();
+
+    // Ducking: while the live input is above DuckThresholdDb the decks go
+    // down by DuckDepthDb, over DuckAttackMs, and back up over DuckReleaseMs
+    duckMusic = settings.value("DuckMusic", false).toBool();
+    duckThresholdDb = settings.value("DuckThresholdDb", -40.0).toDouble();
+    duckDepthDb = settings.value("DuckDepthDb", -12.0).toDouble();
+    duckAttackMs = settings.value("DuckAttackMs", 50).toInt();
+    duckReleaseMs = settings.value("DuckReleaseMs", 800).toInt();
+
+    // Ad breaks: a scheduled pub opens AdBreakSeconds of spots from the pub
+    // table, each customer once per break and not again for AdSeparationMin;
+    // AdMaxDailyPlays caps the plays of a spot, 0 for no limit
+    adBreakSeconds = settings.value("AdBreakSeconds", 0).toInt();
+    adSeparationMin = settings.value("AdSeparationMin", 30).toInt();
+    adMaxDailyPlays = settings.value("AdMaxDailyPlays", 0).toInt();
+
+    // Metrics for Prometheus at http://host:MetricsPort/metrics (JSON at
+    // /metrics.json); 0 keeps the endpoint closed
+    metricsPort = settings.value("MetricsPort", 0).toInt();
+
+    // Remote panels at http://host:RemotePort/api/ and ws://host:RemotePort/api/ws;
+    // without a RemoteToken only this machine may connect
+    remotePort = settings.value("RemotePort", 0).toInt();
+    remoteToken = settings.value("RemoteToken").toString();
+
+    // Local copies of the tracks due next, for libraries on a NAS:
+    // MediaCacheMB of disk, for the files under MediaCachePaths (separated
+    // by ';', all when empty)
+    mediaCacheMb = settings.value("MediaCacheMB", 0).toInt();
+    mediaCachePaths =
+        settings.value("MediaCachePaths").toString().split(';', Qt::SkipEmptyParts);
+
+    // Studios sharing one library: the primary sets LibraryFeed, the others
+    // LibraryPrimary to its remote API and, when the files are mounted
+    // elsewhere, LibraryPathFrom and LibraryPathTo
+    libraryFeed = settings.value("LibraryFeed", false).toBool();
+    libraryPrimary = settings.value("LibraryPrimary").toString();
+    libraryPrimaryToken = settings.value("LibraryPrimaryToken").toString();
+    libraryPathFrom = settings.value("LibraryPathFrom").toString();
+    libraryPathTo = settings.value("LibraryPathTo").toString();
+
+    // Trace spans of the main and worker threads, saved with each dead-air
+    // alarm and served at /trace.json for chrome://tracing or Perfetto
+    Tracer::setEnabled(settings.value("Tracing", false).toBool());
+
+    // A GUI thread that does not answer for StallThresholdMs is logged with
+    // its open spans and stack; 0 turns the watchdog off
+    stallThresholdMs = settings.value("StallThresholdMs", 500).toInt();
+
+    // Dynamic DNS: a provider URL with %IP% where the address goes, called
+    // only when the public IP changes
+    const QString ddnsUpdateUrl = settings.value("DdnsUpdateUrl").toString();
+    networkMaintenance->setUpdateUrl(ddnsUpdateUrl);
+    networkMaintenance->setRefreshInterval(ddnsUpdateUrl.isEmpty() ? 0 : DDNS_REFRESH_MS);
+
+    // The upload script sends everything in FTPPath, so by default one
+    // transfer runs at a time
+    serverTransfers->setMaxConcurrent(settings.value("ServerTransferSlots", 1).toInt());
 
     // Read boolean values directly
     fullScreen = settings.value("FullScreen", false).toBool();
@@ -666,53 +1600,76 @@ void player::updateConfig() {
     recContainer = settings.value("RecContainer", QVariant::fromValue(QMediaFormat::FileFormat()))
                        .value<QMediaFormat::FileFormat>();
 
-    // Database path
+    // Database path; informative only, the database is always databasePath
     txt_selected_db = settings.value("Database").toString();
 
     // Role
     Role = settings.value("Role", "Client").toString(); // Default "Client"
 
+    // Crossfade between on-air tracks, 0 for a gapless splice
+    crossfadeMs = settings.value("Crossfade_Ms", 3000).toInt();
+    prefetchSeconds = settings.value("Prefetch_Seconds", 20).toInt();
+    onAirDevice = settings.value("OnAir_Device").toString();
+    cueDevice = settings.value("Cue_Device").toString();
+    // Native output: fixed ALSA periods instead of Qt's sink, for carts fired on time
+    nativeAudioEnabled = settings.value("Native_Audio", false).toBool();
+    nativeAudioDevice = settings.value("Native_Audio_Device", "default").toString();
+    nativeAudioPeriodFrames =
+        settings.value("Native_Audio_Period_Frames", NativeAudioOutput::DEFAULT_PERIOD_FRAMES)
+            .toInt();
+    nativeAudioPeriods =
+        settings.value("Native_Audio_Periods", NativeAudioOutput::DEFAULT_PERIODS).toInt();
+    rotationSeparation = settings.value("Rotation_Separation", RotationEngine::DEFAULT_SEPARATION).toInt();
+    rotationArtistSeparationMin = settings.value("Rotation_Artist_Separation_Min", 60).toInt();
+    rotationTitleSeparationMin = settings.value("Rotation_Title_Separation_Min", 180).toInt();
+    dayLogArtistSeparationMin = settings.value("DayLog_Artist_Separation_Min", 60).toInt();
+    dayLogTitleSeparationMin = settings.value("DayLog_Title_Separation_Min", 180).toInt();
+
     // --- Apply settings to UI or internal state AFTER reading ALL settings ---
-    qDebug() << "Applying loaded configuration settings...";
+    qCDebug(xfbPlayer) << "Applying loaded configuration settings...";
 
     // Example: Update UI elements based on loaded settings
     if (disableSeekBar) {
         ui->sliderProgress->setEnabled(false);
-        qDebug() << "Disable Seek bar setting: true";
+        qCDebug(xfbPlayer) << "Disable Seek bar setting: true";
     } else {
         ui->sliderProgress->setEnabled(true);
-        qDebug() << "Disable Seek bar setting: false";
+        qCDebug(xfbPlayer) << "Disable Seek bar setting: false";
     }
 
     if (Disable_Volume) {
         ui->sliderVolume->setEnabled(false);
-        qDebug() << "Disable Volume setting: true";
+        qCDebug(xfbPlayer) << "Disable Volume setting: true";
     } else {
         ui->sliderVolume->setEnabled(true);
-        qDebug() << "Disable Volume setting: false";
+        qCDebug(xfbPlayer) << "Disable Volume setting: false";
     }
 
     // Log other settings
-    qDebug() << "Normalization Soft setting:" << normalization_soft;
-    qDebug() << "Role setting:" << Role;
+    qCDebug(xfbPlayer) << "Normalization Soft setting:" << normalization_soft;
+    qCDebug(xfbPlayer) << "Crossfade setting (ms):" << crossfadeMs;
+    // Only the subsystems whose settings changed are set up again
+    if (configReloader)
+        configReloader->reload(settings);
+    qCDebug(xfbPlayer) << "Role setting:" << Role;
     if (Role == "Server") {
-        qDebug("XFB Role: Server mode actions can be taken now.");
+        qCDebug(xfbPlayer, "XFB Role: Server mode actions can be taken now.");
         // Add any specific logic needed when running as server
     } else {
-        qDebug("XFB Role: Client mode actions can be taken now.");
+        qCDebug(xfbPlayer, "XFB Role: Client mode actions can be taken now.");
         // Add any specific logic needed when running as client
     }
-    qDebug() << "DarkMode setting:" << darkMode;
+    qCDebug(xfbPlayer) << "DarkMode setting:" << darkMode;
     // Note: Applying dark mode often requires more than just setting the variable.
     // It usually involves reapplying palettes/stylesheets, potentially restarting parts of the UI.
     // Consider how dark mode changes are triggered and applied application-wide.
 
     // Log paths etc.
-    qDebug() << "SavePath:" << SavePath;
-    qDebug() << "ProgramsPath:" << ProgramsPath;
+    qCDebug(xfbPlayer) << "SavePath:" << SavePath;
+    qCDebug(xfbPlayer) << "ProgramsPath:" << ProgramsPath;
     // ... log other variables as needed ...
 
-    qDebug() << "Finished updating player configuration.";
+    qCDebug(xfbPlayer) << "Finished updating player configuration.";
 }
 
 void player::showTime() {
@@ -725,210 +1682,65 @@ void player::showTime() {
 }
 
 bool player::checkDbOpen() {
-    QSqlDatabase db = QSqlDatabase::database("xfb_connection");
-    QString resourceDbPath = ":/adb.db";
-    QString appDataPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
-    if (appDataPath.isEmpty()) {
-        qWarning() << "Could not determine writable application data location.";
+    // Opened once at startup and kept answering by checkDatabaseHealth(), so
+    // handlers only pay for a flag check
+    return adb.isOpen() || openDatabase();
+}
+
+bool player::openDatabase() {
+    const QString connectionName = "xfb_connection";
+    QString error;
+    if (databaseProvisioningPending) {
+        databaseProvisioningPending = false;
+        error = databaseProvisioning.result();
+    } else if (!QFileInfo::exists(databasePath)) {
+        DatabaseService::provisionDatabaseFile(":/adb.db", databasePath, &error);
+    }
+    if (!error.isEmpty()) {
+        qCritical() << "Database setup failed:" << error;
         return false;
     }
 
-    QString appDirName =
-        QCoreApplication::applicationName(); // Or your specific app identifier "XFB"
-    if (appDirName.isEmpty()) {
-        appDirName = "XFB"; // Fallback if not set via QCoreApplication
-        qWarning() << "QCoreApplication::applicationName() is empty, using fallback:" << appDirName;
-    }
-    QString specificAppDataPath = appDataPath + "/" + appDirName;
-    QString persistentDbPath =
-        specificAppDataPath + "/adb.db";             // Target path using app-specific subfolder
-    const QString connectionName = "xfb_connection"; // Use a distinct connection name
-
-    // --- Ensure Application Data Sub-Directory Exists ---
-    QDir dir(specificAppDataPath); // Use the specific path
-    if (!dir.exists()) {
-        qInfo() << "Creating application data directory:" << specificAppDataPath;
-        if (!dir.mkpath(".")) { // mkpath creates parent directories if needed
-            qWarning() << "Failed to create application data directory:" << specificAppDataPath;
-            return false;
+    adb = DatabaseService::openNamedConnection(connectionName, databasePath, &error);
+    if (!adb.isOpen()) {
+        qCritical() << "Database Error: Failed to open" << databasePath << ":" << error;
+        if (error.contains("unable to open", Qt::CaseInsensitive)) {
+            qCritical() << ">>> Error indicates file access problem. Verify permissions and "
+                           "path again.";
         }
-    }
-
-    // --- Check and Copy Database File ---
-    QFile persistentFile(persistentDbPath);
-    QFileInfo resourceInfo(resourceDbPath);
-
-    if (!resourceInfo.exists()) {
-        qCritical() << "CRITICAL: Database resource file not found:" << resourceDbPath;
-        qCritical() << "Make sure adb.db is added to your .qrc file and the .qrc is in RESOURCES "
-                       "in your .pro file.";
         return false;
     }
 
-    bool copyRequired = !persistentFile.exists();
-    if (persistentFile.exists() &&
-        resourceInfo.lastModified() > QFileInfo(persistentFile).lastModified()) {
-        qInfo() << "Resource database is newer. Removing old persistent copy.";
-        if (!persistentFile.remove()) {
-            qWarning() << "Could not remove existing persistent database file:"
-                       << persistentFile.errorString()
-                       << "- Check if it's locked by another process.";
-            // Decide if you want to proceed or fail here. Maybe try opening anyway?
-        }
-        copyRequired = true;
-    }
-
-    if (copyRequired) {
-        qInfo() << "Attempting to copy database from resource to:" << persistentDbPath;
-        if (!QFile::copy(resourceDbPath, persistentDbPath)) {
-            QFile resFile(resourceDbPath); // For error checking
-            qCritical() << "Failed to copy database from resource (" << resourceDbPath
-                        << ", exists:" << resFile.exists() << ") to" << persistentDbPath
-                        << "- Error:" << persistentFile.errorString()
-                        << "(Check write permissions for " << specificAppDataPath << ")";
-            return false;
-        } else {
-            // Explicitly set permissions after successful copy
-            if (!persistentFile.setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner |
-                                               QFileDevice::ReadGroup | QFileDevice::ReadOther)) {
-                qWarning() << "Could not set permissions on the copied database file:"
-                           << persistentDbPath << "Error:" << persistentFile.errorString();
-            } else {
-                qInfo() << "Database copied successfully and permissions set for"
-                        << persistentDbPath;
-            }
-        }
-    }
+    qInfo() << "Database connection" << connectionName << "opened:" << databasePath;
+    return true;
+}
 
-    // --- Verify Readability Before Connecting ---
-    // Re-instantiate QFile object to ensure fresh state check
-    QFile checkFile(persistentDbPath);
-    if (!checkFile.exists()) {
-        qCritical() << "Database file disappeared after check/copy? Path:" << persistentDbPath;
-        return false;
-    }
-    if (!checkFile.permissions().testFlag(
-            QFileDevice::ReadOwner)) { // Check owner read permission specifically
-        qWarning() << "Persistent database file lacks read permission for owner:"
-                   << persistentDbPath;
-        qWarning() << "Attempting to grant read permission...";
-        if (!checkFile.setPermissions(checkFile.permissions() | QFileDevice::ReadOwner |
-                                      QFileDevice::WriteOwner)) {
-            qCritical() << "Failed to grant read/write permission to database file:"
-                        << persistentDbPath << "Error:" << checkFile.errorString();
-            qCritical() << "Manual permission change might be required. Check user/group ownership "
-                           "and permissions.";
-            return false; // Fail if we can't ensure readability
-        } else {
-            qInfo() << "Read/Write permission granted successfully.";
-        }
-    }
+void player::checkDatabaseHealth() {
+    if (DatabaseService::pingConnection(adb))
+        return;
+    qCWarning(xfbPlayer) << "The database connection stopped answering, reopening it";
+    adb.close();
+    if (!openDatabase())
+        qCCritical(xfbPlayer) << "Could not reopen the database, retrying in"
+                              << DB_HEALTH_CHECK_MS / 1000 << "seconds";
+}
 
-    // --- Setup the QSqlDatabase connection ---
-    if (QSqlDatabase::contains(connectionName)) {
-        // Even if reusing, check if it's actually usable / still open correctly
-        if (db.isOpen() && !db.databaseName().isEmpty()) {
-            // Optional: Ping the database to be sure it's responsive
-            QSqlQuery pingQuery(db);
-            if (!pingQuery.exec("SELECT 1")) { // Simple query
-                qWarning() << "Ping query failed on existing open connection. Error:"
-                           << pingQuery.lastError().text();
-                qWarning() << "Connection state might be stale. Closing it.";
-                adb.close(); // Close the potentially stale connection
-            } else {
-                qDebug() << "Existing connection ping successful.";
-            }
-        } else {
-            qDebug() << "Existing connection handle was found but not open or configured. Will "
-                        "proceed to open.";
-        }
+void player::on_actionOpen_triggered() {
+    qCDebug(xfbPlayer) << "File -> Open file";
 
-    } else {
-        adb = QSqlDatabase::addDatabase("QSQLITE", connectionName);
-        qDebug() << "Adding new database connection:" << connectionName;
-        if (!adb.isValid()) {
-            qCritical()
-                << "Failed to add database connection. QSQLITE driver possibly missing or invalid.";
-            qCritical() << "Available drivers:" << QSqlDatabase::drivers();
-            return false;
-        }
-    }
+    QFileDialog dialog(this);
+    dialog.setFileMode(QFileDialog::ExistingFiles);
+    dialog.setNameFilter(tr("Audio Files (*.ogg *.mp3 *.flac *.wav)"));
+    dialog.setViewMode(QFileDialog::Detail);
+    QStringList fileNames;
+    if (dialog.exec()) {
+        fileNames = dialog.selectedFiles();
+        playlistQueue->append(fileNames);
 
-    // Set the database file path *after* getting a valid handle
-    // This is important even for existing connections if they were closed or became invalid
-    if (adb.databaseName() != persistentDbPath) {
-        qDebug() << "Setting database name for connection" << connectionName << "to"
-                 << persistentDbPath;
-        adb.setDatabaseName(persistentDbPath);
+        // The files will be played when the current track finishes, or when
+        // the user clicks Play; we don't auto-start playback here
     }
-
-    // Only try to open if it's not already open (or if we closed it above)
-    if (!adb.isOpen()) {
-        qInfo() << "Attempting to open database connection:" << connectionName
-                << " Path:" << adb.databaseName();
-        if (!adb.open()) {
-            qCritical() << "Database Error: Failed to open database:" << adb.lastError().text();
-            qCritical() << "Database path was:" << adb.databaseName();
-            qCritical() << "Underlying driver error:" << adb.lastError().driverText();
-            qCritical() << "Available drivers:" << QSqlDatabase::drivers();
-            if (adb.lastError().text().contains("Driver not loaded")) {
-                qCritical() << ">>> Potential deployment issue: Ensure the QSQLITE plugin is "
-                               "deployed correctly.";
-            }
-            // Specifically check for file permission related errors if possible
-            if (adb.lastError().text().contains("unable to open", Qt::CaseInsensitive)) {
-                qCritical() << ">>> Error indicates file access problem. Verify permissions and "
-                               "path again.";
-                qCritical() << ">>> Path:" << persistentDbPath
-                            << " Exists:" << QFile::exists(persistentDbPath)
-                            << " Readable:" << QFile(persistentDbPath).isReadable();
-            }
-            return false;
-        } else {
-            qInfo() << "Database connection opened successfully:" << adb.connectionName()
-                    << " Path:" << adb.databaseName();
-        }
-    } else {
-        qDebug() << "Database connection" << connectionName << "was already open and seems valid.";
-    }
-
-    // Final check
-    if (!adb.isOpen()) {
-        qCritical()
-            << "Database connection is unexpectedly not open after initialization sequence.";
-        return false;
-    }
-
-    qInfo() << "Database initialization successful. Connection '" << connectionName << "' is open.";
-    return true;
-}
-
-void player::on_actionOpen_triggered() {
-    qDebug() << "File -> Open file";
-
-    QFileDialog dialog(this);
-    dialog.setFileMode(QFileDialog::ExistingFiles);
-    dialog.setNameFilter(tr("Audio Files (*.ogg *.mp3 *.flac *.wav)"));
-    dialog.setViewMode(QFileDialog::Detail);
-    QStringList fileNames;
-    if (dialog.exec()) {
-        fileNames = dialog.selectedFiles();
-        ui->playlist->addItems(fileNames);
-
-        // If we're currently playing, we don't need to do anything else
-        // The files will be played when the current track finishes
-        // If we're not playing, we could start playing the first file
-        if (PlayMode == "stopped" && !fileNames.isEmpty()) {
-            // Add the first file to the playlist and play it
-            XplaylistUrls.clear();
-            XplaylistUrls.append(QUrl::fromLocalFile(fileNames.first()));
-            XplaylistIndex = 0;
-
-            // This will trigger playback if the user clicks Play
-            // We don't auto-start playback here to maintain the original behavior
-        }
-    }
-}
+}
 
 void ::player::playlistContextMenu(const QPoint& pos) {
     QPoint globalPos = ui->playlist->mapToGlobal(pos);
@@ -936,29 +1748,33 @@ void ::player::playlistContextMenu(const QPoint& pos) {
     QString remove = tr("Remove this track from the playlist");
     QString moveToTop = tr("Send this track to the top of the playlist");
     QString moveToBottom = tr("Send this track to the bottom of the playlist");
+    QString preListen = tr("Pre-listen on the cue output");
+    QString stopPreListen = tr("Stop pre-listening");
 
     thisMenu.addAction(remove);
     thisMenu.addAction(moveToTop);
     thisMenu.addAction(moveToBottom);
+    thisMenu.addSeparator();
+    thisMenu.addAction(preListen);
+    if (playbackEngine->isCueing())
+        thisMenu.addAction(stopPreListen);
 
     QAction* selectedItem = thisMenu.exec(globalPos);
     if (selectedItem) {
         QString selectedListItem = selectedItem->text();
         int rowidx = ui->playlist->selectionModel()->currentIndex().row();
-        estevalor = ui->playlist->model()->data(ui->playlist->model()->index(rowidx, 0)).toString();
+        estevalor = playlistQueue->path(rowidx);
 
-        if (selectedListItem == remove) {
-            delete ui->playlist->item(rowidx);
-            calculate_playlist_total_time();
-        }
-        if (selectedListItem == moveToTop) {
-            delete ui->playlist->item(rowidx);
-            ui->playlist->insertItem(0, estevalor);
-        }
-        if (selectedListItem == moveToBottom) {
-            delete ui->playlist->item(rowidx);
-            ui->playlist->addItem(estevalor);
-        }
+        if (selectedListItem == remove)
+            playlistQueue->removeAt(rowidx);
+        if (selectedListItem == moveToTop)
+            playlistQueue->move(rowidx, 0);
+        if (selectedListItem == moveToBottom)
+            playlistQueue->move(rowidx, playlistQueue->count() - 1);
+        if (selectedListItem == preListen && !estevalor.isEmpty())
+            playbackEngine->cue(estevalor);
+        if (selectedListItem == stopPreListen)
+            playbackEngine->stopCue();
     }
 }
 
@@ -997,13 +1813,11 @@ void player::musicViewContextMenu(const QPoint& pos) {
     QString selectedActionText = selectedItem->text();
 
     if (selectedActionText == actionAddToBottom) {
-        qDebug() << "Adding to bottom of playlist:" << selectedFilePath;
-        ui->playlist->addItem(selectedFilePath);
-        calculate_playlist_total_time();
+        qCDebug(xfbPlayer) << "Adding to bottom of playlist:" << selectedFilePath;
+        playlistQueue->append(selectedFilePath);
     } else if (selectedActionText == actionAddToTop) {
-        qDebug() << "Adding to top of playlist:" << selectedFilePath;
-        ui->playlist->insertItem(0, selectedFilePath);
-        calculate_playlist_total_time();
+        qCDebug(xfbPlayer) << "Adding to top of playlist:" << selectedFilePath;
+        playlistQueue->prepend(selectedFilePath);
     } else if (selectedActionText == actionDeleteFromDB) {
         QMessageBox::StandardButton go = QMessageBox::question(
             this, tr("Confirm Deletion"),
@@ -1078,11 +1892,17 @@ void player::musicViewContextMenu(const QPoint& pos) {
 void player::jinglesViewContextMenu(const QPoint& pos) {
     QPoint globalPos = ui->jinglesView->mapToGlobal(pos);
     QMenu thisMenu;
+    const QString actionPlayNow = tr("Play now over the music");
     const QString actionAddToBottom = tr("Add to the bottom of playlist");
     const QString actionAddToTop = tr("Add to the top of the playlist");
     const QString actionDeleteFromDB = tr("Delete this jingle from the database");
     const QString actionOpenAudacity = tr("Open this in Audacity");
 
+    const QModelIndex pressed = ui->jinglesView->indexAt(pos);
+    const QString pressedPath =
+        pressed.isValid() ? jinglesModel->index(pressed.row(), 1).data().toString() : QString();
+    thisMenu.addAction(actionPlayNow)->setEnabled(cartWall->slotOf(pressedPath) >= 0);
+    thisMenu.addSeparator();
     thisMenu.addAction(actionAddToBottom);
     thisMenu.addAction(actionAddToTop);
     thisMenu.addSeparator();
@@ -1106,12 +1926,12 @@ void player::jinglesViewContextMenu(const QPoint& pos) {
 
     QString selectedActionText = selectedItem->text();
 
-    if (selectedActionText == actionAddToBottom) {
-        ui->playlist->addItem(selectedFilePath);
-        calculate_playlist_total_time();
+    if (selectedActionText == actionPlayNow) {
+        fireCart(selectedFilePath);
+    } else if (selectedActionText == actionAddToBottom) {
+        playlistQueue->append(selectedFilePath);
     } else if (selectedActionText == actionAddToTop) {
-        ui->playlist->insertItem(0, selectedFilePath);
-        calculate_playlist_total_time();
+        playlistQueue->prepend(selectedFilePath);
     } else if (selectedActionText == actionDeleteFromDB) {
         QMessageBox::StandardButton go =
             QMessageBox::question(this, tr("Confirm Deletion"),
@@ -1163,12 +1983,12 @@ void ::player::pubViewContextMenu(const QPoint& pos) {
         estevalor = ui->pubView->model()->data(ui->pubView->model()->index(rowidx, 2)).toString();
 
         if (selectedMenuItem == addToBottomOfPlaylist) {
-            qDebug() << "Launch add this to bottom of playlist";
-            ui->playlist->addItem(estevalor);
+            qCDebug(xfbPlayer) << "Launch add this to bottom of playlist";
+            playlistQueue->append(estevalor);
         }
         if (selectedMenuItem == addtoTopOfPlaylist) {
-            qDebug() << "Launch add this to top of playlist";
-            ui->playlist->insertItem(0, estevalor);
+            qCDebug(xfbPlayer) << "Launch add this to top of playlist";
+            playlistQueue->prepend(estevalor);
         }
         if (selectedMenuItem == deleteThisFromDB) {
             QMessageBox::StandardButton go;
@@ -1187,7 +2007,7 @@ void ::player::pubViewContextMenu(const QPoint& pos) {
                     update_music_table();
                 } else {
                     QMessageBox::critical(this, tr("Error"), sql.lastError().text());
-                    qDebug() << "last sql: " << sql.lastQuery();
+                    qCDebug(xfbPlayer) << "last sql: " << sql.lastQuery();
                 }
             }
         }
@@ -1199,16 +2019,11 @@ void ::player::pubViewContextMenu(const QPoint& pos) {
         }
     }
 }
-// Helper function to run a server script asynchronously
-void player::runServerCheckScript(const QString& scriptName, const QString& fileToCheck,
-                                  const QString& successMessage, const QString& failureMessage) {
-    // TODO: Replace this with a robust way to find the script
-    QString scriptBaseName = scriptName; // e.g., "serverFtpCmdsCHKProgram.sh"
-    QString scriptDir =
-        QCoreApplication::applicationDirPath() + "/usr/share/xfb/scripts"; // Example path
-    QString scriptPath = QDir(scriptDir).filePath(scriptBaseName);
-
-    qInfo() << "Attempting to execute check script:" << scriptPath << "for file:" << fileToCheck;
+// Helper function to check the server for a program, through the presence cache
+void player::runServerCheckScript(const QString& fileToCheck, const QString& successMessage,
+                                  const QString& failureMessage) {
+    const QString scriptPath = serverPresence->listingJob().program;
+    qInfo() << "Queueing check script:" << scriptPath << "for file:" << fileToCheck;
 
     if (!QFileInfo::exists(scriptPath)) {
         qWarning() << "Check script not found at:" << scriptPath;
@@ -1218,83 +2033,63 @@ void player::runServerCheckScript(const QString& scriptName, const QString& file
         return;
     }
 
-    QProgressDialog progress(tr("Checking server..."), tr("Cancel"), 0, 0, this);
-    progress.setWindowModality(Qt::WindowModal);
-    progress.show();
-    qApp->processEvents();
-
-    QProcess* checkProcess = new QProcess(this);
-    QStringList args;
-    // Pass filename as argument instead of relying on grep? Modify script if possible.
-    // For now, mimic original grep:
-    // args << "| grep" << fileToCheck; // NO! Don't pipe in C++ QProcess args
-
-    connect(checkProcess, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
-            [this, checkProcess, fileToCheck, successMessage, failureMessage,
-             &progress](int exitCode, QProcess::ExitStatus exitStatus) {
-                progress.cancel(); // Close progress dialog
-                QString stdOutput =
-                    QString::fromLocal8Bit(checkProcess->readAllStandardOutput()).trimmed();
-                QString stdError =
-                    QString::fromLocal8Bit(checkProcess->readAllStandardError()).trimmed();
-                bool found = false;
-
-                if (exitStatus == QProcess::NormalExit && exitCode == 0) {
-                    qDebug() << "Check script STDOUT:\n" << stdOutput;
-                    // Check if the output contains the filename we are looking for
-                    if (stdOutput.contains(fileToCheck, Qt::CaseInsensitive)) {
-                        found = true;
-                    } else {
-                        if (!stdError.isEmpty())
-                            qWarning() << "Check script STDERR (exit 0):\n" << stdError;
-                    }
-                } else {
-                    qWarning() << "Check script failed or exited with error. ExitCode:" << exitCode;
-                    if (!stdError.isEmpty())
-                        qWarning() << "Check script STDERR:\n" << stdError;
-                }
-
-                if (found) {
-                    QMessageBox::information(this, tr("Check Successful"),
-                                             successMessage + "\n\nServer Output:\n" +
-                                                 stdOutput.left(300));
-                } else {
-                    QMessageBox::critical(this, tr("Check Failed"), failureMessage);
-                }
+    // The script lists the whole server folder, so checks that are queued
+    // together share one listing. A listing without the file is an answer,
+    // not a failure; only a script that fails is retried.
+    serverPresence->refresh(fileToCheck, [this, successMessage, failureMessage](
+                                             ServerPresenceCache::Presence presence,
+                                             const TransferQueue::Result& result) {
+        if (result.ok) {
+            qCDebug(xfbPlayer) << "Check script STDOUT:\n" << result.output;
+            if (presence != ServerPresenceCache::Presence::Present && !result.errorOutput.isEmpty())
+                qWarning() << "Check script STDERR (exit 0):\n" << result.errorOutput;
+        } else {
+            qWarning() << "Check script failed after" << result.attempts << "attempts:" << result.error;
+            if (!result.errorOutput.isEmpty())
+                qWarning() << "Check script STDERR:\n" << result.errorOutput;
+        }
 
-                checkProcess->deleteLater();
-            });
+        if (presence == ServerPresenceCache::Presence::Present) {
+            QMessageBox::information(this, tr("Check Successful"),
+                                     successMessage + "\n\nServer Output:\n" +
+                                         result.output.left(300));
+        } else {
+            QMessageBox::critical(this, tr("Check Failed"), failureMessage);
+        }
+    });
+}
 
-    connect(checkProcess, &QProcess::errorOccurred, this,
-            [this, checkProcess, scriptPath, &progress](QProcess::ProcessError error) {
-                qWarning() << "Failed to start check script (" << scriptPath << "). Error:" << error
-                           << "-" << checkProcess->errorString();
-                progress.cancel();
-                QMessageBox::critical(this, "Script Error",
-                                      QString("Could not start the check script:\n%1\n\nError: %2")
-                                          .arg(scriptPath)
-                                          .arg(checkProcess->errorString()));
-                checkProcess->deleteLater();
-            });
+QString player::serverPresenceText(const QString& fileName) {
+    if (fileName.isEmpty())
+        return tr("Server status: no program selected");
 
-    // Start the script - How to handle the grep part robustly?
-    // Option 1 (Best): Modify script to take filename as arg and return exit code 0 if found.
-    // checkProcess->start(scriptPath, QStringList() << fileToCheck); // If script modified
-    // Option 2 (Current): Run script and check output in C++.
-    checkProcess->start(scriptPath); // Run script, check full output in finished signal
+    // Only what is cached is shown; an old or missing answer is refreshed in the background
+    const bool checking = QFileInfo::exists(serverPresence->listingJob().program) &&
+                          serverPresence->refreshIfStale(fileName);
+    const ServerPresenceCache::Status status = serverPresence->status(fileName);
+    const QString checked = status.checked.toString("hh:mm");
+    switch (status.presence) {
+    case ServerPresenceCache::Presence::Present:
+        return tr("Server status: on the server (checked %1)").arg(checked);
+    case ServerPresenceCache::Presence::Missing:
+        return tr("Server status: NOT on the server (checked %1)").arg(checked);
+    case ServerPresenceCache::Presence::Unknown:
+        break;
+    }
+    return checking ? tr("Server status: checking...") : tr("Server status: unknown");
+}
+QString player::serverScriptPath(const QString& scriptName) const {
+    return QDir(serverScriptsPath).filePath(scriptName);
 }
-// Helper function to run upload/put script asynchronously
+
+// Helper function to queue an upload/put script
 void player::runServerUploadScript(const QString& scriptName, const QString& fileToUpload,
                                    const QString& successMessage, const QString& failureMessage,
                                    std::function<void(bool)> callback) {
-    // TODO: Replace this with a robust way to find the script
-    QString scriptBaseName = scriptName; // e.g., "serverFtpCmdsPutProgram.sh"
-    QString scriptDir =
-        QCoreApplication::applicationDirPath() + "/usr/share/xfb/scripts"; // Example path
-    QString scriptPath = QDir(scriptDir).filePath(scriptBaseName);
+    const QString scriptPath = serverScriptPath(scriptName); // e.g., "serverFtpCmdsPutProgram.sh"
 
-    qInfo() << "Attempting to execute upload script:" << scriptPath << "for file:" << fileToUpload;
-    qDebug() << "Dependencies: Script must exist, be executable, ~/.netrc configured.";
+    qInfo() << "Queueing upload script:" << scriptPath << "for file:" << fileToUpload;
+    qCDebug(xfbPlayer) << "Dependencies: Script must exist, be executable, ~/.netrc configured.";
 
     if (!QFileInfo::exists(scriptPath)) {
         qWarning() << "Upload script not found at:" << scriptPath;
@@ -1305,76 +2100,39 @@ void player::runServerUploadScript(const QString& scriptName, const QString& fil
         return;
     }
 
-    QProgressDialog progress(tr("Uploading to server..."), tr("Cancel"), 0, 0, this);
-    progress.setWindowModality(Qt::WindowModal);
-    progress.show();
-    qApp->processEvents();
-
-    QProcess* uploadProcess = new QProcess(this);
-    // Does the script need the filename as argument? Assume not for now based on original.
-
-    connect(uploadProcess, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
-            [this, uploadProcess, successMessage, failureMessage, &progress,
-             callback](int exitCode, QProcess::ExitStatus exitStatus) {
-                progress.cancel();
-                QString stdOutput =
-                    QString::fromLocal8Bit(uploadProcess->readAllStandardOutput()).trimmed();
-                QString stdError =
-                    QString::fromLocal8Bit(uploadProcess->readAllStandardError()).trimmed();
-                bool success = false;
-
-                if (exitStatus == QProcess::NormalExit && exitCode == 0) {
-                    qDebug() << "Upload script STDOUT:\n" << stdOutput;
-                    if (stdOutput.contains("Transfer complete", Qt::CaseInsensitive)) {
-                        qInfo() << "Upload script reported success.";
-                        success = true;
-                    } else {
-                        qWarning() << "Upload script finished (exit 0) but success message not "
-                                      "found in output.";
-                        if (!stdError.isEmpty())
-                            qWarning() << "Upload script STDERR:\n" << stdError;
-                    }
-                } else {
-                    qWarning() << "Upload script failed or exited with error. ExitCode:"
-                               << exitCode;
-                    if (!stdError.isEmpty())
-                        qWarning() << "Upload script STDERR:\n" << stdError;
-                    else if (!stdOutput.isEmpty())
-                        qWarning() << "Upload script STDOUT (check errors):\n" << stdOutput;
-                }
+    // An upload that ends without ftp's "Transfer complete" is sent again
+    TransferQueue::Job job;
+    job.key = "upload:" + fileToUpload;
+    job.description = tr("Uploading %1").arg(QFileInfo(fileToUpload).fileName());
+    job.program = scriptPath;
+    job.validate = [](const TransferQueue::Result& result) {
+        return result.output.contains("Transfer complete", Qt::CaseInsensitive);
+    };
 
-                if (success) {
-                    QMessageBox::information(this, tr("Upload Successful"), successMessage);
-                    callback(true); // Indicate success
-                } else {
-                    QMessageBox::critical(
-                        this, "Upload Failed",
-                        failureMessage +
-                            tr("\nCheck ~/.netrc, script, network, server status.\nOutput:\n%1\n%2")
-                                .arg(stdOutput.left(200))
-                                .arg(stdError.left(200)));
-                    callback(false); // Indicate failure
-                }
-                uploadProcess->deleteLater();
-            });
+    serverTransfers->enqueue(job, [this, successMessage, failureMessage,
+                                   callback](const TransferQueue::Result& result) {
+        if (result.ok) {
+            qCDebug(xfbPlayer) << "Upload script STDOUT:\n" << result.output;
+            qInfo() << "Upload script reported success.";
+            QMessageBox::information(this, tr("Upload Successful"), successMessage);
+            callback(true); // Indicate success
+            return;
+        }
 
-    connect(uploadProcess, &QProcess::errorOccurred, this,
-            [this, uploadProcess, scriptPath, failureMessage, &progress,
-             callback](QProcess::ProcessError error) {
-                qWarning() << "Failed to start upload script (" << scriptPath
-                           << "). Error:" << error << "-" << uploadProcess->errorString();
-                progress.cancel();
-                QMessageBox::critical(this, "Script Error",
-                                      QString("Could not start the upload script:\n%1\n\nError: %2")
-                                              .arg(scriptPath)
-                                              .arg(uploadProcess->errorString()) +
-                                          "\n" + failureMessage);
-                callback(false); // Indicate failure
-                uploadProcess->deleteLater();
-            });
+        qWarning() << "Upload script failed after" << result.attempts << "attempts:" << result.error;
+        if (!result.errorOutput.isEmpty())
+            qWarning() << "Upload script STDERR:\n" << result.errorOutput;
+        else if (!result.output.isEmpty())
+            qWarning() << "Upload script STDOUT (check errors):\n" << result.output;
 
-    // Start the script
-    uploadProcess->start(scriptPath);
+        QMessageBox::critical(
+            this, "Upload Failed",
+            failureMessage +
+                tr("\nCheck ~/.netrc, script, network, server status.\nOutput:\n%1\n%2")
+                    .arg(result.output.left(200))
+                    .arg(result.errorOutput.left(200)));
+        callback(false); // Indicate failure
+    });
 }
 
 void player::programsViewContextMenu(const QPoint& pos) {
@@ -1394,6 +2152,12 @@ void player::programsViewContextMenu(const QPoint& pos) {
     thisMenu.addSeparator();
     thisMenu.addAction(actionOpenAudacity);
     thisMenu.addSeparator();
+    const QModelIndex pressed = ui->programsView->indexAt(pos);
+    const QString pressedName =
+        pressed.isValid()
+            ? QFileInfo(programsModel->index(pressed.row(), 2).data().toString()).fileName()
+            : QString();
+    thisMenu.addAction(serverPresenceText(pressedName))->setEnabled(false);
     thisMenu.addAction(actionCheckSent);
     thisMenu.addAction(actionResendToServer);
 
@@ -1417,11 +2181,9 @@ void player::programsViewContextMenu(const QPoint& pos) {
     QString selectedActionText = selectedItem->text();
 
     if (selectedActionText == actionAddToBottom) {
-        ui->playlist->addItem(selectedFilePath);
-        calculate_playlist_total_time();
+        playlistQueue->append(selectedFilePath);
     } else if (selectedActionText == actionAddToTop) {
-        ui->playlist->insertItem(0, selectedFilePath);
-        calculate_playlist_total_time();
+        playlistQueue->prepend(selectedFilePath);
     } else if (selectedActionText == actionDeleteFromDB) {
         QMessageBox::StandardButton go =
             QMessageBox::question(this, tr("Confirm Deletion"),
@@ -1450,15 +2212,20 @@ void player::programsViewContextMenu(const QPoint& pos) {
         launchExternalApplication("audacity", selectedFilePath);
     } else if (selectedActionText == actionCheckSent) {
         runServerCheckScript(
-            "serverFtpCmdsCHKProgram.sh", selectedFileName,
+            selectedFileName,
             tr("The program '%1' is present on the server!").arg(selectedFileName),
             tr("The program '%1' was NOT found on the server.").arg(selectedFileName));
     } else if (selectedActionText == actionResendToServer) {
         qInfo() << "(Re)Sending program to server:" << selectedFilePath;
-        ui->txt_uploadingPrograms->show(); // Show indicator
 
         // 1. Copy file to temporary FTP location (FTPPath)
         QString ftpTempPath = QDir(FTPPath).filePath(selectedFileName);
+        if (serverTransfers->contains("upload:" + ftpTempPath)) {
+            // Copying it again would change the file under the running upload
+            qInfo() << "Program is already queued for upload:" << selectedFileName;
+            return;
+        }
+        ui->txt_uploadingPrograms->show(); // Show indicator
         qInfo() << "Copying" << selectedFilePath << "to" << ftpTempPath;
         QFile::remove(ftpTempPath); // Remove existing temp file first
         if (!QFile::copy(selectedFilePath, ftpTempPath)) {
@@ -1476,65 +2243,49 @@ void player::programsViewContextMenu(const QPoint& pos) {
                               tr("Program '%1' uploaded successfully.").arg(selectedFileName),
                               tr("Failed to upload program '%1'.").arg(selectedFileName),
                               // Callback function after upload attempt:
-                              [this, ftpTempPath](bool uploadSuccess) {
+                              [this, ftpTempPath, selectedFileName](bool uploadSuccess) {
+                                  if (uploadSuccess)
+                                      serverPresence->record(
+                                          selectedFileName,
+                                          ServerPresenceCache::Presence::Present);
                                   // 3. Clean up temporary file
                                   qInfo() << "Cleaning up temporary FTP file:" << ftpTempPath;
                                   if (QFile::remove(ftpTempPath)) {
-                                      qDebug() << "Removed temporary FTP file:" << ftpTempPath;
+                                      qCDebug(xfbPlayer) << "Removed temporary FTP file:"
+                                                         << ftpTempPath;
                                   } else {
                                       qWarning()
                                           << "Failed to remove temporary FTP file:" << ftpTempPath;
                                   }
-                                  ui->txt_uploadingPrograms->hide(); // Hide indicator
-                                  // No further action needed here based on original code after
-                                  // upload attempt
+                                  // Other uploads may still be queued
+                                  if (serverTransfers->pendingCount() == 0)
+                                      ui->txt_uploadingPrograms->hide(); // Hide indicator
                               });
     }
 }
 
-// Helper to get duration using exiftool (async)
+// Helper to get duration using the in-process media probe, or exiftool for what it cannot read
 void player::getDurationForFile(const QString& filePath,
                                 std::function<void(const QString&, const QString&)> callback) {
-    QString exiftoolPath = QStandardPaths::findExecutable("exiftool");
-    if (exiftoolPath.isEmpty()) {
-        qWarning() << "exiftool not found for duration check.";
-        callback(filePath, ""); // Return empty duration on failure
+    MediaProbe::ProbeResult info = MediaProbe::probe(filePath);
+    if (info.isValid) {
+        callback(filePath, info.durationString());
         return;
     }
 
-    QProcess* process = new QProcess(this);
-    QStringList arguments;
-    arguments << "-T"
-              << "-Duration" << filePath; // Use -T for direct value output
-
-    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
-            [process, filePath, callback](int exitCode, QProcess::ExitStatus exitStatus) {
-                QString durationValue = "";
-                if (exitStatus == QProcess::NormalExit && exitCode == 0) {
-                    durationValue =
-                        QString::fromLocal8Bit(process->readAllStandardOutput()).trimmed();
-                    if (durationValue == "-")
-                        durationValue = ""; // Handle case where tag not found
-                } else {
-                    qWarning() << "exiftool failed for duration check on" << filePath;
-                    // Log error output?
-                }
-                callback(filePath, durationValue); // Call the callback with result
-                process->deleteLater();
-            });
-
-    connect(process, &QProcess::errorOccurred, this,
-            [process, filePath, callback](QProcess::ProcessError error) {
-                qWarning() << "Failed to start exiftool for duration check. Error:" << error;
-                callback(filePath, ""); // Return empty duration
-                process->deleteLater();
-            });
-
-    process->start(exiftoolPath, arguments);
+    ExifToolPool::instance()->request(
+        filePath, {"Duration"}, this,
+        [filePath, callback, reason = info.errorMessage](const ExifToolPool::Result& result) {
+            const QString duration = result.value("Duration").section(" (", 0, 0).trimmed();
+            if (duration.isEmpty())
+                qWarning() << "Duration check failed for" << filePath << "-" << reason
+                           << result.error;
+            callback(filePath, duration); // Empty duration on failure
+        });
 }
 
 void player::on_btPlay_clicked() {
-    qDebug() << "Play button clicked";
+    qCDebug(xfbPlayback) << "Play button clicked";
 
     if (PlayMode == "stopped") {
         if (darkMode) {
@@ -1568,58 +2319,15 @@ void player::on_btPlay_clicked() {
         ui->btPlay->setStyleSheet("background-color:#F0DB1B"); // amarillo
         PlayMode = "Playing_StopAtNextOne";
         ui->btPlay->setText(tr("Play and Stop"));
+        requeueQueuedTrack(); // Don't segue into an already queued item
 
         // Sync the new button visual
         ui->bt_stop_next->setStyleSheet("background-color:#F0DB1B; color: black;"); // Yellow
     }
 }
 
-void player::playNextMedia() {
-    // Increment the playlist index and play the next media
-    if (XplaylistUrls.isEmpty()) {
-        qDebug() << "Playlist is empty, cannot play next media";
-        return;
-    }
-
-    XplaylistIndex++;
-    if (XplaylistIndex >= XplaylistUrls.size()) {
-        // Reached the end of the playlist
-        XplaylistIndex = 0;
-        if (PlayMode == "Playing_Segue") {
-            // In segue mode, try to get the next song from the playlist widget
-            playNextSong();
-        } else {
-            // Otherwise, stop playback
-            Xplayer->stop();
-            ui->btPlay->setStyleSheet("");
-            ui->btPlay->setText(tr("Play"));
-            PlayMode = "stopped";
-        }
-    } else {
-        // Play the next media in the playlist
-        Xplayer->setSource(XplaylistUrls[XplaylistIndex]);
-        Xplayer->play();
-    }
-}
-
-void player::playPreviousMedia() {
-    // Decrement the playlist index and play the previous media
-    if (XplaylistUrls.isEmpty()) {
-        qDebug() << "Playlist is empty, cannot play previous media";
-        return;
-    }
-
-    XplaylistIndex--;
-    if (XplaylistIndex < 0) {
-        // Reached the beginning of the playlist, wrap around to the end
-        XplaylistIndex = XplaylistUrls.size() - 1;
-    }
-
-    Xplayer->setSource(XplaylistUrls[XplaylistIndex]);
-    Xplayer->play();
-}
-
 void player::playNextSong() {
+    TraceSpan span("player", "playNextSong");
     QSqlDatabase db = QSqlDatabase::database("xfb_connection");
     if (!db.isOpen()) {
         qWarning() << "Database connection 'xfb_connection' is not open in playNextSong!";
@@ -1632,68 +2340,40 @@ void player::playNextSong() {
     }
 
     if (PlayMode == "Playing_Segue") {
-        qDebug() << "The white rabit is Playing_segue";
+        qCDebug(xfbPlayback) << "The white rabit is Playing_segue";
 
-        if (ui->playlist->count() > 0) {
-            QString itemDaPlaylist = ui->playlist->item(0)->text();
+        if (!playlistQueue->isEmpty()) {
+            QString itemDaPlaylist = playlistQueue->path(0);
 
-            qDebug() << "itemDaPlaylist has value " << itemDaPlaylist;
+            qCDebug(xfbPlayback) << "itemDaPlaylist has value " << itemDaPlaylist;
 
             if ((lastPlayedSong != itemDaPlaylist) || (autoMode == 0)) {
-                qDebug() << "lastplayesong != itemdaplaylist";
-
-                // Clear current playlist and add new media
-                XplaylistUrls.clear();
-                XplaylistUrls.append(QUrl::fromLocalFile(itemDaPlaylist));
-                XplaylistIndex = 0;
+                qCDebug(xfbPlayback) << "lastplayesong != itemdaplaylist";
 
-                // Set the media to play
-                Xplayer->setSource(XplaylistUrls[XplaylistIndex]);
+                // Start right away when nothing is on air; otherwise let the
+                // engine pre-decode it and segue at the end of the current track.
+                // Now playing and history are updated from onEngineTrackStarted().
+                if (playbackEngine->state() == PlaybackEngine::State::Stopped) {
+                    playbackEngine->play(itemDaPlaylist);
+                } else {
+                    playbackEngine->queueNext(itemDaPlaylist);
+                }
 
                 lastPlayedSong = itemDaPlaylist;
-
-                int dotsNumInString = itemDaPlaylist.count(".");
-
-                qDebug() << "dotsNumInString has value: " << dotsNumInString;
-
-                QFileInfo fileName(itemDaPlaylist);
-                QString baseName = fileName.fileName();
-                ui->txtNowPlaying->setText(baseName);
-
                 QDateTime now = QDateTime::currentDateTime();
-                QString text = now.toString("yyyy-MM-dd || hh:mm:ss ||");
-                QString historyNewLine = text + " " + baseName;
-                ui->historyList->addItem(historyNewLine);
-                int hlistcout = ui->historyList->count();
-                qDebug() << "historyList has " << hlistcout << " items";
-
-                if (hlistcout > 99) {
-                    qDebug()
-                        << "HistoryList is beeing cleaned beacuse it's over 100 records now...";
-                    delete ui->historyList->item(0);
-                }
-
-                Xplayer->play();
 
-                delete ui->playlist->item(0);
+                playlistQueue->takeFirst();
 
                 if (ui->checkBox_update_last_played_values->isChecked()) {
-                    QSqlQuery* qry = new QSqlQuery(db);
-                    QString qrystr = "update musics set last_played = '" +
-                                     now.toString("yyyy-MM-dd || hh:mm:ss") + "' where path = \"" +
-                                     lastPlayedSong + "\"";
-                    qry->exec(qrystr);
-
-                    qrystr = "update musics set played_times = played_times+1 where path = \"" +
-                             lastPlayedSong + "\"";
-                    qry->exec(qrystr);
+                    playHistory->recordPlay(lastPlayedSong, now);
                 }
 
                 if (ui->checkBox_random_jingles->isChecked()) {
                     int num = ui->spinBox_random_jingles_interval->value();
 
-                    qDebug() << "Adding a new jingle every " << num
-                             << " songs.. (setting checkbox to false if value is zero..)";
+                    qCDebug(xfbPlayback)
+                        << "Adding a new jingle every " << num
+                        << " songs.. (setting checkbox to false if value is zero..)";
 
                     if (num == 0) {
                         ui->checkBox_random_jingles->setChecked(false);
@@ -1701,56 +2381,45 @@ void player::playNextSong() {
                     } else {
                         if (jingleCadaNumMusicas == num) {
                             jingleCadaNumMusicas = 0;
-                            qDebug() << "Adding a jingle..";
-
-                            int num = 1;
-                            checkDbOpen();
-                            QSqlQuery query(db);
-                            query.prepare("select path from jingles order by random() limit :num");
-                            query.bindValue(":num", num);
-                            if (query.exec()) {
-                                qDebug() << "SQL query executed: " << query.lastQuery();
-
-                                while (query.next()) {
-                                    QString path = query.value(0).toString();
-                                    ui->playlist->insertItem(0, path);
-
-                                    qDebug() << "autoMode random jingle chooser adding: " << path;
-                                }
-
-                            } else {
-                                qDebug() << "SQL ERROR: " << query.lastError();
-                                qDebug() << "SQL was: " << query.lastQuery();
+                            qCDebug(xfbPlayback) << "Adding a jingle..";
+
+                            // Drawn from memory; prepending it prefetches its file
+                            const SpotPool::Spot jingle = jinglePool->next();
+                            if (!jingle.path.isEmpty()) {
+                                playlistQueue->prepend(jingle.path);
+                                qCDebug(xfbPlayback)
+                                    << "autoMode random jingle chooser adding: " << jingle.path;
                             }
 
                         } else {
                             jingleCadaNumMusicas++;
 
-                            qDebug()
+                            qCDebug(xfbPlayback)
                                 << "jingleCadaNumMusicas incremented to " << jingleCadaNumMusicas;
                         }
                     }
                 }
 
             } else {
-                qDebug() << "lastplayesong has the same value that itemdaplaylist...";
+                qCDebug(xfbPlayback) << "lastplayesong has the same value that itemdaplaylist...";
             }
 
         } else {
             if (autoMode == 1) {
-                qDebug() << "Almost giving up dude.. there's nothing to play.. but trying again "
-                            "since we are in autoMode..";
+                qCDebug(xfbPlayback)
+                    << "Almost giving up dude.. there's nothing to play.. but trying again "
+                       "since we are in autoMode..";
                 // Prevent infinite recursion by checking if playlist is still empty after
                 // playlistAboutToFinish
-                int currentPlaylistCount = ui->playlist->count();
+                int currentPlaylistCount = playlistQueue->count();
                 playlistAboutToFinish();
-                if (ui->playlist->count() > currentPlaylistCount) {
+                if (playlistQueue->count() > currentPlaylistCount) {
                     // Only recurse if new items were added to the playlist
                     playNextSong();
                 } else {
-                    qDebug()
+                    qCDebug(xfbPlayback)
                         << "No new items added to playlist, stopping to prevent infinite recursion";
-                    Xplayer->stop();
+                    playbackEngine->stop();
                     ui->btPlay->setStyleSheet("");
                     ui->btPlay->setText(tr("Play"));
                     PlayMode = "stopped";
@@ -1758,34 +2427,33 @@ void player::playNextSong() {
                 return;
             }
 
-            qDebug() << "I'm giving up dude.. there's nothing to play..";
-            Xplayer->stop();
+            qCDebug(xfbPlayback) << "I'm giving up dude.. there's nothing to play..";
+            playbackEngine->stop();
             ui->btPlay->setStyleSheet("");
             ui->btPlay->setText(tr("Play"));
             PlayMode = "stopped";
         }
 
     } else if (PlayMode == "Playing_StopAtNextOne") {
-        qDebug() << "The white rabit is Playing_StopAtNextOne";
-        Xplayer->stop();
+        qCDebug(xfbPlayback) << "The white rabit is Playing_StopAtNextOne";
+        playbackEngine->stop();
         ui->btPlay->setStyleSheet("");
         ui->btPlay->setText(tr("Play"));
         PlayMode = "stopped";
 
     } else if (PlayMode == "stopped") {
-        qDebug() << "The white rabit is stopped";
+        qCDebug(xfbPlayback) << "The white rabit is stopped";
     }
 
     calculate_playlist_total_time();
 }
 
 void player::on_btStop_clicked() {
-    Xplayer->stop();
+    requeueQueuedTrack();
+    playbackEngine->stop();
     ui->btPlay->setStyleSheet("");
     ui->btPlay->setText(tr("Play"));
     PlayMode = "stopped";
-    XplaylistUrls.clear();
-    XplaylistIndex = 0;
 }
 
 void player::on_sliderProgress_sliderMoved(int position) {
@@ -1797,121 +2465,226 @@ void player::on_sliderProgress_sliderMoved(int position) {
 
 void player::on_sliderVolume_sliderMoved(int position) {
     // qDebug()<<"volume slider mooved "<<position;
-    XplayerOutput->setVolume(position / 100.0);
+    playbackEngine->setVolume(position / 100.0f);
 }
 
 void player::onPositionChanged(qint64 position) {
-    if (!isDraggingProgress) {
+    // Position ticks go to the clock, which republishes them at a fixed rate
+    // so playback doesn't flood the GUI thread
+    PlaybackClock::instance()->setPosition(position);
+}
+
+void player::refreshPositionDisplay(qint64 position) {
+    if (!isDraggingProgress && ui->sliderProgress->value() != position) {
         ui->sliderProgress->setValue(position);
     }
+    waveform->setPosition(position);
 
-    int valor = (position * 100) / trackTotalDuration;
+    if (trackTotalDuration > 0) {
+        int valor = static_cast<int>((position * 100) / trackTotalDuration);
+        if (valor >= 10 && valor % 10 == 0 && valor != lastTrackPercentage) {
+            XFB_TRACE(xfbPlayback) << "trackPercentage: " << valor;
+            lastTrackPercentage = valor;
+        }
+    }
+}
 
-    QString tamanhoDoValor = QString::number(valor);
-    // qDebug()<<"Tamanho do valor: "<<tamanhoDoValor;
+void player::refreshTimeDisplay() {
+    // Only called when the whole second or the duration changes
+    const PlaybackClock::Time& time = PlaybackClock::instance()->time();
+    ui->txtDuration->setText(time.elapsed + QLatin1String(" of ") + time.duration);
+}
 
-    QStringList segundoValorTamanhoDoValor = tamanhoDoValor.split("");
-    // qDebug() << "O segundo valor de TamanhoDoValor é: " << segundoValorTamanhoDoValor;
+void player::durationChanged(qint64 position) {
+    qCDebug(xfbPlayback) << "Playback engine duration changed to " << position;
+    ui->sliderProgress->setMaximum(position);
+    trackTotalDuration = position;
+    PlaybackClock::instance()->setDuration(position);
+}
 
-    if (segundoValorTamanhoDoValor[2] == "0" && valor != lastTrackPercentage) {
-        qDebug() << "trackPercentage: " << valor;
-        lastTrackPercentage = valor;
+void player::onEngineTrackStarted(const QString& filePath) {
+    TraceSpan span("player", "onEngineTrackStarted");
+    QFileInfo fileName(filePath);
+    QString baseName = fileName.fileName();
+    QDateTime now = QDateTime::currentDateTime();
+    journalTrackEnded("next");
+    journalTrack = filePath;
+    journalTrackStarted = now;
+    eventJournal->record(EventJournal::Type::TrackStart,
+                         {{"path", filePath}, {"title", baseName}}, now);
+
+    ui->txtNowPlaying->setText(baseName);
+    icecastMetadata->setTitle(NowPlayingStatus::titleOf(filePath));
+    rotationEngine->markPlayed(filePath);
+    showWaveform(filePath);
+
+    // The mixer's rate is only known once it plays, so the air-check may start here
+    if (airCheckEnabled && !airCheck->isRunning())
+        applyAirCheck();
+    airCheck->markTrack(baseName);
+
+    // The oldest entry makes way once a day's worth is listed
+    historyModel->append(now, baseName);
+
+    // Warm up whatever is due next so the switch is served from memory
+    if (!playlistQueue->isEmpty())
+        playbackEngine->prefetch(playlistQueue->path(0));
+
+    TrackPrefetcher::Statistics prefetchStats = playbackEngine->prefetchStatistics();
+    qCDebug(xfbPlayback) << "Prefetch hits:" << prefetchStats.hits << "late:" << prefetchStats.late
+                         << "misses:" << prefetchStats.misses << "wasted:" << prefetchStats.wasted
+                         << "hit rate:" << prefetchStats.hitRate();
+
+    prepareTranscodes();
+    const TranscodeCache::Statistics transcodeStats = transcodeCache->statistics();
+    qCDebug(xfbPlayback) << "Transcode cache hits:" << transcodeStats.hits
+                         << "misses:" << transcodeStats.misses << "hit rate:"
+                         << transcodeStats.hitRate()
+                         << "copies:" << transcodeStats.entries << "MB:"
+                         << transcodeStats.bytes / 1048576;
+}
+
+void player::journalTrackEnded(const QString& reason) {
+    if (journalTrack.isEmpty())
+        return;
+    const QDateTime now = QDateTime::currentDateTime();
+    const qint64 playedMs = journalTrackStarted.msecsTo(now);
+    eventJournal->record(EventJournal::Type::TrackStop,
+                         {{"path", journalTrack}, {"reason", reason}, {"played_ms", playedMs}},
+                         now);
+    playHistory->recordAiring(journalTrack, journalTrackStarted, playedMs);
+    journalTrack.clear();
+}
+
+void player::setupQueueJournal() {
+    queueJournal = new QueueJournal(this);
+    queueJournal->setQueueSource([this]() { return playlistQueue->paths(); });
+    connect(queueJournal, &QueueJournal::operationError, this,
+            [this](const QString& operation, const QString& error) {
+                eventJournal->record(EventJournal::Type::Error, {{"component", "QueueJournal"},
+                                                                 {"operation", operation},
+                                                                 {"message", error}});
+            });
+    if (!queueJournal->open(QueueJournal::defaultLocation()))
+        return;
+    if (resumeAfterRestart)
+        resumeFromJournal();
+    else
+        queueJournal->stopped();
+    queueJournal->queueChanged();
+
+    const auto queueChanged = [this]() { queueJournal->queueChanged(); };
+    connect(playlistQueue, &QAbstractItemModel::rowsInserted, queueJournal, queueChanged);
+    connect(playlistQueue, &QAbstractItemModel::rowsRemoved, queueJournal, queueChanged);
+    connect(playlistQueue, &QAbstractItemModel::rowsMoved, queueJournal, queueChanged);
+    connect(playlistQueue, &QAbstractItemModel::modelReset, queueJournal, queueChanged);
+    connect(playbackEngine, &PlaybackEngine::trackStarted, queueJournal,
+            &QueueJournal::trackStarted);
+    connect(playbackEngine, &PlaybackEngine::positionChanged, queueJournal,
+            &QueueJournal::setPosition);
+    connect(playbackEngine, &PlaybackEngine::stateChanged, queueJournal,
+            [this](DeckMixer::State state) {
+                if (state == DeckMixer::State::Stopped)
+                    queueJournal->stopped();
+            });
+    if (schedulerEngine) {
+        connect(schedulerEngine, &SchedulerEngine::eventDue, queueJournal,
+                [this](const ScheduledEvent& event) {
+                    queueJournal->scheduled(event.rule.rowId, event.fireAt);
+                });
     }
+}
 
-    if (valor >= 80 && onAbout2Finish == 0) {
-        playlistAboutToFinish();
+void player::resumeFromJournal() {
+    const QueueJournal::State state = queueJournal->restored();
+    // Events that fired just before the restart are not played a second time
+    if (schedulerEngine) {
+        for (const QueueJournal::Firing& firing : state.fired)
+            schedulerEngine->markFired(firing.rowId, firing.fireAt);
     }
+    if (state.isEmpty() || !playlistQueue->isEmpty())
+        return;
 
-    int segundos = position / 1000;
-    int minutos = 0;
-    int horas = 0;
-    QString xsegundos;
-    QString xminutos;
-    QString xhoras;
-    while (segundos > 60) {
-        ++minutos;
-        segundos -= 60;
-    }
-    while (minutos > 60) {
-        ++horas;
-        minutos -= 60;
+    QStringList queue;
+    for (const QString& path : state.queue) {
+        if (QFileInfo::exists(path))
+            queue << path;
     }
+    playlistQueue->append(queue);
 
-    if (segundos < 10) {
-        xsegundos = "0" + QString::number(segundos);
-    } else {
-        xsegundos = QString::number(segundos);
-    }
-    if (minutos < 10) {
-        xminutos = "0" + QString::number(minutos);
-    } else {
-        xminutos = QString::number(minutos);
+    const bool recent = state.savedAt.isValid() &&
+                        state.savedAt.msecsTo(QDateTime::currentDateTime()) <= RESUME_WINDOW_MS;
+    if (state.current.isEmpty() || !recent || !QFileInfo::exists(state.current)) {
+        qCInfo(xfbPlayback) << "Restored" << queue.size() << "queued tracks after a restart";
+        queueJournal->stopped();
+        return;
     }
-    if (horas < 10) {
-        xhoras = "0" + QString::number(horas);
+
+    qCInfo(xfbPlayback) << "Resuming" << state.current << "at" << state.positionMs
+                        << "ms with" << queue.size() << "queued tracks";
+    playbackEngine->play(state.current);
+    if (state.positionMs > 0)
+        playbackEngine->setPosition(state.positionMs);
+    lastPlayedSong = state.current;
+    PlayMode = "Playing_Segue";
+    if (darkMode) {
+        ui->btPlay->setStyleSheet("background-color:#5e9604"); // green
     } else {
-        xhoras = QString::number(horas);
+        ui->btPlay->setStyleSheet("background-color:#2CCD54"); // green
     }
-    QString txtElapsedTimeLable = xhoras + ":" + xminutos + ":" + xsegundos + " of " + txtDuration;
-    ui->txtDuration->setText(txtElapsedTimeLable);
+    ui->btPlay->setText(tr("Play and Segue"));
 }
 
-void player::durationChanged(qint64 position) {
-    qDebug() << "Xplayer durationChanged changed to " << position;
-    ui->sliderProgress->setMaximum(position);
-    trackTotalDuration = position;
+void player::writeNowPlaying() {
+    // journalTrack is cleared when playback stops, which the displays show as off air
+    NowPlayingStatus::Entry entry;
+    entry.path = journalTrack;
+    entry.title = NowPlayingStatus::titleOf(journalTrack);
+    entry.startedAt = journalTrackStarted;
+    entry.durationMs = playbackEngine->duration() > 0 ? playbackEngine->duration() : -1;
+    entry.upcoming = playlistQueue->paths(NowPlayingStatus::UPCOMING_LIMIT);
+    nowPlayingStatus->write(entry);
+}
 
-    int segundos = position / 1000;
-    int minutos = 0;
-    int horas = 0;
-    QString xsegundos;
-    QString xminutos;
-    QString xhoras;
-    while (segundos > 60) {
-        ++minutos;
-        segundos -= 60;
-    }
-    while (minutos > 60) {
-        ++horas;
-        minutos -= 60;
-    }
+void player::onEngineNextTrackRequested() {
+    // The engine wants the following item early so it can be pre-decoded and
+    // mixed in without a gap; in "stop at next" mode we simply let it run out
+    if (PlayMode != "Playing_Segue")
+        return;
 
-    if (segundos < 10) {
-        xsegundos = "0" + QString::number(segundos);
-    } else {
-        xsegundos = QString::number(segundos);
-    }
-    if (minutos < 10) {
-        xminutos = "0" + QString::number(minutos);
-    } else {
-        xminutos = QString::number(minutos);
-    }
-    if (horas < 10) {
-        xhoras = "0" + QString::number(horas);
-    } else {
-        xhoras = QString::number(horas);
+    qCDebug(xfbPlayback) << "Playback engine requested the next track";
+    // The track ending now is the last before an event back-timed to follow it
+    if (backTimedNext && !backTimedQueued) {
+        playlistQueue->prepend(backTimedPath);
+        backTimedQueued = true;
+        qCDebug(xfbScheduler) << "Back-timed event follows the track on air:" << backTimedPath;
     }
+    if (playlistQueue->isEmpty())
+        playlistAboutToFinish();
 
-    txtDuration = xhoras + ":" + xminutos + ":" + xsegundos;
+    if (!playlistQueue->isEmpty())
+        playNextSong();
 }
 
-void player::currentMediaChanged(const QUrl& content) {
-    // Unused parameter 'content'
-    Q_UNUSED(content);
-
-    // qDebug()<<"On currentMediaChanged with content: "<<content;
-    if (onAbout2Finish == 1) {
-        onAbout2Finish = 0;
-        // Using XplaylistUrls instead of deprecated QMediaPlaylist
-        if (XplaylistIndex < XplaylistUrls.size()) {
-            XplaylistUrls.removeAt(XplaylistIndex);
-        }
+void player::onEnginePlaybackFinished() {
+    TraceSpan span("player", "onEnginePlaybackFinished");
+    // Nothing was queued when the last track ended: pick up (or give up) here
+    qCDebug(xfbPlayback) << "Playback engine finished with nothing queued";
+    journalTrackEnded("end");
+    if (PlayMode != "stopped")
         playNextSong();
-    }
 }
 
-void player::volumeChanged(int volume) {
-    qDebug() << "Volume: " << volume;
+void player::requeueQueuedTrack() {
+    // A queued item was already taken off the playlist; put it back on top
+    QString queued = playbackEngine->queuedSource();
+    if (queued.isEmpty())
+        return;
+
+    playbackEngine->clearNext();
+    playlistQueue->prepend(queued);
+    if (lastPlayedSong == queued)
+        lastPlayedSong.clear();
 }
 
 void player::lp1_onPositionChanged(qint64 position) {
@@ -2003,7 +2776,7 @@ void player::lp1_onPositionChanged(qint64 position) {
 }
 
 void player::lp1_durationChanged(qint64 position) {
-    qDebug() << "LP 1 Duration Changed changed to " << position;
+    XFB_TRACE(xfbPlayback) << "LP 1 Duration Changed changed to " << position;
 
     lp1_total_time_int = position;
 
@@ -2051,11 +2824,11 @@ void player::lp1_currentMediaChanged(const QUrl& content) {
     // Unused parameter 'content'
     Q_UNUSED(content);
 
-    qDebug() << "LP 1 Current Media Changed..";
+    XFB_TRACE(xfbPlayback) << "LP 1 Current Media Changed..";
 }
 
 void player::lp1_volumeChanged(int volume) {
-    qDebug() << "LP 1 Volume: " << volume;
+    XFB_TRACE(xfbPlayback) << "LP 1 Volume: " << volume;
 }
 
 void player::lp2_onPositionChanged(qint64 position) {
@@ -2147,7 +2920,7 @@ void player::lp2_onPositionChanged(qint64 position) {
 }
 
 void player::lp2_durationChanged(qint64 position) {
-    qDebug() << "LP 2 Duration Changed changed to " << position;
+    XFB_TRACE(xfbPlayback) << "LP 2 Duration Changed changed to " << position;
 
     lp2_total_time_int = position;
 
@@ -2195,154 +2968,113 @@ void player::lp2_currentMediaChanged(const QUrl& content) {
     // Unused parameter 'content', but keeping method for signal connection
     Q_UNUSED(content);
 
-    qDebug() << "LP 2 Current Media Changed..";
+    XFB_TRACE(xfbPlayback) << "LP 2 Current Media Changed..";
 }
 
 void player::lp2_volumeChanged(int volume) {
-    qDebug() << "LP 2 Volume: " << volume;
+    XFB_TRACE(xfbPlayback) << "LP 2 Volume: " << volume;
 }
 
 void player::playlistAboutToFinish() {
-    qDebug() << "Launched playlistAboutToFinish";
-    onAbout2Finish = 1;
+    qCDebug(xfbPlayback) << "Launched playlistAboutToFinish";
 
-    int numItemsInPlaylist = ui->playlist->count();
+    int numItemsInPlaylist = playlistQueue->count();
     if (numItemsInPlaylist == 0)
         autoModeGetMoreSongs();
 }
 
 void player::update_music_table() {
-    QSqlDatabase db = QSqlDatabase::database("xfb_connection");
     checkDbOpen();
 
-    qInfo() << "Updating tables using connection:" << db.connectionName()
-            << "DB Name:" << db.databaseName();
-
-    // --- Populate music table ---
-    // Always delete previous model if reloading to prevent memory leaks and issues
-    delete ui->musicView->model();                        // Delete old model first
-    QSqlTableModel* model = new QSqlTableModel(this, db); // Pass the CORRECT db handle
-    model->setTable("musics");
-    // Optional: Set edit strategy if needed (BEFORE select)
-    // model->setEditStrategy(QSqlTableModel::OnFieldChange);
-    if (!model->select()) {
-        qWarning() << "Failed to select 'musics' table:" << model->lastError().text();
-        delete model; // Clean up failed model
-    } else {
-        ui->musicView->setModel(model);
-        // Configure view AFTER setting model (if needed)
-        qDebug() << "'musics' table model set.";
-        // Re-apply view settings if necessary as they might reset with new model
-        ui->musicView->setSortingEnabled(true);
-        ui->musicView->hideColumn(0);
-        // ... other ui->musicView settings ...
-    }
-
-    // --- Populate jingles table ---
-    delete ui->jinglesView->model();                             // Delete old model
-    QSqlTableModel* jinglesmodel = new QSqlTableModel(this, db); // Pass the CORRECT db handle
-    jinglesmodel->setTable("jingles");
-    if (!jinglesmodel->select()) {
-        qWarning() << "Failed to select 'jingles' table:" << jinglesmodel->lastError().text();
-        delete jinglesmodel;
-    } else {
-        ui->jinglesView->setModel(jinglesmodel);
-        qDebug() << "'jingles' table model set.";
-        // Configure view if needed
-    }
-
-    // --- Populate Pub table ---
-    delete ui->pubView->model();                             // Delete old model
-    QSqlTableModel* pubmodel = new QSqlTableModel(this, db); // Pass the CORRECT db handle
-    pubmodel->setTable("pub");
-    if (!pubmodel->select()) {
-        qWarning() << "Failed to select 'pub' table:" << pubmodel->lastError().text();
-        delete pubmodel;
-    } else {
-        ui->pubView->setModel(pubmodel);
-        qDebug() << "'pub' table model set.";
-        // Configure view if needed
-    }
-
-    // --- Populate Programs table ---
-    delete ui->programsView->model();                             // Delete old model
-    QSqlTableModel* programsmodel = new QSqlTableModel(this, db); // Pass the CORRECT db handle
-    programsmodel->setTable("programs");
-    if (!programsmodel->select()) {
-        qWarning() << "Failed to select 'programs' table:" << programsmodel->lastError().text();
-        delete programsmodel;
-    } else {
-        ui->programsView->setModel(programsmodel);
-        qDebug() << "'programs' table model set.";
-        // Configure view if needed
-    }
-
-    // --- Populate genre1 and 2 filters ---
-    // No need to delete QComboBox models usually unless you are replacing them frequently
-    // Create model ONCE, maybe in constructor, and just update query if needed?
-    // Or if updating here, manage previous model memory:
-    delete ui->cBoxGenre1->model(); // Delete previous model data if reloading fully
-    // Note: cBoxGenre2 shares the same model, deleting above is sufficient
-
-    // Create model associated with the correct DB connection
-    QSqlQueryModel* model_genre1 =
-        new QSqlQueryModel(this); // Parent 'this' manages memory somewhat
-
-    // Use a stack-based QSqlQuery - safer memory management
-    QSqlQuery qry(db); // Pass the CORRECT db handle
-
-    QString sqlq = "SELECT name FROM genres1 ORDER BY name"; // Added ORDER BY
-    if (!qry.prepare(sqlq)) {                                // Prepare is safer
-        qWarning() << "Failed to prepare genre query:" << qry.lastError().text();
-        delete model_genre1; // Clean up model
-        return;              // Exit if query prep fails
-    }
-
-    if (!qry.exec()) { // Execute the prepared query
-        qWarning() << "Failed to execute genre query:" << qry.lastError().text();
-        delete model_genre1; // Clean up model
-        return;              // Exit if query exec fails
-    }
-
-    model_genre1->setQuery(std::move(qry)); // Set query AFTER successful execution
-    if (model_genre1->lastError().isValid()) {
-        qWarning() << "Error setting query on genre model:" << model_genre1->lastError().text();
-    }
-
-    // Set model for BOTH combo boxes
-    ui->cBoxGenre1->setModel(model_genre1);
-    ui->cBoxGenre1->setModelColumn(0); // Display the first column ('name')
-
-    ui->cBoxGenre2->setModel(model_genre1); // Share the same model
-    ui->cBoxGenre2->setModelColumn(0);
-
-    // Also update the random add genre combo box if it uses the same list
-    delete ui->comboBox_random_add_genre->model(); // Assuming it should also be updated
-    ui->comboBox_random_add_genre->setModel(model_genre1);
-    ui->comboBox_random_add_genre->setModelColumn(0);
-
-    qInfo() << "Genre combo boxes updated.";
-
-    qInfo() << "Finished updating tables.";
+    // For writes that cannot tell which rows they touched; every reader
+    // re-reads its table, the models applying only what changed
+    for (const char* table :
+         {"musics", "jingles", "pub", "programs", "genres1", "hourgenre", "scheduler"})
+        TableChangeBus::instance()->notifyReset(table);
+}
+
+void player::setupTableChanges() {
+    TableChangeBus* bus = TableChangeBus::instance();
+
+    // Tracks added, edited or deleted through the repository, by imports,
+    // downloads and bulk deletes, are posted as the rows they are
+    connect(musicRepository, &MusicRepository::musicAdded, bus,
+            [bus](const MusicItem& music) { bus->notifyChanged("musics", {music.id}); });
+    connect(musicRepository, &MusicRepository::musicUpdated, bus,
+            [bus](const MusicItem& music) { bus->notifyChanged("musics", {music.id}); });
+    connect(musicRepository, &MusicRepository::playCountIncremented, bus,
+            [bus](int musicId) { bus->notifyChanged("musics", {musicId}); });
+    connect(musicRepository, &MusicRepository::musicDeleted, bus,
+            [bus](int musicId) { bus->notifyRemoved("musics", {musicId}); });
+
+    connect(bus, &TableChangeBus::tableChanged, this, [this](const TableChangeBus::Change& change) {
+        for (LiveTableModel* model :
+             {musicsModel, jinglesModel, pubModel, programsModel, genresModel}) {
+            if (model && !model->applyChange(change))
+                qWarning() << "Failed to update" << model->tableName()
+                           << "table:" << model->lastError().text();
+        }
+
+        // Let auto mode reload its rotation pools and hour genres, and the
+        // scheduler its rules. The rotation reloads once the library
+        // snapshot is read again.
+        if (change.table == "musics") {
+            if (searchController)
+                searchController->invalidate();
+            if (librarySnapshots)
+                librarySnapshots->rebuild();
+            else if (rotationEngine)
+                rotationEngine->invalidate();
+        } else if (change.table == "jingles") {
+            if (jinglePool)
+                jinglePool->invalidate();
+            if (cartWall)
+                loadCartWall();
+        } else if (change.table == "hourgenre") {
+            if (hourGenreSchedule)
+                hourGenreSchedule->invalidate();
+        } else if (change.table == "scheduler" || change.table == "pub"
+                   || change.table == "programs") {
+            if (schedulerEngine)
+                schedulerEngine->reload();
+            if (adBreaks && change.table == "pub")
+                adBreaks->invalidate();
+            planAdBreaks();
+            publishSchedule();
+        }
+    });
 }
 
 void player::dropEvent(QDropEvent* event) {
+    // Files and folders from a file manager have no source in this application
+    if (!event->source() && event->mimeData()->hasUrls()) {
+        QStringList paths;
+        for (const QUrl& url : event->mimeData()->urls()) {
+            if (url.isLocalFile())
+                paths << QDir::cleanPath(url.toLocalFile());
+        }
+        if (!paths.isEmpty())
+            importDroppedPaths(paths, ui->tabWidget_2->currentIndex() == 0);
+        event->acceptProposedAction();
+        return;
+    }
+
     player* source = qobject_cast<player*>(event->source());
 
-    qDebug() << "::::DROP::::";
+    qCDebug(xfbPlaylist) << "::::DROP::::";
 
     if (xaction == "drag_to_music_playlist") {
-        qDebug() << "drop MUSIC event! " << estevalor << " xaction: " << xaction
-                 << "evnt source: " << source->objectName();
+        qCDebug(xfbPlaylist) << "drop MUSIC event! " << estevalor << " xaction: " << xaction
+                             << "evnt source: " << (source ? source->objectName() : QString());
         // qDebug () << "event mime data" << event->mimeData();
 
-        if (source->objectName() == "player") {
+        if (source && source->objectName() == "player") {
             // sources.append(estevalor);
 
             int tab_index = ui->tabWidget_2->currentIndex();
 
             if (tab_index == 0) {
-                ui->playlist->addItem(estevalor);
+                playlistQueue->append(estevalor);
 
                 if (ui->checkBox_sum_to_playlist_time->isChecked()) {
                     calculate_playlist_total_time();
@@ -2351,14 +3083,14 @@ void player::dropEvent(QDropEvent* event) {
 
             if (tab_index == 2) {
                 if (ui->lp_1->underMouse()) {
-                    qDebug() << "Add to DJ tab :: LP 1 ::" << estevalor;
+                    qCDebug(xfbPlaylist) << "Add to DJ tab :: LP 1 ::" << estevalor;
 
                     ui->lp_1_txt_file->setText(estevalor);
                     ui->lp_1->setPixmap(QPixmap(":/images/lp_player_p1.png"));
                 }
 
                 if (ui->lp_2->underMouse()) {
-                    qDebug() << "Add to DJ tab :: LP 2 ::" << estevalor;
+                    qCDebug(xfbPlaylist) << "Add to DJ tab :: LP 2 ::" << estevalor;
 
                     ui->lp_2_txt_file->setText(estevalor);
                     ui->lp_2->setPixmap(QPixmap(":/images/lp_player_p1.png"));
@@ -2368,8 +3100,9 @@ void player::dropEvent(QDropEvent* event) {
         xaction = "";
 
     } else {
-        qDebug() << "xaction is not defined or is not 'drag_to_music_playlist' .. its content is: "
-                 << xaction;
+        qCDebug(xfbPlaylist)
+            << "xaction is not defined or is not 'drag_to_music_playlist' .. its content is: "
+            << xaction;
     }
 
     event->acceptProposedAction();
@@ -2377,6 +3110,10 @@ void player::dropEvent(QDropEvent* event) {
 
 void player::dragEnterEvent(QDragEnterEvent* event) {
     // qDebug() << "drag enter event " << event << event->mimeData();
+    if (!event->source() && event->mimeData()->hasUrls()) {
+        event->acceptProposedAction();
+        return;
+    }
     if (indexJust3rdDropEvt == 1) {
         // qDebug () << "This is the 2nd interaction and we now accepted the proposed action.";
         event->acceptProposedAction();
@@ -2386,6 +3123,94 @@ void player::dragEnterEvent(QDragEnterEvent* event) {
     }
 }
 
+void player::importDroppedPaths(const QStringList& paths, bool toPlaylist) {
+    // Each drop gets an import of its own on the pool, so a folder of
+    // hundreds of tracks does not hold up the window. Dropped on the
+    // playlist, every file shows at once and is filled in once it is read
+    auto* importer = new BatchImportProcessor(musicRepository, this);
+    importer->setDurationCache(durationCache);
+
+    BackgroundOperationFeedback* feedback = backgroundFeedback();
+    const int operation =
+        feedback ? feedback->startOperation(tr("Import"), tr("Importing the dropped files"),
+                                            BackgroundOperationFeedback::OperationType::FileImport)
+                 : -1;
+
+    if (!dropRefreshTimer) {
+        dropRefreshTimer = new QTimer(this);
+        dropRefreshTimer->setSingleShot(true);
+        dropRefreshTimer->setInterval(DROP_REFRESH_INTERVAL_MS);
+        connect(dropRefreshTimer, &QTimer::timeout, this, &player::update_music_table);
+    }
+
+    // Playlist files of this drop that the import has not reached yet
+    auto outstanding = std::make_shared<QSet<QString>>();
+    if (toPlaylist) {
+        connect(importer, &BatchImportProcessor::filesFound, this,
+                [this, outstanding](const QStringList& files) {
+                    for (const QString& file : files) {
+                        playlistQueue->appendPending(file, tr("Reading tags..."));
+                        outstanding->insert(file);
+                    }
+                });
+    }
+    connect(importer, &BatchImportProcessor::batchWritten, this,
+            [this, toPlaylist, outstanding](const QList<MusicItem>& items,
+                                            const QHash<QString, QString>& failed) {
+                if (toPlaylist) {
+                    QHash<QString, QString> toolTips = failed;
+                    for (const MusicItem& item : items)
+                        toolTips.insert(item.path, QString("%1 - %2 (%3)")
+                                                       .arg(item.artist, item.song, item.time));
+                    for (auto it = toolTips.cbegin(); it != toolTips.cend(); ++it)
+                        outstanding->remove(it.key());
+                    settleDroppedItems(toolTips);
+                }
+                if (!items.isEmpty() && !dropRefreshTimer->isActive())
+                    dropRefreshTimer->start();
+            });
+    connect(importer, &BatchImportProcessor::progressChanged, this,
+            [this, operation](int current, int total, const QString& message) {
+                BackgroundOperationFeedback* feedback = backgroundFeedback();
+                if (feedback && operation >= 0 && total > 0)
+                    feedback->updateProgress(operation, current * 100 / total, message);
+            });
+    connect(importer, &BatchImportProcessor::finished, this,
+            [this, importer, operation,
+             outstanding](const EnhancedAddDirectoryDialog::ImportStatistics& statistics,
+                          bool cancelled) {
+                QHash<QString, QString> toolTips;
+                for (const QString& file : std::as_const(*outstanding))
+                    toolTips.insert(file, tr("Not imported"));
+                settleDroppedItems(toolTips);
+
+                if (statistics.successfulImports > 0) {
+                    dropRefreshTimer->stop();
+                    update_music_table();
+                }
+
+                BackgroundOperationFeedback* feedback = backgroundFeedback();
+                if (feedback && operation >= 0)
+                    feedback->completeOperation(
+                        operation, !cancelled && statistics.errorFiles == 0,
+                        tr("%1 imported, %2 already in the library, %3 unreadable")
+                            .arg(statistics.successfulImports)
+                            .arg(statistics.skippedFiles)
+                            .arg(statistics.errorFiles));
+                importer->deleteLater();
+            });
+
+    importer->start(paths, EnhancedAddDirectoryDialog::ImportOptions());
+}
+
+void player::settleDroppedItems(const QHash<QString, QString>& toolTips) {
+    if (toolTips.isEmpty())
+        return;
+
+    // Counted in the total from now on; the duration is cached by the import
+    playlistQueue->settle(toolTips);
+}
+
 void player::on_musicView_pressed(const QModelIndex& index) {
     indexJust3rdDropEvt = 0;
 
@@ -2393,7 +3218,7 @@ void player::on_musicView_pressed(const QModelIndex& index) {
     ui->musicView->selectRow(index.row());
     int rowidx = ui->musicView->selectionModel()->currentIndex().row();
     estevalor = ui->musicView->model()->data(ui->musicView->model()->index(rowidx, 7)).toString();
-    qDebug() << "Music path: [" << estevalor << "]";
+    qCDebug(xfbPlayer) << "Music path: [" << estevalor << "]";
 
     xaction = "drag_to_music_playlist";
     // check if file exists and avoid adding if it does not
@@ -2406,22 +3231,24 @@ void player::on_musicView_pressed(const QModelIndex& index) {
             "reading it. Should it be deleted from the database?",
             QMessageBox::Yes | QMessageBox::No);
         if (reply == QMessageBox::Yes) {
-            qDebug() << "the file should be deleted from the database cause it does not exist in "
-                        "the hd (or path was changed)";
+            qCDebug(xfbPlayer)
+                << "the file should be deleted from the database cause it does not exist in "
+                   "the hd (or path was changed)";
             checkDbOpen();
             QSqlQuery* qry = new QSqlQuery(db);
             qry->prepare("delete from musics where path = :thpath");
             qry->bindValue(":thpath", estevalor);
 
             if (qry->exec()) {
-                qDebug() << "Music Deleted from database! last query was:" << qry->lastQuery();
+                qCDebug(xfbPlayer) << "Music Deleted from database! last query was:"
+                                   << qry->lastQuery();
                 update_music_table();
             } else {
-                qDebug() << "There was an error deleting the music from the database"
-                         << qry->lastError() << qry->lastQuery();
+                qCDebug(xfbPlayer) << "There was an error deleting the music from the database"
+                                   << qry->lastError() << qry->lastQuery();
             }
         } else {
-            qDebug() << "keeping invalid record in db... please fix path manually..";
+            qCDebug(xfbPlayer) << "keeping invalid record in db... please fix path manually..";
         }
 
     } else {
@@ -2433,7 +3260,7 @@ void player::on_musicView_pressed(const QModelIndex& index) {
         mimeData->setData(text, "drag_to_music_playlist");
         drag->setMimeData(mimeData);
         Qt::DropAction dropAction = drag->exec(Qt::CopyAction);
-        qDebug() << "DropAction near 1081 has: " << dropAction;
+        qCDebug(xfbPlayer) << "DropAction near 1081 has: " << dropAction;
     }
 }
 
@@ -2444,12 +3271,8 @@ void player::on_jinglesView_pressed(const QModelIndex& index) {
     // int thisid = index.row()+1;
     ui->jinglesView->selectRow(index.row());
     int rowidx = ui->jinglesView->selectionModel()->currentIndex().row();
-    checkDbOpen();
-    QSqlTableModel* model = new QSqlTableModel(this, db);
-    model->setTable("jingles");
-    model->select();
-    QString sqlPath = model->index(rowidx, 1).data().toString();
-    qDebug() << sqlPath;
+    QString sqlPath = jinglesModel->index(rowidx, 1).data().toString();
+    qCDebug(xfbPlayer) << sqlPath;
     xaction = "drag_to_music_playlist";
     estevalor = sqlPath;
     // check if file exists and avoid adding if it does not
@@ -2462,21 +3285,23 @@ void player::on_jinglesView_pressed(const QModelIndex& index) {
                                       QMessageBox::Yes | QMessageBox::No);
         if (reply == QMessageBox::Yes) {
             checkDbOpen();
-            qDebug() << "the file should be deleted from the database cause it does not exist in "
-                        "the hd (or path should change)";
+            qCDebug(xfbPlayer)
+                << "the file should be deleted from the database cause it does not exist in "
+                   "the hd (or path should change)";
             QSqlQuery* qry = new QSqlQuery(db);
             qry->prepare("delete from jingles where path = :thpath");
             qry->bindValue(":thpath", sqlPath);
 
             if (qry->exec()) {
-                qDebug() << "Music Deleted form database! last query was:" << qry->lastQuery();
+                qCDebug(xfbPlayer) << "Music Deleted form database! last query was:"
+                                   << qry->lastQuery();
                 update_music_table();
             } else {
-                qDebug() << "There was an error deleting the music from the database"
-                         << qry->lastError() << qry->lastQuery();
+                qCDebug(xfbPlayer) << "There was an error deleting the music from the database"
+                                   << qry->lastError() << qry->lastQuery();
             }
         } else {
-            qDebug() << "keeping invalid record in db... please fix path..";
+            qCDebug(xfbPlayer) << "keeping invalid record in db... please fix path..";
         }
     }
 
@@ -2488,19 +3313,40 @@ void player::on_jinglesView_pressed(const QModelIndex& index) {
     drag->exec(Qt::CopyAction);
 }
 
-void player::on_pubView_pressed(const QModelIndex& index) {
-    indexJust3rdDropEvt = 0;
+void player::on_jinglesView_activated(const QModelIndex& index) {
+    // Enter, or a double click where the platform activates on it, fires the cart
+    fireCart(jinglesModel->index(index.row(), 1).data().toString());
+}
 
-    QSqlDatabase db = QSqlDatabase::database("xfb_connection");
+void player::loadCartWall() {
+    // Files too long for a cart are left to the playlist
+    QStringList paths;
+    for (const SpotPool::Spot& spot : jinglePool->spots()) {
+        if (spot.durationUs <= qint64(CartWall::MAX_CART_SECONDS) * 1000000)
+            paths << spot.path;
+    }
+    std::sort(paths.begin(), paths.end());
+    cartWall->setCarts(paths);
+}
+
+bool player::fireCart(const QString& filePath) {
+    if (!playbackEngine->playCart(cartWall->slotOf(filePath))) {
+        qCDebug(xfbPlayback) << "Jingle is not on the cart wall yet:" << filePath;
+        return false;
+    }
+    qCDebug(xfbPlayback) << "Cart fired over the music:" << filePath;
+    return true;
+}
+
+void player::on_pubView_pressed(const QModelIndex& index) {
+    indexJust3rdDropEvt = 0;
+
+    QSqlDatabase db = QSqlDatabase::database("xfb_connection");
     // int thisid = index.row()+1;
     ui->pubView->selectRow(index.row());
     int rowidx = ui->pubView->selectionModel()->currentIndex().row();
-    checkDbOpen();
-    QSqlTableModel* model = new QSqlTableModel(this, db);
-    model->setTable("pub");
-    model->select();
-    QString sqlPath = model->index(rowidx, 2).data().toString();
-    qDebug() << sqlPath;
+    QString sqlPath = pubModel->index(rowidx, 2).data().toString();
+    qCDebug(xfbPlayer) << sqlPath;
     xaction = "drag_to_music_playlist";
     estevalor = sqlPath;
     // check if file exists and avoid adding if it does not
@@ -2513,21 +3359,23 @@ void player::on_pubView_pressed(const QModelIndex& index) {
                                       QMessageBox::Yes | QMessageBox::No);
         if (reply == QMessageBox::Yes) {
             checkDbOpen();
-            qDebug() << "the file should be deleted from the database cause it does not exist in "
-                        "the hd (or path should change)";
+            qCDebug(xfbPlayer)
+                << "the file should be deleted from the database cause it does not exist in "
+                   "the hd (or path should change)";
             QSqlQuery* qry = new QSqlQuery(db);
             qry->prepare("delete from pub where path = :thpath");
             qry->bindValue(":thpath", sqlPath);
 
             if (qry->exec()) {
-                qDebug() << "Pub deleted form database! last query was:" << qry->lastQuery();
+                qCDebug(xfbPlayer) << "Pub deleted form database! last query was:"
+                                   << qry->lastQuery();
                 update_music_table();
             } else {
-                qDebug() << "There was an error deleting the music from the database"
-                         << qry->lastError() << qry->lastQuery();
+                qCDebug(xfbPlayer) << "There was an error deleting the music from the database"
+                                   << qry->lastError() << qry->lastQuery();
             }
         } else {
-            qDebug() << "keeping invalid record in db... please fix path..";
+            qCDebug(xfbPlayer) << "keeping invalid record in db... please fix path..";
         }
     }
 
@@ -2548,12 +3396,8 @@ void player::on_programsView_pressed(const QModelIndex& index) {
     // int thisid = index.row()+1;
     ui->programsView->selectRow(index.row());
     int rowidx = ui->programsView->selectionModel()->currentIndex().row();
-    checkDbOpen();
-    QSqlTableModel* model = new QSqlTableModel(this, db);
-    model->setTable("programs");
-    model->select();
-    QString sqlPath = model->index(rowidx, 2).data().toString();
-    qDebug() << sqlPath;
+    QString sqlPath = programsModel->index(rowidx, 2).data().toString();
+    qCDebug(xfbPlayer) << sqlPath;
     xaction = "drag_to_music_playlist";
     estevalor = sqlPath;
     // check if file exists and avoid adding if it does not
@@ -2566,21 +3410,23 @@ void player::on_programsView_pressed(const QModelIndex& index) {
                                       QMessageBox::Yes | QMessageBox::No);
         if (reply == QMessageBox::Yes) {
             checkDbOpen();
-            qDebug() << "the file should be deleted from the database cause it does not exist in "
-                        "the hd (or path should change)";
+            qCDebug(xfbPlayer)
+                << "the file should be deleted from the database cause it does not exist in "
+                   "the hd (or path should change)";
             QSqlQuery* qry = new QSqlQuery(db);
             qry->prepare("delete from programs where path = :thpath");
             qry->bindValue(":thpath", sqlPath);
 
             if (qry->exec()) {
-                qDebug() << "Program deleted form database! last query was:" << qry->lastQuery();
+                qCDebug(xfbPlayer) << "Program deleted form database! last query was:"
+                                   << qry->lastQuery();
                 update_music_table();
             } else {
-                qDebug() << "There was an error deleting the program from the database"
-                         << qry->lastError() << qry->lastQuery();
+                qCDebug(xfbPlayer) << "There was an error deleting the program from the database"
+                                   << qry->lastError() << qry->lastQuery();
             }
         } else {
-            qDebug() << "keeping invalid record in db... please fix path.. ";
+            qCDebug(xfbPlayer) << "keeping invalid record in db... please fix path.. ";
         }
     }
 
@@ -2597,155 +3443,88 @@ void player::on_programsView_pressed(const QModelIndex& index) {
 void player::on_bt_autoMode_clicked() {
     if (autoMode == 0) {
         autoMode = 1;
-        qDebug() << "autoMode is ON";
+        qCDebug(xfbPlayback) << "autoMode is ON";
         ui->bt_autoMode->setStyleSheet("background-color: rgb(175, 227, 59)");
     } else {
         autoMode = 0;
-        qDebug() << "autoMode is OFF";
+        qCDebug(xfbPlayback) << "autoMode is OFF";
         ui->bt_autoMode->setStyleSheet("");
     }
 }
 
 void player::autoModeGetMoreSongs() {
+    TraceSpan span("player", "autoModeGetMoreSongs");
     // check if there's a programed genre for this hour in the hourgenre table
-
-    QSqlDatabase db = QSqlDatabase::database("xfb_connection");
-    QDateTime now = QDateTime::currentDateTime();
-    QString currentHour = now.toString("h");
-    int dia = QDate::currentDate().dayOfWeek();
-
-    QString dw;
-    if (dia == 1)
-        dw = "1";
-    if (dia == 2)
-        dw = "2";
-    if (dia == 3)
-        dw = "3";
-    if (dia == 4)
-        dw = "4";
-    if (dia == 5)
-        dw = "5";
-    if (dia == 6)
-        dw = "6";
-    if (dia == 7)
-        dw = "7";
-
-    QString qry = "select genre from hourgenre where hour=" + currentHour + " and day=" + dw;
-    qDebug() << "hourgenre query is: " << qry;
-    checkDbOpen();
-    QSqlQuery runQry(db);
-    QString currentGenre = "";
-
-    if (runQry.exec(qry)) {
-        qDebug() << "The query was successfull: " << qry;
-
-        while (runQry.next()) {
-            currentGenre = runQry.value(0).toString();
-            qDebug() << "We now have selected the following genre for this hour, based on the data "
-                        "from the hourgenre table in the database: "
-                     << currentGenre;
-        }
-
-    } else {
-        qDebug() << "Oh dear, what now? " << runQry.lastError();
-    }
-
-    if (currentGenre.isEmpty()) {
-        if (autoMode == 1) {
-            // randomly select music from db
-            int numMusics = 1;
-            QSqlQuery query(db);
-            query.prepare("select path from musics order by random() limit :numMusics");
-            query.bindValue(":numMusics", numMusics);
-            if (query.exec()) {
-                qDebug() << "SQL query executed: " << query.lastQuery();
-
-                while (query.next()) {
-                    QString path = query.value(0).toString();
-
-                    if (path != lastPlayedSong) {
-                        ui->playlist->addItem(path);
-                        qDebug() << "autoMode random music chooser adding: " << path;
-
-                    } else {
-                        QSqlQuery numOfItemsInDB(db);
-                        numOfItemsInDB.prepare("select count(path) from music where 1");
-                        numOfItemsInDB.exec();
-                        if (numOfItemsInDB.value(0).toInt() > 1) {
-                            qDebug() << "autoMode picked the same song that was played before... "
-                                        "Small DB or a Big Coincidence? Quering again for a "
-                                        "'random' new song..";
-                            autoModeGetMoreSongs();
-                        }
-                    }
-                }
-
-            } else {
-                qDebug() << "SQL ERROR: " << query.lastError();
-                qDebug() << "SQL was: " << query.lastQuery();
-            }
-        }
-
-    } else {
-        if (autoMode == 1) {
-            // randomly select music from db based on genre for this hour
-
-            QString querystr = "select path from musics where genre1 like '" + currentGenre +
-                               "' order by random() limit 1";
-            QSqlQuery query(db);
-            if (query.exec(querystr)) {
-                qDebug() << "SQL query executed: " << query.lastQuery();
-
-                while (query.next()) {
-                    QString path = query.value(0).toString();
-
-                    if (path != lastPlayedSong) {
-                        ui->playlist->addItem(path);
-                        qDebug() << "autoMode genre based random music chooser adding: " << path;
-
-                    } else {
-                        QSqlQuery numOfItemsInDB(db);
-                        numOfItemsInDB.prepare("select count(path) from music where 1");
-                        numOfItemsInDB.exec();
-                        if (numOfItemsInDB.value(0).toInt() > 1) {
-                            qDebug() << "autoMode picked the same song that was played before... "
-                                        "Small DB or a Big Coincidence? Quering again for a "
-                                        "'random' new song..";
-                            autoModeGetMoreSongs();
-                        }
-                    }
-                }
-
-            } else {
-                qDebug() << "SQL ERROR: " << query.lastError();
-                qDebug() << "SQL was: " << query.lastQuery();
-            }
-            currentGenre = "";
+    QString currentGenre = hourGenreSchedule->genreAt(QDateTime::currentDateTime());
+    if (!currentGenre.isEmpty()) {
+        qCDebug(xfbPlayback)
+            << "We now have selected the following genre for this hour, based on the data "
+               "from the hourgenre table in the database: "
+            << currentGenre;
+    }
+
+    if (autoMode == 1) {
+        // Pick from the shuffled rotation pools, whole library when no genre is
+        // programmed for this hour; the rotation keeps recent songs out
+        QString path = rotationEngine->nextTrack(currentGenre);
+        if (!path.isEmpty()) {
+            playlistQueue->append(path);
+            qCDebug(xfbPlayback) << "autoMode rotation adding: " << path << "genre:"
+                                 << currentGenre;
+        } else {
+            qCDebug(xfbPlayback) << "autoMode rotation has no songs for genre:" << currentGenre;
         }
     }
 }
 
 void player::on_actionAdd_a_single_song_triggered() {
-    add_music_single add_music_single;
-    add_music_single.setModal(true);
-    add_music_single.exec();
-    update_music_table();
+    if (!addMusicSingleDialog) {
+        setupTableModels();
+        addMusicSingleDialog = new add_music_single(this);
+        addMusicSingleDialog->setModal(true);
+        addMusicSingleDialog->setGenreModel(genresModel,
+                                            std::max(0, genresModel->fieldIndex("name")));
+    }
+    addMusicSingleDialog->reset();
+    addMusicSingleDialog->exec();
+    peakGenerator->generate(existingLibraryPaths());
 }
 
 void player::on_btPlayNext_clicked() {
-    // Using XplaylistUrls instead of deprecated QMediaPlaylist
-    if (!XplaylistUrls.isEmpty()) {
-        XplaylistUrls.removeAt(0);
+    if (PlayMode == "Playing_Segue") {
+        // Make sure something is queued, then start the transition now
+        if (!playbackEngine->hasQueuedTrack())
+            playNextSong();
+        playbackEngine->skipToNext();
+        return;
     }
     playNextSong();
 }
 
 void player::on_actionAdd_all_songs_in_a_folder_triggered() {
-    qDebug() << "Add a full dir";
-    add_full_dir add_full_dir;
-    add_full_dir.setModal(true);
-    add_full_dir.exec();
-    update_music_table();
+    qCDebug(xfbPlayer) << "Add a full dir";
+    if (!addFullDirDialog) {
+        setupTableModels();
+        // Imported on the pool in batches, so the window keeps playing out
+        addFullDirDialog = new EnhancedAddDirectoryDialog(musicRepository, this);
+        addFullDirDialog->setModal(true);
+        addFullDirDialog->setGenreModel(genresModel, std::max(0, genresModel->fieldIndex("name")));
+        addFullDirDialog->setDurationCache(durationCache);
+        EnhancedAddDirectoryDialog::ImportOptions options;
+        options.fileExtensions << "wma" << "opus";
+        addFullDirDialog->setImportOptions(options);
+        connect(addFullDirDialog, &EnhancedAddDirectoryDialog::importCompleted, this,
+                &player::update_music_table);
+        connect(addFullDirDialog, &EnhancedAddDirectoryDialog::importCancelled, this,
+                &player::update_music_table);
+        connect(addFullDirDialog, &EnhancedAddDirectoryDialog::errorOccurred, this,
+                [this](const QString& error) {
+                    QMessageBox::warning(addFullDirDialog, tr("Add directory"), error);
+                });
+    }
+    addFullDirDialog->resetDialog();
+    addFullDirDialog->exec();
+    peakGenerator->generate(existingLibraryPaths());
 }
 
 void player::on_actionManage_Genres_triggered() {
@@ -2758,1359 +3537,651 @@ void player::on_actionAdd_Jingle_triggered() {
     addJingle addjingle;
     addjingle.setModal(true);
     addjingle.exec();
-    update_music_table();
 }
 
 void player::on_actionAdd_a_publicity_triggered() {
     add_pub addp;
+    addp.setSchedulerEngine(schedulerEngine);
     addp.setModal(true);
     addp.exec();
     update_music_table();
 }
 
-void player::monitorTakeOver() {
-    QString hora = QDateTime::currentDateTime().toString("hh:mm:ss");
-
-    QString tkOut = "";
-
-    tkOut += hora + "-----> TakeOver Monitoring ";
-
-    QString takeoverfile = TakeOverPath + "/takeover.xml";
-    QFile file(takeoverfile);
+void player::startTakeOver(const QString& ip, const QString& stream) {
+    takeOverIP = ip;
+    takeOverStream = stream;
+    qCDebug(xfbPlayer) << "takeOverIP: " << takeOverIP << "TakeOverStream: " << takeOverStream;
 
-    tkOut += takeoverfile;
+    // play
 
-    if (!file.open(QFile::ReadOnly | QFile::Text)) {
-        tkOut += ": nothing found. ";
-        qDebug() << tkOut;
+    if (isContributionStream(takeOverStream)) {
+        const int port = QUrl(takeOverStream).port(contributionPort);
+        contributionLink->listen(static_cast<quint16>(port));
+        contributionLink->setPlayout(true);
+        contributionOnAir = true;
     } else {
-        QXmlStreamReader Rxml;
-        Rxml.setDevice(&file);
-        Rxml.readNext();
-
-        while (!Rxml.atEnd()) {
-            if (Rxml.isStartElement()) {
-                if (Rxml.name() == QStringLiteral("XFBClientTakeOver")) {
-                    qDebug() << "Valid XFB TakeOver Found!";
-                    Rxml.readNext();
-
-                    if (Rxml.isEndElement()) {
-                        qDebug() << "Found the last element of the XML file after StarElement, "
-                                    "leaving the while loop";
-                        Rxml.readNext();
-                        break;
-                    }
+        radio1str = "mplayer -volume 100 -playlist " + takeOverStream;
 
-                } else {
-                    Rxml.raiseError(QObject::tr("Not an XFB TakeOver file"));
-                }
-            } else {
-                Rxml.readNext();
+        qCDebug(xfbPlayer) << "Full cmd is: " << radio1str;
 
-                if (Rxml.name() == QStringLiteral("www.netpack.pt")) {
-                    qDebug() << "Token element: " << Rxml.name();
-                    Rxml.readNext();
-                }
+        radio1.start("sh", QStringList() << "-c" << radio1str);
+        radio1.waitForStarted(-1);
+        radio1.closeReadChannel(QProcess::StandardOutput);
+        radio1.closeReadChannel(QProcess::StandardError);
+    }
 
-                if (Rxml.name() == QStringLiteral("ip")) {
-                    takeOverIP = Rxml.readElementText();
-                    qDebug() << "takeOverIP: " << takeOverIP;
-                }
+    ui->txtNowPlaying->setText(takeOverStream);
+    eventJournal->record(EventJournal::Type::TakeOver,
+                         {{"state", "started"}, {"ip", takeOverIP}, {"stream", takeOverStream}});
 
-                if (Rxml.name() == QStringLiteral("stream")) {
-                    takeOverStream = Rxml.readElementText();
-                    qDebug() << "TakeOverStream: " << takeOverStream;
+    historyModel->append(QDateTime::currentDateTime(), takeOverStream);
 
-                    // play
+    // stop the main player...
 
-                    radio1str = "mplayer -volume 100 -playlist " + takeOverStream;
+    QTimer::singleShot(500, this, SLOT(MainFadeOut()));
+    QTimer::singleShot(4000, this, SLOT(MainStop()));
 
-                    qDebug() << "Full cmd is: " << radio1str;
+    // ping the client
 
-                    radio1.start("sh", QStringList() << "-c" << radio1str);
-                    radio1.waitForStarted(-1);
-                    radio1.closeReadChannel(QProcess::StandardOutput);
-                    radio1.closeReadChannel(QProcess::StandardError);
+    pingTakeOverClient();
+    updateFailoverStandby();
+    failoverStandby->arm();
+}
+
+void player::endTakeOver(const QString& ip, const QString& command) {
+    reachability->stop("takeover");
+    failoverStandby->disarm();
 
-                    ui->txtNowPlaying->setText(takeOverStream);
+    returnTakeOverIP = ip;
+    if (command != "returnTakeOver" || returnTakeOverIP != takeOverIP) {
+        qCDebug(xfbPlayer) << "The returnTakeOver IP: " << returnTakeOverIP
+                           << " tried to close a takeOver connection created by: " << takeOverIP;
+        return;
+    }
 
-                    QDateTime now = QDateTime::currentDateTime();
-                    QString text = now.toString("yyyy-MM-dd || hh:mm:ss ||");
-                    QString historyNewLine = text + " " + takeOverStream;
-                    ui->historyList->addItem(historyNewLine);
+    qCDebug(xfbPlayer) << "Closing takeOver from: " << returnTakeOverIP;
+    eventJournal->record(EventJournal::Type::TakeOver,
+                         {{"state", "ended"}, {"ip", returnTakeOverIP}});
 
-                    // stop the main player...
+    if (contributionOnAir) {
+        contributionOnAir = false;
+        contributionLink->setPlayout(false);
+        contributionLink->stop();
+    }
+    QTimer::singleShot(3000, this, SLOT(stopMplayer()));
 
-                    QTimer::singleShot(500, this, SLOT(MainsetVol100()));
-                    QTimer::singleShot(1000, this, SLOT(MainsetVol80()));
-                    QTimer::singleShot(1500, this, SLOT(MainsetVol60()));
-                    QTimer::singleShot(2000, this, SLOT(MainsetVol40()));
-                    QTimer::singleShot(2500, this, SLOT(MainsetVol20()));
-                    QTimer::singleShot(3000, this, SLOT(MainsetVol10()));
-                    QTimer::singleShot(3500, this, SLOT(MainsetVol5()));
-                    QTimer::singleShot(4000, this, SLOT(MainStop()));
+    // ensure stop
 
-                    // rename the takeover xml
+    on_btStop_clicked();
 
-                    qDebug() << "Converting TakeOver file into confirmation..";
-                    QString confirmtakeover = TakeOverPath + "/confirmtakeover.xml";
+    // Start the main player...
 
-                    QFile::rename(takeoverfile, confirmtakeover);
-                    qDebug() << "TakeOver file converted into confirmation file!";
+    QTimer::singleShot(250, this, SLOT(on_btPlay_clicked()));
 
-                    QTimer::singleShot(120000, this, SLOT(rmConfirmTakeOver()));
+    QTimer::singleShot(500, this, SLOT(MainFadeIn()));
+}
 
-                    // ping the client
+void player::server_check_and_schedule_new_programs() {
+    // Sorting uploads and adding them to the schedule runs on the broadcast
+    // worker; programsChanged() reloads the tables if anything was added
+    qCDebug(xfbScheduler) << "-------------------------------> Running Server Scheduler "
+                             "<-------------------------------------";
+    broadcastWorker->scanPrograms();
+}
 
-                    connect(stimer, SIGNAL(timeout()), this, SLOT(pingTakeOverClient()));
-                    stimer->start(30000);
-                }
-            }
-        }
-        file.close();
+void player::server_ftp_check() {
+    qCDebug(xfbScheduler)
+        << "server_ftp_check() :: Looking for new programs in the FTP server to download";
+    if (programSync->isRunning()) {
+        qCDebug(xfbScheduler) << "server_ftp_check() :: A check is already running";
+        return;
     }
 
-    QString ret = TakeOverPath + "/returntakeover.xml";
-    QFile rfile(ret);
+    // Programs are fetched straight into ProgramsPath; the broadcast worker
+    // adds each one to the schedule as it arrives
+    const QUrl server = QUrl::fromUserInput(Server_URL);
+    const quint16 port = Port > 0 ? static_cast<quint16>(Port) : FtpClient::DEFAULT_PORT;
+    programSync->setServer(server.host(), port, User, Pass);
+    programSync->setLocalDirectory(ProgramsPath);
+    if (!programSync->sync()) {
+        qWarning() << "server_ftp_check() :: Could not start the FTP check. Are the server and "
+                      "programs path set in the options?";
+    }
+}
 
-    tkOut = "";
+void player::returnTakeOver() {
+    QFile::remove("/usr/share/xfb/ftp/takeover.xml");
 
-    tkOut += hora + "-----> ReturnTakeOver Monitoring " + ret;
+    QString takeOverFile = "/usr/share/xfb/ftp/returntakeover.xml";
+    QFile file(takeOverFile);
 
-    if (!rfile.open(QFile::ReadOnly | QFile::Text)) {
-        tkOut += ": nothing found.";
-        qDebug() << tkOut;
-    } else {
-        stimer->stop();
+    if (returntakeOver == false) {
+        returntakeOver = true;
 
-        QXmlStreamReader Rxml;
-        Rxml.setDevice(&rfile);
-        Rxml.readNext();
+        file.open(QIODevice::WriteOnly);
+        QXmlStreamWriter xmlWriter(&file);
+        xmlWriter.setAutoFormatting(true);
+        xmlWriter.writeStartDocument();
 
-        while (!Rxml.atEnd()) {
-            if (Rxml.isStartElement()) {
-                if (Rxml.name() == QStringLiteral("XFBClientTakeOver")) {
-                    qDebug() << "Valid XFB returnTakeOver Found!";
-                    Rxml.readNext();
+        xmlWriter.writeStartElement("XFBClientTakeOver");
+        xmlWriter.writeStartElement("www.netpack.pt");
+        QString ip = ui->lbl_ddns->text();
 
-                    if (Rxml.isEndElement()) {
-                        qDebug() << "Found the last element of the XML file after StarElement, "
-                                    "leaving the while loop";
-                        Rxml.readNext();
-                        break;
-                    }
+        xmlWriter.writeTextElement("ip", ip);
+        xmlWriter.writeTextElement("cmd", "returnTakeOver");
 
-                } else {
-                    Rxml.raiseError(QObject::tr("Not an XFB returnTakeOver file"));
-                }
-            } else {
-                Rxml.readNext();
+        xmlWriter.writeEndElement();
+        xmlWriter.writeEndDocument();
+        file.close();
 
-                if (Rxml.name() == QStringLiteral("www.netpack.pt")) {
-                    qDebug() << "Token element: " << Rxml.name();
-                    Rxml.readNext();
-                }
+        qCDebug(xfbPlayer)
+            << "Sending returntakeOver to server. This requires ~/.netrc to be configured "
+               "with the ftp options and FTP Path in the options to point to a folder called "
+               "'ftp' that MUST be located in the parent directory of XFB (due to the code of "
+               "config/serverFtpCmdsPutTakeOver.sh).";
 
-                if (Rxml.name() == QStringLiteral("ip")) {
-                    returnTakeOverIP = Rxml.readElementText();
-                    qDebug() << "returnTakeOverIP: " << returnTakeOverIP;
-                }
+        QProcess sh, sh2;
+        QByteArray output, output2;
+        QString outPath, FTPCmdPath, xmls;
 
-                if (Rxml.name() == QStringLiteral("cmd")) {
-                    takeOverStream = Rxml.readElementText();
-                    qDebug() << "ReturnTakeOver :: " << takeOverStream;
+        sh.start("sh", QStringList() << "-c"
+                                     << "pwd");
+        sh.waitForFinished();
+        output = sh.readAll();
+        outPath = output;
+        QStringList path_arry = outPath.split("\n");
+        FTPCmdPath =
+            path_arry[0] +
+            "/usr/share/xfb/scripts/serverFtpCmdsPutTakeOver.sh | grep 'Transfer complete'";
+        qCDebug(xfbPlayer) << "running: " << FTPCmdPath;
+        qCDebug(xfbPlayer)
+            << "If you get errors: cd config && chmod +x serverFtpCmdsPutTakeOver.sh && chmod "
+               "600 ~/.netrc (the ftp is configured in .netrc correct?)";
+        sh.close();
 
-                    if (takeOverStream == "returnTakeOver" && returnTakeOverIP == takeOverIP) {
-                        qDebug() << "Closing takeOver from: " << returnTakeOverIP;
+        sh2.start("sh", QStringList() << "-c" << FTPCmdPath);
+        sh2.waitForFinished(-1);
+        output2 = sh2.readAll().trimmed();
+        xmls = output2;
+        qCDebug(xfbPlayer) << "The output of serverFtpCmdsPutTakeOver.sh is:\n" << output2;
+        sh2.close();
 
-                        QTimer::singleShot(3000, this, SLOT(stopMplayer()));
+        if (output2 == "226 Transfer complete.") {
+            ui->bt_takeOver->setStyleSheet("");
+            ui->bt_takeOver->setText(tr("Broadcast LIVE"));
 
-                        // ensure stop
+            ui->txt_ProgramName->setStyleSheet("background-color:#FFE329;padding:5px;");
+            ui->txt_ProgramName->hide();
 
-                        on_btStop_clicked();
+            piscaLive = false;
 
-                        // Start the main player...
+            QFile::remove("/usr/share/xfb/ftp/takeover.xml");
+        }
 
-                        QTimer::singleShot(250, this, SLOT(on_btPlay_clicked()));
+    } else {
+        returntakeOver = false;
+        QFile::remove(takeOverFile);
+        ui->bt_takeOver->setStyleSheet("");
+        ui->bt_takeOver->setText(tr("Broadcast LIVE"));
 
-                        QTimer::singleShot(500, this, SLOT(MainsetVol5()));
-                        QTimer::singleShot(1000, this, SLOT(MainsetVol10()));
-                        QTimer::singleShot(1500, this, SLOT(MainsetVol20()));
-                        QTimer::singleShot(2000, this, SLOT(MainsetVol40()));
-                        QTimer::singleShot(2500, this, SLOT(MainsetVol60()));
-                        QTimer::singleShot(3000, this, SLOT(MainsetVol80()));
-                        QTimer::singleShot(3500, this, SLOT(MainsetVol100()));
+        ui->txt_ProgramName->setStyleSheet("background-color:#FFE329;padding:5px;");
+        ui->txt_ProgramName->hide();
 
-                    } else {
-                        qDebug() << "The returnTakeOver IP: " << returnTakeOverIP
-                                 << " tried to close a takeOver connection created by: "
-                                 << takeOverIP;
-                    }
-                }
-            }
-        }
-        rfile.close();
-        QString rmthis = TakeOverPath + "/returntakeover.xml";
-        QFile::remove(rmthis);
+        piscaLive = false;
     }
 }
 
-void player::run_server_scheduler() {
-    QString hora = QDateTime::currentDateTime().toString("hh:mm");
-
-    qDebug() << "-------------------------------> Running Server Scheduler "
-                "<-------------------------------------\n"
-                "----------------------------------> "
-             << hora << " <------------------------------------------------";
+void player::stopMplayer() {
+    QProcess kb;
+    kb.startDetached("sh", QStringList() << "-c"
+                                         << "killall mplayer");
+    kb.waitForFinished();
 
-    server_check_and_schedule_new_programs();
+    qCDebug(xfbPlayback) << "All instances of mplayer were closed";
 }
 
-void player::server_check_and_schedule_new_programs() {
-    QSqlDatabase db = QSqlDatabase::database("xfb_connection");
-    // check the programs folder and get the name of the programs/folders
-
-    qDebug() << "Monitoring ProgramsPath var that is set to: " << ProgramsPath;
+void player::onScheduledEvent(const ScheduledEvent& event) {
+    TraceSpan span("player", "onScheduledEvent");
+    qCDebug(xfbScheduler) << "Scheduled event now fired (type" << int(event.rule.type) << ") at"
+                          << event.fireAt.toString();
 
-    QDirIterator folder_it(ProgramsPath, QStringList() << "*", QDir::Files);
-
-    while (folder_it.hasNext()) {
-        QString fit = folder_it.next();
-        qDebug() << "Folder Iterator fodler_it found the value: " << fit;
-
-        QStringList fit_array = fit.split("/");
-        QString fit_name = fit_array.last();
+    if (event.rule.path.isEmpty()) {
+        qCDebug(xfbScheduler) << "Scheduled event" << event.rule.itemId
+                              << "has no pub/program path, skipping";
+        return;
+    }
 
-        QStringList fit_array2 = fit_name.split("_");
+    QJsonObject fields{{"item", event.rule.itemId},
+                       {"kind", int(event.rule.type)},
+                       {"path", event.rule.path},
+                       {"due", EventJournal::formatTime(event.fireAt)}};
+    const QStringList adBreak = takeAdBreak(event);
+    if (!adBreak.isEmpty())
+        fields.insert("break", QJsonArray::fromStringList(adBreak));
+    // Proven when they go off air; the spots of the break are looked up by path
+    using Kind = ProofOfPlay::Kind;
+    const Kind kind = event.rule.isProgram ? Kind::Program : Kind::Pub;
+    playHistory->expectAiring({kind, event.rule.itemId, event.rule.path, event.fireAt});
+    for (const QString& spot : adBreak)
+        playHistory->expectAiring({Kind::Pub, -1, spot, event.fireAt});
+    const bool backTimed = backTimedQueued && backTimedAt == event.fireAt
+                           && backTimedRule == event.rule.rowId;
+    const bool cut = backTimedCut;
+    resetBackTiming();
+    backTimingRefresh->start();
+
+    // A back-timed event is on air or queued already, unless playback stopped meanwhile
+    const bool queued = playbackEngine->queuedSource() == event.rule.path;
+    if (backTimed && (queued || playbackEngine->currentSource() == event.rule.path)) {
+        if (cut && queued)
+            playbackEngine->skipToNext();
+        for (auto spot = adBreak.crbegin(); spot != adBreak.crend(); ++spot)
+            playlistQueue->prepend(*spot);
+        fields.insert("timing", cut ? "cut" : "segue");
+        eventJournal->record(EventJournal::Type::Scheduled, fields);
+        qCDebug(xfbScheduler) << "Back-timed event on air:" << event.rule.path;
+        return;
+    }
 
-        QString fit_prog_name = fit_array2[0];
+    for (auto spot = adBreak.crbegin(); spot != adBreak.crend(); ++spot)
+        playlistQueue->prepend(*spot);
+    playlistQueue->prepend(event.rule.path);
+    eventJournal->record(EventJournal::Type::Scheduled, fields);
+    qCDebug(xfbScheduler) << "Scheduled event added to the top of the playlist: "
+                          << event.rule.path;
+}
 
-        qDebug() << "NEW UPLOADED FILE FOUND: " << fit_prog_name;
+void player::applyAdBreaks() {
+    adBreaks->setCustomerSeparationMs(qint64(adSeparationMin) * 60 * 1000);
+    adBreaks->setMaxDailyPlays(adMaxDailyPlays);
+    planAdBreaks();
+}
 
-        QString mv2folder = ProgramsPath + "/" + fit_prog_name + "/" + fit_name;
+void player::planAdBreaks() {
+    adBreakPlan.clear();
+    if (!schedulerEngine || !adBreaks || adBreakSeconds <= 0)
+        return;
 
-        QDir dir;
+    // The pubs of the day ahead, packed together so the separation holds across them
+    const QDateTime now = QDateTime::currentDateTime();
+    QVector<AdBreakPacker::Slot> breaks;
+    QVector<ScheduledEvent> pubs;
+    for (const ScheduledEvent& event : schedulerEngine->upcomingEvents(now, now.addDays(1))) {
+        if (event.rule.isProgram || event.rule.path.isEmpty())
+            continue;
+        breaks.append({event.fireAt, qint64(adBreakSeconds) * 1000, event.rule.path});
+        pubs.append(event);
+    }
+    // Events come in time order, which packDay() keeps
+    const QVector<AdBreakPacker::Break> day = adBreaks->packDay(breaks);
+    for (int i = 0; i < day.size(); ++i)
+        adBreakPlan.insert({pubs[i].fireAt.toMSecsSinceEpoch(), pubs[i].rule.rowId},
+                           day[i].paths.mid(1));
+    qCDebug(xfbScheduler) << "Packed" << day.size() << "ad breaks for the day ahead";
+}
+
+QStringList player::takeAdBreak(const ScheduledEvent& event) {
+    if (event.rule.isProgram || adBreakSeconds <= 0)
+        return QStringList();
+    const QPair<qint64, qint64> key(event.fireAt.toMSecsSinceEpoch(), event.rule.rowId);
+    // The plan covers a day from when it was made
+    if (!adBreakPlan.contains(key))
+        planAdBreaks();
+    const QStringList rest = adBreakPlan.take(key);
+    adBreaks->markAired(event.fireAt, QStringList{event.rule.path} + rest);
+    return rest;
+}
+
+void player::setupBackTiming() {
+    backTimer = new BackTimer(playlistQueue, this);
+    backTimingRefresh = new QTimer(this);
+    backTimingRefresh->setSingleShot(true);
+    backTimingRefresh->setInterval(BACK_TIMING_REFRESH_MS);
+    connect(backTimingRefresh, &QTimer::timeout, this, &player::planBackTiming);
+    hardEventTimer = new QTimer(this);
+    hardEventTimer->setSingleShot(true);
+    connect(hardEventTimer, &QTimer::timeout, this, &player::queueBackTimedEvent);
+
+    const auto replan = [this]() { backTimingRefresh->start(); };
+    connect(playlistQueue, &PlaylistQueueModel::totalChanged, this, replan);
+    connect(playlistQueue, &QAbstractItemModel::rowsMoved, this, replan);
+    connect(playbackEngine, &PlaybackEngine::trackStarted, this, replan);
+    connect(playbackEngine, &PlaybackEngine::stateChanged, this, replan);
+}
+
+void player::resetBackTiming() {
+    hardEventTimer->stop();
+    backTimedAt = QDateTime();
+    backTimedRule = -1;
+    backTimedPath.clear();
+    backTimedCut = false;
+    backTimedNext = false;
+    backTimedQueued = false;
+}
+
+void player::planBackTiming() {
+    // An event on its way to air is kept to
+    if (backTimedQueued)
+        return;
+    resetBackTiming();
+    if (!schedulerEngine || PlayMode != "Playing_Segue"
+        || playbackEngine->state() == PlaybackEngine::State::Stopped)
+        return;
 
-        bool check = dir.rename(fit, mv2folder);
+    const QDateTime now = QDateTime::currentDateTime();
+    const QList<ScheduledEvent> upcoming =
+        schedulerEngine->upcomingEvents(now, now.addSecs(BACK_TIMING_HORIZON_S));
+    const auto event =
+        std::find_if(upcoming.cbegin(), upcoming.cend(), [&now](const ScheduledEvent& candidate) {
+            return !candidate.rule.path.isEmpty() && candidate.fireAt > now;
+        });
+    if (event == upcoming.cend())
+        return;
 
-        if (check == true) {
-            qDebug() << "Uploaded program was moved to " << mv2folder;
-        } else {
-            qDebug() << "There was an error moving the uploaded file to " << mv2folder;
-        }
+    backTimer->setOverlapMs(crossfadeMs);
+    const BackTimer::Plan plan = backTimer->plan(now, onAirRemainingMs(), event->fireAt);
+    if (plan.fillRow >= 0) {
+        // The move comes back here through the refresh, with what is left to fill
+        qCDebug(xfbScheduler) << "Back-timing moves" << playlistQueue->path(plan.fillRow)
+                              << "up before" << event->rule.path;
+        playlistQueue->move(plan.fillRow, plan.fitCount);
+        return;
     }
 
-    QDirIterator it(ProgramsPath, QStringList() << "*", QDir::Dirs, QDirIterator::Subdirectories);
-    while (it.hasNext()) {
-        QString dir = it.next();
-        QStringList lst = dir.split("/");
-        QString ls = lst.last();
-
-        if ((ls != ".") && (ls != "..")) {
-            qDebug() << ls;
+    switch (plan.ending) {
+    case BackTimer::Ending::Cut:
+        backTimedCut = true;
+        hardEventTimer->start(
+            int(qMax<qint64>(0, now.msecsTo(event->fireAt) - HARD_EVENT_PRELOAD_MS)));
+        break;
+    case BackTimer::Ending::OnTime:
+    case BackTimer::Ending::Early:
+        backTimedNext = plan.fitCount == 0;
+        break;
+    default:
+        // Not enough is known, or queued, to time it: it goes on top when due
+        return;
+    }
+    backTimedAt = event->fireAt;
+    backTimedRule = event->rule.rowId;
+    backTimedPath = event->rule.path;
+    qCDebug(xfbScheduler) << "Back-timed" << event->rule.path << "at"
+                          << plan.startsAt().toString() << "after" << plan.fitCount
+                          << "entries, ending" << int(plan.ending);
+}
 
-            // check every folder
+void player::queueBackTimedEvent() {
+    if (!backTimedCut || backTimedQueued || PlayMode != "Playing_Segue"
+        || playbackEngine->state() == PlaybackEngine::State::Stopped)
+        return;
 
-            qDebug() << "Looking for programs...";
-            QDirIterator fit(dir,
-                             QStringList() << "*.mp3"
-                                           << "*.mp4"
-                                           << "*.ogg"
-                                           << "*.wav"
-                                           << "*.flac",
-                             QDir::Files, QDirIterator::Subdirectories);
-            while (fit.hasNext()) {
-                QString file = fit.next();
+    // Pre-decoded on the other deck, to be faded in by onScheduledEvent() on the dot
+    requeueQueuedTrack();
+    playlistQueue->prepend(backTimedPath);
+    backTimedQueued = true;
+    playNextSong();
+    qCDebug(xfbScheduler) << "Back-timed event queued to cut in at" << backTimedAt.toString()
+                          << ":" << backTimedPath;
+}
+
+qint64 player::onAirRemainingMs() {
+    if (playbackEngine->state() == PlaybackEngine::State::Stopped)
+        return 0;
+    qint64 endMs = playbackEngine->duration();
+    if (endMs <= 0)
+        return -1;
+    const CuePoints cue = cuePoints ? cuePoints->cuePoints(playbackEngine->currentSource())
+                                    : CuePoints();
+    if (cue.outMs >= 0)
+        endMs = qMin(endMs, cue.outMs);
+    qint64 remainingMs = qMax<qint64>(0, endMs - playbackEngine->position());
+
+    // A track queued on the engine has already left the playlist
+    const QString queued = playbackEngine->queuedSource();
+    if (!queued.isEmpty()) {
+        const qint64 queuedUs = durationCache->durationUs(queued);
+        if (queuedUs < 0)
+            return -1;
+        const CuePoints queuedCue = cuePoints ? cuePoints->cuePoints(queued) : CuePoints();
+        qint64 queuedMs = queuedUs / 1000;
+        if (queuedCue.outMs >= 0)
+            queuedMs = qMin(queuedMs, queuedCue.outMs);
+        queuedMs -= qMax<qint64>(0, queuedCue.inMs);
+        remainingMs += qMax<qint64>(0, queuedMs - crossfadeMs);
+    }
+    return remainingMs;
+}
 
-                qDebug() << "Found: " << file;
+void player::on_actionOptions_triggered() {
+    if (!optionsDlg) {
+        optionsDlg = new optionsDialog(this);
+        optionsDlg->setModal(true);
+    } else {
+        optionsDlg->loadSettings();
+    }
+    optionsDlg->exec();
+    updateConfig();
+    update_music_table();
+}
 
-                // for every file in this folder check if it exist in DB
+void player::on_actionAbout_triggered() {
+    aboutUs ab;
+    ab.setModal(true);
+    ab.exec();
+}
 
-                QSqlQuery sql(db);
-                QString qry = "SELECT path from programs where path='" + file + "'";
+void player::on_actionAdd_a_song_from_Youtube_or_Other_triggered() {
+    // The music table follows downloads->tracksAdded, so the window may be closed at any time
+    externaldownloader* widget = new externaldownloader(downloads);
+    widget->setAttribute(Qt::WA_DeleteOnClose);
+    widget->show();
+}
 
-                if (sql.exec(qry)) {
-                    qDebug() << "Query ran fine: " << sql.lastQuery();
+void player::on_bt_search_clicked() {
+    qCDebug(xfbPlayer) << "Start a new search!";
+    setupTableModels();
+    searchController->searchNow(ui->txt_search->text());
+}
 
-                    QString ha = "default";
+void player::on_txt_search_textEdited(const QString& text) {
+    setupTableModels();
+    searchController->setText(text);
+}
 
-                    while (sql.next()) {
-                        ha = sql.value(0).toString();
+void player::on_bt_reset_clicked() {
+    setupTableModels();
+    musicsModel->setFilter("");
+    musicsModel->select();
+}
 
-                        qDebug() << "Query returned: " << ha;
-                    }
+void player::on_bt_apply_filter_clicked() {
+    // filter by genres
+    setupTableModels();
 
-                    if (ha == "default") {
-                        qDebug() << "Query didn't return any rows.. so adding it..";
-                        // add if if not
-
-                        QFileInfo info(file);
-                        QString filename(info.fileName());
-
-                        QSqlQuery sql_add(db);
-                        QString qry_add =
-                            "insert into programs values(NULL,'" + filename + "','" + file + "')";
-                        if (sql_add.exec(qry_add)) {
-                            qDebug() << "Query OK. Program localy added to programs table";
-
-                            // schelule it
-
-                            QSqlQuery qryid(db);
-                            QString thisqueryid =
-                                "select * from programs where path like '" + file + "'";
-                            qDebug() << "server programs monitorization :: Select id query is: "
-                                     << thisqueryid;
-                            if (qryid.exec(thisqueryid)) {
-                                while (qryid.next()) {
-                                    QString pID = qryid.value(0).toString();
-                                    qDebug() << "server programs monitorization :: Query OK. This "
-                                                "id is: "
-                                             << pID;
-
-                                    QStringList divide_filename = filename.split("_");
-                                    QString nomeDoPrograma = divide_filename[0];
-
-                                    QStringList divide_ext = divide_filename[1].split(".");
-                                    QString dataDoPrograma = divide_ext[0];
-
-                                    QStringList dataarr = dataDoPrograma.split("-");
-                                    QString pAno = dataarr[0];
-                                    QString pMes = dataarr[1];
-                                    QString pDia = dataarr[2];
-
-                                    if (!pAno.isEmpty() && !pMes.isEmpty() && !pDia.isEmpty()) {
-                                        QString qryhourmin =
-                                            "select hour, min from hourprograms where name like '" +
-                                            nomeDoPrograma + "'";
-
-                                        QSqlQuery qhm(db);
-
-                                        if (qhm.exec(qryhourmin)) {
-                                            QString def = "def";
-
-                                            while (qhm.next()) {
-                                                def = "not";
-                                                QString pHora = qhm.value(0).toString();
-                                                QString pMin = qhm.value(1).toString();
-
-                                                QSqlQuery addsch(db);
-                                                QString addstr =
-                                                    "insert into scheduler values ('" + pID +
-                                                    "','" + pAno + "','" + pMes + "','" + pDia +
-                                                    "','" + pHora + "','" + pMin +
-                                                    "','1',NULL,NULL,NULL,NULL,NULL,NULL,NULL,'1')";
-
-                                                if (addsch.exec(addstr)) {
-                                                    qDebug() << "server programs monitorization :: "
-                                                                "Program scheduled correctly.";
-                                                    qDebug() << nomeDoPrograma << " :: " << pAno
-                                                             << "-" << pMes << "-" << pDia << " at "
-                                                             << pHora << ":" << pMin;
-                                                } else {
-                                                    qDebug() << "server programs monitorization :: "
-                                                                "It was not possible to add "
-                                                                "program to scheduler: "
-                                                             << addsch.lastError();
-                                                }
-                                            }
-
-                                            if (def == "def") {
-                                                qDebug() << "The program " << nomeDoPrograma
-                                                         << " hasn't got an hour and minute "
-                                                            "extablished in the hourprograms table "
-                                                            "so XFB can't add it by itself..";
-                                            }
-
-                                        } else {
-                                            qDebug() << "server programs monitorization :: It was "
-                                                        "not possible to figure out the hour and "
-                                                        "minute for this program: "
-                                                     << nomeDoPrograma;
-                                            qDebug() << "server programs monitorization :: This "
-                                                        "should be in the 'hourprograms' table.";
-                                        }
-
-                                    } else {
-                                        qDebug()
-                                            << "server programs monitorization :: We got a program "
-                                               "but there was an error adding it beacuse one value "
-                                               "of the data is empty. Please check the programs "
-                                               "are named like 'name_YYYY-mm-dd.ogg'";
-                                    }
-                                }
-
-                            } else {
-                                qDebug() << "server programs monitorization :: Query was not ok "
-                                            "while atempting to get ID from the programs table"
-                                         << qryid.lastError();
-                            }
+    const bool g1_checked = ui->checkBox_filter_genre1->checkState();
+    const bool g2_checked = ui->checkBox_filter_genre2->checkState();
+    const QString selectedGenre1 = g1_checked ? ui->cBoxGenre1->currentText() : QString();
+    const QString selectedGenre2 = g2_checked ? ui->cBoxGenre2->currentText() : QString();
+    qCDebug(xfbPlayer) << "Genre filter:" << selectedGenre1 << ":" << selectedGenre2;
 
-                        } else {
-                            qDebug() << "Query was not ok while atempting to localy add to the "
-                                        "programs table: "
-                                     << sql_add.lastError();
-                        }
-                    }
+    if (!selectedGenre1.isEmpty() && musicRepository) {
+        const int songs = musicRepository->countMusicByGenre(selectedGenre1);
+        if (songs >= 0) {
+            qCDebug(xfbPlayer) << "This genre has " << songs << " songs";
 
-                } else {
-                    qDebug() << "Error running query: " << sql.lastError();
-                }
-            }
+            QString lbl = "The genre '" + selectedGenre1 + "' has " + QString::number(songs) +
+                          " songs";
+            ui->txt_bottom_info->setText(lbl);
         }
     }
 
-    // do the same for songs
-
-    qDebug() << "Monitoring MusicPath var that is set to: " << MusicPath;
+    // Bound equalities on the indexed genre columns, not a scan of the table
+    QVariantList values;
+    const QString condition =
+        musicRepository ? musicRepository->genreCondition(selectedGenre1, selectedGenre2, values)
+                        : QString();
+    if (!condition.isEmpty()) {
+        qCDebug(xfbPlayer) << "filtering the music table with the results...";
+        musicsModel->setFilter(condition, values);
+        musicsModel->select();
+    }
+}
 
-    qDebug() << "Looking for musics in the subdirectories of Music Path... [BUG FIX :: NOT LOOKING "
-                "BECAUSE IT HAS TO BE MOOVED TO ANOTHER THREAD FIST]";
-    /*
+/*
+void player::on_bt_youtubeDL_clicked()
+{
+    externaldownloader* widget = new externaldownloader;
+    widget->setAttribute(Qt::WA_DeleteOnClose);
 
-        QDirIterator mit(MusicPath,QStringList()<<"*", QDir::Dirs,QDirIterator::Subdirectories);
-        while(mit.hasNext()){
+    // Connect the musicAdded signal to update the music table
+    connect(widget, &externaldownloader::musicAdded, this, &player::update_music_table);
 
+    widget->show();
+}
+*/
+void player::on_actionSave_Playlist_triggered() {
+    qCDebug(xfbPlaylist) << "Saving the playlist...";
 
+    QString filename = QFileDialog::getSaveFileName(
+        this, "Save playlist", "../playlists/", tr("Playlists (*.m3u8);;XML playlists (*.xml)"));
+    if (filename.isEmpty())
+        return;
+    if (QFileInfo(filename).suffix().isEmpty())
+        filename += ".m3u8";
+    qCDebug(xfbPlaylist) << "saving " << filename;
+
+    std::vector<PlaylistFile::Track> tracks;
+    tracks.reserve(size_t(playlistQueue->count()));
+    for (int row = 0; row < playlistQueue->count(); ++row) {
+        const PlaylistQueueModel::Entry& entry = playlistQueue->entry(row);
+        if (entry.pending)
+            tracks.push_back({entry.path, -1, -1});
+        else
+            tracks.push_back({entry.path, entry.musicId, entry.durationUs});
+    }
+
+    QString error;
+    if (!PlaylistFile::save(filename, tracks, &error)) {
+        QMessageBox::warning(this, "Playlist not saved",
+                             tr("The playlist could not be saved: %1").arg(error));
+        return;
+    }
+    QMessageBox::information(this, "Playlist Saved", "The playlist was saved!");
+}
 
+void player::on_actionClear_Playlist_triggered() {
+    QMessageBox::StandardButton reply;
+    reply = QMessageBox::question(
+        this, "Sure?", "Are you sure? This will clear all tracks listed in the playlist.",
+        QMessageBox::Yes | QMessageBox::No);
+    if (reply == QMessageBox::Yes) {
+        playlistQueue->clear();
+    }
+}
 
-            QString dir = mit.next();
-            QStringList lst = dir.split("/");
-            QString ls = lst.last();
+void player::on_actionLoad_Playlist_triggered() {
+    const QString filename = QFileDialog::getOpenFileName(
+        this, "Load Playlist", "../playlists/", tr("Playlists (*.m3u8 *.m3u *.xml)"));
+    if (filename.isEmpty())
+        return;
 
+    QString error;
+    const std::vector<PlaylistFile::Track> tracks = PlaylistFile::load(filename, &error);
+    if (tracks.empty() && !error.isEmpty()) {
+        QMessageBox::information(this, "Bad input",
+                                 tr("There was an error importing the file: %1").arg(error));
+        return;
+    }
+    if (!error.isEmpty())
+        qCWarning(xfbPlaylist) << "Playlist" << filename << "read up to an error:" << error;
 
+    std::vector<PlaylistQueueModel::Entry> entries(tracks.size());
+    for (size_t i = 0; i < tracks.size(); ++i) {
+        entries[i].path = tracks[i].path;
+        entries[i].musicId = tracks[i].musicId;
+        entries[i].durationUs = tracks[i].durationUs;
+    }
+    qCDebug(xfbPlaylist) << "Loaded" << entries.size() << "tracks from" << filename;
+    playlistQueue->append(std::move(entries));
+}
 
-            if((ls!=".") && (ls!="..")){
-                qDebug() << "Processing: "<<dir;
+void player::on_actionGenerate_Day_Log_triggered() {
+    TraceSpan span("player", "generateDayLog");
+    QElapsedTimer timer;
+    timer.start();
 
-                qDebug()<<"Looking for musics...";
-                QDirIterator fmit(dir,QStringList()<<
-    "*.mp3"<<"*.mp4"<<"*.ogg"<<"*.wav"<<"*.flac",QDir::Files,QDirIterator::Subdirectories); while
-    (fmit.hasNext()){
+    QVector<DayLogGenerator::Track> songs;
+    if (const LibrarySnapshot::Ptr library = librarySnapshots->current()) {
+        songs.reserve(library->size());
+        for (int row = 0; row < library->size(); ++row)
+            songs.append({library->ids().at(row), library->path(row), library->artist(row),
+                          library->song(row), library->genre(row),
+                          library->durationsUs().at(row)});
+    } else {
+        musicRepository->forEachMusic([&songs](const MusicItem& music) {
+            songs.append({music.id, music.path, music.artist, music.song, music.genre1,
+                          DayLogGenerator::parseDuration(music.time)});
+            return true;
+        });
+    }
 
-                    QString file = fmit.next();
+    QVector<DayLogGenerator::Track> jingles;
+    for (const SpotPool::Spot& spot : jinglePool->spots()) {
+        DayLogGenerator::Track jingle;
+        jingle.path = spot.path;
+        jingle.durationUs = spot.durationUs;
+        jingles.append(jingle);
+    }
+
+    // The day starts where the queue ends
+    const QDateTime from =
+        QDateTime::currentDateTime().addMSecs(playlistQueue->totalAirTimeUs() / 1000);
+    const QDateTime to = from.addDays(1);
+
+    // The scheduler still airs its pubs and programs itself; the log only
+    // leaves their time free
+    QVector<DayLogGenerator::Break> breaks;
+    if (schedulerEngine) {
+        for (const ScheduledEvent& event : schedulerEngine->upcomingEvents(from, to))
+            breaks.append({event.fireAt, event.rule.path,
+                           durationCache->durationUs(event.rule.path), event.rule.isProgram});
+    }
+
+    const int jingleEvery = ui->checkBox_random_jingles->isChecked()
+                                ? ui->spinBox_random_jingles_interval->value()
+                                : 0;
+    DayLogGenerator generator;
+    generator.setRules({dayLogArtistSeparationMin, dayLogTitleSeparationMin});
+    generator.setLibrary(songs);
+    generator.setJingles(jingles);
+    const QVector<DayLogGenerator::Item> log = generator.generate(
+        from, to,
+        [this, jingleEvery](const QDateTime& hourStart) {
+            return DayLogGenerator::HourClock{hourGenreSchedule->genreAt(hourStart), jingleEvery};
+        },
+        breaks);
+
+    std::vector<PlaylistQueueModel::Entry> entries;
+    entries.reserve(size_t(log.size()));
+    for (const DayLogGenerator::Item& item : log) {
+        if (item.kind == DayLogGenerator::Kind::Pub || item.kind == DayLogGenerator::Kind::Program)
+            continue;
+        PlaylistQueueModel::Entry entry;
+        entry.path = item.path;
+        entry.musicId = item.musicId;
+        entry.durationUs = item.durationUs;
+        entries.push_back(entry);
+    }
+    if (entries.empty()) {
+        QMessageBox::information(this, "Day log", "There are no songs to make a day log from.");
+        return;
+    }
 
-                    qDebug()<<"Found: "<<file;
-
-
-
-                    //for every file in this folder check if it exist in DB
-
-
-
-                    QSqlQuery sql;
-                    QString qry = "SELECT path from musics where path='"+file+"'";
-
-                    if(sql.exec(qry)){
-                        qDebug()<<"Query ran fine: "<<sql.lastQuery();
-
-                        QString ha = "default";
-
-                        while(sql.next()){
-
-                            ha = sql.value(0).toString();
-
-                            qDebug()<<"Query returned: "<<ha;
-
-                        }
-
-                        if(ha=="default"){
-                            qDebug()<<"Query didn't return any rows ------------> So adding.. ";
-                            //add if if not
-
-
-
-
-
-
-                            QFileInfo info(file);
-                            QString filename(info.fileName());
-
-
-
-
-
-
-
-                            QString artist = filename;
-                            QString song = "";
-
-                            QStringList splitFileName = filename.split("-");
-                            if(splitFileName.count()>1){
-                                artist = splitFileName[0];
-                                song = splitFileName[1];
-                            }
-
-
-                            QStringList genre_split = dir.split("/");
-
-
-                            QString genre = genre_split.last();
-
-                            qDebug()<<"------------------>>>>>>>>>>>>>>>>>>>>  GENRE: "<<genre;
-
-
-                            QString g1 = genre, g2 = genre;
-
-                            QString country = "Other country / language";
-
-                            QString pub_date = "2016/01/01";
-
-
-
-                            QProcess cmd;
-                            QString time;
-                            QString cmdtmpstr = "exiftool \""+file+"\" | grep Duration";
-                            cmd.start("sh",QStringList()<<"-c"<<cmdtmpstr);
-                            cmd.waitForFinished();
-                            QString cmdOut = cmd.readAll();
-                            qDebug()<<"Output of exiftool: "<<cmdOut;
-                            cmd.close();
-
-                            QStringList arraycmd = cmdOut.split(" ");
-                            if(arraycmd.count()>25){
-                                QStringList splitarray = arraycmd[25].split("\n");
-                                qDebug()<<"Total track time is: "<<splitarray[0];
-                                time = splitarray[0];
-
-                            } else {
-                                qDebug()<<"-------------->>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> !!!!!!!! An
-    exception happend !? ... outputing details of this track: "; for(int
-    i=0;i<arraycmd.count();i++){ qDebug()<< "The array position "<<i<<" has: "<<arraycmd[i];
-                                   }
-
-                               }
-
-                            QSqlQuery sql_add;
-                            int played = 0;
-                            QString last = "-";
-                            QString qry_add = "insert into musics
-    values(NULL,'"+artist+"','"+song+"','"+g1+"','"+g2+"','"+country+"','"+pub_date+"','"+file+"','"+time+"','"+played+"','"+last+"')";
-                            if(sql_add.exec(qry_add)){
-                                qDebug()<<"Query OK. Music localy added to musics table ::
-    "<<sql_add.lastQuery();
-
-
-                            } else {
-                                 qDebug()<<"Query was not ok while atempting to localy add to the
-    musics table: "<<sql_add.lastError();
-                            }
-
-
-                        }
-
-
-                    } else {
-                         qDebug()<<"Error running query: "<<sql.lastError();
-                    }
-
-
-
-
-    }
-
-
-
-
-                }
-
-
-
-
-
-
-
-
-            }
-    */
-
-    qDebug() << "Looking for musics on the root folder... [BUG FIX :: NOT LOOKING BECAUSE IT HAS "
-                "TO BE MOOVED TO ANOTHER THREAD FIST]";
-    /*
-    QDirIterator rfmit(MusicPath,QStringList()<<
-"*.mp3"<<"*.mp4"<<"*.ogg"<<"*.wav"<<"*.flac",QDir::Files); while (rfmit.hasNext()){
-
-        QString file = rfmit.next();
-
-        qDebug()<<"Found: "<<file;
-
-
-
-        //for every file in this folder check if it exist in DB
-
-
-
-        QSqlQuery sql;
-        QString qry = "SELECT path from musics where path='"+file+"'";
-
-        if(sql.exec(qry)){
-            qDebug()<<"Query ran fine: "<<sql.lastQuery();
-
-            QString ha = "default";
-
-            while(sql.next()){
-
-                ha = sql.value(0).toString();
-
-                qDebug()<<"Query returned: "<<ha;
-
-            }
-
-            if(ha=="default"){
-                qDebug()<<"Query didn't return any rows";
-                //add if if not
-
-
-
-
-
-
-                QFileInfo info(file);
-                QString filename(info.fileName());
-
-
-
-
-
-
-
-                QString artist = filename;
-                QString song = "";
-
-                QStringList splitFileName = filename.split("-");
-                if(splitFileName.count()>1){
-                    artist = splitFileName[0];
-                    song = splitFileName[1];
-                }
-
-
-                QString g1 = "Pop", g2 = "Pop";
-
-                QString country = "Other country / language";
-
-                QString pub_date = "2016/01/01";
-
-
-
-                QProcess cmd;
-                QString time;
-                QString cmdtmpstr = "exiftool \""+file+"\" | grep Duration";
-                cmd.start("sh",QStringList()<<"-c"<<cmdtmpstr);
-                cmd.waitForFinished();
-                QString cmdOut = cmd.readAll();
-                qDebug()<<"Output of exiftool: "<<cmdOut;
-                cmd.close();
-
-                QStringList arraycmd = cmdOut.split(" ");
-                if(arraycmd.count()>25){
-                    QStringList splitarray = arraycmd[25].split("\n");
-                    qDebug()<<"Total track time is: "<<splitarray[0];
-                    time = splitarray[0];
-
-                } else {
-                    qDebug()<<"-------------->>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>     !!!!!!!!    An
-exception happend !? ... outputing details of this track: "; for(int i=0;i<arraycmd.count();i++){
-                        qDebug()<< "The array position "<<i<<" has: "<<arraycmd[i];
-                       }
-
-                   }
-
-
-                QSqlQuery sql_add;
-                int played = 0;
-                QString last = "-";
-                QString qry_add = "insert into musics
-values(NULL,'"+artist+"','"+song+"','"+g1+"','"+g2+"','"+country+"','"+pub_date+"','"+file+"','"+time+"','"+played+"','"+last+"')";
-                if(sql_add.exec(qry_add)){
-                    qDebug()<<"Query OK. Music localy added to musics table ::
-"<<sql_add.lastQuery();
-
-
-                } else {
-                     qDebug()<<"Query was not ok while atempting to localy add to the musics table:
-"<<sql_add.lastError();
-                }
-
-
-            }
-
-
-        } else {
-             qDebug()<<"Error running query: "<<sql.lastError();
-        }
-
-
-
-
-}
-
-
-
-
-
-*/
-
-    // do the same for jingles?
-
-    update_music_table();
-}
-
-void player::server_ftp_check() {
-    QSqlDatabase db = QSqlDatabase::database("xfb_connection");
-    qDebug() << "server_ftp_check() :: Looking for new programs in the FTP server to download";
-    QProcess sh, sh2, sh3;
-    QByteArray output, output2;
-    QString outPath, FTPCmdPath, xmls;
-
-    sh.start("sh", QStringList() << "-c"
-                                 << "pwd");
-    sh.waitForFinished(-1);
-    output = sh.readAll();
-    outPath = output;
-    QStringList path_arry = outPath.split("\n");
-    FTPCmdPath = path_arry[0] + "/usr/share/xfb/scripts/serverFtpCmdsGetPrograms";
-    qDebug() << "server_ftp_check() :: running: " << FTPCmdPath;
-    qDebug()
-        << "server_ftp_check() :: !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!   -> If "
-           "you get errors: cd config && chmod +x serverFtpCmdsGetPrograms && chmod 600 ~/.netrc  "
-           "<- !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!";
-    sh.close();
-
-    sh2.start("sh", QStringList() << "-c" << FTPCmdPath);
-    sh2.waitForFinished(-1);
-    output2 = sh2.readAll();
-    xmls = output2;
-    qDebug() << output2;
-    sh2.close();
-
-    QString mvcmdstr = "ls *.ogg && mv *.ogg " + ProgramsPath;
-
-    qDebug() << "server_ftp_check() :: Running: " << mvcmdstr;
-
-    sh3.start("sh", QStringList() << "-c" << mvcmdstr);
-    sh3.waitForFinished(-1);
-    QString sh3Out = sh3.readAll();
-    QStringList filearr = sh3Out.split("\n");
-
-    for (int i = 0; i < filearr.length(); i++) {
-        QString fileName = filearr[i];
-
-        qDebug() << "server_ftp_check() :: Found this one to add:" << fileName;
-
-        if (!fileName.isEmpty()) {
-            QString fileNameWPath = ProgramsPath + "/" + fileName;
-
-            QStringList splitstr = fileName.split("_");
-            QString nomeDoPrograma = splitstr[0];
-
-            QString splitstr2 = splitstr[1];
-            QStringList split2 = splitstr2.split(".");
-            QString dataDoPrograma = split2[0];
-
-            qDebug() << "server_ftp_check() :: This programs name is: " << nomeDoPrograma;
-            qDebug() << "server_ftp_check() :: The programs date is: " << dataDoPrograma;
-
-            QSqlQuery qry(db);
-            QString thisquery = "insert into programs values(NULL,'" + nomeDoPrograma + "','" +
-                                fileNameWPath + "')";
-            if (qry.exec(thisquery)) {
-                qDebug() << "server_ftp_check() :: Query OK. Program added to programs table";
-            } else {
-                qDebug() << "server_ftp_check() :: Query was not ok while atempting to add to the "
-                            "programs table";
-            }
-
-            QSqlQuery qryid(db);
-            QString thisqueryid = "select * from programs where path like '" + fileNameWPath + "'";
-            qDebug() << "server_ftp_check() :: Select id query is: " << thisqueryid;
-            if (qryid.exec(thisqueryid)) {
-                while (qryid.next()) {
-                    QString pID = qryid.value(0).toString();
-                    qDebug() << "server_ftp_check() :: Query OK. This id is: " << pID;
-
-                    QStringList dataarr = dataDoPrograma.split("-");
-                    QString pAno = dataarr[0];
-                    QString pMes = dataarr[1];
-                    QString pDia = dataarr[2];
-
-                    if (!pAno.isEmpty() && !pMes.isEmpty() && !pDia.isEmpty()) {
-                        QString qryhourmin =
-                            "select hour, min from hourprograms where name like '" +
-                            nomeDoPrograma + "'";
-
-                        QSqlQuery qhm(db);
-
-                        if (qhm.exec(qryhourmin)) {
-                            while (qhm.next()) {
-                                QString pHora = qhm.value(0).toString();
-                                QString pMin = qhm.value(1).toString();
-
-                                QSqlQuery addsch(db);
-                                QString addstr = "insert into scheduler values ('" + pID + "','" +
-                                                 pAno + "','" + pMes + "','" + pDia + "','" +
-                                                 pHora + "','" + pMin +
-                                                 "','1',NULL,NULL,NULL,NULL,NULL,NULL,NULL,'1')";
-
-                                if (addsch.exec(addstr)) {
-                                    qDebug()
-                                        << "server_ftp_check() :: Program scheduled correctly.";
-                                    qDebug() << nomeDoPrograma << " :: " << pAno << "-" << pMes
-                                             << "-" << pDia << " at " << pHora << ":" << pMin;
-                                } else {
-                                    qDebug() << "server_ftp_check() :: It was not possible to add "
-                                                "program to scheduler: "
-                                             << addsch.lastError();
-                                }
-                            }
-
-                        } else {
-                            qDebug() << "server_ftp_check() :: It was not possible to figure out "
-                                        "the hour and minute for this program: "
-                                     << nomeDoPrograma;
-                            qDebug() << "server_ftp_check() :: This should be in the "
-                                        "'hourprograms' table.";
-                        }
-
-                    } else {
-                        qDebug() << "server_ftp_check() :: We got a program but there was an error "
-                                    "adding it beacuse one value of the data is empty. Please "
-                                    "check the programs are named like 'name_YYYY-mm-dd.ogg'";
-                    }
-                }
-
-            } else {
-                qDebug() << "server_ftp_check() :: Query was not ok while atempting to get ID from "
-                            "the programs table"
-                         << qryid.lastError();
-            }
-
-        } else {
-            qDebug() << "server_ftp_check() :: SERVER: Finished looking for programs on the FTP";
-        }
-    }
-}
-
-void player::rmConfirmTakeOver() {
-    QString rmthis = TakeOverPath + "/confirmtakeover.xml";
-    QFile::remove(rmthis);
-}
-
-void player::returnTakeOver() {
-    QFile::remove("/usr/share/xfb/ftp/takeover.xml");
-
-    QString takeOverFile = "/usr/share/xfb/ftp/returntakeover.xml";
-    QFile file(takeOverFile);
-
-    if (returntakeOver == false) {
-        returntakeOver = true;
-
-        file.open(QIODevice::WriteOnly);
-        QXmlStreamWriter xmlWriter(&file);
-        xmlWriter.setAutoFormatting(true);
-        xmlWriter.writeStartDocument();
-
-        xmlWriter.writeStartElement("XFBClientTakeOver");
-        xmlWriter.writeStartElement("www.netpack.pt");
-        QString ip = ui->lbl_ddns->text();
-
-        xmlWriter.writeTextElement("ip", ip);
-        xmlWriter.writeTextElement("cmd", "returnTakeOver");
-
-        xmlWriter.writeEndElement();
-        xmlWriter.writeEndDocument();
-        file.close();
-
-        qDebug() << "Sending returntakeOver to server. This requires ~/.netrc to be configured "
-                    "with the ftp options and FTP Path in the options to point to a folder called "
-                    "'ftp' that MUST be located in the parent directory of XFB (due to the code of "
-                    "config/serverFtpCmdsPutTakeOver.sh).";
-
-        QProcess sh, sh2;
-        QByteArray output, output2;
-        QString outPath, FTPCmdPath, xmls;
-
-        sh.start("sh", QStringList() << "-c"
-                                     << "pwd");
-        sh.waitForFinished();
-        output = sh.readAll();
-        outPath = output;
-        QStringList path_arry = outPath.split("\n");
-        FTPCmdPath =
-            path_arry[0] +
-            "/usr/share/xfb/scripts/serverFtpCmdsPutTakeOver.sh | grep 'Transfer complete'";
-        qDebug() << "running: " << FTPCmdPath;
-        qDebug() << "If you get errors: cd config && chmod +x serverFtpCmdsPutTakeOver.sh && chmod "
-                    "600 ~/.netrc (the ftp is configured in .netrc correct?)";
-        sh.close();
-
-        sh2.start("sh", QStringList() << "-c" << FTPCmdPath);
-        sh2.waitForFinished(-1);
-        output2 = sh2.readAll().trimmed();
-        xmls = output2;
-        qDebug() << "The output of serverFtpCmdsPutTakeOver.sh is:\n" << output2;
-        sh2.close();
-
-        if (output2 == "226 Transfer complete.") {
-            ui->bt_takeOver->setStyleSheet("");
-            ui->bt_takeOver->setText(tr("Broadcast LIVE"));
-
-            ui->txt_ProgramName->setStyleSheet("background-color:#FFE329;padding:5px;");
-            ui->txt_ProgramName->hide();
-
-            piscaLive = false;
-
-            QFile::remove("/usr/share/xfb/ftp/takeover.xml");
-        }
-
-    } else {
-        returntakeOver = false;
-        QFile::remove(takeOverFile);
-        ui->bt_takeOver->setStyleSheet("");
-        ui->bt_takeOver->setText(tr("Broadcast LIVE"));
-
-        ui->txt_ProgramName->setStyleSheet("background-color:#FFE329;padding:5px;");
-        ui->txt_ProgramName->hide();
-
-        piscaLive = false;
-    }
-}
-
-void player::stopMplayer() {
-    QProcess kb;
-    kb.startDetached("sh", QStringList() << "-c"
-                                         << "killall mplayer");
-    kb.waitForFinished();
-
-    qDebug() << "All instances of mplayer were closed";
-}
-
-void player::run_scheduler() {
-    QSqlDatabase db = QSqlDatabase::database("xfb_connection");
-    checkDbOpen();
-
-    /*check if there is any thing to go on now*/
-
-    qDebug() << "\nThe scheduller is now monitoring the database (the scheduler table) to check if "
-                "there is something to go on at "
-             << QDateTime::currentDateTime().toString() << "\n";
-
-    QSqlQuery sched_qry(db);
-    sched_qry.prepare("select * from scheduler");
-    if (sched_qry.exec()) {
-        while (sched_qry.next()) {
-            QString tipo = sched_qry.value(6).toString();
-            // qDebug() << "Scheduler got a type "<<tipo<<" event rule.";
-
-            /*
-             *
-             * Var tipo determines the type of shedule
-             * 1 = an event to be played only once at a specific minute in time
-             *
-             * 2 = an event to be played every specific day of the week at a specific hour/min
-             *
-             * */
-
-            if (tipo == "1") {
-                QDateTime now = QDateTime::currentDateTime();
-
-                QString ano1 = now.toString("yyyy");
-                QString mes1 = now.toString("M");
-                QString dia1 = now.toString("d");
-                QString hora1 = now.toString("h");
-                QString min1 = now.toString("m");
-
-                QString ano2 = sched_qry.value(1).toString();
-                QString mes2 = sched_qry.value(2).toString();
-                QString dia2 = sched_qry.value(3).toString();
-                QString hora2 = sched_qry.value(4).toString();
-                QString min2 = sched_qry.value(5).toString();
-
-                QString is_program = sched_qry.value(14).toString();
-
-                /*
-                qDebug()<<"Scheduler is comparing values: ";
-                qDebug()<<ano1<<" should be equal to "<<ano2<<" -> ano";
-                qDebug()<<mes1<<" should be equal to "<<mes2<<" -> mes";
-                qDebug()<<dia1<<" should be equal to "<<dia2<<" -> dia";
-                qDebug()<<hora1<<" should be equal to "<<hora2<<" -> hora";
-                qDebug()<<min1<<" should be equal to "<<min2<<" -> minuto";
-                 */
-
-                // if agora values == este qry values
-                if ((ano1 == ano2) && (mes1 == mes2) && (dia1 == dia2) && (hora1 == hora2) &&
-                    (min1 == min2)) {
-                    qDebug() << "Scheduled event now fired (type 1)!";
-
-                    QString schId = sched_qry.value(0).toString();
-
-                    // add to playlist
-                    QSqlQuery getPath(db);
-                    if (is_program == "1") {
-                        getPath.prepare("select path from programs where id='" + schId + "'");
-                    } else {
-                        getPath.prepare("select path from pub where id='" + schId + "'");
-                    }
-
-                    if (getPath.exec()) {
-                        while (getPath.next()) {
-                            QString pubPath = getPath.value(0).toString();
-                            ui->playlist->insertItem(0, pubPath);
-                            qDebug()
-                                << "Scheduled event added to the top of the playlist: " << pubPath;
-                        }
-                    }
-
-                    // delete scheduler row cause its a type 1
-
-                    QSqlQuery del_qry(db);
-                    del_qry.prepare("delete from scheduler where id='" + schId + "' and ano='" +
-                                    ano1 + "' and mes='" + mes1 + "' and dia='" + dia1 +
-                                    "' and ano='" + ano1 + "' and hora='" + hora1 + "' and min='" +
-                                    min1 + "'");
-                    if (del_qry.exec()) {
-                        qDebug() << "Scheduled rule was deleted!";
-                    } else {
-                        qDebug() << "exeption deleting scheduled rule with qry: "
-                                 << del_qry.lastQuery() << " we got: " << del_qry.lastError();
-                    }
-
-                    // check if pub still has other scheduler rules and delete from pub if not
-                    QSqlQuery sq(db);
-                    sq.prepare("select count(id) from scheduler where id='" + schId + "'");
-                    if (sq.exec()) {
-                        while (sq.next()) {
-                            qDebug() << "We have a total of " << sq.value(0).toString()
-                                     << " records in the scheduler table with the schId " << schId;
-                            if (sq.value(0).toString() == "0") {
-                                // we can delete it from pub cause no more scheduled rules apply
-
-                                QSqlQuery sd(db);
-                                sd.prepare("delete from pub where id='" + schId + "'");
-                                if (sd.exec()) {
-                                    qDebug() << "Pub rule was deleted!";
-                                    update_music_table();
-                                } else {
-                                    qDebug() << "exeption deleting pub rule with qry: "
-                                             << del_qry.lastQuery()
-                                             << " we got: " << del_qry.lastError();
-                                }
-                            }
-                        }
-                    }
-                }
-            }
-
-            if (tipo == "2") {
-                int dia = QDate::currentDate().dayOfWeek();
-
-                QString dw;
-                if (dia == 1)
-                    dw = "Monday";
-                if (dia == 2)
-                    dw = "Tuesday";
-                if (dia == 3)
-                    dw = "Wednesday";
-                if (dia == 4)
-                    dw = "Thursday";
-                if (dia == 5)
-                    dw = "Friday";
-                if (dia == 6)
-                    dw = "Saturday";
-                if (dia == 7)
-                    dw = "Sunday";
-
-                // qDebug()<<"Today it's "<< dw << "!";
-
-                QString is_program = sched_qry.value(14).toString();
-
-                QDateTime now = QDateTime::currentDateTime();
-
-                QString hora1 = now.toString("h");
-                QString min1 = now.toString("m");
-
-                QString dw2 = sched_qry.value(7).toString();
-                QString hora2 = sched_qry.value(4).toString();
-                QString min2 = sched_qry.value(5).toString();
-
-                // so:
-                //
-                // dw has today's day of the week
-                // hora1 has the current hour
-                // min1 has the current minute
-                // dw2 has the scheduled day of the week
-                // hora2 has the scheduled hour
-                // min2 has the scheduled minute
-                //
-                //  /////////////// //
-
-                if ((dw == dw2) && (hora1 == hora2) && (min1 == min2)) {
-                    qDebug() << "Scheduled event now fired (type 2)!";
-                    QString schId = sched_qry.value(0).toString();
-
-                    // add to playlist
-                    QSqlQuery getPath(db);
-                    if (is_program == "1") {
-                        getPath.prepare("select path from programs where id='" + schId + "'");
-                    } else {
-                        getPath.prepare("select path from pub where id='" + schId + "'");
-                    }
-
-                    if (getPath.exec()) {
-                        while (getPath.next()) {
-                            QString pubPath = getPath.value(0).toString();
-                            ui->playlist->insertItem(0, pubPath);
-                            qDebug()
-                                << "Scheduled event added to the top of the playlist: " << pubPath;
-                        }
-                    }
-                }
-            }
-        }
-    }
-}
-
-void player::on_actionOptions_triggered() {
-    optionsDialog opt;
-    opt.setModal(true);
-    opt.exec();
-    update_music_table();
-}
-
-void player::on_actionAbout_triggered() {
-    aboutUs ab;
-    ab.setModal(true);
-    ab.exec();
-}
-
-void player::on_actionAdd_a_song_from_Youtube_or_Other_triggered() {
-    externaldownloader* widget = new externaldownloader;
-    widget->setAttribute(Qt::WA_DeleteOnClose);
-
-    // Connect the musicAdded signal to update the music table
-    connect(widget, &externaldownloader::musicAdded, this, &player::update_music_table);
-
-    widget->show();
-}
-
-void player::on_bt_search_clicked() {
-    qDebug() << "Start a new search!";
-    QString term = ui->txt_search->text().trimmed();
-
-    QSqlTableModel* m = qobject_cast<QSqlTableModel*>(ui->musicView->model());
-    if (!m) {
-        // If the current model is not a QSqlTableModel restore it
-        checkDbOpen();
-        QSqlDatabase db = QSqlDatabase::database("xfb_connection");
-        m = new QSqlTableModel(this, db);
-        m->setTable("musics");
-        ui->musicView->setModel(m);
-    }
-
-    if (term.isEmpty()) {
-        m->setFilter("");
-    } else {
-        // Escape single quotes to prevent SQL syntax errors
-        QString escapedTerm = term;
-        escapedTerm.replace("'", "''");
-
-        // Correctly format the filter string.
-        // We use '%%%1%%' where '%%' becomes literal '%' and '%1' is the placeholder.
-        QString filterString =
-            QString("artist LIKE '%%%1%%' OR song LIKE '%%%1%%'").arg(escapedTerm);
-        m->setFilter(filterString);
-    }
-
-    m->select();
-
-    ui->musicView->setSortingEnabled(true);
-    ui->musicView->hideColumn(0);
-    ui->musicView->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
-    ui->musicView->setColumnWidth(1, 150);
-    ui->musicView->setColumnWidth(2, 150);
-    ui->musicView->setColumnWidth(3, 80);
-    ui->musicView->setColumnWidth(4, 80);
-    ui->musicView->setColumnWidth(5, 60);
-    ui->musicView->setColumnWidth(6, 100);
-    ui->musicView->setColumnWidth(7, 300);
-    ui->musicView->setColumnWidth(8, 50);
-    ui->musicView->setColumnWidth(9, 80);
-    ui->musicView->setColumnWidth(10, 100);
-}
-
-void player::on_bt_reset_clicked() {
-    QSqlQueryModel* modelo = new QSqlQueryModel();
-    modelo->setQuery("select * from musics");
-    ui->musicView->setModel(modelo);
-}
-
-void player::on_bt_apply_filter_clicked() {
-    // filter by genres
-
-    QSqlDatabase db = QSqlDatabase::database("xfb_connection");
-    QString addG1 = "";
-    QString addG2 = "";
-
-    bool g1_checked = ui->checkBox_filter_genre1->checkState(); // true or false
-    bool g2_checked = ui->checkBox_filter_genre2->checkState();
-
-    qDebug() << "132426032015 " << g1_checked << " : " << g2_checked;
-
-    if (g1_checked == true) {
-        qDebug() << "g1 is checked";
-        QString selectedGenre1 = ui->cBoxGenre1->currentText();
-        addG1 = " genre1='" + selectedGenre1 + "' ";
-
-        QSqlQuery sql(db);
-        QString qry = "select count(*) from musics where genre1 like '" + selectedGenre1 + "'";
-
-        if (sql.exec(qry)) {
-            qDebug() << "Query ran fine: " << sql.lastQuery();
-
-            while (sql.next()) {
-                QString num_of_songs_with_this_genre = sql.value(0).toString();
-
-                qDebug() << "This genre has " << num_of_songs_with_this_genre << " songs";
-
-                QString lbl = "The genre '" + selectedGenre1 + "' has " +
-                              num_of_songs_with_this_genre + " songs";
-                ui->txt_bottom_info->setText(lbl);
-            }
-        }
-    }
-    if (g2_checked == true) {
-        qDebug() << "g2 is checked";
-        QString selectedGenre2 = ui->cBoxGenre2->currentText();
-        if (g1_checked == true) {
-            qDebug() << "both are checked...";
-            addG2 = "and genre2='" + selectedGenre2 + "' ";
-        } else {
-            qDebug() << "Only g2 is checked";
-            addG2 = " genre2='" + selectedGenre2 + "' ";
-        }
-    }
-    qDebug() << "addG1 is " << addG1 << " and addG2 is " << addG2;
-    if (addG1 != "" || addG2 != "") {
-        qDebug() << "making a new table to show with the results...";
-        QSqlQueryModel* model = new QSqlQueryModel();
-        model->setQuery("select * from musics where " + addG1 + addG2);
-        ui->musicView->setModel(model);
-    }
-}
-
-void player::on_bt_updateTables_clicked() {
-    update_music_table();
-}
-/*
-void player::on_bt_youtubeDL_clicked()
-{
-    externaldownloader* widget = new externaldownloader;
-    widget->setAttribute(Qt::WA_DeleteOnClose);
-
-    // Connect the musicAdded signal to update the music table
-    connect(widget, &externaldownloader::musicAdded, this, &player::update_music_table);
-
-    widget->show();
-}
-*/
-void player::on_actionSave_Playlist_triggered() {
-    qDebug() << "Saving the playlist...";
-
-    QString filename =
-        QFileDialog::getSaveFileName(this, "Save playlist", "../playlists/", "XML files (*.xml)");
-
-    if (!filename.isEmpty()) {
-        qDebug() << "saving " << filename;
-
-        QStringList farray = filename.split(".");
-        if (farray.count() == 1) {
-            filename = filename + ".xml";
-        }
-
-        QFile file(filename);
-        file.open(QIODevice::WriteOnly);
-
-        QXmlStreamWriter xmlWriter(&file);
-        xmlWriter.setAutoFormatting(true);
-        xmlWriter.writeStartDocument();
-
-        xmlWriter.writeStartElement("XFBPlaylist");
-        xmlWriter.writeStartElement("www.netpack.pt");
-
-        // loop playlist and save every line into xml
-        int numItems = ui->playlist->count();
-        for (int i = 0; i < numItems; i++) {
-            // qDebug()<<"i is: "<<i;
-            QString txtItem = ui->playlist->item(i)->text();
-            qDebug() << "Xml adding file " << txtItem;
-
-            xmlWriter.writeTextElement("track", txtItem);
-        }
-
-        xmlWriter.writeEndElement();
-        xmlWriter.writeEndDocument();
-        file.close();
-        QMessageBox::information(this, "Playlist Saved", "The playlist was saved!");
-    }
-}
-
-void player::on_actionClear_Playlist_triggered() {
-    QMessageBox::StandardButton reply;
-    reply = QMessageBox::question(
-        this, "Sure?", "Are you sure? This will clear all tracks listed in the playlist.",
-        QMessageBox::Yes | QMessageBox::No);
-    if (reply == QMessageBox::Yes) {
-        ui->playlist->clear();
-        calculate_playlist_total_time();
-    }
-}
-
-void player::on_actionLoad_Playlist_triggered() {
-    QString filename = QFileDialog::getOpenFileName(this, "Load Playlist", "../playlists/",
-                                                    tr("Xml files(*.xml)"));
-    QFile file(filename);
-    if (!file.open(QFile::ReadOnly | QFile::Text)) {
-        QMessageBox::information(this, "Bad input",
-                                 "There was an error importing the file.. sorry.");
-    }
-
-    QXmlStreamReader Rxml;
-    Rxml.setDevice(&file);
-    Rxml.readNext();
-
-    while (!Rxml.atEnd()) {
-        if (Rxml.isStartElement()) {
-            if (Rxml.name() == QStringLiteral("XFBPlaylist")) {
-                qDebug() << "Valid XFB Playlist Found!";
-                Rxml.readNext();
-
-                if (Rxml.isEndElement() && Rxml.name() == QLatin1String("XFBPlaylist")) {
-                    qDebug() << "Found the last element of the XML file after StarElement, leaving "
-                                "the while loop";
-                    Rxml.readNext();
-                    break;
-                }
-
-            } else {
-                Rxml.raiseError(QObject::tr("Not an XFB playlist file"));
-            }
-        } else {
-            Rxml.readNext();
-
-            // qDebug()<<"This Rxml.name() is "<<Rxml.name();
-
-            if (Rxml.name() == QStringLiteral("www.netpack.pt")) {
-                qDebug() << "Token element: " << Rxml.name();
-                Rxml.readNext();
-            }
-
-            if (Rxml.name() == QStringLiteral("track")) {
-                QString track = Rxml.readElementText();
-                qDebug() << "Rxml.readElementText(): " << track;
-                ui->playlist->addItem(track);
-            }
-        }
-    }
-    file.close();
-}
+    qCInfo(xfbPlaylist) << "Day log from" << from.toString(Qt::ISODate) << "has" << entries.size()
+                        << "items," << generator.relaxedPicks()
+                        << "placed past the separation rules; made in" << timer.elapsed() << "ms";
+    playlistQueue->append(std::move(entries));
+}
 
 void player::on_bt_rec_clicked() {
     if (recMode == 0) {
@@ -4120,11 +4191,12 @@ void player::on_bt_rec_clicked() {
 
         // qDebug()<<"The current recording device is: "<<recDevice;
 
-        saveFile = SavePath + "/XFB.ogg";
+        aExtencaoDesteCoiso = recordingSuffix(recContainer);
+        saveFile = SavePath + "/XFB." + aExtencaoDesteCoiso;
 
-        qDebug() << "Removing old file..";
+        qCDebug(xfbPlayer) << "Removing old file..";
         QFile::remove(saveFile);
-        qDebug() << "Removed!";
+        qCDebug(xfbPlayer) << "Removed!";
 
         QTimer::singleShot(5000, this, SLOT(RectimerDone()));
         RecT5();
@@ -4137,11 +4209,11 @@ void player::on_bt_rec_clicked() {
 
     } else {
         recMode = 0;
-        qDebug() << "STOP RECORDING!";
+        qCDebug(xfbPlayer) << "STOP RECORDING!";
         ui->bt_rec->setStyleSheet("");
         ui->bt_pause_rec->setStyleSheet("");
         setRecTimeToDefaults();
-        audioRecorder->stop();
+        recorder->stop();
         ui->led_rec->hide();
         ui->bt_pause_rec->setEnabled(false);
         recPause = false;
@@ -4149,11 +4221,9 @@ void player::on_bt_rec_clicked() {
 }
 
 void player::RecCHK() {
-    QFile myFile(saveFile);
-
-    qDebug() << "File.size() is now: " << myFile.size();
+    qCDebug(xfbPlayer) << "Samples recorded so far: " << recorder->recordedSamples();
 
-    if (myFile.size() == 0) {
+    if (!recorder->isRecording() || recorder->recordedSamples() == 0) {
         // red
         ui->led_rec->setStyleSheet("background-color:#FF0010;border-radius:8px;");
     } else {
@@ -4188,7 +4258,7 @@ void player::RecT1() {
 }
 
 void player::RectimerDone() {
-    qDebug() << "RECORDING!";
+    qCDebug(xfbPlayer) << "RECORDING!";
     ui->bt_rec->setStyleSheet("background-color: rgb(245, 101, 101)");
 
     ui->bt_pause_rec->setEnabled(true);
@@ -4199,99 +4269,27 @@ void player::RectimerDone() {
 
     recTimer->start(1000);
 
-    qDebug() << "---> NEW Recording to: " << saveFile;
+    qCDebug(xfbPlayer) << "---> NEW Recording to: " << saveFile;
 
-    // Find the requested audio input device
-    const QList<QAudioDevice> inputDevices = QMediaDevices::audioInputs();
-    QAudioDevice selectedDevice;
+    // The input is shared with a live stream; the device applies if nothing captures yet
+    const QAudioDevice selectedDevice = audioInput(audioDevices, recDevice);
+    liveCapture->setDevice(selectedDevice);
+    qCDebug(xfbPlayer) << "Selecting this audio input device: " << selectedDevice.description();
 
-    for (const QAudioDevice& device : inputDevices) {
-        if (device.description() == recDevice) {
-            selectedDevice = device;
-            break;
-        }
-    }
+    if (recordReader < 0)
+        recordReader = liveCapture->openReader();
+    recorder->setReader(liveCapture->reader(recordReader), liveCapture->sampleRate(),
+                        LiveCapture::CHANNELS);
+    recorder->setCodec(recordingEncoder(recCodec));
 
-    if (selectedDevice.isNull()) {
-        // If the specific device wasn't found, use the default device
-        selectedDevice = QMediaDevices::defaultAudioInput();
-    }
-
-    // Set the audio input device
-    audioInput->setDevice(selectedDevice);
-    qDebug() << "Selecting this audio input device: " << selectedDevice.description();
-
-    // Configure media recorder settings
-    QMediaFormat format;
-
-    // Set container format
-    aExtencaoDesteCoiso = "ogg";
-
-    if (contentamento == "matroska") {
-        format.setFileFormat(QMediaFormat::FileFormat::Matroska);
-        aExtencaoDesteCoiso = "mp3";
-    } else if (contentamento == "ogg") {
-        format.setFileFormat(QMediaFormat::FileFormat::Ogg);
-        aExtencaoDesteCoiso = "ogg";
-    } else if (contentamento == "mp4") {
-        format.setFileFormat(QMediaFormat::FileFormat::MPEG4);
-        aExtencaoDesteCoiso = "mp4";
-    } else if (contentamento == "wav") {
-        format.setFileFormat(QMediaFormat::FileFormat::Wave);
-        aExtencaoDesteCoiso = "wav";
-    } else if (contentamento == "quicktime") {
-        format.setFileFormat(QMediaFormat::FileFormat::QuickTime);
-        aExtencaoDesteCoiso = "mov";
-    } else {
-        // Default to Ogg if format not recognized
-        format.setFileFormat(QMediaFormat::FileFormat::Ogg);
-        aExtencaoDesteCoiso = "ogg";
-    }
-
-    // Set audio codec (if needed)
-    if (!codec.isEmpty()) {
-        if (codec == "audio/vorbis") {
-            format.setAudioCodec(QMediaFormat::AudioCodec::Vorbis);
-        } else if (codec == "audio/opus") {
-            format.setAudioCodec(QMediaFormat::AudioCodec::Opus);
-        } else if (codec == "audio/mp3") {
-            format.setAudioCodec(QMediaFormat::AudioCodec::MP3);
-        } else if (codec == "audio/aac") {
-            format.setAudioCodec(QMediaFormat::AudioCodec::AAC);
-        }
+    if (recordReader < 0 || !recorder->start(saveFile)) {
+        liveCapture->closeReader(recordReader);
+        recordReader = -1;
+        QMessageBox::warning(this, tr("Recording Error"),
+                             tr("Recording could not be started. Check that ffmpeg is installed "
+                                "and the input device is available."));
     }
 
-    // Set quality
-    audioRecorder->setQuality(QMediaRecorder::HighQuality);
-    audioRecorder->setMediaFormat(format);
-    audioRecorder->setOutputLocation(QUrl::fromLocalFile(saveFile));
-
-    // Connect signals for recording state changes
-    connect(audioRecorder, &QMediaRecorder::recorderStateChanged, this,
-            [](QMediaRecorder::RecorderState state) {
-                if (state == QMediaRecorder::RecordingState) {
-                    qDebug() << "Recording state: Recording";
-                } else if (state == QMediaRecorder::PausedState) {
-                    qDebug() << "Recording state: Paused";
-                } else if (state == QMediaRecorder::StoppedState) {
-                    qDebug() << "Recording state: Stopped";
-                }
-            });
-
-    connect(audioRecorder, &QMediaRecorder::errorOccurred, this,
-            [this](QMediaRecorder::Error error, const QString& errorString) {
-                // Unused parameter 'error'
-                Q_UNUSED(error);
-
-                qDebug() << "Recording error: " << errorString;
-                QMessageBox::warning(this, tr("Recording Error"), errorString);
-            });
-
-    // Start recording
-    audioRecorder->record();
-
-    qDebug() << "Recording started with format: " << format.fileFormat();
-
     ui->bt_rec->show();
 }
 
@@ -4354,7 +4352,7 @@ void player::on_actionRecord_a_new_Program_triggered() {
                                                  "NAME_YYYY-MM-DD \nEx: program_2016-02-07\n\n"),
                                               QLineEdit::Normal, tr("Program_2016-02-07"), &ok);
     if (ok && !NomeDestePrograma.isEmpty()) {
-        qDebug() << "Program name is: " << NomeDestePrograma;
+        qCDebug(xfbPlayer) << "Program name is: " << NomeDestePrograma;
         ui->txt_ProgramName->setText(NomeDestePrograma);
         ui->txt_ProgramName->show();
         ui->bt_ProgramStopandProcess->show();
@@ -4368,13 +4366,17 @@ void player::on_bt_ProgramStopandProcess_clicked() {
     saveProgram = QMessageBox::question(this, tr("Save Program?"), tr("Save this program?"),
                                         QMessageBox::Yes | QMessageBox::No);
     if (saveProgram == QMessageBox::Yes) {
-        qDebug() << "Saving the program";
+        qCDebug(xfbPlayer) << "Saving the program";
 
         if (saveFile.isEmpty()) {
             QMessageBox::information(this, tr("No program set or recorded"),
                                      tr("There is no program set or recorded to send"));
+        } else if (recorder->isRecording() || recorder->isFinishing()) {
+            QMessageBox::information(this, tr("Recording not saved yet"),
+                                     tr("Stop the recording and wait a moment for it to be "
+                                        "saved before processing the program"));
         } else {
-            qDebug() << "Processing file: " << saveFile;
+            qCDebug(xfbPlayer) << "Processing file: " << saveFile;
 
             if (Role == "Client") {
                 ui->txt_uploadingPrograms->show();
@@ -4382,7 +4384,7 @@ void player::on_bt_ProgramStopandProcess_clicked() {
                 destinationProgram =
                     ProgramsPath + "/" + NomeDestePrograma + "." + aExtencaoDesteCoiso;
                 QString mvcmd = "cp " + saveFile + " " + destinationProgram;
-                qDebug() << "Running: " << mvcmd;
+                qCDebug(xfbPlayer) << "Running: " << mvcmd;
                 cmd.startDetached("sh", QStringList() << "-c" << mvcmd);
                 cmd.waitForFinished(-1);
                 cmd.close();
@@ -4395,12 +4397,12 @@ void player::on_bt_ProgramStopandProcess_clicked() {
                 if (sendToServer == QMessageBox::Yes) {
                     QString cp2ftp = "cp " + saveFile + " " + FTPPath + "/" + NomeDestePrograma +
                                      "." + aExtencaoDesteCoiso;
-                    qDebug() << "Running: " << cp2ftp;
+                    qCDebug(xfbPlayer) << "Running: " << cp2ftp;
                     cmd.startDetached("sh", QStringList() << "-c" << cp2ftp);
                     cmd.waitForFinished(-1);
                     cmd.close();
 
-                    qDebug()
+                    qCDebug(xfbPlayer)
                         << "Sending program to server. This requires ~/.netrc to be configured "
                            "with the ftp options and FTP Path in the options to point to a folder "
                            "called 'ftp' that MUST be located in the parent directory of XFB (due "
@@ -4418,8 +4420,8 @@ void player::on_bt_ProgramStopandProcess_clicked() {
                     QStringList path_arry = outPath.split("\n");
                     FTPCmdPath = path_arry[0] + "/usr/share/xfb/scripts/serverFtpCmdsPutProgram.sh "
                                                 "| grep 'Transfer complete'";
-                    qDebug() << "running: " << FTPCmdPath;
-                    qDebug()
+                    qCDebug(xfbPlayer) << "running: " << FTPCmdPath;
+                    qCDebug(xfbPlayer)
                         << "If you get errors: cd scripts && chmod +x serverFtpCmdsPutProgram.sh "
                            "&& chmod 600 ~/.netrc (the ftp is configured in .netrc correct?)";
                     sh.close();
@@ -4428,10 +4430,10 @@ void player::on_bt_ProgramStopandProcess_clicked() {
                     sh2.waitForFinished(-1);
                     output2 = sh2.readAll();
                     xmls = output2;
-                    qDebug() << output2;
+                    qCDebug(xfbPlayer) << output2;
                     sh2.close();
 
-                    qDebug() << "Program upload finished!";
+                    qCDebug(xfbPlayer) << "Program upload finished!";
 
                     QProcess bashDelThis;
                     QString fileToRemove = "rm " + FTPPath + "/" + NomeDestePrograma + ".ogg";
@@ -4439,7 +4441,7 @@ void player::on_bt_ProgramStopandProcess_clicked() {
                     bashDelThis.waitForFinished();
                     bashDelThis.close();
 
-                    qDebug() << "FTP temp file deleted";
+                    qCDebug(xfbPlayer) << "FTP temp file deleted";
 
                     QMessageBox::StandardButton answer;
                     answer = QMessageBox::question(this, tr("Delete local copy?"),
@@ -4459,13 +4461,16 @@ void player::on_bt_ProgramStopandProcess_clicked() {
 
                     } else {
                         QSqlQuery qry(db);
-                        QString thisquery = "insert into programs values(NULL,'" +
-                                            NomeDestePrograma + "','" + destinationProgram + "')";
-                        if (qry.exec(thisquery)) {
-                            qDebug() << "Query OK. Program localy added to programs table";
+                        qry.prepare("insert into programs values(NULL, ?, ?)");
+                        qry.addBindValue(NomeDestePrograma);
+                        qry.addBindValue(destinationProgram);
+                        if (qry.exec()) {
+                            qCDebug(xfbPlayer)
+                                << "Query OK. Program localy added to programs table";
                         } else {
-                            qDebug() << "Query was not ok while atempting to localy add to the "
-                                        "programs table";
+                            qCDebug(xfbPlayer)
+                                << "Query was not ok while atempting to localy add to the "
+                                   "programs table";
                         }
 
                         ui->txt_ProgramName->hide();
@@ -4489,7 +4494,7 @@ void player::on_bt_ProgramStopandProcess_clicked() {
         }
 
     } else {
-        qDebug() << "Sending program to server was cancelled";
+        qCDebug(xfbPlayer) << "Sending program to server was cancelled";
         ui->txt_ProgramName->hide();
         ui->bt_ProgramStopandProcess->hide();
     }
@@ -4497,6 +4502,7 @@ void player::on_bt_ProgramStopandProcess_clicked() {
 
 void player::on_actionAdd_a_program_triggered() {
     add_program addp;
+    addp.setSchedulerEngine(schedulerEngine);
     addp.setModal(true);
     addp.exec();
     update_music_table();
@@ -4513,9 +4519,28 @@ void player::on_actionFullScreen_triggered() {
 }
 
 void player::pingServer() {
-    QMessageBox::information(
-        this, tr("Ping Server"),
-        tr("Option not coded. Can you buy me a coffee? (Paypal: fred@netpack.pt ;))"));
+    QUrl serverUrl = QUrl::fromUserInput(Server_URL);
+    if (Server_URL.isEmpty() || serverUrl.host().isEmpty()) {
+        QMessageBox::warning(this, tr("Ping Server"),
+                             tr("No server is configured. Set the server URL in the options."));
+        return;
+    }
+
+    // Connect to the web server the configuration is fetched from
+    const quint16 port = serverUrl.port(serverUrl.scheme() == "https" ? 443 : 80);
+    qInfo() << "Probing server" << serverUrl.host() << ":" << port;
+    reachability->probeOnce(
+        serverUrl.host(), port, 5000,
+        [this, serverUrl, port](const ReachabilityMonitor::ProbeResult& result) {
+            const QString address = QString("%1:%2").arg(serverUrl.host()).arg(port);
+            if (result.reachable) {
+                QMessageBox::information(this, tr("Ping Server"),
+                                         tr("%1 answered in %2 ms.").arg(address).arg(result.rttMs));
+            } else {
+                QMessageBox::warning(this, tr("Ping Server"),
+                                     tr("%1 is not reachable: %2").arg(address, result.errorString));
+            }
+        });
 }
 
 void player::on_actionForce_an_FTP_Check_triggered() {
@@ -4523,88 +4548,51 @@ void player::on_actionForce_an_FTP_Check_triggered() {
 }
 
 void player::on_actionMake_a_program_from_this_playlist_triggered() {
-    QSqlDatabase db = QSqlDatabase::database("xfb_connection");
-    ui->txt_creatingPrograms->show();
-    qDebug() << "Running Make_a_program_with_the_current_playlist";
-
-    QString cmdcp;
-    cmdcp = "rm ../ProgramGenerator/*.ogg";
-    QProcess cmddelP;
-    cmddelP.start("sh", QStringList() << "-c" << cmdcp);
-    cmddelP.waitForFinished(-1);
-    cmddelP.close();
-    qDebug() << "temp files from ProgramGenerator folder removed";
-
-    cmdcp = "rm inputs.txt";
-    cmddelP.start("sh", QStringList() << "-c" << cmdcp);
-    cmddelP.waitForFinished(-1);
-    cmddelP.close();
-    qDebug() << "inputs.txt from bin forlder removed";
+    qCDebug(xfbPlayer) << "Running Make_a_program_with_the_current_playlist";
+    if (programBuilder->isRunning()) {
+        QMessageBox::information(this, tr("Program generator"),
+                                 tr("A program is already being created. Please wait for it to "
+                                    "finish."));
+        return;
+    }
 
     bool ok;
     NomeDestePrograma = QInputDialog::getText(0, tr("Program name"),
                                               tr("What is the program's name? \n\nFormat MUST be: "
                                                  "NAME_YYYY-MM-DD \nEx: program_2016-02-07\n\n"),
                                               QLineEdit::Normal, tr("Program_2016-02-07"), &ok);
-    if (ok && !NomeDestePrograma.isEmpty()) {
-        qDebug() << "Program name is: " << NomeDestePrograma;
+    if (!ok || NomeDestePrograma.isEmpty()) {
+        return;
     }
+    qCDebug(xfbPlayer) << "Program name is: " << NomeDestePrograma;
 
-    // get the curent items of the playlist
-    QString contatstr;
-    QString destino = ProgramsPath + "/" + NomeDestePrograma + ".ogg";
-    int numItems = ui->playlist->count();
-    for (int i = 0; i < numItems; i++) {
-        QString nome = "music" + QString::number(i) + ".ogg";
-        qDebug() << "NOME: " << nome;
-        qDebug() << "Processing " << i;
-        QString txtItem = ui->playlist->item(i)->text();
-        qDebug() << "Processing file " << txtItem;
-
-        QStringList array_ext_item = txtItem.split(".");
-        qDebug() << " ------------>>>>>>>>>>>>>>>>>>>> EXT :::::::::::::: "
-                 << array_ext_item.last();
-        if (array_ext_item.last() != "ogg") {
+    // The items are joined as they are, so every one of them must be Ogg
+    QStringList sources;
+    for (const QString& txtItem : playlistQueue->paths()) {
+        if (QFileInfo(txtItem).suffix().toLower() != "ogg") {
             QMessageBox::warning(
                 this, tr("File not in ogg..."),
                 "The file " + txtItem +
                     " is not in OGG and at this moment we can only concatenate the files if they "
                     "are.. please convert this file (or all?) to ogg for now... sorry :-( ");
-            ui->txt_creatingPrograms->hide();
             return;
-
-        } else {
-            QString cmdcp = "cp \"" + txtItem + "\" ../ProgramGenerator/" + nome;
-            qDebug() << ">> >> >> >> >> Adding audio: ";
-            qDebug() << cmdcp;
-            QProcess cmd;
-            cmd.start("sh", QStringList() << "-c" << cmdcp);
-            cmd.waitForFinished(-1);
-            cmd.close();
-
-            contatstr = "../ProgramGenerator/" + nome;
-            QProcess cmd34;
-            cmd34.start("sh", QStringList() << "-c"
-                                            << "echo \"file '" + contatstr + "'\" >> inputs.txt");
-            cmd34.waitForFinished(-1);
-            cmd34.close();
         }
+        sources << txtItem;
+    }
+    if (sources.isEmpty()) {
+        QMessageBox::information(this, tr("Program generator"), tr("The playlist is empty."));
+        return;
     }
-    QString cmdconcat = "ffmpeg -f concat -i inputs.txt " + destino;
-    qDebug() << ">> >> >> >> >> Concatenating audio.. the full command is: >> >> >> >> >> >>";
-    qDebug() << cmdconcat;
-    QProcess cmd;
-    cmd.start("sh", QStringList() << "-c" << cmdconcat);
-    cmd.waitForFinished(300000); // 600000 10 minutos
 
-    cmd.close();
-    ui->txt_creatingPrograms->hide();
-    QString cmddel = "rm ../ProgramGenerator/*.ogg";
-    qDebug() << ">> >> >> >> >> Removing tmp audio: ";
-    qDebug() << cmddel;
-    cmd.start("sh", QStringList() << "-c" << cmddel);
-    cmd.waitForFinished(-1);
-    cmd.close();
+    QString destino = ProgramsPath + "/" + NomeDestePrograma + ".ogg";
+    qInfo() << "Creating program" << destino << "from" << sources.size() << "items";
+    ui->txt_creatingPrograms->show();
+    programProgress->showProgress("Creating the program " + NomeDestePrograma, QString(), 0, 1000);
+    programBuilder->start(sources, destino);
+}
+
+void player::offerProgramUpload(const QString& programName, const QString& destino) {
+    QSqlDatabase db = QSqlDatabase::database("xfb_connection");
     ui->txt_uploadingPrograms->show();
 
     QMessageBox::StandardButton sendToServer;
@@ -4612,17 +4600,18 @@ void player::on_actionMake_a_program_from_this_playlist_triggered() {
         QMessageBox::question(this, tr("Send to server?"), tr("Send programs to the server?"),
                               QMessageBox::Yes | QMessageBox::No);
     if (sendToServer == QMessageBox::Yes) {
-        QString cp2ftp = "cp " + destino + " " + FTPPath + "/" + NomeDestePrograma + ".ogg";
-        qDebug() << "Running: " << cp2ftp;
+        QString cp2ftp = "cp " + destino + " " + FTPPath + "/" + programName + ".ogg";
+        qCDebug(xfbPlayer) << "Running: " << cp2ftp;
         QProcess cmd;
         cmd.startDetached("sh", QStringList() << "-c" << cp2ftp);
         cmd.waitForFinished(-1);
         cmd.close();
 
-        qDebug() << "Sending program to server. This requires ~/.netrc to be configured with the "
-                    "ftp options and FTP Path in the options to point to a folder called 'ftp' "
-                    "that MUST be located in the parent directory of XFB (due to the code of "
-                    "config/serverFtpCmdsPutProgram).";
+        qCDebug(xfbPlayer)
+            << "Sending program to server. This requires ~/.netrc to be configured with the "
+               "ftp options and FTP Path in the options to point to a folder called 'ftp' "
+               "that MUST be located in the parent directory of XFB (due to the code of "
+               "config/serverFtpCmdsPutProgram).";
         QProcess sh, sh2;
 
         QByteArray output, output2;
@@ -4635,17 +4624,18 @@ void player::on_actionMake_a_program_from_this_playlist_triggered() {
         QStringList path_arry = outPath.split("\n");
         FTPCmdPath = path_arry[0] +
                      "/usr/share/xfb/scripts/serverFtpCmdsPutProgram.sh | grep 'Transfer complete'";
-        qDebug() << "running: " << FTPCmdPath;
-        qDebug() << "If you get errors: cd config && chmod +x serverFtpCmdsPutProgram.sh && chmod "
-                    "600 ~/.netrc (the ftp is configured in .netrc correct?)";
+        qCDebug(xfbPlayer) << "running: " << FTPCmdPath;
+        qCDebug(xfbPlayer)
+            << "If you get errors: cd config && chmod +x serverFtpCmdsPutProgram.sh && chmod "
+               "600 ~/.netrc (the ftp is configured in .netrc correct?)";
         sh.close();
         sh2.start("sh", QStringList() << "-c" << FTPCmdPath);
         sh2.waitForFinished(-1);
         output2 = sh2.readAll();
         xmls = output2;
-        qDebug() << output2;
+        qCDebug(xfbPlayer) << output2;
         sh2.close();
-        qDebug() << "Checking if the file's intergrity was perserved...";
+        qCDebug(xfbPlayer) << "Checking if the file's intergrity was perserved...";
         QProcess shCHK, shCHK2;
         QByteArray outputCHK, outputCHK2;
         QString outPathCHK, FTPCmdPathCHK, xmlsCHK;
@@ -4656,21 +4646,23 @@ void player::on_actionMake_a_program_from_this_playlist_triggered() {
         outPathCHK = outputCHK;
         QStringList path_arryCHK = outPathCHK.split("\n");
         FTPCmdPathCHK = path_arryCHK[0] + "/usr/share/xfb/scripts/serverFtpCmdsCHKProgram | grep " +
-                        NomeDestePrograma;
-        qDebug() << "running: " << FTPCmdPathCHK;
-        qDebug() << "If you get errors: cd config && chmod +x serverFtpCmdsCHKProgram && chmod 600 "
-                    "~/.netrc (the ftp is configured in .netrc correct?)";
+                        programName;
+        qCDebug(xfbPlayer) << "running: " << FTPCmdPathCHK;
+        qCDebug(xfbPlayer)
+            << "If you get errors: cd config && chmod +x serverFtpCmdsCHKProgram && chmod 600 "
+               "~/.netrc (the ftp is configured in .netrc correct?)";
         shCHK.close();
         shCHK2.start("sh", QStringList() << "-c" << FTPCmdPathCHK);
         shCHK2.waitForFinished();
         outputCHK2 = shCHK2.readAll();
         xmlsCHK = outputCHK2;
-        qDebug() << outputCHK2;
+        qCDebug(xfbPlayer) << outputCHK2;
         shCHK2.close();
         if (!xmlsCHK.isEmpty()) {
             QStringList splitCHKout = xmlsCHK.split(" ");
             for (int i = 0; i < splitCHKout.count(); i++) {
-                qDebug() << "In position " << i << " of the array the value is: " << splitCHKout[i];
+                qCDebug(xfbPlayer) << "In position " << i << " of the array the value is: "
+                                   << splitCHKout[i];
             }
             QString ftpSizeStr = splitCHKout[9];
 
@@ -4679,20 +4671,22 @@ void player::on_actionMake_a_program_from_this_playlist_triggered() {
                     ftpSizeStr = splitCHKout[i];
             }
 
-            qDebug() << "Size value in array: " << ftpSizeStr;
+            qCDebug(xfbPlayer) << "Size value in array: " << ftpSizeStr;
             int size = 0;
-            QString mmfile = FTPPath + "/" + NomeDestePrograma + ".ogg";
+            QString mmfile = FTPPath + "/" + programName + ".ogg";
             QFile myFile(mmfile);
             if (myFile.open(QIODevice::ReadOnly)) {
                 size = myFile.size(); // when file does open.
                 QString sizeStr = QString::number(size);
-                qDebug() << "Size value of local file: " << sizeStr;
+                qCDebug(xfbPlayer) << "Size value of local file: " << sizeStr;
                 myFile.close();
                 if (ftpSizeStr == sizeStr) {
-                    qDebug() << "The file's integrity on the FTP server was verified correctly!";
+                    qCDebug(xfbPlayer)
+                        << "The file's integrity on the FTP server was verified correctly!";
                 } else {
-                    qDebug() << "Failed to verify the integrity of the file in the FTP server. "
-                                "Size of Local and remote files do NOT match...";
+                    qCDebug(xfbPlayer)
+                        << "Failed to verify the integrity of the file in the FTP server. "
+                           "Size of Local and remote files do NOT match...";
                     QMessageBox::information(
                         this, tr("Interity verification faild!"),
                         tr("The file does not seam to have been sent to the server correctly since "
@@ -4700,16 +4694,17 @@ void player::on_actionMake_a_program_from_this_playlist_triggered() {
                            "Please try to send the program again."));
                 }
             } else {
-                qDebug() << "It was not possible to get the size of the local file: " << mmfile;
+                qCDebug(xfbPlayer) << "It was not possible to get the size of the local file: "
+                                   << mmfile;
             }
         }
-        qDebug() << "Program uploaded to server!";
+        qCDebug(xfbPlayer) << "Program uploaded to server!";
         QProcess bashDelThis;
-        QString fileToRemove = "rm " + FTPPath + "/" + NomeDestePrograma + ".ogg";
+        QString fileToRemove = "rm " + FTPPath + "/" + programName + ".ogg";
         bashDelThis.start("sh", QStringList() << "-c" << fileToRemove);
         bashDelThis.waitForFinished();
         bashDelThis.close();
-        qDebug() << "FTP temp file deleted";
+        qCDebug(xfbPlayer) << "FTP temp file deleted";
         QMessageBox::StandardButton answer;
         answer = QMessageBox::question(this, tr("Delete local copy?"),
                                        tr("Delete the local copy of the program? (The program was "
@@ -4725,12 +4720,14 @@ void player::on_actionMake_a_program_from_this_playlist_triggered() {
                                      tr("The local copy of the file was deleted."));
         } else {
             QSqlQuery qry(db);
-            QString thisquery =
-                "insert into programs values(NULL,'" + NomeDestePrograma + "','" + destino + "')";
-            if (qry.exec(thisquery)) {
-                qDebug() << "Query OK. Program localy added to programs table";
+            qry.prepare("insert into programs values(NULL, ?, ?)");
+            qry.addBindValue(programName);
+            qry.addBindValue(destino);
+            if (qry.exec()) {
+                qCDebug(xfbPlayer) << "Query OK. Program localy added to programs table";
             } else {
-                qDebug() << "Query was not ok while atempting to localy add to the programs table";
+                qCDebug(xfbPlayer)
+                    << "Query was not ok while atempting to localy add to the programs table";
             }
         }
     } else {
@@ -4748,12 +4745,14 @@ void player::on_actionMake_a_program_from_this_playlist_triggered() {
                                      tr("The local copy of the file was deleted."));
         } else {
             QSqlQuery qry(db);
-            QString thisquery =
-                "insert into programs values(NULL,'" + NomeDestePrograma + "','" + destino + "')";
-            if (qry.exec(thisquery)) {
-                qDebug() << "Query OK. Program localy added to programs table";
+            qry.prepare("insert into programs values(NULL, ?, ?)");
+            qry.addBindValue(programName);
+            qry.addBindValue(destino);
+            if (qry.exec()) {
+                qCDebug(xfbPlayer) << "Query OK. Program localy added to programs table";
             } else {
-                qDebug() << "Query was not ok while atempting to localy add to the programs table";
+                qCDebug(xfbPlayer)
+                    << "Query was not ok while atempting to localy add to the programs table";
             }
         }
     }
@@ -4761,12 +4760,45 @@ void player::on_actionMake_a_program_from_this_playlist_triggered() {
 }
 
 void player::on_actionCheck_the_Database_records_triggered() {
-    QSqlDatabase db = QSqlDatabase::database("xfb_connection");
-    if (!db.isOpen()) {
+    if (!adb.isOpen()) {
         qWarning() << "Database connection 'xfb_connection' is not open!";
         QMessageBox::critical(this, "Database Error", "Database connection is not open.");
         return;
     }
+    // A running check can be paused for the busy hours and resumed later,
+    // from where it stopped even after a restart
+    if (libraryChecker->isRunning() && !libraryChecker->isPaused()) {
+        if (QMessageBox::question(this, "Database Check",
+                                  "The database is being checked.\n\nPause the check? It can be "
+                                  "resumed later from where it stopped.",
+                                  QMessageBox::Yes | QMessageBox::No) == QMessageBox::Yes)
+            libraryChecker->pause();
+        return;
+    }
+    if (libraryChecker->isPaused() || libraryChecker->hasCheckpoint()) {
+        QMessageBox box(QMessageBox::Question, "Database Check",
+                        "A database check was paused before it was done.", QMessageBox::NoButton,
+                        this);
+        QPushButton* resume = box.addButton("Resume", QMessageBox::AcceptRole);
+        QPushButton* restart = box.addButton("Start Over", QMessageBox::DestructiveRole);
+        box.addButton(QMessageBox::Cancel);
+        box.exec();
+        if (box.clickedButton() == resume) {
+            if (!libraryChecker->resume()) {
+                QMessageBox::critical(this, "Database Error", "Failed to resume the check.");
+                return;
+            }
+            if (libraryChecker->isRunning()) {
+                libraryCheckProgress->showProgress("Checking the music records", QString(), 0,
+                                                   libraryChecker->total());
+            }
+            return;
+        }
+        if (box.clickedButton() != restart)
+            return;
+        if (libraryChecker->isRunning())
+            libraryChecker->cancel();
+    }
 
     QMessageBox::StandardButton run = QMessageBox::question(this, "Run Database Check?",
                                                             "Run a check on all music records?\n"
@@ -4774,389 +4806,358 @@ void player::on_actionCheck_the_Database_records_triggered() {
                                                             "- Check for empty files\n"
                                                             "- Update duration from file metadata\n"
                                                             "- Reset play count (if file OK)\n\n"
-                                                            "This may take some time.",
+                                                            "The check runs in the background.",
                                                             QMessageBox::Yes | QMessageBox::No);
     if (run == QMessageBox::No) {
         return;
     }
 
-    // Use stack-allocated QSqlQuery objects within the loop or prepare outside
-    QSqlQuery querySelect(db);
-    QSqlQuery queryDelete(db); // For delete operations
-    QSqlQuery queryUpdate(db); // For update operations
-
-    // Prepare statements outside the loop for efficiency
-    if (!queryDelete.prepare("DELETE FROM musics WHERE path = :path")) {
-        qWarning() << "Failed to prepare DELETE statement:" << queryDelete.lastError();
-        QMessageBox::critical(this, "Database Error", "Failed to prepare database query (DELETE).");
-        return;
-    }
-    if (!queryUpdate.prepare("UPDATE musics SET time = :time WHERE path = :path")) {
-        qWarning() << "Failed to prepare time UPDATE statement:" << queryUpdate.lastError();
-        QMessageBox::critical(this, "Database Error",
-                              "Failed to prepare database query (UPDATE time).");
-        return;
-    }
-    // Separate prepare for played_times update
-    QSqlQuery queryUpdatePlayedTimes(db);
-    if (!queryUpdatePlayedTimes.prepare("UPDATE musics SET played_times = 0 WHERE path = :path")) {
-        qWarning() << "Failed to prepare played_times UPDATE statement:"
-                   << queryUpdatePlayedTimes.lastError();
-        QMessageBox::critical(this, "Database Error",
-                              "Failed to prepare database query (UPDATE played_times).");
-        return;
-    }
-
-    QString selectStr = "SELECT path, time FROM musics"; // Select only needed columns
-    if (!querySelect.exec(selectStr)) {
-        qWarning() << "Failed to SELECT from musics:" << querySelect.lastError();
+    if (!libraryChecker->start()) {
         QMessageBox::critical(this, "Database Error", "Failed to query the musics table.");
         return;
     }
-
-    int processedCount = 0;
-    int errorsCount = 0;
-    int deletedCount = 0;
-    int updatedCount = 0;
-
-    while (querySelect.next()) {
-        QString path = querySelect.value(0).toString();
-        QString currentDbTime =
-            querySelect.value(1).toString(); // Get current time for comparison later if needed
-
-        qInfo().noquote() << "Processing [" << ++processedCount
-                          << "]:" << path; // Use qInfo for less verbose default logging
-
-        if (!QFile::exists(path)) {
-            qWarning() << "File does not exist:" << path;
-            QMessageBox::StandardButton reply = QMessageBox::question(
-                this, "File Missing",
-                QString("File not found:\n%1\n\nDelete this record from the database?").arg(path),
-                QMessageBox::Yes | QMessageBox::No | QMessageBox::Cancel);
-            if (reply == QMessageBox::Cancel) {
-                qInfo() << "User cancelled operation.";
-                break; // Exit the loop
-            } else if (reply == QMessageBox::Yes) {
-                queryDelete.bindValue(":path", path);
-                if (queryDelete.exec()) {
-                    qInfo() << "Record deleted from database (file missing):" << path;
-                    deletedCount++;
-                    update_music_table(); // Update view immediately
-                } else {
-                    qWarning() << "Failed to delete record for missing file:"
-                               << queryDelete.lastError() << queryDelete.lastQuery();
-                    errorsCount++;
-                    QMessageBox::warning(
-                        this, "Database Error",
-                        QString("Failed to delete record for missing file:\n%1\n\nError: %2")
-                            .arg(path, queryDelete.lastError().text()));
+    if (libraryChecker->isRunning())
+        libraryCheckProgress->showProgress("Checking the music records", QString(), 0,
+                                           libraryChecker->total());
+}
+
+void player::setupLibraryCheck() {
+    // Files are looked at on a pool of workers and the results written in
+    // batches, so checking a large library takes minutes and never blocks
+    // the decks; problems are reported as they come and handled at the end
+    libraryChecker = new LibraryChecker(adb, this);
+
+    libraryCheckProgress = new ProgressIndicatorWidget(this);
+    libraryCheckProgress->setCancelEnabled(true);
+    libraryCheckProgress->setShowElapsedTime(true);
+    libraryCheckProgress->setShowEstimatedTime(true);
+    ui->gridLayout->addWidget(libraryCheckProgress, ui->gridLayout->rowCount(), 0, 1,
+                              ui->gridLayout->columnCount());
+    connect(libraryCheckProgress, &ProgressIndicatorWidget::cancelRequested, libraryChecker,
+            &LibraryChecker::cancel);
+
+    connect(libraryChecker, &LibraryChecker::problemFound, this,
+            [this](const QString& filePath, LibraryChecker::Problem problem,
+                   const QString& detail) {
+                ++libraryCheckProblems;
+                switch (problem) {
+                case LibraryChecker::Problem::Missing:
+                    qWarning() << "File does not exist:" << filePath;
+                    break;
+                case LibraryChecker::Problem::Empty:
+                    qWarning() << "File exists but is empty (0 bytes):" << filePath;
+                    break;
+                case LibraryChecker::Problem::Unreadable:
+                    qWarning() << "Could not read the duration of" << filePath << ":" << detail;
+                    break;
                 }
-            } else {
-                qInfo() << "Skipping missing file record, keeping in DB:" << path;
-                errorsCount++; // Count as an issue to resolve
-            }
-            continue; // Move to the next record
-        }
-
-        // File exists, check size
-        QFile file(path);
-        qint64 fileSize = file.size(); // Check size directly
-        qDebug() << "File exists, size:" << fileSize;
-
-        if (fileSize == 0) {
-            qWarning() << "File exists but is empty (0 bytes):" << path;
-            QMessageBox::StandardButton reply = QMessageBox::question(
-                this, "Empty File",
-                QString("File exists but is empty (0 bytes):\n%1\n\nDelete record from database "
-                        "AND delete the empty file from disk?")
-                    .arg(path),
-                QMessageBox::Yes | QMessageBox::No | QMessageBox::Cancel);
-            if (reply == QMessageBox::Cancel) {
-                qInfo() << "User cancelled operation.";
-                break; // Exit the loop
-            } else if (reply == QMessageBox::Yes) {
-                // 1. Delete from DB first
-                queryDelete.bindValue(":path", path);
-                if (queryDelete.exec()) {
-                    qInfo() << "Record deleted from database (empty file):" << path;
-                    deletedCount++;
-                    // 2. If DB delete successful, delete file from disk
-                    if (QFile::remove(path)) {
-                        qInfo() << "Empty file deleted from disk:" << path;
-                    } else {
-                        qWarning()
-                            << "Failed to delete empty file from disk (record was deleted from DB):"
-                            << path << file.errorString();
-                        QMessageBox::warning(this, "File System Error",
-                                             QString("Record deleted from DB, but failed to delete "
-                                                     "empty file from disk:\n%1\n\nError: %2")
-                                                 .arg(path, file.errorString()));
-                        // Don't increment errorsCount here as the primary goal (DB cleanup)
-                        // succeeded.
+            });
+    connect(libraryChecker, &LibraryChecker::progressChanged, this, [this](int done, int total) {
+        libraryCheckProgress->updateProgress(
+            done, QString("%1 of %2 records checked, %3 problems found")
+                      .arg(done)
+                      .arg(total)
+                      .arg(libraryCheckProblems));
+    });
+    connect(libraryChecker, &LibraryChecker::paused, this, [this](int done, int total) {
+        libraryCheckProgress->hideProgress();
+        qInfo() << "Database check paused after" << done << "of" << total << "records.";
+    });
+    connect(libraryChecker, &LibraryChecker::finished, this,
+            [this](const LibraryChecker::Report& report) {
+                libraryCheckProgress->hideProgress();
+                libraryCheckProblems = 0;
+
+                int deletedCount = 0;
+                const QStringList removable = report.missing + report.empty;
+                if (!removable.isEmpty()) {
+                    QStringList details;
+                    for (const QString& path : report.missing)
+                        details << "missing: " + path;
+                    for (const QString& path : report.empty)
+                        details << "empty: " + path;
+
+                    QMessageBox box(QMessageBox::Question, "Check Found Problems",
+                                    QString("%1 records point to files that do not exist and %2 "
+                                            "to empty files.\n\nDelete these records from the "
+                                            "database, and the empty files from disk?")
+                                        .arg(report.missing.size())
+                                        .arg(report.empty.size()),
+                                    QMessageBox::Yes | QMessageBox::No, this);
+                    box.setDetailedText(details.join('\n'));
+                    if (box.exec() == QMessageBox::Yes) {
+                        deletedCount = qMax(0, libraryChecker->removeRecords(removable));
+                        for (const QString& path : report.empty) {
+                            if (!QFile::remove(path))
+                                qWarning() << "Failed to delete empty file from disk (record "
+                                              "was deleted from DB):"
+                                           << path;
+                        }
                     }
-                    update_music_table(); // Update view immediately
-                } else {
-                    qWarning() << "Failed to delete record for empty file:"
-                               << queryDelete.lastError() << queryDelete.lastQuery();
-                    errorsCount++;
-                    QMessageBox::warning(
-                        this, "Database Error",
-                        QString("Failed to delete record for empty file:\n%1\n\nError: %2")
-                            .arg(path, queryDelete.lastError().text()));
                 }
-            } else {
-                qInfo() << "Skipping empty file record, keeping in DB and on disk:" << path;
-                errorsCount++; // Count as an issue to resolve
-            }
-            continue; // Move to the next record
-        }
 
-        // --- File seems OK, get duration using Exiftool (C++ Parsing Method) ---
-        qDebug() << "File seems OK. Checking metadata with exiftool...";
+                const int skipped = report.problems() - deletedCount + report.writeErrors;
+                qInfo() << "-------------------------------------";
+                qInfo() << "Database check complete.";
+                qInfo() << "Processed:" << report.checked << "records.";
+                qInfo() << "Deleted:" << deletedCount << "records.";
+                qInfo() << "Updated:" << report.updated << "times.";
+                qInfo() << "Errors/Skipped:" << skipped << "records (check warnings above).";
+                qInfo() << "-------------------------------------";
 
-        QProcess process;
-        QString command = "exiftool"; // Just the command
-        QStringList arguments;
-        arguments << "-Duration"; // Ask only for the Duration tag for efficiency
-        arguments << path;        // QProcess handles quoting arguments
+                QMessageBox::information(
+                    this, report.cancelled ? "Check Cancelled" : "Check Complete",
+                    QString("Database check %1.\n\nProcessed: %2 of %3\nDeleted: %4\nTime "
+                            "Updated: %5\nUnreadable: %6\nErrors/Skipped: %7\n\nSee "
+                            "application output log for details.")
+                        .arg(report.cancelled ? "cancelled" : "finished")
+                        .arg(report.checked)
+                        .arg(report.total)
+                        .arg(deletedCount)
+                        .arg(report.updated)
+                        .arg(report.unreadable.size())
+                        .arg(skipped));
 
-        qDebug() << "Running command:" << command << arguments;
+                update_music_table();
+            });
+}
 
-        process.start(command, arguments);
+void player::on_actionRescan_the_library_folders_triggered() {
+    if (libraryRescanner->isRunning()) {
+        QMessageBox::information(this, "Library Rescan",
+                                 "The library folders are already being rescanned.");
+        return;
+    }
+    if (libraryRescanner->roots().isEmpty()) {
+        QMessageBox::warning(this, "Library Rescan",
+                             "No library folder is configured. Set the music path in the "
+                             "options, or list the folders under LibraryRoots in xfb.conf.");
+        return;
+    }
 
-        // Wait for the process to finish (e.g., 10 seconds timeout)
-        if (!process.waitForFinished(10000)) {
-            qWarning() << "Exiftool process timed out for:" << path << process.errorString();
-            process.kill();
-            process.waitForFinished(1000); // Wait a bit after killing
-            errorsCount++;
-            continue; // Skip this file
-        }
+    libraryRescanFromMenu = true;
+    libraryRescanProgress->showIndeterminateProgress("Rescanning the library folders",
+                                                     "Looking for new and changed files");
+    libraryRescanner->start();
+}
 
-        // Check for exiftool execution errors
-        if (process.exitStatus() != QProcess::NormalExit || process.exitCode() != 0) {
-            qWarning() << "Exiftool process failed for:" << path
-                       << "Exit code:" << process.exitCode()
-                       << "Exit status:" << process.exitStatus();
-            QString errorOutput =
-                QString::fromLocal8Bit(process.readAllStandardError()); // Or fromUtf8
-            qWarning() << "Exiftool Standard Error:\n" << errorOutput;
-            errorsCount++;
-            // Optionally show a non-blocking notification or log this error prominently
-            continue; // Skip this file
-        }
+void player::on_actionExport_the_library_triggered() {
+    const QString fileName = chooseExportFile(tr("Export the library"), "library");
+    if (fileName.isEmpty())
+        return;
 
-        // Read ALL standard output from exiftool
-        QString exiftoolOutput =
-            QString::fromLocal8Bit(process.readAllStandardOutput()); // Or fromUtf8
-        qDebug() << "Exiftool raw output:\n" << exiftoolOutput;
-
-        QString durationValue;
-        // Find the line containing "Duration" and extract the value
-        QStringList lines = exiftoolOutput.split(QRegularExpression("[\r\n]+"), Qt::SkipEmptyParts);
-        for (const QString& line : lines) {
-            if (line.simplified().startsWith("Duration", Qt::CaseInsensitive)) {
-                int colonPos = line.indexOf(':');
-                if (colonPos != -1) {
-                    durationValue = line.mid(colonPos + 1).trimmed();
-                    qInfo() << "Found Duration:" << durationValue << "for" << path;
-                    break; // Found it
-                }
-            }
-        }
+    const bool gzip = fileName.endsWith(".gz");
+    const bool json = QFileInfo(gzip ? fileName.chopped(3) : fileName).suffix() == "jsonl";
+    auto* exporter = new StreamingExporter(this);
+    watchExport(exporter, tr("Library export"));
+    exporter->start(StreamingExporter::libraryJob(
+        databasePath, fileName,
+        json ? StreamingExporter::Format::JsonLines : StreamingExporter::Format::Csv, gzip));
+}
+
+void player::on_actionExport_the_play_history_triggered() {
+    const PlayHistory history(adb, playHistory->historyDirectory());
+    const QStringList months = history.months();
+    if (months.isEmpty()) {
+        QMessageBox::information(this, tr("Export the play history"),
+                                 tr("No play has been logged yet."));
+        return;
+    }
+    bool ok = false;
+    const QString month =
+        QInputDialog::getItem(this, tr("Export the play history"), tr("Month"), months,
+                              months.size() - 1, false, &ok);
+    if (!ok || month.isEmpty())
+        return;
+    const QString fileName = chooseExportFile(tr("Export the play history"), "plays-" + month);
+    if (fileName.isEmpty())
+        return;
 
-        if (durationValue.isEmpty()) {
-            qWarning() << "Could not find or parse 'Duration' tag from exiftool output for:"
-                       << path;
-            QString errorOutput =
-                QString::fromLocal8Bit(process.readAllStandardError()); // Check stderr again
-            if (!errorOutput.trimmed().isEmpty()) {
-                qWarning() << "Exiftool stderr for non-duration file:" << errorOutput;
-            }
-            errorsCount++;
-            // Maybe update time to NULL or a special value? For now, just skip update.
-        } else {
-            // Update the database only if the time is different or needs setting
-            if (currentDbTime != durationValue) { // Optional: Avoid unnecessary updates
-                qInfo() << "Updating time in DB from" << currentDbTime << "to" << durationValue
-                        << "for" << path;
-                queryUpdate.bindValue(":time", durationValue);
-                queryUpdate.bindValue(":path", path);
-                if (queryUpdate.exec()) {
-                    qDebug() << "Time updated successfully in DB.";
-                    updatedCount++;
-                    update_music_table(); // Update view
-                } else {
-                    qWarning() << "Failed to update time in DB:" << queryUpdate.lastError()
-                               << queryUpdate.lastQuery();
-                    errorsCount++;
-                    QMessageBox::warning(this, "Database Error",
-                                         QString("Failed to update time for:\n%1\n\nError: %2")
-                                             .arg(path, queryUpdate.lastError().text()));
-                }
-            } else {
-                qDebug()
-                    << "Duration in DB already matches exiftool output. No time update needed.";
-            }
+    const bool gzip = fileName.endsWith(".gz");
+    const bool json = QFileInfo(gzip ? fileName.chopped(3) : fileName).suffix() == "jsonl";
+    auto* exporter = new StreamingExporter(this);
+    watchExport(exporter, tr("Play history export"));
+    exporter->start(StreamingExporter::playsJob(
+        history.partitionPath(month), fileName,
+        json ? StreamingExporter::Format::JsonLines : StreamingExporter::Format::Csv, gzip));
+}
+
+QString player::chooseExportFile(const QString& title, const QString& baseName) {
+    // The suffix picks the format, and a trailing .gz compresses it
+    QString filter = tr("CSV files (*.csv);;JSON lines files (*.jsonl)");
+    if (StreamingExporter::isGzipAvailable())
+        filter += tr(";;Compressed CSV files (*.csv.gz);;Compressed JSON lines files (*.jsonl.gz)");
+    QString selected;
+    QString fileName = QFileDialog::getSaveFileName(
+        this, title, QDir::home().filePath(baseName + ".csv"), filter, &selected);
+    if (fileName.isEmpty())
+        return QString();
+    if (!fileName.endsWith(".csv") && !fileName.endsWith(".jsonl") &&
+        !fileName.endsWith(".gz")) {
+        fileName += selected.contains("jsonl") ? ".jsonl" : ".csv";
+        if (selected.contains(".gz"))
+            fileName += ".gz";
+    }
+    if (fileName.endsWith(".gz") && !StreamingExporter::isGzipAvailable()) {
+        QMessageBox::warning(this, title,
+                             tr("This build cannot write compressed files; choose a name "
+                                "ending in .csv or .jsonl."));
+        return QString();
+    }
+    return fileName;
+}
+
+void player::watchExport(StreamingExporter* exporter, const QString& title) {
+    // The rows are read and written on the pool; the feedback follows them
+    BackgroundOperationFeedback* feedback = backgroundFeedback();
+    const int operation =
+        feedback ? feedback->startOperation(title, tr("Writing the rows"),
+                                            BackgroundOperationFeedback::OperationType::FileExport)
+                 : -1;
+    connect(exporter, &StreamingExporter::progressChanged, this,
+            [this, operation](qint64 rows, qint64 total) {
+                BackgroundOperationFeedback* feedback = backgroundFeedback();
+                if (feedback && operation >= 0 && total > 0)
+                    feedback->updateProgress(operation, int(rows * 100 / total),
+                                             tr("%1 of %2 rows written").arg(rows).arg(total));
+            });
+    connect(exporter, &StreamingExporter::finished, this,
+            [this, exporter, operation, title](const StreamingExporter::Result& result) {
+                exporter->deleteLater();
+                BackgroundOperationFeedback* feedback = backgroundFeedback();
+                const QString message =
+                    result.succeeded()
+                        ? tr("%1 rows written to %2").arg(result.rows).arg(result.outputPath)
+                        : tr("Export failed: %1").arg(result.error);
+                if (feedback && operation >= 0)
+                    feedback->completeOperation(operation, result.succeeded(), message);
+                if (!result.succeeded())
+                    QMessageBox::warning(this, title, message);
+            });
+}
 
-            // Reset played_times (original logic) - Do this only if time update was successful or
-            // not needed? Let's assume reset should happen if the file is valid, regardless of time
-            // update necessity.
-            qInfo() << "Resetting played_times to 0 for:" << path;
-            queryUpdatePlayedTimes.bindValue(":path", path);
-            if (!queryUpdatePlayedTimes.exec()) {
-                qWarning() << "Failed to reset played_times:" << queryUpdatePlayedTimes.lastError()
-                           << queryUpdatePlayedTimes.lastQuery();
-                errorsCount++;
-                // Non-critical error, maybe don't show a message box here.
-            }
-        }
-        // --- End Exiftool Processing ---
+void player::setupLibraryRescan() {
+    // Each root's files are compared with what they looked like at the last
+    // rescan, so only new and changed files are read; an archive where
+    // nothing changed is a directory walk. Runs nightly and from the menu
+    libraryRescanner = new LibraryRescanner(musicRepository, this);
+
+    // Between rescans, the folders are watched and what producers drop in
+    // is added a few seconds after the copy completes
+    libraryWatcher = new LibraryWatcher(this);
+    connect(libraryWatcher, &LibraryWatcher::directoriesChanged, libraryRescanner,
+            &LibraryRescanner::rescanDirectories);
+
+    libraryRescanProgress = new ProgressIndicatorWidget(this);
+    libraryRescanProgress->setCancelEnabled(true);
+    libraryRescanProgress->setShowElapsedTime(true);
+    libraryRescanProgress->setShowEstimatedTime(true);
+    ui->gridLayout->addWidget(libraryRescanProgress, ui->gridLayout->rowCount(), 0, 1,
+                              ui->gridLayout->columnCount());
+    connect(libraryRescanProgress, &ProgressIndicatorWidget::cancelRequested, libraryRescanner,
+            &LibraryRescanner::cancel);
+
+    connect(libraryRescanner, &LibraryRescanner::progressChanged, this,
+            [this](int done, int total) {
+                if (!libraryRescanProgress->isProgressVisible())
+                    libraryRescanProgress->showProgress("Rescanning the library folders",
+                                                        QString(), 0, total);
+                libraryRescanProgress->setRange(0, total);
+                libraryRescanProgress->updateProgress(
+                    done, QString("%1 of %2 new or changed files read").arg(done).arg(total));
+            });
+    connect(libraryRescanner, &LibraryRescanner::finished, this,
+            [this](const LibraryRescanner::Report& report) {
+                libraryRescanProgress->hideProgress();
+                if (report.changes() > 0)
+                    update_music_table();
+                // New tracks may be ones another machine analyzed
+                if (report.added + report.updated + report.renamed > 0)
+                    importAnalysisIndexes();
+
+                // The nightly rescan only logs; see LibraryRescanner's warnings
+                const bool fromMenu = libraryRescanFromMenu;
+                libraryRescanFromMenu = false;
+                if (!fromMenu)
+                    return;
+                QMessageBox::information(
+                    this, report.cancelled ? "Rescan Cancelled" : "Rescan Complete",
+                    QString("Library rescan %1 in %2 s.\n\nFiles: %3\nAdded: %4\n"
+                            "Updated: %5\nMoved: %6\nRemoved: %7\nUnreadable: %8\n"
+                            "Folders skipped (missing or empty): %9")
+                        .arg(report.cancelled ? "cancelled" : "finished")
+                        .arg(report.elapsedMs / 1000.0, 0, 'f', 1)
+                        .arg(report.files)
+                        .arg(report.added)
+                        .arg(report.updated)
+                        .arg(report.renamed)
+                        .arg(report.removed)
+                        .arg(report.failed)
+                        .arg(report.skippedRoots));
+            });
 
-    } // End while loop
+    libraryRescanTimer = new QTimer(this);
+    libraryRescanTimer->setSingleShot(true);
+    libraryRescanTimer->setTimerType(Qt::PreciseTimer);  // A coarse timer may fire early
+    connect(libraryRescanTimer, &QTimer::timeout, this, [this]() {
+        if (!libraryRescanner->isRunning())
+            libraryRescanner->start();
+        // Shares mounted again since lose their watches; list the trees afresh
+        if (libraryWatch)
+            libraryWatcher->setRoots(libraryRescanner->roots());
+        scheduleLibraryRescan();
+    });
+    applyLibraryRoots();
+}
 
-    qInfo() << "-------------------------------------";
-    qInfo() << "Database check complete.";
-    qInfo() << "Processed:" << processedCount << "records.";
-    qInfo() << "Deleted:" << deletedCount << "records.";
-    qInfo() << "Updated:" << updatedCount << "times.";
-    qInfo() << "Errors/Skipped:" << errorsCount << "records (check warnings above).";
-    qInfo() << "-------------------------------------";
+void player::applyLibraryRoots() {
+    libraryRescanner->setRoots(libraryRoots);
+    const QStringList watched = libraryWatch ? libraryRescanner->roots() : QStringList();
+    if (libraryWatcher->roots() != watched)
+        libraryWatcher->setRoots(watched);
+    scheduleLibraryRescan();
+}
 
-    QMessageBox::information(
-        this, "Check Complete",
-        QString("Database check finished.\n\nProcessed: %1\nDeleted: %2\nTime Updated: "
-                "%3\nErrors/Skipped: %4\n\nSee application output log for details.")
-            .arg(processedCount)
-            .arg(deletedCount)
-            .arg(updatedCount)
-            .arg(errorsCount));
-
-    // Final table update might be redundant if called after every change, but safe to have.
-    update_music_table();
+void player::scheduleLibraryRescan() {
+    if (!libraryRescanTimer)
+        return;
+    if (!libraryRescanTime.isValid()) {
+        libraryRescanTimer->stop();
+        return;
+    }
+
+    const QDateTime now = QDateTime::currentDateTime();
+    QDateTime next(now.date(), libraryRescanTime);
+    if (next <= now)
+        next = next.addDays(1);
+    libraryRescanTimer->start(int(now.msecsTo(next)));
 }
 
 void player::calculate_playlist_total_time() {
-    qint64 totalSeconds = 0; // Use qint64 for total seconds to prevent overflow
-    int failedFiles = 0;
-    int playlistCount = ui->playlist->count();
+    // The queue keeps the total as entries come and go; this formats it,
+    // plus any scheduled items.
+    qint64 totalSeconds = playlistQueue->totalAirTimeUs() / 1000000;
+    int failedFiles = playlistQueue->unknownDurationCount();
 
-    qInfo() << "Calculating total time for" << playlistCount << "items in playlist...";
-
-    if (playlistCount == 0) {
+    if (playlistQueue->isEmpty()) {
         ui->txt_playlistTotalTime->setText("Total time: 00:00:00");
         return;
     }
 
-    for (int i = 0; i < playlistCount; ++i) {
-        QListWidgetItem* item = ui->playlist->item(i);
-        if (!item)
-            continue; // Should not happen, but safety check
-
-        QString filePath = item->text(); // Assuming the item text is the full path
-        qInfo().noquote() << "Processing playlist item [" << i + 1 << "/" << playlistCount
-                          << "]:" << filePath;
-
-        // --- Optional but recommended: Check if file exists ---
-        if (!QFile::exists(filePath)) {
-            qWarning() << "File listed in playlist does not exist:" << filePath;
-            failedFiles++;
-            // Optional: Visually mark the item in the playlist?
-            // item->setForeground(Qt::red); // Example
-            continue; // Skip to the next item
-        }
-        // --- End existence check ---
-
-        QProcess process;
-        QString command = "exiftool";
-        QStringList arguments;
-        // Use -T for Tab-separated values (easier parsing) and request only Duration
-        // This should output *just* the duration value if found.
-        arguments << "-T"
-                  << "-Duration" << filePath;
-
-        qDebug() << "Running command:" << command << arguments;
-
-        process.setProcessChannelMode(
-            QProcess::MergedChannels); // Combine stdout and stderr for simpler reading if needed
-        process.start(command, arguments);
-
-        // Wait for the process to finish (e.g., 5 seconds timeout per file)
-        if (!process.waitForFinished(5000)) {
-            qWarning() << "Exiftool process timed out for:" << filePath << process.errorString();
-            process.kill();
-            process.waitForFinished(1000);
-            failedFiles++;
-            continue; // Skip this file
-        }
-
-        // Check for exiftool execution errors
-        if (process.exitStatus() != QProcess::NormalExit || process.exitCode() != 0) {
-            qWarning() << "Exiftool process failed for:" << filePath
-                       << "Exit code:" << process.exitCode()
-                       << "Exit status:" << process.exitStatus();
-            QString errorOutput =
-                QString::fromLocal8Bit(process.readAll()); // Read combined output/error
-            qWarning() << "Exiftool output/error:\n" << errorOutput;
-            failedFiles++;
-            continue; // Skip this file
-        }
-
-        // Read the output (should be just the duration value now because of -T)
-        QString durationString =
-            QString::fromLocal8Bit(process.readAllStandardOutput()).trimmed(); // Or fromUtf8
-
-        if (durationString.isEmpty() ||
-            durationString == "-") { // Exiftool might output "-" if tag not found
-            qWarning() << "Could not find 'Duration' tag via exiftool for:" << filePath;
-            failedFiles++;
-            continue; // Skip this file
-        }
-
-        qDebug() << "Found Duration string:" << durationString << "for" << filePath;
-
-        // --- Parse the duration string (HH:MM:SS.ss or SS.ss) into seconds ---
-        qint64 currentTrackSeconds = 0;
-        bool parseOk = false;
-
-        if (durationString.contains(':')) {
-            // Format HH:MM:SS.ss
-            QStringList parts = durationString.split(':');
-            if (parts.size() == 3) {
-                bool hOk, mOk, sOk;
-                int hours = parts[0].toInt(&hOk);
-                int minutes = parts[1].toInt(&mOk);
-                // Seconds might have fraction, take integer part
-                double secondsDouble = parts[2].toDouble(&sOk);
-                int seconds = static_cast<int>(secondsDouble); // Truncate fraction
-
-                if (hOk && mOk && sOk && hours >= 0 && minutes >= 0 && minutes < 60 &&
-                    seconds >= 0 && seconds < 60) {
-                    currentTrackSeconds = (hours * 3600) + (minutes * 60) + seconds;
-                    parseOk = true;
-                }
-            }
-        } else {
-            // Format SS.ss (seconds only)
-            bool sOk;
-            double secondsDouble = durationString.toDouble(&sOk);
-            if (sOk && secondsDouble >= 0) {
-                currentTrackSeconds = static_cast<qint64>(secondsDouble); // Truncate fraction
-                parseOk = true;
-            }
-        }
-
-        if (parseOk) {
-            qDebug() << "Parsed seconds:" << currentTrackSeconds;
-            totalSeconds += currentTrackSeconds;
-        } else {
-            qWarning() << "Failed to parse duration string:" << durationString
-                       << "for file:" << filePath;
-            failedFiles++;
+    // Scheduled pubs and programs that go on top of the playlist while it
+    // runs add to its air time
+    int scheduledItems = 0;
+    if (schedulerEngine) {
+        const QDateTime now = QDateTime::currentDateTime();
+        const QList<ScheduledEvent> upcoming =
+            schedulerEngine->upcomingEvents(now, now.addSecs(totalSeconds));
+        for (const ScheduledEvent& event : upcoming) {
+            qint64 us = durationCache->durationUs(event.rule.path);
+            if (us > 0)
+                totalSeconds += us / 1000000;
+            ++scheduledItems;
         }
-        // --- End duration parsing ---
-
-    } // End for loop
+    }
 
     // --- Format total time ---
     qint64 finalHours = totalSeconds / 3600;
@@ -5170,13 +5171,13 @@ void player::calculate_playlist_total_time() {
             .arg(finalMinutes, 2, 10, QChar('0'))
             .arg(finalSeconds, 2, 10, QChar('0'));
 
+    if (scheduledItems > 0) {
+        finalTimeString += QString(" (incl. %1 scheduled)").arg(scheduledItems);
+    }
     if (failedFiles > 0) {
         finalTimeString += QString(" (%1 item(s) failed)").arg(failedFiles);
-        qWarning() << "Finished calculating playlist time, but failed to get duration for"
-                   << failedFiles << "items.";
     }
 
-    qInfo() << "Final calculated playlist time string:" << finalTimeString;
     ui->txt_playlistTotalTime->setText(finalTimeString);
 }
 void player::
@@ -5194,29 +5195,30 @@ void player::
         if (qr.exec(qrstr)) {
             while (qr.next()) {
                 QString path = qr.value(7).toString();
-                qDebug() << "Processing: " << path;
+                XFB_TRACE(xfbPlayer) << "Processing: " << path;
 
                 bool ha = QFile::exists(path);
                 if (!ha) {
-                    qDebug() << "Deleting " << path;
+                    qCDebug(xfbPlayer) << "Deleting " << path;
 
                     QSqlQuery* qry = new QSqlQuery(db);
                     qry->prepare("delete from musics where path = :thpath");
                     qry->bindValue(":thpath", path);
 
                     if (qry->exec()) {
-                        qDebug() << "Music Deleted from database! last query was:"
-                                 << qry->lastQuery();
+                        qCDebug(xfbPlayer) << "Music Deleted from database! last query was:"
+                                           << qry->lastQuery();
                         update_music_table();
                     } else {
-                        qDebug() << "There was an error deleting the music from the database"
-                                 << qry->lastError() << qry->lastQuery();
+                        qCDebug(xfbPlayer)
+                            << "There was an error deleting the music from the database"
+                            << qry->lastError() << qry->lastQuery();
                     }
 
                 } else {
                     QFile myFile(path);
 
-                    qDebug() << "File.size() is now: " << myFile.size();
+                    XFB_TRACE(xfbPlayer) << "File.size() is now: " << myFile.size();
 
                     if (myFile.size() == 0) {
                         QSqlQuery* qry = new QSqlQuery(db);
@@ -5224,8 +5226,9 @@ void player::
                         qry->bindValue(":thpath", path);
 
                         if (qry->exec()) {
-                            qDebug() << "Music Deleted from database and HD! last query was:"
-                                     << qry->lastQuery();
+                            qCDebug(xfbPlayer)
+                                << "Music Deleted from database and HD! last query was:"
+                                << qry->lastQuery();
 
                             QProcess rmthis;
                             QString rmthistr = "rm " + path;
@@ -5234,7 +5237,7 @@ void player::
 
                             update_music_table();
                         } else {
-                            qDebug()
+                            qCDebug(xfbPlayer)
                                 << "There was an erropositionr deleting the music from the database"
                                 << qry->lastError() << qry->lastQuery();
                         }
@@ -5255,11 +5258,11 @@ void player::on_bt_rol_streaming_play_clicked() {
 
     QStringList ServerIP = cOut.split("\n");
 
-    qDebug() << "Server's IP is now:" << ServerIP[0];
+    qCDebug(xfbPlayer) << "Server's IP is now:" << ServerIP[0];
 
     QString radio1str = "mplayer -playlist http://" + ServerIP[0] + ":8000/stream.m3u";
 
-    qDebug() << "Full cmd is: " << radio1str;
+    qCDebug(xfbPlayer) << "Full cmd is: " << radio1str;
 
     radio1.start("sh", QStringList() << "-c" << radio1str);
     radio1.waitForStarted(-1);
@@ -5363,245 +5366,152 @@ void player::
         QMessageBox::critical(this, "Database Error", "Database connection is not open.");
         return;
     }
-
-    // --- Check for SOX executable ---
-    QString soxPath = QStandardPaths::findExecutable("sox");
-    if (soxPath.isEmpty()) {
-        qWarning() << "'sox' command not found in system PATH.";
-        QMessageBox::critical(this, "Missing Dependency",
-                              "The 'sox' command (Sound eXchange) is required for this feature "
-                              "but was not found in the system's PATH.\n\nPlease install SoX and "
-                              "ensure it's accessible.");
+    if (silenceScanner->isRunning()) {
+        QMessageBox::information(this, "Auto-Trim", "The library is already being analyzed.");
+        return;
+    }
+
+    QMessageBox::StandardButton run = QMessageBox::question(
+        this, "Confirm Auto-Trim",
+        "This will measure the silence at the start and the end of every track in the "
+        "database and play each track from its first to its last audible moment.\n\n"
+        "It also finds where each intro ends and where each track fades out, so that "
+        "crossfades start at the fade instead of a fixed time before the end.\n\n"
+        "The files themselves are not changed.\n\n"
+        "The tracks are analyzed in the background and you can keep working meanwhile.\n"
+        "Are you sure you want to proceed?",
+        QMessageBox::Yes | QMessageBox::No);
+    if (run == QMessageBox::No) {
+        return;
+    }
+
+    const QStringList paths = existingLibraryPaths();
+    if (paths.isEmpty()) {
+        QMessageBox::information(this, "Auto-Trim", "There are no tracks to analyze.");
+        return;
+    }
+
+    qInfo() << "AutoTrim: analyzing" << paths.size() << "tracks with"
+            << silenceScanner->maxWorkers() << "workers";
+    cueScanProgress->showProgress("Finding the silence around the tracks", QString(), 0,
+                                  paths.size());
+    silenceScanner->scan(paths);
+}
+
+QStringList player::existingLibraryPaths() {
+    QSqlQuery querySelect(adb);
+    querySelect.setForwardOnly(true);
+    if (!querySelect.exec("SELECT path FROM musics")) {
+        qWarning() << "Failed to SELECT paths from musics:" << querySelect.lastError();
+        return {};
+    }
+
+    QStringList paths;
+    while (querySelect.next()) {
+        const QString path = querySelect.value(0).toString();
+        if (QFileInfo(path).isFile())
+            paths << path;
+        else
+            qWarning() << "File does not exist or is not a regular file:" << path;
+    }
+    return paths;
+}
+
+void player::on_actionAnalyze_the_loudness_of_all_music_tracks_in_the_database_triggered() {
+    if (!adb.isOpen()) {
+        QMessageBox::critical(this, "Database Error", "Database connection is not open.");
+        return;
+    }
+    if (loudnessScanner->isRunning()) {
+        QMessageBox::information(this, "Loudness Analysis",
+                                 "The library is already being analyzed.");
+        return;
+    }
+
+    QMessageBox::StandardButton run = QMessageBox::question(
+        this, "Confirm Loudness Analysis",
+        "This will measure the loudness (EBU R128) of every track in the database.\n\n"
+        "With Soft Live Sound Normalization enabled in the options, each track is then "
+        "played at an even loudness. The files themselves are not changed.\n\n"
+        "The tracks are analyzed in the background and you can keep working meanwhile.\n"
+        "Are you sure you want to proceed?",
+        QMessageBox::Yes | QMessageBox::No);
+    if (run == QMessageBox::No) {
+        return;
+    }
+
+    const QStringList paths = existingLibraryPaths();
+    if (paths.isEmpty()) {
+        QMessageBox::information(this, "Loudness Analysis", "There are no tracks to analyze.");
+        return;
+    }
+
+    qInfo() << "Loudness: analyzing" << paths.size() << "tracks with"
+            << loudnessScanner->maxWorkers() << "workers";
+    loudnessProgress->showProgress("Measuring the loudness of the tracks", QString(), 0,
+                                   paths.size());
+    loudnessScanner->scan(paths);
+}
+
+void player::on_actionAnalyze_all_music_tracks_in_the_database_triggered() {
+    if (!adb.isOpen()) {
+        QMessageBox::critical(this, "Database Error", "Database connection is not open.");
+        return;
+    }
+    if (analysisPipeline->isRunning() || silenceScanner->isRunning() ||
+        loudnessScanner->isRunning()) {
+        QMessageBox::information(this, "Library Analysis",
+                                 "The library is already being analyzed.");
         return;
     }
-    qInfo() << "Found sox executable at:" << soxPath;
-    // --- End SOX check ---
 
-    QMessageBox::StandardButton run =
-        QMessageBox::question(this, "Confirm Auto-Trim",
-                              "This will attempt to trim silence (below 1% threshold) from the "
-                              "start and end of every track in the database using 'sox'.\n\n"
-                              "Original files will be overwritten!\n\n"
-                              "This process can take a long time and is irreversible.\n"
-                              "Are you sure you want to proceed?",
-                              QMessageBox::Yes | QMessageBox::No);
+    QMessageBox::StandardButton run = QMessageBox::question(
+        this, "Confirm Library Analysis",
+        "This will find the cue points (Auto-Trim), measure the loudness and draw the "
+        "waveform of every track in the database, decoding each track only once.\n\n"
+        "The files themselves are not changed.\n\n"
+        "The tracks are analyzed in the background and you can keep working meanwhile.\n"
+        "Are you sure you want to proceed?",
+        QMessageBox::Yes | QMessageBox::No);
     if (run == QMessageBox::No) {
         return;
     }
 
-    // --- Setup Loading Indicator & Progress Dialog ---
-    QMovie loadingMovie(":/images/loading.gif"); // Use stack variable if movie is temporary
-    if (!loadingMovie.isValid()) {
-        qWarning() << "Loading GIF not valid:"
-                   << ":/images/loading.gif";
-        // Continue without movie, maybe show text?
-        ui->txt_loading->setText("Processing...");
-        ui->txt_loading->show();
-    } else {
-        ui->txt_loading->setMovie(&loadingMovie);
-        ui->txt_loading->setScaledContents(true);
-        ui->txt_loading->show();
-        loadingMovie.start();
-    }
-    qApp->processEvents(); // Allow UI to update
-
-    QProgressDialog progressDialog("Trimming silence...", "Cancel", 0, 0, this);
-    progressDialog.setWindowModality(Qt::WindowModal);
-    progressDialog.setValue(0);
-    progressDialog.show();
-    qApp->processEvents();
-    // --- End Setup ---
-
-    QSqlQuery querySelect(db);
-    QString selectStr = "SELECT path FROM musics"; // Only need the path
-    int totalFiles = 0;
-
-    // First count the files for the progress bar
-    if (querySelect.exec("SELECT COUNT(*) FROM musics")) {
-        if (querySelect.next()) {
-            totalFiles = querySelect.value(0).toInt();
-        }
-    } else {
-        qWarning() << "Failed to count records:" << querySelect.lastError();
-        // Proceed without accurate progress max? Or abort? Let's try proceeding.
-    }
-    progressDialog.setMaximum(totalFiles > 0 ? totalFiles : 100); // Set max for progress bar
-    qApp->processEvents();
-
-    // Now get the paths
-    if (!querySelect.exec(selectStr)) {
-        qWarning() << "Failed to SELECT paths from musics:" << querySelect.lastError();
-        QMessageBox::critical(this, "Database Error",
-                              "Failed to query the musics table for paths.");
-        loadingMovie.stop();
-        ui->txt_loading->hide();
-        progressDialog.cancel();
+    const QStringList paths = existingLibraryPaths();
+    if (paths.isEmpty()) {
+        QMessageBox::information(this, "Library Analysis", "There are no tracks to analyze.");
         return;
     }
 
-    int processedCount = 0;
-    int successCount = 0;
-    int failCount = 0;
-    bool cancelled = false;
+    qInfo() << "Analysis: analyzing" << paths.size() << "tracks with"
+            << analysisPipeline->maxWorkers() << "workers";
+    analysisProgress->showProgress("Analyzing the tracks", QString(), 0, paths.size());
+    analysisPipeline->scan(paths);
+}
 
-    QTemporaryDir tempDir; // Creates a unique temporary directory
-    if (!tempDir.isValid()) {
-        qWarning() << "Failed to create temporary directory:" << tempDir.errorString();
-        QMessageBox::critical(this, "File System Error",
-                              "Could not create a temporary directory to process files.");
-        loadingMovie.stop();
-        ui->txt_loading->hide();
-        progressDialog.cancel();
+void player::on_actionFind_duplicate_tracks_in_the_database_triggered() {
+    if (!adb.isOpen()) {
+        QMessageBox::critical(this, "Database Error", "Database connection is not open.");
         return;
     }
-    qInfo() << "Using temporary directory:" << tempDir.path();
-
-    while (querySelect.next() && !cancelled) {
-        processedCount++;
-        progressDialog.setValue(processedCount);
-        QString originalPath = querySelect.value(0).toString();
-        QFileInfo originalFileInfo(originalPath);
-
-        progressDialog.setLabelText(QString("Processing [%1/%2]:\n%3")
-                                        .arg(processedCount)
-                                        .arg(totalFiles)
-                                        .arg(originalFileInfo.fileName()));
-        qApp->processEvents(); // Keep UI responsive and check for Cancel button
-
-        if (progressDialog.wasCanceled()) {
-            qInfo() << "User cancelled the operation.";
-            cancelled = true;
-            break;
-        }
-
-        qInfo().noquote() << "AutoTrim Processing [" << processedCount << "/" << totalFiles
-                          << "]:" << originalPath;
-
-        if (!originalFileInfo.exists() || !originalFileInfo.isFile()) {
-            qWarning() << "File does not exist or is not a regular file:" << originalPath;
-            failCount++;
-            continue; // Skip to next file
-        }
-
-        // --- Prepare temporary output path ---
-        // Use original filename but in the temporary directory
-        QString tempOutputPath = tempDir.filePath(originalFileInfo.fileName());
-        qDebug() << "Temporary output path:" << tempOutputPath;
-
-        // --- Run SOX ---
-        QProcess soxProcess;
-        QStringList soxArgs;
-        soxArgs << originalPath   // Input file
-                << tempOutputPath // Output file
-                << "silence"      // Effect name
-                << "1"            // Detect silence around the file (mode)
-                << "0.1"          // Stop point (duration in seconds)
-                << "1%"; // Threshold (e.g., 0.1% or 1%) - NOTE: You had 0.1% in question, 1% in
-                         // code. Using 1% as per code.
-
-        qDebug() << "Running command:" << soxPath << soxArgs;
-
-        soxProcess.start(soxPath, soxArgs);
-
-        // Wait for SOX to finish (adjust timeout if needed, -1 means wait indefinitely)
-        // Use a reasonable timeout, e.g., 5 minutes (300000 ms) for potentially large files
-        if (!soxProcess.waitForFinished(300000)) {
-            qWarning() << "Sox process timed out for:" << originalPath << soxProcess.errorString();
-            soxProcess.kill();
-            soxProcess.waitForFinished(1000); // Wait a bit after killing
-            failCount++;
-            continue; // Skip to next file
-        }
-
-        // Check SOX execution result
-        if (soxProcess.exitStatus() != QProcess::NormalExit || soxProcess.exitCode() != 0) {
-            qWarning() << "Sox process failed for:" << originalPath
-                       << "Exit code:" << soxProcess.exitCode()
-                       << "Exit status:" << soxProcess.exitStatus();
-            QString errorOutput = QString::fromLocal8Bit(soxProcess.readAllStandardError());
-            qWarning() << "Sox Standard Error:\n" << errorOutput;
-            // Clean up potentially incomplete temp file before continuing
-            QFile::remove(tempOutputPath);
-            failCount++;
-            continue; // Skip to next file
-        }
-
-        // --- Check if temp file was created and is valid ---
-        QFileInfo tempFileInfo(tempOutputPath);
-        if (!tempFileInfo.exists() || tempFileInfo.size() == 0) {
-            qWarning() << "Sox finished successfully but the output file is missing or empty:"
-                       << tempOutputPath;
-            // Clean up potentially empty temp file
-            QFile::remove(tempOutputPath);
-            failCount++;
-            continue; // Skip to next file
-        }
-
-        qDebug() << "Sox completed successfully. Temp file size:" << tempFileInfo.size();
-
-        // --- Replace original file with trimmed version ---
-        // QFile::rename will overwrite the destination if it exists on most platforms.
-        // This is atomic on many filesystems (safer than delete then move).
-        bool renamed = QFile::rename(tempOutputPath, originalPath);
-
-        if (!renamed) {
-            // Rename failed. Maybe permissions issue, file lock, cross-device move?
-            // Try copy & delete as a fallback (less safe, not atomic)
-            qWarning() << "QFile::rename failed for" << tempOutputPath << "to" << originalPath
-                       << ". Attempting copy and delete.";
-            if (QFile::copy(tempOutputPath, originalPath)) {
-                qDebug() << "Copy successful. Now removing temporary file.";
-                if (!QFile::remove(tempOutputPath)) {
-                    qWarning() << "Failed to remove temporary file after successful copy:"
-                               << tempOutputPath;
-                    // Continue, main goal achieved, but temp file left behind.
-                }
-                successCount++;
-                qInfo() << "File trimmed and replaced (using copy/delete):" << originalPath;
-            } else {
-                qWarning() << "Fallback copy failed for:" << tempOutputPath << "to" << originalPath;
-                // Clean up temp file if copy failed
-                QFile::remove(tempOutputPath);
-                failCount++;
-                continue; // Skip to next file
-            }
-        } else {
-            // Rename successful! The temp file is now gone (moved).
-            successCount++;
-            qInfo() << "File trimmed and replaced (using rename):" << originalPath;
-        }
-        // --- End Replace ---
-
-    } // End while loop
-
-    // --- Cleanup and Summary ---
-    loadingMovie.stop();
-    ui->txt_loading->hide();
-    progressDialog.cancel(); // Close the progress dialog cleanly
-
-    // Temporary directory (`tempDir`) is automatically removed here when it goes out of scope.
-
-    QString summaryMessage;
-    if (cancelled) {
-        summaryMessage =
-            QString("Operation Cancelled.\n\nProcessed: %1\nSuccessfully Trimmed: "
-                    "%2\nFailed/Skipped: %3")
-                .arg(processedCount - 1) // Don't count the one being processed when cancelled
-                .arg(successCount)
-                .arg(failCount);
-    } else {
-        summaryMessage = QString("Auto-Trim Complete.\n\nTotal Records: %1\nSuccessfully Trimmed: "
-                                 "%2\nFailed/Skipped: %3")
-                             .arg(totalFiles)
-                             .arg(successCount)
-                             .arg(failCount);
+    if (contentHashScanner->isRunning()) {
+        QMessageBox::information(this, "Duplicate Tracks",
+                                 "The tracks are already being compared.");
+        return;
     }
 
-    qInfo() << "-------------------------------------";
-    qInfo() << summaryMessage.replace("\n\n", " | "); // Log summary concisely
-    qInfo() << "-------------------------------------";
+    // Only tracks added before content hashing need to be read
+    const QStringList paths = musicRepository->getPathsWithoutContentHash();
+    if (paths.isEmpty()) {
+        showDuplicateReport();
+        return;
+    }
 
-    QMessageBox::information(this, "Operation Summary", summaryMessage);
+    qInfo() << "Duplicates: hashing" << paths.size() << "tracks with"
+            << contentHashScanner->maxWorkers() << "workers";
+    contentHashProgress->showProgress("Comparing the tracks in the database", QString(), 0,
+                                      paths.size());
+    contentHashScanner->scan(paths);
 }
 
 void player::on_actionUpdate_System_triggered() {
@@ -5612,7 +5522,7 @@ void player::on_bt_apply_multi_selection_clicked() {
     QSqlDatabase db = QSqlDatabase::database("xfb_connection");
     int accao = ui->cbox_multi_select->currentIndex();
 
-    qDebug() << "ComboBox action: " << accao;
+    qCDebug(xfbPlayer) << "ComboBox action: " << accao;
 
     if (accao == 1) {
         // name them in debugger
@@ -5622,648 +5532,80 @@ void player::on_bt_apply_multi_selection_clicked() {
         foreach (QModelIndex index, indexlist) {
             if (index.row() != row) {
                 row = index.row();
-                qDebug() << "This row is selected: " << row;
-                qDebug() << ui->musicView->model()
-                                ->data(ui->musicView->model()->index(row, 7))
-                                .toString();
+                qCDebug(xfbPlayer) << "This row is selected: " << row;
+                qCDebug(xfbPlayer) << ui->musicView->model()
+                                          ->data(ui->musicView->model()->index(row, 7))
+                                          .toString();
             }
         }
     }
 
     if (accao == 2) {
         // rm them
-
-        {
-            QMessageBox::StandardButton go;
-            go = QMessageBox::question(
-                this, tr("Sure?"),
-                tr("Are you sure you want to delete all the selected track from the database?"),
-                QMessageBox::Yes | QMessageBox::No);
-            if (go == QMessageBox::Yes) {
-                QMessageBox::StandardButton rm;
-                rm = QMessageBox::question(
-                    this, tr("Erase the files also?"),
-                    tr("Do you want to delete all the selected files from the hard drive also?"),
-                    QMessageBox::Yes | QMessageBox::No);
-
-                QModelIndexList indexlist = ui->musicView->selectionModel()->selectedIndexes();
-                int row;
-                foreach (QModelIndex index, indexlist) {
-                    if (index.row() != row) {
-                        row = index.row();
-                        qDebug() << "This row is selected: " << row;
-                        QString thisfilename = ui->musicView->model()
-                                                   ->data(ui->musicView->model()->index(row, 7))
-                                                   .toString();
-
-                        QString qry = "delete from musics where path='" + thisfilename + "'";
-                        QSqlQuery sql(db);
-
-                        if (sql.exec(qry)) {
-                            qDebug() << "Track removed from the database: " << thisfilename;
-                        } else {
-                            QMessageBox::critical(this, tr("Error"), sql.lastError().text());
-                            qDebug() << "last sql: " << sql.lastQuery();
-                        }
-
-                        if (rm == QMessageBox::Yes) {
-                            qInfo()
-                                << "User confirmed deletion. Attempting to delete file from disk:"
-                                << thisfilename;
-
-                            // --- Use Qt's QFile::remove for platform-independent deletion ---
-
-                            // Optional: Check existence first, though remove() handles non-existent
-                            // files gracefully (returns false)
-                            if (!QFile::exists(thisfilename)) {
-                                qWarning() << "File no longer exists or path is incorrect:"
-                                           << thisfilename;
-                                // You might want to inform the user or just proceed as if deleted
-                                QMessageBox::information(
-                                    this, "File Not Found",
-                                    QString("The file\n%1\ncould not be found. It might have been "
-                                            "deleted already.")
-                                        .arg(thisfilename));
-                            } else {
-                                // Attempt the deletion
-                                bool success = QFile::remove(thisfilename);
-
-                                if (success) {
-                                    qInfo()
-                                        << "File successfully deleted from disk:" << thisfilename;
-                                    // Optional: A small confirmation message if desired, often
-                                    // logging is enough. QMessageBox::information(this, "Success",
-                                    // QString("File deleted:\n%1").arg(thisfilename));
-                                } else {
-                                    // Deletion failed - Log the error and inform the user
-                                    // Note: QFile::errorString() isn't always set reliably after
-                                    // remove(),
-                                    //       so checking the return value is the primary way.
-                                    qWarning()
-                                        << "Failed to delete file from disk:" << thisfilename;
-                                    QMessageBox::warning(
-                                        this, "Deletion Failed",
-                                        QString(
-                                            "Could not delete the file:\n%1\n\nPlease check file "
-                                            "permissions or if the file is currently in use.")
-                                            .arg(thisfilename));
-                                }
-                            }
-                            // --- End of QFile::remove usage ---
-
-                        } else {
-                            qDebug() << "User cancelled file deletion for:" << thisfilename;
-                        }
-                    }
-                }
-
-                update_music_table();
-            }
-        }
-    }
-
-    if (accao == 3) {
-        QSqlDatabase db = QSqlDatabase::database("xfb_connection"); // Or pass it in
-        if (!db.isOpen()) {
-            qWarning() << "Database connection 'xfb_connection' is not open!";
-            QMessageBox::critical(this, "Database Error", "Database connection is not open.");
+        const QList<int> rows =
+            BulkTrackOperations::uniqueRows(ui->musicView->selectionModel()->selectedIndexes());
+        if (rows.isEmpty())
             return;
-        }
-
-        // --- Check for FFMPEG executable ---
-        QString ffmpegPath = QStandardPaths::findExecutable("ffmpeg");
-        if (ffmpegPath.isEmpty()) {
-            qWarning() << "'ffmpeg' command not found in system PATH.";
-            QMessageBox::critical(this, "Missing Dependency",
-                                  "The 'ffmpeg' command is required for audio conversion "
-                                  "but was not found in the system's PATH.\n\nPlease install "
-                                  "ffmpeg and ensure it's accessible.");
-            return;
-        }
-        qInfo() << "Found ffmpeg executable at:" << ffmpegPath;
-        // --- End FFMPEG check ---
-
-        // --- Get Selected Files ---
-        QModelIndexList selectedIndexes = ui->musicView->selectionModel()->selectedIndexes();
-        QSet<int> uniqueRows; // Use a QSet to get unique row numbers easily
-        for (const QModelIndex& index : selectedIndexes) {
-            uniqueRows.insert(index.row());
-        }
-
-        if (uniqueRows.isEmpty()) {
-            QMessageBox::information(this, "No Selection",
-                                     "Please select one or more tracks in the list to convert.");
-            return;
-        }
-
-        int totalFilesToProcess = uniqueRows.size();
-        qInfo() << "Found" << totalFilesToProcess << "unique rows selected for conversion.";
-
-        // --- Confirmation ---
-        QMessageBox::StandardButton confirm =
-            QMessageBox::question(this, "Confirm Conversion",
-                                  QString("Convert %1 selected track(s) to MP3 (192kbps)?\n\n"
-                                          "Original files will be replaced with the MP3 version.\n"
-                                          "This action cannot be undone.\n\n"
-                                          "Note: Only the audio stream will be kept.")
-                                      .arg(totalFilesToProcess),
-                                  QMessageBox::Yes | QMessageBox::No);
-
-        if (confirm == QMessageBox::No) {
-            return;
-        }
-
-        // --- Setup Progress Dialog ---
-        QProgressDialog progressDialog("Converting to MP3...", "Cancel", 0, totalFilesToProcess,
-                                       this);
-        progressDialog.setWindowModality(Qt::WindowModal);
-        progressDialog.setValue(0);
-        progressDialog.show();
-        qApp->processEvents(); // Allow UI to update
-
-        // --- Prepare Database Query (outside loop) ---
-        QSqlQuery queryUpdate(db);
-        if (!queryUpdate.prepare("UPDATE musics SET path = :new_path WHERE path = :old_path")) {
-            qWarning() << "Failed to prepare database UPDATE statement:" << queryUpdate.lastError();
-            QMessageBox::critical(this, "Database Error",
-                                  "Failed to prepare database query for updating paths.");
-            progressDialog.cancel();
-            return;
-        }
-
-        // --- Get Temporary Directory ---
-        QString tempDirPath = QStandardPaths::writableLocation(QStandardPaths::TempLocation);
-        if (tempDirPath.isEmpty()) {
-            qWarning() << "Could not find a writable temporary location.";
-            QMessageBox::critical(this, "File System Error",
-                                  "Cannot find a suitable temporary directory for conversion.");
-            progressDialog.cancel();
-            return;
-        }
-        QDir tempDir(tempDirPath);
-        qInfo() << "Using temporary directory:" << tempDirPath;
-
-        // --- Process Files ---
-        int successCount = 0;
-        int failCount = 0;
-        bool cancelled = false;
-
-        // Convert QSet to QList to iterate in a defined order (optional, but often useful)
-        QList<int> rowsToProcess = uniqueRows.values();
-        std::sort(rowsToProcess.begin(), rowsToProcess.end()); // Sort rows numerically
-
-        for (int row : rowsToProcess) {
-            if (progressDialog.wasCanceled()) {
-                cancelled = true;
-                break;
-            }
-
-            progressDialog.setValue(successCount + failCount); // Update progress
-            qApp->processEvents();
-
-            // Get original file path from model (assuming column 7)
-            QModelIndex pathIndex = ui->musicView->model()->index(row, 7);
-            QString originalPath = ui->musicView->model()->data(pathIndex).toString();
-            QFileInfo originalFileInfo(originalPath);
-
-            progressDialog.setLabelText(QString("Converting [%1/%2]:\n%3")
-                                            .arg(successCount + failCount + 1)
-                                            .arg(totalFilesToProcess)
-                                            .arg(originalFileInfo.fileName()));
-            qApp->processEvents();
-
-            qInfo().noquote() << "Processing [" << (successCount + failCount + 1) << "/"
-                              << totalFilesToProcess << "]:" << originalPath;
-
-            if (!originalFileInfo.exists() || !originalFileInfo.isFile()) {
-                qWarning() << "Original file does not exist or is not a file:" << originalPath;
-                failCount++;
-                continue; // Skip to next file
-            }
-
-            // --- Prepare Paths ---
-            QString baseName = originalFileInfo.baseName();        // Name without extension
-            QString originalDir = originalFileInfo.absolutePath(); // Directory of original file
-            QString tempMp3Path =
-                tempDir.filePath(baseName + ".mp3"); // Full path for temporary MP3
-            QString finalMp3Path =
-                QDir(originalDir).filePath(baseName + ".mp3"); // Final path for MP3 in original dir
-
-            // --- Run FFMPEG ---
-            QProcess ffmpegProcess;
-            QStringList ffmpegArgs;
-            ffmpegArgs << "-i" << originalPath // Input file
-                       << "-vn"                // No video output
-                       << "-ar"
-                       << "44100" // Audio sample rate
-                       << "-ac"
-                       << "2" // Audio channels (stereo)
-                       << "-b:a"
-                       << "192k" // Audio bitrate (use -b:a for modern ffmpeg) - was -ab
-                       << "-f"
-                       << "mp3"        // Force output format (usually optional)
-                       << tempMp3Path; // Output file path
-
-            qDebug() << "Running command:" << ffmpegPath << ffmpegArgs;
-
-            ffmpegProcess.start(ffmpegPath, ffmpegArgs);
-
-            // Wait for ffmpeg (e.g., 10 min timeout for potentially large files/slow conversion)
-            if (!ffmpegProcess.waitForFinished(600000)) {
-                qWarning() << "ffmpeg process timed out for:" << originalPath
-                           << ffmpegProcess.errorString();
-                ffmpegProcess.kill();
-                ffmpegProcess.waitForFinished(1000);
-                QFile::remove(tempMp3Path); // Clean up incomplete temp file
-                failCount++;
-                continue;
-            }
-
-            // Check ffmpeg result
-            if (ffmpegProcess.exitStatus() != QProcess::NormalExit ||
-                ffmpegProcess.exitCode() != 0) {
-                qWarning() << "ffmpeg process failed for:" << originalPath
-                           << "Exit code:" << ffmpegProcess.exitCode()
-                           << "Exit status:" << ffmpegProcess.exitStatus();
-                QString errorOutput = QString::fromLocal8Bit(ffmpegProcess.readAllStandardError());
-                qWarning() << "ffmpeg Standard Error:\n" << errorOutput;
-                QFile::remove(tempMp3Path); // Clean up potentially failed temp file
-                failCount++;
-                continue;
-            }
-
-            // Check if temp MP3 exists and has size
-            QFileInfo tempMp3Info(tempMp3Path);
-            if (!tempMp3Info.exists() || tempMp3Info.size() == 0) {
-                qWarning()
-                    << "ffmpeg finished successfully but the output MP3 file is missing or empty:"
-                    << tempMp3Path;
-                QFile::remove(tempMp3Path);
-                failCount++;
-                continue;
-            }
-
-            qInfo() << "ffmpeg conversion successful for:" << originalPath << " -> " << tempMp3Path;
-
-            // --- Delete Original File ---
-            qInfo() << "Attempting to delete original file:" << originalPath;
-            if (!QFile::remove(originalPath)) {
-                qWarning() << "Failed to delete original file:" << originalPath
-                           << ". Skipping move and database update.";
-                // Don't delete the temp MP3 - user might want it
-                // Consider moving temp MP3 to a known 'failed' folder? For now, just leave it in
-                // temp.
-                failCount++;
-                continue; // Skip rest of steps for this file
-            }
-            qInfo() << "Original file deleted successfully.";
-
-            // --- Move Temporary MP3 to Final Location ---
-            qInfo() << "Attempting to move" << tempMp3Path << "to" << finalMp3Path;
-            if (!QFile::rename(tempMp3Path, finalMp3Path)) {
-                qWarning() << "Failed to move temporary MP3" << tempMp3Path << "to" << finalMp3Path
-                           << ". The original file was deleted! MP3 remains in temp folder.";
-                // This is a problematic state - original is gone, MP3 is stuck in temp.
-                // Inform the user strongly.
-                QMessageBox::warning(
-                    this, "Move Failed",
-                    QString("Failed to move the converted MP3 to its final destination:\n%1\n\n"
-                            "The original file was deleted, but the MP3 remains in the temporary "
-                            "folder:\n%2\n\n"
-                            "Please move it manually and check the database record.")
-                        .arg(finalMp3Path)
-                        .arg(tempMp3Path));
-                failCount++;
-                continue; // Cannot update DB path if move failed
-            }
-            qInfo() << "MP3 moved successfully to:" << finalMp3Path;
-
-            // --- Update Database ---
-            qInfo() << "Updating database: set path =" << finalMp3Path
-                    << "where path =" << originalPath;
-            queryUpdate.bindValue(":new_path", finalMp3Path);
-            queryUpdate.bindValue(":old_path", originalPath);
-
-            if (!queryUpdate.exec()) {
-                qWarning() << "Failed to update database path for:" << originalPath << "->"
-                           << finalMp3Path;
-                qWarning() << "DB Error:" << queryUpdate.lastError().text();
-                qWarning() << "Last Query:"
-                           << queryUpdate.lastQuery(); // See bound values if driver supports it
-                // The file was converted and moved, but the DB is out of sync.
-                QMessageBox::warning(
-                    this, "Database Update Failed",
-                    QString("The file was successfully converted and moved to:\n%1\n\n"
-                            "However, updating the database record failed:\n%2\n\n"
-                            "Please check the database manually.")
-                        .arg(finalMp3Path)
-                        .arg(queryUpdate.lastError().text()));
-                failCount++; // Count as failure since DB update is critical
-            } else {
-                qInfo() << "Database path updated successfully.";
-                successCount++;
-                // update_music_table(); // Consider updating only once at the end for performance
-            }
-
-        } // End for loop
-
-        // --- Final Cleanup & Summary ---
-        progressDialog.cancel(); // Close progress dialog
-
-        update_music_table(); // Update the table view once after all operations
-
-        QString summaryMessage;
-        if (cancelled) {
-            summaryMessage =
-                QString("Operation Cancelled.\n\nSuccessfully Converted: %1\nFailed/Skipped: %2")
-                    .arg(successCount)
-                    .arg(failCount);
-        } else {
-            summaryMessage = QString("Conversion Complete.\n\nTotal Selected: %1\nSuccessfully "
-                                     "Converted: %2\nFailed/Skipped: %3")
-                                 .arg(totalFilesToProcess)
-                                 .arg(successCount)
-                                 .arg(failCount);
-        }
 
-        qInfo() << "-------------------------------------";
-        qInfo() << summaryMessage.replace("\n\n", " | "); // Log summary concisely
-        qInfo() << "-------------------------------------";
-
-        QMessageBox::information(this, "Conversion Summary", summaryMessage);
-    }
-
-    if (accao == 4) {
-        QSqlDatabase db = QSqlDatabase::database("xfb_connection"); // Or pass it in
-        if (!db.isOpen()) {
-            qWarning() << "Database connection 'xfb_connection' is not open!";
-            QMessageBox::critical(this, "Database Error", "Database connection is not open.");
-            return;
-        }
-
-        // --- Check for FFMPEG executable ---
-        QString ffmpegPath = QStandardPaths::findExecutable("ffmpeg");
-        if (ffmpegPath.isEmpty()) {
-            qWarning() << "'ffmpeg' command not found in system PATH.";
-            QMessageBox::critical(this, "Missing Dependency",
-                                  "The 'ffmpeg' command is required for audio conversion "
-                                  "but was not found in the system's PATH.\n\nPlease install "
-                                  "ffmpeg and ensure it's accessible.");
+        QMessageBox::StandardButton go;
+        go = QMessageBox::question(
+            this, tr("Sure?"),
+            tr("Are you sure you want to delete all the selected track from the database?"),
+            QMessageBox::Yes | QMessageBox::No);
+        if (go != QMessageBox::Yes)
             return;
-        }
-        qInfo() << "Found ffmpeg executable at:" << ffmpegPath;
-        // --- End FFMPEG check ---
-
-        // --- Get Selected Files ---
-        QModelIndexList selectedIndexes = ui->musicView->selectionModel()->selectedIndexes();
-        QSet<int> uniqueRows; // Use a QSet to get unique row numbers easily
-        for (const QModelIndex& index : selectedIndexes) {
-            uniqueRows.insert(index.row());
-        }
+        QMessageBox::StandardButton rm;
+        rm = QMessageBox::question(
+            this, tr("Erase the files also?"),
+            tr("Do you want to delete all the selected files from the hard drive also?"),
+            QMessageBox::Yes | QMessageBox::No);
 
-        if (uniqueRows.isEmpty()) {
+        // One transaction for the lot; the rows go from the view as they are
+        // deleted and the files are removed in the background
+        QList<int> ids;
+        ids.reserve(rows.size());
+        for (int row : rows)
+            ids.append(int(musicsModel->keyOf(row)));
+        if (bulkOperations->removeTracks(ids, rm == QMessageBox::Yes) < 0)
+            QMessageBox::critical(this, tr("Error"),
+                                  tr("The selected tracks could not be deleted; see the log."));
+    }
+
+    if (accao == 3 || accao == 4) {
+        // Both conversions go to the transcoder's worker pool, which keeps
+        // every core busy and lets the user carry on while it runs
+        const QStringList paths = selectedPaths();
+        if (paths.isEmpty()) {
             QMessageBox::information(this, "No Selection",
                                      "Please select one or more tracks in the list to convert.");
             return;
         }
+        const bool mp3 = accao == 3;
+        qInfo() << "Found" << paths.size() << "unique rows selected for conversion to"
+                << (mp3 ? "MP3" : "Ogg Vorbis");
 
-        int totalFilesToProcess = uniqueRows.size();
-        qInfo() << "Found" << totalFilesToProcess
-                << "unique rows selected for conversion to Ogg Vorbis.";
-
-        // --- Confirmation ---
-        // Adjusted confirmation message for Ogg Vorbis (quality scale 7)
         QMessageBox::StandardButton confirm = QMessageBox::question(
             this, "Confirm Conversion",
-            QString("Convert %1 selected track(s) to Ogg Vorbis (Quality ~7)?\n\n"
-                    "Original files will be replaced with the Ogg version.\n"
-                    "This action cannot be undone.\n\n"
+            QString("Convert %1 selected track(s) to %2?\n\n"
+                    "Each original file is replaced with the %3 version once it is converted.\n"
+                    "This action cannot be undone. Up to %4 tracks are converted at once.\n\n"
                     "Note: Only the audio stream will be kept.")
-                .arg(totalFilesToProcess),
+                .arg(paths.size())
+                .arg(mp3 ? "MP3 (192kbps)" : "Ogg Vorbis (Quality ~7)")
+                .arg(mp3 ? "MP3" : "Ogg")
+                .arg(transcoder->maxWorkers()),
             QMessageBox::Yes | QMessageBox::No);
-
-        if (confirm == QMessageBox::No) {
-            return;
-        }
-
-        // --- Setup Progress Dialog ---
-        // Adjusted progress dialog title
-        QProgressDialog progressDialog("Converting to Ogg Vorbis...", "Cancel", 0,
-                                       totalFilesToProcess, this);
-        progressDialog.setWindowModality(Qt::WindowModal);
-        progressDialog.setValue(0);
-        progressDialog.show();
-        qApp->processEvents(); // Allow UI to update
-
-        // --- Prepare Database Query (outside loop) ---
-        QSqlQuery queryUpdate(db);
-        // Using single quotes for string literals in SQL might be less portable
-        // but stick to original if required by specific DB. Prepared statements handle this better.
-        if (!queryUpdate.prepare("UPDATE musics SET path = :new_path WHERE path = :old_path")) {
-            qWarning() << "Failed to prepare database UPDATE statement:" << queryUpdate.lastError();
-            QMessageBox::critical(this, "Database Error",
-                                  "Failed to prepare database query for updating paths.");
-            progressDialog.cancel();
-            return;
-        }
-
-        // --- Get Temporary Directory ---
-        QString tempDirPath = QStandardPaths::writableLocation(QStandardPaths::TempLocation);
-        if (tempDirPath.isEmpty()) {
-            qWarning() << "Could not find a writable temporary location.";
-            QMessageBox::critical(this, "File System Error",
-                                  "Cannot find a suitable temporary directory for conversion.");
-            progressDialog.cancel();
+        if (confirm != QMessageBox::Yes)
             return;
-        }
-        QDir tempDir(tempDirPath);
-        qInfo() << "Using temporary directory:" << tempDirPath;
-
-        // --- Process Files ---
-        int successCount = 0;
-        int failCount = 0;
-        bool cancelled = false;
-
-        QList<int> rowsToProcess = uniqueRows.values();
-        std::sort(rowsToProcess.begin(), rowsToProcess.end());
-
-        for (int row : rowsToProcess) {
-            if (progressDialog.wasCanceled()) {
-                cancelled = true;
-                break;
-            }
-
-            progressDialog.setValue(successCount + failCount); // Update progress
-            qApp->processEvents();
-
-            // Get original file path from model (assuming column 7)
-            QModelIndex pathIndex = ui->musicView->model()->index(row, 7);
-            QString originalPath = ui->musicView->model()->data(pathIndex).toString();
-            QFileInfo originalFileInfo(originalPath);
-
-            // Adjust progress label text
-            progressDialog.setLabelText(QString("Converting [%1/%2]:\n%3")
-                                            .arg(successCount + failCount + 1)
-                                            .arg(totalFilesToProcess)
-                                            .arg(originalFileInfo.fileName()));
-            qApp->processEvents();
-
-            qInfo().noquote() << "Processing [" << (successCount + failCount + 1) << "/"
-                              << totalFilesToProcess << "]:" << originalPath;
-
-            if (!originalFileInfo.exists() || !originalFileInfo.isFile()) {
-                qWarning() << "Original file does not exist or is not a file:" << originalPath;
-                failCount++;
-                continue; // Skip to next file
-            }
-
-            // --- Prepare Paths ---
-            QString baseName = originalFileInfo.baseName();
-            QString originalDir = originalFileInfo.absolutePath();
-            // Construct Ogg paths
-            QString tempOggPath = tempDir.filePath(baseName + ".ogg");
-            QString finalOggPath = QDir(originalDir).filePath(baseName + ".ogg");
-
-            // --- Run FFMPEG ---
-            QProcess ffmpegProcess;
-            QStringList ffmpegArgs;
-            // Adjusted ffmpeg arguments for Ogg Vorbis
-            ffmpegArgs << "-i" << originalPath // Input file
-                       << "-c:a"
-                       << "libvorbis" // Audio codec: libvorbis
-                       << "-qscale:a"
-                       << "7"          // Quality scale (adjust as needed, 5-7 is common)
-                       << tempOggPath; // Output file path
-
-            qDebug() << "Running command:" << ffmpegPath << ffmpegArgs;
-
-            ffmpegProcess.start(ffmpegPath, ffmpegArgs);
-
-            // Wait for ffmpeg (adjust timeout if needed)
-            if (!ffmpegProcess.waitForFinished(600000)) { // 10 min timeout
-                qWarning() << "ffmpeg process timed out for:" << originalPath
-                           << ffmpegProcess.errorString();
-                ffmpegProcess.kill();
-                ffmpegProcess.waitForFinished(1000);
-                QFile::remove(tempOggPath); // Clean up incomplete temp file
-                failCount++;
-                continue;
-            }
-
-            // Check ffmpeg result
-            if (ffmpegProcess.exitStatus() != QProcess::NormalExit ||
-                ffmpegProcess.exitCode() != 0) {
-                qWarning() << "ffmpeg process failed for:" << originalPath
-                           << "Exit code:" << ffmpegProcess.exitCode()
-                           << "Exit status:" << ffmpegProcess.exitStatus();
-                QString errorOutput = QString::fromLocal8Bit(ffmpegProcess.readAllStandardError());
-                qWarning() << "ffmpeg Standard Error:\n" << errorOutput;
-                QFile::remove(tempOggPath); // Clean up potentially failed temp file
-                failCount++;
-                continue;
-            }
-
-            // Check if temp Ogg exists and has size
-            QFileInfo tempOggInfo(tempOggPath);
-            if (!tempOggInfo.exists() || tempOggInfo.size() == 0) {
-                qWarning()
-                    << "ffmpeg finished successfully but the output Ogg file is missing or empty:"
-                    << tempOggPath;
-                QFile::remove(tempOggPath);
-                failCount++;
-                continue;
-            }
-
-            qInfo() << "ffmpeg conversion successful for:" << originalPath << " -> " << tempOggPath;
-
-            // --- Delete Original File ---
-            qInfo() << "Attempting to delete original file:" << originalPath;
-            if (!QFile::remove(originalPath)) {
-                qWarning() << "Failed to delete original file:" << originalPath
-                           << ". Skipping move and database update.";
-                failCount++;
-                continue; // Skip rest of steps for this file
-            }
-            qInfo() << "Original file deleted successfully.";
-
-            // --- Move Temporary Ogg to Final Location ---
-            qInfo() << "Attempting to move" << tempOggPath << "to" << finalOggPath;
-            if (!QFile::rename(tempOggPath, finalOggPath)) {
-                qWarning() << "Failed to move temporary Ogg" << tempOggPath << "to" << finalOggPath
-                           << ". The original file was deleted! Ogg remains in temp folder.";
-                QMessageBox::warning(
-                    this, "Move Failed",
-                    QString(
-                        "Failed to move the converted Ogg file to its final destination:\n%1\n\n"
-                        "The original file was deleted, but the Ogg file remains in the temporary "
-                        "folder:\n%2\n\n"
-                        "Please move it manually and check the database record.")
-                        .arg(finalOggPath)
-                        .arg(tempOggPath));
-                failCount++;
-                continue; // Cannot update DB path if move failed
-            }
-            qInfo() << "Ogg file moved successfully to:" << finalOggPath;
-
-            // --- Update Database ---
-            qInfo() << "Updating database: set path =" << finalOggPath
-                    << "where path =" << originalPath;
-            queryUpdate.bindValue(":new_path", finalOggPath);
-            queryUpdate.bindValue(":old_path", originalPath);
-
-            if (!queryUpdate.exec()) {
-                qWarning() << "Failed to update database path for:" << originalPath << "->"
-                           << finalOggPath;
-                qWarning() << "DB Error:" << queryUpdate.lastError().text();
-                qWarning() << "Last Query:" << queryUpdate.lastQuery();
-                QMessageBox::warning(
-                    this, "Database Update Failed",
-                    QString("The file was successfully converted and moved to:\n%1\n\n"
-                            "However, updating the database record failed:\n%2\n\n"
-                            "Please check the database manually.")
-                        .arg(finalOggPath)
-                        .arg(queryUpdate.lastError().text()));
-                failCount++; // Count as failure since DB update is critical
-            } else {
-                qInfo() << "Database path updated successfully.";
-                successCount++;
-            }
-
-        } // End for loop
-
-        // --- Final Cleanup & Summary ---
-        progressDialog.cancel(); // Close progress dialog
 
-        update_music_table(); // Update the table view once after all operations
-
-        // Adjust summary message
-        QString summaryMessage;
-        if (cancelled) {
-            summaryMessage =
-                QString(
-                    "Operation Cancelled.\n\nSuccessfully Converted to Ogg: %1\nFailed/Skipped: %2")
-                    .arg(successCount)
-                    .arg(failCount);
-        } else {
-            summaryMessage = QString("Ogg Conversion Complete.\n\nTotal Selected: %1\nSuccessfully "
-                                     "Converted: %2\nFailed/Skipped: %3")
-                                 .arg(totalFilesToProcess)
-                                 .arg(successCount)
-                                 .arg(failCount);
-        }
-
-        qInfo() << "-------------------------------------";
-        qInfo() << summaryMessage.replace("\n\n", " | "); // Log summary concisely
-        qInfo() << "-------------------------------------";
-
-        QMessageBox::information(this, "Conversion Summary", summaryMessage);
+        queueConversion(paths, mp3 ? "mp3" : "ogg");
     }
 
-    if (accao == 5) {
-        // trim
-
-        // --- Check for SOX executable ---
-        QString soxPath = QStandardPaths::findExecutable("sox");
+    if (accao == 5 || accao == 6) {
+        // Trimming runs on the shared task pool; the view stays usable and
+        // the progress shows under it, with a cancel button
+        const bool extreme = accao == 6;
+        const QString soxPath = QStandardPaths::findExecutable("sox");
         if (soxPath.isEmpty()) {
             qWarning() << "'sox' command not found in system PATH.";
             QMessageBox::critical(this, "Missing Dependency",
@@ -6273,1041 +5615,1061 @@ void player::on_bt_apply_multi_selection_clicked() {
             return;
         }
         qInfo() << "Found sox executable at:" << soxPath;
-        // --- End SOX check ---
-
-        // --- Get Selected Files ---
-        QItemSelectionModel* selectionModel = ui->musicView->selectionModel();
-        if (!selectionModel) {
-            qWarning() << "Music view selection model is null.";
-            return;
-        }
-        QModelIndexList selectedIndexes = selectionModel->selectedIndexes();
-        QSet<int> uniqueRows; // Use a QSet to get unique row numbers easily
-        for (const QModelIndex& index : selectedIndexes) {
-            uniqueRows.insert(index.row());
-        }
 
-        if (uniqueRows.isEmpty()) {
+        const QStringList paths = selectedPaths();
+        if (paths.isEmpty()) {
             QMessageBox::information(
                 this, "No Selection",
                 "Please select one or more tracks in the list to trim silence.");
             return;
         }
+        qInfo() << "Found" << paths.size() << "unique rows selected for silence trimming"
+                << (extreme ? "(0.2s threshold)." : "(0.1s threshold).");
 
-        int totalFilesToProcess = uniqueRows.size();
-        qInfo() << "Found" << totalFilesToProcess << "unique rows selected for silence trimming.";
-
-        // --- Confirmation ---
-        QMessageBox::StandardButton confirm =
-            QMessageBox::question(this, "Confirm Silence Trim",
-                                  QString("Trim silence (below 1% threshold) from the start and "
-                                          "end of %1 selected track(s)?\n\n"
-                                          "Original files will be overwritten!\n\n"
-                                          "This action cannot be undone.")
-                                      .arg(totalFilesToProcess),
-                                  QMessageBox::Yes | QMessageBox::No);
-
-        if (confirm == QMessageBox::No) {
-            return;
-        }
-
-        // --- Setup Progress Dialog ---
-        QProgressDialog progressDialog("Trimming silence...", "Cancel", 0, totalFilesToProcess,
-                                       this);
-        progressDialog.setWindowModality(Qt::WindowModal);
-        progressDialog.setValue(0);
-        progressDialog.show();
-        qApp->processEvents(); // Allow UI to update
-
-        // --- Get Temporary Directory ---
-        // Use QTemporaryDir for automatic cleanup if preferred, or standard temp location
-        QString tempDirPath = QStandardPaths::writableLocation(QStandardPaths::TempLocation);
-        if (tempDirPath.isEmpty()) {
-            qWarning() << "Could not find a writable temporary location.";
-            QMessageBox::critical(this, "File System Error",
-                                  "Cannot find a suitable temporary directory for processing.");
-            progressDialog.cancel();
-            return;
-        }
-        QDir tempDir(tempDirPath);
-        qInfo() << "Using temporary directory:" << tempDirPath;
-
-        // --- Process Files ---
-        int successCount = 0;
-        int failCount = 0;
-        bool cancelled = false;
-        QAbstractItemModel* model = ui->musicView->model();
-        if (!model) {
-            qWarning() << "Music view model is null.";
-            QMessageBox::critical(this, "Internal Error", "Cannot access the data model.");
-            progressDialog.cancel();
+        QMessageBox::StandardButton confirm = QMessageBox::question(
+            this, "Confirm Silence Trim",
+            QString("Trim silence (%1below 1% threshold) from the start and end of %2 selected "
+                    "track(s)?\n\n"
+                    "Original files will be overwritten!\n\n"
+                    "This action cannot be undone.")
+                .arg(extreme ? "0.2s duration, " : "")
+                .arg(paths.size()),
+            QMessageBox::Yes | QMessageBox::No);
+        if (confirm != QMessageBox::Yes)
             return;
-        }
-
-        // Convert QSet to QList to iterate in a defined order (optional)
-        QList<int> rowsToProcess = uniqueRows.values();
-        std::sort(rowsToProcess.begin(), rowsToProcess.end()); // Sort rows numerically
-
-        for (int row : rowsToProcess) {
-            if (progressDialog.wasCanceled()) {
-                cancelled = true;
-                break;
-            }
-
-            progressDialog.setValue(successCount + failCount); // Update progress
-            qApp->processEvents();
-
-            // Get original file path from model (assuming column 7)
-            QModelIndex pathIndex = model->index(row, 7); // Assuming column 7 holds the path
-            if (!pathIndex.isValid()) {
-                qWarning() << "Invalid model index for row" << row << ", column 7.";
-                failCount++;
-                continue;
-            }
-            QString originalPath = model->data(pathIndex).toString();
-            QFileInfo originalFileInfo(originalPath);
-
-            progressDialog.setLabelText(QString("Trimming [%1/%2]:\n%3")
-                                            .arg(successCount + failCount + 1)
-                                            .arg(totalFilesToProcess)
-                                            .arg(originalFileInfo.fileName()));
-            qApp->processEvents();
-
-            qInfo().noquote() << "Processing [" << (successCount + failCount + 1) << "/"
-                              << totalFilesToProcess << "]:" << originalPath;
-
-            if (!originalFileInfo.exists() || !originalFileInfo.isFile()) {
-                qWarning() << "Original file does not exist or is not a file:" << originalPath;
-                failCount++;
-                continue; // Skip to next file
-            }
-
-            // --- Prepare Paths ---
-            QString baseName = originalFileInfo.fileName();      // Keep full filename for temp
-            QString tempOutputPath = tempDir.filePath(baseName); // Construct full path in temp dir
-            // Ensure temp filename is unique in case multiple selections have the same filename
-            // (though unlikely if paths are unique) A more robust approach might add a unique ID or
-            // use QTemporaryFile, but simple temp path often suffices here.
-            qDebug() << "Temporary output path:" << tempOutputPath;
-
-            // --- Run SOX ---
-            QProcess soxProcess;
-            QStringList soxArgs;
-            soxArgs << originalPath   // Input file
-                    << tempOutputPath // Output file
-                    << "silence"      // Effect name
-                    << "1"            // Detect silence around the file (mode)
-                    << "0.1"          // Stop point (duration in seconds) - from original code
-                    << "1%";          // Threshold (e.g., 0.1% or 1%) - from original code
-
-            qDebug() << "Running command:" << soxPath << soxArgs;
-
-            soxProcess.start(soxPath, soxArgs);
-
-            // Wait for SOX (adjust timeout if needed, -1 means wait indefinitely)
-            if (!soxProcess.waitForFinished(300000)) { // 5 min timeout
-                qWarning() << "Sox process timed out for:" << originalPath
-                           << soxProcess.errorString();
-                soxProcess.kill();
-                soxProcess.waitForFinished(1000);
-                QFile::remove(tempOutputPath); // Clean up incomplete temp file
-                failCount++;
-                continue;
-            }
-
-            // Check SOX execution result
-            if (soxProcess.exitStatus() != QProcess::NormalExit || soxProcess.exitCode() != 0) {
-                qWarning() << "Sox process failed for:" << originalPath
-                           << "Exit code:" << soxProcess.exitCode()
-                           << "Exit status:" << soxProcess.exitStatus();
-                QString errorOutput = QString::fromLocal8Bit(soxProcess.readAllStandardError());
-                qWarning() << "Sox Standard Error:\n" << errorOutput;
-                QFile::remove(tempOutputPath); // Clean up potentially failed temp file
-                failCount++;
-                continue;
-            }
 
-            // --- Check if temp file was created and is valid ---
-            QFileInfo tempFileInfo(tempOutputPath);
-            if (!tempFileInfo.exists() || tempFileInfo.size() == 0) {
-                qWarning() << "Sox finished successfully but the output file is missing or empty:"
-                           << tempOutputPath;
-                QFile::remove(tempOutputPath);
-                failCount++;
-                continue;
-            }
-            // Optional: Check if temp file size is drastically different? Maybe not reliable.
-
-            qInfo() << "Sox completed successfully for:" << originalPath << " -> "
-                    << tempOutputPath;
-
-            // --- Replace original file with trimmed version ---
-            qInfo() << "Attempting to replace" << originalPath << "with" << tempOutputPath;
-            if (!QFile::rename(tempOutputPath, originalPath)) {
-                qWarning() << "Failed to replace original file using rename:" << originalPath
-                           << "with temp file:" << tempOutputPath;
-                // Attempt fallback copy/delete might be risky if original perms are the issue
-                // Best to leave the temp file and warn the user.
-                QMessageBox::warning(
-                    this, "Replacement Failed",
-                    QString("Could not replace the original file:\n%1\n\n"
-                            "The trimmed version remains in the temporary folder:\n%2\n\n"
-                            "Please check file permissions and replace it manually if desired.")
-                        .arg(originalPath)
-                        .arg(tempOutputPath));
-                failCount++;
-                // Do NOT delete the temp file in this case - user might want it.
-            } else {
-                qInfo() << "File trimmed and replaced successfully:" << originalPath;
-                successCount++;
-                // Temp file is gone (renamed)
-            }
-            // --- End Replace ---
-
-        } // End for loop
-
-        // --- Final Cleanup & Summary ---
-        progressDialog.cancel(); // Close progress dialog
+        trimSilence(soxPath, paths, extreme ? "0.2" : "0.1");
+    }
+}
 
-        // Note: If using QTemporaryDir, it cleans up here. If using standard temp location,
-        // successfully moved files are gone, failed temp files might remain as per logic above.
+void player::on_actionConvert_all_musics_in_the_database_to_mp3_triggered() {
+    QMessageBox::StandardButton confirm = QMessageBox::question(
+        this, "Confirm Full Conversion",
+        QString("Convert ALL tracks in the database to MP3 (192kbps)?\n\n"
+                "Each original file is replaced with the MP3 version once it is converted.\n"
+                "This action cannot be undone. Up to %1 tracks are converted at once; the "
+                "conversion can be stopped and carries on where it stopped, even after a "
+                "restart.\n\n"
+                "Note: Only the audio stream will be kept.")
+            .arg(transcoder->maxWorkers()),
+        QMessageBox::Yes | QMessageBox::No);
+    if (confirm != QMessageBox::Yes)
+        return;
 
-        QString summaryMessage;
-        if (cancelled) {
-            summaryMessage =
-                QString("Operation Cancelled.\n\nSuccessfully Trimmed: %1\nFailed/Skipped: %2")
-                    .arg(successCount)
-                    .arg(failCount);
-        } else {
-            summaryMessage = QString("Silence Trim Complete.\n\nTotal Selected: %1\nSuccessfully "
-                                     "Trimmed: %2\nFailed/Skipped: %3")
-                                 .arg(totalFilesToProcess)
-                                 .arg(successCount)
-                                 .arg(failCount);
-        }
+    const QStringList paths = libraryPaths();
+    if (!paths.isEmpty())
+        queueConversion(paths, "mp3");
+}
+void player::setupCuePoints() {
+    // Cue points from the Auto-Trim scan; tracks play from their first to
+    // their last audible moment and crossfade from their segue point,
+    // without the files being rewritten
+    cuePoints = new CuePointStore(adb, this);
+    if (cuePoints->initialize())
+        playbackEngine->setCueProvider(
+            [this](const QString& filePath) { return cuePoints->cuePoints(filePath); });
+    silenceScanner = new SilenceScanner(cuePoints, this);
+
+    cueScanProgress = new ProgressIndicatorWidget(this);
+    cueScanProgress->setCancelEnabled(true);
+    cueScanProgress->setShowElapsedTime(true);
+    cueScanProgress->setShowEstimatedTime(true);
+    ui->gridLayout->addWidget(cueScanProgress, ui->gridLayout->rowCount(), 0, 1,
+                              ui->gridLayout->columnCount());
+    connect(cueScanProgress, &ProgressIndicatorWidget::cancelRequested, silenceScanner,
+            &SilenceScanner::cancel);
+    connect(silenceScanner, &SilenceScanner::progressChanged, this, [this](int done, int total) {
+        cueScanProgress->updateProgress(done,
+                                        QString("%1 of %2 tracks analyzed").arg(done).arg(total));
+    });
+    connect(silenceScanner, &SilenceScanner::finished, this, [this](int analyzed, int failed) {
+        cueScanProgress->hideProgress();
+        QMessageBox::information(this, "Operation Summary",
+                                 QString("Auto-Trim Complete.\n\nTracks analyzed: %1\n"
+                                         "Failed/Skipped: %2\n\nTracks with cue points: %3")
+                                     .arg(analyzed)
+                                     .arg(failed)
+                                     .arg(cuePoints->count()));
+    });
+}
 
-        qInfo() << "-------------------------------------";
-        qInfo() << summaryMessage.replace("\n\n", " | "); // Log summary concisely
-        qInfo() << "-------------------------------------";
+void player::setupLoudness() {
+    // Measured loudness of the musics; with Normalize_Soft set, every track
+    // is played at the target loudness instead of its mastered level
+    replayGain = new ReplayGainStore(adb, this);
+    replayGain->initialize();
+    loudnessScanner = new LoudnessScanner(replayGain, this);
+    applyLoudnessNormalization();
+
+    loudnessProgress = new ProgressIndicatorWidget(this);
+    loudnessProgress->setCancelEnabled(true);
+    loudnessProgress->setShowElapsedTime(true);
+    loudnessProgress->setShowEstimatedTime(true);
+    ui->gridLayout->addWidget(loudnessProgress, ui->gridLayout->rowCount(), 0, 1,
+                              ui->gridLayout->columnCount());
+    connect(loudnessProgress, &ProgressIndicatorWidget::cancelRequested, loudnessScanner,
+            &LoudnessScanner::cancel);
+    connect(loudnessScanner, &LoudnessScanner::progressChanged, this, [this](int done, int total) {
+        loudnessProgress->updateProgress(done,
+                                         QString("%1 of %2 tracks measured").arg(done).arg(total));
+    });
+    connect(loudnessScanner, &LoudnessScanner::finished, this, [this](int measured, int failed) {
+        loudnessProgress->hideProgress();
+        QMessageBox::information(this, "Operation Summary",
+                                 QString("Loudness Analysis Complete.\n\nTracks measured: %1\n"
+                                         "Failed/Skipped: %2%3")
+                                     .arg(measured)
+                                     .arg(failed)
+                                     .arg(normalization_soft
+                                              ? QString()
+                                              : QString("\n\nEnable Soft Live Sound "
+                                                        "Normalization in the options to play "
+                                                        "the tracks at an even loudness.")));
+    });
+}
 
-        QMessageBox::information(this, "Operation Summary", summaryMessage);
+void player::applyLoudnessNormalization() {
+    if (!playbackEngine || !replayGain)
+        return;
+    if (!normalization_soft) {
+        playbackEngine->setGainProvider(nullptr);
+        return;
     }
+    playbackEngine->setGainProvider([this](const QString& filePath) {
+        return static_cast<float>(std::pow(10.0, replayGain->gainDb(filePath) / 20.0));
+    });
+}
 
-    if (accao == 6) {
-        // trim eXtreme 1
-        //  --- Check for SOX executable ---
-        QString soxPath = QStandardPaths::findExecutable("sox");
-        if (soxPath.isEmpty()) {
-            qWarning() << "'sox' command not found in system PATH.";
-            QMessageBox::critical(this, "Missing Dependency",
-                                  "The 'sox' command (Sound eXchange) is required for this feature "
-                                  "but was not found in the system's PATH.\n\nPlease install SoX "
-                                  "and ensure it's accessible.");
-            return;
-        }
-        qInfo() << "Found sox executable at:" << soxPath;
-        // --- End SOX check ---
-
-        // --- Get Selected Files ---
-        QItemSelectionModel* selectionModel = ui->musicView->selectionModel();
-        if (!selectionModel) {
-            qWarning() << "Music view selection model is null.";
-            return;
-        }
-        QModelIndexList selectedIndexes = selectionModel->selectedIndexes();
-        QSet<int> uniqueRows; // Use a QSet to get unique row numbers easily
-        for (const QModelIndex& index : selectedIndexes) {
-            uniqueRows.insert(index.row());
-        }
+void player::applyNativeAudio() {
+    NativeAudioOutput::Config config;
+    config.device = nativeAudioDevice;
+    config.periodFrames = nativeAudioEnabled ? nativeAudioPeriodFrames : 0;
+    config.periods = nativeAudioPeriods;
+    playbackEngine->setNativeOutput(config);
+}
+
+void player::setupProgramBuilder() {
+    // Programs are made by copying the Ogg pages of the playlist items into
+    // one chained file on a worker thread, without re-encoding them
+    programBuilder = new ProgramBuilder(this);
+
+    programProgress = new ProgressIndicatorWidget(this);
+    programProgress->setCancelEnabled(true);
+    programProgress->setShowElapsedTime(true);
+    programProgress->setShowEstimatedTime(true);
+    ui->gridLayout->addWidget(programProgress, ui->gridLayout->rowCount(), 0, 1,
+                              ui->gridLayout->columnCount());
+    connect(programProgress, &ProgressIndicatorWidget::cancelRequested, programBuilder,
+            &ProgramBuilder::cancel);
+    connect(programBuilder, &ProgramBuilder::progressChanged, this, [this](int permille) {
+        programProgress->updateProgress(permille,
+                                        QString("%1% of the playlist joined").arg(permille / 10));
+    });
+    connect(programBuilder, &ProgramBuilder::finished, this,
+            [this](bool success, const QString& destination, const QString& error) {
+                programProgress->hideProgress();
+                ui->txt_creatingPrograms->hide();
+                if (!success) {
+                    QMessageBox::warning(this, tr("Program generator"),
+                                         tr("The program could not be created:\n\n") + error);
+                    return;
+                }
+                offerProgramUpload(QFileInfo(destination).completeBaseName(), destination);
+            });
+}
 
-        if (uniqueRows.isEmpty()) {
-            QMessageBox::information(
-                this, "No Selection",
-                "Please select one or more tracks in the list to trim silence.");
-            return;
-        }
+void player::setupWaveform() {
+    // Peak files are made in the background when tracks are imported or
+    // queued, so drawing the waveform never decodes audio
+    peakGenerator = new PeakFileGenerator(
+        QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/peaks", this);
+    connect(peakGenerator, &PeakFileGenerator::peaksReady, this,
+            [this](const QString& audioPath, const QString& peakPath) {
+                if (audioPath == waveformTrack && !waveform->hasPeaks()) {
+                    waveform->setPeakFile(peakPath);
+                    waveform->setPosition(PlaybackClock::instance()->time().positionMs);
+                }
+            });
 
-        int totalFilesToProcess = uniqueRows.size();
-        qInfo() << "Found" << totalFilesToProcess
-                << "unique rows selected for silence trimming (0.2s threshold).";
-
-        // --- Confirmation ---
-        // Updated confirmation message slightly
-        QMessageBox::StandardButton confirm =
-            QMessageBox::question(this, "Confirm Silence Trim",
-                                  QString("Trim silence (0.2s duration, below 1% threshold) from "
-                                          "the start and end of %1 selected track(s)?\n\n"
-                                          "Original files will be overwritten!\n\n"
-                                          "This action cannot be undone.")
-                                      .arg(totalFilesToProcess),
-                                  QMessageBox::Yes | QMessageBox::No);
+    waveform = new WaveformWidget(this);
+    ui->verticalLayout_main->insertWidget(
+        ui->verticalLayout_main->indexOf(ui->horizontalLayout_sliders_row) + 1, waveform);
+    connect(waveform, &WaveformWidget::seekRequested, this,
+            [this](qint64 positionMs) { playbackEngine->setPosition(positionMs); });
+    connect(silenceScanner, &SilenceScanner::trackAnalyzed, this,
+            [this](const QString& filePath, const CuePoints& cue) {
+                if (filePath == waveformTrack)
+                    waveform->setCuePoints(cue);
+            });
+}
 
-        if (confirm == QMessageBox::No) {
-            return;
-        }
+void player::setupAnalysis() {
+    // Auto-Trim, loudness and peaks from a single decode of each track, for
+    // analyzing the whole library; the scanners stay for single tracks
+    analysisPipeline = new AnalysisPipeline(adb, this);
+    analysisPipeline->addAnalyzer(AnalysisPipeline::cuePoints(cuePoints));
+    analysisPipeline->addAnalyzer(AnalysisPipeline::loudness(replayGain));
+    analysisPipeline->addAnalyzer(AnalysisPipeline::peaks(peakGenerator));
+
+    analysisProgress = new ProgressIndicatorWidget(this);
+    analysisProgress->setCancelEnabled(true);
+    analysisProgress->setShowElapsedTime(true);
+    analysisProgress->setShowEstimatedTime(true);
+    ui->gridLayout->addWidget(analysisProgress, ui->gridLayout->rowCount(), 0, 1,
+                              ui->gridLayout->columnCount());
+    connect(analysisProgress, &ProgressIndicatorWidget::cancelRequested, analysisPipeline,
+            &AnalysisPipeline::cancel);
+    connect(analysisPipeline, &AnalysisPipeline::progressChanged, this,
+            [this](int done, int total) {
+                analysisProgress->updateProgress(
+                    done, QString("%1 of %2 tracks analyzed").arg(done).arg(total));
+            });
+    connect(analysisPipeline, &AnalysisPipeline::trackAnalyzed, this,
+            [this](const QString& filePath) {
+                if (filePath != waveformTrack)
+                    return;
+                waveform->setCuePoints(cuePoints->cuePoints(filePath));
+                if (!waveform->hasPeaks() && peakGenerator->isCurrent(filePath)) {
+                    waveform->setPeakFile(peakGenerator->peakPath(filePath));
+                    waveform->setPosition(PlaybackClock::instance()->time().positionMs);
+                }
+            });
+    connect(analysisPipeline, &AnalysisPipeline::finished, this, [this](int analyzed, int failed) {
+        analysisProgress->hideProgress();
+        QMessageBox::information(this, "Operation Summary",
+                                 QString("Library Analysis Complete.\n\nTracks analyzed: %1\n"
+                                         "Failed/Skipped: %2\n\nTracks with cue points: %3")
+                                     .arg(analyzed)
+                                     .arg(failed)
+                                     .arg(cuePoints->count()));
+        exportAnalysisIndexes();
+    });
+    // A library copied from another machine brings the analysis index of each root
+    QTimer::singleShot(0, this, &player::importAnalysisIndexes);
+}
 
-        // --- Setup Progress Dialog ---
-        QProgressDialog progressDialog("Trimming silence (0.2s threshold)...", "Cancel", 0,
-                                       totalFilesToProcess, this);
-        progressDialog.setWindowModality(Qt::WindowModal);
-        progressDialog.setValue(0);
-        progressDialog.show();
-        qApp->processEvents(); // Allow UI to update
-
-        // --- Get Temporary Directory ---
-        QString tempDirPath = QStandardPaths::writableLocation(QStandardPaths::TempLocation);
-        if (tempDirPath.isEmpty()) {
-            qWarning() << "Could not find a writable temporary location.";
-            QMessageBox::critical(this, "File System Error",
-                                  "Cannot find a suitable temporary directory for processing.");
-            progressDialog.cancel();
-            return;
-        }
-        QDir tempDir(tempDirPath);
-        qInfo() << "Using temporary directory:" << tempDirPath;
-
-        // --- Process Files ---
-        int successCount = 0;
-        int failCount = 0;
-        bool cancelled = false;
-        QAbstractItemModel* model = ui->musicView->model();
-        if (!model) {
-            qWarning() << "Music view model is null.";
-            QMessageBox::critical(this, "Internal Error", "Cannot access the data model.");
-            progressDialog.cancel();
-            return;
-        }
+void player::exportAnalysisIndexes() {
+    if (analysisIndexExport.isRunning())
+        return;
+    // The indexes are read from the musics table, so what is in memory goes first
+    cuePoints->flush();
+    replayGain->flush();
+    const auto currentPeaks = [this](const QString& filePath) {
+        return peakGenerator->isCurrent(filePath) ? peakGenerator->peakPath(filePath) : QString();
+    };
+    QList<QPair<QString, QList<AnalysisIndex::Entry>>> indexes;
+    for (const QString& root : std::as_const(libraryRoots)) {
+        bool ok = false;
+        QList<AnalysisIndex::Entry> entries =
+            AnalysisIndex::libraryEntries(adb, root, currentPeaks, &ok);
+        if (ok && !entries.isEmpty() && QFileInfo(root).isDir())
+            indexes.append({AnalysisIndex::defaultPath(root), std::move(entries)});
+    }
+    if (indexes.isEmpty())
+        return;
 
-        QList<int> rowsToProcess = uniqueRows.values();
-        std::sort(rowsToProcess.begin(), rowsToProcess.end());
+    // Copying in the peak files reads a lot, so it is done off the UI thread
+    analysisIndexExport = QtConcurrent::run([indexes]() {
+        for (const auto& index : indexes) {
+            QString error;
+            if (AnalysisIndex::write(index.first, index.second, &error))
+                qInfo() << "Analysis index:" << index.second.size() << "tracks written to"
+                        << index.first;
+            else
+                qWarning() << "Analysis index:" << error;
+        }
+    });
+}
 
-        for (int row : rowsToProcess) {
-            if (progressDialog.wasCanceled()) {
-                cancelled = true;
-                break;
+void player::importAnalysisIndexes() {
+    // Writes still pending would be dropped when the imported results are published
+    cuePoints->flush();
+    replayGain->flush();
+    const auto missingPeaks = [this](const QString& filePath) {
+        return peakGenerator->isCurrent(filePath) ? QString() : peakGenerator->peakPath(filePath);
+    };
+    for (const QString& root : std::as_const(libraryRoots)) {
+        AnalysisIndex index;
+        if (!index.open(AnalysisIndex::defaultPath(root)))
+            continue;
+        const QList<AnalysisIndex::Imported> imported = index.importInto(adb, root, missingPeaks);
+        for (const AnalysisIndex::Imported& track : imported) {
+            if (track.content & AnalysisIndex::HasCuePoints)
+                cuePoints->setStoredCuePoints(track.path, track.entry.cue);
+            if (track.content & AnalysisIndex::HasLoudness) {
+                ReplayGainStore::Loudness loudness;
+                loudness.integratedLufs = track.entry.integratedLufs;
+                loudness.truePeakDbtp = track.entry.truePeakDbtp;
+                replayGain->setStoredLoudness(track.path, &loudness);
             }
+            if (track.path == waveformTrack)
+                showWaveform(track.path);
+        }
+        if (!imported.isEmpty())
+            qInfo() << "Analysis index:" << imported.size() << "tracks took their analysis from"
+                    << AnalysisIndex::defaultPath(root);
+    }
+}
+
+void player::showWaveform(const QString& filePath) {
+    waveformTrack = filePath;
+    waveform->clear();
+    waveform->setCuePoints(cuePoints->cuePoints(filePath));
+    if (peakGenerator->isCurrent(filePath))
+        waveform->setPeakFile(peakGenerator->peakPath(filePath));
+    else
+        peakGenerator->generate({filePath}, true);
+}
+
+void player::setupTasks() {
+    // Background work backs off while the track on air runs low on decoded
+    // audio and in the minute before a scheduled event
+    backgroundThrottle = new BackgroundThrottle(this);
+    backgroundThrottle->setFillProvider([this]() { return playbackEngine->bufferFillPercent(); });
+    backgroundThrottle->setEventProvider(
+        [this]() { return schedulerEngine ? schedulerEngine->nextFireTime() : QDateTime(); });
+    backgroundThrottle->start();
+    // A banner refresh held back by the broadcast goes ahead once it is idle again
+    connect(backgroundThrottle, &BackgroundThrottle::levelChanged, this,
+            [this](BackgroundThrottle::Level level) {
+                if (level == BackgroundThrottle::Level::Full && adRefreshPending)
+                    refreshAdBanner();
+            });
 
-            progressDialog.setValue(successCount + failCount);
-            qApp->processEvents();
+    // One pool for long operations; the task shown is the one started last,
+    // and every task is passed on to the accessibility announcements
+    taskRunner = new TaskRunner(QThread::idealThreadCount(), this);
+    taskProgress = new ProgressIndicatorWidget(this);
+    taskProgress->setCancelEnabled(true);
+    taskProgress->setShowElapsedTime(true);
+    taskProgress->setShowEstimatedTime(true);
+    ui->gridLayout->addWidget(taskProgress, ui->gridLayout->rowCount(), 0, 1,
+                              ui->gridLayout->columnCount());
+    connect(taskProgress, &ProgressIndicatorWidget::cancelRequested, this,
+            [this]() { taskRunner->cancel(taskProgressId); });
+
+    connect(taskRunner, &TaskRunner::taskStarted, this,
+            [this](int id, const QString& title, TaskRunner::Priority priority) {
+                taskTitles.insert(id, title);
+                taskProgressId = id;
+                taskProgress->showIndeterminateProgress(title, tr("Starting"));
+                BackgroundOperationFeedback* feedback = backgroundFeedback();
+                if (feedback)
+                    taskOperations.insert(
+                        id, feedback->startOperation(
+                                title, QString(),
+                                priority == TaskRunner::Priority::Maintenance
+                                    ? BackgroundOperationFeedback::OperationType::SystemMaintenance
+                                    : BackgroundOperationFeedback::OperationType::UserOperation,
+                                priority == TaskRunner::Priority::OnAir
+                                    ? BackgroundOperationFeedback::Priority::High
+                                    : BackgroundOperationFeedback::Priority::Normal));
+            });
+    connect(taskRunner, &TaskRunner::progressChanged, this,
+            [this](int id, int done, int total, const QString& message) {
+                if (id == taskProgressId && total > 0) {
+                    taskProgress->setRange(0, total);
+                    taskProgress->updateProgress(done, message);
+                } else if (id == taskProgressId) {
+                    taskProgress->updateMessage(message);
+                }
+                const int percentage = total > 0 ? int(qint64(done) * 100 / total) : 0;
+                BackgroundOperationFeedback* feedback = backgroundFeedback();
+                if (feedback && taskOperations.contains(id))
+                    feedback->updateProgress(taskOperations.value(id), percentage, message);
+                auto* announcer = ServiceContainer::instance()->resolve<SystemStatusAnnouncer>();
+                if (announcer && total > 0)
+                    announcer->announceDatabaseProgress(taskTitles.value(id), percentage, done,
+                                                        total);
+            });
+    connect(taskRunner, &TaskRunner::taskFinished, this, [this](const TaskRunner::Result& result) {
+        taskTitles.remove(result.id);
+        const int operation = taskOperations.value(result.id, -1);
+        taskOperations.remove(result.id);
+        BackgroundOperationFeedback* feedback = backgroundFeedback();
+        if (feedback && operation >= 0) {
+            if (result.cancelled)
+                feedback->cancelOperation(operation);
+            else
+                feedback->completeOperation(operation, result.succeeded(),
+                                            result.succeeded() ? result.message : result.error);
+        }
+        auto* announcer = ServiceContainer::instance()->resolve<SystemStatusAnnouncer>();
+        if (announcer && !result.cancelled)
+            announcer->announceDatabaseCompletion(result.title, result.succeeded(),
+                                                  result.succeeded() ? result.message
+                                                                     : result.error);
+
+        if (result.id != taskProgressId)
+            return;
+        // Another task still running takes the widget over
+        if (taskTitles.isEmpty()) {
+            taskProgressId = -1;
+            taskProgress->hideProgress();
+        } else {
+            taskProgressId = taskTitles.constBegin().key();
+            taskProgress->showIndeterminateProgress(taskTitles.constBegin().value(),
+                                                    tr("Running"));
+        }
+    });
+}
 
-            QModelIndex pathIndex = model->index(row, 7); // Assuming column 7 holds the path
-            if (!pathIndex.isValid()) {
-                qWarning() << "Invalid model index for row" << row << ", column 7.";
-                failCount++;
-                continue;
-            }
-            QString originalPath = model->data(pathIndex).toString();
-            QFileInfo originalFileInfo(originalPath);
-
-            progressDialog.setLabelText(QString("Trimming [%1/%2]:\n%3")
-                                            .arg(successCount + failCount + 1)
-                                            .arg(totalFilesToProcess)
-                                            .arg(originalFileInfo.fileName()));
-            qApp->processEvents();
-
-            qInfo().noquote() << "Processing [" << (successCount + failCount + 1) << "/"
-                              << totalFilesToProcess << "]:" << originalPath;
-
-            if (!originalFileInfo.exists() || !originalFileInfo.isFile()) {
-                qWarning() << "Original file does not exist or is not a file:" << originalPath;
-                failCount++;
-                continue;
+void player::trimSilence(const QString& soxPath, const QStringList& paths,
+                         const QString& stopSeconds) {
+    taskRunner->start(
+        tr("Trimming silence (%1s threshold)").arg(stopSeconds),
+        TaskRunner::Priority::Maintenance,
+        [soxPath, paths, stopSeconds](TaskRunner::Context& context, TaskRunner::Result& result) {
+            int trimmed = 0;
+            int failed = 0;
+            for (int i = 0; i < paths.size() && !context.isCancelled(); ++i) {
+                context.pace();
+                const QString& path = paths.at(i);
+                context.setProgress(i, int(paths.size()),
+                                    QString("Trimming [%1/%2]: %3")
+                                        .arg(i + 1)
+                                        .arg(paths.size())
+                                        .arg(QFileInfo(path).fileName()));
+                QString error;
+                if (trimSilenceOf(soxPath, path, stopSeconds, context, &error)) {
+                    qInfo() << "File trimmed and replaced successfully:" << path;
+                    ++trimmed;
+                } else if (!context.isCancelled()) {
+                    qWarning() << "Could not trim silence of" << path << ":" << error;
+                    ++failed;
+                }
             }
+            context.setProgress(trimmed + failed, int(paths.size()));
+            result.message = QString("Total Selected: %1\nSuccessfully Trimmed: %2\n"
+                                     "Failed/Skipped: %3")
+                                 .arg(paths.size())
+                                 .arg(trimmed)
+                                 .arg(paths.size() - trimmed);
+        },
+        [this](const TaskRunner::Result& result) {
+            QString summary = result.cancelled ? "Operation Cancelled." : "Silence Trim Complete.";
+            if (!result.message.isEmpty())
+                summary += "\n\n" + result.message;
+            qInfo() << summary.simplified();
+            QMessageBox::information(this, "Operation Summary", summary);
+        });
+}
 
-            // --- Prepare Paths ---
-            QString baseName = originalFileInfo.fileName();
-            QString tempOutputPath = tempDir.filePath(baseName);
-            qDebug() << "Temporary output path:" << tempOutputPath;
-
-            // --- Run SOX ---
-            QProcess soxProcess;
-            QStringList soxArgs;
-            // ***** THE ONLY CHANGE IS HERE *****
-            soxArgs << originalPath   // Input file
-                    << tempOutputPath // Output file
-                    << "silence"      // Effect name
-                    << "1"            // Detect silence around the file (mode)
-                    << "0.2"          // Stop point (duration in seconds) - MODIFIED
-                    << "1%";          // Threshold (e.g., 0.1% or 1%)
-
-            qDebug() << "Running command:" << soxPath << soxArgs;
-
-            soxProcess.start(soxPath, soxArgs);
-
-            if (!soxProcess.waitForFinished(300000)) { // 5 min timeout
-                qWarning() << "Sox process timed out for:" << originalPath
-                           << soxProcess.errorString();
-                soxProcess.kill();
-                soxProcess.waitForFinished(1000);
-                QFile::remove(tempOutputPath);
-                failCount++;
-                continue;
-            }
+void player::setupTranscoder() {
+    // Library and selection conversions run in a pool of ffmpeg workers whose
+    // jobs live in the database, so a restart carries on where the last run stopped
+    transcoder = new TranscodeEngine(adb, this);
+    transcoder->setEncoder("ogg", {"-vn", "-c:a", "libvorbis", "-qscale:a", "7"});
+    transcoder->setEncoder("mp3", {"-vn", "-ar", "44100", "-ac", "2", "-b:a", "192k"});
+    transcoder->setDurationProvider(
+        [this](const QString& filePath) { return durationCache->durationUs(filePath); });
+
+    transcodeProgress = new ProgressIndicatorWidget(this);
+    transcodeProgress->setCancelEnabled(true);
+    transcodeProgress->setShowElapsedTime(true);
+    transcodeProgress->setShowEstimatedTime(true);
+    ui->gridLayout->addWidget(transcodeProgress, ui->gridLayout->rowCount(), 0, 1,
+                              ui->gridLayout->columnCount());
+    connect(transcodeProgress, &ProgressIndicatorWidget::cancelRequested, this, [this]() {
+        transcoder->stop();
+        transcodeProgress->hideProgress();
+        QMessageBox::information(this, "Conversion Paused",
+                                 QString("The conversion was stopped with %1 tracks left.\n\n"
+                                         "Choose the conversion again, or restart XFB, to carry "
+                                         "on where it stopped.")
+                                     .arg(transcoder->pendingCount()));
+    });
 
-            if (soxProcess.exitStatus() != QProcess::NormalExit || soxProcess.exitCode() != 0) {
-                qWarning() << "Sox process failed for:" << originalPath
-                           << "Exit code:" << soxProcess.exitCode()
-                           << "Exit status:" << soxProcess.exitStatus();
-                QString errorOutput = QString::fromLocal8Bit(soxProcess.readAllStandardError());
-                qWarning() << "Sox Standard Error:\n" << errorOutput;
-                QFile::remove(tempOutputPath);
-                failCount++;
-                continue;
-            }
+    connect(transcoder, &TranscodeEngine::progressChanged, this,
+            [this](const TranscodeEngine::Progress& progress) {
+                if (!transcoder->isRunning())
+                    return;
+                if (!transcodeProgress->isProgressVisible())
+                    transcodeProgress->showProgress("Converting tracks", QString(), 0, 1000);
+                transcodeProgress->updateProgress(
+                    progress.permille, QString("%1 of %2 converted, %3 failed, %4 running")
+                                           .arg(progress.done)
+                                           .arg(progress.total)
+                                           .arg(progress.failed)
+                                           .arg(progress.running));
+            });
+    connect(transcoder, &TranscodeEngine::jobFinished, this,
+            [this](const QString& source, const QString& target, bool ok, const QString&) {
+                if (!ok)
+                    return;
+                // Queued items still name the old file, which is gone now
+                durationCache->invalidate(source);
+                cuePoints->relocate(source, target);
+                replayGain->relocate(source, target);
+                playlistQueue->relocate(source, target);
+            });
+    connect(transcoder, &TranscodeEngine::finished, this, [this](int succeeded, int failed) {
+        transcodeProgress->hideProgress();
+        update_music_table();
+        QMessageBox::information(this, "Conversion Summary",
+                                 QString("Conversion Complete.\n\nSuccessfully Converted: "
+                                         "%1\nFailed: %2")
+                                     .arg(succeeded)
+                                     .arg(failed));
+    });
 
-            // --- Check if temp file was created and is valid ---
-            QFileInfo tempFileInfo(tempOutputPath);
-            if (!tempFileInfo.exists() || tempFileInfo.size() == 0) {
-                qWarning() << "Sox finished successfully but the output file is missing or empty:"
-                           << tempOutputPath;
-                QFile::remove(tempOutputPath);
-                failCount++;
-                continue;
-            }
+    if (!transcoder->initialize() || transcoder->pendingCount() == 0)
+        return;
+    const QString ffmpegPath = QStandardPaths::findExecutable("ffmpeg");
+    if (ffmpegPath.isEmpty()) {
+        qWarning() << "An interrupted library conversion cannot resume: 'ffmpeg' is not in PATH.";
+        return;
+    }
+    qInfo() << "Resuming the library conversion," << transcoder->pendingCount() << "tracks left";
+    transcoder->setProgram(ffmpegPath);
+    transcoder->start();
+}
 
-            qInfo() << "Sox completed successfully for:" << originalPath << " -> "
-                    << tempOutputPath;
+void player::setupDownloads() {
+    // Links pasted in the external downloader queue up here and download a
+    // few at a time; finished tracks reach the library in batches
+    musicRepository = new MusicRepository(adb, this);
 
-            // --- Replace original file with trimmed version ---
-            qInfo() << "Attempting to replace" << originalPath << "with" << tempOutputPath;
-            if (!QFile::rename(tempOutputPath, originalPath)) {
-                qWarning() << "Failed to replace original file using rename:" << originalPath
-                           << "with temp file:" << tempOutputPath;
+    // A selection deleted from the music view leaves it row by row, without a reload
+    bulkOperations = new BulkTrackOperations(musicRepository, this);
+    connect(bulkOperations, &BulkTrackOperations::filesDeleted, this,
+            [this](const BulkTrackOperations::FileDeletion& result) {
+                qInfo() << result.deleted.size() << "files deleted from disk";
+                if (result.missing.isEmpty() && result.failed.isEmpty())
+                    return;
                 QMessageBox::warning(
-                    this, "Replacement Failed",
-                    QString("Could not replace the original file:\n%1\n\n"
-                            "The trimmed version remains in the temporary folder:\n%2\n\n"
-                            "Please check file permissions and replace it manually if desired.")
-                        .arg(originalPath)
-                        .arg(tempOutputPath));
-                failCount++;
-                // Do NOT delete the temp file in this case
-            } else {
-                qInfo() << "File trimmed and replaced successfully:" << originalPath;
-                successCount++;
-                // Temp file is gone (renamed)
-            }
-            // --- End Replace ---
+                    this, tr("Deletion Failed"),
+                    tr("%1 files were deleted.\n\n%2 could not be found:\n%3\n\n"
+                       "%4 could not be deleted; check the file permissions or if they are "
+                       "in use:\n%5")
+                        .arg(result.deleted.size())
+                        .arg(result.missing.size())
+                        .arg(result.missing.mid(0, 10).join('\n'))
+                        .arg(result.failed.size())
+                        .arg(result.failed.mid(0, 10).join('\n')));
+            });
 
-        } // End for loop
+    downloads = new DownloadQueue(musicRepository, this);
+    downloads->setOutputDirectory(QCoreApplication::applicationDirPath() + "/../music");
+    downloads->setFfmpegLocation(QStandardPaths::findExecutable("ffmpeg"));
+
+    downloadProgress = new ProgressIndicatorWidget(this);
+    downloadProgress->setCancelEnabled(true);
+    downloadProgress->setShowElapsedTime(true);
+    ui->gridLayout->addWidget(downloadProgress, ui->gridLayout->rowCount(), 0, 1,
+                              ui->gridLayout->columnCount());
+    connect(downloadProgress, &ProgressIndicatorWidget::cancelRequested, downloads,
+            &DownloadQueue::cancel);
+
+    connect(downloads, &DownloadQueue::progressChanged, this,
+            [this](const DownloadQueue::Progress& progress) {
+                if (!downloads->isRunning())
+                    return;
+                if (!downloadProgress->isProgressVisible())
+                    downloadProgress->showProgress("Downloading external links", QString(), 0,
+                                                   1000);
+                downloadProgress->updateProgress(
+                    progress.permille, QString("%1 of %2 downloaded, %3 failed, %4 running")
+                                           .arg(progress.done)
+                                           .arg(progress.total)
+                                           .arg(progress.failed)
+                                           .arg(progress.running));
+            });
+    connect(downloads, &DownloadQueue::finished, this, [this](int added, int failed) {
+        downloadProgress->hideProgress();
+        if (failed > 0)
+            QMessageBox::warning(this, "Downloads Finished",
+                                 QString("%1 tracks were added to the database.\n\n"
+                                         "%2 downloads failed.")
+                                     .arg(added)
+                                     .arg(failed));
+    });
+}
 
-        // --- Final Cleanup & Summary ---
-        progressDialog.cancel(); // Close progress dialog
+void player::setupDeduplication() {
+    // New tracks are hashed as they are added, so a second copy of a track
+    // is turned away whatever its path or tags; the scanner catches up on
+    // tracks added before
+    musicRepository->setContentHasher(
+        [](const QString& filePath) { return ContentHash::ofFile(filePath); });
+    MusicRepository::ensureContentHashColumn(adb);
+    contentHashScanner = new ContentHashScanner(musicRepository, this);
+
+    contentHashProgress = new ProgressIndicatorWidget(this);
+    contentHashProgress->setCancelEnabled(true);
+    contentHashProgress->setShowElapsedTime(true);
+    contentHashProgress->setShowEstimatedTime(true);
+    ui->gridLayout->addWidget(contentHashProgress, ui->gridLayout->rowCount(), 0, 1,
+                              ui->gridLayout->columnCount());
+    connect(contentHashProgress, &ProgressIndicatorWidget::cancelRequested, contentHashScanner,
+            &ContentHashScanner::cancel);
+    connect(contentHashScanner, &ContentHashScanner::progressChanged, this,
+            [this](int done, int total) {
+                contentHashProgress->updateProgress(
+                    done, QString("%1 of %2 tracks read").arg(done).arg(total));
+            });
+    connect(contentHashScanner, &ContentHashScanner::finished, this, [this](int, int failed) {
+        contentHashProgress->hideProgress();
+        if (failed > 0)
+            qWarning() << "Duplicates:" << failed << "tracks could not be read";
+        showDuplicateReport();
+    });
+}
 
-        // Adjust summary message slightly
-        QString summaryMessage;
-        if (cancelled) {
-            summaryMessage =
-                QString(
-                    "Operation Cancelled.\n\nSuccessfully Trimmed (0.2s): %1\nFailed/Skipped: %2")
-                    .arg(successCount)
-                    .arg(failCount);
-        } else {
-            summaryMessage = QString("Silence Trim Complete (0.2s threshold).\n\nTotal Selected: "
-                                     "%1\nSuccessfully Trimmed: %2\nFailed/Skipped: %3")
-                                 .arg(totalFilesToProcess)
-                                 .arg(successCount)
-                                 .arg(failCount);
-        }
+void player::setupTranscodeCache() {
+    // Tracks in formats the platform decoder cannot open (or opens slowly)
+    // are converted to WAV once they are near the top of the playlist, so
+    // the scheduler and auto mode put a ready copy on the decks
+    transcodeCache = new TranscodeCache(
+        QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/transcoded", this);
+    transcodeCache->setProgram(QStandardPaths::findExecutable("ffmpeg"));
+    if (transcodeCache->program().isEmpty())
+        qWarning() << "Tracks in" << transcodeCache->suffixes().join(", ")
+                   << "play unconverted: 'ffmpeg' is not in PATH.";
+    // A converted copy is local already; anything else may come from the media cache
+    playbackEngine->setSourceResolver([this](const QString& filePath) {
+        const QString transcoded = transcodeCache->resolve(filePath);
+        return transcoded != filePath ? transcoded : mediaCache->resolve(filePath);
+    });
+}
 
-        qInfo() << "-------------------------------------";
-        qInfo() << summaryMessage.replace("\n\n", " | "); // Log summary concisely
-        qInfo() << "-------------------------------------";
+void player::setupMediaCache() {
+    mediaCache = new MediaCache(
+        QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/media", this);
+    connect(mediaCache, &MediaCache::failed, this, [](const QString& source, const QString& error) {
+        qCWarning(xfbPlayback) << "Media cache: cannot copy" << source << "-" << error;
+    });
 
-        QMessageBox::information(this, "Operation Summary", summaryMessage);
-    }
+    mediaCachePlanTimer = new QTimer(this);
+    mediaCachePlanTimer->setInterval(MEDIA_CACHE_PLAN_MS);
+    connect(mediaCachePlanTimer, &QTimer::timeout, this, &player::prepareMediaCache);
+    applyMediaCache();
 }
 
-void player::on_actionConvert_all_musics_in_the_database_to_mp3_triggered() {
-    QSqlDatabase db = QSqlDatabase::database("xfb_connection"); // Or pass it in
-    if (!db.isOpen()) {
-        qWarning() << "Database connection 'xfb_connection' is not open!";
-        QMessageBox::critical(this, "Database Error", "Database connection is not open.");
-        return;
-    }
-
-    // --- Check for FFMPEG executable ---
-    QString ffmpegPath = QStandardPaths::findExecutable("ffmpeg");
-    if (ffmpegPath.isEmpty()) {
-        qWarning() << "'ffmpeg' command not found in system PATH.";
-        QMessageBox::critical(this, "Missing Dependency",
-                              "The 'ffmpeg' command is required for audio conversion "
-                              "but was not found in the system's PATH.\n\nPlease install ffmpeg "
-                              "and ensure it's accessible.");
+void player::applyMediaCache() {
+    mediaCache->setPaths(mediaCachePaths);
+    mediaCache->setMaxBytes(qint64(qMax(0, mediaCacheMb)) * 1024 * 1024);
+    mediaCache->setEnabled(mediaCacheMb > 0);
+    if (mediaCacheMb <= 0) {
+        mediaCachePlanTimer->stop();
         return;
     }
-    qInfo() << "Found ffmpeg executable at:" << ffmpegPath;
-    // --- End FFMPEG check ---
-
-    // --- Confirmation ---
-    QMessageBox::StandardButton confirm =
-        QMessageBox::question(this, "Confirm Full Conversion",
-                              "Convert ALL tracks in the database to MP3 (192kbps)?\n\n"
-                              "Original files will be replaced with the MP3 version.\n"
-                              "This action cannot be undone and may take a very long time!\n\n"
-                              "Note: Only the audio stream will be kept.",
-                              QMessageBox::Yes | QMessageBox::No);
+    mediaCachePlanTimer->start();
+    // The engines are created later in startup; the first plan runs once they are
+    QTimer::singleShot(0, this, &player::prepareMediaCache);
+}
 
-    if (confirm == QMessageBox::No) {
+void player::prepareMediaCache() {
+    if (!mediaCache->isEnabled())
         return;
-    }
+    mediaCache->prepare(playlistQueue ? playlistQueue->paths(TRANSCODE_LOOKAHEAD) : QStringList());
 
-    // --- Setup Loading Indicator & Progress Dialog ---
-    // Use stack variable for QMovie if its lifetime is limited to this function
-    QMovie loadingMovie(":/images/loading.gif");
-    if (!loadingMovie.isValid()) {
-        qWarning() << "Loading GIF not valid:"
-                   << ":/images/loading.gif";
-        ui->txt_loading->setText("Processing..."); // Fallback text
-        ui->txt_loading->show();
-    } else {
-        ui->txt_loading->setMovie(&loadingMovie);
-        ui->txt_loading->setScaledContents(true);
-        ui->txt_loading->show();
-        loadingMovie.start();
-    }
-    qApp->processEvents(); // Allow UI to update
-
-    QProgressDialog progressDialog("Converting all tracks to MP3...", "Cancel", 0, 0, this);
-    progressDialog.setWindowModality(Qt::WindowModal);
-    progressDialog.setValue(0);
-    progressDialog.show();
-    qApp->processEvents();
-    // --- End Setup ---
-
-    // --- Prepare Database Queries (outside loop) ---
-    QSqlQuery querySelect(db);
-    QSqlQuery queryUpdate(db);
-    QSqlQuery queryCount(db); // For counting total records
-
-    // Prepare UPDATE statement
-    if (!queryUpdate.prepare("UPDATE musics SET path = :new_path WHERE path = :old_path")) {
-        qWarning() << "Failed to prepare database UPDATE statement:" << queryUpdate.lastError();
-        QMessageBox::critical(this, "Database Error",
-                              "Failed to prepare database query for updating paths.");
-        loadingMovie.stop();
-        ui->txt_loading->hide();
-        progressDialog.cancel();
-        return;
+    const QDateTime now = QDateTime::currentDateTime();
+    const QDateTime horizon = now.addMSecs(MEDIA_CACHE_HORIZON_MS);
+    if (schedulerEngine) {
+        QStringList scheduled;
+        for (const ScheduledEvent& event : schedulerEngine->upcomingEvents(now, horizon))
+            scheduled << event.rule.path;
+        mediaCache->prepare(scheduled);
     }
-
-    // Count total files for progress bar
-    int totalFiles = 0;
-    if (queryCount.exec("SELECT COUNT(*) FROM musics")) {
-        if (queryCount.next()) {
-            totalFiles = queryCount.value(0).toInt();
-            progressDialog.setMaximum(totalFiles);
+    if (hourGenreSchedule && rotationEngine) {
+        QStringList genres;
+        for (QDateTime hour = now; hour <= horizon; hour = hour.addSecs(3600)) {
+            const QString genre = hourGenreSchedule->genreAt(hour);
+            if (!genres.contains(genre))
+                genres << genre;
         }
-    } else {
-        qWarning() << "Failed to count records:" << queryCount.lastError();
-        // Proceed without accurate progress max? Or abort? Let's proceed.
-        progressDialog.setMaximum(100); // Set an arbitrary max
+        for (const QString& genre : std::as_const(genres))
+            mediaCache->prepare(rotationEngine->upcoming(genre, MEDIA_CACHE_ROTATION_PICKS));
     }
-    qApp->processEvents();
+}
 
-    // Select only the path
-    QString selectStr = "SELECT path FROM musics";
-    if (!querySelect.exec(selectStr)) {
-        qWarning() << "Failed to SELECT paths from musics:" << querySelect.lastError();
-        QMessageBox::critical(this, "Database Error",
-                              "Failed to query the musics table for paths.");
-        loadingMovie.stop();
-        ui->txt_loading->hide();
-        progressDialog.cancel();
-        return;
-    }
+void player::setupRemoteControl() {
+    remoteControl = new RemoteControlServer(this);
 
-    // --- Get Temporary Directory ---
-    QString tempDirPath = QStandardPaths::writableLocation(QStandardPaths::TempLocation);
-    if (tempDirPath.isEmpty()) {
-        qWarning() << "Could not find a writable temporary location.";
-        QMessageBox::critical(this, "File System Error",
-                              "Cannot find a suitable temporary directory for conversion.");
-        loadingMovie.stop();
-        ui->txt_loading->hide();
-        progressDialog.cancel();
+    remoteControl->addCommand("play", [this](const QJsonObject&) {
+        if (PlayMode == "stopped")
+            on_btPlay_clicked();
+        return QString();
+    });
+    remoteControl->addCommand("stop", [this](const QJsonObject&) {
+        on_btStop_clicked();
+        return QString();
+    });
+    remoteControl->addCommand("next", [this](const QJsonObject&) {
+        on_btPlayNext_clicked();
+        return QString();
+    });
+    remoteControl->addCommand("queue.append", [this](const QJsonObject& args) {
+        const QString path = args.value("path").toString();
+        if (!QFileInfo::exists(path))
+            return tr("No such file: %1").arg(path);
+        playlistQueue->append(path);
+        return QString();
+    });
+    remoteControl->addCommand("queue.remove", [this](const QJsonObject& args) {
+        const int row = args.value("index").toInt(-1);
+        if (row < 0 || row >= playlistQueue->count())
+            return tr("No queue entry %1").arg(row);
+        playlistQueue->removeAt(row);
+        return QString();
+    });
+    remoteControl->addCommand("queue.move", [this](const QJsonObject& args) {
+        if (!playlistQueue->move(args.value("from").toInt(-1), args.value("to").toInt(-1)))
+            return tr("Cannot move that queue entry");
+        return QString();
+    });
+    remoteControl->addDocument("metrics",
+                               []() { return MetricsRegistry::instance().toJson(); });
+
+    // The clock already limits the position to a few updates a second
+    connect(PlaybackClock::instance(), &PlaybackClock::positionChanged, this,
+            &player::publishTransport);
+    connect(playbackEngine, &PlaybackEngine::stateChanged, this, &player::publishTransport);
+    connect(playbackEngine, &PlaybackEngine::trackStarted, this, &player::publishTransport);
+    connect(playlistQueue, &QAbstractItemModel::rowsInserted, this, &player::publishQueue);
+    connect(playlistQueue, &QAbstractItemModel::rowsRemoved, this, &player::publishQueue);
+    connect(playlistQueue, &QAbstractItemModel::rowsMoved, this, &player::publishQueue);
+    connect(playlistQueue, &QAbstractItemModel::modelReset, this, &player::publishQueue);
+    if (schedulerEngine)
+        connect(schedulerEngine, &SchedulerEngine::eventDue, this, &player::publishSchedule);
+
+    publishTransport();
+    publishQueue();
+    publishSchedule();
+    applyRemoteControl();
+}
+
+void player::applyRemoteControl() {
+    remoteControl->setToken(remoteToken);
+    remoteControl->close();
+    if (remotePort <= 0 || remotePort > 65535)
         return;
-    }
-    QDir tempDir(tempDirPath);
-    qInfo() << "Using temporary directory:" << tempDirPath;
-
-    // --- Process Files ---
-    int processedCount = 0;
-    int successCount = 0;
-    int failCount = 0;
-    bool cancelled = false;
-
-    while (querySelect.next() && !cancelled) {
-        processedCount++;
-        progressDialog.setValue(processedCount);
-        qApp->processEvents(); // Keep UI responsive and check for Cancel button
-
-        if (progressDialog.wasCanceled()) {
-            qInfo() << "User cancelled the operation.";
-            cancelled = true;
-            break;
-        }
-
-        QString originalPath = querySelect.value(0).toString();
-        QFileInfo originalFileInfo(originalPath);
-
-        progressDialog.setLabelText(
-            QString("Converting [%1/%2]:\n%3")
-                .arg(processedCount)
-                .arg(totalFiles > 0 ? totalFiles : processedCount) // Show total if known
-                .arg(originalFileInfo.fileName()));
-        qApp->processEvents();
+    remoteControl->listen(quint16(remotePort),
+                          remoteToken.isEmpty() ? QHostAddress(QHostAddress::LocalHost)
+                                                : QHostAddress(QHostAddress::Any));
+}
+
+void player::setupLibrarySync() {
+    remoteControl->addQuery(LibraryReplica::QUERY_NAME, [this](const QJsonObject& args) {
+        if (!libraryFeed)
+            return QJsonValue(QJsonObject{{"error", tr("This studio does not share its library")}});
+        const LibraryChangeLog log(QSqlDatabase::database("xfb_connection"));
+        return QJsonValue(log.changesSince(
+            args.value("since").toVariant().toLongLong(),
+            args.value("limit").toVariant().toInt()));
+    });
 
-        qInfo().noquote() << "Processing [" << processedCount << "/"
-                          << (totalFiles > 0 ? QString::number(totalFiles) : "?")
-                          << "]:" << originalPath;
+    libraryReplica = new LibraryReplica(QSqlDatabase::database("xfb_connection"), this);
+    connect(libraryReplica, &LibraryReplica::changesApplied, this, &player::update_music_table);
+    applyLibrarySync();
+}
 
-        if (!originalFileInfo.exists() || !originalFileInfo.isFile()) {
-            qWarning() << "Original file does not exist or is not a file:" << originalPath;
-            failCount++;
-            continue; // Skip to next file
-        }
+void player::applyLibrarySync() {
+    // The triggers stay once created, so the log is complete from then on
+    if (libraryFeed && !LibraryChangeLog(QSqlDatabase::database("xfb_connection")).ensure())
+        qWarning() << "Cannot create the library change log for LibraryFeed";
 
-        // --- Prepare Paths ---
-        QString baseName = originalFileInfo.baseName();            // Name without extension
-        QString originalDir = originalFileInfo.absolutePath();     // Directory of original file
-        QString tempMp3Path = tempDir.filePath(baseName + ".mp3"); // Full path for temporary MP3
-        QString finalMp3Path =
-            QDir(originalDir).filePath(baseName + ".mp3"); // Final path for MP3 in original dir
-
-        // --- Run FFMPEG ---
-        QProcess ffmpegProcess;
-        QStringList ffmpegArgs;
-        ffmpegArgs << "-i" << originalPath // Input file
-                   << "-vn"                // No video output
-                   << "-ar"
-                   << "44100" // Audio sample rate
-                   << "-ac"
-                   << "2" // Audio channels (stereo)
-                   << "-b:a"
-                   << "192k" // Audio bitrate (use -b:a)
-                   << "-f"
-                   << "mp3"        // Force output format (optional)
-                   << tempMp3Path; // Output file path
-
-        qDebug() << "Running command:" << ffmpegPath << ffmpegArgs;
-
-        ffmpegProcess.start(ffmpegPath, ffmpegArgs);
-
-        // Wait for ffmpeg (e.g., 10 min timeout)
-        if (!ffmpegProcess.waitForFinished(600000)) {
-            qWarning() << "ffmpeg process timed out for:" << originalPath
-                       << ffmpegProcess.errorString();
-            ffmpegProcess.kill();
-            ffmpegProcess.waitForFinished(1000);
-            QFile::remove(tempMp3Path); // Clean up incomplete temp file
-            failCount++;
-            continue;
-        }
+    libraryReplica->stop();
+    if (libraryPrimary.isEmpty())
+        return;
+    libraryReplica->setSource(QUrl::fromUserInput(libraryPrimary), libraryPrimaryToken);
+    libraryReplica->setPathMapping(libraryPathFrom, libraryPathTo);
+    libraryReplica->start();
+}
 
-        // Check ffmpeg result
-        if (ffmpegProcess.exitStatus() != QProcess::NormalExit || ffmpegProcess.exitCode() != 0) {
-            qWarning() << "ffmpeg process failed for:" << originalPath
-                       << "Exit code:" << ffmpegProcess.exitCode()
-                       << "Exit status:" << ffmpegProcess.exitStatus();
-            QString errorOutput = QString::fromLocal8Bit(ffmpegProcess.readAllStandardError());
-            qWarning() << "ffmpeg Standard Error:\n" << errorOutput;
-            QFile::remove(tempMp3Path); // Clean up potentially failed temp file
-            failCount++;
-            continue;
-        }
+void player::publishTransport() {
+    if (!remoteControl)
+        return;
+    static const char* const states[] = {"stopped", "playing", "paused"};
+    remoteControl->publish("transport",
+                           QJsonObject{{"mode", PlayMode},
+                                       {"state", states[int(playbackEngine->state())]},
+                                       {"nowPlaying", playbackEngine->currentSource()},
+                                       {"next", playbackEngine->queuedSource()},
+                                       {"positionMs", double(playbackEngine->position())},
+                                       {"durationMs", double(playbackEngine->duration())}});
+}
 
-        // Check if temp MP3 exists and has size
-        QFileInfo tempMp3Info(tempMp3Path);
-        if (!tempMp3Info.exists() || tempMp3Info.size() == 0) {
-            qWarning()
-                << "ffmpeg finished successfully but the output MP3 file is missing or empty:"
-                << tempMp3Path;
-            QFile::remove(tempMp3Path);
-            failCount++;
-            continue;
-        }
+void player::publishQueue() {
+    if (remoteControl)
+        remoteControl->publish("queue", QJsonArray::fromStringList(playlistQueue->paths()));
+}
 
-        qInfo() << "ffmpeg conversion successful for:" << originalPath << " -> " << tempMp3Path;
+void player::publishSchedule() {
+    if (!remoteControl || !schedulerEngine)
+        return;
+    // What the scheduler will put on air in the next hours
+    const QDateTime now = QDateTime::currentDateTime();
+    QJsonArray events;
+    const QList<ScheduledEvent> upcoming =
+        schedulerEngine->upcomingEvents(now, now.addSecs(3 * 3600));
+    for (const ScheduledEvent& event : upcoming) {
+        events.append(QJsonObject{{"at", event.fireAt.toString(Qt::ISODate)},
+                                  {"path", event.rule.path},
+                                  {"program", event.rule.isProgram}});
+    }
+    remoteControl->publish("schedule", events);
+}
+
+void player::setupMetrics() {
+    MetricsRegistry& metrics = MetricsRegistry::instance();
+    playbackEngine->setRenderTimeHistogram(metrics.histogram(
+        "xfb_audio_render_microseconds", "Time to mix one block for the audio sink"));
+    dbOptimizer->setQueryTimeHistogram(
+        metrics.histogram("xfb_database_query_milliseconds", "Execution time of timed queries"));
+
+    // The services keep their own counts; these copy them in before each scrape
+    metrics.addCollector(dbOptimizer, [this](MetricsRegistry& registry) {
+        const DatabaseOptimizer::PerformanceMetrics db = dbOptimizer->getPerformanceMetrics();
+        registry.counter("xfb_database_queries_total", "Queries timed")->set(db.totalQueries);
+        registry.counter("xfb_database_slow_queries_total", "Timed queries over the slow threshold")
+            ->set(db.slowQueries);
+        registry.gauge("xfb_database_size_bytes", "Size of the database file")
+            ->set(double(db.databaseSize));
+        registry.gauge("xfb_database_cache_hit_ratio", "SQLite page cache hit ratio")
+            ->set(db.cacheHitRatio);
+        registry.gauge("xfb_database_indexes", "Indexes in the database")->set(db.indexCount);
+    });
+    metrics.addCollector(playbackEngine, [this](MetricsRegistry& registry) {
+        const TrackPrefetcher::Statistics prefetch = playbackEngine->prefetchStatistics();
+        registry.counter("xfb_prefetch_hits_total", "Loads served from a completed prefetch")
+            ->set(prefetch.hits);
+        registry.counter("xfb_prefetch_late_total", "Loads whose prefetch had not finished")
+            ->set(prefetch.late);
+        registry.counter("xfb_prefetch_misses_total", "Loads of files never prefetched")
+            ->set(prefetch.misses);
+        registry.counter("xfb_prefetch_wasted_total", "Prefetches evicted without being used")
+            ->set(prefetch.wasted);
+        registry.counter("xfb_prefetch_read_bytes_total", "Bytes read ahead")
+            ->set(prefetch.bytesRead);
+
+        const NativeAudioOutput::Statistics output = playbackEngine->nativeOutputStatistics();
+        registry.counter("xfb_audio_xruns_total", "Underruns of the native output")
+            ->set(output.xruns);
+        registry.counter("xfb_audio_periods_total", "Periods written to the native output")
+            ->set(output.periodsWritten);
+        registry.gauge("xfb_audio_period_frames", "Frames per period, 0 without native output")
+            ->set(output.periodFrames);
+        registry.gauge("xfb_audio_output_latency_milliseconds",
+                       "Buffered output of the native device")
+            ->set(output.latencyMs);
+    });
+    metrics.addCollector(transcodeCache, [this](MetricsRegistry& registry) {
+        const TranscodeCache::Statistics transcode = transcodeCache->statistics();
+        registry.counter("xfb_transcode_hits_total", "Tracks served from a transcoded copy")
+            ->set(transcode.hits);
+        registry.counter("xfb_transcode_misses_total", "Tracks whose copy was not ready")
+            ->set(transcode.misses);
+        registry.counter("xfb_transcode_failed_total", "Conversions that failed")
+            ->set(transcode.failed);
+        registry.gauge("xfb_transcode_cache_entries", "Copies in the transcode cache")
+            ->set(transcode.entries);
+        registry.gauge("xfb_transcode_cache_bytes", "Size of the transcode cache")
+            ->set(double(transcode.bytes));
+    });
 
-        // --- Delete Original File ---
-        qInfo() << "Attempting to delete original file:" << originalPath;
-        if (!QFile::remove(originalPath)) {
-            qWarning() << "Failed to delete original file:" << originalPath
-                       << ". Skipping move and database update.";
-            failCount++;
-            continue; // Skip rest of steps for this file
-        }
-        qInfo() << "Original file deleted successfully.";
+    metrics.addCollector(mediaCache, [this](MetricsRegistry& registry) {
+        const MediaCache::Statistics media = mediaCache->statistics();
+        registry.counter("xfb_media_cache_hits_total", "Tracks played from a local copy")
+            ->set(media.hits);
+        registry.counter("xfb_media_cache_misses_total", "Tracks played without a local copy")
+            ->set(media.misses);
+        registry.counter("xfb_media_cache_failed_total", "Copies that failed")->set(media.failed);
+        registry.counter("xfb_media_cache_read_bytes_total", "Bytes read to fill the media cache")
+            ->set(double(media.bytesCopied));
+        registry.gauge("xfb_media_cache_entries", "Copies in the media cache")
+            ->set(media.entries);
+        registry.gauge("xfb_media_cache_bytes", "Size of the media cache")
+            ->set(double(media.bytes));
+    });
 
-        // --- Move Temporary MP3 to Final Location ---
-        qInfo() << "Attempting to move" << tempMp3Path << "to" << finalMp3Path;
-        if (!QFile::rename(tempMp3Path, finalMp3Path)) {
-            qWarning() << "Failed to move temporary MP3" << tempMp3Path << "to" << finalMp3Path
-                       << ". The original file was deleted! MP3 remains in temp folder.";
-            QMessageBox::warning(
-                this, "Move Failed",
-                QString("Failed to move the converted MP3 to its final destination:\n%1\n\n"
-                        "The original file was deleted, but the MP3 remains in the temporary "
-                        "folder:\n%2\n\n"
-                        "Please move it manually and check the database record.")
-                    .arg(finalMp3Path)
-                    .arg(tempMp3Path));
-            failCount++;
-            continue; // Cannot update DB path if move failed
-        }
-        qInfo() << "MP3 moved successfully to:" << finalMp3Path;
-
-        // --- Update Database ---
-        qInfo() << "Updating database: set path =" << finalMp3Path
-                << "where path =" << originalPath;
-        queryUpdate.bindValue(":new_path", finalMp3Path);
-        queryUpdate.bindValue(":old_path", originalPath);
-
-        if (!queryUpdate.exec()) {
-            qWarning() << "Failed to update database path for:" << originalPath << "->"
-                       << finalMp3Path;
-            qWarning() << "DB Error:" << queryUpdate.lastError().text();
-            qWarning() << "Last Query (Bound values might not show):" << queryUpdate.lastQuery();
-            QMessageBox::warning(this, "Database Update Failed",
-                                 QString("The file was successfully converted and moved to:\n%1\n\n"
-                                         "However, updating the database record failed:\n%2\n\n"
-                                         "Please check the database manually.")
-                                     .arg(finalMp3Path)
-                                     .arg(queryUpdate.lastError().text()));
-            failCount++; // Count as failure since DB update is critical
-        } else {
-            qInfo() << "Database path updated successfully.";
-            successCount++;
-            // update_music_table(); // Update only once at the end
-        }
+    metrics.addCollector(MemoryBudget::instance(), [](MetricsRegistry& registry) {
+        MemoryBudget::instance()->exportTo(registry);
+    });
 
-    } // End while loop
+    metricsServer = new MetricsServer(&metrics, this);
+    metricsServer->addPath("/trace.json", "application/json",
+                           []() { return Tracer::toChromeTrace(); });
+    applyMetrics();
+}
+
+void player::setupMemoryBudget() {
+    MemoryBudget* budget = MemoryBudget::instance();
+    // The caches shrink to the budget they were given; under pressure they shrink further
+    const QList<QPair<QString, MusicCache*>> caches = {
+        {"search_cache", searchCache},
+        {"server_presence_cache", serverPresenceCache},
+        {"media_info_cache", mediaInfoCache}};
+    for (const auto& [name, cache] : caches) {
+        budget->addSubsystem(
+            name, cache, cache->maxMemoryUsage(), [cache]() { return cache->currentMemoryUsage(); },
+            [cache](qint64 bytes) { cache->cleanup(bytes); });
+    }
+    // What the library views show is read back on demand, so they are only reported
+    budget->addSubsystem("library_models", this, MODELS_MEMORY_BUDGET, [this]() {
+        qint64 bytes = 0;
+        for (const LiveTableModel* model :
+             {musicsModel, jinglesModel, pubModel, programsModel, genresModel}) {
+            if (model)
+                bytes += model->memoryUsage();
+        }
+        return bytes;
+    });
+    budget->addSubsystem(
+        "audio_buffers", playbackEngine, AUDIO_BUFFERS_MEMORY_BUDGET,
+        [this]() { return playbackEngine->bufferMemoryUsage(); },
+        [this](qint64 bytes) { playbackEngine->shrinkBuffers(bytes); });
+    budget->addSubsystem(
+        "sqlite", this, SQLITE_MEMORY_BUDGET, []() { return MemoryBudget::sqliteBytes(); },
+        [this](qint64 bytes) { MemoryBudget::shrinkSqlite(bytes, adb); });
+    connect(budget, &MemoryBudget::envelopeExceeded, this,
+            [this](qint64 resident, qint64 envelope) {
+                if (!eventJournal)
+                    return;
+                eventJournal->record(EventJournal::Type::Error,
+                                     {{"component", "MemoryBudget"},
+                                      {"message", "Resident size over the memory envelope"},
+                                      {"resident_bytes", resident},
+                                      {"envelope_bytes", envelope}});
+            });
+    budget->start();
+}
 
-    // --- Final Cleanup & Summary ---
-    loadingMovie.stop();
-    ui->txt_loading->hide();
-    progressDialog.cancel(); // Close progress dialog
-
-    update_music_table(); // Update the table view once after all operations
-
-    QString summaryMessage;
-    if (cancelled) {
-        summaryMessage =
-            QString("Operation Cancelled.\n\nProcessed: %1\nSuccessfully Converted: "
-                    "%2\nFailed/Skipped: %3")
-                .arg(processedCount - 1) // Don't count the one being processed when cancelled
-                .arg(successCount)
-                .arg(failCount);
-    } else {
-        summaryMessage = QString("MP3 Conversion Complete.\n\nTotal Records: %1\nSuccessfully "
-                                 "Converted: %2\nFailed/Skipped: %3")
-                             .arg(totalFiles) // Use the count obtained earlier
-                             .arg(successCount)
-                             .arg(failCount);
+void player::applyStallWatchdog() {
+    if (stallThresholdMs <= 0) {
+        stallWatchdog->stop();
+        return;
     }
+    stallWatchdog->setThresholdMs(stallThresholdMs);
+    stallWatchdog->start();
+}
 
-    qInfo() << "-------------------------------------";
-    qInfo() << summaryMessage.replace("\n\n", " | "); // Log summary concisely
-    qInfo() << "-------------------------------------";
-
-    QMessageBox::information(this, "Conversion Summary", summaryMessage);
+QString player::traceDirectory() const {
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/traces";
 }
-void player::on_actionConvert_all_musics_in_the_database_to_ogg_triggered() {
-    QSqlDatabase db = QSqlDatabase::database("xfb_connection"); // Or pass it in
-    if (!db.isOpen()) {
-        qWarning() << "Database connection 'xfb_connection' is not open!";
-        QMessageBox::critical(this, "Database Error", "Database connection is not open.");
-        return;
-    }
 
-    // --- Check for FFMPEG executable ---
-    QString ffmpegPath = QStandardPaths::findExecutable("ffmpeg");
-    if (ffmpegPath.isEmpty()) {
-        qWarning() << "'ffmpeg' command not found in system PATH.";
-        QMessageBox::critical(this, "Missing Dependency",
-                              "The 'ffmpeg' command is required for audio conversion "
-                              "but was not found in the system's PATH.\n\nPlease install ffmpeg "
-                              "and ensure it's accessible.");
+void player::applyMetrics() {
+    if (metricsPort <= 0 || metricsPort > 65535) {
+        metricsServer->close();
         return;
     }
-    qInfo() << "Found ffmpeg executable at:" << ffmpegPath;
-    // --- End FFMPEG check ---
+    if (metricsServer->port() == metricsPort)
+        return;
+    metricsServer->listen(quint16(metricsPort));
+}
 
-    // --- Confirmation ---
-    // Updated confirmation message for Ogg
-    QMessageBox::StandardButton confirm =
-        QMessageBox::question(this, "Confirm Full Conversion",
-                              "Convert ALL tracks in the database to Ogg Vorbis (Quality ~7)?\n\n"
-                              "Original files will be replaced with the Ogg version.\n"
-                              "This action cannot be undone and may take a very long time!\n\n"
-                              "Note: Only the audio stream will be kept.",
-                              QMessageBox::Yes | QMessageBox::No);
+void player::prepareTranscodes() {
+    transcodeCache->prepare(playlistQueue->paths(TRANSCODE_LOOKAHEAD));
+    mediaCache->prepare(playlistQueue->paths(TRANSCODE_LOOKAHEAD));
+}
 
-    if (confirm == QMessageBox::No) {
+void player::showDuplicateReport() {
+    const QList<QList<MusicItem>> groups = musicRepository->findContentDuplicates();
+    if (groups.isEmpty()) {
+        QMessageBox::information(this, "Duplicate Tracks",
+                                 "No track in the database is a copy of another one.");
         return;
     }
 
-    // --- Setup Loading Indicator & Progress Dialog ---
-    QMovie loadingMovie(":/images/loading.gif");
-    if (!loadingMovie.isValid()) {
-        qWarning() << "Loading GIF not valid:"
-                   << ":/images/loading.gif";
-        ui->txt_loading->setText("Processing..."); // Fallback text
-        ui->txt_loading->show();
-    } else {
-        ui->txt_loading->setMovie(&loadingMovie);
-        ui->txt_loading->setScaledContents(true);
-        ui->txt_loading->show();
-        loadingMovie.start();
-    }
-    qApp->processEvents(); // Allow UI to update
-
-    // Updated progress dialog title
-    QProgressDialog progressDialog("Converting all tracks to Ogg Vorbis...", "Cancel", 0, 0, this);
-    progressDialog.setWindowModality(Qt::WindowModal);
-    progressDialog.setValue(0);
-    progressDialog.show();
-    qApp->processEvents();
-    // --- End Setup ---
-
-    // --- Prepare Database Queries (outside loop) ---
-    QSqlQuery querySelect(db);
-    QSqlQuery queryUpdate(db);
-    QSqlQuery queryCount(db); // For counting total records
-
-    // Prepare UPDATE statement
-    if (!queryUpdate.prepare("UPDATE musics SET path = :new_path WHERE path = :old_path")) {
-        qWarning() << "Failed to prepare database UPDATE statement:" << queryUpdate.lastError();
-        QMessageBox::critical(this, "Database Error",
-                              "Failed to prepare database query for updating paths.");
-        loadingMovie.stop();
-        ui->txt_loading->hide();
-        progressDialog.cancel();
-        return;
+    int copies = 0;
+    QStringList report;
+    for (const QList<MusicItem>& group : groups) {
+        report << QString("%1 - %2\n  %3").arg(group.first().artist, group.first().song,
+                                                group.first().path);
+        for (qsizetype i = 1; i < group.size(); ++i)
+            report << QString("  copy: %1").arg(group.at(i).path);
+        copies += group.size() - 1;
     }
 
-    // Count total files for progress bar
-    int totalFiles = 0;
-    if (queryCount.exec("SELECT COUNT(*) FROM musics")) {
-        if (queryCount.next()) {
-            totalFiles = queryCount.value(0).toInt();
-            progressDialog.setMaximum(totalFiles);
-        }
-    } else {
-        qWarning() << "Failed to count records:" << queryCount.lastError();
-        progressDialog.setMaximum(100); // Set an arbitrary max
-    }
-    qApp->processEvents();
+    QMessageBox box(QMessageBox::Information, "Duplicate Tracks",
+                    QString("%1 tracks are in the database more than once, with %2 extra "
+                            "copies.\n\nThe copies hold the same audio under another path or "
+                            "with other tags. Nothing was removed; see the details for the "
+                            "list.")
+                        .arg(groups.size())
+                        .arg(copies),
+                    QMessageBox::Ok, this);
+    box.setDetailedText(report.join("\n"));
+    box.exec();
+}
+
+void player::on_actionConvert_all_musics_in_the_database_to_ogg_triggered() {
+    QMessageBox::StandardButton confirm = QMessageBox::question(
+        this, "Confirm Full Conversion",
+        QString("Convert ALL tracks in the database to Ogg Vorbis (Quality ~7)?\n\n"
+                "Each original file is replaced with the Ogg version once it is converted.\n"
+                "This action cannot be undone. Up to %1 tracks are converted at once; the "
+                "conversion can be stopped and carries on where it stopped, even after a "
+                "restart.\n\n"
+                "Note: Only the audio stream will be kept.")
+            .arg(transcoder->maxWorkers()),
+        QMessageBox::Yes | QMessageBox::No);
+    if (confirm != QMessageBox::Yes)
+        return;
 
-    // Select only the path
-    QString selectStr = "SELECT path FROM musics";
-    if (!querySelect.exec(selectStr)) {
+    const QStringList paths = libraryPaths();
+    if (!paths.isEmpty())
+        queueConversion(paths, "ogg");
+}
+
+QStringList player::libraryPaths() {
+    QSqlQuery querySelect(QSqlDatabase::database("xfb_connection"));
+    querySelect.setForwardOnly(true);
+    if (!querySelect.exec("SELECT path FROM musics")) {
         qWarning() << "Failed to SELECT paths from musics:" << querySelect.lastError();
         QMessageBox::critical(this, "Database Error",
                               "Failed to query the musics table for paths.");
-        loadingMovie.stop();
-        ui->txt_loading->hide();
-        progressDialog.cancel();
-        return;
+        return QStringList();
     }
+    QStringList paths;
+    while (querySelect.next())
+        paths << querySelect.value(0).toString();
+    return paths;
+}
 
-    // --- Get Temporary Directory ---
-    QString tempDirPath = QStandardPaths::writableLocation(QStandardPaths::TempLocation);
-    if (tempDirPath.isEmpty()) {
-        qWarning() << "Could not find a writable temporary location.";
-        QMessageBox::critical(this, "File System Error",
-                              "Cannot find a suitable temporary directory for conversion.");
-        loadingMovie.stop();
-        ui->txt_loading->hide();
-        progressDialog.cancel();
+QStringList player::selectedPaths() {
+    QStringList paths;
+    const QList<int> rows =
+        BulkTrackOperations::uniqueRows(ui->musicView->selectionModel()->selectedIndexes());
+    for (int row : rows)
+        paths << musicsModel->data(musicsModel->index(row, 7)).toString();
+    return paths;
+}
+
+void player::queueConversion(const QStringList& paths, const QString& suffix) {
+    const QString ffmpegPath = QStandardPaths::findExecutable("ffmpeg");
+    if (ffmpegPath.isEmpty()) {
+        qWarning() << "'ffmpeg' command not found in system PATH.";
+        QMessageBox::critical(this, "Missing Dependency",
+                              "The 'ffmpeg' command is required for audio conversion "
+                              "but was not found in the system's PATH.\n\nPlease install ffmpeg "
+                              "and ensure it's accessible.");
         return;
     }
-    QDir tempDir(tempDirPath);
-    qInfo() << "Using temporary directory:" << tempDirPath;
-
-    // --- Process Files ---
-    int processedCount = 0;
-    int successCount = 0;
-    int failCount = 0;
-    bool cancelled = false;
-
-    while (querySelect.next() && !cancelled) {
-        processedCount++;
-        progressDialog.setValue(processedCount);
-        qApp->processEvents(); // Keep UI responsive and check for Cancel button
-
-        if (progressDialog.wasCanceled()) {
-            qInfo() << "User cancelled the operation.";
-            cancelled = true;
-            break;
-        }
-
-        QString originalPath = querySelect.value(0).toString();
-        QFileInfo originalFileInfo(originalPath);
-
-        // Updated progress label
-        progressDialog.setLabelText(
-            QString("Converting [%1/%2]:\n%3")
-                .arg(processedCount)
-                .arg(totalFiles > 0 ? totalFiles : processedCount) // Show total if known
-                .arg(originalFileInfo.fileName()));
-        qApp->processEvents();
-
-        qInfo().noquote() << "Processing [" << processedCount << "/"
-                          << (totalFiles > 0 ? QString::number(totalFiles) : "?")
-                          << "]:" << originalPath;
-
-        if (!originalFileInfo.exists() || !originalFileInfo.isFile()) {
-            qWarning() << "Original file does not exist or is not a file:" << originalPath;
-            failCount++;
-            continue; // Skip to next file
-        }
-
-        // --- Prepare Paths ---
-        QString baseName = originalFileInfo.baseName();        // Name without extension
-        QString originalDir = originalFileInfo.absolutePath(); // Directory of original file
-        // Ogg paths
-        QString tempOggPath = tempDir.filePath(baseName + ".ogg"); // Full path for temporary Ogg
-        QString finalOggPath =
-            QDir(originalDir).filePath(baseName + ".ogg"); // Final path for Ogg in original dir
-
-        // --- Run FFMPEG ---
-        QProcess ffmpegProcess;
-        QStringList ffmpegArgs;
-        // Args for Ogg Vorbis
-        ffmpegArgs << "-i" << originalPath // Input file
-                   << "-c:a"
-                   << "libvorbis" // Audio codec: libvorbis
-                   << "-qscale:a"
-                   << "7"          // Quality scale (adjust as needed)
-                   << tempOggPath; // Output file path
-
-        qDebug() << "Running command:" << ffmpegPath << ffmpegArgs;
-
-        ffmpegProcess.start(ffmpegPath, ffmpegArgs);
-
-        // Wait for ffmpeg (e.g., 10 min timeout)
-        if (!ffmpegProcess.waitForFinished(600000)) {
-            qWarning() << "ffmpeg process timed out for:" << originalPath
-                       << ffmpegProcess.errorString();
-            ffmpegProcess.kill();
-            ffmpegProcess.waitForFinished(1000);
-            QFile::remove(tempOggPath); // Clean up incomplete temp file
-            failCount++;
-            continue;
-        }
-
-        // Check ffmpeg result
-        if (ffmpegProcess.exitStatus() != QProcess::NormalExit || ffmpegProcess.exitCode() != 0) {
-            qWarning() << "ffmpeg process failed for:" << originalPath
-                       << "Exit code:" << ffmpegProcess.exitCode()
-                       << "Exit status:" << ffmpegProcess.exitStatus();
-            QString errorOutput = QString::fromLocal8Bit(ffmpegProcess.readAllStandardError());
-            qWarning() << "ffmpeg Standard Error:\n" << errorOutput;
-            QFile::remove(tempOggPath); // Clean up potentially failed temp file
-            failCount++;
-            continue;
-        }
-
-        // Check if temp Ogg exists and has size
-        QFileInfo tempOggInfo(tempOggPath);
-        if (!tempOggInfo.exists() || tempOggInfo.size() == 0) {
-            qWarning()
-                << "ffmpeg finished successfully but the output Ogg file is missing or empty:"
-                << tempOggPath;
-            QFile::remove(tempOggPath);
-            failCount++;
-            continue;
-        }
-
-        qInfo() << "ffmpeg conversion successful for:" << originalPath << " -> " << tempOggPath;
-
-        // --- Delete Original File ---
-        qInfo() << "Attempting to delete original file:" << originalPath;
-        if (!QFile::remove(originalPath)) {
-            qWarning() << "Failed to delete original file:" << originalPath
-                       << ". Skipping move and database update.";
-            failCount++;
-            continue; // Skip rest of steps for this file
-        }
-        qInfo() << "Original file deleted successfully.";
-
-        // --- Move Temporary Ogg to Final Location ---
-        qInfo() << "Attempting to move" << tempOggPath << "to" << finalOggPath;
-        if (!QFile::rename(tempOggPath, finalOggPath)) {
-            qWarning() << "Failed to move temporary Ogg" << tempOggPath << "to" << finalOggPath
-                       << ". The original file was deleted! Ogg remains in temp folder.";
-            QMessageBox::warning(
-                this, "Move Failed",
-                QString("Failed to move the converted Ogg file to its final destination:\n%1\n\n"
-                        "The original file was deleted, but the Ogg file remains in the temporary "
-                        "folder:\n%2\n\n"
-                        "Please move it manually and check the database record.")
-                    .arg(finalOggPath)
-                    .arg(tempOggPath));
-            failCount++;
-            continue; // Cannot update DB path if move failed
-        }
-        qInfo() << "Ogg file moved successfully to:" << finalOggPath;
-
-        // --- Update Database ---
-        qInfo() << "Updating database: set path =" << finalOggPath
-                << "where path =" << originalPath;
-        queryUpdate.bindValue(":new_path", finalOggPath);
-        queryUpdate.bindValue(":old_path", originalPath);
-
-        if (!queryUpdate.exec()) {
-            qWarning() << "Failed to update database path for:" << originalPath << "->"
-                       << finalOggPath;
-            qWarning() << "DB Error:" << queryUpdate.lastError().text();
-            qWarning() << "Last Query (Bound values might not show):" << queryUpdate.lastQuery();
-            QMessageBox::warning(this, "Database Update Failed",
-                                 QString("The file was successfully converted and moved to:\n%1\n\n"
-                                         "However, updating the database record failed:\n%2\n\n"
-                                         "Please check the database manually.")
-                                     .arg(finalOggPath)
-                                     .arg(queryUpdate.lastError().text()));
-            failCount++; // Count as failure since DB update is critical
-        } else {
-            qInfo() << "Database path updated successfully.";
-            successCount++;
-            // update_music_table(); // Update only once at the end
-        }
 
-    } // End while loop
-
-    // --- Final Cleanup & Summary ---
-    loadingMovie.stop();
-    ui->txt_loading->hide();
-    progressDialog.cancel(); // Close progress dialog
-
-    update_music_table(); // Update the table view once after all operations
-
-    // Updated summary message
-    QString summaryMessage;
-    if (cancelled) {
-        summaryMessage = QString("Operation Cancelled.\n\nProcessed: %1\nSuccessfully Converted to "
-                                 "Ogg: %2\nFailed/Skipped: %3")
-                             .arg(processedCount - 1)
-                             .arg(successCount)
-                             .arg(failCount);
-    } else {
-        summaryMessage = QString("Ogg Conversion Complete.\n\nTotal Records: %1\nSuccessfully "
-                                 "Converted: %2\nFailed/Skipped: %3")
-                             .arg(totalFiles) // Use the count obtained earlier
-                             .arg(successCount)
-                             .arg(failCount);
+    // Tracks already waiting or being converted are not queued twice, so a
+    // selection can be added while a conversion of the whole library runs
+    transcoder->setProgram(ffmpegPath);
+    const int queued = transcoder->enqueue(paths, suffix);
+    if (transcoder->pendingCount() == 0) {
+        QMessageBox::information(this, "Conversion Summary",
+                                 QString("There is nothing left to convert to %1.")
+                                     .arg(suffix.toUpper()));
+        return;
     }
+    qInfo() << queued << "tracks queued for conversion to" << suffix << ","
+            << transcoder->pendingCount() << "left in all";
 
-    qInfo() << "-------------------------------------";
-    qInfo() << summaryMessage.replace("\n\n", " | "); // Log summary concisely
-    qInfo() << "-------------------------------------";
-
-    QMessageBox::information(this, "Conversion Summary", summaryMessage);
+    transcoder->start();
+    if (!transcodeProgress->isProgressVisible())
+        transcodeProgress->showProgress(
+            "Converting tracks", QString("%1 tracks to convert").arg(transcoder->pendingCount()),
+            0, 1000);
+    transcodeProgress->updateProgress(transcoder->progress().permille);
 }
 void player::on_bt_start_streaming_clicked() {
-    qDebug() << "Starting the streaming!";
+    qCDebug(xfbPlayer) << "Starting the streaming!";
 
     on_bt_icecast_clicked();
 
@@ -7334,76 +6696,29 @@ void player::on_bt_stop_streaming_clicked() {
 
     qInfo() << "Attempting to stop streaming processes...";
 
-    // --- Stop Icecast ---
-    QProcess killer_icecast;
-    QString icecast_cmd;
-    QStringList icecast_args;
-    bool kill_success_icecast = false;
-
-#ifdef Q_OS_WIN
-    icecast_cmd = "taskkill";
-    icecast_args << "/F"
-                 << "/IM"
-                 << "icecast.exe"; // Adjust executable name if needed
-#else                              // Linux, macOS, other Unix-like
-    // Prefer pkill if available, fallback to killall might be needed if pkill isn't standard
-    icecast_cmd = "pkill";     // Or "killall" as a fallback
-    icecast_args << "icecast"; // Process name
-#endif
-
-    qDebug() << "Running kill command for icecast:" << icecast_cmd << icecast_args;
-    killer_icecast.start(icecast_cmd, icecast_args);
-    if (killer_icecast.waitForFinished(3000)) { // Wait up to 3 seconds
-        if (killer_icecast.exitStatus() == QProcess::NormalExit && killer_icecast.exitCode() == 0) {
-            qInfo() << "Icecast process killed successfully (or was not running).";
-            kill_success_icecast = true; // Assume success if command ran ok
-        } else {
-            qWarning() << "Kill command for icecast failed or process not found. Exit code:"
-                       << killer_icecast.exitCode();
-            // Might log stderr: QString err = killer_icecast.readAllStandardError(); qDebug() <<
-            // err;
-        }
-    } else {
-        qWarning() << "Kill command for icecast timed out.";
-        killer_icecast.kill(); // Kill the killer process itself
-    }
+    // --- Stop Icecast and Butt ---
+    // Both supervised children are signalled at once, each with its whole
+    // process group, so butt goes down with the xvfb-run that wraps it.
+    // The report arrives once they are gone; nothing here waits for it
+    QStringList helpers = {"icecast"};
+    if (builtinStream)
+        stopBuiltinStream();
+    else
+        helpers << "butt";
+    processShutdown->stop(helpers, [](const ShutdownCoordinator::Report& report) {
+        qInfo() << "Streaming processes stopped in" << report.elapsedMs << "ms:" << report.stopped;
+        if (!report.forced.isEmpty())
+            qWarning() << "Had to kill:" << report.forced;
+        if (!report.unresponsive.isEmpty())
+            qWarning() << "Still running after being killed:" << report.unresponsive;
+    });
+    icecastrunning = false;
+    buttrunning = false;
 
-    // Update UI regardless of success? Or only on success? Let's update anyway.
     ui->lbl_icecast->setText("Stopped");
     ui->lbl_icecast->setStyleSheet("color:blue;"); // Ensure CSS syntax is correct
     ui->bt_icecast->setStyleSheet("");
 
-    // --- Stop Butt ---
-    QProcess killer_butt;
-    QString butt_cmd;
-    QStringList butt_args;
-    bool kill_success_butt = false;
-
-#ifdef Q_OS_WIN
-    butt_cmd = "taskkill";
-    butt_args << "/F"
-              << "/IM"
-              << "butt.exe"; // Adjust executable name if needed
-#else                        // Linux, macOS, other Unix-like
-    butt_cmd = "pkill";  // Or "killall"
-    butt_args << "butt"; // Process name
-#endif
-
-    qDebug() << "Running kill command for butt:" << butt_cmd << butt_args;
-    killer_butt.start(butt_cmd, butt_args);
-    if (killer_butt.waitForFinished(3000)) { // Wait up to 3 seconds
-        if (killer_butt.exitStatus() == QProcess::NormalExit && killer_butt.exitCode() == 0) {
-            qInfo() << "Butt process killed successfully (or was not running).";
-            kill_success_butt = true;
-        } else {
-            qWarning() << "Kill command for butt failed or process not found. Exit code:"
-                       << killer_butt.exitCode();
-        }
-    } else {
-        qWarning() << "Kill command for butt timed out.";
-        killer_butt.kill();
-    }
-
     ui->lbl_butt->setText("Stopped");
     ui->lbl_butt->setStyleSheet("color:blue;");
     ui->bt_butt->setStyleSheet("");
@@ -7419,152 +6734,36 @@ void player::on_bt_stop_streaming_clicked() {
     ui->txt_ProgramName->setStyleSheet(""); // Clear specific style
     ui->txt_ProgramName->hide();
 
-    piscaLive = false; // Assuming piscaLive is a member variable bool
-}
-void player::streaming_timmer() {
-    qDebug() << "Running streaming_timmer (checking external processes...)";
-
-    // --- Check Icecast ---
-    QProcess check_icecast;
-    QString icecast_check_cmd;
-    QStringList icecast_check_args;
-    bool icecast_running = false;
-
-#ifdef Q_OS_WIN
-    icecast_check_cmd = "tasklist";
-    icecast_check_args << "/NH"
-                       << "/FI"
-                       << "IMAGENAME eq icecast.exe"; // Adjust image name
-#else                                                 // Linux, macOS, other Unix-like
-    icecast_check_cmd = "pgrep";
-    icecast_check_args << "-x"
-                       << "icecast"; // Match exact process name
-#endif
-
-    check_icecast.start(icecast_check_cmd, icecast_check_args);
-    if (check_icecast.waitForFinished(1000)) { // Short timeout
-#ifdef Q_OS_WIN
-        // Tasklist often returns 0 even if not found, check output
-        QString output = check_icecast.readAllStandardOutput();
-        if (output.contains("icecast.exe", Qt::CaseInsensitive)) {
-            icecast_running = true;
-        }
-#else // pgrep check
-        if (check_icecast.exitStatus() == QProcess::NormalExit && check_icecast.exitCode() == 0) {
-            // pgrep returns 0 if process(es) found
-            icecast_running = true;
-        }
-#endif
-    } else {
-        qWarning() << "Check command for icecast timed out or failed.";
-    }
-
-    // Update Icecast UI
-    if (icecast_running) {
-        ui->lbl_icecast->setText("Running");
-        ui->lbl_icecast->setStyleSheet("color:green;");
-    } else {
-        ui->lbl_icecast->setText("Stopped");
-        ui->lbl_icecast->setStyleSheet("color:red;");
-        ui->bt_takeOver->setEnabled(false); // Disable takeover if icecast stopped
-    }
-
-    // --- Check Butt ---
-    QProcess check_butt;
-    QString butt_check_cmd;
-    QStringList butt_check_args;
-    bool butt_running = false;
-
-#ifdef Q_OS_WIN
-    butt_check_cmd = "tasklist";
-    butt_check_args << "/NH"
-                    << "/FI"
-                    << "IMAGENAME eq butt.exe"; // Adjust image name
-#else                                           // Linux, macOS, other Unix-like
-    butt_check_cmd = "pgrep";
-    butt_check_args << "-x"
-                    << "butt"; // Match exact process name
-#endif
-
-    check_butt.start(butt_check_cmd, butt_check_args);
-    if (check_butt.waitForFinished(1000)) { // Short timeout
-#ifdef Q_OS_WIN
-        QString output = check_butt.readAllStandardOutput();
-        if (output.contains("butt.exe", Qt::CaseInsensitive)) {
-            butt_running = true;
-        }
-#else // pgrep check
-        if (check_butt.exitStatus() == QProcess::NormalExit && check_butt.exitCode() == 0) {
-            butt_running = true;
-        }
-#endif
-    } else {
-        qWarning() << "Check command for butt timed out or failed.";
-    }
-
-    // Update Butt UI
-    if (butt_running) {
-        ui->lbl_butt->setText("Running");
-        ui->lbl_butt->setStyleSheet("color:green;");
-    } else {
-        ui->lbl_butt->setText("Stopped");
-        ui->lbl_butt->setStyleSheet("color:red;");
-        ui->bt_takeOver->setEnabled(false); // Also disable if butt stopped? Decide based on logic.
-    }
-}
-void player::ddnsUpdate() {
-    qDebug() << "Requesting external IP address...";
-
-    // Ensure networkManager is initialized (e.g., in constructor)
-    if (!networkManager) {
-        qWarning() << "Network manager not initialized!";
-        networkManager = new QNetworkAccessManager(this); // Lazy init? Or handle error better.
-    }
-
-    // Use HTTPS for security. icanhazip supports it.
-    QUrl url("https://ipv4.icanhazip.com");
-    QNetworkRequest request(url);
-
-    // Set a timeout for the request (e.g., 10 seconds)
-    request.setTransferTimeout(10000);
-
-    QNetworkReply* reply = networkManager->get(request);
-
-    // Connect the finished signal to a lambda or a dedicated slot
-    connect(reply, &QNetworkReply::finished, this, [this, reply]() {
-        QString externalIp = "Error"; // Default in case of failure
-
-        if (reply->error() == QNetworkReply::NoError) {
-            QByteArray responseData = reply->readAll();
-            externalIp = QString::fromUtf8(responseData).trimmed(); // Assume UTF-8, trim whitespace
-            qInfo() << "External IP determined:" << externalIp;
-        } else {
-            qWarning() << "Failed to get external IP:" << reply->errorString();
-            externalIp = "Error: " + reply->errorString(); // Provide error info in UI
-        }
-
-        // Update the UI label
-        ui->lbl_ddns->setText(externalIp);
-        // Consider styling based on success/error?
-        // if (reply->error() != QNetworkReply::NoError) {
-        //     ui->lbl_ddns->setStyleSheet("color: red;");
-        // } else {
-        //     ui->lbl_ddns->setStyleSheet(""); // Clear style
-        // }
-
-        // IMPORTANT: Clean up the reply object to prevent memory leaks
-        reply->deleteLater();
-    });
-
-    // Optional: Connect errorOccurred signal for more immediate feedback?
-    // connect(reply, &QNetworkReply::errorOccurred, this, ...);
+    piscaLive = false; // Assuming piscaLive is a member variable bool
+}
+void player::streaming_timmer() {
+    // Process state comes from streamSupervisor; nothing to poll
+    ice_timmer();
+    butt_timmer();
+    const bool sourceRunning = builtinStream ? streamOutput && streamOutput->isRunning()
+                                             : streamSupervisor && streamSupervisor->isRunning("butt");
+    if (!streamSupervisor || !streamSupervisor->isRunning("icecast") || !sourceRunning)
+        ui->bt_takeOver->setEnabled(false);
+}
+void player::ddnsUpdate(bool forceRefresh) {
+    qCDebug(xfbPlayer) << "Requesting external IP address...";
 
-    // Optional: Connect sslErrors signal if needed for debugging HTTPS issues
-    // connect(reply, &QNetworkReply::sslErrors, this, ...);
+    // The address is cached, and a DDNS update is sent only when it changed
+    networkMaintenance->publicAddress(
+        [this](const QHostAddress& address, const QString& error) {
+            if (error.isEmpty()) {
+                qInfo() << "External IP determined:" << address.toString();
+                ui->lbl_ddns->setText(address.toString());
+            } else {
+                qWarning() << "Failed to get external IP:" << error;
+                ui->lbl_ddns->setText("Error: " + error); // Provide error info in UI
+            }
+        },
+        forceRefresh);
 }
 
 void player::on_horizontalSlider_lps_vol_sliderMoved(int position) {
-    qDebug() << "LPS Horisontal Slider moved to: " << position;
+    XFB_TRACE(xfbPlayback) << "LPS Horisontal Slider moved to: " << position;
 
     if (position == 100) {
         lp1_XplayerOutput->setVolume(1.0); // Qt6 uses 0.0-1.0 range for volume
@@ -7609,23 +6808,12 @@ void player::on_bt_center_lps_vol_clicked() {
 }
 
 void player::on_txt_search_returnPressed() {
-    // search
-    qDebug() << "Staring a new search!";
-    QString term = ui->txt_search->text();
-
-    QSqlQueryModel* model = new QSqlQueryModel();
-    model->setQuery("select * from musics where artist like '%" + term + "%' or song like '%" +
-                    term + "%'");
-    ui->musicView->setModel(model);
-
-    ui->musicView->setSortingEnabled(true);
-    ui->musicView->hideColumn(0);
-    ui->musicView->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+    // Same search as the button, filtering the shared music model
+    on_bt_search_clicked();
 }
 
 void player::on_actionForce_monitorization_triggered() {
     server_check_and_schedule_new_programs();
-    run_server_scheduler();
 }
 
 void player::on_actionUpdate_Dinamic_Server_s_IP_triggered() {
@@ -7667,7 +6855,7 @@ void player::on_actionUpdate_Dinamic_Server_s_IP_triggered() {
     QNetworkRequest request(configUrl);
     request.setTransferTimeout(15000); // 15 second timeout
 
-    qDebug() << "Fetching configuration from:" << request.url().toString();
+    qCDebug(xfbPlayer) << "Fetching configuration from:" << request.url().toString();
 
     QNetworkReply* reply = networkManager->get(request);
 
@@ -7765,27 +6953,17 @@ void player::on_actionUpdate_Dinamic_Server_s_IP_triggered() {
 void player::on_bt_add_some_random_songs_from_genre_clicked() {
     QString selectedGenre = ui->comboBox_random_add_genre->currentText();
 
-    QSqlDatabase db = QSqlDatabase::database("xfb_connection");
-    QString num = ui->spinBox_num_of_songs_to_add_random->text();
+    const int num = ui->spinBox_num_of_songs_to_add_random->value();
     checkDbOpen();
-    QString querystr = "select path from musics where genre1 like '" + selectedGenre +
-                       "' order by random() limit " + num;
-    QSqlQuery query(db);
-    if (query.exec(querystr)) {
-        qDebug() << "SQL query executed from 201606181026: " << query.lastQuery();
-
-        while (query.next()) {
-            QString path = query.value(0).toString();
-
-            ui->playlist->addItem(path);
-            qDebug() << "autoMode genre based random music chooser from "
-                        "on_bt_add_some_random_songs_from_genre_clicked() adding: "
-                     << path;
-        }
-
-    } else {
-        qDebug() << "SQL ERROR: " << query.lastError();
-        qDebug() << "SQL was: " << query.lastQuery();
+    if (!musicRepository)
+        return;
+    // The repository keeps the statement prepared for the next click; errors are logged there
+    const QStringList paths = musicRepository->getRandomPathsByGenre(selectedGenre, num);
+    for (const QString& path : paths) {
+        playlistQueue->append(path);
+        qCDebug(xfbPlaylist) << "autoMode genre based random music chooser from "
+                                "on_bt_add_some_random_songs_from_genre_clicked() adding: "
+                             << path;
     }
 }
 
@@ -7797,81 +6975,40 @@ void player::on_bt_icecast_clicked() {
         // --- Try to START Icecast ---
         qInfo() << "Attempting to start Icecast...";
 
-        // 1. Force kill any existing instances first (as per original logic)
-        qDebug() << "Ensuring no other icecast instances are running...";
-        killProcessByName("icecast"); // Call helper function
-
-        // 2. Find xvfb-run
-        QString xvfbRunPath = QStandardPaths::findExecutable("xvfb-run");
-        if (xvfbRunPath.isEmpty()) {
-            qWarning() << "xvfb-run command not found in PATH. Cannot start icecast.";
+        // 1. Find icecast; it is a plain server and needs no display
+        QString icecastPath = QStandardPaths::findExecutable("icecast");
+        if (icecastPath.isEmpty()) {
+            qWarning() << "icecast command not found in PATH. Cannot start icecast.";
             QMessageBox::critical(this, "Error",
-                                  "Required command 'xvfb-run' not found. Cannot start Icecast.");
+                                  "Required command 'icecast' not found. Cannot start Icecast.");
             return; // Cannot proceed
         }
-        qDebug() << "Found xvfb-run at:" << xvfbRunPath;
-        // Optional: Check if icecast executable itself exists?
-        // QString icecastPath = QStandardPaths::findExecutable("icecast");
-        // if (icecastPath.isEmpty()) { ... error ... }
-
-        // 3. Prepare and start the process detached
-        QProcess* icecastProcess =
-            new QProcess(this); // Create on heap if needed elsewhere, else stack
-        QStringList args;
+        qCDebug(xfbPlayer) << "Found icecast at:" << icecastPath;
+
+        // 2. Kill instances left over from an earlier run, then run it as a
+        // supervised child: its state arrives through stateChanged and it is
+        // restarted if it dies
+        qCDebug(xfbPlayer) << "Ensuring no other icecast instances are running...";
         QString configPath = "/usr/local/etc/icecast.xml"; // Consider making this configurable
-        args << "-a"
-             << "icecast"
-             << "-c" << configPath;
-
-        qDebug() << "Starting detached process:" << xvfbRunPath << args;
-
-        bool started = icecastProcess->startDetached(xvfbRunPath, args);
-        // Note: startDetached only tells you if Qt could *invoke* the process,
-        // not if xvfb-run or icecast started successfully internally.
-        // The timer check (ice_timmer) is the real verification.
-
-        if (started) {
-            qInfo() << "Icecast process launch initiated.";
-            icecastrunning = true; // Update state flag
-
-            // Update UI to "Starting" or "Running" - timer will confirm "Running"
-            ui->lbl_icecast->setText("Starting...");         // More accurate initial state
-            ui->lbl_icecast->setStyleSheet("color:orange;"); // Indicate intermediate state
-            ui->bt_icecast->setStyleSheet("background-color:#C8EE72;"); // Indicate "on" state
-
-            // Connect and start the timer to check status
-            if (icetimer) {
-                // Disconnect first to avoid multiple connections if clicked rapidly
-                disconnect(icetimer, &QTimer::timeout, this, &player::ice_timmer);
-                connect(icetimer, &QTimer::timeout, this, &player::ice_timmer);
-                icetimer->start(5000); // Check every 5 seconds
-                QTimer::singleShot(500, this,
-                                   &player::ice_timmer); // Check quickly once after starting
-            } else {
-                qWarning() << "icetimer is null!";
-            }
-        } else {
-            qWarning() << "Failed to initiate icecast process launch.";
-            QMessageBox::critical(this, "Error",
-                                  "Failed to start the Icecast process using xvfb-run.");
-            // Don't change icecastrunning state or UI if launch failed
-            delete icecastProcess; // Clean up if created on heap
-        }
+        killProcessByName("icecast", [this, icecastPath, configPath](bool) {
+            if (!icecastrunning)
+                return; // Stopped again in the meantime
+            streamSupervisor->addProcess("icecast", icecastPath, {"-c", configPath});
+            streamSupervisor->start("icecast");
+        });
+
+        icecastrunning = true; // Update state flag
+        ui->bt_icecast->setStyleSheet("background-color:#C8EE72;"); // Indicate "on" state
+        ice_timmer();
 
     } else {
         // --- Try to STOP Icecast ---
         qInfo() << "Attempting to stop Icecast...";
 
-        // 1. Stop the status check timer
-        if (icetimer) {
-            icetimer->stop();
-            // Optional: disconnect(icetimer, &QTimer::timeout, this, &player::ice_timmer);
-        }
-
-        // 2. Kill the process
-        bool killed = killProcessByName("icecast"); // Call helper function
+        // 1. Terminate the child; it is killed if it does not exit in time
+        streamSupervisor->stop("icecast");
 
-        // 3. Update state and UI regardless of kill success, as the intention is to stop
+        // 2. Update state and UI, as the intention is to stop
         icecastrunning = false;
         ui->bt_icecast->setStyleSheet(""); // Default style
         ui->lbl_icecast->setText("Stopped");
@@ -7883,99 +7020,34 @@ void player::on_bt_icecast_clicked() {
         ui->txt_ProgramName->setStyleSheet(""); // Clear specific style
         ui->txt_ProgramName->hide();
         piscaLive = false;
-
-        if (!killed) {
-            qWarning()
-                << "Kill command for icecast may have failed, but UI is set to stopped state.";
-            // User might need to manually check if process actually stopped
-        }
     }
 }
 void player::ice_timmer() {
-    qDebug() << "Running ice_timmer (checking icecast process status...)";
-
-    QProcess check_icecast;
-    QString check_cmd;
-    QStringList check_args;
-    bool is_running = false; // Assume not running initially
-
-#ifdef Q_OS_WIN
-    // Windows: Use tasklist with image name filter
-    check_cmd = "tasklist";
-    // /NH for no header, /FI for filter. Adjust "icecast.exe" if needed.
-    check_args << "/NH"
-               << "/FI"
-               << "IMAGENAME eq icecast.exe";
-#else
-    // Unix-like (Linux, macOS): Use pgrep with exact name match
-    check_cmd = "pgrep";
-    check_args << "-x"
-               << "icecast"; // -x matches the name exactly
-#endif
-
-    qDebug() << "Executing check:" << check_cmd << check_args;
-    check_icecast.start(check_cmd, check_args);
-
-    // Wait for the check command to finish (short timeout)
-    if (check_icecast.waitForFinished(1500)) { // 1.5 second timeout
+    // The supervisor tracks the icecast child itself, so this only mirrors its state
+    const ProcessSupervisor::State state =
+        streamSupervisor ? streamSupervisor->state("icecast") : ProcessSupervisor::State::Stopped;
 
-#ifdef Q_OS_WIN
-        // On Windows, tasklist usually exits with 0 even if not found when filtering.
-        // We need to check if the output contains the process name.
-        QByteArray output = check_icecast.readAllStandardOutput();
-        if (output.contains("icecast.exe", Qt::CaseInsensitive)) {
-            is_running = true;
-            qDebug() << "tasklist output indicates icecast is running.";
-        } else {
-            qDebug() << "tasklist output does not contain icecast.exe.";
-            is_running = false;
-        }
-#else
-        // On Unix-like, pgrep exits with 0 if found, non-zero otherwise.
-        if (check_icecast.exitStatus() == QProcess::NormalExit && check_icecast.exitCode() == 0) {
-            is_running = true;
-            qDebug() << "pgrep found running icecast process (exit code 0).";
-        } else {
-            // Exit code 1 usually means not found, other codes indicate errors.
-            qDebug() << "pgrep did not find running icecast process (exit code"
-                     << check_icecast.exitCode() << ").";
-            is_running = false;
-        }
-#endif
-    } else {
-        // Timeout or other error running the check command itself
-        qWarning() << "Check command (" << check_cmd << ") timed out or failed to start.";
-        is_running = false; // Assume not running if check failed
-        // Consider setting UI to an "Unknown" or "Error" state? For now, treat as stopped.
-    }
-
-    // --- Update UI based on the is_running state ---
-    if (is_running) {
-        // Update state variable if needed (though might be redundant if only used here)
-        if (!icecastrunning) { // Update internal state if it changed
-            qInfo() << "Icecast detected as running (was previously considered stopped).";
-            icecastrunning = true;
-        }
-        // Set UI to "Running" state
+    if (state == ProcessSupervisor::State::Running) {
+        icecastrunning = true;
         ui->lbl_icecast->setText("Running");
-        ui->lbl_icecast->setStyleSheet("color:green;"); // Ensure semicolon
-        // Optionally ensure other UI elements are in the correct "running" state if needed
-    } else {
-        // Update state variable if needed
-        if (icecastrunning) { // Update internal state if it changed
-            qInfo() << "Icecast detected as stopped (was previously considered running).";
-            icecastrunning = false;
-        }
-        // Set UI to "Stopped" state and reset related elements
-        ui->lbl_icecast->setText("Stopped");
-        ui->lbl_icecast->setStyleSheet("color:red;"); // Ensure semicolon
+        ui->lbl_icecast->setStyleSheet("color:green;");
+    } else if (state == ProcessSupervisor::State::Starting) {
+        ui->lbl_icecast->setText("Starting...");
+        ui->lbl_icecast->setStyleSheet("color:orange;");
+    } else if (state == ProcessSupervisor::State::Backoff) {
+        // Died on its own; the supervisor restarts it after a delay
+        ui->lbl_icecast->setText("Restarting...");
+        ui->lbl_icecast->setStyleSheet("color:red;");
 
-        // Reset other UI elements as per original logic when stopped
         ui->bt_takeOver->setStyleSheet("");
         ui->bt_takeOver->setEnabled(false);
         ui->txt_ProgramName->setStyleSheet(""); // Clear specific style
         ui->txt_ProgramName->hide();
         piscaLive = false; // Reset live indicator flag
+    } else {
+        icecastrunning = false;
+        ui->lbl_icecast->setText("Stopped");
+        ui->lbl_icecast->setStyleSheet("color:blue;");
     }
 }
 void player::on_bt_butt_clicked() {
@@ -7983,14 +7055,21 @@ void player::on_bt_butt_clicked() {
     bool shouldBeRunning = !buttrunning;
 
     if (shouldBeRunning) {
+        if (builtinStream) {
+            // Encode the mixer's own output and push it to Icecast; no butt,
+            // no virtual display and no capture of the sound card
+            if (!startBuiltinStream())
+                return;
+            buttrunning = true;
+            ui->bt_butt->setStyleSheet("background-color:#C8EE72;");
+            butt_timmer();
+            return;
+        }
+
         // --- Try to START Butt ---
         qInfo() << "Attempting to start Butt...";
 
-        // 1. Force kill any existing instances first
-        qDebug() << "Ensuring no other butt instances are running...";
-        killProcessByName("butt"); // Kill 'butt' process
-
-        // 2. Find required executables
+        // 1. Find required executables
         QString xvfbRunPath = QStandardPaths::findExecutable("xvfb-run");
         if (xvfbRunPath.isEmpty()) {
             qWarning() << "xvfb-run command not found in PATH. Cannot start butt.";
@@ -8005,60 +7084,37 @@ void player::on_bt_butt_clicked() {
                                   "Required command 'butt' not found. Cannot start Butt.");
             return; // Cannot proceed
         }
-        qDebug() << "Found xvfb-run at:" << xvfbRunPath;
-        qDebug() << "Found butt at:" << buttPath; // We found it, but xvfb-run will call it by name
-
-        // 3. Prepare and start the process detached
-        QProcess* buttProcess = new QProcess(this); // Optional: manage this pointer if needed later
-        QStringList args;
-        args << "-a"
-             << "butt"; // Arguments for xvfb-run
-
-        qDebug() << "Starting detached process:" << xvfbRunPath << args;
-
-        bool started = buttProcess->startDetached(xvfbRunPath, args);
-
-        if (started) {
-            qInfo() << "Butt process launch initiated.";
-            buttrunning = true; // Update state flag
-
-            // Update UI to "Starting..." - timer will confirm "Running"
-            ui->lbl_butt->setText("Starting...");                    // More accurate initial state
-            ui->lbl_butt->setStyleSheet("color:orange;");            // Indicate intermediate state
-            ui->bt_butt->setStyleSheet("background-color:#C8EE72;"); // Indicate "on" state
-
-            // Connect and start the timer to check status
-            if (butt_timer) {
-                // Ensure clean connection
-                disconnect(butt_timer, &QTimer::timeout, this, &player::butt_timmer);
-                connect(butt_timer, &QTimer::timeout, this, &player::butt_timmer);
-                butt_timer->start(5000); // Check every 5 seconds
-                QTimer::singleShot(500, this,
-                                   &player::butt_timmer); // Check quickly once after starting
-            } else {
-                qWarning() << "butt_timer is null!";
-            }
-        } else {
-            qWarning() << "Failed to initiate butt process launch.";
-            QMessageBox::critical(this, "Error",
-                                  "Failed to start the Butt process using xvfb-run.");
-            // Clean up if necessary
-            delete buttProcess;
-        }
+        qCDebug(xfbPlayer) << "Found xvfb-run at:" << xvfbRunPath;
+        qCDebug(xfbPlayer) << "Found butt at:"
+                           << buttPath; // We found it, but xvfb-run will call it by name
+
+        // 2. Kill instances left over from an earlier run, then run it as a
+        // supervised child: its state arrives through stateChanged and it is
+        // restarted if it dies
+        qCDebug(xfbPlayer) << "Ensuring no other butt instances are running...";
+        killProcessByName("butt", [this, xvfbRunPath](bool) {
+            if (!buttrunning)
+                return; // Stopped again in the meantime
+            streamSupervisor->addProcess("butt", xvfbRunPath, {"-a", "butt"});
+            streamSupervisor->start("butt");
+        });
+
+        buttrunning = true; // Update state flag
+        ui->bt_butt->setStyleSheet("background-color:#C8EE72;"); // Indicate "on" state
+        butt_timmer();
 
     } else {
         // --- Try to STOP Butt ---
         qInfo() << "Attempting to stop Butt...";
 
-        // 1. Stop the status check timer
-        if (butt_timer) {
-            butt_timer->stop();
-            // Optional: disconnect(...)
+        if (builtinStream) {
+            stopBuiltinStream();
+        } else {
+            // 1. Stop supervising; the signal goes to the process group, so
+            // butt goes down with xvfb-run even though it does not pass it on
+            processShutdown->stop({"butt"});
         }
 
-        // 2. Kill the 'butt' process (FIXED: was killing icecast in original code)
-        bool killed = killProcessByName("butt");
-
         // 3. Update state and UI regardless of kill success
         buttrunning = false;
         ui->bt_butt->setStyleSheet(""); // Default style
@@ -8075,199 +7131,422 @@ void player::on_bt_butt_clicked() {
         ui->txt_ProgramName->setStyleSheet(""); // Clear specific style
         ui->txt_ProgramName->hide();
         piscaLive = false;
-
-        if (!killed) {
-            qWarning() << "Kill command for butt may have failed, but UI is set to stopped state.";
-        }
     }
 }
 
-// --- Refactored butt_timmer ---
+bool player::startBuiltinStream() {
+    QList<StreamOutput::Mount> mounts;
+    const bool hlsOnly = streamMounts.trimmed().isEmpty() && !hlsTarget.isEmpty();
+    if (!hlsOnly && !StreamOutput::parseMounts(streamMounts, mounts)) {
+        QMessageBox::critical(this, "Error",
+                              tr("The StreamMounts setting is not valid: %1\n"
+                                 "Use entries like /live.ogg=opus:96, /live.mp3=mp3:128")
+                                  .arg(streamMounts));
+        return false;
+    }
 
-void player::butt_timmer() {
-    qDebug() << "Running butt_timmer (checking butt process status...)";
-
-    QProcess check_butt;
-    QString check_cmd;
-    QStringList check_args;
-    bool is_running = false; // Assume not running initially
-
-#ifdef Q_OS_WIN
-    // Windows: Use tasklist with image name filter
-    check_cmd = "tasklist";
-    // Adjust "butt.exe" if the actual executable name differs
-    check_args << "/NH"
-               << "/FI"
-               << "IMAGENAME eq butt.exe";
-#else
-    // Unix-like (Linux, macOS): Use pgrep with exact name match
-    check_cmd = "pgrep";
-    check_args << "-x"
-               << "butt"; // -x matches the name exactly
-#endif
+    // The stream goes to the Icecast started by on_bt_icecast_clicked()
+    if (streamSource == "input") {
+        // Shares the capture with the recorder instead of opening the card again
+        liveCapture->setDevice(audioInput(audioDevices, recDevice));
+        if (streamReader < 0)
+            streamReader = liveCapture->openReader();
+        streamOutput->setSource(liveCapture->reader(streamReader), liveCapture->sampleRate());
+    } else {
+        streamOutput->setSource(
+            [this](float* data, int samples) { return playbackEngine->readTap(data, samples); },
+            playbackEngine->sampleRate());
+        playbackEngine->setTapEnabled(true);
+    }
+    streamOutput->setServer("127.0.0.1", TAKEOVER_STREAM_PORT, streamPassword);
+    streamOutput->setMounts(mounts);
+    StreamOutput::Hls hls;
+    hls.target = hlsTarget;
+    hls.codec = hlsCodec.compare("opus", Qt::CaseInsensitive) == 0 ? StreamOutput::Codec::Opus
+                                                                   : StreamOutput::Codec::Aac;
+    hls.bitrateKbps = hlsBitrate;
+    hls.segmentMs = qMax(1, hlsSegmentSeconds) * 1000;
+    streamOutput->setHls(hls);
+
+    if ((streamSource == "input" && streamReader < 0) || !streamOutput->start()) {
+        stopBuiltinStream();
+        QMessageBox::critical(this, "Error",
+                              tr("Could not start the built-in stream. Check that ffmpeg is "
+                                 "installed and that playback has started, or that the input "
+                                 "is available."));
+        return false;
+    }
+    return true;
+}
+
+void player::applyDeadAir() {
+    deadAirDetector->setSilenceSeconds(deadAirSeconds);
+    deadAirDetector->setThresholdDb(deadAirThresholdDb);
+
+    // Only audio meant to be on air is watched; a stop or pause is not dead air
+    const bool playing = playbackEngine->state() == DeckMixer::State::Playing;
+    deadAirDetector->setFormat(DeadAirDetector::Source::Output, playbackEngine->sampleRate(),
+                               AudioDeck::CHANNELS);
+    deadAirDetector->setArmed(DeadAirDetector::Source::Output, deadAirSeconds > 0 && playing);
+    deadAirDetector->setFormat(DeadAirDetector::Source::Input, liveCapture->sampleRate(),
+                               LiveCapture::CHANNELS);
+    deadAirDetector->setArmed(DeadAirDetector::Source::Input,
+                              deadAirSeconds > 0 && liveCapture->isCapturing());
+}
+
+void player::applyDucking() {
+    micDucker->setThresholdDb(duckThresholdDb);
+    micDucker->setDepthDb(duckDepthDb);
+    micDucker->setAttackMs(duckAttackMs);
+    micDucker->setReleaseMs(duckReleaseMs);
+    micDucker->setEnabled(duckMusic);
+
+    // The side chain needs the input open even when nothing records or streams it
+    if (duckMusic) {
+        if (!liveCapture->isCapturing())
+            liveCapture->setDevice(audioInput(audioDevices, recDevice));
+        liveCapture->start();
+    } else {
+        liveCapture->stop();
+    }
+}
 
-    qDebug() << "Executing check:" << check_cmd << check_args;
-    check_butt.start(check_cmd, check_args);
+void player::stopBuiltinStream() {
+    streamOutput->stop();
+    playbackEngine->setTapEnabled(false);
+    liveCapture->closeReader(streamReader);
+    streamReader = -1;
+}
 
-    // Wait for the check command to finish (short timeout)
-    if (check_butt.waitForFinished(1500)) { // 1.5 second timeout
+bool player::isContributionStream(const QString& stream) const {
+    return QUrl(stream).scheme() == QLatin1String(CONTRIBUTION_SCHEME);
+}
 
-#ifdef Q_OS_WIN
-        QByteArray output = check_butt.readAllStandardOutput();
-        if (output.contains("butt.exe", Qt::CaseInsensitive)) {
-            is_running = true;
-            qDebug() << "tasklist output indicates butt is running.";
-        } else {
-            qDebug() << "tasklist output does not contain butt.exe.";
-            is_running = false;
+void player::startContribution() {
+    // What goes out is the live input, shared with the recorder and the stream
+    const QString host = QUrl::fromUserInput(Server_URL).host();
+    if (host.isEmpty()) {
+        qWarning() << "Cannot start the contribution link: Server_URL has no host.";
+        return;
+    }
+    liveCapture->setDevice(audioInput(audioDevices, recDevice));
+    if (contributionReader < 0)
+        contributionReader = liveCapture->openReader();
+    if (contributionReader < 0) {
+        qWarning() << "Cannot start the contribution link: the input is not available.";
+        return;
+    }
+    QHostInfo::lookupHost(host, this, [this](const QHostInfo& info) {
+        if (contributionReader < 0)
+            return;
+        if (info.addresses().isEmpty()) {
+            qWarning() << "Cannot start the contribution link:" << info.errorString();
+            return;
         }
-#else
-        if (check_butt.exitStatus() == QProcess::NormalExit && check_butt.exitCode() == 0) {
-            is_running = true;
-            qDebug() << "pgrep found running butt process (exit code 0).";
-        } else {
-            qDebug() << "pgrep did not find running butt process (exit code"
-                     << check_butt.exitCode() << ").";
-            is_running = false;
+        contributionLink->send(info.addresses().first(),
+                               static_cast<quint16>(contributionPort),
+                               liveCapture->reader(contributionReader), liveCapture->sampleRate());
+    });
+}
+
+void player::stopContribution() {
+    contributionLink->stop();
+    liveCapture->closeReader(contributionReader);
+    contributionReader = -1;
+}
+
+void player::applyStreamMetadata() {
+    // No mounts, no updates
+    QStringList mounts;
+    if (streamMetadata && !streamMetadataMounts.trimmed().isEmpty()) {
+        mounts = streamMetadataMounts.split(',', Qt::SkipEmptyParts);
+    } else if (streamMetadata && builtinStream) {
+        QList<StreamOutput::Mount> streamed;
+        StreamOutput::parseMounts(streamMounts, streamed);
+        for (const StreamOutput::Mount& mount : std::as_const(streamed)) {
+            if (mount.codec == StreamOutput::Codec::Mp3)
+                mounts << mount.path;
+        }
+    }
+    icecastMetadata->setServer("127.0.0.1", TAKEOVER_STREAM_PORT, streamPassword);
+    icecastMetadata->setMounts(mounts);
+}
+
+void player::setupConfigReload() {
+    // Saved options reach the subsystems that read them, without a restart
+    configReloader = new ConfigReloader(this);
+    configReloader->subscribe("library roots",
+                              {"LibraryRoots", "LibraryRescanTime", "LibraryWatch", "MusicPath"},
+                              [this]() { applyLibraryRoots(); });
+    configReloader->subscribe("stream metadata", {"Stream*", "BuiltinStream"},
+                              [this]() { applyStreamMetadata(); });
+    configReloader->subscribe("built-in stream",
+                              {"StreamMounts", "StreamPassword", "StreamSource", "Hls*"},
+                              [this]() { restartBuiltinStream(); });
+    configReloader->subscribe("air-check", {"AirCheck*", "SavePath"},
+                              [this]() { applyAirCheck(); });
+    configReloader->subscribe("retention", {"Programs*"}, [this]() { applyRetention(); });
+    configReloader->subscribe("dead air", {"DeadAir*"}, [this]() { applyDeadAir(); });
+    configReloader->subscribe("ducking", {"Duck*", "RecDevice"}, [this]() { applyDucking(); });
+    configReloader->subscribe("ad breaks", {"AdBreakSeconds", "AdSeparationMin", "AdMaxDailyPlays"},
+                              [this]() { applyAdBreaks(); });
+    configReloader->subscribe("metrics", {"MetricsPort"}, [this]() { applyMetrics(); });
+    configReloader->subscribe("remote control", {"RemotePort", "RemoteToken"},
+                              [this]() { applyRemoteControl(); });
+    configReloader->subscribe("media cache", {"MediaCache*"}, [this]() { applyMediaCache(); });
+    configReloader->subscribe("library sync", {"LibraryFeed", "LibraryPrimary*", "LibraryPath*"},
+                              [this]() { applyLibrarySync(); });
+    configReloader->subscribe("stall watchdog", {"StallThresholdMs"},
+                              [this]() { applyStallWatchdog(); });
+    configReloader->subscribe("rotation", {"Rotation_*"}, [this]() {
+        rotationEngine->setSeparation(rotationSeparation);
+        rotationEngine->setArtistSeparation(rotationArtistSeparationMin);
+        rotationEngine->setTitleSeparation(rotationTitleSeparationMin);
+    });
+    configReloader->subscribe("crossfade", {"Crossfade_Ms"}, [this]() {
+        playbackEngine->setCrossfadeDuration(crossfadeMs);
+        backTimingRefresh->start();
+    });
+    configReloader->subscribe("prefetch", {"Prefetch_Seconds"},
+                              [this]() { playbackEngine->setPrefetchSeconds(prefetchSeconds); });
+    configReloader->subscribe("on-air output", {"OnAir_Device"}, [this]() {
+        playbackEngine->setOutputDevice(onAirDevice);
+        contributionLink->setOutputDevice(DeckMixer::findOutput(onAirDevice));
+    });
+    configReloader->subscribe("native audio", {"Native_Audio*"}, [this]() { applyNativeAudio(); });
+    configReloader->subscribe("cue output", {"Cue_Device"},
+                              [this]() { playbackEngine->setCueDevice(cueDevice); });
+    configReloader->subscribe("normalization", {"Normalize_Soft"},
+                              [this]() { applyLoudnessNormalization(); });
+    // Records what the setups applied, so the first saved options compare with it
+    updateConfig();
+}
+
+void player::restartBuiltinStream() {
+    // A change of BuiltinStream itself waits for the stream to be started again
+    if (!buttrunning || !builtinStream || !streamOutput->isRunning())
+        return;
+    qInfo() << "Restarting the built-in stream with the new settings";
+    stopBuiltinStream();
+    if (!startBuiltinStream())
+        on_bt_butt_clicked(); // Shows it stopped
+}
+
+void player::setupRetention() {
+    // Old programs go on a low-priority thread, batch by batch, and the
+    // programs table loses their rows in one transaction afterwards
+    archiveRetention = new ArchiveRetention(adb, this);
+    archiveRetention->setInUse([this]() {
+        QStringList inUse = playlistQueue->paths();
+        inUse << waveformTrack;
+        if (schedulerEngine) {
+            const QDateTime now = QDateTime::currentDateTime();
+            const QList<ScheduledEvent> upcoming =
+                schedulerEngine->upcomingEvents(now, now.addDays(RETENTION_SCHEDULE_DAYS));
+            for (const ScheduledEvent& event : upcoming)
+                inUse << event.rule.path;
+        }
+        return inUse;
+    });
+    connect(archiveRetention, &ArchiveRetention::finished, this,
+            [this](const ArchiveRetention::Report& report) {
+                if (report.rows > 0)
+                    programsModel->select();
+            });
+    connect(archiveRetention, &ArchiveRetention::operationError, this,
+            [this](const QString& operation, const QString& error) {
+                eventJournal->record(EventJournal::Type::Error,
+                                     {{"component", "ArchiveRetention"},
+                                      {"operation", operation},
+                                      {"message", error}});
+            });
+
+    retentionTimer = new QTimer(this);
+    connect(retentionTimer, &QTimer::timeout, this, [this]() {
+        retentionTimer->setInterval(RETENTION_INTERVAL_MS);
+        archiveRetention->start();
+    });
+    applyRetention();
+}
+
+void player::applyRetention() {
+    ArchiveRetention::Policy programs;
+    programs.directory = ProgramsPath;
+    programs.maxAgeDays = programsKeepDays;
+    programs.maxCount = programsKeepCount;
+    programs.maxBytes = qint64(programsQuotaGb) * 1024 * 1024 * 1024;
+    programs.table = "programs";
+    archiveRetention->setPolicies({programs});
+
+    if (!programs.isEnabled()) {
+        retentionTimer->stop();
+    } else if (!retentionTimer->isActive()) {
+        retentionTimer->start(RETENTION_FIRST_RUN_MS);
+    }
+}
+
+void player::applyAirCheck() {
+    if (!airCheckEnabled) {
+        if (airCheck->isRunning()) {
+            airCheck->stop();
+            playbackEngine->setTapEnabled(false, DeckMixer::Tap::AirCheck);
         }
-#endif
-    } else {
-        qWarning() << "Check command (" << check_cmd << ") timed out or failed to start.";
-        is_running = false; // Assume not running if check failed
+        return;
+    }
+
+    airCheck->setDirectory(airCheckPath);
+    airCheck->setRetentionDays(airCheckRetentionDays);
+    const int sampleRate = playbackEngine->sampleRate();
+    if (airCheck->isRunning() || sampleRate <= 0)
+        return;
+
+    airCheck->setEncoding("libopus", "opus", airCheckBitrate);
+    airCheck->setSource(
+        [this](float* data, int samples) {
+            return playbackEngine->readTap(data, samples, DeckMixer::Tap::AirCheck);
+        },
+        sampleRate);
+    playbackEngine->setTapEnabled(true, DeckMixer::Tap::AirCheck);
+    if (!airCheck->start()) {
+        playbackEngine->setTapEnabled(false, DeckMixer::Tap::AirCheck);
+        // Not retried on every track; saving the options tries again
+        airCheckEnabled = false;
+        qWarning() << "Air-check recording could not start in" << airCheckPath;
     }
+}
+
+void player::butt_timmer() {
+    if (builtinStream) {
+        // On air as soon as one mount is streaming
+        bool streaming = false;
+        if (streamOutput->isRunning()) {
+            for (const StreamOutput::Mount& mount : streamOutput->mounts()) {
+                if (streamOutput->mountState(mount.path) == IcecastSource::State::Streaming)
+                    streaming = true;
+            }
+        }
 
-    // --- Update UI and state based on the is_running result ---
-    if (is_running) {
-        // Update state if changed
-        if (!buttrunning) {
-            qInfo() << "Butt detected as running (was previously considered stopped).";
+        if (streaming) {
             buttrunning = true;
+            ui->lbl_butt->setText("Running");
+            ui->lbl_butt->setStyleSheet("color:green;");
+        } else if (streamOutput->isRunning()) {
+            ui->lbl_butt->setText("Connecting...");
+            ui->lbl_butt->setStyleSheet("color:orange;");
+        } else {
+            buttrunning = false;
+            ui->lbl_butt->setText("Stopped");
+            ui->lbl_butt->setStyleSheet("color:blue;");
         }
-        // Set UI to "Running" state
+        return;
+    }
+
+    // The supervisor tracks the butt child itself, so this only mirrors its state
+    const ProcessSupervisor::State state =
+        streamSupervisor ? streamSupervisor->state("butt") : ProcessSupervisor::State::Stopped;
+
+    if (state == ProcessSupervisor::State::Running) {
+        buttrunning = true;
         ui->lbl_butt->setText("Running");
         ui->lbl_butt->setStyleSheet("color:green;");
+    } else if (state == ProcessSupervisor::State::Starting) {
+        ui->lbl_butt->setText("Starting...");
+        ui->lbl_butt->setStyleSheet("color:orange;");
+    } else if (state == ProcessSupervisor::State::Backoff) {
+        // Died on its own; the supervisor restarts it after a delay
+        ui->lbl_butt->setText("Restarting...");
+        ui->lbl_butt->setStyleSheet("color:red;");
     } else {
-        // Update state if changed
-        if (buttrunning) {
-            qInfo() << "Butt detected as stopped (was previously considered running).";
-            buttrunning = false;
-        }
-        // Set UI to "Stopped" state
+        buttrunning = false;
         ui->lbl_butt->setText("Stopped");
-        ui->lbl_butt->setStyleSheet("color:red;");
-        // Decide if stopping Butt should affect other UI like bt_takeOver.
-        // Original butt_timmer didn't reset other UI, only ice_timmer did.
-        // Stick to that logic unless intended otherwise.
+        ui->lbl_butt->setStyleSheet("color:blue;");
     }
 }
 
 void player::on_bt_ddns_clicked() {
-    ddnsUpdate();
+    ddnsUpdate(true);
 }
 void player::on_bt_portTest_clicked() {
     // --- Configuration ---
     const quint16 portToCheck = 8888;
     const int connectionTimeoutMs = 5000; // 5 seconds timeout for connection attempt
 
-    // --- Get External IP ---
-    QString externalIpStr = ui->lbl_ddns->text();
-
-    // --- Basic Validation ---
-    if (externalIpStr.isEmpty() || externalIpStr.startsWith("Error")) {
-        QMessageBox::warning(
-            this, tr("Missing IP"),
-            tr("Could not determine the external IP address. Please update DDNS first."));
-        ui->lbl_port->setText("No IP");
-        ui->lbl_port->setStyleSheet("color:orange;");
-        return;
-    }
-    // Optional: More robust IP validation
-    QHostAddress addr(externalIpStr);
-    if (addr.isNull() || addr.protocol() != QAbstractSocket::IPv4Protocol) {
-        qWarning() << "External IP from label is not a valid IPv4 address:" << externalIpStr;
-        // Decide whether to proceed or warn the user further
-        // QMessageBox::warning(this, tr("Invalid IP"), tr("The determined external IP address (%1)
-        // does not appear valid.").arg(externalIpStr)); return; // Uncomment to be stricter
-    }
-
     // --- Start Check ---
-    qInfo() << "Checking external reachability for" << externalIpStr << ":" << portToCheck;
+    // The external IP is looked up first (or taken from the cache), so this no
+    // longer depends on lbl_ddns having been filled in by an earlier lookup
+    qInfo() << "Checking external reachability of port" << portToCheck;
     ui->lbl_port->setText("Checking...");
     ui->lbl_port->setStyleSheet("color:#FBEA23;"); // Yellowish color for checking
-    // Disable button during check to prevent multiple clicks?
-    // ui->bt_portTest->setEnabled(false); // Re-enable in results handling
-
-    // --- Use QTcpSocket for the check ---
-    QTcpSocket* socket = new QTcpSocket(this);
-    QTimer* timeoutTimer = new QTimer(this);
-    timeoutTimer->setSingleShot(true);
-
-    // Lambda to handle cleanup for both success and failure
-    auto cleanup = [socket, timeoutTimer, this]() {
-        // ui->bt_portTest->setEnabled(true); // Re-enable button
-        if (timeoutTimer->isActive()) {
-            timeoutTimer->stop();
-        }
-        // Ensure socket is disconnected before deleting if necessary
-        if (socket->state() != QAbstractSocket::UnconnectedState) {
-            socket->abort(); // Force close immediately
-        }
-        socket->deleteLater();
-        timeoutTimer->deleteLater();
-        qDebug() << "Cleanup after port check complete.";
-    };
 
-    // Connection successful
-    connect(socket, &QTcpSocket::connected, this, [this, externalIpStr, portToCheck, cleanup]() {
-        qInfo() << "Connection successful to" << externalIpStr << ":" << portToCheck;
-        ui->lbl_port->setText("OPEN"); // Simplified from "OPEN IN + OUT"
-        ui->lbl_port->setStyleSheet("color:green;");
+    // A click always probes again; the streaming start-up reuses a fresh result
+    const bool clicked = sender() == ui->bt_portTest;
+    networkMaintenance->probePorts(
+        {portToCheck}, connectionTimeoutMs,
+        [this, portToCheck](const QHostAddress& address,
+                            const QList<NetworkMaintenance::PortResult>& results,
+                            const QString& error) {
+            if (!error.isEmpty() || results.isEmpty()) {
+                QMessageBox::warning(
+                    this, tr("Missing IP"),
+                    tr("Could not determine the external IP address: %1").arg(error));
+                ui->lbl_port->setText("No IP");
+                ui->lbl_port->setStyleSheet("color:orange;");
+                return;
+            }
 
-        // Format the clickable link
-        QString urlString = QString("http://%1:%2/stream.m3u").arg(externalIpStr).arg(portToCheck);
-        QString linkHtml = QString("<a href=\"%1\">%1</a>").arg(urlString);
+            const QString externalIpStr = address.toString();
+            const ReachabilityMonitor::ProbeResult& result = results.first().probe;
+            if (result.reachable) {
+                qInfo() << "Connection successful to" << externalIpStr << ":" << portToCheck << "in"
+                        << result.rttMs << "ms";
+                ui->lbl_port->setText("OPEN"); // Simplified from "OPEN IN + OUT"
+                ui->lbl_port->setStyleSheet("color:green;");
 
-        ui->lbl_streamURL->setText(linkHtml);
-        ui->lbl_streamURL->setTextFormat(Qt::RichText);
-        ui->lbl_streamURL->setTextInteractionFlags(Qt::TextBrowserInteraction);
-        // Note: setOpenExternalLinks(false) is default for QLabel, use true if you want direct
-        // clicking
-        ui->lbl_streamURL->setOpenExternalLinks(true);
+                // Format the clickable link
+                QString urlString =
+                    QString("http://%1:%2/stream.m3u").arg(externalIpStr).arg(portToCheck);
+                QString linkHtml = QString("<a href=\"%1\">%1</a>").arg(urlString);
 
-        ui->bt_takeOver->setEnabled(true);
+                ui->lbl_streamURL->setText(linkHtml);
+                ui->lbl_streamURL->setTextFormat(Qt::RichText);
+                ui->lbl_streamURL->setTextInteractionFlags(Qt::TextBrowserInteraction);
+                ui->lbl_streamURL->setOpenExternalLinks(true);
 
-        cleanup(); // Call cleanup lambda
-    });
+                ui->bt_takeOver->setEnabled(true);
+                return;
+            }
 
-    // Connection error (includes refusal, host not found, etc.)
-    connect(socket, &QTcpSocket::errorOccurred, this,
-            [this, socket, cleanup](QAbstractSocket::SocketError socketError) {
+            if (result.error == QAbstractSocket::SocketTimeoutError) {
+                qWarning() << "Connection attempt timed out.";
+                ui->lbl_port->setText("TIMEOUT");
+                ui->lbl_port->setStyleSheet("color:red;");
+                QMessageBox::warning(
+                    this, tr("Port Check Timed Out"),
+                    tr("Could not connect to the server within the time limit.\n\nCheck if the "
+                       "server is running, the IP address is correct, and the port is "
+                       "open/forwarded. Network latency or firewalls could also be the cause."));
+            } else {
                 QString errorMsg;
-                switch (socketError) {
+                switch (result.error) {
                     case QAbstractSocket::ConnectionRefusedError:
                         errorMsg =
                             tr("Connection Refused: Port is likely closed or not listening.");
                         break;
                     case QAbstractSocket::RemoteHostClosedError:
-                        errorMsg = tr(
-                            "Connection Closed Unexpectedly."); // Less likely during initial check
+                        errorMsg = tr("Connection Closed Unexpectedly.");
                         break;
                     case QAbstractSocket::HostNotFoundError:
                         errorMsg =
                             tr("Host Not Found: The IP address might be incorrect or unreachable.");
                         break;
-                    case QAbstractSocket::SocketTimeoutError: // Should be caught by our timer, but
-                                                              // handle anyway
-                        errorMsg = tr("Connection Timed Out (Socket Error).");
-                        break;
                     case QAbstractSocket::NetworkError:
                         errorMsg = tr("Network Error: Check your connection or firewall.");
                         break;
                     default:
-                        errorMsg = tr("Connection Failed: %1").arg(socket->errorString());
+                        errorMsg = tr("Connection Failed: %1").arg(result.errorString);
                         break;
                 }
-                qWarning() << "Connection error:" << errorMsg << "(" << socketError << ")";
+                qWarning() << "Connection error:" << errorMsg << "(" << result.error << ")";
                 ui->lbl_port->setText("CLOSED/ERROR");
                 ui->lbl_port->setStyleSheet("color:red;");
                 QMessageBox::warning(
@@ -8275,37 +7554,13 @@ void player::on_bt_portTest_clicked() {
                     errorMsg + "\n\n" +
                         tr("Ensure the service (e.g., Icecast) is running locally and the port is "
                            "correctly forwarded in your router/firewall."));
+            }
 
-                ui->lbl_streamURL->setText(tr("N/A")); // Clear stream URL
-                ui->lbl_streamURL->setOpenExternalLinks(false);
-                ui->bt_takeOver->setEnabled(false);
-
-                cleanup(); // Call cleanup lambda
-            });
-
-    // Connection timeout timer
-    connect(timeoutTimer, &QTimer::timeout, this, [this, socket, cleanup]() {
-        qWarning() << "Connection attempt timed out.";
-        ui->lbl_port->setText("TIMEOUT");
-        ui->lbl_port->setStyleSheet("color:red;");
-        QMessageBox::warning(
-            this, tr("Port Check Timed Out"),
-            tr("Could not connect to the server within the time limit.\n\nCheck if the server is "
-               "running, the IP address is correct, and the port is open/forwarded. Network "
-               "latency or firewalls could also be the cause."));
-
-        ui->lbl_streamURL->setText(tr("N/A"));
-        ui->lbl_streamURL->setOpenExternalLinks(false);
-        ui->bt_takeOver->setEnabled(false);
-
-        // Abort the socket connection attempt before cleanup
-        socket->abort();
-        cleanup(); // Call cleanup lambda
-    });
-
-    // --- Initiate Connection ---
-    socket->connectToHost(externalIpStr, portToCheck);
-    timeoutTimer->start(connectionTimeoutMs); // Start the timeout timer
+            ui->lbl_streamURL->setText(tr("N/A")); // Clear stream URL
+            ui->lbl_streamURL->setOpenExternalLinks(false);
+            ui->bt_takeOver->setEnabled(false);
+        },
+        clicked);
 }
 
 void player::deleteFilesByPattern(const QString& dirPath, const QString& pattern) {
@@ -8324,7 +7579,7 @@ void player::deleteFilesByPattern(const QString& dirPath, const QString& pattern
 
     int deletedCount = 0;
     if (filesToDelete.isEmpty()) {
-        qDebug() << "No files matching pattern" << pattern << "found in" << dirPath;
+        qCDebug(xfbPlayer) << "No files matching pattern" << pattern << "found in" << dirPath;
         return;
     }
 
@@ -8333,7 +7588,7 @@ void player::deleteFilesByPattern(const QString& dirPath, const QString& pattern
     for (const QString& filename : filesToDelete) {
         QString filePath = dir.filePath(filename);
         if (QFile::remove(filePath)) {
-            qDebug() << "Deleted:" << filePath;
+            qCDebug(xfbPlayer) << "Deleted:" << filePath;
             deletedCount++;
         } else {
             qWarning() << "Failed to delete:" << filePath;
@@ -8351,6 +7606,7 @@ void player::on_bt_takeOver_clicked() {
         // Currently in takeover mode, user wants to cancel
         qInfo() << "Cancelling Takeover...";
         takeOver = false; // Update state first
+        stopContribution();
 
         // Call the function responsible for reversing the takeover on the server side
         returnTakeOver(); // This likely needs its own robust implementation (maybe another script?)
@@ -8379,7 +7635,7 @@ void player::on_bt_takeOver_clicked() {
     ui->bt_takeOver->setEnabled(false); // Disable button during operation
     ui->bt_takeOver->setText(tr("Processing..."));
     ui->bt_takeOver->setStyleSheet("background-color:yellow;"); // Indicate processing
-    qApp->processEvents();                                      // Update UI immediately
+    ui->bt_takeOver->repaint(); // Show it now, without running other events first
 
     // --- 1. Clean Up Old Files ---
     qInfo() << "Cleaning up previous XML files...";
@@ -8400,6 +7656,10 @@ void player::on_bt_takeOver_clicked() {
         return;
     }
     QString streamUrl = QString("http://%1:8888/stream.m3u").arg(externalIp); // Hardcoded port 8888
+    if (contributionEnabled && ContributionLink::isAvailable())
+        streamUrl = QString("%1://%2:%3")
+                        .arg(QLatin1String(CONTRIBUTION_SCHEME), externalIp)
+                        .arg(contributionPort);
 
     // --- 3. Create Takeover XML ---
     QString takeOverFilePath = QDir(FTPPath).filePath("takeover.xml"); // Create in FTPPath
@@ -8443,15 +7703,10 @@ void player::on_bt_takeOver_clicked() {
     qInfo() << "Takeover XML created successfully.";
 
     // --- 4. Execute Upload Script Asynchronously ---
-    // Determine script path (needs configuration - example assumes it's relative to app dir)
-    // TODO: Replace this with a robust way to find the script (e.g., settings, known install path)
-    QString scriptName = "serverFtpCmdsPutTakeOver.sh";
-    QString scriptDir = QCoreApplication::applicationDirPath() +
-                        "/usr/share/xfb/scripts"; // Example path relative to app binary
-    QString scriptPath = QDir(scriptDir).filePath(scriptName);
+    QString scriptPath = serverScriptPath("serverFtpCmdsPutTakeOver.sh");
 
     qInfo() << "Attempting to execute upload script:" << scriptPath;
-    qDebug()
+    qCDebug(xfbPlayer)
         << "Dependencies: Script must exist, be executable, and ~/.netrc configured correctly.";
 
     if (!QFileInfo::exists(scriptPath)) {
@@ -8470,15 +7725,16 @@ void player::on_bt_takeOver_clicked() {
     // if (!scriptInfo.isExecutable()) { ... error ... }
 
     ui->bt_takeOver->setText(tr("Uploading..."));
-    qApp->processEvents();
+    ui->bt_takeOver->repaint();
 
     QProcess* uploadProcess = new QProcess(this); // Create on heap for async handling
 
     // Connect signals *before* starting
     connect(uploadProcess, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
-            [this, uploadProcess, takeOverFilePath](int exitCode, QProcess::ExitStatus exitStatus) {
-                qDebug() << "Upload script finished. ExitCode:" << exitCode
-                         << "ExitStatus:" << exitStatus;
+            [this, uploadProcess, takeOverFilePath,
+             streamUrl](int exitCode, QProcess::ExitStatus exitStatus) {
+                qCDebug(xfbPlayer) << "Upload script finished. ExitCode:" << exitCode
+                                   << "ExitStatus:" << exitStatus;
 
                 QString stdOutput =
                     QString::fromLocal8Bit(uploadProcess->readAllStandardOutput()).trimmed();
@@ -8488,7 +7744,7 @@ void player::on_bt_takeOver_clicked() {
                 bool success = false;
                 if (exitStatus == QProcess::NormalExit && exitCode == 0) {
                     // Script exited normally, check output for confirmation
-                    qDebug() << "Upload script STDOUT:\n" << stdOutput;
+                    qCDebug(xfbPlayer) << "Upload script STDOUT:\n" << stdOutput;
                     // Make check more robust - case-insensitive contains?
                     if (stdOutput.contains("Transfer complete", Qt::CaseInsensitive)) {
                         qInfo() << "Upload script reported success.";
@@ -8517,6 +7773,8 @@ void player::on_bt_takeOver_clicked() {
                     ui->bt_takeOver->setText(
                         tr("Verifying...")); // Or "Broadcasting (Click to Stop)"
                     takeOver = true;         // Update state only on confirmed success
+                    if (isContributionStream(streamUrl))
+                        startContribution();
 
                     // Clean up local file *after* successful upload
                     if (QFile::remove(takeOverFilePath)) {
@@ -8527,7 +7785,7 @@ void player::on_bt_takeOver_clicked() {
                     }
 
                     // Start the verification check
-                    QTimer::singleShot(5000, this, &player::checkTakeOver);
+                    QTimer::singleShot(TAKEOVER_CHECK_DELAY_MS, this, &player::checkTakeOver);
 
                 } else {
                     // Upload failed or confirmation missing
@@ -8583,328 +7841,143 @@ void player::livePiscaStop() {
 }
 
 void player::checkTakeOver() {
-    qDebug() << "Checking Takeover status asynchronously...";
-
-    // --- Determine Script Path ---
-    // TODO: Replace this with a robust way to find the script
-    QString scriptName = "serverFtpCmdsCHKTakeOver.sh";
-    QString scriptDir =
-        QCoreApplication::applicationDirPath() + "/usr/share/xfb/scripts"; // Example path
-    QString scriptPath = QDir(scriptDir).filePath(scriptName);
-
-    qInfo() << "Attempting to execute check script:" << scriptPath;
-
-    if (!QFileInfo::exists(scriptPath)) {
-        qWarning() << "Check script not found at:" << scriptPath;
-        // Stop checking? Or keep retrying? Let's stop and warn.
-        QMessageBox::critical(
-            this, "Script Error",
-            QString(
-                "The required check script was not found:\n%1\n\nTakeover verification stopped.")
-                .arg(scriptPath));
-        // Reset UI to non-live state? Depends on desired behavior on error.
-        // resetToNonLiveState(); // Call a hypothetical function to reset UI
-        return;
-    }
-    // Optional: Check script executability on Linux/macOS
-
-    // --- Execute Script Asynchronously ---
-    QProcess* checkProcess = new QProcess(this); // Create on heap for async
-
-    // Connection to handle when the process finishes
-    connect(checkProcess, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
-            [this, checkProcess](int exitCode, QProcess::ExitStatus exitStatus) {
-                qDebug() << "Check script finished. ExitCode:" << exitCode
-                         << "ExitStatus:" << exitStatus;
-
-                bool takeoverConfirmed = false;
-                QString stdOutput =
-                    QString::fromLocal8Bit(checkProcess->readAllStandardOutput()).trimmed();
-                QString stdError =
-                    QString::fromLocal8Bit(checkProcess->readAllStandardError()).trimmed();
-
-                if (exitStatus == QProcess::NormalExit && exitCode == 0) {
-                    // Script finished successfully, now check its output
-                    qDebug() << "Check script STDOUT:\n" << stdOutput;
-                    if (stdOutput.contains("confirmtakeover.xml", Qt::CaseInsensitive)) {
-                        // Found the confirmation filename in the output
-                        takeoverConfirmed = true;
-                        qInfo() << "Takeover confirmation found in script output.";
-                    } else {
-                        qInfo() << "Takeover confirmation filename not found in script output.";
-                        // Log stderr just in case it has info
-                        if (!stdError.isEmpty()) {
-                            qWarning() << "Check script STDERR (though exit code was 0):\n"
-                                       << stdError;
-                        }
-                    }
-                } else {
-                    // Script failed to execute properly or returned an error code
-                    qWarning() << "Check script failed or exited with error.";
-                    if (!stdError.isEmpty()) {
-                        qWarning() << "Check script STDERR:\n" << stdError;
-                    } else if (!stdOutput.isEmpty()) {
-                        // Sometimes errors go to stdout
-                        qWarning() << "Check script STDOUT (check for errors):\n" << stdOutput;
-                    }
-                }
-
-                // --- Update UI and State ---
-                if (takeoverConfirmed) {
-                    qInfo() << "      -------------------         [TakeOver CONFIRMED]      "
-                               "---------------------       ";
-                    // Check if already in the live state to avoid redundant updates/starts
-                    if (ui->bt_takeOver->text() != tr("BROADCASTING LIVE!!!")) {
-                        ui->bt_takeOver->setStyleSheet("background-color:green;"); // Use semicolon
-                        ui->bt_takeOver->setText(tr("BROADCASTING LIVE!!!"));
-
-                        ui->txt_ProgramName->setText(tr("BROADCASTING LIVE!!!"));
-                        ui->txt_ProgramName->setStyleSheet(
-                            "background-color:red;color:#FFF;text-align:center "
-                            "!important;font-size:28px;font-weight:bolder;"); // Added semicolon
-                        ui->txt_ProgramName->setAlignment(Qt::AlignHCenter);
-                        ui->txt_ProgramName->show();
-
-                        if (piscaLive == false) {
-                            piscaLive = true;
-                            livePiscaStart(); // Assuming this starts the blinking animation
-                        }
-                    } else {
-                        qDebug() << "Takeover already confirmed, UI state unchanged.";
-                    }
-                    // Successfully confirmed, do NOT schedule another check.
+    qCDebug(xfbPlayer) << "Checking Takeover status asynchronously...";
+
+    // The server renames our takeover.xml to confirmtakeover.xml as soon as
+    // it picks the request up; look for that in its TakeOver folder
+    const QUrl server = QUrl::fromUserInput(Server_URL);
+    const quint16 port = Port > 0 ? static_cast<quint16>(Port) : FtpClient::DEFAULT_PORT;
+    FtpClient* ftp = new FtpClient(this);
+    ftp->connectToHost(server.host(), port, User, Pass, nullptr);
+    ftp->changeDirectory("TakeOver", nullptr);
+    ftp->list([this, ftp](bool ok, const QList<FtpClient::RemoteFile>& files, const QString& error) {
+        if (ftp->isConnected()) {
+            connect(ftp, &FtpClient::disconnected, ftp, &QObject::deleteLater);
+            ftp->quit();
+        } else {
+            ftp->deleteLater();
+        }
 
-                } else {
-                    // Takeover not confirmed, schedule retry
-                    qWarning() << "      -------------------         [Takeover Check FAILED]       "
-                                  "  ---------------------       ";
-                    qWarning() << "      -------------------     [Scheduling retry in 10 sec]     "
-                                  "---------------------";
-
-                    // Optional: Update UI to show "Verification Failed" or similar temporarily?
-                    // ui->bt_takeOver->setText(tr("Verification Failed"));
-                    // ui->bt_takeOver->setStyleSheet("background-color:orange;"); // Indicate
-                    // temporary failure?
-
-                    QTimer::singleShot(10000, this, &player::checkTakeOver); // Schedule retry
+        bool takeoverConfirmed = false;
+        if (!ok) {
+            qWarning() << "Could not list the server's TakeOver folder:" << error;
+        } else {
+            takeoverConfirmed = std::any_of(files.cbegin(), files.cend(), [](const FtpClient::RemoteFile& file) {
+                return file.name.compare("confirmtakeover.xml", Qt::CaseInsensitive) == 0;
+            });
+            if (takeoverConfirmed)
+                qInfo() << "Takeover confirmation found on the server.";
+            else
+                qInfo() << "Takeover confirmation not on the server yet.";
+        }
+
+        // --- Update UI and State ---
+        if (takeoverConfirmed) {
+            qInfo() << "      -------------------         [TakeOver CONFIRMED]      "
+                       "---------------------       ";
+            // Check if already in the live state to avoid redundant updates/starts
+            if (ui->bt_takeOver->text() != tr("BROADCASTING LIVE!!!")) {
+                ui->bt_takeOver->setStyleSheet("background-color:green;"); // Use semicolon
+                ui->bt_takeOver->setText(tr("BROADCASTING LIVE!!!"));
+
+                ui->txt_ProgramName->setText(tr("BROADCASTING LIVE!!!"));
+                ui->txt_ProgramName->setStyleSheet(
+                    "background-color:red;color:#FFF;text-align:center "
+                    "!important;font-size:28px;font-weight:bolder;"); // Added semicolon
+                ui->txt_ProgramName->setAlignment(Qt::AlignHCenter);
+                ui->txt_ProgramName->show();
+
+                if (piscaLive == false) {
+                    piscaLive = true;
+                    livePiscaStart(); // Assuming this starts the blinking animation
                 }
+            } else {
+                qCDebug(xfbPlayer) << "Takeover already confirmed, UI state unchanged.";
+            }
+            // Successfully confirmed, do NOT schedule another check.
 
-                // Cleanup the process object
-                checkProcess->deleteLater();
-            });
+        } else {
+            // Takeover not confirmed, schedule retry
+            qWarning() << "      -------------------         [Takeover Check FAILED]       "
+                          "  ---------------------       ";
+            qWarning() << "      -------------------     [Scheduling retry]     "
+                          "---------------------";
 
-    // Connection to handle process startup errors
-    connect(checkProcess, &QProcess::errorOccurred, this,
-            [this, checkProcess, scriptPath](QProcess::ProcessError error) {
-                qWarning() << "Failed to start check script (" << scriptPath << "). Error:" << error
-                           << "-" << checkProcess->errorString();
-
-                // Decide how to handle startup failure. Retry? Show critical error?
-                qWarning() << "      -------------------         [Takeover Check FAILED - Could "
-                              "not start script]         ---------------------       ";
-                qWarning() << "      -------------------     [Scheduling retry in 10 sec]     "
-                              "---------------------";
-
-                // Optional: Update UI to show error state
-                // ui->bt_takeOver->setText(tr("Check Script Error"));
-                // ui->bt_takeOver->setStyleSheet("background-color:purple;");
-
-                QTimer::singleShot(10000, this,
-                                   &player::checkTakeOver); // Schedule retry even on startup error
-                checkProcess->deleteLater();                // Cleanup
-            });
+            // Optional: Update UI to show "Verification Failed" or similar temporarily?
+            // ui->bt_takeOver->setText(tr("Verification Failed"));
+            // ui->bt_takeOver->setStyleSheet("background-color:orange;"); // Indicate
+            // temporary failure?
 
-    // --- Start the Check ---
-    // Execute the script directly, do not pipe to grep here
-    checkProcess->start(scriptPath);
+            QTimer::singleShot(TAKEOVER_CHECK_RETRY_MS, this, &player::checkTakeOver);
+        }
+    });
 }
-void player::MainsetVol100() {
-    XplayerOutput->setVolume(1.0); // Qt6 uses 0.0-1.0 range for volume
+void player::MainFadeIn() {
+    // The engine fades on the audio thread, so the fade is smooth and click-free
+    playbackEngine->fadeVolume(1.0f, MAIN_FADE_MS, 0.05f);
 }
 
-void player::MainsetVol80() {
-    XplayerOutput->setVolume(0.8); // Qt6 uses 0.0-1.0 range for volume
-}
-void player::MainsetVol60() {
-    XplayerOutput->setVolume(0.6); // Qt6 uses 0.0-1.0 range for volume
-}
-void player::MainsetVol40() {
-    XplayerOutput->setVolume(0.4); // Qt6 uses 0.0-1.0 range for volume
-}
-void player::MainsetVol20() {
-    XplayerOutput->setVolume(0.2); // Qt6 uses 0.0-1.0 range for volume
-}
-void player::MainsetVol10() {
-    XplayerOutput->setVolume(0.1); // Qt6 uses 0.0-1.0 range for volume
-}
-void player::MainsetVol5() {
-    XplayerOutput->setVolume(0.05); // Qt6 uses 0.0-1.0 range for volume
+void player::MainFadeOut() {
+    playbackEngine->fadeVolume(0.05f, MAIN_FADE_MS, 1.0f);
 }
 void player::MainStop() {
-    Xplayer->stop();
+    requeueQueuedTrack();
+    playbackEngine->stop();
     ui->btPlay->setStyleSheet("");
     ui->btPlay->setText(tr("Play"));
     PlayMode = "stopped";
 }
 
-bool player::killProcessByName(const QString& processName) {
-    QProcess killer;
-    QString cmd;
-    QStringList args;
-    bool success = false;
-
-#ifdef Q_OS_WIN
-    // Windows: Use taskkill
-    cmd = "taskkill";
-    args << "/F"
-         << "/IM" << processName + "*";
-    qWarning() << "Windows taskkill pattern matching is basic. Ensure '" << processName
-               << "*' matches correctly, or use exact name.";
-#else
-    // Unix-like (Linux, macOS): Prefer pkill
-    cmd = "pkill";
-    args << "-f" << processName; // -f matches against the entire command line
-#endif
+void player::killProcessByName(const QString& processName, std::function<void(bool)> done) {
+    // pkill/taskkill runs as an asynchronous child; done is called once it has
+    processShutdown->killByName(processName, [processName, done](bool success) {
+        if (success)
+            qInfo() << "Kill command executed successfully for" << processName;
+        else
+            qCDebug(xfbPlayer) << "Kill command for" << processName << "matched nothing or failed.";
+        if (done)
+            done(success);
+    });
+}
 
-    qInfo() << "Attempting to kill processes matching:" << processName << "using command:" << cmd
-            << args;
-    killer.start(cmd, args);
-    if (killer.waitForFinished(3000)) { // Wait up to 3 seconds
-        if (killer.exitStatus() == QProcess::NormalExit && killer.exitCode() == 0) {
-            qInfo() << "Kill command executed successfully for" << processName
-                    << "(process may or may not have been running).";
-            success = true;
-        } else {
-            qWarning() << "Kill command for" << processName
-                       << "failed or reported an error. Exit code:" << killer.exitCode()
-                       << "Status:" << killer.exitStatus();
-        }
-    } else {
-        qWarning() << "Kill command for" << processName << "timed out.";
-        killer.kill();
-        killer.waitForFinished(500);
-    }
-    return success;
+void player::updateFailoverStandby() {
+    failoverStandby->setStandbySource(playlistQueue->path(0));
 }
 
 void player::pingTakeOverClient() {
     if (takeOverIP.isEmpty()) {
         qWarning() << "Cannot ping TakeOver Client: takeOverIP is empty.";
-        // Optionally trigger the failure actions immediately? Or just return?
-        // triggerPingFailureActions(); // Call a helper containing the failure steps
         return;
     }
+    // The link reports a silent client itself
+    if (isContributionStream(takeOverStream))
+        return;
 
-    qInfo() << "Pinging TakeOver Client asynchronously ->| " << takeOverIP;
-
-    // --- Prepare Ping Command (Platform Specific) ---
-    QProcess* pingProcess = new QProcess(this); // Create on heap for async handling
-    QString pingCmd;
-    QStringList pingArgs;
-    int timeoutMs = 5000; // Timeout for the ping command itself (e.g., 5 seconds) - was 8s wait
-
-#ifdef Q_OS_WIN
-    pingCmd = "ping";
-    // -n 1: Send 1 echo request
-    // -w timeout: Wait 'timeout' milliseconds for reply (use slightly less than waitForFinished
-    // timeout)
-    pingArgs << "-n"
-             << "1"
-             << "-w" << QString::number(timeoutMs - 500) << takeOverIP;
-#elif defined(Q_OS_MACOS)
-    pingCmd = "ping";
-    // -c 1: Send 1 echo request
-    // -t timeout: Specify timeout in seconds for the command
-    pingArgs << "-c"
-             << "1"
-             << "-t" << QString::number(timeoutMs / 1000) << takeOverIP;
-#else // Linux and other Unix-like
-    pingCmd = "ping";
-    // -c 1: Send 1 echo request
-    // -W timeout: Wait 'timeout' seconds for a reply
-    // -q: Quiet output (optional, we only care about exit code)
-    pingArgs << "-c"
-             << "1"
-             << "-W" << QString::number(timeoutMs / 1000) << "-q" << takeOverIP;
-#endif
-
-    qDebug() << "Executing ping command:" << pingCmd << pingArgs;
-
-    // --- Connect Signals BEFORE Starting ---
-
-    // Handle process finished
-    connect(pingProcess, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
-            [this, pingProcess](int exitCode, QProcess::ExitStatus exitStatus) {
-                qDebug() << "Ping process finished. ExitCode:" << exitCode
-                         << "ExitStatus:" << exitStatus;
-
-                bool success = false;
-                if (exitStatus == QProcess::NormalExit && exitCode == 0) {
-                    // Exit code 0 typically means success (at least one reply received)
-                    success = true;
-                } else {
-                    // Non-zero exit code or crash indicates failure
-                    qWarning() << "Ping command failed or host unreachable.";
-                    // Read stderr/stdout for potential clues (optional)
-                    // QString stdErr = QString::fromLocal8Bit(pingProcess->readAllStandardError());
-                    // if (!stdErr.isEmpty()) qDebug() << "Ping STDERR:" << stdErr;
-                    // QString stdOut =
-                    // QString::fromLocal8Bit(pingProcess->readAllStandardOutput()); if
-                    // (!stdOut.isEmpty()) qDebug() << "Ping STDOUT:" << stdOut;
-                }
-
-                // --- Take Action Based on Result ---
-                if (success) {
-                    qInfo() << "TakeOver Client pinged OK!! |<- " << takeOverIP;
-                    // No further action needed on success according to original logic
-                } else {
-                    qWarning() << "ERROR pinging TakeOver Client!! Taking recovery actions...";
-                    triggerPingFailureActions(); // Encapsulate failure actions in a helper
-                }
-
-                // Cleanup
-                pingProcess->deleteLater();
-            });
-
-    // Handle process startup errors
-    connect(pingProcess, &QProcess::errorOccurred, this,
-            [this, pingProcess](QProcess::ProcessError error) {
-                qWarning() << "Failed to start ping process for" << takeOverIP
-                           << ". Error:" << error << "-" << pingProcess->errorString();
-                qWarning() << "Treating as ping failure and taking recovery actions...";
-
-                triggerPingFailureActions(); // Trigger failure actions if ping command itself fails
-
-                // Cleanup
-                pingProcess->deleteLater();
-            });
-
-    // --- Start the Ping ---
-    pingProcess->start(pingCmd, pingArgs);
-    // We don't use waitForFinished here, rely on signals
+    // Probe the client's stream server rather than shelling out to ping; an
+    // outage is reported once, through the monitor's statusChanged signal
+    const quint16 port = static_cast<quint16>(QUrl(takeOverStream).port(TAKEOVER_STREAM_PORT));
+    qInfo() << "Monitoring TakeOver Client ->| " << takeOverIP << ":" << port;
+    reachability->addTarget("takeover", takeOverIP, port);
+    reachability->start("takeover");
 }
 
 // --- Helper Function for Failure Actions ---
 // Encapsulating these makes the main logic cleaner
 void player::triggerPingFailureActions() {
     qWarning() << "Killing all streams (mplayer) and starting local playback...";
+    failoverStandby->beginFailover();
 
     // Stop mplayer using the robust helper
     killProcessByName("mplayer");
+    contributionLink->setPlayout(false);
 
-    // Start local playback
-    on_btPlay_clicked(); // Assuming this starts the local player
+    // Start local playback from the standby; Play on a running player would
+    // only switch it to stop after the current track
+    if (PlayMode == "stopped")
+        on_btPlay_clicked();
 
-    // Schedule volume fade-in (Original logic)
-    // Consider if these delays/steps are still appropriate
-    QTimer::singleShot(3500, this, &player::MainsetVol100);
-    QTimer::singleShot(3000, this, &player::MainsetVol80);
-    QTimer::singleShot(2500, this, &player::MainsetVol60);
-    QTimer::singleShot(2000, this, &player::MainsetVol40);
-    QTimer::singleShot(1500, this, &player::MainsetVol20);
-    QTimer::singleShot(1000, this, &player::MainsetVol10);
-    QTimer::singleShot(500, this,
-                       &player::MainsetVol5); // Note: Original code didn't have 0? Start low.
+    // Fade the local playback in over the three seconds after it starts
+    QTimer::singleShot(500, this, &player::MainFadeIn);
 
     // Schedule recovery attempt
     qInfo() << "Scheduling recovery stream attempt in 30 seconds.";
@@ -8918,6 +7991,18 @@ void player::recoveryStreamTakeOverPlay() {
     qInfo() << "Stopping any existing mplayer instance...";
     stopMplayer(); // Call the assumed function to stop the player
 
+    // The link is still listening; it goes back on air once the client is heard again
+    if (isContributionStream(takeOverStream)) {
+        if (!contributionOnAir)
+            return;
+        if (contributionLink->isReceiving()) {
+            contributionLink->setPlayout(true);
+        } else {
+            QTimer::singleShot(30000, this, &player::recoveryStreamTakeOverPlay);
+        }
+        return;
+    }
+
     // --- 2. Validate Stream URL/Path ---
     if (takeOverStream.isEmpty()) {
         qWarning() << "Cannot start recovery stream: takeOverStream variable is empty.";
@@ -8957,7 +8042,7 @@ void player::recoveryStreamTakeOverPlay() {
                 << "100"; // Start at full volume? Or maybe lower and fade in?
     mplayerArgs << "-playlist" << takeOverStream; // Add playlist/URL last
 
-    qDebug() << "Executing:" << mplayerPath << mplayerArgs;
+    qCDebug(xfbPlayer) << "Executing:" << mplayerPath << mplayerArgs;
 
     // Disconnect any previous signal connections from the 'radio1' process object
     // to avoid duplicate handlers if this function is called again rapidly.
@@ -8992,6 +8077,10 @@ void player::recoveryStreamTakeOverPlay() {
     // Start the process
     radio1.start(mplayerPath, mplayerArgs);
 
+    // Probe the client afresh: if it is still down, the failover runs again
+    if (reachability->isMonitoring("takeover"))
+        reachability->start("takeover");
+
     // Close communication channels *after* starting if not needed (as per original)
     // Note: Keeping stderr open can be useful for debugging mplayer errors.
     radio1.closeReadChannel(QProcess::StandardOutput);
@@ -9003,25 +8092,14 @@ void player::recoveryStreamTakeOverPlay() {
     ui->txtNowPlaying->setText(
         QString("RECOVERY: %1").arg(takeOverStream)); // Add prefix for clarity
 
-    QDateTime now = QDateTime::currentDateTime();
-    QString text = now.toString("yyyy-MM-dd || hh:mm:ss ||");
     // Add context to history entry
-    QString historyNewLine = text + " RECOVERY STARTED - " + takeOverStream;
-    ui->historyList->addItem(historyNewLine);
+    historyModel->append(QDateTime::currentDateTime(), "RECOVERY STARTED - " + takeOverStream);
     ui->historyList->scrollToBottom(); // Ensure latest entry is visible
 
     // --- 6. Stop the Main Local Player (Delayed Fade) ---
-    // This logic assumes MainsetVol/MainStop control a *different* player/UI element
+    // This logic assumes MainFadeOut/MainStop control a *different* player/UI element
     qInfo() << "Scheduling fade-out and stop for the main local player...";
-    QTimer::singleShot(
-        500, this,
-        &player::MainsetVol100); // Start fade from 100? Or 0? This sequence looks like fade *out*.
-    QTimer::singleShot(1000, this, &player::MainsetVol80);
-    QTimer::singleShot(1500, this, &player::MainsetVol60);
-    QTimer::singleShot(2000, this, &player::MainsetVol40);
-    QTimer::singleShot(2500, this, &player::MainsetVol20);
-    QTimer::singleShot(3000, this, &player::MainsetVol10);
-    QTimer::singleShot(3500, this, &player::MainsetVol5);
+    QTimer::singleShot(500, this, &player::MainFadeOut);
     QTimer::singleShot(4000, this, &player::MainStop); // Final stop
 }
 void player::on_bt_pause_rec_clicked() {
@@ -9029,34 +8107,42 @@ void player::on_bt_pause_rec_clicked() {
         recPause = true;
         ui->bt_pause_rec->setStyleSheet("background-color:yellow");
 
-        audioRecorder->pause();
+        recorder->setPaused(true);
         recTimer->stop();
 
     } else {
         recPause = false;
         ui->bt_pause_rec->setStyleSheet("");
-        audioRecorder->record();
+        recorder->setPaused(false);
         recTimer->start();
     }
 }
 
 void player::on_bt_pause_play_clicked() {
-    if (Xplayer->playbackState() == QMediaPlayer::PlayingState) {
-        Xplayer->pause();
+    if (playbackEngine->state() == PlaybackEngine::State::Playing) {
+        playbackEngine->pause();
         ui->bt_pause_play->setStyleSheet("background-color:yellow");
         playPause = true; // Sync legacy boolean
     } else {
-        Xplayer->play();
+        playbackEngine->resume();
         ui->bt_pause_play->setStyleSheet("");
         playPause = false; // Sync legacy boolean
     }
 }
 
 void player::refreshAdBanner() {
-    if (adBanner && adBanner->rootObject()) {
-        // Call the QML function to reload the ad
-        QMetaObject::invokeMethod(adBanner->rootObject(), "loadAd");
+    if (!adBanner || !adBanner->rootObject())
+        return;
+    // The banner is the least important thing on screen; it waits for the
+    // broadcast, and for the window to be seen at all
+    if (BackgroundThrottle::level() != BackgroundThrottle::Level::Full || !adBanner->isVisible()
+        || isMinimized()) {
+        adRefreshPending = true;
+        return;
     }
+    adRefreshPending = false;
+    // Queued, so the reload runs after the events already waiting
+    QMetaObject::invokeMethod(adBanner->rootObject(), "loadAd", Qt::QueuedConnection);
 }
 
 // UI accessor methods for controllers
@@ -9086,13 +8172,14 @@ void player::on_sliderProgress_sliderPressed() {
 
 void player::on_sliderProgress_sliderReleased() {
     isDraggingProgress = false;
-    Xplayer->setPosition(ui->sliderProgress->value());
+    playbackEngine->setPosition(ui->sliderProgress->value());
 }
 
 void player::on_bt_stop_next_clicked() {
     if (PlayMode != "stopped") {
         PlayMode = "Playing_StopAtNextOne";
         ui->btPlay->setText(tr("Play and Stop"));
+        requeueQueuedTrack(); // Don't segue into an already queued item
 
         // Visual feedback
         if (darkMode) {
@@ -9101,6 +8188,6 @@ void player::on_bt_stop_next_clicked() {
             ui->bt_stop_next->setStyleSheet("background-color:#F0DB1B; color: black;");
         }
 
-        qDebug() << "Stop Next activated via dedicated button";
+        qCDebug(xfbPlayback) << "Stop Next activated via dedicated button";
     }
 }
\ No newline at end of file
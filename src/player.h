@@ -6,7 +6,9 @@
 // QMediaPlaylist replaced with QList<QUrl>
 #include <QByteArray>
 #include <QComboBox>
+#include <QDateTime>
 #include <QFrame>
+#include <QFuture>
 #include <QLabel>
 #include <QMainWindow>
 #include <QMediaFormat>
@@ -20,16 +22,91 @@
 #include <QTime>
 #include <QUrl>
 #include <QWidget>
-#include <QtMultimedia/QMediaRecorder>
+#include <QtMultimedia/QMediaFormat>
 #include <QtQuickWidgets/QQuickWidget>
 #include <QtSql>
 #include <QtWebEngineQuick/QtWebEngineQuick>
 // Qt6 multimedia includes
-#include <QMediaCaptureSession>
-#include <QtMultimedia/QAudioInput>
 #include <QtMultimedia/QAudioOutput>
 #include <QtMultimedia/QMediaDevices>
 
+class AdBreakPacker;
+class AnalysisPipeline;
+class ArchiveRetention;
+class AirCheckRecorder;
+class AudioDeviceRegistry;
+class BackTimer;
+class BackgroundOperationFeedback;
+class BackgroundThrottle;
+class BroadcastWorker;
+class BulkTrackOperations;
+class CartWall;
+class ConfigReloader;
+class ContentHashScanner;
+class ContributionLink;
+class CuePointStore;
+class DatabaseOptimizer;
+class DeadAirDetector;
+class DownloadQueue;
+class DurationCache;
+class EnhancedAddDirectoryDialog;
+class EventJournal;
+class FailoverStandby;
+class FtpSyncEngine;
+class HistoryListModel;
+class HourGenreSchedule;
+class IcecastMetadata;
+class LibraryChecker;
+class LibraryReplica;
+class LibraryRescanner;
+class LibrarySnapshotStore;
+class LibraryWatcher;
+class LiveCapture;
+class LiveTableModel;
+class LoudnessScanner;
+class MaintenanceScheduler;
+class MediaCache;
+class MediaInfoLoader;
+class MetricsServer;
+class MicDucker;
+class MusicCache;
+class MusicRepository;
+class NowPlayingStatus;
+class NetworkMaintenance;
+class PeakFileGenerator;
+class PlayHistoryWriter;
+class PlaybackEngine;
+class PlaylistQueueModel;
+class PlaylistValidator;
+class ProcessSupervisor;
+class ProgramBuilder;
+class ProgressIndicatorWidget;
+class QmlHttpCache;
+class QueueJournal;
+class ReachabilityMonitor;
+class RemoteControlServer;
+class ReplayGainStore;
+class RotationEngine;
+class SchedulerEngine;
+class SearchController;
+class SegmentRecorder;
+class ServerPresenceCache;
+class ShutdownCoordinator;
+class StallWatchdog;
+class StartupProfiler;
+class SilenceScanner;
+class SpotPool;
+class StreamOutput;
+class StreamingExporter;
+class TaskRunner;
+class TranscodeCache;
+class TranscodeEngine;
+class TransferQueue;
+class WaveformWidget;
+class add_music_single;
+class optionsDialog;
+struct ScheduledEvent;
+
 namespace Ui {
 class player;
 }
@@ -41,7 +118,6 @@ class player : public QMainWindow {
   public:
     explicit player(QWidget* parent = 0);
     ~player();
-    int onAbout2Finish;
     QSqlDatabase adb;
     QString saveFile;
     QTimer* recTimer = nullptr; // Will be initialized in constructor
@@ -80,9 +156,12 @@ class player : public QMainWindow {
     void on_btStop_clicked();
     // Update these method signatures to work with Qt6
     void onPositionChanged(qint64 position);
+    void refreshPositionDisplay(qint64 position);
+    void refreshTimeDisplay();
     void durationChanged(qint64 position);
-    void currentMediaChanged(const QUrl& content); // Changed from QMediaContent
-    void volumeChanged(int volume);
+    void onEngineTrackStarted(const QString& filePath);
+    void onEngineNextTrackRequested();
+    void onEnginePlaybackFinished();
     void lp1_onPositionChanged(qint64 position);
     void lp1_durationChanged(qint64 position);
     void lp1_currentMediaChanged(const QUrl& content); // Changed from QMediaContent
@@ -93,8 +172,6 @@ class player : public QMainWindow {
     void lp2_volumeChanged(int volume);
 
     // Add new methods for playlist management
-    void playNextMedia();     // New method to handle playlist progression
-    void playPreviousMedia(); // New method to handle playlist progression
     void playlistAboutToFinish();
     void playNextSong();
     void showTime();
@@ -107,6 +184,7 @@ class player : public QMainWindow {
     void dragEnterEvent(QDragEnterEvent*);
     void on_musicView_pressed(const QModelIndex& index);
     void on_jinglesView_pressed(const QModelIndex& index);
+    void on_jinglesView_activated(const QModelIndex& index);
     void on_pubView_pressed(const QModelIndex& index);
     void on_programsView_pressed(const QModelIndex& index);
     void autoModeGetMoreSongs();
@@ -117,18 +195,17 @@ class player : public QMainWindow {
     void on_actionManage_Genres_triggered();
     void on_actionAdd_Jingle_triggered();
     void on_actionAdd_a_publicity_triggered();
-    void run_scheduler();
+    void onScheduledEvent(const ScheduledEvent& event);
     void on_actionOptions_triggered();
     void on_actionAbout_triggered();
     void on_actionAdd_a_song_from_Youtube_or_Other_triggered();
     void on_bt_search_clicked();
     void on_bt_reset_clicked();
     void on_bt_apply_filter_clicked();
-    void on_bt_updateTables_clicked();
     void on_actionSave_Playlist_triggered();
     void on_actionClear_Playlist_triggered();
     void on_actionLoad_Playlist_triggered();
-    void run_server_scheduler();
+    void on_actionGenerate_Day_Log_triggered();
     void on_bt_rec_clicked();
     void on_actionRecord_a_new_Program_triggered();
     void on_bt_ProgramStopandProcess_clicked();
@@ -163,6 +240,12 @@ class player : public QMainWindow {
     void on_bt_sndconv_clicked();
     void
     on_actionAutoTrim_the_silence_from_the_start_and_the_end_of_all_music_tracks_in_the_database_triggered();
+    void on_actionAnalyze_the_loudness_of_all_music_tracks_in_the_database_triggered();
+    void on_actionAnalyze_all_music_tracks_in_the_database_triggered();
+    void on_actionFind_duplicate_tracks_in_the_database_triggered();
+    void on_actionRescan_the_library_folders_triggered();
+    void on_actionExport_the_library_triggered();
+    void on_actionExport_the_play_history_triggered();
     void on_actionUpdate_System_triggered();
     void on_bt_apply_multi_selection_clicked();
     void on_actionConvert_all_musics_in_the_database_to_mp3_triggered();
@@ -173,11 +256,12 @@ class player : public QMainWindow {
     void streaming_timmer();
     void on_bt_stop_streaming_clicked();
     void on_txt_search_returnPressed();
+    void on_txt_search_textEdited(const QString& text);
     void server_check_and_schedule_new_programs();
     void on_actionForce_monitorization_triggered();
     void on_actionUpdate_Dinamic_Server_s_IP_triggered();
     void on_bt_add_some_random_songs_from_genre_clicked();
-    void ddnsUpdate();
+    void ddnsUpdate(bool forceRefresh = false);
     void ice_timmer();
     void butt_timmer();
     void on_bt_icecast_clicked();
@@ -185,37 +269,43 @@ class player : public QMainWindow {
     void on_bt_ddns_clicked();
     void on_bt_portTest_clicked();
     void on_bt_takeOver_clicked();
-    void MainsetVol100();
-    void MainsetVol80();
-    void MainsetVol60();
-    void MainsetVol40();
-    void MainsetVol20();
-    void MainsetVol10();
-    void MainsetVol5();
+    void MainFadeIn();
+    void MainFadeOut();
     void MainStop();
     void pingTakeOverClient();
+    void updateFailoverStandby();
     void recoveryStreamTakeOverPlay();
     void checkTakeOver();
     void livePiscaStart();
     void livePiscaStop();
-    void rmConfirmTakeOver();
     void returnTakeOver();
     void stopMplayer();
-    void monitorTakeOver();
+    void startTakeOver(const QString& ip, const QString& stream);
+    void endTakeOver(const QString& ip, const QString& command);
     void on_bt_pause_rec_clicked();
     void deleteFilesByPattern(const QString& dirPath, const QString& pattern);
     void on_bt_pause_play_clicked();
     void triggerPingFailureActions();
-    bool killProcessByName(const QString& processName);
 
     // Accessibility initialization
     void initializeAccessibility();
 
+  protected:
+    void showEvent(QShowEvent* event) override;
+
   private:
     Ui::player* ui;
-    QMediaPlayer* Xplayer;
-    QList<QUrl> XplaylistUrls; // Store URLs instead of using QMediaPlaylist
-    int XplaylistIndex = 0;    // Track current index
+    PlaybackEngine* playbackEngine = nullptr; // On-air dual-deck engine
+    int crossfadeMs = 3000;
+    int prefetchSeconds = 20;
+    QString onAirDevice;  // Program output, by id or description; empty for the default
+    QString cueDevice;    // Pre-listen output, usually the headphones
+    bool nativeAudioEnabled = false;  // ALSA periods of our own instead of Qt's sink
+    QString nativeAudioDevice;
+    int nativeAudioPeriodFrames = 256;
+    int nativeAudioPeriods = 2;
+
+    void requeueQueuedTrack();
 
     QMediaPlayer* lp1_Xplayer;
     QList<QUrl> lp1_XplaylistUrls; // Store URLs for LP1
@@ -225,23 +315,81 @@ class player : public QMainWindow {
     QList<QUrl> lp2_XplaylistUrls; // Store URLs for LP2
     int lp2_XplaylistIndex = 0;    // Track current index
 
-    QAudioOutput* XplayerOutput;
     QAudioOutput* lp1_XplayerOutput;
     QAudioOutput* lp2_XplayerOutput;
 
-    // Media recording components
-    QMediaCaptureSession* captureSession;
-    QMediaRecorder* audioRecorder;
-    QAudioInput* audioInput;
+    // Records shows to crash-safe segment files
+    SegmentRecorder* recorder = nullptr;
+    // The one capture of the input; the recorder and a live stream read from it
+    LiveCapture* liveCapture = nullptr;
+    AudioDeviceRegistry* audioDevices = nullptr;  // Looked up when recording starts
+    int recordReader = -1;
+    int streamReader = -1;
+    int contributionReader = -1;
+    // Alarm for silence on the output and the live input
+    DeadAirDetector* deadAirDetector = nullptr;
+    int deadAirSeconds = 10;                        // 0 turns the alarm off
+    double deadAirThresholdDb = -50.0;
+    QString deadAirAction;                          // "alert", "next" or "recovery"
+    void applyDeadAir();
+    // Turns the decks down while the live input is heard
+    MicDucker* micDucker = nullptr;
+    bool duckMusic = false;
+    double duckThresholdDb = -40.0;
+    double duckDepthDb = -12.0;
+    int duckAttackMs = 50;
+    int duckReleaseMs = 800;
+    void applyDucking();
+    // Prometheus/JSON endpoint of MetricsRegistry; MetricsPort 0 keeps it closed
+    MetricsServer* metricsServer = nullptr;
+    int metricsPort = 0;
+    void setupMetrics();
+    void applyMetrics();
+    // Memory of each subsystem against a soft budget, see MemoryBudget
+    static constexpr qint64 MODELS_MEMORY_BUDGET = 64 * 1024 * 1024;
+    static constexpr qint64 AUDIO_BUFFERS_MEMORY_BUDGET = 48 * 1024 * 1024;
+    static constexpr qint64 SQLITE_MEMORY_BUDGET = 32 * 1024 * 1024;
+    void setupMemoryBudget();
+    // REST and WebSocket API for remote panels; RemotePort 0 keeps it closed
+    RemoteControlServer* remoteControl = nullptr;
+    int remotePort = 0;
+    QString remoteToken;                            // Required from clients when set
+    void setupRemoteControl();
+    void applyRemoteControl();
+    // Library shared between studios: LibraryFeed serves this studio's
+    // changes on the remote API, LibraryPrimary follows another studio's
+    LibraryReplica* libraryReplica = nullptr;
+    bool libraryFeed = false;
+    QString libraryPrimary;                         // http://host:RemotePort of the primary
+    QString libraryPrimaryToken;
+    QString libraryPathFrom;                        // Prefix of the primary's paths...
+    QString libraryPathTo;                          // ...and of the same files here
+    void setupLibrarySync();
+    void applyLibrarySync();
+    void publishTransport();
+    void publishQueue();
+    void publishSchedule();
+    QString traceDirectory() const;                 // Where dead-air traces are saved
+    // Logs what the GUI thread was doing whenever it freezes
+    StallWatchdog* stallWatchdog = nullptr;
+    int stallThresholdMs = 500;                     // 0 turns the watchdog off
+    void applyStallWatchdog();
+    // Times the phases of start-up; gone once the deferred phase has run
+    StartupProfiler* startupProfiler = nullptr;
+    bool startupFinished = false;
+    void setupTableModels();                        // Also run lazily by the library searches
+    void finishStartup();                           // After the first paint
 
     // Google Ads banner webview
-    QQuickWidget* adBanner;
+    QQuickWidget* adBanner = nullptr;
+    QmlHttpCache* adBannerCache = nullptr;  // Disk cache of adBanner's engine; not owned by it
+    bool adRefreshPending = false;          // Refresh waiting for the throttle to return to Full
 
     int indexcanal;
-    qint64 trackTotalDuration;
+    qint64 trackTotalDuration = 0;
     int autoMode, recMode, indexJust3rdDropEvt, lastTrackPercentage, Port, tmpFullScreen;
     QString aExtencaoDesteCoiso, txt_selected_db, ask_normalize_new_files, estevalor, xaction, text,
-        txtDuration, lastPlayedSong, Role, recDevice, SavePath, NomeDestePrograma, ProgramsPath,
+        lastPlayedSong, Role, recDevice, SavePath, NomeDestePrograma, ProgramsPath,
         MusicPath, JinglePath, Server_URL, User, Pass, destinationProgram, FTPPath, TakeOverPath,
         PlayMode, genrehour, ComHour, codec, contentamento;
     QMediaPlayer RadioPlayer;
@@ -272,8 +420,35 @@ class player : public QMainWindow {
     QNetworkAccessManager* networkManager;
     void launchExternalApplication(const QString& appName, const QString& filePath);
     void getMediaInfoForFile(const QString& filePath);
-    void runServerCheckScript(const QString& scriptName, const QString& fileToCheck,
-                              const QString& successMessage, const QString& failureMessage);
+    // Tags and stream details read off the GUI thread and cached; selecting a track reads ahead
+    MusicCache* mediaInfoCache = nullptr;
+    MediaInfoLoader* mediaInfoLoader = nullptr;
+    QString mediaInfoShowPath;  // Track whose info dialog opens when it is loaded
+    static constexpr qint64 MEDIA_INFO_CACHE_BYTES = 4 * 1024 * 1024;
+    void setupMediaInfo();
+    // The search box filters the music view as the user types, off the GUI thread
+    MusicCache* searchCache = nullptr;
+    SearchController* searchController = nullptr;
+    static constexpr qint64 SEARCH_CACHE_BYTES = 16 * 1024 * 1024;
+    void setupSearch();
+    void applyMediaInfo(const QVariant& info);  // A MediaInfoLoader::Info; offers to store it
+    bool startBuiltinStream();
+    void stopBuiltinStream();
+    void restartBuiltinStream();                    // When its settings changed while streaming
+    ConfigReloader* configReloader = nullptr;       // Reapplies only the settings that changed
+    void setupConfigReload();
+    BackgroundOperationFeedback* backgroundFeedback() const;
+    void killProcessByName(const QString& processName, std::function<void(bool)> done = nullptr);
+    void runServerCheckScript(const QString& fileToCheck, const QString& successMessage,
+                              const QString& failureMessage);
+    // Server presence of programs, cached so the programs menu opens without a check
+    MusicCache* serverPresenceCache = nullptr;
+    ServerPresenceCache* serverPresence = nullptr;
+    static constexpr qint64 SERVER_PRESENCE_CACHE_BYTES = 1024 * 1024;
+    void setupServerPresence();
+    QString serverPresenceText(const QString& fileName);  // Cached status for the menu
+    QString serverScriptsPath;                            // ScriptsPath, or the installed scripts
+    QString serverScriptPath(const QString& scriptName) const;
     void runServerUploadScript(const QString& scriptName, const QString& fileToUpload,
                                const QString& successMessage, const QString& failureMessage,
                                std::function<void(bool)> callback);
@@ -283,6 +458,210 @@ class player : public QMainWindow {
   private: // New vars for UI logic
     bool isDraggingProgress = false;
 
+    // Playlist total time, maintained incrementally as rows are added/removed
+    DurationCache* durationCache = nullptr;
+    // Long operations share one pool and report through one progress widget
+    TaskRunner* taskRunner = nullptr;
+    ProgressIndicatorWidget* taskProgress = nullptr;  // Progress of the task shown last
+    int taskProgressId = -1;
+    QHash<int, QString> taskTitles;     // Running tasks by id
+    QHash<int, int> taskOperations;     // BackgroundOperationFeedback operation of each task
+    BackgroundThrottle* backgroundThrottle = nullptr;  // Holds background work back while on air
+    void setupTasks();
+    void trimSilence(const QString& soxPath, const QStringList& paths, const QString& stopSeconds);
+    TranscodeEngine* transcoder = nullptr;                 // Conversions to Ogg and MP3
+    ProgressIndicatorWidget* transcodeProgress = nullptr;  // Progress of transcoder
+    void setupTranscoder();
+    void queueConversion(const QStringList& paths, const QString& suffix);
+    QStringList libraryPaths();
+    QStringList selectedPaths();
+    MusicRepository* musicRepository = nullptr;           // Files downloaded tracks in batches
+    DownloadQueue* downloads = nullptr;                   // yt-dlp downloads of external links
+    ProgressIndicatorWidget* downloadProgress = nullptr;  // Progress of downloads
+    void setupDownloads();
+    void setupTableChanges();  // What reads a table learns from TableChangeBus that it changed
+    BulkTrackOperations* bulkOperations = nullptr;  // Deletes of the music view's selection
+    ContentHashScanner* contentHashScanner = nullptr;        // Hashes tracks added before hashing
+    ProgressIndicatorWidget* contentHashProgress = nullptr;  // Progress of contentHashScanner
+    void setupDeduplication();
+    void showDuplicateReport();
+    TranscodeCache* transcodeCache = nullptr;  // WAV copies of queued tracks in other formats
+    void setupTranscodeCache();
+    void prepareTranscodes();
+    // Local copies of the tracks due next, for libraries on a NAS; MediaCacheMB 0 keeps it off
+    MediaCache* mediaCache = nullptr;
+    QTimer* mediaCachePlanTimer = nullptr;  // Copies the pubs, programs and music due soon
+    int mediaCacheMb = 0;
+    QStringList mediaCachePaths;            // Directories copied; empty for all
+    void setupMediaCache();
+    void applyMediaCache();
+    void prepareMediaCache();
+    // The library connection is opened once; the timer reopens it if it stops answering
+    static constexpr int DB_HEALTH_CHECK_MS = 30 * 1000;
+    QString databasePath;
+    QFuture<QString> databaseProvisioning;  // Bundled adb.db copy; empty result on success
+    bool databaseProvisioningPending = false;
+    QTimer* databaseHealthTimer = nullptr;
+    bool openDatabase();
+    void checkDatabaseHealth();
+    LibraryChecker* libraryChecker = nullptr;                 // Checks the musics records in parallel
+    ProgressIndicatorWidget* libraryCheckProgress = nullptr;  // Progress of libraryChecker
+    int libraryCheckProblems = 0;                             // Problems found by the running check
+    void setupLibraryCheck();
+    LibraryRescanner* libraryRescanner = nullptr;              // Syncs the library with its roots
+    ProgressIndicatorWidget* libraryRescanProgress = nullptr;  // Progress of libraryRescanner
+    QTimer* libraryRescanTimer = nullptr;                      // Fires at libraryRescanTime
+    QStringList libraryRoots;                                  // LibraryRoots, or MusicPath
+    QTime libraryRescanTime;                                   // Invalid for no nightly rescan
+    bool libraryRescanFromMenu = false;                        // Report the result in a box
+    LibraryWatcher* libraryWatcher = nullptr;                  // Rescans what changes at once
+    bool libraryWatch = true;                                  // Watch libraryRoots
+    void setupLibraryRescan();
+    void applyLibraryRoots();
+    void scheduleLibraryRescan();
+    CuePointStore* cuePoints = nullptr;                  // Auto-Trim cue points of the musics
+    SilenceScanner* silenceScanner = nullptr;            // Finds them in parallel
+    ProgressIndicatorWidget* cueScanProgress = nullptr;  // Progress of silenceScanner
+    void setupCuePoints();
+    ReplayGainStore* replayGain = nullptr;                // Measured loudness of the musics
+    LoudnessScanner* loudnessScanner = nullptr;           // Measures it in parallel
+    ProgressIndicatorWidget* loudnessProgress = nullptr;  // Progress of loudnessScanner
+    void setupLoudness();
+    void applyLoudnessNormalization();
+    void applyNativeAudio();
+    ProgramBuilder* programBuilder = nullptr;            // Joins the playlist into a program
+    ProgressIndicatorWidget* programProgress = nullptr;  // Progress of programBuilder
+    void setupProgramBuilder();
+    void offerProgramUpload(const QString& programName, const QString& destino);
+    PeakFileGenerator* peakGenerator = nullptr;  // Waveform overviews of the tracks
+    WaveformWidget* waveform = nullptr;          // Waveform of the track on air
+    QString waveformTrack;                       // Track the waveform belongs to
+    void setupWaveform();
+    void showWaveform(const QString& filePath);
+    AnalysisPipeline* analysisPipeline = nullptr;        // One decode for all the analyses
+    ProgressIndicatorWidget* analysisProgress = nullptr; // Progress of analysisPipeline
+    void setupAnalysis();
+    QFuture<void> analysisIndexExport;  // Analysis indexes of the roots being written
+    void exportAnalysisIndexes();
+    void importAnalysisIndexes();
+    QStringList existingLibraryPaths();
+    DatabaseOptimizer* dbOptimizer = nullptr; // Collects query timings from the services
+    bool fullTextSearch = false;              // musics_fts index is available
+    MaintenanceScheduler* maintenance = nullptr; // Time-boxed VACUUM/ANALYZE slices
+    PlayHistoryWriter* playHistory = nullptr; // Deferred played_times/last_played updates
+    // As-run journal of tracks, scheduler firings, TakeOvers and errors
+    EventJournal* eventJournal = nullptr;
+    QString journalTrack;                     // Track on air, as the journal knows it
+    QDateTime journalTrackStarted;
+    void journalTrackEnded(const QString& reason);
+    QueueJournal* queueJournal = nullptr;     // The queue and position, for resuming
+    bool resumeAfterRestart = true;
+    void setupQueueJournal();
+    void resumeFromJournal();
+    NowPlayingStatus* nowPlayingStatus = nullptr;  // The row lobby displays (--display) read
+    QTimer* nowPlayingTimer = nullptr;             // Folds queue edits into one write
+    void writeNowPlaying();
+    RotationEngine* rotationEngine = nullptr;  // Auto mode song rotation
+    LibrarySnapshotStore* librarySnapshots = nullptr;  // The library in memory for auto mode
+    int rotationSeparation = 20;
+    int rotationArtistSeparationMin = 60;  // Minutes before auto mode repeats an artist
+    int rotationTitleSeparationMin = 180;  // Minutes before auto mode repeats a song
+    SpotPool* jinglePool = nullptr;  // Random jingles, drawn without SQL
+    CartWall* cartWall = nullptr;    // Jingles in memory, fired over the music
+    void loadCartWall();
+    bool fireCart(const QString& filePath);
+    int dayLogArtistSeparationMin = 60;  // Minutes before an artist repeats in a day log
+    int dayLogTitleSeparationMin = 180;  // Minutes before a song repeats in a day log
+    HourGenreSchedule* hourGenreSchedule = nullptr; // Cached hourgenre table
+    SchedulerEngine* schedulerEngine = nullptr;     // Server role only
+    // The queue is planned back from the next event so it starts on its time
+    static constexpr int BACK_TIMING_HORIZON_S = 3600;
+    static constexpr int BACK_TIMING_REFRESH_MS = 200;
+    static constexpr int HARD_EVENT_PRELOAD_MS = 5000;  // Queued this early to be cut in
+    BackTimer* backTimer = nullptr;
+    QTimer* backTimingRefresh = nullptr;  // Coalesces the replans of queue changes
+    QTimer* hardEventTimer = nullptr;     // Queues an event that cuts the track on air
+    QDateTime backTimedAt;                // The event planned for, by time and rule
+    int backTimedRule = -1;
+    QString backTimedPath;
+    bool backTimedCut = false;     // The track on air is faded under the event
+    bool backTimedNext = false;    // The event follows the track on air
+    bool backTimedQueued = false;  // The event is already on its way to air
+    void setupBackTiming();
+    void planBackTiming();
+    void resetBackTiming();
+    void queueBackTimedEvent();
+    qint64 onAirRemainingMs();
+    // A scheduled pub opens a break of AdBreakSeconds, packed from the pub table
+    AdBreakPacker* adBreaks = nullptr;
+    int adBreakSeconds = 0;  // 0 airs the scheduled pub on its own
+    int adSeparationMin = 30;
+    int adMaxDailyPlays = 0;
+    QHash<QPair<qint64, qint64>, QStringList> adBreakPlan;  // Rest of each break, by time and rule
+    void applyAdBreaks();
+    void planAdBreaks();
+    QStringList takeAdBreak(const ScheduledEvent& event);
+    ProcessSupervisor* streamSupervisor = nullptr;  // icecast and butt child processes
+    ShutdownCoordinator* processShutdown = nullptr; // Parallel, non-blocking stops
+    ReachabilityMonitor* reachability = nullptr;    // TakeOver client and server probes
+    FailoverStandby* failoverStandby = nullptr;     // Local fallback kept ready during a TakeOver
+    NetworkMaintenance* networkMaintenance = nullptr; // Public IP, DDNS and port tests
+    TransferQueue* serverTransfers = nullptr;       // Upload and check scripts
+    int transferOperation = -1;                     // BackgroundOperationFeedback ID of the batch
+    FtpSyncEngine* programSync = nullptr;           // Programs from the FTP server
+    BroadcastWorker* broadcastWorker = nullptr;     // Program ingest and TakeOver requests
+    StreamOutput* streamOutput = nullptr;           // Built-in encoder and Icecast source
+    bool builtinStream = false;                     // Stream with streamOutput instead of butt
+    QString streamMounts;
+    QString streamPassword;
+    QString streamSource;                           // "output" of the decks, or the "input"
+    QString hlsTarget;                              // Directory or URL; empty for no HLS
+    QString hlsCodec;
+    int hlsBitrate = 128;
+    int hlsSegmentSeconds = 6;
+    IcecastMetadata* icecastMetadata = nullptr;     // Now-playing titles for the listeners
+    bool streamMetadata = true;
+    QString streamMetadataMounts;                   // Empty for the built-in MP3 mounts
+    void applyStreamMetadata();
+    ContributionLink* contributionLink = nullptr;   // TakeOver audio over UDP, in Opus
+    bool contributionEnabled = false;               // Client: send it instead of the stream
+    int contributionPort = 8890;
+    bool contributionOnAir = false;                 // Server: a TakeOver plays from the link
+    bool isContributionStream(const QString& stream) const;
+    void startContribution();
+    void stopContribution();
+    AirCheckRecorder* airCheck = nullptr;           // Hourly files of everything that went to air
+    bool airCheckEnabled = false;
+    QString airCheckPath;
+    int airCheckBitrate = 48;
+    int airCheckRetentionDays = 0;                  // 0 keeps the files
+    void applyAirCheck();
+    ArchiveRetention* archiveRetention = nullptr;   // Removes old programs in the background
+    QTimer* retentionTimer = nullptr;
+    int programsKeepDays = 0;                       // 0 for no age limit
+    int programsKeepCount = 0;                      // 0 for no count limit
+    int programsQuotaGb = 0;                        // 0 for no size quota
+    void setupRetention();
+    void applyRetention();
+    // Table views and genre combo boxes; kept up to date from TableChangeBus
+    LiveTableModel* musicsModel = nullptr;
+    LiveTableModel* jinglesModel = nullptr;
+    LiveTableModel* pubModel = nullptr;
+    LiveTableModel* programsModel = nullptr;
+    LiveTableModel* genresModel = nullptr;
+    // Made on first opening and kept, so opening them again does not build them anew
+    add_music_single* addMusicSingleDialog = nullptr;
+    EnhancedAddDirectoryDialog* addFullDirDialog = nullptr;
+    optionsDialog* optionsDlg = nullptr;
+    PlaylistQueueModel* playlistQueue = nullptr;  // The on-air queue shown by ui->playlist
+    HistoryListModel* historyModel = nullptr;     // What went on air today, in ui->historyList
+    PlaylistValidator* playlistValidator = nullptr;  // Checks the next files before they are due
+    QTimer* dropRefreshTimer = nullptr;  // Coalesces music view refreshes during drop imports
+    void importDroppedPaths(const QStringList& paths, bool toPlaylist);
+    QString chooseExportFile(const QString& title, const QString& baseName);
+    void watchExport(StreamingExporter* exporter, const QString& title);
+    void settleDroppedItems(const QHash<QString, QString>& toolTips);
+
   private slots: // New slots for improved UI interaction
     void on_sliderProgress_sliderPressed();
     void on_sliderProgress_sliderReleased();
@@ -57,6 +57,24 @@ bool DatabaseMigrator::addMigration(const Migration& migration)
         }
     }
     
+    if (migration.isChunked()) {
+        // The table name goes into the SQL as is
+        static const QRegularExpression identifier("^[A-Za-z_][A-Za-z0-9_]*$");
+        QString error;
+        if (!identifier.match(migration.chunkTable).hasMatch()) {
+            error = QString("Invalid chunk table: %1").arg(migration.chunkTable);
+        } else if (migration.chunkSize <= 0) {
+            error = QString("Invalid chunk size: %1").arg(migration.chunkSize);
+        } else if (!migration.upSql.contains(":from") || !migration.upSql.contains(":to")) {
+            error = "Chunked up SQL must use :from and :to";
+        }
+        if (!error.isEmpty()) {
+            logError("addMigration", error);
+            emit operationError("addMigration", error);
+            return false;
+        }
+    }
+    
     // Validate SQL
     QString sqlError = validateMigrationSql(migration.upSql);
     if (!sqlError.isEmpty()) {
@@ -124,53 +142,7 @@ DatabaseMigrator::MigrationResult DatabaseMigrator::migrate()
     result.totalMigrations = pendingMigrations.size();
     emit migrationBatchStarted(result.totalMigrations);
     
-    // Start transaction
-    if (!m_database.transaction()) {
-        result.error = "Failed to start transaction";
-        logError("migrate", result.error);
-        emit operationError("migrate", result.error);
-        return result;
-    }
-    
-    bool allSuccessful = true;
-    
-    for (const Migration& migration : pendingMigrations) {
-        emit migrationStarted(migration.version, migration.name);
-        
-        if (executeMigration(migration, false)) {
-            if (markMigrationAsApplied(migration)) {
-                result.appliedMigrations.append(migration.version);
-                result.appliedCount++;
-                emit migrationCompleted(migration.version, migration.name);
-            } else {
-                QString error = QString("Failed to mark migration as applied: %1").arg(migration.version);
-                result.failedMigrations.append(migration.version);
-                emit migrationFailed(migration.version, migration.name, error);
-                allSuccessful = false;
-                break;
-            }
-        } else {
-            QString error = QString("Failed to execute migration: %1").arg(migration.version);
-            result.failedMigrations.append(migration.version);
-            emit migrationFailed(migration.version, migration.name, error);
-            allSuccessful = false;
-            break;
-        }
-    }
-    
-    if (allSuccessful) {
-        if (m_database.commit()) {
-            result.success = true;
-        } else {
-            result.error = "Failed to commit transaction";
-            result.success = false;
-            m_database.rollback();
-        }
-    } else {
-        result.error = "One or more migrations failed";
-        result.success = false;
-        m_database.rollback();
-    }
+    applyMigrations(pendingMigrations, result);
     
     // Invalidate stats cache
     QMutexLocker statsLocker(&m_statsMutex);
@@ -223,40 +195,8 @@ DatabaseMigrator::MigrationResult DatabaseMigrator::migrateTo(const QString& tar
     result.totalMigrations = migrationsToApply.size();
     emit migrationBatchStarted(result.totalMigrations);
     
-    // Execute migrations (similar to migrate() but with filtered list)
-    if (!m_database.transaction()) {
-        result.error = "Failed to start transaction";
-        return result;
-    }
-    
-    bool allSuccessful = true;
-    
-    for (const Migration& migration : migrationsToApply) {
-        emit migrationStarted(migration.version, migration.name);
-        
-        if (executeMigration(migration, false)) {
-            if (markMigrationAsApplied(migration)) {
-                result.appliedMigrations.append(migration.version);
-                result.appliedCount++;
-                emit migrationCompleted(migration.version, migration.name);
-            } else {
-                allSuccessful = false;
-                break;
-            }
-        } else {
-            result.failedMigrations.append(migration.version);
-            allSuccessful = false;
-            break;
-        }
-    }
-    
-    if (allSuccessful && m_database.commit()) {
-        result.success = true;
-    } else {
-        result.error = allSuccessful ? "Failed to commit transaction" : "One or more migrations failed";
-        result.success = false;
-        m_database.rollback();
-    }
+    // Execute migrations (same as migrate() but with filtered list)
+    applyMigrations(migrationsToApply, result);
     
     emit migrationBatchCompleted(result);
     return result;
@@ -710,6 +650,10 @@ bool DatabaseMigrator::reset()
     query.prepare(QString("DELETE FROM %1").arg(MIGRATIONS_TABLE));
     
     bool success = executeQuery(query, "reset");
+    if (success) {
+        query.prepare(QString("DELETE FROM %1").arg(PROGRESS_TABLE));
+        success = executeQuery(query, "reset");
+    }
     
     if (success) {
         // Invalidate stats cache
@@ -742,6 +686,19 @@ bool DatabaseMigrator::createMigrationsTable()
         return false;
     }
     
+    QString createProgressSql = QString(R"(
+        CREATE TABLE IF NOT EXISTS %1 (
+            version TEXT PRIMARY KEY,
+            next_rowid INTEGER NOT NULL,
+            updated_at DATETIME
+        )
+    )").arg(PROGRESS_TABLE);
+    
+    if (!query.exec(createProgressSql)) {
+        logError("createMigrationsTable", query.lastError().text(), createProgressSql);
+        return false;
+    }
+    
     return true;
 }
 
@@ -770,6 +727,145 @@ bool DatabaseMigrator::executeMigration(const Migration& migration, bool isRollb
     return true;
 }
 
+void DatabaseMigrator::applyMigrations(const QList<Migration>& migrations, MigrationResult& result)
+{
+    if (!m_database.transaction()) {
+        result.error = "Failed to start transaction";
+        logError("migrate", result.error);
+        emit operationError("migrate", result.error);
+        return;
+    }
+    
+    bool allSuccessful = true;
+    bool inTransaction = true;
+    
+    for (const Migration& migration : migrations) {
+        emit migrationStarted(migration.version, migration.name);
+        
+        QString error;
+        if (migration.isChunked()) {
+            // Chunks commit on their own, so what came before is committed first
+            if (!m_database.commit()) {
+                result.error = "Failed to commit transaction";
+                m_database.rollback();
+                return;
+            }
+            inTransaction = false;
+            if (!executeChunkedMigration(migration)) {
+                error = QString("Failed to execute migration: %1").arg(migration.version);
+            } else {
+                inTransaction = m_database.transaction();
+            }
+        } else if (!executeMigration(migration, false)) {
+            error = QString("Failed to execute migration: %1").arg(migration.version);
+        } else if (!markMigrationAsApplied(migration)) {
+            error = QString("Failed to mark migration as applied: %1").arg(migration.version);
+        }
+        
+        if (!error.isEmpty()) {
+            result.failedMigrations.append(migration.version);
+            emit migrationFailed(migration.version, migration.name, error);
+            allSuccessful = false;
+            break;
+        }
+        
+        result.appliedMigrations.append(migration.version);
+        result.appliedCount++;
+        emit migrationCompleted(migration.version, migration.name);
+        
+        if (!inTransaction) {
+            result.error = "Failed to start transaction";
+            return;
+        }
+    }
+    
+    if (!allSuccessful) {
+        result.error = "One or more migrations failed";
+        if (inTransaction) {
+            m_database.rollback();
+        }
+    } else if (m_database.commit()) {
+        result.success = true;
+    } else {
+        result.error = "Failed to commit transaction";
+        m_database.rollback();
+    }
+}
+
+bool DatabaseMigrator::executeChunkedMigration(const Migration& migration)
+{
+    QSqlQuery query(m_database);
+    query.prepare(QString("SELECT MIN(rowid), MAX(rowid) FROM %1").arg(migration.chunkTable));
+    if (!executeQuery(query, "executeChunkedMigration") || !query.next()) {
+        return false;
+    }
+    const qint64 first = query.value(0).toLongLong();
+    qint64 last = query.value(1).toLongLong();
+    const bool empty = query.value(1).isNull();
+    
+    qint64 from = first;
+    query.prepare(QString("SELECT next_rowid FROM %1 WHERE version = ?").arg(PROGRESS_TABLE));
+    query.addBindValue(migration.version);
+    if (!executeQuery(query, "executeChunkedMigration")) {
+        return false;
+    }
+    if (query.next()) {
+        from = qMax(from, query.value(0).toLongLong());
+        qDebug() << "DatabaseMigrator: resuming migration" << migration.version << "at rowid" << from;
+    }
+    
+    while (!empty && from <= last) {
+        const qint64 to = from + migration.chunkSize;
+        if (!m_database.transaction()) {
+            logError("executeChunkedMigration", "Failed to start transaction");
+            return false;
+        }
+        
+        QSqlQuery chunk(m_database);
+        chunk.prepare(migration.upSql);
+        chunk.bindValue(":from", from);
+        chunk.bindValue(":to", to);
+        QSqlQuery checkpoint(m_database);
+        checkpoint.prepare(QString("INSERT OR REPLACE INTO %1 (version, next_rowid, updated_at) VALUES (?, ?, ?)").arg(PROGRESS_TABLE));
+        checkpoint.addBindValue(migration.version);
+        checkpoint.addBindValue(to);
+        checkpoint.addBindValue(QDateTime::currentDateTime());
+        
+        if (!chunk.exec()) {
+            logError("executeChunkedMigration", QString("Failed to execute migration %1 for rowids %2 to %3: %4")
+                    .arg(migration.version).arg(from).arg(to).arg(chunk.lastError().text()), migration.upSql);
+            m_database.rollback();
+            return false;
+        }
+        if (!executeQuery(checkpoint, "executeChunkedMigration") || !m_database.commit()) {
+            m_database.rollback();
+            return false;
+        }
+        
+        from = to;
+        emit migrationProgress(migration.version, qMin(from, last + 1) - first, last - first + 1);
+        
+        // Rows added while the migration runs are covered too
+        query.prepare(QString("SELECT MAX(rowid) FROM %1").arg(migration.chunkTable));
+        if (executeQuery(query, "executeChunkedMigration") && query.next()) {
+            last = qMax(last, query.value(0).toLongLong());
+        }
+    }
+    
+    if (!m_database.transaction()) {
+        logError("executeChunkedMigration", "Failed to start transaction");
+        return false;
+    }
+    query.prepare(QString("DELETE FROM %1 WHERE version = ?").arg(PROGRESS_TABLE));
+    query.addBindValue(migration.version);
+    if (!executeQuery(query, "executeChunkedMigration") || !markMigrationAsApplied(migration) ||
+        !m_database.commit()) {
+        m_database.rollback();
+        return false;
+    }
+    return true;
+}
+
 bool DatabaseMigrator::markMigrationAsApplied(const Migration& migration)
 {
     QSqlQuery query(m_database);
@@ -18,6 +18,12 @@
  * 
  * This structure represents a database migration with its metadata
  * and execution information.
+ *
+ * A migration that rewrites many rows can be made chunkable by naming the
+ * table it walks in chunkTable. Its upSql then covers one range of rowids,
+ * bound to :from (inclusive) and :to (exclusive), and is run chunkSize rows
+ * at a time, each chunk in its own transaction, so other connections can
+ * write between chunks.
  */
 struct Migration {
     int id = -1;
@@ -28,6 +34,15 @@ struct Migration {
     QString downSql;        // SQL to rollback the migration
     QDateTime appliedAt;    // When the migration was applied
     bool isApplied = false; // Whether the migration has been applied
+    QString chunkTable;     // Table whose rowids upSql walks; empty runs upSql once
+    int chunkSize = 5000;   // Rows per chunk of a chunkable migration
+    
+    /**
+     * @brief Check if the migration runs in chunks over chunkTable
+     */
+    bool isChunked() const {
+        return !chunkTable.isEmpty();
+    }
     
     /**
      * @brief Check if the migration has valid required fields
@@ -51,6 +66,10 @@ struct Migration {
         map["down_sql"] = downSql;
         map["applied_at"] = appliedAt;
         map["is_applied"] = isApplied;
+        if (isChunked()) {
+            map["chunk_table"] = chunkTable;
+            map["chunk_size"] = chunkSize;
+        }
         return map;
     }
     
@@ -69,6 +88,8 @@ struct Migration {
         migration.downSql = map.value("down_sql").toString();
         migration.appliedAt = map.value("applied_at").toDateTime();
         migration.isApplied = map.value("is_applied", false).toBool();
+        migration.chunkTable = map.value("chunk_table").toString();
+        migration.chunkSize = map.value("chunk_size", migration.chunkSize).toInt();
         return migration;
     }
 };
@@ -84,6 +105,7 @@ struct Migration {
  * - Version-based migration system
  * - Forward and backward migration support
  * - Transaction-based migration execution
+ * - Chunked data migrations with resumable checkpoints and progress
  * - Migration history tracking
  * - Rollback capabilities
  * - Validation and error handling
@@ -104,6 +126,15 @@ struct Migration {
  * migration.downSql = "DROP INDEX idx_music_artist;";
  * migrator->addMigration(migration);
  * 
+ * // A data migration over a large table, committed 5000 rows at a time
+ * Migration backfill;
+ * backfill.version = "002";
+ * backfill.name = "Lowercase artist keys";
+ * backfill.upSql = "UPDATE musics SET artist_key = lower(artist) "
+ *                  "WHERE rowid >= :from AND rowid < :to;";
+ * backfill.chunkTable = "musics";
+ * migrator->addMigration(backfill);
+ * 
  * // Run pending migrations
  * migrator->migrate();
  * @endcode
@@ -158,6 +189,11 @@ public:
 
     /**
      * @brief Run all pending migrations
+     *
+     * Migrations run in one transaction, except that a chunkable migration
+     * commits the ones before it and then commits chunk by chunk. If it
+     * stops, the migrations before it stay applied and the next migrate()
+     * carries on from the last chunk it committed.
      * @return MigrationResult with execution details
      */
     MigrationResult migrate();
@@ -292,6 +328,14 @@ signals:
      */
     void migrationFailed(const QString& version, const QString& name, const QString& error);
 
+    /**
+     * @brief Emitted after each chunk of a chunkable migration is committed
+     * @param version Migration version
+     * @param done Rowids covered so far, counting those done before a resume
+     * @param total Rowids to cover, from the lowest to the highest in the table
+     */
+    void migrationProgress(const QString& version, qint64 done, qint64 total);
+
     /**
      * @brief Emitted when a rollback starts
      * @param version Migration version being rolled back
@@ -348,6 +392,23 @@ private:
      */
     bool executeMigration(const Migration& migration, bool isRollback = false);
 
+    /**
+     * @brief Apply migrations in order, as migrate() describes
+     * @param migrations Pending migrations, sorted by version
+     * @param result Filled in with what was applied
+     */
+    void applyMigrations(const QList<Migration>& migrations, MigrationResult& result);
+
+    /**
+     * @brief Run a chunkable migration chunk by chunk and mark it applied
+     *
+     * Called outside a transaction. Each chunk commits with the checkpoint of
+     * the next rowid, which is read back to resume.
+     * @param migration Chunkable migration
+     * @return true if every chunk ran and the migration was marked applied
+     */
+    bool executeChunkedMigration(const Migration& migration);
+
     /**
      * @brief Mark migration as applied
      * @param migration Migration to mark as applied
@@ -409,6 +470,9 @@ private:
     
     // Migration table name
     static constexpr const char* MIGRATIONS_TABLE = "schema_migrations";
+    
+    // Next rowid of each chunkable migration still running
+    static constexpr const char* PROGRESS_TABLE = "schema_migration_progress";
 };
 
 #endif // DATABASEMIGRATOR_H
\ No newline at end of file
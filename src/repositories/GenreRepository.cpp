@@ -1,10 +1,28 @@
 #include "GenreRepository.h"
+#include "../services/QueryTimer.h"
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QVariant>
 #include <QDebug>
 #include <QDateTime>
 #include <QMutexLocker>
+#include <algorithm>
+
+namespace {
+
+// Index order: ignoring case first, so completion is one range, then exact
+bool nameLess(const QString& a, const QString& b)
+{
+    const int folded = a.compare(b, Qt::CaseInsensitive);
+    return folded != 0 ? folded < 0 : a < b;
+}
+
+bool foldedLess(const QString& entry, const QString& value)
+{
+    return entry.compare(value, Qt::CaseInsensitive) < 0;
+}
+
+} // namespace
 
 GenreRepository::GenreRepository(QSqlDatabase& database, QObject* parent)
     : QObject(parent)
@@ -29,22 +47,12 @@ bool GenreRepository::addGenre(const GenreItem& genre)
     }
     
     // Check if genre already exists (inline to avoid recursive mutex lock)
-    {
-        QString tableName = getTableName(genre.genreType);
-        if (!tableName.isEmpty()) {
-            QSqlQuery checkQuery(m_database);
-            QString checkQueryString = QString("SELECT COUNT(*) as count FROM %1 WHERE name = ?").arg(tableName);
-            checkQuery.prepare(checkQueryString);
-            checkQuery.addBindValue(sanitizeName(genre.name));
-            
-            if (checkQuery.exec() && checkQuery.next() && checkQuery.value("count").toInt() > 0) {
-                QString error = QString("Genre already exists in %1: %2")
-                               .arg(tableName, genre.name);
-                logError("addGenre", error);
-                emit operationError("addGenre", error);
-                return false;
-            }
-        }
+    if (indexContains(sanitizeName(genre.name), genre.genreType)) {
+        QString error = QString("Genre already exists in %1: %2")
+                       .arg(getTableName(genre.genreType), genre.name);
+        logError("addGenre", error);
+        emit operationError("addGenre", error);
+        return false;
     }
     
     QString tableName = getTableName(genre.genreType);
@@ -64,6 +72,8 @@ bool GenreRepository::addGenre(const GenreItem& genre)
         return false;
     }
     
+    indexInsert(sanitizeName(genre.name), genre.genreType);
+    
     // Create a copy with the new ID for the signal
     GenreItem addedGenre = genre;
     addedGenre.id = query.lastInsertId().toInt();
@@ -122,6 +132,9 @@ bool GenreRepository::updateGenre(const GenreItem& genre)
         return false;
     }
     
+    // The old name is not known here; read the table again on next use
+    m_names.remove(genre.genreType);
+    
     emit genreUpdated(genre);
     
     // Invalidate stats cache
@@ -167,6 +180,8 @@ bool GenreRepository::deleteGenre(int genreId, int genreType)
         return false;
     }
     
+    m_names.remove(genreType);
+    
     emit genreDeleted(genreId, genreType);
     
     // Invalidate stats cache
@@ -371,23 +386,18 @@ int GenreRepository::addGenreBatch(const QList<GenreItem>& genreList)
                 continue;
             }
             
-            // Check if genre already exists (inline to avoid recursive mutex lock)
-            {
-                QSqlQuery checkQuery(m_database);
-                QString checkQueryString = QString("SELECT COUNT(*) as count FROM %1 WHERE name = ?").arg(tableName);
-                checkQuery.prepare(checkQueryString);
-                checkQuery.addBindValue(sanitizeName(genre.name));
-                
-                if (checkQuery.exec() && checkQuery.next() && checkQuery.value("count").toInt() > 0) {
-                    qDebug() << "Skipping duplicate genre:" << genre.name;
-                    continue;
-                }
+            // Check if genre already exists, in the table or earlier in this batch
+            const QString name = sanitizeName(genre.name);
+            if (indexContains(name, genreType)) {
+                qDebug() << "Skipping duplicate genre:" << genre.name;
+                continue;
             }
             
-            query.addBindValue(sanitizeName(genre.name));
+            query.addBindValue(name);
             
             if (query.exec()) {
                 successCount++;
+                indexInsert(name, genreType);
                 
                 // Emit signal for each added item
                 GenreItem addedGenre = genre;
@@ -403,6 +413,7 @@ int GenreRepository::addGenreBatch(const QList<GenreItem>& genreList)
     // Commit transaction
     if (!m_database.commit()) {
         m_database.rollback();
+        m_names.clear();
         logError("addGenreBatch", "Failed to commit transaction");
         emit operationError("addGenreBatch", "Failed to commit transaction");
         return 0;
@@ -419,25 +430,7 @@ bool GenreRepository::genreExists(const QString& name, int genreType)
 {
     QMutexLocker locker(&m_mutex);
     
-    QString tableName = getTableName(genreType);
-    if (tableName.isEmpty()) {
-        return false;
-    }
-    
-    QSqlQuery query(m_database);
-    QString queryString = QString("SELECT COUNT(*) as count FROM %1 WHERE name = ?").arg(tableName);
-    query.prepare(queryString);
-    query.addBindValue(sanitizeName(name));
-    
-    if (query.exec() && query.next()) {
-        return query.value("count").toInt() > 0;
-    }
-    
-    if (query.lastError().isValid()) {
-        logError("genreExists", query.lastError().text(), query.lastQuery());
-    }
-    
-    return false;
+    return indexContains(sanitizeName(name), genreType);
 }
 
 GenreRepository::GenreStats GenreRepository::getStatistics()
@@ -500,40 +493,48 @@ QStringList GenreRepository::getAllGenreNames(int genreType)
 {
     QMutexLocker locker(&m_mutex);
     
-    QStringList names;
-    
+    QStringList result;
     if (genreType == 0 || genreType == 1) {
-        // Get from genres1
-        QSqlQuery query(m_database);
-        query.prepare("SELECT name FROM genres1 ORDER BY name");
-        
-        if (executeQuery(query, "getAllGenreNames")) {
-            while (query.next()) {
-                QString name = query.value("name").toString();
-                if (!names.contains(name)) {
-                    names.append(name);
-                }
-            }
-        }
+        result += names(1);
     }
-    
     if (genreType == 0 || genreType == 2) {
-        // Get from genres2
-        QSqlQuery query(m_database);
-        query.prepare("SELECT name FROM genres2 ORDER BY name");
-        
-        if (executeQuery(query, "getAllGenreNames")) {
-            while (query.next()) {
-                QString name = query.value("name").toString();
-                if (!names.contains(name)) {
-                    names.append(name);
-                }
-            }
+        result += names(2);
+    }
+    
+    result.sort();
+    result.removeDuplicates();
+    return result;
+}
+
+QStringList GenreRepository::completeGenres(const QString& prefix, int genreType, int limit)
+{
+    QMutexLocker locker(&m_mutex);
+    
+    const QString typed = sanitizeName(prefix);
+    QStringList result;
+    for (int type = 1; type <= 2; ++type) {
+        if (genreType != 0 && genreType != type) {
+            continue;
+        }
+        const QStringList& sorted = names(type);
+        auto it = std::lower_bound(sorted.cbegin(), sorted.cend(), typed, foldedLess);
+        for (; it != sorted.cend() && it->startsWith(typed, Qt::CaseInsensitive); ++it) {
+            result.append(*it);
         }
     }
     
-    names.sort();
-    return names;
+    std::sort(result.begin(), result.end(), nameLess);
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    if (limit >= 0 && result.size() > limit) {
+        result.resize(limit);
+    }
+    return result;
+}
+
+void GenreRepository::reloadNames()
+{
+    QMutexLocker locker(&m_mutex);
+    m_names.clear();
 }
 
 QString GenreRepository::validateGenreItem(const GenreItem& genre)
@@ -577,9 +578,71 @@ void GenreRepository::logError(const QString& operation, const QString& error, c
     qWarning() << logMessage;
 }
 
+const QStringList& GenreRepository::names(int genreType)
+{
+    auto it = m_names.find(genreType);
+    if (it != m_names.end()) {
+        return *it;
+    }
+    
+    static const QStringList none;
+    const QString tableName = getTableName(genreType);
+    if (tableName.isEmpty()) {
+        return none;
+    }
+    
+    QSqlQuery query(m_database);
+    query.prepare(QString("SELECT name FROM %1").arg(tableName));
+    bool success;
+    {
+        QueryTimer timer(query.lastQuery());
+        success = query.exec();
+    }
+    if (!success) {
+        // Not kept, so the next lookup tries the table again; the caller reports its own failure
+        logError("names", query.lastError().text(), query.lastQuery());
+        return none;
+    }
+    
+    QStringList loaded;
+    while (query.next()) {
+        loaded.append(query.value(0).toString());
+    }
+    std::sort(loaded.begin(), loaded.end(), nameLess);
+    return *m_names.insert(genreType, loaded);
+}
+
+bool GenreRepository::indexContains(const QString& name, int genreType)
+{
+    const QStringList& sorted = names(genreType);
+    auto it = std::lower_bound(sorted.cbegin(), sorted.cend(), name, foldedLess);
+    // Names equal but for case sit together; the tables compare names exactly
+    for (; it != sorted.cend() && it->compare(name, Qt::CaseInsensitive) == 0; ++it) {
+        if (*it == name) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void GenreRepository::indexInsert(const QString& name, int genreType)
+{
+    auto it = m_names.find(genreType);
+    if (it == m_names.end()) {
+        return;
+    }
+    it->insert(std::lower_bound(it->cbegin(), it->cend(), name, nameLess), name);
+}
+
 bool GenreRepository::executeQuery(QSqlQuery& query, const QString& operation)
 {
-    if (!query.exec()) {
+    bool success;
+    {
+        QueryTimer timer(query.lastQuery());
+        success = query.exec();
+    }
+    
+    if (!success) {
         QString error = QString("SQL Error: %1").arg(query.lastError().text());
         logError(operation, error, query.lastQuery());
         emit operationError(operation, error);
@@ -9,6 +9,8 @@
 #include <QVariantMap>
 #include <QDateTime>
 #include <QMutex>
+#include <QHash>
+#include <QStringList>
 #include <memory>
 
 /**
@@ -71,6 +73,7 @@ struct GenreItem {
  * - Thread-safe operations
  * - Input validation and sanitization
  * - Duplicate prevention
+ * - In-memory name index for duplicate checks and completion
  * 
  * @example
  * @code
@@ -198,6 +201,24 @@ public:
      */
     QStringList getAllGenreNames(int genreType = 0);
 
+    /**
+     * @brief Complete a genre name from the in-memory index
+     *
+     * Matches names starting with prefix, ignoring case, without a query.
+     * @param prefix Text typed so far
+     * @param genreType 0 for both tables, 1 for genres1, 2 for genres2
+     * @param limit Maximum number of names, -1 for all
+     * @return Matching names, sorted ignoring case
+     */
+    QStringList completeGenres(const QString& prefix, int genreType = 0, int limit = 20);
+
+    /**
+     * @brief Drop the in-memory name index so the next lookup reads the tables again
+     *
+     * Call after genres1 or genres2 were changed without this repository.
+     */
+    void reloadNames();
+
     /**
      * @brief Validate genre item data
      * @param genre GenreItem to validate
@@ -263,9 +284,30 @@ private:
      */
     bool executeQuery(QSqlQuery& query, const QString& operation);
 
+    /**
+     * @brief Get the sorted names of a genre table, reading it on first use
+     *
+     * Callers hold m_mutex. Names are sorted ignoring case, then by case.
+     * @param genreType Genre type (1 or 2)
+     */
+    const QStringList& names(int genreType);
+
+    /**
+     * @brief Check the index for a name, already sanitized; callers hold m_mutex
+     */
+    bool indexContains(const QString& name, int genreType);
+
+    /**
+     * @brief Add a name, already sanitized, to the index if it is loaded
+     */
+    void indexInsert(const QString& name, int genreType);
+
     QSqlDatabase& m_database;
     mutable QMutex m_mutex;
     
+    // Sorted genre names by type, so duplicate checks and completion need no query
+    QHash<int, QStringList> m_names;
+    
     // Statistics cache
     mutable QMutex m_statsMutex;
     mutable GenreStats m_cachedStats;
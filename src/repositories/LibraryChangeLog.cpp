@@ -0,0 +1,420 @@
+#include "LibraryChangeLog.h"
+#include "Savepoint.h"
+#include <QDebug>
+#include <QHash>
+#include <QJsonArray>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QUuid>
+#include <QVariant>
+#include <memory>
+
+namespace {
+
+bool execLogged(QSqlQuery& query, const QString& operation, const QString& sql)
+{
+    if (query.exec(sql)) {
+        return true;
+    }
+    qWarning() << QString("LibraryChangeLog::%1 - SQL Error: %2 (Query: %3)")
+                      .arg(operation, query.lastError().text(), sql);
+    return false;
+}
+
+} // namespace
+
+LibraryChangeLog::LibraryChangeLog(const QSqlDatabase& database)
+    : m_database(database)
+{
+}
+
+const QList<LibraryChangeLog::Table>& LibraryChangeLog::tables()
+{
+    static const QList<Table> synced = {
+        {"musics", "path",
+         {"artist", "song", "genre1", "genre2", "country", "published_date", "path", "time"},
+         ", played_times", ", 0"},
+        {"jingles", "path", {"name", "path"}, QString(), QString()},
+        {"genres1", "name", {"name"}, QString(), QString()},
+        {"genres2", "name", {"name"}, QString(), QString()}
+    };
+    return synced;
+}
+
+const LibraryChangeLog::Table* LibraryChangeLog::findTable(const QString& name)
+{
+    for (const Table& table : tables()) {
+        if (table.name == name) {
+            return &table;
+        }
+    }
+    return nullptr;
+}
+
+QStringList LibraryChangeLog::syncedTables()
+{
+    QStringList names;
+    for (const Table& table : tables()) {
+        names.append(table.name);
+    }
+    return names;
+}
+
+bool LibraryChangeLog::ensure()
+{
+    QSqlQuery query(m_database);
+    if (!execLogged(query, "ensure", "SELECT 1 FROM sqlite_master "
+                                     "WHERE type = 'table' AND name = 'library_changes'")) {
+        return false;
+    }
+    if (query.next()) {
+        return true;
+    }
+
+    // One entry per key: INSERT OR REPLACE moves a key changed again to the end of the log
+    QStringList statements = {
+        "CREATE TABLE library_changes (seq INTEGER PRIMARY KEY AUTOINCREMENT, "
+        "table_name TEXT NOT NULL, row_key TEXT NOT NULL, UNIQUE (table_name, row_key))",
+        "CREATE TABLE library_changes_info (log_id TEXT NOT NULL)",
+        QString("INSERT INTO library_changes_info (log_id) VALUES ('%1')")
+            .arg(QUuid::createUuid().toString(QUuid::WithoutBraces)),
+        "CREATE INDEX IF NOT EXISTS idx_musics_path ON musics(path)"
+    };
+
+    for (const Table& table : tables()) {
+        const QString log("INSERT OR REPLACE INTO library_changes (table_name, row_key) ");
+        QStringList changed;
+        for (const QString& column : table.columns) {
+            changed.append(QString("old.%1 IS NOT new.%1").arg(column));
+        }
+
+        statements.append(QString("CREATE TRIGGER library_changes_%1_insert AFTER INSERT ON %1 "
+                                  "WHEN new.%2 IS NOT NULL BEGIN "
+                                  "%3VALUES ('%1', new.%2); END")
+                              .arg(table.name, table.key, log));
+        statements.append(QString("CREATE TRIGGER library_changes_%1_delete AFTER DELETE ON %1 "
+                                  "WHEN old.%2 IS NOT NULL BEGIN "
+                                  "%3VALUES ('%1', old.%2); END")
+                              .arg(table.name, table.key, log));
+        // A changed key is a delete of the old one and an insert of the new one
+        statements.append(QString("CREATE TRIGGER library_changes_%1_update "
+                                  "AFTER UPDATE OF %2 ON %1 WHEN %3 BEGIN "
+                                  "%4SELECT '%1', old.%5 WHERE old.%5 IS NOT NULL "
+                                  "AND old.%5 IS NOT new.%5; "
+                                  "%4SELECT '%1', new.%5 WHERE new.%5 IS NOT NULL; END")
+                              .arg(table.name, table.columns.join(", "), changed.join(" OR "),
+                                   log, table.key));
+        statements.append(QString("%1SELECT '%2', %3 FROM %2 WHERE %3 IS NOT NULL")
+                              .arg(log, table.name, table.key));
+    }
+
+    // The log, its triggers and its first rows appear together or not at all
+    Savepoint savepoint(m_database, "library_changes_setup");
+    if (!savepoint.isOpen()) {
+        return false;
+    }
+
+    for (const QString& sql : statements) {
+        if (!execLogged(query, "ensure", sql)) {
+            return false;
+        }
+    }
+
+    if (!savepoint.release()) {
+        return false;
+    }
+
+    qDebug() << "LibraryChangeLog: created library change log";
+    return true;
+}
+
+bool LibraryChangeLog::ensureCursors()
+{
+    QSqlQuery query(m_database);
+    return execLogged(query, "ensureCursors",
+                      "CREATE TABLE IF NOT EXISTS library_sync_cursor (source TEXT PRIMARY KEY, "
+                      "seq INTEGER NOT NULL, log_id TEXT)");
+}
+
+QString LibraryChangeLog::logId() const
+{
+    QSqlQuery query(m_database);
+    if (!query.exec("SELECT log_id FROM library_changes_info LIMIT 1") || !query.next()) {
+        return QString();
+    }
+    return query.value(0).toString();
+}
+
+qint64 LibraryChangeLog::latestSeq() const
+{
+    QSqlQuery query(m_database);
+    if (!query.exec("SELECT MAX(seq) FROM library_changes") || !query.next()) {
+        return 0;
+    }
+    return query.value(0).toLongLong();
+}
+
+QJsonObject LibraryChangeLog::changesSince(qint64 since, int limit) const
+{
+    limit = limit <= 0 ? DEFAULT_BATCH : qMin(limit, int(MAX_BATCH));
+    since = qMax<qint64>(0, since);
+
+    QSqlQuery changes(m_database);
+    changes.prepare("SELECT seq, table_name, row_key FROM library_changes "
+                    "WHERE seq > ? ORDER BY seq LIMIT ?");
+    changes.addBindValue(since);
+    changes.addBindValue(limit);
+    if (!changes.exec()) {
+        qWarning() << "LibraryChangeLog::changesSince - SQL Error:" << changes.lastError().text();
+        return QJsonObject{{"error", changes.lastError().text()}};
+    }
+
+    QHash<QString, QJsonArray> rows;
+    QHash<QString, QJsonArray> deleted;
+    QHash<QString, std::shared_ptr<QSqlQuery>> lookups;
+    qint64 to = since;
+    int count = 0;
+
+    while (changes.next()) {
+        to = changes.value(0).toLongLong();
+        ++count;
+        const Table* table = findTable(changes.value(1).toString());
+        if (!table) {
+            continue;
+        }
+        const QString key = changes.value(2).toString();
+
+        std::shared_ptr<QSqlQuery> lookup = lookups.value(table->name);
+        if (!lookup) {
+            lookup = std::make_shared<QSqlQuery>(m_database);
+            lookup->prepare(QString("SELECT %1 FROM %2 WHERE %3 = ? LIMIT 1")
+                                .arg(table->columns.join(", "), table->name, table->key));
+            lookups.insert(table->name, lookup);
+        }
+
+        // The log only says the key changed; whether the row is still there says how
+        lookup->addBindValue(key);
+        if (!lookup->exec()) {
+            qWarning() << "LibraryChangeLog::changesSince - SQL Error:"
+                       << lookup->lastError().text();
+            return QJsonObject{{"error", lookup->lastError().text()}};
+        }
+        if (lookup->next()) {
+            QJsonArray row;
+            for (int i = 0; i < table->columns.size(); ++i) {
+                row.append(QJsonValue::fromVariant(lookup->value(i)));
+            }
+            rows[table->name].append(row);
+        } else {
+            deleted[table->name].append(key);
+        }
+        lookup->finish();
+    }
+
+    QJsonObject result;
+    for (const Table& table : tables()) {
+        if (!rows.contains(table.name) && !deleted.contains(table.name)) {
+            continue;
+        }
+        result.insert(table.name, QJsonObject{
+            {"key", table.key},
+            {"columns", QJsonArray::fromStringList(table.columns)},
+            {"rows", rows.value(table.name)},
+            {"deleted", deleted.value(table.name)}
+        });
+    }
+
+    const qint64 latest = latestSeq();
+    return QJsonObject{
+        {"log", logId()},
+        {"from", since},
+        {"to", to},
+        {"latest", latest},
+        {"more", count == limit && to < latest},
+        {"tables", result}
+    };
+}
+
+QString LibraryChangeLog::mapPath(const QString& path, const QString& from, const QString& to)
+{
+    if (from.isEmpty() || !path.startsWith(from)) {
+        return path;
+    }
+    return to + path.mid(from.size());
+}
+
+int LibraryChangeLog::applyChanges(const QString& source, const QJsonObject& delta,
+                                   const QString& pathFrom, const QString& pathTo)
+{
+    if (!delta.contains("to") || !delta.value("tables").isObject()) {
+        qWarning() << "LibraryChangeLog::applyChanges - not a delta from" << source;
+        return -1;
+    }
+
+    // A delta is applied whole; any failure below rolls back what it changed
+    Savepoint savepoint(m_database, "library_sync");
+    if (!savepoint.isOpen()) {
+        return -1;
+    }
+
+    auto fail = [](const QString& error) {
+        qWarning() << "LibraryChangeLog::applyChanges - SQL Error:" << error;
+        return -1;
+    };
+
+    int applied = 0;
+    const QJsonObject changed = delta.value("tables").toObject();
+    for (auto it = changed.begin(); it != changed.end(); ++it) {
+        const Table* table = findTable(it.key());
+        if (!table) {
+            continue;
+        }
+        const QJsonObject entry = it.value().toObject();
+        const bool mapsPaths = table->key == "path";
+
+        // Columns are matched by name, so a primary syncing more of them still applies
+        QList<int> positions;
+        const QJsonArray columns = entry.value("columns").toArray();
+        for (const QString& column : table->columns) {
+            int position = -1;
+            for (int i = 0; i < columns.size(); ++i) {
+                if (columns.at(i).toString() == column) {
+                    position = i;
+                }
+            }
+            if (position < 0) {
+                return fail(QString("%1 has no column %2").arg(table->name, column));
+            }
+            positions.append(position);
+        }
+
+        QStringList assignments;
+        QStringList others;
+        for (const QString& column : table->columns) {
+            if (column != table->key) {
+                assignments.append(column + " = ?");
+                others.append(column);
+            }
+        }
+
+        QSqlQuery update(m_database);
+        if (!assignments.isEmpty()) {
+            update.prepare(QString("UPDATE %1 SET %2 WHERE %3 = ?")
+                               .arg(table->name, assignments.join(", "), table->key));
+        }
+        QSqlQuery exists(m_database);
+        exists.prepare(QString("SELECT 1 FROM %1 WHERE %2 = ? LIMIT 1")
+                           .arg(table->name, table->key));
+        QSqlQuery insert(m_database);
+        insert.prepare(QString("INSERT INTO %1 (%2%3) VALUES (%4%5)")
+                           .arg(table->name, table->columns.join(", "), table->insertColumns,
+                                QStringList(table->columns.size(), "?").join(", "),
+                                table->insertValues));
+
+        for (const QJsonValue& value : entry.value("rows").toArray()) {
+            const QJsonArray row = value.toArray();
+            QVariantMap values;
+            for (int i = 0; i < table->columns.size(); ++i) {
+                QVariant cell = row.at(positions.at(i)).toVariant();
+                if (table->columns.at(i) == "path") {
+                    cell = mapPath(cell.toString(), pathFrom, pathTo);
+                }
+                values.insert(table->columns.at(i), cell);
+            }
+            const QVariant key = values.value(table->key);
+
+            bool found = false;
+            if (!assignments.isEmpty()) {
+                for (const QString& column : others) {
+                    update.addBindValue(values.value(column));
+                }
+                update.addBindValue(key);
+                if (!update.exec()) {
+                    return fail(update.lastError().text());
+                }
+                found = update.numRowsAffected() > 0;
+            } else {
+                exists.addBindValue(key);
+                if (!exists.exec()) {
+                    return fail(exists.lastError().text());
+                }
+                found = exists.next();
+                exists.finish();
+                if (found) {
+                    continue;
+                }
+            }
+
+            if (!found) {
+                for (const QString& column : table->columns) {
+                    insert.addBindValue(values.value(column));
+                }
+                if (!insert.exec()) {
+                    return fail(insert.lastError().text());
+                }
+            }
+            ++applied;
+        }
+
+        QSqlQuery remove(m_database);
+        remove.prepare(QString("DELETE FROM %1 WHERE %2 = ?").arg(table->name, table->key));
+        for (const QJsonValue& key : entry.value("deleted").toArray()) {
+            const QString value = key.toString();
+            remove.addBindValue(mapsPaths ? mapPath(value, pathFrom, pathTo) : value);
+            if (!remove.exec()) {
+                return fail(remove.lastError().text());
+            }
+            applied += remove.numRowsAffected();
+        }
+    }
+
+    if (!storeCursor(source, delta.value("to").toVariant().toLongLong(),
+                     delta.value("log").toString())) {
+        return fail(QString("cannot store the cursor of %1").arg(source));
+    }
+
+    if (!savepoint.release()) {
+        return -1;
+    }
+    return applied;
+}
+
+qint64 LibraryChangeLog::cursor(const QString& source, QString* logId) const
+{
+    QSqlQuery query(m_database);
+    query.prepare("SELECT seq, log_id FROM library_sync_cursor WHERE source = ?");
+    query.addBindValue(source);
+    if (!query.exec() || !query.next()) {
+        if (logId) {
+            logId->clear();
+        }
+        return 0;
+    }
+    if (logId) {
+        *logId = query.value(1).toString();
+    }
+    return query.value(0).toLongLong();
+}
+
+bool LibraryChangeLog::resetCursor(const QString& source, const QString& logId)
+{
+    return storeCursor(source, 0, logId);
+}
+
+bool LibraryChangeLog::storeCursor(const QString& source, qint64 seq, const QString& logId)
+{
+    if (!ensureCursors()) {
+        return false;
+    }
+    QSqlQuery query(m_database);
+    query.prepare("INSERT OR REPLACE INTO library_sync_cursor (source, seq, log_id) "
+                  "VALUES (?, ?, ?)");
+    query.addBindValue(source);
+    query.addBindValue(seq);
+    query.addBindValue(logId);
+    if (!query.exec()) {
+        qWarning() << "LibraryChangeLog::storeCursor - SQL Error:" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,138 @@
+#ifndef LIBRARYCHANGELOG_H
+#define LIBRARYCHANGELOG_H
+
+#include <QJsonObject>
+#include <QSqlDatabase>
+#include <QString>
+#include <QStringList>
+
+/**
+ * @brief Change log of the shared library tables, and applying it on a replica
+ *
+ * Stations with several studios kept one adb.db per studio and copied new
+ * tracks to each by hand. LibraryChangeLog lets one studio, the primary,
+ * serve what changed in its library, and the others apply it.
+ *
+ * On the primary, ensure() adds a library_changes table filled by triggers
+ * on the synced tables, so every writer is covered: the repositories, the
+ * importers and the older SQL in the window alike. A row of the log is a
+ * table and the key of a row in it; a key changed twice has one entry, at
+ * the sequence number of the last change, so a replica that was away for a
+ * week only fetches each changed row once.
+ *
+ * Synced are the music library (musics, keyed by path, without the play
+ * counts, which stay per studio), the jingles (keyed by path) and the two
+ * genre lists (keyed by name). Pubs, programs and the schedules stay per
+ * studio.
+ *
+ * changesSince() turns the log into a delta: the current rows of the keys
+ * changed after a sequence number, and the keys deleted. applyChanges()
+ * applies a delta on a replica in one transaction and moves the cursor of
+ * its source, kept in library_sync_cursor, so a batch applies entirely or
+ * not at all and is fetched again after a failure.
+ *
+ * Each log has a random id. A replica seeing another id, because the
+ * primary's database was replaced, starts again from 0.
+ *
+ * @example
+ * @code
+ * // Primary
+ * LibraryChangeLog log(database);
+ * log.ensure();
+ * QJsonObject delta = log.changesSince(since, 500);
+ *
+ * // Replica
+ * LibraryChangeLog replica(database);
+ * replica.applyChanges("http://studio-a:9106", delta);
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class LibraryChangeLog
+{
+public:
+    static constexpr int DEFAULT_BATCH = 500;   ///< Rows per delta
+    static constexpr int MAX_BATCH = 5000;
+
+    explicit LibraryChangeLog(const QSqlDatabase& database);
+
+    /**
+     * @brief Create the log and its triggers if they do not exist yet
+     *
+     * A new log starts with every row of the synced tables in it, so a
+     * replica fetching from 0 gets the whole library.
+     * @return true if the log is ready
+     */
+    bool ensure();
+
+    /**
+     * @brief Create the cursor table a replica keeps its position in
+     */
+    bool ensureCursors();
+
+    /**
+     * @brief Id of this database's log, empty without one
+     */
+    QString logId() const;
+
+    /**
+     * @brief Sequence number of the last change, 0 without any
+     */
+    qint64 latestSeq() const;
+
+    /**
+     * @brief Changes after a sequence number
+     * @param since Last sequence number the replica has
+     * @param limit Most keys to include, up to MAX_BATCH; DEFAULT_BATCH if 0
+     * @return {"log","from","to","latest","more","tables":{name:{"key","columns",
+     *         "rows":[[...]],"deleted":[keys]}}}; {"error":...} on failure
+     */
+    QJsonObject changesSince(qint64 since, int limit = DEFAULT_BATCH) const;
+
+    /**
+     * @brief Apply a delta made by changesSince() and store the cursor of its source
+     *
+     * Rows are updated by key, or inserted if the replica does not have them.
+     * @param source Name of the primary, such as its URL
+     * @param delta Delta to apply
+     * @param pathFrom Prefix of the paths on the primary, replaced by pathTo
+     * @param pathTo Prefix of the same files on this studio
+     * @return Rows changed, or -1 if nothing was applied
+     */
+    int applyChanges(const QString& source, const QJsonObject& delta,
+                     const QString& pathFrom = QString(), const QString& pathTo = QString());
+
+    /**
+     * @brief Last sequence number applied from a source, 0 if none
+     * @param logId Set to the log id the sequence number belongs to
+     */
+    qint64 cursor(const QString& source, QString* logId = nullptr) const;
+
+    /**
+     * @brief Forget the position in a source so it is fetched from 0 again
+     */
+    bool resetCursor(const QString& source, const QString& logId);
+
+    /**
+     * @brief Names of the synced tables
+     */
+    static QStringList syncedTables();
+
+private:
+    struct Table {
+        QString name;
+        QString key;
+        QStringList columns;   ///< Synced, the key included
+        QString insertColumns; ///< Unsynced columns given a value on a replica's insert
+        QString insertValues;
+    };
+
+    static const QList<Table>& tables();
+    static const Table* findTable(const QString& name);
+    static QString mapPath(const QString& path, const QString& from, const QString& to);
+    bool storeCursor(const QString& source, qint64 seq, const QString& logId);
+
+    QSqlDatabase m_database;
+};
+
+#endif // LIBRARYCHANGELOG_H
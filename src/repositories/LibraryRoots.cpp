@@ -0,0 +1,339 @@
+#include "LibraryRoots.h"
+#include "Savepoint.h"
+#include <QDebug>
+#include <QDir>
+#include <QList>
+#include <QPair>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QStringList>
+#include <QVariant>
+
+namespace {
+
+bool execLogged(QSqlQuery& query, const QString& operation, const QString& sql)
+{
+    if (query.exec(sql)) {
+        return true;
+    }
+    qWarning() << QString("LibraryRoots::%1 - SQL Error: %2 (Query: %3)")
+                      .arg(operation, query.lastError().text(), sql);
+    return false;
+}
+
+bool execLogged(QSqlQuery& query, const QString& operation)
+{
+    if (query.exec()) {
+        return true;
+    }
+    qWarning() << QString("LibraryRoots::%1 - SQL Error: %2 (Query: %3)")
+                      .arg(operation, query.lastError().text(), query.lastQuery());
+    return false;
+}
+
+} // namespace
+
+std::atomic<quint64> LibraryRoots::s_generation{0};
+
+LibraryRoots::LibraryRoots(const QSqlDatabase& database)
+    : m_database(database)
+{
+}
+
+qint64 LibraryRoots::hashPath(const QString& relativePath)
+{
+    quint64 hash = 14695981039346656037ULL;
+    for (const char byte : relativePath.toUtf8()) {
+        hash ^= quint8(byte);
+        hash *= 1099511628211ULL;
+    }
+    return qint64(hash);
+}
+
+QString LibraryRoots::normalizedRoot(const QString& path)
+{
+    const QString trimmed = path.trimmed();
+    if (trimmed.isEmpty()) {
+        return QString();
+    }
+    // The same cleaning as MusicRepository::sanitizePath(), so the prefixes match
+    QString root = QDir::cleanPath(QDir::toNativeSeparators(trimmed));
+    if (!root.endsWith('/')) {
+        root += '/';
+    }
+    return root;
+}
+
+bool LibraryRoots::ensure()
+{
+    QSqlQuery query(m_database);
+    if (!execLogged(query, "ensure", "PRAGMA table_info(musics)")) {
+        return false;
+    }
+    QStringList columns;
+    while (query.next()) {
+        columns.append(query.value(1).toString());
+    }
+    if (columns.isEmpty()) {
+        qWarning() << "LibraryRoots::ensure - The musics table does not exist";
+        return false;
+    }
+
+    QStringList statements = {
+        "CREATE TABLE IF NOT EXISTS library_roots (id INTEGER PRIMARY KEY, "
+        "path TEXT NOT NULL UNIQUE)",
+        "INSERT OR IGNORE INTO library_roots (id, path) VALUES (0, '')"
+    };
+    const QList<QPair<QString, QString>> added = {
+        {"root_id", "INTEGER"}, {"rel_path", "TEXT"}, {"path_hash", "INTEGER"}
+    };
+    for (const auto& column : added) {
+        if (!columns.contains(column.first)) {
+            statements.append(
+                QString("ALTER TABLE musics ADD COLUMN %1 %2").arg(column.first, column.second));
+        }
+    }
+    statements.append("CREATE INDEX IF NOT EXISTS idx_musics_location "
+                      "ON musics(root_id, path_hash)");
+    // A path set without its location no longer matches it; forget the location then
+    statements.append("CREATE TRIGGER IF NOT EXISTS musics_location_path "
+                      "AFTER UPDATE OF path ON musics WHEN new.path_hash IS NOT NULL "
+                      "AND new.path IS NOT (SELECT path FROM library_roots "
+                      "WHERE id = new.root_id) || new.rel_path BEGIN "
+                      "UPDATE musics SET root_id = NULL, rel_path = NULL, path_hash = NULL "
+                      "WHERE id = new.id; END");
+
+    Savepoint savepoint(m_database, "library_roots_setup");
+    if (!savepoint.isOpen()) {
+        return false;
+    }
+    for (const QString& sql : std::as_const(statements)) {
+        if (!execLogged(query, "ensure", sql)) {
+            return false;
+        }
+    }
+    if (!savepoint.release() || !loadRoots()) {
+        return false;
+    }
+
+    const int filled = backfill();
+    if (filled < 0) {
+        return false;
+    }
+    if (filled > 0) {
+        qDebug() << "LibraryRoots: located" << filled << "tracks under" << m_roots.size()
+                 << "roots";
+    }
+    m_ready = true;
+    return true;
+}
+
+QMap<int, QString> LibraryRoots::roots() const
+{
+    QMap<int, QString> roots = m_roots;
+    roots.remove(NO_ROOT);
+    return roots;
+}
+
+LibraryRoots::Location LibraryRoots::locate(const QString& path) const
+{
+    Location location;
+    int rootLength = 0;
+    for (auto it = m_roots.cbegin(); it != m_roots.cend(); ++it) {
+        if (it.value().size() > rootLength && path.startsWith(it.value())) {
+            location.rootId = it.key();
+            rootLength = it.value().size();
+        }
+    }
+    location.relativePath = path.mid(rootLength);
+    location.hash = hashPath(location.relativePath);
+    return location;
+}
+
+int LibraryRoots::addRoot(const QString& path)
+{
+    const QString root = normalizedRoot(path);
+    if (!m_ready || root.isEmpty()) {
+        return -1;
+    }
+    refresh();
+    const Location holder = locate(root);
+    if (holder.rootId != NO_ROOT) {
+        return holder.rootId;
+    }
+
+    Savepoint savepoint(m_database, "library_roots_add");
+    if (!savepoint.isOpen()) {
+        return -1;
+    }
+    QSqlQuery query(m_database);
+    query.prepare("INSERT INTO library_roots (path) VALUES (?)");
+    query.addBindValue(root);
+    if (!execLogged(query, "addRoot")) {
+        return -1;
+    }
+    const int rootId = query.lastInsertId().toInt();
+    if (!moveTracksInto(rootId, root) || !savepoint.release()) {
+        return -1;
+    }
+    m_roots.insert(rootId, root);
+    m_generation = ++s_generation;
+    qDebug() << "LibraryRoots: added root" << rootId << root;
+    return rootId;
+}
+
+bool LibraryRoots::moveTracksInto(int rootId, const QString& rootPath)
+{
+    // Only tracks outside every root can be under a root that was in none
+    QSqlQuery select(m_database);
+    select.setForwardOnly(true);
+    select.prepare("SELECT id, path FROM musics WHERE root_id = ? AND substr(path, 1, ?) = ?");
+    select.addBindValue(NO_ROOT);
+    select.addBindValue(rootPath.size());
+    select.addBindValue(rootPath);
+    if (!execLogged(select, "addRoot")) {
+        return false;
+    }
+
+    QSqlQuery update(m_database);
+    update.prepare("UPDATE musics SET root_id = ?, rel_path = ?, path_hash = ? WHERE id = ?");
+    while (select.next()) {
+        const QString relativePath = select.value(1).toString().mid(rootPath.size());
+        update.addBindValue(rootId);
+        update.addBindValue(relativePath);
+        update.addBindValue(hashPath(relativePath));
+        update.addBindValue(select.value(0));
+        if (!execLogged(update, "addRoot")) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool LibraryRoots::relocateRoot(int rootId, const QString& newPath)
+{
+    const QString newRoot = normalizedRoot(newPath);
+    if (m_ready) {
+        refresh();
+    }
+    if (!m_ready || rootId == NO_ROOT || !m_roots.contains(rootId) || newRoot.isEmpty()) {
+        return false;
+    }
+    const QString oldRoot = m_roots.value(rootId);
+    if (newRoot == oldRoot) {
+        return true;
+    }
+
+    Savepoint savepoint(m_database, "library_roots_relocate");
+    // Tracks without a location would keep the old path
+    if (!savepoint.isOpen() || backfill() < 0) {
+        return false;
+    }
+
+    QSqlQuery query(m_database);
+    query.prepare("UPDATE library_roots SET path = ? WHERE id = ?");
+    QStringList moved;
+    for (auto it = m_roots.cbegin(); it != m_roots.cend(); ++it) {
+        if (it.key() == NO_ROOT || !it.value().startsWith(oldRoot)) {
+            continue;
+        }
+        query.addBindValue(newRoot + it.value().mid(oldRoot.size()));
+        query.addBindValue(it.key());
+        if (!execLogged(query, "relocateRoot")) {
+            return false;
+        }
+        moved.append(QString::number(it.key()));
+    }
+
+    // The location stays as it is, so musics_location_path finds the new path consistent
+    if (!execLogged(query, "relocateRoot",
+                    QString("UPDATE musics SET path = (SELECT r.path FROM library_roots r "
+                            "WHERE r.id = musics.root_id) || rel_path WHERE root_id IN (%1)")
+                        .arg(moved.join(", ")))) {
+        return false;
+    }
+    const int tracks = query.numRowsAffected();
+    ++s_generation;
+    if (!savepoint.release() || !loadRoots()) {
+        return false;
+    }
+    qDebug() << "LibraryRoots: moved" << oldRoot << "to" << newRoot << "with" << tracks
+             << "tracks";
+    return true;
+}
+
+int LibraryRoots::backfill()
+{
+    QSqlQuery select(m_database);
+    select.setForwardOnly(true);
+    select.prepare("SELECT id, path FROM musics WHERE path_hash IS NULL AND path IS NOT NULL "
+                   "LIMIT ?");
+    QSqlQuery update(m_database);
+    update.prepare("UPDATE musics SET root_id = ?, rel_path = ?, path_hash = ? WHERE id = ?");
+
+    int filled = 0;
+    while (true) {
+        select.addBindValue(BACKFILL_CHUNK);
+        if (!execLogged(select, "backfill")) {
+            return -1;
+        }
+        QList<QPair<QVariant, QString>> rows;
+        while (select.next()) {
+            rows.append({select.value(0), select.value(1).toString()});
+        }
+        select.finish();
+        if (rows.isEmpty()) {
+            return filled;
+        }
+
+        // One savepoint per chunk, so readers get a turn between them
+        Savepoint savepoint(m_database, "library_roots_backfill");
+        if (!savepoint.isOpen()) {
+            return -1;
+        }
+        for (const auto& row : std::as_const(rows)) {
+            const Location location = locate(row.second);
+            update.addBindValue(location.rootId);
+            update.addBindValue(location.relativePath);
+            update.addBindValue(location.hash);
+            update.addBindValue(row.first);
+            if (!execLogged(update, "backfill")) {
+                return -1;
+            }
+        }
+        if (!savepoint.release()) {
+            return -1;
+        }
+        filled += rows.size();
+    }
+}
+
+bool LibraryRoots::refresh()
+{
+    return m_ready && m_generation != s_generation.load() && loadRoots();
+}
+
+bool LibraryRoots::reload()
+{
+    if (!m_ready) {
+        return false;
+    }
+    const QMap<int, QString> before = m_roots;
+    return loadRoots() && m_roots != before;
+}
+
+bool LibraryRoots::loadRoots()
+{
+    // Taken before the read, so a root added meanwhile is read again next time
+    const quint64 generation = s_generation.load();
+    QSqlQuery query(m_database);
+    if (!execLogged(query, "loadRoots", "SELECT id, path FROM library_roots")) {
+        return false;
+    }
+    m_roots.clear();
+    while (query.next()) {
+        m_roots.insert(query.value(0).toInt(), query.value(1).toString());
+    }
+    m_generation = generation;
+    return true;
+}
@@ -0,0 +1,142 @@
+#ifndef LIBRARYROOTS_H
+#define LIBRARYROOTS_H
+
+#include <QMap>
+#include <QSqlDatabase>
+#include <QString>
+#include <atomic>
+
+/**
+ * @brief Library root directories, and the tracks' paths within them
+ *
+ * Every musics row held an absolute path of a hundred bytes or so, most of
+ * it the same mount point, and looked tracks up by that string through an
+ * index of those strings. LibraryRoots keeps the directories the library
+ * lives under once each, in a library_roots table, and gives every track a
+ * root_id, its rel_path within the root and a path_hash of that relative
+ * path. Lookups go through idx_musics_location on (root_id, path_hash), a
+ * few bytes per entry, and compare rel_path only on the row found.
+ *
+ * Root 0 has an empty path and holds the tracks outside every root, with
+ * their whole path as rel_path. ensure() adds the columns to an existing
+ * library and fills them, BACKFILL_CHUNK rows at a time.
+ *
+ * The absolute path column stays: the older SQL in the window, the change
+ * log and the other tables still know tracks by it. A trigger forgets the
+ * location of a row whose path is set by anything that does not also set
+ * the location; such a row is found by its path until ensure() fills it
+ * again. Moving a library to a new mount point is relocateRoot(): the root
+ * changes in one row, and the paths are rewritten in a single statement
+ * that leaves every hash as it was.
+ *
+ * Each instance keeps the roots in memory. Roots added or moved through
+ * any instance of the process are picked up by the others on their next
+ * refresh(); reload() reads them again for changes made by another
+ * process, such as the daemon.
+ *
+ * @example
+ * @code
+ * LibraryRoots roots(database);
+ * roots.ensure();
+ * const int music = roots.addRoot("/srv/music");
+ * LibraryRoots::Location location = roots.locate("/srv/music/a/song.ogg");
+ * // location.rootId == music, location.relativePath == "a/song.ogg"
+ * roots.relocateRoot(music, "/mnt/nas/music");
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class LibraryRoots
+{
+public:
+    static constexpr int NO_ROOT = 0;             ///< Root of the tracks outside every root
+    static constexpr int BACKFILL_CHUNK = 500;    ///< Rows per backfill transaction
+
+    /**
+     * @brief Where a track is: its root, its path within it and the hash of that
+     */
+    struct Location {
+        int rootId = NO_ROOT;
+        QString relativePath;
+        qint64 hash = 0;
+    };
+
+    explicit LibraryRoots(const QSqlDatabase& database);
+
+    /**
+     * @brief Create the roots table and the location columns, and fill them
+     * @return true if tracks can be looked up by location
+     */
+    bool ensure();
+    bool isReady() const { return m_ready; }
+
+    /**
+     * @brief Paths of the roots by id, each ending in a separator; root 0 left out
+     */
+    QMap<int, QString> roots() const;
+
+    /**
+     * @brief Add a root and move the tracks under it into it
+     *
+     * A directory inside an existing root is not a root of its own: the id
+     * of the root holding it is returned.
+     * @return Id of the root, or -1 on failure
+     */
+    int addRoot(const QString& path);
+
+    /**
+     * @brief Move a root, and the roots inside it, to a new directory
+     *
+     * Only library_roots changes row by row; the absolute paths of the
+     * tracks follow in one UPDATE, in the same transaction.
+     * @return true if the root was moved
+     */
+    bool relocateRoot(int rootId, const QString& newPath);
+
+    /**
+     * @brief Split a path into the deepest root holding it and the rest
+     * @param path Absolute path, as stored in musics.path
+     */
+    Location locate(const QString& path) const;
+
+    /**
+     * @brief Pick up the roots another instance of this process added or moved
+     * @return true if the roots were read again
+     */
+    bool refresh();
+
+    /**
+     * @brief Read the roots again from library_roots
+     * @return true if they differ from the ones held before
+     */
+    bool reload();
+
+    /**
+     * @brief Fill the location of the tracks that have none
+     * @return Rows filled, or -1 on failure
+     */
+    int backfill();
+
+    /**
+     * @brief 64 bit FNV-1a of a relative path, stable across releases and platforms
+     */
+    static qint64 hashPath(const QString& relativePath);
+
+    /**
+     * @brief A directory cleaned up and ending in a separator, as roots are stored
+     */
+    static QString normalizedRoot(const QString& path);
+
+private:
+    bool loadRoots();
+    bool moveTracksInto(int rootId, const QString& rootPath);
+
+    QSqlDatabase m_database;
+    QMap<int, QString> m_roots;
+    quint64 m_generation = 0;
+    bool m_ready = false;
+
+    static std::atomic<quint64> s_generation;   ///< Bumped whenever a root is added or moved
+};
+
+#endif // LIBRARYROOTS_H
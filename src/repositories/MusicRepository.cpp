@@ -1,4 +1,6 @@
 #include "MusicRepository.h"
+#include "Savepoint.h"
+#include "../services/QueryTimer.h"
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QVariant>
@@ -9,10 +11,33 @@
 #include <QDateTime>
 #include <QMutexLocker>
 #include <QCoreApplication>
+#include <QRegularExpression>
+#include <QThread>
+#include <QThreadPool>
+#include <algorithm>
+
+namespace {
+
+// Hashing is mostly waiting for the disk, so a few more threads than cores help
+void hashMissingContent(QList<MusicItem>& items, const MusicRepository::ContentHasher& hasher)
+{
+    QThreadPool pool;
+    pool.setMaxThreadCount(QThread::idealThreadCount() * 2);
+    MusicItem* data = items.data();
+    for (qsizetype i = 0; i < items.size(); ++i) {
+        if (data[i].contentHash.isEmpty() && !data[i].path.isEmpty()) {
+            pool.start([&hasher, item = data + i]() { item->contentHash = hasher(item->path); });
+        }
+    }
+    pool.waitForDone();
+}
+
+} // namespace
 
 MusicRepository::MusicRepository(QSqlDatabase& database, QObject* parent)
     : QObject(parent)
     , m_database(database)
+    , m_libraryRoots(database)
 {
     // Initialize mime database for file type detection
     // Cache will be initialized on first use
@@ -35,23 +60,20 @@ bool MusicRepository::addMusic(const MusicItem& music)
         return false;
     }
     
-    // Check if path already exists (inline to avoid recursive mutex lock)
-    {
-        QSqlQuery checkQuery(m_database);
-        checkQuery.prepare("SELECT COUNT(*) as count FROM musics WHERE path = ?");
-        checkQuery.addBindValue(sanitizePath(music.path));
-        
-        if (checkQuery.exec() && checkQuery.next() && checkQuery.value("count").toInt() > 0) {
-            QString error = QString("Music file already exists in database: %1").arg(music.path);
-            logError("addMusic", error);
-            emit operationError("addMusic", error);
-            return false;
-        }
+    const QString path = sanitizePath(music.path);
+    if (findIdByPath(path) != -1) {
+        QString error = QString("Music file already exists in database: %1").arg(music.path);
+        logError("addMusic", error);
+        emit operationError("addMusic", error);
+        return false;
     }
     
+    const bool located = libraryRootsReady();
     QSqlQuery query(m_database);
-    query.prepare("INSERT INTO musics (artist, song, genre1, genre2, country, published_date, path, time, played_times, last_played) "
-                  "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+    query.prepare(QString("INSERT INTO musics (artist, song, genre1, genre2, country, published_date, path, time, played_times, last_played%1) "
+                          "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?%2)")
+                      .arg(located ? ", root_id, rel_path, path_hash" : "",
+                           located ? ", ?, ?, ?" : ""));
     
     query.addBindValue(music.artist);
     query.addBindValue(music.song);
@@ -59,10 +81,13 @@ bool MusicRepository::addMusic(const MusicItem& music)
     query.addBindValue(music.genre2);
     query.addBindValue(music.country);
     query.addBindValue(music.publishedDate);
-    query.addBindValue(sanitizePath(music.path));
+    query.addBindValue(path);
     query.addBindValue(music.time);
     query.addBindValue(music.playedTimes);
     query.addBindValue(music.lastPlayed);
+    if (located) {
+        bindLocation(query, path);
+    }
     
     if (!executeQuery(query, "addMusic")) {
         return false;
@@ -74,10 +99,6 @@ bool MusicRepository::addMusic(const MusicItem& music)
     
     emit musicAdded(addedMusic);
     
-    // Invalidate stats cache
-    QMutexLocker statsLocker(&m_statsMutex);
-    m_statsLastUpdated = QDateTime();
-    
     return true;
 }
 
@@ -100,21 +121,27 @@ bool MusicRepository::updateMusic(const MusicItem& music)
         return false;
     }
     
+    const bool located = libraryRootsReady();
     QSqlQuery query(m_database);
-    query.prepare("UPDATE musics SET artist = ?, song = ?, genre1 = ?, genre2 = ?, "
-                  "country = ?, published_date = ?, path = ?, time = ?, "
-                  "played_times = ?, last_played = ? WHERE id = ?");
+    query.prepare(QString("UPDATE musics SET artist = ?, song = ?, genre1 = ?, genre2 = ?, "
+                          "country = ?, published_date = ?, path = ?, time = ?, "
+                          "played_times = ?, last_played = ?%1 WHERE id = ?")
+                      .arg(located ? ", root_id = ?, rel_path = ?, path_hash = ?" : ""));
     
+    const QString path = sanitizePath(music.path);
     query.addBindValue(music.artist);
     query.addBindValue(music.song);
     query.addBindValue(music.genre1);
     query.addBindValue(music.genre2);
     query.addBindValue(music.country);
     query.addBindValue(music.publishedDate);
-    query.addBindValue(sanitizePath(music.path));
+    query.addBindValue(path);
     query.addBindValue(music.time);
     query.addBindValue(music.playedTimes);
     query.addBindValue(music.lastPlayed);
+    if (located) {
+        bindLocation(query, path);
+    }
     query.addBindValue(music.id);
     
     if (!executeQuery(query, "updateMusic")) {
@@ -130,10 +157,6 @@ bool MusicRepository::updateMusic(const MusicItem& music)
     
     emit musicUpdated(music);
     
-    // Invalidate stats cache
-    QMutexLocker statsLocker(&m_statsMutex);
-    m_statsLastUpdated = QDateTime();
-    
     return true;
 }
 
@@ -165,10 +188,6 @@ bool MusicRepository::deleteMusic(int musicId)
     
     emit musicDeleted(musicId);
     
-    // Invalidate stats cache
-    QMutexLocker statsLocker(&m_statsMutex);
-    m_statsLastUpdated = QDateTime();
-    
     return true;
 }
 
@@ -190,31 +209,30 @@ MusicItem MusicRepository::getMusicById(int musicId)
     }
     
     if (query.next()) {
-        QVariantMap map;
-        map["id"] = query.value("id");
-        map["artist"] = query.value("artist");
-        map["song"] = query.value("song");
-        map["genre1"] = query.value("genre1");
-        map["genre2"] = query.value("genre2");
-        map["country"] = query.value("country");
-        map["published_date"] = query.value("published_date");
-        map["path"] = query.value("path");
-        map["time"] = query.value("time");
-        map["played_times"] = query.value("played_times");
-        map["last_played"] = query.value("last_played");
-        
-        return MusicItem::fromVariantMap(map);
+        return musicFromRow(query);
     }
     
     return MusicItem(); // Not found
 }
 
 QList<MusicItem> MusicRepository::getAllMusic(int limit, int offset)
+{
+    QList<MusicItem> results;
+    
+    forEachMusic([&results](const MusicItem& item) {
+        results.append(item);
+        return true;
+    }, limit, offset);
+    
+    return results;
+}
+
+int MusicRepository::forEachMusic(const MusicVisitor& visitor, int limit, int offset)
 {
     QMutexLocker locker(&m_mutex);
     
     QString queryString = "SELECT id, artist, song, genre1, genre2, country, published_date, "
-                         "path, time, played_times, last_played FROM musics ORDER BY artist, song";
+                         "path, time, played_times, last_played FROM musics ORDER BY artist, song, id";
     
     if (limit > 0) {
         queryString += QString(" LIMIT %1").arg(limit);
@@ -223,30 +241,127 @@ QList<MusicItem> MusicRepository::getAllMusic(int limit, int offset)
         }
     }
     
+    ensureSortIndex();
+    
+    // Forward-only keeps the driver from caching rows already visited
+    QSqlQuery query(m_database);
+    query.setForwardOnly(true);
+    query.prepare(queryString);
+    
+    if (!executeQuery(query, "forEachMusic")) {
+        return -1;
+    }
+    
+    int visited = 0;
+    while (query.next()) {
+        ++visited;
+        if (!visitor(musicFromRow(query))) {
+            break;
+        }
+    }
+    
+    return visited;
+}
+
+QList<MusicItem> MusicRepository::getMusicPage(const QString& whereClause, const QVariantList& bindValues,
+                                               const QString& orderByClause, int limit, int offset,
+                                               QSqlDatabase connection)
+{
+    QList<MusicItem> results;
+    if (limit <= 0) {
+        return results;
+    }
+    
+    QString queryString = "SELECT id, artist, song, genre1, genre2, country, published_date, "
+                         "path, time, played_times, last_played FROM musics";
+    if (!whereClause.isEmpty()) {
+        queryString += " WHERE " + whereClause;
+    }
+    queryString += " ORDER BY " + (orderByClause.isEmpty() ? QString("id") : orderByClause + ", id");
+    queryString += QString(" LIMIT %1 OFFSET %2").arg(limit).arg(std::max(0, offset));
+    
+    // A connection of the caller's own needs no lock; the shared one does
+    const bool shared = !connection.isValid();
+    QMutexLocker locker(shared ? &m_mutex : nullptr);
+    
+    QSqlQuery query(shared ? m_database : connection);
+    query.setForwardOnly(true);
+    query.prepare(queryString);
+    for (const QVariant& value : bindValues) {
+        query.addBindValue(value);
+    }
+    
+    if (!executeQuery(query, "getMusicPage")) {
+        return results;
+    }
+    
+    results.reserve(limit);
+    while (query.next()) {
+        results.append(musicFromRow(query));
+    }
+    
+    return results;
+}
+
+int MusicRepository::countMusic(const QString& whereClause, const QVariantList& bindValues)
+{
+    QMutexLocker locker(&m_mutex);
+    
+    QString queryString = "SELECT COUNT(*) FROM musics";
+    if (!whereClause.isEmpty()) {
+        ensureFilterIndexes();
+        queryString += " WHERE " + whereClause;
+    }
+    
     QSqlQuery query(m_database);
     query.prepare(queryString);
+    for (const QVariant& value : bindValues) {
+        query.addBindValue(value);
+    }
+    
+    if (!executeQuery(query, "countMusic") || !query.next()) {
+        return -1;
+    }
+    
+    return query.value(0).toInt();
+}
+
+QList<MusicItem> MusicRepository::getMusicAfter(const MusicSortKey& lastSortKey, int lastId, int limit)
+{
+    QMutexLocker locker(&m_mutex);
     
     QList<MusicItem> results;
+    if (limit <= 0) {
+        return results;
+    }
+    
+    ensureSortIndex();
+    
+    QString queryString = "SELECT id, artist, song, genre1, genre2, country, published_date, "
+                          "path, time, played_times, last_played FROM musics";
+    if (lastId >= 0) {
+        queryString += " WHERE (artist, song, id) > (?, ?, ?)";
+    }
+    queryString += " ORDER BY artist, song, id LIMIT ?";
+    
+    QSqlQuery query(m_database);
+    query.setForwardOnly(true);
+    query.prepare(queryString);
+    
+    if (lastId >= 0) {
+        query.addBindValue(lastSortKey.artist);
+        query.addBindValue(lastSortKey.song);
+        query.addBindValue(lastId);
+    }
+    query.addBindValue(limit);
     
-    if (!executeQuery(query, "getAllMusic")) {
+    if (!executeQuery(query, "getMusicAfter")) {
         return results;
     }
     
+    results.reserve(limit);
     while (query.next()) {
-        QVariantMap map;
-        map["id"] = query.value("id");
-        map["artist"] = query.value("artist");
-        map["song"] = query.value("song");
-        map["genre1"] = query.value("genre1");
-        map["genre2"] = query.value("genre2");
-        map["country"] = query.value("country");
-        map["published_date"] = query.value("published_date");
-        map["path"] = query.value("path");
-        map["time"] = query.value("time");
-        map["played_times"] = query.value("played_times");
-        map["last_played"] = query.value("last_played");
-        
-        results.append(MusicItem::fromVariantMap(map));
+        results.append(musicFromRow(query));
     }
     
     return results;
@@ -287,7 +402,14 @@ QList<MusicItem> MusicRepository::searchMusic(const SearchCriteria& criteria)
         bindValues.append(QString("%%1%").arg(criteria.country));
     }
     
-    if (!criteria.searchText.isEmpty()) {
+    const QString matchExpression = (criteria.fullText && !criteria.searchText.isEmpty())
+                                        ? fullTextQuery(criteria.searchText)
+                                        : QString();
+    
+    if (!matchExpression.isEmpty() && fullTextIndexReady()) {
+        queryString += " AND rowid IN (SELECT rowid FROM musics_fts WHERE musics_fts MATCH ?)";
+        bindValues.append(matchExpression);
+    } else if (!criteria.searchText.isEmpty()) {
         queryString += " AND (artist LIKE ? OR song LIKE ? OR genre1 LIKE ? OR genre2 LIKE ?)";
         QString searchPattern = QString("%%1%").arg(criteria.searchText);
         bindValues.append(searchPattern);
@@ -325,25 +447,191 @@ QList<MusicItem> MusicRepository::searchMusic(const SearchCriteria& criteria)
     }
     
     while (query.next()) {
-        QVariantMap map;
-        map["id"] = query.value("id");
-        map["artist"] = query.value("artist");
-        map["song"] = query.value("song");
-        map["genre1"] = query.value("genre1");
-        map["genre2"] = query.value("genre2");
-        map["country"] = query.value("country");
-        map["published_date"] = query.value("published_date");
-        map["path"] = query.value("path");
-        map["time"] = query.value("time");
-        map["played_times"] = query.value("played_times");
-        map["last_played"] = query.value("last_played");
-        
-        results.append(MusicItem::fromVariantMap(map));
+        results.append(musicFromRow(query));
     }
     
     return results;
 }
 
+bool MusicRepository::isFullTextSearchAvailable()
+{
+    QMutexLocker locker(&m_mutex);
+    return fullTextIndexReady();
+}
+
+bool MusicRepository::ensureFullTextIndex(QSqlDatabase& database)
+{
+    QSqlQuery query(database);
+    if (!query.exec("SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = 'musics_fts'")) {
+        qWarning() << "MusicRepository::ensureFullTextIndex - SQL Error:" << query.lastError().text();
+        return false;
+    }
+    
+    if (query.next()) {
+        return true;
+    }
+    
+    const QString columns = "artist, song, genre1, genre2, path";
+    const QString newValues = "new.rowid, new.artist, new.song, new.genre1, new.genre2, new.path";
+    const QString oldValues = "old.rowid, old.artist, old.song, old.genre1, old.genre2, old.path";
+    
+    // Only the searched columns touch the index, so play count updates stay cheap
+    const QStringList statements = {
+        QString("CREATE VIRTUAL TABLE musics_fts USING fts5(%1, content='musics', "
+                "tokenize='unicode61 remove_diacritics 2', prefix='2 3')").arg(columns),
+        QString("CREATE TRIGGER musics_fts_insert AFTER INSERT ON musics BEGIN "
+                "INSERT INTO musics_fts(rowid, %1) VALUES (%2); END").arg(columns, newValues),
+        QString("CREATE TRIGGER musics_fts_delete AFTER DELETE ON musics BEGIN "
+                "INSERT INTO musics_fts(musics_fts, rowid, %1) VALUES ('delete', %2); END").arg(columns, oldValues),
+        QString("CREATE TRIGGER musics_fts_update AFTER UPDATE OF %1 ON musics BEGIN "
+                "INSERT INTO musics_fts(musics_fts, rowid, %1) VALUES ('delete', %2); "
+                "INSERT INTO musics_fts(rowid, %1) VALUES (%3); END").arg(columns, oldValues, newValues),
+        "INSERT INTO musics_fts(musics_fts) VALUES ('rebuild')"
+    };
+    
+    Savepoint savepoint(database, "musics_fts_setup");
+    if (!savepoint.isOpen()) {
+        return false;
+    }
+    
+    for (const QString& sql : statements) {
+        if (!query.exec(sql)) {
+            qWarning() << QString("MusicRepository::ensureFullTextIndex - SQL Error: %1 (Query: %2)")
+                              .arg(query.lastError().text(), sql);
+            return false;
+        }
+    }
+    
+    if (!savepoint.release()) {
+        return false;
+    }
+    
+    qDebug() << "MusicRepository: created full-text search index";
+    return true;
+}
+
+bool MusicRepository::ensureStatistics(QSqlDatabase& database)
+{
+    QSqlQuery query(database);
+    if (!query.exec("SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = 'musics_stats'")) {
+        qWarning() << "MusicRepository::ensureStatistics - SQL Error:" << query.lastError().text();
+        return false;
+    }
+    
+    if (query.next()) {
+        return true;
+    }
+    
+    // Counts per artist and genre tell when the first track of one is added
+    // and the last removed, which is when the distinct counts change; the
+    // same tables are the sorted dictionaries behind getAllArtists() and
+    // getAllGenres()
+    auto countTriggers = [](const QString& table, const QString& column, const QString& field,
+                            const QString& skip, bool counted) {
+        const QString added = QString("INSERT OR IGNORE INTO musics_stats_%1 SELECT new.%2, 0 "
+                                      "WHERE new.%2 IS NOT NULL%3; "
+                                      "UPDATE musics_stats_%1 SET tracks = tracks + 1 "
+                                      "WHERE %4 = new.%2;")
+                                  .arg(table, column, QString(skip).replace("%c", "new." + column), field);
+        const QString removed = QString("UPDATE musics_stats_%1 SET tracks = tracks - 1 "
+                                        "WHERE %3 = old.%2; "
+                                        "DELETE FROM musics_stats_%1 WHERE %3 = old.%2 AND tracks <= 0;")
+                                    .arg(table, column, field);
+        QStringList triggers = {
+            QString("CREATE TABLE musics_stats_%1 (%2 TEXT PRIMARY KEY, tracks INTEGER NOT NULL) WITHOUT ROWID")
+                .arg(table, field),
+            QString("INSERT INTO musics_stats_%1 SELECT %2, COUNT(*) FROM musics "
+                    "WHERE %2 IS NOT NULL%3 GROUP BY %2").arg(table, column, QString(skip).replace("%c", column)),
+            QString("CREATE TRIGGER musics_stats_%1_insert AFTER INSERT ON musics BEGIN %2 END")
+                .arg(table, added),
+            QString("CREATE TRIGGER musics_stats_%1_delete AFTER DELETE ON musics BEGIN %2 END")
+                .arg(table, removed),
+            QString("CREATE TRIGGER musics_stats_%1_update AFTER UPDATE OF %2 ON musics "
+                    "WHEN old.%2 IS NOT new.%2 BEGIN %3 %4 END").arg(table, column, removed, added)
+        };
+        if (counted) {
+            triggers += {
+                QString("CREATE TRIGGER musics_stats_%1_added AFTER INSERT ON musics_stats_%1 BEGIN "
+                        "UPDATE musics_stats SET %1 = %1 + 1; END").arg(table),
+                QString("CREATE TRIGGER musics_stats_%1_removed AFTER DELETE ON musics_stats_%1 BEGIN "
+                        "UPDATE musics_stats SET %1 = %1 - 1; END").arg(table)
+            };
+        }
+        return triggers;
+    };
+    
+    QStringList statements = {
+        "CREATE TABLE musics_stats (id INTEGER PRIMARY KEY CHECK (id = 1), "
+        "tracks INTEGER NOT NULL, artists INTEGER NOT NULL, genres INTEGER NOT NULL, "
+        "plays INTEGER NOT NULL)"
+    };
+    statements += countTriggers("artists", "artist", "artist", "", true);
+    statements += countTriggers("genres", "genre1", "genre", " AND %c != ''", true);
+    statements += countTriggers("genres2", "genre2", "genre", " AND %c != ''", false);
+    statements += {
+        "INSERT INTO musics_stats SELECT 1, COUNT(*), "
+        "(SELECT COUNT(*) FROM musics_stats_artists), (SELECT COUNT(*) FROM musics_stats_genres), "
+        "COALESCE(SUM(played_times), 0) FROM musics",
+        "CREATE TRIGGER musics_stats_insert AFTER INSERT ON musics BEGIN "
+        "UPDATE musics_stats SET tracks = tracks + 1, plays = plays + COALESCE(new.played_times, 0); END",
+        "CREATE TRIGGER musics_stats_delete AFTER DELETE ON musics BEGIN "
+        "UPDATE musics_stats SET tracks = tracks - 1, plays = plays - COALESCE(old.played_times, 0); END",
+        "CREATE TRIGGER musics_stats_plays AFTER UPDATE OF played_times ON musics "
+        "WHEN old.played_times IS NOT new.played_times BEGIN "
+        "UPDATE musics_stats SET plays = plays + COALESCE(new.played_times, 0) - COALESCE(old.played_times, 0); END"
+    };
+    
+    Savepoint savepoint(database, "musics_stats_setup");
+    if (!savepoint.isOpen()) {
+        return false;
+    }
+    
+    for (const QString& sql : std::as_const(statements)) {
+        if (!query.exec(sql)) {
+            qWarning() << QString("MusicRepository::ensureStatistics - SQL Error: %1 (Query: %2)")
+                              .arg(query.lastError().text(), sql);
+            return false;
+        }
+    }
+    
+    if (!savepoint.release()) {
+        return false;
+    }
+    
+    qDebug() << "MusicRepository: created the library statistics";
+    return true;
+}
+
+QString MusicRepository::durationSecondsSql()
+{
+    // CAST reads the leading digits, so CAST(time AS INTEGER) is the first
+    // field and the text after the first colon gives the second
+    return "(CASE WHEN instr(time, ':') = 0 THEN NULL "
+           "WHEN instr(substr(time, instr(time, ':') + 1), ':') > 0 "
+           "THEN CAST(time AS INTEGER) * 3600 + CAST(substr(time, instr(time, ':') + 1) AS INTEGER) * 60 "
+           "+ CAST(substr(time, instr(time, ':') + 4) AS INTEGER) "
+           "ELSE CAST(time AS INTEGER) * 60 + CAST(substr(time, instr(time, ':') + 1) AS INTEGER) END)";
+}
+
+QString MusicRepository::fullTextQuery(const QString& text)
+{
+    static const QRegularExpression separators(R"(\s+)");
+    static const QRegularExpression searchable(R"([\p{L}\p{N}])");
+    
+    QStringList terms;
+    const QStringList words = text.split(separators, Qt::SkipEmptyParts);
+    for (QString word : words) {
+        // Words made only of punctuation produce no tokens and would match nothing
+        if (!word.contains(searchable)) {
+            continue;
+        }
+        word.replace('"', "\"\"");
+        terms.append(QString("\"%1\"*").arg(word));
+    }
+    
+    return terms.join(' ');
+}
+
 QList<MusicItem> MusicRepository::getMusicByGenre(const QString& genre, bool useGenre2)
 {
     SearchCriteria criteria;
@@ -369,20 +657,7 @@ QList<MusicItem> MusicRepository::getMusicByGenre(const QString& genre, bool use
         }
         
         while (query.next()) {
-            QVariantMap map;
-            map["id"] = query.value("id");
-            map["artist"] = query.value("artist");
-            map["song"] = query.value("song");
-            map["genre1"] = query.value("genre1");
-            map["genre2"] = query.value("genre2");
-            map["country"] = query.value("country");
-            map["published_date"] = query.value("published_date");
-            map["path"] = query.value("path");
-            map["time"] = query.value("time");
-            map["played_times"] = query.value("played_times");
-            map["last_played"] = query.value("last_played");
-            
-            results.append(MusicItem::fromVariantMap(map));
+            results.append(musicFromRow(query));
         }
         
         return results;
@@ -391,6 +666,76 @@ QList<MusicItem> MusicRepository::getMusicByGenre(const QString& genre, bool use
     return searchMusic(criteria);
 }
 
+int MusicRepository::countMusicByGenre(const QString& genre)
+{
+    QMutexLocker locker(&m_mutex);
+    
+    ensureFilterIndexes();
+    QSqlQuery* query = preparedQuery("SELECT COUNT(*) FROM musics WHERE genre1 = ? COLLATE NOCASE",
+                                     "countMusicByGenre");
+    if (!query) {
+        return -1;
+    }
+    query->addBindValue(genre);
+    
+    if (!executeQuery(*query, "countMusicByGenre") || !query->next()) {
+        return -1;
+    }
+    
+    const int count = query->value(0).toInt();
+    query->finish();
+    return count;
+}
+
+QString MusicRepository::genreCondition(const QString& genre1, const QString& genre2,
+                                        QVariantList& bindValues)
+{
+    bindValues.clear();
+    QStringList conditions;
+    if (!genre1.isEmpty()) {
+        conditions << "genre1 = ? COLLATE NOCASE";
+        bindValues << genre1;
+    }
+    if (!genre2.isEmpty()) {
+        conditions << "genre2 = ? COLLATE NOCASE";
+        bindValues << genre2;
+    }
+    if (!conditions.isEmpty()) {
+        QMutexLocker locker(&m_mutex);
+        ensureFilterIndexes();
+    }
+    return conditions.join(" AND ");
+}
+
+QStringList MusicRepository::getRandomPathsByGenre(const QString& genre, int limit)
+{
+    QStringList paths;
+    if (limit <= 0) {
+        return paths;
+    }
+    
+    QMutexLocker locker(&m_mutex);
+    
+    QSqlQuery* query = preparedQuery("SELECT path FROM musics WHERE genre1 = ? COLLATE NOCASE "
+                                     "ORDER BY random() LIMIT ?",
+                                     "getRandomPathsByGenre");
+    if (!query) {
+        return paths;
+    }
+    query->addBindValue(genre);
+    query->addBindValue(limit);
+    
+    if (!executeQuery(*query, "getRandomPathsByGenre")) {
+        return paths;
+    }
+    
+    while (query->next()) {
+        paths.append(query->value(0).toString());
+    }
+    query->finish();
+    return paths;
+}
+
 QList<MusicItem> MusicRepository::getMusicByArtist(const QString& artist)
 {
     SearchCriteria criteria;
@@ -398,82 +743,206 @@ QList<MusicItem> MusicRepository::getMusicByArtist(const QString& artist)
     return searchMusic(criteria);
 }
 
-int MusicRepository::addMusicBatch(const QList<MusicItem>& musicList)
+QList<MusicItem> MusicRepository::getMostPlayedMusic(int limit, const QString& genre)
 {
-    if (musicList.isEmpty()) {
-        return 0;
+    QMutexLocker locker(&m_mutex);
+    
+    QList<MusicItem> results;
+    if (limit <= 0) {
+        return results;
     }
     
+    QString queryString = "SELECT id, artist, song, genre1, genre2, country, published_date, "
+                         "path, time, played_times, last_played FROM musics";
+    if (!genre.isEmpty()) {
+        queryString += " WHERE genre1 = ? OR genre2 = ?";
+    }
+    queryString += " ORDER BY played_times DESC, id LIMIT ?";
+    
+    QSqlQuery query(m_database);
+    query.setForwardOnly(true);
+    query.prepare(queryString);
+    if (!genre.isEmpty()) {
+        query.addBindValue(genre);
+        query.addBindValue(genre);
+    }
+    query.addBindValue(limit);
+    
+    if (!executeQuery(query, "getMostPlayedMusic")) {
+        return results;
+    }
+    
+    while (query.next()) {
+        results.append(musicFromRow(query));
+    }
+    
+    return results;
+}
+
+QList<MusicItem> MusicRepository::getRecentlyPlayedMusic(int limit)
+{
     QMutexLocker locker(&m_mutex);
     
-    // Start transaction
-    if (!m_database.transaction()) {
-        logError("addMusicBatch", "Failed to start transaction");
-        emit operationError("addMusicBatch", "Failed to start transaction");
+    QList<MusicItem> results;
+    if (limit <= 0) {
+        return results;
+    }
+    
+    QSqlQuery query(m_database);
+    query.setForwardOnly(true);
+    query.prepare("SELECT id, artist, song, genre1, genre2, country, published_date, "
+                  "path, time, played_times, last_played FROM musics "
+                  "WHERE last_played IS NOT NULL AND last_played != '' "
+                  "ORDER BY last_played DESC, id LIMIT ?");
+    query.addBindValue(limit);
+    
+    if (!executeQuery(query, "getRecentlyPlayedMusic")) {
+        return results;
+    }
+    
+    while (query.next()) {
+        results.append(musicFromRow(query));
+    }
+    
+    return results;
+}
+
+int MusicRepository::addMusicBatch(const QList<MusicItem>& musicList)
+{
+    if (musicList.isEmpty()) {
         return 0;
     }
     
     int successCount = 0;
-    QSqlQuery query(m_database);
-    query.prepare("INSERT INTO musics (artist, song, genre1, genre2, country, published_date, path, time, played_times, last_played) "
-                  "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
-    
-    for (const MusicItem& music : musicList) {
-        // Validate each item
-        QString validationError = validateMusicItem(music);
-        if (!validationError.isEmpty()) {
-            qDebug() << "Skipping invalid music item:" << validationError;
-            continue;
+    QSet<QString> addedPaths;
+    QSet<QString> addedHashes;
+    
+    ContentHasher hasher;
+    {
+        QMutexLocker locker(&m_mutex);
+        hasher = m_contentHasher;
+    }
+    
+    for (int start = 0; start < musicList.size(); start += IMPORT_CHUNK_SIZE) {
+        const int end = std::min(start + IMPORT_CHUNK_SIZE, static_cast<int>(musicList.size()));
+        
+        // Files are read before locking, so readers are not held up by the disk
+        QList<MusicItem> chunk = musicList.mid(start, end - start);
+        if (hasher) {
+            hashMissingContent(chunk, hasher);
+        }
+        
+        // Lock per chunk so readers get a turn between commits
+        QMutexLocker locker(&m_mutex);
+        ensurePathIndex();
+        if (!m_contentHashReady) {
+            m_contentHashReady = ensureContentHashColumn(m_database);
         }
         
-        // Check if path already exists (inline to avoid recursive mutex lock)
-        {
-            QSqlQuery checkQuery(m_database);
-            checkQuery.prepare("SELECT COUNT(*) as count FROM musics WHERE path = ?");
-            checkQuery.addBindValue(sanitizePath(music.path));
+        QStringList chunkPaths;
+        QStringList chunkHashes;
+        chunkPaths.reserve(chunk.size());
+        for (const MusicItem& music : std::as_const(chunk)) {
+            chunkPaths.append(sanitizePath(music.path));
+            if (!music.contentHash.isEmpty()) {
+                chunkHashes.append(music.contentHash);
+            }
+        }
+        QSet<QString> knownPaths = findExistingPaths(chunkPaths);
+        QSet<QString> knownHashes = m_contentHashReady ? findExistingContentHashes(chunkHashes)
+                                                       : QSet<QString>();
+        
+        // Start transaction
+        if (!m_database.transaction()) {
+            logError("addMusicBatch", "Failed to start transaction");
+            emit operationError("addMusicBatch", "Failed to start transaction");
+            return successCount;
+        }
+        
+        QString columns = "artist, song, genre1, genre2, country, published_date, path, time, played_times, last_played";
+        QString values = "?, ?, ?, ?, ?, ?, ?, ?, ?, ?";
+        if (m_contentHashReady) {
+            columns += ", content_hash";
+            values += ", ?";
+        }
+        const bool located = libraryRootsReady();
+        if (located) {
+            columns += ", root_id, rel_path, path_hash";
+            values += ", ?, ?, ?";
+        }
+        QSqlQuery query(m_database);
+        query.prepare(QString("INSERT INTO musics (%1) VALUES (%2)").arg(columns, values));
+        
+        QList<MusicItem> added;
+        for (int i = 0; i < chunk.size(); ++i) {
+            const MusicItem& music = chunk.at(i);
+            const QString& path = chunkPaths.at(i);
+            
+            // Validate each item
+            QString validationError = validateMusicItem(music);
+            if (!validationError.isEmpty()) {
+                qDebug() << "Skipping invalid music item:" << validationError;
+                continue;
+            }
             
-            if (checkQuery.exec() && checkQuery.next() && checkQuery.value("count").toInt() > 0) {
+            if (knownPaths.contains(path) || addedPaths.contains(path)) {
                 qDebug() << "Skipping duplicate path:" << music.path;
                 continue;
             }
+            
+            const QString& hash = music.contentHash;
+            if (!hash.isEmpty() && (knownHashes.contains(hash) || addedHashes.contains(hash))) {
+                qDebug() << "Skipping duplicate content:" << music.path;
+                continue;
+            }
+            
+            query.addBindValue(music.artist);
+            query.addBindValue(music.song);
+            query.addBindValue(music.genre1);
+            query.addBindValue(music.genre2);
+            query.addBindValue(music.country);
+            query.addBindValue(music.publishedDate);
+            query.addBindValue(path);
+            query.addBindValue(music.time);
+            query.addBindValue(music.playedTimes);
+            query.addBindValue(music.lastPlayed);
+            if (m_contentHashReady) {
+                query.addBindValue(hash.isEmpty() ? QVariant() : QVariant(hash));
+            }
+            if (located) {
+                bindLocation(query, path);
+            }
+            
+            if (query.exec()) {
+                MusicItem addedMusic = music;
+                addedMusic.id = query.lastInsertId().toInt();
+                added.append(addedMusic);
+                addedPaths.insert(path);
+                if (!hash.isEmpty()) {
+                    addedHashes.insert(hash);
+                }
+            } else {
+                logError("addMusicBatch", QString("Failed to add music item: %1 - %2")
+                        .arg(music.artist, music.song), query.lastError().text());
+            }
         }
         
-        query.addBindValue(music.artist);
-        query.addBindValue(music.song);
-        query.addBindValue(music.genre1);
-        query.addBindValue(music.genre2);
-        query.addBindValue(music.country);
-        query.addBindValue(music.publishedDate);
-        query.addBindValue(sanitizePath(music.path));
-        query.addBindValue(music.time);
-        query.addBindValue(music.playedTimes);
-        query.addBindValue(music.lastPlayed);
+        // Commit transaction
+        if (!m_database.commit()) {
+            m_database.rollback();
+            logError("addMusicBatch", "Failed to commit transaction");
+            emit operationError("addMusicBatch", "Failed to commit transaction");
+            return successCount;
+        }
         
-        if (query.exec()) {
-            successCount++;
-            
-            // Emit signal for each added item
-            MusicItem addedMusic = music;
-            addedMusic.id = query.lastInsertId().toInt();
+        successCount += added.size();
+        
+        // Announce items only once they are committed
+        for (const MusicItem& addedMusic : std::as_const(added)) {
             emit musicAdded(addedMusic);
-        } else {
-            logError("addMusicBatch", QString("Failed to add music item: %1 - %2")
-                    .arg(music.artist, music.song), query.lastError().text());
         }
     }
     
-    // Commit transaction
-    if (!m_database.commit()) {
-        m_database.rollback();
-        logError("addMusicBatch", "Failed to commit transaction");
-        emit operationError("addMusicBatch", "Failed to commit transaction");
-        return 0;
-    }
-    
-    // Invalidate stats cache
-    QMutexLocker statsLocker(&m_statsMutex);
-    m_statsLastUpdated = QDateTime();
-    
     return successCount;
 }
 
@@ -506,25 +975,36 @@ int MusicRepository::importFromDirectory(const QString& directoryPath, bool recu
         return 0;
     }
     
+    // Find files already in the library up front, so their metadata is never read
+    QSet<QString> knownPaths;
+    {
+        QStringList sanitizedPaths;
+        sanitizedPaths.reserve(audioFiles.size());
+        for (const QString& filePath : std::as_const(audioFiles)) {
+            sanitizedPaths.append(sanitizePath(filePath));
+        }
+        
+        QMutexLocker locker(&m_mutex);
+        ensurePathIndex();
+        if (libraryRootsReady()) {
+            m_libraryRoots.addRoot(sanitizePath(directoryPath));
+        }
+        knownPaths = findExistingPaths(sanitizedPaths);
+    }
+    
     // Process files in batches
     QList<MusicItem> musicBatch;
     int processed = 0;
     int imported = 0;
-    const int batchSize = 50; // Process in batches of 50
+    const int batchSize = IMPORT_CHUNK_SIZE;
     
     for (const QString& filePath : audioFiles) {
         emit importProgress(processed, audioFiles.size(), filePath);
         
-        // Skip if already exists (check without additional mutex lock)
-        {
-            QSqlQuery checkQuery(m_database);
-            checkQuery.prepare("SELECT COUNT(*) as count FROM musics WHERE path = ?");
-            checkQuery.addBindValue(sanitizePath(filePath));
-            
-            if (checkQuery.exec() && checkQuery.next() && checkQuery.value("count").toInt() > 0) {
-                processed++;
-                continue;
-            }
+        // Skip if already exists
+        if (knownPaths.contains(sanitizePath(filePath))) {
+            processed++;
+            continue;
         }
         
         // Extract metadata
@@ -551,7 +1031,7 @@ int MusicRepository::importFromDirectory(const QString& directoryPath, bool recu
     return imported;
 }
 
-bool MusicRepository::incrementPlayCount(int musicId)
+bool MusicRepository::incrementPlayCount(int musicId, const QString& lastPlayed)
 {
     QMutexLocker locker(&m_mutex);
     
@@ -562,9 +1042,20 @@ bool MusicRepository::incrementPlayCount(int musicId)
         return false;
     }
     
-    QSqlQuery query(m_database);
-    query.prepare("UPDATE musics SET played_times = played_times + 1, last_played = ? WHERE id = ?");
-    query.addBindValue(QDateTime::currentDateTime().toString(Qt::ISODate));
+    // Played on every track change, so keep the statement prepared
+    if (!m_playCountQuery) {
+        m_playCountQuery = std::make_unique<QSqlQuery>(m_database);
+        if (!m_playCountQuery->prepare("UPDATE musics SET played_times = played_times + 1, last_played = ? WHERE id = ?")) {
+            QString error = QString("SQL Error: %1").arg(m_playCountQuery->lastError().text());
+            logError("incrementPlayCount", error);
+            emit operationError("incrementPlayCount", error);
+            m_playCountQuery.reset();
+            return false;
+        }
+    }
+    
+    QSqlQuery& query = *m_playCountQuery;
+    query.addBindValue(lastPlayed.isEmpty() ? QDateTime::currentDateTime().toString(Qt::ISODate) : lastPlayed);
     query.addBindValue(musicId);
     
     if (!executeQuery(query, "incrementPlayCount")) {
@@ -578,67 +1069,107 @@ bool MusicRepository::incrementPlayCount(int musicId)
         return false;
     }
     
-    // Invalidate stats cache
-    QMutexLocker statsLocker(&m_statsMutex);
-    m_statsLastUpdated = QDateTime();
+    emit playCountIncremented(musicId);
     
     return true;
 }
 
-MusicRepository::MusicStats MusicRepository::getStatistics()
+int MusicRepository::getMusicIdByPath(const QString& filePath)
+{
+    QMutexLocker locker(&m_mutex);
+    return findIdByPath(sanitizePath(filePath));
+}
+
+int MusicRepository::findIdByPath(const QString& path)
 {
-    QMutexLocker statsLocker(&m_statsMutex);
+    ensurePathIndex();
+    const bool located = libraryRootsReady();
+    
+    if (!m_idByPathQuery) {
+        // Tracks whose location was forgotten are still found by their path
+        const QString sql = located ? "SELECT id FROM musics "
+                                      "WHERE (root_id = ? AND path_hash = ? AND rel_path = ?) "
+                                      "OR (path_hash IS NULL AND path = ?) LIMIT 1"
+                                    : "SELECT id FROM musics WHERE path = ? LIMIT 1";
+        m_idByPathQuery = std::make_unique<QSqlQuery>(m_database);
+        m_idByPathQuery->setForwardOnly(true);
+        if (!m_idByPathQuery->prepare(sql)) {
+            logError("getMusicIdByPath", QString("SQL Error: %1").arg(m_idByPathQuery->lastError().text()));
+            m_idByPathQuery.reset();
+            return -1;
+        }
+    }
     
-    // Check if cached stats are still valid
-    if (m_statsLastUpdated.isValid() && 
-        m_statsLastUpdated.msecsTo(QDateTime::currentDateTime()) < STATS_CACHE_DURATION_MS) {
-        return m_cachedStats;
+    QSqlQuery& query = *m_idByPathQuery;
+    if (located) {
+        bindLocation(query, path);
     }
+    query.addBindValue(path);
     
-    statsLocker.unlock();
-    QMutexLocker locker(&m_mutex);
+    if (!executeQuery(query, "getMusicIdByPath")) {
+        return -1;
+    }
     
-    MusicStats stats;
+    int id = query.next() ? query.value(0).toInt() : -1;
+    query.finish();
     
-    // Get total tracks
-    QSqlQuery query(m_database);
-    query.prepare("SELECT COUNT(*) as total FROM musics");
-    if (executeQuery(query, "getStatistics") && query.next()) {
-        stats.totalTracks = query.value("total").toInt();
+    // Another process may have made a root of the track's directory since the roots were read
+    if (id == -1 && located && m_libraryRoots.reload()) {
+        bindLocation(query, path);
+        query.addBindValue(path);
+        if (executeQuery(query, "getMusicIdByPath") && query.next()) {
+            id = query.value(0).toInt();
+        }
+        query.finish();
     }
+    return id;
+}
+
+void MusicRepository::bindLocation(QSqlQuery& query, const QString& path)
+{
+    const LibraryRoots::Location location = m_libraryRoots.locate(path);
+    query.addBindValue(location.rootId);
+    query.addBindValue(location.relativePath);
+    query.addBindValue(location.hash);
+}
+
+MusicRepository::MusicStats MusicRepository::getStatistics()
+{
+    QMutexLocker locker(&m_mutex);
     
-    // Get total artists
-    query.prepare("SELECT COUNT(DISTINCT artist) as total FROM musics");
-    if (executeQuery(query, "getStatistics") && query.next()) {
-        stats.totalArtists = query.value("total").toInt();
-    }
+    MusicStats stats;
+    QSqlQuery query(m_database);
     
-    // Get total genres
-    query.prepare("SELECT COUNT(DISTINCT genre1) as total FROM musics WHERE genre1 IS NOT NULL AND genre1 != ''");
-    if (executeQuery(query, "getStatistics") && query.next()) {
-        stats.totalGenres = query.value("total").toInt();
+    if (statisticsReady()) {
+        // One row kept current by the musics_stats triggers
+        query.prepare("SELECT tracks, artists, genres, plays FROM musics_stats WHERE id = 1");
+        if (executeQuery(query, "getStatistics") && query.next()) {
+            stats.totalTracks = query.value("tracks").toInt();
+            stats.totalArtists = query.value("artists").toInt();
+            stats.totalGenres = query.value("genres").toInt();
+            stats.totalPlays = query.value("plays").toInt();
+        }
+    } else {
+        query.prepare("SELECT COUNT(*) AS tracks, COUNT(DISTINCT artist) AS artists, "
+                      "COUNT(DISTINCT NULLIF(genre1, '')) AS genres, "
+                      "COALESCE(SUM(played_times), 0) AS plays FROM musics");
+        if (executeQuery(query, "getStatistics") && query.next()) {
+            stats.totalTracks = query.value("tracks").toInt();
+            stats.totalArtists = query.value("artists").toInt();
+            stats.totalGenres = query.value("genres").toInt();
+            stats.totalPlays = query.value("plays").toInt();
+        }
     }
     
-    // Get most played track
-    query.prepare("SELECT id, song, artist, played_times FROM musics WHERE played_times = (SELECT MAX(played_times) FROM musics) LIMIT 1");
+    // The top of idx_musics_played_times rather than a scan for the maximum
+    ensureFilterIndexes();
+    query.prepare("SELECT id, song, artist FROM musics WHERE played_times IS NOT NULL "
+                  "ORDER BY played_times DESC LIMIT 1");
     if (executeQuery(query, "getStatistics") && query.next()) {
         stats.mostPlayedTrackId = query.value("id").toInt();
         stats.mostPlayedTrackTitle = QString("%1 - %2").arg(query.value("artist").toString(), query.value("song").toString());
     }
     
-    // Get total plays
-    query.prepare("SELECT SUM(played_times) as total FROM musics");
-    if (executeQuery(query, "getStatistics") && query.next()) {
-        stats.totalPlays = query.value("total").toInt();
-    }
-    
-    locker.unlock();
-    
-    // Cache the results
-    statsLocker.relock();
-    m_cachedStats = stats;
-    m_statsLastUpdated = QDateTime::currentDateTime();
-    
     return stats;
 }
 
@@ -646,8 +1177,11 @@ QStringList MusicRepository::getAllArtists()
 {
     QMutexLocker locker(&m_mutex);
     
+    // The dictionary is kept sorted by its primary key, so this reads it in order
     QSqlQuery query(m_database);
-    query.prepare("SELECT DISTINCT artist FROM musics WHERE artist IS NOT NULL AND artist != '' ORDER BY artist");
+    query.prepare(statisticsReady()
+                      ? "SELECT artist FROM musics_stats_artists WHERE artist != '' ORDER BY artist"
+                      : "SELECT DISTINCT artist FROM musics WHERE artist IS NOT NULL AND artist != '' ORDER BY artist");
     
     QStringList artists;
     
@@ -666,56 +1200,518 @@ QStringList MusicRepository::getAllGenres(bool includeGenre2)
 {
     QMutexLocker locker(&m_mutex);
     
-    QStringList genres;
+    QString queryString;
+    if (statisticsReady()) {
+        queryString = includeGenre2
+                          ? "SELECT genre FROM musics_stats_genres UNION SELECT genre FROM musics_stats_genres2 ORDER BY 1"
+                          : "SELECT genre FROM musics_stats_genres ORDER BY genre";
+    } else {
+        queryString = "SELECT genre1 AS genre FROM musics WHERE genre1 IS NOT NULL AND genre1 != ''";
+        if (includeGenre2) {
+            queryString += " UNION SELECT genre2 FROM musics WHERE genre2 IS NOT NULL AND genre2 != ''";
+        } else {
+            queryString.replace("SELECT genre1", "SELECT DISTINCT genre1");
+        }
+        queryString += " ORDER BY 1";
+    }
     
-    // Get genres from genre1
     QSqlQuery query(m_database);
-    query.prepare("SELECT DISTINCT genre1 FROM musics WHERE genre1 IS NOT NULL AND genre1 != '' ORDER BY genre1");
+    query.prepare(queryString);
     
+    QStringList genres;
     if (executeQuery(query, "getAllGenres")) {
         while (query.next()) {
-            QString genre = query.value("genre1").toString();
-            if (!genres.contains(genre)) {
-                genres.append(genre);
-            }
+            genres.append(query.value(0).toString());
         }
     }
     
-    // Get genres from genre2 if requested
-    if (includeGenre2) {
-        query.prepare("SELECT DISTINCT genre2 FROM musics WHERE genre2 IS NOT NULL AND genre2 != '' ORDER BY genre2");
+    return genres;
+}
+
+bool MusicRepository::pathExists(const QString& filePath)
+{
+    QMutexLocker locker(&m_mutex);
+    return findIdByPath(sanitizePath(filePath)) != -1;
+}
+
+int MusicRepository::addLibraryRoot(const QString& directoryPath)
+{
+    QMutexLocker locker(&m_mutex);
+    
+    if (!libraryRootsReady()) {
+        return -1;
+    }
+    const int rootId = m_libraryRoots.addRoot(sanitizePath(directoryPath));
+    if (rootId < 0) {
+        QString error = QString("Cannot add library root: %1").arg(directoryPath);
+        logError("addLibraryRoot", error);
+        emit operationError("addLibraryRoot", error);
+    }
+    return rootId;
+}
+
+bool MusicRepository::relocateLibraryRoot(int rootId, const QString& newPath)
+{
+    QMutexLocker locker(&m_mutex);
+    
+    if (!libraryRootsReady() || !m_libraryRoots.relocateRoot(rootId, sanitizePath(newPath))) {
+        QString error = QString("Cannot move library root %1 to %2").arg(rootId).arg(newPath);
+        logError("relocateLibraryRoot", error);
+        emit operationError("relocateLibraryRoot", error);
+        return false;
+    }
+    return true;
+}
+
+QMap<int, QString> MusicRepository::libraryRoots()
+{
+    QMutexLocker locker(&m_mutex);
+    return libraryRootsReady() ? m_libraryRoots.roots() : QMap<int, QString>();
+}
+
+void MusicRepository::setContentHasher(ContentHasher hasher)
+{
+    QMutexLocker locker(&m_mutex);
+    m_contentHasher = std::move(hasher);
+}
+
+bool MusicRepository::ensureContentHashColumn(QSqlDatabase& database)
+{
+    QSqlQuery query(database);
+    if (!query.exec("PRAGMA table_info(musics)")) {
+        qWarning() << "MusicRepository::ensureContentHashColumn - SQL Error:" << query.lastError().text();
+        return false;
+    }
+    
+    bool hasColumn = false;
+    bool hasTable = false;
+    while (query.next()) {
+        hasTable = true;
+        hasColumn = hasColumn || query.value(1).toString() == "content_hash";
+    }
+    if (!hasTable) {
+        qWarning() << "MusicRepository::ensureContentHashColumn - The musics table does not exist";
+        return false;
+    }
+    
+    const QStringList statements = {
+        hasColumn ? QString() : QString("ALTER TABLE musics ADD COLUMN content_hash TEXT"),
+        "CREATE INDEX IF NOT EXISTS idx_musics_content_hash ON musics(content_hash)"
+    };
+    for (const QString& sql : statements) {
+        if (!sql.isEmpty() && !query.exec(sql)) {
+            qWarning() << QString("MusicRepository::ensureContentHashColumn - SQL Error: %1 (Query: %2)")
+                              .arg(query.lastError().text(), sql);
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+MusicItem MusicRepository::findMusicByContentHash(const QString& contentHash)
+{
+    QMutexLocker locker(&m_mutex);
+    
+    if (contentHash.isEmpty()) {
+        return MusicItem();
+    }
+    if (!m_contentHashReady) {
+        m_contentHashReady = ensureContentHashColumn(m_database);
+        if (!m_contentHashReady) {
+            return MusicItem();
+        }
+    }
+    
+    QSqlQuery query(m_database);
+    query.setForwardOnly(true);
+    query.prepare("SELECT id, artist, song, genre1, genre2, country, published_date, "
+                  "path, time, played_times, last_played, content_hash FROM musics "
+                  "WHERE content_hash = ? ORDER BY id LIMIT 1");
+    query.addBindValue(contentHash);
+    
+    if (!executeQuery(query, "findMusicByContentHash") || !query.next()) {
+        return MusicItem();
+    }
+    
+    MusicItem music = musicFromRow(query);
+    music.contentHash = query.value(11).toString();
+    return music;
+}
+
+QList<QList<MusicItem>> MusicRepository::findContentDuplicates()
+{
+    QMutexLocker locker(&m_mutex);
+    
+    QList<QList<MusicItem>> groups;
+    if (!m_contentHashReady) {
+        m_contentHashReady = ensureContentHashColumn(m_database);
+        if (!m_contentHashReady) {
+            return groups;
+        }
+    }
+    
+    // The inner query only walks idx_musics_content_hash
+    QSqlQuery query(m_database);
+    query.setForwardOnly(true);
+    query.prepare("SELECT id, artist, song, genre1, genre2, country, published_date, "
+                  "path, time, played_times, last_played, content_hash FROM musics "
+                  "WHERE content_hash IN (SELECT content_hash FROM musics "
+                  "WHERE content_hash IS NOT NULL GROUP BY content_hash HAVING COUNT(*) > 1) "
+                  "ORDER BY content_hash, id");
+    
+    if (!executeQuery(query, "findContentDuplicates")) {
+        return groups;
+    }
+    
+    QString currentHash;
+    while (query.next()) {
+        MusicItem music = musicFromRow(query);
+        music.contentHash = query.value(11).toString();
+        if (groups.isEmpty() || music.contentHash != currentHash) {
+            currentHash = music.contentHash;
+            groups.append(QList<MusicItem>());
+        }
+        groups.last().append(music);
+    }
+    
+    return groups;
+}
+
+QStringList MusicRepository::getPathsWithoutContentHash(int limit)
+{
+    QMutexLocker locker(&m_mutex);
+    
+    QStringList paths;
+    if (!m_contentHashReady) {
+        m_contentHashReady = ensureContentHashColumn(m_database);
+        if (!m_contentHashReady) {
+            return paths;
+        }
+    }
+    
+    QSqlQuery query(m_database);
+    query.setForwardOnly(true);
+    query.prepare("SELECT path FROM musics WHERE content_hash IS NULL ORDER BY id LIMIT ?");
+    query.addBindValue(limit);
+    
+    if (!executeQuery(query, "getPathsWithoutContentHash")) {
+        return paths;
+    }
+    
+    while (query.next()) {
+        paths.append(query.value(0).toString());
+    }
+    
+    return paths;
+}
+
+int MusicRepository::setContentHashes(const QHash<QString, QString>& hashesByPath)
+{
+    QMutexLocker locker(&m_mutex);
+    
+    if (hashesByPath.isEmpty()) {
+        return 0;
+    }
+    if (!m_contentHashReady) {
+        m_contentHashReady = ensureContentHashColumn(m_database);
+        if (!m_contentHashReady) {
+            return 0;
+        }
+    }
+    ensurePathIndex();
+    
+    if (!m_database.transaction()) {
+        logError("setContentHashes", "Failed to start transaction");
+        emit operationError("setContentHashes", "Failed to start transaction");
+        return 0;
+    }
+    
+    QSqlQuery query(m_database);
+    query.prepare("UPDATE musics SET content_hash = ? WHERE path = ?");
+    
+    int updated = 0;
+    for (auto it = hashesByPath.constBegin(); it != hashesByPath.constEnd(); ++it) {
+        if (it.value().isEmpty()) {
+            continue;
+        }
+        query.addBindValue(it.value());
+        query.addBindValue(it.key());
+        if (query.exec()) {
+            updated += query.numRowsAffected();
+        } else {
+            logError("setContentHashes", query.lastError().text(), query.lastQuery());
+        }
+    }
+    
+    if (!m_database.commit()) {
+        m_database.rollback();
+        logError("setContentHashes", "Failed to commit transaction");
+        emit operationError("setContentHashes", "Failed to commit transaction");
+        return 0;
+    }
+    
+    return updated;
+}
+
+MusicItem MusicRepository::itemFromTags(const QString& filePath, const TagReader::Tags& tags)
+{
+    MusicItem music;
+    music.path = filePath;
+    
+    // Tags first; the file name fills what they leave out
+    QString baseName = QFileInfo(filePath).completeBaseName();
+    QString fileArtist = "Unknown Artist";
+    QString fileSong = baseName;
+    
+    // Try to parse "Artist - Song" format
+    if (baseName.contains(" - ")) {
+        QStringList parts = baseName.split(" - ", Qt::SkipEmptyParts);
+        if (parts.size() >= 2) {
+            fileArtist = parts[0].trimmed();
+            fileSong = parts[1].trimmed();
+        }
+    }
+    
+    music.artist = tags.artist.isEmpty() ? fileArtist : tags.artist;
+    music.song = tags.title.isEmpty() ? fileSong : tags.title;
+    music.genre1 = tags.genre.isEmpty() ? QString("Unknown") : tags.genre;
+    music.publishedDate = tags.year;
+    music.time = tags.durationString();
+    music.playedTimes = 0;
+    music.lastPlayed = "";
+    
+    return music;
+}
+
+QSet<QString> MusicRepository::existingPaths(const QStringList& paths)
+{
+    QMutexLocker locker(&m_mutex);
+    
+    if (paths.isEmpty()) {
+        return QSet<QString>();
+    }
+    ensurePathIndex();
+    
+    QStringList sanitized;
+    sanitized.reserve(paths.size());
+    for (const QString& path : paths) {
+        sanitized.append(sanitizePath(path));
+    }
+    const QSet<QString> known = findExistingPaths(sanitized);
+    
+    QSet<QString> existing;
+    for (int i = 0; i < paths.size(); ++i) {
+        if (known.contains(sanitized.at(i))) {
+            existing.insert(paths.at(i));
+        }
+    }
+    return existing;
+}
+
+int MusicRepository::refreshMusicBatch(const QList<MusicItem>& musicList)
+{
+    if (musicList.isEmpty()) {
+        return 0;
+    }
+    
+    ContentHasher hasher;
+    {
+        QMutexLocker locker(&m_mutex);
+        hasher = m_contentHasher;
+    }
+    
+    int updatedCount = 0;
+    for (int start = 0; start < musicList.size(); start += IMPORT_CHUNK_SIZE) {
+        const int end = std::min(start + IMPORT_CHUNK_SIZE, static_cast<int>(musicList.size()));
         
-        if (executeQuery(query, "getAllGenres")) {
-            while (query.next()) {
-                QString genre = query.value("genre2").toString();
-                if (!genres.contains(genre)) {
-                    genres.append(genre);
-                }
+        // The audio changed, so the old hash is stale; hash before locking
+        QList<MusicItem> chunk = musicList.mid(start, end - start);
+        if (hasher) {
+            hashMissingContent(chunk, hasher);
+        }
+        
+        QMutexLocker locker(&m_mutex);
+        ensurePathIndex();
+        if (!m_contentHashReady) {
+            m_contentHashReady = ensureContentHashColumn(m_database);
+        }
+        
+        if (!m_database.transaction()) {
+            logError("refreshMusicBatch", "Failed to start transaction");
+            emit operationError("refreshMusicBatch", "Failed to start transaction");
+            return updatedCount;
+        }
+        
+        QSqlQuery query(m_database);
+        query.prepare(QString("UPDATE musics SET artist = COALESCE(NULLIF(?, ''), artist), "
+                              "song = COALESCE(NULLIF(?, ''), song), "
+                              "genre1 = COALESCE(NULLIF(?, ''), genre1), "
+                              "published_date = COALESCE(NULLIF(?, ''), published_date), "
+                              "time = ?%1 WHERE path = ?")
+                          .arg(m_contentHashReady ? ", content_hash = ?" : ""));
+        QSqlQuery select(m_database);
+        select.prepare("SELECT id, artist, song, genre1, genre2, country, published_date, "
+                       "path, time, played_times, last_played FROM musics WHERE path = ?");
+        
+        QList<MusicItem> updated;
+        for (const MusicItem& music : std::as_const(chunk)) {
+            const QString path = sanitizePath(music.path);
+            query.addBindValue(music.artist);
+            query.addBindValue(music.song);
+            query.addBindValue(music.genre1);
+            query.addBindValue(music.publishedDate);
+            query.addBindValue(music.time);
+            if (m_contentHashReady) {
+                query.addBindValue(music.contentHash.isEmpty() ? QVariant()
+                                                               : QVariant(music.contentHash));
             }
+            query.addBindValue(path);
+            
+            if (!query.exec()) {
+                logError("refreshMusicBatch", query.lastError().text(), query.lastQuery());
+                continue;
+            }
+            if (query.numRowsAffected() == 0) {
+                continue;
+            }
+            
+            select.addBindValue(path);
+            if (select.exec() && select.next()) {
+                updated.append(musicFromRow(select));
+            }
+            select.finish();
+        }
+        
+        if (!m_database.commit()) {
+            m_database.rollback();
+            logError("refreshMusicBatch", "Failed to commit transaction");
+            emit operationError("refreshMusicBatch", "Failed to commit transaction");
+            return updatedCount;
+        }
+        
+        updatedCount += updated.size();
+        for (const MusicItem& music : std::as_const(updated)) {
+            emit musicUpdated(music);
         }
     }
     
-    genres.sort();
-    return genres;
+    return updatedCount;
 }
 
-bool MusicRepository::pathExists(const QString& filePath)
+int MusicRepository::renameMusicBatch(const QHash<QString, QString>& newPathsByOldPath)
 {
     QMutexLocker locker(&m_mutex);
     
+    if (newPathsByOldPath.isEmpty()) {
+        return 0;
+    }
+    ensurePathIndex();
+    
+    if (!m_database.transaction()) {
+        logError("renameMusicBatch", "Failed to start transaction");
+        emit operationError("renameMusicBatch", "Failed to start transaction");
+        return 0;
+    }
+    
     QSqlQuery query(m_database);
-    query.prepare("SELECT COUNT(*) as count FROM musics WHERE path = ?");
-    query.addBindValue(sanitizePath(filePath));
+    query.prepare("UPDATE musics SET path = ? WHERE path = ?");
+    QSqlQuery select(m_database);
+    select.prepare("SELECT id, artist, song, genre1, genre2, country, published_date, "
+                   "path, time, played_times, last_played FROM musics WHERE path = ?");
+    
+    QList<MusicItem> moved;
+    for (auto it = newPathsByOldPath.constBegin(); it != newPathsByOldPath.constEnd(); ++it) {
+        const QString newPath = sanitizePath(it.value());
+        query.addBindValue(newPath);
+        query.addBindValue(sanitizePath(it.key()));
+        if (!query.exec()) {
+            logError("renameMusicBatch", query.lastError().text(), query.lastQuery());
+            continue;
+        }
+        if (query.numRowsAffected() == 0) {
+            continue;
+        }
+        
+        select.addBindValue(newPath);
+        if (select.exec() && select.next()) {
+            moved.append(musicFromRow(select));
+        }
+        select.finish();
+    }
     
-    if (query.exec() && query.next()) {
-        return query.value("count").toInt() > 0;
+    if (!m_database.commit()) {
+        m_database.rollback();
+        logError("renameMusicBatch", "Failed to commit transaction");
+        emit operationError("renameMusicBatch", "Failed to commit transaction");
+        return 0;
     }
     
-    if (query.lastError().isValid()) {
-        logError("pathExists", query.lastError().text(), query.lastQuery());
+    for (const MusicItem& music : std::as_const(moved)) {
+        emit musicUpdated(music);
     }
+    return moved.size();
+}
+
+int MusicRepository::removeMusicBatch(const QStringList& paths)
+{
+    int removedCount = 0;
     
-    return false;
+    for (int start = 0; start < paths.size(); start += IMPORT_CHUNK_SIZE) {
+        const int end = std::min(start + IMPORT_CHUNK_SIZE, static_cast<int>(paths.size()));
+        
+        // Lock per chunk so readers get a turn between commits
+        QMutexLocker locker(&m_mutex);
+        ensurePathIndex();
+        
+        if (!m_database.transaction()) {
+            logError("removeMusicBatch", "Failed to start transaction");
+            emit operationError("removeMusicBatch", "Failed to start transaction");
+            return removedCount;
+        }
+        
+        QSqlQuery select(m_database);
+        select.prepare("SELECT id FROM musics WHERE path = ?");
+        QSqlQuery query(m_database);
+        query.prepare("DELETE FROM musics WHERE id = ?");
+        
+        QList<int> removed;
+        for (int i = start; i < end; ++i) {
+            select.addBindValue(sanitizePath(paths.at(i)));
+            if (!select.exec()) {
+                logError("removeMusicBatch", select.lastError().text(), select.lastQuery());
+                continue;
+            }
+            QList<int> ids;
+            while (select.next()) {
+                ids.append(select.value(0).toInt());
+            }
+            select.finish();
+            
+            for (int id : std::as_const(ids)) {
+                query.addBindValue(id);
+                if (query.exec()) {
+                    removed.append(id);
+                } else {
+                    logError("removeMusicBatch", query.lastError().text(), query.lastQuery());
+                }
+            }
+        }
+        
+        if (!m_database.commit()) {
+            m_database.rollback();
+            logError("removeMusicBatch", "Failed to commit transaction");
+            emit operationError("removeMusicBatch", "Failed to commit transaction");
+            return removedCount;
+        }
+        
+        removedCount += removed.size();
+        for (int id : std::as_const(removed)) {
+            emit musicDeleted(id);
+        }
+    }
+    
+    return removedCount;
 }
 
 QString MusicRepository::validateMusicItem(const MusicItem& music)
@@ -753,42 +1749,12 @@ QString MusicRepository::validateMusicItem(const MusicItem& music)
 
 MusicItem MusicRepository::extractMetadata(const QString& filePath)
 {
-    MusicItem music;
-    
     QFileInfo fileInfo(filePath);
     if (!fileInfo.exists() || !fileInfo.isFile()) {
-        return music;
-    }
-    
-    music.path = filePath;
-    
-    // Extract basic information from filename if no metadata available
-    QString baseName = fileInfo.baseName();
-    
-    // Try to parse "Artist - Song" format
-    if (baseName.contains(" - ")) {
-        QStringList parts = baseName.split(" - ", Qt::SkipEmptyParts);
-        if (parts.size() >= 2) {
-            music.artist = parts[0].trimmed();
-            music.song = parts[1].trimmed();
-        } else {
-            music.artist = "Unknown Artist";
-            music.song = baseName;
-        }
-    } else {
-        music.artist = "Unknown Artist";
-        music.song = baseName;
+        return MusicItem();
     }
     
-    // Set default values
-    music.genre1 = "Unknown";
-    music.playedTimes = 0;
-    music.lastPlayed = "";
-    
-    // TODO: In a real implementation, you would use a library like TagLib
-    // to extract actual metadata from audio files. For now, we'll use basic file info.
-    
-    return music;
+    return itemFromTags(filePath, TagReader::read(filePath));
 }
 
 bool MusicRepository::isSupportedAudioFile(const QString& filePath, const QStringList& supportedExtensions)
@@ -820,9 +1786,275 @@ void MusicRepository::logError(const QString& operation, const QString& error, c
     qWarning() << logMessage;
 }
 
+QSet<QString> MusicRepository::findExistingContentHashes(const QStringList& hashes)
+{
+    QSet<QString> existing;
+    
+    for (int start = 0; start < hashes.size(); start += IMPORT_CHUNK_SIZE) {
+        const int count = std::min(IMPORT_CHUNK_SIZE, static_cast<int>(hashes.size()) - start);
+        
+        QStringList placeholders;
+        for (int i = 0; i < count; ++i) {
+            placeholders.append("?");
+        }
+        
+        QSqlQuery query(m_database);
+        query.setForwardOnly(true);
+        query.prepare(QString("SELECT content_hash FROM musics WHERE content_hash IN (%1)").arg(placeholders.join(", ")));
+        for (int i = 0; i < count; ++i) {
+            query.addBindValue(hashes.at(start + i));
+        }
+        
+        if (!executeQuery(query, "findExistingContentHashes")) {
+            continue;
+        }
+        
+        while (query.next()) {
+            existing.insert(query.value(0).toString());
+        }
+    }
+    
+    return existing;
+}
+
+int MusicRepository::deleteMusicBatch(const QList<int>& musicIds,
+                                      QHash<int, QString>* deletedPaths)
+{
+    QList<int> ids = musicIds;
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    if (ids.isEmpty()) {
+        return 0;
+    }
+    
+    QMutexLocker locker(&m_mutex);
+    
+    if (!m_database.transaction()) {
+        logError("deleteMusicBatch", "Failed to start transaction");
+        emit operationError("deleteMusicBatch", "Failed to start transaction");
+        return -1;
+    }
+    
+    QHash<int, QString> paths;
+    for (int start = 0; start < ids.size(); start += IMPORT_CHUNK_SIZE) {
+        const int count = std::min(IMPORT_CHUNK_SIZE, static_cast<int>(ids.size()) - start);
+        
+        QStringList placeholders;
+        for (int i = 0; i < count; ++i) {
+            placeholders.append("?");
+        }
+        const QString idList = placeholders.join(", ");
+        
+        // The paths are read in the same transaction, so they are those of the rows deleted
+        QSqlQuery select(m_database);
+        select.setForwardOnly(true);
+        select.prepare(QString("SELECT id, path FROM musics WHERE id IN (%1)").arg(idList));
+        QSqlQuery remove(m_database);
+        remove.prepare(QString("DELETE FROM musics WHERE id IN (%1)").arg(idList));
+        for (int i = 0; i < count; ++i) {
+            select.addBindValue(ids.at(start + i));
+            remove.addBindValue(ids.at(start + i));
+        }
+        
+        if (!executeQuery(select, "deleteMusicBatch")) {
+            m_database.rollback();
+            return -1;
+        }
+        while (select.next()) {
+            paths.insert(select.value(0).toInt(), select.value(1).toString());
+        }
+        select.finish();
+        
+        if (!executeQuery(remove, "deleteMusicBatch")) {
+            m_database.rollback();
+            return -1;
+        }
+    }
+    
+    if (!m_database.commit()) {
+        m_database.rollback();
+        logError("deleteMusicBatch", "Failed to commit transaction");
+        emit operationError("deleteMusicBatch", "Failed to commit transaction");
+        return -1;
+    }
+    
+    for (auto it = paths.cbegin(); it != paths.cend(); ++it) {
+        emit musicDeleted(it.key());
+    }
+    if (deletedPaths) {
+        *deletedPaths = paths;
+    }
+    return paths.size();
+}
+
+QSet<QString> MusicRepository::findExistingPaths(const QStringList& paths)
+{
+    QSet<QString> existing;
+    
+    for (int start = 0; start < paths.size(); start += IMPORT_CHUNK_SIZE) {
+        const int count = std::min(IMPORT_CHUNK_SIZE, static_cast<int>(paths.size()) - start);
+        
+        QStringList placeholders;
+        for (int i = 0; i < count; ++i) {
+            placeholders.append("?");
+        }
+        
+        QSqlQuery query(m_database);
+        query.setForwardOnly(true);
+        query.prepare(QString("SELECT path FROM musics WHERE path IN (%1)").arg(placeholders.join(", ")));
+        for (int i = 0; i < count; ++i) {
+            query.addBindValue(paths.at(start + i));
+        }
+        
+        if (!executeQuery(query, "findExistingPaths")) {
+            continue;
+        }
+        
+        while (query.next()) {
+            existing.insert(query.value(0).toString());
+        }
+    }
+    
+    return existing;
+}
+
+void MusicRepository::ensurePathIndex()
+{
+    if (m_pathIndexReady) {
+        return;
+    }
+    
+    QSqlQuery query(m_database);
+    if (query.exec("CREATE INDEX IF NOT EXISTS idx_musics_path ON musics(path)")) {
+        m_pathIndexReady = true;
+    } else {
+        logError("ensurePathIndex", QString("SQL Error: %1").arg(query.lastError().text()), query.lastQuery());
+    }
+}
+
+void MusicRepository::ensureSortIndex()
+{
+    if (m_sortIndexReady) {
+        return;
+    }
+    
+    QSqlQuery query(m_database);
+    if (query.exec("CREATE INDEX IF NOT EXISTS idx_musics_artist_song ON musics(artist, song)")) {
+        m_sortIndexReady = true;
+    } else {
+        logError("ensureSortIndex", QString("SQL Error: %1").arg(query.lastError().text()), query.lastQuery());
+    }
+}
+
+void MusicRepository::ensureFilterIndexes()
+{
+    if (m_filterIndexesReady) {
+        return;
+    }
+    
+    const QStringList statements = {
+        "CREATE INDEX IF NOT EXISTS idx_musics_played_times ON musics(played_times)",
+        "CREATE INDEX IF NOT EXISTS idx_musics_last_played ON musics(last_played)",
+        "CREATE INDEX IF NOT EXISTS idx_musics_genre1 ON musics(genre1 COLLATE NOCASE)",
+        "CREATE INDEX IF NOT EXISTS idx_musics_genre2 ON musics(genre2 COLLATE NOCASE)",
+        QString("CREATE INDEX IF NOT EXISTS idx_musics_duration ON musics(%1)").arg(durationSecondsSql())
+    };
+    
+    QSqlQuery query(m_database);
+    bool ready = true;
+    for (const QString& statement : statements) {
+        if (!query.exec(statement)) {
+            logError("ensureFilterIndexes", QString("SQL Error: %1").arg(query.lastError().text()), query.lastQuery());
+            ready = false;
+        }
+    }
+    m_filterIndexesReady = ready;
+}
+
+bool MusicRepository::statisticsReady()
+{
+    if (!m_statisticsChecked) {
+        m_statisticsChecked = true;
+        m_statisticsAvailable = ensureStatistics(m_database);
+        if (!m_statisticsAvailable) {
+            logError("statisticsReady", "Library statistics unavailable, counting the library on each call");
+        }
+    }
+    
+    return m_statisticsAvailable;
+}
+
+bool MusicRepository::libraryRootsReady()
+{
+    if (!m_libraryRootsChecked) {
+        m_libraryRootsChecked = true;
+        if (!m_libraryRoots.ensure()) {
+            logError("libraryRootsReady", "Library roots unavailable, looking tracks up by path");
+        }
+    }
+    
+    // Roots added through another repository, such as the player's import
+    m_libraryRoots.refresh();
+    return m_libraryRoots.isReady();
+}
+
+bool MusicRepository::fullTextIndexReady()
+{
+    if (!m_fullTextChecked) {
+        m_fullTextChecked = true;
+        m_fullTextAvailable = ensureFullTextIndex(m_database);
+        if (!m_fullTextAvailable) {
+            logError("fullTextIndexReady", "Full-text index unavailable, falling back to LIKE searches");
+        }
+    }
+    
+    return m_fullTextAvailable;
+}
+
+MusicItem MusicRepository::musicFromRow(const QSqlQuery& query)
+{
+    MusicItem item;
+    item.id = query.value(0).toInt();
+    item.artist = query.value(1).toString();
+    item.song = query.value(2).toString();
+    item.genre1 = query.value(3).toString();
+    item.genre2 = query.value(4).toString();
+    item.country = query.value(5).toString();
+    item.publishedDate = query.value(6).toString();
+    item.path = query.value(7).toString();
+    item.time = query.value(8).toString();
+    item.playedTimes = query.value(9).toInt();
+    item.lastPlayed = query.value(10).toString();
+    return item;
+}
+
+QSqlQuery* MusicRepository::preparedQuery(const QString& sql, const QString& operation)
+{
+    auto it = m_preparedQueries.find(sql);
+    if (it != m_preparedQueries.end()) {
+        return it->second.get();
+    }
+    
+    auto query = std::make_unique<QSqlQuery>(m_database);
+    query->setForwardOnly(true);
+    if (!query->prepare(sql)) {
+        QString error = QString("SQL Error: %1").arg(query->lastError().text());
+        logError(operation, error, sql);
+        emit operationError(operation, error);
+        return nullptr;
+    }
+    return m_preparedQueries.emplace(sql, std::move(query)).first->second.get();
+}
+
 bool MusicRepository::executeQuery(QSqlQuery& query, const QString& operation)
 {
-    if (!query.exec()) {
+    bool success;
+    {
+        QueryTimer timer(query.lastQuery());
+        success = query.exec();
+    }
+    
+    if (!success) {
         QString error = QString("SQL Error: %1").arg(query.lastError().text());
         logError(operation, error, query.lastQuery());
         emit operationError(operation, error);
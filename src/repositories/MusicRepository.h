@@ -10,9 +10,16 @@
 #include <QDateTime>
 #include <QDir>
 #include <QFileInfo>
+#include <QHash>
 #include <QMimeDatabase>
 #include <QMutex>
+#include <QSet>
+#include <functional>
 #include <memory>
+#include <unordered_map>
+
+#include "../services/TagReader.h"
+#include "LibraryRoots.h"
 
 /**
  * @brief Data model representing a music item
@@ -33,6 +40,7 @@ struct MusicItem {
     QString time;
     int playedTimes = 0;
     QString lastPlayed;
+    QString contentHash;   ///< ContentHash of the audio; addMusicBatch() fills it in if empty
     
     /**
      * @brief Check if the music item has valid required fields
@@ -59,6 +67,7 @@ struct MusicItem {
         map["time"] = time;
         map["played_times"] = playedTimes;
         map["last_played"] = lastPlayed;
+        map["content_hash"] = contentHash;
         return map;
     }
     
@@ -80,6 +89,7 @@ struct MusicItem {
         item.time = map.value("time").toString();
         item.playedTimes = map.value("played_times", 0).toInt();
         item.lastPlayed = map.value("last_played").toString();
+        item.contentHash = map.value("content_hash").toString();
         return item;
     }
 };
@@ -131,12 +141,21 @@ public:
         QString genre2;
         QString country;
         QString searchText; // General text search across multiple fields
+        bool fullText = false; // Match searchText words as prefixes through the FTS index
         int limit = -1;     // -1 for no limit
         int offset = 0;
         QString orderBy = "artist, song"; // Default ordering
         bool ascending = true;
     };
 
+    /**
+     * @brief Position in the artist, song, id order used by the list APIs
+     */
+    struct MusicSortKey {
+        QString artist;
+        QString song;
+    };
+
     /**
      * @brief Statistics about music collection
      */
@@ -189,6 +208,88 @@ public:
      */
     QList<MusicItem> getAllMusic(int limit = -1, int offset = 0);
 
+    /**
+     * @brief Get the page of music items that follows a given item
+     *
+     * Keyset pagination: instead of skipping offset rows the query seeks
+     * straight past the last item of the previous page through the
+     * (artist, song) index, so every page costs the same however deep it
+     * is. Items are ordered by artist, song and id, the same order as
+     * getAllMusic().
+     * @param lastSortKey Sort key of the last item already shown
+     * @param lastId ID of the last item already shown, or -1 for the first page
+     * @param limit Maximum number of items to return
+     * @return List of MusicItem objects
+     */
+    QList<MusicItem> getMusicAfter(const MusicSortKey& lastSortKey, int lastId, int limit);
+
+    /**
+     * @brief Get the sort key of an item for use with getMusicAfter()
+     * @param music Item
+     * @return Sort key
+     */
+    static MusicSortKey sortKeyOf(const MusicItem& music) { return {music.artist, music.song}; }
+
+    /**
+     * @brief Visitor called for each streamed music item
+     * @return false to stop the scan
+     */
+    using MusicVisitor = std::function<bool(const MusicItem&)>;
+
+    /**
+     * @brief Stream music items to a visitor without building a list
+     *
+     * Rows are read with a forward-only cursor, so scanning the whole
+     * library runs in constant memory. The repository stays locked during
+     * the scan; the visitor must not call back into it.
+     * @param visitor Called for each item in artist, song, id order
+     * @param limit Maximum number of items to visit (-1 for no limit)
+     * @param offset Number of items to skip
+     * @return Number of items visited, or -1 on error
+     */
+    int forEachMusic(const MusicVisitor& visitor, int limit = -1, int offset = 0);
+
+    /**
+     * @brief Get one page of music items for a caller-built filter and sort
+     *
+     * Used by MusicListModel, which builds its clauses from the view's
+     * filters. Values go in bindValues, one per ? placeholder in the
+     * condition. Ties in the sort order are broken by id so consecutive
+     * pages never overlap.
+     * @param whereClause Condition without the WHERE keyword (empty for all items)
+     * @param bindValues Values for the placeholders in whereClause, in order
+     * @param orderByClause Sort without the ORDER BY keyword (empty for id order)
+     * @param limit Maximum number of items to return
+     * @param offset Number of items to skip
+     * @param connection Connection to run the query on, such as a worker thread's
+     *        own; when invalid the repository's connection is used under its lock
+     * @return List of MusicItem objects
+     */
+    QList<MusicItem> getMusicPage(const QString& whereClause, const QVariantList& bindValues,
+                                  const QString& orderByClause, int limit, int offset,
+                                  QSqlDatabase connection = QSqlDatabase());
+
+    /**
+     * @brief Count the music items matching a caller-built filter
+     *
+     * Also creates the indexes behind the play count, last played and
+     * duration filters, so call it before paging through a new filter.
+     * @param whereClause Condition without the WHERE keyword (empty for all items)
+     * @param bindValues Values for the placeholders in whereClause, in order
+     * @return Number of matching items, or -1 on error
+     */
+    int countMusic(const QString& whereClause = QString(), const QVariantList& bindValues = QVariantList());
+
+    /**
+     * @brief Get the SQL expression for the duration of a row in seconds
+     *
+     * musics.time holds "m:ss" or "h:mm:ss" text. The expression converts it
+     * and is indexed, so a condition such as "<expression> >= ?" is answered
+     * from the index; it must be used exactly as returned to match it.
+     * @return Expression giving the duration in seconds, or NULL for other text
+     */
+    static QString durationSecondsSql();
+
     /**
      * @brief Search music items based on criteria
      * @param criteria Search criteria
@@ -196,6 +297,56 @@ public:
      */
     QList<MusicItem> searchMusic(const SearchCriteria& criteria);
 
+    /**
+     * @brief Check if the full-text search index can be used
+     *
+     * Creates the index on first use. Returns false when the SQLite build
+     * lacks FTS5, in which case full-text searches fall back to LIKE.
+     * @return true if full-text searches use the index
+     */
+    bool isFullTextSearchAvailable();
+
+    /**
+     * @brief Create the musics_fts full-text index if it does not exist
+     *
+     * musics_fts is an FTS5 external content table over artist, song,
+     * genre1, genre2 and path, keyed by the rowid of musics. Triggers keep
+     * it in sync with every write to musics, including the ones made
+     * outside the repository. A new index is filled from the existing rows.
+     * @param database Open database holding the musics table
+     * @return true if the index is available
+     */
+    static bool ensureFullTextIndex(QSqlDatabase& database);
+
+    /**
+     * @brief Create the musics_stats summary tables if they do not exist
+     *
+     * musics_stats is a single row with the number of tracks, distinct
+     * artists and distinct genre1 values and the sum of played_times.
+     * musics_stats_artists and musics_stats_genres count the tracks of
+     * each artist and genre1 value, and musics_stats_genres2 of each
+     * genre2 value, so the distinct counts change only when the first
+     * track of one is added or the last removed; they double as the sorted
+     * dictionaries behind getAllArtists() and getAllGenres(). Triggers keep
+     * all of them in step with every write to musics, including the ones
+     * made outside the repository. New tables are filled from the existing rows.
+     * Rows removed by a REPLACE conflict skip the delete triggers, so
+     * musics is never written with INSERT OR REPLACE.
+     * @param database Open database holding the musics table
+     * @return true if the statistics are available
+     */
+    static bool ensureStatistics(QSqlDatabase& database);
+
+    /**
+     * @brief Build an FTS5 MATCH expression from user input
+     *
+     * Every word becomes a quoted prefix term and all terms must match, so
+     * "beat yel" finds "The Beatles - Yellow Submarine".
+     * @param text Text as typed by the user
+     * @return MATCH expression, or an empty string if text has no searchable words
+     */
+    static QString fullTextQuery(const QString& text);
+
     /**
      * @brief Get music items by genre
      * @param genre Genre name to search for
@@ -204,6 +355,37 @@ public:
      */
     QList<MusicItem> getMusicByGenre(const QString& genre, bool useGenre2 = false);
 
+    /**
+     * @brief Count the music items whose genre1 is a genre, ignoring case
+     * @param genre Genre name
+     * @return Number of items, or -1 on error
+     */
+    int countMusicByGenre(const QString& genre);
+
+    /**
+     * @brief Build the condition of the music view's genre filter
+     *
+     * Each genre is an equality on genre1 or genre2, ignoring case as the
+     * genre combo boxes list it, so the query walks idx_musics_genre1 or
+     * idx_musics_genre2 rather than the whole table. The indexes are
+     * created the first time.
+     * @param genre1 Genre the genre1 field must have (empty for any)
+     * @param genre2 Genre the genre2 field must have (empty for any)
+     * @param bindValues Set to the values for the placeholders, in order
+     * @return Condition without the WHERE keyword, empty if both genres are empty
+     */
+    QString genreCondition(const QString& genre1, const QString& genre2, QVariantList& bindValues);
+
+    /**
+     * @brief Pick random paths among the music items whose genre1 is a genre
+     *
+     * The genre is matched ignoring case, as the genre combo boxes list it.
+     * @param genre Genre name
+     * @param limit Maximum number of paths to return
+     * @return Paths in random order
+     */
+    QStringList getRandomPathsByGenre(const QString& genre, int limit);
+
     /**
      * @brief Get music items by artist
      * @param artist Artist name to search for
@@ -212,7 +394,33 @@ public:
     QList<MusicItem> getMusicByArtist(const QString& artist);
 
     /**
-     * @brief Add multiple music items in a single transaction
+     * @brief Get the most played music items
+     * @param limit Maximum number of items to return
+     * @param genre Only return items with this genre1 or genre2 (empty for any genre)
+     * @return Items ordered by played_times, most played first
+     */
+    QList<MusicItem> getMostPlayedMusic(int limit, const QString& genre = QString());
+
+    /**
+     * @brief Get the most recently played music items
+     * @param limit Maximum number of items to return
+     * @return Items ordered by last_played, most recent first
+     */
+    QList<MusicItem> getRecentlyPlayedMusic(int limit);
+
+    /**
+     * @brief Add multiple music items, committing in chunks
+     *
+     * Known paths are looked up once per chunk instead of once per item,
+     * and each chunk of IMPORT_CHUNK_SIZE items is committed separately
+     * with the repository unlocked in between, so readers are not starved
+     * during large imports. Items whose path is already in the library or
+     * earlier in the list are skipped.
+     *
+     * With a content hasher set, the items of a chunk that have no
+     * contentHash yet are hashed in parallel before the repository is
+     * locked. Items whose audio is already in the library or earlier in
+     * the list are skipped as well, whatever their path.
      * @param musicList List of MusicItem objects to add
      * @return Number of successfully added items
      */
@@ -232,26 +440,48 @@ public:
     /**
      * @brief Update play count and last played time for a music item
      * @param musicId ID of the music item
+     * @param lastPlayed Value stored in last_played (empty for the current time in ISO format)
      * @return true if successful, false otherwise
      */
-    bool incrementPlayCount(int musicId);
+    bool incrementPlayCount(int musicId, const QString& lastPlayed = QString());
+
+    /**
+     * @brief Look up the ID of the music item stored at a path
+     *
+     * Goes through idx_musics_location once LibraryRoots has located the
+     * library, and through idx_musics_path for tracks it has not.
+     * @param filePath Path of the audio file
+     * @return Music ID, or -1 if the path is not in the library
+     */
+    int getMusicIdByPath(const QString& filePath);
 
     /**
      * @brief Get music collection statistics
+     *
+     * The counts and the play total are read from musics_stats, which
+     * ensureStatistics() creates on first use, so they are current after
+     * every write without counting the library. The most played track is
+     * the top of idx_musics_played_times.
      * @return MusicStats structure with collection information
      */
     MusicStats getStatistics();
 
     /**
      * @brief Get list of all unique artists
+     *
+     * Read in order from the musics_stats_artists dictionary rather than
+     * by sorting the distinct values of musics.
      * @return List of artist names
      */
     QStringList getAllArtists();
 
     /**
      * @brief Get list of all unique genres
+     *
+     * Read from the musics_stats_genres and musics_stats_genres2
+     * dictionaries rather than from musics.
      * @param includeGenre2 If true, include genre2 field values
-     * @return List of genre names
+     * @return Sorted list of genre names
      */
     QStringList getAllGenres(bool includeGenre2 = true);
 
@@ -262,6 +492,138 @@ public:
      */
     bool pathExists(const QString& filePath);
 
+    /**
+     * @brief Make a directory a library root, see LibraryRoots::addRoot()
+     *
+     * importFromDirectory() adds the directory it imports itself.
+     * @param directoryPath Directory holding tracks
+     * @return Id of the root, or -1 if the library has no root ids
+     */
+    int addLibraryRoot(const QString& directoryPath);
+
+    /**
+     * @brief Move a library root to a new mount point, see LibraryRoots::relocateRoot()
+     * @param rootId Id from addLibraryRoot() or libraryRoots()
+     * @param newPath Directory the files of the root are in now
+     * @return true if the root and its tracks were moved
+     */
+    bool relocateLibraryRoot(int rootId, const QString& newPath);
+
+    /**
+     * @brief Paths of the library roots by id
+     */
+    QMap<int, QString> libraryRoots();
+
+    /**
+     * @brief Function that hashes the audio of a file, usually ContentHash::ofFile()
+     * @return Hash, or an empty string if the file cannot be read
+     */
+    using ContentHasher = std::function<QString(const QString& filePath)>;
+
+    /**
+     * @brief Set how addMusicBatch() hashes new tracks
+     *
+     * The hasher is called from pool threads and must be thread-safe.
+     * Without one, tracks are only checked by path.
+     * @param hasher Hash function, or nullptr to stop hashing
+     */
+    void setContentHasher(ContentHasher hasher);
+
+    /**
+     * @brief Add the content_hash column and its index to musics if missing
+     *
+     * Static so the legacy dialogs that insert into musics directly can
+     * check for duplicates too.
+     * @param database Open database holding the musics table
+     * @return true if the column and index are available
+     */
+    static bool ensureContentHashColumn(QSqlDatabase& database);
+
+    /**
+     * @brief Find the track with the given audio
+     *
+     * A single lookup through idx_musics_content_hash.
+     * @param contentHash Hash from ContentHash::ofFile()
+     * @return The earliest track with that hash, or an item with id -1
+     */
+    MusicItem findMusicByContentHash(const QString& contentHash);
+
+    /**
+     * @brief List the tracks that hold the same audio as another track
+     * @return One group per hash shared by more than one track; every
+     *         group is ordered by id, so the first item is the original
+     */
+    QList<QList<MusicItem>> findContentDuplicates();
+
+    /**
+     * @brief Get the paths of tracks added before content hashing
+     * @param limit Maximum number of paths (-1 for no limit)
+     * @return Paths whose content_hash is not set
+     */
+    QStringList getPathsWithoutContentHash(int limit = -1);
+
+    /**
+     * @brief Store content hashes for existing tracks
+     * @param hashesByPath Hash for each path
+     * @return Number of tracks updated
+     */
+    int setContentHashes(const QHash<QString, QString>& hashesByPath);
+    
+    /**
+     * @brief Build the item for a new file from its tags
+     *
+     * An "Artist - Song" file name fills in what the tags leave out, and
+     * the genre defaults to "Unknown".
+     * @param filePath Path of the audio file
+     * @param tags Tags read from it
+     * @return MusicItem ready for addMusicBatch()
+     */
+    static MusicItem itemFromTags(const QString& filePath, const TagReader::Tags& tags);
+    
+    /**
+     * @brief Find which of the given paths are in the library
+     * @param paths Paths to look up
+     * @return The given paths that have a track, as they were passed in
+     */
+    QSet<QString> existingPaths(const QStringList& paths);
+    
+    /**
+     * @brief Update tracks whose files changed on disk, committing in chunks
+     *
+     * Tracks are matched by path. time and content_hash are always
+     * replaced; artist, song, genre1 and published_date only when the item
+     * has a value, so fields edited in XFB survive a file without tags.
+     * Items without contentHash are hashed with the content hasher.
+     * @param musicList Items carrying the path and the values read from the file
+     * @return Number of tracks updated
+     */
+    int refreshMusicBatch(const QList<MusicItem>& musicList);
+    
+    /**
+     * @brief Move tracks to new paths, keeping their play history
+     * @param newPathsByOldPath New path for each old path
+     * @return Number of tracks moved
+     */
+    int renameMusicBatch(const QHash<QString, QString>& newPathsByOldPath);
+    
+    /**
+     * @brief Remove the tracks stored at the given paths, committing in chunks
+     * @param paths Paths of files that are gone
+     * @return Number of tracks removed
+     */
+    int removeMusicBatch(const QStringList& paths);
+
+    /**
+     * @brief Delete tracks by ID in a single transaction
+     *
+     * Runs one DELETE per IMPORT_CHUNK_SIZE IDs; either every track is
+     * deleted or, on failure, none is.
+     * @param musicIds IDs to delete; duplicates are ignored
+     * @param deletedPaths Filled with the path of each track deleted, by ID
+     * @return Number of tracks deleted, or -1 on failure
+     */
+    int deleteMusicBatch(const QList<int>& musicIds, QHash<int, QString>* deletedPaths = nullptr);
+
     /**
      * @brief Validate music item data
      * @param music MusicItem to validate
@@ -288,6 +650,12 @@ signals:
      */
     void musicDeleted(int musicId);
 
+    /**
+     * @brief Emitted when a music item's play count was incremented
+     * @param musicId ID of the played music item
+     */
+    void playCountIncremented(int musicId);
+
     /**
      * @brief Emitted when a batch import operation progresses
      * @param processed Number of files processed
@@ -313,6 +681,9 @@ signals:
 private:
     /**
      * @brief Extract metadata from audio file
+     *
+     * Tags are read with TagReader; an "Artist - Song" file name fills in
+     * what they leave out.
      * @param filePath Path to audio file
      * @return MusicItem with extracted metadata
      */
@@ -355,18 +726,128 @@ private:
      */
     bool executeQuery(QSqlQuery& query, const QString& operation);
 
+    /**
+     * @brief Get a statement from the prepared statement cache, preparing it the first time
+     *
+     * For queries run again and again with new values, so SQLite plans them
+     * once. The caller holds m_mutex and binds all the values before exec().
+     * @param sql Statement with ? placeholders
+     * @param operation Operation name for error logging
+     * @return The prepared query, or nullptr if it cannot be prepared
+     */
+    QSqlQuery* preparedQuery(const QString& sql, const QString& operation);
+
+    /**
+     * @brief Build a MusicItem from the current row of a query
+     *
+     * The query must select id, artist, song, genre1, genre2, country,
+     * published_date, path, time, played_times and last_played in that order.
+     * @param query Query positioned on a row
+     * @return MusicItem for the row
+     */
+    static MusicItem musicFromRow(const QSqlQuery& query);
+
+    /**
+     * @brief Look up which of the given paths are already in the library
+     *
+     * Runs one query per IMPORT_CHUNK_SIZE paths. The caller holds m_mutex.
+     * @param paths Sanitized paths
+     * @return The subset of paths present in the musics table
+     */
+    QSet<QString> findExistingPaths(const QStringList& paths);
+
+    /**
+     * @brief Look up which of the given content hashes are already in the library
+     *
+     * Runs one query per IMPORT_CHUNK_SIZE hashes. The caller holds m_mutex.
+     * @param hashes Content hashes
+     * @return The subset of hashes present in the musics table
+     */
+    QSet<QString> findExistingContentHashes(const QStringList& hashes);
+
+    /**
+     * @brief Look up the ID of the track at a sanitized path
+     *
+     * The caller holds m_mutex.
+     * @return Music ID, or -1 if the path is not in the library
+     */
+    int findIdByPath(const QString& path);
+
+    /**
+     * @brief Bind root_id, rel_path and path_hash of a sanitized path
+     *
+     * The caller holds m_mutex and has checked libraryRootsReady().
+     */
+    void bindLocation(QSqlQuery& query, const QString& path);
+
+    /**
+     * @brief Check for the library roots once, adding them if needed
+     *
+     * The caller holds m_mutex.
+     * @return true if tracks can be looked up by location
+     */
+    bool libraryRootsReady();
+
+    /**
+     * @brief Create the index on musics.path used by duplicate lookups
+     *
+     * The index is not unique, so libraries that already hold duplicate
+     * paths keep working. The caller holds m_mutex.
+     */
+    void ensurePathIndex();
+
+    /**
+     * @brief Create the (artist, song) index used by the paged list APIs
+     *
+     * The caller holds m_mutex.
+     */
+    void ensureSortIndex();
+
+    /**
+     * @brief Create the indexes used by MusicListModel's range and genre filters
+     *
+     * Covers played_times, last_played, durationSecondsSql() and genre1 and
+     * genre2 without case. The caller holds m_mutex.
+     */
+    void ensureFilterIndexes();
+
+    /**
+     * @brief Check for the statistics tables once, creating them if needed
+     *
+     * The caller holds m_mutex.
+     * @return true if getStatistics() can read musics_stats
+     */
+    bool statisticsReady();
+
+    /**
+     * @brief Check for the full-text index once, creating it if needed
+     *
+     * The caller holds m_mutex.
+     * @return true if the index is available
+     */
+    bool fullTextIndexReady();
+
     QSqlDatabase& m_database;
     mutable QMutex m_mutex;
     QMimeDatabase m_mimeDatabase;
     
     // Prepared statement cache
-    mutable QHash<QString, std::unique_ptr<QSqlQuery>> m_preparedQueries;
+    std::unordered_map<QString, std::unique_ptr<QSqlQuery>> m_preparedQueries;   ///< By their SQL
+    std::unique_ptr<QSqlQuery> m_playCountQuery;
+    std::unique_ptr<QSqlQuery> m_idByPathQuery;
+    ContentHasher m_contentHasher;
+    LibraryRoots m_libraryRoots;
+    bool m_libraryRootsChecked = false;
+    bool m_pathIndexReady = false;
+    bool m_contentHashReady = false;
+    bool m_sortIndexReady = false;
+    bool m_filterIndexesReady = false;
+    bool m_fullTextChecked = false;
+    bool m_fullTextAvailable = false;
+    bool m_statisticsChecked = false;
+    bool m_statisticsAvailable = false;
     
-    // Statistics cache
-    mutable QMutex m_statsMutex;
-    mutable MusicStats m_cachedStats;
-    mutable QDateTime m_statsLastUpdated;
-    static constexpr int STATS_CACHE_DURATION_MS = 60000; // 1 minute
+    static constexpr int IMPORT_CHUNK_SIZE = 500;          // items per import transaction
 };
 
 #endif // MUSICREPOSITORY_H
\ No newline at end of file
@@ -0,0 +1,90 @@
+#include "NowPlayingStatus.h"
+#include <QDebug>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QVariant>
+
+namespace {
+
+bool execLogged(QSqlQuery& query, const QString& operation)
+{
+    if (query.exec()) {
+        return true;
+    }
+    qWarning() << QString("NowPlayingStatus::%1 - SQL Error: %2 (Query: %3)")
+                      .arg(operation, query.lastError().text(), query.lastQuery());
+    return false;
+}
+
+} // namespace
+
+NowPlayingStatus::NowPlayingStatus(const QSqlDatabase& database)
+    : m_database(database)
+{
+}
+
+bool NowPlayingStatus::ensureTable()
+{
+    QSqlQuery query(m_database);
+    query.prepare("CREATE TABLE IF NOT EXISTS now_playing ("
+                  "id INTEGER PRIMARY KEY CHECK (id = 1), "
+                  "path TEXT, "
+                  "title TEXT, "
+                  "started_at INTEGER, "
+                  "duration_ms INTEGER, "
+                  "upcoming TEXT)");
+    return execLogged(query, "ensureTable");
+}
+
+bool NowPlayingStatus::write(const Entry& entry)
+{
+    const QStringList upcoming = entry.upcoming.mid(0, UPCOMING_LIMIT);
+    QSqlQuery query(m_database);
+    query.prepare("INSERT OR REPLACE INTO now_playing "
+                  "(id, path, title, started_at, duration_ms, upcoming) "
+                  "VALUES (1, ?, ?, ?, ?, ?)");
+    query.addBindValue(entry.path);
+    query.addBindValue(entry.title);
+    query.addBindValue(entry.startedAt.isValid() ? QVariant(entry.startedAt.toMSecsSinceEpoch())
+                                                 : QVariant());
+    query.addBindValue(entry.durationMs);
+    query.addBindValue(QString::fromUtf8(
+        QJsonDocument(QJsonArray::fromStringList(upcoming)).toJson(QJsonDocument::Compact)));
+    return execLogged(query, "write");
+}
+
+NowPlayingStatus::Entry NowPlayingStatus::read(bool* ok) const
+{
+    Entry entry;
+    QSqlQuery query(m_database);
+    query.setForwardOnly(true);
+    query.prepare("SELECT path, title, started_at, duration_ms, upcoming FROM now_playing "
+                  "WHERE id = 1");
+    const bool succeeded = execLogged(query, "read");
+    if (ok) {
+        *ok = succeeded;
+    }
+    if (!succeeded || !query.next()) {
+        return entry;
+    }
+
+    entry.path = query.value(0).toString();
+    entry.title = query.value(1).toString();
+    if (!query.value(2).isNull()) {
+        entry.startedAt = QDateTime::fromMSecsSinceEpoch(query.value(2).toLongLong());
+    }
+    entry.durationMs = query.value(3).isNull() ? -1 : query.value(3).toLongLong();
+    const QJsonArray upcoming = QJsonDocument::fromJson(query.value(4).toByteArray()).array();
+    for (const QJsonValue& path : upcoming) {
+        entry.upcoming.append(path.toString());
+    }
+    return entry;
+}
+
+QString NowPlayingStatus::titleOf(const QString& path)
+{
+    return QFileInfo(path).completeBaseName();
+}
@@ -0,0 +1,86 @@
+#ifndef NOWPLAYINGSTATUS_H
+#define NOWPLAYINGSTATUS_H
+
+#include <QDateTime>
+#include <QMetaType>
+#include <QSqlDatabase>
+#include <QString>
+#include <QStringList>
+
+/**
+ * @brief One-row table saying what is on air and what comes next
+ *
+ * Lobby screens and other secondary displays only need to know what is
+ * playing. Rather than each of them running a copy of the automation, the
+ * instance on air writes the now_playing table here when a track starts or
+ * the queue changes, and the displays read it through NowPlayingMonitor on
+ * a read-only connection.
+ *
+ * The table holds a single row, replaced on every write, so a display's
+ * poll reads a few hundred bytes whatever the size of the library.
+ *
+ * @example
+ * @code
+ * NowPlayingStatus status(database);
+ * status.ensureTable();
+ * status.write({"/music/song.ogg", "song", QDateTime::currentDateTime(), 215000,
+ *               {"/music/next.ogg"}});
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class NowPlayingStatus
+{
+public:
+    static constexpr int UPCOMING_LIMIT = 5;   ///< Items of the queue kept in the table
+
+    struct Entry {
+        QString path;             ///< Empty when nothing is on air
+        QString title;
+        QDateTime startedAt;
+        qint64 durationMs = -1;   ///< -1 if unknown
+        QStringList upcoming;     ///< Paths due next, first one first
+
+        bool isEmpty() const { return path.isEmpty(); }
+        bool operator==(const Entry& other) const
+        {
+            return path == other.path && title == other.title && startedAt == other.startedAt &&
+                   durationMs == other.durationMs && upcoming == other.upcoming;
+        }
+        bool operator!=(const Entry& other) const { return !(*this == other); }
+    };
+
+    /**
+     * @param database Connection to the library database
+     */
+    explicit NowPlayingStatus(const QSqlDatabase& database);
+
+    /**
+     * @brief Create the now_playing table if it is missing
+     */
+    bool ensureTable();
+
+    /**
+     * @brief Replace the row; only the first UPCOMING_LIMIT upcoming paths are kept
+     */
+    bool write(const Entry& entry);
+
+    /**
+     * @brief Read the row
+     * @param ok Set to false if the table cannot be read; a missing row is no error
+     * @return The entry, empty before anything was written
+     */
+    Entry read(bool* ok = nullptr) const;
+
+    /**
+     * @brief Title shown for a path, its file name without the extension
+     */
+    static QString titleOf(const QString& path);
+
+private:
+    QSqlDatabase m_database;
+};
+
+Q_DECLARE_METATYPE(NowPlayingStatus::Entry)
+
+#endif // NOWPLAYINGSTATUS_H
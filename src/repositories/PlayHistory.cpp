@@ -0,0 +1,289 @@
+#include "PlayHistory.h"
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QVariant>
+
+namespace {
+
+const QString SCHEMA_PREFIX = "history_";
+
+bool execLogged(QSqlQuery& query, const QString& operation)
+{
+    if (query.exec()) {
+        return true;
+    }
+    qWarning() << QString("PlayHistory::%1 - SQL Error: %2 (Query: %3)")
+                      .arg(operation, query.lastError().text(), query.lastQuery());
+    return false;
+}
+
+bool execLogged(QSqlQuery& query, const QString& operation, const QString& sql)
+{
+    if (query.exec(sql)) {
+        return true;
+    }
+    qWarning() << QString("PlayHistory::%1 - SQL Error: %2 (Query: %3)")
+                      .arg(operation, query.lastError().text(), sql);
+    return false;
+}
+
+bool isMonth(const QString& month)
+{
+    static const QRegularExpression pattern("^\\d{4}-\\d{2}$");
+    return pattern.match(month).hasMatch();
+}
+
+} // namespace
+
+PlayHistory::PlayHistory(const QSqlDatabase& database, const QString& directory)
+    : m_database(database)
+    , m_directory(directory.isEmpty() ? defaultDirectory(database) : directory)
+{
+}
+
+QString PlayHistory::defaultDirectory(const QSqlDatabase& database)
+{
+    const QString name = database.databaseName();
+    if (name.isEmpty() || name == ":memory:") {
+        return QString();
+    }
+    return QFileInfo(name).absoluteDir().filePath("history");
+}
+
+QString PlayHistory::monthKey(const QDate& date)
+{
+    return date.toString("yyyy-MM");
+}
+
+QString PlayHistory::partitionPath(const QString& month) const
+{
+    return QDir(m_directory).filePath(QString("plays-%1.db").arg(month));
+}
+
+QStringList PlayHistory::months() const
+{
+    QStringList result;
+    if (m_directory.isEmpty()) {
+        return result;
+    }
+    const QStringList files = QDir(m_directory).entryList({"plays-*.db"}, QDir::Files, QDir::Name);
+    for (const QString& file : files) {
+        const QString month = file.mid(6, 7);
+        if (isMonth(month) && file.size() == 16) {
+            result.append(month);
+        }
+    }
+    return result;
+}
+
+QString PlayHistory::schemaName(const QString& month)
+{
+    return SCHEMA_PREFIX + QString(month).replace('-', '_');
+}
+
+QStringList PlayHistory::attachedMonths() const
+{
+    QStringList result;
+    QSqlQuery query(m_database);
+    if (!execLogged(query, "attachedMonths", "PRAGMA database_list")) {
+        return result;
+    }
+    while (query.next()) {
+        const QString name = query.value("name").toString();
+        if (name.startsWith(SCHEMA_PREFIX)) {
+            result.append(name.mid(SCHEMA_PREFIX.size()).replace('_', '-'));
+        }
+    }
+    return result;
+}
+
+bool PlayHistory::attach(const QString& month, bool create) const
+{
+    if (m_directory.isEmpty() || !isMonth(month)) {
+        qWarning() << "PlayHistory::attach - no history directory or bad month" << month;
+        return false;
+    }
+    if (attachedMonths().contains(month)) {
+        return true;
+    }
+    if (!create && !QFileInfo::exists(partitionPath(month))) {
+        return false;
+    }
+    if (create && !QDir().mkpath(m_directory)) {
+        qWarning() << "PlayHistory::attach - cannot create" << m_directory;
+        return false;
+    }
+
+    const QString schema = schemaName(month);
+    QSqlQuery query(m_database);
+    query.prepare(QString("ATTACH DATABASE ? AS %1").arg(schema));
+    query.addBindValue(partitionPath(month));
+    if (!execLogged(query, "attach")) {
+        return false;
+    }
+    if (!create) {
+        return true;
+    }
+
+    const QStringList statements = {
+        QString("CREATE TABLE IF NOT EXISTS %1.plays (id INTEGER PRIMARY KEY, "
+                "played_at INTEGER NOT NULL, path TEXT NOT NULL, music_id INTEGER, "
+                "artist TEXT, song TEXT, duration TEXT)").arg(schema),
+        QString("CREATE INDEX IF NOT EXISTS %1.plays_played_at ON plays(played_at)").arg(schema)
+    };
+    for (const QString& sql : statements) {
+        if (!execLogged(query, "attach", sql)) {
+            detach(month);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool PlayHistory::detach(const QString& month) const
+{
+    QSqlQuery query(m_database);
+    return execLogged(query, "detach", QString("DETACH DATABASE %1").arg(schemaName(month)));
+}
+
+bool PlayHistory::prepare(const QStringList& months)
+{
+    QSqlQuery query(m_database);
+    if (!execLogged(query, "prepare",
+                    "CREATE TABLE IF NOT EXISTS play_history_monthly (month TEXT NOT NULL, "
+                    "path TEXT NOT NULL, artist TEXT, song TEXT, plays INTEGER NOT NULL DEFAULT 0, "
+                    "first_played INTEGER, last_played INTEGER, PRIMARY KEY (month, path)) "
+                    "WITHOUT ROWID")) {
+        return false;
+    }
+
+    // Only the months being written stay attached, well within SQLite's limit of ten
+    for (const QString& attached : attachedMonths()) {
+        if (!months.contains(attached)) {
+            detach(attached);
+        }
+    }
+    for (const QString& month : months) {
+        if (!attach(month, true)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool PlayHistory::append(const QList<Play>& plays)
+{
+    // LIMIT 1: a path listed twice in musics is still one play
+    const QString logSql =
+        "INSERT INTO %1.plays (played_at, path, music_id, artist, song, duration) "
+        "SELECT ?, ?, m.id, m.artist, m.song, m.time FROM (SELECT 1) "
+        "LEFT JOIN main.musics m ON m.path = ? LIMIT 1";
+    QSqlQuery count(m_database);
+    count.prepare("INSERT INTO main.play_history_monthly "
+                  "(month, path, artist, song, plays, first_played, last_played) "
+                  "SELECT ?, ?, m.artist, m.song, 1, ?, ? FROM (SELECT 1) "
+                  "LEFT JOIN main.musics m ON m.path = ? WHERE true LIMIT 1 "
+                  "ON CONFLICT (month, path) DO UPDATE SET plays = plays + 1, "
+                  "first_played = min(first_played, excluded.first_played), "
+                  "last_played = max(last_played, excluded.last_played)");
+
+    QString preparedMonth;
+    QSqlQuery log(m_database);
+    for (const Play& play : plays) {
+        const QString month = monthKey(play.playedAt.date());
+        if (month != preparedMonth) {
+            log.prepare(logSql.arg(schemaName(month)));
+            preparedMonth = month;
+        }
+        const qint64 playedAt = play.playedAt.toMSecsSinceEpoch();
+
+        log.addBindValue(playedAt);
+        log.addBindValue(play.path);
+        log.addBindValue(play.path);
+        if (!execLogged(log, "append")) {
+            return false;
+        }
+
+        count.addBindValue(month);
+        count.addBindValue(play.path);
+        count.addBindValue(playedAt);
+        count.addBindValue(playedAt);
+        count.addBindValue(play.path);
+        if (!execLogged(count, "append")) {
+            return false;
+        }
+    }
+    return true;
+}
+
+QList<PlayHistory::Play> PlayHistory::plays(const QDateTime& from, const QDateTime& to) const
+{
+    QList<Play> result;
+    if (!from.isValid() || !to.isValid() || from >= to) {
+        return result;
+    }
+
+    const QStringList attached = attachedMonths();
+    QDate month(from.date().year(), from.date().month(), 1);
+    const QDate last = to.addMSecs(-1).date();
+    for (; month <= last; month = month.addMonths(1)) {
+        const QString key = monthKey(month);
+        if (!attach(key, false)) {
+            continue;
+        }
+
+        QSqlQuery query(m_database);
+        query.prepare(QString("SELECT played_at, path, music_id, artist, song, duration "
+                              "FROM %1.plays WHERE played_at >= ? AND played_at < ? "
+                              "ORDER BY played_at, id").arg(schemaName(key)));
+        query.addBindValue(from.toMSecsSinceEpoch());
+        query.addBindValue(to.toMSecsSinceEpoch());
+        if (execLogged(query, "plays")) {
+            while (query.next()) {
+                Play play;
+                play.playedAt = QDateTime::fromMSecsSinceEpoch(query.value(0).toLongLong());
+                play.path = query.value(1).toString();
+                play.musicId = query.value(2).isNull() ? -1 : query.value(2).toInt();
+                play.artist = query.value(3).toString();
+                play.song = query.value(4).toString();
+                play.duration = query.value(5).toString();
+                result.append(play);
+            }
+        }
+        query.finish();
+
+        // A month a writer has attached stays attached for it
+        if (!attached.contains(key)) {
+            detach(key);
+        }
+    }
+    return result;
+}
+
+QList<PlayHistory::MonthlyEntry> PlayHistory::monthlySummary(const QString& month) const
+{
+    QList<MonthlyEntry> result;
+    QSqlQuery query(m_database);
+    query.prepare("SELECT path, artist, song, plays, first_played, last_played "
+                  "FROM play_history_monthly WHERE month = ? ORDER BY plays DESC, path");
+    query.addBindValue(month);
+    if (!execLogged(query, "monthlySummary")) {
+        return result;
+    }
+    while (query.next()) {
+        MonthlyEntry entry;
+        entry.month = month;
+        entry.path = query.value(0).toString();
+        entry.artist = query.value(1).toString();
+        entry.song = query.value(2).toString();
+        entry.plays = query.value(3).toInt();
+        entry.firstPlayed = QDateTime::fromMSecsSinceEpoch(query.value(4).toLongLong());
+        entry.lastPlayed = QDateTime::fromMSecsSinceEpoch(query.value(5).toLongLong());
+        result.append(entry);
+    }
+    return result;
+}
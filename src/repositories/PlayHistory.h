@@ -0,0 +1,141 @@
+#ifndef PLAYHISTORY_H
+#define PLAYHISTORY_H
+
+#include <QDate>
+#include <QDateTime>
+#include <QList>
+#include <QSqlDatabase>
+#include <QString>
+#include <QStringList>
+
+/**
+ * @brief Every play that went on air, kept for as-run and royalty reports
+ *
+ * musics only keeps the count of plays of a track and when it last played.
+ * PlayHistory appends a row per play to a plays table in a database file of
+ * its own for each month, plays-YYYY-MM.db in directory(), so the library
+ * database does not grow with years of round-the-clock logging, and an old
+ * month can be archived or removed by moving its file.
+ *
+ * A month is attached to the connection while it is written or read. Along
+ * with each play, the play_history_monthly table of the main database counts
+ * the plays of each path in the month, so royalty summaries read one small
+ * table instead of every play.
+ *
+ * Plays are stored with the artist, title and duration the library had for
+ * the path at the time, so a report still names a track that was renamed or
+ * removed since. Paths not in the library, jingles and ads, are logged too,
+ * without them.
+ *
+ * SQLite cannot attach databases inside a transaction, so a writer calls
+ * prepare() for the months of its batch first, then append() inside its
+ * transaction: the plays and the summary are committed together.
+ *
+ * @example
+ * @code
+ * PlayHistory history(database);
+ * history.prepare({PlayHistory::monthKey(QDate::currentDate())});
+ * database.transaction();
+ * history.append({{"/music/song.ogg", QDateTime::currentDateTime()}});
+ * database.commit();
+ *
+ * QList<PlayHistory::MonthlyEntry> royalties = history.monthlySummary("2026-09");
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class PlayHistory
+{
+public:
+    struct Play {
+        QString path;
+        QDateTime playedAt;
+        int musicId = -1;     ///< -1 for paths not in the library
+        QString artist;
+        QString song;
+        QString duration;
+    };
+
+    struct MonthlyEntry {
+        QString month;        ///< "YYYY-MM"
+        QString path;
+        QString artist;
+        QString song;
+        int plays = 0;
+        QDateTime firstPlayed;
+        QDateTime lastPlayed;
+    };
+
+    /**
+     * @param database Connection to the library database
+     * @param directory Where the monthly files go; defaultDirectory() if empty
+     */
+    explicit PlayHistory(const QSqlDatabase& database, const QString& directory = QString());
+
+    /**
+     * @brief The history directory beside a database file, empty for an in-memory database
+     */
+    static QString defaultDirectory(const QSqlDatabase& database);
+
+    /**
+     * @brief Month a play belongs to, "YYYY-MM" in local time
+     */
+    static QString monthKey(const QDate& date);
+
+    QString directory() const { return m_directory; }
+
+    /**
+     * @brief Path of the file holding the plays of a month
+     */
+    QString partitionPath(const QString& month) const;
+
+    /**
+     * @brief Months with a file in directory(), oldest first
+     */
+    QStringList months() const;
+
+    /**
+     * @brief Create the summary table and attach the files of the given months
+     *
+     * Files of other months attached before are detached. Must be called
+     * outside a transaction.
+     * @param months Months to write, as monthKey() gives them
+     * @return true if every month is attached and has its plays table
+     */
+    bool prepare(const QStringList& months);
+
+    /**
+     * @brief Log plays and count them in the monthly summary
+     *
+     * The months of the plays must have been given to prepare(). Run inside
+     * the caller's transaction; the library columns of each play are read
+     * from musics.
+     * @param plays Plays with path and playedAt set
+     * @return true if every play was logged
+     */
+    bool append(const QList<Play>& plays);
+
+    /**
+     * @brief Plays from one time up to, but not including, another
+     *
+     * Each month in the range is attached while it is read. Must be called
+     * outside a transaction.
+     */
+    QList<Play> plays(const QDateTime& from, const QDateTime& to) const;
+
+    /**
+     * @brief Plays of each path in a month, most played first
+     */
+    QList<MonthlyEntry> monthlySummary(const QString& month) const;
+
+private:
+    static QString schemaName(const QString& month);
+    QStringList attachedMonths() const;
+    bool attach(const QString& month, bool create) const;
+    bool detach(const QString& month) const;
+
+    QSqlDatabase m_database;
+    QString m_directory;
+};
+
+#endif // PLAYHISTORY_H
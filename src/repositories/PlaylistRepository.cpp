@@ -1,4 +1,5 @@
 #include "PlaylistRepository.h"
+#include "../services/QueryTimer.h"
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QVariant>
@@ -192,7 +193,7 @@ QList<PlaylistItem> PlaylistRepository::getAllPlaylists(int limit, int offset)
 {
     QMutexLocker locker(&m_mutex);
     
-    QString queryString = "SELECT id, name, path FROM programs ORDER BY name";
+    QString queryString = "SELECT id, name, path FROM programs ORDER BY name, id";
     
     if (limit > 0) {
         queryString += QString(" LIMIT %1").arg(limit);
@@ -222,6 +223,47 @@ QList<PlaylistItem> PlaylistRepository::getAllPlaylists(int limit, int offset)
     return results;
 }
 
+QList<PlaylistItem> PlaylistRepository::getPlaylistsAfter(const QString& lastName, int lastId, int limit)
+{
+    QMutexLocker locker(&m_mutex);
+    
+    QList<PlaylistItem> results;
+    if (limit <= 0) {
+        return results;
+    }
+    
+    QString queryString = "SELECT id, name, path FROM programs";
+    if (lastId >= 0) {
+        queryString += " WHERE (name, id) > (?, ?)";
+    }
+    queryString += " ORDER BY name, id LIMIT ?";
+    
+    QSqlQuery query(m_database);
+    query.setForwardOnly(true);
+    query.prepare(queryString);
+    
+    if (lastId >= 0) {
+        query.addBindValue(lastName);
+        query.addBindValue(lastId);
+    }
+    query.addBindValue(limit);
+    
+    if (!executeQuery(query, "getPlaylistsAfter")) {
+        return results;
+    }
+    
+    while (query.next()) {
+        QVariantMap map;
+        map["id"] = query.value("id");
+        map["name"] = query.value("name");
+        map["path"] = query.value("path");
+        
+        results.append(PlaylistItem::fromVariantMap(map));
+    }
+    
+    return results;
+}
+
 QList<PlaylistItem> PlaylistRepository::searchPlaylists(const SearchCriteria& criteria)
 {
     QMutexLocker locker(&m_mutex);
@@ -573,7 +615,13 @@ void PlaylistRepository::logError(const QString& operation, const QString& error
 
 bool PlaylistRepository::executeQuery(QSqlQuery& query, const QString& operation)
 {
-    if (!query.exec()) {
+    bool success;
+    {
+        QueryTimer timer(query.lastQuery());
+        success = query.exec();
+    }
+    
+    if (!success) {
         QString error = QString("SQL Error: %1").arg(query.lastError().text());
         logError(operation, error, query.lastQuery());
         emit operationError(operation, error);
@@ -191,6 +191,18 @@ public:
      */
     QList<PlaylistItem> getAllPlaylists(int limit = -1, int offset = 0);
 
+    /**
+     * @brief Get the page of playlists that follows a given playlist
+     *
+     * Keyset pagination in name, id order: the query seeks past the last
+     * playlist of the previous page instead of skipping offset rows.
+     * @param lastName Name of the last playlist already shown
+     * @param lastId ID of the last playlist already shown, or -1 for the first page
+     * @param limit Maximum number of items to return
+     * @return List of PlaylistItem objects
+     */
+    QList<PlaylistItem> getPlaylistsAfter(const QString& lastName, int lastId, int limit);
+
     /**
      * @brief Search playlists based on criteria
      * @param criteria Search criteria
@@ -0,0 +1,259 @@
+#include "ProofOfPlay.h"
+#include <QDebug>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QStringList>
+#include <QVariant>
+
+namespace {
+
+bool execLogged(QSqlQuery& query, const QString& operation, const QString& sql = QString())
+{
+    if (sql.isEmpty() ? query.exec() : query.exec(sql)) {
+        return true;
+    }
+    qWarning() << QString("ProofOfPlay::%1 - SQL Error: %2 (Query: %3)")
+                      .arg(operation, query.lastError().text(),
+                           sql.isEmpty() ? query.lastQuery() : sql);
+    return false;
+}
+
+QString kindName(ProofOfPlay::Kind kind)
+{
+    return kind == ProofOfPlay::Kind::Program ? "program" : "pub";
+}
+
+ProofOfPlay::Kind kindOf(const QString& name)
+{
+    return name == "program" ? ProofOfPlay::Kind::Program : ProofOfPlay::Kind::Pub;
+}
+
+QString tableOf(ProofOfPlay::Kind kind)
+{
+    return kind == ProofOfPlay::Kind::Program ? "programs" : "pub";
+}
+
+QVariant msecs(const QDateTime& time)
+{
+    return time.isValid() ? QVariant(time.toMSecsSinceEpoch()) : QVariant();
+}
+
+QDateTime dateTime(const QVariant& value)
+{
+    return value.isNull() ? QDateTime() : QDateTime::fromMSecsSinceEpoch(value.toLongLong());
+}
+
+} // namespace
+
+ProofOfPlay::ProofOfPlay(const QSqlDatabase& database)
+    : m_database(database)
+{
+}
+
+bool ProofOfPlay::ensure()
+{
+    const QStringList statements = {
+        "CREATE TABLE IF NOT EXISTS proof_of_play (id INTEGER PRIMARY KEY, kind TEXT NOT NULL, "
+        "item_id INTEGER, path TEXT NOT NULL, campaign TEXT NOT NULL, scheduled_at INTEGER, "
+        "started_at INTEGER NOT NULL, duration_ms INTEGER NOT NULL)",
+        "CREATE INDEX IF NOT EXISTS idx_proof_of_play_started_at ON proof_of_play(started_at)",
+        "CREATE TABLE IF NOT EXISTS proof_of_play_monthly (month TEXT NOT NULL, "
+        "kind TEXT NOT NULL, campaign TEXT NOT NULL, item_id INTEGER NOT NULL, path TEXT, "
+        "airings INTEGER NOT NULL DEFAULT 0, aired_ms INTEGER NOT NULL DEFAULT 0, "
+        "late_ms INTEGER NOT NULL DEFAULT 0, first_aired INTEGER, last_aired INTEGER, "
+        "PRIMARY KEY (month, kind, campaign, item_id)) WITHOUT ROWID"
+    };
+    QSqlQuery query(m_database);
+    for (const QString& sql : statements) {
+        if (!execLogged(query, "ensure", sql)) {
+            return false;
+        }
+    }
+    m_ready = true;
+    return true;
+}
+
+bool ProofOfPlay::prepareLookup(QSqlQuery& lookup, Kind kind) const
+{
+    const QString table = tableOf(kind);
+    QSqlQuery query(m_database);
+    if (!execLogged(query, "prepareLookup", QString("PRAGMA table_info(%1)").arg(table))) {
+        return false;
+    }
+    QStringList columns;
+    while (query.next()) {
+        columns << query.value(1).toString();
+    }
+    if (!columns.contains("name")) {
+        return false;
+    }
+    // Older libraries have no customer until AdBreakPacker adds it
+    const QString campaign = columns.contains("customer")
+                                 ? "coalesce(nullif(trim(customer), ''), nullif(trim(name), ''))"
+                                 : "nullif(trim(name), '')";
+    // pub and programs are small, so the path needs no index
+    return lookup.prepare(QString("SELECT id, %1 FROM %2 WHERE id = ? OR (? < 0 AND path = ?) "
+                                  "ORDER BY id LIMIT 1").arg(campaign, table));
+}
+
+bool ProofOfPlay::lookUp(QSqlQuery& lookup, Airing& airing)
+{
+    lookup.addBindValue(airing.itemId);
+    lookup.addBindValue(airing.itemId);
+    lookup.addBindValue(airing.path);
+    if (!execLogged(lookup, "lookUp")) {
+        return false;
+    }
+    if (lookup.next()) {
+        airing.itemId = lookup.value(0).toInt();
+        airing.campaign = lookup.value(1).toString();
+    }
+    lookup.finish();
+    return true;
+}
+
+bool ProofOfPlay::resolve(Airing& airing) const
+{
+    QSqlQuery lookup(m_database);
+    if (prepareLookup(lookup, airing.kind) && !lookUp(lookup, airing)) {
+        return false;
+    }
+    if (airing.campaign.isEmpty()) {
+        airing.campaign = airing.path;
+    }
+    return true;
+}
+
+bool ProofOfPlay::append(const QList<Airing>& airings)
+{
+    if (airings.isEmpty()) {
+        return true;
+    }
+    if (!m_ready && !ensure()) {
+        return false;
+    }
+
+    QSqlQuery pubLookup(m_database);
+    QSqlQuery programLookup(m_database);
+    const bool canLookUpPub = prepareLookup(pubLookup, Kind::Pub);
+    const bool canLookUpProgram = prepareLookup(programLookup, Kind::Program);
+
+    QSqlQuery log(m_database);
+    log.prepare("INSERT INTO proof_of_play (kind, item_id, path, campaign, scheduled_at, "
+                "started_at, duration_ms) VALUES (?, ?, ?, ?, ?, ?, ?)");
+    QSqlQuery count(m_database);
+    count.prepare("INSERT INTO proof_of_play_monthly (month, kind, campaign, item_id, path, "
+                  "airings, aired_ms, late_ms, first_aired, last_aired) "
+                  "VALUES (?, ?, ?, ?, ?, 1, ?, ?, ?, ?) "
+                  "ON CONFLICT (month, kind, campaign, item_id) DO UPDATE SET "
+                  "airings = airings + 1, aired_ms = aired_ms + excluded.aired_ms, "
+                  "late_ms = late_ms + excluded.late_ms, path = excluded.path, "
+                  "first_aired = min(first_aired, excluded.first_aired), "
+                  "last_aired = max(last_aired, excluded.last_aired)");
+
+    for (Airing airing : airings) {
+        const bool isProgram = airing.kind == Kind::Program;
+        if (airing.campaign.isEmpty() && (isProgram ? canLookUpProgram : canLookUpPub)
+            && !lookUp(isProgram ? programLookup : pubLookup, airing)) {
+            return false;
+        }
+        if (airing.campaign.isEmpty()) {
+            airing.campaign = airing.path;
+        }
+        const int itemId = airing.itemId;
+        const QString& campaign = airing.campaign;
+
+        const qint64 startedAt = airing.startedAt.toMSecsSinceEpoch();
+        const qint64 lateMs = airing.scheduledAt.isValid()
+                                  ? qMax<qint64>(0, airing.scheduledAt.msecsTo(airing.startedAt))
+                                  : 0;
+        log.addBindValue(kindName(airing.kind));
+        log.addBindValue(itemId >= 0 ? QVariant(itemId) : QVariant());
+        log.addBindValue(airing.path);
+        log.addBindValue(campaign);
+        log.addBindValue(msecs(airing.scheduledAt));
+        log.addBindValue(startedAt);
+        log.addBindValue(airing.durationMs);
+        if (!execLogged(log, "append")) {
+            return false;
+        }
+
+        count.addBindValue(airing.startedAt.date().toString("yyyy-MM"));
+        count.addBindValue(kindName(airing.kind));
+        count.addBindValue(campaign);
+        count.addBindValue(itemId);
+        count.addBindValue(airing.path);
+        count.addBindValue(airing.durationMs);
+        count.addBindValue(lateMs);
+        count.addBindValue(startedAt);
+        count.addBindValue(startedAt);
+        if (!execLogged(count, "append")) {
+            return false;
+        }
+    }
+    return true;
+}
+
+QList<ProofOfPlay::Airing> ProofOfPlay::airings(const QDateTime& from, const QDateTime& to,
+                                                const QString& campaign) const
+{
+    QList<Airing> result;
+    if (!from.isValid() || !to.isValid() || from >= to) {
+        return result;
+    }
+
+    QSqlQuery query(m_database);
+    query.setForwardOnly(true);
+    query.prepare(QString("SELECT kind, item_id, path, campaign, scheduled_at, started_at, "
+                          "duration_ms FROM proof_of_play WHERE started_at >= ? "
+                          "AND started_at < ?%1 ORDER BY started_at, id")
+                      .arg(campaign.isEmpty() ? "" : " AND campaign = ?"));
+    query.addBindValue(from.toMSecsSinceEpoch());
+    query.addBindValue(to.toMSecsSinceEpoch());
+    if (!campaign.isEmpty()) {
+        query.addBindValue(campaign);
+    }
+    if (!execLogged(query, "airings")) {
+        return result;
+    }
+    while (query.next()) {
+        Airing airing;
+        airing.kind = kindOf(query.value(0).toString());
+        airing.itemId = query.value(1).isNull() ? -1 : query.value(1).toInt();
+        airing.path = query.value(2).toString();
+        airing.campaign = query.value(3).toString();
+        airing.scheduledAt = dateTime(query.value(4));
+        airing.startedAt = dateTime(query.value(5));
+        airing.durationMs = query.value(6).toLongLong();
+        result.append(airing);
+    }
+    return result;
+}
+
+QList<ProofOfPlay::CampaignEntry> ProofOfPlay::campaignSummary(const QString& month) const
+{
+    QList<CampaignEntry> result;
+    QSqlQuery query(m_database);
+    query.prepare("SELECT kind, campaign, item_id, path, airings, aired_ms, late_ms, "
+                  "first_aired, last_aired FROM proof_of_play_monthly WHERE month = ? "
+                  "ORDER BY campaign, kind, item_id");
+    query.addBindValue(month);
+    if (!execLogged(query, "campaignSummary")) {
+        return result;
+    }
+    while (query.next()) {
+        CampaignEntry entry;
+        entry.month = month;
+        entry.kind = kindOf(query.value(0).toString());
+        entry.campaign = query.value(1).toString();
+        entry.itemId = query.value(2).toInt();
+        entry.path = query.value(3).toString();
+        entry.airings = query.value(4).toInt();
+        entry.airedMs = query.value(5).toLongLong();
+        entry.lateMs = query.value(6).toLongLong();
+        entry.firstAired = dateTime(query.value(7));
+        entry.lastAired = dateTime(query.value(8));
+        result.append(entry);
+    }
+    return result;
+}
@@ -0,0 +1,118 @@
+#ifndef PROOFOFPLAY_H
+#define PROOFOFPLAY_H
+
+#include <QDateTime>
+#include <QList>
+#include <QSqlDatabase>
+#include <QString>
+
+class QSqlQuery;
+
+/**
+ * @brief Proof that the pubs and programs of the scheduler went on air
+ *
+ * Scheduled items were only put on top of the playlist, and the journal
+ * noted that they fired; nothing said when they actually went on air or
+ * for how long, which is what an advertiser's affidavit has to state.
+ * ProofOfPlay keeps a row per airing in the proof_of_play table of the
+ * main database: the pub or programs id, the time it was scheduled for,
+ * the time it started and how long it played.
+ *
+ * Each airing is counted in proof_of_play_monthly as well, by month,
+ * campaign and item, so the affidavits of a month of ads are one read of
+ * a small table. The campaign of a pub is its customer, else its name, as
+ * AdBreakPacker groups spots; that of a program is its name. Either falls
+ * back to the path for an item no longer in its table.
+ *
+ * PlayHistoryWriter appends the airings inside its transaction, along
+ * with the plays.
+ *
+ * @example
+ * @code
+ * ProofOfPlay proofs(database);
+ * proofs.ensure();
+ * database.transaction();
+ * proofs.append({{ProofOfPlay::Kind::Pub, 12, "/pubs/spot.mp3", scheduledAt, startedAt, 30000}});
+ * database.commit();
+ *
+ * QList<ProofOfPlay::CampaignEntry> affidavits = proofs.campaignSummary("2026-09");
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class ProofOfPlay
+{
+public:
+    enum class Kind { Pub, Program };
+
+    struct Airing {
+        Kind kind = Kind::Pub;
+        int itemId = -1;          ///< pub or programs id; -1 to look it up by path
+        QString path;
+        QDateTime scheduledAt;
+        QDateTime startedAt;
+        qint64 durationMs = 0;
+        QString campaign;         ///< Looked up by resolve() or append() if empty
+    };
+
+    struct CampaignEntry {
+        QString month;            ///< "YYYY-MM"
+        Kind kind = Kind::Pub;
+        QString campaign;
+        int itemId = -1;
+        QString path;
+        int airings = 0;
+        qint64 airedMs = 0;
+        qint64 lateMs = 0;        ///< Sum of the delays from scheduled to actual start
+        QDateTime firstAired;
+        QDateTime lastAired;
+    };
+
+    explicit ProofOfPlay(const QSqlDatabase& database);
+
+    /**
+     * @brief Create the airings and summary tables
+     * @return true if they exist
+     */
+    bool ensure();
+
+    /**
+     * @brief Look up the item id and campaign of an airing
+     *
+     * A pub that a one-time rule fired is deleted right after, so the
+     * player resolves its airings while the row is still there.
+     * @return false on an SQL error; the campaign is the path if the item is not found
+     */
+    bool resolve(Airing& airing) const;
+
+    /**
+     * @brief Log airings and count them in the campaign summary
+     *
+     * Run inside the caller's transaction; airings not resolved yet are
+     * looked up in the pub or programs table.
+     * @param airings Airings with path, scheduledAt, startedAt and durationMs set
+     * @return true if every airing was logged
+     */
+    bool append(const QList<Airing>& airings);
+
+    /**
+     * @brief Airings that started from one time up to, but not including, another
+     * @param campaign Only the airings of this campaign, or all if empty
+     */
+    QList<Airing> airings(const QDateTime& from, const QDateTime& to,
+                          const QString& campaign = QString()) const;
+
+    /**
+     * @brief Airings of each item of each campaign in a month, by campaign
+     */
+    QList<CampaignEntry> campaignSummary(const QString& month) const;
+
+private:
+    bool prepareLookup(QSqlQuery& lookup, Kind kind) const;
+    static bool lookUp(QSqlQuery& lookup, Airing& airing);
+
+    QSqlDatabase m_database;
+    bool m_ready = false;
+};
+
+#endif // PROOFOFPLAY_H
@@ -0,0 +1,87 @@
+#ifndef SAVEPOINT_H
+#define SAVEPOINT_H
+
+#include <QDebug>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QString>
+
+/**
+ * @brief Scoped SQLite savepoint, rolled back unless released
+ *
+ * The repositories create their tables, triggers and backfills in steps
+ * that have to land together, often from code that does not know whether
+ * its caller already opened a transaction. A savepoint works either way:
+ * inside a transaction it nests, outside one it starts one, where BEGIN
+ * would fail in the first case.
+ *
+ * Leaving the scope without release() rolls back to the savepoint and
+ * releases it, so an early return cannot leave it open. Errors are logged
+ * with the savepoint's name.
+ *
+ * @example
+ * @code
+ * Savepoint savepoint(database, "musics_fts_setup");
+ * if (!savepoint.isOpen() || !query.exec(sql)) {
+ *     return false; // rolled back here
+ * }
+ * return savepoint.release();
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class Savepoint
+{
+public:
+    /**
+     * @param database Connection the steps run on
+     * @param name Savepoint name, an SQL identifier
+     */
+    Savepoint(const QSqlDatabase& database, const QString& name)
+        : m_query(database)
+        , m_name(name)
+    {
+        m_open = exec(QString("SAVEPOINT %1").arg(name));
+    }
+
+    ~Savepoint()
+    {
+        if (m_open) {
+            m_query.exec(QString("ROLLBACK TO %1").arg(m_name));
+            m_query.exec(QString("RELEASE %1").arg(m_name));
+        }
+    }
+
+    Savepoint(const Savepoint&) = delete;
+    Savepoint& operator=(const Savepoint&) = delete;
+
+    bool isOpen() const { return m_open; }
+
+    /**
+     * @brief Keep the steps run since the savepoint was opened
+     * @return true if released; false leaves it to be rolled back
+     */
+    bool release()
+    {
+        m_open = !exec(QString("RELEASE %1").arg(m_name));
+        return !m_open;
+    }
+
+private:
+    bool exec(const QString& sql)
+    {
+        if (m_query.exec(sql)) {
+            return true;
+        }
+        qWarning() << QString("Savepoint %1 - SQL Error: %2")
+                          .arg(m_name, m_query.lastError().text());
+        return false;
+    }
+
+    QSqlQuery m_query;
+    QString m_name;
+    bool m_open = false;
+};
+
+#endif // SAVEPOINT_H
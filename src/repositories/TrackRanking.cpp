@@ -0,0 +1,211 @@
+#include "TrackRanking.h"
+#include "Savepoint.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QHash>
+#include <QPair>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QStringList>
+#include <QVariant>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// The player writes "yyyy-MM-dd || hh:mm:ss", MusicRepository ISO 8601
+const QString PLAYER_FORMAT = "yyyy-MM-dd || hh:mm:ss";
+const QDate SCORE_EPOCH(2000, 1, 1);
+
+bool execLogged(QSqlQuery& query, const QString& operation, const QString& sql = QString())
+{
+    if (sql.isEmpty() ? query.exec() : query.exec(sql)) {
+        return true;
+    }
+    qWarning() << QString("TrackRanking::%1 - SQL Error: %2 (Query: %3)")
+                      .arg(operation, query.lastError().text(),
+                           sql.isEmpty() ? query.lastQuery() : sql);
+    return false;
+}
+
+QString placeholders(int count)
+{
+    QStringList marks;
+    marks.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        marks.append("?");
+    }
+    return marks.join(", ");
+}
+
+} // namespace
+
+TrackRanking::TrackRanking(const QSqlDatabase& database)
+    : m_database(database)
+{
+}
+
+QVariant TrackRanking::score(qint64 playedTimes, const QString& lastPlayed)
+{
+    if (playedTimes <= 0) {
+        return QVariant();
+    }
+    QDateTime played = QDateTime::fromString(lastPlayed, PLAYER_FORMAT);
+    if (!played.isValid()) {
+        played = QDateTime::fromString(lastPlayed, Qt::ISODate);
+    }
+    const double days = played.isValid() ? SCORE_EPOCH.daysTo(played.date()) : 0.0;
+    return std::log1p(double(playedTimes)) + days / RECENCY_DAYS;
+}
+
+bool TrackRanking::isReady()
+{
+    if (!m_checked) {
+        QSqlQuery query(m_database);
+        m_checked = execLogged(query, "isReady", "PRAGMA table_info(musics)");
+        while (query.next()) {
+            m_ready = m_ready || query.value(1).toString() == "rank_score";
+        }
+    }
+    return m_ready;
+}
+
+bool TrackRanking::ensure()
+{
+    QSqlQuery query(m_database);
+    m_checked = false;
+    m_ready = false;
+    if (!isReady()) {
+        if (!execLogged(query, "ensure", "ALTER TABLE musics ADD COLUMN rank_score REAL")) {
+            return false;
+        }
+        m_ready = true;
+    }
+    if (!execLogged(query, "ensure",
+                    "CREATE INDEX IF NOT EXISTS idx_musics_rank_score ON musics(rank_score)")) {
+        return false;
+    }
+
+    // Played tracks without a score: rows added with their counts, or scored before
+    QSqlQuery select(m_database);
+    select.setForwardOnly(true);
+    select.prepare("SELECT id, played_times, last_played FROM musics "
+                   "WHERE rank_score IS NULL AND played_times > 0 LIMIT ?");
+    int filled = 0;
+    while (true) {
+        select.addBindValue(BACKFILL_CHUNK);
+        int scored = 0;
+        // One savepoint per chunk, so readers get a turn between them
+        Savepoint savepoint(m_database, "track_ranking_backfill");
+        if (!savepoint.isOpen() || !scoreRows(select, &scored) || !savepoint.release()) {
+            return false;
+        }
+        filled += scored;
+        if (scored < BACKFILL_CHUNK) {
+            break;
+        }
+    }
+    if (filled > 0) {
+        qDebug() << "TrackRanking: scored" << filled << "tracks";
+    }
+    return true;
+}
+
+bool TrackRanking::refresh(const QList<int>& ids)
+{
+    if (ids.isEmpty() || !isReady()) {
+        return true;
+    }
+
+    QSqlQuery select(m_database);
+    select.setForwardOnly(true);
+    select.prepare(QString("SELECT id, played_times, last_played FROM musics WHERE id IN (%1)")
+                       .arg(placeholders(int(ids.size()))));
+    for (int id : ids) {
+        select.addBindValue(id);
+    }
+    int scored = 0;
+    return scoreRows(select, &scored);
+}
+
+bool TrackRanking::scoreRows(QSqlQuery& select, int* scored)
+{
+    if (!execLogged(select, "scoreRows")) {
+        return false;
+    }
+    QList<QPair<QVariant, QVariant>> scores;
+    while (select.next()) {
+        scores.append({select.value(0), score(select.value(1).toLongLong(),
+                                              select.value(2).toString())});
+    }
+    select.finish();
+
+    QSqlQuery update(m_database);
+    update.prepare("UPDATE musics SET rank_score = ? WHERE id = ?");
+    for (const auto& entry : std::as_const(scores)) {
+        update.addBindValue(entry.second);
+        update.addBindValue(entry.first);
+        if (!execLogged(update, "scoreRows")) {
+            return false;
+        }
+    }
+    *scored = int(scores.size());
+    return true;
+}
+
+QList<qint64> TrackRanking::top(const QString& condition, const QVariantList& bindValues,
+                                int limit, const QString& matchExpression)
+{
+    if (limit <= 0 || !isReady()) {
+        return QList<qint64>();
+    }
+
+    // Down idx_musics_rank_score, so SQLite stops at the last candidate
+    QSqlQuery query(m_database);
+    query.setForwardOnly(true);
+    QString sql = "SELECT rowid, rank_score FROM musics";
+    if (!condition.isEmpty()) {
+        sql += QString(" WHERE (%1)").arg(condition);
+    }
+    query.prepare(sql + " ORDER BY rank_score DESC LIMIT ?");
+    for (const QVariant& value : bindValues) {
+        query.addBindValue(value);
+    }
+    query.addBindValue(limit * CANDIDATE_FACTOR);
+    if (!execLogged(query, "top")) {
+        return QList<qint64>();
+    }
+    QList<qint64> keys;
+    QHash<qint64, double> scores;
+    while (query.next()) {
+        const qint64 key = query.value(0).toLongLong();
+        keys.append(key);
+        scores.insert(key, query.value(1).toDouble());
+    }
+    query.finish();
+    if (keys.isEmpty() || matchExpression.isEmpty()) {
+        return keys.mid(0, limit);
+    }
+
+    // bm25() is negative, the more so the better the match
+    const QString relevanceSql =
+        QString("SELECT rowid, bm25(musics_fts) FROM musics_fts WHERE musics_fts MATCH ? "
+                "AND rowid IN (%1)")
+            .arg(placeholders(int(keys.size())));
+    query.prepare(relevanceSql);
+    query.addBindValue(matchExpression);
+    for (qint64 key : std::as_const(keys)) {
+        query.addBindValue(key);
+    }
+    if (!execLogged(query, "top")) {
+        return keys.mid(0, limit);
+    }
+    while (query.next()) {
+        scores[query.value(0).toLongLong()] -= MATCH_WEIGHT * query.value(1).toDouble();
+    }
+
+    std::stable_sort(keys.begin(), keys.end(), [&scores](qint64 a, qint64 b) {
+        return scores.value(a) > scores.value(b);
+    });
+    return keys.mid(0, limit);
+}
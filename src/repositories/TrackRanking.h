@@ -0,0 +1,104 @@
+#ifndef TRACKRANKING_H
+#define TRACKRANKING_H
+
+#include <QList>
+#include <QSqlDatabase>
+#include <QString>
+#include <QVariantList>
+
+class QSqlQuery;
+
+/**
+ * @brief Popularity scores of the tracks, for searches that put the best match first
+ *
+ * Searches listed their matches in table order, so the version of a song
+ * that is played every day sat among the live takes and the remixes.
+ * TrackRanking stores a rank_score per track, indexed by
+ * idx_musics_rank_score, from its played_times and last_played:
+ *
+ *     ln(1 + played_times) + (days from 2000-01-01 to last_played) / RECENCY_DAYS
+ *
+ * A track's popularity fades with the time since its last play. Every
+ * score would have to be lowered by the same amount as days go by, which
+ * changes none of their order, so the score holds the fading part as the
+ * date of the last play instead and is only written again when the track
+ * is played. Tracks that were never played have no score and come last.
+ *
+ * top() reads the highest scoring matches of a search through the index,
+ * CANDIDATE_FACTOR times as many as asked for. With a full-text match the
+ * candidates' bm25() relevance for the match is added, MATCH_WEIGHT per
+ * unit, and the best of them are returned. Only the candidates are sorted.
+ *
+ * ensure() adds the column and the index to an existing library and
+ * scores the played tracks, BACKFILL_CHUNK rows at a time. After that
+ * PlayHistoryWriter calls refresh() for the tracks it counted a play for,
+ * in the same transaction.
+ *
+ * @example
+ * @code
+ * TrackRanking ranking(database);
+ * ranking.ensure();
+ * const QList<qint64> best = ranking.top(
+ *     "rowid IN (SELECT rowid FROM musics_fts WHERE musics_fts MATCH ?)", {match}, 10, match);
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class TrackRanking
+{
+public:
+    static constexpr double RECENCY_DAYS = 180.0;   ///< Days more recent worth e times the plays
+    static constexpr double MATCH_WEIGHT = 1.0;     ///< Score of one unit of bm25() relevance
+    static constexpr int CANDIDATE_FACTOR = 4;      ///< Candidates read per result of top()
+    static constexpr int BACKFILL_CHUNK = 500;      ///< Rows per backfill transaction
+
+    explicit TrackRanking(const QSqlDatabase& database);
+
+    /**
+     * @brief Score a track
+     * @param playedTimes Number of plays
+     * @param lastPlayed last_played as the player or MusicRepository writes it
+     * @return The score, or a null QVariant for a track never played
+     */
+    static QVariant score(qint64 playedTimes, const QString& lastPlayed);
+
+    /**
+     * @brief Add the score column and its index, and score the played tracks
+     * @return true if the tracks can be ranked
+     */
+    bool ensure();
+
+    /**
+     * @brief Whether the musics table has the score column
+     *
+     * Looked up once, so a library that ensure() never ran on is left alone.
+     */
+    bool isReady();
+
+    /**
+     * @brief Score tracks again from their play counts
+     * @param ids musics.id of the tracks
+     * @return true on success, or if the library has no score column
+     */
+    bool refresh(const QList<int>& ids);
+
+    /**
+     * @brief Get the best matches of a search
+     * @param condition Condition on musics, without the WHERE keyword
+     * @param bindValues Values for the placeholders of condition
+     * @param limit Number of matches wanted
+     * @param matchExpression musics_fts expression to weigh the matches by, or empty
+     * @return rowid of the best matches, best first; empty on failure
+     */
+    QList<qint64> top(const QString& condition, const QVariantList& bindValues, int limit,
+                      const QString& matchExpression = QString());
+
+private:
+    bool scoreRows(QSqlQuery& select, int* scored);
+
+    QSqlDatabase m_database;
+    bool m_checked = false;
+    bool m_ready = false;
+};
+
+#endif // TRACKRANKING_H
@@ -0,0 +1,70 @@
+#include "ATSPIBusWatcher.h"
+#include <QDebug>
+
+#ifdef XFB_HAVE_DBUS
+#include <QDBusConnection>
+#include <QDBusConnectionInterface>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+#include <QDBusServiceWatcher>
+#endif
+
+ATSPIBusWatcher::ATSPIBusWatcher(QObject* parent)
+    : QObject(parent)
+{
+}
+
+void ATSPIBusWatcher::start()
+{
+#ifdef XFB_HAVE_DBUS
+    if (m_watcher) {
+        return;
+    }
+
+    QDBusConnection bus = QDBusConnection::sessionBus();
+    if (!bus.isConnected() || !bus.interface()) {
+        qDebug() << "ATSPIBusWatcher: No session bus";
+        setPresent(false);
+        return;
+    }
+
+    m_watcher = new QDBusServiceWatcher(QString::fromLatin1(SERVICE_NAME), bus,
+                                        QDBusServiceWatcher::WatchForOwnerChange, this);
+    connect(m_watcher, &QDBusServiceWatcher::serviceOwnerChanged, this,
+            [this](const QString&, const QString&, const QString& newOwner) {
+                setPresent(!newOwner.isEmpty());
+            });
+
+    // Watch first, then ask, so a change between the two is not missed
+    QDBusPendingCall call = bus.interface()->asyncCall(QStringLiteral("NameHasOwner"),
+                                                       QString::fromLatin1(SERVICE_NAME));
+    auto* pending = new QDBusPendingCallWatcher(call, this);
+    connect(pending, &QDBusPendingCallWatcher::finished, this,
+            [this](QDBusPendingCallWatcher* finished) {
+                QDBusPendingReply<bool> reply = *finished;
+                finished->deleteLater();
+                // An owner change heard meanwhile is newer than this answer
+                if (m_known) {
+                    return;
+                }
+                if (reply.isError()) {
+                    qDebug() << "ATSPIBusWatcher: NameHasOwner failed:" << reply.error().message();
+                    setPresent(false);
+                    return;
+                }
+                setPresent(reply.value());
+            });
+#else
+    setPresent(false);
+#endif
+}
+
+void ATSPIBusWatcher::setPresent(bool present)
+{
+    const bool changed = !m_known || m_present != present;
+    m_known = true;
+    m_present = present;
+    if (changed) {
+        emit presenceChanged(present);
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef ATSPIBUSWATCHER_H
+#define ATSPIBUSWATCHER_H
+
+#include <QObject>
+
+class QDBusServiceWatcher;
+
+/**
+ * @brief Tells whether the AT-SPI accessibility bus is up, without asking twice
+ *
+ * The accessibility stack is present when org.a11y.Bus has an owner on the
+ * session bus. start() asks once, asynchronously, and then watches the name,
+ * so the answer follows at-spi-bus-launcher coming and going without any
+ * process being spawned or any call blocking the GUI thread.
+ *
+ * Built without Qt D-Bus (XFB_HAVE_DBUS unset, as on macOS and Windows) the
+ * bus is reported absent as soon as start() is called.
+ *
+ * @example
+ * @code
+ * auto* watcher = new ATSPIBusWatcher(this);
+ * connect(watcher, &ATSPIBusWatcher::presenceChanged, this, [](bool present) {
+ *     qDebug() << "AT-SPI" << (present ? "up" : "down");
+ * });
+ * watcher->start();
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class ATSPIBusWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr const char* SERVICE_NAME = "org.a11y.Bus";
+
+    explicit ATSPIBusWatcher(QObject* parent = nullptr);
+
+    /**
+     * @brief Start watching; the first answer arrives through presenceChanged()
+     */
+    void start();
+
+    /**
+     * @brief Whether the bus has an owner, as last heard; false until known
+     */
+    bool isPresent() const { return m_present; }
+
+    /**
+     * @brief Whether an answer has arrived since start()
+     */
+    bool isKnown() const { return m_known; }
+
+signals:
+    /**
+     * @brief Emitted when the first answer arrives and whenever it changes
+     * @param present Whether the AT-SPI bus has an owner
+     */
+    void presenceChanged(bool present);
+
+private:
+    void setPresent(bool present);
+
+    QDBusServiceWatcher* m_watcher = nullptr;
+    bool m_present = false;
+    bool m_known = false;
+};
+
+#endif // ATSPIBUSWATCHER_H
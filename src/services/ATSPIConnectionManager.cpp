@@ -1,4 +1,5 @@
 #include "ATSPIConnectionManager.h"
+#include "ATSPIBusWatcher.h"
 #include <QAccessible>
 #include <QApplication>
 #include <QDebug>
@@ -15,8 +16,10 @@ ATSPIConnectionManager::ATSPIConnectionManager(QObject *parent)
     , m_healthCheckTimer(new QTimer(this))
     , m_recoveryTimer(new QTimer(this))
     , m_bridgeProcess(nullptr)
+    , m_busWatcher(new ATSPIBusWatcher(this))
     , m_autoRecoveryEnabled(true)
     , m_atSpiAvailable(false)
+    , m_awaitingBus(false)
     , m_recoveryAttempts(0)
 {
     // Set up timers
@@ -28,6 +31,8 @@ ATSPIConnectionManager::ATSPIConnectionManager(QObject *parent)
     
     connect(m_healthCheckTimer, &QTimer::timeout, this, &ATSPIConnectionManager::checkConnectionStatus);
     connect(m_recoveryTimer, &QTimer::timeout, this, &ATSPIConnectionManager::attemptRecovery);
+    connect(m_busWatcher, &ATSPIBusWatcher::presenceChanged,
+            this, &ATSPIConnectionManager::onBusPresenceChanged);
 }
 
 ATSPIConnectionManager::~ATSPIConnectionManager()
@@ -56,8 +61,9 @@ void ATSPIConnectionManager::initialize()
     // Start health check timer
     m_healthCheckTimer->start();
     
-    // Attempt initial connection
-    connectToATSPI();
+    // Attempt initial connection once the session bus says whether AT-SPI is up
+    m_awaitingBus = true;
+    m_busWatcher->start();
     
     qDebug() << "AT-SPI Connection Manager initialized";
 }
@@ -282,6 +288,19 @@ void ATSPIConnectionManager::checkConnectionStatus()
     }
 }
 
+void ATSPIConnectionManager::onBusPresenceChanged(bool present)
+{
+    qDebug() << "AT-SPI bus" << (present ? "is up" : "is down");
+    
+    if (m_awaitingBus) {
+        m_awaitingBus = false;
+        connectToATSPI();
+        return;
+    }
+    
+    checkConnectionStatus();
+}
+
 void ATSPIConnectionManager::onBridgeProcessFinished(int exitCode, QProcess::ExitStatus exitStatus)
 {
     qWarning() << "AT-SPI bridge process finished with exit code" << exitCode 
@@ -408,18 +427,14 @@ bool ATSPIConnectionManager::isATSPIBridgeRunning() const
         return true;
     }
     
-    // Check if any AT-SPI bridge is running system-wide
-    QProcess process;
-    process.start("pgrep", QStringList() << "-f" << "at-spi-bus-launcher");
-    process.waitForFinished(3000);
-    
-    return process.exitCode() == 0;
+    // Check if any AT-SPI bus is up system-wide, as last heard from the session bus
+    return m_busWatcher->isPresent();
 }
 
 bool ATSPIConnectionManager::testATSPIConnection() const
 {
     // Test if QAccessible is active and working
-    if (!QAccessible::isActive()) {
+    if (!QAccessible::isActive() || !isATSPIBridgeRunning()) {
         return false;
     }
     
@@ -471,18 +486,7 @@ QString ATSPIConnectionManager::getATSPIBridgePath() const
     }
     
     // Try to find it in PATH
-    QProcess process;
-    process.start("which", QStringList() << "at-spi-bus-launcher");
-    process.waitForFinished(3000);
-    
-    if (process.exitCode() == 0) {
-        QString path = process.readAllStandardOutput().trimmed();
-        if (!path.isEmpty()) {
-            return path;
-        }
-    }
-    
-    return QString();
+    return QStandardPaths::findExecutable("at-spi-bus-launcher");
 }
 
 QStringList ATSPIConnectionManager::getATSPIBridgeArguments() const
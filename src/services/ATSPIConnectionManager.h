@@ -8,6 +8,8 @@
 #include <QDateTime>
 #include <QWidget>
 
+class ATSPIBusWatcher;
+
 /**
  * @brief Manages AT-SPI connection and recovery
  * 
@@ -127,6 +129,7 @@ signals:
 
 private slots:
     void checkConnectionStatus();
+    void onBusPresenceChanged(bool present);
     void onBridgeProcessFinished(int exitCode, QProcess::ExitStatus exitStatus);
     void onBridgeProcessError(QProcess::ProcessError error);
 
@@ -146,10 +149,12 @@ private:
     QTimer* m_healthCheckTimer;
     QTimer* m_recoveryTimer;
     QProcess* m_bridgeProcess;
+    ATSPIBusWatcher* m_busWatcher;
     mutable QMutex m_stateMutex;
     
     bool m_autoRecoveryEnabled;
     bool m_atSpiAvailable;
+    bool m_awaitingBus;
     int m_recoveryAttempts;
     QDateTime m_lastRecoveryAttempt;
     
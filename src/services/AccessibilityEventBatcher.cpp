@@ -0,0 +1,205 @@
+#include "AccessibilityEventBatcher.h"
+#include <QAbstractItemModel>
+#include <QAbstractItemView>
+#include <QCoreApplication>
+#include <QLocale>
+#include <QStringList>
+#include <algorithm>
+
+namespace {
+// The batcher whose handler QAccessible calls; the handler is a plain function
+AccessibilityEventBatcher* handlerOwner = nullptr;
+}
+
+AccessibilityEventBatcher* AccessibilityEventBatcher::instance()
+{
+    static QPointer<AccessibilityEventBatcher> batcher;
+    if (!batcher) {
+        batcher = new AccessibilityEventBatcher(QCoreApplication::instance());
+    }
+    return batcher;
+}
+
+AccessibilityEventBatcher::AccessibilityEventBatcher(QObject* parent)
+    : QObject(parent)
+{
+}
+
+AccessibilityEventBatcher::~AccessibilityEventBatcher()
+{
+    removeHandler();
+}
+
+void AccessibilityEventBatcher::beginBatch(const QAbstractItemModel* model)
+{
+    if (!model) {
+        return;
+    }
+    ++m_batches[model].depth;
+    installHandler();
+}
+
+void AccessibilityEventBatcher::endBatch(const QAbstractItemModel* model, const QString& summary)
+{
+    auto it = m_batches.find(model);
+    if (it == m_batches.end() || --it->depth > 0) {
+        return;
+    }
+
+    const Batch batch = std::move(*it);
+    m_batches.erase(it);
+    if (m_batches.isEmpty()) {
+        removeHandler();
+    }
+
+    for (const ViewChanges& changes : batch.views) {
+        if (changes.view) {
+            send(changes, summary);
+        }
+    }
+}
+
+bool AccessibilityEventBatcher::isBatching(const QAbstractItemModel* model) const
+{
+    return model && m_batches.contains(model);
+}
+
+bool AccessibilityEventBatcher::isBatchingView(const QObject* view) const
+{
+    const auto* itemView = qobject_cast<const QAbstractItemView*>(view);
+    return itemView && isBatching(itemView->model());
+}
+
+QString AccessibilityEventBatcher::summary(const QObject* view) const
+{
+    return view && view == m_summaryView ? m_summary : QString();
+}
+
+QString AccessibilityEventBatcher::summarize(int inserted, int removed, int updated,
+                                             const QString& singular, const QString& plural)
+{
+    const QLocale locale;
+    QStringList parts;
+    const auto add = [&](int count, const QString& what) {
+        if (count <= 0) {
+            return;
+        }
+        // The first part names the rows, the others go by it
+        if (parts.isEmpty()) {
+            parts << QString("%1 %2 %3")
+                         .arg(locale.toString(count), count == 1 ? singular : plural, what);
+        } else {
+            parts << QString("%1 %2").arg(locale.toString(count), what);
+        }
+    };
+    add(inserted, "added");
+    add(removed, "removed");
+    add(updated, "updated");
+    return parts.join(", ");
+}
+
+void AccessibilityEventBatcher::handleUpdate(QAccessibleEvent* event)
+{
+    AccessibilityEventBatcher* batcher = handlerOwner;
+    if (!batcher) {
+        return;
+    }
+    if (event->type() == QAccessible::TableModelChanged
+        && batcher->hold(static_cast<QAccessibleTableModelChangeEvent*>(event))) {
+        return;
+    }
+    batcher->forward(event);
+}
+
+bool AccessibilityEventBatcher::hold(QAccessibleTableModelChangeEvent* event)
+{
+    const auto* itemView = qobject_cast<const QAbstractItemView*>(event->object());
+    if (!itemView) {
+        return false;
+    }
+    auto batch = m_batches.find(itemView->model());
+    if (batch == m_batches.end()) {
+        return false;
+    }
+
+    auto changes = std::find_if(batch->views.begin(), batch->views.end(),
+                                [&](const ViewChanges& held) { return held.view == itemView; });
+    if (changes == batch->views.end()) {
+        ViewChanges first;
+        first.view = event->object();
+        first.type = event->modelChangeType();
+        first.firstRow = event->firstRow();
+        first.lastRow = event->lastRow();
+        first.firstColumn = event->firstColumn();
+        first.lastColumn = event->lastColumn();
+        first.rows = event->lastRow() - event->firstRow() + 1;
+        batch->views.push_back(first);
+    } else {
+        changes->mixed = changes->mixed || changes->type != event->modelChangeType();
+        changes->firstRow = std::min(changes->firstRow, event->firstRow());
+        changes->lastRow = std::max(changes->lastRow, event->lastRow());
+        changes->firstColumn = std::min(changes->firstColumn, event->firstColumn());
+        changes->lastColumn = std::max(changes->lastColumn, event->lastColumn());
+        changes->rows += event->lastRow() - event->firstRow() + 1;
+    }
+    ++m_heldBack;
+    return true;
+}
+
+void AccessibilityEventBatcher::forward(QAccessibleEvent* event)
+{
+    if (m_previousHandler) {
+        m_previousHandler(event);
+        return;
+    }
+    // Without a handler Qt gives the event to the platform bridge. Going round
+    // once more tells a table interface about its own change twice, which only
+    // clears its cell cache again.
+    QAccessible::installUpdateHandler(nullptr);
+    QAccessible::updateAccessibility(event);
+    QAccessible::installUpdateHandler(&AccessibilityEventBatcher::handleUpdate);
+}
+
+void AccessibilityEventBatcher::send(const ViewChanges& changes, const QString& summary)
+{
+    // Rows inserted or removed in separate blocks have no one range to report
+    const bool oneRange = !changes.mixed
+                          && (changes.type == QAccessibleTableModelChangeEvent::DataChanged
+                              || changes.rows == changes.lastRow - changes.firstRow + 1);
+    const auto type = oneRange ? changes.type : QAccessibleTableModelChangeEvent::ModelReset;
+
+    QAccessibleTableModelChangeEvent event(changes.view, type);
+    if (type != QAccessibleTableModelChangeEvent::ModelReset) {
+        event.setFirstRow(changes.firstRow);
+        event.setLastRow(changes.lastRow);
+        event.setFirstColumn(changes.firstColumn);
+        event.setLastColumn(changes.lastColumn);
+    }
+
+    m_summaryView = changes.view;
+    m_summary = summary;
+    QAccessible::updateAccessibility(&event);
+    m_summaryView = nullptr;
+    m_summary.clear();
+}
+
+void AccessibilityEventBatcher::installHandler()
+{
+    if (m_handlerInstalled || handlerOwner) {
+        return;
+    }
+    handlerOwner = this;
+    m_previousHandler = QAccessible::installUpdateHandler(&AccessibilityEventBatcher::handleUpdate);
+    m_handlerInstalled = true;
+}
+
+void AccessibilityEventBatcher::removeHandler()
+{
+    if (!m_handlerInstalled) {
+        return;
+    }
+    QAccessible::installUpdateHandler(m_previousHandler);
+    m_previousHandler = nullptr;
+    m_handlerInstalled = false;
+    handlerOwner = nullptr;
+}
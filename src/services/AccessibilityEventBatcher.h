@@ -0,0 +1,133 @@
+#ifndef ACCESSIBILITYEVENTBATCHER_H
+#define ACCESSIBILITYEVENTBATCHER_H
+
+#include <QAccessible>
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <vector>
+
+class QAbstractItemModel;
+
+/**
+ * @brief Folds the table change events of a bulk model update into one
+ *
+ * A refresh after an import can insert and remove rows in hundreds of
+ * separate blocks. Each block made the views of the model send a
+ * QAccessibleTableModelChangeEvent, and AccessibleTableInterface spoke a
+ * line for each of them, so a screen reader was busy for minutes.
+ *
+ * Between beginBatch() and endBatch() on a model, the table change events
+ * of its views are held back. When the batch ends each view sends one
+ * event instead: the row range of the change when all of it was of one
+ * kind over one contiguous range, or a model reset otherwise. The summary
+ * passed to endBatch() is what AccessibleTableInterface says for it, in
+ * place of its own line per block.
+ *
+ * Events are held back through QAccessible's update handler, which is
+ * installed only while a batch is open and hands every other event on
+ * unchanged. Batches nest; only the outermost endBatch() sends.
+ *
+ * @example
+ * @code
+ * AccessibilityEventBatcher* batcher = AccessibilityEventBatcher::instance();
+ * batcher->beginBatch(model);
+ * model->refresh();
+ * batcher->endBatch(model, AccessibilityEventBatcher::summarize(1250, 0, 0, "track", "tracks"));
+ * // "1,250 tracks added"
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class AccessibilityEventBatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief The batcher of the application, made on first use; GUI thread only
+     */
+    static AccessibilityEventBatcher* instance();
+
+    explicit AccessibilityEventBatcher(QObject* parent = nullptr);
+    ~AccessibilityEventBatcher() override;
+
+    /**
+     * @brief Hold back the table change events of the views of a model
+     */
+    void beginBatch(const QAbstractItemModel* model);
+
+    /**
+     * @brief End a batch and send one event per view that changed
+     * @param model Model given to beginBatch()
+     * @param summary What to say for the change; empty to say what the event says
+     */
+    void endBatch(const QAbstractItemModel* model, const QString& summary = QString());
+
+    /**
+     * @brief Whether a batch is open on a model
+     */
+    bool isBatching(const QAbstractItemModel* model) const;
+
+    /**
+     * @brief Whether a batch is open on the model of an item view
+     */
+    bool isBatchingView(const QObject* view) const;
+
+    /**
+     * @brief The summary to say for a view while its batched event is sent, else empty
+     */
+    QString summary(const QObject* view) const;
+
+    /**
+     * @brief Table change events held back since the batcher was made
+     */
+    qint64 heldBackCount() const { return m_heldBack; }
+
+    /**
+     * @brief Describe a bulk change, e.g. "1,250 tracks added, 3 removed"
+     * @param inserted Rows inserted
+     * @param removed Rows removed
+     * @param updated Rows changed
+     * @param singular Name of one row, e.g. "track"
+     * @param plural Name of several rows, e.g. "tracks"
+     * @return The description, empty when nothing changed
+     */
+    static QString summarize(int inserted, int removed, int updated, const QString& singular,
+                             const QString& plural);
+
+private:
+    struct ViewChanges {
+        QPointer<QObject> view;
+        QAccessibleTableModelChangeEvent::ModelChangeType type =
+            QAccessibleTableModelChangeEvent::ModelReset;
+        bool mixed = false;
+        int firstRow = -1;
+        int lastRow = -1;
+        int firstColumn = -1;
+        int lastColumn = -1;
+        int rows = 0;   ///< Rows of all events together, to tell a contiguous range
+    };
+
+    struct Batch {
+        int depth = 0;
+        std::vector<ViewChanges> views;
+    };
+
+    static void handleUpdate(QAccessibleEvent* event);
+    bool hold(QAccessibleTableModelChangeEvent* event);
+    void forward(QAccessibleEvent* event);
+    void send(const ViewChanges& changes, const QString& summary);
+    void installHandler();
+    void removeHandler();
+
+    QHash<const QAbstractItemModel*, Batch> m_batches;
+    QAccessible::UpdateHandler m_previousHandler = nullptr;
+    bool m_handlerInstalled = false;
+    QPointer<QObject> m_summaryView;
+    QString m_summary;
+    qint64 m_heldBack = 0;
+};
+
+#endif // ACCESSIBILITYEVENTBATCHER_H
@@ -10,6 +10,8 @@
 #include "LiveRegionManager.h"
 #include "PlaybackStatusAnnouncer.h"
 #include "SystemStatusAnnouncer.h"
+#include "AnnouncementBus.h"
+#include "ATSPIBusWatcher.h"
 // Temporarily disabled for beta build:
 // #include "AccessibleHelpSystem.h"
 // #include "ContextSensitiveHelpService.h"
@@ -20,7 +22,6 @@
 #include <QDebug>
 #include <QStandardPaths>
 #include <QDir>
-#include <QProcess>
 
 AccessibilityManager::AccessibilityManager(QObject* parent)
     : BaseService(parent)
@@ -40,8 +41,10 @@ AccessibilityManager::AccessibilityManager(QObject* parent)
     , m_accessibleHelpSystem(nullptr)
     , m_contextSensitiveHelpService(nullptr)
     , m_settings(nullptr)
-    , m_announcementTimer(new QTimer(this))
-    , m_processingAnnouncements(false)
+    , m_atspiWatcher(nullptr)
+    , m_active(false)
+    , m_observingActivation(false)
+    , m_pendingPlayer(nullptr)
 {
     // Initialize settings
     QString configPath = QStandardPaths::writableLocation(QStandardPaths::ConfigLocation);
@@ -53,25 +56,16 @@ AccessibilityManager::AccessibilityManager(QObject* parent)
     m_settings = new QSettings(configDir.absoluteFilePath("xfb_accessibility.ini"), 
                               QSettings::IniFormat, this);
     
-    // Setup announcement timer
-    m_announcementTimer->setSingleShot(false);
-    m_announcementTimer->setInterval(ANNOUNCEMENT_PROCESSING_INTERVAL_MS);
-    connect(m_announcementTimer, &QTimer::timeout,
-            this, &AccessibilityManager::processAnnouncementQueue);
-    
-    // Connect to application focus changes
-    if (QApplication* app = qobject_cast<QApplication*>(QApplication::instance())) {
-        connect(app, &QApplication::focusChanged,
-                this, &AccessibilityManager::onFocusChanged);
-        connect(app, &QApplication::applicationStateChanged,
-                this, &AccessibilityManager::onApplicationStateChanged);
-    }
+    // Focus and application state are followed from activate() on
     
     logDebug("AccessibilityManager created");
 }
 
 AccessibilityManager::~AccessibilityManager()
 {
+    if (m_observingActivation) {
+        QAccessible::removeActivationObserver(this);
+    }
     cleanupAccessibility();
     logDebug("AccessibilityManager destroyed");
 }
@@ -83,23 +77,66 @@ bool AccessibilityManager::doInitialize()
     // Load settings first
     loadSettings();
     
+    // Initialize AT-SPI bridge; whether the bus is up is learned asynchronously
+    if (!initializeATSPIBridge()) {
+        logWarning("AT-SPI bridge initialization failed - accessibility may be limited");
+        // Don't fail initialization as basic Qt accessibility might still work
+    }
+    
+    // Setup application-level accessibility
+    setupApplicationAccessibility();
+    
+    // Everything else waits for an assistive technology, or for the user to ask
+    if (!m_observingActivation) {
+        QAccessible::installActivationObserver(this);
+        m_observingActivation = true;
+    }
+    if (m_accessibilityEnabled || QAccessible::isActive()) {
+        activate();
+    } else {
+        logDebug("No assistive technology connected - accessibility services deferred");
+    }
+    
+    logDebug("AccessibilityManager initialized successfully");
+    return true;
+}
+
+void AccessibilityManager::accessibilityActiveChanged(bool active)
+{
+    if (active && state() == ServiceState::Running) {
+        logDebug("Assistive technology connected");
+        // Qt reports this from inside its own bookkeeping; build the services just after
+        QMetaObject::invokeMethod(this, &AccessibilityManager::activate, Qt::QueuedConnection);
+    }
+}
+
+void AccessibilityManager::activate()
+{
+    if (m_active) {
+        return;
+    }
+    m_active = true;
+    logDebug("Activating accessibility services");
+    
     // Initialize Qt accessibility framework
     if (!initializeQtAccessibility()) {
-        setError("Failed to initialize Qt accessibility framework");
-        return false;
+        logWarning("Failed to initialize Qt accessibility framework");
     }
     
-    // Initialize AT-SPI bridge if available
-    if (!initializeATSPIBridge()) {
-        logWarning("AT-SPI bridge initialization failed - accessibility may be limited");
-        // Don't fail initialization as basic Qt accessibility might still work
+    // Connect to application focus changes
+    if (QApplication* app = qobject_cast<QApplication*>(QApplication::instance())) {
+        connect(app, &QApplication::focusChanged,
+                this, &AccessibilityManager::onFocusChanged, Qt::UniqueConnection);
+        connect(app, &QApplication::applicationStateChanged,
+                this, &AccessibilityManager::onApplicationStateChanged, Qt::UniqueConnection);
     }
     
     // Initialize widget enhancer
     m_widgetEnhancer = new WidgetAccessibilityEnhancer(this, this);
     if (!m_widgetEnhancer->initialize()) {
-        setError("Failed to initialize WidgetAccessibilityEnhancer");
-        return false;
+        logWarning("Failed to initialize WidgetAccessibilityEnhancer");
+        delete m_widgetEnhancer;
+        m_widgetEnhancer = nullptr;
     }
     
     // Keyboard navigation controller temporarily disabled for beta build
@@ -109,8 +146,16 @@ bool AccessibilityManager::doInitialize()
     //     return false;
     // }
     
+    // The announcers are registered in the container but only made here
+    auto startService = [](BaseService* service) {
+        if (service && service->state() == ServiceState::Uninitialized) {
+            service->initialize();
+        }
+    };
+    
     // Initialize audio feedback service
     m_audioFeedbackService = ServiceContainer::instance()->resolve<AudioFeedbackService>();
+    startService(m_audioFeedbackService);
     if (!m_audioFeedbackService) {
         logWarning("AudioFeedbackService not available - audio feedback will be limited");
     }
@@ -125,18 +170,21 @@ bool AccessibilityManager::doInitialize()
     
     // Initialize live region manager
     m_liveRegionManager = ServiceContainer::instance()->resolve<LiveRegionManager>();
+    startService(m_liveRegionManager);
     if (!m_liveRegionManager) {
         logWarning("LiveRegionManager not available - live region announcements will be limited");
     }
     
     // Initialize playback status announcer
     m_playbackStatusAnnouncer = ServiceContainer::instance()->resolve<PlaybackStatusAnnouncer>();
+    startService(m_playbackStatusAnnouncer);
     if (!m_playbackStatusAnnouncer) {
         logWarning("PlaybackStatusAnnouncer not available - playback status announcements will be limited");
     }
     
     // Initialize system status announcer
     m_systemStatusAnnouncer = ServiceContainer::instance()->resolve<SystemStatusAnnouncer>();
+    startService(m_systemStatusAnnouncer);
     if (!m_systemStatusAnnouncer) {
         logWarning("SystemStatusAnnouncer not available - system status announcements will be limited");
     }
@@ -163,16 +211,13 @@ bool AccessibilityManager::doInitialize()
     //     m_contextSensitiveHelpService = nullptr;
     // }
     
-    // Setup application-level accessibility
-    setupApplicationAccessibility();
-    
-    // Start announcement processing if accessibility is enabled
-    if (m_accessibilityEnabled) {
-        m_announcementTimer->start();
+    // The player asked before there was anything to set up
+    if (m_pendingPlayer) {
+        initializePlayerAccessibility(m_pendingPlayer);
+        m_pendingPlayer = nullptr;
     }
     
-    logDebug("AccessibilityManager initialized successfully");
-    return true;
+    emit activated();
 }
 
 void AccessibilityManager::doShutdown()
@@ -182,8 +227,13 @@ void AccessibilityManager::doShutdown()
     // Save settings before shutdown
     saveSettings();
     
-    // Stop announcement processing
-    m_announcementTimer->stop();
+    // Drop what is still waiting to be said
+    AnnouncementBus::instance()->clear(this);
+    
+    if (m_observingActivation) {
+        QAccessible::removeActivationObserver(this);
+        m_observingActivation = false;
+    }
     
     // Cleanup accessibility resources
     cleanupAccessibility();
@@ -196,6 +246,15 @@ QString AccessibilityManager::getServiceName() const
     return "AccessibilityManager";
 }
 
+bool AccessibilityManager::healthCheck()
+{
+    // Screen readers cannot reach the application once the AT-SPI bus is gone
+    if (!m_accessibilityEnabled || !m_atspiWatcher || !m_atspiWatcher->isKnown()) {
+        return true;
+    }
+    return m_atspiWatcher->isPresent();
+}
+
 void AccessibilityManager::enableAccessibility(bool enabled)
 {
     if (m_accessibilityEnabled == enabled) {
@@ -207,10 +266,8 @@ void AccessibilityManager::enableAccessibility(bool enabled)
     if (enabled) {
         logDebug("Enabling accessibility features");
         
-        // Start announcement processing
-        if (!m_announcementTimer->isActive()) {
-            m_announcementTimer->start();
-        }
+        // Build the services if no assistive technology has done so yet
+        activate();
         
         // Enable Qt accessibility
         QAccessible::setActive(true);
@@ -220,11 +277,8 @@ void AccessibilityManager::enableAccessibility(bool enabled)
     } else {
         logDebug("Disabling accessibility features");
         
-        // Stop announcement processing
-        m_announcementTimer->stop();
-        
         // Clear announcement queue
-        m_announcementQueue.clear();
+        AnnouncementBus::instance()->clear(this);
         
         // Announce accessibility deactivation
         announceMessage("Accessibility features disabled", Priority::High);
@@ -397,26 +451,6 @@ void AccessibilityManager::onApplicationStateChanged(Qt::ApplicationState state)
     }
 }
 
-void AccessibilityManager::processAnnouncementQueue()
-{
-    if (m_processingAnnouncements || m_announcementQueue.isEmpty()) {
-        return;
-    }
-    
-    m_processingAnnouncements = true;
-    
-    // Process one announcement per timer tick to avoid overwhelming the screen reader
-    AnnouncementItem item = m_announcementQueue.dequeue();
-    processAnnouncement(item.message, item.priority);
-    
-    m_processingAnnouncements = false;
-    
-    // Stop timer if queue is empty
-    if (m_announcementQueue.isEmpty()) {
-        m_announcementTimer->stop();
-    }
-}
-
 void AccessibilityManager::onWidgetDestroyed(QObject* obj)
 {
     // Remove metadata for destroyed widget
@@ -444,10 +478,18 @@ bool AccessibilityManager::initializeQtAccessibility()
 
 bool AccessibilityManager::initializeATSPIBridge()
 {
-    // Check if AT-SPI is available on the system
-    if (!isATSPIAvailable()) {
-        logWarning("AT-SPI is not available on this system");
-        return false;
+    // Watch org.a11y.Bus rather than looking for the daemons; the answer comes later
+    if (!m_atspiWatcher) {
+        m_atspiWatcher = new ATSPIBusWatcher(this);
+        connect(m_atspiWatcher, &ATSPIBusWatcher::presenceChanged, this, [this](bool present) {
+            if (present) {
+                logDebug("AT-SPI bus is available");
+            } else {
+                logWarning("AT-SPI is not available on this system");
+            }
+            emit atspiAvailabilityChanged(present);
+        });
+        m_atspiWatcher->start();
     }
     
     // Qt6 automatically handles AT-SPI bridge initialization when QAccessible is active
@@ -482,6 +524,13 @@ bool AccessibilityManager::initializePlayerAccessibility(player* playerWindow)
         return false;
     }
     
+    if (!m_active) {
+        // Set up by activate(), if an assistive technology ever connects
+        m_pendingPlayer = playerWindow;
+        logDebug("Player accessibility deferred until activation");
+        return true;
+    }
+    
     // Player keyboard navigation enhancers temporarily disabled for beta build
     // if (!m_keyboardNavigationController) {
     //     logError("KeyboardNavigationController must be initialized before player accessibility");
@@ -588,53 +637,37 @@ void AccessibilityManager::cleanupAccessibility()
     // Clear widget metadata
     m_widgetMetadata.clear();
     
-    // Clear announcement queue
-    m_announcementQueue.clear();
+    if (QApplication* app = qobject_cast<QApplication*>(QApplication::instance())) {
+        disconnect(app, nullptr, this, nullptr);
+    }
+    m_pendingPlayer = nullptr;
+    m_active = false;
     
     logDebug("Accessibility resources cleaned up");
 }
 
 void AccessibilityManager::queueAnnouncement(const QString& message, Priority priority)
 {
-    // Handle critical priority announcements immediately
-    if (priority == Priority::Critical) {
-        // Clear queue for critical announcements
-        m_announcementQueue.clear();
-        processAnnouncement(message, priority);
+    // Paced and deduplicated with the other accessibility services; Critical
+    // messages are said at once. The priorities are in the same order.
+    AnnouncementBus::Announcement announcement;
+    announcement.message = message;
+    announcement.priority = static_cast<AnnouncementBus::Priority>(priority);
+    announcement.context = this;
+    announcement.deliver = [this](const AnnouncementBus::Announcement& item) {
+        processAnnouncement(item.message, static_cast<Priority>(item.priority));
+    };
+    AnnouncementBus::instance()->post(announcement);
+}
+
+void AccessibilityManager::deliverAnnouncement(const QString& message, Priority priority)
+{
+    if (!m_accessibilityEnabled || message.isEmpty()) {
         return;
     }
     
-    // Check queue size limit
-    if (m_announcementQueue.size() >= MAX_ANNOUNCEMENT_QUEUE_SIZE) {
-        // Remove oldest low priority items to make room
-        while (m_announcementQueue.size() >= MAX_ANNOUNCEMENT_QUEUE_SIZE && 
-               !m_announcementQueue.isEmpty()) {
-            AnnouncementItem oldest = m_announcementQueue.head();
-            if (oldest.priority == Priority::Low) {
-                m_announcementQueue.dequeue();
-            } else {
-                break;
-            }
-        }
-        
-        // If still full, remove oldest item regardless of priority
-        if (m_announcementQueue.size() >= MAX_ANNOUNCEMENT_QUEUE_SIZE) {
-            m_announcementQueue.dequeue();
-        }
-    }
-    
-    // Add to queue
-    AnnouncementItem item;
-    item.message = message;
-    item.priority = priority;
-    item.timestamp = QDateTime::currentMSecsSinceEpoch();
-    
-    m_announcementQueue.enqueue(item);
-    
-    // Start timer if not already running
-    if (!m_announcementTimer->isActive()) {
-        m_announcementTimer->start();
-    }
+    processAnnouncement(message, priority);
+    emit announcementRequested(message, priority);
 }
 
 void AccessibilityManager::processAnnouncement(const QString& message, Priority priority)
@@ -661,25 +694,5 @@ void AccessibilityManager::processAnnouncement(const QString& message, Priority
 
 bool AccessibilityManager::isATSPIAvailable() const
 {
-    // Check if AT-SPI daemon is running
-    QProcess process;
-    process.start("pgrep", QStringList() << "at-spi-bus-launcher");
-    process.waitForFinished(1000);
-    
-    if (process.exitCode() == 0) {
-        logDebug("AT-SPI bus launcher is running");
-        return true;
-    }
-    
-    // Also check for at-spi2-core
-    process.start("pgrep", QStringList() << "at-spi2-registryd");
-    process.waitForFinished(1000);
-    
-    if (process.exitCode() == 0) {
-        logDebug("AT-SPI2 registry daemon is running");
-        return true;
-    }
-    
-    logDebug("AT-SPI services not detected");
-    return false;
-}
\ No newline at end of file
+    return m_atspiWatcher && m_atspiWatcher->isPresent();
+}
@@ -7,9 +7,9 @@
 #include <QSettings>
 #include <QAccessible>
 #include <QHash>
-#include <QQueue>
 #include <QTimer>
 
+class ATSPIBusWatcher;
 class WidgetAccessibilityEnhancer;
 // Temporarily disabled for beta build:
 // class KeyboardNavigationController;
@@ -36,6 +36,13 @@ class player;
  * accessibility state across the entire application and integrates with Qt6's
  * QAccessible framework and AT-SPI bridge for ORCA communication.
  * 
+ * Initialization is cheap: settings are read and the AT-SPI bus is watched,
+ * nothing more. The enhancers, their event filters, the feedback services
+ * and the announcers are only made by activate(), which runs when an
+ * assistive technology client connects (Qt reports it through
+ * QAccessible::ActivationObserver) or when the user turns accessibility on.
+ * Studio machines without a screen reader never pay for them.
+ * 
  * @example
  * @code
  * auto* manager = ServiceContainer::instance()->resolve<AccessibilityManager>();
@@ -47,7 +54,7 @@ class player;
  * @see WidgetAccessibilityEnhancer, BaseService
  * @since XFB 2.0
  */
-class AccessibilityManager : public BaseService
+class AccessibilityManager : public BaseService, public QAccessible::ActivationObserver
 {
     Q_OBJECT
 
@@ -143,6 +150,13 @@ public:
      */
     void announceMessage(const QString& message, Priority priority = Priority::Normal);
 
+    /**
+     * @brief Say a message now, for services that already paced it on AnnouncementBus
+     * @param message The message to announce
+     * @param priority Priority level of the announcement
+     */
+    void deliverAnnouncement(const QString& message, Priority priority = Priority::Normal);
+
     /**
      * @brief Load accessibility settings from persistent storage
      */
@@ -173,6 +187,21 @@ public:
      */
     bool initializePlayerAccessibility(player* playerWindow);
 
+    /**
+     * @brief Build the accessibility services and enhancers; does nothing if already done
+     *
+     * Called on its own once an assistive technology connects, or when
+     * accessibility is enabled. Player accessibility requested before that
+     * is set up here.
+     */
+    void activate();
+
+    /**
+     * @brief Check if the accessibility services have been built
+     * @return true once activate() has run
+     */
+    bool isActive() const { return m_active; }
+
     /**
      * @brief Get the player keyboard navigation enhancer (temporarily disabled for beta build)
      * @return nullptr (player keyboard enhancer disabled)
@@ -269,18 +298,28 @@ signals:
      */
     void verbosityLevelChanged(VerbosityLevel level);
 
+    /**
+     * @brief Emitted when the AT-SPI bus is first found up or down, and when that changes
+     * @param available true if a screen reader can reach the application
+     */
+    void atspiAvailabilityChanged(bool available);
+
+    /**
+     * @brief Emitted once activate() has built the accessibility services
+     */
+    void activated();
+
 protected:
     // BaseService interface implementation
     bool doInitialize() override;
     void doShutdown() override;
     QString getServiceName() const override;
+    bool healthCheck() override;
 
-private slots:
-    /**
-     * @brief Process queued announcements
-     */
-    void processAnnouncementQueue();
+    // QAccessible::ActivationObserver
+    void accessibilityActiveChanged(bool active) override;
 
+private slots:
     /**
      * @brief Handle widget destruction
      * @param obj The destroyed object
@@ -295,7 +334,7 @@ private:
     bool initializeQtAccessibility();
 
     /**
-     * @brief Initialize AT-SPI bridge configuration
+     * @brief Initialize AT-SPI bridge configuration and start watching the AT-SPI bus
      * @return true if initialization was successful
      */
     bool initializeATSPIBridge();
@@ -311,7 +350,7 @@ private:
     void cleanupAccessibility();
 
     /**
-     * @brief Queue an announcement for processing
+     * @brief Queue an announcement on AnnouncementBus
      * @param message The message to queue
      * @param priority Priority level
      */
@@ -325,8 +364,8 @@ private:
     void processAnnouncement(const QString& message, Priority priority);
 
     /**
-     * @brief Check if AT-SPI is available on the system
-     * @return true if AT-SPI is available
+     * @brief Check if AT-SPI is available on the system, as last heard from the session bus
+     * @return true if AT-SPI is available; false until the first answer arrives
      */
     bool isATSPIAvailable() const;
 
@@ -347,23 +386,15 @@ private:
     AccessibleHelpSystem* m_accessibleHelpSystem;
     ContextSensitiveHelpService* m_contextSensitiveHelpService;
     QSettings* m_settings;
+    ATSPIBusWatcher* m_atspiWatcher;
+    bool m_active;
+    bool m_observingActivation;
+    player* m_pendingPlayer;  ///< The main window, waiting for activate()
     
     // Widget metadata management
     QHash<QWidget*, AccessibilityMetadata> m_widgetMetadata;
     
-    // Announcement queue management
-    struct AnnouncementItem {
-        QString message;
-        Priority priority;
-        qint64 timestamp;
-    };
-    QQueue<AnnouncementItem> m_announcementQueue;
-    QTimer* m_announcementTimer;
-    bool m_processingAnnouncements;
-    
     // Configuration constants
-    static constexpr int ANNOUNCEMENT_PROCESSING_INTERVAL_MS = 100;
-    static constexpr int MAX_ANNOUNCEMENT_QUEUE_SIZE = 50;
     static constexpr const char* SETTINGS_GROUP = "Accessibility";
     static constexpr const char* SETTINGS_ENABLED = "Enabled";
     static constexpr const char* SETTINGS_VERBOSITY = "VerbosityLevel";
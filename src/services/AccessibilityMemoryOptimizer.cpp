@@ -1,4 +1,6 @@
 #include "AccessibilityMemoryOptimizer.h"
+#include "MemoryBudget.h"
+#include "MemoryPressureMonitor.h"
 #include <QWidget>
 #include <QAccessibleInterface>
 #include <QAccessible>
@@ -6,26 +8,24 @@
 #include <QDebug>
 #include <QMutexLocker>
 #include <QDateTime>
+#include <QTimer>
+#include <algorithm>
+#include <utility>
+#include <vector>
 
 AccessibilityMemoryOptimizer::AccessibilityMemoryOptimizer(QObject *parent)
     : QObject(parent)
     , m_strategy(Balanced)
-    , m_interfaceCache(100) // Default cache size
-    , m_cleanupTimer(new QTimer(this))
-    , m_memoryCheckTimer(new QTimer(this))
+    , m_pressureMonitor(new MemoryPressureMonitor(this))
     , m_currentMemoryUsage(0)
     , m_memoryLimit(50 * 1024 * 1024) // 50MB default limit
-    , m_lastCleanupUsage(0)
-    , m_cleanupInterval(30000) // 30 seconds
+    , m_cachedInterfaces(0)
     , m_cacheSize(100)
     , m_accessThreshold(5)
     , m_staleThreshold(24) // 24 hours
 {
-    connect(m_cleanupTimer, &QTimer::timeout, this, &AccessibilityMemoryOptimizer::performPeriodicCleanup);
-    connect(m_memoryCheckTimer, &QTimer::timeout, this, &AccessibilityMemoryOptimizer::checkMemoryUsage);
-    
-    // Set up cache cost function
-    m_interfaceCache.setMaxCost(m_cacheSize);
+    connect(m_pressureMonitor, &MemoryPressureMonitor::pressureDetected,
+            this, &AccessibilityMemoryOptimizer::onLowMemoryWarning);
 }
 
 AccessibilityMemoryOptimizer::~AccessibilityMemoryOptimizer()
@@ -40,9 +40,15 @@ void AccessibilityMemoryOptimizer::initialize()
     // Apply initial optimization strategy
     applyOptimizationStrategy();
     
-    // Start timers
-    m_cleanupTimer->start(m_cleanupInterval);
-    m_memoryCheckTimer->start(5000); // Check every 5 seconds
+    // Limits are kept on every insert; beyond that only the kernel wakes us
+    if (!m_pressureMonitor->start()) {
+        qDebug() << "No memory pressure source available, relying on limits alone";
+    }
+    
+    // Reported with the rest of the application, and trimmed with it
+    MemoryBudget::instance()->addSubsystem(
+        "accessibility", this, m_memoryLimit, [this]() { return getCurrentMemoryUsage(); },
+        [this](qint64 bytes) { shrinkTo(bytes); });
     
     qDebug() << "AccessibilityMemoryOptimizer initialized with strategy:" << m_strategy;
 }
@@ -66,59 +72,73 @@ void AccessibilityMemoryOptimizer::registerWidget(QWidget* widget, qint64 metada
 {
     if (!widget) return;
     
-    QMutexLocker locker(&m_dataMutex);
-    
-    WidgetMemoryInfo info;
-    info.widget = widget;
-    info.metadataSize = metadataSize;
-    info.lastAccessed = QDateTime::currentDateTime();
-    info.accessCount = 1;
-    
-    m_trackedWidgets[widget] = info;
-    m_currentMemoryUsage += metadataSize;
-    
-    updateMemoryUsage();
+    qint64 usage;
+    {
+        QMutexLocker locker(&m_dataMutex);
+        
+        WidgetMemoryInfo& info = trackWidget(widget);
+        m_currentMemoryUsage += metadataSize - info.metadataSize;
+        info.metadataSize = metadataSize;
+        info.lastAccessed = QDateTime::currentDateTime();
+        info.accessCount++;
+        
+        enforceLimits();
+        usage = m_currentMemoryUsage;
+    }
+    emit memoryUsageChanged(usage);
 }
 
 void AccessibilityMemoryOptimizer::unregisterWidget(QWidget* widget)
 {
     if (!widget) return;
     
-    QMutexLocker locker(&m_dataMutex);
-    
-    if (m_trackedWidgets.contains(widget)) {
-        qint64 size = m_trackedWidgets[widget].metadataSize;
-        m_trackedWidgets.remove(widget);
-        m_currentMemoryUsage -= size;
+    qint64 usage;
+    {
+        QMutexLocker locker(&m_dataMutex);
         
-        // Remove from cache as well
-        m_interfaceCache.remove(widget);
-        
-        updateMemoryUsage();
+        auto it = m_trackedWidgets.find(widget);
+        if (it == m_trackedWidgets.end()) {
+            return;
+        }
+        // Removes the cached interface as well
+        removeEntry(it);
+        usage = m_currentMemoryUsage;
     }
+    emit memoryUsageChanged(usage);
 }
 
 void AccessibilityMemoryOptimizer::cacheInterface(QWidget* widget, QAccessibleInterface* interface)
 {
     if (!widget || !interface) return;
     
-    QMutexLocker locker(&m_dataMutex);
-    
-    // Calculate interface size
-    qint64 interfaceSize = calculateInterfaceSize(interface);
-    
-    // Update widget access info
-    if (m_trackedWidgets.contains(widget)) {
-        WidgetMemoryInfo& info = m_trackedWidgets[widget];
+    qint64 usage;
+    qint64 overLimit = 0;
+    {
+        QMutexLocker locker(&m_dataMutex);
+        
+        WidgetMemoryInfo& info = trackWidget(widget);
         info.lastAccessed = QDateTime::currentDateTime();
         info.accessCount++;
+        
+        // A widget has one interface; caching another replaces it
+        if (info.interface != interface) {
+            dropInterface(info);
+            info.interface = interface;
+            info.interfaceSize = calculateInterfaceSize(interface);
+            m_currentMemoryUsage += info.interfaceSize;
+            ++m_cachedInterfaces;
+        }
+        
+        if (m_currentMemoryUsage > m_memoryLimit) {
+            overLimit = m_currentMemoryUsage;
+        }
+        enforceLimits();
+        usage = m_currentMemoryUsage;
     }
-    
-    // Cache the interface
-    m_interfaceCache.insert(widget, interface);
-    
-    m_currentMemoryUsage += interfaceSize;
-    updateMemoryUsage();
+    if (overLimit > 0) {
+        emit memoryLimitExceeded(overLimit, m_memoryLimit);
+    }
+    emit memoryUsageChanged(usage);
 }
 
 QAccessibleInterface* AccessibilityMemoryOptimizer::getCachedInterface(QWidget* widget)
@@ -127,20 +147,20 @@ QAccessibleInterface* AccessibilityMemoryOptimizer::getCachedInterface(QWidget*
     
     QMutexLocker locker(&m_dataMutex);
     
-    QAccessibleInterface* interface = m_interfaceCache.value(widget);
-    
-    if (interface && m_trackedWidgets.contains(widget)) {
-        // Update access info
-        WidgetMemoryInfo& info = m_trackedWidgets[widget];
-        info.lastAccessed = QDateTime::currentDateTime();
-        info.accessCount++;
+    auto it = m_trackedWidgets.find(widget);
+    if (it == m_trackedWidgets.end() || !it->interface) {
+        return nullptr;
     }
     
-    return interface;
+    // Update access info
+    it->lastAccessed = QDateTime::currentDateTime();
+    it->accessCount++;
+    return it->interface;
 }
 
 qint64 AccessibilityMemoryOptimizer::getCurrentMemoryUsage() const
 {
+    QMutexLocker locker(&m_dataMutex);
     return m_currentMemoryUsage;
 }
 
@@ -155,11 +175,9 @@ QHash<QString, qint64> AccessibilityMemoryOptimizer::getMemoryUsageByCategory()
     
     for (const WidgetMemoryInfo& info : m_trackedWidgets) {
         widgetMetadata += info.metadataSize;
+        cachedInterfaces += info.interfaceSize;
     }
     
-    // Estimate cached interface memory
-    cachedInterfaces = m_interfaceCache.totalCost() * 1024; // Convert from KB to bytes
-    
     usage["Widget Metadata"] = widgetMetadata;
     usage["Cached Interfaces"] = cachedInterfaces;
     usage["Other"] = m_currentMemoryUsage - widgetMetadata - cachedInterfaces;
@@ -167,55 +185,90 @@ QHash<QString, qint64> AccessibilityMemoryOptimizer::getMemoryUsageByCategory()
     return usage;
 }
 
-void AccessibilityMemoryOptimizer::performCleanup(bool force)
+int AccessibilityMemoryOptimizer::getCachedInterfaceCount() const
 {
     QMutexLocker locker(&m_dataMutex);
-    
-    qint64 initialUsage = m_currentMemoryUsage;
-    
-    // Clean up unused interfaces
-    cleanupUnusedInterfaces();
-    
-    // Clean up stale widgets
-    cleanupStaleWidgets();
-    
-    // Force cleanup if memory limit exceeded or forced
-    if (force || m_currentMemoryUsage > m_memoryLimit) {
-        // More aggressive cleanup
-        m_interfaceCache.clear();
+    return m_cachedInterfaces;
+}
+
+void AccessibilityMemoryOptimizer::performCleanup(bool force)
+{
+    qint64 freedBytes;
+    qint64 usage;
+    {
+        QMutexLocker locker(&m_dataMutex);
         
-        // Remove widgets that haven't been accessed recently
-        auto it = m_trackedWidgets.begin();
-        while (it != m_trackedWidgets.end()) {
-            const WidgetMemoryInfo& info = it.value();
-            QDateTime cutoff = QDateTime::currentDateTime().addSecs(-3600); // 1 hour
+        qint64 initialUsage = m_currentMemoryUsage;
+        
+        // Clean up stale widgets
+        cleanupStaleWidgets();
+        
+        if (force) {
+            // More aggressive cleanup: every interface goes, and so does the
+            // metadata of widgets that haven't been accessed recently
+            evictInterfaces(0, 0);
             
-            if (info.lastAccessed < cutoff || info.widget.isNull()) {
-                m_currentMemoryUsage -= info.metadataSize;
-                it = m_trackedWidgets.erase(it);
-            } else {
-                ++it;
+            const QDateTime cutoff = QDateTime::currentDateTime().addSecs(-3600); // 1 hour
+            auto it = m_trackedWidgets.begin();
+            while (it != m_trackedWidgets.end()) {
+                if (it->lastAccessed < cutoff) {
+                    it = removeEntry(it);
+                } else {
+                    ++it;
+                }
             }
+        } else {
+            enforceLimits();
         }
+        
+        freedBytes = initialUsage - m_currentMemoryUsage;
+        usage = m_currentMemoryUsage;
     }
     
-    qint64 freedBytes = initialUsage - m_currentMemoryUsage;
     if (freedBytes > 0) {
         emit cleanupPerformed(freedBytes);
         qDebug() << "Accessibility memory cleanup freed" << freedBytes << "bytes";
     }
     
-    updateMemoryUsage();
+    emit memoryUsageChanged(usage);
+}
+
+void AccessibilityMemoryOptimizer::shrinkTo(qint64 bytes)
+{
+    qint64 freedBytes;
+    qint64 usage;
+    {
+        QMutexLocker locker(&m_dataMutex);
+        
+        const qint64 initialUsage = m_currentMemoryUsage;
+        evictInterfaces(m_cacheSize, bytes);
+        if (m_currentMemoryUsage > bytes) {
+            cleanupStaleWidgets();
+        }
+        
+        freedBytes = initialUsage - m_currentMemoryUsage;
+        usage = m_currentMemoryUsage;
+    }
+    
+    if (freedBytes > 0) {
+        emit cleanupPerformed(freedBytes);
+    }
+    emit memoryUsageChanged(usage);
 }
 
 void AccessibilityMemoryOptimizer::setMemoryLimit(qint64 bytes)
 {
-    m_memoryLimit = bytes;
+    MemoryBudget::instance()->setBudget("accessibility", bytes);
+    {
+        QMutexLocker locker(&m_dataMutex);
+        m_memoryLimit = bytes;
+        if (m_currentMemoryUsage <= m_memoryLimit) {
+            return;
+        }
+    }
     
     // Trigger cleanup if current usage exceeds new limit
-    if (m_currentMemoryUsage > m_memoryLimit) {
-        QTimer::singleShot(0, this, [this]() { performCleanup(true); });
-    }
+    performCleanup(false);
 }
 
 qint64 AccessibilityMemoryOptimizer::getMemoryLimit() const
@@ -230,7 +283,10 @@ void AccessibilityMemoryOptimizer::optimizeMemory()
     switch (m_strategy) {
     case Conservative:
         // Only clean up obviously stale data
-        cleanupStaleWidgets();
+        {
+            QMutexLocker locker(&m_dataMutex);
+            cleanupStaleWidgets();
+        }
         break;
         
     case Balanced:
@@ -249,91 +305,136 @@ void AccessibilityMemoryOptimizer::onLowMemoryWarning()
 {
     qDebug() << "Low memory warning received, performing aggressive cleanup";
     
-    // Temporarily switch to aggressive strategy
-    OptimizationStrategy originalStrategy = m_strategy;
-    setOptimizationStrategy(Aggressive);
-    
+    // Interfaces are rebuilt by Qt on demand; dropping them all is safe
     performCleanup(true);
-    
-    // Restore original strategy
-    setOptimizationStrategy(originalStrategy);
 }
 
 void AccessibilityMemoryOptimizer::clearCache()
 {
-    QMutexLocker locker(&m_dataMutex);
-    
-    qint64 initialUsage = m_currentMemoryUsage;
-    
-    m_interfaceCache.clear();
-    m_trackedWidgets.clear();
-    m_currentMemoryUsage = 0;
+    qint64 freedBytes;
+    {
+        QMutexLocker locker(&m_dataMutex);
+        
+        freedBytes = m_currentMemoryUsage;
+        
+        for (const WidgetMemoryInfo& info : std::as_const(m_trackedWidgets)) {
+            if (info.widget) {
+                disconnect(info.widget, &QObject::destroyed,
+                           this, &AccessibilityMemoryOptimizer::onWidgetDestroyed);
+            }
+        }
+        m_trackedWidgets.clear();
+        m_cachedInterfaces = 0;
+        m_currentMemoryUsage = 0;
+    }
     
-    qint64 freedBytes = initialUsage;
     if (freedBytes > 0) {
         emit cleanupPerformed(freedBytes);
     }
     
-    updateMemoryUsage();
+    emit memoryUsageChanged(0);
 }
 
-void AccessibilityMemoryOptimizer::performPeriodicCleanup()
+void AccessibilityMemoryOptimizer::onWidgetDestroyed(QObject* object)
 {
-    // Only perform cleanup if memory usage has grown significantly
-    qint64 growthThreshold = m_lastCleanupUsage * 1.2; // 20% growth
-    
-    if (m_currentMemoryUsage > growthThreshold || m_currentMemoryUsage > m_memoryLimit * 0.8) {
-        optimizeMemory();
-        m_lastCleanupUsage = m_currentMemoryUsage;
+    qint64 usage;
+    {
+        QMutexLocker locker(&m_dataMutex);
+        
+        // The widget is half destroyed; only its address is used
+        auto it = m_trackedWidgets.find(static_cast<QWidget*>(object));
+        if (it == m_trackedWidgets.end()) {
+            return;
+        }
+        removeEntry(it);
+        usage = m_currentMemoryUsage;
     }
+    emit memoryUsageChanged(usage);
 }
 
-void AccessibilityMemoryOptimizer::checkMemoryUsage()
+AccessibilityMemoryOptimizer::WidgetMemoryInfo&
+AccessibilityMemoryOptimizer::trackWidget(QWidget* widget)
 {
-    if (m_currentMemoryUsage > m_memoryLimit) {
-        emit memoryLimitExceeded(m_currentMemoryUsage, m_memoryLimit);
-        
-        // Trigger cleanup
-        QTimer::singleShot(0, this, [this]() { performCleanup(true); });
+    auto it = m_trackedWidgets.find(widget);
+    if (it != m_trackedWidgets.end()) {
+        return *it;
     }
+    
+    // The entry lives exactly as long as the widget
+    connect(widget, &QObject::destroyed, this, &AccessibilityMemoryOptimizer::onWidgetDestroyed,
+            Qt::DirectConnection);
+    
+    WidgetMemoryInfo info;
+    info.widget = widget;
+    m_currentMemoryUsage += ENTRY_OVERHEAD;
+    return *m_trackedWidgets.insert(widget, info);
 }
 
-void AccessibilityMemoryOptimizer::updateMemoryUsage()
+QHash<QWidget*, AccessibilityMemoryOptimizer::WidgetMemoryInfo>::iterator
+AccessibilityMemoryOptimizer::removeEntry(QHash<QWidget*, WidgetMemoryInfo>::iterator it)
 {
-    emit memoryUsageChanged(m_currentMemoryUsage);
+    dropInterface(*it);
+    m_currentMemoryUsage -= it->metadataSize + ENTRY_OVERHEAD;
+    if (it->widget) {
+        disconnect(it->widget, &QObject::destroyed,
+                   this, &AccessibilityMemoryOptimizer::onWidgetDestroyed);
+    }
+    return m_trackedWidgets.erase(it);
 }
 
-void AccessibilityMemoryOptimizer::cleanupUnusedInterfaces()
+void AccessibilityMemoryOptimizer::dropInterface(WidgetMemoryInfo& info)
 {
-    // Remove interfaces for widgets that no longer exist
-    QList<QWidget*> keysToRemove;
+    if (!info.interface) {
+        return;
+    }
+    // The interface belongs to QAccessible's own cache; only our reference goes
+    m_currentMemoryUsage -= info.interfaceSize;
+    info.interface = nullptr;
+    info.interfaceSize = 0;
+    --m_cachedInterfaces;
+}
+
+void AccessibilityMemoryOptimizer::enforceLimits()
+{
+    if (m_cachedInterfaces <= m_cacheSize && m_currentMemoryUsage <= m_memoryLimit) {
+        return;
+    }
+    evictInterfaces(m_cacheSize, m_memoryLimit);
     
+    // Interfaces alone may not be enough; stale metadata goes next
+    if (m_currentMemoryUsage > m_memoryLimit) {
+        cleanupStaleWidgets();
+    }
+}
+
+void AccessibilityMemoryOptimizer::evictInterfaces(int keepCount, qint64 keepBytes)
+{
+    // Least recently used first
+    std::vector<QHash<QWidget*, WidgetMemoryInfo>::iterator> cached;
+    cached.reserve(size_t(m_cachedInterfaces));
     for (auto it = m_trackedWidgets.begin(); it != m_trackedWidgets.end(); ++it) {
-        if (it.value().widget.isNull()) {
-            keysToRemove.append(it.key());
+        if (it->interface) {
+            cached.push_back(it);
         }
     }
+    std::sort(cached.begin(), cached.end(), [](const auto& a, const auto& b) {
+        return a->lastAccessed < b->lastAccessed;
+    });
     
-    for (QWidget* key : keysToRemove) {
-        qint64 size = m_trackedWidgets[key].metadataSize;
-        m_trackedWidgets.remove(key);
-        m_interfaceCache.remove(key);
-        m_currentMemoryUsage -= size;
+    for (auto& it : cached) {
+        if (m_cachedInterfaces <= keepCount && m_currentMemoryUsage <= keepBytes) {
+            break;
+        }
+        dropInterface(*it);
     }
 }
 
 void AccessibilityMemoryOptimizer::cleanupStaleWidgets()
 {
-    QDateTime cutoff = QDateTime::currentDateTime().addSecs(-m_staleThreshold * 3600);
-    
     auto it = m_trackedWidgets.begin();
     while (it != m_trackedWidgets.end()) {
-        const WidgetMemoryInfo& info = it.value();
-        
-        if (shouldCleanupWidget(info)) {
-            m_currentMemoryUsage -= info.metadataSize;
-            m_interfaceCache.remove(it.key());
-            it = m_trackedWidgets.erase(it);
+        if (shouldCleanupWidget(it.value())) {
+            it = removeEntry(it);
         } else {
             ++it;
         }
@@ -344,21 +445,18 @@ qint64 AccessibilityMemoryOptimizer::calculateInterfaceSize(QAccessibleInterface
 {
     if (!interface) return 0;
     
-    // Estimate interface size based on text content and complexity
-    qint64 size = sizeof(QAccessibleInterface);
-    
-    // Add estimated size for text content
-    QString name = interface->text(QAccessible::Name);
-    QString description = interface->text(QAccessible::Description);
-    QString value = interface->text(QAccessible::Value);
+    // What the interface holds on Qt's side: its object, and the text it
+    // answers with, counted by allocated capacity rather than length
+    qint64 size = sizeof(void*) * 4; // vtable, object pointer, QAccessible cache slot
     
-    size += name.length() * sizeof(QChar);
-    size += description.length() * sizeof(QChar);
-    size += value.length() * sizeof(QChar);
+    for (QAccessible::Text text : {QAccessible::Name, QAccessible::Description,
+                                   QAccessible::Value, QAccessible::Help}) {
+        const QString content = interface->text(text);
+        size += sizeof(QString) + qint64(content.capacity()) * qint64(sizeof(QChar));
+    }
     
-    // Add estimated size for child interfaces
-    int childCount = interface->childCount();
-    size += childCount * sizeof(void*); // Rough estimate for child pointers
+    // Children are interfaces of their own with entries of their own; only the links count here
+    size += qint64(interface->childCount()) * qint64(sizeof(void*));
     
     return size;
 }
@@ -393,34 +491,28 @@ bool AccessibilityMemoryOptimizer::shouldCleanupWidget(const WidgetMemoryInfo& i
 
 void AccessibilityMemoryOptimizer::applyOptimizationStrategy()
 {
+    QMutexLocker locker(&m_dataMutex);
+    
     switch (m_strategy) {
     case Conservative:
-        m_cleanupInterval = 60000; // 1 minute
         m_cacheSize = 200;
         m_accessThreshold = 2;
         m_staleThreshold = 48; // 48 hours
         break;
         
     case Balanced:
-        m_cleanupInterval = 30000; // 30 seconds
         m_cacheSize = 100;
         m_accessThreshold = 5;
         m_staleThreshold = 24; // 24 hours
         break;
         
     case Aggressive:
-        m_cleanupInterval = 15000; // 15 seconds
         m_cacheSize = 50;
         m_accessThreshold = 10;
         m_staleThreshold = 12; // 12 hours
         break;
     }
     
-    // Update cache size
-    m_interfaceCache.setMaxCost(m_cacheSize);
-    
-    // Update timer interval
-    if (m_cleanupTimer->isActive()) {
-        m_cleanupTimer->setInterval(m_cleanupInterval);
-    }
-}
\ No newline at end of file
+    // A smaller cache takes effect at once
+    enforceLimits();
+}
@@ -2,21 +2,29 @@
 #define ACCESSIBILITYMEMORYOPTIMIZER_H
 
 #include <QObject>
-#include <QTimer>
 #include <QHash>
-#include <QWeakPointer>
+#include <QPointer>
 #include <QMutex>
-#include <QCache>
 #include <QDateTime>
 
 class QWidget;
 class QAccessibleInterface;
+class MemoryPressureMonitor;
 
 /**
  * @brief Memory optimization system for accessibility metadata
  * 
  * Manages memory usage of accessibility-related data including
  * cached interfaces, metadata, and temporary objects.
+ * 
+ * Entries are keyed by widget and hold it weakly: the widget's destroyed()
+ * signal removes its entry at once, so the cache never hands out an
+ * interface of a widget that is gone. Usage is the exact sum of what the
+ * entries account for, each entry's size being counted when it is stored
+ * and taken off when it leaves. The limits are kept on every insert by
+ * evicting the least recently used interfaces, and on memory pressure
+ * reported by the kernel (see MemoryPressureMonitor) the cache is trimmed
+ * without waiting for a timer.
  */
 class AccessibilityMemoryOptimizer : public QObject
 {
@@ -97,6 +105,12 @@ public:
      */
     void performCleanup(bool force = false);
 
+    /**
+     * @brief Drop the least recently used interfaces, then stale metadata, down to a size
+     * @param bytes Memory usage to get under; the limit itself is unchanged
+     */
+    void shrinkTo(qint64 bytes);
+
     /**
      * @brief Set memory usage limit
      * @param bytes Maximum memory usage in bytes
@@ -109,6 +123,12 @@ public:
      */
     qint64 getMemoryLimit() const;
 
+    /**
+     * @brief Get number of cached interfaces
+     * @return Interfaces currently cached
+     */
+    int getCachedInterfaceCount() const;
+
 public slots:
     /**
      * @brief Optimize memory usage based on current strategy
@@ -146,23 +166,28 @@ signals:
     void cleanupPerformed(qint64 freedBytes);
 
 private slots:
-    void performPeriodicCleanup();
-    void checkMemoryUsage();
+    void onWidgetDestroyed(QObject* object);
 
 private:
     /**
      * @brief Structure for tracking widget memory usage
      */
     struct WidgetMemoryInfo {
-        QWeakPointer<QWidget> widget;
-        qint64 metadataSize;
+        QPointer<QWidget> widget;
+        qint64 metadataSize = 0;
+        QAccessibleInterface* interface = nullptr;
+        qint64 interfaceSize = 0;
         QDateTime lastAccessed;
-        int accessCount;
+        int accessCount = 0;
     };
 
-    // Helper methods
-    void updateMemoryUsage();
-    void cleanupUnusedInterfaces();
+    // Helper methods, called with m_dataMutex held
+    WidgetMemoryInfo& trackWidget(QWidget* widget);
+    QHash<QWidget*, WidgetMemoryInfo>::iterator
+    removeEntry(QHash<QWidget*, WidgetMemoryInfo>::iterator it);
+    void dropInterface(WidgetMemoryInfo& info);
+    void enforceLimits();
+    void evictInterfaces(int keepCount, qint64 keepBytes);
     void cleanupStaleWidgets();
     qint64 calculateInterfaceSize(QAccessibleInterface* interface) const;
     bool shouldCleanupWidget(const WidgetMemoryInfo& info) const;
@@ -171,20 +196,19 @@ private:
     // Member variables
     OptimizationStrategy m_strategy;
     QHash<QWidget*, WidgetMemoryInfo> m_trackedWidgets;
-    QHash<QWidget*, QAccessibleInterface*> m_interfaceCache;
-    QTimer* m_cleanupTimer;
-    QTimer* m_memoryCheckTimer;
+    MemoryPressureMonitor* m_pressureMonitor;
     mutable QMutex m_dataMutex;
     
     qint64 m_currentMemoryUsage;
     qint64 m_memoryLimit;
-    qint64 m_lastCleanupUsage;
+    int m_cachedInterfaces;
     
     // Configuration based on strategy
-    int m_cleanupInterval;
     int m_cacheSize;
     int m_accessThreshold;
     int m_staleThreshold; // Hours
+    
+    static constexpr qint64 ENTRY_OVERHEAD = sizeof(WidgetMemoryInfo) + 2 * sizeof(void*);
 };
 
 #endif // ACCESSIBILITYMEMORYOPTIMIZER_H
\ No newline at end of file
@@ -6,44 +6,26 @@
 #include <QThread>
 #include <QProcess>
 #include <cmath>
+#include <limits>
 
 AccessibilityPerformanceMonitor::AccessibilityPerformanceMonitor(QObject *parent)
     : QObject(parent)
     , m_periodicTimer(new QTimer(this))
-    , m_cleanupTimer(new QTimer(this))
     , m_autoOptimizationEnabled(true)
     , m_currentAlertLevel(Normal)
 {
     // Initialize timers
     m_periodicTimer->setInterval(PERIODIC_CHECK_INTERVAL);
-    m_cleanupTimer->setInterval(CLEANUP_INTERVAL);
     
     connect(m_periodicTimer, &QTimer::timeout, this, &AccessibilityPerformanceMonitor::performPeriodicCheck);
-    connect(m_cleanupTimer, &QTimer::timeout, this, &AccessibilityPerformanceMonitor::cleanupOldMeasurements);
     
     // Initialize thresholds
     initializeThresholds();
-    
-    // Initialize metric data structures
-    for (int i = AnnouncementLatency; i <= WidgetEnhancementTime; ++i) {
-        MetricType type = static_cast<MetricType>(i);
-        m_metrics[type] = MetricData();
-        m_metrics[type].enabled = true;
-        m_metrics[type].stats = PerformanceStats();
-        m_metrics[type].stats.averageLatency = 0.0;
-        m_metrics[type].stats.maxLatency = 0.0;
-        m_metrics[type].stats.minLatency = std::numeric_limits<double>::max();
-        m_metrics[type].stats.sampleCount = 0;
-        m_metrics[type].stats.totalMemoryUsage = 0;
-        m_metrics[type].stats.memoryGrowthRate = 0.0;
-        m_metrics[type].stats.lastUpdated = QDateTime::currentDateTime();
-    }
 }
 
 AccessibilityPerformanceMonitor::~AccessibilityPerformanceMonitor()
 {
     m_periodicTimer->stop();
-    m_cleanupTimer->stop();
 }
 
 void AccessibilityPerformanceMonitor::initialize()
@@ -52,7 +34,6 @@ void AccessibilityPerformanceMonitor::initialize()
     
     // Start monitoring timers
     m_periodicTimer->start();
-    m_cleanupTimer->start();
     
     // Reset statistics
     resetStats();
@@ -62,19 +43,18 @@ void AccessibilityPerformanceMonitor::initialize()
 
 void AccessibilityPerformanceMonitor::setMonitoringEnabled(MetricType type, bool enabled)
 {
-    QMutexLocker locker(&m_dataMutex);
-    
-    if (m_metrics.contains(type)) {
-        m_metrics[type].enabled = enabled;
-        qDebug() << "Monitoring for metric type" << type << (enabled ? "enabled" : "disabled");
+    if (type < 0 || type >= METRIC_COUNT) {
+        return;
     }
+    
+    m_metrics[type].enabled.store(enabled, std::memory_order_relaxed);
+    qDebug() << "Monitoring for metric type" << type << (enabled ? "enabled" : "disabled");
 }
 
 bool AccessibilityPerformanceMonitor::isMonitoringEnabled(MetricType type) const
 {
-    QMutexLocker locker(&m_dataMutex);
-    
-    return m_metrics.value(type).enabled;
+    return type >= 0 && type < METRIC_COUNT
+           && m_metrics[type].enabled.load(std::memory_order_relaxed);
 }
 
 void AccessibilityPerformanceMonitor::startMeasurement(MetricType type, const QString& operationId)
@@ -85,15 +65,11 @@ void AccessibilityPerformanceMonitor::startMeasurement(MetricType type, const QS
     
     QMutexLocker locker(&m_dataMutex);
     
-    QString id = operationId.isEmpty() ? QString::number(reinterpret_cast<quintptr>(QThread::currentThreadId())) : operationId;
-    
-    Measurement measurement;
-    measurement.timer.start();
-    measurement.operationId = id;
-    measurement.startTime = QDateTime::currentDateTime();
-    measurement.active = true;
-    
-    m_metrics[type].activeMeasurements[id] = measurement;
+    QHash<QString, QElapsedTimer>& measurements = m_activeMeasurements[type];
+    if (measurements.size() >= MAX_ACTIVE_MEASUREMENTS) {
+        dropAbandonedMeasurements(measurements);
+    }
+    measurements[measurementId(operationId)].start();
 }
 
 void AccessibilityPerformanceMonitor::endMeasurement(MetricType type, const QString& operationId)
@@ -102,27 +78,19 @@ void AccessibilityPerformanceMonitor::endMeasurement(MetricType type, const QStr
         return;
     }
     
-    QMutexLocker locker(&m_dataMutex);
-    
-    QString id = operationId.isEmpty() ? QString::number(reinterpret_cast<quintptr>(QThread::currentThreadId())) : operationId;
-    
-    if (m_metrics[type].activeMeasurements.contains(id)) {
-        Measurement& measurement = m_metrics[type].activeMeasurements[id];
+    double elapsedMs = 0.0;
+    {
+        QMutexLocker locker(&m_dataMutex);
         
-        if (measurement.active) {
-            double elapsedMs = measurement.timer.elapsed();
-            measurement.active = false;
-            
-            // Record the measurement
-            updateStats(type, elapsedMs);
-            
-            // Check performance thresholds
-            checkPerformanceThresholds(type, elapsedMs);
-            
-            // Remove completed measurement
-            m_metrics[type].activeMeasurements.remove(id);
+        auto it = m_activeMeasurements[type].find(measurementId(operationId));
+        if (it == m_activeMeasurements[type].end()) {
+            return;
         }
+        elapsedMs = it.value().nsecsElapsed() / 1e6;
+        m_activeMeasurements[type].erase(it);
     }
+    
+    recordLatency(type, elapsedMs);
 }
 
 void AccessibilityPerformanceMonitor::recordMemoryUsage(qint64 bytes, const QString& component)
@@ -134,13 +102,12 @@ void AccessibilityPerformanceMonitor::recordMemoryUsage(qint64 bytes, const QStr
     m_memoryUsageByComponent[comp] = bytes;
     
     // Update memory stats
-    MetricData& memoryMetric = m_metrics[MemoryUsage];
-    memoryMetric.stats.totalMemoryUsage = bytes;
+    m_memoryStats.totalMemoryUsage = bytes;
     
     // Calculate growth rate
     if (previousUsage > 0) {
         double growthRate = (static_cast<double>(bytes - previousUsage) / previousUsage) * 100.0;
-        memoryMetric.stats.memoryGrowthRate = growthRate;
+        m_memoryStats.memoryGrowthRate = growthRate;
         
         // Check for memory growth issues
         if (growthRate > 10.0) { // More than 10% growth
@@ -150,15 +117,46 @@ void AccessibilityPerformanceMonitor::recordMemoryUsage(qint64 bytes, const QStr
         }
     }
     
-    memoryMetric.stats.lastUpdated = QDateTime::currentDateTime();
-    emit statsUpdated(MemoryUsage, memoryMetric.stats);
+    m_memoryStats.lastUpdated = QDateTime::currentDateTime();
+    emit statsUpdated(MemoryUsage, m_memoryStats);
+}
+
+void AccessibilityPerformanceMonitor::recordLatency(MetricType type, double latencyMs)
+{
+    if (type == MemoryUsage || !isMonitoringEnabled(type)) {
+        return;
+    }
+    
+    recordSample(type, latencyMs);
+    checkPerformanceThresholds(type, latencyMs);
 }
 
 AccessibilityPerformanceMonitor::PerformanceStats AccessibilityPerformanceMonitor::getStats(MetricType type) const
 {
-    QMutexLocker locker(&m_dataMutex);
+    PerformanceStats stats;
+    if (type < 0 || type >= METRIC_COUNT) {
+        return stats;
+    }
+    if (type == MemoryUsage) {
+        QMutexLocker locker(&m_dataMutex);
+        return m_memoryStats;
+    }
     
-    return m_metrics.value(type).stats;
+    const MetricData& metric = m_metrics[type];
+    const qint64 count = metric.histogram.count();
+    stats.sampleCount = static_cast<int>(qMin<qint64>(count, std::numeric_limits<int>::max()));
+    if (count > 0) {
+        stats.averageLatency = metric.histogram.sum() / 1000.0 / count;
+        stats.maxLatency = metric.histogram.max() / 1000.0;
+        stats.minLatency = qMax<qint64>(0, metric.minUs.load(std::memory_order_relaxed)) / 1000.0;
+        stats.p95Latency = metric.histogram.percentile(95.0) / 1000.0;
+        stats.p99Latency = metric.histogram.percentile(99.0) / 1000.0;
+    }
+    const qint64 lastUpdatedMs = metric.lastUpdatedMs.load(std::memory_order_relaxed);
+    if (lastUpdatedMs > 0) {
+        stats.lastUpdated = QDateTime::fromMSecsSinceEpoch(lastUpdatedMs);
+    }
+    return stats;
 }
 
 AccessibilityPerformanceMonitor::AlertLevel AccessibilityPerformanceMonitor::getCurrentAlertLevel() const
@@ -168,16 +166,14 @@ AccessibilityPerformanceMonitor::AlertLevel AccessibilityPerformanceMonitor::get
 
 QStringList AccessibilityPerformanceMonitor::getPerformanceRecommendations() const
 {
-    QMutexLocker locker(&m_dataMutex);
-    
     QStringList recommendations;
     
     // Analyze each metric and provide recommendations
-    for (auto it = m_metrics.constBegin(); it != m_metrics.constEnd(); ++it) {
-        MetricType type = it.key();
-        const PerformanceStats& stats = it.value().stats;
+    for (int i = 0; i < METRIC_COUNT; ++i) {
+        const MetricType type = static_cast<MetricType>(i);
+        const PerformanceStats stats = getStats(type);
         
-        if (!it.value().enabled || stats.sampleCount == 0) {
+        if (!isMonitoringEnabled(type) || stats.sampleCount == 0) {
             continue;
         }
         
@@ -244,20 +240,18 @@ void AccessibilityPerformanceMonitor::resetStats()
 {
     QMutexLocker locker(&m_dataMutex);
     
-    for (auto it = m_metrics.begin(); it != m_metrics.end(); ++it) {
-        it.value().samples.clear();
-        it.value().stats = PerformanceStats();
-        it.value().stats.averageLatency = 0.0;
-        it.value().stats.maxLatency = 0.0;
-        it.value().stats.minLatency = std::numeric_limits<double>::max();
-        it.value().stats.sampleCount = 0;
-        it.value().stats.totalMemoryUsage = 0;
-        it.value().stats.memoryGrowthRate = 0.0;
-        it.value().stats.lastUpdated = QDateTime::currentDateTime();
-        it.value().activeMeasurements.clear();
+    for (MetricData& metric : m_metrics) {
+        metric.histogram.reset();
+        metric.minUs.store(-1, std::memory_order_relaxed);
+        metric.lastUpdatedMs.store(0, std::memory_order_relaxed);
+        metric.reportedCount = 0;
+    }
+    for (QHash<QString, QElapsedTimer>& measurements : m_activeMeasurements) {
+        measurements.clear();
     }
     
     m_memoryUsageByComponent.clear();
+    m_memoryStats = PerformanceStats();
     m_currentAlertLevel = Normal;
     
     qDebug() << "Performance statistics reset";
@@ -325,14 +319,12 @@ void AccessibilityPerformanceMonitor::optimizePerformance()
 
 void AccessibilityPerformanceMonitor::onAnnouncementLatency(double latencyMs)
 {
-    updateStats(AnnouncementLatency, latencyMs);
-    checkPerformanceThresholds(AnnouncementLatency, latencyMs);
+    recordLatency(AnnouncementLatency, latencyMs);
 }
 
 void AccessibilityPerformanceMonitor::onFocusChangeLatency(double latencyMs)
 {
-    updateStats(FocusChangeLatency, latencyMs);
-    checkPerformanceThresholds(FocusChangeLatency, latencyMs);
+    recordLatency(FocusChangeLatency, latencyMs);
 }
 
 void AccessibilityPerformanceMonitor::onMemoryUsageUpdate(qint64 bytes)
@@ -345,14 +337,25 @@ void AccessibilityPerformanceMonitor::performPeriodicCheck()
     // Calculate overall alert level
     AlertLevel maxLevel = Normal;
     
-    QMutexLocker locker(&m_dataMutex);
-    
-    for (auto it = m_metrics.constBegin(); it != m_metrics.constEnd(); ++it) {
-        if (!it.value().enabled || it.value().stats.sampleCount == 0) {
+    for (int i = 0; i < METRIC_COUNT; ++i) {
+        const MetricType type = static_cast<MetricType>(i);
+        if (type == MemoryUsage || !isMonitoringEnabled(type)) {
+            continue;
+        }
+        
+        const PerformanceStats stats = getStats(type);
+        if (stats.sampleCount == 0) {
             continue;
         }
         
-        AlertLevel level = calculateAlertLevel(it.key(), it.value().stats);
+        // Report what was recorded since the last check, once
+        MetricData& metric = m_metrics[type];
+        if (stats.sampleCount != metric.reportedCount) {
+            metric.reportedCount = stats.sampleCount;
+            emit statsUpdated(type, stats);
+        }
+        
+        AlertLevel level = calculateAlertLevel(type, stats);
         if (level > maxLevel) {
             maxLevel = level;
         }
@@ -379,61 +382,17 @@ void AccessibilityPerformanceMonitor::performPeriodicCheck()
     }
 }
 
-void AccessibilityPerformanceMonitor::cleanupOldMeasurements()
+void AccessibilityPerformanceMonitor::recordSample(MetricType type, double valueMs)
 {
-    QMutexLocker locker(&m_dataMutex);
-    
-    QDateTime cutoff = QDateTime::currentDateTime().addSecs(-SAMPLE_RETENTION_HOURS * 3600);
+    MetricData& metric = m_metrics[type];
+    const qint64 valueUs = qMax<qint64>(0, std::llround(valueMs * 1000.0));
     
-    for (auto it = m_metrics.begin(); it != m_metrics.end(); ++it) {
-        // Clean up old active measurements that may have been abandoned
-        auto measurementIt = it.value().activeMeasurements.begin();
-        while (measurementIt != it.value().activeMeasurements.end()) {
-            if (measurementIt.value().startTime < cutoff) {
-                measurementIt = it.value().activeMeasurements.erase(measurementIt);
-            } else {
-                ++measurementIt;
-            }
-        }
-        
-        // Prune old samples
-        pruneOldSamples(it.key());
+    metric.histogram.record(valueUs);
+    qint64 min = metric.minUs.load(std::memory_order_relaxed);
+    while ((min < 0 || valueUs < min)
+           && !metric.minUs.compare_exchange_weak(min, valueUs, std::memory_order_relaxed)) {
     }
-}
-
-void AccessibilityPerformanceMonitor::updateStats(MetricType type, double value)
-{
-    if (!m_metrics.contains(type)) {
-        return;
-    }
-    
-    MetricData& data = m_metrics[type];
-    PerformanceStats& stats = data.stats;
-    
-    // Record sample
-    recordSample(type, value);
-    
-    // Update statistics
-    stats.sampleCount++;
-    
-    if (value > stats.maxLatency) {
-        stats.maxLatency = value;
-    }
-    
-    if (value < stats.minLatency) {
-        stats.minLatency = value;
-    }
-    
-    // Calculate running average
-    if (stats.sampleCount == 1) {
-        stats.averageLatency = value;
-    } else {
-        stats.averageLatency = ((stats.averageLatency * (stats.sampleCount - 1)) + value) / stats.sampleCount;
-    }
-    
-    stats.lastUpdated = QDateTime::currentDateTime();
-    
-    emit statsUpdated(type, stats);
+    metric.lastUpdatedMs.store(QDateTime::currentMSecsSinceEpoch(), std::memory_order_relaxed);
 }
 
 void AccessibilityPerformanceMonitor::checkPerformanceThresholds(MetricType type, double value)
@@ -469,9 +428,10 @@ AccessibilityPerformanceMonitor::AlertLevel AccessibilityPerformanceMonitor::cal
     double warningThreshold = getThreshold(type, "warning");
     double criticalThreshold = getThreshold(type, "critical");
     
-    if (stats.averageLatency >= criticalThreshold || stats.maxLatency >= criticalThreshold * 1.5) {
+    // The tail, not one outlier kept forever in the maximum
+    if (stats.averageLatency >= criticalThreshold || stats.p99Latency >= criticalThreshold * 1.5) {
         return Critical;
-    } else if (stats.averageLatency >= warningThreshold || stats.maxLatency >= warningThreshold * 1.5) {
+    } else if (stats.averageLatency >= warningThreshold || stats.p99Latency >= warningThreshold * 1.5) {
         return Warning;
     }
     
@@ -535,25 +495,29 @@ void AccessibilityPerformanceMonitor::initializeThresholds()
     m_thresholds[WidgetEnhancementTime]["critical"] = 25.0;  // 25ms
 }
 
-void AccessibilityPerformanceMonitor::recordSample(MetricType type, double value)
+void AccessibilityPerformanceMonitor::dropAbandonedMeasurements(QHash<QString, QElapsedTimer>& measurements)
 {
-    MetricData& data = m_metrics[type];
-    
-    data.samples.enqueue(value);
-    
-    // Limit sample count to prevent excessive memory usage
-    while (data.samples.size() > MAX_SAMPLES) {
-        data.samples.dequeue();
+    // Started and never ended; without this, unique ids would pile up
+    QString oldestId;
+    qint64 oldestElapsed = -1;
+    for (auto it = measurements.begin(); it != measurements.end();) {
+        const qint64 elapsed = it.value().elapsed();
+        if (elapsed > ABANDONED_MEASUREMENT_MS) {
+            it = measurements.erase(it);
+            continue;
+        }
+        if (elapsed > oldestElapsed) {
+            oldestId = it.key();
+            oldestElapsed = elapsed;
+        }
+        ++it;
+    }
+    if (measurements.size() >= MAX_ACTIVE_MEASUREMENTS) {
+        measurements.remove(oldestId);
     }
 }
 
-void AccessibilityPerformanceMonitor::pruneOldSamples(MetricType type)
+QString AccessibilityPerformanceMonitor::measurementId(const QString& operationId)
 {
-    // For now, we just limit by count. In a more sophisticated implementation,
-    // we could track timestamps and prune by age.
-    MetricData& data = m_metrics[type];
-    
-    while (data.samples.size() > MAX_SAMPLES) {
-        data.samples.dequeue();
-    }
-}
\ No newline at end of file
+    return operationId.isEmpty() ? QString::number(reinterpret_cast<quintptr>(QThread::currentThreadId())) : operationId;
+}
@@ -1,15 +1,17 @@
 #ifndef ACCESSIBILITYPERFORMANCEMONITOR_H
 #define ACCESSIBILITYPERFORMANCEMONITOR_H
 
+#include "MetricsRegistry.h"
 #include <QObject>
 #include <QTimer>
 #include <QElapsedTimer>
-#include <QQueue>
 #include <QMutex>
 #include <QThread>
 #include <QHash>
 #include <QVariant>
 #include <QDateTime>
+#include <array>
+#include <atomic>
 
 /**
  * @brief Performance monitoring system for accessibility operations
@@ -17,6 +19,13 @@
  * Monitors and optimizes performance of accessibility-related operations
  * including announcement latency, memory usage, and focus change performance.
  * Provides metrics and automatic optimization suggestions.
+ *
+ * Latencies are counted in a fixed-size log-bucketed histogram per metric
+ * (MetricsRegistry::Histogram, in microseconds) instead of a list of
+ * samples, so the monitor's memory stays the same however long it runs and
+ * nothing has to be pruned. Recording a latency takes no lock and may be
+ * done from any thread; averages and the p95 and p99 latencies are worked
+ * out from the buckets when asked for.
  */
 class AccessibilityPerformanceMonitor : public QObject
 {
@@ -48,12 +57,14 @@ public:
      * @brief Performance statistics structure
      */
     struct PerformanceStats {
-        double averageLatency;
-        double maxLatency;
-        double minLatency;
-        int sampleCount;
-        qint64 totalMemoryUsage;
-        double memoryGrowthRate;
+        double averageLatency = 0.0;
+        double maxLatency = 0.0;
+        double minLatency = 0.0;    ///< 0 until a sample is recorded
+        double p95Latency = 0.0;    ///< Within 1/8 of the true value, from the histogram
+        double p99Latency = 0.0;
+        int sampleCount = 0;
+        qint64 totalMemoryUsage = 0;
+        double memoryGrowthRate = 0.0;
         QDateTime lastUpdated;
     };
 
@@ -100,8 +111,17 @@ public:
      */
     void recordMemoryUsage(qint64 bytes, const QString& component = QString());
 
+    /**
+     * @brief Record a latency measured elsewhere; lock-free, any thread
+     * @param type The metric type the latency belongs to
+     * @param latencyMs Latency in milliseconds
+     */
+    void recordLatency(MetricType type, double latencyMs);
+
     /**
      * @brief Get performance statistics for a metric type
+     *
+     * The quantiles are read from the histogram on each call.
      * @param type The metric type to get stats for
      * @return Performance statistics
      */
@@ -171,6 +191,9 @@ signals:
 
     /**
      * @brief Emitted when performance statistics are updated
+     *
+     * Latency metrics report at most once per periodic check, when they
+     * recorded samples since the last one.
      * @param type The metric type that was updated
      * @param stats Updated statistics
      */
@@ -184,45 +207,38 @@ signals:
 
 private slots:
     void performPeriodicCheck();
-    void cleanupOldMeasurements();
 
 private:
-    /**
-     * @brief Structure for tracking individual measurements
-     */
-    struct Measurement {
-        QElapsedTimer timer;
-        QString operationId;
-        QDateTime startTime;
-        bool active;
-    };
+    static constexpr int METRIC_COUNT = WidgetEnhancementTime + 1;
 
     /**
-     * @brief Structure for storing metric data
+     * @brief Latency metric; updated with relaxed atomics only
      */
     struct MetricData {
-        QQueue<double> samples;
-        PerformanceStats stats;
-        bool enabled;
-        QHash<QString, Measurement> activeMeasurements;
+        MetricsRegistry::Histogram histogram;   ///< Microseconds
+        std::atomic<qint64> minUs{-1};          ///< -1 until the first sample
+        std::atomic<qint64> lastUpdatedMs{0};   ///< Epoch milliseconds of the last sample
+        std::atomic<bool> enabled{true};
+        qint64 reportedCount = 0;               ///< Samples at the last statsUpdated(), GUI thread
     };
 
     // Helper methods
-    void updateStats(MetricType type, double value);
+    void recordSample(MetricType type, double valueMs);
     void checkPerformanceThresholds(MetricType type, double value);
     AlertLevel calculateAlertLevel(MetricType type, const PerformanceStats& stats) const;
     void applyOptimizations(const QStringList& optimizations);
     double getThreshold(MetricType type, const QString& thresholdType) const;
     void initializeThresholds();
-    void recordSample(MetricType type, double value);
-    void pruneOldSamples(MetricType type);
+    void dropAbandonedMeasurements(QHash<QString, QElapsedTimer>& measurements);
+    static QString measurementId(const QString& operationId);
 
     // Member variables
-    QHash<MetricType, MetricData> m_metrics;
+    std::array<MetricData, METRIC_COUNT> m_metrics;
+    std::array<QHash<QString, QElapsedTimer>, METRIC_COUNT> m_activeMeasurements;
     QHash<QString, qint64> m_memoryUsageByComponent;
+    PerformanceStats m_memoryStats;
     QTimer* m_periodicTimer;
-    QTimer* m_cleanupTimer;
-    mutable QMutex m_dataMutex;
+    mutable QMutex m_dataMutex;   ///< Guards measurements and memory usage, not the histograms
     
     bool m_autoOptimizationEnabled;
     AlertLevel m_currentAlertLevel;
@@ -232,10 +248,9 @@ private:
     QHash<MetricType, QHash<QString, double>> m_thresholds;
     
     // Configuration
-    static const int MAX_SAMPLES = 1000;
     static const int PERIODIC_CHECK_INTERVAL = 5000; // 5 seconds
-    static const int CLEANUP_INTERVAL = 60000; // 1 minute
-    static const int SAMPLE_RETENTION_HOURS = 24;
+    static const int MAX_ACTIVE_MEASUREMENTS = 256;  // Beyond this, abandoned ones are dropped
+    static const int ABANDONED_MEASUREMENT_MS = 60000; // 1 minute
 };
 
 Q_DECLARE_METATYPE(AccessibilityPerformanceMonitor::MetricType)
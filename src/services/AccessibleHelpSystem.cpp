@@ -1,5 +1,6 @@
 #include "AccessibleHelpSystem.h"
 #include "AccessibilityManager.h"
+#include "HelpCorpus.h"
 #include "KeyboardNavigationController.h"
 #include <QApplication>
 #include <QDesktopWidget>
@@ -15,6 +16,53 @@
 #include <QTimer>
 #include <QDebug>
 
+namespace {
+
+AccessibleHelpSystem::HelpCategory toCategory(int category)
+{
+    if (category < 0 || category >= HelpCorpus::categoryNames().size()) {
+        return AccessibleHelpSystem::HelpCategory::GettingStarted;
+    }
+    return static_cast<AccessibleHelpSystem::HelpCategory>(category);
+}
+
+AccessibleHelpSystem::HelpContent toHelpContent(const HelpCorpus::Topic& topic)
+{
+    AccessibleHelpSystem::HelpContent content;
+    content.id = topic.id;
+    content.title = topic.title;
+    content.content = topic.content;
+    content.category = toCategory(topic.category);
+    content.keywords = topic.keywords;
+    content.relatedTopics = topic.relatedTopics;
+    content.contextWidget = topic.contextWidget;
+    content.priority = topic.priority;
+    return content;
+}
+
+AccessibleHelpSystem::GuidedTutorial toGuidedTutorial(const HelpCorpus::Tutorial& source)
+{
+    AccessibleHelpSystem::GuidedTutorial tutorial;
+    tutorial.id = source.id;
+    tutorial.title = source.title;
+    tutorial.description = source.description;
+    tutorial.category = toCategory(source.category);
+    tutorial.prerequisite = source.prerequisite;
+    for (const HelpCorpus::TutorialStep& sourceStep : source.steps) {
+        AccessibleHelpSystem::TutorialStep step;
+        step.title = sourceStep.title;
+        step.instruction = sourceStep.instruction;
+        step.audioDescription = sourceStep.audioDescription;
+        step.targetWidget = sourceStep.targetWidget;
+        step.keySequence = QKeySequence::fromString(sourceStep.keys, QKeySequence::PortableText);
+        step.waitForUserAction = sourceStep.waitForUserAction;
+        tutorial.steps.append(step);
+    }
+    return tutorial;
+}
+
+} // namespace
+
 AccessibleHelpSystem::AccessibleHelpSystem(AccessibilityManager* accessibilityManager, QObject* parent)
     : QObject(parent)
     , m_accessibilityManager(accessibilityManager)
@@ -37,6 +85,7 @@ AccessibleHelpSystem::AccessibleHelpSystem(AccessibilityManager* accessibilityMa
     , m_tutorialActive(false)
     , m_initialized(false)
     , m_helpWindowVisible(false)
+    , m_shortcutsLoaded(false)
 {
     if (m_accessibilityManager) {
         m_keyboardController = m_accessibilityManager->keyboardNavigationController();
@@ -56,14 +105,8 @@ bool AccessibleHelpSystem::initialize()
 
     qDebug() << "AccessibleHelpSystem: Initializing accessible help system";
 
-    // Load default help content
-    loadDefaultHelpContent();
-    
-    // Load keyboard shortcut documentation
-    loadKeyboardShortcutDocumentation();
-    
-    // Load guided tutorials
-    loadGuidedTutorials();
+    // The texts, tutorials and search index stay in the built-in HelpCorpus,
+    // which is not even mapped until help is first asked for
     
     // Register global help shortcut
     if (m_keyboardController) {
@@ -135,12 +178,12 @@ void AccessibleHelpSystem::shutdown()
     // Clear all data
     m_helpContent.clear();
     m_contentByCategory.clear();
-    m_searchIndex.clear();
     m_shortcutDocs.clear();
     m_shortcutsByCategory.clear();
     m_tutorials.clear();
     m_tutorialsByCategory.clear();
     m_contextHelpMapping.clear();
+    m_shortcutsLoaded = false;
     
     m_initialized = false;
 }
@@ -152,6 +195,11 @@ void AccessibleHelpSystem::showHelpWindow(HelpCategory category)
         return;
     }
 
+    if (!m_shortcutsLoaded) {
+        loadKeyboardShortcutDocumentation();
+        m_shortcutsLoaded = true;
+    }
+
     if (!m_helpWindow) {
         createHelpWindow();
         setupHelpWindowAccessibility();
@@ -234,23 +282,25 @@ void AccessibleHelpSystem::showKeyboardShortcuts(HelpCategory category)
     
     // Find and display keyboard shortcuts content
     QString shortcutsContentId = "keyboard_shortcuts_reference";
-    if (m_helpContent.contains(shortcutsContentId)) {
+    if (!getHelpContent(shortcutsContentId).id.isEmpty()) {
         displayHelpContent(shortcutsContentId);
     }
 }
 
 QStringList AccessibleHelpSystem::searchHelpContent(const QString& query)
 {
-    QStringList results;
-    
     if (query.trimmed().isEmpty()) {
-        return results;
+        return QStringList();
     }
 
+    // The built-in topics through their prebuilt index, best first
+    QStringList results = HelpCorpus::builtIn().search(query);
+    const qsizetype builtInResults = results.size();
+
     QString lowerQuery = query.toLower();
     QStringList queryWords = lowerQuery.split(' ', Qt::SkipEmptyParts);
 
-    // Search through all help content
+    // Then the few topics registered at runtime, searched the slow way
     for (auto it = m_helpContent.constBegin(); it != m_helpContent.constEnd(); ++it) {
         const HelpContent& content = it.value();
         bool matches = false;
@@ -294,13 +344,14 @@ QStringList AccessibleHelpSystem::searchHelpContent(const QString& query)
             }
         }
         
-        if (matches) {
+        if (matches && !results.contains(it.key())) {
             results.append(it.key());
         }
     }
     
-    // Sort results by priority
-    std::sort(results.begin(), results.end(), [this](const QString& a, const QString& b) {
+    // Sort registered results by priority
+    std::sort(results.begin() + builtInResults, results.end(),
+              [this](const QString& a, const QString& b) {
         return m_helpContent[a].priority > m_helpContent[b].priority;
     });
 
@@ -309,7 +360,13 @@ QStringList AccessibleHelpSystem::searchHelpContent(const QString& query)
 
 AccessibleHelpSystem::HelpContent AccessibleHelpSystem::getHelpContent(const QString& contentId) const
 {
-    return m_helpContent.value(contentId, HelpContent());
+    // Registered content replaces a built-in topic of the same id
+    const auto registered = m_helpContent.constFind(contentId);
+    if (registered != m_helpContent.constEnd()) {
+        return registered.value();
+    }
+    const HelpCorpus::Topic topic = HelpCorpus::builtIn().topic(contentId);
+    return topic.id.isEmpty() ? HelpContent() : toHelpContent(topic);
 }
 
 void AccessibleHelpSystem::registerHelpContent(const HelpContent& content)
@@ -326,17 +383,6 @@ void AccessibleHelpSystem::registerHelpContent(const HelpContent& content)
         m_contentByCategory[content.category].append(content.id);
     }
     
-    // Add to search index
-    QStringList searchTerms = content.keywords;
-    searchTerms.append(content.title.split(' ', Qt::SkipEmptyParts));
-    
-    for (const QString& term : searchTerms) {
-        QString lowerTerm = term.toLower();
-        if (!m_searchIndex[lowerTerm].contains(content.id)) {
-            m_searchIndex[lowerTerm].append(content.id);
-        }
-    }
-    
     // Add context mapping if specified
     if (!content.contextWidget.isEmpty()) {
         m_contextHelpMapping[content.contextWidget] = content.id;
@@ -376,8 +422,12 @@ void AccessibleHelpSystem::registerGuidedTutorial(const GuidedTutorial& tutorial
 bool AccessibleHelpSystem::startGuidedTutorial(const QString& tutorialId)
 {
     if (!m_tutorials.contains(tutorialId)) {
-        qWarning() << "AccessibleHelpSystem: Tutorial not found:" << tutorialId;
-        return false;
+        const HelpCorpus::Tutorial builtIn = HelpCorpus::builtIn().tutorial(tutorialId);
+        if (builtIn.id.isEmpty()) {
+            qWarning() << "AccessibleHelpSystem: Tutorial not found:" << tutorialId;
+            return false;
+        }
+        m_tutorials.insert(tutorialId, toGuidedTutorial(builtIn));
     }
 
     const GuidedTutorial& tutorial = m_tutorials[tutorialId];
@@ -420,7 +470,13 @@ bool AccessibleHelpSystem::startGuidedTutorial(const QString& tutorialId)
 
 QStringList AccessibleHelpSystem::getAvailableTutorials(HelpCategory category) const
 {
-    return m_tutorialsByCategory.value(category, QStringList());
+    QStringList tutorials = HelpCorpus::builtIn().tutorialIds(static_cast<int>(category));
+    for (const QString& id : m_tutorialsByCategory.value(category)) {
+        if (!tutorials.contains(id)) {
+            tutorials.append(id);
+        }
+    }
+    return tutorials;
 }
 
 bool AccessibleHelpSystem::hasContextHelp(QWidget* widget) const
@@ -577,26 +633,32 @@ QString AccessibleHelpSystem::findContextHelpForWidget(QWidget* widget) const
         return QString();
     }
 
+    // Registered mappings first, then those of the built-in topics
+    const auto lookup = [this](const QString& name) {
+        const QString registered = m_contextHelpMapping.value(name);
+        return registered.isEmpty() ? HelpCorpus::builtIn().contextTopic(name) : registered;
+    };
+
     // Check direct mapping by class name
-    QString className = widget->metaObject()->className();
-    if (m_contextHelpMapping.contains(className)) {
-        return m_contextHelpMapping[className];
+    QString contentId = lookup(widget->metaObject()->className());
+    if (!contentId.isEmpty()) {
+        return contentId;
     }
     
     // Check parent widgets
     QWidget* parent = widget->parentWidget();
     while (parent) {
-        QString parentClassName = parent->metaObject()->className();
-        if (m_contextHelpMapping.contains(parentClassName)) {
-            return m_contextHelpMapping[parentClassName];
+        contentId = lookup(parent->metaObject()->className());
+        if (!contentId.isEmpty()) {
+            return contentId;
         }
         parent = parent->parentWidget();
     }
     
     // Check by object name
     QString objectName = widget->objectName();
-    if (!objectName.isEmpty() && m_contextHelpMapping.contains(objectName)) {
-        return m_contextHelpMapping[objectName];
+    if (!objectName.isEmpty()) {
+        return lookup(objectName);
     }
     
     return QString();
@@ -746,205 +808,6 @@ void AccessibleHelpSystem::setupHelpWindowAccessibility()
     }
 }
 
-void AccessibleHelpSystem::loadDefaultHelpContent()
-{
-    // Getting Started content
-    HelpContent gettingStarted;
-    gettingStarted.id = "getting_started_overview";
-    gettingStarted.title = "Getting Started with XFB";
-    gettingStarted.category = HelpCategory::GettingStarted;
-    gettingStarted.priority = 100;
-    gettingStarted.keywords = {"introduction", "overview", "basics", "start", "begin"};
-    gettingStarted.content = R"(
-        <h1>Welcome to XFB Radio Broadcasting Software</h1>
-        <p>XFB is a professional radio automation software designed with full accessibility support for visually impaired broadcasters.</p>
-        
-        <h2>Key Features</h2>
-        <ul>
-            <li>Complete keyboard navigation support</li>
-            <li>ORCA screen reader integration</li>
-            <li>Audio feedback for all operations</li>
-            <li>Accessible database management</li>
-            <li>Professional broadcasting tools</li>
-        </ul>
-        
-        <h2>Getting Help</h2>
-        <p>Press <strong>F1</strong> at any time to open this help system.</p>
-        <p>Press <strong>Shift+F1</strong> for context-sensitive help on the current control.</p>
-        
-        <h2>First Steps</h2>
-        <ol>
-            <li>Configure your accessibility preferences</li>
-            <li>Set up your music library</li>
-            <li>Learn the keyboard shortcuts</li>
-            <li>Try the guided tutorials</li>
-        </ol>
-    )";
-    registerHelpContent(gettingStarted);
-
-    // Player Controls content
-    HelpContent playerControls;
-    playerControls.id = "player_controls_overview";
-    playerControls.title = "Player Controls";
-    playerControls.category = HelpCategory::PlayerControls;
-    playerControls.priority = 90;
-    playerControls.keywords = {"player", "playback", "controls", "play", "pause", "stop"};
-    playerControls.contextWidget = "player";
-    playerControls.content = R"(
-        <h1>Player Controls</h1>
-        <p>The XFB player provides full keyboard control for all playback operations.</p>
-        
-        <h2>Basic Playback Controls</h2>
-        <ul>
-            <li><strong>Space</strong> - Play/Pause toggle</li>
-            <li><strong>Ctrl+S</strong> - Stop playback</li>
-            <li><strong>Ctrl+Right</strong> - Next track</li>
-            <li><strong>Ctrl+Left</strong> - Previous track</li>
-        </ul>
-        
-        <h2>Volume and Seeking</h2>
-        <ul>
-            <li><strong>Ctrl+Up</strong> - Increase volume</li>
-            <li><strong>Ctrl+Down</strong> - Decrease volume</li>
-            <li><strong>Shift+Right</strong> - Seek forward 10 seconds</li>
-            <li><strong>Shift+Left</strong> - Seek backward 10 seconds</li>
-        </ul>
-        
-        <h2>Audio Feedback</h2>
-        <p>All player operations provide immediate audio feedback through ORCA announcements.</p>
-        <p>Press <strong>Ctrl+T</strong> to hear the current playback time without interrupting other announcements.</p>
-    )";
-    registerHelpContent(playerControls);
-
-    // Database Management content
-    HelpContent databaseManagement;
-    databaseManagement.id = "database_management_overview";
-    databaseManagement.title = "Database Management";
-    databaseManagement.category = HelpCategory::DatabaseManagement;
-    databaseManagement.priority = 85;
-    databaseManagement.keywords = {"database", "library", "music", "tracks", "management"};
-    databaseManagement.contextWidget = "QTableView";
-    databaseManagement.content = R"(
-        <h1>Database Management</h1>
-        <p>XFB provides accessible tools for managing your music library and database.</p>
-        
-        <h2>Grid Navigation</h2>
-        <ul>
-            <li><strong>Arrow keys</strong> - Navigate between cells</li>
-            <li><strong>Home/End</strong> - Move to first/last column</li>
-            <li><strong>Ctrl+Home/End</strong> - Move to first/last row</li>
-            <li><strong>Page Up/Down</strong> - Navigate by pages</li>
-        </ul>
-        
-        <h2>Editing Operations</h2>
-        <ul>
-            <li><strong>F2</strong> - Enter edit mode for current cell</li>
-            <li><strong>Enter</strong> - Save changes and move to next row</li>
-            <li><strong>Escape</strong> - Cancel editing</li>
-            <li><strong>Tab</strong> - Move to next editable cell</li>
-        </ul>
-        
-        <h2>Selection and Operations</h2>
-        <ul>
-            <li><strong>Ctrl+A</strong> - Select all items</li>
-            <li><strong>Ctrl+C</strong> - Copy selected items</li>
-            <li><strong>Ctrl+X</strong> - Cut selected items</li>
-            <li><strong>Ctrl+V</strong> - Paste items</li>
-            <li><strong>Delete</strong> - Remove selected items</li>
-        </ul>
-    )";
-    registerHelpContent(databaseManagement);
-
-    // Keyboard Shortcuts Reference
-    HelpContent keyboardShortcuts;
-    keyboardShortcuts.id = "keyboard_shortcuts_reference";
-    keyboardShortcuts.title = "Keyboard Shortcuts Reference";
-    keyboardShortcuts.category = HelpCategory::KeyboardShortcuts;
-    keyboardShortcuts.priority = 95;
-    keyboardShortcuts.keywords = {"shortcuts", "keyboard", "keys", "hotkeys", "commands"};
-    keyboardShortcuts.content = R"(
-        <h1>Keyboard Shortcuts Reference</h1>
-        <p>Complete reference of all keyboard shortcuts available in XFB.</p>
-        
-        <h2>Global Shortcuts</h2>
-        <ul>
-            <li><strong>F1</strong> - Show help</li>
-            <li><strong>Shift+F1</strong> - Context-sensitive help</li>
-            <li><strong>Ctrl+Q</strong> - Quit application</li>
-            <li><strong>Ctrl+,</strong> - Open preferences</li>
-        </ul>
-        
-        <h2>Player Shortcuts</h2>
-        <ul>
-            <li><strong>Space</strong> - Play/Pause</li>
-            <li><strong>Ctrl+S</strong> - Stop</li>
-            <li><strong>Ctrl+T</strong> - Announce current time</li>
-            <li><strong>Ctrl+Right/Left</strong> - Next/Previous track</li>
-            <li><strong>Ctrl+Up/Down</strong> - Volume up/down</li>
-        </ul>
-        
-        <h2>Database Shortcuts</h2>
-        <ul>
-            <li><strong>Ctrl+F</strong> - Find/Search</li>
-            <li><strong>F3</strong> - Find next</li>
-            <li><strong>F5</strong> - Refresh</li>
-            <li><strong>Ctrl+N</strong> - New item</li>
-            <li><strong>F2</strong> - Edit current item</li>
-        </ul>
-        
-        <p><em>Note: All shortcuts can be customized in the accessibility preferences.</em></p>
-    )";
-    registerHelpContent(keyboardShortcuts);
-
-    // Accessibility Features
-    HelpContent accessibilityFeatures;
-    accessibilityFeatures.id = "accessibility_features_overview";
-    accessibilityFeatures.title = "Accessibility Features";
-    accessibilityFeatures.category = HelpCategory::Accessibility;
-    accessibilityFeatures.priority = 88;
-    accessibilityFeatures.keywords = {"accessibility", "orca", "screen reader", "braille", "settings"};
-    accessibilityFeatures.contextWidget = "AccessibilityPreferencesDialog";
-    accessibilityFeatures.content = R"(
-        <h1>Accessibility Features</h1>
-        <p>XFB provides comprehensive accessibility support for visually impaired users.</p>
-        
-        <h2>Screen Reader Support</h2>
-        <ul>
-            <li>Full ORCA integration with AT-SPI</li>
-            <li>Proper accessible names and descriptions</li>
-            <li>Live region announcements for dynamic content</li>
-            <li>Context-sensitive help and navigation hints</li>
-        </ul>
-        
-        <h2>Audio Feedback</h2>
-        <ul>
-            <li>Immediate confirmation for all user actions</li>
-            <li>Customizable verbosity levels (Terse, Normal, Verbose)</li>
-            <li>Priority-based announcement queuing</li>
-            <li>Background operation progress announcements</li>
-        </ul>
-        
-        <h2>Keyboard Navigation</h2>
-        <ul>
-            <li>Logical tab order following visual flow</li>
-            <li>Arrow key navigation in grids and lists</li>
-            <li>Customizable keyboard shortcuts</li>
-            <li>Focus management with clear announcements</li>
-        </ul>
-        
-        <h2>Braille Support</h2>
-        <ul>
-            <li>Braille display integration</li>
-            <li>Customizable braille formatting</li>
-            <li>Optimized braille output for efficiency</li>
-        </ul>
-        
-        <h2>Customization</h2>
-        <p>Access accessibility preferences through the main menu or press <strong>Ctrl+Alt+A</strong>.</p>
-    )";
-    registerHelpContent(accessibilityFeatures);
-}
-
 void AccessibleHelpSystem::loadKeyboardShortcutDocumentation()
 {
     if (!m_keyboardController) {
@@ -988,75 +851,6 @@ void AccessibleHelpSystem::loadKeyboardShortcutDocumentation()
     }
 }
 
-void AccessibleHelpSystem::loadGuidedTutorials()
-{
-    // Basic Navigation Tutorial
-    GuidedTutorial basicNavigation;
-    basicNavigation.id = "basic_navigation_tutorial";
-    basicNavigation.title = "Basic Navigation Tutorial";
-    basicNavigation.description = "Learn the fundamentals of navigating XFB with keyboard and screen reader.";
-    basicNavigation.category = HelpCategory::GettingStarted;
-    
-    TutorialStep step1;
-    step1.title = "Welcome to XFB";
-    step1.instruction = "Welcome to the XFB basic navigation tutorial. This tutorial will teach you how to navigate the interface using keyboard and screen reader.";
-    step1.audioDescription = "Tutorial started. You will learn keyboard navigation basics.";
-    step1.waitForUserAction = false;
-    basicNavigation.steps.append(step1);
-    
-    TutorialStep step2;
-    step2.title = "Tab Navigation";
-    step2.instruction = "Press Tab to move between controls. Press Shift+Tab to move backwards. Try navigating through the main interface now.";
-    step2.audioDescription = "Practice using Tab and Shift+Tab to navigate between controls.";
-    step2.keySequence = QKeySequence(Qt::Key_Tab);
-    step2.waitForUserAction = true;
-    basicNavigation.steps.append(step2);
-    
-    TutorialStep step3;
-    step3.title = "Getting Help";
-    step3.instruction = "Press F1 at any time to open help. Press Shift+F1 for context-sensitive help on the current control.";
-    step3.audioDescription = "Remember: F1 for general help, Shift+F1 for context help.";
-    step3.keySequence = QKeySequence(Qt::Key_F1);
-    step3.waitForUserAction = false;
-    basicNavigation.steps.append(step3);
-    
-    registerGuidedTutorial(basicNavigation);
-
-    // Player Controls Tutorial
-    GuidedTutorial playerTutorial;
-    playerTutorial.id = "player_controls_tutorial";
-    playerTutorial.title = "Player Controls Tutorial";
-    playerTutorial.description = "Learn how to control audio playback using keyboard shortcuts.";
-    playerTutorial.category = HelpCategory::PlayerControls;
-    playerTutorial.prerequisite = "basic_navigation_tutorial";
-    
-    TutorialStep playerStep1;
-    playerStep1.title = "Basic Playback";
-    playerStep1.instruction = "Press Space to play or pause audio. The player will announce the current state.";
-    playerStep1.audioDescription = "Space bar controls play and pause. Listen for the announcement.";
-    playerStep1.keySequence = QKeySequence(Qt::Key_Space);
-    playerStep1.waitForUserAction = true;
-    playerTutorial.steps.append(playerStep1);
-    
-    TutorialStep playerStep2;
-    playerStep2.title = "Volume Control";
-    playerStep2.instruction = "Use Ctrl+Up and Ctrl+Down to adjust volume. Try changing the volume now.";
-    playerStep2.audioDescription = "Control volume with Ctrl+Up and Ctrl+Down arrow keys.";
-    playerStep2.keySequence = QKeySequence(Qt::CTRL | Qt::Key_Up);
-    playerStep2.waitForUserAction = true;
-    playerTutorial.steps.append(playerStep2);
-    
-    TutorialStep playerStep3;
-    playerStep3.title = "Track Navigation";
-    playerStep3.instruction = "Use Ctrl+Right and Ctrl+Left to skip between tracks in your playlist.";
-    playerStep3.audioDescription = "Navigate tracks with Ctrl+Right and Ctrl+Left arrow keys.";
-    playerStep3.keySequence = QKeySequence(Qt::CTRL | Qt::Key_Right);
-    playerStep3.waitForUserAction = false;
-    playerTutorial.steps.append(playerStep3);
-    
-    registerGuidedTutorial(playerTutorial);
-}
-
 void AccessibleHelpSystem::createHelpContentTree()
 {
     if (!m_contentTree) {
@@ -1065,12 +859,17 @@ void AccessibleHelpSystem::createHelpContentTree()
 
     m_contentTree->clear();
 
-    // Create category items
+    // Create category items, in the order of the categories
     QHash<HelpCategory, QTreeWidgetItem*> categoryItems;
     
-    for (auto it = m_contentByCategory.constBegin(); it != m_contentByCategory.constEnd(); ++it) {
-        HelpCategory category = it.key();
-        const QStringList& contentIds = it.value();
+    for (int index = 0; index < HelpCorpus::categoryNames().size(); ++index) {
+        HelpCategory category = static_cast<HelpCategory>(index);
+        QStringList contentIds = HelpCorpus::builtIn().topicsInCategory(index);
+        for (const QString& id : m_contentByCategory.value(category)) {
+            if (!contentIds.contains(id)) {
+                contentIds.append(id);
+            }
+        }
         
         if (contentIds.isEmpty()) {
             continue;
@@ -1083,7 +882,7 @@ void AccessibleHelpSystem::createHelpContentTree()
         
         // Add content items
         for (const QString& contentId : contentIds) {
-            const HelpContent& content = m_helpContent[contentId];
+            const HelpContent content = getHelpContent(contentId);
             
             QTreeWidgetItem* contentItem = new QTreeWidgetItem(categoryItem);
             contentItem->setText(0, content.title);
@@ -1120,7 +919,7 @@ void AccessibleHelpSystem::updateSearchResults(const QStringList& results)
     resultsItem->setExpanded(true);
     
     for (const QString& contentId : results) {
-        const HelpContent& content = m_helpContent[contentId];
+        const HelpContent content = getHelpContent(contentId);
         
         QTreeWidgetItem* resultItem = new QTreeWidgetItem(resultsItem);
         resultItem->setText(0, content.title);
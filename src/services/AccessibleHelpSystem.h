@@ -287,20 +287,10 @@ private:
     void setupHelpWindowAccessibility();
 
     /**
-     * @brief Load default help content
-     */
-    void loadDefaultHelpContent();
-
-    /**
-     * @brief Load keyboard shortcut documentation
+     * @brief Load keyboard shortcut documentation; done when the help window first opens
      */
     void loadKeyboardShortcutDocumentation();
 
-    /**
-     * @brief Load guided tutorials
-     */
-    void loadGuidedTutorials();
-
     /**
      * @brief Create help content tree
      */
@@ -366,16 +356,15 @@ private:
     AccessibilityManager* m_accessibilityManager;
     KeyboardNavigationController* m_keyboardController;
     
-    // Help content management
+    // Help content registered at runtime; the built-in topics stay in HelpCorpus
     QHash<QString, HelpContent> m_helpContent;
     QHash<HelpCategory, QStringList> m_contentByCategory;
-    QHash<QString, QStringList> m_searchIndex;
     
     // Shortcut documentation
     QHash<QString, ShortcutDocumentation> m_shortcutDocs;
     QHash<HelpCategory, QStringList> m_shortcutsByCategory;
     
-    // Guided tutorials
+    // Guided tutorials, registered or read from HelpCorpus once started
     QHash<QString, GuidedTutorial> m_tutorials;
     QHash<HelpCategory, QStringList> m_tutorialsByCategory;
     
@@ -408,6 +397,7 @@ private:
     // State tracking
     bool m_initialized;
     bool m_helpWindowVisible;
+    bool m_shortcutsLoaded;
     QString m_currentContentId;
     
     // Configuration constants
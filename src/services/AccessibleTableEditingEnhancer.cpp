@@ -1,6 +1,7 @@
 #include "AccessibleTableEditingEnhancer.h"
 #include "AccessibilityManager.h"
 #include "AccessibleTableInterface.h"
+#include "KeyDispatcher.h"
 #include <QApplication>
 #include <QAbstractItemModel>
 #include <QItemSelectionModel>
@@ -39,9 +40,6 @@ bool AccessibleTableEditingEnhancer::initialize()
         return false;
     }
     
-    // Install event filter for keyboard handling
-    m_tableView->installEventFilter(this);
-    
     // Connect to table signals
     connectTableSignals();
     
@@ -54,8 +52,9 @@ bool AccessibleTableEditingEnhancer::initialize()
 
 void AccessibleTableEditingEnhancer::shutdown()
 {
+    KeyDispatcher::instance()->removeAll(this);
     if (m_tableView) {
-        m_tableView->removeEventFilter(this);
+        KeyDispatcher::instance()->setFocusContext(m_tableView, QString());
         disconnectTableSignals();
     }
     
@@ -170,20 +169,6 @@ bool AccessibleTableEditingEnhancer::cancelEditMode()
     return true;
 }
 
-bool AccessibleTableEditingEnhancer::eventFilter(QObject* obj, QEvent* event)
-{
-    if (obj != m_tableView || !m_editingEnabled) {
-        return false;
-    }
-    
-    if (event->type() == QEvent::KeyPress) {
-        QKeyEvent* keyEvent = static_cast<QKeyEvent*>(event);
-        return handleEditingKeyboard(keyEvent);
-    }
-    
-    return false;
-}
-
 void AccessibleTableEditingEnhancer::onSelectionChanged(const QModelIndex& current, const QModelIndex& previous)
 {
     Q_UNUSED(previous)
@@ -399,8 +384,16 @@ bool AccessibleTableEditingEnhancer::isCellEditable(const QModelIndex& index) co
 
 void AccessibleTableEditingEnhancer::setupKeyboardShortcuts()
 {
-    // Keyboard shortcuts are handled in the event filter
-    // This method is for future expansion if needed
+    // Every key pressed on the table itself; handleEditingKeyboard() picks the ones it wants
+    KeyDispatcher* keys = KeyDispatcher::instance();
+    keys->setFocusContext(m_tableView, FOCUS_CONTEXT);
+    keys->add(KeyDispatcher::ANY_KEY, Qt::NoModifier, FOCUS_CONTEXT, this,
+              [this](QWidget* target, QKeyEvent* event) {
+        if (target != m_tableView || !m_editingEnabled) {
+            return false;
+        }
+        return handleEditingKeyboard(event);
+    });
     qDebug() << "Keyboard shortcuts for table editing configured";
 }
 
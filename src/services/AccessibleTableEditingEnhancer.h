@@ -74,15 +74,6 @@ public:
      */
     bool cancelEditMode();
 
-protected:
-    /**
-     * @brief Event filter for handling keyboard shortcuts and edit events
-     * @param obj The object that received the event
-     * @param event The event
-     * @return true if the event was handled
-     */
-    bool eventFilter(QObject* obj, QEvent* event) override;
-
 private slots:
     /**
      * @brief Handle selection changes in the table
@@ -155,7 +146,7 @@ private:
     bool isCellEditable(const QModelIndex& index) const;
 
     /**
-     * @brief Setup keyboard shortcuts for editing
+     * @brief Bind the editing keys of the table in KeyDispatcher
      */
     void setupKeyboardShortcuts();
 
@@ -189,6 +180,7 @@ private:
     
     // Configuration
     static constexpr int ANNOUNCEMENT_DELAY_MS = 150;
+    static constexpr const char* FOCUS_CONTEXT = "TableEditing";
 };
 
 #endif // ACCESSIBLETABLEEDITINGENHANCER_H
\ No newline at end of file
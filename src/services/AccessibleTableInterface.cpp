@@ -1,10 +1,12 @@
 #include "AccessibleTableInterface.h"
+#include "AccessibilityEventBatcher.h"
 #include "AccessibilityManager.h"
 #include <QApplication>
 #include <QHeaderView>
 #include <QAbstractItemModel>
 #include <QItemSelectionModel>
 #include <QDebug>
+#include <QTimer>
 
 AccessibleTableInterface::AccessibleTableInterface(QTableView* tableView, AccessibilityManager* manager)
     : m_tableView(tableView)
@@ -15,9 +17,7 @@ AccessibleTableInterface::AccessibleTableInterface(QTableView* tableView, Access
 
 AccessibleTableInterface::~AccessibleTableInterface()
 {
-    // Clean up cell interfaces
-    qDeleteAll(m_cellInterfaces);
-    m_cellInterfaces.clear();
+    clearCellCache();
 }
 
 bool AccessibleTableInterface::isValid() const
@@ -74,8 +74,8 @@ int AccessibleTableInterface::indexOfChild(const QAccessibleInterface* child) co
         return -1;
     }
 
-    const AccessibleTableCellInterface* cellInterface = 
-        qobject_cast<const AccessibleTableCellInterface*>(child);
+    const AccessibleTableCellInterface* cellInterface =
+        dynamic_cast<const AccessibleTableCellInterface*>(child);
     
     if (!cellInterface) {
         return -1;
@@ -225,14 +225,25 @@ QAccessibleInterface* AccessibleTableInterface::cellAt(int row, int column) cons
         return nullptr;
     }
 
-    const QPair<int, int> cellKey(row, column);
-    
-    if (!m_cellInterfaces.contains(cellKey)) {
-        m_cellInterfaces[cellKey] = new AccessibleTableCellInterface(
-            m_tableView, row, column, const_cast<AccessibleTableInterface*>(this));
+    const CellKey cellKey(row, column);
+    auto cached = m_cellInterfaces.find(cellKey);
+    if (cached != m_cellInterfaces.end()) {
+        m_cellUse.splice(m_cellUse.begin(), m_cellUse, cached->use);
+        return cached->cell;
     }
 
-    return m_cellInterfaces[cellKey];
+    CachedCell entry;
+    entry.cell = new AccessibleTableCellInterface(
+        m_tableView, row, column, const_cast<AccessibleTableInterface*>(this));
+    entry.id = QAccessible::registerAccessibleInterface(entry.cell);
+    m_cellUse.push_front(cellKey);
+    entry.use = m_cellUse.begin();
+    m_cellInterfaces.insert(cellKey, entry);
+
+    if (m_cellInterfaces.size() > MAX_CACHED_CELLS) {
+        scheduleCellCacheTrim();
+    }
+    return entry.cell;
 }
 
 QAccessibleInterface* AccessibleTableInterface::caption() const
@@ -485,33 +496,40 @@ void AccessibleTableInterface::modelChange(QAccessibleTableModelChangeEvent* eve
         return;
     }
 
-    // Clear cached cell interfaces when model changes
-    qDeleteAll(m_cellInterfaces);
-    m_cellInterfaces.clear();
+    // Rows and columns may have moved, so no cached cell can be trusted
+    clearCellCache();
+
+    // During a bulk change one summary follows when it is done
+    AccessibilityEventBatcher* batcher = AccessibilityEventBatcher::instance();
+    if (batcher->isBatchingView(m_tableView)) {
+        return;
+    }
 
     // Announce model changes if accessibility manager is available
     if (m_accessibilityManager) {
-        QString announcement;
+        QString announcement = batcher->summary(m_tableView);
         
-        switch (event->modelChangeType()) {
-        case QAccessibleTableModelChangeEvent::ModelReset:
-            announcement = "Table data refreshed";
-            break;
-        case QAccessibleTableModelChangeEvent::DataChanged:
-            announcement = "Table data updated";
-            break;
-        case QAccessibleTableModelChangeEvent::RowsInserted:
-            announcement = QString("%1 rows added to table").arg(event->lastRow() - event->firstRow() + 1);
-            break;
-        case QAccessibleTableModelChangeEvent::RowsRemoved:
-            announcement = QString("%1 rows removed from table").arg(event->lastRow() - event->firstRow() + 1);
-            break;
-        case QAccessibleTableModelChangeEvent::ColumnsInserted:
-            announcement = QString("%1 columns added to table").arg(event->lastColumn() - event->firstColumn() + 1);
-            break;
-        case QAccessibleTableModelChangeEvent::ColumnsRemoved:
-            announcement = QString("%1 columns removed from table").arg(event->lastColumn() - event->firstColumn() + 1);
-            break;
+        if (announcement.isEmpty()) {
+            switch (event->modelChangeType()) {
+            case QAccessibleTableModelChangeEvent::ModelReset:
+                announcement = "Table data refreshed";
+                break;
+            case QAccessibleTableModelChangeEvent::DataChanged:
+                announcement = "Table data updated";
+                break;
+            case QAccessibleTableModelChangeEvent::RowsInserted:
+                announcement = QString("%1 rows added to table").arg(event->lastRow() - event->firstRow() + 1);
+                break;
+            case QAccessibleTableModelChangeEvent::RowsRemoved:
+                announcement = QString("%1 rows removed from table").arg(event->lastRow() - event->firstRow() + 1);
+                break;
+            case QAccessibleTableModelChangeEvent::ColumnsInserted:
+                announcement = QString("%1 columns added to table").arg(event->lastColumn() - event->firstColumn() + 1);
+                break;
+            case QAccessibleTableModelChangeEvent::ColumnsRemoved:
+                announcement = QString("%1 columns removed from table").arg(event->lastColumn() - event->firstColumn() + 1);
+                break;
+            }
         }
         
         if (!announcement.isEmpty()) {
@@ -669,6 +687,71 @@ QString AccessibleTableInterface::getSelectionInfo() const
     }
 }
 
+void AccessibleTableInterface::trimCellCache() const
+{
+    int excess = int(m_cellInterfaces.size()) - MAX_CACHED_CELLS;
+    if (excess <= 0 || !m_tableView) {
+        return;
+    }
+
+    // Rows on screen, with a margin either side, stay
+    int firstKept = m_tableView->rowAt(0);
+    int lastKept = m_tableView->rowAt(m_tableView->viewport()->height() - 1);
+    if (firstKept < 0) {
+        firstKept = lastKept = -1;
+    } else {
+        if (lastKept < 0) {
+            lastKept = rowCount() - 1;
+        }
+        firstKept = qMax(0, firstKept - VIEWPORT_MARGIN_ROWS);
+        lastKept += VIEWPORT_MARGIN_ROWS;
+    }
+    const QItemSelectionModel* selection = m_tableView->selectionModel();
+    const QModelIndex current = selection ? selection->currentIndex() : QModelIndex();
+
+    auto it = m_cellUse.end();
+    while (excess > 0 && it != m_cellUse.begin()) {
+        --it;
+        const CellKey key = *it;
+        const bool kept = (key.first >= firstKept && key.first <= lastKept)
+                          || (current.isValid() && key.first == current.row()
+                              && key.second == current.column());
+        if (kept) {
+            continue;
+        }
+        const CachedCell entry = m_cellInterfaces.take(key);
+        it = m_cellUse.erase(it);
+        QAccessible::deleteAccessibleInterface(entry.id);
+        --excess;
+    }
+}
+
+void AccessibleTableInterface::scheduleCellCacheTrim() const
+{
+    if (m_trimScheduled || !m_tableView) {
+        return;
+    }
+    m_trimScheduled = true;
+    const std::weak_ptr<bool> alive = m_alive;
+    QTimer::singleShot(0, m_tableView, [this, alive]() {
+        if (alive.expired()) {
+            return;
+        }
+        m_trimScheduled = false;
+        trimCellCache();
+    });
+}
+
+void AccessibleTableInterface::clearCellCache()
+{
+    // Deleted through QAccessible, which drops the ids it handed out for them
+    for (const CachedCell& entry : std::as_const(m_cellInterfaces)) {
+        QAccessible::deleteAccessibleInterface(entry.id);
+    }
+    m_cellInterfaces.clear();
+    m_cellUse.clear();
+}
+
 // AccessibleTableCellInterface implementation
 
 AccessibleTableCellInterface::AccessibleTableCellInterface(QTableView* tableView, int row, int column, AccessibleTableInterface* parent)
@@ -8,8 +8,11 @@
 #include <QAbstractItemModel>
 #include <QModelIndex>
 #include <QHeaderView>
+#include <list>
+#include <memory>
 
 class AccessibilityManager;
+class AccessibleTableCellInterface;
 
 /**
  * @brief Custom accessible interface for QTableView widgets
@@ -24,6 +27,16 @@ class AccessibilityManager;
  * - Navigation state tracking
  * - Edit mode state announcements
  * - Selection state management
+ *
+ * Cell interfaces are made on demand and kept in a cache of at most
+ * MAX_CACHED_CELLS, so a screen reader walking every child of a large
+ * library table does not keep one object per cell alive. The least
+ * recently used cells go first, except those of the visible rows and of
+ * VIEWPORT_MARGIN_ROWS rows either side. Eviction runs from the event
+ * loop, so the cells a call hands out stay valid until it returns, even
+ * when one call makes many of them, as selectedCells() may. Cells are
+ * registered with QAccessible and removed through it, so the bridge to
+ * the screen reader forgets the ids of evicted cells.
  * 
  * @since XFB 2.0
  */
@@ -101,6 +114,14 @@ public:
      */
     void updateEditingState(bool editing, int row = -1, int column = -1);
 
+    /**
+     * @brief Number of cell interfaces held by the cache
+     */
+    int cachedCellCount() const { return int(m_cellInterfaces.size()); }
+
+    static constexpr int MAX_CACHED_CELLS = 2048;
+    static constexpr int VIEWPORT_MARGIN_ROWS = 50;
+
 private:
     /**
      * @brief Get formatted cell content with context
@@ -138,9 +159,35 @@ private:
      */
     QString getSelectionInfo() const;
 
+    /**
+     * @brief Evict least recently used cells until the cache is within its limit
+     */
+    void trimCellCache() const;
+
+    /**
+     * @brief Run trimCellCache() from the event loop, once for any number of calls
+     */
+    void scheduleCellCacheTrim() const;
+
+    /**
+     * @brief Remove every cached cell interface
+     */
+    void clearCellCache();
+
+    using CellKey = QPair<int, int>;   ///< Row and column
+
+    struct CachedCell {
+        AccessibleTableCellInterface* cell = nullptr;
+        QAccessible::Id id = 0;
+        std::list<CellKey>::iterator use;   ///< Position in m_cellUse
+    };
+
     QTableView* m_tableView;
     AccessibilityManager* m_accessibilityManager;
-    mutable QHash<QPair<int, int>, QAccessibleInterface*> m_cellInterfaces;
+    mutable QHash<CellKey, CachedCell> m_cellInterfaces;
+    mutable std::list<CellKey> m_cellUse;   ///< Most recently used first
+    mutable bool m_trimScheduled = false;
+    std::shared_ptr<bool> m_alive = std::make_shared<bool>(true);   ///< For the queued trim
 };
 
 /**
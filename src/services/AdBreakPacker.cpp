@@ -0,0 +1,299 @@
+#include "AdBreakPacker.h"
+#include <QDebug>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+// A step of air time is worth more than any number of plays, which only
+// decide between fills of the same length
+constexpr qint64 STEP_VALUE = 1000000;
+
+struct Candidate {
+    int spot = -1;
+    int steps = 0;
+    qint64 value = 0;
+};
+
+} // namespace
+
+AdBreakPacker::AdBreakPacker(QSqlDatabase& database, QObject* parent)
+    : QObject(parent)
+    , m_database(database)
+{
+}
+
+bool AdBreakPacker::reload()
+{
+    m_stale = false;
+    if (!ensureCustomerColumn()) {
+        return false;
+    }
+
+    QSqlQuery query(m_database);
+    query.setForwardOnly(true);
+    if (!query.exec("SELECT name, path, customer FROM pub")) {
+        const QString error = QString("SQL Error: %1").arg(query.lastError().text());
+        logError("reload", error, query.lastQuery());
+        emit operationError("reload", error);
+        return false;
+    }
+
+    // A spot that stays keeps its duration, so a reload probes only new files
+    QHash<QString, qint64> durations;
+    for (const Spot& spot : std::as_const(m_spots)) {
+        durations.insert(spot.path, spot.durationMs);
+    }
+
+    QVector<Spot> spots;
+    QHash<QString, int> index;
+    while (query.next()) {
+        Spot spot;
+        spot.path = query.value(1).toString();
+        if (spot.path.isEmpty() || index.contains(spot.path)) {
+            continue;
+        }
+        spot.customer = query.value(2).toString().trimmed();
+        if (spot.customer.isEmpty()) {
+            spot.customer = query.value(0).toString().trimmed();
+        }
+        if (spot.customer.isEmpty()) {
+            spot.customer = spot.path;
+        }
+        const auto known = durations.constFind(spot.path);
+        if (known != durations.cend() && *known >= 0) {
+            spot.durationMs = *known;
+        } else if (m_durationLookup) {
+            const qint64 durationUs = m_durationLookup(spot.path);
+            spot.durationMs = durationUs >= 0 ? durationUs / 1000 : -1;
+        }
+        index.insert(spot.path, spots.size());
+        spots.append(spot);
+    }
+
+    m_spots = std::move(spots);
+    m_index = std::move(index);
+    qDebug() << "AdBreakPacker: loaded" << m_spots.size() << "spots";
+    return true;
+}
+
+void AdBreakPacker::setSpots(const QVector<Spot>& spots)
+{
+    m_stale = false;
+    m_spots.clear();
+    m_index.clear();
+    for (const Spot& spot : spots) {
+        if (spot.path.isEmpty() || m_index.contains(spot.path)) {
+            continue;
+        }
+        m_index.insert(spot.path, m_spots.size());
+        m_spots.append(spot);
+        if (m_spots.last().customer.isEmpty()) {
+            m_spots.last().customer = spot.path;
+        }
+    }
+}
+
+QVector<AdBreakPacker::Spot> AdBreakPacker::spots()
+{
+    ensureLoaded();
+    return m_spots;
+}
+
+void AdBreakPacker::setCustomerSeparationMs(qint64 separationMs)
+{
+    m_separationMs = qMax<qint64>(0, separationMs);
+}
+
+void AdBreakPacker::setMaxDailyPlays(int plays)
+{
+    m_maxDailyPlays = qMax(0, plays);
+}
+
+QVector<AdBreakPacker::Break> AdBreakPacker::packDay(QVector<Slot> breaks)
+{
+    ensureLoaded();
+    std::stable_sort(breaks.begin(), breaks.end(),
+                     [](const Slot& a, const Slot& b) { return a.at < b.at; });
+
+    History history = m_aired;
+    QVector<Break> day;
+    day.reserve(breaks.size());
+    for (const Slot& slot : std::as_const(breaks)) {
+        day.append(packOne(slot, history));
+    }
+    return day;
+}
+
+void AdBreakPacker::markAired(const QDateTime& at, const QStringList& paths)
+{
+    ensureLoaded();
+    record(m_aired, at, paths);
+}
+
+void AdBreakPacker::ensureLoaded()
+{
+    if (m_stale) {
+        reload();
+    }
+}
+
+AdBreakPacker::Break AdBreakPacker::packOne(const Slot& slot, History& history) const
+{
+    Break result;
+    result.at = slot.at;
+    result.lengthMs = slot.lengthMs;
+    if (history.playsDate != slot.at.date()) {
+        history.plays.clear();
+        history.playsDate = slot.at.date();
+    }
+
+    qint64 freeMs = slot.lengthMs;
+    QString pinnedCustomer;
+    if (!slot.pinnedPath.isEmpty()) {
+        result.paths << slot.pinnedPath;
+        const int pinned = m_index.value(slot.pinnedPath, -1);
+        pinnedCustomer = pinned >= 0 ? m_spots[pinned].customer : slot.pinnedPath;
+        const qint64 pinnedMs = pinned >= 0 ? m_spots[pinned].durationMs : -1;
+        if (pinnedMs < 0) {
+            // Nothing can be fitted around a spot of unknown length
+            result.filledMs = -1;
+            record(history, slot.at, result.paths);
+            return result;
+        }
+        result.filledMs = pinnedMs;
+        freeMs -= pinnedMs;
+    }
+
+    // One group per customer, of the spots the rules let into this break
+    QHash<QString, int> groupOf;
+    QVector<QVector<Candidate>> groups;
+    for (int i = 0; i < m_spots.size(); ++i) {
+        const Spot& spot = m_spots[i];
+        if (spot.durationMs <= 0 || spot.durationMs > freeMs || spot.customer == pinnedCustomer) {
+            continue;
+        }
+        if (m_maxDailyPlays > 0 && history.plays.value(spot.path) >= m_maxDailyPlays) {
+            continue;
+        }
+        const auto aired = history.customerAiredAt.constFind(spot.customer);
+        if (aired != history.customerAiredAt.cend() && aired->msecsTo(slot.at) < m_separationMs) {
+            continue;
+        }
+        auto group = groupOf.constFind(spot.customer);
+        if (group == groupOf.cend()) {
+            group = groupOf.insert(spot.customer, groups.size());
+            groups.append(QVector<Candidate>());
+        }
+        Candidate candidate;
+        candidate.spot = i;
+        candidate.steps = int((spot.durationMs + PACK_STEP_MS - 1) / PACK_STEP_MS);
+        candidate.value = candidate.steps * STEP_VALUE - history.plays.value(spot.path);
+        groups[*group].append(candidate);
+    }
+
+    const int capacity = int(qMax<qint64>(0, freeMs) / PACK_STEP_MS);
+    if (groups.isEmpty() || capacity == 0) {
+        record(history, slot.at, result.paths);
+        return result;
+    }
+
+    // best[c] is the most a fill of at most c steps is worth, with at most
+    // one spot per group; walking c down keeps the groups before in best
+    const size_t width = size_t(capacity) + 1;
+    std::vector<qint64> best(width, 0);
+    std::vector<int> choice(size_t(groups.size()) * width, -1);
+    for (int g = 0; g < groups.size(); ++g) {
+        const QVector<Candidate>& group = groups[g];
+        int* taken = choice.data() + size_t(g) * width;
+        for (int c = capacity; c > 0; --c) {
+            for (int k = 0; k < group.size(); ++k) {
+                if (group[k].steps > c) {
+                    continue;
+                }
+                const qint64 value = best[size_t(c - group[k].steps)] + group[k].value;
+                if (value > best[size_t(c)]) {
+                    best[size_t(c)] = value;
+                    taken[c] = k;
+                }
+            }
+        }
+    }
+
+    QVector<int> chosen;
+    int c = capacity;
+    for (int g = groups.size() - 1; g >= 0 && c > 0; --g) {
+        const int k = choice[size_t(g) * width + size_t(c)];
+        if (k >= 0) {
+            chosen.prepend(groups[g][k].spot);
+            c -= groups[g][k].steps;
+        }
+    }
+    for (int i : std::as_const(chosen)) {
+        result.paths << m_spots[i].path;
+        result.filledMs += m_spots[i].durationMs;
+    }
+
+    record(history, slot.at, result.paths);
+    return result;
+}
+
+void AdBreakPacker::record(History& history, const QDateTime& at, const QStringList& paths) const
+{
+    if (history.playsDate != at.date()) {
+        history.plays.clear();
+        history.playsDate = at.date();
+    }
+    for (const QString& path : paths) {
+        const int row = m_index.value(path, -1);
+        history.customerAiredAt.insert(row >= 0 ? m_spots[row].customer : path, at);
+        ++history.plays[path];
+    }
+}
+
+bool AdBreakPacker::ensureCustomerColumn()
+{
+    QSqlQuery info(m_database);
+    if (!info.exec("PRAGMA table_info(pub)")) {
+        const QString error = QString("SQL Error: %1").arg(info.lastError().text());
+        logError("ensureCustomerColumn", error, info.lastQuery());
+        emit operationError("ensureCustomerColumn", error);
+        return false;
+    }
+
+    QStringList columns;
+    while (info.next()) {
+        columns << info.value(1).toString();
+    }
+    if (columns.isEmpty()) {
+        logError("ensureCustomerColumn", "The pub table does not exist");
+        emit operationError("ensureCustomerColumn", "The pub table does not exist");
+        return false;
+    }
+    if (columns.contains("customer")) {
+        return true;
+    }
+
+    QSqlQuery query(m_database);
+    const QString sql = "ALTER TABLE pub ADD COLUMN customer TEXT";
+    if (!query.exec(sql)) {
+        const QString error = QString("SQL Error: %1").arg(query.lastError().text());
+        logError("ensureCustomerColumn", error, sql);
+        emit operationError("ensureCustomerColumn", error);
+        return false;
+    }
+    qInfo() << "AdBreakPacker: added customer to the pub table";
+    return true;
+}
+
+void AdBreakPacker::logError(const QString& operation, const QString& error, const QString& query)
+{
+    QString logMessage = QString("AdBreakPacker::%1 - %2").arg(operation, error);
+    if (!query.isEmpty()) {
+        logMessage += QString(" (Query: %1)").arg(query);
+    }
+
+    qWarning() << logMessage;
+}
@@ -0,0 +1,157 @@
+#ifndef ADBREAKPACKER_H
+#define ADBREAKPACKER_H
+
+#include <QDateTime>
+#include <QHash>
+#include <QObject>
+#include <QSqlDatabase>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <functional>
+
+/**
+ * @brief Fills the ad breaks of a day from the pub table
+ *
+ * A scheduled pub used to air on its own, and whatever else the break was
+ * meant to hold had to be queued by hand. AdBreakPacker reads the pub
+ * table once and, for each break of a given length, picks the spots that
+ * fill it the most without running over. It is a knapsack bounded by the
+ * separation rules:
+ *
+ * - A customer airs at most once per break.
+ * - A customer is kept out of the breaks that start less than
+ *   customerSeparationMs() after one of its spots aired.
+ * - A spot airs at most maxDailyPlays() times a day, 0 for no limit.
+ *
+ * Among fills of the same length the spots that aired least are taken.
+ * The customer is the customer column of the pub table, added when it is
+ * missing; a pub without one is a customer of its own, under its name.
+ *
+ * The scheduled pub of a break is pinned: it always opens the break, even
+ * against the rules, and the others fill what it leaves. Lengths are
+ * packed in steps of PACK_STEP_MS, rounded up, so a whole day packs in a
+ * few milliseconds.
+ *
+ * markAired() tells which breaks were played, so the rules also hold
+ * across the days packed apart.
+ *
+ * @example
+ * @code
+ * AdBreakPacker packer(db);
+ * packer.setDurationLookup([cache](const QString& path) { return cache->durationUs(path); });
+ * const QVector<AdBreakPacker::Break> day = packer.packDay({{at, 120000, pubPath}});
+ * for (const QString& path : day.first().paths)
+ *     queue->append(path);
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class AdBreakPacker : public QObject
+{
+    Q_OBJECT
+
+public:
+    /// Resolution of the packing
+    static constexpr qint64 PACK_STEP_MS = 100;
+
+    struct Spot {
+        QString path;
+        QString customer;
+        qint64 durationMs = -1;   ///< -1 if unknown; such a spot is only aired when pinned
+    };
+
+    /**
+     * @brief A break to fill
+     */
+    struct Slot {
+        QDateTime at;
+        qint64 lengthMs = 0;
+        QString pinnedPath;       ///< Spot that opens the break, empty for none
+    };
+
+    struct Break {
+        QDateTime at;
+        qint64 lengthMs = 0;
+        qint64 filledMs = 0;      ///< Air time of the spots; -1 if the pinned one's is unknown
+        QStringList paths;        ///< In airing order, the pinned spot first
+    };
+
+    /// Returns the duration of a file in microseconds, -1 if unknown
+    using DurationLookup = std::function<qint64(const QString& filePath)>;
+
+    explicit AdBreakPacker(QSqlDatabase& database, QObject* parent = nullptr);
+
+    void setDurationLookup(DurationLookup lookup) { m_durationLookup = std::move(lookup); }
+
+    /**
+     * @brief Read the pub table, adding the customer column if needed
+     * @return true if the table was read
+     */
+    bool reload();
+
+    /**
+     * @brief Mark the pool stale so the table is read again before the next packing
+     */
+    void invalidate() { m_stale = true; }
+
+    /**
+     * @brief Replace the pool, instead of reading the table
+     */
+    void setSpots(const QVector<Spot>& spots);
+    QVector<Spot> spots();
+
+    void setCustomerSeparationMs(qint64 separationMs);
+    qint64 customerSeparationMs() const { return m_separationMs; }
+
+    void setMaxDailyPlays(int plays);
+    int maxDailyPlays() const { return m_maxDailyPlays; }
+
+    /**
+     * @brief Fill breaks in time order, each following the rules of the ones before
+     * @param breaks Breaks to fill, in any order
+     * @return One break per slot, sorted by time
+     */
+    QVector<Break> packDay(QVector<Slot> breaks);
+
+    /**
+     * @brief Fill a single break
+     */
+    Break pack(const Slot& slot) { return packDay({slot}).value(0); }
+
+    /**
+     * @brief Record the spots of a break as aired at its time
+     */
+    void markAired(const QDateTime& at, const QStringList& paths);
+
+signals:
+    /**
+     * @brief Emitted when the table cannot be read
+     */
+    void operationError(const QString& operation, const QString& error);
+
+private:
+    /// What the rules need to know of the breaks before
+    struct History {
+        QHash<QString, QDateTime> customerAiredAt;
+        QHash<QString, int> plays;    ///< By path, on playsDate
+        QDate playsDate;
+    };
+
+    void ensureLoaded();
+    bool ensureCustomerColumn();
+    Break packOne(const Slot& slot, History& history) const;
+    void record(History& history, const QDateTime& at, const QStringList& paths) const;
+    void logError(const QString& operation, const QString& error, const QString& query = QString());
+
+    QSqlDatabase& m_database;
+    DurationLookup m_durationLookup;
+    QVector<Spot> m_spots;
+    QHash<QString, int> m_index;   ///< Row of each path in m_spots
+    qint64 m_separationMs = 30 * 60 * 1000;
+    int m_maxDailyPlays = 0;
+    History m_aired;
+    bool m_stale = true;
+};
+
+#endif // ADBREAKPACKER_H
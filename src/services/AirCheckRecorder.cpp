@@ -0,0 +1,161 @@
+#include "AirCheckRecorder.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+
+namespace {
+
+const QString FILE_PREFIX = QStringLiteral("aircheck");
+const QString INDEX_SUFFIX = QStringLiteral(".tracks.txt");
+const QString FILE_STAMP_FORMAT = QStringLiteral("yyyyMMdd-HHmmss");
+const QString DAY_FORMAT = QStringLiteral("yyyyMMdd");
+
+} // namespace
+
+AirCheckRecorder::AirCheckRecorder(QObject* parent)
+    : QObject(parent)
+    , m_recorder(new SegmentRecorder(this))
+{
+    m_recorder->setSegmentSeconds(FILE_SECONDS);
+    setEncoding("libopus", m_suffix, DEFAULT_BITRATE_KBPS);
+    connect(m_recorder, &SegmentRecorder::segmentWritten, this,
+            &AirCheckRecorder::onFileWritten);
+    connect(m_recorder, &SegmentRecorder::operationError, this,
+            &AirCheckRecorder::operationError);
+}
+
+void AirCheckRecorder::setEncoding(const QString& codec, const QString& suffix, int bitrateKbps)
+{
+    m_suffix = suffix;
+    m_recorder->setCodec(codec, bitrateKbps);
+}
+
+void AirCheckRecorder::setSource(SegmentRecorder::PcmReader reader, int sampleRate,
+                                 int channels)
+{
+    m_recorder->setReader(std::move(reader), sampleRate, channels);
+}
+
+bool AirCheckRecorder::start()
+{
+    if (isRunning()) {
+        return true;
+    }
+    if (m_directory.isEmpty()) {
+        logError("start", "No directory set");
+        return false;
+    }
+    if (!m_recorder->startArchive(m_directory, FILE_PREFIX, m_suffix)) {
+        return false;
+    }
+    prune();
+    qInfo() << "AirCheckRecorder: recording the output into" << m_directory;
+    return true;
+}
+
+void AirCheckRecorder::stop()
+{
+    m_recorder->stop();
+}
+
+bool AirCheckRecorder::markTrack(const QString& title, const QDateTime& at)
+{
+    if (!isRunning()) {
+        return false;
+    }
+    QFile index(indexFile(m_directory, at.date()));
+    if (!index.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+        logError("markTrack", QString("Cannot write %1").arg(index.fileName()));
+        return false;
+    }
+    // One line per track, whatever the title holds
+    QString line = title;
+    line.replace('\t', ' ').replace('\n', ' ').replace('\r', ' ');
+    QTextStream out(&index);
+    out << at.toString("HH:mm:ss") << '\t' << line << '\n';
+    return true;
+}
+
+int AirCheckRecorder::prune(const QDateTime& now)
+{
+    if (m_retentionDays <= 0 || m_directory.isEmpty()) {
+        return 0;
+    }
+    const QDateTime cutoff = now.addDays(-m_retentionDays);
+    int removed = 0;
+    for (const QString& file : SegmentRecorder::archiveFiles(m_directory, FILE_PREFIX, m_suffix)) {
+        const QDateTime started = fileStart(file);
+        if (started.isValid() && started < cutoff && QFile::remove(file)) {
+            ++removed;
+        }
+    }
+
+    const QDir dir(m_directory);
+    const QStringList indexes =
+        dir.entryList({FILE_PREFIX + "-*" + INDEX_SUFFIX}, QDir::Files, QDir::Name);
+    for (const QString& name : indexes) {
+        const QString stamp = name.chopped(INDEX_SUFFIX.size()).mid(FILE_PREFIX.size() + 1);
+        const QDate day = QDate::fromString(stamp, DAY_FORMAT);
+        if (day.isValid() && day < cutoff.date() && QFile::remove(dir.filePath(name))) {
+            ++removed;
+        }
+    }
+
+    if (removed > 0) {
+        qInfo() << "AirCheckRecorder: removed" << removed << "files older than"
+                << m_retentionDays << "days";
+    }
+    return removed;
+}
+
+QString AirCheckRecorder::indexFile(const QString& directory, const QDate& day)
+{
+    return QDir(directory).filePath(
+        QString("%1-%2%3").arg(FILE_PREFIX, day.toString(DAY_FORMAT), INDEX_SUFFIX));
+}
+
+AirCheckRecorder::Position AirCheckRecorder::locate(const QString& directory,
+                                                    const QString& suffix, const QDateTime& at,
+                                                    int fileSeconds)
+{
+    Position position;
+    for (const QString& file : SegmentRecorder::archiveFiles(directory, FILE_PREFIX, suffix)) {
+        const QDateTime started = fileStart(file);
+        if (!started.isValid() || started > at) {
+            continue;
+        }
+        // Files sort by their start, so the last one before the moment holds it
+        const qint64 offsetMs = started.msecsTo(at);
+        if (offsetMs < qint64(fileSeconds) * 1000) {
+            position.file = file;
+            position.offsetMs = offsetMs;
+        } else {
+            position = Position();
+        }
+    }
+    return position;
+}
+
+QDateTime AirCheckRecorder::fileStart(const QString& file)
+{
+    const QString name = QFileInfo(file).completeBaseName();
+    if (!name.startsWith(FILE_PREFIX + "-")) {
+        return QDateTime();
+    }
+    return QDateTime::fromString(name.mid(FILE_PREFIX.size() + 1), FILE_STAMP_FORMAT);
+}
+
+void AirCheckRecorder::onFileWritten(const QString& file)
+{
+    qInfo() << "AirCheckRecorder: closed" << QFileInfo(file).fileName();
+    emit fileWritten(file);
+    prune();
+}
+
+void AirCheckRecorder::logError(const QString& operation, const QString& error)
+{
+    qWarning() << QString("AirCheckRecorder::%1 - %2").arg(operation, error);
+    emit operationError(operation, error);
+}
@@ -0,0 +1,187 @@
+#ifndef AIRCHECKRECORDER_H
+#define AIRCHECKRECORDER_H
+
+#include <QDateTime>
+#include <QObject>
+#include <QString>
+
+#include "SegmentRecorder.h"
+
+/**
+ * @brief Records everything that goes to air, around the clock, into hourly files
+ *
+ * Stations have to keep what they broadcast. AirCheckRecorder takes the
+ * mixed output from the playback engine's air-check tap, so whatever the
+ * listeners hear is recorded, crossfades and volume included. It is
+ * encoded at a low bitrate (Opus at DEFAULT_BITRATE_KBPS by default). A
+ * SegmentRecorder archive does the work: the encoder thread pulls the
+ * tap, one ffmpeg child encodes, and a file is cut on every hour of the
+ * wall clock:
+ *
+ *     aircheck-20261014-150000.opus
+ *
+ * Each file is complete once the next one starts, so a crash costs at
+ * most the hour in progress. Memory does not grow with the length of
+ * the run: the tap and the encoder's pipe are bounded, and nothing else
+ * is kept.
+ *
+ * markTrack() logs a track boundary. Each one is appended at once to the
+ * day's index, "aircheck-20261014.tracks.txt", one track per line:
+ *
+ *     15:04:31<TAB>song.mp3
+ *
+ * locate() turns a time into a file and offset, for finding a moment
+ * again. With setRetentionDays(), files older than the retention period
+ * are removed as new files are written.
+ *
+ * @example
+ * @code
+ * AirCheckRecorder* airCheck = new AirCheckRecorder(this);
+ * airCheck->setDirectory(savePath + "/aircheck");
+ * airCheck->setSource([engine](float* data, int samples) {
+ *     return engine->readTap(data, samples, DeckMixer::Tap::AirCheck);
+ * }, engine->sampleRate());
+ * engine->setTapEnabled(true, DeckMixer::Tap::AirCheck);
+ * airCheck->start();
+ * airCheck->markTrack("song.mp3");
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class AirCheckRecorder : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int FILE_SECONDS = 3600;
+    static constexpr int DEFAULT_BITRATE_KBPS = 48;
+
+    /**
+     * @brief Where a moment of the recording is
+     */
+    struct Position {
+        QString file;          ///< Audio file, empty if none covers the time
+        qint64 offsetMs = 0;   ///< From the start of the file
+    };
+
+    explicit AirCheckRecorder(QObject* parent = nullptr);
+
+    /**
+     * @brief Set the ffmpeg executable
+     * @param program Path or name of ffmpeg; "ffmpeg" by default
+     */
+    void setProgram(const QString& program) { m_recorder->setProgram(program); }
+
+    void setDirectory(const QString& directory) { m_directory = directory; }
+    QString directory() const { return m_directory; }
+
+    /**
+     * @brief Choose the encoding, applied by the next start()
+     * @param codec ffmpeg encoder, such as "libopus"
+     * @param suffix File suffix, which picks the container
+     * @param bitrateKbps Bitrate
+     */
+    void setEncoding(const QString& codec, const QString& suffix, int bitrateKbps);
+    QString suffix() const { return m_suffix; }
+
+    /**
+     * @brief Set how long each file lasts
+     * @param seconds Length; FILE_SECONDS by default, for files on the hour
+     */
+    void setFileSeconds(int seconds) { m_recorder->setSegmentSeconds(seconds); }
+
+    /**
+     * @brief Keep files for a number of days
+     * @param days Days, or 0 to keep them until removed by hand
+     */
+    void setRetentionDays(int days) { m_retentionDays = qMax(0, days); }
+    int retentionDays() const { return m_retentionDays; }
+
+    /**
+     * @brief Set where the audio comes from
+     * @param reader Pulled on the encoder thread, such as from the air-check tap
+     * @param sampleRate Rate of the samples in Hz
+     * @param channels Channels per interleaved frame
+     */
+    void setSource(SegmentRecorder::PcmReader reader, int sampleRate,
+                   int channels = SegmentRecorder::DEFAULT_CHANNELS);
+
+    /**
+     * @brief Start recording
+     * @return false if ffmpeg cannot be started or the directory is not writable
+     */
+    bool start();
+
+    /**
+     * @brief Stop recording; the file in progress is closed
+     */
+    void stop();
+
+    bool isRunning() const { return m_recorder->isRecording(); }
+
+    /**
+     * @brief Log the start of a track in the day's index
+     * @param title Name of the track
+     * @param at When it started
+     * @return false if not recording or the index cannot be written
+     */
+    bool markTrack(const QString& title, const QDateTime& at = QDateTime::currentDateTime());
+
+    /**
+     * @brief Remove the files that are older than the retention period
+     * @param now Current time
+     * @return Number of files removed
+     */
+    int prune(const QDateTime& now = QDateTime::currentDateTime());
+
+    /**
+     * @brief Get the index a day's track boundaries are logged in
+     * @param directory Directory of the recording
+     * @param day Day
+     * @return Path of "aircheck-<yyyyMMdd>.tracks.txt"
+     */
+    static QString indexFile(const QString& directory, const QDate& day);
+
+    /**
+     * @brief Find the file and offset a moment was recorded at
+     * @param directory Directory of the recording
+     * @param suffix Suffix of the audio files
+     * @param at Moment
+     * @param fileSeconds Length of the files
+     * @return Position, with an empty file if nothing was recorded then
+     */
+    static Position locate(const QString& directory, const QString& suffix, const QDateTime& at,
+                           int fileSeconds = FILE_SECONDS);
+
+    /**
+     * @brief Get the time a file started, from its name
+     * @param file Audio file
+     * @return Start, or an invalid time if the name is not an air-check file
+     */
+    static QDateTime fileStart(const QString& file);
+
+signals:
+    /**
+     * @brief Emitted when a file is complete
+     * @param file Path of the file
+     */
+    void fileWritten(const QString& file);
+
+    /**
+     * @brief Emitted when an operation fails
+     * @param operation Name of the operation
+     * @param error Error message
+     */
+    void operationError(const QString& operation, const QString& error);
+
+private:
+    void onFileWritten(const QString& file);
+    void logError(const QString& operation, const QString& error);
+
+    SegmentRecorder* m_recorder;
+    QString m_directory;
+    QString m_suffix = "opus";
+    int m_retentionDays = 0;
+};
+
+#endif // AIRCHECKRECORDER_H
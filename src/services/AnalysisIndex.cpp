@@ -0,0 +1,428 @@
+#include "AnalysisIndex.h"
+#include "CuePointStore.h"
+#include "ReplayGainStore.h"
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QStringList>
+#include <QVariant>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+constexpr char MAGIC[4] = {'X', 'F', 'B', 'A'};
+constexpr const char* INDEX_FILE_NAME = ".xfb-analysis.index";
+
+bool execLogged(QSqlQuery& query, const QString& operation)
+{
+    if (query.exec()) {
+        return true;
+    }
+    qWarning() << QString("AnalysisIndex::%1 - SQL Error: %2 (Query: %3)")
+                      .arg(operation, query.lastError().text(), query.lastQuery());
+    return false;
+}
+
+/// Condition on musics.path for the tracks under a root, binding the prefix and the root
+QString underRoot(const QString& rootPath)
+{
+    return rootPath.isEmpty() ? QString()
+                              : QString(" AND (substr(path, 1, length(?)) = ? OR path = ?)");
+}
+
+void bindRoot(QSqlQuery& query, const QString& rootPath)
+{
+    if (rootPath.isEmpty()) {
+        return;
+    }
+    const QString prefix = QDir::cleanPath(rootPath) + '/';
+    query.addBindValue(prefix);
+    query.addBindValue(prefix);
+    query.addBindValue(QDir::cleanPath(rootPath));
+}
+
+qint64 cueValue(const QVariant& value, qint64 unset)
+{
+    return value.isNull() ? unset : value.toLongLong();
+}
+
+void putDouble(uchar* out, double value)
+{
+    quint64 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    qToLittleEndian<quint64>(bits, out);
+}
+
+double getDouble(const uchar* in)
+{
+    const quint64 bits = qFromLittleEndian<quint64>(in);
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+bool fail(QString* error, const QString& reason)
+{
+    if (error) {
+        *error = reason;
+    }
+    return false;
+}
+
+} // namespace
+
+QString AnalysisIndex::defaultPath(const QString& rootPath)
+{
+    return QDir(rootPath).filePath(INDEX_FILE_NAME);
+}
+
+quint64 AnalysisIndex::hashKey(const QString& contentHash)
+{
+    if (contentHash.size() != 16) {
+        return 0;
+    }
+    bool ok = false;
+    const quint64 key = contentHash.toULongLong(&ok, 16);
+    return ok ? key : 0;
+}
+
+bool AnalysisIndex::write(const QString& indexPath, QList<Entry> entries, QString* error)
+{
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](const Entry& a, const Entry& b) { return a.hash < b.hash; });
+    entries.erase(std::unique(entries.begin(), entries.end(),
+                              [](const Entry& a, const Entry& b) { return a.hash == b.hash; }),
+                  entries.end());
+
+    // Peak files are copied in after the entries, which need their sizes first
+    QList<qint64> peakSizes;
+    for (Entry& entry : entries) {
+        const QFileInfo peaks(entry.peakPath);
+        const qint64 size = (entry.content & HasPeaks) && peaks.isFile() ? peaks.size() : 0;
+        if (size <= 0 || size > std::numeric_limits<quint32>::max()) {
+            entry.content &= ~quint32(HasPeaks);
+        }
+        peakSizes.append(entry.content & HasPeaks ? size : 0);
+    }
+
+    const qint64 entriesOffset = HEADER_SIZE;
+    const qint64 peaksOffset = entriesOffset + qint64(entries.size()) * ENTRY_SIZE;
+    QByteArray head(peaksOffset, '\0');
+    uchar* out = reinterpret_cast<uchar*>(head.data());
+    memcpy(out, MAGIC, 4);
+    qToLittleEndian<quint32>(VERSION, out + 4);
+    qToLittleEndian<quint32>(quint32(entries.size()), out + 8);
+    qToLittleEndian<quint64>(quint64(entriesOffset), out + 16);
+    qToLittleEndian<quint64>(quint64(peaksOffset), out + 24);
+
+    qint64 peakOffset = 0;
+    for (qsizetype i = 0; i < entries.size(); ++i) {
+        const Entry& entry = entries.at(i);
+        uchar* record = out + entriesOffset + i * ENTRY_SIZE;
+        qToLittleEndian<quint64>(entry.hash, record);
+        qToLittleEndian<quint32>(entry.content, record + 8);
+        qToLittleEndian<quint32>(quint32(peakSizes.at(i)), record + 12);
+        qToLittleEndian<quint64>(quint64(peakOffset), record + 16);
+        qToLittleEndian<qint64>(entry.cue.inMs, record + 24);
+        qToLittleEndian<qint64>(entry.cue.outMs, record + 32);
+        qToLittleEndian<qint64>(entry.cue.introMs, record + 40);
+        qToLittleEndian<qint64>(entry.cue.fadeMs, record + 48);
+        qToLittleEndian<qint64>(entry.cue.segueMs, record + 56);
+        putDouble(record + 64, entry.integratedLufs);
+        putDouble(record + 72, entry.truePeakDbtp);
+        peakOffset += peakSizes.at(i);
+    }
+
+    QSaveFile file(indexPath);
+    if (!file.open(QIODevice::WriteOnly) || file.write(head) != head.size()) {
+        return fail(error, QString("Cannot write %1: %2").arg(indexPath, file.errorString()));
+    }
+    for (qsizetype i = 0; i < entries.size(); ++i) {
+        if (!(entries.at(i).content & HasPeaks)) {
+            continue;
+        }
+        // A peak file that changed size since would shift every offset after it
+        QFile peaks(entries.at(i).peakPath);
+        const QByteArray data = peaks.open(QIODevice::ReadOnly) ? peaks.readAll() : QByteArray();
+        if (data.size() != peakSizes.at(i)) {
+            return fail(error, QString("Cannot read %1").arg(entries.at(i).peakPath));
+        }
+        if (file.write(data) != data.size()) {
+            return fail(error, QString("Cannot write %1: %2").arg(indexPath, file.errorString()));
+        }
+    }
+    if (!file.commit()) {
+        return fail(error, QString("Cannot write %1: %2").arg(indexPath, file.errorString()));
+    }
+    return true;
+}
+
+QList<AnalysisIndex::Entry> AnalysisIndex::libraryEntries(QSqlDatabase& database,
+                                                           const QString& rootPath,
+                                                           const PeakLocator& peakFile, bool* ok)
+{
+    QList<Entry> entries;
+    QSqlQuery query(database);
+    query.setForwardOnly(true);
+    query.prepare("SELECT path, content_hash, cue_in_ms, cue_out_ms, intro_ms, fade_ms, "
+                  "segue_ms, loudness_lufs, true_peak_dbtp FROM musics "
+                  "WHERE content_hash IS NOT NULL" + underRoot(rootPath));
+    bindRoot(query, rootPath);
+    const bool executed = execLogged(query, "libraryEntries");
+    if (ok) {
+        *ok = executed;
+    }
+    while (executed && query.next()) {
+        Entry entry;
+        entry.hash = hashKey(query.value(1).toString());
+        if (entry.hash == 0) {
+            continue;
+        }
+        for (int column = 2; column <= 6; ++column) {
+            if (!query.value(column).isNull()) {
+                entry.content |= HasCuePoints;
+            }
+        }
+        // The same defaults as CuePointStore reads for NULL columns
+        entry.cue.inMs = cueValue(query.value(2), 0);
+        entry.cue.outMs = cueValue(query.value(3), -1);
+        entry.cue.introMs = cueValue(query.value(4), -1);
+        entry.cue.fadeMs = cueValue(query.value(5), -1);
+        entry.cue.segueMs = cueValue(query.value(6), -1);
+        if (!query.value(7).isNull()) {
+            entry.content |= HasLoudness;
+            entry.integratedLufs = query.value(7).toDouble();
+            entry.truePeakDbtp = query.value(8).toDouble();
+        }
+        entry.peakPath = peakFile ? peakFile(query.value(0).toString()) : QString();
+        if (!entry.peakPath.isEmpty()) {
+            entry.content |= HasPeaks;
+        }
+        if (entry.content != 0) {
+            entries.append(entry);
+        }
+    }
+    return entries;
+}
+
+int AnalysisIndex::exportLibrary(QSqlDatabase& database, const QString& rootPath,
+                                 const QString& indexPath, const PeakLocator& peakFile,
+                                 QString* error)
+{
+    bool ok = false;
+    const QList<Entry> entries = libraryEntries(database, rootPath, peakFile, &ok);
+    if (!ok) {
+        fail(error, QString("Cannot read the analysis of %1").arg(rootPath));
+        return -1;
+    }
+    return write(indexPath, entries, error) ? int(entries.size()) : -1;
+}
+
+bool AnalysisIndex::open(const QString& indexPath)
+{
+    close();
+
+    m_file.setFileName(indexPath);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const qint64 size = m_file.size();
+    const uchar* base = size >= HEADER_SIZE ? m_file.map(0, size) : nullptr;
+    if (!base || memcmp(base, MAGIC, 4) != 0 || qFromLittleEndian<quint32>(base + 4) != VERSION) {
+        close();
+        return false;
+    }
+    const qint64 count = qFromLittleEndian<quint32>(base + 8);
+    const quint64 entriesOffset = qFromLittleEndian<quint64>(base + 16);
+    const quint64 peaksOffset = qFromLittleEndian<quint64>(base + 24);
+    if (entriesOffset < quint64(HEADER_SIZE) || entriesOffset > quint64(size)
+        || quint64(count) > (quint64(size) - entriesOffset) / ENTRY_SIZE
+        || peaksOffset > quint64(size)) {
+        close();
+        return false;
+    }
+    m_data = base;
+    m_size = size;
+    m_count = count;
+    m_entriesOffset = qint64(entriesOffset);
+    m_peaksOffset = qint64(peaksOffset);
+    return true;
+}
+
+void AnalysisIndex::close()
+{
+    m_file.close();
+    m_data = nullptr;
+    m_size = 0;
+    m_count = 0;
+    m_entriesOffset = 0;
+    m_peaksOffset = 0;
+}
+
+AnalysisIndex::Entry AnalysisIndex::entryAt(qint64 index) const
+{
+    const uchar* record = m_data + m_entriesOffset + index * ENTRY_SIZE;
+    Entry entry;
+    entry.hash = qFromLittleEndian<quint64>(record);
+    entry.content = qFromLittleEndian<quint32>(record + 8);
+    entry.cue.inMs = qFromLittleEndian<qint64>(record + 24);
+    entry.cue.outMs = qFromLittleEndian<qint64>(record + 32);
+    entry.cue.introMs = qFromLittleEndian<qint64>(record + 40);
+    entry.cue.fadeMs = qFromLittleEndian<qint64>(record + 48);
+    entry.cue.segueMs = qFromLittleEndian<qint64>(record + 56);
+    entry.integratedLufs = getDouble(record + 64);
+    entry.truePeakDbtp = getDouble(record + 72);
+
+    const quint64 length = qFromLittleEndian<quint32>(record + 12);
+    const quint64 offset = qFromLittleEndian<quint64>(record + 16);
+    const quint64 available = quint64(m_size - m_peaksOffset);
+    if ((entry.content & HasPeaks) && length > 0 && offset <= available
+        && length <= available - offset) {
+        entry.peaks = QByteArray::fromRawData(
+            reinterpret_cast<const char*>(m_data + m_peaksOffset + offset), qsizetype(length));
+    } else {
+        entry.content &= ~quint32(HasPeaks);
+    }
+    return entry;
+}
+
+bool AnalysisIndex::find(quint64 hash, Entry* entry) const
+{
+    qint64 low = 0;
+    qint64 high = m_count;
+    while (low < high) {
+        const qint64 middle = low + (high - low) / 2;
+        const quint64 key = qFromLittleEndian<quint64>(m_data + m_entriesOffset
+                                                       + middle * ENTRY_SIZE);
+        if (key < hash) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    if (low >= m_count
+        || qFromLittleEndian<quint64>(m_data + m_entriesOffset + low * ENTRY_SIZE) != hash) {
+        return false;
+    }
+    if (entry) {
+        *entry = entryAt(low);
+    }
+    return true;
+}
+
+QList<AnalysisIndex::Imported> AnalysisIndex::importInto(QSqlDatabase& database,
+                                                         const QString& rootPath,
+                                                         const PeakLocator& peakFile) const
+{
+    QList<Imported> imported;
+    if (!isOpen() || m_count == 0) {
+        return imported;
+    }
+
+    // The matches are collected first, so the updates do not run under the open SELECT
+    QSqlQuery query(database);
+    query.setForwardOnly(true);
+    query.prepare("SELECT path, content_hash, cue_in_ms IS NULL AND cue_out_ms IS NULL "
+                  "AND intro_ms IS NULL AND fade_ms IS NULL AND segue_ms IS NULL, "
+                  "loudness_lufs IS NULL FROM musics WHERE content_hash IS NOT NULL"
+                  + underRoot(rootPath));
+    bindRoot(query, rootPath);
+    if (!execLogged(query, "importInto")) {
+        return imported;
+    }
+    while (query.next()) {
+        Imported track;
+        if (!find(hashKey(query.value(1).toString()), &track.entry)) {
+            continue;
+        }
+        track.path = query.value(0).toString();
+        if (query.value(2).toBool()) {
+            track.content |= track.entry.content & HasCuePoints;
+        }
+        if (query.value(3).toBool()) {
+            track.content |= track.entry.content & HasLoudness;
+        }
+        if ((track.entry.content & HasPeaks) && peakFile) {
+            track.entry.peakPath = peakFile(track.path);
+            if (!track.entry.peakPath.isEmpty()) {
+                track.content |= HasPeaks;
+            }
+        }
+        if (track.content != 0) {
+            imported.append(track);
+        }
+    }
+    query.finish();
+
+    if (!database.transaction()) {
+        qWarning() << QString("AnalysisIndex::importInto - SQL Error: %1")
+                          .arg(database.lastError().text());
+        return {};
+    }
+    QSqlQuery update(database);
+    QString prepared;
+    for (Imported& track : imported) {
+        QVariantMap columns;
+        if (track.content & HasCuePoints) {
+            columns.insert(CuePointStore::toColumns(track.entry.cue));
+        }
+        if (track.content & HasLoudness) {
+            ReplayGainStore::Loudness loudness;
+            loudness.integratedLufs = track.entry.integratedLufs;
+            loudness.truePeakDbtp = track.entry.truePeakDbtp;
+            columns.insert(ReplayGainStore::toColumns(&loudness));
+        }
+        if (!columns.isEmpty()) {
+            QStringList assignments;
+            for (auto it = columns.cbegin(); it != columns.cend(); ++it) {
+                assignments.append(it.key() + " = ?");
+            }
+            const QString sql =
+                QString("UPDATE musics SET %1 WHERE path = ?").arg(assignments.join(", "));
+            if (sql != prepared && !update.prepare(sql)) {
+                qWarning() << QString("AnalysisIndex::importInto - SQL Error: %1 (Query: %2)")
+                                  .arg(update.lastError().text(), sql);
+                database.rollback();
+                return {};
+            }
+            prepared = sql;
+            for (const QVariant& value : std::as_const(columns)) {
+                update.addBindValue(value);
+            }
+            update.addBindValue(track.path);
+            if (!execLogged(update, "importInto")) {
+                database.rollback();
+                return {};
+            }
+        }
+
+        // A peak file that cannot be written is made again from the audio later
+        if (track.content & HasPeaks) {
+            QDir().mkpath(QFileInfo(track.entry.peakPath).absolutePath());
+            QSaveFile peaks(track.entry.peakPath);
+            if (!peaks.open(QIODevice::WriteOnly)
+                || peaks.write(track.entry.peaks) != track.entry.peaks.size() || !peaks.commit()) {
+                qWarning() << QString("AnalysisIndex::importInto - Cannot write %1: %2")
+                                  .arg(track.entry.peakPath, peaks.errorString());
+                track.content &= ~quint32(HasPeaks);
+            }
+        }
+    }
+    if (!database.commit()) {
+        qWarning() << QString("AnalysisIndex::importInto - SQL Error: %1")
+                          .arg(database.lastError().text());
+        database.rollback();
+        return {};
+    }
+
+    imported.erase(std::remove_if(imported.begin(), imported.end(),
+                                  [](const Imported& track) { return track.content == 0; }),
+                   imported.end());
+    return imported;
+}
@@ -0,0 +1,182 @@
+#ifndef ANALYSISINDEX_H
+#define ANALYSISINDEX_H
+
+#include "CuePoints.h"
+#include <QByteArray>
+#include <QFile>
+#include <QList>
+#include <QSqlDatabase>
+#include <QString>
+#include <functional>
+
+/**
+ * @brief The analysis results of a library root, in a file that moves with it
+ *
+ * Cue points, loudness and waveform peaks take days to compute for a large
+ * library, and a studio machine set up with a copy of the library started
+ * again from nothing. An analysis index holds the results of every
+ * analyzed track under a root, keyed by ContentHash rather than by path, so
+ * another machine finds them whatever the library is mounted as.
+ *
+ * The layout, all little-endian:
+ * - 32-byte header: "XFBA", version, entry count, a reserved word, then
+ *   the offsets of the entries and of the peak data as 64-bit integers
+ * - ENTRY_SIZE bytes per track, in increasing order of hash: the hash,
+ *   which results it has, the offset and length of its peak file in the
+ *   peak data, the five cue points and the loudness
+ * - the peak files of the tracks, as PeakFile wrote them
+ *
+ * open() maps the file and find() looks a hash up in the mapping, so
+ * importing a library reads only the entries of its tracks and the peaks
+ * they need. exportLibrary() writes the index of a root from the musics
+ * table, and importInto() fills in what the tracks of a root lack from
+ * an index, leaving whatever was analyzed on this machine as it is.
+ *
+ * @example
+ * @code
+ * AnalysisIndex::exportLibrary(database, "/music", AnalysisIndex::defaultPath("/music"),
+ *                              currentPeakFile);
+ * // ... on the other machine, once the tracks are in its library ...
+ * AnalysisIndex index;
+ * if (index.open(AnalysisIndex::defaultPath("/mnt/music"))) {
+ *     const QList<AnalysisIndex::Imported> imported =
+ *         index.importInto(database, "/mnt/music", missingPeakFile);
+ * }
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class AnalysisIndex
+{
+public:
+    static constexpr int VERSION = 1;
+    static constexpr int HEADER_SIZE = 32;
+    static constexpr int ENTRY_SIZE = 80;
+
+    /// Results an entry holds
+    enum Content : quint32 {
+        HasCuePoints = 0x1,
+        HasLoudness = 0x2,
+        HasPeaks = 0x4
+    };
+
+    struct Entry {
+        quint64 hash = 0;
+        quint32 content = 0;           ///< Content flags
+        CuePoints cue;
+        double integratedLufs = 0.0;
+        double truePeakDbtp = 0.0;
+        QByteArray peaks;              ///< Read: the peak file, valid while the index is open
+        QString peakPath;              ///< Peak file written in, or that importInto() wrote
+    };
+
+    /**
+     * @brief What importInto() gave a track
+     */
+    struct Imported {
+        QString path;                  ///< Path as stored in the musics table
+        quint32 content = 0;           ///< Content flags of what was taken
+        Entry entry;
+    };
+
+    /// Peak file of a track as stored in the musics table, or empty for none
+    using PeakLocator = std::function<QString(const QString& audioPath)>;
+
+    AnalysisIndex() = default;
+    ~AnalysisIndex() { close(); }
+
+    AnalysisIndex(const AnalysisIndex&) = delete;
+    AnalysisIndex& operator=(const AnalysisIndex&) = delete;
+
+    /**
+     * @brief Where the index of a library root is kept, in the root itself
+     */
+    static QString defaultPath(const QString& rootPath);
+
+    /**
+     * @brief Key of a content hash as ContentHash gives it
+     * @return The hash, or 0 if it is not 16 hex digits
+     */
+    static quint64 hashKey(const QString& contentHash);
+
+    /**
+     * @brief Write an index, atomically
+     *
+     * Entries are sorted by hash; of two with the same hash the first is kept.
+     * @param indexPath File to write; replaced only on success
+     * @param entries Entries with hash, content and, for peaks, peakPath set
+     * @param error Set to the reason on failure, if given
+     */
+    static bool write(const QString& indexPath, QList<Entry> entries, QString* error = nullptr);
+
+    /**
+     * @brief Read the analysis of the tracks under a root, for write()
+     *
+     * Only the database is read, so the entries can be written on another thread.
+     * @param database Library database with the cue point and loudness columns
+     * @param rootPath Library root; every track if empty
+     * @param peakFile Current peak file of a track, or empty if it has none
+     * @param ok Set to false on an SQL error, if given
+     * @return Entries of the tracks with a content hash and some analysis
+     */
+    static QList<Entry> libraryEntries(QSqlDatabase& database, const QString& rootPath,
+                                       const PeakLocator& peakFile, bool* ok = nullptr);
+
+    /**
+     * @brief Write the index of the analyzed tracks under a root
+     * @param database Library database with the cue point and loudness columns
+     * @param rootPath Library root; every track if empty
+     * @param indexPath File to write
+     * @param peakFile Current peak file of a track, or empty if it has none
+     * @param error Set to the reason on failure, if given
+     * @return Number of tracks written, or -1 on failure
+     */
+    static int exportLibrary(QSqlDatabase& database, const QString& rootPath,
+                             const QString& indexPath, const PeakLocator& peakFile,
+                             QString* error = nullptr);
+
+    /**
+     * @brief Map an index
+     * @return false if it cannot be read or is not an index of this version
+     */
+    bool open(const QString& indexPath);
+    void close();
+    bool isOpen() const { return m_data != nullptr; }
+
+    int count() const { return int(m_count); }
+
+    /**
+     * @brief Look a track up
+     * @param hash hashKey() of its content hash
+     * @param entry Receives the entry, if given
+     * @return true if the index has the track
+     */
+    bool find(quint64 hash, Entry* entry = nullptr) const;
+
+    /**
+     * @brief Fill in the analysis the tracks under a root lack, in one transaction
+     *
+     * Cue points are only taken for a track that has none, loudness for
+     * one that was not measured. Peak files are written to where peakFile
+     * says, for the tracks it gives a path for. The stores that keep the
+     * results in memory are given them by the caller.
+     * @param database Library database with the cue point and loudness columns
+     * @param rootPath Library root; every track if empty
+     * @param peakFile Peak file to write for a track, or empty if it needs none
+     * @return Tracks that took something; empty on failure too
+     */
+    QList<Imported> importInto(QSqlDatabase& database, const QString& rootPath,
+                               const PeakLocator& peakFile) const;
+
+private:
+    Entry entryAt(qint64 index) const;
+
+    QFile m_file;
+    const uchar* m_data = nullptr;
+    qint64 m_size = 0;
+    qint64 m_count = 0;
+    qint64 m_entriesOffset = 0;
+    qint64 m_peaksOffset = 0;
+};
+
+#endif // ANALYSISINDEX_H
@@ -0,0 +1,420 @@
+#include "AnalysisPipeline.h"
+#include "BackgroundThrottle.h"
+#include "CuePointStore.h"
+#include "LoudnessMeter.h"
+#include "PeakFile.h"
+#include "PeakFileGenerator.h"
+#include "ReplayGainStore.h"
+#include <QDebug>
+#include <QFutureWatcher>
+#include <QPointer>
+#include <QSet>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QThread>
+#include <QTimer>
+#include <QtConcurrent/QtConcurrent>
+
+namespace {
+
+class LoudnessAnalyzer : public AnalysisPipeline::Analyzer
+{
+public:
+    explicit LoudnessAnalyzer(ReplayGainStore* store)
+        : m_store(store)
+    {
+    }
+
+    void feed(const float* samples, qint64 count, int sampleRate, int channels) override
+    {
+        if (!m_meter) {
+            m_meter = std::make_unique<LoudnessMeter>(sampleRate, channels);
+        }
+        m_meter->feed(samples, count);
+    }
+
+    bool finish(QString* error) override
+    {
+        m_result = m_meter ? m_meter->result() : LoudnessMeter::Result();
+        m_meter.reset();
+        if (!m_result.valid) {
+            *error = "No loudness was measured";
+        }
+        return m_result.valid;
+    }
+
+    QVariantMap columns() const override
+    {
+        const ReplayGainStore::Loudness loudness = measured();
+        return ReplayGainStore::toColumns(m_result.audible ? &loudness : nullptr);
+    }
+
+    void publish(const QString& filePath) override
+    {
+        // Tracks that are silent throughout are never boosted
+        const ReplayGainStore::Loudness loudness = measured();
+        if (m_store) {
+            m_store->setStoredLoudness(filePath, m_result.audible ? &loudness : nullptr);
+        }
+    }
+
+private:
+    ReplayGainStore::Loudness measured() const
+    {
+        ReplayGainStore::Loudness loudness;
+        loudness.integratedLufs = m_result.integratedLufs;
+        loudness.truePeakDbtp = m_result.truePeakDbtp;
+        return loudness;
+    }
+
+    QPointer<ReplayGainStore> m_store;
+    std::unique_ptr<LoudnessMeter> m_meter;
+    LoudnessMeter::Result m_result;
+};
+
+class CueAnalyzer : public AnalysisPipeline::Analyzer
+{
+public:
+    CueAnalyzer(CuePointStore* store, const SilenceDetector::Settings& settings)
+        : m_store(store)
+        , m_settings(settings)
+    {
+    }
+
+    void feed(const float* samples, qint64 count, int sampleRate, int channels) override
+    {
+        if (!m_detector) {
+            m_detector = std::make_unique<SilenceDetector>(sampleRate, channels, m_settings);
+            m_segue = std::make_unique<SegueDetector>(sampleRate, channels);
+        }
+        m_detector->feed(samples, count);
+        m_segue->feed(samples, count);
+    }
+
+    bool finish(QString* error) override
+    {
+        if (!m_detector) {
+            *error = "No audio was analyzed";
+            return false;
+        }
+        m_result = SilenceDetector::withSeguePoints(m_detector->result(), m_segue->result());
+        m_detector.reset();
+        m_segue.reset();
+        if (!m_result.valid) {
+            *error = "No cue points were found";
+        }
+        return m_result.valid;
+    }
+
+    QVariantMap columns() const override { return CuePointStore::toColumns(m_result.cue); }
+
+    void publish(const QString& filePath) override
+    {
+        if (m_store) {
+            m_store->setStoredCuePoints(filePath, m_result.cue);
+        }
+    }
+
+private:
+    QPointer<CuePointStore> m_store;
+    SilenceDetector::Settings m_settings;
+    std::unique_ptr<SilenceDetector> m_detector;
+    std::unique_ptr<SegueDetector> m_segue;
+    SilenceDetector::Result m_result;
+};
+
+class PeakAnalyzer : public AnalysisPipeline::Analyzer
+{
+public:
+    explicit PeakAnalyzer(const QString& peakPath)
+        : m_peakPath(peakPath)
+    {
+    }
+
+    void feed(const float* samples, qint64 count, int sampleRate, int channels) override
+    {
+        if (!m_builder) {
+            m_builder = std::make_unique<PeakFile::Builder>(sampleRate, channels);
+        }
+        m_builder->feed(samples, count);
+    }
+
+    bool finish(QString* error) override
+    {
+        if (!m_builder) {
+            *error = "No audio was analyzed";
+            return false;
+        }
+        const bool saved = m_builder->save(m_peakPath, error);
+        m_builder.reset();
+        return saved;
+    }
+
+private:
+    QString m_peakPath;
+    std::unique_ptr<PeakFile::Builder> m_builder;
+};
+
+} // namespace
+
+AnalysisPipeline::AnalysisPipeline(QSqlDatabase& database, QObject* parent)
+    : QObject(parent)
+    , m_database(database)
+    , m_decode([](const QString& filePath, int sampleRate, const PcmDecoder::Sink& sink,
+                  QString* error) { return PcmDecoder::decode(filePath, sampleRate, sink, error); })
+    , m_maxWorkers(qMax(1, QThread::idealThreadCount() - 1))
+{
+    m_pool.setThreadPriority(QThread::LowPriority);
+    m_pool.setMaxThreadCount(m_maxWorkers);
+}
+
+AnalysisPipeline::~AnalysisPipeline()
+{
+    m_queue.clear();
+    m_pool.waitForDone();
+}
+
+AnalysisPipeline::Factory AnalysisPipeline::loudness(ReplayGainStore* store)
+{
+    return [store](const QString&) { return std::make_unique<LoudnessAnalyzer>(store); };
+}
+
+AnalysisPipeline::Factory AnalysisPipeline::cuePoints(CuePointStore* store,
+                                                      const SilenceDetector::Settings& settings)
+{
+    return [store, settings](const QString&) {
+        return std::make_unique<CueAnalyzer>(store, settings);
+    };
+}
+
+AnalysisPipeline::Factory AnalysisPipeline::peaks(PeakFileGenerator* generator)
+{
+    QPointer<PeakFileGenerator> target(generator);
+    return [target](const QString& filePath) -> std::unique_ptr<Analyzer> {
+        if (!target || target->isCurrent(filePath)) {
+            return nullptr;
+        }
+        return std::make_unique<PeakAnalyzer>(target->peakPath(filePath));
+    };
+}
+
+void AnalysisPipeline::setMaxWorkers(int workers)
+{
+    m_maxWorkers = qMax(1, workers);
+    m_pool.setMaxThreadCount(m_maxWorkers);
+    schedule();
+}
+
+int AnalysisPipeline::scan(const QStringList& filePaths)
+{
+    const QSet<QString> waiting(m_queue.cbegin(), m_queue.cend());
+    int added = 0;
+    for (const QString& filePath : filePaths) {
+        if (filePath.isEmpty() || waiting.contains(filePath)) {
+            continue;
+        }
+        m_queue.append(filePath);
+        ++added;
+    }
+    if (added == 0) {
+        return 0;
+    }
+
+    m_total += added;
+    m_running = true;
+    schedule();
+    return added;
+}
+
+void AnalysisPipeline::cancel()
+{
+    if (!m_running) {
+        return;
+    }
+
+    m_queue.clear();
+    ++m_generation;
+    m_inFlight = 0;
+    finish();
+}
+
+void AnalysisPipeline::schedule()
+{
+    while (m_running && m_inFlight < m_maxWorkers && !m_queue.isEmpty()) {
+        Outcome outcome;
+        outcome.filePath = m_queue.takeFirst();
+        for (const Factory& factory : std::as_const(m_factories)) {
+            std::shared_ptr<Analyzer> analyzer = factory(outcome.filePath);
+            if (analyzer) {
+                outcome.analyzers.append(std::move(analyzer));
+            }
+        }
+        // Nothing to find out, so nothing to decode
+        if (outcome.analyzers.isEmpty()) {
+            ++m_analyzed;
+            emit progressChanged(m_analyzed + m_failed, m_total);
+            continue;
+        }
+        ++m_inFlight;
+
+        auto* watcher = new QFutureWatcher<Outcome>(this);
+        const int generation = m_generation;
+        connect(watcher, &QFutureWatcher<Outcome>::finished, this, [this, watcher, generation]() {
+            onAnalyzed(watcher->result(), generation);
+            watcher->deleteLater();
+        });
+        watcher->setFuture(QtConcurrent::run(
+            &m_pool, [decode = m_decode, sampleRate = m_sampleRate, outcome]() mutable {
+                BackgroundThrottle::lowerCurrentThread();
+                BackgroundThrottle::pace();
+                const auto fanOut = [&outcome](const float* samples, qint64 count, int rate,
+                                               int channels) {
+                    for (const auto& analyzer : std::as_const(outcome.analyzers)) {
+                        analyzer->feed(samples, count, rate, channels);
+                    }
+                };
+                outcome.decoded = decode(outcome.filePath, sampleRate, fanOut, &outcome.error);
+
+                QVector<std::shared_ptr<Analyzer>> finished;
+                for (const auto& analyzer : std::as_const(outcome.analyzers)) {
+                    QString error;
+                    if (outcome.decoded && analyzer->finish(&error)) {
+                        finished.append(analyzer);
+                    } else if (outcome.decoded) {
+                        qWarning() << QString("AnalysisPipeline::schedule - %1: %2")
+                                          .arg(outcome.filePath, error);
+                    }
+                }
+                outcome.analyzers = finished;
+                return outcome;
+            }));
+    }
+
+    if (m_running && m_inFlight == 0 && m_queue.isEmpty()) {
+        finish();
+    }
+}
+
+void AnalysisPipeline::onAnalyzed(const Outcome& outcome, int generation)
+{
+    if (generation != m_generation) {
+        return;
+    }
+    --m_inFlight;
+
+    if (outcome.decoded) {
+        ++m_analyzed;
+        m_done.append(outcome);
+        scheduleFlush();
+    } else {
+        ++m_failed;
+        qWarning() << QString("AnalysisPipeline::onAnalyzed - %1: %2")
+                          .arg(outcome.filePath, outcome.error);
+    }
+    emit progressChanged(m_analyzed + m_failed, m_total);
+    schedule();
+}
+
+bool AnalysisPipeline::flush()
+{
+    m_flushScheduled = false;
+    if (m_done.isEmpty()) {
+        return true;
+    }
+
+    // Whatever happens, these results are not tried again
+    const QList<Outcome> done = std::move(m_done);
+    m_done.clear();
+
+    if (!m_database.isOpen()) {
+        logError("flush", "Database is not open");
+        return false;
+    }
+    if (!m_database.transaction()) {
+        logError("flush",
+                 QString("Failed to start transaction: %1").arg(m_database.lastError().text()));
+        return false;
+    }
+
+    // One UPDATE per file; it is prepared again only when the set of columns differs
+    QSqlQuery update(m_database);
+    QString prepared;
+    for (const Outcome& outcome : done) {
+        QVariantMap columns;
+        for (const auto& analyzer : outcome.analyzers) {
+            columns.insert(analyzer->columns());
+        }
+        if (columns.isEmpty()) {
+            continue;
+        }
+
+        QStringList assignments;
+        for (auto it = columns.cbegin(); it != columns.cend(); ++it) {
+            assignments.append(it.key() + " = ?");
+        }
+        const QString sql =
+            QString("UPDATE musics SET %1 WHERE path = ?").arg(assignments.join(", "));
+        if (sql != prepared && !update.prepare(sql)) {
+            logError("flush", QString("SQL Error: %1 (Query: %2)")
+                                  .arg(update.lastError().text(), sql));
+            m_database.rollback();
+            return false;
+        }
+        prepared = sql;
+
+        for (const QVariant& value : std::as_const(columns)) {
+            update.addBindValue(value);
+        }
+        update.addBindValue(outcome.filePath);
+        if (!update.exec()) {
+            logError("flush", QString("SQL Error: %1 (Query: %2)")
+                                  .arg(update.lastError().text(), sql));
+            m_database.rollback();
+            return false;
+        }
+    }
+
+    if (!m_database.commit()) {
+        logError("flush", QString("Failed to commit: %1").arg(m_database.lastError().text()));
+        m_database.rollback();
+        return false;
+    }
+
+    for (const Outcome& outcome : done) {
+        for (const auto& analyzer : outcome.analyzers) {
+            analyzer->publish(outcome.filePath);
+        }
+        emit trackAnalyzed(outcome.filePath);
+    }
+    return true;
+}
+
+void AnalysisPipeline::scheduleFlush()
+{
+    if (m_flushScheduled) {
+        return;
+    }
+    m_flushScheduled = true;
+    QTimer::singleShot(0, this, [this]() { flush(); });
+}
+
+void AnalysisPipeline::finish()
+{
+    const int analyzed = m_analyzed;
+    const int failed = m_failed;
+    m_running = false;
+    m_total = 0;
+    m_analyzed = 0;
+    m_failed = 0;
+
+    flush();
+    qInfo() << "AnalysisPipeline: scan finished," << analyzed << "analyzed," << failed
+            << "failed";
+    emit finished(analyzed, failed);
+}
+
+void AnalysisPipeline::logError(const QString& operation, const QString& error)
+{
+    qWarning() << QString("AnalysisPipeline::%1 - %2").arg(operation, error);
+    emit operationError(operation, error);
+}
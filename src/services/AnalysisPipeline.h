@@ -0,0 +1,219 @@
+#ifndef ANALYSISPIPELINE_H
+#define ANALYSISPIPELINE_H
+
+#include "PcmDecoder.h"
+#include "SilenceDetector.h"
+#include <QList>
+#include <QObject>
+#include <QSqlDatabase>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVariantMap>
+#include <QVector>
+#include <functional>
+#include <memory>
+
+class CuePointStore;
+class PeakFileGenerator;
+class ReplayGainStore;
+
+/**
+ * @brief Decodes each library track once and runs every analysis over it
+ *
+ * Auto-Trim, the loudness analysis and the waveform peaks each decoded the
+ * whole library with a scanner of their own, so analyzing everything took
+ * three decodes of every file. AnalysisPipeline decodes a file once, on a
+ * low-priority pool of up to maxWorkers() threads, and hands each decoded
+ * block to all the analyzers of the file in turn: they read the decoder's
+ * buffer itself, nothing is copied.
+ *
+ * Analyzers are pluggable. A Factory makes one per file, on the pipeline's
+ * thread, or nullptr if the file needs nothing from it; a file that needs
+ * nothing from any of them is not decoded. loudness(), cuePoints() and
+ * peaks() wrap LoudnessMeter, SilenceDetector with SegueDetector, and
+ * PeakFile::Builder.
+ *
+ * The columns of every analyzer of a file go to the musics table in one
+ * UPDATE, and the files done in an event loop iteration share one
+ * transaction. Only then are the results published to the stores, which
+ * keep their copies in memory without writing them again.
+ *
+ * Like LoudnessScanner, only maxWorkers() files are handed to the pool at
+ * a time, so cancel() takes effect after the files being decoded; their
+ * results are dropped.
+ *
+ * @example
+ * @code
+ * AnalysisPipeline* pipeline = new AnalysisPipeline(db, this);
+ * pipeline->addAnalyzer(AnalysisPipeline::loudness(replayGain));
+ * pipeline->addAnalyzer(AnalysisPipeline::cuePoints(cueStore));
+ * pipeline->addAnalyzer(AnalysisPipeline::peaks(peakGenerator));
+ * pipeline->scan(allLibraryPaths);
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class AnalysisPipeline : public QObject
+{
+    Q_OBJECT
+
+public:
+    /// Rate the files are decoded at, enough for every analyzer
+    static constexpr int DEFAULT_SAMPLE_RATE = 48000;
+
+    /**
+     * @brief One analysis of one file
+     */
+    class Analyzer
+    {
+    public:
+        virtual ~Analyzer() = default;
+
+        /**
+         * @brief Analyze the next decoded block, on the pool thread
+         *
+         * The samples belong to the decoder and are only valid during the call.
+         * @param samples Interleaved float samples
+         * @param count Number of samples, a whole number of frames
+         */
+        virtual void feed(const float* samples, qint64 count, int sampleRate, int channels) = 0;
+
+        /**
+         * @brief Finish once the whole file was fed, on the pool thread
+         * @param error Receives the reason on failure
+         * @return false to leave the file's columns of this analyzer as they are
+         */
+        virtual bool finish(QString* error)
+        {
+            Q_UNUSED(error)
+            return true;
+        }
+
+        /**
+         * @brief Get the musics columns to set, on the pipeline's thread
+         */
+        virtual QVariantMap columns() const { return QVariantMap(); }
+
+        /**
+         * @brief Hand the result on once its columns are committed, on the pipeline's thread
+         */
+        virtual void publish(const QString& filePath) { Q_UNUSED(filePath) }
+    };
+
+    /// Makes the analyzer of a file, or nullptr if the file needs none
+    using Factory = std::function<std::unique_ptr<Analyzer>(const QString& filePath)>;
+
+    /// Runs on a pool thread; PcmDecoder::decode() unless replaced
+    using Decoder = std::function<bool(const QString& filePath, int sampleRate,
+                                       const PcmDecoder::Sink& sink, QString* error)>;
+
+    explicit AnalysisPipeline(QSqlDatabase& database, QObject* parent = nullptr);
+    ~AnalysisPipeline() override;
+
+    /**
+     * @brief Measure loudness, for ReplayGainStore; silent tracks are cleared
+     */
+    static Factory loudness(ReplayGainStore* store);
+
+    /**
+     * @brief Find the cue and segue points, for CuePointStore
+     */
+    static Factory cuePoints(
+        CuePointStore* store,
+        const SilenceDetector::Settings& settings = SilenceDetector::Settings());
+
+    /**
+     * @brief Write the peak files of the tracks that have no current one
+     */
+    static Factory peaks(PeakFileGenerator* generator);
+
+    void addAnalyzer(Factory factory) { m_factories.append(std::move(factory)); }
+    void setDecoder(Decoder decoder) { m_decode = std::move(decoder); }
+    void setSampleRate(int sampleRate) { m_sampleRate = qMax(8000, sampleRate); }
+
+    /**
+     * @brief Set how many files are decoded at once
+     * @param workers Worker count; one less than the number of cores by default
+     */
+    void setMaxWorkers(int workers);
+    int maxWorkers() const { return m_maxWorkers; }
+
+    /**
+     * @brief Add tracks to the scan and start it if it is not running
+     * @param filePaths Paths as stored in the musics table
+     * @return Number of tracks added; tracks already waiting are skipped
+     */
+    int scan(const QStringList& filePaths);
+
+    /**
+     * @brief Drop the tracks that have not been started
+     */
+    void cancel();
+
+    bool isRunning() const { return m_running; }
+
+    /**
+     * @brief Write the results of the tracks done so far and publish them
+     * @return true on success
+     */
+    bool flush();
+
+signals:
+    /**
+     * @brief Emitted when a track's results were stored
+     */
+    void trackAnalyzed(const QString& filePath);
+
+    /**
+     * @brief Emitted after each track
+     * @param done Tracks finished, including those that failed
+     * @param total Tracks in this scan
+     */
+    void progressChanged(int done, int total);
+
+    /**
+     * @brief Emitted when the last track of the scan is done, or after cancel()
+     * @param analyzed Tracks that were decoded and stored
+     * @param failed Tracks that could not be decoded
+     */
+    void finished(int analyzed, int failed);
+
+    /**
+     * @brief Emitted when the results cannot be written
+     */
+    void operationError(const QString& operation, const QString& error);
+
+private:
+    struct Outcome {
+        QString filePath;
+        QVector<std::shared_ptr<Analyzer>> analyzers;   ///< Those that finished
+        bool decoded = false;
+        QString error;
+    };
+
+    void schedule();
+    void onAnalyzed(const Outcome& outcome, int generation);
+    void scheduleFlush();
+    void finish();
+    void logError(const QString& operation, const QString& error);
+
+    QSqlDatabase& m_database;
+    QThreadPool m_pool;
+    QList<Factory> m_factories;
+    Decoder m_decode;
+    int m_sampleRate = DEFAULT_SAMPLE_RATE;
+    int m_maxWorkers;
+
+    QStringList m_queue;
+    QList<Outcome> m_done;       ///< Analyzed, not written yet
+    bool m_flushScheduled = false;
+    bool m_running = false;
+    int m_inFlight = 0;
+    int m_generation = 0;        ///< Bumped by cancel() so late results are dropped
+    int m_total = 0;
+    int m_analyzed = 0;
+    int m_failed = 0;
+};
+
+#endif // ANALYSISPIPELINE_H
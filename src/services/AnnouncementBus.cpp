@@ -0,0 +1,225 @@
+#include "AnnouncementBus.h"
+#include <QCoreApplication>
+#include <QThread>
+#include <QTimer>
+#include <algorithm>
+#include <limits>
+
+AnnouncementBus* AnnouncementBus::instance()
+{
+    static QPointer<AnnouncementBus> bus;
+    if (!bus) {
+        bus = new AnnouncementBus(QCoreApplication::instance());
+    }
+    return bus;
+}
+
+AnnouncementBus::AnnouncementBus(QObject* parent)
+    : QObject(parent)
+    , m_timer(new QTimer(this))
+{
+    m_timer->setSingleShot(true);
+    connect(m_timer, &QTimer::timeout, this, &AnnouncementBus::dispatch);
+}
+
+void AnnouncementBus::post(Announcement announcement)
+{
+    if (!announcement.deliver || !announcement.context || announcement.message.isEmpty()) {
+        return;
+    }
+    if (QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(
+            this, [this, announcement]() { post(announcement); }, Qt::QueuedConnection);
+        return;
+    }
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    announcement.postedAt = now;
+    ++m_statistics.posted;
+
+    if (announcement.priority == Priority::Critical) {
+        // Said now; anything of the region still waiting is out of date
+        m_pending.erase(std::remove_if(m_pending.begin(), m_pending.end(),
+                                       [&](const Announcement& pending) {
+                                           return !announcement.region.isEmpty()
+                                                  && pending.region == announcement.region;
+                                       }),
+                        m_pending.end());
+        deliver(announcement, now);
+        schedule();
+        return;
+    }
+
+    if (recentlyDelivered(announcement, now)) {
+        ++m_statistics.duplicates;
+        return;
+    }
+
+    for (Announcement& pending : m_pending) {
+        if (pending.region != announcement.region || pending.context != announcement.context) {
+            continue;
+        }
+        if (pending.message == announcement.message) {
+            pending.priority = std::max(pending.priority, announcement.priority);
+            ++m_statistics.duplicates;
+            return;
+        }
+        if (!announcement.region.isEmpty()) {
+            // Keeps its place in the queue and the higher of the two priorities
+            announcement.postedAt = pending.postedAt;
+            announcement.priority = std::max(pending.priority, announcement.priority);
+            pending = std::move(announcement);
+            ++m_statistics.coalesced;
+            schedule();
+            return;
+        }
+    }
+
+    if (int(m_pending.size()) >= MAX_PENDING) {
+        dropDeadContexts();
+    }
+    if (int(m_pending.size()) >= MAX_PENDING) {
+        // The oldest of the lowest priority makes room
+        auto victim = std::min_element(m_pending.begin(), m_pending.end(),
+                                       [](const Announcement& a, const Announcement& b) {
+                                           return a.priority < b.priority
+                                                  || (a.priority == b.priority
+                                                      && a.postedAt < b.postedAt);
+                                       });
+        if (victim->priority > announcement.priority) {
+            ++m_statistics.dropped;
+            return;
+        }
+        m_pending.erase(victim);
+        ++m_statistics.dropped;
+    }
+
+    m_pending.push_back(std::move(announcement));
+    schedule();
+}
+
+void AnnouncementBus::clear(const QObject* context, bool keepCritical)
+{
+    const auto old = m_pending.size();
+    m_pending.erase(std::remove_if(m_pending.begin(), m_pending.end(),
+                                   [&](const Announcement& pending) {
+                                       return pending.context == context
+                                              && !(keepCritical
+                                                   && pending.priority == Priority::Critical);
+                                   }),
+                    m_pending.end());
+    m_statistics.dropped += qint64(old - m_pending.size());
+    schedule();
+}
+
+void AnnouncementBus::clear(const QObject* context, const QString& region)
+{
+    const auto old = m_pending.size();
+    m_pending.erase(std::remove_if(m_pending.begin(), m_pending.end(),
+                                   [&](const Announcement& pending) {
+                                       return pending.context == context
+                                              && pending.region == region;
+                                   }),
+                    m_pending.end());
+    m_statistics.dropped += qint64(old - m_pending.size());
+    schedule();
+}
+
+int AnnouncementBus::pendingCount(const QObject* context) const
+{
+    if (!context) {
+        return int(m_pending.size());
+    }
+    return int(std::count_if(m_pending.begin(), m_pending.end(),
+                             [&](const Announcement& pending) {
+                                 return pending.context == context;
+                             }));
+}
+
+bool AnnouncementBus::isArmed() const
+{
+    return m_timer->isActive();
+}
+
+void AnnouncementBus::deliver(const Announcement& announcement, qint64 now)
+{
+    RegionState& region = m_regions[announcement.region];
+    region.deliveredAt = now;
+    region.message = announcement.message;
+    m_lastDeliveryAt = now;
+    ++m_statistics.delivered;
+
+    announcement.deliver(announcement);
+    emit announcementDelivered(announcement.region, announcement.message, announcement.priority);
+}
+
+void AnnouncementBus::dispatch()
+{
+    dropDeadContexts();
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+    // Highest priority first, then the oldest, among those that are due
+    auto next = m_pending.end();
+    for (auto it = m_pending.begin(); it != m_pending.end(); ++it) {
+        if (dueAt(*it) > now) {
+            continue;
+        }
+        if (next == m_pending.end() || it->priority > next->priority
+            || (it->priority == next->priority && it->postedAt < next->postedAt)) {
+            next = it;
+        }
+    }
+
+    if (next != m_pending.end()) {
+        const Announcement announcement = std::move(*next);
+        m_pending.erase(next);
+        // A context may be gone by the time its turn comes around
+        if (announcement.context) {
+            deliver(announcement, now);
+        }
+    }
+    schedule();
+}
+
+void AnnouncementBus::schedule()
+{
+    if (m_pending.empty()) {
+        m_timer->stop();
+        return;
+    }
+    qint64 earliest = std::numeric_limits<qint64>::max();
+    for (const Announcement& pending : m_pending) {
+        earliest = std::min(earliest, dueAt(pending));
+    }
+    const qint64 delay = std::max<qint64>(0, earliest - QDateTime::currentMSecsSinceEpoch());
+    m_timer->start(int(std::min<qint64>(delay, std::numeric_limits<int>::max())));
+}
+
+void AnnouncementBus::dropDeadContexts()
+{
+    const auto old = m_pending.size();
+    m_pending.erase(std::remove_if(m_pending.begin(), m_pending.end(),
+                                   [](const Announcement& pending) { return !pending.context; }),
+                    m_pending.end());
+    m_statistics.dropped += qint64(old - m_pending.size());
+}
+
+qint64 AnnouncementBus::dueAt(const Announcement& announcement) const
+{
+    qint64 due = std::max({announcement.postedAt, announcement.notBefore,
+                           m_lastDeliveryAt + MIN_SPACING_MS});
+    if (!announcement.region.isEmpty() && announcement.throttleMs > 0) {
+        const auto region = m_regions.constFind(announcement.region);
+        if (region != m_regions.constEnd()) {
+            due = std::max(due, region->deliveredAt + announcement.throttleMs);
+        }
+    }
+    return due;
+}
+
+bool AnnouncementBus::recentlyDelivered(const Announcement& announcement, qint64 now) const
+{
+    const auto region = m_regions.constFind(announcement.region);
+    return region != m_regions.constEnd() && region->message == announcement.message
+           && now - region->deliveredAt < DUPLICATE_WINDOW_MS;
+}
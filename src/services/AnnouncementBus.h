@@ -0,0 +1,153 @@
+#ifndef ANNOUNCEMENTBUS_H
+#define ANNOUNCEMENTBUS_H
+
+#include <QDateTime>
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <functional>
+#include <vector>
+
+class QTimer;
+
+/**
+ * @brief One queue for everything the accessibility services say
+ *
+ * AccessibilityManager, LiveRegionManager, SystemStatusAnnouncer and
+ * AudioFeedbackService each drained a queue of their own from a timer
+ * that ran all the time, waking the GUI thread several times a second
+ * with nothing to say. They now post to this bus, which keeps one timer
+ * and arms it only for the moment the next announcement is due.
+ *
+ * Announcements wait in priority order, oldest first within a priority,
+ * and are handed out MIN_SPACING_MS apart so a screen reader can finish
+ * one before the next arrives. On top of that:
+ * - messages of the same region replace each other while they wait, so
+ *   a burst of progress updates is spoken as its latest value;
+ * - a message already waiting, or given to its region less than
+ *   DUPLICATE_WINDOW_MS ago, is dropped;
+ * - a region is given at most one message per throttleMs, which each
+ *   poster sets for the kind of message it sends;
+ * - Critical messages are delivered at once, past all of the above.
+ *
+ * Announcements without a region are never merged with one another.
+ * Each carries the object that posted it; when that object is destroyed
+ * its announcements are dropped, and clear() drops them on request.
+ *
+ * The bus lives on the GUI thread; posts from other threads are queued
+ * to it.
+ *
+ * @example
+ * @code
+ * AnnouncementBus::Announcement announcement;
+ * announcement.region = "database-progress";
+ * announcement.message = tr("Import 40% done");
+ * announcement.throttleMs = 5000;
+ * announcement.context = this;
+ * announcement.deliver = [this](const AnnouncementBus::Announcement& a) { speak(a.message); };
+ * AnnouncementBus::instance()->post(announcement);
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class AnnouncementBus : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class Priority {
+        Low,
+        Normal,
+        High,
+        Critical
+    };
+
+    struct Announcement {
+        QString region;                ///< Merge key; empty for messages that stand alone
+        QString message;
+        Priority priority = Priority::Normal;
+        int throttleMs = 0;            ///< Least time between two messages of the region
+        qint64 notBefore = 0;          ///< Earliest delivery, epoch milliseconds; 0 for any
+        QPointer<QObject> context;     ///< Poster, required; its announcements go with it
+        std::function<void(const Announcement&)> deliver;
+        qint64 postedAt = 0;           ///< Set by post(), epoch milliseconds
+    };
+
+    struct Statistics {
+        qint64 posted = 0;
+        qint64 delivered = 0;
+        qint64 coalesced = 0;    ///< Replaced by a newer message of their region
+        qint64 duplicates = 0;   ///< The same text as one waiting or just given
+        qint64 dropped = 0;      ///< Pushed out of a full queue, or cleared
+    };
+
+    static constexpr int MIN_SPACING_MS = 100;
+    static constexpr int DUPLICATE_WINDOW_MS = 2000;
+    static constexpr int MAX_PENDING = 50;
+
+    /**
+     * @brief The bus of the application, made on first use; call it first on the GUI thread
+     */
+    static AnnouncementBus* instance();
+
+    explicit AnnouncementBus(QObject* parent = nullptr);
+
+    /**
+     * @brief Queue an announcement, or deliver it now if it is Critical
+     * @param announcement What to say; context and deliver must be set
+     */
+    void post(Announcement announcement);
+
+    /**
+     * @brief Drop the waiting announcements of one poster
+     * @param context The poster
+     * @param keepCritical Keep those of Critical priority
+     */
+    void clear(const QObject* context, bool keepCritical = false);
+
+    /**
+     * @brief Drop what one poster has waiting in one region
+     */
+    void clear(const QObject* context, const QString& region);
+
+    /**
+     * @brief Waiting announcements, of one poster or of all when null
+     */
+    int pendingCount(const QObject* context = nullptr) const;
+
+    Statistics statistics() const { return m_statistics; }
+
+    /**
+     * @brief Whether a timer is armed; false whenever nothing is waiting
+     */
+    bool isArmed() const;
+
+signals:
+    /**
+     * @brief Emitted after an announcement was delivered
+     */
+    void announcementDelivered(const QString& region, const QString& message,
+                               AnnouncementBus::Priority priority);
+
+private:
+    void deliver(const Announcement& announcement, qint64 now);
+    void dispatch();
+    void schedule();
+    void dropDeadContexts();
+    qint64 dueAt(const Announcement& announcement) const;
+    bool recentlyDelivered(const Announcement& announcement, qint64 now) const;
+
+    struct RegionState {
+        qint64 deliveredAt = 0;
+        QString message;
+    };
+
+    std::vector<Announcement> m_pending;
+    QHash<QString, RegionState> m_regions;
+    qint64 m_lastDeliveryAt = 0;
+    QTimer* m_timer;
+    Statistics m_statistics;
+};
+
+#endif // ANNOUNCEMENTBUS_H
@@ -0,0 +1,242 @@
+#include "ArchiveRetention.h"
+#include "BackgroundThrottle.h"
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSet>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QThread>
+#include <QVariant>
+#include <QtConcurrent/QtConcurrent>
+#include <algorithm>
+
+namespace {
+
+QString cleanedPath(const QString& path)
+{
+    return QDir::cleanPath(QFileInfo(path).absoluteFilePath());
+}
+
+} // namespace
+
+ArchiveRetention::ArchiveRetention(QSqlDatabase& database, QObject* parent)
+    : QObject(parent)
+    , m_database(database)
+    , m_cancelled(std::make_shared<std::atomic_bool>(false))
+{
+    m_pool.setThreadPriority(QThread::LowPriority);
+    m_pool.setMaxThreadCount(1);
+}
+
+ArchiveRetention::~ArchiveRetention()
+{
+    // Files already removed still have their rows deleted
+    if (m_running) {
+        *m_cancelled = true;
+        m_pool.waitForDone();
+        Run run = m_watcher->result();
+        forget(run.removals, &run.report);
+    }
+}
+
+QList<QFileInfo> ArchiveRetention::expired(QList<QFileInfo> files, const Policy& policy,
+                                           const QDateTime& now)
+{
+    std::sort(files.begin(), files.end(), [](const QFileInfo& a, const QFileInfo& b) {
+        return a.lastModified() > b.lastModified();
+    });
+
+    // Newest first: a file stays while it is recent enough and fits the count and the quota
+    const QDateTime cutoff = now.addDays(-policy.maxAgeDays);
+    QList<QFileInfo> removed;
+    int keptCount = 0;
+    qint64 keptBytes = 0;
+    bool full = false;
+    for (const QFileInfo& file : std::as_const(files)) {
+        full = full || (policy.maxCount > 0 && keptCount >= policy.maxCount) ||
+               (policy.maxBytes > 0 && keptBytes + file.size() > policy.maxBytes);
+        if (full || (policy.maxAgeDays > 0 && file.lastModified() < cutoff)) {
+            removed.prepend(file);
+            continue;
+        }
+        ++keptCount;
+        keptBytes += file.size();
+    }
+    return removed;
+}
+
+bool ArchiveRetention::start()
+{
+    QList<Policy> policies;
+    for (const Policy& policy : std::as_const(m_policies)) {
+        if (policy.isEnabled()) {
+            policies.append(policy);
+        }
+    }
+    if (m_running || policies.isEmpty()) {
+        return false;
+    }
+
+    QSet<QString> inUse;
+    if (m_inUse) {
+        for (const QString& path : m_inUse()) {
+            inUse.insert(cleanedPath(path));
+        }
+    }
+
+    m_running = true;
+    m_cancelled = std::make_shared<std::atomic_bool>(false);
+    m_watcher = new QFutureWatcher<Run>(this);
+    connect(m_watcher, &QFutureWatcher<Run>::finished, this, [this]() {
+        QFutureWatcher<Run>* watcher = m_watcher;
+        m_watcher = nullptr;
+        complete(watcher->result());
+        watcher->deleteLater();
+    });
+    m_watcher->setFuture(QtConcurrent::run(&m_pool, [policies, inUse,
+                                                     cancelled = m_cancelled]() {
+        BackgroundThrottle::lowerCurrentThread();
+        QElapsedTimer timer;
+        timer.start();
+        const QDateTime now = QDateTime::currentDateTime();
+
+        Run run;
+        int inBatch = UNLINK_BATCH;
+        for (const Policy& policy : policies) {
+            const QDir directory(policy.directory);
+            if (*cancelled) {
+                break;
+            }
+            if (!directory.exists()) {
+                qWarning() << "ArchiveRetention: folder" << policy.directory << "does not exist";
+                continue;
+            }
+            const QList<QFileInfo> files =
+                directory.entryInfoList(policy.nameFilters, QDir::Files | QDir::NoDotAndDotDot);
+            ++run.report.folders;
+            run.report.files += files.size();
+
+            Removal removal;
+            removal.table = policy.table;
+            for (const QFileInfo& file : expired(files, policy, now)) {
+                const QString path = QDir::cleanPath(file.absoluteFilePath());
+                if (inUse.contains(path)) {
+                    continue;
+                }
+                if (inBatch == UNLINK_BATCH) {
+                    BackgroundThrottle::pace(cancelled.get());
+                    inBatch = 0;
+                }
+                if (*cancelled) {
+                    break;
+                }
+                ++inBatch;
+                if (QFile::remove(path)) {
+                    ++run.report.removed;
+                    run.report.freedBytes += file.size();
+                    removal.paths.append(path);
+                } else {
+                    ++run.report.failed;
+                    qWarning() << "ArchiveRetention: cannot remove" << path;
+                }
+            }
+            if (!removal.paths.isEmpty()) {
+                run.removals.append(removal);
+            }
+        }
+        run.report.cancelled = *cancelled;
+        run.report.elapsedMs = timer.elapsed();
+        return run;
+    }));
+    return true;
+}
+
+void ArchiveRetention::cancel()
+{
+    *m_cancelled = true;
+}
+
+void ArchiveRetention::complete(Run run)
+{
+    forget(run.removals, &run.report);
+    m_running = false;
+    qInfo() << "ArchiveRetention: removed" << run.report.removed << "of" << run.report.files
+            << "files," << run.report.freedBytes / (1024 * 1024) << "MB, and"
+            << run.report.rows << "rows in" << run.report.elapsedMs << "ms";
+    emit finished(run.report);
+}
+
+bool ArchiveRetention::forget(const QList<Removal>& removals, Report* report)
+{
+    const bool tracked = std::any_of(removals.cbegin(), removals.cend(), [](const Removal& r) {
+        return !r.table.isEmpty();
+    });
+    if (!tracked) {
+        return true;
+    }
+    if (!m_database.isOpen()) {
+        logError("forget", "Database is not open");
+        return false;
+    }
+    if (!m_database.transaction()) {
+        logError("forget",
+                 QString("Failed to start transaction: %1").arg(m_database.lastError().text()));
+        return false;
+    }
+
+    // The tables hold the paths as they were written, so they are compared cleaned
+    int rows = 0;
+    for (const Removal& removal : removals) {
+        if (removal.table.isEmpty()) {
+            continue;
+        }
+        const QSet<QString> removed(removal.paths.cbegin(), removal.paths.cend());
+        QSqlQuery select(m_database);
+        select.setForwardOnly(true);
+        QSqlQuery remove(m_database);
+        const QString deleteSql = QString("DELETE FROM %1 WHERE id = ?").arg(removal.table);
+        if (!select.exec(QString("SELECT id, path FROM %1").arg(removal.table)) ||
+            !remove.prepare(deleteSql)) {
+            const QSqlError error = select.lastError().isValid() ? select.lastError()
+                                                                 : remove.lastError();
+            logError("forget", QString("SQL Error: %1 (Table: %2)")
+                                   .arg(error.text(), removal.table));
+            m_database.rollback();
+            return false;
+        }
+        QVariantList ids;
+        while (select.next()) {
+            if (removed.contains(cleanedPath(select.value(1).toString()))) {
+                ids.append(select.value(0));
+            }
+        }
+        select.finish();
+
+        for (const QVariant& id : std::as_const(ids)) {
+            remove.addBindValue(id);
+            if (!remove.exec()) {
+                logError("forget", QString("SQL Error: %1 (Query: %2)")
+                                       .arg(remove.lastError().text(), deleteSql));
+                m_database.rollback();
+                return false;
+            }
+            ++rows;
+        }
+    }
+
+    if (!m_database.commit()) {
+        logError("forget", QString("Failed to commit: %1").arg(m_database.lastError().text()));
+        m_database.rollback();
+        return false;
+    }
+    report->rows += rows;
+    return true;
+}
+
+void ArchiveRetention::logError(const QString& operation, const QString& error)
+{
+    qWarning() << QString("ArchiveRetention::%1 - %2").arg(operation, error);
+    emit operationError(operation, error);
+}
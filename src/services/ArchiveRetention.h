@@ -0,0 +1,161 @@
+#ifndef ARCHIVERETENTION_H
+#define ARCHIVERETENTION_H
+
+#include <QDateTime>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QList>
+#include <QMetaType>
+#include <QObject>
+#include <QSqlDatabase>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+/**
+ * @brief Removes old files from archive folders by age, count and size
+ *
+ * Programs pile up under ProgramsPath until someone deletes them by hand,
+ * and deleting a folder's worth of files from the window froze it for the
+ * time of the listing and the unlinks. ArchiveRetention applies a Policy
+ * per folder on a low-priority pool thread: files older than maxAgeDays
+ * go, then whatever is beyond the newest maxCount files or the newest
+ * maxBytes. Files are removed UNLINK_BATCH at a time, and the thread gives
+ * way to BackgroundThrottle between batches.
+ *
+ * Nothing that is in use is removed: the paths from the InUse provider,
+ * read on the owner thread when a run starts, are left alone, whatever the
+ * policy says.
+ *
+ * A policy may name the table its files are listed in, such as programs.
+ * The rows of the files removed are deleted from it in one transaction
+ * once the files are gone, so the table never lists a file that is not
+ * there for longer than a run takes.
+ *
+ * @example
+ * @code
+ * ArchiveRetention::Policy programs;
+ * programs.directory = ProgramsPath;
+ * programs.maxAgeDays = 90;
+ * programs.maxBytes = 20LL * 1024 * 1024 * 1024;
+ * programs.table = "programs";
+ * retention->setPolicies({programs});
+ * retention->start();
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class ArchiveRetention : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int UNLINK_BATCH = 64;   ///< Files removed between two pauses
+
+    /**
+     * @brief What one folder keeps; every limit at 0 keeps everything
+     */
+    struct Policy {
+        QString directory;
+        QStringList nameFilters;   ///< Wildcards of the files concerned; empty for all
+        int maxAgeDays = 0;        ///< Files older than this go; 0 for no age limit
+        int maxCount = 0;          ///< Newest files kept; 0 for no limit
+        qint64 maxBytes = 0;       ///< Total size of the newest files kept; 0 for no quota
+        QString table;             ///< Table whose path column lists the files, or empty
+
+        bool isEnabled() const
+        {
+            return !directory.isEmpty() && (maxAgeDays > 0 || maxCount > 0 || maxBytes > 0);
+        }
+    };
+
+    /**
+     * @brief Outcome of a run
+     */
+    struct Report {
+        int folders = 0;          ///< Folders that were listed
+        int files = 0;            ///< Files found in them
+        int removed = 0;          ///< Files removed
+        qint64 freedBytes = 0;
+        int failed = 0;           ///< Files that could not be removed
+        int rows = 0;             ///< Table rows of the removed files deleted
+        bool cancelled = false;
+        qint64 elapsedMs = 0;
+    };
+
+    /// Paths, as the tables and the queue hold them, that must stay
+    using InUse = std::function<QStringList()>;
+
+    explicit ArchiveRetention(QSqlDatabase& database, QObject* parent = nullptr);
+    ~ArchiveRetention() override;
+
+    void setPolicies(const QList<Policy>& policies) { m_policies = policies; }
+    QList<Policy> policies() const { return m_policies; }
+    void setInUse(InUse inUse) { m_inUse = std::move(inUse); }
+
+    /**
+     * @brief Apply the policies in the background
+     * @return false if a run is going on or no policy is enabled
+     */
+    bool start();
+
+    /**
+     * @brief Stop removing files after the current batch
+     *
+     * The rows of the files already removed are still deleted.
+     */
+    void cancel();
+
+    bool isRunning() const { return m_running; }
+
+    /**
+     * @brief Pick the files a policy removes
+     * @param files Files of the folder, in any order
+     * @param policy Limits to apply
+     * @param now Time the ages are counted from
+     * @return The files to remove, oldest first
+     */
+    static QList<QFileInfo> expired(QList<QFileInfo> files, const Policy& policy,
+                                    const QDateTime& now);
+
+signals:
+    /**
+     * @brief Emitted when a run is over, cancelled or not
+     */
+    void finished(const ArchiveRetention::Report& report);
+
+    /**
+     * @brief Emitted when the table rows cannot be deleted
+     */
+    void operationError(const QString& operation, const QString& error);
+
+private:
+    struct Removal {
+        QString table;
+        QStringList paths;   ///< Cleaned absolute paths of the files removed
+    };
+
+    struct Run {
+        Report report;
+        QList<Removal> removals;
+    };
+
+    void complete(Run run);
+    bool forget(const QList<Removal>& removals, Report* report);
+    void logError(const QString& operation, const QString& error);
+
+    QSqlDatabase& m_database;
+    QThreadPool m_pool;
+    QList<Policy> m_policies;
+    InUse m_inUse;
+    bool m_running = false;
+    QFutureWatcher<Run>* m_watcher = nullptr;        ///< Of the run going on
+    std::shared_ptr<std::atomic_bool> m_cancelled;   ///< Set by cancel(); one per run
+};
+
+Q_DECLARE_METATYPE(ArchiveRetention::Report)
+
+#endif // ARCHIVERETENTION_H
@@ -0,0 +1,141 @@
+#include "AudioBroadcastBuffer.h"
+#include <cstring>
+
+AudioBroadcastBuffer::AudioBroadcastBuffer(int capacitySamples, int frameSamples)
+{
+    resize(capacitySamples, frameSamples);
+}
+
+void AudioBroadcastBuffer::resize(int capacitySamples, int frameSamples)
+{
+    m_frameSamples = qMax(1, frameSamples);
+    const int capacity = qMax(0, capacitySamples) / m_frameSamples * m_frameSamples;
+    m_buffer.assign(static_cast<size_t>(capacity), 0.0f);
+    m_writePos.store(0, std::memory_order_relaxed);
+    for (Cursor& cursor : m_cursors) {
+        cursor.open.store(false, std::memory_order_relaxed);
+        cursor.position.store(0, std::memory_order_relaxed);
+        cursor.dropped.store(0, std::memory_order_relaxed);
+    }
+}
+
+void AudioBroadcastBuffer::write(const float* data, int samples)
+{
+    const int cap = capacity();
+    if (cap == 0 || samples <= 0) {
+        return;
+    }
+
+    // More than the buffer holds: only the newest part can ever be read
+    const quint64 writePos = m_writePos.load(std::memory_order_relaxed);
+    quint64 position = writePos;
+    if (samples > cap) {
+        const int skipped = (samples - cap) / m_frameSamples * m_frameSamples;
+        data += skipped;
+        samples -= skipped;
+        position += quint64(skipped);
+    }
+
+    const int start = static_cast<int>(position % quint64(cap));
+    const int first = qMin(samples, cap - start);
+    std::memcpy(m_buffer.data() + start, data, sizeof(float) * size_t(first));
+    if (samples > first) {
+        std::memcpy(m_buffer.data(), data + first, sizeof(float) * size_t(samples - first));
+    }
+
+    m_writePos.store(position + quint64(samples), std::memory_order_release);
+}
+
+int AudioBroadcastBuffer::openReader()
+{
+    for (int i = 0; i < MAX_READERS; ++i) {
+        Cursor& cursor = m_cursors[i];
+        if (!cursor.open.load(std::memory_order_relaxed)) {
+            cursor.position.store(m_writePos.load(std::memory_order_acquire),
+                                  std::memory_order_relaxed);
+            cursor.dropped.store(0, std::memory_order_relaxed);
+            cursor.open.store(true, std::memory_order_release);
+            return i;
+        }
+    }
+    return -1;
+}
+
+void AudioBroadcastBuffer::closeReader(int reader)
+{
+    if (reader >= 0 && reader < MAX_READERS) {
+        m_cursors[reader].open.store(false, std::memory_order_release);
+    }
+}
+
+int AudioBroadcastBuffer::readerCount() const
+{
+    int count = 0;
+    for (const Cursor& cursor : m_cursors) {
+        if (cursor.open.load(std::memory_order_acquire)) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+bool AudioBroadcastBuffer::isValid(int reader) const
+{
+    return reader >= 0 && reader < MAX_READERS &&
+           m_cursors[reader].open.load(std::memory_order_acquire);
+}
+
+int AudioBroadcastBuffer::availableToRead(int reader) const
+{
+    if (!isValid(reader)) {
+        return 0;
+    }
+    const quint64 writePos = m_writePos.load(std::memory_order_acquire);
+    const quint64 readPos = m_cursors[reader].position.load(std::memory_order_relaxed);
+    return static_cast<int>(qMin<quint64>(writePos - readPos, quint64(capacity())));
+}
+
+int AudioBroadcastBuffer::read(int reader, float* data, int samples)
+{
+    const int cap = capacity();
+    if (cap == 0 || samples <= 0 || !isValid(reader)) {
+        return 0;
+    }
+
+    Cursor& cursor = m_cursors[reader];
+    quint64 readPos = cursor.position.load(std::memory_order_relaxed);
+    const quint64 writePos = m_writePos.load(std::memory_order_acquire);
+
+    // Lapped: the oldest unread samples were overwritten. Jump to the newest
+    // half, which the writer will not reach before this read is done
+    if (writePos - readPos > quint64(cap)) {
+        const quint64 resume = writePos - quint64(cap / 2 / m_frameSamples * m_frameSamples);
+        cursor.dropped.fetch_add(qint64(resume - readPos), std::memory_order_relaxed);
+        readPos = resume;
+    }
+
+    const int wanted = samples / m_frameSamples * m_frameSamples;
+    const int toRead = static_cast<int>(qMin<quint64>(quint64(wanted), writePos - readPos));
+    if (toRead <= 0) {
+        cursor.position.store(readPos, std::memory_order_relaxed);
+        return 0;
+    }
+
+    const int start = static_cast<int>(readPos % quint64(cap));
+    const int first = qMin(toRead, cap - start);
+    std::memcpy(data, m_buffer.data() + start, sizeof(float) * size_t(first));
+    if (toRead > first) {
+        std::memcpy(data + first, m_buffer.data(), sizeof(float) * size_t(toRead - first));
+    }
+
+    cursor.position.store(readPos + quint64(toRead), std::memory_order_relaxed);
+    return toRead;
+}
+
+qint64 AudioBroadcastBuffer::dropped(int reader) const
+{
+    if (reader < 0 || reader >= MAX_READERS) {
+        return 0;
+    }
+    return m_cursors[reader].dropped.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,127 @@
+#ifndef AUDIOBROADCASTBUFFER_H
+#define AUDIOBROADCASTBUFFER_H
+
+#include <QtGlobal>
+#include <array>
+#include <atomic>
+#include <vector>
+
+/**
+ * @brief Single-producer/multi-consumer buffer of float samples
+ *
+ * AudioBroadcastBuffer hands one stream of interleaved float samples to
+ * several readers without copying it for each. Every reader has its own
+ * position in the same buffer, so a recorder, a stream encoder and a meter
+ * read the audio of one capture at their own pace.
+ *
+ * The writer never waits for a reader. A reader that falls more than the
+ * capacity behind is moved forward to the newest half of the buffer, and
+ * the samples it skipped are counted in dropped(). Positions move in whole
+ * frames, so a reader that was skipped forward keeps its channels in order.
+ *
+ * write() and read() never block and never allocate. write() may run on
+ * one thread, and each reader on one thread of its own. resize() is not
+ * thread-safe. openReader() and closeReader() may be called while writing,
+ * from one controlling thread.
+ *
+ * @example
+ * @code
+ * AudioBroadcastBuffer buffer(48000 * 2 * 30, 2);   // 30 s of 48 kHz stereo
+ * const int recorder = buffer.openReader();
+ * const int stream = buffer.openReader();
+ * buffer.write(captured, count);                    // capture thread
+ * int got = buffer.read(recorder, out, 1024);       // recorder thread
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class AudioBroadcastBuffer
+{
+public:
+    static constexpr int MAX_READERS = 8;
+
+    /**
+     * @param capacitySamples Capacity in samples
+     * @param frameSamples Samples per frame, such as the channel count
+     */
+    explicit AudioBroadcastBuffer(int capacitySamples = 0, int frameSamples = 1);
+
+    /**
+     * @brief Reallocate the buffer, discarding its contents and closing the readers
+     * @param capacitySamples New capacity in samples, rounded down to whole frames
+     * @param frameSamples Samples per frame
+     */
+    void resize(int capacitySamples, int frameSamples = 1);
+
+    int capacity() const { return static_cast<int>(m_buffer.size()); }
+    int frameSamples() const { return m_frameSamples; }
+
+    /**
+     * @brief Write samples, overwriting the oldest ones if a reader is behind
+     * @param data Source samples, whole frames
+     * @param samples Number of samples
+     */
+    void write(const float* data, int samples);
+
+    /**
+     * @brief Get how many samples were written since resize()
+     * @return Total sample count
+     */
+    quint64 written() const { return m_writePos.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Add a reader; it starts at the newest sample
+     * @return Reader ID, or -1 if MAX_READERS are open
+     */
+    int openReader();
+
+    /**
+     * @brief Remove a reader
+     * @param reader Reader ID; its slot may be handed out again
+     */
+    void closeReader(int reader);
+
+    /**
+     * @brief Get how many readers are open
+     */
+    int readerCount() const;
+
+    /**
+     * @brief Get how many samples a reader has not read yet
+     * @param reader Reader ID
+     * @return Sample count, at most the capacity
+     */
+    int availableToRead(int reader) const;
+
+    /**
+     * @brief Read samples for a reader
+     * @param reader Reader ID
+     * @param data Destination for the samples
+     * @param samples Maximum number of samples to read
+     * @return Number of samples read, whole frames
+     */
+    int read(int reader, float* data, int samples);
+
+    /**
+     * @brief Get how many samples a reader lost by falling behind
+     * @param reader Reader ID
+     * @return Samples skipped since openReader()
+     */
+    qint64 dropped(int reader) const;
+
+private:
+    struct Cursor {
+        std::atomic<bool> open{false};
+        std::atomic<quint64> position{0};
+        std::atomic<qint64> dropped{0};
+    };
+
+    bool isValid(int reader) const;
+
+    std::vector<float> m_buffer;
+    int m_frameSamples = 1;
+    std::atomic<quint64> m_writePos{0};
+    std::array<Cursor, MAX_READERS> m_cursors;
+};
+
+#endif // AUDIOBROADCASTBUFFER_H
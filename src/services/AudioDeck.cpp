@@ -0,0 +1,360 @@
+#include "AudioDeck.h"
+#include "MediaProbe.h"
+#include "TrackPrefetcher.h"
+#include <QAudioBuffer>
+#include <QAudioFormat>
+#include <QDebug>
+#include <QUrl>
+
+AudioDeck::AudioDeck(int sampleRate, QObject* parent)
+    : QObject(parent)
+    , m_sampleRate(sampleRate)
+    , m_ring(sampleRate * CHANNELS * RING_SECONDS)
+{
+}
+
+AudioDeck::~AudioDeck()
+{
+    unload();
+}
+
+void AudioDeck::load(const QString& filePath, qint64 startMs, qint64 endMs, float gain)
+{
+    unload();
+
+    m_source = filePath;
+    m_gain = gain;
+    m_loaded = true;
+    m_startFrame = qMax<qint64>(0, startMs) * m_sampleRate / 1000;
+    m_skipFrames = m_startFrame;
+    // A seek past the cue-out point plays on to the end of the file
+    const qint64 endFrame = endMs >= 0 ? endMs * m_sampleRate / 1000 : -1;
+    m_endFrame = endFrame > m_startFrame ? endFrame : -1;
+
+    if (loadMapped(filePath)) {
+        return;
+    }
+
+    qint64 probedUs = MediaProbe::durationUs(filePath);
+    m_expectedFrames = probedUs > 0 ? probedUs * m_sampleRate / 1000000 : -1;
+
+    QAudioFormat format;
+    format.setSampleRate(m_sampleRate);
+    format.setChannelCount(CHANNELS);
+    format.setSampleFormat(QAudioFormat::Float);
+
+    // A fresh decoder per track keeps late signals from the previous file
+    // from being attributed to this one
+    m_decoder = new QAudioDecoder(this);
+    m_decoder->setAudioFormat(format);
+
+    std::unique_ptr<QIODevice> prefetched;
+    if (m_prefetcher) {
+        prefetched =
+            m_borrowPrefetch ? m_prefetcher->borrow(filePath) : m_prefetcher->take(filePath);
+    }
+    if (prefetched) {
+        // The device is owned by the decoder so it lives exactly as long as it is read
+        QIODevice* device = prefetched.release();
+        device->setParent(m_decoder);
+        m_decoder->setSourceDevice(device);
+    } else {
+        m_decoder->setSource(QUrl::fromLocalFile(filePath));
+    }
+    connect(m_decoder, &QAudioDecoder::bufferReady, this, &AudioDeck::onBufferReady);
+    connect(m_decoder, &QAudioDecoder::finished, this, &AudioDeck::onFinished);
+    connect(m_decoder, QOverload<QAudioDecoder::Error>::of(&QAudioDecoder::error), this,
+            &AudioDeck::onError);
+    m_decoder->start();
+}
+
+bool AudioDeck::loadMapped(const QString& filePath)
+{
+    if (!filePath.endsWith(".wav", Qt::CaseInsensitive) || !m_wav.open(filePath)) {
+        return false;
+    }
+
+    // The header gives the exact length, and a seek is a jump to the frame
+    const qint64 fileRate = m_wav.format().sampleRate();
+    m_expectedFrames = m_wav.frames() * m_sampleRate / fileRate;
+    m_wavFrame = qMin(m_startFrame * fileRate / m_sampleRate, m_wav.frames());
+    m_framesDecoded = m_startFrame;
+    m_skipFrames = 0;
+    // Reading the head in warmed the page cache the mapping reads from; the copy is not needed
+    if (m_prefetcher && !m_borrowPrefetch) {
+        m_prefetcher->take(filePath);
+    }
+    pump();
+    return true;
+}
+
+void AudioDeck::unload()
+{
+    if (m_decoder) {
+        m_decoder->disconnect(this);
+        m_decoder->stop();
+        m_decoder->deleteLater();
+        m_decoder = nullptr;
+    }
+    m_wav.close();
+    m_wavFrame = 0;
+
+    m_source.clear();
+    m_gain = 1.0f;
+    m_loaded = false;
+    m_decodeFinished = false;
+    m_failed = false;
+    m_ring.clear();
+    m_spill.resize(0);
+    m_spillOffset = 0;
+    m_startFrame = 0;
+    m_endFrame = -1;
+    m_skipFrames = 0;
+    m_framesRead = 0;
+    m_framesDecoded = 0;
+    m_expectedFrames = -1;
+    m_resamplePhase = 0.0;
+    m_hasPrevious = false;
+}
+
+int AudioDeck::read(float* out, int frames)
+{
+    if (!m_loaded || frames <= 0) {
+        return 0;
+    }
+
+    int got = m_ring.read(out, frames * CHANNELS) / CHANNELS;
+    m_framesRead += got;
+    if (m_gain != 1.0f) {
+        for (int i = 0; i < got * CHANNELS; ++i) {
+            out[i] *= m_gain;
+        }
+    }
+
+    // Reading made room in the ring; let the decoder continue
+    pump();
+    return got;
+}
+
+AudioDeck::State AudioDeck::state() const
+{
+    if (!m_loaded) {
+        return State::Empty;
+    }
+
+    const bool buffered = m_ring.availableToRead() > 0 || m_spillOffset < m_spill.size();
+    if (buffered) {
+        return State::Ready;
+    }
+    if (m_failed && m_framesDecoded == 0) {
+        return State::Error;
+    }
+    if (m_decodeFinished) {
+        return State::Drained;
+    }
+    return State::Loading;
+}
+
+bool AudioDeck::isActive() const
+{
+    State current = state();
+    return current == State::Loading || current == State::Ready;
+}
+
+qint64 AudioDeck::durationFrames() const
+{
+    if (!m_loaded) {
+        return -1;
+    }
+    if (m_decodeFinished && !m_failed) {
+        return m_framesDecoded;
+    }
+
+    qint64 frames = -1;
+    if (m_expectedFrames > 0) {
+        frames = m_expectedFrames;
+    } else if (m_decoder && m_decoder->duration() > 0) {
+        frames = m_decoder->duration() * m_sampleRate / 1000;
+    }
+    if (m_endFrame >= 0) {
+        return frames < 0 ? m_endFrame : qMin(frames, m_endFrame);
+    }
+    return frames;
+}
+
+qint64 AudioDeck::remainingFrames() const
+{
+    qint64 duration = durationFrames();
+    if (duration < 0) {
+        return -1;
+    }
+    return qMax<qint64>(0, duration - positionFrames());
+}
+
+int AudioDeck::bufferedFrames() const
+{
+    return (m_ring.availableToRead() + (m_spill.size() - m_spillOffset)) / CHANNELS;
+}
+
+void AudioDeck::onBufferReady()
+{
+    pump();
+}
+
+void AudioDeck::onFinished()
+{
+    m_decodeFinished = true;
+    pump();
+    emit durationChanged(m_framesDecoded);
+}
+
+void AudioDeck::onError(QAudioDecoder::Error error)
+{
+    Q_UNUSED(error);
+
+    QString message = m_decoder ? m_decoder->errorString() : QString();
+    qWarning() << "AudioDeck: failed to decode" << m_source << "-" << message;
+
+    m_failed = true;
+    m_decodeFinished = true;
+    emit errorOccurred(m_source, message);
+}
+
+void AudioDeck::pump()
+{
+    while (m_loaded && (m_decoder || m_wav.isOpen())) {
+        if (m_spillOffset < m_spill.size()) {
+            m_spillOffset += m_ring.write(m_spill.constData() + m_spillOffset,
+                                          m_spill.size() - m_spillOffset);
+            if (m_spillOffset < m_spill.size()) {
+                return; // Ring is full
+            }
+        }
+        m_spill.resize(0);
+        m_spillOffset = 0;
+
+        if (m_wav.isOpen()) {
+            if (m_decodeFinished || m_ring.availableToWrite() == 0) {
+                return;
+            }
+            readMapped();
+            continue;
+        }
+
+        // Only pull from the decoder while there is room; decoders that decode
+        // on demand then pause instead of racing ahead through the whole file
+        if (!m_decoder->bufferAvailable() || m_ring.availableToWrite() == 0) {
+            return;
+        }
+        convertBuffer(m_decoder->read());
+        if (m_endFrame >= 0 && m_framesDecoded >= m_endFrame) {
+            finishAtEnd();
+        }
+    }
+}
+
+void AudioDeck::readMapped()
+{
+    const int frames =
+        static_cast<int>(qMin<qint64>(m_wav.frames() - m_wavFrame, MAPPED_BLOCK_FRAMES));
+    if (frames > 0) {
+        m_wav.adviseAhead(m_wavFrame, qint64(m_wav.format().sampleRate()) * RING_SECONDS);
+        convertFrames(m_wav.frameData(m_wavFrame), frames, m_wav.format());
+        m_wavFrame += frames;
+    }
+    if (m_wavFrame >= m_wav.frames() || (m_endFrame >= 0 && m_framesDecoded >= m_endFrame)) {
+        m_decodeFinished = true;
+        emit durationChanged(m_framesDecoded);
+    }
+}
+
+void AudioDeck::convertBuffer(const QAudioBuffer& buffer)
+{
+    if (buffer.isValid()) {
+        convertFrames(buffer.constData<char>(), static_cast<int>(buffer.frameCount()),
+                      buffer.format());
+    }
+}
+
+void AudioDeck::convertFrames(const char* data, int frames, const QAudioFormat& format)
+{
+    const int channels = format.channelCount();
+    const int bytesPerSample = format.bytesPerSample();
+    if (channels <= 0 || frames <= 0 || bytesPerSample <= 0) {
+        return;
+    }
+
+    m_spill.reserve(m_spill.size() + frames * CHANNELS);
+
+    const int rightChannel = channels > 1 ? 1 : 0;
+    const double step = double(format.sampleRate()) / m_sampleRate;
+    const bool resample = format.sampleRate() != m_sampleRate && format.sampleRate() > 0;
+
+    for (int i = 0; i < frames; ++i) {
+        float left;
+        float right;
+        if (format.sampleFormat() == QAudioFormat::Float) {
+            const float* frame = reinterpret_cast<const float*>(data) + i * channels;
+            left = frame[0];
+            right = frame[rightChannel];
+        } else if (format.sampleFormat() == QAudioFormat::Int16) {
+            const qint16* frame = reinterpret_cast<const qint16*>(data) + i * channels;
+            left = frame[0] / 32768.0f;
+            right = frame[rightChannel] / 32768.0f;
+        } else {
+            const char* frame = data + i * channels * bytesPerSample;
+            left = format.normalizedSampleValue(frame);
+            right = format.normalizedSampleValue(frame + rightChannel * bytesPerSample);
+        }
+
+        if (!resample) {
+            appendFrame(left, right);
+            continue;
+        }
+
+        // Linear interpolation between the previous and current input frame
+        if (!m_hasPrevious) {
+            m_previousLeft = left;
+            m_previousRight = right;
+            m_hasPrevious = true;
+            continue;
+        }
+        while (m_resamplePhase < 1.0) {
+            const float t = static_cast<float>(m_resamplePhase);
+            appendFrame(m_previousLeft + (left - m_previousLeft) * t,
+                        m_previousRight + (right - m_previousRight) * t);
+            m_resamplePhase += step;
+        }
+        m_resamplePhase -= 1.0;
+        m_previousLeft = left;
+        m_previousRight = right;
+    }
+}
+
+void AudioDeck::appendFrame(float left, float right)
+{
+    if (m_endFrame >= 0 && m_framesDecoded >= m_endFrame) {
+        return; // Past the cue-out point
+    }
+    ++m_framesDecoded;
+    if (m_skipFrames > 0) {
+        --m_skipFrames;
+        return;
+    }
+    m_spill.append(left);
+    m_spill.append(right);
+}
+
+void AudioDeck::finishAtEnd()
+{
+    if (m_decodeFinished) {
+        return;
+    }
+
+    // The rest of the file is never played; the decoder stays around, stopped,
+    // so that pump() keeps moving the spill into the ring
+    m_decoder->disconnect(this);
+    m_decoder->stop();
+    m_decodeFinished = true;
+    emit durationChanged(m_framesDecoded);
+}
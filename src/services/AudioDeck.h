@@ -0,0 +1,222 @@
+#ifndef AUDIODECK_H
+#define AUDIODECK_H
+
+#include "AudioRingBuffer.h"
+#include "MappedWav.h"
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QtMultimedia/QAudioDecoder>
+
+class QAudioBuffer;
+class TrackPrefetcher;
+
+/**
+ * @brief One playback deck: a decoder feeding a ring buffer
+ *
+ * AudioDeck decodes a single file with QAudioDecoder and keeps up to
+ * RING_SECONDS of interleaved stereo float audio at the engine sample rate
+ * in an AudioRingBuffer, ready for the mixer to pull. Decoded buffers are
+ * only taken from the decoder while there is room in the ring, so a loaded
+ * deck pre-decodes the start of its track and then waits.
+ *
+ * When a TrackPrefetcher is set and holds the head of the file, decoding
+ * starts from that in-memory copy instead of a cold open of the file. A
+ * deck that borrows from the prefetcher leaves the copy for the deck that
+ * airs the file later.
+ *
+ * WAV files, which include the copies of TranscodeCache, skip the decoder:
+ * they are mapped with MappedWav and their samples converted straight from
+ * the mapping, MAPPED_BLOCK_FRAMES at a time, with no read copies. A seek
+ * then starts at the requested frame. Files MappedWav does not read go to
+ * the decoder as before.
+ *
+ * Sample format, channel count and sample rate are normalised here, so the
+ * mixer only ever sees stereo float frames. Seeking is done by restarting
+ * the decoder and discarding frames up to the requested position.
+ *
+ * A track can be cut short with an end position, its cue-out point: frames
+ * past it are dropped and the decoder is stopped once it gets there, so
+ * the deck drains, and the crossfade is timed, as if the file ended there.
+ * A per-track gain, such as a replay gain, is applied to everything read.
+ *
+ * AudioDeck is not thread-safe; it lives on the audio thread together with
+ * the DeckMixer that reads from it.
+ *
+ * @since XFB 2.0
+ */
+class AudioDeck : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Deck lifecycle
+     */
+    enum class State {
+        Empty,    ///< Nothing loaded
+        Loading,  ///< Decoder started, no audio buffered yet
+        Ready,    ///< Audio is buffered and can be played
+        Drained,  ///< Decoding finished and all audio has been read
+        Error     ///< The file could not be decoded
+    };
+
+    static constexpr int CHANNELS = 2;
+    static constexpr int RING_SECONDS = 10;   ///< Audio the ring holds
+    static constexpr int MAPPED_BLOCK_FRAMES = 4096;   ///< Converted at a time from a WAV
+
+    explicit AudioDeck(int sampleRate, QObject* parent = nullptr);
+    ~AudioDeck() override;
+
+    /**
+     * @brief Start decoding a file
+     * @param filePath Path of the audio file
+     * @param startMs Position to start at, in milliseconds
+     * @param endMs Position to end at, in milliseconds; -1 plays to the end of the file
+     * @param gain Linear gain applied to the track
+     */
+    void load(const QString& filePath, qint64 startMs = 0, qint64 endMs = -1, float gain = 1.0f);
+
+    /**
+     * @brief Stop decoding and drop all buffered audio
+     */
+    void unload();
+
+    /**
+     * @brief Read decoded frames
+     * @param out Destination for interleaved stereo frames
+     * @param frames Maximum number of frames to read
+     * @return Number of frames read; fewer than requested on underrun or end of track
+     */
+    int read(float* out, int frames);
+
+    /**
+     * @brief Get the loaded file
+     * @return File path, or empty string if the deck is empty
+     */
+    QString source() const { return m_source; }
+
+    /**
+     * @brief Get the end position given to load()
+     * @return Position in milliseconds, or -1 if the track plays to the end of the file
+     */
+    qint64 endMs() const { return m_endFrame < 0 ? -1 : m_endFrame * 1000 / m_sampleRate; }
+
+    /**
+     * @brief Get the gain given to load()
+     */
+    float gain() const { return m_gain; }
+
+    /**
+     * @brief Whether the track is read from a mapped WAV rather than decoded
+     */
+    bool isMapped() const { return m_wav.isOpen(); }
+
+    State state() const;
+
+    /**
+     * @brief Whether the deck has a track that still has audio to play
+     */
+    bool isActive() const;
+
+    /**
+     * @brief Get the playback position
+     * @return Position in frames from the start of the track
+     */
+    qint64 positionFrames() const { return m_startFrame + m_framesRead; }
+
+    /**
+     * @brief Get the best known track length
+     * @return Length in frames, or -1 if unknown
+     */
+    qint64 durationFrames() const;
+
+    /**
+     * @brief Get the number of frames left to play
+     * @return Remaining frames, or -1 if the length is unknown
+     */
+    qint64 remainingFrames() const;
+
+    /**
+     * @brief Get the number of frames ready to be read without decoding
+     */
+    int bufferedFrames() const;
+
+    /**
+     * @brief Get the number of frames the ring holds when full
+     */
+    int capacityFrames() const { return m_ring.capacity() / CHANNELS; }
+
+    int sampleRate() const { return m_sampleRate; }
+
+    /**
+     * @brief Use prefetched file heads when available
+     * @param prefetcher Prefetcher shared with the engine, or nullptr
+     * @param borrow Read the heads without taking them from the prefetcher
+     */
+    void setPrefetcher(TrackPrefetcher* prefetcher, bool borrow = false)
+    {
+        m_prefetcher = prefetcher;
+        m_borrowPrefetch = borrow;
+    }
+
+signals:
+    /**
+     * @brief Emitted when the track length becomes exactly known
+     * @param frames Track length in frames
+     */
+    void durationChanged(qint64 frames);
+
+    /**
+     * @brief Emitted when the file cannot be decoded
+     * @param filePath Path of the file
+     * @param message Decoder error message
+     */
+    void errorOccurred(const QString& filePath, const QString& message);
+
+private slots:
+    void onBufferReady();
+    void onFinished();
+    void onError(QAudioDecoder::Error error);
+
+private:
+    bool loadMapped(const QString& filePath);
+    void pump();
+    void readMapped();
+    void convertBuffer(const QAudioBuffer& buffer);
+    void convertFrames(const char* data, int frames, const QAudioFormat& format);
+    void appendFrame(float left, float right);
+    void finishAtEnd();
+
+    int m_sampleRate;
+    QAudioDecoder* m_decoder = nullptr;
+    TrackPrefetcher* m_prefetcher = nullptr;
+    bool m_borrowPrefetch = false;
+    AudioRingBuffer m_ring;
+    MappedWav m_wav;
+    qint64 m_wavFrame = 0;       ///< Next frame of m_wav to convert
+
+    QString m_source;
+    float m_gain = 1.0f;
+    bool m_loaded = false;
+    bool m_decodeFinished = false;
+    bool m_failed = false;
+
+    QVector<float> m_spill;     ///< Converted samples not yet written to the ring
+    int m_spillOffset = 0;
+
+    qint64 m_startFrame = 0;     ///< Frame the deck was started at (seek offset)
+    qint64 m_endFrame = -1;      ///< Frame the track is cut at, or -1 for the end of the file
+    qint64 m_skipFrames = 0;     ///< Decoded frames still to discard for a seek
+    qint64 m_framesRead = 0;     ///< Frames handed to the mixer since load()
+    qint64 m_framesDecoded = 0;  ///< Frames produced by the decoder since load()
+    qint64 m_expectedFrames = -1;
+
+    // Linear resampler state for decoders that ignore the requested rate
+    double m_resamplePhase = 0.0;
+    float m_previousLeft = 0.0f;
+    float m_previousRight = 0.0f;
+    bool m_hasPrevious = false;
+};
+
+#endif // AUDIODECK_H
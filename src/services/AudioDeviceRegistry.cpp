@@ -0,0 +1,51 @@
+#include "AudioDeviceRegistry.h"
+#include <QDebug>
+#include <QMediaDevices>
+
+AudioDeviceRegistry::AudioDeviceRegistry(QObject* parent)
+    : QObject(parent)
+    , m_monitor(new QMediaDevices(this))
+{
+    // The defaults are read with the lists, so a new default also refreshes
+    connect(m_monitor, &QMediaDevices::audioInputsChanged, this, &AudioDeviceRegistry::refresh);
+    connect(m_monitor, &QMediaDevices::audioOutputsChanged, this, &AudioDeviceRegistry::refresh);
+    refresh();
+}
+
+void AudioDeviceRegistry::refresh()
+{
+    m_inputs = index(QMediaDevices::audioInputs(), QMediaDevices::defaultAudioInput());
+    m_outputs = index(QMediaDevices::audioOutputs(), QMediaDevices::defaultAudioOutput());
+    qDebug() << "AudioDeviceRegistry:" << m_inputs.devices.size() << "inputs,"
+             << m_outputs.devices.size() << "outputs";
+    emit devicesChanged();
+}
+
+AudioDeviceRegistry::Devices AudioDeviceRegistry::index(const QList<QAudioDevice>& devices,
+                                                        const QAudioDevice& defaultDevice)
+{
+    Devices indexed;
+    indexed.devices = devices;
+    indexed.defaultDevice = defaultDevice;
+    indexed.byId.reserve(devices.size());
+    indexed.byDescription.reserve(devices.size());
+    for (int i = 0; i < devices.size(); ++i) {
+        indexed.byId.insert(devices.at(i).id(), i);
+        if (!indexed.byDescription.contains(devices.at(i).description())) {
+            indexed.byDescription.insert(devices.at(i).description(), i);
+        }
+    }
+    return indexed;
+}
+
+QAudioDevice AudioDeviceRegistry::find(const Devices& devices, const QString& key)
+{
+    if (key.isEmpty()) {
+        return QAudioDevice();
+    }
+    int i = devices.byId.value(key.toUtf8(), -1);
+    if (i < 0) {
+        i = devices.byDescription.value(key, -1);
+    }
+    return i < 0 ? QAudioDevice() : devices.devices.at(i);
+}
@@ -0,0 +1,92 @@
+#ifndef AUDIODEVICEREGISTRY_H
+#define AUDIODEVICEREGISTRY_H
+
+#include <QAudioDevice>
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QString>
+
+class QMediaDevices;
+
+/**
+ * @brief The audio devices of the system, enumerated once and kept current
+ *
+ * QMediaDevices::audioInputs() and audioOutputs() ask the audio backend
+ * every time, which takes hundreds of milliseconds on some systems, and
+ * starting a recording or switching the output looked the device up that
+ * way. AudioDeviceRegistry enumerates the devices when it is created and
+ * again only when QMediaDevices reports that they changed; in between, a
+ * device is found by its id or its description through a hash.
+ *
+ * The settings keep devices by description, which is what the options
+ * dialog shows, so find() accepts either; ids are tried first. Among
+ * devices with the same description the first one listed wins.
+ *
+ * @example
+ * @code
+ * AudioDeviceRegistry* devices = new AudioDeviceRegistry(this);
+ * QAudioDevice input = devices->findInput(settings.value("RecDevice").toString());
+ * if (input.isNull())
+ *     input = devices->defaultInput();
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class AudioDeviceRegistry : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit AudioDeviceRegistry(QObject* parent = nullptr);
+
+    QList<QAudioDevice> inputs() const { return m_inputs.devices; }
+    QList<QAudioDevice> outputs() const { return m_outputs.devices; }
+    QAudioDevice defaultInput() const { return m_inputs.defaultDevice; }
+    QAudioDevice defaultOutput() const { return m_outputs.defaultDevice; }
+
+    /**
+     * @brief Find an input device
+     * @param key Id or description of the device
+     * @return The device, or a null device if there is none such
+     */
+    QAudioDevice findInput(const QString& key) const { return find(m_inputs, key); }
+
+    /**
+     * @brief Find an output device
+     * @param key Id or description of the device
+     * @return The device, or a null device if there is none such
+     */
+    QAudioDevice findOutput(const QString& key) const { return find(m_outputs, key); }
+
+    /**
+     * @brief Enumerate the devices again
+     *
+     * Done on its own when the system's devices change.
+     */
+    void refresh();
+
+signals:
+    /**
+     * @brief Emitted after the devices were enumerated again
+     */
+    void devicesChanged();
+
+private:
+    struct Devices {
+        QList<QAudioDevice> devices;
+        QAudioDevice defaultDevice;
+        QHash<QByteArray, int> byId;
+        QHash<QString, int> byDescription;
+    };
+
+    static Devices index(const QList<QAudioDevice>& devices, const QAudioDevice& defaultDevice);
+    static QAudioDevice find(const Devices& devices, const QString& key);
+
+    QMediaDevices* m_monitor;
+    Devices m_inputs;
+    Devices m_outputs;
+};
+
+#endif // AUDIODEVICEREGISTRY_H
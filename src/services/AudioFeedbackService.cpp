@@ -1,17 +1,16 @@
 #include "AudioFeedbackService.h"
 #include "AccessibilityManager.h"
+#include "AnnouncementBus.h"
 #include "ServiceContainer.h"
 #include <QApplication>
 #include <QAccessibleEvent>
 #include <QDateTime>
 #include <QSettings>
 #include <QDebug>
-#include <QMutexLocker>
 #include <algorithm>
 
 AudioFeedbackService::AudioFeedbackService(QObject* parent)
     : BaseService(parent)
-    , m_processingTimer(nullptr)
     , m_isProcessing(false)
     , m_isInitialized(false)
     , m_accessibilityManager(nullptr)
@@ -89,33 +88,16 @@ QString AudioFeedbackService::getServiceName() const
 
 void AudioFeedbackService::initializeAnnouncementSystem()
 {
-    // Create and configure processing timer
-    m_processingTimer = new QTimer(this);
-    m_processingTimer->setInterval(m_config.processingIntervalMs);
-    m_processingTimer->setSingleShot(false);
-    
-    connect(m_processingTimer, &QTimer::timeout,
-            this, &AudioFeedbackService::processNextAnnouncement);
-    
-    // Start processing if enabled
-    if (m_config.enabled && m_accessibilityManager && m_accessibilityManager->isAccessibilityEnabled()) {
-        m_processingTimer->start();
-    }
+    // Announcements are paced by AnnouncementBus; it is armed only while one waits
+    AnnouncementBus::instance();
     
     qDebug() << "AudioFeedbackService: Announcement system initialized";
 }
 
 void AudioFeedbackService::shutdownAnnouncementSystem()
 {
-    if (m_processingTimer) {
-        m_processingTimer->stop();
-        m_processingTimer->deleteLater();
-        m_processingTimer = nullptr;
-    }
-    
     // Clear any remaining announcements
-    QMutexLocker locker(&m_queueMutex);
-    m_announcementQueue.clear();
+    AnnouncementBus::instance()->clear(this);
     m_isProcessing = false;
     
     qDebug() << "AudioFeedbackService: Announcement system shutdown completed";
@@ -381,71 +363,55 @@ void AudioFeedbackService::queueAnnouncement(const QString& message, Priority pr
 
 void AudioFeedbackService::addToQueue(const AnnouncementItem& item)
 {
-    QMutexLocker locker(&m_queueMutex);
+    AnnouncementBus* bus = AnnouncementBus::instance();
+    
+    AnnouncementBus::Announcement announcement;
+    announcement.region = regionFor(item.feedbackType);
+    announcement.message = item.message;
+    announcement.priority = static_cast<AnnouncementBus::Priority>(item.priority);
+    announcement.throttleMs = announcement.region.isEmpty() ? 0 : m_config.processingIntervalMs;
+    announcement.context = this;
+    announcement.deliver = [this, item](const AnnouncementBus::Announcement& delivered) {
+        AnnouncementItem current = item;
+        current.message = delivered.message;
+        current.priority = static_cast<Priority>(delivered.priority);
+        processAnnouncementItem(current);
+    };
     
     // Handle critical announcements that should interrupt
-    if (item.priority == Priority::Critical && shouldInterruptForPriority(item.priority)) {
-        // Clear lower priority items and add critical item to front
-        auto it = m_announcementQueue.begin();
-        while (it != m_announcementQueue.end()) {
-            if (static_cast<int>(it->priority) < static_cast<int>(Priority::Critical)) {
-                it = m_announcementQueue.erase(it);
-                m_announcementsDropped++;
-            } else {
-                ++it;
-            }
+    if (item.priority == Priority::Critical) {
+        if (shouldInterruptForPriority(item.priority)) {
+            // Drop lower priority items; the bus says the critical one at once
+            const int before = bus->pendingCount(this);
+            bus->clear(this, true);
+            m_announcementsDropped += before - bus->pendingCount(this);
+            emit criticalAnnouncementInterrupted(item.message);
+        } else {
+            // Waits its turn ahead of everything else
+            announcement.priority = AnnouncementBus::Priority::High;
         }
-        
-        m_announcementQueue.prepend(item);
-        emit criticalAnnouncementInterrupted(item.message);
+    } else if (bus->pendingCount(this) >= m_config.maxQueueSize
+               && item.priority != Priority::High) {
+        // Check queue size and handle overflow
+        m_announcementsDropped++;
+        emit queueOverflow(1);
         return;
     }
     
-    // Check queue size and handle overflow
-    if (m_announcementQueue.size() >= m_config.maxQueueSize) {
-        int dropped = handleQueueOverflow();
-        if (dropped > 0) {
-            emit queueOverflow(dropped);
-        }
-    }
-    
-    // Add item to queue in priority order
-    auto insertPos = std::lower_bound(m_announcementQueue.begin(), m_announcementQueue.end(), item);
-    m_announcementQueue.insert(insertPos, item);
+    bus->post(announcement);
 }
 
 void AudioFeedbackService::clearAnnouncementQueue(bool preserveCritical)
 {
-    QMutexLocker locker(&m_queueMutex);
-    
-    if (preserveCritical) {
-        auto it = m_announcementQueue.begin();
-        while (it != m_announcementQueue.end()) {
-            if (it->priority != Priority::Critical) {
-                it = m_announcementQueue.erase(it);
-            } else {
-                ++it;
-            }
-        }
-    } else {
-        m_announcementQueue.clear();
-    }
+    AnnouncementBus::instance()->clear(this, preserveCritical);
 }
 
 void AudioFeedbackService::setConfig(const AnnouncementConfig& config)
 {
     m_config = config;
     
-    if (m_processingTimer) {
-        m_processingTimer->setInterval(m_config.processingIntervalMs);
-        
-        if (m_config.enabled && m_accessibilityManager && m_accessibilityManager->isAccessibilityEnabled()) {
-            if (!m_processingTimer->isActive()) {
-                m_processingTimer->start();
-            }
-        } else {
-            m_processingTimer->stop();
-        }
+    if (!m_config.enabled) {
+        clearAnnouncementQueue(false);
     }
     
     saveConfiguration();
@@ -455,12 +421,8 @@ void AudioFeedbackService::setEnabled(bool enabled)
 {
     m_config.enabled = enabled;
     
-    if (m_processingTimer) {
-        if (enabled && m_accessibilityManager && m_accessibilityManager->isAccessibilityEnabled()) {
-            m_processingTimer->start();
-        } else {
-            m_processingTimer->stop();
-        }
+    if (!enabled) {
+        clearAnnouncementQueue(false);
     }
     
     saveConfiguration();
@@ -468,33 +430,16 @@ void AudioFeedbackService::setEnabled(bool enabled)
 
 int AudioFeedbackService::getQueueSize() const
 {
-    QMutexLocker locker(const_cast<QMutex*>(&m_queueMutex));
-    return m_announcementQueue.size();
+    return AnnouncementBus::instance()->pendingCount(this);
 }
 
-void AudioFeedbackService::processNextAnnouncement()
+void AudioFeedbackService::processAnnouncementItem(const AnnouncementItem& item)
 {
-    if (m_isProcessing || !m_config.enabled) {
+    if (!m_config.enabled) {
         return;
     }
     
-    AnnouncementItem item;
-    {
-        QMutexLocker locker(&m_queueMutex);
-        if (m_announcementQueue.isEmpty()) {
-            return;
-        }
-        
-        item = m_announcementQueue.dequeue();
-    }
-    
     m_isProcessing = true;
-    processAnnouncementItem(item);
-    m_isProcessing = false;
-}
-
-void AudioFeedbackService::processAnnouncementItem(const AnnouncementItem& item)
-{
     try {
         sendToAccessibilityFramework(item.message, item.priority);
         
@@ -506,6 +451,7 @@ void AudioFeedbackService::processAnnouncementItem(const AnnouncementItem& item)
     } catch (const std::exception& e) {
         qWarning() << "AudioFeedbackService: Error processing announcement:" << e.what();
     }
+    m_isProcessing = false;
 }
 
 void AudioFeedbackService::sendToAccessibilityFramework(const QString& message, Priority priority)
@@ -531,8 +477,8 @@ void AudioFeedbackService::sendToAccessibilityFramework(const QString& message,
             break;
     }
     
-    // Send announcement through accessibility manager
-    m_accessibilityManager->announceMessage(message, amPriority);
+    // Already paced on the bus; queueing it again would delay it a second time
+    m_accessibilityManager->deliverAnnouncement(message, amPriority);
 }
 
 QString AudioFeedbackService::formatMessageForVerbosity(const QString& message, FeedbackType feedbackType) const
@@ -543,34 +489,19 @@ QString AudioFeedbackService::formatMessageForVerbosity(const QString& message,
     return message;
 }
 
-int AudioFeedbackService::handleQueueOverflow()
+QString AudioFeedbackService::regionFor(FeedbackType feedbackType)
 {
-    int removed = 0;
-    
-    // Remove low priority items first
-    auto it = m_announcementQueue.begin();
-    while (it != m_announcementQueue.end() && m_announcementQueue.size() >= m_config.maxQueueSize) {
-        if (it->priority == Priority::Low) {
-            it = m_announcementQueue.erase(it);
-            removed++;
-        } else {
-            ++it;
-        }
-    }
-    
-    // If still too full, remove normal priority items
-    it = m_announcementQueue.begin();
-    while (it != m_announcementQueue.end() && m_announcementQueue.size() >= m_config.maxQueueSize) {
-        if (it->priority == Priority::Normal) {
-            it = m_announcementQueue.erase(it);
-            removed++;
-        } else {
-            ++it;
-        }
+    // Only the latest of these is worth hearing; the others all stand alone
+    switch (feedbackType) {
+        case FeedbackType::PlaybackChange:
+            return QStringLiteral("audio-feedback:playback");
+        case FeedbackType::TrackChange:
+            return QStringLiteral("audio-feedback:track");
+        case FeedbackType::ProgressUpdate:
+            return QStringLiteral("audio-feedback:progress");
+        default:
+            return QString();
     }
-    
-    m_announcementsDropped += removed;
-    return removed;
 }
 
 bool AudioFeedbackService::shouldInterruptForPriority(Priority priority) const
@@ -586,12 +517,8 @@ void AudioFeedbackService::onVerbosityLevelChanged(int level)
 
 void AudioFeedbackService::onAccessibilityStateChanged(bool enabled)
 {
-    if (m_processingTimer) {
-        if (enabled && m_config.enabled) {
-            m_processingTimer->start();
-        } else {
-            m_processingTimer->stop();
-        }
+    if (!enabled) {
+        clearAnnouncementQueue(false);
     }
     
     qDebug() << "AudioFeedbackService: Accessibility state changed to" << enabled;
@@ -3,9 +3,7 @@
 
 #include "BaseService.h"
 #include <QObject>
-#include <QQueue>
-#include <QTimer>
-#include <QMutex>
+#include <QDateTime>
 #include <QAccessible>
 
 class AccessibilityManager;
@@ -69,7 +67,7 @@ public:
     struct AnnouncementConfig {
         bool enabled = true;                    ///< Whether announcements are enabled
         int maxQueueSize = 50;                  ///< Maximum number of queued announcements
-        int processingIntervalMs = 100;         ///< Interval between announcement processing
+        int processingIntervalMs = 100;         ///< Least gap between two merged messages
         int criticalInterruptDelayMs = 50;      ///< Delay before critical announcements interrupt
         bool allowInterruption = true;         ///< Whether announcements can be interrupted
         int maxAnnouncementLengthChars = 500;   ///< Maximum length of a single announcement
@@ -254,11 +252,6 @@ protected:
     QString getServiceName() const override;
 
 private slots:
-    /**
-     * @brief Process the next announcement in the queue
-     */
-    void processNextAnnouncement();
-
     /**
      * @brief Handle accessibility manager state changes
      * @param enabled Whether accessibility is enabled
@@ -301,7 +294,7 @@ private:
     void shutdownAnnouncementSystem();
 
     /**
-     * @brief Add an announcement to the queue with priority handling
+     * @brief Post an announcement to AnnouncementBus with priority handling
      * @param item The announcement item to add
      */
     void addToQueue(const AnnouncementItem& item);
@@ -328,10 +321,11 @@ private:
     QString formatMessageForVerbosity(const QString& message, FeedbackType feedbackType) const;
 
     /**
-     * @brief Handle queue overflow by removing low-priority items
-     * @return Number of items removed
+     * @brief AnnouncementBus region for a kind of feedback, merging what only matters when latest
+     * @param feedbackType Type of feedback
+     * @return The region, empty when announcements of the type stand alone
      */
-    int handleQueueOverflow();
+    static QString regionFor(FeedbackType feedbackType);
 
     /**
      * @brief Check if an announcement should interrupt current processing
@@ -352,9 +346,6 @@ private:
 
     // Member variables
     AnnouncementConfig m_config;
-    QQueue<AnnouncementItem> m_announcementQueue;
-    QTimer* m_processingTimer;
-    QMutex m_queueMutex;
     bool m_isProcessing;
     bool m_isInitialized;
     AccessibilityManager* m_accessibilityManager;
@@ -368,8 +359,6 @@ private:
     int m_currentVerbosityLevel;
     
     // Constants
-    static constexpr int DEFAULT_PROCESSING_INTERVAL_MS = 100;
-    static constexpr int DEFAULT_MAX_QUEUE_SIZE = 50;
     static constexpr int CRITICAL_INTERRUPT_DELAY_MS = 50;
     static constexpr int MAX_ANNOUNCEMENT_LENGTH = 500;
 };
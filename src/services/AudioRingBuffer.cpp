@@ -0,0 +1,91 @@
+#include "AudioRingBuffer.h"
+#include <cstring>
+
+AudioRingBuffer::AudioRingBuffer(int capacitySamples)
+{
+    resize(capacitySamples);
+}
+
+void AudioRingBuffer::resize(int capacitySamples)
+{
+    m_buffer.assign(static_cast<size_t>(qMax(0, capacitySamples)), 0.0f);
+    clear();
+}
+
+void AudioRingBuffer::clear()
+{
+    m_readPos.store(0, std::memory_order_relaxed);
+    m_writePos.store(0, std::memory_order_relaxed);
+}
+
+int AudioRingBuffer::availableToRead() const
+{
+    const quint64 writePos = m_writePos.load(std::memory_order_acquire);
+    const quint64 readPos = m_readPos.load(std::memory_order_acquire);
+    return static_cast<int>(writePos - readPos);
+}
+
+int AudioRingBuffer::availableToWrite() const
+{
+    return capacity() - availableToRead();
+}
+
+int AudioRingBuffer::write(const float* data, int samples)
+{
+    const int cap = capacity();
+    if (cap == 0 || samples <= 0) {
+        return 0;
+    }
+
+    const quint64 writePos = m_writePos.load(std::memory_order_relaxed);
+    const quint64 readPos = m_readPos.load(std::memory_order_acquire);
+    const int toWrite = qMin(samples, cap - static_cast<int>(writePos - readPos));
+    if (toWrite <= 0) {
+        return 0;
+    }
+
+    const int start = static_cast<int>(writePos % cap);
+    const int first = qMin(toWrite, cap - start);
+    std::memcpy(m_buffer.data() + start, data, sizeof(float) * first);
+    if (toWrite > first) {
+        std::memcpy(m_buffer.data(), data + first, sizeof(float) * (toWrite - first));
+    }
+
+    m_writePos.store(writePos + toWrite, std::memory_order_release);
+    return toWrite;
+}
+
+int AudioRingBuffer::read(float* data, int samples)
+{
+    const int cap = capacity();
+    if (cap == 0 || samples <= 0) {
+        return 0;
+    }
+
+    const quint64 readPos = m_readPos.load(std::memory_order_relaxed);
+    const quint64 writePos = m_writePos.load(std::memory_order_acquire);
+    const int toRead = qMin(samples, static_cast<int>(writePos - readPos));
+    if (toRead <= 0) {
+        return 0;
+    }
+
+    const int start = static_cast<int>(readPos % cap);
+    const int first = qMin(toRead, cap - start);
+    std::memcpy(data, m_buffer.data() + start, sizeof(float) * first);
+    if (toRead > first) {
+        std::memcpy(data + first, m_buffer.data(), sizeof(float) * (toRead - first));
+    }
+
+    m_readPos.store(readPos + toRead, std::memory_order_release);
+    return toRead;
+}
+
+int AudioRingBuffer::skip(int samples)
+{
+    const quint64 readPos = m_readPos.load(std::memory_order_relaxed);
+    const quint64 writePos = m_writePos.load(std::memory_order_acquire);
+    const int toSkip = qMin(qMax(0, samples), static_cast<int>(writePos - readPos));
+
+    m_readPos.store(readPos + toSkip, std::memory_order_release);
+    return toSkip;
+}
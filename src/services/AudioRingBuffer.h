@@ -0,0 +1,92 @@
+#ifndef AUDIORINGBUFFER_H
+#define AUDIORINGBUFFER_H
+
+#include <QtGlobal>
+#include <atomic>
+#include <vector>
+
+/**
+ * @brief Single-producer/single-consumer ring buffer of float samples
+ *
+ * AudioRingBuffer holds interleaved float samples between a decoder
+ * (producer) and the mixer (consumer). Reads and writes never block and
+ * never allocate; the read and write positions are monotonically increasing
+ * atomic counters, so one thread may write while another reads without a
+ * lock.
+ *
+ * resize() and clear() are not thread-safe and must only be called while
+ * neither side is active.
+ *
+ * @example
+ * @code
+ * AudioRingBuffer ring(48000 * 2 * 10); // 10 s of 48 kHz stereo
+ * ring.write(decoded.data(), decoded.size());
+ * int got = ring.read(out, 1024);
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class AudioRingBuffer
+{
+public:
+    explicit AudioRingBuffer(int capacitySamples = 0);
+
+    /**
+     * @brief Reallocate the buffer, discarding its contents
+     * @param capacitySamples New capacity in samples
+     */
+    void resize(int capacitySamples);
+
+    /**
+     * @brief Discard all buffered samples
+     */
+    void clear();
+
+    /**
+     * @brief Get the buffer capacity
+     * @return Capacity in samples
+     */
+    int capacity() const { return static_cast<int>(m_buffer.size()); }
+
+    /**
+     * @brief Get the number of samples that can be read
+     * @return Buffered sample count
+     */
+    int availableToRead() const;
+
+    /**
+     * @brief Get the number of samples that can be written
+     * @return Free space in samples
+     */
+    int availableToWrite() const;
+
+    /**
+     * @brief Write samples into the buffer
+     * @param data Source samples
+     * @param samples Number of samples to write
+     * @return Number of samples actually written
+     */
+    int write(const float* data, int samples);
+
+    /**
+     * @brief Read samples out of the buffer
+     * @param data Destination for the samples
+     * @param samples Maximum number of samples to read
+     * @return Number of samples actually read
+     */
+    int read(float* data, int samples);
+
+    /**
+     * @brief Drop samples without copying them
+     * @param samples Maximum number of samples to drop
+     * @return Number of samples dropped
+     */
+    int skip(int samples);
+
+private:
+    std::vector<float> m_buffer;
+    std::atomic<quint64> m_readPos{0};
+    std::atomic<quint64> m_writePos{0};
+};
+
+#endif // AUDIORINGBUFFER_H
@@ -1,4 +1,5 @@
 #include "AudioService.h"
+#include "AudioDeviceRegistry.h"
 #include <QDir>
 #include <QFileInfo>
 #include <QStandardPaths>
@@ -79,6 +80,16 @@ QString AudioService::getServiceName() const
     return "AudioService";
 }
 
+bool AudioService::healthCheck()
+{
+    // The output in use must still be listed; silent mode is only healthy without any
+    const QAudioDevice device = currentOutputDevice();
+    if (device.isNull()) {
+        return deviceRegistry()->outputs().isEmpty();
+    }
+    return !deviceRegistry()->findOutput(QString::fromUtf8(device.id())).isNull();
+}
+
 // Playback control methods
 bool AudioService::play(const QUrl& mediaUrl)
 {
@@ -162,7 +173,7 @@ qint64 AudioService::duration() const
 // Device management methods
 QList<QAudioDevice> AudioService::getAvailableOutputDevices() const
 {
-    return QMediaDevices::audioOutputs();
+    return deviceRegistry()->outputs();
 }
 
 bool AudioService::setOutputDevice(const QAudioDevice& device)
@@ -175,6 +186,11 @@ bool AudioService::setOutputDevice(const QAudioDevice& device)
     return false;
 }
 
+bool AudioService::setOutputDevice(const QString& device)
+{
+    return setOutputDevice(deviceRegistry()->findOutput(device));
+}
+
 QAudioDevice AudioService::currentOutputDevice() const
 {
     return m_audioOutput ? m_audioOutput->device() : QAudioDevice();
@@ -182,7 +198,7 @@ QAudioDevice AudioService::currentOutputDevice() const
 
 QList<QAudioDevice> AudioService::getAvailableInputDevices() const
 {
-    return QMediaDevices::audioInputs();
+    return deviceRegistry()->inputs();
 }
 
 bool AudioService::setInputDevice(const QAudioDevice& device)
@@ -195,11 +211,24 @@ bool AudioService::setInputDevice(const QAudioDevice& device)
     return false;
 }
 
+bool AudioService::setInputDevice(const QString& device)
+{
+    return setInputDevice(deviceRegistry()->findInput(device));
+}
+
 QAudioDevice AudioService::currentInputDevice() const
 {
     return m_audioInput ? m_audioInput->device() : QAudioDevice();
 }
 
+AudioDeviceRegistry* AudioService::deviceRegistry() const
+{
+    if (!m_devices) {
+        m_devices = new AudioDeviceRegistry(const_cast<AudioService*>(this));
+    }
+    return m_devices;
+}
+
 // Recording control methods
 bool AudioService::startRecording(const QString& outputPath)
 {
@@ -546,7 +575,7 @@ bool AudioService::initializeMediaPlayer()
         // Check if Qt Multimedia is available at all
         QList<QAudioDevice> audioDevices;
         try {
-            audioDevices = QMediaDevices::audioOutputs();
+            audioDevices = deviceRegistry()->outputs();
         } catch (...) {
             qWarning() << "AudioService: Cannot enumerate audio devices - multimedia not available";
             return false;
@@ -625,7 +654,7 @@ bool AudioService::initializeMediaRecorder()
         // Check if audio input devices are available
         QList<QAudioDevice> inputDevices;
         try {
-            inputDevices = QMediaDevices::audioInputs();
+            inputDevices = deviceRegistry()->inputs();
         } catch (...) {
             qWarning() << "AudioService: Cannot enumerate audio input devices";
             return false;
@@ -694,10 +723,9 @@ bool AudioService::initializeMediaRecorder()
 
 void AudioService::initializeDeviceMonitoring()
 {
-    // Note: QMediaDevices doesn't have instance() method in Qt6
-    // Device monitoring would need to be implemented differently
-    // For now, we'll skip automatic device monitoring
-    qDebug() << "AudioService: Device monitoring not implemented in this Qt6 version";
+    // The registry follows QMediaDevices and enumerates again only on a change
+    connect(deviceRegistry(), &AudioDeviceRegistry::devicesChanged,
+            this, &AudioService::onAudioDevicesChanged, Qt::UniqueConnection);
 }
 
 int AudioService::validateVolume(int volume) const
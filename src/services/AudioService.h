@@ -14,6 +14,8 @@
 #include <QList>
 #include <memory>
 
+class AudioDeviceRegistry;
+
 /**
  * @brief Service for managing audio playback and device operations
  * 
@@ -25,7 +27,8 @@
  * - Audio playback control (play, pause, stop)
  * - Audio recording with format and quality selection
  * - Volume control with range validation
- * - Audio device enumeration and selection (input/output)
+ * - Audio device enumeration and selection (input/output), from a registry
+ *   that enumerates once and again only when the devices change
  * - Audio format handling and validation
  * - Comprehensive error handling and reporting
  * 
@@ -119,6 +122,13 @@ public:
      */
     bool setOutputDevice(const QAudioDevice& device);
 
+    /**
+     * @brief Set the audio output device by its id or description
+     * @param device Id or description, as saved in the settings
+     * @return true if the device exists and was set
+     */
+    bool setOutputDevice(const QString& device);
+
     /**
      * @brief Get the currently selected output device
      * @return Current output device
@@ -138,12 +148,25 @@ public:
      */
     bool setInputDevice(const QAudioDevice& device);
 
+    /**
+     * @brief Set the audio input device by its id or description
+     * @param device Id or description, as saved in the settings
+     * @return true if the device exists and was set
+     */
+    bool setInputDevice(const QString& device);
+
     /**
      * @brief Get the currently selected input device
      * @return Current input device
      */
     QAudioDevice currentInputDevice() const;
 
+    /**
+     * @brief Get the registry the devices are looked up in
+     * @return Registry, created on first use
+     */
+    AudioDeviceRegistry* deviceRegistry() const;
+
     // Recording control
     /**
      * @brief Start recording audio to the specified file
@@ -392,6 +415,7 @@ protected:
     bool doInitialize() override;
     void doShutdown() override;
     QString getServiceName() const override;
+    bool healthCheck() override;
 
 private slots:
     /**
@@ -520,6 +544,9 @@ private:
     QMediaFormat getDefaultRecordingFormat() const;
 
 private:
+    // Device registry, enumerated on first use rather than at construction
+    mutable AudioDeviceRegistry* m_devices = nullptr;
+
     // Playback components
     std::unique_ptr<QMediaPlayer> m_mediaPlayer;
     std::unique_ptr<QAudioOutput> m_audioOutput;
@@ -0,0 +1,223 @@
+#include "AutomationClock.h"
+#include <QCoreApplication>
+#include <QThread>
+#include <limits>
+
+AutomationClock* AutomationClock::wallClock()
+{
+    static QPointer<AutomationClock> clock;
+    if (!clock) {
+        clock = new AutomationClock(QCoreApplication::instance());
+    }
+    return clock;
+}
+
+AutomationClock::AutomationClock(QObject* parent)
+    : QObject(parent)
+{
+}
+
+qint64 AutomationClock::nowMs() const
+{
+    return QDateTime::currentMSecsSinceEpoch();
+}
+
+void AutomationClock::arm(ClockTimer* timer, qint64 deadlineMs)
+{
+    const qint64 delay = qBound<qint64>(0, deadlineMs - nowMs(), std::numeric_limits<int>::max());
+    timer->m_timer.start(int(delay));
+}
+
+void AutomationClock::disarm(ClockTimer* timer)
+{
+    timer->m_timer.stop();
+}
+
+SimulatedClock::SimulatedClock(const QDateTime& start, QObject* parent)
+    : AutomationClock(parent)
+    , m_nowMs(start.toMSecsSinceEpoch())
+{
+}
+
+SimulatedClock::~SimulatedClock()
+{
+    // Timers left armed will not fire; they would need another clock first
+    QMutexLocker locker(&m_mutex);
+    for (ClockTimer* timer : std::as_const(m_armed)) {
+        timer->m_active = false;
+    }
+}
+
+int SimulatedClock::advance(qint64 milliseconds)
+{
+    return milliseconds < 0 ? 0 : fireUntil(nowMs() + milliseconds);
+}
+
+int SimulatedClock::advanceTo(const QDateTime& time)
+{
+    return time.isValid() ? fireUntil(time.toMSecsSinceEpoch()) : 0;
+}
+
+bool SimulatedClock::step()
+{
+    const qint64 deadline = nextDeadlineMs();
+    if (deadline < 0) {
+        return false;
+    }
+    fireUntil(deadline);
+    return true;
+}
+
+qint64 SimulatedClock::nextDeadlineMs() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_armed.isEmpty() ? -1 : m_armed.firstKey().first;
+}
+
+int SimulatedClock::armedTimers() const
+{
+    QMutexLocker locker(&m_mutex);
+    return int(m_armed.size());
+}
+
+void SimulatedClock::arm(ClockTimer* timer, qint64 deadlineMs)
+{
+    QMutexLocker locker(&m_mutex);
+    const auto existing = m_keys.constFind(timer);
+    if (existing != m_keys.constEnd()) {
+        m_armed.remove(*existing);
+    }
+    const Key key(deadlineMs, m_sequence++);
+    m_armed.insert(key, timer);
+    m_keys.insert(timer, key);
+}
+
+void SimulatedClock::disarm(ClockTimer* timer)
+{
+    QMutexLocker locker(&m_mutex);
+    const auto it = m_keys.find(timer);
+    if (it != m_keys.end()) {
+        m_armed.remove(*it);
+        m_keys.erase(it);
+    }
+}
+
+int SimulatedClock::fireUntil(qint64 targetMs)
+{
+    // A handler that advances the clock itself would fire timers out of order
+    if (m_advancing) {
+        return 0;
+    }
+    m_advancing = true;
+
+    int fired = 0;
+    for (;;) {
+        ClockTimer* timer = nullptr;
+        {
+            QMutexLocker locker(&m_mutex);
+            if (m_armed.isEmpty() || m_armed.firstKey().first > targetMs) {
+                break;
+            }
+            const auto first = m_armed.begin();
+            timer = first.value();
+            m_nowMs.store(qMax(m_nowMs.load(), first.key().first));
+            m_keys.remove(timer);
+            m_armed.erase(first);
+        }
+
+        if (timer->thread() == QThread::currentThread()) {
+            timer->fire();
+        } else {
+            QMetaObject::invokeMethod(timer, [timer]() { timer->fire(); },
+                                      Qt::BlockingQueuedConnection);
+        }
+        ++fired;
+    }
+
+    m_nowMs.store(qMax(m_nowMs.load(), targetMs));
+    m_advancing = false;
+    return fired;
+}
+
+ClockTimer::ClockTimer(AutomationClock* clock, QObject* parent)
+    : QObject(parent)
+    , m_clock(clock)
+    , m_timer(this)
+{
+    m_timer.setSingleShot(true);
+    connect(&m_timer, &QTimer::timeout, this, &ClockTimer::fire);
+}
+
+ClockTimer::~ClockTimer()
+{
+    stop();
+}
+
+void ClockTimer::setClock(AutomationClock* clock)
+{
+    stop();
+    m_clock = clock;
+}
+
+AutomationClock* ClockTimer::clock() const
+{
+    return m_clock ? m_clock.data() : AutomationClock::wallClock();
+}
+
+qint64 ClockTimer::remainingTime() const
+{
+    return m_active ? qMax<qint64>(0, m_deadlineMs - clock()->nowMs()) : -1;
+}
+
+void ClockTimer::singleShot(AutomationClock* clock, int milliseconds, QObject* context,
+                            std::function<void()> functor)
+{
+    ClockTimer* timer = new ClockTimer(clock, context);
+    timer->setSingleShot(true);
+    connect(timer, &ClockTimer::timeout, context, [timer, functor = std::move(functor)]() {
+        functor();
+        timer->deleteLater();
+    });
+    timer->start(milliseconds);
+}
+
+void ClockTimer::start()
+{
+    start(m_interval);
+}
+
+void ClockTimer::start(int milliseconds)
+{
+    stop();
+    m_interval = qMax(0, milliseconds);
+    m_active = true;
+    AutomationClock* current = clock();
+    m_deadlineMs = current->nowMs() + m_interval;
+    current->arm(this, m_deadlineMs);
+}
+
+void ClockTimer::stop()
+{
+    if (!m_active) {
+        return;
+    }
+    m_active = false;
+    clock()->disarm(this);
+}
+
+void ClockTimer::fire()
+{
+    if (!m_active) {
+        return;
+    }
+
+    if (m_singleShot) {
+        m_active = false;
+    } else {
+        // From this firing, so a simulated repeat lands exactly an interval later
+        AutomationClock* current = clock();
+        m_deadlineMs = current->nowMs() + qMax(1, m_interval);
+        current->arm(this, m_deadlineMs);
+    }
+    emit timeout();
+}
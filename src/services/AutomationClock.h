@@ -0,0 +1,199 @@
+#ifndef AUTOMATIONCLOCK_H
+#define AUTOMATIONCLOCK_H
+
+#include <QDateTime>
+#include <QHash>
+#include <QMap>
+#include <QMutex>
+#include <QObject>
+#include <QPair>
+#include <QPointer>
+#include <QTimer>
+#include <atomic>
+#include <functional>
+
+class ClockTimer;
+
+/**
+ * @brief The time the automation runs on
+ *
+ * SchedulerEngine, RotationEngine, the library snapshots, BroadcastWorker
+ * and AutomationDaemon read the time and wait through their clock rather
+ * than through QDateTime::currentDateTime() and QTimer. The wall clock,
+ * wallClock(), is what they use unless given another. It is the system time,
+ * and its ClockTimers are QTimers.
+ *
+ * SimulatedClock stands still until it is advanced. Its ClockTimers fire
+ * when it is advanced past them, at their exact deadline, so a week of
+ * pubs, programs and hourly rescans replays in as long as the handlers take.
+ *
+ * @since XFB 2.0
+ */
+class AutomationClock : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief The system clock, made on first use
+     */
+    static AutomationClock* wallClock();
+
+    explicit AutomationClock(QObject* parent = nullptr);
+
+    /**
+     * @brief Milliseconds since the epoch; safe from any thread
+     */
+    virtual qint64 nowMs() const;
+    QDateTime now() const { return QDateTime::fromMSecsSinceEpoch(nowMs()); }
+
+    virtual bool isSimulated() const { return false; }
+
+protected:
+    friend class ClockTimer;
+
+    /**
+     * @brief Have a timer fire at a deadline; called from the timer's thread
+     */
+    virtual void arm(ClockTimer* timer, qint64 deadlineMs);
+    virtual void disarm(ClockTimer* timer);
+};
+
+/**
+ * @brief A clock that only moves when told to
+ *
+ * advance() and advanceTo() fire the timers whose deadline they pass in
+ * deadline order, and in the order they were armed for equal deadlines,
+ * with now() at the deadline of each, so handlers see no jitter. A
+ * repeating timer is re-armed an interval after its deadline. Timers of
+ * other threads fire on their thread, and advancing waits for them.
+ *
+ * @example
+ * @code
+ * SimulatedClock clock(QDateTime(QDate(2024, 5, 13), QTime(0, 0)));
+ * scheduler.setClock(&clock);
+ * scheduler.start();
+ * clock.advance(7 * 24 * 3600 * 1000LL);   // a week of events, in seconds
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class SimulatedClock : public AutomationClock
+{
+    Q_OBJECT
+
+public:
+    explicit SimulatedClock(const QDateTime& start, QObject* parent = nullptr);
+    ~SimulatedClock() override;
+
+    qint64 nowMs() const override { return m_nowMs.load(); }
+    bool isSimulated() const override { return true; }
+
+    /**
+     * @brief Move the time forward, firing what falls due on the way
+     * @param milliseconds How far; negative moves nothing
+     * @return Timers fired
+     */
+    int advance(qint64 milliseconds);
+
+    /**
+     * @brief Move the time forward to a point, firing what falls due on the way
+     * @return Timers fired
+     */
+    int advanceTo(const QDateTime& time);
+
+    /**
+     * @brief Jump to the next deadline and fire what is due there
+     * @return false if no timer is armed
+     */
+    bool step();
+
+    /**
+     * @brief Deadline of the next timer, -1 if none is armed
+     */
+    qint64 nextDeadlineMs() const;
+    int armedTimers() const;
+
+protected:
+    void arm(ClockTimer* timer, qint64 deadlineMs) override;
+    void disarm(ClockTimer* timer) override;
+
+private:
+    using Key = QPair<qint64, quint64>;   ///< Deadline, then order of arming
+
+    int fireUntil(qint64 targetMs);
+
+    std::atomic<qint64> m_nowMs;
+    mutable QMutex m_mutex;
+    QMap<Key, ClockTimer*> m_armed;       ///< Guarded by m_mutex
+    QHash<ClockTimer*, Key> m_keys;       ///< Guarded by m_mutex
+    quint64 m_sequence = 0;               ///< Guarded by m_mutex
+    bool m_advancing = false;
+};
+
+/**
+ * @brief QTimer on an AutomationClock
+ *
+ * Has the parts of QTimer the automation uses. On the wall clock it is a
+ * QTimer; on a SimulatedClock it fires when the clock passes its deadline.
+ *
+ * @since XFB 2.0
+ */
+class ClockTimer : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @param clock Clock to run on; nullptr for the wall clock
+     */
+    explicit ClockTimer(AutomationClock* clock = nullptr, QObject* parent = nullptr);
+    ~ClockTimer() override;
+
+    /**
+     * @brief Run on another clock; stops the timer
+     */
+    void setClock(AutomationClock* clock);
+    AutomationClock* clock() const;
+
+    void setSingleShot(bool singleShot) { m_singleShot = singleShot; }
+    bool isSingleShot() const { return m_singleShot; }
+    void setInterval(int milliseconds) { m_interval = qMax(0, milliseconds); }
+    int interval() const { return m_interval; }
+    void setTimerType(Qt::TimerType type) { m_timer.setTimerType(type); }
+    bool isActive() const { return m_active; }
+
+    /**
+     * @brief Milliseconds until it fires on its clock, -1 if it is not active
+     */
+    qint64 remainingTime() const;
+
+    /**
+     * @brief Call a functor once, after a delay on a clock, unless context is gone
+     */
+    static void singleShot(AutomationClock* clock, int milliseconds, QObject* context,
+                           std::function<void()> functor);
+
+public slots:
+    void start();
+    void start(int milliseconds);
+    void stop();
+
+signals:
+    void timeout();
+
+private:
+    friend class AutomationClock;
+    friend class SimulatedClock;
+
+    void fire();
+
+    QPointer<AutomationClock> m_clock;
+    QTimer m_timer;           ///< On the wall clock
+    int m_interval = 0;
+    bool m_singleShot = false;
+    bool m_active = false;
+    qint64 m_deadlineMs = 0;
+};
+
+#endif // AUTOMATIONCLOCK_H
@@ -0,0 +1,183 @@
+#include "BackTimer.h"
+#include "../models/PlaylistQueueModel.h"
+#include <algorithm>
+
+BackTimer::BackTimer(PlaylistQueueModel* queue, QObject* parent)
+    : QObject(parent)
+    , m_queue(queue)
+{
+    if (!queue) {
+        return;
+    }
+    connect(queue, &QAbstractItemModel::rowsInserted, this,
+            [this](const QModelIndex&, int first, int) { truncateFrom(first); });
+    connect(queue, &QAbstractItemModel::rowsRemoved, this,
+            [this](const QModelIndex&, int first, int last) {
+                // Playing the head of the queue is the common case, and moves every start
+                if (first == 0) {
+                    dropHead(last + 1);
+                } else {
+                    truncateFrom(first);
+                }
+            });
+    connect(queue, &QAbstractItemModel::rowsMoved, this,
+            [this](const QModelIndex&, int start, int, const QModelIndex&, int row) {
+                truncateFrom(qMin(start, row));
+            });
+    connect(queue, &QAbstractItemModel::dataChanged, this,
+            [this](const QModelIndex& topLeft) { truncateFrom(topLeft.row()); });
+    connect(queue, &QAbstractItemModel::modelReset, this, [this]() { truncateFrom(0); });
+}
+
+void BackTimer::setOverlapMs(qint64 overlapMs)
+{
+    overlapMs = qMax<qint64>(0, overlapMs);
+    if (overlapMs != m_overlapMs) {
+        m_overlapMs = overlapMs;
+        truncateFrom(0);
+    }
+}
+
+BackTimer::Plan BackTimer::plan(const QDateTime& now, qint64 currentRemainingMs,
+                                const QDateTime& eventAt)
+{
+    Plan plan;
+    plan.eventAt = eventAt;
+    if (!m_queue || !now.isValid() || !eventAt.isValid()) {
+        return plan;
+    }
+    const qint64 untilEventMs = now.msecsTo(eventAt);
+    if (untilEventMs < 0) {
+        return plan;
+    }
+    plan.valid = true;
+    if (currentRemainingMs < 0) {
+        return plan;
+    }
+
+    // The head of the queue starts when what plays now fades into it
+    const qint64 headStartMs = qMax<qint64>(0, currentRemainingMs - m_overlapMs);
+    if (currentRemainingMs > 0 && headStartMs >= untilEventMs) {
+        if (headStartMs == untilEventMs) {
+            plan.ending = Ending::OnTime;
+        } else {
+            plan.ending = Ending::Cut;
+            plan.cutAfterMs = untilEventMs;
+        }
+        return plan;
+    }
+
+    const qint64 fillMs = untilEventMs - headStartMs;
+    extendTo(-1, fillMs);
+    const int count = m_queue->count();
+    const int read = int(m_starts.size()) - 1;
+    const qint64 base = m_starts.front();
+
+    // The last row that starts by the time of the event
+    const auto after = std::upper_bound(m_starts.cbegin(), m_starts.cend(), base + fillMs);
+    const int row = int(after - m_starts.cbegin()) - 1;
+    const qint64 gapMs = fillMs - (m_starts[size_t(row)] - base);
+    plan.fitCount = row;
+
+    if (row == read) {
+        if (m_blocked || read < count) {
+            return plan;
+        }
+        plan.ending = gapMs == 0 ? Ending::OnTime : Ending::Short;
+        plan.gapMs = gapMs;
+        return plan;
+    }
+
+    if (gapMs == 0) {
+        plan.ending = Ending::OnTime;
+        return plan;
+    }
+
+    // Of the next few entries, the longest that still ends by the event
+    qint64 bestMs = 0;
+    const int last = qMin(count, row + 1 + FILL_LOOKAHEAD);
+    for (int candidate = row + 1; candidate < last; ++candidate) {
+        const qint64 length = lengthOf(candidate);
+        if (length > bestMs && length <= gapMs) {
+            plan.fillRow = candidate;
+            bestMs = length;
+        }
+    }
+
+    if (gapMs >= MIN_CUT_MS) {
+        plan.ending = Ending::Cut;
+        plan.cutRow = row;
+        plan.cutAfterMs = gapMs;
+    } else {
+        plan.ending = Ending::Early;
+        plan.earlyMs = gapMs;
+    }
+    return plan;
+}
+
+qint64 BackTimer::startOffsetMs(int row)
+{
+    if (!m_queue || row < 0 || row > m_queue->count()) {
+        return -1;
+    }
+    extendTo(row, -1);
+    if (row >= int(m_starts.size())) {
+        return -1;
+    }
+    return m_starts[size_t(row)] - m_starts.front();
+}
+
+void BackTimer::extendTo(int row, qint64 untilMs)
+{
+    if (!m_queue) {
+        return;
+    }
+    const int count = m_queue->count();
+    while (!m_blocked) {
+        const int next = int(m_starts.size()) - 1;   // Row whose end is read next
+        if (next >= count) {
+            break;
+        }
+        const bool rowNeeded = next < row;
+        const bool timeNeeded = untilMs >= 0 && m_starts.back() - m_starts.front() <= untilMs;
+        if (!rowNeeded && !timeNeeded) {
+            break;
+        }
+        const qint64 length = lengthOf(next);
+        ++m_entriesRead;
+        if (length < 0) {
+            m_blocked = true;
+            break;
+        }
+        m_starts.push_back(m_starts.back() + length);
+    }
+}
+
+qint64 BackTimer::lengthOf(int row) const
+{
+    const PlaylistQueueModel::Entry& entry = m_queue->entry(row);
+    const qint64 airTimeUs = entry.pending ? -1 : entry.airTimeUs();
+    if (airTimeUs < 0) {
+        return -1;
+    }
+    return qMax<qint64>(0, airTimeUs / 1000 - m_overlapMs);
+}
+
+void BackTimer::truncateFrom(int row)
+{
+    // The start of the row itself is still right
+    if (row >= 0 && int(m_starts.size()) > row) {
+        m_starts.resize(size_t(row) + 1);
+        m_blocked = false;
+    }
+}
+
+void BackTimer::dropHead(int rows)
+{
+    if (rows < int(m_starts.size())) {
+        m_starts.erase(m_starts.begin(), m_starts.begin() + rows);
+    } else {
+        m_starts.assign(1, 0);
+        m_blocked = false;
+    }
+}
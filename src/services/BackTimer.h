@@ -0,0 +1,130 @@
+#ifndef BACKTIMER_H
+#define BACKTIMER_H
+
+#include <QDateTime>
+#include <QObject>
+#include <QPointer>
+#include <deque>
+
+class PlaylistQueueModel;
+
+/**
+ * @brief Works back from a hard-timed event to what must play before it
+ *
+ * Scheduled pubs and programs used to go on top of the queue when their
+ * minute came, so they aired whenever the track on air happened to end.
+ * BackTimer tells, for an event at a given time, which entries of the
+ * queue play in full before it and what happens in the time that is left:
+ *
+ * - OnTime: the entries end exactly when the event is due.
+ * - Cut: the track on air at the event, the current one or an entry, is
+ *   faded under the event, which starts on the dot.
+ * - Early: what is left is shorter than MIN_CUT_MS, not worth starting a
+ *   track for, so the event follows the entries that fit, that much early.
+ * - Short: the queue ends before the event; gapMs is still to be filled.
+ * - Unknown: an entry before the event has no known duration.
+ *
+ * When a shorter entry among the FILL_LOOKAHEAD after the ones that fit
+ * would fill the time left better, its row is given as fillRow, to be
+ * moved up before the event.
+ *
+ * The air time of an entry is its duration between its cue points, less
+ * the overlap of a crossfade into the next. The start time of each entry
+ * is kept as a running sum that follows the queue: playing the head of it
+ * drops the first sums, and any other change only drops the sums from the
+ * changed row on. A plan therefore only reads the entries it did not
+ * read before and never walks the whole playlist.
+ *
+ * @example
+ * @code
+ * BackTimer backTimer(playlistQueue);
+ * backTimer.setOverlapMs(crossfadeMs);
+ * const BackTimer::Plan plan = backTimer.plan(now, remainingMs, event.fireAt);
+ * if (plan.ending == BackTimer::Ending::Cut)
+ *     armCutAt(plan.eventAt);
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class BackTimer : public QObject
+{
+    Q_OBJECT
+
+public:
+    /// Shortest a queued track is started for before an event
+    static constexpr qint64 MIN_CUT_MS = 15000;
+    /// Entries past the ones that fit that are looked at for a fill
+    static constexpr int FILL_LOOKAHEAD = 10;
+
+    enum class Ending {
+        OnTime,
+        Cut,
+        Early,
+        Short,
+        Unknown
+    };
+
+    /**
+     * @brief How the queue meets one event
+     */
+    struct Plan {
+        bool valid = false;
+        QDateTime eventAt;
+        Ending ending = Ending::Unknown;
+        int fitCount = 0;        ///< Entries from the head that play in full before the event
+        int cutRow = -1;         ///< Cut: row of the entry faded under it; -1 for the current
+        qint64 cutAfterMs = 0;   ///< Cut: how long that track plays from its start, or from now
+        qint64 earlyMs = 0;      ///< Early: how much before its time the event starts
+        qint64 gapMs = 0;        ///< Short: time between the end of the queue and the event
+        int fillRow = -1;        ///< Entry that would fill the time left better, -1 if none
+
+        /**
+         * @brief When the event goes on air under this plan
+         */
+        QDateTime startsAt() const { return eventAt.addMSecs(-earlyMs); }
+    };
+
+    explicit BackTimer(PlaylistQueueModel* queue, QObject* parent = nullptr);
+
+    /**
+     * @brief Set how much each track overlaps the next, the crossfade
+     */
+    void setOverlapMs(qint64 overlapMs);
+    qint64 overlapMs() const { return m_overlapMs; }
+
+    /**
+     * @brief Plan the queue up to an event
+     * @param now Current time
+     * @param currentRemainingMs Air time left of what plays before the head of the queue; 0
+     *        if nothing does, negative if unknown
+     * @param eventAt When the event is due
+     * @return Invalid if the event is in the past
+     */
+    Plan plan(const QDateTime& now, qint64 currentRemainingMs, const QDateTime& eventAt);
+
+    /**
+     * @brief Time from the start of the head of the queue to the start of a row
+     * @return -1 if an entry before the row has no known duration, or the row does not exist
+     */
+    qint64 startOffsetMs(int row);
+
+    /**
+     * @brief Entries whose air time was added up since the planner was made
+     */
+    int entriesRead() const { return m_entriesRead; }
+
+private:
+    void extendTo(int row, qint64 untilMs);
+    qint64 lengthOf(int row) const;
+    void truncateFrom(int row);
+    void dropHead(int rows);
+
+    QPointer<PlaylistQueueModel> m_queue;
+    qint64 m_overlapMs = 0;
+    /// Running start time of each row read so far; one more than the rows read
+    std::deque<qint64> m_starts{0};
+    bool m_blocked = false;      ///< The row after the last start has no known duration
+    int m_entriesRead = 0;
+};
+
+#endif // BACKTIMER_H
@@ -0,0 +1,173 @@
+#include "BackgroundThrottle.h"
+#include <QDebug>
+#include <QThread>
+#include <algorithm>
+
+#if defined(Q_OS_LINUX)
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(Q_OS_MACOS)
+#include <pthread.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#elif defined(Q_OS_UNIX)
+#include <unistd.h>
+#elif defined(Q_OS_WIN)
+#include <windows.h>
+#endif
+
+namespace {
+
+// Level of the process, read by the workers
+std::atomic<int> g_level{int(BackgroundThrottle::Level::Full)};
+
+#ifdef Q_OS_LINUX
+// From linux/ioprio.h, which not every libc ships
+constexpr int IOPRIO_WHO_PROCESS = 1;
+constexpr int IOPRIO_CLASS_IDLE = 3;
+constexpr int IOPRIO_CLASS_SHIFT = 13;
+
+// who is 0: the calling thread, or the whole process right after fork()
+void setIdleIoPriority()
+{
+    ::syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT);
+}
+#endif
+
+} // namespace
+
+BackgroundThrottle::BackgroundThrottle(QObject* parent)
+    : QObject(parent)
+{
+    m_timer.setInterval(SAMPLE_MS);
+    connect(&m_timer, &QTimer::timeout, this, &BackgroundThrottle::update);
+}
+
+BackgroundThrottle::~BackgroundThrottle()
+{
+    stop();
+}
+
+void BackgroundThrottle::start()
+{
+    m_timer.start();
+    update();
+}
+
+void BackgroundThrottle::stop()
+{
+    m_timer.stop();
+    setLevel(Level::Full);
+}
+
+void BackgroundThrottle::update()
+{
+    const int fill = m_fill ? m_fill() : -1;
+    qint64 msToEvent = -1;
+    if (m_nextEvent) {
+        const QDateTime next = m_nextEvent();
+        if (next.isValid()) {
+            msToEvent = std::max<qint64>(0, QDateTime::currentDateTime().msecsTo(next));
+        }
+    }
+
+    // Backing off is immediate; going back up waits until the hold is over
+    const Level wanted = evaluate(fill, msToEvent);
+    if (wanted >= m_level) {
+        m_sinceBackoff.start();
+        setLevel(wanted);
+    } else if (!m_sinceBackoff.isValid() || m_sinceBackoff.elapsed() >= m_holdMs) {
+        m_sinceBackoff.start();
+        setLevel(wanted);
+    }
+}
+
+BackgroundThrottle::Level BackgroundThrottle::evaluate(int fillPercent, qint64 msToEvent)
+{
+    if (msToEvent >= 0 && msToEvent <= EVENT_GUARD_MS) {
+        return Level::Paused;
+    }
+    if (fillPercent < 0) {
+        return Level::Full;
+    }
+    if (fillPercent < PAUSED_FILL_PERCENT) {
+        return Level::Paused;
+    }
+    return fillPercent < REDUCED_FILL_PERCENT ? Level::Reduced : Level::Full;
+}
+
+BackgroundThrottle::Level BackgroundThrottle::level()
+{
+    return Level(g_level.load(std::memory_order_relaxed));
+}
+
+int BackgroundThrottle::workerLimit(int maxWorkers)
+{
+    switch (level()) {
+    case Level::Full:
+        return maxWorkers;
+    case Level::Reduced:
+        return std::max(1, maxWorkers / 2);
+    case Level::Paused:
+        return std::min(1, maxWorkers);
+    }
+    return maxWorkers;
+}
+
+void BackgroundThrottle::pace(const std::atomic_bool* cancelled)
+{
+    if (level() == Level::Reduced) {
+        QThread::msleep(REDUCED_DELAY_MS);
+        return;
+    }
+    for (int waited = 0; level() == Level::Paused && waited < MAX_PAUSE_MS;
+         waited += PAUSE_POLL_MS) {
+        if (cancelled && cancelled->load()) {
+            return;
+        }
+        QThread::msleep(PAUSE_POLL_MS);
+    }
+}
+
+void BackgroundThrottle::lowerCurrentThread()
+{
+#if defined(Q_OS_LINUX)
+    // A thread id names the thread alone to setpriority() on Linux; the
+    // niceness is set, not added to, so calling this again changes nothing
+    const id_t thread = id_t(::syscall(SYS_gettid));
+    ::setpriority(PRIO_PROCESS, thread,
+                  std::max(CHILD_NICE_INCREMENT, ::getpriority(PRIO_PROCESS, thread)));
+    setIdleIoPriority();
+#elif defined(Q_OS_MACOS)
+    // The background class also throttles the thread's disk access
+    pthread_set_qos_class_self_np(QOS_CLASS_BACKGROUND, 0);
+#elif defined(Q_OS_WIN)
+    SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+#endif
+}
+
+void BackgroundThrottle::lowerChildProcess(int niceIncrement)
+{
+#if defined(Q_OS_UNIX)
+    [[maybe_unused]] int niceness = ::nice(niceIncrement);
+#else
+    Q_UNUSED(niceIncrement);
+#endif
+#if defined(Q_OS_LINUX)
+    setIdleIoPriority();
+#elif defined(Q_OS_MACOS)
+    ::setiopolicy_np(IOPOL_TYPE_DISK, IOPOL_SCOPE_PROCESS, IOPOL_THROTTLE);
+#endif
+}
+
+void BackgroundThrottle::setLevel(Level level)
+{
+    if (level == m_level) {
+        return;
+    }
+    m_level = level;
+    g_level.store(int(level), std::memory_order_relaxed);
+    qDebug() << "BackgroundThrottle: background work is now" << level;
+    emit levelChanged(level);
+}
@@ -0,0 +1,175 @@
+#ifndef BACKGROUNDTHROTTLE_H
+#define BACKGROUNDTHROTTLE_H
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+#include <atomic>
+#include <functional>
+
+/**
+ * @brief Keeps background work out of the way of the broadcast
+ *
+ * Imports, conversions and loudness scans ran at whatever priority their
+ * threads got, and a large one could starve the decoder of the deck on
+ * air of CPU or disk. Two things keep them back now.
+ *
+ * Their threads and processes run at a lower OS priority, see
+ * lowerCurrentThread() and lowerChildProcess(): on Linux a higher nice
+ * value and the idle I/O class, on macOS the background QoS class, which
+ * also throttles disk access, and on Windows background mode.
+ *
+ * And they back off while the broadcast needs the machine. Every SAMPLE_MS
+ * the throttle looks at how full the on-air deck's buffer is and how soon
+ * the scheduler fires next, and sets a level that any thread can read:
+ * - Reduced when the buffer drops below REDUCED_FILL_PERCENT;
+ * - Paused when it drops below PAUSED_FILL_PERCENT, or within
+ *   EVENT_GUARD_MS before a scheduled event.
+ * A level is kept for holdMs() after its cause went away, so the work does
+ * not start and stop with each sample. Workers call pace() before each
+ * item, which waits while Paused and slows them down while Reduced, and
+ * pools of external processes start at most workerLimit() of them.
+ *
+ * The level belongs to the process; one throttle drives it, and with none
+ * running it is Full.
+ *
+ * @example
+ * @code
+ * auto* throttle = new BackgroundThrottle(this);
+ * throttle->setFillProvider([engine]() { return engine->bufferFillPercent(); });
+ * throttle->setEventProvider([scheduler]() { return scheduler->nextFireTime(); });
+ * throttle->start();
+ *
+ * // On a worker thread, before each file
+ * BackgroundThrottle::pace(&cancelled);
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class BackgroundThrottle : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class Level {
+        Full,      ///< Nothing on air needs the machine
+        Reduced,   ///< The on-air buffer is getting low
+        Paused     ///< The buffer is nearly empty, or a scheduled event is near
+    };
+    Q_ENUM(Level)
+
+    static constexpr int SAMPLE_MS = 250;
+    static constexpr int REDUCED_FILL_PERCENT = 80;
+    static constexpr int PAUSED_FILL_PERCENT = 50;
+    static constexpr int EVENT_GUARD_MS = 60 * 1000;
+    static constexpr int DEFAULT_HOLD_MS = 5000;
+    static constexpr int REDUCED_DELAY_MS = 50;    ///< pace() sleeps this long while Reduced
+    static constexpr int PAUSE_POLL_MS = 100;
+    static constexpr int MAX_PAUSE_MS = 30 * 1000; ///< pace() never waits longer than this
+    static constexpr int CHILD_NICE_INCREMENT = 10;
+
+    /// Fill of the on-air buffer in percent, or -1 when nothing is on air
+    using FillProvider = std::function<int()>;
+
+    /// Time of the next scheduled event, invalid if there is none
+    using EventProvider = std::function<QDateTime()>;
+
+    explicit BackgroundThrottle(QObject* parent = nullptr);
+    ~BackgroundThrottle() override;
+
+    void setFillProvider(FillProvider provider) { m_fill = std::move(provider); }
+    void setEventProvider(EventProvider provider) { m_nextEvent = std::move(provider); }
+
+    /**
+     * @brief Set how long a level is kept after its cause went away
+     */
+    void setHoldMs(int ms) { m_holdMs = qMax(0, ms); }
+    int holdMs() const { return m_holdMs; }
+
+    /**
+     * @brief Start sampling every SAMPLE_MS
+     */
+    void start();
+
+    /**
+     * @brief Stop sampling and let background work run at Full
+     */
+    void stop();
+
+    bool isRunning() const { return m_timer.isActive(); }
+
+    /**
+     * @brief Sample the providers once and update the level
+     */
+    void update();
+
+    /**
+     * @brief Level the throttle set last
+     */
+    Level currentLevel() const { return m_level; }
+
+    /**
+     * @brief Level for a buffer fill and the time to the next event
+     * @param fillPercent Fill of the on-air buffer, -1 when nothing is on air
+     * @param msToEvent Milliseconds to the next scheduled event, -1 if none
+     */
+    static Level evaluate(int fillPercent, qint64 msToEvent);
+
+    /**
+     * @brief Level in force for the process; may be called from any thread
+     */
+    static Level level();
+
+    /**
+     * @brief Number of workers a pool of maxWorkers may run at the current level
+     *
+     * Half of them while Reduced and one while Paused, so work already
+     * queued keeps moving, slowly.
+     */
+    static int workerLimit(int maxWorkers);
+
+    /**
+     * @brief Wait as long as the level asks, before the next item of work
+     *
+     * Waits while Paused, for up to MAX_PAUSE_MS, and REDUCED_DELAY_MS while
+     * Reduced; returns at once at Full.
+     * @param cancelled Stops the wait early once set; may be nullptr
+     */
+    static void pace(const std::atomic_bool* cancelled = nullptr);
+
+    /**
+     * @brief Lower the CPU and I/O priority of the calling thread, for good
+     *
+     * Only for threads that do nothing but background work: without
+     * privileges the priority cannot be raised again. Calling it again on
+     * the same thread changes nothing.
+     */
+    static void lowerCurrentThread();
+
+    /**
+     * @brief Lower the CPU and I/O priority of a child process
+     *
+     * For QProcess::setChildProcessModifier(); only async-signal-safe calls are made.
+     * @param niceIncrement Added to the niceness on Unix
+     */
+    static void lowerChildProcess(int niceIncrement = CHILD_NICE_INCREMENT);
+
+signals:
+    /**
+     * @brief Emitted when the level changed
+     */
+    void levelChanged(BackgroundThrottle::Level level);
+
+private:
+    void setLevel(Level level);
+
+    FillProvider m_fill;
+    EventProvider m_nextEvent;
+    QTimer m_timer;
+    int m_holdMs = DEFAULT_HOLD_MS;
+    Level m_level = Level::Full;
+    QElapsedTimer m_sinceBackoff;   ///< Since the level the throttle is at was last called for
+};
+
+#endif // BACKGROUNDTHROTTLE_H
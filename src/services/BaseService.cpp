@@ -1,6 +1,28 @@
 #include "BaseService.h"
 #include <QDebug>
 #include <QDateTime>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSet>
+#include <QThread>
+
+namespace {
+
+// Running services, checked by the one health check timer
+QMutex healthMutex;
+QSet<BaseService*> healthChecked;
+QTimer* healthTimer = nullptr;
+
+void checkRunningServices()
+{
+    QMutexLocker locker(&healthMutex);
+    for (BaseService* service : std::as_const(healthChecked)) {
+        // Run on the service's thread; dropped if the service is gone by then
+        QMetaObject::invokeMethod(service, [service]() { service->checkHealth(); });
+    }
+}
+
+} // namespace
 
 BaseService::BaseService(QObject* parent)
     : IService(parent)
@@ -13,6 +35,11 @@ BaseService::BaseService(QObject* parent)
 
 BaseService::~BaseService()
 {
+    {
+        QMutexLocker locker(&healthMutex);
+        healthChecked.remove(this);
+    }
+
     // Don't call virtual methods in destructor
     if (state() == ServiceState::Running) {
         setState(ServiceState::Stopping);
@@ -36,17 +63,31 @@ bool BaseService::initialize()
     logDebug("Starting initialization...");
     setState(ServiceState::Initializing);
     
-    // Start initialization timeout timer
-    m_initializationTimer->start();
+    // Start initialization timeout timer; the container may initialize the
+    // service on a worker thread, where the timer cannot be started
+    if (QThread::currentThread() == thread()) {
+        m_initializationTimer->start();
+    }
     
+    QElapsedTimer lifecycleTimer;
+    lifecycleTimer.start();
     try {
-        if (doInitialize()) {
+        const bool initialized = doInitialize();
+        m_initializeMs = lifecycleTimer.elapsed();
+        if (MetricsRegistry::Gauge* gauge = lifecycleGauge("initialize")) {
+            gauge->set(double(m_initializeMs));
+        }
+        if (initialized) {
             m_initializationTimer->stop();
             m_initializationTime = QDateTime::currentDateTime();
             m_uptimeTimer.start();
             setState(ServiceState::Running);
             clearError();
-            logDebug("Initialization completed successfully");
+            {
+                QMutexLocker locker(&healthMutex);
+                healthChecked.insert(this);
+            }
+            logDebug(QString("Initialization completed in %1 ms").arg(m_initializeMs));
             return true;
         } else {
             m_initializationTimer->stop();
@@ -75,13 +116,23 @@ void BaseService::shutdown()
 
     logDebug("Starting shutdown...");
     setState(ServiceState::Stopping);
+    {
+        QMutexLocker locker(&healthMutex);
+        healthChecked.remove(this);
+    }
     
     m_initializationTimer->stop();
     
+    QElapsedTimer lifecycleTimer;
+    lifecycleTimer.start();
     try {
         doShutdown();
+        m_shutdownMs = lifecycleTimer.elapsed();
+        if (MetricsRegistry::Gauge* gauge = lifecycleGauge("shutdown")) {
+            gauge->set(double(m_shutdownMs));
+        }
         setState(ServiceState::Stopped);
-        logDebug("Shutdown completed successfully");
+        logDebug(QString("Shutdown completed in %1 ms").arg(m_shutdownMs));
     } catch (const std::exception& e) {
         setError(QString("Exception during shutdown: %1").arg(e.what()));
         logError(QString("Exception during shutdown: %1").arg(e.what()));
@@ -96,6 +147,92 @@ QString BaseService::serviceName() const
     return getServiceName();
 }
 
+void BaseService::startHealthChecks(int intervalMs)
+{
+    if (!healthTimer) {
+        healthTimer = new QTimer();
+        QObject::connect(healthTimer, &QTimer::timeout, healthTimer, &checkRunningServices);
+    }
+    healthTimer->start(intervalMs);
+}
+
+void BaseService::stopHealthChecks()
+{
+    delete healthTimer;
+    healthTimer = nullptr;
+}
+
+bool BaseService::checkHealth()
+{
+    if (state() != ServiceState::Running) {
+        return false;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    bool healthy = false;
+    try {
+        healthy = healthCheck();
+    } catch (...) {
+        healthy = false;
+    }
+    m_lastHealthCheckUs = timer.nsecsElapsed() / 1000;
+
+    if (!m_healthLatency) {
+        MetricsRegistry& metrics = MetricsRegistry::instance();
+        const QString name = "xfb_service_" + metricName(getServiceName());
+        m_healthLatency = metrics.histogram(name + "_health_check_microseconds",
+                                            QString("Time the health check of %1 takes")
+                                                .arg(getServiceName()));
+        m_healthGauge = metrics.gauge(name + "_healthy",
+                                      QString("1 if %1 passed its last health check")
+                                          .arg(getServiceName()));
+    }
+    if (m_healthLatency) {
+        m_healthLatency->record(m_lastHealthCheckUs);
+    }
+    if (m_healthGauge) {
+        m_healthGauge->set(healthy ? 1.0 : 0.0);
+    }
+
+    if (healthy != m_healthy) {
+        m_healthy = healthy;
+        if (healthy) {
+            logDebug("Health check passes again");
+        } else {
+            logWarning(QString("Health check failed (%1 us)").arg(m_lastHealthCheckUs));
+        }
+        emit healthChanged(healthy);
+    }
+    return healthy;
+}
+
+QString BaseService::metricName(const QString& serviceName)
+{
+    QString name;
+    for (int i = 0; i < serviceName.size(); ++i) {
+        const QChar c = serviceName[i];
+        // A word starts at a capital after a small letter, or at the last capital of an acronym
+        if (i > 0 && c.isUpper()) {
+            const QChar previous = serviceName[i - 1];
+            const bool acronymEnds = previous.isUpper() && i + 1 < serviceName.size()
+                                     && serviceName[i + 1].isLower();
+            if (previous.isLower() || previous.isDigit() || acronymEnds) {
+                name += '_';
+            }
+        }
+        name += c.isLetterOrNumber() && c.unicode() < 128 ? c.toLower() : QChar('_');
+    }
+    return name;
+}
+
+MetricsRegistry::Gauge* BaseService::lifecycleGauge(const char* phase) const
+{
+    return MetricsRegistry::instance().gauge(
+        QString("xfb_service_%1_%2_milliseconds").arg(metricName(getServiceName()), phase),
+        QString("Time %1 took to %2").arg(getServiceName(), phase));
+}
+
 qint64 BaseService::uptime() const
 {
     if (!m_initializationTime.isValid() || !m_uptimeTimer.isValid()) {
@@ -2,6 +2,7 @@
 #define BASESERVICE_H
 
 #include "IService.h"
+#include "MetricsRegistry.h"
 #include <QTimer>
 #include <QElapsedTimer>
 #include <QDateTime>
@@ -13,6 +14,18 @@
  * with common functionality that most services will need, such as
  * initialization tracking, error handling, and basic lifecycle management.
  * 
+ * The time doInitialize() and doShutdown() take is kept and exported to
+ * MetricsRegistry as xfb_service_<name>_initialize_milliseconds and
+ * xfb_service_<name>_shutdown_milliseconds, <name> being the service name in
+ * snake case, so a service that is slow to start shows in monitoring.
+ * 
+ * A service that can tell whether it still works overrides healthCheck().
+ * Once startHealthChecks() has been called, one timer shared by all services
+ * runs the check of every running service each HEALTH_CHECK_INTERVAL_MS, on
+ * the service's thread; its latency goes to the
+ * xfb_service_<name>_health_check_microseconds histogram and its result to
+ * the xfb_service_<name>_healthy gauge.
+ * 
  * @since XFB 2.0
  */
 class BaseService : public IService
@@ -28,6 +41,56 @@ public:
     void shutdown() override;
     QString serviceName() const override;
 
+    static constexpr int HEALTH_CHECK_INTERVAL_MS = 60000;
+
+    /**
+     * @brief Start checking the health of the running services
+     *
+     * Call from the main thread; services started later are checked too.
+     * @param intervalMs Time between two rounds of checks
+     */
+    static void startHealthChecks(int intervalMs = HEALTH_CHECK_INTERVAL_MS);
+
+    /**
+     * @brief Stop the shared health check timer
+     */
+    static void stopHealthChecks();
+
+    /**
+     * @brief Run healthCheck() now and record its result and latency
+     * @return true if the service is running and healthy
+     */
+    bool checkHealth();
+
+    /**
+     * @brief Get the result of the last health check
+     * @return true if healthy, or if the service was never checked
+     */
+    bool isHealthy() const { return m_healthy; }
+
+    /**
+     * @brief Get the time the last health check took
+     * @return Microseconds, or -1 if the service was never checked
+     */
+    qint64 lastHealthCheckUs() const { return m_lastHealthCheckUs; }
+
+    /**
+     * @brief Get the time doInitialize() took
+     * @return Milliseconds, or -1 if it has not run
+     */
+    qint64 initializeDurationMs() const { return m_initializeMs; }
+
+    /**
+     * @brief Get the time doShutdown() took
+     * @return Milliseconds, or -1 if it has not run
+     */
+    qint64 shutdownDurationMs() const { return m_shutdownMs; }
+
+    /**
+     * @brief Name of the service in metric names, "AudioService" as "audio_service"
+     */
+    static QString metricName(const QString& serviceName);
+
     /**
      * @brief Get the time when the service was initialized
      * @return Initialization timestamp, or invalid QDateTime if not initialized
@@ -52,6 +115,13 @@ public:
      */
     QString lastError() const { return m_lastError; }
 
+signals:
+    /**
+     * @brief Emitted when a health check finds the service otherwise than the last one
+     * @param healthy Result of the check
+     */
+    void healthChanged(bool healthy);
+
 protected:
     /**
      * @brief Override this method to implement service-specific initialization
@@ -64,6 +134,14 @@ protected:
      */
     virtual void doShutdown() {}
 
+    /**
+     * @brief Override this method to tell whether the running service still works
+     *
+     * Keep it short: it runs on the service's thread, between its events.
+     * @return true if the service is healthy
+     */
+    virtual bool healthCheck() { return true; }
+
     /**
      * @brief Override this method to provide the service name
      * @return The service name
@@ -106,10 +184,18 @@ private slots:
     void onInitializationTimeout();
 
 private:
+    MetricsRegistry::Gauge* lifecycleGauge(const char* phase) const;
+
     QDateTime m_initializationTime;
     QElapsedTimer m_uptimeTimer;
     QString m_lastError;
     QTimer* m_initializationTimer;
+    qint64 m_initializeMs = -1;
+    qint64 m_shutdownMs = -1;
+    bool m_healthy = true;
+    qint64 m_lastHealthCheckUs = -1;
+    MetricsRegistry::Histogram* m_healthLatency = nullptr;
+    MetricsRegistry::Gauge* m_healthGauge = nullptr;
     
     static constexpr int INITIALIZATION_TIMEOUT_MS = 30000; // 30 seconds
 };
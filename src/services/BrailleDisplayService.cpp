@@ -1,10 +1,12 @@
 #include "BrailleDisplayService.h"
+#include "DeviceHotplugWatcher.h"
 #include <QApplication>
 #include <QStandardPaths>
 #include <QDir>
 #include <QFileInfo>
 #include <QRegularExpression>
 #include <QDebug>
+#include <algorithm>
 
 BrailleDisplayService::BrailleDisplayService(QObject* parent)
     : BaseService(parent)
@@ -12,19 +14,20 @@ BrailleDisplayService::BrailleDisplayService(QObject* parent)
     , m_brailleFormat(BrailleFormat::Standard)
     , m_detectionInProgress(false)
     , m_detectionTimer(new QTimer(this))
-    , m_deviceMonitorTimer(new QTimer(this))
+    , m_hotplugWatcher(nullptr)
     , m_detectionProcess(nullptr)
     , m_currentTranslationTable(DEFAULT_TRANSLATION_TABLE)
     , m_cursorPosition(-1)
+    , m_refreshTimer(new QTimer(this))
 {
     // Setup detection timer
     m_detectionTimer->setSingleShot(true);
     m_detectionTimer->setInterval(DETECTION_TIMEOUT_MS);
     connect(m_detectionTimer, &QTimer::timeout, this, &BrailleDisplayService::onDetectionTimeout);
     
-    // Setup device monitoring timer
-    m_deviceMonitorTimer->setInterval(DEVICE_MONITOR_INTERVAL_MS);
-    connect(m_deviceMonitorTimer, &QTimer::timeout, this, &BrailleDisplayService::onDeviceMonitorTimeout);
+    // Setup output pacing timer
+    m_refreshTimer->setSingleShot(true);
+    connect(m_refreshTimer, &QTimer::timeout, this, &BrailleDisplayService::onRefreshTimeout);
 }
 
 BrailleDisplayService::~BrailleDisplayService()
@@ -41,8 +44,18 @@ bool BrailleDisplayService::doInitialize()
             logWarning("Braille system initialization failed, service will run with limited functionality");
         }
         
-        // Start device monitoring
-        m_deviceMonitorTimer->start();
+        // Start device monitoring; nothing runs until a device node comes or goes
+        if (!m_hotplugWatcher) {
+            m_hotplugWatcher = new DeviceHotplugWatcher(DeviceHotplugWatcher::defaultDirectories(),
+                                                        DeviceHotplugWatcher::defaultNameFilters(),
+                                                        this);
+            connect(m_hotplugWatcher, &DeviceHotplugWatcher::deviceAdded,
+                    this, &BrailleDisplayService::onHotplugDeviceAdded);
+            connect(m_hotplugWatcher, &DeviceHotplugWatcher::deviceRemoved,
+                    this, &BrailleDisplayService::onHotplugDeviceRemoved);
+            connect(m_hotplugWatcher, &DeviceHotplugWatcher::devicesChanged,
+                    this, &BrailleDisplayService::onHotplugDevicesChanged);
+        }
         
         logDebug("BrailleDisplayService initialized successfully");
         return true;
@@ -60,9 +73,11 @@ void BrailleDisplayService::doShutdown()
 {
     logDebug("Shutting down BrailleDisplayService");
     
-    // Stop timers
+    // Stop timers and device monitoring
     m_detectionTimer->stop();
-    m_deviceMonitorTimer->stop();
+    m_refreshTimer->stop();
+    delete m_hotplugWatcher;
+    m_hotplugWatcher = nullptr;
     
     // Stop any ongoing detection
     stopDeviceDetection();
@@ -126,12 +141,8 @@ bool BrailleDisplayService::isBrailleDisplayConnected() const
 
 bool BrailleDisplayService::isBRLTTYAvailable() const
 {
-    // Check if BRLTTY is installed and available
-    QProcess process;
-    process.start("brltty", QStringList() << "--version");
-    process.waitForFinished(3000);
-    
-    return process.exitCode() == 0;
+    // Check if BRLTTY is installed; a PATH lookup, not a process
+    return !QStandardPaths::findExecutable("brltty").isEmpty();
 }
 
 QMap<QString, QString> BrailleDisplayService::getSystemBrailleConfig() const
@@ -381,6 +392,12 @@ bool BrailleDisplayService::setActiveDevice(const QString& deviceId)
         m_activeDevice = targetDevice;
         m_activeDevice.isConnected = true;
         
+        // The display content is unknown until written in full
+        m_frameBuffer.reset(targetDevice.cellCount > 0 ? targetDevice.cellCount
+                                                      : DEFAULT_CELL_COUNT);
+        m_writeClock.invalidate();
+        m_lastFormattedText.clear();
+        
         emit activeDeviceChanged(deviceId);
         emit deviceConnected(deviceId);
         
@@ -423,6 +440,8 @@ void BrailleDisplayService::disconnectFromDevice()
     
     m_activeDevice = BrailleDevice();
     m_cursorPosition = -1;
+    m_refreshTimer->stop();
+    m_outputPending = false;
     
     emit deviceDisconnected(deviceId);
 }
@@ -438,32 +457,82 @@ bool BrailleDisplayService::sendText(const QString& text, BrailleFormat format,
         return false;
     }
     
-    // Format the text according to the specified format
-    QString formattedText = formatTextForBraille(text, format, m_activeDevice.cellCount);
+    // Format the text according to the specified format, unless it is the same as last time
+    if (m_lastFormattedText.isNull() || text != m_lastInputText || format != m_lastInputFormat) {
+        m_lastFormattedText = formatTextForBraille(text, format, m_activeDevice.cellCount);
+        m_lastInputText = text;
+        m_lastInputFormat = format;
+    }
+    m_pendingText = m_lastFormattedText;
+    m_outputPending = true;
+    
+    // Important output goes now; the rest waits until the display can take more
+    const int interval = refreshInterval();
+    const qint64 sinceWrite = m_writeClock.isValid() ? m_writeClock.elapsed() : interval;
+    if (priority >= BraillePriority::High || sinceWrite >= interval) {
+        m_refreshTimer->stop();
+        return flushOutput();
+    }
+    
+    if (!m_refreshTimer->isActive()) {
+        m_refreshTimer->start(int(interval - sinceWrite));
+    }
+    return true;
+}
+
+bool BrailleDisplayService::flushOutput()
+{
+    if (!m_outputPending) {
+        return true;
+    }
+    m_outputPending = false;
+    
+    if (!isBrailleDisplayConnected()) {
+        return false;
+    }
     
-    // In a real implementation, this would send the formatted text
-    // to the braille display using the appropriate protocol
+    const QString formattedText = m_pendingText;
+    const QVector<BrailleFrameBuffer::Span> spans = m_frameBuffer.update(formattedText);
     
-    logDebug(QString("Sending text to braille display: %1").arg(formattedText));
+    bool success = true;
+    for (const BrailleFrameBuffer::Span& span : spans) {
+        success = sendRawData(span.cells.toUtf8(), span.start) && success;
+    }
     
-    // Simulate sending the text
-    bool success = sendRawData(formattedText.toUtf8());
+    if (!spans.isEmpty()) {
+        logDebug(QString("Sent %1 changed span(s) to braille display: %2")
+                     .arg(spans.size()).arg(formattedText));
+        m_writeClock.start();
+    }
     
     if (success) {
         m_lastOutputText = formattedText;
+    } else {
+        // What the display shows is unknown; the next line is written in full
+        m_frameBuffer.invalidate();
     }
     
     emit brailleOutputSent(formattedText, success);
     return success;
 }
 
-bool BrailleDisplayService::sendRawData(const QByteArray& data)
+int BrailleDisplayService::refreshInterval() const
+{
+    const auto capabilities = m_deviceCapabilities.constFind(m_activeDevice.id);
+    if (capabilities != m_deviceCapabilities.constEnd() && capabilities->refreshIntervalMs > 0) {
+        return capabilities->refreshIntervalMs;
+    }
+    return USB_REFRESH_INTERVAL_MS;
+}
+
+bool BrailleDisplayService::sendRawData(const QByteArray& data, int offset)
 {
     // In a real implementation, this would send raw data to the device
     // using the appropriate communication protocol
     
     // For simulation, we'll just log the data
-    logDebug(QString("Sending raw data to braille display: %1 bytes").arg(data.size()));
+    logDebug(QString("Sending raw data to braille display: %1 bytes at cell %2")
+                 .arg(data.size()).arg(offset));
     
     return true; // Simulate success
 }
@@ -601,6 +670,15 @@ void BrailleDisplayService::updateDeviceCapabilities(const BrailleDevice& device
     capabilities.supportsVibration = false; // Less common
     capabilities.supportsAudio = false; // Rare
     
+    // Wireless and serial links refresh more slowly than USB
+    if (device.connectionType == "Bluetooth") {
+        capabilities.refreshIntervalMs = BLUETOOTH_REFRESH_INTERVAL_MS;
+    } else if (device.connectionType == "Serial") {
+        capabilities.refreshIntervalMs = SERIAL_REFRESH_INTERVAL_MS;
+    } else {
+        capabilities.refreshIntervalMs = USB_REFRESH_INTERVAL_MS;
+    }
+    
     // Add common translation tables
     capabilities.supportedTables << "en-us-g1.ctb" << "en-us-g2.ctb" << "unicode.dis";
     
@@ -630,6 +708,7 @@ bool BrailleDisplayService::setTranslationTable(const QString& tableName)
     }
     
     m_currentTranslationTable = tableName;
+    m_lastFormattedText.clear();
     logDebug(QString("Braille translation table set to: %1").arg(tableName));
     
     return true;
@@ -762,6 +841,38 @@ void BrailleDisplayService::onDetectionTimeout()
     }
 }
 
+void BrailleDisplayService::onRefreshTimeout()
+{
+    flushOutput();
+}
+
+void BrailleDisplayService::setPlaybackTimeShown(bool shown)
+{
+    if (m_playbackTimeShown == shown) {
+        return;
+    }
+    m_playbackTimeShown = shown;
+    
+    PlaybackClock* clock = PlaybackClock::instance();
+    if (shown) {
+        connect(clock, &PlaybackClock::timeChanged,
+                this, &BrailleDisplayService::onPlaybackTimeChanged);
+        onPlaybackTimeChanged(clock->time());
+    } else {
+        disconnect(clock, &PlaybackClock::timeChanged,
+                   this, &BrailleDisplayService::onPlaybackTimeChanged);
+    }
+}
+
+void BrailleDisplayService::onPlaybackTimeChanged(const PlaybackClock::Time& time)
+{
+    if (!m_brailleEnabled || !isBrailleDisplayConnected()) {
+        return;
+    }
+    // From one second to the next only the last digits change; the frame buffer sends just those
+    sendText(time.elapsed + " / " + time.duration, BrailleFormat::Standard, BraillePriority::Low);
+}
+
 void BrailleDisplayService::onDetectionProcessFinished(int exitCode, QProcess::ExitStatus exitStatus)
 {
     Q_UNUSED(exitCode)
@@ -772,14 +883,40 @@ void BrailleDisplayService::onDetectionProcessFinished(int exitCode, QProcess::E
     // Process results would be handled here in a real implementation
 }
 
-void BrailleDisplayService::onDeviceMonitorTimeout()
+void BrailleDisplayService::onHotplugDeviceAdded(const QString& path)
 {
-    // Periodically check for device status changes
-    // In a real implementation, this would monitor device connections
-    // and update the available devices list accordingly
+    logDebug(QString("Device node appeared: %1").arg(path));
+    onDeviceConnected();
+    m_hotplugPending = true;
+}
+
+void BrailleDisplayService::onHotplugDeviceRemoved(const QString& path)
+{
+    logDebug(QString("Device node disappeared: %1").arg(path));
     
-    // For now, we'll just log that monitoring is active
-    if (isRunning()) {
-        logDebug("Device monitoring active");
+    // Drop it from the cached list; nothing needs probing to know it is gone
+    const int before = m_availableDevices.size();
+    m_availableDevices.erase(std::remove_if(m_availableDevices.begin(), m_availableDevices.end(),
+                                            [&path](const BrailleDevice& device) {
+                                                return device.port == path;
+                                            }),
+                             m_availableDevices.end());
+    
+    if (isBrailleDisplayConnected() && m_activeDevice.port == path) {
+        disconnectFromDevice();
+    }
+    
+    if (m_availableDevices.size() != before) {
+        emit deviceDetectionCompleted(m_availableDevices.size());
     }
-}
\ No newline at end of file
+}
+
+void BrailleDisplayService::onHotplugDevicesChanged()
+{
+    // Probe once per settled change, and only when something arrived
+    if (!m_hotplugPending || !isRunning()) {
+        return;
+    }
+    m_hotplugPending = false;
+    detectAvailableDevices();
+}
@@ -3,14 +3,19 @@
 
 #include "BaseService.h"
 #include "AccessibilitySettingsService.h"
+#include "BrailleFrameBuffer.h"
+#include "PlaybackClock.h"
 #include <QObject>
 #include <QString>
 #include <QStringList>
+#include <QElapsedTimer>
 #include <QTimer>
 #include <QProcess>
 #include <QMap>
 #include <QThread>
 
+class DeviceHotplugWatcher;
+
 /**
  * @brief Service for managing braille display support and configuration
  * 
@@ -19,6 +24,14 @@
  * It integrates with the system's braille infrastructure and provides
  * optimized output for different braille display types.
  * 
+ * Once initialized the service watches for device nodes coming and going and
+ * only probes for displays when one arrives; the device list is cached in
+ * between.
+ * 
+ * Output goes through a frame buffer, so only the cells that changed are
+ * written, and no more often than the display's refresh interval; a line
+ * that arrives sooner waits, and is replaced if another follows it.
+ * 
  * @example
  * @code
  * auto* brailleService = ServiceContainer::instance()->resolve<BrailleDisplayService>();
@@ -89,6 +102,7 @@ public:
         bool supportsVibration;     ///< Supports tactile feedback
         bool supportsAudio;         ///< Has audio feedback capability
         int maxCellCount;           ///< Maximum number of cells
+        int refreshIntervalMs;      ///< Least time between two writes to the display
         QStringList supportedTables; ///< Supported braille translation tables
         
         BrailleCapabilities()
@@ -97,7 +111,8 @@ public:
             , supportsStatusCells(false)
             , supportsVibration(false)
             , supportsAudio(false)
-            , maxCellCount(0) {}
+            , maxCellCount(0)
+            , refreshIntervalMs(0) {}
     };
 
     explicit BrailleDisplayService(QObject* parent = nullptr);
@@ -170,6 +185,17 @@ public:
      */
     int cursorPosition() const { return m_cursorPosition; }
 
+    /**
+     * @brief Show the on-air elapsed time and duration, as PlaybackClock publishes them
+     * @param shown true to follow the playback clock, false to stop
+     */
+    void setPlaybackTimeShown(bool shown);
+
+    /**
+     * @brief Check if the display follows the playback clock
+     */
+    bool isPlaybackTimeShown() const { return m_playbackTimeShown; }
+
     /**
      * @brief Start automatic device detection
      * @return true if detection was started successfully
@@ -338,15 +364,38 @@ private slots:
      */
     void onDetectionTimeout();
 
+    /**
+     * @brief Write the line that waited for the refresh interval
+     */
+    void onRefreshTimeout();
+
+    /**
+     * @brief Show a new second from the playback clock
+     * @param time The published time
+     */
+    void onPlaybackTimeChanged(const PlaybackClock::Time& time);
+
     /**
      * @brief Handle device detection process completion
      */
     void onDetectionProcessFinished(int exitCode, QProcess::ExitStatus exitStatus);
 
     /**
-     * @brief Handle periodic device monitoring
+     * @brief Handle a device node appearing
+     * @param path Path of the device node
+     */
+    void onHotplugDeviceAdded(const QString& path);
+
+    /**
+     * @brief Handle a device node disappearing; disconnects the active device if it was on it
+     * @param path Path of the device node
+     */
+    void onHotplugDeviceRemoved(const QString& path);
+
+    /**
+     * @brief Refresh the cached device list after devices were added
      */
-    void onDeviceMonitorTimeout();
+    void onHotplugDevicesChanged();
 
 private:
     /**
@@ -394,9 +443,21 @@ private:
     /**
      * @brief Send raw data to braille display
      * @param data Data to send
+     * @param offset First cell the data is written to
      * @return true if data was sent successfully
      */
-    bool sendRawData(const QByteArray& data);
+    bool sendRawData(const QByteArray& data, int offset = 0);
+
+    /**
+     * @brief Write the cells of the pending line that differ from the display
+     * @return true if every write succeeded
+     */
+    bool flushOutput();
+
+    /**
+     * @brief Least time between two writes to the active display
+     */
+    int refreshInterval() const;
 
     /**
      * @brief Convert AccessibilitySettingsService format to internal format
@@ -457,18 +518,32 @@ private:
     // Detection and monitoring
     bool m_detectionInProgress;
     QTimer* m_detectionTimer;
-    QTimer* m_deviceMonitorTimer;
+    DeviceHotplugWatcher* m_hotplugWatcher;
     QProcess* m_detectionProcess;
+    bool m_hotplugPending = false;
     
     // Braille system integration
     QString m_currentTranslationTable;
     int m_cursorPosition;
     QString m_lastOutputText;
     
+    // Output pacing: only changed cells, at most once per refresh interval
+    BrailleFrameBuffer m_frameBuffer;
+    QTimer* m_refreshTimer;
+    QElapsedTimer m_writeClock;
+    QString m_pendingText;
+    bool m_outputPending = false;
+    QString m_lastInputText;
+    BrailleFormat m_lastInputFormat = BrailleFormat::Standard;
+    QString m_lastFormattedText;
+    bool m_playbackTimeShown = false;
+    
     // Configuration
     static constexpr int DETECTION_TIMEOUT_MS = 10000;  // 10 seconds
-    static constexpr int DEVICE_MONITOR_INTERVAL_MS = 5000;  // 5 seconds
     static constexpr int DEFAULT_CELL_COUNT = 40;
+    static constexpr int USB_REFRESH_INTERVAL_MS = 100;
+    static constexpr int SERIAL_REFRESH_INTERVAL_MS = 200;
+    static constexpr int BLUETOOTH_REFRESH_INTERVAL_MS = 250;
     static constexpr const char* DEFAULT_TRANSLATION_TABLE = "en-us-g2.ctb";
 };
 
@@ -0,0 +1,50 @@
+#include "BrailleFrameBuffer.h"
+
+BrailleFrameBuffer::BrailleFrameBuffer(int cellCount)
+{
+    reset(cellCount);
+}
+
+void BrailleFrameBuffer::reset(int cellCount)
+{
+    m_cellCount = qMax(0, cellCount);
+    m_cells = QString(m_cellCount, QLatin1Char(' '));
+    m_valid = false;
+}
+
+QVector<BrailleFrameBuffer::Span> BrailleFrameBuffer::update(const QString& text)
+{
+    const QString line = text.left(m_cellCount).leftJustified(m_cellCount, QLatin1Char(' '));
+    QVector<Span> spans;
+
+    if (!m_valid) {
+        m_cells = line;
+        m_valid = true;
+        if (m_cellCount > 0) {
+            spans.append({0, line});
+        }
+        return spans;
+    }
+
+    int start = -1;  // first cell of the run being built
+    int end = -1;    // one past its last changed cell
+    for (int i = 0; i < m_cellCount; ++i) {
+        if (line.at(i) == m_cells.at(i)) {
+            continue;
+        }
+        if (start >= 0 && i - end > MERGE_GAP) {
+            spans.append({start, line.mid(start, end - start)});
+            start = -1;
+        }
+        if (start < 0) {
+            start = i;
+        }
+        end = i + 1;
+    }
+    if (start >= 0) {
+        spans.append({start, line.mid(start, end - start)});
+    }
+
+    m_cells = line;
+    return spans;
+}
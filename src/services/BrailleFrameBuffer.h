@@ -0,0 +1,70 @@
+#ifndef BRAILLEFRAMEBUFFER_H
+#define BRAILLEFRAMEBUFFER_H
+
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief What a braille display shows, and which cells a new line changes
+ *
+ * BrailleDisplayService writes a whole status line every second, but from one
+ * second to the next usually only the elapsed-time digits differ. update()
+ * compares the new line with the cells on the display and returns just the
+ * runs that changed, so only those are sent to the device.
+ *
+ * Runs separated by at most MERGE_GAP unchanged cells are sent as one. Each
+ * write carries a header that costs about that much.
+ *
+ * @example
+ * @code
+ * BrailleFrameBuffer frame(40);
+ * frame.update("Playing 00:41");            // the whole line, the display being unknown
+ * auto spans = frame.update("Playing 00:42");  // one span: "2" at cell 12
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class BrailleFrameBuffer
+{
+public:
+    struct Span {
+        int start = 0;   ///< First cell
+        QString cells;   ///< New content from start on
+    };
+
+    static constexpr int MERGE_GAP = 4;
+
+    explicit BrailleFrameBuffer(int cellCount = 0);
+
+    /**
+     * @brief Resize and forget the display content; the next update() sends every cell
+     * @param cellCount Number of cells on the display
+     */
+    void reset(int cellCount);
+
+    /**
+     * @brief Forget the display content, as after a reconnect
+     */
+    void invalidate() { m_valid = false; }
+
+    /**
+     * @brief Take a new line, cut or padded with blanks to the cell count
+     * @param text The line to show
+     * @return The changed runs, in order; empty when nothing changed
+     */
+    QVector<Span> update(const QString& text);
+
+    int cellCount() const { return m_cellCount; }
+
+    /**
+     * @brief The cells on the display, as last updated
+     */
+    const QString& cells() const { return m_cells; }
+
+private:
+    QString m_cells;
+    int m_cellCount = 0;
+    bool m_valid = false;
+};
+
+#endif // BRAILLEFRAMEBUFFER_H
@@ -0,0 +1,392 @@
+#include "BroadcastWorker.h"
+#include "AutomationClock.h"
+#include "FolderWatcher.h"
+#include "FtpSyncEngine.h"
+#include "IngestIndex.h"
+#include "LogCategories.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QVariant>
+#include <QXmlStreamReader>
+
+namespace {
+
+const QStringList PROGRAM_FILTERS = {"*.mp3", "*.mp4", "*.ogg", "*.wav", "*.flac"};
+
+/**
+ * @brief Read the fields of a request file written by a TakeOver client
+ * @param path Request file
+ * @param fields Receives the text of its elements, such as ip, stream and cmd
+ * @return false if there is no such file
+ */
+bool readRequest(const QString& path, QHash<QString, QString>& fields)
+{
+    QFile file(path);
+    if (!file.open(QFile::ReadOnly | QFile::Text)) {
+        return false;
+    }
+
+    QXmlStreamReader xml(&file);
+    if (!xml.readNextStartElement() || xml.name() != QStringLiteral("XFBClientTakeOver")) {
+        qCDebug(xfbScheduler) << path << "is not an XFB TakeOver file";
+        return true;
+    }
+    // The fields sit in a www.netpack.pt element under the root
+    while (!xml.atEnd()) {
+        if (xml.readNext() == QXmlStreamReader::StartElement
+            && xml.name() != QStringLiteral("www.netpack.pt")) {
+            const QString name = xml.name().toString();
+            fields.insert(name, xml.readElementText(QXmlStreamReader::SkipChildElements));
+        }
+    }
+    if (xml.hasError()) {
+        qCDebug(xfbScheduler) << path << "is not well formed:" << xml.errorString();
+    }
+    return true;
+}
+
+} // namespace
+
+BroadcastWorker::BroadcastWorker(QObject* parent)
+    : QObject(parent)
+    , m_context(new QObject)
+{
+    m_thread.setObjectName("BroadcastWorker");
+    m_context->moveToThread(&m_thread);
+    connect(&m_thread, &QThread::finished, m_context, &QObject::deleteLater);
+    m_thread.start();
+}
+
+BroadcastWorker::~BroadcastWorker()
+{
+    QMetaObject::invokeMethod(
+        m_context,
+        [this]() {
+            delete m_programIndex;
+            m_programIndex = nullptr;
+            closeDatabase();
+        },
+        Qt::BlockingQueuedConnection);
+    m_thread.quit();
+    m_thread.wait();
+}
+
+void BroadcastWorker::start(const QString& databasePath, const QString& programsPath,
+                            const QString& takeOverPath)
+{
+    QMetaObject::invokeMethod(m_context, [this, databasePath, programsPath, takeOverPath]() {
+        m_databasePath = databasePath;
+        m_programsPath = programsPath;
+        m_takeOverPath = takeOverPath;
+        openDatabase();
+    });
+}
+
+void BroadcastWorker::setClock(AutomationClock* clock)
+{
+    QMetaObject::invokeMethod(m_context, [this, clock = QPointer<AutomationClock>(clock)]() {
+        m_clock = clock;
+        if (m_rescanTimer) {
+            m_rescanTimer->setClock(clock);
+            m_rescanTimer->start();
+            m_takeOverTimer->setClock(clock);
+            m_takeOverTimer->start();
+        }
+    });
+}
+
+void BroadcastWorker::watch()
+{
+    QMetaObject::invokeMethod(m_context, [this]() {
+        if (m_rescanTimer) {
+            return; // already watching
+        }
+
+        // The hourly run covers files copied in ways the watcher misses
+        m_rescanTimer = new ClockTimer(m_clock, m_context);
+        connect(m_rescanTimer, &ClockTimer::timeout, m_context, [this]() { scanPrograms(); });
+        m_rescanTimer->start(RESCAN_INTERVAL_MS);
+
+        // Uploads into programsPath are sorted and scheduled once they are complete
+        m_programsWatcher = new FolderWatcher(m_context);
+        m_programsWatcher->setDebounceInterval(PROGRAM_UPLOAD_SETTLE_MS);
+        m_programsWatcher->setNameFilters(PROGRAM_FILTERS);
+        connect(m_programsWatcher, &FolderWatcher::changed, m_context,
+                [this]() { scanPrograms(); });
+        m_programsWatcher->setPath(m_programsPath);
+
+        // TakeOver requests are handled as soon as the upload settles
+        m_takeOverWatcher = new FolderWatcher(m_context);
+        m_takeOverWatcher->setNameFilters({"takeover.xml", "returntakeover.xml"});
+        connect(m_takeOverWatcher, &FolderWatcher::changed, m_context,
+                [this]() { checkTakeOver(); });
+        const bool watching = m_takeOverWatcher->setPath(m_takeOverPath);
+
+        m_takeOverTimer = new ClockTimer(m_clock, m_context);
+        connect(m_takeOverTimer, &ClockTimer::timeout, m_context, [this]() { checkTakeOver(); });
+        m_takeOverTimer->start(watching ? TAKEOVER_FALLBACK_POLL_MS : TAKEOVER_POLL_MS);
+
+        scanPrograms();
+        checkTakeOver();
+    });
+}
+
+void BroadcastWorker::scanPrograms()
+{
+    if (QThread::currentThread() != &m_thread) {
+        QMetaObject::invokeMethod(m_context, [this]() { scanPrograms(); });
+        return;
+    }
+    if (!QSqlDatabase::database(CONNECTION_NAME, false).isOpen()) {
+        return;
+    }
+
+    qCDebug(xfbScheduler) << "Monitoring ProgramsPath var that is set to: " << m_programsPath;
+    sortUploads();
+
+    // Only the program folders that changed since the last run are listed,
+    // and only files the index has not seen yet are checked against the DB
+    if (!m_programIndex) {
+        m_programIndex = new IngestIndex(IngestIndex::defaultLocation("programs"));
+        m_programIndex->load();
+    }
+    const int added = m_programIndex->scan(m_programsPath, PROGRAM_FILTERS,
+                                           [this](const QString& file) {
+                                               return ingestProgramFile(file);
+                                           });
+    m_programIndex->save();
+    qCDebug(xfbScheduler) << "server programs monitorization ::" << added << "new program files,"
+                          << m_programIndex->fileCount() << "known";
+
+    if (added > 0) {
+        emit programsChanged(added);
+    }
+}
+
+void BroadcastWorker::addDownloadedProgram(const QString& fileName)
+{
+    if (QThread::currentThread() != &m_thread) {
+        QMetaObject::invokeMethod(m_context,
+                                  [this, fileName]() { addDownloadedProgram(fileName); });
+        return;
+    }
+    QSqlDatabase db = QSqlDatabase::database(CONNECTION_NAME, false);
+    if (!db.isOpen()) {
+        return;
+    }
+    qCDebug(xfbScheduler) << "server_ftp_check() :: Found this one to add:" << fileName;
+
+    const QStringList parts = fileName.split("_");
+    if (parts.size() < 2) {
+        qCDebug(xfbScheduler) << "server_ftp_check() :: Skipping it, programs must be named like "
+                                 "'name_YYYY-mm-dd.ogg'";
+        return;
+    }
+    const QString name = parts[0];
+    const QString date = parts[1].split(".").first();
+
+    QSqlQuery insert(db);
+    insert.prepare("insert into programs values(NULL, ?, ?)");
+    insert.addBindValue(name);
+    insert.addBindValue(m_programsPath + "/" + fileName);
+    if (!insert.exec()) {
+        qCDebug(xfbScheduler) << "server_ftp_check() :: Query was not ok while atempting to add "
+                                 "to the programs table"
+                              << insert.lastError();
+        return;
+    }
+    qCDebug(xfbScheduler) << "server_ftp_check() :: Query OK. Program added to programs table";
+
+    scheduleProgram(insert.lastInsertId(), name, date);
+    emit programsChanged(1);
+}
+
+void BroadcastWorker::checkTakeOver()
+{
+    if (QThread::currentThread() != &m_thread) {
+        QMetaObject::invokeMethod(m_context, [this]() { checkTakeOver(); });
+        return;
+    }
+    if (m_takeOverPath.isEmpty()) {
+        return;
+    }
+    readTakeOver();
+    readReturnTakeOver();
+}
+
+bool BroadcastWorker::openDatabase()
+{
+    closeDatabase();
+
+    // The worker thread's own connection, as DatabaseService keeps one per thread
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", CONNECTION_NAME);
+    db.setDatabaseName(m_databasePath);
+    // The window writes to the same file; wait for its transactions
+    db.setConnectOptions("QSQLITE_BUSY_TIMEOUT=5000");
+    if (!db.open()) {
+        qWarning() << "BroadcastWorker: Cannot open" << m_databasePath << db.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+void BroadcastWorker::closeDatabase()
+{
+    if (!QSqlDatabase::contains(CONNECTION_NAME)) {
+        return;
+    }
+    QSqlDatabase::database(CONNECTION_NAME, false).close();
+    QSqlDatabase::removeDatabase(CONNECTION_NAME);
+}
+
+void BroadcastWorker::sortUploads()
+{
+    // New uploads land in programsPath itself; sort them into their program's folder
+    const QStringList uploads = QDir(m_programsPath).entryList(QDir::Files);
+    for (const QString& fileName : uploads) {
+        if (fileName.endsWith(FtpSyncEngine::PARTIAL_SUFFIX)) {
+            continue; // still being downloaded
+        }
+        const QString programName = fileName.split("_").first();
+        qCDebug(xfbScheduler) << "NEW UPLOADED FILE FOUND: " << programName;
+
+        const QString destination = m_programsPath + "/" + programName + "/" + fileName;
+        if (QDir().rename(m_programsPath + "/" + fileName, destination)) {
+            qCDebug(xfbScheduler) << "Uploaded program was moved to " << destination;
+        } else {
+            qCDebug(xfbScheduler) << "There was an error moving the uploaded file to "
+                                  << destination;
+        }
+    }
+}
+
+bool BroadcastWorker::ingestProgramFile(const QString& file)
+{
+    QSqlDatabase db = QSqlDatabase::database(CONNECTION_NAME);
+    XFB_TRACE(xfbScheduler) << "Found: " << file;
+
+    QSqlQuery existing(db);
+    existing.prepare("SELECT path from programs where path = ?");
+    existing.addBindValue(file);
+    if (!existing.exec()) {
+        qCDebug(xfbScheduler) << "Error running query: " << existing.lastError();
+        return false;
+    }
+    if (existing.next()) {
+        return true;
+    }
+
+    XFB_TRACE(xfbScheduler) << "Query didn't return any rows.. so adding it..";
+    const QString fileName = QFileInfo(file).fileName();
+    QSqlQuery insert(db);
+    insert.prepare("insert into programs values(NULL, ?, ?)");
+    insert.addBindValue(fileName);
+    insert.addBindValue(file);
+    if (!insert.exec()) {
+        qCDebug(xfbScheduler) << "Query was not ok while atempting to localy add to the "
+                                 "programs table: "
+                              << insert.lastError();
+        return false;
+    }
+    XFB_TRACE(xfbScheduler) << "Query OK. Program localy added to programs table";
+
+    const QStringList parts = fileName.split("_");
+    const QString date = parts.size() > 1 ? parts[1].split(".").first() : QString();
+    scheduleProgram(insert.lastInsertId(), parts[0], date);
+    return true;
+}
+
+bool BroadcastWorker::scheduleProgram(const QVariant& programId, const QString& name,
+                                      const QString& date)
+{
+    QSqlDatabase db = QSqlDatabase::database(CONNECTION_NAME);
+
+    const QStringList day = date.split("-");
+    if (day.size() < 3 || day[0].isEmpty() || day[1].isEmpty() || day[2].isEmpty()) {
+        qCDebug(xfbScheduler) << "We got a program but there was an error adding it beacuse one "
+                                 "value of the data is empty. Please check the programs are "
+                                 "named like 'name_YYYY-mm-dd.ogg'";
+        return false;
+    }
+
+    // Programs air at the hour and minute set for them in hourprograms
+    QSqlQuery airTimes(db);
+    airTimes.prepare("select hour, min from hourprograms where name like ?");
+    airTimes.addBindValue(name);
+    if (!airTimes.exec()) {
+        qCDebug(xfbScheduler) << "It was not possible to figure out the hour and minute for "
+                                 "this program: "
+                              << name << "- this should be in the 'hourprograms' table.";
+        return false;
+    }
+
+    bool scheduled = false;
+    while (airTimes.next()) {
+        const QString hour = airTimes.value(0).toString();
+        const QString minute = airTimes.value(1).toString();
+
+        QSqlQuery insert(db);
+        insert.prepare("insert into scheduler values (?, ?, ?, ?, ?, ?, '1', NULL, NULL, NULL, "
+                       "NULL, NULL, NULL, NULL, '1')");
+        for (const QVariant& value : {programId, QVariant(day[0]), QVariant(day[1]),
+                                      QVariant(day[2]), QVariant(hour), QVariant(minute)}) {
+            insert.addBindValue(value);
+        }
+        if (insert.exec()) {
+            scheduled = true;
+            XFB_TRACE(xfbScheduler) << "Program scheduled correctly." << name << "::" << date
+                                    << "at" << hour << ":" << minute;
+        } else {
+            qCDebug(xfbScheduler) << "It was not possible to add program to scheduler: "
+                                  << insert.lastError();
+        }
+    }
+    if (!scheduled) {
+        XFB_TRACE(xfbScheduler) << "The program " << name
+                                << " hasn't got an hour and minute extablished in the "
+                                   "hourprograms table so XFB can't add it by itself..";
+    }
+    return scheduled;
+}
+
+void BroadcastWorker::readTakeOver()
+{
+    const QString takeOverFile = m_takeOverPath + "/takeover.xml";
+    QHash<QString, QString> fields;
+    if (!readRequest(takeOverFile, fields)) {
+        XFB_TRACE(xfbScheduler) << "TakeOver Monitoring" << takeOverFile << ": nothing found.";
+        return;
+    }
+    const QString stream = fields.value("stream");
+    if (stream.isEmpty()) {
+        return;
+    }
+    qCDebug(xfbScheduler) << "Valid XFB TakeOver Found! Stream:" << stream;
+
+    // The client takes the renamed file as the confirmation
+    const QString confirmation = m_takeOverPath + "/confirmtakeover.xml";
+    QFile::rename(takeOverFile, confirmation);
+    ClockTimer::singleShot(m_clock, CONFIRMATION_LIFETIME_MS, m_context,
+                           [confirmation]() { QFile::remove(confirmation); });
+
+    emit takeOverRequested(fields.value("ip"), stream);
+}
+
+void BroadcastWorker::readReturnTakeOver()
+{
+    const QString returnFile = m_takeOverPath + "/returntakeover.xml";
+    QHash<QString, QString> fields;
+    if (!readRequest(returnFile, fields)) {
+        XFB_TRACE(xfbScheduler) << "ReturnTakeOver Monitoring" << returnFile << ": nothing found.";
+        return;
+    }
+    QFile::remove(returnFile);
+    qCDebug(xfbScheduler) << "ReturnTakeOver ::" << fields.value("cmd") << "from"
+                          << fields.value("ip");
+    emit takeOverReturned(fields.value("ip"), fields.value("cmd"));
+}
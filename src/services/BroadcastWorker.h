@@ -0,0 +1,152 @@
+#ifndef BROADCASTWORKER_H
+#define BROADCASTWORKER_H
+
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <QThread>
+
+class AutomationClock;
+class ClockTimer;
+class FolderWatcher;
+class IngestIndex;
+class QVariant;
+
+/**
+ * @brief Runs the server's automation chores on a thread of its own
+ *
+ * A server station sorts program uploads into their folders, adds new
+ * programs to the database and schedules them, and watches TakeOverPath
+ * for takeover requests. All of it touches the disk and the database,
+ * and when a disk or the database stalled on the GUI thread the window
+ * froze along with whatever was due on air.
+ *
+ * BroadcastWorker does that work on its own thread, the way LiveCapture
+ * captures on one: a context object lives on the thread and owns the
+ * hourly rescan timer, the takeover poll, the folder watchers and a
+ * database connection of its own, CONNECTION_NAME. The public calls only
+ * queue work on it and may be made from any thread; results come back as
+ * signals, which arrive queued on the window.
+ *
+ * Only what the window needs to change is reported: programsChanged()
+ * when rows were added, so the tables and the scheduler are reloaded,
+ * and takeOverRequested() and takeOverReturned() with what the request
+ * files said. The takeover file is turned into the confirmation the
+ * client looks for, and removed again, on the worker thread.
+ *
+ * @example
+ * @code
+ * BroadcastWorker* worker = new BroadcastWorker(this);
+ * connect(worker, &BroadcastWorker::programsChanged, this, &player::update_music_table);
+ * connect(worker, &BroadcastWorker::takeOverRequested, this, &player::startTakeOver);
+ * worker->start(adb.databaseName(), ProgramsPath, TakeOverPath);
+ * worker->watch();   // server role
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class BroadcastWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr const char* CONNECTION_NAME = "xfb_broadcast";
+    static constexpr int RESCAN_INTERVAL_MS = 60 * 60 * 1000;
+    // Program uploads are large and can stall for a moment; wait this long
+    // after the last write before sorting them into their folders
+    static constexpr int PROGRAM_UPLOAD_SETTLE_MS = 5000;
+    // takeover.xml is normally noticed by FolderWatcher; polling covers file
+    // systems that do not report changes
+    static constexpr int TAKEOVER_FALLBACK_POLL_MS = 5 * 60 * 1000;
+    static constexpr int TAKEOVER_POLL_MS = 25000;           ///< Without a watcher
+    static constexpr int CONFIRMATION_LIFETIME_MS = 120000;  ///< confirmtakeover.xml is kept
+
+    explicit BroadcastWorker(QObject* parent = nullptr);
+    ~BroadcastWorker() override;
+
+    /**
+     * @brief Open the worker's database connection
+     * @param databasePath SQLite file the window uses
+     * @param programsPath Folder programs are uploaded into
+     * @param takeOverPath Folder takeover requests are uploaded into
+     */
+    void start(const QString& databasePath, const QString& programsPath,
+               const QString& takeOverPath);
+
+    /**
+     * @brief Run the rescan and the takeover poll on another clock; before watch()
+     * @param clock Clock to run on, nullptr for the wall clock
+     */
+    void setClock(AutomationClock* clock);
+
+    /**
+     * @brief Watch the programs and takeover folders, as a server does
+     *
+     * Scans the programs and checks for a takeover right away, as uploads
+     * and requests may have arrived while XFB was not running.
+     */
+    void watch();
+
+    /**
+     * @brief Sort uploads into their folders and add new programs to the schedule
+     */
+    void scanPrograms();
+
+    /**
+     * @brief Add a program fetched from the FTP server and schedule it
+     * @param fileName File name in the programs folder, like "name_YYYY-mm-dd.ogg"
+     */
+    void addDownloadedProgram(const QString& fileName);
+
+    /**
+     * @brief Look for takeover.xml and returntakeover.xml now
+     */
+    void checkTakeOver();
+
+signals:
+    /**
+     * @brief Emitted when programs were added to the database
+     * @param added Number of programs added
+     */
+    void programsChanged(int added);
+
+    /**
+     * @brief Emitted for a valid takeover request
+     * @param ip Address of the client taking over
+     * @param stream Stream to put on air
+     */
+    void takeOverRequested(const QString& ip, const QString& stream);
+
+    /**
+     * @brief Emitted when a client asked to end its takeover
+     * @param ip Address the request came from
+     * @param command Command in the request, "returnTakeOver" to end it
+     */
+    void takeOverReturned(const QString& ip, const QString& command);
+
+private:
+    // Worker thread only
+    bool openDatabase();
+    void closeDatabase();
+    void sortUploads();
+    bool ingestProgramFile(const QString& file);
+    bool scheduleProgram(const QVariant& programId, const QString& name, const QString& date);
+    void readTakeOver();
+    void readReturnTakeOver();
+
+    QThread m_thread;
+    QObject* m_context;   ///< Lives on m_thread
+
+    // Worker thread only
+    QString m_databasePath;
+    QString m_programsPath;
+    QString m_takeOverPath;
+    IngestIndex* m_programIndex = nullptr;   ///< Program files already in the DB
+    FolderWatcher* m_programsWatcher = nullptr;
+    FolderWatcher* m_takeOverWatcher = nullptr;
+    QPointer<AutomationClock> m_clock;
+    ClockTimer* m_rescanTimer = nullptr;
+    ClockTimer* m_takeOverTimer = nullptr;
+};
+
+#endif // BROADCASTWORKER_H
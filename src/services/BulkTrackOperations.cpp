@@ -0,0 +1,86 @@
+#include "BulkTrackOperations.h"
+#include "../repositories/MusicRepository.h"
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QtConcurrent/QtConcurrentRun>
+#include <algorithm>
+
+BulkTrackOperations::BulkTrackOperations(MusicRepository* repository, QObject* parent)
+    : QObject(parent)
+    , m_repository(repository)
+{
+    connect(&m_watcher, &QFutureWatcher<FileDeletion>::finished, this,
+            &BulkTrackOperations::onFilesDeleted);
+}
+
+BulkTrackOperations::~BulkTrackOperations()
+{
+    m_watcher.disconnect(this);
+    m_watcher.waitForFinished();
+}
+
+QList<int> BulkTrackOperations::uniqueRows(const QModelIndexList& indexes)
+{
+    QList<int> rows;
+    rows.reserve(indexes.size());
+    for (const QModelIndex& index : indexes) {
+        rows.append(index.row());
+    }
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+    return rows;
+}
+
+int BulkTrackOperations::removeTracks(const QList<int>& musicIds, bool deleteFiles)
+{
+    QHash<int, QString> paths;
+    const int removed = m_repository->deleteMusicBatch(musicIds, &paths);
+    if (removed <= 0) {
+        return removed;
+    }
+    qInfo() << "BulkTrackOperations:" << removed << "tracks removed from the library";
+
+    QList<int> ids = paths.keys();
+    std::sort(ids.begin(), ids.end());
+    emit tracksRemoved(ids);
+
+    if (deleteFiles) {
+        m_queuedPaths.append(paths.values());
+        if (!m_watcher.isRunning()) {
+            startFileDeletion();
+        }
+    }
+    return removed;
+}
+
+BulkTrackOperations::FileDeletion BulkTrackOperations::deleteFiles(const QStringList& paths)
+{
+    FileDeletion result;
+    for (const QString& path : paths) {
+        if (!QFileInfo::exists(path)) {
+            result.missing.append(path);
+        } else if (QFile::remove(path)) {
+            result.deleted.append(path);
+        } else {
+            qWarning() << "BulkTrackOperations: cannot delete" << path;
+            result.failed.append(path);
+        }
+    }
+    return result;
+}
+
+void BulkTrackOperations::startFileDeletion()
+{
+    const QStringList paths = m_queuedPaths;
+    m_queuedPaths.clear();
+    m_watcher.setFuture(QtConcurrent::run(&BulkTrackOperations::deleteFiles, paths));
+}
+
+void BulkTrackOperations::onFilesDeleted()
+{
+    emit filesDeleted(m_watcher.result());
+    if (!m_queuedPaths.isEmpty()) {
+        startFileDeletion();
+    }
+}
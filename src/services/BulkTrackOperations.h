@@ -0,0 +1,99 @@
+#ifndef BULKTRACKOPERATIONS_H
+#define BULKTRACKOPERATIONS_H
+
+#include <QFutureWatcher>
+#include <QList>
+#include <QModelIndexList>
+#include <QObject>
+#include <QStringList>
+
+class MusicRepository;
+
+/**
+ * @brief Operations on many library tracks at once, as chosen in the music view
+ *
+ * Deleting a selection used to run one DELETE per selected cell and reload
+ * the whole table afterwards. removeTracks() deletes every track in one
+ * transaction through MusicRepository::deleteMusicBatch() and reports the
+ * IDs removed with tracksRemoved(), so the view drops those rows alone.
+ *
+ * Removing the files from the disk as well can take a while on a share;
+ * it runs on the thread pool and ends with filesDeleted(). Deletions asked
+ * for while one runs are queued after it.
+ *
+ * @example
+ * @code
+ * BulkTrackOperations* bulk = new BulkTrackOperations(repository, this);
+ * connect(bulk, &BulkTrackOperations::tracksRemoved, this, &Window::dropRows);
+ * const QList<int> rows = BulkTrackOperations::uniqueRows(selection->selectedIndexes());
+ * bulk->removeTracks(idsOf(rows), true);
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class BulkTrackOperations : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief What became of the files of removed tracks
+     */
+    struct FileDeletion {
+        QStringList deleted;
+        QStringList missing;    ///< Already gone
+        QStringList failed;     ///< Still there, usually for lack of permission
+    };
+
+    /**
+     * @param repository Repository the tracks are deleted through
+     * @param parent Parent object
+     */
+    explicit BulkTrackOperations(MusicRepository* repository, QObject* parent = nullptr);
+    ~BulkTrackOperations() override;
+
+    /**
+     * @brief Rows of a selection, each once and in order
+     * @param indexes Selected cells, as QItemSelectionModel::selectedIndexes() gives them
+     */
+    static QList<int> uniqueRows(const QModelIndexList& indexes);
+
+    /**
+     * @brief Delete tracks from the library in one transaction
+     * @param musicIds Tracks to delete
+     * @param deleteFiles Remove their files from the disk too, in the background
+     * @return Number of tracks deleted, or -1 if nothing could be deleted
+     */
+    int removeTracks(const QList<int>& musicIds, bool deleteFiles);
+
+    /**
+     * @brief Remove files from the disk on the calling thread
+     */
+    static FileDeletion deleteFiles(const QStringList& paths);
+
+    bool isDeletingFiles() const { return m_watcher.isRunning(); }
+
+signals:
+    /**
+     * @brief Emitted after tracks were deleted from the library
+     * @param musicIds IDs of the tracks deleted
+     */
+    void tracksRemoved(const QList<int>& musicIds);
+
+    /**
+     * @brief Emitted when the files of a removal were dealt with
+     */
+    void filesDeleted(const BulkTrackOperations::FileDeletion& result);
+
+private:
+    void startFileDeletion();
+    void onFilesDeleted();
+
+    MusicRepository* m_repository;
+    QFutureWatcher<FileDeletion> m_watcher;
+    QStringList m_queuedPaths;   ///< Waiting for the running deletion to finish
+};
+
+Q_DECLARE_METATYPE(BulkTrackOperations::FileDeletion)
+
+#endif // BULKTRACKOPERATIONS_H
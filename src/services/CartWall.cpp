@@ -0,0 +1,341 @@
+#include "CartWall.h"
+#include "PcmDecoder.h"
+#include <QDebug>
+#include <QFutureWatcher>
+#include <QThread>
+#include <QtConcurrent/QtConcurrent>
+#include <algorithm>
+#include <utility>
+
+CartWall::CartWall(QObject* parent)
+    : QObject(parent)
+{
+    m_pool.setThreadPriority(QThread::LowPriority);
+    m_pool.setMaxThreadCount(1);
+    m_commands.reserve(MAX_COMMANDS);
+    // Every voice that ends and every command that replaces one retires at
+    // most one cart between two posts, which empty the list
+    m_retired.reserve(MAX_VOICES + MAX_COMMANDS);
+}
+
+CartWall::~CartWall()
+{
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+bool CartWall::load(int slot, const QString& filePath)
+{
+    if (!isValidSlot(slot)) {
+        return false;
+    }
+
+    m_loading[slot] = filePath;
+    auto* watcher = new QFutureWatcher<Decoded>(this);
+    connect(watcher, &QFutureWatcher<Decoded>::finished, this, [this, watcher, slot, filePath]() {
+        watcher->deleteLater();
+        // A later load() or unload() of the slot wins over this one
+        if (m_loading[slot] != filePath) {
+            return;
+        }
+        m_loading[slot].clear();
+
+        Decoded decoded = watcher->result();
+        if (!decoded.error.isEmpty()) {
+            qWarning() << "CartWall: could not load" << filePath << "-" << decoded.error;
+            emit loadFailed(slot, filePath, decoded.error);
+            return;
+        }
+        if (setCart(slot, filePath, std::move(decoded.samples), decoded.sampleRate)) {
+            emit cartLoaded(slot, filePath);
+        } else {
+            emit loadFailed(slot, filePath, tr("No audio could be decoded"));
+        }
+    });
+    watcher->setFuture(QtConcurrent::run(&m_pool, [filePath]() { return decode(filePath); }));
+    return true;
+}
+
+bool CartWall::setCart(int slot, const QString& filePath, std::vector<float> samples,
+                       int sampleRate)
+{
+    if (!isValidSlot(slot) || samples.empty() || sampleRate <= 0
+        || qint64(samples.size()) > qint64(MAX_CART_SECONDS) * sampleRate * CHANNELS) {
+        return false;
+    }
+
+    auto cart = std::make_shared<Cart>();
+    cart->path = filePath;
+    cart->samples = std::move(samples);
+    cart->samples.resize(cart->samples.size() / CHANNELS * CHANNELS);
+    cart->sampleRate = sampleRate;
+
+    std::shared_ptr<const Cart> old;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_retired.clear();
+        old = std::exchange(m_carts[slot], std::move(cart));
+    }
+    return true;
+}
+
+void CartWall::setCarts(const QStringList& filePaths)
+{
+    for (int slot = 0; slot < MAX_CARTS; ++slot) {
+        if (slot >= filePaths.size()) {
+            unload(slot);
+        } else if (path(slot) != filePaths[slot] && m_loading[slot] != filePaths[slot]) {
+            load(slot, filePaths[slot]);
+        }
+    }
+    if (filePaths.size() > MAX_CARTS) {
+        qDebug() << "CartWall:" << filePaths.size() - MAX_CARTS << "files left off the wall";
+    }
+}
+
+void CartWall::unload(int slot)
+{
+    if (!isValidSlot(slot)) {
+        return;
+    }
+
+    m_loading[slot].clear();
+    std::shared_ptr<const Cart> old;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_retired.clear();
+        old = std::move(m_carts[slot]);
+    }
+}
+
+bool CartWall::isLoaded(int slot) const
+{
+    QMutexLocker locker(&m_mutex);
+    return isValidSlot(slot) && m_carts[slot];
+}
+
+QString CartWall::path(int slot) const
+{
+    QMutexLocker locker(&m_mutex);
+    return isValidSlot(slot) && m_carts[slot] ? m_carts[slot]->path : QString();
+}
+
+qint64 CartWall::durationMs(int slot) const
+{
+    QMutexLocker locker(&m_mutex);
+    if (!isValidSlot(slot) || !m_carts[slot]) {
+        return -1;
+    }
+    const Cart& cart = *m_carts[slot];
+    return cart.frames() * 1000 / cart.sampleRate;
+}
+
+int CartWall::slotOf(const QString& filePath) const
+{
+    QMutexLocker locker(&m_mutex);
+    const auto found = std::find_if(m_carts.begin(), m_carts.end(), [&](const auto& cart) {
+        return cart && cart->path == filePath;
+    });
+    return found != m_carts.end() ? int(found - m_carts.begin()) : -1;
+}
+
+qint64 CartWall::memoryBytes() const
+{
+    QMutexLocker locker(&m_mutex);
+    qint64 bytes = 0;
+    for (const auto& cart : m_carts) {
+        if (cart) {
+            bytes += qint64(cart->samples.size()) * qint64(sizeof(float));
+        }
+    }
+    return bytes;
+}
+
+bool CartWall::trigger(int slot)
+{
+    Command command;
+    command.type = Command::Type::Start;
+    command.slot = slot;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!isValidSlot(slot) || !m_carts[slot]) {
+            return false;
+        }
+        command.cart = m_carts[slot];
+    }
+    post(std::move(command));
+    return true;
+}
+
+void CartWall::stop(int slot)
+{
+    Command command;
+    command.type = Command::Type::Stop;
+    command.slot = slot;
+    post(std::move(command));
+}
+
+void CartWall::stopAll()
+{
+    Command command;
+    command.type = Command::Type::StopAll;
+    post(std::move(command));
+}
+
+bool CartWall::isIdle() const
+{
+    return m_activeVoices.load(std::memory_order_relaxed) == 0
+           && m_pendingCommands.load(std::memory_order_acquire) == 0;
+}
+
+void CartWall::render(float* out, int frames, int sampleRate)
+{
+    ++m_blocks;
+
+    // Commands wait for the next block rather than have the audio thread wait
+    const bool locked = m_mutex.tryLock();
+    if (locked) {
+        for (Command& command : m_commands) {
+            switch (command.type) {
+            case Command::Type::Start:
+                start(command);
+                break;
+            case Command::Type::Stop:
+                for (Voice& voice : m_voices) {
+                    if (voice.cart && voice.slot == command.slot) {
+                        release(voice);
+                    }
+                }
+                break;
+            case Command::Type::StopAll:
+                for (Voice& voice : m_voices) {
+                    release(voice);
+                }
+                break;
+            }
+        }
+        m_commands.clear();
+        m_pendingCommands.store(0, std::memory_order_release);
+    }
+
+    int active = 0;
+    for (Voice& voice : m_voices) {
+        if (!voice.cart) {
+            continue;
+        }
+        const Cart& cart = *voice.cart;
+        const qint64 length = cart.frames();
+        const float* samples = cart.samples.data();
+        const double step = sampleRate > 0 ? double(cart.sampleRate) / sampleRate : 1.0;
+
+        for (int frame = 0; frame < frames && voice.position < length; ++frame) {
+            const qint64 index = qint64(voice.position);
+            const qint64 next = std::min(index + 1, length - 1);
+            const float fraction = float(voice.position - double(index));
+            for (int channel = 0; channel < CHANNELS; ++channel) {
+                const float a = samples[index * CHANNELS + channel];
+                const float b = samples[next * CHANNELS + channel];
+                out[frame * CHANNELS + channel] += a + (b - a) * fraction;
+            }
+            voice.position += step;
+        }
+
+        // A voice that ended while the lock was taken is released next block
+        if (voice.position < length) {
+            ++active;
+        } else if (locked) {
+            release(voice);
+        }
+    }
+    m_activeVoices.store(active, std::memory_order_relaxed);
+
+    if (locked) {
+        m_mutex.unlock();
+    }
+}
+
+CartWall::Decoded CartWall::decode(const QString& filePath)
+{
+    Decoded decoded;
+    bool tooLong = false;
+    const auto feed = [&](const float* samples, qint64 count, int rate, int channels) {
+        if (tooLong || channels <= 0) {
+            return;
+        }
+        decoded.sampleRate = rate;
+        const qint64 frames = count / channels;
+        if (qint64(decoded.samples.size()) / CHANNELS + frames > qint64(MAX_CART_SECONDS) * rate) {
+            tooLong = true;
+            return;
+        }
+        // Mono is played on both sides; channels past the first two are dropped
+        for (qint64 frame = 0; frame < frames; ++frame) {
+            const float* in = samples + frame * channels;
+            decoded.samples.push_back(in[0]);
+            decoded.samples.push_back(channels > 1 ? in[1] : in[0]);
+        }
+    };
+
+    QString error;
+    if (!PcmDecoder::decode(filePath, DECODE_SAMPLE_RATE, feed, &error)) {
+        decoded.error = error.isEmpty() ? QString("Decoding failed") : error;
+    } else if (tooLong) {
+        decoded.error = QString("Longer than %1 seconds").arg(MAX_CART_SECONDS);
+    }
+    if (!decoded.error.isEmpty()) {
+        decoded.samples.clear();
+    }
+    return decoded;
+}
+
+void CartWall::post(Command command)
+{
+    QMutexLocker locker(&m_mutex);
+    m_retired.clear();
+    if (int(m_commands.size()) >= MAX_COMMANDS) {
+        qWarning() << "CartWall: command dropped, the audio thread is not rendering";
+        return;
+    }
+    m_commands.push_back(std::move(command));
+    m_pendingCommands.store(int(m_commands.size()), std::memory_order_release);
+}
+
+void CartWall::start(Command& command)
+{
+    // The same cart starts over; otherwise a free voice, or the oldest one
+    Voice* target = nullptr;
+    for (Voice& voice : m_voices) {
+        if (voice.cart && voice.slot == command.slot) {
+            target = &voice;
+            break;
+        }
+    }
+    if (!target) {
+        const auto free =
+            std::find_if(m_voices.begin(), m_voices.end(), [](const Voice& v) { return !v.cart; });
+        target = free != m_voices.end()
+                     ? &*free
+                     : &*std::min_element(m_voices.begin(), m_voices.end(),
+                                          [](const Voice& a, const Voice& b) {
+                                              return a.startedAt < b.startedAt;
+                                          });
+    }
+
+    release(*target);
+    target->cart = std::move(command.cart);
+    target->slot = command.slot;
+    target->position = 0.0;
+    target->startedAt = m_blocks;
+}
+
+void CartWall::release(Voice& voice)
+{
+    // Called with the lock held. The last reference to a cart is handed to
+    // another thread to free, so the audio thread never frees memory.
+    if (voice.cart.use_count() == 1) {
+        m_retired.push_back(std::move(voice.cart));
+    }
+    voice.cart.reset();
+    voice.slot = -1;
+    voice.position = 0.0;
+}
@@ -0,0 +1,199 @@
+#ifndef CARTWALL_H
+#define CARTWALL_H
+
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Jingles held in memory, fired over the music on their own bus
+ *
+ * A jingle used to be queued in the playlist and played by the same decks
+ * as the music, so it could only start when the song before it ended and
+ * was decoded from disk like any track. The wall keeps up to MAX_CARTS
+ * short files decoded to stereo float PCM in memory. trigger() starts one
+ * on a voice of its own, which DeckMixer adds to its output on top of both
+ * decks: the cart plays over the music, and goes to the stream and the
+ * air-check recording with it.
+ *
+ * Files are decoded on a low priority worker when load() or setCarts() is
+ * called and kept at their own rate; voices step through them at the rate
+ * of the output. Files longer than MAX_CART_SECONDS are refused, which
+ * keeps a cart under 24 MB.
+ *
+ * trigger() may be called from any thread and never waits on the audio
+ * thread. The cart starts in the next block the mixer renders, so the only
+ * delay is the audio already buffered in the sink. Firing a cart that is
+ * playing starts it again from the top; when all MAX_VOICES voices are
+ * busy the one that has played longest gives way.
+ *
+ * @example
+ * @code
+ * CartWall* carts = new CartWall(this);
+ * carts->setCarts({"/jingles/id.ogg", "/jingles/sweeper.ogg"});
+ * playbackEngine->setCartWall(carts);
+ * ...
+ * playbackEngine->playCart(carts->slotOf("/jingles/id.ogg"));
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class CartWall : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int MAX_CARTS = 32;
+    static constexpr int MAX_VOICES = 8;
+    static constexpr int MAX_CART_SECONDS = 60;
+    static constexpr int CHANNELS = 2;
+
+    explicit CartWall(QObject* parent = nullptr);
+    ~CartWall() override;
+
+    /**
+     * @brief Decode a file into a slot in the background
+     *
+     * The slot keeps its current cart until the new one is decoded.
+     * @param slot Slot, 0 to MAX_CARTS - 1
+     * @param filePath Path of the audio file
+     * @return false if the slot does not exist
+     */
+    bool load(int slot, const QString& filePath);
+
+    /**
+     * @brief Put decoded audio in a slot, replacing its cart
+     * @param slot Slot, 0 to MAX_CARTS - 1
+     * @param filePath Name of the cart
+     * @param samples Interleaved stereo float samples
+     * @param sampleRate Rate of the samples in Hz
+     * @return false if the slot does not exist or the audio is empty or too long
+     */
+    bool setCart(int slot, const QString& filePath, std::vector<float> samples, int sampleRate);
+
+    /**
+     * @brief Fill the wall from a list of files, the first one in slot 0
+     *
+     * Slots that already hold their file are left alone; slots past the
+     * list are emptied and files past MAX_CARTS are ignored.
+     */
+    void setCarts(const QStringList& filePaths);
+
+    /**
+     * @brief Empty a slot; a voice still playing its cart plays to the end
+     */
+    void unload(int slot);
+
+    bool isLoaded(int slot) const;
+    QString path(int slot) const;
+
+    /**
+     * @brief Length of the cart in a slot, -1 if it is empty
+     */
+    qint64 durationMs(int slot) const;
+
+    /**
+     * @brief Slot holding a file, -1 if it is not on the wall
+     */
+    int slotOf(const QString& filePath) const;
+
+    /**
+     * @brief Memory held by the decoded carts, in bytes
+     */
+    qint64 memoryBytes() const;
+
+    /**
+     * @brief Start a cart from the top; thread-safe
+     * @return false if the slot is empty
+     */
+    bool trigger(int slot);
+
+    /**
+     * @brief Stop the voices of one slot, or of all of them; thread-safe
+     */
+    void stop(int slot);
+    void stopAll();
+
+    /**
+     * @brief Whether nothing is playing and nothing is waiting to start
+     */
+    bool isIdle() const;
+
+    /**
+     * @brief Voices playing, as of the last rendered block
+     */
+    int activeVoices() const { return m_activeVoices.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Add the playing carts to a block of output; audio thread only
+     * @param out Interleaved stereo float samples to add to
+     * @param frames Frames in the block
+     * @param sampleRate Rate of the output in Hz
+     */
+    void render(float* out, int frames, int sampleRate);
+
+signals:
+    void cartLoaded(int slot, const QString& filePath);
+    void loadFailed(int slot, const QString& filePath, const QString& error);
+
+private:
+    struct Cart {
+        QString path;
+        std::vector<float> samples;
+        int sampleRate = 0;
+
+        qint64 frames() const { return qint64(samples.size()) / CHANNELS; }
+    };
+
+    struct Decoded {
+        std::vector<float> samples;
+        int sampleRate = 0;
+        QString error;
+    };
+
+    struct Command {
+        enum class Type { Start, Stop, StopAll } type = Type::Start;
+        int slot = -1;
+        std::shared_ptr<const Cart> cart;
+    };
+
+    struct Voice {
+        std::shared_ptr<const Cart> cart;
+        int slot = -1;
+        double position = 0.0;   ///< Frame of the cart, fractional when the rates differ
+        qint64 startedAt = 0;    ///< Block the voice started in, to find the oldest
+    };
+
+    static Decoded decode(const QString& filePath);
+    bool isValidSlot(int slot) const { return slot >= 0 && slot < MAX_CARTS; }
+    void post(Command command);
+    void start(Command& command);
+    void release(Voice& voice);
+
+    static constexpr int MAX_COMMANDS = 64;
+    static constexpr int DECODE_SAMPLE_RATE = 48000;
+
+    QThreadPool m_pool;
+    std::array<QString, MAX_CARTS> m_loading;   ///< File being decoded for each slot
+
+    // Guarded by m_mutex, which the audio thread only ever tries to take
+    mutable QMutex m_mutex;
+    std::array<std::shared_ptr<const Cart>, MAX_CARTS> m_carts;
+    std::vector<Command> m_commands;
+    std::vector<std::shared_ptr<const Cart>> m_retired;   ///< Freed off the audio thread
+
+    // Audio thread only
+    std::array<Voice, MAX_VOICES> m_voices;
+    qint64 m_blocks = 0;
+
+    std::atomic<int> m_activeVoices{0};
+    std::atomic<int> m_pendingCommands{0};
+};
+
+#endif // CARTWALL_H
@@ -0,0 +1,69 @@
+#include "ConfigReloader.h"
+#include <QDebug>
+#include <QSet>
+#include <algorithm>
+
+ConfigReloader::ConfigReloader(QObject* parent)
+    : QObject(parent)
+{
+}
+
+void ConfigReloader::subscribe(const QString& name, const QStringList& keys, Apply apply)
+{
+    m_subscriptions.append({name, keys, std::move(apply)});
+}
+
+QStringList ConfigReloader::reload(const QSettings& settings)
+{
+    QHash<QString, QVariant> values;
+    for (const QString& key : settings.allKeys()) {
+        values.insert(key, settings.value(key));
+    }
+
+    QSet<QString> changed;
+    for (auto it = values.cbegin(); it != values.cend(); ++it) {
+        const auto previous = m_values.constFind(it.key());
+        if (previous == m_values.cend() || previous.value() != it.value()) {
+            changed.insert(it.key());
+        }
+    }
+    for (auto it = m_values.cbegin(); it != m_values.cend(); ++it) {
+        if (!values.contains(it.key())) {
+            changed.insert(it.key());
+        }
+    }
+    m_values = std::move(values);
+
+    const bool first = !m_loaded;
+    m_loaded = true;
+    m_changed = QStringList(changed.cbegin(), changed.cend());
+    std::sort(m_changed.begin(), m_changed.end());
+    if (first || m_changed.isEmpty()) {
+        return QStringList();
+    }
+
+    QStringList applied;
+    for (const Subscription& subscription : std::as_const(m_subscriptions)) {
+        if (matches(subscription, m_changed)) {
+            subscription.apply();
+            applied.append(subscription.name);
+        }
+    }
+    qInfo() << "ConfigReloader:" << m_changed.size() << "settings changed, reapplied"
+            << applied;
+    return applied;
+}
+
+bool ConfigReloader::matches(const Subscription& subscription, const QStringList& changed)
+{
+    for (const QString& key : subscription.keys) {
+        const bool prefix = key.endsWith('*');
+        const QString stem = prefix ? key.chopped(1) : key;
+        for (const QString& name : changed) {
+            if (prefix ? name.startsWith(stem) : name == stem) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
@@ -0,0 +1,85 @@
+#ifndef CONFIGRELOADER_H
+#define CONFIGRELOADER_H
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QSettings>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include <functional>
+
+/**
+ * @brief Applies a changed configuration to only the parts that read it
+ *
+ * Saving the options reapplied everything: the metrics and remote ports
+ * were closed and opened again, the air-check started a new file, the
+ * library was rescanned, whatever had changed. ConfigReloader keeps the
+ * values of the last reload, and on the next one runs the subscriptions
+ * whose keys changed, once each and in the order they subscribed; the
+ * others are left as they are.
+ *
+ * A key ending in '*' stands for every key it starts, so "DeadAir*" covers
+ * DeadAirSeconds and DeadAirThresholdDb. A key that was added or removed
+ * counts as changed.
+ *
+ * The first reload only records the values: the subsystems apply their
+ * settings themselves when they are set up.
+ *
+ * @example
+ * @code
+ * reloader->subscribe("metrics", {"MetricsPort"}, [this]() { applyMetrics(); });
+ * reloader->subscribe("dead air", {"DeadAir*"}, [this]() { applyDeadAir(); });
+ * reloader->reload(settings);   // At startup: nothing runs
+ * // ... the options are saved ...
+ * reloader->reload(settings);   // Runs what reads the keys that changed
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class ConfigReloader : public QObject
+{
+    Q_OBJECT
+
+public:
+    using Apply = std::function<void()>;
+
+    explicit ConfigReloader(QObject* parent = nullptr);
+
+    /**
+     * @brief Run apply whenever one of keys changes
+     * @param name Name for the log
+     * @param keys Keys read, or prefixes ending in '*'
+     */
+    void subscribe(const QString& name, const QStringList& keys, Apply apply);
+
+    /**
+     * @brief Compare the settings with the last reload and apply the changes
+     * @return Names of the subscriptions that ran
+     */
+    QStringList reload(const QSettings& settings);
+
+    bool isLoaded() const { return m_loaded; }
+
+    /**
+     * @brief Get the keys that differed at the last reload, sorted
+     */
+    QStringList changedKeys() const { return m_changed; }
+
+private:
+    struct Subscription {
+        QString name;
+        QStringList keys;
+        Apply apply;
+    };
+
+    static bool matches(const Subscription& subscription, const QStringList& changed);
+
+    QList<Subscription> m_subscriptions;
+    QHash<QString, QVariant> m_values;
+    QStringList m_changed;
+    bool m_loaded = false;
+};
+
+#endif // CONFIGRELOADER_H
@@ -4,6 +4,7 @@
 #include <QDebug>
 #include <QMutexLocker>
 #include <QMutex>
+#include <atomic>
 
 ConfigurationService::ConfigurationService(QObject* parent)
     : BaseService(parent)
@@ -14,6 +15,7 @@ ConfigurationService::ConfigurationService(QObject* parent)
     
     QString configFile = QDir(configPath).filePath("xfb.conf");
     m_settings = std::make_unique<QSettings>(configFile, QSettings::IniFormat);
+    rebuildSnapshot();
 }
 
 ConfigurationService::~ConfigurationService()
@@ -30,7 +32,11 @@ bool ConfigurationService::initialize()
 bool ConfigurationService::doInitialize()
 {
     try {
-        loadDefaults();
+        {
+            QMutexLocker locker(&m_mutex);
+            loadDefaults();
+            rebuildSnapshot();
+        }
         
         if (!validateConfiguration()) {
             qWarning() << "ConfigurationService: Invalid configuration detected, resetting to defaults";
@@ -60,8 +66,14 @@ void ConfigurationService::doShutdown()
 
 QVariant ConfigurationService::getValue(const QString& key, const QVariant& defaultValue) const
 {
-    QMutexLocker locker(&m_mutex);
-    return m_settings->value(key, defaultValue);
+    const std::shared_ptr<const QVariantHash> values = snapshot();
+    const auto it = values->constFind(key);
+    return it != values->cend() ? it.value() : defaultValue;
+}
+
+std::shared_ptr<const QVariantHash> ConfigurationService::snapshot() const
+{
+    return std::atomic_load(&m_snapshot);
 }
 
 void ConfigurationService::setValue(const QString& key, const QVariant& value)
@@ -75,10 +87,18 @@ void ConfigurationService::setValue(const QString& key, const QVariant& value)
     }
     
     QVariant oldValue = m_settings->value(key);
-    if (oldValue != value) {
-        m_settings->setValue(key, value);
-        emit configurationChanged(key, value);
+    if (oldValue == value) {
+        return;
     }
+    m_settings->setValue(key, value);
+    
+    // Copy on write: readers still holding the old snapshot are not affected
+    auto values = std::make_shared<QVariantHash>(*std::atomic_load(&m_snapshot));
+    values->insert(key, value);
+    std::atomic_store(&m_snapshot, std::shared_ptr<const QVariantHash>(std::move(values)));
+    
+    locker.unlock(); // Slots may read the configuration again
+    emit configurationChanged(key, value);
 }
 
 QString ConfigurationService::getLanguage() const
@@ -178,6 +198,7 @@ void ConfigurationService::resetToDefaults()
     m_settings->setValue("database/path", QDir(defaultPath).filePath("xfb.db"));
     m_settings->setValue("database/autoBackup", true);
     m_settings->setValue("database/backupRetentionDays", 30);
+    rebuildSnapshot();
     
     locker.unlock(); // Unlock before emitting signal
     emit configurationChanged("*", QVariant()); // Signal that all configuration changed
@@ -187,6 +208,8 @@ void ConfigurationService::sync()
 {
     QMutexLocker locker(&m_mutex);
     m_settings->sync();
+    // sync() also reads what other processes wrote to the file
+    rebuildSnapshot();
 }
 
 void ConfigurationService::loadDefaults()
@@ -250,4 +273,15 @@ bool ConfigurationService::validateKey(const QString& key, const QVariant& value
     
     // Default: allow all other keys
     return true;
-}
\ No newline at end of file
+}
+
+void ConfigurationService::rebuildSnapshot()
+{
+    auto values = std::make_shared<QVariantHash>();
+    const QStringList keys = m_settings->allKeys();
+    values->reserve(keys.size());
+    for (const QString& key : keys) {
+        values->insert(key, m_settings->value(key));
+    }
+    std::atomic_store(&m_snapshot, std::shared_ptr<const QVariantHash>(std::move(values)));
+}
@@ -6,6 +6,7 @@
 #include <QVariant>
 #include <QString>
 #include <QMutex>
+#include <QVariantHash>
 #include <memory>
 
 /**
@@ -14,6 +15,19 @@
  * The ConfigurationService provides centralized configuration management
  * with validation and secure storage capabilities.
  * 
+ * Reads come from an immutable snapshot of every value rather than from
+ * QSettings, so getValue() takes no lock and never touches the disk, and
+ * can be called from any thread. setValue() writes QSettings and publishes
+ * a new snapshot with the value changed; readers holding the old one keep
+ * a consistent view of the configuration until they let it go.
+ * 
+ * @example
+ * @code
+ * auto values = config->snapshot();   // one consistent view for a burst of reads
+ * QString language = values->value("ui/language").toString();
+ * int volume = values->value("audio/defaultVolume").toInt();
+ * @endcode
+ * 
  * @since XFB 2.0
  */
 class ConfigurationService : public BaseService
@@ -38,6 +52,14 @@ public:
      */
     QVariant getValue(const QString& key, const QVariant& defaultValue = QVariant()) const;
 
+    /**
+     * @brief Configuration values as they were at one moment
+     *
+     * The snapshot never changes; a later setValue() publishes a new one.
+     * @return Every key and its value
+     */
+    std::shared_ptr<const QVariantHash> snapshot() const;
+
     /**
      * @brief Set configuration value
      * @param key Configuration key
@@ -154,9 +176,15 @@ private:
      */
     bool validateKey(const QString& key, const QVariant& value) const;
 
+    /**
+     * @brief Publish a snapshot of everything in QSettings; call with m_mutex held
+     */
+    void rebuildSnapshot();
+
 private:
     std::unique_ptr<QSettings> m_settings;
-    mutable QMutex m_mutex;
+    mutable QMutex m_mutex;   ///< Serializes writers; readers use m_snapshot
+    std::shared_ptr<const QVariantHash> m_snapshot;   ///< Swapped with std::atomic_store
 };
 
 #endif // CONFIGURATIONSERVICE_H
\ No newline at end of file
@@ -0,0 +1,200 @@
+#include "ContentHash.h"
+#include <QByteArray>
+#include <QFile>
+#include <QList>
+#include <QtEndian>
+#include <cstring>
+
+namespace {
+
+constexpr quint64 PRIME1 = 11400714785074694791ULL;
+constexpr quint64 PRIME2 = 14029467366897019727ULL;
+constexpr quint64 PRIME3 = 1609587929392839161ULL;
+constexpr quint64 PRIME4 = 9650029242287828579ULL;
+constexpr quint64 PRIME5 = 2870177450012600261ULL;
+
+constexpr int ID3V1_SIZE = 128;
+constexpr int APE_FOOTER_SIZE = 32;
+constexpr quint32 APE_HAS_HEADER = 0x80000000u;
+
+inline quint64 rotl(quint64 value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+inline quint64 read64(const char* data)
+{
+    quint64 value;
+    std::memcpy(&value, data, sizeof(value));
+    return qFromLittleEndian(value);
+}
+
+inline quint32 read32(const char* data)
+{
+    quint32 value;
+    std::memcpy(&value, data, sizeof(value));
+    return qFromLittleEndian(value);
+}
+
+inline quint64 xxRound(quint64 acc, quint64 lane)
+{
+    return rotl(acc + lane * PRIME2, 31) * PRIME1;
+}
+
+inline quint64 mergeRound(quint64 acc, quint64 value)
+{
+    return (acc ^ xxRound(0, value)) * PRIME1 + PRIME4;
+}
+
+qint64 id3v2Size(const QByteArray& head)
+{
+    if (head.size() < 10 || !head.startsWith("ID3")) {
+        return 0;
+    }
+    const auto* u = reinterpret_cast<const uchar*>(head.constData());
+    const qint64 size = (qint64(u[6] & 0x7F) << 21) | (qint64(u[7] & 0x7F) << 14) |
+                        (qint64(u[8] & 0x7F) << 7) | qint64(u[9] & 0x7F);
+    return 10 + size + ((u[5] & 0x10) ? 10 : 0);
+}
+
+} // namespace
+
+QString ContentHash::ofFile(const QString& filePath, QString* error)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error) {
+            *error = QString("Cannot open file: %1").arg(file.errorString());
+        }
+        return QString();
+    }
+
+    const Range payload = payloadRange(file);
+    if (payload.length <= 0) {
+        if (error) {
+            *error = "File holds no audio";
+        }
+        return QString();
+    }
+
+    // The size goes in first, so a truncated copy never matches the full file
+    QByteArray sample(sizeof(quint64), Qt::Uninitialized);
+    qToLittleEndian<quint64>(static_cast<quint64>(payload.length), sample.data());
+
+    QList<Range> parts;
+    if (payload.length <= 3 * qint64(SAMPLE_SIZE)) {
+        parts.append(payload);
+    } else {
+        parts.append({payload.offset, SAMPLE_SIZE});
+        parts.append({payload.offset + (payload.length - SAMPLE_SIZE) / 2, SAMPLE_SIZE});
+        parts.append({payload.offset + payload.length - SAMPLE_SIZE, SAMPLE_SIZE});
+    }
+
+    for (const Range& part : std::as_const(parts)) {
+        const QByteArray bytes = file.seek(part.offset) ? file.read(part.length) : QByteArray();
+        if (bytes.size() != part.length) {
+            if (error) {
+                *error = QString("Cannot read file: %1").arg(file.errorString());
+            }
+            return QString();
+        }
+        sample.append(bytes);
+    }
+
+    return QString("%1").arg(xxh64(sample.constData(), sample.size()), 16, 16, QChar('0'));
+}
+
+ContentHash::Range ContentHash::payloadRange(QFile& file)
+{
+    qint64 begin = 0;
+    qint64 end = file.size();
+
+    if (file.seek(0)) {
+        begin = qMin(end, id3v2Size(file.read(10)));
+    }
+
+    if (end - begin >= ID3V1_SIZE && file.seek(end - ID3V1_SIZE) && file.read(3) == "TAG") {
+        end -= ID3V1_SIZE;
+    }
+
+    // APEv2 sits before ID3v1 when a file has both; its size leaves out the header
+    if (end - begin >= APE_FOOTER_SIZE && file.seek(end - APE_FOOTER_SIZE)) {
+        const QByteArray footer = file.read(APE_FOOTER_SIZE);
+        if (footer.size() == APE_FOOTER_SIZE && footer.startsWith("APETAGEX")) {
+            const quint32 flags = read32(footer.constData() + 20);
+            const qint64 size = qint64(read32(footer.constData() + 12)) +
+                                ((flags & APE_HAS_HEADER) ? APE_FOOTER_SIZE : 0);
+            if (size <= end - begin) {
+                end -= size;
+            }
+        }
+    }
+
+    // FLAC keeps its tags and pictures in metadata blocks before the frames
+    if (end - begin >= 4 && file.seek(begin) && file.read(4) == "fLaC") {
+        qint64 position = begin + 4;
+        while (position + 4 <= end && file.seek(position)) {
+            const QByteArray header = file.read(4);
+            if (header.size() != 4) {
+                break;
+            }
+            const auto* u = reinterpret_cast<const uchar*>(header.constData());
+            position += 4 + ((qint64(u[1]) << 16) | (qint64(u[2]) << 8) | qint64(u[3]));
+            if (u[0] & 0x80) {
+                break;
+            }
+        }
+        begin = qMin(position, end);
+    }
+
+    Range range;
+    range.offset = begin;
+    range.length = qMax<qint64>(0, end - begin);
+    return range;
+}
+
+quint64 ContentHash::xxh64(const char* data, qsizetype length, quint64 seed)
+{
+    const char* p = data;
+    const char* const end = data + length;
+    quint64 hash;
+
+    if (length >= 32) {
+        quint64 v1 = seed + PRIME1 + PRIME2;
+        quint64 v2 = seed + PRIME2;
+        quint64 v3 = seed;
+        quint64 v4 = seed - PRIME1;
+        for (; p + 32 <= end; p += 32) {
+            v1 = xxRound(v1, read64(p));
+            v2 = xxRound(v2, read64(p + 8));
+            v3 = xxRound(v3, read64(p + 16));
+            v4 = xxRound(v4, read64(p + 24));
+        }
+        hash = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        hash = mergeRound(hash, v1);
+        hash = mergeRound(hash, v2);
+        hash = mergeRound(hash, v3);
+        hash = mergeRound(hash, v4);
+    } else {
+        hash = seed + PRIME5;
+    }
+
+    hash += static_cast<quint64>(length);
+    for (; p + 8 <= end; p += 8) {
+        hash = rotl(hash ^ xxRound(0, read64(p)), 27) * PRIME1 + PRIME4;
+    }
+    if (p + 4 <= end) {
+        hash = rotl(hash ^ (quint64(read32(p)) * PRIME1), 23) * PRIME2 + PRIME3;
+        p += 4;
+    }
+    for (; p < end; ++p) {
+        hash = rotl(hash ^ (quint64(static_cast<uchar>(*p)) * PRIME5), 11) * PRIME1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= PRIME2;
+    hash ^= hash >> 29;
+    hash *= PRIME3;
+    hash ^= hash >> 32;
+    return hash;
+}
@@ -0,0 +1,73 @@
+#ifndef CONTENTHASH_H
+#define CONTENTHASH_H
+
+#include <QString>
+#include <QtGlobal>
+
+class QFile;
+
+/**
+ * @brief Fingerprints the audio in a file so copies can be found whatever their tags
+ *
+ * The same track often reaches the library twice: once from a CD rip and
+ * once from a download, or as a copy with corrected tags. The paths differ,
+ * so MusicRepository's path check lets both in.
+ *
+ * ContentHash takes the XXH64 hash of the audio payload. Tags that editors
+ * rewrite are left out first: ID3v2 at the start, ID3v1 and APEv2 at the
+ * end, and the metadata blocks of FLAC files. Reading a whole library of
+ * files would take far longer than importing it, so only the size of the
+ * payload and SAMPLE_SIZE bytes at its start, middle and end are hashed.
+ * Two different recordings that agree on all of that in practice do not
+ * exist; copies that were re-encoded, on the other hand, do not match.
+ *
+ * @example
+ * @code
+ * QString error;
+ * const QString hash = ContentHash::ofFile("/music/song.mp3", &error);
+ * if (!hash.isEmpty() && musicRepository->findMusicByContentHash(hash).id != -1) {
+ *     // Already in the library
+ * }
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class ContentHash
+{
+public:
+    /**
+     * @brief Part of a file that holds the audio
+     */
+    struct Range {
+        qint64 offset = 0;
+        qint64 length = 0;
+    };
+
+    static constexpr int SAMPLE_SIZE = 64 * 1024;
+
+    /**
+     * @brief Hash the audio payload of a file
+     * @param filePath Path of the audio file
+     * @param error Set to the reason if the file cannot be read
+     * @return 16 lowercase hex digits, or an empty string on error
+     */
+    static QString ofFile(const QString& filePath, QString* error = nullptr);
+
+    /**
+     * @brief Find the audio payload of an open file, leaving out its tags
+     * @param file File opened for reading
+     * @return Offset and length of the payload
+     */
+    static Range payloadRange(QFile& file);
+
+    /**
+     * @brief XXH64 of a block of memory
+     * @param data Bytes to hash
+     * @param length Number of bytes
+     * @param seed Hash seed
+     * @return The 64-bit hash
+     */
+    static quint64 xxh64(const char* data, qsizetype length, quint64 seed = 0);
+};
+
+#endif // CONTENTHASH_H
@@ -0,0 +1,139 @@
+#include "ContentHashScanner.h"
+#include "BackgroundThrottle.h"
+#include "ContentHash.h"
+#include "../repositories/MusicRepository.h"
+#include <QDebug>
+#include <QFutureWatcher>
+#include <QSet>
+#include <QThread>
+#include <QtConcurrent/QtConcurrent>
+
+ContentHashScanner::ContentHashScanner(MusicRepository* repository, QObject* parent)
+    : QObject(parent)
+    , m_repository(repository)
+    , m_hash([](const QString& filePath, QString* error) {
+        return ContentHash::ofFile(filePath, error);
+    })
+    , m_maxWorkers(qMax(1, QThread::idealThreadCount() * 2))
+{
+    m_pool.setThreadPriority(QThread::LowPriority);
+    m_pool.setMaxThreadCount(m_maxWorkers);
+}
+
+ContentHashScanner::~ContentHashScanner()
+{
+    m_queue.clear();
+    m_pool.waitForDone();
+}
+
+void ContentHashScanner::setMaxWorkers(int workers)
+{
+    m_maxWorkers = qMax(1, workers);
+    m_pool.setMaxThreadCount(m_maxWorkers);
+    schedule();
+}
+
+int ContentHashScanner::scan(const QStringList& filePaths)
+{
+    const QSet<QString> waiting(m_queue.cbegin(), m_queue.cend());
+    int added = 0;
+    for (const QString& filePath : filePaths) {
+        if (filePath.isEmpty() || waiting.contains(filePath)) {
+            continue;
+        }
+        m_queue.append(filePath);
+        ++added;
+    }
+    if (added == 0) {
+        return 0;
+    }
+
+    m_total += added;
+    m_running = true;
+    schedule();
+    return added;
+}
+
+void ContentHashScanner::cancel()
+{
+    if (!m_running) {
+        return;
+    }
+
+    m_queue.clear();
+    ++m_generation;
+    m_inFlight = 0;
+    finish();
+}
+
+void ContentHashScanner::schedule()
+{
+    while (m_running && m_inFlight < m_maxWorkers && !m_queue.isEmpty()) {
+        const QString filePath = m_queue.takeFirst();
+        ++m_inFlight;
+
+        auto* watcher = new QFutureWatcher<Outcome>(this);
+        const int generation = m_generation;
+        connect(watcher, &QFutureWatcher<Outcome>::finished, this, [this, watcher, generation]() {
+            onHashed(watcher->result(), generation);
+            watcher->deleteLater();
+        });
+        watcher->setFuture(QtConcurrent::run(&m_pool, [hash = m_hash, filePath]() {
+            BackgroundThrottle::lowerCurrentThread();
+            BackgroundThrottle::pace();
+            Outcome outcome;
+            outcome.filePath = filePath;
+            outcome.hash = hash(filePath, &outcome.error);
+            return outcome;
+        }));
+    }
+}
+
+void ContentHashScanner::onHashed(const Outcome& outcome, int generation)
+{
+    if (generation != m_generation) {
+        return;
+    }
+    --m_inFlight;
+
+    if (!outcome.hash.isEmpty()) {
+        m_ready.insert(outcome.filePath, outcome.hash);
+        ++m_hashed;
+        if (m_ready.size() >= BATCH_SIZE) {
+            flush();
+        }
+    } else {
+        ++m_failed;
+        qWarning() << QString("ContentHashScanner::onHashed - %1: %2")
+                          .arg(outcome.filePath, outcome.error);
+    }
+    emit progressChanged(m_hashed + m_failed, m_total);
+
+    if (m_queue.isEmpty() && m_inFlight == 0) {
+        finish();
+    } else {
+        schedule();
+    }
+}
+
+void ContentHashScanner::flush()
+{
+    if (m_repository && !m_ready.isEmpty()) {
+        m_repository->setContentHashes(m_ready);
+    }
+    m_ready.clear();
+}
+
+void ContentHashScanner::finish()
+{
+    const int hashed = m_hashed;
+    const int failed = m_failed;
+    m_running = false;
+    m_total = 0;
+    m_hashed = 0;
+    m_failed = 0;
+
+    flush();
+    qInfo() << "ContentHashScanner: scan finished," << hashed << "hashed," << failed << "failed";
+    emit finished(hashed, failed);
+}
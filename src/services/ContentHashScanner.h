@@ -0,0 +1,115 @@
+#ifndef CONTENTHASHSCANNER_H
+#define CONTENTHASHSCANNER_H
+
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <functional>
+
+class MusicRepository;
+
+/**
+ * @brief Hashes the tracks that were added before content hashing, in parallel
+ *
+ * New tracks are hashed by MusicRepository::addMusicBatch(). For the rest
+ * of the library, ContentHashScanner runs ContentHash::ofFile() on its own
+ * low-priority thread pool, up to maxWorkers() files at a time, and
+ * stores the hashes with MusicRepository::setContentHashes() in batches of
+ * BATCH_SIZE. Once every track has a hash,
+ * MusicRepository::findContentDuplicates() covers the whole library.
+ *
+ * @example
+ * @code
+ * ContentHashScanner* scanner = new ContentHashScanner(musicRepository, this);
+ * connect(scanner, &ContentHashScanner::finished, this, [this](int hashed, int failed) {
+ *     const auto duplicates = musicRepository->findContentDuplicates();
+ * });
+ * scanner->scan(musicRepository->getPathsWithoutContentHash());
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class ContentHashScanner : public QObject
+{
+    Q_OBJECT
+
+public:
+    /// Runs on a pool thread; ContentHash::ofFile() unless replaced
+    using Hasher = std::function<QString(const QString& filePath, QString* error)>;
+
+    static constexpr int BATCH_SIZE = 200;
+
+    explicit ContentHashScanner(MusicRepository* repository, QObject* parent = nullptr);
+    ~ContentHashScanner() override;
+
+    /**
+     * @brief Set how many files are read at once
+     * @param workers Worker count; twice the number of cores by default,
+     *        since the workers mostly wait for the disk
+     */
+    void setMaxWorkers(int workers);
+    int maxWorkers() const { return m_maxWorkers; }
+
+    void setHasher(Hasher hasher) { m_hash = std::move(hasher); }
+
+    /**
+     * @brief Add tracks to the scan and start it if it is not running
+     * @param filePaths Paths as stored in the musics table
+     * @return Number of tracks added; tracks already waiting are skipped
+     */
+    int scan(const QStringList& filePaths);
+
+    /**
+     * @brief Drop the tracks that have not been started
+     *
+     * Hashes found so far are still stored.
+     */
+    void cancel();
+
+    bool isRunning() const { return m_running; }
+
+signals:
+    /**
+     * @brief Emitted after each track
+     * @param done Tracks finished, including those that failed
+     * @param total Tracks in this scan
+     */
+    void progressChanged(int done, int total);
+
+    /**
+     * @brief Emitted when the last track of the scan is done, or after cancel()
+     * @param hashed Tracks whose hash was stored
+     * @param failed Tracks that could not be read
+     */
+    void finished(int hashed, int failed);
+
+private:
+    struct Outcome {
+        QString filePath;
+        QString hash;
+        QString error;
+    };
+
+    void schedule();
+    void onHashed(const Outcome& outcome, int generation);
+    void flush();
+    void finish();
+
+    MusicRepository* m_repository;
+    QThreadPool m_pool;
+    Hasher m_hash;
+    int m_maxWorkers;
+
+    QStringList m_queue;
+    QHash<QString, QString> m_ready;   ///< Hashes not yet stored, by path
+    bool m_running = false;
+    int m_inFlight = 0;
+    int m_generation = 0;   ///< Bumped by cancel() so late results are dropped
+    int m_total = 0;
+    int m_hashed = 0;
+    int m_failed = 0;
+};
+
+#endif // CONTENTHASHSCANNER_H
@@ -1,6 +1,7 @@
 #include "ContextSensitiveHelpService.h"
 #include "AccessibilityManager.h"
 #include "AccessibleHelpSystem.h"
+#include "HelpCorpus.h"
 #include <QApplication>
 #include <QDateTime>
 #include <QSettings>
@@ -60,8 +61,7 @@ bool ContextSensitiveHelpService::initialize()
 
     qDebug() << "ContextSensitiveHelpService: Initializing context-sensitive help service";
 
-    // Load default context mappings
-    loadDefaultContextMappings();
+    // The default context mappings are read from HelpCorpus when first looked up
     
     // Load default workflow help
     loadDefaultWorkflowHelp();
@@ -208,7 +208,7 @@ ContextSensitiveHelpService::ContextHelpMapping ContextSensitiveHelpService::get
     }
 
     QString contextId = determineContextId(widget);
-    return m_contextMappings.value(contextId, ContextHelpMapping());
+    return mappingFor(contextId);
 }
 
 bool ContextSensitiveHelpService::showContextHelp()
@@ -224,7 +224,7 @@ bool ContextSensitiveHelpService::showContextHelp(QWidget* widget)
     }
 
     QString contextId = determineContextId(widget);
-    ContextHelpMapping mapping = m_contextMappings.value(contextId);
+    ContextHelpMapping mapping = mappingFor(contextId);
     
     if (mapping.helpContentId.isEmpty()) {
         if (m_accessibilityManager) {
@@ -331,8 +331,7 @@ bool ContextSensitiveHelpService::hasContextHelp(QWidget* widget) const
     }
 
     QString contextId = determineContextId(widget);
-    return m_contextMappings.contains(contextId) && 
-           !m_contextMappings[contextId].helpContentId.isEmpty();
+    return !mappingFor(contextId).helpContentId.isEmpty();
 }
 
 ContextSensitiveHelpService::HelpContext ContextSensitiveHelpService::getCurrentContext() const
@@ -529,11 +528,10 @@ bool ContextSensitiveHelpService::shouldTriggerAutoHelp(const QString& contextId
     }
 
     // Check if we have help for this context
-    if (!m_contextMappings.contains(contextId)) {
+    const ContextHelpMapping mapping = mappingFor(contextId);
+    if (mapping.contextId.isEmpty()) {
         return false;
     }
-
-    const ContextHelpMapping& mapping = m_contextMappings[contextId];
     
     // Check if auto trigger is enabled for this context
     if (!mapping.autoTrigger) {
@@ -565,7 +563,7 @@ void ContextSensitiveHelpService::triggerAutoHelp()
     QString contextId = m_pendingAutoHelpContext;
     m_pendingAutoHelpContext.clear();
 
-    const ContextHelpMapping& mapping = m_contextMappings[contextId];
+    const ContextHelpMapping mapping = mappingFor(contextId);
     
     QString suggestion;
     if (!mapping.audioDescription.isEmpty()) {
@@ -584,54 +582,28 @@ void ContextSensitiveHelpService::triggerAutoHelp()
     emit autoHelpSuggestion(contextId, suggestion);
 }
 
-void ContextSensitiveHelpService::loadDefaultContextMappings()
-{
-    // Player controls context help
-    ContextHelpMapping playerMapping;
-    playerMapping.contextId = "player";
-    playerMapping.helpContentId = "player_controls_overview";
-    playerMapping.audioDescription = "Player controls. Use Space to play/pause, Ctrl+Up/Down for volume.";
-    playerMapping.priority = 90;
-    playerMapping.autoTrigger = true;
-    playerMapping.autoTriggerDelay = 3;
-    registerContextHelp("player", playerMapping);
-
-    // Database grid context help
-    ContextHelpMapping databaseMapping;
-    databaseMapping.contextId = "QTableView";
-    databaseMapping.helpContentId = "database_management_overview";
-    databaseMapping.audioDescription = "Database grid. Use arrow keys to navigate, F2 to edit, Enter to confirm.";
-    databaseMapping.priority = 85;
-    databaseMapping.autoTrigger = true;
-    databaseMapping.autoTriggerDelay = 5;
-    registerContextHelp("QTableView", databaseMapping);
-
-    // Playlist context help
-    ContextHelpMapping playlistMapping;
-    playlistMapping.contextId = "QListWidget";
-    playlistMapping.helpContentId = "playlist_management_overview";
-    playlistMapping.audioDescription = "Playlist. Use arrow keys to navigate, Ctrl+C/V to copy/paste tracks.";
-    playlistMapping.priority = 80;
-    playlistMapping.autoTrigger = true;
-    registerContextHelp("QListWidget", playlistMapping);
-
-    // Button context help
-    ContextHelpMapping buttonMapping;
-    buttonMapping.contextId = "QPushButton";
-    buttonMapping.helpContentId = "general_controls_help";
-    buttonMapping.audioDescription = "Button control. Press Enter or Space to activate.";
-    buttonMapping.priority = 50;
-    buttonMapping.autoTrigger = false; // Don't auto-trigger for common controls
-    registerContextHelp("QPushButton", buttonMapping);
-
-    // Text input context help
-    ContextHelpMapping textMapping;
-    textMapping.contextId = "QLineEdit";
-    textMapping.helpContentId = "text_input_help";
-    textMapping.audioDescription = "Text input field. Type to enter text, Tab to move to next field.";
-    textMapping.priority = 60;
-    textMapping.autoTrigger = false;
-    registerContextHelp("QLineEdit", textMapping);
+ContextSensitiveHelpService::ContextHelpMapping
+ContextSensitiveHelpService::mappingFor(const QString& contextId) const
+{
+    const auto registered = m_contextMappings.constFind(contextId);
+    if (registered != m_contextMappings.constEnd()) {
+        return registered.value();
+    }
+
+    for (const HelpCorpus::ContextMapping& builtIn : HelpCorpus::builtIn().contextMappings()) {
+        if (builtIn.contextId == contextId) {
+            ContextHelpMapping mapping;
+            mapping.contextId = builtIn.contextId;
+            mapping.helpContentId = builtIn.helpContentId;
+            mapping.tutorialId = builtIn.tutorialId;
+            mapping.audioDescription = builtIn.audioDescription;
+            mapping.priority = builtIn.priority;
+            mapping.autoTrigger = builtIn.autoTrigger;
+            mapping.autoTriggerDelay = builtIn.autoTriggerDelay;
+            return mapping;
+        }
+    }
+    return ContextHelpMapping();
 }
 
 void ContextSensitiveHelpService::loadDefaultWorkflowHelp()
@@ -336,9 +336,9 @@ private:
     void triggerAutoHelp();
 
     /**
-     * @brief Load default context help mappings
+     * @brief Mapping registered for a context, else the built-in one from HelpCorpus
      */
-    void loadDefaultContextMappings();
+    ContextHelpMapping mappingFor(const QString& contextId) const;
 
     /**
      * @brief Load default workflow help sequences
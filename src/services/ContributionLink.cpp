@@ -0,0 +1,531 @@
+#include "ContributionLink.h"
+#include <QDebug>
+#include <QIODevice>
+#include <QMediaDevices>
+#include <QMutexLocker>
+#include <QRandomGenerator>
+#include <QTimer>
+#include <QUdpSocket>
+#include <QtEndian>
+#include <QtMultimedia/QAudioSink>
+#include <algorithm>
+
+#ifdef XFB_HAVE_OPUS
+#include <opus.h>
+#endif
+
+namespace {
+
+constexpr char FLAG_REDUNDANT = 0x01;
+
+void appendUInt16(QByteArray& data, quint16 value)
+{
+    const quint16 big = qToBigEndian(value);
+    data.append(reinterpret_cast<const char*>(&big), int(sizeof(big)));
+}
+
+quint16 readUInt16(const QByteArray& data, int offset)
+{
+    return qFromBigEndian<quint16>(reinterpret_cast<const uchar*>(data.constData()) + offset);
+}
+
+/// What the audio sink pulls the decoded audio from
+class PlayoutDevice : public QIODevice
+{
+public:
+    PlayoutDevice(ContributionLink* link, qint64 bufferBytes, QObject* parent)
+        : QIODevice(parent)
+        , m_link(link)
+        , m_bufferBytes(bufferBytes)
+    {
+    }
+
+    bool isSequential() const override { return true; }
+
+    // Silence is played while nothing arrives, so there is always more
+    qint64 bytesAvailable() const override
+    {
+        return QIODevice::bytesAvailable() + m_bufferBytes;
+    }
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override
+    {
+        const int samples = int(maxSize / qint64(sizeof(float))) & ~1;
+        if (samples <= 0) {
+            return 0;
+        }
+        const int read = m_link->read(reinterpret_cast<float*>(data), samples);
+        return qint64(read) * qint64(sizeof(float));
+    }
+
+    qint64 writeData(const char*, qint64) override { return -1; }
+
+private:
+    ContributionLink* m_link;
+    qint64 m_bufferBytes;
+};
+
+} // namespace
+
+bool ContributionLink::isAvailable()
+{
+#ifdef XFB_HAVE_OPUS
+    return true;
+#else
+    return false;
+#endif
+}
+
+ContributionLink::ContributionLink(QObject* parent)
+    : QObject(parent)
+    , m_context(new QObject)
+{
+    m_decoded.resize(size_t(FRAME_SAMPLES) * CHANNELS);
+    m_clock.start();
+    m_thread.setObjectName("ContributionLink");
+    m_context->moveToThread(&m_thread);
+    connect(&m_thread, &QThread::finished, m_context, &QObject::deleteLater);
+    m_thread.start();
+}
+
+ContributionLink::~ContributionLink()
+{
+    QMetaObject::invokeMethod(
+        m_context, [this]() { stopOnThread(); }, Qt::BlockingQueuedConnection);
+    m_thread.quit();
+    m_thread.wait();
+}
+
+void ContributionLink::setBitrateKbps(int kbps)
+{
+    QMetaObject::invokeMethod(m_context, [this, kbps]() {
+        m_bitrateKbps = qBound(6, kbps, 510);
+#ifdef XFB_HAVE_OPUS
+        if (m_encoder) {
+            opus_encoder_ctl(m_encoder, OPUS_SET_BITRATE(m_bitrateKbps * 1000));
+        }
+#endif
+    });
+}
+
+void ContributionLink::setOutputDevice(const QAudioDevice& device)
+{
+    QMetaObject::invokeMethod(m_context, [this, device]() {
+        m_outputDevice = device;
+        if (m_sink) {
+            stopPlayout();
+            startPlayout();
+        }
+    });
+}
+
+void ContributionLink::send(const QHostAddress& host, quint16 port, PcmReader reader,
+                            int sampleRate)
+{
+    QMetaObject::invokeMethod(m_context, [this, host, port, reader, sampleRate]() {
+        stopOnThread();
+#ifdef XFB_HAVE_OPUS
+        if (sampleRate <= 0 || !reader) {
+            fail("send", "There is nothing to send");
+            return;
+        }
+        int error = OPUS_OK;
+        m_encoder = opus_encoder_create(SAMPLE_RATE, CHANNELS, OPUS_APPLICATION_AUDIO, &error);
+        if (error != OPUS_OK) {
+            m_encoder = nullptr;
+            fail("send", QString("Cannot create the encoder: %1").arg(opus_strerror(error)));
+            return;
+        }
+        opus_encoder_ctl(m_encoder, OPUS_SET_BITRATE(m_bitrateKbps * 1000));
+        opus_encoder_ctl(m_encoder, OPUS_SET_INBAND_FEC(1));
+        opus_encoder_ctl(m_encoder, OPUS_SET_PACKET_LOSS_PERC(EXPECTED_LOSS_PERCENT));
+
+        m_reader = reader;
+        m_host = host;
+        m_port = port;
+        m_sourceRate = sampleRate;
+        m_converter.reset();
+        m_converter.setRates(sampleRate, SAMPLE_RATE);
+        m_pending.clear();
+        m_previous.clear();
+        // A receiver tells a restarted sender by its stream id
+        m_streamId = quint16(QRandomGenerator::global()->bounded(1, 65536));
+        m_sequence = quint16(QRandomGenerator::global()->bounded(65536));
+
+        m_socket = new QUdpSocket(m_context);
+        m_timer = new QTimer(m_context);
+        m_timer->setTimerType(Qt::PreciseTimer);
+        m_timer->setInterval(SEND_INTERVAL_MS);
+        connect(m_timer, &QTimer::timeout, m_context, [this]() { sendPending(); });
+        m_timer->start();
+        qInfo() << "ContributionLink: sending to" << host.toString() << port << "at"
+                << m_bitrateKbps << "kbps";
+#else
+        Q_UNUSED(host)
+        Q_UNUSED(port)
+        Q_UNUSED(reader)
+        Q_UNUSED(sampleRate)
+        fail("send", "XFB was built without Opus");
+#endif
+    });
+}
+
+void ContributionLink::listen(quint16 port)
+{
+    QMetaObject::invokeMethod(m_context, [this, port]() {
+        stopOnThread();
+#ifdef XFB_HAVE_OPUS
+        int error = OPUS_OK;
+        OpusDecoder* decoder = opus_decoder_create(SAMPLE_RATE, CHANNELS, &error);
+        if (error != OPUS_OK) {
+            fail("listen", QString("Cannot create the decoder: %1").arg(opus_strerror(error)));
+            return;
+        }
+        {
+            QMutexLocker locker(&m_mutex);
+            m_decoder = decoder;
+            resetReceiver();
+        }
+
+        m_socket = new QUdpSocket(m_context);
+        if (!m_socket->bind(QHostAddress::Any, port)) {
+            fail("listen", QString("Cannot listen on port %1: %2")
+                               .arg(port)
+                               .arg(m_socket->errorString()));
+            stopOnThread();
+            return;
+        }
+        m_localPort = m_socket->localPort();
+        connect(m_socket, &QUdpSocket::readyRead, m_context, [this]() { receivePending(); });
+        m_timer = new QTimer(m_context);
+        m_timer->setInterval(RECEIVE_TIMEOUT_MS / 4);
+        connect(m_timer, &QTimer::timeout, m_context, [this]() { checkReceiving(); });
+        m_timer->start();
+        if (m_playout) {
+            startPlayout();
+        }
+        qInfo() << "ContributionLink: listening on port" << m_localPort;
+#else
+        Q_UNUSED(port)
+        fail("listen", "XFB was built without Opus");
+#endif
+    });
+}
+
+void ContributionLink::setPlayout(bool playout)
+{
+    QMetaObject::invokeMethod(m_context, [this, playout]() {
+        if (playout == m_playout) {
+            return;
+        }
+        m_playout = playout;
+        if (!m_decoder) {
+            return;
+        }
+        if (playout) {
+            startPlayout();
+        } else {
+            stopPlayout();
+        }
+    });
+}
+
+void ContributionLink::stop()
+{
+    QMetaObject::invokeMethod(m_context, [this]() { stopOnThread(); });
+}
+
+int ContributionLink::read(float* data, int samples)
+{
+    QMutexLocker locker(&m_mutex);
+    const int frames = samples / CHANNELS;
+    int written = 0;
+    while (written < frames) {
+        written += m_resampler.pull(data + size_t(written) * CHANNELS, frames - written);
+        if (written < frames && !decodeNext()) {
+            break;
+        }
+    }
+    std::fill(data + size_t(written) * CHANNELS, data + samples, 0.0f);
+    return samples;
+}
+
+ContributionLink::Statistics ContributionLink::statistics() const
+{
+    QMutexLocker locker(&m_mutex);
+    Statistics statistics;
+    statistics.network = m_jitter.statistics();
+    statistics.recovered = m_recovered;
+    statistics.fecRecovered = m_fecRecovered;
+    statistics.concealed = m_concealed;
+    statistics.depthMs = m_jitter.depth() * FRAME_MS;
+    statistics.targetMs = m_jitter.targetDepth() * FRAME_MS;
+    statistics.jitterMs = m_jitter.jitterMs();
+    statistics.drift = m_resampler.drift();
+    return statistics;
+}
+
+QByteArray ContributionLink::encodePacket(const Packet& packet)
+{
+    const bool redundant = packet.redundant && !packet.previous.isEmpty();
+    QByteArray datagram;
+    datagram.reserve(HEADER_BYTES + packet.primary.size() + packet.previous.size());
+    datagram.append('X');
+    datagram.append('C');
+    datagram.append(redundant ? FLAG_REDUNDANT : char(0));
+    datagram.append(char(0));
+    appendUInt16(datagram, packet.sequence);
+    appendUInt16(datagram, packet.streamId);
+    appendUInt16(datagram, quint16(packet.primary.size()));
+    datagram.append(packet.primary);
+    if (redundant) {
+        datagram.append(packet.previous);
+    }
+    return datagram;
+}
+
+bool ContributionLink::decodePacket(const QByteArray& datagram, Packet& packet)
+{
+    if (datagram.size() < HEADER_BYTES || datagram[0] != 'X' || datagram[1] != 'C') {
+        return false;
+    }
+    const int length = readUInt16(datagram, 8);
+    const int rest = datagram.size() - HEADER_BYTES - length;
+    if (length == 0 || length > MAX_FRAME_BYTES || rest < 0 || rest > MAX_FRAME_BYTES) {
+        return false;
+    }
+    packet.redundant = (datagram[2] & FLAG_REDUNDANT) && rest > 0;
+    packet.sequence = readUInt16(datagram, 4);
+    packet.streamId = readUInt16(datagram, 6);
+    packet.primary = datagram.mid(HEADER_BYTES, length);
+    packet.previous = packet.redundant ? datagram.mid(HEADER_BYTES + length) : QByteArray();
+    return true;
+}
+
+void ContributionLink::stopOnThread()
+{
+    stopPlayout();
+    delete m_timer;
+    m_timer = nullptr;
+    delete m_socket;
+    m_socket = nullptr;
+    m_localPort = 0;
+    m_reader = nullptr;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_haveStream = false;
+#ifdef XFB_HAVE_OPUS
+        if (m_decoder) {
+            opus_decoder_destroy(m_decoder);
+            m_decoder = nullptr;
+        }
+#endif
+    }
+#ifdef XFB_HAVE_OPUS
+    if (m_encoder) {
+        opus_encoder_destroy(m_encoder);
+        m_encoder = nullptr;
+    }
+#endif
+    m_lastPacketMs = -1;
+    checkReceiving();
+}
+
+void ContributionLink::sendPending()
+{
+#ifdef XFB_HAVE_OPUS
+    const int frameValues = FRAME_SAMPLES * CHANNELS;
+    std::vector<float> source(size_t(m_sourceRate * FRAME_MS / 1000 + 1) * CHANNELS);
+    int got;
+    do {
+        got = m_reader(source.data(), int(source.size())) / CHANNELS;
+        if (m_sourceRate == SAMPLE_RATE) {
+            m_pending.insert(m_pending.end(), source.begin(), source.begin() + got * CHANNELS);
+            continue;
+        }
+        m_converter.push(source.data(), got);
+        int converted;
+        do {
+            const size_t size = m_pending.size();
+            m_pending.resize(size + size_t(frameValues));
+            converted = m_converter.pull(m_pending.data() + size, FRAME_SAMPLES);
+            m_pending.resize(size + size_t(converted) * CHANNELS);
+        } while (converted == FRAME_SAMPLES);
+    } while (got * CHANNELS == int(source.size()));
+
+    size_t offset = 0;
+    unsigned char encoded[MAX_FRAME_BYTES];
+    while (m_pending.size() - offset >= size_t(frameValues)) {
+        const int bytes = opus_encode_float(m_encoder, m_pending.data() + offset, FRAME_SAMPLES,
+                                            encoded, MAX_FRAME_BYTES);
+        offset += size_t(frameValues);
+        if (bytes < 0) {
+            fail("send", QString("Cannot encode: %1").arg(opus_strerror(bytes)));
+            continue;
+        }
+
+        Packet packet;
+        packet.redundant = !m_previous.isEmpty();
+        packet.sequence = m_sequence++;
+        packet.streamId = m_streamId;
+        packet.primary = QByteArray(reinterpret_cast<const char*>(encoded), bytes);
+        packet.previous = m_previous;
+        m_socket->writeDatagram(encodePacket(packet), m_host, m_port);
+        m_previous = packet.primary;
+        ++m_packetsSent;
+    }
+    m_pending.erase(m_pending.begin(), m_pending.begin() + ptrdiff_t(offset));
+#endif
+}
+
+void ContributionLink::receivePending()
+{
+    while (m_socket && m_socket->hasPendingDatagrams()) {
+        const qint64 size = qMax<qint64>(0, m_socket->pendingDatagramSize());
+        QByteArray datagram(int(size), Qt::Uninitialized);
+        if (m_socket->readDatagram(datagram.data(), datagram.size()) < 0) {
+            break;
+        }
+        Packet packet;
+        if (!decodePacket(datagram, packet)) {
+            continue;
+        }
+
+        const qint64 now = m_clock.elapsed();
+        QMutexLocker locker(&m_mutex);
+        if (packet.streamId != m_receivedStreamId || !m_haveStream) {
+            if (m_haveStream) {
+                qInfo() << "ContributionLink: the sender restarted";
+            }
+            resetReceiver();
+            m_haveStream = true;
+            m_receivedStreamId = packet.streamId;
+        }
+        m_jitter.push(packet.sequence, datagram, now);
+        m_lastPacketMs = now;
+    }
+    checkReceiving();
+}
+
+void ContributionLink::checkReceiving()
+{
+    const qint64 last = m_lastPacketMs;
+    const bool receiving = last >= 0 && m_clock.elapsed() - last < RECEIVE_TIMEOUT_MS;
+    if (receiving != m_receiving) {
+        m_receiving = receiving;
+        emit receivingChanged(receiving);
+    }
+}
+
+void ContributionLink::startPlayout()
+{
+    const QAudioDevice device =
+        m_outputDevice.isNull() ? QMediaDevices::defaultAudioOutput() : m_outputDevice;
+    QAudioFormat format;
+    format.setSampleRate(SAMPLE_RATE);
+    format.setChannelCount(CHANNELS);
+    format.setSampleFormat(QAudioFormat::Float);
+    if (!device.isFormatSupported(format)) {
+        format.setSampleRate(device.preferredFormat().sampleRate());
+    }
+    if (!device.isFormatSupported(format)) {
+        fail("setPlayout", QString("%1 cannot play stereo float audio").arg(device.description()));
+        return;
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_resampler.setRates(SAMPLE_RATE, format.sampleRate());
+    }
+    const qint64 bufferBytes = format.bytesForDuration(PLAYOUT_BUFFER_MS * 1000);
+    m_playoutDevice = new PlayoutDevice(this, bufferBytes, m_context);
+    m_playoutDevice->open(QIODevice::ReadOnly);
+    m_sink = new QAudioSink(device, format, m_context);
+    m_sink->setBufferSize(bufferBytes);
+    m_sink->start(m_playoutDevice);
+    qDebug() << "ContributionLink: playing to" << device.description() << format.sampleRate()
+             << "Hz";
+}
+
+void ContributionLink::stopPlayout()
+{
+    if (m_sink) {
+        m_sink->stop();
+        delete m_sink;
+        m_sink = nullptr;
+    }
+    delete m_playoutDevice;
+    m_playoutDevice = nullptr;
+    QMutexLocker locker(&m_mutex);
+    m_resampler.setRates(SAMPLE_RATE, SAMPLE_RATE);
+}
+
+bool ContributionLink::decodeNext()
+{
+    const JitterBuffer::Frame frame = m_jitter.pop();
+    if (frame.kind == JitterBuffer::Frame::Empty) {
+        return false;
+    }
+
+    Packet packet;
+    if (frame.kind == JitterBuffer::Frame::Packet && decodePacket(frame.payload, packet)) {
+        decode(packet.primary, false);
+    } else if (!frame.payload.isEmpty() && decodePacket(frame.payload, packet)) {
+        // The next frame came: it carries the lost one, or at least its FEC
+        if (packet.redundant) {
+            decode(packet.previous, false);
+            ++m_recovered;
+        } else {
+            decode(packet.primary, true);
+            ++m_fecRecovered;
+        }
+    } else {
+        decode(QByteArray(), false);
+        ++m_concealed;
+    }
+
+    m_resampler.push(m_decoded.data(), FRAME_SAMPLES);
+    m_resampler.update(m_jitter.depth(), m_jitter.targetDepth());
+    return true;
+}
+
+void ContributionLink::decode(const QByteArray& frame, bool fec)
+{
+    int samples = -1;
+#ifdef XFB_HAVE_OPUS
+    if (m_decoder) {
+        // A null frame asks Opus to conceal the loss
+        const auto* data = reinterpret_cast<const unsigned char*>(frame.constData());
+        if (frame.isEmpty()) {
+            data = nullptr;
+        }
+        samples = opus_decode_float(m_decoder, data, frame.size(), m_decoded.data(), FRAME_SAMPLES,
+                                    fec ? 1 : 0);
+    }
+#else
+    Q_UNUSED(frame)
+    Q_UNUSED(fec)
+#endif
+    if (samples < FRAME_SAMPLES) {
+        const int from = qMax(0, samples) * CHANNELS;
+        std::fill(m_decoded.begin() + from, m_decoded.end(), 0.0f);
+    }
+}
+
+void ContributionLink::resetReceiver()
+{
+    m_jitter.reset();
+    m_resampler.reset();
+#ifdef XFB_HAVE_OPUS
+    if (m_decoder) {
+        opus_decoder_ctl(m_decoder, OPUS_RESET_STATE);
+    }
+#endif
+}
+
+void ContributionLink::fail(const QString& operation, const QString& error)
+{
+    qWarning() << QString("ContributionLink::%1 - %2").arg(operation, error);
+    emit operationError(operation, error);
+}
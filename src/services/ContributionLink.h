@@ -0,0 +1,226 @@
+#ifndef CONTRIBUTIONLINK_H
+#define CONTRIBUTIONLINK_H
+
+#include "DriftResampler.h"
+#include "JitterBuffer.h"
+#include <QAudioDevice>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHostAddress>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QThread>
+#include <atomic>
+#include <functional>
+#include <vector>
+
+class QAudioSink;
+class QIODevice;
+class QTimer;
+class QUdpSocket;
+struct OpusDecoder;
+struct OpusEncoder;
+
+/**
+ * @brief Sends live audio from one XFB to another over UDP, with Opus
+ *
+ * A TakeOver used to play the client's Icecast stream on the server, with
+ * the seconds of buffering of an mp3 stream over HTTP in between; a remote
+ * show could not talk to the studio. ContributionLink carries the audio
+ * itself, in 20 ms Opus frames, one per UDP datagram, and plays it out
+ * with under 200 ms from microphone to air on a fair network.
+ *
+ * The sender encodes what a PcmReader returns, at its own rate, with
+ * Opus' inband FEC on. Each datagram also carries the frame before it,
+ * so a single lost packet costs nothing; the receiver tries that copy
+ * first, then the FEC of the next frame, and only then conceals the gap.
+ *
+ * The receiver keeps the packets in a JitterBuffer, which sets how deep
+ * it has to run, and the decoded audio goes through a DriftResampler that
+ * plays it a fraction faster or slower so the buffer stays at that depth:
+ * the sender's sound card clock and the receiver's never agree, and would
+ * otherwise empty or overflow the buffer in a few minutes. With
+ * setPlayout() on the audio plays to the output device; read() returns it
+ * otherwise.
+ *
+ * A datagram is a HEADER_BYTES header: "XC", a flags byte, a reserved
+ * byte, the sequence number, the stream id and the length of the primary
+ * frame, all big endian, followed by the primary frame and the redundant
+ * one. A new stream id, as after the sender restarts, resets the receiver.
+ *
+ * Like LiveCapture it works on a thread of its own, so a busy window does
+ * not delay packets; the public calls queue work on it. Opus comes from
+ * libopus and is optional at build time: without it isAvailable() is
+ * false and sending or listening fails with operationError().
+ *
+ * @example
+ * @code
+ * // Client
+ * link->send(serverAddress, ContributionLink::DEFAULT_PORT, capture->reader(id), 48000);
+ * // Server
+ * link->listen(ContributionLink::DEFAULT_PORT);
+ * link->setPlayout(true);
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class ContributionLink : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int DEFAULT_PORT = 8890;
+    static constexpr int SAMPLE_RATE = 48000;
+    static constexpr int CHANNELS = 2;
+    static constexpr int FRAME_MS = 20;
+    static constexpr int FRAME_SAMPLES = SAMPLE_RATE * FRAME_MS / 1000;   ///< Per channel
+    static constexpr int DEFAULT_BITRATE_KBPS = 128;
+    /// Loss the encoder plans its FEC for
+    static constexpr int EXPECTED_LOSS_PERCENT = 10;
+    static constexpr int HEADER_BYTES = 10;
+    static constexpr int MAX_FRAME_BYTES = 1275;   ///< Largest Opus frame
+    /// How often the sender reads its source
+    static constexpr int SEND_INTERVAL_MS = 5;
+    /// Without a packet for this long the link is no longer receiving
+    static constexpr int RECEIVE_TIMEOUT_MS = 1000;
+    static constexpr int PLAYOUT_BUFFER_MS = 40;
+
+    /// Returns up to the given number of interleaved stereo float samples, 0 if none is ready
+    using PcmReader = std::function<int(float*, int)>;
+
+    struct Packet {
+        bool redundant = false;   ///< A copy of the frame before follows the primary one
+        quint16 sequence = 0;
+        quint16 streamId = 0;
+        QByteArray primary;
+        QByteArray previous;
+    };
+
+    struct Statistics {
+        JitterBuffer::Statistics network;
+        qint64 recovered = 0;     ///< Lost frames played from the redundant copy
+        qint64 fecRecovered = 0;  ///< Lost frames decoded from the next frame's FEC
+        qint64 concealed = 0;     ///< Lost frames Opus had to make up
+        int depthMs = 0;
+        int targetMs = 0;
+        double jitterMs = 0;
+        double drift = 0;         ///< How much faster than it came the audio is played
+    };
+
+    /**
+     * @brief Whether XFB was built with Opus
+     */
+    static bool isAvailable();
+
+    explicit ContributionLink(QObject* parent = nullptr);
+    ~ContributionLink() override;
+
+    void setBitrateKbps(int kbps);
+    void setOutputDevice(const QAudioDevice& device);
+
+    /**
+     * @brief Stream a source to a receiver, instead of whatever the link did
+     * @param reader Source of interleaved stereo samples, called on the link thread
+     * @param sampleRate Rate of the source, converted to SAMPLE_RATE if need be
+     */
+    void send(const QHostAddress& host, quint16 port, PcmReader reader, int sampleRate);
+
+    /**
+     * @brief Receive on a port, instead of whatever the link did
+     */
+    void listen(quint16 port);
+
+    /**
+     * @brief Play what arrives to the output device, or leave it to read()
+     */
+    void setPlayout(bool playout);
+
+    /**
+     * @brief Stop sending or receiving
+     */
+    void stop();
+
+    /**
+     * @brief Decoded audio, in real time; silence while there is none
+     *
+     * May be called from any thread, and not while playout is on.
+     * @return samples, always filled
+     */
+    int read(float* data, int samples);
+
+    /// Port listen() bound, the one picked by the system for 0; 0 when not listening
+    quint16 localPort() const { return m_localPort; }
+    /// A packet came in the last RECEIVE_TIMEOUT_MS
+    bool isReceiving() const { return m_receiving; }
+    qint64 packetsSent() const { return m_packetsSent; }
+    Statistics statistics() const;
+
+    /**
+     * @brief The datagram of a packet
+     */
+    static QByteArray encodePacket(const Packet& packet);
+
+    /**
+     * @brief Read a datagram
+     * @return false if it is not one of ours
+     */
+    static bool decodePacket(const QByteArray& datagram, Packet& packet);
+
+signals:
+    void receivingChanged(bool receiving);
+    void operationError(const QString& operation, const QString& error);
+
+private:
+    void stopOnThread();
+    void sendPending();
+    void receivePending();
+    void checkReceiving();
+    void startPlayout();
+    void stopPlayout();
+    bool decodeNext();
+    void decode(const QByteArray& frame, bool fec);
+    void resetReceiver();
+    void fail(const QString& operation, const QString& error);
+
+    QThread m_thread;
+    QObject* m_context;          ///< Lives on m_thread and parents what runs there
+    QUdpSocket* m_socket = nullptr;
+    QTimer* m_timer = nullptr;   ///< Sends, or checks for a silent sender
+    QElapsedTimer m_clock;       ///< Arrival times of the packets
+    QAudioSink* m_sink = nullptr;
+    QIODevice* m_playoutDevice = nullptr;
+    QAudioDevice m_outputDevice;
+    int m_bitrateKbps = DEFAULT_BITRATE_KBPS;
+    bool m_playout = false;
+
+    // Sender
+    PcmReader m_reader;
+    QHostAddress m_host;
+    quint16 m_port = 0;
+    int m_sourceRate = SAMPLE_RATE;
+    OpusEncoder* m_encoder = nullptr;
+    DriftResampler m_converter{CHANNELS};   ///< From the source rate to SAMPLE_RATE
+    std::vector<float> m_pending;            ///< Samples at SAMPLE_RATE not yet encoded
+    QByteArray m_previous;       ///< Frame sent last, repeated in the next packet
+    quint16 m_sequence = 0;
+    quint16 m_streamId = 0;
+    std::atomic<qint64> m_packetsSent{0};
+
+    // Receiver, guarded by m_mutex as read() may come from any thread
+    mutable QMutex m_mutex;
+    OpusDecoder* m_decoder = nullptr;
+    JitterBuffer m_jitter{FRAME_MS};
+    DriftResampler m_resampler{CHANNELS};
+    std::vector<float> m_decoded;   ///< The frame decode() wrote
+    bool m_haveStream = false;
+    quint16 m_receivedStreamId = 0;
+    qint64 m_recovered = 0;
+    qint64 m_fecRecovered = 0;
+    qint64 m_concealed = 0;
+    std::atomic<qint64> m_lastPacketMs{-1};
+    std::atomic<bool> m_receiving{false};
+    std::atomic<quint16> m_localPort{0};
+};
+
+#endif // CONTRIBUTIONLINK_H
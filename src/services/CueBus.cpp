@@ -0,0 +1,195 @@
+#include "CueBus.h"
+#include "AudioDeck.h"
+#include "DeckMixer.h"
+#include <QAudioDevice>
+#include <QDebug>
+#include <QtMultimedia/QAudioSink>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+CueBus::CueBus(TrackPrefetcher* prefetcher, QObject* parent)
+    : QIODevice(parent)
+    , m_prefetcher(prefetcher)
+{
+}
+
+CueBus::~CueBus()
+{
+    if (m_sink) {
+        closeOutput();
+    }
+}
+
+qint64 CueBus::bytesAvailable() const
+{
+    // Silence is played once the track is over, until the finish is handled
+    return QIODevice::bytesAvailable() + m_format.bytesForDuration(BUFFER_MS * 1000);
+}
+
+void CueBus::setOutputDevice(const QString& name)
+{
+    if (name == m_deviceName) {
+        return;
+    }
+    m_deviceName = name;
+    if (!m_sink) {
+        return;
+    }
+
+    // Reopen on the new device and carry on where the track was
+    const QString source = m_source;
+    const qint64 positionMs = m_deck ? m_deck->positionFrames() * 1000 / m_deck->sampleRate() : 0;
+    const bool resume = !source.isEmpty() && !m_ending;
+    closeOutput();
+    if (resume) {
+        play(source, positionMs);
+    } else {
+        emit finished();
+    }
+}
+
+void CueBus::play(const QString& filePath, qint64 startMs)
+{
+    if (!m_sink && !openOutput()) {
+        return;
+    }
+
+    m_deck->load(filePath, startMs);
+    m_source = filePath;
+    m_ending = false;
+    m_framesSinceReport = 0;
+    m_positionMs.store(startMs, std::memory_order_relaxed);
+    m_durationMs.store(0, std::memory_order_relaxed);
+    m_playing.store(true, std::memory_order_relaxed);
+    if (m_sink->state() != QAudio::ActiveState) {
+        m_sink->start(this);
+    }
+    emit started(filePath);
+}
+
+void CueBus::stop()
+{
+    if (!m_sink) {
+        return;
+    }
+    closeOutput();
+    emit finished();
+}
+
+bool CueBus::openOutput()
+{
+    const QAudioDevice device = DeckMixer::findOutput(m_deviceName);
+    const int preferredRate = device.preferredFormat().sampleRate();
+
+    QAudioFormat format;
+    format.setSampleRate(preferredRate > 0 ? preferredRate : DeckMixer::DEFAULT_SAMPLE_RATE);
+    format.setChannelCount(AudioDeck::CHANNELS);
+    format.setSampleFormat(QAudioFormat::Float);
+    if (!device.isFormatSupported(format)) {
+        format.setSampleFormat(QAudioFormat::Int16);
+    }
+    if (!device.isFormatSupported(format)) {
+        emit errorOccurred(QString("%1 cannot play stereo at %2 Hz")
+                               .arg(device.description())
+                               .arg(format.sampleRate()));
+        return false;
+    }
+
+    if (m_deck && m_deck->sampleRate() != format.sampleRate()) {
+        delete m_deck;
+        m_deck = nullptr;
+    }
+    if (!m_deck) {
+        m_deck = new AudioDeck(format.sampleRate(), this);
+        m_deck->setPrefetcher(m_prefetcher, true);
+        connect(m_deck, &AudioDeck::errorOccurred, this,
+                [this](const QString& filePath, const QString& message) {
+                    emit errorOccurred(QString("%1: %2").arg(filePath, message));
+                });
+    }
+
+    m_format = format;
+    if (!isOpen()) {
+        open(QIODevice::ReadOnly);
+    }
+    m_sink = new QAudioSink(device, m_format, this);
+    m_sink->setBufferSize(m_format.bytesForDuration(BUFFER_MS * 1000));
+    qDebug() << "CueBus: output" << device.description() << m_format.sampleRate() << "Hz";
+    return true;
+}
+
+void CueBus::closeOutput()
+{
+    m_sink->stop();
+    delete m_sink;
+    m_sink = nullptr;
+    m_deck->unload();
+    m_source.clear();
+    m_ending = false;
+    m_playing.store(false, std::memory_order_relaxed);
+    m_positionMs.store(0, std::memory_order_relaxed);
+    m_durationMs.store(0, std::memory_order_relaxed);
+}
+
+qint64 CueBus::readData(char* data, qint64 maxSize)
+{
+    const int bytesPerFrame = m_format.bytesPerFrame();
+    const int frames = bytesPerFrame > 0 ? static_cast<int>(maxSize / bytesPerFrame) : 0;
+    if (frames <= 0 || !m_deck) {
+        return 0;
+    }
+
+    const int samples = frames * AudioDeck::CHANNELS;
+    if (m_buffer.size() < samples) {
+        m_buffer.resize(samples);
+    }
+    float* out = m_buffer.data();
+    const int read = m_deck->read(out, frames);
+    std::fill(out + read * AudioDeck::CHANNELS, out + samples, 0.0f);
+
+    if (!m_ending && !m_deck->isActive()) {
+        m_ending = true;
+        QMetaObject::invokeMethod(
+            this,
+            [this]() {
+                if (m_ending) {
+                    stop();
+                }
+            },
+            Qt::QueuedConnection);
+    }
+
+    const float gain = volume();
+    if (m_format.sampleFormat() == QAudioFormat::Float) {
+        float* dst = reinterpret_cast<float*>(data);
+        for (int i = 0; i < samples; ++i) {
+            dst[i] = out[i] * gain;
+        }
+    } else {
+        qint16* dst = reinterpret_cast<qint16*>(data);
+        for (int i = 0; i < samples; ++i) {
+            const float value = std::clamp(out[i] * gain, -1.0f, 1.0f);
+            dst[i] = static_cast<qint16>(std::lround(value * 32767.0f));
+        }
+    }
+
+    const int rate = m_deck->sampleRate();
+    const qint64 position = m_deck->positionFrames() * 1000 / rate;
+    m_positionMs.store(position, std::memory_order_relaxed);
+    m_durationMs.store(qMax<qint64>(0, m_deck->durationFrames()) * 1000 / rate,
+                       std::memory_order_relaxed);
+    m_framesSinceReport += frames;
+    if (m_framesSinceReport >= qint64(rate) * POSITION_REPORT_MS / 1000) {
+        m_framesSinceReport = 0;
+        emit positionChanged(position);
+    }
+    return qint64(frames) * bytesPerFrame;
+}
+
+qint64 CueBus::writeData(const char* data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
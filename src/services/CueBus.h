@@ -0,0 +1,113 @@
+#ifndef CUEBUS_H
+#define CUEBUS_H
+
+#include <QAudioFormat>
+#include <QIODevice>
+#include <QString>
+#include <QVector>
+#include <atomic>
+
+class AudioDeck;
+class QAudioSink;
+class TrackPrefetcher;
+
+/**
+ * @brief Pre-listen output: one deck played to a device of its own
+ *
+ * The program bus, DeckMixer, goes to air. The cue bus lets the presenter
+ * hear a track in the headphones, usually the next one, while the current
+ * one airs. It plays through a QAudioSink on the device chosen with
+ * setOutputDevice(), separately from the program output. Nothing on it
+ * reaches the taps, the stream or the air-check recording.
+ *
+ * The deck of the cue bus borrows the heads of prefetched files from the
+ * engine's TrackPrefetcher rather than taking them. Pre-listening the next
+ * item therefore decodes from the copy read ahead for air, and the deck
+ * that later airs the item still finds that copy, so the file is not read
+ * from disk twice.
+ *
+ * The sink and the deck are created on the first play() and closed again
+ * by stop(), so an unused cue output does not hold the device open.
+ *
+ * All slots must run on the bus's thread, the audio thread of
+ * PlaybackEngine, which marshals calls there. Position, duration and
+ * volume are exchanged through atomics.
+ *
+ * @since XFB 2.0
+ */
+class CueBus : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    explicit CueBus(TrackPrefetcher* prefetcher, QObject* parent = nullptr);
+    ~CueBus() override;
+
+    bool isSequential() const override { return true; }
+    qint64 bytesAvailable() const override;
+
+    qint64 positionMs() const { return m_positionMs.load(std::memory_order_relaxed); }
+    qint64 durationMs() const { return m_durationMs.load(std::memory_order_relaxed); }
+    bool isPlaying() const { return m_playing.load(std::memory_order_relaxed); }
+
+    void setVolume(float volume) { m_volume.store(volume, std::memory_order_relaxed); }
+    float volume() const { return m_volume.load(std::memory_order_relaxed); }
+
+public slots:
+    /**
+     * @brief Route the bus to a device; a track that is playing moves with it
+     * @param name Id or description of the device; empty for the default
+     */
+    void setOutputDevice(const QString& name);
+
+    /**
+     * @brief Play a file on the bus, replacing what was playing
+     * @param filePath Path of the audio file
+     * @param startMs Where to start, in milliseconds
+     */
+    void play(const QString& filePath, qint64 startMs = 0);
+
+    /**
+     * @brief Stop and close the output
+     */
+    void stop();
+
+signals:
+    void started(const QString& filePath);
+    void positionChanged(qint64 positionMs);
+
+    /**
+     * @brief Emitted when the track played to its end or was stopped
+     */
+    void finished();
+
+    void errorOccurred(const QString& message);
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override;
+    qint64 writeData(const char* data, qint64 maxSize) override;
+
+private:
+    bool openOutput();
+    void closeOutput();
+
+    static constexpr int BUFFER_MS = 100;
+    static constexpr int POSITION_REPORT_MS = 100;
+
+    TrackPrefetcher* m_prefetcher;
+    QString m_deviceName;
+    QAudioFormat m_format;
+    QAudioSink* m_sink = nullptr;
+    AudioDeck* m_deck = nullptr;
+    QString m_source;
+    bool m_ending = false;                    ///< End of the track seen, finish queued
+    QVector<float> m_buffer;
+    qint64 m_framesSinceReport = 0;
+
+    std::atomic<qint64> m_positionMs{0};
+    std::atomic<qint64> m_durationMs{0};
+    std::atomic<float> m_volume{1.0f};
+    std::atomic<bool> m_playing{false};
+};
+
+#endif // CUEBUS_H
@@ -0,0 +1,238 @@
+#include "CuePointStore.h"
+#include <QDebug>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QStringList>
+#include <QTimer>
+#include <QVariant>
+
+namespace {
+
+const char* const COLUMNS[] = {"cue_in_ms", "cue_out_ms", "intro_ms", "fade_ms", "segue_ms"};
+
+} // namespace
+
+CuePointStore::CuePointStore(QSqlDatabase& database, QObject* parent)
+    : QObject(parent)
+    , m_database(database)
+{
+}
+
+CuePointStore::~CuePointStore()
+{
+    flush();
+}
+
+bool CuePointStore::initialize()
+{
+    if (m_initialized) {
+        return true;
+    }
+
+    if (!m_database.isOpen()) {
+        logError("initialize", "Database is not open");
+        return false;
+    }
+
+    if (!ensureColumns()) {
+        return false;
+    }
+
+    loadCuePoints();
+    m_initialized = true;
+    return true;
+}
+
+CuePoints CuePointStore::cuePoints(const QString& filePath) const
+{
+    return m_cues.value(filePath);
+}
+
+void CuePointStore::setCuePoints(const QString& filePath, const CuePoints& cue)
+{
+    if (cuePoints(filePath) == cue) {
+        return;
+    }
+
+    if (cue.isSet()) {
+        m_cues.insert(filePath, cue);
+    } else {
+        m_cues.remove(filePath);
+    }
+    m_pending.insert(filePath, cue);
+    scheduleFlush();
+}
+
+void CuePointStore::setStoredCuePoints(const QString& filePath, const CuePoints& cue)
+{
+    m_pending.remove(filePath);
+    if (cue.isSet()) {
+        m_cues.insert(filePath, cue);
+    } else {
+        m_cues.remove(filePath);
+    }
+}
+
+QVariantMap CuePointStore::toColumns(const CuePoints& cue)
+{
+    // The same NULLs as flush() writes
+    return {{"cue_in_ms", cue.inMs > 0 ? QVariant(cue.inMs) : QVariant()},
+            {"cue_out_ms", cue.outMs >= 0 ? QVariant(cue.outMs) : QVariant()},
+            {"intro_ms", cue.introMs >= 0 ? QVariant(cue.introMs) : QVariant()},
+            {"fade_ms", cue.fadeMs >= 0 ? QVariant(cue.fadeMs) : QVariant()},
+            {"segue_ms", cue.segueMs >= 0 ? QVariant(cue.segueMs) : QVariant()}};
+}
+
+void CuePointStore::relocate(const QString& from, const QString& to)
+{
+    auto it = m_cues.find(from);
+    if (it == m_cues.end() || from == to) {
+        return;
+    }
+
+    const CuePoints cue = it.value();
+    m_cues.erase(it);
+    m_cues.insert(to, cue);
+    if (m_pending.contains(from)) {
+        m_pending.insert(to, m_pending.take(from));
+    }
+}
+
+bool CuePointStore::flush()
+{
+    m_flushScheduled = false;
+
+    if (!m_initialized || m_pending.isEmpty()) {
+        return true;
+    }
+
+    if (!m_database.isOpen()) {
+        logError("flush", "Database is not open");
+        return false;
+    }
+
+    if (!m_database.transaction()) {
+        logError("flush", QString("Failed to start transaction: %1").arg(m_database.lastError().text()));
+        return false;
+    }
+
+    QSqlQuery update(m_database);
+    update.prepare("UPDATE musics SET cue_in_ms = ?, cue_out_ms = ?, intro_ms = ?, fade_ms = ?, "
+                   "segue_ms = ? WHERE path = ?");
+
+    for (auto it = m_pending.constBegin(); it != m_pending.constEnd(); ++it) {
+        // NULL rather than the defaults, so untrimmed tracks read as such
+        update.addBindValue(it->inMs > 0 ? QVariant(it->inMs) : QVariant());
+        update.addBindValue(it->outMs >= 0 ? QVariant(it->outMs) : QVariant());
+        update.addBindValue(it->introMs >= 0 ? QVariant(it->introMs) : QVariant());
+        update.addBindValue(it->fadeMs >= 0 ? QVariant(it->fadeMs) : QVariant());
+        update.addBindValue(it->segueMs >= 0 ? QVariant(it->segueMs) : QVariant());
+        update.addBindValue(it.key());
+        if (!update.exec()) {
+            QString error = QString("SQL Error: %1").arg(update.lastError().text());
+            logError("flush", error, update.lastQuery());
+            m_database.rollback();
+            emit operationError("flush", error);
+            return false;
+        }
+    }
+
+    if (!m_database.commit()) {
+        QString error = QString("Failed to commit: %1").arg(m_database.lastError().text());
+        logError("flush", error);
+        m_database.rollback();
+        emit operationError("flush", error);
+        return false;
+    }
+
+    m_pending.clear();
+    return true;
+}
+
+bool CuePointStore::ensureColumns()
+{
+    QSqlQuery info(m_database);
+    if (!info.exec("PRAGMA table_info(musics)")) {
+        QString error = QString("SQL Error: %1").arg(info.lastError().text());
+        logError("ensureColumns", error, info.lastQuery());
+        emit operationError("ensureColumns", error);
+        return false;
+    }
+
+    QStringList columns;
+    while (info.next()) {
+        columns << info.value(1).toString();
+    }
+    if (columns.isEmpty()) {
+        logError("ensureColumns", "The musics table does not exist");
+        emit operationError("ensureColumns", "The musics table does not exist");
+        return false;
+    }
+
+    for (const char* name : COLUMNS) {
+        const QString column = QString::fromLatin1(name);
+        if (columns.contains(column)) {
+            continue;
+        }
+
+        QSqlQuery query(m_database);
+        const QString sql = QString("ALTER TABLE musics ADD COLUMN %1 INTEGER").arg(column);
+        if (!query.exec(sql)) {
+            QString error = QString("SQL Error: %1").arg(query.lastError().text());
+            logError("ensureColumns", error, sql);
+            emit operationError("ensureColumns", error);
+            return false;
+        }
+        qInfo() << "CuePointStore: added" << column << "to the musics table";
+    }
+
+    return true;
+}
+
+void CuePointStore::loadCuePoints()
+{
+    QSqlQuery query(m_database);
+    query.setForwardOnly(true);
+
+    if (!query.exec("SELECT path, cue_in_ms, cue_out_ms, intro_ms, fade_ms, segue_ms FROM musics "
+                    "WHERE cue_in_ms IS NOT NULL OR cue_out_ms IS NOT NULL "
+                    "OR intro_ms IS NOT NULL OR fade_ms IS NOT NULL OR segue_ms IS NOT NULL")) {
+        logError("loadCuePoints", QString("SQL Error: %1").arg(query.lastError().text()),
+                 query.lastQuery());
+        return;
+    }
+
+    while (query.next()) {
+        CuePoints cue;
+        cue.inMs = query.value(1).isNull() ? 0 : query.value(1).toLongLong();
+        cue.outMs = query.value(2).isNull() ? -1 : query.value(2).toLongLong();
+        cue.introMs = query.value(3).isNull() ? -1 : query.value(3).toLongLong();
+        cue.fadeMs = query.value(4).isNull() ? -1 : query.value(4).toLongLong();
+        cue.segueMs = query.value(5).isNull() ? -1 : query.value(5).toLongLong();
+        if (cue.isSet()) {
+            m_cues.insert(query.value(0).toString(), cue);
+        }
+    }
+
+    qDebug() << "CuePointStore: loaded cue points of" << m_cues.size() << "tracks";
+}
+
+void CuePointStore::scheduleFlush()
+{
+    if (m_flushScheduled || !m_initialized) {
+        return;
+    }
+
+    m_flushScheduled = true;
+    QTimer::singleShot(0, this, [this]() { flush(); });
+}
+
+void CuePointStore::logError(const QString& operation, const QString& error, const QString& query)
+{
+    QString logMessage = QString("CuePointStore::%1 - %2").arg(operation, error);
+    if (!query.isEmpty()) {
+        logMessage += QString(" (Query: %1)").arg(query);
+    }
+
+    qWarning() << logMessage;
+}
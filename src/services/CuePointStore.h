@@ -0,0 +1,123 @@
+#ifndef CUEPOINTSTORE_H
+#define CUEPOINTSTORE_H
+
+#include "CuePoints.h"
+#include <QHash>
+#include <QObject>
+#include <QSqlDatabase>
+#include <QString>
+#include <QVariantMap>
+
+/**
+ * @brief Cue points of the library tracks, kept in the musics table
+ *
+ * The cue points are stored in the cue_in_ms, cue_out_ms, intro_ms, fade_ms
+ * and segue_ms columns of the musics table, which initialize() adds to
+ * databases created before they existed. A track whose columns are NULL
+ * plays in full and is mixed at the crossfade length. Since the columns
+ * belong to the track's row, they follow it when its path changes;
+ * relocate() does the same for the copy held in memory.
+ *
+ * All cue points are loaded into memory, so cuePoints() is a hash lookup
+ * and can be used by PlaybackEngine every time an item is played or
+ * queued. New cue points are written back in a single transaction when
+ * flush() is called, or automatically on the next event loop iteration.
+ *
+ * CuePointStore is not thread-safe; it is used from the GUI thread.
+ *
+ * @example
+ * @code
+ * CuePointStore* store = new CuePointStore(db, this);
+ * store->initialize();
+ * engine->setCueProvider([store](const QString& path) { return store->cuePoints(path); });
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class CuePointStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit CuePointStore(QSqlDatabase& database, QObject* parent = nullptr);
+    ~CuePointStore() override;
+
+    /**
+     * @brief Add the cue columns to the musics table if needed and load the cue points
+     * @return true if the columns are available
+     */
+    bool initialize();
+
+    /**
+     * @brief Get the cue points of a track
+     * @param filePath Path as stored in the musics table
+     * @return Cue points; the default for tracks that have none
+     */
+    CuePoints cuePoints(const QString& filePath) const;
+
+    /**
+     * @brief Set the cue points of a track
+     * @param filePath Path as stored in the musics table
+     * @param cue Cue points; the default clears them
+     */
+    void setCuePoints(const QString& filePath, const CuePoints& cue);
+
+    /**
+     * @brief Take cue points that another writer stored in the track's row
+     *
+     * Only the copy in memory changes, and a write still pending for the
+     * track is dropped. AnalysisPipeline writes toColumns() itself, in one
+     * UPDATE with the results of its other analyzers.
+     * @param filePath Path as stored in the musics table
+     * @param cue Cue points; the default clears them
+     */
+    void setStoredCuePoints(const QString& filePath, const CuePoints& cue);
+
+    /**
+     * @brief Get the musics columns that hold cue points, NULL where unset
+     */
+    static QVariantMap toColumns(const CuePoints& cue);
+
+    /**
+     * @brief Move the cue points held in memory to a track's new path
+     *
+     * Only needed after the path of a musics row was changed directly in
+     * the database; the stored columns moved with it.
+     * @param from Old path
+     * @param to New path
+     */
+    void relocate(const QString& from, const QString& to);
+
+    /**
+     * @brief Get the number of tracks with cue points
+     */
+    int count() const { return m_cues.size(); }
+
+    /**
+     * @brief Write pending cue points to the database
+     * @return true on success
+     */
+    bool flush();
+
+signals:
+    /**
+     * @brief Emitted when a database operation fails
+     * @param operation Name of the operation
+     * @param error Error message
+     */
+    void operationError(const QString& operation, const QString& error);
+
+private:
+    bool ensureColumns();
+    void loadCuePoints();
+    void scheduleFlush();
+    void logError(const QString& operation, const QString& error, const QString& query = QString());
+
+    QSqlDatabase& m_database;
+    QHash<QString, CuePoints> m_cues;
+    QHash<QString, CuePoints> m_pending;
+    bool m_initialized = false;
+    bool m_flushScheduled = false;
+};
+
+#endif // CUEPOINTSTORE_H
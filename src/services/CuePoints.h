@@ -0,0 +1,34 @@
+#ifndef CUEPOINTS_H
+#define CUEPOINTS_H
+
+#include <QtGlobal>
+
+/**
+ * @brief Where the audio of a track starts and ends, and where it can be mixed
+ *
+ * Found by SilenceDetector and SegueDetector, kept by CuePointStore and
+ * honoured by PlaybackEngine, which starts a track at inMs and treats it as
+ * ending at outMs. When crossfading, the crossfade into the next track
+ * starts at segueMs if it is set. The default value plays the whole file.
+ *
+ * @since XFB 2.0
+ */
+struct CuePoints {
+    qint64 inMs = 0;      ///< First audible position, in milliseconds
+    qint64 outMs = -1;    ///< End of the audio, in milliseconds; -1 for the end of the file
+    qint64 introMs = -1;  ///< End of the intro, in milliseconds; -1 if not known
+    qint64 fadeMs = -1;   ///< Start of the fade-out, in milliseconds; -1 if not known
+    qint64 segueMs = -1;  ///< Suggested mix-out point, in milliseconds; -1 if not known
+
+    bool isSet() const { return inMs > 0 || outMs >= 0 || hasSegue(); }
+    bool hasSegue() const { return introMs >= 0 || fadeMs >= 0 || segueMs >= 0; }
+
+    bool operator==(const CuePoints& other) const
+    {
+        return inMs == other.inMs && outMs == other.outMs && introMs == other.introMs
+            && fadeMs == other.fadeMs && segueMs == other.segueMs;
+    }
+    bool operator!=(const CuePoints& other) const { return !(*this == other); }
+};
+
+#endif // CUEPOINTS_H
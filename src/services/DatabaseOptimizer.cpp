@@ -5,6 +5,7 @@
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QRegularExpression>
+#include <QSet>
 #include <QDebug>
 #include <algorithm>
 
@@ -29,6 +30,7 @@ DatabaseOptimizer::DatabaseOptimizer(QSqlDatabase& database, QObject* parent)
 
 DatabaseOptimizer::~DatabaseOptimizer()
 {
+    QueryTimer::clearSink(this);
     shutdown();
 }
 
@@ -70,6 +72,11 @@ void DatabaseOptimizer::shutdown()
 
 bool DatabaseOptimizer::createOptimalIndexes()
 {
+    if (!m_database.isOpen()) {
+        ErrorHandler::logMessage(ErrorHandler::ErrorSeverity::Error, "DatabaseOptimizer", "Database is not open");
+        return false;
+    }
+    
     ErrorHandler::logMessage(ErrorHandler::ErrorSeverity::Info, "DatabaseOptimizer", "Creating optimal indexes");
     QElapsedTimer timer;
     timer.start();
@@ -77,48 +84,72 @@ bool DatabaseOptimizer::createOptimalIndexes()
     bool success = true;
     int createdCount = 0;
     
-    // Define optimal indexes for XFB database schema
+    // Define optimal indexes for XFB database schema. Each definition lists
+    // the table names it applies to, in order of preference: the live
+    // application schema uses plural names (musics, genres1, programs),
+    // older and test schemas the singular ones.
     struct IndexDefinition {
         QString name;
-        QString table;
+        QStringList tables;
         QStringList columns;
         bool unique;
         QString whereClause;
     };
     
+    const QStringList musicTables = {"musics", "music"};
+    
     QList<IndexDefinition> indexes = {
         // Music table indexes
-        {"idx_music_artist", "music", {"artist"}, false, ""},
-        {"idx_music_song", "music", {"song"}, false, ""},
-        {"idx_music_genre1", "music", {"genre1"}, false, "genre1 IS NOT NULL AND genre1 != ''"},
-        {"idx_music_genre2", "music", {"genre2"}, false, "genre2 IS NOT NULL AND genre2 != ''"},
-        {"idx_music_country", "music", {"country"}, false, "country IS NOT NULL AND country != ''"},
-        {"idx_music_path", "music", {"path"}, true, ""}, // Unique index for file paths
-        {"idx_music_played_times", "music", {"played_times"}, false, ""},
-        {"idx_music_last_played", "music", {"last_played"}, false, "last_played IS NOT NULL"},
-        {"idx_music_artist_song", "music", {"artist", "song"}, false, ""},
-        {"idx_music_genre1_artist", "music", {"genre1", "artist"}, false, "genre1 IS NOT NULL"},
+        {"idx_music_artist", musicTables, {"artist"}, false, ""},
+        {"idx_music_song", musicTables, {"song"}, false, ""},
+        {"idx_music_genre1", musicTables, {"genre1"}, false, "genre1 IS NOT NULL AND genre1 != ''"},
+        {"idx_music_genre2", musicTables, {"genre2"}, false, "genre2 IS NOT NULL AND genre2 != ''"},
+        {"idx_music_country", musicTables, {"country"}, false, "country IS NOT NULL AND country != ''"},
+        {"idx_music_path", musicTables, {"path"}, true, ""}, // Unique index for file paths
+        {"idx_music_played_times", musicTables, {"played_times"}, false, ""},
+        {"idx_music_last_played", musicTables, {"last_played"}, false, "last_played IS NOT NULL"},
+        {"idx_music_artist_song", musicTables, {"artist", "song"}, false, ""},
+        {"idx_music_genre1_artist", musicTables, {"genre1", "artist"}, false, "genre1 IS NOT NULL"},
         
         // Composite indexes for common queries
-        {"idx_music_search", "music", {"artist", "song", "genre1"}, false, ""},
-        {"idx_music_popular", "music", {"played_times", "last_played"}, false, "played_times > 0"},
+        {"idx_music_search", musicTables, {"artist", "song", "genre1"}, false, ""},
+        {"idx_music_popular", musicTables, {"played_times", "last_played"}, false, "played_times > 0"},
         
         // Playlist table indexes (if exists)
-        {"idx_playlist_name", "playlist", {"name"}, false, ""},
-        {"idx_playlist_created", "playlist", {"created_date"}, false, ""},
+        {"idx_playlist_name", {"playlist"}, {"name"}, false, ""},
+        {"idx_playlist_created", {"playlist"}, {"created_date"}, false, ""},
         
         // Genre table indexes (if exists)
-        {"idx_genre_name", "genre", {"name"}, true, ""},
+        {"idx_genre_name", {"genres1", "genre"}, {"name"}, true, ""},
+        {"idx_genre2_name", {"genres2"}, {"name"}, true, ""},
         
         // Program table indexes (if exists)
-        {"idx_program_name", "program", {"name"}, false, ""},
-        {"idx_program_date", "program", {"date"}, false, ""},
+        {"idx_program_name", {"programs", "program"}, {"name"}, false, ""},
+        {"idx_program_date", {"programs", "program"}, {"date"}, false, ""},
     };
     
+    const QStringList tables = getTableNames();
+    
     for (const auto& indexDef : indexes) {
-        // Check if table exists
-        QStringList tables = getTableNames();
-        if (!tables.contains(indexDef.table, Qt::CaseInsensitive)) {
+        // Resolve the table against the live schema
+        QString table;
+        for (const QString& candidate : indexDef.tables) {
+            if (tables.contains(candidate, Qt::CaseInsensitive)) {
+                table = candidate;
+                break;
+            }
+        }
+        if (table.isEmpty()) {
+            continue;
+        }
+        
+        // Skip definitions whose columns this schema does not have
+        const QStringList tableColumns = getColumnNames(table);
+        bool hasColumns = std::all_of(indexDef.columns.begin(), indexDef.columns.end(),
+                                      [&tableColumns](const QString& column) {
+                                          return tableColumns.contains(column, Qt::CaseInsensitive);
+                                      });
+        if (!hasColumns) {
             continue;
         }
         
@@ -128,8 +159,22 @@ bool DatabaseOptimizer::createOptimalIndexes()
             continue;
         }
         
+        // An index created elsewhere on the same columns makes this one redundant
+        if (hasIndexOn(table, indexDef.columns, false)) {
+            ErrorHandler::logMessage(ErrorHandler::ErrorSeverity::Info, "DatabaseOptimizer", QString("Columns of %1 are already indexed").arg(indexDef.name));
+            continue;
+        }
+        
+        // Libraries built before paths were unique may hold duplicates; a
+        // plain index still serves the lookups
+        bool unique = indexDef.unique;
+        if (unique && hasDuplicateValues(table, indexDef.columns)) {
+            ErrorHandler::logMessage(ErrorHandler::ErrorSeverity::Warning, "DatabaseOptimizer", QString("Creating %1 without UNIQUE, %2 has duplicate values").arg(indexDef.name, table));
+            unique = false;
+        }
+        
         // Create the index
-        if (createIndex(indexDef.name, indexDef.table, indexDef.columns, indexDef.unique, indexDef.whereClause)) {
+        if (createIndex(indexDef.name, table, indexDef.columns, unique, indexDef.whereClause)) {
             createdCount++;
             ErrorHandler::logMessage(ErrorHandler::ErrorSeverity::Info, "DatabaseOptimizer", QString("Created index: %1").arg(indexDef.name));
         } else {
@@ -138,6 +183,12 @@ bool DatabaseOptimizer::createOptimalIndexes()
         }
     }
     
+    // Cached index information is stale now
+    {
+        QMutexLocker indexLocker(&m_indexMutex);
+        m_indexCacheUpdated = QDateTime();
+    }
+    
     qint64 duration = timer.elapsed();
     ErrorHandler::logMessage(ErrorHandler::ErrorSeverity::Info, "DatabaseOptimizer", QString("Created %1 indexes in %2ms").arg(createdCount).arg(duration));
     
@@ -227,6 +278,14 @@ bool DatabaseOptimizer::vacuumDatabase()
         QSqlQuery query(m_database);
         success = query.exec("VACUUM");
         if (success) {
+            // VACUUM may renumber the rowids of tables without an INTEGER
+            // PRIMARY KEY, and the music full-text index is keyed by rowid
+            if (getTableNames().contains("musics_fts")
+                && !query.exec("INSERT INTO musics_fts(musics_fts) VALUES ('rebuild')")) {
+                ErrorHandler::logMessage(ErrorHandler::ErrorSeverity::Warning, "DatabaseOptimizer",
+                                         QString("Failed to rebuild full-text index: %1").arg(query.lastError().text()));
+            }
+            
             // Update last vacuum time
             QMutexLocker locker(&m_metricsMutex);
             m_metrics.lastVacuum = QDateTime::currentDateTime();
@@ -287,10 +346,22 @@ void DatabaseOptimizer::recordQueryExecution(const QString& query, qint64 execut
     if (!m_monitoringEnabled) {
         return;
     }
+    if (MetricsRegistry::Histogram* histogram = m_queryTime.load(std::memory_order_acquire)) {
+        histogram->record(executionTime);
+    }
     
     QMutexLocker locker(&m_statsMutex);
+    m_lastQueryActivity.start();
     
-    QString pattern = normalizeQuery(query);
+    // Timed queries repeat the same prepared SQL, so normalize each text once
+    QString pattern = m_patternCache.value(query);
+    if (pattern.isEmpty()) {
+        if (m_patternCache.size() >= PATTERN_CACHE_LIMIT) {
+            m_patternCache.clear();
+        }
+        pattern = normalizeQuery(query);
+        m_patternCache.insert(query, pattern);
+    }
     
     if (m_queryStats.contains(pattern)) {
         QueryStats& stats = m_queryStats[pattern];
@@ -319,22 +390,49 @@ void DatabaseOptimizer::recordQueryExecution(const QString& query, qint64 execut
         m_queryStats[pattern] = stats;
     }
     
+    const bool isSlow = executionTime >= m_slowQueryThreshold;
+    
     // Update global metrics
     QMutexLocker metricsLocker(&m_metricsMutex);
     m_metrics.totalQueries++;
-    if (executionTime >= m_slowQueryThreshold) {
+    if (isSlow) {
         m_metrics.slowQueries++;
-        emit slowQueryDetected(query, executionTime);
     }
     
     // Update average query time
-    if (m_metrics.totalQueries > 0) {
-        static qint64 totalTime = 0;
-        totalTime += executionTime;
-        m_metrics.averageQueryTime = totalTime / m_metrics.totalQueries;
+    m_totalQueryTime += executionTime;
+    m_metrics.averageQueryTime = m_totalQueryTime / m_metrics.totalQueries;
+    
+    metricsLocker.unlock();
+    locker.unlock();
+    
+    // Emitted unlocked: a receiver may run queries that are timed again
+    if (isSlow) {
+        emit slowQueryDetected(query, executionTime);
     }
 }
 
+bool DatabaseOptimizer::isRecordingQueries() const
+{
+    return m_monitoringEnabled;
+}
+
+void DatabaseOptimizer::setAutomaticQueryTiming(bool enabled)
+{
+    if (enabled) {
+        QueryTimer::setSink(this);
+    } else {
+        QueryTimer::clearSink(this);
+    }
+    
+    ErrorHandler::logMessage(ErrorHandler::ErrorSeverity::Info, "DatabaseOptimizer", QString("Automatic query timing %1").arg(enabled ? "enabled" : "disabled"));
+}
+
+bool DatabaseOptimizer::isAutomaticQueryTimingEnabled() const
+{
+    return QueryTimer::sink() == this;
+}
+
 QList<DatabaseOptimizer::QueryStats> DatabaseOptimizer::getQueryStatistics(int limit)
 {
     QMutexLocker locker(&m_statsMutex);
@@ -470,6 +568,19 @@ QList<DatabaseOptimizer::OptimizationRecommendation> DatabaseOptimizer::getOptim
         recommendations.append(rec);
     }
     
+    // Indexes for hot queries whose plan scans a whole table
+    for (const auto& index : analyzeQueryPatterns()) {
+        OptimizationRecommendation rec;
+        rec.type = OptimizationRecommendation::CreateIndex;
+        rec.description = QString("Create index on %1(%2) for a query that scans the table")
+                         .arg(index.tableName, index.columns.join(", "));
+        rec.sqlCommand = QString("CREATE INDEX IF NOT EXISTS %1 ON %2 (%3)")
+                        .arg(index.name, index.tableName, index.columns.join(", "));
+        rec.priority = 7;
+        rec.estimatedImpact = index.size;
+        recommendations.append(rec);
+    }
+    
     // Analyze slow queries for index recommendations
     QList<QueryStats> slowQueries = getSlowQueries();
     for (const auto& queryStats : slowQueries) {
@@ -542,6 +653,9 @@ bool DatabaseOptimizer::applyRecommendation(const OptimizationRecommendation& re
                 if (!success) {
                     ErrorHandler::logMessage(ErrorHandler::ErrorSeverity::Error, "DatabaseOptimizer", QString("Failed to execute recommendation SQL: %1")
                                  .arg(query.lastError().text()));
+                } else if (recommendation.type != OptimizationRecommendation::QueryOptimization) {
+                    QMutexLocker indexLocker(&m_indexMutex);
+                    m_indexCacheUpdated = QDateTime();
                 }
             }
             break;
@@ -571,6 +685,16 @@ bool DatabaseOptimizer::isAutoOptimizationEnabled() const
     return m_autoOptimizationEnabled;
 }
 
+void DatabaseOptimizer::setWholeDatabaseMaintenance(bool enabled)
+{
+    m_wholeDatabaseMaintenance = enabled;
+}
+
+bool DatabaseOptimizer::isWholeDatabaseMaintenanceEnabled() const
+{
+    return m_wholeDatabaseMaintenance;
+}
+
 void DatabaseOptimizer::setOptimizationInterval(int intervalMs)
 {
     m_optimizationInterval = intervalMs;
@@ -588,6 +712,7 @@ void DatabaseOptimizer::clearQueryStatistics()
 {
     QMutexLocker locker(&m_statsMutex);
     m_queryStats.clear();
+    m_patternCache.clear();
     
     ErrorHandler::logMessage(ErrorHandler::ErrorSeverity::Info, "DatabaseOptimizer", "Query statistics cleared");
 }
@@ -670,6 +795,21 @@ void DatabaseOptimizer::performAutoOptimization()
         return;
     }
     
+    // Index builds and VACUUM hold the write lock; wait for a quiet moment
+    {
+        QMutexLocker locker(&m_statsMutex);
+        if (m_lastQueryActivity.isValid() && !m_lastQueryActivity.hasExpired(IDLE_THRESHOLD_MS)) {
+            if (!m_idleRetryPending) {
+                m_idleRetryPending = true;
+                QTimer::singleShot(IDLE_THRESHOLD_MS, this, [this]() {
+                    m_idleRetryPending = false;
+                    performAutoOptimization();
+                });
+            }
+            return;
+        }
+    }
+    
     ErrorHandler::logMessage(ErrorHandler::ErrorSeverity::Info, "DatabaseOptimizer", "Performing automatic optimization");
     
     // Get recommendations
@@ -677,6 +817,11 @@ void DatabaseOptimizer::performAutoOptimization()
     
     // Apply high-priority recommendations automatically
     for (const auto& rec : recommendations) {
+        const bool wholeDatabase = rec.type == OptimizationRecommendation::Vacuum
+                                   || rec.type == OptimizationRecommendation::UpdateStatistics;
+        if (wholeDatabase && !m_wholeDatabaseMaintenance) {
+            continue; // Done in slices by the maintenance scheduler
+        }
         if (rec.priority >= 7) { // High priority
             applyRecommendation(rec);
         }
@@ -822,28 +967,187 @@ QList<DatabaseOptimizer::IndexInfo> DatabaseOptimizer::analyzeQueryPatterns()
 {
     QList<IndexInfo> recommendations;
     
-    // This is a simplified implementation
-    // In a real-world scenario, you would analyze actual query patterns
-    // from the query statistics to recommend indexes
+    // Copy the candidates so the plans are computed without holding the lock
+    QList<QueryStats> candidates;
+    {
+        QMutexLocker locker(&m_statsMutex);
+        for (const auto& stats : std::as_const(m_queryStats)) {
+            if (stats.isSlowQuery || stats.executionCount >= HOT_QUERY_EXECUTIONS) {
+                candidates.append(stats);
+            }
+        }
+    }
     
-    QMutexLocker locker(&m_statsMutex);
+    const QStringList tables = getTableNames();
+    QSet<QString> recommended;
     
-    for (const auto& stats : m_queryStats.values()) {
-        if (stats.isSlowQuery && stats.executionCount > 10) {
-            // Analyze query pattern and suggest indexes
-            // This would require more sophisticated query parsing
+    for (const auto& stats : std::as_const(candidates)) {
+        const QString& pattern = stats.queryPattern;
+        if (!pattern.startsWith("SELECT") && !pattern.startsWith("UPDATE") && !pattern.startsWith("DELETE")) {
+            continue;
+        }
+        
+        for (const QString& scanned : scannedTables(pattern)) {
+            // Map the plan's table name back to its declared spelling
+            QString table;
+            for (const QString& candidate : tables) {
+                if (candidate.compare(scanned, Qt::CaseInsensitive) == 0) {
+                    table = candidate;
+                    break;
+                }
+            }
+            if (table.isEmpty()) {
+                continue;
+            }
             
-            IndexInfo recommendation;
-            recommendation.isRecommended = true;
-            // ... populate recommendation based on query analysis
+            QStringList columns = predicateColumns(pattern, getColumnNames(table));
+            if (columns.isEmpty() || hasIndexOn(table, columns, true)) {
+                continue;
+            }
             
-            recommendations.append(recommendation);
+            IndexInfo info;
+            info.name = QString("idx_auto_%1_%2").arg(table, columns.join("_")).toLower();
+            info.tableName = table;
+            info.columns = columns;
+            info.isRecommended = true;
+            // Estimated saving: half the time these queries spend
+            info.size = stats.totalExecutionTime / 2;
+            
+            if (!recommended.contains(info.name) && !indexExists(info.name)) {
+                recommended.insert(info.name);
+                recommendations.append(info);
+            }
         }
     }
     
     return recommendations;
 }
 
+QStringList DatabaseOptimizer::scannedTables(const QString& queryPattern)
+{
+    QStringList scanned;
+    
+    QSqlQuery query(m_database);
+    if (!query.exec("EXPLAIN QUERY PLAN " + queryPattern)) {
+        return scanned;
+    }
+    
+    // "SCAN musics" (or "SCAN TABLE musics" before SQLite 3.36) without
+    // "USING ... INDEX" is a full table scan
+    static const QRegularExpression scanRe(R"(^SCAN (?:TABLE )?(\w+))");
+    while (query.next()) {
+        QString detail = query.value("detail").toString();
+        QRegularExpressionMatch match = scanRe.match(detail);
+        if (match.hasMatch() && !detail.contains("USING")) {
+            scanned.append(match.captured(1));
+        }
+    }
+    
+    return scanned;
+}
+
+QStringList DatabaseOptimizer::predicateColumns(const QString& queryPattern, const QStringList& tableColumns)
+{
+    QStringList columns;
+    
+    int wherePos = queryPattern.indexOf(" WHERE ");
+    if (wherePos == -1) {
+        return columns;
+    }
+    
+    QString where = queryPattern.mid(wherePos + 7);
+    static const QRegularExpression tailRe(R"( (?:GROUP BY|ORDER BY|LIMIT) )");
+    int tailPos = where.indexOf(tailRe);
+    if (tailPos != -1) {
+        where.truncate(tailPos);
+    }
+    
+    // Equality and range comparisons can use an index; LIKE patterns
+    // usually start with a wildcard and cannot
+    static const QRegularExpression predicateRe(R"((?:\w+\.)?(\w+)\s*(=|<=|>=|<|>|\bIN\b|\bBETWEEN\b))");
+    QStringList rangeColumns;
+    QRegularExpressionMatchIterator it = predicateRe.globalMatch(where);
+    while (it.hasNext()) {
+        QRegularExpressionMatch match = it.next();
+        QString column = match.captured(1);
+        
+        auto found = std::find_if(tableColumns.begin(), tableColumns.end(), [&column](const QString& name) {
+            return name.compare(column, Qt::CaseInsensitive) == 0;
+        });
+        if (found == tableColumns.end()) {
+            continue;
+        }
+        
+        // Equality columns lead, a single range column may follow
+        QString op = match.captured(2);
+        if (op == "=" || op == "IN") {
+            if (!columns.contains(*found)) {
+                columns.append(*found);
+            }
+        } else if (!rangeColumns.contains(*found)) {
+            rangeColumns.append(*found);
+        }
+    }
+    
+    if (!rangeColumns.isEmpty() && !columns.contains(rangeColumns.first())) {
+        columns.append(rangeColumns.first());
+    }
+    
+    while (columns.size() > MAX_RECOMMENDED_INDEX_COLUMNS) {
+        columns.removeLast();
+    }
+    
+    return columns;
+}
+
+bool DatabaseOptimizer::hasIndexOn(const QString& tableName, const QStringList& columns, bool includeAutomatic)
+{
+    QSqlQuery listQuery(m_database);
+    if (!listQuery.exec(QString("PRAGMA index_list(%1)").arg(tableName))) {
+        return false;
+    }
+    
+    while (listQuery.next()) {
+        if (!includeAutomatic && listQuery.value("origin").toString() != "c") {
+            continue;
+        }
+        
+        QSqlQuery infoQuery(m_database);
+        if (!infoQuery.exec(QString("PRAGMA index_info(%1)").arg(listQuery.value("name").toString()))) {
+            continue;
+        }
+        
+        QStringList indexed;
+        while (infoQuery.next()) {
+            indexed.append(infoQuery.value("name").toString());
+        }
+        
+        // An index whose leading columns match serves the same lookups
+        if (indexed.size() >= columns.size()) {
+            bool covers = true;
+            for (int i = 0; i < columns.size(); ++i) {
+                if (indexed.at(i).compare(columns.at(i), Qt::CaseInsensitive) != 0) {
+                    covers = false;
+                    break;
+                }
+            }
+            if (covers) {
+                return true;
+            }
+        }
+    }
+    
+    return false;
+}
+
+bool DatabaseOptimizer::hasDuplicateValues(const QString& tableName, const QStringList& columns)
+{
+    QSqlQuery query(m_database);
+    QString sql = QString("SELECT 1 FROM %1 GROUP BY %2 HAVING COUNT(*) > 1 LIMIT 1")
+                  .arg(tableName, columns.join(", "));
+    return query.exec(sql) && query.next();
+}
+
 bool DatabaseOptimizer::isIndexUsed(const QString& indexName)
 {
     // Check if index appears in query plans
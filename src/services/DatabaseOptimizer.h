@@ -11,7 +11,10 @@
 #include <QMutex>
 #include <QElapsedTimer>
 #include <QHash>
+#include <atomic>
 #include <memory>
+#include "MetricsRegistry.h"
+#include "QueryTimer.h"
 
 /**
  * @brief Service for database performance optimization and monitoring
@@ -22,8 +25,10 @@
  * performance as the music collection grows.
  * 
  * Features:
- * - Automatic index creation and management
- * - Query performance monitoring and analysis
+ * - Automatic index creation and management against the live schema
+ * - Index advice from EXPLAIN QUERY PLAN on recorded hot queries
+ * - Query performance monitoring and analysis, fed automatically by
+ *   QueryTimer from DatabaseService and the repositories
  * - Database statistics collection
  * - Optimization recommendations
  * - Scheduled maintenance operations
@@ -39,6 +44,7 @@
  * 
  * // Monitor query performance
  * optimizer->startQueryMonitoring();
+ * optimizer->setAutomaticQueryTiming(true);
  * 
  * // Get performance recommendations
  * auto recommendations = optimizer->getOptimizationRecommendations();
@@ -46,7 +52,7 @@
  * 
  * @since XFB 2.0
  */
-class DatabaseOptimizer : public QObject
+class DatabaseOptimizer : public QObject, public QueryTimingSink
 {
     Q_OBJECT
 
@@ -136,6 +142,9 @@ public:
 
     /**
      * @brief Create optimal indexes for the current database schema
+     *
+     * Index definitions are matched to the tables and columns that exist,
+     * and skipped when another index already covers the same columns.
      * @return true if all indexes were created successfully
      */
     bool createOptimalIndexes();
@@ -180,7 +189,38 @@ public:
      * @param query SQL query string
      * @param executionTime Execution time in milliseconds
      */
-    void recordQueryExecution(const QString& query, qint64 executionTime);
+    void recordQueryExecution(const QString& query, qint64 executionTime) override;
+
+    /**
+     * @brief Check if query monitoring is running
+     * @return true between startQueryMonitoring() and stopQueryMonitoring()
+     */
+    bool isRecordingQueries() const override;
+
+    /**
+     * @brief Receive timings of every query run through DatabaseService and the repositories
+     *
+     * Installs this optimizer as the QueryTimer sink, replacing any other.
+     * Timings are only taken while query monitoring is running.
+     * @param enabled true to install, false to remove
+     */
+    void setAutomaticQueryTiming(bool enabled);
+
+    /**
+     * @brief Check if this optimizer is the installed QueryTimer sink
+     * @return true if automatic timing feeds this optimizer
+     */
+    bool isAutomaticQueryTimingEnabled() const;
+
+    /**
+     * @brief Also count every recorded execution time in a histogram
+     * @param histogram Histogram of query times in milliseconds, or null for none;
+     *                  it must outlive the optimizer or be unset
+     */
+    void setQueryTimeHistogram(MetricsRegistry::Histogram* histogram)
+    {
+        m_queryTime.store(histogram, std::memory_order_release);
+    }
 
     /**
      * @brief Get query performance statistics
@@ -203,6 +243,9 @@ public:
 
     /**
      * @brief Get optimization recommendations
+     *
+     * Includes CreateIndex recommendations for recorded slow or frequent
+     * queries whose query plan scans a whole table.
      * @return List of recommendations ordered by priority
      */
     QList<OptimizationRecommendation> getOptimizationRecommendations();
@@ -232,6 +275,21 @@ public:
      */
     bool isAutoOptimizationEnabled() const;
 
+    /**
+     * @brief Let automatic optimization run whole-database VACUUM and ANALYZE
+     *
+     * Turn this off when a MaintenanceScheduler does the same work in
+     * time-boxed slices; automatic optimization then only manages indexes.
+     * @param enabled true to apply Vacuum and UpdateStatistics recommendations (default)
+     */
+    void setWholeDatabaseMaintenance(bool enabled);
+
+    /**
+     * @brief Check if automatic optimization runs whole-database VACUUM and ANALYZE
+     * @return true if enabled
+     */
+    bool isWholeDatabaseMaintenanceEnabled() const;
+
     /**
      * @brief Set the interval for automatic optimization checks
      * @param intervalMs Interval in milliseconds
@@ -346,10 +404,45 @@ private:
 
     /**
      * @brief Analyze query patterns to recommend indexes
-     * @return List of recommended indexes
+     *
+     * Runs EXPLAIN QUERY PLAN on each slow or frequent normalized query and
+     * proposes an index on the compared columns of every fully scanned table.
+     * @return List of recommended indexes; size holds the estimated saving in ms
      */
     QList<IndexInfo> analyzeQueryPatterns();
 
+    /**
+     * @brief Get the tables a query reads with a full scan
+     * @param queryPattern Normalized query
+     * @return Table names as reported by the query plan
+     */
+    QStringList scannedTables(const QString& queryPattern);
+
+    /**
+     * @brief Get the indexable columns compared in a query's WHERE clause
+     * @param queryPattern Normalized query
+     * @param tableColumns Columns of the scanned table
+     * @return Equality columns first, then at most one range column
+     */
+    QStringList predicateColumns(const QString& queryPattern, const QStringList& tableColumns);
+
+    /**
+     * @brief Check if an index on a table starts with the given columns
+     * @param tableName Table name
+     * @param columns Leading columns
+     * @param includeAutomatic true to count indexes SQLite created for constraints
+     * @return true if such an index exists
+     */
+    bool hasIndexOn(const QString& tableName, const QStringList& columns, bool includeAutomatic);
+
+    /**
+     * @brief Check if rows share the same values for the given columns
+     * @param tableName Table name
+     * @param columns Columns to check
+     * @return true if a UNIQUE index on the columns would fail
+     */
+    bool hasDuplicateValues(const QString& tableName, const QStringList& columns);
+
     /**
      * @brief Check if index is being used
      * @param indexName Name of the index
@@ -390,7 +483,12 @@ private:
     mutable QMutex m_statsMutex;
     QHash<QString, QueryStats> m_queryStats;
     qint64 m_slowQueryThreshold;
-    bool m_monitoringEnabled;
+    std::atomic<bool> m_monitoringEnabled;
+    std::atomic<MetricsRegistry::Histogram*> m_queryTime{nullptr};
+    QHash<QString, QString> m_patternCache;
+    qint64 m_totalQueryTime = 0;
+    QElapsedTimer m_lastQueryActivity;
+    bool m_idleRetryPending = false;
     
     // Index management
     mutable QMutex m_indexMutex;
@@ -400,6 +498,7 @@ private:
     // Auto optimization
     QTimer* m_optimizationTimer;
     bool m_autoOptimizationEnabled;
+    bool m_wholeDatabaseMaintenance = true;
     int m_optimizationInterval;
     
     // Performance metrics
@@ -412,6 +511,10 @@ private:
     static constexpr int DEFAULT_OPTIMIZATION_INTERVAL = 3600000; // 1 hour
     static constexpr int INDEX_CACHE_DURATION = 300000; // 5 minutes
     static constexpr int METRICS_CACHE_DURATION = 60000; // 1 minute
+    static constexpr int IDLE_THRESHOLD_MS = 30000; // quiet time before auto optimization
+    static constexpr int HOT_QUERY_EXECUTIONS = 50; // executions that make a query worth indexing
+    static constexpr int MAX_RECOMMENDED_INDEX_COLUMNS = 3;
+    static constexpr int PATTERN_CACHE_LIMIT = 512;
 };
 
 #endif // DATABASEOPTIMIZER_H
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "DatabaseService.h"
+#include "QueryTimer.h"
 #include <QSqlDatabase>
 #include <QSqlQuery>
 #include <QSqlError>
@@ -13,6 +14,37 @@
 #include <QDebug>
 #include <QDateTime>
 #include <QVariant>
+#include <algorithm>
+#include <sqlite3.h>
+
+/**
+ * @brief State of a running online backup
+ *
+ * Uses raw SQLite handles: the backup API is not reachable through QtSql,
+ * and handles opened here never cross into Qt's driver.
+ */
+struct DatabaseService::BackupJob {
+    QString backupPath;
+    QString partialPath;
+    int pagesPerStep = 0;
+    sqlite3* source = nullptr;
+    sqlite3* destination = nullptr;
+    sqlite3_backup* backup = nullptr;
+    
+    ~BackupJob()
+    {
+        if (backup) {
+            sqlite3_backup_finish(backup);
+        }
+        if (source) {
+            sqlite3_exec(source, "COMMIT", nullptr, nullptr, nullptr);
+            sqlite3_close(source);
+        }
+        if (destination) {
+            sqlite3_close(destination);
+        }
+    }
+};
 
 DatabaseService::DatabaseService(QObject* parent)
     : BaseService(parent)
@@ -20,6 +52,7 @@ DatabaseService::DatabaseService(QObject* parent)
     , m_maxConnections(DEFAULT_MAX_CONNECTIONS)
     , m_connectionCounter(0)
     , m_cleanupTimer(new QTimer(this))
+    , m_backupTimer(new QTimer(this))
     , m_totalQueries(0)
     , m_failedQueries(0)
     , m_totalTransactions(0)
@@ -30,6 +63,11 @@ DatabaseService::DatabaseService(QObject* parent)
     m_cleanupTimer->setSingleShot(false);
     connect(m_cleanupTimer, &QTimer::timeout, this, &DatabaseService::onConnectionCleanupTimer);
     
+    // Online backups advance one step per timeout, yielding to the event loop in between
+    m_backupTimer->setInterval(BACKUP_STEP_INTERVAL_MS);
+    m_backupTimer->setSingleShot(false);
+    connect(m_backupTimer, &QTimer::timeout, this, &DatabaseService::onBackupStep);
+    
     // Set default database path
     QString configDir = QStandardPaths::writableLocation(QStandardPaths::ConfigLocation);
     QString appDir = configDir + "/Netpack - Online Solutions/XFB/config";
@@ -39,6 +77,11 @@ DatabaseService::DatabaseService(QObject* parent)
 DatabaseService::~DatabaseService()
 {
     // Shutdown is called in BaseService destructor
+    if (m_backupJob) {
+        const QString partialPath = m_backupJob->partialPath;
+        m_backupJob.reset();
+        QFile::remove(partialPath);
+    }
 }
 
 bool DatabaseService::doInitialize()
@@ -68,28 +111,25 @@ bool DatabaseService::doInitialize()
         return false;
     }
     
-    // Create initial connection to test database
-    auto testConnection = createConnection();
-    if (!testConnection || !testConnection->database.isValid()) {
-        setError("Failed to create initial database connection");
-        return false;
+    // Open the initializing thread's connection; this also switches the
+    // database file to WAL, which persists for every later connection
+    {
+        QMutexLocker locker(&m_poolMutex);
+        m_acceptingConnections = true;
     }
     
-    // Test opening the database
-    if (!testConnection->database.open()) {
-        QSqlError error = testConnection->database.lastError();
-        setError(QString("Failed to open database: %1").arg(error.text()));
-        logSqlError(error, "", "Initial connection test");
+    PooledConnection* connection = getConnection();
+    if (!connection) {
+        setError("Failed to open initial database connection");
+        QMutexLocker locker(&m_poolMutex);
+        m_acceptingConnections = false;
         return false;
     }
     
-    // Add test connection to pool before schema initialization
-    m_connectionPool.push_back(std::move(testConnection));
-    
-    // Create a default database connection for simple queries
+    // Create a default database connection for code that uses QSqlDatabase::database()
     QSqlDatabase defaultDb = QSqlDatabase::addDatabase(m_driverName);
     defaultDb.setDatabaseName(m_databasePath);
-    defaultDb.setConnectOptions("QSQLITE_BUSY_TIMEOUT=30000");
+    defaultDb.setConnectOptions(QString("QSQLITE_BUSY_TIMEOUT=%1").arg(BUSY_TIMEOUT_MS));
     
     if (!defaultDb.open()) {
         QSqlError error = defaultDb.lastError();
@@ -97,6 +137,7 @@ bool DatabaseService::doInitialize()
         logSqlError(error, "", "Default connection");
         return false;
     }
+    applyConnectionPragmas(defaultDb);
     
     // Initialize schema if needed
     if (!initializeSchema()) {
@@ -111,6 +152,12 @@ bool DatabaseService::doInitialize()
     return true;
 }
 
+bool DatabaseService::healthCheck()
+{
+    // A query on this thread's connection, the one the checks run on
+    return pingConnection(threadConnection());
+}
+
 void DatabaseService::doShutdown()
 {
     logDebug("Shutting down database service...");
@@ -118,6 +165,10 @@ void DatabaseService::doShutdown()
     // Stop cleanup timer
     m_cleanupTimer->stop();
     
+    if (m_backupJob) {
+        cancelBackup();
+    }
+    
     // Close default connection
     QSqlDatabase defaultDb = QSqlDatabase::database();
     if (defaultDb.isValid() && defaultDb.isOpen()) {
@@ -126,11 +177,14 @@ void DatabaseService::doShutdown()
     
     // Close all connections
     QMutexLocker locker(&m_poolMutex);
+    m_acceptingConnections = false;
     for (auto& connection : m_connectionPool) {
-        if (connection->database.isOpen()) {
-            connection->database.close();
+        if (connection->thread) {
+            disconnect(connection->thread, nullptr, this, nullptr);
         }
+        closeConnection(connection.get());
     }
+    m_threadConnections.clear();
     m_connectionPool.clear();
     
     // Remove all database connections
@@ -165,14 +219,149 @@ QString DatabaseService::databasePath() const
 
 QSqlQuery DatabaseService::createQuery()
 {
-    // Use the default database connection for simple queries
-    QSqlDatabase db = QSqlDatabase::database();
-    if (!db.isValid() || !db.isOpen()) {
-        logError("Default database connection is not available");
+    PooledConnection* connection = getConnection();
+    if (!connection) {
+        logError("Database connection is not available");
         return QSqlQuery();
     }
     
-    return QSqlQuery(db);
+    return QSqlQuery(connection->database);
+}
+
+QSqlDatabase DatabaseService::threadConnection()
+{
+    PooledConnection* connection = getConnection();
+    return connection ? connection->database : QSqlDatabase();
+}
+
+bool DatabaseService::applyConnectionPragmas(QSqlDatabase& database)
+{
+    if (!database.isOpen()) {
+        return false;
+    }
+    
+    QSqlQuery query(database);
+    
+    // WAL lets readers proceed while another connection writes; NORMAL sync
+    // is safe with WAL and avoids an fsync on every commit
+    bool walEnabled = query.exec("PRAGMA journal_mode=WAL") && query.next() &&
+                      query.value(0).toString().compare("wal", Qt::CaseInsensitive) == 0;
+    
+    const char* const pragmas[] = {
+        "PRAGMA synchronous=NORMAL",
+        "PRAGMA cache_size=-16384",     // 16 MB page cache
+        "PRAGMA mmap_size=268435456",   // 256 MB memory map
+        "PRAGMA temp_store=MEMORY",
+    };
+    
+    for (const char* pragma : pragmas) {
+        if (!query.exec(pragma)) {
+            qWarning() << "DatabaseService: failed to apply" << pragma << "-" << query.lastError().text();
+        }
+    }
+    
+    return walEnabled;
+}
+
+bool DatabaseService::provisionDatabaseFile(const QString& resourcePath,
+                                            const QString& databasePath, QString* error)
+{
+    auto fail = [error](const QString& reason) {
+        if (error) {
+            *error = reason;
+        }
+        return false;
+    };
+    
+    QDir dbDir = QFileInfo(databasePath).absoluteDir();
+    if (!dbDir.exists() && !dbDir.mkpath(".")) {
+        return fail(QString("Cannot create the database directory %1").arg(dbDir.absolutePath()));
+    }
+    
+    const QFileInfo resourceInfo(resourcePath);
+    if (!resourceInfo.exists()) {
+        return fail(QString("The bundled database %1 is missing").arg(resourcePath));
+    }
+    
+    QFile databaseFile(databasePath);
+    bool copyRequired = !databaseFile.exists();
+    if (!copyRequired && resourceInfo.lastModified() > QFileInfo(databasePath).lastModified()) {
+        qInfo() << "DatabaseService: the bundled database is newer, replacing" << databasePath;
+        if (!databaseFile.remove()) {
+            qWarning() << "DatabaseService: cannot remove" << databasePath << "-"
+                       << databaseFile.errorString();
+        }
+        copyRequired = true;
+    }
+    
+    if (copyRequired) {
+        if (!QFile::copy(resourcePath, databasePath)) {
+            return fail(QString("Cannot copy %1 to %2, check the permissions of %3")
+                            .arg(resourcePath, databasePath, dbDir.absolutePath()));
+        }
+        // Files copied out of the resources are read-only
+        const QFileDevice::Permissions permissions = QFileDevice::ReadOwner |
+                                                     QFileDevice::WriteOwner |
+                                                     QFileDevice::ReadGroup |
+                                                     QFileDevice::ReadOther;
+        if (!QFile::setPermissions(databasePath, permissions)) {
+            qWarning() << "DatabaseService: cannot set the permissions of" << databasePath;
+        }
+        qInfo() << "DatabaseService: copied the bundled database to" << databasePath;
+    }
+    
+    const QFileDevice::Permissions permissions = QFile::permissions(databasePath);
+    if (!permissions.testFlag(QFileDevice::ReadOwner) ||
+        !permissions.testFlag(QFileDevice::WriteOwner)) {
+        if (!QFile::setPermissions(databasePath, permissions | QFileDevice::ReadOwner |
+                                                     QFileDevice::WriteOwner)) {
+            return fail(QString("%1 cannot be read and written, and the permissions cannot be "
+                                "changed").arg(databasePath));
+        }
+    }
+    return true;
+}
+
+QSqlDatabase DatabaseService::openNamedConnection(const QString& connectionName,
+                                                  const QString& databasePath, QString* error)
+{
+    QSqlDatabase database = QSqlDatabase::contains(connectionName)
+                                ? QSqlDatabase::database(connectionName, false)
+                                : QSqlDatabase::addDatabase("QSQLITE", connectionName);
+    if (!database.isValid()) {
+        if (error) {
+            *error = QString("The QSQLITE driver is not available (drivers: %1)")
+                         .arg(QSqlDatabase::drivers().join(", "));
+        }
+        return database;
+    }
+    
+    if (database.isOpen() && database.databaseName() == databasePath) {
+        return database;
+    }
+    database.close();
+    database.setDatabaseName(databasePath);
+    if (!database.open()) {
+        if (error) {
+            *error = database.lastError().text();
+        }
+        return database;
+    }
+    
+    if (!applyConnectionPragmas(database)) {
+        qWarning() << "DatabaseService: WAL journaling is not available for" << connectionName
+                   << ", readers may block on writes";
+    }
+    return database;
+}
+
+bool DatabaseService::pingConnection(const QSqlDatabase& database)
+{
+    if (!database.isOpen()) {
+        return false;
+    }
+    QSqlQuery query(database);
+    return query.exec("SELECT 1") && query.next();
 }
 
 bool DatabaseService::executeTransaction(TransactionFunction transaction)
@@ -188,6 +377,21 @@ bool DatabaseService::executeTransaction(TransactionFunction transaction)
         return false;
     }
     
+    // A transaction started inside another one on the same thread joins the
+    // outer transaction; its failure makes the outer one roll back
+    if (connection->transactionDepth > 0) {
+        connection->transactionDepth++;
+        bool success = false;
+        try {
+            success = transaction();
+        } catch (...) {
+            connection->transactionDepth--;
+            throw;
+        }
+        connection->transactionDepth--;
+        return success;
+    }
+    
     QMutexLocker statsLocker(&m_statsMutex);
     m_totalTransactions++;
     statsLocker.unlock();
@@ -201,6 +405,7 @@ bool DatabaseService::executeTransaction(TransactionFunction transaction)
         errorMessage = QString("Failed to start transaction: %1").arg(connection->database.lastError().text());
         logSqlError(connection->database.lastError(), "", "Transaction start");
     } else {
+        connection->transactionDepth++;
         try {
             success = transaction();
             
@@ -223,6 +428,7 @@ bool DatabaseService::executeTransaction(TransactionFunction transaction)
             errorMessage = "Unknown exception in transaction";
             success = false;
         }
+        connection->transactionDepth--;
         
         if (!success) {
             if (!connection->database.rollback()) {
@@ -236,8 +442,6 @@ bool DatabaseService::executeTransaction(TransactionFunction transaction)
         }
     }
     
-    returnConnection(connection);
-    
     if (!success) {
         QMutexLocker statsLocker(&m_statsMutex);
         m_failedTransactions++;
@@ -252,9 +456,9 @@ bool DatabaseService::executeTransaction(TransactionFunction transaction)
 
 bool DatabaseService::executeQuery(const QString& queryString, const QVariantList& bindValues)
 {
-    QSqlQuery query = createQuery();
-    if (!query.isValid()) {
-        logError("Failed to create valid query for execution");
+    PooledConnection* connection = getConnection();
+    if (!connection) {
+        logError("Failed to get database connection for query execution");
         return false;
     }
     
@@ -262,88 +466,131 @@ bool DatabaseService::executeQuery(const QString& queryString, const QVariantLis
     m_totalQueries++;
     statsLocker.unlock();
     
-    if (!query.prepare(queryString)) {
+    bool prepared = true;
+    std::unique_ptr<QSqlQuery> query = takeStatement(connection, queryString, prepared);
+    if (!prepared) {
         QMutexLocker statsLocker(&m_statsMutex);
         m_failedQueries++;
         statsLocker.unlock();
         
-        logSqlError(query.lastError(), queryString, "Query preparation");
-        emit databaseError(query.lastError().text(), queryString);
+        QSqlError error = query->lastError();
+        query.reset();
+        logSqlError(error, queryString, "Query preparation");
+        emit databaseError(error.text(), queryString);
         return false;
     }
     
     // Bind values if provided
-    for (const QVariant& value : bindValues) {
-        query.addBindValue(value);
+    for (int i = 0; i < bindValues.size(); ++i) {
+        query->bindValue(i, bindValues.at(i));
+    }
+    
+    bool executed;
+    {
+        QueryTimer timer(queryString);
+        executed = query->exec();
     }
     
-    if (!query.exec()) {
+    if (!executed) {
         QMutexLocker statsLocker(&m_statsMutex);
         m_failedQueries++;
         statsLocker.unlock();
         
-        logSqlError(query.lastError(), queryString, "Query execution");
-        emit databaseError(query.lastError().text(), queryString);
+        QSqlError error = query->lastError();
+        query.reset();
+        logSqlError(error, queryString, "Query execution");
+        emit databaseError(error.text(), queryString);
         return false;
     }
     
+    returnStatement(connection, queryString, std::move(query));
     return true;
 }
 
 QList<QVariantMap> DatabaseService::executeSelect(const QString& queryString, const QVariantList& bindValues)
 {
     QList<QVariantMap> results;
+    QStringList fieldNames;
+    
+    forEachRow(queryString, bindValues, [&results, &fieldNames](const QSqlQuery& row) {
+        if (fieldNames.isEmpty()) {
+            QSqlRecord record = row.record();
+            for (int i = 0; i < record.count(); ++i) {
+                fieldNames.append(record.fieldName(i));
+            }
+        }
+        
+        QVariantMap map;
+        for (int i = 0; i < fieldNames.size(); ++i) {
+            map[fieldNames.at(i)] = row.value(i);
+        }
+        results.append(map);
+        return true;
+    });
     
-    QSqlQuery query = createQuery();
-    if (!query.isValid()) {
-        return results;
+    logDebug(QString("SELECT query returned %1 rows").arg(results.size()));
+    return results;
+}
+
+int DatabaseService::forEachRow(const QString& queryString, const QVariantList& bindValues,
+                                const RowFunction& visitor)
+{
+    PooledConnection* connection = getConnection();
+    if (!connection) {
+        return -1;
     }
     
     QMutexLocker statsLocker(&m_statsMutex);
     m_totalQueries++;
     statsLocker.unlock();
     
-    if (!query.prepare(queryString)) {
+    bool prepared = true;
+    std::unique_ptr<QSqlQuery> query = takeStatement(connection, queryString, prepared);
+    if (!prepared) {
         QMutexLocker statsLocker(&m_statsMutex);
         m_failedQueries++;
         statsLocker.unlock();
         
-        logSqlError(query.lastError(), queryString, "SELECT query preparation");
-        emit databaseError(query.lastError().text(), queryString);
-        return results;
+        QSqlError error = query->lastError();
+        query.reset();
+        logSqlError(error, queryString, "SELECT query preparation");
+        emit databaseError(error.text(), queryString);
+        return -1;
     }
     
     // Bind values if provided
-    for (const QVariant& value : bindValues) {
-        query.addBindValue(value);
+    for (int i = 0; i < bindValues.size(); ++i) {
+        query->bindValue(i, bindValues.at(i));
     }
     
-    if (!query.exec()) {
+    bool executed;
+    {
+        QueryTimer timer(queryString);
+        executed = query->exec();
+    }
+    
+    if (!executed) {
         QMutexLocker statsLocker(&m_statsMutex);
         m_failedQueries++;
         statsLocker.unlock();
         
-        logSqlError(query.lastError(), queryString, "SELECT query execution");
-        emit databaseError(query.lastError().text(), queryString);
-        return results;
+        QSqlError error = query->lastError();
+        query.reset();
+        logSqlError(error, queryString, "SELECT query execution");
+        emit databaseError(error.text(), queryString);
+        return -1;
     }
     
-    // Process results
-    QSqlRecord record = query.record();
-    int fieldCount = record.count();
-    
-    while (query.next()) {
-        QVariantMap row;
-        for (int i = 0; i < fieldCount; ++i) {
-            QString fieldName = record.fieldName(i);
-            QVariant value = query.value(i);
-            row[fieldName] = value;
+    int visited = 0;
+    while (query->next()) {
+        ++visited;
+        if (!visitor(*query)) {
+            break;
         }
-        results.append(row);
     }
     
-    logDebug(QString("SELECT query returned %1 rows").arg(results.size()));
-    return results;
+    returnStatement(connection, queryString, std::move(query));
+    return visited;
 }
 
 bool DatabaseService::backup(const QString& backupPath)
@@ -379,6 +626,12 @@ bool DatabaseService::backup(const QString& backupPath)
         }
     }
     
+    // Fold the write-ahead log into the main file so the copy is complete
+    {
+        QSqlQuery checkpoint = createQuery();
+        checkpoint.exec("PRAGMA wal_checkpoint(TRUNCATE)");
+    }
+    
     // Copy database file
     if (!QFile::copy(m_databasePath, backupPath)) {
         QString error = QString("Failed to copy database file from %1 to %2").arg(m_databasePath, backupPath);
@@ -392,6 +645,132 @@ bool DatabaseService::backup(const QString& backupPath)
     return true;
 }
 
+bool DatabaseService::startBackup(const QString& backupPath, int pagesPerStep)
+{
+    if (m_backupJob) {
+        logWarning(QString("Online backup already running to: %1").arg(m_backupJob->backupPath));
+        return false;
+    }
+    
+    if (!QFile::exists(m_databasePath)) {
+        logError(QString("Source database file does not exist: %1").arg(m_databasePath));
+        return false;
+    }
+    
+    QDir backupDir = QFileInfo(backupPath).absoluteDir();
+    if (!backupDir.exists() && !backupDir.mkpath(".")) {
+        logError(QString("Failed to create backup directory: %1").arg(backupDir.absolutePath()));
+        return false;
+    }
+    
+    auto job = std::make_unique<BackupJob>();
+    job->backupPath = backupPath;
+    job->partialPath = backupPath + ".partial";
+    job->pagesPerStep = std::max(1, pagesPerStep);
+    QFile::remove(job->partialPath);
+    
+    auto fail = [this](sqlite3* db, const QString& what) {
+        logError(QString("%1: %2").arg(what, db ? QString::fromUtf8(sqlite3_errmsg(db)) : QString()));
+        return false;
+    };
+    
+    if (sqlite3_open_v2(QFile::encodeName(m_databasePath).constData(), &job->source,
+                        SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK) {
+        return fail(job->source, "Failed to open backup source");
+    }
+    sqlite3_busy_timeout(job->source, BUSY_TIMEOUT_MS);
+    
+    // Pin one WAL snapshot for the whole job; without it every write from
+    // another connection would restart the backup from the first page
+    if (sqlite3_exec(job->source, "BEGIN; SELECT COUNT(*) FROM sqlite_master;",
+                     nullptr, nullptr, nullptr) != SQLITE_OK) {
+        return fail(job->source, "Failed to start backup snapshot");
+    }
+    
+    if (sqlite3_open_v2(QFile::encodeName(job->partialPath).constData(), &job->destination,
+                        SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, nullptr) != SQLITE_OK) {
+        return fail(job->destination, "Failed to create backup file");
+    }
+    
+    job->backup = sqlite3_backup_init(job->destination, "main", job->source, "main");
+    if (!job->backup) {
+        return fail(job->destination, "Failed to start online backup");
+    }
+    
+    logDebug(QString("Starting online backup to: %1").arg(backupPath));
+    m_backupJob = std::move(job);
+    m_backupTimer->start();
+    return true;
+}
+
+bool DatabaseService::isBackupRunning() const
+{
+    return m_backupJob != nullptr;
+}
+
+void DatabaseService::cancelBackup()
+{
+    if (m_backupJob) {
+        finishBackup(false, "Backup cancelled");
+    }
+}
+
+void DatabaseService::onBackupStep()
+{
+    if (!m_backupJob) {
+        m_backupTimer->stop();
+        return;
+    }
+    
+    const int rc = sqlite3_backup_step(m_backupJob->backup, m_backupJob->pagesPerStep);
+    const int totalPages = sqlite3_backup_pagecount(m_backupJob->backup);
+    emit backupProgress(totalPages - sqlite3_backup_remaining(m_backupJob->backup), totalPages);
+    
+    if (rc == SQLITE_DONE) {
+        finishBackup(true);
+    } else if (rc != SQLITE_OK && rc != SQLITE_BUSY && rc != SQLITE_LOCKED) {
+        // Busy and locked are transient; the next step retries
+        finishBackup(false, QString::fromUtf8(sqlite3_errstr(rc)));
+    }
+}
+
+void DatabaseService::finishBackup(bool success, const QString& error)
+{
+    m_backupTimer->stop();
+    
+    std::unique_ptr<BackupJob> job = std::move(m_backupJob);
+    const QString backupPath = job->backupPath;
+    const QString partialPath = job->partialPath;
+    QString reason = error;
+    
+    if (success && sqlite3_backup_finish(job->backup) != SQLITE_OK) {
+        reason = QString::fromUtf8(sqlite3_errmsg(job->destination));
+        success = false;
+    }
+    job->backup = nullptr;
+    job.reset();
+    
+    if (success) {
+        if (QFile::exists(backupPath) && !QFile::remove(backupPath)) {
+            logError(QString("Failed to remove existing backup file: %1").arg(backupPath));
+            success = false;
+        } else if (!QFile::rename(partialPath, backupPath)) {
+            logError(QString("Failed to move backup into place: %1").arg(backupPath));
+            success = false;
+        }
+    } else {
+        logError(QString("Online backup to %1 failed: %2").arg(backupPath, reason));
+    }
+    
+    if (success) {
+        logDebug(QString("Online backup completed successfully: %1").arg(backupPath));
+    } else {
+        QFile::remove(partialPath);
+    }
+    
+    emit backupCompleted(success, backupPath);
+}
+
 bool DatabaseService::restore(const QString& backupPath)
 {
     logDebug(QString("Starting database restore from: %1").arg(backupPath));
@@ -403,16 +782,53 @@ bool DatabaseService::restore(const QString& backupPath)
         return false;
     }
     
-    // Close all connections before restore
+    // Close the other threads' connections first; a read snapshot held on
+    // one would stop the checkpoint short of the end of the log. Threads
+    // reopen them on next use
     {
         QMutexLocker locker(&m_poolMutex);
         for (auto& connection : m_connectionPool) {
-            if (connection->database.isOpen()) {
-                connection->database.close();
+            if (connection->thread != QThread::currentThread()) {
+                closeConnection(connection.get());
             }
         }
     }
     
+    // Fold the write-ahead log into the main file so the copy of the current
+    // database taken below is complete. The row is busy, frames in the log
+    // and frames checkpointed, -1 and -1 when the database is not in WAL
+    // mode; anything short of the whole log would be lost with it below
+    {
+        QSqlQuery checkpoint = createQuery();
+        if (!checkpoint.exec("PRAGMA wal_checkpoint(TRUNCATE)") || !checkpoint.next()) {
+            logError(QString("Failed to checkpoint before restore: %1")
+                    .arg(checkpoint.lastError().text()));
+            emit restoreCompleted(false, backupPath);
+            return false;
+        }
+        const int busy = checkpoint.value(0).toInt();
+        const int logFrames = checkpoint.value(1).toInt();
+        const int checkpointed = checkpoint.value(2).toInt();
+        if (busy != 0 || checkpointed != logFrames) {
+            logError(QString("Restore aborted: checkpoint incomplete (busy %1, %2 of %3 frames)")
+                    .arg(busy).arg(checkpointed).arg(logFrames));
+            emit restoreCompleted(false, backupPath);
+            return false;
+        }
+    }
+    
+    {
+        QMutexLocker locker(&m_poolMutex);
+        for (auto& connection : m_connectionPool) {
+            closeConnection(connection.get());
+        }
+    }
+    
+    // The log is empty now, but belongs to the file being replaced and must
+    // not be replayed onto the restored one
+    QFile::remove(m_databasePath + "-wal");
+    QFile::remove(m_databasePath + "-shm");
+    
     // Backup current database
     QString currentBackup = m_databasePath + ".restore_backup";
     if (QFile::exists(m_databasePath)) {
@@ -449,8 +865,7 @@ bool DatabaseService::restore(const QString& backupPath)
     }
     
     // Test restored database
-    auto testConnection = createConnection();
-    if (!testConnection || !testConnection->database.open()) {
+    if (!getConnection()) {
         QString error = "Restored database failed validation";
         logError(error);
         
@@ -464,9 +879,6 @@ bool DatabaseService::restore(const QString& backupPath)
         return false;
     }
     
-    // Return test connection to pool
-    m_connectionPool.push_back(std::move(testConnection));
-    
     // Clean up restore backup
     if (QFile::exists(currentBackup)) {
         QFile::remove(currentBackup);
@@ -490,6 +902,17 @@ bool DatabaseService::optimizeDatabase()
             return false;
         }
         
+        // VACUUM may renumber the rowids of tables without an INTEGER
+        // PRIMARY KEY, and the music full-text index is keyed by rowid
+        if (query.exec("SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = 'musics_fts'")
+            && query.next()) {
+            const QString rebuild = "INSERT INTO musics_fts(musics_fts) VALUES ('rebuild')";
+            if (!query.exec(rebuild)) {
+                logSqlError(query.lastError(), rebuild, "Database optimization");
+                return false;
+            }
+        }
+        
         // ANALYZE to update query planner statistics
         if (!query.exec("ANALYZE")) {
             logSqlError(query.lastError(), "ANALYZE", "Database optimization");
@@ -517,24 +940,26 @@ bool DatabaseService::checkIntegrity()
 {
     logDebug("Checking database integrity...");
     
-    QList<QVariantMap> results = executeSelect("PRAGMA integrity_check");
+    // Every reported problem is logged; the scan does not stop at the first
+    bool intact = true;
+    int rows = forEachRow("PRAGMA integrity_check", QVariantList(), [this, &intact](const QSqlQuery& row) {
+        QString result = row.value(0).toString();
+        if (result != "ok") {
+            logError(QString("Database integrity check failed: %1").arg(result));
+            intact = false;
+        }
+        return true;
+    });
     
-    if (results.isEmpty()) {
+    if (rows <= 0) {
         logError("Failed to check database integrity");
         return false;
     }
     
-    // Check results
-    for (const QVariantMap& row : results) {
-        QString result = row.value("integrity_check").toString();
-        if (result != "ok") {
-            logError(QString("Database integrity check failed: %1").arg(result));
-            return false;
-        }
+    if (intact) {
+        logDebug("Database integrity check passed");
     }
-    
-    logDebug("Database integrity check passed");
-    return true;
+    return intact;
 }
 
 QVariantMap DatabaseService::getDatabaseStats()
@@ -546,6 +971,8 @@ QVariantMap DatabaseService::getDatabaseStats()
     stats["failed_queries"] = m_failedQueries;
     stats["total_transactions"] = m_totalTransactions;
     stats["failed_transactions"] = m_failedTransactions;
+    stats["statement_cache_hits"] = m_statementCacheHits;
+    stats["statement_cache_misses"] = m_statementCacheMisses;
     stats["last_optimization"] = m_lastOptimization;
     locker.unlock();
     
@@ -556,18 +983,25 @@ QVariantMap DatabaseService::getDatabaseStats()
         stats["last_modified"] = dbInfo.lastModified();
     }
     
-    // Get connection pool stats
+    // Journal mode as seen by the calling thread's connection
+    QSqlQuery journalQuery = createQuery();
+    if (journalQuery.exec("PRAGMA journal_mode") && journalQuery.next()) {
+        stats["journal_mode"] = journalQuery.value(0).toString();
+    }
+    
+    // Get connection stats
     QMutexLocker poolLocker(&m_poolMutex);
     stats["max_connections"] = m_maxConnections;
     stats["active_connections"] = static_cast<int>(m_connectionPool.size());
+    stats["thread_connections"] = static_cast<int>(m_threadConnections.size());
     
-    int inUseCount = 0;
+    int inTransactionCount = 0;
     for (const auto& connection : m_connectionPool) {
-        if (connection->inUse) {
-            inUseCount++;
+        if (connection->transactionDepth > 0) {
+            inTransactionCount++;
         }
     }
-    stats["connections_in_use"] = inUseCount;
+    stats["connections_in_use"] = inTransactionCount;
     
     return stats;
 }
@@ -601,19 +1035,6 @@ void DatabaseService::setMaxConnections(int maxConnections)
     QMutexLocker locker(&m_poolMutex);
     m_maxConnections = maxConnections;
     
-    // Clean up excess connections if needed
-    while (static_cast<int>(m_connectionPool.size()) > maxConnections) {
-        auto it = m_connectionPool.end() - 1;
-        if (!(*it)->inUse) {
-            if ((*it)->database.isOpen()) {
-                (*it)->database.close();
-            }
-            m_connectionPool.erase(it);
-        } else {
-            break; // Can't remove connections that are in use
-        }
-    }
-    
     logDebug(QString("Maximum connections set to: %1").arg(maxConnections));
 }
 
@@ -625,63 +1046,98 @@ int DatabaseService::maxConnections() const
 
 DatabaseService::PooledConnection* DatabaseService::getConnection()
 {
+    QThread* thread = QThread::currentThread();
+    
     QMutexLocker locker(&m_poolMutex);
+    if (!m_acceptingConnections) {
+        return nullptr;
+    }
     
-    // Look for available connection
-    for (auto& connection : m_connectionPool) {
-        if (!connection->inUse && connection->database.isValid() && connection->database.isOpen()) {
-            connection->inUse = true;
-            connection->lastUsed = QDateTime::currentDateTime();
-            connection->useCount++;
-            return connection.get();
+    PooledConnection* connection = m_threadConnections.value(thread, nullptr);
+    if (connection && connection->thread == thread) {
+        if (!connection->database.isOpen()) {
+            // Closed by restore() or recovery; reopen on the owning thread
+            if (!connection->database.open()) {
+                logError(QString("Failed to reopen database connection: %1")
+                        .arg(connection->database.lastError().text()));
+                return nullptr;
+            }
+            applyConnectionPragmas(connection->database);
         }
+        connection->lastUsed = QDateTime::currentDateTime();
+        connection->useCount++;
+        return connection;
     }
     
-    // Create new connection if under limit
-    if (static_cast<int>(m_connectionPool.size()) < m_maxConnections) {
-        auto newConnection = createConnection();
-        if (newConnection && newConnection->database.isValid() && newConnection->database.open()) {
-            newConnection->inUse = true;
-            newConnection->lastUsed = QDateTime::currentDateTime();
-            newConnection->useCount++;
-            
-            PooledConnection* ptr = newConnection.get();
-            m_connectionPool.push_back(std::move(newConnection));
-            return ptr;
-        } else {
-            logError("Failed to create new database connection");
-        }
+    // A stale entry means a thread object was reused at the same address
+    if (connection) {
+        removeConnectionLocked(connection);
     }
     
-    // Wait for connection to become available
-    if (m_connectionAvailable.wait(&m_poolMutex, CONNECTION_TIMEOUT_MS)) {
-        // Try again after wait
-        for (auto& connection : m_connectionPool) {
-            if (!connection->inUse && connection->database.isValid() && connection->database.isOpen()) {
-                connection->inUse = true;
-                connection->lastUsed = QDateTime::currentDateTime();
-                connection->useCount++;
-                return connection.get();
-            }
+    auto newConnection = createConnection();
+    if (!newConnection || !newConnection->database.isValid() || !newConnection->database.open()) {
+        QSqlError error = newConnection ? newConnection->database.lastError() : QSqlError();
+        logError(QString("Failed to open database connection: %1").arg(error.text()));
+        if (newConnection) {
+            QString name = newConnection->connectionName;
+            newConnection.reset();
+            QSqlDatabase::removeDatabase(name);
         }
+        return nullptr;
+    }
+    
+    if (!applyConnectionPragmas(newConnection->database)) {
+        logWarning(QString("WAL journal mode is not active on %1").arg(newConnection->connectionName));
     }
     
-    logError("Failed to get database connection (timeout or no connections available)");
-    return nullptr;
+    newConnection->thread = thread;
+    newConnection->useCount++;
+    connection = newConnection.get();
+    m_connectionPool.push_back(std::move(newConnection));
+    m_threadConnections.insert(thread, connection);
+    
+    if (thread != this->thread()) {
+        // Qt connections must be closed by the thread that opened them
+        connect(thread, &QThread::finished, this, [this, thread]() {
+            releaseThreadConnection(thread);
+        }, Qt::DirectConnection);
+    }
+    
+    if (static_cast<int>(m_threadConnections.size()) > m_maxConnections) {
+        logWarning(QString("%1 threads hold database connections (expected at most %2)")
+                   .arg(m_threadConnections.size()).arg(m_maxConnections));
+    }
+    
+    return connection;
 }
 
-void DatabaseService::returnConnection(PooledConnection* connection)
+void DatabaseService::releaseThreadConnection(QThread* thread)
 {
-    if (!connection) {
+    QMutexLocker locker(&m_poolMutex);
+    
+    PooledConnection* connection = m_threadConnections.value(thread, nullptr);
+    if (connection) {
+        removeConnectionLocked(connection);
+    }
+}
+
+void DatabaseService::removeConnectionLocked(PooledConnection* connection)
+{
+    m_threadConnections.remove(m_threadConnections.key(connection));
+    
+    auto it = std::find_if(m_connectionPool.begin(), m_connectionPool.end(),
+                           [connection](const auto& entry) { return entry.get() == connection; });
+    if (it == m_connectionPool.end()) {
         return;
     }
     
-    QMutexLocker locker(&m_poolMutex);
-    connection->inUse = false;
-    connection->lastUsed = QDateTime::currentDateTime();
+    QString connectionName = (*it)->connectionName;
+    closeConnection(it->get());
+    m_connectionPool.erase(it);
     
-    // Notify waiting threads
-    m_connectionAvailable.wakeOne();
+    // The QSqlDatabase handle is gone, so the name can be released
+    QSqlDatabase::removeDatabase(connectionName);
+    logDebug(QString("Released database connection: %1").arg(connectionName));
 }
 
 std::unique_ptr<DatabaseService::PooledConnection> DatabaseService::createConnection()
@@ -697,23 +1153,56 @@ std::unique_ptr<DatabaseService::PooledConnection> DatabaseService::createConnec
     connection->lastUsed = QDateTime::currentDateTime();
     
     // Set SQLite-specific options for better performance and reliability
-    connection->database.setConnectOptions("QSQLITE_BUSY_TIMEOUT=30000");
+    connection->database.setConnectOptions(QString("QSQLITE_BUSY_TIMEOUT=%1").arg(BUSY_TIMEOUT_MS));
+    
+    connection->statements.setMaxCost(STATEMENT_CACHE_SIZE);
     
     logDebug(QString("Created database connection: %1").arg(connectionName));
     return connection;
 }
 
-bool DatabaseService::initializeSchema()
+std::unique_ptr<QSqlQuery> DatabaseService::takeStatement(PooledConnection* connection,
+                                                          const QString& queryString, bool& prepared)
 {
-    logDebug("Initializing database schema...");
+    std::unique_ptr<QSqlQuery> statement(connection->statements.take(queryString));
     
-    // Use the test connection that was already created and validated
-    if (m_connectionPool.empty()) {
-        logError("No database connections available for schema initialization");
-        return false;
+    QMutexLocker statsLocker(&m_statsMutex);
+    if (statement) {
+        m_statementCacheHits++;
+        prepared = true;
+        return statement;
     }
+    m_statementCacheMisses++;
+    statsLocker.unlock();
+    
+    statement = std::make_unique<QSqlQuery>(connection->database);
+    statement->setForwardOnly(true);
+    prepared = statement->prepare(queryString);
+    return statement;
+}
+
+void DatabaseService::returnStatement(PooledConnection* connection, const QString& queryString,
+                                      std::unique_ptr<QSqlQuery> statement)
+{
+    // Reset the statement so it holds no read snapshot while cached
+    statement->finish();
+    connection->statements.insert(queryString, statement.release());
+}
+
+void DatabaseService::closeConnection(PooledConnection* connection)
+{
+    connection->statements.clear();
+    if (connection->database.isOpen()) {
+        connection->database.close();
+    }
+}
+
+bool DatabaseService::initializeSchema()
+{
+    logDebug("Initializing database schema...");
     
-    PooledConnection* connection = m_connectionPool[0].get();
+    // Use the initializing thread's connection opened by doInitialize()
+    PooledConnection* connection = getConnection();
     if (!connection || !connection->database.isValid() || !connection->database.isOpen()) {
         logError("Invalid database connection for schema initialization");
         return false;
@@ -757,20 +1246,19 @@ void DatabaseService::cleanupConnections()
 {
     QMutexLocker locker(&m_poolMutex);
     
-    QDateTime cutoff = QDateTime::currentDateTime().addSecs(-300); // 5 minutes ago
-    
-    auto it = m_connectionPool.begin();
-    while (it != m_connectionPool.end()) {
-        if (!(*it)->inUse && (*it)->lastUsed < cutoff) {
-            logDebug(QString("Cleaning up unused connection: %1").arg((*it)->connectionName));
-            if ((*it)->database.isOpen()) {
-                (*it)->database.close();
-            }
-            it = m_connectionPool.erase(it);
-        } else {
-            ++it;
+    // Connections of live threads stay open for the thread's lifetime; this
+    // catches threads that were destroyed without emitting finished()
+    std::vector<PooledConnection*> stale;
+    for (const auto& connection : m_connectionPool) {
+        if (!connection->thread || connection->thread->isFinished()) {
+            stale.push_back(connection.get());
         }
     }
+    
+    for (PooledConnection* connection : stale) {
+        logDebug(QString("Cleaning up connection of finished thread: %1").arg(connection->connectionName));
+        removeConnectionLocked(connection);
+    }
 }
 
 void DatabaseService::onConnectionCleanupTimer()
@@ -810,24 +1298,26 @@ bool DatabaseService::attemptRecovery(const QSqlError& error)
     if (errorText.contains("database is locked") || errorText.contains("database is busy")) {
         logDebug("Attempting recovery from database lock/busy error");
         
-        // Close and recreate connections
+        // Reopen the calling thread's connection; connections of other
+        // threads may only be touched by those threads
         QMutexLocker locker(&m_poolMutex);
-        for (auto& connection : m_connectionPool) {
-            if (connection->database.isOpen()) {
-                connection->database.close();
-            }
+        PooledConnection* connection = m_threadConnections.value(QThread::currentThread(), nullptr);
+        if (!connection || connection->transactionDepth > 0) {
+            // Closing would discard the open transaction
+            return false;
         }
         
+        closeConnection(connection);
+        
         // Wait a bit and try to reopen
         QThread::msleep(100);
         
-        for (auto& connection : m_connectionPool) {
-            if (!connection->database.open()) {
-                logError(QString("Failed to reopen connection after recovery attempt: %1")
-                        .arg(connection->database.lastError().text()));
-                return false;
-            }
+        if (!connection->database.open()) {
+            logError(QString("Failed to reopen connection after recovery attempt: %1")
+                    .arg(connection->database.lastError().text()));
+            return false;
         }
+        applyConnectionPragmas(connection->database);
         
         logDebug("Database connection recovery completed");
         return true;
@@ -8,8 +8,9 @@
 #include <QMutex>
 #include <QTimer>
 #include <QThread>
-#include <QQueue>
-#include <QWaitCondition>
+#include <QPointer>
+#include <QHash>
+#include <QCache>
 #include <functional>
 #include <memory>
 #include <vector>
@@ -23,9 +24,16 @@
  * and manages connection lifecycle automatically.
  * 
  * Features:
- * - Connection pooling for improved performance
+ * - One cached connection per thread, so threads never wait for each other
+ *   to get a connection and Qt's rule that a connection is only used by the
+ *   thread that opened it holds
+ * - WAL journaling and tuned pragmas on every connection, so background
+ *   writers don't block readers on the on-air thread
+ * - Per-connection LRU cache of prepared statements keyed by SQL text, so
+ *   repeated queries skip SQLite's parse and plan step
  * - Transaction management with automatic rollback on failure
- * - Database backup and restore functionality
+ * - Database backup and restore functionality, including online backups
+ *   that copy a few pages per event loop iteration
  * - Thread-safe operations
  * - Automatic connection recovery
  * - Query performance monitoring
@@ -59,6 +67,11 @@ public:
      */
     using TransactionFunction = std::function<bool()>;
 
+    /**
+     * @brief Row visitor type; return false to stop the scan
+     */
+    using RowFunction = std::function<bool(const QSqlQuery& row)>;
+
     /**
      * @brief Database connection information
      */
@@ -90,11 +103,64 @@ public:
     QString databasePath() const;
 
     /**
-     * @brief Create a new query object using a pooled connection
+     * @brief Create a new query object on the calling thread's connection
      * @return QSqlQuery object ready for use
      */
     QSqlQuery createQuery();
 
+    /**
+     * @brief Get the calling thread's connection, opening it on first use
+     *
+     * A QSqlDatabase may only be used on the thread that opened it, which is
+     * why there is one per thread. Workers that do without the service open
+     * a connection of their own on their thread, under a name of their own.
+     * @return Open database connection, or an invalid one if the service is not running
+     */
+    QSqlDatabase threadConnection();
+
+    /**
+     * @brief Apply the WAL journal mode and performance pragmas to a connection
+     *
+     * Used for the service's own connections and for connections opened
+     * elsewhere, such as the player's legacy connection.
+     * @param database Open SQLite connection
+     * @return true if the connection runs in WAL mode
+     */
+    static bool applyConnectionPragmas(QSqlDatabase& database);
+
+    /**
+     * @brief Put the bundled database in place if the copy on disk is missing or older
+     *
+     * Only touches files, so it can run on a worker thread while the window
+     * is being built.
+     * @param resourcePath Bundled database, such as ":/adb.db"
+     * @param databasePath Where the library is kept
+     * @param error Set to the reason on failure
+     * @return true if databasePath is a database file the user can read and write
+     */
+    static bool provisionDatabaseFile(const QString& resourcePath, const QString& databasePath,
+                                      QString* error = nullptr);
+
+    /**
+     * @brief Open a named connection on the calling thread, with the pragmas applied
+     *
+     * An existing connection of that name is reused. The connection may only
+     * be used on the thread that opened it.
+     * @param connectionName Name for QSqlDatabase::database()
+     * @param databasePath SQLite database file
+     * @param error Set to the reason on failure
+     * @return The connection, closed if it could not be opened
+     */
+    static QSqlDatabase openNamedConnection(const QString& connectionName,
+                                            const QString& databasePath, QString* error = nullptr);
+
+    /**
+     * @brief Check that an open connection still answers a query
+     * @param database Connection to check
+     * @return false if it is closed or the query fails
+     */
+    static bool pingConnection(const QSqlDatabase& database);
+
     /**
      * @brief Execute a transaction with automatic rollback on failure
      * @param transaction Function containing the transaction logic
@@ -118,6 +184,19 @@ public:
      */
     QList<QVariantMap> executeSelect(const QString& queryString, const QVariantList& bindValues = QVariantList());
 
+    /**
+     * @brief Stream the rows of a SELECT query to a visitor
+     *
+     * Rows are read with a forward-only cursor and never collected, so large
+     * scans run in constant memory. Columns are read by index with
+     * row.value(i). The visitor may run other queries through the service.
+     * @param queryString SQL SELECT query
+     * @param bindValues Bind values for prepared statements
+     * @param visitor Called once per row
+     * @return Number of rows visited, or -1 on error
+     */
+    int forEachRow(const QString& queryString, const QVariantList& bindValues, const RowFunction& visitor);
+
     /**
      * @brief Backup the database to a file
      * @param backupPath Path where backup should be saved
@@ -125,8 +204,42 @@ public:
      */
     bool backup(const QString& backupPath);
 
+    /**
+     * @brief Start an online backup that runs in small steps
+     *
+     * Uses SQLite's online backup API from a dedicated read-only connection
+     * that holds one snapshot for the whole job, so writes made meanwhile
+     * neither block nor restart it. pagesPerStep pages are copied each time
+     * the event loop runs the step timer; the caller's thread is never
+     * blocked for longer than one step. The copy is written next to
+     * backupPath and renamed once complete. Progress is reported through
+     * backupProgress() and the result through backupCompleted().
+     * @param backupPath Path where backup should be saved
+     * @param pagesPerStep Database pages copied per step
+     * @return true if the job was started
+     */
+    bool startBackup(const QString& backupPath, int pagesPerStep = BACKUP_PAGES_PER_STEP);
+
+    /**
+     * @brief Check if an online backup is in progress
+     * @return true while a job started by startBackup() is running
+     */
+    bool isBackupRunning() const;
+
+    /**
+     * @brief Abandon the running online backup
+     *
+     * The partial copy is removed and backupCompleted() is emitted with
+     * success set to false.
+     */
+    void cancelBackup();
+
     /**
      * @brief Restore database from a backup file
+     *
+     * The write-ahead log is checkpointed into the current file first. The
+     * restore is abandoned, with the database untouched, when another
+     * reader keeps the checkpoint from reaching the end of the log.
      * @param backupPath Path to the backup file
      * @return true if restore was successful
      */
@@ -151,13 +264,16 @@ public:
     QVariantMap getDatabaseStats();
 
     /**
-     * @brief Get connection pool information
+     * @brief Get information about the per-thread connections
      * @return List of connection information
      */
     QList<ConnectionInfo> getConnectionInfo() const;
 
     /**
-     * @brief Set maximum number of connections in the pool
+     * @brief Set the expected number of concurrently connected threads
+     *
+     * Threads always get their own connection; going past this limit only
+     * logs a warning, as it usually means worker threads are not finishing.
      * @param maxConnections Maximum connections (default: 5)
      */
     void setMaxConnections(int maxConnections);
@@ -183,6 +299,13 @@ signals:
      */
     void backupCompleted(bool success, const QString& backupPath);
 
+    /**
+     * @brief Emitted after each step of an online backup
+     * @param pagesCopied Pages copied so far
+     * @param totalPages Pages in the source database
+     */
+    void backupProgress(int pagesCopied, int totalPages);
+
     /**
      * @brief Emitted when restore operation completes
      * @param success true if restore was successful
@@ -216,33 +339,80 @@ protected:
     // BaseService interface
     bool doInitialize() override;
     void doShutdown() override;
+    bool healthCheck() override;
 
 private slots:
     void onConnectionCleanupTimer();
+    void onBackupStep();
 
 private:
     /**
-     * @brief Connection pool entry
+     * @brief Per-thread connection entry
      */
     struct PooledConnection {
         QSqlDatabase database;
         QString connectionName;
+        QPointer<QThread> thread;
         QDateTime lastUsed;
-        bool inUse = false;
+        int transactionDepth = 0;
         int useCount = 0;
+        QCache<QString, QSqlQuery> statements; ///< Prepared statements by SQL text
     };
 
+    struct BackupJob;
+
+    /**
+     * @brief End the online backup and report the result
+     * @param success true if every page was copied
+     * @param error Reason for failure
+     */
+    void finishBackup(bool success, const QString& error = QString());
+
     /**
-     * @brief Get a connection from the pool
-     * @return Pooled connection, or invalid connection if none available
+     * @brief Take a prepared statement out of a connection's cache
+     *
+     * The statement is removed from the cache while in use, so a nested
+     * query on the same connection can never evict or reuse it.
+     * @param connection Connection to prepare on
+     * @param queryString SQL text
+     * @param prepared Set to false if preparing a new statement failed
+     * @return Statement; on failure its lastError() describes the problem
+     */
+    std::unique_ptr<QSqlQuery> takeStatement(PooledConnection* connection, const QString& queryString,
+                                             bool& prepared);
+
+    /**
+     * @brief Put a statement back into its connection's cache
+     * @param connection Connection the statement was prepared on
+     * @param queryString SQL text
+     * @param statement Statement to cache
+     */
+    void returnStatement(PooledConnection* connection, const QString& queryString,
+                         std::unique_ptr<QSqlQuery> statement);
+
+    /**
+     * @brief Close a connection, dropping its cached statements first
+     * @param connection Connection to close
+     */
+    static void closeConnection(PooledConnection* connection);
+
+    /**
+     * @brief Get the calling thread's connection, creating it on first use
+     * @return Connection, or nullptr if the service is not running
      */
     PooledConnection* getConnection();
 
     /**
-     * @brief Return a connection to the pool
-     * @param connection Connection to return
+     * @brief Close and forget the connection of a thread
+     * @param thread Thread whose connection is released
+     */
+    void releaseThreadConnection(QThread* thread);
+
+    /**
+     * @brief Forget a connection; the caller holds m_poolMutex
+     * @param connection Connection to remove
      */
-    void returnConnection(PooledConnection* connection);
+    void removeConnectionLocked(PooledConnection* connection);
 
     /**
      * @brief Create a new database connection
@@ -257,7 +427,7 @@ private:
     bool initializeSchema();
 
     /**
-     * @brief Clean up unused connections
+     * @brief Clean up connections of threads that have finished
      */
     void cleanupConnections();
 
@@ -290,9 +460,12 @@ private:
     
     mutable QMutex m_poolMutex;
     std::vector<std::unique_ptr<PooledConnection>> m_connectionPool;
-    QWaitCondition m_connectionAvailable;
+    QHash<QThread*, PooledConnection*> m_threadConnections;
+    bool m_acceptingConnections = false;
     
     QTimer* m_cleanupTimer;
+    QTimer* m_backupTimer;
+    std::unique_ptr<BackupJob> m_backupJob;
     
     // Statistics
     mutable QMutex m_statsMutex;
@@ -300,11 +473,16 @@ private:
     int m_failedQueries;
     int m_totalTransactions;
     int m_failedTransactions;
+    int m_statementCacheHits = 0;
+    int m_statementCacheMisses = 0;
     QDateTime m_lastOptimization;
     
     static constexpr int DEFAULT_MAX_CONNECTIONS = 5;
-    static constexpr int CONNECTION_TIMEOUT_MS = 30000; // 30 seconds
-    static constexpr int CLEANUP_INTERVAL_MS = 60000;   // 1 minute
+    static constexpr int BUSY_TIMEOUT_MS = 30000;     // 30 seconds
+    static constexpr int STATEMENT_CACHE_SIZE = 64;   // statements per connection
+    static constexpr int CLEANUP_INTERVAL_MS = 60000; // 1 minute
+    static constexpr int BACKUP_PAGES_PER_STEP = 128;  // ~512 KB with 4 KB pages
+    static constexpr int BACKUP_STEP_INTERVAL_MS = 20;
 };
 
 #endif // DATABASESERVICE_H
\ No newline at end of file
@@ -0,0 +1,248 @@
+#include "DayLogGenerator.h"
+#include <QStringList>
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <utility>
+
+namespace {
+
+constexpr qint64 NEVER = std::numeric_limits<qint64>::min() / 2;
+
+qint64 airTimeMs(qint64 durationUs)
+{
+    return (durationUs < 0 ? DayLogGenerator::DEFAULT_DURATION_US : durationUs) / 1000;
+}
+
+} // namespace
+
+DayLogGenerator::DayLogGenerator()
+    : m_random(QRandomGenerator::global()->generate())
+{
+}
+
+void DayLogGenerator::setLibrary(const QVector<Track>& songs)
+{
+    m_songs.clear();
+    m_songs.reserve(songs.size());
+    m_libraryPool = Pool();
+    m_genrePools.clear();
+
+    for (const Track& song : songs) {
+        if (song.path.isEmpty()) {
+            continue;
+        }
+        const int index = m_songs.size();
+        m_songs.append(song);
+        m_libraryPool.order.append(index);
+        const QString genre = key(song.genre);
+        if (!genre.isEmpty()) {
+            m_genrePools[genre].order.append(index);
+        }
+    }
+
+    reshuffle(m_libraryPool.order);
+    for (Pool& pool : m_genrePools) {
+        reshuffle(pool.order);
+    }
+}
+
+void DayLogGenerator::setJingles(const QVector<Track>& jingles)
+{
+    m_jingles.clear();
+    for (const Track& jingle : jingles) {
+        if (!jingle.path.isEmpty()) {
+            m_jingles.append(jingle);
+        }
+    }
+    m_jingleOrder.resize(m_jingles.size());
+    std::iota(m_jingleOrder.begin(), m_jingleOrder.end(), 0);
+    reshuffle(m_jingleOrder);
+    m_jingleCursor = 0;
+}
+
+QVector<DayLogGenerator::Item> DayLogGenerator::generate(const QDateTime& from,
+                                                         const QDateTime& to,
+                                                         const ClockForHour& clock,
+                                                         QVector<Break> breaks)
+{
+    m_relaxedPicks = 0;
+    m_artistAiredMs.clear();
+    m_titleAiredMs.clear();
+
+    std::stable_sort(breaks.begin(), breaks.end(),
+                     [](const Break& a, const Break& b) { return a.at < b.at; });
+    int nextBreak = 0;
+    while (nextBreak < breaks.size() && breaks[nextBreak].at < from) {
+        ++nextBreak;
+    }
+
+    QVector<Item> log;
+    qint64 nowMs = from.toMSecsSinceEpoch();
+    const qint64 endMs = to.toMSecsSinceEpoch();
+    const auto place = [&](Kind kind, const QString& path, int musicId, qint64 durationUs) {
+        log.append({QDateTime::fromMSecsSinceEpoch(nowMs), kind, path, musicId, durationUs});
+        nowMs += airTimeMs(durationUs);
+    };
+    const auto placeBreak = [&]() {
+        const Break& item = breaks[nextBreak++];
+        place(item.isProgram ? Kind::Program : Kind::Pub, item.path, -1, item.durationUs);
+    };
+
+    HourClock hourClock;
+    qint64 hourEndMs = NEVER;
+    int songsSinceJingle = 0;
+
+    while (nowMs < endMs) {
+        if (nowMs >= hourEndMs) {
+            const QDateTime now = QDateTime::fromMSecsSinceEpoch(nowMs);
+            const QDateTime hourStart(now.date(), QTime(now.time().hour(), 0));
+            hourEndMs = hourStart.addSecs(3600).toMSecsSinceEpoch();
+            hourClock = clock ? clock(hourStart) : HourClock();
+        }
+
+        if (nextBreak < breaks.size() && breaks[nextBreak].at.toMSecsSinceEpoch() <= nowMs) {
+            placeBreak();
+            continue;
+        }
+
+        if (hourClock.jingleEvery > 0 && songsSinceJingle >= hourClock.jingleEvery
+            && !m_jingles.isEmpty()) {
+            if (m_jingleCursor >= m_jingleOrder.size()) {
+                // A new round never opens with the jingle that closed the last one
+                const int last = m_jingleOrder.constLast();
+                reshuffle(m_jingleOrder);
+                if (m_jingleOrder.size() > 1 && m_jingleOrder.constFirst() == last) {
+                    std::swap(m_jingleOrder.first(), m_jingleOrder.last());
+                }
+                m_jingleCursor = 0;
+            }
+            const Track& jingle = m_jingles[m_jingleOrder[m_jingleCursor++]];
+            place(Kind::Jingle, jingle.path, -1, jingle.durationUs);
+            songsSinceJingle = 0;
+            continue;
+        }
+
+        auto genrePool = m_genrePools.find(key(hourClock.genre));
+        Pool& pool = genrePool != m_genrePools.end() ? *genrePool : m_libraryPool;
+        if (pool.order.isEmpty()) {
+            // Nothing to fill with; what is left is breaks
+            if (nextBreak >= breaks.size() || breaks[nextBreak].at.toMSecsSinceEpoch() >= endMs) {
+                break;
+            }
+            nowMs = breaks[nextBreak].at.toMSecsSinceEpoch();
+            continue;
+        }
+
+        const Track& song = m_songs[pickSong(pool, nowMs)];
+        // A break due before the middle of the song is nearer its time before it
+        const qint64 middleMs = nowMs + airTimeMs(song.durationUs) / 2;
+        while (nextBreak < breaks.size() && breaks[nextBreak].at.toMSecsSinceEpoch() < middleMs
+               && nowMs < endMs) {
+            placeBreak();
+        }
+        if (nowMs >= endMs) {
+            break;
+        }
+
+        const QString artist = key(song.artist);
+        if (!artist.isEmpty()) {
+            m_artistAiredMs.insert(artist, nowMs);
+        }
+        m_titleAiredMs.insert(titleKey(song), nowMs);
+        place(Kind::Song, song.path, song.id, song.durationUs);
+        ++songsSinceJingle;
+    }
+    return log;
+}
+
+qint64 DayLogGenerator::parseDuration(const QString& text)
+{
+    const QStringList parts = text.trimmed().split(':');
+    if (parts.size() < 2 || parts.size() > 3) {
+        return -1;
+    }
+    qint64 seconds = 0;
+    for (const QString& part : parts) {
+        bool ok = false;
+        const int value = part.toInt(&ok);
+        if (!ok || value < 0) {
+            return -1;
+        }
+        seconds = seconds * 60 + value;
+    }
+    return seconds * 1000000;
+}
+
+int DayLogGenerator::pickSong(Pool& pool, qint64 atMs)
+{
+    const auto take = [&]() {
+        const int index = pool.order[pool.cursor++];
+        if (pool.cursor >= pool.order.size()) {
+            reshuffle(pool.order);
+            pool.cursor = 0;
+        }
+        return index;
+    };
+
+    // The rest of this round first, then a fresh round
+    for (int round = 0; round < 2; ++round) {
+        for (int i = pool.cursor; i < pool.order.size(); ++i) {
+            if (allowed(m_songs[pool.order[i]], atMs)) {
+                std::swap(pool.order[i], pool.order[pool.cursor]);
+                return take();
+            }
+        }
+        if (round == 0) {
+            reshuffle(pool.order);
+            pool.cursor = 0;
+        }
+    }
+
+    // Every song breaks a rule; the one that aired longest ago breaks it
+    // least, and of those by the same artist the one whose title did
+    const auto staleness = [this](const Track& song) {
+        return std::make_pair(lastAiredMs(song), m_titleAiredMs.value(titleKey(song), NEVER));
+    };
+    int best = pool.cursor;
+    for (int i = pool.cursor + 1; i < pool.order.size(); ++i) {
+        if (staleness(m_songs[pool.order[i]]) < staleness(m_songs[pool.order[best]])) {
+            best = i;
+        }
+    }
+    std::swap(pool.order[best], pool.order[pool.cursor]);
+    ++m_relaxedPicks;
+    return take();
+}
+
+bool DayLogGenerator::allowed(const Track& song, qint64 atMs) const
+{
+    const QString artist = key(song.artist);
+    if (!artist.isEmpty()
+        && atMs - m_artistAiredMs.value(artist, NEVER)
+               < qint64(m_rules.artistSeparationMinutes) * 60000) {
+        return false;
+    }
+    return atMs - m_titleAiredMs.value(titleKey(song), NEVER)
+           >= qint64(m_rules.titleSeparationMinutes) * 60000;
+}
+
+qint64 DayLogGenerator::lastAiredMs(const Track& song) const
+{
+    const QString artist = key(song.artist);
+    const qint64 titleMs = m_titleAiredMs.value(titleKey(song), NEVER);
+    return artist.isEmpty() ? titleMs : std::max(titleMs, m_artistAiredMs.value(artist, NEVER));
+}
+
+QString DayLogGenerator::titleKey(const Track& song)
+{
+    // Untitled songs are told apart by their file
+    return key(song.artist) + '\n' + (song.title.trimmed().isEmpty() ? song.path : key(song.title));
+}
+
+void DayLogGenerator::reshuffle(QVector<int>& order)
+{
+    for (int i = order.size() - 1; i > 0; --i) {
+        std::swap(order[i], order[m_random.bounded(i + 1)]);
+    }
+}
@@ -0,0 +1,169 @@
+#ifndef DAYLOGGENERATOR_H
+#define DAYLOGGENERATOR_H
+
+#include <QDateTime>
+#include <QHash>
+#include <QRandomGenerator>
+#include <QString>
+#include <QVector>
+#include <functional>
+
+/**
+ * @brief Plans a whole day of air time from hour clocks in one pass
+ *
+ * Auto mode picks one song at a time as the queue runs low, so a day can
+ * only be seen as it happens. DayLogGenerator plans a day ahead: for each
+ * hour it asks the clock which genre to play and how often a jingle goes
+ * in, places the pubs and programs of the scheduler nearest their time,
+ * and fills the rest with songs from the library given to setLibrary().
+ *
+ * Everything happens in memory: the library is indexed by genre once, and
+ * each genre is a shuffled pool that plays through before it repeats. A
+ * song is not placed while its artist aired less than
+ * Rules::artistSeparationMinutes before, or the same artist and title less
+ * than Rules::titleSeparationMinutes before. When a genre is too small for
+ * that, the song whose artist aired longest ago is placed anyway and
+ * counted in relaxedPicks(). A day of a library of tens of thousands of
+ * songs is planned in a few milliseconds.
+ *
+ * Start times are worked out from the durations given; songs whose
+ * duration is unknown count as DEFAULT_DURATION_US.
+ *
+ * @example
+ * @code
+ * DayLogGenerator generator;
+ * generator.setLibrary(songs);
+ * generator.setJingles(jingles);
+ * const QVector<DayLogGenerator::Item> log = generator.generate(
+ *     start, start.addDays(1),
+ *     [&](const QDateTime& hour) { return DayLogGenerator::HourClock{schedule.genreAt(hour), 4}; },
+ *     breaks);
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class DayLogGenerator
+{
+public:
+    enum class Kind {
+        Song,
+        Jingle,
+        Pub,
+        Program
+    };
+
+    struct Track {
+        int id = -1;              ///< Id in the musics table, -1 for jingles
+        QString path;
+        QString artist;
+        QString title;
+        QString genre;
+        qint64 durationUs = -1;   ///< -1 if unknown
+    };
+
+    /**
+     * @brief What an hour plays
+     */
+    struct HourClock {
+        QString genre;            ///< Genre of its songs; empty for the whole library
+        int jingleEvery = 0;      ///< Songs between two jingles, 0 for no jingles
+    };
+
+    /**
+     * @brief A pub or program that airs at a set time
+     */
+    struct Break {
+        QDateTime at;
+        QString path;
+        qint64 durationUs = -1;
+        bool isProgram = false;
+    };
+
+    struct Item {
+        QDateTime startsAt;
+        Kind kind = Kind::Song;
+        QString path;
+        int musicId = -1;
+        qint64 durationUs = -1;   ///< As given; -1 if unknown
+    };
+
+    struct Rules {
+        int artistSeparationMinutes = 60;
+        int titleSeparationMinutes = 180;
+    };
+
+    /// Called once per hour of the log with the start of that hour
+    using ClockForHour = std::function<HourClock(const QDateTime& hourStart)>;
+
+    static constexpr qint64 DEFAULT_DURATION_US = 210LL * 1000000;
+
+    DayLogGenerator();
+
+    /**
+     * @brief Set the songs to pick from and index them by genre
+     */
+    void setLibrary(const QVector<Track>& songs);
+
+    /**
+     * @brief Set the jingles, played in a shuffled rotation
+     */
+    void setJingles(const QVector<Track>& jingles);
+
+    void setRules(const Rules& rules) { m_rules = rules; }
+    Rules rules() const { return m_rules; }
+
+    /**
+     * @brief Seed the shuffles, for reproducible logs
+     */
+    void setSeed(quint32 seed) { m_random.seed(seed); }
+
+    /**
+     * @brief Plan the air time between two points
+     * @param from Start of the first item
+     * @param to The last item is the one that starts before this
+     * @param clock Clock of each hour; songs come from the whole library if null
+     * @param breaks Pubs and programs; each goes in at the boundary nearest its time
+     * @return Items in air order
+     */
+    QVector<Item> generate(const QDateTime& from, const QDateTime& to,
+                           const ClockForHour& clock = ClockForHour(),
+                           QVector<Break> breaks = QVector<Break>());
+
+    /**
+     * @brief Songs of the last log placed although they broke a separation rule
+     */
+    int relaxedPicks() const { return m_relaxedPicks; }
+
+    /**
+     * @brief Read a duration as the musics.time column stores it, "H:MM:SS" or "MM:SS"
+     * @return Microseconds, or -1 if the text is not a duration
+     */
+    static qint64 parseDuration(const QString& text);
+
+private:
+    struct Pool {
+        QVector<int> order;   ///< Indices into m_songs
+        int cursor = 0;
+    };
+
+    int pickSong(Pool& pool, qint64 atMs);
+    bool allowed(const Track& song, qint64 atMs) const;
+    qint64 lastAiredMs(const Track& song) const;
+    void reshuffle(QVector<int>& order);
+    static QString key(const QString& text) { return text.trimmed().toCaseFolded(); }
+    static QString titleKey(const Track& song);
+
+    QVector<Track> m_songs;
+    QVector<Track> m_jingles;
+    Pool m_libraryPool;
+    QHash<QString, Pool> m_genrePools;
+    QVector<int> m_jingleOrder;
+    int m_jingleCursor = 0;
+    QHash<QString, qint64> m_artistAiredMs;
+    QHash<QString, qint64> m_titleAiredMs;
+    Rules m_rules;
+    QRandomGenerator m_random;
+    int m_relaxedPicks = 0;
+};
+
+#endif // DAYLOGGENERATOR_H
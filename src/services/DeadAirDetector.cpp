@@ -0,0 +1,134 @@
+#include "DeadAirDetector.h"
+#include <QDebug>
+#include <QTimer>
+#include <cmath>
+
+DeadAirDetector::DeadAirDetector(QObject* parent)
+    : QObject(parent)
+    , m_timer(new QTimer(this))
+{
+    setThresholdDb(DEFAULT_THRESHOLD_DB);
+    m_timer->setInterval(CHECK_INTERVAL_MS);
+    connect(m_timer, &QTimer::timeout, this, &DeadAirDetector::check);
+    m_clock.start();
+    m_timer->start();
+}
+
+void DeadAirDetector::setThresholdDb(double db)
+{
+    m_thresholdDb = db;
+    const double level = std::pow(10.0, db / 20.0);
+    m_thresholdSquared.store(float(level * level), std::memory_order_relaxed);
+}
+
+void DeadAirDetector::setFormat(Source source, int sampleRate, int channels)
+{
+    Monitor& m = monitor(source);
+    m.sampleRate.store(qMax(0, sampleRate), std::memory_order_relaxed);
+    m.channels.store(qMax(1, channels), std::memory_order_relaxed);
+}
+
+void DeadAirDetector::setArmed(Source source, bool armed)
+{
+    Monitor& m = monitor(source);
+    if (armed == m.armed.load(std::memory_order_relaxed)) {
+        return;
+    }
+    m.silentFrames.store(0, std::memory_order_relaxed);
+    m.lastFrames = m.frames.load(std::memory_order_relaxed);
+    m.lastSilentFrames = 0;
+    m.stalledMs = 0;
+    m.lastSilentMs = 0;
+    m.alarmed = false;
+    m.armed.store(armed, std::memory_order_release);
+}
+
+bool DeadAirDetector::isArmed(Source source) const
+{
+    return monitor(source).armed.load(std::memory_order_acquire);
+}
+
+void DeadAirDetector::process(Source source, const float* samples, int count)
+{
+    Monitor& m = monitor(source);
+    if (!m.armed.load(std::memory_order_relaxed) || count <= 0) {
+        return;
+    }
+
+    // Four accumulators so the compiler can keep them in one vector register
+    float sums[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        sums[0] += samples[i] * samples[i];
+        sums[1] += samples[i + 1] * samples[i + 1];
+        sums[2] += samples[i + 2] * samples[i + 2];
+        sums[3] += samples[i + 3] * samples[i + 3];
+    }
+    for (; i < count; ++i) {
+        sums[0] += samples[i] * samples[i];
+    }
+    const float sumSquares = (sums[0] + sums[1]) + (sums[2] + sums[3]);
+    const float threshold = m_thresholdSquared.load(std::memory_order_relaxed);
+
+    // The silence count goes first; check() reads the frame count first
+    const qint64 frames = count / m.channels.load(std::memory_order_relaxed);
+    if (sumSquares < threshold * float(count)) {
+        m.silentFrames.fetch_add(frames, std::memory_order_relaxed);
+    } else {
+        m.silentFrames.store(0, std::memory_order_relaxed);
+    }
+    m.frames.fetch_add(frames, std::memory_order_release);
+}
+
+qint64 DeadAirDetector::silentMs(Source source) const
+{
+    const Monitor& m = monitor(source);
+    if (!m.armed.load(std::memory_order_acquire)) {
+        return 0;
+    }
+    const int rate = m.sampleRate.load(std::memory_order_relaxed);
+    const qint64 silentFrames = m.silentFrames.load(std::memory_order_relaxed);
+    return (rate > 0 ? silentFrames * 1000 / rate : 0) + m.stalledMs;
+}
+
+bool DeadAirDetector::isDeadAir(Source source) const
+{
+    return monitor(source).alarmed;
+}
+
+void DeadAirDetector::check()
+{
+    const qint64 elapsedMs = m_clock.restart();
+    for (int i = 0; i < SOURCE_COUNT; ++i) {
+        const Source source = static_cast<Source>(i);
+        Monitor& m = monitor(source);
+        if (!m.armed.load(std::memory_order_acquire)) {
+            continue;
+        }
+
+        const qint64 frames = m.frames.load(std::memory_order_acquire);
+        const qint64 silentFrames = m.silentFrames.load(std::memory_order_relaxed);
+        const qint64 delta = frames - m.lastFrames;
+        if (delta == 0) {
+            m.stalledMs += elapsedMs;
+        } else if (silentFrames < m.lastSilentFrames + delta) {
+            // Something audible arrived since the last check
+            m.stalledMs = 0;
+        }
+        m.lastFrames = frames;
+        m.lastSilentFrames = silentFrames;
+
+        const qint64 silence = silentMs(source);
+        if (!m.alarmed && silence >= m_silenceMs) {
+            m.alarmed = true;
+            qWarning() << "DeadAirDetector:" << source << "silent for" << silence << "ms";
+            emit deadAir(source, silence);
+        } else if (m.alarmed && silence < m.lastSilentMs) {
+            m.alarmed = false;
+            qInfo() << "DeadAirDetector:" << source << "audible again after"
+                    << m.lastSilentMs << "ms";
+            emit recovered(source, m.lastSilentMs);
+        }
+        m.lastSilentMs = silence;
+    }
+}
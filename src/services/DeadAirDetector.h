@@ -0,0 +1,166 @@
+#ifndef DEADAIRDETECTOR_H
+#define DEADAIRDETECTOR_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <array>
+#include <atomic>
+
+class QTimer;
+
+/**
+ * @brief Raises an alarm when the output or the live input goes silent
+ *
+ * Dead air used to go unnoticed until a listener called. DeadAirDetector
+ * watches two sources: the mixed output, fed by DeckMixer, and the live
+ * input, fed by LiveCapture. The audio thread passes each block to
+ * process(). It sums the squares of the samples in one pass and compares
+ * the block's RMS level with thresholdDb(). Silent frames are counted in
+ * an atomic, and an audible block resets the count. process() does not
+ * allocate, lock or emit, so it adds no latency to the audio thread.
+ *
+ * A timer on the detector's thread looks at the counts every
+ * CHECK_INTERVAL_MS. When an armed source has been silent for
+ * silenceSeconds(), deadAir() is emitted once; recovered() follows when
+ * audio comes back. A source whose audio stops arriving altogether, such
+ * as a stalled sink, counts as silent too.
+ *
+ * Only armed sources are watched, so a deliberate stop or pause does not
+ * raise the alarm. Arming starts the count over.
+ *
+ * @example
+ * @code
+ * DeadAirDetector* detector = new DeadAirDetector(this);
+ * detector->setSilenceSeconds(10);
+ * detector->setFormat(DeadAirDetector::Source::Output, 48000, 2);
+ * detector->setArmed(DeadAirDetector::Source::Output, true);
+ * detector->process(DeadAirDetector::Source::Output, samples, count);   // audio thread
+ * connect(detector, &DeadAirDetector::deadAir, this, &Player::playNextSong);
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class DeadAirDetector : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Audio that is watched
+     */
+    enum class Source {
+        Output,   ///< What the decks send to air
+        Input,    ///< The live input
+    };
+    Q_ENUM(Source)
+    static constexpr int SOURCE_COUNT = 2;
+
+    static constexpr double DEFAULT_THRESHOLD_DB = -50.0;
+    static constexpr int DEFAULT_SILENCE_SECONDS = 10;
+    static constexpr int CHECK_INTERVAL_MS = 250;
+
+    explicit DeadAirDetector(QObject* parent = nullptr);
+
+    /**
+     * @brief Set the level below which a block is silent
+     * @param db RMS level in dBFS
+     */
+    void setThresholdDb(double db);
+    double thresholdDb() const { return m_thresholdDb; }
+
+    /**
+     * @brief Set how long silence lasts before it is dead air
+     * @param seconds Length of the silence, at least one second
+     */
+    void setSilenceSeconds(int seconds) { m_silenceMs = qint64(qMax(1, seconds)) * 1000; }
+    int silenceSeconds() const { return int(m_silenceMs / 1000); }
+
+    /**
+     * @brief Set the format of the samples a source is fed
+     * @param source Source
+     * @param sampleRate Rate in Hz
+     * @param channels Channels per interleaved frame
+     */
+    void setFormat(Source source, int sampleRate, int channels);
+
+    /**
+     * @brief Start or stop watching a source
+     *
+     * Arming starts the silence count over; disarming ends an alarm
+     * without recovered().
+     * @param source Source
+     * @param armed true to watch it
+     */
+    void setArmed(Source source, bool armed);
+    bool isArmed(Source source) const;
+
+    /**
+     * @brief Measure a block of a source
+     *
+     * Never blocks or allocates; may be called from one thread per source.
+     * @param source Source of the samples
+     * @param samples Interleaved float samples
+     * @param count Number of samples, whole frames
+     */
+    void process(Source source, const float* samples, int count);
+
+    /**
+     * @brief Get how long a source has been silent
+     * @param source Source
+     * @return Silence in ms, counting time in which no audio arrived
+     */
+    qint64 silentMs(Source source) const;
+
+    /**
+     * @brief Check if the alarm is raised for a source
+     */
+    bool isDeadAir(Source source) const;
+
+    /**
+     * @brief Look at the silence counts now rather than on the next tick
+     */
+    void check();
+
+signals:
+    /**
+     * @brief Emitted once when an armed source has been silent for silenceSeconds()
+     * @param source Source that went silent
+     * @param silentMs How long it has been silent
+     */
+    void deadAir(DeadAirDetector::Source source, qint64 silentMs);
+
+    /**
+     * @brief Emitted when audio comes back after deadAir()
+     * @param source Source that recovered
+     * @param silentMs How long the silence lasted
+     */
+    void recovered(DeadAirDetector::Source source, qint64 silentMs);
+
+private:
+    struct Monitor {
+        std::atomic<bool> armed{false};
+        std::atomic<int> sampleRate{0};
+        std::atomic<int> channels{2};
+        std::atomic<qint64> frames{0};           ///< Frames measured
+        std::atomic<qint64> silentFrames{0};     ///< Frames since the last audible block
+
+        // Detector thread only
+        qint64 lastFrames = 0;
+        qint64 lastSilentFrames = 0;
+        qint64 stalledMs = 0;      ///< Time no frame arrived, since the last audible block
+        qint64 lastSilentMs = 0;   ///< Silence at the last check()
+        bool alarmed = false;
+    };
+
+    Monitor& monitor(Source source) { return m_monitors[static_cast<int>(source)]; }
+    const Monitor& monitor(Source source) const { return m_monitors[static_cast<int>(source)]; }
+
+    double m_thresholdDb = DEFAULT_THRESHOLD_DB;
+    std::atomic<float> m_thresholdSquared{0.0f};   ///< Mean square level of the threshold
+    qint64 m_silenceMs = qint64(DEFAULT_SILENCE_SECONDS) * 1000;
+    std::array<Monitor, SOURCE_COUNT> m_monitors;
+    QTimer* m_timer;
+    QElapsedTimer m_clock;   ///< Time since the last check()
+};
+
+#endif // DEADAIRDETECTOR_H
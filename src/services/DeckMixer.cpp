@@ -0,0 +1,910 @@
+#include "DeckMixer.h"
+#include "AudioDeck.h"
+#include "CartWall.h"
+#include "DeadAirDetector.h"
+#include "MicDucker.h"
+#include <QAudioDevice>
+#include <QDebug>
+#include <QMediaDevices>
+#include <QTimer>
+#include <QtMultimedia/QAudioSink>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+constexpr float HALF_PI = 1.57079632679f;
+
+} // namespace
+
+DeckMixer::DeckMixer(QObject* parent)
+    : QIODevice(parent)
+{
+    // Sized for the highest rate a sink is likely to pick; not resized later
+    // because the readers may be active on other threads
+    for (TapBuffer& tap : m_taps) {
+        tap.buffer.resize(TAP_SAMPLE_RATE * AudioDeck::CHANNELS * TAP_CAPACITY_MS / 1000);
+    }
+}
+
+qint64 DeckMixer::bufferMemoryUsage() const
+{
+    const qint64 tapSamples = qint64(TAP_COUNT) * TAP_SAMPLE_RATE * AudioDeck::CHANNELS
+                              * TAP_CAPACITY_MS / 1000;
+    const qint64 deckSamples = 2LL * sampleRate() * AudioDeck::CHANNELS * AudioDeck::RING_SECONDS;
+    return (tapSamples + deckSamples) * qint64(sizeof(float));
+}
+
+NativeAudioOutput::Statistics DeckMixer::nativeStatistics() const
+{
+    NativeAudioOutput::Statistics statistics;
+    statistics.xruns = m_nativeXruns.load(std::memory_order_relaxed);
+    statistics.periodsWritten = m_nativePeriodsWritten.load(std::memory_order_relaxed);
+    statistics.periodFrames = m_nativePeriodFrames.load(std::memory_order_relaxed);
+    statistics.periods = m_nativePeriods.load(std::memory_order_relaxed);
+    statistics.sampleRate = sampleRate();
+    if (statistics.sampleRate > 0) {
+        statistics.latencyMs =
+            double(statistics.periodFrames) * statistics.periods * 1000.0 / statistics.sampleRate;
+    }
+    return statistics;
+}
+
+DeckMixer::~DeckMixer()
+{
+    shutdown();
+}
+
+qint64 DeckMixer::bytesAvailable() const
+{
+    // The mixer always produces audio (silence when nothing is on air)
+    return QIODevice::bytesAvailable() + m_format.bytesForDuration(100000);
+}
+
+void DeckMixer::initialize()
+{
+    if (isOpen()) {
+        return;
+    }
+
+    const QAudioDevice device = m_headlessSpeed > 0 ? QAudioDevice() : findOutput(m_deviceName);
+    const int preferredRate = device.preferredFormat().sampleRate();
+
+    m_format.setSampleRate(preferredRate > 0 ? preferredRate : DEFAULT_SAMPLE_RATE);
+    m_format.setChannelCount(AudioDeck::CHANNELS);
+    m_format.setSampleFormat(QAudioFormat::Float);
+    if (m_headlessSpeed <= 0 && !device.isFormatSupported(m_format)) {
+        m_format.setSampleFormat(QAudioFormat::Int16);
+    }
+    m_sampleRate.store(m_format.sampleRate(), std::memory_order_relaxed);
+
+    for (int i = 0; i < 2; ++i) {
+        m_decks[i] = new AudioDeck(m_format.sampleRate(), this);
+        m_decks[i]->setPrefetcher(m_prefetcher);
+        connect(m_decks[i], &AudioDeck::errorOccurred, this,
+                [this](const QString& filePath, const QString& message) {
+                    emit errorOccurred(QString("%1: %2").arg(filePath, message));
+                });
+    }
+
+    open(QIODevice::ReadOnly);
+
+    if (m_headlessSpeed > 0) {
+        m_clock = new QTimer(this);
+        m_clock->setTimerType(Qt::PreciseTimer);
+        m_clock->setInterval(qMax(1, qRound(HEADLESS_BLOCK_MS / m_headlessSpeed)));
+        connect(m_clock, &QTimer::timeout, this, &DeckMixer::pullHeadless);
+        qDebug() << "DeckMixer: headless output" << m_format.sampleRate() << "Hz at"
+                 << m_headlessSpeed << "times real time";
+        return;
+    }
+
+    if (m_nativeConfig.periodFrames > 0 && openNative()) {
+        return;
+    }
+    m_sink = new QAudioSink(device, m_format, this);
+    m_sink->setBufferSize(m_format.bytesForDuration(200000));
+    qDebug() << "DeckMixer: output" << device.description() << m_format.sampleRate() << "Hz"
+             << m_format.sampleFormat();
+}
+
+void DeckMixer::createSink()
+{
+    const QAudioDevice device = findOutput(m_deviceName);
+    m_format.setSampleFormat(QAudioFormat::Float);
+    if (!device.isFormatSupported(m_format)) {
+        m_format.setSampleFormat(QAudioFormat::Int16);
+    }
+    m_sink = new QAudioSink(device, m_format, this);
+    m_sink->setBufferSize(m_format.bytesForDuration(200000));
+    qDebug() << "DeckMixer: output" << device.description() << m_format.sampleRate() << "Hz"
+             << m_format.sampleFormat();
+}
+
+void DeckMixer::setNativeOutput(const NativeAudioOutput::Config& config)
+{
+    const bool enabled = config.periodFrames > 0 && !config.device.isEmpty();
+    m_nativeConfig = config;
+    if (!enabled) {
+        m_nativeConfig.periodFrames = 0;
+    }
+    if (!isOpen() || m_clock) {
+        return;
+    }
+
+    // Reopened even with the same config, which is how a failed device is retried
+    const bool running = m_state == State::Playing || m_cartOutput;
+    closeNative();
+    delete m_sink;
+    m_sink = nullptr;
+    if (!enabled || !openNative()) {
+        createSink();
+    }
+    if (running) {
+        ensureSinkRunning();
+    }
+}
+
+bool DeckMixer::openNative()
+{
+    NativeAudioOutput::Config config = m_nativeConfig;
+    config.sampleRate = m_format.sampleRate();
+    auto native = std::make_unique<NativeAudioOutput>();
+    if (!native->open(config)) {
+        emit errorOccurred(QString("The native output could not be opened, playing through Qt: %1")
+                               .arg(native->errorString()));
+        return false;
+    }
+
+    m_native = std::move(native);
+    m_format.setSampleFormat(QAudioFormat::Float);
+    m_nativeXrunsSeen = 0;
+    const NativeAudioOutput::Statistics statistics = m_native->statistics();
+    m_nativePeriodFrames.store(statistics.periodFrames, std::memory_order_relaxed);
+    m_nativePeriods.store(statistics.periods, std::memory_order_relaxed);
+    if (!m_nativePump) {
+        m_nativePump = new QTimer(this);
+        m_nativePump->setInterval(0);
+        connect(m_nativePump, &QTimer::timeout, this, &DeckMixer::pumpNative);
+    }
+    if (!NativeAudioOutput::raiseThreadPriority()) {
+        qWarning() << "DeckMixer: no real-time priority for the native output; allow rtprio";
+    }
+    qDebug() << "DeckMixer: native output" << config.device << statistics.sampleRate << "Hz,"
+             << statistics.periods << "periods of" << statistics.periodFrames << "frames,"
+             << statistics.latencyMs << "ms";
+    return true;
+}
+
+void DeckMixer::closeNative()
+{
+    if (m_nativePump) {
+        m_nativePump->stop();
+    }
+    m_native.reset();
+    m_nativePeriodFrames.store(0, std::memory_order_relaxed);
+    m_nativePeriods.store(0, std::memory_order_relaxed);
+}
+
+void DeckMixer::pumpNative()
+{
+    // One period per tick, so commands queued meanwhile run between periods
+    NativeAudioOutput* native = m_native.get();
+    const bool written = native->writePeriod([this](float* out, int frames) {
+        readData(reinterpret_cast<char*>(out), qint64(frames) * m_format.bytesPerFrame());
+    });
+    const qint64 xruns = native->statistics().xruns;
+    m_nativeXruns.fetch_add(xruns - m_nativeXrunsSeen, std::memory_order_relaxed);
+    m_nativeXrunsSeen = xruns;
+    if (written) {
+        m_nativePeriodsWritten.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    emit errorOccurred(QString("The native output failed, playing through Qt: %1")
+                           .arg(native->errorString()));
+    closeNative();
+    createSink();
+    if (m_state == State::Playing || m_cartOutput) {
+        ensureSinkRunning();
+    }
+}
+
+QAudioDevice DeckMixer::findOutput(const QString& name)
+{
+    if (!name.isEmpty()) {
+        const QList<QAudioDevice> outputs = QMediaDevices::audioOutputs();
+        for (const QAudioDevice& device : outputs) {
+            if (QString::fromUtf8(device.id()) == name || device.description() == name) {
+                return device;
+            }
+        }
+        qWarning() << "DeckMixer: output device" << name << "not found, using the default";
+    }
+    return QMediaDevices::defaultAudioOutput();
+}
+
+void DeckMixer::setOutputDevice(const QString& name)
+{
+    if (m_sink && name == m_deviceName) {
+        return;
+    }
+    m_deviceName = name;
+    // The native output has a device of its own; this one is for going back to Qt
+    if (!m_sink) {
+        return;
+    }
+
+    // The decks run at the rate picked at start, so only the sample format may change
+    const QAudioDevice device = findOutput(name);
+    QAudioFormat format = m_format;
+    format.setSampleFormat(QAudioFormat::Float);
+    if (!device.isFormatSupported(format)) {
+        format.setSampleFormat(QAudioFormat::Int16);
+    }
+    if (!device.isFormatSupported(format)) {
+        emit errorOccurred(QString("%1 cannot play %2 Hz; the output was not moved")
+                               .arg(device.description())
+                               .arg(m_format.sampleRate()));
+        return;
+    }
+
+    const QAudio::State state = m_sink->state();
+    delete m_sink;
+    m_format = format;
+    m_sink = new QAudioSink(device, m_format, this);
+    m_sink->setBufferSize(m_format.bytesForDuration(200000));
+    if (state == QAudio::ActiveState || state == QAudio::IdleState) {
+        m_sink->start(this);
+    } else if (state == QAudio::SuspendedState) {
+        m_sink->start(this);
+        m_sink->suspend();
+    }
+    qDebug() << "DeckMixer: output moved to" << device.description();
+}
+
+bool DeckMixer::post(Command command)
+{
+    if (!m_commands.push(std::move(command))) {
+        qWarning() << "DeckMixer: command dropped, the audio thread is not taking commands";
+        return false;
+    }
+    // One wake-up covers everything queued until processCommands() runs
+    if (!m_commandsWoken.exchange(true, std::memory_order_acq_rel)) {
+        QMetaObject::invokeMethod(this, &DeckMixer::processCommands, Qt::QueuedConnection);
+    }
+    return true;
+}
+
+void DeckMixer::processCommands()
+{
+    m_commandsWoken.store(false, std::memory_order_release);
+
+    // A seek is held back while more seeks follow it: scrubbing the
+    // position slider plays only where the handle was let go
+    Command command;
+    Command seek;
+    while (m_commands.pop(command)) {
+        if (command.type == Command::Type::Seek) {
+            seek = std::move(command);
+            continue;
+        }
+        if (seek.type == Command::Type::Seek) {
+            execute(seek);
+            seek = Command();
+        }
+        execute(command);
+    }
+    if (seek.type == Command::Type::Seek) {
+        execute(seek);
+    }
+}
+
+void DeckMixer::execute(const Command& command)
+{
+    switch (command.type) {
+    case Command::Type::None:
+        break;
+    case Command::Type::Play:
+        play(command.filePath, command.cueInMs, command.cueOutMs, command.gain);
+        break;
+    case Command::Type::QueueNext:
+        queueNext(command.filePath, command.cueInMs, command.cueOutMs, command.gain);
+        break;
+    case Command::Type::ClearNext:
+        clearNext();
+        break;
+    case Command::Type::SkipToNext:
+        skipToNext();
+        break;
+    case Command::Type::Stop:
+        stop();
+        break;
+    case Command::Type::Pause:
+        pause();
+        break;
+    case Command::Type::Resume:
+        resume();
+        break;
+    case Command::Type::Seek:
+        seek(command.positionMs);
+        break;
+    case Command::Type::StartCarts:
+        startCartOutput();
+        break;
+    case Command::Type::Volume:
+        setVolume(command.gain, command.rampMs, command.curve, command.fromGain);
+        break;
+    }
+}
+
+void DeckMixer::report(Status status)
+{
+    // Dropped when the owner has stopped reading; nothing here may wait
+    m_statuses.push(std::move(status));
+}
+
+void DeckMixer::shutdown()
+{
+    if (!isOpen()) {
+        return;
+    }
+
+    stop();
+    closeNative();
+    delete m_nativePump;
+    m_nativePump = nullptr;
+    delete m_sink;
+    m_sink = nullptr;
+    delete m_clock;
+    m_clock = nullptr;
+    close();
+}
+
+void DeckMixer::play(const QString& filePath, qint64 cueInMs, qint64 cueOutMs, float gain)
+{
+    if (!isOpen()) {
+        return;
+    }
+
+    m_fading = false;
+    m_deferredNext.clear();
+    incoming()->unload();
+    onAir()->load(filePath, cueInMs, cueOutMs, gain);
+    m_nextRequested = false;
+    m_lastReportedDuration = -1;
+
+    setState(State::Playing);
+    ensureSinkRunning();
+    Status started;
+    started.kind = Status::Kind::TrackStarted;
+    started.filePath = filePath;
+    report(std::move(started));
+    reportPosition(true);
+}
+
+void DeckMixer::queueNext(const QString& filePath, qint64 cueInMs, qint64 cueOutMs, float gain)
+{
+    if (!isOpen()) {
+        return;
+    }
+
+    // The incoming deck is busy until the running transition completes
+    if (m_fading) {
+        m_deferredNext = filePath;
+        m_deferredCueInMs = cueInMs;
+        m_deferredCueOutMs = cueOutMs;
+        m_deferredGain = gain;
+        return;
+    }
+    incoming()->load(filePath, cueInMs, cueOutMs, gain);
+}
+
+void DeckMixer::clearNext()
+{
+    if (!isOpen()) {
+        return;
+    }
+
+    m_deferredNext.clear();
+    if (!m_fading) {
+        incoming()->unload();
+    }
+}
+
+void DeckMixer::skipToNext()
+{
+    if (!isOpen() || m_state == State::Stopped) {
+        return;
+    }
+
+    if (m_fading) {
+        finishFade();
+    }
+
+    if (incoming()->state() == AudioDeck::State::Empty) {
+        stop();
+        Status finished;
+        finished.kind = Status::Kind::PlaybackFinished;
+        report(finished);
+        return;
+    }
+
+    const qint64 crossfadeFrames = qint64(crossfadeMs()) * m_format.sampleRate() / 1000;
+    if (crossfadeFrames > 0) {
+        m_fading = true;
+        m_fadeFrames = crossfadeFrames;
+        m_fadePosition = 0;
+        Status started;
+        started.kind = Status::Kind::TrackStarted;
+        started.filePath = incoming()->source();
+        report(std::move(started));
+    } else {
+        switchToIncoming();
+    }
+}
+
+void DeckMixer::stop()
+{
+    if (!isOpen()) {
+        return;
+    }
+
+    m_fading = false;
+    m_deferredNext.clear();
+    m_decks[0]->unload();
+    m_decks[1]->unload();
+    if (cartsPlaying()) {
+        m_cartOutput = true;
+    } else {
+        stopOutput();
+    }
+
+    setState(State::Stopped);
+    reportPosition(true);
+}
+
+void DeckMixer::pause()
+{
+    if (isOpen() && m_state == State::Playing) {
+        suspendOutput();
+        setState(State::Paused);
+    }
+}
+
+void DeckMixer::resume()
+{
+    if (isOpen() && m_state == State::Paused) {
+        if (m_sink) {
+            m_sink->resume();
+        } else if (m_native) {
+            ensureSinkRunning();
+        }
+        setState(State::Playing);
+    }
+}
+
+void DeckMixer::startCartOutput()
+{
+    if (!isOpen() || m_state == State::Playing) {
+        return;
+    }
+    m_cartOutput = true;
+    ensureSinkRunning();
+}
+
+void DeckMixer::setVolume(float volume, int rampMs, GainRamp::Curve curve, float fromVolume)
+{
+    volume = qBound(0.0f, volume, 1.0f);
+    m_volume.store(volume, std::memory_order_relaxed);
+    if (fromVolume >= 0.0f) {
+        m_gain.setGain(qBound(0.0f, fromVolume, 1.0f));
+    }
+    m_gain.rampTo(volume, qint64(qMax(0, rampMs)) * m_format.sampleRate() / 1000, curve);
+}
+
+bool DeckMixer::cartsPlaying() const
+{
+    const CartWall* carts = m_carts.load(std::memory_order_acquire);
+    return carts && !carts->isIdle();
+}
+
+void DeckMixer::stopCartOutput()
+{
+    if (m_cartOutput || m_state == State::Playing) {
+        return;
+    }
+    if (m_state == State::Paused) {
+        suspendOutput();
+    } else if (m_state == State::Stopped) {
+        stopOutput();
+    }
+}
+
+void DeckMixer::seek(qint64 positionMs)
+{
+    if (!isOpen() || onAir()->state() == AudioDeck::State::Empty) {
+        return;
+    }
+
+    if (m_fading) {
+        finishFade();
+    }
+
+    onAir()->load(onAir()->source(), positionMs, onAir()->endMs(), onAir()->gain());
+    reportPosition(true);
+}
+
+qint64 DeckMixer::readData(char* data, qint64 maxSize)
+{
+    const int bytesPerFrame = m_format.bytesPerFrame();
+    const int frames = bytesPerFrame > 0 ? static_cast<int>(maxSize / bytesPerFrame) : 0;
+    if (frames <= 0) {
+        return 0;
+    }
+
+    MetricsRegistry::Histogram* renderTime = m_renderTime.load(std::memory_order_acquire);
+    const auto renderStart = renderTime ? std::chrono::steady_clock::now()
+                                        : std::chrono::steady_clock::time_point();
+
+    const int samples = frames * AudioDeck::CHANNELS;
+    if (m_mixBuffer.size() < samples) {
+        m_mixBuffer.resize(samples);
+    }
+    float* mixed = m_mixBuffer.data();
+    std::fill(mixed, mixed + samples, 0.0f);
+
+    if (m_state == State::Playing) {
+        mix(mixed, frames);
+        m_framesSinceReport += frames;
+
+        const AudioDeck* deck = onAir();
+        const int capacity = deck->capacityFrames();
+        int fill = 100;
+        if (deck->state() != AudioDeck::State::Drained && capacity > 0) {
+            fill = int(qint64(deck->bufferedFrames()) * 100 / capacity);
+        }
+        m_bufferFill.store(fill, std::memory_order_relaxed);
+    } else {
+        m_bufferFill.store(-1, std::memory_order_relaxed);
+    }
+    if (MicDucker* ducker = m_ducker.load(std::memory_order_acquire)) {
+        ducker->process(mixed, frames, AudioDeck::CHANNELS, m_format.sampleRate());
+    }
+    if (CartWall* carts = m_carts.load(std::memory_order_acquire)) {
+        carts->render(mixed, frames, m_format.sampleRate());
+        if (m_cartOutput && carts->isIdle()) {
+            m_cartOutput = false;
+            QMetaObject::invokeMethod(this, [this]() { stopCartOutput(); }, Qt::QueuedConnection);
+        }
+    }
+
+    m_gain.process(mixed, frames, AudioDeck::CHANNELS);
+    if (m_format.sampleFormat() == QAudioFormat::Float) {
+        std::memcpy(data, mixed, sizeof(float) * samples);
+    } else {
+        qint16* out = reinterpret_cast<qint16*>(data);
+        for (int i = 0; i < samples; ++i) {
+            const float value = std::clamp(mixed[i], -1.0f, 1.0f);
+            out[i] = static_cast<qint16>(std::lround(value * 32767.0f));
+        }
+    }
+
+    if (DeadAirDetector* detector = m_deadAir.load(std::memory_order_acquire)) {
+        detector->process(DeadAirDetector::Source::Output, mixed, samples);
+    }
+
+    for (TapBuffer& tap : m_taps) {
+        if (!tap.enabled.load(std::memory_order_relaxed)) {
+            continue;
+        }
+        // Whole frames only, so the reader never sees the channels swap
+        const int room =
+            tap.buffer.availableToWrite() / AudioDeck::CHANNELS * AudioDeck::CHANNELS;
+        tap.buffer.write(mixed, std::min(samples, room));
+    }
+
+    if (m_state == State::Playing) {
+        // Ask for the following item early enough to pre-decode it
+        const qint64 leadFrames =
+            qint64(crossfadeMs() + QUEUE_LEAD_MS) * m_format.sampleRate() / 1000;
+        const qint64 remaining = onAir()->remainingFrames();
+        if (!m_nextRequested && !m_fading && m_deferredNext.isEmpty() &&
+            incoming()->state() == AudioDeck::State::Empty &&
+            (remaining < 0 || remaining <= leadFrames)) {
+            m_nextRequested = true;
+            Status request;
+            request.kind = Status::Kind::NextTrackRequested;
+            report(request);
+        }
+        reportPosition();
+    }
+
+    if (renderTime) {
+        renderTime->record(std::chrono::duration_cast<std::chrono::microseconds>(
+                               std::chrono::steady_clock::now() - renderStart)
+                               .count());
+    }
+    return qint64(frames) * bytesPerFrame;
+}
+
+void DeckMixer::setTapEnabled(bool enabled, Tap tap)
+{
+    TapBuffer& buffer = m_taps[static_cast<int>(tap)];
+    if (enabled && !buffer.enabled.load(std::memory_order_relaxed)) {
+        buffer.reset.store(true, std::memory_order_relaxed);
+    }
+    buffer.enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool DeckMixer::isTapEnabled(Tap tap) const
+{
+    return m_taps[static_cast<int>(tap)].enabled.load(std::memory_order_relaxed);
+}
+
+int DeckMixer::readTap(float* data, int samples, Tap tap)
+{
+    TapBuffer& buffer = m_taps[static_cast<int>(tap)];
+    // clear() is not safe while the mixer writes; drop from the reading side
+    if (buffer.reset.exchange(false, std::memory_order_relaxed)) {
+        buffer.buffer.skip(buffer.buffer.availableToRead());
+    }
+    const int frames = std::min(samples, buffer.buffer.availableToRead()) / AudioDeck::CHANNELS;
+    return buffer.buffer.read(data, frames * AudioDeck::CHANNELS);
+}
+
+qint64 DeckMixer::writeData(const char* data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
+
+void DeckMixer::mix(float* out, int frames)
+{
+    const qint64 crossfadeFrames = qint64(crossfadeMs()) * m_format.sampleRate() / 1000;
+    int done = 0;
+
+    while (done < frames && m_state == State::Playing) {
+        float* dst = out + done * AudioDeck::CHANNELS;
+        int want = frames - done;
+
+        if (m_fading) {
+            done += mixFade(dst, want);
+            continue;
+        }
+
+        AudioDeck* current = onAir();
+        if (!current->isActive()) {
+            // The on-air track has ended: splice the next one in without a gap
+            if (incoming()->isActive()) {
+                switchToIncoming();
+                continue;
+            }
+
+            current->unload();
+            setState(State::Stopped);
+            QMetaObject::invokeMethod(
+                this,
+                [this]() {
+                    if (m_state != State::Stopped) {
+                        return;
+                    }
+                    if (cartsPlaying()) {
+                        m_cartOutput = true;
+                    } else {
+                        stopOutput();
+                    }
+                },
+                Qt::QueuedConnection);
+            Status finished;
+            finished.kind = Status::Kind::PlaybackFinished;
+            report(finished);
+            break;
+        }
+
+        const qint64 remaining = current->remainingFrames();
+        if (crossfadeFrames > 0 && incoming()->isActive() && remaining >= 0) {
+            if (remaining <= crossfadeFrames) {
+                // Start the transition so it ends on the outgoing track's last sample
+                m_fading = true;
+                m_fadeFrames = remaining > 0 ? remaining : crossfadeFrames;
+                m_fadePosition = 0;
+                Status started;
+                started.kind = Status::Kind::TrackStarted;
+                started.filePath = incoming()->source();
+                report(std::move(started));
+                continue;
+            }
+            want = static_cast<int>(qMin<qint64>(want, remaining - crossfadeFrames));
+        }
+
+        const int got = current->read(dst, want);
+        done += got;
+        if (got < want && current->isActive()) {
+            break; // Decoder underrun; the rest of this buffer stays silent
+        }
+    }
+}
+
+int DeckMixer::mixFade(float* out, int frames)
+{
+    const int count = static_cast<int>(qMin<qint64>(frames, m_fadeFrames - m_fadePosition));
+    if (count <= 0) {
+        finishFade();
+        return 0;
+    }
+
+    const int samples = count * AudioDeck::CHANNELS;
+    if (m_deckBuffer.size() < samples) {
+        m_deckBuffer.resize(samples);
+    }
+    float* deck = m_deckBuffer.data();
+    const float span = static_cast<float>(m_fadeFrames);
+
+    // Equal-power curves keep the perceived loudness constant across the fade
+    const int outgoing = onAir()->read(deck, count);
+    for (int i = 0; i < outgoing; ++i) {
+        const float gain = std::cos(HALF_PI * (m_fadePosition + i) / span);
+        out[i * 2] += deck[i * 2] * gain;
+        out[i * 2 + 1] += deck[i * 2 + 1] * gain;
+    }
+
+    const int entering = incoming()->read(deck, count);
+    for (int i = 0; i < entering; ++i) {
+        const float gain = std::sin(HALF_PI * (m_fadePosition + i) / span);
+        out[i * 2] += deck[i * 2] * gain;
+        out[i * 2 + 1] += deck[i * 2 + 1] * gain;
+    }
+
+    m_fadePosition += count;
+    if (m_fadePosition >= m_fadeFrames) {
+        finishFade();
+    }
+    return count;
+}
+
+void DeckMixer::switchToIncoming()
+{
+    onAir()->unload();
+    m_onAir = 1 - m_onAir;
+    m_nextRequested = false;
+    m_lastReportedDuration = -1;
+    Status started;
+    started.kind = Status::Kind::TrackStarted;
+    started.filePath = onAir()->source();
+    report(std::move(started));
+    reportPosition(true);
+}
+
+void DeckMixer::finishFade()
+{
+    onAir()->unload();
+    m_onAir = 1 - m_onAir;
+    m_fading = false;
+    m_nextRequested = false;
+    m_lastReportedDuration = -1;
+
+    if (!m_deferredNext.isEmpty()) {
+        incoming()->load(m_deferredNext, m_deferredCueInMs, m_deferredCueOutMs, m_deferredGain);
+        m_deferredNext.clear();
+    }
+    reportPosition(true);
+}
+
+void DeckMixer::setState(State state)
+{
+    if (m_state != state) {
+        m_state = state;
+        Status changed;
+        changed.kind = Status::Kind::StateChanged;
+        changed.state = state;
+        report(changed);
+    }
+}
+
+void DeckMixer::ensureSinkRunning()
+{
+    if (m_clock) {
+        if (!m_clock->isActive()) {
+            m_clockStarted.start();
+            m_clockFrames = 0;
+            m_clock->start();
+        }
+        return;
+    }
+    if (m_native) {
+        if (!m_nativePump->isActive()) {
+            m_nativePump->start();
+        }
+        return;
+    }
+    if (m_sink->state() == QAudio::SuspendedState) {
+        m_sink->resume();
+    } else if (m_sink->state() != QAudio::ActiveState) {
+        m_sink->start(this);
+    }
+}
+
+void DeckMixer::stopOutput()
+{
+    if (m_sink) {
+        m_sink->stop();
+    } else if (m_native) {
+        m_nativePump->stop();
+        m_native->drop();
+    } else if (m_clock) {
+        m_clock->stop();
+    }
+}
+
+void DeckMixer::suspendOutput()
+{
+    // ALSA can pause only on some cards; what was queued is little enough to drop
+    if (m_sink) {
+        m_sink->suspend();
+    } else if (m_native) {
+        stopOutput();
+    }
+}
+
+void DeckMixer::pullHeadless()
+{
+    // Catch up on what the timer fell behind by, but never more than a few
+    // blocks at once so a stalled thread does not render in a burst
+    const int rate = m_format.sampleRate();
+    const qint64 due = qint64(m_clockStarted.nsecsElapsed() / 1e9 * m_headlessSpeed * rate);
+    const qint64 blockFrames = qint64(rate) * HEADLESS_BLOCK_MS / 1000;
+    qint64 frames = qMin(due - m_clockFrames, HEADLESS_MAX_BLOCKS * blockFrames);
+    if (due - m_clockFrames > frames) {
+        m_clockFrames = due - frames;
+    }
+
+    const qint64 blockBytes = blockFrames * m_format.bytesPerFrame();
+    if (m_clockBuffer.size() < blockBytes) {
+        m_clockBuffer.resize(blockBytes);
+    }
+    while (frames > 0 && m_clock && m_clock->isActive()) {
+        const qint64 count = qMin(frames, blockFrames);
+        readData(m_clockBuffer.data(), count * m_format.bytesPerFrame());
+        m_clockFrames += count;
+        frames -= count;
+    }
+}
+
+void DeckMixer::reportPosition(bool force)
+{
+    // During a transition the incoming track is the one on air for listeners
+    AudioDeck* deck = m_fading ? incoming() : onAir();
+    const bool loaded = deck && deck->state() != AudioDeck::State::Empty;
+    const qint64 position = loaded ? framesToMs(deck->positionFrames()) : 0;
+    const qint64 duration = loaded ? framesToMs(qMax<qint64>(0, deck->durationFrames())) : 0;
+
+    m_positionMs.store(position, std::memory_order_relaxed);
+    m_durationMs.store(duration, std::memory_order_relaxed);
+
+    if (duration != m_lastReportedDuration) {
+        m_lastReportedDuration = duration;
+        Status changed;
+        changed.kind = Status::Kind::DurationChanged;
+        changed.ms = duration;
+        report(changed);
+    }
+
+    const qint64 interval = qint64(m_format.sampleRate()) * POSITION_REPORT_MS / 1000;
+    if (force || m_framesSinceReport >= interval) {
+        m_framesSinceReport = 0;
+        Status changed;
+        changed.kind = Status::Kind::PositionChanged;
+        changed.ms = position;
+        report(changed);
+    }
+}
+
+qint64 DeckMixer::framesToMs(qint64 frames) const
+{
+    const int rate = m_format.sampleRate();
+    return rate > 0 ? frames * 1000 / rate : 0;
+}
@@ -0,0 +1,456 @@
+#ifndef DECKMIXER_H
+#define DECKMIXER_H
+
+#include <QIODevice>
+#include <QAudioDevice>
+#include <QAudioFormat>
+#include <QElapsedTimer>
+#include <QString>
+#include <QVector>
+#include <array>
+#include <atomic>
+#include <memory>
+
+#include "AudioRingBuffer.h"
+#include "GainRamp.h"
+#include "MetricsRegistry.h"
+#include "NativeAudioOutput.h"
+#include "SpscQueue.h"
+
+class AudioDeck;
+class CartWall;
+class DeadAirDetector;
+class MicDucker;
+class TrackPrefetcher;
+class QAudioSink;
+class QTimer;
+
+/**
+ * @brief Two-deck mixer feeding a QAudioSink from the audio thread
+ *
+ * DeckMixer owns the two AudioDecks used by PlaybackEngine and is the
+ * QIODevice a QAudioSink pulls PCM from. Each readData() call mixes the
+ * on-air deck and, during a transition, the incoming deck with an
+ * equal-power crossfade. The crossfade starts so that its end lines up
+ * with the last sample of the outgoing track; with a crossfade length of
+ * zero the next track is spliced in within the same buffer, which makes
+ * transitions gapless and sample-accurate regardless of how long the
+ * decoder takes to open a file, as long as the next deck was queued ahead.
+ *
+ * play() and queueNext() take optional cue points. A track starts at its
+ * cue-in and is treated as ending at its cue-out, so the crossfade lines up
+ * with the end of the audio rather than with trailing silence. Each track
+ * can also be given its own gain, which evens out loudness between tracks.
+ *
+ * NextTrackRequested is reported once per track when the on-air deck gets
+ * within the crossfade length plus QUEUE_LEAD_MS of its end, giving the
+ * caller time to queue the following item.
+ *
+ * The volume is applied by a GainRamp on the audio thread. setVolume()
+ * moves to the new value over VOLUME_RAMP_MS, or over the length of a
+ * fade, a little on every frame, so a slider dragged or a fade stepped
+ * from the GUI does not click however its events are spaced.
+ *
+ * A copy of the mixed output, after the volume, can be taken from a tap:
+ * while it is enabled every buffer handed to the sink is also written to a
+ * ring buffer that another thread drains with readTap(). Each Tap has its
+ * own buffer, so the stream encoder and the air-check recorder read at
+ * their own pace. A tap never blocks the audio thread; if it is not
+ * drained in time, audio is dropped from it rather than from the sink.
+ *
+ * A CartWall adds its voices to the output as a bus of its own, on top of
+ * both decks and before the volume, so jingles fired from it play over the
+ * music and reach the taps with it. A MicDucker turns the decks down, and
+ * only the decks, while the presenter speaks. startCartOutput() keeps the sink
+ * running while a cart plays with the decks stopped or paused.
+ *
+ * Every buffer handed to the sink can also be measured by a
+ * DeadAirDetector, on the audio thread, so silence on air is noticed
+ * without copying the output anywhere.
+ *
+ * Headless, the mixer has no sink: a timer on its thread pulls the blocks
+ * a sink would, optionally faster than real time, and the output is only
+ * seen through the taps and the detector. Benchmarks drive it that way.
+ *
+ * setNativeOutput() plays through a NativeAudioOutput instead of the
+ * QAudioSink, in periods of a fixed size written from the mixer's thread
+ * at real-time priority, for a known and short output latency. Commands
+ * are taken between periods. If the device fails the mixer goes back to
+ * a QAudioSink and says so with errorOccurred().
+ *
+ * Commands reach the mixer through post(), which needs no lock: they go
+ * into a single-producer queue that the mixer's thread drains, woken by at
+ * most one queued call however many commands are waiting. A run of seeks
+ * is played as its last one. What the mixer has to report, from position
+ * ticks to the start of a track, goes back the same way through a queue
+ * the owner empties with takeStatus(); nothing in readData() emits a
+ * signal, takes a lock or allocates on behalf of the GUI.
+ *
+ * The slots must run on the mixer's thread. Position, duration, volume and
+ * the tap are exchanged through atomics.
+ *
+ * @since XFB 2.0
+ */
+class DeckMixer : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Mixer playback state
+     */
+    enum class State {
+        Stopped,
+        Playing,
+        Paused
+    };
+    Q_ENUM(State)
+
+    explicit DeckMixer(QObject* parent = nullptr);
+    ~DeckMixer() override;
+
+    bool isSequential() const override { return true; }
+    qint64 bytesAvailable() const override;
+
+    qint64 positionMs() const { return m_positionMs.load(std::memory_order_relaxed); }
+    qint64 durationMs() const { return m_durationMs.load(std::memory_order_relaxed); }
+    /**
+     * @brief Volume the output is at, or moving to
+     */
+    float volume() const { return m_volume.load(std::memory_order_relaxed); }
+    void setCrossfadeMs(int ms) { m_crossfadeMs.store(qMax(0, ms), std::memory_order_relaxed); }
+    int crossfadeMs() const { return m_crossfadeMs.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Get the output sample rate
+     * @return Rate in Hz, 0 before initialize()
+     */
+    int sampleRate() const { return m_sampleRate.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Get how full the buffer of the deck on air is; may be called from any thread
+     * @return Percent of the ring, 100 once the track is decoded to its end,
+     *         or -1 while nothing plays
+     */
+    int bufferFillPercent() const { return m_bufferFill.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Get the bytes of the deck rings and output taps; may be called from any thread
+     *
+     * Computed from the sizes the buffers are given rather than read from
+     * them, since the audio thread resizes them.
+     */
+    qint64 bufferMemoryUsage() const;
+
+    /**
+     * @brief Get the xruns and sizes of the native output; may be called from any thread
+     *
+     * The counts run on across reopening the device. periodFrames is 0
+     * while the output is not native.
+     */
+    NativeAudioOutput::Statistics nativeStatistics() const;
+
+    /**
+     * @brief Consumers of a copy of the output
+     */
+    enum class Tap {
+        Stream,     ///< Built-in stream encoder
+        AirCheck,   ///< Compliance recording of everything that went to air
+    };
+    static constexpr int TAP_COUNT = 2;
+
+    /**
+     * @brief Start or stop copying the output to a tap
+     *
+     * Enabling the tap discards whatever is left in it from before.
+     * @param enabled true to copy
+     * @param tap Tap to switch
+     */
+    void setTapEnabled(bool enabled, Tap tap = Tap::Stream);
+    bool isTapEnabled(Tap tap = Tap::Stream) const;
+
+    /**
+     * @brief Take interleaved stereo float samples out of a tap
+     *
+     * May be called from any one thread other than the mixer's, per tap.
+     * @param data Destination for the samples
+     * @param samples Maximum number of samples to read
+     * @param tap Tap to read
+     * @return Number of samples read
+     */
+    int readTap(float* data, int samples, Tap tap = Tap::Stream);
+
+    /**
+     * @brief Measure the output for dead air
+     *
+     * May be called from any thread; the detector must outlive the mixer or be unset.
+     * @param detector Detector fed DeadAirDetector::Source::Output, or null for none
+     */
+    void setDeadAirDetector(DeadAirDetector* detector)
+    {
+        m_deadAir.store(detector, std::memory_order_release);
+    }
+
+    /**
+     * @brief Add the carts of a wall to the output
+     *
+     * May be called from any thread; the wall must outlive the mixer or be unset.
+     * @param carts Wall to render, or null for none
+     */
+    void setCartWall(CartWall* carts) { m_carts.store(carts, std::memory_order_release); }
+
+    /**
+     * @brief Duck the decks under the live input
+     *
+     * May be called from any thread; the ducker must outlive the mixer or be unset.
+     * @param ducker Ducker to pass the decks through, or null for none
+     */
+    void setDucker(MicDucker* ducker) { m_ducker.store(ducker, std::memory_order_release); }
+
+    /**
+     * @brief Time each mixed block
+     *
+     * May be called from any thread; the histogram must outlive the mixer or be unset.
+     * @param histogram Histogram of readData() durations in microseconds, or null for none
+     */
+    void setRenderTimeHistogram(MetricsRegistry::Histogram* histogram)
+    {
+        m_renderTime.store(histogram, std::memory_order_release);
+    }
+
+    /**
+     * @brief Share a prefetcher with both decks; call before initialize()
+     */
+    void setPrefetcher(TrackPrefetcher* prefetcher) { m_prefetcher = prefetcher; }
+
+    /**
+     * @brief Render without a sound card; call before initialize()
+     *
+     * The output is DEFAULT_SAMPLE_RATE float, pulled HEADLESS_BLOCK_MS at a time.
+     * @param speed How many times faster than real time to render
+     */
+    void setHeadless(double speed) { m_headlessSpeed = speed; }
+    bool isHeadless() const { return m_headlessSpeed > 0; }
+
+    /**
+     * @brief Find an output device by its id or its description
+     * @param name Id or description; empty for the default device
+     * @return The device, or the default one when none matches
+     */
+    static QAudioDevice findOutput(const QString& name);
+
+    /**
+     * @brief A request to the mixer; see post()
+     */
+    struct Command {
+        enum class Type {
+            None,
+            Play,
+            QueueNext,
+            ClearNext,
+            SkipToNext,
+            Stop,
+            Pause,
+            Resume,
+            Seek,
+            StartCarts,
+            Volume
+        } type = Type::None;
+        QString filePath;
+        qint64 cueInMs = 0;
+        qint64 cueOutMs = -1;
+        float gain = 1.0f;       ///< Track gain, or the volume to move to
+        qint64 positionMs = 0;   ///< Seek target
+        int rampMs = 0;          ///< Length of a volume move
+        GainRamp::Curve curve = GainRamp::Curve::Linear;
+        float fromGain = -1.0f;  ///< Volume a move starts from, -1 for the current one
+    };
+
+    /**
+     * @brief Something the mixer reports; see takeStatus()
+     */
+    struct Status {
+        enum class Kind {
+            None,
+            StateChanged,
+            PositionChanged,
+            DurationChanged,
+            TrackStarted,
+            NextTrackRequested,
+            PlaybackFinished
+        } kind = Kind::None;
+        State state = State::Stopped;
+        qint64 ms = 0;           ///< Position or duration
+        QString filePath;        ///< Track that started
+    };
+
+    /**
+     * @brief Queue a command for the mixer's thread; one producer thread only
+     * @return false if the queue is full and the command was dropped
+     */
+    bool post(Command command);
+
+    /**
+     * @brief Take the oldest report; one consumer thread only
+     * @return false if there is none
+     */
+    bool takeStatus(Status& status) { return m_statuses.pop(status); }
+
+    static constexpr int QUEUE_CAPACITY = 256;
+    static constexpr int VOLUME_RAMP_MS = 20;   ///< Length of a plain volume change
+    static constexpr int DEFAULT_SAMPLE_RATE = 44100;   ///< When the device has no preference
+    static constexpr int HEADLESS_BLOCK_MS = 10;
+
+public slots:
+    /**
+     * @brief Create the audio sink; must be called once on the audio thread
+     */
+    void initialize();
+
+    /**
+     * @brief Route the output to a device; before initialize() or while running
+     *
+     * The output keeps its sample rate, so a device that cannot play it is
+     * refused with errorOccurred().
+     * @param name Id or description of the device; empty for the default
+     */
+    void setOutputDevice(const QString& name);
+
+    /**
+     * @brief Play through a native device instead; before initialize() or while running
+     *
+     * The device plays at the mixer's rate. Headless, the config is kept and unused.
+     * @param config Device and period sizes; no periods or no device for the QAudioSink
+     */
+    void setNativeOutput(const NativeAudioOutput::Config& config);
+
+    /**
+     * @brief Stop playback and release the audio sink
+     */
+    void shutdown();
+
+    void play(const QString& filePath, qint64 cueInMs = 0, qint64 cueOutMs = -1, float gain = 1.0f);
+    void queueNext(const QString& filePath, qint64 cueInMs = 0, qint64 cueOutMs = -1,
+                   float gain = 1.0f);
+    void clearNext();
+    void skipToNext();
+    void stop();
+    void pause();
+    void resume();
+    void seek(qint64 positionMs);
+
+    /**
+     * @brief Run the output for a cart that was just fired, until the wall is idle
+     */
+    void startCartOutput();
+
+    /**
+     * @brief Move the output volume
+     * @param volume Linear gain to end on, 0.0 to 1.0
+     * @param rampMs Length of the move; 0 jumps
+     * @param curve Shape of the move
+     * @param fromVolume Gain to start from, or -1 to start from the current one
+     */
+    void setVolume(float volume, int rampMs = VOLUME_RAMP_MS,
+                   GainRamp::Curve curve = GainRamp::Curve::Linear, float fromVolume = -1.0f);
+
+signals:
+    void errorOccurred(const QString& message);
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override;
+    qint64 writeData(const char* data, qint64 maxSize) override;
+
+private:
+    AudioDeck* onAir() const { return m_decks[m_onAir]; }
+    AudioDeck* incoming() const { return m_decks[1 - m_onAir]; }
+
+    void processCommands();
+    void execute(const Command& command);
+    void report(Status status);
+    void mix(float* out, int frames);
+    int mixFade(float* out, int frames);
+    void switchToIncoming();
+    void finishFade();
+    void setState(State state);
+    void ensureSinkRunning();
+    void stopOutput();
+    void suspendOutput();
+    void createSink();
+    bool openNative();
+    void closeNative();
+    void pumpNative();
+    void stopCartOutput();
+    bool cartsPlaying() const;
+    void pullHeadless();
+    void reportPosition(bool force = false);
+    qint64 framesToMs(qint64 frames) const;
+
+    static constexpr int QUEUE_LEAD_MS = 10000;
+    static constexpr int POSITION_REPORT_MS = 50;
+    static constexpr int TAP_CAPACITY_MS = 4000;
+    static constexpr int TAP_SAMPLE_RATE = 96000;   ///< Highest rate a sink is likely to pick
+    static constexpr int HEADLESS_MAX_BLOCKS = 8;   ///< Most blocks one tick catches up on
+
+    QAudioFormat m_format;
+    QString m_deviceName;                     ///< Requested output; empty for the default
+    QAudioSink* m_sink = nullptr;
+    QTimer* m_clock = nullptr;                ///< Pulls the output when headless
+    double m_headlessSpeed = 0.0;
+    QElapsedTimer m_clockStarted;
+    qint64 m_clockFrames = 0;                 ///< Frames pulled since the clock started
+    QByteArray m_clockBuffer;
+    NativeAudioOutput::Config m_nativeConfig{QString(), 0, 0, 0};   ///< No periods for none
+    std::unique_ptr<NativeAudioOutput> m_native;   ///< Instead of m_sink when open
+    QTimer* m_nativePump = nullptr;           ///< Writes a period whenever the thread is free
+    qint64 m_nativeXrunsSeen = 0;             ///< Of the device open now
+    TrackPrefetcher* m_prefetcher = nullptr;
+    AudioDeck* m_decks[2] = {nullptr, nullptr};
+    int m_onAir = 0;
+    State m_state = State::Stopped;
+
+    bool m_fading = false;
+    qint64 m_fadeFrames = 0;
+    qint64 m_fadePosition = 0;
+    bool m_nextRequested = false;
+    QString m_deferredNext;
+    qint64 m_deferredCueInMs = 0;
+    qint64 m_deferredCueOutMs = -1;
+    float m_deferredGain = 1.0f;
+
+    GainRamp m_gain;   ///< Audio thread only
+    QVector<float> m_mixBuffer;
+    QVector<float> m_deckBuffer;
+    qint64 m_framesSinceReport = 0;
+    qint64 m_lastReportedDuration = -1;
+
+    std::atomic<qint64> m_positionMs{0};
+    std::atomic<qint64> m_durationMs{0};
+    std::atomic<float> m_volume{1.0f};
+    std::atomic<int> m_crossfadeMs{0};
+    std::atomic<int> m_sampleRate{0};
+    std::atomic<int> m_bufferFill{-1};
+    std::atomic<qint64> m_nativeXruns{0};
+    std::atomic<qint64> m_nativePeriodsWritten{0};
+    std::atomic<int> m_nativePeriodFrames{0};
+    std::atomic<int> m_nativePeriods{0};
+
+    struct TapBuffer {
+        AudioRingBuffer buffer;
+        std::atomic<bool> enabled{false};
+        std::atomic<bool> reset{false};
+    };
+    std::array<TapBuffer, TAP_COUNT> m_taps;
+    bool m_cartOutput = false;                ///< Output running for the carts alone
+
+    SpscQueue<Command> m_commands{QUEUE_CAPACITY};
+    SpscQueue<Status> m_statuses{QUEUE_CAPACITY};
+    std::atomic<bool> m_commandsWoken{false};   ///< A processCommands() call is queued
+
+    std::atomic<CartWall*> m_carts{nullptr};
+    std::atomic<DeadAirDetector*> m_deadAir{nullptr};
+    std::atomic<MicDucker*> m_ducker{nullptr};
+    std::atomic<MetricsRegistry::Histogram*> m_renderTime{nullptr};
+};
+
+#endif // DECKMIXER_H
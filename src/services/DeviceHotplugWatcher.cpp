@@ -0,0 +1,95 @@
+#include "DeviceHotplugWatcher.h"
+#include <QDir>
+#include <QFileSystemWatcher>
+#include <QTimer>
+#include <algorithm>
+
+DeviceHotplugWatcher::DeviceHotplugWatcher(const QStringList& directories,
+                                           const QStringList& nameFilters, QObject* parent)
+    : QObject(parent)
+    , m_watcher(new QFileSystemWatcher(this))
+    , m_settleTimer(new QTimer(this))
+    , m_directories(directories)
+    , m_nameFilters(nameFilters)
+{
+    m_settleTimer->setSingleShot(true);
+    m_settleTimer->setInterval(SETTLE_MS);
+    connect(m_settleTimer, &QTimer::timeout, this, &DeviceHotplugWatcher::rescan);
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged, m_settleTimer,
+            qOverload<>(&QTimer::start));
+
+    for (const QString& directory : m_directories) {
+        if (QDir(directory).exists()) {
+            m_watcher->addPath(directory);
+        }
+    }
+    m_devices = scan();
+}
+
+QStringList DeviceHotplugWatcher::defaultDirectories()
+{
+    return {QStringLiteral("/dev")};
+}
+
+QStringList DeviceHotplugWatcher::defaultNameFilters()
+{
+#ifdef Q_OS_MACOS
+    return {QStringLiteral("cu.*")};
+#else
+    return {QStringLiteral("ttyUSB*"), QStringLiteral("ttyACM*"), QStringLiteral("hidraw*"),
+            QStringLiteral("rfcomm*")};
+#endif
+}
+
+QStringList DeviceHotplugWatcher::devices() const
+{
+    QStringList devices(m_devices.cbegin(), m_devices.cend());
+    std::sort(devices.begin(), devices.end());
+    return devices;
+}
+
+void DeviceHotplugWatcher::rescan()
+{
+    const QSet<QString> current = scan();
+    if (current == m_devices) {
+        return;
+    }
+
+    QStringList added;
+    QStringList removed;
+    for (const QString& path : current) {
+        if (!m_devices.contains(path)) {
+            added << path;
+        }
+    }
+    for (const QString& path : m_devices) {
+        if (!current.contains(path)) {
+            removed << path;
+        }
+    }
+    std::sort(added.begin(), added.end());
+    std::sort(removed.begin(), removed.end());
+    m_devices = current;
+
+    for (const QString& path : removed) {
+        emit deviceRemoved(path);
+    }
+    for (const QString& path : added) {
+        emit deviceAdded(path);
+    }
+    emit devicesChanged();
+}
+
+QSet<QString> DeviceHotplugWatcher::scan() const
+{
+    QSet<QString> devices;
+    for (const QString& directory : m_directories) {
+        const QDir dir(directory);
+        const QStringList entries =
+            dir.entryList(m_nameFilters, QDir::System | QDir::Files | QDir::NoDotAndDotDot);
+        for (const QString& entry : entries) {
+            devices.insert(dir.absoluteFilePath(entry));
+        }
+    }
+    return devices;
+}
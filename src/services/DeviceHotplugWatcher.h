@@ -0,0 +1,81 @@
+#ifndef DEVICEHOTPLUGWATCHER_H
+#define DEVICEHOTPLUGWATCHER_H
+
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+
+class QFileSystemWatcher;
+class QTimer;
+
+/**
+ * @brief Reports device nodes as they appear and disappear, without polling
+ *
+ * The kernel creates a node in /dev when a USB, serial or Bluetooth braille
+ * display is plugged in and removes it when the display goes. This class
+ * watches the device directories through QFileSystemWatcher (inotify on
+ * Linux, kqueue on macOS) and keeps the list of nodes matching the name
+ * filters. A burst of directory changes is settled for SETTLE_MS before the
+ * list is compared with the previous one.
+ *
+ * @example
+ * @code
+ * auto* watcher = new DeviceHotplugWatcher(DeviceHotplugWatcher::defaultDirectories(),
+ *                                          DeviceHotplugWatcher::defaultNameFilters(), this);
+ * connect(watcher, &DeviceHotplugWatcher::deviceAdded, this, &MyClass::probe);
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class DeviceHotplugWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int SETTLE_MS = 300;
+
+    /**
+     * @brief Watch the given directories for nodes matching the filters
+     * @param directories Directories to watch; missing ones are skipped
+     * @param nameFilters Wildcard patterns, such as "ttyUSB*"
+     * @param parent Parent object
+     */
+    DeviceHotplugWatcher(const QStringList& directories, const QStringList& nameFilters,
+                         QObject* parent = nullptr);
+
+    /**
+     * @brief Where the platform creates braille display device nodes
+     */
+    static QStringList defaultDirectories();
+
+    /**
+     * @brief Names the platform gives to USB, serial, HID and Bluetooth device nodes
+     */
+    static QStringList defaultNameFilters();
+
+    /**
+     * @brief The matching device nodes, as absolute paths, sorted
+     */
+    QStringList devices() const;
+
+signals:
+    void deviceAdded(const QString& path);
+    void deviceRemoved(const QString& path);
+
+    /**
+     * @brief Emitted once after each settled change, after the added and removed signals
+     */
+    void devicesChanged();
+
+private:
+    void rescan();
+    QSet<QString> scan() const;
+
+    QFileSystemWatcher* m_watcher;
+    QTimer* m_settleTimer;
+    QStringList m_directories;
+    QStringList m_nameFilters;
+    QSet<QString> m_devices;
+};
+
+#endif // DEVICEHOTPLUGWATCHER_H
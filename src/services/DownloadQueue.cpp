@@ -0,0 +1,455 @@
+#include "DownloadQueue.h"
+#include "MediaProbe.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+#include <QRegularExpression>
+#include <QStandardPaths>
+#include <QTimer>
+#include <utility>
+
+namespace {
+
+// yt-dlp prints this line once the file is in place; tabs keep titles
+// with spaces in one field, and empty fields stay empty
+const QString INFO_PREFIX = "XFB-INFO";
+const QString INFO_TEMPLATE =
+    INFO_PREFIX + "\t%(filepath)s\t%(artist|)s\t%(uploader|)s\t%(track|)s\t%(title|)s";
+
+// Used when a request names no track, so every download gets its own file
+const QString METADATA_FILE_NAME = "%(artist,uploader|Unknown)s - %(track,title|Untitled)s "
+                                   "[%(id)s]";
+
+// Makes artist or title safe as part of an output template
+QString fileNamePart(QString text)
+{
+    text.remove(QRegularExpression(R"([\\/:*?"<>|])"));
+    // yt-dlp expands %(...)s in the template
+    text.replace('%', "%%");
+    return text.trimmed();
+}
+
+QString withoutLineEnd(QString line)
+{
+    while (line.endsWith('\n') || line.endsWith('\r')) {
+        line.chop(1);
+    }
+    return line;
+}
+
+} // namespace
+
+DownloadQueue::DownloadQueue(MusicRepository* repository, QObject* parent)
+    : QObject(parent)
+    , m_repository(repository)
+    , m_flushTimer(new QTimer(this))
+{
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(FLUSH_DELAY_MS);
+    connect(m_flushTimer, &QTimer::timeout, this, &DownloadQueue::flush);
+}
+
+DownloadQueue::~DownloadQueue()
+{
+    abortWorkers();
+    // What was downloaded is not lost, but nobody is listening any more
+    if (m_repository && !m_ready.isEmpty()) {
+        m_repository->addMusicBatch(m_ready);
+    }
+}
+
+QString DownloadQueue::findProgram()
+{
+    QString program = QStandardPaths::findExecutable("yt-dlp");
+
+#ifdef Q_OS_WIN
+    // findExecutable() tries PATHEXT, but not every installer sets it up
+    for (const QString& name : {QString("yt-dlp.exe"), QString("yt-dlp.cmd"),
+                                QString("yt-dlp.bat")}) {
+        if (program.isEmpty()) {
+            program = QStandardPaths::findExecutable(name);
+        }
+    }
+#endif
+
+#ifdef Q_OS_MACOS
+    // Applications started from the Finder do not get the shell's PATH
+    if (program.isEmpty()) {
+        const QStringList commonPaths = {
+            "/opt/homebrew/bin/yt-dlp",               // Homebrew on Apple Silicon
+            "/usr/local/bin/yt-dlp",                  // Homebrew on Intel Macs
+            "/opt/local/bin/yt-dlp",                  // MacPorts
+            QDir::homePath() + "/.local/bin/yt-dlp",  // pip user install
+            "/usr/bin/yt-dlp"                         // System install
+        };
+        for (const QString& path : commonPaths) {
+            if (QFile::exists(path)) {
+                program = path;
+                break;
+            }
+        }
+    }
+#endif
+
+    return program;
+}
+
+QStringList DownloadQueue::splitUrls(const QString& text)
+{
+    QStringList urls;
+    const QStringList words = text.split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
+    for (const QString& word : words) {
+        // Words that are not links, such as a title pasted along with one, are left out
+        if (!word.contains("://") && !word.startsWith("www.", Qt::CaseInsensitive)) {
+            continue;
+        }
+        const QString url = word.section('&', 0, 0);
+        if (!urls.contains(url)) {
+            urls.append(url);
+        }
+    }
+    return urls;
+}
+
+QList<DownloadQueue::Request> DownloadQueue::requestsFor(const QStringList& urls,
+                                                         const Request& details)
+{
+    QList<Request> requests;
+    requests.reserve(urls.size());
+    for (const QString& url : urls) {
+        Request request = details;
+        request.url = url;
+        requests.append(request);
+    }
+    return requests;
+}
+
+void DownloadQueue::setMaxWorkers(int workers)
+{
+    m_maxWorkers = qMax(1, workers);
+    schedule();
+}
+
+int DownloadQueue::enqueue(const QList<Request>& requests)
+{
+    int added = 0;
+    for (Request request : requests) {
+        request.url = request.url.trimmed();
+        if (request.url.isEmpty() || m_active.contains(request.url)) {
+            continue;
+        }
+        m_active.append(request.url);
+        m_queue.append({request, 0});
+        ++m_total;
+        ++added;
+    }
+    if (added == 0) {
+        return 0;
+    }
+
+    qInfo() << "DownloadQueue: queued" << added << "downloads," << pendingCount() << "pending";
+    m_running = true;
+    emit progressChanged(progress());
+    schedule();
+    return added;
+}
+
+void DownloadQueue::cancel()
+{
+    if (!m_running) {
+        return;
+    }
+
+    const int dropped = pendingCount();
+    m_queue.clear();
+    ++m_generation;
+    m_retrying = 0;
+    abortWorkers();
+    qInfo() << "DownloadQueue: cancelled with" << dropped << "downloads left";
+    emit progressChanged(progress());
+    finishIfIdle();
+}
+
+DownloadQueue::Progress DownloadQueue::progress() const
+{
+    Progress progress;
+    progress.total = m_total;
+    progress.done = m_done;
+    progress.failed = m_failed;
+    progress.running = m_workers.size();
+    if (m_total > 0) {
+        progress.permille = (m_done + m_failed) * 1000 / m_total;
+    }
+    return progress;
+}
+
+void DownloadQueue::schedule()
+{
+    while (m_running && m_workers.size() < m_maxWorkers && !m_queue.isEmpty()) {
+        startJob(m_queue.takeFirst());
+    }
+    finishIfIdle();
+}
+
+QString DownloadQueue::outputTemplate(const Request& request) const
+{
+    const QString name = request.artist.isEmpty() || request.song.isEmpty()
+                             ? METADATA_FILE_NAME
+                             : fileNamePart(request.artist) + " - " + fileNamePart(request.song);
+    return QDir(m_outputDirectory).filePath(name + ".%(ext)s");
+}
+
+void DownloadQueue::startJob(const Job& job)
+{
+    Worker worker;
+    worker.job = job;
+    ++worker.job.attempt;
+    const QString url = job.request.url;
+
+    QString error;
+    if (m_program.isEmpty()) {
+        error = "yt-dlp is not installed";
+    } else if (m_outputDirectory.isEmpty() || !QDir().mkpath(m_outputDirectory)) {
+        error = QString("Cannot create the music directory %1").arg(m_outputDirectory);
+    }
+    if (!error.isEmpty()) {
+        ++m_failed;
+        m_active.removeOne(url);
+        qWarning() << QString("DownloadQueue::startJob - %1: %2").arg(url, error);
+        emit jobFinished(url, QString(), false, error, false);
+        emit progressChanged(progress());
+        return;
+    }
+
+    // "--" keeps a link that starts with a dash from being read as an option
+    QStringList arguments{"--no-playlist", "--no-progress", "--extract-audio",
+                          "--audio-format", "m4a", "--audio-quality", "0",
+                          "--print", "after_move:" + INFO_TEMPLATE,
+                          "-o", outputTemplate(job.request)};
+    if (!m_ffmpegLocation.isEmpty()) {
+        arguments << "--ffmpeg-location" << m_ffmpegLocation;
+    }
+    arguments << "--" << url;
+
+    QProcess* process = new QProcess(this);
+    process->setProcessChannelMode(QProcess::MergedChannels);
+
+    if (m_timeoutMs > 0) {
+        worker.timeout = new QTimer(process);
+        worker.timeout->setSingleShot(true);
+        connect(worker.timeout, &QTimer::timeout, this, [this, process]() {
+            m_workers[process].timedOut = true;
+            process->kill();
+        });
+        worker.timeout->start(m_timeoutMs);
+    }
+
+    const auto readLine = [this, process](const QString& line) {
+        Worker& worker = m_workers[process];
+        if (line.startsWith(INFO_PREFIX + '\t')) {
+            worker.info = line;
+        } else if (!line.trimmed().isEmpty()) {
+            worker.output = line.trimmed();
+            emit outputReceived(worker.job.request.url, worker.output);
+        }
+    };
+    connect(process, &QProcess::readyReadStandardOutput, this, [process, readLine]() {
+        while (process->canReadLine()) {
+            readLine(withoutLineEnd(QString::fromUtf8(process->readLine())));
+        }
+    });
+    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
+            [this, process, readLine](int exitCode, QProcess::ExitStatus exitStatus) {
+                const QString rest = withoutLineEnd(QString::fromUtf8(process->readAll()));
+                if (!rest.isEmpty()) {
+                    readLine(rest);
+                }
+
+                const Worker worker = m_workers.value(process);
+                QString error;
+                if (worker.timedOut) {
+                    error = QString("Timed out after %1 s").arg(m_timeoutMs / 1000);
+                } else if (exitStatus != QProcess::NormalExit) {
+                    error = "yt-dlp crashed";
+                } else if (exitCode != 0) {
+                    error = QString("yt-dlp exited with code %1: %2")
+                                .arg(exitCode)
+                                .arg(worker.output);
+                }
+                onWorkerFinished(process, error, true);
+            });
+    connect(process, &QProcess::errorOccurred, this, [this, process](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart) {
+            onWorkerFinished(process, process->errorString(), false);
+        }
+    });
+
+    m_workers.insert(process, worker);
+    emit jobStarted(url, worker.job.attempt);
+    emit progressChanged(progress());
+    qDebug() << "DownloadQueue: downloading" << url << "attempt" << worker.job.attempt;
+    process->start(m_program, arguments);
+}
+
+void DownloadQueue::onWorkerFinished(QProcess* process, const QString& error, bool retryable)
+{
+    const auto it = m_workers.constFind(process);
+    if (it == m_workers.cend()) {
+        return;
+    }
+    const Worker worker = it.value();
+    m_workers.remove(process);
+    process->disconnect(this);
+    process->deleteLater();
+
+    const QString url = worker.job.request.url;
+    QString failure = error;
+    MusicItem track;
+    if (failure.isEmpty()) {
+        track = trackFor(worker.job.request, worker.info, &failure);
+        retryable = false;
+    }
+
+    if (failure.isEmpty()) {
+        ++m_done;
+        m_active.removeOne(url);
+        m_ready.append(track);
+        qInfo() << "DownloadQueue: downloaded" << url << "->" << track.path;
+        emit jobFinished(url, track.path, true, QString(), false);
+        if (m_ready.size() >= BATCH_SIZE) {
+            flush();
+        } else if (!m_flushTimer->isActive()) {
+            m_flushTimer->start();
+        }
+    } else if (retryable && worker.job.attempt < m_maxAttempts) {
+        // Most failures are the network or the site; give them time to recover
+        ++m_retrying;
+        const Job job = worker.job;
+        const int generation = m_generation;
+        qWarning() << QString("DownloadQueue::onWorkerFinished - %1: %2; retrying")
+                          .arg(url, failure);
+        QTimer::singleShot(m_retryDelayMs * job.attempt, this, [this, job, generation]() {
+            if (generation != m_generation) {
+                return;
+            }
+            --m_retrying;
+            m_queue.append(job);
+            schedule();
+        });
+        emit jobFinished(url, QString(), false, failure, true);
+    } else {
+        ++m_failed;
+        m_active.removeOne(url);
+        qWarning() << QString("DownloadQueue::onWorkerFinished - %1: %2").arg(url, failure);
+        emit jobFinished(url, QString(), false, failure, false);
+    }
+
+    emit progressChanged(progress());
+    schedule();
+}
+
+MusicItem DownloadQueue::trackFor(const Request& request, const QString& info,
+                                  QString* error) const
+{
+    // Prefix, file path, artist, uploader, track and title
+    const QStringList fields = info.split('\t');
+    if (fields.size() < 6 || fields.at(1).isEmpty()) {
+        *error = "yt-dlp did not report the downloaded file";
+        return MusicItem();
+    }
+
+    MusicItem track;
+    track.path = fields.at(1);
+    if (!QFileInfo(track.path).isFile()) {
+        *error = QString("The downloaded file %1 is missing").arg(track.path);
+        return MusicItem();
+    }
+
+    QString artist = fields.at(2).trimmed();
+    QString song = fields.at(4).trimmed();
+    const QString title = fields.at(5).trimmed();
+    // Music videos without tags are usually titled "Artist - Song"
+    if ((artist.isEmpty() || song.isEmpty()) && title.contains(" - ")) {
+        artist = title.section(" - ", 0, 0).trimmed();
+        song = title.section(" - ", 1).trimmed();
+    }
+    if (artist.isEmpty()) {
+        artist = fields.at(3).trimmed();
+    }
+    if (song.isEmpty()) {
+        song = title;
+    }
+
+    track.artist = !request.artist.isEmpty() ? request.artist
+                   : !artist.isEmpty()       ? artist
+                                             : QString("Unknown artist");
+    track.song = !request.song.isEmpty() ? request.song
+                 : !song.isEmpty()       ? song
+                                         : QString("Untitled");
+    track.genre1 = request.genre1;
+    track.genre2 = request.genre2;
+    track.country = request.country;
+    track.publishedDate = request.publishedDate;
+    track.lastPlayed = "-";
+
+    const MediaProbe::ProbeResult probe = MediaProbe::probe(track.path);
+    if (probe.isValid) {
+        track.time = probe.durationString();
+    } else {
+        track.time = "-";
+        qWarning() << QString("DownloadQueue::trackFor - %1: no duration: %2")
+                          .arg(track.path, probe.errorMessage);
+    }
+    return track;
+}
+
+void DownloadQueue::flush()
+{
+    m_flushTimer->stop();
+    if (m_ready.isEmpty()) {
+        return;
+    }
+
+    const QList<MusicItem> batch = std::exchange(m_ready, QList<MusicItem>());
+    const int added = m_repository ? m_repository->addMusicBatch(batch) : 0;
+    m_added += added;
+    qInfo() << "DownloadQueue: added" << added << "of" << batch.size()
+            << "downloaded tracks to the library";
+    if (added > 0) {
+        emit tracksAdded(added);
+    }
+}
+
+void DownloadQueue::finishIfIdle()
+{
+    if (!m_running || !m_queue.isEmpty() || !m_workers.isEmpty() || m_retrying > 0) {
+        return;
+    }
+
+    flush();
+    const int added = m_added;
+    const int failed = m_failed;
+    m_running = false;
+    m_active.clear();
+    m_total = 0;
+    m_done = 0;
+    m_failed = 0;
+    m_added = 0;
+
+    qInfo() << "DownloadQueue: queue empty," << added << "added," << failed << "failed";
+    emit finished(added, failed);
+}
+
+void DownloadQueue::abortWorkers()
+{
+    const QList<QProcess*> processes = m_workers.keys();
+    m_workers.clear();
+    for (QProcess* process : processes) {
+        process->disconnect(this);
+        process->kill();
+        process->waitForFinished(1000);
+        delete process;
+    }
+}
@@ -0,0 +1,259 @@
+#ifndef DOWNLOADQUEUE_H
+#define DOWNLOADQUEUE_H
+
+#include "../repositories/MusicRepository.h"
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+class QProcess;
+class QTimer;
+
+/**
+ * @brief Downloads tracks with a pool of yt-dlp workers and adds them to the library
+ *
+ * The external downloader ran one yt-dlp at a time on a pool thread and
+ * kept the dialog busy until it was done, so adding a list of videos meant
+ * waiting for each one in turn.
+ *
+ * DownloadQueue takes any number of links and runs up to maxWorkers() of
+ * them at once, each as a yt-dlp process driven by signals. A download
+ * that fails is tried again after a delay that grows with every attempt,
+ * up to maxAttempts() times. After a download the file is probed with
+ * MediaProbe for its duration. Artist and title come from the request or,
+ * if it has none, from the video's metadata, which yt-dlp prints once the
+ * file is in place.
+ *
+ * Finished tracks are not written one by one. They are collected and
+ * added with MusicRepository::addMusicBatch() once BATCH_SIZE of them are
+ * ready, FLUSH_DELAY_MS after the first of them, or when the queue runs
+ * empty, whichever comes first.
+ *
+ * @example
+ * @code
+ * DownloadQueue* downloads = new DownloadQueue(musicRepository, this);
+ * downloads->setProgram(DownloadQueue::findProgram());
+ * downloads->setOutputDirectory(musicDirectory);
+ * connect(downloads, &DownloadQueue::tracksAdded, this, &player::update_music_table);
+ * downloads->enqueue(DownloadQueue::requestsFor(DownloadQueue::splitUrls(pasted), details));
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class DownloadQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief One link to download and the library details to file it under
+     */
+    struct Request {
+        QString url;
+        QString artist;         ///< Taken from the video's metadata if empty
+        QString song;           ///< Taken from the video's metadata if empty
+        QString genre1;
+        QString genre2;
+        QString country;
+        QString publishedDate;
+    };
+
+    /**
+     * @brief State of the downloads since the queue was last empty
+     */
+    struct Progress {
+        int total = 0;     ///< Downloads queued
+        int done = 0;      ///< Downloaded
+        int failed = 0;    ///< Given up on
+        int running = 0;   ///< In a worker right now
+        int permille = 0;  ///< Finished downloads, of total
+    };
+
+    static constexpr int DEFAULT_MAX_WORKERS = 3;
+    static constexpr int DEFAULT_MAX_ATTEMPTS = 3;
+    /// Delay before the first retry; the n-th retry waits n times as long
+    static constexpr int DEFAULT_RETRY_DELAY_MS = 5000;
+    static constexpr int DEFAULT_TIMEOUT_MS = 15 * 60 * 1000;
+    static constexpr int BATCH_SIZE = 10;
+    static constexpr int FLUSH_DELAY_MS = 3000;
+
+    explicit DownloadQueue(MusicRepository* repository, QObject* parent = nullptr);
+    ~DownloadQueue() override;
+
+    /**
+     * @brief Find the yt-dlp executable
+     *
+     * Looks in PATH and, on macOS, where Homebrew, MacPorts and pip put it,
+     * since applications started from the Finder do not get the shell's PATH.
+     * @return Path of yt-dlp, or an empty string if it is not installed
+     */
+    static QString findProgram();
+
+    /**
+     * @brief Get the links in pasted text
+     *
+     * Links may be separated by spaces or new lines. Everything after the
+     * first '&' is dropped, which removes playlist and tracking parameters.
+     * @param text Text holding one or more links
+     * @return Links in order, each only once
+     */
+    static QStringList splitUrls(const QString& text);
+
+    /**
+     * @brief Make one request per link with the same library details
+     * @param urls Links to download
+     * @param details Library details; its url is ignored
+     * @return Requests, in the order of the links
+     */
+    static QList<Request> requestsFor(const QStringList& urls, const Request& details);
+
+    void setProgram(const QString& program) { m_program = program; }
+    QString program() const { return m_program; }
+
+    /**
+     * @brief Set the ffmpeg yt-dlp converts with
+     * @param ffmpegPath Path of ffmpeg; empty lets yt-dlp find it
+     */
+    void setFfmpegLocation(const QString& ffmpegPath) { m_ffmpegLocation = ffmpegPath; }
+
+    void setOutputDirectory(const QString& directory) { m_outputDirectory = directory; }
+    QString outputDirectory() const { return m_outputDirectory; }
+
+    /**
+     * @brief Set how many downloads run at once
+     * @param workers Worker count; DEFAULT_MAX_WORKERS by default
+     */
+    void setMaxWorkers(int workers);
+    int maxWorkers() const { return m_maxWorkers; }
+
+    void setMaxAttempts(int attempts) { m_maxAttempts = qMax(1, attempts); }
+    int maxAttempts() const { return m_maxAttempts; }
+
+    void setRetryDelay(int delayMs) { m_retryDelayMs = qMax(0, delayMs); }
+    int retryDelay() const { return m_retryDelayMs; }
+
+    void setTimeout(int timeoutMs) { m_timeoutMs = qMax(0, timeoutMs); }
+    int timeout() const { return m_timeoutMs; }
+
+    /**
+     * @brief Add downloads to the queue and start them
+     *
+     * Requests without a link, or for a link that is already waiting or
+     * downloading, are skipped.
+     * @param requests Downloads to add
+     * @return Number of downloads added
+     */
+    int enqueue(const QList<Request>& requests);
+
+    /**
+     * @brief Drop the waiting downloads and stop the running ones
+     *
+     * Tracks that were already downloaded are still added to the library.
+     */
+    void cancel();
+
+    bool isRunning() const { return m_running; }
+
+    /**
+     * @brief Get the number of downloads not finished yet
+     * @return Waiting, retrying and running downloads
+     */
+    int pendingCount() const { return m_queue.size() + m_retrying + m_workers.size(); }
+
+    Progress progress() const;
+
+signals:
+    /**
+     * @brief Emitted when a worker takes a download
+     * @param url Link being downloaded
+     * @param attempt 1 for the first try
+     */
+    void jobStarted(const QString& url, int attempt);
+
+    /**
+     * @brief Emitted for every line yt-dlp writes
+     * @param url Link the worker is downloading
+     * @param line Output line
+     */
+    void outputReceived(const QString& url, const QString& line);
+
+    /**
+     * @brief Emitted when a download is done, will be tried again, or was given up on
+     * @param url Link that was downloaded
+     * @param filePath Downloaded file, if ok
+     * @param ok true if the file was downloaded
+     * @param error Why it failed
+     * @param willRetry true if the download is tried again later
+     */
+    void jobFinished(const QString& url, const QString& filePath, bool ok, const QString& error,
+                     bool willRetry);
+
+    /**
+     * @brief Emitted whenever a download starts or finishes
+     * @param progress Current progress
+     */
+    void progressChanged(const DownloadQueue::Progress& progress);
+
+    /**
+     * @brief Emitted when a batch of downloaded tracks was added to the library
+     * @param count Tracks added; tracks already in the library are not counted
+     */
+    void tracksAdded(int count);
+
+    /**
+     * @brief Emitted when the queue ran empty
+     * @param added Tracks added to the library since the queue was last empty
+     * @param failed Downloads given up on
+     */
+    void finished(int added, int failed);
+
+private:
+    struct Job {
+        Request request;
+        int attempt = 0;
+    };
+
+    struct Worker {
+        Job job;
+        QString output;   ///< Everything yt-dlp wrote, for the error message
+        QString info;     ///< The line printed after the move
+        QTimer* timeout = nullptr;
+        bool timedOut = false;
+    };
+
+    void schedule();
+    void startJob(const Job& job);
+    void onWorkerFinished(QProcess* process, const QString& error, bool retryable);
+    MusicItem trackFor(const Request& request, const QString& info, QString* error) const;
+    void flush();
+    void finishIfIdle();
+    void abortWorkers();
+    QString outputTemplate(const Request& request) const;
+
+    MusicRepository* m_repository;
+    QString m_program;
+    QString m_ffmpegLocation;
+    QString m_outputDirectory;
+    int m_maxWorkers = DEFAULT_MAX_WORKERS;
+    int m_maxAttempts = DEFAULT_MAX_ATTEMPTS;
+    int m_retryDelayMs = DEFAULT_RETRY_DELAY_MS;
+    int m_timeoutMs = DEFAULT_TIMEOUT_MS;
+
+    bool m_running = false;
+    int m_generation = 0;      ///< Bumped by cancel() so pending retries are dropped
+    QList<Job> m_queue;
+    QHash<QProcess*, Worker> m_workers;
+    QStringList m_active;      ///< Links waiting, retrying or downloading
+    int m_retrying = 0;
+    QList<MusicItem> m_ready;  ///< Downloaded, not yet in the library
+    QTimer* m_flushTimer;
+
+    int m_total = 0;
+    int m_done = 0;
+    int m_failed = 0;
+    int m_added = 0;
+};
+
+#endif // DOWNLOADQUEUE_H
@@ -0,0 +1,74 @@
+#include "DriftResampler.h"
+#include <algorithm>
+#include <cmath>
+
+DriftResampler::DriftResampler(int channels)
+    : m_channels(qMax(1, channels))
+{
+}
+
+void DriftResampler::setRates(int inputRate, int outputRate)
+{
+    if (inputRate > 0 && outputRate > 0) {
+        m_baseRatio = double(inputRate) / outputRate;
+    }
+}
+
+void DriftResampler::setDrift(double drift)
+{
+    m_drift = std::clamp(drift, -MAX_DRIFT, MAX_DRIFT);
+}
+
+void DriftResampler::update(double depth, double targetDepth)
+{
+    m_error += (depth - targetDepth - m_error) * SMOOTHING;
+    setDrift(m_error * GAIN);
+}
+
+void DriftResampler::push(const float* data, int frames)
+{
+    if (frames > 0) {
+        m_input.insert(m_input.end(), data, data + size_t(frames) * size_t(m_channels));
+    }
+}
+
+int DriftResampler::pull(float* data, int frames)
+{
+    const int available = int(m_input.size()) / m_channels;
+    const double step = ratio();
+    int written = 0;
+    while (written < frames) {
+        const int index = int(m_position);
+        // Interpolating needs the frame after too
+        if (index + 1 >= available) {
+            break;
+        }
+        const float fraction = float(m_position - index);
+        const float* a = m_input.data() + size_t(index) * size_t(m_channels);
+        const float* b = a + m_channels;
+        float* out = data + size_t(written) * size_t(m_channels);
+        for (int c = 0; c < m_channels; ++c) {
+            out[c] = a[c] + (b[c] - a[c]) * fraction;
+        }
+        m_position += step;
+        ++written;
+    }
+
+    const int consumed = qMin(int(m_position), available);
+    m_input.erase(m_input.begin(), m_input.begin() + ptrdiff_t(consumed) * m_channels);
+    m_position -= consumed;
+    return written;
+}
+
+int DriftResampler::queued() const
+{
+    return qMax(0, int(m_input.size()) / m_channels - int(m_position));
+}
+
+void DriftResampler::reset()
+{
+    m_input.clear();
+    m_position = 0;
+    m_error = 0;
+    m_drift = 0;
+}
@@ -0,0 +1,93 @@
+#ifndef DRIFTRESAMPLER_H
+#define DRIFTRESAMPLER_H
+
+#include <QtGlobal>
+#include <vector>
+
+/**
+ * @brief Plays a stream a fraction faster or slower, to follow another clock
+ *
+ * Two machines never agree on what 48 kHz is. The sender's sound card
+ * makes samples a little faster or slower than the receiver's plays them,
+ * and a buffer between them slowly fills up or runs dry. DriftResampler
+ * stretches the audio by a ratio that far from 1 no one hears: at most
+ * MAX_DRIFT, 0.5%, where a sound card is off by a hundredth of that.
+ *
+ * The ratio steers a buffer depth to its target: update() is told both
+ * after each frame, and the smoothed difference sets how many input
+ * frames each output frame consumes. A fuller buffer is played faster.
+ * Samples are interpolated linearly, which at these ratios sounds no
+ * different from a sinc filter and costs a multiply per sample. The same
+ * goes between two rates, setRates(), where the drift is on top of their
+ * ratio.
+ *
+ * @example
+ * @code
+ * DriftResampler resampler(2);
+ * resampler.push(decoded, 960);
+ * resampler.update(jitter.depth(), jitter.targetDepth());
+ * const int frames = resampler.pull(output, 960);
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class DriftResampler
+{
+public:
+    static constexpr double MAX_DRIFT = 0.005;
+    /// Weight of each update in the smoothed depth error
+    static constexpr double SMOOTHING = 0.02;
+    /// Drift per frame of smoothed depth error
+    static constexpr double GAIN = 0.002;
+
+    explicit DriftResampler(int channels = 2);
+
+    /**
+     * @brief Convert between two sample rates; the same one by default
+     */
+    void setRates(int inputRate, int outputRate);
+
+    /**
+     * @brief Set how much faster than the input rate the input is consumed
+     * @param drift Kept within MAX_DRIFT
+     */
+    void setDrift(double drift);
+    double drift() const { return m_drift; }
+
+    /// Input frames consumed per output frame
+    double ratio() const { return m_baseRatio * (1.0 + m_drift); }
+
+    /**
+     * @brief Steer the ratio by how far a buffer is from its target depth
+     */
+    void update(double depth, double targetDepth);
+
+    /**
+     * @brief Queue interleaved input
+     */
+    void push(const float* data, int frames);
+
+    /**
+     * @brief Produce interleaved output
+     * @return Frames written, fewer than asked for when the input ran out
+     */
+    int pull(float* data, int frames);
+
+    /// Input frames queued and not yet consumed
+    int queued() const;
+
+    /**
+     * @brief Drop the input and the drift, keeping the rates
+     */
+    void reset();
+
+private:
+    int m_channels;
+    double m_baseRatio = 1.0;      ///< Input rate over output rate
+    double m_drift = 0;
+    double m_error = 0;            ///< Smoothed depth less target
+    std::vector<float> m_input;
+    double m_position = 0;         ///< Fractional input frame of the next output frame
+};
+
+#endif // DRIFTRESAMPLER_H
@@ -0,0 +1,246 @@
+#include "DurationCache.h"
+#include "MediaProbe.h"
+#include "Tracer.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QFileInfo>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QTimer>
+
+DurationCache::DurationCache(QSqlDatabase& database, QObject* parent)
+    : QObject(parent)
+    , m_database(database)
+{
+}
+
+DurationCache::~DurationCache()
+{
+    flush();
+}
+
+bool DurationCache::initialize()
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (m_initialized) {
+        return true;
+    }
+
+    if (!m_database.isOpen()) {
+        logError("initialize", "Database is not open");
+        return false;
+    }
+
+    if (!ensureTable()) {
+        return false;
+    }
+
+    loadEntries();
+    m_initialized = true;
+    return true;
+}
+
+qint64 DurationCache::durationUs(const QString& filePath)
+{
+    TraceSpan span("cache", "DurationCache::durationUs");
+    QFileInfo info(filePath);
+    if (!info.exists()) {
+        return -1;
+    }
+
+    const qint64 mtime = info.lastModified().toMSecsSinceEpoch();
+    const qint64 size = info.size();
+
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_entries.constFind(filePath);
+        if (it != m_entries.constEnd() && it->mtime == mtime && it->size == size) {
+            ++m_hits;
+            return it->durationUs;
+        }
+        ++m_misses;
+    }
+
+    // Probe outside the lock; only headers are read so this stays cheap
+    Entry entry;
+    entry.mtime = mtime;
+    entry.size = size;
+    entry.durationUs = MediaProbe::durationUs(filePath);
+
+    QMutexLocker locker(&m_mutex);
+    m_entries.insert(filePath, entry);
+    m_pending.insert(filePath, entry);
+    m_pendingRemovals.removeAll(filePath);
+    scheduleFlush();
+    return entry.durationUs;
+}
+
+void DurationCache::store(const QString& filePath, qint64 durationUs)
+{
+    const QFileInfo info(filePath);
+    if (durationUs < 0 || !info.exists()) {
+        return;
+    }
+
+    Entry entry;
+    entry.mtime = info.lastModified().toMSecsSinceEpoch();
+    entry.size = info.size();
+    entry.durationUs = durationUs;
+
+    QMutexLocker locker(&m_mutex);
+    m_entries.insert(filePath, entry);
+    m_pending.insert(filePath, entry);
+    m_pendingRemovals.removeAll(filePath);
+    scheduleFlush();
+}
+
+void DurationCache::invalidate(const QString& filePath)
+{
+    QMutexLocker locker(&m_mutex);
+
+    const bool wasCached = m_entries.remove(filePath) > 0;
+    m_pending.remove(filePath);
+    if (wasCached) {
+        m_pendingRemovals.append(filePath);
+        scheduleFlush();
+    }
+}
+
+bool DurationCache::flush()
+{
+    QMutexLocker locker(&m_mutex);
+    m_flushScheduled = false;
+
+    if (!m_initialized || (m_pending.isEmpty() && m_pendingRemovals.isEmpty())) {
+        return true;
+    }
+
+    if (!m_database.isOpen()) {
+        logError("flush", "Database is not open");
+        return false;
+    }
+
+    if (!m_database.transaction()) {
+        logError("flush", QString("Failed to start transaction: %1").arg(m_database.lastError().text()));
+        return false;
+    }
+
+    QSqlQuery upsert(m_database);
+    upsert.prepare("INSERT OR REPLACE INTO duration_cache (path, mtime, size, duration_us) "
+                   "VALUES (?, ?, ?, ?)");
+
+    for (auto it = m_pending.constBegin(); it != m_pending.constEnd(); ++it) {
+        upsert.addBindValue(it.key());
+        upsert.addBindValue(it->mtime);
+        upsert.addBindValue(it->size);
+        upsert.addBindValue(it->durationUs);
+        if (!upsert.exec()) {
+            QString error = QString("SQL Error: %1").arg(upsert.lastError().text());
+            logError("flush", error, upsert.lastQuery());
+            m_database.rollback();
+            emit operationError("flush", error);
+            return false;
+        }
+    }
+
+    QSqlQuery remove(m_database);
+    remove.prepare("DELETE FROM duration_cache WHERE path = ?");
+
+    for (const QString& path : std::as_const(m_pendingRemovals)) {
+        remove.addBindValue(path);
+        if (!remove.exec()) {
+            QString error = QString("SQL Error: %1").arg(remove.lastError().text());
+            logError("flush", error, remove.lastQuery());
+            m_database.rollback();
+            emit operationError("flush", error);
+            return false;
+        }
+    }
+
+    if (!m_database.commit()) {
+        QString error = QString("Failed to commit: %1").arg(m_database.lastError().text());
+        logError("flush", error);
+        m_database.rollback();
+        emit operationError("flush", error);
+        return false;
+    }
+
+    m_pending.clear();
+    m_pendingRemovals.clear();
+    return true;
+}
+
+DurationCache::Statistics DurationCache::statistics() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    Statistics stats;
+    stats.entries = m_entries.size();
+    stats.hits = m_hits;
+    stats.misses = m_misses;
+    stats.pendingWrites = m_pending.size() + m_pendingRemovals.size();
+    return stats;
+}
+
+bool DurationCache::ensureTable()
+{
+    QSqlQuery query(m_database);
+    const QString sql = "CREATE TABLE IF NOT EXISTS duration_cache ("
+                        "path TEXT PRIMARY KEY NOT NULL, "
+                        "mtime INTEGER NOT NULL, "
+                        "size INTEGER NOT NULL, "
+                        "duration_us INTEGER NOT NULL)";
+
+    if (!query.exec(sql)) {
+        QString error = QString("SQL Error: %1").arg(query.lastError().text());
+        logError("ensureTable", error, sql);
+        emit operationError("ensureTable", error);
+        return false;
+    }
+
+    return true;
+}
+
+void DurationCache::loadEntries()
+{
+    QSqlQuery query(m_database);
+    query.setForwardOnly(true);
+
+    if (!query.exec("SELECT path, mtime, size, duration_us FROM duration_cache")) {
+        logError("loadEntries", QString("SQL Error: %1").arg(query.lastError().text()),
+                 query.lastQuery());
+        return;
+    }
+
+    while (query.next()) {
+        Entry entry;
+        entry.mtime = query.value(1).toLongLong();
+        entry.size = query.value(2).toLongLong();
+        entry.durationUs = query.value(3).toLongLong();
+        m_entries.insert(query.value(0).toString(), entry);
+    }
+
+    qDebug() << "DurationCache: loaded" << m_entries.size() << "cached durations";
+}
+
+void DurationCache::scheduleFlush()
+{
+    // Callers hold m_mutex
+    if (m_flushScheduled || !m_initialized) {
+        return;
+    }
+
+    m_flushScheduled = true;
+    QTimer::singleShot(0, this, [this]() { flush(); });
+}
+
+void DurationCache::logError(const QString& operation, const QString& error, const QString& query)
+{
+    QString logMessage = QString("DurationCache::%1 - %2").arg(operation, error);
+    if (!query.isEmpty()) {
+        logMessage += QString(" (Query: %1)").arg(query);
+    }
+
+    qWarning() << logMessage;
+}
@@ -0,0 +1,124 @@
+#ifndef DURATIONCACHE_H
+#define DURATIONCACHE_H
+
+#include <QObject>
+#include <QSqlDatabase>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+
+/**
+ * @brief Persistent cache of probed audio durations
+ *
+ * DurationCache sits in front of MediaProbe and remembers the duration of
+ * every file it has probed in the duration_cache table of the application
+ * database. Entries are keyed by path and validated against the file's
+ * modification time and size, so a file is only probed again when it is
+ * new or has changed on disk. All entries are loaded into memory when the
+ * cache is initialized; lookups afterwards only cost a stat() call.
+ *
+ * New and updated entries are written back in a single transaction when
+ * flush() is called, or automatically on the next event loop iteration.
+ *
+ * @example
+ * @code
+ * DurationCache cache(db);
+ * cache.initialize();
+ * qint64 us = cache.durationUs("/music/song.ogg"); // probes once
+ * us = cache.durationUs("/music/song.ogg");        // served from cache
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class DurationCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Cache usage counters
+     */
+    struct Statistics {
+        int entries = 0;       ///< Entries held in memory
+        int hits = 0;          ///< Lookups answered without probing
+        int misses = 0;        ///< Lookups that required a probe
+        int pendingWrites = 0; ///< Entries not yet written to the database
+    };
+
+    explicit DurationCache(QSqlDatabase& database, QObject* parent = nullptr);
+    ~DurationCache() override;
+
+    /**
+     * @brief Create the cache table if needed and load existing entries
+     * @return true if the table is available
+     */
+    bool initialize();
+
+    /**
+     * @brief Get the duration of a file, probing it only if it is not cached
+     * @param filePath Path of the audio file
+     * @return Duration in microseconds, or -1 if the file is missing or unreadable
+     */
+    qint64 durationUs(const QString& filePath);
+
+    /**
+     * @brief Record a duration read elsewhere, such as by an import on a pool thread
+     *
+     * The next durationUs() of the file is then a hit, so a track that was
+     * just imported is not probed again on the GUI thread.
+     * @param filePath Path of the audio file
+     * @param durationUs Duration in microseconds; ignored if negative
+     */
+    void store(const QString& filePath, qint64 durationUs);
+
+    /**
+     * @brief Drop the cached entry for a file
+     * @param filePath Path of the audio file
+     */
+    void invalidate(const QString& filePath);
+
+    /**
+     * @brief Write pending entries to the database
+     * @return true on success
+     */
+    bool flush();
+
+    /**
+     * @brief Get cache usage counters
+     * @return Current statistics
+     */
+    Statistics statistics() const;
+
+signals:
+    /**
+     * @brief Emitted when a database operation fails
+     * @param operation Name of the operation
+     * @param error Error message
+     */
+    void operationError(const QString& operation, const QString& error);
+
+private:
+    struct Entry {
+        qint64 mtime = 0;
+        qint64 size = 0;
+        qint64 durationUs = -1;
+    };
+
+    bool ensureTable();
+    void loadEntries();
+    void scheduleFlush();
+    void logError(const QString& operation, const QString& error, const QString& query = QString());
+
+    QSqlDatabase& m_database;
+    mutable QMutex m_mutex;
+    QHash<QString, Entry> m_entries;
+    QHash<QString, Entry> m_pending;
+    QStringList m_pendingRemovals;
+    bool m_initialized = false;
+    bool m_flushScheduled = false;
+    int m_hits = 0;
+    int m_misses = 0;
+};
+
+#endif // DURATIONCACHE_H
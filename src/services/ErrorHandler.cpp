@@ -5,6 +5,7 @@
 #include <QDir>
 #include <QDebug>
 #include <QThread>
+#include <QTimer>
 #include <mutex>
 
 // Logging categories
@@ -24,11 +25,17 @@ ErrorHandler::ErrorHandler(QObject* parent)
     , m_logLevel(ErrorSeverity::Info)
     , m_userDialogsEnabled(true)
     , m_initialized(false)
+    , m_summaryTimer(new QTimer(this))
 {
+    m_clock.start();
+    m_summaryTimer->setSingleShot(true);
+    m_summaryTimer->setInterval(SUPPRESSION_WINDOW_MS);
+    connect(m_summaryTimer, &QTimer::timeout, this, &ErrorHandler::flushSummaries);
 }
 
 ErrorHandler::~ErrorHandler()
 {
+    flushSummaries();
     if (m_logger) {
         m_logger->flush();
     }
@@ -73,6 +80,9 @@ bool ErrorHandler::initialize(const QString& logDirectory, int maxLogFiles, int
         return false;
     }
 
+    // The main window logs through the xfb.player categories (LogCategories.h)
+    m_logger->captureCategories("xfb.player");
+
     m_initialized = true;
 
     // Log initialization
@@ -103,6 +113,12 @@ void ErrorHandler::handleErrorInternal(ErrorSeverity severity,
                                      const QString& details,
                                      ErrorCategory category)
 {
+    if (!admit(severity, component, message, category)) {
+        // A repeat: counted for the summary, neither logged nor shown
+        emit errorOccurred(severity, component, message, details, category);
+        return;
+    }
+
     // Log the error
     QString fullMessage = message;
     if (!details.isEmpty()) {
@@ -203,15 +219,25 @@ void ErrorHandler::logMessage(ErrorSeverity severity,
         handler.initialize();
     }
 
-    if (handler.m_logger && handler.m_logger->isEnabled()) {
-        handler.m_logger->writeLog(static_cast<Logger::LogLevel>(severity),
-                                  component,
-                                  message,
-                                  categoryToString(category));
+    if (handler.admit(severity, component, message, category)) {
+        handler.writeMessage(severity, component, message, category);
+    }
+}
+
+void ErrorHandler::writeMessage(ErrorSeverity severity,
+                              const QString& component,
+                              const QString& message,
+                              ErrorCategory category)
+{
+    if (m_logger && m_logger->isEnabled()) {
+        m_logger->writeLog(static_cast<Logger::LogLevel>(severity),
+                          component,
+                          message,
+                          categoryToString(category));
     }
 
     // Emit signal
-    emit handler.messageLogged(severity, component, message, category);
+    emit messageLogged(severity, component, message, category);
 
     // Also use Qt's logging system for appropriate categories
     switch (category) {
@@ -288,6 +314,101 @@ void ErrorHandler::logMessage(ErrorSeverity severity,
     }
 }
 
+bool ErrorHandler::admit(ErrorSeverity severity,
+                         const QString& component,
+                         const QString& message,
+                         ErrorCategory category)
+{
+    const int window = m_suppressionWindow.load();
+    if (window <= 0) {
+        return true;
+    }
+
+    const Fingerprint fingerprint{severity, category, component, messageTemplate(message)};
+    const qint64 now = m_clock.elapsed();
+    bool first = false;
+    QList<Summary> expired;
+    {
+        QMutexLocker locker(&m_occurrenceMutex);
+        Occurrence& occurrence = m_occurrences[fingerprint];
+        first = occurrence.windowStart == 0 || now - occurrence.windowStart >= window;
+        if (first) {
+            // Without an event loop the timer never fires; summarize before starting over
+            if (occurrence.suppressed > 0) {
+                expired.append(Summary{fingerprint, occurrence});
+            }
+            occurrence = Occurrence{qMax<qint64>(now, 1), 0, QString()};
+        } else {
+            ++occurrence.suppressed;
+            occurrence.lastMessage = message;
+        }
+    }
+
+    if (first) {
+        writeSummaries(expired);
+        return true;
+    }
+    if (!m_summaryPending.exchange(true)) {
+        // The timer belongs to the handler's thread; start it there
+        QMetaObject::invokeMethod(m_summaryTimer, qOverload<>(&QTimer::start));
+    }
+    return false;
+}
+
+void ErrorHandler::flushSummaries()
+{
+    m_summaryPending.store(false);
+
+    const qint64 now = m_clock.elapsed();
+    const int window = m_suppressionWindow.load();
+    QList<Summary> summaries;
+    {
+        QMutexLocker locker(&m_occurrenceMutex);
+        for (auto it = m_occurrences.begin(); it != m_occurrences.end();) {
+            if (it->suppressed > 0) {
+                summaries.append(Summary{it.key(), it.value()});
+                // The storm may go on; its next repeats start a new summary
+                it->windowStart = qMax<qint64>(now, 1);
+                it->suppressed = 0;
+                it->lastMessage.clear();
+                ++it;
+            } else if (now - it->windowStart >= window) {
+                it = m_occurrences.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    writeSummaries(summaries);
+}
+
+void ErrorHandler::writeSummaries(const QList<Summary>& summaries)
+{
+    const qint64 now = m_clock.elapsed();
+    for (const Summary& summary : summaries) {
+        const qint64 seconds = qMax<qint64>(1, (now - summary.occurrence.windowStart + 999) / 1000);
+        writeMessage(summary.fingerprint.severity,
+                     summary.fingerprint.component,
+                     QString("Repeated %1 times in %2 s: %3")
+                         .arg(summary.occurrence.suppressed)
+                         .arg(seconds)
+                         .arg(summary.occurrence.lastMessage),
+                     summary.fingerprint.category);
+    }
+}
+
+void ErrorHandler::setSuppressionWindow(int milliseconds)
+{
+    m_suppressionWindow.store(qMax(0, milliseconds));
+    if (milliseconds > 0) {
+        QMetaObject::invokeMethod(m_summaryTimer, [this, milliseconds]() {
+            m_summaryTimer->setInterval(milliseconds);
+        });
+    } else {
+        flushSummaries();
+    }
+}
+
 void ErrorHandler::setLogLevel(ErrorSeverity severity)
 {
     m_logLevel = severity;
@@ -338,4 +459,57 @@ QString ErrorHandler::categoryToString(ErrorCategory category)
         return "File";
     }
     return "Unknown";
-}
\ No newline at end of file
+}
+
+QString ErrorHandler::messageTemplate(const QString& message)
+{
+    QString result;
+    result.reserve(message.size());
+
+    const qsizetype size = message.size();
+    qsizetype i = 0;
+    while (i < size) {
+        const QChar c = message.at(i);
+        if (c.isSpace()) {
+            result += c;
+            ++i;
+            continue;
+        }
+
+        // At the start of a word: quoted text, or a word that is a path
+        if (c == QLatin1Char('\'') || c == QLatin1Char('"')) {
+            const qsizetype close = message.indexOf(c, i + 1);
+            if (close > i) {
+                result += c;
+                result += QLatin1Char('*');
+                result += c;
+                i = close + 1;
+                continue;
+            }
+        }
+        qsizetype end = i;
+        bool path = false;
+        while (end < size && !message.at(end).isSpace()) {
+            const QChar w = message.at(end);
+            path = path || w == QLatin1Char('/') || w == QLatin1Char('\\');
+            ++end;
+        }
+        if (path) {
+            result += QLatin1Char('*');
+            i = end;
+            continue;
+        }
+
+        while (i < end) {
+            if (message.at(i).isDigit()) {
+                while (i < end && message.at(i).isDigit()) {
+                    ++i;
+                }
+                result += QLatin1Char('#');
+            } else {
+                result += message.at(i++);
+            }
+        }
+    }
+    return result;
+}
@@ -4,9 +4,13 @@
 #include <QObject>
 #include <QString>
 #include <QDateTime>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
 #include <QLoggingCategory>
 #include <QMessageBox>
 #include <QWidget>
+#include <atomic>
 #include <memory>
 #include <mutex>
 
@@ -17,6 +21,7 @@ Q_DECLARE_LOGGING_CATEGORY(xfbNetwork)
 Q_DECLARE_LOGGING_CATEGORY(xfbUI)
 
 class Logger;
+class QTimer;
 
 /**
  * @brief Centralized error handling and logging system for XFB
@@ -25,6 +30,14 @@ class Logger;
  * and user notification throughout the XFB application. It supports different
  * severity levels and provides both programmatic and user-friendly error handling.
  * 
+ * Repeats are logged once per window. Messages with the same severity,
+ * category, component and messageTemplate() count as one error; the first
+ * is logged and may raise a dialog, the repeats within suppressionWindow()
+ * are only counted. Once per window a summary with the count and the last
+ * message goes to the log instead. A share that goes away while a thousand
+ * files are read costs a line every few seconds, not a thousand lines and
+ * dialogs. errorOccurred() is still emitted for every error.
+ * 
  * @example
  * @code
  * ErrorHandler::handleError(ErrorHandler::ErrorSeverity::Error,
@@ -62,6 +75,8 @@ public:
         File        ///< File system errors
     };
 
+    static constexpr int SUPPRESSION_WINDOW_MS = 10000;   ///< Default window for repeats
+
     /**
      * @brief Get the singleton instance of ErrorHandler
      * @return Reference to the ErrorHandler instance
@@ -153,6 +168,20 @@ public:
      */
     void setUserDialogsEnabled(bool enabled);
 
+    /**
+     * @brief Set how long repeats of an error are counted instead of logged
+     * @param milliseconds Window length; 0 logs every repeat
+     */
+    void setSuppressionWindow(int milliseconds);
+    int suppressionWindow() const { return m_suppressionWindow.load(); }
+
+    /**
+     * @brief Log the summaries of the repeats counted so far
+     *
+     * Runs by itself once per window while repeats are being counted.
+     */
+    void flushSummaries();
+
     /**
      * @brief Get the current log directory
      * @return Path to the log directory
@@ -173,6 +202,15 @@ public:
      */
     static QString categoryToString(ErrorCategory category);
 
+    /**
+     * @brief A message with what varies between repeats taken out
+     *
+     * Numbers become '#'; quoted text and words with a path separator
+     * become '*'. "Cannot open /nas/12.mp3" and "Cannot open /nas/13.mp3"
+     * have the same template.
+     */
+    static QString messageTemplate(const QString& message);
+
 signals:
     /**
      * @brief Emitted when an error occurs
@@ -218,12 +256,63 @@ private:
                        const QString& details,
                        QWidget* parent);
 
+    void writeMessage(ErrorSeverity severity,
+                     const QString& component,
+                     const QString& message,
+                     ErrorCategory category);
+
+    /**
+     * @brief Whether a message is the first of its window, counting it if not
+     */
+    bool admit(ErrorSeverity severity,
+              const QString& component,
+              const QString& message,
+              ErrorCategory category);
+
+    struct Fingerprint {
+        ErrorSeverity severity;
+        ErrorCategory category;
+        QString component;
+        QString messageTemplate;
+
+        bool operator==(const Fingerprint& other) const
+        {
+            return severity == other.severity && category == other.category
+                   && component == other.component && messageTemplate == other.messageTemplate;
+        }
+    };
+    friend size_t qHash(const Fingerprint& fingerprint, size_t seed) noexcept
+    {
+        return qHashMulti(seed, int(fingerprint.severity), int(fingerprint.category),
+                          fingerprint.component, fingerprint.messageTemplate);
+    }
+
+    struct Occurrence {
+        qint64 windowStart = 0;    ///< m_clock milliseconds
+        int suppressed = 0;
+        QString lastMessage;
+    };
+
+    struct Summary {
+        Fingerprint fingerprint;
+        Occurrence occurrence;
+    };
+
+    void writeSummaries(const QList<Summary>& summaries);
+
     std::unique_ptr<Logger> m_logger;
     ErrorSeverity m_logLevel;
     bool m_userDialogsEnabled;
     QString m_logDirectory;
     bool m_initialized;
 
+    QMutex m_occurrenceMutex;
+    QHash<Fingerprint, Occurrence> m_occurrences;   ///< Guarded by m_occurrenceMutex
+    QElapsedTimer m_clock;
+    std::atomic<int> m_suppressionWindow{SUPPRESSION_WINDOW_MS};
+    std::atomic<bool> m_summaryPending{false};
+    QTimer* m_summaryTimer;
+
     // Singleton pattern
     static std::unique_ptr<ErrorHandler> s_instance;
     static std::once_flag s_onceFlag;
@@ -0,0 +1,162 @@
+#include "EventJournal.h"
+#include "Logger.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QStandardPaths>
+
+namespace {
+
+struct TypeName {
+    EventJournal::Type type;
+    const char* name;
+};
+
+constexpr TypeName TYPE_NAMES[] = {
+    {EventJournal::Type::TrackStart, "track_start"},
+    {EventJournal::Type::TrackStop, "track_stop"},
+    {EventJournal::Type::Scheduled, "scheduled"},
+    {EventJournal::Type::TakeOver, "takeover"},
+    {EventJournal::Type::Error, "error"},
+};
+
+// Logger names its files prefix_yyyyMMdd_hhmmss plus the extension
+QDateTime fileStart(const QString& fileName)
+{
+    const int prefix = int(qstrlen(EventJournal::FILE_PREFIX)) + 1;
+    const int extension = int(qstrlen(EventJournal::FILE_EXTENSION));
+    return QDateTime::fromString(fileName.mid(prefix, fileName.size() - prefix - extension),
+                                 "yyyyMMdd_hhmmss");
+}
+
+} // namespace
+
+EventJournal::EventJournal(QObject* parent)
+    : QObject(parent)
+    , m_logger(new Logger(this))
+{
+    m_logger->setFileNames(FILE_PREFIX, FILE_EXTENSION);
+    m_logger->setPlainLines(true);
+}
+
+EventJournal::~EventJournal() = default;
+
+QString EventJournal::defaultLocation()
+{
+    const QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    return QDir(dataDir).filePath("journal");
+}
+
+bool EventJournal::open(const QString& directory)
+{
+    m_directory = directory;
+    if (!m_logger->initialize(directory, MAX_FILES, MAX_FILE_MB)) {
+        logError("open", QString("Cannot write to %1").arg(directory));
+        return false;
+    }
+    return true;
+}
+
+bool EventJournal::isOpen() const
+{
+    return m_logger->isEnabled();
+}
+
+void EventJournal::record(Type type, const QJsonObject& fields, const QDateTime& time)
+{
+    if (!m_logger->isEnabled()) {
+        return;
+    }
+    QJsonObject object = fields;
+    object.insert("time", formatTime(time));
+    object.insert("type", typeName(type));
+    m_logger->writeLog(Logger::LogLevel::Info, QString(),
+                       QString::fromUtf8(QJsonDocument(object).toJson(QJsonDocument::Compact)));
+}
+
+void EventJournal::flush()
+{
+    m_logger->flush();
+}
+
+QList<EventJournal::Event> EventJournal::read(const QString& directory, const QDateTime& from,
+                                              const QDateTime& to)
+{
+    QList<Event> events;
+    const QString pattern =
+        QString("%1_*%2").arg(QLatin1String(FILE_PREFIX), QLatin1String(FILE_EXTENSION));
+    const QStringList files = QDir(directory).entryList(QStringList() << pattern, QDir::Files,
+                                                        QDir::Name);
+    for (int i = 0; i < files.size(); ++i) {
+        // A file holds the events from its own start to the next file's;
+        // names only have whole seconds, hence the second of slack
+        const QDateTime start = fileStart(files[i]);
+        if (start.isValid() && start >= to) {
+            break;
+        }
+        if (i + 1 < files.size()) {
+            const QDateTime next = fileStart(files[i + 1]);
+            if (next.isValid() && next.addSecs(1) <= from) {
+                continue;
+            }
+        }
+
+        QFile file(QDir(directory).filePath(files[i]));
+        if (!file.open(QIODevice::ReadOnly)) {
+            qWarning() << "EventJournal: cannot read" << file.fileName();
+            continue;
+        }
+        while (!file.atEnd()) {
+            const QByteArray line = file.readLine().trimmed();
+            if (line.isEmpty()) {
+                continue;
+            }
+            // A line cut short by a crash does not parse and is skipped
+            QJsonObject object = QJsonDocument::fromJson(line).object();
+            Event event;
+            event.time = QDateTime::fromString(object.value("time").toString(), Qt::ISODateWithMs);
+            if (!event.time.isValid() || event.time < from || event.time >= to ||
+                !typeFromName(object.value("type").toString(), &event.type)) {
+                continue;
+            }
+            object.remove("time");
+            object.remove("type");
+            event.fields = object;
+            events.append(event);
+        }
+    }
+    return events;
+}
+
+QString EventJournal::typeName(Type type)
+{
+    for (const TypeName& entry : TYPE_NAMES) {
+        if (entry.type == type) {
+            return QString::fromLatin1(entry.name);
+        }
+    }
+    return QString();
+}
+
+bool EventJournal::typeFromName(const QString& name, Type* type)
+{
+    for (const TypeName& entry : TYPE_NAMES) {
+        if (name == QLatin1String(entry.name)) {
+            *type = entry.type;
+            return true;
+        }
+    }
+    return false;
+}
+
+QString EventJournal::formatTime(const QDateTime& time)
+{
+    return time.toOffsetFromUtc(time.offsetFromUtc()).toString(Qt::ISODateWithMs);
+}
+
+void EventJournal::logError(const QString& operation, const QString& error)
+{
+    qWarning() << QString("EventJournal::%1 - %2").arg(operation, error);
+    emit operationError(operation, error);
+}
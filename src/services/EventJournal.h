@@ -0,0 +1,152 @@
+#ifndef EVENTJOURNAL_H
+#define EVENTJOURNAL_H
+
+#include <QDateTime>
+#include <QJsonObject>
+#include <QList>
+#include <QObject>
+#include <QString>
+
+class Logger;
+
+/**
+ * @brief Append-only journal of what went on air, for as-run reports
+ *
+ * The history list on screen keeps the last 100 tracks, and scheduler
+ * firings only showed up in debug output. EventJournal writes one JSON
+ * object per line for each track start and stop, scheduler firing,
+ * TakeOver change and error:
+ * @code
+ * {"path":"/music/song.ogg","time":"2026-10-14T12:00:00.000+01:00","type":"track_start"}
+ * @endcode
+ *
+ * The lines are written by a Logger of the journal's own in plain line
+ * mode, so record() only builds the line and queues it; the file is
+ * written on the logger's writer thread. Files rotate at MAX_FILE_MB and
+ * the oldest beyond MAX_FILES are removed, so the journal can stay on
+ * around the clock.
+ *
+ * read() collects the events of a time range from the files, skipping
+ * those that cannot hold any, and any line that was cut short by a crash.
+ *
+ * @example
+ * @code
+ * EventJournal journal;
+ * journal.open(EventJournal::defaultLocation());
+ * journal.record(EventJournal::Type::TrackStart, {{"path", "/music/song.ogg"}});
+ * const QDateTime midnight(QDate::currentDate(), QTime(0, 0));
+ * const auto events = EventJournal::read(journal.directory(), midnight, midnight.addDays(1));
+ * for (const EventJournal::Event& event : events)
+ *     qInfo() << event.time << EventJournal::typeName(event.type) << event.fields;
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class EventJournal : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief What an event records
+     */
+    enum class Type {
+        TrackStart,   ///< A track went on air
+        TrackStop,    ///< The track on air ended, was stopped or replaced
+        Scheduled,    ///< The scheduler fired
+        TakeOver,     ///< A TakeOver started or ended
+        Error         ///< An error was reported
+    };
+    Q_ENUM(Type)
+
+    /**
+     * @brief An event read back from the journal
+     */
+    struct Event {
+        QDateTime time;
+        Type type = Type::Error;
+        QJsonObject fields;   ///< Everything but the time and type
+    };
+
+    static constexpr const char* FILE_PREFIX = "events";
+    static constexpr const char* FILE_EXTENSION = ".jsonl";
+    static constexpr int MAX_FILES = 100;
+    static constexpr int MAX_FILE_MB = 10;
+
+    explicit EventJournal(QObject* parent = nullptr);
+    ~EventJournal() override;
+
+    /**
+     * @brief Default directory of the journal, under the application data
+     */
+    static QString defaultLocation();
+
+    /**
+     * @brief Start writing to a directory
+     * @param directory Directory of the journal files; created if needed
+     * @return true if the journal is open
+     */
+    bool open(const QString& directory);
+    bool isOpen() const;
+    QString directory() const { return m_directory; }
+
+    /**
+     * @brief Queue an event
+     *
+     * Does nothing until open() succeeds. The "time" and "type" fields are
+     * set by the journal and override any in @p fields.
+     * @param type What happened
+     * @param fields Details of the event
+     * @param time When it happened (defaults to now)
+     */
+    void record(Type type, const QJsonObject& fields = QJsonObject(),
+                const QDateTime& time = QDateTime::currentDateTime());
+
+    /**
+     * @brief Write every event queued so far, and wait for it
+     */
+    void flush();
+
+    /**
+     * @brief Read the events of a time range
+     * @param directory Directory of the journal files
+     * @param from First time to include
+     * @param to Time after the last to include
+     * @return Events in the order they were written
+     */
+    static QList<Event> read(const QString& directory, const QDateTime& from, const QDateTime& to);
+
+    /**
+     * @brief Name of a type in the journal, e.g. "track_start"
+     */
+    static QString typeName(Type type);
+
+    /**
+     * @brief Type for a name written by typeName()
+     * @param name Name in the journal
+     * @param type Set to the type if the name is known
+     * @return true if the name is known
+     */
+    static bool typeFromName(const QString& name, Type* type);
+
+    /**
+     * @brief Format of the time field
+     */
+    static QString formatTime(const QDateTime& time);
+
+signals:
+    /**
+     * @brief Emitted when the journal cannot be opened
+     * @param operation Name of the operation
+     * @param error Error message
+     */
+    void operationError(const QString& operation, const QString& error);
+
+private:
+    void logError(const QString& operation, const QString& error);
+
+    Logger* m_logger;
+    QString m_directory;
+};
+
+#endif // EVENTJOURNAL_H
@@ -0,0 +1,327 @@
+#include "ExifToolPool.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+#include <QStandardPaths>
+#include <QTimer>
+
+ExifToolPool* ExifToolPool::instance()
+{
+    static QPointer<ExifToolPool> pool;
+    if (!pool) {
+        pool = new ExifToolPool(QCoreApplication::instance());
+        pool->setProgram(findProgram());
+    }
+    return pool;
+}
+
+QString ExifToolPool::findProgram()
+{
+    QString program = QStandardPaths::findExecutable("exiftool");
+
+#ifdef Q_OS_WIN
+    // The standalone Windows build is shipped under this name
+    if (program.isEmpty()) {
+        program = QStandardPaths::findExecutable("exiftool(-k)");
+    }
+#endif
+
+#ifdef Q_OS_MACOS
+    // Applications started from the Finder do not get the shell's PATH
+    if (program.isEmpty()) {
+        const QStringList commonPaths = {
+            "/opt/homebrew/bin/exiftool",  // Homebrew on Apple Silicon
+            "/usr/local/bin/exiftool",     // Homebrew on Intel Macs and the installer package
+            "/opt/local/bin/exiftool"      // MacPorts
+        };
+        for (const QString& path : commonPaths) {
+            if (QFile::exists(path)) {
+                program = path;
+                break;
+            }
+        }
+    }
+#endif
+
+    return program;
+}
+
+ExifToolPool::ExifToolPool(QObject* parent)
+    : QObject(parent)
+{
+}
+
+ExifToolPool::~ExifToolPool()
+{
+    // Whoever asked may be gone already, so nobody is answered
+    m_queue.clear();
+    for (Worker& worker : m_workers) {
+        worker.busy = false;
+    }
+    shutdown();
+}
+
+void ExifToolPool::setWorkers(int workers)
+{
+    m_maxWorkers = qMax(1, workers);
+    dispatch();
+}
+
+int ExifToolPool::request(const QString& path, const QStringList& tags, QObject* context,
+                          Callback callback)
+{
+    Job job;
+    job.id = m_nextId++;
+    job.path = path;
+    job.tags = tags;
+    job.context = context;
+    job.guarded = context != nullptr;
+    job.callback = std::move(callback);
+    const int id = job.id;
+
+    if (m_program.isEmpty()) {
+        failLater(job, "exiftool is not installed");
+    } else if (path.isEmpty() || path.contains('\n')) {
+        // Arguments are passed one per line
+        failLater(job, QString("cannot pass %1 to exiftool").arg(path));
+    } else {
+        m_queue.append(std::move(job));
+        dispatch();
+    }
+    return id;
+}
+
+ExifToolPool::Result ExifToolPool::query(const QString& path, const QStringList& tags)
+{
+    Result result;
+    bool done = false;
+    QEventLoop loop;
+    request(path, tags, &loop, [&](const Result& answer) {
+        result = answer;
+        done = true;
+        loop.quit();
+    });
+    if (!done) {
+        loop.exec(QEventLoop::ExcludeUserInputEvents);
+    }
+    return result;
+}
+
+QString ExifToolPool::duration(const QString& path)
+{
+    const Result result = query(path, {"Duration"});
+    return result.value("Duration").section(" (", 0, 0).trimmed();
+}
+
+void ExifToolPool::shutdown()
+{
+    const QList<QProcess*> processes = m_workers.keys();
+    for (QProcess* process : processes) {
+        dropWorker(process, "exiftool was stopped", true);
+    }
+    while (!m_queue.isEmpty()) {
+        Result result;
+        result.error = "exiftool was stopped";
+        complete(m_queue.takeFirst(), result);
+    }
+}
+
+int ExifToolPool::pendingCount() const
+{
+    int pending = int(m_queue.size());
+    for (const Worker& worker : m_workers) {
+        if (worker.busy) {
+            ++pending;
+        }
+    }
+    return pending;
+}
+
+void ExifToolPool::dispatch()
+{
+    while (!m_queue.isEmpty()) {
+        QProcess* idle = nullptr;
+        for (auto it = m_workers.cbegin(); it != m_workers.cend(); ++it) {
+            if (!it->busy) {
+                idle = it.key();
+                break;
+            }
+        }
+        if (!idle) {
+            if (m_workers.size() >= m_maxWorkers) {
+                return;
+            }
+            idle = startWorker();
+            // A process that failed to start already failed the queue
+            if (!m_workers.contains(idle)) {
+                return;
+            }
+        }
+        send(idle, m_queue.takeFirst());
+    }
+}
+
+QProcess* ExifToolPool::startWorker()
+{
+    QProcess* process = new QProcess(this);
+    Worker& worker = m_workers[process];
+    worker.timeout = new QTimer(process);
+    worker.timeout->setSingleShot(true);
+
+    connect(worker.timeout, &QTimer::timeout, this, [this, process]() {
+        qWarning() << "ExifToolPool: exiftool took over" << m_timeoutMs << "ms, restarting it";
+        dropWorker(process, QString("exiftool timed out after %1 ms").arg(m_timeoutMs), false);
+        dispatch();
+    });
+    connect(process, &QProcess::readyReadStandardOutput, this,
+            [this, process]() { readOutput(process); });
+    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
+            [this, process]() {
+                dropWorker(process, "exiftool exited", false);
+                dispatch();
+            });
+    connect(process, &QProcess::errorOccurred, this, [this, process](QProcess::ProcessError error) {
+        if (error != QProcess::FailedToStart) {
+            return;
+        }
+        const QString reason =
+            QString("cannot start %1: %2").arg(m_program, process->errorString());
+        qWarning() << "ExifToolPool:" << reason;
+        dropWorker(process, reason, false);
+        // Every request would fail the same way
+        while (!m_queue.isEmpty()) {
+            failLater(m_queue.takeFirst(), reason);
+        }
+    });
+
+    // Errors about a file then come before its {ready} line
+    process->setProcessChannelMode(QProcess::MergedChannels);
+    ++m_started;
+    process->start(m_program, {"-stay_open", "True", "-@", "-"});
+    return process;
+}
+
+void ExifToolPool::send(QProcess* process, Job job)
+{
+    Worker& worker = m_workers[process];
+
+    // Short "Tag: value" lines, and file names in UTF-8 on every platform
+    QByteArray arguments = "-S\n-charset\nfilename=UTF8\n";
+    for (const QString& tag : std::as_const(job.tags)) {
+        if (!tag.isEmpty() && !tag.contains('\n')) {
+            arguments += '-' + tag.toUtf8() + '\n';
+        }
+    }
+    // Absolute, so a name starting with '-' is not taken for an option
+    arguments += QDir::toNativeSeparators(QFileInfo(job.path).absoluteFilePath()).toUtf8() + '\n';
+    arguments += "-execute" + QByteArray::number(job.id) + '\n';
+
+    worker.output.clear();
+    worker.job = std::move(job);
+    worker.busy = true;
+    if (m_timeoutMs > 0) {
+        worker.timeout->start(m_timeoutMs);
+    }
+    process->write(arguments);
+}
+
+void ExifToolPool::readOutput(QProcess* process)
+{
+    auto it = m_workers.find(process);
+    if (it == m_workers.end()) {
+        return;
+    }
+    it->output += process->readAllStandardOutput();
+    if (!it->busy) {
+        it->output.clear();
+        return;
+    }
+
+    const QByteArray marker = "{ready" + QByteArray::number(it->job.id) + '}';
+    const int at = it->output.indexOf(marker);
+    if (at < 0) {
+        return;
+    }
+    it->timeout->stop();
+    Result result = parse(it->output.left(at));
+    Job job = std::move(it->job);
+    it->job = Job();
+    it->busy = false;
+    it->output.clear();
+
+    // The callback may queue more, which can add workers, so nothing of it is kept
+    complete(std::move(job), std::move(result));
+    dispatch();
+}
+
+void ExifToolPool::dropWorker(QProcess* process, const QString& error, bool graceful)
+{
+    auto it = m_workers.find(process);
+    if (it == m_workers.end()) {
+        return;
+    }
+    Worker worker = std::move(*it);
+    m_workers.erase(it);
+    worker.timeout->stop();
+    process->disconnect(this);
+
+    if (process->state() != QProcess::NotRunning) {
+        if (graceful) {
+            process->write("-stay_open\nFalse\n");
+            process->closeWriteChannel();
+        }
+        if (!graceful || !process->waitForFinished(STOP_TIMEOUT_MS)) {
+            process->kill();
+            process->waitForFinished(STOP_TIMEOUT_MS);
+        }
+    }
+    process->deleteLater();
+
+    if (worker.busy) {
+        Result result;
+        result.error = error;
+        complete(std::move(worker.job), std::move(result));
+    }
+}
+
+void ExifToolPool::complete(Job job, Result result)
+{
+    result.id = job.id;
+    result.path = job.path;
+    if (job.callback && (!job.guarded || job.context)) {
+        job.callback(result);
+    }
+    emit finished(result);
+}
+
+void ExifToolPool::failLater(Job job, const QString& error)
+{
+    QTimer::singleShot(0, this, [this, job, error]() {
+        Result result;
+        result.error = error;
+        complete(job, result);
+    });
+}
+
+ExifToolPool::Result ExifToolPool::parse(const QByteArray& output)
+{
+    Result result;
+    for (const QByteArray& raw : output.split('\n')) {
+        const QString line = QString::fromUtf8(raw).trimmed();
+        const int colon = line.indexOf(": ");
+        if (colon > 0) {
+            result.tags.insert(line.left(colon), line.mid(colon + 2));
+        }
+    }
+
+    // A warning about a file that was still read is not a failure
+    if (result.tags.contains("Error")) {
+        result.error = result.tags.take("Error");
+    }
+    result.ok = result.error.isEmpty();
+    return result;
+}
@@ -0,0 +1,187 @@
+#ifndef EXIFTOOLPOOL_H
+#define EXIFTOOLPOOL_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <QStringList>
+#include <functional>
+
+class QProcess;
+class QTimer;
+
+/**
+ * @brief Resident exiftool processes that read tags for anything MediaProbe cannot
+ *
+ * Each exiftool run starts a Perl interpreter, which costs about 200 ms
+ * before a single byte of the file is read; the add-track dialogs paid
+ * that on every file they could not probe natively. ExifToolPool keeps up
+ * to workers() processes running as "exiftool -stay_open True -@ -" and
+ * writes each request to one of them as an argument list ending in
+ * -execute<id>. The process answers with the tags, then {ready<id>}, and
+ * stays around for the next file, so a request costs a few milliseconds.
+ *
+ * Requests are answered asynchronously, in any order, through the
+ * callback given to request(); query() waits for one in a local event
+ * loop, for code that cannot be made asynchronous yet. A process that
+ * takes longer than timeout() on a file is killed and a new one started
+ * for the next request.
+ *
+ * Tags are printed by exiftool, not as numbers, so a Duration reads
+ * "0:03:45" as it always did in the library.
+ *
+ * @example
+ * @code
+ * ExifToolPool* exiftool = ExifToolPool::instance();
+ * exiftool->request(path, {"Duration"}, this, [this](const ExifToolPool::Result& result) {
+ *     if (result.ok)
+ *         showDuration(result.value("Duration"));
+ * });
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class ExifToolPool : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int DEFAULT_WORKERS = 2;
+    static constexpr int DEFAULT_TIMEOUT_MS = 10000;
+    static constexpr int STOP_TIMEOUT_MS = 1000;
+
+    /**
+     * @brief Tags exiftool read from one file
+     */
+    struct Result {
+        int id = 0;
+        QString path;
+        bool ok = false;               ///< false if the file could not be read
+        QHash<QString, QString> tags;  ///< Value of each tag found, by tag name
+        QString error;
+
+        QString value(const QString& tag) const { return tags.value(tag); }
+    };
+
+    using Callback = std::function<void(const ExifToolPool::Result&)>;
+
+    /**
+     * @brief The pool of the application, running findProgram(); call it first on the GUI thread
+     */
+    static ExifToolPool* instance();
+
+    /**
+     * @brief Find the exiftool executable
+     * @return Path of exiftool, or an empty string if it is not installed
+     */
+    static QString findProgram();
+
+    explicit ExifToolPool(QObject* parent = nullptr);
+    ~ExifToolPool() override;
+
+    void setProgram(const QString& program) { m_program = program; }
+    QString program() const { return m_program; }
+
+    /**
+     * @brief Set how many exiftool processes may run at once
+     * @param workers Process count; DEFAULT_WORKERS by default
+     */
+    void setWorkers(int workers);
+    int workers() const { return m_maxWorkers; }
+
+    /**
+     * @brief Set how long a process may take on one file before it is killed
+     * @param timeoutMs Time in milliseconds; 0 waits for ever
+     */
+    void setTimeout(int timeoutMs) { m_timeoutMs = qMax(0, timeoutMs); }
+    int timeout() const { return m_timeoutMs; }
+
+    /**
+     * @brief Read tags of a file, answering later
+     * @param path File to read
+     * @param tags Tag names, such as "Duration"
+     * @param context The callback is dropped if this object is destroyed first; may be null
+     * @param callback Receives the result on the thread of the pool, never from inside request()
+     * @return Id of the request, as in Result::id
+     */
+    int request(const QString& path, const QStringList& tags, QObject* context,
+                Callback callback);
+
+    /**
+     * @brief Read tags of a file and wait for them
+     *
+     * Runs a local event loop, without user input, until the answer comes
+     * or the request times out.
+     */
+    Result query(const QString& path, const QStringList& tags);
+
+    /**
+     * @brief Duration of a file as exiftool prints it, such as "0:03:45"
+     *
+     * The " (approx)" exiftool adds to estimated durations is left out.
+     * @return Empty if exiftool could not tell
+     */
+    QString duration(const QString& path);
+
+    /**
+     * @brief Have every process exit, failing the requests not answered yet
+     */
+    void shutdown();
+
+    /**
+     * @brief Requests not answered yet, waiting or being read
+     */
+    int pendingCount() const;
+
+    int runningWorkers() const { return int(m_workers.size()); }
+
+    /**
+     * @brief Processes started since the pool was made
+     */
+    int startedWorkers() const { return m_started; }
+
+signals:
+    /**
+     * @brief Emitted for every answered request, after its callback
+     */
+    void finished(const ExifToolPool::Result& result);
+
+private:
+    struct Job {
+        int id = 0;
+        QString path;
+        QStringList tags;
+        QPointer<QObject> context;
+        bool guarded = false;   ///< Whether a context was given
+        Callback callback;
+    };
+
+    struct Worker {
+        QByteArray output;
+        QTimer* timeout = nullptr;
+        Job job;
+        bool busy = false;
+    };
+
+    void dispatch();
+    QProcess* startWorker();
+    void send(QProcess* process, Job job);
+    void readOutput(QProcess* process);
+    void dropWorker(QProcess* process, const QString& error, bool graceful);
+    void complete(Job job, Result result);
+    void failLater(Job job, const QString& error);
+    static Result parse(const QByteArray& output);
+
+    QString m_program;
+    int m_maxWorkers = DEFAULT_WORKERS;
+    int m_timeoutMs = DEFAULT_TIMEOUT_MS;
+    int m_nextId = 1;
+    int m_started = 0;
+    QList<Job> m_queue;
+    QHash<QProcess*, Worker> m_workers;
+};
+
+#endif // EXIFTOOLPOOL_H
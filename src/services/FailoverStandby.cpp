@@ -0,0 +1,97 @@
+#include "FailoverStandby.h"
+#include <QDebug>
+
+FailoverStandby::FailoverStandby(QObject* parent)
+    : QObject(parent)
+{
+}
+
+void FailoverStandby::arm()
+{
+    if (m_armed) {
+        return;
+    }
+    m_armed = true;
+    qInfo() << "FailoverStandby: armed with" << (m_source.isEmpty() ? QString("nothing") : m_source);
+
+    if (m_source.isEmpty()) {
+        emit standbyMissing();
+    } else if (m_prefetcher) {
+        m_prefetcher(m_source);
+    }
+}
+
+void FailoverStandby::disarm()
+{
+    m_armed = false;
+    m_outageClock.invalidate();
+    m_switchClock.invalidate();
+}
+
+void FailoverStandby::setStandbySource(const QString& filePath)
+{
+    if (filePath == m_source) {
+        return;
+    }
+    m_source = filePath;
+    if (!m_armed) {
+        return;
+    }
+
+    if (m_source.isEmpty()) {
+        emit standbyMissing();
+    } else if (m_prefetcher) {
+        m_prefetcher(m_source);
+    }
+}
+
+void FailoverStandby::probeFailed(int probeMs)
+{
+    if (!m_armed || m_outageClock.isValid()) {
+        return;
+    }
+    m_outageClock.start();
+    m_outageOffsetMs = qMax(0, probeMs);
+}
+
+void FailoverStandby::probeSucceeded()
+{
+    m_outageClock.invalidate();
+}
+
+void FailoverStandby::beginFailover()
+{
+    if (m_switchClock.isValid()) {
+        return;
+    }
+    m_detectionMs = m_outageClock.isValid() ? m_outageClock.elapsed() + m_outageOffsetMs : 0;
+    m_outageClock.invalidate();
+    m_coldStart = !isReady();
+    m_switchClock.start();
+}
+
+void FailoverStandby::completeFailover()
+{
+    if (!m_switchClock.isValid()) {
+        return;
+    }
+    const qint64 switchMs = m_switchClock.elapsed();
+    m_switchClock.invalidate();
+
+    ++m_stats.failovers;
+    if (m_coldStart) {
+        ++m_stats.coldStarts;
+    }
+    m_stats.lastDetectionMs = m_detectionMs;
+    m_stats.lastSwitchMs = switchMs;
+    m_stats.worstLatencyMs = qMax(m_stats.worstLatencyMs, m_stats.lastLatencyMs());
+    m_stats.totalLatencyMs += m_stats.lastLatencyMs();
+
+    qInfo() << "FailoverStandby: local audio on air" << m_stats.lastLatencyMs() << "ms after the outage ("
+            << m_detectionMs << "ms detection," << switchMs << "ms switch"
+            << (m_coldStart ? ", cold start)" : ")");
+    if (switchMs > SLOW_SWITCH_MS) {
+        qWarning() << QString("FailoverStandby::completeFailover - Switch took %1 ms").arg(switchMs);
+    }
+    emit failoverCompleted(m_detectionMs, switchMs);
+}
@@ -0,0 +1,159 @@
+#ifndef FAILOVERSTANDBY_H
+#define FAILOVERSTANDBY_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QString>
+#include <functional>
+
+/**
+ * @brief Keeps the local fallback ready while a TakeOver is on air
+ *
+ * When the TakeOver client went away, the failover started the local
+ * playlist from cold. It opened the file at the head of the playlist only
+ * then, and if the playlist was empty it first ran the auto mode queries.
+ * While armed, FailoverStandby tracks the item the failover would start
+ * with. It prefetches each new one, so the engine loads it from memory,
+ * and emits standbyMissing() when there is none, so the playlist can be
+ * filled before it is needed.
+ *
+ * It also times every failover in two parts. Detection runs from the
+ * first failed probe to the moment the link is declared down. Switch runs
+ * from there until the local audio is on air. Together they are the gap
+ * listeners heard.
+ *
+ * @example
+ * @code
+ * FailoverStandby* standby = new FailoverStandby(this);
+ * standby->setPrefetcher([engine](const QString& path) { engine->prefetch(path); });
+ * standby->arm();
+ * standby->setStandbySource(playlist->item(0)->text());
+ * ...
+ * standby->beginFailover();   // link declared down
+ * engine->play(standby->standbySource());
+ * standby->completeFailover(); // from the engine's trackStarted()
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class FailoverStandby : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Failover timings
+     */
+    struct Statistics {
+        int failovers = 0;          ///< Failovers that reached the air
+        int coldStarts = 0;         ///< Of those, the ones without a ready standby
+        qint64 lastDetectionMs = 0; ///< First failed probe to failover, last failover
+        qint64 lastSwitchMs = 0;    ///< Failover to local audio on air, last failover
+        qint64 worstLatencyMs = 0;  ///< Longest detection plus switch
+        qint64 totalLatencyMs = 0;  ///< Sum of detection plus switch
+
+        qint64 lastLatencyMs() const { return lastDetectionMs + lastSwitchMs; }
+        qint64 averageLatencyMs() const { return failovers > 0 ? totalLatencyMs / failovers : 0; }
+    };
+
+    using Prefetcher = std::function<void(const QString& filePath)>;
+
+    /// Switch time above which a failover is logged as slow
+    static constexpr int SLOW_SWITCH_MS = 500;
+
+    explicit FailoverStandby(QObject* parent = nullptr);
+
+    /**
+     * @brief Set what warms up a standby item
+     * @param prefetcher Called with each new standby item while armed
+     */
+    void setPrefetcher(Prefetcher prefetcher) { m_prefetcher = std::move(prefetcher); }
+
+    /**
+     * @brief Start keeping a standby ready; call when a TakeOver goes on air
+     */
+    void arm();
+
+    /**
+     * @brief Stop keeping a standby ready; call when the TakeOver is returned
+     *
+     * A failover still waiting for the air is dropped without being counted.
+     */
+    void disarm();
+
+    bool isArmed() const { return m_armed; }
+
+    /**
+     * @brief Set the item the failover would start with
+     *
+     * While armed, a new item is prefetched and an empty one emits
+     * standbyMissing().
+     * @param filePath Head of the playlist; empty when the playlist is empty
+     */
+    void setStandbySource(const QString& filePath);
+    QString standbySource() const { return m_source; }
+
+    /**
+     * @brief Check if a failover now would start from a prefetched item
+     * @return true while armed with a standby item
+     */
+    bool isReady() const { return m_armed && !m_source.isEmpty(); }
+
+    /**
+     * @brief Note a failed probe of the TakeOver link
+     *
+     * The first one after a success starts the detection clock.
+     * @param probeMs Time the failed probe took, counted as part of the outage
+     */
+    void probeFailed(int probeMs = 0);
+
+    /**
+     * @brief Note a successful probe; the link did not go down after all
+     */
+    void probeSucceeded();
+
+    /**
+     * @brief Note that the link was declared down and the failover started
+     */
+    void beginFailover();
+
+    /**
+     * @brief Check if a failover started and its audio is not on air yet
+     */
+    bool isFailingOver() const { return m_switchClock.isValid(); }
+
+    /**
+     * @brief Note that the local audio went on air; records the failover
+     *
+     * Does nothing unless beginFailover() was called.
+     */
+    void completeFailover();
+
+    Statistics statistics() const { return m_stats; }
+
+signals:
+    /**
+     * @brief Emitted when armed without an item to fail over to
+     */
+    void standbyMissing();
+
+    /**
+     * @brief Emitted when a failover reached the air
+     * @param detectionMs First failed probe to failover
+     * @param switchMs Failover to local audio on air
+     */
+    void failoverCompleted(qint64 detectionMs, qint64 switchMs);
+
+private:
+    bool m_armed = false;
+    QString m_source;
+    Prefetcher m_prefetcher;
+    QElapsedTimer m_outageClock;  ///< Running since the first failed probe
+    qint64 m_outageOffsetMs = 0;  ///< Time the first failed probe took
+    QElapsedTimer m_switchClock;  ///< Running since beginFailover()
+    qint64 m_detectionMs = 0;
+    bool m_coldStart = false;
+    Statistics m_stats;
+};
+
+#endif // FAILOVERSTANDBY_H
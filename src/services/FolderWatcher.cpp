@@ -0,0 +1,95 @@
+#include "FolderWatcher.h"
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QTimer>
+#include <algorithm>
+
+FolderWatcher::FolderWatcher(QObject* parent)
+    : QObject(parent)
+    , m_watcher(new QFileSystemWatcher(this))
+    , m_debounceTimer(new QTimer(this))
+{
+    m_debounceTimer->setSingleShot(true);
+    m_debounceTimer->setInterval(m_debounceMs);
+    connect(m_debounceTimer, &QTimer::timeout, this, &FolderWatcher::changed);
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, &FolderWatcher::onDirectoryChanged);
+    connect(m_watcher, &QFileSystemWatcher::fileChanged, this, &FolderWatcher::onFileChanged);
+}
+
+bool FolderWatcher::setPath(const QString& path)
+{
+    const QStringList watched = m_watcher->files() + m_watcher->directories();
+    if (!watched.isEmpty()) {
+        m_watcher->removePaths(watched);
+    }
+    m_debounceTimer->stop();
+    m_path.clear();
+
+    if (!QFileInfo(path).isDir()) {
+        qWarning() << QString("FolderWatcher::setPath - Not a directory: %1").arg(path);
+        return false;
+    }
+    if (!m_watcher->addPath(path)) {
+        qWarning() << QString("FolderWatcher::setPath - Cannot watch %1").arg(path);
+        return false;
+    }
+
+    m_path = path;
+    watchMatchingFiles();
+    return true;
+}
+
+void FolderWatcher::setNameFilters(const QStringList& filters)
+{
+    m_nameFilters = filters;
+    const QStringList files = m_watcher->files();
+    if (!files.isEmpty()) {
+        m_watcher->removePaths(files);
+    }
+    watchMatchingFiles();
+}
+
+void FolderWatcher::setDebounceInterval(int intervalMs)
+{
+    m_debounceMs = std::max(0, intervalMs);
+    m_debounceTimer->setInterval(m_debounceMs);
+}
+
+bool FolderWatcher::isWatching() const
+{
+    return !m_path.isEmpty();
+}
+
+void FolderWatcher::onDirectoryChanged()
+{
+    watchMatchingFiles();
+    m_debounceTimer->start();
+}
+
+void FolderWatcher::onFileChanged(const QString& file)
+{
+    // A file that was replaced is no longer watched; watch the new one
+    if (QFileInfo::exists(file) && !m_watcher->files().contains(file)) {
+        m_watcher->addPath(file);
+    }
+    m_debounceTimer->start();
+}
+
+void FolderWatcher::watchMatchingFiles()
+{
+    if (m_path.isEmpty() || m_nameFilters.isEmpty()) {
+        return;
+    }
+
+    const QStringList watched = m_watcher->files();
+    const QDir dir(m_path);
+    const QStringList names = dir.entryList(m_nameFilters, QDir::Files);
+    for (const QString& name : names) {
+        const QString file = dir.filePath(name);
+        if (!watched.contains(file)) {
+            m_watcher->addPath(file);
+        }
+    }
+}
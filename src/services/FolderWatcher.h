@@ -0,0 +1,95 @@
+#ifndef FOLDERWATCHER_H
+#define FOLDERWATCHER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+class QFileSystemWatcher;
+class QTimer;
+
+/**
+ * @brief Reports changes in a directory, with bursts folded into one signal
+ *
+ * A thin layer over QFileSystemWatcher for directories that other machines
+ * drop files into over FTP. An upload creates the file and then writes it in
+ * many small pieces, so the raw watcher fires once for the directory and,
+ * if the file is watched, once per write. FolderWatcher watches the
+ * directory plus every file in it that matches nameFilters(), and emits
+ * changed() once things have been quiet for debounceInterval(), which is
+ * normally when the upload is complete.
+ *
+ * Files that are replaced or renamed drop out of QFileSystemWatcher; they
+ * are picked up again on the next directory change.
+ *
+ * @example
+ * @code
+ * FolderWatcher* watcher = new FolderWatcher(this);
+ * watcher->setNameFilters({"takeover.xml"});
+ * connect(watcher, &FolderWatcher::changed, this, &player::monitorTakeOver);
+ * if (!watcher->setPath(takeOverPath))
+ *     qWarning() << "Falling back to polling";
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class FolderWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int DEFAULT_DEBOUNCE_MS = 500;
+
+    explicit FolderWatcher(QObject* parent = nullptr);
+
+    /**
+     * @brief Start watching a directory, replacing the previous one
+     * @param path Existing directory
+     * @return false if the directory does not exist or cannot be watched
+     */
+    bool setPath(const QString& path);
+
+    /**
+     * @brief Get the watched directory
+     * @return Directory, empty if none
+     */
+    QString path() const { return m_path; }
+
+    /**
+     * @brief Choose which files are watched for writes as well
+     *
+     * Changes to the directory itself (files created, removed, renamed) are
+     * always reported.
+     * @param filters Wildcard patterns, such as "*.ogg"; empty for none
+     */
+    void setNameFilters(const QStringList& filters);
+    QStringList nameFilters() const { return m_nameFilters; }
+
+    void setDebounceInterval(int intervalMs);
+    int debounceInterval() const { return m_debounceMs; }
+
+    /**
+     * @brief Check if a directory is being watched
+     * @return true after a successful setPath()
+     */
+    bool isWatching() const;
+
+signals:
+    /**
+     * @brief Emitted once the directory has been quiet for debounceInterval()
+     */
+    void changed();
+
+private:
+    void onDirectoryChanged();
+    void onFileChanged(const QString& file);
+    void watchMatchingFiles();
+
+    QFileSystemWatcher* m_watcher;
+    QTimer* m_debounceTimer;
+    QString m_path;
+    QStringList m_nameFilters;
+    int m_debounceMs = DEFAULT_DEBOUNCE_MS;
+};
+
+#endif // FOLDERWATCHER_H
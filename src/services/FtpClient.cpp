@@ -0,0 +1,592 @@
+#include "FtpClient.h"
+#include <QDebug>
+#include <QMetaObject>
+#include <QRegularExpression>
+#include <QTcpSocket>
+#include <QTimer>
+#include <algorithm>
+#include <memory>
+
+/// State of one passive-mode data command (listing or download)
+struct FtpClient::Transfer {
+    enum class Phase { Epsv, Pasv, Rest, Command, Transferring };
+
+    Phase phase = Phase::Epsv;
+    QString command;
+    qint64 offset = 0;
+    QTcpSocket* socket = nullptr;
+    DataCallback onData;
+    std::function<void(bool ok, int code, const QString& error)> onDone;
+    bool replyDone = false;
+    bool dataDone = false;
+    bool finished = false;
+    int code = 0;
+    QString error;
+};
+
+FtpClient::FtpClient(QObject* parent)
+    : QObject(parent)
+    , m_idleTimer(new QTimer(this))
+{
+    m_idleTimer->setSingleShot(true);
+    connect(m_idleTimer, &QTimer::timeout, this, [this]() {
+        qWarning() << QString("FtpClient - No answer from the server in %1 ms").arg(m_timeoutMs);
+        if (m_control) {
+            m_control->abort();
+        }
+        failAll(QString("Timed out after %1 ms").arg(m_timeoutMs));
+    });
+}
+
+FtpClient::~FtpClient()
+{
+    // Callbacks may point into objects that are going away as well
+    m_queue.clear();
+    m_inFlight = false;
+    if (m_control) {
+        m_control->disconnect(this);
+        m_control->abort();
+    }
+}
+
+void FtpClient::connectToHost(const QString& host, quint16 port, const QString& user, const QString& password,
+                              ResultCallback callback)
+{
+    if (m_control) {
+        m_control->disconnect(this);
+        m_control->abort();
+        m_control->deleteLater();
+        failAll("Connection aborted");
+    }
+
+    m_buffer.clear();
+    m_multilineCode.clear();
+    m_multilineText.clear();
+
+    m_control = new QTcpSocket(this);
+    connect(m_control, &QTcpSocket::readyRead, this, &FtpClient::onReadyRead);
+    connect(m_control, &QTcpSocket::disconnected, this, [this]() {
+        failAll("Connection closed by the server");
+        emit disconnected();
+    });
+    connect(m_control, &QTcpSocket::errorOccurred, this, [this](QAbstractSocket::SocketError error) {
+        if (error != QAbstractSocket::RemoteHostClosedError) {
+            failAll(m_control->errorString());
+        }
+    });
+
+    // Greeting, USER, PASS and TYPE I form one request so that a failed
+    // login cannot leave later commands running on a half-open session
+    auto phase = std::make_shared<int>(0);
+    const QString login = user.isEmpty() ? QString("anonymous") : user;
+    Request request;
+    request.onReply = [this, phase, login, password, callback](int code, const QString& text) {
+        auto fail = [this, callback, code, text]() {
+            if (callback) {
+                callback(false, QString("%1 %2").arg(code).arg(text));
+            }
+            QMetaObject::invokeMethod(this, &FtpClient::abort, Qt::QueuedConnection);
+            return true;
+        };
+
+        switch (*phase) {
+        case 0:
+            if (code == 120) {
+                return false;  // Service ready in a moment; 220 follows
+            }
+            if (code != 220) {
+                return fail();
+            }
+            *phase = 1;
+            sendLine("USER " + login);
+            return false;
+        case 1:
+            if (code == 331) {
+                *phase = 2;
+                sendLine("PASS " + password);
+                return false;
+            }
+            if (code != 230) {
+                return fail();
+            }
+            break;
+        case 2:
+            if (code != 230 && code != 202) {
+                return fail();
+            }
+            break;
+        default:
+            if (code != 200) {
+                return fail();
+            }
+            if (callback) {
+                callback(true, QString());
+            }
+            return true;
+        }
+
+        *phase = 3;
+        sendLine("TYPE I");
+        return false;
+    };
+    request.onFailure = [callback](const QString& error) {
+        if (callback) {
+            callback(false, error);
+        }
+    };
+    enqueue(request);
+
+    m_control->connectToHost(host, port);
+}
+
+void FtpClient::changeDirectory(const QString& path, ResultCallback callback)
+{
+    Request request;
+    request.command = "CWD " + path;
+    request.onReply = [callback](int code, const QString& text) {
+        if (callback) {
+            callback(code == 250, code == 250 ? QString() : QString("%1 %2").arg(code).arg(text));
+        }
+        return true;
+    };
+    request.onFailure = [callback](const QString& error) {
+        if (callback) {
+            callback(false, error);
+        }
+    };
+    enqueue(request);
+}
+
+void FtpClient::list(ListCallback callback)
+{
+    auto listing = std::make_shared<QByteArray>();
+    auto collect = [listing](const QByteArray& chunk) { listing->append(chunk); };
+
+    auto parseNames = [listing]() {
+        QList<RemoteFile> files;
+        const QStringList lines = QString::fromUtf8(*listing).split('\n', Qt::SkipEmptyParts);
+        for (QString line : lines) {
+            line = line.trimmed();
+            // Some servers prefix NLST names with the directory
+            const QString name = line.mid(line.lastIndexOf('/') + 1);
+            if (!name.isEmpty() && name != "." && name != "..") {
+                RemoteFile file;
+                file.name = name;
+                files.append(file);
+            }
+        }
+        return files;
+    };
+
+    auto parseFacts = [listing]() {
+        QList<RemoteFile> files;
+        const QStringList lines = QString::fromUtf8(*listing).split('\n', Qt::SkipEmptyParts);
+        for (const QString& line : lines) {
+            RemoteFile file;
+            if (parseMlsdLine(line.trimmed(), file) && file.name != "." && file.name != "..") {
+                files.append(file);
+            }
+        }
+        return files;
+    };
+
+    startDataCommand("MLSD", 0, collect,
+                     [this, listing, collect, parseNames, parseFacts, callback](bool ok, int code,
+                                                                                const QString& error) {
+                         if (ok) {
+                             if (callback) {
+                                 callback(true, parseFacts(), QString());
+                             }
+                             return;
+                         }
+                         if (code < 500 || code > 502) {
+                             if (callback) {
+                                 callback(false, QList<RemoteFile>(), error);
+                             }
+                             return;
+                         }
+
+                         // No MLSD on this server: names only
+                         listing->clear();
+                         startDataCommand(
+                             "NLST", 0, collect,
+                             [parseNames, callback](bool ok, int, const QString& error) {
+                                 if (callback) {
+                                     callback(ok, ok ? parseNames() : QList<RemoteFile>(), error);
+                                 }
+                             },
+                             true);
+                     });
+}
+
+void FtpClient::retrieve(const QString& name, qint64 offset, DataCallback onData, ResultCallback callback)
+{
+    startDataCommand("RETR " + name, offset, onData, [callback](bool ok, int, const QString& error) {
+        if (callback) {
+            callback(ok, error);
+        }
+    });
+}
+
+void FtpClient::remove(const QString& name, ResultCallback callback)
+{
+    Request request;
+    request.command = "DELE " + name;
+    request.onReply = [callback](int code, const QString& text) {
+        if (callback) {
+            callback(code == 250, code == 250 ? QString() : QString("%1 %2").arg(code).arg(text));
+        }
+        return true;
+    };
+    request.onFailure = [callback](const QString& error) {
+        if (callback) {
+            callback(false, error);
+        }
+    };
+    enqueue(request);
+}
+
+void FtpClient::quit()
+{
+    if (!m_control) {
+        return;
+    }
+
+    Request request;
+    request.command = "QUIT";
+    request.onReply = [this](int, const QString&) {
+        m_control->disconnectFromHost();
+        return true;
+    };
+    request.onFailure = [](const QString&) {};
+    enqueue(request);
+}
+
+void FtpClient::abort()
+{
+    if (m_control) {
+        m_control->abort();
+    }
+    failAll("Connection aborted");
+}
+
+bool FtpClient::isConnected() const
+{
+    return m_control && m_control->state() == QAbstractSocket::ConnectedState;
+}
+
+void FtpClient::setTimeout(int timeoutMs)
+{
+    m_timeoutMs = std::max(1, timeoutMs);
+}
+
+bool FtpClient::parseMlsdLine(const QString& line, RemoteFile& file)
+{
+    const int space = line.indexOf(' ');
+    if (space <= 0 || space == line.size() - 1) {
+        return false;
+    }
+
+    file = RemoteFile();
+    file.name = line.mid(space + 1);
+
+    const QStringList facts = line.left(space).split(';', Qt::SkipEmptyParts);
+    for (const QString& fact : facts) {
+        const int equals = fact.indexOf('=');
+        if (equals <= 0) {
+            continue;
+        }
+        const QString key = fact.left(equals).toLower();
+        const QString value = fact.mid(equals + 1);
+        if (key == "type") {
+            const QString type = value.toLower();
+            file.isDirectory = type == "dir" || type == "cdir" || type == "pdir";
+        } else if (key == "size") {
+            bool ok = false;
+            const qint64 size = value.toLongLong(&ok);
+            file.size = ok ? size : -1;
+        }
+    }
+    return true;
+}
+
+quint16 FtpClient::parsePassivePort(int code, const QString& text)
+{
+    if (code == 229) {
+        static const QRegularExpression extended("\\(\\|\\|\\|(\\d+)\\|\\)");
+        const QRegularExpressionMatch match = extended.match(text);
+        return match.hasMatch() ? static_cast<quint16>(match.captured(1).toUInt()) : 0;
+    }
+    if (code == 227) {
+        static const QRegularExpression passive("(\\d+),(\\d+),(\\d+),(\\d+),(\\d+),(\\d+)");
+        const QRegularExpressionMatch match = passive.match(text);
+        if (!match.hasMatch()) {
+            return 0;
+        }
+        return static_cast<quint16>(match.captured(5).toUInt() * 256 + match.captured(6).toUInt());
+    }
+    return 0;
+}
+
+void FtpClient::enqueue(const Request& request)
+{
+    m_queue.append(request);
+    sendNext();
+}
+
+void FtpClient::sendNext()
+{
+    if (m_inFlight) {
+        return;
+    }
+    if (m_queue.isEmpty()) {
+        m_idleTimer->stop();
+        return;
+    }
+
+    m_current = m_queue.takeFirst();
+    m_inFlight = true;
+    m_idleTimer->start(m_timeoutMs);
+    if (!m_current.command.isEmpty()) {
+        sendLine(m_current.command);
+    }
+}
+
+void FtpClient::sendLine(const QString& line)
+{
+    if (!m_control) {
+        return;
+    }
+    qDebug() << "FtpClient >" << (line.startsWith("PASS ") ? QString("PASS ****") : line);
+    m_control->write(line.toUtf8() + "\r\n");
+}
+
+void FtpClient::onReadyRead()
+{
+    m_buffer.append(m_control->readAll());
+    m_idleTimer->start(m_timeoutMs);
+
+    int newline;
+    while ((newline = m_buffer.indexOf('\n')) >= 0) {
+        const QString line = QString::fromUtf8(m_buffer.left(newline)).trimmed();
+        m_buffer.remove(0, newline + 1);
+
+        // Multi-line replies run from "123-" to "123 "
+        if (!m_multilineCode.isEmpty()) {
+            if (line.startsWith(m_multilineCode + ' ')) {
+                m_multilineText.append(line.mid(4));
+                const int code = m_multilineCode.toInt();
+                const QString text = m_multilineText.join('\n');
+                m_multilineCode.clear();
+                m_multilineText.clear();
+                dispatchReply(code, text);
+            } else {
+                m_multilineText.append(line);
+            }
+            continue;
+        }
+
+        if (line.size() >= 4 && line.at(3) == '-') {
+            m_multilineCode = line.left(3);
+            m_multilineText.append(line.mid(4));
+        } else if (line.size() >= 3) {
+            dispatchReply(line.left(3).toInt(), line.mid(4));
+        }
+    }
+}
+
+void FtpClient::dispatchReply(int code, const QString& text)
+{
+    qDebug() << "FtpClient <" << code << text;
+
+    if (!m_inFlight) {
+        if (code == 421) {
+            // Server is closing the session on its own
+            failAll(QString("%1 %2").arg(code).arg(text));
+        }
+        return;
+    }
+
+    // The handler may queue more work; it must not see itself replaced
+    const auto handler = m_current.onReply;
+    if (handler(code, text)) {
+        m_inFlight = false;
+        m_current = Request();
+        sendNext();
+    }
+}
+
+void FtpClient::failAll(const QString& error)
+{
+    QList<Request> failed;
+    if (m_inFlight) {
+        failed.append(m_current);
+    }
+    failed.append(m_queue);
+    m_queue.clear();
+    m_current = Request();
+    m_inFlight = false;
+    m_idleTimer->stop();
+
+    for (const Request& request : std::as_const(failed)) {
+        if (request.onFailure) {
+            request.onFailure(error);
+        }
+    }
+}
+
+void FtpClient::startDataCommand(const QString& command, qint64 offset, DataCallback onData,
+                                 std::function<void(bool ok, int code, const QString& error)> onDone,
+                                 bool runNext)
+{
+    auto transfer = std::make_shared<Transfer>();
+    transfer->command = command;
+    transfer->offset = offset;
+    transfer->onData = onData;
+    transfer->onDone = onDone;
+
+    // Report once both the final control reply and the end of the data have arrived
+    auto finishIfDone = [transfer]() {
+        if (transfer->finished || !transfer->replyDone || !transfer->dataDone) {
+            return;
+        }
+        transfer->finished = true;
+        if (transfer->socket) {
+            transfer->socket->disconnect();
+            transfer->socket->abort();
+            transfer->socket->deleteLater();
+            transfer->socket = nullptr;
+        }
+        if (transfer->onDone) {
+            transfer->onDone(transfer->error.isEmpty(), transfer->code, transfer->error);
+        }
+    };
+
+    auto failTransfer = [transfer, finishIfDone](int code, const QString& error) {
+        if (transfer->error.isEmpty()) {
+            transfer->code = code;
+            transfer->error = error;
+        }
+        transfer->replyDone = true;
+        transfer->dataDone = true;
+        finishIfDone();
+    };
+
+    auto openData = [this, transfer, finishIfDone](quint16 port) {
+        QTcpSocket* socket = new QTcpSocket(this);
+        transfer->socket = socket;
+
+        connect(socket, &QTcpSocket::readyRead, this, [this, transfer, socket]() {
+            m_idleTimer->start(m_timeoutMs);
+            const QByteArray chunk = socket->readAll();
+            if (transfer->onData && !chunk.isEmpty()) {
+                transfer->onData(chunk);
+            }
+        });
+        connect(socket, &QTcpSocket::disconnected, this, [transfer, socket, finishIfDone]() {
+            const QByteArray rest = socket->readAll();
+            if (transfer->onData && !rest.isEmpty()) {
+                transfer->onData(rest);
+            }
+            transfer->dataDone = true;
+            finishIfDone();
+        });
+        connect(socket, &QTcpSocket::errorOccurred, this,
+                [transfer, socket, finishIfDone](QAbstractSocket::SocketError error) {
+                    if (error == QAbstractSocket::RemoteHostClosedError) {
+                        return;  // disconnected() follows
+                    }
+                    if (transfer->error.isEmpty()) {
+                        transfer->error = "Data connection: " + socket->errorString();
+                    }
+                    transfer->dataDone = true;
+                    finishIfDone();
+                });
+
+        socket->connectToHost(m_control->peerAddress(), port);
+    };
+
+    Request request;
+    request.onReply = [this, transfer, failTransfer, finishIfDone, openData](int code, const QString& text) {
+        const QString reply = QString("%1 %2").arg(code).arg(text);
+
+        auto sendCommand = [this, transfer]() {
+            if (transfer->offset > 0) {
+                transfer->phase = Transfer::Phase::Rest;
+                sendLine(QString("REST %1").arg(transfer->offset));
+            } else {
+                transfer->phase = Transfer::Phase::Command;
+                sendLine(transfer->command);
+            }
+        };
+
+        switch (transfer->phase) {
+        case Transfer::Phase::Epsv:
+        case Transfer::Phase::Pasv: {
+            const quint16 port = parsePassivePort(code, text);
+            if (port != 0) {
+                openData(port);
+                sendCommand();
+                return false;
+            }
+            if (transfer->phase == Transfer::Phase::Epsv && code >= 500) {
+                transfer->phase = Transfer::Phase::Pasv;
+                sendLine("PASV");
+                return false;
+            }
+            failTransfer(code, reply);
+            return true;
+        }
+        case Transfer::Phase::Rest:
+            if (code != 350) {
+                failTransfer(code, reply);
+                return true;
+            }
+            transfer->phase = Transfer::Phase::Command;
+            sendLine(transfer->command);
+            return false;
+        case Transfer::Phase::Command:
+            if (code == 125 || code == 150) {
+                transfer->phase = Transfer::Phase::Transferring;
+                return false;
+            }
+            if (code != 226 && code != 250) {
+                failTransfer(code, reply);
+                return true;
+            }
+            break;
+        case Transfer::Phase::Transferring:
+            if (code != 226 && code != 250) {
+                // Keep what did arrive, so a download can resume from it, but
+                // do not wait for a data connection that never closes
+                transfer->code = code;
+                transfer->error = reply;
+                if (transfer->socket && transfer->socket->state() != QAbstractSocket::UnconnectedState) {
+                    QTimer::singleShot(m_timeoutMs, transfer->socket, [transfer, finishIfDone]() {
+                        transfer->dataDone = true;
+                        finishIfDone();
+                    });
+                } else {
+                    transfer->dataDone = true;
+                }
+            }
+            break;
+        }
+
+        transfer->replyDone = true;
+        finishIfDone();
+        return true;
+    };
+    request.onFailure = [failTransfer](const QString& error) { failTransfer(0, error); };
+
+    Request epsv = request;
+    epsv.command = "EPSV";
+
+    if (runNext) {
+        // A fallback for the command that just failed goes before anything queued since
+        m_queue.prepend(epsv);
+        sendNext();
+    } else {
+        enqueue(epsv);
+    }
+}
@@ -0,0 +1,176 @@
+#ifndef FTPCLIENT_H
+#define FTPCLIENT_H
+
+#include <QByteArray>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <functional>
+
+class QTcpSocket;
+class QTimer;
+
+/**
+ * @brief Minimal asynchronous FTP client on a single control connection
+ *
+ * Qt 6 has no FTP support in QNetworkAccessManager, and the programs sync
+ * used to drive the command line ftp client through shell scripts with
+ * waitForFinished(-1) on the GUI thread. FtpClient speaks the subset of
+ * RFC 959 that sync needs: login, CWD, directory listings (MLSD, falling
+ * back to NLST), resumable RETR through REST, and DELE. Data connections
+ * are passive (EPSV, falling back to PASV) and always go to the control
+ * connection's peer address, which keeps servers behind NAT working.
+ *
+ * Operations are queued and run one at a time; each reports through its
+ * callback. If the connection drops or the server stops answering for
+ * timeout() milliseconds, the running operation and everything queued
+ * behind it fail.
+ *
+ * @example
+ * @code
+ * FtpClient* ftp = new FtpClient(this);
+ * ftp->connectToHost("ftp.example.com", 21, "user", "secret",
+ *                    [](bool ok, const QString& error) { if (!ok) qWarning() << error; });
+ * ftp->changeDirectory("Programs", [](bool, const QString&) {});
+ * ftp->list([](bool ok, const QList<FtpClient::RemoteFile>& files, const QString&) {
+ *     for (const FtpClient::RemoteFile& file : files)
+ *         qDebug() << file.name << file.size;
+ * });
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class FtpClient : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct RemoteFile {
+        QString name;
+        qint64 size = -1;  ///< -1 when the server did not say (NLST listings)
+        bool isDirectory = false;
+    };
+
+    using ResultCallback = std::function<void(bool ok, const QString& error)>;
+    using ListCallback = std::function<void(bool ok, const QList<RemoteFile>& files, const QString& error)>;
+    using DataCallback = std::function<void(const QByteArray& chunk)>;
+
+    static constexpr int DEFAULT_PORT = 21;
+    static constexpr int DEFAULT_TIMEOUT_MS = 30 * 1000;
+
+    explicit FtpClient(QObject* parent = nullptr);
+    ~FtpClient() override;
+
+    /**
+     * @brief Connect, log in and switch to binary mode
+     * @param host Server host name or address
+     * @param port Control port
+     * @param user User name; "anonymous" if empty
+     * @param password Password
+     * @param callback Receives the login result
+     */
+    void connectToHost(const QString& host, quint16 port, const QString& user, const QString& password,
+                       ResultCallback callback);
+
+    /**
+     * @brief Change the remote working directory
+     * @param path Directory
+     * @param callback Receives the result
+     */
+    void changeDirectory(const QString& path, ResultCallback callback);
+
+    /**
+     * @brief List the remote working directory
+     * @param callback Receives the entries, without "." and ".."
+     */
+    void list(ListCallback callback);
+
+    /**
+     * @brief Download a file
+     *
+     * onData receives the file in chunks as they arrive; callback runs once
+     * the server confirmed the transfer and the data connection is drained.
+     * @param name Remote file name
+     * @param offset Byte to start from, for resuming a partial download
+     * @param onData Receives the data
+     * @param callback Receives the result
+     */
+    void retrieve(const QString& name, qint64 offset, DataCallback onData, ResultCallback callback);
+
+    /**
+     * @brief Delete a remote file
+     * @param name Remote file name
+     * @param callback Receives the result
+     */
+    void remove(const QString& name, ResultCallback callback);
+
+    /**
+     * @brief Send QUIT after the queued operations and close the connection
+     */
+    void quit();
+
+    /**
+     * @brief Drop the connection now, failing every pending operation
+     */
+    void abort();
+
+    bool isConnected() const;
+
+    void setTimeout(int timeoutMs);
+    int timeout() const { return m_timeoutMs; }
+
+    /**
+     * @brief Parse one line of an MLSD listing
+     * @param line "fact=value;fact=value; name"
+     * @param file Receives the entry
+     * @return false if the line is not a listing entry
+     */
+    static bool parseMlsdLine(const QString& line, RemoteFile& file);
+
+    /**
+     * @brief Get the data port from a 227 or 229 reply
+     * @param code Reply code
+     * @param text Reply text
+     * @return Port, or 0 if the reply has none
+     */
+    static quint16 parsePassivePort(int code, const QString& text);
+
+signals:
+    /**
+     * @brief Emitted when the control connection closes
+     */
+    void disconnected();
+
+private:
+    /// A command in the queue. onReply sees every reply while the command is
+    /// current and returns true once its final reply has arrived.
+    struct Request {
+        QString command;
+        std::function<bool(int code, const QString& text)> onReply;
+        std::function<void(const QString& error)> onFailure;
+    };
+
+    struct Transfer;
+
+    void enqueue(const Request& request);
+    void sendNext();
+    void sendLine(const QString& line);
+    void onReadyRead();
+    void dispatchReply(int code, const QString& text);
+    void failAll(const QString& error);
+    void startDataCommand(const QString& command, qint64 offset, DataCallback onData,
+                          std::function<void(bool ok, const QString& error)> onDone);
+
+    QTcpSocket* m_control = nullptr;
+    QTimer* m_idleTimer = nullptr;
+    QByteArray m_buffer;
+    QString m_multilineCode;
+    QStringList m_multilineText;
+    QList<Request> m_queue;
+    Request m_current;
+    bool m_inFlight = false;
+    int m_timeoutMs = DEFAULT_TIMEOUT_MS;
+};
+
+#endif // FTPCLIENT_H
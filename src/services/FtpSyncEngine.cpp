@@ -0,0 +1,387 @@
+#include "FtpSyncEngine.h"
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QTextStream>
+#include <algorithm>
+#include <memory>
+
+FtpSyncEngine::FtpSyncEngine(QObject* parent)
+    : QObject(parent)
+{
+    setFilePattern("*.ogg");
+}
+
+void FtpSyncEngine::setServer(const QString& host, quint16 port, const QString& user, const QString& password)
+{
+    m_host = host;
+    m_port = port;
+    m_user = user;
+    m_password = password;
+}
+
+void FtpSyncEngine::setFilePattern(const QString& pattern)
+{
+    m_filePattern = QRegularExpression(QRegularExpression::wildcardToRegularExpression(pattern),
+                                       QRegularExpression::CaseInsensitiveOption);
+}
+
+void FtpSyncEngine::setMaxParallelDownloads(int downloads)
+{
+    m_maxParallel = std::clamp(downloads, 1, MAX_PARALLEL_DOWNLOADS);
+}
+
+bool FtpSyncEngine::sync()
+{
+    if (m_running) {
+        return false;
+    }
+    if (m_host.isEmpty() || m_localDirectory.isEmpty()) {
+        logError("sync", "No server or local directory configured");
+        return false;
+    }
+    if (!QDir().mkpath(m_localDirectory)) {
+        logError("sync", QString("Cannot create %1").arg(m_localDirectory));
+        return false;
+    }
+
+    m_running = true;
+    m_pending.clear();
+    m_listed = false;
+    m_downloaded = 0;
+    m_failed = 0;
+    m_manifest = readManifest(m_localDirectory);
+
+    qDebug() << "FtpSyncEngine: syncing" << m_host << m_remoteDirectory << "into" << m_localDirectory;
+    openClient([this](FtpClient* client, bool ok, const QString& error) {
+        if (!ok) {
+            logError("sync", error);
+            finishWorker(client);
+            return;
+        }
+        client->list([this, client](bool ok, const QList<FtpClient::RemoteFile>& files, const QString& error) {
+            if (!m_running) {
+                return;
+            }
+            if (!ok) {
+                logError("list", error);
+                finishWorker(client);
+                return;
+            }
+            onListed(client, files);
+        });
+    });
+    return true;
+}
+
+void FtpSyncEngine::cancel()
+{
+    if (!m_running) {
+        return;
+    }
+
+    // Clear the flag first so the aborted clients' callbacks do nothing
+    m_running = false;
+    m_failed += m_pending.size();
+    m_pending.clear();
+
+    const QList<FtpClient*> clients = m_clients;
+    m_clients.clear();
+    for (FtpClient* client : clients) {
+        client->abort();
+        client->deleteLater();
+    }
+    emit syncFinished(false, m_downloaded, m_failed);
+}
+
+QHash<QString, FtpSyncEngine::ManifestEntry> FtpSyncEngine::readManifest(const QString& directory)
+{
+    QHash<QString, ManifestEntry> manifest;
+
+    QFile file(QDir(directory).filePath(MANIFEST_FILE_NAME));
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return manifest;
+    }
+
+    // One "<sha256>\t<size>\t<name>" line per file
+    QTextStream in(&file);
+    while (!in.atEnd()) {
+        const QStringList fields = in.readLine().split('\t');
+        if (fields.size() != 3 || fields.at(2).isEmpty()) {
+            continue;
+        }
+        ManifestEntry entry;
+        entry.sha256 = fields.at(0);
+        entry.size = fields.at(1).toLongLong();
+        manifest.insert(fields.at(2), entry);
+    }
+    return manifest;
+}
+
+QHash<QString, QString> FtpSyncEngine::parseChecksums(const QString& text)
+{
+    QHash<QString, QString> checksums;
+
+    static const QRegularExpression line("^([0-9a-fA-F]{64}) [ *](.+)$");
+    const QStringList lines = text.split('\n', Qt::SkipEmptyParts);
+    for (const QString& entry : lines) {
+        const QRegularExpressionMatch match = line.match(entry.trimmed());
+        if (match.hasMatch()) {
+            const QString name = match.captured(2);
+            checksums.insert(name.mid(name.lastIndexOf('/') + 1), match.captured(1).toLower());
+        }
+    }
+    return checksums;
+}
+
+void FtpSyncEngine::onListed(FtpClient* client, const QList<FtpClient::RemoteFile>& files)
+{
+    m_listed = true;
+    const bool hasChecksums = std::any_of(files.cbegin(), files.cend(), [](const FtpClient::RemoteFile& file) {
+        return file.name == QLatin1String(REMOTE_MANIFEST_NAME);
+    });
+    if (!hasChecksums) {
+        planDownloads(client, files, QHash<QString, QString>());
+        return;
+    }
+
+    auto text = std::make_shared<QByteArray>();
+    client->retrieve(
+        REMOTE_MANIFEST_NAME, 0, [text](const QByteArray& chunk) { text->append(chunk); },
+        [this, client, files, text](bool ok, const QString& error) {
+            if (!m_running) {
+                return;
+            }
+            if (!ok) {
+                // Still sync; downloads are checked against the listed sizes only
+                logError("checksums", error);
+            }
+            planDownloads(client, files, ok ? parseChecksums(QString::fromUtf8(*text)) : QHash<QString, QString>());
+        });
+}
+
+void FtpSyncEngine::planDownloads(FtpClient* client, const QList<FtpClient::RemoteFile>& files,
+                                  const QHash<QString, QString>& checksums)
+{
+    const QDir local(m_localDirectory);
+    for (const FtpClient::RemoteFile& file : files) {
+        if (file.isDirectory || !m_filePattern.match(file.name).hasMatch()) {
+            continue;
+        }
+
+        Job job;
+        job.file = file;
+        job.expectedSha256 = checksums.value(file.name);
+
+        auto known = m_manifest.constFind(file.name);
+        if (known != m_manifest.constEnd() && QFileInfo::exists(local.filePath(file.name))
+            && (file.size < 0 || known.value().size == file.size)
+            && (job.expectedSha256.isEmpty() || known.value().sha256 == job.expectedSha256)) {
+            continue;  // Fetched before and unchanged
+        }
+        m_pending.append(job);
+    }
+
+    qDebug() << "FtpSyncEngine:" << m_pending.size() << "of" << files.size() << "remote files to fetch";
+
+    // The listing connection becomes the first worker
+    const int extraWorkers = std::min<int>(m_maxParallel, m_pending.size()) - 1;
+    for (int i = 0; i < extraWorkers; ++i) {
+        openClient([this](FtpClient* worker, bool ok, const QString& error) {
+            if (!ok) {
+                logError("connect", error);
+                finishWorker(worker);
+                return;
+            }
+            runWorker(worker);
+        });
+    }
+    runWorker(client);
+}
+
+FtpClient* FtpSyncEngine::openClient(std::function<void(FtpClient*, bool, const QString&)> ready)
+{
+    FtpClient* client = new FtpClient(this);
+    client->setTimeout(m_timeoutMs);
+    m_clients.append(client);
+
+    // A failed login also fails the queued CWD; report only the first error
+    auto reported = std::make_shared<bool>(false);
+    client->connectToHost(m_host, m_port, m_user, m_password,
+                          [this, client, ready, reported](bool ok, const QString& error) {
+                              if (m_running && !ok && !*reported) {
+                                  *reported = true;
+                                  ready(client, false, error);
+                              }
+                          });
+    client->changeDirectory(m_remoteDirectory, [this, client, ready, reported](bool ok, const QString& error) {
+        if (m_running && !*reported) {
+            *reported = true;
+            ready(client, ok, error);
+        }
+    });
+    return client;
+}
+
+void FtpSyncEngine::runWorker(FtpClient* client)
+{
+    if (!m_running) {
+        return;
+    }
+    if (m_pending.isEmpty()) {
+        finishWorker(client);
+        return;
+    }
+    download(client, m_pending.takeFirst());
+}
+
+void FtpSyncEngine::download(FtpClient* client, const Job& job)
+{
+    const QString name = job.file.name;
+    const QString partPath = QDir(m_localDirectory).filePath(name + PARTIAL_SUFFIX);
+    const QString finalPath = QDir(m_localDirectory).filePath(name);
+
+    auto part = std::make_shared<QFile>(partPath);
+    if (!part->open(QIODevice::ReadWrite)) {
+        logError("download", QString("Cannot write %1: %2").arg(partPath, part->errorString()));
+        ++m_failed;
+        emit fileFailed(name, part->errorString());
+        runWorker(client);
+        return;
+    }
+
+    // A leftover longer than the remote file is not a prefix of it
+    if (job.file.size >= 0 && part->size() > job.file.size) {
+        part->resize(0);
+    }
+
+    // Resume after what an earlier sync already wrote; the checksum covers it too
+    auto hash = std::make_shared<QCryptographicHash>(QCryptographicHash::Sha256);
+    const qint64 offset = part->size();
+    if (offset > 0) {
+        qDebug() << "FtpSyncEngine: resuming" << name << "at byte" << offset;
+        hash->addData(part.get());
+    }
+    part->seek(offset);
+
+    auto writeError = std::make_shared<QString>();
+    client->retrieve(
+        name, offset,
+        [part, hash, writeError](const QByteArray& chunk) {
+            if (part->write(chunk) != chunk.size() && writeError->isEmpty()) {
+                *writeError = part->errorString();
+            }
+            hash->addData(chunk);
+        },
+        [this, client, job, part, hash, writeError, partPath, finalPath](bool ok, const QString& error) {
+            part->flush();
+            const qint64 received = part->size();
+            part->close();
+            if (!m_running) {
+                return;
+            }
+
+            const QString name = job.file.name;
+            QString failure;
+            if (!ok) {
+                failure = error;  // The .part file stays for the next sync to resume
+            } else if (!writeError->isEmpty()) {
+                failure = *writeError;
+            } else if (job.file.size >= 0 && received != job.file.size) {
+                failure = QString("Size mismatch: got %1 bytes, expected %2").arg(received).arg(job.file.size);
+                QFile::remove(partPath);
+            } else {
+                const QString sha256 = QString::fromLatin1(hash->result().toHex());
+                if (!job.expectedSha256.isEmpty() && sha256 != job.expectedSha256) {
+                    failure = QString("Checksum mismatch: got %1, expected %2").arg(sha256, job.expectedSha256);
+                    QFile::remove(partPath);
+                } else {
+                    QFile::remove(finalPath);
+                    if (!QFile::rename(partPath, finalPath)) {
+                        failure = QString("Cannot move %1 into place").arg(partPath);
+                    } else {
+                        ManifestEntry entry;
+                        entry.size = received;
+                        entry.sha256 = sha256;
+                        m_manifest.insert(name, entry);
+                        writeManifest();
+                    }
+                }
+            }
+
+            if (!failure.isEmpty()) {
+                logError("download", QString("%1: %2").arg(name, failure));
+                ++m_failed;
+                emit fileFailed(name, failure);
+            } else {
+                ++m_downloaded;
+                qDebug() << "FtpSyncEngine: fetched" << name << "(" << received << "bytes )";
+                if (m_deleteRemote) {
+                    client->remove(name, [this, name](bool ok, const QString& error) {
+                        if (!ok) {
+                            logError("delete", QString("%1: %2").arg(name, error));
+                        }
+                    });
+                }
+                emit fileDownloaded(name, finalPath);
+            }
+            runWorker(client);
+        });
+}
+
+void FtpSyncEngine::finishWorker(FtpClient* client)
+{
+    if (!m_clients.removeOne(client)) {
+        return;
+    }
+
+    if (client->isConnected()) {
+        // Let queued deletions and the QUIT go out before the client goes away
+        connect(client, &FtpClient::disconnected, client, &QObject::deleteLater);
+        client->quit();
+    } else {
+        client->deleteLater();
+    }
+
+    if (m_clients.isEmpty() && m_running) {
+        finishSync();
+    }
+}
+
+void FtpSyncEngine::finishSync()
+{
+    // Jobs no worker got to (every connection failed) count as failures
+    m_failed += m_pending.size();
+    m_pending.clear();
+    m_running = false;
+
+    qDebug() << "FtpSyncEngine: sync finished," << m_downloaded << "fetched," << m_failed << "failed";
+    emit syncFinished(m_listed, m_downloaded, m_failed);
+}
+
+void FtpSyncEngine::writeManifest()
+{
+    QSaveFile file(QDir(m_localDirectory).filePath(MANIFEST_FILE_NAME));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        logError("writeManifest", file.errorString());
+        return;
+    }
+
+    QTextStream out(&file);
+    for (auto it = m_manifest.constBegin(); it != m_manifest.constEnd(); ++it) {
+        out << it.value().sha256 << '\t' << it.value().size << '\t' << it.key() << '\n';
+    }
+    out.flush();
+    if (!file.commit()) {
+        logError("writeManifest", file.errorString());
+    }
+}
+
+void FtpSyncEngine::logError(const QString& operation, const QString& error)
+{
+    qWarning() << QString("FtpSyncEngine::%1 - %2").arg(operation, error);
+    emit operationError(operation, error);
+}
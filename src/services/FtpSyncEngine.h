@@ -0,0 +1,196 @@
+#ifndef FTPSYNCENGINE_H
+#define FTPSYNCENGINE_H
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QRegularExpression>
+#include <QString>
+
+#include "FtpClient.h"
+
+/**
+ * @brief Fetches new files from an FTP directory into a local one, asynchronously
+ *
+ * Replaces the serverFtpCmdsGetPrograms script and the "mv *.ogg" that
+ * followed it. A sync lists the remote directory, works out which files are
+ * new and downloads them over up to maxParallelDownloads() connections at
+ * once, straight into localDirectory(). Nothing blocks the caller's thread.
+ *
+ * Delta sync: a manifest in the local directory (MANIFEST_FILE_NAME) records
+ * the size and SHA-256 of every file fetched so far. A remote file is skipped
+ * when the manifest already has it with the same size and checksum and the
+ * local copy still exists.
+ *
+ * Checksums: if the remote directory holds a REMOTE_MANIFEST_NAME file in
+ * sha256sum format, every download is checked against it, and so is the
+ * delta decision. Without one, downloads are checked against the size from
+ * the listing.
+ *
+ * Resuming: a download is written to "<name>.part" and renamed into place
+ * only once it is complete and verified. A sync that finds a .part file left
+ * over from an interrupted one continues it with REST instead of starting
+ * over.
+ *
+ * @example
+ * @code
+ * FtpSyncEngine* sync = new FtpSyncEngine(this);
+ * sync->setServer("ftp.example.com", 21, "user", "secret");
+ * sync->setRemoteDirectory("Programs");
+ * sync->setLocalDirectory(programsPath);
+ * connect(sync, &FtpSyncEngine::fileDownloaded, this,
+ *         [](const QString& name, const QString& path) { qDebug() << "New program" << path; });
+ * sync->sync();
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class FtpSyncEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int DEFAULT_PARALLEL_DOWNLOADS = 2;
+    static constexpr int MAX_PARALLEL_DOWNLOADS = 8;
+    static constexpr const char* MANIFEST_FILE_NAME = ".xfb-sync-manifest";
+    static constexpr const char* REMOTE_MANIFEST_NAME = "manifest.sha256";
+    static constexpr const char* PARTIAL_SUFFIX = ".part";
+
+    /**
+     * @brief What the local manifest knows about one fetched file
+     */
+    struct ManifestEntry {
+        qint64 size = -1;
+        QString sha256;
+    };
+
+    explicit FtpSyncEngine(QObject* parent = nullptr);
+
+    void setServer(const QString& host, quint16 port, const QString& user, const QString& password);
+
+    void setRemoteDirectory(const QString& path) { m_remoteDirectory = path; }
+    QString remoteDirectory() const { return m_remoteDirectory; }
+
+    void setLocalDirectory(const QString& path) { m_localDirectory = path; }
+    QString localDirectory() const { return m_localDirectory; }
+
+    /**
+     * @brief Set which remote files are synced
+     * @param pattern Wildcard pattern such as "*.ogg"
+     */
+    void setFilePattern(const QString& pattern);
+
+    void setMaxParallelDownloads(int downloads);
+    int maxParallelDownloads() const { return m_maxParallel; }
+
+    /**
+     * @brief Delete remote files once they are downloaded and verified
+     *
+     * On by default: the remote directory works as an inbox, as it did with
+     * the old script's mdelete.
+     * @param enabled true to delete
+     */
+    void setDeleteRemoteAfterDownload(bool enabled) { m_deleteRemote = enabled; }
+    bool deleteRemoteAfterDownload() const { return m_deleteRemote; }
+
+    void setTimeout(int timeoutMs) { m_timeoutMs = timeoutMs; }
+
+    /**
+     * @brief Check if a sync is in progress
+     * @return true between sync() and syncFinished()
+     */
+    bool isRunning() const { return m_running; }
+
+    /**
+     * @brief Start a sync
+     * @return false if one is already running or the setup is incomplete
+     */
+    bool sync();
+
+    /**
+     * @brief Abort the running sync; partial files are kept for resuming
+     */
+    void cancel();
+
+    /**
+     * @brief Read the manifest of a local directory
+     * @param directory Local directory
+     * @return Entries by file name
+     */
+    static QHash<QString, ManifestEntry> readManifest(const QString& directory);
+
+    /**
+     * @brief Parse sha256sum output
+     * @param text Lines of "<hex>  <name>" or "<hex> *<name>"
+     * @return Lower-case checksums by file name
+     */
+    static QHash<QString, QString> parseChecksums(const QString& text);
+
+signals:
+    /**
+     * @brief Emitted for every file that arrived and passed verification
+     * @param fileName File name
+     * @param localPath Where the file now is
+     */
+    void fileDownloaded(const QString& fileName, const QString& localPath);
+
+    /**
+     * @brief Emitted when a file could not be fetched or verified
+     * @param fileName File name
+     * @param error Error message
+     */
+    void fileFailed(const QString& fileName, const QString& error);
+
+    /**
+     * @brief Emitted when a sync ends
+     * @param ok false if the remote directory could not be listed or the sync was cancelled
+     * @param downloaded Number of files fetched
+     * @param failed Number of files that failed
+     */
+    void syncFinished(bool ok, int downloaded, int failed);
+
+    /**
+     * @brief Emitted when an operation fails
+     * @param operation Name of the operation
+     * @param error Error message
+     */
+    void operationError(const QString& operation, const QString& error);
+
+private:
+    struct Job {
+        FtpClient::RemoteFile file;
+        QString expectedSha256;
+    };
+
+    void onListed(FtpClient* client, const QList<FtpClient::RemoteFile>& files);
+    void planDownloads(FtpClient* client, const QList<FtpClient::RemoteFile>& files,
+                       const QHash<QString, QString>& checksums);
+    FtpClient* openClient(std::function<void(FtpClient* client, bool ok, const QString& error)> ready);
+    void runWorker(FtpClient* client);
+    void download(FtpClient* client, const Job& job);
+    void finishWorker(FtpClient* client);
+    void finishSync();
+    void writeManifest();
+    void logError(const QString& operation, const QString& error);
+
+    QString m_host;
+    quint16 m_port = FtpClient::DEFAULT_PORT;
+    QString m_user;
+    QString m_password;
+    QString m_remoteDirectory = "Programs";
+    QString m_localDirectory;
+    QRegularExpression m_filePattern;
+    int m_maxParallel = DEFAULT_PARALLEL_DOWNLOADS;
+    bool m_deleteRemote = true;
+    int m_timeoutMs = FtpClient::DEFAULT_TIMEOUT_MS;
+
+    bool m_running = false;
+    bool m_listed = false;
+    QList<Job> m_pending;
+    QList<FtpClient*> m_clients;
+    QHash<QString, ManifestEntry> m_manifest;
+    int m_downloaded = 0;
+    int m_failed = 0;
+};
+
+#endif // FTPSYNCENGINE_H
@@ -0,0 +1,145 @@
+#include "GainRamp.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define GAINRAMP_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define GAINRAMP_NEON
+#endif
+
+namespace {
+
+#if defined(GAINRAMP_SSE2) || defined(GAINRAMP_NEON)
+
+constexpr int LANES = 4;
+
+#if defined(GAINRAMP_SSE2)
+using Vector = __m128;
+
+inline Vector vectorSet(float value) { return _mm_set1_ps(value); }
+inline Vector vectorLoad(const float* samples) { return _mm_loadu_ps(samples); }
+inline void vectorStore(float* out, Vector v) { _mm_storeu_ps(out, v); }
+inline Vector vectorAdd(Vector a, Vector b) { return _mm_add_ps(a, b); }
+inline Vector vectorMul(Vector a, Vector b) { return _mm_mul_ps(a, b); }
+#else
+using Vector = float32x4_t;
+
+inline Vector vectorSet(float value) { return vdupq_n_f32(value); }
+inline Vector vectorLoad(const float* samples) { return vld1q_f32(samples); }
+inline void vectorStore(float* out, Vector v) { vst1q_f32(out, v); }
+inline Vector vectorAdd(Vector a, Vector b) { return vaddq_f32(a, b); }
+inline Vector vectorMul(Vector a, Vector b) { return vmulq_f32(a, b); }
+#endif
+
+#endif
+
+} // namespace
+
+GainRamp::GainRamp(float gain)
+    : m_gain(std::max(0.0f, gain))
+    , m_target(m_gain)
+{
+}
+
+void GainRamp::setGain(float gain)
+{
+    m_gain = std::max(0.0f, gain);
+    m_target = m_gain;
+    m_remaining = 0;
+}
+
+void GainRamp::rampTo(float target, qint64 frames, Curve curve)
+{
+    if (frames <= 0) {
+        setGain(target);
+        return;
+    }
+    m_target = std::max(0.0f, target);
+    m_remaining = frames;
+    m_curve = curve;
+}
+
+void GainRamp::process(float* samples, int frames, int channels)
+{
+    if (channels <= 0 || frames <= 0) {
+        return;
+    }
+
+    int done = 0;
+    while (done < frames && m_remaining > 0) {
+        const int count =
+            int(std::min<qint64>({qint64(SEGMENT_FRAMES), m_remaining, qint64(frames - done)}));
+
+        // Where the curve is at the end of the segment; the last one lands on the target
+        float end = m_target;
+        if (count < m_remaining) {
+            const float progress = float(count) / float(m_remaining);
+            if (m_curve == Curve::Linear) {
+                end = m_gain + (m_target - m_gain) * progress;
+            } else {
+                const float from = std::max(m_gain, SILENCE);
+                const float to = std::max(m_target, SILENCE);
+                end = from * std::pow(to / from, progress);
+            }
+        }
+
+        apply(samples + qint64(done) * channels, count, channels, m_gain,
+              (end - m_gain) / float(count));
+        m_gain = end;
+        m_remaining -= count;
+        done += count;
+    }
+
+    if (done < frames && m_gain != 1.0f) {
+        apply(samples + qint64(done) * channels, frames - done, channels, m_gain, 0.0f);
+    }
+}
+
+void GainRamp::apply(float* samples, int frames, int channels, float start, float step)
+{
+#if defined(GAINRAMP_SSE2) || defined(GAINRAMP_NEON)
+    // Whole frames fill a vector only when the channel count divides its lanes
+    if (channels > 0 && LANES % channels == 0) {
+        const int framesPerVector = LANES / channels;
+        const int vectors = frames / framesPerVector;
+
+        // Frame of each lane, counted from 1 like the scalar loop
+        float lanes[LANES];
+        for (int lane = 0; lane < LANES; ++lane) {
+            lanes[lane] = float(1 + lane / channels);
+        }
+        const Vector offsets = vectorLoad(lanes);
+        const Vector startGain = vectorSet(start);
+        const Vector stepGain = vectorSet(step);
+
+        // Each gain is worked out from the start of the segment, so no
+        // rounding error builds up across it
+        for (int v = 0; v < vectors; ++v) {
+            const Vector frame = vectorAdd(vectorSet(float(v * framesPerVector)), offsets);
+            const Vector gain = vectorAdd(startGain, vectorMul(stepGain, frame));
+            float* out = samples + v * LANES;
+            vectorStore(out, vectorMul(vectorLoad(out), gain));
+        }
+
+        const int done = vectors * framesPerVector;
+        applyScalar(samples + qint64(done) * channels, frames - done, channels,
+                    start + step * float(done), step);
+        return;
+    }
+#endif
+    applyScalar(samples, frames, channels, start, step);
+}
+
+void GainRamp::applyScalar(float* samples, int frames, int channels, float start, float step)
+{
+    for (int i = 0; i < frames; ++i) {
+        const float gain = start + step * float(i + 1);
+        float* frame = samples + qint64(i) * channels;
+        for (int channel = 0; channel < channels; ++channel) {
+            frame[channel] *= gain;
+        }
+    }
+}
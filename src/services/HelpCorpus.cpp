@@ -0,0 +1,602 @@
+#include "HelpCorpus.h"
+#include <QCborArray>
+#include <QCborMap>
+#include <QCborValue>
+#include <QDebug>
+#include <QDir>
+#include <QHash>
+#include <QJsonArray>
+#include <QMap>
+#include <QRegularExpression>
+#include <QSet>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// Header words after MAGIC and VERSION
+enum HeaderWord {
+    TopicCount = 2,
+    TopicsOffset,
+    TermCount,
+    TermsOffset,
+    PostingsOffset,
+    PostingCount,
+    ContextCount,
+    ContextsOffset,
+    StringsOffset,
+    StringsSize,
+    ExtrasOffset,
+    ExtrasSize
+};
+
+// Word offsets within a topic record
+constexpr int TOPIC_ID = 0;
+constexpr int TOPIC_TITLE = 2;
+constexpr int TOPIC_CONTENT = 4;
+constexpr int TOPIC_CONTEXT = 6;
+constexpr int TOPIC_KEYWORDS = 8;
+constexpr int TOPIC_RELATED = 10;
+constexpr int TOPIC_CATEGORY = 12;
+constexpr int TOPIC_PRIORITY = 13;
+
+void appendWord(QByteArray& out, quint32 value)
+{
+    char bytes[4];
+    qToLittleEndian(value, bytes);
+    out.append(bytes, 4);
+}
+
+void setWord(QByteArray& out, int index, quint32 value)
+{
+    qToLittleEndian(value, out.data() + index * 4);
+}
+
+// Byte order, as the terms and contexts are sorted
+int compareBytes(const QByteArray& left, const QByteArray& right)
+{
+    const int common = int(std::min(left.size(), right.size()));
+    const int order = common > 0 ? std::memcmp(left.constData(), right.constData(), common) : 0;
+    if (order != 0) {
+        return order;
+    }
+    return int(left.size() - right.size());
+}
+
+QStringList stringList(const QJsonValue& value)
+{
+    QStringList list;
+    for (const QJsonValue& item : value.toArray()) {
+        list.append(item.toString());
+    }
+    return list;
+}
+
+int number(const QCborValue& value, int defaultValue)
+{
+    if (value.isInteger()) {
+        return int(value.toInteger());
+    }
+    return value.isDouble() ? int(value.toDouble()) : defaultValue;
+}
+
+} // namespace
+
+const HelpCorpus& HelpCorpus::builtIn()
+{
+    static HelpCorpus corpus;
+    static const bool opened = [] {
+        if (!corpus.open(BUILT_IN_PATH)) {
+            qWarning() << "HelpCorpus: cannot open the built-in help:" << corpus.errorString();
+            return false;
+        }
+        return true;
+    }();
+    Q_UNUSED(opened);
+    return corpus;
+}
+
+bool HelpCorpus::open(const QString& path)
+{
+    m_file.close();
+    m_data.clear();
+    m_base = nullptr;
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        m_error = m_file.errorString();
+        return false;
+    }
+
+    // Uncompressed resources and plain files map without a copy
+    const qint64 size = m_file.size();
+    if (const uchar* mapped = m_file.map(0, size)) {
+        return attach(mapped, size);
+    }
+    m_data = m_file.readAll();
+    m_file.close();
+    return attach(reinterpret_cast<const uchar*>(m_data.constData()), m_data.size());
+}
+
+bool HelpCorpus::openData(const QByteArray& data)
+{
+    m_file.close();
+    m_data = data;
+    return attach(reinterpret_cast<const uchar*>(m_data.constData()), m_data.size());
+}
+
+bool HelpCorpus::attach(const uchar* base, qint64 size)
+{
+    m_base = nullptr;
+    m_extrasDecoded = false;
+    m_tutorials.clear();
+    m_contextMappings.clear();
+    if (size < HEADER_WORDS * 4) {
+        m_error = "The help corpus is truncated";
+        return false;
+    }
+
+    m_base = base;
+    m_size = size;
+    if (word(0) != MAGIC || word(4) != VERSION) {
+        m_base = nullptr;
+        m_error = "Not a help corpus of this version";
+        return false;
+    }
+    m_topicCount = int(word(TopicCount * 4));
+    m_topics = word(TopicsOffset * 4);
+    m_termCount = int(word(TermCount * 4));
+    m_terms = word(TermsOffset * 4);
+    m_postings = word(PostingsOffset * 4);
+    m_postingCount = int(word(PostingCount * 4));
+    m_contextCount = int(word(ContextCount * 4));
+    m_contexts = word(ContextsOffset * 4);
+    m_strings = word(StringsOffset * 4);
+    m_stringsSize = word(StringsSize * 4);
+    m_extras = word(ExtrasOffset * 4);
+    m_extrasSize = word(ExtrasSize * 4);
+
+    const auto fits = [size](qint64 offset, qint64 bytes) {
+        return offset >= 0 && bytes >= 0 && offset + bytes <= size;
+    };
+    if (!fits(m_topics, qint64(m_topicCount) * TOPIC_WORDS * 4)
+        || !fits(m_terms, qint64(m_termCount) * TERM_WORDS * 4)
+        || !fits(m_postings, qint64(m_postingCount) * 4)
+        || !fits(m_contexts, qint64(m_contextCount) * CONTEXT_WORDS * 4)
+        || !fits(m_strings, m_stringsSize) || !fits(m_extras, m_extrasSize)) {
+        m_base = nullptr;
+        m_error = "The help corpus is truncated";
+        return false;
+    }
+    m_error.clear();
+    return true;
+}
+
+quint32 HelpCorpus::word(qint64 offset) const
+{
+    return qFromLittleEndian<quint32>(m_base + offset);
+}
+
+QByteArray HelpCorpus::bytes(qint64 referenceOffset) const
+{
+    const qint64 offset = word(referenceOffset);
+    const qint64 length = word(referenceOffset + 4);
+    if (offset + length > m_stringsSize) {
+        return QByteArray();
+    }
+    return QByteArray::fromRawData(reinterpret_cast<const char*>(m_base + m_strings + offset),
+                                   length);
+}
+
+QString HelpCorpus::string(qint64 referenceOffset) const
+{
+    return QString::fromUtf8(bytes(referenceOffset));
+}
+
+qint64 HelpCorpus::topicOffset(int index) const
+{
+    return m_topics + qint64(index) * TOPIC_WORDS * 4;
+}
+
+int HelpCorpus::findTopic(const QByteArray& id) const
+{
+    int low = 0;
+    int high = m_topicCount;
+    while (low < high) {
+        const int middle = low + (high - low) / 2;
+        const int order = compareBytes(bytes(topicOffset(middle) + TOPIC_ID * 4), id);
+        if (order == 0) {
+            return middle;
+        }
+        if (order < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return -1;
+}
+
+HelpCorpus::Topic HelpCorpus::topic(const QString& id) const
+{
+    if (!isOpen()) {
+        return Topic();
+    }
+    const int index = findTopic(id.toUtf8());
+    return index >= 0 ? topicAt(index) : Topic();
+}
+
+HelpCorpus::Topic HelpCorpus::topicAt(int index) const
+{
+    Topic topic;
+    if (!isOpen() || index < 0 || index >= m_topicCount) {
+        return topic;
+    }
+    const qint64 offset = topicOffset(index);
+    topic.id = string(offset + TOPIC_ID * 4);
+    topic.title = string(offset + TOPIC_TITLE * 4);
+    topic.content = string(offset + TOPIC_CONTENT * 4);
+    topic.contextWidget = string(offset + TOPIC_CONTEXT * 4);
+    topic.keywords = string(offset + TOPIC_KEYWORDS * 4).split('\n', Qt::SkipEmptyParts);
+    topic.relatedTopics = string(offset + TOPIC_RELATED * 4).split('\n', Qt::SkipEmptyParts);
+    topic.category = int(word(offset + TOPIC_CATEGORY * 4));
+    topic.priority = qint32(word(offset + TOPIC_PRIORITY * 4));
+    return topic;
+}
+
+QStringList HelpCorpus::topicsInCategory(int category) const
+{
+    QList<QPair<qint32, int>> found;
+    for (int index = 0; isOpen() && index < m_topicCount; ++index) {
+        const qint64 offset = topicOffset(index);
+        if (int(word(offset + TOPIC_CATEGORY * 4)) == category) {
+            found.append({qint32(word(offset + TOPIC_PRIORITY * 4)), index});
+        }
+    }
+    std::stable_sort(found.begin(), found.end(), [](const auto& left, const auto& right) {
+        return left.first > right.first;
+    });
+
+    QStringList ids;
+    for (const auto& entry : std::as_const(found)) {
+        ids.append(string(topicOffset(entry.second) + TOPIC_ID * 4));
+    }
+    return ids;
+}
+
+QString HelpCorpus::contextTopic(const QString& widgetName) const
+{
+    if (!isOpen() || widgetName.isEmpty()) {
+        return QString();
+    }
+    const QByteArray name = widgetName.toUtf8();
+    int low = 0;
+    int high = m_contextCount;
+    while (low < high) {
+        const int middle = low + (high - low) / 2;
+        const qint64 offset = m_contexts + qint64(middle) * CONTEXT_WORDS * 4;
+        const int order = compareBytes(bytes(offset), name);
+        if (order == 0) {
+            const int topic = int(word(offset + 8));
+            return topic < m_topicCount ? string(topicOffset(topic) + TOPIC_ID * 4) : QString();
+        }
+        if (order < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return QString();
+}
+
+QStringList HelpCorpus::search(const QString& query) const
+{
+    if (!isOpen()) {
+        return QStringList();
+    }
+    QStringList words = tokens(query);
+    words.removeDuplicates();
+    if (words.isEmpty()) {
+        return QStringList();
+    }
+
+    // Words matched per topic
+    QHash<int, int> matched;
+    for (const QString& queryWord : std::as_const(words)) {
+        const QByteArray prefix = queryWord.toUtf8();
+        int low = 0;
+        int high = m_termCount;
+        while (low < high) {
+            const int middle = low + (high - low) / 2;
+            if (compareBytes(bytes(m_terms + qint64(middle) * TERM_WORDS * 4), prefix) < 0) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+
+        QSet<int> topics;
+        for (int term = low; term < m_termCount; ++term) {
+            const qint64 offset = m_terms + qint64(term) * TERM_WORDS * 4;
+            if (!bytes(offset).startsWith(prefix)) {
+                break;
+            }
+            const qint64 first = word(offset + 8);
+            const qint64 count = word(offset + 12);
+            for (qint64 posting = first; posting < first + count && posting < m_postingCount;
+                 ++posting) {
+                const int topic = int(word(m_postings + posting * 4));
+                if (topic < m_topicCount) {
+                    topics.insert(topic);
+                }
+            }
+        }
+        for (int topic : std::as_const(topics)) {
+            ++matched[topic];
+        }
+    }
+
+    const int needed = (int(words.size()) + 1) / 2;
+    QList<int> found;
+    for (auto it = matched.cbegin(); it != matched.cend(); ++it) {
+        if (it.value() >= needed) {
+            found.append(it.key());
+        }
+    }
+    std::sort(found.begin(), found.end(), [this, &matched](int left, int right) {
+        if (matched.value(left) != matched.value(right)) {
+            return matched.value(left) > matched.value(right);
+        }
+        const qint32 leftPriority = qint32(word(topicOffset(left) + TOPIC_PRIORITY * 4));
+        const qint32 rightPriority = qint32(word(topicOffset(right) + TOPIC_PRIORITY * 4));
+        return leftPriority != rightPriority ? leftPriority > rightPriority : left < right;
+    });
+
+    QStringList ids;
+    for (int topic : std::as_const(found)) {
+        ids.append(string(topicOffset(topic) + TOPIC_ID * 4));
+    }
+    return ids;
+}
+
+QStringList HelpCorpus::tutorialIds(int category) const
+{
+    decodeExtras();
+    QStringList ids;
+    for (const Tutorial& tutorial : std::as_const(m_tutorials)) {
+        if (tutorial.category == category) {
+            ids.append(tutorial.id);
+        }
+    }
+    return ids;
+}
+
+HelpCorpus::Tutorial HelpCorpus::tutorial(const QString& id) const
+{
+    decodeExtras();
+    for (const Tutorial& tutorial : std::as_const(m_tutorials)) {
+        if (tutorial.id == id) {
+            return tutorial;
+        }
+    }
+    return Tutorial();
+}
+
+QList<HelpCorpus::ContextMapping> HelpCorpus::contextMappings() const
+{
+    decodeExtras();
+    return m_contextMappings;
+}
+
+void HelpCorpus::decodeExtras() const
+{
+    if (m_extrasDecoded || !isOpen()) {
+        return;
+    }
+    m_extrasDecoded = true;
+
+    const QCborMap extras = QCborValue::fromCbor(
+        QByteArray::fromRawData(reinterpret_cast<const char*>(m_base + m_extras), m_extrasSize))
+                                .toMap();
+    for (const QCborValue& value : extras.value("tutorials").toArray()) {
+        const QCborMap object = value.toMap();
+        Tutorial tutorial;
+        tutorial.id = object.value("id").toString();
+        tutorial.title = object.value("title").toString();
+        tutorial.description = object.value("description").toString();
+        tutorial.category = number(object.value("category"), 0);
+        tutorial.prerequisite = object.value("prerequisite").toString();
+        for (const QCborValue& stepValue : object.value("steps").toArray()) {
+            const QCborMap stepObject = stepValue.toMap();
+            TutorialStep step;
+            step.title = stepObject.value("title").toString();
+            step.instruction = stepObject.value("instruction").toString();
+            step.audioDescription = stepObject.value("audioDescription").toString();
+            step.targetWidget = stepObject.value("targetWidget").toString();
+            step.keys = stepObject.value("keys").toString();
+            step.waitForUserAction = stepObject.value("waitForUserAction").toBool(false);
+            tutorial.steps.append(step);
+        }
+        m_tutorials.append(tutorial);
+    }
+    for (const QCborValue& value : extras.value("contexts").toArray()) {
+        const QCborMap object = value.toMap();
+        ContextMapping mapping;
+        mapping.contextId = object.value("contextId").toString();
+        mapping.helpContentId = object.value("helpContentId").toString();
+        mapping.tutorialId = object.value("tutorialId").toString();
+        mapping.audioDescription = object.value("audioDescription").toString();
+        mapping.priority = number(object.value("priority"), mapping.priority);
+        mapping.autoTrigger = object.value("autoTrigger").toBool(mapping.autoTrigger);
+        mapping.autoTriggerDelay = number(object.value("autoTriggerDelay"),
+                                          mapping.autoTriggerDelay);
+        m_contextMappings.append(mapping);
+    }
+}
+
+QStringList HelpCorpus::tokens(const QString& text)
+{
+    static const QRegularExpression markup(R"(<[^>]*>|&#?\w+;)");
+    static const QRegularExpression separators(R"([^\p{L}\p{N}]+)");
+    QString plain = text;
+    plain.replace(markup, " ");
+    return plain.toCaseFolded().split(separators, Qt::SkipEmptyParts);
+}
+
+QStringList HelpCorpus::categoryNames()
+{
+    return {"GettingStarted", "PlayerControls",    "DatabaseManagement", "PlaylistManagement",
+            "KeyboardShortcuts", "Accessibility", "Troubleshooting",    "Advanced"};
+}
+
+QByteArray HelpCorpus::compile(const QJsonObject& manifest, const QString& baseDirectory,
+                               QString* error)
+{
+    const auto fail = [error](const QString& message) {
+        if (error) {
+            *error = message;
+        }
+        return QByteArray();
+    };
+    const QStringList categories = categoryNames();
+    const QDir base(baseDirectory);
+
+    QList<Topic> topics;
+    QSet<QString> ids;
+    for (const QJsonValue& value : manifest.value("topics").toArray()) {
+        const QJsonObject object = value.toObject();
+        Topic topic;
+        topic.id = object.value("id").toString();
+        if (topic.id.isEmpty() || ids.contains(topic.id)) {
+            return fail(QString("Topic without an id, or a second one with id '%1'").arg(topic.id));
+        }
+        ids.insert(topic.id);
+        topic.title = object.value("title").toString();
+        topic.category = int(categories.indexOf(object.value("category").toString()));
+        if (topic.category < 0) {
+            return fail(QString("Topic '%1' has no known category").arg(topic.id));
+        }
+        topic.priority = object.value("priority").toInt();
+        topic.contextWidget = object.value("contextWidget").toString();
+        topic.keywords = stringList(object.value("keywords"));
+        topic.relatedTopics = stringList(object.value("relatedTopics"));
+        topic.content = object.value("content").toString();
+        const QString file = object.value("file").toString();
+        if (!file.isEmpty()) {
+            QFile html(base.filePath(file));
+            if (!html.open(QIODevice::ReadOnly)) {
+                return fail(QString("Cannot read %1: %2").arg(html.fileName(), html.errorString()));
+            }
+            topic.content = QString::fromUtf8(html.readAll());
+        }
+        topics.append(topic);
+    }
+    std::sort(topics.begin(), topics.end(), [](const Topic& left, const Topic& right) {
+        return compareBytes(left.id.toUtf8(), right.id.toUtf8()) < 0;
+    });
+
+    QByteArray pool;
+    QHash<QByteArray, quint32> pooled;
+    const auto reference = [&pool, &pooled](QByteArray& out, const QString& text) {
+        const QByteArray utf8 = text.toUtf8();
+        auto it = pooled.constFind(utf8);
+        if (it == pooled.constEnd()) {
+            it = pooled.insert(utf8, quint32(pool.size()));
+            pool.append(utf8);
+        }
+        appendWord(out, *it);
+        appendWord(out, quint32(utf8.size()));
+    };
+
+    QByteArray topicTable;
+    QMap<QByteArray, QList<int>> terms;
+    QMap<QByteArray, int> contexts;
+    for (int index = 0; index < topics.size(); ++index) {
+        const Topic& topic = topics.at(index);
+        reference(topicTable, topic.id);
+        reference(topicTable, topic.title);
+        reference(topicTable, topic.content);
+        reference(topicTable, topic.contextWidget);
+        reference(topicTable, topic.keywords.join('\n'));
+        reference(topicTable, topic.relatedTopics.join('\n'));
+        appendWord(topicTable, quint32(topic.category));
+        appendWord(topicTable, quint32(qint32(topic.priority)));
+
+        const QStringList words = tokens(topic.title + ' ' + topic.keywords.join(' ') + ' '
+                                         + topic.content);
+        for (const QString& term : QSet<QString>(words.cbegin(), words.cend())) {
+            terms[term.toUtf8()].append(index);
+        }
+        if (!topic.contextWidget.isEmpty()) {
+            if (contexts.contains(topic.contextWidget.toUtf8())) {
+                return fail(QString("Two topics are context help for %1").arg(topic.contextWidget));
+            }
+            contexts.insert(topic.contextWidget.toUtf8(), index);
+        }
+    }
+
+    // QMap orders QByteArray keys byte by byte, as the reader searches them
+    QByteArray termTable;
+    QByteArray postings;
+    int postingCount = 0;
+    for (auto it = terms.begin(); it != terms.end(); ++it) {
+        QList<int>& list = it.value();
+        std::sort(list.begin(), list.end(), [&topics](int left, int right) {
+            const int leftPriority = topics.at(left).priority;
+            const int rightPriority = topics.at(right).priority;
+            return leftPriority != rightPriority ? leftPriority > rightPriority : left < right;
+        });
+        reference(termTable, QString::fromUtf8(it.key()));
+        appendWord(termTable, quint32(postingCount));
+        appendWord(termTable, quint32(list.size()));
+        for (int topic : std::as_const(list)) {
+            appendWord(postings, quint32(topic));
+        }
+        postingCount += int(list.size());
+    }
+
+    QByteArray contextTable;
+    for (auto it = contexts.cbegin(); it != contexts.cend(); ++it) {
+        reference(contextTable, QString::fromUtf8(it.key()));
+        appendWord(contextTable, quint32(it.value()));
+    }
+
+    // Tutorials carry category numbers, like the topics
+    QJsonArray tutorials;
+    for (const QJsonValue& value : manifest.value("tutorials").toArray()) {
+        QJsonObject object = value.toObject();
+        const int category = int(categories.indexOf(object.value("category").toString()));
+        if (object.value("id").toString().isEmpty() || category < 0) {
+            return fail("A tutorial has no id or no known category");
+        }
+        object.insert("category", category);
+        tutorials.append(object);
+    }
+    QJsonObject extrasObject;
+    extrasObject.insert("tutorials", tutorials);
+    extrasObject.insert("contexts", manifest.value("contexts").toArray());
+    const QByteArray extras = QCborValue::fromJsonValue(extrasObject).toCbor();
+
+    QByteArray corpus(HEADER_WORDS * 4, '\0');
+    setWord(corpus, 0, MAGIC);
+    setWord(corpus, 1, VERSION);
+    setWord(corpus, TopicCount, quint32(topics.size()));
+    setWord(corpus, TopicsOffset, quint32(corpus.size()));
+    corpus.append(topicTable);
+    setWord(corpus, TermCount, quint32(terms.size()));
+    setWord(corpus, TermsOffset, quint32(corpus.size()));
+    corpus.append(termTable);
+    setWord(corpus, PostingsOffset, quint32(corpus.size()));
+    setWord(corpus, PostingCount, quint32(postingCount));
+    corpus.append(postings);
+    setWord(corpus, ContextCount, quint32(contexts.size()));
+    setWord(corpus, ContextsOffset, quint32(corpus.size()));
+    corpus.append(contextTable);
+    setWord(corpus, StringsOffset, quint32(corpus.size()));
+    setWord(corpus, StringsSize, quint32(pool.size()));
+    corpus.append(pool);
+    setWord(corpus, ExtrasOffset, quint32(corpus.size()));
+    setWord(corpus, ExtrasSize, quint32(extras.size()));
+    corpus.append(extras);
+    return corpus;
+}
@@ -0,0 +1,210 @@
+#ifndef HELPCORPUS_H
+#define HELPCORPUS_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+/**
+ * @brief Read-only view of the help texts and their search index, compiled at build time
+ *
+ * AccessibleHelpSystem and ContextSensitiveHelpService used to build their
+ * topics, tutorials, context mappings and search index in code at startup,
+ * whether or not anybody asked for help. The texts now live in src/help as
+ * a JSON manifest and one HTML file per topic, and xfb_helpc compiles them
+ * with compile() into help.bin, which is embedded uncompressed at
+ * BUILT_IN_PATH. Opening it maps the file and checks its header; nothing
+ * is copied or decoded until a topic, a search or a tutorial asks for it.
+ *
+ * Layout of the file, every number a little-endian 32-bit word:
+ * - a header of HEADER_WORDS words: MAGIC, VERSION, then count and offset
+ *   of the topics, the terms, the postings and the context table, offset
+ *   and size of the string pool, and offset and size of the extras;
+ * - topics sorted by id, TOPIC_WORDS words each: id, title, content,
+ *   context widget, keywords and related topics as string references
+ *   (offset into the pool and length, UTF-8; lists joined by newlines),
+ *   then category and priority;
+ * - terms in byte order, TERM_WORDS words each: the term as a string
+ *   reference, then first posting and number of postings;
+ * - postings, topic numbers, each term's by priority, highest first;
+ * - the context table, widget names in byte order with a topic number;
+ * - the extras, tutorials and context mappings as CBOR, decoded on first use.
+ *
+ * Terms are the case-folded words of the title, keywords and text of each
+ * topic, see tokens().
+ *
+ * @example
+ * @code
+ * const HelpCorpus& help = HelpCorpus::builtIn();
+ * for (const QString& id : help.search("volume keys"))
+ *     qDebug() << help.topic(id).title;
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class HelpCorpus
+{
+public:
+    static constexpr quint32 MAGIC = 0x48424658;   ///< "XFBH"
+    static constexpr quint32 VERSION = 1;
+    static constexpr int HEADER_WORDS = 16;
+    static constexpr int TOPIC_WORDS = 14;
+    static constexpr int TERM_WORDS = 4;
+    static constexpr int CONTEXT_WORDS = 3;
+    static constexpr const char* BUILT_IN_PATH = ":/help/help.bin";
+
+    struct Topic {
+        QString id;
+        QString title;
+        QString content;           ///< HTML
+        QString contextWidget;     ///< Class or object name the topic is context help for
+        QStringList keywords;
+        QStringList relatedTopics;
+        int category = 0;          ///< AccessibleHelpSystem::HelpCategory
+        int priority = 0;
+    };
+
+    struct TutorialStep {
+        QString title;
+        QString instruction;
+        QString audioDescription;
+        QString targetWidget;
+        QString keys;              ///< QKeySequence in portable text
+        bool waitForUserAction = false;
+    };
+
+    struct Tutorial {
+        QString id;
+        QString title;
+        QString description;
+        int category = 0;
+        QString prerequisite;
+        QList<TutorialStep> steps;
+    };
+
+    /**
+     * @brief Defaults of ContextSensitiveHelpService, by focused widget
+     */
+    struct ContextMapping {
+        QString contextId;
+        QString helpContentId;
+        QString tutorialId;
+        QString audioDescription;
+        int priority = 0;
+        bool autoTrigger = false;
+        int autoTriggerDelay = 5;
+    };
+
+    HelpCorpus() = default;
+    HelpCorpus(const HelpCorpus&) = delete;
+    HelpCorpus& operator=(const HelpCorpus&) = delete;
+
+    /**
+     * @brief The corpus built into the application, opened on first use
+     */
+    static const HelpCorpus& builtIn();
+
+    /**
+     * @brief Map a compiled corpus
+     * @param path File or resource path
+     * @return true if it is a corpus of this VERSION
+     */
+    bool open(const QString& path);
+
+    /**
+     * @brief Use a compiled corpus held in memory
+     */
+    bool openData(const QByteArray& data);
+
+    bool isOpen() const { return m_base != nullptr; }
+    QString errorString() const { return m_error; }
+
+    int topicCount() const { return m_topicCount; }
+
+    /**
+     * @brief Topic by id; one with an empty id if there is none
+     */
+    Topic topic(const QString& id) const;
+    Topic topicAt(int index) const;
+
+    /**
+     * @brief Ids of the topics of a category, highest priority first
+     */
+    QStringList topicsInCategory(int category) const;
+
+    /**
+     * @brief Topic that is context help for a widget class or object name
+     */
+    QString contextTopic(const QString& widgetName) const;
+
+    /**
+     * @brief Topics matching a query, best first
+     *
+     * Each word of the query matches the terms it is a prefix of. A topic
+     * must match at least half of the words; those matching more words
+     * come first, then those of higher priority.
+     */
+    QStringList search(const QString& query) const;
+
+    QStringList tutorialIds(int category) const;
+    Tutorial tutorial(const QString& id) const;
+
+    QList<ContextMapping> contextMappings() const;
+
+    /**
+     * @brief Compile a manifest and its topic files into a corpus
+     * @param manifest Parsed help.json
+     * @param baseDirectory Directory the topic files are relative to
+     * @param error Set when the manifest is invalid
+     * @return The corpus, empty on error
+     */
+    static QByteArray compile(const QJsonObject& manifest, const QString& baseDirectory,
+                              QString* error = nullptr);
+
+    /**
+     * @brief Case-folded words of a text, HTML tags and entities removed
+     */
+    static QStringList tokens(const QString& text);
+
+    /**
+     * @brief Names of the categories in the manifest, in the order of their numbers
+     */
+    static QStringList categoryNames();
+
+private:
+    bool attach(const uchar* base, qint64 size);
+    quint32 word(qint64 offset) const;
+    QByteArray bytes(qint64 referenceOffset) const;
+    QString string(qint64 referenceOffset) const;
+    qint64 topicOffset(int index) const;
+    int findTopic(const QByteArray& id) const;
+    void decodeExtras() const;
+
+    QFile m_file;
+    QByteArray m_data;
+    const uchar* m_base = nullptr;
+    qint64 m_size = 0;
+    QString m_error;
+
+    int m_topicCount = 0;
+    qint64 m_topics = 0;
+    int m_termCount = 0;
+    qint64 m_terms = 0;
+    qint64 m_postings = 0;
+    int m_postingCount = 0;
+    int m_contextCount = 0;
+    qint64 m_contexts = 0;
+    qint64 m_strings = 0;
+    qint64 m_stringsSize = 0;
+    qint64 m_extras = 0;
+    qint64 m_extrasSize = 0;
+
+    mutable bool m_extrasDecoded = false;
+    mutable QList<Tutorial> m_tutorials;
+    mutable QList<ContextMapping> m_contextMappings;
+};
+
+#endif // HELPCORPUS_H
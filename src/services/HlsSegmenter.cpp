@@ -0,0 +1,403 @@
+#include "HlsSegmenter.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QSaveFile>
+#include <QtEndian>
+#include <QtMath>
+
+namespace {
+
+/// An ISO BMFF box within a buffer
+struct Box {
+    qsizetype start = -1;
+    qsizetype body = 0;       ///< Where its content starts
+    qsizetype end = 0;
+
+    bool isValid() const { return start >= 0; }
+};
+
+quint32 readU32(const QByteArray& data, qsizetype offset)
+{
+    return qFromBigEndian<quint32>(data.constData() + offset);
+}
+
+// The boxes of a type directly inside [begin, end)
+QList<Box> children(const QByteArray& data, qsizetype begin, qsizetype end, const char* type)
+{
+    QList<Box> found;
+    qsizetype offset = begin;
+    while (end - offset >= 8) {
+        quint64 size = readU32(data, offset);
+        qsizetype header = 8;
+        if (size == 1) {
+            if (end - offset < 16) {
+                break;
+            }
+            size = qFromBigEndian<quint64>(data.constData() + offset + 8);
+            header = 16;
+        } else if (size == 0) {
+            size = quint64(end - offset);
+        }
+        if (size < quint64(header) || size > quint64(end - offset)) {
+            break;
+        }
+        if (qstrncmp(data.constData() + offset + 4, type, 4) == 0) {
+            found.append({offset, offset + header, offset + qsizetype(size)});
+        }
+        offset += qsizetype(size);
+    }
+    return found;
+}
+
+Box child(const QByteArray& data, const Box& parent, const char* type)
+{
+    return children(data, parent.body, parent.end, type).value(0);
+}
+
+quint32 flagsOf(const QByteArray& data, const Box& fullBox)
+{
+    return readU32(data, fullBox.body) & 0xffffff;
+}
+
+QString contentTypeOf(const QString& name)
+{
+    return name.endsWith(".m3u8") ? "application/vnd.apple.mpegurl" : "video/mp4";
+}
+
+} // namespace
+
+HlsSegmenter::HlsSegmenter(QObject* parent)
+    : QObject(parent)
+{
+}
+
+HlsSegmenter::~HlsSegmenter() = default;
+
+bool HlsSegmenter::setTarget(const QString& target)
+{
+    m_target = target;
+    const QUrl url(target);
+    if (url.scheme() == "http" || url.scheme() == "https") {
+        m_url = url;
+        if (!m_network) {
+            m_network = new QNetworkAccessManager(this);
+        }
+        return true;
+    }
+
+    m_url = QUrl();
+    if (!QDir().mkpath(target)) {
+        fail("setTarget", QString("Cannot create %1").arg(target));
+        return false;
+    }
+    return true;
+}
+
+void HlsSegmenter::setSegmentMs(int segmentMs)
+{
+    m_segmentMs = qMax(500, segmentMs);
+}
+
+void HlsSegmenter::setPlaylistLength(int segments)
+{
+    m_playlistLength = qMax(1, segments);
+}
+
+void HlsSegmenter::write(const QByteArray& data)
+{
+    if (m_broken || m_target.isEmpty()) {
+        return;
+    }
+    m_buffer += data;
+    parse();
+}
+
+void HlsSegmenter::reset()
+{
+    m_buffer.clear();
+    m_boxStart = 0;
+    m_moofStart = -1;
+    m_broken = false;
+    m_timescale = 0;
+    m_defaultSampleDuration = 0;
+    m_pendingTicks = 0;
+    m_initName.clear();
+    m_discontinuity = m_sequence > 0;
+}
+
+QString HlsSegmenter::playlist() const
+{
+    qint64 longestMs = m_segmentMs;
+    for (const Segment& segment : m_segments) {
+        longestMs = qMax(longestMs, segment.durationMs);
+    }
+
+    QString text = "#EXTM3U\n#EXT-X-VERSION:7\n";
+    text += QString("#EXT-X-TARGETDURATION:%1\n").arg(qCeil(longestMs / 1000.0));
+    text += QString("#EXT-X-MEDIA-SEQUENCE:%1\n").arg(m_firstSequence);
+    if (m_discontinuitySequence > 0) {
+        text += QString("#EXT-X-DISCONTINUITY-SEQUENCE:%1\n").arg(m_discontinuitySequence);
+    }
+    QString initName;
+    for (const Segment& segment : m_segments) {
+        if (segment.discontinuity) {
+            text += "#EXT-X-DISCONTINUITY\n";
+        }
+        if (segment.initName != initName) {
+            initName = segment.initName;
+            text += QString("#EXT-X-MAP:URI=\"%1\"\n").arg(initName);
+        }
+        text += QString("#EXTINF:%1,\n%2\n")
+                    .arg(segment.durationMs / 1000.0, 0, 'f', 3)
+                    .arg(segment.name);
+    }
+    return text;
+}
+
+void HlsSegmenter::parse()
+{
+    while (!m_broken) {
+        const qsizetype available = m_buffer.size() - m_boxStart;
+        if (available < 8) {
+            return;
+        }
+        quint64 size = readU32(m_buffer, m_boxStart);
+        qsizetype header = 8;
+        if (size == 1) {
+            if (available < 16) {
+                return;
+            }
+            size = qFromBigEndian<quint64>(m_buffer.constData() + m_boxStart + 8);
+            header = 16;
+        }
+        if (size < quint64(header) || size > quint64(MAX_BOX_BYTES)) {
+            fail("parse", "The encoder output is not fragmented MP4");
+            m_broken = true;
+            m_buffer.clear();
+            return;
+        }
+        if (quint64(available) < size) {
+            return;
+        }
+
+        const qsizetype end = m_boxStart + qsizetype(size);
+        const char* type = m_buffer.constData() + m_boxStart + 4;
+        if (qstrncmp(type, "moov", 4) == 0) {
+            onInit(m_boxStart, end);
+        } else if (qstrncmp(type, "moof", 4) == 0 && !m_initName.isEmpty()) {
+            m_moofStart = m_boxStart;
+            m_boxStart = end;
+        } else if (qstrncmp(type, "mdat", 4) == 0 && m_moofStart >= 0) {
+            onFragment(m_moofStart, end);
+        } else {
+            // "ftyp", "styp", "sidx" and the like go along with what follows
+            m_boxStart = end;
+        }
+    }
+}
+
+void HlsSegmenter::onInit(qsizetype moovStart, qsizetype end)
+{
+    const Box moov{moovStart, moovStart + 8, end};
+    m_timescale = 0;
+    m_defaultSampleDuration = 0;
+    for (const Box& trak : children(m_buffer, moov.body, moov.end, "trak")) {
+        const Box mdhd = child(m_buffer, child(m_buffer, trak, "mdia"), "mdhd");
+        if (!mdhd.isValid() || mdhd.end - mdhd.body < 4) {
+            continue;
+        }
+        // Version 1 has 64 bit creation and modification times
+        const qsizetype offset = mdhd.body + (m_buffer.at(mdhd.body) == 1 ? 20 : 12);
+        if (offset + 4 <= mdhd.end) {
+            m_timescale = readU32(m_buffer, offset);
+            break;
+        }
+    }
+    const Box trex = child(m_buffer, child(m_buffer, moov, "mvex"), "trex");
+    if (trex.isValid() && trex.end - trex.body >= 16) {
+        m_defaultSampleDuration = readU32(m_buffer, trex.body + 12);
+    }
+    if (m_timescale == 0) {
+        fail("parse", "The encoder output has no audio track");
+        m_broken = true;
+        m_buffer.clear();
+        return;
+    }
+
+    QByteArray init = std::move(m_buffer);
+    m_buffer = init.mid(end);
+    init.truncate(end);
+    m_boxStart = 0;
+    m_moofStart = -1;
+    m_pendingTicks = 0;
+    m_initName = QString("init%1.mp4").arg(++m_initCount);
+    store(m_initName, init, false);
+}
+
+void HlsSegmenter::onFragment(qsizetype moofStart, qsizetype end)
+{
+    const Box moof{moofStart, moofStart + 8, end};
+    const Box traf = child(m_buffer, moof, "traf");
+    quint32 defaultDuration = m_defaultSampleDuration;
+    const Box tfhd = child(m_buffer, traf, "tfhd");
+    if (tfhd.isValid()) {
+        const quint32 flags = flagsOf(m_buffer, tfhd);
+        qsizetype offset = tfhd.body + 8;
+        offset += (flags & 0x01) ? 8 : 0;
+        offset += (flags & 0x02) ? 4 : 0;
+        if ((flags & 0x08) && offset + 4 <= tfhd.end) {
+            defaultDuration = readU32(m_buffer, offset);
+        }
+    }
+
+    quint64 ticks = 0;
+    for (const Box& trun : children(m_buffer, traf.body, traf.end, "trun")) {
+        const quint32 flags = flagsOf(m_buffer, trun);
+        const quint32 count = trun.end - trun.body >= 8 ? readU32(m_buffer, trun.body + 4) : 0;
+        if (!(flags & 0x100)) {
+            ticks += quint64(count) * defaultDuration;
+            continue;
+        }
+        qsizetype offset = trun.body + 8;
+        offset += (flags & 0x01) ? 4 : 0;
+        offset += (flags & 0x04) ? 4 : 0;
+        // Each sample lists whichever of duration, size, flags and offset are set
+        int stride = 0;
+        for (quint32 bit : {0x100u, 0x200u, 0x400u, 0x800u}) {
+            stride += (flags & bit) ? 4 : 0;
+        }
+        for (quint32 i = 0; i < count && offset + 4 <= trun.end; ++i, offset += stride) {
+            ticks += readU32(m_buffer, offset);
+        }
+    }
+
+    m_pendingTicks += ticks;
+    m_boxStart = end;
+    m_moofStart = -1;
+    if (m_pendingTicks * 1000 >= quint64(m_segmentMs) * m_timescale) {
+        cutSegment(end);
+    }
+}
+
+void HlsSegmenter::cutSegment(qsizetype end)
+{
+    // The segment keeps the buffer, so only what follows it is copied
+    QByteArray data = std::move(m_buffer);
+    m_buffer = data.mid(end);
+    data.truncate(end);
+    m_boxStart = 0;
+
+    Segment segment;
+    segment.name = QString("segment%1.m4s").arg(m_sequence);
+    segment.initName = m_initName;
+    segment.durationMs = qint64(m_pendingTicks * 1000 / m_timescale);
+    segment.discontinuity = m_discontinuity;
+    m_discontinuity = false;
+    m_pendingTicks = 0;
+    publish(segment, data);
+}
+
+void HlsSegmenter::publish(const Segment& segment, const QByteArray& data)
+{
+    m_segments.append(segment);
+    ++m_sequence;
+    while (m_segments.size() > m_playlistLength) {
+        const Segment left = m_segments.takeFirst();
+        ++m_firstSequence;
+        if (left.discontinuity) {
+            ++m_discontinuitySequence;
+        }
+        m_retired.append(left);
+    }
+
+    while (m_retired.size() > GRACE_SEGMENTS) {
+        const Segment old = m_retired.takeFirst();
+        remove(old.name);
+        // Its init segment goes with the last segment that needs it
+        bool needed = old.initName == m_initName;
+        for (const Segment& other : std::as_const(m_retired)) {
+            needed = needed || other.initName == old.initName;
+        }
+        for (const Segment& other : std::as_const(m_segments)) {
+            needed = needed || other.initName == old.initName;
+        }
+        if (!needed) {
+            remove(old.initName);
+        }
+    }
+
+    store(segment.name, data, true);
+    emit segmentWritten(segment.name, segment.durationMs);
+}
+
+void HlsSegmenter::store(const QString& name, const QByteArray& data, bool updatePlaylist)
+{
+    if (!m_url.isValid()) {
+        QFile file(QDir(m_target).filePath(name));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)
+            || file.write(data) != data.size()) {
+            fail("store", QString("Cannot write %1: %2").arg(file.fileName(), file.errorString()));
+            return;
+        }
+        file.close();
+        if (updatePlaylist) {
+            // Players read the playlist at any time, so it is replaced whole
+            QSaveFile playlistFile(QDir(m_target).filePath(m_playlistName));
+            if (!playlistFile.open(QIODevice::WriteOnly)
+                || playlistFile.write(playlist().toUtf8()) < 0 || !playlistFile.commit()) {
+                fail("store", QString("Cannot write %1: %2")
+                                  .arg(playlistFile.fileName(), playlistFile.errorString()));
+            }
+        }
+        return;
+    }
+
+    QUrl url(m_url);
+    url.setPath(url.path() + (url.path().endsWith('/') ? "" : "/") + name);
+    QNetworkRequest request(url);
+    request.setTransferTimeout(UPLOAD_TIMEOUT_MS);
+    request.setHeader(QNetworkRequest::ContentTypeHeader, contentTypeOf(name));
+
+    ++m_pendingUploads;
+    QNetworkReply* reply = m_network->put(request, data);
+    connect(reply, &QNetworkReply::finished, this, [this, reply, name, updatePlaylist]() {
+        reply->deleteLater();
+        --m_pendingUploads;
+        if (reply->error() != QNetworkReply::NoError) {
+            fail("store", QString("Cannot upload %1: %2").arg(name, reply->errorString()));
+        } else if (updatePlaylist) {
+            store(m_playlistName, playlist().toUtf8(), false);
+        }
+    });
+}
+
+void HlsSegmenter::remove(const QString& name)
+{
+    if (!m_url.isValid()) {
+        QFile::remove(QDir(m_target).filePath(name));
+        return;
+    }
+
+    QUrl url(m_url);
+    url.setPath(url.path() + (url.path().endsWith('/') ? "" : "/") + name);
+    QNetworkRequest request(url);
+    request.setTransferTimeout(UPLOAD_TIMEOUT_MS);
+    QNetworkReply* reply = m_network->deleteResource(request);
+    connect(reply, &QNetworkReply::finished, reply, [reply, name]() {
+        // A segment left behind only costs space on the server
+        if (reply->error() != QNetworkReply::NoError) {
+            qDebug() << "HlsSegmenter: could not delete" << name << reply->errorString();
+        }
+        reply->deleteLater();
+    });
+}
+
+void HlsSegmenter::fail(const QString& operation, const QString& error)
+{
+    qWarning() << QString("HlsSegmenter::%1 - %2").arg(operation, error);
+    emit operationError(operation, error);
+}
@@ -0,0 +1,159 @@
+#ifndef HLSSEGMENTER_H
+#define HLSSEGMENTER_H
+
+#include <QByteArray>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QUrl>
+
+class QNetworkAccessManager;
+
+/**
+ * @brief Cuts a fragmented MP4 stream into HLS segments and a rolling playlist
+ *
+ * Web and mobile players want HLS rather than an Icecast mount. An ffmpeg
+ * encoder writing fragmented MP4, see StreamOutput::hlsEncoderArguments(),
+ * hands its output to write(). HlsSegmenter walks the top level boxes as
+ * they arrive: "ftyp" and "moov" make the init segment, and each
+ * "moof"/"mdat" pair a fragment, whose length it reads from the "trun"
+ * sample durations. Fragments are gathered until they last segmentMs(),
+ * and the segment is then written out and added to the playlist, which
+ * keeps the last playlistLength() segments.
+ *
+ * The target is a local directory, or an http(s) URL the files are PUT
+ * under, such as a CDN origin. Every byte is appended once, from the
+ * encoder's pipe to the segment being built, and that same buffer is
+ * written to the file or handed to the upload; nothing is copied on the
+ * way out. The playlist is only updated once its new segment is in place,
+ * and segments that left it are deleted a few segments later, so players
+ * still fetching them are not cut off.
+ *
+ * When the encoder restarts, call reset(): the next stream starts with a
+ * new init segment, marked as a discontinuity in the playlist.
+ *
+ * @example
+ * @code
+ * HlsSegmenter* hls = new HlsSegmenter(this);
+ * hls->setTarget("/var/www/radio/hls");
+ * connect(encoder, &QProcess::readyReadStandardOutput, hls,
+ *         [=]() { hls->write(encoder->readAllStandardOutput()); });
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class HlsSegmenter : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int DEFAULT_SEGMENT_MS = 6000;
+    static constexpr int DEFAULT_PLAYLIST_LENGTH = 6;
+    /// Segments kept after they left the playlist
+    static constexpr int GRACE_SEGMENTS = 2;
+    static constexpr int UPLOAD_TIMEOUT_MS = 10 * 1000;
+    /// A box larger than this is taken for a broken stream
+    static constexpr qint64 MAX_BOX_BYTES = 32 * 1024 * 1024;
+
+    explicit HlsSegmenter(QObject* parent = nullptr);
+    ~HlsSegmenter() override;
+
+    /**
+     * @brief Set where the files go
+     * @param target Directory, created if needed, or an http(s) URL to PUT them under
+     * @return false if the directory cannot be created
+     */
+    bool setTarget(const QString& target);
+    QString target() const { return m_target; }
+
+    void setPlaylistName(const QString& name) { m_playlistName = name; }
+    QString playlistName() const { return m_playlistName; }
+
+    void setSegmentMs(int segmentMs);
+    int segmentMs() const { return m_segmentMs; }
+
+    void setPlaylistLength(int segments);
+    int playlistLength() const { return m_playlistLength; }
+
+    /**
+     * @brief Take more of the encoder's output
+     * @param data Fragmented MP4, in any pieces
+     */
+    void write(const QByteArray& data);
+
+    /**
+     * @brief Expect a new stream, with its own init segment
+     */
+    void reset();
+
+    /**
+     * @brief Get the playlist as it is now
+     */
+    QString playlist() const;
+
+    /// Media sequence number of the next segment
+    qint64 nextSequence() const { return m_sequence; }
+
+    /// Uploads that have not been answered yet
+    int pendingUploads() const { return m_pendingUploads; }
+
+signals:
+    /**
+     * @brief Emitted when a segment was stored and added to the playlist
+     * @param name File name of the segment
+     * @param durationMs Its length
+     */
+    void segmentWritten(const QString& name, qint64 durationMs);
+
+    /**
+     * @brief Emitted when the stream cannot be parsed or a file not stored
+     * @param operation Name of the operation
+     * @param error Error message
+     */
+    void operationError(const QString& operation, const QString& error);
+
+private:
+    struct Segment {
+        QString name;
+        QString initName;         ///< Init segment it is decoded with
+        qint64 durationMs = 0;
+        bool discontinuity = false;
+    };
+
+    void parse();
+    void onInit(qsizetype moovStart, qsizetype end);
+    void onFragment(qsizetype moofStart, qsizetype end);
+    void cutSegment(qsizetype end);
+    void publish(const Segment& segment, const QByteArray& data);
+    void store(const QString& name, const QByteArray& data, bool updatePlaylist);
+    void remove(const QString& name);
+    void fail(const QString& operation, const QString& error);
+
+    QString m_target;
+    QUrl m_url;                   ///< Set when the target is uploaded to
+    QNetworkAccessManager* m_network = nullptr;
+    QString m_playlistName = "live.m3u8";
+    int m_segmentMs = DEFAULT_SEGMENT_MS;
+    int m_playlistLength = DEFAULT_PLAYLIST_LENGTH;
+
+    QByteArray m_buffer;          ///< Init segment or segment being built
+    qsizetype m_boxStart = 0;     ///< Start of the first box not walked yet
+    qsizetype m_moofStart = -1;   ///< "moof" waiting for its "mdat"
+    bool m_broken = false;        ///< Output skipped until reset()
+
+    quint32 m_timescale = 0;
+    quint32 m_defaultSampleDuration = 0;  ///< From "trex"
+    quint64 m_pendingTicks = 0;   ///< Length of the fragments in m_buffer
+    QString m_initName;
+    int m_initCount = 0;
+    bool m_discontinuity = false;
+
+    QList<Segment> m_segments;    ///< In the playlist
+    QList<Segment> m_retired;     ///< Left the playlist, not deleted yet
+    qint64 m_sequence = 0;
+    qint64 m_firstSequence = 0;
+    qint64 m_discontinuitySequence = 0;  ///< Discontinuities that left the playlist
+    int m_pendingUploads = 0;
+};
+
+#endif // HLSSEGMENTER_H
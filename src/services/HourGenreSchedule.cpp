@@ -0,0 +1,125 @@
+#include "HourGenreSchedule.h"
+#include <QDebug>
+#include <QSqlError>
+#include <QSqlQuery>
+
+HourGenreSchedule::HourGenreSchedule(QSqlDatabase& database, QObject* parent)
+    : QObject(parent)
+    , m_database(database)
+{
+}
+
+bool HourGenreSchedule::reload()
+{
+    m_stale = false;
+    m_slots.fill(QString());
+
+    QSqlQuery query(m_database);
+    query.setForwardOnly(true);
+    if (!query.exec("SELECT day, hour, genre FROM hourgenre ORDER BY id")) {
+        QString error = QString("SQL Error: %1").arg(query.lastError().text());
+        logError("reload", error, query.lastQuery());
+        emit operationError("reload", error);
+        return false;
+    }
+
+    int programmed = 0;
+    while (query.next()) {
+        const int index = slotIndex(query.value(0).toInt(), query.value(1).toInt());
+        if (index < 0) {
+            continue;
+        }
+        if (m_slots[index].isEmpty()) {
+            ++programmed;
+        }
+        m_slots[index] = query.value(2).toString();
+    }
+
+    qDebug() << "HourGenreSchedule: loaded" << programmed << "programmed hours";
+    return true;
+}
+
+void HourGenreSchedule::invalidate()
+{
+    m_stale = true;
+}
+
+QString HourGenreSchedule::genreAt(int dayOfWeek, int hour)
+{
+    const int index = slotIndex(dayOfWeek, hour);
+    if (index < 0) {
+        return QString();
+    }
+
+    if (m_stale) {
+        reload();
+    }
+    return m_slots[index];
+}
+
+QString HourGenreSchedule::genreAt(const QDateTime& when)
+{
+    return genreAt(when.date().dayOfWeek(), when.time().hour());
+}
+
+bool HourGenreSchedule::setGenre(int dayOfWeek, int hour, const QString& genre)
+{
+    const int index = slotIndex(dayOfWeek, hour);
+    if (index < 0) {
+        QString error = QString("Invalid slot: day %1, hour %2").arg(dayOfWeek).arg(hour);
+        logError("setGenre", error);
+        emit operationError("setGenre", error);
+        return false;
+    }
+
+    if (!m_database.transaction()) {
+        logError("setGenre", QString("Failed to start transaction: %1").arg(m_database.lastError().text()));
+        return false;
+    }
+
+    // Stored as text, like the rows written by earlier versions
+    QSqlQuery query(m_database);
+    query.prepare("DELETE FROM hourgenre WHERE day = ? AND hour = ?");
+    query.addBindValue(QString::number(dayOfWeek));
+    query.addBindValue(QString::number(hour));
+    bool ok = query.exec();
+
+    if (ok && !genre.isEmpty()) {
+        query.prepare("INSERT INTO hourgenre (day, hour, genre) VALUES (?, ?, ?)");
+        query.addBindValue(QString::number(dayOfWeek));
+        query.addBindValue(QString::number(hour));
+        query.addBindValue(genre);
+        ok = query.exec();
+    }
+
+    if (!ok || !m_database.commit()) {
+        QString error = QString("SQL Error: %1").arg(ok ? m_database.lastError().text() : query.lastError().text());
+        logError("setGenre", error, query.lastQuery());
+        m_database.rollback();
+        emit operationError("setGenre", error);
+        return false;
+    }
+
+    if (!m_stale) {
+        m_slots[index] = genre;
+    }
+    return true;
+}
+
+int HourGenreSchedule::slotIndex(int dayOfWeek, int hour)
+{
+    if (dayOfWeek < 1 || dayOfWeek > DAYS || hour < 0 || hour >= HOURS) {
+        return -1;
+    }
+    return (dayOfWeek - 1) * HOURS + hour;
+}
+
+void HourGenreSchedule::logError(const QString& operation, const QString& error, const QString& query)
+{
+    QString logMessage = QString("HourGenreSchedule::%1 - %2").arg(operation, error);
+    if (!query.isEmpty()) {
+        logMessage += QString(" (Query: %1)").arg(query);
+    }
+
+    qWarning() << logMessage;
+}
@@ -0,0 +1,94 @@
+#ifndef HOURGENRESCHEDULE_H
+#define HOURGENRESCHEDULE_H
+
+#include <QDateTime>
+#include <QObject>
+#include <QSqlDatabase>
+#include <QString>
+#include <array>
+
+/**
+ * @brief In-memory copy of the hourgenre table
+ *
+ * The hourgenre table assigns a genre to each hour of the week for auto
+ * mode. HourGenreSchedule loads it once into a 7 x 24 slot array so the
+ * auto mode filler can resolve the current genre without running a query
+ * per pick. The table is read again on the first lookup after
+ * invalidate(). Writes made through setGenre() update the array directly.
+ *
+ * Days follow QDate::dayOfWeek() (1 = Monday ... 7 = Sunday) and hours run
+ * from 0 to 23, matching the values stored in the table. When a slot has
+ * more than one row, the most recently inserted row wins.
+ *
+ * @example
+ * @code
+ * HourGenreSchedule schedule(db);
+ * QString genre = schedule.genreAt(QDateTime::currentDateTime());
+ * schedule.setGenre(Qt::Friday, 22, "Dance");
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class HourGenreSchedule : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int DAYS = 7;
+    static constexpr int HOURS = 24;
+
+    explicit HourGenreSchedule(QSqlDatabase& database, QObject* parent = nullptr);
+
+    /**
+     * @brief Read the hourgenre table into memory
+     * @return true if the table was read
+     */
+    bool reload();
+
+    /**
+     * @brief Mark the schedule stale so it is read again on the next lookup
+     */
+    void invalidate();
+
+    /**
+     * @brief Get the genre programmed for a slot
+     * @param dayOfWeek Day, 1 (Monday) to 7 (Sunday)
+     * @param hour Hour, 0 to 23
+     * @return Genre name, or an empty string if the slot is free
+     */
+    QString genreAt(int dayOfWeek, int hour);
+
+    /**
+     * @brief Get the genre programmed for a point in time
+     * @param when Local date and time
+     * @return Genre name, or an empty string if the slot is free
+     */
+    QString genreAt(const QDateTime& when);
+
+    /**
+     * @brief Program a genre for a slot, replacing any previous one
+     * @param dayOfWeek Day, 1 (Monday) to 7 (Sunday)
+     * @param hour Hour, 0 to 23
+     * @param genre Genre name, empty to free the slot
+     * @return true on success
+     */
+    bool setGenre(int dayOfWeek, int hour, const QString& genre);
+
+signals:
+    /**
+     * @brief Emitted when a database operation fails
+     * @param operation Name of the operation
+     * @param error Error message
+     */
+    void operationError(const QString& operation, const QString& error);
+
+private:
+    static int slotIndex(int dayOfWeek, int hour);
+    void logError(const QString& operation, const QString& error, const QString& query = QString());
+
+    QSqlDatabase& m_database;
+    std::array<QString, DAYS * HOURS> m_slots;
+    bool m_stale = true;
+};
+
+#endif // HOURGENRESCHEDULE_H
@@ -0,0 +1,140 @@
+#include "IcecastMetadata.h"
+#include <QDebug>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QTimer>
+#include <QUrl>
+
+IcecastMetadata::IcecastMetadata(QObject* parent)
+    : QObject(parent)
+    , m_network(new QNetworkAccessManager(this))
+    , m_timer(new QTimer(this))
+{
+    m_timer->setSingleShot(true);
+    connect(m_timer, &QTimer::timeout, this, &IcecastMetadata::flush);
+}
+
+IcecastMetadata::~IcecastMetadata() = default;
+
+void IcecastMetadata::setServer(const QString& host, quint16 port, const QString& password,
+                                const QString& user)
+{
+    m_host = host;
+    m_port = port;
+    m_password = password;
+    m_user = user;
+}
+
+void IcecastMetadata::setMounts(const QStringList& mounts)
+{
+    m_mounts.clear();
+    for (const QString& mount : mounts) {
+        const QString path = mount.trimmed();
+        if (!path.isEmpty()) {
+            m_mounts << (path.startsWith('/') ? path : '/' + path);
+        }
+    }
+    m_mounts.removeDuplicates();
+}
+
+void IcecastMetadata::setMinIntervalMs(int intervalMs)
+{
+    m_minIntervalMs = qMax(0, intervalMs);
+}
+
+void IcecastMetadata::setTitle(const QString& title)
+{
+    if (title == m_title) {
+        return;
+    }
+    m_title = title;
+    m_dirty = true;
+    flush();
+}
+
+void IcecastMetadata::resend()
+{
+    if (!m_title.isEmpty()) {
+        m_dirty = true;
+        flush();
+    }
+}
+
+void IcecastMetadata::flush()
+{
+    if (!m_dirty || m_inFlight > 0 || m_mounts.isEmpty() || m_host.isEmpty()) {
+        return;
+    }
+    if (m_lastSend.isValid() && m_lastSend.elapsed() < m_minIntervalMs) {
+        m_timer->start(int(m_minIntervalMs - m_lastSend.elapsed()));
+        return;
+    }
+
+    m_dirty = false;
+    m_lastSend.start();
+    for (const QString& mount : std::as_const(m_mounts)) {
+        send(mount);
+    }
+}
+
+void IcecastMetadata::send(const QString& mount)
+{
+    // QUrlQuery would leave a '+' that Icecast reads as a space
+    QUrl url;
+    url.setScheme("http");
+    url.setHost(m_host);
+    url.setPort(m_port);
+    url.setPath("/admin/metadata");
+    const auto encoded = [](const QString& value) {
+        return QString::fromLatin1(QUrl::toPercentEncoding(value));
+    };
+    url.setQuery("mode=updinfo&charset=UTF-8&mount=" + encoded(mount)
+                 + "&song=" + encoded(m_title));
+
+    QNetworkRequest request(url);
+    request.setTransferTimeout(REQUEST_TIMEOUT_MS);
+    request.setRawHeader("Authorization",
+                         "Basic " + (m_user + ':' + m_password).toUtf8().toBase64());
+    request.setHeader(QNetworkRequest::UserAgentHeader, "XFB");
+
+    ++m_inFlight;
+    ++m_requestsSent;
+    QNetworkReply* reply = m_network->get(request);
+    connect(reply, &QNetworkReply::finished, this,
+            [this, reply, mount, title = m_title]() { onReply(reply, mount, title); });
+}
+
+void IcecastMetadata::onReply(QNetworkReply* reply, const QString& mount, const QString& title)
+{
+    reply->deleteLater();
+    --m_inFlight;
+
+    const QByteArray body = reply->readAll();
+    if (reply->error() != QNetworkReply::NoError) {
+        const QString error = QString("%1: %2").arg(mount, reply->errorString());
+        logError("push", error);
+        emit operationError("push", error);
+    } else if (body.contains("<return>0</return>")) {
+        // Icecast answers 200 with a message when it will not take the update
+        const qsizetype start = body.indexOf("<message>");
+        const qsizetype end = body.indexOf("</message>");
+        const QString message = start >= 0 && end > start
+                                    ? QString::fromUtf8(body.mid(start + 9, end - start - 9))
+                                    : QString("Update refused");
+        const QString error = QString("%1: %2").arg(mount, message);
+        logError("push", error);
+        emit operationError("push", error);
+    } else {
+        emit titleSent(mount, title);
+    }
+
+    if (m_inFlight == 0) {
+        flush();
+    }
+}
+
+void IcecastMetadata::logError(const QString& operation, const QString& error)
+{
+    qWarning() << QString("IcecastMetadata::%1 - %2").arg(operation, error);
+}
@@ -0,0 +1,133 @@
+#ifndef ICECASTMETADATA_H
+#define ICECASTMETADATA_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+class QNetworkAccessManager;
+class QNetworkReply;
+class QTimer;
+
+/**
+ * @brief Pushes the now-playing title to Icecast's admin metadata endpoint
+ *
+ * The title listeners see used to reach Icecast only if butt picked it up.
+ * IcecastMetadata sends it itself, as "/admin/metadata?mode=updinfo", to
+ * every mount given to setMounts(), with the source credentials that
+ * Icecast accepts for the mounts they stream.
+ *
+ * Requests go through one QNetworkAccessManager, which keeps the
+ * connection to the server open between updates when the server lets it.
+ * Nothing waits for them: setTitle() returns at once and the reply is
+ * handled later on the event loop.
+ *
+ * A title is sent as soon as it is set, unless an update is still on its
+ * way or one was sent less than minIntervalMs() ago. The titles set
+ * meanwhile are folded into one, the latest, sent when the one before is
+ * answered and the interval is over. Skipping through a few tracks then
+ * costs two requests, not one per track.
+ *
+ * Icecast only takes these updates for MP3 and AAC mounts; an Ogg stream
+ * carries its titles inside the stream.
+ *
+ * @example
+ * @code
+ * IcecastMetadata* metadata = new IcecastMetadata(this);
+ * metadata->setServer("127.0.0.1", 8000, "hackme");
+ * metadata->setMounts({"/live.mp3"});
+ * connect(engine, &PlaybackEngine::trackStarted, metadata,
+ *         [=](const QString& path) { metadata->setTitle(QFileInfo(path).completeBaseName()); });
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class IcecastMetadata : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int DEFAULT_MIN_INTERVAL_MS = 1000;
+    static constexpr int REQUEST_TIMEOUT_MS = 5000;
+
+    explicit IcecastMetadata(QObject* parent = nullptr);
+    ~IcecastMetadata() override;
+
+    /**
+     * @brief Set the server the mounts are on
+     * @param host Icecast host
+     * @param port Icecast port
+     * @param password Source password of the mounts
+     * @param user Source user name
+     */
+    void setServer(const QString& host, quint16 port, const QString& password,
+                   const QString& user = "source");
+
+    /**
+     * @brief Set the mounts to update; an empty list turns the updates off
+     */
+    void setMounts(const QStringList& mounts);
+    QStringList mounts() const { return m_mounts; }
+
+    void setMinIntervalMs(int intervalMs);
+    int minIntervalMs() const { return m_minIntervalMs; }
+
+    /**
+     * @brief Show this title to listeners
+     *
+     * The same title as the last one is not sent again.
+     */
+    void setTitle(const QString& title);
+    QString title() const { return m_title; }
+
+    /**
+     * @brief Send the current title again, such as when a mount reconnected
+     */
+    void resend();
+
+    /**
+     * @brief Get whether a title is waiting to be sent or answered
+     */
+    bool isPending() const { return m_dirty || m_inFlight > 0; }
+
+    int requestsSent() const { return m_requestsSent; }
+
+signals:
+    /**
+     * @brief Emitted when a mount accepted a title
+     * @param mount Mount point
+     * @param title Title it shows
+     */
+    void titleSent(const QString& mount, const QString& title);
+
+    /**
+     * @brief Emitted when an update could not be sent or was refused
+     * @param operation Name of the operation
+     * @param error Error message
+     */
+    void operationError(const QString& operation, const QString& error);
+
+private:
+    void flush();
+    void send(const QString& mount);
+    void onReply(QNetworkReply* reply, const QString& mount, const QString& title);
+    void logError(const QString& operation, const QString& error);
+
+    QNetworkAccessManager* m_network;
+    QTimer* m_timer;
+    QString m_host;
+    quint16 m_port = 8000;
+    QString m_user = "source";
+    QString m_password;
+    QStringList m_mounts;
+    int m_minIntervalMs = DEFAULT_MIN_INTERVAL_MS;
+
+    QString m_title;
+    bool m_dirty = false;       ///< m_title has not been sent yet
+    int m_inFlight = 0;         ///< Replies still to come
+    QElapsedTimer m_lastSend;
+    int m_requestsSent = 0;
+};
+
+#endif // ICECASTMETADATA_H
@@ -0,0 +1,222 @@
+#include "IcecastSource.h"
+#include <QDebug>
+#include <QStringList>
+#include <QTcpSocket>
+#include <QTimer>
+#include <algorithm>
+
+namespace {
+
+// Icecast sends a status line and a few headers; anything longer is not Icecast
+constexpr int MAX_RESPONSE_BYTES = 8192;
+
+QByteArray headerValue(const QString& value)
+{
+    return value.simplified().toUtf8();
+}
+
+} // namespace
+
+IcecastSource::IcecastSource(QObject* parent)
+    : QObject(parent)
+    , m_timer(new QTimer(this))
+{
+    m_timer->setSingleShot(true);
+    connect(m_timer, &QTimer::timeout, this, [this]() {
+        if (m_state == State::Backoff) {
+            connectToServer();
+        } else if (m_state == State::Connecting) {
+            fail("Timed out waiting for the server");
+        }
+    });
+}
+
+IcecastSource::~IcecastSource()
+{
+    // No state changes from here on
+    m_open = false;
+    dropSocket();
+}
+
+void IcecastSource::setServer(const QString& host, quint16 port, const QString& mount,
+                              const QString& password, const QString& user)
+{
+    m_host = host;
+    m_port = port;
+    m_mount = mount.startsWith('/') ? mount : "/" + mount;
+    m_password = password;
+    m_user = user;
+    m_useSourceMethod = false;
+}
+
+void IcecastSource::open()
+{
+    if (m_open) {
+        return;
+    }
+    m_open = true;
+    m_retryDelayMs = MIN_RECONNECT_DELAY_MS;
+    connectToServer();
+}
+
+void IcecastSource::close()
+{
+    m_open = false;
+    m_timer->stop();
+    dropSocket();
+    setState(State::Disconnected);
+}
+
+void IcecastSource::write(const QByteArray& data)
+{
+    if (m_state != State::Streaming || !m_socket || m_socket->bytesToWrite() > MAX_BACKLOG_BYTES) {
+        m_bytesDropped += data.size();
+        return;
+    }
+    m_socket->write(data);
+    m_bytesSent += data.size();
+}
+
+void IcecastSource::connectToServer()
+{
+    dropSocket();
+    m_response.clear();
+
+    QTcpSocket* socket = new QTcpSocket(this);
+    m_socket = socket;
+    connect(socket, &QTcpSocket::connected, this, &IcecastSource::sendRequest);
+    connect(socket, &QTcpSocket::readyRead, this, &IcecastSource::onReadyRead);
+    connect(socket, &QTcpSocket::disconnected, this,
+            [this]() { fail(QString("Connection to %1 closed").arg(m_mount)); });
+    connect(socket, &QTcpSocket::errorOccurred, this,
+            [this, socket](QAbstractSocket::SocketError) { fail(socket->errorString()); });
+
+    setState(State::Connecting);
+    m_timer->start(CONNECT_TIMEOUT_MS);
+    socket->connectToHost(m_host, m_port);
+}
+
+void IcecastSource::dropSocket()
+{
+    if (!m_socket) {
+        return;
+    }
+    m_socket->disconnect(this);
+    m_socket->abort();
+    m_socket->deleteLater();
+    m_socket = nullptr;
+}
+
+void IcecastSource::sendRequest()
+{
+    m_socket->write(requestHeader());
+}
+
+QByteArray IcecastSource::requestHeader() const
+{
+    const QByteArray mount = headerValue(m_mount);
+    QByteArray request;
+    if (m_useSourceMethod) {
+        request += "SOURCE " + mount + " HTTP/1.0\r\n";
+    } else {
+        request += "PUT " + mount + " HTTP/1.1\r\n";
+        request += "Host: " + headerValue(m_host) + ":" + QByteArray::number(m_port) + "\r\n";
+    }
+    request += "Authorization: Basic " + (m_user + ":" + m_password).toUtf8().toBase64() + "\r\n";
+    request += "User-Agent: XFB/2.0\r\n";
+    request += "Content-Type: " + headerValue(m_contentType) + "\r\n";
+    request += QByteArray("Ice-Public: ") + (m_info.isPublic ? "1" : "0") + "\r\n";
+    if (!m_info.name.isEmpty()) {
+        request += "Ice-Name: " + headerValue(m_info.name) + "\r\n";
+    }
+    if (!m_info.description.isEmpty()) {
+        request += "Ice-Description: " + headerValue(m_info.description) + "\r\n";
+    }
+    if (!m_info.genre.isEmpty()) {
+        request += "Ice-Genre: " + headerValue(m_info.genre) + "\r\n";
+    }
+    if (!m_info.url.isEmpty()) {
+        request += "Ice-Url: " + headerValue(m_info.url) + "\r\n";
+    }
+    if (m_info.bitrateKbps > 0) {
+        const QByteArray bitrate = QByteArray::number(m_info.bitrateKbps);
+        request += "Ice-Bitrate: " + bitrate + "\r\n";
+        request += "Ice-Audio-Info: bitrate=" + bitrate + "\r\n";
+    }
+    if (!m_useSourceMethod) {
+        request += "Expect: 100-continue\r\n";
+    }
+    request += "\r\n";
+    return request;
+}
+
+void IcecastSource::onReadyRead()
+{
+    if (m_state == State::Streaming) {
+        // Nothing the server says now matters; it closes the socket to stop us
+        m_socket->readAll();
+        return;
+    }
+
+    m_response += m_socket->readAll();
+    const qsizetype end = m_response.indexOf("\r\n");
+    if (end < 0) {
+        if (m_response.size() > MAX_RESPONSE_BYTES) {
+            fail("Not an Icecast server");
+        }
+        return;
+    }
+
+    const QString statusLine = QString::fromLatin1(m_response.left(end));
+    const QStringList parts = statusLine.split(' ', Qt::SkipEmptyParts);
+    const int code = parts.size() > 1 && parts[0].startsWith("HTTP/") ? parts[1].toInt() : 0;
+
+    if (code == 100 || code == 200) {
+        startStreaming();
+    } else if (!m_useSourceMethod && (code == 400 || code == 405 || code == 501)) {
+        // Icecast before 2.4 only knows the SOURCE method
+        qDebug() << "IcecastSource:" << m_host << "does not accept PUT, using SOURCE";
+        m_useSourceMethod = true;
+        connectToServer();
+    } else if (code == 401) {
+        fail(QString("Wrong source password for %1").arg(m_mount));
+    } else {
+        fail(QString("The server refused %1: %2").arg(m_mount, statusLine));
+    }
+}
+
+void IcecastSource::startStreaming()
+{
+    m_timer->stop();
+    m_response.clear();
+    m_retryDelayMs = MIN_RECONNECT_DELAY_MS;
+    setState(State::Streaming);
+    if (!m_header.isEmpty()) {
+        m_socket->write(m_header);
+        m_bytesSent += m_header.size();
+    }
+}
+
+void IcecastSource::fail(const QString& error)
+{
+    dropSocket();
+    qWarning() << QString("IcecastSource::%1 - %2").arg(m_mount, error);
+    emit errorOccurred(error);
+
+    if (!m_open) {
+        setState(State::Disconnected);
+        return;
+    }
+    setState(State::Backoff);
+    m_timer->start(m_retryDelayMs);
+    m_retryDelayMs = std::min(m_retryDelayMs * 2, MAX_RECONNECT_DELAY_MS);
+}
+
+void IcecastSource::setState(State state)
+{
+    if (m_state == state) {
+        return;
+    }
+    m_state = state;
+    emit stateChanged(state);
+}
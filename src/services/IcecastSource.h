@@ -0,0 +1,165 @@
+#ifndef ICECASTSOURCE_H
+#define ICECASTSOURCE_H
+
+#include <QByteArray>
+#include <QObject>
+#include <QString>
+
+class QTcpSocket;
+class QTimer;
+
+/**
+ * @brief Source connection that feeds one Icecast mount point
+ *
+ * Speaks the Icecast source protocol directly: an HTTP PUT with
+ * "Expect: 100-continue" as Icecast 2.4 and later expect, falling back to
+ * the older SOURCE method when the server does not know PUT. Once the
+ * server accepts the mount, everything passed to write() is sent as the
+ * stream body.
+ *
+ * A live stream cannot wait for the network. When the connection falls
+ * behind by more than MAX_BACKLOG_BYTES, new data is dropped and counted
+ * instead of queued. When the connection drops, it is reopened after a
+ * delay that doubles on each failure, up to MAX_RECONNECT_DELAY_MS.
+ *
+ * Listeners of an Ogg stream need its header pages before any audio. Give
+ * them to setStreamHeader(), and they are sent again at the start of every
+ * new connection.
+ *
+ * @example
+ * @code
+ * IcecastSource* source = new IcecastSource(this);
+ * source->setServer("127.0.0.1", 8000, "/live.mp3", "hackme");
+ * source->setContentType("audio/mpeg");
+ * source->open();
+ * connect(encoder, &QProcess::readyReadStandardOutput, source,
+ *         [=]() { source->write(encoder->readAllStandardOutput()); });
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class IcecastSource : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class State {
+        Disconnected,  ///< Not opened, or closed
+        Connecting,    ///< Waiting for the server to accept the mount
+        Streaming,     ///< Sending data
+        Backoff        ///< Connection lost; reconnecting after a delay
+    };
+    Q_ENUM(State)
+
+    /**
+     * @brief What the server shows listeners and directories about the stream
+     */
+    struct StreamInfo {
+        QString name;
+        QString description;
+        QString genre;
+        QString url;
+        int bitrateKbps = 0;
+        bool isPublic = false;
+    };
+
+    static constexpr int DEFAULT_PORT = 8000;
+    static constexpr int CONNECT_TIMEOUT_MS = 10 * 1000;
+    static constexpr int MIN_RECONNECT_DELAY_MS = 1000;
+    static constexpr int MAX_RECONNECT_DELAY_MS = 30 * 1000;
+    static constexpr qint64 MAX_BACKLOG_BYTES = 512 * 1024;
+
+    explicit IcecastSource(QObject* parent = nullptr);
+    ~IcecastSource() override;
+
+    /**
+     * @brief Set where to stream to; takes effect on the next connection
+     * @param host Icecast host
+     * @param port Icecast port
+     * @param mount Mount point, such as "/live.ogg"
+     * @param password Source password
+     * @param user Source user name
+     */
+    void setServer(const QString& host, quint16 port, const QString& mount, const QString& password,
+                   const QString& user = "source");
+
+    QString mount() const { return m_mount; }
+
+    void setContentType(const QString& contentType) { m_contentType = contentType; }
+    QString contentType() const { return m_contentType; }
+
+    void setStreamInfo(const StreamInfo& info) { m_info = info; }
+    StreamInfo streamInfo() const { return m_info; }
+
+    /**
+     * @brief Set data that every new connection starts with
+     * @param header Ogg header pages; empty for formats that need none
+     */
+    void setStreamHeader(const QByteArray& header) { m_header = header; }
+
+    /**
+     * @brief Connect, and keep reconnecting until close()
+     */
+    void open();
+
+    /**
+     * @brief Disconnect and stop reconnecting
+     */
+    void close();
+
+    /**
+     * @brief Send stream data
+     *
+     * Data is dropped while not streaming or when the connection is too far
+     * behind.
+     * @param data Encoded audio
+     */
+    void write(const QByteArray& data);
+
+    State state() const { return m_state; }
+    qint64 bytesSent() const { return m_bytesSent; }
+    qint64 bytesDropped() const { return m_bytesDropped; }
+
+signals:
+    /**
+     * @brief Emitted when the connection state changes
+     * @param state New state
+     */
+    void stateChanged(IcecastSource::State state);
+
+    /**
+     * @brief Emitted when the server refuses the mount or the connection fails
+     * @param error Error message
+     */
+    void errorOccurred(const QString& error);
+
+private:
+    void connectToServer();
+    void dropSocket();
+    void sendRequest();
+    void onReadyRead();
+    void startStreaming();
+    void fail(const QString& error);
+    void setState(State state);
+    QByteArray requestHeader() const;
+
+    QTcpSocket* m_socket = nullptr;
+    QTimer* m_timer;
+    QString m_host;
+    quint16 m_port = DEFAULT_PORT;
+    QString m_mount;
+    QString m_user = "source";
+    QString m_password;
+    QString m_contentType = "audio/mpeg";
+    StreamInfo m_info;
+    QByteArray m_header;
+    QByteArray m_response;
+    bool m_useSourceMethod = false;
+    bool m_open = false;
+    State m_state = State::Disconnected;
+    int m_retryDelayMs = MIN_RECONNECT_DELAY_MS;
+    qint64 m_bytesSent = 0;
+    qint64 m_bytesDropped = 0;
+};
+
+#endif // ICECASTSOURCE_H
@@ -0,0 +1,171 @@
+#include "IngestIndex.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QTextStream>
+
+IngestIndex::IngestIndex(const QString& indexFile)
+    : m_indexFile(indexFile)
+{
+}
+
+QString IngestIndex::defaultLocation(const QString& name)
+{
+    const QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    return QDir(dataDir).filePath(name + ".ingest-index");
+}
+
+bool IngestIndex::load()
+{
+    m_directories.clear();
+    m_modified = false;
+
+    QFile file(m_indexFile);
+    if (!file.exists()) {
+        return true;
+    }
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        logError("load", QString("Cannot read %1: %2").arg(m_indexFile, file.errorString()));
+        return false;
+    }
+
+    // "<mtime>\t<directory>" lines, each followed by "\t<file name>" lines
+    QTextStream in(&file);
+    Directory* current = nullptr;
+    while (!in.atEnd()) {
+        const QString line = in.readLine();
+        if (line.isEmpty()) {
+            continue;
+        }
+        if (line.startsWith('\t')) {
+            if (current) {
+                current->files.insert(line.mid(1));
+            }
+            continue;
+        }
+        const qsizetype tab = line.indexOf('\t');
+        bool ok = false;
+        const qint64 mtime = tab > 0 ? line.left(tab).toLongLong(&ok) : 0;
+        if (!ok) {
+            current = nullptr;
+            continue;
+        }
+        current = &m_directories[line.mid(tab + 1)];
+        current->mtime = mtime;
+    }
+    return true;
+}
+
+bool IngestIndex::save()
+{
+    if (!m_modified) {
+        return true;
+    }
+
+    QDir().mkpath(QFileInfo(m_indexFile).absolutePath());
+    QSaveFile file(m_indexFile);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        logError("save", QString("Cannot write %1: %2").arg(m_indexFile, file.errorString()));
+        return false;
+    }
+
+    QTextStream out(&file);
+    for (auto it = m_directories.cbegin(); it != m_directories.cend(); ++it) {
+        out << it.value().mtime << '\t' << it.key() << '\n';
+        for (const QString& name : it.value().files) {
+            out << '\t' << name << '\n';
+        }
+    }
+    out.flush();
+
+    if (!file.commit()) {
+        logError("save", QString("Cannot write %1: %2").arg(m_indexFile, file.errorString()));
+        return false;
+    }
+    m_modified = false;
+    return true;
+}
+
+int IngestIndex::scan(const QString& root, const QStringList& nameFilters, const Acceptor& accept)
+{
+    int accepted = 0;
+    QSet<QString> visited;
+    const QString top = QDir::cleanPath(root);
+
+    QDirIterator it(top, QDir::Dirs | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        const QString path = it.next();
+        visited.insert(path);
+
+        // Taken before listing, so a file added meanwhile moves it again
+        const qint64 mtime = it.fileInfo().lastModified().toMSecsSinceEpoch();
+        Directory& entry = m_directories[path];
+        if (entry.mtime == mtime) {
+            continue;
+        }
+
+        const QDir dir(path);
+        const QStringList names = dir.entryList(nameFilters, QDir::Files);
+        QSet<QString> present;
+        bool complete = true;
+        for (const QString& name : names) {
+            if (entry.files.contains(name)) {
+                present.insert(name);
+            } else if (accept(dir.filePath(name))) {
+                present.insert(name);
+                ++accepted;
+            } else {
+                complete = false;
+            }
+        }
+
+        entry.files = present;
+        entry.mtime = complete ? mtime : -1;
+        m_modified = true;
+    }
+
+    for (auto dir = m_directories.begin(); dir != m_directories.end();) {
+        if (dir.key().startsWith(top + '/') && !visited.contains(dir.key())) {
+            dir = m_directories.erase(dir);
+            m_modified = true;
+        } else {
+            ++dir;
+        }
+    }
+
+    return accepted;
+}
+
+bool IngestIndex::contains(const QString& filePath) const
+{
+    const QFileInfo info(filePath);
+    const auto dir = m_directories.constFind(info.path());
+    return dir != m_directories.cend() && dir.value().files.contains(info.fileName());
+}
+
+int IngestIndex::fileCount() const
+{
+    int count = 0;
+    for (const Directory& dir : m_directories) {
+        count += dir.files.size();
+    }
+    return count;
+}
+
+void IngestIndex::clear()
+{
+    if (!m_directories.isEmpty()) {
+        m_directories.clear();
+        m_modified = true;
+    }
+}
+
+void IngestIndex::logError(const QString& operation, const QString& error) const
+{
+    qWarning() << QString("IngestIndex::%1 - %2").arg(operation, error);
+}
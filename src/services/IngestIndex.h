@@ -0,0 +1,120 @@
+#ifndef INGESTINDEX_H
+#define INGESTINDEX_H
+
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <functional>
+
+/**
+ * @brief Persistent record of which files in a folder tree were already ingested
+ *
+ * The server's programs folder keeps every program ever uploaded, and the
+ * hourly check used to walk all of it and run a database query per file.
+ * IngestIndex remembers, for every directory under the root, its
+ * modification time when it was last listed and the files found in it.
+ * scan() stats each directory, lists only the ones whose modification time
+ * moved (a file was added, removed or renamed in it), and hands the files it
+ * has not seen before to a callback. A scan of an unchanged archive costs
+ * one stat per directory, however many files it holds.
+ *
+ * A file only counts as seen once the callback accepts it. If the callback
+ * rejects a file, for example because the database was unavailable, the
+ * directory is listed again on the next scan and the file is offered again.
+ *
+ * The index is kept in a small text file; nothing is written unless a scan
+ * changed it.
+ *
+ * @example
+ * @code
+ * IngestIndex index(IngestIndex::defaultLocation("programs"));
+ * index.load();
+ * index.scan(programsPath, {"*.ogg", "*.mp3"}, [this](const QString& path) {
+ *     return addProgram(path);
+ * });
+ * index.save();
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class IngestIndex
+{
+public:
+    /// Receives a file that was not seen before; returns true once it is handled
+    using Acceptor = std::function<bool(const QString& filePath)>;
+
+    /**
+     * @param indexFile Where the index is stored
+     */
+    explicit IngestIndex(const QString& indexFile);
+
+    /**
+     * @brief Get the standard place for an index
+     * @param name Index name, such as "programs"
+     * @return Path in the application data directory
+     */
+    static QString defaultLocation(const QString& name);
+
+    QString indexFile() const { return m_indexFile; }
+
+    /**
+     * @brief Read the index file, replacing what is in memory
+     * @return false if the file exists but cannot be read; a missing file is an empty index
+     */
+    bool load();
+
+    /**
+     * @brief Write the index file if a scan changed it
+     * @return true on success or when there was nothing to write
+     */
+    bool save();
+
+    /**
+     * @brief Check if the index holds changes that save() has not written
+     * @return true after a scan that found something
+     */
+    bool isModified() const { return m_modified; }
+
+    /**
+     * @brief Offer new files under a root directory to a callback
+     *
+     * Only the subdirectories of root are scanned, at any depth; files
+     * directly in root are left alone, as that is where uploads wait to be
+     * sorted into their program's folder.
+     * @param root Root directory
+     * @param nameFilters Wildcard patterns of the files to consider
+     * @param accept Receives every file that is not in the index yet
+     * @return Number of files accepted
+     */
+    int scan(const QString& root, const QStringList& nameFilters, const Acceptor& accept);
+
+    /**
+     * @brief Check if a file was already ingested
+     * @param filePath Absolute file path
+     * @return true if a scan accepted it
+     */
+    bool contains(const QString& filePath) const;
+
+    int directoryCount() const { return m_directories.size(); }
+    int fileCount() const;
+
+    /**
+     * @brief Forget everything, so the next scan offers every file again
+     */
+    void clear();
+
+private:
+    struct Directory {
+        qint64 mtime = -1;
+        QSet<QString> files;
+    };
+
+    void logError(const QString& operation, const QString& error) const;
+
+    QString m_indexFile;
+    QHash<QString, Directory> m_directories;
+    bool m_modified = false;
+};
+
+#endif // INGESTINDEX_H
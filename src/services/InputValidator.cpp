@@ -4,28 +4,153 @@
 #include <QUrl>
 #include <QRegularExpression>
 #include <QStandardPaths>
+#include <cstring>
 #include <limits>
 
-// Static member definitions
-const QRegularExpression InputValidator::s_emailRegex(
-    R"(^[a-zA-Z0-9._%+-]+@[a-zA-Z0-9.-]+\.[a-zA-Z]{2,}$)"
-);
+namespace {
 
-const QRegularExpression InputValidator::s_sqlInjectionRegex(
-    R"((\b(SELECT|INSERT|UPDATE|DELETE|DROP|CREATE|ALTER|EXEC|UNION|SCRIPT)\b)|(')|(--)|(;)|(\/\*))",
-    QRegularExpression::CaseInsensitiveOption
-);
+// Bulk imports validate every path and tag, so the common checks scan the
+// text once, character by character, instead of running a regular
+// expression per check. Like the patterns they replaced, the classes are
+// ASCII: \s and \w of a pattern match only ASCII characters.
 
-const QRegularExpression InputValidator::s_directoryTraversalRegex(
-    R"((\.\.[\\/])|(\.\.[\\\/])|([\\\/]\.\.)|(^\.\.)|(\.\.$))"
-);
+inline bool isAsciiLetter(char16_t c)
+{
+    return (c >= u'a' && c <= u'z') || (c >= u'A' && c <= u'Z');
+}
 
-const QRegularExpression InputValidator::s_filenameRegex(
-    R"(^[a-zA-Z0-9._\-\s()]+$)"
-);
+inline bool isAsciiDigit(char16_t c)
+{
+    return c >= u'0' && c <= u'9';
+}
+
+inline bool isAsciiSpace(char16_t c)
+{
+    return c == u' ' || (c >= u'\t' && c <= u'\r');
+}
+
+inline bool isWordCharacter(char16_t c)
+{
+    return isAsciiLetter(c) || isAsciiDigit(c) || c == u'_';
+}
+
+inline bool isFilenameCharacter(char16_t c)
+{
+    return isAsciiLetter(c) || isAsciiDigit(c) || isAsciiSpace(c) || c == u'.' || c == u'_'
+           || c == u'-' || c == u'(' || c == u')';
+}
+
+inline bool isPathSeparator(char16_t c)
+{
+    return c == u'/' || c == u'\\';
+}
 
-const QRegularExpression InputValidator::s_alphaNumericRegex(
-    R"(^[a-zA-Z0-9]+$)"
+/// C0 controls and DEL; text keeps its tabs, line feeds and carriage returns
+inline bool isControlCharacter(char16_t c, bool keepLineBreaks)
+{
+    if (c >= 0x20) {
+        return c == 0x7F;
+    }
+    return !keepLineBreaks || (c != u'\t' && c != u'\n' && c != u'\r');
+}
+
+/// Whether the ".." at index is a traversal: at either end or next to a separator
+inline bool isTraversalAt(const QChar* path, qsizetype size, qsizetype index)
+{
+    if (path[index] != u'.' || index + 1 >= size || path[index + 1] != u'.') {
+        return false;
+    }
+    return index == 0 || isPathSeparator(path[index - 1].unicode()) || index + 2 == size
+           || isPathSeparator(path[index + 2].unicode())
+           || (index + 3 == size && path[index + 2] == u'\n');   // "$" before a final newline
+}
+
+/// The characters of text that keep() accepts; text itself, not a copy, if that is all of them
+template <typename Keep>
+QString keepOnly(const QString& text, Keep keep)
+{
+    const QChar* in = text.constData();
+    const qsizetype size = text.size();
+    qsizetype kept = 0;
+    while (kept < size && keep(in[kept].unicode())) {
+        ++kept;
+    }
+    if (kept == size) {
+        return text;
+    }
+
+    QString result(size, Qt::Uninitialized);
+    QChar* out = result.data();
+    std::memcpy(out, in, size_t(kept) * sizeof(QChar));
+    out += kept;
+    for (qsizetype i = kept + 1; i < size; ++i) {
+        if (keep(in[i].unicode())) {
+            *out++ = in[i];
+        }
+    }
+    result.truncate(out - result.constData());
+    return result;
+}
+
+template <typename Test>
+bool allOf(const QString& text, Test test)
+{
+    for (const QChar& ch : text) {
+        if (!test(ch.unicode())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Runs of whitespace as one space
+QString collapseWhitespace(const QString& text)
+{
+    QString result(text.size(), Qt::Uninitialized);
+    QChar* out = result.data();
+    bool inSpace = false;
+    for (const QChar& ch : text) {
+        if (isAsciiSpace(ch.unicode())) {
+            if (!inSpace) {
+                *out++ = u' ';
+            }
+            inSpace = true;
+        } else {
+            *out++ = ch;
+            inSpace = false;
+        }
+    }
+    result.truncate(out - result.constData());
+    return result;
+}
+
+bool isSqlKeyword(const QChar* word, qsizetype length)
+{
+    static const char* const keywords[] = {"SELECT", "INSERT", "UPDATE", "DELETE", "DROP",
+                                           "CREATE", "ALTER", "EXEC", "UNION", "SCRIPT"};
+    if (length < 4 || length > 6) {
+        return false;
+    }
+    for (const char* keyword : keywords) {
+        if (qsizetype(std::strlen(keyword)) != length) {
+            continue;
+        }
+        qsizetype i = 0;
+        while (i < length && (word[i].unicode() & ~0x20) == char16_t(keyword[i])) {
+            ++i;
+        }
+        if (i == length) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+// Static member definitions
+const QRegularExpression InputValidator::s_emailRegex(
+    R"(^[a-zA-Z0-9._%+-]+@[a-zA-Z0-9.-]+\.[a-zA-Z]{2,}$)"
 );
 
 const QStringList InputValidator::s_audioExtensions = {
@@ -106,8 +231,7 @@ QString InputValidator::sanitizeFilePath(const QString& filePath)
     sanitized = QDir::cleanPath(sanitized);
     
     // Remove null bytes and other control characters
-    sanitized.remove(QChar('\0'));
-    sanitized.remove(QRegularExpression(R"([\x00-\x1F\x7F])"));
+    sanitized = keepOnly(sanitized, [](char16_t c) { return !isControlCharacter(c, false); });
     
     // Limit path length
     if (sanitized.length() > 4096) { // Reasonable path length limit
@@ -123,21 +247,20 @@ bool InputValidator::isPathSafe(const QString& filePath)
         return false;
     }
 
-    // Check for directory traversal patterns
-    if (containsDirectoryTraversal(filePath)) {
-        return false;
-    }
-
-    // Check for null bytes
-    if (filePath.contains(QChar('\0'))) {
-        return false;
-    }
-
     // Check for excessive length
     if (filePath.length() > 4096) {
         return false;
     }
 
+    // Check for null bytes and directory traversal patterns, in one pass
+    const QChar* path = filePath.constData();
+    const qsizetype size = filePath.size();
+    for (qsizetype i = 0; i < size; ++i) {
+        if (path[i].isNull() || isTraversalAt(path, size, i)) {
+            return false;
+        }
+    }
+
     return true;
 }
 
@@ -209,16 +332,19 @@ InputValidator::ValidationResult InputValidator::validateText(const QString& tex
         }
         break;
     case TextType::AlphaNumeric:
-        isValid = s_alphaNumericRegex.match(sanitized).hasMatch();
+        isValid = !sanitized.isEmpty() && allOf(sanitized, [](char16_t c) {
+            return isAsciiLetter(c) || isAsciiDigit(c);
+        });
         if (!isValid) errorMessage = "Text must contain only alphanumeric characters";
         break;
     case TextType::Filename:
-        isValid = s_filenameRegex.match(sanitized).hasMatch();
+        isValid = !sanitized.isEmpty() && allOf(sanitized, isFilenameCharacter);
         if (!isValid) errorMessage = "Invalid filename characters";
         break;
     case TextType::DatabaseName:
         // Database names should be alphanumeric with underscores
-        isValid = QRegularExpression(R"(^[a-zA-Z][a-zA-Z0-9_]*$)").match(sanitized).hasMatch();
+        isValid = !sanitized.isEmpty() && isAsciiLetter(sanitized.at(0).unicode())
+                  && allOf(sanitized, isWordCharacter);
         if (!isValid) errorMessage = "Database name must start with letter and contain only letters, numbers, and underscores";
         break;
     case TextType::General:
@@ -238,39 +364,39 @@ QString InputValidator::sanitizeText(const QString& text, TextType type)
         return text;
     }
 
-    QString sanitized = text;
-
-    // Remove null bytes and control characters
-    sanitized.remove(QChar('\0'));
-    sanitized.remove(QRegularExpression(R"([\x00-\x08\x0B\x0C\x0E-\x1F\x7F])"));
+    QString sanitized;
 
     switch (type) {
     case TextType::Filename:
-        // Keep only safe filename characters
+        // Remove control characters, then replace other unsafe filename characters
+        sanitized = keepOnly(text, [](char16_t c) { return !isControlCharacter(c, true); });
         sanitized = removeUnsafeCharacters(sanitized, type, '_');
         break;
     case TextType::DatabaseName:
         // Keep only alphanumeric and underscore
-        sanitized.remove(QRegularExpression(R"([^a-zA-Z0-9_])"));
+        sanitized = keepOnly(text, isWordCharacter);
         break;
     case TextType::AlphaNumeric:
         // Keep only alphanumeric
-        sanitized.remove(QRegularExpression(R"([^a-zA-Z0-9])"));
+        sanitized = keepOnly(text, [](char16_t c) { return isAsciiLetter(c) || isAsciiDigit(c); });
         break;
     case TextType::Numeric:
         // Keep only numeric characters, decimal point, and minus sign
-        sanitized.remove(QRegularExpression(R"([^0-9.\-])"));
+        sanitized = keepOnly(text, [](char16_t c) {
+            return isAsciiDigit(c) || c == u'.' || c == u'-';
+        });
         break;
     case TextType::Email:
     case TextType::URL:
-        // Trim whitespace for these types
+        // Remove control characters and trim whitespace for these types
+        sanitized = keepOnly(text, [](char16_t c) { return !isControlCharacter(c, true); });
         sanitized = sanitized.trimmed();
         break;
     case TextType::General:
     default:
-        // For general text, just trim and normalize whitespace
-        sanitized = sanitized.trimmed();
-        sanitized.replace(QRegularExpression(R"(\s+)"), " ");
+        // For general text, remove control characters, trim and normalize whitespace
+        sanitized = keepOnly(text, [](char16_t c) { return !isControlCharacter(c, true); });
+        sanitized = collapseWhitespace(sanitized.trimmed());
         break;
     }
 
@@ -475,7 +601,7 @@ bool InputValidator::isCharacterSafe(QChar character, TextType textType)
 
     switch (textType) {
     case TextType::Filename:
-        return s_filenameRegex.match(QString(character)).hasMatch();
+        return isFilenameCharacter(character.unicode());
     case TextType::AlphaNumeric:
         return character.isLetterOrNumber();
     case TextType::Numeric:
@@ -531,10 +657,45 @@ bool InputValidator::isValidConfigExtension(const QString& extension)
 
 bool InputValidator::containsDirectoryTraversal(const QString& filePath)
 {
-    return s_directoryTraversalRegex.match(filePath).hasMatch();
+    const QChar* path = filePath.constData();
+    const qsizetype size = filePath.size();
+    for (qsizetype i = 0; i < size; ++i) {
+        if (isTraversalAt(path, size, i)) {
+            return true;
+        }
+    }
+    return false;
 }
 
 bool InputValidator::containsSqlInjectionPatterns(const QString& text)
 {
-    return s_sqlInjectionRegex.match(text).hasMatch();
+    // Quotes, statement separators, comments, and keywords as whole words
+    const QChar* in = text.constData();
+    const qsizetype size = text.size();
+    qsizetype i = 0;
+    while (i < size) {
+        const char16_t c = in[i].unicode();
+        if (c == u'\'' || c == u';') {
+            return true;
+        }
+        if (i + 1 < size) {
+            const QChar next = in[i + 1];
+            if ((c == u'-' && next == u'-') || (c == u'/' && next == u'*')) {
+                return true;
+            }
+        }
+        if (!isWordCharacter(c)) {
+            ++i;
+            continue;
+        }
+        qsizetype end = i + 1;
+        while (end < size && isWordCharacter(in[end].unicode())) {
+            ++end;
+        }
+        if (isSqlKeyword(in + i, end - i)) {
+            return true;
+        }
+        i = end;
+    }
+    return false;
 }
\ No newline at end of file
@@ -245,12 +245,8 @@ private:
     static bool containsDirectoryTraversal(const QString& filePath);
     static bool containsSqlInjectionPatterns(const QString& text);
     
-    // Regular expressions for validation
+    // Regular expressions for what the character scanners do not cover
     static const QRegularExpression s_emailRegex;
-    static const QRegularExpression s_sqlInjectionRegex;
-    static const QRegularExpression s_directoryTraversalRegex;
-    static const QRegularExpression s_filenameRegex;
-    static const QRegularExpression s_alphaNumericRegex;
     
     // File extension lists
     static const QStringList s_audioExtensions;
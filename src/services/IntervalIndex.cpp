@@ -0,0 +1,152 @@
+#include "IntervalIndex.h"
+#include <algorithm>
+
+namespace {
+
+// Orders by start, then id
+bool before(const IntervalIndex::Interval& interval, qint64 start, qint64 id)
+{
+    return interval.start != start ? interval.start < start : interval.id < id;
+}
+
+} // namespace
+
+bool IntervalIndex::insert(qint64 start, qint64 end, qint64 id)
+{
+    if (end <= start) {
+        return false;
+    }
+
+    int node;
+    if (!m_free.empty()) {
+        node = m_free.back();
+        m_free.pop_back();
+        m_nodes[size_t(node)] = Node();
+    } else {
+        node = int(m_nodes.size());
+        m_nodes.emplace_back();
+    }
+    Node& created = m_nodes[size_t(node)];
+    created.interval = {start, end, id};
+    created.maxEnd = end;
+    created.priority = nextPriority();
+
+    int left;
+    int right;
+    split(m_root, start, id, left, right);
+    m_root = merge(merge(left, node), right);
+    ++m_size;
+    return true;
+}
+
+bool IntervalIndex::remove(qint64 start, qint64 id)
+{
+    int left;
+    int rest;
+    split(m_root, start, id, left, rest);
+    // The matches are then the smallest keys of rest
+    int match;
+    int right;
+    split(rest, start, id + 1, match, right);
+
+    const bool found = match >= 0;
+    if (found) {
+        const Node& removed = m_nodes[size_t(match)];
+        m_free.push_back(match);
+        match = merge(removed.left, removed.right);
+        --m_size;
+    }
+    m_root = merge(merge(left, match), right);
+    return found;
+}
+
+QVector<IntervalIndex::Interval> IntervalIndex::overlapping(qint64 start, qint64 end) const
+{
+    QVector<Interval> found;
+    if (end > start) {
+        collect(m_root, start, end, found);
+    }
+    return found;
+}
+
+void IntervalIndex::clear()
+{
+    m_nodes.clear();
+    m_free.clear();
+    m_root = -1;
+    m_size = 0;
+}
+
+void IntervalIndex::split(int tree, qint64 start, qint64 id, int& left, int& right)
+{
+    if (tree < 0) {
+        left = right = -1;
+        return;
+    }
+    Node& node = m_nodes[size_t(tree)];
+    if (before(node.interval, start, id)) {
+        split(node.right, start, id, node.right, right);
+        left = tree;
+    } else {
+        split(node.left, start, id, left, node.left);
+        right = tree;
+    }
+    update(tree);
+}
+
+int IntervalIndex::merge(int left, int right)
+{
+    if (left < 0) {
+        return right;
+    }
+    if (right < 0) {
+        return left;
+    }
+    if (m_nodes[size_t(left)].priority > m_nodes[size_t(right)].priority) {
+        const int merged = merge(m_nodes[size_t(left)].right, right);
+        m_nodes[size_t(left)].right = merged;
+        update(left);
+        return left;
+    }
+    const int merged = merge(left, m_nodes[size_t(right)].left);
+    m_nodes[size_t(right)].left = merged;
+    update(right);
+    return right;
+}
+
+void IntervalIndex::update(int node)
+{
+    Node& updated = m_nodes[size_t(node)];
+    updated.maxEnd = updated.interval.end;
+    if (updated.left >= 0) {
+        updated.maxEnd = std::max(updated.maxEnd, m_nodes[size_t(updated.left)].maxEnd);
+    }
+    if (updated.right >= 0) {
+        updated.maxEnd = std::max(updated.maxEnd, m_nodes[size_t(updated.right)].maxEnd);
+    }
+}
+
+void IntervalIndex::collect(int node, qint64 start, qint64 end, QVector<Interval>& found) const
+{
+    // Nothing below ends after the range starts
+    if (node < 0 || m_nodes[size_t(node)].maxEnd <= start) {
+        return;
+    }
+    const Node& visited = m_nodes[size_t(node)];
+    collect(visited.left, start, end, found);
+    if (visited.interval.start < end) {
+        if (visited.interval.end > start) {
+            found.append(visited.interval);
+        }
+        collect(visited.right, start, end, found);
+    }
+}
+
+quint32 IntervalIndex::nextPriority()
+{
+    // xorshift32: balanced on average, and the same tree on every run
+    m_seed ^= m_seed << 13;
+    m_seed ^= m_seed >> 17;
+    m_seed ^= m_seed << 5;
+    return m_seed;
+}
@@ -0,0 +1,80 @@
+#ifndef INTERVALINDEX_H
+#define INTERVALINDEX_H
+
+#include <QVector>
+#include <QtGlobal>
+#include <vector>
+
+/**
+ * @brief Interval tree over half-open [start, end) ranges
+ *
+ * A treap ordered by start, each node keeping the latest end below it, so
+ * the intervals overlapping a range are found in O(log n + k) and an
+ * interval is added or removed in O(log n), without rebuilding anything.
+ * An id tells intervals with the same start apart and comes back with
+ * each result.
+ *
+ * @example
+ * @code
+ * IntervalIndex index;
+ * index.insert(fireMs, fireMs + durationMs, rowId);
+ * for (const IntervalIndex::Interval& other : index.overlapping(startMs, endMs))
+ *     qDebug() << "Overlaps rule" << other.id;
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class IntervalIndex
+{
+public:
+    struct Interval {
+        qint64 start = 0;
+        qint64 end = 0;
+        qint64 id = -1;
+    };
+
+    /**
+     * @brief Add an interval
+     * @return false if it is empty, end not after start
+     */
+    bool insert(qint64 start, qint64 end, qint64 id);
+
+    /**
+     * @brief Remove one interval with this start and id
+     * @return false if there is none
+     */
+    bool remove(qint64 start, qint64 id);
+
+    /**
+     * @brief Intervals that share some time with [start, end)
+     * @return Ordered by start
+     */
+    QVector<Interval> overlapping(qint64 start, qint64 end) const;
+
+    int size() const { return m_size; }
+    bool isEmpty() const { return m_size == 0; }
+    void clear();
+
+private:
+    struct Node {
+        Interval interval;
+        qint64 maxEnd = 0;
+        quint32 priority = 0;
+        int left = -1;
+        int right = -1;
+    };
+
+    void split(int tree, qint64 start, qint64 id, int& left, int& right);
+    int merge(int left, int right);
+    void update(int node);
+    void collect(int node, qint64 start, qint64 end, QVector<Interval>& found) const;
+    quint32 nextPriority();
+
+    std::vector<Node> m_nodes;
+    std::vector<int> m_free;   ///< Nodes of removed intervals, reused first
+    int m_root = -1;
+    int m_size = 0;
+    quint32 m_seed = 2463534242u;
+};
+
+#endif // INTERVALINDEX_H
@@ -0,0 +1,134 @@
+#include "JitterBuffer.h"
+#include <algorithm>
+#include <cmath>
+
+JitterBuffer::JitterBuffer(int frameMs)
+    : m_frameMs(qMax(1, frameMs))
+    , m_slots(MAX_PACKETS)
+{
+    updateTarget();
+}
+
+void JitterBuffer::setDelayRange(int minDelayMs, int maxDelayMs)
+{
+    m_minDelayMs = qMax(0, minDelayMs);
+    m_maxDelayMs = qMax(m_minDelayMs, maxDelayMs);
+    updateTarget();
+}
+
+bool JitterBuffer::push(quint16 sequence, const QByteArray& payload, qint64 arrivalMs)
+{
+    if (!m_started) {
+        m_started = true;
+        m_next = sequence;
+        m_newest = sequence;
+    }
+
+    const int ahead = qint16(quint16(sequence - m_next));
+    if (ahead < 0) {
+        ++m_statistics.late;
+        return false;
+    }
+    if (ahead >= MAX_PACKETS) {
+        // Too far ahead to wait for the gap: the sender restarted or skipped
+        for (Slot& stale : m_slots) {
+            stale = Slot();
+        }
+        m_next = sequence;
+        m_newest = sequence;
+        m_buffering = true;
+    }
+
+    Slot& target = slot(sequence);
+    if (target.filled) {
+        ++m_statistics.duplicates;
+        return false;
+    }
+    target.filled = true;
+    target.sequence = sequence;
+    target.payload = payload;
+    ++m_statistics.received;
+    if (qint16(quint16(sequence - m_newest)) > 0) {
+        m_newest = sequence;
+    }
+    updateJitter(sequence, arrivalMs);
+    return true;
+}
+
+JitterBuffer::Frame JitterBuffer::pop()
+{
+    Frame frame;
+    if (!m_started) {
+        return frame;
+    }
+    if (m_buffering) {
+        if (depth() < m_targetDepth) {
+            return frame;
+        }
+        m_buffering = false;
+    }
+    if (depth() == 0) {
+        m_buffering = true;
+        ++m_statistics.underruns;
+        return frame;
+    }
+
+    // With anything waiting, the newest packet is at or after m_next
+    frame.sequence = m_next;
+    Slot& current = slot(m_next);
+    if (current.filled) {
+        frame.kind = Frame::Packet;
+        frame.payload = std::move(current.payload);
+        current = Slot();
+    } else {
+        frame.kind = Frame::Lost;
+        const Slot& following = slot(quint16(m_next + 1));
+        if (following.filled) {
+            frame.payload = following.payload;
+        }
+        ++m_statistics.lost;
+    }
+    ++m_next;
+    return frame;
+}
+
+int JitterBuffer::depth() const
+{
+    if (!m_started) {
+        return 0;
+    }
+    return qMax(0, int(qint16(quint16(m_newest - m_next))) + 1);
+}
+
+void JitterBuffer::reset()
+{
+    for (Slot& stale : m_slots) {
+        stale = Slot();
+    }
+    m_started = false;
+    m_buffering = true;
+    m_jitterMs = 0;
+    m_lastArrivalMs = -1;
+    updateTarget();
+}
+
+void JitterBuffer::updateJitter(quint16 sequence, qint64 arrivalMs)
+{
+    // RFC 3550 6.4.1, the send time of a packet being its sequence times
+    // the frame length
+    if (m_lastArrivalMs >= 0) {
+        const int frames = qint16(quint16(sequence - m_lastSequence));
+        const double difference = double(arrivalMs - m_lastArrivalMs) - frames * m_frameMs;
+        m_jitterMs += (std::abs(difference) - m_jitterMs) / 16.0;
+    }
+    m_lastSequence = sequence;
+    m_lastArrivalMs = arrivalMs;
+    updateTarget();
+}
+
+void JitterBuffer::updateTarget()
+{
+    const int coverMs = int(std::ceil(m_jitterMs * JITTER_MULTIPLIER));
+    const int delayMs = std::clamp(coverMs, m_minDelayMs, m_maxDelayMs);
+    m_targetDepth = qMax(1, (delayMs + m_frameMs - 1) / m_frameMs);
+}
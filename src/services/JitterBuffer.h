@@ -0,0 +1,127 @@
+#ifndef JITTERBUFFER_H
+#define JITTERBUFFER_H
+
+#include <QByteArray>
+#include <QtGlobal>
+#include <vector>
+
+/**
+ * @brief Reorders packets of a real-time stream and plays them out on time
+ *
+ * Packets come off the network late, out of order, twice or not at all.
+ * JitterBuffer keeps them by their 16 bit sequence number, which may wrap,
+ * and hands them out one frame at a time in order: a packet, a gap where
+ * one was lost, or nothing at all when the buffer ran dry.
+ *
+ * How deep it runs follows the network. The interarrival jitter is
+ * estimated the way RFC 3550 does, and the target depth is enough frames
+ * to cover JITTER_MULTIPLIER times it, kept between the minimum and
+ * maximum delays. After an underrun, and at the start, nothing is handed
+ * out until the target depth is reached again.
+ *
+ * A gap is only given up on when a later packet is waiting behind it; that
+ * packet's payload comes back with the gap, so a codec can recover the
+ * lost frame from what the next one carries.
+ *
+ * @example
+ * @code
+ * JitterBuffer buffer(20);
+ * buffer.push(sequence, payload, elapsed.elapsed());
+ * JitterBuffer::Frame frame = buffer.pop();
+ * if (frame.kind == JitterBuffer::Frame::Lost)
+ *     conceal(frame.payload);
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class JitterBuffer
+{
+public:
+    /// Packets kept at most, a window of sequence numbers
+    static constexpr int MAX_PACKETS = 256;
+    static constexpr int DEFAULT_MIN_DELAY_MS = 40;
+    static constexpr int DEFAULT_MAX_DELAY_MS = 400;
+    static constexpr double JITTER_MULTIPLIER = 3.0;
+
+    struct Frame {
+        enum Kind {
+            Packet,   ///< payload is the packet of this frame
+            Lost,     ///< The packet never came; payload is the next one's
+            Empty     ///< Nothing to play: buffering, or run dry
+        };
+        Kind kind = Empty;
+        quint16 sequence = 0;
+        QByteArray payload;
+    };
+
+    struct Statistics {
+        qint64 received = 0;
+        qint64 lost = 0;
+        qint64 late = 0;         ///< Arrived after their frame was played
+        qint64 duplicates = 0;
+        qint64 underruns = 0;
+    };
+
+    /**
+     * @param frameMs Length of the audio in each packet
+     */
+    explicit JitterBuffer(int frameMs = 20);
+
+    void setDelayRange(int minDelayMs, int maxDelayMs);
+    int minDelayMs() const { return m_minDelayMs; }
+    int maxDelayMs() const { return m_maxDelayMs; }
+
+    /**
+     * @brief Take a packet off the network
+     * @param arrivalMs When it arrived, on any clock that counts milliseconds
+     * @return false if it was late or a duplicate, and dropped
+     */
+    bool push(quint16 sequence, const QByteArray& payload, qint64 arrivalMs);
+
+    /**
+     * @brief The next frame to play, called once per frameMs
+     */
+    Frame pop();
+
+    /// Frames waiting, from the next one to play to the newest
+    int depth() const;
+    int targetDepth() const { return m_targetDepth; }
+    /// Interarrival jitter estimate
+    double jitterMs() const { return m_jitterMs; }
+    bool isBuffering() const { return m_buffering; }
+    const Statistics& statistics() const { return m_statistics; }
+
+    /**
+     * @brief Forget every packet, as for a new stream
+     *
+     * The statistics are kept.
+     */
+    void reset();
+
+private:
+    struct Slot {
+        bool filled = false;
+        quint16 sequence = 0;
+        QByteArray payload;
+    };
+
+    Slot& slot(quint16 sequence) { return m_slots[size_t(sequence % MAX_PACKETS)]; }
+    void updateJitter(quint16 sequence, qint64 arrivalMs);
+    void updateTarget();
+
+    int m_frameMs;
+    int m_minDelayMs = DEFAULT_MIN_DELAY_MS;
+    int m_maxDelayMs = DEFAULT_MAX_DELAY_MS;
+    std::vector<Slot> m_slots;
+    bool m_started = false;          ///< A packet came since the last reset
+    quint16 m_next = 0;              ///< Sequence of the next frame to play
+    quint16 m_newest = 0;
+    bool m_buffering = true;
+    int m_targetDepth = 1;
+    double m_jitterMs = 0;
+    quint16 m_lastSequence = 0;      ///< Of the last packet the jitter was updated with
+    qint64 m_lastArrivalMs = -1;
+    Statistics m_statistics;
+};
+
+#endif // JITTERBUFFER_H
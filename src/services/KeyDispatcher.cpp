@@ -0,0 +1,203 @@
+#include "KeyDispatcher.h"
+#include <QApplication>
+#include <QKeyEvent>
+#include <QWidget>
+
+namespace {
+
+constexpr int MODIFIER_MASK = int(Qt::ShiftModifier) | int(Qt::ControlModifier)
+                              | int(Qt::AltModifier) | int(Qt::MetaModifier);
+
+} // namespace
+
+KeyDispatcher* KeyDispatcher::instance()
+{
+    static QPointer<KeyDispatcher> dispatcher;
+    if (!dispatcher) {
+        dispatcher = new KeyDispatcher(QCoreApplication::instance());
+        if (QCoreApplication::instance()) {
+            QCoreApplication::instance()->installEventFilter(dispatcher);
+        }
+    }
+    return dispatcher;
+}
+
+KeyDispatcher::KeyDispatcher(QObject* parent)
+    : QObject(parent)
+{
+    if (QApplication* app = qobject_cast<QApplication*>(QCoreApplication::instance())) {
+        connect(app, &QApplication::focusChanged, this, [this]() { m_chainTarget.clear(); });
+    }
+}
+
+void KeyDispatcher::add(int key, Qt::KeyboardModifiers modifiers, const QString& context,
+                        QObject* owner, Handler handler)
+{
+    if (!owner || !handler) {
+        return;
+    }
+    watch(owner);
+    QList<Entry>& entries = m_bindings[binding(key, modifiers, context)];
+    entries.prepend(Entry{owner, std::move(handler)});
+}
+
+void KeyDispatcher::add(const QKeySequence& sequence, const QString& context, QObject* owner,
+                        Handler handler)
+{
+    if (sequence.isEmpty()) {
+        return;
+    }
+    const QKeyCombination combination = sequence[0];
+    add(combination.key(), combination.keyboardModifiers(), context, owner, std::move(handler));
+}
+
+void KeyDispatcher::remove(int key, Qt::KeyboardModifiers modifiers, const QString& context,
+                           QObject* owner)
+{
+    const auto it = m_bindings.find(binding(key, modifiers, context));
+    if (it == m_bindings.end()) {
+        return;
+    }
+    it->removeIf([owner](const Entry& entry) { return entry.owner == owner; });
+    if (it->isEmpty()) {
+        m_bindings.erase(it);
+    }
+}
+
+void KeyDispatcher::remove(const QKeySequence& sequence, const QString& context, QObject* owner)
+{
+    if (sequence.isEmpty()) {
+        return;
+    }
+    const QKeyCombination combination = sequence[0];
+    remove(combination.key(), combination.keyboardModifiers(), context, owner);
+}
+
+void KeyDispatcher::removeAll(QObject* owner)
+{
+    for (auto it = m_bindings.begin(); it != m_bindings.end();) {
+        it->removeIf([owner](const Entry& entry) { return entry.owner == owner; });
+        it = it->isEmpty() ? m_bindings.erase(it) : std::next(it);
+    }
+}
+
+void KeyDispatcher::setFocusContext(QWidget* widget, const QString& context)
+{
+    if (!widget) {
+        return;
+    }
+    if (context.isEmpty()) {
+        m_contexts.remove(widget);
+    } else {
+        watch(widget);
+        m_contexts.insert(widget, context);
+    }
+    m_chainTarget.clear();
+}
+
+QStringList KeyDispatcher::contextsFor(QWidget* widget) const
+{
+    if (widget && widget == m_chainTarget) {
+        return m_chain;
+    }
+
+    QStringList chain;
+    for (QWidget* current = widget; current; current = current->parentWidget()) {
+        const auto it = m_contexts.constFind(current);
+        if (it != m_contexts.constEnd() && !chain.contains(*it)) {
+            chain.append(*it);
+        }
+    }
+    chain.removeAll(QString::fromLatin1(GLOBAL));
+    chain.append(QString::fromLatin1(GLOBAL));
+
+    m_chainTarget = widget;
+    m_chain = chain;
+    return chain;
+}
+
+bool KeyDispatcher::dispatch(QWidget* target, QKeyEvent* event)
+{
+    if (!event || m_bindings.isEmpty()) {
+        return false;
+    }
+
+    const Qt::KeyboardModifiers modifiers = event->modifiers();
+    for (const QString& context : contextsFor(target)) {
+        if (run(binding(event->key(), modifiers, context), target, event)
+            || run(binding(ANY_KEY, Qt::NoModifier, context), target, event)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int KeyDispatcher::bindingCount() const
+{
+    int count = 0;
+    for (const QList<Entry>& entries : m_bindings) {
+        count += int(entries.size());
+    }
+    return count;
+}
+
+bool KeyDispatcher::eventFilter(QObject* watched, QEvent* event)
+{
+    if (event->type() != QEvent::KeyPress || !watched->isWidgetType()) {
+        return QObject::eventFilter(watched, event);
+    }
+
+    // A key the focus widget ignores is sent on to its parents; look it up only once
+    QWidget* widget = static_cast<QWidget*>(watched);
+    QWidget* focus = QApplication::focusWidget();
+    const bool target = focus ? widget == focus : widget->isWindow();
+    if (!target) {
+        return QObject::eventFilter(watched, event);
+    }
+    return dispatch(widget, static_cast<QKeyEvent*>(event));
+}
+
+KeyDispatcher::Binding KeyDispatcher::binding(int key, Qt::KeyboardModifiers modifiers,
+                                              const QString& context)
+{
+    int flags = key == ANY_KEY ? 0 : int(modifiers) & MODIFIER_MASK;
+    if (key == Qt::Key_Backtab) {
+        // Shift+Tab arrives as Backtab, with or without Shift
+        flags &= ~int(Qt::ShiftModifier);
+    }
+    return Binding{key, flags, context.isEmpty() ? QString::fromLatin1(GLOBAL) : context};
+}
+
+bool KeyDispatcher::run(const Binding& binding, QWidget* target, QKeyEvent* event)
+{
+    const auto it = m_bindings.constFind(binding);
+    if (it == m_bindings.constEnd()) {
+        return false;
+    }
+
+    // Handlers may bind or unbind keys while they run
+    const QList<Entry> entries = *it;
+    for (const Entry& entry : entries) {
+        if (entry.handler(target, event)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void KeyDispatcher::watch(QObject* object)
+{
+    if (m_watched.contains(object)) {
+        return;
+    }
+    m_watched.insert(object);
+    connect(object, &QObject::destroyed, this, [this](QObject* destroyed) { forget(destroyed); });
+}
+
+void KeyDispatcher::forget(QObject* object)
+{
+    m_watched.remove(object);
+    m_contexts.remove(object);
+    removeAll(object);
+    m_chainTarget.clear();
+}
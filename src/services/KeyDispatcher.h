@@ -0,0 +1,154 @@
+#ifndef KEYDISPATCHER_H
+#define KEYDISPATCHER_H
+
+#include <QHash>
+#include <QKeySequence>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QWidget>
+#include <functional>
+
+class QKeyEvent;
+
+/**
+ * @brief One table of key bindings for the whole application
+ *
+ * KeyboardNavigationController filtered every event of the application and
+ * then every event of each widget it navigated, and the table editing
+ * enhancer filtered each table again, each testing key combinations one
+ * after the other. Every keystroke went through all of them. The dispatcher
+ * is the one event filter left: bindings are hashed by key, modifiers and
+ * focus context, and a keystroke costs two lookups per context it is in,
+ * however many bindings there are.
+ *
+ * A widget is given a context with setFocusContext(); a keystroke goes to
+ * the contexts of the focus widget and of its parents, nearest first, then
+ * to GLOBAL. In each context the bindings of the key come first, then those
+ * of ANY_KEY. Bindings of one key and context are tried newest first, until
+ * a handler returns true; that consumes the key.
+ *
+ * Bindings belong to an owner and go when it is destroyed.
+ *
+ * @example
+ * @code
+ * KeyDispatcher* keys = KeyDispatcher::instance();
+ * keys->setFocusContext(tableView, "TableEditing");
+ * keys->add(Qt::Key_F2, Qt::NoModifier, "TableEditing", this,
+ *           [this](QWidget*, QKeyEvent*) { return enterEditMode(); });
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class KeyDispatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    /// Context every keystroke reaches last, whatever has the focus
+    static constexpr const char* GLOBAL = "Global";
+    /// Key of bindings that take any key of their context
+    static constexpr int ANY_KEY = 0;
+
+    /**
+     * @brief Called with the focus widget; true when it consumed the key
+     */
+    using Handler = std::function<bool(QWidget* target, QKeyEvent* event)>;
+
+    /**
+     * @brief The dispatcher of the application, made on first use and filtering its events
+     */
+    static KeyDispatcher* instance();
+
+    explicit KeyDispatcher(QObject* parent = nullptr);
+
+    /**
+     * @brief Bind a key in a context
+     * @param key Qt::Key, or ANY_KEY
+     * @param modifiers Shift, Control, Alt and Meta; ignored for ANY_KEY
+     * @param context Focus context, GLOBAL if empty
+     * @param owner Object the binding belongs to
+     * @param handler Called on the key
+     */
+    void add(int key, Qt::KeyboardModifiers modifiers, const QString& context, QObject* owner,
+             Handler handler);
+
+    /**
+     * @brief Bind the first key combination of a sequence in a context
+     */
+    void add(const QKeySequence& sequence, const QString& context, QObject* owner,
+             Handler handler);
+
+    /**
+     * @brief Remove the bindings of an owner for a key in a context
+     */
+    void remove(int key, Qt::KeyboardModifiers modifiers, const QString& context,
+                QObject* owner);
+    void remove(const QKeySequence& sequence, const QString& context, QObject* owner);
+
+    /**
+     * @brief Remove every binding of an owner
+     */
+    void removeAll(QObject* owner);
+
+    /**
+     * @brief Put a widget and its children in a focus context; an empty one takes it out
+     */
+    void setFocusContext(QWidget* widget, const QString& context);
+    QString focusContext(QWidget* widget) const { return m_contexts.value(widget); }
+
+    /**
+     * @brief Contexts a keystroke to a widget goes to, in order; GLOBAL last
+     */
+    QStringList contextsFor(QWidget* widget) const;
+
+    /**
+     * @brief Run the bindings for a key event to a widget
+     * @return true if a handler consumed it
+     */
+    bool dispatch(QWidget* target, QKeyEvent* event);
+
+    int bindingCount() const;
+
+protected:
+    bool eventFilter(QObject* watched, QEvent* event) override;
+
+private:
+    struct Binding {
+        int key;
+        int modifiers;
+        QString context;
+
+        bool operator==(const Binding& other) const
+        {
+            return key == other.key && modifiers == other.modifiers && context == other.context;
+        }
+    };
+    friend size_t qHash(const Binding& binding, size_t seed) noexcept
+    {
+        return qHashMulti(seed, binding.key, binding.modifiers, binding.context);
+    }
+
+    struct Entry {
+        QObject* owner;
+        Handler handler;
+    };
+
+    static Binding binding(int key, Qt::KeyboardModifiers modifiers, const QString& context);
+    bool run(const Binding& binding, QWidget* target, QKeyEvent* event);
+    void watch(QObject* object);
+    void forget(QObject* object);
+
+    QHash<Binding, QList<Entry>> m_bindings;
+    QHash<const QObject*, QString> m_contexts;
+    QSet<const QObject*> m_watched;
+
+    // Contexts of the last target, kept until the focus or a context changes
+    mutable QPointer<QWidget> m_chainTarget;
+    mutable QStringList m_chain;
+};
+
+#endif // KEYDISPATCHER_H
@@ -1,5 +1,6 @@
 #include "KeyboardNavigationController.h"
 #include "AccessibilityManager.h"
+#include "KeyDispatcher.h"
 #include "Logger.h"
 #include <QApplication>
 #include <QKeyEvent>
@@ -17,7 +18,7 @@ KeyboardNavigationController::KeyboardNavigationController(AccessibilityManager*
     , m_lastFocusedWidget(nullptr)
     , m_focusAnnouncementTimer(new QTimer(this))
     , m_initialized(false)
-    , m_eventFilterInstalled(false)
+    , m_navigationKeysBound(false)
 {
     if (!m_accessibilityManager) {
         logError("KeyboardNavigationController: AccessibilityManager is null");
@@ -57,11 +58,8 @@ bool KeyboardNavigationController::initialize()
         return false;
     }
     
-    // Install application-wide event filter
-    if (QApplication* app = qobject_cast<QApplication*>(QApplication::instance())) {
-        app->installEventFilter(this);
-        m_eventFilterInstalled = true;
-    }
+    // Bind the navigation keys in the application's key table
+    bindNavigationKeys();
     
     // Setup default keyboard shortcuts
     setupDefaultShortcuts();
@@ -79,13 +77,9 @@ void KeyboardNavigationController::shutdown()
     
     logDebug("Shutting down KeyboardNavigationController");
     
-    // Remove event filter
-    if (m_eventFilterInstalled) {
-        if (QApplication* app = qobject_cast<QApplication*>(QApplication::instance())) {
-            app->removeEventFilter(this);
-        }
-        m_eventFilterInstalled = false;
-    }
+    // Remove navigation keys and shortcuts from the key table
+    KeyDispatcher::instance()->removeAll(this);
+    m_navigationKeysBound = false;
     
     // Stop timers
     m_focusAnnouncementTimer->stop();
@@ -140,6 +134,16 @@ bool KeyboardNavigationController::registerKeyboardShortcut(const QString& actio
     m_shortcuts[action] = shortcut;
     m_sequenceToAction[sequence] = action;
     
+    // Sequences are unique across contexts, so they are all bound globally, as before
+    KeyDispatcher::instance()->add(sequence, KeyDispatcher::GLOBAL, this,
+                                   [this, action](QWidget*, QKeyEvent*) {
+        if (!m_initialized) {
+            return false;
+        }
+        executeShortcutAction(action);
+        return true;
+    });
+    
     logDebug(QString("Registered keyboard shortcut: %1 (%2) - %3")
              .arg(action)
              .arg(sequence.toString())
@@ -155,6 +159,7 @@ void KeyboardNavigationController::unregisterKeyboardShortcut(const QString& act
     }
     
     KeyboardShortcut shortcut = m_shortcuts[action];
+    KeyDispatcher::instance()->remove(shortcut.sequence, KeyDispatcher::GLOBAL, this);
     m_sequenceToAction.remove(shortcut.sequence);
     m_shortcuts.remove(action);
     
@@ -203,9 +208,6 @@ void KeyboardNavigationController::registerNavigationWidget(QWidget* widget,
     connect(widget, &QObject::destroyed,
             this, &KeyboardNavigationController::onWidgetDestroyed);
     
-    // Install event filter on widget
-    installEventFilterRecursively(widget);
-    
     logDebug(QString("Registered navigation widget: %1 (context: %2)")
              .arg(accessibleName)
              .arg(static_cast<int>(context)));
@@ -217,9 +219,6 @@ void KeyboardNavigationController::unregisterNavigationWidget(QWidget* widget)
         return;
     }
     
-    // Remove event filter
-    removeEventFilterRecursively(widget);
-    
     // Remove from data structures
     m_navigationWidgets.remove(widget);
     m_arrowKeyEnabled.remove(widget);
@@ -343,35 +342,6 @@ void KeyboardNavigationController::executeShortcutAction(const QString& action)
     }
 }
 
-bool KeyboardNavigationController::eventFilter(QObject* obj, QEvent* event)
-{
-    if (!m_initialized || event->type() != QEvent::KeyPress) {
-        return QObject::eventFilter(obj, event);
-    }
-    
-    QWidget* widget = qobject_cast<QWidget*>(obj);
-    if (!widget) {
-        return QObject::eventFilter(obj, event);
-    }
-    
-    QKeyEvent* keyEvent = static_cast<QKeyEvent*>(event);
-    
-    // Handle keyboard shortcuts first
-    QKeySequence sequence(keyEvent->key() | keyEvent->modifiers());
-    if (m_sequenceToAction.contains(sequence)) {
-        QString action = m_sequenceToAction[sequence];
-        executeShortcutAction(action);
-        return true; // Event handled
-    }
-    
-    // Handle navigation keys
-    if (handleKeyPress(widget, keyEvent)) {
-        return true; // Event handled
-    }
-    
-    return QObject::eventFilter(obj, event);
-}
-
 void KeyboardNavigationController::onWidgetDestroyed(QObject* obj)
 {
     QWidget* widget = static_cast<QWidget*>(obj);
@@ -609,32 +579,23 @@ bool KeyboardNavigationController::hasShortcutConflict(const QKeySequence& seque
     return false;
 }
 
-void KeyboardNavigationController::installEventFilterRecursively(QWidget* widget)
+void KeyboardNavigationController::bindNavigationKeys()
 {
-    if (!widget) {
+    if (m_navigationKeysBound) {
         return;
     }
     
-    widget->installEventFilter(this);
-    
-    // Install on child widgets
-    for (QWidget* child : widget->findChildren<QWidget*>()) {
-        child->installEventFilter(this);
-    }
-}
-
-void KeyboardNavigationController::removeEventFilterRecursively(QWidget* widget)
-{
-    if (!widget) {
-        return;
-    }
-    
-    widget->removeEventFilter(this);
-    
-    // Remove from child widgets
-    for (QWidget* child : widget->findChildren<QWidget*>()) {
-        child->removeEventFilter(this);
+    // Looked at for every widget, after whatever its focus context binds
+    const Qt::Key keys[] = {Qt::Key_Left, Qt::Key_Up, Qt::Key_Right, Qt::Key_Down,
+                            Qt::Key_Tab, Qt::Key_Backtab, Qt::Key_Return, Qt::Key_Enter,
+                            Qt::Key_Escape};
+    for (Qt::Key key : keys) {
+        KeyDispatcher::instance()->add(key, Qt::NoModifier, KeyDispatcher::GLOBAL, this,
+                                       [this](QWidget* widget, QKeyEvent* event) {
+            return m_initialized && widget && handleKeyPress(widget, event);
+        });
     }
+    m_navigationKeysBound = true;
 }
 
 void KeyboardNavigationController::setupDefaultShortcuts()
@@ -225,15 +225,6 @@ signals:
      */
     void gridNavigationChanged(QWidget* widget, int row, int column, const QString& itemText);
 
-protected:
-    /**
-     * @brief Event filter for handling keyboard events
-     * @param obj Object that received the event
-     * @param event Event to process
-     * @return true if event was handled
-     */
-    bool eventFilter(QObject* obj, QEvent* event) override;
-
 private slots:
     /**
      * @brief Handle widget destruction
@@ -296,16 +287,9 @@ private:
     bool hasShortcutConflict(const QKeySequence& sequence, const QString& excludeAction = QString()) const;
 
     /**
-     * @brief Install event filter on a widget and its children
-     * @param widget Widget to install filter on
-     */
-    void installEventFilterRecursively(QWidget* widget);
-
-    /**
-     * @brief Remove event filter from a widget and its children
-     * @param widget Widget to remove filter from
+     * @brief Bind arrows, Tab, Return and Escape in KeyDispatcher for handleKeyPress()
      */
-    void removeEventFilterRecursively(QWidget* widget);
+    void bindNavigationKeys();
 
     /**
      * @brief Setup default keyboard shortcuts
@@ -363,7 +347,7 @@ private:
     
     // State tracking
     bool m_initialized;
-    bool m_eventFilterInstalled;
+    bool m_navigationKeysBound;
     
     // Configuration constants
     static constexpr int FOCUS_ANNOUNCEMENT_DELAY_MS = 150;
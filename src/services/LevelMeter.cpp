@@ -0,0 +1,352 @@
+#include "LevelMeter.h"
+#include <QtGlobal>
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LEVELMETER_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define LEVELMETER_NEON
+#endif
+
+namespace {
+
+constexpr float UINT8_SCALE = 1.0f / 128.0f;
+constexpr float INT16_SCALE = 1.0f / 32768.0f;
+constexpr float INT32_SCALE = 1.0f / 2147483648.0f;
+
+/// Running totals of one buffer; squares are summed in double so long buffers stay exact
+struct Sums {
+    std::array<float, LevelMeter::MAX_CHANNELS> peak{};
+    std::array<double, LevelMeter::MAX_CHANNELS> sumSquares{};
+};
+
+int bytesPerSample(QAudioFormat::SampleFormat format)
+{
+    switch (format) {
+    case QAudioFormat::UInt8:
+        return 1;
+    case QAudioFormat::Int16:
+        return 2;
+    case QAudioFormat::Int32:
+    case QAudioFormat::Float:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+inline float normalized(quint8 sample) { return (int(sample) - 128) * UINT8_SCALE; }
+inline float normalized(qint16 sample) { return sample * INT16_SCALE; }
+inline float normalized(qint32 sample) { return float(sample) * INT32_SCALE; }
+inline float normalized(float sample) { return sample; }
+
+template <typename Sample>
+void accumulateScalar(const char* data, qint64 firstFrame, qint64 frames, int channels,
+                      int measured, Sums& sums)
+{
+    const Sample* samples = reinterpret_cast<const Sample*>(data);
+    for (qint64 frame = firstFrame; frame < frames; ++frame) {
+        const Sample* first = samples + frame * channels;
+        for (int channel = 0; channel < measured; ++channel) {
+            const float x = normalized(first[channel]);
+            sums.peak[channel] = std::max(sums.peak[channel], std::fabs(x));
+            sums.sumSquares[channel] += double(x) * x;
+        }
+    }
+}
+
+void accumulateScalar(const char* data, qint64 firstFrame, qint64 frames,
+                      QAudioFormat::SampleFormat format, int channels, int measured, Sums& sums)
+{
+    switch (format) {
+    case QAudioFormat::UInt8:
+        accumulateScalar<quint8>(data, firstFrame, frames, channels, measured, sums);
+        break;
+    case QAudioFormat::Int16:
+        accumulateScalar<qint16>(data, firstFrame, frames, channels, measured, sums);
+        break;
+    case QAudioFormat::Int32:
+        accumulateScalar<qint32>(data, firstFrame, frames, channels, measured, sums);
+        break;
+    case QAudioFormat::Float:
+        accumulateScalar<float>(data, firstFrame, frames, channels, measured, sums);
+        break;
+    default:
+        break;
+    }
+}
+
+LevelMeter::Levels toLevels(const Sums& sums, qint64 frames, int measured)
+{
+    LevelMeter::Levels levels;
+    if (frames <= 0) {
+        return levels;
+    }
+    levels.channels = measured;
+    for (int channel = 0; channel < measured; ++channel) {
+        levels.peak[channel] = sums.peak[channel];
+        levels.rms[channel] = float(std::sqrt(sums.sumSquares[channel] / double(frames)));
+    }
+    return levels;
+}
+
+#if defined(LEVELMETER_SSE2) || defined(LEVELMETER_NEON)
+
+#if defined(LEVELMETER_SSE2)
+using Vector = __m128;
+
+inline Vector vectorZero() { return _mm_setzero_ps(); }
+inline void vectorStore(float* out, Vector v) { _mm_storeu_ps(out, v); }
+
+inline Vector vectorAbsMax(Vector peak, Vector x)
+{
+    // Clearing the sign bit is the absolute value; a NaN sample keeps the old peak
+    return _mm_max_ps(_mm_andnot_ps(_mm_set1_ps(-0.0f), x), peak);
+}
+
+inline Vector vectorSquareAdd(Vector sum, Vector x) { return _mm_add_ps(sum, _mm_mul_ps(x, x)); }
+
+inline Vector vectorLoad(const float* samples) { return _mm_loadu_ps(samples); }
+
+inline Vector vectorLoad(const qint32* samples)
+{
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples));
+    return _mm_mul_ps(_mm_cvtepi32_ps(v), _mm_set1_ps(INT32_SCALE));
+}
+
+inline void vectorLoad(const qint16* samples, Vector* low, Vector* high)
+{
+    // Each sample goes to the top of a 32-bit lane and is shifted down with its sign
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples));
+    const __m128 scale = _mm_set1_ps(INT16_SCALE);
+    *low = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16)), scale);
+    *high = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16)), scale);
+}
+#else
+using Vector = float32x4_t;
+
+inline Vector vectorZero() { return vdupq_n_f32(0.0f); }
+inline void vectorStore(float* out, Vector v) { vst1q_f32(out, v); }
+inline Vector vectorAbsMax(Vector peak, Vector x) { return vmaxq_f32(peak, vabsq_f32(x)); }
+inline Vector vectorSquareAdd(Vector sum, Vector x) { return vmlaq_f32(sum, x, x); }
+inline Vector vectorLoad(const float* samples) { return vld1q_f32(samples); }
+
+inline Vector vectorLoad(const qint32* samples)
+{
+    return vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(samples)), INT32_SCALE);
+}
+
+inline void vectorLoad(const qint16* samples, Vector* low, Vector* high)
+{
+    const int16x8_t v = vld1q_s16(samples);
+    *low = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), INT16_SCALE);
+    *high = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), INT16_SCALE);
+}
+#endif
+
+constexpr int LANES = 4;
+
+// Float lanes lose precision past a few thousand squares; hand them to the
+// double totals this often
+constexpr int FOLD_INTERVAL = 1024;
+
+struct VectorSums {
+    Vector peak = vectorZero();
+    Vector sumSquares = vectorZero();
+
+    void add(Vector x)
+    {
+        peak = vectorAbsMax(peak, x);
+        sumSquares = vectorSquareAdd(sumSquares, x);
+    }
+
+    /// Lane i holds samples i, i + 4, ..., which all belong to channel i % channels
+    void fold(int channels, Sums& sums)
+    {
+        float peaks[LANES];
+        float squares[LANES];
+        vectorStore(peaks, peak);
+        vectorStore(squares, sumSquares);
+        for (int lane = 0; lane < LANES; ++lane) {
+            const int channel = lane % channels;
+            sums.peak[channel] = std::max(sums.peak[channel], peaks[lane]);
+            sums.sumSquares[channel] += squares[lane];
+        }
+        peak = vectorZero();
+        sumSquares = vectorZero();
+    }
+};
+
+inline int addVectors(VectorSums& sums, const float* samples)
+{
+    sums.add(vectorLoad(samples));
+    return 1;
+}
+
+inline int addVectors(VectorSums& sums, const qint32* samples)
+{
+    sums.add(vectorLoad(samples));
+    return 1;
+}
+
+inline int addVectors(VectorSums& sums, const qint16* samples)
+{
+    Vector low;
+    Vector high;
+    vectorLoad(samples, &low, &high);
+    sums.add(low);
+    sums.add(high);
+    return 2;
+}
+
+/// Returns the number of samples taken; the rest is less than a load
+template <typename Sample>
+qint64 accumulateVectors(const char* data, qint64 count, int channels, Sums& sums)
+{
+    constexpr int STEP = 16 / int(sizeof(Sample));
+    const Sample* samples = reinterpret_cast<const Sample*>(data);
+    const qint64 end = count - count % STEP;
+
+    VectorSums vectors;
+    int added = 0;
+    for (qint64 i = 0; i < end; i += STEP) {
+        added += addVectors(vectors, samples + i);
+        if (added >= FOLD_INTERVAL) {
+            vectors.fold(channels, sums);
+            added = 0;
+        }
+    }
+    vectors.fold(channels, sums);
+    return end;
+}
+
+#endif
+
+} // namespace
+
+float LevelMeter::Levels::maxPeak() const
+{
+    return channels > 0 ? *std::max_element(peak.cbegin(), peak.cbegin() + channels) : 0.0f;
+}
+
+float LevelMeter::Levels::maxRms() const
+{
+    return channels > 0 ? *std::max_element(rms.cbegin(), rms.cbegin() + channels) : 0.0f;
+}
+
+LevelMeter::LevelMeter(const QAudioFormat& format)
+    : m_sampleFormat(format.sampleFormat())
+    , m_channels(format.channelCount())
+{
+    reset();
+}
+
+LevelMeter::Levels LevelMeter::measure(const char* data, qint64 bytes,
+                                       QAudioFormat::SampleFormat format, int channels)
+{
+#if defined(LEVELMETER_SSE2) || defined(LEVELMETER_NEON)
+    // Whole frames fill a vector only when the channel count divides its lanes
+    const int sampleBytes = bytesPerSample(format);
+    if (channels > 0 && LANES % channels == 0 && sampleBytes > 1) {
+        const qint64 frames = bytes / sampleBytes / channels;
+        const qint64 count = frames * channels;
+        Sums sums;
+        qint64 done = 0;
+        switch (format) {
+        case QAudioFormat::Int16:
+            done = accumulateVectors<qint16>(data, count, channels, sums);
+            break;
+        case QAudioFormat::Int32:
+            done = accumulateVectors<qint32>(data, count, channels, sums);
+            break;
+        default:
+            done = accumulateVectors<float>(data, count, channels, sums);
+            break;
+        }
+        accumulateScalar(data, done / channels, frames, format, channels, channels, sums);
+        return toLevels(sums, frames, channels);
+    }
+#endif
+    return measureScalar(data, bytes, format, channels);
+}
+
+LevelMeter::Levels LevelMeter::measureScalar(const char* data, qint64 bytes,
+                                             QAudioFormat::SampleFormat format, int channels)
+{
+    const int sampleBytes = bytesPerSample(format);
+    if (channels <= 0 || sampleBytes == 0) {
+        return Levels();
+    }
+
+    const qint64 frames = bytes / sampleBytes / channels;
+    const int measured = qMin(channels, int(MAX_CHANNELS));
+    Sums sums;
+    accumulateScalar(data, 0, frames, format, channels, measured, sums);
+    return toLevels(sums, frames, measured);
+}
+
+void LevelMeter::process(const char* data, qint64 bytes)
+{
+    const Levels levels = measure(data, bytes, m_sampleFormat, m_channels);
+    if (levels.channels == 0) {
+        return;
+    }
+
+    for (int channel = 0; channel < levels.channels; ++channel) {
+        m_peak[channel].store(levels.peak[channel], std::memory_order_relaxed);
+        m_rms[channel].store(levels.rms[channel], std::memory_order_relaxed);
+    }
+
+    // Raise the held peak unless the reader has not taken a higher one yet
+    const float peak = levels.maxPeak();
+    float held = m_heldPeak.load(std::memory_order_relaxed);
+    while (peak > held &&
+           !m_heldPeak.compare_exchange_weak(held, peak, std::memory_order_relaxed)) {
+    }
+}
+
+float LevelMeter::peak(int channel) const
+{
+    return pick(m_peak, channel, channelCount());
+}
+
+float LevelMeter::rms(int channel) const
+{
+    return pick(m_rms, channel, channelCount());
+}
+
+float LevelMeter::takePeak()
+{
+    return m_heldPeak.exchange(0.0f, std::memory_order_relaxed);
+}
+
+void LevelMeter::reset()
+{
+    for (int channel = 0; channel < MAX_CHANNELS; ++channel) {
+        m_peak[channel].store(0.0f, std::memory_order_relaxed);
+        m_rms[channel].store(0.0f, std::memory_order_relaxed);
+    }
+    m_heldPeak.store(0.0f, std::memory_order_relaxed);
+}
+
+int LevelMeter::channelCount() const
+{
+    return qBound(0, m_channels, int(MAX_CHANNELS));
+}
+
+float LevelMeter::pick(const std::array<std::atomic<float>, MAX_CHANNELS>& levels, int channel,
+                       int channels)
+{
+    if (channel >= 0) {
+        return channel < channels ? levels[channel].load(std::memory_order_relaxed) : 0.0f;
+    }
+
+    float loudest = 0.0f;
+    for (int i = 0; i < channels; ++i) {
+        loudest = std::max(loudest, levels[i].load(std::memory_order_relaxed));
+    }
+    return loudest;
+}
@@ -0,0 +1,123 @@
+#ifndef LEVELMETER_H
+#define LEVELMETER_H
+
+#include <QAudioFormat>
+#include <array>
+#include <atomic>
+
+/**
+ * @brief Peak and RMS level of each channel of a PCM stream, for meters
+ *
+ * process() runs on the thread that receives the audio and measures each
+ * buffer in one pass. UInt8, Int16, Int32 and Float samples are
+ * normalised to -1..1, and the absolute peak and the root mean square of
+ * every channel are taken. With SSE2 on x86 or NEON on ARM four samples
+ * are handled per instruction, as long as the channels line up with the
+ * vector lanes (1, 2 or 4 channels); other layouts and UInt8 use the
+ * scalar loop.
+ *
+ * The results are published through lock-free atomics, so a meter widget
+ * reads them from a timer at its own frame rate and the audio thread
+ * never waits for a repaint. takePeak() returns the highest peak since
+ * the last call, so a transient between two frames still shows.
+ *
+ * @example
+ * @code
+ * LevelMeter meter(format);
+ * meter.process(data, len);            // audio thread
+ * bar->setLevel(meter.takePeak());     // GUI timer
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class LevelMeter
+{
+public:
+    static constexpr int MAX_CHANNELS = 8;
+
+    /**
+     * @brief Levels of one buffer, 0.0 to 1.0 for full scale
+     *
+     * Float samples beyond full scale give levels above 1.0.
+     */
+    struct Levels {
+        int channels = 0;   ///< Channels measured, at most MAX_CHANNELS
+        std::array<float, MAX_CHANNELS> peak{};
+        std::array<float, MAX_CHANNELS> rms{};
+
+        float maxPeak() const;
+        float maxRms() const;
+    };
+
+    /**
+     * @param format Format of the buffers that will be passed to process()
+     */
+    explicit LevelMeter(const QAudioFormat& format);
+
+    /**
+     * @brief Measure interleaved samples
+     * @param data Samples in native byte order
+     * @param bytes Size of the data; a partial frame at the end is ignored
+     * @param format Sample format
+     * @param channels Channels per frame; those beyond MAX_CHANNELS are skipped
+     * @return Levels of the data
+     */
+    static Levels measure(const char* data, qint64 bytes, QAudioFormat::SampleFormat format,
+                          int channels);
+
+    /**
+     * @brief Measure like measure(), one sample at a time
+     *
+     * The reference the vector code is checked against.
+     */
+    static Levels measureScalar(const char* data, qint64 bytes,
+                                QAudioFormat::SampleFormat format, int channels);
+
+    /**
+     * @brief Measure a buffer and publish its levels
+     *
+     * Does not allocate or lock, so it can run on the audio thread.
+     */
+    void process(const char* data, qint64 bytes);
+
+    /**
+     * @brief Get the peak of the last buffer
+     * @param channel Channel, or -1 for the loudest one
+     */
+    float peak(int channel = -1) const;
+
+    /**
+     * @brief Get the RMS level of the last buffer
+     * @param channel Channel, or -1 for the loudest one
+     */
+    float rms(int channel = -1) const;
+
+    /**
+     * @brief Get the highest peak since the last call, and start over
+     * @return Peak of the loudest channel, 0.0 if nothing was processed
+     */
+    float takePeak();
+
+    /**
+     * @brief Forget the levels, such as when the input stops
+     */
+    void reset();
+
+    /**
+     * @brief Get how many channels are measured
+     * @return Channels of the format, at most MAX_CHANNELS
+     */
+    int channelCount() const;
+
+private:
+    static float pick(const std::array<std::atomic<float>, MAX_CHANNELS>& levels, int channel,
+                      int channels);
+
+    const QAudioFormat::SampleFormat m_sampleFormat;
+    const int m_channels;   ///< Channels per frame of the format
+    std::array<std::atomic<float>, MAX_CHANNELS> m_peak{};
+    std::array<std::atomic<float>, MAX_CHANNELS> m_rms{};
+    std::atomic<float> m_heldPeak{0.0f};   ///< Highest peak since takePeak()
+};
+
+#endif // LEVELMETER_H
@@ -0,0 +1,424 @@
+#include "LibraryChecker.h"
+#include "BackgroundThrottle.h"
+#include "MediaProbe.h"
+#include <QDebug>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QThread>
+#include <QVariant>
+#include <QtConcurrent/QtConcurrent>
+#include <utility>
+
+LibraryChecker::LibraryChecker(QSqlDatabase& database, QObject* parent)
+    : QObject(parent)
+    , m_database(database)
+    , m_probe([](const QString& filePath, QString* error) {
+        const MediaProbe::ProbeResult result = MediaProbe::probe(filePath);
+        if (!result.isValid && error) {
+            *error = result.errorMessage;
+        }
+        return result.durationString();
+    })
+    , m_maxWorkers(qMax(1, QThread::idealThreadCount() * 2))
+{
+    m_pool.setThreadPriority(QThread::LowPriority);
+    m_pool.setMaxThreadCount(m_maxWorkers);
+}
+
+LibraryChecker::~LibraryChecker()
+{
+    // A check cut short by quitting carries on from here next time
+    if (m_running && m_database.isOpen()) {
+        flush();
+        saveCheckpoint();
+    }
+    m_queue.clear();
+    m_pool.waitForDone();
+}
+
+void LibraryChecker::setMaxWorkers(int workers)
+{
+    m_maxWorkers = qMax(1, workers);
+    m_pool.setMaxThreadCount(m_maxWorkers);
+    schedule();
+}
+
+bool LibraryChecker::start()
+{
+    if (m_running) {
+        return false;
+    }
+    if (!m_database.isOpen()) {
+        logError("start", "Database is not open");
+        return false;
+    }
+
+    clearCheckpoint();
+    m_report = Report();
+    return begin(0);
+}
+
+void LibraryChecker::pause()
+{
+    if (!m_running || m_paused) {
+        return;
+    }
+    m_paused = true;
+    qInfo() << "LibraryChecker: pausing after" << m_inFlight << "files being looked at";
+    if (m_inFlight == 0) {
+        settlePause();
+    }
+}
+
+bool LibraryChecker::resume()
+{
+    if (m_running) {
+        if (!m_paused) {
+            return false;
+        }
+        m_paused = false;
+        qInfo() << "LibraryChecker: resuming," << m_queue.size() << "records left";
+        schedule();
+        return true;
+    }
+    if (!m_database.isOpen() || !ensureStateTable()) {
+        return false;
+    }
+
+    QSqlQuery state(m_database);
+    if (!state.exec("SELECT next_rowid, total, checked, updated, write_errors, missing, empty, "
+                    "unreadable FROM library_check_state WHERE id = 1")) {
+        logError("resume", QString("SQL Error: %1").arg(state.lastError().text()),
+                 state.lastQuery());
+        return false;
+    }
+    if (!state.next()) {
+        return false;
+    }
+
+    Report report;
+    report.total = state.value(1).toInt();
+    report.checked = state.value(2).toInt();
+    report.updated = state.value(3).toInt();
+    report.writeErrors = state.value(4).toInt();
+    report.missing = state.value(5).toString().split('\n', Qt::SkipEmptyParts);
+    report.empty = state.value(6).toString().split('\n', Qt::SkipEmptyParts);
+    report.unreadable = state.value(7).toString().split('\n', Qt::SkipEmptyParts);
+    m_report = report;
+    return begin(state.value(0).toLongLong());
+}
+
+bool LibraryChecker::hasCheckpoint()
+{
+    if (!m_database.isOpen() || !ensureStateTable()) {
+        return false;
+    }
+    QSqlQuery state(m_database);
+    return state.exec("SELECT 1 FROM library_check_state WHERE id = 1") && state.next();
+}
+
+bool LibraryChecker::begin(qint64 fromRowid)
+{
+    QSqlQuery select(m_database);
+    select.setForwardOnly(true);
+    select.prepare("SELECT rowid, path, time FROM musics WHERE rowid >= ? ORDER BY rowid");
+    select.addBindValue(fromRowid);
+    if (!select.exec()) {
+        logError("begin", QString("SQL Error: %1").arg(select.lastError().text()),
+                 select.lastQuery());
+        m_report = Report();
+        return false;
+    }
+
+    m_queue.clear();
+    while (select.next()) {
+        m_queue.append({select.value(0).toLongLong(), select.value(1).toString(),
+                        select.value(2).toString()});
+    }
+
+    // Records added since a checkpoint was saved are counted in
+    m_report.total = qMax(m_report.total, m_report.checked + int(m_queue.size()));
+    m_running = true;
+    m_paused = false;
+    qInfo() << "LibraryChecker: checking" << m_queue.size() << "of" << m_report.total
+            << "records with" << m_maxWorkers << "workers";
+
+    if (m_queue.isEmpty()) {
+        finish();
+    } else {
+        schedule();
+    }
+    return true;
+}
+
+void LibraryChecker::cancel()
+{
+    if (!m_running) {
+        return;
+    }
+
+    m_queue.clear();
+    ++m_generation;
+    m_inFlight = 0;
+    m_inFlightRows.clear();
+    m_report.cancelled = true;
+    finish();
+}
+
+int LibraryChecker::removeRecords(const QStringList& filePaths)
+{
+    if (filePaths.isEmpty()) {
+        return 0;
+    }
+    if (!m_database.transaction()) {
+        logError("removeRecords",
+                 QString("Failed to start transaction: %1").arg(m_database.lastError().text()));
+        return -1;
+    }
+
+    QSqlQuery remove(m_database);
+    remove.prepare("DELETE FROM musics WHERE path = ?");
+    int removed = 0;
+    for (const QString& filePath : filePaths) {
+        remove.addBindValue(filePath);
+        if (!remove.exec()) {
+            logError("removeRecords", QString("SQL Error: %1").arg(remove.lastError().text()),
+                     remove.lastQuery());
+            m_database.rollback();
+            return -1;
+        }
+        removed += remove.numRowsAffected();
+    }
+
+    if (!m_database.commit()) {
+        logError("removeRecords",
+                 QString("Failed to commit: %1").arg(m_database.lastError().text()));
+        m_database.rollback();
+        return -1;
+    }
+    return removed;
+}
+
+void LibraryChecker::schedule()
+{
+    while (m_running && !m_paused && m_inFlight < m_maxWorkers && !m_queue.isEmpty()) {
+        const Record record = m_queue.takeFirst();
+        ++m_inFlight;
+        m_inFlightRows.insert(record.rowid);
+
+        auto* watcher = new QFutureWatcher<Outcome>(this);
+        const int generation = m_generation;
+        connect(watcher, &QFutureWatcher<Outcome>::finished, this, [this, watcher, generation]() {
+            onChecked(watcher->result(), generation);
+            watcher->deleteLater();
+        });
+        watcher->setFuture(QtConcurrent::run(&m_pool, [probe = m_probe, record]() {
+            BackgroundThrottle::lowerCurrentThread();
+            BackgroundThrottle::pace();
+            Outcome outcome;
+            outcome.record = record;
+            const QFileInfo info(record.path);
+            outcome.exists = info.isFile();
+            outcome.empty = outcome.exists && info.size() == 0;
+            if (outcome.exists && !outcome.empty) {
+                outcome.time = probe(record.path, &outcome.error);
+            }
+            return outcome;
+        }));
+    }
+}
+
+void LibraryChecker::onChecked(const Outcome& outcome, int generation)
+{
+    if (generation != m_generation) {
+        return;
+    }
+    --m_inFlight;
+    m_inFlightRows.erase(outcome.record.rowid);
+    ++m_report.checked;
+
+    const QString& path = outcome.record.path;
+    if (!outcome.exists) {
+        m_report.missing.append(path);
+        emit problemFound(path, Problem::Missing, QString());
+    } else if (outcome.empty) {
+        m_report.empty.append(path);
+        emit problemFound(path, Problem::Empty, QString());
+    } else if (outcome.time.isEmpty()) {
+        m_report.unreadable.append(path);
+        emit problemFound(path, Problem::Unreadable, outcome.error);
+    } else {
+        m_ready.append({outcome.record.rowid, path,
+                        outcome.time != outcome.record.time ? outcome.time : QString()});
+        if (m_ready.size() >= BATCH_SIZE) {
+            flush();
+            saveCheckpoint();
+        }
+    }
+    emit progressChanged(m_report.checked, m_report.total);
+
+    if (m_queue.isEmpty() && m_inFlight == 0) {
+        finish();
+    } else if (m_paused) {
+        if (m_inFlight == 0) {
+            settlePause();
+        }
+    } else {
+        schedule();
+    }
+}
+
+void LibraryChecker::flush()
+{
+    if (m_ready.isEmpty()) {
+        return;
+    }
+    const QList<Record> ready = std::exchange(m_ready, {});
+
+    if (!m_database.transaction()) {
+        logError("flush",
+                 QString("Failed to start transaction: %1").arg(m_database.lastError().text()));
+        m_report.writeErrors += ready.size();
+        return;
+    }
+
+    // An empty time means the stored one is right; the play count is reset either way
+    QSqlQuery updateTime(m_database);
+    updateTime.prepare("UPDATE musics SET time = ?, played_times = 0 WHERE path = ?");
+    QSqlQuery resetCount(m_database);
+    resetCount.prepare("UPDATE musics SET played_times = 0 WHERE path = ?");
+
+    int updated = 0;
+    for (const Record& record : ready) {
+        QSqlQuery& query = record.time.isEmpty() ? resetCount : updateTime;
+        if (!record.time.isEmpty()) {
+            query.addBindValue(record.time);
+        }
+        query.addBindValue(record.path);
+        if (!query.exec()) {
+            logError("flush", QString("SQL Error: %1").arg(query.lastError().text()),
+                     query.lastQuery());
+            m_database.rollback();
+            m_report.writeErrors += ready.size();
+            return;
+        }
+        if (!record.time.isEmpty()) {
+            ++updated;
+        }
+    }
+
+    if (!m_database.commit()) {
+        logError("flush", QString("Failed to commit: %1").arg(m_database.lastError().text()));
+        m_database.rollback();
+        m_report.writeErrors += ready.size();
+        return;
+    }
+    m_report.updated += updated;
+}
+
+void LibraryChecker::finish()
+{
+    flush();
+    clearCheckpoint();
+    m_running = false;
+    m_paused = false;
+    m_inFlightRows.clear();
+
+    // Records past a checkpoint may have been looked at twice
+    Report report = std::exchange(m_report, Report());
+    report.checked = qMin(report.checked, report.total);
+    report.missing.removeDuplicates();
+    report.empty.removeDuplicates();
+    report.unreadable.removeDuplicates();
+
+    qInfo() << "LibraryChecker: check finished," << report.checked << "of" << report.total
+            << "checked," << report.updated << "times updated," << report.missing.size()
+            << "missing," << report.empty.size() << "empty," << report.unreadable.size()
+            << "unreadable";
+    emit finished(report);
+}
+
+void LibraryChecker::settlePause()
+{
+    flush();
+    saveCheckpoint();
+    qInfo() << "LibraryChecker: paused," << m_report.checked << "of" << m_report.total
+            << "checked";
+    emit paused(m_report.checked, m_report.total);
+}
+
+bool LibraryChecker::ensureStateTable()
+{
+    QSqlQuery query(m_database);
+    const QString sql = "CREATE TABLE IF NOT EXISTS library_check_state ("
+                        "id INTEGER PRIMARY KEY CHECK (id = 1), "
+                        "next_rowid INTEGER NOT NULL, "
+                        "total INTEGER NOT NULL, "
+                        "checked INTEGER NOT NULL, "
+                        "updated INTEGER NOT NULL, "
+                        "write_errors INTEGER NOT NULL, "
+                        "missing TEXT, "
+                        "empty TEXT, "
+                        "unreadable TEXT)";
+    if (!query.exec(sql)) {
+        logError("ensureStateTable", QString("SQL Error: %1").arg(query.lastError().text()), sql);
+        return false;
+    }
+    return true;
+}
+
+void LibraryChecker::saveCheckpoint()
+{
+    // Every record before the first one not done has been written
+    qint64 next = -1;
+    if (!m_inFlightRows.empty()) {
+        next = *m_inFlightRows.begin();
+    }
+    if (!m_queue.isEmpty() && (next < 0 || m_queue.first().rowid < next)) {
+        next = m_queue.first().rowid;
+    }
+    if (next < 0 || !ensureStateTable()) {
+        return;
+    }
+
+    QSqlQuery save(m_database);
+    save.prepare("INSERT OR REPLACE INTO library_check_state (id, next_rowid, total, checked, "
+                 "updated, write_errors, missing, empty, unreadable) "
+                 "VALUES (1, ?, ?, ?, ?, ?, ?, ?, ?)");
+    save.addBindValue(next);
+    save.addBindValue(m_report.total);
+    save.addBindValue(m_report.checked);
+    save.addBindValue(m_report.updated);
+    save.addBindValue(m_report.writeErrors);
+    save.addBindValue(m_report.missing.join('\n'));
+    save.addBindValue(m_report.empty.join('\n'));
+    save.addBindValue(m_report.unreadable.join('\n'));
+    if (!save.exec()) {
+        logError("saveCheckpoint", QString("SQL Error: %1").arg(save.lastError().text()),
+                 save.lastQuery());
+    }
+}
+
+void LibraryChecker::clearCheckpoint()
+{
+    if (!m_database.isOpen() || !ensureStateTable()) {
+        return;
+    }
+    QSqlQuery clear(m_database);
+    if (!clear.exec("DELETE FROM library_check_state")) {
+        logError("clearCheckpoint", QString("SQL Error: %1").arg(clear.lastError().text()),
+                 clear.lastQuery());
+    }
+}
+
+void LibraryChecker::logError(const QString& operation, const QString& error, const QString& query)
+{
+    QString logMessage = QString("LibraryChecker::%1 - %2").arg(operation, error);
+    if (!query.isEmpty()) {
+        logMessage += QString(" (Query: %1)").arg(query);
+    }
+
+    qWarning() << logMessage;
+}
@@ -0,0 +1,215 @@
+#ifndef LIBRARYCHECKER_H
+#define LIBRARYCHECKER_H
+
+#include <QList>
+#include <QObject>
+#include <QSqlDatabase>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <functional>
+#include <set>
+
+/**
+ * @brief Checks every record of the musics table against its file, in parallel
+ *
+ * For each record, LibraryChecker looks at the file on its own
+ * low-priority thread pool, up to maxWorkers() files at a time. A file that
+ * is missing, empty or whose duration cannot be read is reported with
+ * problemFound() as soon as it is seen. For a readable file, the time
+ * column is set to the duration MediaProbe reads from its headers and the
+ * play count is reset. These writes are collected and made BATCH_SIZE
+ * records per transaction, so a large library costs a few hundred commits
+ * rather than one per track.
+ *
+ * Records are never removed during a check; the caller decides what to do
+ * with the problems in the Report and can pass them to removeRecords().
+ *
+ * Records are checked in rowid order, and each batch written also saves a
+ * checkpoint to the library_check_state table: the first record not yet
+ * done, with the Report so far. pause() lets the files being looked at
+ * finish and keeps the checkpoint; resume() carries on from it, in this
+ * run or after a restart, so a check stopped for the busy hours does not
+ * start over. The few records finished out of order past the checkpoint
+ * are looked at again. A check that finishes or is cancelled drops the
+ * checkpoint.
+ *
+ * @example
+ * @code
+ * LibraryChecker* checker = new LibraryChecker(db, this);
+ * connect(checker, &LibraryChecker::finished, this, [checker](const auto& report) {
+ *     if (!report.missing.isEmpty() && confirmRemoval(report.missing))
+ *         checker->removeRecords(report.missing);
+ * });
+ * checker->start();
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class LibraryChecker : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class Problem {
+        Missing,      ///< The file does not exist
+        Empty,        ///< The file has no bytes
+        Unreadable    ///< The file is there but its duration cannot be read
+    };
+
+    /**
+     * @brief Outcome of a check
+     */
+    struct Report {
+        int total = 0;            ///< Records in the table when the check started
+        int checked = 0;          ///< Records whose file was looked at
+        int updated = 0;          ///< Records whose time column changed
+        int writeErrors = 0;      ///< Records that could not be written
+        QStringList missing;      ///< Paths of records without a file
+        QStringList empty;        ///< Paths of records whose file is empty
+        QStringList unreadable;   ///< Paths of records whose duration cannot be read
+        bool cancelled = false;
+
+        int problems() const { return missing.size() + empty.size() + unreadable.size(); }
+    };
+
+    /// Runs on a pool thread; returns the duration as "H:MM:SS", empty if unreadable
+    using Prober = std::function<QString(const QString& filePath, QString* error)>;
+
+    static constexpr int BATCH_SIZE = 500;
+
+    explicit LibraryChecker(QSqlDatabase& database, QObject* parent = nullptr);
+    ~LibraryChecker() override;
+
+    /**
+     * @brief Set how many files are looked at once
+     * @param workers Worker count; twice the number of cores by default,
+     *        since the workers mostly wait for the disk
+     */
+    void setMaxWorkers(int workers);
+    int maxWorkers() const { return m_maxWorkers; }
+
+    void setProber(Prober prober) { m_probe = std::move(prober); }
+
+    /**
+     * @brief Start checking all records of the musics table, dropping any checkpoint
+     * @return false if a check is running or the table cannot be read
+     */
+    bool start();
+
+    /**
+     * @brief Stop after the files being looked at now, keeping a checkpoint
+     *
+     * paused() is emitted once they are done and written.
+     */
+    void pause();
+
+    /**
+     * @brief Carry on with a paused check, or from the checkpoint a past run left
+     * @return false if there is nothing to resume or the table cannot be read
+     */
+    bool resume();
+
+    bool isPaused() const { return m_paused; }
+
+    /**
+     * @brief Check whether a stopped check left a checkpoint to resume from
+     */
+    bool hasCheckpoint();
+
+    /**
+     * @brief Stop after the files being looked at now
+     *
+     * What was found so far is still written and reported.
+     */
+    void cancel();
+
+    bool isRunning() const { return m_running; }
+
+    /**
+     * @brief Get the number of records in the running check
+     */
+    int total() const { return m_report.total; }
+
+    /**
+     * @brief Remove records from the musics table in one transaction
+     * @param filePaths Paths as stored in the musics table
+     * @return Number of records removed, -1 if nothing could be written
+     */
+    int removeRecords(const QStringList& filePaths);
+
+signals:
+    /**
+     * @brief Emitted after each record
+     * @param done Records finished
+     * @param total Records in this check
+     */
+    void progressChanged(int done, int total);
+
+    /**
+     * @brief Emitted as soon as a file with a problem is seen
+     * @param filePath Path as stored in the musics table
+     * @param problem What is wrong with it
+     * @param detail Why the duration could not be read, for Problem::Unreadable
+     */
+    void problemFound(const QString& filePath, LibraryChecker::Problem problem,
+                      const QString& detail);
+
+    /**
+     * @brief Emitted once a check asked to pause has written what it found
+     * @param done Records finished
+     * @param total Records in this check
+     */
+    void paused(int done, int total);
+
+    /**
+     * @brief Emitted when the last record is done, or after cancel()
+     * @param report What was found and written
+     */
+    void finished(const LibraryChecker::Report& report);
+
+private:
+    struct Record {
+        qint64 rowid = 0;
+        QString path;
+        QString time;
+    };
+
+    struct Outcome {
+        Record record;
+        bool exists = false;
+        bool empty = false;
+        QString time;
+        QString error;
+    };
+
+    bool begin(qint64 fromRowid);
+    void schedule();
+    void onChecked(const Outcome& outcome, int generation);
+    void flush();
+    void finish();
+    void settlePause();
+    bool ensureStateTable();
+    void saveCheckpoint();
+    void clearCheckpoint();
+    void logError(const QString& operation, const QString& error, const QString& query = QString());
+
+    QSqlDatabase& m_database;
+    QThreadPool m_pool;
+    Prober m_probe;
+    int m_maxWorkers;
+
+    QList<Record> m_queue;
+    QList<Record> m_ready;   ///< Readable files not yet written, with their new time
+    Report m_report;
+    bool m_running = false;
+    bool m_paused = false;
+    int m_inFlight = 0;
+    std::set<qint64> m_inFlightRows;   ///< Rowids being looked at, for the checkpoint
+    int m_generation = 0;   ///< Bumped by cancel() so late results are dropped
+};
+
+Q_DECLARE_METATYPE(LibraryChecker::Problem)
+Q_DECLARE_METATYPE(LibraryChecker::Report)
+
+#endif // LIBRARYCHECKER_H
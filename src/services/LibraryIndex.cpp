@@ -0,0 +1,280 @@
+#include "LibraryIndex.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSet>
+#include <QTextStream>
+#include <utility>
+
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#endif
+
+LibraryIndex::LibraryIndex(const QString& indexFile)
+    : m_indexFile(indexFile)
+{
+}
+
+QString LibraryIndex::fileNameFor(const QString& root)
+{
+    const QByteArray hash = QCryptographicHash::hash(QDir::cleanPath(root).toUtf8(),
+                                                     QCryptographicHash::Sha1)
+                                .toHex()
+                                .left(16);
+    return QString("library-%1.index").arg(QString::fromLatin1(hash));
+}
+
+bool LibraryIndex::load()
+{
+    m_files.clear();
+    m_modified = false;
+
+    QFile file(m_indexFile);
+    if (!file.exists()) {
+        return true;
+    }
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        logError("load", QString("Cannot read %1: %2").arg(m_indexFile, file.errorString()));
+        return false;
+    }
+
+    // "<size>\t<mtime>\t<inode>\t<path>" lines
+    QTextStream in(&file);
+    while (!in.atEnd()) {
+        const QString line = in.readLine();
+        const QStringList fields = line.split('\t');
+        if (fields.size() < 4) {
+            continue;
+        }
+        bool sizeOk = false;
+        bool timeOk = false;
+        bool inodeOk = false;
+        FileState state;
+        state.size = fields.at(0).toLongLong(&sizeOk);
+        state.mtimeMs = fields.at(1).toLongLong(&timeOk);
+        state.inode = fields.at(2).toULongLong(&inodeOk);
+        if (sizeOk && timeOk && inodeOk) {
+            // A tab in a file name survives the split
+            m_files.insert(fields.mid(3).join('\t'), state);
+        }
+    }
+    return true;
+}
+
+bool LibraryIndex::save()
+{
+    if (!m_modified) {
+        return true;
+    }
+
+    QDir().mkpath(QFileInfo(m_indexFile).absolutePath());
+    QSaveFile file(m_indexFile);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        logError("save", QString("Cannot write %1: %2").arg(m_indexFile, file.errorString()));
+        return false;
+    }
+
+    QTextStream out(&file);
+    for (auto it = m_files.cbegin(); it != m_files.cend(); ++it) {
+        const FileState& state = it.value();
+        out << state.size << '\t' << state.mtimeMs << '\t' << state.inode << '\t' << it.key()
+            << '\n';
+    }
+    out.flush();
+
+    if (!file.commit()) {
+        logError("save", QString("Cannot write %1: %2").arg(m_indexFile, file.errorString()));
+        return false;
+    }
+    m_modified = false;
+    return true;
+}
+
+LibraryIndex::States LibraryIndex::walk(const QString& root, const QStringList& nameFilters,
+                                        const std::atomic_bool* cancelled)
+{
+    States states;
+    QDirIterator it(QDir::cleanPath(root), nameFilters, QDir::Files | QDir::NoDotAndDotDot,
+                    QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        if (cancelled && cancelled->load()) {
+            break;
+        }
+        const QString path = it.next();
+        const FileState state = stat(path);
+        if (state.size >= 0) {
+            states.insert(path, state);
+        }
+    }
+    return states;
+}
+
+LibraryIndex::FileState LibraryIndex::stat(const QString& filePath)
+{
+    FileState state;
+#ifdef Q_OS_UNIX
+    // One stat() gives all three; QFileInfo has no inode
+    struct ::stat info;
+    if (::stat(QFile::encodeName(filePath).constData(), &info) == 0 && S_ISREG(info.st_mode)) {
+        state.size = qint64(info.st_size);
+#if defined(Q_OS_DARWIN)
+        state.mtimeMs =
+            qint64(info.st_mtimespec.tv_sec) * 1000 + info.st_mtimespec.tv_nsec / 1000000;
+#else
+        state.mtimeMs = qint64(info.st_mtim.tv_sec) * 1000 + info.st_mtim.tv_nsec / 1000000;
+#endif
+        state.inode = quint64(info.st_ino);
+    }
+#else
+    const QFileInfo info(filePath);
+    if (info.isFile()) {
+        state.size = info.size();
+        state.mtimeMs = info.lastModified().toMSecsSinceEpoch();
+    }
+#endif
+    return state;
+}
+
+LibraryIndex::Diff LibraryIndex::compare(const States& known, const States& current)
+{
+    Diff diff;
+    for (auto it = current.cbegin(); it != current.cend(); ++it) {
+        const auto indexed = known.constFind(it.key());
+        if (indexed == known.cend()) {
+            diff.added.append(it.key());
+        } else if (indexed.value() != it.value()) {
+            diff.changed.append(it.key());
+        } else {
+            ++diff.unchanged;
+        }
+    }
+    for (auto it = known.cbegin(); it != known.cend(); ++it) {
+        if (!current.contains(it.key())) {
+            diff.removed.append(it.key());
+        }
+    }
+
+    // A file that vanished and one that appeared with its inode and size were moved
+    QHash<std::pair<quint64, qint64>, QString> addedByInode;
+    for (const QString& path : std::as_const(diff.added)) {
+        const FileState& state = current.value(path);
+        if (state.inode != 0) {
+            addedByInode.insert({state.inode, state.size}, path);
+        }
+    }
+    if (addedByInode.isEmpty()) {
+        return diff;
+    }
+
+    QStringList removed;
+    QSet<QString> movedTo;
+    for (const QString& path : std::as_const(diff.removed)) {
+        const FileState& state = known.value(path);
+        const QString moved =
+            state.inode != 0 ? addedByInode.take({state.inode, state.size}) : QString();
+        if (moved.isEmpty()) {
+            removed.append(path);
+        } else {
+            diff.renamed.insert(path, moved);
+            movedTo.insert(moved);
+        }
+    }
+    diff.removed = removed;
+    if (!movedTo.isEmpty()) {
+        diff.added.removeIf([&movedTo](const QString& path) { return movedTo.contains(path); });
+    }
+    return diff;
+}
+
+void LibraryIndex::scanDirectory(const QString& directory, const QStringList& nameFilters,
+                                 States* known, States* current) const
+{
+    const QString cleaned = QDir::cleanPath(directory);
+    const QDir dir(cleaned);
+    const QStringList names = dir.entryList(nameFilters, QDir::Files);
+    for (const QString& name : names) {
+        const QString path = dir.filePath(name);
+        const FileState state = stat(path);
+        if (state.size >= 0) {
+            current->insert(path, state);
+        }
+    }
+
+    // Indexed files directly in the directory, and the subdirectories the index knows
+    const States under = filesUnder(cleaned);
+    QHash<QString, States> bySubdirectory;
+    for (auto it = under.cbegin(); it != under.cend(); ++it) {
+        const int slash = it.key().indexOf('/', cleaned.size() + 1);
+        if (slash < 0) {
+            known->insert(it.key(), it.value());
+        } else {
+            bySubdirectory[it.key().left(slash)].insert(it.key(), it.value());
+        }
+    }
+
+    // A deleted folder takes its files with it
+    for (auto it = bySubdirectory.cbegin(); it != bySubdirectory.cend(); ++it) {
+        if (!QFileInfo(it.key()).isDir()) {
+            known->insert(it.value());
+        }
+    }
+
+    // A folder dropped in brings files the index has never seen
+    const QStringList subdirectories = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString& name : subdirectories) {
+        const QString path = dir.filePath(name);
+        if (!bySubdirectory.contains(path)) {
+            current->insert(walk(path, nameFilters));
+        }
+    }
+}
+
+LibraryIndex::States LibraryIndex::filesUnder(const QString& directory) const
+{
+    const QString prefix = QDir::cleanPath(directory) + '/';
+    States states;
+    for (auto it = m_files.cbegin(); it != m_files.cend(); ++it) {
+        if (it.key().startsWith(prefix)) {
+            states.insert(it.key(), it.value());
+        }
+    }
+    return states;
+}
+
+void LibraryIndex::insert(const QString& filePath, const FileState& state)
+{
+    auto it = m_files.find(filePath);
+    if (it == m_files.end()) {
+        m_files.insert(filePath, state);
+    } else if (it.value() != state) {
+        it.value() = state;
+    } else {
+        return;
+    }
+    m_modified = true;
+}
+
+void LibraryIndex::remove(const QString& filePath)
+{
+    if (m_files.remove(filePath) > 0) {
+        m_modified = true;
+    }
+}
+
+void LibraryIndex::clear()
+{
+    if (!m_files.isEmpty()) {
+        m_files.clear();
+        m_modified = true;
+    }
+}
+
+void LibraryIndex::logError(const QString& operation, const QString& error) const
+{
+    qWarning() << QString("LibraryIndex::%1 - %2").arg(operation, error);
+}
@@ -0,0 +1,185 @@
+#ifndef LIBRARYINDEX_H
+#define LIBRARYINDEX_H
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <atomic>
+
+/**
+ * @brief Persistent record of the size, modification time and inode of every file under a root
+ *
+ * Re-importing a music folder reads every file again to find the few that
+ * changed. LibraryIndex remembers what each file looked like when it was
+ * last taken into the library. walk() stats the files under the root, and
+ * diff() sorts them into files that are new, changed or gone, and files
+ * that were only moved: a file that disappeared and one that appeared with
+ * the same inode and size. Nothing but the stats is read, so an archive
+ * where nothing changed costs one directory walk.
+ *
+ * Entries are only updated through insert() and remove(), once the change
+ * has reached the database, so a rescan that fails half way offers the rest
+ * again next time. The index is kept in a small text file; nothing is
+ * written unless it changed.
+ *
+ * @example
+ * @code
+ * LibraryIndex index(indexDir + "/" + LibraryIndex::fileNameFor(root));
+ * index.load();
+ * const LibraryIndex::States current = LibraryIndex::walk(root, {"*.mp3", "*.ogg"});
+ * const LibraryIndex::Diff diff = index.diff(current);
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class LibraryIndex
+{
+public:
+    /**
+     * @brief What a file looked like when it was indexed
+     */
+    struct FileState {
+        qint64 size = -1;
+        qint64 mtimeMs = -1;
+        quint64 inode = 0;              ///< 0 where the platform reports none
+
+        bool operator==(const FileState& other) const
+        {
+            return size == other.size && mtimeMs == other.mtimeMs && inode == other.inode;
+        }
+        bool operator!=(const FileState& other) const { return !(*this == other); }
+    };
+
+    /// File states by absolute path
+    using States = QHash<QString, FileState>;
+
+    /**
+     * @brief Difference between the index and the files on disk
+     */
+    struct Diff {
+        QStringList added;                  ///< Files the index does not know
+        QStringList changed;                ///< Files whose size, time or inode moved
+        QStringList removed;                ///< Indexed files that are gone
+        QHash<QString, QString> renamed;    ///< New path for each moved file
+        int unchanged = 0;
+
+        bool isEmpty() const
+        {
+            return added.isEmpty() && changed.isEmpty() && removed.isEmpty() &&
+                   renamed.isEmpty();
+        }
+    };
+
+    /**
+     * @param indexFile Where the index is stored
+     */
+    explicit LibraryIndex(const QString& indexFile);
+
+    /**
+     * @brief Get the index file name for a root directory
+     * @param root Root directory
+     * @return File name derived from a hash of the root's path
+     */
+    static QString fileNameFor(const QString& root);
+
+    QString indexFile() const { return m_indexFile; }
+
+    /**
+     * @brief Read the index file, replacing what is in memory
+     * @return false if the file exists but cannot be read; a missing file is an empty index
+     */
+    bool load();
+
+    /**
+     * @brief Write the index file if it changed
+     * @return true on success or when there was nothing to write
+     */
+    bool save();
+
+    bool isModified() const { return m_modified; }
+
+    /**
+     * @brief Stat the files under a directory tree
+     * @param root Root directory
+     * @param nameFilters Wildcard patterns of the files to consider
+     * @param cancelled Set from another thread to stop the walk early
+     * @return State of every matching file
+     */
+    static States walk(const QString& root, const QStringList& nameFilters,
+                       const std::atomic_bool* cancelled = nullptr);
+
+    /**
+     * @brief Stat one file
+     * @param filePath Path of the file
+     * @return Its state, with size -1 if it does not exist
+     */
+    static FileState stat(const QString& filePath);
+
+    /**
+     * @brief Compare the index with the result of walk()
+     * @param current Files on disk now
+     * @return What changed since the files were indexed
+     */
+    Diff diff(const States& current) const { return compare(m_files, current); }
+
+    /**
+     * @brief Compare two sets of file states
+     * @param known States as indexed
+     * @param current States on disk now
+     * @return What changed from known to current
+     */
+    static Diff compare(const States& known, const States& current);
+
+    /**
+     * @brief Collect the indexed and current states of one directory
+     *
+     * Files directly in the directory are stated. Subdirectories are only
+     * looked into when the index knows nothing under them (a folder that was
+     * dropped in) or they are gone from disk (a folder that was deleted);
+     * the others are expected to be reported on their own. Call it for
+     * each changed directory of a root, then compare() the two sets, so a
+     * file moved between them is still seen as moved.
+     * @param directory Directory that changed
+     * @param nameFilters Wildcard patterns of the files to consider
+     * @param known Receives the indexed states under the directory
+     * @param current Receives the states on disk
+     */
+    void scanDirectory(const QString& directory, const QStringList& nameFilters, States* known,
+                       States* current) const;
+
+    /**
+     * @brief Get the indexed files under a directory, at any depth
+     * @param directory Directory
+     * @return Their states
+     */
+    States filesUnder(const QString& directory) const;
+
+    /**
+     * @brief Record the state a file had when it was taken into the library
+     */
+    void insert(const QString& filePath, const FileState& state);
+
+    /**
+     * @brief Forget a file
+     */
+    void remove(const QString& filePath);
+
+    bool contains(const QString& filePath) const { return m_files.contains(filePath); }
+    FileState state(const QString& filePath) const { return m_files.value(filePath); }
+    const States& files() const { return m_files; }
+    int fileCount() const { return m_files.size(); }
+
+    /**
+     * @brief Forget everything, so the next diff reports every file as added
+     */
+    void clear();
+
+private:
+    void logError(const QString& operation, const QString& error) const;
+
+    QString m_indexFile;
+    States m_files;
+    bool m_modified = false;
+};
+
+#endif // LIBRARYINDEX_H
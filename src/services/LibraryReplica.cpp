@@ -0,0 +1,173 @@
+#include "LibraryReplica.h"
+#include "../repositories/LibraryChangeLog.h"
+#include <QDebug>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QTimer>
+#include <QUrlQuery>
+
+LibraryReplica::LibraryReplica(const QSqlDatabase& database, QObject* parent)
+    : QObject(parent)
+    , m_database(database)
+    , m_network(new QNetworkAccessManager(this))
+    , m_timer(new QTimer(this))
+{
+    m_timer->setSingleShot(true);
+    connect(m_timer, &QTimer::timeout, this, &LibraryReplica::poll);
+}
+
+LibraryReplica::~LibraryReplica()
+{
+    stop();
+}
+
+void LibraryReplica::setSource(const QUrl& baseUrl, const QString& token)
+{
+    m_baseUrl = baseUrl;
+    m_token = token;
+}
+
+void LibraryReplica::setPathMapping(const QString& from, const QString& to)
+{
+    m_pathFrom = from;
+    m_pathTo = to;
+}
+
+void LibraryReplica::start()
+{
+    if (!m_baseUrl.isValid() || m_baseUrl.isEmpty()) {
+        fail("start", "No primary to replicate set");
+        return;
+    }
+    if (!LibraryChangeLog(m_database).ensureCursors()) {
+        fail("start", "Cannot create the sync cursor table");
+        return;
+    }
+    m_running = true;
+    m_backoffMs = 0;
+    schedule(0);
+}
+
+void LibraryReplica::stop()
+{
+    m_running = false;
+    m_timer->stop();
+    if (m_reply) {
+        QNetworkReply* reply = m_reply;
+        m_reply = nullptr;
+        reply->abort();
+        reply->deleteLater();
+    }
+}
+
+qint64 LibraryReplica::cursor() const
+{
+    return LibraryChangeLog(m_database).cursor(sourceName());
+}
+
+QString LibraryReplica::sourceName() const
+{
+    return m_baseUrl.toString(QUrl::RemoveUserInfo | QUrl::StripTrailingSlash);
+}
+
+void LibraryReplica::schedule(int delayMs)
+{
+    if (m_running) {
+        m_timer->start(delayMs);
+    }
+}
+
+void LibraryReplica::poll()
+{
+    if (!m_running || m_reply) {
+        return;
+    }
+
+    QUrl base(m_baseUrl);
+    base.setPath(base.path() + (base.path().endsWith('/') ? "" : "/") + "api/" + QUERY_NAME);
+
+    QUrlQuery query;
+    query.addQueryItem("since", QString::number(cursor()));
+    query.addQueryItem("limit", QString::number(LibraryChangeLog::DEFAULT_BATCH));
+    base.setQuery(query);
+
+    QNetworkRequest request(base);
+    request.setTransferTimeout(REQUEST_TIMEOUT_MS);
+    if (!m_token.isEmpty()) {
+        request.setRawHeader("Authorization", "Bearer " + m_token.toUtf8());
+    }
+
+    m_reply = m_network->get(request);
+    connect(m_reply, &QNetworkReply::finished, this, [this, reply = m_reply]() {
+        onReply(reply);
+    });
+}
+
+void LibraryReplica::onReply(QNetworkReply* reply)
+{
+    reply->deleteLater();
+    if (reply != m_reply) {
+        return;
+    }
+    m_reply = nullptr;
+
+    if (reply->error() != QNetworkReply::NoError) {
+        fail("poll", reply->errorString());
+        return;
+    }
+
+    QJsonParseError parseError;
+    const QJsonDocument document = QJsonDocument::fromJson(reply->readAll(), &parseError);
+    const QJsonObject answer = document.object();
+    const QJsonObject delta = answer.value("value").toObject();
+    if (parseError.error != QJsonParseError::NoError || !answer.value("ok").toBool()) {
+        fail("poll", answer.value("error").toString("Not a library change feed"));
+        return;
+    }
+    if (delta.contains("error")) {
+        fail("poll", delta.value("error").toString());
+        return;
+    }
+
+    LibraryChangeLog log(m_database);
+    const QString source = sourceName();
+    QString appliedLog;
+    const qint64 applied = log.cursor(source, &appliedLog);
+    const QString deltaLog = delta.value("log").toString();
+    const qint64 latest = delta.value("latest").toVariant().toLongLong();
+
+    // A recreated log numbers its changes from the start again
+    if ((applied > 0 && appliedLog != deltaLog) || latest < applied) {
+        qWarning() << "LibraryReplica: the change log of" << source
+                   << "was recreated, replicating it again from the start";
+        log.resetCursor(source, deltaLog);
+        schedule(0);
+        return;
+    }
+
+    const int rows = log.applyChanges(source, delta, m_pathFrom, m_pathTo);
+    if (rows < 0) {
+        fail("apply", QString("Cannot apply the changes %1 to %2 of %3")
+                          .arg(delta.value("from").toVariant().toString(),
+                               delta.value("to").toVariant().toString(), source));
+        return;
+    }
+
+    m_backoffMs = 0;
+    if (rows > 0) {
+        emit changesApplied(rows);
+    }
+    schedule(delta.value("more").toBool() ? 0 : POLL_INTERVAL_MS);
+}
+
+void LibraryReplica::fail(const QString& operation, const QString& error)
+{
+    qWarning() << QString("LibraryReplica::%1 - %2").arg(operation, error);
+    emit operationError(operation, error);
+
+    m_backoffMs = m_backoffMs == 0 ? POLL_INTERVAL_MS : qMin(m_backoffMs * 2, MAX_BACKOFF_MS);
+    schedule(m_backoffMs);
+}
@@ -0,0 +1,116 @@
+#ifndef LIBRARYREPLICA_H
+#define LIBRARYREPLICA_H
+
+#include <QObject>
+#include <QSqlDatabase>
+#include <QString>
+#include <QUrl>
+
+class QNetworkAccessManager;
+class QNetworkReply;
+class QTimer;
+
+/**
+ * @brief Keeps a studio's library a replica of another studio's
+ *
+ * The primary studio serves its LibraryChangeLog as the "library.changes"
+ * query of its remote API (RemoteControlServer). LibraryReplica polls it
+ * every POLL_INTERVAL_MS for the changes after the cursor it has applied,
+ * and applies each batch with LibraryChangeLog::applyChanges(). A batch
+ * that leaves more behind is followed by the next at once, so a new
+ * replica catches up at full speed and then only fetches the few rows that
+ * changed, and new tracks show up on every studio within seconds.
+ *
+ * Paths on the primary may be mounted elsewhere on the replica; a prefix
+ * set with setPathMapping() is replaced in every path applied.
+ *
+ * A failed request is retried with a doubling delay up to MAX_BACKOFF_MS.
+ * When the primary's log was recreated, the replica starts from 0 again;
+ * rows deleted meanwhile on the primary are then kept.
+ *
+ * @example
+ * @code
+ * LibraryReplica* replica = new LibraryReplica(database, this);
+ * replica->setSource(QUrl("http://studio-a:9106"), token);
+ * connect(replica, &LibraryReplica::changesApplied, this, &player::update_music_table);
+ * replica->start();
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class LibraryReplica : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr const char* QUERY_NAME = "library.changes";
+    static constexpr int POLL_INTERVAL_MS = 5 * 1000;
+    static constexpr int MAX_BACKOFF_MS = 5 * 60 * 1000;
+    static constexpr int REQUEST_TIMEOUT_MS = 30 * 1000;
+
+    explicit LibraryReplica(const QSqlDatabase& database, QObject* parent = nullptr);
+    ~LibraryReplica() override;
+
+    /**
+     * @brief Set the primary to follow
+     * @param baseUrl Address of the primary's remote API, such as http://studio-a:9106
+     * @param token RemoteToken of the primary, empty if it has none
+     */
+    void setSource(const QUrl& baseUrl, const QString& token = QString());
+
+    /**
+     * @brief Replace a path prefix of the primary with one of this studio
+     */
+    void setPathMapping(const QString& from, const QString& to);
+
+    /**
+     * @brief Start polling, with a request right away
+     */
+    void start();
+
+    /**
+     * @brief Stop polling; a request in flight is abandoned
+     */
+    void stop();
+
+    bool isRunning() const { return m_running; }
+
+    /**
+     * @brief Sequence number of the primary applied last
+     */
+    qint64 cursor() const;
+
+signals:
+    /**
+     * @brief Emitted after a batch changed the library
+     * @param rows Rows inserted, updated or deleted
+     */
+    void changesApplied(int rows);
+
+    /**
+     * @brief Emitted when a request or applying its batch failed
+     * @param operation Name of the operation
+     * @param error Error message
+     */
+    void operationError(const QString& operation, const QString& error);
+
+private:
+    void poll();
+    void onReply(QNetworkReply* reply);
+    void schedule(int delayMs);
+    void fail(const QString& operation, const QString& error);
+    QString sourceName() const;
+
+    QSqlDatabase m_database;
+    QNetworkAccessManager* m_network;
+    QTimer* m_timer;
+    QNetworkReply* m_reply = nullptr;
+    QUrl m_baseUrl;
+    QString m_token;
+    QString m_pathFrom;
+    QString m_pathTo;
+    int m_backoffMs = 0;
+    bool m_running = false;
+};
+
+#endif // LIBRARYREPLICA_H
@@ -0,0 +1,410 @@
+#include "LibraryRescanner.h"
+#include "BackgroundThrottle.h"
+#include "../repositories/MusicRepository.h"
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QSet>
+#include <QStandardPaths>
+#include <QThread>
+#include <QTimer>
+#include <QtConcurrent/QtConcurrent>
+#include <utility>
+
+LibraryRescanner::LibraryRescanner(MusicRepository* repository, QObject* parent)
+    : QObject(parent)
+    , m_repository(repository)
+    , m_tagSource([](const QString& filePath, QString* error) {
+        return TagReader::read(filePath, error);
+    })
+    , m_nameFilters({"*.mp3", "*.ogg", "*.opus", "*.wav", "*.flac", "*.m4a", "*.aac", "*.wma"})
+    , m_indexDirectory(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation))
+    , m_maxWorkers(qMax(1, QThread::idealThreadCount() * 2))
+    , m_cancelled(std::make_shared<std::atomic_bool>(false))
+{
+    m_pool.setThreadPriority(QThread::LowPriority);
+    m_pool.setMaxThreadCount(m_maxWorkers);
+}
+
+LibraryRescanner::~LibraryRescanner()
+{
+    *m_cancelled = true;
+    m_queue.clear();
+    m_pool.waitForDone();
+}
+
+void LibraryRescanner::setRoots(const QStringList& roots)
+{
+    m_roots.clear();
+    for (const QString& root : roots) {
+        const QString cleaned = QDir::cleanPath(root);
+        if (!root.isEmpty() && !m_roots.contains(cleaned)) {
+            m_roots.append(cleaned);
+        }
+    }
+}
+
+void LibraryRescanner::setIndexDirectory(const QString& directory)
+{
+    if (directory != m_indexDirectory) {
+        m_indexDirectory = directory;
+        m_indexCache.clear();
+    }
+}
+
+void LibraryRescanner::setMaxWorkers(int workers)
+{
+    m_maxWorkers = qMax(1, workers);
+    m_pool.setMaxThreadCount(m_maxWorkers);
+    schedule();
+}
+
+bool LibraryRescanner::start()
+{
+    if (m_running || m_roots.isEmpty() || !m_repository) {
+        return false;
+    }
+
+    // A full rescan covers whatever directories were waiting
+    m_pending.clear();
+    QHash<QString, QStringList> scopes;
+    for (const QString& root : std::as_const(m_roots)) {
+        scopes.insert(root, QStringList());
+    }
+    run(scopes);
+    return true;
+}
+
+bool LibraryRescanner::rescanDirectories(const QStringList& directories)
+{
+    if (!m_repository) {
+        return false;
+    }
+
+    bool accepted = false;
+    for (const QString& directory : directories) {
+        const QString cleaned = QDir::cleanPath(directory);
+        const QString root = rootOf(cleaned);
+        if (root.isEmpty()) {
+            continue;
+        }
+        QStringList& pending = m_pending[root];
+        if (!pending.contains(cleaned)) {
+            pending.append(cleaned);
+        }
+        accepted = true;
+    }
+
+    // Directories that change during a rescan wait for the next one
+    if (accepted && !m_running) {
+        run(std::exchange(m_pending, {}));
+    }
+    return accepted;
+}
+
+void LibraryRescanner::cancel()
+{
+    if (!m_running) {
+        return;
+    }
+
+    // Walks still running keep their copy of the flag, and of the index they read
+    *m_cancelled = true;
+    m_indexCache.clear();
+    m_queue.clear();
+    m_pending.clear();
+    ++m_generation;
+    m_inFlight = 0;
+    m_walksLeft = 0;
+    m_report.cancelled = true;
+    finish();
+}
+
+void LibraryRescanner::run(const QHash<QString, QStringList>& scopes)
+{
+    m_queue.clear();
+    m_ready.clear();
+    m_indexes.clear();
+    m_report = Report();
+    m_cancelled = std::make_shared<std::atomic_bool>(false);
+    m_walksLeft = scopes.size();
+    m_toRead = 0;
+    m_read = 0;
+    m_running = true;
+    m_elapsed.start();
+
+    const int generation = m_generation;
+    for (auto it = scopes.cbegin(); it != scopes.cend(); ++it) {
+        const QString& root = it.key();
+        const QStringList& directories = it.value();
+        if (directories.isEmpty()) {
+            qInfo() << "LibraryRescanner: rescanning" << root << "with" << m_maxWorkers
+                    << "workers";
+        }
+
+        // Indexes stay loaded between rescans; only the first one reads the file
+        std::shared_ptr<LibraryIndex>& cached = m_indexCache[root];
+        const bool load = !cached;
+        if (!cached) {
+            cached = std::make_shared<LibraryIndex>(
+                QDir(m_indexDirectory).filePath(LibraryIndex::fileNameFor(root)));
+        }
+
+        auto* watcher = new QFutureWatcher<Plan>(this);
+        connect(watcher, &QFutureWatcher<Plan>::finished, this, [this, watcher, generation]() {
+            onWalked(watcher->result(), generation);
+            watcher->deleteLater();
+        });
+        watcher->setFuture(QtConcurrent::run(&m_pool, [root, directories, load, index = cached,
+                                                       filters = m_nameFilters,
+                                                       cancelled = m_cancelled]() {
+            BackgroundThrottle::lowerCurrentThread();
+            Plan plan;
+            plan.root = root;
+            plan.index = index;
+            if (load) {
+                index->load();
+            }
+
+            // An unmounted share leaves a missing or empty mount point
+            const bool rootMissing = !QFileInfo(root).isDir();
+            if (directories.isEmpty()) {
+                if (!rootMissing) {
+                    plan.current = LibraryIndex::walk(root, filters, cancelled.get());
+                }
+                plan.unmounted = rootMissing || (plan.current.isEmpty() && index->fileCount() > 0);
+                plan.diff = index->diff(plan.current);
+                return plan;
+            }
+
+            plan.unmounted = rootMissing || (QDir(root).isEmpty() && index->fileCount() > 0);
+            if (plan.unmounted) {
+                return plan;
+            }
+            LibraryIndex::States known;
+            for (const QString& directory : directories) {
+                BackgroundThrottle::pace(cancelled.get());
+                if (cancelled->load()) {
+                    break;
+                }
+                index->scanDirectory(directory, filters, &known, &plan.current);
+            }
+            plan.diff = LibraryIndex::compare(known, plan.current);
+            return plan;
+        }));
+    }
+}
+
+QString LibraryRescanner::rootOf(const QString& directory) const
+{
+    for (const QString& root : m_roots) {
+        if (directory == root || directory.startsWith(root + '/')) {
+            return root;
+        }
+    }
+    return QString();
+}
+
+void LibraryRescanner::onWalked(const Plan& plan, int generation)
+{
+    if (generation != m_generation) {
+        return;
+    }
+    --m_walksLeft;
+    applyPlan(plan);
+
+    if (m_walksLeft == 0 && m_queue.isEmpty() && m_inFlight == 0) {
+        finish();
+    } else {
+        schedule();
+    }
+}
+
+void LibraryRescanner::applyPlan(const Plan& plan)
+{
+    m_indexes.append(plan.index);
+    LibraryIndex& index = *plan.index;
+    const LibraryIndex::Diff& diff = plan.diff;
+
+    // Left alone rather than emptied: its files did not go away, the share did
+    if (plan.unmounted) {
+        qWarning() << QString("LibraryRescanner::applyPlan - Skipping %1: the folder is missing "
+                              "or empty, as if it were not mounted")
+                          .arg(plan.root);
+        ++m_report.skippedRoots;
+        return;
+    }
+    ++m_report.roots;
+    m_report.files += plan.current.size();
+    m_report.unchanged += diff.unchanged;
+
+    if (!diff.renamed.isEmpty()) {
+        m_report.renamed += m_repository->renameMusicBatch(diff.renamed);
+        for (auto it = diff.renamed.cbegin(); it != diff.renamed.cend(); ++it) {
+            index.remove(it.key());
+            index.insert(it.value(), plan.current.value(it.value()));
+        }
+    }
+
+    if (!diff.removed.isEmpty()) {
+        m_report.removed += m_repository->removeMusicBatch(diff.removed);
+        for (const QString& path : diff.removed) {
+            index.remove(path);
+        }
+    }
+
+    // Files imported before the root was indexed only need their state recorded, and a
+    // changed file whose track was deleted in XFB comes back as a new one
+    const QSet<QString> known = m_repository->existingPaths(diff.added + diff.changed);
+    const int queued = m_queue.size();
+    for (const QString& path : diff.added) {
+        if (known.contains(path)) {
+            index.insert(path, plan.current.value(path));
+            ++m_report.unchanged;
+        } else {
+            m_queue.append({path, plan.current.value(path), plan.index, true});
+        }
+    }
+    for (const QString& path : diff.changed) {
+        m_queue.append({path, plan.current.value(path), plan.index, !known.contains(path)});
+    }
+    m_toRead += m_queue.size() - queued;
+}
+
+void LibraryRescanner::schedule()
+{
+    while (m_running && m_inFlight < m_maxWorkers && !m_queue.isEmpty()) {
+        const Job job = m_queue.takeFirst();
+        ++m_inFlight;
+
+        auto* watcher = new QFutureWatcher<Outcome>(this);
+        const int generation = m_generation;
+        connect(watcher, &QFutureWatcher<Outcome>::finished, this, [this, watcher, generation]() {
+            onRead(watcher->result(), generation);
+            watcher->deleteLater();
+        });
+        watcher->setFuture(QtConcurrent::run(&m_pool, [source = m_tagSource, job]() {
+            BackgroundThrottle::lowerCurrentThread();
+            BackgroundThrottle::pace();
+            Outcome outcome;
+            outcome.job = job;
+            outcome.tags = source(job.path, &outcome.error);
+            return outcome;
+        }));
+    }
+}
+
+void LibraryRescanner::onRead(const Outcome& outcome, int generation)
+{
+    if (generation != m_generation) {
+        return;
+    }
+    --m_inFlight;
+    ++m_read;
+
+    if (!outcome.error.isEmpty()) {
+        qWarning() << QString("LibraryRescanner::onRead - Cannot read %1: %2")
+                          .arg(outcome.job.path, outcome.error);
+        ++m_report.failed;
+    } else {
+        m_ready.append(outcome);
+        if (m_ready.size() >= BATCH_SIZE) {
+            flush();
+        }
+    }
+    emit progressChanged(m_read, m_toRead);
+
+    if (m_walksLeft == 0 && m_queue.isEmpty() && m_inFlight == 0) {
+        finish();
+    } else {
+        schedule();
+    }
+}
+
+void LibraryRescanner::flush()
+{
+    if (m_ready.isEmpty()) {
+        return;
+    }
+    const QList<Outcome> ready = std::exchange(m_ready, {});
+
+    QList<MusicItem> added;
+    QList<MusicItem> refreshed;
+    QList<const Job*> addedJobs;
+    QList<const Job*> refreshedJobs;
+    for (const Outcome& outcome : ready) {
+        if (outcome.job.isNew) {
+            added.append(MusicRepository::itemFromTags(outcome.job.path, outcome.tags));
+            addedJobs.append(&outcome.job);
+        } else {
+            // Empty fields keep what is stored, so edits made in XFB survive
+            MusicItem item;
+            item.path = outcome.job.path;
+            item.artist = outcome.tags.artist;
+            item.song = outcome.tags.title;
+            item.genre1 = outcome.tags.genre;
+            item.publishedDate = outcome.tags.year;
+            item.time = outcome.tags.durationString();
+            refreshed.append(item);
+            refreshedJobs.append(&outcome.job);
+        }
+    }
+
+    if (!added.isEmpty()) {
+        m_report.added += m_repository->addMusicBatch(added);
+
+        // Copies of tracks already in the library are not stored; they and any
+        // failed writes stay out of the index and are offered again next time
+        QStringList paths;
+        paths.reserve(addedJobs.size());
+        for (const Job* job : std::as_const(addedJobs)) {
+            paths.append(job->path);
+        }
+        const QSet<QString> stored = m_repository->existingPaths(paths);
+        for (const Job* job : std::as_const(addedJobs)) {
+            if (stored.contains(job->path)) {
+                job->index->insert(job->path, job->state);
+            }
+        }
+    }
+
+    if (!refreshed.isEmpty()) {
+        const int updated = m_repository->refreshMusicBatch(refreshed);
+        m_report.updated += updated;
+
+        // A partial write cannot tell which tracks made it; refreshing again is harmless
+        if (updated == refreshed.size()) {
+            for (const Job* job : std::as_const(refreshedJobs)) {
+                job->index->insert(job->path, job->state);
+            }
+        }
+    }
+}
+
+void LibraryRescanner::finish()
+{
+    flush();
+    for (const std::shared_ptr<LibraryIndex>& index : std::as_const(m_indexes)) {
+        index->save();
+    }
+    m_indexes.clear();
+    m_running = false;
+
+    Report report = std::exchange(m_report, Report());
+    report.elapsedMs = m_elapsed.elapsed();
+
+    qInfo() << "LibraryRescanner: rescan finished in" << report.elapsedMs << "ms," << report.files
+            << "files," << report.added << "added," << report.updated << "updated,"
+            << report.renamed << "moved," << report.removed << "removed," << report.failed
+            << "unreadable," << report.skippedRoots << "roots skipped";
+    emit finished(report);
+
+    if (!m_pending.isEmpty()) {
+        QTimer::singleShot(0, this, [this]() {
+            if (!m_running && !m_pending.isEmpty()) {
+                run(std::exchange(m_pending, {}));
+            }
+        });
+    }
+}
@@ -0,0 +1,212 @@
+#ifndef LIBRARYRESCANNER_H
+#define LIBRARYRESCANNER_H
+
+#include "LibraryIndex.h"
+#include "TagReader.h"
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+class MusicRepository;
+
+/**
+ * @brief Brings the library in line with the music folders, reading only files that changed
+ *
+ * For each library root, LibraryRescanner walks the tree on a pool thread
+ * and compares it with the root's LibraryIndex. Files the index already
+ * knows unchanged are not opened at all. Then, against the repository:
+ *
+ * - Moved files (same inode and size under a new path) get their new path,
+ *   keeping their play history.
+ * - Files that are gone have their tracks removed.
+ * - New files are read with TagReader and added. New files whose path is
+ *   already in the library, because they were imported before the root
+ *   was indexed, are only taken into the index.
+ * - Changed files are read again and their tracks refreshed.
+ *
+ * Reads run on a low-priority pool, up to maxWorkers() files at a time, and
+ * the results are written BATCH_SIZE tracks per call. A file is only
+ * recorded in the index once its track is written, so an interrupted
+ * rescan carries on where it stopped.
+ *
+ * A root that is missing, or that comes back empty while its index is not,
+ * is skipped rather than emptied; that is what an unmounted share looks
+ * like.
+ *
+ * @example
+ * @code
+ * LibraryRescanner* rescanner = new LibraryRescanner(musicRepository, this);
+ * rescanner->setRoots({musicPath});
+ * connect(rescanner, &LibraryRescanner::finished, this, [](const auto& report) {
+ *     qInfo() << report.added << "added," << report.removed << "removed";
+ * });
+ * rescanner->start();
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class LibraryRescanner : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Outcome of a rescan
+     */
+    struct Report {
+        int roots = 0;          ///< Roots walked
+        int skippedRoots = 0;   ///< Roots left alone because they looked unmounted
+        int files = 0;          ///< Files found under the roots
+        int unchanged = 0;      ///< Files that needed no work
+        int added = 0;          ///< Tracks added
+        int updated = 0;        ///< Tracks refreshed from a changed file
+        int renamed = 0;        ///< Tracks moved to a new path
+        int removed = 0;        ///< Tracks whose file is gone
+        int failed = 0;         ///< Files that could not be read; offered again next time
+        bool cancelled = false;
+        qint64 elapsedMs = 0;
+
+        int changes() const { return added + updated + renamed + removed; }
+    };
+
+    /// Runs on a pool thread; reads the tags and duration of a file
+    using TagSource = std::function<TagReader::Tags(const QString& filePath, QString* error)>;
+
+    static constexpr int BATCH_SIZE = 500;
+
+    explicit LibraryRescanner(MusicRepository* repository, QObject* parent = nullptr);
+    ~LibraryRescanner() override;
+
+    void setRoots(const QStringList& roots);
+    QStringList roots() const { return m_roots; }
+
+    /**
+     * @brief Choose which files belong to the library
+     * @param filters Wildcard patterns; the audio formats XFB plays by default
+     */
+    void setNameFilters(const QStringList& filters) { m_nameFilters = filters; }
+    QStringList nameFilters() const { return m_nameFilters; }
+
+    /**
+     * @brief Set where the root indexes are kept
+     * @param directory Directory; the application data directory by default
+     */
+    void setIndexDirectory(const QString& directory);
+    QString indexDirectory() const { return m_indexDirectory; }
+
+    /**
+     * @brief Set how many files are read at once
+     * @param workers Worker count; twice the number of cores by default
+     */
+    void setMaxWorkers(int workers);
+    int maxWorkers() const { return m_maxWorkers; }
+
+    void setTagSource(TagSource source) { m_tagSource = std::move(source); }
+
+    /**
+     * @brief Start rescanning all roots
+     * @return false if a rescan is running or there are no roots
+     */
+    bool start();
+
+    /**
+     * @brief Rescan only some directories of the roots
+     *
+     * For directories reported by LibraryWatcher: files directly in each
+     * directory are compared with the index, and subdirectories only when
+     * they are new or gone, so a change costs a few stats rather than a
+     * walk of the root. During a rescan the directories wait for the next
+     * one, which starts when this one finishes.
+     * @param directories Changed directories; those outside the roots are ignored
+     * @return false if none of them is under a root
+     */
+    bool rescanDirectories(const QStringList& directories);
+
+    /**
+     * @brief Stop after the files being read now
+     *
+     * What was read so far is still written and indexed.
+     */
+    void cancel();
+
+    bool isRunning() const { return m_running; }
+
+signals:
+    /**
+     * @brief Emitted while files are read
+     * @param done Files read
+     * @param total Files to read in this rescan
+     */
+    void progressChanged(int done, int total);
+
+    /**
+     * @brief Emitted when the last file is written, or after cancel()
+     * @param report What changed
+     */
+    void finished(const LibraryRescanner::Report& report);
+
+private:
+    struct Plan {
+        QString root;
+        std::shared_ptr<LibraryIndex> index;
+        LibraryIndex::States current;
+        LibraryIndex::Diff diff;
+        bool unmounted = false;
+    };
+
+    struct Job {
+        QString path;
+        LibraryIndex::FileState state;
+        std::shared_ptr<LibraryIndex> index;
+        bool isNew = false;
+    };
+
+    struct Outcome {
+        Job job;
+        TagReader::Tags tags;
+        QString error;
+    };
+
+    void run(const QHash<QString, QStringList>& scopes);
+    QString rootOf(const QString& directory) const;
+    void onWalked(const Plan& plan, int generation);
+    void applyPlan(const Plan& plan);
+    void schedule();
+    void onRead(const Outcome& outcome, int generation);
+    void flush();
+    void finish();
+
+    MusicRepository* m_repository;
+    QThreadPool m_pool;
+    TagSource m_tagSource;
+    QStringList m_roots;
+    QStringList m_nameFilters;
+    QString m_indexDirectory;
+    int m_maxWorkers;
+
+    QHash<QString, std::shared_ptr<LibraryIndex>> m_indexCache;   ///< Loaded indexes by root
+    QList<std::shared_ptr<LibraryIndex>> m_indexes;   ///< Indexes of this rescan, saved at the end
+    QHash<QString, QStringList> m_pending;   ///< Directories by root, for the next rescan
+    QList<Job> m_queue;
+    QList<Outcome> m_ready;   ///< Files read but not yet written
+    Report m_report;
+    QElapsedTimer m_elapsed;
+    std::shared_ptr<std::atomic_bool> m_cancelled;   ///< Set by cancel(); one per rescan
+    bool m_running = false;
+    int m_walksLeft = 0;
+    int m_toRead = 0;
+    int m_read = 0;
+    int m_inFlight = 0;
+    int m_generation = 0;   ///< Bumped by cancel() so late results are dropped
+};
+
+Q_DECLARE_METATYPE(LibraryRescanner::Report)
+
+#endif // LIBRARYRESCANNER_H
@@ -0,0 +1,210 @@
+#include "LibrarySnapshot.h"
+#include <QDebug>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QUuid>
+#include <QVariant>
+#include <QtConcurrent/QtConcurrentRun>
+#include <algorithm>
+
+LibrarySnapshot::Ptr LibrarySnapshot::fromRows(QVector<Row> rows)
+{
+    std::sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) { return a.id < b.id; });
+
+    auto snapshot = std::make_shared<LibrarySnapshot>();
+    LibrarySnapshot& s = *snapshot;
+    s.m_ids.reserve(rows.size());
+    s.m_durationsUs.reserve(rows.size());
+    s.m_genreIds.reserve(rows.size());
+    s.m_artistIds.reserve(rows.size());
+    s.m_directoryIds.reserve(rows.size());
+    s.m_fileNames.reserve(rows.size());
+    s.m_songs.reserve(rows.size());
+    s.m_rowsByPathHash.reserve(rows.size());
+    QHash<QString, int> directoryIds;
+
+    for (const Row& row : std::as_const(rows)) {
+        if (row.path.isEmpty()) {
+            continue;
+        }
+        const int index = s.m_ids.size();
+        const int genre = intern(row.genre, s.m_genres, s.m_genreIdByKey);
+        s.m_ids.append(row.id);
+        s.m_durationsUs.append(row.durationUs);
+        s.m_genreIds.append(genre);
+        s.m_artistIds.append(intern(row.artist, s.m_artists, s.m_artistIdByKey));
+        const qsizetype split = row.path.lastIndexOf('/') + 1;
+        const QString directory = row.path.left(split);
+        auto directoryId = directoryIds.constFind(directory);
+        if (directoryId == directoryIds.cend()) {
+            s.m_directories.append(directory);
+            directoryId = directoryIds.insert(directory, s.m_directories.size() - 1);
+        }
+        s.m_directoryIds.append(*directoryId);
+        s.m_fileNames.append(row.path.mid(split));
+        s.m_songs.append(row.song);
+        s.m_rowsByPathHash.insert(qHash(row.path), index);
+        if (genre != NONE) {
+            if (genre == s.m_rowsByGenre.size()) {
+                s.m_rowsByGenre.append(QVector<int>());
+            }
+            s.m_rowsByGenre[genre].append(index);
+        }
+    }
+    return snapshot;
+}
+
+LibrarySnapshot::Ptr LibrarySnapshot::load(const QSqlDatabase& database, QString* error)
+{
+    QSqlQuery query(database);
+    query.setForwardOnly(true);
+    if (!query.exec("SELECT id, path, artist, song, genre1, time FROM musics")) {
+        qWarning() << QString("LibrarySnapshot::load - SQL Error: %1 (Query: %2)")
+                          .arg(query.lastError().text(), query.lastQuery());
+        if (error) {
+            *error = query.lastError().text();
+        }
+        return nullptr;
+    }
+
+    QVector<Row> rows;
+    while (query.next()) {
+        Row row;
+        row.id = query.value(0).toInt();
+        row.path = query.value(1).toString();
+        row.artist = query.value(2).toString();
+        row.song = query.value(3).toString();
+        row.genre = query.value(4).toString();
+        row.durationUs = parseDuration(query.value(5).toString());
+        rows.append(row);
+    }
+    return fromRows(std::move(rows));
+}
+
+qint64 LibrarySnapshot::parseDuration(const QString& text)
+{
+    const QStringList parts = text.trimmed().split(':');
+    if (parts.size() < 2 || parts.size() > 3) {
+        return -1;
+    }
+    qint64 seconds = 0;
+    for (const QString& part : parts) {
+        bool ok = false;
+        const int value = part.toInt(&ok);
+        if (!ok || value < 0) {
+            return -1;
+        }
+        seconds = seconds * 60 + value;
+    }
+    return seconds * 1000000;
+}
+
+const QVector<int>& LibrarySnapshot::rowsOfGenre(int genreId) const
+{
+    static const QVector<int> none;
+    return genreId >= 0 && genreId < m_rowsByGenre.size() ? m_rowsByGenre.at(genreId) : none;
+}
+
+int LibrarySnapshot::rowOf(int musicId) const
+{
+    const auto it = std::lower_bound(m_ids.cbegin(), m_ids.cend(), musicId);
+    return it != m_ids.cend() && *it == musicId ? int(it - m_ids.cbegin()) : -1;
+}
+
+int LibrarySnapshot::rowOfPath(const QString& path) const
+{
+    const auto rows = m_rowsByPathHash.equal_range(qHash(path));
+    for (auto it = rows.first; it != rows.second; ++it) {
+        if (this->path(*it) == path) {
+            return *it;
+        }
+    }
+    return -1;
+}
+
+int LibrarySnapshot::intern(const QString& name, QStringList& names, QHash<QString, int>& ids)
+{
+    const QString nameKey = key(name);
+    if (nameKey.isEmpty()) {
+        return NONE;
+    }
+    auto it = ids.constFind(nameKey);
+    if (it != ids.cend()) {
+        return *it;
+    }
+    names.append(name.trimmed());
+    return *ids.insert(nameKey, names.size() - 1);
+}
+
+LibrarySnapshotStore::LibrarySnapshotStore(const QString& databasePath, QObject* parent)
+    : QObject(parent)
+    , m_databasePath(databasePath)
+{
+    connect(&m_watcher, &QFutureWatcher<LoadResult>::finished, this,
+            &LibrarySnapshotStore::onRebuildFinished);
+}
+
+LibrarySnapshotStore::~LibrarySnapshotStore()
+{
+    m_watcher.disconnect(this);
+    m_watcher.waitForFinished();
+}
+
+void LibrarySnapshotStore::rebuild()
+{
+    if (m_watcher.isRunning()) {
+        m_rebuildAgain = true;
+        return;
+    }
+    m_rebuildAgain = false;
+    m_watcher.setFuture(QtConcurrent::run(&LibrarySnapshotStore::loadFrom, m_databasePath));
+}
+
+void LibrarySnapshotStore::publish(LibrarySnapshot::Ptr snapshot)
+{
+    if (!snapshot) {
+        return;
+    }
+    const int tracks = snapshot->size();
+    std::atomic_store(&m_current, std::move(snapshot));
+    ++m_generation;
+    emit published(tracks);
+}
+
+LibrarySnapshotStore::LoadResult LibrarySnapshotStore::loadFrom(const QString& databasePath)
+{
+    LoadResult result;
+    // Opened and removed on the pool thread, under a name no other rebuild uses
+    const QString connectionName = "xfb_snapshot_" + QUuid::createUuid().toString(QUuid::Id128);
+    {
+        QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+        database.setDatabaseName(databasePath);
+        database.setConnectOptions("QSQLITE_OPEN_READONLY;QSQLITE_BUSY_TIMEOUT=5000");
+        if (database.open()) {
+            result.snapshot = LibrarySnapshot::load(database, &result.error);
+        } else {
+            result.error = database.lastError().text();
+        }
+        database.close();
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+    return result;
+}
+
+void LibrarySnapshotStore::onRebuildFinished()
+{
+    const LoadResult result = m_watcher.result();
+    if (!result.snapshot) {
+        qWarning() << "LibrarySnapshotStore: cannot read" << m_databasePath << result.error;
+        m_stale = true;
+        emit rebuildFailed(result.error);
+    } else {
+        m_stale = false;
+        publish(result.snapshot);
+        emit rebuilt(result.snapshot->size());
+    }
+
+    if (m_rebuildAgain) {
+        rebuild();
+    }
+}
@@ -0,0 +1,267 @@
+#ifndef LIBRARYSNAPSHOT_H
+#define LIBRARYSNAPSHOT_H
+
+#include <QFutureWatcher>
+#include <QHash>
+#include <QObject>
+#include <QSqlDatabase>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <memory>
+
+/**
+ * @brief Immutable copy of the musics table for automation decisions
+ *
+ * Auto mode, the day log and the media cache forecast all walk the library,
+ * and each used to read the musics table again to do it. A LibrarySnapshot
+ * holds what they need of every track, column by column: ids() and
+ * durationsUs() are plain arrays indexed by row, so a pass over one of
+ * them touches nothing else. Artists and genres are stored once each, in
+ * artists() and genres(), and each row refers to its own by its index
+ * there; artistId() and genreId() look a name up the same way. Paths and
+ * titles, only needed for the tracks picked, are kept beside them; a path
+ * as the index of its directory, stored once per directory like the
+ * artists, and the file name, so an album's tracks share their long
+ * prefix. rowOfPath() looks paths up by their hash.
+ *
+ * Rows are ordered by id. A snapshot never changes once built: a change is
+ * a new snapshot.
+ *
+ * Snapshots are handed around as a shared pointer to const, which readers
+ * may hold on any thread for as long as they like; see LibrarySnapshotStore
+ * for how a new one replaces the current one.
+ *
+ * @example
+ * @code
+ * LibrarySnapshot::Ptr library = LibrarySnapshot::load(database);
+ * const int rock = library->genreId("Rock");
+ * for (int row : library->rowsOfGenre(rock)) {
+ *     total += library->durationsUs().at(row);
+ * }
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class LibrarySnapshot
+{
+public:
+    using Ptr = std::shared_ptr<const LibrarySnapshot>;
+
+    static constexpr int NONE = -1;   ///< Dictionary id of an empty artist or genre
+
+    /**
+     * @brief One track, as read from the table
+     */
+    struct Row {
+        int id = -1;
+        QString path;
+        QString artist;
+        QString song;
+        QString genre;
+        qint64 durationUs = -1;     ///< -1 if unknown
+    };
+
+    /**
+     * @brief Build a snapshot from rows in any order
+     * @param rows Tracks; those without a path are left out
+     */
+    static Ptr fromRows(QVector<Row> rows);
+
+    /**
+     * @brief Read the musics table into a snapshot
+     * @param database Open connection, used on the calling thread only
+     * @param error Set to the reason on failure
+     * @return The snapshot, or nullptr if the table cannot be read
+     */
+    static Ptr load(const QSqlDatabase& database, QString* error = nullptr);
+
+    /**
+     * @brief Parse a musics.time value, "m:ss" or "h:mm:ss"
+     * @return Microseconds, or -1 if the text is not a duration
+     */
+    static qint64 parseDuration(const QString& text);
+
+    int size() const { return m_ids.size(); }
+    bool isEmpty() const { return m_ids.isEmpty(); }
+
+    const QVector<int>& ids() const { return m_ids; }
+    const QVector<qint64>& durationsUs() const { return m_durationsUs; }
+
+    /// Genre names by genre id, as first spelled in the table
+    const QStringList& genres() const { return m_genres; }
+    /// Artist names by artist id, as first spelled in the table
+    const QStringList& artists() const { return m_artists; }
+
+    QString path(int row) const
+    {
+        return m_directories.at(m_directoryIds.at(row)) + m_fileNames.at(row);
+    }
+    QString song(int row) const { return m_songs.at(row); }
+    QString artist(int row) const { return name(m_artists, m_artistIds.at(row)); }
+    QString genre(int row) const { return name(m_genres, m_genreIds.at(row)); }
+
+    /**
+     * @brief Find the id of a genre
+     * @param genre Genre name, matched ignoring case and surrounding spaces
+     * @return Genre id, or NONE if no track has it
+     */
+    int genreId(const QString& genre) const { return m_genreIdByKey.value(key(genre), NONE); }
+
+    /**
+     * @brief Find the id of an artist
+     * @param artist Artist name, matched ignoring case and surrounding spaces
+     * @return Artist id, or NONE if no track has it
+     */
+    int artistId(const QString& artist) const { return m_artistIdByKey.value(key(artist), NONE); }
+
+    /**
+     * @brief Get the rows of a genre, in id order
+     * @param genreId Genre id from genreId()
+     */
+    const QVector<int>& rowsOfGenre(int genreId) const;
+
+    /**
+     * @brief Find the row of a music id
+     * @return Row, or -1 if the id is not in the snapshot
+     */
+    int rowOf(int musicId) const;
+
+    /**
+     * @brief Find the row of a path
+     * @return Row, or -1 if the path is not in the snapshot
+     */
+    int rowOfPath(const QString& path) const;
+
+private:
+    static QString key(const QString& name) { return name.trimmed().toCaseFolded(); }
+    static QString name(const QStringList& names, int id)
+    {
+        return id == NONE ? QString() : names.at(id);
+    }
+    static int intern(const QString& name, QStringList& names, QHash<QString, int>& ids);
+
+    QVector<int> m_ids;
+    QVector<qint64> m_durationsUs;
+    QVector<int> m_genreIds;
+    QVector<int> m_artistIds;
+    QVector<int> m_directoryIds;
+    QVector<QString> m_fileNames;
+    QVector<QString> m_songs;
+    QStringList m_directories;     ///< Each ending in a separator
+
+    QStringList m_genres;
+    QStringList m_artists;
+    QHash<QString, int> m_genreIdByKey;
+    QHash<QString, int> m_artistIdByKey;
+    QVector<QVector<int>> m_rowsByGenre;
+    QMultiHash<size_t, int> m_rowsByPathHash;
+};
+
+/**
+ * @brief Holds the current LibrarySnapshot and replaces it when the library changes
+ *
+ * rebuild() reads the library into a new snapshot on a worker thread, on a
+ * connection of its own to databasePath(), so the pick that follows a large
+ * import does not wait for the table to be read. The new snapshot is then
+ * published by swapping the pointer that current() returns; a reader keeps
+ * the snapshot it got for as long as it holds it, and the old one goes away
+ * with its last reader. current() never waits for a rebuild.
+ *
+ * Rebuilds asked for while one is running are folded into a single one
+ * after it. When a rebuild cannot read the library, the snapshot published
+ * before stays current() but no longer matches the table: isStale() tells
+ * until a later rebuild succeeds.
+ *
+ * Only the thread the store lives on publishes; current() may be called
+ * from any thread.
+ *
+ * @example
+ * @code
+ * LibrarySnapshotStore* library = new LibrarySnapshotStore(databasePath, this);
+ * connect(library, &LibrarySnapshotStore::rebuilt, rotation, &RotationEngine::invalidate);
+ * connect(library, &LibrarySnapshotStore::rebuildFailed, rotation, &RotationEngine::invalidate);
+ * library->rebuild();
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class LibrarySnapshotStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @param databasePath Library database file the worker connection opens
+     * @param parent Parent object
+     */
+    explicit LibrarySnapshotStore(const QString& databasePath, QObject* parent = nullptr);
+    ~LibrarySnapshotStore() override;
+
+    QString databasePath() const { return m_databasePath; }
+
+    /**
+     * @brief Get the snapshot published last
+     * @return The snapshot, or nullptr before the first one is built
+     */
+    LibrarySnapshot::Ptr current() const { return std::atomic_load(&m_current); }
+
+    /**
+     * @brief Read the library into a new snapshot in the background
+     */
+    void rebuild();
+
+    bool isRebuilding() const { return m_watcher.isRunning(); }
+
+    /**
+     * @brief Check whether the last rebuild failed
+     * @return true if current() is older than the table
+     */
+    bool isStale() const { return m_stale; }
+
+    /**
+     * @brief Publish a snapshot built elsewhere
+     */
+    void publish(LibrarySnapshot::Ptr snapshot);
+
+    /**
+     * @brief Number of snapshots published so far
+     */
+    int generation() const { return m_generation; }
+
+signals:
+    /**
+     * @brief Emitted when a new snapshot was published
+     * @param tracks Tracks in it
+     */
+    void published(int tracks);
+
+    /**
+     * @brief Emitted when a snapshot read by rebuild() was published
+     * @param tracks Tracks in it
+     */
+    void rebuilt(int tracks);
+
+    /**
+     * @brief Emitted when a rebuild could not read the library
+     */
+    void rebuildFailed(const QString& error);
+
+private:
+    struct LoadResult {
+        LibrarySnapshot::Ptr snapshot;
+        QString error;
+    };
+
+    static LoadResult loadFrom(const QString& databasePath);
+    void onRebuildFinished();
+
+    QString m_databasePath;
+    LibrarySnapshot::Ptr m_current;     ///< Only read and written through std::atomic_load/store
+    QFutureWatcher<LoadResult> m_watcher;
+    bool m_rebuildAgain = false;
+    bool m_stale = false;
+    int m_generation = 0;
+};
+
+#endif // LIBRARYSNAPSHOT_H
@@ -0,0 +1,215 @@
+#include "LibraryWatcher.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QFutureWatcher>
+#include <QTimer>
+#include <QtConcurrent/QtConcurrent>
+#include <algorithm>
+
+LibraryWatcher::LibraryWatcher(QObject* parent)
+    : QObject(parent)
+    , m_watcher(new QFileSystemWatcher(this))
+    , m_debounceTimer(new QTimer(this))
+    , m_nameFilters({"*.mp3", "*.ogg", "*.opus", "*.wav", "*.flac", "*.m4a", "*.aac", "*.wma"})
+{
+    m_debounceTimer->setSingleShot(true);
+    m_debounceTimer->setInterval(m_debounceMs);
+    connect(m_debounceTimer, &QTimer::timeout, this, &LibraryWatcher::flush);
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged, this,
+            &LibraryWatcher::onDirectoryChanged);
+}
+
+void LibraryWatcher::setRoots(const QStringList& roots)
+{
+    const QStringList watched = m_watcher->directories();
+    if (!watched.isEmpty()) {
+        m_watcher->removePaths(watched);
+    }
+    m_watched.clear();
+    m_pending.clear();
+    m_debounceTimer->stop();
+    ++m_generation;
+
+    m_roots.clear();
+    QStringList existing;
+    for (const QString& root : roots) {
+        const QString cleaned = QDir::cleanPath(root);
+        if (root.isEmpty() || m_roots.contains(cleaned)) {
+            continue;
+        }
+        m_roots.append(cleaned);
+        if (QFileInfo(cleaned).isDir()) {
+            existing.append(cleaned);
+        } else {
+            qWarning() << QString("LibraryWatcher::setRoots - Not a directory: %1").arg(cleaned);
+        }
+    }
+    if (existing.isEmpty()) {
+        return;
+    }
+
+    // Listing a large archive takes a while; its directories are watched when it is done
+    auto* watcher = new QFutureWatcher<QStringList>(this);
+    const int generation = m_generation;
+    connect(watcher, &QFutureWatcher<QStringList>::finished, this,
+            [this, watcher, generation]() {
+                onTreeListed(watcher->result(), generation);
+                watcher->deleteLater();
+            });
+    watcher->setFuture(QtConcurrent::run([existing]() {
+        QStringList directories;
+        for (const QString& root : existing) {
+            directories += listTree(root);
+        }
+        return directories;
+    }));
+}
+
+void LibraryWatcher::setDebounceInterval(int intervalMs)
+{
+    m_debounceMs = std::max(0, intervalMs);
+    m_debounceTimer->setInterval(m_debounceMs);
+}
+
+int LibraryWatcher::watchedDirectoryCount() const
+{
+    return m_watched.size();
+}
+
+void LibraryWatcher::onTreeListed(const QStringList& directories, int generation)
+{
+    if (generation != m_generation) {
+        return;
+    }
+
+    const int watched = watch(directories);
+    const int failed = directories.size() - watched;
+    qInfo() << "LibraryWatcher: watching" << watched << "directories under" << m_roots.size()
+            << "roots";
+    if (failed > 0) {
+        qWarning() << QString("LibraryWatcher::onTreeListed - %1 directories cannot be watched; "
+                              "raise the platform's watch limit or rely on the nightly rescan")
+                          .arg(failed);
+    }
+    emit ready(watched, failed);
+}
+
+void LibraryWatcher::onDirectoryChanged(const QString& directory)
+{
+    if (m_pending.isEmpty()) {
+        m_firstEvent.start();
+    }
+    m_pending.insert(directory);
+
+    if (QFileInfo(directory).isDir()) {
+        watchNewSubdirectories(directory);
+    } else {
+        // The watcher dropped the deleted directory and those below it by itself
+        const QString prefix = directory + '/';
+        m_watched.remove(directory);
+        m_watched.removeIf([&prefix](const QString& path) { return path.startsWith(prefix); });
+    }
+
+    if (m_firstEvent.elapsed() >= m_maxDelayMs) {
+        flush();
+    } else {
+        m_debounceTimer->start();
+    }
+}
+
+void LibraryWatcher::watchNewSubdirectories(const QString& directory)
+{
+    const QDir dir(directory);
+    const QStringList names = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    QStringList added;
+    for (const QString& name : names) {
+        const QString path = dir.filePath(name);
+        if (!m_watched.contains(path)) {
+            // A folder dropped in may hold a whole tree of albums
+            added += listTree(path);
+        }
+    }
+    if (!added.isEmpty()) {
+        watch(added);
+    }
+}
+
+int LibraryWatcher::watch(const QStringList& directories)
+{
+    QStringList toAdd;
+    for (const QString& directory : directories) {
+        if (!m_watched.contains(directory)) {
+            toAdd.append(directory);
+        }
+    }
+    if (toAdd.isEmpty()) {
+        return 0;
+    }
+
+    const QStringList failed = m_watcher->addPaths(toAdd);
+    const QSet<QString> failedSet(failed.cbegin(), failed.cend());
+    for (const QString& directory : std::as_const(toAdd)) {
+        if (!failedSet.contains(directory)) {
+            m_watched.insert(directory);
+        }
+    }
+    return toAdd.size() - failed.size();
+}
+
+QStringList LibraryWatcher::listTree(const QString& root)
+{
+    QStringList directories{root};
+    QDirIterator it(root, QDir::Dirs | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        directories.append(it.next());
+    }
+    return directories;
+}
+
+void LibraryWatcher::flush()
+{
+    m_debounceTimer->stop();
+
+    QStringList settled;
+    QSet<QString> settling;
+    for (const QString& directory : std::as_const(m_pending)) {
+        if (isSettling(directory)) {
+            settling.insert(directory);
+        } else {
+            settled.append(directory);
+        }
+    }
+
+    // Uploads still being written are looked at again after the next quiet spell
+    m_pending = settling;
+    if (!m_pending.isEmpty()) {
+        m_firstEvent.start();
+        m_debounceTimer->start();
+    }
+
+    if (!settled.isEmpty()) {
+        std::sort(settled.begin(), settled.end());
+        emit directoriesChanged(settled);
+    }
+}
+
+bool LibraryWatcher::isSettling(const QString& directory) const
+{
+    if (m_settleMs <= 0) {
+        return false;
+    }
+
+    const QFileInfoList files =
+        QDir(directory).entryInfoList(m_nameFilters, QDir::Files, QDir::Time);
+    if (files.isEmpty()) {
+        return false;
+    }
+
+    // Either way round, so a clock running ahead on the share cannot hold a directory forever
+    const qint64 ageMs = files.first().lastModified().msecsTo(QDateTime::currentDateTime());
+    return qAbs(ageMs) < m_settleMs;
+}
@@ -0,0 +1,131 @@
+#ifndef LIBRARYWATCHER_H
+#define LIBRARYWATCHER_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+class QFileSystemWatcher;
+class QTimer;
+
+/**
+ * @brief Watches whole library trees and reports the directories that changed, once they settle
+ *
+ * QFileSystemWatcher uses the platform's notifications (inotify on Linux,
+ * FSEvents on macOS, change notifications on Windows) but is not
+ * recursive. LibraryWatcher watches every directory under the roots, and
+ * adds the directories that appear. Each event marks a directory as
+ * changed. The changed directories are reported together in one
+ * directoriesChanged() signal:
+ *
+ * - once no event has come for debounceInterval();
+ * - or once maxDelay() has passed since the first event, so a share that
+ *   never goes quiet is still taken in.
+ *
+ * A directory holding a file modified within the last settleInterval() is
+ * held back until the file stops growing. Producers copy over the network
+ * and a track is only read once its upload is complete.
+ *
+ * The tree is walked for its directories on a pool thread, so a large
+ * archive does not hold up the interface. Platforms limit the number of
+ * watches (fs.inotify.max_user_watches on Linux); directories over the
+ * limit are logged and left to the nightly rescan.
+ *
+ * @example
+ * @code
+ * LibraryWatcher* watcher = new LibraryWatcher(this);
+ * connect(watcher, &LibraryWatcher::directoriesChanged, rescanner,
+ *         &LibraryRescanner::rescanDirectories);
+ * watcher->setRoots({musicPath});
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class LibraryWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int DEFAULT_DEBOUNCE_MS = 2000;
+    static constexpr int DEFAULT_MAX_DELAY_MS = 30000;
+    static constexpr int DEFAULT_SETTLE_MS = 5000;
+
+    explicit LibraryWatcher(QObject* parent = nullptr);
+
+    /**
+     * @brief Watch these trees, replacing the previous ones
+     *
+     * Watching starts once their directories are listed; see ready().
+     * @param roots Root directories; missing ones are skipped with a warning
+     */
+    void setRoots(const QStringList& roots);
+    QStringList roots() const { return m_roots; }
+
+    /**
+     * @brief Choose which files matter when waiting for a directory to settle
+     * @param filters Wildcard patterns; the audio formats XFB plays by default
+     */
+    void setNameFilters(const QStringList& filters) { m_nameFilters = filters; }
+    QStringList nameFilters() const { return m_nameFilters; }
+
+    void setDebounceInterval(int intervalMs);
+    int debounceInterval() const { return m_debounceMs; }
+
+    void setMaxDelay(int delayMs) { m_maxDelayMs = qMax(0, delayMs); }
+    int maxDelay() const { return m_maxDelayMs; }
+
+    void setSettleInterval(int intervalMs) { m_settleMs = qMax(0, intervalMs); }
+    int settleInterval() const { return m_settleMs; }
+
+    /**
+     * @brief Get how many directories are watched
+     * @return Directory count, 0 until the trees are listed
+     */
+    int watchedDirectoryCount() const;
+
+    /**
+     * @brief Check if directories are waiting to be reported
+     * @return true between an event and directoriesChanged()
+     */
+    bool hasPendingChanges() const { return !m_pending.isEmpty(); }
+
+signals:
+    /**
+     * @brief Emitted once the roots' directories are watched
+     * @param directories Directories watched
+     * @param failed Directories that could not be watched
+     */
+    void ready(int directories, int failed);
+
+    /**
+     * @brief Emitted when changed directories have settled
+     * @param directories Directories where files appeared, changed or went,
+     *                    including directories that were deleted
+     */
+    void directoriesChanged(const QStringList& directories);
+
+private:
+    void onTreeListed(const QStringList& directories, int generation);
+    void onDirectoryChanged(const QString& directory);
+    void watchNewSubdirectories(const QString& directory);
+    int watch(const QStringList& directories);
+    static QStringList listTree(const QString& root);
+    void flush();
+    bool isSettling(const QString& directory) const;
+
+    QFileSystemWatcher* m_watcher;
+    QTimer* m_debounceTimer;
+    QStringList m_roots;
+    QStringList m_nameFilters;
+    QSet<QString> m_watched;   ///< Directories added to m_watcher
+    QSet<QString> m_pending;   ///< Directories changed since the last report
+    QElapsedTimer m_firstEvent;   ///< Started by the first event since the last report
+    int m_debounceMs = DEFAULT_DEBOUNCE_MS;
+    int m_maxDelayMs = DEFAULT_MAX_DELAY_MS;
+    int m_settleMs = DEFAULT_SETTLE_MS;
+    int m_generation = 0;   ///< Bumped by setRoots() so a stale listing is dropped
+};
+
+#endif // LIBRARYWATCHER_H
@@ -0,0 +1,237 @@
+#include "LiveCapture.h"
+#include <QAudioSource>
+#include <QDebug>
+#include <QMediaDevices>
+
+namespace {
+
+QAudioFormat stereoFloat()
+{
+    QAudioFormat format;
+    format.setSampleRate(LiveCapture::DEFAULT_SAMPLE_RATE);
+    format.setChannelCount(LiveCapture::CHANNELS);
+    format.setSampleFormat(QAudioFormat::Float);
+    return format;
+}
+
+} // namespace
+
+LiveCapture::LiveCapture(QObject* parent)
+    : QObject(parent)
+    , m_meter(stereoFloat())
+    , m_captureContext(new QObject)
+{
+    m_captureThread.setObjectName("LiveCapture");
+    m_captureContext->moveToThread(&m_captureThread);
+    connect(&m_captureThread, &QThread::finished, m_captureContext, &QObject::deleteLater);
+    m_captureThread.start(QThread::TimeCriticalPriority);
+}
+
+LiveCapture::~LiveCapture()
+{
+    stopCapture();
+    m_captureThread.quit();
+    m_captureThread.wait();
+}
+
+void LiveCapture::addListener(Listener listener)
+{
+    if (m_capturing) {
+        logError("addListener", "The capture is running");
+        return;
+    }
+    m_listeners.push_back(std::move(listener));
+}
+
+int LiveCapture::openReader()
+{
+    if (!m_capturing && !startCapture()) {
+        return -1;
+    }
+    const int reader = m_buffer.openReader();
+    if (reader < 0) {
+        logError("openReader", QString("All %1 readers are open")
+                                   .arg(AudioBroadcastBuffer::MAX_READERS));
+        if (!m_started && m_buffer.readerCount() == 0) {
+            stopCapture();
+        }
+    }
+    return reader;
+}
+
+void LiveCapture::closeReader(int reader)
+{
+    if (reader < 0) {
+        return;
+    }
+    m_buffer.closeReader(reader);
+    if (!m_started && m_buffer.readerCount() == 0) {
+        stopCapture();
+    }
+}
+
+int LiveCapture::read(int reader, float* data, int samples)
+{
+    return m_buffer.read(reader, data, samples);
+}
+
+SegmentRecorder::PcmReader LiveCapture::reader(int reader)
+{
+    return [this, reader](float* data, int samples) { return read(reader, data, samples); };
+}
+
+bool LiveCapture::start()
+{
+    if (!m_capturing && !startCapture()) {
+        return false;
+    }
+    m_started = true;
+    return true;
+}
+
+void LiveCapture::stop()
+{
+    m_started = false;
+    if (m_buffer.readerCount() == 0) {
+        stopCapture();
+    }
+}
+
+void LiveCapture::write(const float* samples, int count)
+{
+    if (m_capturing && m_externalRate > 0) {
+        publish(samples, count);
+    }
+}
+
+bool LiveCapture::startCapture()
+{
+    QAudioDevice device;
+    QAudioFormat format;
+    if (m_externalRate > 0) {
+        m_sampleRate = m_externalRate;
+    } else {
+        device = m_device.isNull() ? QMediaDevices::defaultAudioInput() : m_device;
+        if (device.isNull()) {
+            logError("start", "No audio input");
+            return false;
+        }
+        format = stereoFloat();
+        if (!device.isFormatSupported(format)) {
+            format = device.preferredFormat();
+        }
+        m_sampleRate = format.sampleRate();
+    }
+
+    // No reader is open and the capture thread is idle, so nothing else touches the buffer
+    m_buffer.resize(m_sampleRate * CHANNELS * BUFFER_SECONDS, CHANNELS);
+    m_meter.reset();
+
+    if (m_externalRate <= 0 && !openDevice(device, format)) {
+        logError("start", QString("Cannot open %1").arg(device.description()));
+        return false;
+    }
+    m_capturing = true;
+    qInfo() << "LiveCapture: capturing"
+            << (m_externalRate > 0 ? QString("external samples") : device.description())
+            << "at" << m_sampleRate << "Hz";
+    emit capturingChanged(true);
+    return true;
+}
+
+bool LiveCapture::openDevice(const QAudioDevice& device, const QAudioFormat& format)
+{
+    bool opened = false;
+    QMetaObject::invokeMethod(m_captureContext, [&]() {
+        m_captureFormat = format;
+        m_source = new QAudioSource(device, format, m_captureContext);
+        const int bytes = format.bytesForDuration(READ_INTERVAL_MS * 1000);
+        m_captureBytes.resize(qMax(bytes, format.bytesPerFrame()));
+        m_captureSamples.resize(m_captureBytes.size());
+        m_stereoSamples.resize(m_captureBytes.size() * CHANNELS);
+        m_captureDevice = m_source->start();
+        if (!m_captureDevice || m_source->error() != QAudio::NoError) {
+            delete m_source;
+            m_source = nullptr;
+            m_captureDevice = nullptr;
+            return;
+        }
+        connect(m_captureDevice, &QIODevice::readyRead, m_captureContext,
+                [this]() { readCapture(); });
+        opened = true;
+    }, Qt::BlockingQueuedConnection);
+    return opened;
+}
+
+void LiveCapture::readCapture()
+{
+    const int frameBytes = m_captureFormat.bytesPerFrame();
+    const int maxBytes = m_captureBytes.size() / frameBytes * frameBytes;
+    const int channels = m_captureFormat.channelCount();
+    qint64 bytes;
+    while ((bytes = m_captureDevice->read(m_captureBytes.data(), maxBytes)) > 0) {
+        const int count =
+            SegmentRecorder::toFloat(m_captureBytes.constData(), int(bytes),
+                                     m_captureFormat.sampleFormat(), m_captureSamples.data());
+        if (channels == CHANNELS) {
+            publish(m_captureSamples.data(), count);
+        } else {
+            const int stereo = toStereo(m_captureSamples.data(), count / channels, channels,
+                                        m_stereoSamples.data());
+            publish(m_stereoSamples.data(), stereo);
+        }
+    }
+}
+
+void LiveCapture::stopCapture()
+{
+    if (!m_capturing) {
+        return;
+    }
+    QMetaObject::invokeMethod(m_captureContext, [this]() {
+        if (!m_source) {
+            return;
+        }
+        readCapture();
+        m_source->stop();
+        delete m_source;
+        m_source = nullptr;
+        m_captureDevice = nullptr;
+    }, Qt::BlockingQueuedConnection);
+    m_capturing = false;
+    m_meter.reset();
+    qInfo() << "LiveCapture: stopped";
+    emit capturingChanged(false);
+}
+
+void LiveCapture::publish(const float* samples, int count)
+{
+    count = count / CHANNELS * CHANNELS;
+    if (count <= 0) {
+        return;
+    }
+    m_buffer.write(samples, count);
+    m_meter.process(reinterpret_cast<const char*>(samples), qint64(count) * sizeof(float));
+    for (const Listener& listener : m_listeners) {
+        listener(samples, count);
+    }
+}
+
+int LiveCapture::toStereo(const float* in, int frames, int channels, float* out)
+{
+    if (frames <= 0 || channels <= 0) {
+        return 0;
+    }
+    for (int frame = 0; frame < frames; ++frame) {
+        const float* source = in + frame * channels;
+        out[frame * 2] = source[0];
+        out[frame * 2 + 1] = channels > 1 ? source[1] : source[0];
+    }
+    return frames * 2;
+}
+
+void LiveCapture::logError(const QString& operation, const QString& error)
+{
+    qWarning() << QString("LiveCapture::%1 - %2").arg(operation, error);
+    emit operationError(operation, error);
+}
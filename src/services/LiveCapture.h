@@ -0,0 +1,213 @@
+#ifndef LIVECAPTURE_H
+#define LIVECAPTURE_H
+
+#include <QAudioDevice>
+#include <QAudioFormat>
+#include <QByteArray>
+#include <QObject>
+#include <QThread>
+#include <atomic>
+#include <functional>
+#include <vector>
+
+#include "AudioBroadcastBuffer.h"
+#include "LevelMeter.h"
+#include "SegmentRecorder.h"
+
+class QAudioSource;
+class QIODevice;
+
+/**
+ * @brief One capture of the live input, shared by everything that uses it
+ *
+ * The show recorder, the built-in stream, the input meter and the dead-air
+ * detector each used to open the sound card on their own, or could not run
+ * at once. LiveCapture opens the input once, on a capture thread of its
+ * own. It converts the samples to stereo float and writes them into one
+ * AudioBroadcastBuffer. Each sink opens a reader and drains the buffer at
+ * its own pace, so a stalled encoder does not hold up the meter.
+ *
+ * The capture runs while a reader is open, or while started. It starts when
+ * the first reader opens and stops when the last one closes.
+ *
+ * Listeners are called on the capture thread with every converted block.
+ * They suit cheap measurements that must not lag, like silence detection.
+ * The built-in meter() measures the same blocks.
+ *
+ * Samples can also be fed with write() rather than a sound card; see
+ * setExternalSource().
+ *
+ * @example
+ * @code
+ * LiveCapture* capture = new LiveCapture(this);
+ * capture->setDevice(QMediaDevices::defaultAudioInput());
+ * const int id = capture->openReader();
+ * recorder->setReader(capture->reader(id), capture->sampleRate(), LiveCapture::CHANNELS);
+ * inputBar->setLevel(capture->meter().takePeak());   // GUI timer
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class LiveCapture : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int DEFAULT_SAMPLE_RATE = 48000;
+    static constexpr int CHANNELS = 2;
+    static constexpr int BUFFER_SECONDS = 30;
+    static constexpr int READ_INTERVAL_MS = 20;   ///< Audio the capture converts at once
+
+    /// Called on the capture thread with interleaved stereo samples
+    using Listener = std::function<void(const float*, int)>;
+
+    explicit LiveCapture(QObject* parent = nullptr);
+    ~LiveCapture() override;
+
+    /**
+     * @brief Set the input to capture
+     *
+     * Takes effect the next time the capture starts.
+     * @param device Audio input; the default input if null
+     */
+    void setDevice(const QAudioDevice& device) { m_device = device; }
+
+    /**
+     * @brief Take samples passed to write() rather than a sound card
+     *
+     * Takes effect the next time the capture starts.
+     * @param sampleRate Rate of the samples in Hz, or 0 to capture from the device again
+     */
+    void setExternalSource(int sampleRate) { m_externalRate = qMax(0, sampleRate); }
+
+    /**
+     * @brief Add a function that sees every captured block
+     *
+     * Must not block or allocate. Call before the capture starts.
+     * @param listener Function called on the capture thread
+     */
+    void addListener(Listener listener);
+
+    /**
+     * @brief Open a reader, starting the capture if it is the first
+     * @return Reader ID, or -1 if the input cannot be opened or too many readers are open
+     */
+    int openReader();
+
+    /**
+     * @brief Close a reader, stopping the capture if it was the last
+     * @param reader Reader ID; -1 is ignored
+     */
+    void closeReader(int reader);
+
+    /**
+     * @brief Read captured samples
+     *
+     * Never blocks; may be called from one thread per reader.
+     * @param reader Reader ID
+     * @param data Destination for interleaved stereo samples
+     * @param samples Maximum number of samples
+     * @return Samples read
+     */
+    int read(int reader, float* data, int samples);
+
+    /**
+     * @brief Get a function that reads for one reader
+     * @param reader Reader ID
+     * @return Function for SegmentRecorder::setReader() or StreamOutput::setSource()
+     */
+    SegmentRecorder::PcmReader reader(int reader);
+
+    /**
+     * @brief Get how many samples a reader lost by falling behind
+     */
+    qint64 dropped(int reader) const { return m_buffer.dropped(reader); }
+
+    /**
+     * @brief Start the capture without a reader, such as for the input meter
+     * @return false if the input cannot be opened
+     */
+    bool start();
+
+    /**
+     * @brief Undo start(); the capture keeps running while a reader is open
+     */
+    void stop();
+
+    bool isCapturing() const { return m_capturing; }
+
+    /**
+     * @brief Get the rate of the captured samples
+     * @return Rate in Hz of the running capture, or of the last one
+     */
+    int sampleRate() const { return m_sampleRate; }
+
+    /**
+     * @brief Feed samples to an external source capture
+     *
+     * Never blocks or allocates; may be called from one thread at a time.
+     * @param samples Interleaved stereo float samples
+     * @param count Number of samples
+     */
+    void write(const float* samples, int count);
+
+    /**
+     * @brief Get the level of the input
+     * @return Meter of the converted stereo samples; read it from any thread
+     */
+    LevelMeter& meter() { return m_meter; }
+
+    /**
+     * @brief Turn interleaved samples of any channel count into stereo
+     *
+     * Mono is copied to both sides; beyond two channels, the first two are kept.
+     * @param in Interleaved samples
+     * @param frames Number of frames
+     * @param channels Channels per frame of in
+     * @param out Destination, room for frames * 2 samples
+     * @return Samples written to out
+     */
+    static int toStereo(const float* in, int frames, int channels, float* out);
+
+signals:
+    /**
+     * @brief Emitted when the capture starts or stops
+     * @param capturing Whether the input is open
+     */
+    void capturingChanged(bool capturing);
+
+    /**
+     * @brief Emitted when an operation fails
+     * @param operation Name of the operation
+     * @param error Error message
+     */
+    void operationError(const QString& operation, const QString& error);
+
+private:
+    bool startCapture();
+    bool openDevice(const QAudioDevice& device, const QAudioFormat& format);
+    void stopCapture();
+    void readCapture();
+    void publish(const float* samples, int count);
+    void logError(const QString& operation, const QString& error);
+
+    QAudioDevice m_device;
+    int m_externalRate = 0;
+    int m_sampleRate = DEFAULT_SAMPLE_RATE;
+    bool m_started = false;     ///< start() was called
+    std::atomic<bool> m_capturing{false};
+    AudioBroadcastBuffer m_buffer;
+    LevelMeter m_meter;
+    std::vector<Listener> m_listeners;
+
+    QThread m_captureThread;
+    QObject* m_captureContext;             ///< Lives on m_captureThread
+    QAudioSource* m_source = nullptr;      ///< Capture thread only
+    QIODevice* m_captureDevice = nullptr;  ///< Capture thread only
+    QAudioFormat m_captureFormat;          ///< Capture thread only
+    QByteArray m_captureBytes;             ///< Capture thread only
+    std::vector<float> m_captureSamples;   ///< Capture thread only
+    std::vector<float> m_stereoSamples;    ///< Capture thread only
+};
+
+#endif // LIVECAPTURE_H
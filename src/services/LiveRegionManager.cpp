@@ -1,17 +1,18 @@
 #include "LiveRegionManager.h"
 #include "AccessibilityManager.h"
+#include "AnnouncementBus.h"
 #include "AudioFeedbackService.h"
+#include "PlaybackClock.h"
 #include "ServiceContainer.h"
 #include <QApplication>
 #include <QAccessibleEvent>
 #include <QDateTime>
 #include <QDebug>
+#include <QPointer>
 #include <QSettings>
 
 LiveRegionManager::LiveRegionManager(QObject* parent)
     : BaseService(parent)
-    , m_updateTimer(nullptr)
-    , m_timeUpdateTimer(nullptr)
     , m_accessibilityManager(nullptr)
     , m_audioFeedbackService(nullptr)
     , m_isProcessingUpdates(false)
@@ -90,7 +91,6 @@ void LiveRegionManager::doShutdown()
     
     // Clear all live regions
     m_liveRegions.clear();
-    m_pendingUpdates.clear();
     
     // Reset service dependencies
     m_accessibilityManager = nullptr;
@@ -106,41 +106,13 @@ QString LiveRegionManager::getServiceName() const
 
 void LiveRegionManager::initializeLiveRegionSystem()
 {
-    // Create update processing timer
-    m_updateTimer = new QTimer(this);
-    m_updateTimer->setInterval(UPDATE_PROCESSING_INTERVAL_MS);
-    m_updateTimer->setSingleShot(false);
-    connect(m_updateTimer, &QTimer::timeout, this, &LiveRegionManager::processPendingUpdates);
-    
-    // Create time update timer
-    m_timeUpdateTimer = new QTimer(this);
-    m_timeUpdateTimer->setInterval(m_config.timeUpdateIntervalMs);
-    m_timeUpdateTimer->setSingleShot(false);
-    connect(m_timeUpdateTimer, &QTimer::timeout, this, &LiveRegionManager::onTimeUpdateTimer);
-    
-    // Start timers if enabled
-    if (m_config.enabled) {
-        m_updateTimer->start();
-        if (m_config.timeUpdateIntervalMs > 0) {
-            m_timeUpdateTimer->start();
-        }
-    }
+    // Throttled updates wait on AnnouncementBus, which is armed only while one does
+    AnnouncementBus::instance();
 }
 
 void LiveRegionManager::shutdownLiveRegionSystem()
 {
-    // Stop and cleanup timers
-    if (m_updateTimer) {
-        m_updateTimer->stop();
-        m_updateTimer->deleteLater();
-        m_updateTimer = nullptr;
-    }
-    
-    if (m_timeUpdateTimer) {
-        m_timeUpdateTimer->stop();
-        m_timeUpdateTimer->deleteLater();
-        m_timeUpdateTimer = nullptr;
-    }
+    AnnouncementBus::instance()->clear(this);
     
     // Clear processing state
     m_isProcessingUpdates = false;
@@ -211,7 +183,7 @@ void LiveRegionManager::removeLiveRegion(QWidget* widget)
         qDebug() << "LiveRegionManager: Removing live region for widget" << widget->objectName();
         
         // Clear pending updates for this widget
-        clearPendingUpdates(widget);
+        AnnouncementBus::instance()->clear(this, regionKey(widget));
         
         // Remove from registry
         m_liveRegions.remove(widget);
@@ -252,9 +224,8 @@ void LiveRegionManager::updateLiveRegion(QWidget* widget, const QString& content
     // Check throttling
     bool isCritical = (info.updateType == UpdateType::CriticalAlert);
     if (!forceUpdate && !isCritical && shouldThrottleUpdate(widget, info.updateType, false)) {
-        // Add to pending updates
-        PendingUpdate update(widget, content, info.updateType, isCritical);
-        addPendingUpdate(update);
+        // Wait for the end of the throttle interval
+        addPendingUpdate(widget, content, info.updateType);
         return;
     }
     
@@ -321,6 +292,23 @@ void LiveRegionManager::announceTimeUpdate(const QString& currentTime, const QSt
         return;
     }
     
+    QString announcement = formatTimeInfo(currentTime, totalTime, remainingTime);
+    
+    // Store for comparison
+    m_lastTimeInfo = announcement;
+    
+    // Send to audio feedback service with low priority (time updates are frequent)
+    if (m_audioFeedbackService) {
+        m_audioFeedbackService->queueAnnouncement(announcement, AudioFeedbackService::Priority::Low, 
+                                                 AudioFeedbackService::FeedbackType::StatusChange);
+    }
+    
+    emit liveRegionUpdated(nullptr, announcement, UpdateType::TimeUpdate);
+}
+
+QString LiveRegionManager::formatTimeInfo(const QString& currentTime, const QString& totalTime,
+                                          const QString& remainingTime) const
+{
     QString announcement;
     
     // Format based on verbosity level
@@ -347,16 +335,7 @@ void LiveRegionManager::announceTimeUpdate(const QString& currentTime, const QSt
             break;
     }
     
-    // Store for comparison
-    m_lastTimeInfo = announcement;
-    
-    // Send to audio feedback service with low priority (time updates are frequent)
-    if (m_audioFeedbackService) {
-        m_audioFeedbackService->queueAnnouncement(announcement, AudioFeedbackService::Priority::Low, 
-                                                 AudioFeedbackService::FeedbackType::StatusChange);
-    }
-    
-    emit liveRegionUpdated(nullptr, announcement, UpdateType::TimeUpdate);
+    return announcement;
 }
 
 void LiveRegionManager::announceSystemStatus(const QString& component, const QString& status, const QString& additionalInfo)
@@ -498,8 +477,13 @@ void LiveRegionManager::requestTimeAnnouncement(bool includeRemaining)
     
     m_lastTimeAnnouncementRequest = currentTime;
     
-    // Use last known time info or request current info
+    // The clock has the current time whenever a track is loaded
+    const PlaybackClock::Time& time = PlaybackClock::instance()->time();
     QString announcement = m_lastTimeInfo;
+    if (time.durationMs > 0) {
+        announcement = formatTimeInfo(time.spokenElapsed, time.spokenDuration,
+                                      includeRemaining ? time.spokenRemaining : QString());
+    }
     if (announcement.isEmpty()) {
         announcement = "Time information not available";
     }
@@ -519,27 +503,8 @@ void LiveRegionManager::setConfig(const LiveRegionConfig& config)
 {
     m_config = config;
     
-    // Update timer intervals
-    if (m_updateTimer) {
-        // Update timer interval is fixed, but we can enable/disable
-        if (config.enabled) {
-            if (!m_updateTimer->isActive()) {
-                m_updateTimer->start();
-            }
-        } else {
-            m_updateTimer->stop();
-        }
-    }
-    
-    if (m_timeUpdateTimer) {
-        m_timeUpdateTimer->setInterval(config.timeUpdateIntervalMs);
-        if (config.enabled && config.timeUpdateIntervalMs > 0) {
-            if (!m_timeUpdateTimer->isActive()) {
-                m_timeUpdateTimer->start();
-            }
-        } else {
-            m_timeUpdateTimer->stop();
-        }
+    if (!config.enabled) {
+        clearAllPendingUpdates();
     }
     
     // Save configuration
@@ -554,21 +519,7 @@ void LiveRegionManager::setEnabled(bool enabled)
     
     m_config.enabled = enabled;
     
-    if (enabled) {
-        if (m_updateTimer && !m_updateTimer->isActive()) {
-            m_updateTimer->start();
-        }
-        if (m_timeUpdateTimer && m_config.timeUpdateIntervalMs > 0 && !m_timeUpdateTimer->isActive()) {
-            m_timeUpdateTimer->start();
-        }
-    } else {
-        if (m_updateTimer) {
-            m_updateTimer->stop();
-        }
-        if (m_timeUpdateTimer) {
-            m_timeUpdateTimer->stop();
-        }
-        
+    if (!enabled) {
         // Clear pending updates
         clearAllPendingUpdates();
     }
@@ -593,14 +544,7 @@ void LiveRegionManager::clearPendingUpdates(QWidget* widget)
     QMutexLocker locker(&m_updateMutex);
     
     // Remove pending updates for the specific widget
-    auto it = m_pendingUpdates.begin();
-    while (it != m_pendingUpdates.end()) {
-        if (it->widget == widget) {
-            it = m_pendingUpdates.erase(it);
-        } else {
-            ++it;
-        }
-    }
+    AnnouncementBus::instance()->clear(this, regionKey(widget));
     
     // Reset pending count for the widget
     if (m_liveRegions.contains(widget)) {
@@ -612,7 +556,7 @@ void LiveRegionManager::clearAllPendingUpdates()
 {
     QMutexLocker locker(&m_updateMutex);
     
-    m_pendingUpdates.clear();
+    AnnouncementBus::instance()->clear(this);
     
     // Reset pending counts for all widgets
     for (auto& info : m_liveRegions) {
@@ -636,51 +580,6 @@ void LiveRegionManager::onVerbosityLevelChanged(int level)
     qDebug() << "LiveRegionManager: Verbosity level changed to" << level;
 }
 
-void LiveRegionManager::processPendingUpdates()
-{
-    if (m_isProcessingUpdates || !m_config.enabled) {
-        return;
-    }
-    
-    QMutexLocker locker(&m_updateMutex);
-    
-    if (m_pendingUpdates.isEmpty()) {
-        return;
-    }
-    
-    m_isProcessingUpdates = true;
-    
-    // Process a limited number of updates per cycle to avoid blocking
-    const int maxUpdatesPerCycle = 5;
-    int updatesProcessed = 0;
-    
-    while (!m_pendingUpdates.isEmpty() && updatesProcessed < maxUpdatesPerCycle) {
-        PendingUpdate update = m_pendingUpdates.dequeue();
-        
-        // Check if widget still exists and is registered
-        if (update.widget && m_liveRegions.contains(update.widget)) {
-            // Check if update is still relevant (not too old)
-            qint64 currentTime = QDateTime::currentMSecsSinceEpoch();
-            if (currentTime - update.timestamp < EXPIRED_UPDATE_CLEANUP_MS) {
-                processLiveRegionUpdate(update.widget, update.content, update.updateType);
-                updatesProcessed++;
-            }
-            
-            // Decrement pending count
-            if (m_liveRegions[update.widget].pendingUpdates > 0) {
-                m_liveRegions[update.widget].pendingUpdates--;
-            }
-        }
-    }
-    
-    m_isProcessingUpdates = false;
-    
-    // Clean up expired updates periodically
-    if (m_updatesProcessed % 50 == 0) {
-        cleanupExpiredUpdates();
-    }
-}
-
 void LiveRegionManager::onWidgetDestroyed(QObject* obj)
 {
     QWidget* widget = qobject_cast<QWidget*>(obj);
@@ -689,12 +588,6 @@ void LiveRegionManager::onWidgetDestroyed(QObject* obj)
     }
 }
 
-void LiveRegionManager::onTimeUpdateTimer()
-{
-    // This timer can be used for periodic time announcements if needed
-    // Currently, time updates are handled on-demand or through external triggers
-}
-
 bool LiveRegionManager::shouldThrottleUpdate(QWidget* widget, UpdateType updateType, bool isCritical) const
 {
     if (isCritical && m_config.prioritizeCriticalUpdates) {
@@ -715,37 +608,48 @@ bool LiveRegionManager::shouldThrottleUpdate(QWidget* widget, UpdateType updateT
         return true;
     }
     
-    // Check pending update count
-    if (info.pendingUpdates >= m_config.maxPendingUpdates) {
+    // A waiting update must not be overtaken by a newer one
+    if (info.pendingUpdates > 0) {
         return true;
     }
     
     return false;
 }
 
-void LiveRegionManager::addPendingUpdate(const PendingUpdate& update)
+void LiveRegionManager::addPendingUpdate(QWidget* widget, const QString& content,
+                                         UpdateType updateType)
 {
-    // Check if we're at the limit
-    if (m_pendingUpdates.size() >= m_config.maxPendingUpdates * m_liveRegions.size()) {
-        // Remove oldest non-critical update
-        auto it = m_pendingUpdates.begin();
-        while (it != m_pendingUpdates.end()) {
-            if (!it->isCritical) {
-                m_pendingUpdates.erase(it);
-                m_updatesThrottled++;
-                emit updateThrottled(update.widget, update.content);
-                break;
-            }
-            ++it;
-        }
-    }
+    LiveRegionInfo& info = m_liveRegions[widget];
     
-    m_pendingUpdates.enqueue(update);
+    // Only the latest content of a region is announced; the one it replaces is throttled
+    if (info.pendingUpdates > 0) {
+        m_updatesThrottled++;
+        emit updateThrottled(widget, content);
+    }
+    
+    AnnouncementBus::Announcement announcement;
+    announcement.region = regionKey(widget);
+    announcement.message = content;
+    announcement.throttleMs = m_config.updateThrottleMs;
+    announcement.notBefore = info.lastUpdateTime + m_config.updateThrottleMs;
+    announcement.context = this;
+    QPointer<QWidget> target(widget);
+    announcement.deliver = [this, target, updateType](const AnnouncementBus::Announcement& item) {
+        QMutexLocker locker(&m_updateMutex);
+        if (!m_config.enabled || !target || !m_liveRegions.contains(target)) {
+            return;
+        }
+        m_liveRegions[target].pendingUpdates = 0;
+        processLiveRegionUpdate(target, item.message, updateType);
+    };
     
-    // Increment pending count for the widget
-    if (m_liveRegions.contains(update.widget)) {
-        m_liveRegions[update.widget].pendingUpdates++;
-    }
+    info.pendingUpdates = 1;
+    AnnouncementBus::instance()->post(announcement);
+}
+
+QString LiveRegionManager::regionKey(const QWidget* widget)
+{
+    return QStringLiteral("live-region:%1").arg(quintptr(widget), 0, 16);
 }
 
 void LiveRegionManager::processLiveRegionUpdate(QWidget* widget, const QString& content, UpdateType updateType)
@@ -881,18 +785,3 @@ void LiveRegionManager::saveConfiguration()
     
     settings.endGroup();
 }
-
-void LiveRegionManager::cleanupExpiredUpdates()
-{
-    qint64 currentTime = QDateTime::currentMSecsSinceEpoch();
-    
-    auto it = m_pendingUpdates.begin();
-    while (it != m_pendingUpdates.end()) {
-        if (currentTime - it->timestamp > EXPIRED_UPDATE_CLEANUP_MS) {
-            it = m_pendingUpdates.erase(it);
-            m_updatesThrottled++;
-        } else {
-            ++it;
-        }
-    }
-}
\ No newline at end of file
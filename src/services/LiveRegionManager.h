@@ -6,8 +6,6 @@
 #include <QWidget>
 #include <QAccessible>
 #include <QHash>
-#include <QTimer>
-#include <QQueue>
 #include <QMutex>
 
 class AccessibilityManager;
@@ -186,6 +184,10 @@ public:
 
     /**
      * @brief Request immediate time announcement (typically triggered by keyboard shortcut)
+     *
+     * Reads the time PlaybackClock last published, so the answer is current
+     * even when no time update has been announced.
+     *
      * @param includeRemaining Whether to include remaining time information
      */
     void requestTimeAnnouncement(bool includeRemaining = true);
@@ -279,38 +281,18 @@ protected:
     QString getServiceName() const override;
 
 private slots:
-    /**
-     * @brief Process pending live region updates
-     */
-    void processPendingUpdates();
-
     /**
      * @brief Handle widget destruction
      * @param obj The destroyed widget
      */
     void onWidgetDestroyed(QObject* obj);
 
-    /**
-     * @brief Handle automatic time updates
-     */
-    void onTimeUpdateTimer();
-
 private:
     /**
-     * @brief Pending update item for throttling management
+     * @brief Put playback time strings into words for the current verbosity level
      */
-    struct PendingUpdate {
-        QWidget* widget;
-        QString content;
-        UpdateType updateType;
-        qint64 timestamp;
-        bool isCritical;
-
-        PendingUpdate() : widget(nullptr), updateType(UpdateType::GeneralStatus), timestamp(0), isCritical(false) {}
-        
-        PendingUpdate(QWidget* w, const QString& c, UpdateType t, bool critical = false)
-            : widget(w), content(c), updateType(t), timestamp(QDateTime::currentMSecsSinceEpoch()), isCritical(critical) {}
-    };
+    QString formatTimeInfo(const QString& currentTime, const QString& totalTime,
+                           const QString& remainingTime) const;
 
     /**
      * @brief Initialize live region management system
@@ -332,10 +314,17 @@ private:
     bool shouldThrottleUpdate(QWidget* widget, UpdateType updateType, bool isCritical) const;
 
     /**
-     * @brief Add an update to the pending queue
-     * @param update The update to add
+     * @brief Post a throttled update to AnnouncementBus, replacing any still waiting
+     * @param widget The widget to update
+     * @param content The content to announce
+     * @param updateType Type of update
      */
-    void addPendingUpdate(const PendingUpdate& update);
+    void addPendingUpdate(QWidget* widget, const QString& content, UpdateType updateType);
+
+    /**
+     * @brief AnnouncementBus region of a widget
+     */
+    static QString regionKey(const QWidget* widget);
 
     /**
      * @brief Process a single live region update
@@ -377,17 +366,9 @@ private:
      */
     void saveConfiguration();
 
-    /**
-     * @brief Clean up expired pending updates
-     */
-    void cleanupExpiredUpdates();
-
     // Member variables
     LiveRegionConfig m_config;
     QHash<QWidget*, LiveRegionInfo> m_liveRegions;
-    QQueue<PendingUpdate> m_pendingUpdates;
-    QTimer* m_updateTimer;
-    QTimer* m_timeUpdateTimer;
     QMutex m_updateMutex;
     
     // Service dependencies
@@ -410,8 +391,6 @@ private:
     static constexpr int DEFAULT_TIME_UPDATE_INTERVAL_MS = 5000;
     static constexpr int DEFAULT_COUNTDOWN_THRESHOLD_SECONDS = 30;
     static constexpr int MAX_PENDING_UPDATES_PER_REGION = 20;
-    static constexpr int UPDATE_PROCESSING_INTERVAL_MS = 200;
-    static constexpr int EXPIRED_UPDATE_CLEANUP_MS = 10000;
 };
 
 Q_DECLARE_METATYPE(LiveRegionManager::UpdateType)
@@ -0,0 +1,7 @@
+#include "LogCategories.h"
+
+// Debug is opt-in: these categories carry most of the main window's chatter
+Q_LOGGING_CATEGORY(xfbPlayer, "xfb.player", QtInfoMsg)
+Q_LOGGING_CATEGORY(xfbPlayback, "xfb.player.playback", QtInfoMsg)
+Q_LOGGING_CATEGORY(xfbScheduler, "xfb.player.scheduler", QtInfoMsg)
+Q_LOGGING_CATEGORY(xfbPlaylist, "xfb.player.playlist", QtInfoMsg)
@@ -0,0 +1,44 @@
+#ifndef LOGCATEGORIES_H
+#define LOGCATEGORIES_H
+
+#include <QLoggingCategory>
+
+/**
+ * @file LogCategories.h
+ * @brief Logging categories of the main window and the trace macro
+ *
+ * player.cpp logs through these categories rather than plain qDebug().
+ * qCDebug() checks whether its category is enabled before the message
+ * is built, so a disabled line costs one branch: none of the streamed
+ * values is converted and no string is allocated.
+ *
+ * Debug messages of the xfb.player categories are off by default. They
+ * are turned on at run time with the usual Qt rules, for example
+ * @code
+ * QT_LOGGING_RULES="xfb.player.playback.debug=true" ./XFB
+ * @endcode
+ *
+ * XFB_TRACE() is for lines on paths that run many times a second or once
+ * per item. It is qCDebug() in debug builds, and compiled out in release
+ * builds (NDEBUG) unless XFB_TRACE_LOGGING is defined, so those lines
+ * cost nothing at all when nobody can see them.
+ *
+ * Messages of the xfb.player categories also go to the log file once
+ * Logger::captureCategories() is called; ErrorHandler::initialize()
+ * does that.
+ *
+ * @since XFB 2.0
+ */
+
+Q_DECLARE_LOGGING_CATEGORY(xfbPlayer)     ///< "xfb.player": everything else in the main window
+Q_DECLARE_LOGGING_CATEGORY(xfbPlayback)   ///< "xfb.player.playback": decks, position, next track
+Q_DECLARE_LOGGING_CATEGORY(xfbScheduler)  ///< "xfb.player.scheduler": server scheduler, ingest
+Q_DECLARE_LOGGING_CATEGORY(xfbPlaylist)   ///< "xfb.player.playlist": playlist edits, files
+
+#if defined(NDEBUG) && !defined(XFB_TRACE_LOGGING)
+#define XFB_TRACE(category) while (false) QMessageLogger().noDebug()
+#else
+#define XFB_TRACE(category) qCDebug(category)
+#endif
+
+#endif // LOGCATEGORIES_H
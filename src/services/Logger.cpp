@@ -3,113 +3,168 @@
 #include <QFileInfo>
 #include <QStandardPaths>
 #include <QMutexLocker>
+#include <QDeadlineTimer>
 #include <QDebug>
-#include <QCoreApplication>
+#include <QThread>
 
 // Static constants
 const QString Logger::LOG_FILE_PREFIX = "xfb";
 const QString Logger::LOG_FILE_EXTENSION = ".log";
-const int Logger::MAINTENANCE_INTERVAL_MS = 60000; // 1 minute
+
+namespace {
+
+// flush() gives up waiting for the writer thread after this long
+constexpr int FLUSH_TIMEOUT_MS = 5000;
+
+// State of the Qt message handler installed by captureCategories()
+std::atomic<Logger*> s_captureLogger{nullptr};
+QtMessageHandler s_previousHandler = nullptr;
+QByteArray s_capturePrefix;
+
+Logger::LogLevel levelForMessage(QtMsgType type)
+{
+    switch (type) {
+    case QtWarningMsg:
+        return Logger::LogLevel::Warning;
+    case QtCriticalMsg:
+        return Logger::LogLevel::Error;
+    case QtFatalMsg:
+        return Logger::LogLevel::Critical;
+    default:
+        return Logger::LogLevel::Info;
+    }
+}
+
+void captureMessage(QtMsgType type, const QMessageLogContext& context, const QString& message)
+{
+    Logger* logger = s_captureLogger.load(std::memory_order_acquire);
+    if (logger && context.category &&
+        qstrncmp(context.category, s_capturePrefix.constData(), s_capturePrefix.size()) == 0) {
+        logger->writeLog(levelForMessage(type), QString::fromLatin1(context.category), message,
+                         "Qt");
+        if (type == QtFatalMsg) {
+            logger->flush();
+        }
+    }
+    if (s_previousHandler) {
+        s_previousHandler(type, context, message);
+    }
+}
+
+} // namespace
 
 Logger::Logger(QObject* parent)
     : QObject(parent)
+    , m_filePrefix(LOG_FILE_PREFIX)
+    , m_fileExtension(LOG_FILE_EXTENSION)
     , m_maxFiles(10)
     , m_maxSizeMB(10)
-    , m_minLevel(LogLevel::Info)
+    , m_minLevel(static_cast<int>(LogLevel::Info))
     , m_enabled(false)
-    , m_maintenanceTimer(new QTimer(this))
+    , m_head(&m_stub)
+    , m_tail(&m_stub)
 {
-    // Set up maintenance timer
-    m_maintenanceTimer->setInterval(MAINTENANCE_INTERVAL_MS);
-    m_maintenanceTimer->setSingleShot(false);
-    connect(m_maintenanceTimer, &QTimer::timeout, this, &Logger::performMaintenance);
 }
 
 Logger::~Logger()
 {
-    QMutexLocker locker(&m_mutex);
-    
+    Logger* self = this;
+    if (s_captureLogger.compare_exchange_strong(self, nullptr)) {
+        qInstallMessageHandler(s_previousHandler);
+    }
+
+    m_enabled = false;
+    stopWriter();
+
+    // Pushed after the writer stopped; nothing else reads the queue now
+    while (Entry* entry = pop()) {
+        delete entry;
+    }
+
     if (m_logStream) {
         m_logStream->flush();
         m_logStream.reset();
     }
-    
+
     if (m_logFile) {
         m_logFile->close();
         m_logFile.reset();
     }
-    
-    m_maintenanceTimer->stop();
 }
 
 bool Logger::initialize(const QString& logDirectory, int maxFiles, int maxSizeMB, LogLevel minLevel)
 {
-    QMutexLocker locker(&m_mutex);
-    
+    // The writer thread owns the file while it runs
+    m_enabled = false;
+    stopWriter();
+
     m_logDirectory = logDirectory;
     m_maxFiles = maxFiles;
     m_maxSizeMB = maxSizeMB;
-    m_minLevel = minLevel;
-    
+    m_minLevel = static_cast<int>(minLevel);
+
     if (!ensureLogDirectory()) {
         qWarning() << "Failed to create log directory:" << m_logDirectory;
         return false;
     }
-    
+
     if (!createNewLogFile()) {
         qWarning() << "Failed to create initial log file";
         return false;
     }
-    
-    m_enabled = true;
-    
-    // Only start timer if we have an event loop running
-    if (QCoreApplication::instance()) {
-        m_maintenanceTimer->start();
-    }
-    
-    // Write initialization message directly (avoid recursive mutex lock)
-    if (m_logStream && m_logFile && m_logFile->isOpen()) {
-        QString formattedMessage = formatMessage(LogLevel::Info, "Logger", "Logging system initialized", "System");
-        *m_logStream << formattedMessage << Qt::endl;
+
+    // Written before the writer starts, so the file is never empty
+    if (!m_plainLines && m_logStream && m_logFile && m_logFile->isOpen()) {
+        *m_logStream << formatMessage(LogLevel::Info, QDateTime::currentDateTime(), "Logger",
+                                      "Logging system initialized", "System")
+                     << '\n';
         m_logStream->flush();
     }
-    
+
+    m_writer = QThread::create([this]() { run(); });
+    m_writer->setObjectName("Logger");
+    m_writer->start(QThread::LowPriority);
+    m_enabled = true;
+
     return true;
 }
 
 void Logger::writeLog(LogLevel level, const QString& component, const QString& message, const QString& category)
 {
-    QMutexLocker locker(&m_mutex);
-    
-    if (!m_enabled || level < m_minLevel) {
+    if (!m_enabled.load(std::memory_order_acquire) ||
+        static_cast<int>(level) < m_minLevel.load(std::memory_order_relaxed)) {
         return;
     }
-    
-    if (!m_logStream) {
-        return;
-    }
-    
-    QString formattedMessage = formatMessage(level, component, message, category);
-    *m_logStream << formattedMessage << Qt::endl;
-    m_logStream->flush();
-    
-    // Check if rotation is needed (without holding the lock too long)
-    if (needsRotation()) {
-        // Schedule rotation for next maintenance cycle
-        QMetaObject::invokeMethod(this, &Logger::rotateIfNeeded, Qt::QueuedConnection);
+
+    // Only the timestamp is taken here; formatting happens on the writer thread
+    Entry* entry = new Entry;
+    entry->level = level;
+    entry->time = QDateTime::currentDateTime();
+    entry->component = component;
+    entry->message = message;
+    entry->category = category;
+    push(entry);
+    m_queued.fetch_add(1, std::memory_order_release);
+
+    if (level >= LogLevel::Error) {
+        wakeWriter();
     }
 }
 
 void Logger::setMinLevel(LogLevel level)
 {
-    QMutexLocker locker(&m_mutex);
-    m_minLevel = level;
+    m_minLevel = static_cast<int>(level);
+}
+
+void Logger::setFileNames(const QString& prefix, const QString& extension)
+{
+    m_filePrefix = prefix;
+    m_fileExtension = extension;
 }
 
 QString Logger::getCurrentLogFile() const
 {
-    QMutexLocker locker(&m_mutex);
+    QMutexLocker locker(&m_fileMutex);
     return m_currentLogFile;
 }
 
@@ -125,10 +180,32 @@ bool Logger::isEnabled() const
 
 void Logger::flush()
 {
-    QMutexLocker locker(&m_mutex);
-    if (m_logStream) {
-        m_logStream->flush();
+    if (!m_writer) {
+        return;
+    }
+
+    const quint64 target = m_queued.load(std::memory_order_acquire);
+    QDeadlineTimer deadline(FLUSH_TIMEOUT_MS);
+    QMutexLocker locker(&m_wakeMutex);
+    m_urgent = true;
+    m_wake.wakeOne();
+    while (m_flushed.load(std::memory_order_acquire) < target && !deadline.hasExpired()) {
+        m_flushDone.wait(&m_wakeMutex, deadline);
+    }
+}
+
+void Logger::captureCategories(const QString& categoryPrefix)
+{
+    // The prefix is set before the handler can see it, and never while another logger captures
+    Logger* expected = nullptr;
+    if (!s_captureLogger.compare_exchange_strong(expected, this)) {
+        if (expected != this) {
+            qWarning() << "Logger: another logger already captures Qt messages";
+        }
+        return;
     }
+    s_capturePrefix = categoryPrefix.toLatin1();
+    s_previousHandler = qInstallMessageHandler(captureMessage);
 }
 
 QString Logger::levelToString(LogLevel level)
@@ -148,43 +225,177 @@ QString Logger::levelToString(LogLevel level)
 
 void Logger::rotateIfNeeded()
 {
-    QMutexLocker locker(&m_mutex);
-    
+    m_rotateRequested = true;
+    wakeWriter();
+}
+
+void Logger::cleanupOldFiles()
+{
+    m_cleanupRequested = true;
+    wakeWriter();
+}
+
+void Logger::push(Entry* entry)
+{
+    entry->next.store(nullptr, std::memory_order_relaxed);
+    Entry* previous = m_head.exchange(entry, std::memory_order_acq_rel);
+    previous->next.store(entry, std::memory_order_release);
+}
+
+Logger::Entry* Logger::pop()
+{
+    Entry* tail = m_tail;
+    Entry* next = tail->next.load(std::memory_order_acquire);
+    if (tail == &m_stub) {
+        if (!next) {
+            return nullptr;
+        }
+        m_tail = next;
+        tail = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+    if (next) {
+        m_tail = next;
+        return tail;
+    }
+
+    // tail is the last entry, or a producer is between its two steps of push()
+    if (tail != m_head.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+    push(&m_stub);
+    next = tail->next.load(std::memory_order_acquire);
+    if (next) {
+        m_tail = next;
+        return tail;
+    }
+    return nullptr;
+}
+
+void Logger::run()
+{
+    m_sinceMaintenance.start();
+    for (;;) {
+        {
+            QMutexLocker locker(&m_wakeMutex);
+            if (!m_urgent && !m_stopping) {
+                m_wake.wait(&m_wakeMutex, FLUSH_INTERVAL_MS);
+            }
+        }
+        m_urgent = false;
+
+        writeQueued();
+        flushFile();
+
+        const bool maintenance = m_sinceMaintenance.hasExpired(MAINTENANCE_INTERVAL_MS);
+        if (maintenance) {
+            m_sinceMaintenance.restart();
+        }
+        if (m_rotateRequested.exchange(false) || maintenance) {
+            rotateFile();
+        }
+        if (m_cleanupRequested.exchange(false) || maintenance) {
+            removeOldFiles();
+        }
+
+        if (m_stopping && m_written >= m_queued.load(std::memory_order_acquire)) {
+            break;
+        }
+    }
+}
+
+quint64 Logger::writeQueued()
+{
+    quint64 taken = 0;
+    while (Entry* entry = pop()) {
+        if (m_logStream) {
+            const QString line =
+                m_plainLines ? entry->message
+                             : formatMessage(entry->level, entry->time, entry->component,
+                                             entry->message, entry->category);
+            *m_logStream << line << '\n';
+            m_unflushedBytes += line.size() + 1;
+        }
+        delete entry;
+        ++taken;
+        ++m_written;
+
+        if (m_unflushedBytes >= FLUSH_BYTES) {
+            flushFile();
+            rotateFile();
+        }
+    }
+    return taken;
+}
+
+void Logger::flushFile()
+{
+    if (m_logStream && m_unflushedBytes > 0) {
+        m_logStream->flush();
+    }
+    m_unflushedBytes = 0;
+
+    if (m_flushed.load(std::memory_order_relaxed) != m_written) {
+        QMutexLocker locker(&m_wakeMutex);
+        m_flushed.store(m_written, std::memory_order_release);
+        m_flushDone.wakeAll();
+    }
+}
+
+void Logger::stopWriter()
+{
+    if (!m_writer) {
+        return;
+    }
+    {
+        QMutexLocker locker(&m_wakeMutex);
+        m_stopping = true;
+        m_wake.wakeAll();
+    }
+    m_writer->wait();
+    delete m_writer;
+    m_writer = nullptr;
+    m_stopping = false;
+}
+
+void Logger::rotateFile()
+{
     if (!needsRotation()) {
         return;
     }
-    
+
     // Close current file
     if (m_logStream) {
         m_logStream->flush();
         m_logStream.reset();
     }
-    
+
     if (m_logFile) {
         m_logFile->close();
         m_logFile.reset();
     }
-    
+
     // Create new log file
-    if (createNewLogFile()) {
-        writeLog(LogLevel::Info, "Logger", "Log file rotated", "System");
+    if (createNewLogFile() && !m_plainLines) {
+        *m_logStream << formatMessage(LogLevel::Info, QDateTime::currentDateTime(), "Logger",
+                                      "Log file rotated", "System")
+                     << '\n';
+        m_logStream->flush();
     }
 }
 
-void Logger::cleanupOldFiles()
+void Logger::removeOldFiles()
 {
-    QMutexLocker locker(&m_mutex);
-    
     QDir logDir(m_logDirectory);
     if (!logDir.exists()) {
         return;
     }
-    
+
     // Get all log files
     QStringList filters;
-    filters << QString("%1*%2").arg(LOG_FILE_PREFIX, LOG_FILE_EXTENSION);
+    filters << QString("%1*%2").arg(m_filePrefix, m_fileExtension);
     QFileInfoList logFiles = logDir.entryInfoList(filters, QDir::Files, QDir::Time | QDir::Reversed);
-    
+
     // Remove excess files
     while (logFiles.size() > m_maxFiles) {
         QFileInfo oldestFile = logFiles.takeLast();
@@ -194,27 +405,32 @@ void Logger::cleanupOldFiles()
     }
 }
 
-void Logger::performMaintenance()
+void Logger::wakeWriter()
 {
-    rotateIfNeeded();
-    cleanupOldFiles();
+    // Without the mutex a wake can be missed; the writer then wakes on its interval
+    m_urgent = true;
+    m_wake.wakeOne();
 }
 
 bool Logger::createNewLogFile()
 {
     QString fileName = getNextLogFileName();
-    m_currentLogFile = QDir(m_logDirectory).absoluteFilePath(fileName);
-    
-    m_logFile = std::make_unique<QFile>(m_currentLogFile);
+    const QString path = QDir(m_logDirectory).absoluteFilePath(fileName);
+    {
+        QMutexLocker locker(&m_fileMutex);
+        m_currentLogFile = path;
+    }
+
+    m_logFile = std::make_unique<QFile>(path);
     if (!m_logFile->open(QIODevice::WriteOnly | QIODevice::Append)) {
-        qWarning() << "Failed to open log file:" << m_currentLogFile;
+        qWarning() << "Failed to open log file:" << path;
         m_logFile.reset();
         return false;
     }
-    
+
     m_logStream = std::make_unique<QTextStream>(m_logFile.get());
     m_logStream->setEncoding(QStringConverter::Utf8);
-    
+
     return true;
 }
 
@@ -223,11 +439,11 @@ bool Logger::needsRotation() const
     if (!m_logFile) {
         return false;
     }
-    
+
     // Check file size
     qint64 currentSize = m_logFile->size();
     qint64 maxSize = static_cast<qint64>(m_maxSizeMB) * 1024 * 1024;
-    
+
     return currentSize >= maxSize;
 }
 
@@ -235,14 +451,13 @@ QString Logger::getNextLogFileName() const
 {
     QDateTime now = QDateTime::currentDateTime();
     QString timestamp = now.toString("yyyyMMdd_hhmmss");
-    return QString("%1_%2%3").arg(LOG_FILE_PREFIX, timestamp, LOG_FILE_EXTENSION);
+    return QString("%1_%2%3").arg(m_filePrefix, timestamp, m_fileExtension);
 }
 
-QString Logger::formatMessage(LogLevel level, const QString& component, const QString& message, const QString& category) const
+QString Logger::formatMessage(LogLevel level, const QDateTime& time, const QString& component, const QString& message, const QString& category) const
 {
-    QDateTime now = QDateTime::currentDateTime();
-    QString timestamp = now.toString("yyyy-MM-dd hh:mm:ss.zzz");
-    
+    QString timestamp = time.toString("yyyy-MM-dd hh:mm:ss.zzz");
+
     return QString("[%1] [%2] [%3] [%4] %5")
            .arg(timestamp)
            .arg(levelToString(level), -5)  // Left-aligned, minimum 5 characters
@@ -255,4 +470,4 @@ bool Logger::ensureLogDirectory()
 {
     QDir dir;
     return dir.mkpath(m_logDirectory);
-}
\ No newline at end of file
+}
@@ -4,19 +4,32 @@
 #include <QObject>
 #include <QString>
 #include <QDateTime>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QTextStream>
 #include <QMutex>
-#include <QTimer>
+#include <QWaitCondition>
+#include <atomic>
 #include <memory>
 
+class QThread;
+
 /**
  * @brief File-based logging system with rotation and filtering
- * 
+ *
  * The Logger class provides thread-safe file logging with automatic
  * file rotation based on size and age. It supports different log levels
  * and categories for better organization of log messages.
- * 
+ *
+ * writeLog() does not touch the file. It puts the message on a lock-free
+ * queue that any number of threads may write to, and returns. A writer
+ * thread of the logger's own formats the queued messages and writes them
+ * in batches. The file is flushed once per batch, at least every
+ * FLUSH_INTERVAL_MS, or when FLUSH_BYTES are pending. Error and Critical
+ * messages wake the writer at once, so they reach the disk without
+ * waiting for the interval. Rotation and the removal of old files happen
+ * on the writer thread too.
+ *
  * @since XFB 2.0
  */
 class Logger : public QObject
@@ -34,6 +47,10 @@ public:
         Critical = 3
     };
 
+    static constexpr int FLUSH_INTERVAL_MS = 50;              ///< Longest a message waits for the disk
+    static constexpr qint64 FLUSH_BYTES = 64 * 1024;          ///< Flushed early past this much
+    static constexpr int MAINTENANCE_INTERVAL_MS = 60000;     ///< Rotation and cleanup check
+
     /**
      * @brief Constructor
      * @param parent Parent QObject
@@ -41,7 +58,7 @@ public:
     explicit Logger(QObject* parent = nullptr);
 
     /**
-     * @brief Destructor - ensures proper cleanup
+     * @brief Destructor - writes what is queued and stops the writer thread
      */
     ~Logger() override;
 
@@ -58,8 +75,32 @@ public:
                    int maxSizeMB = 10,
                    LogLevel minLevel = LogLevel::Info);
 
+    /**
+     * @brief Name the log files
+     *
+     * Call before initialize(). Files are named prefix_yyyyMMdd_hhmmss plus
+     * the extension, and only files with this prefix and extension count
+     * towards the limit on the number of files.
+     * @param prefix Start of the file names, "xfb" by default
+     * @param extension End of the file names, ".log" by default
+     */
+    void setFileNames(const QString& prefix, const QString& extension);
+
+    /**
+     * @brief Write each message as it is, one per line
+     *
+     * Call before initialize(). The timestamp, level, category and component
+     * columns are left out, and so are the logger's own lines about starting
+     * and rotating, so the file holds nothing but the messages. Used for
+     * files other programs read, such as EventJournal's JSON lines.
+     * @param plain true for plain lines
+     */
+    void setPlainLines(bool plain) { m_plainLines = plain; }
+
     /**
      * @brief Write a log message
+     *
+     * Queues the message and returns; never waits for the file or a lock.
      * @param level Log level
      * @param component Component generating the message
      * @param message Message text
@@ -95,10 +136,22 @@ public:
     bool isEnabled() const;
 
     /**
-     * @brief Flush any pending log messages to disk
+     * @brief Write every message queued so far to disk, and wait for it
      */
     void flush();
 
+    /**
+     * @brief Also write Qt messages of some logging categories to the file
+     *
+     * Installs a Qt message handler that queues the messages whose category
+     * name starts with @p categoryPrefix, then hands every message on to the
+     * handler installed before it, so the console still shows them. Debug
+     * messages are written as Info. Only one logger captures at a time; the
+     * handler is removed when that logger is destroyed.
+     * @param categoryPrefix Start of the category names to capture, e.g. "xfb.player"
+     */
+    void captureCategories(const QString& categoryPrefix);
+
     /**
      * @brief Convert log level to string
      * @param level Log level
@@ -109,21 +162,78 @@ public:
 public slots:
     /**
      * @brief Rotate log files if needed
+     *
+     * Returns at once; the writer thread rotates before its next batch.
      */
     void rotateIfNeeded();
 
     /**
      * @brief Clean up old log files
+     *
+     * Returns at once; the writer thread removes them before its next batch.
      */
     void cleanupOldFiles();
 
-private slots:
+private:
     /**
-     * @brief Periodic maintenance timer
+     * @brief A queued message; the queue links them through next
      */
-    void performMaintenance();
+    struct Entry {
+        std::atomic<Entry*> next{nullptr};
+        LogLevel level = LogLevel::Info;
+        QDateTime time;
+        QString component;
+        QString message;
+        QString category;
+    };
+
+    /**
+     * @brief Add an entry to the queue; safe from any thread
+     */
+    void push(Entry* entry);
+
+    /**
+     * @brief Take the oldest entry off the queue; writer thread only
+     * @return Entry to delete after use, or nullptr if none is ready
+     */
+    Entry* pop();
+
+    /**
+     * @brief Run the writer thread until the logger stops
+     */
+    void run();
+
+    /**
+     * @brief Write the queued entries to the file
+     * @return Entries taken off the queue
+     */
+    quint64 writeQueued();
+
+    /**
+     * @brief Flush the file and tell flush() how far it got
+     */
+    void flushFile();
+
+    /**
+     * @brief Stop the writer thread, writing what is queued
+     */
+    void stopWriter();
+
+    /**
+     * @brief Start a new file if the current one is full; writer thread only
+     */
+    void rotateFile();
+
+    /**
+     * @brief Remove the oldest files beyond the limit; writer thread only
+     */
+    void removeOldFiles();
+
+    /**
+     * @brief Wake the writer thread for an immediate batch
+     */
+    void wakeWriter();
 
-private:
     /**
      * @brief Create a new log file
      * @return true if successful
@@ -145,12 +255,14 @@ private:
     /**
      * @brief Format a log message
      * @param level Log level
+     * @param time When the message was logged
      * @param component Component name
      * @param message Message text
      * @param category Message category
      * @return Formatted log message
      */
     QString formatMessage(LogLevel level,
+                         const QDateTime& time,
                          const QString& component,
                          const QString& message,
                          const QString& category) const;
@@ -162,21 +274,41 @@ private:
     bool ensureLogDirectory();
 
     QString m_logDirectory;
-    QString m_currentLogFile;
-    std::unique_ptr<QFile> m_logFile;
-    std::unique_ptr<QTextStream> m_logStream;
-    
+    QString m_currentLogFile;                 ///< Guarded by m_fileMutex
+    std::unique_ptr<QFile> m_logFile;         ///< Writer thread once it runs
+    std::unique_ptr<QTextStream> m_logStream; ///< Writer thread once it runs
+
+    QString m_filePrefix;
+    QString m_fileExtension;
+    bool m_plainLines = false;
     int m_maxFiles;
     int m_maxSizeMB;
-    LogLevel m_minLevel;
-    bool m_enabled;
-    
-    mutable QMutex m_mutex;
-    QTimer* m_maintenanceTimer;
-    
+    std::atomic<int> m_minLevel;
+    std::atomic<bool> m_enabled;
+
+    // Vyukov's intrusive MPSC queue: producers swap m_head, the writer follows m_tail
+    std::atomic<Entry*> m_head;
+    Entry* m_tail;                             ///< Writer thread only
+    Entry m_stub;
+    std::atomic<quint64> m_queued{0};          ///< Entries pushed
+    std::atomic<quint64> m_flushed{0};         ///< Entries on disk
+
+    QThread* m_writer = nullptr;
+    std::atomic<bool> m_stopping{false};
+    std::atomic<bool> m_urgent{false};         ///< Write and flush without waiting
+    std::atomic<bool> m_rotateRequested{false};
+    std::atomic<bool> m_cleanupRequested{false};
+    QMutex m_wakeMutex;
+    QWaitCondition m_wake;                     ///< The writer sleeps on it between batches
+    QWaitCondition m_flushDone;                ///< flush() waits on it, with m_wakeMutex
+    qint64 m_unflushedBytes = 0;               ///< Writer thread only
+    quint64 m_written = 0;                     ///< Writer thread only
+    QElapsedTimer m_sinceMaintenance;          ///< Writer thread only
+
+    mutable QMutex m_fileMutex;
+
     static const QString LOG_FILE_PREFIX;
     static const QString LOG_FILE_EXTENSION;
-    static const int MAINTENANCE_INTERVAL_MS;
 };
 
-#endif // LOGGER_H
\ No newline at end of file
+#endif // LOGGER_H
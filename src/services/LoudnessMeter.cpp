@@ -0,0 +1,214 @@
+#include "LoudnessMeter.h"
+#include <cmath>
+#include <memory>
+
+namespace {
+
+constexpr int TABLE_TAPS = 12;
+constexpr int TABLE_PHASES = 4;
+
+// Coefficients of the true-peak interpolator, laid out [tap][phase] so the
+// four phases of one tap sit next to each other
+struct PolyphaseTable {
+    float coefficients[TABLE_TAPS][TABLE_PHASES];
+
+    PolyphaseTable()
+    {
+        // Hann-windowed sinc low-pass at the original Nyquist frequency
+        const int length = TABLE_TAPS * TABLE_PHASES;
+        const double centre = (length - 1) / 2.0;
+        double prototype[length];
+        double sum = 0.0;
+        for (int j = 0; j < length; ++j) {
+            const double t = (j - centre) / TABLE_PHASES;
+            const double sinc = t == 0.0 ? 1.0 : std::sin(M_PI * t) / (M_PI * t);
+            const double window = 0.5 - 0.5 * std::cos(2.0 * M_PI * (j + 1) / (length + 1));
+            prototype[j] = sinc * window;
+            sum += prototype[j];
+        }
+
+        // Output phase p of input n is the sum over k of h[4k + p] * x[n - k];
+        // the history window holds x[n - k] at index TAPS - 1 - k
+        for (int k = 0; k < TABLE_TAPS; ++k) {
+            for (int p = 0; p < TABLE_PHASES; ++p) {
+                coefficients[TABLE_TAPS - 1 - k][p] =
+                    static_cast<float>(prototype[k * TABLE_PHASES + p] * TABLE_PHASES / sum);
+            }
+        }
+    }
+};
+
+const PolyphaseTable& polyphaseTable()
+{
+    static const PolyphaseTable table;
+    return table;
+}
+
+double loudnessOf(double meanSquare)
+{
+    return -0.691 + 10.0 * std::log10(meanSquare);
+}
+
+} // namespace
+
+LoudnessMeter::LoudnessMeter(int sampleRate, int channels)
+    : m_sampleRate(qMax(1, sampleRate))
+    , m_channels(qMax(1, channels))
+    , m_state(m_channels)
+    , m_subBlockFrames(qMax<qint64>(1, m_sampleRate / 10))
+{
+    static_assert(TAPS_PER_PHASE == TABLE_TAPS && OVERSAMPLING == TABLE_PHASES,
+                  "The interpolator table does not match the meter");
+
+    // BS.1770 gives the coefficients for 48 kHz; these are the analogue
+    // prototypes they come from, so any rate gets the same response
+    const double rate = m_sampleRate;
+    double f0 = 1681.974450955533;
+    double gainDb = 3.999843853973347;
+    double q = 0.7071752369554196;
+    double k = std::tan(M_PI * f0 / rate);
+    const double vh = std::pow(10.0, gainDb / 20.0);
+    const double vb = std::pow(vh, 0.4996667741545416);
+    double a0 = 1.0 + k / q + k * k;
+    m_shelf.b0 = (vh + vb * k / q + k * k) / a0;
+    m_shelf.b1 = 2.0 * (k * k - vh) / a0;
+    m_shelf.b2 = (vh - vb * k / q + k * k) / a0;
+    m_shelf.a1 = 2.0 * (k * k - 1.0) / a0;
+    m_shelf.a2 = (1.0 - k / q + k * k) / a0;
+
+    f0 = 38.13547087602444;
+    q = 0.5003270373238773;
+    k = std::tan(M_PI * f0 / rate);
+    a0 = 1.0 + k / q + k * k;
+    m_highPass.b0 = 1.0;
+    m_highPass.b1 = -2.0;
+    m_highPass.b2 = 1.0;
+    m_highPass.a1 = 2.0 * (k * k - 1.0) / a0;
+    m_highPass.a2 = (1.0 - k / q + k * k) / a0;
+}
+
+void LoudnessMeter::feed(const float* samples, qint64 count)
+{
+    const qint64 frames = qMax<qint64>(0, count) / m_channels;
+    for (qint64 i = 0; i < frames; ++i) {
+        const float* frame = samples + i * m_channels;
+        for (int c = 0; c < m_channels; ++c) {
+            Channel& channel = m_state[c];
+            const float x = frame[c];
+            m_peak = qMax(m_peak, interpolatedPeak(channel, x));
+
+            const double weighted = filter(m_highPass, channel.highPass,
+                                           filter(m_shelf, channel.shelf, x));
+            m_subBlockEnergy += weighted * weighted;
+        }
+
+        if (++m_subBlockFill == m_subBlockFrames) {
+            closeSubBlock();
+        }
+    }
+    m_frames += frames;
+}
+
+LoudnessMeter::Result LoudnessMeter::result() const
+{
+    Result result;
+    result.valid = m_frames > 0;
+    result.durationMs = m_frames * 1000 / m_sampleRate;
+    result.truePeakDbtp = m_peak > 0.0f ? 20.0 * std::log10(m_peak) : result.truePeakDbtp;
+    if (m_blocks.isEmpty()) {
+        return result;
+    }
+
+    double sum = 0.0;
+    for (double block : m_blocks) {
+        sum += block;
+    }
+    // The relative gate sits RELATIVE_GATE_LU below the loudness of the absolute-gated blocks
+    const double relativeGate = sum / m_blocks.size() * std::pow(10.0, RELATIVE_GATE_LU / 10.0);
+
+    double gatedSum = 0.0;
+    int gated = 0;
+    for (double block : m_blocks) {
+        if (block > relativeGate) {
+            gatedSum += block;
+            ++gated;
+        }
+    }
+    if (gated == 0) {
+        return result;
+    }
+
+    result.audible = true;
+    result.integratedLufs = loudnessOf(gatedSum / gated);
+    return result;
+}
+
+LoudnessMeter::Result LoudnessMeter::analyzeFile(const QString& filePath, QString* error,
+                                                 int timeoutMs)
+{
+    std::unique_ptr<LoudnessMeter> meter;
+    const auto feed = [&](const float* samples, qint64 count, int sampleRate, int channels) {
+        if (!meter) {
+            meter = std::make_unique<LoudnessMeter>(sampleRate, channels);
+        }
+        meter->feed(samples, count);
+    };
+
+    if (!PcmDecoder::decode(filePath, ANALYSIS_SAMPLE_RATE, feed, error, timeoutMs)) {
+        return Result();
+    }
+    return meter->result();
+}
+
+double LoudnessMeter::filter(const Biquad& biquad, double* state, double x)
+{
+    // Transposed direct form II
+    const double y = biquad.b0 * x + state[0];
+    state[0] = biquad.b1 * x - biquad.a1 * y + state[1];
+    state[1] = biquad.b2 * x - biquad.a2 * y;
+    return y;
+}
+
+float LoudnessMeter::interpolatedPeak(Channel& channel, float x) const
+{
+    // Each sample is stored twice so the last TAPS_PER_PHASE of them are
+    // always one contiguous window, oldest first
+    channel.historyPos = (channel.historyPos + 1) % TAPS_PER_PHASE;
+    channel.history[channel.historyPos] = x;
+    channel.history[channel.historyPos + TAPS_PER_PHASE] = x;
+    const float* window = channel.history + channel.historyPos + 1;
+
+    const PolyphaseTable& table = polyphaseTable();
+    float phases[OVERSAMPLING] = {};
+    for (int k = 0; k < TAPS_PER_PHASE; ++k) {
+        for (int p = 0; p < OVERSAMPLING; ++p) {
+            phases[p] += table.coefficients[k][p] * window[k];
+        }
+    }
+
+    float peak = std::fabs(x);
+    for (int p = 0; p < OVERSAMPLING; ++p) {
+        peak = qMax(peak, std::fabs(phases[p]));
+    }
+    return peak;
+}
+
+void LoudnessMeter::closeSubBlock()
+{
+    m_recent[m_subBlocks % SUB_BLOCKS_PER_BLOCK] = m_subBlockEnergy / m_subBlockFill;
+    ++m_subBlocks;
+    m_subBlockEnergy = 0.0;
+    m_subBlockFill = 0;
+
+    if (m_subBlocks < SUB_BLOCKS_PER_BLOCK) {
+        return;
+    }
+    double block = 0.0;
+    for (double subBlock : m_recent) {
+        block += subBlock;
+    }
+    block /= SUB_BLOCKS_PER_BLOCK;
+    if (block > 0.0 && loudnessOf(block) > ABSOLUTE_GATE_LUFS) {
+        m_blocks.append(block);
+    }
+}
@@ -0,0 +1,135 @@
+#include "LoudnessScanner.h"
+#include "BackgroundThrottle.h"
+#include "ReplayGainStore.h"
+#include <QDebug>
+#include <QFutureWatcher>
+#include <QSet>
+#include <QThread>
+#include <QtConcurrent/QtConcurrent>
+
+LoudnessScanner::LoudnessScanner(ReplayGainStore* store, QObject* parent)
+    : QObject(parent)
+    , m_store(store)
+    , m_analyze([](const QString& filePath, QString* error) {
+        return LoudnessMeter::analyzeFile(filePath, error);
+    })
+    , m_maxWorkers(qMax(1, QThread::idealThreadCount() - 1))
+{
+    m_pool.setThreadPriority(QThread::LowPriority);
+    m_pool.setMaxThreadCount(m_maxWorkers);
+}
+
+LoudnessScanner::~LoudnessScanner()
+{
+    m_queue.clear();
+    m_pool.waitForDone();
+}
+
+void LoudnessScanner::setMaxWorkers(int workers)
+{
+    m_maxWorkers = qMax(1, workers);
+    m_pool.setMaxThreadCount(m_maxWorkers);
+    schedule();
+}
+
+int LoudnessScanner::scan(const QStringList& filePaths)
+{
+    const QSet<QString> waiting(m_queue.cbegin(), m_queue.cend());
+    int added = 0;
+    for (const QString& filePath : filePaths) {
+        if (filePath.isEmpty() || waiting.contains(filePath)) {
+            continue;
+        }
+        m_queue.append(filePath);
+        ++added;
+    }
+    if (added == 0) {
+        return 0;
+    }
+
+    m_total += added;
+    m_running = true;
+    schedule();
+    return added;
+}
+
+void LoudnessScanner::cancel()
+{
+    if (!m_running) {
+        return;
+    }
+
+    m_queue.clear();
+    ++m_generation;
+    m_inFlight = 0;
+    finish();
+}
+
+void LoudnessScanner::schedule()
+{
+    while (m_running && m_inFlight < m_maxWorkers && !m_queue.isEmpty()) {
+        const QString filePath = m_queue.takeFirst();
+        ++m_inFlight;
+
+        auto* watcher = new QFutureWatcher<Outcome>(this);
+        const int generation = m_generation;
+        connect(watcher, &QFutureWatcher<Outcome>::finished, this, [this, watcher, generation]() {
+            onMeasured(watcher->result(), generation);
+            watcher->deleteLater();
+        });
+        watcher->setFuture(QtConcurrent::run(&m_pool, [analyze = m_analyze, filePath]() {
+            BackgroundThrottle::lowerCurrentThread();
+            BackgroundThrottle::pace();
+            Outcome outcome;
+            outcome.filePath = filePath;
+            outcome.result = analyze(filePath, &outcome.error);
+            return outcome;
+        }));
+    }
+}
+
+void LoudnessScanner::onMeasured(const Outcome& outcome, int generation)
+{
+    if (generation != m_generation) {
+        return;
+    }
+    --m_inFlight;
+
+    if (outcome.result.valid) {
+        if (m_store && outcome.result.audible) {
+            m_store->setLoudness(outcome.filePath, outcome.result.integratedLufs,
+                                 outcome.result.truePeakDbtp);
+        } else if (m_store) {
+            m_store->clear(outcome.filePath);
+        }
+        ++m_measured;
+        emit trackMeasured(outcome.filePath, outcome.result);
+    } else {
+        ++m_failed;
+        qWarning() << QString("LoudnessScanner::onMeasured - %1: %2")
+                          .arg(outcome.filePath, outcome.error);
+    }
+    emit progressChanged(m_measured + m_failed, m_total);
+
+    if (m_queue.isEmpty() && m_inFlight == 0) {
+        finish();
+    } else {
+        schedule();
+    }
+}
+
+void LoudnessScanner::finish()
+{
+    const int measured = m_measured;
+    const int failed = m_failed;
+    m_running = false;
+    m_total = 0;
+    m_measured = 0;
+    m_failed = 0;
+
+    if (m_store) {
+        m_store->flush();
+    }
+    qInfo() << "LoudnessScanner: scan finished," << measured << "measured," << failed << "failed";
+    emit finished(measured, failed);
+}
@@ -0,0 +1,120 @@
+#ifndef LOUDNESSSCANNER_H
+#define LOUDNESSSCANNER_H
+
+#include "LoudnessMeter.h"
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <functional>
+
+class ReplayGainStore;
+
+/**
+ * @brief Measures the loudness of many tracks in parallel
+ *
+ * LoudnessScanner runs LoudnessMeter::analyzeFile() for a list of library
+ * tracks on its own low-priority thread pool, with up to maxWorkers() files
+ * decoding at once. By default that leaves one core for on-air playback.
+ * Results come back on the scanner's thread and are handed to the
+ * ReplayGainStore, which writes them to the musics table in batches.
+ * Tracks that are silent throughout have their measurement cleared, so
+ * they are never boosted.
+ *
+ * Only maxWorkers() files are handed to the pool at a time, so cancel()
+ * takes effect after the files being decoded are done; their results are
+ * dropped.
+ *
+ * @example
+ * @code
+ * LoudnessScanner* scanner = new LoudnessScanner(replayGain, this);
+ * connect(scanner, &LoudnessScanner::finished, this, [](int measured, int failed) {
+ *     qDebug() << measured << "tracks measured," << failed << "could not be decoded";
+ * });
+ * scanner->scan(allLibraryPaths);
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class LoudnessScanner : public QObject
+{
+    Q_OBJECT
+
+public:
+    /// Runs on a pool thread; LoudnessMeter::analyzeFile() unless replaced
+    using Analyzer = std::function<LoudnessMeter::Result(const QString& filePath, QString* error)>;
+
+    explicit LoudnessScanner(ReplayGainStore* store, QObject* parent = nullptr);
+    ~LoudnessScanner() override;
+
+    /**
+     * @brief Set how many files are decoded at once
+     * @param workers Worker count; one less than the number of cores by default
+     */
+    void setMaxWorkers(int workers);
+    int maxWorkers() const { return m_maxWorkers; }
+
+    void setAnalyzer(Analyzer analyzer) { m_analyze = std::move(analyzer); }
+
+    /**
+     * @brief Add tracks to the scan and start it if it is not running
+     * @param filePaths Paths as stored in the musics table
+     * @return Number of tracks added; tracks already waiting are skipped
+     */
+    int scan(const QStringList& filePaths);
+
+    /**
+     * @brief Drop the tracks that have not been started
+     */
+    void cancel();
+
+    bool isRunning() const { return m_running; }
+
+signals:
+    /**
+     * @brief Emitted when a track's measurement was stored
+     * @param filePath Path of the track
+     * @param result What was measured
+     */
+    void trackMeasured(const QString& filePath, const LoudnessMeter::Result& result);
+
+    /**
+     * @brief Emitted after each track
+     * @param done Tracks finished, including those that failed
+     * @param total Tracks in this scan
+     */
+    void progressChanged(int done, int total);
+
+    /**
+     * @brief Emitted when the last track of the scan is done, or after cancel()
+     * @param measured Tracks whose loudness was stored
+     * @param failed Tracks that could not be decoded
+     */
+    void finished(int measured, int failed);
+
+private:
+    struct Outcome {
+        QString filePath;
+        LoudnessMeter::Result result;
+        QString error;
+    };
+
+    void schedule();
+    void onMeasured(const Outcome& outcome, int generation);
+    void finish();
+
+    ReplayGainStore* m_store;
+    QThreadPool m_pool;
+    Analyzer m_analyze;
+    int m_maxWorkers;
+
+    QStringList m_queue;
+    bool m_running = false;
+    int m_inFlight = 0;
+    int m_generation = 0;   ///< Bumped by cancel() so late results are dropped
+    int m_total = 0;
+    int m_measured = 0;
+    int m_failed = 0;
+};
+
+#endif // LOUDNESSSCANNER_H
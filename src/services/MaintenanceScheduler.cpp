@@ -0,0 +1,234 @@
+#include "MaintenanceScheduler.h"
+#include "SchedulerEngine.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <algorithm>
+
+MaintenanceScheduler::MaintenanceScheduler(QSqlDatabase& database, QObject* parent)
+    : QObject(parent)
+    , m_database(database)
+{
+    m_timer.setInterval(DEFAULT_INTERVAL_MS);
+    connect(&m_timer, &QTimer::timeout, this, [this]() { runSlice(); });
+}
+
+void MaintenanceScheduler::setSchedulerEngine(SchedulerEngine* scheduler)
+{
+    m_scheduler = scheduler;
+}
+
+void MaintenanceScheduler::setSliceBudget(int budgetMs)
+{
+    m_sliceBudgetMs = std::max(1, budgetMs);
+}
+
+void MaintenanceScheduler::setInterval(int intervalMs)
+{
+    m_timer.setInterval(std::max(1, intervalMs));
+}
+
+bool MaintenanceScheduler::start()
+{
+    if (!m_database.isOpen()) {
+        logError("start", "Database is not open");
+        return false;
+    }
+
+    QSqlQuery query(m_database);
+    if (!query.exec(QString("PRAGMA analysis_limit = %1").arg(ANALYSIS_LIMIT))) {
+        logError("start", QString("SQL Error: %1").arg(query.lastError().text()), query.lastQuery());
+    }
+
+    int autoVacuum = 0;
+    if (pragmaValue("auto_vacuum", autoVacuum) && autoVacuum != 2) {
+        // Takes effect right away on an empty database, otherwise at the next full VACUUM
+        if (!query.exec("PRAGMA auto_vacuum = INCREMENTAL")) {
+            logError("start", QString("SQL Error: %1").arg(query.lastError().text()), query.lastQuery());
+        }
+    }
+
+    m_timer.start();
+    return true;
+}
+
+void MaintenanceScheduler::stop()
+{
+    m_timer.stop();
+}
+
+bool MaintenanceScheduler::runSlice(const QDateTime& now)
+{
+    const QDateTime blocker = blockingEvent(now);
+    if (blocker.isValid()) {
+        ++m_stats.slicesSkipped;
+        emit sliceSkipped(blocker);
+        return false;
+    }
+
+    if (!m_database.isOpen()) {
+        logError("runSlice", "Database is not open");
+        return false;
+    }
+
+    const Task task = m_nextTask;
+    QElapsedTimer timer;
+    timer.start();
+
+    switch (task) {
+    case Task::IncrementalVacuum:
+        vacuumSlice(timer);
+        m_nextTask = Task::Optimize;
+        break;
+    case Task::Optimize:
+        optimizeSlice();
+        m_nextTask = Task::Analyze;
+        break;
+    case Task::Analyze:
+        // Stay on ANALYZE until every table has been visited once
+        if (analyzeSlice(timer)) {
+            m_nextTask = Task::IncrementalVacuum;
+        }
+        break;
+    }
+
+    const qint64 elapsed = timer.elapsed();
+    ++m_stats.slicesRun;
+    m_stats.lastSliceMs = elapsed;
+    m_stats.longestSliceMs = std::max(m_stats.longestSliceMs, elapsed);
+
+    qDebug() << "MaintenanceScheduler:" << taskName(task) << "slice took" << elapsed << "ms";
+    emit sliceCompleted(taskName(task), elapsed);
+    return true;
+}
+
+QDateTime MaintenanceScheduler::blockingEvent(const QDateTime& now) const
+{
+    if (!m_scheduler) {
+        return QDateTime();
+    }
+
+    // Leave room for the slice itself as well as the guard time
+    const QDateTime until = now.addSecs(AIR_GUARD_SECS).addMSecs(m_sliceBudgetMs);
+    const QList<ScheduledEvent> upcoming = m_scheduler->upcomingEvents(now, until);
+    return upcoming.isEmpty() ? QDateTime() : upcoming.first().fireAt;
+}
+
+QString MaintenanceScheduler::taskName(Task task)
+{
+    switch (task) {
+    case Task::IncrementalVacuum:
+        return "incremental_vacuum";
+    case Task::Optimize:
+        return "optimize";
+    case Task::Analyze:
+        return "analyze";
+    }
+    return QString();
+}
+
+void MaintenanceScheduler::vacuumSlice(const QElapsedTimer& timer)
+{
+    int autoVacuum = 0;
+    int freePages = 0;
+    if (!pragmaValue("auto_vacuum", autoVacuum) || autoVacuum != 2
+        || !pragmaValue("freelist_count", freePages) || freePages == 0) {
+        return; // Not in incremental mode yet, or nothing to reclaim
+    }
+
+    // The pragma frees one page per step, and QSqlQuery steps a statement
+    // without result columns only once, so run it once per page. A single
+    // transaction keeps that from costing a commit per page.
+    const bool ownTransaction = m_database.transaction();
+    QSqlQuery query(m_database);
+    query.prepare("PRAGMA incremental_vacuum(1)");
+
+    int freed = 0;
+    bool failed = false;
+    while (!failed && freed < freePages && !timer.hasExpired(m_sliceBudgetMs)) {
+        for (int i = 0; i < VACUUM_PAGES_PER_STEP && freed < freePages; ++i) {
+            if (!query.exec()) {
+                QString error = QString("SQL Error: %1").arg(query.lastError().text());
+                logError("vacuumSlice", error, query.lastQuery());
+                emit operationError("vacuumSlice", error);
+                failed = true;
+                break;
+            }
+            ++freed;
+        }
+    }
+    query.finish();
+
+    if (ownTransaction && !m_database.commit()) {
+        logError("vacuumSlice", QString("Failed to commit: %1").arg(m_database.lastError().text()));
+        m_database.rollback();
+    }
+}
+
+void MaintenanceScheduler::optimizeSlice()
+{
+    QSqlQuery query(m_database);
+    if (!query.exec("PRAGMA optimize")) {
+        QString error = QString("SQL Error: %1").arg(query.lastError().text());
+        logError("optimizeSlice", error, query.lastQuery());
+        emit operationError("optimizeSlice", error);
+    }
+}
+
+bool MaintenanceScheduler::analyzeSlice(const QElapsedTimer& timer)
+{
+    QSqlQuery query(m_database);
+
+    if (m_analyzeQueue.isEmpty()) {
+        query.setForwardOnly(true);
+        if (!query.exec("SELECT name FROM sqlite_master WHERE type = 'table' "
+                        "AND name NOT LIKE 'sqlite_%' AND sql NOT LIKE 'CREATE VIRTUAL TABLE%' "
+                        "ORDER BY name")) {
+            QString error = QString("SQL Error: %1").arg(query.lastError().text());
+            logError("analyzeSlice", error, query.lastQuery());
+            emit operationError("analyzeSlice", error);
+            return true;
+        }
+        while (query.next()) {
+            m_analyzeQueue.append(query.value(0).toString());
+        }
+        query.finish();
+    }
+
+    // Always analyze at least one table so a slice never ends without progress
+    do {
+        if (m_analyzeQueue.isEmpty()) {
+            break;
+        }
+        const QString table = m_analyzeQueue.takeFirst();
+        QString quoted = table;
+        quoted.replace('"', "\"\"");
+        if (!query.exec(QString("ANALYZE \"%1\"").arg(quoted))) {
+            logError("analyzeSlice", QString("SQL Error: %1").arg(query.lastError().text()), query.lastQuery());
+        }
+    } while (!timer.hasExpired(m_sliceBudgetMs));
+
+    return m_analyzeQueue.isEmpty();
+}
+
+bool MaintenanceScheduler::pragmaValue(const QString& pragma, int& value)
+{
+    QSqlQuery query(m_database);
+    if (!query.exec(QString("PRAGMA %1").arg(pragma)) || !query.next()) {
+        logError("pragmaValue", QString("SQL Error: %1").arg(query.lastError().text()), query.lastQuery());
+        return false;
+    }
+    value = query.value(0).toInt();
+    return true;
+}
+
+void MaintenanceScheduler::logError(const QString& operation, const QString& error, const QString& query)
+{
+    QString logMessage = QString("MaintenanceScheduler::%1 - %2").arg(operation, error);
+    if (!query.isEmpty()) {
+        logMessage += QString(" (Query: %1)").arg(query);
+    }
+
+    qWarning() << logMessage;
+}
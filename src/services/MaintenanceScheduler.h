@@ -0,0 +1,185 @@
+#ifndef MAINTENANCESCHEDULER_H
+#define MAINTENANCESCHEDULER_H
+
+#include <QDateTime>
+#include <QObject>
+#include <QPointer>
+#include <QSqlDatabase>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+
+class QElapsedTimer;
+class SchedulerEngine;
+
+/**
+ * @brief Runs database upkeep in short, time-boxed slices
+ *
+ * Instead of a whole-database VACUUM or ANALYZE on a fixed timer,
+ * MaintenanceScheduler does a little work every interval and stops as soon
+ * as the slice budget is spent. Slices rotate between three tasks:
+ *
+ * - IncrementalVacuum: PRAGMA incremental_vacuum, checking the clock every
+ *   VACUUM_PAGES_PER_STEP pages, for databases in auto_vacuum=INCREMENTAL mode
+ * - Optimize: PRAGMA optimize
+ * - Analyze: ANALYZE one table after another, resuming where the previous
+ *   slice stopped
+ *
+ * ANALYZE and PRAGMA optimize run under PRAGMA analysis_limit, so no single
+ * statement scans a whole large table. When a SchedulerEngine is attached,
+ * no slice starts within AIR_GUARD_SECS of a scheduled pub or program.
+ * Every slice reports how long it took through sliceCompleted().
+ *
+ * @example
+ * @code
+ * MaintenanceScheduler maintenance(db);
+ * maintenance.setSchedulerEngine(scheduler);
+ * connect(&maintenance, &MaintenanceScheduler::sliceCompleted, this,
+ *         [](const QString& task, qint64 ms) { qDebug() << task << "took" << ms << "ms"; });
+ * maintenance.start();
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class MaintenanceScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class Task {
+        IncrementalVacuum,
+        Optimize,
+        Analyze
+    };
+
+    /**
+     * @brief Slice counters
+     */
+    struct Statistics {
+        int slicesRun = 0;         ///< Slices that did work
+        int slicesSkipped = 0;     ///< Slices skipped because something was about to go on air
+        qint64 lastSliceMs = 0;    ///< Duration of the most recent slice
+        qint64 longestSliceMs = 0; ///< Longest slice so far
+    };
+
+    static constexpr int DEFAULT_INTERVAL_MS = 5 * 60 * 1000;
+    static constexpr int DEFAULT_SLICE_BUDGET_MS = 50;
+    /// No slice starts this close to a scheduled pub or program
+    static constexpr int AIR_GUARD_SECS = 120;
+    /// Pages freed between checks of the slice budget
+    static constexpr int VACUUM_PAGES_PER_STEP = 32;
+    /// Rows per index sampled by ANALYZE and PRAGMA optimize
+    static constexpr int ANALYSIS_LIMIT = 400;
+
+    explicit MaintenanceScheduler(QSqlDatabase& database, QObject* parent = nullptr);
+
+    /**
+     * @brief Attach the scheduler whose upcoming events block maintenance
+     * @param scheduler Scheduler, or nullptr to run regardless of the schedule
+     */
+    void setSchedulerEngine(SchedulerEngine* scheduler);
+
+    /**
+     * @brief Set the time budget of one slice
+     * @param budgetMs Milliseconds of work per slice
+     */
+    void setSliceBudget(int budgetMs);
+
+    /**
+     * @brief Get the time budget of one slice
+     * @return Milliseconds of work per slice
+     */
+    int sliceBudget() const { return m_sliceBudgetMs; }
+
+    /**
+     * @brief Set the time between slices
+     * @param intervalMs Interval in milliseconds
+     */
+    void setInterval(int intervalMs);
+
+    /**
+     * @brief Prepare the connection and start running slices
+     *
+     * Switches the database to auto_vacuum=INCREMENTAL. An existing
+     * database only changes mode at its next full VACUUM; until then the
+     * vacuum task has nothing to do.
+     * @return true if the database is open
+     */
+    bool start();
+
+    /**
+     * @brief Stop running slices
+     */
+    void stop();
+
+    /**
+     * @brief Check if slices are being run
+     * @return true between start() and stop()
+     */
+    bool isRunning() const { return m_timer.isActive(); }
+
+    /**
+     * @brief Run the next slice now unless something is about to go on air
+     * @param now Current time, used to look up upcoming events
+     * @return true if the slice ran
+     */
+    bool runSlice(const QDateTime& now = QDateTime::currentDateTime());
+
+    /**
+     * @brief Find the first scheduled event that blocks a slice started now
+     * @param now Current time
+     * @return Firing time of the event, or an invalid QDateTime if a slice may run
+     */
+    QDateTime blockingEvent(const QDateTime& now) const;
+
+    /**
+     * @brief Get slice counters
+     * @return Current statistics
+     */
+    Statistics statistics() const { return m_stats; }
+
+    /**
+     * @brief Get the name a task is reported under
+     * @param task Task
+     * @return Task name
+     */
+    static QString taskName(Task task);
+
+signals:
+    /**
+     * @brief Emitted after each slice that ran
+     * @param task Name of the task the slice worked on
+     * @param elapsedMs Time the slice took
+     */
+    void sliceCompleted(const QString& task, qint64 elapsedMs);
+
+    /**
+     * @brief Emitted when a slice is skipped for an upcoming event
+     * @param eventTime Firing time of the event that blocked the slice
+     */
+    void sliceSkipped(const QDateTime& eventTime);
+
+    /**
+     * @brief Emitted when a database operation fails
+     * @param operation Name of the operation
+     * @param error Error message
+     */
+    void operationError(const QString& operation, const QString& error);
+
+private:
+    void vacuumSlice(const QElapsedTimer& timer);
+    void optimizeSlice();
+    bool analyzeSlice(const QElapsedTimer& timer);
+    bool pragmaValue(const QString& pragma, int& value);
+    void logError(const QString& operation, const QString& error, const QString& query = QString());
+
+    QSqlDatabase& m_database;
+    QPointer<SchedulerEngine> m_scheduler;
+    QTimer m_timer;
+    int m_sliceBudgetMs = DEFAULT_SLICE_BUDGET_MS;
+    Task m_nextTask = Task::IncrementalVacuum;
+    QStringList m_analyzeQueue;
+    Statistics m_stats;
+};
+
+#endif // MAINTENANCESCHEDULER_H
@@ -0,0 +1,139 @@
+#include "MappedWav.h"
+#include <QtEndian>
+#include <cstring>
+
+#ifdef Q_OS_UNIX
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr quint16 FORMAT_PCM = 0x0001;
+constexpr quint16 FORMAT_FLOAT = 0x0003;
+constexpr quint16 FORMAT_EXTENSIBLE = 0xFFFE;
+
+QAudioFormat::SampleFormat sampleFormat(quint16 code, int bits)
+{
+    if (code == FORMAT_PCM) {
+        switch (bits) {
+        case 8:
+            return QAudioFormat::UInt8;
+        case 16:
+            return QAudioFormat::Int16;
+        case 32:
+            return QAudioFormat::Int32;
+        default:
+            return QAudioFormat::Unknown;
+        }
+    }
+    return code == FORMAT_FLOAT && bits == 32 ? QAudioFormat::Float : QAudioFormat::Unknown;
+}
+
+} // namespace
+
+bool MappedWav::open(const QString& filePath)
+{
+    close();
+
+    m_file.setFileName(filePath);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const qint64 size = m_file.size();
+    const uchar* base = size > 12 ? m_file.map(0, size) : nullptr;
+    if (!base || !parse(base, size)) {
+        close();
+        return false;
+    }
+    m_base = base;
+
+#ifdef Q_OS_UNIX
+    madvise(const_cast<uchar*>(m_base), size_t(size), MADV_SEQUENTIAL);
+#endif
+    return true;
+}
+
+void MappedWav::close()
+{
+    m_file.close();
+    m_base = nullptr;
+    m_data = nullptr;
+    m_format = QAudioFormat();
+    m_frameBytes = 0;
+    m_frames = 0;
+    m_advisedUntil = 0;
+}
+
+bool MappedWav::parse(const uchar* base, qint64 size)
+{
+    if (memcmp(base, "RIFF", 4) != 0 || memcmp(base + 8, "WAVE", 4) != 0) {
+        return false;
+    }
+
+    // Chunks are word aligned; fmt comes before data, anything else is skipped
+    bool haveFormat = false;
+    qint64 offset = 12;
+    while (offset + 8 <= size) {
+        const uchar* chunk = base + offset;
+        const qint64 chunkSize = qFromLittleEndian<quint32>(chunk + 4);
+        const qint64 body = offset + 8;
+
+        if (memcmp(chunk, "fmt ", 4) == 0) {
+            if (chunkSize < 16 || body + chunkSize > size) {
+                return false;
+            }
+            quint16 code = qFromLittleEndian<quint16>(chunk + 8);
+            const int channels = qFromLittleEndian<quint16>(chunk + 10);
+            const int sampleRate = qFromLittleEndian<quint32>(chunk + 12);
+            const int blockAlign = qFromLittleEndian<quint16>(chunk + 20);
+            const int bits = qFromLittleEndian<quint16>(chunk + 22);
+            // The subformat GUID starts with the format code
+            if (code == FORMAT_EXTENSIBLE && chunkSize >= 40) {
+                code = qFromLittleEndian<quint16>(chunk + 32);
+            }
+            const QAudioFormat::SampleFormat format = sampleFormat(code, bits);
+            if (format == QAudioFormat::Unknown || channels < 1 || sampleRate < 1
+                || blockAlign != channels * bits / 8) {
+                return false;
+            }
+            m_format.setSampleFormat(format);
+            m_format.setChannelCount(channels);
+            m_format.setSampleRate(sampleRate);
+            m_frameBytes = blockAlign;
+            haveFormat = true;
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            if (!haveFormat) {
+                return false;
+            }
+            m_data = reinterpret_cast<const char*>(chunk + 8);
+            m_frames = qMin(chunkSize, size - body) / m_frameBytes;
+            m_advisedUntil = body;
+            return true;
+        }
+        offset = body + chunkSize + (chunkSize & 1);
+    }
+    return false;
+}
+
+void MappedWav::adviseAhead(qint64 frame, qint64 frames)
+{
+    if (!isOpen()) {
+        return;
+    }
+    const qint64 dataOffset = reinterpret_cast<const uchar*>(m_data) - m_base;
+    const qint64 until = dataOffset + qMin(frame + frames, m_frames) * m_frameBytes;
+    if (until <= m_advisedUntil) {
+        return;
+    }
+
+#ifdef Q_OS_UNIX
+    // madvise() wants a page aligned start
+    static const qint64 pageSize = sysconf(_SC_PAGESIZE);
+    const qint64 start = qMax(m_advisedUntil, dataOffset + frame * m_frameBytes);
+    const qint64 alignedStart = start - start % pageSize;
+    madvise(const_cast<uchar*>(m_base) + alignedStart, size_t(until - alignedStart),
+            MADV_WILLNEED);
+#endif
+    m_advisedUntil = until;
+}
@@ -0,0 +1,95 @@
+#ifndef MAPPEDWAV_H
+#define MAPPEDWAV_H
+
+#include <QFile>
+#include <QString>
+#include <QtMultimedia/QAudioFormat>
+
+/**
+ * @brief A WAV file's samples, mapped into memory
+ *
+ * Carts, long WAV programs and the copies of TranscodeCache went through
+ * QAudioDecoder like everything else: the file was read into the
+ * backend's buffers and each buffer copied into a QAudioBuffer before
+ * AudioDeck converted it. MappedWav parses the RIFF header, maps the file
+ * and hands out pointers into its data chunk, so the deck converts the
+ * samples straight from the page cache.
+ *
+ * The whole mapping is advised as read sequentially, and adviseAhead()
+ * asks the kernel to read the next part in while the current one plays,
+ * so the reader does not wait on page faults.
+ *
+ * 8-bit, 16-bit and 32-bit integer PCM and 32-bit float are mapped, in
+ * plain and WAVE_FORMAT_EXTENSIBLE files; open() fails for any other
+ * file, such as 24-bit PCM or RF64, which the decoder still plays. A data
+ * chunk that claims more than the file holds, as files whose writer was
+ * stopped do, is cut to what is there.
+ *
+ * @example
+ * @code
+ * MappedWav wav;
+ * if (wav.open(path)) {
+ *     wav.adviseAhead(0, wav.format().sampleRate() * 10);
+ *     convert(wav.frameData(0), wav.frames(), wav.format());
+ * }
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class MappedWav
+{
+public:
+    MappedWav() = default;
+    ~MappedWav() { close(); }
+
+    MappedWav(const MappedWav&) = delete;
+    MappedWav& operator=(const MappedWav&) = delete;
+
+    /**
+     * @brief Map a WAV file
+     * @param filePath Path of the file
+     * @return false if the file cannot be mapped or is not a WAV MappedWav reads
+     */
+    bool open(const QString& filePath);
+
+    void close();
+
+    bool isOpen() const { return m_data != nullptr; }
+
+    /**
+     * @brief Get the format of the samples in the data chunk
+     */
+    QAudioFormat format() const { return m_format; }
+
+    /**
+     * @brief Get the number of whole frames in the data chunk
+     */
+    qint64 frames() const { return m_frames; }
+
+    /**
+     * @brief Get the samples of a frame and the frames after it
+     * @param frame Frame from the start of the data chunk, below frames()
+     */
+    const char* frameData(qint64 frame) const { return m_data + frame * m_frameBytes; }
+
+    /**
+     * @brief Have frames read in ahead of time, without waiting for them
+     *
+     * Only whatever was not advised before is advised again, so it may be
+     * called for every block read.
+     */
+    void adviseAhead(qint64 frame, qint64 frames);
+
+private:
+    bool parse(const uchar* base, qint64 size);
+
+    QFile m_file;
+    const uchar* m_base = nullptr;          ///< Start of the mapping, page aligned
+    const char* m_data = nullptr;           ///< Start of the data chunk
+    QAudioFormat m_format;
+    int m_frameBytes = 0;
+    qint64 m_frames = 0;
+    qint64 m_advisedUntil = 0;              ///< Byte offset read ahead up to
+};
+
+#endif // MAPPEDWAV_H
@@ -0,0 +1,345 @@
+#include "MediaCache.h"
+#include "ContentHash.h"
+#include "Tracer.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QtConcurrent/QtConcurrentRun>
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace {
+
+const QString PART_SUFFIX = ".part";
+
+} // namespace
+
+MediaCache::MediaCache(const QString& cacheDirectory, QObject* parent)
+    : QObject(parent)
+    , m_cacheDirectory(QDir(cacheDirectory).absolutePath())
+    , m_abort(std::make_shared<std::atomic_bool>(false))
+{
+    QDir().mkpath(m_cacheDirectory);
+    connect(&m_watcher, &QFutureWatcher<CopyResult>::finished, this, &MediaCache::onCopyFinished);
+    loadIndex();
+}
+
+MediaCache::~MediaCache()
+{
+    m_queue.clear();
+    m_abort->store(true);
+    m_watcher.disconnect(this);
+    m_watcher.waitForFinished();
+}
+
+void MediaCache::setEnabled(bool enabled)
+{
+    m_enabled = enabled;
+    if (!enabled) {
+        m_queue.clear();
+    }
+}
+
+void MediaCache::setMaxBytes(qint64 bytes)
+{
+    m_maxBytes = qMax<qint64>(0, bytes);
+    evict();
+}
+
+bool MediaCache::handles(const QString& source) const
+{
+    if (!m_enabled || source.isEmpty()) {
+        return false;
+    }
+    const QString path = QDir::cleanPath(source);
+    if (path.startsWith(m_cacheDirectory + '/')) {
+        return false;
+    }
+    if (m_paths.isEmpty()) {
+        return true;
+    }
+    return std::any_of(m_paths.cbegin(), m_paths.cend(), [&path](const QString& prefix) {
+        return !prefix.isEmpty() && path.startsWith(QDir::cleanPath(prefix));
+    });
+}
+
+bool MediaCache::isCached(const QString& source) const
+{
+    const auto it = m_mappings.constFind(source);
+    if (it == m_mappings.cend() || !m_entries.contains(it->copyPath)) {
+        return false;
+    }
+    const QFileInfo original(source);
+    return original.size() == it->sourceSize && original.lastModified() == it->sourceModified;
+}
+
+int MediaCache::prepare(const QStringList& sources, bool urgent)
+{
+    QStringList added;
+    for (const QString& source : sources) {
+        if (!handles(source) || isCached(source) || source == m_running ||
+            added.contains(source)) {
+            continue;
+        }
+        if (urgent) {
+            m_queue.removeAll(source);
+        } else if (m_queue.contains(source)) {
+            continue;
+        }
+        added.append(source);
+    }
+
+    if (urgent) {
+        m_queue = added + m_queue;
+    } else {
+        m_queue += added;
+    }
+    schedule();
+    return added.size();
+}
+
+QString MediaCache::resolve(const QString& source)
+{
+    TraceSpan span("cache", "MediaCache::resolve");
+    if (!handles(source)) {
+        return source;
+    }
+
+    const auto it = m_mappings.constFind(source);
+    if (it != m_mappings.cend() && m_entries.contains(it->copyPath)) {
+        // A track the NAS cannot serve right now plays from its copy; a changed one does not
+        const QFileInfo original(source);
+        const bool changed = original.exists() && (original.size() != it->sourceSize ||
+                                                   original.lastModified() != it->sourceModified);
+        if (!changed) {
+            const QString path = it->copyPath;
+            ++m_hits;
+            touch(path);
+            m_pinned.removeAll(path);
+            m_pinned.prepend(path);
+            while (m_pinned.size() > PINNED_ENTRIES) {
+                m_pinned.removeLast();
+            }
+            return path;
+        }
+        m_mappings.remove(source);
+    }
+
+    ++m_misses;
+    qDebug() << "MediaCache: no copy of" << source << "yet, playing the original";
+    prepare({source}, true);
+    return source;
+}
+
+MediaCache::Statistics MediaCache::statistics() const
+{
+    Statistics stats;
+    stats.hits = m_hits;
+    stats.misses = m_misses;
+    stats.copied = m_copied;
+    stats.shared = m_shared;
+    stats.failed = m_failed;
+    stats.evicted = m_evicted;
+    stats.entries = m_entries.size();
+    stats.bytes = m_bytes;
+    stats.bytesCopied = m_bytesCopied;
+    return stats;
+}
+
+void MediaCache::loadIndex()
+{
+    QDir directory(m_cacheDirectory);
+    for (const QFileInfo& part : directory.entryInfoList({"*" + PART_SUFFIX}, QDir::Files)) {
+        QFile::remove(part.filePath());
+    }
+    // Only the copies are kept; the first prepare() of a track after a restart
+    // hashes it and finds its copy again without reading all of it
+    for (const QFileInfo& copy : directory.entryInfoList(QDir::Files)) {
+        Entry entry;
+        entry.bytes = copy.size();
+        entry.lastUsedMs = copy.lastModified().toMSecsSinceEpoch();
+        m_entries.insert(copy.filePath(), entry);
+        m_bytes += entry.bytes;
+    }
+    evict();
+}
+
+void MediaCache::schedule()
+{
+    if (!m_running.isEmpty() || m_queue.isEmpty()) {
+        return;
+    }
+    // One copy at a time, so filling the cache does not load the NAS it relieves
+    m_running = m_queue.takeFirst();
+    m_watcher.setFuture(
+        QtConcurrent::run(&MediaCache::copyToCache, m_running, m_cacheDirectory, m_abort));
+}
+
+MediaCache::CopyResult MediaCache::copyToCache(const QString& source, const QString& directory,
+                                               const std::shared_ptr<std::atomic_bool>& abort)
+{
+    CopyResult result;
+    result.source = source;
+
+    const QFileInfo info(source);
+    if (!info.isFile()) {
+        result.error = "Source file is missing";
+        return result;
+    }
+    result.mapping.sourceSize = info.size();
+    result.mapping.sourceModified = info.lastModified();
+
+    QString error;
+    const QString hash = ContentHash::ofFile(source, &error);
+    if (hash.isEmpty()) {
+        result.error = error;
+        return result;
+    }
+    const QString suffix = info.suffix().toLower();
+    result.mapping.copyPath = QDir(directory).filePath(suffix.isEmpty() ? hash
+                                                                        : hash + '.' + suffix);
+
+    // The same audio under another path, or with other tags, plays the same
+    const QFileInfo existing(result.mapping.copyPath);
+    if (existing.isFile()) {
+        result.bytes = existing.size();
+        return result;
+    }
+
+    const QString partPath = result.mapping.copyPath + PART_SUFFIX;
+    QFile input(source);
+    QFile output(partPath);
+    if (!input.open(QIODevice::ReadOnly)) {
+        result.error = input.errorString();
+        return result;
+    }
+    if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        result.error = output.errorString();
+        return result;
+    }
+
+    QByteArray buffer(COPY_CHUNK_BYTES, Qt::Uninitialized);
+    qint64 written = 0;
+    while (true) {
+        if (abort->load()) {
+            result.error = "Aborted";
+            break;
+        }
+        const qint64 read = input.read(buffer.data(), buffer.size());
+        if (read < 0) {
+            result.error = input.errorString();
+            break;
+        }
+        if (read == 0) {
+            break;
+        }
+        if (output.write(buffer.constData(), read) != read) {
+            result.error = output.errorString();
+            break;
+        }
+        written += read;
+    }
+    output.close();
+
+    if (result.error.isEmpty() && written != result.mapping.sourceSize) {
+        result.error = "The file changed while it was copied";
+    }
+    if (result.error.isEmpty()) {
+        // rename() puts the copy in place in one step, so a deck never opens half a file
+        std::error_code renameError;
+        std::filesystem::rename(QFile(partPath).filesystemFileName(),
+                                QFile(result.mapping.copyPath).filesystemFileName(), renameError);
+        if (renameError) {
+            result.error = QString("Cannot move the copy into place: %1")
+                               .arg(QString::fromStdString(renameError.message()));
+        }
+    }
+    if (!result.error.isEmpty()) {
+        QFile::remove(partPath);
+        return result;
+    }
+
+    result.copied = true;
+    result.bytes = written;
+    return result;
+}
+
+void MediaCache::onCopyFinished()
+{
+    const CopyResult result = m_watcher.result();
+    m_running.clear();
+
+    if (!result.error.isEmpty()) {
+        ++m_failed;
+        qWarning() << QString("MediaCache::onCopyFinished - %1: %2").arg(result.source,
+                                                                          result.error);
+        emit failed(result.source, result.error);
+        schedule();
+        return;
+    }
+
+    const QString path = result.mapping.copyPath;
+    if (result.copied) {
+        ++m_copied;
+        m_bytesCopied += result.bytes;
+    } else {
+        ++m_shared;
+    }
+    if (!m_entries.contains(path)) {
+        m_bytes += result.bytes;
+    }
+    Entry& entry = m_entries[path];
+    entry.bytes = result.bytes;
+    entry.lastUsedMs = QDateTime::currentMSecsSinceEpoch();
+    m_mappings.insert(result.source, result.mapping);
+    evict();
+
+    if (m_entries.contains(path)) {
+        emit prepared(result.source, path);
+    }
+    schedule();
+}
+
+void MediaCache::touch(const QString& path)
+{
+    const QDateTime now = QDateTime::currentDateTime();
+    m_entries[path].lastUsedMs = now.toMSecsSinceEpoch();
+    QFile file(path);
+    if (file.open(QIODevice::ReadWrite)) {
+        file.setFileTime(now, QFileDevice::FileModificationTime);
+    }
+}
+
+void MediaCache::evict()
+{
+    if (m_bytes <= m_maxBytes) {
+        return;
+    }
+
+    std::vector<std::pair<qint64, QString>> candidates;
+    for (auto it = m_entries.cbegin(); it != m_entries.cend(); ++it) {
+        if (!m_pinned.contains(it.key())) {
+            candidates.emplace_back(it.value().lastUsedMs, it.key());
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    for (const auto& candidate : candidates) {
+        if (m_bytes <= m_maxBytes) {
+            break;
+        }
+        const QString& path = candidate.second;
+        // A copy a deck still has open cannot be removed on Windows; it goes next time
+        if (!QFile::remove(path) && QFileInfo::exists(path)) {
+            continue;
+        }
+        m_bytes -= m_entries.value(path).bytes;
+        m_entries.remove(path);
+        ++m_evicted;
+        qDebug() << "MediaCache: evicted" << path;
+    }
+}
@@ -0,0 +1,213 @@
+#ifndef MEDIACACHE_H
+#define MEDIACACHE_H
+
+#include <QDateTime>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <atomic>
+#include <memory>
+
+/**
+ * @brief Keeps local copies of the tracks that go on air next
+ *
+ * With the library on a NAS every studio reads the same files from it
+ * again each time they come round in the rotation, and a network blip at
+ * the wrong moment is dead air. MediaCache copies the tracks that are due,
+ * the top of the playlist and the pubs, programs and rotation picks of the
+ * coming hours, to a directory on the local disk, one at a time in the
+ * background, so they play from there.
+ *
+ * Copies are named after the ContentHash of their audio, so the same track
+ * under two paths, or with edited tags, is kept once, and a track moved on
+ * the NAS is found again without copying it. The path of each track is
+ * mapped to its copy along with the size and modification time it had; a
+ * track that changed since plays from the NAS and is copied again, while
+ * one that cannot be reached at all plays from its copy.
+ *
+ * Only tracks under one of paths() are copied, all but those already in
+ * the cache directory if none are set. The cache is kept within maxBytes()
+ * by removing the copies played least recently, with the last
+ * PINNED_ENTRIES resolved kept, as TranscodeCache does.
+ *
+ * @example
+ * @code
+ * MediaCache* cache = new MediaCache(cacheDir + "/media", this);
+ * cache->setPaths({"/mnt/nas/music"});
+ * cache->prepare(nextTracks);
+ * playbackEngine->setSourceResolver([cache](const QString& path) { return cache->resolve(path); });
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class MediaCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Counters since the cache was created
+     */
+    struct Statistics {
+        int hits = 0;             ///< resolve() calls served from a copy
+        int misses = 0;           ///< resolve() calls for tracks without a ready copy
+        int copied = 0;           ///< Tracks copied
+        int shared = 0;           ///< Tracks whose audio was already in the cache
+        int failed = 0;           ///< Copies that failed
+        int evicted = 0;          ///< Copies removed to stay within maxBytes()
+        int entries = 0;          ///< Copies in the cache now
+        qint64 bytes = 0;         ///< Size of the cache now
+        qint64 bytesCopied = 0;   ///< Read from the sources to fill it
+
+        double hitRate() const
+        {
+            const int lookups = hits + misses;
+            return lookups > 0 ? double(hits) / lookups : 0.0;
+        }
+    };
+
+    static constexpr qint64 DEFAULT_MAX_BYTES = 10LL * 1024 * 1024 * 1024;
+    static constexpr int PINNED_ENTRIES = 2;
+    static constexpr int COPY_CHUNK_BYTES = 1024 * 1024;
+
+    /**
+     * @brief Open a cache directory, creating it if needed
+     *
+     * Copies already in it are counted; copies a crash interrupted are removed.
+     * @param cacheDirectory Directory that holds the copies
+     * @param parent Parent object
+     */
+    explicit MediaCache(const QString& cacheDirectory, QObject* parent = nullptr);
+    ~MediaCache() override;
+
+    /**
+     * @brief Turn the cache on or off; off, prepare() copies nothing and resolve() maps nothing
+     */
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return m_enabled; }
+
+    /**
+     * @brief Set the directories whose tracks are copied
+     * @param paths Path prefixes, such as the NAS mount; empty for every track
+     */
+    void setPaths(const QStringList& paths) { m_paths = paths; }
+    QStringList paths() const { return m_paths; }
+
+    /**
+     * @brief Set how large the cache may grow, removing copies if it is over
+     * @param bytes Size limit; DEFAULT_MAX_BYTES by default
+     */
+    void setMaxBytes(qint64 bytes);
+    qint64 maxBytes() const { return m_maxBytes; }
+
+    QString cacheDirectory() const { return m_cacheDirectory; }
+
+    /**
+     * @brief Check whether a track is one the cache copies
+     * @param source Path of the track
+     */
+    bool handles(const QString& source) const;
+
+    /**
+     * @brief Check whether a track has a copy made from its current file
+     * @param source Path of the track
+     */
+    bool isCached(const QString& source) const;
+
+    /**
+     * @brief Copy tracks in the background
+     *
+     * Tracks not handled, already copied, or already waiting are skipped.
+     * @param sources Paths of the tracks
+     * @param urgent Put them in front of the tracks already waiting
+     * @return Number of tracks added to the queue
+     */
+    int prepare(const QStringList& sources, bool urgent = false);
+
+    /**
+     * @brief Get the file to play for a track
+     *
+     * Counts a hit when the copy is ready and a miss when it is not. A miss
+     * plays the track's own file and puts its copy in front of the queue.
+     * @param source Path of the track
+     * @return Path of the copy, or source if there is none
+     */
+    QString resolve(const QString& source);
+
+    /**
+     * @brief Get the number of copies not finished yet
+     */
+    int pendingCount() const { return m_queue.size() + (m_running.isEmpty() ? 0 : 1); }
+
+    Statistics statistics() const;
+
+signals:
+    /**
+     * @brief Emitted when the copy of a track is ready
+     * @param source Path of the track
+     * @param cachePath Path of the copy
+     */
+    void prepared(const QString& source, const QString& cachePath);
+
+    /**
+     * @brief Emitted when a track could not be copied
+     * @param source Path of the track
+     * @param error Why it failed
+     */
+    void failed(const QString& source, const QString& error);
+
+private:
+    struct Entry {
+        qint64 bytes = 0;
+        qint64 lastUsedMs = 0;
+    };
+
+    /// A track and the copy of its audio
+    struct Mapping {
+        QString copyPath;
+        qint64 sourceSize = 0;
+        QDateTime sourceModified;
+    };
+
+    struct CopyResult {
+        QString source;
+        Mapping mapping;
+        bool copied = false;   ///< false if the audio was already in the cache
+        qint64 bytes = 0;
+        QString error;
+    };
+
+    static CopyResult copyToCache(const QString& source, const QString& directory,
+                                  const std::shared_ptr<std::atomic_bool>& abort);
+    void loadIndex();
+    void schedule();
+    void onCopyFinished();
+    void touch(const QString& path);
+    void evict();
+
+    QString m_cacheDirectory;
+    QStringList m_paths;
+    qint64 m_maxBytes = DEFAULT_MAX_BYTES;
+    bool m_enabled = true;
+
+    QHash<QString, Entry> m_entries;     ///< Copies by their path
+    QHash<QString, Mapping> m_mappings;  ///< Copies by the path of their track
+    qint64 m_bytes = 0;
+    QStringList m_pinned;                ///< Copies resolved last, most recent first
+    QStringList m_queue;
+    QString m_running;
+    QFutureWatcher<CopyResult> m_watcher;
+    std::shared_ptr<std::atomic_bool> m_abort;
+
+    int m_hits = 0;
+    int m_misses = 0;
+    int m_copied = 0;
+    int m_shared = 0;
+    int m_failed = 0;
+    int m_evicted = 0;
+    qint64 m_bytesCopied = 0;
+};
+
+#endif // MEDIACACHE_H
@@ -0,0 +1,170 @@
+#include "MediaInfoLoader.h"
+#include "MediaProbe.h"
+#include "MusicCache.h"
+#include "TagReader.h"
+#include <QFileInfo>
+#include <QVariantMap>
+#include <QtConcurrent/QtConcurrentRun>
+
+QVariant MediaInfoLoader::Info::toVariant() const
+{
+    QVariantMap map;
+    map.insert("path", path);
+    map.insert("error", error);
+    map.insert("artist", artist);
+    map.insert("title", title);
+    map.insert("album", album);
+    map.insert("genre", genre);
+    map.insert("year", year);
+    map.insert("duration", duration);
+    map.insert("tagFormat", tagFormat);
+    map.insert("container", container);
+    map.insert("bitrateKbps", bitrateKbps);
+    map.insert("size", size);
+    map.insert("modified", modified);
+    return map;
+}
+
+MediaInfoLoader::Info MediaInfoLoader::Info::fromVariant(const QVariant& value)
+{
+    const QVariantMap map = value.toMap();
+    Info info;
+    info.path = map.value("path").toString();
+    info.error = map.value("error").toString();
+    info.artist = map.value("artist").toString();
+    info.title = map.value("title").toString();
+    info.album = map.value("album").toString();
+    info.genre = map.value("genre").toString();
+    info.year = map.value("year").toString();
+    info.duration = map.value("duration").toString();
+    info.tagFormat = map.value("tagFormat").toString();
+    info.container = map.value("container").toString();
+    info.bitrateKbps = map.value("bitrateKbps").toInt();
+    info.size = map.value("size").toLongLong();
+    info.modified = map.value("modified").toDateTime();
+    return info;
+}
+
+MediaInfoLoader::MediaInfoLoader(MusicCache* cache, QObject* parent)
+    : QObject(parent)
+    , m_cache(cache)
+{
+    qRegisterMetaType<MediaInfoLoader::Info>();
+    connect(&m_watcher, &QFutureWatcher<Info>::finished, this, &MediaInfoLoader::onReadFinished);
+}
+
+MediaInfoLoader::~MediaInfoLoader()
+{
+    m_watcher.disconnect(this);
+    m_watcher.waitForFinished();
+}
+
+MediaInfoLoader::Info MediaInfoLoader::read(const QString& path)
+{
+    Info info;
+    info.path = path;
+    const QFileInfo file(path);
+    info.size = file.size();
+    info.modified = file.lastModified();
+
+    const TagReader::Tags tags = TagReader::read(path, &info.error);
+    if (!info.error.isEmpty()) {
+        return info;
+    }
+    info.artist = tags.artist;
+    info.title = tags.title;
+    info.album = tags.album;
+    info.genre = tags.genre;
+    info.year = tags.year;
+    info.duration = tags.durationString();
+    info.tagFormat = tags.format;
+
+    const MediaProbe::ProbeResult probe = MediaProbe::probe(path);
+    info.container = MediaProbe::containerName(probe.container);
+    info.bitrateKbps = probe.bitrateKbps;
+    return info;
+}
+
+bool MediaInfoLoader::cached(const QString& path, Info* info) const
+{
+    if (!m_cache) {
+        return false;
+    }
+    const QVariant value = m_cache->getMetadata(path, CACHE_CATEGORY);
+    if (!value.isValid()) {
+        return false;
+    }
+    const Info hit = Info::fromVariant(value);
+    const QFileInfo file(path);
+    if (file.size() != hit.size || file.lastModified() != hit.modified) {
+        m_cache->removeMetadata(path, CACHE_CATEGORY);
+        return false;
+    }
+    if (info) {
+        *info = hit;
+    }
+    return true;
+}
+
+void MediaInfoLoader::request(const QString& path)
+{
+    if (path.isEmpty()) {
+        return;
+    }
+    Info info;
+    if (cached(path, &info)) {
+        cancel();
+        emit loaded(info);
+        return;
+    }
+
+    m_latest = path;
+    if (m_running.isEmpty()) {
+        start(path);
+        return;
+    }
+    if (!m_waiting.isEmpty() && m_waiting != path) {
+        ++m_superseded;
+    }
+    // The track being read already is reported when it finishes
+    m_waiting = path == m_running ? QString() : path;
+}
+
+void MediaInfoLoader::cancel()
+{
+    if (!m_waiting.isEmpty()) {
+        ++m_superseded;
+    }
+    m_waiting.clear();
+    m_latest.clear();
+}
+
+void MediaInfoLoader::start(const QString& path)
+{
+    m_running = path;
+    ++m_reads;
+    m_watcher.setFuture(QtConcurrent::run(&MediaInfoLoader::read, path));
+}
+
+void MediaInfoLoader::onReadFinished()
+{
+    const Info info = m_watcher.result();
+    m_running.clear();
+
+    // A file that cannot be opened now may be readable on the next try
+    if (m_cache && info.error.isEmpty()) {
+        m_cache->putMetadata(info.path, info.toVariant(), CACHE_CATEGORY);
+    }
+    if (info.path == m_latest) {
+        m_latest.clear();
+        emit loaded(info);
+    } else {
+        ++m_superseded;
+    }
+
+    if (!m_waiting.isEmpty()) {
+        const QString next = m_waiting;
+        m_waiting.clear();
+        start(next);
+    }
+}
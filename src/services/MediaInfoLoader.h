@@ -0,0 +1,147 @@
+#ifndef MEDIAINFOLOADER_H
+#define MEDIAINFOLOADER_H
+
+#include <QDateTime>
+#include <QFutureWatcher>
+#include <QMetaType>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <QVariant>
+
+class MusicCache;
+
+/**
+ * @brief Reads the tags and stream details of tracks for the info panel
+ *
+ * The tags come from TagReader and the stream details from MediaProbe,
+ * read on a worker thread so inspecting a track on a slow disk or a NAS
+ * never blocks the window. Results are kept in a MusicCache under the
+ * CACHE_CATEGORY metadata category along with the size and modification
+ * time the file had, so a track inspected again is answered at once and a
+ * track changed since is read again.
+ *
+ * Only the most recent request matters: while one read runs, a newer
+ * request replaces any request still waiting, so clicking or scrolling
+ * through the library reads at most the track being read and the last one
+ * selected. A superseded read still fills the cache, but loaded() is only
+ * emitted for the latest request.
+ *
+ * @example
+ * @code
+ * MediaInfoLoader* loader = new MediaInfoLoader(cache, this);
+ * connect(loader, &MediaInfoLoader::loaded, this, &Panel::show);
+ * loader->request(path);   // emits loaded() right away when cached
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class MediaInfoLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief What the info panel shows about a track
+     */
+    struct Info {
+        QString path;
+        QString error;           ///< Why the file could not be read; empty on success
+        QString artist;
+        QString title;
+        QString album;
+        QString genre;
+        QString year;
+        QString duration;        ///< As the musics.time column stores it, or empty
+        QString tagFormat;       ///< Tag format read, such as "ID3v2.4"
+        QString container;       ///< MediaProbe container name
+        int bitrateKbps = 0;
+        qint64 size = 0;         ///< File size when it was read
+        QDateTime modified;      ///< File modification time when it was read
+
+        bool isValid() const { return !path.isEmpty() && error.isEmpty(); }
+
+        /**
+         * @brief Check whether any text tag was found
+         */
+        bool hasTags() const
+        {
+            return !artist.isEmpty() || !title.isEmpty() || !album.isEmpty() ||
+                   !genre.isEmpty() || !year.isEmpty();
+        }
+
+        QVariant toVariant() const;
+        static Info fromVariant(const QVariant& value);
+    };
+
+    static constexpr const char* CACHE_CATEGORY = "mediainfo";
+
+    /**
+     * @brief Create a loader
+     * @param cache Cache for the results, or nullptr to read every time
+     * @param parent Parent object
+     */
+    explicit MediaInfoLoader(MusicCache* cache, QObject* parent = nullptr);
+    ~MediaInfoLoader() override;
+
+    /**
+     * @brief Read a track now, on the calling thread
+     * @param path Path of the track
+     * @return What was read; error is set if the file cannot be opened
+     */
+    static Info read(const QString& path);
+
+    /**
+     * @brief Get the cached info of a track if the file has not changed since
+     * @param path Path of the track
+     * @param info Receives the info
+     * @return true on a hit
+     */
+    bool cached(const QString& path, Info* info) const;
+
+    /**
+     * @brief Ask for the info of a track, replacing any request still waiting
+     *
+     * A cached track is answered through loaded() before this returns.
+     * @param path Path of the track
+     */
+    void request(const QString& path);
+
+    /**
+     * @brief Drop the waiting request and ignore the read in progress
+     */
+    void cancel();
+
+    /**
+     * @brief Get the track whose info loaded() will report next, if any
+     */
+    QString pendingPath() const { return m_latest; }
+
+    /// Reads started on the worker
+    int readCount() const { return m_reads; }
+    /// Requests replaced or cancelled before loaded() reported them
+    int supersededCount() const { return m_superseded; }
+
+signals:
+    /**
+     * @brief Emitted with the info of the most recently requested track
+     * @param info What was read, or why it could not be
+     */
+    void loaded(const MediaInfoLoader::Info& info);
+
+private:
+    void start(const QString& path);
+    void onReadFinished();
+
+    QPointer<MusicCache> m_cache;
+    QFutureWatcher<Info> m_watcher;
+    QString m_running;   ///< Track being read on the worker
+    QString m_waiting;   ///< Track to read once m_running is done
+    QString m_latest;    ///< Track loaded() is emitted for
+    int m_reads = 0;
+    int m_superseded = 0;
+};
+
+Q_DECLARE_METATYPE(MediaInfoLoader::Info)
+
+#endif // MEDIAINFOLOADER_H
@@ -0,0 +1,665 @@
+#include "MediaProbe.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDebug>
+
+namespace {
+
+quint16 readU16LE(const char* p)
+{
+    const auto* u = reinterpret_cast<const uchar*>(p);
+    return quint16(u[0] | (u[1] << 8));
+}
+
+quint32 readU32LE(const char* p)
+{
+    const auto* u = reinterpret_cast<const uchar*>(p);
+    return quint32(u[0]) | (quint32(u[1]) << 8) | (quint32(u[2]) << 16) | (quint32(u[3]) << 24);
+}
+
+quint64 readU64LE(const char* p)
+{
+    return quint64(readU32LE(p)) | (quint64(readU32LE(p + 4)) << 32);
+}
+
+quint32 readU32BE(const char* p)
+{
+    const auto* u = reinterpret_cast<const uchar*>(p);
+    return (quint32(u[0]) << 24) | (quint32(u[1]) << 16) | (quint32(u[2]) << 8) | quint32(u[3]);
+}
+
+quint64 readU64BE(const char* p)
+{
+    return (quint64(readU32BE(p)) << 32) | quint64(readU32BE(p + 4));
+}
+
+qint64 samplesToUs(quint64 samples, int sampleRate)
+{
+    if (sampleRate <= 0) {
+        return 0;
+    }
+    // Split to avoid overflowing 64 bits on very long files
+    return qint64((samples / quint64(sampleRate)) * 1000000ULL +
+                  ((samples % quint64(sampleRate)) * 1000000ULL) / quint64(sampleRate));
+}
+
+// MPEG audio header tables, indexed as [version][layer][index]
+// version: 0 = MPEG1, 1 = MPEG2/2.5; layer: 0 = I, 1 = II, 2 = III
+const int kMpegBitrates[2][3][16] = {
+    {
+        {0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448, -1},
+        {0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384, -1},
+        {0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, -1},
+    },
+    {
+        {0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256, -1},
+        {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160, -1},
+        {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160, -1},
+    },
+};
+
+const int kMpegSampleRates[3][3] = {
+    {44100, 48000, 32000}, // MPEG1
+    {22050, 24000, 16000}, // MPEG2
+    {11025, 12000, 8000},  // MPEG2.5
+};
+
+struct MpegFrameHeader {
+    bool valid = false;
+    bool mpeg1 = false;
+    int layer = 0;          // 1, 2 or 3
+    int bitrateKbps = 0;
+    int sampleRate = 0;
+    int channels = 0;
+    int frameLength = 0;
+    int samplesPerFrame = 0;
+};
+
+MpegFrameHeader parseMpegHeader(const char* p)
+{
+    MpegFrameHeader header;
+    const auto* u = reinterpret_cast<const uchar*>(p);
+
+    if (u[0] != 0xFF || (u[1] & 0xE0) != 0xE0) {
+        return header;
+    }
+
+    int versionBits = (u[1] >> 3) & 0x03; // 0 = 2.5, 1 = reserved, 2 = 2, 3 = 1
+    int layerBits = (u[1] >> 1) & 0x03;   // 1 = III, 2 = II, 3 = I
+    int bitrateIndex = (u[2] >> 4) & 0x0F;
+    int sampleRateIndex = (u[2] >> 2) & 0x03;
+    int padding = (u[2] >> 1) & 0x01;
+    int channelMode = (u[3] >> 6) & 0x03;
+
+    if (versionBits == 1 || layerBits == 0 || bitrateIndex == 0 || bitrateIndex == 15 ||
+        sampleRateIndex == 3) {
+        return header;
+    }
+
+    header.mpeg1 = (versionBits == 3);
+    header.layer = 4 - layerBits;
+    int versionRow = header.mpeg1 ? 0 : 1;
+    int rateRow = header.mpeg1 ? 0 : (versionBits == 2 ? 1 : 2);
+
+    header.bitrateKbps = kMpegBitrates[versionRow][header.layer - 1][bitrateIndex];
+    header.sampleRate = kMpegSampleRates[rateRow][sampleRateIndex];
+    header.channels = (channelMode == 3) ? 1 : 2;
+
+    if (header.layer == 1) {
+        header.samplesPerFrame = 384;
+        header.frameLength = (12 * header.bitrateKbps * 1000 / header.sampleRate + padding) * 4;
+    } else if (header.layer == 2 || header.mpeg1) {
+        header.samplesPerFrame = 1152;
+        header.frameLength = 144 * header.bitrateKbps * 1000 / header.sampleRate + padding;
+    } else {
+        header.samplesPerFrame = 576;
+        header.frameLength = 72 * header.bitrateKbps * 1000 / header.sampleRate + padding;
+    }
+
+    header.valid = header.frameLength > 4;
+    return header;
+}
+
+} // namespace
+
+MediaProbe::ProbeResult MediaProbe::probe(const QString& filePath)
+{
+    ProbeResult result;
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        result.errorMessage = QString("Cannot open file: %1").arg(file.errorString());
+        return result;
+    }
+
+    QByteArray head = file.read(HEAD_READ_SIZE);
+    if (head.size() < 12) {
+        result.errorMessage = "File is too small to contain an audio stream";
+        return result;
+    }
+
+    qint64 tagSize = id3v2Size(head);
+    QByteArray afterTag = head;
+    if (tagSize > 0) {
+        file.seek(tagSize);
+        afterTag = file.read(HEAD_READ_SIZE);
+    }
+
+    result.container = detectContainer(afterTag, filePath);
+
+    bool ok = false;
+    switch (result.container) {
+    case Container::Wav:
+        ok = probeWav(file, result);
+        break;
+    case Container::Flac:
+        ok = probeFlac(file, tagSize, result);
+        break;
+    case Container::Ogg:
+        ok = probeOgg(file, result);
+        break;
+    case Container::Mpeg:
+        ok = probeMpeg(file, tagSize, result);
+        break;
+    case Container::Mp4:
+        ok = probeMp4(file, result);
+        break;
+    case Container::Unknown:
+        result.errorMessage = "Unrecognised audio container";
+        break;
+    }
+
+    result.isValid = ok && result.durationUs > 0;
+    if (!result.isValid && result.errorMessage.isEmpty()) {
+        result.errorMessage = QString("Could not determine duration of %1 stream")
+                                  .arg(containerName(result.container));
+    }
+
+    return result;
+}
+
+qint64 MediaProbe::durationUs(const QString& filePath)
+{
+    ProbeResult result = probe(filePath);
+    return result.isValid ? result.durationUs : -1;
+}
+
+QString MediaProbe::formatDuration(qint64 durationUs)
+{
+    qint64 totalSeconds = durationUs / 1000000;
+    qint64 hours = totalSeconds / 3600;
+    qint64 minutes = (totalSeconds % 3600) / 60;
+    qint64 seconds = totalSeconds % 60;
+
+    return QStringLiteral("%1:%2:%3")
+        .arg(hours)
+        .arg(minutes, 2, 10, QChar('0'))
+        .arg(seconds, 2, 10, QChar('0'));
+}
+
+QString MediaProbe::containerName(Container container)
+{
+    switch (container) {
+    case Container::Wav:
+        return "WAV";
+    case Container::Flac:
+        return "FLAC";
+    case Container::Ogg:
+        return "Ogg";
+    case Container::Mpeg:
+        return "MPEG";
+    case Container::Mp4:
+        return "MP4";
+    case Container::Unknown:
+        break;
+    }
+    return "Unknown";
+}
+
+MediaProbe::Container MediaProbe::detectContainer(const QByteArray& head, const QString& filePath)
+{
+    if (head.size() >= 12 && head.startsWith("RIFF") && head.mid(8, 4) == "WAVE") {
+        return Container::Wav;
+    }
+    if (head.startsWith("fLaC")) {
+        return Container::Flac;
+    }
+    if (head.startsWith("OggS")) {
+        return Container::Ogg;
+    }
+    if (head.size() >= 8 && head.mid(4, 4) == "ftyp") {
+        return Container::Mp4;
+    }
+    if (head.size() >= 4 && parseMpegHeader(head.constData()).valid) {
+        return Container::Mpeg;
+    }
+
+    // Fall back on the extension for MPEG streams with leading garbage
+    QString suffix = QFileInfo(filePath).suffix().toLower();
+    if (suffix == "mp3" || suffix == "mp2" || suffix == "mpga") {
+        return Container::Mpeg;
+    }
+
+    return Container::Unknown;
+}
+
+qint64 MediaProbe::id3v2Size(const QByteArray& head)
+{
+    if (head.size() < 10 || !head.startsWith("ID3")) {
+        return 0;
+    }
+
+    const auto* u = reinterpret_cast<const uchar*>(head.constData());
+    qint64 size = (qint64(u[6] & 0x7F) << 21) | (qint64(u[7] & 0x7F) << 14) |
+                  (qint64(u[8] & 0x7F) << 7) | qint64(u[9] & 0x7F);
+    bool hasFooter = (u[5] & 0x10) != 0;
+
+    return 10 + size + (hasFooter ? 10 : 0);
+}
+
+bool MediaProbe::probeWav(QFile& file, ProbeResult& result)
+{
+    result.codec = "pcm";
+
+    int formatTag = 0;
+    quint32 byteRate = 0;
+    int blockAlign = 0;
+    bool haveFormat = false;
+
+    qint64 pos = 12;
+    const qint64 fileSize = file.size();
+
+    while (pos + 8 <= fileSize) {
+        if (!file.seek(pos)) {
+            break;
+        }
+        QByteArray chunkHeader = file.read(8);
+        if (chunkHeader.size() < 8) {
+            break;
+        }
+
+        QByteArray chunkId = chunkHeader.left(4);
+        quint32 chunkSize = readU32LE(chunkHeader.constData() + 4);
+
+        if (chunkId == "fmt ") {
+            QByteArray fmt = file.read(qMin<quint32>(chunkSize, 40));
+            if (fmt.size() < 16) {
+                result.errorMessage = "Truncated WAV fmt chunk";
+                return false;
+            }
+            formatTag = readU16LE(fmt.constData());
+            result.channels = readU16LE(fmt.constData() + 2);
+            result.sampleRate = int(readU32LE(fmt.constData() + 4));
+            byteRate = readU32LE(fmt.constData() + 8);
+            blockAlign = readU16LE(fmt.constData() + 12);
+            haveFormat = true;
+
+            if (formatTag != 1 && formatTag != 3 && formatTag != 0xFFFE) {
+                result.codec = QString("wav-0x%1").arg(formatTag, 4, 16, QChar('0'));
+            }
+        } else if (chunkId == "data") {
+            if (!haveFormat || byteRate == 0) {
+                result.errorMessage = "WAV data chunk precedes a valid fmt chunk";
+                return false;
+            }
+
+            qint64 dataSize = chunkSize;
+            qint64 available = fileSize - (pos + 8);
+            // Streamed or truncated recordings often carry a bogus size
+            if (chunkSize == 0 || chunkSize == 0xFFFFFFFFu || dataSize > available) {
+                dataSize = available;
+            }
+            if (blockAlign > 0) {
+                dataSize -= dataSize % blockAlign;
+            }
+
+            result.durationUs = qint64(double(dataSize) * 1000000.0 / double(byteRate));
+            result.bitrateKbps = int(qint64(byteRate) * 8 / 1000);
+            return true;
+        }
+
+        // Chunks are word aligned
+        pos += 8 + qint64(chunkSize) + (chunkSize & 1);
+    }
+
+    result.errorMessage = "WAV file has no data chunk";
+    return false;
+}
+
+bool MediaProbe::probeFlac(QFile& file, qint64 offset, ProbeResult& result)
+{
+    result.codec = "flac";
+
+    if (!file.seek(offset + 4)) {
+        return false;
+    }
+
+    // STREAMINFO is always the first metadata block
+    QByteArray block = file.read(4 + 34);
+    if (block.size() < 38 || (uchar(block[0]) & 0x7F) != 0) {
+        result.errorMessage = "FLAC stream has no STREAMINFO block";
+        return false;
+    }
+
+    const auto* s = reinterpret_cast<const uchar*>(block.constData() + 4);
+    result.sampleRate = int((quint32(s[10]) << 12) | (quint32(s[11]) << 4) | (s[12] >> 4));
+    result.channels = ((s[12] >> 1) & 0x07) + 1;
+    quint64 totalSamples = (quint64(s[13] & 0x0F) << 32) | readU32BE(block.constData() + 4 + 14);
+
+    if (result.sampleRate <= 0 || totalSamples == 0) {
+        result.errorMessage = "FLAC STREAMINFO does not declare a sample count";
+        return false;
+    }
+
+    result.durationUs = samplesToUs(totalSamples, result.sampleRate);
+    qint64 audioBytes = file.size() - offset;
+    if (result.durationUs > 0) {
+        result.bitrateKbps = int(audioBytes * 8 * 1000 / result.durationUs);
+    }
+    return true;
+}
+
+bool MediaProbe::probeOgg(QFile& file, ProbeResult& result)
+{
+    if (!file.seek(0)) {
+        return false;
+    }
+
+    QByteArray firstPage = file.read(27 + 255 + 128);
+    if (firstPage.size() < 28 + 19) {
+        result.errorMessage = "Truncated Ogg page";
+        return false;
+    }
+
+    quint32 serial = readU32LE(firstPage.constData() + 14);
+    int segments = uchar(firstPage[26]);
+    int packetStart = 27 + segments;
+    QByteArray packet = firstPage.mid(packetStart);
+
+    quint64 preSkip = 0;
+    if (packet.startsWith("\x01vorbis") && packet.size() >= 24) {
+        result.codec = "vorbis";
+        result.channels = uchar(packet[11]);
+        result.sampleRate = int(readU32LE(packet.constData() + 12));
+        int nominal = int(readU32LE(packet.constData() + 20));
+        if (nominal > 0) {
+            result.bitrateKbps = nominal / 1000;
+        }
+    } else if (packet.startsWith("OpusHead") && packet.size() >= 19) {
+        result.codec = "opus";
+        result.channels = uchar(packet[9]);
+        preSkip = readU16LE(packet.constData() + 10);
+        // Opus granule positions always count 48 kHz samples
+        result.sampleRate = 48000;
+    } else if (packet.startsWith("\x7F" "FLAC") && packet.size() >= 13 + 4 + 34) {
+        result.codec = "flac";
+        const auto* s = reinterpret_cast<const uchar*>(packet.constData() + 13 + 4);
+        result.sampleRate = int((quint32(s[10]) << 12) | (quint32(s[11]) << 4) | (s[12] >> 4));
+        result.channels = ((s[12] >> 1) & 0x07) + 1;
+    } else {
+        result.errorMessage = "Unsupported codec in Ogg stream";
+        return false;
+    }
+
+    if (result.sampleRate <= 0) {
+        result.errorMessage = "Ogg stream declares no sample rate";
+        return false;
+    }
+
+    // The last page of the logical stream carries the total sample count
+    const qint64 fileSize = file.size();
+    qint64 tailSize = qMin<qint64>(fileSize, OGG_TAIL_READ_SIZE);
+    if (!file.seek(fileSize - tailSize)) {
+        return false;
+    }
+    QByteArray tail = file.read(tailSize);
+
+    qint64 granule = -1;
+    int idx = tail.lastIndexOf("OggS");
+    while (idx >= 0) {
+        if (idx + 27 <= tail.size()) {
+            quint32 pageSerial = readU32LE(tail.constData() + idx + 14);
+            qint64 pageGranule = qint64(readU64LE(tail.constData() + idx + 6));
+            if (pageSerial == serial && pageGranule > 0) {
+                granule = pageGranule;
+                break;
+            }
+        }
+        if (idx == 0) {
+            break;
+        }
+        idx = tail.lastIndexOf("OggS", idx - 1);
+    }
+
+    if (granule <= 0) {
+        result.errorMessage = "Could not find a final Ogg granule position";
+        return false;
+    }
+
+    quint64 samples = quint64(granule) > preSkip ? quint64(granule) - preSkip : 0;
+    result.durationUs = samplesToUs(samples, result.sampleRate);
+    if (result.bitrateKbps == 0 && result.durationUs > 0) {
+        result.bitrateKbps = int(fileSize * 8 * 1000 / result.durationUs);
+    }
+    return true;
+}
+
+bool MediaProbe::probeMpeg(QFile& file, qint64 offset, ProbeResult& result)
+{
+    result.codec = "mp3";
+
+    if (!file.seek(offset)) {
+        return false;
+    }
+    QByteArray data = file.read(HEAD_READ_SIZE);
+
+    // Find the first frame whose successor is also a valid frame
+    int frameStart = -1;
+    MpegFrameHeader header;
+    for (int i = 0; i + 4 <= data.size(); ++i) {
+        if (uchar(data[i]) != 0xFF) {
+            continue;
+        }
+        MpegFrameHeader candidate = parseMpegHeader(data.constData() + i);
+        if (!candidate.valid) {
+            continue;
+        }
+        int next = i + candidate.frameLength;
+        if (next + 4 <= data.size()) {
+            MpegFrameHeader following = parseMpegHeader(data.constData() + next);
+            if (!following.valid || following.sampleRate != candidate.sampleRate) {
+                continue;
+            }
+        }
+        frameStart = i;
+        header = candidate;
+        break;
+    }
+
+    if (frameStart < 0) {
+        result.errorMessage = "No MPEG audio frame found";
+        return false;
+    }
+
+    if (header.layer == 1) {
+        result.codec = "mp1";
+    } else if (header.layer == 2) {
+        result.codec = "mp2";
+    }
+    result.sampleRate = header.sampleRate;
+    result.channels = header.channels;
+    result.bitrateKbps = header.bitrateKbps;
+
+    const char* frame = data.constData() + frameStart;
+    int available = data.size() - frameStart;
+
+    // Xing/Info header sits right after the side information of the first frame
+    int sideInfo = header.mpeg1 ? (header.channels == 1 ? 17 : 32) : (header.channels == 1 ? 9 : 17);
+    int xingOffset = 4 + sideInfo;
+    if (header.layer == 3 && xingOffset + 12 <= available) {
+        QByteArray tag = QByteArray(frame + xingOffset, 4);
+        if (tag == "Xing" || tag == "Info") {
+            quint32 flags = readU32BE(frame + xingOffset + 4);
+            if (flags & 0x1) {
+                quint32 frames = readU32BE(frame + xingOffset + 8);
+                if (frames > 0) {
+                    result.durationUs = samplesToUs(quint64(frames) * header.samplesPerFrame,
+                                                    header.sampleRate);
+                    if ((flags & 0x2) && xingOffset + 16 <= available && result.durationUs > 0) {
+                        quint32 bytes = readU32BE(frame + xingOffset + 12);
+                        result.bitrateKbps = int(qint64(bytes) * 8 * 1000 / result.durationUs);
+                    }
+                    return true;
+                }
+            }
+        }
+    }
+
+    // Fraunhofer VBRI header is always 32 bytes after the frame header
+    if (36 + 18 <= available && QByteArray(frame + 36, 4) == "VBRI") {
+        quint32 bytes = readU32BE(frame + 36 + 10);
+        quint32 frames = readU32BE(frame + 36 + 14);
+        if (frames > 0) {
+            result.durationUs = samplesToUs(quint64(frames) * header.samplesPerFrame,
+                                            header.sampleRate);
+            if (result.durationUs > 0) {
+                result.bitrateKbps = int(qint64(bytes) * 8 * 1000 / result.durationUs);
+            }
+            return true;
+        }
+    }
+
+    // No VBR header: assume constant bitrate over the audio payload
+    qint64 audioBytes = file.size() - offset - frameStart;
+    if (file.size() >= 128 && file.seek(file.size() - 128) && file.read(3) == "TAG") {
+        audioBytes -= 128;
+    }
+    if (audioBytes <= 0 || header.bitrateKbps <= 0) {
+        result.errorMessage = "MPEG stream has no audio payload";
+        return false;
+    }
+
+    result.durationUs = audioBytes * 8 * 1000 / header.bitrateKbps;
+    return true;
+}
+
+bool MediaProbe::probeMp4(QFile& file, ProbeResult& result)
+{
+    result.codec = "aac";
+
+    // Locate the top-level moov box, which may live at either end of the file
+    const qint64 fileSize = file.size();
+    qint64 pos = 0;
+    QByteArray moov;
+
+    while (pos + 8 <= fileSize) {
+        if (!file.seek(pos)) {
+            break;
+        }
+        QByteArray boxHeader = file.read(16);
+        if (boxHeader.size() < 8) {
+            break;
+        }
+
+        qint64 boxSize = readU32BE(boxHeader.constData());
+        QByteArray type = boxHeader.mid(4, 4);
+        int headerSize = 8;
+        if (boxSize == 1 && boxHeader.size() >= 16) {
+            boxSize = qint64(readU64BE(boxHeader.constData() + 8));
+            headerSize = 16;
+        } else if (boxSize == 0) {
+            boxSize = fileSize - pos;
+        }
+        if (boxSize < headerSize) {
+            break;
+        }
+
+        if (type == "moov") {
+            if (boxSize > MP4_MAX_MOOV_SIZE) {
+                result.errorMessage = "MP4 moov box is unreasonably large";
+                return false;
+            }
+            file.seek(pos + headerSize);
+            moov = file.read(boxSize - headerSize);
+            break;
+        }
+        pos += boxSize;
+    }
+
+    if (moov.isEmpty()) {
+        result.errorMessage = "MP4 file has no moov box";
+        return false;
+    }
+
+    // Walk child boxes of a container held in memory
+    auto findChild = [](const QByteArray& data, int start, int end, const char* wanted,
+                        int* payloadStart, int* payloadEnd) {
+        int p = start;
+        while (p + 8 <= end) {
+            qint64 size = readU32BE(data.constData() + p);
+            int header = 8;
+            if (size == 1 && p + 16 <= end) {
+                size = qint64(readU64BE(data.constData() + p + 8));
+                header = 16;
+            } else if (size == 0) {
+                size = end - p;
+            }
+            if (size < header || p + size > end) {
+                return false;
+            }
+            if (qstrncmp(data.constData() + p + 4, wanted, 4) == 0) {
+                *payloadStart = p + header;
+                *payloadEnd = int(p + size);
+                return true;
+            }
+            p += int(size);
+        }
+        return false;
+    };
+
+    int mvhdStart = 0;
+    int mvhdEnd = 0;
+    if (findChild(moov, 0, moov.size(), "mvhd", &mvhdStart, &mvhdEnd) && mvhdEnd - mvhdStart >= 20) {
+        const char* m = moov.constData() + mvhdStart;
+        quint32 timescale = 0;
+        quint64 duration = 0;
+        if (uchar(m[0]) == 1 && mvhdEnd - mvhdStart >= 32) {
+            timescale = readU32BE(m + 20);
+            duration = readU64BE(m + 24);
+        } else {
+            timescale = readU32BE(m + 12);
+            duration = readU32BE(m + 16);
+        }
+        if (timescale > 0) {
+            result.durationUs = samplesToUs(duration, int(timescale));
+        }
+    }
+
+    // The media header of the first track usually uses the sample rate as timescale
+    int trakStart = 0;
+    int trakEnd = 0;
+    int mdiaStart = 0;
+    int mdiaEnd = 0;
+    int mdhdStart = 0;
+    int mdhdEnd = 0;
+    if (findChild(moov, 0, moov.size(), "trak", &trakStart, &trakEnd) &&
+        findChild(moov, trakStart, trakEnd, "mdia", &mdiaStart, &mdiaEnd) &&
+        findChild(moov, mdiaStart, mdiaEnd, "mdhd", &mdhdStart, &mdhdEnd) &&
+        mdhdEnd - mdhdStart >= 20) {
+        const char* m = moov.constData() + mdhdStart;
+        quint32 timescale = (uchar(m[0]) == 1) ? readU32BE(m + 20) : readU32BE(m + 12);
+        quint64 duration = (uchar(m[0]) == 1) ? readU64BE(m + 24) : readU32BE(m + 16);
+        result.sampleRate = int(timescale);
+        if (result.durationUs <= 0 && timescale > 0) {
+            result.durationUs = samplesToUs(duration, int(timescale));
+        }
+    }
+
+    if (result.durationUs > 0) {
+        result.bitrateKbps = int(fileSize * 8 * 1000 / result.durationUs);
+        return true;
+    }
+
+    result.errorMessage = "MP4 file declares no duration";
+    return false;
+}
@@ -0,0 +1,121 @@
+#ifndef MEDIAPROBE_H
+#define MEDIAPROBE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QtGlobal>
+
+class QFile;
+
+/**
+ * @brief In-process audio duration and stream metadata probe
+ *
+ * MediaProbe reads container and frame headers directly from disk to
+ * determine the duration and basic stream parameters of an audio file
+ * without decoding it and without starting an external process such as
+ * exiftool. Only a few kilobytes are read from the start (and, for Ogg,
+ * the end) of each file, so probing a full playlist is cheap enough to
+ * run on the GUI thread.
+ *
+ * Supported containers:
+ * - RIFF/WAVE (PCM and compressed WAV, using the fmt and data chunks)
+ * - FLAC (STREAMINFO total sample count)
+ * - Ogg Vorbis, Ogg Opus and Ogg FLAC (last page granule position)
+ * - MPEG audio layer I/II/III (Xing/Info/VBRI headers, CBR estimate otherwise)
+ * - MP4/M4A (mvhd/mdhd boxes)
+ *
+ * @example
+ * @code
+ * MediaProbe::ProbeResult info = MediaProbe::probe("/music/song.ogg");
+ * if (info.isValid) {
+ *     qint64 ms = info.durationMs();
+ *     QString text = info.durationString(); // "0:03:45"
+ * }
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class MediaProbe
+{
+public:
+    /**
+     * @brief Container formats recognised by the probe
+     */
+    enum class Container {
+        Unknown,
+        Wav,
+        Flac,
+        Ogg,
+        Mpeg,
+        Mp4
+    };
+
+    /**
+     * @brief Result of probing a media file
+     */
+    struct ProbeResult {
+        bool isValid = false;                   ///< Whether a duration could be determined
+        Container container = Container::Unknown;
+        QString codec;                          ///< Codec name (e.g. "vorbis", "mp3", "pcm")
+        qint64 durationUs = 0;                  ///< Duration in microseconds
+        int sampleRate = 0;                     ///< Sample rate in Hz
+        int channels = 0;                       ///< Number of channels
+        int bitrateKbps = 0;                    ///< Average bitrate, if known
+        QString errorMessage;                   ///< Reason for failure when isValid is false
+
+        /**
+         * @brief Duration rounded down to milliseconds
+         */
+        qint64 durationMs() const { return durationUs / 1000; }
+
+        /**
+         * @brief Duration formatted the way the musics.time column stores it
+         * @return Duration as "H:MM:SS", or empty string if invalid
+         */
+        QString durationString() const { return isValid ? formatDuration(durationUs) : QString(); }
+    };
+
+    /**
+     * @brief Probe a file and return its duration and stream parameters
+     * @param filePath Path of the audio file
+     * @return ProbeResult describing the file
+     */
+    static ProbeResult probe(const QString& filePath);
+
+    /**
+     * @brief Convenience wrapper returning only the duration
+     * @param filePath Path of the audio file
+     * @return Duration in microseconds, or -1 if it could not be determined
+     */
+    static qint64 durationUs(const QString& filePath);
+
+    /**
+     * @brief Format a duration in microseconds as "H:MM:SS"
+     * @param durationUs Duration in microseconds
+     * @return Formatted string
+     */
+    static QString formatDuration(qint64 durationUs);
+
+    /**
+     * @brief Get a human readable name for a container
+     * @param container Container type
+     * @return Container name
+     */
+    static QString containerName(Container container);
+
+private:
+    static Container detectContainer(const QByteArray& head, const QString& filePath);
+    static qint64 id3v2Size(const QByteArray& head);
+
+    static bool probeWav(QFile& file, ProbeResult& result);
+    static bool probeFlac(QFile& file, qint64 offset, ProbeResult& result);
+    static bool probeOgg(QFile& file, ProbeResult& result);
+    static bool probeMpeg(QFile& file, qint64 offset, ProbeResult& result);
+    static bool probeMp4(QFile& file, ProbeResult& result);
+
+    static constexpr int HEAD_READ_SIZE = 64 * 1024;
+    static constexpr int OGG_TAIL_READ_SIZE = 64 * 1024;
+    static constexpr qint64 MP4_MAX_MOOV_SIZE = 64 * 1024 * 1024;
+};
+
+#endif // MEDIAPROBE_H
@@ -0,0 +1,308 @@
+#include "MemoryBudget.h"
+#include "MemoryPressureMonitor.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFile>
+#include <QSqlDatabase>
+#include <QSqlDriver>
+#include <QTimer>
+#include <algorithm>
+#include <limits>
+#include <sqlite3.h>
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+namespace {
+
+bool isMetricName(const QString& name)
+{
+    if (name.isEmpty() || name.at(0).isDigit()) {
+        return false;
+    }
+    return std::all_of(name.cbegin(), name.cend(), [](QChar c) {
+        return (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_';
+    });
+}
+
+} // namespace
+
+MemoryBudget* MemoryBudget::instance()
+{
+    static QPointer<MemoryBudget> budget;
+    if (!budget) {
+        budget = new MemoryBudget(QCoreApplication::instance());
+    }
+    return budget;
+}
+
+MemoryBudget::MemoryBudget(QObject* parent)
+    : QObject(parent)
+    , m_timer(new QTimer(this))
+    , m_pressureMonitor(new MemoryPressureMonitor(this))
+{
+    m_timer->setInterval(CHECK_INTERVAL_MS);
+    connect(m_timer, &QTimer::timeout, this, &MemoryBudget::check);
+    connect(m_pressureMonitor, &MemoryPressureMonitor::pressureDetected, this,
+            &MemoryBudget::relieve);
+}
+
+MemoryBudget::~MemoryBudget() = default;
+
+bool MemoryBudget::addSubsystem(const QString& name, QObject* context, qint64 budgetBytes,
+                                Usage usage, Shrink shrink)
+{
+    if (!isMetricName(name) || !context || !usage) {
+        qWarning() << "MemoryBudget: refusing subsystem" << name;
+        return false;
+    }
+
+    Subsystem subsystem;
+    subsystem.name = name;
+    subsystem.context = context;
+    subsystem.budgetBytes = qMax<qint64>(0, budgetBytes);
+    subsystem.usage = std::move(usage);
+    subsystem.shrink = std::move(shrink);
+
+    if (Subsystem* existing = find(name)) {
+        *existing = std::move(subsystem);
+    } else {
+        m_subsystems.append(std::move(subsystem));
+    }
+    return true;
+}
+
+void MemoryBudget::removeSubsystem(const QString& name)
+{
+    m_subsystems.erase(std::remove_if(m_subsystems.begin(), m_subsystems.end(),
+                                      [&name](const Subsystem& subsystem) {
+                                          return subsystem.name == name;
+                                      }),
+                       m_subsystems.end());
+}
+
+QStringList MemoryBudget::subsystems() const
+{
+    QStringList names;
+    for (const Subsystem& subsystem : m_subsystems) {
+        if (subsystem.context) {
+            names.append(subsystem.name);
+        }
+    }
+    return names;
+}
+
+void MemoryBudget::setBudget(const QString& name, qint64 bytes)
+{
+    if (Subsystem* subsystem = find(name)) {
+        subsystem->budgetBytes = qMax<qint64>(0, bytes);
+    }
+}
+
+qint64 MemoryBudget::budget(const QString& name) const
+{
+    const Subsystem* subsystem = find(name);
+    return subsystem ? subsystem->budgetBytes : 0;
+}
+
+void MemoryBudget::start()
+{
+    m_timer->start();
+    if (!m_pressureMonitor->start()) {
+        qDebug() << "MemoryBudget: no memory pressure source, checking on the timer alone";
+    }
+}
+
+void MemoryBudget::stop()
+{
+    m_timer->stop();
+    m_pressureMonitor->stop();
+}
+
+int MemoryBudget::check()
+{
+    prune();
+
+    int shrunk = 0;
+    // Hooks may register or drop subsystems, so the list is walked by index
+    for (int i = 0; i < m_subsystems.size(); ++i) {
+        Subsystem& subsystem = m_subsystems[i];
+        if (subsystem.budgetBytes <= 0) {
+            continue;
+        }
+        const qint64 bytes = subsystem.usage();
+        if (bytes <= subsystem.budgetBytes) {
+            continue;
+        }
+
+        const QString name = subsystem.name;
+        const qint64 budgetBytes = subsystem.budgetBytes;
+        if (subsystem.shrink) {
+            ++subsystem.shrinks;
+            ++m_shrinks;
+            ++shrunk;
+            const Shrink shrink = subsystem.shrink;
+            shrink(budgetBytes * SHRINK_TARGET_PERCENT / 100);
+        }
+        emit budgetExceeded(name, bytes, budgetBytes);
+    }
+
+    const qint64 resident = residentBytes();
+    if (m_envelopeBytes > 0 && resident > m_envelopeBytes) {
+        qWarning() << "MemoryBudget: resident size" << resident / (1024 * 1024)
+                   << "MB is over the envelope of" << m_envelopeBytes / (1024 * 1024) << "MB";
+        shrunk += relieve();
+        emit envelopeExceeded(resident, m_envelopeBytes);
+    }
+    return shrunk;
+}
+
+int MemoryBudget::relieve()
+{
+    prune();
+
+    int shrunk = 0;
+    for (int i = 0; i < m_subsystems.size(); ++i) {
+        Subsystem& subsystem = m_subsystems[i];
+        if (!subsystem.shrink) {
+            continue;
+        }
+        const qint64 bytes = subsystem.usage();
+        if (bytes <= 0) {
+            continue;
+        }
+        ++subsystem.shrinks;
+        ++m_shrinks;
+        ++shrunk;
+        const Shrink shrink = subsystem.shrink;
+        shrink(bytes / 2);
+    }
+    return shrunk;
+}
+
+QList<MemoryBudget::Report> MemoryBudget::report()
+{
+    prune();
+
+    QList<Report> reports;
+    reports.reserve(m_subsystems.size());
+    for (const Subsystem& subsystem : std::as_const(m_subsystems)) {
+        Report report;
+        report.name = subsystem.name;
+        report.bytes = subsystem.usage();
+        report.budgetBytes = subsystem.budgetBytes;
+        report.shrinks = subsystem.shrinks;
+        report.shrinkable = bool(subsystem.shrink);
+        reports.append(report);
+    }
+    return reports;
+}
+
+qint64 MemoryBudget::accountedBytes()
+{
+    qint64 total = 0;
+    for (const Report& report : report()) {
+        total += qMax<qint64>(0, report.bytes);
+    }
+    return total;
+}
+
+void MemoryBudget::exportTo(MetricsRegistry& registry)
+{
+    qint64 total = 0;
+    for (const Report& report : report()) {
+        const qint64 bytes = qMax<qint64>(0, report.bytes);
+        total += bytes;
+        registry.gauge(QString("xfb_memory_%1_bytes").arg(report.name),
+                       QString("Memory held by %1").arg(report.name))
+            ->set(double(bytes));
+        if (report.budgetBytes > 0) {
+            registry.gauge(QString("xfb_memory_%1_budget_bytes").arg(report.name),
+                           QString("Soft memory budget of %1").arg(report.name))
+                ->set(double(report.budgetBytes));
+        }
+    }
+    registry.gauge("xfb_memory_accounted_bytes", "Memory held by the accounted subsystems")
+        ->set(double(total));
+    registry.gauge("xfb_memory_resident_bytes", "Resident size of the process")
+        ->set(double(residentBytes()));
+    registry.gauge("xfb_memory_envelope_bytes", "Resident size the process should stay under")
+        ->set(double(m_envelopeBytes));
+    registry.counter("xfb_memory_shrinks_total", "Subsystems asked to give memory back")
+        ->set(m_shrinks);
+}
+
+qint64 MemoryBudget::residentBytes()
+{
+#ifdef Q_OS_LINUX
+    // Total and resident pages, then the rest, on one line
+    QFile file("/proc/self/statm");
+    if (!file.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+    const QList<QByteArray> fields = file.readLine().split(' ');
+    bool ok = false;
+    const qint64 pages = fields.size() > 1 ? fields.at(1).toLongLong(&ok) : 0;
+    return ok ? pages * ::sysconf(_SC_PAGESIZE) : -1;
+#else
+    return -1;
+#endif
+}
+
+qint64 MemoryBudget::sqliteBytes()
+{
+    sqlite3_int64 current = 0;
+    sqlite3_int64 highwater = 0;
+    if (sqlite3_status64(SQLITE_STATUS_MEMORY_USED, &current, &highwater, 0) != SQLITE_OK) {
+        return -1;
+    }
+    return qint64(current);
+}
+
+void MemoryBudget::shrinkSqlite(qint64 targetBytes, const QSqlDatabase& database)
+{
+    if (database.isOpen() && database.driver()) {
+        const QVariant handle = database.driver()->handle();
+        if (handle.isValid() && qstrcmp(handle.typeName(), "sqlite3*") == 0) {
+            if (sqlite3* connection = *static_cast<sqlite3* const*>(handle.constData())) {
+                sqlite3_db_release_memory(connection);
+            }
+        }
+    }
+
+    // Frees anything only in an SQLite built with SQLITE_ENABLE_MEMORY_MANAGEMENT
+    const qint64 excess = sqliteBytes() - qMax<qint64>(0, targetBytes);
+    if (excess > 0) {
+        sqlite3_release_memory(int(qMin<qint64>(excess, std::numeric_limits<int>::max())));
+    }
+}
+
+void MemoryBudget::prune()
+{
+    m_subsystems.erase(std::remove_if(m_subsystems.begin(), m_subsystems.end(),
+                                      [](const Subsystem& subsystem) {
+                                          return subsystem.context.isNull();
+                                      }),
+                       m_subsystems.end());
+}
+
+MemoryBudget::Subsystem* MemoryBudget::find(const QString& name)
+{
+    for (Subsystem& subsystem : m_subsystems) {
+        if (subsystem.name == name) {
+            return &subsystem;
+        }
+    }
+    return nullptr;
+}
+
+const MemoryBudget::Subsystem* MemoryBudget::find(const QString& name) const
+{
+    for (const Subsystem& subsystem : m_subsystems) {
+        if (subsystem.name == name) {
+            return &subsystem;
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,197 @@
+#ifndef MEMORYBUDGET_H
+#define MEMORYBUDGET_H
+
+#include "MetricsRegistry.h"
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <QStringList>
+#include <functional>
+
+class MemoryPressureMonitor;
+class QSqlDatabase;
+class QTimer;
+
+/**
+ * @brief Where the memory of XFB goes, and soft limits that keep it small
+ *
+ * The caches, models and buffers of the application each know what they
+ * hold, but nothing added it up, so the only figure was the RSS of the
+ * whole process. Each subsystem registers here with a functor reporting
+ * its bytes, a soft budget, and optionally a shrink hook, and the totals
+ * are exported through MetricsRegistry with exportTo().
+ *
+ * check() runs every CHECK_INTERVAL_MS once start() was called. A
+ * subsystem over its budget is asked to shrink to SHRINK_TARGET_PERCENT of
+ * it. When the resident size of the process is over the envelope, or the
+ * kernel reports memory pressure (see MemoryPressureMonitor), every
+ * subsystem is asked to give up half of what it holds, since anything kept
+ * in a cache then competes with the audio for the little memory there is.
+ *
+ * Budgets are soft: a subsystem without a shrink hook, such as the audio
+ * buffers, is only reported. Usage functors and hooks run on the thread of
+ * the budget, the GUI thread, and should be cheap; they run on every check
+ * and every export.
+ *
+ * @example
+ * @code
+ * MemoryBudget* budget = MemoryBudget::instance();
+ * budget->addSubsystem("search_cache", cache, 16 * 1024 * 1024,
+ *                      [cache]() { return cache->currentMemoryUsage(); },
+ *                      [cache](qint64 bytes) { cache->cleanup(bytes); });
+ * budget->start();
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class MemoryBudget : public QObject
+{
+    Q_OBJECT
+
+public:
+    /// Resident size the small studio PCs leave to XFB
+    static constexpr qint64 DEFAULT_ENVELOPE_BYTES = 512LL * 1024 * 1024;
+    static constexpr int CHECK_INTERVAL_MS = 10000;
+    static constexpr int SHRINK_TARGET_PERCENT = 80;   ///< Of the budget, after going over it
+
+    using Usage = std::function<qint64()>;
+    using Shrink = std::function<void(qint64 targetBytes)>;
+
+    /**
+     * @brief What a subsystem held at the last report
+     */
+    struct Report {
+        QString name;
+        qint64 bytes = 0;
+        qint64 budgetBytes = 0;
+        int shrinks = 0;          ///< Times it was asked to shrink
+        bool shrinkable = false;
+    };
+
+    /**
+     * @brief The budget of the application, made on first use; call it first on the GUI thread
+     */
+    static MemoryBudget* instance();
+
+    explicit MemoryBudget(QObject* parent = nullptr);
+    ~MemoryBudget() override;
+
+    /**
+     * @brief Account for a subsystem until its context is destroyed
+     *
+     * A name already registered is replaced.
+     * @param name Lower case letters, digits and '_', as it appears in the metric names
+     * @param context Object the subsystem belongs to
+     * @param budgetBytes Soft budget; 0 for none
+     * @param usage Bytes the subsystem holds
+     * @param shrink Frees memory until the subsystem holds at most the given bytes, or nothing
+     * @return false if the name or the functors are unusable
+     */
+    bool addSubsystem(const QString& name, QObject* context, qint64 budgetBytes, Usage usage,
+                      Shrink shrink = Shrink());
+
+    void removeSubsystem(const QString& name);
+    QStringList subsystems() const;
+
+    void setBudget(const QString& name, qint64 bytes);
+    qint64 budget(const QString& name) const;
+
+    /**
+     * @brief Set the resident size the whole process should stay under; 0 for none
+     */
+    void setEnvelope(qint64 bytes) { m_envelopeBytes = qMax<qint64>(0, bytes); }
+    qint64 envelope() const { return m_envelopeBytes; }
+
+    /**
+     * @brief Check every CHECK_INTERVAL_MS and on memory pressure
+     */
+    void start();
+    void stop();
+
+    /**
+     * @brief Shrink the subsystems over their budget, and all of them when over the envelope
+     * @return Subsystems asked to shrink
+     */
+    int check();
+
+    /**
+     * @brief Have every shrinkable subsystem give up half of what it holds
+     * @return Subsystems asked to shrink
+     */
+    int relieve();
+
+    /**
+     * @brief Usage of every subsystem, in the order they were registered
+     */
+    QList<Report> report();
+
+    /**
+     * @brief Bytes of all the subsystems together
+     */
+    qint64 accountedBytes();
+
+    /**
+     * @brief Update the memory gauges of a registry, from a collector
+     *
+     * Each subsystem has xfb_memory_<name>_bytes and, with a budget,
+     * xfb_memory_<name>_budget_bytes.
+     */
+    void exportTo(MetricsRegistry& registry);
+
+    /**
+     * @brief Resident size of this process, from /proc/self/statm; -1 if unknown
+     */
+    static qint64 residentBytes();
+
+    /**
+     * @brief Heap the SQLite library holds: page cache, schemas and statements
+     *
+     * As sqlite3_status64() reports it for the SQLite XFB links, which is
+     * the one the Qt driver uses unless Qt bundles its own.
+     */
+    static qint64 sqliteBytes();
+
+    /**
+     * @brief Have SQLite drop cached pages until it holds at most the given bytes
+     *
+     * The unused pages of the given connection are released, then the
+     * library is asked to free the rest of what is over the target.
+     * @param targetBytes Heap to keep to
+     * @param database Open QSQLITE connection of this thread, if any
+     */
+    static void shrinkSqlite(qint64 targetBytes, const QSqlDatabase& database);
+
+signals:
+    /**
+     * @brief Emitted when a check finds a subsystem over its budget
+     */
+    void budgetExceeded(const QString& name, qint64 bytes, qint64 budgetBytes);
+
+    /**
+     * @brief Emitted when a check finds the process over the envelope
+     */
+    void envelopeExceeded(qint64 residentBytes, qint64 envelopeBytes);
+
+private:
+    struct Subsystem {
+        QString name;
+        QPointer<QObject> context;
+        qint64 budgetBytes = 0;
+        Usage usage;
+        Shrink shrink;
+        int shrinks = 0;
+    };
+
+    void prune();
+    Subsystem* find(const QString& name);
+    const Subsystem* find(const QString& name) const;
+
+    QList<Subsystem> m_subsystems;
+    qint64 m_envelopeBytes = DEFAULT_ENVELOPE_BYTES;
+    qint64 m_shrinks = 0;
+    QTimer* m_timer;
+    MemoryPressureMonitor* m_pressureMonitor;
+};
+
+#endif // MEMORYBUDGET_H
@@ -0,0 +1,161 @@
+#include "MemoryPressureMonitor.h"
+#include <QDebug>
+#include <QFile>
+#include <QFileSystemWatcher>
+#include <QSocketNotifier>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+QByteArray readFile(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    return file.readAll();
+}
+
+} // namespace
+
+MemoryPressureMonitor::MemoryPressureMonitor(QObject* parent)
+    : QObject(parent)
+{
+}
+
+MemoryPressureMonitor::~MemoryPressureMonitor()
+{
+    stop();
+}
+
+bool MemoryPressureMonitor::start()
+{
+    if (m_source != Source::None) {
+        return true;
+    }
+    return watchPsi("/proc/pressure/memory") || watchCgroupEvents(defaultCgroupEventsPath());
+}
+
+void MemoryPressureMonitor::stop()
+{
+    delete m_psiNotifier;
+    m_psiNotifier = nullptr;
+#ifdef Q_OS_LINUX
+    if (m_psiFd >= 0) {
+        ::close(m_psiFd);
+    }
+#endif
+    m_psiFd = -1;
+
+    delete m_eventsWatcher;
+    m_eventsWatcher = nullptr;
+    m_eventsPath.clear();
+    m_source = Source::None;
+}
+
+bool MemoryPressureMonitor::watchPsi(const QString& path)
+{
+#ifdef Q_OS_LINUX
+    stop();
+    const int fd = ::open(QFile::encodeName(path).constData(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    // The kernel signals POLLPRI on the descriptor each time the stall threshold is crossed
+    const QByteArray trigger = QByteArray("some ") + QByteArray::number(PSI_STALL_US) + ' '
+                               + QByteArray::number(PSI_WINDOW_US);
+    if (::write(fd, trigger.constData(), size_t(trigger.size()) + 1) < 0) {
+        ::close(fd);
+        return false;
+    }
+
+    m_psiFd = fd;
+    m_psiNotifier = new QSocketNotifier(fd, QSocketNotifier::Exception, this);
+    connect(m_psiNotifier, &QSocketNotifier::activated, this,
+            &MemoryPressureMonitor::onPsiActivated);
+    m_source = Source::Psi;
+    qDebug() << "MemoryPressureMonitor: Watching" << path;
+    return true;
+#else
+    Q_UNUSED(path);
+    return false;
+#endif
+}
+
+bool MemoryPressureMonitor::watchCgroupEvents(const QString& path)
+{
+    stop();
+    if (path.isEmpty()) {
+        return false;
+    }
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    m_eventCount = pressureEventCount(file.readAll());
+
+    m_eventsWatcher = new QFileSystemWatcher(this);
+    if (!m_eventsWatcher->addPath(path)) {
+        delete m_eventsWatcher;
+        m_eventsWatcher = nullptr;
+        return false;
+    }
+    connect(m_eventsWatcher, &QFileSystemWatcher::fileChanged, this,
+            &MemoryPressureMonitor::onCgroupEventsChanged);
+    m_eventsPath = path;
+    m_source = Source::CgroupEvents;
+    qDebug() << "MemoryPressureMonitor: Watching" << path;
+    return true;
+}
+
+QString MemoryPressureMonitor::defaultCgroupEventsPath()
+{
+    // cgroup v2 lists the process as "0::/path/of/the/group"
+    const QList<QByteArray> lines = readFile("/proc/self/cgroup").split('\n');
+    for (const QByteArray& line : lines) {
+        if (line.startsWith("0::")) {
+            const QString group = QString::fromUtf8(line.mid(3)).trimmed();
+            const QString path = "/sys/fs/cgroup" + (group == "/" ? QString() : group)
+                                 + "/memory.events";
+            return QFile::exists(path) ? path : QString();
+        }
+    }
+    return QString();
+}
+
+qint64 MemoryPressureMonitor::pressureEventCount(const QByteArray& memoryEvents)
+{
+    qint64 count = 0;
+    for (const QByteArray& line : memoryEvents.split('\n')) {
+        const QList<QByteArray> fields = line.simplified().split(' ');
+        if (fields.size() != 2) {
+            continue;
+        }
+        if (fields[0] == "high" || fields[0] == "max" || fields[0] == "oom") {
+            count += fields[1].toLongLong();
+        }
+    }
+    return count;
+}
+
+void MemoryPressureMonitor::onPsiActivated()
+{
+    emit pressureDetected();
+}
+
+void MemoryPressureMonitor::onCgroupEventsChanged(const QString& path)
+{
+    // Some file systems drop the watch on change; keep it
+    if (!m_eventsWatcher->files().contains(path)) {
+        m_eventsWatcher->addPath(path);
+    }
+    const qint64 count = pressureEventCount(readFile(path));
+    if (count > m_eventCount) {
+        m_eventCount = count;
+        emit pressureDetected();
+    }
+}
@@ -0,0 +1,106 @@
+#ifndef MEMORYPRESSUREMONITOR_H
+#define MEMORYPRESSUREMONITOR_H
+
+#include <QObject>
+#include <QString>
+
+class QFileSystemWatcher;
+class QSocketNotifier;
+
+/**
+ * @brief Tells when the system runs short of memory, without polling
+ *
+ * On Linux the kernel reports memory pressure in two ways, and the monitor
+ * waits on whichever it can use:
+ * - a PSI trigger on /proc/pressure/memory, which wakes the monitor when
+ *   tasks stall on memory for PSI_STALL_US within PSI_WINDOW_US;
+ * - the memory.events file of the process's cgroup, whose high, max and
+ *   oom counters rise when the cgroup hits its limits. The file is watched
+ *   through QFileSystemWatcher, as the kernel notifies it on each change.
+ *
+ * Where neither is available, as on other platforms, start() returns false
+ * and pressureDetected() is never emitted.
+ *
+ * @example
+ * @code
+ * auto* monitor = new MemoryPressureMonitor(this);
+ * connect(monitor, &MemoryPressureMonitor::pressureDetected, this, &MyCache::trim);
+ * monitor->start();
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class MemoryPressureMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class Source {
+        None,
+        Psi,
+        CgroupEvents
+    };
+
+    static constexpr int PSI_STALL_US = 150000;
+    static constexpr int PSI_WINDOW_US = 2000000;  ///< Least window allowed without privileges
+
+    explicit MemoryPressureMonitor(QObject* parent = nullptr);
+    ~MemoryPressureMonitor() override;
+
+    /**
+     * @brief Watch the system PSI file, or failing that the cgroup's memory.events
+     * @return true if a source is being watched
+     */
+    bool start();
+
+    /**
+     * @brief Stop watching
+     */
+    void stop();
+
+    /**
+     * @brief Arm a PSI trigger on the given pressure file
+     * @param path Usually /proc/pressure/memory
+     * @return true if the trigger was accepted
+     */
+    bool watchPsi(const QString& path);
+
+    /**
+     * @brief Watch a cgroup v2 memory.events file
+     * @param path Path of the memory.events file
+     * @return true if the file could be read and watched
+     */
+    bool watchCgroupEvents(const QString& path);
+
+    Source source() const { return m_source; }
+
+    /**
+     * @brief The memory.events file of this process's cgroup, or empty if unknown
+     */
+    static QString defaultCgroupEventsPath();
+
+    /**
+     * @brief Sum of the high, max and oom counters of a memory.events file
+     */
+    static qint64 pressureEventCount(const QByteArray& memoryEvents);
+
+signals:
+    /**
+     * @brief Emitted when the kernel reports memory pressure
+     */
+    void pressureDetected();
+
+private slots:
+    void onPsiActivated();
+    void onCgroupEventsChanged(const QString& path);
+
+private:
+    Source m_source = Source::None;
+    int m_psiFd = -1;
+    QSocketNotifier* m_psiNotifier = nullptr;
+    QFileSystemWatcher* m_eventsWatcher = nullptr;
+    QString m_eventsPath;
+    qint64 m_eventCount = 0;
+};
+
+#endif // MEMORYPRESSUREMONITOR_H
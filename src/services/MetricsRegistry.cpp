@@ -0,0 +1,241 @@
+#include "MetricsRegistry.h"
+#include <QDebug>
+#include <QMutexLocker>
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+QByteArray formatValue(double value)
+{
+    if (qIsNaN(value)) {
+        return "NaN";
+    }
+    if (qIsInf(value)) {
+        return value > 0 ? "+Inf" : "-Inf";
+    }
+    return QByteArray::number(value, 'g', 15);
+}
+
+// HELP text may hold anything but a raw backslash or line break
+QByteArray escapeHelp(const QString& help)
+{
+    QByteArray escaped = help.toUtf8();
+    escaped.replace('\\', "\\\\");
+    escaped.replace('\n', "\\n");
+    return escaped;
+}
+
+QString quantileLabel(double quantile)
+{
+    return QString::number(quantile, 'g', 6);
+}
+
+} // namespace
+
+qint64 MetricsRegistry::Histogram::percentile(double percent) const
+{
+    const qint64 total = count();
+    if (total == 0) {
+        return 0;
+    }
+    const double share = qBound(0.0, percent, 100.0) / 100.0;
+    const qint64 rank = qMax<qint64>(1, qint64(std::ceil(share * double(total))));
+
+    // Buckets are read while other threads record, so the walk can come up
+    // short of a rank counted a moment ago; the last bucket then answers
+    qint64 seen = 0;
+    for (int bucket = 0; bucket < BUCKET_COUNT; ++bucket) {
+        seen += m_buckets[bucket].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            return qMin(bucketUpperBound(bucket), max());
+        }
+    }
+    return max();
+}
+
+qint64 MetricsRegistry::Histogram::bucketUpperBound(int bucket)
+{
+    const int shift = bucket / SUB_BUCKETS - 1;
+    if (shift <= 0) {
+        return bucket;
+    }
+    const int subBucket = bucket % SUB_BUCKETS;
+    return (qint64(SUB_BUCKETS + subBucket + 1) << shift) - 1;
+}
+
+MetricsRegistry& MetricsRegistry::instance()
+{
+    static MetricsRegistry registry;
+    return registry;
+}
+
+bool MetricsRegistry::isValidName(const QString& name)
+{
+    if (name.isEmpty() || name.at(0).isDigit()) {
+        return false;
+    }
+    for (const QChar c : name) {
+        const bool letter = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+        const bool digit = c >= '0' && c <= '9';
+        if (!letter && !digit && c != '_' && c != ':') {
+            return false;
+        }
+    }
+    return true;
+}
+
+MetricsRegistry::Counter* MetricsRegistry::counter(const QString& name, const QString& help)
+{
+    Metric* metric = find(name, Kind::Counter, help);
+    return metric ? metric->counter.get() : nullptr;
+}
+
+MetricsRegistry::Gauge* MetricsRegistry::gauge(const QString& name, const QString& help)
+{
+    Metric* metric = find(name, Kind::Gauge, help);
+    return metric ? metric->gauge.get() : nullptr;
+}
+
+MetricsRegistry::Histogram* MetricsRegistry::histogram(const QString& name, const QString& help)
+{
+    Metric* metric = find(name, Kind::Histogram, help);
+    return metric ? metric->histogram.get() : nullptr;
+}
+
+MetricsRegistry::Metric* MetricsRegistry::find(const QString& name, Kind kind, const QString& help)
+{
+    if (!isValidName(name)) {
+        qWarning() << "MetricsRegistry: invalid metric name" << name;
+        return nullptr;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    auto it = m_metrics.find(name);
+    if (it != m_metrics.end()) {
+        if (it->second.kind != kind) {
+            qWarning() << "MetricsRegistry: metric" << name << "already exists with another type";
+            return nullptr;
+        }
+        return &it->second;
+    }
+
+    Metric& metric = m_metrics[name];
+    metric.kind = kind;
+    metric.help = help;
+    switch (kind) {
+    case Kind::Counter:
+        metric.counter = std::make_unique<Counter>();
+        break;
+    case Kind::Gauge:
+        metric.gauge = std::make_unique<Gauge>();
+        break;
+    case Kind::Histogram:
+        metric.histogram = std::make_unique<Histogram>();
+        break;
+    }
+    return &metric;
+}
+
+void MetricsRegistry::addCollector(QObject* context, Collector collector)
+{
+    if (!context || !collector) {
+        return;
+    }
+    QMutexLocker locker(&m_mutex);
+    m_collectors.append({QPointer<QObject>(context), std::move(collector)});
+}
+
+void MetricsRegistry::collect()
+{
+    QList<CollectorEntry> collectors;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_collectors.erase(std::remove_if(m_collectors.begin(), m_collectors.end(),
+                                          [](const CollectorEntry& entry) {
+                                              return entry.context.isNull();
+                                          }),
+                           m_collectors.end());
+        collectors = m_collectors;
+    }
+
+    // Collectors create metrics, so they run without m_mutex held
+    for (const CollectorEntry& entry : collectors) {
+        if (entry.context) {
+            entry.collector(*this);
+        }
+    }
+}
+
+QByteArray MetricsRegistry::toPrometheus()
+{
+    QMutexLocker collectLocker(&m_collectMutex);
+    collect();
+
+    QByteArray text;
+    QMutexLocker locker(&m_mutex);
+    for (const auto& [name, metric] : m_metrics) {
+        const QByteArray id = name.toUtf8();
+        if (!metric.help.isEmpty()) {
+            text += "# HELP " + id + ' ' + escapeHelp(metric.help) + '\n';
+        }
+        switch (metric.kind) {
+        case Kind::Counter:
+            text += "# TYPE " + id + " counter\n";
+            text += id + ' ' + QByteArray::number(metric.counter->value()) + '\n';
+            break;
+        case Kind::Gauge:
+            text += "# TYPE " + id + " gauge\n";
+            text += id + ' ' + formatValue(metric.gauge->value()) + '\n';
+            break;
+        case Kind::Histogram: {
+            const Histogram& histogram = *metric.histogram;
+            text += "# TYPE " + id + " summary\n";
+            for (double quantile : exportedQuantiles()) {
+                text += id + "{quantile=\"" + quantileLabel(quantile).toLatin1() + "\"} " +
+                        QByteArray::number(histogram.percentile(quantile * 100.0)) + '\n';
+            }
+            text += id + "_sum " + QByteArray::number(histogram.sum()) + '\n';
+            text += id + "_count " + QByteArray::number(histogram.count()) + '\n';
+            break;
+        }
+        }
+    }
+    return text;
+}
+
+QJsonObject MetricsRegistry::toJson()
+{
+    QMutexLocker collectLocker(&m_collectMutex);
+    collect();
+
+    QJsonObject json;
+    QMutexLocker locker(&m_mutex);
+    for (const auto& [name, metric] : m_metrics) {
+        switch (metric.kind) {
+        case Kind::Counter:
+            json.insert(name, double(metric.counter->value()));
+            break;
+        case Kind::Gauge:
+            json.insert(name, metric.gauge->value());
+            break;
+        case Kind::Histogram: {
+            const Histogram& histogram = *metric.histogram;
+            QJsonObject quantiles;
+            for (double quantile : exportedQuantiles()) {
+                quantiles.insert(quantileLabel(quantile),
+                                 double(histogram.percentile(quantile * 100.0)));
+            }
+            QJsonObject object;
+            object.insert("count", double(histogram.count()));
+            object.insert("sum", double(histogram.sum()));
+            object.insert("max", double(histogram.max()));
+            object.insert("quantiles", quantiles);
+            json.insert(name, object);
+            break;
+        }
+        }
+    }
+    return json;
+}
@@ -0,0 +1,247 @@
+#ifndef METRICSREGISTRY_H
+#define METRICSREGISTRY_H
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <QtAlgorithms>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+
+/**
+ * @brief Counters, gauges and latency histograms of the whole application
+ *
+ * Each service used to keep its own statistics behind its own getter,
+ * and none of them were visible outside the GUI. MetricsRegistry is the
+ * one place they are gathered, in a form that MetricsServer exports as
+ * Prometheus text or JSON.
+ *
+ * Metrics are created once by name and live as long as the registry, so
+ * the returned pointers can be kept. Updating one is a relaxed atomic
+ * operation; it never locks or allocates and is safe on the audio
+ * thread.
+ *
+ * Statistics that a service already counts are pulled rather than
+ * pushed: a collector registered with addCollector() copies them into
+ * the registry before each export.
+ *
+ * Histogram buckets follow HdrHistogram: SUB_BUCKETS linear buckets per
+ * power of two, so every bucket is within 1/SUB_BUCKETS of its values.
+ * Quantiles are exported as a Prometheus summary.
+ *
+ * @example
+ * @code
+ * MetricsRegistry& metrics = MetricsRegistry::instance();
+ * MetricsRegistry::Histogram* render =
+ *     metrics.histogram("xfb_audio_render_microseconds", "Time to mix one audio block");
+ * render->record(elapsedUs);   // any thread
+ * metrics.addCollector(this, [this](MetricsRegistry& registry) {
+ *     registry.gauge("xfb_playlist_items", "Items in the playlist")->set(playlist->count());
+ * });
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class MetricsRegistry
+{
+public:
+    /**
+     * @brief A count that only goes up
+     */
+    class Counter
+    {
+    public:
+        void add(qint64 amount = 1) { m_value.fetch_add(amount, std::memory_order_relaxed); }
+
+        /**
+         * @brief Copy a total that is counted elsewhere, from a collector
+         */
+        void set(qint64 total) { m_value.store(total, std::memory_order_relaxed); }
+
+        qint64 value() const { return m_value.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<qint64> m_value{0};
+    };
+
+    /**
+     * @brief A value that goes up and down
+     */
+    class Gauge
+    {
+    public:
+        void set(double value) { m_value.store(value, std::memory_order_relaxed); }
+        double value() const { return m_value.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<double> m_value{0.0};
+    };
+
+    /**
+     * @brief Distribution of non-negative integer values, such as latencies
+     */
+    class Histogram
+    {
+    public:
+        static constexpr int SUB_BUCKET_BITS = 3;
+        static constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+        static constexpr int MAX_MAGNITUDE = 47;   ///< Values from 2^48 on share the last bucket
+        static constexpr int BUCKET_COUNT = SUB_BUCKETS * (MAX_MAGNITUDE - SUB_BUCKET_BITS + 2);
+
+        /**
+         * @brief Count a value; negative values count as 0
+         */
+        void record(qint64 value)
+        {
+            value = qMax<qint64>(value, 0);
+            m_buckets[bucketFor(value)].fetch_add(1, std::memory_order_relaxed);
+            m_sum.fetch_add(value, std::memory_order_relaxed);
+            qint64 max = m_max.load(std::memory_order_relaxed);
+            while (value > max &&
+                   !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+            }
+            m_count.fetch_add(1, std::memory_order_release);
+        }
+
+        qint64 count() const { return m_count.load(std::memory_order_acquire); }
+        qint64 sum() const { return m_sum.load(std::memory_order_relaxed); }
+        qint64 max() const { return m_max.load(std::memory_order_relaxed); }
+
+        /**
+         * @brief Forget every value; one recorded meanwhile may be partly kept
+         */
+        void reset()
+        {
+            for (std::atomic<qint64>& bucket : m_buckets) {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+            m_sum.store(0, std::memory_order_relaxed);
+            m_max.store(0, std::memory_order_relaxed);
+            m_count.store(0, std::memory_order_release);
+        }
+
+        /**
+         * @brief Get the value below which a share of the values fall
+         * @param percent Share in percent, 0 to 100
+         * @return Highest value of the bucket holding that rank, at most max(); 0 if empty
+         */
+        qint64 percentile(double percent) const;
+
+        /**
+         * @brief Bucket a value is counted in
+         */
+        static int bucketFor(qint64 value)
+        {
+            if (value < SUB_BUCKETS) {
+                return int(value);
+            }
+            const int magnitude = 63 - qCountLeadingZeroBits(quint64(value));
+            if (magnitude > MAX_MAGNITUDE) {
+                return BUCKET_COUNT - 1;
+            }
+            const int shift = magnitude - SUB_BUCKET_BITS;
+            return SUB_BUCKETS * (shift + 1) + int(value >> shift) - SUB_BUCKETS;
+        }
+
+        /**
+         * @brief Highest value counted in a bucket
+         */
+        static qint64 bucketUpperBound(int bucket);
+
+    private:
+        std::array<std::atomic<qint64>, BUCKET_COUNT> m_buckets{};
+        std::atomic<qint64> m_count{0};
+        std::atomic<qint64> m_sum{0};
+        std::atomic<qint64> m_max{0};
+    };
+
+    /**
+     * @brief Copies statistics into the registry before an export
+     */
+    using Collector = std::function<void(MetricsRegistry&)>;
+
+    MetricsRegistry() = default;
+    MetricsRegistry(const MetricsRegistry&) = delete;
+    MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+    /**
+     * @brief The registry the application's services report to
+     */
+    static MetricsRegistry& instance();
+
+    /**
+     * @brief Get or create a metric
+     *
+     * Names follow the Prometheus rules: letters, digits, '_' and ':', not
+     * starting with a digit. A name already used by another kind of metric
+     * is refused.
+     * @param name Metric name; counters end in _total by convention
+     * @param help One line describing the metric
+     * @return Metric, valid as long as the registry; nullptr if the name is refused
+     */
+    Counter* counter(const QString& name, const QString& help);
+    Gauge* gauge(const QString& name, const QString& help);
+    Histogram* histogram(const QString& name, const QString& help);
+
+    /**
+     * @brief Run a collector before every export, until its context is destroyed
+     * @param context Object the collector belongs to
+     * @param collector Function that updates metrics from the context's statistics
+     */
+    void addCollector(QObject* context, Collector collector);
+
+    /**
+     * @brief Run the collectors and write the metrics in the Prometheus text format
+     */
+    QByteArray toPrometheus();
+
+    /**
+     * @brief Run the collectors and write the metrics as a JSON object, keyed by name
+     *
+     * Histograms become objects of count, sum, max and the exported quantiles.
+     */
+    QJsonObject toJson();
+
+    /**
+     * @brief Quantiles exported for each histogram
+     */
+    static QList<double> exportedQuantiles() { return {0.5, 0.9, 0.99, 0.999, 1.0}; }
+
+    /**
+     * @brief Check if a metric name is valid
+     */
+    static bool isValidName(const QString& name);
+
+private:
+    enum class Kind { Counter, Gauge, Histogram };
+
+    struct Metric {
+        Kind kind;
+        QString help;
+        std::unique_ptr<Counter> counter;
+        std::unique_ptr<Gauge> gauge;
+        std::unique_ptr<Histogram> histogram;
+    };
+
+    struct CollectorEntry {
+        QPointer<QObject> context;
+        Collector collector;
+    };
+
+    Metric* find(const QString& name, Kind kind, const QString& help);
+    void collect();
+
+    QMutex m_mutex;                       ///< Guards the maps; never taken to update a metric
+    std::map<QString, Metric> m_metrics;  ///< Sorted, so exports list metrics by name
+    QList<CollectorEntry> m_collectors;
+    QMutex m_collectMutex;                ///< One export at a time runs the collectors
+};
+
+#endif // METRICSREGISTRY_H
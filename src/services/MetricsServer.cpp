@@ -0,0 +1,135 @@
+#include "MetricsServer.h"
+#include "MetricsRegistry.h"
+#include <QDebug>
+#include <QJsonDocument>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <memory>
+
+MetricsServer::MetricsServer(MetricsRegistry* registry, QObject* parent)
+    : QObject(parent)
+    , m_registry(registry)
+    , m_server(new QTcpServer(this))
+{
+    connect(m_server, &QTcpServer::newConnection, this, &MetricsServer::onNewConnection);
+}
+
+MetricsServer::~MetricsServer() = default;
+
+bool MetricsServer::listen(quint16 port, const QHostAddress& address)
+{
+    close();
+    if (!m_server->listen(address, port)) {
+        logError("listen", QString("Cannot listen on %1:%2: %3")
+                               .arg(address.toString())
+                               .arg(port)
+                               .arg(m_server->errorString()));
+        return false;
+    }
+    qInfo() << "MetricsServer: serving metrics on port" << m_server->serverPort();
+    return true;
+}
+
+void MetricsServer::close()
+{
+    if (m_server->isListening()) {
+        m_server->close();
+    }
+}
+
+bool MetricsServer::isListening() const
+{
+    return m_server->isListening();
+}
+
+quint16 MetricsServer::port() const
+{
+    return m_server->isListening() ? m_server->serverPort() : 0;
+}
+
+void MetricsServer::addPath(const QByteArray& path, const QByteArray& contentType,
+                            std::function<QByteArray()> body)
+{
+    m_documents.insert(path, {contentType, std::move(body)});
+}
+
+void MetricsServer::onNewConnection()
+{
+    while (QTcpSocket* socket = m_server->nextPendingConnection()) {
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        QTimer::singleShot(REQUEST_TIMEOUT_MS, socket, [socket]() { socket->abort(); });
+
+        auto buffer = std::make_shared<QByteArray>();
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket, buffer]() {
+            *buffer += socket->readAll();
+            const qsizetype end = buffer->indexOf("\r\n\r\n");
+            if (end < 0 && buffer->size() <= MAX_REQUEST_BYTES) {
+                return;
+            }
+            // One request per connection; anything after it is ignored
+            disconnect(socket, &QTcpSocket::readyRead, this, nullptr);
+            if (end < 0 || end > MAX_REQUEST_BYTES) {
+                respond(socket, "431 Request Header Fields Too Large", "text/plain",
+                        "Request too large\n");
+                return;
+            }
+            handleRequest(socket, buffer->left(end));
+        });
+    }
+}
+
+void MetricsServer::handleRequest(QTcpSocket* socket, const QByteArray& head)
+{
+    const QList<QByteArray> requestLine = head.left(head.indexOf("\r\n")).split(' ');
+    const QByteArray method = requestLine.value(0);
+    QByteArray path = requestLine.value(1);
+    const qsizetype query = path.indexOf('?');
+    if (query >= 0) {
+        path.truncate(query);
+    }
+
+    const auto document = m_documents.constFind(path);
+    if (path != "/metrics" && path != "/metrics.json" && document == m_documents.constEnd()) {
+        respond(socket, "404 Not Found", "text/plain", "Not found\n");
+        return;
+    }
+    if (method != "GET" && method != "HEAD") {
+        respond(socket, "405 Method Not Allowed", "text/plain", "Only GET and HEAD\n");
+        return;
+    }
+
+    const bool withBody = method == "GET";
+    if (document != m_documents.constEnd()) {
+        respond(socket, "200 OK", document->contentType, document->body(), withBody);
+    } else if (path == "/metrics.json") {
+        respond(socket, "200 OK", "application/json",
+                QJsonDocument(m_registry->toJson()).toJson(QJsonDocument::Compact), withBody);
+    } else {
+        respond(socket, "200 OK", "text/plain; version=0.0.4; charset=utf-8",
+                m_registry->toPrometheus(), withBody);
+    }
+}
+
+void MetricsServer::respond(QTcpSocket* socket, const QByteArray& status,
+                            const QByteArray& contentType, const QByteArray& body, bool withBody)
+{
+    QByteArray response = "HTTP/1.1 " + status + "\r\n";
+    response += "Content-Type: " + contentType + "\r\n";
+    response += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+    if (status.startsWith("405")) {
+        response += "Allow: GET, HEAD\r\n";
+    }
+    response += "Connection: close\r\n\r\n";
+    if (withBody) {
+        response += body;
+    }
+    socket->write(response);
+    socket->disconnectFromHost();
+}
+
+void MetricsServer::logError(const QString& operation, const QString& error)
+{
+    qWarning() << QString("MetricsServer::%1 - %2").arg(operation, error);
+    emit operationError(operation, error);
+}
@@ -0,0 +1,117 @@
+#ifndef METRICSSERVER_H
+#define METRICSSERVER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QHostAddress>
+#include <QObject>
+#include <QString>
+#include <functional>
+
+class MetricsRegistry;
+class QTcpServer;
+class QTcpSocket;
+
+/**
+ * @brief HTTP endpoint that exports a MetricsRegistry
+ *
+ * Serves two read-only paths, so a Prometheus server or a plain curl can
+ * watch the station without touching the GUI:
+ * - GET /metrics: Prometheus text format 0.0.4
+ * - GET /metrics.json: the same metrics as one JSON object
+ *
+ * Other read-only documents, such as a trace, can be served next to them
+ * with addPath().
+ *
+ * Only as much HTTP as a scraper needs is spoken: one request per
+ * connection, no body, and the connection closes after the response.
+ * A request that is larger than MAX_REQUEST_BYTES or not complete within
+ * REQUEST_TIMEOUT_MS is dropped. Everything runs on the thread of the
+ * server, and the registry is only read, so the audio thread never waits
+ * for a scrape.
+ *
+ * The server listens on all addresses when asked to; metrics hold no
+ * secrets but file paths may appear in them, so bind it to localhost
+ * unless a scraper on another host needs it.
+ *
+ * @example
+ * @code
+ * MetricsServer* server = new MetricsServer(&MetricsRegistry::instance(), this);
+ * server->listen(9105, QHostAddress::LocalHost);
+ * // curl http://localhost:9105/metrics
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class MetricsServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int MAX_REQUEST_BYTES = 8 * 1024;
+    static constexpr int REQUEST_TIMEOUT_MS = 5 * 1000;
+
+    /**
+     * @param registry Registry to export; must outlive the server
+     * @param parent Parent object
+     */
+    explicit MetricsServer(MetricsRegistry* registry, QObject* parent = nullptr);
+    ~MetricsServer() override;
+
+    /**
+     * @brief Start accepting scrapes
+     * @param port TCP port; 0 picks a free one
+     * @param address Address to listen on
+     * @return true if listening
+     */
+    bool listen(quint16 port, const QHostAddress& address = QHostAddress::Any);
+
+    /**
+     * @brief Stop accepting scrapes; connections being served are finished
+     */
+    void close();
+
+    bool isListening() const;
+
+    /**
+     * @brief Port listened on, or 0
+     */
+    quint16 port() const;
+
+    /**
+     * @brief Serve another document
+     * @param path Path such as "/trace.json"; replaces an earlier one of the same path
+     * @param contentType Content-Type of the document
+     * @param body Builds the document for each request, on the server's thread
+     */
+    void addPath(const QByteArray& path, const QByteArray& contentType,
+                 std::function<QByteArray()> body);
+
+signals:
+    /**
+     * @brief Emitted when the server cannot listen
+     * @param operation Name of the operation
+     * @param error Error message
+     */
+    void operationError(const QString& operation, const QString& error);
+
+private slots:
+    void onNewConnection();
+
+private:
+    void handleRequest(QTcpSocket* socket, const QByteArray& head);
+    static void respond(QTcpSocket* socket, const QByteArray& status, const QByteArray& contentType,
+                        const QByteArray& body, bool withBody = true);
+    void logError(const QString& operation, const QString& error);
+
+    struct Document {
+        QByteArray contentType;
+        std::function<QByteArray()> body;
+    };
+
+    MetricsRegistry* m_registry;
+    QTcpServer* m_server;
+    QHash<QByteArray, Document> m_documents;
+};
+
+#endif // METRICSSERVER_H
@@ -0,0 +1,73 @@
+#include "MicDucker.h"
+#include <algorithm>
+#include <cmath>
+
+MicDucker::MicDucker(QObject* parent)
+    : QObject(parent)
+{
+    setThresholdDb(DEFAULT_THRESHOLD_DB);
+    setDepthDb(DEFAULT_DEPTH_DB);
+}
+
+void MicDucker::setThresholdDb(double db)
+{
+    m_thresholdDb = db;
+    m_threshold.store(float(std::pow(10.0, db / 20.0)), std::memory_order_relaxed);
+}
+
+void MicDucker::setDepthDb(double db)
+{
+    m_depthDb = qMin(0.0, db);
+    m_depth.store(float(std::pow(10.0, m_depthDb / 20.0)), std::memory_order_relaxed);
+}
+
+void MicDucker::processInput(const float* samples, int count, int channels, int sampleRate)
+{
+    if (channels <= 0 || sampleRate <= 0) {
+        return;
+    }
+
+    // The envelope jumps to every peak and decays over ENVELOPE_RELEASE_MS
+    const float decay = std::exp(-1000.0f / (float(ENVELOPE_RELEASE_MS) * float(sampleRate)));
+    const float threshold = m_threshold.load(std::memory_order_relaxed);
+    const qint64 holdLength = qint64(HOLD_MS) * sampleRate / 1000;
+    const int frames = count / channels;
+
+    float envelope = m_envelope;
+    qint64 hold = m_holdFrames;
+    for (int i = 0; i < frames; ++i) {
+        const float* frame = samples + qint64(i) * channels;
+        float peak = 0.0f;
+        for (int channel = 0; channel < channels; ++channel) {
+            peak = std::max(peak, std::abs(frame[channel]));
+        }
+        envelope = peak > envelope ? peak : envelope * decay;
+        if (envelope >= threshold) {
+            hold = holdLength;
+        } else if (hold > 0) {
+            --hold;
+        }
+    }
+    m_envelope = envelope;
+    m_holdFrames = hold;
+    m_speaking.store(hold > 0, std::memory_order_relaxed);
+}
+
+void MicDucker::reset()
+{
+    m_envelope = 0.0f;
+    m_holdFrames = 0;
+    m_speaking.store(false, std::memory_order_relaxed);
+}
+
+void MicDucker::process(float* samples, int frames, int channels, int sampleRate)
+{
+    const bool duck = isEnabled() && isSpeaking();
+    const float target = duck ? m_depth.load(std::memory_order_relaxed) : 1.0f;
+    if (target != m_ramp.target()) {
+        const int ms = duck ? attackMs() : releaseMs();
+        m_ramp.rampTo(target, qint64(ms) * sampleRate / 1000, GainRamp::Curve::Exponential);
+    }
+    m_ramp.process(samples, frames, channels);
+    m_gain.store(m_ramp.gain(), std::memory_order_relaxed);
+}
@@ -0,0 +1,138 @@
+#ifndef MICDUCKER_H
+#define MICDUCKER_H
+
+#include "GainRamp.h"
+#include <QObject>
+#include <atomic>
+
+/**
+ * @brief Lowers the music under the live microphone
+ *
+ * Presenters talking over a music bed used to ride a fader by hand.
+ * MicDucker does it for them: it follows the level of the live input, the
+ * side chain, and while the presenter speaks the decks are turned down by
+ * depthDb(). Carts fired over the talk are left at full level.
+ *
+ * The side chain is fed to processInput() from the capture thread, where
+ * a peak envelope follower with a fast attack and a short release tracks
+ * the input. Speech is heard while the envelope is above thresholdDb(),
+ * and for HOLD_MS after it drops, so the music does not pump back up
+ * between words. The verdict is published in an atomic.
+ *
+ * DeckMixer calls process() on its audio thread with the mix of the decks.
+ * The music moves down over attackMs() and back up over releaseMs(), along
+ * an exponential GainRamp, so ducking is click-free however the capture
+ * blocks are spaced. Neither call locks or allocates.
+ *
+ * @example
+ * @code
+ * MicDucker* ducker = new MicDucker(this);
+ * ducker->setDepthDb(-12.0);
+ * ducker->setEnabled(true);
+ * playbackEngine->setDucker(ducker);
+ * liveCapture->addListener([=](const float* samples, int count) {
+ *     ducker->processInput(samples, count, LiveCapture::CHANNELS, liveCapture->sampleRate());
+ * });
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class MicDucker : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr double DEFAULT_THRESHOLD_DB = -40.0;
+    static constexpr double DEFAULT_DEPTH_DB = -12.0;
+    static constexpr int DEFAULT_ATTACK_MS = 50;
+    static constexpr int DEFAULT_RELEASE_MS = 800;
+    static constexpr int HOLD_MS = 300;              ///< Speech heard after the input drops
+    static constexpr int ENVELOPE_RELEASE_MS = 20;   ///< Decay of the input envelope
+
+    explicit MicDucker(QObject* parent = nullptr);
+
+    /**
+     * @brief Turn ducking on or off; off brings the music back up over releaseMs()
+     */
+    void setEnabled(bool enabled) { m_enabled.store(enabled, std::memory_order_relaxed); }
+    bool isEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Set the input level above which the presenter is speaking
+     * @param db Peak level in dBFS
+     */
+    void setThresholdDb(double db);
+    double thresholdDb() const { return m_thresholdDb; }
+
+    /**
+     * @brief Set how far the music goes down
+     * @param db Attenuation in dB, 0 or less
+     */
+    void setDepthDb(double db);
+    double depthDb() const { return m_depthDb; }
+
+    void setAttackMs(int ms) { m_attackMs.store(qMax(0, ms), std::memory_order_relaxed); }
+    int attackMs() const { return m_attackMs.load(std::memory_order_relaxed); }
+    void setReleaseMs(int ms) { m_releaseMs.store(qMax(0, ms), std::memory_order_relaxed); }
+    int releaseMs() const { return m_releaseMs.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Follow a block of the side chain
+     *
+     * Never blocks or allocates; call from one thread, the capture thread.
+     * @param samples Interleaved float samples
+     * @param count Number of samples, whole frames
+     * @param channels Channels per frame
+     * @param sampleRate Rate of the samples in Hz
+     */
+    void processInput(const float* samples, int count, int channels, int sampleRate);
+
+    /**
+     * @brief Forget the side chain, such as when the capture stops
+     *
+     * Call while processInput() is not running.
+     */
+    void reset();
+
+    /**
+     * @brief Duck a block of the music
+     *
+     * Never blocks or allocates; call from one thread, the audio thread.
+     * @param samples Interleaved float samples, scaled in place
+     * @param frames Number of frames
+     * @param channels Channels per frame
+     * @param sampleRate Rate of the samples in Hz
+     */
+    void process(float* samples, int frames, int channels, int sampleRate);
+
+    /**
+     * @brief Whether the presenter is heard on the side chain
+     */
+    bool isSpeaking() const { return m_speaking.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Gain of the music as of the last block, 1.0 when not ducked
+     */
+    float gain() const { return m_gain.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<bool> m_enabled{false};
+    std::atomic<float> m_threshold{0.0f};
+    std::atomic<float> m_depth{0.0f};
+    std::atomic<int> m_attackMs{DEFAULT_ATTACK_MS};
+    std::atomic<int> m_releaseMs{DEFAULT_RELEASE_MS};
+    double m_thresholdDb = DEFAULT_THRESHOLD_DB;
+    double m_depthDb = DEFAULT_DEPTH_DB;
+
+    // Capture thread only
+    float m_envelope = 0.0f;
+    qint64 m_holdFrames = 0;   ///< Frames of hold left after the input dropped
+
+    // Audio thread only
+    GainRamp m_ramp;
+
+    std::atomic<bool> m_speaking{false};
+    std::atomic<float> m_gain{1.0f};
+};
+
+#endif // MICDUCKER_H
@@ -1,30 +1,548 @@
 #include "MusicCache.h"
 #include "../repositories/MusicRepository.h"
 #include "ErrorHandler.h"
+#include "HourGenreSchedule.h"
+#include "SchedulerEngine.h"
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QFile>
 #include <QDir>
+#include <QMetaMethod>
 #include <QStandardPaths>
+#include <QBitArray>
 #include <QCryptographicHash>
 #include <QDataStream>
-#include <QBuffer>
+#include <QSaveFile>
+#include <QSet>
+#include <QtConcurrent>
 #include <algorithm>
+#include <cstring>
+
+// Register MusicItem with Qt's meta-type system for QVariant storage
+Q_DECLARE_METATYPE(MusicItem)
+
+/**
+ * @brief Interned category with its own counters
+ */
+struct MusicCache::Category {
+    int id = 0;
+    QString name;
+    std::atomic<qint64> hits{0};
+    std::atomic<qint64> misses{0};
+    std::atomic<qint64> size{0};
+};
+
+/**
+ * @brief Bookkeeping shared by every kind of cache entry
+ */
+struct MusicCache::EntryHeader {
+    qint64 createdAtMs = 0;     // When entry was created
+    qint64 lastAccessedMs = 0;  // When entry was last accessed
+    qint64 expiresAtMs = 0;     // When entry expires, 0 for never
+    qint64 size = 0;            // Size in bytes
+    quint64 lruStamp = 0;       // Recency clock at the last access
+    int accessCount = 0;        // Number of times accessed
+    bool isPinned = false;      // Pinned entries are not evicted
+    EntryKind kind = EntryKind::Music;
+    Category* category = nullptr;
+    EntryHeader* lruPrev = nullptr; // Next more recently used entry of the shard
+    EntryHeader* lruNext = nullptr; // Next less recently used entry of the shard
+};
+
+namespace {
+
+// Files written before entries were stored by type carry no cached values
+const QString CACHE_FILE_VERSION = QStringLiteral("2.0");
+
+quint64 musicKey(int categoryId, int musicId)
+{
+    return (static_cast<quint64>(static_cast<quint32>(categoryId)) << 32) | static_cast<quint32>(musicId);
+}
+
+QDateTime fromMs(qint64 ms)
+{
+    return ms > 0 ? QDateTime::fromMSecsSinceEpoch(ms) : QDateTime();
+}
+
+qint64 toMs(const QString& isoDate)
+{
+    const QDateTime dateTime = QDateTime::fromString(isoDate, Qt::ISODateWithMs);
+    return dateTime.isValid() ? dateTime.toMSecsSinceEpoch() : 0;
+}
+
+// Heap block behind a QString: QArrayData header, capacity and terminator.
+// Literals and empty strings use static data and own no block.
+qint64 heapSize(const QString& string)
+{
+    const qsizetype capacity = string.capacity();
+    return capacity > 0 ? qint64(sizeof(QArrayData)) + (capacity + 1) * qint64(sizeof(QChar)) : 0;
+}
+
+qint64 heapSize(const QByteArray& bytes)
+{
+    const qsizetype capacity = bytes.capacity();
+    return capacity > 0 ? qint64(sizeof(QArrayData)) + capacity + 1 : 0;
+}
+
+qint64 heapSize(const MusicItem& music)
+{
+    return heapSize(music.artist) + heapSize(music.song) + heapSize(music.genre1)
+         + heapSize(music.genre2) + heapSize(music.country) + heapSize(music.publishedDate)
+         + heapSize(music.path) + heapSize(music.time) + heapSize(music.lastPlayed);
+}
+
+template <typename T>
+qint64 listBlockSize(const QList<T>& list)
+{
+    const qsizetype capacity = list.capacity();
+    return capacity > 0 ? qint64(sizeof(QArrayData)) + capacity * qint64(sizeof(T)) : 0;
+}
+
+qint64 heapSize(const QList<MusicItem>& results)
+{
+    qint64 size = listBlockSize(results);
+    for (const MusicItem& music : results) {
+        size += heapSize(music);
+    }
+    return size;
+}
+
+qint64 heapSize(const QVariant& value)
+{
+    // std::map node links plus key and value; QVariantHash nodes are charged alike
+    constexpr qint64 mapNodeSize = 4 * sizeof(void*) + sizeof(QString) + sizeof(QVariant);
+    
+    switch (value.typeId()) {
+        case QMetaType::UnknownType:
+            return 0;
+        case QMetaType::QString:
+            return heapSize(value.toString());
+        case QMetaType::QByteArray:
+            return heapSize(value.toByteArray());
+        case QMetaType::QStringList: {
+            const QStringList list = value.toStringList();
+            qint64 size = listBlockSize(list);
+            for (const QString& string : list) {
+                size += heapSize(string);
+            }
+            return size;
+        }
+        case QMetaType::QVariantList: {
+            const QVariantList list = value.toList();
+            qint64 size = listBlockSize(list);
+            for (const QVariant& element : list) {
+                size += heapSize(element);
+            }
+            return size;
+        }
+        case QMetaType::QVariantMap: {
+            const QVariantMap map = value.toMap();
+            qint64 size = 0;
+            for (auto it = map.constBegin(); it != map.constEnd(); ++it) {
+                size += mapNodeSize + heapSize(it.key()) + heapSize(it.value());
+            }
+            return size;
+        }
+        case QMetaType::QVariantHash: {
+            const QVariantHash hash = value.toHash();
+            qint64 size = 0;
+            for (auto it = hash.constBegin(); it != hash.constEnd(); ++it) {
+                size += mapNodeSize + heapSize(it.key()) + heapSize(it.value());
+            }
+            return size;
+        }
+        default:
+            break;
+    }
+    
+    if (value.typeId() == qMetaTypeId<MusicItem>()) {
+        return qint64(sizeof(MusicItem)) + 2 * qint64(sizeof(void*)) + heapSize(value.value<MusicItem>());
+    }
+    
+    // Other types only count the out-of-line copy QVariant makes of values
+    // too large for its inline buffer
+    const qint64 typeSize = value.metaType().sizeOf();
+    return typeSize > qint64(3 * sizeof(void*)) ? typeSize + 2 * qint64(sizeof(void*)) : 0;
+}
+
+// Binary snapshot layout. Sections follow the header in this order, each
+// starting on an 8-byte boundary: string index, UTF-16 string data, music
+// items, entry records and QDataStream blobs of metadata values.
+constexpr char SNAPSHOT_MAGIC[8] = {'X', 'F', 'B', 'C', 'A', 'C', 'H', 'E'};
+constexpr quint32 SNAPSHOT_VERSION = 1;
+constexpr quint32 SNAPSHOT_BYTE_ORDER = 0x01020304;
+constexpr int SNAPSHOT_ITEM_STRINGS = 9;
+
+struct SnapshotHeader {
+    char magic[8];
+    quint32 version;
+    quint32 byteOrder;
+    quint32 stringCount;
+    quint32 itemCount;
+    quint32 recordCount;
+    quint32 reserved;
+    quint64 stringIndexOffset;
+    quint64 stringDataOffset;
+    quint64 stringDataSize;     // In QChar units
+    quint64 itemOffset;
+    quint64 recordOffset;
+    quint64 blobOffset;
+    quint64 blobSize;
+};
+
+struct SnapshotString {
+    quint64 offset;             // In QChar units from the start of the string data
+    quint32 length;
+    quint32 reserved;
+};
+
+struct SnapshotItem {
+    qint32 id;
+    qint32 playedTimes;
+    quint32 strings[SNAPSHOT_ITEM_STRINGS]; // artist, song, genre1, genre2, country, publishedDate, path, time, lastPlayed
+    quint32 reserved;
+};
+
+struct SnapshotRecord {
+    qint64 createdAtMs;
+    qint64 lastAccessedMs;
+    qint64 expiresAtMs;
+    quint64 blobOffset;         // Metadata value
+    quint32 blobSize;
+    qint32 accessCount;
+    qint32 musicId;
+    quint32 category;           // String index
+    quint32 key;                // String index of the search or metadata key
+    quint32 firstItem;          // Music item or first search result
+    quint32 itemCount;
+    quint8 kind;
+    quint8 isPinned;
+    quint16 reserved;
+};
+
+static_assert(sizeof(SnapshotHeader) % 8 == 0 && sizeof(SnapshotString) % 8 == 0
+                  && sizeof(SnapshotItem) % 8 == 0 && sizeof(SnapshotRecord) % 8 == 0,
+              "snapshot sections must stay 8-byte aligned");
+
+quint64 alignTo8(quint64 offset)
+{
+    return (offset + 7) & ~quint64(7);
+}
+
+// Check that count elements of elementSize bytes at offset lie within size
+bool sectionFits(quint64 offset, quint64 count, quint64 elementSize, quint64 size)
+{
+    return offset <= size && count <= (size - offset) / elementSize;
+}
+
+template <typename T>
+T readPod(const uchar* data)
+{
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+/**
+ * @brief Builds the sections of a snapshot, deduplicating strings
+ */
+class SnapshotWriter
+{
+public:
+    quint32 string(const QString& string)
+    {
+        auto it = m_stringIds.constFind(string);
+        if (it != m_stringIds.constEnd()) {
+            return it.value();
+        }
+        
+        const quint32 id = static_cast<quint32>(m_strings.size());
+        m_strings.append(SnapshotString{static_cast<quint64>(m_stringData.size()),
+                                        static_cast<quint32>(string.size()), 0});
+        m_stringData.append(string);
+        m_stringIds.insert(string, id);
+        return id;
+    }
+    
+    quint32 item(const MusicItem& music)
+    {
+        SnapshotItem item{};
+        item.id = music.id;
+        item.playedTimes = music.playedTimes;
+        const QString* fields[SNAPSHOT_ITEM_STRINGS] = {
+            &music.artist, &music.song, &music.genre1, &music.genre2, &music.country,
+            &music.publishedDate, &music.path, &music.time, &music.lastPlayed
+        };
+        for (int i = 0; i < SNAPSHOT_ITEM_STRINGS; ++i) {
+            item.strings[i] = string(*fields[i]);
+        }
+        m_items.append(item);
+        return static_cast<quint32>(m_items.size() - 1);
+    }
+    
+    void blob(const QVariant& value, SnapshotRecord& record)
+    {
+        QByteArray bytes;
+        QDataStream stream(&bytes, QIODevice::WriteOnly);
+        stream.setVersion(QDataStream::Qt_6_0);
+        stream << value;
+        record.blobOffset = static_cast<quint64>(m_blobs.size());
+        record.blobSize = static_cast<quint32>(bytes.size());
+        m_blobs.append(bytes);
+    }
+    
+    QByteArray build(const QList<SnapshotRecord>& records) const
+    {
+        SnapshotHeader header{};
+        std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+        header.version = SNAPSHOT_VERSION;
+        header.byteOrder = SNAPSHOT_BYTE_ORDER;
+        header.stringCount = static_cast<quint32>(m_strings.size());
+        header.itemCount = static_cast<quint32>(m_items.size());
+        header.recordCount = static_cast<quint32>(records.size());
+        header.stringIndexOffset = sizeof(SnapshotHeader);
+        header.stringDataOffset = header.stringIndexOffset + m_strings.size() * sizeof(SnapshotString);
+        header.stringDataSize = static_cast<quint64>(m_stringData.size());
+        header.itemOffset = alignTo8(header.stringDataOffset + header.stringDataSize * sizeof(QChar));
+        header.recordOffset = header.itemOffset + m_items.size() * sizeof(SnapshotItem);
+        header.blobOffset = header.recordOffset + records.size() * sizeof(SnapshotRecord);
+        header.blobSize = static_cast<quint64>(m_blobs.size());
+        
+        QByteArray data(static_cast<qsizetype>(header.blobOffset + header.blobSize), '\0');
+        auto copy = [&data](quint64 offset, const void* source, quint64 bytes) {
+            if (bytes > 0) {
+                std::memcpy(data.data() + offset, source, bytes);
+            }
+        };
+        copy(0, &header, sizeof(header));
+        copy(header.stringIndexOffset, m_strings.constData(), m_strings.size() * sizeof(SnapshotString));
+        copy(header.stringDataOffset, m_stringData.constData(), m_stringData.size() * sizeof(QChar));
+        copy(header.itemOffset, m_items.constData(), m_items.size() * sizeof(SnapshotItem));
+        copy(header.recordOffset, records.constData(), records.size() * sizeof(SnapshotRecord));
+        copy(header.blobOffset, m_blobs.constData(), m_blobs.size());
+        return data;
+    }
+    
+private:
+    QHash<QString, quint32> m_stringIds;
+    QList<SnapshotString> m_strings;
+    QString m_stringData;
+    QList<SnapshotItem> m_items;
+    QByteArray m_blobs;
+};
+
+// Key strings for signals are only built when someone listens
+const QMetaMethod& hitSignal()
+{
+    static const QMetaMethod method = QMetaMethod::fromSignal(&MusicCache::cacheHit);
+    return method;
+}
+
+const QMetaMethod& missSignal()
+{
+    static const QMetaMethod method = QMetaMethod::fromSignal(&MusicCache::cacheMiss);
+    return method;
+}
+
+const QMetaMethod& evictedSignal()
+{
+    static const QMetaMethod method = QMetaMethod::fromSignal(&MusicCache::entryEvicted);
+    return method;
+}
+
+} // namespace
+
+/**
+ * @brief One independently locked slice of the cache
+ *
+ * Entries are heap nodes so their recency links survive rehashing. The
+ * unpinned entries of a shard form a list from most to least recently
+ * used; pinned entries are kept out of it, so the tail is always the
+ * shard's next eviction candidate.
+ */
+struct MusicCache::Shard {
+    struct MusicEntry : EntryHeader {
+        int musicId = 0;
+        MusicItem music;
+    };
+
+    struct SearchEntry : EntryHeader {
+        QString key;
+        QList<MusicItem> results;
+    };
+
+    struct MetadataEntry : EntryHeader {
+        QString key;
+        QVariant data;
+    };
+
+    QMutex mutex;
+    QHash<quint64, MusicEntry*> music;                   // Category ID in the high word, music ID in the low
+    QHash<QString, SearchEntry*> search;                 // Search key
+    QHash<QPair<int, QString>, MetadataEntry*> metadata; // Category ID, key
+    QMultiHash<int, SearchEntry*> searchesByMusicId;     // Searches of this shard containing each music ID
+    EntryHeader* lruHead = nullptr;                      // Most recently used unpinned entry
+    EntryHeader* lruTail = nullptr;                      // Least recently used unpinned entry
+
+    ~Shard()
+    {
+        clear();
+    }
+
+    bool isLinked(const EntryHeader* entry) const
+    {
+        return entry->lruPrev || lruHead == entry;
+    }
+
+    void link(EntryHeader* entry)
+    {
+        entry->lruPrev = nullptr;
+        entry->lruNext = lruHead;
+        if (lruHead) {
+            lruHead->lruPrev = entry;
+        } else {
+            lruTail = entry;
+        }
+        lruHead = entry;
+    }
+
+    void unlink(EntryHeader* entry)
+    {
+        if (!isLinked(entry)) {
+            return;
+        }
+        (entry->lruPrev ? entry->lruPrev->lruNext : lruHead) = entry->lruNext;
+        (entry->lruNext ? entry->lruNext->lruPrev : lruTail) = entry->lruPrev;
+        entry->lruPrev = nullptr;
+        entry->lruNext = nullptr;
+    }
+
+    // Move an entry to the most recently used end
+    void touch(EntryHeader* entry)
+    {
+        if (entry->isPinned || lruHead == entry) {
+            return;
+        }
+        unlink(entry);
+        link(entry);
+    }
+
+    // Track which music IDs a search result contains
+    void index(EntryHeader* entry)
+    {
+        if (entry->kind == EntryKind::Search) {
+            auto* searchEntry = static_cast<SearchEntry*>(entry);
+            for (const MusicItem& result : std::as_const(searchEntry->results)) {
+                searchesByMusicId.insert(result.id, searchEntry);
+            }
+        }
+    }
+    
+    void unindex(EntryHeader* entry)
+    {
+        if (entry->kind == EntryKind::Search) {
+            auto* searchEntry = static_cast<SearchEntry*>(entry);
+            for (const MusicItem& result : std::as_const(searchEntry->results)) {
+                searchesByMusicId.remove(result.id, searchEntry);
+            }
+        }
+    }
+    
+    // Store an entry, replacing any entry under the same key
+    template <typename Entry, typename Key>
+    qint64 insert(QHash<Key, Entry*>& hash, const Key& key, Entry* entry)
+    {
+        qint64 oldSize = -1;
+        auto it = hash.find(key);
+        if (it != hash.end()) {
+            Entry* old = it.value();
+            oldSize = old->size;
+            entry->isPinned = entry->isPinned || old->isPinned;
+            unlink(old);
+            unindex(old);
+            delete old;
+            it.value() = entry;
+        } else {
+            hash.insert(key, entry);
+        }
+        index(entry);
+        if (!entry->isPinned) {
+            link(entry);
+        }
+        return oldSize;
+    }
+
+    // Free an entry as the type it was allocated as
+    static void destroy(EntryHeader* entry)
+    {
+        switch (entry->kind) {
+            case EntryKind::Music:
+                delete static_cast<MusicEntry*>(entry);
+                break;
+            case EntryKind::Search:
+                delete static_cast<SearchEntry*>(entry);
+                break;
+            case EntryKind::Metadata:
+                delete static_cast<MetadataEntry*>(entry);
+                break;
+        }
+    }
+    
+    // Remove an entry from its hash and free it
+    void erase(EntryHeader* entry)
+    {
+        unlink(entry);
+        unindex(entry);
+        switch (entry->kind) {
+            case EntryKind::Music:
+                music.remove(musicKey(entry->category->id, static_cast<MusicEntry*>(entry)->musicId));
+                break;
+            case EntryKind::Search:
+                search.remove(static_cast<SearchEntry*>(entry)->key);
+                break;
+            case EntryKind::Metadata:
+                metadata.remove(qMakePair(entry->category->id, static_cast<MetadataEntry*>(entry)->key));
+                break;
+        }
+        destroy(entry);
+    }
+
+    void clear()
+    {
+        qDeleteAll(music);
+        qDeleteAll(search);
+        qDeleteAll(metadata);
+        music.clear();
+        search.clear();
+        metadata.clear();
+        searchesByMusicId.clear();
+        lruHead = nullptr;
+        lruTail = nullptr;
+    }
+};
 
 MusicCache::MusicCache(QObject* parent)
     : QObject(parent)
+    , m_searchCategory(nullptr)
     , m_maxMemoryUsage(DEFAULT_MAX_MEMORY)
     , m_defaultExpirationTime(DEFAULT_EXPIRATION_TIME)
     , m_invalidationStrategy(SmartInvalidation)
     , m_warmupStrategy(PopularItemsWarmup)
+    , m_warmupWatcher(new QFutureWatcher<int>(this))
     , m_maintenanceTimer(new QTimer(this))
     , m_persistenceTimer(new QTimer(this))
+    , m_warmupTimer(new QTimer(this))
     , m_autoPersistenceEnabled(false)
 {
-    // Initialize statistics
-    m_statistics = CacheStatistics{};
-    m_statistics.maxMemoryUsage = m_maxMemoryUsage;
+    for (auto& shard : m_shards) {
+        shard = std::make_unique<Shard>();
+    }
+    
+    // Built-in categories; search results are accounted under "search"
+    registerCategory("music");
+    m_searchCategory = registerCategory("search");
+    registerCategory("metadata");
     
     // Setup maintenance timer
     m_maintenanceTimer->setSingleShot(false);
@@ -35,11 +553,23 @@ MusicCache::MusicCache(QObject* parent)
     m_persistenceTimer->setSingleShot(false);
     m_persistenceTimer->setInterval(PERSISTENCE_INTERVAL_MS);
     connect(m_persistenceTimer, &QTimer::timeout, this, &MusicCache::autoPersist);
+    
+    // Setup warmup; the timer is armed for the next scheduled program
+    m_warmupTimer->setSingleShot(true);
+    connect(m_warmupTimer, &QTimer::timeout, this, &MusicCache::warmupCache);
+    connect(m_warmupWatcher, &QFutureWatcher<int>::finished, this,
+            [this]() { finishWarmup(m_warmupWatcher->result()); });
 }
 
 MusicCache::~MusicCache()
 {
     shutdown();
+    
+    // Entries point at their categories, so the shards go first
+    for (auto& shard : m_shards) {
+        shard.reset();
+    }
+    qDeleteAll(m_categories);
 }
 
 bool MusicCache::initialize()
@@ -52,7 +582,7 @@ bool MusicCache::initialize()
     // Load cache from persistent storage if enabled
     if (m_autoPersistenceEnabled && !m_persistenceFilePath.isEmpty()) {
         if (QFile::exists(m_persistenceFilePath)) {
-            loadFromFile(m_persistenceFilePath);
+            loadSnapshot(m_persistenceFilePath);
         }
         m_persistenceTimer->start();
     }
@@ -70,47 +600,62 @@ void MusicCache::shutdown()
     // Stop timers
     m_maintenanceTimer->stop();
     m_persistenceTimer->stop();
+    m_warmupTimer->stop();
+    
+    // A running warmup stores into the shards cleared below
+    m_warmupWatcher->waitForFinished();
     
     // Save cache if auto-persistence is enabled
     if (m_autoPersistenceEnabled && !m_persistenceFilePath.isEmpty()) {
-        saveToFile(m_persistenceFilePath);
+        saveSnapshot(m_persistenceFilePath);
     }
     
     // Clear cache
-    QMutexLocker locker(&m_cacheMutex);
-    m_cache.clear();
+    for (auto& shard : m_shards) {
+        QMutexLocker locker(&shard->mutex);
+        shard->clear();
+    }
     
     // Reset statistics
+    m_totalHits = 0;
+    m_totalMisses = 0;
+    m_totalEvictions = 0;
+    m_entryCount = 0;
+    m_memoryUsage = 0;
+    {
+        QReadLocker locker(&m_categoryLock);
+        for (Category* category : std::as_const(m_categories)) {
+            category->hits = 0;
+            category->misses = 0;
+            category->size = 0;
+        }
+    }
+    
     QMutexLocker statsLocker(&m_statsMutex);
-    m_statistics = CacheStatistics{};
-    m_statistics.maxMemoryUsage = m_maxMemoryUsage;
+    m_lastCleanup = QDateTime();
+    m_lastWarmup = QDateTime();
 }
 
 void MusicCache::setMaxMemoryUsage(qint64 maxBytes)
 {
-    QMutexLocker locker(&m_statsMutex);
     m_maxMemoryUsage = maxBytes;
-    m_statistics.maxMemoryUsage = maxBytes;
     
     ErrorHandler::logMessage(ErrorHandler::ErrorSeverity::Info, "MusicCache", QString("Max memory usage set to %1 MB").arg(maxBytes / (1024 * 1024)));
     
     // Trigger cleanup if current usage exceeds new limit
-    if (m_statistics.currentMemoryUsage > maxBytes) {
-        locker.unlock();
+    if (m_memoryUsage > maxBytes) {
         cleanup(static_cast<qint64>(maxBytes * MEMORY_CLEANUP_TARGET));
     }
 }
 
 qint64 MusicCache::maxMemoryUsage() const
 {
-    QMutexLocker locker(&m_statsMutex);
     return m_maxMemoryUsage;
 }
 
 qint64 MusicCache::currentMemoryUsage() const
 {
-    QMutexLocker locker(&m_statsMutex);
-    return m_statistics.currentMemoryUsage;
+    return m_memoryUsage;
 }
 
 void MusicCache::setDefaultExpirationTime(int seconds)
@@ -168,467 +713,378 @@ MusicCache::WarmupStrategy MusicCache::warmupStrategy() const
 
 void MusicCache::put(int musicId, const MusicItem& music, const QString& category, int expirationSeconds)
 {
-    QString key = generateMusicKey(musicId, category);
-    
-    QMutexLocker locker(&m_cacheMutex);
+    Category* cat = registerCategory(category);
     
     // Create cache entry
-    CacheEntry entry;
-    entry.data = QVariant::fromValue(music);
-    entry.createdAt = QDateTime::currentDateTime();
-    entry.lastAccessed = entry.createdAt;
-    entry.accessCount = 0;
-    entry.source = "manual";
-    entry.size = calculateDataSize(entry.data);
-    
-    // Set expiration
-    if (expirationSeconds > 0) {
-        entry.expiresAt = entry.createdAt.addSecs(expirationSeconds);
-    } else if (m_defaultExpirationTime > 0) {
-        entry.expiresAt = entry.createdAt.addSecs(m_defaultExpirationTime);
-    }
-    
-    // Add metadata
-    entry.metadata["musicId"] = musicId;
-    entry.metadata["category"] = category;
+    auto* entry = new Shard::MusicEntry;
+    entry->kind = EntryKind::Music;
+    entry->category = cat;
+    entry->musicId = musicId;
+    entry->music = music;
+    initHeader(*entry, entrySize(*entry),
+               expirationSeconds > 0 ? expirationSeconds : m_defaultExpirationTime);
+    const qint64 size = entry->size;
     
     // Check if we need to evict entries to make room
-    qint64 newMemoryUsage = m_statistics.currentMemoryUsage + entry.size;
-    if (newMemoryUsage > m_maxMemoryUsage) {
-        locker.unlock();
-        cleanup(static_cast<qint64>(m_maxMemoryUsage * MEMORY_CLEANUP_TARGET));
-        locker.relock();
-    }
+    makeRoom(size);
     
-    // Store entry
-    bool isUpdate = m_cache.contains(key);
-    if (isUpdate) {
-        // Update existing entry size in statistics
-        qint64 oldSize = m_cache[key].size;
-        m_statistics.currentMemoryUsage -= oldSize;
+    qint64 oldSize = -1;
+    {
+        Shard& shard = musicShard(musicId);
+        QMutexLocker locker(&shard.mutex);
+        oldSize = shard.insert(shard.music, musicKey(cat->id, musicId), entry);
     }
     
-    m_cache[key] = entry;
-    m_statistics.currentMemoryUsage += entry.size;
-    m_statistics.currentEntries = m_cache.size();
-    
-    // Update category statistics
-    m_statistics.categorySize[category] += entry.size;
-    
-    logCacheOperation("put", key, true, QString("Music ID: %1, Size: %2 bytes").arg(musicId).arg(entry.size));
+    recordUsage(cat, size - std::max<qint64>(oldSize, 0), oldSize >= 0 ? 0 : 1);
 }
 
 std::unique_ptr<MusicItem> MusicCache::get(int musicId, const QString& category)
 {
-    QString key = generateMusicKey(musicId, category);
-    
-    QMutexLocker locker(&m_cacheMutex);
-    
-    if (!m_cache.contains(key)) {
-        // Cache miss
-        m_statistics.totalMisses++;
-        m_statistics.categoryMisses[category]++;
+    Category* cat = registerCategory(category);
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    
+    std::unique_ptr<MusicItem> result;
+    qint64 expiredSize = -1;
+    {
+        Shard& shard = musicShard(musicId);
+        QMutexLocker locker(&shard.mutex);
         
-        locker.unlock();
-        emit cacheMiss(key, category);
-        logCacheOperation("get", key, false, "Cache miss");
-        return nullptr;
+        Shard::MusicEntry* entry = shard.music.value(musicKey(cat->id, musicId));
+        if (entry) {
+            if (isExpired(*entry, now)) {
+                expiredSize = entry->size;
+                shard.erase(entry);
+            } else {
+                // Update access information
+                entry->lastAccessedMs = now;
+                entry->accessCount++;
+                entry->lruStamp = nextLruStamp();
+                shard.touch(entry);
+                result = std::make_unique<MusicItem>(entry->music);
+            }
+        }
     }
     
-    CacheEntry& entry = m_cache[key];
-    
-    // Check if entry has expired
-    if (isExpired(entry)) {
-        m_cache.remove(key);
-        m_statistics.currentMemoryUsage -= entry.size;
-        m_statistics.currentEntries = m_cache.size();
-        m_statistics.totalMisses++;
-        m_statistics.categoryMisses[category]++;
-        
-        locker.unlock();
-        emit cacheMiss(key, category);
-        logCacheOperation("get", key, false, "Entry expired");
-        return nullptr;
+    if (expiredSize >= 0) {
+        recordUsage(cat, -expiredSize, -1);
     }
+    recordAccess(cat, result != nullptr);
     
-    // Update access information
-    entry.lastAccessed = QDateTime::currentDateTime();
-    entry.accessCount++;
-    
-    // Cache hit
-    m_statistics.totalHits++;
-    m_statistics.categoryHits[category]++;
-    
-    // Calculate hit ratio
-    qint64 totalAccesses = m_statistics.totalHits + m_statistics.totalMisses;
-    if (totalAccesses > 0) {
-        m_statistics.hitRatio = static_cast<double>(m_statistics.totalHits) / totalAccesses;
+    if (result) {
+        if (isSignalConnected(hitSignal())) {
+            emit cacheHit(generateMusicKey(musicId, category), category);
+        }
+    } else if (isSignalConnected(missSignal())) {
+        emit cacheMiss(generateMusicKey(musicId, category), category);
     }
     
-    auto result = std::make_unique<MusicItem>(entry.data.value<MusicItem>());
-    
-    locker.unlock();
-    emit cacheHit(key, category);
-    logCacheOperation("get", key, true, QString("Access count: %1").arg(entry.accessCount));
-    
     return result;
 }
 
 bool MusicCache::contains(int musicId, const QString& category)
 {
-    QString key = generateMusicKey(musicId, category);
-    
-    QMutexLocker locker(&m_cacheMutex);
-    
-    if (!m_cache.contains(key)) {
+    Category* cat = findCategory(category);
+    if (!cat) {
         return false;
     }
     
-    // Check if entry has expired
-    const CacheEntry& entry = m_cache[key];
-    if (isExpired(entry)) {
+    qint64 expiredSize = -1;
+    {
+        Shard& shard = musicShard(musicId);
+        QMutexLocker locker(&shard.mutex);
+        
+        Shard::MusicEntry* entry = shard.music.value(musicKey(cat->id, musicId));
+        if (!entry) {
+            return false;
+        }
+        
+        if (!isExpired(*entry, QDateTime::currentMSecsSinceEpoch())) {
+            return true;
+        }
+        
         // Remove expired entry
-        m_cache.remove(key);
-        m_statistics.currentMemoryUsage -= entry.size;
-        m_statistics.currentEntries = m_cache.size();
-        return false;
+        expiredSize = entry->size;
+        shard.erase(entry);
     }
     
-    return true;
+    recordUsage(cat, -expiredSize, -1);
+    return false;
 }
 
 bool MusicCache::remove(int musicId, const QString& category)
 {
-    QString key = generateMusicKey(musicId, category);
-    
-    QMutexLocker locker(&m_cacheMutex);
-    
-    if (!m_cache.contains(key)) {
+    Category* cat = findCategory(category);
+    if (!cat) {
         return false;
     }
     
-    const CacheEntry& entry = m_cache[key];
-    m_statistics.currentMemoryUsage -= entry.size;
-    m_statistics.categorySize[category] -= entry.size;
-    
-    m_cache.remove(key);
-    m_statistics.currentEntries = m_cache.size();
+    qint64 size = 0;
+    {
+        Shard& shard = musicShard(musicId);
+        QMutexLocker locker(&shard.mutex);
+        
+        Shard::MusicEntry* entry = shard.music.value(musicKey(cat->id, musicId));
+        if (!entry) {
+            return false;
+        }
+        
+        size = entry->size;
+        shard.erase(entry);
+    }
     
-    logCacheOperation("remove", key, true, QString("Music ID: %1").arg(musicId));
+    recordUsage(cat, -size, -1);
+    logCacheOperation("remove", generateMusicKey(musicId, category), true, QString("Music ID: %1").arg(musicId));
     return true;
 }
 
 void MusicCache::putSearchResults(const QString& searchKey, const QList<MusicItem>& results, int expirationSeconds)
 {
-    QString key = generateSearchKey(searchKey);
-    
-    QMutexLocker locker(&m_cacheMutex);
-    
     // Create cache entry
-    CacheEntry entry;
-    entry.data = QVariant::fromValue(results);
-    entry.createdAt = QDateTime::currentDateTime();
-    entry.lastAccessed = entry.createdAt;
-    entry.accessCount = 0;
-    entry.source = "search";
-    entry.size = calculateDataSize(entry.data);
+    auto* entry = new Shard::SearchEntry;
+    entry->kind = EntryKind::Search;
+    entry->category = m_searchCategory;
+    entry->key = searchKey;
+    entry->results = results;
     
-    // Set expiration (search results typically expire faster)
-    int searchExpirationTime = expirationSeconds > 0 ? expirationSeconds : (m_defaultExpirationTime / 2);
-    if (searchExpirationTime > 0) {
-        entry.expiresAt = entry.createdAt.addSecs(searchExpirationTime);
-    }
-    
-    // Add metadata
-    entry.metadata["searchKey"] = searchKey;
-    entry.metadata["resultCount"] = results.size();
-    entry.metadata["category"] = "search";
+    // Search results typically expire faster
+    initHeader(*entry, entrySize(*entry),
+               expirationSeconds > 0 ? expirationSeconds : (m_defaultExpirationTime / 2));
+    const qint64 size = entry->size;
     
     // Check memory usage
-    qint64 newMemoryUsage = m_statistics.currentMemoryUsage + entry.size;
-    if (newMemoryUsage > m_maxMemoryUsage) {
-        locker.unlock();
-        cleanup(static_cast<qint64>(m_maxMemoryUsage * MEMORY_CLEANUP_TARGET));
-        locker.relock();
-    }
+    makeRoom(size);
     
-    // Store entry
-    bool isUpdate = m_cache.contains(key);
-    if (isUpdate) {
-        qint64 oldSize = m_cache[key].size;
-        m_statistics.currentMemoryUsage -= oldSize;
+    qint64 oldSize = -1;
+    {
+        Shard& shard = keyShard(searchKey);
+        QMutexLocker locker(&shard.mutex);
+        oldSize = shard.insert(shard.search, searchKey, entry);
     }
     
-    m_cache[key] = entry;
-    m_statistics.currentMemoryUsage += entry.size;
-    m_statistics.currentEntries = m_cache.size();
-    m_statistics.categorySize["search"] += entry.size;
-    
-    logCacheOperation("putSearchResults", key, true, 
-                     QString("Search: %1, Results: %2, Size: %3 bytes")
-                     .arg(searchKey).arg(results.size()).arg(entry.size));
+    recordUsage(m_searchCategory, size - std::max<qint64>(oldSize, 0), oldSize >= 0 ? 0 : 1);
 }
 
 QList<MusicItem> MusicCache::getSearchResults(const QString& searchKey)
 {
-    QString key = generateSearchKey(searchKey);
-    
-    QMutexLocker locker(&m_cacheMutex);
-    
-    if (!m_cache.contains(key)) {
-        m_statistics.totalMisses++;
-        m_statistics.categoryMisses["search"]++;
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    
+    QList<MusicItem> results;
+    bool hit = false;
+    qint64 expiredSize = -1;
+    {
+        Shard& shard = keyShard(searchKey);
+        QMutexLocker locker(&shard.mutex);
         
-        locker.unlock();
-        emit cacheMiss(key, "search");
-        logCacheOperation("getSearchResults", key, false, "Cache miss");
-        return QList<MusicItem>();
+        Shard::SearchEntry* entry = shard.search.value(searchKey);
+        if (entry) {
+            if (isExpired(*entry, now)) {
+                expiredSize = entry->size;
+                shard.erase(entry);
+            } else {
+                // Update access information
+                entry->lastAccessedMs = now;
+                entry->accessCount++;
+                entry->lruStamp = nextLruStamp();
+                shard.touch(entry);
+                results = entry->results;
+                hit = true;
+            }
+        }
     }
     
-    CacheEntry& entry = m_cache[key];
-    
-    // Check if entry has expired
-    if (isExpired(entry)) {
-        m_cache.remove(key);
-        m_statistics.currentMemoryUsage -= entry.size;
-        m_statistics.currentEntries = m_cache.size();
-        m_statistics.totalMisses++;
-        m_statistics.categoryMisses["search"]++;
-        
-        locker.unlock();
-        emit cacheMiss(key, "search");
-        logCacheOperation("getSearchResults", key, false, "Entry expired");
-        return QList<MusicItem>();
+    if (expiredSize >= 0) {
+        recordUsage(m_searchCategory, -expiredSize, -1);
     }
+    recordAccess(m_searchCategory, hit);
     
-    // Update access information
-    entry.lastAccessed = QDateTime::currentDateTime();
-    entry.accessCount++;
-    
-    // Cache hit
-    m_statistics.totalHits++;
-    m_statistics.categoryHits["search"]++;
-    
-    // Calculate hit ratio
-    qint64 totalAccesses = m_statistics.totalHits + m_statistics.totalMisses;
-    if (totalAccesses > 0) {
-        m_statistics.hitRatio = static_cast<double>(m_statistics.totalHits) / totalAccesses;
+    if (hit) {
+        if (isSignalConnected(hitSignal())) {
+            emit cacheHit(generateSearchKey(searchKey), "search");
+        }
+    } else if (isSignalConnected(missSignal())) {
+        emit cacheMiss(generateSearchKey(searchKey), "search");
     }
     
-    QList<MusicItem> results = entry.data.value<QList<MusicItem>>();
-    
-    locker.unlock();
-    emit cacheHit(key, "search");
-    logCacheOperation("getSearchResults", key, true, 
-                     QString("Search: %1, Results: %2").arg(searchKey).arg(results.size()));
-    
     return results;
 }
 
 bool MusicCache::containsSearchResults(const QString& searchKey)
 {
-    QString key = generateSearchKey(searchKey);
-    
-    QMutexLocker locker(&m_cacheMutex);
-    
-    if (!m_cache.contains(key)) {
-        return false;
-    }
-    
-    const CacheEntry& entry = m_cache[key];
-    if (isExpired(entry)) {
-        m_cache.remove(key);
-        m_statistics.currentMemoryUsage -= entry.size;
-        m_statistics.currentEntries = m_cache.size();
-        return false;
+    qint64 expiredSize = -1;
+    {
+        Shard& shard = keyShard(searchKey);
+        QMutexLocker locker(&shard.mutex);
+        
+        Shard::SearchEntry* entry = shard.search.value(searchKey);
+        if (!entry) {
+            return false;
+        }
+        
+        if (!isExpired(*entry, QDateTime::currentMSecsSinceEpoch())) {
+            return true;
+        }
+        
+        expiredSize = entry->size;
+        shard.erase(entry);
     }
     
-    return true;
+    recordUsage(m_searchCategory, -expiredSize, -1);
+    return false;
 }
 
 bool MusicCache::removeSearchResults(const QString& searchKey)
 {
-    QString key = generateSearchKey(searchKey);
-    
-    QMutexLocker locker(&m_cacheMutex);
-    
-    if (!m_cache.contains(key)) {
-        return false;
+    qint64 size = 0;
+    {
+        Shard& shard = keyShard(searchKey);
+        QMutexLocker locker(&shard.mutex);
+        
+        Shard::SearchEntry* entry = shard.search.value(searchKey);
+        if (!entry) {
+            return false;
+        }
+        
+        size = entry->size;
+        shard.erase(entry);
     }
     
-    const CacheEntry& entry = m_cache[key];
-    m_statistics.currentMemoryUsage -= entry.size;
-    m_statistics.categorySize["search"] -= entry.size;
-    
-    m_cache.remove(key);
-    m_statistics.currentEntries = m_cache.size();
-    
-    logCacheOperation("removeSearchResults", key, true, QString("Search: %1").arg(searchKey));
+    recordUsage(m_searchCategory, -size, -1);
+    logCacheOperation("removeSearchResults", generateSearchKey(searchKey), true, QString("Search: %1").arg(searchKey));
     return true;
 }
 
 void MusicCache::putMetadata(const QString& key, const QVariant& data, const QString& category, int expirationSeconds)
 {
-    QString cacheKey = generateMetadataKey(key, category);
-    
-    QMutexLocker locker(&m_cacheMutex);
+    Category* cat = registerCategory(category);
     
     // Create cache entry
-    CacheEntry entry;
-    entry.data = data;
-    entry.createdAt = QDateTime::currentDateTime();
-    entry.lastAccessed = entry.createdAt;
-    entry.accessCount = 0;
-    entry.source = "metadata";
-    entry.size = calculateDataSize(data);
-    
-    // Set expiration
-    if (expirationSeconds > 0) {
-        entry.expiresAt = entry.createdAt.addSecs(expirationSeconds);
-    } else if (m_defaultExpirationTime > 0) {
-        entry.expiresAt = entry.createdAt.addSecs(m_defaultExpirationTime);
-    }
-    
-    // Add metadata
-    entry.metadata["originalKey"] = key;
-    entry.metadata["category"] = category;
+    auto* entry = new Shard::MetadataEntry;
+    entry->kind = EntryKind::Metadata;
+    entry->category = cat;
+    entry->key = key;
+    entry->data = data;
+    initHeader(*entry, entrySize(*entry),
+               expirationSeconds > 0 ? expirationSeconds : m_defaultExpirationTime);
+    const qint64 size = entry->size;
     
     // Check memory usage
-    qint64 newMemoryUsage = m_statistics.currentMemoryUsage + entry.size;
-    if (newMemoryUsage > m_maxMemoryUsage) {
-        locker.unlock();
-        cleanup(static_cast<qint64>(m_maxMemoryUsage * MEMORY_CLEANUP_TARGET));
-        locker.relock();
-    }
+    makeRoom(size);
     
-    // Store entry
-    bool isUpdate = m_cache.contains(cacheKey);
-    if (isUpdate) {
-        qint64 oldSize = m_cache[cacheKey].size;
-        m_statistics.currentMemoryUsage -= oldSize;
+    qint64 oldSize = -1;
+    {
+        Shard& shard = keyShard(key);
+        QMutexLocker locker(&shard.mutex);
+        oldSize = shard.insert(shard.metadata, qMakePair(cat->id, key), entry);
     }
     
-    m_cache[cacheKey] = entry;
-    m_statistics.currentMemoryUsage += entry.size;
-    m_statistics.currentEntries = m_cache.size();
-    m_statistics.categorySize[category] += entry.size;
-    
-    logCacheOperation("putMetadata", cacheKey, true, 
-                     QString("Key: %1, Category: %2, Size: %3 bytes")
-                     .arg(key).arg(category).arg(entry.size));
+    recordUsage(cat, size - std::max<qint64>(oldSize, 0), oldSize >= 0 ? 0 : 1);
 }
 
 QVariant MusicCache::getMetadata(const QString& key, const QString& category)
 {
-    QString cacheKey = generateMetadataKey(key, category);
-    
-    QMutexLocker locker(&m_cacheMutex);
-    
-    if (!m_cache.contains(cacheKey)) {
-        m_statistics.totalMisses++;
-        m_statistics.categoryMisses[category]++;
+    Category* cat = registerCategory(category);
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    
+    QVariant result;
+    bool hit = false;
+    qint64 expiredSize = -1;
+    {
+        Shard& shard = keyShard(key);
+        QMutexLocker locker(&shard.mutex);
         
-        locker.unlock();
-        emit cacheMiss(cacheKey, category);
-        logCacheOperation("getMetadata", cacheKey, false, "Cache miss");
-        return QVariant();
+        Shard::MetadataEntry* entry = shard.metadata.value(qMakePair(cat->id, key));
+        if (entry) {
+            if (isExpired(*entry, now)) {
+                expiredSize = entry->size;
+                shard.erase(entry);
+            } else {
+                // Update access information
+                entry->lastAccessedMs = now;
+                entry->accessCount++;
+                entry->lruStamp = nextLruStamp();
+                shard.touch(entry);
+                result = entry->data;
+                hit = true;
+            }
+        }
     }
     
-    CacheEntry& entry = m_cache[cacheKey];
-    
-    // Check if entry has expired
-    if (isExpired(entry)) {
-        m_cache.remove(cacheKey);
-        m_statistics.currentMemoryUsage -= entry.size;
-        m_statistics.currentEntries = m_cache.size();
-        m_statistics.totalMisses++;
-        m_statistics.categoryMisses[category]++;
-        
-        locker.unlock();
-        emit cacheMiss(cacheKey, category);
-        logCacheOperation("getMetadata", cacheKey, false, "Entry expired");
-        return QVariant();
+    if (expiredSize >= 0) {
+        recordUsage(cat, -expiredSize, -1);
     }
+    recordAccess(cat, hit);
     
-    // Update access information
-    entry.lastAccessed = QDateTime::currentDateTime();
-    entry.accessCount++;
-    
-    // Cache hit
-    m_statistics.totalHits++;
-    m_statistics.categoryHits[category]++;
-    
-    // Calculate hit ratio
-    qint64 totalAccesses = m_statistics.totalHits + m_statistics.totalMisses;
-    if (totalAccesses > 0) {
-        m_statistics.hitRatio = static_cast<double>(m_statistics.totalHits) / totalAccesses;
+    if (hit) {
+        if (isSignalConnected(hitSignal())) {
+            emit cacheHit(generateMetadataKey(key, category), category);
+        }
+    } else if (isSignalConnected(missSignal())) {
+        emit cacheMiss(generateMetadataKey(key, category), category);
     }
     
-    QVariant result = entry.data;
-    
-    locker.unlock();
-    emit cacheHit(cacheKey, category);
-    logCacheOperation("getMetadata", cacheKey, true, QString("Key: %1, Category: %2").arg(key).arg(category));
-    
     return result;
 }
 
 bool MusicCache::containsMetadata(const QString& key, const QString& category)
 {
-    QString cacheKey = generateMetadataKey(key, category);
-    
-    QMutexLocker locker(&m_cacheMutex);
-    
-    if (!m_cache.contains(cacheKey)) {
+    Category* cat = findCategory(category);
+    if (!cat) {
         return false;
     }
     
-    const CacheEntry& entry = m_cache[cacheKey];
-    if (isExpired(entry)) {
-        m_cache.remove(cacheKey);
-        m_statistics.currentMemoryUsage -= entry.size;
-        m_statistics.currentEntries = m_cache.size();
-        return false;
+    qint64 expiredSize = -1;
+    {
+        Shard& shard = keyShard(key);
+        QMutexLocker locker(&shard.mutex);
+        
+        Shard::MetadataEntry* entry = shard.metadata.value(qMakePair(cat->id, key));
+        if (!entry) {
+            return false;
+        }
+        
+        if (!isExpired(*entry, QDateTime::currentMSecsSinceEpoch())) {
+            return true;
+        }
+        
+        expiredSize = entry->size;
+        shard.erase(entry);
     }
     
-    return true;
+    recordUsage(cat, -expiredSize, -1);
+    return false;
 }
 
 bool MusicCache::removeMetadata(const QString& key, const QString& category)
 {
-    QString cacheKey = generateMetadataKey(key, category);
-    
-    QMutexLocker locker(&m_cacheMutex);
-    
-    if (!m_cache.contains(cacheKey)) {
+    Category* cat = findCategory(category);
+    if (!cat) {
         return false;
     }
     
-    const CacheEntry& entry = m_cache[cacheKey];
-    m_statistics.currentMemoryUsage -= entry.size;
-    m_statistics.categorySize[category] -= entry.size;
-    
-    m_cache.remove(cacheKey);
-    m_statistics.currentEntries = m_cache.size();
+    qint64 size = 0;
+    {
+        Shard& shard = keyShard(key);
+        QMutexLocker locker(&shard.mutex);
+        
+        Shard::MetadataEntry* entry = shard.metadata.value(qMakePair(cat->id, key));
+        if (!entry) {
+            return false;
+        }
+        
+        size = entry->size;
+        shard.erase(entry);
+    }
     
-    logCacheOperation("removeMetadata", cacheKey, true, QString("Key: %1, Category: %2").arg(key).arg(category));
+    recordUsage(cat, -size, -1);
+    logCacheOperation("removeMetadata", generateMetadataKey(key, category), true,
+                      QString("Key: %1, Category: %2").arg(key).arg(category));
     return true;
 }
 
 void MusicCache::clear()
 {
-    QMutexLocker locker(&m_cacheMutex);
-    
-    int entriesRemoved = m_cache.size();
-    qint64 memoryFreed = m_statistics.currentMemoryUsage;
-    
-    m_cache.clear();
-    
-    // Reset statistics
-    QMutexLocker statsLocker(&m_statsMutex);
-    m_statistics.currentEntries = 0;
-    m_statistics.currentMemoryUsage = 0;
-    m_statistics.categorySize.clear();
+    qint64 memoryFreed = 0;
+    int entriesRemoved = removeWhere([](const EntryHeader&) { return true; }, QString(), memoryFreed);
     
     ErrorHandler::logMessage(ErrorHandler::ErrorSeverity::Info, "MusicCache", QString("Cache cleared: %1 entries, %2 MB freed")
                  .arg(entriesRemoved).arg(memoryFreed / (1024 * 1024)));
@@ -638,31 +1094,15 @@ void MusicCache::clear()
 
 void MusicCache::clearCategory(const QString& category)
 {
-    QMutexLocker locker(&m_cacheMutex);
+    Category* cat = findCategory(category);
     
-    int entriesRemoved = 0;
     qint64 memoryFreed = 0;
-    
-    auto it = m_cache.begin();
-    while (it != m_cache.end()) {
-        const CacheEntry& entry = it.value();
-        QString entryCategory = entry.metadata.value("category", "unknown").toString();
-        
-        if (entryCategory == category) {
-            memoryFreed += entry.size;
-            entriesRemoved++;
-            it = m_cache.erase(it);
-        } else {
-            ++it;
-        }
+    int entriesRemoved = 0;
+    if (cat) {
+        entriesRemoved = removeWhere([cat](const EntryHeader& entry) { return entry.category == cat; },
+                                     QString(), memoryFreed);
     }
     
-    // Update statistics
-    QMutexLocker statsLocker(&m_statsMutex);
-    m_statistics.currentEntries = m_cache.size();
-    m_statistics.currentMemoryUsage -= memoryFreed;
-    m_statistics.categorySize[category] = 0;
-    
     ErrorHandler::logMessage(ErrorHandler::ErrorSeverity::Info, "MusicCache", QString("Category '%1' cleared: %2 entries, %3 MB freed")
                  .arg(category).arg(entriesRemoved).arg(memoryFreed / (1024 * 1024)));
     
@@ -671,32 +1111,12 @@ void MusicCache::clearCategory(const QString& category)
 
 void MusicCache::invalidateExpired()
 {
-    QMutexLocker locker(&m_cacheMutex);
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
     
-    int entriesRemoved = 0;
     qint64 memoryFreed = 0;
-    
-    auto it = m_cache.begin();
-    while (it != m_cache.end()) {
-        const CacheEntry& entry = it.value();
-        
-        if (isExpired(entry)) {
-            QString category = entry.metadata.value("category", "unknown").toString();
-            memoryFreed += entry.size;
-            entriesRemoved++;
-            
-            emit entryEvicted(it.key(), category, "expired");
-            it = m_cache.erase(it);
-        } else {
-            ++it;
-        }
-    }
-    
-    // Update statistics
-    QMutexLocker statsLocker(&m_statsMutex);
-    m_statistics.currentEntries = m_cache.size();
-    m_statistics.currentMemoryUsage -= memoryFreed;
-    m_statistics.totalEvictions += entriesRemoved;
+    int entriesRemoved = removeWhere([this, now](const EntryHeader& entry) { return isExpired(entry, now); },
+                                     "expired", memoryFreed);
+    m_totalEvictions += entriesRemoved;
     
     if (entriesRemoved > 0) {
         ErrorHandler::logMessage(ErrorHandler::ErrorSeverity::Info, "MusicCache", QString("Expired entries invalidated: %1 entries, %2 MB freed")
@@ -704,101 +1124,250 @@ void MusicCache::invalidateExpired()
     }
 }
 
-void MusicCache::cleanup(qint64 targetMemoryUsage)
+int MusicCache::invalidateMusic(int musicId)
 {
-    QMutexLocker locker(&m_cacheMutex);
+    struct Removed {
+        QString key;
+        QString category;
+    };
+    
+    const bool reportEvictions = isSignalConnected(evictedSignal());
+    QList<Removed> reported;
+    QHash<Category*, qint64> freedByCategory;
+    int removed = 0;
+    
+    // Callers hold the shard's lock
+    auto drop = [&](Shard& shard, EntryHeader* entry) {
+        freedByCategory[entry->category] += entry->size;
+        if (reportEvictions) {
+            reported.append(Removed{cacheKey(*entry), entry->category->name});
+        }
+        shard.erase(entry);
+        ++removed;
+    };
+    
+    QList<Category*> categories;
+    {
+        QReadLocker locker(&m_categoryLock);
+        categories = m_categories;
+    }
+    
+    // The item itself, under every category it may be cached in
+    {
+        Shard& shard = musicShard(musicId);
+        QMutexLocker locker(&shard.mutex);
+        for (Category* category : std::as_const(categories)) {
+            if (Shard::MusicEntry* entry = shard.music.value(musicKey(category->id, musicId))) {
+                drop(shard, entry);
+            }
+        }
+    }
     
-    if (targetMemoryUsage < 0) {
-        targetMemoryUsage = static_cast<qint64>(m_maxMemoryUsage * MEMORY_CLEANUP_TARGET);
+    // Searches containing it; erasing a search drops all of its index entries
+    for (auto& shard : m_shards) {
+        QMutexLocker locker(&shard->mutex);
+        while (Shard::SearchEntry* entry = shard->searchesByMusicId.value(musicId)) {
+            drop(*shard, entry);
+        }
     }
     
-    if (m_statistics.currentMemoryUsage <= targetMemoryUsage) {
-        return; // No cleanup needed
+    if (removed == 0) {
+        return 0;
     }
     
-    ErrorHandler::logMessage(ErrorHandler::ErrorSeverity::Info, "MusicCache", QString("Starting cleanup: current %1 MB, target %2 MB")
-                 .arg(m_statistics.currentMemoryUsage / (1024 * 1024))
-                 .arg(targetMemoryUsage / (1024 * 1024)));
+    for (auto it = freedByCategory.constBegin(); it != freedByCategory.constEnd(); ++it) {
+        recordUsage(it.key(), -it.value(), 0);
+    }
+    m_entryCount -= removed;
     
-    int entriesRemoved = 0;
+    for (const Removed& entry : std::as_const(reported)) {
+        emit entryEvicted(entry.key, entry.category, "invalidated");
+    }
+    
+    return removed;
+}
+
+int MusicCache::invalidateSearchResults()
+{
     qint64 memoryFreed = 0;
+    return removeWhere([](const EntryHeader& entry) { return entry.kind == EntryKind::Search; },
+                       "invalidated", memoryFreed);
+}
+
+void MusicCache::attachRepository(MusicRepository* repository)
+{
+    if (m_repository) {
+        disconnect(m_repository, nullptr, this, nullptr);
+    }
     
-    // First, remove expired entries
-    auto it = m_cache.begin();
-    while (it != m_cache.end() && m_statistics.currentMemoryUsage > targetMemoryUsage) {
-        const CacheEntry& entry = it.value();
-        
-        if (isExpired(entry)) {
-            QString category = entry.metadata.value("category", "unknown").toString();
-            memoryFreed += entry.size;
-            m_statistics.currentMemoryUsage -= entry.size;
-            entriesRemoved++;
-            
-            emit entryEvicted(it.key(), category, "expired");
-            it = m_cache.erase(it);
-        } else {
-            ++it;
-        }
+    m_repository = repository;
+    if (!repository) {
+        return;
+    }
+    
+    connect(repository, &MusicRepository::musicUpdated, this,
+            [this](const MusicItem& music) { invalidateMusic(music.id); }, Qt::DirectConnection);
+    connect(repository, &MusicRepository::musicDeleted, this,
+            [this](int musicId) { invalidateMusic(musicId); }, Qt::DirectConnection);
+    connect(repository, &MusicRepository::playCountIncremented, this,
+            [this](int musicId) { invalidateMusic(musicId); }, Qt::DirectConnection);
+    connect(repository, &MusicRepository::musicAdded, this,
+            [this]() { invalidateSearchResults(); }, Qt::DirectConnection);
+}
+
+void MusicCache::cleanup(qint64 targetMemoryUsage)
+{
+    const qint64 maxUsage = m_maxMemoryUsage;
+    if (targetMemoryUsage < 0) {
+        targetMemoryUsage = static_cast<qint64>(maxUsage * MEMORY_CLEANUP_TARGET);
     }
     
-    // If still over target, use LRU eviction
-    if (m_statistics.currentMemoryUsage > targetMemoryUsage) {
-        int lruEvicted = evictLRU(targetMemoryUsage);
-        entriesRemoved += lruEvicted;
+    const qint64 usageBefore = m_memoryUsage;
+    if (usageBefore <= targetMemoryUsage) {
+        return; // No cleanup needed
     }
     
-    // Update statistics
-    QMutexLocker statsLocker(&m_statsMutex);
-    m_statistics.currentEntries = m_cache.size();
-    m_statistics.totalEvictions += entriesRemoved;
-    m_statistics.lastCleanup = QDateTime::currentDateTime();
+    ErrorHandler::logMessage(ErrorHandler::ErrorSeverity::Info, "MusicCache", QString("Starting cleanup: current %1 MB, target %2 MB")
+                 .arg(usageBefore / (1024 * 1024))
+                 .arg(targetMemoryUsage / (1024 * 1024)));
+    
+    // Expired entries are reclaimed on access and by invalidateExpired();
+    // any left over sit at the old end of the recency lists and go first
+    const int entriesRemoved = evictLRU(targetMemoryUsage);
+    m_totalEvictions += entriesRemoved;
+    {
+        QMutexLocker statsLocker(&m_statsMutex);
+        m_lastCleanup = QDateTime::currentDateTime();
+    }
     
+    const qint64 usageAfter = m_memoryUsage;
+    const qint64 memoryFreed = std::max<qint64>(0, usageBefore - usageAfter);
     ErrorHandler::logMessage(ErrorHandler::ErrorSeverity::Info, "MusicCache", QString("Cleanup completed: %1 entries removed, %2 MB freed, current usage: %3 MB")
                  .arg(entriesRemoved)
                  .arg(memoryFreed / (1024 * 1024))
-                 .arg(m_statistics.currentMemoryUsage / (1024 * 1024)));
+                 .arg(usageAfter / (1024 * 1024)));
     
     emit cleanupCompleted(entriesRemoved, memoryFreed);
     
     // Check if we're still over the memory threshold
-    if (m_statistics.currentMemoryUsage > m_maxMemoryUsage * MEMORY_CLEANUP_THRESHOLD) {
-        emit memoryThresholdExceeded(m_statistics.currentMemoryUsage, m_maxMemoryUsage);
+    if (usageAfter > maxUsage * MEMORY_CLEANUP_THRESHOLD) {
+        emit memoryThresholdExceeded(usageAfter, maxUsage);
+    }
+}
+
+void MusicCache::setHourGenreSchedule(HourGenreSchedule* schedule)
+{
+    m_hourGenres = schedule;
+}
+
+void MusicCache::setSchedulerEngine(SchedulerEngine* scheduler)
+{
+    m_scheduler = scheduler;
+    if (scheduler) {
+        scheduleNextWarmup();
+    } else {
+        m_warmupTimer->stop();
     }
 }
 
 void MusicCache::warmupCache()
 {
-    if (m_warmupStrategy == NoWarmup) {
+    if (m_warmupStrategy == NoWarmup || m_warmupWatcher->isRunning()) {
+        return;
+    }
+    
+    if (!m_repository) {
+        ErrorHandler::logMessage(ErrorHandler::ErrorSeverity::Info, "MusicCache", "No repository attached, nothing to warm up");
+        finishWarmup(0);
         return;
     }
     
     ErrorHandler::logMessage(ErrorHandler::ErrorSeverity::Info, "MusicCache", "Starting cache warmup");
     
-    int entriesWarmed = 0;
+    // The schedule reads its own connection, so resolve genres on this thread
+    const WarmupStrategy strategy = m_warmupStrategy;
+    const QStringList genres = strategy == PredictiveWarmup
+                                   ? upcomingGenres(QDateTime::currentDateTime())
+                                   : QStringList();
+    MusicRepository* repository = m_repository;
+    
+    m_warmupWatcher->setFuture(QtConcurrent::run([this, repository, strategy, genres]() {
+        return loadWarmupItems(repository, strategy, genres);
+    }));
+}
+
+bool MusicCache::isWarmupRunning() const
+{
+    return m_warmupWatcher->isRunning();
+}
+
+QStringList MusicCache::upcomingGenres(const QDateTime& from) const
+{
+    QStringList genres;
+    if (!m_hourGenres) {
+        return genres;
+    }
+    
+    for (int hour = 0; hour < WARMUP_HORIZON_HOURS; ++hour) {
+        const QString genre = m_hourGenres->genreAt(from.addSecs(hour * 3600));
+        if (!genre.isEmpty() && !genres.contains(genre)) {
+            genres.append(genre);
+        }
+    }
+    
+    return genres;
+}
+
+int MusicCache::loadWarmupItems(MusicRepository* repository, WarmupStrategy strategy, const QStringList& genres)
+{
+    // Stay below the cleanup target so warming never evicts live entries
+    const qint64 budget = static_cast<qint64>(m_maxMemoryUsage * MEMORY_CLEANUP_TARGET);
+    QSet<int> warmed;
     
-    // This is a simplified warmup implementation
-    // In a real application, you would query the database for popular/recent items
-    // and pre-load them into the cache
+    auto warm = [this, budget, &warmed](const MusicItem& music) {
+        if (m_memoryUsage >= budget) {
+            return false;
+        }
+        if (!warmed.contains(music.id)) {
+            put(music.id, music);
+            warmed.insert(music.id);
+        }
+        return true;
+    };
+    auto warmAll = [&warm](const QList<MusicItem>& items) {
+        for (const MusicItem& music : items) {
+            if (!warm(music)) {
+                return false;
+            }
+        }
+        return true;
+    };
     
-    switch (m_warmupStrategy) {
+    switch (strategy) {
         case PopularItemsWarmup:
-            // Would query database for most played items
-            ErrorHandler::logMessage(ErrorHandler::ErrorSeverity::Info, "MusicCache", "Popular items warmup not implemented - requires database access");
+            warmAll(repository->getMostPlayedMusic(WARMUP_TOP_PLAYED));
             break;
             
         case RecentItemsWarmup:
-            // Would query database for recently accessed items
-            ErrorHandler::logMessage(ErrorHandler::ErrorSeverity::Info, "MusicCache", "Recent items warmup not implemented - requires database access");
+            warmAll(repository->getRecentlyPlayedMusic(WARMUP_TOP_PLAYED));
             break;
             
-        case PredictiveWarmup:
-            // Would use machine learning or heuristics to predict likely accessed items
-            ErrorHandler::logMessage(ErrorHandler::ErrorSeverity::Info, "MusicCache", "Predictive warmup not implemented - requires ML model");
+        case PredictiveWarmup: {
+            bool hasRoom = true;
+            for (const QString& genre : genres) {
+                hasRoom = warmAll(repository->getMostPlayedMusic(WARMUP_TRACKS_PER_GENRE, genre));
+                if (!hasRoom) {
+                    break;
+                }
+            }
+            if (hasRoom) {
+                warmAll(repository->getMostPlayedMusic(WARMUP_TOP_PLAYED));
+            }
             break;
+        }
             
         case FullWarmup:
-            // Would load entire dataset (use with caution)
-            ErrorHandler::logMessage(ErrorHandler::ErrorSeverity::Info, "MusicCache", "Full warmup not implemented - requires database access");
+            repository->forEachMusic(warm);
             break;
             
         case NoWarmup:
@@ -806,75 +1375,174 @@ void MusicCache::warmupCache()
             break;
     }
     
-    QMutexLocker statsLocker(&m_statsMutex);
-    m_statistics.lastWarmup = QDateTime::currentDateTime();
+    return warmed.size();
+}
+
+void MusicCache::finishWarmup(int entriesWarmed)
+{
+    {
+        QMutexLocker statsLocker(&m_statsMutex);
+        m_lastWarmup = QDateTime::currentDateTime();
+    }
     
     ErrorHandler::logMessage(ErrorHandler::ErrorSeverity::Info, "MusicCache", QString("Cache warmup completed: %1 entries warmed").arg(entriesWarmed));
     emit warmupCompleted(entriesWarmed);
+    
+    scheduleNextWarmup();
 }
 
-void MusicCache::pinEntry(const QString& key, const QString& category)
+void MusicCache::scheduleNextWarmup()
 {
-    QString cacheKey = (category == "music") ? generateMusicKey(key.toInt(), category) : 
-                       (category == "search") ? generateSearchKey(key) :
-                       generateMetadataKey(key, category);
-    
-    QMutexLocker locker(&m_cacheMutex);
+    m_warmupTimer->stop();
+    if (!m_scheduler || m_warmupStrategy == NoWarmup) {
+        return;
+    }
     
-    if (m_cache.contains(cacheKey)) {
-        m_cache[cacheKey].isPinned = true;
-        logCacheOperation("pinEntry", cacheKey, true, QString("Category: %1").arg(category));
+    // Programs closer than the lead time are covered by the warmup just run
+    const QDateTime now = QDateTime::currentDateTime();
+    const QList<ScheduledEvent> upcoming = m_scheduler->upcomingEvents(now.addSecs(WARMUP_LEAD_SECS), now.addDays(1));
+    for (const ScheduledEvent& event : upcoming) {
+        if (event.rule.isProgram) {
+            const qint64 delayMs = now.msecsTo(event.fireAt.addSecs(-WARMUP_LEAD_SECS));
+            m_warmupTimer->start(static_cast<int>(std::max<qint64>(0, delayMs)));
+            return;
+        }
+    }
+}
+
+void MusicCache::pinEntry(const QString& key, const QString& category)
+{
+    if (setPinned(key, category, true)) {
+        logCacheOperation("pinEntry", key, true, QString("Category: %1").arg(category));
     }
 }
 
 void MusicCache::unpinEntry(const QString& key, const QString& category)
 {
-    QString cacheKey = (category == "music") ? generateMusicKey(key.toInt(), category) : 
-                       (category == "search") ? generateSearchKey(key) :
-                       generateMetadataKey(key, category);
-    
-    QMutexLocker locker(&m_cacheMutex);
-    
-    if (m_cache.contains(cacheKey)) {
-        m_cache[cacheKey].isPinned = false;
-        logCacheOperation("unpinEntry", cacheKey, true, QString("Category: %1").arg(category));
+    if (setPinned(key, category, false)) {
+        logCacheOperation("unpinEntry", key, true, QString("Category: %1").arg(category));
     }
 }
 
 MusicCache::CacheStatistics MusicCache::getStatistics() const
 {
+    CacheStatistics stats;
+    stats.totalHits = m_totalHits;
+    stats.totalMisses = m_totalMisses;
+    stats.totalEvictions = m_totalEvictions;
+    stats.currentEntries = m_entryCount;
+    stats.currentMemoryUsage = m_memoryUsage;
+    stats.maxMemoryUsage = m_maxMemoryUsage;
+    
+    // Calculate hit ratio
+    const qint64 totalAccesses = stats.totalHits + stats.totalMisses;
+    if (totalAccesses > 0) {
+        stats.hitRatio = static_cast<double>(stats.totalHits) / totalAccesses;
+    }
+    
+    {
+        QReadLocker locker(&m_categoryLock);
+        for (const Category* category : std::as_const(m_categories)) {
+            if (const qint64 hits = category->hits) {
+                stats.categoryHits.insert(category->name, hits);
+            }
+            if (const qint64 misses = category->misses) {
+                stats.categoryMisses.insert(category->name, misses);
+            }
+            if (const qint64 size = category->size) {
+                stats.categorySize.insert(category->name, size);
+            }
+        }
+    }
+    
     QMutexLocker locker(&m_statsMutex);
-    return m_statistics;
+    stats.lastCleanup = m_lastCleanup;
+    stats.lastWarmup = m_lastWarmup;
+    return stats;
 }
 
 std::unique_ptr<MusicCache::CacheEntry> MusicCache::getEntryInfo(const QString& key, const QString& category)
 {
-    QString cacheKey = (category == "music") ? generateMusicKey(key.toInt(), category) : 
-                       (category == "search") ? generateSearchKey(key) :
-                       generateMetadataKey(key, category);
-    
-    QMutexLocker locker(&m_cacheMutex);
-    
-    if (!m_cache.contains(cacheKey)) {
+    Category* cat = findCategory(category);
+    if (!cat) {
         return nullptr;
     }
     
-    return std::make_unique<CacheEntry>(m_cache[cacheKey]);
+    auto info = std::make_unique<CacheEntry>();
+    auto fillHeader = [&info](const EntryHeader& header) {
+        info->createdAt = fromMs(header.createdAtMs);
+        info->lastAccessed = fromMs(header.lastAccessedMs);
+        info->expiresAt = fromMs(header.expiresAtMs);
+        info->accessCount = header.accessCount;
+        info->size = header.size;
+        info->isPinned = header.isPinned;
+    };
+    
+    if (category == "music") {
+        const int musicId = key.toInt();
+        Shard& shard = musicShard(musicId);
+        QMutexLocker locker(&shard.mutex);
+        
+        const Shard::MusicEntry* entry = shard.music.value(musicKey(cat->id, musicId));
+        if (!entry) {
+            return nullptr;
+        }
+        fillHeader(*entry);
+        info->data = QVariant::fromValue(entry->music);
+        info->source = "manual";
+        info->metadata["musicId"] = musicId;
+    } else if (cat == m_searchCategory) {
+        Shard& shard = keyShard(key);
+        QMutexLocker locker(&shard.mutex);
+        
+        const Shard::SearchEntry* entry = shard.search.value(key);
+        if (!entry) {
+            return nullptr;
+        }
+        fillHeader(*entry);
+        info->data = QVariant::fromValue(entry->results);
+        info->source = "search";
+        info->metadata["searchKey"] = key;
+        info->metadata["resultCount"] = entry->results.size();
+    } else {
+        Shard& shard = keyShard(key);
+        QMutexLocker locker(&shard.mutex);
+        
+        const Shard::MetadataEntry* entry = shard.metadata.value(qMakePair(cat->id, key));
+        if (!entry) {
+            return nullptr;
+        }
+        fillHeader(*entry);
+        info->data = entry->data;
+        info->source = "metadata";
+        info->metadata["originalKey"] = key;
+    }
+    
+    info->metadata["category"] = category;
+    return info;
 }
 
 QStringList MusicCache::getKeys(const QString& category)
 {
-    QMutexLocker locker(&m_cacheMutex);
+    const Category* cat = category.isEmpty() ? nullptr : findCategory(category);
+    if (!category.isEmpty() && !cat) {
+        return QStringList();
+    }
     
     QStringList keys;
-    
-    for (auto it = m_cache.begin(); it != m_cache.end(); ++it) {
-        const CacheEntry& entry = it.value();
-        QString entryCategory = entry.metadata.value("category", "unknown").toString();
-        
-        if (category.isEmpty() || entryCategory == category) {
-            keys.append(it.key());
+    auto collect = [this, cat, &keys](const auto& hash) {
+        for (const EntryHeader* entry : hash) {
+            if (!cat || entry->category == cat) {
+                keys.append(cacheKey(*entry));
+            }
         }
+    };
+    
+    for (auto& shard : m_shards) {
+        QMutexLocker locker(&shard->mutex);
+        collect(shard->music);
+        collect(shard->search);
+        collect(shard->metadata);
     }
     
     return keys;
@@ -882,42 +1550,42 @@ QStringList MusicCache::getKeys(const QString& category)
 
 QString MusicCache::exportStatistics()
 {
-    QMutexLocker locker(&m_statsMutex);
+    const CacheStatistics stats = getStatistics();
     
     QJsonObject root;
     
     // Basic statistics
-    root["totalHits"] = static_cast<qint64>(m_statistics.totalHits);
-    root["totalMisses"] = static_cast<qint64>(m_statistics.totalMisses);
-    root["totalEvictions"] = static_cast<qint64>(m_statistics.totalEvictions);
-    root["currentEntries"] = static_cast<qint64>(m_statistics.currentEntries);
-    root["currentMemoryUsage"] = static_cast<qint64>(m_statistics.currentMemoryUsage);
-    root["maxMemoryUsage"] = static_cast<qint64>(m_statistics.maxMemoryUsage);
-    root["hitRatio"] = m_statistics.hitRatio;
+    root["totalHits"] = stats.totalHits;
+    root["totalMisses"] = stats.totalMisses;
+    root["totalEvictions"] = stats.totalEvictions;
+    root["currentEntries"] = stats.currentEntries;
+    root["currentMemoryUsage"] = stats.currentMemoryUsage;
+    root["maxMemoryUsage"] = stats.maxMemoryUsage;
+    root["hitRatio"] = stats.hitRatio;
     
-    if (m_statistics.lastCleanup.isValid()) {
-        root["lastCleanup"] = m_statistics.lastCleanup.toString(Qt::ISODate);
+    if (stats.lastCleanup.isValid()) {
+        root["lastCleanup"] = stats.lastCleanup.toString(Qt::ISODate);
     }
-    if (m_statistics.lastWarmup.isValid()) {
-        root["lastWarmup"] = m_statistics.lastWarmup.toString(Qt::ISODate);
+    if (stats.lastWarmup.isValid()) {
+        root["lastWarmup"] = stats.lastWarmup.toString(Qt::ISODate);
     }
     
     // Category statistics
     QJsonObject categoryHits;
-    for (auto it = m_statistics.categoryHits.begin(); it != m_statistics.categoryHits.end(); ++it) {
-        categoryHits[it.key()] = static_cast<qint64>(it.value());
+    for (auto it = stats.categoryHits.begin(); it != stats.categoryHits.end(); ++it) {
+        categoryHits[it.key()] = it.value();
     }
     root["categoryHits"] = categoryHits;
     
     QJsonObject categoryMisses;
-    for (auto it = m_statistics.categoryMisses.begin(); it != m_statistics.categoryMisses.end(); ++it) {
-        categoryMisses[it.key()] = static_cast<qint64>(it.value());
+    for (auto it = stats.categoryMisses.begin(); it != stats.categoryMisses.end(); ++it) {
+        categoryMisses[it.key()] = it.value();
     }
     root["categoryMisses"] = categoryMisses;
     
     QJsonObject categorySize;
-    for (auto it = m_statistics.categorySize.begin(); it != m_statistics.categorySize.end(); ++it) {
-        categorySize[it.key()] = static_cast<qint64>(it.value());
+    for (auto it = stats.categorySize.begin(); it != stats.categorySize.end(); ++it) {
+        categorySize[it.key()] = it.value();
     }
     root["categorySize"] = categorySize;
     
@@ -927,58 +1595,84 @@ QString MusicCache::exportStatistics()
 
 bool MusicCache::saveToFile(const QString& filePath)
 {
-    QMutexLocker locker(&m_cacheMutex);
-    
     QFile file(filePath);
     if (!file.open(QIODevice::WriteOnly)) {
         ErrorHandler::logMessage(ErrorHandler::ErrorSeverity::Error, "MusicCache", QString("Failed to open cache file for writing: %1").arg(filePath));
         return false;
     }
     
-    QJsonObject root;
     QJsonArray entries;
     
-    for (auto it = m_cache.begin(); it != m_cache.end(); ++it) {
-        const CacheEntry& entry = it.value();
-        
+    auto headerObject = [](const QString& key, const EntryHeader& header, const QString& source) {
         QJsonObject entryObj;
-        entryObj["key"] = it.key();
-        entryObj["createdAt"] = entry.createdAt.toString(Qt::ISODate);
-        entryObj["lastAccessed"] = entry.lastAccessed.toString(Qt::ISODate);
-        if (entry.expiresAt.isValid()) {
-            entryObj["expiresAt"] = entry.expiresAt.toString(Qt::ISODate);
-        }
-        entryObj["accessCount"] = entry.accessCount;
-        entryObj["size"] = static_cast<qint64>(entry.size);
-        entryObj["source"] = entry.source;
-        entryObj["isPinned"] = entry.isPinned;
-        
-        // Serialize data (simplified - in practice you'd need proper serialization)
-        QJsonObject dataObj;
-        dataObj["type"] = entry.data.typeName();
-        // Note: Full data serialization would require custom serialization for MusicItem
+        entryObj["key"] = key;
+        entryObj["createdAt"] = fromMs(header.createdAtMs).toString(Qt::ISODateWithMs);
+        entryObj["lastAccessed"] = fromMs(header.lastAccessedMs).toString(Qt::ISODateWithMs);
+        if (header.expiresAtMs > 0) {
+            entryObj["expiresAt"] = fromMs(header.expiresAtMs).toString(Qt::ISODateWithMs);
+        }
+        entryObj["accessCount"] = header.accessCount;
+        entryObj["size"] = static_cast<qint64>(header.size);
+        entryObj["source"] = source;
+        entryObj["isPinned"] = header.isPinned;
+        return entryObj;
+    };
+    
+    for (auto& shard : m_shards) {
+        QMutexLocker locker(&shard->mutex);
         
-        entryObj["data"] = dataObj;
+        for (const Shard::MusicEntry* entry : std::as_const(shard->music)) {
+            QJsonObject entryObj = headerObject(cacheKey(*entry), *entry, "manual");
+            entryObj["data"] = QJsonObject::fromVariantMap(entry->music.toVariantMap());
+            
+            QJsonObject metadataObj;
+            metadataObj["musicId"] = entry->musicId;
+            metadataObj["category"] = entry->category->name;
+            entryObj["metadata"] = metadataObj;
+            entries.append(entryObj);
+        }
         
-        // Metadata
-        QJsonObject metadataObj;
-        for (auto metaIt = entry.metadata.begin(); metaIt != entry.metadata.end(); ++metaIt) {
-            metadataObj[metaIt.key()] = QJsonValue::fromVariant(metaIt.value());
+        for (const Shard::SearchEntry* entry : std::as_const(shard->search)) {
+            QJsonObject entryObj = headerObject(cacheKey(*entry), *entry, "search");
+            
+            QJsonArray results;
+            for (const MusicItem& music : entry->results) {
+                results.append(QJsonObject::fromVariantMap(music.toVariantMap()));
+            }
+            entryObj["data"] = results;
+            
+            QJsonObject metadataObj;
+            metadataObj["searchKey"] = entry->key;
+            metadataObj["resultCount"] = static_cast<int>(entry->results.size());
+            metadataObj["category"] = "search";
+            entryObj["metadata"] = metadataObj;
+            entries.append(entryObj);
         }
-        entryObj["metadata"] = metadataObj;
         
-        entries.append(entryObj);
+        for (const Shard::MetadataEntry* entry : std::as_const(shard->metadata)) {
+            QJsonObject entryObj = headerObject(cacheKey(*entry), *entry, "metadata");
+            QJsonObject dataObj;
+            dataObj["value"] = QJsonValue::fromVariant(entry->data);
+            entryObj["data"] = dataObj;
+            
+            QJsonObject metadataObj;
+            metadataObj["originalKey"] = entry->key;
+            metadataObj["category"] = entry->category->name;
+            entryObj["metadata"] = metadataObj;
+            entries.append(entryObj);
+        }
     }
     
+    QJsonObject root;
     root["entries"] = entries;
-    root["version"] = "1.0";
+    root["version"] = CACHE_FILE_VERSION;
     root["timestamp"] = QDateTime::currentDateTime().toString(Qt::ISODate);
     
     QJsonDocument doc(root);
     file.write(doc.toJson());
     
     ErrorHandler::logMessage(ErrorHandler::ErrorSeverity::Info, "MusicCache", QString("Cache saved to file: %1 (%2 entries)")
-                 .arg(filePath).arg(m_cache.size()));
+                 .arg(filePath).arg(entries.size()));
     
     return true;
 }
@@ -1000,52 +1694,333 @@ bool MusicCache::loadFromFile(const QString& filePath)
     }
     
     QJsonObject root = doc.object();
-    QJsonArray entries = root["entries"].toArray();
+    if (root["version"].toString() != CACHE_FILE_VERSION) {
+        // Older files only recorded entry bookkeeping, not the cached values
+        ErrorHandler::logMessage(ErrorHandler::ErrorSeverity::Warning, "MusicCache", QString("Ignoring cache file with version %1: %2")
+                     .arg(root["version"].toString(), filePath));
+        return true;
+    }
     
-    QMutexLocker locker(&m_cacheMutex);
+    QJsonArray entries = root["entries"].toArray();
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
     
     int loadedEntries = 0;
     
     for (const QJsonValue& value : entries) {
         QJsonObject entryObj = value.toObject();
+        QJsonObject metadataObj = entryObj["metadata"].toObject();
+        
+        EntryHeader header;
+        header.createdAtMs = toMs(entryObj["createdAt"].toString());
+        header.lastAccessedMs = toMs(entryObj["lastAccessed"].toString());
+        header.expiresAtMs = toMs(entryObj["expiresAt"].toString());
+        header.accessCount = entryObj["accessCount"].toInt();
+        header.isPinned = entryObj["isPinned"].toBool();
+        
+        // Skip expired entries
+        if (isExpired(header, now)) {
+            continue;
+        }
+        
+        // Entries are loaded in the order they were saved, not by recency
+        header.lruStamp = nextLruStamp();
+        header.category = registerCategory(metadataObj["category"].toString());
+        
+        if (metadataObj.contains("musicId")) {
+            auto* entry = new Shard::MusicEntry;
+            static_cast<EntryHeader&>(*entry) = header;
+            entry->kind = EntryKind::Music;
+            entry->musicId = metadataObj["musicId"].toInt();
+            entry->music = MusicItem::fromVariantMap(entryObj["data"].toObject().toVariantMap());
+            adoptEntry(entry);
+        } else if (metadataObj.contains("searchKey")) {
+            auto* entry = new Shard::SearchEntry;
+            static_cast<EntryHeader&>(*entry) = header;
+            entry->kind = EntryKind::Search;
+            entry->key = metadataObj["searchKey"].toString();
+            const QJsonArray results = entryObj["data"].toArray();
+            entry->results.reserve(results.size());
+            for (const QJsonValue& result : results) {
+                entry->results.append(MusicItem::fromVariantMap(result.toObject().toVariantMap()));
+            }
+            adoptEntry(entry);
+        } else if (metadataObj.contains("originalKey")) {
+            auto* entry = new Shard::MetadataEntry;
+            static_cast<EntryHeader&>(*entry) = header;
+            entry->kind = EntryKind::Metadata;
+            entry->key = metadataObj["originalKey"].toString();
+            entry->data = entryObj["data"].toObject().value("value").toVariant();
+            adoptEntry(entry);
+        } else {
+            continue;
+        }
         
-        QString key = entryObj["key"].toString();
+        loadedEntries++;
+    }
+    
+    ErrorHandler::logMessage(ErrorHandler::ErrorSeverity::Info, "MusicCache", QString("Cache loaded from file: %1 (%2 entries loaded)")
+                 .arg(filePath).arg(loadedEntries));
+    
+    return true;
+}
+
+bool MusicCache::saveSnapshot(const QString& filePath)
+{
+    struct PendingRecord {
+        quint64 lruStamp;
+        SnapshotRecord record;
+    };
+    
+    SnapshotWriter writer;
+    QList<PendingRecord> pending;
+    
+    for (auto& shard : m_shards) {
+        QMutexLocker locker(&shard->mutex);
         
-        CacheEntry entry;
-        entry.createdAt = QDateTime::fromString(entryObj["createdAt"].toString(), Qt::ISODate);
-        entry.lastAccessed = QDateTime::fromString(entryObj["lastAccessed"].toString(), Qt::ISODate);
+        auto addRecord = [&writer, &pending](const EntryHeader& entry) -> SnapshotRecord& {
+            SnapshotRecord record{};
+            record.createdAtMs = entry.createdAtMs;
+            record.lastAccessedMs = entry.lastAccessedMs;
+            record.expiresAtMs = entry.expiresAtMs;
+            record.accessCount = entry.accessCount;
+            record.category = writer.string(entry.category->name);
+            record.kind = static_cast<quint8>(entry.kind);
+            record.isPinned = entry.isPinned ? 1 : 0;
+            pending.append(PendingRecord{entry.lruStamp, record});
+            return pending.last().record;
+        };
         
-        if (entryObj.contains("expiresAt")) {
-            entry.expiresAt = QDateTime::fromString(entryObj["expiresAt"].toString(), Qt::ISODate);
+        for (const Shard::MusicEntry* entry : std::as_const(shard->music)) {
+            SnapshotRecord& record = addRecord(*entry);
+            record.musicId = entry->musicId;
+            record.firstItem = writer.item(entry->music);
+            record.itemCount = 1;
         }
         
-        entry.accessCount = entryObj["accessCount"].toInt();
-        entry.size = entryObj["size"].toVariant().toLongLong();
-        entry.source = entryObj["source"].toString();
-        entry.isPinned = entryObj["isPinned"].toBool();
+        for (const Shard::SearchEntry* entry : std::as_const(shard->search)) {
+            SnapshotRecord& record = addRecord(*entry);
+            record.key = writer.string(entry->key);
+            record.itemCount = static_cast<quint32>(entry->results.size());
+            for (qsizetype i = 0; i < entry->results.size(); ++i) {
+                const quint32 item = writer.item(entry->results.at(i));
+                if (i == 0) {
+                    record.firstItem = item;
+                }
+            }
+        }
         
-        // Load metadata
-        QJsonObject metadataObj = entryObj["metadata"].toObject();
-        for (auto it = metadataObj.begin(); it != metadataObj.end(); ++it) {
-            entry.metadata[it.key()] = it.value().toVariant();
+        for (const Shard::MetadataEntry* entry : std::as_const(shard->metadata)) {
+            SnapshotRecord& record = addRecord(*entry);
+            record.key = writer.string(entry->key);
+            writer.blob(entry->data, record);
+        }
+    }
+    
+    // Oldest first, so that loading the records in order rebuilds the recency lists
+    std::sort(pending.begin(), pending.end(), [](const PendingRecord& a, const PendingRecord& b) {
+        return a.lruStamp < b.lruStamp;
+    });
+    
+    QList<SnapshotRecord> records;
+    records.reserve(pending.size());
+    for (const PendingRecord& entry : std::as_const(pending)) {
+        records.append(entry.record);
+    }
+    
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        ErrorHandler::logMessage(ErrorHandler::ErrorSeverity::Error, "MusicCache", QString("Failed to open snapshot for writing: %1").arg(filePath));
+        return false;
+    }
+    
+    const QByteArray data = writer.build(records);
+    if (file.write(data) != data.size() || !file.commit()) {
+        ErrorHandler::logMessage(ErrorHandler::ErrorSeverity::Error, "MusicCache", QString("Failed to write snapshot %1: %2")
+                     .arg(filePath, file.errorString()));
+        return false;
+    }
+    
+    ErrorHandler::logMessage(ErrorHandler::ErrorSeverity::Info, "MusicCache", QString("Cache snapshot saved: %1 (%2 entries, %3 KB)")
+                 .arg(filePath).arg(records.size()).arg(data.size() / 1024));
+    
+    return true;
+}
+
+bool MusicCache::loadSnapshot(const QString& filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        ErrorHandler::logMessage(ErrorHandler::ErrorSeverity::Warning, "MusicCache", QString("Failed to open snapshot for reading: %1").arg(filePath));
+        return false;
+    }
+    
+    const quint64 fileSize = static_cast<quint64>(file.size());
+    QByteArray fallback;
+    const uchar* base = fileSize > 0 ? file.map(0, file.size()) : nullptr;
+    if (!base) {
+        // Not mappable (e.g. some network filesystems), read it instead
+        fallback = file.readAll();
+        base = reinterpret_cast<const uchar*>(fallback.constData());
+    }
+    
+    auto reject = [&filePath](const QString& reason) {
+        ErrorHandler::logMessage(ErrorHandler::ErrorSeverity::Error, "MusicCache", QString("Invalid cache snapshot %1: %2").arg(filePath, reason));
+        return false;
+    };
+    
+    if (fileSize < sizeof(SnapshotHeader)) {
+        return reject("file too short");
+    }
+    
+    const SnapshotHeader header = readPod<SnapshotHeader>(base);
+    if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0) {
+        return reject("not a snapshot");
+    }
+    if (header.version != SNAPSHOT_VERSION || header.byteOrder != SNAPSHOT_BYTE_ORDER) {
+        return reject(QString("unsupported version %1").arg(header.version));
+    }
+    if (!sectionFits(header.stringIndexOffset, header.stringCount, sizeof(SnapshotString), fileSize)
+        || !sectionFits(header.stringDataOffset, header.stringDataSize, sizeof(QChar), fileSize)
+        || !sectionFits(header.itemOffset, header.itemCount, sizeof(SnapshotItem), fileSize)
+        || !sectionFits(header.recordOffset, header.recordCount, sizeof(SnapshotRecord), fileSize)
+        || !sectionFits(header.blobOffset, header.blobSize, 1, fileSize)) {
+        return reject("truncated");
+    }
+    
+    // Strings are decoded on first use and shared by every entry referencing them
+    QList<QString> strings(header.stringCount);
+    QBitArray decoded(static_cast<qsizetype>(header.stringCount));
+    bool valid = true;
+    auto stringAt = [&](quint32 id) -> QString {
+        if (id >= header.stringCount) {
+            valid = false;
+            return QString();
         }
+        if (!decoded.testBit(id)) {
+            const SnapshotString entry = readPod<SnapshotString>(base + header.stringIndexOffset + id * sizeof(SnapshotString));
+            if (entry.offset > header.stringDataSize || entry.length > header.stringDataSize - entry.offset) {
+                valid = false;
+                return QString();
+            }
+            QString string(static_cast<qsizetype>(entry.length), Qt::Uninitialized);
+            if (entry.length > 0) {
+                std::memcpy(string.data(), base + header.stringDataOffset + entry.offset * sizeof(QChar),
+                            entry.length * sizeof(QChar));
+            }
+            strings[id] = string;
+            decoded.setBit(id);
+        }
+        return strings.at(id);
+    };
+    
+    auto itemAt = [&](quint32 index) -> MusicItem {
+        MusicItem music;
+        if (index >= header.itemCount) {
+            valid = false;
+            return music;
+        }
+        const SnapshotItem item = readPod<SnapshotItem>(base + header.itemOffset + index * sizeof(SnapshotItem));
+        QString* fields[SNAPSHOT_ITEM_STRINGS] = {
+            &music.artist, &music.song, &music.genre1, &music.genre2, &music.country,
+            &music.publishedDate, &music.path, &music.time, &music.lastPlayed
+        };
+        music.id = item.id;
+        music.playedTimes = item.playedTimes;
+        for (int i = 0; i < SNAPSHOT_ITEM_STRINGS; ++i) {
+            *fields[i] = stringAt(item.strings[i]);
+        }
+        return music;
+    };
+    
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    int loadedEntries = 0;
+    
+    for (quint32 i = 0; i < header.recordCount && valid; ++i) {
+        const SnapshotRecord record = readPod<SnapshotRecord>(base + header.recordOffset + i * sizeof(SnapshotRecord));
+        
+        EntryHeader entryHeader;
+        entryHeader.createdAtMs = record.createdAtMs;
+        entryHeader.lastAccessedMs = record.lastAccessedMs;
+        entryHeader.expiresAtMs = record.expiresAtMs;
+        entryHeader.accessCount = record.accessCount;
+        entryHeader.isPinned = record.isPinned != 0;
         
         // Skip expired entries
-        if (isExpired(entry)) {
+        if (isExpired(entryHeader, now)) {
             continue;
         }
         
-        // Note: Data loading is simplified here
-        // In practice, you'd need proper deserialization for MusicItem and other types
+        const QString category = stringAt(record.category);
+        if (!valid || record.itemCount > header.itemCount
+            || record.firstItem > header.itemCount - record.itemCount) {
+            valid = false;
+            break;
+        }
+        entryHeader.kind = static_cast<EntryKind>(record.kind);
+        entryHeader.lruStamp = nextLruStamp();
+        entryHeader.category = registerCategory(category);
+        
+        EntryHeader* entry = nullptr;
+        switch (entryHeader.kind) {
+            case EntryKind::Music: {
+                auto* musicEntry = new Shard::MusicEntry;
+                static_cast<EntryHeader&>(*musicEntry) = entryHeader;
+                musicEntry->musicId = record.musicId;
+                musicEntry->music = itemAt(record.firstItem);
+                entry = musicEntry;
+                break;
+            }
+            case EntryKind::Search: {
+                auto* searchEntry = new Shard::SearchEntry;
+                static_cast<EntryHeader&>(*searchEntry) = entryHeader;
+                searchEntry->key = stringAt(record.key);
+                searchEntry->results.reserve(record.itemCount);
+                for (quint32 item = 0; item < record.itemCount; ++item) {
+                    searchEntry->results.append(itemAt(record.firstItem + item));
+                }
+                entry = searchEntry;
+                break;
+            }
+            case EntryKind::Metadata: {
+                if (record.blobOffset > header.blobSize || record.blobSize > header.blobSize - record.blobOffset) {
+                    valid = false;
+                    break;
+                }
+                auto* metadataEntry = new Shard::MetadataEntry;
+                static_cast<EntryHeader&>(*metadataEntry) = entryHeader;
+                metadataEntry->key = stringAt(record.key);
+                const QByteArray bytes = QByteArray::fromRawData(
+                    reinterpret_cast<const char*>(base + header.blobOffset + record.blobOffset),
+                    static_cast<qsizetype>(record.blobSize));
+                QDataStream stream(bytes);
+                stream.setVersion(QDataStream::Qt_6_0);
+                stream >> metadataEntry->data;
+                entry = metadataEntry;
+                break;
+            }
+            default:
+                valid = false;
+                break;
+        }
+        
+        if (!entry) {
+            break;
+        }
+        if (!valid) {
+            Shard::destroy(entry);
+            break;
+        }
         
-        m_cache[key] = entry;
-        m_statistics.currentMemoryUsage += entry.size;
+        adoptEntry(entry);
         loadedEntries++;
     }
     
-    m_statistics.currentEntries = m_cache.size();
+    if (!valid) {
+        // Entries before the damaged record stay loaded; they were valid
+        return reject(QString("corrupt record after %1 entries").arg(loadedEntries));
+    }
     
-    ErrorHandler::logMessage(ErrorHandler::ErrorSeverity::Info, "MusicCache", QString("Cache loaded from file: %1 (%2 entries loaded)")
+    ErrorHandler::logMessage(ErrorHandler::ErrorSeverity::Info, "MusicCache", QString("Cache snapshot loaded: %1 (%2 entries loaded)")
                  .arg(filePath).arg(loadedEntries));
     
     return true;
@@ -1060,7 +2035,7 @@ void MusicCache::setAutoPersistence(bool enabled, const QString& filePath)
             // Use default cache directory
             QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
             QDir().mkpath(cacheDir);
-            m_persistenceFilePath = QDir(cacheDir).filePath("music_cache.json");
+            m_persistenceFilePath = QDir(cacheDir).filePath("music_cache.snapshot");
         } else {
             m_persistenceFilePath = filePath;
         }
@@ -1079,23 +2054,72 @@ void MusicCache::performMaintenance()
     invalidateExpired();
     
     // Check memory usage and cleanup if necessary
-    if (m_statistics.currentMemoryUsage > m_maxMemoryUsage * MEMORY_CLEANUP_THRESHOLD) {
+    if (currentMemoryUsage() > maxMemoryUsage() * MEMORY_CLEANUP_THRESHOLD) {
         cleanup();
     }
     
     // Update statistics
     updateStatistics();
     
+    const CacheStatistics stats = getStatistics();
     ErrorHandler::logMessage(ErrorHandler::ErrorSeverity::Info, "MusicCache", QString("Maintenance completed: %1 entries, %2 MB used")
-                  .arg(m_statistics.currentEntries)
-                  .arg(m_statistics.currentMemoryUsage / (1024 * 1024)));
+                  .arg(stats.currentEntries)
+                  .arg(stats.currentMemoryUsage / (1024 * 1024)));
 }
 
 void MusicCache::autoPersist()
 {
     if (m_autoPersistenceEnabled && !m_persistenceFilePath.isEmpty()) {
-        saveToFile(m_persistenceFilePath);
+        saveSnapshot(m_persistenceFilePath);
+    }
+}
+
+MusicCache::Shard& MusicCache::musicShard(int musicId) const
+{
+    return *m_shards[static_cast<quint32>(musicId) % SHARD_COUNT];
+}
+
+MusicCache::Shard& MusicCache::keyShard(const QString& key) const
+{
+    return *m_shards[qHash(key) % SHARD_COUNT];
+}
+
+MusicCache::Category* MusicCache::findCategory(const QString& category) const
+{
+    QReadLocker locker(&m_categoryLock);
+    return m_categoriesByName.value(category, nullptr);
+}
+
+MusicCache::Category* MusicCache::registerCategory(const QString& category)
+{
+    if (Category* existing = findCategory(category)) {
+        return existing;
+    }
+    
+    QWriteLocker locker(&m_categoryLock);
+    if (Category* existing = m_categoriesByName.value(category, nullptr)) {
+        return existing; // Registered by another thread in the meantime
     }
+    
+    auto* registered = new Category;
+    registered->id = m_categories.size();
+    registered->name = category;
+    m_categories.append(registered);
+    m_categoriesByName.insert(category, registered);
+    return registered;
+}
+
+QString MusicCache::cacheKey(const EntryHeader& entry)
+{
+    switch (entry.kind) {
+        case EntryKind::Music:
+            return generateMusicKey(static_cast<const Shard::MusicEntry&>(entry).musicId, entry.category->name);
+        case EntryKind::Search:
+            return generateSearchKey(static_cast<const Shard::SearchEntry&>(entry).key);
+        case EntryKind::Metadata:
+            return generateMetadataKey(static_cast<const Shard::MetadataEntry&>(entry).key, entry.category->name);
+    }
+    return QString();
 }
 
 QString MusicCache::generateMusicKey(int musicId, const QString& category)
@@ -1116,91 +2140,292 @@ QString MusicCache::generateMetadataKey(const QString& key, const QString& categ
     return QString("meta:%1:%2").arg(category).arg(key);
 }
 
-qint64 MusicCache::calculateDataSize(const QVariant& data)
+qint64 MusicCache::entrySize(const EntryHeader& entry)
 {
-    // Simplified size calculation
-    // In practice, you'd need more accurate size calculation for complex types
-    
-    QBuffer buffer;
-    buffer.open(QIODevice::WriteOnly);
-    QDataStream stream(&buffer);
-    stream << data;
-    
-    return buffer.size();
+    // Every hash slot holds the key and a pointer to the entry node
+    constexpr qint64 slotSize = sizeof(void*);
+    
+    switch (entry.kind) {
+        case EntryKind::Music: {
+            const auto& music = static_cast<const Shard::MusicEntry&>(entry);
+            return qint64(sizeof(Shard::MusicEntry)) + qint64(sizeof(quint64)) + slotSize
+                 + heapSize(music.music);
+        }
+        case EntryKind::Search: {
+            // The hash key shares its data with the entry's copy; each result
+            // also has a node in the shard's music ID index
+            const auto& search = static_cast<const Shard::SearchEntry&>(entry);
+            return qint64(sizeof(Shard::SearchEntry)) + qint64(sizeof(QString)) + slotSize
+                 + heapSize(search.key) + heapSize(search.results)
+                 + search.results.size() * qint64(sizeof(int) + 2 * sizeof(void*));
+        }
+        case EntryKind::Metadata: {
+            const auto& metadata = static_cast<const Shard::MetadataEntry&>(entry);
+            return qint64(sizeof(Shard::MetadataEntry)) + qint64(sizeof(QPair<int, QString>)) + slotSize
+                 + heapSize(metadata.key) + heapSize(metadata.data);
+        }
+    }
+    return 0;
+}
+
+void MusicCache::initHeader(EntryHeader& header, qint64 size, int expirationSeconds)
+{
+    header.createdAtMs = QDateTime::currentMSecsSinceEpoch();
+    header.lastAccessedMs = header.createdAtMs;
+    header.expiresAtMs = expirationSeconds > 0 ? header.createdAtMs + qint64(expirationSeconds) * 1000 : 0;
+    header.size = size;
+    header.lruStamp = nextLruStamp();
+}
+
+quint64 MusicCache::nextLruStamp()
+{
+    return m_lruClock.fetch_add(1, std::memory_order_relaxed) + 1;
 }
 
-bool MusicCache::isExpired(const CacheEntry& entry)
+bool MusicCache::isExpired(const EntryHeader& header, qint64 nowMs) const
 {
-    if (!entry.expiresAt.isValid()) {
+    if (header.expiresAtMs <= 0) {
         return false; // No expiration set
     }
     
-    QDateTime now = QDateTime::currentDateTime();
+    const qint64 idleMs = nowMs - header.lastAccessedMs;
+    const qint64 expirationMs = qint64(m_defaultExpirationTime) * 1000;
     
     switch (m_invalidationStrategy) {
         case TimeBasedExpiration:
-            return now > entry.expiresAt;
+            return nowMs > header.expiresAtMs;
             
         case AccessBasedExpiration:
             // Expire if not accessed for expiration time
-            return entry.lastAccessed.secsTo(now) > m_defaultExpirationTime;
+            return idleMs > expirationMs;
             
         case VersionBasedExpiration:
             // Would need version tracking - simplified here
-            return now > entry.expiresAt;
+            return nowMs > header.expiresAtMs;
             
         case ManualInvalidation:
             return false; // Never expire automatically
             
         case SmartInvalidation:
             // Combination of time-based and access-based
-            return (now > entry.expiresAt) || 
-                   (entry.lastAccessed.secsTo(now) > m_defaultExpirationTime * 2);
+            return (nowMs > header.expiresAtMs) || (idleMs > expirationMs * 2);
     }
     
     return false;
 }
 
-int MusicCache::evictLRU(qint64 targetSize)
+void MusicCache::makeRoom(qint64 size)
+{
+    const qint64 maxUsage = m_maxMemoryUsage;
+    if (m_memoryUsage + size > maxUsage) {
+        cleanup(static_cast<qint64>(maxUsage * MEMORY_CLEANUP_TARGET));
+    }
+}
+
+void MusicCache::adoptEntry(EntryHeader* entry)
 {
-    // Create list of entries sorted by last access time (oldest first)
-    QList<QPair<QString, QDateTime>> entries;
+    if (entry->kind == EntryKind::Search) {
+        entry->category = m_searchCategory;
+    }
+    
+    // Sizes are recomputed rather than trusted from the file
+    entry->size = entrySize(*entry);
+    
+    // Once stored the entry may be evicted by another thread at any time
+    Category* category = entry->category;
+    const qint64 size = entry->size;
+    qint64 oldSize = -1;
+    switch (entry->kind) {
+        case EntryKind::Music: {
+            auto* musicEntry = static_cast<Shard::MusicEntry*>(entry);
+            Shard& shard = musicShard(musicEntry->musicId);
+            QMutexLocker locker(&shard.mutex);
+            oldSize = shard.insert(shard.music, musicKey(entry->category->id, musicEntry->musicId), musicEntry);
+            break;
+        }
+        case EntryKind::Search: {
+            auto* searchEntry = static_cast<Shard::SearchEntry*>(entry);
+            Shard& shard = keyShard(searchEntry->key);
+            QMutexLocker locker(&shard.mutex);
+            oldSize = shard.insert(shard.search, searchEntry->key, searchEntry);
+            break;
+        }
+        case EntryKind::Metadata: {
+            auto* metadataEntry = static_cast<Shard::MetadataEntry*>(entry);
+            Shard& shard = keyShard(metadataEntry->key);
+            QMutexLocker locker(&shard.mutex);
+            oldSize = shard.insert(shard.metadata, qMakePair(entry->category->id, metadataEntry->key), metadataEntry);
+            break;
+        }
+    }
     
-    for (auto it = m_cache.begin(); it != m_cache.end(); ++it) {
-        const CacheEntry& entry = it.value();
-        
-        // Don't evict pinned entries
-        if (entry.isPinned) {
-            continue;
+    recordUsage(category, size - std::max<qint64>(oldSize, 0), oldSize >= 0 ? 0 : 1);
+}
+
+void MusicCache::recordAccess(Category* category, bool hit)
+{
+    if (hit) {
+        m_totalHits.fetch_add(1, std::memory_order_relaxed);
+        category->hits.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        m_totalMisses.fetch_add(1, std::memory_order_relaxed);
+        category->misses.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void MusicCache::recordUsage(Category* category, qint64 sizeDelta, int entryDelta)
+{
+    m_memoryUsage.fetch_add(sizeDelta, std::memory_order_relaxed);
+    m_entryCount.fetch_add(entryDelta, std::memory_order_relaxed);
+    category->size.fetch_add(sizeDelta, std::memory_order_relaxed);
+}
+
+bool MusicCache::setPinned(const QString& key, const QString& category, bool pinned)
+{
+    Category* cat = findCategory(category);
+    if (!cat) {
+        return false;
+    }
+    
+    auto apply = [this, pinned](Shard& shard, EntryHeader* entry) {
+        if (!entry) {
+            return false;
+        }
+        if (entry->isPinned != pinned) {
+            entry->isPinned = pinned;
+            // Pinned entries leave the recency list; unpinning counts as a use
+            if (pinned) {
+                shard.unlink(entry);
+            } else {
+                entry->lruStamp = nextLruStamp();
+                shard.link(entry);
+            }
+        }
+        return true;
+    };
+    
+    if (category == "music") {
+        const int musicId = key.toInt();
+        Shard& shard = musicShard(musicId);
+        QMutexLocker locker(&shard.mutex);
+        return apply(shard, shard.music.value(musicKey(cat->id, musicId)));
+    }
+    
+    Shard& shard = keyShard(key);
+    QMutexLocker locker(&shard.mutex);
+    
+    if (cat == m_searchCategory) {
+        return apply(shard, shard.search.value(key));
+    }
+    return apply(shard, shard.metadata.value(qMakePair(cat->id, key)));
+}
+
+template <typename Predicate>
+int MusicCache::removeWhere(Predicate predicate, const QString& reason, qint64& memoryFreed)
+{
+    struct Removed {
+        QString key;
+        QString category;
+    };
+    
+    const bool reportEvictions = !reason.isEmpty() && isSignalConnected(evictedSignal());
+    QList<Removed> reported;
+    QHash<Category*, qint64> freedByCategory;
+    QList<EntryHeader*> victims;
+    int removed = 0;
+    memoryFreed = 0;
+    
+    auto collect = [&predicate, &victims](const auto& hash) {
+        for (EntryHeader* entry : hash) {
+            if (predicate(*entry)) {
+                victims.append(entry);
+            }
         }
+    };
+    
+    for (auto& shard : m_shards) {
+        QMutexLocker locker(&shard->mutex);
         
-        entries.append(qMakePair(it.key(), entry.lastAccessed));
+        victims.clear();
+        collect(shard->music);
+        collect(shard->search);
+        collect(shard->metadata);
+        
+        for (EntryHeader* entry : std::as_const(victims)) {
+            freedByCategory[entry->category] += entry->size;
+            if (reportEvictions) {
+                reported.append(Removed{cacheKey(*entry), entry->category->name});
+            }
+            shard->erase(entry);
+        }
+        removed += static_cast<int>(victims.size());
+    }
+    
+    if (removed == 0) {
+        return 0;
     }
     
-    // Sort by last accessed time (oldest first)
-    std::sort(entries.begin(), entries.end(), 
-              [](const QPair<QString, QDateTime>& a, const QPair<QString, QDateTime>& b) {
-                  return a.second < b.second;
-              });
+    for (auto it = freedByCategory.constBegin(); it != freedByCategory.constEnd(); ++it) {
+        recordUsage(it.key(), -it.value(), 0);
+        memoryFreed += it.value();
+    }
+    m_entryCount -= removed;
+    
+    for (const Removed& entry : std::as_const(reported)) {
+        emit entryEvicted(entry.key, entry.category, reason);
+    }
     
+    return removed;
+}
+
+int MusicCache::evictLRU(qint64 targetSize)
+{
+    const bool reportEvictions = isSignalConnected(evictedSignal());
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
     int evicted = 0;
     
     // Evict oldest entries until we reach target size
-    for (const auto& pair : entries) {
-        if (m_statistics.currentMemoryUsage <= targetSize) {
-            break;
+    while (m_memoryUsage > targetSize) {
+        // The oldest entry of the cache is the oldest of the shards' tails
+        Shard* oldest = nullptr;
+        quint64 oldestStamp = 0;
+        for (auto& shard : m_shards) {
+            QMutexLocker locker(&shard->mutex);
+            if (shard->lruTail && (!oldest || shard->lruTail->lruStamp < oldestStamp)) {
+                oldest = shard.get();
+                oldestStamp = shard->lruTail->lruStamp;
+            }
         }
         
-        const QString& key = pair.first;
-        if (m_cache.contains(key)) {
-            const CacheEntry& entry = m_cache[key];
-            QString category = entry.metadata.value("category", "unknown").toString();
-            
-            m_statistics.currentMemoryUsage -= entry.size;
-            m_cache.remove(key);
-            evicted++;
+        if (!oldest) {
+            break; // Only pinned entries are left
+        }
+        
+        QString key;
+        Category* category = nullptr;
+        qint64 size = 0;
+        bool expired = false;
+        {
+            QMutexLocker locker(&oldest->mutex);
+            EntryHeader* victim = oldest->lruTail;
+            if (!victim) {
+                continue; // Emptied since the scan
+            }
             
-            emit entryEvicted(key, category, "LRU");
+            category = victim->category;
+            size = victim->size;
+            expired = isExpired(*victim, now);
+            if (reportEvictions) {
+                key = cacheKey(*victim);
+            }
+            oldest->erase(victim);
+        }
+        
+        recordUsage(category, -size, -1);
+        evicted++;
+        
+        if (reportEvictions) {
+            emit entryEvicted(key, category->name, expired ? "expired" : "LRU");
         }
     }
     
@@ -1209,13 +2434,8 @@ int MusicCache::evictLRU(qint64 targetSize)
 
 void MusicCache::updateStatistics()
 {
-    QMutexLocker locker(&m_statsMutex);
-    
-    // Update current entries count
-    m_statistics.currentEntries = m_cache.size();
-    
     // Emit statistics update
-    emit statisticsUpdated(m_statistics);
+    emit statisticsUpdated(getStatistics());
 }
 
 void MusicCache::logCacheOperation(const QString& operation, const QString& key, bool success, const QString& details)
@@ -1231,7 +2451,3 @@ void MusicCache::logCacheOperation(const QString& operation, const QString& key,
     
     ErrorHandler::logMessage(ErrorHandler::ErrorSeverity::Info, "MusicCache", message);
 }
-
-// Register MusicItem with Qt's meta-type system for QVariant storage
-Q_DECLARE_METATYPE(MusicItem)
-Q_DECLARE_METATYPE(QList<MusicItem>)
\ No newline at end of file
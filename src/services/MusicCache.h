@@ -3,17 +3,26 @@
 
 #include <QObject>
 #include <QCache>
+#include <QFutureWatcher>
 #include <QHash>
 #include <QMutex>
+#include <QPointer>
+#include <QReadWriteLock>
+#include <QStringList>
 #include <QTimer>
 #include <QDateTime>
 #include <QVariant>
 #include <QJsonObject>
 #include <QJsonDocument>
+#include <array>
+#include <atomic>
 #include <memory>
 
 // Forward declarations
 struct MusicItem;
+class MusicRepository;
+class HourGenreSchedule;
+class SchedulerEngine;
 
 /**
  * @brief Intelligent caching system for music metadata
@@ -25,12 +34,13 @@ struct MusicItem;
  * accessed music data.
  * 
  * Features:
- * - LRU (Least Recently Used) cache eviction
+ * - LRU (Least Recently Used) cache eviction in constant time
  * - Intelligent cache invalidation strategies
  * - Memory usage monitoring and limits
  * - Cache hit/miss statistics
  * - Automatic cache warming for popular items
- * - Thread-safe operations
+ * - Thread-safe operations, with entries spread over independently locked
+ *   shards so lookups from different threads rarely contend
  * - Cache persistence across application restarts
  * - Smart prefetching based on access patterns
  * 
@@ -55,6 +65,18 @@ struct MusicItem;
  * cache->putSearchResults("genre:rock", results);
  * @endcode
  * 
+ * Entries are stored by type rather than boxed in a QVariant: music items
+ * are keyed by an integer built from the music ID and an interned category
+ * ID, search results by their search key and metadata by category and key.
+ * Cache keys in string form ("music:<category>:<id>" and so on) are only
+ * built for signals that have receivers and for getKeys().
+ *
+ * warmupCache() loads tracks from the attached repository in a background
+ * thread. With PredictiveWarmup it takes the most played tracks of the
+ * genres programmed for the next WARMUP_HORIZON_HOURS hours, then the most
+ * played tracks overall. When a SchedulerEngine is attached, a warmup also
+ * runs WARMUP_LEAD_SECS before each scheduled program.
+ *
  * @since XFB 2.0
  */
 class MusicCache : public QObject
@@ -113,12 +135,21 @@ public:
      */
     enum WarmupStrategy {
         NoWarmup,              // No automatic warmup
-        PopularItemsWarmup,    // Warm up most popular items
-        RecentItemsWarmup,     // Warm up recently accessed items
-        PredictiveWarmup,      // Predictive warmup based on patterns
+        PopularItemsWarmup,    // Warm up most played items
+        RecentItemsWarmup,     // Warm up recently played items
+        PredictiveWarmup,      // Warm up the genres programmed for the coming hours
         FullWarmup             // Warm up entire dataset (use carefully)
     };
 
+    /// Hours of programmed genres loaded by PredictiveWarmup
+    static constexpr int WARMUP_HORIZON_HOURS = 3;
+    /// A scheduled warmup starts this long before a program
+    static constexpr int WARMUP_LEAD_SECS = 15 * 60;
+    /// Most played tracks loaded per upcoming genre
+    static constexpr int WARMUP_TRACKS_PER_GENRE = 200;
+    /// Most played tracks loaded regardless of genre
+    static constexpr int WARMUP_TOP_PLAYED = 500;
+
     explicit MusicCache(QObject* parent = nullptr);
     ~MusicCache() override;
 
@@ -302,6 +333,35 @@ public:
      */
     void invalidateExpired();
 
+    /**
+     * @brief Drop everything derived from one music item
+     *
+     * Removes the item from every category it is cached under and every
+     * cached search result containing it. Each search keeps an index of the
+     * IDs it holds, so this does not scan the cache. Removed entries are
+     * reported through entryEvicted() with the reason "invalidated".
+     * @param musicId Music item ID
+     * @return Number of entries removed
+     */
+    int invalidateMusic(int musicId);
+
+    /**
+     * @brief Drop all cached search results
+     * @return Number of entries removed
+     */
+    int invalidateSearchResults();
+
+    /**
+     * @brief Keep the cache consistent with a repository's writes
+     *
+     * Updates, deletions and play count changes invalidate the affected
+     * item through invalidateMusic(). A newly added item may match any
+     * cached search, so additions drop all search results. Connections are
+     * direct, so entries are gone before the repository call returns.
+     * @param repository Repository to follow, or nullptr to detach
+     */
+    void attachRepository(MusicRepository* repository);
+
     /**
      * @brief Force cleanup of cache to free memory
      * @param targetMemoryUsage Target memory usage after cleanup
@@ -309,10 +369,38 @@ public:
     void cleanup(qint64 targetMemoryUsage = -1);
 
     /**
-     * @brief Warm up cache with popular/recent items
+     * @brief Attach the hour genre schedule used by PredictiveWarmup
+     * @param schedule Schedule, or nullptr to warm up by play count only
+     */
+    void setHourGenreSchedule(HourGenreSchedule* schedule);
+
+    /**
+     * @brief Attach the scheduler whose programs trigger a warmup
+     *
+     * A warmup is started WARMUP_LEAD_SECS before the next program that
+     * fires within a day, and rescheduled after every warmup.
+     * @param scheduler Scheduler, or nullptr to warm up only on request
+     */
+    void setSchedulerEngine(SchedulerEngine* scheduler);
+
+    /**
+     * @brief Load likely tracks from the attached repository
+     *
+     * The genres for PredictiveWarmup are looked up on the calling thread;
+     * the repository queries and insertions run in a background thread and
+     * stop once the cache holds MEMORY_CLEANUP_TARGET of its memory limit,
+     * so warming never evicts entries that are in use. warmupCompleted() is
+     * emitted when the load finishes, right away if no repository is
+     * attached. A call made while a warmup is running is ignored.
      */
     void warmupCache();
 
+    /**
+     * @brief Check if a warmup is loading in the background
+     * @return true until warmupCompleted() is emitted
+     */
+    bool isWarmupRunning() const;
+
     /**
      * @brief Pin an entry to prevent eviction
      * @param key Cache key
@@ -355,7 +443,9 @@ public:
     QString exportStatistics();
 
     /**
-     * @brief Save cache to persistent storage
+     * @brief Save cache to persistent storage as JSON
+     *
+     * Readable but slow to load; automatic persistence uses saveSnapshot().
      * @param filePath Path to save cache data
      * @return true if successful
      */
@@ -368,8 +458,34 @@ public:
      */
     bool loadFromFile(const QString& filePath);
 
+    /**
+     * @brief Save the cache as a binary snapshot
+     *
+     * A snapshot holds a deduplicated string table followed by fixed-size
+     * records, written oldest entry first so loading restores the recency
+     * order. It is written through QSaveFile, so a crash mid-save leaves the
+     * previous snapshot intact. Snapshots are native-endian and only meant
+     * to be read back on the machine that wrote them.
+     * @param filePath Path to save the snapshot to
+     * @return true if successful
+     */
+    bool saveSnapshot(const QString& filePath);
+
+    /**
+     * @brief Load a binary snapshot written by saveSnapshot()
+     *
+     * The file is memory-mapped and its records are read in place; each
+     * string of the table is decoded on first reference and shared by every
+     * entry using it. Expired entries are skipped.
+     * @param filePath Path of the snapshot
+     * @return true if the snapshot was valid and loaded
+     */
+    bool loadSnapshot(const QString& filePath);
+
     /**
      * @brief Enable/disable automatic cache persistence
+     *
+     * Automatic saves use the binary snapshot format.
      * @param enabled true to enable automatic persistence
      * @param filePath Path for automatic saves
      */
@@ -436,6 +552,57 @@ private slots:
     void autoPersist();
 
 private:
+    struct Category;
+    struct EntryHeader;
+    struct Shard;
+
+    /// Number of independently locked shards; a power of two
+    static constexpr int SHARD_COUNT = 16;
+
+    /**
+     * @brief Kind of value an entry holds
+     */
+    enum class EntryKind {
+        Music,
+        Search,
+        Metadata
+    };
+
+    /**
+     * @brief Get the shard holding a music item
+     * @param musicId Music item ID
+     * @return Shard
+     */
+    Shard& musicShard(int musicId) const;
+
+    /**
+     * @brief Get the shard holding a search result or metadata entry
+     * @param key Search or metadata key
+     * @return Shard
+     */
+    Shard& keyShard(const QString& key) const;
+
+    /**
+     * @brief Look up an interned category
+     * @param category Category name
+     * @return Category, or nullptr if nothing was ever stored under it
+     */
+    Category* findCategory(const QString& category) const;
+
+    /**
+     * @brief Intern a category, registering it on first use
+     * @param category Category name
+     * @return Category
+     */
+    Category* registerCategory(const QString& category);
+
+    /**
+     * @brief Build the cache key of an entry in string form
+     * @param entry Entry; the caller holds its shard's lock
+     * @return Cache key
+     */
+    QString cacheKey(const EntryHeader& entry);
+
     /**
      * @brief Generate cache key for music item
      * @param musicId Music item ID
@@ -460,21 +627,120 @@ private:
     QString generateMetadataKey(const QString& key, const QString& category);
 
     /**
-     * @brief Calculate size of data in bytes
-     * @param data Data to calculate size for
+     * @brief Calculate the memory held by an entry
+     *
+     * Counts the entry node, its hash slot and the heap blocks behind its
+     * strings and lists by allocated capacity. Implicitly shared blocks are
+     * charged in full to every entry that references them, so the total is
+     * an upper bound on what dropping the entries frees.
+     * @param entry Entry with its value filled in
      * @return Size in bytes
      */
-    qint64 calculateDataSize(const QVariant& data);
+    static qint64 entrySize(const EntryHeader& entry);
+
+    /**
+     * @brief Fill in the bookkeeping of a new entry
+     * @param header Header to fill in
+     * @param size Size of the entry in bytes
+     * @param expirationSeconds Lifetime in seconds, or 0 for no expiration
+     */
+    void initHeader(EntryHeader& header, qint64 size, int expirationSeconds);
+
+    /**
+     * @brief Get the next value of the recency clock
+     *
+     * Entries are ordered by this clock rather than by access time, which
+     * is too coarse to order accesses made within the same millisecond.
+     * @return Stamp newer than every stamp handed out before
+     */
+    quint64 nextLruStamp();
 
     /**
      * @brief Check if entry has expired
-     * @param entry Cache entry to check
+     * @param header Bookkeeping of the entry to check
+     * @param nowMs Current time in milliseconds since the epoch
      * @return true if expired
      */
-    bool isExpired(const CacheEntry& entry);
+    bool isExpired(const EntryHeader& header, qint64 nowMs) const;
+
+    /**
+     * @brief Free memory before an entry of the given size is stored
+     * @param size Size of the entry about to be stored
+     */
+    void makeRoom(qint64 size);
+
+    /**
+     * @brief Store an entry read from a cache file, replacing any entry with the same key
+     * @param entry Heap-allocated entry with its value and bookkeeping filled in
+     */
+    void adoptEntry(EntryHeader* entry);
+
+    /**
+     * @brief Get the genres programmed for the hours ahead
+     * @param from Start of the warmup horizon
+     * @return Distinct genres in hour order
+     */
+    QStringList upcomingGenres(const QDateTime& from) const;
+
+    /**
+     * @brief Load warmup tracks into the cache; runs in a worker thread
+     * @param repository Repository to read from
+     * @param strategy Warmup strategy
+     * @param genres Genres to warm up first, for PredictiveWarmup
+     * @return Number of items stored
+     */
+    int loadWarmupItems(MusicRepository* repository, WarmupStrategy strategy, const QStringList& genres);
+
+    /**
+     * @brief Record a finished warmup and schedule the next one
+     * @param entriesWarmed Number of items stored
+     */
+    void finishWarmup(int entriesWarmed);
+
+    /**
+     * @brief Arm the warmup timer for the next scheduled program
+     */
+    void scheduleNextWarmup();
+
+    /**
+     * @brief Record a lookup in the hit/miss statistics
+     * @param category Category looked up
+     * @param hit true for a hit
+     */
+    void recordAccess(Category* category, bool hit);
+
+    /**
+     * @brief Record entries added to or removed from a category
+     * @param category Category
+     * @param sizeDelta Change in memory usage
+     * @param entryDelta Change in the number of entries
+     */
+    void recordUsage(Category* category, qint64 sizeDelta, int entryDelta);
+
+    /**
+     * @brief Pin or unpin an entry
+     * @param key Music ID, search key or metadata key
+     * @param category Category
+     * @param pinned true to pin
+     * @return true if the entry exists
+     */
+    bool setPinned(const QString& key, const QString& category, bool pinned);
+
+    /**
+     * @brief Remove entries matching a predicate from every shard
+     * @param predicate Called with the bookkeeping of each entry
+     * @param reason Eviction reason reported through entryEvicted(), or empty for none
+     * @param memoryFreed Receives the memory freed
+     * @return Number of entries removed
+     */
+    template <typename Predicate>
+    int removeWhere(Predicate predicate, const QString& reason, qint64& memoryFreed);
 
     /**
      * @brief Evict least recently used entries
+     *
+     * Each shard keeps its unpinned entries in recency order, so every
+     * eviction only compares the shards' oldest entries and unlinks one.
      * @param targetSize Target cache size after eviction
      * @return Number of entries evicted
      */
@@ -495,22 +761,41 @@ private:
     void logCacheOperation(const QString& operation, const QString& key, bool success, const QString& details = QString());
 
     // Cache storage
-    mutable QMutex m_cacheMutex;
-    QHash<QString, CacheEntry> m_cache;
+    std::array<std::unique_ptr<Shard>, SHARD_COUNT> m_shards;
+    
+    // Interned categories; IDs index m_categories
+    mutable QReadWriteLock m_categoryLock;
+    QHash<QString, Category*> m_categoriesByName;
+    QList<Category*> m_categories;
+    Category* m_searchCategory;
     
     // Configuration
-    qint64 m_maxMemoryUsage;
+    std::atomic<qint64> m_maxMemoryUsage;
     int m_defaultExpirationTime;
     InvalidationStrategy m_invalidationStrategy;
     WarmupStrategy m_warmupStrategy;
     
-    // Statistics
-    mutable QMutex m_statsMutex;
-    CacheStatistics m_statistics;
+    // Statistics; counters are atomic so lookups never wait on m_statsMutex
+    std::atomic<qint64> m_totalHits{0};
+    std::atomic<qint64> m_totalMisses{0};
+    std::atomic<qint64> m_totalEvictions{0};
+    std::atomic<qint64> m_entryCount{0};
+    std::atomic<qint64> m_memoryUsage{0};
+    std::atomic<quint64> m_lruClock{0};
+    mutable QMutex m_statsMutex; // Guards m_lastCleanup and m_lastWarmup
+    QDateTime m_lastCleanup;
+    QDateTime m_lastWarmup;
+    
+    // Source of write-through invalidation and warmup data
+    QPointer<MusicRepository> m_repository;
+    QPointer<HourGenreSchedule> m_hourGenres;
+    QPointer<SchedulerEngine> m_scheduler;
+    QFutureWatcher<int>* m_warmupWatcher;
     
     // Maintenance
     QTimer* m_maintenanceTimer;
     QTimer* m_persistenceTimer;
+    QTimer* m_warmupTimer;
     bool m_autoPersistenceEnabled;
     QString m_persistenceFilePath;
     
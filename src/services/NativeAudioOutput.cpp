@@ -0,0 +1,228 @@
+#include "NativeAudioOutput.h"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+
+#ifdef XFB_HAVE_ALSA
+#include <alsa/asoundlib.h>
+#endif
+
+#ifdef Q_OS_UNIX
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+bool NativeAudioOutput::isAvailable()
+{
+#ifdef XFB_HAVE_ALSA
+    return true;
+#else
+    return false;
+#endif
+}
+
+NativeAudioOutput::Config NativeAudioOutput::normalized(Config config)
+{
+    config.device = config.device.trimmed();
+    if (config.device.isEmpty()) {
+        config.device = "default";
+    }
+    if (config.sampleRate <= 0) {
+        config.sampleRate = 48000;
+    }
+    config.periodFrames = std::clamp(config.periodFrames, MIN_PERIOD_FRAMES, MAX_PERIOD_FRAMES);
+    config.periods = std::clamp(config.periods, 2, MAX_PERIODS);
+    return config;
+}
+
+bool NativeAudioOutput::raiseThreadPriority(int priority)
+{
+#ifdef Q_OS_UNIX
+    sched_param param{};
+    param.sched_priority = std::clamp(priority, sched_get_priority_min(SCHED_FIFO),
+                                      sched_get_priority_max(SCHED_FIFO));
+    return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+#else
+    Q_UNUSED(priority)
+    return false;
+#endif
+}
+
+void NativeAudioOutput::toInt16(const float* in, qint16* out, int samples)
+{
+    for (int i = 0; i < samples; ++i) {
+        const float value = std::clamp(in[i], -1.0f, 1.0f);
+        out[i] = static_cast<qint16>(std::lround(value * 32767.0f));
+    }
+}
+
+NativeAudioOutput::~NativeAudioOutput()
+{
+    close();
+}
+
+bool NativeAudioOutput::open(const Config& config)
+{
+    close();
+    m_error.clear();
+    const Config wanted = normalized(config);
+
+#ifdef XFB_HAVE_ALSA
+    snd_pcm_t* pcm = nullptr;
+    int error = snd_pcm_open(&pcm, wanted.device.toUtf8().constData(), SND_PCM_STREAM_PLAYBACK, 0);
+    if (error < 0) {
+        m_error = QString("Cannot open %1: %2").arg(wanted.device, snd_strerror(error));
+        return false;
+    }
+    const auto fail = [&](const QString& what) {
+        m_error = QString("%1 on %2: %3").arg(what, wanted.device, snd_strerror(error));
+        snd_pcm_close(pcm);
+        return false;
+    };
+
+    snd_pcm_hw_params_t* hardware = nullptr;
+    snd_pcm_hw_params_alloca(&hardware);
+    snd_pcm_hw_params_any(pcm, hardware);
+    if ((error = snd_pcm_hw_params_set_access(pcm, hardware, SND_PCM_ACCESS_RW_INTERLEAVED)) < 0) {
+        return fail("Cannot write interleaved frames");
+    }
+    m_int16 = snd_pcm_hw_params_set_format(pcm, hardware, SND_PCM_FORMAT_FLOAT_LE) < 0;
+    if (m_int16) {
+        if ((error = snd_pcm_hw_params_set_format(pcm, hardware, SND_PCM_FORMAT_S16_LE)) < 0) {
+            return fail("Cannot play float or 16 bit samples");
+        }
+    }
+    if ((error = snd_pcm_hw_params_set_channels(pcm, hardware, CHANNELS)) < 0) {
+        return fail("Cannot play stereo");
+    }
+    // The decks run at the mixer's rate; a plug device converts if the card cannot
+    if ((error = snd_pcm_hw_params_set_rate(pcm, hardware, unsigned(wanted.sampleRate), 0)) < 0) {
+        return fail(QString("Cannot play %1 Hz").arg(wanted.sampleRate));
+    }
+    snd_pcm_uframes_t periodFrames = snd_pcm_uframes_t(wanted.periodFrames);
+    unsigned periods = unsigned(wanted.periods);
+    if ((error = snd_pcm_hw_params_set_period_size_near(pcm, hardware, &periodFrames, nullptr))
+            < 0
+        || (error = snd_pcm_hw_params_set_periods_near(pcm, hardware, &periods, nullptr)) < 0) {
+        return fail(QString("Cannot use periods of %1 frames").arg(wanted.periodFrames));
+    }
+    if ((error = snd_pcm_hw_params(pcm, hardware)) < 0) {
+        return fail("Cannot set up the device");
+    }
+    snd_pcm_hw_params_get_period_size(hardware, &periodFrames, nullptr);
+    snd_pcm_hw_params_get_periods(hardware, &periods, nullptr);
+
+    // Playing starts with the first period and goes on as each one has room
+    snd_pcm_sw_params_t* software = nullptr;
+    snd_pcm_sw_params_alloca(&software);
+    snd_pcm_sw_params_current(pcm, software);
+    snd_pcm_sw_params_set_start_threshold(pcm, software, periodFrames);
+    snd_pcm_sw_params_set_avail_min(pcm, software, periodFrames);
+    if ((error = snd_pcm_sw_params(pcm, software)) < 0) {
+        return fail("Cannot set the start threshold");
+    }
+
+    m_pcm = pcm;
+    m_sampleRate = wanted.sampleRate;
+    m_periodFrames = int(periodFrames);
+    m_periods = int(periods);
+    m_buffer.assign(size_t(m_periodFrames) * CHANNELS, 0.0f);
+    m_converted.assign(m_int16 ? m_buffer.size() : 0, 0);
+    return true;
+#else
+    m_error = "XFB was built without ALSA";
+    return false;
+#endif
+}
+
+void NativeAudioOutput::close()
+{
+#ifdef XFB_HAVE_ALSA
+    if (m_pcm) {
+        snd_pcm_t* pcm = static_cast<snd_pcm_t*>(m_pcm);
+        snd_pcm_drop(pcm);
+        snd_pcm_close(pcm);
+    }
+#endif
+    m_pcm = nullptr;
+}
+
+bool NativeAudioOutput::writePeriod(const Render& render)
+{
+    if (!m_pcm) {
+        return false;
+    }
+    render(m_buffer.data(), m_periodFrames);
+    if (m_int16) {
+        toInt16(m_buffer.data(), m_converted.data(), int(m_buffer.size()));
+    }
+
+#ifdef XFB_HAVE_ALSA
+    snd_pcm_t* pcm = static_cast<snd_pcm_t*>(m_pcm);
+    int done = 0;
+    while (done < m_periodFrames) {
+        const size_t offset = size_t(done) * CHANNELS;
+        const snd_pcm_uframes_t left = snd_pcm_uframes_t(m_periodFrames - done);
+        const snd_pcm_sframes_t written =
+            m_int16 ? snd_pcm_writei(pcm, m_converted.data() + offset, left)
+                    : snd_pcm_writei(pcm, m_buffer.data() + offset, left);
+        if (written == -EAGAIN) {
+            continue;
+        }
+        if (written < 0) {
+            if (!recover(int(written))) {
+                return false;
+            }
+            continue;
+        }
+        done += int(written);
+    }
+#endif
+    ++m_periodsWritten;
+    return true;
+}
+
+void NativeAudioOutput::drop()
+{
+#ifdef XFB_HAVE_ALSA
+    if (m_pcm) {
+        snd_pcm_t* pcm = static_cast<snd_pcm_t*>(m_pcm);
+        snd_pcm_drop(pcm);
+        snd_pcm_prepare(pcm);
+    }
+#endif
+}
+
+NativeAudioOutput::Statistics NativeAudioOutput::statistics() const
+{
+    Statistics statistics;
+    statistics.xruns = m_xruns;
+    statistics.periodsWritten = m_periodsWritten;
+    statistics.periodFrames = m_periodFrames;
+    statistics.periods = m_periods;
+    statistics.sampleRate = m_sampleRate;
+    if (m_sampleRate > 0) {
+        statistics.latencyMs = double(m_periodFrames) * m_periods * 1000.0 / m_sampleRate;
+    }
+    return statistics;
+}
+
+bool NativeAudioOutput::recover(int error)
+{
+#ifdef XFB_HAVE_ALSA
+    // An underrun, or the system suspending the card
+    if (error == -EPIPE || error == -ESTRPIPE) {
+        ++m_xruns;
+    }
+    const int recovered = snd_pcm_recover(static_cast<snd_pcm_t*>(m_pcm), error, 1);
+    if (recovered < 0) {
+        m_error = QString("The output failed: %1").arg(snd_strerror(recovered));
+        close();
+        return false;
+    }
+    return true;
+#else
+    Q_UNUSED(error)
+    return false;
+#endif
+}
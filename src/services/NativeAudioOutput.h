@@ -0,0 +1,143 @@
+#ifndef NATIVEAUDIOOUTPUT_H
+#define NATIVEAUDIOOUTPUT_H
+
+#include <QString>
+#include <QtGlobal>
+#include <functional>
+#include <vector>
+
+/**
+ * @brief Plays to an ALSA device directly, in periods of a size of our choosing
+ *
+ * QAudioSink picks its own buffer and period sizes, and they change with
+ * the Qt version and the platform plugin, so the delay from a cart being
+ * fired to it being heard was whatever Qt made it. NativeAudioOutput opens
+ * the PCM itself with periodFrames per period and a ring of periods of
+ * them, which is the whole output latency, and writes one period at a
+ * time: writePeriod() renders it through a callback and blocks until the
+ * device has room for it.
+ *
+ * The thread that writes should run at real-time priority, or a busy
+ * desktop can delay it past a period; raiseThreadPriority() asks for
+ * SCHED_FIFO, which needs rtprio in limits.conf or CAP_SYS_NICE. An
+ * underrun, an xrun, is recovered from and counted, and so are the
+ * periods written, for the metrics.
+ *
+ * PipeWire and PulseAudio systems are reached through their ALSA plugins,
+ * as the "pipewire" or "default" device; "hw:0,0" bypasses them for the
+ * lowest latency. ALSA is optional at build time: without it, or on
+ * another platform, isAvailable() is false and open() fails.
+ *
+ * @example
+ * @code
+ * NativeAudioOutput output;
+ * NativeAudioOutput::Config config;
+ * config.periodFrames = 128;
+ * if (output.open(config)) {
+ *     NativeAudioOutput::raiseThreadPriority();
+ *     while (running)
+ *         output.writePeriod([&](float* out, int frames) { mixer.render(out, frames); });
+ * }
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class NativeAudioOutput
+{
+public:
+    static constexpr int DEFAULT_PERIOD_FRAMES = 256;
+    static constexpr int MIN_PERIOD_FRAMES = 32;
+    static constexpr int MAX_PERIOD_FRAMES = 8192;
+    static constexpr int DEFAULT_PERIODS = 2;
+    static constexpr int MAX_PERIODS = 16;
+    static constexpr int CHANNELS = 2;
+    static constexpr int DEFAULT_RT_PRIORITY = 70;
+
+    struct Config {
+        QString device = "default";
+        int sampleRate = 48000;
+        int periodFrames = DEFAULT_PERIOD_FRAMES;
+        int periods = DEFAULT_PERIODS;
+    };
+
+    struct Statistics {
+        qint64 xruns = 0;
+        qint64 periodsWritten = 0;
+        int periodFrames = 0;         ///< As the device granted them
+        int periods = 0;
+        int sampleRate = 0;
+        double latencyMs = 0;         ///< Of the whole ring of periods
+    };
+
+    /// Fills the interleaved stereo float frames of one period
+    using Render = std::function<void(float* out, int frames)>;
+
+    /**
+     * @brief Whether XFB was built with ALSA
+     */
+    static bool isAvailable();
+
+    /**
+     * @brief A config with its sizes brought within the limits
+     */
+    static Config normalized(Config config);
+
+    /**
+     * @brief Ask for real-time scheduling of the calling thread
+     * @return false if the system refused, as it does without rtprio
+     */
+    static bool raiseThreadPriority(int priority = DEFAULT_RT_PRIORITY);
+
+    /**
+     * @brief Convert float samples to 16 bit, clipping
+     */
+    static void toInt16(const float* in, qint16* out, int samples);
+
+    NativeAudioOutput() = default;
+    ~NativeAudioOutput();
+    NativeAudioOutput(const NativeAudioOutput&) = delete;
+    NativeAudioOutput& operator=(const NativeAudioOutput&) = delete;
+
+    /**
+     * @brief Open a device; the sizes granted may differ from those asked for
+     * @return false with errorString() set if it cannot be opened
+     */
+    bool open(const Config& config);
+    void close();
+    bool isOpen() const { return m_pcm != nullptr; }
+    QString errorString() const { return m_error; }
+
+    /**
+     * @brief Render one period and write it, blocking until the device takes it
+     * @return false if the device failed and was closed
+     */
+    bool writePeriod(const Render& render);
+
+    /**
+     * @brief Stop playing what is queued, as for a stop or a pause
+     *
+     * The next writePeriod() starts the device again.
+     */
+    void drop();
+
+    /**
+     * @brief Counts and sizes; on the writing thread, or while it does not write
+     */
+    Statistics statistics() const;
+
+private:
+    bool recover(int error);
+
+    void* m_pcm = nullptr;            ///< snd_pcm_t
+    QString m_error;
+    bool m_int16 = false;             ///< The device took 16 bit rather than float
+    int m_sampleRate = 0;
+    int m_periodFrames = 0;
+    int m_periods = 0;
+    std::vector<float> m_buffer;
+    std::vector<qint16> m_converted;
+    qint64 m_xruns = 0;
+    qint64 m_periodsWritten = 0;
+};
+
+#endif // NATIVEAUDIOOUTPUT_H
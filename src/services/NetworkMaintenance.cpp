@@ -0,0 +1,212 @@
+#include "NetworkMaintenance.h"
+#include <QDebug>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QRegularExpression>
+#include <QStringList>
+#include <QTimer>
+#include <memory>
+
+namespace {
+
+// dyndns2 answers that mean the record was not updated
+const QStringList DDNS_FAILURES = {"badauth", "notfqdn", "nohost", "numhost",
+                                   "abuse",   "badagent", "dnserr", "911"};
+
+} // namespace
+
+NetworkMaintenance::NetworkMaintenance(QNetworkAccessManager* network, QObject* parent)
+    : QObject(parent)
+    , m_network(network ? network : new QNetworkAccessManager(this))
+    , m_probes(new ReachabilityMonitor(this))
+    , m_refreshTimer(new QTimer(this))
+{
+    connect(m_refreshTimer, &QTimer::timeout, this, &NetworkMaintenance::refresh);
+}
+
+void NetworkMaintenance::setUpdateUrl(const QString& url)
+{
+    if (url != m_updateUrl) {
+        // A new record has never seen the address
+        m_publishedAddress = QHostAddress();
+    }
+    m_updateUrl = url;
+}
+
+void NetworkMaintenance::setRefreshInterval(int intervalMs)
+{
+    if (intervalMs > 0) {
+        m_refreshTimer->start(intervalMs);
+    } else {
+        m_refreshTimer->stop();
+    }
+}
+
+bool NetworkMaintenance::isFresh(const QElapsedTimer& age) const
+{
+    return age.isValid() && age.elapsed() < m_cacheTtlMs;
+}
+
+void NetworkMaintenance::publicAddress(AddressCallback callback, bool forceRefresh)
+{
+    if (!forceRefresh && !m_address.isNull() && isFresh(m_addressAge)) {
+        if (callback) {
+            callback(m_address, QString());
+        }
+        return;
+    }
+
+    m_waiting.append(std::move(callback));
+    if (m_lookup) {
+        return;
+    }
+
+    QNetworkRequest request(m_lookupUrl);
+    request.setTransferTimeout(m_timeoutMs);
+    QNetworkReply* reply = m_network->get(request);
+    m_lookup = reply;
+    connect(reply, &QNetworkReply::finished, this, [this, reply]() { onLookupFinished(reply); });
+}
+
+void NetworkMaintenance::refresh()
+{
+    publicAddress(nullptr, true);
+}
+
+void NetworkMaintenance::onLookupFinished(QNetworkReply* reply)
+{
+    m_lookup = nullptr;
+    reply->deleteLater();
+
+    QHostAddress address;
+    QString error;
+    if (reply->error() != QNetworkReply::NoError) {
+        error = reply->errorString();
+    } else {
+        const QString text = QString::fromUtf8(reply->readAll()).section(QRegularExpression("\\s+"), 0, 0,
+                                                                          QString::SectionSkipEmpty);
+        if (!address.setAddress(text)) {
+            error = QString("Not an IP address: %1").arg(text.left(64));
+        }
+    }
+
+    if (error.isEmpty()) {
+        m_addressAge.start();
+        if (address != m_address) {
+            qInfo() << "NetworkMaintenance: public address is" << address.toString();
+            m_address = address;
+            // Probes of the old address say nothing about the new one
+            m_portCache.clear();
+            emit publicAddressChanged(address);
+        }
+        publish();
+    } else {
+        logError("lookup", error);
+    }
+
+    const QList<AddressCallback> waiting = std::move(m_waiting);
+    m_waiting.clear();
+    for (const AddressCallback& callback : waiting) {
+        if (callback) {
+            callback(error.isEmpty() ? address : QHostAddress(), error);
+        }
+    }
+}
+
+void NetworkMaintenance::publish()
+{
+    if (m_updateUrl.isEmpty() || m_update || m_address == m_publishedAddress) {
+        return;
+    }
+
+    const QHostAddress address = m_address;
+    QNetworkRequest request(QUrl(QString(m_updateUrl).replace("%IP%", address.toString())));
+    request.setTransferTimeout(m_timeoutMs);
+    request.setHeader(QNetworkRequest::UserAgentHeader, "XFB/2.0");
+    QNetworkReply* reply = m_network->get(request);
+    m_update = reply;
+
+    connect(reply, &QNetworkReply::finished, this, [this, reply, address]() {
+        m_update = nullptr;
+        reply->deleteLater();
+
+        const QString response = QString::fromUtf8(reply->readAll()).trimmed();
+        bool ok = reply->error() == QNetworkReply::NoError;
+        for (const QString& failure : DDNS_FAILURES) {
+            if (response.startsWith(failure)) {
+                ok = false;
+            }
+        }
+
+        if (ok) {
+            m_publishedAddress = address;
+            qInfo() << "NetworkMaintenance: DDNS record set to" << address.toString();
+        } else {
+            // Left unpublished, so the next lookup tries again
+            logError("update", reply->error() != QNetworkReply::NoError ? reply->errorString() : response);
+        }
+        emit ddnsUpdated(ok, response);
+
+        // The address may have moved on while the update was in flight
+        if (ok && m_address != m_publishedAddress) {
+            publish();
+        }
+    });
+}
+
+void NetworkMaintenance::probePorts(const QList<quint16>& ports, int timeoutMs, PortsCallback callback,
+                                    bool forceRefresh)
+{
+    publicAddress(
+        [this, ports, timeoutMs, callback, forceRefresh](const QHostAddress& address, const QString& error) {
+            if (!error.isEmpty() || ports.isEmpty()) {
+                if (callback) {
+                    callback(address, QList<PortResult>(), error);
+                }
+                return;
+            }
+
+            auto results = std::make_shared<QList<PortResult>>();
+            auto remaining = std::make_shared<int>(int(ports.size()));
+            for (quint16 port : ports) {
+                PortResult result;
+                result.port = port;
+                results->append(result);
+            }
+
+            auto finishOne = [callback, address, results, remaining]() {
+                if (--*remaining == 0 && callback) {
+                    callback(address, *results, QString());
+                }
+            };
+
+            for (int i = 0; i < ports.size(); ++i) {
+                const quint16 port = ports[i];
+                const auto cached = m_portCache.constFind(port);
+                if (!forceRefresh && cached != m_portCache.cend() && cached->address == address &&
+                    isFresh(cached->age)) {
+                    (*results)[i].probe = cached->probe;
+                    finishOne();
+                    continue;
+                }
+
+                m_probes->probeOnce(address.toString(), port, timeoutMs,
+                                    [this, address, port, i, results, finishOne](
+                                        const ReachabilityMonitor::ProbeResult& probe) {
+                                        CachedProbe& entry = m_portCache[port];
+                                        entry.address = address;
+                                        entry.probe = probe;
+                                        entry.age.start();
+                                        (*results)[i].probe = probe;
+                                        finishOne();
+                                    });
+            }
+        });
+}
+
+void NetworkMaintenance::logError(const QString& operation, const QString& error)
+{
+    qWarning() << QString("NetworkMaintenance::%1 - %2").arg(operation, error);
+    emit operationError(operation, error);
+}
@@ -0,0 +1,140 @@
+#include "NowPlayingMonitor.h"
+#include <QDebug>
+#include <QFileInfo>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QUuid>
+
+NowPlayingMonitor::NowPlayingMonitor(const QString& databasePath, QObject* parent)
+    : QObject(parent)
+    , m_databasePath(databasePath)
+    , m_connectionName("xfb_now_playing_" + QUuid::createUuid().toString(QUuid::Id128))
+{
+    m_timer.setInterval(POLL_INTERVAL_MS);
+    connect(&m_timer, &QTimer::timeout, this, &NowPlayingMonitor::poll);
+}
+
+NowPlayingMonitor::~NowPlayingMonitor()
+{
+    close();
+}
+
+QSqlDatabase NowPlayingMonitor::openReadOnly(const QString& connectionName,
+                                             const QString& databasePath, QString* error)
+{
+    QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+    // Opening read-only would otherwise create an empty file for a missing path
+    if (!QFileInfo::exists(databasePath)) {
+        if (error) {
+            *error = QString("%1 does not exist").arg(databasePath);
+        }
+        return database;
+    }
+    database.setDatabaseName(databasePath);
+    database.setConnectOptions("QSQLITE_OPEN_READONLY;QSQLITE_BUSY_TIMEOUT=1000");
+    if (!database.open()) {
+        if (error) {
+            *error = database.lastError().text();
+        }
+        return database;
+    }
+
+    // query_only also refuses writes to temporary and attached databases
+    QSqlQuery query(database);
+    const QString pragmas[] = {
+        "PRAGMA query_only=ON",
+        QString("PRAGMA mmap_size=%1").arg(MMAP_BYTES),
+        QString("PRAGMA cache_size=-%1").arg(CACHE_KIB),
+        "PRAGMA temp_store=MEMORY",
+    };
+    for (const QString& pragma : pragmas) {
+        if (!query.exec(pragma)) {
+            qWarning() << "NowPlayingMonitor: failed to apply" << pragma << "-"
+                       << query.lastError().text();
+        }
+    }
+    return database;
+}
+
+bool NowPlayingMonitor::start()
+{
+    const bool opened = open();
+    if (opened) {
+        poll();
+    }
+    m_timer.start();
+    return opened;
+}
+
+void NowPlayingMonitor::stop()
+{
+    m_timer.stop();
+    close();
+}
+
+bool NowPlayingMonitor::poll()
+{
+    if (!m_database.isOpen() && !open()) {
+        return false;
+    }
+
+    QSqlQuery query(m_database);
+    if (!query.exec("PRAGMA data_version") || !query.next()) {
+        const QString error = query.lastError().text();
+        qWarning() << "NowPlayingMonitor: cannot read the data version of" << m_databasePath
+                   << error;
+        close();
+        if (!m_failed) {
+            m_failed = true;
+            emit connectionFailed(error);
+        }
+        return false;
+    }
+    m_failed = false;
+
+    const qint64 version = query.value(0).toLongLong();
+    if (version == m_dataVersion) {
+        return false;
+    }
+    m_dataVersion = version;
+    query.finish();
+
+    // Until the instance on air writes it the table may not exist; that reads as nothing on air
+    const NowPlayingStatus::Entry entry = NowPlayingStatus(m_database).read();
+    if (entry == m_current) {
+        return false;
+    }
+    m_current = entry;
+    emit changed(m_current);
+    return true;
+}
+
+bool NowPlayingMonitor::open()
+{
+    QString error;
+    m_database = openReadOnly(m_connectionName, m_databasePath, &error);
+    if (m_database.isOpen()) {
+        m_failed = false;
+        return true;
+    }
+    close();
+    if (!m_failed) {
+        m_failed = true;
+        qWarning() << "NowPlayingMonitor: cannot open" << m_databasePath << error;
+        emit connectionFailed(error);
+    }
+    return false;
+}
+
+void NowPlayingMonitor::close()
+{
+    if (m_database.isOpen()) {
+        m_database.close();
+    }
+    m_database = QSqlDatabase();
+    if (QSqlDatabase::contains(m_connectionName)) {
+        QSqlDatabase::removeDatabase(m_connectionName);
+    }
+    // A new connection starts its own count
+    m_dataVersion = -1;
+}
@@ -0,0 +1,111 @@
+#ifndef NOWPLAYINGMONITOR_H
+#define NOWPLAYINGMONITOR_H
+
+#include "../repositories/NowPlayingStatus.h"
+#include <QObject>
+#include <QSqlDatabase>
+#include <QString>
+#include <QTimer>
+
+/**
+ * @brief Follows the now_playing table from a read-only connection
+ *
+ * Used by the secondary display mode (xfb --display), which shows what is on
+ * air without running an automation of its own. The database is opened
+ * read-only with query_only set, so the display can never take a write
+ * lock from the instance on air, and memory-mapped with a small page cache,
+ * so reading it costs the display next to nothing.
+ *
+ * Every POLL_INTERVAL_MS the monitor asks SQLite for the data_version of
+ * the file, which only changes when another connection commits. The
+ * now_playing row is read again and changed() emitted only then, so an
+ * idle poll is one pragma and no table is touched.
+ *
+ * SQLite's immutable flag is not used: it tells SQLite the file never
+ * changes, and the display would then never see the next track.
+ *
+ * @example
+ * @code
+ * NowPlayingMonitor* monitor = new NowPlayingMonitor(databasePath, this);
+ * connect(monitor, &NowPlayingMonitor::changed, display, &Display::showEntry);
+ * monitor->start();
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class NowPlayingMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int POLL_INTERVAL_MS = 1000;
+    static constexpr qint64 MMAP_BYTES = 64 * 1024 * 1024;
+    static constexpr int CACHE_KIB = 1024;
+
+    /**
+     * @param databasePath Library database the instance on air writes
+     * @param parent Parent object
+     */
+    explicit NowPlayingMonitor(const QString& databasePath, QObject* parent = nullptr);
+    ~NowPlayingMonitor() override;
+
+    /**
+     * @brief Open a connection that can only read, with the memory map set up
+     *
+     * The connection may only be used on the thread that opened it.
+     * @param connectionName Name for QSqlDatabase::database()
+     * @param databasePath SQLite database file
+     * @param error Set to the reason on failure
+     * @return The connection, closed if it could not be opened
+     */
+    static QSqlDatabase openReadOnly(const QString& connectionName, const QString& databasePath,
+                                     QString* error = nullptr);
+
+    /**
+     * @brief Open the database, read the row and start polling
+     * @return false if the database cannot be opened; polling retries it
+     */
+    bool start();
+
+    void stop();
+    bool isRunning() const { return m_timer.isActive(); }
+
+    void setInterval(int intervalMs) { m_timer.setInterval(intervalMs); }
+    int interval() const { return m_timer.interval(); }
+
+    /**
+     * @brief Check the data version now, and read the row if it changed
+     * @return true if changed() was emitted
+     */
+    bool poll();
+
+    /**
+     * @brief The row read last
+     */
+    NowPlayingStatus::Entry current() const { return m_current; }
+
+signals:
+    /**
+     * @brief Emitted when what is on air, or the queue after it, changed
+     */
+    void changed(const NowPlayingStatus::Entry& entry);
+
+    /**
+     * @brief Emitted when the database could not be opened or read
+     */
+    void connectionFailed(const QString& error);
+
+private:
+    bool open();
+    void close();
+
+    QString m_databasePath;
+    QString m_connectionName;
+    QSqlDatabase m_database;
+    QTimer m_timer;
+    qint64 m_dataVersion = -1;   ///< -1 until the first read
+    NowPlayingStatus::Entry m_current;
+    bool m_failed = false;       ///< connectionFailed() was emitted since the last success
+};
+
+#endif // NOWPLAYINGMONITOR_H
@@ -0,0 +1,99 @@
+#include "PcmDecoder.h"
+#include <QAudioBuffer>
+#include <QAudioDecoder>
+#include <QAudioFormat>
+#include <QEventLoop>
+#include <QTimer>
+#include <QUrl>
+#include <QVector>
+
+namespace {
+
+const float* floatSamples(const QAudioBuffer& buffer, QVector<float>& scratch)
+{
+    const QAudioFormat format = buffer.format();
+    const qint64 count = buffer.sampleCount();
+    if (format.sampleFormat() == QAudioFormat::Float) {
+        return buffer.constData<float>();
+    }
+
+    scratch.resize(count);
+    if (format.sampleFormat() == QAudioFormat::Int16) {
+        const qint16* data = buffer.constData<qint16>();
+        for (qint64 i = 0; i < count; ++i) {
+            scratch[i] = data[i] / 32768.0f;
+        }
+    } else {
+        const char* data = buffer.constData<char>();
+        const int bytesPerSample = format.bytesPerSample();
+        for (qint64 i = 0; i < count; ++i) {
+            scratch[i] = format.normalizedSampleValue(data + i * bytesPerSample);
+        }
+    }
+    return scratch.constData();
+}
+
+} // namespace
+
+bool PcmDecoder::decode(const QString& filePath, int sampleRate, const Sink& sink, QString* error,
+                        int timeoutMs)
+{
+    QAudioFormat format;
+    format.setSampleRate(sampleRate);
+    format.setChannelCount(2);
+    format.setSampleFormat(QAudioFormat::Float);
+
+    QAudioDecoder decoder;
+    decoder.setAudioFormat(format);
+    decoder.setSource(QUrl::fromLocalFile(filePath));
+
+    QVector<float> scratch;
+    QString failure;
+    bool decoded = false;
+    bool done = false;
+    QEventLoop loop;
+    QTimer timer;
+    timer.setSingleShot(true);
+
+    const auto finish = [&](const QString& reason) {
+        failure = reason;
+        done = true;
+        loop.quit();
+    };
+
+    QObject::connect(&decoder, &QAudioDecoder::bufferReady, &loop, [&]() {
+        while (decoder.bufferAvailable()) {
+            const QAudioBuffer buffer = decoder.read();
+            const QAudioFormat bufferFormat = buffer.format();
+            if (!buffer.isValid() || bufferFormat.channelCount() <= 0 ||
+                bufferFormat.sampleRate() <= 0) {
+                continue;
+            }
+            sink(floatSamples(buffer, scratch), buffer.sampleCount(), bufferFormat.sampleRate(),
+                 bufferFormat.channelCount());
+            decoded = true;
+        }
+    });
+    QObject::connect(&decoder, &QAudioDecoder::finished, &loop, [&]() { finish(QString()); });
+    QObject::connect(&decoder, QOverload<QAudioDecoder::Error>::of(&QAudioDecoder::error), &loop,
+                     [&]() { finish(decoder.errorString()); });
+    QObject::connect(&timer, &QTimer::timeout, &loop, [&]() {
+        finish(QString("Decoding took longer than %1 s").arg(timeoutMs / 1000));
+    });
+
+    timer.start(timeoutMs);
+    decoder.start();
+    // Backends may fail synchronously inside start()
+    if (!done) {
+        loop.exec();
+    }
+    decoder.stop();
+
+    if (failure.isEmpty() && !decoded) {
+        failure = "No audio decoded";
+    }
+    if (!failure.isEmpty() && error) {
+        *error = failure;
+    }
+    return failure.isEmpty();
+}
@@ -0,0 +1,48 @@
+#ifndef PCMDECODER_H
+#define PCMDECODER_H
+
+#include <QString>
+#include <functional>
+
+/**
+ * @brief Decodes a whole file to float PCM for analysis, blocking
+ *
+ * Shared by the library analyzers, which run on worker threads: decode()
+ * runs a QAudioDecoder in its own event loop and hands every decoded
+ * buffer to a sink as interleaved float samples, converting other sample
+ * formats on the way. The requested rate and channel count are a request
+ * only; the sink is always told the format the samples really have.
+ *
+ * @example
+ * @code
+ * QString error;
+ * PcmDecoder::decode(path, 48000, [&](const float* samples, qint64 count, int rate, int channels) {
+ *     meter.feed(samples, count);
+ * }, &error);
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class PcmDecoder
+{
+public:
+    /// Receives interleaved samples; count is a whole number of frames
+    using Sink =
+        std::function<void(const float* samples, qint64 count, int sampleRate, int channels)>;
+
+    static constexpr int DEFAULT_TIMEOUT_MS = 2 * 60 * 1000;
+
+    /**
+     * @brief Decode a file from start to end
+     * @param filePath Path of the audio file
+     * @param sampleRate Rate to ask the decoder for, in Hz
+     * @param sink Called for every decoded buffer, on the calling thread
+     * @param error Receives the reason if decoding failed; may be nullptr
+     * @param timeoutMs Decoding is given up after this long
+     * @return true if the file was decoded to the end and produced audio
+     */
+    static bool decode(const QString& filePath, int sampleRate, const Sink& sink,
+                       QString* error = nullptr, int timeoutMs = DEFAULT_TIMEOUT_MS);
+};
+
+#endif // PCMDECODER_H
@@ -0,0 +1,221 @@
+#include "PeakFile.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QtEndian>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <memory>
+
+namespace {
+
+constexpr char MAGIC[4] = {'X', 'F', 'B', 'W'};
+
+static_assert(sizeof(PeakFile::Bucket) == 2, "Buckets are stored as byte pairs");
+
+PeakFile::Bucket quantize(float min, float max)
+{
+    // Outwards, so the drawn envelope never hides a peak
+    PeakFile::Bucket bucket;
+    bucket.min = static_cast<qint8>(std::floor(qBound(-1.0f, min, 1.0f) * 127.0f));
+    bucket.max = static_cast<qint8>(std::ceil(qBound(-1.0f, max, 1.0f) * 127.0f));
+    return bucket;
+}
+
+} // namespace
+
+PeakFile::Builder::Builder(int sampleRate, int channels)
+    : m_sampleRate(qMax(1, sampleRate))
+    , m_channels(qMax(1, channels))
+    , m_min(std::numeric_limits<float>::max())
+    , m_max(std::numeric_limits<float>::lowest())
+{
+}
+
+void PeakFile::Builder::feed(const float* samples, qint64 count)
+{
+    const qint64 frames = qMax<qint64>(0, count) / m_channels;
+    qint64 frame = 0;
+    while (frame < frames) {
+        const qint64 span = qMin<qint64>(BASE_FRAMES_PER_BUCKET - m_bucketFill, frames - frame);
+
+        // The channels of a bucket are pooled, so this is one plain min/max
+        // over contiguous samples, which the compiler vectorizes
+        const float* first = samples + frame * m_channels;
+        const qint64 length = span * m_channels;
+        float min = m_min;
+        float max = m_max;
+        for (qint64 i = 0; i < length; ++i) {
+            min = first[i] < min ? first[i] : min;
+            max = first[i] > max ? first[i] : max;
+        }
+        m_min = min;
+        m_max = max;
+
+        m_bucketFill += static_cast<int>(span);
+        frame += span;
+        if (m_bucketFill == BASE_FRAMES_PER_BUCKET) {
+            closeBucket();
+        }
+    }
+    m_frames += frames;
+}
+
+QByteArray PeakFile::Builder::data() const
+{
+    QList<QVector<Bucket>> levels;
+    levels.append(m_buckets);
+    if (m_bucketFill > 0) {
+        levels.first().append(quantize(m_min, m_max));
+    }
+    while (levels.size() < MAX_LEVELS && levels.last().size() > MIN_LEVEL_BUCKETS) {
+        const QVector<Bucket>& finer = levels.last();
+        QVector<Bucket> coarser;
+        coarser.reserve((finer.size() + LEVEL_FACTOR - 1) / LEVEL_FACTOR);
+        for (qsizetype i = 0; i < finer.size(); i += LEVEL_FACTOR) {
+            Bucket bucket = finer.at(i);
+            for (qsizetype j = i + 1; j < qMin<qsizetype>(i + LEVEL_FACTOR, finer.size()); ++j) {
+                bucket.min = qMin(bucket.min, finer.at(j).min);
+                bucket.max = qMax(bucket.max, finer.at(j).max);
+            }
+            coarser.append(bucket);
+        }
+        levels.append(coarser);
+    }
+
+    QByteArray header(HEADER_SIZE + levels.size() * 8, '\0');
+    char* out = header.data();
+    memcpy(out, MAGIC, sizeof(MAGIC));
+    qToLittleEndian<quint16>(VERSION, out + 4);
+    qToLittleEndian<quint16>(static_cast<quint16>(levels.size()), out + 6);
+    qToLittleEndian<quint32>(static_cast<quint32>(m_sampleRate), out + 8);
+    qToLittleEndian<quint32>(BASE_FRAMES_PER_BUCKET, out + 12);
+    qToLittleEndian<quint64>(static_cast<quint64>(m_frames), out + 16);
+    qToLittleEndian<quint32>(LEVEL_FACTOR, out + 24);
+    for (int level = 0; level < levels.size(); ++level) {
+        qToLittleEndian<quint64>(levels.at(level).size(), out + HEADER_SIZE + level * 8);
+    }
+
+    QByteArray data = header;
+    for (const QVector<Bucket>& level : levels) {
+        data.append(reinterpret_cast<const char*>(level.constData()),
+                    level.size() * qsizetype(sizeof(Bucket)));
+    }
+    return data;
+}
+
+void PeakFile::Builder::closeBucket()
+{
+    m_buckets.append(quantize(m_min, m_max));
+    m_bucketFill = 0;
+    m_min = std::numeric_limits<float>::max();
+    m_max = std::numeric_limits<float>::lowest();
+}
+
+PeakFile::~PeakFile()
+{
+    close();
+}
+
+bool PeakFile::generate(const QString& audioPath, const QString& peakPath, QString* error,
+                        int timeoutMs)
+{
+    std::unique_ptr<Builder> builder;
+    const auto feed = [&](const float* samples, qint64 count, int sampleRate, int channels) {
+        if (!builder) {
+            builder = std::make_unique<Builder>(sampleRate, channels);
+        }
+        builder->feed(samples, count);
+    };
+    if (!PcmDecoder::decode(audioPath, SAMPLE_RATE, feed, error, timeoutMs)) {
+        return false;
+    }
+    return builder->save(peakPath, error);
+}
+
+bool PeakFile::Builder::save(const QString& peakPath, QString* error) const
+{
+    QDir().mkpath(QFileInfo(peakPath).absolutePath());
+    QSaveFile file(peakPath);
+    const QByteArray data = this->data();
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+        if (error) {
+            *error = QString("Cannot write %1: %2").arg(peakPath, file.errorString());
+        }
+        return false;
+    }
+    return true;
+}
+
+bool PeakFile::open(const QString& peakPath)
+{
+    close();
+
+    m_file.setFileName(peakPath);
+    if (!m_file.open(QIODevice::ReadOnly) || m_file.size() < HEADER_SIZE) {
+        close();
+        return false;
+    }
+    const qint64 size = m_file.size();
+    const uchar* data = m_file.map(0, size);
+    if (!data || memcmp(data, MAGIC, sizeof(MAGIC)) != 0
+        || qFromLittleEndian<quint16>(data + 4) != VERSION) {
+        close();
+        return false;
+    }
+
+    const int levels = qFromLittleEndian<quint16>(data + 6);
+    const qint64 baseFrames = qFromLittleEndian<quint32>(data + 12);
+    const qint64 factor = qFromLittleEndian<quint32>(data + 24);
+    if (levels < 1 || levels > MAX_LEVELS || baseFrames < 1 || factor < 2
+        || size < HEADER_SIZE + levels * 8) {
+        close();
+        return false;
+    }
+
+    qint64 offset = HEADER_SIZE + levels * 8;
+    qint64 framesPerBucket = baseFrames;
+    for (int level = 0; level < levels; ++level) {
+        Level entry;
+        entry.count =
+            static_cast<qint64>(qFromLittleEndian<quint64>(data + HEADER_SIZE + level * 8));
+        entry.framesPerBucket = framesPerBucket;
+        entry.buckets = reinterpret_cast<const Bucket*>(data + offset);
+        if (entry.count < 0 || entry.count > (size - offset) / qint64(sizeof(Bucket))) {
+            close();
+            return false;
+        }
+        offset += entry.count * qint64(sizeof(Bucket));
+        framesPerBucket *= factor;
+        m_levels.append(entry);
+    }
+    if (offset != size) {
+        close();
+        return false;
+    }
+
+    m_data = data;
+    m_sampleRate = static_cast<int>(qFromLittleEndian<quint32>(data + 8));
+    m_frames = static_cast<qint64>(qFromLittleEndian<quint64>(data + 16));
+    return true;
+}
+
+void PeakFile::close()
+{
+    m_levels.clear();
+    m_data = nullptr;
+    m_sampleRate = 0;
+    m_frames = 0;
+    m_file.close();   // Also unmaps
+}
+
+int PeakFile::levelFor(double framesPerPixel) const
+{
+    for (int level = m_levels.size() - 1; level > 0; --level) {
+        if (m_levels.at(level).framesPerBucket <= framesPerPixel) {
+            return level;
+        }
+    }
+    return 0;
+}
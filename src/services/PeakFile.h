@@ -0,0 +1,159 @@
+#ifndef PEAKFILE_H
+#define PEAKFILE_H
+
+#include "PcmDecoder.h"
+#include <QByteArray>
+#include <QFile>
+#include <QList>
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief Waveform overview of a track, stored as a min/max pyramid
+ *
+ * A peak file holds the lowest and highest sample of every bucket of
+ * BASE_FRAMES_PER_BUCKET frames, all channels together, quantized to
+ * signed bytes. Above that level sit coarser ones, each LEVEL_FACTOR times
+ * coarser than the one below, until a level fits in MIN_LEVEL_BUCKETS. A
+ * three-minute track takes about 90 KB, and drawing it at any width reads
+ * at most a few thousand buckets of the right level.
+ *
+ * The layout, all little-endian:
+ * - 32-byte header: "XFBW", version, level count, sample rate, frames per
+ *   level-0 bucket, total frames, level factor and a reserved word
+ * - the bucket count of every level, as 64-bit integers
+ * - the buckets of every level, finest first, as (min, max) byte pairs
+ *
+ * Use Builder or generate() to write one and open() to read one. open()
+ * maps the file instead of reading it, so a waveform can be drawn without
+ * decoding or even loading the track.
+ *
+ * @example
+ * @code
+ * PeakFile::generate("/music/song.ogg", "/cache/peaks/song.peak");
+ * PeakFile peaks;
+ * if (peaks.open("/cache/peaks/song.peak")) {
+ *     const int level = peaks.levelFor(peaks.frames() / double(width()));
+ *     const PeakFile::Bucket* buckets = peaks.buckets(level);
+ * }
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class PeakFile
+{
+public:
+    /**
+     * @brief Lowest and highest sample of a bucket, scaled to -127..127
+     */
+    struct Bucket {
+        qint8 min = 0;
+        qint8 max = 0;
+    };
+
+    /**
+     * @brief Collects the buckets of decoded audio
+     */
+    class Builder
+    {
+    public:
+        Builder(int sampleRate, int channels);
+
+        /**
+         * @brief Add interleaved samples
+         * @param samples Samples of whole frames
+         * @param count Number of samples, not frames
+         */
+        void feed(const float* samples, qint64 count);
+
+        /**
+         * @brief Get the peak file of everything fed so far
+         */
+        QByteArray data() const;
+
+        /**
+         * @brief Write the peak file of everything fed so far, atomically
+         * @param peakPath File to write; its directory is created if needed
+         * @param error Receives the reason on failure; may be nullptr
+         */
+        bool save(const QString& peakPath, QString* error = nullptr) const;
+
+    private:
+        void closeBucket();
+
+        int m_sampleRate;
+        int m_channels;
+        qint64 m_frames = 0;
+        int m_bucketFill = 0;   ///< Frames in the bucket being collected
+        float m_min = 0.0f;
+        float m_max = 0.0f;
+        QVector<Bucket> m_buckets;
+    };
+
+    static constexpr int VERSION = 1;
+    static constexpr int HEADER_SIZE = 32;
+    /// Tracks are decoded at this rate, so every file has the same timing
+    static constexpr int SAMPLE_RATE = 48000;
+    /// About 5 ms at SAMPLE_RATE
+    static constexpr int BASE_FRAMES_PER_BUCKET = 256;
+    static constexpr int LEVEL_FACTOR = 4;
+    static constexpr qint64 MIN_LEVEL_BUCKETS = 256;
+    static constexpr int MAX_LEVELS = 12;
+
+    PeakFile() = default;
+    ~PeakFile();
+    PeakFile(const PeakFile&) = delete;
+    PeakFile& operator=(const PeakFile&) = delete;
+
+    /**
+     * @brief Decode a track and write its peak file
+     * @param audioPath Track to decode
+     * @param peakPath Peak file to write; replaced only on success
+     * @param error Set to the reason on failure, if given
+     * @param timeoutMs Time allowed for decoding
+     * @return true if the peak file was written
+     */
+    static bool generate(const QString& audioPath, const QString& peakPath,
+                         QString* error = nullptr,
+                         int timeoutMs = PcmDecoder::DEFAULT_TIMEOUT_MS);
+
+    /**
+     * @brief Map a peak file
+     * @param peakPath File written by generate() or Builder
+     * @return false if it cannot be read or is not a valid peak file
+     */
+    bool open(const QString& peakPath);
+    void close();
+    bool isOpen() const { return m_data != nullptr; }
+
+    int sampleRate() const { return m_sampleRate; }
+    qint64 frames() const { return m_frames; }
+    qint64 durationMs() const { return m_sampleRate > 0 ? m_frames * 1000 / m_sampleRate : 0; }
+    int levelCount() const { return m_levels.size(); }
+
+    qint64 bucketCount(int level) const { return m_levels.at(level).count; }
+    qint64 framesPerBucket(int level) const { return m_levels.at(level).framesPerBucket; }
+    const Bucket* buckets(int level) const { return m_levels.at(level).buckets; }
+
+    /**
+     * @brief Get the coarsest level that still has a bucket per pixel
+     * @param framesPerPixel Frames of the track one pixel stands for
+     * @return Level index; 0 when zoomed in further than level 0
+     */
+    int levelFor(double framesPerPixel) const;
+
+private:
+    struct Level {
+        qint64 count = 0;
+        qint64 framesPerBucket = 0;
+        const Bucket* buckets = nullptr;
+    };
+
+    QFile m_file;
+    const uchar* m_data = nullptr;
+    int m_sampleRate = 0;
+    qint64 m_frames = 0;
+    QList<Level> m_levels;
+};
+
+#endif // PEAKFILE_H
@@ -0,0 +1,175 @@
+#include "PeakFileGenerator.h"
+#include "PeakFile.h"
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QSet>
+#include <QThread>
+#include <QtConcurrent/QtConcurrent>
+
+namespace {
+
+bool peakFileIsCurrent(const QString& audioPath, const QString& peakPath)
+{
+    const QFileInfo peaks(peakPath);
+    const QFileInfo audio(audioPath);
+    return peaks.exists() && audio.exists() && peaks.lastModified() >= audio.lastModified();
+}
+
+} // namespace
+
+PeakFileGenerator::PeakFileGenerator(const QString& cacheDirectory, QObject* parent)
+    : QObject(parent)
+    , m_cacheDirectory(cacheDirectory)
+    , m_generate([](const QString& audioPath, const QString& peakPath, QString* error) {
+        return PeakFile::generate(audioPath, peakPath, error);
+    })
+    , m_maxWorkers(qMax(1, QThread::idealThreadCount() - 1))
+{
+    m_pool.setThreadPriority(QThread::LowPriority);
+    m_pool.setMaxThreadCount(m_maxWorkers);
+}
+
+PeakFileGenerator::~PeakFileGenerator()
+{
+    m_queue.clear();
+    m_pool.waitForDone();
+}
+
+QString PeakFileGenerator::peakPath(const QString& audioPath) const
+{
+    const QByteArray hash =
+        QCryptographicHash::hash(audioPath.toUtf8(), QCryptographicHash::Sha1).toHex();
+    return QDir(m_cacheDirectory).filePath(QString::fromLatin1(hash) + ".peak");
+}
+
+bool PeakFileGenerator::isCurrent(const QString& audioPath) const
+{
+    return peakFileIsCurrent(audioPath, peakPath(audioPath));
+}
+
+void PeakFileGenerator::setMaxWorkers(int workers)
+{
+    m_maxWorkers = qMax(1, workers);
+    m_pool.setMaxThreadCount(m_maxWorkers);
+    schedule();
+}
+
+int PeakFileGenerator::generate(const QStringList& audioPaths, bool urgent)
+{
+    QSet<QString> waiting(m_queue.cbegin(), m_queue.cend());
+    QStringList front;
+    int added = 0;
+    for (const QString& audioPath : audioPaths) {
+        if (audioPath.isEmpty()) {
+            continue;
+        }
+        if (waiting.contains(audioPath)) {
+            if (urgent && !front.contains(audioPath)) {
+                m_queue.removeOne(audioPath);
+                front.append(audioPath);
+            }
+            continue;
+        }
+
+        waiting.insert(audioPath);
+        if (urgent) {
+            front.append(audioPath);
+        } else {
+            m_queue.append(audioPath);
+        }
+        ++added;
+    }
+    m_queue = front + m_queue;
+    if (added == 0) {
+        schedule();
+        return 0;
+    }
+
+    m_total += added;
+    m_running = true;
+    schedule();
+    return added;
+}
+
+void PeakFileGenerator::cancel()
+{
+    if (!m_running) {
+        return;
+    }
+
+    m_queue.clear();
+    ++m_generation;
+    m_inFlight = 0;
+    finish();
+}
+
+void PeakFileGenerator::schedule()
+{
+    while (m_running && m_inFlight < m_maxWorkers && !m_queue.isEmpty()) {
+        const QString audioPath = m_queue.takeFirst();
+        ++m_inFlight;
+
+        auto* watcher = new QFutureWatcher<Outcome>(this);
+        const int generation = m_generation;
+        connect(watcher, &QFutureWatcher<Outcome>::finished, this, [this, watcher, generation]() {
+            onGenerated(watcher->result(), generation);
+            watcher->deleteLater();
+        });
+        watcher->setFuture(QtConcurrent::run(
+            &m_pool, [generate = m_generate, audioPath, target = peakPath(audioPath)]() {
+                Outcome outcome;
+                outcome.audioPath = audioPath;
+                if (peakFileIsCurrent(audioPath, target)) {
+                    outcome.status = Status::Current;
+                } else if (generate(audioPath, target, &outcome.error)) {
+                    outcome.status = Status::Generated;
+                }
+                return outcome;
+            }));
+    }
+}
+
+void PeakFileGenerator::onGenerated(const Outcome& outcome, int generation)
+{
+    if (generation != m_generation) {
+        return;
+    }
+    --m_inFlight;
+    ++m_done;
+
+    if (outcome.status == Status::Failed) {
+        ++m_failed;
+        qWarning() << QString("PeakFileGenerator::onGenerated - %1: %2")
+                          .arg(outcome.audioPath, outcome.error);
+    } else {
+        if (outcome.status == Status::Generated) {
+            ++m_generated;
+        }
+        emit peaksReady(outcome.audioPath, peakPath(outcome.audioPath));
+    }
+    emit progressChanged(m_done, m_total);
+
+    if (m_queue.isEmpty() && m_inFlight == 0) {
+        finish();
+    } else {
+        schedule();
+    }
+}
+
+void PeakFileGenerator::finish()
+{
+    const int generated = m_generated;
+    const int failed = m_failed;
+    m_running = false;
+    m_total = 0;
+    m_done = 0;
+    m_generated = 0;
+    m_failed = 0;
+
+    qInfo() << "PeakFileGenerator: run finished," << generated << "generated," << failed
+            << "failed";
+    emit finished(generated, failed);
+}
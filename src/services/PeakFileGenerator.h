@@ -0,0 +1,133 @@
+#ifndef PEAKFILEGENERATOR_H
+#define PEAKFILEGENERATOR_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <functional>
+
+/**
+ * @brief Keeps a cache of peak files for the library tracks
+ *
+ * PeakFileGenerator writes the PeakFile of each track into a cache
+ * directory, named after a hash of the track's path, on its own
+ * low-priority thread pool with up to maxWorkers() files decoding at once.
+ * A track whose peak file is newer than the track itself is skipped on the
+ * worker, without decoding, so handing the whole library to generate()
+ * after every import only decodes what is new or changed.
+ *
+ * Tracks given with urgent set, such as the one going on air, are put in
+ * front of the queue.
+ *
+ * @example
+ * @code
+ * PeakFileGenerator* peaks = new PeakFileGenerator(cacheDir + "/peaks", this);
+ * connect(peaks, &PeakFileGenerator::peaksReady, this,
+ *         [](const QString& audioPath, const QString& peakPath) { qDebug() << peakPath; });
+ * peaks->generate(allLibraryPaths);
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class PeakFileGenerator : public QObject
+{
+    Q_OBJECT
+
+public:
+    /// Runs on a pool thread; PeakFile::generate() unless replaced
+    using Generator = std::function<bool(const QString& audioPath, const QString& peakPath,
+                                         QString* error)>;
+
+    explicit PeakFileGenerator(const QString& cacheDirectory, QObject* parent = nullptr);
+    ~PeakFileGenerator() override;
+
+    QString cacheDirectory() const { return m_cacheDirectory; }
+
+    /**
+     * @brief Get where the peak file of a track is kept
+     * @param audioPath Path of the track
+     */
+    QString peakPath(const QString& audioPath) const;
+
+    /**
+     * @brief Check whether a track has a peak file newer than itself
+     * @param audioPath Path of the track
+     */
+    bool isCurrent(const QString& audioPath) const;
+
+    /**
+     * @brief Set how many files are decoded at once
+     * @param workers Worker count; one less than the number of cores by default
+     */
+    void setMaxWorkers(int workers);
+    int maxWorkers() const { return m_maxWorkers; }
+
+    void setGenerator(Generator generator) { m_generate = std::move(generator); }
+
+    /**
+     * @brief Add tracks to the queue and start it if it is not running
+     * @param audioPaths Paths of the tracks
+     * @param urgent Put them in front of the tracks already waiting
+     * @return Number of tracks added; tracks already waiting are skipped
+     */
+    int generate(const QStringList& audioPaths, bool urgent = false);
+
+    /**
+     * @brief Drop the tracks that have not been started
+     */
+    void cancel();
+
+    bool isRunning() const { return m_running; }
+
+signals:
+    /**
+     * @brief Emitted when a track's peak file was written or found current
+     * @param audioPath Path of the track
+     * @param peakPath Path of its peak file
+     */
+    void peaksReady(const QString& audioPath, const QString& peakPath);
+
+    /**
+     * @brief Emitted after each track
+     * @param done Tracks finished, including those skipped or failed
+     * @param total Tracks in this run
+     */
+    void progressChanged(int done, int total);
+
+    /**
+     * @brief Emitted when the last track of the run is done, or after cancel()
+     * @param generated Tracks whose peak file was written
+     * @param failed Tracks that could not be decoded
+     */
+    void finished(int generated, int failed);
+
+private:
+    enum class Status { Generated, Current, Failed };
+
+    struct Outcome {
+        QString audioPath;
+        Status status = Status::Failed;
+        QString error;
+    };
+
+    void schedule();
+    void onGenerated(const Outcome& outcome, int generation);
+    void finish();
+
+    QString m_cacheDirectory;
+    QThreadPool m_pool;
+    Generator m_generate;
+    int m_maxWorkers;
+
+    QStringList m_queue;
+    bool m_running = false;
+    int m_inFlight = 0;
+    int m_generation = 0;   ///< Bumped by cancel() so late results are dropped
+    int m_total = 0;
+    int m_done = 0;
+    int m_generated = 0;
+    int m_failed = 0;
+};
+
+#endif // PEAKFILEGENERATOR_H
@@ -0,0 +1,206 @@
+#include "PlayHistoryWriter.h"
+#include <QDebug>
+#include <QSqlError>
+#include <algorithm>
+
+PlayHistoryWriter::PlayHistoryWriter(QSqlDatabase& database, QObject* parent)
+    : QObject(parent)
+    , m_database(database)
+    , m_repository(database)
+    , m_ranking(database)
+    , m_proofs(database)
+    , m_historyDirectory(PlayHistory::defaultDirectory(database))
+{
+    m_flushTimer.setSingleShot(true);
+    m_flushTimer.setInterval(FLUSH_DELAY_MS);
+    connect(&m_flushTimer, &QTimer::timeout, this, [this]() { flush(); });
+}
+
+PlayHistoryWriter::~PlayHistoryWriter()
+{
+    flush();
+}
+
+void PlayHistoryWriter::recordPlay(const QString& filePath, const QDateTime& playedAt)
+{
+    if (filePath.isEmpty()) {
+        return;
+    }
+
+    m_pending.append({filePath, playedAt, playedAt.toString(LAST_PLAYED_FORMAT)});
+    queued();
+}
+
+void PlayHistoryWriter::expectAiring(const ProofOfPlay::Airing& airing)
+{
+    if (airing.path.isEmpty()) {
+        return;
+    }
+
+    const QDateTime stale = airing.scheduledAt.addSecs(-EXPECTED_AIRING_TTL_S);
+    m_expected.erase(std::remove_if(m_expected.begin(), m_expected.end(),
+                                    [&stale](const ProofOfPlay::Airing& expected) {
+                                        return expected.scheduledAt < stale;
+                                    }),
+                     m_expected.end());
+
+    ProofOfPlay::Airing expected = airing;
+    if (m_database.isOpen() && !m_proofs.resolve(expected)) {
+        logError("expectAiring", QString("Cannot look up %1").arg(airing.path));
+    }
+    m_expected.append(expected);
+}
+
+bool PlayHistoryWriter::recordAiring(const QString& filePath, const QDateTime& startedAt,
+                                     qint64 durationMs)
+{
+    const auto expected = std::find_if(m_expected.begin(), m_expected.end(),
+                                       [&filePath](const ProofOfPlay::Airing& airing) {
+                                           return airing.path == filePath;
+                                       });
+    if (expected == m_expected.end()) {
+        return false;
+    }
+
+    ProofOfPlay::Airing airing = *expected;
+    m_expected.erase(expected);
+    airing.startedAt = startedAt;
+    airing.durationMs = durationMs;
+    m_pendingAirings.append(airing);
+    queued();
+    return true;
+}
+
+void PlayHistoryWriter::queued()
+{
+    if (pendingCount() >= MAX_PENDING) {
+        flush();
+    } else if (!m_flushTimer.isActive()) {
+        m_flushTimer.start();
+    }
+}
+
+int PlayHistoryWriter::flush()
+{
+    m_flushTimer.stop();
+
+    if (m_pending.isEmpty() && m_pendingAirings.isEmpty()) {
+        return 0;
+    }
+
+    if (!m_database.isOpen()) {
+        logError("flush", "Database is not open");
+        dropOverflow();
+        return -1;
+    }
+
+    PlayHistory history(m_database, m_historyDirectory);
+    QList<PlayHistory::Play> plays;
+    QStringList months;
+    if (!m_historyDirectory.isEmpty()) {
+        for (const PlayEvent& event : std::as_const(m_pending)) {
+            PlayHistory::Play play;
+            play.path = event.path;
+            play.playedAt = event.playedAt;
+            plays.append(play);
+            const QString month = PlayHistory::monthKey(event.playedAt.date());
+            if (!months.contains(month)) {
+                months.append(month);
+            }
+        }
+        if (!history.prepare(months)) {
+            logError("flush", QString("Cannot open the play history in %1, %2 plays not logged")
+                                  .arg(m_historyDirectory)
+                                  .arg(plays.size()));
+            plays.clear();
+        }
+    }
+
+    bool historyFailed = false;
+    int updated = writeBatch(history, plays, historyFailed);
+    if (updated < 0 && historyFailed) {
+        logError("flush", QString("Failed to write the play history, %1 plays not logged")
+                              .arg(plays.size()));
+        updated = writeBatch(history, {}, historyFailed);
+    }
+    if (updated < 0) {
+        dropOverflow();
+        return -1;
+    }
+
+    qDebug() << "PlayHistoryWriter: wrote" << updated << "of" << m_pending.size() << "play events"
+             << "and" << m_pendingAirings.size() << "proofs of play";
+    m_pending.clear();
+    m_pendingAirings.clear();
+    return updated;
+}
+
+int PlayHistoryWriter::writeBatch(PlayHistory& history, const QList<PlayHistory::Play>& plays,
+                                  bool& historyFailed)
+{
+    if (!m_database.transaction()) {
+        logError("flush", QString("Failed to start transaction: %1").arg(m_database.lastError().text()));
+        return -1;
+    }
+
+    // Reported by the caller, which writes the batch again without the history
+    historyFailed = !plays.isEmpty() && !history.append(plays);
+    if (historyFailed) {
+        m_database.rollback();
+        return -1;
+    }
+
+    int updated = 0;
+    QList<int> played;
+    for (const PlayEvent& event : std::as_const(m_pending)) {
+        const int musicId = m_repository.getMusicIdByPath(event.path);
+        if (musicId <= 0) {
+            continue;
+        }
+        if (m_repository.incrementPlayCount(musicId, event.lastPlayed)) {
+            ++updated;
+            if (!played.contains(musicId)) {
+                played.append(musicId);
+            }
+        }
+    }
+
+    if (!m_ranking.refresh(played)) {
+        m_database.rollback();
+        logError("flush", "Failed to refresh the rank scores");
+        return -1;
+    }
+
+    if (!m_proofs.append(m_pendingAirings)) {
+        m_database.rollback();
+        logError("flush", "Failed to write the proofs of play");
+        return -1;
+    }
+
+    if (!m_database.commit()) {
+        logError("flush", QString("Failed to commit: %1").arg(m_database.lastError().text()));
+        m_database.rollback();
+        return -1;
+    }
+    return updated;
+}
+
+void PlayHistoryWriter::dropOverflow()
+{
+    const int plays = m_pending.size() - MAX_QUEUED;
+    if (plays > 0) {
+        m_pending.erase(m_pending.begin(), m_pending.begin() + plays);
+        logError("flush", QString("Dropped the %1 oldest play events").arg(plays));
+    }
+    const int airings = m_pendingAirings.size() - MAX_QUEUED;
+    if (airings > 0) {
+        m_pendingAirings.erase(m_pendingAirings.begin(), m_pendingAirings.begin() + airings);
+        logError("flush", QString("Dropped the %1 oldest proofs of play").arg(airings));
+    }
+}
+
+void PlayHistoryWriter::logError(const QString& operation, const QString& error)
+{
+    qWarning() << QString("PlayHistoryWriter::%1 - %2").arg(operation, error);
+    emit operationError(operation, error);
+}
@@ -0,0 +1,157 @@
+#ifndef PLAYHISTORYWRITER_H
+#define PLAYHISTORYWRITER_H
+
+#include "../repositories/MusicRepository.h"
+#include "../repositories/PlayHistory.h"
+#include "../repositories/ProofOfPlay.h"
+#include "../repositories/TrackRanking.h"
+#include <QDateTime>
+#include <QList>
+#include <QObject>
+#include <QSqlDatabase>
+#include <QString>
+#include <QTimer>
+
+/**
+ * @brief Deferred writer for play counts and last played times
+ *
+ * Marking a song as played used to cost two synchronous UPDATE statements
+ * on the track transition path. PlayHistoryWriter only queues the play
+ * event there; queued events are written later in a single transaction,
+ * resolving each path to its musics.id and updating the row through
+ * MusicRepository::incrementPlayCount(), whose statement stays prepared.
+ *
+ * Events are flushed FLUSH_DELAY_MS after the first one is queued, as soon
+ * as MAX_PENDING events are waiting, or when flush() is called. Pending
+ * events are written when the writer is destroyed.
+ *
+ * Paths that are not in the musics table (jingles, ads, programs) are
+ * skipped silently.
+ *
+ * Each play is also logged to PlayHistory in the same transaction, beside
+ * the database unless setHistoryDirectory() says otherwise, so the as-run
+ * log and the play counts cannot disagree. When the history cannot be
+ * written, the rest of the batch is committed without it and the error is
+ * reported; the play counts are not held back by the as-run log.
+ *
+ * A batch that fails to commit stays queued for the next flush, up to
+ * MAX_QUEUED events of each kind. Beyond that the oldest are dropped, and
+ * reported, so a database that keeps failing cannot grow the queue.
+ *
+ * The rank_score of the tracks played is refreshed in the same
+ * transaction too, see TrackRanking, when the library has one.
+ *
+ * Pubs and programs the scheduler fires are announced with expectAiring().
+ * When one of them has gone off air, recordAiring() queues its proof of
+ * play with the time it started and how long it played, and the batch
+ * writes it through ProofOfPlay along with the plays. An expected item
+ * that has not aired within EXPECTED_AIRING_TTL_S is forgotten.
+ *
+ * @example
+ * @code
+ * PlayHistoryWriter history(db);
+ * history.recordPlay("/music/song.ogg");
+ * // ...
+ * history.flush(); // optional, happens automatically
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class PlayHistoryWriter : public QObject
+{
+    Q_OBJECT
+
+public:
+    /// Format of last_played values written by the player
+    static constexpr const char* LAST_PLAYED_FORMAT = "yyyy-MM-dd || hh:mm:ss";
+    static constexpr int FLUSH_DELAY_MS = 5000;
+    static constexpr int MAX_PENDING = 50;
+    static constexpr int MAX_QUEUED = 20 * MAX_PENDING;
+    static constexpr int EXPECTED_AIRING_TTL_S = 24 * 60 * 60;
+
+    explicit PlayHistoryWriter(QSqlDatabase& database, QObject* parent = nullptr);
+    ~PlayHistoryWriter() override;
+
+    /**
+     * @brief Queue a play event
+     * @param filePath Path of the track that went on air
+     * @param playedAt Time the track was played (defaults to now)
+     */
+    void recordPlay(const QString& filePath, const QDateTime& playedAt = QDateTime::currentDateTime());
+
+    /**
+     * @brief Announce a scheduled item, to be proven when it airs
+     *
+     * Its item id and campaign are looked up now, while the pub of a
+     * one-time rule is still in the table.
+     * @param airing Kind, item id, path and scheduled time of the item
+     */
+    void expectAiring(const ProofOfPlay::Airing& airing);
+
+    /**
+     * @brief Queue the proof of play of an expected item that went off air
+     * @param filePath Path of the track that played
+     * @param startedAt Time it went on air
+     * @param durationMs How long it played
+     * @return true if the track was an expected item
+     */
+    bool recordAiring(const QString& filePath, const QDateTime& startedAt, qint64 durationMs);
+
+    /**
+     * @brief Get the number of scheduled items waiting to air
+     */
+    int expectedCount() const { return m_expected.size(); }
+
+    /**
+     * @brief Write all queued events in one transaction
+     * @return Number of library rows updated, or -1 if the transaction failed
+     */
+    int flush();
+
+    /**
+     * @brief Get the number of events waiting to be written
+     * @return Pending plays and airings
+     */
+    int pendingCount() const { return m_pending.size() + m_pendingAirings.size(); }
+
+    /**
+     * @brief Set where the monthly play history files go
+     * @param directory History directory, PlayHistory::defaultDirectory() by default; empty
+     *        turns the history off
+     */
+    void setHistoryDirectory(const QString& directory) { m_historyDirectory = directory; }
+    QString historyDirectory() const { return m_historyDirectory; }
+
+signals:
+    /**
+     * @brief Emitted when writing the queued events fails
+     * @param operation Name of the operation
+     * @param error Error message
+     */
+    void operationError(const QString& operation, const QString& error);
+
+private:
+    struct PlayEvent {
+        QString path;
+        QDateTime playedAt;
+        QString lastPlayed;
+    };
+
+    int writeBatch(PlayHistory& history, const QList<PlayHistory::Play>& plays,
+                   bool& historyFailed);
+    void dropOverflow();
+    void logError(const QString& operation, const QString& error);
+    void queued();
+
+    QSqlDatabase& m_database;
+    MusicRepository m_repository;
+    TrackRanking m_ranking;
+    ProofOfPlay m_proofs;
+    QList<PlayEvent> m_pending;
+    QList<ProofOfPlay::Airing> m_expected;          ///< Fired, oldest first, not aired yet
+    QList<ProofOfPlay::Airing> m_pendingAirings;
+    QString m_historyDirectory;
+    QTimer m_flushTimer;
+};
+
+#endif // PLAYHISTORYWRITER_H
@@ -0,0 +1,136 @@
+#include "PlaybackClock.h"
+#include <QCoreApplication>
+#include <QPointer>
+#include <QTimer>
+
+namespace {
+
+QString clockString(qint64 totalSeconds)
+{
+    QChar text[24];
+    return QString(text, PlaybackClock::formatClock(totalSeconds, text));
+}
+
+} // namespace
+
+PlaybackClock* PlaybackClock::instance()
+{
+    static QPointer<PlaybackClock> clock;
+    if (!clock) {
+        clock = new PlaybackClock(QCoreApplication::instance());
+    }
+    return clock;
+}
+
+PlaybackClock::PlaybackClock(QObject* parent)
+    : QObject(parent)
+    , m_timer(new QTimer(this))
+{
+    m_timer->setSingleShot(true);
+    m_timer->setInterval(PUBLISH_INTERVAL_MS);
+    connect(m_timer, &QTimer::timeout, this, &PlaybackClock::publish);
+
+    m_time.elapsed = m_time.duration = m_time.remaining = clockString(0);
+    m_time.spokenElapsed = m_time.spokenDuration = m_time.spokenRemaining = formatSpoken(0);
+}
+
+void PlaybackClock::setPosition(qint64 positionMs)
+{
+    m_pendingPosition = positionMs;
+    // Ticks only record the latest value; the timer runs while there is one to publish
+    if (positionMs != m_publishedPosition && !m_timer->isActive()) {
+        m_timer->start();
+    }
+}
+
+void PlaybackClock::setDuration(qint64 durationMs)
+{
+    if (durationMs == m_time.durationMs) {
+        return;
+    }
+    m_time.durationMs = durationMs;
+    m_time.duration = clockString(durationMs / 1000);
+    m_time.spokenDuration = formatSpoken(durationMs);
+    m_durationChanged = true;
+    if (!m_timer->isActive()) {
+        m_timer->start();
+    }
+}
+
+void PlaybackClock::publish()
+{
+    const qint64 position = m_pendingPosition;
+    if (position != m_publishedPosition) {
+        m_publishedPosition = position;
+        m_time.positionMs = position;
+        emit positionChanged(position);
+    }
+
+    // The strings only show whole seconds; rebuild them when that changes
+    const qint64 second = position / 1000;
+    if (second == m_publishedSecond && !m_durationChanged) {
+        return;
+    }
+    m_publishedSecond = second;
+    m_durationChanged = false;
+
+    const qint64 remainingMs = qMax<qint64>(0, m_time.durationMs - position);
+    m_time.elapsed = clockString(second);
+    m_time.remaining = clockString(remainingMs / 1000);
+    m_time.spokenElapsed = formatSpoken(position);
+    m_time.spokenRemaining = formatSpoken(remainingMs);
+    emit timeChanged(m_time);
+}
+
+int PlaybackClock::formatClock(qint64 totalSeconds, QChar* out)
+{
+    if (totalSeconds < 0)
+        totalSeconds = 0;
+
+    const qint64 hours = totalSeconds / 3600;
+    const int minutes = static_cast<int>((totalSeconds % 3600) / 60);
+    const int seconds = static_cast<int>(totalSeconds % 60);
+
+    char digits[20];
+    int hourDigits = 0;
+    qint64 h = hours;
+    do {
+        digits[hourDigits++] = char('0' + h % 10);
+        h /= 10;
+    } while (h > 0);
+
+    int length = 0;
+    if (hourDigits < 2)
+        out[length++] = u'0';
+    while (hourDigits > 0)
+        out[length++] = QLatin1Char(digits[--hourDigits]);
+    out[length++] = u':';
+    out[length++] = QLatin1Char(char('0' + minutes / 10));
+    out[length++] = QLatin1Char(char('0' + minutes % 10));
+    out[length++] = u':';
+    out[length++] = QLatin1Char(char('0' + seconds / 10));
+    out[length++] = QLatin1Char(char('0' + seconds % 10));
+    return length;
+}
+
+QString PlaybackClock::formatSpoken(qint64 milliseconds)
+{
+    if (milliseconds < 0) {
+        return "0:00";
+    }
+
+    int seconds = static_cast<int>(milliseconds / 1000);
+    int minutes = seconds / 60;
+    const int hours = minutes / 60;
+
+    seconds %= 60;
+    minutes %= 60;
+
+    if (hours > 0) {
+        return QString("%1:%2:%3")
+            .arg(hours)
+            .arg(minutes, 2, 10, QChar('0'))
+            .arg(seconds, 2, 10, QChar('0'));
+    }
+    return QString("%1:%2").arg(minutes).arg(seconds, 2, 10, QChar('0'));
+}
@@ -0,0 +1,112 @@
+#ifndef PLAYBACKCLOCK_H
+#define PLAYBACKCLOCK_H
+
+#include <QObject>
+#include <QString>
+
+class QTimer;
+
+/**
+ * @brief The on-air playback position, published at a fixed low rate
+ *
+ * The playback engine reports its position many times a second. The player
+ * window, PlaybackStatusAnnouncer, LiveRegionManager and the braille display
+ * all want that position, and each turned it into a time string of its own.
+ * The player now gives every tick to this clock, and the others subscribe
+ * to it:
+ * - positionChanged() comes at most every PUBLISH_INTERVAL_MS, for sliders
+ *   and waveforms, and not at all while the position stands still;
+ * - timeChanged() comes when the whole second or the duration changes, and
+ *   carries the strings for it, made once for all subscribers.
+ *
+ * The clock lives on the GUI thread.
+ *
+ * @example
+ * @code
+ * connect(PlaybackClock::instance(), &PlaybackClock::timeChanged,
+ *         this, [this](const PlaybackClock::Time& time) { label->setText(time.elapsed); });
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class PlaybackClock : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief One second of playback, in the forms it is shown and spoken
+     */
+    struct Time {
+        qint64 positionMs = 0;
+        qint64 durationMs = 0;
+        QString elapsed;          ///< "HH:MM:SS", as on the player window
+        QString duration;
+        QString remaining;
+        QString spokenElapsed;    ///< "M:SS", or "H:MM:SS" past an hour
+        QString spokenDuration;
+        QString spokenRemaining;
+    };
+
+    static constexpr int PUBLISH_INTERVAL_MS = 100;
+
+    /**
+     * @brief The clock of the application, made on first use; call it first on the GUI thread
+     */
+    static PlaybackClock* instance();
+
+    explicit PlaybackClock(QObject* parent = nullptr);
+
+    /**
+     * @brief Take a position tick; published within PUBLISH_INTERVAL_MS
+     * @param positionMs Position in milliseconds
+     */
+    void setPosition(qint64 positionMs);
+
+    /**
+     * @brief Take the duration of the track now playing
+     * @param durationMs Duration in milliseconds
+     */
+    void setDuration(qint64 durationMs);
+
+    /**
+     * @brief The time as last published
+     */
+    const Time& time() const { return m_time; }
+
+    /**
+     * @brief Write seconds as "HH:MM:SS" without allocating; hours grow past two digits if needed
+     * @param totalSeconds Seconds to write; negative counts as zero
+     * @param out At least 24 QChars
+     * @return The number of QChars written
+     */
+    static int formatClock(qint64 totalSeconds, QChar* out);
+
+    /**
+     * @brief Milliseconds as spoken: "3:45", or "1:23:45" past an hour
+     */
+    static QString formatSpoken(qint64 milliseconds);
+
+signals:
+    /**
+     * @brief Emitted at most every PUBLISH_INTERVAL_MS while the position moves
+     */
+    void positionChanged(qint64 positionMs);
+
+    /**
+     * @brief Emitted when the whole second or the duration changes
+     */
+    void timeChanged(const PlaybackClock::Time& time);
+
+private:
+    void publish();
+
+    QTimer* m_timer;
+    Time m_time;
+    qint64 m_pendingPosition = 0;
+    qint64 m_publishedPosition = -1;
+    qint64 m_publishedSecond = -1;
+    bool m_durationChanged = false;
+};
+
+#endif // PLAYBACKCLOCK_H
@@ -0,0 +1,423 @@
+#include "PlaybackEngine.h"
+#include "CartWall.h"
+#include "CueBus.h"
+#include <QDebug>
+#include <QThread>
+#include <QTimer>
+
+PlaybackEngine::PlaybackEngine(QObject* parent)
+    : PlaybackEngine(0.0, parent)
+{
+}
+
+PlaybackEngine::PlaybackEngine(double headlessSpeed, QObject* parent)
+    : QObject(parent)
+{
+    qRegisterMetaType<DeckMixer::State>("DeckMixer::State");
+
+    m_thread = new QThread(this);
+    m_thread->setObjectName("XFB audio");
+
+    m_prefetcher = std::make_unique<TrackPrefetcher>();
+
+    m_mixer = new DeckMixer();
+    m_mixer->setPrefetcher(m_prefetcher.get());
+    if (headlessSpeed > 0) {
+        m_mixer->setHeadless(headlessSpeed);
+    }
+    m_mixer->moveToThread(m_thread);
+    connect(m_thread, &QThread::started, m_mixer, &DeckMixer::initialize);
+
+    m_cue = new CueBus(m_prefetcher.get());
+    m_cue->moveToThread(m_thread);
+
+    m_statusTimer = new QTimer(this);
+    m_statusTimer->setInterval(STATUS_POLL_MS);
+    connect(m_statusTimer, &QTimer::timeout, this, &PlaybackEngine::pollStatus);
+
+    connect(m_mixer, &DeckMixer::errorOccurred, this, [this](const QString& message) {
+        qWarning() << "PlaybackEngine:" << message;
+        emit errorOccurred(message);
+    });
+
+    connect(m_cue, &CueBus::started, this, [this](const QString& filePath) {
+        m_cueSource = filePath;
+        emit cueStarted(filePath);
+    });
+    connect(m_cue, &CueBus::positionChanged, this, &PlaybackEngine::cuePositionChanged);
+    connect(m_cue, &CueBus::finished, this, [this]() {
+        m_cueSource.clear();
+        emit cueFinished();
+    });
+    connect(m_cue, &CueBus::errorOccurred, this, [this](const QString& message) {
+        qWarning() << "PlaybackEngine: cue:" << message;
+        emit errorOccurred(message);
+    });
+
+    m_thread->start(QThread::TimeCriticalPriority);
+}
+
+PlaybackEngine::~PlaybackEngine()
+{
+    if (m_thread->isRunning()) {
+        QMetaObject::invokeMethod(m_mixer, &DeckMixer::shutdown, Qt::BlockingQueuedConnection);
+        QMetaObject::invokeMethod(m_cue, &CueBus::stop, Qt::BlockingQueuedConnection);
+        m_thread->quit();
+        m_thread->wait();
+    }
+    delete m_cue;
+    delete m_mixer;
+}
+
+void PlaybackEngine::post(DeckMixer::Command command)
+{
+    if (m_mixer->post(std::move(command))) {
+        m_idlePolls = 0;
+        if (!m_statusTimer->isActive()) {
+            m_statusTimer->start();
+        }
+    }
+}
+
+void PlaybackEngine::pollStatus()
+{
+    DeckMixer::Status status;
+    bool any = false;
+    while (m_mixer->takeStatus(status)) {
+        any = true;
+        handleStatus(status);
+    }
+
+    // Nothing reports while the mixer is stopped, unless a command wakes it
+    m_idlePolls = any ? 0 : m_idlePolls + 1;
+    if (m_mixerState == State::Stopped && m_idlePolls >= STATUS_IDLE_POLLS) {
+        m_statusTimer->stop();
+    }
+}
+
+void PlaybackEngine::handleStatus(const DeckMixer::Status& status)
+{
+    using Kind = DeckMixer::Status::Kind;
+
+    switch (status.kind) {
+    case Kind::None:
+        break;
+    case Kind::StateChanged:
+        m_mixerState = status.state;
+        m_state = status.state;
+        if (status.state == State::Stopped) {
+            m_currentSource.clear();
+            m_queuedSource.clear();
+            m_originals.clear();
+        }
+        emit stateChanged(status.state);
+        break;
+    case Kind::PositionChanged:
+        emit positionChanged(status.ms);
+        break;
+    case Kind::DurationChanged:
+        emit durationChanged(status.ms);
+        break;
+    case Kind::TrackStarted: {
+        const QString filePath = m_originals.value(status.filePath, status.filePath);
+        m_currentSource = filePath;
+        if (m_queuedSource == filePath) {
+            m_queuedSource.clear();
+        }
+        for (auto it = m_originals.begin(); it != m_originals.end();) {
+            if (it.value() != m_currentSource && it.value() != m_queuedSource) {
+                it = m_originals.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        emit trackStarted(filePath);
+        break;
+    }
+    case Kind::NextTrackRequested:
+        emit nextTrackRequested();
+        break;
+    case Kind::PlaybackFinished:
+        emit playbackFinished();
+        break;
+    }
+}
+
+void PlaybackEngine::play(const QString& filePath)
+{
+    m_state = State::Playing;
+    m_queuedSource.clear();
+    const CuePoints cue = m_cueProvider ? m_cueProvider(filePath) : CuePoints();
+    const qint64 outMs = mixOutMs(cue);
+    const float gain = m_gainProvider ? m_gainProvider(filePath) : 1.0f;
+    DeckMixer::Command command;
+    command.type = DeckMixer::Command::Type::Play;
+    command.filePath = resolveSource(filePath);
+    command.cueInMs = cue.inMs;
+    command.cueOutMs = outMs;
+    command.gain = gain;
+    post(std::move(command));
+}
+
+void PlaybackEngine::queueNext(const QString& filePath)
+{
+    m_queuedSource = filePath;
+    const CuePoints cue = m_cueProvider ? m_cueProvider(filePath) : CuePoints();
+    const qint64 outMs = mixOutMs(cue);
+    const float gain = m_gainProvider ? m_gainProvider(filePath) : 1.0f;
+    DeckMixer::Command command;
+    command.type = DeckMixer::Command::Type::QueueNext;
+    command.filePath = resolveSource(filePath);
+    command.cueInMs = cue.inMs;
+    command.cueOutMs = outMs;
+    command.gain = gain;
+    post(std::move(command));
+}
+
+void PlaybackEngine::clearNext()
+{
+    m_queuedSource.clear();
+    DeckMixer::Command command;
+    command.type = DeckMixer::Command::Type::ClearNext;
+    post(std::move(command));
+}
+
+void PlaybackEngine::skipToNext()
+{
+    DeckMixer::Command command;
+    command.type = DeckMixer::Command::Type::SkipToNext;
+    post(std::move(command));
+}
+
+void PlaybackEngine::stop()
+{
+    m_state = State::Stopped;
+    m_currentSource.clear();
+    m_queuedSource.clear();
+    m_originals.clear();
+    DeckMixer::Command command;
+    command.type = DeckMixer::Command::Type::Stop;
+    post(std::move(command));
+}
+
+void PlaybackEngine::pause()
+{
+    DeckMixer::Command command;
+    command.type = DeckMixer::Command::Type::Pause;
+    post(std::move(command));
+}
+
+void PlaybackEngine::resume()
+{
+    DeckMixer::Command command;
+    command.type = DeckMixer::Command::Type::Resume;
+    post(std::move(command));
+}
+
+void PlaybackEngine::setPosition(qint64 positionMs)
+{
+    DeckMixer::Command command;
+    command.type = DeckMixer::Command::Type::Seek;
+    command.positionMs = positionMs;
+    post(std::move(command));
+}
+
+qint64 PlaybackEngine::position() const
+{
+    return m_mixer->positionMs();
+}
+
+qint64 PlaybackEngine::duration() const
+{
+    return m_mixer->durationMs();
+}
+
+void PlaybackEngine::setVolume(float volume)
+{
+    m_volume = qBound(0.0f, volume, 1.0f);
+    DeckMixer::Command command;
+    command.type = DeckMixer::Command::Type::Volume;
+    command.gain = m_volume;
+    command.rampMs = DeckMixer::VOLUME_RAMP_MS;
+    post(std::move(command));
+}
+
+void PlaybackEngine::fadeVolume(float volume, int durationMs, float fromVolume)
+{
+    m_volume = qBound(0.0f, volume, 1.0f);
+    DeckMixer::Command command;
+    command.type = DeckMixer::Command::Type::Volume;
+    command.gain = m_volume;
+    command.rampMs = qMax(0, durationMs);
+    command.curve = GainRamp::Curve::Exponential;
+    command.fromGain = fromVolume;
+    post(std::move(command));
+}
+
+void PlaybackEngine::setCrossfadeDuration(int ms)
+{
+    m_mixer->setCrossfadeMs(ms);
+}
+
+qint64 PlaybackEngine::mixOutMs(const CuePoints& cue) const
+{
+    // The mixer starts the crossfade so that it ends with the track; ending
+    // the track one crossfade after its segue point starts it there instead
+    const int crossfade = crossfadeDuration();
+    if (crossfade <= 0 || cue.segueMs <= cue.inMs) {
+        return cue.outMs;
+    }
+    const qint64 segueEnd = cue.segueMs + crossfade;
+    return cue.outMs >= 0 ? qMin(cue.outMs, segueEnd) : segueEnd;
+}
+
+QString PlaybackEngine::resolveSource(const QString& filePath)
+{
+    if (!m_sourceResolver) {
+        return filePath;
+    }
+    const QString deckPath = m_sourceResolver(filePath);
+    if (deckPath.isEmpty() || deckPath == filePath) {
+        return filePath;
+    }
+    m_originals.insert(deckPath, filePath);
+    return deckPath;
+}
+
+int PlaybackEngine::crossfadeDuration() const
+{
+    return m_mixer->crossfadeMs();
+}
+
+void PlaybackEngine::prefetch(const QString& filePath)
+{
+    m_prefetcher->prefetch(filePath);
+}
+
+void PlaybackEngine::setPrefetchSeconds(int seconds)
+{
+    m_prefetcher->setPrefetchSeconds(seconds);
+}
+
+void PlaybackEngine::setOutputDevice(const QString& name)
+{
+    QMetaObject::invokeMethod(
+        m_mixer, [mixer = m_mixer, name]() { mixer->setOutputDevice(name); },
+        Qt::QueuedConnection);
+}
+
+void PlaybackEngine::setNativeOutput(const NativeAudioOutput::Config& config)
+{
+    QMetaObject::invokeMethod(
+        m_mixer, [mixer = m_mixer, config]() { mixer->setNativeOutput(config); },
+        Qt::QueuedConnection);
+}
+
+NativeAudioOutput::Statistics PlaybackEngine::nativeOutputStatistics() const
+{
+    return m_mixer->nativeStatistics();
+}
+
+void PlaybackEngine::setCueDevice(const QString& name)
+{
+    QMetaObject::invokeMethod(
+        m_cue, [cue = m_cue, name]() { cue->setOutputDevice(name); }, Qt::QueuedConnection);
+}
+
+void PlaybackEngine::cue(const QString& filePath, qint64 startMs)
+{
+    if (startMs < 0) {
+        startMs = m_cueProvider ? m_cueProvider(filePath).inMs : 0;
+    }
+    // The original path, which is the one the prefetcher read ahead
+    QMetaObject::invokeMethod(
+        m_cue, [cue = m_cue, filePath, startMs]() { cue->play(filePath, startMs); },
+        Qt::QueuedConnection);
+}
+
+void PlaybackEngine::stopCue()
+{
+    QMetaObject::invokeMethod(m_cue, &CueBus::stop, Qt::QueuedConnection);
+}
+
+void PlaybackEngine::setCueVolume(float volume)
+{
+    m_cue->setVolume(qBound(0.0f, volume, 1.0f));
+}
+
+bool PlaybackEngine::isCueing() const
+{
+    return m_cue->isPlaying();
+}
+
+qint64 PlaybackEngine::cuePosition() const
+{
+    return m_cue->positionMs();
+}
+
+TrackPrefetcher::Statistics PlaybackEngine::prefetchStatistics() const
+{
+    return m_prefetcher->statistics();
+}
+
+qint64 PlaybackEngine::bufferMemoryUsage() const
+{
+    return m_mixer->bufferMemoryUsage() + m_prefetcher->memoryUsage();
+}
+
+void PlaybackEngine::shrinkBuffers(qint64 targetBytes)
+{
+    m_prefetcher->shrink(qMax<qint64>(0, targetBytes - m_mixer->bufferMemoryUsage()));
+}
+
+void PlaybackEngine::setTapEnabled(bool enabled, DeckMixer::Tap tap)
+{
+    m_mixer->setTapEnabled(enabled, tap);
+}
+
+int PlaybackEngine::readTap(float* data, int samples, DeckMixer::Tap tap)
+{
+    return m_mixer->readTap(data, samples, tap);
+}
+
+void PlaybackEngine::setDeadAirDetector(DeadAirDetector* detector)
+{
+    m_mixer->setDeadAirDetector(detector);
+}
+
+void PlaybackEngine::setCartWall(CartWall* carts)
+{
+    m_carts = carts;
+    m_mixer->setCartWall(carts);
+}
+
+void PlaybackEngine::setDucker(MicDucker* ducker)
+{
+    m_mixer->setDucker(ducker);
+}
+
+bool PlaybackEngine::playCart(int slot)
+{
+    if (!m_carts || !m_carts->trigger(slot)) {
+        return false;
+    }
+    DeckMixer::Command command;
+    command.type = DeckMixer::Command::Type::StartCarts;
+    post(std::move(command));
+    return true;
+}
+
+void PlaybackEngine::setRenderTimeHistogram(MetricsRegistry::Histogram* histogram)
+{
+    m_mixer->setRenderTimeHistogram(histogram);
+}
+
+int PlaybackEngine::sampleRate() const
+{
+    return m_mixer->sampleRate();
+}
+
+int PlaybackEngine::bufferFillPercent() const
+{
+    return m_mixer->bufferFillPercent();
+}
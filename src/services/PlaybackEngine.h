@@ -0,0 +1,375 @@
+#ifndef PLAYBACKENGINE_H
+#define PLAYBACKENGINE_H
+
+#include "CuePoints.h"
+#include "DeckMixer.h"
+#include "TrackPrefetcher.h"
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <functional>
+#include <memory>
+
+class CartWall;
+class CueBus;
+class DeadAirDetector;
+class MicDucker;
+class QThread;
+class QTimer;
+
+/**
+ * @brief Gapless dual-deck playback engine with configurable crossfade
+ *
+ * PlaybackEngine replaces the single QMediaPlayer used for on-air playback.
+ * Two decks decode into ring buffers and a DeckMixer running on a dedicated
+ * audio thread mixes them straight into a QAudioSink, so song transitions
+ * no longer wait on a media player tearing down and reopening its source.
+ *
+ * The engine asks for the next item with nextTrackRequested() while the
+ * current one is still playing. Items handed to queueNext() are pre-decoded
+ * and then either spliced in at the last sample of the current track
+ * (crossfade of 0 ms) or mixed over the end of it with an equal-power
+ * crossfade of crossfadeDuration() milliseconds. When nothing was queued
+ * the engine stops and emits playbackFinished().
+ *
+ * prefetch() reads the head of a likely next item into memory as soon as
+ * it is known, so queueing it later does not start with a cold read.
+ *
+ * The engine has two output buses, each routed to a device of its own:
+ * the program bus that goes to air, and a cue bus for pre-listening a
+ * track, typically the next one, in the headphones while another airs.
+ * The cue bus reads from the same prefetched copy of a file as the deck
+ * that airs it later; see CueBus.
+ *
+ * When a cue provider is set, play() and queueNext() ask it for the cue
+ * points of each file, so tracks start at their first audible sample and
+ * hand over at the end of their audio instead of after trailing silence.
+ * With a crossfade set, a track with a segue point is mixed into the next
+ * one from that point, and what is left of its fade plays under it.
+ * A gain provider likewise gives each file its own gain, for loudness
+ * normalization.
+ *
+ * All methods must be called from the thread that owns the engine; they
+ * are forwarded to the audio thread asynchronously and in order. The
+ * transport goes through the mixer's lock-free command queue, and the
+ * engine collects what the mixer reports every STATUS_POLL_MS while it has
+ * something to report, re-emitting it as the signals below.
+ *
+ * @example
+ * @code
+ * PlaybackEngine* engine = new PlaybackEngine(this);
+ * engine->setCrossfadeDuration(3000);
+ * connect(engine, &PlaybackEngine::nextTrackRequested, this, [=]() {
+ *     engine->queueNext(nextFileInPlaylist());
+ * });
+ * engine->play("/music/first.ogg");
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class PlaybackEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    using State = DeckMixer::State;
+
+    /// Cue points of a file; the default CuePoints plays all of it
+    using CueProvider = std::function<CuePoints(const QString& filePath)>;
+
+    /// Linear gain of a file; 1.0 plays it unchanged
+    using GainProvider = std::function<float(const QString& filePath)>;
+
+    /// File the decks should open for a track; the track's own path plays it as it is
+    using SourceResolver = std::function<QString(const QString& filePath)>;
+
+    explicit PlaybackEngine(QObject* parent = nullptr);
+
+    /**
+     * @brief Create an engine that renders without a sound card
+     *
+     * See DeckMixer::setHeadless(); the output can still be read from the taps.
+     * @param headlessSpeed How many times faster than real time to render;
+     *        0 plays to the default audio device like the other constructor
+     * @param parent Parent object
+     */
+    explicit PlaybackEngine(double headlessSpeed, QObject* parent = nullptr);
+    ~PlaybackEngine() override;
+
+    /**
+     * @brief Start playing a file immediately, replacing anything on air
+     * @param filePath Path of the audio file
+     */
+    void play(const QString& filePath);
+
+    /**
+     * @brief Pre-decode the item that should follow the current one
+     * @param filePath Path of the audio file
+     */
+    void queueNext(const QString& filePath);
+
+    /**
+     * @brief Drop the queued item so playback stops after the current one
+     */
+    void clearNext();
+
+    /**
+     * @brief Start the transition to the queued item now
+     *
+     * Stops playback and emits playbackFinished() if nothing is queued.
+     */
+    void skipToNext();
+
+    void stop();
+    void pause();
+    void resume();
+
+    /**
+     * @brief Seek within the current track
+     * @param positionMs Position in milliseconds
+     */
+    void setPosition(qint64 positionMs);
+
+    qint64 position() const;
+    qint64 duration() const;
+
+    /**
+     * @brief Set the output gain
+     *
+     * The gain moves to the new value over DeckMixer::VOLUME_RAMP_MS on
+     * the audio thread rather than jumping, so dragging a slider is
+     * click-free.
+     * @param volume Linear gain, 0.0 to 1.0
+     */
+    void setVolume(float volume);
+
+    /**
+     * @brief Fade the output gain, evenly in decibels
+     * @param volume Linear gain to end on, 0.0 to 1.0
+     * @param durationMs Length of the fade
+     * @param fromVolume Gain to start from, or -1 to start from the current one
+     */
+    void fadeVolume(float volume, int durationMs, float fromVolume = -1.0f);
+
+    /**
+     * @brief Gain the output is at, or fading to
+     */
+    float volume() const { return m_volume; }
+
+    /**
+     * @brief Set the length of the crossfade between tracks
+     * @param ms Crossfade length in milliseconds; 0 splices tracks gaplessly
+     */
+    void setCrossfadeDuration(int ms);
+    int crossfadeDuration() const;
+
+    /**
+     * @brief Set where play() and queueNext() look up cue points
+     * @param provider Called on the engine's thread; an empty provider plays whole files
+     */
+    void setCueProvider(CueProvider provider) { m_cueProvider = std::move(provider); }
+
+    /**
+     * @brief Set where play() and queueNext() look up each file's gain
+     *
+     * Takes effect from the next track; the one on air keeps its gain.
+     * @param provider Called on the engine's thread; an empty provider plays files unchanged
+     */
+    void setGainProvider(GainProvider provider) { m_gainProvider = std::move(provider); }
+
+    /**
+     * @brief Set which file play() and queueNext() hand to the decks
+     *
+     * Cue points, gain, trackStarted() and currentSource() still use the
+     * track's own path.
+     * @param resolver Called on the engine's thread; an empty resolver plays every path as it is
+     */
+    void setSourceResolver(SourceResolver resolver) { m_sourceResolver = std::move(resolver); }
+
+    /**
+     * @brief Read the start of a file ahead of queueing it
+     * @param filePath Path of the audio file expected to play next
+     */
+    void prefetch(const QString& filePath);
+
+    /**
+     * @brief Set how many seconds of each file prefetch() reads
+     */
+    void setPrefetchSeconds(int seconds);
+
+    /**
+     * @brief Route the program output, what goes to air, to a device
+     * @param name Id or description of the device; empty for the default
+     */
+    void setOutputDevice(const QString& name);
+
+    /**
+     * @brief Play the program output through a native device; see DeckMixer::setNativeOutput()
+     * @param config Device and period sizes; no periods or no device for Qt's output
+     */
+    void setNativeOutput(const NativeAudioOutput::Config& config);
+
+    /**
+     * @brief Get the xruns and latency of the native output, zero sizes while there is none
+     */
+    NativeAudioOutput::Statistics nativeOutputStatistics() const;
+
+    /**
+     * @brief Route the cue output, for pre-listening, to a device
+     * @param name Id or description of the device; empty for the default
+     */
+    void setCueDevice(const QString& name);
+
+    /**
+     * @brief Pre-listen a file on the cue output, replacing what it was playing
+     * @param filePath Path of the audio file
+     * @param startMs Where to start, in milliseconds; -1 for the cue-in point of the file
+     */
+    void cue(const QString& filePath, qint64 startMs = -1);
+    void stopCue();
+    void setCueVolume(float volume);
+    bool isCueing() const;
+    qint64 cuePosition() const;
+    QString cueSource() const { return m_cueSource; }
+
+    /**
+     * @brief Get prefetch hit/miss counters
+     */
+    TrackPrefetcher::Statistics prefetchStatistics() const;
+
+    /**
+     * @brief Get the bytes of the audio buffers: deck rings, output taps and prefetched heads
+     */
+    qint64 bufferMemoryUsage() const;
+
+    /**
+     * @brief Drop prefetched heads until the audio buffers hold at most the given bytes
+     *
+     * The rings and taps are fixed while playing; a dropped prefetch only
+     * means the next load reads the file cold.
+     */
+    void shrinkBuffers(qint64 targetBytes);
+
+    /**
+     * @brief Start or stop copying the mixed output for an encoder
+     * @param enabled true to copy
+     * @param tap Copy to switch; each is read independently
+     */
+    void setTapEnabled(bool enabled, DeckMixer::Tap tap = DeckMixer::Tap::Stream);
+
+    /**
+     * @brief Take copied output; unlike the other methods this reads directly
+     * @param data Destination for interleaved stereo float samples
+     * @param samples Maximum number of samples to read
+     * @param tap Copy to read
+     * @return Number of samples read
+     */
+    int readTap(float* data, int samples, DeckMixer::Tap tap = DeckMixer::Tap::Stream);
+
+    /**
+     * @brief Measure the mixed output for dead air
+     * @param detector Detector, or null for none; unset it before deleting it
+     */
+    void setDeadAirDetector(DeadAirDetector* detector);
+
+    /**
+     * @brief Play the carts of a wall over the decks
+     * @param carts Wall, or null for none; unset it before deleting it
+     */
+    void setCartWall(CartWall* carts);
+
+    /**
+     * @brief Turn the music down while the presenter speaks
+     * @param ducker Ducker, or null for none; unset it before deleting it
+     */
+    void setDucker(MicDucker* ducker);
+
+    /**
+     * @brief Fire a cart of the wall set with setCartWall()
+     *
+     * The cart plays over whatever is on air, and on its own when nothing is.
+     * @param slot Slot of the cart
+     * @return false if no wall is set or the slot is empty
+     */
+    bool playCart(int slot);
+
+    /**
+     * @brief Time each block the mixer renders
+     * @param histogram Histogram of render times in microseconds, or null for none
+     */
+    void setRenderTimeHistogram(MetricsRegistry::Histogram* histogram);
+
+    /**
+     * @brief Get the rate the mixer runs at
+     * @return Rate in Hz, 0 until the audio thread has started
+     */
+    int sampleRate() const;
+
+    /**
+     * @brief Get how full the buffer of the track on air is
+     * @return Percent, or -1 while nothing plays; see DeckMixer::bufferFillPercent()
+     */
+    int bufferFillPercent() const;
+
+    State state() const { return m_state; }
+    QString currentSource() const { return m_currentSource; }
+    QString queuedSource() const { return m_queuedSource; }
+    bool hasQueuedTrack() const { return !m_queuedSource.isEmpty(); }
+
+signals:
+    void stateChanged(DeckMixer::State state);
+    void positionChanged(qint64 positionMs);
+    void durationChanged(qint64 durationMs);
+
+    /**
+     * @brief Emitted when a track goes on air (at the start of its crossfade)
+     * @param filePath Path of the track
+     */
+    void trackStarted(const QString& filePath);
+
+    /**
+     * @brief Emitted once per track when the next item should be queued
+     */
+    void nextTrackRequested();
+
+    /**
+     * @brief Emitted when the last track ended with nothing queued after it
+     */
+    void playbackFinished();
+
+    void errorOccurred(const QString& message);
+
+    void cueStarted(const QString& filePath);
+    void cuePositionChanged(qint64 positionMs);
+    void cueFinished();
+
+private:
+    void post(DeckMixer::Command command);
+    void pollStatus();
+    void handleStatus(const DeckMixer::Status& status);
+    qint64 mixOutMs(const CuePoints& cue) const;
+
+    static constexpr int STATUS_POLL_MS = 20;
+    static constexpr int STATUS_IDLE_POLLS = 50;   ///< Empty polls after a stop before resting
+    QString resolveSource(const QString& filePath);
+
+    QThread* m_thread = nullptr;
+    DeckMixer* m_mixer = nullptr;
+    CueBus* m_cue = nullptr;
+    QTimer* m_statusTimer = nullptr;
+    State m_mixerState = State::Stopped;   ///< As last reported by the mixer
+    int m_idlePolls = 0;
+    float m_volume = 1.0f;
+    std::unique_ptr<TrackPrefetcher> m_prefetcher;
+    CartWall* m_carts = nullptr;
+    CueProvider m_cueProvider;
+    GainProvider m_gainProvider;
+    SourceResolver m_sourceResolver;
+    QHash<QString, QString> m_originals;   ///< Track paths by the file the decks opened
+    State m_state = State::Stopped;
+    QString m_currentSource;
+    QString m_queuedSource;
+    QString m_cueSource;
+};
+
+#endif // PLAYBACKENGINE_H
@@ -20,8 +20,6 @@ PlaybackStatusAnnouncer::PlaybackStatusAnnouncer(QObject* parent)
     , m_playerInstance(nullptr)
     , m_mediaPlayer(nullptr)
     , m_currentState(QMediaPlayer::StoppedState)
-    , m_currentPosition(0)
-    , m_currentDuration(0)
     , m_currentVerbosityLevel(1)
     , m_timeUpdateTimer(nullptr)
     , m_countdownTimer(nullptr)
@@ -72,6 +70,8 @@ bool PlaybackStatusAnnouncer::doInitialize()
         
         // Initialize playback monitoring
         initializePlaybackMonitoring();
+        connect(PlaybackClock::instance(), &PlaybackClock::timeChanged,
+                this, &PlaybackStatusAnnouncer::onPlaybackTimeChanged);
         
         // Connect to accessibility manager signals
         connect(m_accessibilityManager, &AccessibilityManager::accessibilityStateChanged,
@@ -113,6 +113,7 @@ void PlaybackStatusAnnouncer::doShutdown()
     
     // Shutdown playback monitoring
     shutdownPlaybackMonitoring();
+    disconnect(PlaybackClock::instance(), nullptr, this, nullptr);
     
     // Reset service dependencies
     m_liveRegionManager = nullptr;
@@ -198,8 +199,6 @@ void PlaybackStatusAnnouncer::disconnectFromPlayer()
     // Reset current state
     m_currentState = QMediaPlayer::StoppedState;
     m_currentMedia = QUrl();
-    m_currentPosition = 0;
-    m_currentDuration = 0;
     m_currentTrackInfo = TrackInfo();
     
     qDebug() << "PlaybackStatusAnnouncer: Disconnected from player";
@@ -246,10 +245,11 @@ void PlaybackStatusAnnouncer::announceCurrentTime(bool includeRemaining)
     QString timeInfo = getCurrentTimeInfo(includeRemaining);
     
     if (!timeInfo.isEmpty()) {
+        const PlaybackClock::Time& time = PlaybackClock::instance()->time();
         m_liveRegionManager->announceTimeUpdate(
-            formatTime(m_currentPosition),
-            formatTime(m_currentDuration),
-            includeRemaining ? formatTime(m_currentDuration - m_currentPosition) : QString()
+            time.spokenElapsed,
+            time.spokenDuration,
+            includeRemaining ? time.spokenRemaining : QString()
         );
         
         emit timeInfoAnnounced(timeInfo);
@@ -349,7 +349,8 @@ QString PlaybackStatusAnnouncer::getCurrentTrackInfo() const
 
 QString PlaybackStatusAnnouncer::getCurrentTimeInfo(bool includeRemaining) const
 {
-    return formatTimeAnnouncement(m_currentPosition, m_currentDuration, includeRemaining, m_currentVerbosityLevel);
+    return formatTimeAnnouncement(PlaybackClock::instance()->time(), includeRemaining,
+                                  m_currentVerbosityLevel);
 }
 
 void PlaybackStatusAnnouncer::onAccessibilityStateChanged(bool enabled)
@@ -452,21 +453,14 @@ void PlaybackStatusAnnouncer::onMediaChanged(const QUrl& media)
     }
 }
 
-void PlaybackStatusAnnouncer::onPositionChanged(qint64 position)
+void PlaybackStatusAnnouncer::onPlaybackTimeChanged(const PlaybackClock::Time& time)
 {
-    m_currentPosition = position;
-    
     // No automatic announcements for position changes to avoid spam
     // Time announcements are handled by timer or manual requests
-}
-
-void PlaybackStatusAnnouncer::onDurationChanged(qint64 duration)
-{
-    m_currentDuration = duration;
     
     // Update track info with duration if not already set
-    if (m_currentTrackInfo.duration.isEmpty() && duration > 0) {
-        m_currentTrackInfo.duration = formatTime(duration);
+    if (m_currentTrackInfo.duration.isEmpty() && time.durationMs > 0) {
+        m_currentTrackInfo.duration = time.spokenDuration;
     }
 }
 
@@ -638,15 +632,17 @@ QString PlaybackStatusAnnouncer::formatPlaybackStateAnnouncement(QMediaPlayer::P
     return stateString;
 }
 
-QString PlaybackStatusAnnouncer::formatTimeAnnouncement(qint64 currentMs, qint64 totalMs, bool includeRemaining, int verbosityLevel) const
+QString PlaybackStatusAnnouncer::formatTimeAnnouncement(const PlaybackClock::Time& time,
+                                                        bool includeRemaining,
+                                                        int verbosityLevel) const
 {
-    if (currentMs < 0 || totalMs <= 0) {
+    if (time.positionMs < 0 || time.durationMs <= 0) {
         return "Time information not available";
     }
     
     QString announcement;
-    QString currentTime = formatTime(currentMs);
-    QString totalTime = formatTime(totalMs);
+    const QString& currentTime = time.spokenElapsed;
+    const QString& totalTime = time.spokenDuration;
     
     switch (verbosityLevel) {
         case 0: // Terse
@@ -660,8 +656,7 @@ QString PlaybackStatusAnnouncer::formatTimeAnnouncement(qint64 currentMs, qint64
         case 2: // Verbose
             announcement = "Current time: " + currentTime + " of " + totalTime;
             if (includeRemaining && m_config.announceRemainingTime) {
-                QString remainingTime = formatTime(totalMs - currentMs);
-                announcement += ", " + remainingTime + " remaining";
+                announcement += ", " + time.spokenRemaining + " remaining";
             }
             break;
     }
@@ -669,31 +664,6 @@ QString PlaybackStatusAnnouncer::formatTimeAnnouncement(qint64 currentMs, qint64
     return announcement;
 }
 
-QString PlaybackStatusAnnouncer::formatTime(qint64 milliseconds) const
-{
-    if (milliseconds < 0) {
-        return "0:00";
-    }
-    
-    int seconds = static_cast<int>(milliseconds / 1000);
-    int minutes = seconds / 60;
-    int hours = minutes / 60;
-    
-    seconds %= 60;
-    minutes %= 60;
-    
-    if (hours > 0) {
-        return QString("%1:%2:%3")
-            .arg(hours)
-            .arg(minutes, 2, 10, QChar('0'))
-            .arg(seconds, 2, 10, QChar('0'));
-    } else {
-        return QString("%1:%2")
-            .arg(minutes)
-            .arg(seconds, 2, 10, QChar('0'));
-    }
-}
-
 int PlaybackStatusAnnouncer::getCountdownSecondsRemaining() const
 {
     if (!m_countdownActive) {
@@ -2,6 +2,7 @@
 #define PLAYBACKSTATUSANNOUNCER_H
 
 #include "BaseService.h"
+#include "PlaybackClock.h"
 #include <QObject>
 #include <QTimer>
 #include <QtMultimedia/QMediaPlayer>
@@ -22,6 +23,7 @@ class player;
  * 
  * This service monitors the player state and provides appropriate announcements
  * based on the current accessibility verbosity level and user preferences.
+ * The position and its time strings come from PlaybackClock.
  * 
  * @example
  * @code
@@ -206,16 +208,10 @@ private slots:
     void onMediaChanged(const QUrl& media);
 
     /**
-     * @brief Handle position changes
-     * @param position New position in milliseconds
+     * @brief Handle a new second, or duration, from the playback clock
+     * @param time The published time
      */
-    void onPositionChanged(qint64 position);
-
-    /**
-     * @brief Handle duration changes
-     * @param duration New duration in milliseconds
-     */
-    void onDurationChanged(qint64 duration);
+    void onPlaybackTimeChanged(const PlaybackClock::Time& time);
 
     /**
      * @brief Handle automatic time updates
@@ -285,20 +281,13 @@ private:
 
     /**
      * @brief Format time information for announcement
-     * @param currentMs Current position in milliseconds
-     * @param totalMs Total duration in milliseconds
+     * @param time Time from the playback clock
      * @param includeRemaining Whether to include remaining time
      * @param verbosityLevel Current verbosity level
      * @return Formatted time announcement string
      */
-    QString formatTimeAnnouncement(qint64 currentMs, qint64 totalMs, bool includeRemaining, int verbosityLevel) const;
-
-    /**
-     * @brief Convert milliseconds to readable time string
-     * @param milliseconds Time in milliseconds
-     * @return Formatted time string (e.g., "3:45", "1:23:45")
-     */
-    QString formatTime(qint64 milliseconds) const;
+    QString formatTimeAnnouncement(const PlaybackClock::Time& time, bool includeRemaining,
+                                   int verbosityLevel) const;
 
     /**
      * @brief Calculate remaining time for countdown
@@ -342,8 +331,6 @@ private:
     // Current state tracking
     QMediaPlayer::PlaybackState m_currentState;
     QUrl m_currentMedia;
-    qint64 m_currentPosition;
-    qint64 m_currentDuration;
     TrackInfo m_currentTrackInfo;
     int m_currentVerbosityLevel;
     
@@ -422,39 +422,9 @@ void PlayerKeyboardNavigationEnhancer::onShortcutTriggered(const QString& action
 {
     Q_UNUSED(sequence)
     
-    // Handle player-specific shortcuts
-    if (action == "play_pause") {
-        onPlayPauseShortcut();
-    } else if (action == "stop") {
-        onStopShortcut();
-    } else if (action == "next_track" || action == "next_track_legacy") {
-        onNextTrackShortcut();
-    } else if (action == "previous_track" || action == "previous_track_legacy") {
-        onPreviousTrackShortcut();
-    } else if (action == "volume_up" || action == "volume_up_legacy") {
-        onVolumeUpShortcut();
-    } else if (action == "volume_down" || action == "volume_down_legacy") {
-        onVolumeDownShortcut();
-    } else if (action == "volume_up_fine") {
-        onVolumeUpFineShortcut();
-    } else if (action == "volume_down_fine") {
-        onVolumeDownFineShortcut();
-    } else if (action == "mute" || action == "mute_legacy") {
-        onMuteShortcut();
-    } else if (action == "reset_volume") {
-        onResetVolumeShortcut();
-    } else if (action == "fast_forward") {
-        onFastForwardShortcut();
-    } else if (action == "rewind") {
-        onRewindShortcut();
-    } else if (action == "current_time") {
-        onCurrentTimeShortcut();
-    } else if (action == "remaining_time") {
-        onRemainingTimeShortcut();
-    } else if (action == "total_duration") {
-        onTotalDurationShortcut();
-    } else if (action == "track_info") {
-        onTrackInfoShortcut();
+    // Handle player-specific shortcuts; the others are not in the table
+    if (const auto handler = m_shortcutHandlers.value(action)) {
+        (this->*handler)();
     }
 }
 
@@ -492,6 +462,32 @@ void PlayerKeyboardNavigationEnhancer::setupPlayerShortcuts()
         return;
     }
     
+    // Actions this enhancer handles, so that a shortcut costs one lookup
+    using Enhancer = PlayerKeyboardNavigationEnhancer;
+    m_shortcutHandlers = {
+        {"play_pause", &Enhancer::onPlayPauseShortcut},
+        {"stop", &Enhancer::onStopShortcut},
+        {"next_track", &Enhancer::onNextTrackShortcut},
+        {"next_track_legacy", &Enhancer::onNextTrackShortcut},
+        {"previous_track", &Enhancer::onPreviousTrackShortcut},
+        {"previous_track_legacy", &Enhancer::onPreviousTrackShortcut},
+        {"volume_up", &Enhancer::onVolumeUpShortcut},
+        {"volume_up_legacy", &Enhancer::onVolumeUpShortcut},
+        {"volume_down", &Enhancer::onVolumeDownShortcut},
+        {"volume_down_legacy", &Enhancer::onVolumeDownShortcut},
+        {"volume_up_fine", &Enhancer::onVolumeUpFineShortcut},
+        {"volume_down_fine", &Enhancer::onVolumeDownFineShortcut},
+        {"mute", &Enhancer::onMuteShortcut},
+        {"mute_legacy", &Enhancer::onMuteShortcut},
+        {"reset_volume", &Enhancer::onResetVolumeShortcut},
+        {"fast_forward", &Enhancer::onFastForwardShortcut},
+        {"rewind", &Enhancer::onRewindShortcut},
+        {"current_time", &Enhancer::onCurrentTimeShortcut},
+        {"remaining_time", &Enhancer::onRemainingTimeShortcut},
+        {"total_duration", &Enhancer::onTotalDurationShortcut},
+        {"track_info", &Enhancer::onTrackInfoShortcut},
+    };
+    
     // Register player-specific shortcuts (these override the default ones with player context)
     m_navigationController->registerKeyboardShortcut(
         "play_pause", QKeySequence(Qt::Key_Space), 
@@ -1,6 +1,7 @@
 #ifndef PLAYERKEYBOARDNAVIGATIONENHANCER_H
 #define PLAYERKEYBOARDNAVIGATIONENHANCER_H
 
+#include <QHash>
 #include <QObject>
 #include <QWidget>
 #include <QKeyEvent>
@@ -251,6 +252,9 @@ private:
     QSlider* m_progressSlider;
     QTableView* m_musicView;
     QListWidget* m_playlistView;
+    
+    // Shortcut actions handled here, by action identifier
+    QHash<QString, void (PlayerKeyboardNavigationEnhancer::*)()> m_shortcutHandlers;
 };
 
 #endif // PLAYERKEYBOARDNAVIGATIONENHANCER_H
\ No newline at end of file
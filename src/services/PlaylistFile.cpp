@@ -0,0 +1,180 @@
+#include "PlaylistFile.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QObject>
+#include <QSaveFile>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+
+namespace {
+
+const char* const XML_ROOT = "XFBPlaylist";
+const char* const XML_GROUP = "www.netpack.pt";
+const char* const XML_TRACK = "track";
+
+// Skips a UTF-8 byte order mark and leading blanks to tell XML from M3U
+bool looksLikeXml(QFile& file)
+{
+    QByteArray head = file.peek(256);
+    if (head.startsWith("\xEF\xBB\xBF")) {
+        head.remove(0, 3);
+    }
+    return head.trimmed().startsWith('<');
+}
+
+std::vector<PlaylistFile::Track> readXml(QFile& file, QString* error)
+{
+    std::vector<PlaylistFile::Track> tracks;
+    QXmlStreamReader xml(&file);
+    if (!xml.readNextStartElement() || xml.name() != QLatin1String(XML_ROOT)) {
+        if (error) {
+            *error = QObject::tr("Not an XFB playlist file");
+        }
+        return tracks;
+    }
+
+    while (!xml.atEnd()) {
+        if (xml.readNext() == QXmlStreamReader::StartElement
+            && xml.name() == QLatin1String(XML_TRACK)) {
+            PlaylistFile::Track track;
+            track.path = xml.readElementText().trimmed();
+            if (!xml.hasError() && !track.path.isEmpty()) {
+                tracks.push_back(track);
+            }
+        }
+    }
+    if (xml.hasError() && error) {
+        *error = QObject::tr("Line %1: %2").arg(xml.lineNumber()).arg(xml.errorString());
+    }
+    return tracks;
+}
+
+std::vector<PlaylistFile::Track> readM3u(QFile& file, const QDir& base)
+{
+    std::vector<PlaylistFile::Track> tracks;
+    PlaylistFile::Track next;
+    const QLatin1String trackTag(PlaylistFile::TRACK_TAG);
+
+    while (!file.atEnd()) {
+        QString line = QString::fromUtf8(file.readLine()).trimmed();
+        if (line.startsWith(QChar(0xFEFF))) {
+            line.remove(0, 1);
+        }
+        if (line.isEmpty()) {
+            continue;
+        }
+
+        if (line.startsWith(trackTag)) {
+            const QStringList fields = line.mid(trackTag.size()).split(',');
+            for (const QString& field : fields) {
+                const QString key = field.section('=', 0, 0).trimmed();
+                bool ok = false;
+                const qint64 value = field.section('=', 1).trimmed().toLongLong(&ok);
+                if (!ok) {
+                    continue;
+                }
+                if (key == QLatin1String("id")) {
+                    next.musicId = value;
+                } else if (key == QLatin1String("duration-us")) {
+                    next.durationUs = value;
+                }
+            }
+        } else if (line.startsWith(QLatin1String("#EXTINF:"))) {
+            // Whole seconds only; an XFB line, if any, has the exact value
+            bool ok = false;
+            const qint64 seconds = line.mid(8).section(',', 0, 0).trimmed().toLongLong(&ok);
+            if (ok && seconds >= 0 && next.durationUs < 0) {
+                next.durationUs = seconds * 1000000;
+            }
+        } else if (!line.startsWith('#')) {
+            next.path = QDir::isRelativePath(line) ? QDir::cleanPath(base.filePath(line)) : line;
+            tracks.push_back(next);
+            next = PlaylistFile::Track();
+        }
+    }
+    return tracks;
+}
+
+void writeM3u(QIODevice& device, const std::vector<PlaylistFile::Track>& tracks)
+{
+    QByteArray out;
+    out.reserve(int(tracks.size()) * 128 + 16);
+    out += PlaylistFile::M3U_HEADER;
+    out += '\n';
+    for (const PlaylistFile::Track& track : tracks) {
+        const qint64 seconds = track.durationUs < 0 ? -1 : (track.durationUs + 500000) / 1000000;
+        out += "#EXTINF:" + QByteArray::number(seconds) + ','
+               + QFileInfo(track.path).completeBaseName().toUtf8() + '\n';
+        out += PlaylistFile::TRACK_TAG;
+        out += "id=" + QByteArray::number(track.musicId)
+               + ",duration-us=" + QByteArray::number(track.durationUs) + '\n';
+        out += track.path.toUtf8() + '\n';
+    }
+    device.write(out);
+}
+
+void writeXml(QIODevice& device, const std::vector<PlaylistFile::Track>& tracks)
+{
+    QXmlStreamWriter xml(&device);
+    xml.setAutoFormatting(true);
+    xml.writeStartDocument();
+    xml.writeStartElement(XML_ROOT);
+    xml.writeStartElement(XML_GROUP);
+    for (const PlaylistFile::Track& track : tracks) {
+        xml.writeTextElement(XML_TRACK, track.path);
+    }
+    xml.writeEndElement();
+    xml.writeEndElement();
+    xml.writeEndDocument();
+}
+
+} // namespace
+
+PlaylistFile::Format PlaylistFile::formatFor(const QString& fileName)
+{
+    return fileName.endsWith(QLatin1String(".xml"), Qt::CaseInsensitive) ? Format::Xml
+                                                                         : Format::M3U8;
+}
+
+std::vector<PlaylistFile::Track> PlaylistFile::load(const QString& fileName, QString* error)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return {};
+    }
+
+    if (looksLikeXml(file)) {
+        return readXml(file, error);
+    }
+    return readM3u(file, QFileInfo(fileName).absoluteDir());
+}
+
+bool PlaylistFile::save(const QString& fileName, const std::vector<Track>& tracks,
+                        QString* error)
+{
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+
+    if (formatFor(fileName) == Format::Xml) {
+        writeXml(file, tracks);
+    } else {
+        writeM3u(file, tracks);
+    }
+
+    if (!file.commit()) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+    return true;
+}
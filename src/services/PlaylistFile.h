@@ -0,0 +1,83 @@
+#ifndef PLAYLISTFILE_H
+#define PLAYLISTFILE_H
+
+#include <QString>
+#include <QtGlobal>
+#include <vector>
+
+/**
+ * @brief Reads and writes saved playlists
+ *
+ * Playlists used to be saved as XML holding only the path of each track,
+ * so loading one looked every track up again. They are now saved as
+ * extended M3U in UTF-8, which other players read too, with what XFB
+ * already knows about each track on a line of its own:
+ *
+ * @code
+ * #EXTM3U
+ * #EXTINF:183,song
+ * #XFB-TRACK:id=42,duration-us=183456000
+ * /music/song.ogg
+ * @endcode
+ *
+ * Unknown values are -1 and are looked up again on load. Readers that do
+ * not know the XFB line skip it as a comment. Relative paths are taken as
+ * relative to the playlist file.
+ *
+ * Files are read line by line, or element by element for the XML playlists
+ * of earlier versions, and come back as one list for the queue to insert
+ * at once.
+ *
+ * @example
+ * @code
+ * QString error;
+ * const std::vector<PlaylistFile::Track> tracks = PlaylistFile::load(fileName, &error);
+ * if (!error.isEmpty()) {
+ *     QMessageBox::warning(this, tr("Load playlist"), error);
+ * }
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class PlaylistFile
+{
+public:
+    struct Track {
+        QString path;
+        qint64 musicId = -1;      ///< Id in the musics table, -1 if unknown
+        qint64 durationUs = -1;   ///< -1 if unknown
+    };
+
+    enum class Format {
+        M3U8,
+        Xml   ///< XFBPlaylist documents of XFB 1.x
+    };
+
+    static constexpr const char* M3U_HEADER = "#EXTM3U";
+    static constexpr const char* TRACK_TAG = "#XFB-TRACK:";
+
+    /**
+     * @brief Tell the format of a playlist from its file name; M3U8 unless it ends in .xml
+     */
+    static Format formatFor(const QString& fileName);
+
+    /**
+     * @brief Read a playlist of either format
+     * @param fileName Playlist to read
+     * @param error Set to the reason if the file cannot be read, or is not a playlist
+     * @return The tracks read, in order; those before an error in an XML file are kept
+     */
+    static std::vector<Track> load(const QString& fileName, QString* error = nullptr);
+
+    /**
+     * @brief Write a playlist in the format its file name asks for
+     * @param fileName Playlist to write; replaced only on success
+     * @param tracks Tracks in order
+     * @param error Set to the reason on failure, if given
+     * @return true if the playlist was written
+     */
+    static bool save(const QString& fileName, const std::vector<Track>& tracks,
+                     QString* error = nullptr);
+};
+
+#endif // PLAYLISTFILE_H
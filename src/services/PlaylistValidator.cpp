@@ -0,0 +1,211 @@
+#include "PlaylistValidator.h"
+#include "MediaProbe.h"
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QThread>
+#include <QTimer>
+#include <QtConcurrent/QtConcurrent>
+
+PlaylistValidator::PlaylistValidator(PlaylistQueueModel* queue, QObject* parent)
+    : QObject(parent)
+    , m_queue(queue)
+    , m_soon(new QTimer(this))
+    , m_recheck(new QTimer(this))
+    , m_checker(&PlaylistValidator::check)
+{
+    qRegisterMetaType<PlaylistValidator::Problem>("PlaylistValidator::Problem");
+
+    // One file at a time is plenty for a few entries, and keeps the disk free for the deck
+    m_pool.setThreadPriority(QThread::LowPriority);
+    m_pool.setMaxThreadCount(1);
+
+    m_soon->setSingleShot(true);
+    m_soon->setInterval(0);
+    connect(m_soon, &QTimer::timeout, this, &PlaylistValidator::validate);
+    m_recheck->setInterval(m_recheckIntervalMs);
+    connect(m_recheck, &QTimer::timeout, this, &PlaylistValidator::validate);
+    m_recheck->start();
+
+    if (m_queue) {
+        connect(m_queue, &QAbstractItemModel::rowsInserted, this, &PlaylistValidator::scheduleSoon);
+        connect(m_queue, &QAbstractItemModel::rowsRemoved, this, &PlaylistValidator::scheduleSoon);
+        connect(m_queue, &QAbstractItemModel::rowsMoved, this, &PlaylistValidator::scheduleSoon);
+        connect(m_queue, &QAbstractItemModel::modelReset, this, &PlaylistValidator::scheduleSoon);
+        connect(m_queue, &QAbstractItemModel::dataChanged, this, &PlaylistValidator::scheduleSoon);
+    }
+}
+
+PlaylistValidator::~PlaylistValidator()
+{
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+void PlaylistValidator::setLookahead(int entries)
+{
+    m_lookahead = qMax(1, entries);
+    scheduleSoon();
+}
+
+void PlaylistValidator::setRecheckInterval(int milliseconds)
+{
+    m_recheckIntervalMs = qMax(1000, milliseconds);
+    m_recheck->setInterval(m_recheckIntervalMs);
+}
+
+PlaylistValidator::Result PlaylistValidator::check(const QString& filePath)
+{
+    Result result;
+    result.path = filePath;
+
+    const QFileInfo info(filePath);
+    if (!info.isFile()) {
+        result.problem = Problem::Missing;
+        return result;
+    }
+    if (info.size() == 0) {
+        result.problem = Problem::Empty;
+        return result;
+    }
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        result.problem = Problem::Unreadable;
+        result.detail = file.errorString();
+        return result;
+    }
+    file.close();
+
+    // Containers the probe does not know may still play, so only known ones can fail here
+    const MediaProbe::ProbeResult probe = MediaProbe::probe(filePath);
+    if (!probe.isValid && probe.container != MediaProbe::Container::Unknown) {
+        result.problem = Problem::BadHeader;
+        result.detail = probe.errorMessage;
+    }
+    return result;
+}
+
+QString PlaylistValidator::describe(Problem problem, const QString& detail)
+{
+    QString text;
+    switch (problem) {
+    case Problem::None:
+        return QString();
+    case Problem::Missing:
+        text = tr("The file is missing");
+        break;
+    case Problem::Empty:
+        text = tr("The file is empty");
+        break;
+    case Problem::Unreadable:
+        text = tr("The file cannot be opened");
+        break;
+    case Problem::BadHeader:
+        text = tr("The file cannot be decoded");
+        break;
+    }
+    return detail.isEmpty() ? text : QString("%1: %2").arg(text, detail);
+}
+
+void PlaylistValidator::validate()
+{
+    if (!m_queue) {
+        return;
+    }
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    for (auto it = m_known.begin(); it != m_known.end();) {
+        it = isFresh(*it, now) ? std::next(it) : m_known.erase(it);
+    }
+
+    const int rows = qMin(m_lookahead, m_queue->count());
+    for (int row = 0; row < rows; ++row) {
+        const PlaylistQueueModel::Entry& entry = m_queue->entry(row);
+        if (entry.pending || m_inFlight.contains(entry.path)) {
+            continue;
+        }
+        const auto known = m_known.constFind(entry.path);
+        if (known != m_known.cend()) {
+            if (known->problem != Problem::None) {
+                handleProblem(row, *known);
+            }
+            continue;
+        }
+
+        const QString path = entry.path;
+        m_inFlight.insert(path);
+        auto* watcher = new QFutureWatcher<Result>(this);
+        connect(watcher, &QFutureWatcher<Result>::finished, this, [this, watcher]() {
+            onChecked(watcher->result());
+            watcher->deleteLater();
+        });
+        watcher->setFuture(QtConcurrent::run(&m_pool, m_checker, path));
+    }
+}
+
+void PlaylistValidator::scheduleSoon()
+{
+    m_soon->start();
+}
+
+void PlaylistValidator::onChecked(const Result& result)
+{
+    m_inFlight.remove(result.path);
+    const Known known{QDateTime::currentMSecsSinceEpoch(), result.problem, result.detail};
+    m_known.insert(result.path, known);
+
+    if (m_queue) {
+        if (result.problem == Problem::None) {
+            // The file may have come back since it was marked
+            m_queue->flagProblem(result.path, QString());
+        } else {
+            emit problemFound(result.path, result.problem, result.detail);
+            const int rows = qMin(m_lookahead, m_queue->count());
+            for (int row = 0; row < rows; ++row) {
+                if (m_queue->entry(row).path == result.path) {
+                    handleProblem(row, known);
+                }
+            }
+        }
+    }
+
+    if (m_inFlight.isEmpty()) {
+        emit idle();
+    }
+}
+
+void PlaylistValidator::handleProblem(int row, const Known& known)
+{
+    const PlaylistQueueModel::Entry entry = m_queue->entry(row);
+    const QString problem = describe(known.problem, known.detail);
+    if (entry.problem == problem) {
+        return;   // Already marked, and the picker had nothing for it then
+    }
+
+    if (m_picker) {
+        const qint64 now = QDateTime::currentMSecsSinceEpoch();
+        for (int pick = 0; pick < MAX_PICKS; ++pick) {
+            const QString candidate = m_picker(entry);
+            if (candidate.isEmpty()) {
+                break;
+            }
+            const auto candidateKnown = m_known.constFind(candidate);
+            if (candidate == entry.path
+                || (candidateKnown != m_known.cend() && isFresh(*candidateKnown, now)
+                    && candidateKnown->problem != Problem::None)) {
+                continue;
+            }
+            m_queue->replaceAt(row, candidate);
+            emit replaced(row, entry.path, candidate);
+            return;
+        }
+    }
+    m_queue->flagProblem(entry.path, problem);
+}
+
+bool PlaylistValidator::isFresh(const Known& known, qint64 now) const
+{
+    return now - known.checkedAt < m_recheckIntervalMs;
+}
@@ -0,0 +1,147 @@
+#ifndef PLAYLISTVALIDATOR_H
+#define PLAYLISTVALIDATOR_H
+
+#include "../models/PlaylistQueueModel.h"
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+#include <QSet>
+#include <QString>
+#include <QThreadPool>
+#include <functional>
+
+class QTimer;
+
+/**
+ * @brief Checks the next tracks of the on-air queue before they are due
+ *
+ * A missing or broken file used to be found only when the deck failed to
+ * open it, with the previous track already over. PlaylistValidator looks
+ * at the first lookahead() entries of the queue on a low-priority thread:
+ * the file must exist, be non-empty, open for reading and have headers
+ * MediaProbe can read. A file is checked again once its result is older
+ * than recheckIntervalMs(), since shares and removable disks go away.
+ *
+ * An entry whose file fails is marked in the queue with the problem. If a
+ * replacement picker is set, the entry is swapped for the track it picks,
+ * typically the next one of the same genre from the rotation, and that
+ * track is checked in turn. Entries the picker has nothing for stay in
+ * the queue, marked.
+ *
+ * @example
+ * @code
+ * PlaylistValidator* validator = new PlaylistValidator(queue, this);
+ * validator->setReplacementPicker([this](const PlaylistQueueModel::Entry& entry) {
+ *     return rotation->nextTrack(genreOf(entry.musicId));
+ * });
+ * connect(validator, &PlaylistValidator::replaced, this, &Player::onTrackReplaced);
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class PlaylistValidator : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class Problem {
+        None,
+        Missing,      ///< The file does not exist
+        Empty,        ///< The file has no bytes
+        Unreadable,   ///< The file cannot be opened
+        BadHeader     ///< The file opens but its headers cannot be read
+    };
+
+    struct Result {
+        QString path;
+        Problem problem = Problem::None;
+        QString detail;
+    };
+
+    /// Runs on a pool thread
+    using Checker = std::function<Result(const QString& filePath)>;
+    /// Runs on the GUI thread; returns an empty path when there is nothing to put instead
+    using ReplacementPicker = std::function<QString(const PlaylistQueueModel::Entry& entry)>;
+
+    static constexpr int DEFAULT_LOOKAHEAD = 10;
+    static constexpr int DEFAULT_RECHECK_INTERVAL_MS = 60000;
+    /// Picks tried for one entry before it is left marked
+    static constexpr int MAX_PICKS = 3;
+
+    explicit PlaylistValidator(PlaylistQueueModel* queue, QObject* parent = nullptr);
+    ~PlaylistValidator() override;
+
+    void setLookahead(int entries);
+    int lookahead() const { return m_lookahead; }
+
+    void setRecheckInterval(int milliseconds);
+    int recheckIntervalMs() const { return m_recheckIntervalMs; }
+
+    void setChecker(Checker checker) { m_checker = std::move(checker); }
+    void setReplacementPicker(ReplacementPicker picker) { m_picker = std::move(picker); }
+
+    /**
+     * @brief Whether checks are queued or running
+     */
+    bool isBusy() const { return !m_inFlight.isEmpty(); }
+
+    /**
+     * @brief Check one file: exists, is not empty, opens and has readable headers
+     */
+    static Result check(const QString& filePath);
+
+    /**
+     * @brief Text shown in the queue for a problem
+     */
+    static QString describe(Problem problem, const QString& detail = QString());
+
+public slots:
+    /**
+     * @brief Check the entries in the lookahead whose result is missing or old
+     */
+    void validate();
+
+signals:
+    /**
+     * @brief Emitted when a file of the lookahead fails its check
+     */
+    void problemFound(const QString& filePath, PlaylistValidator::Problem problem,
+                      const QString& detail);
+
+    /**
+     * @brief Emitted after an entry was swapped for another track
+     */
+    void replaced(int row, const QString& oldPath, const QString& newPath);
+
+    /**
+     * @brief Emitted when the last queued check is done
+     */
+    void idle();
+
+private:
+    struct Known {
+        qint64 checkedAt = 0;   ///< Milliseconds since the epoch
+        Problem problem = Problem::None;
+        QString detail;
+    };
+
+    void scheduleSoon();
+    void onChecked(const Result& result);
+    void handleProblem(int row, const Known& known);
+    bool isFresh(const Known& known, qint64 now) const;
+
+    QPointer<PlaylistQueueModel> m_queue;
+    QThreadPool m_pool;
+    QTimer* m_soon;
+    QTimer* m_recheck;
+    Checker m_checker;
+    ReplacementPicker m_picker;
+    QHash<QString, Known> m_known;
+    QSet<QString> m_inFlight;
+    int m_lookahead = DEFAULT_LOOKAHEAD;
+    int m_recheckIntervalMs = DEFAULT_RECHECK_INTERVAL_MS;
+};
+
+Q_DECLARE_METATYPE(PlaylistValidator::Problem)
+
+#endif // PLAYLISTVALIDATOR_H
@@ -0,0 +1,310 @@
+#include "ProcessSupervisor.h"
+#include <QDebug>
+#include <QTimer>
+#include <algorithm>
+
+#ifdef Q_OS_UNIX
+#include <signal.h>
+#include <unistd.h>
+#endif
+
+ProcessSupervisor::ProcessSupervisor(QObject* parent)
+    : QObject(parent)
+{
+}
+
+ProcessSupervisor::~ProcessSupervisor()
+{
+    // Children go down with the supervisor; no restarts from here on. All
+    // of them are killed first, so they die in parallel, not one by one
+    QList<QProcess*> running;
+    for (Entry& entry : m_processes) {
+        entry.wanted = false;
+        if (entry.process && entry.process->state() != QProcess::NotRunning) {
+            entry.process->disconnect(this);
+            signalProcess(entry.process, true);
+            running.append(entry.process);
+        }
+    }
+    for (QProcess* process : running) {
+        process->waitForFinished(1000);
+    }
+}
+
+void ProcessSupervisor::addProcess(const QString& name, const QString& program, const QStringList& arguments)
+{
+    Entry& entry = m_processes[name];
+    entry.program = program;
+    entry.arguments = arguments;
+}
+
+bool ProcessSupervisor::start(const QString& name)
+{
+    auto it = m_processes.find(name);
+    if (it == m_processes.end()) {
+        logError("start", QString("Unknown process: %1").arg(name));
+        return false;
+    }
+
+    Entry& entry = it.value();
+    entry.wanted = true;
+    entry.failures = 0;
+    entry.restarts = 0;
+    if (entry.restartTimer) {
+        entry.restartTimer->stop();
+    }
+
+    switch (entry.state) {
+    case State::Starting:
+    case State::Running:
+        return true;
+    case State::Stopping:
+        // Relaunched as soon as the old process has exited
+        return true;
+    case State::Stopped:
+    case State::Backoff:
+        launch(name);
+        return true;
+    }
+    return true;
+}
+
+void ProcessSupervisor::stop(const QString& name)
+{
+    auto it = m_processes.find(name);
+    if (it == m_processes.end()) {
+        return;
+    }
+
+    Entry& entry = it.value();
+    entry.wanted = false;
+    if (entry.restartTimer) {
+        entry.restartTimer->stop();
+    }
+
+    if (!entry.process || entry.process->state() == QProcess::NotRunning) {
+        setState(name, State::Stopped);
+        return;
+    }
+
+    setState(name, State::Stopping);
+    signalProcess(entry.process, false);
+
+    if (!entry.killTimer) {
+        entry.killTimer = new QTimer(this);
+        entry.killTimer->setSingleShot(true);
+        connect(entry.killTimer, &QTimer::timeout, this, [this, name]() {
+            Entry& stopping = m_processes[name];
+            if (stopping.process && stopping.process->state() != QProcess::NotRunning) {
+                qWarning() << "ProcessSupervisor:" << name << "ignored terminate, killing it";
+                signalProcess(stopping.process, true);
+                emit forceKilled(name);
+            }
+        });
+    }
+    entry.killTimer->start(m_stopGraceMs);
+}
+
+void ProcessSupervisor::stopAll()
+{
+    const QStringList names = m_processes.keys();
+    for (const QString& name : names) {
+        stop(name);
+    }
+}
+
+ProcessSupervisor::State ProcessSupervisor::state(const QString& name) const
+{
+    auto it = m_processes.constFind(name);
+    return it == m_processes.constEnd() ? State::Stopped : it.value().state;
+}
+
+int ProcessSupervisor::restartCount(const QString& name) const
+{
+    auto it = m_processes.constFind(name);
+    return it == m_processes.constEnd() ? 0 : it.value().restarts;
+}
+
+void ProcessSupervisor::setBackoff(int initialMs, int maxMs)
+{
+    m_initialBackoffMs = std::max(1, initialMs);
+    m_maxBackoffMs = std::max(m_initialBackoffMs, maxMs);
+}
+
+void ProcessSupervisor::setStopGracePeriod(int graceMs)
+{
+    m_stopGraceMs = std::max(0, graceMs);
+}
+
+qint64 ProcessSupervisor::processId(const QString& name) const
+{
+    auto it = m_processes.constFind(name);
+    if (it == m_processes.constEnd() || !it.value().process) {
+        return 0;
+    }
+    return it.value().process->processId();
+}
+
+QString ProcessSupervisor::stateName(State state)
+{
+    switch (state) {
+    case State::Stopped:
+        return "stopped";
+    case State::Starting:
+        return "starting";
+    case State::Running:
+        return "running";
+    case State::Backoff:
+        return "backoff";
+    case State::Stopping:
+        return "stopping";
+    }
+    return QString();
+}
+
+void ProcessSupervisor::launch(const QString& name)
+{
+    Entry& entry = m_processes[name];
+
+    if (!entry.process) {
+        entry.process = new QProcess(this);
+        // Nobody reads the helpers' output; a full pipe would stall them
+        entry.process->setProcessChannelMode(QProcess::ForwardedChannels);
+#ifdef Q_OS_UNIX
+        // Lead a process group of its own, so stop() reaches whatever it spawns
+        entry.process->setChildProcessModifier([]() { ::setpgid(0, 0); });
+#endif
+        connect(entry.process, &QProcess::started, this, [this, name]() {
+            m_processes[name].upTime.start();
+            setState(name, State::Running);
+        });
+        connect(entry.process, &QProcess::finished, this,
+                [this, name](int exitCode, QProcess::ExitStatus exitStatus) {
+                    onFinished(name, exitCode, exitStatus);
+                });
+        connect(entry.process, &QProcess::errorOccurred, this,
+                [this, name](QProcess::ProcessError error) { onErrorOccurred(name, error); });
+    }
+
+    entry.upTime.invalidate();
+    entry.process->setProgram(entry.program);
+    entry.process->setArguments(entry.arguments);
+    setState(name, State::Starting);
+    qDebug() << "ProcessSupervisor: starting" << name << ":" << entry.program << entry.arguments;
+    entry.process->start();
+}
+
+void ProcessSupervisor::onFinished(const QString& name, int exitCode, QProcess::ExitStatus exitStatus)
+{
+    Entry& entry = m_processes[name];
+    if (entry.killTimer) {
+        entry.killTimer->stop();
+    }
+
+    const bool wasStopping = entry.state == State::Stopping;
+    if (!entry.wanted) {
+        qDebug() << "ProcessSupervisor:" << name << "stopped";
+        setState(name, State::Stopped);
+        return;
+    }
+    if (wasStopping) {
+        // start() was called again while the old process was going down
+        launch(name);
+        return;
+    }
+
+    if (entry.upTime.isValid() && entry.upTime.elapsed() >= STABLE_RUN_MS) {
+        entry.failures = 0;
+    }
+
+    logError("onFinished", QString("%1 exited (%2, code %3)")
+                               .arg(name, exitStatus == QProcess::CrashExit ? "crashed" : "normal exit")
+                               .arg(exitCode));
+    scheduleRestart(name);
+}
+
+void ProcessSupervisor::onErrorOccurred(const QString& name, QProcess::ProcessError error)
+{
+    Entry& entry = m_processes[name];
+    const QString message = entry.process ? entry.process->errorString() : QString();
+
+    switch (error) {
+    case QProcess::FailedToStart:
+        // No finished() follows a failed start
+        logError("start", QString("%1 failed to start: %2").arg(name, message));
+        emit processError(name, message);
+        if (entry.wanted) {
+            scheduleRestart(name);
+        } else {
+            setState(name, State::Stopped);
+        }
+        break;
+    case QProcess::Crashed:
+        // finished() follows and schedules the restart
+        if (entry.state != State::Stopping) {
+            emit processError(name, message);
+        }
+        break;
+    default:
+        logError("onErrorOccurred", QString("%1: %2").arg(name, message));
+        break;
+    }
+}
+
+void ProcessSupervisor::scheduleRestart(const QString& name)
+{
+    Entry& entry = m_processes[name];
+
+    // Double the delay for every failure in a row, up to the maximum
+    int delay = m_initialBackoffMs;
+    for (int i = 0; i < entry.failures && delay < m_maxBackoffMs; ++i) {
+        delay = std::min(m_maxBackoffMs, delay * 2);
+    }
+    ++entry.failures;
+
+    if (!entry.restartTimer) {
+        entry.restartTimer = new QTimer(this);
+        entry.restartTimer->setSingleShot(true);
+        connect(entry.restartTimer, &QTimer::timeout, this, [this, name]() {
+            Entry& restarting = m_processes[name];
+            if (restarting.wanted) {
+                ++restarting.restarts;
+                launch(name);
+            }
+        });
+    }
+
+    setState(name, State::Backoff);
+    entry.restartTimer->start(delay);
+    emit restartScheduled(name, delay);
+}
+
+void ProcessSupervisor::signalProcess(QProcess* process, bool kill)
+{
+#ifdef Q_OS_UNIX
+    const pid_t pid = static_cast<pid_t>(process->processId());
+    if (pid > 0 && ::kill(-pid, kill ? SIGKILL : SIGTERM) == 0) {
+        return;
+    }
+#endif
+    // No group to signal (Windows, or the child has not started yet)
+    if (kill) {
+        process->kill();
+    } else {
+        process->terminate();
+    }
+}
+
+void ProcessSupervisor::setState(const QString& name, State state)
+{
+    Entry& entry = m_processes[name];
+    if (entry.state != state) {
+        entry.state = state;
+        emit stateChanged(name, state);
+    }
+}
+
+void ProcessSupervisor::logError(const QString& operation, const QString& error)
+{
+    qWarning() << QString("ProcessSupervisor::%1 - %2").arg(operation, error);
+}
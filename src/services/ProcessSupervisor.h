@@ -0,0 +1,213 @@
+#ifndef PROCESSSUPERVISOR_H
+#define PROCESSSUPERVISOR_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QProcess>
+#include <QString>
+#include <QStringList>
+
+class QTimer;
+
+/**
+ * @brief Runs helper programs as child processes and restarts them when they die
+ *
+ * The streaming helpers (icecast, butt) used to be launched detached and
+ * then polled every few seconds with pgrep, each poll a fork/exec that
+ * blocked the GUI thread for up to a second and a half. ProcessSupervisor
+ * starts each one as a child QProcess instead and learns about it from
+ * QProcess::started, finished and errorOccurred, so nothing is polled and
+ * nothing blocks.
+ *
+ * A supervised process that exits or fails to start while it is meant to
+ * run is restarted after a back-off delay. The delay starts at
+ * initialBackoff(), doubles with every consecutive failure up to
+ * maxBackoff(), and is reset once the process has stayed up for
+ * STABLE_RUN_MS. stop() asks the process to terminate and kills it if it
+ * is still running stopGracePeriod() later.
+ *
+ * On Unix every child is started as the leader of its own process group,
+ * and stop() signals the whole group by ID. A wrapper such as xvfb-run,
+ * which does not pass signals on, goes down together with the program it
+ * runs, without looking anything up by name.
+ *
+ * @example
+ * @code
+ * ProcessSupervisor* supervisor = new ProcessSupervisor(this);
+ * supervisor->addProcess("icecast", "icecast", {"-c", "/usr/local/etc/icecast.xml"});
+ * connect(supervisor, &ProcessSupervisor::stateChanged, this,
+ *         [](const QString& name, ProcessSupervisor::State state) { qDebug() << name << state; });
+ * supervisor->start("icecast");
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class ProcessSupervisor : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class State {
+        Stopped,   ///< Not running and not meant to
+        Starting,  ///< Launched, waiting for QProcess::started
+        Running,   ///< Up
+        Backoff,   ///< Died while meant to run; a restart is scheduled
+        Stopping   ///< stop() was called, waiting for the process to exit
+    };
+    Q_ENUM(State)
+
+    static constexpr int DEFAULT_INITIAL_BACKOFF_MS = 1000;
+    static constexpr int DEFAULT_MAX_BACKOFF_MS = 60 * 1000;
+    /// A process that stays up this long resets its back-off delay
+    static constexpr int STABLE_RUN_MS = 30 * 1000;
+    /// Default time a process has to exit after terminate() before it is killed
+    static constexpr int STOP_GRACE_MS = 3000;
+
+    explicit ProcessSupervisor(QObject* parent = nullptr);
+    ~ProcessSupervisor() override;
+
+    /**
+     * @brief Register a program to supervise, or change how it is launched
+     *
+     * A running process keeps its old command line until it is restarted.
+     * @param name Name the process is addressed by
+     * @param program Program to run
+     * @param arguments Command line arguments
+     */
+    void addProcess(const QString& name, const QString& program, const QStringList& arguments = QStringList());
+
+    /**
+     * @brief Check if a process is registered
+     * @param name Process name
+     * @return true if addProcess() registered it
+     */
+    bool hasProcess(const QString& name) const { return m_processes.contains(name); }
+
+    /**
+     * @brief Start a registered process and keep it running
+     * @param name Process name
+     * @return false if no such process is registered
+     */
+    bool start(const QString& name);
+
+    /**
+     * @brief Stop a process and stop restarting it
+     * @param name Process name
+     */
+    void stop(const QString& name);
+
+    /**
+     * @brief Stop every process
+     */
+    void stopAll();
+
+    /**
+     * @brief Get the state of a process
+     * @param name Process name
+     * @return Current state, Stopped for unknown names
+     */
+    State state(const QString& name) const;
+
+    /**
+     * @brief Check if a process is up
+     * @param name Process name
+     * @return true in the Running state
+     */
+    bool isRunning(const QString& name) const { return state(name) == State::Running; }
+
+    /**
+     * @brief Get the number of restarts since the process was last started by start()
+     * @param name Process name
+     * @return Restart count
+     */
+    int restartCount(const QString& name) const;
+
+    /**
+     * @brief Set the restart delays
+     * @param initialMs Delay before the first restart after a failure
+     * @param maxMs Longest delay between restarts
+     */
+    void setBackoff(int initialMs, int maxMs);
+
+    int initialBackoff() const { return m_initialBackoffMs; }
+    int maxBackoff() const { return m_maxBackoffMs; }
+
+    /**
+     * @brief Set how long stop() waits before it kills a process
+     * @param graceMs Time a process has to exit after being asked to
+     */
+    void setStopGracePeriod(int graceMs);
+    int stopGracePeriod() const { return m_stopGraceMs; }
+
+    /**
+     * @brief Get the operating system's ID of a process
+     * @param name Process name
+     * @return Process ID, 0 if it is not running
+     */
+    qint64 processId(const QString& name) const;
+
+    /**
+     * @brief Get a readable name for a state
+     * @param state State
+     * @return State name
+     */
+    static QString stateName(State state);
+
+signals:
+    /**
+     * @brief Emitted when a process changes state
+     * @param name Process name
+     * @param state New state
+     */
+    void stateChanged(const QString& name, ProcessSupervisor::State state);
+
+    /**
+     * @brief Emitted when a restart is scheduled for a process that died
+     * @param name Process name
+     * @param delayMs Time until the restart
+     */
+    void restartScheduled(const QString& name, int delayMs);
+
+    /**
+     * @brief Emitted when a process fails to start or crashes
+     * @param name Process name
+     * @param error Error message
+     */
+    void processError(const QString& name, const QString& error);
+
+    /**
+     * @brief Emitted when a stopping process ignored terminate and was killed
+     * @param name Process name
+     */
+    void forceKilled(const QString& name);
+
+private:
+    struct Entry {
+        QString program;
+        QStringList arguments;
+        QProcess* process = nullptr;
+        QTimer* restartTimer = nullptr;
+        QTimer* killTimer = nullptr;
+        QElapsedTimer upTime;
+        State state = State::Stopped;
+        bool wanted = false;
+        int failures = 0;
+        int restarts = 0;
+    };
+
+    void launch(const QString& name);
+    void onFinished(const QString& name, int exitCode, QProcess::ExitStatus exitStatus);
+    void onErrorOccurred(const QString& name, QProcess::ProcessError error);
+    void scheduleRestart(const QString& name);
+    void setState(const QString& name, State state);
+    static void signalProcess(QProcess* process, bool kill);
+    void logError(const QString& operation, const QString& error);
+
+    QHash<QString, Entry> m_processes;
+    int m_initialBackoffMs = DEFAULT_INITIAL_BACKOFF_MS;
+    int m_maxBackoffMs = DEFAULT_MAX_BACKOFF_MS;
+    int m_stopGraceMs = STOP_GRACE_MS;
+};
+
+#endif // PROCESSSUPERVISOR_H
@@ -0,0 +1,244 @@
+#include "ProgramBuilder.h"
+#include <QDebug>
+#include <QFile>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QSaveFile>
+#include <QSet>
+#include <QtConcurrent/QtConcurrent>
+#include <QtEndian>
+#include <array>
+
+namespace {
+
+constexpr int PAGE_HEADER_SIZE = 27;
+constexpr uchar FLAG_BEGIN_OF_STREAM = 0x02;
+constexpr uchar FLAG_END_OF_STREAM = 0x04;
+constexpr int SERIAL_OFFSET = 14;
+constexpr int CHECKSUM_OFFSET = 22;
+
+// Ogg's CRC-32: polynomial 0x04c11db7, not reflected, no initial or final inversion
+quint32 oggChecksum(const char* data, qsizetype size)
+{
+    static const std::array<quint32, 256> table = [] {
+        std::array<quint32, 256> entries{};
+        for (quint32 i = 0; i < 256; ++i) {
+            quint32 remainder = i << 24;
+            for (int bit = 0; bit < 8; ++bit) {
+                remainder = (remainder & 0x80000000u) ? (remainder << 1) ^ 0x04c11db7u
+                                                      : remainder << 1;
+            }
+            entries[i] = remainder;
+        }
+        return entries;
+    }();
+
+    quint32 crc = 0;
+    for (qsizetype i = 0; i < size; ++i) {
+        crc = (crc << 8) ^ table[((crc >> 24) ^ static_cast<uchar>(data[i])) & 0xff];
+    }
+    return crc;
+}
+
+void updateChecksum(QByteArray& page)
+{
+    qToLittleEndian<quint32>(0, page.data() + CHECKSUM_OFFSET);
+    qToLittleEndian<quint32>(oggChecksum(page.constData(), page.size()),
+                             page.data() + CHECKSUM_OFFSET);
+}
+
+// 1 if a page was read, 0 at the end of the file, -1 if what follows is not a whole page
+int readPage(QIODevice& file, QByteArray* page)
+{
+    *page = file.read(PAGE_HEADER_SIZE);
+    if (page->isEmpty()) {
+        return 0;
+    }
+    if (page->size() < PAGE_HEADER_SIZE || !page->startsWith("OggS") || page->at(4) != 0) {
+        return -1;
+    }
+
+    const int segments = static_cast<uchar>(page->at(26));
+    const QByteArray lacing = file.read(segments);
+    if (lacing.size() != segments) {
+        return -1;
+    }
+    qsizetype bodySize = 0;
+    for (char length : lacing) {
+        bodySize += static_cast<uchar>(length);
+    }
+    const QByteArray body = file.read(bodySize);
+    if (body.size() != bodySize) {
+        return -1;
+    }
+
+    page->reserve(PAGE_HEADER_SIZE + segments + bodySize);
+    page->append(lacing).append(body);
+    return 1;
+}
+
+} // namespace
+
+ProgramBuilder::ProgramBuilder(QObject* parent)
+    : QObject(parent)
+{
+}
+
+ProgramBuilder::~ProgramBuilder()
+{
+    m_cancelled = true;
+    m_future.waitForFinished();
+}
+
+bool ProgramBuilder::concatenate(const QStringList& sources, const QString& destination,
+                                 QString* error, const ProgressCallback& progress,
+                                 const std::atomic<bool>* cancelled)
+{
+    const auto fail = [error](const QString& reason) {
+        if (error) {
+            *error = reason;
+        }
+        return false;
+    };
+
+    if (sources.isEmpty()) {
+        return fail("There are no files to join");
+    }
+
+    // Check every source before writing anything, so a bad item fails at once
+    qint64 total = 0;
+    for (const QString& source : sources) {
+        QFile file(source);
+        if (!file.open(QIODevice::ReadOnly)) {
+            return fail(QString("Cannot open %1: %2").arg(source, file.errorString()));
+        }
+        if (file.read(4) != "OggS") {
+            return fail(QString("%1 is not an Ogg file").arg(source));
+        }
+        total += file.size();
+    }
+
+    QSaveFile output(destination);
+    if (!output.open(QIODevice::WriteOnly)) {
+        return fail(QString("Cannot write %1: %2").arg(destination, output.errorString()));
+    }
+
+    QSet<quint32> usedSerials;
+    qint64 done = 0;
+    for (const QString& source : sources) {
+        QFile file(source);
+        if (!file.open(QIODevice::ReadOnly)) {
+            return fail(QString("Cannot open %1: %2").arg(source, file.errorString()));
+        }
+
+        // Serial numbers of this source's streams and what they are written as
+        QHash<quint32, quint32> serials;
+        // Each page waits for the next, so the last one can still get its end flag
+        QByteArray held;
+        bool heldChanged = false;
+        const auto writeHeld = [&]() {
+            if (held.isEmpty()) {
+                return true;
+            }
+            if (heldChanged) {
+                updateChecksum(held);
+            }
+            return output.write(held) == held.size();
+        };
+
+        QByteArray page;
+        int status;
+        while ((status = readPage(file, &page)) > 0) {
+            const quint32 serial = qFromLittleEndian<quint32>(page.constData() + SERIAL_OFFSET);
+            if (static_cast<uchar>(page.at(5)) & FLAG_BEGIN_OF_STREAM) {
+                quint32 written = serial;
+                while (usedSerials.contains(written)) {
+                    ++written;
+                }
+                usedSerials.insert(written);
+                serials.insert(serial, written);
+            } else if (!serials.contains(serial)) {
+                return fail(QString("%1 has a page of a stream that never began").arg(source));
+            }
+
+            if (!writeHeld()) {
+                return fail(QString("Cannot write %1: %2").arg(destination, output.errorString()));
+            }
+            const quint32 written = serials.value(serial);
+            held = page;
+            heldChanged = written != serial;
+            if (heldChanged) {
+                qToLittleEndian<quint32>(written, held.data() + SERIAL_OFFSET);
+            }
+
+            if (progress) {
+                progress(done + file.pos(), total);
+            }
+            if (cancelled && cancelled->load()) {
+                return fail("Cancelled");
+            }
+        }
+        if (status < 0) {
+            return fail(QString("%1 is damaged at byte %2").arg(source).arg(file.pos()));
+        }
+
+        if (!(static_cast<uchar>(held.at(5)) & FLAG_END_OF_STREAM)) {
+            held[5] = static_cast<char>(static_cast<uchar>(held.at(5)) | FLAG_END_OF_STREAM);
+            heldChanged = true;
+        }
+        if (!writeHeld()) {
+            return fail(QString("Cannot write %1: %2").arg(destination, output.errorString()));
+        }
+        done += file.size();
+    }
+
+    if (!output.commit()) {
+        return fail(QString("Cannot write %1: %2").arg(destination, output.errorString()));
+    }
+    return true;
+}
+
+bool ProgramBuilder::start(const QStringList& sources, const QString& destination)
+{
+    if (m_running || sources.isEmpty()) {
+        return false;
+    }
+
+    m_running = true;
+    m_cancelled = false;
+    m_permille = -1;
+
+    auto* watcher = new QFutureWatcher<Outcome>(this);
+    connect(watcher, &QFutureWatcher<Outcome>::finished, this, [this, watcher, destination]() {
+        const Outcome outcome = watcher->result();
+        watcher->deleteLater();
+        m_running = false;
+        if (outcome.success) {
+            qInfo() << "ProgramBuilder: built" << destination;
+        } else {
+            qWarning() << QString("ProgramBuilder::start - %1: %2").arg(destination, outcome.error);
+        }
+        emit finished(outcome.success, destination, outcome.error);
+    });
+
+    m_future = QtConcurrent::run([this, sources, destination]() {
+        // Emitted from the worker; receivers on the GUI thread get it queued
+        const auto progress = [this](qint64 done, qint64 total) {
+            const int permille = total > 0 ? static_cast<int>(done * 1000 / total) : 0;
+            if (m_permille.exchange(permille) != permille) {
+                emit progressChanged(permille);
+            }
+        };
+
+        Outcome outcome;
+        outcome.success = concatenate(sources, destination, &outcome.error, progress, &m_cancelled);
+        return outcome;
+    });
+    watcher->setFuture(m_future);
+    return true;
+}
+
+void ProgramBuilder::cancel()
+{
+    m_cancelled = true;
+}
@@ -0,0 +1,113 @@
+#ifndef PROGRAMBUILDER_H
+#define PROGRAMBUILDER_H
+
+#include <QFuture>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <atomic>
+#include <functional>
+
+/**
+ * @brief Joins Ogg files into one program without re-encoding them
+ *
+ * "Make a program from this playlist" used to copy every item to a scratch
+ * folder, write an ffmpeg concat list with one shell per line and then
+ * re-encode everything, all while blocking the GUI thread.
+ *
+ * An Ogg file may be followed by another complete Ogg stream; players treat
+ * the result as one chained file. ProgramBuilder uses that to build the
+ * program by copying the pages of each source straight into the output,
+ * on a worker thread. Pages are only changed, and their checksum computed
+ * again, where the chain needs it:
+ * - a stream whose serial number was already used by an earlier source
+ *   gets a new one, so the links stay distinct
+ * - the last page of a source that was cut short gets its end-of-stream flag
+ *
+ * Each link keeps its own granule positions, so no audio is decoded and
+ * sources with different sample rates or codecs can be joined. The output
+ * is written to a temporary file that only replaces the destination once
+ * the last page is in, so a failed or cancelled build leaves no half
+ * program behind.
+ *
+ * @example
+ * @code
+ * ProgramBuilder* builder = new ProgramBuilder(this);
+ * connect(builder, &ProgramBuilder::finished, this,
+ *         [](bool success, const QString& destination, const QString& error) {
+ *             qDebug() << destination << (success ? "built" : error);
+ *         });
+ * builder->start(playlistPaths, "/programs/program_2016-02-07.ogg");
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class ProgramBuilder : public QObject
+{
+    Q_OBJECT
+
+public:
+    /// Bytes of the sources read so far, of their total size
+    using ProgressCallback = std::function<void(qint64 done, qint64 total)>;
+
+    explicit ProgramBuilder(QObject* parent = nullptr);
+    ~ProgramBuilder() override;
+
+    /**
+     * @brief Join Ogg files into one chained Ogg file
+     *
+     * Runs on the calling thread.
+     * @param sources Files to join, in order
+     * @param destination File to write; replaced only on success
+     * @param error Set to the reason on failure, if given
+     * @param progress Called after every page, if given
+     * @param cancelled Checked after every page, if given
+     * @return true if the destination was written
+     */
+    static bool concatenate(const QStringList& sources, const QString& destination,
+                            QString* error = nullptr, const ProgressCallback& progress = {},
+                            const std::atomic<bool>* cancelled = nullptr);
+
+    /**
+     * @brief Start joining files on a worker thread
+     * @param sources Files to join, in order
+     * @param destination File to write
+     * @return false if a build is already running or there are no sources
+     */
+    bool start(const QStringList& sources, const QString& destination);
+
+    /**
+     * @brief Stop the running build; finished() reports it as failed
+     */
+    void cancel();
+
+    bool isRunning() const { return m_running; }
+
+signals:
+    /**
+     * @brief Emitted as the build goes on
+     * @param permille Share of the sources copied, 0 to 1000
+     */
+    void progressChanged(int permille);
+
+    /**
+     * @brief Emitted when the build is done
+     * @param success true if the destination was written
+     * @param destination File that was built
+     * @param error Reason of the failure; empty on success
+     */
+    void finished(bool success, const QString& destination, const QString& error);
+
+private:
+    struct Outcome {
+        bool success = false;
+        QString error;
+    };
+
+    QFuture<Outcome> m_future;
+    std::atomic<bool> m_cancelled{false};
+    std::atomic<int> m_permille{-1};   ///< Last progress sent, to send each step once
+    bool m_running = false;
+};
+
+#endif // PROGRAMBUILDER_H
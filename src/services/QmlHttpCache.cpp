@@ -0,0 +1,27 @@
+#include "QmlHttpCache.h"
+#include <QDir>
+#include <QMutexLocker>
+#include <QNetworkAccessManager>
+#include <QNetworkDiskCache>
+
+QmlHttpCache::QmlHttpCache(const QString& directory, qint64 maxBytes)
+    : m_directory(directory)
+    , m_maxBytes(qMax<qint64>(1024 * 1024, maxBytes))
+{
+}
+
+QNetworkAccessManager* QmlHttpCache::create(QObject* parent)
+{
+    int index;
+    {
+        QMutexLocker locker(&m_mutex);
+        index = m_created++;
+    }
+
+    auto* network = new QNetworkAccessManager(parent);
+    auto* cache = new QNetworkDiskCache(network);
+    cache->setCacheDirectory(QDir(m_directory).filePath(QString::number(index)));
+    cache->setMaximumCacheSize(m_maxBytes);
+    network->setCache(cache);
+    return network;
+}
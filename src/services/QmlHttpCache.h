@@ -0,0 +1,52 @@
+#ifndef QMLHTTPCACHE_H
+#define QMLHTTPCACHE_H
+
+#include <QMutex>
+#include <QQmlNetworkAccessManagerFactory>
+#include <QString>
+
+/**
+ * @brief Disk-backed HTTP cache for the network access of a QML engine
+ *
+ * A QML engine fetches remote content through access managers without a
+ * cache, so every refresh of the ad banner downloaded everything again.
+ * Set on the engine, QmlHttpCache gives each access manager the engine
+ * creates a QNetworkDiskCache under one directory. Fresh responses are
+ * then answered from disk and stale ones are revalidated with
+ * If-None-Match and If-Modified-Since, so an unchanged banner costs one
+ * 304 reply.
+ *
+ * A QNetworkDiskCache cannot share its directory, and the engine asks for
+ * an access manager from each of its loader threads, so each one gets a
+ * numbered subdirectory; the one created first, on the GUI thread, is the
+ * same on every run.
+ *
+ * @example
+ * @code
+ * auto* cache = new QmlHttpCache(cacheLocation + "/qml-http");
+ * widget->engine()->setNetworkAccessManagerFactory(cache); // the engine does not own it
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class QmlHttpCache : public QQmlNetworkAccessManagerFactory
+{
+public:
+    static constexpr qint64 DEFAULT_MAX_BYTES = 32 * 1024 * 1024;
+
+    explicit QmlHttpCache(const QString& directory, qint64 maxBytes = DEFAULT_MAX_BYTES);
+
+    QString directory() const { return m_directory; }
+    qint64 maxBytes() const { return m_maxBytes; }
+
+    /// Called by the engine, from any of its threads
+    QNetworkAccessManager* create(QObject* parent) override;
+
+private:
+    const QString m_directory;
+    const qint64 m_maxBytes;
+    QMutex m_mutex;
+    int m_created = 0;
+};
+
+#endif // QMLHTTPCACHE_H
@@ -0,0 +1,113 @@
+#ifndef QUERYTIMER_H
+#define QUERYTIMER_H
+
+#include "Tracer.h"
+#include <QElapsedTimer>
+#include <QString>
+#include <atomic>
+
+/**
+ * @brief Receiver of automatic query timings
+ *
+ * Implemented by DatabaseOptimizer. Only one sink is active at a time.
+ *
+ * @since XFB 2.0
+ */
+class QueryTimingSink
+{
+public:
+    virtual ~QueryTimingSink() = default;
+
+    /**
+     * @brief Record one query execution
+     * @param query SQL query string
+     * @param executionTime Execution time in milliseconds
+     */
+    virtual void recordQueryExecution(const QString& query, qint64 executionTime) = 0;
+
+    /**
+     * @brief Check if timings are currently wanted
+     * @return true while the sink is recording
+     */
+    virtual bool isRecordingQueries() const = 0;
+};
+
+/**
+ * @brief Scoped timer that reports a query's execution time to the active sink
+ *
+ * Placed around QSqlQuery::exec() in DatabaseService and the repositories'
+ * executeQuery helpers. When no sink is installed, or the sink is not
+ * recording, constructing the timer costs one atomic load and nothing is
+ * measured. While Tracer is enabled, each query is also a "db" span.
+ *
+ * @example
+ * @code
+ * {
+ *     QueryTimer timer(query.lastQuery());
+ *     query.exec();
+ * } // elapsed time reported here
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class QueryTimer
+{
+public:
+    explicit QueryTimer(const QString& query)
+        : m_sink(s_sink.load(std::memory_order_acquire))
+    {
+        if (m_sink && m_sink->isRecordingQueries()) {
+            m_query = query;
+            m_timer.start();
+        } else {
+            m_sink = nullptr;
+        }
+    }
+
+    ~QueryTimer()
+    {
+        if (m_sink) {
+            m_sink->recordQueryExecution(m_query, m_timer.elapsed());
+        }
+    }
+
+    QueryTimer(const QueryTimer&) = delete;
+    QueryTimer& operator=(const QueryTimer&) = delete;
+
+    /**
+     * @brief Install the sink that receives timings, or nullptr to stop timing
+     * @param sink Sink to install
+     */
+    static void setSink(QueryTimingSink* sink)
+    {
+        s_sink.store(sink, std::memory_order_release);
+    }
+
+    /**
+     * @brief Remove a sink if it is the one installed
+     * @param sink Sink being destroyed or disabled
+     */
+    static void clearSink(QueryTimingSink* sink)
+    {
+        s_sink.compare_exchange_strong(sink, nullptr, std::memory_order_acq_rel);
+    }
+
+    /**
+     * @brief Get the installed sink
+     * @return Active sink, or nullptr
+     */
+    static QueryTimingSink* sink()
+    {
+        return s_sink.load(std::memory_order_acquire);
+    }
+
+private:
+    TraceSpan m_span{"db", "query"};
+    QueryTimingSink* m_sink;
+    QString m_query;
+    QElapsedTimer m_timer;
+
+    static inline std::atomic<QueryTimingSink*> s_sink{nullptr};
+};
+
+#endif // QUERYTIMER_H
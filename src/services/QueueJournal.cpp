@@ -0,0 +1,328 @@
+#include "QueueJournal.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QTimer>
+#include <algorithm>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+QString formatTime(const QDateTime& time)
+{
+    return time.toString(Qt::ISODateWithMs);
+}
+
+// QFile::flush() only reaches the kernel; the record has to survive a power cut too
+bool syncToDisk(QFile& file)
+{
+    if (!file.flush()) {
+        return false;
+    }
+#ifdef Q_OS_WIN
+    return _commit(file.handle()) == 0;
+#else
+    return ::fsync(file.handle()) == 0;
+#endif
+}
+
+} // namespace
+
+QueueJournal::QueueJournal(QObject* parent)
+    : QObject(parent)
+    , m_context(new QObject)
+    , m_timer(new QTimer(this))
+{
+    m_thread.setObjectName("QueueJournal");
+    m_context->moveToThread(&m_thread);
+    connect(&m_thread, &QThread::finished, m_context, &QObject::deleteLater);
+    m_thread.start();
+
+    m_timer->setInterval(FLUSH_INTERVAL_MS);
+    connect(m_timer, &QTimer::timeout, this, [this]() {
+        bool replace = false;
+        const QByteArray batch = takeBatch(&replace);
+        if (!batch.isEmpty()) {
+            QMetaObject::invokeMethod(m_context, [this, batch, replace]() {
+                writeOnThread(batch, replace);
+            });
+        }
+    });
+}
+
+QueueJournal::~QueueJournal()
+{
+    flush();
+    QMetaObject::invokeMethod(
+        m_context,
+        [this]() {
+            delete m_file;
+            m_file = nullptr;
+        },
+        Qt::BlockingQueuedConnection);
+    m_thread.quit();
+    m_thread.wait();
+}
+
+QString QueueJournal::defaultLocation()
+{
+    const QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    return QDir(dataDir).filePath(FILE_NAME);
+}
+
+QueueJournal::State QueueJournal::read(const QString& filePath)
+{
+    State state;
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return state;
+    }
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine().trimmed();
+        if (line.isEmpty()) {
+            continue;
+        }
+        // A line cut short by a crash does not parse and is skipped
+        const QJsonObject object = QJsonDocument::fromJson(line).object();
+        const QDateTime time =
+            QDateTime::fromString(object.value("time").toString(), Qt::ISODateWithMs);
+        const QString type = object.value("type").toString();
+        if (!time.isValid()) {
+            continue;
+        }
+
+        if (type == "queue") {
+            state.queue.clear();
+            const QJsonArray paths = object.value("paths").toArray();
+            for (const QJsonValue& path : paths) {
+                state.queue << path.toString();
+            }
+        } else if (type == "track") {
+            state.current = object.value("path").toString();
+            state.positionMs = 0;
+        } else if (type == "position") {
+            state.positionMs = qMax<qint64>(0, object.value("ms").toInteger());
+        } else if (type == "stop") {
+            state.current.clear();
+            state.positionMs = 0;
+        } else if (type == "fired") {
+            Firing firing;
+            firing.rowId = object.value("row").toInteger(-1);
+            firing.fireAt =
+                QDateTime::fromString(object.value("fire_at").toString(), Qt::ISODateWithMs);
+            if (firing.rowId < 0 || !firing.fireAt.isValid()) {
+                continue;
+            }
+            state.fired.append(firing);
+        } else {
+            continue;
+        }
+        state.savedAt = time;
+    }
+    return state;
+}
+
+bool QueueJournal::open(const QString& filePath)
+{
+    if (m_open) {
+        return true;
+    }
+    if (!QDir().mkpath(QFileInfo(filePath).absolutePath())) {
+        logError("open", QString("Cannot create the directory of %1").arg(filePath));
+        return false;
+    }
+
+    m_filePath = filePath;
+    m_restored = read(filePath);
+    m_queue = m_restored.queue;
+    m_current = m_restored.current;
+    m_positionMs = m_restored.positionMs;
+    m_fired = m_restored.fired;
+
+    // Start from the state alone, so the file never grows from one run to the next
+    const QByteArray state = stateRecords();
+    bool written = false;
+    QMetaObject::invokeMethod(
+        m_context, [this, state, &written]() { written = writeOnThread(state, true); },
+        Qt::BlockingQueuedConnection);
+    if (!written) {
+        return false;
+    }
+    m_bytes = state.size();
+    m_open = true;
+    m_timer->start();
+    qDebug() << "QueueJournal: restored" << m_restored.queue.size() << "queued tracks from"
+             << filePath;
+    return true;
+}
+
+void QueueJournal::queueChanged()
+{
+    m_queueDirty = true;
+}
+
+void QueueJournal::trackStarted(const QString& path)
+{
+    m_current = path;
+    m_positionMs = 0;
+    m_positionDirty = false;
+    append({{"path", path}}, "track");
+}
+
+void QueueJournal::setPosition(qint64 positionMs)
+{
+    if (m_current.isEmpty() || positionMs == m_positionMs) {
+        return;
+    }
+    m_positionMs = positionMs;
+    m_positionDirty = true;
+}
+
+void QueueJournal::stopped()
+{
+    if (m_current.isEmpty()) {
+        return;
+    }
+    m_current.clear();
+    m_positionMs = 0;
+    m_positionDirty = false;
+    append(QJsonObject(), "stop");
+}
+
+void QueueJournal::scheduled(qint64 rowId, const QDateTime& fireAt)
+{
+    m_fired.append({rowId, fireAt});
+    append({{"row", rowId}, {"fire_at", formatTime(fireAt)}}, "fired");
+}
+
+void QueueJournal::flush()
+{
+    if (!m_open) {
+        return;
+    }
+    bool replace = false;
+    const QByteArray batch = takeBatch(&replace);
+    QMetaObject::invokeMethod(
+        m_context,
+        [this, batch, replace]() {
+            if (!batch.isEmpty()) {
+                writeOnThread(batch, replace);
+            }
+        },
+        Qt::BlockingQueuedConnection);
+}
+
+void QueueJournal::append(QJsonObject record, const QString& type)
+{
+    if (!m_open) {
+        return;
+    }
+    record.insert("time", formatTime(QDateTime::currentDateTime()));
+    record.insert("type", type);
+    m_pending += QJsonDocument(record).toJson(QJsonDocument::Compact);
+    m_pending += '\n';
+}
+
+QByteArray QueueJournal::takeBatch(bool* replace)
+{
+    if (m_queueDirty && m_queueSource) {
+        const QStringList queue = m_queueSource();
+        if (queue != m_queue) {
+            m_queue = queue;
+            append({{"paths", QJsonArray::fromStringList(m_queue)}}, "queue");
+        }
+    }
+    m_queueDirty = false;
+    if (m_positionDirty) {
+        append({{"ms", m_positionMs}}, "position");
+        m_positionDirty = false;
+    }
+
+    QByteArray batch;
+    batch.swap(m_pending);
+    *replace = !batch.isEmpty() && m_bytes + batch.size() > COMPACT_BYTES;
+    if (*replace) {
+        batch = stateRecords();
+        m_bytes = 0;
+    }
+    m_bytes += batch.size();
+    return batch;
+}
+
+QByteArray QueueJournal::stateRecords()
+{
+    // Older firings are dropped here, the only place the list is pruned
+    const QDateTime keepFrom = QDateTime::currentDateTime().addMSecs(-FIRED_KEEP_MS);
+    m_fired.erase(std::remove_if(m_fired.begin(), m_fired.end(),
+                                 [&keepFrom](const Firing& firing) {
+                                     return firing.fireAt < keepFrom;
+                                 }),
+                  m_fired.end());
+
+    const QString now = formatTime(QDateTime::currentDateTime());
+    QByteArray records;
+    const auto add = [&records, &now](QJsonObject record, const char* type) {
+        record.insert("time", now);
+        record.insert("type", QLatin1String(type));
+        records += QJsonDocument(record).toJson(QJsonDocument::Compact);
+        records += '\n';
+    };
+    add({{"paths", QJsonArray::fromStringList(m_queue)}}, "queue");
+    if (!m_current.isEmpty()) {
+        add({{"path", m_current}}, "track");
+        add({{"ms", m_positionMs}}, "position");
+    }
+    for (const Firing& firing : std::as_const(m_fired)) {
+        add({{"row", firing.rowId}, {"fire_at", formatTime(firing.fireAt)}}, "fired");
+    }
+    return records;
+}
+
+bool QueueJournal::writeOnThread(const QByteArray& batch, bool replace)
+{
+    if (replace) {
+        delete m_file;
+        m_file = nullptr;
+        QSaveFile save(m_filePath);
+        if (!save.open(QIODevice::WriteOnly) || save.write(batch) != batch.size() ||
+            !save.commit()) {
+            logError("compact", save.errorString());
+            return false;
+        }
+    }
+
+    if (!m_file) {
+        m_file = new QFile(m_filePath, m_context);
+        if (!m_file->open(QIODevice::WriteOnly | QIODevice::Append)) {
+            logError("open", QString("%1: %2").arg(m_filePath, m_file->errorString()));
+            delete m_file;
+            m_file = nullptr;
+            return false;
+        }
+    }
+    if (!replace && m_file->write(batch) != batch.size()) {
+        logError("write", m_file->errorString());
+        return false;
+    }
+    if (!syncToDisk(*m_file)) {
+        logError("sync", QString("Cannot sync %1").arg(m_filePath));
+        return false;
+    }
+    return true;
+}
+
+void QueueJournal::logError(const QString& operation, const QString& error)
+{
+    qWarning() << QString("QueueJournal::%1 - %2").arg(operation, error);
+    emit operationError(operation, error);
+}
@@ -0,0 +1,188 @@
+#ifndef QUEUEJOURNAL_H
+#define QUEUEJOURNAL_H
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QJsonObject>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+#include <functional>
+
+class QFile;
+class QTimer;
+
+/**
+ * @brief Crash-safe record of the on-air queue, for resuming after a restart
+ *
+ * When XFB crashed or was restarted mid-show the queue and the place in
+ * the track on air were gone, and the operator rebuilt them by hand over
+ * dead air. QueueJournal keeps them in one small file, one JSON object per
+ * line, appended as they change:
+ * @code
+ * {"paths":["/music/a.ogg","/music/b.ogg"],"time":"2026-10-14T12:00:00.000+01:00","type":"queue"}
+ * {"path":"/music/song.ogg","time":"2026-10-14T12:00:00.020+01:00","type":"track"}
+ * {"ms":61250,"time":"2026-10-14T12:01:01.270+01:00","type":"position"}
+ * @endcode
+ * "stop" records that playback stopped, and "fired" a scheduler event,
+ * so the restarted scheduler does not play it again within its minute.
+ *
+ * Changes are gathered and written once every FLUSH_INTERVAL_MS with one
+ * fsync, on a thread of the journal's own so a slow disk never holds up
+ * the window: a crash loses at most that last second. The queue is taken
+ * from a QueueSource when it is written, however often it changed in
+ * between. Past COMPACT_BYTES the file is rewritten, atomically, with
+ * only the current state.
+ *
+ * open() reads back what the journal held, as restored(), skipping a line
+ * cut short by a crash; the caller queues it again and seeks back.
+ *
+ * @example
+ * @code
+ * journal->setQueueSource([queue]() { return queue->paths(); });
+ * journal->open(QueueJournal::defaultLocation());
+ * const QueueJournal::State state = journal->restored();
+ * queue->append(state.queue);
+ * if (!state.current.isEmpty()) {
+ *     engine->play(state.current);
+ *     engine->setPosition(state.positionMs);
+ * }
+ * connect(engine, &PlaybackEngine::positionChanged, journal, &QueueJournal::setPosition);
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class QueueJournal : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr const char* FILE_NAME = "queue.jsonl";
+    static constexpr int FLUSH_INTERVAL_MS = 1000;
+    /// The file is rewritten with the current state alone past this size
+    static constexpr qint64 COMPACT_BYTES = 1024 * 1024;
+    /// A scheduler event this old has had its minute and cannot fire again
+    static constexpr qint64 FIRED_KEEP_MS = 120000;
+
+    /**
+     * @brief A scheduler event that fired
+     */
+    struct Firing {
+        qint64 rowId = -1;
+        QDateTime fireAt;
+    };
+
+    /**
+     * @brief What the journal held
+     */
+    struct State {
+        QStringList queue;
+        QString current;          ///< Track on air, empty if playback was stopped
+        qint64 positionMs = 0;    ///< Last position seen in the current track
+        QList<Firing> fired;
+        QDateTime savedAt;        ///< Time of the last record, invalid if there was none
+
+        bool isEmpty() const { return queue.isEmpty() && current.isEmpty(); }
+    };
+
+    /// Returns the paths of the queue, in order
+    using QueueSource = std::function<QStringList()>;
+
+    explicit QueueJournal(QObject* parent = nullptr);
+    ~QueueJournal() override;
+
+    /**
+     * @brief Default file of the journal, under the application data
+     */
+    static QString defaultLocation();
+
+    /**
+     * @brief Replay a journal file
+     * @return The state it ends in; empty if the file is missing or unreadable
+     */
+    static State read(const QString& filePath);
+
+    /**
+     * @brief Read a journal back and go on writing to it, compacted
+     * @param filePath File of the journal; its directory is created if needed
+     * @return true if the journal can be written
+     */
+    bool open(const QString& filePath);
+    bool isOpen() const { return m_open; }
+    QString filePath() const { return m_filePath; }
+
+    /**
+     * @brief What the file held when it was opened
+     */
+    State restored() const { return m_restored; }
+
+    void setQueueSource(QueueSource source) { m_queueSource = std::move(source); }
+
+    /**
+     * @brief Note that the queue changed; it is read from the source at the next write
+     */
+    void queueChanged();
+
+    /**
+     * @brief Note the track that went on air, at its start
+     */
+    void trackStarted(const QString& path);
+
+    /**
+     * @brief Note the position in the track on air; only the last one is written
+     */
+    void setPosition(qint64 positionMs);
+
+    /**
+     * @brief Note that playback stopped, so nothing is resumed
+     */
+    void stopped();
+
+    /**
+     * @brief Note a scheduler event that fired
+     */
+    void scheduled(qint64 rowId, const QDateTime& fireAt);
+
+    /**
+     * @brief Write and sync everything noted so far, and wait for it
+     */
+    void flush();
+
+signals:
+    /**
+     * @brief Emitted when the journal cannot be written
+     * @param operation Name of the operation
+     * @param error Error message
+     */
+    void operationError(const QString& operation, const QString& error);
+
+private:
+    void append(QJsonObject record, const QString& type);
+    QByteArray takeBatch(bool* replace);
+    QByteArray stateRecords();
+    bool writeOnThread(const QByteArray& batch, bool replace);
+    void logError(const QString& operation, const QString& error);
+
+    QThread m_thread;
+    QObject* m_context;          ///< Lives on m_thread, where the file is written
+    QFile* m_file = nullptr;     ///< Writer thread only
+    QTimer* m_timer;
+    QString m_filePath;
+    bool m_open = false;
+    State m_restored;
+
+    // What the journal holds now, on the owner's thread
+    QueueSource m_queueSource;
+    QStringList m_queue;
+    bool m_queueDirty = false;
+    QString m_current;
+    qint64 m_positionMs = 0;
+    bool m_positionDirty = false;
+    QList<Firing> m_fired;
+    QByteArray m_pending;        ///< Records not handed to the writer yet
+    qint64 m_bytes = 0;          ///< Size of the file, as far as the records handed on go
+};
+
+#endif // QUEUEJOURNAL_H
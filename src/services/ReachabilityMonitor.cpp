@@ -0,0 +1,258 @@
+#include "ReachabilityMonitor.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QTcpSocket>
+#include <QTimer>
+#include <algorithm>
+#include <numeric>
+
+ReachabilityMonitor::ReachabilityMonitor(QObject* parent)
+    : QObject(parent)
+{
+}
+
+void ReachabilityMonitor::addTarget(const QString& name, const QString& host, quint16 port)
+{
+    Target& target = m_targets[name];
+    const bool moved = target.host != host || target.port != port;
+    target.host = host;
+    target.port = port;
+
+    if (moved && target.monitoring) {
+        start(name);
+    }
+}
+
+void ReachabilityMonitor::removeTarget(const QString& name)
+{
+    auto it = m_targets.find(name);
+    if (it == m_targets.end()) {
+        return;
+    }
+    delete it.value().timer;
+    m_targets.erase(it);
+}
+
+bool ReachabilityMonitor::start(const QString& name)
+{
+    auto it = m_targets.find(name);
+    if (it == m_targets.end()) {
+        qWarning() << QString("ReachabilityMonitor::start - Unknown target: %1").arg(name);
+        return false;
+    }
+
+    Target& target = it.value();
+    ++target.generation;
+    target.monitoring = true;
+    target.failures = 0;
+    target.status = Status::Unknown;
+    if (target.timer) {
+        target.timer->stop();
+    }
+    probeTarget(name);
+    return true;
+}
+
+void ReachabilityMonitor::stop(const QString& name)
+{
+    auto it = m_targets.find(name);
+    if (it == m_targets.end()) {
+        return;
+    }
+
+    Target& target = it.value();
+    ++target.generation;
+    target.monitoring = false;
+    if (target.timer) {
+        target.timer->stop();
+    }
+}
+
+void ReachabilityMonitor::stopAll()
+{
+    const QStringList names = m_targets.keys();
+    for (const QString& name : names) {
+        stop(name);
+    }
+}
+
+bool ReachabilityMonitor::isMonitoring(const QString& name) const
+{
+    auto it = m_targets.constFind(name);
+    return it != m_targets.constEnd() && it.value().monitoring;
+}
+
+ReachabilityMonitor::Status ReachabilityMonitor::status(const QString& name) const
+{
+    auto it = m_targets.constFind(name);
+    return it == m_targets.constEnd() ? Status::Unknown : it.value().status;
+}
+
+int ReachabilityMonitor::consecutiveFailures(const QString& name) const
+{
+    auto it = m_targets.constFind(name);
+    return it == m_targets.constEnd() ? 0 : it.value().failures;
+}
+
+QList<int> ReachabilityMonitor::rttHistory(const QString& name) const
+{
+    auto it = m_targets.constFind(name);
+    return it == m_targets.constEnd() ? QList<int>() : it.value().rtts;
+}
+
+double ReachabilityMonitor::averageRtt(const QString& name) const
+{
+    const QList<int> rtts = rttHistory(name);
+    if (rtts.isEmpty()) {
+        return -1.0;
+    }
+    return std::accumulate(rtts.cbegin(), rtts.cend(), 0.0) / rtts.size();
+}
+
+void ReachabilityMonitor::setInterval(int intervalMs)
+{
+    m_intervalMs = std::max(RETRY_DELAY_MS, intervalMs);
+}
+
+void ReachabilityMonitor::setTimeout(int timeoutMs)
+{
+    m_timeoutMs = std::max(1, timeoutMs);
+}
+
+void ReachabilityMonitor::setJitter(int percent)
+{
+    m_jitterPercent = std::clamp(percent, 0, 100);
+}
+
+void ReachabilityMonitor::setFailureThreshold(int failures)
+{
+    m_failureThreshold = std::max(1, failures);
+}
+
+void ReachabilityMonitor::probeOnce(const QString& host, quint16 port, int timeoutMs, ProbeCallback callback)
+{
+    QTcpSocket* socket = new QTcpSocket(this);
+    QTimer* timeoutTimer = new QTimer(socket);
+    timeoutTimer->setSingleShot(true);
+
+    QElapsedTimer clock;
+    clock.start();
+
+    // Whichever of connected, error and timeout comes first decides the result;
+    // the socket is silenced before abort() so nothing reports twice
+    auto finish = [socket, timeoutTimer, clock, callback](ProbeResult result) {
+        result.rttMs = static_cast<int>(clock.elapsed());
+        socket->disconnect();
+        timeoutTimer->stop();
+        socket->abort();
+        socket->deleteLater();
+        if (callback) {
+            callback(result);
+        }
+    };
+
+    connect(socket, &QTcpSocket::connected, this, [finish]() {
+        ProbeResult result;
+        result.reachable = true;
+        finish(result);
+    });
+    connect(socket, &QTcpSocket::errorOccurred, this, [socket, finish](QAbstractSocket::SocketError error) {
+        ProbeResult result;
+        result.error = error;
+        result.errorString = socket->errorString();
+        finish(result);
+    });
+    connect(timeoutTimer, &QTimer::timeout, this, [timeoutMs, finish]() {
+        ProbeResult result;
+        result.error = QAbstractSocket::SocketTimeoutError;
+        result.errorString = QString("No answer within %1 ms").arg(timeoutMs);
+        finish(result);
+    });
+
+    socket->connectToHost(host, port);
+    timeoutTimer->start(std::max(1, timeoutMs));
+}
+
+int ReachabilityMonitor::jitteredDelay(int delayMs, int percent)
+{
+    const int spread = delayMs * std::clamp(percent, 0, 100) / 100;
+    if (spread <= 0) {
+        return delayMs;
+    }
+    return delayMs - spread + QRandomGenerator::global()->bounded(2 * spread + 1);
+}
+
+void ReachabilityMonitor::probeTarget(const QString& name)
+{
+    const Target& target = m_targets[name];
+    const quint64 generation = target.generation;
+    probeOnce(target.host, target.port, m_timeoutMs, [this, name, generation](const ProbeResult& result) {
+        onTargetProbed(name, generation, result);
+    });
+}
+
+void ReachabilityMonitor::onTargetProbed(const QString& name, quint64 generation, const ProbeResult& result)
+{
+    auto it = m_targets.find(name);
+    if (it == m_targets.end() || it.value().generation != generation || !it.value().monitoring) {
+        return;
+    }
+
+    Target& target = it.value();
+    int nextDelay = m_intervalMs;
+    if (result.reachable) {
+        target.failures = 0;
+        target.rtts.append(result.rttMs);
+        if (target.rtts.size() > RTT_HISTORY_SIZE) {
+            target.rtts.removeFirst();
+        }
+    } else {
+        ++target.failures;
+        qDebug() << "ReachabilityMonitor:" << name << "probe failed (" << target.failures << "in a row):"
+                 << result.errorString;
+        if (target.failures < m_failureThreshold) {
+            nextDelay = RETRY_DELAY_MS;
+        }
+    }
+
+    const bool down = !result.reachable && target.failures >= m_failureThreshold;
+    scheduleProbe(name, nextDelay);
+    emit probeFinished(name, result.reachable, result.rttMs);
+
+    // A probeFinished() listener may have stopped, restarted or removed the target
+    it = m_targets.find(name);
+    if (it == m_targets.end() || it.value().generation != generation) {
+        return;
+    }
+    if (result.reachable) {
+        setStatus(name, Status::Reachable);
+    } else if (down) {
+        setStatus(name, Status::Unreachable);
+    }
+}
+
+void ReachabilityMonitor::scheduleProbe(const QString& name, int delayMs)
+{
+    Target& target = m_targets[name];
+    if (!target.timer) {
+        target.timer = new QTimer(this);
+        target.timer->setSingleShot(true);
+        connect(target.timer, &QTimer::timeout, this, [this, name]() {
+            if (isMonitoring(name)) {
+                probeTarget(name);
+            }
+        });
+    }
+    target.timer->start(jitteredDelay(delayMs, m_jitterPercent));
+}
+
+void ReachabilityMonitor::setStatus(const QString& name, Status status)
+{
+    auto it = m_targets.find(name);
+    if (it == m_targets.end() || it.value().status == status) {
+        return;
+    }
+    it.value().status = status;
+    emit statusChanged(name, status);
+}
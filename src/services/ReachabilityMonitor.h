@@ -0,0 +1,230 @@
+#ifndef REACHABILITYMONITOR_H
+#define REACHABILITYMONITOR_H
+
+#include <QAbstractSocket>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <functional>
+
+class QTimer;
+
+/**
+ * @brief Watches remote hosts with TCP connect probes
+ *
+ * The TakeOver link used to be checked by spawning the ping binary every
+ * 30 seconds and reading its exit code, so a dead client went unnoticed for
+ * up to half a minute and every check cost a fork/exec. ReachabilityMonitor
+ * opens a TCP connection to the service the hosts are expected to run
+ * instead. A completed handshake means reachable, and the time it took is
+ * recorded as the round trip time. A refused connection, an error or no
+ * answer within the timeout counts as a failure.
+ *
+ * Each target is probed every interval(), give or take jitter() percent so
+ * that several monitors do not probe in lockstep. After a failure the next
+ * probe follows RETRY_DELAY_MS later, and failureThreshold() failures in a
+ * row mark the target unreachable. statusChanged() fires only on the
+ * transitions, so a listener reacts to an outage once rather than on every
+ * failed probe.
+ *
+ * @example
+ * @code
+ * ReachabilityMonitor* monitor = new ReachabilityMonitor(this);
+ * monitor->addTarget("takeover", "192.168.1.20", 8888);
+ * connect(monitor, &ReachabilityMonitor::statusChanged, this,
+ *         [](const QString& name, ReachabilityMonitor::Status status) {
+ *             if (status == ReachabilityMonitor::Status::Unreachable)
+ *                 qWarning() << name << "is down";
+ *         });
+ * monitor->start("takeover");
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class ReachabilityMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class Status {
+        Unknown,     ///< Not probed since start()
+        Reachable,   ///< The last probe connected
+        Unreachable  ///< failureThreshold() probes in a row failed
+    };
+    Q_ENUM(Status)
+
+    /**
+     * @brief Outcome of one connect probe
+     */
+    struct ProbeResult {
+        bool reachable = false;
+        int rttMs = -1;  ///< Time to connect, or to fail
+        QAbstractSocket::SocketError error = QAbstractSocket::UnknownSocketError;
+        QString errorString;
+    };
+
+    using ProbeCallback = std::function<void(const ProbeResult& result)>;
+
+    static constexpr int DEFAULT_INTERVAL_MS = 1000;
+    static constexpr int DEFAULT_TIMEOUT_MS = 1000;
+    static constexpr int DEFAULT_JITTER_PERCENT = 10;
+    static constexpr int DEFAULT_FAILURE_THRESHOLD = 2;
+    /// Delay before re-probing a target whose last probe failed
+    static constexpr int RETRY_DELAY_MS = 200;
+    /// Number of round trip times kept per target
+    static constexpr int RTT_HISTORY_SIZE = 60;
+
+    explicit ReachabilityMonitor(QObject* parent = nullptr);
+
+    /**
+     * @brief Register a host to watch, or change where an existing target points
+     *
+     * A target that is being monitored restarts with the new address.
+     * @param name Name the target is addressed by
+     * @param host Host name or address
+     * @param port TCP port of a service the host runs
+     */
+    void addTarget(const QString& name, const QString& host, quint16 port);
+
+    /**
+     * @brief Stop watching a target and forget it
+     * @param name Target name
+     */
+    void removeTarget(const QString& name);
+
+    /**
+     * @brief Check if a target is registered
+     * @param name Target name
+     * @return true if addTarget() registered it
+     */
+    bool hasTarget(const QString& name) const { return m_targets.contains(name); }
+
+    /**
+     * @brief Start probing a target, from the Unknown status
+     * @param name Target name
+     * @return false if no such target is registered
+     */
+    bool start(const QString& name);
+
+    /**
+     * @brief Stop probing a target
+     *
+     * A probe in flight is abandoned and its result dropped.
+     * @param name Target name
+     */
+    void stop(const QString& name);
+
+    /**
+     * @brief Stop probing every target
+     */
+    void stopAll();
+
+    /**
+     * @brief Check if a target is being probed
+     * @param name Target name
+     * @return true between start() and stop()
+     */
+    bool isMonitoring(const QString& name) const;
+
+    /**
+     * @brief Get the status of a target
+     * @param name Target name
+     * @return Current status, Unknown for unknown names
+     */
+    Status status(const QString& name) const;
+
+    /**
+     * @brief Get the number of failed probes since the last success
+     * @param name Target name
+     * @return Consecutive failures
+     */
+    int consecutiveFailures(const QString& name) const;
+
+    /**
+     * @brief Get the round trip times of the latest successful probes
+     * @param name Target name
+     * @return Up to RTT_HISTORY_SIZE times in milliseconds, oldest first
+     */
+    QList<int> rttHistory(const QString& name) const;
+
+    /**
+     * @brief Get the mean of the recorded round trip times
+     * @param name Target name
+     * @return Mean in milliseconds, or -1 without history
+     */
+    double averageRtt(const QString& name) const;
+
+    void setInterval(int intervalMs);
+    int interval() const { return m_intervalMs; }
+
+    void setTimeout(int timeoutMs);
+    int timeout() const { return m_timeoutMs; }
+
+    void setJitter(int percent);
+    int jitter() const { return m_jitterPercent; }
+
+    void setFailureThreshold(int failures);
+    int failureThreshold() const { return m_failureThreshold; }
+
+    /**
+     * @brief Probe a host once, outside of any target
+     *
+     * The callback runs on this object's thread once the connection is made,
+     * fails or times out. It does not run if the monitor is destroyed first.
+     * @param host Host name or address
+     * @param port TCP port
+     * @param timeoutMs Time to wait for the handshake
+     * @param callback Receives the result
+     */
+    void probeOnce(const QString& host, quint16 port, int timeoutMs, ProbeCallback callback);
+
+    /**
+     * @brief Spread a delay by up to a percentage either way
+     * @param delayMs Base delay
+     * @param percent Largest deviation, in percent of the delay
+     * @return Delay between delayMs - percent% and delayMs + percent%
+     */
+    static int jitteredDelay(int delayMs, int percent);
+
+signals:
+    /**
+     * @brief Emitted after every probe of a monitored target
+     * @param name Target name
+     * @param reachable true if the probe connected
+     * @param rttMs Time the probe took
+     */
+    void probeFinished(const QString& name, bool reachable, int rttMs);
+
+    /**
+     * @brief Emitted when a target becomes reachable or unreachable
+     * @param name Target name
+     * @param status New status
+     */
+    void statusChanged(const QString& name, ReachabilityMonitor::Status status);
+
+private:
+    struct Target {
+        QString host;
+        quint16 port = 0;
+        QTimer* timer = nullptr;
+        bool monitoring = false;
+        quint64 generation = 0;  ///< Bumped by start/stop so stale results are dropped
+        Status status = Status::Unknown;
+        int failures = 0;
+        QList<int> rtts;
+    };
+
+    void probeTarget(const QString& name);
+    void onTargetProbed(const QString& name, quint64 generation, const ProbeResult& result);
+    void scheduleProbe(const QString& name, int delayMs);
+    void setStatus(const QString& name, Status status);
+
+    QHash<QString, Target> m_targets;
+    int m_intervalMs = DEFAULT_INTERVAL_MS;
+    int m_timeoutMs = DEFAULT_TIMEOUT_MS;
+    int m_jitterPercent = DEFAULT_JITTER_PERCENT;
+    int m_failureThreshold = DEFAULT_FAILURE_THRESHOLD;
+};
+
+#endif // REACHABILITYMONITOR_H
@@ -0,0 +1,717 @@
+#include "RemoteControlServer.h"
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QJsonDocument>
+#include <QJsonParseError>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QUrlQuery>
+#include <QtEndian>
+#include <algorithm>
+
+namespace {
+
+constexpr int OPCODE_CONTINUATION = 0x0;
+constexpr int OPCODE_TEXT = 0x1;
+constexpr int OPCODE_CLOSE = 0x8;
+constexpr int OPCODE_PING = 0x9;
+constexpr int OPCODE_PONG = 0xA;
+
+constexpr quint16 CLOSE_GOING_AWAY = 1001;
+constexpr quint16 CLOSE_PROTOCOL_ERROR = 1002;
+constexpr quint16 CLOSE_UNSUPPORTED = 1003;
+constexpr quint16 CLOSE_TOO_BIG = 1009;
+
+QByteArray compact(const QJsonValue& value)
+{
+    if (value.isObject()) {
+        return QJsonDocument(value.toObject()).toJson(QJsonDocument::Compact);
+    }
+    return QJsonDocument(QJsonArray{value}).toJson(QJsonDocument::Compact);
+}
+
+// Compares in the same time however much of the token is right
+bool sameToken(const QByteArray& given, const QByteArray& token)
+{
+    if (given.size() != token.size()) {
+        return false;
+    }
+    char difference = 0;
+    for (qsizetype i = 0; i < token.size(); ++i) {
+        difference |= char(given[i] ^ token[i]);
+    }
+    return difference == 0;
+}
+
+} // namespace
+
+RemoteControlServer::RemoteControlServer(QObject* parent)
+    : QObject(parent)
+    , m_server(new QTcpServer(this))
+    , m_flushTimer(new QTimer(this))
+{
+    m_clock.start();
+    m_flushTimer->setSingleShot(true);
+    connect(m_flushTimer, &QTimer::timeout, this, &RemoteControlServer::flush);
+    connect(m_server, &QTcpServer::newConnection, this, &RemoteControlServer::onNewConnection);
+}
+
+RemoteControlServer::~RemoteControlServer() = default;
+
+bool RemoteControlServer::listen(quint16 port, const QHostAddress& address)
+{
+    close();
+    if (!m_server->listen(address, port)) {
+        logError("listen", QString("Cannot listen on %1:%2: %3")
+                               .arg(address.toString())
+                               .arg(port)
+                               .arg(m_server->errorString()));
+        return false;
+    }
+    qInfo() << "RemoteControlServer: serving the remote API on port" << m_server->serverPort();
+    return true;
+}
+
+void RemoteControlServer::close()
+{
+    if (m_server->isListening()) {
+        m_server->close();
+    }
+    const QList<std::shared_ptr<Client>> clients = m_clients.values();
+    for (const std::shared_ptr<Client>& client : clients) {
+        closeClient(*client, CLOSE_GOING_AWAY);
+    }
+}
+
+bool RemoteControlServer::isListening() const
+{
+    return m_server->isListening();
+}
+
+quint16 RemoteControlServer::port() const
+{
+    return m_server->isListening() ? m_server->serverPort() : 0;
+}
+
+void RemoteControlServer::publish(const QString& topic, const QJsonValue& value)
+{
+    auto it = m_topics.find(topic);
+    if (it != m_topics.end() && it->value == value) {
+        return;
+    }
+    m_topics.insert(topic, {value, ++m_seq});
+    if (!m_clients.isEmpty()) {
+        // Every publish of this pass of the event loop goes out together
+        scheduleFlush(0);
+    }
+}
+
+QJsonValue RemoteControlServer::value(const QString& topic) const
+{
+    const auto it = m_topics.constFind(topic);
+    return it == m_topics.constEnd() ? QJsonValue(QJsonValue::Undefined) : it->value;
+}
+
+void RemoteControlServer::addCommand(const QString& name, CommandHandler handler)
+{
+    m_commands.insert(name, std::move(handler));
+}
+
+void RemoteControlServer::addDocument(const QString& name, DocumentBuilder builder)
+{
+    m_documents.insert(name, std::move(builder));
+}
+
+void RemoteControlServer::addQuery(const QString& name, QueryHandler handler)
+{
+    m_queries.insert(name, std::move(handler));
+}
+
+QJsonObject RemoteControlServer::spliceDiff(const QJsonArray& from, const QJsonArray& to)
+{
+    const qsizetype shorter = std::min(from.size(), to.size());
+    qsizetype head = 0;
+    while (head < shorter && from.at(head) == to.at(head)) {
+        ++head;
+    }
+    qsizetype tail = 0;
+    while (tail < shorter - head
+           && from.at(from.size() - 1 - tail) == to.at(to.size() - 1 - tail)) {
+        ++tail;
+    }
+
+    QJsonArray insert;
+    for (qsizetype i = head; i < to.size() - tail; ++i) {
+        insert.append(to.at(i));
+    }
+    return {{"index", double(head)}, {"remove", double(from.size() - tail - head)},
+            {"insert", insert}};
+}
+
+QJsonArray RemoteControlServer::applySplice(const QJsonArray& array, const QJsonObject& splice)
+{
+    const qsizetype index = std::clamp<qsizetype>(splice.value("index").toInteger(), 0,
+                                                  array.size());
+    const qsizetype remove = std::clamp<qsizetype>(splice.value("remove").toInteger(), 0,
+                                                   array.size() - index);
+    QJsonArray result;
+    for (qsizetype i = 0; i < index; ++i) {
+        result.append(array.at(i));
+    }
+    for (const QJsonValue& value : splice.value("insert").toArray()) {
+        result.append(value);
+    }
+    for (qsizetype i = index + remove; i < array.size(); ++i) {
+        result.append(array.at(i));
+    }
+    return result;
+}
+
+QByteArray RemoteControlServer::encodeFrame(int opcode, const QByteArray& payload)
+{
+    QByteArray frame;
+    frame.reserve(payload.size() + 10);
+    frame.append(char(0x80 | (opcode & 0x0F)));
+    if (payload.size() < 126) {
+        frame.append(char(payload.size()));
+    } else if (payload.size() <= 0xFFFF) {
+        frame.append(char(126));
+        char length[2];
+        qToBigEndian<quint16>(quint16(payload.size()), length);
+        frame.append(length, 2);
+    } else {
+        frame.append(char(127));
+        char length[8];
+        qToBigEndian<quint64>(quint64(payload.size()), length);
+        frame.append(length, 8);
+    }
+    frame.append(payload);
+    return frame;
+}
+
+QByteArray RemoteControlServer::acceptKey(const QByteArray& key)
+{
+    return QCryptographicHash::hash(key.trimmed() + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11",
+                                    QCryptographicHash::Sha1)
+        .toBase64();
+}
+
+void RemoteControlServer::onNewConnection()
+{
+    while (QTcpSocket* socket = m_server->nextPendingConnection()) {
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+
+        auto pending = std::make_shared<Pending>();
+        pending->timeout = new QTimer(socket);
+        pending->timeout->setSingleShot(true);
+        connect(pending->timeout, &QTimer::timeout, socket, &QTcpSocket::abort);
+        pending->timeout->start(REQUEST_TIMEOUT_MS);
+
+        connect(socket, &QTcpSocket::readyRead, this,
+                [this, socket, pending]() { readRequest(socket, *pending); });
+    }
+}
+
+void RemoteControlServer::readRequest(QTcpSocket* socket, Pending& pending)
+{
+    pending.buffer += socket->readAll();
+    const qsizetype end = pending.buffer.indexOf("\r\n\r\n");
+    if (end < 0) {
+        if (pending.buffer.size() > MAX_REQUEST_BYTES) {
+            disconnect(socket, &QTcpSocket::readyRead, this, nullptr);
+            respond(socket, "431 Request Header Fields Too Large", "text/plain",
+                    "Request too large\n");
+        }
+        return;
+    }
+    if (end > MAX_REQUEST_BYTES) {
+        disconnect(socket, &QTcpSocket::readyRead, this, nullptr);
+        respond(socket, "431 Request Header Fields Too Large", "text/plain",
+                "Request too large\n");
+        return;
+    }
+
+    Request request;
+    const QList<QByteArray> lines = pending.buffer.left(end).split('\n');
+    const QList<QByteArray> requestLine = lines.value(0).trimmed().split(' ');
+    request.method = requestLine.value(0);
+    QByteArray target = requestLine.value(1);
+    const qsizetype queryStart = target.indexOf('?');
+    if (queryStart >= 0) {
+        const QUrlQuery query(QString::fromUtf8(target.mid(queryStart + 1)));
+        for (const auto& item : query.queryItems(QUrl::FullyDecoded)) {
+            request.query.insert(item.first.toUtf8(), item.second.toUtf8());
+        }
+        target.truncate(queryStart);
+    }
+    request.path = target;
+    for (qsizetype i = 1; i < lines.size(); ++i) {
+        const qsizetype colon = lines[i].indexOf(':');
+        if (colon > 0) {
+            request.headers.insert(lines[i].left(colon).trimmed().toLower(),
+                                   lines[i].mid(colon + 1).trimmed());
+        }
+    }
+
+    const qint64 length = request.headers.value("content-length", "0").toLongLong();
+    if (length < 0 || length > MAX_MESSAGE_BYTES) {
+        disconnect(socket, &QTcpSocket::readyRead, this, nullptr);
+        respond(socket, "413 Payload Too Large", "text/plain", "Body too large\n");
+        return;
+    }
+    const qsizetype bodyStart = end + 4;
+    if (pending.buffer.size() - bodyStart < length) {
+        return;
+    }
+
+    // One request per connection, unless it becomes a WebSocket
+    disconnect(socket, &QTcpSocket::readyRead, this, nullptr);
+    pending.timeout->stop();
+    request.body = pending.buffer.mid(bodyStart, length);
+    handleRequest(socket, request, pending.buffer.mid(bodyStart + length));
+}
+
+void RemoteControlServer::handleRequest(QTcpSocket* socket, const Request& request,
+                                        const QByteArray& rest)
+{
+    if (!request.path.startsWith("/api/")) {
+        respond(socket, "404 Not Found", "text/plain", "Not found\n");
+        return;
+    }
+    if (!authorized(request)) {
+        respond(socket, "401 Unauthorized", "text/plain", "Token required\n");
+        return;
+    }
+
+    const QString name = QString::fromUtf8(request.path.mid(5));
+    if (name == "ws") {
+        upgrade(socket, request, rest);
+        return;
+    }
+
+    if (request.method == "POST" && name.startsWith("command/")) {
+        QJsonObject args;
+        if (!request.body.trimmed().isEmpty()) {
+            QJsonParseError error;
+            const QJsonDocument document = QJsonDocument::fromJson(request.body, &error);
+            if (error.error != QJsonParseError::NoError || !document.isObject()) {
+                respondJson(socket, "400 Bad Request",
+                            {{"ok", false}, {"error", "Arguments must be a JSON object"}});
+                return;
+            }
+            args = document.object();
+        }
+        QByteArray status;
+        const QJsonObject result =
+            runCommand(name.mid(8), args, socket->peerAddress(), &status);
+        respondJson(socket, status, result);
+        return;
+    }
+
+    if (request.method != "GET") {
+        respond(socket, "405 Method Not Allowed", "text/plain", "Only GET, or POST a command\n");
+        return;
+    }
+    if (name == "state") {
+        respondJson(socket, "200 OK", state());
+        return;
+    }
+    QJsonObject args;
+    for (auto it = request.query.constBegin(); it != request.query.constEnd(); ++it) {
+        if (it.key() != "token") {
+            args.insert(QString::fromUtf8(it.key()), QString::fromUtf8(it.value()));
+        }
+    }
+    const QJsonObject result = getValue(name, args);
+    respondJson(socket, result.value("ok").toBool() ? "200 OK" : "404 Not Found", result);
+}
+
+void RemoteControlServer::upgrade(QTcpSocket* socket, const Request& request,
+                                  const QByteArray& rest)
+{
+    const QByteArray key = request.headers.value("sec-websocket-key");
+    if (request.method != "GET"
+        || !request.headers.value("upgrade").toLower().contains("websocket") || key.isEmpty()) {
+        respond(socket, "400 Bad Request", "text/plain", "WebSocket upgrade expected\n");
+        return;
+    }
+    if (request.headers.value("sec-websocket-version") != "13") {
+        respond(socket, "426 Upgrade Required", "text/plain", "WebSocket version 13 only\n");
+        return;
+    }
+    if (m_clients.size() >= MAX_CLIENTS) {
+        respond(socket, "503 Service Unavailable", "text/plain", "Too many clients\n");
+        return;
+    }
+
+    socket->write("HTTP/1.1 101 Switching Protocols\r\n"
+                  "Upgrade: websocket\r\n"
+                  "Connection: Upgrade\r\n"
+                  "Sec-WebSocket-Accept: " + acceptKey(key) + "\r\n\r\n");
+    socket->setSocketOption(QAbstractSocket::KeepAliveOption, 1);
+
+    auto client = std::make_shared<Client>();
+    client->socket = socket;
+    client->frames = rest;
+    m_clients.insert(socket, client);
+
+    connect(socket, &QTcpSocket::readyRead, this, [this, socket]() {
+        // Held while parsing, as a close may drop the client from m_clients
+        const std::shared_ptr<Client> client = m_clients.value(socket);
+        if (client) {
+            client->frames += socket->readAll();
+            readFrames(*client);
+        }
+    });
+    connect(socket, &QTcpSocket::disconnected, this, [this, socket]() { dropClient(socket); });
+
+    emit clientsChanged(clientCount());
+    sendSnapshot(*client);
+    if (!client->frames.isEmpty()) {
+        readFrames(*client);
+    }
+}
+
+bool RemoteControlServer::authorized(const Request& request) const
+{
+    if (m_token.isEmpty()) {
+        return true;
+    }
+    const QByteArray header = request.headers.value("authorization");
+    if (header.startsWith("Bearer ") && sameToken(header.mid(7).trimmed(), m_token)) {
+        return true;
+    }
+    return sameToken(request.query.value("token"), m_token);
+}
+
+bool RemoteControlServer::takeCommandToken(const QHostAddress& peer)
+{
+    if (m_buckets.size() > 256) {
+        m_buckets.clear();   // Forget idle peers rather than grow without bound
+    }
+    const qint64 now = m_clock.elapsed();
+    Bucket& bucket = m_buckets[peer.toString()];
+    if (bucket.updatedMs == 0) {
+        bucket.updatedMs = now;
+    }
+    bucket.tokens = std::min<double>(
+        COMMAND_BURST, bucket.tokens + (now - bucket.updatedMs) * COMMANDS_PER_SECOND / 1000.0);
+    bucket.updatedMs = now;
+    if (bucket.tokens < 1.0) {
+        return false;
+    }
+    bucket.tokens -= 1.0;
+    return true;
+}
+
+QJsonObject RemoteControlServer::runCommand(const QString& name, const QJsonObject& args,
+                                            const QHostAddress& peer, QByteArray* status)
+{
+    const auto handler = m_commands.constFind(name);
+    if (handler == m_commands.constEnd()) {
+        if (status) {
+            *status = "404 Not Found";
+        }
+        return {{"ok", false}, {"error", "Unknown command: " + name}};
+    }
+    if (!takeCommandToken(peer)) {
+        if (status) {
+            *status = "429 Too Many Requests";
+        }
+        return {{"ok", false}, {"error", "Too many commands, slow down"}};
+    }
+
+    const QString error = (*handler)(args);
+    if (!error.isEmpty()) {
+        if (status) {
+            *status = "400 Bad Request";
+        }
+        return {{"ok", false}, {"error", error}};
+    }
+    if (status) {
+        *status = "200 OK";
+    }
+    return {{"ok", true}};
+}
+
+QJsonObject RemoteControlServer::getValue(const QString& name, const QJsonObject& args) const
+{
+    const auto topic = m_topics.constFind(name);
+    if (topic != m_topics.constEnd()) {
+        return {{"ok", true}, {"value", topic->value}, {"seq", double(topic->seq)}};
+    }
+    const auto document = m_documents.constFind(name);
+    if (document != m_documents.constEnd()) {
+        return {{"ok", true}, {"value", (*document)()}};
+    }
+    const auto query = m_queries.constFind(name);
+    if (query != m_queries.constEnd()) {
+        return {{"ok", true}, {"value", (*query)(args)}};
+    }
+    return {{"ok", false}, {"error", "Unknown name: " + name}};
+}
+
+QJsonObject RemoteControlServer::state() const
+{
+    QJsonObject topics;
+    for (auto it = m_topics.constBegin(); it != m_topics.constEnd(); ++it) {
+        topics.insert(it.key(), it->value);
+    }
+    return {{"seq", double(m_seq)}, {"topics", topics}};
+}
+
+void RemoteControlServer::readFrames(Client& client)
+{
+    QTcpSocket* socket = client.socket;
+    while (socket->state() == QAbstractSocket::ConnectedState && client.frames.size() >= 2) {
+        const QByteArray& data = client.frames;
+        const quint8 first = quint8(data[0]);
+        const quint8 second = quint8(data[1]);
+        const bool fin = first & 0x80;
+        const int opcode = first & 0x0F;
+
+        quint64 length = second & 0x7F;
+        qsizetype offset = 2;
+        if (length == 126) {
+            if (data.size() < 4) {
+                return;
+            }
+            length = qFromBigEndian<quint16>(data.constData() + 2);
+            offset = 4;
+        } else if (length == 127) {
+            if (data.size() < 10) {
+                return;
+            }
+            length = qFromBigEndian<quint64>(data.constData() + 2);
+            offset = 10;
+        }
+
+        // Clients must mask what they send
+        if (!(second & 0x80)) {
+            closeClient(client, CLOSE_PROTOCOL_ERROR);
+            return;
+        }
+        if (length > quint64(MAX_MESSAGE_BYTES)
+            || quint64(client.message.size()) + length > quint64(MAX_MESSAGE_BYTES)) {
+            closeClient(client, CLOSE_TOO_BIG);
+            return;
+        }
+        if (quint64(data.size()) < quint64(offset) + 4 + length) {
+            return;
+        }
+
+        const char* mask = data.constData() + offset;
+        QByteArray payload = data.mid(offset + 4, qsizetype(length));
+        for (qsizetype i = 0; i < payload.size(); ++i) {
+            payload[i] = char(payload[i] ^ mask[i % 4]);
+        }
+        client.frames.remove(0, offset + 4 + qsizetype(length));
+
+        switch (opcode) {
+        case OPCODE_CLOSE:
+            socket->write(encodeFrame(OPCODE_CLOSE, payload.left(2)));
+            socket->disconnectFromHost();
+            return;
+        case OPCODE_PING:
+            socket->write(encodeFrame(OPCODE_PONG, payload));
+            break;
+        case OPCODE_PONG:
+            break;
+        case OPCODE_TEXT:
+        case OPCODE_CONTINUATION:
+            if ((opcode == OPCODE_TEXT) == client.fragmented) {
+                closeClient(client, CLOSE_PROTOCOL_ERROR);
+                return;
+            }
+            client.message += payload;
+            client.fragmented = !fin;
+            if (fin) {
+                const QByteArray message = client.message;
+                client.message.clear();
+                handleMessage(client, message);
+            }
+            break;
+        default:
+            closeClient(client, CLOSE_UNSUPPORTED);
+            return;
+        }
+    }
+}
+
+void RemoteControlServer::closeClient(Client& client, quint16 code)
+{
+    char payload[2];
+    qToBigEndian<quint16>(code, payload);
+    client.socket->write(encodeFrame(OPCODE_CLOSE, QByteArray(payload, 2)));
+    client.socket->disconnectFromHost();
+}
+
+void RemoteControlServer::handleMessage(Client& client, const QByteArray& message)
+{
+    QJsonParseError error;
+    const QJsonDocument document = QJsonDocument::fromJson(message, &error);
+    if (error.error != QJsonParseError::NoError || !document.isObject()) {
+        sendMessage(client, {{"type", "error"}, {"error", "Messages must be JSON objects"}});
+        return;
+    }
+    const QJsonObject request = document.object();
+    const QString type = request.value("type").toString();
+
+    if (type == "subscribe") {
+        client.topics.clear();
+        for (const QJsonValue& topic : request.value("topics").toArray()) {
+            client.topics.insert(topic.toString());
+        }
+        if (request.contains("intervalMs")) {
+            client.intervalMs = std::clamp(request.value("intervalMs").toInt(),
+                                           MIN_PUSH_INTERVAL_MS, MAX_PUSH_INTERVAL_MS);
+        }
+        sendSnapshot(client);
+        return;
+    }
+
+    QJsonObject result;
+    if (type == "command") {
+        result = runCommand(request.value("command").toString(),
+                            request.value("args").toObject(), client.socket->peerAddress());
+    } else if (type == "get") {
+        result = getValue(request.value("name").toString(), request.value("args").toObject());
+    } else {
+        result = {{"ok", false}, {"error", "Unknown message type: " + type}};
+    }
+    result.insert("type", "result");
+    if (request.contains("id")) {
+        result.insert("id", request.value("id"));
+    }
+    sendMessage(client, result);
+}
+
+void RemoteControlServer::sendMessage(Client& client, const QJsonObject& message)
+{
+    client.socket->write(encodeFrame(OPCODE_TEXT, QJsonDocument(message).toJson(
+                                                      QJsonDocument::Compact)));
+}
+
+void RemoteControlServer::sendSnapshot(Client& client)
+{
+    QJsonObject topics;
+    client.sentSeq.clear();
+    client.sentValues.clear();
+    for (auto it = m_topics.constBegin(); it != m_topics.constEnd(); ++it) {
+        if (follows(client, it.key())) {
+            topics.insert(it.key(), it->value);
+            client.sentSeq.insert(it.key(), it->seq);
+            client.sentValues.insert(it.key(), it->value);
+        }
+    }
+    sendMessage(client, {{"type", "snapshot"}, {"seq", double(m_seq)}, {"topics", topics}});
+    client.lastPushMs = m_clock.elapsed();
+}
+
+void RemoteControlServer::flush()
+{
+    const qint64 now = m_clock.elapsed();
+    qint64 nextDue = -1;
+
+    for (const std::shared_ptr<Client>& client : std::as_const(m_clients)) {
+        QStringList changed;
+        for (auto it = m_topics.constBegin(); it != m_topics.constEnd(); ++it) {
+            if (follows(*client, it.key()) && it->seq > client->sentSeq.value(it.key())) {
+                changed.append(it.key());
+            }
+        }
+        if (changed.isEmpty()) {
+            continue;
+        }
+
+        // Too soon, or the client has not read what it was sent: coalesce
+        const qint64 due = client->lastPushMs + client->intervalMs;
+        if (now < due || client->socket->bytesToWrite() > MAX_PENDING_BYTES) {
+            const qint64 retry = std::max(due, now + MIN_PUSH_INTERVAL_MS);
+            nextDue = nextDue < 0 ? retry : std::min(nextDue, retry);
+            continue;
+        }
+
+        QJsonObject topics;
+        QJsonObject splices;
+        for (const QString& name : std::as_const(changed)) {
+            const Topic& topic = m_topics[name];
+            const QJsonValue sent = client->sentValues.value(name);
+            bool spliced = false;
+            if (topic.value.isArray() && sent.isArray()) {
+                const QJsonObject splice = spliceDiff(sent.toArray(), topic.value.toArray());
+                if (compact(splice).size() < compact(topic.value).size()) {
+                    splices.insert(name, splice);
+                    spliced = true;
+                }
+            }
+            if (!spliced) {
+                topics.insert(name, topic.value);
+            }
+            client->sentSeq.insert(name, topic.seq);
+            client->sentValues.insert(name, topic.value);
+        }
+
+        QJsonObject update{{"type", "update"}, {"seq", double(m_seq)}, {"topics", topics}};
+        if (!splices.isEmpty()) {
+            update.insert("splices", splices);
+        }
+        sendMessage(*client, update);
+        client->lastPushMs = now;
+    }
+
+    if (nextDue >= 0) {
+        scheduleFlush(int(nextDue - now));
+    }
+}
+
+void RemoteControlServer::scheduleFlush(int delayMs)
+{
+    if (m_flushTimer->isActive() && m_flushTimer->remainingTime() <= delayMs) {
+        return;
+    }
+    m_flushTimer->start(std::max(0, delayMs));
+}
+
+void RemoteControlServer::dropClient(QTcpSocket* socket)
+{
+    if (m_clients.remove(socket)) {
+        emit clientsChanged(clientCount());
+    }
+}
+
+bool RemoteControlServer::follows(const Client& client, const QString& topic) const
+{
+    return client.topics.isEmpty() || client.topics.contains(topic);
+}
+
+void RemoteControlServer::respond(QTcpSocket* socket, const QByteArray& status,
+                                  const QByteArray& contentType, const QByteArray& body)
+{
+    QByteArray response = "HTTP/1.1 " + status + "\r\n";
+    response += "Content-Type: " + contentType + "\r\n";
+    response += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+    if (status.startsWith("401")) {
+        response += "WWW-Authenticate: Bearer\r\n";
+    } else if (status.startsWith("405")) {
+        response += "Allow: GET, POST\r\n";
+    }
+    response += "Connection: close\r\n\r\n";
+    response += body;
+    socket->write(response);
+    socket->disconnectFromHost();
+}
+
+void RemoteControlServer::respondJson(QTcpSocket* socket, const QByteArray& status,
+                                      const QJsonObject& body)
+{
+    respond(socket, status, "application/json",
+            QJsonDocument(body).toJson(QJsonDocument::Compact));
+}
+
+void RemoteControlServer::logError(const QString& operation, const QString& error)
+{
+    qWarning() << QString("RemoteControlServer::%1 - %2").arg(operation, error);
+    emit operationError(operation, error);
+}
@@ -0,0 +1,285 @@
+#ifndef REMOTECONTROLSERVER_H
+#define REMOTECONTROLSERVER_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QHostAddress>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <functional>
+#include <memory>
+
+class QTcpServer;
+class QTcpSocket;
+class QTimer;
+
+/**
+ * @brief REST and WebSocket API for running a station from another machine
+ *
+ * Remote sites were run over VNC, which streams the whole window to move
+ * one fader. RemoteControlServer serves the state of the station as JSON
+ * instead, and pushes changes to it as they happen, so a remote panel
+ * costs kilobytes a minute.
+ *
+ * The state is a set of topics, such as "transport" or "queue", each a
+ * JSON value set with publish(). Commands, such as "next", are handlers
+ * added with addCommand(); they change the station and the change comes
+ * back as an update of a topic. Documents added with addDocument(), such
+ * as the metrics, are only built when asked for, and so are queries added
+ * with addQuery(), which take arguments.
+ *
+ * REST, one request per connection:
+ * - GET /api/state: every topic, and the sequence number of the last change
+ * - GET /api/<name>: one topic, document or query
+ * - POST /api/command/<name>: run a command, arguments as a JSON object body
+ *
+ * WebSocket at /api/ws, text frames of JSON. The server sends a
+ * "snapshot" of the topics on connect and then "update" messages with the
+ * topics that changed. Changes are coalesced: a client gets at most one
+ * update per push interval, DEFAULT_PUSH_INTERVAL_MS unless it asks for
+ * another, with the latest value of each topic, so a position published
+ * every 100 ms costs a client asking for updates every second one message
+ * a second. A topic whose value is an array, like the queue, is sent as a
+ * splice of the array last sent to that client when that is shorter; see
+ * spliceDiff(). No updates are sent to a client that has not read the
+ * previous ones, beyond MAX_PENDING_BYTES, until it has caught up.
+ *
+ * Clients send:
+ * - {"type":"subscribe","topics":[...],"intervalMs":n}: topics to follow
+ *   (all when left out) and the push interval
+ * - {"type":"command","id":n,"command":"next","args":{...}}
+ * - {"type":"get","id":n,"name":"metrics","args":{...}}
+ * and commands and gets are answered with {"type":"result","id":n,"ok":...}.
+ *
+ * Commands are rate limited per address, COMMAND_BURST at once and
+ * COMMANDS_PER_SECOND after that, over REST and WebSocket alike. With a
+ * token set every request has to carry it, as "Authorization: Bearer" or
+ * a token query parameter (browsers cannot set headers on a WebSocket).
+ *
+ * Everything runs on the thread of the server.
+ *
+ * @example
+ * @code
+ * RemoteControlServer* remote = new RemoteControlServer(this);
+ * remote->setToken(settings.value("RemoteToken").toString());
+ * remote->addCommand("next", [this](const QJsonObject&) {
+ *     playbackEngine->skipToNext();
+ *     return QString();
+ * });
+ * remote->publish("transport", QJsonObject{{"nowPlaying", path}});
+ * remote->listen(9106);
+ * // websocat ws://localhost:9106/api/ws
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class RemoteControlServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int MAX_REQUEST_BYTES = 8 * 1024;     ///< HTTP request line and headers
+    static constexpr int MAX_MESSAGE_BYTES = 64 * 1024;    ///< Request body or WebSocket message
+    static constexpr int REQUEST_TIMEOUT_MS = 5 * 1000;
+    static constexpr int MAX_CLIENTS = 16;                 ///< WebSocket connections
+    static constexpr int DEFAULT_PUSH_INTERVAL_MS = 250;
+    static constexpr int MIN_PUSH_INTERVAL_MS = 50;
+    static constexpr int MAX_PUSH_INTERVAL_MS = 60 * 1000;
+    static constexpr qint64 MAX_PENDING_BYTES = 256 * 1024;
+    static constexpr int COMMAND_BURST = 10;
+    static constexpr int COMMANDS_PER_SECOND = 5;
+
+    /// Runs a command; returns an error message, or an empty string when it was done
+    using CommandHandler = std::function<QString(const QJsonObject& args)>;
+
+    /// Builds a document when it is asked for
+    using DocumentBuilder = std::function<QJsonValue()>;
+
+    /// Answers a query from its arguments, query parameters over REST
+    using QueryHandler = std::function<QJsonValue(const QJsonObject& args)>;
+
+    explicit RemoteControlServer(QObject* parent = nullptr);
+    ~RemoteControlServer() override;
+
+    /**
+     * @brief Start accepting clients
+     * @param port TCP port; 0 picks a free one
+     * @param address Address to listen on
+     * @return true if listening
+     */
+    bool listen(quint16 port, const QHostAddress& address = QHostAddress::Any);
+
+    /**
+     * @brief Stop accepting clients and close the WebSocket connections
+     */
+    void close();
+
+    bool isListening() const;
+
+    /**
+     * @brief Port listened on, or 0
+     */
+    quint16 port() const;
+
+    /**
+     * @brief Require a token on every request; empty accepts anyone
+     */
+    void setToken(const QString& token) { m_token = token.toUtf8(); }
+
+    /**
+     * @brief Set the value of a topic
+     *
+     * A value equal to the current one is not a change and pushes nothing.
+     * @param topic Name of the topic
+     * @param value New value
+     */
+    void publish(const QString& topic, const QJsonValue& value);
+
+    /**
+     * @brief Current value of a topic, undefined if it was never published
+     */
+    QJsonValue value(const QString& topic) const;
+
+    /**
+     * @brief Add a command; replaces an earlier one of the same name
+     */
+    void addCommand(const QString& name, CommandHandler handler);
+
+    /**
+     * @brief Add a document served on request; replaces an earlier one of the same name
+     */
+    void addDocument(const QString& name, DocumentBuilder builder);
+
+    /**
+     * @brief Add a query, a document built from arguments; replaces an earlier one
+     *
+     * Served as GET /api/<name>?arg=value, or a "get" message with "args".
+     * Over REST the arguments are strings.
+     */
+    void addQuery(const QString& name, QueryHandler handler);
+
+    /**
+     * @brief Number of WebSocket clients connected
+     */
+    int clientCount() const { return int(m_clients.size()); }
+
+    /**
+     * @brief Describe how to turn one array into another with a single splice
+     *
+     * The elements both share at the start and at the end are kept. Moving
+     * or inserting one entry in a long queue is then a few bytes.
+     * @return {"index":i,"remove":n,"insert":[...]}
+     */
+    static QJsonObject spliceDiff(const QJsonArray& from, const QJsonArray& to);
+
+    /**
+     * @brief Apply a splice made by spliceDiff(), as a client does
+     */
+    static QJsonArray applySplice(const QJsonArray& array, const QJsonObject& splice);
+
+    /**
+     * @brief Frame a WebSocket message as the server sends it, unmasked
+     * @param opcode 0x1 text, 0x8 close, 0x9 ping, 0xA pong
+     */
+    static QByteArray encodeFrame(int opcode, const QByteArray& payload);
+
+    /**
+     * @brief Sec-WebSocket-Accept for a Sec-WebSocket-Key
+     */
+    static QByteArray acceptKey(const QByteArray& key);
+
+signals:
+    /**
+     * @brief Emitted when a WebSocket client connects or leaves
+     */
+    void clientsChanged(int count);
+
+    /**
+     * @brief Emitted when the server cannot listen
+     * @param operation Name of the operation
+     * @param error Error message
+     */
+    void operationError(const QString& operation, const QString& error);
+
+private:
+    struct Request {
+        QByteArray method;
+        QByteArray path;
+        QHash<QByteArray, QByteArray> query;
+        QHash<QByteArray, QByteArray> headers;   ///< Names in lower case
+        QByteArray body;
+    };
+
+    struct Pending {
+        QByteArray buffer;
+        QTimer* timeout = nullptr;   ///< Drops a request that does not complete
+    };
+
+    struct Topic {
+        QJsonValue value;
+        quint64 seq = 0;
+    };
+
+    struct Client {
+        QTcpSocket* socket = nullptr;
+        QByteArray frames;               ///< Received, not yet parsed
+        QByteArray message;              ///< Fragments of a message so far
+        bool fragmented = false;         ///< A message is being continued
+        QSet<QString> topics;            ///< Followed; empty follows all
+        int intervalMs = DEFAULT_PUSH_INTERVAL_MS;
+        qint64 lastPushMs = -MAX_PUSH_INTERVAL_MS;
+        QHash<QString, quint64> sentSeq;
+        QHash<QString, QJsonValue> sentValues;   ///< What the client has, for splices
+    };
+
+    struct Bucket {
+        double tokens = COMMAND_BURST;
+        qint64 updatedMs = 0;
+    };
+
+    void onNewConnection();
+    void readRequest(QTcpSocket* socket, Pending& pending);
+    void handleRequest(QTcpSocket* socket, const Request& request, const QByteArray& rest);
+    void upgrade(QTcpSocket* socket, const Request& request, const QByteArray& rest);
+    bool authorized(const Request& request) const;
+    bool takeCommandToken(const QHostAddress& peer);
+    QJsonObject runCommand(const QString& name, const QJsonObject& args,
+                           const QHostAddress& peer, QByteArray* status = nullptr);
+    QJsonObject getValue(const QString& name, const QJsonObject& args = QJsonObject()) const;
+    QJsonObject state() const;
+
+    void readFrames(Client& client);
+    void closeClient(Client& client, quint16 code);
+    void handleMessage(Client& client, const QByteArray& message);
+    void sendMessage(Client& client, const QJsonObject& message);
+    void sendSnapshot(Client& client);
+    void flush();
+    void scheduleFlush(int delayMs);
+    void dropClient(QTcpSocket* socket);
+    bool follows(const Client& client, const QString& topic) const;
+
+    static void respond(QTcpSocket* socket, const QByteArray& status,
+                        const QByteArray& contentType, const QByteArray& body);
+    static void respondJson(QTcpSocket* socket, const QByteArray& status,
+                            const QJsonObject& body);
+    void logError(const QString& operation, const QString& error);
+
+    QTcpServer* m_server;
+    QTimer* m_flushTimer;
+    QElapsedTimer m_clock;
+    QByteArray m_token;
+    quint64 m_seq = 0;
+    QHash<QString, Topic> m_topics;
+    QHash<QString, CommandHandler> m_commands;
+    QHash<QString, DocumentBuilder> m_documents;
+    QHash<QString, QueryHandler> m_queries;
+    QHash<QTcpSocket*, std::shared_ptr<Client>> m_clients;
+    QHash<QString, Bucket> m_buckets;   ///< Command rate per peer address
+};
+
+#endif // REMOTECONTROLSERVER_H
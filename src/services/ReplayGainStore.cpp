@@ -0,0 +1,237 @@
+#include "ReplayGainStore.h"
+#include <QDebug>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QStringList>
+#include <QTimer>
+#include <QVariant>
+
+ReplayGainStore::ReplayGainStore(QSqlDatabase& database, QObject* parent)
+    : QObject(parent)
+    , m_database(database)
+{
+}
+
+ReplayGainStore::~ReplayGainStore()
+{
+    flush();
+}
+
+bool ReplayGainStore::initialize()
+{
+    if (m_initialized) {
+        return true;
+    }
+
+    if (!m_database.isOpen()) {
+        logError("initialize", "Database is not open");
+        return false;
+    }
+
+    if (!ensureColumns()) {
+        return false;
+    }
+
+    loadLoudness();
+    m_initialized = true;
+    return true;
+}
+
+double ReplayGainStore::gainDb(const QString& filePath) const
+{
+    auto it = m_loudness.constFind(filePath);
+    if (it == m_loudness.constEnd()) {
+        return 0.0;
+    }
+
+    const double gain = m_targetLufs - it->integratedLufs;
+    if (gain <= 0.0) {
+        return gain;
+    }
+    const double headroom = m_peakCeilingDbtp - it->truePeakDbtp;
+    return qMax(0.0, qMin(gain, qMin(headroom, MAX_BOOST_DB)));
+}
+
+void ReplayGainStore::setLoudness(const QString& filePath, double integratedLufs,
+                                  double truePeakDbtp)
+{
+    Loudness loudness;
+    loudness.integratedLufs = integratedLufs;
+    loudness.truePeakDbtp = truePeakDbtp;
+    m_loudness.insert(filePath, loudness);
+
+    Pending pending;
+    pending.loudness = loudness;
+    m_pending.insert(filePath, pending);
+    scheduleFlush();
+}
+
+void ReplayGainStore::clear(const QString& filePath)
+{
+    if (m_loudness.remove(filePath) == 0) {
+        return;
+    }
+
+    Pending pending;
+    pending.clear = true;
+    m_pending.insert(filePath, pending);
+    scheduleFlush();
+}
+
+void ReplayGainStore::setStoredLoudness(const QString& filePath, const Loudness* loudness)
+{
+    m_pending.remove(filePath);
+    if (loudness) {
+        m_loudness.insert(filePath, *loudness);
+    } else {
+        m_loudness.remove(filePath);
+    }
+}
+
+QVariantMap ReplayGainStore::toColumns(const Loudness* loudness)
+{
+    return {{"loudness_lufs", loudness ? QVariant(loudness->integratedLufs) : QVariant()},
+            {"true_peak_dbtp", loudness ? QVariant(loudness->truePeakDbtp) : QVariant()}};
+}
+
+void ReplayGainStore::relocate(const QString& from, const QString& to)
+{
+    auto it = m_loudness.find(from);
+    if (it == m_loudness.end() || from == to) {
+        return;
+    }
+
+    const Loudness loudness = it.value();
+    m_loudness.erase(it);
+    m_loudness.insert(to, loudness);
+    if (m_pending.contains(from)) {
+        m_pending.insert(to, m_pending.take(from));
+    }
+}
+
+bool ReplayGainStore::flush()
+{
+    m_flushScheduled = false;
+
+    if (!m_initialized || m_pending.isEmpty()) {
+        return true;
+    }
+
+    if (!m_database.isOpen()) {
+        logError("flush", "Database is not open");
+        return false;
+    }
+
+    if (!m_database.transaction()) {
+        logError("flush", QString("Failed to start transaction: %1").arg(m_database.lastError().text()));
+        return false;
+    }
+
+    QSqlQuery update(m_database);
+    update.prepare("UPDATE musics SET loudness_lufs = ?, true_peak_dbtp = ? WHERE path = ?");
+
+    for (auto it = m_pending.constBegin(); it != m_pending.constEnd(); ++it) {
+        update.addBindValue(it->clear ? QVariant() : QVariant(it->loudness.integratedLufs));
+        update.addBindValue(it->clear ? QVariant() : QVariant(it->loudness.truePeakDbtp));
+        update.addBindValue(it.key());
+        if (!update.exec()) {
+            QString error = QString("SQL Error: %1").arg(update.lastError().text());
+            logError("flush", error, update.lastQuery());
+            m_database.rollback();
+            emit operationError("flush", error);
+            return false;
+        }
+    }
+
+    if (!m_database.commit()) {
+        QString error = QString("Failed to commit: %1").arg(m_database.lastError().text());
+        logError("flush", error);
+        m_database.rollback();
+        emit operationError("flush", error);
+        return false;
+    }
+
+    m_pending.clear();
+    return true;
+}
+
+bool ReplayGainStore::ensureColumns()
+{
+    QSqlQuery info(m_database);
+    if (!info.exec("PRAGMA table_info(musics)")) {
+        QString error = QString("SQL Error: %1").arg(info.lastError().text());
+        logError("ensureColumns", error, info.lastQuery());
+        emit operationError("ensureColumns", error);
+        return false;
+    }
+
+    QStringList columns;
+    while (info.next()) {
+        columns << info.value(1).toString();
+    }
+    if (columns.isEmpty()) {
+        logError("ensureColumns", "The musics table does not exist");
+        emit operationError("ensureColumns", "The musics table does not exist");
+        return false;
+    }
+
+    for (const QString& column : {QString("loudness_lufs"), QString("true_peak_dbtp")}) {
+        if (columns.contains(column)) {
+            continue;
+        }
+
+        QSqlQuery query(m_database);
+        const QString sql = QString("ALTER TABLE musics ADD COLUMN %1 REAL").arg(column);
+        if (!query.exec(sql)) {
+            QString error = QString("SQL Error: %1").arg(query.lastError().text());
+            logError("ensureColumns", error, sql);
+            emit operationError("ensureColumns", error);
+            return false;
+        }
+        qInfo() << "ReplayGainStore: added" << column << "to the musics table";
+    }
+
+    return true;
+}
+
+void ReplayGainStore::loadLoudness()
+{
+    QSqlQuery query(m_database);
+    query.setForwardOnly(true);
+
+    if (!query.exec("SELECT path, loudness_lufs, true_peak_dbtp FROM musics "
+                    "WHERE loudness_lufs IS NOT NULL AND true_peak_dbtp IS NOT NULL")) {
+        logError("loadLoudness", QString("SQL Error: %1").arg(query.lastError().text()),
+                 query.lastQuery());
+        return;
+    }
+
+    while (query.next()) {
+        Loudness loudness;
+        loudness.integratedLufs = query.value(1).toDouble();
+        loudness.truePeakDbtp = query.value(2).toDouble();
+        m_loudness.insert(query.value(0).toString(), loudness);
+    }
+
+    qDebug() << "ReplayGainStore: loaded the loudness of" << m_loudness.size() << "tracks";
+}
+
+void ReplayGainStore::scheduleFlush()
+{
+    if (m_flushScheduled || !m_initialized) {
+        return;
+    }
+
+    m_flushScheduled = true;
+    QTimer::singleShot(0, this, [this]() { flush(); });
+}
+
+void ReplayGainStore::logError(const QString& operation, const QString& error, const QString& query)
+{
+    QString logMessage = QString("ReplayGainStore::%1 - %2").arg(operation, error);
+    if (!query.isEmpty()) {
+        logMessage += QString(" (Query: %1)").arg(query);
+    }
+
+    qWarning() << logMessage;
+}
@@ -0,0 +1,172 @@
+#ifndef REPLAYGAINSTORE_H
+#define REPLAYGAINSTORE_H
+
+#include <QHash>
+#include <QObject>
+#include <QSqlDatabase>
+#include <QString>
+#include <QVariantMap>
+
+/**
+ * @brief Loudness of the library tracks and the gain that evens them out
+ *
+ * The measurements of LoudnessMeter are kept in the loudness_lufs and
+ * true_peak_dbtp columns of the musics table, which initialize() adds to
+ * databases created before they existed. A track whose columns are NULL
+ * has not been measured and plays unchanged.
+ *
+ * gainDb() brings a track to the target loudness. A boost is limited to
+ * MAX_BOOST_DB and to what keeps the true peak below the ceiling, so quiet
+ * tracks with loud transients are not pushed into clipping. Cuts are not
+ * limited.
+ *
+ * All measurements are loaded into memory, so gainDb() is a hash lookup
+ * and can be used by PlaybackEngine every time an item is played or
+ * queued. New measurements are written back in a single transaction when
+ * flush() is called, or automatically on the next event loop iteration.
+ *
+ * ReplayGainStore is not thread-safe; it is used from the GUI thread.
+ *
+ * @example
+ * @code
+ * ReplayGainStore* store = new ReplayGainStore(db, this);
+ * store->initialize();
+ * engine->setGainProvider([store](const QString& path) {
+ *     return float(std::pow(10.0, store->gainDb(path) / 20.0));
+ * });
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class ReplayGainStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Measured loudness of one track
+     */
+    struct Loudness {
+        double integratedLufs = 0.0;
+        double truePeakDbtp = 0.0;
+    };
+
+    static constexpr double DEFAULT_TARGET_LUFS = -18.0;
+    static constexpr double DEFAULT_PEAK_CEILING_DBTP = -1.0;
+    static constexpr double MAX_BOOST_DB = 12.0;
+
+    explicit ReplayGainStore(QSqlDatabase& database, QObject* parent = nullptr);
+    ~ReplayGainStore() override;
+
+    /**
+     * @brief Add the loudness columns to the musics table if needed and load the measurements
+     * @return true if the columns are available
+     */
+    bool initialize();
+
+    void setTargetLufs(double lufs) { m_targetLufs = lufs; }
+    double targetLufs() const { return m_targetLufs; }
+    void setPeakCeilingDbtp(double dbtp) { m_peakCeilingDbtp = dbtp; }
+    double peakCeilingDbtp() const { return m_peakCeilingDbtp; }
+
+    /**
+     * @brief Check whether a track has been measured
+     * @param filePath Path as stored in the musics table
+     */
+    bool contains(const QString& filePath) const { return m_loudness.contains(filePath); }
+
+    /**
+     * @brief Get the measured loudness of a track
+     * @param filePath Path as stored in the musics table
+     * @return Measurement; zeros if the track has not been measured
+     */
+    Loudness loudness(const QString& filePath) const { return m_loudness.value(filePath); }
+
+    /**
+     * @brief Get the gain that brings a track to the target loudness
+     * @param filePath Path as stored in the musics table
+     * @return Gain in dB; 0 for tracks that have not been measured
+     */
+    double gainDb(const QString& filePath) const;
+
+    /**
+     * @brief Store the loudness of a track
+     * @param filePath Path as stored in the musics table
+     * @param integratedLufs Integrated loudness
+     * @param truePeakDbtp True peak
+     */
+    void setLoudness(const QString& filePath, double integratedLufs, double truePeakDbtp);
+
+    /**
+     * @brief Forget the loudness of a track, so it plays unchanged
+     * @param filePath Path as stored in the musics table
+     */
+    void clear(const QString& filePath);
+
+    /**
+     * @brief Take a measurement that another writer stored in the track's row
+     *
+     * Only the copy in memory changes, and a write still pending for the
+     * track is dropped. AnalysisPipeline writes toColumns() itself, in one
+     * UPDATE with the results of its other analyzers.
+     * @param filePath Path as stored in the musics table
+     * @param loudness Measurement, or nullptr for a track that was cleared
+     */
+    void setStoredLoudness(const QString& filePath, const Loudness* loudness);
+
+    /**
+     * @brief Get the musics columns that hold a measurement
+     * @param loudness Measurement, or nullptr for NULL columns
+     */
+    static QVariantMap toColumns(const Loudness* loudness);
+
+    /**
+     * @brief Move the measurement held in memory to a track's new path
+     *
+     * Only needed after the path of a musics row was changed directly in
+     * the database; the stored columns moved with it.
+     * @param from Old path
+     * @param to New path
+     */
+    void relocate(const QString& from, const QString& to);
+
+    /**
+     * @brief Get the number of measured tracks
+     */
+    int count() const { return m_loudness.size(); }
+
+    /**
+     * @brief Write pending measurements to the database
+     * @return true on success
+     */
+    bool flush();
+
+signals:
+    /**
+     * @brief Emitted when a database operation fails
+     * @param operation Name of the operation
+     * @param error Error message
+     */
+    void operationError(const QString& operation, const QString& error);
+
+private:
+    struct Pending {
+        bool clear = false;
+        Loudness loudness;
+    };
+
+    bool ensureColumns();
+    void loadLoudness();
+    void scheduleFlush();
+    void logError(const QString& operation, const QString& error, const QString& query = QString());
+
+    QSqlDatabase& m_database;
+    double m_targetLufs = DEFAULT_TARGET_LUFS;
+    double m_peakCeilingDbtp = DEFAULT_PEAK_CEILING_DBTP;
+    QHash<QString, Loudness> m_loudness;
+    QHash<QString, Pending> m_pending;
+    bool m_initialized = false;
+    bool m_flushScheduled = false;
+};
+
+#endif // REPLAYGAINSTORE_H
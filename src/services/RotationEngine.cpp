@@ -0,0 +1,363 @@
+#include "RotationEngine.h"
+#include "LibrarySnapshot.h"
+#include "../repositories/MusicRepository.h"
+#include <QDebug>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <limits>
+#include <algorithm>
+
+namespace {
+
+constexpr qint64 NEVER = std::numeric_limits<qint64>::min() / 2;
+
+} // namespace
+
+RotationEngine::RotationEngine(QSqlDatabase& database, QObject* parent)
+    : QObject(parent)
+    , m_database(database)
+    , m_random(QRandomGenerator::global()->generate())
+{
+}
+
+bool RotationEngine::reload()
+{
+    m_stale = false;
+
+    // A published snapshot saves reading the table, unless the table moved on without it
+    const LibrarySnapshot::Ptr library =
+        m_snapshots && !m_snapshots->isStale() ? m_snapshots->current() : nullptr;
+    QSqlQuery query(m_database);
+    query.setForwardOnly(true);
+    if (!library && !query.exec("SELECT id, path, genre1, artist, song FROM musics")) {
+        qWarning() << QString("RotationEngine::reload - SQL Error: %1 (Query: %2)")
+                          .arg(query.lastError().text(), query.lastQuery());
+        return false;
+    }
+
+    // Keep the separation history across reloads
+    QHash<QString, quint64> lastPlayed;
+    for (const Track& track : std::as_const(m_tracks)) {
+        if (track.active && track.lastPlayed > 0) {
+            lastPlayed.insert(track.path, track.lastPlayed);
+        }
+    }
+
+    m_tracks.clear();
+    m_indexById.clear();
+    m_indexByPath.clear();
+    m_genrePools.clear();
+    m_libraryPool = Pool();
+
+    if (library) {
+        for (int row = 0; row < library->size(); ++row) {
+            insertTrack(library->ids().at(row), library->path(row), library->genre(row),
+                        library->artist(row), library->song(row));
+        }
+    }
+    while (query.next()) {
+        insertTrack(query.value(0).toInt(), query.value(1).toString(), query.value(2).toString(),
+                    query.value(3).toString(), query.value(4).toString());
+    }
+
+    for (auto it = lastPlayed.constBegin(); it != lastPlayed.constEnd(); ++it) {
+        auto index = m_indexByPath.constFind(it.key());
+        if (index != m_indexByPath.constEnd()) {
+            m_tracks[*index].lastPlayed = it.value();
+        }
+    }
+
+    reshuffle(m_libraryPool);
+    for (Pool& pool : m_genrePools) {
+        reshuffle(pool);
+    }
+
+    qDebug() << "RotationEngine: loaded" << m_tracks.size() << "tracks in" << m_genrePools.size()
+             << "genres";
+    return true;
+}
+
+void RotationEngine::invalidate()
+{
+    m_stale = true;
+}
+
+QString RotationEngine::nextTrack(const QString& genre, const QDateTime& at)
+{
+    ensureLoaded();
+
+    Pool* pool = &m_libraryPool;
+    if (!genre.isEmpty()) {
+        auto it = m_genrePools.find(genreKey(genre));
+        if (it == m_genrePools.end()) {
+            return QString();
+        }
+        pool = &it.value();
+    }
+
+    const qint64 atMs = at.isValid() ? at.toMSecsSinceEpoch() : clock()->nowMs();
+    const int index = takeFrom(*pool, atMs);
+    if (index < 0) {
+        return QString();
+    }
+
+    Track& track = m_tracks[index];
+    track.lastPlayed = ++m_playSerial;
+    track.picked = true;
+    recordAiring(track, atMs);
+    return track.path;
+}
+
+QStringList RotationEngine::upcoming(const QString& genre, int count)
+{
+    ensureLoaded();
+
+    const Pool* pool = &m_libraryPool;
+    if (!genre.isEmpty()) {
+        auto it = m_genrePools.constFind(genreKey(genre));
+        if (it == m_genrePools.constEnd()) {
+            return {};
+        }
+        pool = &it.value();
+    }
+
+    QStringList paths;
+    for (int i = pool->cursor; i < pool->order.size() && paths.size() < count; ++i) {
+        const Track& track = m_tracks.at(pool->order.at(i));
+        if (track.active) {
+            paths.append(track.path);
+        }
+    }
+    return paths;
+}
+
+void RotationEngine::markPlayed(const QString& filePath, const QDateTime& at)
+{
+    auto it = m_indexByPath.constFind(filePath);
+    if (it == m_indexByPath.constEnd()) {
+        return;
+    }
+
+    // A track the rotation picked itself was counted when nextTrack() took
+    // it; counting it again would shrink both separations
+    Track& track = m_tracks[*it];
+    if (track.picked) {
+        track.picked = false;
+        return;
+    }
+
+    const qint64 atMs = at.isValid() ? at.toMSecsSinceEpoch() : clock()->nowMs();
+    recordAiring(track, atMs);
+    track.lastPlayed = ++m_playSerial;
+}
+
+void RotationEngine::setSeparation(int tracks)
+{
+    m_separation = qMax(0, tracks);
+}
+
+void RotationEngine::addTrack(const MusicItem& music)
+{
+    if (m_stale || music.id <= 0 || m_indexById.contains(music.id)) {
+        return;
+    }
+    insertTrack(music.id, music.path, music.genre1, music.artist, music.song);
+}
+
+void RotationEngine::updateTrack(const MusicItem& music)
+{
+    if (m_stale) {
+        return;
+    }
+
+    auto it = m_indexById.constFind(music.id);
+    if (it != m_indexById.constEnd()) {
+        const Track& track = m_tracks.at(*it);
+        if (track.path == music.path && track.genreKey == genreKey(music.genre1) &&
+            track.titleKey == titleKey(key(music.artist), music.song, music.path)) {
+            return;
+        }
+    }
+
+    const quint64 lastPlayed = it != m_indexById.constEnd() ? m_tracks.at(*it).lastPlayed : 0;
+    removeTrack(music.id);
+    addTrack(music);
+
+    auto added = m_indexById.constFind(music.id);
+    if (added != m_indexById.constEnd()) {
+        m_tracks[*added].lastPlayed = lastPlayed;
+    }
+}
+
+void RotationEngine::removeTrack(int musicId)
+{
+    auto it = m_indexById.find(musicId);
+    if (m_stale || it == m_indexById.end()) {
+        return;
+    }
+
+    // Entries stay in the pool vectors until the next reshuffle
+    Track& track = m_tracks[*it];
+    track.active = false;
+    --m_libraryPool.activeCount;
+    auto pool = m_genrePools.find(track.genreKey);
+    if (pool != m_genrePools.end()) {
+        --pool->activeCount;
+    }
+
+    m_indexByPath.remove(track.path);
+    m_indexById.erase(it);
+}
+
+void RotationEngine::insertTrack(int id, const QString& path, const QString& genre,
+                                 const QString& artist, const QString& title)
+{
+    if (path.isEmpty()) {
+        return;
+    }
+
+    Track track;
+    track.id = id;
+    track.path = path;
+    track.genreKey = genreKey(genre);
+    track.artistKey = key(artist);
+    track.titleKey = titleKey(track.artistKey, title, path);
+
+    const int index = m_tracks.size();
+    m_tracks.append(track);
+    m_indexById.insert(id, index);
+    m_indexByPath.insert(path, index);
+
+    insertIntoPool(m_libraryPool, index);
+    if (!track.genreKey.isEmpty()) {
+        insertIntoPool(m_genrePools[track.genreKey], index);
+    }
+}
+
+void RotationEngine::insertIntoPool(Pool& pool, int trackIndex)
+{
+    // Drop new tracks somewhere into the unplayed part of the current cycle
+    pool.order.append(trackIndex);
+    const int unplayed = pool.order.size() - pool.cursor;
+    const int target = pool.cursor + int(m_random.bounded(quint32(unplayed)));
+    std::swap(pool.order[target], pool.order.last());
+    ++pool.activeCount;
+}
+
+int RotationEngine::takeFrom(Pool& pool, qint64 atMs)
+{
+    if (pool.activeCount <= 0) {
+        return -1;
+    }
+
+    // With the window below the pool size an eligible track always exists,
+    // at the latest in a freshly shuffled cycle
+    const quint64 window = quint64(qMin(m_separation, pool.activeCount - 1));
+
+    // The rest of the cycle is tried first, then a fresh cycle. Only when
+    // neither holds a song spaced enough do the artist rules give way, for
+    // the song of the fresh cycle that aired longest ago
+    int relaxed = -1;
+    for (int pass = 0; pass < 2; ++pass) {
+        for (int i = pool.cursor; i < pool.order.size(); ++i) {
+            const Track& track = m_tracks.at(pool.order.at(i));
+            if (!track.active) {
+                continue;
+            }
+            if (track.lastPlayed > 0 && m_playSerial - track.lastPlayed < window) {
+                continue;
+            }
+            if (spaced(track, atMs)) {
+                std::swap(pool.order[pool.cursor], pool.order[i]);
+                return pool.order.at(pool.cursor++);
+            }
+            if (pass == 1 && (relaxed < 0 || staleness(track) <
+                                                 staleness(m_tracks.at(pool.order.at(relaxed))))) {
+                relaxed = i;
+            }
+        }
+        if (pass == 0) {
+            reshuffle(pool);
+        }
+    }
+
+    if (relaxed < 0) {
+        return -1;
+    }
+    ++m_relaxedPicks;
+    std::swap(pool.order[pool.cursor], pool.order[relaxed]);
+    return pool.order.at(pool.cursor++);
+}
+
+bool RotationEngine::spaced(const Track& track, qint64 atMs) const
+{
+    if (!track.artistKey.isEmpty() &&
+        atMs - m_artistAiredMs.value(track.artistKey, NEVER) < m_artistSeparationMs) {
+        return false;
+    }
+    return atMs - m_titleAiredMs.value(track.titleKey, NEVER) >= m_titleSeparationMs;
+}
+
+std::pair<qint64, qint64> RotationEngine::staleness(const Track& track) const
+{
+    // The song whose artist aired longest ago breaks the rules least, and of
+    // those by the same artist the one whose title did
+    const qint64 titleMs = m_titleAiredMs.value(track.titleKey, NEVER);
+    const qint64 lastMs = track.artistKey.isEmpty()
+                              ? titleMs
+                              : std::max(titleMs, m_artistAiredMs.value(track.artistKey, NEVER));
+    return {lastMs, titleMs};
+}
+
+void RotationEngine::recordAiring(const Track& track, qint64 atMs)
+{
+    if (!track.artistKey.isEmpty()) {
+        m_artistAiredMs.insert(track.artistKey, atMs);
+    }
+    m_titleAiredMs.insert(track.titleKey, atMs);
+    m_recent.append({atMs, track.artistKey, track.titleKey});
+
+    // Airings outside both windows no longer matter; an entry is only
+    // dropped if no later airing of the same artist or title replaced it
+    const qint64 horizon = atMs - std::max(m_artistSeparationMs, m_titleSeparationMs);
+    while (!m_recent.isEmpty() && m_recent.first().atMs < horizon) {
+        const Airing& oldest = m_recent.first();
+        auto artist = m_artistAiredMs.find(oldest.artistKey);
+        if (artist != m_artistAiredMs.end() && *artist == oldest.atMs) {
+            m_artistAiredMs.erase(artist);
+        }
+        auto title = m_titleAiredMs.find(oldest.titleKey);
+        if (title != m_titleAiredMs.end() && *title == oldest.atMs) {
+            m_titleAiredMs.erase(title);
+        }
+        m_recent.removeFirst();
+    }
+}
+
+QString RotationEngine::titleKey(const QString& artistKey, const QString& title,
+                                 const QString& path)
+{
+    // Untitled songs are told apart by their file
+    return artistKey + '\n' + (title.trimmed().isEmpty() ? path : key(title));
+}
+
+void RotationEngine::reshuffle(Pool& pool)
+{
+    pool.order.erase(std::remove_if(pool.order.begin(), pool.order.end(),
+                                    [this](int index) { return !m_tracks.at(index).active; }),
+                     pool.order.end());
+
+    for (int i = pool.order.size() - 1; i > 0; --i) {
+        std::swap(pool.order[i], pool.order[int(m_random.bounded(quint32(i + 1)))]);
+    }
+
+    pool.cursor = 0;
+    pool.activeCount = pool.order.size();
+}
+
+void RotationEngine::ensureLoaded()
+{
+    if (m_stale) {
+        reload();
+    }
+}
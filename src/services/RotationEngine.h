@@ -0,0 +1,224 @@
+#ifndef ROTATIONENGINE_H
+#define ROTATIONENGINE_H
+
+#include "AutomationClock.h"
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QRandomGenerator>
+#include <QSqlDatabase>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <utility>
+
+struct MusicItem;
+class LibrarySnapshotStore;
+
+/**
+ * @brief In-memory shuffled rotation for auto mode
+ *
+ * Auto mode used to pick every song with ORDER BY random(), which scans
+ * and sorts the whole musics table for a single row. RotationEngine loads
+ * id, path and genre1 of every track once and keeps a shuffled pool for the
+ * whole library plus one per genre. Picking the next song takes the next
+ * entry of the pool, so each pool plays through completely before it is
+ * reshuffled.
+ *
+ * A track is never picked again until at least separation() other tracks
+ * have been played (capped at the pool size minus one, so small genres
+ * still rotate). Plays are shared between pools, and tracks started by
+ * hand can be reported with markPlayed(). Reporting a track nextTrack()
+ * picked is harmless; it was counted when it was taken.
+ *
+ * Songs are also kept apart by time, as DayLogGenerator does: a song is
+ * passed over while its artist aired less than artistSeparation() minutes
+ * before, or the same artist and title less than titleSeparation()
+ * minutes before. The last airing of each artist and title is a hash
+ * lookup, and a time-ordered ring of recent plays drops the entries older
+ * than both windows. When neither the rest of the cycle nor a reshuffled
+ * one holds a song spaced enough, the one that aired longest ago is picked
+ * and counted in relaxedPicks().
+ *
+ * The pools follow library edits incrementally through the MusicRepository
+ * signals. Code that edits the musics table directly calls invalidate(),
+ * and the tracks are reloaded before the next pick. With a
+ * LibrarySnapshotStore set, they are reloaded from its current snapshot
+ * instead of the table, once there is one and unless its last rebuild
+ * failed.
+ *
+ * @example
+ * @code
+ * RotationEngine rotation(db);
+ * rotation.setSeparation(30);
+ * QString path = rotation.nextTrack("Rock"); // empty genre for the whole library
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class RotationEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int DEFAULT_SEPARATION = 20;
+
+    explicit RotationEngine(QSqlDatabase& database, QObject* parent = nullptr);
+
+    /**
+     * @brief Load the library from the musics table
+     * @return true if the tracks were read
+     */
+    bool reload();
+
+    /**
+     * @brief Load the tracks from the snapshots of a store rather than the musics table
+     * @param snapshots Store kept up to date by the caller; nullptr to read the table again
+     */
+    void setSnapshots(const LibrarySnapshotStore* snapshots) { m_snapshots = snapshots; }
+
+    /**
+     * @brief Mark the pools stale so they are reloaded before the next pick
+     */
+    void invalidate();
+
+    /**
+     * @brief Pick the next track to play
+     * @param genre genre1 value to pick from (case-insensitive), empty for any track
+     * @param at Time the track airs, for the artist and title separation; now if invalid
+     * @return Path of the track, or an empty string if no track matches
+     */
+    QString nextTrack(const QString& genre = QString(), const QDateTime& at = QDateTime());
+
+    /**
+     * @brief Get the tracks the rotation is likely to pick next, without picking them
+     *
+     * The next entries of the shuffled pool. The separation may still skip
+     * some of them, and a pool that runs out is reshuffled at random, so
+     * this is a forecast for caching rather than a promise.
+     * @param genre genre1 value, as for nextTrack()
+     * @param count Most tracks to return
+     * @return Paths of the tracks
+     */
+    QStringList upcoming(const QString& genre, int count);
+
+    /**
+     * @brief Record that a track went on air outside the rotation
+     * @param filePath Path of the track
+     * @param at Time it aired; now if invalid
+     */
+    void markPlayed(const QString& filePath, const QDateTime& at = QDateTime());
+
+    /**
+     * @brief Set how many tracks must play before a track may repeat
+     * @param tracks Separation in tracks
+     */
+    void setSeparation(int tracks);
+    int separation() const { return m_separation; }
+
+    /**
+     * @brief Set how long an artist stays off the air after one of their songs
+     * @param minutes Separation in minutes, 0 to allow any repeat
+     */
+    void setArtistSeparation(int minutes) { m_artistSeparationMs = qMax(0, minutes) * 60000LL; }
+    int artistSeparation() const { return int(m_artistSeparationMs / 60000); }
+
+    /**
+     * @brief Set how long a title by the same artist stays off the air
+     * @param minutes Separation in minutes, 0 to allow any repeat
+     */
+    void setTitleSeparation(int minutes) { m_titleSeparationMs = qMax(0, minutes) * 60000LL; }
+    int titleSeparation() const { return int(m_titleSeparationMs / 60000); }
+
+    /**
+     * @brief Picks made although they broke the artist or title separation
+     */
+    int relaxedPicks() const { return m_relaxedPicks; }
+
+    /**
+     * @brief Get the number of tracks in rotation
+     * @return Track count
+     */
+    int trackCount() const { return m_indexById.size(); }
+
+    /**
+     * @brief Seed the shuffle, for reproducible rotations
+     * @param seed Random seed
+     */
+    void setSeed(quint32 seed) { m_random.seed(seed); }
+
+    /**
+     * @brief Clock for picks and plays given no time; nullptr for the wall clock
+     */
+    void setClock(AutomationClock* clock) { m_clock = clock; }
+    AutomationClock* clock() const
+    {
+        return m_clock ? m_clock.data() : AutomationClock::wallClock();
+    }
+
+public slots:
+    void addTrack(const MusicItem& music);
+    void updateTrack(const MusicItem& music);
+    void removeTrack(int musicId);
+
+private:
+    struct Track {
+        int id = -1;
+        QString path;
+        QString genreKey;
+        QString artistKey;
+        QString titleKey;
+        bool active = true;
+        quint64 lastPlayed = 0; ///< Play serial, 0 if never played
+        bool picked = false;    ///< Taken by nextTrack() and not reported by markPlayed() yet
+    };
+
+    struct Pool {
+        QVector<int> order; ///< Indices into m_tracks
+        int cursor = 0;
+        int activeCount = 0;
+    };
+
+    /// An airing in the ring of recent plays
+    struct Airing {
+        qint64 atMs = 0;
+        QString artistKey;
+        QString titleKey;
+    };
+
+    void insertTrack(int id, const QString& path, const QString& genre, const QString& artist,
+                     const QString& title);
+    void insertIntoPool(Pool& pool, int trackIndex);
+    int takeFrom(Pool& pool, qint64 atMs);
+    bool spaced(const Track& track, qint64 atMs) const;
+    std::pair<qint64, qint64> staleness(const Track& track) const;
+    void recordAiring(const Track& track, qint64 atMs);
+    void reshuffle(Pool& pool);
+    void ensureLoaded();
+    static QString genreKey(const QString& genre) { return genre.trimmed().toCaseFolded(); }
+    static QString key(const QString& text) { return text.trimmed().toCaseFolded(); }
+    static QString titleKey(const QString& artistKey, const QString& title, const QString& path);
+
+    QSqlDatabase& m_database;
+    const LibrarySnapshotStore* m_snapshots = nullptr;
+    QPointer<AutomationClock> m_clock;
+    QRandomGenerator m_random;
+    QVector<Track> m_tracks;
+    QHash<int, int> m_indexById;
+    QHash<QString, int> m_indexByPath;
+    QHash<QString, Pool> m_genrePools;
+    Pool m_libraryPool;
+    quint64 m_playSerial = 0;
+    int m_separation = DEFAULT_SEPARATION;
+    qint64 m_artistSeparationMs = 0;
+    qint64 m_titleSeparationMs = 0;
+    QHash<QString, qint64> m_artistAiredMs;
+    QHash<QString, qint64> m_titleAiredMs;
+    QList<Airing> m_recent;             ///< Oldest first
+    int m_relaxedPicks = 0;
+    bool m_stale = true;
+};
+
+#endif // ROTATIONENGINE_H
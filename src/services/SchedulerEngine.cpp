@@ -0,0 +1,517 @@
+#include "SchedulerEngine.h"
+#include <QDebug>
+#include <QLocale>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <algorithm>
+#include <functional>
+
+namespace {
+
+// Time of the week from Monday 00:00, in the minutes the rules are set in
+qint64 weekOffsetMs(int dayOfWeek, int hour, int minute)
+{
+    return ((qint64(dayOfWeek - 1) * 24 + hour) * 60 + minute) * 60 * 1000;
+}
+
+} // namespace
+
+int SchedulerEngine::dayOfWeekFromName(const QString& name)
+{
+    // week_day holds the English day names offered by the pub/program dialogs
+    static const char* const names[] = {"monday", "tuesday", "wednesday", "thursday",
+                                        "friday", "saturday", "sunday"};
+    const QString key = name.trimmed().toLower();
+    for (int i = 0; i < 7; ++i) {
+        if (key == QLatin1String(names[i])) {
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+QString SchedulerEngine::describe(const ScheduleRule& rule)
+{
+    const QString file = rule.path.section('/', -1);
+    const QString day = QLocale(QLocale::English).dayName(qBound(1, rule.dayOfWeek, 7));
+    const QString time = QTime(rule.hour, rule.minute).toString("HH:mm");
+    const QString when = rule.type == ScheduleRule::Type::Weekly
+                             ? QString("%1s at %2").arg(day, time)
+                             : rule.at.toString("dd/MM/yyyy 'at' HH:mm");
+    return file.isEmpty() ? when : QString("%1 (%2)").arg(when, file);
+}
+
+bool ScheduleRule::operator==(const ScheduleRule& other) const
+{
+    return rowId == other.rowId && itemId == other.itemId && type == other.type && at == other.at
+           && dayOfWeek == other.dayOfWeek && hour == other.hour && minute == other.minute
+           && isProgram == other.isProgram && path == other.path;
+}
+
+SchedulerEngine::SchedulerEngine(QSqlDatabase& database, QObject* parent)
+    : QObject(parent)
+    , m_database(database)
+{
+    m_timer.setSingleShot(true);
+    m_timer.setTimerType(Qt::PreciseTimer);
+    connect(&m_timer, &ClockTimer::timeout, this, [this]() { processDue(); });
+}
+
+void SchedulerEngine::setClock(AutomationClock* clock)
+{
+    m_timer.setClock(clock);
+    arm();
+}
+
+bool SchedulerEngine::start()
+{
+    m_running = true;
+    const bool loaded = reload();
+    arm();
+    return loaded;
+}
+
+void SchedulerEngine::stop()
+{
+    m_running = false;
+    m_timer.stop();
+}
+
+void SchedulerEngine::setDurationLookup(DurationLookup lookup)
+{
+    m_durationLookup = std::move(lookup);
+    for (RuleState& state : m_rules) {
+        unplace(state);
+        place(state);
+    }
+}
+
+bool SchedulerEngine::reload()
+{
+    QHash<qint64, ScheduleRule> rules;
+    if (!readRules(rules)) {
+        return false;
+    }
+
+    const QDateTime now = clock()->now();
+    QHash<qint64, RuleState> updated;
+    updated.reserve(rules.size());
+    QVector<qint64> changed;
+
+    for (auto it = rules.constBegin(); it != rules.constEnd(); ++it) {
+        auto previous = m_rules.find(it.key());
+        if (previous != m_rules.end()) {
+            if (previous->rule == it.value()) {
+                updated.insert(it.key(), previous.value());
+                continue;
+            }
+            unplace(*previous);
+        }
+
+        RuleState state;
+        state.rule = it.value();
+        const QDateTime next = nextOccurrence(state.rule, now);
+        state.nextFireMs = next.isValid() ? next.toMSecsSinceEpoch() : -1;
+        place(state);
+        updated.insert(it.key(), state);
+        changed.append(it.key());
+    }
+
+    // Rows that are gone leave the trees too
+    for (auto it = m_rules.begin(); it != m_rules.end(); ++it) {
+        if (!rules.contains(it.key())) {
+            unplace(*it);
+        }
+    }
+
+    m_rules.swap(updated);
+    rebuildHeap();
+    arm();
+
+    // Only new and edited rules are looked at, so a reload stays cheap
+    for (qint64 rowId : std::as_const(changed)) {
+        const ScheduleRule rule = m_rules.value(rowId).rule;
+        const QList<ScheduleRule> overlapping = conflicts(rule);
+        if (!overlapping.isEmpty()) {
+            qWarning() << "SchedulerEngine:" << describe(rule) << "overlaps" << overlapping.size()
+                       << "other rules, first" << describe(overlapping.first());
+        }
+    }
+
+    qDebug() << "SchedulerEngine: loaded" << m_rules.size() << "rules," << changed.size()
+             << "recomputed, next event at" << nextFireTime().toString();
+    return true;
+}
+
+QList<ScheduleRule> SchedulerEngine::conflicts(const ScheduleRule& rule) const
+{
+    QList<ScheduleRule> overlapping;
+    const auto loaded = m_rules.constFind(rule.rowId);
+    const qint64 airMs =
+        loaded != m_rules.constEnd() && loaded->airMs > 0 ? loaded->airMs : airTimeOf(rule);
+
+    QVector<qint64> ids;
+    const auto collect = [&ids, &rule](const QVector<IntervalIndex::Interval>& found) {
+        for (const IntervalIndex::Interval& interval : found) {
+            if (interval.id != rule.rowId) {
+                ids.append(interval.id);
+            }
+        }
+    };
+    for (const Span& span : weekSpans(rule, airMs)) {
+        collect(m_weekIndex.overlapping(span.start, span.end));
+        if (rule.type == ScheduleRule::Type::Weekly) {
+            collect(m_onceWeekIndex.overlapping(span.start, span.end));
+        }
+    }
+    if (rule.type == ScheduleRule::Type::Once && rule.at.isValid()) {
+        const qint64 atMs = rule.at.toMSecsSinceEpoch();
+        collect(m_onceIndex.overlapping(atMs, atMs + airMs));
+    }
+
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    for (qint64 id : std::as_const(ids)) {
+        const auto other = m_rules.constFind(id);
+        if (other != m_rules.constEnd()) {
+            overlapping.append(other->rule);
+        }
+    }
+    return overlapping;
+}
+
+QDateTime SchedulerEngine::nextFireTime() const
+{
+    if (m_heap.isEmpty()) {
+        return QDateTime();
+    }
+    return QDateTime::fromMSecsSinceEpoch(m_heap.first().fireMs);
+}
+
+QList<ScheduledEvent> SchedulerEngine::upcomingEvents(const QDateTime& from, const QDateTime& to) const
+{
+    QList<ScheduledEvent> events;
+    if (!from.isValid() || !to.isValid() || to <= from) {
+        return events;
+    }
+
+    const qint64 fromMs = from.toMSecsSinceEpoch();
+    for (auto it = m_rules.constBegin(); it != m_rules.constEnd(); ++it) {
+        if (it->nextFireMs < 0) {
+            continue;
+        }
+
+        // Start at the pending firing; earlier ones have fired already
+        QDateTime fireAt = it->nextFireMs >= fromMs ? QDateTime::fromMSecsSinceEpoch(it->nextFireMs)
+                                                    : nextOccurrence(it->rule, from);
+
+        while (fireAt.isValid() && fireAt < to) {
+            events.append({fireAt, it->rule});
+            if (it->rule.type != ScheduleRule::Type::Weekly) {
+                break;
+            }
+            fireAt = nextOccurrence(it->rule, fireAt.addSecs(60));
+        }
+    }
+
+    std::sort(events.begin(), events.end(), [](const ScheduledEvent& a, const ScheduledEvent& b) {
+        return a.fireAt != b.fireAt ? a.fireAt < b.fireAt : a.rule.rowId < b.rule.rowId;
+    });
+    return events;
+}
+
+QDateTime SchedulerEngine::nextOccurrence(const ScheduleRule& rule, const QDateTime& from)
+{
+    // An occurrence counts until its minute is over, like the old per-minute scan
+    const QDateTime threshold = from.addSecs(-60);
+
+    if (rule.type == ScheduleRule::Type::Once) {
+        return rule.at.isValid() && rule.at > threshold ? rule.at : QDateTime();
+    }
+
+    const QTime time(rule.hour, rule.minute);
+    if (rule.dayOfWeek < 1 || rule.dayOfWeek > 7 || !time.isValid()) {
+        return QDateTime();
+    }
+
+    const QDate start = threshold.date();
+    for (int day = 0; day <= 7; ++day) {
+        const QDate date = start.addDays(day);
+        if (date.dayOfWeek() != rule.dayOfWeek) {
+            continue;
+        }
+        const QDateTime candidate(date, time);
+        if (candidate > threshold) {
+            return candidate;
+        }
+    }
+
+    return QDateTime();
+}
+
+void SchedulerEngine::processDue(const QDateTime& now)
+{
+    const qint64 nowMs = now.isValid() ? now.toMSecsSinceEpoch() : clock()->nowMs();
+    QVector<ScheduledEvent> due;
+
+    while (!m_heap.isEmpty() && m_heap.first().fireMs <= nowMs) {
+        std::pop_heap(m_heap.begin(), m_heap.end(), std::greater<HeapEntry>());
+        const HeapEntry entry = m_heap.takeLast();
+
+        auto it = m_rules.find(entry.rowId);
+        if (it == m_rules.end() || it->nextFireMs != entry.fireMs) {
+            continue;
+        }
+
+        ScheduledEvent event;
+        event.fireAt = QDateTime::fromMSecsSinceEpoch(entry.fireMs);
+        event.rule = it->rule;
+        due.append(event);
+
+        // Fired one-shot rules stay known (as spent) until their row is gone
+        const QDateTime next = it->rule.type == ScheduleRule::Type::Weekly
+                                   ? nextOccurrence(it->rule, event.fireAt.addSecs(60))
+                                   : QDateTime();
+        it->nextFireMs = next.isValid() ? next.toMSecsSinceEpoch() : -1;
+        if (it->nextFireMs >= 0) {
+            pushEntry(it->nextFireMs, entry.rowId);
+        } else {
+            unplace(*it);
+        }
+    }
+
+    arm();
+
+    // Handlers may edit the schedule and reload it, so emit after the heap is settled
+    for (const ScheduledEvent& event : std::as_const(due)) {
+        qDebug() << "SchedulerEngine: event due" << event.fireAt.toString() << event.rule.path;
+        emit eventDue(event);
+        if (event.rule.type == ScheduleRule::Type::Once) {
+            retireOnce(event.rule);
+        }
+    }
+}
+
+bool SchedulerEngine::markFired(qint64 rowId, const QDateTime& fireAt)
+{
+    auto it = m_rules.find(rowId);
+    if (it == m_rules.end() || it->nextFireMs < 0 || it->nextFireMs != fireAt.toMSecsSinceEpoch()) {
+        return false;
+    }
+
+    // The heap entry of the old time is skipped when it comes up
+    const QDateTime next = it->rule.type == ScheduleRule::Type::Weekly
+                               ? nextOccurrence(it->rule, fireAt.addSecs(60))
+                               : QDateTime();
+    it->nextFireMs = next.isValid() ? next.toMSecsSinceEpoch() : -1;
+    const ScheduleRule rule = it->rule;
+    if (it->nextFireMs >= 0) {
+        pushEntry(it->nextFireMs, rowId);
+    } else {
+        unplace(*it);
+    }
+    arm();
+
+    qDebug() << "SchedulerEngine: already fired" << fireAt.toString() << rule.path;
+    if (rule.type == ScheduleRule::Type::Once) {
+        retireOnce(rule);
+    }
+    return true;
+}
+
+bool SchedulerEngine::readRules(QHash<qint64, ScheduleRule>& rules)
+{
+    QSqlQuery query(m_database);
+    query.setForwardOnly(true);
+    const QString sql = "SELECT s.rowid, s.id, s.ano, s.mes, s.dia, s.hora, s.min, s.tipo, "
+                        "s.week_day, s.is_program, programs.path, pub.path "
+                        "FROM scheduler s "
+                        "LEFT JOIN programs ON programs.id = s.id "
+                        "LEFT JOIN pub ON pub.id = s.id";
+
+    if (!query.exec(sql)) {
+        QString error = QString("SQL Error: %1").arg(query.lastError().text());
+        logError("readRules", error, sql);
+        emit operationError("readRules", error);
+        return false;
+    }
+
+    while (query.next()) {
+        ScheduleRule rule;
+        rule.rowId = query.value(0).toLongLong();
+        rule.itemId = query.value(1).toInt();
+        rule.hour = query.value(5).toInt();
+        rule.minute = query.value(6).toInt();
+        rule.isProgram = query.value(9).toString() == "1";
+        rule.path = query.value(rule.isProgram ? 10 : 11).toString();
+
+        const int type = query.value(7).toInt();
+        if (type == int(ScheduleRule::Type::Once)) {
+            rule.type = ScheduleRule::Type::Once;
+            rule.at = QDateTime(QDate(query.value(2).toInt(), query.value(3).toInt(), query.value(4).toInt()),
+                                QTime(rule.hour, rule.minute));
+        } else if (type == int(ScheduleRule::Type::Weekly)) {
+            rule.type = ScheduleRule::Type::Weekly;
+            rule.dayOfWeek = dayOfWeekFromName(query.value(8).toString());
+        } else {
+            continue;
+        }
+
+        rules.insert(rule.rowId, rule);
+    }
+
+    return true;
+}
+
+void SchedulerEngine::rebuildHeap()
+{
+    m_heap.clear();
+    m_heap.reserve(m_rules.size());
+    for (auto it = m_rules.constBegin(); it != m_rules.constEnd(); ++it) {
+        if (it->nextFireMs >= 0) {
+            m_heap.append({it->nextFireMs, it.key()});
+        }
+    }
+    std::make_heap(m_heap.begin(), m_heap.end(), std::greater<HeapEntry>());
+}
+
+void SchedulerEngine::pushEntry(qint64 fireMs, qint64 rowId)
+{
+    m_heap.append({fireMs, rowId});
+    std::push_heap(m_heap.begin(), m_heap.end(), std::greater<HeapEntry>());
+}
+
+void SchedulerEngine::arm()
+{
+    m_timer.stop();
+    if (!m_running || m_heap.isEmpty()) {
+        return;
+    }
+
+    const qint64 delay = m_heap.first().fireMs - clock()->nowMs();
+    m_timer.start(int(qBound<qint64>(0, delay, MAX_SLEEP_MS)));
+}
+
+void SchedulerEngine::retireOnce(const ScheduleRule& rule)
+{
+    QSqlQuery query(m_database);
+    query.prepare("DELETE FROM scheduler WHERE rowid = ?");
+    query.addBindValue(rule.rowId);
+    if (!query.exec()) {
+        QString error = QString("SQL Error: %1").arg(query.lastError().text());
+        logError("retireOnce", error, query.lastQuery());
+        emit operationError("retireOnce", error);
+        return;
+    }
+    auto state = m_rules.find(rule.rowId);
+    if (state != m_rules.end()) {
+        unplace(*state);
+        m_rules.erase(state);
+    }
+
+    if (rule.isProgram) {
+        return;
+    }
+
+    // A pub with no rules left has nothing more to air
+    query.prepare("SELECT COUNT(*) FROM scheduler WHERE id = ?");
+    query.addBindValue(rule.itemId);
+    if (!query.exec() || !query.next() || query.value(0).toInt() > 0) {
+        return;
+    }
+    query.finish();
+
+    query.prepare("DELETE FROM pub WHERE id = ?");
+    query.addBindValue(rule.itemId);
+    if (!query.exec()) {
+        QString error = QString("SQL Error: %1").arg(query.lastError().text());
+        logError("retireOnce", error, query.lastQuery());
+        emit operationError("retireOnce", error);
+        return;
+    }
+
+    emit pubRemoved(rule.itemId);
+}
+
+qint64 SchedulerEngine::airTimeOf(const ScheduleRule& rule) const
+{
+    const qint64 durationUs =
+        m_durationLookup && !rule.path.isEmpty() ? m_durationLookup(rule.path) : -1;
+    return qMax(MIN_AIR_MS, durationUs / 1000);
+}
+
+void SchedulerEngine::place(RuleState& state)
+{
+    const ScheduleRule& rule = state.rule;
+    // A one-shot rule is only in the way until it fired
+    if (rule.type == ScheduleRule::Type::Once && state.nextFireMs < 0) {
+        return;
+    }
+    const qint64 airMs = airTimeOf(rule);
+    const QVector<Span> spans = weekSpans(rule, airMs);
+    if (spans.isEmpty()) {
+        return;
+    }
+    state.airMs = airMs;
+
+    IntervalIndex& week = rule.type == ScheduleRule::Type::Weekly ? m_weekIndex : m_onceWeekIndex;
+    for (const Span& span : spans) {
+        week.insert(span.start, span.end, rule.rowId);
+    }
+    if (rule.type == ScheduleRule::Type::Once) {
+        const qint64 atMs = rule.at.toMSecsSinceEpoch();
+        m_onceIndex.insert(atMs, atMs + state.airMs, rule.rowId);
+    }
+}
+
+void SchedulerEngine::unplace(RuleState& state)
+{
+    if (state.airMs <= 0) {
+        return;
+    }
+    const ScheduleRule& rule = state.rule;
+    IntervalIndex& week = rule.type == ScheduleRule::Type::Weekly ? m_weekIndex : m_onceWeekIndex;
+    for (const Span& span : weekSpans(rule, state.airMs)) {
+        week.remove(span.start, rule.rowId);
+    }
+    if (rule.type == ScheduleRule::Type::Once) {
+        m_onceIndex.remove(rule.at.toMSecsSinceEpoch(), rule.rowId);
+    }
+    state.airMs = 0;
+}
+
+QVector<SchedulerEngine::Span> SchedulerEngine::weekSpans(const ScheduleRule& rule, qint64 airMs)
+{
+    QVector<Span> spans;
+    qint64 start;
+    if (rule.type == ScheduleRule::Type::Weekly) {
+        if (rule.dayOfWeek < 1 || rule.dayOfWeek > 7 || !QTime(rule.hour, rule.minute).isValid()) {
+            return spans;
+        }
+        start = weekOffsetMs(rule.dayOfWeek, rule.hour, rule.minute);
+    } else {
+        if (!rule.at.isValid()) {
+            return spans;
+        }
+        start = weekOffsetMs(rule.at.date().dayOfWeek(), rule.at.time().hour(),
+                             rule.at.time().minute());
+    }
+
+    // What runs past Sunday night goes on at the start of the week
+    const qint64 end = start + qBound<qint64>(1, airMs, WEEK_MS);
+    spans.append({start, qMin(end, WEEK_MS)});
+    if (end > WEEK_MS) {
+        spans.append({0, end - WEEK_MS});
+    }
+    return spans;
+}
+
+void SchedulerEngine::logError(const QString& operation, const QString& error, const QString& query)
+{
+    QString logMessage = QString("SchedulerEngine::%1 - %2").arg(operation, error);
+    if (!query.isEmpty()) {
+        logMessage += QString(" (Query: %1)").arg(query);
+    }
+
+    qWarning() << logMessage;
+}
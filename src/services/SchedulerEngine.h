@@ -0,0 +1,278 @@
+#ifndef SCHEDULERENGINE_H
+#define SCHEDULERENGINE_H
+
+#include "AutomationClock.h"
+#include "IntervalIndex.h"
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QMetaType>
+#include <QObject>
+#include <QSqlDatabase>
+#include <QString>
+#include <QVector>
+#include <functional>
+
+/**
+ * @brief A rule from the scheduler table
+ *
+ * Type 1 rules fire once at a date and time, type 2 rules fire every week
+ * on a day and time. The rule points at a pub or programs row by id; its
+ * path is resolved when the rules are loaded.
+ */
+struct ScheduleRule {
+    enum class Type {
+        Once = 1,  ///< ano/mes/dia hora:min
+        Weekly = 2 ///< week_day hora:min
+    };
+
+    qint64 rowId = -1;  ///< scheduler rowid
+    int itemId = -1;    ///< pub or programs id
+    Type type = Type::Once;
+    QDateTime at;       ///< Once: date and time
+    int dayOfWeek = 0;  ///< Weekly: 1 (Monday) to 7 (Sunday)
+    int hour = 0;
+    int minute = 0;
+    bool isProgram = false;
+    QString path;
+
+    bool operator==(const ScheduleRule& other) const;
+    bool operator!=(const ScheduleRule& other) const { return !(*this == other); }
+};
+
+/**
+ * @brief A concrete firing of a schedule rule
+ */
+struct ScheduledEvent {
+    QDateTime fireAt;
+    ScheduleRule rule;
+};
+
+Q_DECLARE_METATYPE(ScheduledEvent)
+
+/**
+ * @brief Event-driven replacement for the minute-by-minute scheduler scan
+ *
+ * SchedulerEngine loads the scheduler table once, together with the pub
+ * and program paths it refers to, and keeps the next firing time of every
+ * rule in a min-heap. A single precise timer is armed for the earliest
+ * event, so events fire on the second they are due and nothing touches
+ * the database in between.
+ *
+ * reload() re-reads the table after it was edited. Rules that did not
+ * change keep their pending firing time; only new and edited rules are
+ * recomputed. As before, a rule still fires when its minute has started
+ * but not yet ended.
+ *
+ * upcomingEvents() expands the same rules into concrete firing times for a
+ * range, so callers can plan around upcoming pubs and programs without
+ * querying the table.
+ *
+ * Once a type 1 rule has fired, its scheduler row is deleted. A pub that
+ * has no rules left is deleted as well, and pubRemoved() is emitted.
+ *
+ * The time is that of an AutomationClock, the wall clock unless setClock()
+ * gives another; on a SimulatedClock a week of events fires in seconds.
+ *
+ * Each rule is also kept in interval trees as the time it is on air, the
+ * duration of its pub or program and at least its minute, so conflicts()
+ * tells in O(log n) which rules overlap one, loaded or about to be added.
+ * Weekly rules are placed in the week, one-shot rules by date and in their
+ * week, so recurring rules are never expanded. The trees follow reload()
+ * rule by rule, like the firing times.
+ *
+ * @example
+ * @code
+ * SchedulerEngine scheduler(db);
+ * connect(&scheduler, &SchedulerEngine::eventDue, this, [](const ScheduledEvent& event) {
+ *     qDebug() << "On air now:" << event.rule.path;
+ * });
+ * scheduler.start();
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class SchedulerEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    /// Longest timer sleep, so wall clock adjustments are noticed
+    static constexpr int MAX_SLEEP_MS = 60000;
+    /// Shortest time a rule is taken to be on air, its minute
+    static constexpr qint64 MIN_AIR_MS = 60000;
+    static constexpr qint64 WEEK_MS = 7LL * 24 * 3600 * 1000;
+
+    /// Returns the duration of a file in microseconds, -1 if unknown
+    using DurationLookup = std::function<qint64(const QString& filePath)>;
+
+    explicit SchedulerEngine(QSqlDatabase& database, QObject* parent = nullptr);
+
+    /**
+     * @brief Run on another clock, nullptr for the wall clock
+     *
+     * Pending firings are computed from the previous clock; reload() after
+     * a jump of time that rules should fire from.
+     */
+    void setClock(AutomationClock* clock);
+    AutomationClock* clock() const { return m_timer.clock(); }
+
+    /**
+     * @brief Set how the length of a pub or program is found, for conflicts()
+     *
+     * Rules already loaded are placed again with the lengths it finds.
+     */
+    void setDurationLookup(DurationLookup lookup);
+
+    /**
+     * @brief Load the rules and arm the timer
+     * @return true if the scheduler table was read
+     */
+    bool start();
+
+    /**
+     * @brief Disarm the timer
+     */
+    void stop();
+
+    /**
+     * @brief Re-read the scheduler table, recomputing new and edited rules only
+     * @return true if the scheduler table was read
+     */
+    bool reload();
+
+    /**
+     * @brief Get the next pending event
+     * @return Time of the earliest event, or an invalid QDateTime if none is pending
+     */
+    QDateTime nextFireTime() const;
+
+    /**
+     * @brief Expand the loaded rules into their firings within a time range
+     *
+     * Works on the in-memory rules only. Firings that already happened are
+     * left out; an overdue firing still inside its minute is included.
+     * @param from Start of the range
+     * @param to End of the range (exclusive)
+     * @return Events ordered by firing time
+     */
+    QList<ScheduledEvent> upcomingEvents(const QDateTime& from, const QDateTime& to) const;
+
+    /**
+     * @brief Get the number of loaded rules
+     * @return Rule count
+     */
+    int ruleCount() const { return m_rules.size(); }
+
+    /**
+     * @brief Compute the first firing of a rule whose minute ends after a point in time
+     * @param rule Schedule rule
+     * @param from Reference time
+     * @return Firing time, or an invalid QDateTime if the rule will not fire again
+     */
+    static QDateTime nextOccurrence(const ScheduleRule& rule, const QDateTime& from);
+
+    /**
+     * @brief Find the rules on air at the same time as a rule
+     *
+     * A weekly rule meets every other weekly rule of the same time of the
+     * week and every pending one-shot rule that falls on it; one-shot rules
+     * that fired already are left out.
+     * @param rule A loaded rule, or one not added yet with a rowId of -1
+     * @return The overlapping rules, by rowId, without the rule itself
+     */
+    QList<ScheduleRule> conflicts(const ScheduleRule& rule) const;
+
+    /**
+     * @brief Convert a week_day name of the scheduler table
+     * @return 1 (Monday) to 7 (Sunday), 0 if unknown
+     */
+    static int dayOfWeekFromName(const QString& name);
+
+    /**
+     * @brief Describe a rule the way the pub and program dialogs list them
+     */
+    static QString describe(const ScheduleRule& rule);
+
+    /**
+     * @brief Fire every event that is due now
+     *
+     * Called by the timer; public so the schedule can be driven explicitly.
+     * @param now Current time; the clock's when invalid
+     */
+    void processDue(const QDateTime& now = QDateTime());
+
+    /**
+     * @brief Treat a firing as done without emitting it, as after a restart
+     *
+     * A rule fires as long as its minute has not ended, so XFB restarted
+     * right after an event would play it again. The firings a QueueJournal
+     * kept are passed back here after start(). A one-shot rule is retired
+     * as if it had fired.
+     * @param rowId Rule that fired
+     * @param fireAt Time it fired for, ScheduledEvent::fireAt
+     * @return true if the rule was pending for that time
+     */
+    bool markFired(qint64 rowId, const QDateTime& fireAt);
+
+signals:
+    /**
+     * @brief Emitted when a scheduled event is due
+     * @param event The event
+     */
+    void eventDue(const ScheduledEvent& event);
+
+    /**
+     * @brief Emitted when a pub was deleted because its last rule fired
+     * @param pubId ID of the deleted pub
+     */
+    void pubRemoved(int pubId);
+
+    /**
+     * @brief Emitted when a database operation fails
+     * @param operation Name of the operation
+     * @param error Error message
+     */
+    void operationError(const QString& operation, const QString& error);
+
+private:
+    struct RuleState {
+        ScheduleRule rule;
+        qint64 nextFireMs = -1; ///< -1 when the rule will not fire again
+        qint64 airMs = 0;       ///< Length it is placed with for conflicts, 0 if not placed
+    };
+
+    struct Span {
+        qint64 start;
+        qint64 end;
+    };
+
+    struct HeapEntry {
+        qint64 fireMs;
+        qint64 rowId;
+        bool operator>(const HeapEntry& other) const { return fireMs > other.fireMs; }
+    };
+
+    bool readRules(QHash<qint64, ScheduleRule>& rules);
+    void rebuildHeap();
+    void pushEntry(qint64 fireMs, qint64 rowId);
+    void arm();
+    void retireOnce(const ScheduleRule& rule);
+    qint64 airTimeOf(const ScheduleRule& rule) const;
+    void place(RuleState& state);
+    void unplace(RuleState& state);
+    static QVector<Span> weekSpans(const ScheduleRule& rule, qint64 airMs);
+    void logError(const QString& operation, const QString& error, const QString& query = QString());
+
+    QSqlDatabase& m_database;
+    QHash<qint64, RuleState> m_rules;
+    QVector<HeapEntry> m_heap;
+    DurationLookup m_durationLookup;
+    IntervalIndex m_onceIndex;      ///< One-shot rules, by date
+    IntervalIndex m_weekIndex;      ///< Weekly rules, in the week from Monday 00:00
+    IntervalIndex m_onceWeekIndex;  ///< One-shot rules, where they fall in their week
+    ClockTimer m_timer;
+    bool m_running = false;
+};
+
+#endif // SCHEDULERENGINE_H
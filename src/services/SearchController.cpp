@@ -0,0 +1,390 @@
+#include "SearchController.h"
+#include "MusicCache.h"
+#include "../repositories/TrackRanking.h"
+#include <QDebug>
+#include <QRegularExpression>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QUuid>
+#include <QtConcurrent/QtConcurrentRun>
+#include <algorithm>
+
+namespace {
+
+// Rows read between two looks at the cancel flag
+constexpr int CANCEL_CHECK_ROWS = 256;
+
+// Lower case without accents, as the unicode61 tokenizer of musics_fts compares
+QString fold(const QString& text)
+{
+    const QString decomposed = text.normalized(QString::NormalizationForm_D);
+    QString folded;
+    folded.reserve(decomposed.size());
+    for (const QChar c : decomposed) {
+        if (c.category() != QChar::Mark_NonSpacing) {
+            folded.append(c);
+        }
+    }
+    return folded.toCaseFolded();
+}
+
+QStringList tokens(const QString& text)
+{
+    static const QRegularExpression separators(R"([^\p{L}\p{N}]+)");
+    return fold(text).split(separators, Qt::SkipEmptyParts);
+}
+
+// The words MusicRepository::fullTextQuery() turns into terms, each as the
+// tokens of its phrase
+QList<QStringList> terms(const QString& text)
+{
+    static const QRegularExpression whitespace(R"(\s+)");
+    QList<QStringList> terms;
+    for (const QString& word : text.split(whitespace, Qt::SkipEmptyParts)) {
+        const QStringList phrase = tokens(word);
+        if (!phrase.isEmpty()) {
+            terms.append(phrase);
+        }
+    }
+    return terms;
+}
+
+// A phrase term matches when its tokens follow each other, the last one as a prefix
+bool phraseMatches(const QStringList& document, const QStringList& phrase)
+{
+    const int last = int(phrase.size()) - 1;
+    for (int start = 0; start + last < document.size(); ++start) {
+        int i = 0;
+        while (i < last && document.at(start + i) == phrase.at(i)) {
+            ++i;
+        }
+        if (i == last && document.at(start + last).startsWith(phrase.at(last))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Every match of the longer phrase is a match of the shorter one
+bool phraseNarrows(const QStringList& previous, const QStringList& phrase)
+{
+    const int last = int(previous.size()) - 1;
+    if (phrase.size() < previous.size()) {
+        return false;
+    }
+    for (int i = 0; i < last; ++i) {
+        if (previous.at(i) != phrase.at(i)) {
+            return false;
+        }
+    }
+    return phrase.at(last).startsWith(previous.at(last));
+}
+
+} // namespace
+
+SearchController::SearchController(const QString& databasePath, MusicCache* cache,
+                                   QObject* parent)
+    : QObject(parent)
+    , m_databasePath(databasePath)
+    , m_cache(cache)
+    , m_cancelled(std::make_shared<std::atomic_bool>(false))
+{
+    m_debounce.setSingleShot(true);
+    m_debounce.setInterval(DEBOUNCE_MS);
+    connect(&m_debounce, &QTimer::timeout, this, &SearchController::startSearch);
+    connect(&m_watcher, &QFutureWatcher<Result>::finished, this, &SearchController::onFinished);
+}
+
+SearchController::~SearchController()
+{
+    m_cancelled->store(true);
+    m_watcher.disconnect(this);
+    m_watcher.waitForFinished();
+}
+
+void SearchController::setFullTextSearch(bool available)
+{
+    if (m_fullText != available) {
+        m_fullText = available;
+        m_hasPrevious = false;
+        m_previousItems.clear();
+    }
+}
+
+QString SearchController::condition(const QString& text, bool fullText, QVariantList& bindValues)
+{
+    bindValues.clear();
+    const QString term = text.trimmed();
+    if (term.isEmpty()) {
+        return QString();
+    }
+
+    const QString matchExpression = fullText ? MusicRepository::fullTextQuery(term) : QString();
+    if (!matchExpression.isEmpty()) {
+        // Prefix match every word through the full-text index
+        bindValues << matchExpression;
+        return "rowid IN (SELECT rowid FROM musics_fts WHERE musics_fts MATCH ?)";
+    }
+    const QString pattern = QString("%%1%").arg(term);
+    bindValues << pattern << pattern;
+    return "artist LIKE ? OR song LIKE ?";
+}
+
+bool SearchController::isRefinement(const QString& previous, const QString& text, bool fullText)
+{
+    const QString before = previous.trimmed();
+    const QString after = text.trimmed();
+    if (before.isEmpty() || after.isEmpty()) {
+        return false;
+    }
+
+    const QList<QStringList> beforeTerms = fullText ? terms(before) : QList<QStringList>();
+    const QList<QStringList> afterTerms = fullText ? terms(after) : QList<QStringList>();
+    if (beforeTerms.isEmpty() != afterTerms.isEmpty()) {
+        return false;
+    }
+    if (!beforeTerms.isEmpty()) {
+        if (afterTerms.size() < beforeTerms.size()) {
+            return false;
+        }
+        for (int i = 0; i < beforeTerms.size(); ++i) {
+            if (!phraseNarrows(beforeTerms.at(i), afterTerms.at(i))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // LIKE wildcards typed in the box cannot be matched here
+    if (after.contains('%') || after.contains('_')) {
+        return false;
+    }
+    return after.contains(before, Qt::CaseInsensitive);
+}
+
+bool SearchController::matches(const MusicItem& item, const QString& text, bool fullText)
+{
+    const QString term = text.trimmed();
+    const QList<QStringList> phrases = fullText ? terms(term) : QList<QStringList>();
+    if (phrases.isEmpty()) {
+        return term.isEmpty() || item.artist.contains(term, Qt::CaseInsensitive)
+               || item.song.contains(term, Qt::CaseInsensitive);
+    }
+
+    // A phrase never spans two columns of the index
+    const QList<QStringList> columns = {tokens(item.artist), tokens(item.song),
+                                        tokens(item.genre1), tokens(item.genre2),
+                                        tokens(item.path)};
+    for (const QStringList& phrase : phrases) {
+        const bool found = std::any_of(columns.cbegin(), columns.cend(),
+                                       [&phrase](const QStringList& column) {
+                                           return phraseMatches(column, phrase);
+                                       });
+        if (!found) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void SearchController::setText(const QString& text)
+{
+    m_text = text.trimmed();
+    m_debounce.start();
+}
+
+void SearchController::searchNow(const QString& text)
+{
+    m_text = text.trimmed();
+    m_debounce.stop();
+    startSearch();
+}
+
+void SearchController::invalidate()
+{
+    m_hasPrevious = false;
+    m_previousItems.clear();
+    if (m_cache) {
+        m_cache->invalidateSearchResults();
+    }
+}
+
+QString SearchController::cacheKey(const QString& text) const
+{
+    return QString("search:%1:%2").arg(m_fullText ? "fts" : "like", text.toCaseFolded());
+}
+
+void SearchController::startSearch()
+{
+    if (m_watcher.isRunning()) {
+        // The running search stops at its next check and this one follows
+        m_cancelled->store(true);
+        m_searchAgain = true;
+        return;
+    }
+    m_searchAgain = false;
+
+    Job job;
+    job.databasePath = m_databasePath;
+    job.text = m_text;
+    job.fullText = m_fullText;
+    const QString key = cacheKey(m_text);
+    if (!m_text.isEmpty() && m_cache && m_cache->containsSearchResults(key)) {
+        job.source = Source::Cached;
+        job.candidates = m_cache->getSearchResults(key);
+    } else if (m_hasPrevious && isRefinement(m_previousText, m_text, m_fullText)) {
+        job.source = Source::Refined;
+        job.candidates = m_previousItems;
+    }
+
+    m_cancelled = std::make_shared<std::atomic_bool>(false);
+    m_watcher.setFuture(QtConcurrent::run(
+        [job, cancelled = m_cancelled]() { return run(job, cancelled.get()); }));
+}
+
+void SearchController::onFinished()
+{
+    const Result result = m_watcher.result();
+    if (m_searchAgain) {
+        startSearch();
+        return;
+    }
+    if (result.cancelled) {
+        return;
+    }
+    if (!result.error.isEmpty()) {
+        qWarning() << "SearchController: cannot search for" << result.text << result.error;
+        emit searchFailed(result.error);
+        return;
+    }
+
+    m_hasPrevious = !result.text.isEmpty();
+    m_previousText = result.text;
+    m_previousItems = result.items;
+    if (m_cache && m_hasPrevious && result.source != Source::Cached) {
+        m_cache->putSearchResults(cacheKey(result.text), result.items, CACHE_SECONDS);
+    }
+    emit resultsReady(result);
+}
+
+SearchController::Result SearchController::run(const Job& job, const std::atomic_bool* cancelled)
+{
+    Result result;
+    result.text = job.text;
+    result.source = job.source;
+    result.condition = condition(job.text, job.fullText, result.bindValues);
+
+    QList<qint64> ids;
+    if (job.source != Source::Query) {
+        ids.reserve(job.candidates.size());
+        for (const MusicItem& item : job.candidates) {
+            if (job.source == Source::Cached || matches(item, job.text, job.fullText)) {
+                ids.append(item.id);
+            }
+        }
+        std::sort(ids.begin(), ids.end());
+    }
+
+    // Each job opens its own read-only connection on the pool thread running it
+    const QString connectionName = "xfb_search_" + QUuid::createUuid().toString(QUuid::Id128);
+    {
+        QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+        database.setDatabaseName(job.databasePath);
+        database.setConnectOptions("QSQLITE_OPEN_READONLY;QSQLITE_BUSY_TIMEOUT=5000");
+        if (!database.open()) {
+            result.error = database.lastError().text();
+        } else if (job.source == Source::Query) {
+            QSqlQuery query(database);
+            query.setForwardOnly(true);
+            QString sql = "SELECT rowid, * FROM musics";
+            if (!result.condition.isEmpty()) {
+                sql += " WHERE " + result.condition;
+            }
+            query.prepare(sql + " ORDER BY rowid");
+            for (const QVariant& value : std::as_const(result.bindValues)) {
+                query.addBindValue(value);
+            }
+            readRows(query, result, cancelled);
+        } else {
+            QSqlQuery query(database);
+            query.setForwardOnly(true);
+            for (int first = 0; first < ids.size(); first += ROW_CHUNK) {
+                const int count = qMin(ROW_CHUNK, int(ids.size()) - first);
+                QStringList placeholders;
+                placeholders.reserve(count);
+                for (int i = 0; i < count; ++i) {
+                    placeholders.append("?");
+                }
+                query.prepare(QString("SELECT rowid, * FROM musics WHERE rowid IN (%1) "
+                                      "ORDER BY rowid")
+                                  .arg(placeholders.join(", ")));
+                for (int i = first; i < first + count; ++i) {
+                    query.addBindValue(ids.at(i));
+                }
+                if (!readRows(query, result, cancelled)) {
+                    break;
+                }
+            }
+        }
+        if (database.isOpen() && result.error.isEmpty() && !result.cancelled
+            && !result.condition.isEmpty()) {
+            const QString matchExpression =
+                job.fullText ? MusicRepository::fullTextQuery(job.text.trimmed()) : QString();
+            result.ranked = TrackRanking(database).top(result.condition, result.bindValues,
+                                                       RANKED_LIMIT, matchExpression);
+        }
+        database.close();
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+    return result;
+}
+
+bool SearchController::readRows(QSqlQuery& query, Result& result, const std::atomic_bool* cancelled)
+{
+    if (!query.exec()) {
+        result.error = query.lastError().text();
+        return false;
+    }
+
+    if (result.fields.isEmpty()) {
+        const QSqlRecord record = query.record();
+        for (int i = 1; i < record.count(); ++i) {
+            result.fields.append(record.fieldName(i));
+        }
+    }
+    const int fieldCount = int(result.fields.size());
+    const int artist = int(result.fields.indexOf("artist"));
+    const int song = int(result.fields.indexOf("song"));
+    const int genre1 = int(result.fields.indexOf("genre1"));
+    const int genre2 = int(result.fields.indexOf("genre2"));
+    const int path = int(result.fields.indexOf("path"));
+
+    int rows = 0;
+    while (query.next()) {
+        if (cancelled && ++rows % CANCEL_CHECK_ROWS == 0 && cancelled->load()) {
+            result.cancelled = true;
+            return false;
+        }
+        QVariantList values;
+        values.reserve(fieldCount);
+        for (int i = 0; i < fieldCount; ++i) {
+            values.append(query.value(i + 1));
+        }
+
+        // Only the searched columns are kept for narrowing and the cache
+        if (!result.text.isEmpty()) {
+            MusicItem item;
+            item.id = query.value(0).toInt();
+            item.artist = artist >= 0 ? values.at(artist).toString() : QString();
+            item.song = song >= 0 ? values.at(song).toString() : QString();
+            item.genre1 = genre1 >= 0 ? values.at(genre1).toString() : QString();
+            item.genre2 = genre2 >= 0 ? values.at(genre2).toString() : QString();
+            item.path = path >= 0 ? values.at(path).toString() : QString();
+            result.items.append(item);
+        }
+        result.keys.append(query.value(0).toLongLong());
+        result.rows.append(values);
+    }
+    return true;
+}
@@ -0,0 +1,194 @@
+#ifndef SEARCHCONTROLLER_H
+#define SEARCHCONTROLLER_H
+
+#include "../repositories/MusicRepository.h"
+#include <QFutureWatcher>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+#include <QVariantList>
+#include <atomic>
+#include <memory>
+
+class MusicCache;
+class QSqlQuery;
+
+/**
+ * @brief Searches the library as the user types, off the GUI thread
+ *
+ * The search box used to run its query on the GUI thread when it was
+ * submitted, and a large library froze the window while the matches were
+ * read. SearchController waits until typing pauses for DEBOUNCE_MS, then
+ * reads the matching rows on a worker thread, on a read-only connection of
+ * its own. The rows are read in full, so the view can show them without
+ * another query, see LiveTableModel::assignRows().
+ *
+ * A search supersedes the one still running: that one stops at its next
+ * check, its result is dropped and the new text is searched right after.
+ * Results come from the first of these that applies:
+ * - the MusicCache, which keeps the matches of recent searches for
+ *   CACHE_SECONDS unless the repository it follows changes them;
+ * - the previous result, when the new text only narrows it, as "beat"
+ *   followed by "beatles" or "beatles yel" does (see isRefinement());
+ * - the musics_fts index, or LIKE on artist and song without it.
+ * Cached and narrowed matches are read again by rowid, ROW_CHUNK at a time.
+ *
+ * The rows stay in rowid order for the view. Result::ranked adds the
+ * RANKED_LIMIT best matches by TrackRanking, the played and relevant ones
+ * first, so the window can go straight to the usual version of a song.
+ *
+ * @example
+ * @code
+ * SearchController* search = new SearchController(databasePath, cache, this);
+ * search->setFullTextSearch(MusicRepository::ensureFullTextIndex(db));
+ * connect(edit, &QLineEdit::textEdited, search, &SearchController::setText);
+ * connect(search, &SearchController::resultsReady, this, &Window::showMatches);
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class SearchController : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int DEBOUNCE_MS = 120;
+    static constexpr int ROW_CHUNK = 500;        ///< rowids bound per statement
+    static constexpr int CACHE_SECONDS = 300;
+    static constexpr int RANKED_LIMIT = 20;       ///< Best matches in Result::ranked
+
+    /**
+     * @brief Where the matches of a result came from
+     */
+    enum class Source {
+        Query,      ///< The index or LIKE
+        Refined,    ///< The previous result, narrowed
+        Cached      ///< The MusicCache
+    };
+
+    /**
+     * @brief Matches of one search
+     */
+    struct Result {
+        QString text;               ///< Text searched for, trimmed; empty for the whole library
+        QString condition;          ///< Condition with the same matches, for LiveTableModel
+        QVariantList bindValues;    ///< Values for the placeholders of condition
+        QStringList fields;         ///< Columns of musics, in table order
+        QList<qint64> keys;         ///< rowid of each match, ascending
+        QList<QVariantList> rows;   ///< Values of each match, in fields order
+        QList<MusicItem> items;     ///< Searched columns of each match, for narrowing
+        QList<qint64> ranked;       ///< rowid of the best matches, best first
+        Source source = Source::Query;
+        bool cancelled = false;
+        QString error;              ///< Empty on success
+    };
+
+    /**
+     * @param databasePath Library database file the worker connection opens
+     * @param cache Cache for the matches of recent searches; may be nullptr
+     * @param parent Parent object
+     */
+    SearchController(const QString& databasePath, MusicCache* cache, QObject* parent = nullptr);
+    ~SearchController() override;
+
+    /**
+     * @brief Choose between the musics_fts index and LIKE
+     * @param available true if MusicRepository::ensureFullTextIndex() succeeded
+     */
+    void setFullTextSearch(bool available);
+    bool isFullTextSearch() const { return m_fullText; }
+
+    /**
+     * @brief Get the text searched for last, or to be searched once typing pauses
+     */
+    QString text() const { return m_text; }
+
+    bool isSearching() const { return m_watcher.isRunning(); }
+
+    /**
+     * @brief Build the condition a search uses
+     * @param text Text as typed
+     * @param fullText true to match through musics_fts
+     * @param bindValues Set to the values for the placeholders, in order
+     * @return Condition without the WHERE keyword, empty for the whole library
+     */
+    static QString condition(const QString& text, bool fullText, QVariantList& bindValues);
+
+    /**
+     * @brief Check whether every match of a text is a match of another
+     *
+     * With the index, every word of previous must start a word of text in
+     * the same place; without it, text must contain previous.
+     */
+    static bool isRefinement(const QString& previous, const QString& text, bool fullText);
+
+    /**
+     * @brief Check a track against a text as the search condition would
+     *
+     * Like the index, words are matched by prefix, ignoring case and
+     * accents, in artist, song, genre1, genre2 and path.
+     */
+    static bool matches(const MusicItem& item, const QString& text, bool fullText);
+
+public slots:
+    /**
+     * @brief Search for a text once typing pauses for DEBOUNCE_MS
+     */
+    void setText(const QString& text);
+
+    /**
+     * @brief Search for a text right away, as when Return is pressed
+     */
+    void searchNow(const QString& text);
+
+    /**
+     * @brief Forget the previous result and the cached ones
+     *
+     * Call it after the library was changed behind the repository's back.
+     */
+    void invalidate();
+
+signals:
+    /**
+     * @brief Emitted with the matches of the latest search that finished
+     */
+    void resultsReady(const SearchController::Result& result);
+
+    /**
+     * @brief Emitted when a search could not read the library
+     */
+    void searchFailed(const QString& error);
+
+private:
+    struct Job {
+        QString databasePath;
+        QString text;
+        bool fullText = false;
+        Source source = Source::Query;
+        QList<MusicItem> candidates;    ///< Narrowed or taken as they are, unless Query
+    };
+
+    static Result run(const Job& job, const std::atomic_bool* cancelled);
+    static bool readRows(QSqlQuery& query, Result& result, const std::atomic_bool* cancelled);
+    QString cacheKey(const QString& text) const;
+    void startSearch();
+    void onFinished();
+
+    QString m_databasePath;
+    MusicCache* m_cache;
+    bool m_fullText = false;
+    QString m_text;
+    QTimer m_debounce;
+    QFutureWatcher<Result> m_watcher;
+    std::shared_ptr<std::atomic_bool> m_cancelled;
+    bool m_searchAgain = false;
+    bool m_hasPrevious = false;
+    QString m_previousText;
+    QList<MusicItem> m_previousItems;
+};
+
+Q_DECLARE_METATYPE(SearchController::Result)
+
+#endif // SEARCHCONTROLLER_H
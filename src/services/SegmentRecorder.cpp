@@ -0,0 +1,651 @@
+#include "SegmentRecorder.h"
+#include <QAudioSource>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMediaDevices>
+#include <QProcess>
+#include <QStandardPaths>
+#include <QTextStream>
+#include <QTimer>
+#include <cstring>
+
+namespace {
+
+const QString SEGMENT_DIRECTORY_SUFFIX = QStringLiteral(".segments");
+const QString SEGMENT_PREFIX = QStringLiteral("segment-");
+const QString STAMP_FORMAT = QStringLiteral("yyyyMMdd-HHmmss");
+
+// Wait this long for ffmpeg to close its last segment when XFB quits
+constexpr int EXIT_FLUSH_MS = 5000;
+
+QString joinedFile(const QString& segmentDirectory, const QString& outputFile)
+{
+    return QDir(segmentDirectory).filePath("joined." + QFileInfo(outputFile).suffix());
+}
+
+} // namespace
+
+SegmentRecorder::SegmentRecorder(QObject* parent)
+    : QObject(parent)
+    , m_captureContext(new QObject)
+    , m_encoderContext(new QObject)
+{
+    m_captureThread.setObjectName("SegmentRecorderCapture");
+    m_encoderThread.setObjectName("SegmentRecorderEncoder");
+    m_captureContext->moveToThread(&m_captureThread);
+    m_encoderContext->moveToThread(&m_encoderThread);
+    connect(&m_captureThread, &QThread::finished, m_captureContext, &QObject::deleteLater);
+    connect(&m_encoderThread, &QThread::finished, m_encoderContext, &QObject::deleteLater);
+    m_captureThread.start(QThread::TimeCriticalPriority);
+    m_encoderThread.start();
+}
+
+SegmentRecorder::~SegmentRecorder()
+{
+    // Leave the segments for interruptedRecordings(); joining can take longer than quitting
+    m_recording = false;
+    stopCapture();
+    closeEncoder(EXIT_FLUSH_MS);
+    m_captureThread.quit();
+    m_encoderThread.quit();
+    m_captureThread.wait();
+    m_encoderThread.wait();
+    if (m_joiner) {
+        m_joiner->disconnect(this);
+        m_joiner->kill();
+        m_joiner->waitForFinished();
+    }
+}
+
+void SegmentRecorder::setExternalSource(int sampleRate, int channels)
+{
+    m_externalRate = qMax(0, sampleRate);
+    m_externalChannels = qMax(1, channels);
+}
+
+void SegmentRecorder::setReader(PcmReader reader, int sampleRate, int channels)
+{
+    m_reader = std::move(reader);
+    m_readerRate = qMax(0, sampleRate);
+    m_readerChannels = qMax(1, channels);
+}
+
+void SegmentRecorder::setCodec(const QString& codec, int bitrateKbps)
+{
+    m_codec = codec;
+    m_bitrateKbps = qMax(0, bitrateKbps);
+}
+
+bool SegmentRecorder::start(const QString& outputFile)
+{
+    if (isRecording() || isFinishing()) {
+        logError("start", "A recording is still running");
+        return false;
+    }
+    m_outputFile = outputFile;
+    const QString segmentDirectory =
+        segmentDirectoryFor(outputFile, QDateTime::currentDateTime());
+    return startRecording(segmentDirectory,
+                          QDir(segmentDirectory)
+                              .filePath(SEGMENT_PREFIX + "%05d." + QFileInfo(outputFile).suffix()),
+                          false);
+}
+
+bool SegmentRecorder::startArchive(const QString& directory, const QString& prefix,
+                                   const QString& suffix)
+{
+    if (isRecording() || isFinishing()) {
+        logError("start", "A recording is still running");
+        return false;
+    }
+    m_outputFile = directory;
+    m_archivePrefix = prefix;
+    m_archiveSuffix = suffix;
+    return startRecording(directory,
+                          QDir(directory).filePath(prefix + "-%Y%m%d-%H%M%S." + suffix), true);
+}
+
+bool SegmentRecorder::startRecording(const QString& directory, const QString& pattern,
+                                     bool archive)
+{
+    if (QStandardPaths::findExecutable(m_program).isEmpty()) {
+        logError("start", QString("Encoder %1 not found in PATH").arg(m_program));
+        return false;
+    }
+
+    QAudioDevice device;
+    QAudioFormat format;
+    const bool capture = !m_reader && m_externalRate <= 0;
+    if (m_reader && m_readerRate <= 0) {
+        logError("start", "The reader has no sample rate");
+        return false;
+    }
+    if (m_reader) {
+        m_sampleRate = m_readerRate;
+        m_channels = m_readerChannels;
+    } else if (!capture) {
+        m_sampleRate = m_externalRate;
+        m_channels = m_externalChannels;
+    } else {
+        device = m_device.isNull() ? QMediaDevices::defaultAudioInput() : m_device;
+        if (device.isNull()) {
+            logError("start", "No audio input");
+            return false;
+        }
+        format.setSampleRate(DEFAULT_SAMPLE_RATE);
+        format.setChannelCount(DEFAULT_CHANNELS);
+        format.setSampleFormat(QAudioFormat::Float);
+        if (!device.isFormatSupported(format)) {
+            format = device.preferredFormat();
+        }
+        m_sampleRate = format.sampleRate();
+        m_channels = format.channelCount();
+    }
+
+    if (!QDir().mkpath(directory)) {
+        logError("start", QString("Cannot create %1").arg(directory));
+        return false;
+    }
+    m_segmentDirectory = directory;
+    m_archive = archive;
+    // Files of earlier runs share an archive directory; report only this one's
+    const QString stamp = QDateTime::currentDateTime().toString(STAMP_FORMAT);
+    m_firstSegment = archive ? m_archivePrefix + "-" + stamp : QString();
+    m_lastReported.clear();
+
+    // Nothing reads or writes the ring buffer between two recordings
+    m_ring.resize(m_reader ? 0 : m_sampleRate * m_channels * RING_SECONDS);
+    m_ring.clear();
+    m_recorded = 0;
+    m_dropped = 0;
+    m_paused = false;
+
+    const auto discard = [this]() {
+        if (!m_archive) {
+            QDir(m_segmentDirectory).removeRecursively();
+        }
+    };
+    if (!startEncoder(encoderArguments(m_codec, m_bitrateKbps, m_sampleRate, m_channels,
+                                       m_segmentSeconds, pattern, archive))) {
+        discard();
+        return false;
+    }
+    m_encoding = true;
+    m_recording = true;
+
+    if (capture && !startCapture(device, format)) {
+        m_recording = false;
+        m_encoding = false;
+        closeEncoder(EXIT_FLUSH_MS);
+        discard();
+        logError("start", QString("Cannot open %1").arg(device.description()));
+        return false;
+    }
+
+    qInfo() << "SegmentRecorder: recording" << m_outputFile << "in"
+            << m_segmentSeconds << "s segments at" << m_sampleRate << "Hz";
+    return true;
+}
+
+void SegmentRecorder::stop()
+{
+    if (!isRecording()) {
+        return;
+    }
+    m_recording = false;
+    stopCapture();
+
+    // ffmpeg closes the last segment once its input ends, then reports back
+    QMetaObject::invokeMethod(m_encoderContext, [this]() {
+        if (!m_encoder) {
+            return;
+        }
+        m_pullTimer->stop();
+        pull(true);
+        m_encoder->closeWriteChannel();
+    });
+}
+
+int SegmentRecorder::write(const float* samples, int count)
+{
+    if (!isRecording() || count <= 0) {
+        return 0;
+    }
+    if (m_paused.load(std::memory_order_relaxed)) {
+        return count;
+    }
+    const int written = m_ring.write(samples, count);
+    m_recorded.fetch_add(written, std::memory_order_relaxed);
+    if (written < count) {
+        m_dropped.fetch_add(count - written, std::memory_order_relaxed);
+    }
+    return written;
+}
+
+bool SegmentRecorder::startCapture(const QAudioDevice& device, const QAudioFormat& format)
+{
+    bool started = false;
+    QMetaObject::invokeMethod(m_captureContext, [&]() {
+        m_captureFormat = format;
+        m_source = new QAudioSource(device, format, m_captureContext);
+        const int bytes = format.bytesForDuration(PULL_INTERVAL_MS * 1000) * 4;
+        m_captureBytes.resize(qMax(bytes, format.bytesPerFrame()));
+        m_captureSamples.resize(m_captureBytes.size());
+        m_captureDevice = m_source->start();
+        if (!m_captureDevice || m_source->error() != QAudio::NoError) {
+            delete m_source;
+            m_source = nullptr;
+            m_captureDevice = nullptr;
+            return;
+        }
+        connect(m_captureDevice, &QIODevice::readyRead, m_captureContext,
+                [this]() { readCapture(); });
+        started = true;
+    }, Qt::BlockingQueuedConnection);
+    return started;
+}
+
+void SegmentRecorder::readCapture()
+{
+    const int frameBytes = m_captureFormat.bytesPerFrame();
+    const int maxBytes = m_captureBytes.size() / frameBytes * frameBytes;
+    qint64 bytes;
+    while ((bytes = m_captureDevice->read(m_captureBytes.data(), maxBytes)) > 0) {
+        const int count = toFloat(m_captureBytes.constData(), int(bytes),
+                                  m_captureFormat.sampleFormat(), m_captureSamples.data());
+        write(m_captureSamples.data(), count);
+    }
+}
+
+void SegmentRecorder::stopCapture()
+{
+    QMetaObject::invokeMethod(m_captureContext, [this]() {
+        if (!m_source) {
+            return;
+        }
+        readCapture();
+        m_source->stop();
+        delete m_source;
+        m_source = nullptr;
+        m_captureDevice = nullptr;
+    }, Qt::BlockingQueuedConnection);
+}
+
+bool SegmentRecorder::startEncoder(const QStringList& arguments)
+{
+    QString error;
+    QMetaObject::invokeMethod(m_encoderContext, [&]() {
+        m_encoder = new QProcess(m_encoderContext);
+        m_encoder->setProcessChannelMode(QProcess::SeparateChannels);
+        m_encoder->start(m_program, arguments);
+        if (!m_encoder->waitForStarted()) {
+            error = m_encoder->errorString();
+            delete m_encoder;
+            m_encoder = nullptr;
+            return;
+        }
+        connect(m_encoder, &QProcess::finished, m_encoderContext,
+                [this](int exitCode, QProcess::ExitStatus status) {
+            QString failure;
+            if (status != QProcess::NormalExit || exitCode != 0) {
+                failure = QString::fromLocal8Bit(m_encoder->readAllStandardError()).trimmed();
+                if (failure.isEmpty()) {
+                    failure = QString("ffmpeg exited with code %1").arg(exitCode);
+                }
+            }
+            reportSegments(true);
+            m_encoder->deleteLater();
+            m_encoder = nullptr;
+            m_pullTimer->deleteLater();
+            m_pullTimer = nullptr;
+            QMetaObject::invokeMethod(this, [this, failure]() { onEncoderFinished(failure); });
+        });
+
+        const int pullFrames = qMax(1, m_sampleRate * PULL_INTERVAL_MS / 1000);
+        m_pullSamples.resize(size_t(pullFrames) * size_t(m_channels));
+        m_pullsSinceReport = 0;
+        m_pullTimer = new QTimer(m_encoderContext);
+        m_pullTimer->setInterval(PULL_INTERVAL_MS);
+        connect(m_pullTimer, &QTimer::timeout, m_encoderContext, [this]() { pull(false); });
+        m_pullTimer->start();
+    }, Qt::BlockingQueuedConnection);
+
+    if (!error.isEmpty()) {
+        logError("start", QString("Cannot start %1: %2").arg(m_program, error));
+        return false;
+    }
+    return true;
+}
+
+void SegmentRecorder::closeEncoder(int timeoutMs)
+{
+    QMetaObject::invokeMethod(m_encoderContext, [this, timeoutMs]() {
+        if (!m_encoder) {
+            return;
+        }
+        m_encoder->disconnect(m_encoderContext);
+        m_pullTimer->stop();
+        pull(true);
+        m_encoder->closeWriteChannel();
+        if (!m_encoder->waitForFinished(timeoutMs)) {
+            m_encoder->kill();
+            m_encoder->waitForFinished();
+        }
+        delete m_encoder;
+        m_encoder = nullptr;
+        delete m_pullTimer;
+        m_pullTimer = nullptr;
+    }, Qt::BlockingQueuedConnection);
+    m_encoding = false;
+}
+
+void SegmentRecorder::pull(bool drain)
+{
+    if (!m_encoder || m_encoder->state() != QProcess::Running) {
+        return;
+    }
+    // Leave the audio in the ring buffer rather than in an unbounded pipe backlog
+    while (drain || m_encoder->bytesToWrite() < MAX_ENCODER_BACKLOG_BYTES) {
+        const int capacity = int(m_pullSamples.size());
+        const int samples = m_reader ? m_reader(m_pullSamples.data(), capacity)
+                                     : m_ring.read(m_pullSamples.data(), capacity);
+        if (samples <= 0) {
+            break;
+        }
+        if (m_reader) {
+            // A reader's audio is counted as it is taken rather than in write()
+            if (m_paused.load(std::memory_order_relaxed)) {
+                continue;
+            }
+            m_recorded.fetch_add(samples, std::memory_order_relaxed);
+        }
+        m_encoder->write(reinterpret_cast<const char*>(m_pullSamples.data()),
+                         qint64(samples) * qint64(sizeof(float)));
+    }
+
+    if (++m_pullsSinceReport * PULL_INTERVAL_MS >= REPORT_INTERVAL_MS) {
+        m_pullsSinceReport = 0;
+        reportSegments(false);
+    }
+}
+
+void SegmentRecorder::reportSegments(bool all)
+{
+    // The segment ffmpeg is writing is the last one; the ones before it are closed
+    QStringList files = m_archive
+        ? archiveFiles(m_segmentDirectory, m_archivePrefix, m_archiveSuffix)
+        : segmentFiles(m_segmentDirectory);
+    if (!all && !files.isEmpty()) {
+        files.removeLast();
+    }
+    for (const QString& file : files) {
+        const QString name = QFileInfo(file).fileName();
+        if (name < m_firstSegment || (!m_lastReported.isEmpty() && name <= m_lastReported)) {
+            continue;
+        }
+        m_lastReported = name;
+        QMetaObject::invokeMethod(this, [this, file]() { emit segmentWritten(file); });
+    }
+}
+
+void SegmentRecorder::onEncoderFinished(const QString& error)
+{
+    m_encoding = false;
+    if (!error.isEmpty()) {
+        logError("encoder", error);
+    }
+    if (m_archive) {
+        // Every file of an archive is complete as it is
+        emit finished(m_segmentDirectory, error.isEmpty(), error);
+        return;
+    }
+    if (segmentFiles(m_segmentDirectory).isEmpty()) {
+        QDir(m_segmentDirectory).removeRecursively();
+        const QString reason = error.isEmpty() ? QString("Nothing was recorded") : error;
+        logError("stop", reason);
+        emit finished(m_outputFile, false, reason);
+        return;
+    }
+    m_joins.append({m_segmentDirectory, m_outputFile});
+    startNextJoin();
+}
+
+void SegmentRecorder::startNextJoin()
+{
+    while (!m_joiner && !m_joins.isEmpty()) {
+        const Join& join = m_joins.first();
+        const QString listFile = QDir(join.segmentDirectory).filePath("segments.txt");
+        if (!writeConcatList(listFile, segmentFiles(join.segmentDirectory))) {
+            const Join failed = m_joins.takeFirst();
+            const QString error = QString("Cannot write %1").arg(listFile);
+            logError("join", error);
+            emit finished(failed.outputFile, false, error);
+            continue;
+        }
+
+        m_joiner = new QProcess(this);
+        connect(m_joiner, &QProcess::finished, this, [this](int exitCode) {
+            onJoinFinished(exitCode,
+                           QString::fromLocal8Bit(m_joiner->readAllStandardError()).trimmed());
+        });
+        connect(m_joiner, &QProcess::errorOccurred, this, [this](QProcess::ProcessError error) {
+            if (error == QProcess::FailedToStart) {
+                onJoinFinished(-1, m_joiner->errorString());
+            }
+        });
+        m_joiner->start(m_program, {"-hide_banner", "-loglevel", "error", "-y",
+                                    "-f", "concat", "-safe", "0", "-i", listFile,
+                                    "-c", "copy",
+                                    joinedFile(join.segmentDirectory, join.outputFile)});
+    }
+}
+
+void SegmentRecorder::onJoinFinished(int exitCode, const QString& error)
+{
+    const Join join = m_joins.takeFirst();
+    m_joiner->disconnect(this);
+    m_joiner->deleteLater();
+    m_joiner = nullptr;
+
+    const QString joined = joinedFile(join.segmentDirectory, join.outputFile);
+    QString failure;
+    if (exitCode != 0 || !QFileInfo::exists(joined)) {
+        failure = error.isEmpty() ? QString("ffmpeg exited with code %1").arg(exitCode) : error;
+    } else if (QFile::exists(join.outputFile) && !QFile::remove(join.outputFile)) {
+        failure = QString("Cannot replace %1").arg(join.outputFile);
+    } else if (!QFile::rename(joined, join.outputFile)) {
+        failure = QString("Cannot write %1").arg(join.outputFile);
+    }
+
+    if (failure.isEmpty()) {
+        QDir(join.segmentDirectory).removeRecursively();
+        qInfo() << "SegmentRecorder: joined" << join.outputFile;
+    } else {
+        QFile::remove(joined);
+        logError("join", QString("%1; segments kept in %2").arg(failure, join.segmentDirectory));
+    }
+    emit finished(join.outputFile, failure.isEmpty(), failure);
+    startNextJoin();
+}
+
+QString SegmentRecorder::segmentDirectoryFor(const QString& outputFile, const QDateTime& started)
+{
+    const QFileInfo info(outputFile);
+    return info.dir().filePath(QString(".%1-%2.%3%4")
+                                   .arg(info.completeBaseName(), started.toString(STAMP_FORMAT),
+                                        info.suffix(), SEGMENT_DIRECTORY_SUFFIX));
+}
+
+QStringList SegmentRecorder::segmentFiles(const QString& segmentDirectory)
+{
+    const QDir dir(segmentDirectory);
+    QStringList files;
+    for (const QString& name : dir.entryList({SEGMENT_PREFIX + "*"}, QDir::Files, QDir::Name)) {
+        files.append(dir.filePath(name));
+    }
+    return files;
+}
+
+QStringList SegmentRecorder::archiveFiles(const QString& directory, const QString& prefix,
+                                          const QString& suffix)
+{
+    const QDir dir(directory);
+    QStringList files;
+    const QStringList names =
+        dir.entryList({QString("%1-*.%2").arg(prefix, suffix)}, QDir::Files, QDir::Name);
+    for (const QString& name : names) {
+        files.append(dir.filePath(name));
+    }
+    return files;
+}
+
+QStringList SegmentRecorder::interruptedRecordings(const QString& directory)
+{
+    const QDir dir(directory);
+    QStringList recordings;
+    const QStringList names = dir.entryList({QStringLiteral(".*") + SEGMENT_DIRECTORY_SUFFIX},
+                                            QDir::Dirs | QDir::Hidden | QDir::NoDotAndDotDot,
+                                            QDir::Name);
+    for (const QString& name : names) {
+        const QString path = dir.filePath(name);
+        if (!segmentFiles(path).isEmpty()) {
+            recordings.append(path);
+        }
+    }
+    return recordings;
+}
+
+QString SegmentRecorder::recoveredFile(const QString& segmentDirectory)
+{
+    const QFileInfo info(segmentDirectory);
+    QString name = info.fileName();
+    name.remove(0, 1);
+    name.chop(SEGMENT_DIRECTORY_SUFFIX.size());
+    return info.dir().filePath(name);
+}
+
+bool SegmentRecorder::recover(const QString& segmentDirectory)
+{
+    const QString path = QFileInfo(segmentDirectory).absoluteFilePath();
+    if (segmentFiles(path).isEmpty()) {
+        return false;
+    }
+    const bool current = isRecording() || m_encoding;
+    if (current && path == QFileInfo(m_segmentDirectory).absoluteFilePath()) {
+        return false;
+    }
+    for (const Join& join : m_joins) {
+        if (QFileInfo(join.segmentDirectory).absoluteFilePath() == path) {
+            return true;
+        }
+    }
+    qInfo() << "SegmentRecorder: recovering" << path;
+    m_joins.append({path, recoveredFile(path)});
+    startNextJoin();
+    return true;
+}
+
+QStringList SegmentRecorder::encoderArguments(const QString& codec, int bitrateKbps,
+                                              int sampleRate, int channels, int segmentSeconds,
+                                              const QString& segmentPattern, bool archive)
+{
+    QStringList args{"-hide_banner", "-loglevel", "error",
+                     "-f", "f32le", "-ar", QString::number(sampleRate),
+                     "-ac", QString::number(channels), "-i", "pipe:0",
+                     "-c:a", codec.isEmpty() ? defaultCodec(QFileInfo(segmentPattern).suffix())
+                                             : codec};
+    if (bitrateKbps > 0) {
+        args << "-b:a" << QString("%1k").arg(bitrateKbps);
+    }
+    args << "-f" << "segment" << "-segment_time" << QString::number(segmentSeconds)
+         << "-reset_timestamps" << "1";
+    if (archive) {
+        // Cut on the wall clock, on the hour for hourly files, and name them after it
+        args << "-segment_atclocktime" << "1" << "-strftime" << "1";
+    }
+    args << segmentPattern;
+    return args;
+}
+
+QString SegmentRecorder::defaultCodec(const QString& suffix)
+{
+    const QString s = suffix.toLower();
+    if (s == "opus") {
+        return "libopus";
+    }
+    if (s == "mp3") {
+        return "libmp3lame";
+    }
+    if (s == "m4a" || s == "mp4" || s == "mov" || s == "aac") {
+        return "aac";
+    }
+    if (s == "flac") {
+        return "flac";
+    }
+    if (s == "wav") {
+        return "pcm_s16le";
+    }
+    return "libvorbis";
+}
+
+bool SegmentRecorder::writeConcatList(const QString& listFile, const QStringList& files)
+{
+    QFile file(listFile);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        return false;
+    }
+    QTextStream out(&file);
+    for (const QString& path : files) {
+        // The concat demuxer reads 'a'\''b' as a'b, like a shell
+        QString quoted = QFileInfo(path).absoluteFilePath();
+        quoted.replace("'", "'\\''");
+        out << "file '" << quoted << "'\n";
+    }
+    out.flush();
+    return out.status() == QTextStream::Ok && file.error() == QFile::NoError;
+}
+
+int SegmentRecorder::toFloat(const char* data, int bytes, QAudioFormat::SampleFormat format,
+                             float* out)
+{
+    switch (format) {
+    case QAudioFormat::Float: {
+        const int count = bytes / int(sizeof(float));
+        std::memcpy(out, data, size_t(count) * sizeof(float));
+        return count;
+    }
+    case QAudioFormat::Int16: {
+        const int count = bytes / int(sizeof(qint16));
+        for (int i = 0; i < count; ++i) {
+            qint16 sample;
+            std::memcpy(&sample, data + i * sizeof(qint16), sizeof(sample));
+            out[i] = sample / 32768.0f;
+        }
+        return count;
+    }
+    case QAudioFormat::Int32: {
+        const int count = bytes / int(sizeof(qint32));
+        for (int i = 0; i < count; ++i) {
+            qint32 sample;
+            std::memcpy(&sample, data + i * sizeof(qint32), sizeof(sample));
+            out[i] = float(sample / 2147483648.0);
+        }
+        return count;
+    }
+    case QAudioFormat::UInt8:
+        for (int i = 0; i < bytes; ++i) {
+            out[i] = (static_cast<uchar>(data[i]) - 128) / 128.0f;
+        }
+        return bytes;
+    default:
+        return 0;
+    }
+}
+
+void SegmentRecorder::logError(const QString& operation, const QString& error)
+{
+    qWarning() << QString("SegmentRecorder::%1 - %2").arg(operation, error);
+    emit operationError(operation, error);
+}
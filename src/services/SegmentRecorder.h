@@ -0,0 +1,383 @@
+#ifndef SEGMENTRECORDER_H
+#define SEGMENTRECORDER_H
+
+#include <QAudioDevice>
+#include <QAudioFormat>
+#include <QByteArray>
+#include <QDateTime>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+#include <atomic>
+#include <functional>
+#include <vector>
+
+#include "AudioRingBuffer.h"
+
+class QAudioSource;
+class QIODevice;
+class QProcess;
+class QTimer;
+
+/**
+ * @brief Records to rolling segment files, so a crash loses seconds rather than the show
+ *
+ * QMediaRecorder writes one file and finalises it when recording stops. If
+ * XFB dies two hours into a show, the file has no usable index, or is lost.
+ * SegmentRecorder instead hands the audio to an ffmpeg segment muxer. It
+ * closes a complete file every segmentSeconds(), in a hidden directory next
+ * to the output. When the recording stops, the segments are joined into
+ * the output with a stream copy, which takes seconds and does not encode
+ * again.
+ *
+ * The audio takes three threads:
+ * - The capture thread reads the QAudioSource and converts the samples to
+ *   float. It writes them into a lock-free AudioRingBuffer and never
+ *   waits.
+ * - The encoder thread drains the ring buffer into ffmpeg, which runs on
+ *   other cores.
+ * - The GUI thread only starts and stops the recording.
+ *
+ * The ring buffer holds RING_SECONDS of audio, so a stalled encoder does
+ * not lose any. Audio that still does not fit is dropped and counted in
+ * droppedSamples().
+ *
+ * Instead of a sound card, samples can be fed with write() from any single
+ * thread; see setExternalSource(). Or setReader() has the encoder thread
+ * pull them, such as from the playback tap, with no ring buffer between.
+ *
+ * startArchive() keeps the segments rather than joining them. They are
+ * written straight into a directory, named after the time they start, and
+ * cut on the wall clock. This suits a recorder that runs around the clock
+ * and writes hourly files.
+ *
+ * Segment directories left by a crash are found with
+ * interruptedRecordings(). recover() joins one of them into a file named
+ * after the time the recording started.
+ *
+ * @example
+ * @code
+ * SegmentRecorder* recorder = new SegmentRecorder(this);
+ * recorder->setProgram(QStandardPaths::findExecutable("ffmpeg"));
+ * recorder->setDevice(QMediaDevices::defaultAudioInput());
+ * connect(recorder, &SegmentRecorder::finished, this,
+ *         [](const QString& file, bool ok) { qDebug() << file << ok; });
+ * recorder->start(savePath + "/show.ogg");
+ * // ...
+ * recorder->stop();
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class SegmentRecorder : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int DEFAULT_SEGMENT_SECONDS = 5 * 60;
+    static constexpr int DEFAULT_SAMPLE_RATE = 48000;
+    static constexpr int DEFAULT_CHANNELS = 2;
+    static constexpr int RING_SECONDS = 30;
+    static constexpr int PULL_INTERVAL_MS = 20;
+    static constexpr int REPORT_INTERVAL_MS = 1000;   ///< How often new segments are looked for
+    /// Input ffmpeg may fall behind by before the ring buffer holds the rest
+    static constexpr qint64 MAX_ENCODER_BACKLOG_BYTES = 2 * 1024 * 1024;
+
+    /// Returns up to the given number of interleaved float samples, 0 if none is ready
+    using PcmReader = std::function<int(float*, int)>;
+
+    explicit SegmentRecorder(QObject* parent = nullptr);
+    ~SegmentRecorder() override;
+
+    /**
+     * @brief Set the ffmpeg executable
+     * @param program Path or name of ffmpeg; "ffmpeg" by default
+     */
+    void setProgram(const QString& program) { m_program = program; }
+    QString program() const { return m_program; }
+
+    /**
+     * @brief Set the input to record from
+     * @param device Audio input; the default input if null
+     */
+    void setDevice(const QAudioDevice& device) { m_device = device; }
+
+    /**
+     * @brief Record samples passed to write() rather than a sound card
+     * @param sampleRate Rate of the samples in Hz, or 0 to capture from the device again
+     * @param channels Channels per interleaved frame
+     */
+    void setExternalSource(int sampleRate, int channels = DEFAULT_CHANNELS);
+
+    /**
+     * @brief Record what a reader returns rather than a sound card
+     *
+     * The reader is called on the encoder thread every PULL_INTERVAL_MS.
+     * @param reader Source of samples, or null to capture from the device again
+     * @param sampleRate Rate of the samples in Hz
+     * @param channels Channels per interleaved frame
+     */
+    void setReader(PcmReader reader, int sampleRate, int channels = DEFAULT_CHANNELS);
+
+    /**
+     * @brief Choose the encoder
+     * @param codec ffmpeg encoder name, or empty for the usual one for the output's suffix
+     * @param bitrateKbps Bitrate, or 0 for the encoder's default quality
+     */
+    void setCodec(const QString& codec, int bitrateKbps = 0);
+    QString codec() const { return m_codec; }
+
+    void setSegmentSeconds(int seconds) { m_segmentSeconds = qMax(1, seconds); }
+    int segmentSeconds() const { return m_segmentSeconds; }
+
+    /**
+     * @brief Start recording
+     *
+     * ffmpeg picks the container from the output's suffix.
+     * @param outputFile File the segments are joined into when recording stops
+     * @return false if recording or joining, or ffmpeg or the input cannot be opened
+     */
+    bool start(const QString& outputFile);
+
+    /**
+     * @brief Start recording into files that are kept as they are
+     *
+     * Each segment is "<prefix>-yyyyMMdd-HHmmss.<suffix>", named after the
+     * time it starts. Segments are cut on the wall clock, on the hour when
+     * segmentSeconds() is 3600. Files of earlier runs in the directory are
+     * left alone.
+     * @param directory Directory of the files, created if needed
+     * @param prefix Start of the file names
+     * @param suffix File suffix, which picks the container
+     * @return false if recording or joining, or ffmpeg or the input cannot be opened
+     */
+    bool startArchive(const QString& directory, const QString& prefix, const QString& suffix);
+
+    /**
+     * @brief Stop recording and join the segments
+     *
+     * Returns at once; finished() follows once the output is written.
+     */
+    void stop();
+
+    /**
+     * @brief Drop the audio while paused, without closing the segment
+     */
+    void setPaused(bool paused) { m_paused = paused; }
+    bool isPaused() const { return m_paused; }
+
+    bool isRecording() const { return m_recording.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Check if segments are still being joined
+     * @return true from stop() until the last finished(); for an archive, until ffmpeg exits
+     */
+    bool isFinishing() const { return m_encoding || !m_joins.isEmpty(); }
+
+    /**
+     * @brief Feed samples to an external source recording
+     *
+     * Never blocks or allocates; may be called from one thread at a time.
+     * @param samples Interleaved float samples
+     * @param count Number of samples
+     * @return Samples taken; the rest was dropped
+     */
+    int write(const float* samples, int count);
+
+    /**
+     * @brief Get how much audio was recorded
+     * @return Samples taken into the ring buffer since start()
+     */
+    qint64 recordedSamples() const { return m_recorded.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Get how much audio was lost because the encoder fell behind
+     * @return Samples dropped since start()
+     */
+    qint64 droppedSamples() const { return m_dropped.load(std::memory_order_relaxed); }
+
+    int sampleRate() const { return m_sampleRate; }
+    int channels() const { return m_channels; }
+
+    /**
+     * @brief Get where the segments of a recording are kept
+     * @param outputFile Output of the recording
+     * @param started When it started
+     * @return Hidden directory next to the output, named after both
+     */
+    static QString segmentDirectoryFor(const QString& outputFile, const QDateTime& started);
+
+    /**
+     * @brief Get the segment files in a directory, in recording order
+     * @param segmentDirectory Directory
+     * @return Paths of the segments
+     */
+    static QStringList segmentFiles(const QString& segmentDirectory);
+
+    /**
+     * @brief Get the files of an archive, oldest first
+     * @param directory Directory of the archive
+     * @param prefix Start of the file names
+     * @param suffix File suffix
+     * @return Paths of the files
+     */
+    static QStringList archiveFiles(const QString& directory, const QString& prefix,
+                                    const QString& suffix);
+
+    /**
+     * @brief Find recordings that were not joined, such as after a crash
+     * @param directory Directory the recordings were saved in
+     * @return Their segment directories
+     */
+    static QStringList interruptedRecordings(const QString& directory);
+
+    /**
+     * @brief Get the file an interrupted recording is recovered into
+     * @param segmentDirectory Segment directory of the recording
+     * @return "<name>-<yyyyMMdd-HHmmss>.<suffix>" next to it
+     */
+    static QString recoveredFile(const QString& segmentDirectory);
+
+    /**
+     * @brief Join the segments of an interrupted recording
+     *
+     * Queued behind the joins already running; finished() reports the result.
+     * @param segmentDirectory Segment directory of the recording
+     * @return false if it holds no segment
+     */
+    bool recover(const QString& segmentDirectory);
+
+    /**
+     * @brief Get the ffmpeg arguments of a recording
+     * @param codec ffmpeg encoder, or empty for the suffix's usual one
+     * @param bitrateKbps Bitrate, or 0
+     * @param sampleRate Rate of the f32le PCM on stdin
+     * @param channels Channels of the PCM
+     * @param segmentSeconds Length of each segment
+     * @param segmentPattern Path with a printf "%05d" for the segment number, or
+     *                       strftime fields for an archive
+     * @param archive Cut segments on the wall clock and name them with strftime
+     * @return Arguments
+     */
+    static QStringList encoderArguments(const QString& codec, int bitrateKbps, int sampleRate,
+                                        int channels, int segmentSeconds,
+                                        const QString& segmentPattern, bool archive = false);
+
+    /**
+     * @brief Get the usual ffmpeg encoder for a container
+     * @param suffix File suffix, such as "ogg"
+     * @return Encoder name
+     */
+    static QString defaultCodec(const QString& suffix);
+
+    /**
+     * @brief Convert captured PCM to float samples
+     * @param data PCM in native byte order
+     * @param bytes Size of the data
+     * @param format Sample format
+     * @param out Destination, room for one float per sample
+     * @return Samples written to out, 0 for an unknown format
+     */
+    static int toFloat(const char* data, int bytes, QAudioFormat::SampleFormat format,
+                       float* out);
+
+    /**
+     * @brief Write a list for ffmpeg's concat demuxer
+     * @param listFile File to write
+     * @param files Files to join, in order
+     * @return false if it cannot be written
+     */
+    static bool writeConcatList(const QString& listFile, const QStringList& files);
+
+signals:
+    /**
+     * @brief Emitted when a segment is complete on disk
+     * @param segmentFile Path of the segment
+     */
+    void segmentWritten(const QString& segmentFile);
+
+    /**
+     * @brief Emitted when the segments of a recording are joined, or could not be
+     *
+     * For an archive, emitted once ffmpeg has closed the last file.
+     * @param outputFile Joined file, or the directory of an archive
+     * @param success Whether it was written; the segments are kept otherwise
+     * @param error What went wrong
+     */
+    void finished(const QString& outputFile, bool success, const QString& error);
+
+    /**
+     * @brief Emitted when an operation fails
+     * @param operation Name of the operation
+     * @param error Error message
+     */
+    void operationError(const QString& operation, const QString& error);
+
+private:
+    struct Join {
+        QString segmentDirectory;
+        QString outputFile;
+    };
+
+    bool startRecording(const QString& directory, const QString& pattern, bool archive);
+    bool startCapture(const QAudioDevice& device, const QAudioFormat& format);
+    void readCapture();
+    void stopCapture();
+    bool startEncoder(const QStringList& arguments);
+    void closeEncoder(int timeoutMs);
+    void pull(bool drain);
+    void reportSegments(bool all);
+    void onEncoderFinished(const QString& error);
+    void startNextJoin();
+    void onJoinFinished(int exitCode, const QString& error);
+    void logError(const QString& operation, const QString& error);
+
+    QString m_program = "ffmpeg";
+    QAudioDevice m_device;
+    QString m_codec;
+    int m_bitrateKbps = 0;
+    int m_segmentSeconds = DEFAULT_SEGMENT_SECONDS;
+    int m_externalRate = 0;
+    int m_externalChannels = DEFAULT_CHANNELS;
+    PcmReader m_reader;
+    int m_readerRate = 0;
+    int m_readerChannels = DEFAULT_CHANNELS;
+    int m_sampleRate = DEFAULT_SAMPLE_RATE;
+    int m_channels = DEFAULT_CHANNELS;
+
+    QString m_outputFile;
+    QString m_segmentDirectory;
+    bool m_archive = false;
+    QString m_archivePrefix;
+    QString m_archiveSuffix;
+    QString m_firstSegment;   ///< Archive files named before it are from earlier runs
+    AudioRingBuffer m_ring;
+    std::atomic<qint64> m_recorded{0};
+    std::atomic<qint64> m_dropped{0};
+    std::atomic<bool> m_paused{false};
+    std::atomic<bool> m_recording{false};   ///< Taking samples into the ring buffer
+    bool m_encoding = false;   ///< ffmpeg still writing segments
+
+    QThread m_captureThread;
+    QObject* m_captureContext;             ///< Lives on m_captureThread
+    QAudioSource* m_source = nullptr;      ///< Capture thread only
+    QIODevice* m_captureDevice = nullptr;  ///< Capture thread only
+    QAudioFormat m_captureFormat;          ///< Capture thread only
+    QByteArray m_captureBytes;             ///< Capture thread only
+    std::vector<float> m_captureSamples;   ///< Capture thread only
+
+    QThread m_encoderThread;
+    QObject* m_encoderContext;             ///< Lives on m_encoderThread
+    QProcess* m_encoder = nullptr;         ///< Encoder thread only
+    QTimer* m_pullTimer = nullptr;         ///< Encoder thread only
+    std::vector<float> m_pullSamples;      ///< Encoder thread only
+    int m_pullsSinceReport = 0;            ///< Encoder thread only
+    QString m_lastReported;                ///< Encoder thread only
+
+    QList<Join> m_joins;   ///< Running one first
+    QProcess* m_joiner = nullptr;
+};
+
+#endif // SEGMENTRECORDER_H
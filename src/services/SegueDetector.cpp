@@ -0,0 +1,118 @@
+#include "SegueDetector.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Independent lanes so the compiler can keep them in one SIMD register
+float sumOfSquares(const float* samples, qint64 count)
+{
+    constexpr int LANES = 8;
+    float lanes[LANES] = {};
+    qint64 i = 0;
+    for (; i + LANES <= count; i += LANES) {
+        for (int lane = 0; lane < LANES; ++lane) {
+            lanes[lane] += samples[i + lane] * samples[i + lane];
+        }
+    }
+    float sum = 0.0f;
+    for (; i < count; ++i) {
+        sum += samples[i] * samples[i];
+    }
+    for (float lane : lanes) {
+        sum += lane;
+    }
+    return sum;
+}
+
+} // namespace
+
+SegueDetector::SegueDetector(int sampleRate, int channels, const Settings& settings)
+    : m_sampleRate(qMax(1, sampleRate))
+    , m_channels(qMax(1, channels))
+    , m_settings(settings)
+    , m_blockSamples(qMax<qint64>(1, qint64(BLOCK_MS) * m_sampleRate / 1000) * m_channels)
+{
+}
+
+SegueDetector::SegueDetector(int sampleRate, int channels)
+    : SegueDetector(sampleRate, channels, Settings())
+{
+}
+
+void SegueDetector::feed(const float* samples, qint64 count)
+{
+    m_samples += qMax<qint64>(0, count);
+    while (count > 0) {
+        const qint64 take = qMin(count, m_blockSamples - m_blockFill);
+        m_blockSum += sumOfSquares(samples, take);
+        m_blockFill += take;
+        samples += take;
+        count -= take;
+
+        if (m_blockFill == m_blockSamples) {
+            m_blocks.append(m_blockSum / m_blockSamples);
+            m_blockSum = 0.0f;
+            m_blockFill = 0;
+        }
+    }
+}
+
+SegueDetector::Result SegueDetector::result() const
+{
+    QVector<float> blocks = m_blocks;
+    if (m_blockFill > 0) {
+        blocks.append(m_blockSum / m_blockFill);
+    }
+    const qsizetype windows = blocks.size() - WINDOW_BLOCKS + 1;
+    if (windows <= 0) {
+        return Result();
+    }
+
+    QVector<double> levels(windows);
+    QVector<double> audible;
+    for (qsizetype i = 0; i < windows; ++i) {
+        double sum = 0.0;
+        for (int block = 0; block < WINDOW_BLOCKS; ++block) {
+            sum += blocks.at(i + block);
+        }
+        levels[i] = 10.0 * std::log10(qMax(sum / WINDOW_BLOCKS, 1e-12));
+        if (levels.at(i) >= m_settings.audibleDb) {
+            audible.append(levels.at(i));
+        }
+    }
+    if (audible.isEmpty()) {
+        return Result();
+    }
+
+    const qsizetype rank = qBound<qsizetype>(
+        0, static_cast<qsizetype>(m_settings.bodyPercentile * (audible.size() - 1)),
+        audible.size() - 1);
+    std::nth_element(audible.begin(), audible.begin() + rank, audible.end());
+
+    Result result;
+    result.valid = true;
+    result.bodyDb = audible.at(rank);
+    const double fullLevel = result.bodyDb - m_settings.fullLevelDropDb;
+    const double segueLevel = result.bodyDb - m_settings.segueDropDb;
+
+    qsizetype intro = -1;
+    qsizetype fade = -1;
+    qsizetype segue = -1;
+    for (qsizetype i = 0; i < windows; ++i) {
+        if (levels.at(i) >= fullLevel) {
+            intro = intro < 0 ? i : intro;
+            fade = i;
+        }
+        if (levels.at(i) >= segueLevel) {
+            segue = i;
+        }
+    }
+
+    // Points after a window are at its end; the last window may run past the audio
+    const qint64 durationMs = m_samples / m_channels * 1000 / m_sampleRate;
+    result.introMs = intro * BLOCK_MS;
+    result.fadeMs = qMin(durationMs, (fade + WINDOW_BLOCKS) * qint64(BLOCK_MS));
+    result.segueMs = qMin(durationMs, (segue + WINDOW_BLOCKS) * qint64(BLOCK_MS));
+    return result;
+}
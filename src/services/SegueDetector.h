@@ -0,0 +1,81 @@
+#ifndef SEGUEDETECTOR_H
+#define SEGUEDETECTOR_H
+
+#include <QVector>
+#include <QtGlobal>
+
+/**
+ * @brief Finds the intro, fade-out and mix-out point of a track from its energy
+ *
+ * The track is cut into blocks of BLOCK_MS and the level of every window of
+ * WINDOW_BLOCKS blocks is taken. The body level of the track is a
+ * percentile of the windows that are not near silence. From it:
+ * - the intro ends at the first window within fullLevelDropDb of the body,
+ *   so a ramp that builds up reads as a long intro
+ * - the fade-out starts after the last window within fullLevelDropDb
+ * - the segue point follows the last window within segueDropDb; after
+ *   it, what is left of the track can play under the next one
+ *
+ * A track that stops cold has its fade and segue points at its end.
+ *
+ * Samples are fed in as they are decoded; only one value per block is kept.
+ * SilenceDetector::analyzeFile() runs a SegueDetector over the same
+ * decoded audio, so finding cue and segue points costs a single decode.
+ *
+ * @since XFB 2.0
+ */
+class SegueDetector
+{
+public:
+    /**
+     * @brief Levels, relative to the track's body, that place the points
+     */
+    struct Settings {
+        double audibleDb = -50.0;      ///< Windows below this are left out of the body level
+        double bodyPercentile = 0.7;   ///< Share of audible windows at or below the body level
+        double fullLevelDropDb = 3.0;  ///< Windows this close to the body are at full level
+        double segueDropDb = 9.0;      ///< The track can be mixed out once it stays this far below
+    };
+
+    /**
+     * @brief Points found in a track, in milliseconds from the start of the file
+     */
+    struct Result {
+        bool valid = false;      ///< At least one full window was audible
+        double bodyDb = -120.0;  ///< Level of the body of the track
+        qint64 introMs = -1;     ///< End of the intro
+        qint64 fadeMs = -1;      ///< Start of the fade-out
+        qint64 segueMs = -1;     ///< Suggested mix-out point
+    };
+
+    static constexpr int BLOCK_MS = 100;
+    static constexpr int WINDOW_BLOCKS = 4;
+
+    SegueDetector(int sampleRate, int channels, const Settings& settings);
+    SegueDetector(int sampleRate, int channels);
+
+    /**
+     * @brief Scan the next part of the track
+     * @param samples Interleaved float samples
+     * @param count Number of samples, a whole number of frames
+     */
+    void feed(const float* samples, qint64 count);
+
+    /**
+     * @brief Get the points for everything fed so far
+     */
+    Result result() const;
+
+private:
+    int m_sampleRate;
+    int m_channels;
+    Settings m_settings;
+    qint64 m_blockSamples;
+
+    float m_blockSum = 0.0f;
+    qint64 m_blockFill = 0;
+    qint64 m_samples = 0;
+    QVector<float> m_blocks;   ///< Mean square of every complete block
+};
+
+#endif // SEGUEDETECTOR_H
@@ -0,0 +1,98 @@
+#include "ServerPresenceCache.h"
+#include "MusicCache.h"
+#include <QDebug>
+#include <QVariantMap>
+#include <utility>
+
+ServerPresenceCache::ServerPresenceCache(MusicCache* cache, TransferQueue* transfers,
+                                         QObject* parent)
+    : QObject(parent)
+    , m_cache(cache)
+    , m_transfers(transfers)
+{
+}
+
+ServerPresenceCache::Status ServerPresenceCache::status(const QString& fileName) const
+{
+    Status status;
+    if (!m_cache) {
+        return status;
+    }
+    const QVariantMap entry = m_cache->getMetadata(fileName, CACHE_CATEGORY).toMap();
+    if (!entry.isEmpty()) {
+        status.presence = entry.value("present").toBool() ? Presence::Present : Presence::Missing;
+        status.checked = entry.value("checked").toDateTime();
+    }
+    return status;
+}
+
+void ServerPresenceCache::refresh(const QString& fileName, Callback done)
+{
+    QList<Callback>& callbacks = m_waiting[fileName];
+    if (done) {
+        callbacks.append(std::move(done));
+    }
+    if (m_listingQueued) {
+        return;
+    }
+
+    if (!m_transfers || m_listing.program.isEmpty()) {
+        TransferQueue::Result result;
+        result.error = "no listing job";
+        onListed(result);
+        return;
+    }
+    // A listing already queued by someone else is joined, not run again
+    m_listingQueued = true;
+    m_transfers->enqueue(m_listing,
+                         [this](const TransferQueue::Result& result) { onListed(result); });
+}
+
+bool ServerPresenceCache::refreshIfStale(const QString& fileName)
+{
+    const Status current = status(fileName);
+    if (current.presence != Presence::Unknown &&
+        current.checked.secsTo(QDateTime::currentDateTime()) < m_ttlSeconds / 2) {
+        return isRefreshing(fileName);
+    }
+    refresh(fileName);
+    return true;
+}
+
+void ServerPresenceCache::record(const QString& fileName, Presence presence)
+{
+    if (!m_cache) {
+        return;
+    }
+    if (presence == Presence::Unknown) {
+        m_cache->removeMetadata(fileName, CACHE_CATEGORY);
+    } else {
+        QVariantMap entry;
+        entry.insert("present", presence == Presence::Present);
+        entry.insert("checked", QDateTime::currentDateTime());
+        m_cache->putMetadata(fileName, entry, CACHE_CATEGORY, m_ttlSeconds);
+    }
+    emit presenceChanged(fileName, presence);
+}
+
+void ServerPresenceCache::onListed(const TransferQueue::Result& result)
+{
+    m_listingQueued = false;
+    if (!result.ok) {
+        qWarning() << "ServerPresenceCache: cannot list the server:" << result.error;
+    }
+
+    // Files added by the callbacks below wait for the next listing
+    const QHash<QString, QList<Callback>> answered = std::exchange(m_waiting, {});
+    for (auto it = answered.cbegin(); it != answered.cend(); ++it) {
+        Presence presence = Presence::Unknown;
+        if (result.ok) {
+            presence = result.output.contains(it.key(), Qt::CaseInsensitive) ? Presence::Present
+                                                                             : Presence::Missing;
+            record(it.key(), presence);
+        }
+        for (const Callback& done : it.value()) {
+            done(presence, result);
+        }
+    }
+}
@@ -0,0 +1,129 @@
+#ifndef SERVERPRESENCECACHE_H
+#define SERVERPRESENCECACHE_H
+
+#include "TransferQueue.h"
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <functional>
+
+class MusicCache;
+
+/**
+ * @brief Remembers which files are on the server, checked in the background
+ *
+ * Whether a program had reached the server was only known by running the
+ * check script and waiting for its message box. The presence of each file
+ * checked is now kept in a MusicCache under the CACHE_CATEGORY metadata
+ * category for ttlSeconds(), so a context menu can show it at once,
+ * without running anything.
+ *
+ * A check runs the listing job on the TransferQueue; the listing names
+ * every file on the server, so all files waiting for a check share one
+ * run. A file is present when the listing mentions it. A listing that
+ * fails records nothing and leaves the last status cached.
+ *
+ * refreshIfStale() refreshes a status past half its lifetime, so a file
+ * looked at now and then never reaches Unknown.
+ *
+ * @example
+ * @code
+ * ServerPresenceCache* presence = new ServerPresenceCache(cache, transfers, this);
+ * presence->setListingJob(listingJob);
+ * menu.addAction(text(presence->status(fileName)));   // cached answer only
+ * presence->refreshIfStale(fileName);                // checked in the background
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class ServerPresenceCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class Presence {
+        Unknown,   ///< Never checked, or the check expired
+        Present,   ///< The last listing named the file
+        Missing    ///< The last listing did not name the file
+    };
+    Q_ENUM(Presence)
+
+    /**
+     * @brief What is known about one file
+     */
+    struct Status {
+        Presence presence = Presence::Unknown;
+        QDateTime checked;   ///< When the listing that told was read; invalid if Unknown
+    };
+
+    static constexpr const char* CACHE_CATEGORY = "serverpresence";
+    static constexpr int DEFAULT_TTL_SECONDS = 10 * 60;
+
+    /// Called once the listing that answered for the file ended
+    using Callback = std::function<void(Presence presence, const TransferQueue::Result& result)>;
+
+    /**
+     * @param cache Cache for the statuses
+     * @param transfers Queue the listing runs on
+     * @param parent Parent object
+     */
+    ServerPresenceCache(MusicCache* cache, TransferQueue* transfers, QObject* parent = nullptr);
+
+    /**
+     * @brief Set the job whose output lists the files on the server
+     */
+    void setListingJob(const TransferQueue::Job& job) { m_listing = job; }
+    const TransferQueue::Job& listingJob() const { return m_listing; }
+
+    void setTtlSeconds(int seconds) { m_ttlSeconds = qMax(1, seconds); }
+    int ttlSeconds() const { return m_ttlSeconds; }
+
+    /**
+     * @brief Get the cached status of a file; never runs a check
+     */
+    Status status(const QString& fileName) const;
+
+    /**
+     * @brief Check whether a check of the file is queued or running
+     */
+    bool isRefreshing(const QString& fileName) const { return m_waiting.contains(fileName); }
+
+    /**
+     * @brief Check a file in the background, whatever is cached
+     * @param fileName Name the listing shows
+     * @param done Called with the new presence, Unknown if the listing failed; may be empty
+     */
+    void refresh(const QString& fileName, Callback done = Callback());
+
+    /**
+     * @brief Check a file in the background unless its status is under half its lifetime old
+     * @return true if a check was queued or already waiting
+     */
+    bool refreshIfStale(const QString& fileName);
+
+    /**
+     * @brief Record a presence learned some other way
+     */
+    void record(const QString& fileName, Presence presence);
+
+signals:
+    /**
+     * @brief Emitted when a check recorded the presence of a file
+     */
+    void presenceChanged(const QString& fileName, ServerPresenceCache::Presence presence);
+
+private:
+    void onListed(const TransferQueue::Result& result);
+
+    QPointer<MusicCache> m_cache;
+    QPointer<TransferQueue> m_transfers;
+    TransferQueue::Job m_listing;
+    int m_ttlSeconds = DEFAULT_TTL_SECONDS;
+    QHash<QString, QList<Callback>> m_waiting;   ///< Files the next listing answers for
+    bool m_listingQueued = false;
+};
+
+#endif // SERVERPRESENCECACHE_H
@@ -1,6 +1,7 @@
 #include "ServiceContainer.h"
 #include <QDebug>
 #include <QCoreApplication>
+#include <utility>
 
 ServiceContainer* ServiceContainer::s_instance = nullptr;
 QMutex ServiceContainer::s_instanceMutex;
@@ -13,6 +14,7 @@ ServiceContainer::ServiceContainer(QObject* parent)
 
 ServiceContainer::~ServiceContainer()
 {
+    m_initPool.waitForDone();
     shutdownServices();
     clear();
 }
@@ -35,21 +37,37 @@ void ServiceContainer::destroyInstance()
     }
 }
 
-void ServiceContainer::registerService(const QString& serviceName, ServiceLifetime lifetime, ServiceFactory factory)
+int ServiceContainer::nextServiceSlot()
+{
+    static std::atomic<int> next{0};
+    return next.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ServiceContainer::registerService(int slot, const QString& serviceName,
+                                       ServiceLifetime lifetime, ServiceFactory factory)
 {
     QMutexLocker locker(&m_mutex);
     
-    if (m_services.contains(serviceName)) {
+    if (slot < 0 || slot >= MAX_SERVICE_TYPES) {
+        qCritical() << "Too many service types, not registered:" << serviceName;
+        return;
+    }
+
+    if (m_services.contains(slot)) {
         qWarning() << "Service already registered:" << serviceName;
         return;
     }
 
     ServiceRegistration registration;
+    registration.name = serviceName;
     registration.lifetime = lifetime;
     registration.factory = factory;
     
-    m_services.insert(serviceName, registration);
-    m_initializationOrder.append(serviceName);
+    if (m_names[slot].isEmpty()) {
+        m_names[slot] = serviceName;
+    }
+    m_services.insert(slot, registration);
+    m_initializationOrder.append(slot);
     
     emit serviceRegistered(serviceName);
     
@@ -57,23 +75,32 @@ void ServiceContainer::registerService(const QString& serviceName, ServiceLifeti
              << "with lifetime:" << (lifetime == ServiceLifetime::Singleton ? "Singleton" : "Transient");
 }
 
-IService* ServiceContainer::resolveService(const QString& serviceName)
+IService* ServiceContainer::createSingleton(int slot, ServiceRegistration& registration)
+{
+    IService* service = registration.factory(this);
+    if (!service) {
+        return nullptr;
+    }
+    registration.singletonInstance = QSharedPointer<IService>(service);
+    m_published[slot].store(service, std::memory_order_release);
+    return service;
+}
+
+IService* ServiceContainer::resolveService(int slot, const QString& serviceName)
 {
     QMutexLocker locker(&m_mutex);
     
-    if (!m_services.contains(serviceName)) {
+    if (!m_services.contains(slot)) {
         qWarning() << "Service not registered:" << serviceName;
         return nullptr;
     }
 
-    ServiceRegistration& registration = m_services[serviceName];
+    ServiceRegistration& registration = m_services[slot];
     
     if (registration.lifetime == ServiceLifetime::Singleton) {
         if (!registration.singletonInstance) {
             // Create singleton instance
-            IService* service = registration.factory(this);
-            if (service) {
-                registration.singletonInstance = QSharedPointer<IService>(service);
+            if (createSingleton(slot, registration)) {
                 qDebug() << "Created singleton instance for service:" << serviceName;
             } else {
                 qCritical() << "Failed to create service instance:" << serviceName;
@@ -96,79 +123,262 @@ IService* ServiceContainer::resolveService(const QString& serviceName)
     }
 }
 
-bool ServiceContainer::isServiceRegistered(const QString& serviceName) const
+bool ServiceContainer::isServiceRegistered(int slot) const
 {
     QMutexLocker locker(&m_mutex);
-    return m_services.contains(serviceName);
+    return m_services.contains(slot);
+}
+
+void ServiceContainer::setDependencies(int slot, const QList<int>& dependencies)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_services.contains(slot)) {
+        qWarning() << "Service not registered, dependencies ignored:" << m_names[slot];
+        return;
+    }
+    m_services[slot].dependencies = dependencies;
+}
+
+void ServiceContainer::setConcurrent(int slot)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_services.contains(slot)) {
+        qWarning() << "Service not registered:" << m_names[slot];
+        return;
+    }
+    m_services[slot].concurrent = true;
 }
 
 bool ServiceContainer::initializeServices()
 {
     QMutexLocker locker(&m_mutex);
-    
-    qDebug() << "Initializing" << m_services.size() << "services...";
-    
+    const QList<int> targets = m_initializationOrder;
+    locker.unlock();
+    return runInitialization(targets);
+}
+
+bool ServiceContainer::runInitialization(const QList<int>& targets)
+{
+    const QSet<int> wanted = dependencyClosure(targets);
+    qDebug() << "Initializing" << wanted.size() << "services...";
+
+    for (;;) {
+        takeFinished();
+        scheduleReady(wanted);
+        if (isSettled(wanted)) {
+            break;
+        }
+        if (failStuck(wanted)) {
+            continue;
+        }
+
+        // Wait for the pool to finish one of them
+        QMutexLocker locker(&m_finishedMutex);
+        if (m_finished.isEmpty()) {
+            m_finishedChanged.wait(&m_finishedMutex);
+        }
+    }
+
     bool allSuccessful = true;
-    
-    // Initialize services in registration order
-    for (const QString& serviceName : m_initializationOrder) {
-        if (!m_services.contains(serviceName)) {
-            continue; // Service might have been removed
+    for (int slot : wanted) {
+        allSuccessful = allSuccessful && !m_failedRequired.contains(slot);
+    }
+    qDebug() << "Service initialization completed. Success:" << allSuccessful;
+    return allSuccessful;
+}
+
+void ServiceContainer::startInitialization(const QList<int>& targets)
+{
+    m_backgroundTargets.unite(dependencyClosure(targets));
+    QMetaObject::invokeMethod(this, &ServiceContainer::takeFinished, Qt::QueuedConnection);
+}
+
+QSet<int> ServiceContainer::dependencyClosure(const QList<int>& targets) const
+{
+    QMutexLocker locker(&m_mutex);
+
+    // Transient services are initialized when resolved, and dependencies that
+    // were never registered are taken as met
+    QSet<int> closure;
+    QList<int> pending = targets;
+    while (!pending.isEmpty()) {
+        const int slot = pending.takeLast();
+        const auto it = m_services.constFind(slot);
+        if (closure.contains(slot) || it == m_services.constEnd()
+            || it->lifetime != ServiceLifetime::Singleton) {
+            continue;
         }
-        
-        ServiceRegistration& registration = m_services[serviceName];
-        
-        // For singletons, create and initialize the instance
-        if (registration.lifetime == ServiceLifetime::Singleton) {
-            if (!registration.singletonInstance) {
-                IService* service = registration.factory(this);
-                if (service) {
-                    registration.singletonInstance = QSharedPointer<IService>(service);
-                } else {
-                    qCritical() << "Failed to create service:" << serviceName;
-                    emit serviceInitializationFailed(serviceName, "Failed to create service instance");
-                    allSuccessful = false;
+        closure.insert(slot);
+        pending.append(it->dependencies);
+    }
+    return closure;
+}
+
+void ServiceContainer::scheduleReady(const QSet<int>& wanted)
+{
+    for (;;) {
+        int slot = -1;
+        IService* service = nullptr;
+        bool concurrent = false;
+        QString error;
+
+        // Take the first pending service, in registration order, whose
+        // dependencies are done or one of which has failed
+        {
+            QMutexLocker locker(&m_mutex);
+            for (int candidate : m_initializationOrder) {
+                if (!wanted.contains(candidate)
+                    || m_initStates.value(candidate) != InitState::Pending) {
                     continue;
                 }
-            }
-            
-            IService* service = registration.singletonInstance.data();
-            if (service && service->state() == IService::ServiceState::Uninitialized) {
-                qDebug() << "Initializing service:" << serviceName;
-                
-                try {
-                    if (!service->initialize()) {
-                        qWarning() << "Service initialization failed:" << serviceName << "- continuing with other services";
-                        emit serviceInitializationFailed(serviceName, "Service initialization returned false");
-                        // Don't set allSuccessful = false for optional services like AudioService
-                        if (serviceName != "AudioService") {
-                            allSuccessful = false;
-                        }
-                    } else {
-                        qDebug() << "Successfully initialized service:" << serviceName;
+                ServiceRegistration& registration = m_services[candidate];
+                bool ready = true;
+                for (int dependency : registration.dependencies) {
+                    if (!wanted.contains(dependency)) {
+                        continue;
                     }
-                } catch (const std::exception& e) {
-                    qWarning() << "Exception during service initialization:" << serviceName << "-" << e.what();
-                    emit serviceInitializationFailed(serviceName, QString("Exception: %1").arg(e.what()));
-                    // Don't fail completely for optional services
-                    if (serviceName != "AudioService") {
-                        allSuccessful = false;
+                    const InitState state = m_initStates.value(dependency);
+                    if (state == InitState::Failed) {
+                        error = QString("Dependency failed: %1").arg(m_names[dependency]);
+                        break;
                     }
-                } catch (...) {
-                    qWarning() << "Unknown exception during service initialization:" << serviceName;
-                    emit serviceInitializationFailed(serviceName, "Unknown exception occurred");
-                    // Don't fail completely for optional services
-                    if (serviceName != "AudioService") {
-                        allSuccessful = false;
+                    ready = ready && state == InitState::Done;
+                }
+                if (!ready && error.isEmpty()) {
+                    continue;
+                }
+
+                slot = candidate;
+                if (error.isEmpty()) {
+                    service = registration.singletonInstance
+                                  ? registration.singletonInstance.data()
+                                  : createSingleton(candidate, registration);
+                    concurrent = registration.concurrent;
+                    if (!service) {
+                        error = "Failed to create service instance";
                     }
                 }
+                break;
             }
         }
-        // Transient services are initialized when resolved
+
+        if (slot < 0) {
+            return;
+        }
+        if (!error.isEmpty() || service->state() != IService::ServiceState::Uninitialized) {
+            finishInitialization(slot, error);
+            continue;
+        }
+
+        qDebug() << "Initializing service:" << m_names[slot]
+                 << (concurrent ? "on a worker thread" : "");
+        m_initStates[slot] = InitState::Running;
+        if (!concurrent) {
+            finishInitialization(slot, initializeService(service));
+            continue;
+        }
+        m_initPool.start([this, slot, service]() {
+            const QString result = initializeService(service);
+            QMutexLocker locker(&m_finishedMutex);
+            m_finished.append({slot, result});
+            m_finishedChanged.wakeAll();
+            QMetaObject::invokeMethod(this, &ServiceContainer::takeFinished,
+                                      Qt::QueuedConnection);
+        });
+    }
+}
+
+void ServiceContainer::finishInitialization(int slot, const QString& error)
+{
+    const QString& serviceName = m_names[slot];
+    if (error.isEmpty()) {
+        m_initStates[slot] = InitState::Done;
+        qDebug() << "Successfully initialized service:" << serviceName;
+        return;
+    }
+
+    m_initStates[slot] = InitState::Failed;
+    qWarning() << "Service initialization failed:" << serviceName << "-" << error
+               << "- continuing with other services";
+    emit serviceInitializationFailed(serviceName, error);
+    // Don't fail completely for optional services like AudioService
+    if (serviceName != "AudioService") {
+        m_failedRequired.insert(slot);
+    }
+}
+
+void ServiceContainer::takeFinished()
+{
+    QList<InitResult> finished;
+    {
+        QMutexLocker locker(&m_finishedMutex);
+        finished.swap(m_finished);
+    }
+    for (const InitResult& result : finished) {
+        finishInitialization(result.slot, result.error);
+    }
+
+    if (m_backgroundTargets.isEmpty()) {
+        return;
+    }
+    scheduleReady(m_backgroundTargets);
+    while (failStuck(m_backgroundTargets)) {
+        scheduleReady(m_backgroundTargets);
+    }
+    if (!isSettled(m_backgroundTargets)) {
+        return;
+    }
+
+    bool allSuccessful = true;
+    for (int slot : std::as_const(m_backgroundTargets)) {
+        allSuccessful = allSuccessful && !m_failedRequired.contains(slot);
+    }
+    m_backgroundTargets.clear();
+    qDebug() << "Background service initialization completed. Success:" << allSuccessful;
+    emit servicesInitialized(allSuccessful);
+}
+
+bool ServiceContainer::failStuck(const QSet<int>& wanted)
+{
+    QList<int> stuck;
+    for (int slot : wanted) {
+        const InitState state = m_initStates.value(slot);
+        if (state == InitState::Running) {
+            return false;
+        }
+        if (state == InitState::Pending) {
+            stuck.append(slot);
+        }
+    }
+    for (int slot : stuck) {
+        finishInitialization(slot, "Dependency cycle");
+    }
+    return !stuck.isEmpty();
+}
+
+bool ServiceContainer::isSettled(const QSet<int>& wanted) const
+{
+    for (int slot : wanted) {
+        const InitState state = m_initStates.value(slot);
+        if (state != InitState::Done && state != InitState::Failed) {
+            return false;
+        }
+    }
+    return true;
+}
+
+QString ServiceContainer::initializeService(IService* service)
+{
+    try {
+        if (!service->initialize()) {
+            return "Service initialization returned false";
+        }
+        return QString();
+    } catch (const std::exception& e) {
+        return QString("Exception: %1").arg(e.what());
+    } catch (...) {
+        return "Unknown exception occurred";
     }
-    
-    qDebug() << "Service initialization completed. Success:" << allSuccessful;
-    return allSuccessful;
 }
 
 void ServiceContainer::shutdownServices()
@@ -179,16 +389,14 @@ void ServiceContainer::shutdownServices()
     
     // Shutdown services in reverse order
     for (auto it = m_initializationOrder.rbegin(); it != m_initializationOrder.rend(); ++it) {
-        const QString& serviceName = *it;
-        
-        if (!m_services.contains(serviceName)) {
+        if (!m_services.contains(*it)) {
             continue;
         }
         
-        ServiceRegistration& registration = m_services[serviceName];
+        ServiceRegistration& registration = m_services[*it];
         
         if (registration.singletonInstance && registration.singletonInstance->isRunning()) {
-            qDebug() << "Shutting down service:" << serviceName;
+            qDebug() << "Shutting down service:" << registration.name;
             registration.singletonInstance->shutdown();
         }
     }
@@ -198,10 +406,25 @@ void ServiceContainer::shutdownServices()
 
 void ServiceContainer::clear()
 {
+    // Nothing may still be initializing an instance about to be deleted
+    m_initPool.waitForDone();
+
     QMutexLocker locker(&m_mutex);
     
     qDebug() << "Clearing service container...";
     
+    {
+        QMutexLocker finishedLocker(&m_finishedMutex);
+        m_finished.clear();
+    }
+    m_initStates.clear();
+    m_failedRequired.clear();
+    m_backgroundTargets.clear();
+    
+    // Unpublish before the instances go, so resolve() falls back to the lock
+    for (int slot : m_initializationOrder) {
+        m_published[slot].store(nullptr, std::memory_order_release);
+    }
     m_services.clear();
     m_initializationOrder.clear();
     
@@ -4,10 +4,16 @@
 #include "IService.h"
 #include <QObject>
 #include <QHash>
+#include <QList>
 #include <QString>
 #include <QSharedPointer>
 #include <QMutex>
 #include <QMutexLocker>
+#include <QSet>
+#include <QThreadPool>
+#include <QWaitCondition>
+#include <array>
+#include <atomic>
 #include <functional>
 #include <typeinfo>
 #include <memory>
@@ -19,6 +25,19 @@
  * service dependencies throughout the XFB application. It supports both singleton
  * and transient service lifetimes.
  * 
+ * Each service type gets a slot index the first time the container sees it, held in
+ * a function-local static of the type's resolve() instantiation, so no type name is
+ * hashed after that. A singleton is published in its slot through an atomic once it
+ * has been created; resolving it from then on is a single load, without the lock.
+ * Registration, transient services and singletons not yet created take the lock.
+ * 
+ * Singletons are initialized in the order of the dependencies declared with
+ * dependsOn(), and in registration order where there are none. Services whose
+ * initialize() may run off the main thread are marked with initializeConcurrently();
+ * they run on a thread pool while the main thread goes on with the others. Startup
+ * waits with initializeServicesFor() only for what the first window needs and hands
+ * the rest to initializeServicesInBackground().
+ * 
  * @example
  * @code
  * ServiceContainer* container = ServiceContainer::instance();
@@ -55,6 +74,11 @@ public:
      */
     using ServiceFactory = std::function<IService*(ServiceContainer*)>;
 
+    /**
+     * @brief Most service types a process can register
+     */
+    static constexpr int MAX_SERVICE_TYPES = 128;
+
     /**
      * @brief Get the global service container instance
      * @return Pointer to the singleton ServiceContainer instance
@@ -74,7 +98,8 @@ public:
     template<typename T>
     void registerSingleton(ServiceFactory factory = nullptr) {
         static_assert(std::is_base_of_v<IService, T>, "T must inherit from IService");
-        registerService(typeid(T).name(), ServiceLifetime::Singleton, factory ? factory : defaultFactory<T>());
+        registerService(serviceSlot<T>(), typeid(T).name(), ServiceLifetime::Singleton,
+                        factory ? factory : defaultFactory<T>());
     }
 
     /**
@@ -85,7 +110,8 @@ public:
     template<typename T>
     void registerTransient(ServiceFactory factory = nullptr) {
         static_assert(std::is_base_of_v<IService, T>, "T must inherit from IService");
-        registerService(typeid(T).name(), ServiceLifetime::Transient, factory ? factory : defaultFactory<T>());
+        registerService(serviceSlot<T>(), typeid(T).name(), ServiceLifetime::Transient,
+                        factory ? factory : defaultFactory<T>());
     }
 
     /**
@@ -96,7 +122,12 @@ public:
     template<typename T>
     T* resolve() {
         static_assert(std::is_base_of_v<IService, T>, "T must inherit from IService");
-        return static_cast<T*>(resolveService(typeid(T).name()));
+        const int slot = serviceSlot<T>();
+        if (IService* service = publishedService(slot)) {
+            emit serviceResolved(m_names[slot]);
+            return static_cast<T*>(service);
+        }
+        return static_cast<T*>(resolveService(slot, typeid(T).name()));
     }
 
     /**
@@ -107,15 +138,64 @@ public:
     template<typename T>
     bool isRegistered() const {
         static_assert(std::is_base_of_v<IService, T>, "T must inherit from IService");
-        return isServiceRegistered(typeid(T).name());
+        return isServiceRegistered(serviceSlot<T>());
+    }
+
+    /**
+     * @brief Declare that a service is initialized after others
+     * @tparam T Registered service type
+     * @tparam Dependencies Service types T needs to be running first
+     */
+    template<typename T, typename... Dependencies>
+    void dependsOn() {
+        static_assert(std::is_base_of_v<IService, T>, "T must inherit from IService");
+        setDependencies(serviceSlot<T>(), {serviceSlot<Dependencies>()...});
+    }
+
+    /**
+     * @brief Let a service be initialized on a worker thread
+     *
+     * Only for services whose initialize() touches nothing tied to the main
+     * thread, such as widgets, timers of their own or the main database connection.
+     * @tparam T Registered service type
+     */
+    template<typename T>
+    void initializeConcurrently() {
+        static_assert(std::is_base_of_v<IService, T>, "T must inherit from IService");
+        setConcurrent(serviceSlot<T>());
     }
 
     /**
      * @brief Initialize all registered services
+     *
+     * Returns once every singleton has been initialized or has failed.
+     * Call from the container's thread.
      * @return true if all services initialized successfully
      */
     bool initializeServices();
 
+    /**
+     * @brief Initialize some services and what they depend on, and wait for them
+     * @tparam T Service types to initialize
+     * @return true if they all initialized successfully
+     */
+    template<typename... T>
+    bool initializeServicesFor() {
+        return runInitialization({serviceSlot<T>()...});
+    }
+
+    /**
+     * @brief Initialize services and what they depend on without waiting
+     *
+     * Services that must run on the main thread are initialized from its
+     * event loop; servicesInitialized() is emitted when all are done.
+     * @tparam T Service types to initialize
+     */
+    template<typename... T>
+    void initializeServicesInBackground() {
+        startInitialization({serviceSlot<T>()...});
+    }
+
     /**
      * @brief Shutdown all services gracefully
      */
@@ -152,6 +232,12 @@ signals:
      */
     void serviceInitializationFailed(const QString& serviceName, const QString& error);
 
+    /**
+     * @brief Emitted when initializeServicesInBackground() is done
+     * @param success true if every service it started initialized successfully
+     */
+    void servicesInitialized(bool success);
+
 private:
     explicit ServiceContainer(QObject* parent = nullptr);
     ~ServiceContainer() override;
@@ -160,32 +246,142 @@ private:
      * @brief Service registration information
      */
     struct ServiceRegistration {
+        QString name;
         ServiceLifetime lifetime;
         ServiceFactory factory;
         QSharedPointer<IService> singletonInstance;
+        QList<int> dependencies;   ///< Slots initialized first
+        bool concurrent = false;   ///< initialize() may run on the pool
+    };
+
+    /**
+     * @brief Progress of a singleton through an initialization run
+     */
+    enum class InitState {
+        Pending,
+        Running,
+        Done,
+        Failed
     };
 
+    /**
+     * @brief Outcome of one initialize() on the pool
+     */
+    struct InitResult {
+        int slot = -1;
+        QString error;   ///< Empty on success
+    };
+
+    /**
+     * @brief Get the slot index of a service type
+     * @tparam T Service type
+     * @return Index assigned on the first call for T, the same for the life of the process
+     */
+    template<typename T>
+    static int serviceSlot() {
+        static const int slot = nextServiceSlot();
+        return slot;
+    }
+
+    /**
+     * @brief Hand out the next free slot index
+     */
+    static int nextServiceSlot();
+
+    /**
+     * @brief Get a published singleton without taking the lock
+     * @param slot Slot of the service type
+     * @return The singleton, or nullptr if it is not created or not a singleton
+     */
+    IService* publishedService(int slot) const {
+        return slot >= 0 && slot < MAX_SERVICE_TYPES
+                   ? m_published[slot].load(std::memory_order_acquire)
+                   : nullptr;
+    }
+
     /**
      * @brief Register a service with the container
-     * @param serviceName Unique service name (typically from typeid)
+     * @param slot Slot of the service type
+     * @param serviceName Service name for signals and logs (typically from typeid)
      * @param lifetime Service lifetime
      * @param factory Factory function for creating the service
      */
-    void registerService(const QString& serviceName, ServiceLifetime lifetime, ServiceFactory factory);
+    void registerService(int slot, const QString& serviceName, ServiceLifetime lifetime,
+                         ServiceFactory factory);
 
     /**
-     * @brief Resolve a service by name
-     * @param serviceName Service name to resolve
+     * @brief Resolve a service that is not published, under the lock
+     * @param slot Slot of the service type
+     * @param serviceName Service name for logs
      * @return Pointer to the service instance
      */
-    IService* resolveService(const QString& serviceName);
+    IService* resolveService(int slot, const QString& serviceName);
 
     /**
-     * @brief Check if a service is registered by name
-     * @param serviceName Service name to check
+     * @brief Check if a service is registered
+     * @param slot Slot of the service type
      * @return true if registered
      */
-    bool isServiceRegistered(const QString& serviceName) const;
+    bool isServiceRegistered(int slot) const;
+
+    void setDependencies(int slot, const QList<int>& dependencies);
+    void setConcurrent(int slot);
+
+    /**
+     * @brief Initialize the singletons among some slots, and their dependencies, and wait
+     * @return true if they all initialized successfully
+     */
+    bool runInitialization(const QList<int>& targets);
+
+    /**
+     * @brief Initialize like runInitialization() without waiting
+     */
+    void startInitialization(const QList<int>& targets);
+
+    /**
+     * @brief Get the singleton slots among some slots and everything they depend on
+     */
+    QSet<int> dependencyClosure(const QList<int>& targets) const;
+
+    /**
+     * @brief Start every wanted service whose dependencies are done
+     *
+     * Services for the main thread are initialized before this returns.
+     */
+    void scheduleReady(const QSet<int>& wanted);
+
+    /**
+     * @brief Record the outcome of an initialization; main thread only
+     */
+    void finishInitialization(int slot, const QString& error);
+
+    /**
+     * @brief Record what the pool has finished, and go on with a background run
+     */
+    void takeFinished();
+
+    /**
+     * @brief Fail wanted services that can never start, because of a dependency cycle
+     * @return true if any were failed
+     */
+    bool failStuck(const QSet<int>& wanted);
+
+    /**
+     * @brief Whether every wanted service has initialized or failed
+     */
+    bool isSettled(const QSet<int>& wanted) const;
+
+    /**
+     * @brief Run initialize() on any thread
+     * @return Empty on success, otherwise the error
+     */
+    static QString initializeService(IService* service);
+
+    /**
+     * @brief Create a singleton and publish it in its slot; called with the lock held
+     * @return The singleton, or nullptr if the factory failed
+     */
+    IService* createSingleton(int slot, ServiceRegistration& registration);
 
     /**
      * @brief Create default factory function for a service type
@@ -203,8 +399,22 @@ private:
     static QMutex s_instanceMutex;
 
     mutable QMutex m_mutex;
-    QHash<QString, ServiceRegistration> m_services;
-    QList<QString> m_initializationOrder;
+    QHash<int, ServiceRegistration> m_services;   ///< By slot
+    QList<int> m_initializationOrder;
+
+    // Singletons by slot, and the names of their types; a name is written once,
+    // under the lock, before anything is published in its slot
+    std::array<std::atomic<IService*>, MAX_SERVICE_TYPES> m_published{};
+    std::array<QString, MAX_SERVICE_TYPES> m_names;
+
+    // Initialization runs; the container's thread only, except the finished list
+    QThreadPool m_initPool;
+    QHash<int, InitState> m_initStates;
+    QSet<int> m_failedRequired;          ///< Failures that make a run unsuccessful
+    QSet<int> m_backgroundTargets;
+    QMutex m_finishedMutex;
+    QWaitCondition m_finishedChanged;
+    QList<InitResult> m_finished;        ///< Guarded by m_finishedMutex
 };
 
 #endif // SERVICECONTAINER_H
\ No newline at end of file
@@ -0,0 +1,166 @@
+#include "ShutdownCoordinator.h"
+#include <QDebug>
+#include <QProcess>
+#include <QTimer>
+
+ShutdownCoordinator::ShutdownCoordinator(ProcessSupervisor* supervisor, QObject* parent)
+    : QObject(parent)
+    , m_supervisor(supervisor)
+{
+    connect(m_supervisor, &ProcessSupervisor::stateChanged, this, &ShutdownCoordinator::onStateChanged);
+    connect(m_supervisor, &ProcessSupervisor::forceKilled, this, &ShutdownCoordinator::onForceKilled);
+}
+
+void ShutdownCoordinator::stop(const QStringList& names, Callback callback)
+{
+    Batch* batch = new Batch;
+    batch->callback = std::move(callback);
+    batch->clock.start();
+    for (const QString& name : names) {
+        if (m_supervisor->hasProcess(name)) {
+            batch->waiting.insert(name);
+        }
+    }
+    m_batches.append(batch);
+
+    batch->deadline = new QTimer(this);
+    batch->deadline->setSingleShot(true);
+    connect(batch->deadline, &QTimer::timeout, this, [this, batch]() {
+        batch->report.unresponsive = batch->waiting.values();
+        batch->waiting.clear();
+        logError("stop", QString("Still running after %1 ms: %2")
+                             .arg(deadline())
+                             .arg(batch->report.unresponsive.join(", ")));
+        complete(batch);
+    });
+    batch->deadline->start(deadline());
+
+    // Every stop is asked for before any is waited on. A process that is
+    // not running reports Stopped from inside stop(), or already was
+    const QStringList waiting = batch->waiting.values();
+    m_issuing = batch;
+    for (const QString& name : waiting) {
+        m_supervisor->stop(name);
+    }
+    m_issuing = nullptr;
+    for (const QString& name : waiting) {
+        if (m_supervisor->state(name) == ProcessSupervisor::State::Stopped && batch->waiting.remove(name)) {
+            batch->report.stopped.append(name);
+        }
+    }
+    if (batch->waiting.isEmpty()) {
+        complete(batch);
+    }
+}
+
+void ShutdownCoordinator::killByName(const QString& processName, KillCallback callback)
+{
+    QString program;
+    QStringList arguments;
+#ifdef Q_OS_WIN
+    program = "taskkill";
+    arguments << "/F"
+              << "/IM" << processName + "*";
+#else
+    program = "pkill";
+    arguments << "-f" << processName; // -f matches against the entire command line
+#endif
+
+    qInfo() << "ShutdownCoordinator: killing processes matching" << processName << "with" << program
+            << arguments;
+
+    QProcess* killer = new QProcess(this);
+    QTimer* timeout = new QTimer(killer);
+    timeout->setSingleShot(true);
+
+    // Whichever of finished, failed start and timeout comes first reports
+    auto finish = [this, killer, processName, callback](bool success, const QString& error) {
+        killer->disconnect(this);
+        if (!error.isEmpty()) {
+            logError("killByName", QString("%1: %2").arg(processName, error));
+        }
+        if (killer->state() == QProcess::NotRunning) {
+            killer->deleteLater();
+        } else {
+            connect(killer, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), killer,
+                    &QObject::deleteLater);
+            killer->kill();
+        }
+        if (callback) {
+            callback(success);
+        }
+    };
+
+    connect(killer, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
+            [finish](int exitCode, QProcess::ExitStatus exitStatus) {
+                // pkill exits with 1 when nothing matched; that is not an error
+                finish(exitStatus == QProcess::NormalExit && exitCode == 0, QString());
+            });
+    connect(killer, &QProcess::errorOccurred, this, [killer, finish](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart) {
+            finish(false, killer->errorString());
+        }
+    });
+    connect(timeout, &QTimer::timeout, this, [finish]() {
+        finish(false, QString("No answer after %1 ms").arg(KILL_COMMAND_TIMEOUT_MS));
+    });
+
+    timeout->start(KILL_COMMAND_TIMEOUT_MS);
+    killer->start(program, arguments);
+}
+
+void ShutdownCoordinator::onStateChanged(const QString& name, ProcessSupervisor::State state)
+{
+    if (state != ProcessSupervisor::State::Stopped) {
+        return;
+    }
+
+    // A callback may start another stop(), so completed batches are
+    // collected before any is reported
+    QList<Batch*> done;
+    for (Batch* batch : std::as_const(m_batches)) {
+        if (batch->waiting.remove(name)) {
+            batch->report.stopped.append(name);
+            if (batch->waiting.isEmpty() && batch != m_issuing) {
+                done.append(batch);
+            }
+        }
+    }
+    for (Batch* batch : done) {
+        if (m_batches.contains(batch)) {
+            complete(batch);
+        }
+    }
+}
+
+void ShutdownCoordinator::onForceKilled(const QString& name)
+{
+    for (Batch* batch : std::as_const(m_batches)) {
+        if (batch->waiting.contains(name) && !batch->report.forced.contains(name)) {
+            batch->report.forced.append(name);
+        }
+    }
+}
+
+void ShutdownCoordinator::complete(Batch* batch)
+{
+    m_batches.removeAll(batch);
+    batch->deadline->stop();
+    batch->deadline->deleteLater();
+    batch->report.elapsedMs = batch->clock.elapsed();
+
+    const Report report = batch->report;
+    const Callback callback = std::move(batch->callback);
+    delete batch;
+
+    qDebug() << "ShutdownCoordinator: stopped" << report.stopped << "in" << report.elapsedMs << "ms";
+    if (callback) {
+        callback(report);
+    }
+    emit finished(report);
+}
+
+void ShutdownCoordinator::logError(const QString& operation, const QString& error)
+{
+    qWarning() << QString("ShutdownCoordinator::%1 - %2").arg(operation, error);
+}
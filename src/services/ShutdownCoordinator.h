@@ -0,0 +1,123 @@
+#ifndef SHUTDOWNCOORDINATOR_H
+#define SHUTDOWNCOORDINATOR_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <functional>
+
+#include "ProcessSupervisor.h"
+
+class QProcess;
+class QTimer;
+
+/**
+ * @brief Stops helper processes in parallel and reports when they are gone
+ *
+ * Stopping the stream used to run pkill, and taskkill on Windows, for
+ * each helper and wait up to 3 s for each one, on the GUI thread. That
+ * froze the window for over six seconds whenever a helper was slow to
+ * leave. The coordinator asks the ProcessSupervisor to stop every named
+ * process at once. The supervisor signals each child's process group by
+ * ID. The coordinator then waits, without blocking, until all of them
+ * have reached Stopped, and reports which ones had to be killed.
+ *
+ * killByName() does the same for stray instances that were not started
+ * by the supervisor, such as those left over from an earlier run. It
+ * runs pkill or taskkill as an asynchronous child and calls back when
+ * that is done.
+ *
+ * @example
+ * @code
+ * ShutdownCoordinator* shutdown = new ShutdownCoordinator(supervisor, this);
+ * shutdown->stop({"icecast", "butt"}, [](const ShutdownCoordinator::Report& report) {
+ *     qDebug() << report.stopped << "stopped in" << report.elapsedMs << "ms";
+ * });
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class ShutdownCoordinator : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief How a stop() went
+     */
+    struct Report {
+        QStringList stopped;       ///< Processes that reached Stopped
+        QStringList forced;        ///< Of those, the ones that had to be killed
+        QStringList unresponsive;  ///< Still not stopped when the deadline passed
+        qint64 elapsedMs = 0;
+    };
+
+    using Callback = std::function<void(const Report& report)>;
+    using KillCallback = std::function<void(bool success)>;
+
+    /// Time a kill-by-name command gets before it is given up on
+    static constexpr int KILL_COMMAND_TIMEOUT_MS = 3000;
+    /// Time a process gets after being killed before it is reported unresponsive
+    static constexpr int KILL_SETTLE_MS = 2000;
+
+    explicit ShutdownCoordinator(ProcessSupervisor* supervisor, QObject* parent = nullptr);
+
+    /**
+     * @brief Stop supervised processes, all at once
+     *
+     * Returns at once. Processes that are already stopped count as stopped;
+     * unknown names are ignored.
+     * @param names Names the processes are registered under
+     * @param callback Called once every process stopped or the deadline passed
+     */
+    void stop(const QStringList& names, Callback callback = nullptr);
+
+    /**
+     * @brief Check if a stop() is still waiting for processes
+     * @return true while any stop() has not reported yet
+     */
+    bool isStopping() const { return !m_batches.isEmpty(); }
+
+    /**
+     * @brief Kill processes that match a name and were not started by the supervisor
+     * @param processName Name matched against the command lines of running processes
+     * @param callback Called with true if the command ran and matched something
+     */
+    void killByName(const QString& processName, KillCallback callback = nullptr);
+
+    /**
+     * @brief Get the time a stop() waits before it gives up on a process
+     * @return The supervisor's grace period plus KILL_SETTLE_MS
+     */
+    int deadline() const { return m_supervisor->stopGracePeriod() + KILL_SETTLE_MS; }
+
+signals:
+    /**
+     * @brief Emitted when a stop() has its report
+     * @param report What happened
+     */
+    void finished(const ShutdownCoordinator::Report& report);
+
+private:
+    struct Batch {
+        QSet<QString> waiting;
+        Report report;
+        QElapsedTimer clock;
+        Callback callback;
+        QTimer* deadline = nullptr;
+    };
+
+    void onStateChanged(const QString& name, ProcessSupervisor::State state);
+    void onForceKilled(const QString& name);
+    void complete(Batch* batch);
+    void logError(const QString& operation, const QString& error);
+
+    ProcessSupervisor* m_supervisor;
+    QList<Batch*> m_batches;
+    Batch* m_issuing = nullptr;  ///< Batch whose stops are being asked for right now
+};
+
+#endif // SHUTDOWNCOORDINATOR_H
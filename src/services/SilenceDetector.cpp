@@ -0,0 +1,162 @@
+#include "SilenceDetector.h"
+#include "SegueDetector.h"
+#include <cmath>
+#include <memory>
+
+namespace {
+
+float linearLevel(double db)
+{
+    return static_cast<float>(std::pow(10.0, db / 20.0));
+}
+
+} // namespace
+
+SilenceDetector::SilenceDetector(int sampleRate, int channels, const Settings& settings)
+    : m_sampleRate(qMax(1, sampleRate))
+    , m_channels(qMax(1, channels))
+    , m_settings(settings)
+    , m_rmsThreshold(linearLevel(settings.rmsThresholdDb))
+    , m_peakThreshold(linearLevel(settings.peakThresholdDb))
+    , m_windowSamples(qMax<qint64>(1, qint64(settings.windowMs) * m_sampleRate / 1000) * m_channels)
+{
+}
+
+SilenceDetector::SilenceDetector(int sampleRate, int channels)
+    : SilenceDetector(sampleRate, channels, Settings())
+{
+}
+
+void SilenceDetector::feed(const float* samples, qint64 count)
+{
+    m_samples += qMax<qint64>(0, count);
+    while (count > 0) {
+        const qint64 take = qMin(count, m_windowSamples - m_windowFill);
+        accumulate(samples, take, m_windowSum, m_windowPeak);
+        m_windowFill += take;
+        samples += take;
+        count -= take;
+
+        if (m_windowFill == m_windowSamples) {
+            closeWindow();
+        }
+    }
+}
+
+SilenceDetector::Result SilenceDetector::result() const
+{
+    qint64 first = m_firstAudible;
+    qint64 last = m_lastAudible;
+    if (m_windowFill > 0 && isAudible(m_windowSum, m_windowPeak, m_windowFill)) {
+        first = first < 0 ? m_windows : first;
+        last = m_windows;
+    }
+
+    Result result;
+    const qint64 frames = m_samples / m_channels;
+    const float peak = qMax(m_peak, m_windowPeak);
+    result.valid = frames > 0;
+    result.durationMs = frames * 1000 / m_sampleRate;
+    result.peakDb = peak > 0.0f ? 20.0 * std::log10(peak) : result.peakDb;
+    if (first < 0) {
+        return result;
+    }
+
+    result.audible = true;
+    const qint64 windowFrames = m_windowSamples / m_channels;
+    const qint64 startMs = first * windowFrames * 1000 / m_sampleRate;
+    const qint64 endMs = qMin(frames, (last + 1) * windowFrames) * 1000 / m_sampleRate;
+
+    const qint64 inMs = qMax<qint64>(0, startMs - m_settings.leadInMs);
+    if (inMs >= m_settings.minTrimMs) {
+        result.cue.inMs = inMs;
+    }
+    const qint64 outMs = endMs + m_settings.tailMs;
+    if (result.durationMs - outMs >= m_settings.minTrimMs) {
+        result.cue.outMs = outMs;
+    }
+    return result;
+}
+
+SilenceDetector::Result SilenceDetector::analyzeFile(const QString& filePath, const Settings& settings,
+                                                     QString* error, int timeoutMs)
+{
+    std::unique_ptr<SilenceDetector> detector;
+    std::unique_ptr<SegueDetector> segue;
+    const auto feed = [&](const float* samples, qint64 count, int sampleRate, int channels) {
+        if (!detector) {
+            detector = std::make_unique<SilenceDetector>(sampleRate, channels, settings);
+            segue = std::make_unique<SegueDetector>(sampleRate, channels);
+        }
+        detector->feed(samples, count);
+        segue->feed(samples, count);
+    };
+
+    if (!PcmDecoder::decode(filePath, ANALYSIS_SAMPLE_RATE, feed, error, timeoutMs)) {
+        return Result();
+    }
+    return withSeguePoints(detector->result(), segue->result());
+}
+
+SilenceDetector::Result SilenceDetector::withSeguePoints(Result result,
+                                                         const SegueDetector::Result& points)
+{
+    if (result.audible && points.valid) {
+        result.cue.introMs = points.introMs;
+        result.cue.fadeMs = points.fadeMs;
+        // A segue point at the end of the audio adds nothing to the cue-out
+        const qint64 end = result.cue.outMs >= 0 ? result.cue.outMs : result.durationMs;
+        result.cue.segueMs = points.segueMs < end ? points.segueMs : -1;
+    }
+    return result;
+}
+
+void SilenceDetector::closeWindow()
+{
+    if (isAudible(m_windowSum, m_windowPeak, m_windowFill)) {
+        m_firstAudible = m_firstAudible < 0 ? m_windows : m_firstAudible;
+        m_lastAudible = m_windows;
+    }
+    m_peak = qMax(m_peak, m_windowPeak);
+    ++m_windows;
+    m_windowSum = 0.0f;
+    m_windowPeak = 0.0f;
+    m_windowFill = 0;
+}
+
+bool SilenceDetector::isAudible(float sumSquares, float peak, qint64 samples) const
+{
+    if (peak >= m_peakThreshold) {
+        return true;
+    }
+    return samples > 0 && std::sqrt(sumSquares / samples) >= m_rmsThreshold;
+}
+
+void SilenceDetector::accumulate(const float* samples, qint64 count, float& sumSquares, float& peak)
+{
+    // Independent lanes let the compiler keep the loop in SIMD registers; a
+    // single running sum would have to be added up in order without -ffast-math
+    constexpr int LANES = 8;
+    float sums[LANES] = {};
+    float peaks[LANES] = {};
+
+    qint64 i = 0;
+    for (; i + LANES <= count; i += LANES) {
+        for (int lane = 0; lane < LANES; ++lane) {
+            const float x = samples[i + lane];
+            sums[lane] += x * x;
+            const float magnitude = std::fabs(x);
+            peaks[lane] = peaks[lane] < magnitude ? magnitude : peaks[lane];
+        }
+    }
+    for (; i < count; ++i) {
+        const float x = samples[i];
+        sums[0] += x * x;
+        peaks[0] = qMax(peaks[0], std::fabs(x));
+    }
+
+    for (int lane = 0; lane < LANES; ++lane) {
+        sumSquares += sums[lane];
+        peak = qMax(peak, peaks[lane]);
+    }
+}
@@ -0,0 +1,137 @@
+#ifndef SILENCEDETECTOR_H
+#define SILENCEDETECTOR_H
+
+#include "CuePoints.h"
+#include "PcmDecoder.h"
+#include "SegueDetector.h"
+#include <QString>
+
+/**
+ * @brief Finds the leading and trailing silence of a track by RMS and peak level
+ *
+ * The AutoTrim action used to run sox over every file of the library one
+ * at a time and rewrite the files with their silence cut off. That was slow,
+ * lossy for compressed formats and could not be undone. SilenceDetector only
+ * measures: interleaved float samples are fed in as they are decoded, and
+ * the track is cut into windows of Settings::windowMs. A window is audible
+ * if its RMS level reaches rmsThresholdDb or a single sample in it reaches
+ * peakThresholdDb.
+ * The first and last audible windows give cue points, which PlaybackEngine
+ * then plays between without touching the file.
+ *
+ * The level scan is a plain loop over the samples with independent
+ * accumulators, which the compiler turns into SIMD code. Memory does not
+ * grow with the length of the track.
+ *
+ * analyzeFile() decodes a whole file with PcmDecoder and runs a detector
+ * over it, along with a SegueDetector whose intro, fade and segue points
+ * are added to the cue points. It blocks, running its own event loop, and
+ * is meant for worker threads; SilenceScanner runs it for many files in
+ * parallel.
+ *
+ * @example
+ * @code
+ * QString error;
+ * const SilenceDetector::Result result = SilenceDetector::analyzeFile(path, {}, &error);
+ * if (result.valid) {
+ *     store->setCuePoints(path, result.cue);
+ * }
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class SilenceDetector
+{
+public:
+    /**
+     * @brief What counts as silence and how much of it is kept
+     */
+    struct Settings {
+        double rmsThresholdDb = -45.0;  ///< Windows at or above this RMS level are audible
+        double peakThresholdDb = -30.0; ///< So are windows with a sample at or above this level
+        int windowMs = 10;              ///< Length of a level window
+        int leadInMs = 20;              ///< Kept before the first audible window
+        int tailMs = 250;               ///< Kept after the last audible window, for the decay
+        int minTrimMs = 100;            ///< Less silence than this is left in place
+    };
+
+    /**
+     * @brief What was found in a track
+     */
+    struct Result {
+        bool valid = false;      ///< Audio was decoded
+        bool audible = false;    ///< At least one window was audible
+        qint64 durationMs = 0;   ///< Length of the audio that was fed in
+        double peakDb = -120.0;  ///< Highest sample level
+        CuePoints cue;           ///< Where playback should start and end; the default if all silent
+    };
+
+    static constexpr int DEFAULT_TIMEOUT_MS = PcmDecoder::DEFAULT_TIMEOUT_MS;
+
+    /**
+     * @brief Create a detector for one track
+     * @param sampleRate Rate of the samples that will be fed, in Hz
+     * @param channels Channels per interleaved frame
+     * @param settings Thresholds and margins
+     */
+    SilenceDetector(int sampleRate, int channels, const Settings& settings);
+    SilenceDetector(int sampleRate, int channels);
+
+    /**
+     * @brief Scan the next part of the track
+     * @param samples Interleaved float samples
+     * @param count Number of samples, a whole number of frames
+     */
+    void feed(const float* samples, qint64 count);
+
+    /**
+     * @brief Get the cue points for everything fed so far
+     * @return Result; the last, partial window is included
+     */
+    Result result() const;
+
+    /**
+     * @brief Decode a file and find its cue and segue points
+     * @param filePath Path of the audio file
+     * @param settings Thresholds and margins
+     * @param error Receives the reason if the result is not valid; may be nullptr
+     * @param timeoutMs Decoding is given up after this long
+     * @return Result; not valid if the file could not be decoded
+     */
+    static Result analyzeFile(const QString& filePath, const Settings& settings,
+                              QString* error = nullptr, int timeoutMs = DEFAULT_TIMEOUT_MS);
+
+    /**
+     * @brief Add the intro, fade and segue points of a SegueDetector to the cue points
+     * @param result What a detector found in the track
+     * @param points What a SegueDetector found in the same audio
+     */
+    static Result withSeguePoints(Result result, const SegueDetector::Result& points);
+
+private:
+    void closeWindow();
+    bool isAudible(float sumSquares, float peak, qint64 samples) const;
+
+    static void accumulate(const float* samples, qint64 count, float& sumSquares, float& peak);
+
+    /// Rate analyzeFile() asks the decoder for; levels do not need more
+    static constexpr int ANALYSIS_SAMPLE_RATE = 22050;
+
+    int m_sampleRate;
+    int m_channels;
+    Settings m_settings;
+    float m_rmsThreshold;
+    float m_peakThreshold;
+    qint64 m_windowSamples;
+
+    float m_windowSum = 0.0f;
+    float m_windowPeak = 0.0f;
+    qint64 m_windowFill = 0;
+    qint64 m_windows = 0;         ///< Complete windows scanned
+    qint64 m_firstAudible = -1;   ///< Index of the first audible window
+    qint64 m_lastAudible = -1;    ///< Index of the last audible window
+    qint64 m_samples = 0;
+    float m_peak = 0.0f;
+};
+
+#endif // SILENCEDETECTOR_H
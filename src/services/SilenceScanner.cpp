@@ -0,0 +1,128 @@
+#include "SilenceScanner.h"
+#include "CuePointStore.h"
+#include <QDebug>
+#include <QFutureWatcher>
+#include <QSet>
+#include <QThread>
+#include <QtConcurrent/QtConcurrent>
+
+SilenceScanner::SilenceScanner(CuePointStore* store, QObject* parent)
+    : QObject(parent)
+    , m_store(store)
+    , m_analyze([](const QString& filePath, const SilenceDetector::Settings& settings,
+                   QString* error) { return SilenceDetector::analyzeFile(filePath, settings, error); })
+    , m_maxWorkers(qMax(1, QThread::idealThreadCount() - 1))
+{
+    m_pool.setThreadPriority(QThread::LowPriority);
+    m_pool.setMaxThreadCount(m_maxWorkers);
+}
+
+SilenceScanner::~SilenceScanner()
+{
+    m_queue.clear();
+    m_pool.waitForDone();
+}
+
+void SilenceScanner::setMaxWorkers(int workers)
+{
+    m_maxWorkers = qMax(1, workers);
+    m_pool.setMaxThreadCount(m_maxWorkers);
+    schedule();
+}
+
+int SilenceScanner::scan(const QStringList& filePaths)
+{
+    const QSet<QString> waiting(m_queue.cbegin(), m_queue.cend());
+    int added = 0;
+    for (const QString& filePath : filePaths) {
+        if (filePath.isEmpty() || waiting.contains(filePath)) {
+            continue;
+        }
+        m_queue.append(filePath);
+        ++added;
+    }
+    if (added == 0) {
+        return 0;
+    }
+
+    m_total += added;
+    m_running = true;
+    schedule();
+    return added;
+}
+
+void SilenceScanner::cancel()
+{
+    if (!m_running) {
+        return;
+    }
+
+    m_queue.clear();
+    ++m_generation;
+    m_inFlight = 0;
+    finish();
+}
+
+void SilenceScanner::schedule()
+{
+    while (m_running && m_inFlight < m_maxWorkers && !m_queue.isEmpty()) {
+        const QString filePath = m_queue.takeFirst();
+        ++m_inFlight;
+
+        auto* watcher = new QFutureWatcher<Outcome>(this);
+        const int generation = m_generation;
+        connect(watcher, &QFutureWatcher<Outcome>::finished, this, [this, watcher, generation]() {
+            onAnalyzed(watcher->result(), generation);
+            watcher->deleteLater();
+        });
+        watcher->setFuture(QtConcurrent::run(
+            &m_pool, [analyze = m_analyze, settings = m_settings, filePath]() {
+                Outcome outcome;
+                outcome.filePath = filePath;
+                outcome.result = analyze(filePath, settings, &outcome.error);
+                return outcome;
+            }));
+    }
+}
+
+void SilenceScanner::onAnalyzed(const Outcome& outcome, int generation)
+{
+    if (generation != m_generation) {
+        return;
+    }
+    --m_inFlight;
+
+    if (outcome.result.valid) {
+        if (m_store) {
+            m_store->setCuePoints(outcome.filePath, outcome.result.cue);
+        }
+        ++m_analyzed;
+        emit trackAnalyzed(outcome.filePath, outcome.result.cue);
+    } else {
+        ++m_failed;
+        qWarning() << QString("SilenceScanner::onAnalyzed - %1: %2").arg(outcome.filePath, outcome.error);
+    }
+    emit progressChanged(m_analyzed + m_failed, m_total);
+
+    if (m_queue.isEmpty() && m_inFlight == 0) {
+        finish();
+    } else {
+        schedule();
+    }
+}
+
+void SilenceScanner::finish()
+{
+    const int analyzed = m_analyzed;
+    const int failed = m_failed;
+    m_running = false;
+    m_total = 0;
+    m_analyzed = 0;
+    m_failed = 0;
+
+    if (m_store) {
+        m_store->flush();
+    }
+    qInfo() << "SilenceScanner: scan finished," << analyzed << "analyzed," << failed << "failed";
+    emit finished(analyzed, failed);
+}
@@ -0,0 +1,124 @@
+#ifndef SILENCESCANNER_H
+#define SILENCESCANNER_H
+
+#include "SilenceDetector.h"
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <functional>
+
+class CuePointStore;
+
+/**
+ * @brief Finds the cue points of many tracks in parallel
+ *
+ * SilenceScanner runs SilenceDetector::analyzeFile() for a list of library
+ * tracks on its own low-priority thread pool, with up to maxWorkers() files
+ * decoding at once. By default that leaves one core for on-air playback.
+ * Results come back on the scanner's thread and are handed to the
+ * CuePointStore, which writes them to the musics table in batches.
+ *
+ * Only maxWorkers() files are handed to the pool at a time, so cancel()
+ * takes effect after the files being decoded are done; their results are
+ * dropped.
+ *
+ * @example
+ * @code
+ * SilenceScanner* scanner = new SilenceScanner(cueStore, this);
+ * connect(scanner, &SilenceScanner::finished, this, [](int analyzed, int failed) {
+ *     qDebug() << analyzed << "tracks trimmed," << failed << "could not be decoded";
+ * });
+ * scanner->scan(allLibraryPaths);
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class SilenceScanner : public QObject
+{
+    Q_OBJECT
+
+public:
+    /// Runs on a pool thread; SilenceDetector::analyzeFile() unless replaced
+    using Analyzer = std::function<SilenceDetector::Result(
+        const QString& filePath, const SilenceDetector::Settings& settings, QString* error)>;
+
+    explicit SilenceScanner(CuePointStore* store, QObject* parent = nullptr);
+    ~SilenceScanner() override;
+
+    void setSettings(const SilenceDetector::Settings& settings) { m_settings = settings; }
+    SilenceDetector::Settings settings() const { return m_settings; }
+
+    /**
+     * @brief Set how many files are decoded at once
+     * @param workers Worker count; one less than the number of cores by default
+     */
+    void setMaxWorkers(int workers);
+    int maxWorkers() const { return m_maxWorkers; }
+
+    void setAnalyzer(Analyzer analyzer) { m_analyze = std::move(analyzer); }
+
+    /**
+     * @brief Add tracks to the scan and start it if it is not running
+     * @param filePaths Paths as stored in the musics table
+     * @return Number of tracks added; tracks already waiting are skipped
+     */
+    int scan(const QStringList& filePaths);
+
+    /**
+     * @brief Drop the tracks that have not been started
+     */
+    void cancel();
+
+    bool isRunning() const { return m_running; }
+
+signals:
+    /**
+     * @brief Emitted when a track's cue points were stored
+     * @param filePath Path of the track
+     * @param cue Cue points found
+     */
+    void trackAnalyzed(const QString& filePath, const CuePoints& cue);
+
+    /**
+     * @brief Emitted after each track
+     * @param done Tracks finished, including those that failed
+     * @param total Tracks in this scan
+     */
+    void progressChanged(int done, int total);
+
+    /**
+     * @brief Emitted when the last track of the scan is done, or after cancel()
+     * @param analyzed Tracks whose cue points were stored
+     * @param failed Tracks that could not be decoded
+     */
+    void finished(int analyzed, int failed);
+
+private:
+    struct Outcome {
+        QString filePath;
+        SilenceDetector::Result result;
+        QString error;
+    };
+
+    void schedule();
+    void onAnalyzed(const Outcome& outcome, int generation);
+    void finish();
+
+    CuePointStore* m_store;
+    QThreadPool m_pool;
+    SilenceDetector::Settings m_settings;
+    Analyzer m_analyze;
+    int m_maxWorkers;
+
+    QStringList m_queue;
+    bool m_running = false;
+    int m_inFlight = 0;
+    int m_generation = 0;   ///< Bumped by cancel() so late results are dropped
+    int m_total = 0;
+    int m_analyzed = 0;
+    int m_failed = 0;
+};
+
+#endif // SILENCESCANNER_H
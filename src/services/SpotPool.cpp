@@ -0,0 +1,143 @@
+#include "SpotPool.h"
+#include <QDebug>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <algorithm>
+
+SpotPool::SpotPool(QSqlDatabase& database, const QString& table, QObject* parent)
+    : QObject(parent)
+    , m_database(database)
+    , m_table(table)
+    , m_random(QRandomGenerator::global()->generate())
+{
+}
+
+bool SpotPool::reload()
+{
+    m_stale = false;
+
+    QSqlQuery query(m_database);
+    query.setForwardOnly(true);
+    if (!query.exec(QString("SELECT DISTINCT path FROM %1").arg(m_table))) {
+        const QString error = QString("SQL Error: %1").arg(query.lastError().text());
+        qWarning() << "SpotPool::reload -" << m_table << error;
+        emit operationError("reload", error);
+        return false;
+    }
+
+    // A spot that stays keeps its duration, so a reload probes only new files
+    QHash<QString, qint64> durations;
+    for (const Spot& spot : std::as_const(m_spots)) {
+        durations.insert(spot.path, spot.durationUs);
+    }
+    const QString lastPath = m_last >= 0 ? m_spots[m_last].path : QString();
+
+    m_spots.clear();
+    m_last = -1;
+    while (query.next()) {
+        Spot spot;
+        spot.path = query.value(0).toString();
+        if (spot.path.isEmpty()) {
+            continue;
+        }
+        const auto known = durations.constFind(spot.path);
+        if (known != durations.cend() && *known >= 0) {
+            spot.durationUs = *known;
+        } else if (m_durationLookup) {
+            spot.durationUs = m_durationLookup(spot.path);
+        }
+        spot.weight = m_weights.value(spot.path, 1);
+        if (spot.path == lastPath) {
+            m_last = m_spots.size();
+        }
+        m_spots.append(spot);
+    }
+
+    buildRound();
+    qDebug() << "SpotPool: loaded" << m_spots.size() << "spots from" << m_table;
+    return true;
+}
+
+SpotPool::Spot SpotPool::next()
+{
+    ensureLoaded();
+    if (m_round.isEmpty()) {
+        return Spot();
+    }
+    if (m_cursor >= m_round.size()) {
+        buildRound();
+    }
+    m_last = m_round[m_cursor++];
+    return m_spots[m_last];
+}
+
+SpotPool::Spot SpotPool::peek()
+{
+    ensureLoaded();
+    if (m_round.isEmpty()) {
+        return Spot();
+    }
+    if (m_cursor >= m_round.size()) {
+        buildRound();
+    }
+    return m_spots[m_round[m_cursor]];
+}
+
+void SpotPool::setWeight(const QString& filePath, int weight)
+{
+    weight = qMax(1, weight);
+    m_weights.insert(filePath, weight);
+    for (Spot& spot : m_spots) {
+        if (spot.path == filePath && spot.weight != weight) {
+            spot.weight = weight;
+            buildRound();
+            break;
+        }
+    }
+}
+
+int SpotPool::size()
+{
+    ensureLoaded();
+    return m_spots.size();
+}
+
+QVector<SpotPool::Spot> SpotPool::spots()
+{
+    ensureLoaded();
+    return m_spots;
+}
+
+void SpotPool::ensureLoaded()
+{
+    if (m_stale) {
+        reload();
+    }
+}
+
+void SpotPool::buildRound()
+{
+    m_round.clear();
+    m_cursor = 0;
+    for (int i = 0; i < m_spots.size(); ++i) {
+        m_round.insert(m_round.size(), m_spots[i].weight, i);
+    }
+    for (int i = m_round.size() - 1; i > 0; --i) {
+        std::swap(m_round[i], m_round[m_random.bounded(i + 1)]);
+    }
+
+    // Spread out repeats: a spot equal to the one before it trades places
+    // with the first later one that is not
+    int previous = m_last;
+    for (int i = 0; i < m_round.size(); ++i) {
+        if (m_round[i] == previous) {
+            for (int j = i + 1; j < m_round.size(); ++j) {
+                if (m_round[j] != previous) {
+                    std::swap(m_round[i], m_round[j]);
+                    break;
+                }
+            }
+        }
+        previous = m_round[i];
+    }
+}
@@ -0,0 +1,123 @@
+#ifndef SPOTPOOL_H
+#define SPOTPOOL_H
+
+#include <QHash>
+#include <QObject>
+#include <QRandomGenerator>
+#include <QSqlDatabase>
+#include <QString>
+#include <QVector>
+#include <functional>
+
+/**
+ * @brief In-memory rotation of the jingles or pubs
+ *
+ * The random jingle option ran "ORDER BY random()" on the jingles table
+ * every few songs. SpotPool reads the paths of a table once, with their
+ * durations, and hands them out from a shuffled round, so drawing one
+ * touches neither the database nor the disk.
+ *
+ * Every spot airs weight() times per round; the default weight is 1, so a
+ * round plays each spot once. The same spot does not air twice in a row,
+ * across rounds either, unless the weights leave no other order.
+ *
+ * Code that edits the table calls invalidate(), and the paths are read
+ * again before the next draw. Weights are kept by path across reloads.
+ *
+ * @example
+ * @code
+ * SpotPool jingles(db, "jingles");
+ * jingles.setDurationLookup([cache](const QString& path) { return cache->durationUs(path); });
+ * const SpotPool::Spot jingle = jingles.next();
+ * if (!jingle.path.isEmpty())
+ *     queue->prepend(jingle.path);
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class SpotPool : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Spot {
+        QString path;
+        qint64 durationUs = -1;   ///< -1 if unknown or no lookup is set
+        int weight = 1;
+    };
+
+    /// Returns the duration of a file in microseconds, -1 if unknown
+    using DurationLookup = std::function<qint64(const QString& filePath)>;
+
+    /**
+     * @param database Database holding the table
+     * @param table "jingles" or "pub"; any table with a path column
+     */
+    SpotPool(QSqlDatabase& database, const QString& table, QObject* parent = nullptr);
+
+    void setDurationLookup(DurationLookup lookup) { m_durationLookup = std::move(lookup); }
+
+    /**
+     * @brief Read the paths of the table and start a fresh round
+     * @return true if the table was read
+     */
+    bool reload();
+
+    /**
+     * @brief Mark the pool stale so the table is read again before the next draw
+     */
+    void invalidate() { m_stale = true; }
+
+    /**
+     * @brief Take the next spot of the round
+     * @return The spot, with an empty path if the table is empty
+     */
+    Spot next();
+
+    /**
+     * @brief The spot next() will return, without taking it
+     */
+    Spot peek();
+
+    /**
+     * @brief Set how many times per round a spot airs
+     * @param filePath Path of the spot
+     * @param weight Plays per round, at least 1
+     */
+    void setWeight(const QString& filePath, int weight);
+
+    int size();
+
+    /**
+     * @brief All spots of the table, with their durations
+     */
+    QVector<Spot> spots();
+
+    /**
+     * @brief Seed the shuffle, for reproducible rounds
+     */
+    void setSeed(quint32 seed) { m_random.seed(seed); }
+
+signals:
+    /**
+     * @brief Emitted when the table cannot be read
+     */
+    void operationError(const QString& operation, const QString& error);
+
+private:
+    void ensureLoaded();
+    void buildRound();
+
+    QSqlDatabase& m_database;
+    QString m_table;
+    DurationLookup m_durationLookup;
+    QVector<Spot> m_spots;
+    QHash<QString, int> m_weights;
+    QVector<int> m_round;   ///< Indices into m_spots
+    int m_cursor = 0;
+    int m_last = -1;        ///< Spot drawn last, kept out of the start of the next round
+    QRandomGenerator m_random;
+    bool m_stale = true;
+};
+
+#endif // SPOTPOOL_H
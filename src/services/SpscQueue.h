@@ -0,0 +1,98 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <QtGlobal>
+#include <atomic>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Single-producer/single-consumer queue of messages
+ *
+ * The message counterpart of AudioRingBuffer: one thread pushes, another
+ * pops, neither blocks and neither allocates after construction. Like the
+ * ring buffer it counts reads and writes with monotonically increasing
+ * atomic counters; the slots are allocated up front.
+ *
+ * pop() moves a message out and leaves a default-constructed one in its
+ * slot, so whatever a message owns, such as the data of a QString, is
+ * released by the consumer and never by a later push().
+ *
+ * @example
+ * @code
+ * SpscQueue<Status> statuses(256);
+ * statuses.push(status);          // audio thread
+ * Status next;
+ * while (statuses.pop(next)) {}   // GUI thread
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+template <typename T>
+class SpscQueue
+{
+public:
+    /**
+     * @brief Create a queue
+     * @param capacity Messages it holds at most; rounded up to a power of two
+     */
+    explicit SpscQueue(int capacity)
+    {
+        int size = 1;
+        while (size < capacity) {
+            size *= 2;
+        }
+        m_slots.resize(size_t(size));
+        m_mask = size - 1;
+    }
+
+    int capacity() const { return m_mask + 1; }
+
+    /**
+     * @brief Queue a message; producer only
+     * @return false if the queue is full, in which case the message is not queued
+     */
+    bool push(T message)
+    {
+        const quint64 write = m_write.load(std::memory_order_relaxed);
+        if (write - m_read.load(std::memory_order_acquire) > quint64(m_mask)) {
+            return false;
+        }
+        m_slots[size_t(write & quint64(m_mask))] = std::move(message);
+        m_write.store(write + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Take the oldest message; consumer only
+     * @return false if the queue is empty
+     */
+    bool pop(T& message)
+    {
+        const quint64 read = m_read.load(std::memory_order_relaxed);
+        if (read == m_write.load(std::memory_order_acquire)) {
+            return false;
+        }
+        T& slot = m_slots[size_t(read & quint64(m_mask))];
+        message = std::move(slot);
+        slot = T();
+        m_read.store(read + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Whether nothing is queued; exact only on the consumer's thread
+     */
+    bool isEmpty() const
+    {
+        return m_read.load(std::memory_order_acquire) == m_write.load(std::memory_order_acquire);
+    }
+
+private:
+    std::vector<T> m_slots;
+    int m_mask = 0;
+    std::atomic<quint64> m_write{0};
+    std::atomic<quint64> m_read{0};
+};
+
+#endif // SPSCQUEUE_H
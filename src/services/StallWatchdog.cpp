@@ -0,0 +1,200 @@
+#include "StallWatchdog.h"
+#include <QDebug>
+#include <QMutexLocker>
+#include <QThread>
+#include <QTimer>
+#include <chrono>
+
+#if defined(Q_OS_LINUX) && defined(__GLIBC__)
+#define XFB_STALL_STACKS
+#include <cstdlib>
+#include <execinfo.h>
+#include <pthread.h>
+#include <signal.h>
+#endif
+
+namespace {
+
+#ifdef XFB_STALL_STACKS
+void* s_frames[StallWatchdog::MAX_STACK_FRAMES];
+std::atomic<int> s_frameCount{-1};
+
+// Runs on the watched thread; backtrace() was called once before, so it
+// does not need to load anything or allocate here
+void copyStack(int)
+{
+    s_frameCount.store(backtrace(s_frames, StallWatchdog::MAX_STACK_FRAMES),
+                       std::memory_order_release);
+}
+
+void installStackHandler()
+{
+    static const bool installed = []() {
+        void* warmUp[1];
+        backtrace(warmUp, 1);
+        struct sigaction action = {};
+        action.sa_handler = copyStack;
+        action.sa_flags = SA_RESTART;
+        sigemptyset(&action.sa_mask);
+        return sigaction(SIGUSR2, &action, nullptr) == 0;
+    }();
+    Q_UNUSED(installed)
+}
+#endif
+
+} // namespace
+
+StallWatchdog::StallWatchdog(QObject* parent)
+    : QObject(parent)
+    , m_heartbeat(new QTimer(this))
+    , m_spans(Tracer::openSpans())
+{
+    m_heartbeat->setTimerType(Qt::PreciseTimer);
+    m_heartbeat->setInterval(HEARTBEAT_INTERVAL_MS);
+    connect(m_heartbeat, &QTimer::timeout, this,
+            [this]() { m_lastBeatMs.store(nowMs(), std::memory_order_release); });
+#ifdef XFB_STALL_STACKS
+    m_nativeThread = quintptr(pthread_self());
+#endif
+}
+
+StallWatchdog::~StallWatchdog()
+{
+    stop();
+}
+
+void StallWatchdog::setThresholdMs(int thresholdMs)
+{
+    m_thresholdMs.store(qMax(thresholdMs, 2 * HEARTBEAT_INTERVAL_MS), std::memory_order_relaxed);
+}
+
+bool StallWatchdog::canCaptureStack()
+{
+#ifdef XFB_STALL_STACKS
+    return true;
+#else
+    return false;
+#endif
+}
+
+void StallWatchdog::start()
+{
+    if (m_watchdog) {
+        return;
+    }
+#ifdef XFB_STALL_STACKS
+    installStackHandler();
+#endif
+    m_lastBeatMs.store(nowMs(), std::memory_order_release);
+    m_heartbeat->start();
+    m_stopping.store(false);
+    m_watchdog = QThread::create([this]() { run(); });
+    m_watchdog->setObjectName("StallWatchdog");
+    m_watchdog->start();
+}
+
+void StallWatchdog::stop()
+{
+    if (!m_watchdog) {
+        return;
+    }
+    m_heartbeat->stop();
+    {
+        QMutexLocker locker(&m_wakeMutex);
+        m_stopping.store(true);
+        m_wake.wakeAll();
+    }
+    m_watchdog->wait();
+    delete m_watchdog;
+    m_watchdog = nullptr;
+}
+
+void StallWatchdog::run()
+{
+    bool inStall = false;
+    qint64 stallBeatMs = 0;
+    Stall stall;
+
+    QMutexLocker locker(&m_wakeMutex);
+    while (!m_stopping.load()) {
+        m_wake.wait(&m_wakeMutex, HEARTBEAT_INTERVAL_MS);
+        if (m_stopping.load()) {
+            break;
+        }
+
+        const qint64 lastBeatMs = m_lastBeatMs.load(std::memory_order_acquire);
+        const qint64 silentMs = nowMs() - lastBeatMs;
+        if (!inStall && silentMs >= thresholdMs()) {
+            inStall = true;
+            stallBeatMs = lastBeatMs;
+            stall = Stall();
+            stall.started = QDateTime::currentDateTime().addMSecs(-silentMs);
+            stall.spans = describeSpans();
+            stall.stack = captureStack();
+            QString report = QString("StallWatchdog: no answer for %1 ms").arg(silentMs);
+            if (!stall.spans.isEmpty()) {
+                report += " in " + stall.spans.join(" > ");
+            }
+            for (const QString& frame : stall.stack) {
+                report += "\n    " + frame;
+            }
+            qWarning().noquote() << report;
+        } else if (inStall && lastBeatMs != stallBeatMs) {
+            inStall = false;
+            stall.durationMs = lastBeatMs - stallBeatMs;
+            QMetaObject::invokeMethod(
+                this, [this, stall]() { emit stalled(stall); }, Qt::QueuedConnection);
+        }
+    }
+}
+
+QStringList StallWatchdog::describeSpans() const
+{
+    QStringList spans;
+    for (const Tracer::ActiveSpan& span : m_spans->snapshot()) {
+        if (span.category && span.name) {
+            spans << QString("%1:%2").arg(QString::fromUtf8(span.category),
+                                          QString::fromUtf8(span.name));
+        }
+    }
+    return spans;
+}
+
+QStringList StallWatchdog::captureStack()
+{
+    QStringList stack;
+#ifdef XFB_STALL_STACKS
+    s_frameCount.store(-1, std::memory_order_relaxed);
+    if (pthread_kill(pthread_t(m_nativeThread), SIGUSR2) != 0) {
+        return stack;
+    }
+    int frames = -1;
+    for (int waited = 0; waited < STACK_TIMEOUT_MS; ++waited) {
+        frames = s_frameCount.load(std::memory_order_acquire);
+        if (frames >= 0) {
+            break;
+        }
+        QThread::msleep(1);
+    }
+    if (frames <= 0) {
+        return stack;
+    }
+    char** symbols = backtrace_symbols(s_frames, frames);
+    if (!symbols) {
+        return stack;
+    }
+    // The first two frames are the handler and the signal trampoline
+    for (int i = 2; i < frames; ++i) {
+        stack << QString::fromLocal8Bit(symbols[i]);
+    }
+    std::free(symbols);
+#endif
+    return stack;
+}
+
+qint64 StallWatchdog::nowMs()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
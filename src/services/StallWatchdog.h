@@ -0,0 +1,125 @@
+#ifndef STALLWATCHDOG_H
+#define STALLWATCHDOG_H
+
+#include "Tracer.h"
+#include <QDateTime>
+#include <QMetaType>
+#include <QMutex>
+#include <QObject>
+#include <QStringList>
+#include <QWaitCondition>
+#include <atomic>
+
+class QThread;
+class QTimer;
+
+/**
+ * @brief Notices when the event loop of a thread stops answering
+ *
+ * A timer on the watched thread beats every HEARTBEAT_INTERVAL_MS. A
+ * thread of the watchdog's own checks the beats, and when none came for
+ * the threshold it takes what the watched thread is doing at that moment:
+ * - the TraceSpan instances open on it, outermost first;
+ * - its call stack, on Linux with glibc (see canCaptureStack()).
+ *
+ * That is written to the log at once, so a thread that never recovers is
+ * on record too. When the thread answers again, stalled() is emitted on
+ * it with the full duration.
+ *
+ * The stack is taken by sending the watched thread SIGUSR2, whose handler
+ * copies the return addresses; the watchdog thread then turns them into
+ * text. The frames name exported functions only; others show as module
+ * and offset, for addr2line. A blocking call interrupted by the signal is
+ * restarted where the system allows (SA_RESTART).
+ *
+ * @example
+ * @code
+ * // On the GUI thread, once the event loop runs
+ * StallWatchdog* watchdog = new StallWatchdog(this);
+ * watchdog->setThresholdMs(1000);
+ * connect(watchdog, &StallWatchdog::stalled, this, [](const StallWatchdog::Stall& stall) {
+ *     qWarning() << "Frozen for" << stall.durationMs << "ms in" << stall.spans;
+ * });
+ * watchdog->start();
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class StallWatchdog : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief A time the watched thread did not answer
+     */
+    struct Stall {
+        QDateTime started;        ///< Last beat before the stall
+        qint64 durationMs = 0;    ///< Time between that beat and the next
+        QStringList spans;        ///< Open spans when noticed, "category:name", outermost first
+        QStringList stack;        ///< Call stack when noticed, innermost first; empty if not taken
+    };
+
+    static constexpr int DEFAULT_THRESHOLD_MS = 500;
+    static constexpr int HEARTBEAT_INTERVAL_MS = 50;
+    static constexpr int MAX_STACK_FRAMES = 64;
+    static constexpr int STACK_TIMEOUT_MS = 200;   ///< Longest wait for the signal handler
+
+    /**
+     * @brief Create a watchdog for the calling thread
+     * @param parent Parent object; must live on the same thread
+     */
+    explicit StallWatchdog(QObject* parent = nullptr);
+    ~StallWatchdog() override;
+
+    /**
+     * @brief Set how long the thread may not answer before it counts as a stall
+     * @param thresholdMs Threshold, at least 2 * HEARTBEAT_INTERVAL_MS
+     */
+    void setThresholdMs(int thresholdMs);
+    int thresholdMs() const { return m_thresholdMs.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Start beating and watching; call with the thread's event loop running
+     */
+    void start();
+
+    /**
+     * @brief Stop watching and wait for the watchdog thread
+     */
+    void stop();
+
+    bool isRunning() const { return m_watchdog != nullptr; }
+
+    /**
+     * @brief Check if stalls come with the call stack on this platform
+     */
+    static bool canCaptureStack();
+
+signals:
+    /**
+     * @brief Emitted on the watched thread when it answers again after a stall
+     * @param stall What was noticed
+     */
+    void stalled(const StallWatchdog::Stall& stall);
+
+private:
+    void run();
+    QStringList describeSpans() const;
+    QStringList captureStack();
+    static qint64 nowMs();
+
+    QTimer* m_heartbeat;
+    QThread* m_watchdog = nullptr;
+    Tracer::OpenSpans* m_spans;              ///< Of the watched thread
+    std::atomic<qint64> m_lastBeatMs{0};
+    std::atomic<int> m_thresholdMs{DEFAULT_THRESHOLD_MS};
+    std::atomic<bool> m_stopping{false};
+    QMutex m_wakeMutex;
+    QWaitCondition m_wake;                   ///< The watchdog sleeps on it between checks
+    quintptr m_nativeThread = 0;             ///< Watched thread, for the stack signal
+};
+
+Q_DECLARE_METATYPE(StallWatchdog::Stall)
+
+#endif // STALLWATCHDOG_H
@@ -0,0 +1,53 @@
+#include "StartupProfiler.h"
+#include <QStringList>
+
+StartupProfiler::StartupProfiler()
+    : m_createdNs(Tracer::now())
+{
+}
+
+void StartupProfiler::begin(const char* name)
+{
+    end();
+    Phase phase;
+    phase.name = name;
+    phase.startNs = Tracer::now();
+    m_phases.push_back(phase);
+    m_running = true;
+}
+
+void StartupProfiler::end()
+{
+    if (!m_running) {
+        return;
+    }
+    Phase& phase = m_phases.back();
+    phase.durationNs = Tracer::now() - phase.startNs;
+    m_running = false;
+    if (Tracer::isEnabled()) {
+        Tracer::record("startup", phase.name, phase.startNs, phase.durationNs);
+    }
+}
+
+qint64 StartupProfiler::totalNs() const
+{
+    if (m_phases.empty()) {
+        return 0;
+    }
+    const Phase& last = m_phases.back();
+    const qint64 endNs = m_running ? Tracer::now() : last.startNs + last.durationNs;
+    return endNs - m_createdNs;
+}
+
+QString StartupProfiler::summary() const
+{
+    QStringList parts;
+    for (size_t i = 0; i < m_phases.size(); ++i) {
+        const Phase& phase = m_phases[i];
+        // The running phase counts up to now
+        const bool running = m_running && i + 1 == m_phases.size();
+        const qint64 durationNs = running ? Tracer::now() - phase.startNs : phase.durationNs;
+        parts << QString("%1 %2 ms").arg(phase.name).arg(durationNs / 1000000);
+    }
+    return QString("%1 (total %2 ms)").arg(parts.join(", ")).arg(totalNs() / 1000000);
+}
@@ -0,0 +1,86 @@
+#ifndef STARTUPPROFILER_H
+#define STARTUPPROFILER_H
+
+#include "Tracer.h"
+#include <QString>
+#include <vector>
+
+/**
+ * @brief Times the phases of starting the application
+ *
+ * A slow start is hard to blame on anything in particular: the window
+ * appears late and the log shows only what each part says about itself.
+ * Calling begin() at the start of every phase ends the one before it, so
+ * the phases follow one another and together cover the whole start.
+ * summary() lists them with their durations, for one line in the log.
+ *
+ * Each phase is also recorded as a span of category "startup", so with
+ * tracing on the start shows up on the timeline of the Chrome trace.
+ *
+ * Phase names must be literals or otherwise outlive the profiler, as the
+ * names of trace spans do. The profiler is meant for one thread.
+ *
+ * @example
+ * @code
+ * StartupProfiler profiler;
+ * profiler.begin("ui");
+ * setupUi(this);
+ * profiler.begin("database");
+ * openDatabase();
+ * profiler.end();
+ * qInfo() << "Startup:" << profiler.summary();
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class StartupProfiler
+{
+public:
+    struct Phase {
+        const char* name = nullptr;
+        qint64 startNs = 0;      ///< From Tracer::now()
+        qint64 durationNs = 0;   ///< 0 while the phase is running
+    };
+
+    StartupProfiler();
+
+    /**
+     * @brief Start a phase, ending the one running if any
+     * @param name Name of the phase; must be a literal or otherwise outlive the profiler
+     */
+    void begin(const char* name);
+
+    /**
+     * @brief End the phase running, if any
+     */
+    void end();
+
+    /**
+     * @brief Whether a phase is running
+     */
+    bool isRunning() const { return m_running; }
+
+    /**
+     * @brief Phases in the order they began
+     */
+    const std::vector<Phase>& phases() const { return m_phases; }
+
+    /**
+     * @brief Time from the profiler's creation to the end of the last phase, in nanoseconds
+     *
+     * Gaps between phases, after end() and before the next begin(), count too.
+     */
+    qint64 totalNs() const;
+
+    /**
+     * @brief Phases and their durations, e.g. "ui 40 ms, database 12 ms (total 52 ms)"
+     */
+    QString summary() const;
+
+private:
+    qint64 m_createdNs;
+    std::vector<Phase> m_phases;
+    bool m_running = false;
+};
+
+#endif // STARTUPPROFILER_H
@@ -0,0 +1,428 @@
+#include "StreamOutput.h"
+#include "HlsSegmenter.h"
+#include <QDebug>
+#include <QProcess>
+#include <QStandardPaths>
+#include <QSysInfo>
+#include <QTimer>
+#include <QtEndian>
+#include <algorithm>
+
+namespace {
+
+// Give up looking for the end of the Ogg headers after this much output
+constexpr qsizetype MAX_OGG_HEADER_BYTES = 256 * 1024;
+
+bool isOgg(StreamOutput::Codec codec)
+{
+    return codec == StreamOutput::Codec::Opus || codec == StreamOutput::Codec::Vorbis;
+}
+
+} // namespace
+
+StreamOutput::StreamOutput(QObject* parent)
+    : QObject(parent)
+    , m_pullTimer(new QTimer(this))
+{
+    m_pullTimer->setInterval(PULL_INTERVAL_MS);
+    connect(m_pullTimer, &QTimer::timeout, this, &StreamOutput::pull);
+}
+
+StreamOutput::~StreamOutput()
+{
+    stop();
+}
+
+void StreamOutput::setSource(PcmReader reader, int sampleRate)
+{
+    m_reader = std::move(reader);
+    m_sampleRate = sampleRate;
+}
+
+void StreamOutput::setServer(const QString& host, quint16 port, const QString& password)
+{
+    m_host = host;
+    m_port = port;
+    m_password = password;
+}
+
+void StreamOutput::setEncoder(const QString& program, ArgumentBuilder arguments)
+{
+    m_program = program;
+    m_arguments = std::move(arguments);
+}
+
+bool StreamOutput::start()
+{
+    if (m_running) {
+        return true;
+    }
+    if (!m_reader || m_sampleRate <= 0) {
+        logError("start", "No audio source");
+        return false;
+    }
+    const bool hls = !m_hls.target.isEmpty();
+    if ((m_host.isEmpty() || m_mounts.isEmpty()) && !hls) {
+        logError("start", "No server or mount points configured");
+        return false;
+    }
+    if (hls && m_hls.codec != Codec::Aac && m_hls.codec != Codec::Opus) {
+        logError("start", "HLS segments can only hold AAC or Opus");
+        return false;
+    }
+    if (QStandardPaths::findExecutable(m_program).isEmpty()) {
+        logError("start", QString("Encoder %1 not found in PATH").arg(m_program));
+        return false;
+    }
+
+    // One encoder per codec and bitrate, shared by the mounts that use them
+    for (const Mount& mount : m_mounts) {
+        const QString path = mount.path.startsWith('/') ? mount.path : "/" + mount.path;
+        if (m_sources.contains(path)) {
+            logError("start", QString("Mount %1 is listed twice").arg(path));
+            continue;
+        }
+
+        Encoder* encoder = nullptr;
+        for (Encoder* existing : m_encoders) {
+            if (existing->codec == mount.codec && existing->bitrateKbps == mount.bitrateKbps) {
+                encoder = existing;
+                break;
+            }
+        }
+        if (!encoder) {
+            encoder = new Encoder;
+            encoder->codec = mount.codec;
+            encoder->bitrateKbps = mount.bitrateKbps;
+            m_encoders.append(encoder);
+        }
+
+        IcecastSource* source = new IcecastSource(this);
+        IcecastSource::StreamInfo info = m_info;
+        info.bitrateKbps = mount.bitrateKbps;
+        source->setServer(m_host, m_port, path, m_password);
+        source->setContentType(contentType(mount.codec));
+        source->setStreamInfo(info);
+        connect(source, &IcecastSource::stateChanged, this,
+                [this, path](IcecastSource::State state) { emit mountStateChanged(path, state); });
+        m_sources.insert(path, source);
+        encoder->sources.append(source);
+    }
+
+    // HLS gets an encoder of its own, as it needs MP4 rather than the mounts' stream
+    if (hls) {
+        Encoder* encoder = new Encoder;
+        encoder->codec = m_hls.codec;
+        encoder->bitrateKbps = m_hls.bitrateKbps;
+        encoder->segmenter = new HlsSegmenter(this);
+        encoder->segmenter->setSegmentMs(m_hls.segmentMs);
+        connect(encoder->segmenter, &HlsSegmenter::operationError, this,
+                [this](const QString&, const QString& error) {
+                    emit operationError("hls", error);
+                });
+        if (!encoder->segmenter->setTarget(m_hls.target)) {
+            delete encoder->segmenter;
+            delete encoder;
+            stop();
+            return false;
+        }
+        m_encoders.append(encoder);
+    }
+
+    m_running = true;
+    for (Encoder* encoder : m_encoders) {
+        startEncoder(encoder);
+    }
+    for (IcecastSource* source : m_sources) {
+        source->open();
+    }
+    m_pullTimer->start();
+    qDebug() << "StreamOutput: streaming" << m_sources.size() << "mounts" << (hls ? "and HLS" : "")
+             << "with" << m_encoders.size() << "encoders at" << m_sampleRate << "Hz";
+    return true;
+}
+
+void StreamOutput::stop()
+{
+    m_running = false;
+    m_pullTimer->stop();
+
+    for (IcecastSource* source : m_sources) {
+        source->close();
+        source->deleteLater();
+    }
+    m_sources.clear();
+
+    for (Encoder* encoder : m_encoders) {
+        if (encoder->process) {
+            encoder->process->disconnect(this);
+            encoder->process->kill();
+            encoder->process->waitForFinished(1000);
+            delete encoder->process;
+        }
+        delete encoder->segmenter;
+        delete encoder;
+    }
+    m_encoders.clear();
+}
+
+IcecastSource::State StreamOutput::mountState(const QString& path) const
+{
+    const IcecastSource* source = m_sources.value(path);
+    return source ? source->state() : IcecastSource::State::Disconnected;
+}
+
+void StreamOutput::startEncoder(Encoder* encoder)
+{
+    encoder->header.clear();
+    encoder->headerDone = false;
+    if (encoder->segmenter) {
+        // A new encoder starts a new MP4 stream
+        encoder->segmenter->reset();
+    }
+
+    QStringList arguments;
+    if (m_arguments) {
+        arguments = m_arguments(encoder->codec, encoder->bitrateKbps, m_sampleRate);
+    } else if (encoder->segmenter) {
+        arguments = hlsEncoderArguments(encoder->codec, encoder->bitrateKbps, m_sampleRate,
+                                        m_hls.segmentMs);
+    } else {
+        arguments = encoderArguments(encoder->codec, encoder->bitrateKbps, m_sampleRate);
+    }
+
+    QProcess* process = new QProcess(this);
+    process->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    encoder->process = process;
+    connect(process, &QProcess::readyReadStandardOutput, this, [this, encoder]() { onEncoderOutput(encoder); });
+    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
+            [this, encoder]() { onEncoderFinished(encoder); });
+    connect(process, &QProcess::errorOccurred, this, [this, encoder](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart) {
+            onEncoderFinished(encoder);
+        }
+    });
+    process->start(m_program, arguments);
+}
+
+void StreamOutput::onEncoderOutput(Encoder* encoder)
+{
+    QByteArray data = encoder->process->readAllStandardOutput();
+    if (encoder->segmenter) {
+        encoder->segmenter->write(data);
+        return;
+    }
+
+    if (!encoder->headerDone) {
+        // Hold the output back until the Ogg headers are complete, so every
+        // mount gets them, including the ones that connect later
+        encoder->header += data;
+        qsizetype length = isOgg(encoder->codec) ? oggHeaderLength(encoder->header) : 0;
+        if (length < 0 && encoder->header.size() < MAX_OGG_HEADER_BYTES) {
+            return;
+        }
+        length = std::max<qsizetype>(length, 0);
+        data = encoder->header;
+        encoder->header.truncate(length);
+        encoder->headerDone = true;
+        for (IcecastSource* source : encoder->sources) {
+            source->setStreamHeader(encoder->header);
+        }
+    }
+
+    for (IcecastSource* source : encoder->sources) {
+        source->write(data);
+    }
+}
+
+void StreamOutput::onEncoderFinished(Encoder* encoder)
+{
+    if (!encoder->process) {
+        return;
+    }
+    encoder->process->deleteLater();
+    encoder->process = nullptr;
+    if (!m_running) {
+        return;
+    }
+
+    logError("encoder", QString("%1 for %2 kbps %3 stopped; restarting")
+                            .arg(m_program)
+                            .arg(encoder->bitrateKbps)
+                            .arg(contentType(encoder->codec)));
+    QTimer::singleShot(ENCODER_RESTART_MS, this, [this, encoder]() {
+        if (m_running && m_encoders.contains(encoder) && !encoder->process) {
+            startEncoder(encoder);
+        }
+    });
+}
+
+void StreamOutput::pull()
+{
+    // Drain what built up since the last tick, with some slack for a busy GUI thread
+    const int chunk = qMax(CHANNELS, m_sampleRate * CHANNELS * PULL_INTERVAL_MS * 4 / 1000);
+    m_pcm.resize(qsizetype(chunk) * sizeof(float));
+
+    for (;;) {
+        const int samples = m_reader(reinterpret_cast<float*>(m_pcm.data()), chunk);
+        if (samples <= 0) {
+            break;
+        }
+        const qint64 bytes = qint64(samples) * sizeof(float);
+        for (Encoder* encoder : m_encoders) {
+            QProcess* process = encoder->process;
+            if (!process || process->state() != QProcess::Running ||
+                process->bytesToWrite() > MAX_ENCODER_BACKLOG_BYTES) {
+                continue;
+            }
+            process->write(m_pcm.constData(), bytes);
+        }
+        if (samples < chunk) {
+            break;
+        }
+    }
+}
+
+bool StreamOutput::parseMounts(const QString& text, QList<Mount>& mounts)
+{
+    mounts.clear();
+    const QStringList entries = text.split(',', Qt::SkipEmptyParts);
+    for (const QString& entry : entries) {
+        const QString trimmed = entry.trimmed();
+        if (trimmed.isEmpty()) {
+            continue;
+        }
+
+        const qsizetype equals = trimmed.indexOf('=');
+        const QStringList encoding = trimmed.mid(equals + 1).split(':');
+        if (equals <= 0 || encoding.size() != 2) {
+            return false;
+        }
+
+        Mount mount;
+        mount.path = trimmed.left(equals).trimmed();
+        if (!mount.path.startsWith('/')) {
+            mount.path.prepend('/');
+        }
+
+        const QString codec = encoding[0].trimmed().toLower();
+        if (codec == "opus") {
+            mount.codec = Codec::Opus;
+        } else if (codec == "vorbis") {
+            mount.codec = Codec::Vorbis;
+        } else if (codec == "mp3") {
+            mount.codec = Codec::Mp3;
+        } else {
+            return false;
+        }
+
+        bool ok = false;
+        mount.bitrateKbps = encoding[1].trimmed().toInt(&ok);
+        if (!ok || mount.bitrateKbps <= 0) {
+            return false;
+        }
+        mounts.append(mount);
+    }
+    return !mounts.isEmpty();
+}
+
+QStringList StreamOutput::encoderArguments(Codec codec, int bitrateKbps, int sampleRate)
+{
+    const QString input = QSysInfo::ByteOrder == QSysInfo::LittleEndian ? "f32le" : "f32be";
+    QStringList arguments = {"-hide_banner", "-loglevel", "error",
+                             "-f", input, "-ar", QString::number(sampleRate),
+                             "-ac", QString::number(CHANNELS), "-i", "pipe:0",
+                             "-b:a", QString("%1k").arg(bitrateKbps)};
+
+    switch (codec) {
+    case Codec::Opus:
+        // libopus only takes 48 kHz and a few lower rates
+        arguments << "-c:a" << "libopus" << "-ar" << "48000" << "-f" << "ogg";
+        break;
+    case Codec::Vorbis:
+        arguments << "-c:a" << "libvorbis" << "-f" << "ogg";
+        break;
+    case Codec::Mp3:
+        arguments << "-c:a" << "libmp3lame" << "-f" << "mp3";
+        break;
+    case Codec::Aac:
+        arguments << "-c:a" << "aac" << "-f" << "adts";
+        break;
+    }
+
+    // Hand every packet to Icecast as soon as it is muxed
+    arguments << "-flush_packets" << "1" << "pipe:1";
+    return arguments;
+}
+
+QStringList StreamOutput::hlsEncoderArguments(Codec codec, int bitrateKbps, int sampleRate,
+                                              int fragmentMs)
+{
+    const QString input = QSysInfo::ByteOrder == QSysInfo::LittleEndian ? "f32le" : "f32be";
+    QStringList arguments = {"-hide_banner", "-loglevel", "error",
+                             "-f", input, "-ar", QString::number(sampleRate),
+                             "-ac", QString::number(CHANNELS), "-i", "pipe:0",
+                             "-b:a", QString("%1k").arg(bitrateKbps)};
+    if (codec == Codec::Opus) {
+        arguments << "-c:a" << "libopus" << "-ar" << "48000";
+    } else {
+        arguments << "-c:a" << "aac";
+    }
+
+    // An empty moov up front, then one moof and mdat per fragment; every audio
+    // frame is a key frame, so fragments are cut by length only
+    arguments << "-f" << "mp4"
+              << "-movflags" << "+empty_moov+default_base_moof+omit_tfhd_offset"
+              << "-frag_duration" << QString::number(qint64(fragmentMs) * 1000) << "pipe:1";
+    return arguments;
+}
+
+QString StreamOutput::contentType(Codec codec)
+{
+    if (isOgg(codec)) {
+        return "audio/ogg";
+    }
+    return codec == Codec::Aac ? "audio/aac" : "audio/mpeg";
+}
+
+qsizetype StreamOutput::oggHeaderLength(const QByteArray& data)
+{
+    // Header pages come first and carry granule position 0 (or -1 when no
+    // packet ends on them); the first audio page has a real position
+    constexpr int PAGE_HEADER_SIZE = 27;
+    qsizetype offset = 0;
+    for (;;) {
+        if (data.size() - offset < PAGE_HEADER_SIZE) {
+            return offset == 0 && data.size() >= 4 && !data.startsWith("OggS") ? 0 : -1;
+        }
+        const char* page = data.constData() + offset;
+        if (qstrncmp(page, "OggS", 4) != 0) {
+            return offset;
+        }
+
+        const int segments = static_cast<uchar>(page[26]);
+        if (data.size() - offset < PAGE_HEADER_SIZE + segments) {
+            return -1;
+        }
+        qsizetype bodySize = 0;
+        for (int i = 0; i < segments; ++i) {
+            bodySize += static_cast<uchar>(page[PAGE_HEADER_SIZE + i]);
+        }
+        const qsizetype pageSize = PAGE_HEADER_SIZE + segments + bodySize;
+        if (data.size() - offset < pageSize) {
+            return -1;
+        }
+
+        const qint64 granule = qFromLittleEndian<qint64>(page + 6);
+        if (granule != 0 && granule != -1) {
+            return offset;
+        }
+        offset += pageSize;
+    }
+}
+
+void StreamOutput::logError(const QString& operation, const QString& error)
+{
+    qWarning() << QString("StreamOutput::%1 - %2").arg(operation, error);
+    emit operationError(operation, error);
+}
@@ -0,0 +1,252 @@
+#ifndef STREAMOUTPUT_H
+#define STREAMOUTPUT_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <functional>
+
+#include "IcecastSource.h"
+
+class HlsSegmenter;
+class QProcess;
+class QTimer;
+
+/**
+ * @brief Streams XFB's own output to Icecast, without butt or darkice
+ *
+ * StreamOutput pulls the mixed PCM the playback engine hands it, encodes
+ * it and sends it to one or more Icecast mount points through
+ * IcecastSource connections. Nothing is captured from a sound card.
+ *
+ * Encoding is done by an ffmpeg child process per distinct codec and
+ * bitrate, which XFB already relies on for file conversion. Raw float PCM
+ * goes in on its stdin and the encoded stream comes out on its stdout, so
+ * the encoding work runs on other cores, not the GUI thread. Mounts that
+ * share a codec and bitrate share one encoder: "/live.ogg" and
+ * "/backup.ogg", both Opus at 96 kbps, cost a single encode.
+ *
+ * For Ogg codecs, the header pages the encoder writes first are kept.
+ * Every mount that connects or reconnects later is given them before any
+ * audio, so its listeners can decode the stream. An encoder that exits is
+ * started again after ENCODER_RESTART_MS.
+ *
+ * Alongside the mounts, or instead of them, setHls() adds an HLS output
+ * for web and mobile players: one more encoder writes AAC or Opus in
+ * fragmented MP4, which an HlsSegmenter cuts into segments and a rolling
+ * playlist in a directory or under an HTTP URL.
+ *
+ * @example
+ * @code
+ * StreamOutput* output = new StreamOutput(this);
+ * output->setSource([engine](float* data, int samples) { return engine->readTap(data, samples); },
+ *                   engine->sampleRate());
+ * output->setServer("127.0.0.1", 8888, "hackme");
+ * output->setMounts({{"/live.ogg", StreamOutput::Codec::Opus, 96},
+ *                    {"/live.mp3", StreamOutput::Codec::Mp3, 128}});
+ * engine->setTapEnabled(true);
+ * output->start();
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class StreamOutput : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class Codec {
+        Opus,
+        Vorbis,
+        Mp3,
+        Aac     ///< HLS output only
+    };
+    Q_ENUM(Codec)
+
+    /**
+     * @brief One mount point and the encoding it gets
+     */
+    struct Mount {
+        QString path;
+        Codec codec = Codec::Mp3;
+        int bitrateKbps = 128;
+    };
+
+    /**
+     * @brief HLS output; an empty target turns it off
+     */
+    struct Hls {
+        QString target;           ///< Directory, or http(s) URL the files are PUT under
+        Codec codec = Codec::Aac; ///< Aac or Opus
+        int bitrateKbps = 128;
+        int segmentMs = 6000;
+    };
+
+    /// Fills data with up to samples interleaved stereo float samples; returns how many
+    using PcmReader = std::function<int(float* data, int samples)>;
+    /// Builds the encoder's command line for a codec, bitrate and input rate
+    using ArgumentBuilder = std::function<QStringList(Codec codec, int bitrateKbps, int sampleRate)>;
+
+    static constexpr int CHANNELS = 2;
+    static constexpr int PULL_INTERVAL_MS = 20;
+    static constexpr int ENCODER_RESTART_MS = 2000;
+    /// Input an encoder may fall behind by before PCM is dropped for it
+    static constexpr qint64 MAX_ENCODER_BACKLOG_BYTES = 2 * 1024 * 1024;
+
+    explicit StreamOutput(QObject* parent = nullptr);
+    ~StreamOutput() override;
+
+    /**
+     * @brief Set where PCM comes from
+     * @param reader Called every PULL_INTERVAL_MS, from the thread that owns this object
+     * @param sampleRate Rate of the samples in Hz
+     */
+    void setSource(PcmReader reader, int sampleRate);
+
+    /**
+     * @brief Set the Icecast server every mount is on
+     * @param host Icecast host
+     * @param port Icecast port
+     * @param password Source password
+     */
+    void setServer(const QString& host, quint16 port, const QString& password);
+
+    void setStreamInfo(const IcecastSource::StreamInfo& info) { m_info = info; }
+
+    void setMounts(const QList<Mount>& mounts) { m_mounts = mounts; }
+    QList<Mount> mounts() const { return m_mounts; }
+
+    void setHls(const Hls& hls) { m_hls = hls; }
+    Hls hls() const { return m_hls; }
+
+    /**
+     * @brief Use another encoder program; the default is ffmpeg with encoderArguments()
+     * @param program Program to run
+     * @param arguments Builds its arguments
+     */
+    void setEncoder(const QString& program, ArgumentBuilder arguments);
+
+    /**
+     * @brief Start encoding, connect every mount and start the HLS output
+     * @return false if there is no source, no mount or HLS output, or the encoder program
+     *         is missing
+     */
+    bool start();
+
+    /**
+     * @brief Disconnect every mount and stop the encoders
+     */
+    void stop();
+
+    bool isRunning() const { return m_running; }
+
+    /**
+     * @brief Get the number of encoders running
+     * @return One per distinct codec and bitrate while running
+     */
+    int encoderCount() const { return m_encoders.size(); }
+
+    /**
+     * @brief Get the connection state of a mount
+     * @param path Mount point
+     * @return Disconnected if it is not streamed
+     */
+    IcecastSource::State mountState(const QString& path) const;
+
+    /**
+     * @brief Parse a mount list
+     * @param text Comma separated "<mount>=<codec>:<kbps>" entries, codec being
+     *             opus, vorbis or mp3, e.g. "/live.ogg=opus:96, /live.mp3=mp3:128"
+     * @param mounts Receives the mounts
+     * @return false if an entry is malformed
+     */
+    static bool parseMounts(const QString& text, QList<Mount>& mounts);
+
+    /**
+     * @brief Get the ffmpeg arguments for a codec
+     * @param codec Codec
+     * @param bitrateKbps Bitrate
+     * @param sampleRate Rate of the PCM fed in
+     * @return Arguments reading f32le from stdin and writing the stream to stdout
+     */
+    static QStringList encoderArguments(Codec codec, int bitrateKbps, int sampleRate);
+
+    /**
+     * @brief Get the ffmpeg arguments for the HLS output
+     * @param codec Aac or Opus
+     * @param bitrateKbps Bitrate
+     * @param sampleRate Rate of the PCM fed in
+     * @param fragmentMs Length of each MP4 fragment
+     * @return Arguments reading f32le from stdin and writing fragmented MP4 to stdout
+     */
+    static QStringList hlsEncoderArguments(Codec codec, int bitrateKbps, int sampleRate,
+                                           int fragmentMs);
+
+    /**
+     * @brief Get the MIME type Icecast announces for a codec
+     * @param codec Codec
+     * @return Content type
+     */
+    static QString contentType(Codec codec);
+
+    /**
+     * @brief Find where the header pages at the start of an Ogg stream end
+     * @param data Start of the stream
+     * @return Length of the header pages, 0 if data is not Ogg, -1 if more data is needed
+     */
+    static qsizetype oggHeaderLength(const QByteArray& data);
+
+signals:
+    /**
+     * @brief Emitted when a mount connects, disconnects or starts reconnecting
+     * @param path Mount point
+     * @param state New state
+     */
+    void mountStateChanged(const QString& path, IcecastSource::State state);
+
+    /**
+     * @brief Emitted when an operation fails
+     * @param operation Name of the operation
+     * @param error Error message
+     */
+    void operationError(const QString& operation, const QString& error);
+
+private:
+    struct Encoder {
+        Codec codec = Codec::Mp3;
+        int bitrateKbps = 0;
+        QProcess* process = nullptr;
+        QList<IcecastSource*> sources;
+        QByteArray header;        ///< Ogg header pages, once complete
+        bool headerDone = false;
+        HlsSegmenter* segmenter = nullptr;  ///< Set for the HLS encoder, which feeds no mount
+    };
+
+    void startEncoder(Encoder* encoder);
+    void onEncoderOutput(Encoder* encoder);
+    void onEncoderFinished(Encoder* encoder);
+    void pull();
+    void logError(const QString& operation, const QString& error);
+
+    PcmReader m_reader;
+    int m_sampleRate = 0;
+    QString m_host;
+    quint16 m_port = IcecastSource::DEFAULT_PORT;
+    QString m_password;
+    IcecastSource::StreamInfo m_info;
+    QList<Mount> m_mounts;
+    Hls m_hls;
+    QString m_program = "ffmpeg";
+    ArgumentBuilder m_arguments;
+
+    QTimer* m_pullTimer;
+    QList<Encoder*> m_encoders;
+    QHash<QString, IcecastSource*> m_sources;
+    QByteArray m_pcm;
+    bool m_running = false;
+};
+
+#endif // STREAMOUTPUT_H
@@ -0,0 +1,456 @@
+#include "StreamingExporter.h"
+#include <QDebug>
+#include <QFile>
+#include <QLocale>
+#include <QPointer>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QUuid>
+#include <QtConcurrent/QtConcurrentRun>
+#include <cmath>
+#include <filesystem>
+#include <system_error>
+
+#ifdef XFB_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace {
+
+const QString PART_SUFFIX = ".part";
+
+/// Buffers the text of the rows and writes it out, compressed or not, a buffer at a time
+class Sink
+{
+public:
+    Sink(QFile& file, bool gzip)
+        : m_file(file)
+        , m_gzip(gzip)
+    {
+        m_buffer.reserve(StreamingExporter::BUFFER_BYTES * 2);
+    }
+
+    ~Sink()
+    {
+#ifdef XFB_HAVE_ZLIB
+        if (m_deflating) {
+            deflateEnd(&m_stream);
+        }
+#endif
+    }
+
+    bool open()
+    {
+        if (!m_gzip) {
+            return true;
+        }
+#ifdef XFB_HAVE_ZLIB
+        // 16 over the window bits asks zlib for a gzip header and trailer
+        if (deflateInit2(&m_stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+                         Z_DEFAULT_STRATEGY) != Z_OK) {
+            m_error = "Cannot start the gzip compression";
+            return false;
+        }
+        m_deflating = true;
+        m_output.resize(StreamingExporter::BUFFER_BYTES);
+        return true;
+#else
+        m_error = "This build cannot write gzip files";
+        return false;
+#endif
+    }
+
+    QByteArray& buffer() { return m_buffer; }
+
+    bool flushIfFull()
+    {
+        return m_buffer.size() < StreamingExporter::BUFFER_BYTES || write(false);
+    }
+
+    bool finish() { return write(true); }
+
+    QString error() const { return m_error; }
+
+private:
+    bool write(bool last)
+    {
+        if (!m_gzip) {
+            if (m_file.write(m_buffer) != m_buffer.size()) {
+                m_error = m_file.errorString();
+                return false;
+            }
+            m_buffer.clear();
+            return true;
+        }
+#ifdef XFB_HAVE_ZLIB
+        m_stream.next_in = reinterpret_cast<Bytef*>(m_buffer.data());
+        m_stream.avail_in = uInt(m_buffer.size());
+        int status = Z_OK;
+        do {
+            m_stream.next_out = reinterpret_cast<Bytef*>(m_output.data());
+            m_stream.avail_out = uInt(m_output.size());
+            status = deflate(&m_stream, last ? Z_FINISH : Z_NO_FLUSH);
+            if (status == Z_STREAM_ERROR) {
+                m_error = "gzip compression failed";
+                return false;
+            }
+            const qint64 produced = m_output.size() - qint64(m_stream.avail_out);
+            if (m_file.write(m_output.constData(), produced) != produced) {
+                m_error = m_file.errorString();
+                return false;
+            }
+        } while (m_stream.avail_out == 0 || (last && status != Z_STREAM_END));
+        m_buffer.clear();
+        return true;
+#else
+        Q_UNUSED(last);
+        return false;
+#endif
+    }
+
+    QFile& m_file;
+    bool m_gzip;
+    QByteArray m_buffer;
+    QString m_error;
+#ifdef XFB_HAVE_ZLIB
+    z_stream m_stream = {};
+    QByteArray m_output;
+    bool m_deflating = false;
+#endif
+};
+
+void appendCsvField(QByteArray& out, const QVariant& value)
+{
+    if (value.isNull()) {
+        return;
+    }
+    const QByteArray text = value.toString().toUtf8();
+    if (!text.contains(',') && !text.contains('"') && !text.contains('\n') &&
+        !text.contains('\r')) {
+        out += text;
+        return;
+    }
+    out += '"';
+    for (char c : text) {
+        if (c == '"') {
+            out += '"';
+        }
+        out += c;
+    }
+    out += '"';
+}
+
+void appendJsonString(QByteArray& out, const QString& text)
+{
+    static const char hex[] = "0123456789abcdef";
+    out += '"';
+    for (char c : text.toUtf8()) {
+        switch (c) {
+        case '"':
+            out += "\\\"";
+            break;
+        case '\\':
+            out += "\\\\";
+            break;
+        case '\n':
+            out += "\\n";
+            break;
+        case '\r':
+            out += "\\r";
+            break;
+        case '\t':
+            out += "\\t";
+            break;
+        default:
+            if (uchar(c) < 0x20) {
+                out += "\\u00";
+                out += hex[uchar(c) >> 4];
+                out += hex[uchar(c) & 0xf];
+            } else {
+                out += c;
+            }
+        }
+    }
+    out += '"';
+}
+
+void appendJsonValue(QByteArray& out, const QVariant& value)
+{
+    if (value.isNull()) {
+        out += "null";
+        return;
+    }
+    switch (value.metaType().id()) {
+    case QMetaType::Int:
+    case QMetaType::UInt:
+    case QMetaType::LongLong:
+    case QMetaType::ULongLong:
+        out += value.toString().toUtf8();
+        return;
+    case QMetaType::Double: {
+        const double number = value.toDouble();
+        if (std::isfinite(number)) {
+            out += QByteArray::number(number, 'g', QLocale::FloatingPointShortest);
+        } else {
+            out += "null";
+        }
+        return;
+    }
+    case QMetaType::Bool:
+        out += value.toBool() ? "true" : "false";
+        return;
+    default:
+        appendJsonString(out, value.toString());
+    }
+}
+
+/// Total rows of the export, for the progress; -1 if the count fails
+qint64 countRows(const QSqlDatabase& database, const StreamingExporter::Job& job)
+{
+    QSqlQuery query(database);
+    query.setForwardOnly(true);
+    query.prepare(QString("SELECT COUNT(*) FROM (%1)").arg(job.query));
+    for (const QVariant& value : job.bindValues) {
+        query.addBindValue(value);
+    }
+    return query.exec() && query.next() ? query.value(0).toLongLong() : -1;
+}
+
+StreamingExporter::Result exportRows(const QSqlDatabase& database,
+                                     const StreamingExporter::Job& job, QFile& file,
+                                     const StreamingExporter::ProgressCallback& progress,
+                                     const std::atomic_bool* cancelled)
+{
+    StreamingExporter::Result result;
+    const qint64 total = progress ? countRows(database, job) : -1;
+
+    QSqlQuery query(database);
+    query.setForwardOnly(true);
+    if (!query.prepare(job.query)) {
+        result.error = query.lastError().text();
+        return result;
+    }
+    for (const QVariant& value : job.bindValues) {
+        query.addBindValue(value);
+    }
+    if (!query.exec()) {
+        result.error = query.lastError().text();
+        return result;
+    }
+
+    Sink sink(file, job.gzip);
+    if (!sink.open()) {
+        result.error = sink.error();
+        return result;
+    }
+    QByteArray& out = sink.buffer();
+
+    const QSqlRecord record = query.record();
+    QVector<QString> names;
+    for (int column = 0; column < record.count(); ++column) {
+        names.append(record.fieldName(column));
+    }
+    if (job.format == StreamingExporter::Format::Csv) {
+        for (int column = 0; column < names.size(); ++column) {
+            if (column > 0) {
+                out += ',';
+            }
+            appendCsvField(out, names.at(column));
+        }
+        out += "\r\n";
+    }
+
+    while (query.next()) {
+        if (cancelled && cancelled->load()) {
+            result.cancelled = true;
+            return result;
+        }
+        if (job.format == StreamingExporter::Format::Csv) {
+            for (int column = 0; column < names.size(); ++column) {
+                if (column > 0) {
+                    out += ',';
+                }
+                appendCsvField(out, query.value(column));
+            }
+            out += "\r\n";
+        } else {
+            out += '{';
+            for (int column = 0; column < names.size(); ++column) {
+                if (column > 0) {
+                    out += ',';
+                }
+                appendJsonString(out, names.at(column));
+                out += ':';
+                appendJsonValue(out, query.value(column));
+            }
+            out += "}\n";
+        }
+        ++result.rows;
+
+        if (!sink.flushIfFull()) {
+            result.error = sink.error();
+            return result;
+        }
+        if (progress && result.rows % StreamingExporter::PROGRESS_ROWS == 0) {
+            progress(result.rows, total);
+        }
+    }
+    if (query.lastError().isValid()) {
+        result.error = query.lastError().text();
+        return result;
+    }
+    if (!sink.finish()) {
+        result.error = sink.error();
+        return result;
+    }
+    if (progress) {
+        progress(result.rows, total);
+    }
+    return result;
+}
+
+} // namespace
+
+StreamingExporter::StreamingExporter(QObject* parent)
+    : QObject(parent)
+    , m_cancelled(std::make_shared<std::atomic_bool>(false))
+{
+    connect(&m_watcher, &QFutureWatcher<Result>::finished, this, &StreamingExporter::onFinished);
+}
+
+StreamingExporter::~StreamingExporter()
+{
+    m_cancelled->store(true);
+    m_watcher.disconnect(this);
+    m_watcher.waitForFinished();
+}
+
+StreamingExporter::Job StreamingExporter::libraryJob(const QString& databasePath,
+                                                     const QString& outputPath, Format format,
+                                                     bool gzip)
+{
+    Job job;
+    job.databasePath = databasePath;
+    job.query = "SELECT id, artist, song, genre1, genre2, country, published_date, path, time, "
+                "played_times, last_played FROM musics ORDER BY id";
+    job.outputPath = outputPath;
+    job.format = format;
+    job.gzip = gzip;
+    return job;
+}
+
+StreamingExporter::Job StreamingExporter::playsJob(const QString& partitionPath,
+                                                   const QString& outputPath, Format format,
+                                                   bool gzip)
+{
+    Job job;
+    job.databasePath = partitionPath;
+    job.query = "SELECT strftime('%Y-%m-%d %H:%M:%S', played_at / 1000, 'unixepoch', 'localtime') "
+                "AS played_at, path, music_id, artist, song, duration FROM plays "
+                "ORDER BY plays.played_at, id";
+    job.outputPath = outputPath;
+    job.format = format;
+    job.gzip = gzip;
+    return job;
+}
+
+bool StreamingExporter::isGzipAvailable()
+{
+#ifdef XFB_HAVE_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool StreamingExporter::start(const Job& job)
+{
+    if (m_watcher.isRunning()) {
+        return false;
+    }
+    m_cancelled->store(false);
+
+    // Progress crosses to this thread as queued calls, dropped if the exporter is gone
+    QPointer<StreamingExporter> self(this);
+    const ProgressCallback progress = [self](qint64 rows, qint64 total) {
+        QMetaObject::invokeMethod(
+            self.data(),
+            [self, rows, total]() {
+                if (self) {
+                    emit self->progressChanged(rows, total);
+                }
+            },
+            Qt::QueuedConnection);
+    };
+    m_watcher.setFuture(QtConcurrent::run([job, progress, cancelled = m_cancelled]() {
+        return run(job, progress, cancelled.get());
+    }));
+    return true;
+}
+
+void StreamingExporter::cancel()
+{
+    m_cancelled->store(true);
+}
+
+StreamingExporter::Result StreamingExporter::run(const Job& job, const ProgressCallback& progress,
+                                                 const std::atomic_bool* cancelled)
+{
+    Result result;
+    result.outputPath = job.outputPath;
+    if (job.outputPath.isEmpty() || job.query.isEmpty()) {
+        result.error = "Nothing to export";
+        return result;
+    }
+
+    const QString partPath = job.outputPath + PART_SUFFIX;
+    QFile file(partPath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        result.error = file.errorString();
+        return result;
+    }
+
+    // Opened and removed on the export's pool thread; a name of its own lets exports overlap
+    const QString connectionName = "xfb_export_" + QUuid::createUuid().toString(QUuid::Id128);
+    {
+        QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+        database.setDatabaseName(job.databasePath);
+        database.setConnectOptions("QSQLITE_OPEN_READONLY;QSQLITE_BUSY_TIMEOUT=5000");
+        if (database.open()) {
+            const Result exported = exportRows(database, job, file, progress, cancelled);
+            result.rows = exported.rows;
+            result.cancelled = exported.cancelled;
+            result.error = exported.error;
+        } else {
+            result.error = database.lastError().text();
+        }
+        database.close();
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+
+    result.bytes = file.size();
+    file.close();
+    if (result.succeeded()) {
+        // rename() puts the file in place in one step, over an older export of the same name
+        std::error_code renameError;
+        std::filesystem::rename(QFile(partPath).filesystemFileName(),
+                                QFile(job.outputPath).filesystemFileName(), renameError);
+        if (renameError) {
+            result.error = QString("Cannot move the export into place: %1")
+                               .arg(QString::fromStdString(renameError.message()));
+        }
+    }
+    if (!result.succeeded()) {
+        QFile::remove(partPath);
+        if (!result.error.isEmpty()) {
+            qWarning() << "StreamingExporter: cannot export to" << job.outputPath << result.error;
+        }
+    }
+    return result;
+}
+
+void StreamingExporter::onFinished()
+{
+    emit finished(m_watcher.result());
+}
@@ -0,0 +1,146 @@
+#ifndef STREAMINGEXPORTER_H
+#define STREAMINGEXPORTER_H
+
+#include <QFutureWatcher>
+#include <QObject>
+#include <QString>
+#include <QVariantList>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+/**
+ * @brief Writes the rows of a query to a CSV or JSON lines file in the background
+ *
+ * Exporting the library or a month of plays used to mean copying the
+ * database file. StreamingExporter runs a query on a read-only connection
+ * of its own, on a worker thread, and writes each row as it is read: rows
+ * are collected in a buffer of BUFFER_BYTES that is written out whenever it
+ * fills, so the memory used stays the same however many rows there are.
+ *
+ * CSV files start with the column names and quote fields as RFC 4180 says.
+ * JSON lines files hold one object per row, keyed by column name, with
+ * numbers and nulls kept as such. With gzip set the output is compressed
+ * on the way out; this needs a build with zlib, see isGzipAvailable().
+ *
+ * The file is written under a ".part" name and renamed once complete, so a
+ * failed or cancelled export leaves no half file behind. progressChanged()
+ * is emitted every PROGRESS_ROWS rows, against a total counted first.
+ *
+ * @example
+ * @code
+ * StreamingExporter* exporter = new StreamingExporter(this);
+ * connect(exporter, &StreamingExporter::finished, this, &Window::exportDone);
+ * exporter->start(StreamingExporter::libraryJob(databasePath, "/tmp/library.csv.gz",
+ *                                               StreamingExporter::Format::Csv, true));
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class StreamingExporter : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int BUFFER_BYTES = 64 * 1024;
+    static constexpr int PROGRESS_ROWS = 1000;
+
+    enum class Format {
+        Csv,
+        JsonLines
+    };
+
+    /**
+     * @brief What to export and where
+     */
+    struct Job {
+        QString databasePath;      ///< Database file the query runs on
+        QString query;             ///< SELECT statement, with ? placeholders
+        QVariantList bindValues;   ///< Values for the placeholders, in order
+        QString outputPath;
+        Format format = Format::Csv;
+        bool gzip = false;
+    };
+
+    /**
+     * @brief How an export ended
+     */
+    struct Result {
+        QString outputPath;
+        qint64 rows = 0;
+        qint64 bytes = 0;          ///< Size of the file written
+        bool cancelled = false;
+        QString error;             ///< Empty on success
+
+        bool succeeded() const { return error.isEmpty() && !cancelled; }
+    };
+
+    /// Called from the worker thread with the rows written and the total
+    using ProgressCallback = std::function<void(qint64 rows, qint64 total)>;
+
+    explicit StreamingExporter(QObject* parent = nullptr);
+    ~StreamingExporter() override;
+
+    /**
+     * @brief Job exporting every track of the musics table
+     */
+    static Job libraryJob(const QString& databasePath, const QString& outputPath, Format format,
+                          bool gzip = false);
+
+    /**
+     * @brief Job exporting the plays of a monthly history file, oldest first
+     * @param partitionPath File of the month, as PlayHistory::partitionPath() gives it
+     */
+    static Job playsJob(const QString& partitionPath, const QString& outputPath, Format format,
+                        bool gzip = false);
+
+    /**
+     * @brief Check whether this build can write gzip files
+     */
+    static bool isGzipAvailable();
+
+    /**
+     * @brief Start an export on a worker thread
+     * @return false if an export is already running
+     */
+    bool start(const Job& job);
+
+    /**
+     * @brief Stop the running export; finished() reports it as cancelled
+     */
+    void cancel();
+
+    bool isRunning() const { return m_watcher.isRunning(); }
+
+    /**
+     * @brief Run an export on the calling thread
+     * @param job What to export
+     * @param progress Called every PROGRESS_ROWS rows and at the end; may be empty
+     * @param cancelled Set from another thread to stop early; may be nullptr
+     */
+    static Result run(const Job& job, const ProgressCallback& progress = ProgressCallback(),
+                      const std::atomic_bool* cancelled = nullptr);
+
+signals:
+    /**
+     * @brief Emitted as rows are written
+     * @param rows Rows written so far
+     * @param total Rows the query returns, or -1 if they could not be counted
+     */
+    void progressChanged(qint64 rows, qint64 total);
+
+    /**
+     * @brief Emitted when the export ended, whether it succeeded or not
+     */
+    void finished(const StreamingExporter::Result& result);
+
+private:
+    void onFinished();
+
+    QFutureWatcher<Result> m_watcher;
+    std::shared_ptr<std::atomic_bool> m_cancelled;
+};
+
+Q_DECLARE_METATYPE(StreamingExporter::Result)
+
+#endif // STREAMINGEXPORTER_H
@@ -1,6 +1,7 @@
 #include "SystemStatusAnnouncer.h"
 #include "LiveRegionManager.h"
 #include "AccessibilityManager.h"
+#include "AnnouncementBus.h"
 #include "AudioFeedbackService.h"
 #include "ServiceContainer.h"
 #include <QDateTime>
@@ -12,8 +13,6 @@ SystemStatusAnnouncer::SystemStatusAnnouncer(QObject* parent)
     , m_liveRegionManager(nullptr)
     , m_accessibilityManager(nullptr)
     , m_audioFeedbackService(nullptr)
-    , m_queueProcessingTimer(nullptr)
-    , m_progressUpdateTimer(nullptr)
     , m_criticalAlertRepeatTimer(nullptr)
     , m_isProcessingQueue(false)
     , m_currentVerbosityLevel(1)
@@ -118,48 +117,19 @@ QString SystemStatusAnnouncer::getServiceName() const
 
 void SystemStatusAnnouncer::initializeAnnouncementSystem()
 {
-    // Create queue processing timer
-    m_queueProcessingTimer = new QTimer(this);
-    m_queueProcessingTimer->setInterval(QUEUE_PROCESSING_INTERVAL_MS);
-    m_queueProcessingTimer->setSingleShot(false);
-    connect(m_queueProcessingTimer, &QTimer::timeout, this, &SystemStatusAnnouncer::processAnnouncementQueue);
-    
-    // Create progress update timer
-    m_progressUpdateTimer = new QTimer(this);
-    m_progressUpdateTimer->setInterval(m_config.progressUpdateIntervalMs);
-    m_progressUpdateTimer->setSingleShot(false);
-    connect(m_progressUpdateTimer, &QTimer::timeout, this, &SystemStatusAnnouncer::onProgressUpdateTimer);
+    // Queued announcements wait on AnnouncementBus, which is armed only while one does
+    AnnouncementBus::instance();
     
     // Create critical alert repeat timer
     m_criticalAlertRepeatTimer = new QTimer(this);
     m_criticalAlertRepeatTimer->setInterval(m_config.criticalAlertRepeatIntervalMs);
     m_criticalAlertRepeatTimer->setSingleShot(false);
     connect(m_criticalAlertRepeatTimer, &QTimer::timeout, this, &SystemStatusAnnouncer::onCriticalAlertRepeatTimer);
-    
-    // Start timers if enabled
-    if (m_config.enabled) {
-        m_queueProcessingTimer->start();
-        if (m_config.progressUpdatesEnabled) {
-            m_progressUpdateTimer->start();
-        }
-    }
 }
 
 void SystemStatusAnnouncer::shutdownAnnouncementSystem()
 {
     // Stop and cleanup timers
-    if (m_queueProcessingTimer) {
-        m_queueProcessingTimer->stop();
-        m_queueProcessingTimer->deleteLater();
-        m_queueProcessingTimer = nullptr;
-    }
-    
-    if (m_progressUpdateTimer) {
-        m_progressUpdateTimer->stop();
-        m_progressUpdateTimer->deleteLater();
-        m_progressUpdateTimer = nullptr;
-    }
-    
     if (m_criticalAlertRepeatTimer) {
         m_criticalAlertRepeatTimer->stop();
         m_criticalAlertRepeatTimer->deleteLater();
@@ -551,29 +521,12 @@ void SystemStatusAnnouncer::setConfig(const AnnouncementConfig& config)
     m_config = config;
     
     // Update timer intervals
-    if (m_progressUpdateTimer) {
-        m_progressUpdateTimer->setInterval(config.progressUpdateIntervalMs);
-        if (config.enabled && config.progressUpdatesEnabled) {
-            if (!m_progressUpdateTimer->isActive()) {
-                m_progressUpdateTimer->start();
-            }
-        } else {
-            m_progressUpdateTimer->stop();
-        }
-    }
-    
     if (m_criticalAlertRepeatTimer) {
         m_criticalAlertRepeatTimer->setInterval(config.criticalAlertRepeatIntervalMs);
     }
     
-    if (m_queueProcessingTimer) {
-        if (config.enabled) {
-            if (!m_queueProcessingTimer->isActive()) {
-                m_queueProcessingTimer->start();
-            }
-        } else {
-            m_queueProcessingTimer->stop();
-        }
+    if (!config.enabled) {
+        clearAnnouncementQueue(false);
     }
     
     saveConfiguration();
@@ -587,20 +540,7 @@ void SystemStatusAnnouncer::setEnabled(bool enabled)
     
     m_config.enabled = enabled;
     
-    if (enabled) {
-        if (m_queueProcessingTimer && !m_queueProcessingTimer->isActive()) {
-            m_queueProcessingTimer->start();
-        }
-        if (m_progressUpdateTimer && m_config.progressUpdatesEnabled && !m_progressUpdateTimer->isActive()) {
-            m_progressUpdateTimer->start();
-        }
-    } else {
-        if (m_queueProcessingTimer) {
-            m_queueProcessingTimer->stop();
-        }
-        if (m_progressUpdateTimer) {
-            m_progressUpdateTimer->stop();
-        }
+    if (!enabled) {
         if (m_criticalAlertRepeatTimer) {
             m_criticalAlertRepeatTimer->stop();
         }
@@ -652,29 +592,12 @@ void SystemStatusAnnouncer::setCriticalAlertsEnabled(bool enabled)
 
 void SystemStatusAnnouncer::clearAnnouncementQueue(bool preserveCritical)
 {
-    QMutexLocker locker(&m_queueMutex);
-    
-    if (!preserveCritical) {
-        m_announcementQueue.clear();
-        return;
-    }
-    
-    // Remove non-critical announcements
-    QQueue<QueuedAnnouncement> filteredQueue;
-    while (!m_announcementQueue.isEmpty()) {
-        QueuedAnnouncement announcement = m_announcementQueue.dequeue();
-        if (announcement.priority >= Priority::Critical) {
-            filteredQueue.enqueue(announcement);
-        }
-    }
-    
-    m_announcementQueue = filteredQueue;
+    AnnouncementBus::instance()->clear(this, preserveCritical);
 }
 
 int SystemStatusAnnouncer::getQueuedAnnouncementCount() const
 {
-    QMutexLocker locker(const_cast<QMutex*>(&m_queueMutex));
-    return m_announcementQueue.size();
+    return AnnouncementBus::instance()->pendingCount(this);
 }
 
 void SystemStatusAnnouncer::onAccessibilityStateChanged(bool enabled)
@@ -699,39 +622,6 @@ void SystemStatusAnnouncer::onVerbosityLevelChanged(int level)
     qDebug() << "SystemStatusAnnouncer: Verbosity level changed to" << level;
 }
 
-void SystemStatusAnnouncer::processAnnouncementQueue()
-{
-    if (m_isProcessingQueue || !m_config.enabled) {
-        return;
-    }
-    
-    QMutexLocker locker(&m_queueMutex);
-    
-    if (m_announcementQueue.isEmpty()) {
-        return;
-    }
-    
-    m_isProcessingQueue = true;
-    
-    // Process a limited number of announcements per cycle
-    const int maxAnnouncementsPerCycle = 3;
-    int processed = 0;
-    
-    while (!m_announcementQueue.isEmpty() && processed < maxAnnouncementsPerCycle) {
-        QueuedAnnouncement announcement = m_announcementQueue.dequeue();
-        processAnnouncement(announcement);
-        processed++;
-    }
-    
-    m_isProcessingQueue = false;
-}
-
-void SystemStatusAnnouncer::onProgressUpdateTimer()
-{
-    // This timer can be used for periodic progress checks if needed
-    // Currently, progress updates are handled through direct calls
-}
-
 void SystemStatusAnnouncer::onCriticalAlertRepeatTimer()
 {
     if (!m_hasPendingCriticalAlert || !m_config.criticalAlertsEnabled) {
@@ -752,14 +642,45 @@ void SystemStatusAnnouncer::onCriticalAlertRepeatTimer()
 
 void SystemStatusAnnouncer::queueAnnouncement(const QueuedAnnouncement& announcement)
 {
-    QMutexLocker locker(&m_queueMutex);
+    AnnouncementBus* bus = AnnouncementBus::instance();
     
-    // Check for queue overflow
-    if (m_announcementQueue.size() >= m_config.maxQueuedAnnouncements) {
-        handleQueueOverflow();
+    // Check for queue overflow; low-priority announcements give way
+    if (bus->pendingCount(this) >= m_config.maxQueuedAnnouncements
+        && announcement.priority < Priority::Normal) {
+        return;
     }
     
-    m_announcementQueue.enqueue(announcement);
+    // A component's newer status replaces the one still waiting
+    AnnouncementBus::Announcement item;
+    item.region = QStringLiteral("system-status:") + announcement.component;
+    item.message = announcement.status + QLatin1Char('\n') + announcement.additionalInfo;
+    item.priority = toBusPriority(announcement.priority);
+    item.context = this;
+    item.deliver = [this, announcement](const AnnouncementBus::Announcement&) {
+        if (!m_config.enabled) {
+            return;
+        }
+        m_isProcessingQueue = true;
+        processAnnouncement(announcement);
+        m_isProcessingQueue = false;
+    };
+    bus->post(item);
+}
+
+AnnouncementBus::Priority SystemStatusAnnouncer::toBusPriority(Priority priority)
+{
+    switch (priority) {
+        case Priority::Low:
+            return AnnouncementBus::Priority::Low;
+        case Priority::Normal:
+            return AnnouncementBus::Priority::Normal;
+        case Priority::High:
+            return AnnouncementBus::Priority::High;
+        case Priority::Critical:
+        case Priority::Emergency:
+            break;
+    }
+    return AnnouncementBus::Priority::Critical;
 }
 
 void SystemStatusAnnouncer::processAnnouncement(const QueuedAnnouncement& announcement)
@@ -926,25 +847,6 @@ bool SystemStatusAnnouncer::shouldProcessImmediately(Priority priority) const
     return priority >= Priority::High || (m_config.allowCriticalInterruption && priority >= Priority::Critical);
 }
 
-int SystemStatusAnnouncer::handleQueueOverflow()
-{
-    int removed = 0;
-    
-    // Remove low-priority announcements first
-    QQueue<QueuedAnnouncement> filteredQueue;
-    while (!m_announcementQueue.isEmpty()) {
-        QueuedAnnouncement announcement = m_announcementQueue.dequeue();
-        if (announcement.priority >= Priority::Normal) {
-            filteredQueue.enqueue(announcement);
-        } else {
-            removed++;
-        }
-    }
-    
-    m_announcementQueue = filteredQueue;
-    return removed;
-}
-
 void SystemStatusAnnouncer::loadConfiguration()
 {
     QSettings settings;
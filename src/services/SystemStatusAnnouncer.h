@@ -1,11 +1,10 @@
 #ifndef SYSTEMSTATUSANNOUNCER_H
 #define SYSTEMSTATUSANNOUNCER_H
 
+#include "AnnouncementBus.h"
 #include "BaseService.h"
 #include <QObject>
 #include <QTimer>
-#include <QQueue>
-#include <QMutex>
 
 class LiveRegionManager;
 class AccessibilityManager;
@@ -319,16 +318,6 @@ protected:
     QString getServiceName() const override;
 
 private slots:
-    /**
-     * @brief Process queued announcements
-     */
-    void processAnnouncementQueue();
-
-    /**
-     * @brief Handle progress update timer
-     */
-    void onProgressUpdateTimer();
-
     /**
      * @brief Handle critical alert repeat timer
      */
@@ -369,11 +358,16 @@ private:
     void shutdownAnnouncementSystem();
 
     /**
-     * @brief Queue an announcement for processing
+     * @brief Queue an announcement on AnnouncementBus, replacing the component's waiting one
      * @param announcement The announcement to queue
      */
     void queueAnnouncement(const QueuedAnnouncement& announcement);
 
+    /**
+     * @brief AnnouncementBus priority of an announcement; Emergency maps to Critical
+     */
+    static AnnouncementBus::Priority toBusPriority(Priority priority);
+
     /**
      * @brief Process a single announcement
      * @param announcement The announcement to process
@@ -415,12 +409,6 @@ private:
      */
     bool shouldProcessImmediately(Priority priority) const;
 
-    /**
-     * @brief Handle queue overflow by removing low-priority items
-     * @return Number of items removed
-     */
-    int handleQueueOverflow();
-
     /**
      * @brief Load configuration from settings
      */
@@ -448,11 +436,7 @@ private:
     AudioFeedbackService* m_audioFeedbackService;
     
     // Announcement queue management
-    QQueue<QueuedAnnouncement> m_announcementQueue;
-    QTimer* m_queueProcessingTimer;
-    QTimer* m_progressUpdateTimer;
     QTimer* m_criticalAlertRepeatTimer;
-    QMutex m_queueMutex;
     
     // State tracking
     bool m_isProcessingQueue;
@@ -466,7 +450,6 @@ private:
     qint64 m_lastProgressUpdate;
     
     // Constants
-    static constexpr int QUEUE_PROCESSING_INTERVAL_MS = 500;
     static constexpr int DEFAULT_PROGRESS_UPDATE_INTERVAL_MS = 5000;
     static constexpr int DEFAULT_CRITICAL_ALERT_REPEAT_INTERVAL_MS = 30000;
     static constexpr int MAX_QUEUED_ANNOUNCEMENTS = 20;
@@ -0,0 +1,140 @@
+#include "TableChangeBus.h"
+#include <QCoreApplication>
+#include <QPointer>
+#include <QThread>
+#include <QTimer>
+#include <algorithm>
+
+namespace {
+
+QList<qint64> sorted(const QSet<qint64>& keys)
+{
+    QList<qint64> list(keys.cbegin(), keys.cend());
+    std::sort(list.begin(), list.end());
+    return list;
+}
+
+} // namespace
+
+TableChangeBus* TableChangeBus::instance()
+{
+    static QPointer<TableChangeBus> bus;
+    if (!bus) {
+        bus = new TableChangeBus(QCoreApplication::instance());
+    }
+    return bus;
+}
+
+TableChangeBus::TableChangeBus(QObject* parent)
+    : QObject(parent)
+    , m_timer(new QTimer(this))
+{
+    qRegisterMetaType<TableChangeBus::Change>();
+    m_timer->setSingleShot(true);
+    m_timer->setInterval(0);
+    connect(m_timer, &QTimer::timeout, this, &TableChangeBus::flush);
+}
+
+void TableChangeBus::notifyChanged(const QString& table, const QList<qint64>& keys)
+{
+    if (table.isEmpty() || keys.isEmpty()) {
+        return;
+    }
+    if (QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(
+            this, [this, table, keys]() { notifyChanged(table, keys); }, Qt::QueuedConnection);
+        return;
+    }
+
+    Pending& waiting = pending(table);
+    if (waiting.reset) {
+        return;
+    }
+    for (qint64 key : keys) {
+        waiting.removed.remove(key);
+        waiting.changed.insert(key);
+    }
+    limit(waiting);
+}
+
+void TableChangeBus::notifyRemoved(const QString& table, const QList<qint64>& keys)
+{
+    if (table.isEmpty() || keys.isEmpty()) {
+        return;
+    }
+    if (QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(
+            this, [this, table, keys]() { notifyRemoved(table, keys); }, Qt::QueuedConnection);
+        return;
+    }
+
+    Pending& waiting = pending(table);
+    if (waiting.reset) {
+        return;
+    }
+    for (qint64 key : keys) {
+        waiting.changed.remove(key);
+        waiting.removed.insert(key);
+    }
+    limit(waiting);
+}
+
+void TableChangeBus::notifyReset(const QString& table)
+{
+    if (table.isEmpty()) {
+        return;
+    }
+    if (QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(
+            this, [this, table]() { notifyReset(table); }, Qt::QueuedConnection);
+        return;
+    }
+
+    Pending& waiting = pending(table);
+    waiting.reset = true;
+    waiting.changed.clear();
+    waiting.removed.clear();
+}
+
+void TableChangeBus::flush()
+{
+    m_timer->stop();
+
+    // Readers may post again while they apply a change; that goes out next time
+    const QStringList tables = m_order;
+    QHash<QString, Pending> waiting;
+    waiting.swap(m_pending);
+    m_order.clear();
+
+    for (const QString& table : tables) {
+        const Pending& pending = waiting[table];
+        Change change;
+        change.table = table;
+        change.reset = pending.reset;
+        change.changed = sorted(pending.changed);
+        change.removed = sorted(pending.removed);
+        emit tableChanged(change);
+    }
+}
+
+TableChangeBus::Pending& TableChangeBus::pending(const QString& table)
+{
+    auto it = m_pending.find(table);
+    if (it == m_pending.end()) {
+        m_order.append(table);
+        it = m_pending.insert(table, Pending());
+    }
+    if (!m_timer->isActive()) {
+        m_timer->start();
+    }
+    return *it;
+}
+
+void TableChangeBus::limit(Pending& pending)
+{
+    if (pending.changed.size() + pending.removed.size() > MAX_KEYS) {
+        pending.reset = true;
+        pending.changed.clear();
+        pending.removed.clear();
+    }
+}
@@ -0,0 +1,116 @@
+#ifndef TABLECHANGEBUS_H
+#define TABLECHANGEBUS_H
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+class QTimer;
+
+/**
+ * @brief Tells the views which rows of which table changed
+ *
+ * After every dialog or import that wrote to the database the whole window
+ * refreshed all of its tables, and an "Update tables" button was there for
+ * the writes nobody told it about. Code that writes a table now posts what
+ * it changed here, by rowid, and each model and cache that reads the table
+ * applies just that, see LiveTableModel::applyChange().
+ *
+ * Posts are collected and delivered together once control returns to the
+ * event loop, one Change per table, so an import of a thousand rows is
+ * one delivery rather than a thousand. A row changed and then removed in
+ * the same burst is delivered as removed, and the other way round as
+ * changed. When more than MAX_KEYS rows of a table are waiting, or when
+ * the writer does not know which rows it touched, the Change says reset
+ * and readers re-read the table.
+ *
+ * The bus lives on the GUI thread; posts from other threads are queued
+ * to it.
+ *
+ * @example
+ * @code
+ * if (query.exec())
+ *     TableChangeBus::instance()->notifyChanged("musics", {query.lastInsertId().toLongLong()});
+ *
+ * connect(TableChangeBus::instance(), &TableChangeBus::tableChanged, musics,
+ *         &LiveTableModel::applyChange);
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class TableChangeBus : public QObject
+{
+    Q_OBJECT
+
+public:
+    /// Rows of one table delivered one by one; past this the table is re-read
+    static constexpr int MAX_KEYS = 100;
+
+    struct Change {
+        QString table;
+        QList<qint64> changed;   ///< rowids inserted or updated, ascending
+        QList<qint64> removed;   ///< rowids deleted, ascending
+        bool reset = false;      ///< Rows not known; any of them may have changed
+    };
+
+    /**
+     * @brief The bus of the application, made on first use; call it first on the GUI thread
+     */
+    static TableChangeBus* instance();
+
+    explicit TableChangeBus(QObject* parent = nullptr);
+
+    /**
+     * @brief Post rows that were inserted or updated
+     * @param table Name of the table
+     * @param keys rowids of the rows
+     */
+    void notifyChanged(const QString& table, const QList<qint64>& keys);
+
+    /**
+     * @brief Post rows that were deleted
+     */
+    void notifyRemoved(const QString& table, const QList<qint64>& keys);
+
+    /**
+     * @brief Post a change to a table whose rows are not known
+     */
+    void notifyReset(const QString& table);
+
+    /**
+     * @brief Deliver what is waiting now rather than from the event loop
+     */
+    void flush();
+
+    /**
+     * @brief Tables with changes waiting
+     */
+    QStringList pendingTables() const { return m_order; }
+
+signals:
+    /**
+     * @brief Emitted once per table with what changed since the last delivery
+     */
+    void tableChanged(const TableChangeBus::Change& change);
+
+private:
+    struct Pending {
+        QSet<qint64> changed;
+        QSet<qint64> removed;
+        bool reset = false;
+    };
+
+    Pending& pending(const QString& table);
+    void limit(Pending& pending);
+
+    QHash<QString, Pending> m_pending;
+    QStringList m_order;   ///< Tables in the order their first change came
+    QTimer* m_timer;
+};
+
+Q_DECLARE_METATYPE(TableChangeBus::Change)
+
+#endif // TABLECHANGEBUS_H
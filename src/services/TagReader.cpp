@@ -0,0 +1,743 @@
+#include "TagReader.h"
+#include "MediaProbe.h"
+#include <QFile>
+#include <QRegularExpression>
+
+namespace {
+
+constexpr int MAX_OGG_PAGES = 256;
+
+enum class Field {
+    None,
+    Artist,
+    Title,
+    Album,
+    Genre,
+    Year
+};
+
+const char* const kGenres[] = {
+    "Blues", "Classic Rock", "Country", "Dance", "Disco", "Funk", "Grunge", "Hip-Hop", "Jazz",
+    "Metal", "New Age", "Oldies", "Other", "Pop", "R&B", "Rap", "Reggae", "Rock", "Techno",
+    "Industrial", "Alternative", "Ska", "Death Metal", "Pranks", "Soundtrack", "Euro-Techno",
+    "Ambient", "Trip-Hop", "Vocal", "Jazz+Funk", "Fusion", "Trance", "Classical", "Instrumental",
+    "Acid", "House", "Game", "Sound Clip", "Gospel", "Noise", "Alternative Rock", "Bass", "Soul",
+    "Punk", "Space", "Meditative", "Instrumental Pop", "Instrumental Rock", "Ethnic", "Gothic",
+    "Darkwave", "Techno-Industrial", "Electronic", "Pop-Folk", "Eurodance", "Dream",
+    "Southern Rock", "Comedy", "Cult", "Gangsta", "Top 40", "Christian Rap", "Pop/Funk", "Jungle",
+    "Native American", "Cabaret", "New Wave", "Psychedelic", "Rave", "Showtunes", "Trailer",
+    "Lo-Fi", "Tribal", "Acid Punk", "Acid Jazz", "Polka", "Retro", "Musical", "Rock & Roll",
+    "Hard Rock",
+    // Winamp extensions
+    "Folk", "Folk-Rock", "National Folk", "Swing", "Fast Fusion", "Bebop", "Latin", "Revival",
+    "Celtic", "Bluegrass", "Avantgarde", "Gothic Rock", "Progressive Rock", "Psychedelic Rock",
+    "Symphonic Rock", "Slow Rock", "Big Band", "Chorus", "Easy Listening", "Acoustic", "Humour",
+    "Speech", "Chanson", "Opera", "Chamber Music", "Sonata", "Symphony", "Booty Bass", "Primus",
+    "Porn Groove", "Satire", "Slow Jam", "Club", "Tango", "Samba", "Folklore", "Ballad",
+    "Power Ballad", "Rhythmic Soul", "Freestyle", "Duet", "Punk Rock", "Drum Solo", "A Cappella",
+    "Euro-House", "Dance Hall", "Goa", "Drum & Bass", "Club-House", "Hardcore", "Terror", "Indie",
+    "BritPop", "Afro-Punk", "Polsk Punk", "Beat", "Christian Gangsta Rap", "Heavy Metal",
+    "Black Metal", "Crossover", "Contemporary Christian", "Christian Rock", "Merengue", "Salsa",
+    "Thrash Metal", "Anime", "JPop", "Synthpop",
+};
+
+quint16 readU16BE(const char* p)
+{
+    const auto* u = reinterpret_cast<const uchar*>(p);
+    return quint16((u[0] << 8) | u[1]);
+}
+
+quint32 readU24BE(const char* p)
+{
+    const auto* u = reinterpret_cast<const uchar*>(p);
+    return (quint32(u[0]) << 16) | (quint32(u[1]) << 8) | quint32(u[2]);
+}
+
+quint32 readU32BE(const char* p)
+{
+    const auto* u = reinterpret_cast<const uchar*>(p);
+    return (quint32(u[0]) << 24) | (quint32(u[1]) << 16) | (quint32(u[2]) << 8) | quint32(u[3]);
+}
+
+quint64 readU64BE(const char* p)
+{
+    return (quint64(readU32BE(p)) << 32) | quint64(readU32BE(p + 4));
+}
+
+quint32 readU32LE(const char* p)
+{
+    const auto* u = reinterpret_cast<const uchar*>(p);
+    return quint32(u[0]) | (quint32(u[1]) << 8) | (quint32(u[2]) << 16) | (quint32(u[3]) << 24);
+}
+
+quint32 readSynchsafe(const char* p)
+{
+    const auto* u = reinterpret_cast<const uchar*>(p);
+    return (quint32(u[0] & 0x7F) << 21) | (quint32(u[1] & 0x7F) << 14) |
+           (quint32(u[2] & 0x7F) << 7) | quint32(u[3] & 0x7F);
+}
+
+QByteArray removeUnsync(const QByteArray& data)
+{
+    // Unsynchronisation inserts a zero after every 0xFF
+    QByteArray result;
+    result.reserve(data.size());
+    for (int i = 0; i < data.size(); ++i) {
+        result.append(data.at(i));
+        if (uchar(data.at(i)) == 0xFF && i + 1 < data.size() && data.at(i + 1) == '\0') {
+            ++i;
+        }
+    }
+    return result;
+}
+
+QString decodeUtf16(const QByteArray& data, bool bigEndian)
+{
+    QString text;
+    text.reserve(data.size() / 2);
+    for (int i = 0; i + 1 < data.size(); i += 2) {
+        const uchar first = uchar(data.at(i));
+        const uchar second = uchar(data.at(i + 1));
+        text.append(QChar(bigEndian ? ushort((first << 8) | second)
+                                    : ushort((second << 8) | first)));
+    }
+    return text;
+}
+
+QString decodeText(const QByteArray& data)
+{
+    // Tags without a declared encoding are usually UTF-8 nowadays, Latin-1 otherwise
+    const QString text = QString::fromUtf8(data);
+    return text.contains(QChar::ReplacementCharacter) ? QString::fromLatin1(data) : text;
+}
+
+QString firstValue(const QString& text)
+{
+    // ID3v2.4 separates several values with a null; the first one is kept
+    return text.section(QChar(0), 0, 0).trimmed();
+}
+
+QString decodeId3Text(const QByteArray& frame)
+{
+    if (frame.isEmpty()) {
+        return QString();
+    }
+
+    QByteArray data = frame.mid(1);
+    switch (frame.at(0)) {
+    case 1: {
+        bool bigEndian = false;
+        if (data.size() >= 2 && uchar(data.at(0)) == 0xFE && uchar(data.at(1)) == 0xFF) {
+            bigEndian = true;
+            data.remove(0, 2);
+        } else if (data.size() >= 2 && uchar(data.at(0)) == 0xFF && uchar(data.at(1)) == 0xFE) {
+            data.remove(0, 2);
+        }
+        return firstValue(decodeUtf16(data, bigEndian));
+    }
+    case 2:
+        return firstValue(decodeUtf16(data, true));
+    case 3:
+        return firstValue(QString::fromUtf8(data));
+    default:
+        return firstValue(QString::fromLatin1(data));
+    }
+}
+
+QString resolveGenre(const QString& text)
+{
+    // "(17)", "(17)Rock" and "17" refer to ID3v1 genres; a refinement after the number wins
+    static const QRegularExpression reference("^\\((\\d+|RX|CR)\\)(.*)$");
+    const QRegularExpressionMatch match = reference.match(text);
+    if (match.hasMatch()) {
+        const QString refinement = match.captured(2).trimmed();
+        if (!refinement.isEmpty()) {
+            return refinement;
+        }
+        const QString code = match.captured(1);
+        if (code == "RX") {
+            return "Remix";
+        }
+        if (code == "CR") {
+            return "Cover";
+        }
+        return TagReader::genreName(code.toInt());
+    }
+
+    bool isNumber = false;
+    const int index = text.toInt(&isNumber);
+    if (isNumber) {
+        const QString name = TagReader::genreName(index);
+        return name.isEmpty() ? text : name;
+    }
+    return text;
+}
+
+QString yearOf(const QString& date)
+{
+    const QString year = date.trimmed().left(4);
+    if (year.size() != 4) {
+        return QString();
+    }
+    for (const QChar c : year) {
+        if (!c.isDigit()) {
+            return QString();
+        }
+    }
+    return year;
+}
+
+void assign(TagReader::Tags& tags, Field field, const QString& value)
+{
+    // The first tag that has a field wins; later fallbacks only fill gaps
+    QString* target = nullptr;
+    QString text = value.trimmed();
+    switch (field) {
+    case Field::Artist:
+        target = &tags.artist;
+        break;
+    case Field::Title:
+        target = &tags.title;
+        break;
+    case Field::Album:
+        target = &tags.album;
+        break;
+    case Field::Genre:
+        target = &tags.genre;
+        break;
+    case Field::Year:
+        target = &tags.year;
+        text = yearOf(text);
+        break;
+    case Field::None:
+        return;
+    }
+    if (target->isEmpty() && !text.isEmpty()) {
+        *target = text;
+    }
+}
+
+void markFormat(TagReader::Tags& tags, const QString& format)
+{
+    if (tags.format.isEmpty() && tags.hasTags()) {
+        tags.format = format;
+    }
+}
+
+Field id3Field(const QByteArray& id)
+{
+    if (id == "TPE1" || id == "TP1") {
+        return Field::Artist;
+    }
+    if (id == "TIT2" || id == "TT2") {
+        return Field::Title;
+    }
+    if (id == "TALB" || id == "TAL") {
+        return Field::Album;
+    }
+    if (id == "TCON" || id == "TCO") {
+        return Field::Genre;
+    }
+    if (id == "TYER" || id == "TYE" || id == "TDRC") {
+        return Field::Year;
+    }
+    return Field::None;
+}
+
+Field vorbisField(const QByteArray& key)
+{
+    if (key == "ARTIST") {
+        return Field::Artist;
+    }
+    if (key == "TITLE") {
+        return Field::Title;
+    }
+    if (key == "ALBUM") {
+        return Field::Album;
+    }
+    if (key == "GENRE") {
+        return Field::Genre;
+    }
+    if (key == "DATE" || key == "YEAR") {
+        return Field::Year;
+    }
+    return Field::None;
+}
+
+Field mp4Field(const QByteArray& type)
+{
+    if (type == "\xA9" "ART") {
+        return Field::Artist;
+    }
+    if (type == "\xA9nam") {
+        return Field::Title;
+    }
+    if (type == "\xA9" "alb") {
+        return Field::Album;
+    }
+    if (type == "\xA9" "gen" || type == "gnre") {
+        return Field::Genre;
+    }
+    if (type == "\xA9" "day") {
+        return Field::Year;
+    }
+    return Field::None;
+}
+
+Field wavField(const QByteArray& id)
+{
+    if (id == "IART") {
+        return Field::Artist;
+    }
+    if (id == "INAM") {
+        return Field::Title;
+    }
+    if (id == "IPRD") {
+        return Field::Album;
+    }
+    if (id == "IGNR") {
+        return Field::Genre;
+    }
+    if (id == "ICRD") {
+        return Field::Year;
+    }
+    return Field::None;
+}
+
+void readVorbisComment(const QByteArray& data, TagReader::Tags& tags)
+{
+    // A comment cut short by the size cap ends at the last complete entry
+    const char* p = data.constData();
+    const qint64 size = data.size();
+    if (size < 8) {
+        return;
+    }
+    qint64 pos = 4 + qint64(readU32LE(p));
+    if (pos + 4 > size) {
+        return;
+    }
+    const quint32 count = readU32LE(p + pos);
+    pos += 4;
+
+    for (quint32 i = 0; i < count && pos + 4 <= size; ++i) {
+        const qint64 length = readU32LE(p + pos);
+        pos += 4;
+        if (pos + length > size) {
+            break;
+        }
+        const QByteArray entry = data.mid(pos, length);
+        pos += length;
+
+        const int equals = entry.indexOf('=');
+        if (equals > 0) {
+            assign(tags, vorbisField(entry.left(equals).toUpper()),
+                   QString::fromUtf8(entry.mid(equals + 1)));
+        }
+    }
+    markFormat(tags, "Vorbis comment");
+}
+
+void readOggComment(const QByteArray& first, const QByteArray& second, TagReader::Tags& tags)
+{
+    if (first.startsWith("\x01vorbis") && second.startsWith("\x03vorbis")) {
+        readVorbisComment(second.mid(7), tags);
+    } else if (first.startsWith("OpusHead") && second.startsWith("OpusTags")) {
+        readVorbisComment(second.mid(8), tags);
+    } else if (first.startsWith("\x7F" "FLAC") && !second.isEmpty() &&
+               (uchar(second.at(0)) & 0x7F) == 4) {
+        readVorbisComment(second.mid(4), tags);
+    } else if (first.startsWith("Speex   ")) {
+        readVorbisComment(second, tags);
+    }
+}
+
+struct Box {
+    qint64 start = 0;
+    qint64 size = 0;
+    qint64 headerSize = 8;
+    QByteArray type;
+
+    qint64 bodyStart() const { return start + headerSize; }
+    qint64 end() const { return start + size; }
+};
+
+bool readBox(QFile& file, qint64 pos, qint64 end, Box& box)
+{
+    if (pos + 8 > end || !file.seek(pos)) {
+        return false;
+    }
+    const QByteArray header = file.read(8);
+    if (header.size() < 8) {
+        return false;
+    }
+
+    qint64 size = readU32BE(header.constData());
+    box.type = header.mid(4, 4);
+    box.headerSize = 8;
+    if (size == 1) {
+        const QByteArray large = file.read(8);
+        if (large.size() < 8) {
+            return false;
+        }
+        size = qint64(readU64BE(large.constData()));
+        box.headerSize = 16;
+    } else if (size == 0) {
+        size = end - pos;
+    }
+    if (size < box.headerSize || pos + size > end) {
+        return false;
+    }
+    box.start = pos;
+    box.size = size;
+    return true;
+}
+
+bool findBox(QFile& file, qint64 pos, qint64 end, const char* type, Box& box)
+{
+    while (readBox(file, pos, end, box)) {
+        if (box.type == type) {
+            return true;
+        }
+        pos = box.end();
+    }
+    return false;
+}
+
+} // namespace
+
+QString TagReader::Tags::durationString() const
+{
+    return durationUs >= 0 ? MediaProbe::formatDuration(durationUs) : QString();
+}
+
+TagReader::Tags TagReader::read(const QString& filePath, QString* error)
+{
+    Tags tags;
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return tags;
+    }
+
+    const QByteArray head = file.read(12);
+    if (head.startsWith("RIFF")) {
+        readWav(file, tags);
+    } else if (head.mid(4, 4) == "ftyp") {
+        readMp4(file, tags);
+    } else if (head.startsWith("OggS")) {
+        readOgg(file, tags);
+    } else {
+        // Some taggers put ID3v2 in front of FLAC too
+        const qint64 streamStart = readId3v2(file, 0, tags);
+        readFlac(file, streamStart, tags);
+        readId3v1(file, tags);
+    }
+    file.close();
+
+    tags.durationUs = MediaProbe::durationUs(filePath);
+    return tags;
+}
+
+QString TagReader::genreName(int index)
+{
+    constexpr int count = int(sizeof(kGenres) / sizeof(kGenres[0]));
+    return index >= 0 && index < count ? QString::fromLatin1(kGenres[index]) : QString();
+}
+
+qint64 TagReader::readId3v2(QFile& file, qint64 offset, Tags& tags)
+{
+    if (!file.seek(offset)) {
+        return offset;
+    }
+    const QByteArray header = file.read(10);
+    if (header.size() < 10 || !header.startsWith("ID3")) {
+        return offset;
+    }
+
+    const int major = uchar(header.at(3));
+    const uchar flags = uchar(header.at(5));
+    const qint64 size = readSynchsafe(header.constData() + 6);
+    const qint64 end = offset + 10 + size + (major >= 4 && (flags & 0x10) ? 10 : 0);
+    if (major < 2 || major > 4) {
+        return end;
+    }
+
+    // A v2.2/v2.3 tag unsynchronised as a whole is restored in memory first,
+    // since its frame sizes count the restored bytes
+    const bool inMemory = major < 4 && (flags & 0x80);
+    QByteArray body;
+    if (inMemory) {
+        if (size > MAX_UNSYNC_TAG_SIZE) {
+            return end;
+        }
+        body = removeUnsync(file.read(size));
+    }
+    const qint64 limit = inMemory ? body.size() : size;
+    auto readAt = [&](qint64 pos, qint64 length) -> QByteArray {
+        if (inMemory) {
+            return body.mid(pos, length);
+        }
+        return file.seek(offset + 10 + pos) ? file.read(length) : QByteArray();
+    };
+
+    qint64 pos = 0;
+    if (major >= 3 && (flags & 0x40)) {
+        const QByteArray extended = readAt(0, 4);
+        if (extended.size() < 4) {
+            return end;
+        }
+        pos = major == 3 ? 4 + qint64(readU32BE(extended.constData()))
+                         : qint64(readSynchsafe(extended.constData()));
+    }
+
+    const int headerSize = major == 2 ? 6 : 10;
+    const int idSize = major == 2 ? 3 : 4;
+    while (pos + headerSize <= limit) {
+        const QByteArray frameHeader = readAt(pos, headerSize);
+        if (frameHeader.size() < headerSize || frameHeader.at(0) == '\0') {
+            break; // Padding
+        }
+
+        const char* p = frameHeader.constData();
+        qint64 frameSize = 0;
+        quint16 frameFlags = 0;
+        if (major == 2) {
+            frameSize = readU24BE(p + 3);
+        } else {
+            frameSize = major == 3 ? readU32BE(p + 4) : readSynchsafe(p + 4);
+            frameFlags = readU16BE(p + 8);
+        }
+        const qint64 dataPos = pos + headerSize;
+        pos = dataPos + frameSize;
+        if (frameSize <= 0 || pos > limit) {
+            break;
+        }
+
+        // Cover art and other frames that are not wanted are stepped over unread
+        const Field field = id3Field(frameHeader.left(idSize));
+        if (field == Field::None || frameSize > MAX_FRAME_SIZE) {
+            continue;
+        }
+        if ((major == 3 && (frameFlags & 0x00C0)) || (major == 4 && (frameFlags & 0x000C))) {
+            continue; // Compressed or encrypted
+        }
+
+        QByteArray data = readAt(dataPos, frameSize);
+        if (major == 3 && (frameFlags & 0x0020)) {
+            data.remove(0, 1); // Group identifier
+        } else if (major == 4) {
+            if (frameFlags & 0x0040) {
+                data.remove(0, 1); // Group identifier
+            }
+            if (frameFlags & 0x0001) {
+                data.remove(0, 4); // Data length indicator
+            }
+            if ((frameFlags & 0x0002) || (flags & 0x80)) {
+                data = removeUnsync(data);
+            }
+        }
+
+        const QString text = decodeId3Text(data);
+        assign(tags, field, field == Field::Genre ? resolveGenre(text) : text);
+    }
+
+    markFormat(tags, QString("ID3v2.%1").arg(major));
+    return end;
+}
+
+void TagReader::readId3v1(QFile& file, Tags& tags)
+{
+    if (file.size() < 128 || !file.seek(file.size() - 128)) {
+        return;
+    }
+    const QByteArray tag = file.read(128);
+    if (tag.size() < 128 || !tag.startsWith("TAG")) {
+        return;
+    }
+
+    auto text = [&tag](int offset, int length) {
+        return firstValue(decodeText(tag.mid(offset, length)));
+    };
+    assign(tags, Field::Title, text(3, 30));
+    assign(tags, Field::Artist, text(33, 30));
+    assign(tags, Field::Album, text(63, 30));
+    assign(tags, Field::Year, text(93, 4));
+    assign(tags, Field::Genre, genreName(uchar(tag.at(127))));
+    markFormat(tags, "ID3v1");
+}
+
+void TagReader::readFlac(QFile& file, qint64 offset, Tags& tags)
+{
+    if (!file.seek(offset) || file.read(4) != "fLaC") {
+        return;
+    }
+
+    qint64 pos = offset + 4;
+    while (file.seek(pos)) {
+        const QByteArray header = file.read(4);
+        if (header.size() < 4) {
+            return;
+        }
+        const bool last = uchar(header.at(0)) & 0x80;
+        const int type = uchar(header.at(0)) & 0x7F;
+        const qint64 length = readU24BE(header.constData() + 1);
+        if (type == 4) {
+            readVorbisComment(file.read(qMin<qint64>(length, MAX_COMMENT_SIZE)), tags);
+            return;
+        }
+        if (last || type == 127) {
+            return;
+        }
+        pos += 4 + length;
+    }
+}
+
+void TagReader::readOgg(QFile& file, Tags& tags)
+{
+    // The comment header is the second packet of the first stream and may
+    // span several pages; pages of other streams are skipped
+    QByteArray first;
+    QByteArray packet;
+    int packets = 0;
+    quint32 serial = 0;
+    qint64 pos = 0;
+
+    for (int page = 0; page < MAX_OGG_PAGES && file.seek(pos); ++page) {
+        const QByteArray header = file.read(27);
+        if (header.size() < 27 || !header.startsWith("OggS")) {
+            return;
+        }
+        const int segments = uchar(header.at(26));
+        const QByteArray lacing = file.read(segments);
+        if (lacing.size() < segments) {
+            return;
+        }
+        qint64 bodySize = 0;
+        for (const char length : lacing) {
+            bodySize += uchar(length);
+        }
+        pos += 27 + segments + bodySize;
+
+        const quint32 pageSerial = readU32LE(header.constData() + 14);
+        if (page == 0) {
+            serial = pageSerial;
+        } else if (pageSerial != serial) {
+            continue;
+        }
+
+        const QByteArray body = file.read(bodySize);
+        qint64 offset = 0;
+        for (const char length : lacing) {
+            packet.append(body.mid(offset, uchar(length)));
+            offset += uchar(length);
+            if (uchar(length) == 255) {
+                continue;
+            }
+            if (packets++ == 0) {
+                first = packet;
+                packet.clear();
+            } else {
+                readOggComment(first, packet, tags);
+                return;
+            }
+        }
+
+        // A comment swollen by embedded cover art is read up to the cap
+        if (packets == 1 && packet.size() >= MAX_COMMENT_SIZE) {
+            readOggComment(first, packet, tags);
+            return;
+        }
+    }
+}
+
+void TagReader::readMp4(QFile& file, Tags& tags)
+{
+    const qint64 fileSize = file.size();
+    Box moov;
+    Box udta;
+    Box meta;
+    Box ilst;
+    if (!findBox(file, 0, fileSize, "moov", moov) ||
+        !findBox(file, moov.bodyStart(), moov.end(), "udta", udta) ||
+        !findBox(file, udta.bodyStart(), udta.end(), "meta", meta)) {
+        return;
+    }
+
+    // The ISO meta box carries a version and flags before its children; QuickTime's does not
+    qint64 metaBody = meta.bodyStart();
+    if (!file.seek(metaBody) || file.read(8).mid(4, 4) != "hdlr") {
+        metaBody += 4;
+    }
+    if (!findBox(file, metaBody, meta.end(), "ilst", ilst)) {
+        return;
+    }
+
+    Box item;
+    for (qint64 pos = ilst.bodyStart(); readBox(file, pos, ilst.end(), item); pos = item.end()) {
+        const Field field = mp4Field(item.type);
+        Box data;
+        if (field == Field::None || item.size > MAX_FRAME_SIZE ||
+            !findBox(file, item.bodyStart(), item.end(), "data", data) ||
+            data.size < data.headerSize + 8 || !file.seek(data.bodyStart())) {
+            continue;
+        }
+
+        // data holds a type indicator and a locale ahead of the value
+        const QByteArray payload = file.read(data.size - data.headerSize);
+        if (payload.size() < 8) {
+            continue;
+        }
+        const quint32 valueType = readU32BE(payload.constData()) & 0x00FFFFFF;
+        const QByteArray value = payload.mid(8);
+        if (item.type == "gnre") {
+            // Numbered like ID3v1, plus one
+            if (value.size() >= 2) {
+                assign(tags, field, genreName(int(readU16BE(value.constData())) - 1));
+            }
+        } else if (valueType == 1) {
+            assign(tags, field, QString::fromUtf8(value));
+        }
+    }
+    markFormat(tags, "MP4 metadata");
+}
+
+void TagReader::readWav(QFile& file, Tags& tags)
+{
+    if (!file.seek(0) || file.read(12).mid(8, 4) != "WAVE") {
+        return;
+    }
+
+    // Chunks are word aligned; LIST/INFO and embedded ID3v2 both carry tags
+    const qint64 fileSize = file.size();
+    qint64 pos = 12;
+    while (pos + 8 <= fileSize && file.seek(pos)) {
+        const QByteArray header = file.read(8);
+        if (header.size() < 8) {
+            break;
+        }
+        const QByteArray id = header.left(4);
+        const qint64 size = readU32LE(header.constData() + 4);
+
+        if (id == "LIST" && size >= 4 && size <= MAX_COMMENT_SIZE) {
+            const QByteArray list = file.read(size);
+            if (list.startsWith("INFO")) {
+                qint64 entry = 4;
+                while (entry + 8 <= list.size()) {
+                    const qint64 length = readU32LE(list.constData() + entry + 4);
+                    if (entry + 8 + length > list.size()) {
+                        break;
+                    }
+                    assign(tags, wavField(list.mid(entry, 4)),
+                           firstValue(decodeText(list.mid(entry + 8, length))));
+                    entry += 8 + length + (length & 1);
+                }
+                markFormat(tags, "RIFF INFO");
+            }
+        } else if (id == "id3 " || id == "ID3 ") {
+            readId3v2(file, pos + 8, tags);
+        }
+        pos += 8 + size + (size & 1);
+    }
+}
@@ -0,0 +1,99 @@
+#ifndef TAGREADER_H
+#define TAGREADER_H
+
+#include <QString>
+#include <QtGlobal>
+
+class QFile;
+
+/**
+ * @brief In-process reader for the tags embedded in audio files
+ *
+ * TagReader reads artist, title, album, genre and year straight from the
+ * tag blocks of a file, without starting mediainfo or exiftool and without
+ * decoding any audio. Only the tag headers and the text frames that are
+ * wanted are read; cover art and other large frames are skipped with a
+ * seek, so reading a file costs a few small reads. The duration comes
+ * from MediaProbe in the same call.
+ *
+ * Supported tags:
+ * - ID3v2.2, ID3v2.3 and ID3v2.4, with ID3v1 as a fallback
+ * - Vorbis comments in FLAC, Ogg Vorbis, Ogg Opus and Ogg FLAC
+ * - MP4/M4A iTunes metadata (moov/udta/meta/ilst)
+ * - RIFF INFO lists in WAV
+ *
+ * Fields missing from the tags are left empty, so callers can fall back
+ * to the file name.
+ *
+ * @example
+ * @code
+ * TagReader::Tags tags = TagReader::read("/music/song.flac");
+ * if (tags.hasTags()) {
+ *     item.artist = tags.artist;
+ *     item.song = tags.title;
+ * }
+ * item.time = tags.durationString();
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class TagReader
+{
+public:
+    /**
+     * @brief Tags read from a file
+     */
+    struct Tags {
+        QString artist;
+        QString title;
+        QString album;
+        QString genre;              ///< Genre name; ID3v1 genre numbers are resolved
+        QString year;               ///< Four-digit year, if the date had one
+        qint64 durationUs = -1;     ///< Duration from MediaProbe, or -1 if unknown
+        QString format;             ///< Tag format read (e.g. "ID3v2.4", "Vorbis comment")
+
+        /**
+         * @brief Check whether any text field was found
+         */
+        bool hasTags() const
+        {
+            return !artist.isEmpty() || !title.isEmpty() || !album.isEmpty() ||
+                   !genre.isEmpty() || !year.isEmpty();
+        }
+
+        /**
+         * @brief Duration formatted the way the musics.time column stores it
+         * @return Duration as "H:MM:SS", or empty string if unknown
+         */
+        QString durationString() const;
+    };
+
+    /**
+     * @brief Read the tags and duration of a file
+     * @param filePath Path of the audio file
+     * @param error Receives the reason when the file cannot be opened
+     * @return Tags found; all fields empty if the file has none
+     */
+    static Tags read(const QString& filePath, QString* error = nullptr);
+
+    /**
+     * @brief Get the name of an ID3v1 genre number
+     * @param index Genre number, as used by ID3v1, "(n)" references and MP4 gnre atoms
+     * @return Genre name, or empty string if the number is unknown
+     */
+    static QString genreName(int index);
+
+    static constexpr int MAX_FRAME_SIZE = 64 * 1024;
+    static constexpr int MAX_COMMENT_SIZE = 1024 * 1024;
+    static constexpr int MAX_UNSYNC_TAG_SIZE = 4 * 1024 * 1024;
+
+private:
+    static qint64 readId3v2(QFile& file, qint64 offset, Tags& tags);
+    static void readId3v1(QFile& file, Tags& tags);
+    static void readFlac(QFile& file, qint64 offset, Tags& tags);
+    static void readOgg(QFile& file, Tags& tags);
+    static void readMp4(QFile& file, Tags& tags);
+    static void readWav(QFile& file, Tags& tags);
+};
+
+#endif // TAGREADER_H
@@ -0,0 +1,198 @@
+#include "TaskRunner.h"
+#include "BackgroundThrottle.h"
+#include <QFutureWatcher>
+#include <QMutexLocker>
+#include <QtConcurrent/QtConcurrentRun>
+#include <algorithm>
+
+void TaskRunner::Context::setProgress(int done, int total, const QString& message)
+{
+    QMutexLocker locker(&m_state->mutex);
+    m_state->done = done;
+    m_state->total = total;
+    if (!message.isEmpty()) {
+        m_state->message = message;
+    }
+    m_state->changed.store(true);
+}
+
+void TaskRunner::Context::pace() const
+{
+    BackgroundThrottle::pace(&m_state->cancelled);
+}
+
+TaskRunner::TaskRunner(int maxThreads, QObject* parent)
+    : QObject(parent)
+    , m_maxThreads(std::max(1, maxThreads))
+{
+    m_pool.setMaxThreadCount(m_maxThreads);
+    m_progressTimer.setInterval(PROGRESS_INTERVAL_MS);
+    connect(&m_progressTimer, &QTimer::timeout, this, qOverload<>(&TaskRunner::emitProgress));
+}
+
+TaskRunner::~TaskRunner()
+{
+    for (Task& task : m_tasks) {
+        task.state->cancelled.store(true);
+    }
+    m_pool.waitForDone();
+}
+
+int TaskRunner::start(const QString& title, Priority priority, Work work, Done done)
+{
+    const int id = m_nextId++;
+    Task task;
+    task.title = title;
+    task.priority = priority;
+    task.work = std::move(work);
+    task.done = std::move(done);
+    task.state = std::make_shared<Context::State>();
+    m_tasks.insert(id, task);
+    m_waiting[int(priority)].push_back(id);
+    dispatch();
+    return id;
+}
+
+void TaskRunner::cancel(int id)
+{
+    auto it = m_tasks.find(id);
+    if (it == m_tasks.end()) {
+        return;
+    }
+    if (it->running) {
+        it->state->cancelled.store(true);
+        return;
+    }
+
+    std::deque<int>& waiting = m_waiting[int(it->priority)];
+    waiting.erase(std::remove(waiting.begin(), waiting.end(), id), waiting.end());
+    Result result;
+    result.id = id;
+    result.title = it->title;
+    result.cancelled = true;
+    const Done done = it->done;
+    m_tasks.erase(it);
+    finish(done, result);
+}
+
+void TaskRunner::cancelAll()
+{
+    const QList<int> ids = m_tasks.keys();
+    for (int id : ids) {
+        cancel(id);
+    }
+}
+
+int TaskRunner::waitingCount() const
+{
+    return int(m_waiting[0].size() + m_waiting[1].size() + m_waiting[2].size());
+}
+
+void TaskRunner::dispatch()
+{
+    // The last thread is kept for OnAir tasks, unless there is only one
+    const int sharedThreads = std::max(1, m_maxThreads - 1);
+    while (m_running < m_maxThreads) {
+        std::deque<int>* next = nullptr;
+        if (!m_waiting[int(Priority::OnAir)].empty()) {
+            next = &m_waiting[int(Priority::OnAir)];
+        } else if (m_running < sharedThreads) {
+            if (!m_waiting[int(Priority::Normal)].empty()) {
+                next = &m_waiting[int(Priority::Normal)];
+            } else if (!m_waiting[int(Priority::Maintenance)].empty()) {
+                next = &m_waiting[int(Priority::Maintenance)];
+            }
+        }
+        if (!next) {
+            break;
+        }
+        const int id = next->front();
+        next->pop_front();
+        run(id);
+    }
+}
+
+void TaskRunner::run(int id)
+{
+    Task& task = m_tasks[id];
+    task.running = true;
+    ++m_running;
+    if (!m_progressTimer.isActive()) {
+        m_progressTimer.start();
+    }
+    emit taskStarted(id, task.title, task.priority);
+
+    auto* watcher = new QFutureWatcher<Result>(this);
+    connect(watcher, &QFutureWatcher<Result>::finished, this, [this, watcher]() {
+        watcher->deleteLater();
+        onTaskDone(watcher->result());
+    });
+    watcher->setFuture(QtConcurrent::run(
+        &m_pool, [id, title = task.title, work = task.work, state = task.state]() {
+            Result result;
+            result.id = id;
+            result.title = title;
+            Context context(state);
+            if (!state->cancelled.load()) {
+                work(context, result);
+            }
+            result.cancelled = state->cancelled.load();
+            return result;
+        }));
+}
+
+void TaskRunner::onTaskDone(const Result& result)
+{
+    Done done;
+    auto it = m_tasks.find(result.id);
+    if (it != m_tasks.end()) {
+        // The last values reported are shown before the task is gone
+        const std::shared_ptr<Context::State> state = it->state;
+        done = it->done;
+        m_tasks.erase(it);
+        emitProgress(result.id, *state);
+    }
+    --m_running;
+    dispatch();
+    if (m_running == 0) {
+        m_progressTimer.stop();
+    }
+    finish(done, result);
+}
+
+void TaskRunner::finish(const Done& done, const Result& result)
+{
+    if (done) {
+        done(result);
+    }
+    emit taskFinished(result);
+}
+
+void TaskRunner::emitProgress()
+{
+    const QList<int> ids = m_tasks.keys();
+    for (int id : ids) {
+        auto it = m_tasks.find(id);
+        if (it != m_tasks.end() && it->running) {
+            const std::shared_ptr<Context::State> state = it->state;
+            emitProgress(id, *state);
+        }
+    }
+}
+
+void TaskRunner::emitProgress(int id, Context::State& state)
+{
+    if (!state.changed.exchange(false)) {
+        return;
+    }
+    int done = 0;
+    int total = 0;
+    QString message;
+    {
+        QMutexLocker locker(&state.mutex);
+        done = state.done;
+        total = state.total;
+        message = state.message;
+    }
+    emit progressChanged(id, done, total, message);
+}
@@ -0,0 +1,211 @@
+#ifndef TASKRUNNER_H
+#define TASKRUNNER_H
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QThreadPool>
+#include <QTimer>
+#include <QVariant>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+
+/**
+ * @brief Runs long operations on one shared pool, with priorities, cancellation and progress
+ *
+ * Long operations each had their own way of staying out of the way: some
+ * looped on the GUI thread calling processEvents() behind a progress
+ * dialog, others had a pool and a progress widget of their own, and
+ * BackgroundOperationFeedback and SystemStatusAnnouncer had to be told
+ * about each of them separately. A task handed to TaskRunner runs on the
+ * runner's pool and reports through the runner's signals, so one place
+ * can show it in a progress widget and announce it.
+ *
+ * Tasks wait in the runner, not in the pool: the next one started is the
+ * oldest of the highest priority, and tasks below OnAir never hold the
+ * last thread, so a task the broadcast waits on starts right away however
+ * much maintenance is queued.
+ *
+ * A task looks at Context::isCancelled() between steps and stops when it
+ * is set. It reports progress with Context::setProgress() as often as it
+ * likes; progressChanged() is emitted at most every PROGRESS_INTERVAL_MS
+ * per task, with the latest values.
+ *
+ * @example
+ * @code
+ * TaskRunner* tasks = new TaskRunner(QThread::idealThreadCount(), this);
+ * tasks->start(tr("Trimming silence"), TaskRunner::Priority::Maintenance,
+ *              [paths](TaskRunner::Context& context, TaskRunner::Result& result) {
+ *                  for (int i = 0; i < paths.size() && !context.isCancelled(); ++i) {
+ *                      context.setProgress(i, paths.size(), paths.at(i));
+ *                      trim(paths.at(i));
+ *                  }
+ *                  result.message = tr("%1 tracks trimmed").arg(paths.size());
+ *              });
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class TaskRunner : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int PROGRESS_INTERVAL_MS = 250;
+
+    /**
+     * @brief Order in which waiting tasks are started
+     */
+    enum class Priority {
+        Maintenance,   ///< Library upkeep; never takes the last thread
+        Normal,        ///< Started by the user; never takes the last thread
+        OnAir          ///< Needed by the broadcast; started first
+    };
+    Q_ENUM(Priority)
+
+    /**
+     * @brief Handed to a task on its worker thread
+     */
+    class Context
+    {
+    public:
+        /**
+         * @brief Check whether the task should stop
+         */
+        bool isCancelled() const { return m_state->cancelled.load(); }
+
+        /**
+         * @brief Report how far the task got
+         * @param done Steps done
+         * @param total Steps in all, or 0 if not known
+         * @param message What the task is doing, empty to keep the last one
+         */
+        void setProgress(int done, int total, const QString& message = QString());
+
+        /**
+         * @brief Wait while the broadcast needs the machine, see BackgroundThrottle::pace()
+         *
+         * For tasks below OnAir, before each step; returns early once cancelled.
+         */
+        void pace() const;
+
+    private:
+        friend class TaskRunner;
+        struct State {
+            std::atomic_bool cancelled{false};
+            std::atomic_bool changed{false};
+            QMutex mutex;
+            int done = 0;
+            int total = 0;
+            QString message;
+        };
+        explicit Context(std::shared_ptr<State> state) : m_state(std::move(state)) {}
+        std::shared_ptr<State> m_state;
+    };
+
+    /**
+     * @brief How a task ended
+     */
+    struct Result {
+        int id = -1;
+        QString title;
+        QString message;     ///< Summary set by the task, shown once it ended
+        QString error;       ///< Set by the task if it failed; empty on success
+        QVariant value;      ///< Anything else the task hands back
+        bool cancelled = false;
+
+        bool succeeded() const { return error.isEmpty() && !cancelled; }
+    };
+
+    /// Runs on a pool thread; fills in message, error and value of the result
+    using Work = std::function<void(Context& context, Result& result)>;
+
+    /// Runs on the runner's thread once the task ended, before taskFinished()
+    using Done = std::function<void(const Result& result)>;
+
+    /**
+     * @param maxThreads Tasks run at once; at least one
+     * @param parent Parent object
+     */
+    explicit TaskRunner(int maxThreads, QObject* parent = nullptr);
+    ~TaskRunner() override;
+
+    int maxThreads() const { return m_maxThreads; }
+
+    /**
+     * @brief Queue a task
+     * @param title Name of the task, for the progress widget and announcements
+     * @param priority Where it goes in the queue
+     * @param work What the task does
+     * @param done What to do with the result; may be empty
+     * @return Id of the task, for cancel() and the signals
+     */
+    int start(const QString& title, Priority priority, Work work, Done done = Done());
+
+    /**
+     * @brief Stop a task; a waiting one is dropped, a running one is asked to stop
+     */
+    void cancel(int id);
+
+    /**
+     * @brief Stop every task
+     */
+    void cancelAll();
+
+    /**
+     * @brief Check whether a task is waiting or running
+     */
+    bool contains(int id) const { return m_tasks.contains(id); }
+
+    int runningCount() const { return m_running; }
+    int waitingCount() const;
+
+signals:
+    /**
+     * @brief Emitted when a task leaves the queue and starts running
+     */
+    void taskStarted(int id, const QString& title, TaskRunner::Priority priority);
+
+    /**
+     * @brief Emitted at most every PROGRESS_INTERVAL_MS while a task reports progress
+     */
+    void progressChanged(int id, int done, int total, const QString& message);
+
+    /**
+     * @brief Emitted when a task ended, whether it ran or not
+     */
+    void taskFinished(const TaskRunner::Result& result);
+
+private:
+    struct Task {
+        QString title;
+        Priority priority = Priority::Normal;
+        Work work;
+        Done done;
+        std::shared_ptr<Context::State> state;
+        bool running = false;
+    };
+
+    void dispatch();
+    void run(int id);
+    void onTaskDone(const Result& result);
+    void finish(const Done& done, const Result& result);
+    void emitProgress();
+    void emitProgress(int id, Context::State& state);
+
+    QThreadPool m_pool;
+    int m_maxThreads;
+    int m_nextId = 1;
+    int m_running = 0;
+    QHash<int, Task> m_tasks;
+    std::deque<int> m_waiting[3];   ///< Ids by priority, oldest first
+    QTimer m_progressTimer;
+};
+
+Q_DECLARE_METATYPE(TaskRunner::Result)
+
+#endif // TASKRUNNER_H
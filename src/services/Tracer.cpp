@@ -0,0 +1,111 @@
+#include "Tracer.h"
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+struct Span {
+    const char* category;
+    const char* name;
+    qint64 start;
+    qint64 duration;
+};
+
+} // namespace
+
+QByteArray Tracer::toChromeTrace()
+{
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    {
+        QMutexLocker locker(&s_mutex);
+        buffers = s_buffers;
+    }
+
+    // Copy each buffer first; a slot its thread rewrote meanwhile is dropped
+    std::vector<std::vector<Span>> spans(buffers.size());
+    qint64 origin = std::numeric_limits<qint64>::max();
+    for (size_t i = 0; i < buffers.size(); ++i) {
+        const ThreadBuffer& buffer = *buffers[i];
+        const quint64 next = buffer.m_next.load(std::memory_order_acquire);
+        quint64 index = buffer.m_first.load(std::memory_order_relaxed);
+        if (next > EVENTS_PER_THREAD) {
+            index = std::max<quint64>(index, next - EVENTS_PER_THREAD);
+        }
+        for (; index < next; ++index) {
+            const Slot& slot = buffer.m_slots[index & (EVENTS_PER_THREAD - 1)];
+            const quint64 sequence = slot.sequence.load(std::memory_order_acquire);
+            if (sequence != 2 * index + 2) {
+                continue;
+            }
+            const Span span{slot.category.load(std::memory_order_relaxed),
+                            slot.name.load(std::memory_order_relaxed),
+                            slot.start.load(std::memory_order_relaxed),
+                            slot.duration.load(std::memory_order_relaxed)};
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.sequence.load(std::memory_order_relaxed) != sequence) {
+                continue;
+            }
+            spans[i].push_back(span);
+            origin = std::min(origin, span.start);
+        }
+    }
+
+    const qint64 pid = QCoreApplication::applicationPid();
+    QJsonArray events;
+    for (size_t i = 0; i < buffers.size(); ++i) {
+        const ThreadBuffer& buffer = *buffers[i];
+        events.append(QJsonObject{{"name", "thread_name"},
+                                  {"ph", "M"},
+                                  {"pid", pid},
+                                  {"tid", buffer.m_id},
+                                  {"args", QJsonObject{{"name", buffer.m_name}}}});
+        for (const Span& span : spans[i]) {
+            // Complete events; the format counts in microseconds
+            events.append(QJsonObject{{"name", QString::fromUtf8(span.name)},
+                                      {"cat", QString::fromUtf8(span.category)},
+                                      {"ph", "X"},
+                                      {"ts", double(span.start - origin) / 1000.0},
+                                      {"dur", double(span.duration) / 1000.0},
+                                      {"pid", pid},
+                                      {"tid", buffer.m_id}});
+        }
+    }
+
+    QJsonObject trace;
+    trace.insert("traceEvents", events);
+    trace.insert("displayTimeUnit", "ms");
+    return QJsonDocument(trace).toJson(QJsonDocument::Compact);
+}
+
+bool Tracer::writeChromeTrace(const QString& filePath)
+{
+    QDir().mkpath(QFileInfo(filePath).absolutePath());
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Tracer: cannot write" << filePath << "-" << file.errorString();
+        return false;
+    }
+    file.write(toChromeTrace());
+    if (!file.commit()) {
+        qWarning() << "Tracer: cannot write" << filePath << "-" << file.errorString();
+        return false;
+    }
+    qInfo() << "Tracer: trace saved to" << filePath;
+    return true;
+}
+
+void Tracer::clear()
+{
+    QMutexLocker locker(&s_mutex);
+    for (const std::shared_ptr<ThreadBuffer>& buffer : s_buffers) {
+        buffer->m_first.store(buffer->m_next.load(std::memory_order_acquire),
+                              std::memory_order_relaxed);
+    }
+}
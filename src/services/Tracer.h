@@ -0,0 +1,272 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QString>
+#include <QThread>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Flight recorder of timed spans on every thread
+ *
+ * A glitch between two songs leaves nothing in the log. With tracing on,
+ * each TraceSpan records when it started and how long it took, and the
+ * last EVENTS_PER_THREAD spans of every thread are kept. toChromeTrace()
+ * writes them in the Chrome trace event format, which chrome://tracing
+ * and ui.perfetto.dev both open as a timeline per thread.
+ *
+ * Each thread records into a buffer of its own, so recording takes no
+ * lock: a few relaxed stores and a release. A thread's buffer is made the
+ * first time it records, and kept after the thread ends so that its spans
+ * can still be exported. With tracing off a span costs one relaxed load
+ * and pushing its name onto the thread's open span list.
+ *
+ * That list is kept whether tracing is on or not, so a watchdog can tell
+ * what a stuck thread is in the middle of: see openSpans().
+ *
+ * Everything a span needs is in this header, so classes that are linked
+ * into many targets, such as QueryTimer, can be traced without linking
+ * Tracer.cpp; only the export lives there.
+ *
+ * @example
+ * @code
+ * Tracer::setEnabled(true);
+ * {
+ *     TraceSpan span("player", "playNextSong");
+ *     ...
+ * }
+ * Tracer::writeChromeTrace("/tmp/xfb-trace.json");
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class Tracer
+{
+public:
+    static constexpr int EVENTS_PER_THREAD = 4096;   ///< Power of two
+
+    /**
+     * @brief Turn recording on or off; spans already open finish as they began
+     */
+    static void setEnabled(bool enabled) { s_enabled.store(enabled, std::memory_order_relaxed); }
+    static bool isEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Current time on the clock spans are measured with, in nanoseconds
+     */
+    static qint64 now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    /**
+     * @brief Record a finished span on the calling thread
+     * @param category Category; must be a literal or otherwise outlive the tracer
+     * @param name Name; must be a literal or otherwise outlive the tracer
+     * @param startNs Start, from now()
+     * @param durationNs Duration in nanoseconds
+     */
+    static void record(const char* category, const char* name, qint64 startNs, qint64 durationNs)
+    {
+        ThreadBuffer* buffer = t_buffer;
+        if (!buffer) {
+            buffer = registerThread();
+        }
+        buffer->write(category, name, startNs, durationNs);
+    }
+
+    /**
+     * @brief A span that has started and not finished yet
+     */
+    struct ActiveSpan {
+        const char* category = nullptr;
+        const char* name = nullptr;
+        qint64 startNs = 0;   ///< From now(); 0 if it began while tracing was off
+    };
+
+    /**
+     * @brief Spans open on one thread, outermost first
+     *
+     * Only the owning thread changes the list; any thread may read it. A
+     * reader gets a moment's view, which may already be out of date.
+     */
+    class OpenSpans
+    {
+    public:
+        static constexpr int MAX_DEPTH = 32;   ///< Deeper spans are counted, not named
+
+        void push(const char* category, const char* name, qint64 startNs)
+        {
+            const int depth = m_depth.load(std::memory_order_relaxed);
+            if (depth < MAX_DEPTH) {
+                m_spans[depth].category.store(category, std::memory_order_relaxed);
+                m_spans[depth].name.store(name, std::memory_order_relaxed);
+                m_spans[depth].startNs.store(startNs, std::memory_order_relaxed);
+            }
+            m_depth.store(depth + 1, std::memory_order_release);
+        }
+
+        void pop()
+        {
+            m_depth.store(m_depth.load(std::memory_order_relaxed) - 1, std::memory_order_release);
+        }
+
+        std::vector<ActiveSpan> snapshot() const
+        {
+            const int depth = std::min(m_depth.load(std::memory_order_acquire), MAX_DEPTH);
+            std::vector<ActiveSpan> spans(size_t(std::max(depth, 0)));
+            for (size_t i = 0; i < spans.size(); ++i) {
+                spans[i].category = m_spans[i].category.load(std::memory_order_relaxed);
+                spans[i].name = m_spans[i].name.load(std::memory_order_relaxed);
+                spans[i].startNs = m_spans[i].startNs.load(std::memory_order_relaxed);
+            }
+            return spans;
+        }
+
+    private:
+        struct Entry {
+            std::atomic<const char*> category{nullptr};
+            std::atomic<const char*> name{nullptr};
+            std::atomic<qint64> startNs{0};
+        };
+        std::atomic<int> m_depth{0};
+        std::array<Entry, MAX_DEPTH> m_spans;
+    };
+
+    /**
+     * @brief Open spans of the calling thread
+     * @return List that lives as long as the thread
+     */
+    static OpenSpans* openSpans() { return &t_open; }
+
+    /**
+     * @brief Write the recorded spans of all threads as a Chrome trace
+     * @return JSON object with "traceEvents", oldest span first per thread
+     */
+    static QByteArray toChromeTrace();
+
+    /**
+     * @brief Save toChromeTrace() to a file
+     * @param filePath File to write; its directory is created if needed
+     * @return true if written
+     */
+    static bool writeChromeTrace(const QString& filePath);
+
+    /**
+     * @brief Forget every recorded span
+     *
+     * Only clears threads that are not recording at the same moment; meant
+     * for tests and for starting a fresh recording.
+     */
+    static void clear();
+
+private:
+    struct Slot {
+        std::atomic<quint64> sequence{0};   ///< 2 * index + 2 once written, odd while writing
+        std::atomic<const char*> category{nullptr};
+        std::atomic<const char*> name{nullptr};
+        std::atomic<qint64> start{0};
+        std::atomic<qint64> duration{0};
+    };
+
+    class ThreadBuffer
+    {
+    public:
+        ThreadBuffer(int id, const QString& name)
+            : m_id(id)
+            , m_name(name)
+        {
+        }
+
+        // Only the owning thread writes; readers check each slot's sequence
+        // and skip a slot that was overwritten while they read it
+        void write(const char* category, const char* name, qint64 start, qint64 duration)
+        {
+            const quint64 index = m_next.load(std::memory_order_relaxed);
+            Slot& slot = m_slots[index & (EVENTS_PER_THREAD - 1)];
+            slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            slot.category.store(category, std::memory_order_relaxed);
+            slot.name.store(name, std::memory_order_relaxed);
+            slot.start.store(start, std::memory_order_relaxed);
+            slot.duration.store(duration, std::memory_order_relaxed);
+            slot.sequence.store(2 * index + 2, std::memory_order_release);
+            m_next.store(index + 1, std::memory_order_release);
+        }
+
+        const int m_id;
+        const QString m_name;
+        std::atomic<quint64> m_next{0};
+        std::atomic<quint64> m_first{0};   ///< Index clear() left off at
+        std::array<Slot, EVENTS_PER_THREAD> m_slots;
+    };
+
+    static ThreadBuffer* registerThread()
+    {
+        QMutexLocker locker(&s_mutex);
+        const int id = int(s_buffers.size()) + 1;
+        QThread* thread = QThread::currentThread();
+        QString name = thread->objectName();
+        if (QCoreApplication::instance() && thread == QCoreApplication::instance()->thread()) {
+            name = QStringLiteral("main");
+        } else if (name.isEmpty()) {
+            name = QStringLiteral("thread %1").arg(id);
+        }
+        s_buffers.push_back(std::make_shared<ThreadBuffer>(id, name));
+        t_buffer = s_buffers.back().get();
+        return t_buffer;
+    }
+
+    static inline std::atomic<bool> s_enabled{false};
+    static inline QMutex s_mutex;                                    ///< Guards s_buffers
+    static inline std::vector<std::shared_ptr<ThreadBuffer>> s_buffers;
+    static inline thread_local ThreadBuffer* t_buffer = nullptr;
+    static inline thread_local OpenSpans t_open;
+};
+
+/**
+ * @brief Scoped span: records the time from construction to destruction
+ *
+ * @p category and @p name are kept as pointers, so pass string literals.
+ */
+class TraceSpan
+{
+public:
+    TraceSpan(const char* category, const char* name)
+        : m_category(category)
+        , m_name(name)
+        , m_start(Tracer::isEnabled() ? Tracer::now() : -1)
+        , m_open(Tracer::openSpans())
+    {
+        m_open->push(category, name, qMax<qint64>(m_start, 0));
+    }
+
+    ~TraceSpan()
+    {
+        m_open->pop();
+        if (m_start >= 0) {
+            Tracer::record(m_category, m_name, m_start, Tracer::now() - m_start);
+        }
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* m_category;
+    const char* m_name;
+    qint64 m_start;
+    Tracer::OpenSpans* m_open;
+};
+
+#endif // TRACER_H
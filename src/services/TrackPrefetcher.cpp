@@ -0,0 +1,234 @@
+#include "TrackPrefetcher.h"
+#include "MediaProbe.h"
+#include "Tracer.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QtConcurrent/QtConcurrent>
+#include <algorithm>
+#include <cstring>
+
+PrefetchedFileDevice::PrefetchedFileDevice(const QString& filePath, const QByteArray& head,
+                                           qint64 fileSize, QObject* parent)
+    : QIODevice(parent)
+    , m_filePath(filePath)
+    , m_head(head)
+    , m_fileSize(fileSize)
+{
+}
+
+bool PrefetchedFileDevice::seek(qint64 pos)
+{
+    if (pos < 0 || pos > m_fileSize) {
+        return false;
+    }
+    return QIODevice::seek(pos);
+}
+
+qint64 PrefetchedFileDevice::readData(char* data, qint64 maxSize)
+{
+    const qint64 position = pos();
+    if (position >= m_fileSize) {
+        return 0;
+    }
+
+    if (position < m_head.size()) {
+        const qint64 count = qMin(maxSize, m_head.size() - position);
+        std::memcpy(data, m_head.constData() + position, count);
+        return count;
+    }
+
+    // Past the prefetched head: continue from the file itself
+    if (!m_file.isOpen()) {
+        m_file.setFileName(m_filePath);
+        if (!m_file.open(QIODevice::ReadOnly)) {
+            setErrorString(m_file.errorString());
+            return -1;
+        }
+    }
+    if (m_file.pos() != position && !m_file.seek(position)) {
+        setErrorString(m_file.errorString());
+        return -1;
+    }
+    return m_file.read(data, maxSize);
+}
+
+qint64 PrefetchedFileDevice::writeData(const char* data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
+
+TrackPrefetcher::TrackPrefetcher() = default;
+
+TrackPrefetcher::~TrackPrefetcher()
+{
+    // Reads capture this; evicted entries may still be running
+    QList<QFuture<void>> running;
+    {
+        QMutexLocker locker(&m_mutex);
+        running = m_running;
+    }
+    for (QFuture<void>& future : running) {
+        future.waitForFinished();
+    }
+}
+
+void TrackPrefetcher::prefetch(const QString& filePath)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (filePath.isEmpty() || m_entries.contains(filePath)) {
+        return;
+    }
+
+    while (m_entries.size() >= MAX_ENTRIES) {
+        evictOldest();
+    }
+    m_running.erase(std::remove_if(m_running.begin(), m_running.end(),
+                                   [](const QFuture<void>& future) { return future.isFinished(); }),
+                    m_running.end());
+
+    auto entry = std::make_shared<Entry>();
+    const int seconds = m_prefetchSeconds;
+    m_entries.insert(filePath, entry);
+    m_order.append(filePath);
+    ++m_stats.requested;
+
+    entry->future = QtConcurrent::run([this, entry, filePath, seconds]() {
+        TraceSpan span("cache", "TrackPrefetcher::read");
+        QElapsedTimer timer;
+        timer.start();
+
+        QFile file(filePath);
+        if (!file.open(QIODevice::ReadOnly)) {
+            qWarning() << "TrackPrefetcher: cannot open" << filePath << "-" << file.errorString();
+            QMutexLocker statsLocker(&m_mutex);
+            ++m_stats.failed;
+            return;
+        }
+
+        // Translate seconds of audio into bytes using the container's average rate
+        const qint64 fileSize = file.size();
+        qint64 bytes = MAX_PREFETCH_BYTES;
+        qint64 durationUs = MediaProbe::durationUs(filePath);
+        if (durationUs > 0) {
+            bytes = fileSize * seconds * 1000000 / durationUs;
+        }
+        bytes = qBound(MIN_PREFETCH_BYTES, bytes, MAX_PREFETCH_BYTES);
+
+        QByteArray head = file.read(qMin(bytes, fileSize));
+        const qint64 elapsed = timer.elapsed();
+
+        QMutexLocker statsLocker(&m_mutex);
+        entry->head = head;
+        entry->fileSize = fileSize;
+        entry->ok = true;
+        m_stats.bytesRead += head.size();
+        m_stats.totalReadMs += elapsed;
+    });
+    m_running.append(entry->future);
+}
+
+std::unique_ptr<QIODevice> TrackPrefetcher::take(const QString& filePath)
+{
+    TraceSpan span("cache", "TrackPrefetcher::take");
+    QMutexLocker locker(&m_mutex);
+
+    auto it = m_entries.find(filePath);
+    if (it == m_entries.end()) {
+        ++m_stats.misses;
+        return nullptr;
+    }
+
+    std::shared_ptr<Entry> entry = it.value();
+    if (!entry->future.isFinished()) {
+        // Never block the audio thread on a slow read; fall back to a cold open
+        ++m_stats.late;
+        return nullptr;
+    }
+
+    m_entries.erase(it);
+    m_order.removeAll(filePath);
+
+    if (!entry->ok) {
+        ++m_stats.misses;
+        return nullptr;
+    }
+
+    ++m_stats.hits;
+    auto device = std::make_unique<PrefetchedFileDevice>(filePath, entry->head, entry->fileSize);
+    device->open(QIODevice::ReadOnly);
+    return device;
+}
+
+std::unique_ptr<QIODevice> TrackPrefetcher::borrow(const QString& filePath)
+{
+    QMutexLocker locker(&m_mutex);
+
+    const auto it = m_entries.constFind(filePath);
+    if (it == m_entries.cend() || !it.value()->future.isFinished() || !it.value()->ok) {
+        return nullptr;
+    }
+
+    ++m_stats.borrowed;
+    const std::shared_ptr<Entry> entry = it.value();
+    auto device = std::make_unique<PrefetchedFileDevice>(filePath, entry->head, entry->fileSize);
+    device->open(QIODevice::ReadOnly);
+    return device;
+}
+
+void TrackPrefetcher::setPrefetchSeconds(int seconds)
+{
+    QMutexLocker locker(&m_mutex);
+    m_prefetchSeconds = qMax(1, seconds);
+}
+
+int TrackPrefetcher::prefetchSeconds() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_prefetchSeconds;
+}
+
+TrackPrefetcher::Statistics TrackPrefetcher::statistics() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_stats;
+}
+
+qint64 TrackPrefetcher::memoryUsage() const
+{
+    QMutexLocker locker(&m_mutex);
+    return heldBytes();
+}
+
+void TrackPrefetcher::shrink(qint64 keepBytes)
+{
+    QMutexLocker locker(&m_mutex);
+    while (!m_entries.isEmpty() && heldBytes() > keepBytes) {
+        evictOldest();
+    }
+}
+
+qint64 TrackPrefetcher::heldBytes() const
+{
+    // Callers hold m_mutex; a read in progress fills its head under it too
+    qint64 bytes = 0;
+    for (const std::shared_ptr<Entry>& entry : m_entries) {
+        bytes += entry->head.size();
+    }
+    return bytes;
+}
+
+void TrackPrefetcher::evictOldest()
+{
+    // Callers hold m_mutex
+    if (m_order.isEmpty()) {
+        m_entries.clear();
+        return;
+    }
+
+    QString oldest = m_order.takeFirst();
+    m_entries.remove(oldest);
+    ++m_stats.wasted;
+}
@@ -0,0 +1,159 @@
+#ifndef TRACKPREFETCHER_H
+#define TRACKPREFETCHER_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QFuture>
+#include <QHash>
+#include <QIODevice>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <memory>
+
+/**
+ * @brief Read-only device serving a prefetched file head from memory
+ *
+ * The first head.size() bytes are answered from the prefetched buffer; the
+ * underlying file is only opened once the reader moves past them, so the
+ * start of playback never waits on a cold (e.g. NFS) read.
+ */
+class PrefetchedFileDevice : public QIODevice
+{
+public:
+    PrefetchedFileDevice(const QString& filePath, const QByteArray& head, qint64 fileSize,
+                         QObject* parent = nullptr);
+
+    bool isSequential() const override { return false; }
+    qint64 size() const override { return m_fileSize; }
+    bool seek(qint64 pos) override;
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override;
+    qint64 writeData(const char* data, qint64 maxSize) override;
+
+private:
+    QString m_filePath;
+    QByteArray m_head;
+    qint64 m_fileSize;
+    QFile m_file;
+};
+
+/**
+ * @brief Look-ahead loader for the next on-air item
+ *
+ * TrackPrefetcher reads the first few seconds of a file on a worker thread
+ * and keeps them in memory until the playback engine loads that file. A
+ * deck that finds its file prefetched decodes from a PrefetchedFileDevice
+ * instead of opening the file cold, which hides the first-read latency of
+ * network mounted libraries.
+ *
+ * Hits, misses and wasted prefetches are counted so the benefit can be
+ * checked in the logs. All methods are thread-safe.
+ *
+ * @example
+ * @code
+ * TrackPrefetcher prefetcher;
+ * prefetcher.prefetch("/nfs/music/next.ogg");   // when the current track starts
+ * ...
+ * std::unique_ptr<QIODevice> device = prefetcher.take("/nfs/music/next.ogg");
+ * if (device) decoder->setSourceDevice(device.get());
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class TrackPrefetcher
+{
+public:
+    /**
+     * @brief Prefetch counters
+     */
+    struct Statistics {
+        int requested = 0;        ///< prefetch() calls that started a read
+        int hits = 0;             ///< Loads served from a completed prefetch
+        int late = 0;             ///< Loads whose prefetch had not finished yet
+        int misses = 0;           ///< Loads of files that were never prefetched
+        int wasted = 0;           ///< Prefetches evicted without being used
+        int failed = 0;           ///< Prefetches that could not read the file
+        int borrowed = 0;         ///< Reads served by borrow(), leaving the prefetch in place
+        qint64 bytesRead = 0;     ///< Total bytes read ahead
+        qint64 totalReadMs = 0;   ///< Total time spent in prefetch reads
+
+        double hitRate() const
+        {
+            int loads = hits + late + misses;
+            return loads > 0 ? double(hits) / loads : 0.0;
+        }
+    };
+
+    TrackPrefetcher();
+    ~TrackPrefetcher();
+
+    /**
+     * @brief Start reading the head of a file in the background
+     * @param filePath Path of the audio file
+     */
+    void prefetch(const QString& filePath);
+
+    /**
+     * @brief Take the prefetched data for a file as a readable device
+     * @param filePath Path of the audio file
+     * @return Open device, or nullptr if the file was not (yet) prefetched
+     */
+    std::unique_ptr<QIODevice> take(const QString& filePath);
+
+    /**
+     * @brief Read the prefetched data for a file without taking it
+     *
+     * For a second reader of a file, such as the pre-listen of the next
+     * item: the head is shared, not copied, and stays for take().
+     * @param filePath Path of the audio file
+     * @return Open device, or nullptr if the file was not (yet) prefetched
+     */
+    std::unique_ptr<QIODevice> borrow(const QString& filePath);
+
+    /**
+     * @brief Set how much of each file is read ahead
+     * @param seconds Seconds of audio to prefetch
+     */
+    void setPrefetchSeconds(int seconds);
+    int prefetchSeconds() const;
+
+    Statistics statistics() const;
+
+    /**
+     * @brief Get the bytes held by the prefetched heads
+     */
+    qint64 memoryUsage() const;
+
+    /**
+     * @brief Drop the oldest prefetches until the heads hold at most the given bytes
+     * @param keepBytes Bytes to keep; a head a deck reads from stays until the deck is done
+     */
+    void shrink(qint64 keepBytes);
+
+private:
+    struct Entry {
+        QFuture<void> future;
+        QByteArray head;
+        qint64 fileSize = 0;
+        bool ok = false;
+    };
+
+    void evictOldest();
+    qint64 heldBytes() const;
+
+    static constexpr int MAX_ENTRIES = 2;
+    static constexpr qint64 MIN_PREFETCH_BYTES = 256 * 1024;
+    static constexpr qint64 MAX_PREFETCH_BYTES = 16 * 1024 * 1024;
+
+    mutable QMutex m_mutex;
+    QHash<QString, std::shared_ptr<Entry>> m_entries;
+    QStringList m_order;
+    QList<QFuture<void>> m_running;
+    int m_prefetchSeconds = 20;
+    Statistics m_stats;
+};
+
+#endif // TRACKPREFETCHER_H
@@ -0,0 +1,360 @@
+#include "TranscodeCache.h"
+#include "Tracer.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+#include <QTimer>
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+
+namespace {
+
+const QString CACHE_SUFFIX = ".wav";
+const QString PART_SUFFIX = ".part";
+
+} // namespace
+
+TranscodeCache::TranscodeCache(const QString& cacheDirectory, QObject* parent)
+    : QObject(parent)
+    , m_cacheDirectory(cacheDirectory)
+    , m_suffixes(defaultSuffixes())
+{
+    QDir().mkpath(m_cacheDirectory);
+    loadIndex();
+}
+
+TranscodeCache::~TranscodeCache()
+{
+    m_queue.clear();
+    abortWorkers();
+}
+
+QStringList TranscodeCache::defaultSuffixes()
+{
+#if defined(Q_OS_MACOS)
+    return {"ogg", "oga", "opus", "wma", "ape", "wv", "mpc"};
+#elif defined(Q_OS_WIN)
+    return {"ogg", "oga", "opus", "ape", "wv", "mpc"};
+#else
+    return {"wma", "ape", "wv", "mpc"};
+#endif
+}
+
+void TranscodeCache::setSuffixes(const QStringList& suffixes)
+{
+    m_suffixes.clear();
+    for (const QString& suffix : suffixes) {
+        m_suffixes.append(suffix.toLower());
+    }
+}
+
+void TranscodeCache::setMaxBytes(qint64 bytes)
+{
+    m_maxBytes = qMax<qint64>(0, bytes);
+    evict();
+}
+
+void TranscodeCache::setMaxWorkers(int workers)
+{
+    m_maxWorkers = qMax(1, workers);
+    schedule();
+}
+
+QString TranscodeCache::cachePath(const QString& source) const
+{
+    const QByteArray hash =
+        QCryptographicHash::hash(source.toUtf8(), QCryptographicHash::Sha1).toHex();
+    return QDir(m_cacheDirectory).filePath(QString::fromLatin1(hash) + CACHE_SUFFIX);
+}
+
+bool TranscodeCache::needsTranscode(const QString& source) const
+{
+    return m_suffixes.contains(QFileInfo(source).suffix().toLower());
+}
+
+bool TranscodeCache::isCached(const QString& source) const
+{
+    const QString path = cachePath(source);
+    if (!m_entries.contains(path)) {
+        return false;
+    }
+    const QFileInfo copy(path);
+    const QFileInfo original(source);
+    return copy.exists() && original.exists() && copy.lastModified() >= original.lastModified();
+}
+
+int TranscodeCache::prepare(const QStringList& sources, bool urgent)
+{
+    if (m_program.isEmpty()) {
+        return 0;
+    }
+
+    QStringList running;
+    for (const Worker& worker : std::as_const(m_workers)) {
+        running.append(worker.source);
+    }
+
+    QStringList added;
+    for (const QString& source : sources) {
+        if (source.isEmpty() || !needsTranscode(source) || isCached(source) ||
+            running.contains(source) || added.contains(source)) {
+            continue;
+        }
+        if (urgent) {
+            m_queue.removeAll(source);
+        } else if (m_queue.contains(source)) {
+            continue;
+        }
+        added.append(source);
+    }
+
+    if (urgent) {
+        m_queue = added + m_queue;
+    } else {
+        m_queue += added;
+    }
+    schedule();
+    return added.size();
+}
+
+QString TranscodeCache::resolve(const QString& source)
+{
+    TraceSpan span("cache", "TranscodeCache::resolve");
+    if (!needsTranscode(source)) {
+        return source;
+    }
+
+    if (isCached(source)) {
+        const QString path = cachePath(source);
+        ++m_hits;
+        touch(path);
+        m_pinned.removeAll(path);
+        m_pinned.prepend(path);
+        while (m_pinned.size() > PINNED_ENTRIES) {
+            m_pinned.removeLast();
+        }
+        return path;
+    }
+
+    ++m_misses;
+    qDebug() << "TranscodeCache: no copy of" << source << "yet, playing the original";
+    prepare({source}, true);
+    return source;
+}
+
+TranscodeCache::Statistics TranscodeCache::statistics() const
+{
+    Statistics stats;
+    stats.hits = m_hits;
+    stats.misses = m_misses;
+    stats.transcoded = m_transcoded;
+    stats.failed = m_failed;
+    stats.evicted = m_evicted;
+    stats.entries = m_entries.size();
+    stats.bytes = m_bytes;
+    return stats;
+}
+
+void TranscodeCache::loadIndex()
+{
+    QDir directory(m_cacheDirectory);
+    for (const QFileInfo& part : directory.entryInfoList({"*" + PART_SUFFIX}, QDir::Files)) {
+        QFile::remove(part.filePath());
+    }
+    for (const QFileInfo& copy : directory.entryInfoList({"*" + CACHE_SUFFIX}, QDir::Files)) {
+        Entry entry;
+        entry.bytes = copy.size();
+        entry.lastUsedMs = copy.lastModified().toMSecsSinceEpoch();
+        m_entries.insert(copy.filePath(), entry);
+        m_bytes += entry.bytes;
+    }
+    evict();
+}
+
+void TranscodeCache::schedule()
+{
+    while (!m_program.isEmpty() && m_workers.size() < m_maxWorkers && !m_queue.isEmpty()) {
+        startJob(m_queue.takeFirst());
+    }
+}
+
+void TranscodeCache::startJob(const QString& source)
+{
+    if (!QFileInfo(source).isFile()) {
+        ++m_failed;
+        qWarning() << QString("TranscodeCache::startJob - %1: Source file is missing").arg(source);
+        emit failed(source, "Source file is missing");
+        return;
+    }
+
+    const QString partPath = cachePath(source) + PART_SUFFIX;
+    QFile::remove(partPath);
+
+    // Tags are left out; the copy is only ever decoded
+    const QStringList arguments{"-nostdin", "-y",  "-hide_banner", "-loglevel", "error",
+                                "-i",       source, "-vn",         "-map_metadata", "-1",
+                                "-c:a",     "pcm_s16le", "-f",     "wav",       partPath};
+
+    QProcess* process = new QProcess(this);
+#ifdef Q_OS_UNIX
+    process->setChildProcessModifier(
+        []() { [[maybe_unused]] int niceness = ::nice(WORKER_NICE_INCREMENT); });
+#endif
+
+    Worker worker;
+    worker.source = source;
+    if (m_timeoutMs > 0) {
+        worker.timeout = new QTimer(process);
+        worker.timeout->setSingleShot(true);
+        connect(worker.timeout, &QTimer::timeout, this, [this, process]() {
+            const auto it = m_workers.find(process);
+            if (it != m_workers.end()) {
+                it.value().timedOut = true;
+                process->kill();
+            }
+        });
+        worker.timeout->start(m_timeoutMs);
+    }
+
+    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
+            [this, process](int exitCode, QProcess::ExitStatus exitStatus) {
+                QString error;
+                if (m_workers.value(process).timedOut) {
+                    error = QString("Timed out after %1 s").arg(m_timeoutMs / 1000);
+                } else if (exitStatus != QProcess::NormalExit) {
+                    error = "ffmpeg crashed";
+                } else if (exitCode != 0) {
+                    const QString output =
+                        QString::fromLocal8Bit(process->readAllStandardError()).trimmed();
+                    error = QString("ffmpeg exited with code %1: %2")
+                                .arg(exitCode)
+                                .arg(output.section('\n', -1));
+                }
+                onWorkerFinished(process, error);
+            });
+    connect(process, &QProcess::errorOccurred, this, [this, process](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart) {
+            onWorkerFinished(process, process->errorString());
+        }
+    });
+
+    m_workers.insert(process, worker);
+    qDebug() << "TranscodeCache: converting" << source;
+    process->start(m_program, arguments);
+}
+
+void TranscodeCache::onWorkerFinished(QProcess* process, const QString& error)
+{
+    const auto it = m_workers.constFind(process);
+    if (it == m_workers.cend()) {
+        return;
+    }
+    const QString source = it.value().source;
+    m_workers.remove(process);
+    process->disconnect(this);
+    process->deleteLater();
+
+    const QString failure = error.isEmpty() ? commit(source) : error;
+    if (failure.isEmpty()) {
+        ++m_transcoded;
+        evict();
+        emit prepared(source, cachePath(source));
+    } else {
+        QFile::remove(cachePath(source) + PART_SUFFIX);
+        ++m_failed;
+        qWarning() << QString("TranscodeCache::onWorkerFinished - %1: %2").arg(source, failure);
+        emit failed(source, failure);
+    }
+    schedule();
+}
+
+QString TranscodeCache::commit(const QString& source)
+{
+    const QString path = cachePath(source);
+    const QString partPath = path + PART_SUFFIX;
+    const QFileInfo part(partPath);
+    if (!part.isFile() || part.size() == 0) {
+        return "ffmpeg wrote no output";
+    }
+
+    // rename() replaces a stale copy in one step, so a deck never opens half a file
+    std::error_code renameError;
+    std::filesystem::rename(QFile(partPath).filesystemFileName(),
+                            QFile(path).filesystemFileName(), renameError);
+    if (renameError) {
+        return QString("Cannot move the copy into place: %1")
+            .arg(QString::fromStdString(renameError.message()));
+    }
+
+    Entry entry;
+    entry.bytes = part.size();
+    entry.lastUsedMs = QDateTime::currentMSecsSinceEpoch();
+    m_bytes += entry.bytes - m_entries.value(path).bytes;
+    m_entries.insert(path, entry);
+    return QString();
+}
+
+void TranscodeCache::touch(const QString& path)
+{
+    const QDateTime now = QDateTime::currentDateTime();
+    m_entries[path].lastUsedMs = now.toMSecsSinceEpoch();
+    QFile file(path);
+    if (file.open(QIODevice::ReadWrite)) {
+        file.setFileTime(now, QFileDevice::FileModificationTime);
+    }
+}
+
+void TranscodeCache::evict()
+{
+    if (m_bytes <= m_maxBytes) {
+        return;
+    }
+
+    std::vector<std::pair<qint64, QString>> candidates;
+    for (auto it = m_entries.cbegin(); it != m_entries.cend(); ++it) {
+        if (!m_pinned.contains(it.key())) {
+            candidates.emplace_back(it.value().lastUsedMs, it.key());
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    for (const auto& candidate : candidates) {
+        if (m_bytes <= m_maxBytes) {
+            break;
+        }
+        const QString& path = candidate.second;
+        // A copy a deck still has open cannot be removed on Windows; it goes next time
+        if (!QFile::remove(path) && QFileInfo::exists(path)) {
+            continue;
+        }
+        m_bytes -= m_entries.value(path).bytes;
+        m_entries.remove(path);
+        ++m_evicted;
+        qDebug() << "TranscodeCache: evicted" << path;
+    }
+}
+
+void TranscodeCache::abortWorkers()
+{
+    const QList<QProcess*> processes = m_workers.keys();
+    for (QProcess* process : processes) {
+        const QString partPath = cachePath(m_workers.value(process).source) + PART_SUFFIX;
+        process->disconnect(this);
+        process->kill();
+        process->waitForFinished(1000);
+        QFile::remove(partPath);
+        delete process;
+    }
+    m_workers.clear();
+}
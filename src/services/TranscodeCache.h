@@ -0,0 +1,219 @@
+#ifndef TRANSCODECACHE_H
+#define TRANSCODECACHE_H
+
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+class QProcess;
+class QTimer;
+
+/**
+ * @brief Keeps WAV copies of the queued tracks the platform decoder handles badly
+ *
+ * The decks decode through the platform's media backend. AVFoundation on
+ * macOS cannot read Ogg, Opus or WMA at all, Media Foundation on Windows
+ * cannot read Ogg or Opus, and GStreamer needs extra plugins for some
+ * formats. Other formats, such as Monkey's Audio, are slow to set up
+ * everywhere. A track in one of those formats fails or stalls when it
+ * should go on air.
+ *
+ * TranscodeCache converts such tracks with ffmpeg to 16-bit PCM WAV in a
+ * cache directory as soon as they are queued, with one low-priority worker
+ * by default. WAV is the one intermediate every backend opens instantly;
+ * Opus would need the very decoders that are missing. Copies are named
+ * after a hash of the track's path, and a copy older than its track is
+ * made again.
+ *
+ * The cache is kept within maxBytes() by removing the copies that were
+ * played least recently. Playing a copy touches its file, so the order
+ * survives a restart. The PINNED_ENTRIES copies resolved last, the one on
+ * air and the one queued after it, are never removed.
+ *
+ * @example
+ * @code
+ * TranscodeCache* cache = new TranscodeCache(cacheDir + "/transcoded", this);
+ * cache->setProgram(QStandardPaths::findExecutable("ffmpeg"));
+ * cache->prepare(nextTracks);
+ * playbackEngine->setSourceResolver([cache](const QString& path) { return cache->resolve(path); });
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class TranscodeCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Counters since the cache was created
+     */
+    struct Statistics {
+        int hits = 0;         ///< resolve() calls served from a copy
+        int misses = 0;       ///< resolve() calls for tracks whose copy was not ready
+        int transcoded = 0;   ///< Copies made
+        int failed = 0;       ///< Conversions that failed
+        int evicted = 0;      ///< Copies removed to stay within maxBytes()
+        int entries = 0;      ///< Copies in the cache now
+        qint64 bytes = 0;     ///< Size of the cache now
+
+        double hitRate() const
+        {
+            const int lookups = hits + misses;
+            return lookups > 0 ? double(hits) / lookups : 0.0;
+        }
+    };
+
+    static constexpr qint64 DEFAULT_MAX_BYTES = 2LL * 1024 * 1024 * 1024;
+    static constexpr int DEFAULT_MAX_WORKERS = 1;
+    static constexpr int DEFAULT_TIMEOUT_MS = 5 * 60 * 1000;
+    static constexpr int WORKER_NICE_INCREMENT = 10;
+    static constexpr int PINNED_ENTRIES = 2;
+
+    /**
+     * @brief Open a cache directory, creating it if needed
+     *
+     * Copies already in it are counted; conversions a crash interrupted
+     * are removed.
+     * @param cacheDirectory Directory that holds the copies
+     * @param parent Parent object
+     */
+    explicit TranscodeCache(const QString& cacheDirectory, QObject* parent = nullptr);
+    ~TranscodeCache() override;
+
+    /**
+     * @brief Get the suffixes converted by default on this platform
+     * @return Lowercase suffixes without the dot
+     */
+    static QStringList defaultSuffixes();
+
+    void setSuffixes(const QStringList& suffixes);
+    QStringList suffixes() const { return m_suffixes; }
+
+    /**
+     * @brief Set the ffmpeg executable
+     * @param program Path of ffmpeg; without one, tracks always play from their own file
+     */
+    void setProgram(const QString& program) { m_program = program; }
+    QString program() const { return m_program; }
+
+    /**
+     * @brief Set how large the cache may grow, removing copies if it is over
+     * @param bytes Size limit; DEFAULT_MAX_BYTES by default
+     */
+    void setMaxBytes(qint64 bytes);
+    qint64 maxBytes() const { return m_maxBytes; }
+
+    void setMaxWorkers(int workers);
+    int maxWorkers() const { return m_maxWorkers; }
+
+    void setTimeout(int timeoutMs) { m_timeoutMs = qMax(0, timeoutMs); }
+    int timeout() const { return m_timeoutMs; }
+
+    QString cacheDirectory() const { return m_cacheDirectory; }
+
+    /**
+     * @brief Get where the copy of a track is kept
+     * @param source Path of the track
+     */
+    QString cachePath(const QString& source) const;
+
+    /**
+     * @brief Check whether a track is in a format that is converted
+     * @param source Path of the track
+     */
+    bool needsTranscode(const QString& source) const;
+
+    /**
+     * @brief Check whether a track has a copy newer than itself
+     * @param source Path of the track
+     */
+    bool isCached(const QString& source) const;
+
+    /**
+     * @brief Convert tracks in the background
+     *
+     * Tracks that need no conversion, already have a copy, or are already
+     * waiting are skipped.
+     * @param sources Paths of the tracks
+     * @param urgent Put them in front of the tracks already waiting
+     * @return Number of tracks added to the queue
+     */
+    int prepare(const QStringList& sources, bool urgent = false);
+
+    /**
+     * @brief Get the file to play for a track
+     *
+     * Counts a hit when the copy is ready and a miss when it is not. A miss
+     * plays the track's own file and puts its conversion in front of the
+     * queue for the next time.
+     * @param source Path of the track
+     * @return Path of the copy, or source if it needs no conversion or has no copy yet
+     */
+    QString resolve(const QString& source);
+
+    /**
+     * @brief Get the number of conversions not finished yet
+     */
+    int pendingCount() const { return m_queue.size() + m_workers.size(); }
+
+    Statistics statistics() const;
+
+signals:
+    /**
+     * @brief Emitted when the copy of a track is ready
+     * @param source Path of the track
+     * @param cachePath Path of the copy
+     */
+    void prepared(const QString& source, const QString& cachePath);
+
+    /**
+     * @brief Emitted when a track could not be converted
+     * @param source Path of the track
+     * @param error Why it failed
+     */
+    void failed(const QString& source, const QString& error);
+
+private:
+    struct Entry {
+        qint64 bytes = 0;
+        qint64 lastUsedMs = 0;
+    };
+
+    struct Worker {
+        QString source;
+        QTimer* timeout = nullptr;
+        bool timedOut = false;
+    };
+
+    void loadIndex();
+    void schedule();
+    void startJob(const QString& source);
+    void onWorkerFinished(QProcess* process, const QString& error);
+    QString commit(const QString& source);
+    void touch(const QString& path);
+    void evict();
+    void abortWorkers();
+
+    QString m_cacheDirectory;
+    QStringList m_suffixes;
+    QString m_program;
+    qint64 m_maxBytes = DEFAULT_MAX_BYTES;
+    int m_maxWorkers = DEFAULT_MAX_WORKERS;
+    int m_timeoutMs = DEFAULT_TIMEOUT_MS;
+
+    QHash<QString, Entry> m_entries;   ///< Copies by path
+    qint64 m_bytes = 0;
+    QStringList m_pinned;              ///< Copies resolved last, most recent first
+    QStringList m_queue;
+    QHash<QProcess*, Worker> m_workers;
+
+    int m_hits = 0;
+    int m_misses = 0;
+    int m_transcoded = 0;
+    int m_failed = 0;
+    int m_evicted = 0;
+};
+
+#endif // TRANSCODECACHE_H
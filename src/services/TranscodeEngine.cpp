@@ -0,0 +1,565 @@
+#include "TranscodeEngine.h"
+#include "BackgroundThrottle.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QThread>
+#include <QTimer>
+#include <filesystem>
+#include <system_error>
+
+namespace {
+
+const QString STATE_PENDING = "pending";
+const QString STATE_RUNNING = "running";
+const QString STATE_DONE = "done";
+const QString STATE_FAILED = "failed";
+
+} // namespace
+
+TranscodeEngine::TranscodeEngine(QSqlDatabase& database, QObject* parent)
+    : QObject(parent)
+    , m_database(database)
+    , m_maxWorkers(qMax(1, QThread::idealThreadCount()))
+    , m_progressTimer(new QTimer(this))
+{
+    m_progressTimer->setSingleShot(true);
+    m_progressTimer->setInterval(PROGRESS_INTERVAL_MS);
+    connect(m_progressTimer, &QTimer::timeout, this,
+            [this]() { emit progressChanged(progress()); });
+}
+
+TranscodeEngine::~TranscodeEngine()
+{
+    // The rows stay "running"; initialize() queues them again next time
+    abortWorkers();
+}
+
+bool TranscodeEngine::initialize()
+{
+    if (m_initialized) {
+        return true;
+    }
+    if (!m_database.isOpen()) {
+        logError("initialize", "Database is not open");
+        return false;
+    }
+    if (!ensureTable()) {
+        return false;
+    }
+
+    recover();
+    loadQueue();
+    m_initialized = true;
+    return true;
+}
+
+void TranscodeEngine::setEncoder(const QString& suffix, const QStringList& arguments)
+{
+    m_encoders.insert(suffix.toLower(), arguments);
+}
+
+void TranscodeEngine::setMaxWorkers(int workers)
+{
+    m_maxWorkers = qMax(1, workers);
+    schedule();
+}
+
+QString TranscodeEngine::targetPath(const QString& source, const QString& suffix)
+{
+    const QFileInfo info(source);
+    return QDir(info.path()).filePath(info.completeBaseName() + "." + suffix);
+}
+
+QString TranscodeEngine::partPathFor(const QString& target)
+{
+    // Same directory, so the final rename never crosses file systems; the
+    // suffix is kept because ffmpeg picks the container from it
+    const QFileInfo info(target);
+    return QDir(info.path()).filePath("." + info.completeBaseName() + ".xfb-part." + info.suffix());
+}
+
+int TranscodeEngine::enqueue(const QStringList& sources, const QString& suffix)
+{
+    if (!initialize()) {
+        return 0;
+    }
+    if (!m_encoders.contains(suffix.toLower())) {
+        logError("enqueue", QString("No encoder registered for .%1").arg(suffix));
+        return 0;
+    }
+
+    QSqlQuery inLibrary(m_database);
+    inLibrary.prepare("SELECT 1 FROM musics WHERE path = :path LIMIT 1");
+    QSqlQuery retry(m_database);
+    retry.prepare("UPDATE transcode_jobs SET state = :pending, error = NULL, updated_at = :now "
+                  "WHERE source = :source AND state = :failed");
+    QSqlQuery insert(m_database);
+    insert.prepare("INSERT OR IGNORE INTO transcode_jobs (source, target, state, updated_at) "
+                   "VALUES (:source, :target, :pending, :now)");
+
+    const qint64 now = QDateTime::currentSecsSinceEpoch();
+    int queued = 0;
+    int skipped = 0;
+    m_database.transaction();
+    for (const QString& source : sources) {
+        if (QFileInfo(source).suffix().compare(suffix, Qt::CaseInsensitive) == 0) {
+            continue;
+        }
+        const QString target = targetPath(source, suffix);
+
+        // song.mp3 next to a song.ogg of its own must not overwrite it
+        inLibrary.bindValue(":path", target);
+        if (inLibrary.exec() && inLibrary.next()) {
+            ++skipped;
+            continue;
+        }
+
+        retry.bindValue(":pending", STATE_PENDING);
+        retry.bindValue(":now", now);
+        retry.bindValue(":source", source);
+        retry.bindValue(":failed", STATE_FAILED);
+        if (retry.exec() && retry.numRowsAffected() > 0) {
+            --m_failed;
+            m_queue.append({source, target});
+            ++queued;
+            continue;
+        }
+
+        insert.bindValue(":source", source);
+        insert.bindValue(":target", target);
+        insert.bindValue(":pending", STATE_PENDING);
+        insert.bindValue(":now", now);
+        if (!insert.exec()) {
+            logError("enqueue", QString("SQL Error: %1").arg(insert.lastError().text()),
+                     insert.lastQuery());
+            continue;
+        }
+        if (insert.numRowsAffected() > 0) {
+            ++m_total;
+            m_queue.append({source, target});
+            ++queued;
+        }
+    }
+    if (!m_database.commit()) {
+        logError("enqueue", QString("SQL Error: %1").arg(m_database.lastError().text()));
+    }
+
+    if (skipped > 0) {
+        qInfo() << "TranscodeEngine: skipped" << skipped
+                << "tracks whose target is already in the library";
+    }
+    qInfo() << "TranscodeEngine: queued" << queued << "conversions to ." << suffix;
+    emit progressChanged(progress());
+    schedule();
+    return queued;
+}
+
+void TranscodeEngine::start()
+{
+    if (!initialize()) {
+        return;
+    }
+    m_running = true;
+    schedule();
+}
+
+void TranscodeEngine::stop()
+{
+    if (!m_running && m_workers.isEmpty()) {
+        return;
+    }
+    m_running = false;
+
+    QList<Job> interrupted;
+    for (const Worker& worker : std::as_const(m_workers)) {
+        interrupted.append(worker.job);
+    }
+    abortWorkers();
+    for (const Job& job : std::as_const(interrupted)) {
+        setState(job.source, STATE_PENDING);
+    }
+    m_queue = interrupted + m_queue;
+
+    qInfo() << "TranscodeEngine: stopped with" << m_queue.size() << "conversions left";
+    emit progressChanged(progress());
+}
+
+TranscodeEngine::Progress TranscodeEngine::progress() const
+{
+    Progress progress;
+    progress.total = m_total;
+    progress.done = m_done;
+    progress.failed = m_failed;
+    progress.running = m_workers.size();
+    if (m_total > 0) {
+        qint64 units = qint64(m_done + m_failed) * 1000;
+        for (const Worker& worker : m_workers) {
+            if (worker.durationUs > 0) {
+                units += qBound<qint64>(0, worker.doneUs * 1000 / worker.durationUs, 999);
+            }
+        }
+        progress.permille = int(units / m_total);
+    }
+    return progress;
+}
+
+bool TranscodeEngine::ensureTable()
+{
+    QSqlQuery query(m_database);
+    const QString sql = "CREATE TABLE IF NOT EXISTS transcode_jobs ("
+                        "id INTEGER PRIMARY KEY AUTOINCREMENT, "
+                        "source TEXT UNIQUE NOT NULL, "
+                        "target TEXT NOT NULL, "
+                        "state TEXT NOT NULL, "
+                        "attempts INTEGER NOT NULL DEFAULT 0, "
+                        "error TEXT, "
+                        "updated_at INTEGER)";
+
+    if (!query.exec(sql)) {
+        QString error = QString("SQL Error: %1").arg(query.lastError().text());
+        logError("ensureTable", error, sql);
+        emit operationError("ensureTable", error);
+        return false;
+    }
+
+    return true;
+}
+
+void TranscodeEngine::recover()
+{
+    QSqlQuery query(m_database);
+    query.setForwardOnly(true);
+    if (!query.exec("SELECT source, target, state FROM transcode_jobs "
+                    "WHERE state IN ('running', 'done')")) {
+        logError("recover", QString("SQL Error: %1").arg(query.lastError().text()),
+                 query.lastQuery());
+        return;
+    }
+
+    QStringList interrupted;
+    while (query.next()) {
+        const QString source = query.value(0).toString();
+        const QString target = query.value(1).toString();
+        if (query.value(2).toString() == STATE_RUNNING) {
+            QFile::remove(partPathFor(target));
+            interrupted.append(source);
+        } else if (QFile::exists(source) && QFile::exists(target)) {
+            // The library moved to the target; only the old file was left to remove
+            qInfo() << "TranscodeEngine: removing" << source << "left over from an interrupted run";
+            QFile::remove(source);
+        }
+    }
+
+    for (const QString& source : std::as_const(interrupted)) {
+        setState(source, STATE_PENDING);
+    }
+    if (!interrupted.isEmpty()) {
+        qInfo() << "TranscodeEngine:" << interrupted.size()
+                << "conversions were interrupted and are queued again";
+    }
+}
+
+void TranscodeEngine::loadQueue()
+{
+    m_queue.clear();
+    m_total = 0;
+    m_done = 0;
+    m_failed = 0;
+
+    QSqlQuery query(m_database);
+    query.setForwardOnly(true);
+    if (!query.exec("SELECT source, target, state FROM transcode_jobs ORDER BY id")) {
+        logError("loadQueue", QString("SQL Error: %1").arg(query.lastError().text()),
+                 query.lastQuery());
+        return;
+    }
+
+    while (query.next()) {
+        const QString state = query.value(2).toString();
+        ++m_total;
+        if (state == STATE_DONE) {
+            ++m_done;
+        } else if (state == STATE_FAILED) {
+            ++m_failed;
+        } else {
+            m_queue.append({query.value(0).toString(), query.value(1).toString()});
+        }
+    }
+
+    // A run that ended before its finished jobs were cleared away
+    if (m_queue.isEmpty() && m_done > 0) {
+        QSqlQuery clear(m_database);
+        clear.prepare("DELETE FROM transcode_jobs WHERE state = :done");
+        clear.bindValue(":done", STATE_DONE);
+        clear.exec();
+        m_total -= m_done;
+        m_done = 0;
+    }
+
+    if (!m_queue.isEmpty()) {
+        qInfo() << "TranscodeEngine:" << m_queue.size() << "of" << m_total
+                << "conversions left from an earlier run";
+    }
+}
+
+void TranscodeEngine::schedule()
+{
+    // Fewer encoders while the broadcast needs the machine, never none
+    const int workers = BackgroundThrottle::workerLimit(m_maxWorkers);
+    while (m_running && m_workers.size() < workers && !m_queue.isEmpty()) {
+        startJob(m_queue.takeFirst());
+    }
+
+    if (m_running && m_workers.isEmpty() && m_queue.isEmpty()) {
+        m_running = false;
+
+        QSqlQuery clear(m_database);
+        clear.prepare("DELETE FROM transcode_jobs WHERE state = :done");
+        clear.bindValue(":done", STATE_DONE);
+        if (!clear.exec()) {
+            logError("schedule", QString("SQL Error: %1").arg(clear.lastError().text()),
+                     clear.lastQuery());
+        }
+        m_total -= m_done;
+        m_done = 0;
+
+        const int succeeded = m_sessionDone;
+        const int failed = m_sessionFailed;
+        m_sessionDone = 0;
+        m_sessionFailed = 0;
+        qInfo() << "TranscodeEngine: queue empty," << succeeded << "converted," << failed
+                << "failed";
+        emit finished(succeeded, failed);
+    }
+}
+
+void TranscodeEngine::startJob(const Job& job)
+{
+    const QString suffix = QFileInfo(job.target).suffix().toLower();
+
+    Worker worker;
+    worker.job = job;
+    worker.partPath = partPathFor(job.target);
+
+    QString error;
+    if (!m_encoders.contains(suffix)) {
+        error = QString("No encoder registered for .%1").arg(suffix);
+    } else if (!QFileInfo(job.source).isFile()) {
+        error = "Source file is missing";
+    }
+    if (!error.isEmpty()) {
+        setState(job.source, STATE_FAILED, error);
+        ++m_failed;
+        ++m_sessionFailed;
+        logError("run", QString("%1: %2").arg(job.source, error));
+        emit jobFinished(job.source, job.target, false, error);
+        emit progressChanged(progress());
+        return;
+    }
+
+    worker.durationUs = m_durationOf ? m_durationOf(job.source) : -1;
+    QFile::remove(worker.partPath);
+
+    // Parallelism comes from the pool, so each encoder gets one thread
+    QStringList arguments{"-nostdin", "-y", "-hide_banner", "-loglevel", "error", "-nostats",
+                          "-progress", "pipe:1", "-i", job.source, "-threads", "1"};
+    arguments << m_encoders.value(suffix) << worker.partPath;
+
+    QProcess* process = new QProcess(this);
+#ifdef Q_OS_UNIX
+    process->setChildProcessModifier(
+        []() { BackgroundThrottle::lowerChildProcess(WORKER_NICE_INCREMENT); });
+#endif
+
+    if (m_timeoutMs > 0) {
+        worker.timeout = new QTimer(process);
+        worker.timeout->setSingleShot(true);
+        connect(worker.timeout, &QTimer::timeout, this, [this, process]() {
+            m_workers[process].timedOut = true;
+            process->kill();
+        });
+        worker.timeout->start(m_timeoutMs);
+    }
+
+    connect(process, &QProcess::readyReadStandardOutput, this, [this, process]() {
+        Worker& worker = m_workers[process];
+        while (process->canReadLine()) {
+            const QByteArray line = process->readLine().trimmed();
+            // Older ffmpeg releases call the microsecond value out_time_ms
+            if (line.startsWith("out_time_us=") || line.startsWith("out_time_ms=")) {
+                worker.doneUs = line.mid(line.indexOf('=') + 1).toLongLong();
+            }
+        }
+        if (!m_progressTimer->isActive()) {
+            m_progressTimer->start();
+        }
+    });
+    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
+            [this, process](int exitCode, QProcess::ExitStatus exitStatus) {
+                QString error;
+                if (m_workers.value(process).timedOut) {
+                    error = QString("Timed out after %1 s").arg(m_timeoutMs / 1000);
+                } else if (exitStatus != QProcess::NormalExit) {
+                    error = "ffmpeg crashed";
+                } else if (exitCode != 0) {
+                    const QString output =
+                        QString::fromLocal8Bit(process->readAllStandardError()).trimmed();
+                    error = QString("ffmpeg exited with code %1: %2")
+                                .arg(exitCode)
+                                .arg(output.section('\n', -1));
+                }
+                onWorkerFinished(process, error);
+            });
+    connect(process, &QProcess::errorOccurred, this, [this, process](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart) {
+            onWorkerFinished(process, process->errorString());
+        }
+    });
+
+    m_workers.insert(process, worker);
+    setState(job.source, STATE_RUNNING);
+    emit jobStarted(job.source);
+    qDebug() << "TranscodeEngine: converting" << job.source << "to" << job.target;
+    process->start(m_program, arguments);
+}
+
+void TranscodeEngine::onWorkerFinished(QProcess* process, const QString& error)
+{
+    const auto it = m_workers.constFind(process);
+    if (it == m_workers.cend()) {
+        return;
+    }
+    const Worker worker = it.value();
+    m_workers.remove(process);
+    process->disconnect(this);
+    process->deleteLater();
+
+    QString failure = error;
+    if (failure.isEmpty()) {
+        failure = commit(worker.job, worker.partPath);
+    }
+
+    if (failure.isEmpty()) {
+        ++m_done;
+        ++m_sessionDone;
+        qInfo() << "TranscodeEngine: converted" << worker.job.source << "->" << worker.job.target;
+    } else {
+        QFile::remove(worker.partPath);
+        setState(worker.job.source, STATE_FAILED, failure);
+        ++m_failed;
+        ++m_sessionFailed;
+        logError("run", QString("%1: %2").arg(worker.job.source, failure));
+    }
+    emit jobFinished(worker.job.source, worker.job.target, failure.isEmpty(), failure);
+    emit progressChanged(progress());
+    schedule();
+}
+
+QString TranscodeEngine::commit(const Job& job, const QString& partPath)
+{
+    const QFileInfo part(partPath);
+    if (!part.isFile() || part.size() == 0) {
+        return "ffmpeg wrote no output";
+    }
+
+    // rename() replaces the target in one step, so it is never half written
+    std::error_code renameError;
+    std::filesystem::rename(QFile(partPath).filesystemFileName(),
+                            QFile(job.target).filesystemFileName(), renameError);
+    if (renameError) {
+        return QString("Cannot move the result into place: %1")
+            .arg(QString::fromStdString(renameError.message()));
+    }
+
+    // The track points at the new file exactly when its job says done
+    QString error;
+    if (!m_database.transaction()) {
+        error = m_database.lastError().text();
+    } else {
+        QSqlQuery track(m_database);
+        track.prepare("UPDATE musics SET path = :target WHERE path = :source");
+        track.bindValue(":target", job.target);
+        track.bindValue(":source", job.source);
+
+        QSqlQuery state(m_database);
+        state.prepare("UPDATE transcode_jobs SET state = :done, error = NULL, updated_at = :now "
+                      "WHERE source = :source");
+        state.bindValue(":done", STATE_DONE);
+        state.bindValue(":now", QDateTime::currentSecsSinceEpoch());
+        state.bindValue(":source", job.source);
+
+        if (!track.exec()) {
+            error = track.lastError().text();
+        } else if (!state.exec()) {
+            error = state.lastError().text();
+        } else if (!m_database.commit()) {
+            error = m_database.lastError().text();
+        }
+        if (!error.isEmpty()) {
+            m_database.rollback();
+        }
+    }
+    if (!error.isEmpty()) {
+        // The library still plays the source; the converted copy is dropped
+        QFile::remove(job.target);
+        emit operationError("commit", error);
+        return QString("Cannot update the library: %1").arg(error);
+    }
+
+    if (!QFile::remove(job.source)) {
+        logError("commit", QString("Converted, but %1 could not be removed").arg(job.source));
+    }
+    return QString();
+}
+
+void TranscodeEngine::setState(const QString& source, const QString& state, const QString& error)
+{
+    QSqlQuery query(m_database);
+    query.prepare("UPDATE transcode_jobs SET state = :state, error = :error, updated_at = :now, "
+                  "attempts = attempts + :started WHERE source = :source");
+    query.bindValue(":state", state);
+    query.bindValue(":error", error.isEmpty() ? QVariant() : QVariant(error));
+    query.bindValue(":now", QDateTime::currentSecsSinceEpoch());
+    query.bindValue(":started", state == STATE_RUNNING ? 1 : 0);
+    query.bindValue(":source", source);
+    if (!query.exec()) {
+        logError("setState", QString("SQL Error: %1").arg(query.lastError().text()),
+                 query.lastQuery());
+    }
+}
+
+void TranscodeEngine::abortWorkers()
+{
+    for (auto it = m_workers.cbegin(); it != m_workers.cend(); ++it) {
+        QProcess* process = it.key();
+        process->disconnect(this);
+        if (it->timeout) {
+            it->timeout->stop();
+        }
+        if (process->state() == QProcess::NotRunning) {
+            process->deleteLater();
+        } else {
+            connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), process,
+                    &QObject::deleteLater);
+            process->kill();
+        }
+        QFile::remove(it->partPath);
+    }
+    m_workers.clear();
+}
+
+void TranscodeEngine::logError(const QString& operation, const QString& error, const QString& query)
+{
+    QString logMessage = QString("TranscodeEngine::%1 - %2").arg(operation, error);
+    if (!query.isEmpty()) {
+        logMessage += QString(" (Query: %1)").arg(query);
+    }
+
+    qWarning() << logMessage;
+}
@@ -0,0 +1,239 @@
+#ifndef TRANSCODEENGINE_H
+#define TRANSCODEENGINE_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QSqlDatabase>
+#include <QString>
+#include <QStringList>
+#include <functional>
+
+class QProcess;
+class QTimer;
+
+/**
+ * @brief Converts library files with a pool of ffmpeg workers, resumably
+ *
+ * The library conversion actions walked the musics table and ran one
+ * ffmpeg at a time, pumping the event loop in between. A large library
+ * took days, leaving all but one core idle. The conversion could not be
+ * interrupted without starting over, and a failed move could leave a track
+ * with no file at all.
+ *
+ * TranscodeEngine keeps its jobs in the transcode_jobs table of the
+ * application database and runs up to maxWorkers() of them at once. Each
+ * worker is a single-threaded ffmpeg at lower CPU priority, so on-air
+ * playback keeps its share. A job writes a hidden part file next to its
+ * target. Only once that part file is complete is it renamed over the
+ * target. The musics row and the job state are then updated in one
+ * transaction, and the source file is removed last. A crash at any point
+ * leaves the track playable from either its old file or its new one.
+ *
+ * initialize() puts jobs that were running when the application stopped
+ * back in the queue and finishes removing sources that were left behind.
+ * start() then continues with the jobs that are left. Finished jobs stay in the
+ * table until the queue is empty, so the progress of a resumed conversion
+ * includes what was done before the restart.
+ *
+ * The targets of a batch use the encoder registered for their suffix with
+ * setEncoder(). If a duration provider is set, ffmpeg's progress output
+ * gives each running job a fraction, which is rolled into progress().
+ *
+ * @example
+ * @code
+ * TranscodeEngine* engine = new TranscodeEngine(db, this);
+ * engine->setEncoder("ogg", {"-vn", "-c:a", "libvorbis", "-qscale:a", "7"});
+ * engine->initialize();
+ * engine->enqueue(allLibraryPaths, "ogg");
+ * connect(engine, &TranscodeEngine::progressChanged, this,
+ *         [](const TranscodeEngine::Progress& progress) { qDebug() << progress.permille; });
+ * engine->start();
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class TranscodeEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief State of the jobs in the table
+     */
+    struct Progress {
+        int total = 0;     ///< Jobs in the table
+        int done = 0;      ///< Converted
+        int failed = 0;    ///< Given up on
+        int running = 0;   ///< In a worker right now
+        int permille = 0;  ///< Finished jobs plus the fractions of running ones, of total
+    };
+
+    /// Duration of a source in microseconds, or -1 if it is not known
+    using DurationProvider = std::function<qint64(const QString& filePath)>;
+
+    static constexpr int DEFAULT_TIMEOUT_MS = 10 * 60 * 1000;
+    /// Added to the niceness of every worker on Unix
+    static constexpr int WORKER_NICE_INCREMENT = 10;
+    static constexpr int PROGRESS_INTERVAL_MS = 250;
+
+    explicit TranscodeEngine(QSqlDatabase& database, QObject* parent = nullptr);
+    ~TranscodeEngine() override;
+
+    /**
+     * @brief Create the job table if needed and recover an interrupted run
+     * @return true if the table is available
+     */
+    bool initialize();
+
+    /**
+     * @brief Set the ffmpeg executable
+     * @param program Path or name of ffmpeg; "ffmpeg" by default
+     */
+    void setProgram(const QString& program) { m_program = program; }
+
+    /**
+     * @brief Register how files with a suffix are encoded
+     * @param suffix Target suffix without the dot, such as "ogg"
+     * @param arguments ffmpeg output options, placed between the input and the output file
+     */
+    void setEncoder(const QString& suffix, const QStringList& arguments);
+
+    /**
+     * @brief Set how many conversions run at once
+     * @param workers Worker count; the number of cores by default
+     */
+    void setMaxWorkers(int workers);
+    int maxWorkers() const { return m_maxWorkers; }
+
+    void setTimeout(int timeoutMs) { m_timeoutMs = qMax(0, timeoutMs); }
+    int timeout() const { return m_timeoutMs; }
+
+    void setDurationProvider(DurationProvider provider) { m_durationOf = std::move(provider); }
+
+    /**
+     * @brief Get the file a source would be converted to
+     * @param source Source path
+     * @param suffix Target suffix without the dot
+     * @return Path with the same directory and base name and the new suffix
+     */
+    static QString targetPath(const QString& source, const QString& suffix);
+
+    /**
+     * @brief Add conversions to the queue
+     *
+     * Sources that already have the suffix, already have a job or whose
+     * target is another track of the library are skipped. Jobs that failed
+     * before are queued again.
+     * @param sources Paths as stored in the musics table
+     * @param suffix Target suffix; an encoder must be registered for it
+     * @return Number of jobs added or queued again
+     */
+    int enqueue(const QStringList& sources, const QString& suffix);
+
+    /**
+     * @brief Start working through the queue
+     */
+    void start();
+
+    /**
+     * @brief Stop the workers; their jobs go back to the queue for the next start()
+     */
+    void stop();
+
+    bool isRunning() const { return m_running; }
+
+    /**
+     * @brief Get the number of jobs not finished yet
+     * @return Waiting and running jobs
+     */
+    int pendingCount() const { return m_queue.size() + m_workers.size(); }
+
+    Progress progress() const;
+
+signals:
+    /**
+     * @brief Emitted when a worker takes a job
+     * @param source Source path
+     */
+    void jobStarted(const QString& source);
+
+    /**
+     * @brief Emitted when a job is done or failed
+     * @param source Source path
+     * @param target Target path; the track's path in the library, if ok
+     * @param ok true if the track was converted
+     * @param error Why it failed
+     */
+    void jobFinished(const QString& source, const QString& target, bool ok, const QString& error);
+
+    /**
+     * @brief Emitted when a job finishes, and at most every PROGRESS_INTERVAL_MS while jobs run
+     * @param progress Current progress
+     */
+    void progressChanged(const TranscodeEngine::Progress& progress);
+
+    /**
+     * @brief Emitted when the queue ran empty
+     * @param succeeded Jobs converted since the queue was last empty
+     * @param failed Jobs that failed
+     */
+    void finished(int succeeded, int failed);
+
+    /**
+     * @brief Emitted when a database operation fails
+     * @param operation Name of the operation
+     * @param error Error message
+     */
+    void operationError(const QString& operation, const QString& error);
+
+private:
+    struct Job {
+        QString source;
+        QString target;
+    };
+
+    struct Worker {
+        Job job;
+        QString partPath;
+        qint64 durationUs = -1;
+        qint64 doneUs = 0;
+        QTimer* timeout = nullptr;
+        bool timedOut = false;
+    };
+
+    bool ensureTable();
+    void recover();
+    void loadQueue();
+    void schedule();
+    void startJob(const Job& job);
+    void onWorkerFinished(QProcess* process, const QString& error);
+    QString commit(const Job& job, const QString& partPath);
+    void setState(const QString& source, const QString& state, const QString& error = QString());
+    void abortWorkers();
+    void reportProgress();
+    void logError(const QString& operation, const QString& error, const QString& query = QString());
+
+    static QString partPathFor(const QString& target);
+
+    QSqlDatabase& m_database;
+    QString m_program = "ffmpeg";
+    QHash<QString, QStringList> m_encoders;
+    int m_maxWorkers;
+    int m_timeoutMs = DEFAULT_TIMEOUT_MS;
+    DurationProvider m_durationOf;
+
+    bool m_initialized = false;
+    bool m_running = false;
+    QList<Job> m_queue;
+    QHash<QProcess*, Worker> m_workers;
+    int m_total = 0;
+    int m_done = 0;
+    int m_failed = 0;
+    int m_sessionDone = 0;
+    int m_sessionFailed = 0;
+    QTimer* m_progressTimer;
+};
+
+#endif // TRANSCODEENGINE_H
@@ -0,0 +1,232 @@
+#include "TransferQueue.h"
+#include <QDebug>
+#include <QTimer>
+
+TransferQueue::TransferQueue(QObject* parent)
+    : QObject(parent)
+{
+}
+
+TransferQueue::~TransferQueue()
+{
+    // Whoever queued the jobs may be going away too; nobody is called back
+    for (Entry* entry : std::as_const(m_jobs)) {
+        releaseProcess(entry);
+        delete entry;
+    }
+}
+
+int TransferQueue::enqueue(const Job& job, Callback callback)
+{
+    const QString key = job.key.isEmpty() ? (QStringList{job.program} + job.arguments).join(' ') : job.key;
+    const auto existing = m_keys.constFind(key);
+    if (existing != m_keys.cend()) {
+        qDebug() << "TransferQueue:" << key << "is already queued as job" << existing.value();
+        if (callback) {
+            m_jobs.value(existing.value())->callbacks.append(std::move(callback));
+        }
+        return existing.value();
+    }
+
+    Entry* entry = new Entry;
+    entry->id = m_nextId++;
+    entry->job = job;
+    entry->job.key = key;
+    entry->job.maxAttempts = qMax(1, job.maxAttempts);
+    if (callback) {
+        entry->callbacks.append(std::move(callback));
+    }
+    m_jobs.insert(entry->id, entry);
+    m_keys.insert(key, entry->id);
+    m_waiting.append(entry->id);
+
+    ++m_batchTotal;
+    emit progressChanged(m_batchSucceeded + m_batchFailed, m_batchTotal);
+    schedule();
+    return entry->id;
+}
+
+void TransferQueue::cancel(int id)
+{
+    Entry* entry = m_jobs.value(id);
+    if (!entry) {
+        return;
+    }
+
+    m_waiting.removeAll(id);
+    if (entry->process) {
+        --m_running;
+    }
+    releaseProcess(entry);
+
+    Result result;
+    result.attempts = entry->attempts;
+    result.error = "Cancelled";
+    finish(entry, result);
+    schedule();
+}
+
+void TransferQueue::cancelAll()
+{
+    const QList<int> ids = m_jobs.keys();
+    for (int id : ids) {
+        cancel(id);
+    }
+}
+
+void TransferQueue::setMaxConcurrent(int count)
+{
+    m_maxConcurrent = qMax(1, count);
+    schedule();
+}
+
+void TransferQueue::schedule()
+{
+    while (m_running < m_maxConcurrent && !m_waiting.isEmpty()) {
+        startAttempt(m_jobs.value(m_waiting.takeFirst()));
+    }
+}
+
+void TransferQueue::startAttempt(Entry* entry)
+{
+    ++entry->attempts;
+    ++m_running;
+    entry->timedOut = false;
+    emit jobStarted(entry->id, entry->job.description, entry->attempts);
+
+    QProcess* process = new QProcess(this);
+    entry->process = process;
+    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
+            [this, entry](int exitCode, QProcess::ExitStatus exitStatus) {
+                Result result;
+                result.exitCode = exitCode;
+                result.output = QString::fromLocal8Bit(entry->process->readAllStandardOutput()).trimmed();
+                result.errorOutput = QString::fromLocal8Bit(entry->process->readAllStandardError()).trimmed();
+                if (entry->timedOut) {
+                    result.error = QString("Timed out after %1 s").arg(entry->job.timeoutMs / 1000);
+                } else if (exitStatus != QProcess::NormalExit) {
+                    result.error = "Crashed";
+                } else if (exitCode != 0) {
+                    result.error = QString("Exited with code %1").arg(exitCode);
+                }
+                onAttemptFinished(entry, result);
+            });
+    connect(process, &QProcess::errorOccurred, this, [this, entry](QProcess::ProcessError error) {
+        // Crashes and timeouts end in finished(); only a failed start does not
+        if (error != QProcess::FailedToStart) {
+            return;
+        }
+        Result result;
+        result.error = entry->process->errorString();
+        onAttemptFinished(entry, result);
+    });
+
+    if (entry->job.timeoutMs > 0) {
+        entry->timer = new QTimer(this);
+        entry->timer->setSingleShot(true);
+        connect(entry->timer, &QTimer::timeout, this, [entry]() {
+            entry->timedOut = true;
+            entry->process->kill();
+        });
+        entry->timer->start(entry->job.timeoutMs);
+    }
+
+    qDebug() << "TransferQueue: starting" << entry->job.key << "attempt" << entry->attempts << "of"
+             << entry->job.maxAttempts;
+    process->start(entry->job.program, entry->job.arguments);
+}
+
+void TransferQueue::onAttemptFinished(Entry* entry, Result result)
+{
+    releaseProcess(entry);
+    --m_running;
+    result.attempts = entry->attempts;
+
+    if (result.error.isEmpty() && entry->job.validate && !entry->job.validate(result)) {
+        result.error = "Unexpected output";
+    }
+    result.ok = result.error.isEmpty();
+
+    if (!result.ok && entry->attempts < entry->job.maxAttempts) {
+        const int delayMs = m_retryDelayMs * entry->attempts;
+        logError("run", QString("%1 failed (%2); retrying in %3 ms")
+                            .arg(entry->job.key, result.error)
+                            .arg(delayMs));
+        emit jobRetrying(entry->id, result.error, delayMs);
+
+        entry->timer = new QTimer(this);
+        entry->timer->setSingleShot(true);
+        connect(entry->timer, &QTimer::timeout, this, [this, entry]() {
+            entry->timer->deleteLater();
+            entry->timer = nullptr;
+            m_waiting.append(entry->id);
+            schedule();
+        });
+        entry->timer->start(delayMs);
+    } else {
+        if (!result.ok) {
+            logError("run", QString("%1 failed after %2 attempts: %3")
+                                .arg(entry->job.key)
+                                .arg(entry->attempts)
+                                .arg(result.error));
+        }
+        finish(entry, result);
+    }
+    schedule();
+}
+
+void TransferQueue::finish(Entry* entry, const Result& result)
+{
+    m_jobs.remove(entry->id);
+    m_keys.remove(entry->job.key);
+    if (result.ok) {
+        ++m_batchSucceeded;
+    } else {
+        ++m_batchFailed;
+    }
+
+    // Callbacks may queue more jobs, so the entry is detached first
+    const int id = entry->id;
+    const QList<Callback> callbacks = entry->callbacks;
+    delete entry;
+    for (const Callback& callback : callbacks) {
+        callback(result);
+    }
+    emit jobFinished(id, result.ok, result.error);
+    emit progressChanged(m_batchSucceeded + m_batchFailed, m_batchTotal);
+
+    if (m_jobs.isEmpty()) {
+        const int succeeded = m_batchSucceeded;
+        const int failed = m_batchFailed;
+        m_batchTotal = 0;
+        m_batchSucceeded = 0;
+        m_batchFailed = 0;
+        emit drained(succeeded, failed);
+    }
+}
+
+void TransferQueue::releaseProcess(Entry* entry)
+{
+    if (entry->timer) {
+        entry->timer->stop();
+        entry->timer->deleteLater();
+        entry->timer = nullptr;
+    }
+    if (entry->process) {
+        QProcess* process = entry->process;
+        entry->process = nullptr;
+        process->disconnect(this);
+        if (process->state() == QProcess::NotRunning) {
+            process->deleteLater();
+        } else {
+            connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), process,
+                    &QObject::deleteLater);
+            process->kill();
+        }
+    }
+}
+
+void TransferQueue::logError(const QString& operation, const QString& error)
+{
+    qWarning() << QString("TransferQueue::%1 - %2").arg(operation, error);
+}
@@ -0,0 +1,206 @@
+#ifndef TRANSFERQUEUE_H
+#define TRANSFERQUEUE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QProcess>
+#include <QString>
+#include <QStringList>
+#include <functional>
+
+class QTimer;
+
+/**
+ * @brief Runs server transfer scripts as a bounded queue of jobs
+ *
+ * The program upload and check actions each ran their shell script as
+ * soon as they were chosen. Several uploads chosen in a row ran side by
+ * side and fought over the uplink, and choosing the same one twice sent
+ * the file twice. Jobs in a TransferQueue run at most maxConcurrent() at
+ * a time, in the order they were added.
+ *
+ * A job whose key matches a job that is waiting or running is not added
+ * again; its callback is attached to the existing job. A job fails when
+ * its program does not start, exits with an error, crashes, runs past its
+ * timeout or, if it has a validator, produces output the validator
+ * rejects. A failed job is added back to the queue after a delay that
+ * grows with each attempt, until it has run maxAttempts times. While it
+ * waits, its slot goes to the next job.
+ *
+ * progressChanged() counts the jobs of the current batch, meaning all the
+ * jobs added since the queue was last empty. drained() reports how the
+ * batch went. Both are meant for BackgroundOperationFeedback.
+ *
+ * @example
+ * @code
+ * TransferQueue* transfers = new TransferQueue(this);
+ * TransferQueue::Job job;
+ * job.key = "upload:" + file;
+ * job.description = tr("Uploading %1").arg(file);
+ * job.program = scriptPath;
+ * job.validate = [](const TransferQueue::Result& result) {
+ *     return result.output.contains("Transfer complete");
+ * };
+ * transfers->enqueue(job, [](const TransferQueue::Result& result) { qDebug() << result.ok; });
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class TransferQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int DEFAULT_MAX_CONCURRENT = 2;
+    static constexpr int DEFAULT_MAX_ATTEMPTS = 3;
+    static constexpr int DEFAULT_RETRY_DELAY_MS = 5000;
+    static constexpr int DEFAULT_TIMEOUT_MS = 10 * 60 * 1000;
+
+    /**
+     * @brief What a finished job did
+     */
+    struct Result {
+        bool ok = false;
+        int exitCode = -1;
+        QString output;       ///< Standard output of the last attempt
+        QString errorOutput;  ///< Standard error of the last attempt
+        QString error;        ///< Why the last attempt failed; empty if it succeeded
+        int attempts = 0;
+    };
+
+    /// Decides whether an attempt that exited with code 0 really succeeded
+    using Validator = std::function<bool(const Result& result)>;
+    using Callback = std::function<void(const Result& result)>;
+
+    /**
+     * @brief A program to run
+     */
+    struct Job {
+        QString key;          ///< Jobs with the same key are run once; program and arguments if empty
+        QString description;  ///< Shown in progress reports
+        QString program;
+        QStringList arguments;
+        int maxAttempts = DEFAULT_MAX_ATTEMPTS;
+        int timeoutMs = DEFAULT_TIMEOUT_MS;
+        Validator validate;
+    };
+
+    explicit TransferQueue(QObject* parent = nullptr);
+    ~TransferQueue() override;
+
+    /**
+     * @brief Add a job
+     * @param job Job to run
+     * @param callback Called once the job succeeded or ran out of attempts
+     * @return Job ID; the ID of the waiting or running job if the key is taken
+     */
+    int enqueue(const Job& job, Callback callback = nullptr);
+
+    /**
+     * @brief Check if a job with a key is waiting or running
+     * @param key Job key
+     * @return true if it is
+     */
+    bool contains(const QString& key) const { return m_keys.contains(key); }
+
+    /**
+     * @brief Cancel a job; its callbacks get a failed result
+     * @param id Job ID
+     */
+    void cancel(int id);
+
+    /**
+     * @brief Cancel every job
+     */
+    void cancelAll();
+
+    void setMaxConcurrent(int count);
+    int maxConcurrent() const { return m_maxConcurrent; }
+
+    /**
+     * @brief Set the delay before a failed job runs again
+     * @param delayMs Delay after the first failure; it is multiplied by the attempt number
+     */
+    void setRetryDelay(int delayMs) { m_retryDelayMs = qMax(0, delayMs); }
+    int retryDelay() const { return m_retryDelayMs; }
+
+    int runningCount() const { return m_running; }
+
+    /**
+     * @brief Get the number of jobs not finished yet
+     * @return Waiting, retrying and running jobs
+     */
+    int pendingCount() const { return m_jobs.size(); }
+
+signals:
+    /**
+     * @brief Emitted when a job starts an attempt
+     * @param id Job ID
+     * @param description Job description
+     * @param attempt Attempt number, from 1
+     */
+    void jobStarted(int id, const QString& description, int attempt);
+
+    /**
+     * @brief Emitted when a failed job is scheduled to run again
+     * @param id Job ID
+     * @param error Why the attempt failed
+     * @param delayMs Time until the next attempt
+     */
+    void jobRetrying(int id, const QString& error, int delayMs);
+
+    /**
+     * @brief Emitted when a job succeeded, ran out of attempts or was cancelled
+     * @param id Job ID
+     * @param ok true if it succeeded
+     * @param error Why it failed
+     */
+    void jobFinished(int id, bool ok, const QString& error);
+
+    /**
+     * @brief Emitted when a job is added to or leaves the current batch
+     * @param finished Jobs of the batch that are done
+     * @param total Jobs in the batch
+     */
+    void progressChanged(int finished, int total);
+
+    /**
+     * @brief Emitted when the last job of a batch is done
+     * @param succeeded Jobs that succeeded
+     * @param failed Jobs that failed or were cancelled
+     */
+    void drained(int succeeded, int failed);
+
+private:
+    struct Entry {
+        int id = 0;
+        Job job;
+        QList<Callback> callbacks;
+        QProcess* process = nullptr;
+        QTimer* timer = nullptr;  ///< Attempt timeout, or delay before a retry
+        int attempts = 0;
+        bool timedOut = false;
+    };
+
+    void schedule();
+    void startAttempt(Entry* entry);
+    void onAttemptFinished(Entry* entry, Result result);
+    void finish(Entry* entry, const Result& result);
+    void releaseProcess(Entry* entry);
+    void logError(const QString& operation, const QString& error);
+
+    QHash<int, Entry*> m_jobs;
+    QHash<QString, int> m_keys;
+    QList<int> m_waiting;
+    int m_nextId = 1;
+    int m_running = 0;
+    int m_maxConcurrent = DEFAULT_MAX_CONCURRENT;
+    int m_retryDelayMs = DEFAULT_RETRY_DELAY_MS;
+    int m_batchTotal = 0;
+    int m_batchSucceeded = 0;
+    int m_batchFailed = 0;
+};
+
+#endif // TRANSFERQUEUE_H
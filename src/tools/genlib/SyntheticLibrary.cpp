@@ -0,0 +1,486 @@
+#include "SyntheticLibrary.h"
+#include <QDate>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSet>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QVariant>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// What a music station's library holds, roughly; ID3v1 numbers as TagReader resolves them
+const QVector<SyntheticLibrary::Genre> GENRES = {
+    {"Rock", 20, 17},     {"Pop", 18, 13},    {"Dance", 9, 3},     {"Hip-Hop", 8, 7},
+    {"Country", 7, 2},    {"Electronic", 6, 52}, {"Jazz", 6, 8},   {"Metal", 5, 9},
+    {"Blues", 4, 0},      {"Reggae", 4, 16},  {"Soul", 4, 42},     {"Folk", 4, 80},
+    {"Classical", 3, 32}, {"Latin", 3, 86},   {"Funk", 3, 5},      {"Punk", 2, 43}};
+
+struct Country {
+    const char* name;
+    int weight;
+};
+
+const Country COUNTRIES[] = {{"United States", 30}, {"United Kingdom", 15}, {"Portugal", 12},
+                             {"Brazil", 10},        {"France", 6},          {"Germany", 6},
+                             {"Spain", 5},          {"Italy", 4},           {"Angola", 4},
+                             {"Japan", 3},          {"Jamaica", 3},         {"Canada", 2}};
+
+const char* const WEEKDAYS[] = {"Monday", "Tuesday", "Wednesday", "Thursday",
+                                "Friday", "Saturday", "Sunday"};
+
+// Plays are dated back from here rather than from today, so runs compare
+const QDate LAST_PLAYED(2024, 5, 17);
+
+// Independent draws from the same key
+enum Salt {
+    SaltArtist,
+    SaltArtistGenre,
+    SaltArtistCountry,
+    SaltArtistStart,
+    SaltGenre,
+    SaltGenre1,
+    SaltGenre2,
+    SaltYear,
+    SaltLength,
+    SaltLengthSpread,
+    SaltLong,
+    SaltPlays,
+    SaltLastPlayed,
+    SaltTagged,
+    SaltHourGenre
+};
+
+quint64 mix(quint64 x)
+{
+    // splitmix64: cheap, and good enough to spread consecutive keys
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+QByteArray field(const QString& text, int size)
+{
+    QByteArray bytes = text.toLatin1().left(size);
+    bytes.append(QByteArray(size - bytes.size(), '\0'));
+    return bytes;
+}
+
+void appendLittleEndian(QByteArray& bytes, quint32 value, int size)
+{
+    for (int i = 0; i < size; ++i) {
+        bytes.append(char((value >> (8 * i)) & 0xff));
+    }
+}
+
+bool fail(QString* error, const QString& reason)
+{
+    if (error) {
+        *error = reason;
+    }
+    return false;
+}
+
+} // namespace
+
+const QVector<SyntheticLibrary::Genre>& SyntheticLibrary::genres()
+{
+    return GENRES;
+}
+
+QString SyntheticLibrary::artistName(int artist)
+{
+    return QString("Artist %1").arg(artist, 6, 10, QChar('0'));
+}
+
+QString SyntheticLibrary::songName(int track)
+{
+    return QString("Song %1").arg(track);
+}
+
+SyntheticLibrary::SyntheticLibrary(const Options& options)
+    : m_options(options)
+{
+    m_options.tracks = qMax(0, m_options.tracks);
+    m_options.untaggedPercent = qBound(0, m_options.untaggedPercent, 100);
+    m_options.stubMs = qMax(1, m_options.stubMs);
+    m_artists = m_options.artists > 0 ? m_options.artists
+                                      : qMax(1, m_options.tracks / TRACKS_PER_ARTIST);
+    m_artists = qMax(1, qMin(m_artists, qMax(1, m_options.tracks)));
+
+    // Rank r has weight 1 / r^skew
+    m_artistCdf.reserve(m_artists);
+    double total = 0;
+    for (int rank = 1; rank <= m_artists; ++rank) {
+        total += 1.0 / std::pow(double(rank), qMax(0.0, m_options.artistSkew));
+        m_artistCdf.append(total);
+    }
+
+    for (const Genre& genre : GENRES) {
+        m_genreWeights += genre.weight;
+    }
+}
+
+double SyntheticLibrary::uniform(quint64 key, int salt) const
+{
+    const quint64 bits = mix(mix(key * 32 + quint64(salt)) ^ m_options.seed);
+    return double(bits >> 11) / 9007199254740992.0;   // [0, 1) from 53 bits
+}
+
+int SyntheticLibrary::artistOf(int index) const
+{
+    // The first tracks go one to each artist, so none is left without
+    if (index < m_artists) {
+        return index;
+    }
+    const double target = uniform(quint64(index), SaltArtist) * m_artistCdf.last();
+    const auto rank = std::upper_bound(m_artistCdf.cbegin(), m_artistCdf.cend(), target);
+    return qMin(int(rank - m_artistCdf.cbegin()), m_artists - 1);
+}
+
+int SyntheticLibrary::genreAt(double u) const
+{
+    int target = int(u * m_genreWeights);
+    for (int i = 0; i < GENRES.size(); ++i) {
+        target -= GENRES.at(i).weight;
+        if (target < 0) {
+            return i;
+        }
+    }
+    return GENRES.size() - 1;
+}
+
+QString SyntheticLibrary::artistGenre(int artist) const
+{
+    return QString::fromLatin1(GENRES.at(genreAt(uniform(quint64(artist), SaltArtistGenre))).name);
+}
+
+SyntheticLibrary::Track SyntheticLibrary::track(int index) const
+{
+    const quint64 key = quint64(index);
+    const int artist = artistOf(index);
+    const quint64 artistKey = quint64(artist);
+
+    Track track;
+    track.artist = artistName(artist);
+    track.song = songName(index);
+
+    track.genre1 = uniform(key, SaltGenre) * 100 < PRIMARY_GENRE_PERCENT
+                       ? artistGenre(artist)
+                       : QString::fromLatin1(GENRES.at(genreAt(uniform(key, SaltGenre1))).name);
+    const double second = uniform(key, SaltGenre2);
+    if (second < 0.5) {
+        track.genre2 = QString::fromLatin1(GENRES.at(genreAt(second * 2)).name);
+    }
+
+    int countryWeights = 0;
+    for (const Country& country : COUNTRIES) {
+        countryWeights += country.weight;
+    }
+    int countryTarget = int(uniform(artistKey, SaltArtistCountry) * countryWeights);
+    for (const Country& country : COUNTRIES) {
+        countryTarget -= country.weight;
+        if (countryTarget < 0) {
+            track.country = QString::fromLatin1(country.name);
+            break;
+        }
+    }
+
+    // A career of up to fifteen years from its start
+    const int start = 1955 + int(uniform(artistKey, SaltArtistStart) * 66);
+    track.year = QString::number(qMin(2024, start + int(uniform(key, SaltYear) * 16)));
+
+    // Around four minutes, and one in thirty a long take of up to twelve
+    int seconds = 150 + int((uniform(key, SaltLength) + uniform(key, SaltLengthSpread)) * 90);
+    if (uniform(key, SaltLong) < 1.0 / 30) {
+        seconds = 360 + int(uniform(key, SaltLengthSpread) * 360);
+    }
+    track.time = QString("%1:%2:%3")
+                     .arg(seconds / 3600)
+                     .arg(seconds % 3600 / 60, 2, 10, QChar('0'))
+                     .arg(seconds % 60, 2, 10, QChar('0'));
+
+    // Most plays go to few tracks
+    track.playedTimes = int(std::pow(uniform(key, SaltPlays), 4.0) * MAX_PLAYS);
+    if (track.playedTimes > 0) {
+        const int daysAgo = int(uniform(key, SaltLastPlayed) * 365);
+        track.lastPlayed = LAST_PLAYED.addDays(-daysAgo).toString(Qt::ISODate);
+    }
+
+    track.tagged = m_options.audio == Audio::Mp3
+                   && uniform(key, SaltTagged) * 100 >= m_options.untaggedPercent;
+    track.path = trackPath(track, index);
+    return track;
+}
+
+QString SyntheticLibrary::extension() const
+{
+    return m_options.audio == Audio::Wav ? QStringLiteral("wav") : QStringLiteral("mp3");
+}
+
+QString SyntheticLibrary::trackPath(const Track& track, int index) const
+{
+    // Tags name tagged files; the others are named the way the importer reads names
+    const QString name =
+        track.tagged ? QString("%1.%2").arg(index, 7, 10, QChar('0')).arg(extension())
+                     : QString("%1 - %2.%3").arg(track.artist, track.song, extension());
+    return QDir(m_options.root).filePath(QLatin1String(MUSIC_FOLDER) + '/' + track.genre1 + '/'
+                                         + track.artist + '/' + name);
+}
+
+QString SyntheticLibrary::schedulePath(const char* folder, const char* prefix, int id) const
+{
+    const QString name = QString("%1_%2.%3").arg(QLatin1String(prefix)).arg(id).arg(extension());
+    return QDir(m_options.root).filePath(QLatin1String(folder) + '/' + name);
+}
+
+bool SyntheticLibrary::writeMusic(QSqlDatabase& database, QString* error) const
+{
+    QSqlQuery query(database);
+    if (database.tables().contains("genres1")) {
+        QSet<QString> known;
+        if (query.exec("SELECT name FROM genres1")) {
+            while (query.next()) {
+                known.insert(query.value(0).toString());
+            }
+        }
+        query.prepare("INSERT INTO genres1 (name) VALUES (?)");
+        for (const Genre& genre : GENRES) {
+            if (!known.contains(QString::fromLatin1(genre.name))) {
+                query.addBindValue(QString::fromLatin1(genre.name));
+                if (!query.exec()) {
+                    return fail(error, query.lastError().text());
+                }
+            }
+        }
+    }
+
+    query.prepare("INSERT INTO musics (artist, song, genre1, genre2, country, published_date, "
+                  "path, time, played_times, last_played) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+    for (int first = 0; first < m_options.tracks; first += COMMIT_ROWS) {
+        if (!database.transaction()) {
+            return fail(error, database.lastError().text());
+        }
+        const int last = qMin(m_options.tracks, first + COMMIT_ROWS);
+        for (int index = first; index < last; ++index) {
+            const Track row = track(index);
+            query.addBindValue(row.artist);
+            query.addBindValue(row.song);
+            query.addBindValue(row.genre1);
+            query.addBindValue(row.genre2.isEmpty() ? QVariant() : QVariant(row.genre2));
+            query.addBindValue(row.country);
+            query.addBindValue(row.year);
+            query.addBindValue(row.path);
+            query.addBindValue(row.time);
+            query.addBindValue(row.playedTimes);
+            query.addBindValue(row.lastPlayed.isEmpty() ? QVariant() : QVariant(row.lastPlayed));
+            if (!query.exec()) {
+                const QString reason = query.lastError().text();
+                database.rollback();
+                return fail(error, reason);
+            }
+        }
+        if (!database.commit()) {
+            const QString reason = database.lastError().text();
+            database.rollback();
+            return fail(error, reason);
+        }
+    }
+    return true;
+}
+
+bool SyntheticLibrary::writeFiles(QString* error) const
+{
+    if (m_options.audio == Audio::None) {
+        return true;
+    }
+
+    const QByteArray audio = audioStub(m_options.audio, m_options.stubMs);
+    QSet<QString> folders;
+    auto write = [&](const QString& path, const QByteArray& tag) {
+        const QString folder = QFileInfo(path).path();
+        if (!folders.contains(folder)) {
+            if (!QDir().mkpath(folder)) {
+                return fail(error, QString("Cannot create %1").arg(folder));
+            }
+            folders.insert(folder);
+        }
+        QFile file(path);
+        if (!file.open(QIODevice::WriteOnly) || file.write(audio) != audio.size()
+            || file.write(tag) != tag.size()) {
+            return fail(error, QString("%1: %2").arg(path, file.errorString()));
+        }
+        return true;
+    };
+
+    for (int index = 0; index < m_options.tracks; ++index) {
+        const Track row = track(index);
+        const auto genre = std::find_if(GENRES.cbegin(), GENRES.cend(), [&row](const Genre& g) {
+            return row.genre1 == QLatin1String(g.name);
+        });
+        const QByteArray tag = row.tagged ? id3v1(row.song, row.artist, row.year, genre->id3v1)
+                                          : QByteArray();
+        if (!write(row.path, tag)) {
+            return false;
+        }
+    }
+    for (int id = 1; id <= m_options.pubs; ++id) {
+        if (!write(schedulePath("pub", "spot", id), QByteArray())) {
+            return false;
+        }
+    }
+    for (int id = 1; id <= m_options.programs; ++id) {
+        if (!write(schedulePath("programs", "show", id), QByteArray())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SyntheticLibrary::writeSchedule(QSqlDatabase& database, QString* error) const
+{
+    if (!database.transaction()) {
+        return fail(error, database.lastError().text());
+    }
+
+    QSqlQuery query(database);
+    bool ok = query.prepare("INSERT INTO pub (id, name, path) VALUES (?, ?, ?)");
+    for (int id = 1; ok && id <= m_options.pubs; ++id) {
+        query.addBindValue(id);
+        query.addBindValue(QString("Spot %1").arg(id));
+        query.addBindValue(schedulePath("pub", "spot", id));
+        ok = query.exec();
+    }
+    ok = ok && query.prepare("INSERT INTO programs (id, name, path) VALUES (?, ?, ?)");
+    for (int id = 1; ok && id <= m_options.programs; ++id) {
+        query.addBindValue(id);
+        query.addBindValue(QString("Show %1").arg(id));
+        query.addBindValue(schedulePath("programs", "show", id));
+        ok = query.exec();
+    }
+
+    ok = ok && query.prepare("INSERT INTO scheduler (id, hora, min, tipo, week_day, is_program) "
+                             "VALUES (?, ?, ?, ?, ?, ?)");
+    auto rule = [&query](int id, int hour, int minute, const char* weekday, bool program) {
+        query.addBindValue(id);
+        query.addBindValue(hour);
+        query.addBindValue(minute);
+        query.addBindValue(2);   // weekly
+        query.addBindValue(QString::fromLatin1(weekday));
+        query.addBindValue(program ? QStringLiteral("1") : QStringLiteral("0"));
+        return query.exec();
+    };
+    for (const char* weekday : WEEKDAYS) {
+        for (int hour = 0; ok && hour < 24; ++hour) {
+            for (int minute : {0, 30}) {
+                if (ok && m_options.pubs > 0) {
+                    ok = rule((hour * 2 + minute / 30) % m_options.pubs + 1, hour, minute, weekday,
+                              false);
+                }
+            }
+            if (ok && m_options.programs > 0 && hour % 3 == 0) {
+                ok = rule(hour / 3 % m_options.programs + 1, hour, 15, weekday, true);
+            }
+        }
+    }
+
+    if (!ok) {
+        const QString reason = query.lastError().text();
+        database.rollback();
+        return fail(error, reason);
+    }
+    if (!database.commit()) {
+        const QString reason = database.lastError().text();
+        database.rollback();
+        return fail(error, reason);
+    }
+    return true;
+}
+
+bool SyntheticLibrary::writeHourGenres(QSqlDatabase& database, QString* error) const
+{
+    if (!database.transaction()) {
+        return fail(error, database.lastError().text());
+    }
+
+    // Text, as HourGenreSchedule::setGenre() writes the slots
+    QSqlQuery remove(database);
+    QSqlQuery insert(database);
+    bool ok = remove.prepare("DELETE FROM hourgenre WHERE day = ? AND hour = ?")
+              && insert.prepare("INSERT INTO hourgenre (day, hour, genre) VALUES (?, ?, ?)");
+    for (int day = 1; ok && day <= 7; ++day) {
+        for (int hour = 0; ok && hour < 24; ++hour) {
+            const double u = uniform(quint64(day * 24 + hour), SaltHourGenre);
+            remove.addBindValue(QString::number(day));
+            remove.addBindValue(QString::number(hour));
+            insert.addBindValue(QString::number(day));
+            insert.addBindValue(QString::number(hour));
+            insert.addBindValue(QString::fromLatin1(GENRES.at(genreAt(u)).name));
+            ok = remove.exec() && insert.exec();
+        }
+    }
+
+    if (!ok) {
+        const QString reason = remove.lastError().isValid() ? remove.lastError().text()
+                                                            : insert.lastError().text();
+        database.rollback();
+        return fail(error, reason);
+    }
+    if (!database.commit()) {
+        const QString reason = database.lastError().text();
+        database.rollback();
+        return fail(error, reason);
+    }
+    return true;
+}
+
+QByteArray SyntheticLibrary::audioStub(Audio audio, int milliseconds)
+{
+    QByteArray bytes;
+    switch (audio) {
+    case Audio::None:
+        break;
+    case Audio::Mp3: {
+        // MPEG-1 Layer III, 128 kbit/s, 44.1 kHz, mono: 417 bytes and 1152 samples a frame.
+        // Side info of zeros holds no main data, which decodes as silence.
+        const int frames = qMax(1, int((qint64(milliseconds) * 44100 + 1152 * 1000 - 1)
+                                       / (1152 * 1000)));
+        QByteArray frame = QByteArray::fromHex("fffb90c4");
+        frame.append(QByteArray(417 - frame.size(), '\0'));
+        bytes.reserve(frames * frame.size());
+        for (int i = 0; i < frames; ++i) {
+            bytes.append(frame);
+        }
+        break;
+    }
+    case Audio::Wav: {
+        const quint32 samples = quint32(qMax(1, milliseconds) * 8);   // 8 kHz, 8 bits, mono
+        bytes.append("RIFF");
+        appendLittleEndian(bytes, 36 + samples, 4);
+        bytes.append("WAVEfmt ");
+        appendLittleEndian(bytes, 16, 4);       // format chunk size
+        appendLittleEndian(bytes, 1, 2);        // PCM
+        appendLittleEndian(bytes, 1, 2);        // channels
+        appendLittleEndian(bytes, 8000, 4);     // sample rate
+        appendLittleEndian(bytes, 8000, 4);     // byte rate
+        appendLittleEndian(bytes, 1, 2);        // block align
+        appendLittleEndian(bytes, 8, 2);        // bits per sample
+        bytes.append("data");
+        appendLittleEndian(bytes, samples, 4);
+        bytes.append(QByteArray(int(samples), char(0x80)));   // 8-bit PCM is unsigned
+        break;
+    }
+    }
+    return bytes;
+}
+
+QByteArray SyntheticLibrary::id3v1(const QString& title, const QString& artist,
+                                   const QString& year, int genre)
+{
+    return "TAG" + field(title, 30) + field(artist, 30) + field("Synthetic", 30)
+           + field(year, 4) + field(QString(), 30) + QByteArray(1, char(genre));
+}
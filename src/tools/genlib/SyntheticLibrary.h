@@ -0,0 +1,173 @@
+#ifndef SYNTHETICLIBRARY_H
+#define SYNTHETICLIBRARY_H
+
+#include <QByteArray>
+#include <QSqlDatabase>
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief A station's library made up, at any size, the same on every run
+ *
+ * The fixtures of the tests hold a handful of rows, and a real library
+ * cannot be shipped with the sources. SyntheticLibrary describes one of
+ * up to millions of tracks that is shaped like a real one:
+ *
+ * - a few artists have many tracks and most have a few, in a Zipf
+ *   distribution of skew artistSkew; every artist has at least one;
+ * - genres and countries are weighted as in a typical music station, and
+ *   an artist's tracks are mostly in the artist's genre;
+ * - years follow each artist's career, lengths cluster around four
+ *   minutes, and plays cluster on few tracks.
+ *
+ * Each track is computed from the seed and its index, so track() is
+ * random access, millions of tracks cost no memory, and the rows written by
+ * writeMusic() match the files written by writeFiles(). The files are stubs
+ * with valid headers: MPEG frames of silence with an ID3v1 tag, or a PCM
+ * WAV file. Some are left untagged and named "Artist - Song", as real
+ * libraries have them.
+ *
+ * writeSchedule() and writeHourGenres() add the pubs, programs and rules
+ * of a station's week. The xfb_genlib tool writes all four; the data layer
+ * benchmarks and the PGO training workload use the class directly.
+ *
+ * @example
+ * @code
+ * SyntheticLibrary::Options options;
+ * options.tracks = 1000000;
+ * SyntheticLibrary library(options);
+ * library.writeMusic(database);
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class SyntheticLibrary
+{
+public:
+    static constexpr int TRACKS_PER_ARTIST = 8;      ///< Artists when Options::artists is 0
+    static constexpr int PRIMARY_GENRE_PERCENT = 80; ///< Tracks in their artist's genre
+    static constexpr int COMMIT_ROWS = 10000;        ///< Rows written per transaction
+    static constexpr int MAX_PLAYS = 500;
+    static constexpr quint32 DEFAULT_SEED = 20240517;
+    static constexpr const char* MUSIC_FOLDER = "music"; ///< Under root, beside pub and programs
+
+    enum class Audio {
+        None,   ///< No files, only rows
+        Mp3,    ///< MPEG-1 Layer III frames of silence and an ID3v1 tag
+        Wav     ///< 8 kHz mono PCM of silence
+    };
+
+    struct Options {
+        int tracks = 10000;
+        int artists = 0;                ///< 0 for one per TRACKS_PER_ARTIST tracks
+        double artistSkew = 1.0;        ///< Zipf exponent of tracks per artist, 0 for even
+        QString root = "/library";      ///< Folder of music/, pub/ and programs/
+        Audio audio = Audio::Mp3;       ///< Kind of the files and of the paths' extension
+        int untaggedPercent = 10;       ///< Files without tags, named "Artist - Song"
+        int stubMs = 1000;              ///< Length of the silence in each file
+        int pubs = 20;
+        int programs = 4;
+        quint32 seed = DEFAULT_SEED;
+    };
+
+    struct Genre {
+        const char* name;
+        int weight;     ///< Share of the library, out of the sum of the weights
+        int id3v1;      ///< Number in the ID3v1 genre list
+    };
+
+    struct Track {
+        QString artist;
+        QString song;
+        QString genre1;
+        QString genre2;
+        QString country;
+        QString year;
+        QString path;
+        QString time;           ///< As MediaProbe::formatDuration() writes it
+        int playedTimes = 0;
+        QString lastPlayed;     ///< ISO date, empty if never played
+        bool tagged = true;
+    };
+
+    /**
+     * @brief Genres of the library, in no particular order
+     */
+    static const QVector<Genre>& genres();
+
+    static QString artistName(int artist);
+    static QString songName(int track);
+
+    explicit SyntheticLibrary(const Options& options);
+
+    const Options& options() const { return m_options; }
+    int trackCount() const { return m_options.tracks; }
+    int artistCount() const { return m_artists; }
+
+    /**
+     * @brief Describe a track
+     * @param index 0 to trackCount() - 1
+     */
+    Track track(int index) const;
+
+    /**
+     * @brief Genre most of an artist's tracks are in
+     */
+    QString artistGenre(int artist) const;
+
+    /**
+     * @brief Insert every track into the musics table, and the genres into genres1
+     * @param database Open database with the musics table
+     * @param error Set to the reason when false is returned
+     */
+    bool writeMusic(QSqlDatabase& database, QString* error = nullptr) const;
+
+    /**
+     * @brief Write the stub files under root
+     *
+     * Tracks go in music/, in a folder per genre and artist, and pub/ and
+     * programs/ get the files of writeSchedule(). Does nothing for Audio::None.
+     */
+    bool writeFiles(QString* error = nullptr) const;
+
+    /**
+     * @brief Insert the pubs and programs and a week of weekly rules for them
+     *
+     * Pubs go on air on the hour and the half hour, a program at quarter past
+     * every third hour.
+     */
+    bool writeSchedule(QSqlDatabase& database, QString* error = nullptr) const;
+
+    /**
+     * @brief Program a genre for every hour of the week, as HourGenreSchedule stores it
+     */
+    bool writeHourGenres(QSqlDatabase& database, QString* error = nullptr) const;
+
+    /**
+     * @brief Contents of a stub file
+     * @param audio Kind of file; None gives an empty one
+     * @param milliseconds Length of the silence
+     */
+    static QByteArray audioStub(Audio audio, int milliseconds);
+
+    /**
+     * @brief ID3v1 tag, as appended to the MP3 stubs
+     */
+    static QByteArray id3v1(const QString& title, const QString& artist, const QString& year,
+                            int genre);
+
+private:
+    double uniform(quint64 key, int salt) const;
+    int artistOf(int index) const;
+    int genreAt(double u) const;
+    QString trackPath(const Track& track, int index) const;
+    QString extension() const;
+    QString schedulePath(const char* folder, const char* prefix, int id) const;
+
+    Options m_options;
+    int m_artists;
+    QVector<double> m_artistCdf;    ///< Cumulative Zipf weights of the artists, by rank
+    int m_genreWeights = 0;
+};
+
+#endif // SYNTHETICLIBRARY_H
@@ -0,0 +1,145 @@
+#include "SyntheticLibrary.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QTextStream>
+
+namespace {
+
+const char* CONNECTION_NAME = "xfb_genlib";
+
+bool openDatabase(const QString& path, QSqlDatabase& database, QString* error)
+{
+    // A new database starts from the schema XFB ships
+    if (!QFileInfo::exists(path)) {
+        if (!QDir().mkpath(QFileInfo(path).absolutePath()) || !QFile::copy(":/adb.db", path)) {
+            *error = QString("cannot create %1").arg(path);
+            return false;
+        }
+        QFile::setPermissions(path, QFile::ReadOwner | QFile::WriteOwner | QFile::ReadGroup
+                                        | QFile::ReadOther);
+    }
+
+    database = QSqlDatabase::addDatabase("QSQLITE", CONNECTION_NAME);
+    database.setDatabaseName(path);
+    if (!database.open()) {
+        *error = database.lastError().text();
+        return false;
+    }
+    // The library can be generated again; a crash half-way is not worth syncing for
+    QSqlQuery query(database);
+    query.exec("PRAGMA journal_mode = MEMORY");
+    query.exec("PRAGMA synchronous = OFF");
+    return true;
+}
+
+} // namespace
+
+// xfb_genlib: writes a synthetic library of any size, for load tests and benchmarks
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("xfb_genlib");
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Writes a made-up library shaped like a station's into an XFB database, with stub "
+        "audio files and a week of schedule if asked to. The same options give the same "
+        "library.");
+    parser.addHelpOption();
+    const QCommandLineOption databaseOption("database", "Database to add to, created from "
+                                                        "the schema XFB ships if missing.",
+                                            "file");
+    const QCommandLineOption rootOption(
+        "root", "Folder the paths are under: music/, pub/ and programs/.", "dir", "/library");
+    const QCommandLineOption filesOption("files", "Write the stub audio files under --root.");
+    const QCommandLineOption audioOption("audio", "Kind of the stub files: mp3 or wav.", "kind",
+                                         "mp3");
+    const QCommandLineOption tracksOption("tracks", "Tracks in the library.", "n", "100000");
+    const QCommandLineOption artistsOption(
+        "artists",
+        QString("Artists, one per %1 tracks by default.").arg(SyntheticLibrary::TRACKS_PER_ARTIST),
+        "n", "0");
+    const QCommandLineOption skewOption(
+        "skew", "Zipf exponent of the tracks per artist; 0 spreads them evenly.", "s", "1.0");
+    const QCommandLineOption untaggedOption("untagged", "Percent of the MP3 files left untagged.",
+                                            "percent", "10");
+    const QCommandLineOption stubOption("stub-ms", "Milliseconds of silence in each file.", "ms",
+                                        "1000");
+    const QCommandLineOption noScheduleOption(
+        "no-schedule", "Leave out the pubs, programs, scheduler rules and hour genres.");
+    const QCommandLineOption seedOption("seed", "Seed of the library.", "n",
+                                        QString::number(SyntheticLibrary::DEFAULT_SEED));
+    parser.addOptions({databaseOption, rootOption, filesOption, audioOption, tracksOption,
+                       artistsOption, skewOption, untaggedOption, stubOption, noScheduleOption,
+                       seedOption});
+    parser.process(app);
+
+    const QString audio = parser.value(audioOption).toLower();
+    if (audio != "mp3" && audio != "wav") {
+        err << "xfb_genlib: --audio takes mp3 or wav\n";
+        return 2;
+    }
+    if (!parser.isSet(databaseOption) && !parser.isSet(filesOption)) {
+        err << "xfb_genlib: nothing to write; give --database, --files or both\n";
+        return 2;
+    }
+
+    SyntheticLibrary::Options options;
+    options.tracks = parser.value(tracksOption).toInt();
+    options.artists = parser.value(artistsOption).toInt();
+    options.artistSkew = parser.value(skewOption).toDouble();
+    options.root = QDir(parser.value(rootOption)).absolutePath();
+    options.audio = audio == "wav" ? SyntheticLibrary::Audio::Wav : SyntheticLibrary::Audio::Mp3;
+    options.untaggedPercent = parser.value(untaggedOption).toInt();
+    options.stubMs = parser.value(stubOption).toInt();
+    options.seed = parser.value(seedOption).toUInt();
+    if (parser.isSet(noScheduleOption)) {
+        options.pubs = 0;
+        options.programs = 0;
+    }
+    if (options.tracks <= 0) {
+        err << "xfb_genlib: --tracks must be positive\n";
+        return 2;
+    }
+    const SyntheticLibrary library(options);
+
+    QElapsedTimer timer;
+    timer.start();
+    QString error;
+    if (parser.isSet(filesOption)) {
+        if (!library.writeFiles(&error)) {
+            err << "xfb_genlib: " << error << '\n';
+            return 1;
+        }
+        out << "xfb_genlib: " << library.trackCount() << " files under " << options.root << " in "
+            << timer.restart() << " ms\n";
+    }
+
+    if (parser.isSet(databaseOption)) {
+        QSqlDatabase database;
+        const QString path = parser.value(databaseOption);
+        bool ok = openDatabase(path, database, &error) && library.writeMusic(database, &error);
+        if (ok && !parser.isSet(noScheduleOption)) {
+            ok = library.writeSchedule(database, &error)
+                 && library.writeHourGenres(database, &error);
+        }
+        database.close();
+        database = QSqlDatabase();
+        QSqlDatabase::removeDatabase(CONNECTION_NAME);
+        if (!ok) {
+            err << "xfb_genlib: " << path << ": " << error << '\n';
+            return 1;
+        }
+        out << "xfb_genlib: " << library.trackCount() << " tracks of " << library.artistCount()
+            << " artists into " << path << " in " << timer.elapsed() << " ms\n";
+    }
+    return 0;
+}
@@ -0,0 +1,49 @@
+#include "../../services/HelpCorpus.h"
+#include <QCoreApplication>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonParseError>
+#include <QSaveFile>
+#include <QTextStream>
+
+// xfb_helpc: compiles src/help into the help corpus embedded in XFB, at build time
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream err(stderr);
+    const QStringList arguments = app.arguments();
+    if (arguments.size() != 3) {
+        err << "Usage: xfb_helpc <help.json> <help.bin>\n";
+        return 2;
+    }
+
+    QFile manifestFile(arguments.at(1));
+    if (!manifestFile.open(QIODevice::ReadOnly)) {
+        err << manifestFile.fileName() << ": " << manifestFile.errorString() << '\n';
+        return 1;
+    }
+    QJsonParseError parseError;
+    const QJsonDocument manifest = QJsonDocument::fromJson(manifestFile.readAll(), &parseError);
+    if (!manifest.isObject()) {
+        err << manifestFile.fileName() << ": " << parseError.errorString() << " at offset "
+            << parseError.offset << '\n';
+        return 1;
+    }
+
+    QString error;
+    const QByteArray corpus = HelpCorpus::compile(
+        manifest.object(), QFileInfo(manifestFile.fileName()).absolutePath(), &error);
+    if (corpus.isEmpty()) {
+        err << manifestFile.fileName() << ": " << error << '\n';
+        return 1;
+    }
+
+    QSaveFile output(arguments.at(2));
+    if (!output.open(QIODevice::WriteOnly) || output.write(corpus) != corpus.size()
+        || !output.commit()) {
+        err << output.fileName() << ": " << output.errorString() << '\n';
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,357 @@
+#include "TrainingWorkload.h"
+#include "../genlib/SyntheticLibrary.h"
+#include "../../models/LiveTableModel.h"
+#include "../../repositories/MusicRepository.h"
+#include "../../services/DatabaseService.h"
+#include "../../services/HourGenreSchedule.h"
+#include "../../services/LibrarySnapshot.h"
+#include "../../services/MusicCache.h"
+#include "../../services/RotationEngine.h"
+#include "../../services/SchedulerEngine.h"
+#include "../../services/SearchController.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QRandomGenerator>
+#include <QSqlError>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QTimer>
+#include <cstring>
+#include <functional>
+
+namespace {
+
+const char* CONNECTION_NAME = "xfb_pgo_training";
+
+// Where the simulated air time starts, local time: the same weekday and
+// hours of the schedule on every run, whatever day the build is
+const QDate AIR_DATE(2024, 5, 17);
+const QTime AIR_START(6, 0);
+
+// What is typed into the search box, a character at a time
+const char* const TYPED[] = {"artist 0012", "song 42", "rock", "jazz song 1", "unknown"};
+
+// Run start, then wait until the sender emits signal; false on timeout
+template <typename Sender, typename Signal>
+bool waitFor(const Sender* sender, Signal signal, const std::function<void()>& start)
+{
+    QEventLoop loop;
+    QTimer timeout;
+    timeout.setSingleShot(true);
+    QObject::connect(&timeout, &QTimer::timeout, &loop, &QEventLoop::quit);
+    QObject::connect(sender, signal, &loop, &QEventLoop::quit);
+    timeout.start(TrainingWorkload::WAIT_MS);
+    start();
+    loop.exec();
+    return timeout.isActive();
+}
+
+} // namespace
+
+bool TrainingWorkload::isRequested(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], TRAIN_OPTION) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int TrainingWorkload::exec(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QCoreApplication::translate(
+        "TrainingWorkload", "Training run of profile-guided XFB builds"));
+    parser.addHelpOption();
+    parser.addOption(QCommandLineOption(
+        QStringLiteral("pgo-train"),
+        QCoreApplication::translate("TrainingWorkload", "Run the training workload")));
+    QCommandLineOption tracksOption(
+        QStringLiteral("tracks"),
+        QCoreApplication::translate("TrainingWorkload", "Tracks in the synthetic library"),
+        QStringLiteral("n"), QString::number(DEFAULT_TRACKS));
+    QCommandLineOption hoursOption(
+        QStringLiteral("hours"),
+        QCoreApplication::translate("TrainingWorkload", "Hours of automation to simulate"),
+        QStringLiteral("n"), QString::number(DEFAULT_HOURS));
+    QCommandLineOption directoryOption(
+        QStringLiteral("directory"),
+        QCoreApplication::translate("TrainingWorkload",
+                                    "Empty directory for the library, instead of a temporary one"),
+        QStringLiteral("dir"));
+    parser.addOption(tracksOption);
+    parser.addOption(hoursOption);
+    parser.addOption(directoryOption);
+    parser.process(app);
+
+    QTemporaryDir temporary;
+    const QString directory =
+        parser.isSet(directoryOption) ? parser.value(directoryOption) : temporary.path();
+    if (directory.isEmpty() || !QDir().mkpath(directory)) {
+        QTextStream(stderr) << "xfb --pgo-train: no directory for the library\n";
+        return 1;
+    }
+
+    TrainingWorkload workload(directory, qMax(100, parser.value(tracksOption).toInt()),
+                              qMax(1, parser.value(hoursOption).toInt()));
+    return workload.run() ? 0 : 1;
+}
+
+TrainingWorkload::TrainingWorkload(const QString& directory, int tracks, int hours)
+    : m_directory(directory)
+    , m_databasePath(QDir(directory).filePath("adb.db"))
+    , m_tracks(tracks)
+    , m_hours(hours)
+{
+    SyntheticLibrary::Options options;
+    options.tracks = tracks;
+    options.root = directory;
+    options.audio = SyntheticLibrary::Audio::Mp3;
+    options.stubMs = 50;
+    options.seed = SEED;
+    m_library = std::make_unique<SyntheticLibrary>(options);
+}
+
+TrainingWorkload::~TrainingWorkload()
+{
+    m_table.reset();
+    m_music.reset();
+    if (m_database.isOpen()) {
+        m_database.close();
+    }
+    m_database = QSqlDatabase();
+    QSqlDatabase::removeDatabase(CONNECTION_NAME);
+}
+
+bool TrainingWorkload::run()
+{
+    return importLibrary() && browseLibrary() && searchLibrary() && runAutomation();
+}
+
+bool TrainingWorkload::importLibrary()
+{
+    QElapsedTimer timer;
+    timer.start();
+    QString error;
+    if (!m_library->writeFiles(&error)) {
+        QTextStream(stderr) << "xfb --pgo-train: " << error << '\n';
+        return false;
+    }
+    report("files", QString("%1 files").arg(m_tracks), timer.restart());
+
+    if (!DatabaseService::provisionDatabaseFile(":/adb.db", m_databasePath, &error)) {
+        QTextStream(stderr) << "xfb --pgo-train: " << error << '\n';
+        return false;
+    }
+    m_database = DatabaseService::openNamedConnection(CONNECTION_NAME, m_databasePath, &error);
+    if (!m_database.isOpen()) {
+        QTextStream(stderr) << "xfb --pgo-train: " << error << '\n';
+        return false;
+    }
+    m_music = std::make_unique<MusicRepository>(m_database);
+    m_fullText = MusicRepository::ensureFullTextIndex(m_database);
+
+    const QString library = QDir(m_directory).filePath(SyntheticLibrary::MUSIC_FOLDER);
+    const int imported = m_music->importFromDirectory(library, true);
+    report("import", QString("%1 tracks").arg(imported), timer.restart());
+
+    // A rescan finds every file known and reads no tags
+    m_music->importFromDirectory(library, true);
+    report("rescan", QString("%1 files").arg(m_tracks), timer.elapsed());
+    return imported > 0;
+}
+
+bool TrainingWorkload::browseLibrary()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    m_table = std::make_unique<LiveTableModel>("musics", CONNECTION_NAME);
+    if (!m_table->select()) {
+        QTextStream(stderr) << "xfb --pgo-train: " << m_table->lastError().text() << '\n';
+        return false;
+    }
+
+    // Down to the end half a page at a time, then back up a page at a time
+    const int rows = m_table->rowCount();
+    for (int row = 0; row < rows; row += PAGE_ROWS / 2) {
+        readPage(row);
+    }
+    for (int row = rows - PAGE_ROWS; row > 0; row -= PAGE_ROWS) {
+        readPage(row);
+    }
+
+    for (const char* column : {"artist", "song", "genre1", "played_times"}) {
+        const int index = m_table->fieldIndex(column);
+        if (index < 0) {
+            continue;
+        }
+        m_table->sort(index, Qt::AscendingOrder);
+        readPage(rows / 2);
+        m_table->sort(index, Qt::DescendingOrder);
+        readPage(0);
+    }
+
+    for (const SyntheticLibrary::Genre& genre : SyntheticLibrary::genres()) {
+        QVariantList values;
+        m_table->setFilter(m_music->genreCondition(genre.name, QString(), values), values);
+        m_table->select();
+        for (int row = 0; row < qMin(m_table->rowCount(), 10 * PAGE_ROWS); row += PAGE_ROWS) {
+            readPage(row);
+        }
+    }
+    m_table->setFilter(QString());
+    m_table->select();
+
+    report("browse", QString("%1 rows").arg(rows), timer.elapsed());
+    return true;
+}
+
+bool TrainingWorkload::searchLibrary()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    MusicCache cache;
+    cache.setMaxMemoryUsage(16 * 1024 * 1024);
+    cache.setWarmupStrategy(MusicCache::NoWarmup);
+    cache.initialize();
+    cache.attachRepository(m_music.get());
+
+    SearchController search(m_databasePath, &cache);
+    search.setFullTextSearch(m_fullText);
+
+    SearchController::Result last;
+    QObject::connect(&search, &SearchController::resultsReady,
+                     [&last](const SearchController::Result& result) { last = result; });
+
+    int searches = 0;
+    // The second round comes from the cache, as a user going back to a search does
+    for (int round = 0; round < 2; ++round) {
+        for (const char* typed : TYPED) {
+            const QString text = QString::fromLatin1(typed);
+            for (int length = 1; length <= text.size(); ++length) {
+                const QString prefix = text.left(length);
+                if (!waitFor(&search, &SearchController::resultsReady,
+                             [&search, &prefix]() { search.searchNow(prefix); })) {
+                    QTextStream(stderr) << "xfb --pgo-train: no result for " << prefix << '\n';
+                    return false;
+                }
+                ++searches;
+                m_table->setFilter(last.condition, last.bindValues);
+                if (!m_table->assignRows(last.fields, last.keys, last.rows)) {
+                    m_table->select();
+                }
+                readPage(0);
+            }
+        }
+    }
+
+    MusicRepository::SearchCriteria criteria;
+    criteria.limit = 200;
+    for (const SyntheticLibrary::Genre& genre : SyntheticLibrary::genres()) {
+        criteria.genre1 = genre.name;
+        m_music->searchMusic(criteria);
+    }
+    criteria = MusicRepository::SearchCriteria();
+    for (int i = 0; i < 50; ++i) {
+        criteria.artist = SyntheticLibrary::artistName(i * 7 % m_library->artistCount());
+        m_music->searchMusic(criteria);
+    }
+
+    m_table->setFilter(QString());
+    m_table->select();
+    report("search", QString("%1 searches").arg(searches), timer.elapsed());
+    return true;
+}
+
+bool TrainingWorkload::runAutomation()
+{
+    QElapsedTimer timer;
+    timer.start();
+    QString error;
+    if (!m_library->writeSchedule(m_database, &error)
+        || !m_library->writeHourGenres(m_database, &error)) {
+        QTextStream(stderr) << "xfb --pgo-train: " << error << '\n';
+        return false;
+    }
+    HourGenreSchedule hourGenres(m_database);
+
+    LibrarySnapshotStore snapshots(m_databasePath);
+    if (!waitFor(&snapshots, &LibrarySnapshotStore::rebuilt,
+                 [&snapshots]() { snapshots.rebuild(); })) {
+        QTextStream(stderr) << "xfb --pgo-train: the library snapshot was not read\n";
+        return false;
+    }
+
+    RotationEngine rotation(m_database);
+    rotation.setSnapshots(&snapshots);
+    rotation.setSeed(SEED);
+    rotation.setSeparation(RotationEngine::DEFAULT_SEPARATION);
+    rotation.setArtistSeparation(60);
+    rotation.setTitleSeparation(180);
+
+    SchedulerEngine scheduler(m_database);
+    int scheduled = 0;
+    QObject::connect(&scheduler, &SchedulerEngine::eventDue,
+                     [&scheduled](const ScheduledEvent&) { ++scheduled; });
+    if (!scheduler.reload()) {
+        return false;
+    }
+
+    // Air time passes as fast as the engines answer
+    QRandomGenerator random(SEED);
+    QDateTime at(AIR_DATE, AIR_START);
+    const QDateTime end = at.addSecs(qint64(m_hours) * 3600);
+    int played = 0;
+    int lastHour = -1;
+    while (at < end) {
+        scheduler.processDue(at);
+        if (at.time().hour() != lastHour) {
+            lastHour = at.time().hour();
+            scheduler.upcomingEvents(at, at.addSecs(3600));
+        }
+
+        const QString genre = hourGenres.genreAt(at);
+        QString path = rotation.nextTrack(genre, at);
+        if (path.isEmpty()) {
+            path = rotation.nextTrack(QString(), at);
+        }
+        if (!path.isEmpty()) {
+            rotation.markPlayed(path, at);
+            ++played;
+        }
+        rotation.upcoming(genre, 5);
+
+        at = at.addSecs(150 + random.bounded(150));
+    }
+
+    report("automation",
+           QString("%1 h, %2 tracks, %3 scheduled").arg(m_hours).arg(played).arg(scheduled),
+           timer.elapsed());
+    return played > 0;
+}
+
+void TrainingWorkload::readPage(int firstRow)
+{
+    const int last = qMin(m_table->rowCount(), qMax(0, firstRow) + PAGE_ROWS);
+    const int columns = m_table->columnCount();
+    for (int row = qMax(0, firstRow); row < last; ++row) {
+        for (int column = 0; column < columns; ++column) {
+            m_table->data(m_table->index(row, column), Qt::DisplayRole);
+        }
+    }
+}
+
+void TrainingWorkload::report(const char* phase, const QString& result, qint64 elapsedMs)
+{
+    QTextStream(stdout) << "xfb --pgo-train: " << phase << ' ' << result << " in " << elapsedMs
+                        << " ms\n";
+}
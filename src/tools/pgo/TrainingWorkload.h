@@ -0,0 +1,95 @@
+#ifndef TRAININGWORKLOAD_H
+#define TRAININGWORKLOAD_H
+
+#include <QSqlDatabase>
+#include <QString>
+#include <memory>
+
+class LiveTableModel;
+class MusicRepository;
+class SyntheticLibrary;
+
+/**
+ * @brief A station's day in a few minutes, run by an instrumented XFB to train it
+ *
+ * Packaged binaries were built with generic optimization flags, so the
+ * compiler had to guess which branches of the import, the library table,
+ * the search and the automation are the hot ones. With XFB_PGO=GENERATE
+ * (top-level CMakeLists.txt) XFB is built instrumented, and the
+ * xfb_pgo_train target runs `XFB --pgo-train`: headless, on a
+ * SyntheticLibrary in a temporary directory, the workload goes through
+ *
+ * - the import: a folder of tagged files read by importFromDirectory(),
+ *   then read again as a rescan that finds them all known;
+ * - the library table: LiveTableModel scrolled down and up a page at a
+ *   time, sorted, and filtered by genre;
+ * - the search: SearchController fed the words as they are typed, twice,
+ *   the second time from its cache, and MusicRepository::searchMusic();
+ * - the automation: RotationEngine, HourGenreSchedule and SchedulerEngine
+ *   driven through `--hours` of simulated air time, a track every few
+ *   minutes and pubs and programs as scheduled, without waiting for them.
+ *
+ * The profile it leaves is what XFB_PGO=USE optimizes for. The library and
+ * the sequence are the same on every run, so builds are reproducible.
+ *
+ * @since XFB 2.0
+ */
+class TrainingWorkload
+{
+public:
+    static constexpr const char* TRAIN_OPTION = "--pgo-train";
+    static constexpr int DEFAULT_TRACKS = 20000;
+    static constexpr int DEFAULT_HOURS = 12;
+    static constexpr int PAGE_ROWS = 40;           ///< Rows of the library table on screen
+    static constexpr int WAIT_MS = 60000;          ///< Longest wait for a search or a snapshot
+    static constexpr quint32 SEED = 20240517;
+
+    /**
+     * @brief Check a command line for TRAIN_OPTION
+     */
+    static bool isRequested(int argc, char* argv[]);
+
+    /**
+     * @brief Run the workload as `XFB --pgo-train [--tracks n] [--hours n] [--directory dir]`
+     * @return Exit code, 0 if every phase ran
+     */
+    static int exec(int argc, char* argv[]);
+
+    /**
+     * @param directory Where the library and its database are made; must be empty
+     * @param tracks Tracks in the synthetic library
+     * @param hours Hours of automation to simulate
+     */
+    TrainingWorkload(const QString& directory, int tracks, int hours);
+    ~TrainingWorkload();
+
+    TrainingWorkload(const TrainingWorkload&) = delete;
+    TrainingWorkload& operator=(const TrainingWorkload&) = delete;
+
+    /**
+     * @brief Run the phases in order, stopping at the first that fails
+     */
+    bool run();
+
+private:
+    bool importLibrary();
+    bool browseLibrary();
+    bool searchLibrary();
+    bool runAutomation();
+
+    void readPage(int firstRow);
+    static void report(const char* phase, const QString& result, qint64 elapsedMs);
+
+    QString m_directory;
+    QString m_databasePath;
+    int m_tracks;
+    int m_hours;
+    bool m_fullText = false;
+
+    std::unique_ptr<SyntheticLibrary> m_library;
+    QSqlDatabase m_database;
+    std::unique_ptr<MusicRepository> m_music;
+    std::unique_ptr<LiveTableModel> m_table;
+};
+
+#endif // TRAININGWORKLOAD_H
@@ -0,0 +1,127 @@
+#include "ElidedTextDelegate.h"
+#include <QApplication>
+#include <QHeaderView>
+#include <QPainter>
+#include <QTableView>
+
+ElidedTextDelegate::ElidedTextDelegate(QObject* parent)
+    : QStyledItemDelegate(parent)
+{
+}
+
+ElidedTextDelegate* ElidedTextDelegate::install(QTableView* view)
+{
+    auto* delegate = new ElidedTextDelegate(view);
+    view->setItemDelegate(delegate);
+    view->setWordWrap(false);
+
+    QHeaderView* rows = view->verticalHeader();
+    rows->setSectionResizeMode(QHeaderView::Fixed);
+    rows->setDefaultSectionSize(rowHeight(view->font()));
+    if (QAbstractItemModel* model = view->model()) {
+        connect(model, &QAbstractItemModel::modelReset, delegate,
+                &ElidedTextDelegate::clearCache);
+    }
+    return delegate;
+}
+
+int ElidedTextDelegate::rowHeight(const QFont& font)
+{
+    return QFontMetrics(font).height() + 2 * ROW_PADDING;
+}
+
+void ElidedTextDelegate::paint(QPainter* painter, const QStyleOptionViewItem& option,
+                               const QModelIndex& index) const
+{
+    QStyleOptionViewItem opt = option;
+    initStyleOption(&opt, index);
+
+    // Text of several lines is rare enough to leave to the usual layout
+    if (opt.text.contains(QLatin1Char('\n'))) {
+        QStyledItemDelegate::paint(painter, option, index);
+        return;
+    }
+
+    const QWidget* widget = opt.widget;
+    QStyle* style = widget ? widget->style() : QApplication::style();
+    const QString text = opt.text;
+    const QRect textRect = style->subElementRect(QStyle::SE_ItemViewItemText, &opt, widget);
+
+    // Everything but the text, as the style draws it
+    opt.text.clear();
+    style->drawControl(QStyle::CE_ItemViewItem, &opt, painter, widget);
+    if (text.isEmpty()) {
+        return;
+    }
+
+    const int margin = style->pixelMetric(QStyle::PM_FocusFrameHMargin, nullptr, widget) + 1;
+    const QRect area = textRect.adjusted(margin, 0, -margin, 0);
+    if (area.width() <= 0) {
+        return;
+    }
+
+    const QStaticText& layout = layoutFor(text, area.width(), opt, index);
+    const QRect placed = QStyle::alignedRect(opt.direction, opt.displayAlignment,
+                                             layout.size().toSize(), area);
+
+    QPalette::ColorGroup group = QPalette::Normal;
+    if (!(opt.state & QStyle::State_Enabled)) {
+        group = QPalette::Disabled;
+    } else if (!(opt.state & QStyle::State_Active)) {
+        group = QPalette::Inactive;
+    }
+    const QPalette::ColorRole role =
+        (opt.state & QStyle::State_Selected) ? QPalette::HighlightedText : QPalette::Text;
+
+    painter->save();
+    painter->setPen(opt.palette.color(group, role));
+    painter->setFont(opt.font);
+    painter->setClipRect(area);
+    painter->drawStaticText(placed.topLeft(), layout);
+    painter->restore();
+}
+
+QSize ElidedTextDelegate::sizeHint(const QStyleOptionViewItem& option,
+                                   const QModelIndex& index) const
+{
+    // Only resizing a column to its contents asks; rows keep one height
+    return QSize(QStyledItemDelegate::sizeHint(option, index).width(), rowHeight(option.font));
+}
+
+void ElidedTextDelegate::clearCache()
+{
+    m_cache.clear();
+}
+
+const QStaticText& ElidedTextDelegate::layoutFor(const QString& text, int width,
+                                                 const QStyleOptionViewItem& option,
+                                                 const QModelIndex& index) const
+{
+    if (option.font != m_font) {
+        m_cache.clear();
+        m_font = option.font;
+    }
+
+    const quint64 key = (quint64(quint32(index.row())) << 32) | quint32(index.column());
+    const auto it = m_cache.constFind(key);
+    if (it != m_cache.cend() && it->width == width && it->elideMode == option.textElideMode
+        && it->text == text) {
+        ++m_stats.hits;
+        return it->layout;
+    }
+
+    ++m_stats.misses;
+    if (it == m_cache.cend() && m_cache.size() >= MAX_CACHED_CELLS) {
+        m_cache.clear();
+    }
+
+    Cell cell;
+    cell.text = text;
+    cell.width = width;
+    cell.elideMode = option.textElideMode;
+    cell.layout.setTextFormat(Qt::PlainText);
+    cell.layout.setPerformanceHint(QStaticText::AggressiveCaching);
+    cell.layout.setText(option.fontMetrics.elidedText(text, option.textElideMode, width));
+    cell.layout.prepare(QTransform(), option.font);
+    return *m_cache.insert(key, std::move(cell));
+}
@@ -0,0 +1,95 @@
+#ifndef ELIDEDTEXTDELEGATE_H
+#define ELIDEDTEXTDELEGATE_H
+
+#include <QFont>
+#include <QHash>
+#include <QStaticText>
+#include <QStyledItemDelegate>
+
+class QTableView;
+
+/**
+ * @brief Draws one line of elided text per cell, laid out once
+ *
+ * QStyledItemDelegate lays the text of every cell out again on each
+ * paint, which is where scrolling a table of the whole library spent its
+ * time. This delegate keeps the elided text of each cell it drew as a
+ * QStaticText, keyed by row and column, and only lays it out again when
+ * the cell's text, width or font changed. Background, selection, icons and
+ * the focus frame are still drawn by the style.
+ *
+ * The cache holds at most MAX_CACHED_CELLS cells, a few screens of a
+ * table; past that it is emptied and refills with the cells that are
+ * drawn next, the visible ones.
+ *
+ * install() also gives every row of the view the same fixed height, so the
+ * view never measures a row to lay out or scroll.
+ *
+ * @example
+ * @code
+ * ElidedTextDelegate::install(ui->musicView);
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class ElidedTextDelegate : public QStyledItemDelegate
+{
+    Q_OBJECT
+
+public:
+    static constexpr int MAX_CACHED_CELLS = 4096;
+
+    /**
+     * @brief Cache counters
+     */
+    struct Statistics {
+        qint64 hits = 0;      ///< Cells drawn from their cached layout
+        qint64 misses = 0;    ///< Cells laid out
+    };
+
+    explicit ElidedTextDelegate(QObject* parent = nullptr);
+
+    /**
+     * @brief Draw a view's cells with a new delegate, in rows of one fixed height
+     * @param view Table to set up; the delegate is its child
+     * @return The delegate installed
+     */
+    static ElidedTextDelegate* install(QTableView* view);
+
+    /**
+     * @brief Height of a row of one line in the given font
+     */
+    static int rowHeight(const QFont& font);
+
+    void paint(QPainter* painter, const QStyleOptionViewItem& option,
+               const QModelIndex& index) const override;
+    QSize sizeHint(const QStyleOptionViewItem& option, const QModelIndex& index) const override;
+
+    /**
+     * @brief Forget every layout, for a model that was reset
+     */
+    void clearCache();
+
+    int cachedCells() const { return int(m_cache.size()); }
+    Statistics statistics() const { return m_stats; }
+
+private:
+    struct Cell {
+        QString text;
+        int width = 0;
+        Qt::TextElideMode elideMode = Qt::ElideRight;
+        QStaticText layout;
+    };
+
+    static constexpr int ROW_PADDING = 4;   ///< Above and below the line
+
+    const QStaticText& layoutFor(const QString& text, int width,
+                                 const QStyleOptionViewItem& option,
+                                 const QModelIndex& index) const;
+
+    mutable QHash<quint64, Cell> m_cache;
+    mutable QFont m_font;
+    mutable Statistics m_stats;
+};
+
+#endif // ELIDEDTEXTDELEGATE_H
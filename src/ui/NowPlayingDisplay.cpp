@@ -0,0 +1,109 @@
+#include "NowPlayingDisplay.h"
+#include "../services/NowPlayingMonitor.h"
+#include <QDateTime>
+#include <QVBoxLayout>
+#include <cstring>
+
+namespace {
+
+const char* const DISPLAY_OPTION = "--display";
+
+QString clockText(qint64 ms)
+{
+    const qint64 seconds = ms / 1000;
+    return QString("%1:%2").arg(seconds / 60).arg(seconds % 60, 2, 10, QChar('0'));
+}
+
+} // namespace
+
+NowPlayingDisplay::NowPlayingDisplay(const QString& databasePath, QWidget* parent)
+    : QWidget(parent)
+    , m_monitor(new NowPlayingMonitor(databasePath, this))
+    , m_title(new QLabel(this))
+    , m_remaining(new QLabel(this))
+    , m_upcoming(new QLabel(this))
+{
+    setWindowTitle(tr("XFB - Now playing"));
+    setAccessibleName(tr("Now playing"));
+
+    QFont titleFont = font();
+    titleFont.setPointSize(titleFont.pointSize() * 4);
+    titleFont.setBold(true);
+    m_title->setFont(titleFont);
+    m_title->setWordWrap(true);
+    m_title->setAlignment(Qt::AlignCenter);
+
+    QFont remainingFont = font();
+    remainingFont.setPointSize(remainingFont.pointSize() * 2);
+    m_remaining->setFont(remainingFont);
+    m_remaining->setAlignment(Qt::AlignCenter);
+
+    QFont upcomingFont = font();
+    upcomingFont.setPointSize(upcomingFont.pointSize() * 3 / 2);
+    m_upcoming->setFont(upcomingFont);
+    m_upcoming->setAlignment(Qt::AlignHCenter | Qt::AlignTop);
+
+    auto* layout = new QVBoxLayout(this);
+    layout->addStretch(1);
+    layout->addWidget(m_title);
+    layout->addWidget(m_remaining);
+    layout->addSpacing(40);
+    layout->addWidget(m_upcoming, 1);
+
+    m_clock.setInterval(1000);
+    connect(&m_clock, &QTimer::timeout, this, &NowPlayingDisplay::updateRemaining);
+    connect(m_monitor, &NowPlayingMonitor::changed, this, &NowPlayingDisplay::showEntry);
+    connect(m_monitor, &NowPlayingMonitor::connectionFailed, this, [this](const QString&) {
+        m_title->setText(tr("Waiting for the station..."));
+        m_remaining->clear();
+        m_upcoming->clear();
+    });
+
+    showEntry(NowPlayingStatus::Entry());
+    m_monitor->start();
+    m_clock.start();
+}
+
+bool NowPlayingDisplay::isRequested(int argc, char* argv[], QString* databasePath)
+{
+    const size_t length = std::strlen(DISPLAY_OPTION);
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], DISPLAY_OPTION, length) != 0) {
+            continue;
+        }
+        if (argv[i][length] == '\0') {
+            return true;
+        }
+        if (argv[i][length] == '=') {
+            if (databasePath) {
+                *databasePath = QString::fromLocal8Bit(argv[i] + length + 1);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+void NowPlayingDisplay::showEntry(const NowPlayingStatus::Entry& entry)
+{
+    m_entry = entry;
+    m_title->setText(entry.isEmpty() ? tr("Off air") : entry.title);
+
+    QStringList next;
+    for (const QString& path : entry.upcoming) {
+        next.append(NowPlayingStatus::titleOf(path));
+    }
+    m_upcoming->setText(next.isEmpty() ? QString() : tr("Next:\n%1").arg(next.join('\n')));
+    updateRemaining();
+}
+
+void NowPlayingDisplay::updateRemaining()
+{
+    if (m_entry.isEmpty() || m_entry.durationMs <= 0 || !m_entry.startedAt.isValid()) {
+        m_remaining->clear();
+        return;
+    }
+    const qint64 elapsed = m_entry.startedAt.msecsTo(QDateTime::currentDateTime());
+    const qint64 remaining = qMax<qint64>(0, m_entry.durationMs - elapsed);
+    m_remaining->setText(tr("%1 left").arg(clockText(remaining)));
+}
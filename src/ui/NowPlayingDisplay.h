@@ -0,0 +1,67 @@
+#ifndef NOWPLAYINGDISPLAY_H
+#define NOWPLAYINGDISPLAY_H
+
+#include "../repositories/NowPlayingStatus.h"
+#include <QLabel>
+#include <QTimer>
+#include <QWidget>
+
+class NowPlayingMonitor;
+
+/**
+ * @brief Full screen now playing board for lobby and studio displays
+ *
+ * Started with xfb --display, or --display=<database> for a library kept
+ * elsewhere, such as on a share of the machine on air. The board shows the
+ * title on air, the time left and what comes next, as NowPlayingMonitor
+ * reads them from the now_playing table; it plays nothing and never writes
+ * the database, so any number of displays can follow one station.
+ *
+ * The time left is counted down locally between reads.
+ *
+ * @example
+ * @code
+ * QString databasePath;
+ * if (NowPlayingDisplay::isRequested(argc, argv, &databasePath)) {
+ *     NowPlayingDisplay display(databasePath);
+ *     display.showFullScreen();
+ *     return app.exec();
+ * }
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class NowPlayingDisplay : public QWidget
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @param databasePath Library database the instance on air writes
+     * @param parent Parent widget
+     */
+    explicit NowPlayingDisplay(const QString& databasePath, QWidget* parent = nullptr);
+
+    /**
+     * @brief Check the command line for --display
+     * @param databasePath Set to the file given as --display=<file>, if any
+     */
+    static bool isRequested(int argc, char* argv[], QString* databasePath = nullptr);
+
+    NowPlayingMonitor* monitor() const { return m_monitor; }
+
+public slots:
+    void showEntry(const NowPlayingStatus::Entry& entry);
+
+private:
+    void updateRemaining();
+
+    NowPlayingMonitor* m_monitor = nullptr;
+    QLabel* m_title = nullptr;
+    QLabel* m_remaining = nullptr;
+    QLabel* m_upcoming = nullptr;
+    QTimer m_clock;
+    NowPlayingStatus::Entry m_entry;
+};
+
+#endif // NOWPLAYINGDISPLAY_H
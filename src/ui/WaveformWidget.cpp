@@ -0,0 +1,158 @@
+#include "WaveformWidget.h"
+#include <QMouseEvent>
+#include <QPainter>
+#include <QPaintEvent>
+
+WaveformWidget::WaveformWidget(QWidget* parent)
+    : QWidget(parent)
+{
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setAccessibleName(tr("Waveform"));
+    setAccessibleDescription(tr("Waveform of the track on air; click to move the play position"));
+}
+
+bool WaveformWidget::setPeakFile(const QString& peakPath)
+{
+    const bool opened = m_peaks.open(peakPath);
+    m_positionMs = 0;
+    rebuildColumns();
+    update();
+    return opened;
+}
+
+void WaveformWidget::clear()
+{
+    m_peaks.close();
+    m_positionMs = 0;
+    m_cue = CuePoints();
+    rebuildColumns();
+    update();
+}
+
+void WaveformWidget::setCuePoints(const CuePoints& cue)
+{
+    if (m_cue == cue) {
+        return;
+    }
+    m_cue = cue;
+    update();
+}
+
+QSize WaveformWidget::sizeHint() const
+{
+    return QSize(400, 48);
+}
+
+void WaveformWidget::setPosition(qint64 positionMs)
+{
+    // Only the columns between the old and the new position change colour
+    const int from = xForMs(m_positionMs);
+    const int to = xForMs(positionMs);
+    m_positionMs = positionMs;
+    if (from != to) {
+        update(QRect(QPoint(qMin(from, to) - 1, 0), QPoint(qMax(from, to) + 1, height())));
+    }
+}
+
+void WaveformWidget::paintEvent(QPaintEvent* event)
+{
+    QPainter painter(this);
+    const QRect area = event->rect();
+    painter.fillRect(area, QColor(24, 24, 36));
+    if (!m_peaks.isOpen()) {
+        return;
+    }
+
+    // Lines are batched by colour and clipped to the damaged columns
+    const int position = xForMs(m_positionMs);
+    const int first = qMax(0, area.left());
+    const int last = qMin<int>(m_columns.size(), area.right() + 1);
+    if (first < qMin(last, position)) {
+        painter.setPen(QColor(124, 124, 186));
+        painter.drawLines(m_columns.constData() + first, qMin(last, position) - first);
+    }
+    if (qMax(first, position) < last) {
+        painter.setPen(QColor(74, 74, 110));
+        painter.drawLines(m_columns.constData() + qMax(first, position),
+                          last - qMax(first, position));
+    }
+
+    const QColor shade(0, 0, 0, 140);
+    if (m_cue.inMs > 0) {
+        painter.fillRect(QRect(0, 0, xForMs(m_cue.inMs), height()).intersected(area), shade);
+    }
+    if (m_cue.outMs >= 0) {
+        const int out = xForMs(m_cue.outMs);
+        painter.fillRect(QRect(out, 0, width() - out, height()).intersected(area), shade);
+    }
+
+    // The end of the intro and the segue point are marked with thin lines
+    if (m_cue.introMs > 0) {
+        painter.setPen(QColor(96, 176, 120));
+        painter.drawLine(xForMs(m_cue.introMs), 0, xForMs(m_cue.introMs), height());
+    }
+    if (m_cue.segueMs >= 0) {
+        painter.setPen(QColor(210, 150, 70));
+        painter.drawLine(xForMs(m_cue.segueMs), 0, xForMs(m_cue.segueMs), height());
+    }
+
+    painter.setPen(QColor(230, 230, 240));
+    painter.drawLine(position, 0, position, height());
+}
+
+void WaveformWidget::resizeEvent(QResizeEvent* event)
+{
+    QWidget::resizeEvent(event);
+    rebuildColumns();
+}
+
+void WaveformWidget::mousePressEvent(QMouseEvent* event)
+{
+    if (event->button() != Qt::LeftButton || !m_peaks.isOpen() || width() <= 0) {
+        QWidget::mousePressEvent(event);
+        return;
+    }
+    const double fraction = qBound(0.0, event->position().x() / width(), 1.0);
+    emit seekRequested(static_cast<qint64>(fraction * m_peaks.durationMs()));
+}
+
+void WaveformWidget::rebuildColumns()
+{
+    m_columns.clear();
+    const int columns = width();
+    if (!m_peaks.isOpen() || columns <= 0 || m_peaks.frames() <= 0) {
+        return;
+    }
+
+    const int level = m_peaks.levelFor(double(m_peaks.frames()) / columns);
+    const PeakFile::Bucket* buckets = m_peaks.buckets(level);
+    const qint64 count = m_peaks.bucketCount(level);
+    if (count <= 0) {
+        return;
+    }
+
+    const double middle = height() / 2.0;
+    const double scale = (height() / 2.0 - 1.0) / 127.0;
+    m_columns.reserve(columns);
+    for (int x = 0; x < columns; ++x) {
+        const qint64 begin = qMin(count - 1, x * count / columns);
+        const qint64 end = qMax(begin + 1, (x + 1) * count / columns);
+        int min = buckets[begin].min;
+        int max = buckets[begin].max;
+        for (qint64 i = begin + 1; i < end; ++i) {
+            min = qMin<int>(min, buckets[i].min);
+            max = qMax<int>(max, buckets[i].max);
+        }
+        m_columns.append(QLine(x, qRound(middle - max * scale), x, qRound(middle - min * scale)));
+    }
+}
+
+int WaveformWidget::xForMs(qint64 positionMs) const
+{
+    const qint64 duration = m_peaks.durationMs();
+    if (duration <= 0) {
+        return 0;
+    }
+    return static_cast<int>(qBound<qint64>(0, positionMs, duration) * width() / duration);
+}
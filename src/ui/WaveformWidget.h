@@ -0,0 +1,91 @@
+#ifndef WAVEFORMWIDGET_H
+#define WAVEFORMWIDGET_H
+
+#include "../services/CuePoints.h"
+#include "../services/PeakFile.h"
+#include <QLine>
+#include <QVector>
+#include <QWidget>
+
+/**
+ * @brief Draws the waveform of a track from its peak file
+ *
+ * The widget maps the track's PeakFile and draws one min/max line per
+ * pixel column from the coarsest level that still has a bucket per pixel,
+ * so it never decodes audio and repainting costs a few thousand bucket
+ * reads at most. The columns are only worked out again when the file or
+ * the width changes.
+ *
+ * The played part is drawn brighter than the rest. Whatever lies before
+ * the cue-in and after the cue-out point is shaded, which shows how long
+ * the intro and outro are; the end of the intro and the segue point are
+ * marked with a line. Clicking asks for a seek to that point.
+ *
+ * @example
+ * @code
+ * WaveformWidget* waveform = new WaveformWidget(this);
+ * waveform->setPeakFile(peakGenerator->peakPath(track));
+ * connect(engine, &PlaybackEngine::positionChanged, waveform, &WaveformWidget::setPosition);
+ * @endcode
+ *
+ * @since XFB 2.0
+ */
+class WaveformWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit WaveformWidget(QWidget* parent = nullptr);
+
+    /**
+     * @brief Show the waveform in a peak file
+     * @param peakPath File written by PeakFile
+     * @return false if it cannot be read; the widget is then cleared
+     */
+    bool setPeakFile(const QString& peakPath);
+
+    /**
+     * @brief Show no waveform
+     */
+    void clear();
+
+    bool hasPeaks() const { return m_peaks.isOpen(); }
+
+    /**
+     * @brief Set the cue points to shade outside of
+     * @param cue Cue points of the track; the default shades nothing
+     */
+    void setCuePoints(const CuePoints& cue);
+
+    QSize sizeHint() const override;
+
+public slots:
+    /**
+     * @brief Move the play position
+     * @param positionMs Position in the track
+     */
+    void setPosition(qint64 positionMs);
+
+signals:
+    /**
+     * @brief Emitted when the waveform is clicked
+     * @param positionMs Position in the track under the pointer
+     */
+    void seekRequested(qint64 positionMs);
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+    void resizeEvent(QResizeEvent* event) override;
+    void mousePressEvent(QMouseEvent* event) override;
+
+private:
+    void rebuildColumns();
+    int xForMs(qint64 positionMs) const;
+
+    PeakFile m_peaks;
+    QVector<QLine> m_columns;   ///< One line per pixel column, for the current width
+    qint64 m_positionMs = 0;
+    CuePoints m_cue;
+};
+
+#endif // WAVEFORMWIDGET_H
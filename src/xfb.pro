@@ -19,7 +19,6 @@ SOURCES += \
     player.cpp \
     main.cpp \
     add_music_single.cpp \
-    add_full_dir.cpp \
     addgenre.cpp \
     addjingle.cpp \
     add_pub.cpp \
@@ -34,7 +33,6 @@ HEADERS  += \
     permission_utils.h \
     player.h \
     add_music_single.h \
-    add_full_dir.h \
     addgenre.h \
     addjingle.h \
     add_pub.h \
@@ -48,7 +46,6 @@ FORMS    += \
     externaldownloader.ui \
     player.ui \
     add_music_single.ui \
-    add_full_dir.ui \
     addgenre.ui \
     addjingle.ui \
     add_pub.ui \
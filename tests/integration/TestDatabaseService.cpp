@@ -4,6 +4,7 @@
 #include <QSignalSpy>
 #include <QSqlQuery>
 #include <QSqlError>
+#include <QDateTime>
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
@@ -148,6 +149,37 @@ void TestDatabaseService::testSelectQueries()
     QVERIFY(results.isEmpty());
 }
 
+void TestDatabaseService::testForEachRow()
+{
+    QVERIFY(m_databaseService->initialize());
+    
+    createTestTables();
+    insertTestData();
+    
+    QStringList names;
+    int visited = m_databaseService->forEachRow(
+        "SELECT name, value FROM test_table WHERE value >= ? ORDER BY value", {100},
+        [this, &names](const QSqlQuery& row) {
+            names.append(row.value(0).toString());
+            // Queries issued from the visitor run on the same connection
+            return m_databaseService->executeQuery("UPDATE test_table SET value = value + 1 WHERE name = ?",
+                                                   {row.value(0)});
+        });
+    
+    QCOMPARE(visited, 3);
+    QCOMPARE(names, QStringList({"test1", "test2", "test3"}));
+    QList<QVariantMap> results = m_databaseService->executeSelect("SELECT SUM(value) AS total FROM test_table");
+    QCOMPARE(results[0]["total"].toInt(), 603);
+    
+    // Returning false stops the scan
+    int stopped = m_databaseService->forEachRow("SELECT id FROM test_table", {},
+                                                [](const QSqlQuery&) { return false; });
+    QCOMPARE(stopped, 1);
+    
+    QCOMPARE(m_databaseService->forEachRow("SELECT * FROM missing_table", {},
+                                           [](const QSqlQuery&) { return true; }), -1);
+}
+
 void TestDatabaseService::testSimpleTransaction()
 {
     QVERIFY(m_databaseService->initialize());
@@ -348,6 +380,192 @@ void TestDatabaseService::testConnectionCleanup()
     // Note: Actual cleanup testing would require waiting for the timer or manually triggering cleanup
 }
 
+
+void TestDatabaseService::testWalJournalMode()
+{
+    QVERIFY(m_databaseService->initialize());
+    
+    QSqlQuery query = m_databaseService->createQuery();
+    QVERIFY(query.exec("PRAGMA journal_mode"));
+    QVERIFY(query.next());
+    QCOMPARE(query.value(0).toString().toLower(), QString("wal"));
+    
+    QVERIFY(query.exec("PRAGMA synchronous"));
+    QVERIFY(query.next());
+    QCOMPARE(query.value(0).toInt(), 1); // NORMAL
+    
+    QCOMPARE(m_databaseService->getDatabaseStats().value("journal_mode").toString().toLower(),
+             QString("wal"));
+}
+
+void TestDatabaseService::testPerThreadConnections()
+{
+    QVERIFY(m_databaseService->initialize());
+    createTestTables();
+    
+    QString mainConnection = m_databaseService->threadConnection().connectionName();
+    QVERIFY(!mainConnection.isEmpty());
+    QCOMPARE(m_databaseService->threadConnection().connectionName(), mainConnection);
+    
+    // Hold a write transaction open on the main thread; under WAL a reader
+    // on another thread still gets its own connection and is not blocked
+    QVERIFY(m_databaseService->executeQuery("INSERT INTO test_table (name, value) VALUES ('committed', 1)"));
+    QSqlDatabase mainDb = m_databaseService->threadConnection();
+    QVERIFY(mainDb.transaction());
+    QSqlQuery pending(mainDb);
+    QVERIFY(pending.exec("INSERT INTO test_table (name, value) VALUES ('pending', 2)"));
+    
+    QString workerConnection;
+    int workerRows = -1;
+    QThread* worker = QThread::create([&]() {
+        workerConnection = m_databaseService->threadConnection().connectionName();
+        QList<QVariantMap> rows = m_databaseService->executeSelect("SELECT COUNT(*) AS count FROM test_table");
+        if (!rows.isEmpty()) {
+            workerRows = rows.first().value("count").toInt();
+        }
+    });
+    worker->start();
+    QVERIFY(worker->wait(5000));
+    
+    QVERIFY(mainDb.commit());
+    
+    QVERIFY(!workerConnection.isEmpty());
+    QVERIFY(workerConnection != mainConnection);
+    QCOMPARE(workerRows, 1);
+    
+    // The worker's connection is released when its thread finishes
+    QCOMPARE(m_databaseService->getDatabaseStats().value("thread_connections").toInt(), 1);
+    QVERIFY(!QSqlDatabase::contains(workerConnection));
+    delete worker;
+}
+
+void TestDatabaseService::testProvisionDatabaseFile()
+{
+    // A plain file stands in for the bundled resource
+    const QString bundledPath = m_tempDir.path() + "/bundled.db";
+    {
+        QSqlDatabase bundled = QSqlDatabase::addDatabase("QSQLITE", "provision_bundled");
+        bundled.setDatabaseName(bundledPath);
+        QVERIFY(bundled.open());
+        QSqlQuery query(bundled);
+        QVERIFY(query.exec("CREATE TABLE musics (id INTEGER PRIMARY KEY, path TEXT)"));
+        bundled.close();
+    }
+    QSqlDatabase::removeDatabase("provision_bundled");
+    QVERIFY(QFile::setPermissions(bundledPath, QFileDevice::ReadOwner));
+    QFile bundledFile(bundledPath);
+    QVERIFY(bundledFile.open(QIODevice::ReadOnly));
+    QVERIFY(bundledFile.setFileTime(QDateTime::currentDateTime().addSecs(-3600),
+                                    QFileDevice::FileModificationTime));
+    bundledFile.close();
+    
+    // Into a directory that does not exist yet; the copy is made writable
+    const QString databasePath = m_tempDir.path() + "/provisioned/nested/adb.db";
+    QString error;
+    QVERIFY2(DatabaseService::provisionDatabaseFile(bundledPath, databasePath, &error),
+             qPrintable(error));
+    QVERIFY(QFileInfo(databasePath).isFile());
+    QVERIFY(QFile::permissions(databasePath).testFlag(QFileDevice::WriteOwner));
+    
+    {
+        QSqlDatabase library = DatabaseService::openNamedConnection("provision_library",
+                                                                    databasePath, &error);
+        QVERIFY2(library.isOpen(), qPrintable(error));
+        QSqlQuery query(library);
+        QVERIFY(query.exec("INSERT INTO musics (path) VALUES ('/music/kept.ogg')"));
+        library.close();
+    }
+    QSqlDatabase::removeDatabase("provision_library");
+    
+    // The copy on disk is newer than the bundled one and is kept as it is
+    QVERIFY(DatabaseService::provisionDatabaseFile(bundledPath, databasePath, &error));
+    {
+        QSqlDatabase library = QSqlDatabase::addDatabase("QSQLITE", "provision_check");
+        library.setDatabaseName(databasePath);
+        QVERIFY(library.open());
+        QSqlQuery query(library);
+        QVERIFY(query.exec("SELECT COUNT(*) FROM musics"));
+        QVERIFY(query.next());
+        QCOMPARE(query.value(0).toInt(), 1);
+        library.close();
+    }
+    QSqlDatabase::removeDatabase("provision_check");
+    
+    // A missing bundle is reported, not copied
+    error.clear();
+    QVERIFY(!DatabaseService::provisionDatabaseFile(m_tempDir.path() + "/missing.db",
+                                                    m_tempDir.path() + "/other/adb.db", &error));
+    QVERIFY(!error.isEmpty());
+}
+
+void TestDatabaseService::testOpenNamedConnection()
+{
+    const QString connectionName = "test_named_connection";
+    QString error;
+    {
+        QSqlDatabase database = DatabaseService::openNamedConnection(connectionName,
+                                                                     m_testDatabasePath, &error);
+        QVERIFY2(database.isOpen(), qPrintable(error));
+        QCOMPARE(database.connectionName(), connectionName);
+        
+        QSqlQuery query(database);
+        QVERIFY(query.exec("PRAGMA journal_mode"));
+        QVERIFY(query.next());
+        QCOMPARE(query.value(0).toString().toLower(), QString("wal"));
+        QVERIFY(query.exec("PRAGMA synchronous"));
+        QVERIFY(query.next());
+        QCOMPARE(query.value(0).toInt(), 1); // NORMAL
+        
+        // Asking again for the same file hands back the open connection
+        QSqlDatabase again = DatabaseService::openNamedConnection(connectionName,
+                                                                  m_testDatabasePath, &error);
+        QVERIFY(again.isOpen());
+        QCOMPARE(again.databaseName(), m_testDatabasePath);
+        database.close();
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+    
+    // A file that cannot be created leaves the connection closed, with the reason
+    const QString unusable = m_tempDir.path() + "/no/such/dir/adb.db";
+    error.clear();
+    {
+        QSqlDatabase database = DatabaseService::openNamedConnection(connectionName, unusable,
+                                                                     &error);
+        QVERIFY(!database.isOpen());
+        QVERIFY(!error.isEmpty());
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+}
+
+void TestDatabaseService::testPingConnection()
+{
+    const QString connectionName = "test_ping_connection";
+    QString error;
+    {
+        QSqlDatabase database = DatabaseService::openNamedConnection(connectionName,
+                                                                     m_testDatabasePath, &error);
+        QVERIFY2(database.isOpen(), qPrintable(error));
+        QVERIFY(DatabaseService::pingConnection(database));
+        
+        database.close();
+        QVERIFY(!DatabaseService::pingConnection(database));
+        
+        // Reopened under the same name, with the pragmas applied again
+        QSqlDatabase reopened = DatabaseService::openNamedConnection(connectionName,
+                                                                     m_testDatabasePath, &error);
+        QVERIFY2(reopened.isOpen(), qPrintable(error));
+        QVERIFY(DatabaseService::pingConnection(reopened));
+        QSqlQuery query(reopened);
+        QVERIFY(query.exec("PRAGMA journal_mode"));
+        QVERIFY(query.next());
+        QCOMPARE(query.value(0).toString().toLower(), QString("wal"));
+        reopened.close();
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+    
+    QVERIFY(!DatabaseService::pingConnection(QSqlDatabase()));
+}
+
 void TestDatabaseService::testDatabaseBackup()
 {
     QVERIFY(m_databaseService->initialize());
@@ -373,6 +591,51 @@ void TestDatabaseService::testDatabaseBackup()
     QVERIFY(backupInfo.size() > 0);
 }
 
+void TestDatabaseService::testOnlineBackup()
+{
+    QVERIFY(m_databaseService->initialize());
+    
+    createTestTables();
+    insertTestData();
+    int rowCount = m_databaseService->executeSelect("SELECT COUNT(*) AS count FROM test_table")
+                       .first().value("count").toInt();
+    
+    QString backupPath = m_tempDir.path() + "/online_backup.db";
+    
+    QSignalSpy progressSpy(m_databaseService.get(), &DatabaseService::backupProgress);
+    QSignalSpy backupCompletedSpy(m_databaseService.get(), &DatabaseService::backupCompleted);
+    
+    // One page per step so the job spans several event loop iterations
+    QVERIFY(m_databaseService->startBackup(backupPath, 1));
+    QVERIFY(m_databaseService->isBackupRunning());
+    QVERIFY(!m_databaseService->startBackup(backupPath));
+    
+    // Writes made while the job runs neither fail nor restart it
+    QVERIFY(m_databaseService->executeQuery("INSERT INTO test_table (name, value) VALUES ('during', 1)"));
+    
+    QTRY_COMPARE_WITH_TIMEOUT(backupCompletedSpy.count(), 1, 10000);
+    QVERIFY(backupCompletedSpy.first().at(0).toBool());
+    QVERIFY(!m_databaseService->isBackupRunning());
+    QVERIFY(progressSpy.count() > 1);
+    
+    QList<QVariant> lastProgress = progressSpy.last();
+    QCOMPARE(lastProgress.at(0).toInt(), lastProgress.at(1).toInt());
+    QVERIFY(!QFile::exists(backupPath + ".partial"));
+    
+    // The copy holds the snapshot taken when the job started
+    {
+        QSqlDatabase backupDb = QSqlDatabase::addDatabase("QSQLITE", "online_backup_check");
+        backupDb.setDatabaseName(backupPath);
+        QVERIFY(backupDb.open());
+        QSqlQuery query(backupDb);
+        QVERIFY(query.exec("SELECT COUNT(*) FROM test_table"));
+        QVERIFY(query.next());
+        QCOMPARE(query.value(0).toInt(), rowCount);
+        backupDb.close();
+    }
+    QSqlDatabase::removeDatabase("online_backup_check");
+}
+
 void TestDatabaseService::testDatabaseRestore()
 {
     QVERIFY(m_databaseService->initialize());
@@ -496,6 +759,37 @@ void TestDatabaseService::testDatabaseStats()
     QCOMPARE(stats["max_connections"].toInt(), m_databaseService->maxConnections());
 }
 
+void TestDatabaseService::testStatementCache()
+{
+    QVERIFY(m_databaseService->initialize());
+    
+    createTestTables();
+    
+    QVariantMap before = m_databaseService->getDatabaseStats();
+    int hits = before["statement_cache_hits"].toInt();
+    int misses = before["statement_cache_misses"].toInt();
+    
+    const QString insert = "INSERT INTO test_table (name, value) VALUES (?, ?)";
+    for (int i = 0; i < 10; ++i) {
+        QVERIFY(m_databaseService->executeQuery(insert, {QString("cached_%1").arg(i), i}));
+    }
+    
+    // Only the first execution prepares the statement
+    QVariantMap after = m_databaseService->getDatabaseStats();
+    QCOMPARE(after["statement_cache_misses"].toInt(), misses + 1);
+    QCOMPARE(after["statement_cache_hits"].toInt(), hits + 9);
+    
+    // Reused statements take fresh bind values every time
+    QList<QVariantMap> results = m_databaseService->executeSelect(
+        "SELECT name FROM test_table WHERE value = ?", {7});
+    QCOMPARE(results.size(), 1);
+    QCOMPARE(results[0]["name"].toString(), QString("cached_7"));
+    
+    results = m_databaseService->executeSelect("SELECT name FROM test_table WHERE value = ?", {3});
+    QCOMPARE(results.size(), 1);
+    QCOMPARE(results[0]["name"].toString(), QString("cached_3"));
+}
+
 void TestDatabaseService::testInvalidDatabasePath()
 {
     // Set invalid path
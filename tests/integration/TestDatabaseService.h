@@ -36,6 +36,7 @@ private slots:
     void testConnectionCreation();
     void testQueryExecution();
     void testSelectQueries();
+    void testForEachRow();
 
     // Transaction tests
     void testSimpleTransaction();
@@ -48,9 +49,15 @@ private slots:
     void testMaxConnectionsLimit();
     void testConnectionReuse();
     void testConnectionCleanup();
+    void testWalJournalMode();
+    void testPerThreadConnections();
+    void testProvisionDatabaseFile();
+    void testOpenNamedConnection();
+    void testPingConnection();
 
     // Backup and restore tests
     void testDatabaseBackup();
+    void testOnlineBackup();
     void testDatabaseRestore();
     void testBackupWithNonExistentSource();
     void testRestoreWithInvalidBackup();
@@ -59,6 +66,7 @@ private slots:
     void testDatabaseOptimization();
     void testIntegrityCheck();
     void testDatabaseStats();
+    void testStatementCache();
 
     // Error handling tests
     void testInvalidDatabasePath();
@@ -0,0 +1,397 @@
+#include "TestDataLayerBenchmark.h"
+#include "../../src/repositories/MusicRepository.h"
+#include "../../src/repositories/PlaylistRepository.h"
+#include "../../src/services/DatabaseService.h"
+#include "../../src/tools/genlib/SyntheticLibrary.h"
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSqlError>
+#include <QSqlQuery>
+
+namespace {
+
+QString genre(int index)
+{
+    const auto& genres = SyntheticLibrary::genres();
+    return QString::fromLatin1(genres.at(index % genres.size()).name);
+}
+
+} // namespace
+
+void TestDataLayerBenchmark::initTestCase()
+{
+    QVERIFY(m_tempDir.isValid());
+    qDebug() << "TestDataLayerBenchmark: library sizes" << librarySizes();
+
+    const QString batchDir = m_tempDir.filePath("batch");
+    QVERIFY(QDir().mkpath(batchDir));
+    for (int i = 0; i < ADD_BATCH_SIZE; ++i) {
+        const QString path = QDir(batchDir).filePath(QString("new_%1.mp3").arg(i));
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        m_batchFiles << path;
+    }
+}
+
+void TestDataLayerBenchmark::cleanupTestCase()
+{
+    for (const auto& library : std::as_const(m_libraries)) {
+        library->service->shutdown();
+        library->service.reset();
+        library->music.reset();
+        library->playlists.reset();
+        const QString connectionName = library->database.connectionName();
+        library->database.close();
+        library->database = QSqlDatabase();
+        QSqlDatabase::removeDatabase(connectionName);
+    }
+    m_libraries.clear();
+}
+
+void TestDataLayerBenchmark::benchmarkAddMusicBatch_data()
+{
+    addSizeRows();
+}
+
+void TestDataLayerBenchmark::benchmarkAddMusicBatch()
+{
+    QFETCH(int, rows);
+    Library* lib = library(rows);
+    QVERIFY(lib);
+
+    QList<MusicItem> batch;
+    batch.reserve(m_batchFiles.size());
+    for (int i = 0; i < m_batchFiles.size(); ++i) {
+        MusicItem item;
+        item.artist = SyntheticLibrary::artistName(i);
+        item.song = QString("New Song %1").arg(i);
+        item.genre1 = genre(i);
+        item.path = m_batchFiles.at(i);
+        item.time = "00:03:30";
+        batch << item;
+    }
+
+    // Each run fills the same paths, so it can only be measured once per library
+    int added = 0;
+    QBENCHMARK_ONCE {
+        added = lib->music->addMusicBatch(batch);
+    }
+    QCOMPARE(added, ADD_BATCH_SIZE);
+
+    QSqlQuery query(lib->database);
+    query.prepare("DELETE FROM musics WHERE path LIKE ?");
+    query.addBindValue(QDir(m_tempDir.filePath("batch")).absolutePath() + "%");
+    QVERIFY2(query.exec(), qPrintable(query.lastError().text()));
+}
+
+void TestDataLayerBenchmark::benchmarkSearchText_data()
+{
+    addSizeRows();
+}
+
+void TestDataLayerBenchmark::benchmarkSearchText()
+{
+    QFETCH(int, rows);
+    Library* lib = library(rows);
+    QVERIFY(lib);
+
+    MusicRepository::SearchCriteria criteria;
+    criteria.searchText = "Song 42";
+    criteria.limit = PAGE_SIZE;
+    QList<MusicItem> results;
+    QBENCHMARK {
+        results = lib->music->searchMusic(criteria);
+    }
+    QVERIFY(!results.isEmpty());
+}
+
+void TestDataLayerBenchmark::benchmarkSearchFullText_data()
+{
+    addSizeRows();
+}
+
+void TestDataLayerBenchmark::benchmarkSearchFullText()
+{
+    QFETCH(int, rows);
+    Library* lib = library(rows);
+    QVERIFY(lib);
+    if (!lib->music->isFullTextSearchAvailable()) {
+        QSKIP("SQLite was built without FTS5");
+    }
+
+    MusicRepository::SearchCriteria criteria;
+    criteria.searchText = "jazz 0004";
+    criteria.fullText = true;
+    criteria.limit = PAGE_SIZE;
+    QList<MusicItem> results;
+    QBENCHMARK {
+        results = lib->music->searchMusic(criteria);
+    }
+    QVERIFY(!results.isEmpty());
+}
+
+void TestDataLayerBenchmark::benchmarkSearchByArtist_data()
+{
+    addSizeRows();
+}
+
+void TestDataLayerBenchmark::benchmarkSearchByArtist()
+{
+    QFETCH(int, rows);
+    Library* lib = library(rows);
+    QVERIFY(lib);
+
+    MusicRepository::SearchCriteria criteria;
+    const int artist = rows / ARTIST_COUNT_DIVISOR / 2;
+    criteria.artist = SyntheticLibrary::artistName(artist);
+    criteria.genre1 = lib->synthetic->artistGenre(artist);
+    QList<MusicItem> results;
+    QBENCHMARK {
+        results = lib->music->searchMusic(criteria);
+    }
+}
+
+void TestDataLayerBenchmark::benchmarkGetMusicByGenre_data()
+{
+    addSizeRows();
+}
+
+void TestDataLayerBenchmark::benchmarkGetMusicByGenre()
+{
+    QFETCH(int, rows);
+    Library* lib = library(rows);
+    QVERIFY(lib);
+
+    QList<MusicItem> results;
+    QBENCHMARK {
+        results = lib->music->getMusicByGenre(genre(3));
+    }
+    QVERIFY(!results.isEmpty());
+}
+
+void TestDataLayerBenchmark::benchmarkGetAllMusicPage_data()
+{
+    addSizeRows();
+}
+
+void TestDataLayerBenchmark::benchmarkGetAllMusicPage()
+{
+    QFETCH(int, rows);
+    Library* lib = library(rows);
+    QVERIFY(lib);
+
+    // A page in the middle: OFFSET has to step over the rows before it
+    QList<MusicItem> results;
+    QBENCHMARK {
+        results = lib->music->getAllMusic(PAGE_SIZE, rows / 2);
+    }
+    QCOMPARE(results.size(), PAGE_SIZE);
+}
+
+void TestDataLayerBenchmark::benchmarkGetMusicAfterPage_data()
+{
+    addSizeRows();
+}
+
+void TestDataLayerBenchmark::benchmarkGetMusicAfterPage()
+{
+    QFETCH(int, rows);
+    Library* lib = library(rows);
+    QVERIFY(lib);
+
+    const QList<MusicItem> anchor = lib->music->getAllMusic(1, rows / 2 - 1);
+    QCOMPARE(anchor.size(), 1);
+    const MusicRepository::MusicSortKey key = MusicRepository::sortKeyOf(anchor.first());
+
+    QList<MusicItem> results;
+    QBENCHMARK {
+        results = lib->music->getMusicAfter(key, anchor.first().id, PAGE_SIZE);
+    }
+    QCOMPARE(results.size(), PAGE_SIZE);
+}
+
+void TestDataLayerBenchmark::benchmarkGetAllPlaylistsPage_data()
+{
+    addSizeRows();
+}
+
+void TestDataLayerBenchmark::benchmarkGetAllPlaylistsPage()
+{
+    QFETCH(int, rows);
+    Library* lib = library(rows);
+    QVERIFY(lib);
+
+    QList<PlaylistItem> results;
+    QBENCHMARK {
+        results = lib->playlists->getAllPlaylists(PAGE_SIZE, rows / PLAYLIST_RATIO / 2);
+    }
+    QCOMPARE(results.size(), PAGE_SIZE);
+}
+
+void TestDataLayerBenchmark::benchmarkSearchPlaylists_data()
+{
+    addSizeRows();
+}
+
+void TestDataLayerBenchmark::benchmarkSearchPlaylists()
+{
+    QFETCH(int, rows);
+    Library* lib = library(rows);
+    QVERIFY(lib);
+
+    PlaylistRepository::SearchCriteria criteria;
+    criteria.name = "Show 42";
+    criteria.limit = PAGE_SIZE;
+    QList<PlaylistItem> results;
+    QBENCHMARK {
+        results = lib->playlists->searchPlaylists(criteria);
+    }
+    QVERIFY(!results.isEmpty());
+}
+
+void TestDataLayerBenchmark::benchmarkExecuteSelect_data()
+{
+    addSizeRows();
+}
+
+void TestDataLayerBenchmark::benchmarkExecuteSelect()
+{
+    QFETCH(int, rows);
+    Library* lib = library(rows);
+    QVERIFY(lib);
+
+    const QString queryString = "SELECT id, artist, song, genre1, time FROM musics "
+                                "WHERE genre1 = ? ORDER BY artist, song LIMIT ?";
+    const QVariantList bindValues = {genre(5), PAGE_SIZE};
+    QList<QVariantMap> results;
+    QBENCHMARK {
+        results = lib->service->executeSelect(queryString, bindValues);
+    }
+    QCOMPARE(results.size(), PAGE_SIZE);
+}
+
+void TestDataLayerBenchmark::addSizeRows()
+{
+    QTest::addColumn<int>("rows");
+    for (int rows : librarySizes()) {
+        QTest::newRow(qPrintable(QString::number(rows))) << rows;
+    }
+}
+
+TestDataLayerBenchmark::Library* TestDataLayerBenchmark::library(int rows)
+{
+    const auto existing = m_libraries.constFind(rows);
+    if (existing != m_libraries.constEnd()) {
+        return existing.value().get();
+    }
+
+    auto lib = std::make_shared<Library>();
+    lib->path = m_tempDir.filePath(QString("library_%1.db").arg(rows));
+    lib->database = QSqlDatabase::addDatabase("QSQLITE", QString("benchmark_%1").arg(rows));
+    lib->database.setDatabaseName(lib->path);
+    if (!lib->database.open()) {
+        qWarning() << "TestDataLayerBenchmark: cannot open" << lib->path
+                   << lib->database.lastError().text();
+        return nullptr;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    SyntheticLibrary::Options options;
+    options.tracks = rows;
+    options.artists = qMax(1, rows / ARTIST_COUNT_DIVISOR);
+    options.audio = SyntheticLibrary::Audio::None;
+    options.seed = quint32(rows);   // same library for every run, so results compare across builds
+    lib->synthetic = std::make_unique<SyntheticLibrary>(options);
+    if (!generateLibrary(lib->database, *lib->synthetic)) {
+        return nullptr;
+    }
+    qDebug() << "TestDataLayerBenchmark: generated" << rows << "tracks in" << timer.elapsed()
+             << "ms";
+
+    lib->music = std::make_unique<MusicRepository>(lib->database);
+    lib->playlists = std::make_unique<PlaylistRepository>(lib->database);
+    lib->service = std::make_unique<DatabaseService>();
+    lib->service->setDatabasePath(lib->path);
+    if (!lib->service->initialize()) {
+        qWarning() << "TestDataLayerBenchmark: DatabaseService did not start on" << lib->path;
+        return nullptr;
+    }
+
+    m_libraries.insert(rows, lib);
+    return lib.get();
+}
+
+bool TestDataLayerBenchmark::generateLibrary(QSqlDatabase& database,
+                                             const SyntheticLibrary& synthetic)
+{
+    QSqlQuery query(database);
+    const QStringList schema = {
+        R"(CREATE TABLE musics (
+            "id" INTEGER PRIMARY KEY AUTOINCREMENT,
+            "artist" VARCHAR(50) NOT NULL,
+            "song" VARCHAR(25) NOT NULL,
+            "genre1" VARCHAR(25) NOT NULL,
+            "genre2" VARCHAR(25),
+            "country" VARCHAR(25),
+            "published_date" VARCHAR(25),
+            "path" TEXT,
+            "time" TEXT,
+            "played_times" INTEGER DEFAULT 0,
+            "last_played" TEXT
+        ))",
+        R"(CREATE TABLE programs (
+            "id" INTEGER PRIMARY KEY AUTOINCREMENT,
+            "name" TEXT,
+            "path" TEXT
+        ))"};
+    for (const QString& statement : schema) {
+        if (!query.exec(statement)) {
+            qWarning() << "TestDataLayerBenchmark: schema -" << query.lastError().text();
+            return false;
+        }
+    }
+
+    QString error;
+    if (!synthetic.writeMusic(database, &error)) {
+        qWarning() << "TestDataLayerBenchmark: musics -" << error;
+        return false;
+    }
+
+    const int rows = synthetic.trackCount();
+    if (!database.transaction()) {
+        return false;
+    }
+    query.prepare("INSERT INTO programs (name, path) VALUES (?, ?)");
+    for (int i = 0; i < qMax(PAGE_SIZE, rows / PLAYLIST_RATIO); ++i) {
+        query.addBindValue(QString("Show %1").arg(i));
+        query.addBindValue(QString("/playlists/show_%1.xml").arg(i));
+        if (!query.exec()) {
+            qWarning() << "TestDataLayerBenchmark: programs -" << query.lastError().text();
+            database.rollback();
+            return false;
+        }
+    }
+    return database.commit();
+}
+
+QList<int> TestDataLayerBenchmark::librarySizes()
+{
+    QList<int> sizes;
+    const QString configured = qEnvironmentVariable("XFB_BENCH_ROWS");
+    for (const QString& value : configured.split(',', Qt::SkipEmptyParts)) {
+        bool ok = false;
+        const int rows = value.trimmed().toInt(&ok);
+        if (ok && rows >= PAGE_SIZE) {
+            sizes << rows;
+        }
+    }
+    if (sizes.isEmpty()) {
+        sizes = {DEFAULT_SMALL_SIZE, DEFAULT_LARGE_SIZE};
+    }
+    return sizes;
+}
+
+QTEST_MAIN(TestDataLayerBenchmark)
@@ -0,0 +1,107 @@
+#ifndef TESTDATALAYERBENCHMARK_H
+#define TESTDATALAYERBENCHMARK_H
+
+#include <QObject>
+#include <QList>
+#include <QMap>
+#include <QSqlDatabase>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <QTest>
+#include <memory>
+
+class DatabaseService;
+class MusicRepository;
+class PlaylistRepository;
+class SyntheticLibrary;
+
+/**
+ * @brief Benchmarks of the data layer against synthetic libraries
+ *
+ * Every benchmark runs once per library size, 10k and 100k tracks by
+ * default. XFB_BENCH_ROWS takes a comma separated list of sizes instead,
+ * e.g. "10000,100000,1000000"; the run_data_layer_benchmarks target uses
+ * all three. A SyntheticLibrary is generated once per size and shared by
+ * all benchmarks; it holds one playlist for every PLAYLIST_RATIO tracks.
+ *
+ * Covered:
+ * - MusicRepository::addMusicBatch of ADD_BATCH_SIZE new tracks
+ * - MusicRepository::searchMusic, by text, by full-text index and by field
+ * - MusicRepository::getMusicByGenre
+ * - MusicRepository::getAllMusic and getMusicAfter pages deep in the library
+ * - PlaylistRepository::getAllPlaylists and searchPlaylists
+ * - DatabaseService::executeSelect
+ *
+ * The results are QBENCHMARK results, so QtTest writes them in any of its
+ * formats, e.g. "-o results.xml,xml" or "-o results.csv,csv".
+ *
+ * @since XFB 2.0
+ */
+class TestDataLayerBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void benchmarkAddMusicBatch_data();
+    void benchmarkAddMusicBatch();
+    void benchmarkSearchText_data();
+    void benchmarkSearchText();
+    void benchmarkSearchFullText_data();
+    void benchmarkSearchFullText();
+    void benchmarkSearchByArtist_data();
+    void benchmarkSearchByArtist();
+    void benchmarkGetMusicByGenre_data();
+    void benchmarkGetMusicByGenre();
+    void benchmarkGetAllMusicPage_data();
+    void benchmarkGetAllMusicPage();
+    void benchmarkGetMusicAfterPage_data();
+    void benchmarkGetMusicAfterPage();
+    void benchmarkGetAllPlaylistsPage_data();
+    void benchmarkGetAllPlaylistsPage();
+    void benchmarkSearchPlaylists_data();
+    void benchmarkSearchPlaylists();
+    void benchmarkExecuteSelect_data();
+    void benchmarkExecuteSelect();
+
+private:
+    struct Library {
+        QString path;
+        QSqlDatabase database;
+        std::unique_ptr<MusicRepository> music;
+        std::unique_ptr<PlaylistRepository> playlists;
+        std::unique_ptr<DatabaseService> service;
+        std::unique_ptr<SyntheticLibrary> synthetic;
+    };
+
+    /**
+     * @brief Add a "rows" column with one row per library size
+     */
+    void addSizeRows();
+
+    /**
+     * @brief Get the library of a size, generating it on first use
+     * @param rows Number of tracks
+     * @return Library, or nullptr if it could not be made
+     */
+    Library* library(int rows);
+
+    bool generateLibrary(QSqlDatabase& database, const SyntheticLibrary& synthetic);
+
+    static QList<int> librarySizes();
+
+    QTemporaryDir m_tempDir;
+    QMap<int, std::shared_ptr<Library>> m_libraries;
+    QStringList m_batchFiles;   ///< Real files for addMusicBatch, which checks they exist
+
+    static constexpr int DEFAULT_SMALL_SIZE = 10000;
+    static constexpr int DEFAULT_LARGE_SIZE = 100000;
+    static constexpr int ADD_BATCH_SIZE = 1000;
+    static constexpr int PAGE_SIZE = 100;
+    static constexpr int PLAYLIST_RATIO = 10;
+    static constexpr int ARTIST_COUNT_DIVISOR = 20;   ///< Tracks per artist
+};
+
+#endif // TESTDATALAYERBENCHMARK_H
@@ -0,0 +1,278 @@
+#include "TestMusicCacheBenchmark.h"
+#include "../../src/repositories/MusicRepository.h"
+#include "../../src/services/MetricsRegistry.h"
+#include "../../src/services/MusicCache.h"
+#include <QDebug>
+#include <QRandomGenerator>
+#include <QThread>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using Histogram = MetricsRegistry::Histogram;
+
+// Track IDs in order of popularity; rank 0 is drawn most often
+class ZipfKeys
+{
+public:
+    ZipfKeys(int keyCount, double exponent)
+        : m_cdf(size_t(keyCount))
+        , m_ids(size_t(keyCount))
+    {
+        double total = 0.0;
+        for (int rank = 0; rank < keyCount; ++rank) {
+            total += 1.0 / std::pow(double(rank + 1), exponent);
+            m_cdf[size_t(rank)] = total;
+        }
+        for (double& value : m_cdf) {
+            value /= total;
+        }
+        // Popular tracks are spread over the ID range, not the first IDs
+        std::iota(m_ids.begin(), m_ids.end(), 1);
+        QRandomGenerator shuffle(quint32(keyCount));
+        std::shuffle(m_ids.begin(), m_ids.end(), shuffle);
+    }
+
+    int next(QRandomGenerator& random) const
+    {
+        const auto rank = std::upper_bound(m_cdf.begin(), m_cdf.end(), random.generateDouble());
+        return m_ids[std::min(size_t(rank - m_cdf.begin()), m_ids.size() - 1)];
+    }
+
+    const std::vector<int>& ids() const { return m_ids; }
+
+private:
+    std::vector<double> m_cdf;
+    std::vector<int> m_ids;
+};
+
+// Per thread latency counts, in the buckets of MetricsRegistry::Histogram,
+// so that threads do not share counters while they are measured
+struct Latencies {
+    std::array<qint64, Histogram::BUCKET_COUNT> buckets{};
+    qint64 count = 0;
+
+    void record(qint64 ns)
+    {
+        ++buckets[size_t(Histogram::bucketFor(ns))];
+        ++count;
+    }
+
+    void merge(const Latencies& other)
+    {
+        for (size_t i = 0; i < buckets.size(); ++i) {
+            buckets[i] += other.buckets[i];
+        }
+        count += other.count;
+    }
+
+    qint64 percentile(double percent) const
+    {
+        if (count == 0) {
+            return 0;
+        }
+        const qint64 rank = qMax<qint64>(1, qint64(std::ceil(count * percent / 100.0)));
+        qint64 seen = 0;
+        for (size_t i = 0; i < buckets.size(); ++i) {
+            seen += buckets[i];
+            if (seen >= rank) {
+                return Histogram::bucketUpperBound(int(i));
+            }
+        }
+        return Histogram::bucketUpperBound(Histogram::BUCKET_COUNT - 1);
+    }
+};
+
+struct WorkerResult {
+    Latencies reads;
+    Latencies writes;
+    qint64 hits = 0;
+    qint64 misses = 0;
+};
+
+MusicItem makeTrack(int id, int version = 0)
+{
+    MusicItem music;
+    music.id = id;
+    music.artist = QString("Artist %1").arg(id % 997);
+    music.song = QString("Song %1").arg(id);
+    music.genre1 = "Rock";
+    music.genre2 = "Pop";
+    music.country = "Portugal";
+    music.publishedDate = "1999";
+    music.path = QString("/library/rock/artist_%1/song_%2.mp3").arg(id % 997).arg(id);
+    music.time = "00:03:45";
+    music.playedTimes = version;
+    return music;
+}
+
+int environmentInt(const char* name, int fallback)
+{
+    bool ok = false;
+    const int value = qEnvironmentVariableIntValue(name, &ok);
+    return ok ? value : fallback;
+}
+
+qint64 elapsedNs(Clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+}
+
+} // namespace
+
+void TestMusicCacheBenchmark::benchmarkContention_data()
+{
+    QTest::addColumn<int>("readers");
+    QTest::addColumn<int>("writers");
+    QTest::addColumn<int>("keys");
+    QTest::addColumn<double>("zipf");
+    QTest::addColumn<int>("memoryKb");
+
+    // Limits of 0 hold the whole key set
+    QTest::newRow("single reader") << 1 << 0 << DEFAULT_KEYS << DEFAULT_ZIPF << 0;
+    QTest::newRow("read heavy") << 8 << 1 << DEFAULT_KEYS << DEFAULT_ZIPF << 0;
+    QTest::newRow("read heavy uniform") << 8 << 1 << DEFAULT_KEYS << 0.0 << 0;
+    QTest::newRow("mixed") << 4 << 4 << DEFAULT_KEYS << DEFAULT_ZIPF << 0;
+    QTest::newRow("write heavy") << 1 << 8 << DEFAULT_KEYS << DEFAULT_ZIPF << 0;
+    QTest::newRow("memory pressure") << 8 << 2 << DEFAULT_KEYS << DEFAULT_ZIPF << 2048;
+
+    const std::array<const char*, 5> custom = {"XFB_BENCH_READERS", "XFB_BENCH_WRITERS",
+                                               "XFB_BENCH_KEYS", "XFB_BENCH_ZIPF",
+                                               "XFB_BENCH_MEMORY_KB"};
+    if (std::any_of(custom.begin(), custom.end(),
+                    [](const char* name) { return qEnvironmentVariableIsSet(name); })) {
+        bool ok = false;
+        double zipf = qEnvironmentVariable("XFB_BENCH_ZIPF").toDouble(&ok);
+        QTest::newRow("custom") << environmentInt("XFB_BENCH_READERS", 8)
+                                << environmentInt("XFB_BENCH_WRITERS", 1)
+                                << environmentInt("XFB_BENCH_KEYS", DEFAULT_KEYS)
+                                << (ok ? zipf : DEFAULT_ZIPF)
+                                << environmentInt("XFB_BENCH_MEMORY_KB", 0);
+    }
+}
+
+void TestMusicCacheBenchmark::benchmarkContention()
+{
+    QFETCH(int, readers);
+    QFETCH(int, writers);
+    QFETCH(int, keys);
+    QFETCH(double, zipf);
+    QFETCH(int, memoryKb);
+    QVERIFY(readers + writers > 0);
+    QVERIFY(keys > 0);
+
+    const int seconds = qMax(1, environmentInt("XFB_BENCH_SECONDS", DEFAULT_SECONDS));
+    const ZipfKeys distribution(keys, zipf);
+
+    MusicCache cache;
+    cache.setMaxMemoryUsage(memoryKb > 0 ? qint64(memoryKb) * 1024 : qint64(1024) * 1024 * 1024);
+    cache.setDefaultExpirationTime(24 * 60 * 60);
+    QVERIFY(cache.initialize());
+    for (int id : distribution.ids()) {
+        cache.put(id, makeTrack(id));
+    }
+    const MusicCache::CacheStatistics before = cache.getStatistics();
+
+    const int threadCount = readers + writers;
+    std::vector<WorkerResult> results(size_t(threadCount));
+    std::atomic<int> ready{0};
+    std::atomic<bool> go{false};
+    std::atomic<bool> stop{false};
+
+    std::vector<std::unique_ptr<QThread>> threads;
+    for (int t = 0; t < threadCount; ++t) {
+        const bool writer = t >= readers;
+        threads.emplace_back(QThread::create([&, writer, t]() {
+            WorkerResult& result = results[size_t(t)];
+            QRandomGenerator random(quint32(1000 + t));
+            ready.fetch_add(1);
+            while (!go.load(std::memory_order_acquire)) {
+                QThread::yieldCurrentThread();
+            }
+            int version = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                const int id = distribution.next(random);
+                // Tracks are built outside the timed part; only the cache calls count
+                if (!writer) {
+                    Clock::time_point start = Clock::now();
+                    if (cache.get(id)) {
+                        ++result.hits;
+                        result.reads.record(elapsedNs(start));
+                        continue;
+                    }
+                    qint64 ns = elapsedNs(start);
+                    const MusicItem track = makeTrack(id);
+                    start = Clock::now();
+                    cache.put(id, track);
+                    result.reads.record(ns + elapsedNs(start));
+                    ++result.misses;
+                } else if (++version % WRITER_REMOVE_EVERY == 0) {
+                    const Clock::time_point start = Clock::now();
+                    cache.remove(id);
+                    result.writes.record(elapsedNs(start));
+                } else {
+                    const MusicItem track = makeTrack(id, version);
+                    const Clock::time_point start = Clock::now();
+                    cache.put(id, track);
+                    result.writes.record(elapsedNs(start));
+                }
+            }
+        }));
+        threads.back()->start();
+    }
+
+    while (ready.load() < threadCount) {
+        QThread::msleep(1);
+    }
+    const Clock::time_point started = Clock::now();
+    go.store(true, std::memory_order_release);
+    QThread::sleep(seconds);
+    stop.store(true);
+    for (const auto& thread : threads) {
+        thread->wait();
+    }
+    const double elapsedSeconds = elapsedNs(started) / 1e9;
+    const MusicCache::CacheStatistics after = cache.getStatistics();
+    cache.shutdown();
+
+    WorkerResult total;
+    for (const WorkerResult& result : results) {
+        total.reads.merge(result.reads);
+        total.writes.merge(result.writes);
+        total.hits += result.hits;
+        total.misses += result.misses;
+    }
+    const qint64 operations = total.reads.count + total.writes.count;
+    const double hitRatio =
+        total.reads.count > 0 ? double(total.hits) / double(total.reads.count) : 0.0;
+    QVERIFY(operations > 0);
+
+    qInfo().noquote()
+        << QString("RESULT scenario=\"%1\" readers=%2 writers=%3 keys=%4 zipf=%5 memory_kb=%6 "
+                   "ops_per_sec=%7 read_p50_ns=%8 read_p99_ns=%9 write_p50_ns=%10 "
+                   "write_p99_ns=%11 hit_ratio=%12 evictions=%13 memory_bytes=%14")
+               .arg(QString::fromUtf8(QTest::currentDataTag()))
+               .arg(readers)
+               .arg(writers)
+               .arg(keys)
+               .arg(zipf)
+               .arg(memoryKb)
+               .arg(qint64(operations / elapsedSeconds))
+               .arg(total.reads.percentile(50))
+               .arg(total.reads.percentile(99))
+               .arg(total.writes.percentile(50))
+               .arg(total.writes.percentile(99))
+               .arg(hitRatio, 0, 'f', 4)
+               .arg(after.totalEvictions - before.totalEvictions)
+               .arg(after.currentMemoryUsage);
+}
+
+QTEST_MAIN(TestMusicCacheBenchmark)
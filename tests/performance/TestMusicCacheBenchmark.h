@@ -0,0 +1,49 @@
+#ifndef TESTMUSICCACHEBENCHMARK_H
+#define TESTMUSICCACHEBENCHMARK_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Throughput of MusicCache with many threads reading and writing
+ *
+ * Each scenario prefills the cache and then runs reader and writer
+ * threads against it for a fixed time:
+ * - readers get() a track and put() it back on a miss, as a read-through
+ *   lookup in front of the database would;
+ * - writers put() updated tracks and now and then remove() one.
+ *
+ * Keys follow a zipfian distribution, a few tracks in heavy rotation and
+ * a long tail, unless the scenario asks for a uniform one. The memory
+ * limit of some scenarios is below the size of the key set, so evictions
+ * run alongside the lookups.
+ *
+ * For every scenario one line is logged with ops/sec, p50 and p99 latency
+ * of reads and writes, the hit ratio and the evictions. The line starts
+ * with "RESULT" and is made of key=value pairs, for scripts to collect.
+ *
+ * A custom scenario is added when any of these are set:
+ * - XFB_BENCH_READERS, XFB_BENCH_WRITERS: thread counts
+ * - XFB_BENCH_KEYS: number of distinct tracks
+ * - XFB_BENCH_ZIPF: zipf exponent, 0 for uniform
+ * - XFB_BENCH_MEMORY_KB: memory limit of the cache
+ * XFB_BENCH_SECONDS sets how long every scenario runs.
+ *
+ * @since XFB 2.0
+ */
+class TestMusicCacheBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void benchmarkContention_data();
+    void benchmarkContention();
+
+private:
+    static constexpr int DEFAULT_SECONDS = 2;
+    static constexpr int DEFAULT_KEYS = 50000;
+    static constexpr double DEFAULT_ZIPF = 0.99;
+    static constexpr int WRITER_REMOVE_EVERY = 16;   ///< Every nth write is a remove
+};
+
+#endif // TESTMUSICCACHEBENCHMARK_H
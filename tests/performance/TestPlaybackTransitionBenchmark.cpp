@@ -0,0 +1,293 @@
+#include "TestPlaybackTransitionBenchmark.h"
+#include "../../src/services/PlaybackEngine.h"
+#include "../../src/services/SchedulerEngine.h"
+#include <QDataStream>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QTimer>
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <vector>
+
+namespace {
+
+const char* SCHEDULER_CONNECTION = "playback_transition_benchmark_scheduler";
+
+constexpr float SILENCE = 1e-4f;
+constexpr int GAP_MIN_FRAMES = 4;   ///< A tone never stays this long below SILENCE
+
+// 16-bit stereo PCM of a sine at half scale; starts and ends at a zero crossing
+bool writeTone(const QString& filePath, int durationMs, int sampleRate, double frequency)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    const quint32 frames = quint32(qint64(sampleRate) * durationMs / 1000);
+    const quint32 dataBytes = frames * 2 * 2;
+
+    QDataStream out(&file);
+    out.setByteOrder(QDataStream::LittleEndian);
+    out.writeRawData("RIFF", 4);
+    out << quint32(36 + dataBytes);
+    out.writeRawData("WAVEfmt ", 8);
+    out << quint32(16) << quint16(1) << quint16(2) << quint32(sampleRate)
+        << quint32(sampleRate * 4) << quint16(4) << quint16(16);
+    out.writeRawData("data", 4);
+    out << dataBytes;
+    for (quint32 i = 0; i < frames; ++i) {
+        const double phase = 2.0 * M_PI * frequency * i / sampleRate;
+        const qint16 value = qint16(std::lround(std::sin(phase) * 16383.0));
+        out << value << value;
+    }
+    return out.status() == QDataStream::Ok;
+}
+
+// Finds runs of silence between the first and the last sound of the output
+struct GapMeter {
+    qint64 frames = 0;          ///< Frames seen since the first sound
+    qint64 silentRun = 0;
+    bool started = false;
+    std::vector<qint64> gaps;   ///< Lengths in frames
+
+    void feed(const float* samples, int count)
+    {
+        for (int i = 0; i + 1 < count; i += 2) {
+            const bool silent =
+                std::fabs(samples[i]) < SILENCE && std::fabs(samples[i + 1]) < SILENCE;
+            if (!started) {
+                started = !silent;
+                if (!started) {
+                    continue;
+                }
+            }
+            ++frames;
+            if (silent) {
+                ++silentRun;
+                continue;
+            }
+            if (silentRun >= GAP_MIN_FRAMES) {
+                gaps.push_back(silentRun);
+            }
+            silentRun = 0;
+        }
+    }
+};
+
+int environmentInt(const char* name, int fallback)
+{
+    bool ok = false;
+    const int value = qEnvironmentVariableIntValue(name, &ok);
+    return ok ? value : fallback;
+}
+
+double environmentDouble(const char* name, double fallback)
+{
+    bool ok = false;
+    const double value = qEnvironmentVariable(name).toDouble(&ok);
+    return ok && value > 0 ? value : fallback;
+}
+
+double cpuSeconds()
+{
+    return double(std::clock()) / CLOCKS_PER_SEC;
+}
+
+template<typename T>
+T percentileOf(std::vector<T> values, double percent)
+{
+    if (values.empty()) {
+        return T();
+    }
+    std::sort(values.begin(), values.end());
+    const size_t rank = size_t(std::ceil(values.size() * percent / 100.0));
+    return values[std::clamp<size_t>(rank, 1, values.size()) - 1];
+}
+
+} // namespace
+
+void TestPlaybackTransitionBenchmark::initTestCase()
+{
+    QVERIFY(m_tempDir.isValid());
+    for (int i = 0; i < TRACK_COUNT; ++i) {
+        const QString path = m_tempDir.filePath(QString("tone_%1.wav").arg(i));
+        QVERIFY(writeTone(path, TRACK_MS, SAMPLE_RATE, 220.0 + 55.0 * i));
+        m_tracks << path;
+    }
+}
+
+void TestPlaybackTransitionBenchmark::benchmarkTransitions_data()
+{
+    QTest::addColumn<int>("crossfadeMs");
+
+    QTest::newRow("splice") << 0;
+    QTest::newRow("crossfade") << 1000;
+}
+
+void TestPlaybackTransitionBenchmark::benchmarkTransitions()
+{
+    QFETCH(int, crossfadeMs);
+    const int transitions = qMax(1, environmentInt("XFB_BENCH_TRANSITIONS", DEFAULT_TRANSITIONS));
+    const double speed = environmentDouble("XFB_BENCH_SPEED", DEFAULT_SPEED);
+
+    PlaybackEngine engine(speed);
+    engine.setCrossfadeDuration(crossfadeMs);
+    engine.setTapEnabled(true, DeckMixer::Tap::Stream);
+
+    int queued = 0;
+    int started = 0;
+    bool finished = false;
+    QStringList errors;
+    connect(&engine, &PlaybackEngine::nextTrackRequested, this, [&]() {
+        if (queued < transitions) {
+            ++queued;
+            engine.queueNext(m_tracks.at(queued % m_tracks.size()));
+        }
+    });
+    connect(&engine, &PlaybackEngine::trackStarted, this, [&]() { ++started; });
+    connect(&engine, &PlaybackEngine::playbackFinished, this, [&]() { finished = true; });
+    connect(&engine, &PlaybackEngine::errorOccurred, this,
+            [&](const QString& message) { errors << message; });
+
+    GapMeter meter;
+    std::vector<float> buffer(size_t(SAMPLE_RATE) * 2);
+    QTimer drain;
+    drain.setTimerType(Qt::PreciseTimer);
+    connect(&drain, &QTimer::timeout, this, [&]() {
+        int read = 0;
+        while ((read = engine.readTap(buffer.data(), int(buffer.size()))) > 0) {
+            meter.feed(buffer.data(), read);
+        }
+    });
+    drain.start(DRAIN_INTERVAL_MS);
+
+    const double cpuStart = cpuSeconds();
+    QElapsedTimer wall;
+    wall.start();
+    engine.play(m_tracks.first());
+
+    const int expectedMs = int((transitions + 1) * qint64(TRACK_MS) / speed);
+    QTRY_VERIFY_WITH_TIMEOUT(finished, 3 * expectedMs + 10000);
+    const double cpu = cpuSeconds() - cpuStart;
+    const double wallSeconds = wall.elapsed() / 1000.0;
+    drain.stop();
+
+    QVERIFY2(errors.isEmpty(), qPrintable(errors.join("; ")));
+    QCOMPARE(started, transitions + 1);
+
+    const int rate = engine.sampleRate();
+    QVERIFY(rate > 0);
+    qint64 gapFrames = 0;
+    for (qint64 gap : meter.gaps) {
+        gapFrames += gap;
+    }
+    const double audioSeconds = double(meter.frames) / rate;
+    const double toMs = 1000.0 / rate;
+
+    qInfo().noquote()
+        << QString("RESULT scenario=\"transitions %1\" crossfade_ms=%2 transitions=%3 speed=%4 "
+                   "gaps=%5 gap_total_ms=%6 gap_p99_ms=%7 gap_max_ms=%8 audio_s=%9 wall_s=%10 "
+                   "cpu_s_per_audio_hour=%11")
+               .arg(QString::fromUtf8(QTest::currentDataTag()))
+               .arg(crossfadeMs)
+               .arg(started - 1)
+               .arg(speed)
+               .arg(meter.gaps.size())
+               .arg(gapFrames * toMs, 0, 'f', 3)
+               .arg(percentileOf(meter.gaps, 99) * toMs, 0, 'f', 3)
+               .arg(percentileOf(meter.gaps, 100) * toMs, 0, 'f', 3)
+               .arg(audioSeconds, 0, 'f', 1)
+               .arg(wallSeconds, 0, 'f', 2)
+               .arg(audioSeconds > 0 ? cpu / audioSeconds * 3600.0 : 0.0, 0, 'f', 1);
+}
+
+void TestPlaybackTransitionBenchmark::benchmarkSchedulerJitter()
+{
+    const int events = environmentInt("XFB_BENCH_SCHEDULER_EVENTS", DEFAULT_SCHEDULER_EVENTS);
+    if (events <= 0) {
+        QSKIP("XFB_BENCH_SCHEDULER_EVENTS is 0");
+    }
+
+    {
+        QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", SCHEDULER_CONNECTION);
+        database.setDatabaseName(m_tempDir.filePath("scheduler.db"));
+        QVERIFY(database.open());
+
+        QSqlQuery query(database);
+        QVERIFY(query.exec("CREATE TABLE pub (id INTEGER PRIMARY KEY AUTOINCREMENT, name TEXT, "
+                           "path TEXT)"));
+        QVERIFY(query.exec("CREATE TABLE programs (id INTEGER PRIMARY KEY AUTOINCREMENT, "
+                           "name TEXT, path TEXT)"));
+        QVERIFY(query.exec("CREATE TABLE scheduler (id INTEGER, ano INTEGER, mes INTEGER, "
+                           "dia INTEGER, hora INTEGER, min INTEGER, tipo INTEGER, week_day TEXT, "
+                           "start_ano INTEGER, start_mes INTEGER, start_dia INTEGER, "
+                           "end_ano INTEGER, end_mes INTEGER, end_dia INTEGER, is_program NULL)"));
+        query.prepare("INSERT INTO programs (id, name, path) VALUES (1, 'Show', ?)");
+        query.addBindValue(m_tracks.first());
+        QVERIFY(query.exec());
+
+        // One programme at the start of each of the next minutes
+        const QDateTime now = QDateTime::currentDateTime();
+        const QDateTime first =
+            QDateTime(now.date(), QTime(now.time().hour(), now.time().minute())).addSecs(60);
+        query.prepare("INSERT INTO scheduler (id, ano, mes, dia, hora, min, tipo, is_program) "
+                      "VALUES (1, ?, ?, ?, ?, ?, 1, '1')");
+        for (int i = 0; i < events; ++i) {
+            const QDateTime at = first.addSecs(60 * i);
+            query.addBindValue(at.date().year());
+            query.addBindValue(at.date().month());
+            query.addBindValue(at.date().day());
+            query.addBindValue(at.time().hour());
+            query.addBindValue(at.time().minute());
+            QVERIFY2(query.exec(), qPrintable(query.lastError().text()));
+        }
+
+        SchedulerEngine scheduler(database);
+        std::vector<qint64> lateness;
+        connect(&scheduler, &SchedulerEngine::eventDue, this, [&](const ScheduledEvent& event) {
+            lateness.push_back(QDateTime::currentMSecsSinceEpoch()
+                               - event.fireAt.toMSecsSinceEpoch());
+        });
+
+        // Real time playback meanwhile, as on air
+        PlaybackEngine engine(1.0);
+        int next = 0;
+        connect(&engine, &PlaybackEngine::nextTrackRequested, this,
+                [&]() { engine.queueNext(m_tracks.at(++next % m_tracks.size())); });
+
+        const double cpuStart = cpuSeconds();
+        QElapsedTimer wall;
+        wall.start();
+        QVERIFY(scheduler.start());
+        engine.play(m_tracks.first());
+
+        QTRY_VERIFY_WITH_TIMEOUT(int(lateness.size()) >= events, (events + 1) * 60 * 1000);
+        const double cpu = cpuSeconds() - cpuStart;
+        const double wallSeconds = wall.elapsed() / 1000.0;
+        engine.stop();
+        scheduler.stop();
+
+        qint64 total = 0;
+        for (qint64 late : lateness) {
+            total += late;
+        }
+        qInfo().noquote()
+            << QString("RESULT scenario=\"scheduler\" events=%1 late_mean_ms=%2 late_p50_ms=%3 "
+                       "late_max_ms=%4 wall_s=%5 cpu_s_per_playback_hour=%6")
+                   .arg(lateness.size())
+                   .arg(double(total) / lateness.size(), 0, 'f', 1)
+                   .arg(percentileOf(lateness, 50))
+                   .arg(percentileOf(lateness, 100))
+                   .arg(wallSeconds, 0, 'f', 1)
+                   .arg(cpu / wallSeconds * 3600.0, 0, 'f', 1);
+        database.close();
+    }
+    QSqlDatabase::removeDatabase(SCHEDULER_CONNECTION);
+}
+
+QTEST_MAIN(TestPlaybackTransitionBenchmark)
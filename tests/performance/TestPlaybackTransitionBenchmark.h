@@ -0,0 +1,59 @@
+#ifndef TESTPLAYBACKTRANSITIONBENCHMARK_H
+#define TESTPLAYBACKTRANSITIONBENCHMARK_H
+
+#include <QObject>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <QTest>
+
+/**
+ * @brief Song transitions and scheduler timing of a headless player
+ *
+ * benchmarkTransitions plays short tone files back to back through a
+ * headless PlaybackEngine, queueing the next one whenever the engine asks,
+ * and reads the output from the stream tap. Any run of silence between
+ * the first and the last sample is a gap between the end of one track and
+ * the first sample of the next; with the gapless engine there should be
+ * none. It also reports the CPU time the process spent per hour of audio.
+ *
+ * benchmarkSchedulerJitter puts one programme on each of the next few
+ * minutes, plays to a headless engine in real time meanwhile, and reports
+ * how late SchedulerEngine fired against the wall clock, and the CPU time
+ * per hour of real time playback.
+ *
+ * Every row logs one line starting with "RESULT", made of key=value pairs,
+ * for scripts that track the numbers from release to release.
+ *
+ * Environment:
+ * - XFB_BENCH_TRANSITIONS: transitions per row, default DEFAULT_TRANSITIONS
+ * - XFB_BENCH_SPEED: times faster than real time, default DEFAULT_SPEED
+ * - XFB_BENCH_SCHEDULER_EVENTS: programmes to wait for, default
+ *   DEFAULT_SCHEDULER_EVENTS; each one is a minute of wall time
+ *
+ * @since XFB 2.0
+ */
+class TestPlaybackTransitionBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void benchmarkTransitions_data();
+    void benchmarkTransitions();
+    void benchmarkSchedulerJitter();
+
+private:
+    QTemporaryDir m_tempDir;
+    QStringList m_tracks;
+
+    static constexpr int TRACK_COUNT = 8;
+    static constexpr int TRACK_MS = 2000;
+    static constexpr int SAMPLE_RATE = 44100;
+    static constexpr int DEFAULT_TRANSITIONS = 200;
+    static constexpr double DEFAULT_SPEED = 40.0;
+    static constexpr int DEFAULT_SCHEDULER_EVENTS = 2;
+    static constexpr int DRAIN_INTERVAL_MS = 5;
+};
+
+#endif // TESTPLAYBACKTRANSITIONBENCHMARK_H
@@ -0,0 +1,244 @@
+#include "TestBatchImportProcessor.h"
+#include "../../../src/dialogs/EnhancedAddDirectoryDialog.h"
+#include "../../../src/repositories/MusicRepository.h"
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QSqlQuery>
+
+namespace {
+
+const char* CONNECTION_NAME = "test_batch_import_processor_connection";
+
+/// Options that take the test files as they are; they hold no real audio
+EnhancedAddDirectoryDialog::ImportOptions testOptions(int batchSize)
+{
+    EnhancedAddDirectoryDialog::ImportOptions options;
+    options.extractMetadata = false;
+    options.validateFiles = false;
+    options.batchSize = batchSize;
+    return options;
+}
+
+/// What the processor reported, collected without QSignalSpy's metatype needs
+struct Outcome {
+    QList<int> batchSizes;
+    QStringList written;
+    QHash<QString, QString> failed;
+    int finishedCount = 0;
+    bool cancelled = false;
+    EnhancedAddDirectoryDialog::ImportStatistics statistics;
+
+    void watch(BatchImportProcessor& processor)
+    {
+        QObject::connect(&processor, &BatchImportProcessor::batchWritten, &processor,
+                         [this](const QList<MusicItem>& items,
+                                const QHash<QString, QString>& failures) {
+                             batchSizes.append(items.size() + failures.size());
+                             for (const MusicItem& item : items) {
+                                 written.append(item.path);
+                             }
+                             failed.insert(failures);
+                         });
+        QObject::connect(
+            &processor, &BatchImportProcessor::finished, &processor,
+            [this](const EnhancedAddDirectoryDialog::ImportStatistics& result, bool wasCancelled) {
+                ++finishedCount;
+                cancelled = wasCancelled;
+                statistics = result;
+            });
+    }
+};
+
+} // namespace
+
+void TestBatchImportProcessor::init()
+{
+    m_tempDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_tempDir->isValid());
+
+    m_database = QSqlDatabase::addDatabase("QSQLITE", CONNECTION_NAME);
+    m_database.setDatabaseName(m_tempDir->filePath("import.db"));
+    QVERIFY(m_database.open());
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("CREATE TABLE musics (id INTEGER PRIMARY KEY AUTOINCREMENT, "
+                       "artist VARCHAR(50) NOT NULL, song VARCHAR(25) NOT NULL, "
+                       "genre1 VARCHAR(25) NOT NULL, genre2 VARCHAR(25), country VARCHAR(25), "
+                       "published_date VARCHAR(25), path TEXT, time TEXT, "
+                       "played_times INTEGER DEFAULT 0, last_played TEXT)"));
+}
+
+void TestBatchImportProcessor::cleanup()
+{
+    if (m_database.isOpen()) {
+        m_database.close();
+    }
+    m_database = QSqlDatabase();
+    QSqlDatabase::removeDatabase(CONNECTION_NAME);
+    m_tempDir.reset();
+}
+
+QString TestBatchImportProcessor::createFile(const QString& relativePath)
+{
+    const QString path = m_tempDir->filePath(relativePath);
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QFile file(path);
+    // Contents differ, so no two files look like the same audio
+    if (!file.open(QIODevice::WriteOnly) || file.write(relativePath.toUtf8().repeated(64)) <= 0) {
+        return QString();
+    }
+    return path;
+}
+
+int TestBatchImportProcessor::trackCount()
+{
+    QSqlQuery query(m_database);
+    return query.exec("SELECT COUNT(*) FROM musics") && query.next() ? query.value(0).toInt()
+                                                                      : -1;
+}
+
+void TestBatchImportProcessor::testImportsDirectory()
+{
+    QVERIFY(!createFile("library/Artist A - Song 1.mp3").isEmpty());
+    QVERIFY(!createFile("library/Artist B - Song 2.ogg").isEmpty());
+    QVERIFY(!createFile("library/sub/Artist C - Song 3.flac").isEmpty());
+    QVERIFY(!createFile("library/sub/deeper/Artist D - Song 4.wav").isEmpty());
+    QVERIFY(!createFile("library/sub/Artist E - Song 5.mp3").isEmpty());
+    QVERIFY(!createFile("library/cover.jpg").isEmpty());
+    QVERIFY(!createFile("library/notes.txt").isEmpty());
+
+    MusicRepository repository(m_database);
+    BatchImportProcessor processor(&repository);
+    processor.setMaxWorkers(2);
+    Outcome outcome;
+    outcome.watch(processor);
+
+    QVERIFY(processor.start(m_tempDir->filePath("library"), testOptions(2)));
+    QVERIFY(processor.isRunning());
+    // A second import waits for the first
+    QVERIFY(!processor.start(m_tempDir->filePath("library"), testOptions(2)));
+    QTRY_COMPARE_WITH_TIMEOUT(outcome.finishedCount, 1, 10000);
+
+    QVERIFY(!outcome.cancelled);
+    QVERIFY(!processor.isRunning());
+    QCOMPARE(outcome.batchSizes, QList<int>({2, 2, 1}));
+    QCOMPARE(outcome.written.size(), 5);
+    QVERIFY(outcome.failed.isEmpty());
+
+    const EnhancedAddDirectoryDialog::ImportStatistics& statistics = outcome.statistics;
+    QCOMPARE(statistics.totalFiles, 5);
+    QCOMPARE(statistics.processedFiles, 5);
+    QCOMPARE(statistics.successfulImports, 5);
+    QCOMPARE(statistics.skippedFiles, 0);
+    QCOMPARE(statistics.errorFiles, 0);
+    QCOMPARE(statistics.processedSize, statistics.totalSize);
+    QVERIFY(statistics.totalSize > 0);
+    QVERIFY(statistics.startTime.isValid() && statistics.endTime >= statistics.startTime);
+    QCOMPARE(trackCount(), 5);
+
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("SELECT artist, song FROM musics WHERE path LIKE '%Song 3.flac'"));
+    QVERIFY(query.next());
+    QCOMPARE(query.value(0).toString(), QString("Artist C"));
+    QCOMPARE(query.value(1).toString(), QString("Song 3"));
+}
+
+void TestBatchImportProcessor::testSkipsTracksAlreadyImported()
+{
+    for (int i = 0; i < 4; ++i) {
+        QVERIFY(!createFile(QString("library/Artist - Song %1.mp3").arg(i)).isEmpty());
+    }
+
+    MusicRepository repository(m_database);
+    BatchImportProcessor processor(&repository);
+    Outcome first;
+    first.watch(processor);
+    QVERIFY(processor.start(m_tempDir->filePath("library"), testOptions(3)));
+    QTRY_COMPARE_WITH_TIMEOUT(first.finishedCount, 1, 10000);
+    QCOMPARE(first.statistics.successfulImports, 4);
+
+    BatchImportProcessor again(&repository);
+    Outcome second;
+    second.watch(again);
+    QVERIFY(again.start(m_tempDir->filePath("library"), testOptions(3)));
+    QTRY_COMPARE_WITH_TIMEOUT(second.finishedCount, 1, 10000);
+    QCOMPARE(second.statistics.processedFiles, 4);
+    QCOMPARE(second.statistics.successfulImports, 0);
+    QCOMPARE(second.statistics.skippedFiles, 4);
+    QCOMPARE(trackCount(), 4);
+}
+
+void TestBatchImportProcessor::testCancelWithFullQueues()
+{
+    const int files = 100;
+    for (int i = 0; i < files; ++i) {
+        QVERIFY(!createFile(QString("library/Artist - Song %1.mp3").arg(i)).isEmpty());
+    }
+
+    MusicRepository repository(m_database);
+    BatchImportProcessor processor(&repository);
+    processor.setMaxWorkers(2);
+    Outcome outcome;
+    outcome.watch(processor);
+
+    // Paused before the writer's first tick, so the walker and the
+    // extractors fill both queues and block on them
+    QVERIFY(processor.start(m_tempDir->filePath("library"), testOptions(1)));
+    processor.setPaused(true);
+    QTest::qWait(300);
+    QVERIFY(processor.isRunning());
+
+    QElapsedTimer elapsed;
+    elapsed.start();
+    processor.cancel();
+    QVERIFY2(elapsed.elapsed() < 5000, "cancel() waited on the stages");
+
+    QCOMPARE(outcome.finishedCount, 1);
+    QVERIFY(outcome.cancelled);
+    QVERIFY(!processor.isRunning());
+    QCOMPARE(outcome.statistics.processedFiles, 0);
+    // The walker was held back by the full queues
+    QVERIFY(outcome.statistics.totalFiles < files);
+    QCOMPARE(trackCount(), 0);
+
+    // Nothing is left to write after the cancel
+    QTest::qWait(3 * BatchImportProcessor::WRITE_INTERVAL_MS);
+    QCOMPARE(outcome.finishedCount, 1);
+    QVERIFY(outcome.batchSizes.isEmpty());
+}
+
+void TestBatchImportProcessor::testImportsDroppedPaths()
+{
+    QVERIFY(!createFile("dropped/Artist A - Song 1.mp3").isEmpty());
+    QVERIFY(!createFile("dropped/inner/Artist B - Song 2.ogg").isEmpty());
+    QVERIFY(!createFile("dropped/readme.txt").isEmpty());
+    const QString single = createFile("elsewhere/Artist C - Song 3.mp3");
+    QVERIFY(!single.isEmpty());
+    const QString missing = m_tempDir->filePath("elsewhere/gone.mp3");
+
+    MusicRepository repository(m_database);
+    BatchImportProcessor processor(&repository);
+    processor.setMaxWorkers(2);
+    Outcome outcome;
+    outcome.watch(processor);
+
+    QVERIFY(processor.start(QStringList({m_tempDir->filePath("dropped"), single, missing}),
+                            testOptions(2)));
+    QTRY_COMPARE_WITH_TIMEOUT(outcome.finishedCount, 1, 10000);
+
+    QVERIFY(!outcome.cancelled);
+    QCOMPARE(outcome.statistics.totalFiles, 4);
+    QCOMPARE(outcome.statistics.processedFiles, 4);
+    QCOMPARE(outcome.statistics.successfulImports, 3);
+    QCOMPARE(outcome.statistics.errorFiles, 1);
+    QCOMPARE(outcome.statistics.errorMessages.size(), 1);
+    QCOMPARE(outcome.failed.keys(), QStringList({missing}));
+    QVERIFY(outcome.written.contains(single));
+    // The folder is walked with the extension filter, the files are taken as given
+    QVERIFY(!outcome.written.contains(m_tempDir->filePath("dropped/readme.txt")));
+    QCOMPARE(trackCount(), 3);
+}
+
+// The processor needs no widgets, only an event loop for its writer
+QTEST_GUILESS_MAIN(TestBatchImportProcessor)
@@ -0,0 +1,40 @@
+#ifndef TESTBATCHIMPORTPROCESSOR_H
+#define TESTBATCHIMPORTPROCESSOR_H
+
+#include <QObject>
+#include <QTest>
+#include <QSqlDatabase>
+#include <QTemporaryDir>
+#include <memory>
+
+/**
+ * @brief Unit tests for BatchImportProcessor class
+ *
+ * Tests the staged import including:
+ * - Walking a tree and writing its files in batches, with the statistics
+ * - Skipping the tracks a second import of the same tree finds again
+ * - Cancelling while the queues are full, without waiting on the stages
+ * - Importing a mix of files and folders, as a drop on the window does
+ */
+class TestBatchImportProcessor : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testImportsDirectory();
+    void testSkipsTracksAlreadyImported();
+    void testCancelWithFullQueues();
+    void testImportsDroppedPaths();
+
+private:
+    QString createFile(const QString& relativePath);
+    int trackCount();
+
+    std::unique_ptr<QTemporaryDir> m_tempDir;
+    QSqlDatabase m_database;
+};
+
+#endif // TESTBATCHIMPORTPROCESSOR_H
@@ -0,0 +1,76 @@
+#include "TestHistoryListModel.h"
+#include "../../../src/models/HistoryListModel.h"
+#include <QSignalSpy>
+
+void TestHistoryListModel::testAppend()
+{
+    HistoryListModel history(10);
+    const QDateTime noon(QDate(2026, 10, 14), QTime(12, 0));
+    history.append(noon, "song.ogg");
+    history.append(noon.addSecs(185), "RECOVERY STARTED - live");
+
+    QCOMPARE(history.rowCount(), 2);
+    QCOMPARE(history.index(0).data().toString(), QString("2026-10-14 || 12:00:00 || song.ogg"));
+    QCOMPARE(history.index(1).data(HistoryListModel::TextRole).toString(),
+             QString("RECOVERY STARTED - live"));
+    QCOMPARE(history.index(1).data(HistoryListModel::TimeRole).toDateTime(), noon.addSecs(185));
+    QVERIFY(!history.index(2).data().isValid());
+}
+
+void TestHistoryListModel::testRingReplacesOldest()
+{
+    HistoryListModel history(3);
+    const QDateTime start(QDate(2026, 10, 14), QTime(8, 0));
+    QSignalSpy removed(&history, &QAbstractItemModel::rowsRemoved);
+    QSignalSpy inserted(&history, &QAbstractItemModel::rowsInserted);
+
+    for (int i = 0; i < 7; ++i) {
+        history.append(start.addSecs(60 * i), QString("track%1").arg(i));
+    }
+    QCOMPARE(history.count(), 3);
+    QCOMPARE(inserted.count(), 7);
+    QCOMPARE(removed.count(), 4);
+    QCOMPARE(removed.last().at(1).toInt(), 0);
+    QCOMPARE(inserted.last().at(1).toInt(), 2);
+
+    // Oldest first, whichever slot each one took
+    QCOMPARE(history.entry(0).text, QString("track4"));
+    QCOMPARE(history.entry(1).text, QString("track5"));
+    QCOMPARE(history.entry(2).text, QString("track6"));
+
+    history.clear();
+    QVERIFY(history.isEmpty());
+    history.append(start, "after clear");
+    QCOMPARE(history.entry(0).text, QString("after clear"));
+}
+
+void TestHistoryListModel::testLoadEvents()
+{
+    const QDateTime start(QDate(2026, 10, 14), QTime(8, 0));
+    const QList<EventJournal::Event> events = {
+        {start, EventJournal::Type::TrackStart, {{"path", "/music/a.ogg"}, {"title", "a.ogg"}}},
+        {start.addSecs(60), EventJournal::Type::TrackStop, {{"path", "/music/a.ogg"}}},
+        {start.addSecs(61), EventJournal::Type::TrackStart, {{"path", "/music/b.ogg"}}},
+        {start.addSecs(62), EventJournal::Type::TakeOver,
+         {{"state", "started"}, {"stream", "live"}}},
+        {start.addSecs(63), EventJournal::Type::TakeOver, {{"state", "ended"}, {"stream", "live"}}},
+        {start.addSecs(64), EventJournal::Type::Error, {{"message", "oops"}}},
+        {start.addSecs(65), EventJournal::Type::TrackStart, {{"path", "/music/c.ogg"}}},
+    };
+
+    HistoryListModel history(3);
+    QSignalSpy reset(&history, &QAbstractItemModel::modelReset);
+    QCOMPARE(history.load(events), 3);
+    QCOMPARE(reset.count(), 1);
+    QCOMPARE(history.entry(0).text, QString("b.ogg"));
+    QCOMPARE(history.entry(1).text, QString("live"));
+    QCOMPARE(history.entry(2).text, QString("c.ogg"));
+    QCOMPARE(history.entry(2).time, start.addSecs(65));
+
+    QVERIFY(!history.appendEvent(events.at(1)));
+    QVERIFY(history.appendEvent(events.at(0)));
+    QCOMPARE(history.entry(2).text, QString("a.ogg"));
+    QCOMPARE(history.count(), 3);
+}
+
+QTEST_MAIN(TestHistoryListModel)
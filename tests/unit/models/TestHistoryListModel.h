@@ -0,0 +1,25 @@
+#ifndef TESTHISTORYLISTMODEL_H
+#define TESTHISTORYLISTMODEL_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for HistoryListModel class
+ *
+ * Tests the history list including:
+ * - Entries shown as the old list items were
+ * - The oldest entry replaced once the capacity is reached
+ * - Entries read back from journal events
+ */
+class TestHistoryListModel : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testAppend();
+    void testRingReplacesOldest();
+    void testLoadEvents();
+};
+
+#endif // TESTHISTORYLISTMODEL_H
@@ -0,0 +1,302 @@
+#include "TestLiveTableModel.h"
+#include "../../../src/models/LiveTableModel.h"
+#include <QItemSelectionModel>
+#include <QPersistentModelIndex>
+#include <QSignalSpy>
+#include <QSqlError>
+#include <QSqlQuery>
+
+namespace {
+
+const char* CONNECTION_NAME = "test_live_table_model_connection";
+
+QStringList columnValues(const LiveTableModel& model, int column)
+{
+    QStringList values;
+    for (int row = 0; row < model.rowCount(); ++row) {
+        values.append(model.index(row, column).data().toString());
+    }
+    return values;
+}
+
+} // namespace
+
+void TestLiveTableModel::init()
+{
+    m_tempDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_tempDir->isValid());
+
+    m_database = QSqlDatabase::addDatabase("QSQLITE", CONNECTION_NAME);
+    m_database.setDatabaseName(m_tempDir->path() + "/live.db");
+    QVERIFY(m_database.open());
+
+    exec("CREATE TABLE jingles (name TEXT, path TEXT, played INTEGER)");
+    exec("INSERT INTO jingles VALUES ('Alpha', '/j/alpha.mp3', 3)");
+    exec("INSERT INTO jingles VALUES ('Bravo', '/j/bravo.mp3', 1)");
+    exec("INSERT INTO jingles VALUES ('Charlie', '/j/charlie.mp3', 2)");
+}
+
+void TestLiveTableModel::cleanup()
+{
+    if (m_database.isOpen()) {
+        m_database.close();
+    }
+    m_database = QSqlDatabase();
+    QSqlDatabase::removeDatabase(CONNECTION_NAME);
+    m_tempDir.reset();
+}
+
+void TestLiveTableModel::testSelect()
+{
+    LiveTableModel model("jingles", CONNECTION_NAME);
+    QVERIFY(model.select());
+
+    // Same columns as the table, rowid is not one of them
+    QCOMPARE(model.columnCount(), 3);
+    QCOMPARE(model.rowCount(), 3);
+    QCOMPARE(model.headerData(1, Qt::Horizontal).toString(), QString("path"));
+    QCOMPARE(model.fieldIndex("played"), 2);
+    QCOMPARE(model.fieldIndex("missing"), -1);
+    QCOMPARE(columnValues(model, 0), QStringList({"Alpha", "Bravo", "Charlie"}));
+    QCOMPARE(model.keyOf(1), qint64(2));
+    QCOMPARE(model.rowOfKey(3), 2);
+
+    LiveTableModel missing("no_such_table", CONNECTION_NAME);
+    QSignalSpy errorSpy(&missing, &LiveTableModel::operationError);
+    QVERIFY(!missing.select());
+    QCOMPARE(errorSpy.count(), 1);
+}
+
+void TestLiveTableModel::testRefreshAppliesDiff()
+{
+    LiveTableModel model("jingles", CONNECTION_NAME);
+    QVERIFY(model.select());
+
+    QSignalSpy resetSpy(&model, &QAbstractItemModel::modelReset);
+    QSignalSpy insertSpy(&model, &QAbstractItemModel::rowsInserted);
+    QSignalSpy removeSpy(&model, &QAbstractItemModel::rowsRemoved);
+    QSignalSpy changeSpy(&model, &QAbstractItemModel::dataChanged);
+    QSignalSpy batchSpy(&model, &LiveTableModel::batchFinished);
+
+    // Nothing changed: nothing is reported
+    QVERIFY(model.refresh());
+    QCOMPARE(insertSpy.count() + removeSpy.count() + changeSpy.count(), 0);
+    QCOMPARE(batchSpy.count(), 1);
+    QCOMPARE(batchSpy.takeFirst(), QVariantList({0, 0, 0}));
+
+    exec("DELETE FROM jingles WHERE name = 'Bravo'");
+    exec("UPDATE jingles SET path = '/j/charlie.ogg' WHERE name = 'Charlie'");
+    exec("INSERT INTO jingles VALUES ('Delta', '/j/delta.mp3', 0)");
+    exec("INSERT INTO jingles VALUES ('Echo', '/j/echo.mp3', 0)");
+    QVERIFY(model.refresh());
+
+    QCOMPARE(resetSpy.count(), 0);
+    QCOMPARE(removeSpy.count(), 1);
+    QCOMPARE(removeSpy.first().at(1).toInt(), 1);
+    QCOMPARE(changeSpy.count(), 1);
+    QCOMPARE(changeSpy.first().at(0).toModelIndex().row(), 1);
+    QCOMPARE(insertSpy.count(), 1); // Both new rows in one block
+    QCOMPARE(insertSpy.first().at(1).toInt(), 2);
+    QCOMPARE(insertSpy.first().at(2).toInt(), 3);
+    QCOMPARE(batchSpy.count(), 1);
+    QCOMPARE(batchSpy.first(), QVariantList({2, 1, 1})); // inserted, removed, updated
+
+    QCOMPARE(columnValues(model, 0), QStringList({"Alpha", "Charlie", "Delta", "Echo"}));
+    QCOMPARE(model.index(1, 1).data().toString(), QString("/j/charlie.ogg"));
+    QCOMPARE(model.rowOfKey(3), 1);
+}
+
+void TestLiveTableModel::testSelectionFollowsMovedRows()
+{
+    LiveTableModel model("jingles", CONNECTION_NAME);
+    QVERIFY(model.select());
+    model.sort(2, Qt::AscendingOrder);
+    QCOMPARE(columnValues(model, 0), QStringList({"Bravo", "Charlie", "Alpha"}));
+
+    QItemSelectionModel selection(&model);
+    selection.setCurrentIndex(model.index(0, 0), QItemSelectionModel::ClearAndSelect | QItemSelectionModel::Rows);
+    QPersistentModelIndex current = selection.currentIndex();
+
+    // Bravo is played more than the others and moves to the end
+    QSignalSpy resetSpy(&model, &QAbstractItemModel::modelReset);
+    exec("UPDATE jingles SET played = 9 WHERE name = 'Bravo'");
+    QVERIFY(model.refresh());
+
+    QCOMPARE(resetSpy.count(), 0);
+    QCOMPARE(columnValues(model, 0), QStringList({"Charlie", "Alpha", "Bravo"}));
+    QCOMPARE(current.row(), 2);
+    QCOMPARE(selection.currentIndex().data().toString(), QString("Bravo"));
+    QVERIFY(selection.isRowSelected(2, QModelIndex()));
+    QVERIFY(!selection.isRowSelected(0, QModelIndex()));
+}
+
+void TestLiveTableModel::testRefreshRow()
+{
+    LiveTableModel model("jingles", CONNECTION_NAME);
+    QVERIFY(model.select());
+    model.sort(0, Qt::DescendingOrder);
+    QCOMPARE(columnValues(model, 0), QStringList({"Charlie", "Bravo", "Alpha"}));
+
+    QPersistentModelIndex alpha = model.index(2, 0);
+    QSignalSpy moveSpy(&model, &QAbstractItemModel::rowsMoved);
+    exec("UPDATE jingles SET name = 'Zulu' WHERE rowid = 1");
+    QVERIFY(model.refreshRow(1));
+    QCOMPARE(columnValues(model, 0), QStringList({"Zulu", "Charlie", "Bravo"}));
+    QCOMPARE(moveSpy.count(), 1);
+    QCOMPARE(alpha.row(), 0);
+
+    exec("INSERT INTO jingles VALUES ('Golf', '/j/golf.mp3', 0)");
+    QVERIFY(model.refreshRow(4));
+    QCOMPARE(columnValues(model, 0), QStringList({"Zulu", "Golf", "Charlie", "Bravo"}));
+
+    exec("DELETE FROM jingles WHERE rowid = 2");
+    QVERIFY(model.refreshRow(2));
+    QCOMPARE(columnValues(model, 0), QStringList({"Zulu", "Golf", "Charlie"}));
+
+    model.removeKey(4);
+    QCOMPARE(columnValues(model, 0), QStringList({"Zulu", "Charlie"}));
+    QCOMPARE(model.rowOfKey(4), -1);
+    model.removeKey(99);
+    QCOMPARE(model.rowCount(), 2);
+}
+
+void TestLiveTableModel::testRemoveKeys()
+{
+    exec("INSERT INTO jingles VALUES ('Delta', '/j/delta.mp3', 0)");
+    exec("INSERT INTO jingles VALUES ('Echo', '/j/echo.mp3', 0)");
+    exec("INSERT INTO jingles VALUES ('Foxtrot', '/j/foxtrot.mp3', 0)");
+    LiveTableModel model("jingles", CONNECTION_NAME);
+    QVERIFY(model.select());
+
+    // Adjacent rows leave together; unknown and repeated keys are ignored
+    QSignalSpy removeSpy(&model, &QAbstractItemModel::rowsRemoved);
+    model.removeKeys({1, 2, 4, 6, 99, 2});
+    QCOMPARE(columnValues(model, 0), QStringList({"Charlie", "Echo"}));
+    QCOMPARE(removeSpy.count(), 3);
+    QCOMPARE(model.rowOfKey(5), 1);
+    QCOMPARE(model.rowOfKey(4), -1);
+
+    model.removeKeys({});
+    QCOMPARE(removeSpy.count(), 3);
+}
+
+void TestLiveTableModel::testApplyChange()
+{
+    LiveTableModel model("jingles", CONNECTION_NAME);
+    QVERIFY(model.select());
+    QSignalSpy resetSpy(&model, &QAbstractItemModel::modelReset);
+
+    exec("UPDATE jingles SET path = '/j/alpha.ogg' WHERE rowid = 1");
+    exec("DELETE FROM jingles WHERE rowid = 2");
+    exec("INSERT INTO jingles VALUES ('Delta', '/j/delta.mp3', 0)");
+    TableChangeBus::Change change;
+    change.table = "jingles";
+    change.changed = {1, 4};
+    change.removed = {2};
+    QVERIFY(model.applyChange(change));
+    QCOMPARE(columnValues(model, 0), QStringList({"Alpha", "Charlie", "Delta"}));
+    QCOMPARE(model.index(0, 1).data().toString(), QString("/j/alpha.ogg"));
+
+    // Other tables are not this model's business
+    exec("DELETE FROM jingles WHERE rowid = 3");
+    change.table = "musics";
+    change.changed.clear();
+    change.removed = {1, 3, 4};
+    QVERIFY(model.applyChange(change));
+    QCOMPARE(model.rowCount(), 3);
+
+    // A reset re-reads the table without resetting the view
+    TableChangeBus::Change reset;
+    reset.table = "jingles";
+    reset.reset = true;
+    QVERIFY(model.applyChange(reset));
+    QCOMPARE(columnValues(model, 0), QStringList({"Alpha", "Delta"}));
+    QCOMPARE(resetSpy.count(), 0);
+}
+
+void TestLiveTableModel::testAssignRows()
+{
+    LiveTableModel model("jingles", CONNECTION_NAME);
+    QVERIFY(model.select());
+    model.sort(2, Qt::DescendingOrder);
+
+    // Rows read elsewhere take the model's sort order
+    QSignalSpy resetSpy(&model, &QAbstractItemModel::modelReset);
+    const QStringList fields = {"name", "path", "played"};
+    QVERIFY(model.assignRows(fields, {2, 3},
+                             {{"Bravo", "/j/bravo.mp3", 1}, {"Charlie", "/j/charlie.mp3", 2}}));
+    QCOMPARE(resetSpy.count(), 1);
+    QCOMPARE(columnValues(model, 0), QStringList({"Charlie", "Bravo"}));
+    QCOMPARE(model.rowOfKey(2), 1);
+
+    // Rows of other columns are refused
+    QVERIFY(!model.assignRows({"name", "path"}, {1}, {{"Alpha", "/j/alpha.mp3"}}));
+    QVERIFY(!model.assignRows(fields, {1, 2}, {{"Alpha", "/j/alpha.mp3", 3}}));
+    QCOMPARE(model.rowCount(), 2);
+}
+
+void TestLiveTableModel::testSortAndFilter()
+{
+    exec("INSERT INTO jingles VALUES ('Nameless', NULL, NULL)");
+
+    LiveTableModel model("jingles", CONNECTION_NAME);
+    QVERIFY(model.select());
+
+    // NULL sorts first, as in SQLite; a refreshed row lands in the same place
+    model.sort(2, Qt::AscendingOrder);
+    QCOMPARE(columnValues(model, 0), QStringList({"Nameless", "Bravo", "Charlie", "Alpha"}));
+    exec("UPDATE jingles SET played = 2 WHERE name = 'Alpha'");
+    QVERIFY(model.refreshRow(1));
+    QCOMPARE(columnValues(model, 0), QStringList({"Nameless", "Bravo", "Alpha", "Charlie"}));
+
+    model.setFilter("played >= 2");
+    QCOMPARE(model.filter(), QString("played >= 2"));
+    QVERIFY(model.refresh());
+    QCOMPARE(columnValues(model, 0), QStringList({"Alpha", "Charlie"}));
+
+    // A row that stops matching the filter leaves the model
+    exec("UPDATE jingles SET played = 0 WHERE name = 'Charlie'");
+    QVERIFY(model.refreshRow(3));
+    QCOMPARE(columnValues(model, 0), QStringList({"Alpha"}));
+
+    model.setFilter(QString());
+    QVERIFY(model.select());
+    QCOMPARE(model.rowCount(), 4);
+
+    // Bound values go before those of a single row's refresh
+    model.setFilter("name = ? OR played = ?", {"Bravo", 2});
+    QCOMPARE(model.filterValues(), QVariantList({"Bravo", 2}));
+    QVERIFY(model.select());
+    QCOMPARE(columnValues(model, 0), QStringList({"Bravo", "Alpha"}));
+    exec("UPDATE jingles SET played = 2 WHERE name = 'Charlie'");
+    QVERIFY(model.refreshRow(3));
+    QCOMPARE(columnValues(model, 0), QStringList({"Bravo", "Alpha", "Charlie"}));
+}
+
+void TestLiveTableModel::testSetData()
+{
+    LiveTableModel model("jingles", CONNECTION_NAME);
+    QVERIFY(model.select());
+    QVERIFY(model.flags(model.index(0, 1)) & Qt::ItemIsEditable);
+
+    QVERIFY(model.setData(model.index(0, 1), "/j/alpha.ogg"));
+    QCOMPARE(model.index(0, 1).data().toString(), QString("/j/alpha.ogg"));
+
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("SELECT path FROM jingles WHERE rowid = 1"));
+    QVERIFY(query.next());
+    QCOMPARE(query.value(0).toString(), QString("/j/alpha.ogg"));
+
+    // Column affinity converts the text to an integer
+    QVERIFY(model.setData(model.index(0, 2), "7"));
+    QCOMPARE(model.index(0, 2).data().typeId(), int(QMetaType::LongLong));
+    QCOMPARE(model.index(0, 2).data().toInt(), 7);
+}
+
+void TestLiveTableModel::exec(const QString& sql)
+{
+    QSqlQuery query(m_database);
+    QVERIFY2(query.exec(sql), qPrintable(query.lastError().text()));
+}
+
+QTEST_MAIN(TestLiveTableModel)
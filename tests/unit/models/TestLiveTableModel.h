@@ -0,0 +1,45 @@
+#ifndef TESTLIVETABLEMODEL_H
+#define TESTLIVETABLEMODEL_H
+
+#include <QObject>
+#include <QTest>
+#include <QSqlDatabase>
+#include <QTemporaryDir>
+#include <memory>
+
+/**
+ * @brief Unit tests for LiveTableModel class
+ *
+ * Tests that table refreshes reach the view as row-level changes:
+ * - Inserts, removals and updates without a model reset, counted per refresh
+ * - Selection following rows that move
+ * - Single-row refresh, sorting, filtering and editing
+ * - Applying the changes TableChangeBus delivers
+ * - Showing rows read on another thread, in the model's order
+ */
+class TestLiveTableModel : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testSelect();
+    void testRefreshAppliesDiff();
+    void testSelectionFollowsMovedRows();
+    void testRefreshRow();
+    void testRemoveKeys();
+    void testApplyChange();
+    void testAssignRows();
+    void testSortAndFilter();
+    void testSetData();
+
+private:
+    void exec(const QString& sql);
+
+    std::unique_ptr<QTemporaryDir> m_tempDir;
+    QSqlDatabase m_database;
+};
+
+#endif // TESTLIVETABLEMODEL_H
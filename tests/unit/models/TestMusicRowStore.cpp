@@ -0,0 +1,203 @@
+#include "TestMusicRowStore.h"
+#include "../../../src/models/MusicRowStore.h"
+#include "../../../src/repositories/MusicRepository.h"
+
+namespace {
+
+MusicItem makeItem(int id, const QString& artist = "Artist", const QString& genre = "Rock")
+{
+    MusicItem music;
+    music.id = id;
+    music.artist = artist;
+    music.song = QString("Song number %1").arg(id);
+    music.genre1 = genre;
+    music.genre2 = "Alternative";
+    music.country = "Portugal";
+    music.publishedDate = "1999";
+    music.path = QString("/music/library/%1/track_%2.mp3").arg(artist).arg(id);
+    music.time = "3:45";
+    music.playedTimes = id % 7;
+    music.lastPlayed = QString("2024-03-%1T20:15:00").arg(id % 28 + 1, 2, 10, QChar('0'));
+    return music;
+}
+
+void compareItems(const MusicItem& actual, const MusicItem& expected)
+{
+    QCOMPARE(actual.id, expected.id);
+    QCOMPARE(actual.artist, expected.artist);
+    QCOMPARE(actual.song, expected.song);
+    QCOMPARE(actual.genre1, expected.genre1);
+    QCOMPARE(actual.genre2, expected.genre2);
+    QCOMPARE(actual.country, expected.country);
+    QCOMPARE(actual.publishedDate, expected.publishedDate);
+    QCOMPARE(actual.path, expected.path);
+    QCOMPARE(actual.time, expected.time);
+    QCOMPARE(actual.playedTimes, expected.playedTimes);
+    QCOMPARE(actual.lastPlayed, expected.lastPlayed);
+}
+
+} // namespace
+
+void TestMusicRowStore::testRoundTrip()
+{
+    MusicRowStore rows;
+    rows.resize(10);
+    QCOMPARE(rows.rowCount(), 10);
+    QCOMPARE(rows.loadedCount(), 0);
+    QVERIFY(!rows.isLoaded(3));
+
+    const MusicItem music = makeItem(42);
+    rows.setRow(3, music);
+    QVERIFY(rows.isLoaded(3));
+    QCOMPARE(rows.loadedCount(), 1);
+    compareItems(rows.item(3), music);
+    QCOMPARE(rows.durationSecs(3), 225);
+
+    // Out of range rows are ignored
+    rows.setRow(10, music);
+    rows.setRow(-1, music);
+    QCOMPARE(rows.loadedCount(), 1);
+    QVERIFY(!rows.isLoaded(10));
+
+    // Replacing a row keeps one slot
+    const MusicItem other = makeItem(7, "Other", "Jazz");
+    rows.setRow(3, other);
+    QCOMPARE(rows.loadedCount(), 1);
+    compareItems(rows.item(3), other);
+
+    rows.clear();
+    QCOMPARE(rows.rowCount(), 10);
+    QVERIFY(!rows.isLoaded(3));
+}
+
+void TestMusicRowStore::testInterning()
+{
+    MusicRowStore rows;
+    rows.resize(2000);
+
+    rows.setRow(0, makeItem(0));
+    const qint64 afterFirst = rows.memoryUsage();
+    for (int row = 1; row < 2000; ++row) {
+        rows.setRow(row, makeItem(row));
+    }
+
+    // Symbols are stored once; only the pool and records grow per row
+    QCOMPARE(rows.artist(1999), QString("Artist"));
+    QCOMPARE(rows.genre1(1000), QString("Rock"));
+    const qint64 perRow = (rows.memoryUsage() - afterFirst) / 1999;
+    QVERIFY2(perRow < 450, qPrintable(QString("%1 bytes per row").arg(perRow)));
+}
+
+void TestMusicRowStore::testDurationParsing()
+{
+    QCOMPARE(MusicRowStore::parseDuration("3:45"), 225);
+    QCOMPARE(MusicRowStore::parseDuration("1:02:03"), 3723);
+    QCOMPARE(MusicRowStore::parseDuration("03:45"), 225);
+    QCOMPARE(MusicRowStore::parseDuration(""), -1);
+    QCOMPARE(MusicRowStore::parseDuration("3:5"), -1);
+    QCOMPARE(MusicRowStore::parseDuration("3:75"), -1);
+    QCOMPARE(MusicRowStore::parseDuration("abc"), -1);
+    QCOMPARE(MusicRowStore::formatDuration(225), QString("3:45"));
+    QCOMPARE(MusicRowStore::formatDuration(3723), QString("1:02:03"));
+
+    // Text that formats differently is stored as it was
+    MusicRowStore rows;
+    rows.resize(3);
+    MusicItem padded = makeItem(1);
+    padded.time = "03:45";
+    rows.setRow(0, padded);
+    MusicItem unknown = makeItem(2);
+    unknown.time = "unknown";
+    rows.setRow(1, unknown);
+    MusicItem empty = makeItem(3);
+    empty.time.clear();
+    rows.setRow(2, empty);
+
+    QCOMPARE(rows.time(0), QString("03:45"));
+    QCOMPARE(rows.durationSecs(0), 225);
+    QCOMPARE(rows.time(1), QString("unknown"));
+    QCOMPARE(rows.durationSecs(1), -1);
+    QCOMPARE(rows.time(2), QString());
+}
+
+void TestMusicRowStore::testUnloadAndReuse()
+{
+    MusicRowStore rows;
+    rows.resize(100);
+    for (int row = 0; row < 100; ++row) {
+        rows.setRow(row, makeItem(row));
+    }
+
+    rows.unloadRows(10, 19);
+    QCOMPARE(rows.loadedCount(), 90);
+    QVERIFY(!rows.isLoaded(10));
+    QVERIFY(!rows.isLoaded(19));
+    QVERIFY(rows.isLoaded(20));
+
+    // Clamped to the row count
+    rows.unloadRows(95, 500);
+    QCOMPARE(rows.loadedCount(), 85);
+
+    // Freed slots are reused and other rows are untouched
+    for (int row = 10; row < 20; ++row) {
+        rows.setRow(row, makeItem(row + 1000));
+    }
+    QCOMPARE(rows.loadedCount(), 95);
+    compareItems(rows.item(15), makeItem(1015));
+    compareItems(rows.item(25), makeItem(25));
+}
+
+void TestMusicRowStore::testCompaction()
+{
+    MusicRowStore rows;
+    const int count = 4000;
+    rows.resize(count);
+    for (int row = 0; row < count; ++row) {
+        rows.setRow(row, makeItem(row));
+    }
+    const qint64 fullUsage = rows.memoryUsage();
+
+    // Dropping most rows compacts the pool without disturbing the rest
+    rows.unloadRows(0, count - 11);
+    QCOMPARE(rows.loadedCount(), 10);
+    for (int row = count - 10; row < count; ++row) {
+        compareItems(rows.item(row), makeItem(row));
+    }
+
+    // Reloading the same rows reuses the space
+    for (int row = 0; row < count - 10; ++row) {
+        rows.setRow(row, makeItem(row));
+    }
+    QVERIFY(rows.memoryUsage() <= fullUsage * 2);
+    compareItems(rows.item(0), makeItem(0));
+}
+
+void TestMusicRowStore::testMemoryUsage()
+{
+    const int count = 10000;
+    MusicRowStore rows;
+    rows.resize(count);
+    QList<MusicItem> items;
+    items.reserve(count);
+    for (int row = 0; row < count; ++row) {
+        const MusicItem music = makeItem(row, QString("Artist %1").arg(row % 200), QString("Genre %1").arg(row % 20));
+        rows.setRow(row, music);
+        items.append(music);
+    }
+
+    // One heap block per string plus the item itself; the store should need
+    // well under two thirds of that even with its pool over-allocated
+    qint64 itemBytes = 0;
+    for (const MusicItem& music : std::as_const(items)) {
+        itemBytes += sizeof(MusicItem);
+        for (const QString* text : {&music.artist, &music.song, &music.genre1, &music.genre2, &music.country,
+                                    &music.publishedDate, &music.path, &music.time, &music.lastPlayed}) {
+            itemBytes += 16 + text->capacity() * qint64(sizeof(QChar));
+        }
+    }
+
+    QVERIFY2(rows.memoryUsage() * 3 < itemBytes * 2,
+             qPrintable(QString("store %1 bytes, items %2 bytes").arg(rows.memoryUsage()).arg(itemBytes)));
+}
+
+QTEST_MAIN(TestMusicRowStore)
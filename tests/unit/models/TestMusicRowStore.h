@@ -0,0 +1,30 @@
+#ifndef TESTMUSICROWSTORE_H
+#define TESTMUSICROWSTORE_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for MusicRowStore class
+ *
+ * Tests the columnar row storage behind MusicListModel:
+ * - Rows read back field for field
+ * - Repeated values share one interned symbol
+ * - Duration text that does not round-trip through seconds is kept
+ * - Unloading, slot reuse and pool compaction
+ * - Memory use against plain MusicItem copies
+ */
+class TestMusicRowStore : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testRoundTrip();
+    void testInterning();
+    void testDurationParsing();
+    void testUnloadAndReuse();
+    void testCompaction();
+    void testMemoryUsage();
+};
+
+#endif // TESTMUSICROWSTORE_H
@@ -0,0 +1,181 @@
+#include "TestPlaylistQueueModel.h"
+#include "../../../src/models/PlaylistQueueModel.h"
+#include <QSignalSpy>
+
+namespace {
+
+// Durations in seconds are taken from the file name, "unknown" has none
+PlaylistQueueModel::Resolver resolver(int* lookups)
+{
+    return [lookups](PlaylistQueueModel::Entry& entry) {
+        ++*lookups;
+        if (entry.durationUs < 0) {
+            bool ok = false;
+            const QString name = entry.path.section('/', -1).section('.', 0, 0);
+            const qint64 seconds = name.toLongLong(&ok);
+            entry.durationUs = ok ? seconds * 1000000 : -1;
+        }
+        if (entry.path.contains("trimmed")) {
+            entry.cueInMs = 1000;
+            entry.cueOutMs = 9000;
+        }
+    };
+}
+
+} // namespace
+
+void TestPlaylistQueueModel::testTotalFollowsEntries()
+{
+    int lookups = 0;
+    PlaylistQueueModel queue;
+    queue.setResolver(resolver(&lookups));
+    QSignalSpy totalSpy(&queue, &PlaylistQueueModel::totalChanged);
+
+    queue.append(QStringList({"/m/10.ogg", "/m/20.ogg"}));
+    queue.prepend("/m/unknown.ogg");
+    queue.insert(99, "/m/trimmed/30.ogg");
+
+    QCOMPARE(queue.count(), 4);
+    QCOMPARE(queue.paths(), QStringList({"/m/unknown.ogg", "/m/10.ogg", "/m/20.ogg",
+                                         "/m/trimmed/30.ogg"}));
+    QCOMPARE(lookups, 4);
+    // 10 + 20 + the 8 seconds between the cue points of the last one
+    QCOMPARE(queue.totalAirTimeUs(), qint64(38) * 1000000);
+    QCOMPARE(queue.unknownDurationCount(), 1);
+    QCOMPARE(totalSpy.count(), 3);
+    QCOMPARE(totalSpy.last().at(0).toLongLong(), qint64(38) * 1000000);
+
+    QCOMPARE(queue.data(queue.index(1), PlaylistQueueModel::DurationRole).toLongLong(),
+             qint64(10) * 1000000);
+    QCOMPARE(queue.paths(2), QStringList({"/m/unknown.ogg", "/m/10.ogg"}));
+
+    queue.clear();
+    QVERIFY(queue.isEmpty());
+    QCOMPARE(queue.totalAirTimeUs(), qint64(0));
+    QCOMPARE(queue.unknownDurationCount(), 0);
+    // Nothing is looked up again on the way out
+    QCOMPARE(lookups, 4);
+}
+
+void TestPlaylistQueueModel::testAppendEntries()
+{
+    int lookups = 0;
+    PlaylistQueueModel queue;
+    queue.setResolver(resolver(&lookups));
+    queue.append("/m/10.ogg");
+    QSignalSpy insertSpy(&queue, &QAbstractItemModel::rowsInserted);
+    QSignalSpy totalSpy(&queue, &PlaylistQueueModel::totalChanged);
+
+    std::vector<PlaylistQueueModel::Entry> entries(3);
+    entries[0].path = "/m/saved.ogg";
+    entries[0].durationUs = qint64(5) * 1000000;
+    entries[0].musicId = 42;
+    entries[1].path = "/m/20.ogg";
+    entries[2].path = "/m/trimmed/30.ogg";
+    queue.append(std::move(entries));
+
+    QCOMPARE(insertSpy.count(), 1);
+    QCOMPARE(insertSpy.first().at(1).toInt(), 1);
+    QCOMPARE(insertSpy.first().at(2).toInt(), 3);
+    QCOMPARE(totalSpy.count(), 1);
+    QCOMPARE(lookups, 4);
+    // The saved duration is kept; the cue points still come from the resolver
+    QCOMPARE(queue.entry(1).musicId, qint64(42));
+    QCOMPARE(queue.totalAirTimeUs(), qint64(10 + 5 + 20 + 8) * 1000000);
+}
+
+void TestPlaylistQueueModel::testTakeFirstAndRemove()
+{
+    int lookups = 0;
+    PlaylistQueueModel queue;
+    queue.setResolver(resolver(&lookups));
+    queue.append(QStringList({"/m/10.ogg", "/m/20.ogg", "/m/30.ogg"}));
+
+    QSignalSpy removeSpy(&queue, &QAbstractItemModel::rowsRemoved);
+    const PlaylistQueueModel::Entry head = queue.takeFirst();
+    QCOMPARE(head.path, QString("/m/10.ogg"));
+    QCOMPARE(head.durationUs, qint64(10) * 1000000);
+    QCOMPARE(removeSpy.count(), 1);
+    QCOMPARE(queue.path(0), QString("/m/20.ogg"));
+    QCOMPARE(queue.totalAirTimeUs(), qint64(50) * 1000000);
+
+    queue.removeAt(1);
+    QCOMPARE(queue.paths(), QStringList({"/m/20.ogg"}));
+    QCOMPARE(queue.totalAirTimeUs(), qint64(20) * 1000000);
+
+    // Rows that do not exist are left alone
+    queue.removeAt(5);
+    QCOMPARE(queue.count(), 1);
+    QVERIFY(queue.path(5).isEmpty());
+
+    // A view removing rows takes off the duration each row was added with
+    queue.append(QStringList({"/m/unknown.ogg", "/m/trimmed/40.ogg"}));
+    QCOMPARE(queue.totalAirTimeUs(), qint64(20 + 8) * 1000000);
+    QVERIFY(queue.removeRows(1, 2));
+    QCOMPARE(queue.totalAirTimeUs(), qint64(20) * 1000000);
+    QCOMPARE(queue.unknownDurationCount(), 0);
+    QCOMPARE(lookups, 5);
+}
+
+void TestPlaylistQueueModel::testMove()
+{
+    PlaylistQueueModel queue;
+    queue.append(QStringList({"/m/a.ogg", "/m/b.ogg", "/m/c.ogg", "/m/d.ogg"}));
+
+    QSignalSpy moveSpy(&queue, &QAbstractItemModel::rowsMoved);
+    QVERIFY(queue.move(0, 3));
+    QCOMPARE(queue.paths(), QStringList({"/m/b.ogg", "/m/c.ogg", "/m/d.ogg", "/m/a.ogg"}));
+    QVERIFY(queue.move(2, 0));
+    QCOMPARE(queue.paths(), QStringList({"/m/d.ogg", "/m/b.ogg", "/m/c.ogg", "/m/a.ogg"}));
+    QCOMPARE(moveSpy.count(), 2);
+
+    // As a view drops a row: before the row it lands on
+    QVERIFY(queue.moveRow(QModelIndex(), 1, QModelIndex(), 4));
+    QCOMPARE(queue.paths(), QStringList({"/m/d.ogg", "/m/c.ogg", "/m/a.ogg", "/m/b.ogg"}));
+
+    QVERIFY(!queue.move(0, 4));
+    QVERIFY(queue.move(1, 1));
+    QCOMPARE(moveSpy.count(), 3);
+}
+
+void TestPlaylistQueueModel::testPendingEntries()
+{
+    int lookups = 0;
+    PlaylistQueueModel queue;
+    queue.setResolver(resolver(&lookups));
+    queue.append("/m/10.ogg");
+    queue.appendPending("/m/20.ogg", "Reading tags...");
+    queue.appendPending("/m/30.ogg", "Reading tags...");
+
+    QCOMPARE(queue.count(), 3);
+    QCOMPARE(lookups, 1);
+    QCOMPARE(queue.totalAirTimeUs(), qint64(10) * 1000000);
+    QVERIFY(queue.data(queue.index(1), PlaylistQueueModel::PendingRole).toBool());
+    QCOMPARE(queue.data(queue.index(1), Qt::ToolTipRole).toString(), QString("Reading tags..."));
+
+    QSignalSpy changeSpy(&queue, &QAbstractItemModel::dataChanged);
+    QCOMPARE(queue.settle({{"/m/30.ogg", "Song 30"}, {"/m/other.ogg", "Other"}}), 1);
+    QCOMPARE(changeSpy.count(), 1);
+    QCOMPARE(queue.totalAirTimeUs(), qint64(40) * 1000000);
+    QVERIFY(!queue.data(queue.index(2), PlaylistQueueModel::PendingRole).toBool());
+    QCOMPARE(queue.data(queue.index(2), Qt::ToolTipRole).toString(), QString("Song 30"));
+
+    // A pending entry leaves without touching the total
+    queue.removeAt(1);
+    QCOMPARE(queue.totalAirTimeUs(), qint64(40) * 1000000);
+}
+
+void TestPlaylistQueueModel::testRelocate()
+{
+    int lookups = 0;
+    PlaylistQueueModel queue;
+    queue.setResolver(resolver(&lookups));
+    queue.append(QStringList({"/m/10.flac", "/m/20.ogg", "/m/10.flac"}));
+
+    QCOMPARE(queue.relocate("/m/10.flac", "/m/12.ogg"), 2);
+    QCOMPARE(queue.paths(), QStringList({"/m/12.ogg", "/m/20.ogg", "/m/12.ogg"}));
+    QCOMPARE(queue.totalAirTimeUs(), qint64(44) * 1000000);
+    QCOMPARE(queue.relocate("/m/missing.ogg", "/m/1.ogg"), 0);
+}
+
+QTEST_MAIN(TestPlaylistQueueModel)
@@ -0,0 +1,30 @@
+#ifndef TESTPLAYLISTQUEUEMODEL_H
+#define TESTPLAYLISTQUEUEMODEL_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for PlaylistQueueModel class
+ *
+ * Tests the on-air queue including:
+ * - Entries looked up once, and the running total air time between cue points
+ * - Saved entries queued in one insert, keeping what they already know
+ * - Taking the head, removing and moving entries
+ * - Pending entries of a drop, left out of the total until settled
+ * - Entries pointed at a replacement file
+ */
+class TestPlaylistQueueModel : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testTotalFollowsEntries();
+    void testAppendEntries();
+    void testTakeFirstAndRemove();
+    void testMove();
+    void testPendingEntries();
+    void testRelocate();
+};
+
+#endif // TESTPLAYLISTQUEUEMODEL_H
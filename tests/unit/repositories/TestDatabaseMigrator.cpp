@@ -83,6 +83,31 @@ void TestDatabaseMigrator::insertTestMigrations()
         "DROP TABLE posts;"));
 }
 
+void TestDatabaseMigrator::createChunkedRows(int count)
+{
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("DROP TABLE IF EXISTS chunked_rows"));
+    QVERIFY(query.exec("CREATE TABLE chunked_rows (id INTEGER PRIMARY KEY, n INTEGER DEFAULT 0)"));
+    
+    QVERIFY(m_database.transaction());
+    query.prepare("INSERT INTO chunked_rows (id) VALUES (?)");
+    for (int id = 1; id <= count; ++id) {
+        query.addBindValue(id);
+        QVERIFY(query.exec());
+    }
+    QVERIFY(m_database.commit());
+}
+
+Migration TestDatabaseMigrator::createChunkedMigration(const QString& version)
+{
+    Migration migration = createValidMigration(version, "Count chunked rows",
+        "UPDATE chunked_rows SET n = n + 1 WHERE rowid >= :from AND rowid < :to;",
+        "UPDATE chunked_rows SET n = 0;");
+    migration.chunkTable = "chunked_rows";
+    migration.chunkSize = 100;
+    return migration;
+}
+
 void TestDatabaseMigrator::testInitialize()
 {
     bool result = m_migrator->initialize();
@@ -266,6 +291,79 @@ void TestDatabaseMigrator::testMigrateToInvalidVersion()
     QCOMPARE(result.appliedCount, 3);
 }
 
+void TestDatabaseMigrator::testChunkedMigration()
+{
+    QVERIFY(m_migrator->initialize());
+    createChunkedRows(250);
+    QVERIFY(m_migrator->addMigration(createChunkedMigration("201")));
+    
+    Migration unchunked = createChunkedMigration("202");
+    unchunked.upSql = "UPDATE chunked_rows SET n = n + 1;";
+    QVERIFY(!m_migrator->addMigration(unchunked)); // No :from and :to
+    
+    QSignalSpy progressSpy(m_migrator.get(), &DatabaseMigrator::migrationProgress);
+    DatabaseMigrator::MigrationResult result = m_migrator->migrate();
+    
+    QVERIFY(result.success);
+    QCOMPARE(result.appliedCount, 1);
+    QVERIFY(m_migrator->isMigrationApplied("201"));
+    
+    // One commit per chunk of 100 rowids
+    QCOMPARE(progressSpy.count(), 3);
+    QCOMPARE(progressSpy.at(0).at(1).toLongLong(), 100);
+    QCOMPARE(progressSpy.at(2).at(1).toLongLong(), 250);
+    QCOMPARE(progressSpy.at(2).at(2).toLongLong(), 250);
+    
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("SELECT MIN(n), MAX(n) FROM chunked_rows"));
+    QVERIFY(query.next());
+    QCOMPARE(query.value(0).toInt(), 1);
+    QCOMPARE(query.value(1).toInt(), 1);
+    
+    QVERIFY(query.exec("SELECT COUNT(*) FROM schema_migration_progress"));
+    QVERIFY(query.next());
+    QCOMPARE(query.value(0).toInt(), 0);
+}
+
+void TestDatabaseMigrator::testChunkedMigrationResumes()
+{
+    QVERIFY(m_migrator->initialize());
+    createChunkedRows(250);
+    QVERIFY(m_migrator->addMigration(createChunkedMigration("203")));
+    
+    // The second chunk fails; the first stays committed
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("CREATE TRIGGER chunked_rows_fail BEFORE UPDATE ON chunked_rows "
+                       "WHEN OLD.id = 150 BEGIN SELECT RAISE(ABORT, 'blocked'); END"));
+    
+    DatabaseMigrator::MigrationResult result = m_migrator->migrate();
+    QVERIFY(!result.success);
+    QCOMPARE(result.failedMigrations, QStringList({"203"}));
+    QVERIFY(!m_migrator->isMigrationApplied("203"));
+    
+    QVERIFY(query.exec("SELECT COUNT(*) FROM chunked_rows WHERE n = 1"));
+    QVERIFY(query.next());
+    QCOMPARE(query.value(0).toInt(), 100);
+    QVERIFY(query.exec("SELECT next_rowid FROM schema_migration_progress WHERE version = '203'"));
+    QVERIFY(query.next());
+    QCOMPARE(query.value(0).toLongLong(), 101);
+    
+    // The next run carries on from the checkpoint without redoing the first chunk
+    QVERIFY(query.exec("DROP TRIGGER chunked_rows_fail"));
+    QSignalSpy progressSpy(m_migrator.get(), &DatabaseMigrator::migrationProgress);
+    result = m_migrator->migrate();
+    
+    QVERIFY(result.success);
+    QVERIFY(m_migrator->isMigrationApplied("203"));
+    QCOMPARE(progressSpy.count(), 2);
+    QCOMPARE(progressSpy.at(0).at(1).toLongLong(), 200);
+    
+    QVERIFY(query.exec("SELECT MIN(n), MAX(n) FROM chunked_rows"));
+    QVERIFY(query.next());
+    QCOMPARE(query.value(0).toInt(), 1);
+    QCOMPARE(query.value(1).toInt(), 1);
+}
+
 void TestDatabaseMigrator::testRollback()
 {
     QVERIFY(m_migrator->initialize());
@@ -43,6 +43,8 @@ private slots:
     void testMigrateEmpty();
     void testMigrateTo();
     void testMigrateToInvalidVersion();
+    void testChunkedMigration();
+    void testChunkedMigrationResumes();
 
     // Rollback functionality
     void testRollback();
@@ -87,6 +89,8 @@ private:
                                   const QString& upSql = "CREATE TABLE test_table (id INTEGER);",
                                   const QString& downSql = "DROP TABLE test_table;");
     void insertTestMigrations();
+    void createChunkedRows(int count);
+    Migration createChunkedMigration(const QString& version);
 
     std::unique_ptr<DatabaseMigrator> m_migrator;
     QSqlDatabase m_database;
@@ -465,6 +465,48 @@ void TestGenreRepository::testGetAllGenreNames()
     QVERIFY(names.contains("Modern"));
 }
 
+void TestGenreRepository::testCompleteGenres()
+{
+    insertTestData();
+    QVERIFY(m_repository->addGenre(createValidGenreItem("Progressive Rock", 1)));
+    QVERIFY(m_repository->addGenre(createValidGenreItem("pop", 2)));
+    
+    QCOMPARE(m_repository->completeGenres("p", 0), QStringList({"Pop", "pop", "Progressive Rock"}));
+    QCOMPARE(m_repository->completeGenres("P", 1), QStringList({"Pop", "Progressive Rock"}));
+    QCOMPARE(m_repository->completeGenres("  cla", 2), QStringList({"Classic"}));
+    QCOMPARE(m_repository->completeGenres("p", 0, 1), QStringList({"Pop"}));
+    QVERIFY(m_repository->completeGenres("z", 0).isEmpty());
+    QCOMPARE(m_repository->completeGenres("", 2).size(), 3);
+}
+
+void TestGenreRepository::testNameIndexFollowsWrites()
+{
+    insertTestData();
+    QVERIFY(m_repository->genreExists("Rock", 1));
+    QVERIFY(!m_repository->genreExists("rock", 1));
+    
+    // Written through the repository: seen at once
+    QVERIFY(m_repository->addGenre(createValidGenreItem("Blues", 1)));
+    QVERIFY(m_repository->genreExists("Blues", 1));
+    QVERIFY(!m_repository->addGenre(createValidGenreItem(" Blues ", 1)));
+    
+    GenreItem renamed = m_repository->getGenreById(1, 1);
+    renamed.name = "Hard Rock";
+    QVERIFY(m_repository->updateGenre(renamed));
+    QVERIFY(!m_repository->genreExists("Rock", 1));
+    QVERIFY(m_repository->genreExists("Hard Rock", 1));
+    
+    QVERIFY(m_repository->deleteGenre(renamed.id, 1));
+    QVERIFY(!m_repository->genreExists("Hard Rock", 1));
+    
+    // Written past it: seen after reloadNames()
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("INSERT INTO genres2 (name) VALUES ('Ambient')"));
+    QVERIFY(!m_repository->genreExists("Ambient", 2));
+    m_repository->reloadNames();
+    QVERIFY(m_repository->genreExists("Ambient", 2));
+}
+
 void TestGenreRepository::testValidateGenreItem()
 {
     GenreItem validGenre = createValidGenreItem("Valid Genre", 1);
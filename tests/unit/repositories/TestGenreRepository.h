@@ -57,6 +57,8 @@ private slots:
     void testGenreExists();
     void testGetStatistics();
     void testGetAllGenreNames();
+    void testCompleteGenres();
+    void testNameIndexFollowsWrites();
     void testValidateGenreItem();
 
     // Error handling
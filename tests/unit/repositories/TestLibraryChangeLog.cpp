@@ -0,0 +1,271 @@
+#include "TestLibraryChangeLog.h"
+#include "../../../src/repositories/LibraryChangeLog.h"
+#include <QJsonArray>
+#include <QSqlError>
+#include <QSqlQuery>
+
+namespace {
+
+const QString SOURCE = "http://studio-a:9106";
+
+QSqlDatabase openLibrary(const QString& connection)
+{
+    QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", connection);
+    database.setDatabaseName(":memory:");
+    if (!database.open()) {
+        return database;
+    }
+    QSqlQuery query(database);
+    query.exec("CREATE TABLE musics (id INTEGER PRIMARY KEY AUTOINCREMENT, "
+               "artist TEXT NOT NULL, song TEXT NOT NULL, genre1 TEXT NOT NULL, genre2 TEXT, "
+               "country TEXT, published_date TEXT, path TEXT, time TEXT, "
+               "played_times INTEGER DEFAULT 0, last_played TEXT)");
+    query.exec("CREATE TABLE jingles (name TEXT, path TEXT)");
+    query.exec("CREATE TABLE genres1 (id INTEGER PRIMARY KEY AUTOINCREMENT, name TEXT)");
+    query.exec("CREATE TABLE genres2 (id INTEGER PRIMARY KEY AUTOINCREMENT, name TEXT)");
+    return database;
+}
+
+bool exec(QSqlDatabase& database, const QString& sql)
+{
+    QSqlQuery query(database);
+    if (!query.exec(sql)) {
+        qWarning() << query.lastError().text() << sql;
+        return false;
+    }
+    return true;
+}
+
+void addTrack(QSqlDatabase& database, const QString& artist, const QString& path)
+{
+    QSqlQuery query(database);
+    query.prepare("INSERT INTO musics (artist, song, genre1, path, time) "
+                  "VALUES (?, 'Song', 'Pop', ?, '03:30')");
+    query.addBindValue(artist);
+    query.addBindValue(path);
+    QVERIFY2(query.exec(), qPrintable(query.lastError().text()));
+}
+
+QJsonObject table(const QJsonObject& delta, const QString& name)
+{
+    return delta.value("tables").toObject().value(name).toObject();
+}
+
+/// Paths of the musics rows of a delta
+QStringList paths(const QJsonObject& delta)
+{
+    const QJsonObject musics = table(delta, "musics");
+    const int column = musics.value("columns").toArray().toVariantList().indexOf(QVariant("path"));
+    QStringList result;
+    for (const QJsonValue& row : musics.value("rows").toArray()) {
+        result.append(row.toArray().at(column).toString());
+    }
+    return result;
+}
+
+QVariant scalar(QSqlDatabase& database, const QString& sql)
+{
+    QSqlQuery query(database);
+    return query.exec(sql) && query.next() ? query.value(0) : QVariant();
+}
+
+} // namespace
+
+void TestLibraryChangeLog::init()
+{
+    m_primary = openLibrary("test_library_primary");
+    m_replica = openLibrary("test_library_replica");
+    QVERIFY(m_primary.isOpen());
+    QVERIFY(m_replica.isOpen());
+}
+
+void TestLibraryChangeLog::cleanup()
+{
+    m_primary.close();
+    m_replica.close();
+    m_primary = QSqlDatabase();
+    m_replica = QSqlDatabase();
+    QSqlDatabase::removeDatabase("test_library_primary");
+    QSqlDatabase::removeDatabase("test_library_replica");
+}
+
+void TestLibraryChangeLog::testEnsureSeedsExistingRows()
+{
+    addTrack(m_primary, "Before", "/music/before.mp3");
+    QVERIFY(exec(m_primary, "INSERT INTO genres1 (name) VALUES ('Pop')"));
+
+    LibraryChangeLog log(m_primary);
+    QVERIFY(log.ensure());
+    QVERIFY(log.ensure());   // Once only
+    QVERIFY(!log.logId().isEmpty());
+    QCOMPARE(log.latestSeq(), qint64(2));
+
+    const QJsonObject delta = log.changesSince(0);
+    QCOMPARE(paths(delta), QStringList({"/music/before.mp3"}));
+    QCOMPARE(table(delta, "genres1").value("rows").toArray(), QJsonArray({QJsonArray({"Pop"})}));
+    QCOMPARE(delta.value("log").toString(), log.logId());
+    QCOMPARE(delta.value("more").toBool(), false);
+}
+
+void TestLibraryChangeLog::testKeyChangedTwiceLoggedOnce()
+{
+    LibraryChangeLog log(m_primary);
+    QVERIFY(log.ensure());
+    addTrack(m_primary, "First", "/music/a.mp3");
+    addTrack(m_primary, "Other", "/music/b.mp3");
+    const qint64 seen = log.latestSeq();
+
+    QVERIFY(exec(m_primary, "UPDATE musics SET artist = 'Second' WHERE path = '/music/a.mp3'"));
+    QVERIFY(exec(m_primary, "UPDATE musics SET artist = 'Third' WHERE path = '/music/a.mp3'"));
+
+    QCOMPARE(scalar(m_primary, "SELECT COUNT(*) FROM library_changes").toInt(), 2);
+    const QJsonObject delta = log.changesSince(seen);
+    QCOMPARE(paths(delta), QStringList({"/music/a.mp3"}));
+    QCOMPARE(table(delta, "musics").value("rows").toArray().at(0).toArray().at(0).toString(),
+             QString("Third"));
+}
+
+void TestLibraryChangeLog::testPlayCountsNotLogged()
+{
+    LibraryChangeLog log(m_primary);
+    QVERIFY(log.ensure());
+    addTrack(m_primary, "Artist", "/music/a.mp3");
+    const qint64 seen = log.latestSeq();
+
+    QVERIFY(exec(m_primary, "UPDATE musics SET played_times = played_times + 1, "
+                            "last_played = '2026-01-01'"));
+    // Writing the same values is not a change either
+    QVERIFY(exec(m_primary, "UPDATE musics SET artist = 'Artist'"));
+
+    QCOMPARE(log.latestSeq(), seen);
+}
+
+void TestLibraryChangeLog::testDeleteAndKeyChange()
+{
+    LibraryChangeLog log(m_primary);
+    QVERIFY(log.ensure());
+    addTrack(m_primary, "Gone", "/music/gone.mp3");
+    addTrack(m_primary, "Moved", "/music/old.mp3");
+    const qint64 seen = log.latestSeq();
+
+    QVERIFY(exec(m_primary, "DELETE FROM musics WHERE path = '/music/gone.mp3'"));
+    QVERIFY(exec(m_primary, "UPDATE musics SET path = '/music/new.mp3' "
+                            "WHERE path = '/music/old.mp3'"));
+
+    const QJsonObject delta = log.changesSince(seen);
+    QCOMPARE(paths(delta), QStringList({"/music/new.mp3"}));
+    QCOMPARE(table(delta, "musics").value("deleted").toArray(),
+             QJsonArray({"/music/gone.mp3", "/music/old.mp3"}));
+}
+
+void TestLibraryChangeLog::testBatches()
+{
+    LibraryChangeLog log(m_primary);
+    QVERIFY(log.ensure());
+    for (int i = 0; i < 5; ++i) {
+        addTrack(m_primary, "Artist", QString("/music/%1.mp3").arg(i));
+    }
+
+    QJsonObject delta = log.changesSince(0, 2);
+    QCOMPARE(paths(delta), QStringList({"/music/0.mp3", "/music/1.mp3"}));
+    QCOMPARE(delta.value("more").toBool(), true);
+
+    delta = log.changesSince(delta.value("to").toVariant().toLongLong(), 2);
+    QCOMPARE(paths(delta), QStringList({"/music/2.mp3", "/music/3.mp3"}));
+
+    delta = log.changesSince(delta.value("to").toVariant().toLongLong(), 2);
+    QCOMPARE(paths(delta), QStringList({"/music/4.mp3"}));
+    QCOMPARE(delta.value("more").toBool(), false);
+
+    delta = log.changesSince(delta.value("to").toVariant().toLongLong(), 2);
+    QVERIFY(delta.value("tables").toObject().isEmpty());
+}
+
+void TestLibraryChangeLog::testApplyToReplica()
+{
+    LibraryChangeLog log(m_primary);
+    QVERIFY(log.ensure());
+    addTrack(m_primary, "New", "/music/new.mp3");
+    addTrack(m_primary, "Changed", "/music/both.mp3");
+    QVERIFY(exec(m_primary, "INSERT INTO jingles (name, path) VALUES ('Id', '/jingles/id.mp3')"));
+    QVERIFY(exec(m_primary, "INSERT INTO genres2 (name) VALUES ('Dance')"));
+
+    addTrack(m_replica, "Stale", "/music/both.mp3");
+    addTrack(m_replica, "Deleted", "/music/deleted.mp3");
+    QVERIFY(exec(m_replica, "UPDATE musics SET played_times = 9"));
+
+    // Deleted on the primary after the replica had it
+    addTrack(m_primary, "Deleted", "/music/deleted.mp3");
+    QVERIFY(exec(m_primary, "DELETE FROM musics WHERE path = '/music/deleted.mp3'"));
+
+    LibraryChangeLog replica(m_replica);
+    QCOMPARE(replica.applyChanges(SOURCE, log.changesSince(0)), 5);
+
+    QCOMPARE(scalar(m_replica, "SELECT artist FROM musics WHERE path = '/music/both.mp3'")
+                 .toString(),
+             QString("Changed"));
+    // Play counts stay the studio's own
+    QCOMPARE(scalar(m_replica, "SELECT played_times FROM musics WHERE path = '/music/both.mp3'")
+                 .toInt(),
+             9);
+    QCOMPARE(scalar(m_replica, "SELECT played_times FROM musics WHERE path = '/music/new.mp3'")
+                 .toInt(),
+             0);
+    QCOMPARE(scalar(m_replica, "SELECT COUNT(*) FROM musics WHERE path = '/music/deleted.mp3'")
+                 .toInt(),
+             0);
+    QCOMPARE(scalar(m_replica, "SELECT name FROM jingles").toString(), QString("Id"));
+    QCOMPARE(scalar(m_replica, "SELECT name FROM genres2").toString(), QString("Dance"));
+
+    QString logId;
+    QCOMPARE(replica.cursor(SOURCE, &logId), log.latestSeq());
+    QCOMPARE(logId, log.logId());
+
+    // The same batch again changes nothing new
+    QCOMPARE(replica.applyChanges(SOURCE, log.changesSince(0)), 3);
+    QCOMPARE(scalar(m_replica, "SELECT COUNT(*) FROM genres2").toInt(), 1);
+    QCOMPARE(scalar(m_replica, "SELECT COUNT(*) FROM musics").toInt(), 2);
+}
+
+void TestLibraryChangeLog::testApplyMapsPaths()
+{
+    LibraryChangeLog log(m_primary);
+    QVERIFY(log.ensure());
+    addTrack(m_primary, "Artist", "/srv/music/a.mp3");
+    addTrack(m_primary, "Other", "/elsewhere/b.mp3");
+
+    LibraryChangeLog replica(m_replica);
+    QVERIFY(replica.applyChanges(SOURCE, log.changesSince(0), "/srv/music/", "M:/Music/") > 0);
+    QCOMPARE(scalar(m_replica, "SELECT COUNT(*) FROM musics WHERE path = 'M:/Music/a.mp3'")
+                 .toInt(),
+             1);
+    QCOMPARE(scalar(m_replica, "SELECT COUNT(*) FROM musics WHERE path = '/elsewhere/b.mp3'")
+                 .toInt(),
+             1);
+
+    const qint64 seen = log.latestSeq();
+    QVERIFY(exec(m_primary, "DELETE FROM musics WHERE path = '/srv/music/a.mp3'"));
+    QCOMPARE(replica.applyChanges(SOURCE, log.changesSince(seen), "/srv/music/", "M:/Music/"), 1);
+    QCOMPARE(scalar(m_replica, "SELECT COUNT(*) FROM musics").toInt(), 1);
+}
+
+void TestLibraryChangeLog::testApplyFailureKeepsCursor()
+{
+    LibraryChangeLog log(m_primary);
+    QVERIFY(log.ensure());
+    addTrack(m_primary, "Good", "/music/good.mp3");
+    QVERIFY(exec(m_primary, "INSERT INTO genres1 (name) VALUES ('Rock')"));
+
+    // The genres apply first; the musics of this replica lack a column
+    QVERIFY(exec(m_replica, "DROP TABLE musics"));
+    QVERIFY(exec(m_replica, "CREATE TABLE musics (artist TEXT, song TEXT, path TEXT)"));
+
+    LibraryChangeLog replica(m_replica);
+    QCOMPARE(replica.applyChanges(SOURCE, log.changesSince(0)), -1);
+    QCOMPARE(scalar(m_replica, "SELECT COUNT(*) FROM genres1").toInt(), 0);
+    QCOMPARE(replica.cursor(SOURCE), qint64(0));
+
+    QCOMPARE(replica.applyChanges(SOURCE, QJsonObject{{"from", 0}}), -1);
+}
+
+QTEST_MAIN(TestLibraryChangeLog)
@@ -0,0 +1,41 @@
+#ifndef TESTLIBRARYCHANGELOG_H
+#define TESTLIBRARYCHANGELOG_H
+
+#include <QObject>
+#include <QSqlDatabase>
+#include <QTest>
+
+/**
+ * @brief Unit tests for LibraryChangeLog class
+ *
+ * Tests the library change feed including:
+ * - Seeding a new log with the existing rows
+ * - One entry per changed key, and play counts left out
+ * - Deletes, and key changes logged as a delete and an insert
+ * - Batches with a limit and the "more" flag
+ * - Applying deltas on a replica, with path mapping and the cursor
+ * - A failing batch applying nothing
+ */
+class TestLibraryChangeLog : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testEnsureSeedsExistingRows();
+    void testKeyChangedTwiceLoggedOnce();
+    void testPlayCountsNotLogged();
+    void testDeleteAndKeyChange();
+    void testBatches();
+    void testApplyToReplica();
+    void testApplyMapsPaths();
+    void testApplyFailureKeepsCursor();
+
+private:
+    QSqlDatabase m_primary;
+    QSqlDatabase m_replica;
+};
+
+#endif // TESTLIBRARYCHANGELOG_H
@@ -0,0 +1,184 @@
+#include "TestLibraryRoots.h"
+#include "../../../src/repositories/LibraryRoots.h"
+#include <QSqlError>
+#include <QSqlQuery>
+
+namespace {
+
+void addTrack(QSqlDatabase& database, const QString& path)
+{
+    QSqlQuery query(database);
+    query.prepare("INSERT INTO musics (artist, song, genre1, path, time) "
+                  "VALUES ('Artist', 'Song', 'Pop', ?, '03:30')");
+    query.addBindValue(path);
+    QVERIFY2(query.exec(), qPrintable(query.lastError().text()));
+}
+
+/// root_id, rel_path and path_hash of the track at a path
+QVariantList location(QSqlDatabase& database, const QString& path)
+{
+    QSqlQuery query(database);
+    query.prepare("SELECT root_id, rel_path, path_hash FROM musics WHERE path = ?");
+    query.addBindValue(path);
+    if (!query.exec() || !query.next()) {
+        return QVariantList();
+    }
+    return {query.value(0), query.value(1), query.value(2)};
+}
+
+} // namespace
+
+void TestLibraryRoots::init()
+{
+    m_database = QSqlDatabase::addDatabase("QSQLITE", "test_library_roots");
+    m_database.setDatabaseName(":memory:");
+    QVERIFY(m_database.open());
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("CREATE TABLE musics (id INTEGER PRIMARY KEY AUTOINCREMENT, "
+                       "artist TEXT NOT NULL, song TEXT NOT NULL, genre1 TEXT NOT NULL, "
+                       "genre2 TEXT, country TEXT, published_date TEXT, path TEXT, time TEXT, "
+                       "played_times INTEGER DEFAULT 0, last_played TEXT)"));
+}
+
+void TestLibraryRoots::cleanup()
+{
+    m_database.close();
+    m_database = QSqlDatabase();
+    QSqlDatabase::removeDatabase("test_library_roots");
+}
+
+void TestLibraryRoots::testHashPath()
+{
+    // The FNV-1a reference values; stored hashes must not change between releases
+    QCOMPARE(quint64(LibraryRoots::hashPath(QString())), 0xcbf29ce484222325ULL);
+    QCOMPARE(quint64(LibraryRoots::hashPath("a")), 0xaf63dc4c8601ec8cULL);
+    QVERIFY(LibraryRoots::hashPath("rock/a.ogg") != LibraryRoots::hashPath("rock/b.ogg"));
+
+    QCOMPARE(LibraryRoots::normalizedRoot("/srv/music"), QString("/srv/music/"));
+    QCOMPARE(LibraryRoots::normalizedRoot("/srv/music//"), QString("/srv/music/"));
+    QVERIFY(LibraryRoots::normalizedRoot("  ").isEmpty());
+}
+
+void TestLibraryRoots::testEnsureLocatesExistingTracks()
+{
+    addTrack(m_database, "/srv/music/a.ogg");
+    addTrack(m_database, "/srv/music/b.ogg");
+
+    LibraryRoots roots(m_database);
+    QVERIFY(!roots.isReady());
+    QVERIFY(roots.ensure());
+    QVERIFY(roots.roots().isEmpty());
+
+    // Outside every root, a track keeps its whole path
+    const QString path = "/srv/music/a.ogg";
+    QCOMPARE(location(m_database, path),
+             QVariantList({LibraryRoots::NO_ROOT, path, LibraryRoots::hashPath(path)}));
+    QCOMPARE(roots.backfill(), 0);
+
+    // A second run finds everything in place
+    LibraryRoots again(m_database);
+    QVERIFY(again.ensure());
+}
+
+void TestLibraryRoots::testAddRoot()
+{
+    addTrack(m_database, "/srv/music/rock/a.ogg");
+    addTrack(m_database, "/home/dj/b.ogg");
+    LibraryRoots roots(m_database);
+    QVERIFY(roots.ensure());
+
+    const int music = roots.addRoot("/srv/music");
+    QVERIFY(music > LibraryRoots::NO_ROOT);
+    QCOMPARE(roots.roots().value(music), QString("/srv/music/"));
+    QCOMPARE(location(m_database, "/srv/music/rock/a.ogg"),
+             QVariantList({music, "rock/a.ogg", LibraryRoots::hashPath("rock/a.ogg")}));
+    QCOMPARE(location(m_database, "/home/dj/b.ogg").at(0).toInt(), LibraryRoots::NO_ROOT);
+
+    // A directory inside a root belongs to it
+    QCOMPARE(roots.addRoot("/srv/music/rock"), music);
+    QCOMPARE(roots.roots().size(), 1);
+
+    const LibraryRoots::Location located = roots.locate("/srv/music/pop/c.ogg");
+    QCOMPARE(located.rootId, music);
+    QCOMPARE(located.relativePath, QString("pop/c.ogg"));
+    QCOMPARE(located.hash, LibraryRoots::hashPath("pop/c.ogg"));
+}
+
+void TestLibraryRoots::testRootsOfOtherInstances()
+{
+    // The player's repository and the play history writer's, on one library
+    LibraryRoots player(m_database);
+    QVERIFY(player.ensure());
+    LibraryRoots history(m_database);
+    QVERIFY(history.ensure());
+    QVERIFY(!history.refresh());
+
+    const int music = player.addRoot("/srv/music");
+    QVERIFY(history.refresh());
+    QCOMPARE(history.locate("/srv/music/a.ogg").rootId, music);
+    QCOMPARE(history.roots(), player.roots());
+    QVERIFY(!history.refresh());
+
+    QVERIFY(player.relocateRoot(music, "/mnt/music"));
+    QVERIFY(history.refresh());
+    QCOMPARE(history.locate("/mnt/music/a.ogg").rootId, music);
+
+    // A root added by another process is only seen once read again
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("INSERT INTO library_roots (path) VALUES ('/srv/jingles/')"));
+    const int jingles = query.lastInsertId().toInt();
+    QCOMPARE(history.locate("/srv/jingles/ident.ogg").rootId, LibraryRoots::NO_ROOT);
+    QVERIFY(history.reload());
+    QCOMPARE(history.locate("/srv/jingles/ident.ogg").rootId, jingles);
+    QVERIFY(!history.reload());
+}
+
+void TestLibraryRoots::testRelocateRoot()
+{
+    LibraryRoots roots(m_database);
+    QVERIFY(roots.ensure());
+    const int jingles = roots.addRoot("/srv/music/jingles");
+    const int music = roots.addRoot("/srv/music");
+    addTrack(m_database, "/srv/music/rock/a.ogg");
+    addTrack(m_database, "/srv/music/jingles/ident.ogg");
+    QCOMPARE(roots.backfill(), 2);
+    const QVariantList before = location(m_database, "/srv/music/rock/a.ogg");
+    const QVariantList jingle = location(m_database, "/srv/music/jingles/ident.ogg");
+    QCOMPARE(jingle.at(0).toInt(), jingles);
+
+    QVERIFY(roots.relocateRoot(music, "/mnt/nas/music"));
+    QCOMPARE(roots.roots().value(music), QString("/mnt/nas/music/"));
+    QCOMPARE(roots.roots().value(jingles), QString("/mnt/nas/music/jingles/"));
+
+    // Only the absolute paths change; each location is as it was
+    QCOMPARE(location(m_database, "/mnt/nas/music/rock/a.ogg"), before);
+    QCOMPARE(location(m_database, "/mnt/nas/music/jingles/ident.ogg"), jingle);
+    QVERIFY(location(m_database, "/srv/music/rock/a.ogg").isEmpty());
+
+    QVERIFY(!roots.relocateRoot(LibraryRoots::NO_ROOT, "/mnt"));
+    // Two roots cannot share a directory; nothing changes then
+    QVERIFY(!roots.relocateRoot(jingles, "/mnt/nas/music"));
+    QCOMPARE(roots.roots().value(jingles), QString("/mnt/nas/music/jingles/"));
+    QCOMPARE(location(m_database, "/mnt/nas/music/jingles/ident.ogg"), jingle);
+}
+
+void TestLibraryRoots::testPathChangeForgetsLocation()
+{
+    addTrack(m_database, "/srv/music/a.ogg");
+    LibraryRoots roots(m_database);
+    QVERIFY(roots.ensure());
+    roots.addRoot("/srv/music");
+
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("UPDATE musics SET path = '/srv/music/b.ogg'"));
+    const QVariantList forgotten = location(m_database, "/srv/music/b.ogg");
+    QCOMPARE(forgotten.size(), 3);
+    for (const QVariant& value : forgotten) {
+        QVERIFY(value.isNull());
+    }
+
+    QCOMPARE(roots.backfill(), 1);
+    QCOMPARE(location(m_database, "/srv/music/b.ogg").at(1).toString(), QString("b.ogg"));
+}
+
+QTEST_MAIN(TestLibraryRoots)
@@ -0,0 +1,38 @@
+#ifndef TESTLIBRARYROOTS_H
+#define TESTLIBRARYROOTS_H
+
+#include <QObject>
+#include <QSqlDatabase>
+#include <QTest>
+
+/**
+ * @brief Unit tests for LibraryRoots class
+ *
+ * Tests the library roots including:
+ * - A stable hash of relative paths
+ * - Locating the existing tracks when the columns are added
+ * - Adding a root, and a directory inside one
+ * - Roots added by another instance, in this process or another
+ * - Relocating a root with the roots inside it, hashes unchanged
+ * - Forgetting the location of a path changed by plain SQL
+ */
+class TestLibraryRoots : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testHashPath();
+    void testEnsureLocatesExistingTracks();
+    void testAddRoot();
+    void testRootsOfOtherInstances();
+    void testRelocateRoot();
+    void testPathChangeForgetsLocation();
+
+private:
+    QSqlDatabase m_database;
+};
+
+#endif // TESTLIBRARYROOTS_H
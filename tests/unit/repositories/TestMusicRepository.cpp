@@ -276,6 +276,33 @@ void TestMusicRepository::testDeleteMusicInvalidId()
     QCOMPARE(errorSpy.count(), 1);
 }
 
+void TestMusicRepository::testDeleteMusicBatch()
+{
+    insertTestData();
+    
+    QSignalSpy spy(m_repository.get(), &MusicRepository::musicDeleted);
+    QHash<int, QString> paths;
+    QCOMPARE(m_repository->deleteMusicBatch({3, 1, 3, 42}, &paths), 2);
+    QCOMPARE(spy.count(), 2);
+    QCOMPARE(paths.value(1), QString("/path/song1.mp3"));
+    QCOMPARE(paths.value(3), QString("/path/song3.mp3"));
+    QCOMPARE(paths.size(), 2);
+    
+    QVERIFY(!m_repository->getMusicById(1).isValid());
+    QVERIFY(m_repository->getMusicById(2).isValid());
+    QCOMPARE(m_repository->deleteMusicBatch({}), 0);
+    
+    // A failure leaves every track in place
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("CREATE TRIGGER keep_song2 BEFORE DELETE ON musics WHEN old.id = 2 "
+                       "BEGIN SELECT RAISE(ABORT, 'kept'); END"));
+    QVERIFY(m_repository->addMusic(createValidMusicItem()));
+    const int added = m_repository->getMusicIdByPath(m_testMusicFiles.first());
+    QCOMPARE(m_repository->deleteMusicBatch({added, 2}), -1);
+    QVERIFY(m_repository->getMusicById(added).isValid());
+    QVERIFY(m_repository->getMusicById(2).isValid());
+}
+
 void TestMusicRepository::testGetMusicById()
 {
     insertTestData();
@@ -325,6 +352,113 @@ void TestMusicRepository::testGetAllMusicWithLimitAndOffset()
     QCOMPARE(limitedMusic[1].song, QString("Song 2"));
 }
 
+void TestMusicRepository::testGetMusicAfter()
+{
+    insertTestData();
+    
+    QList<MusicItem> firstPage = m_repository->getMusicAfter({}, -1, 2);
+    QCOMPARE(firstPage.size(), 2);
+    QCOMPARE(firstPage[0].song, QString("Song 1"));
+    QCOMPARE(firstPage[1].song, QString("Song 3"));
+    
+    const MusicItem& last = firstPage.last();
+    QList<MusicItem> secondPage = m_repository->getMusicAfter(MusicRepository::sortKeyOf(last), last.id, 2);
+    QCOMPARE(secondPage.size(), 1);
+    QCOMPARE(secondPage[0].song, QString("Song 2"));
+    
+    // Same artist and song on two rows: the id keeps them apart
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("INSERT INTO musics (artist, song, genre1, path) "
+                       "VALUES ('Artist B', 'Song 2', 'Pop', '/path/song2-live.mp3')"));
+    
+    QList<MusicItem> thirdPage = m_repository->getMusicAfter(MusicRepository::sortKeyOf(secondPage[0]),
+                                                             secondPage[0].id, 2);
+    QCOMPARE(thirdPage.size(), 1);
+    QCOMPARE(thirdPage[0].path, QString("/path/song2-live.mp3"));
+    
+    QVERIFY(m_repository->getMusicAfter(MusicRepository::sortKeyOf(thirdPage[0]), thirdPage[0].id, 2).isEmpty());
+}
+
+void TestMusicRepository::testForEachMusicStopsEarly()
+{
+    insertTestData();
+    
+    QStringList songs;
+    int visited = m_repository->forEachMusic([&songs](const MusicItem& item) {
+        songs.append(item.song);
+        return songs.size() < 2;
+    });
+    
+    QCOMPARE(visited, 2);
+    QCOMPARE(songs, QStringList({"Song 1", "Song 3"}));
+}
+
+void TestMusicRepository::testGetMusicPage()
+{
+    insertTestData();
+    
+    QList<MusicItem> page = m_repository->getMusicPage("genre1 = ?", {"Rock"}, "song DESC", 1, 0);
+    QCOMPARE(page.size(), 1);
+    QCOMPARE(page[0].song, QString("Song 3"));
+    
+    page = m_repository->getMusicPage("genre1 = ?", {"Rock"}, "song DESC", 10, 1);
+    QCOMPARE(page.size(), 1);
+    QCOMPARE(page[0].song, QString("Song 1"));
+    
+    // Rows that tie on the sort column come back in id order
+    page = m_repository->getMusicPage(QString(), {}, "artist ASC", 10, 0);
+    QCOMPARE(page.size(), 3);
+    QCOMPARE(page[0].song, QString("Song 1"));
+    QCOMPARE(page[1].song, QString("Song 3"));
+    QCOMPARE(page[2].song, QString("Song 2"));
+    
+    QCOMPARE(m_repository->countMusic(), 3);
+    QCOMPARE(m_repository->countMusic("genre1 = ?", {"Rock"}), 2);
+    
+    // Bound values are never read as SQL
+    QCOMPARE(m_repository->countMusic("genre1 = ?", {"Rock' OR '1'='1"}), 0);
+    
+    // A caller's own connection sees the same rows
+    {
+        QSqlDatabase own = QSqlDatabase::addDatabase("QSQLITE", "test_music_page_connection");
+        own.setDatabaseName(m_databasePath);
+        QVERIFY(own.open());
+        page = m_repository->getMusicPage("genre1 = ?", {"Pop"}, QString(), 10, 0, own);
+        QCOMPARE(page.size(), 1);
+        QCOMPARE(page[0].artist, QString("Artist B"));
+        own.close();
+    }
+    QSqlDatabase::removeDatabase("test_music_page_connection");
+}
+
+void TestMusicRepository::testRangeFilters()
+{
+    insertTestData();
+    
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("INSERT INTO musics (artist, song, genre1, time) VALUES ('Artist C', 'Long', 'Jazz', '1:02:03')"));
+    QVERIFY(query.exec("INSERT INTO musics (artist, song, genre1, time) VALUES ('Artist C', 'Unknown', 'Jazz', 'n/a')"));
+    
+    const QString duration = MusicRepository::durationSecondsSql();
+    QCOMPARE(m_repository->countMusic(duration + " >= ?", {200}), 3);   // 3:30, 4:15, 1:02:03
+    QCOMPARE(m_repository->countMusic(duration + " <= ?", {210}), 2);   // 3:30, 2:45
+    QCOMPARE(m_repository->countMusic(duration + " = ?", {3723}), 1);
+    QCOMPARE(m_repository->countMusic("played_times >= ?", {5}), 2);
+    QCOMPARE(m_repository->countMusic("last_played >= ? AND last_played < ?", {"2023-01-02", "2023-01-03"}), 1);
+    
+    // countMusic() created the indexes, and the filters use them
+    for (const QString& condition : {duration + " >= 200", QString("played_times >= 5"),
+                                     QString("last_played >= '2023-01-02'")}) {
+        QVERIFY(query.exec("EXPLAIN QUERY PLAN SELECT COUNT(*) FROM musics WHERE " + condition));
+        QString plan;
+        while (query.next()) {
+            plan += query.value(3).toString() + "\n";
+        }
+        QVERIFY2(plan.contains("USING COVERING INDEX idx_musics_") || plan.contains("USING INDEX idx_musics_"),
+                 qPrintable(plan));
+    }
+}
+
 void TestMusicRepository::testSearchMusic()
 {
     insertTestData();
@@ -355,6 +489,51 @@ void TestMusicRepository::testSearchMusicWithCriteria()
     QCOMPARE(results[0].country, QString("USA"));
 }
 
+void TestMusicRepository::testFullTextSearch()
+{
+    insertTestData();
+    
+    if (!m_repository->isFullTextSearchAvailable()) {
+        QSKIP("SQLite was built without FTS5");
+    }
+    
+    MusicRepository::SearchCriteria criteria;
+    criteria.fullText = true;
+    
+    // Existing rows are indexed when the index is created
+    criteria.searchText = "art son 3";
+    QList<MusicItem> results = m_repository->searchMusic(criteria);
+    QCOMPARE(results.size(), 1);
+    QCOMPARE(results[0].song, QString("Song 3"));
+    
+    // Rows written afterwards are picked up by the triggers
+    MusicItem music = createValidMusicItem();
+    music.artist = "Sigur Rós";
+    QVERIFY(m_repository->addMusic(music));
+    
+    criteria.searchText = "sigur ros";
+    results = m_repository->searchMusic(criteria);
+    QCOMPARE(results.size(), 1);
+    
+    MusicItem stored = results[0];
+    stored.artist = "Mogwai";
+    QVERIFY(m_repository->updateMusic(stored));
+    QVERIFY(m_repository->searchMusic(criteria).isEmpty());
+    
+    criteria.searchText = "mog";
+    QCOMPARE(m_repository->searchMusic(criteria).size(), 1);
+    
+    QVERIFY(m_repository->deleteMusic(stored.id));
+    QVERIFY(m_repository->searchMusic(criteria).isEmpty());
+}
+
+void TestMusicRepository::testFullTextQuery()
+{
+    QCOMPARE(MusicRepository::fullTextQuery("beat  yel"), QString("\"beat\"* \"yel\"*"));
+    QCOMPARE(MusicRepository::fullTextQuery("say \"hi\""), QString("\"say\"* \"\"\"hi\"\"\"*"));
+    QVERIFY(MusicRepository::fullTextQuery(" - ").isEmpty());
+}
+
 void TestMusicRepository::testGetMusicByGenre()
 {
     insertTestData();
@@ -377,6 +556,58 @@ void TestMusicRepository::testGetMusicByGenreWithGenre2()
     QCOMPARE(alternativeMusic[0].genre2, QString("Alternative"));
 }
 
+void TestMusicRepository::testRandomPathsByGenre()
+{
+    insertTestData();
+    
+    QCOMPARE(m_repository->countMusicByGenre("rock"), 2);
+    QCOMPARE(m_repository->countMusicByGenre("Jazz"), 0);
+    QCOMPARE(m_repository->countMusicByGenre("Ro%"), 0);
+    
+    QStringList paths = m_repository->getRandomPathsByGenre("Rock", 5);
+    paths.sort();
+    QCOMPARE(paths, QStringList({"/path/song1.mp3", "/path/song3.mp3"}));
+    
+    // The cached statement is bound afresh on the next call
+    QCOMPARE(m_repository->getRandomPathsByGenre("pop", 5), QStringList({"/path/song2.mp3"}));
+    QCOMPARE(m_repository->getRandomPathsByGenre("Rock", 1).size(), 1);
+    QVERIFY(m_repository->getRandomPathsByGenre("Rock", 0).isEmpty());
+    QVERIFY(m_repository->getRandomPathsByGenre("' OR 1=1 --", 5).isEmpty());
+}
+
+void TestMusicRepository::testGenreCondition()
+{
+    insertTestData();
+    
+    QVariantList values;
+    QVERIFY(m_repository->genreCondition(QString(), QString(), values).isEmpty());
+    QVERIFY(values.isEmpty());
+    
+    const QString condition = m_repository->genreCondition("rock", "classic", values);
+    QCOMPARE(values, QVariantList({"rock", "classic"}));
+    
+    QSqlQuery query(m_database);
+    query.prepare("SELECT path FROM musics WHERE " + condition);
+    for (const QVariant& value : values) {
+        query.addBindValue(value);
+    }
+    QVERIFY(query.exec());
+    QVERIFY(query.next());
+    QCOMPARE(query.value(0).toString(), QString("/path/song3.mp3"));
+    QVERIFY(!query.next());
+    
+    // The filter is answered from an index, not a scan of musics
+    query.prepare("EXPLAIN QUERY PLAN SELECT path FROM musics WHERE "
+                  + m_repository->genreCondition(QString(), "Alternative", values));
+    query.addBindValue(values.value(0));
+    QVERIFY(query.exec());
+    QString plan;
+    while (query.next()) {
+        plan += query.value(3).toString();
+    }
+    QVERIFY2(plan.contains("idx_musics_genre2"), qPrintable(plan));
+}
+
 void TestMusicRepository::testGetMusicByArtist()
 {
     insertTestData();
@@ -447,6 +678,79 @@ void TestMusicRepository::testAddMusicBatchWithDuplicates()
     QCOMPARE(result, 1);
 }
 
+void TestMusicRepository::testAddMusicBatchSkipsExistingPaths()
+{
+    QVERIFY(m_repository->addMusic(createValidMusicItem("Artist 1", "Song 1", m_testMusicFiles[0])));
+    
+    QSignalSpy addedSpy(m_repository.get(), &MusicRepository::musicAdded);
+    
+    QList<MusicItem> musicList;
+    musicList.append(createValidMusicItem("Artist 1", "Song 1", m_testMusicFiles[0])); // Already imported
+    musicList.append(createValidMusicItem("Artist 2", "Song 2", m_testMusicFiles[1]));
+    musicList.append(createValidMusicItem("Artist 3", "Song 3", m_testMusicFiles[2]));
+    
+    QCOMPARE(m_repository->addMusicBatch(musicList), 2);
+    QCOMPARE(addedSpy.count(), 2);
+    QCOMPARE(m_repository->getAllMusic().size(), 3);
+}
+
+void TestMusicRepository::testAddMusicBatchSkipsContentDuplicates()
+{
+    // Files 0 and 1 hold the same audio, as do 2 and 4; file 3 cannot be read
+    const QHash<QString, QString> hashes = {
+        {m_testMusicFiles[0], "aaaa"}, {m_testMusicFiles[1], "aaaa"},
+        {m_testMusicFiles[2], "bbbb"}, {m_testMusicFiles[4], "bbbb"}
+    };
+    m_repository->setContentHasher([hashes](const QString& filePath) {
+        return hashes.value(filePath);
+    });
+    
+    QCOMPARE(m_repository->addMusicBatch({createValidMusicItem("Artist 1", "Song 1", m_testMusicFiles[0])}), 1);
+    
+    QList<MusicItem> musicList;
+    musicList.append(createValidMusicItem("Artist 1", "Song 1 (Copy)", m_testMusicFiles[1])); // In the library
+    musicList.append(createValidMusicItem("Artist 2", "Song 2", m_testMusicFiles[2]));
+    musicList.append(createValidMusicItem("Artist 3", "Song 3", m_testMusicFiles[3]));
+    musicList.append(createValidMusicItem("Artist 2", "Song 2", m_testMusicFiles[4]));        // Earlier in the list
+    
+    QCOMPARE(m_repository->addMusicBatch(musicList), 2);
+    QCOMPARE(m_repository->getAllMusic().size(), 3);
+    
+    const MusicItem original = m_repository->findMusicByContentHash("aaaa");
+    QCOMPARE(original.path, m_testMusicFiles[0]);
+    QCOMPARE(original.contentHash, QString("aaaa"));
+    QCOMPARE(m_repository->findMusicByContentHash("bbbb").path, m_testMusicFiles[2]);
+    QCOMPARE(m_repository->findMusicByContentHash("cccc").id, -1);
+    
+    // Tracks that could not be hashed are left for a later scan
+    QCOMPARE(m_repository->getPathsWithoutContentHash(), QStringList{m_testMusicFiles[3]});
+}
+
+void TestMusicRepository::testFindContentDuplicates()
+{
+    QList<MusicItem> musicList;
+    for (int i = 0; i < 4; ++i) {
+        musicList.append(createValidMusicItem(QString("Artist %1").arg(i), "Song", m_testMusicFiles[i]));
+    }
+    QCOMPARE(m_repository->addMusicBatch(musicList), 4);
+    QCOMPARE(m_repository->getPathsWithoutContentHash().size(), 4);
+    QVERIFY(m_repository->findContentDuplicates().isEmpty());
+    
+    const QHash<QString, QString> hashes = {
+        {m_testMusicFiles[0], "aaaa"}, {m_testMusicFiles[1], "bbbb"},
+        {m_testMusicFiles[2], "aaaa"}, {m_testMusicFiles[3], "cccc"}
+    };
+    QCOMPARE(m_repository->setContentHashes(hashes), 4);
+    QVERIFY(m_repository->getPathsWithoutContentHash().isEmpty());
+    
+    const QList<QList<MusicItem>> groups = m_repository->findContentDuplicates();
+    QCOMPARE(groups.size(), 1);
+    QCOMPARE(groups.first().size(), 2);
+    QCOMPARE(groups.first().at(0).path, m_testMusicFiles[0]);
+    QCOMPARE(groups.first().at(1).path, m_testMusicFiles[2]);
+    QCOMPARE(groups.first().at(1).contentHash, QString("aaaa"));
+}
+
 void TestMusicRepository::testImportFromDirectory()
 {
     int result = m_repository->importFromDirectory(m_tempDir.path(), false);
@@ -510,6 +814,48 @@ void TestMusicRepository::testGetStatistics()
     QCOMPARE(stats.mostPlayedTrackId, 2); // Song 2 with 10 plays
 }
 
+void TestMusicRepository::testStatisticsFollowWrites()
+{
+    insertTestData();
+    QCOMPARE(m_repository->getStatistics().totalTracks, 3);
+    
+    // Writes made outside the repository are counted too
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("INSERT INTO musics (artist, song, genre1, path, played_times) "
+                       "VALUES ('Artist C', 'Song 4', 'Jazz', '/path/song4.mp3', 20)"));
+    MusicRepository::MusicStats stats = m_repository->getStatistics();
+    QCOMPARE(stats.totalTracks, 4);
+    QCOMPARE(stats.totalArtists, 3);
+    QCOMPARE(stats.totalGenres, 3);
+    QCOMPARE(stats.totalPlays, 37);
+    QCOMPARE(stats.mostPlayedTrackTitle, QString("Artist C - Song 4"));
+    
+    // Renaming the only artist and genre left of a kind drops them from the counts
+    QVERIFY(query.exec("UPDATE musics SET artist = 'Artist A', genre1 = 'Rock' WHERE song = 'Song 2'"));
+    stats = m_repository->getStatistics();
+    QCOMPARE(stats.totalArtists, 2);
+    QCOMPARE(stats.totalGenres, 2);
+    
+    QVERIFY(m_repository->incrementPlayCount(1));
+    QCOMPARE(m_repository->getStatistics().totalPlays, 38);
+    
+    QVERIFY(m_repository->deleteMusic(4));
+    stats = m_repository->getStatistics();
+    QCOMPARE(stats.totalTracks, 3);
+    QCOMPARE(stats.totalArtists, 1);
+    QCOMPARE(stats.totalGenres, 1);
+    QCOMPARE(stats.totalPlays, 18);
+    QCOMPARE(stats.mostPlayedTrackId, 2);
+    
+    QVERIFY(query.exec("DELETE FROM musics"));
+    stats = m_repository->getStatistics();
+    QCOMPARE(stats.totalTracks, 0);
+    QCOMPARE(stats.totalArtists, 0);
+    QCOMPARE(stats.totalGenres, 0);
+    QCOMPARE(stats.totalPlays, 0);
+    QCOMPARE(stats.mostPlayedTrackId, -1);
+}
+
 void TestMusicRepository::testGetAllArtists()
 {
     insertTestData();
@@ -550,6 +896,26 @@ void TestMusicRepository::testGetAllGenresWithGenre2()
     QVERIFY(genres.contains("Classic"));
 }
 
+void TestMusicRepository::testDictionariesFollowWrites()
+{
+    insertTestData();
+    QCOMPARE(m_repository->getAllArtists(), QStringList({"Artist A", "Artist B"}));
+    
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("INSERT INTO musics (artist, song, genre1, genre2, path) "
+                       "VALUES ('Artist 0', 'Song 4', 'Jazz', 'Rock', '/path/song4.mp3')"));
+    QVERIFY(query.exec("UPDATE musics SET artist = 'Artist A', genre2 = 'Blues' WHERE song = 'Song 2'"));
+    
+    QCOMPARE(m_repository->getAllArtists(), QStringList({"Artist 0", "Artist A"}));
+    QCOMPARE(m_repository->getAllGenres(false), QStringList({"Jazz", "Pop", "Rock"}));
+    QCOMPARE(m_repository->getAllGenres(true),
+             QStringList({"Alternative", "Blues", "Classic", "Jazz", "Pop", "Rock"}));
+    
+    QVERIFY(query.exec("DELETE FROM musics WHERE genre1 = 'Rock'"));
+    QCOMPARE(m_repository->getAllArtists(), QStringList({"Artist 0", "Artist A"}));
+    QCOMPARE(m_repository->getAllGenres(true), QStringList({"Blues", "Jazz", "Pop", "Rock"}));
+}
+
 void TestMusicRepository::testPathExists()
 {
     insertTestData();
@@ -561,6 +927,43 @@ void TestMusicRepository::testPathExists()
     QVERIFY(!notExists);
 }
 
+void TestMusicRepository::testRelocateLibraryRoot()
+{
+    insertTestData();
+    
+    const int root = m_repository->addLibraryRoot("/path");
+    QVERIFY(root > 0);
+    const int id = m_repository->getMusicIdByPath("/path/song2.mp3");
+    QVERIFY(id > 0);
+    
+    // The tracks follow their root, and are found at the new path only
+    QVERIFY(m_repository->relocateLibraryRoot(root, "/mnt/music"));
+    QCOMPARE(m_repository->libraryRoots().value(root), QString("/mnt/music/"));
+    QCOMPARE(m_repository->getMusicIdByPath("/mnt/music/song2.mp3"), id);
+    QVERIFY(!m_repository->pathExists("/path/song2.mp3"));
+    QCOMPARE(m_repository->getMusicById(id).path, QString("/mnt/music/song2.mp3"));
+}
+
+void TestMusicRepository::testRootsAddedByAnotherRepository()
+{
+    // As PlayHistoryWriter's repository, which has read the roots before the import
+    MusicRepository history(m_database);
+    const MusicItem music = createValidMusicItem();
+    QCOMPARE(history.getMusicIdByPath(music.path), -1);
+    
+    QVERIFY(m_repository->addLibraryRoot(QFileInfo(music.path).absolutePath()) > 0);
+    QVERIFY(m_repository->addMusic(music));
+    const int id = m_repository->getMusicIdByPath(music.path);
+    QVERIFY(id > 0);
+    
+    QCOMPARE(history.getMusicIdByPath(music.path), id);
+    QVERIFY(!history.addMusic(music));
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("SELECT COUNT(*) FROM musics"));
+    QVERIFY(query.next());
+    QCOMPARE(query.value(0).toInt(), 1);
+}
+
 void TestMusicRepository::testValidateMusicItem()
 {
     MusicItem validMusic = createValidMusicItem();
@@ -37,22 +37,34 @@ private slots:
     void testUpdateMusicInvalidId();
     void testDeleteMusic();
     void testDeleteMusicInvalidId();
+    void testDeleteMusicBatch();
     void testGetMusicById();
     void testGetMusicByIdNotFound();
 
     // Query operations
     void testGetAllMusic();
     void testGetAllMusicWithLimitAndOffset();
+    void testGetMusicAfter();
+    void testForEachMusicStopsEarly();
+    void testGetMusicPage();
+    void testRangeFilters();
     void testSearchMusic();
     void testSearchMusicWithCriteria();
+    void testFullTextSearch();
+    void testFullTextQuery();
     void testGetMusicByGenre();
     void testGetMusicByGenreWithGenre2();
+    void testRandomPathsByGenre();
+    void testGenreCondition();
     void testGetMusicByArtist();
 
     // Batch operations
     void testAddMusicBatch();
     void testAddMusicBatchWithInvalidItems();
     void testAddMusicBatchWithDuplicates();
+    void testAddMusicBatchSkipsExistingPaths();
+    void testAddMusicBatchSkipsContentDuplicates();
+    void testFindContentDuplicates();
     void testImportFromDirectory();
     void testImportFromDirectoryRecursive();
     void testImportFromDirectoryNonExistent();
@@ -60,12 +72,16 @@ private slots:
     // Statistics and metadata
     void testIncrementPlayCount();
     void testGetStatistics();
+    void testStatisticsFollowWrites();
     void testGetAllArtists();
     void testGetAllGenres();
     void testGetAllGenresWithGenre2();
+    void testDictionariesFollowWrites();
 
     // Validation and utility methods
     void testPathExists();
+    void testRelocateLibraryRoot();
+    void testRootsAddedByAnotherRepository();
     void testValidateMusicItem();
     void testValidateMusicItemInvalidData();
 
@@ -0,0 +1,184 @@
+#include "TestPlayHistory.h"
+#include "../../../src/repositories/PlayHistory.h"
+#include <QFileInfo>
+#include <QSqlQuery>
+
+namespace {
+
+const char* CONNECTION_NAME = "test_play_history_store";
+
+} // namespace
+
+void TestPlayHistory::init()
+{
+    m_tempDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_tempDir->isValid());
+
+    m_database = QSqlDatabase::addDatabase("QSQLITE", CONNECTION_NAME);
+    m_database.setDatabaseName(m_tempDir->path() + "/adb.db");
+    QVERIFY(m_database.open());
+
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("CREATE TABLE musics (id INTEGER PRIMARY KEY AUTOINCREMENT, artist TEXT, "
+                       "song TEXT, path TEXT, time TEXT, played_times INTEGER DEFAULT 0, "
+                       "last_played TEXT)"));
+    QVERIFY(query.exec("INSERT INTO musics (artist, song, path, time) VALUES "
+                       "('Artist A', 'Song 1', '/music/one.ogg', '00:03:10'), "
+                       "('Artist B', 'Song 2', '/music/two.ogg', '00:04:20')"));
+}
+
+void TestPlayHistory::cleanup()
+{
+    if (m_database.isOpen()) {
+        m_database.close();
+    }
+    m_database = QSqlDatabase();
+    QSqlDatabase::removeDatabase(CONNECTION_NAME);
+    m_tempDir.reset();
+}
+
+bool TestPlayHistory::appendPlays(PlayHistory& history,
+                                  const QList<QPair<QString, QDateTime>>& plays)
+{
+    QList<PlayHistory::Play> batch;
+    QStringList months;
+    for (const auto& play : plays) {
+        PlayHistory::Play entry;
+        entry.path = play.first;
+        entry.playedAt = play.second;
+        batch.append(entry);
+        const QString month = PlayHistory::monthKey(play.second.date());
+        if (!months.contains(month)) {
+            months.append(month);
+        }
+    }
+    if (!history.prepare(months) || !m_database.transaction()) {
+        return false;
+    }
+    if (!history.append(batch)) {
+        m_database.rollback();
+        return false;
+    }
+    return m_database.commit();
+}
+
+void TestPlayHistory::testMonthlyFiles()
+{
+    PlayHistory history(m_database);
+    QCOMPARE(history.directory(), m_tempDir->path() + "/history");
+
+    QVERIFY(appendPlays(history, {{"/music/one.ogg", QDateTime(QDate(2026, 9, 30), QTime(23, 59))},
+                                  {"/music/two.ogg", QDateTime(QDate(2026, 10, 1), QTime(0, 2))}}));
+    QCOMPARE(history.months(), QStringList({"2026-09", "2026-10"}));
+    QVERIFY(QFileInfo::exists(history.partitionPath("2026-09")));
+
+    // Writing October alone leaves September detached
+    QVERIFY(appendPlays(history, {{"/music/one.ogg", QDateTime(QDate(2026, 10, 2), QTime(8, 0))}}));
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("PRAGMA database_list"));
+    QStringList schemas;
+    while (query.next()) {
+        schemas.append(query.value("name").toString());
+    }
+    QVERIFY(schemas.contains("history_2026_10"));
+    QVERIFY(!schemas.contains("history_2026_09"));
+}
+
+void TestPlayHistory::testAppendStoresLibraryColumns()
+{
+    PlayHistory history(m_database);
+    const QDateTime playedAt(QDate(2026, 10, 5), QTime(14, 30, 5));
+    QVERIFY(appendPlays(history, {{"/music/one.ogg", playedAt},
+                                  {"/jingles/station-id.ogg", playedAt.addSecs(190)}}));
+
+    // A rename afterwards does not change what was logged
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("UPDATE musics SET song = 'Renamed' WHERE path = '/music/one.ogg'"));
+
+    const QList<PlayHistory::Play> plays = history.plays(playedAt, playedAt.addSecs(3600));
+    QCOMPARE(plays.size(), 2);
+    QCOMPARE(plays[0].playedAt, playedAt);
+    QCOMPARE(plays[0].musicId, 1);
+    QCOMPARE(plays[0].artist, QString("Artist A"));
+    QCOMPARE(plays[0].song, QString("Song 1"));
+    QCOMPARE(plays[0].duration, QString("00:03:10"));
+    QCOMPARE(plays[1].path, QString("/jingles/station-id.ogg"));
+    QCOMPARE(plays[1].musicId, -1);
+    QVERIFY(plays[1].artist.isEmpty());
+}
+
+void TestPlayHistory::testMonthlySummary()
+{
+    PlayHistory history(m_database);
+    const QDateTime first(QDate(2026, 10, 1), QTime(9, 0));
+    QVERIFY(appendPlays(history, {{"/music/two.ogg", first},
+                                  {"/music/one.ogg", first.addSecs(300)}}));
+    QVERIFY(appendPlays(history, {{"/music/two.ogg", first.addDays(3)}}));
+    QVERIFY(appendPlays(history, {{"/music/two.ogg", first.addMonths(1)}}));
+
+    const QList<PlayHistory::MonthlyEntry> october = history.monthlySummary("2026-10");
+    QCOMPARE(october.size(), 2);
+    QCOMPARE(october[0].path, QString("/music/two.ogg"));
+    QCOMPARE(october[0].plays, 2);
+    QCOMPARE(october[0].artist, QString("Artist B"));
+    QCOMPARE(october[0].firstPlayed, first);
+    QCOMPARE(october[0].lastPlayed, first.addDays(3));
+    QCOMPARE(october[1].plays, 1);
+
+    QCOMPARE(history.monthlySummary("2026-11").size(), 1);
+    QVERIFY(history.monthlySummary("2026-12").isEmpty());
+}
+
+void TestPlayHistory::testPlaysAcrossMonths()
+{
+    PlayHistory history(m_database);
+    const QDateTime august(QDate(2026, 8, 31), QTime(12, 0));
+    const QDateTime november(QDate(2026, 11, 1), QTime(0, 0));
+    QVERIFY(appendPlays(history, {{"/music/one.ogg", august},
+                                  {"/music/two.ogg", august.addDays(15)}}));
+    QVERIFY(appendPlays(history, {{"/music/one.ogg", november}}));
+
+    // November is attached for writing; August and September only while read
+    const QList<PlayHistory::Play> plays = history.plays(august.addSecs(-3600), november);
+    QCOMPARE(plays.size(), 2);
+    QCOMPARE(plays[0].path, QString("/music/one.ogg"));
+    QCOMPARE(plays[1].path, QString("/music/two.ogg"));
+
+    const QList<PlayHistory::Play> all = history.plays(august.addMonths(-6), november.addMonths(2));
+    QCOMPARE(all.size(), 3);
+}
+
+void TestPlayHistory::testRollbackKeepsSummaryInStep()
+{
+    PlayHistory history(m_database);
+    const QDateTime playedAt(QDate(2026, 10, 5), QTime(10, 0));
+    PlayHistory::Play play;
+    play.path = "/music/one.ogg";
+    play.playedAt = playedAt;
+
+    QVERIFY(history.prepare({"2026-10"}));
+    QVERIFY(m_database.transaction());
+    QVERIFY(history.append({play}));
+    QVERIFY(m_database.rollback());
+
+    QVERIFY(history.plays(playedAt, playedAt.addSecs(1)).isEmpty());
+    QVERIFY(history.monthlySummary("2026-10").isEmpty());
+}
+
+void TestPlayHistory::testNoDirectoryForMemoryDatabase()
+{
+    QSqlDatabase memory = QSqlDatabase::addDatabase("QSQLITE", "test_play_history_memory");
+    memory.setDatabaseName(":memory:");
+    QVERIFY(memory.open());
+    {
+        PlayHistory history(memory);
+        QVERIFY(history.directory().isEmpty());
+        QVERIFY(history.months().isEmpty());
+        QVERIFY(!history.prepare({"2026-10"}));
+    }
+    memory.close();
+    memory = QSqlDatabase();
+    QSqlDatabase::removeDatabase("test_play_history_memory");
+}
+
+QTEST_MAIN(TestPlayHistory)
@@ -0,0 +1,47 @@
+#ifndef TESTPLAYHISTORY_H
+#define TESTPLAYHISTORY_H
+
+#include <QDateTime>
+#include <QList>
+#include <QObject>
+#include <QPair>
+#include <QSqlDatabase>
+#include <QTemporaryDir>
+#include <QTest>
+#include <memory>
+
+class PlayHistory;
+
+/**
+ * @brief Unit tests for PlayHistory class
+ *
+ * Tests the monthly play history including:
+ * - One file per month, and only the written months left attached
+ * - Library columns stored with each play, and paths not in the library
+ * - Monthly summaries counted along with the plays
+ * - Reading a time range across months
+ * - No history for an in-memory database
+ */
+class TestPlayHistory : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testMonthlyFiles();
+    void testAppendStoresLibraryColumns();
+    void testMonthlySummary();
+    void testPlaysAcrossMonths();
+    void testRollbackKeepsSummaryInStep();
+    void testNoDirectoryForMemoryDatabase();
+
+private:
+    bool appendPlays(PlayHistory& history, const QList<QPair<QString, QDateTime>>& plays);
+
+    std::unique_ptr<QTemporaryDir> m_tempDir;
+    QSqlDatabase m_database;
+};
+
+#endif // TESTPLAYHISTORY_H
@@ -274,6 +274,22 @@ void TestPlaylistRepository::testGetAllPlaylistsWithLimitAndOffset()
     QCOMPARE(limitedPlaylists[1].name, QString("Music Hour"));
 }
 
+void TestPlaylistRepository::testGetPlaylistsAfter()
+{
+    insertTestData();
+    
+    QList<PlaylistItem> firstPage = m_repository->getPlaylistsAfter(QString(), -1, 2);
+    QCOMPARE(firstPage.size(), 2);
+    QCOMPARE(firstPage[0].name, QString("Evening News"));
+    QCOMPARE(firstPage[1].name, QString("Morning Show"));
+    
+    QList<PlaylistItem> secondPage = m_repository->getPlaylistsAfter(firstPage[1].name, firstPage[1].id, 2);
+    QCOMPARE(secondPage.size(), 1);
+    QCOMPARE(secondPage[0].name, QString("Music Hour"));
+    
+    QVERIFY(m_repository->getPlaylistsAfter(secondPage[0].name, secondPage[0].id, 2).isEmpty());
+}
+
 void TestPlaylistRepository::testSearchPlaylists()
 {
     insertTestData();
@@ -43,6 +43,7 @@ private slots:
     // Query operations
     void testGetAllPlaylists();
     void testGetAllPlaylistsWithLimitAndOffset();
+    void testGetPlaylistsAfter();
     void testSearchPlaylists();
     void testSearchPlaylistsExactMatch();
     void testGetPlaylistsByName();
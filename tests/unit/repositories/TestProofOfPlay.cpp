@@ -0,0 +1,164 @@
+#include "TestProofOfPlay.h"
+#include "../../../src/repositories/ProofOfPlay.h"
+#include <QSqlQuery>
+
+namespace {
+
+const char* CONNECTION_NAME = "test_proof_of_play";
+
+bool appendInTransaction(QSqlDatabase& database, const QList<ProofOfPlay::Airing>& airings)
+{
+    ProofOfPlay proofs(database);
+    if (!database.transaction()) {
+        return false;
+    }
+    if (!proofs.append(airings)) {
+        database.rollback();
+        return false;
+    }
+    return database.commit();
+}
+
+} // namespace
+
+void TestProofOfPlay::init()
+{
+    m_database = QSqlDatabase::addDatabase("QSQLITE", CONNECTION_NAME);
+    m_database.setDatabaseName(":memory:");
+    QVERIFY(m_database.open());
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("CREATE TABLE pub (id INTEGER PRIMARY KEY AUTOINCREMENT, name TEXT, "
+                       "path TEXT, customer TEXT)"));
+    QVERIFY(query.exec("CREATE TABLE programs (id INTEGER PRIMARY KEY AUTOINCREMENT, "
+                       "name TEXT, path TEXT)"));
+    QVERIFY(query.exec("INSERT INTO pub (name, path, customer) VALUES "
+                       "('Bakery spring', '/pubs/bakery-spring.mp3', 'Bakery'), "
+                       "('Bakery summer', '/pubs/bakery-summer.mp3', 'Bakery'), "
+                       "('Garage', '/pubs/garage.mp3', '')"));
+    QVERIFY(query.exec("INSERT INTO programs (name, path) VALUES "
+                       "('Morning Talk', '/programs/morning.mp3')"));
+    QVERIFY(ProofOfPlay(m_database).ensure());
+    m_scheduled = QDateTime(QDate(2026, 9, 14), QTime(8, 0));
+}
+
+void TestProofOfPlay::cleanup()
+{
+    m_database.close();
+    m_database = QSqlDatabase();
+    QSqlDatabase::removeDatabase(CONNECTION_NAME);
+}
+
+void TestProofOfPlay::testAppendLogsAirings()
+{
+    using Kind = ProofOfPlay::Kind;
+    QVERIFY(appendInTransaction(
+        m_database,
+        {{Kind::Pub, 1, "/pubs/bakery-spring.mp3", m_scheduled, m_scheduled.addSecs(4), 30000},
+         {Kind::Program, 1, "/programs/morning.mp3", m_scheduled, m_scheduled.addSecs(34),
+          3600000}}));
+
+    const QList<ProofOfPlay::Airing> airings =
+        ProofOfPlay(m_database).airings(m_scheduled, m_scheduled.addDays(1));
+    QCOMPARE(airings.size(), 2);
+    QVERIFY(airings[0].kind == Kind::Pub);
+    QCOMPARE(airings[0].itemId, 1);
+    QCOMPARE(airings[0].scheduledAt, m_scheduled);
+    QCOMPARE(airings[0].startedAt, m_scheduled.addSecs(4));
+    QCOMPARE(airings[0].durationMs, qint64(30000));
+    QVERIFY(airings[1].kind == Kind::Program);
+    QCOMPARE(airings[1].durationMs, qint64(3600000));
+
+    QVERIFY(ProofOfPlay(m_database).airings(m_scheduled.addDays(1), m_scheduled.addDays(2))
+                .isEmpty());
+}
+
+void TestProofOfPlay::testCampaignOfItems()
+{
+    using Kind = ProofOfPlay::Kind;
+    QVERIFY(appendInTransaction(
+        m_database,
+        {{Kind::Pub, 1, "/pubs/bakery-spring.mp3", m_scheduled, m_scheduled, 30000},
+         {Kind::Pub, 3, "/pubs/garage.mp3", m_scheduled, m_scheduled.addSecs(30), 20000},
+         {Kind::Program, 1, "/programs/morning.mp3", m_scheduled, m_scheduled.addSecs(50), 1000},
+         {Kind::Pub, 9, "/pubs/gone.mp3", m_scheduled, m_scheduled.addSecs(60), 15000}}));
+
+    const QList<ProofOfPlay::Airing> airings =
+        ProofOfPlay(m_database).airings(m_scheduled, m_scheduled.addDays(1));
+    QCOMPARE(airings.size(), 4);
+    QCOMPARE(airings[0].campaign, QString("Bakery"));
+    QCOMPARE(airings[1].campaign, QString("Garage"));
+    QCOMPARE(airings[2].campaign, QString("Morning Talk"));
+    QCOMPARE(airings[3].campaign, QString("/pubs/gone.mp3"));
+    QCOMPARE(airings[3].itemId, 9);
+
+    const QList<ProofOfPlay::Airing> bakery =
+        ProofOfPlay(m_database).airings(m_scheduled, m_scheduled.addDays(1), "Bakery");
+    QCOMPARE(bakery.size(), 1);
+}
+
+void TestProofOfPlay::testLookUpByPath()
+{
+    QVERIFY(appendInTransaction(m_database, {{ProofOfPlay::Kind::Pub, -1,
+                                              "/pubs/bakery-summer.mp3", m_scheduled,
+                                              m_scheduled.addSecs(30), 30000}}));
+
+    const QList<ProofOfPlay::Airing> airings =
+        ProofOfPlay(m_database).airings(m_scheduled, m_scheduled.addDays(1));
+    QCOMPARE(airings.size(), 1);
+    QCOMPARE(airings[0].itemId, 2);
+    QCOMPARE(airings[0].campaign, QString("Bakery"));
+}
+
+void TestProofOfPlay::testResolveBeforeDelete()
+{
+    ProofOfPlay proofs(m_database);
+    ProofOfPlay::Airing airing{ProofOfPlay::Kind::Pub, 2, "/pubs/bakery-summer.mp3", m_scheduled};
+    QVERIFY(proofs.resolve(airing));
+    QCOMPARE(airing.campaign, QString("Bakery"));
+
+    // As SchedulerEngine does once the last rule of a pub fired
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("DELETE FROM pub WHERE id = 2"));
+    airing.startedAt = m_scheduled;
+    airing.durationMs = 30000;
+    QVERIFY(appendInTransaction(m_database, {airing}));
+
+    const QList<ProofOfPlay::CampaignEntry> summary = proofs.campaignSummary("2026-09");
+    QCOMPARE(summary.size(), 1);
+    QCOMPARE(summary[0].campaign, QString("Bakery"));
+    QCOMPARE(summary[0].itemId, 2);
+}
+
+void TestProofOfPlay::testCampaignSummary()
+{
+    using Kind = ProofOfPlay::Kind;
+    const QDateTime nextMonth = m_scheduled.addMonths(1);
+    QVERIFY(appendInTransaction(
+        m_database,
+        {{Kind::Pub, 1, "/pubs/bakery-spring.mp3", m_scheduled, m_scheduled.addSecs(10), 30000},
+         {Kind::Pub, 1, "/pubs/bakery-spring.mp3", m_scheduled.addDays(1),
+          m_scheduled.addDays(1).addSecs(-5), 29000},
+         {Kind::Pub, 2, "/pubs/bakery-summer.mp3", m_scheduled, m_scheduled.addSecs(40), 31000},
+         {Kind::Pub, 3, "/pubs/garage.mp3", m_scheduled.addDays(2), m_scheduled.addDays(2),
+          20000},
+         {Kind::Pub, 1, "/pubs/bakery-spring.mp3", nextMonth, nextMonth, 30000}}));
+
+    const QList<ProofOfPlay::CampaignEntry> summary =
+        ProofOfPlay(m_database).campaignSummary("2026-09");
+    QCOMPARE(summary.size(), 3);
+    QCOMPARE(summary[0].campaign, QString("Bakery"));
+    QCOMPARE(summary[0].itemId, 1);
+    QCOMPARE(summary[0].airings, 2);
+    QCOMPARE(summary[0].airedMs, qint64(59000));
+    // Early starts are not late
+    QCOMPARE(summary[0].lateMs, qint64(10000));
+    QCOMPARE(summary[0].firstAired, m_scheduled.addSecs(10));
+    QCOMPARE(summary[0].lastAired, m_scheduled.addDays(1).addSecs(-5));
+    QCOMPARE(summary[1].itemId, 2);
+    QCOMPARE(summary[1].lateMs, qint64(40000));
+    QCOMPARE(summary[2].campaign, QString("Garage"));
+
+    QCOMPARE(ProofOfPlay(m_database).campaignSummary("2026-10").size(), 1);
+}
+
+QTEST_MAIN(TestProofOfPlay)
@@ -0,0 +1,37 @@
+#ifndef TESTPROOFOFPLAY_H
+#define TESTPROOFOFPLAY_H
+
+#include <QDateTime>
+#include <QObject>
+#include <QSqlDatabase>
+#include <QTest>
+
+/**
+ * @brief Unit tests for ProofOfPlay class
+ *
+ * Tests the proof of play of scheduled items including:
+ * - Airings logged with their item, schedule, start and duration
+ * - Campaigns from the pub customer, the name or the path
+ * - Items looked up by path, and resolved before their row is deleted
+ * - The monthly summary of each campaign
+ */
+class TestProofOfPlay : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testAppendLogsAirings();
+    void testCampaignOfItems();
+    void testLookUpByPath();
+    void testResolveBeforeDelete();
+    void testCampaignSummary();
+
+private:
+    QSqlDatabase m_database;
+    QDateTime m_scheduled;
+};
+
+#endif // TESTPROOFOFPLAY_H
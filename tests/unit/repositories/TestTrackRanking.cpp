@@ -0,0 +1,147 @@
+#include "TestTrackRanking.h"
+#include "../../../src/repositories/TrackRanking.h"
+#include <QDebug>
+#include <QSqlError>
+#include <QSqlQuery>
+
+void TestTrackRanking::init()
+{
+    m_database = QSqlDatabase::addDatabase("QSQLITE", "test_track_ranking");
+    m_database.setDatabaseName(":memory:");
+    QVERIFY(m_database.open());
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("CREATE TABLE musics (id INTEGER PRIMARY KEY AUTOINCREMENT, "
+                       "artist TEXT NOT NULL, song TEXT NOT NULL, genre1 TEXT, genre2 TEXT, "
+                       "country TEXT, published_date TEXT, path TEXT, time TEXT, "
+                       "played_times INTEGER DEFAULT 0, last_played TEXT)"));
+}
+
+void TestTrackRanking::cleanup()
+{
+    m_database.close();
+    m_database = QSqlDatabase();
+    QSqlDatabase::removeDatabase("test_track_ranking");
+}
+
+int TestTrackRanking::addTrack(const QString& artist, const QString& song, int playedTimes,
+                               const QString& lastPlayed)
+{
+    QSqlQuery query(m_database);
+    query.prepare("INSERT INTO musics (artist, song, path, played_times, last_played) "
+                  "VALUES (?, ?, ?, ?, ?)");
+    query.addBindValue(artist);
+    query.addBindValue(song);
+    query.addBindValue(QString("/music/%1 - %2.ogg").arg(artist, song));
+    query.addBindValue(playedTimes);
+    query.addBindValue(lastPlayed);
+    if (!query.exec()) {
+        qWarning() << query.lastError().text();
+        return -1;
+    }
+    return query.lastInsertId().toInt();
+}
+
+QVariant TestTrackRanking::rankScore(int id)
+{
+    QSqlQuery query(m_database);
+    query.prepare("SELECT rank_score FROM musics WHERE id = ?");
+    query.addBindValue(id);
+    return query.exec() && query.next() ? query.value(0) : QVariant();
+}
+
+void TestTrackRanking::testScore()
+{
+    QVERIFY(TrackRanking::score(0, "2024-05-17 || 14:30:05").isNull());
+
+    const double once = TrackRanking::score(1, "2024-05-17 || 14:30:05").toDouble();
+    QVERIFY(TrackRanking::score(10, "2024-05-17 || 14:30:05").toDouble() > once);
+    QVERIFY(TrackRanking::score(1, "2024-06-17 || 09:00:00").toDouble() > once);
+    // The player's format and ISO 8601 give the same day
+    QCOMPARE(TrackRanking::score(1, "2024-05-17T14:30:05").toDouble(), once);
+
+    // RECENCY_DAYS later is worth one more unit, whatever the plays
+    const QString later = QDate(2024, 5, 17)
+                              .addDays(int(TrackRanking::RECENCY_DAYS))
+                              .toString("yyyy-MM-dd || 14:30:05");
+    QVERIFY(qAbs(TrackRanking::score(1, later).toDouble() - once - 1.0) < 1e-9);
+}
+
+void TestTrackRanking::testEnsureScoresPlayedTracks()
+{
+    const int unplayed = addTrack("Artist", "New", 0);
+    const int played = addTrack("Artist", "Old", 12, "2024-01-02 || 10:00:00");
+
+    TrackRanking ranking(m_database);
+    QVERIFY(ranking.ensure());
+    QVERIFY(ranking.isReady());
+    QVERIFY(rankScore(unplayed).isNull());
+    QCOMPARE(rankScore(played).toDouble(),
+             TrackRanking::score(12, "2024-01-02 || 10:00:00").toDouble());
+
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("SELECT 1 FROM sqlite_master WHERE type = 'index' "
+                       "AND name = 'idx_musics_rank_score'"));
+    QVERIFY(query.next());
+
+    // A second run finds the column and leaves the scores as they are
+    QVERIFY(TrackRanking(m_database).ensure());
+    QCOMPARE(rankScore(played).toDouble(),
+             TrackRanking::score(12, "2024-01-02 || 10:00:00").toDouble());
+}
+
+void TestTrackRanking::testRefresh()
+{
+    const int id = addTrack("Artist", "Song", 1, "2024-01-02 || 10:00:00");
+
+    // Without the column there is nothing to refresh
+    QVERIFY(TrackRanking(m_database).refresh({id}));
+
+    TrackRanking ranking(m_database);
+    QVERIFY(ranking.ensure());
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec(QString("UPDATE musics SET played_times = 5, "
+                               "last_played = '2024-03-04 || 08:00:00' WHERE id = %1")
+                           .arg(id)));
+    QVERIFY(ranking.refresh({id}));
+    QCOMPARE(rankScore(id).toDouble(),
+             TrackRanking::score(5, "2024-03-04 || 08:00:00").toDouble());
+}
+
+void TestTrackRanking::testTopByPopularity()
+{
+    const int remix = addTrack("Beatles", "Yesterday (Remix)", 0);
+    const int live = addTrack("Beatles", "Yesterday (Live)", 2, "2023-08-01 || 12:00:00");
+    const int original = addTrack("Beatles", "Yesterday", 50, "2024-05-16 || 18:00:00");
+    addTrack("Beatles", "Help", 80, "2024-05-16 || 19:00:00");
+
+    TrackRanking ranking(m_database);
+    QVERIFY(ranking.ensure());
+    QCOMPARE(ranking.top("song LIKE ?", {"%Yesterday%"}, 2), (QList<qint64>{original, live}));
+    QCOMPARE(ranking.top("song LIKE ?", {"%Yesterday%"}, 10),
+             (QList<qint64>{original, live, remix}));
+    QVERIFY(ranking.top("song LIKE ?", {"%Nothing%"}, 10).isEmpty());
+}
+
+void TestTrackRanking::testTopWeighsMatch()
+{
+    QSqlQuery query(m_database);
+    if (!query.exec("CREATE VIRTUAL TABLE musics_fts USING fts5(artist, song, "
+                    "content='musics')")) {
+        QSKIP("SQLite was built without FTS5");
+    }
+
+    // Never played, so only the match tells them apart: the shorter title matches better
+    const int longer = addTrack("Beatles", "Yesterday live at the Hollywood Bowl, remastered", 0);
+    const int shorter = addTrack("Beatles", "Yesterday", 0);
+    const int played = addTrack("Beatles", "Yesterday once more, the extended version", 3,
+                                "2024-05-16 || 18:00:00");
+    QVERIFY(query.exec("INSERT INTO musics_fts(musics_fts) VALUES ('rebuild')"));
+
+    TrackRanking ranking(m_database);
+    QVERIFY(ranking.ensure());
+    const QString condition = "rowid IN (SELECT rowid FROM musics_fts WHERE musics_fts MATCH ?)";
+    QCOMPARE(ranking.top(condition, {"yesterday"}, 3, "yesterday"),
+             (QList<qint64>{played, shorter, longer}));
+}
+
+QTEST_MAIN(TestTrackRanking)
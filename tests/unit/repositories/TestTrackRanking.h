@@ -0,0 +1,40 @@
+#ifndef TESTTRACKRANKING_H
+#define TESTTRACKRANKING_H
+
+#include <QObject>
+#include <QSqlDatabase>
+#include <QTest>
+#include <QVariant>
+
+/**
+ * @brief Unit tests for TrackRanking class
+ *
+ * Tests the popularity ranking of tracks including:
+ * - Scores that grow with the plays and the date of the last play
+ * - Scoring the played tracks when the column is added
+ * - Scoring tracks again after they were played
+ * - The most played matches first, and the better match among equals
+ */
+class TestTrackRanking : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testScore();
+    void testEnsureScoresPlayedTracks();
+    void testRefresh();
+    void testTopByPopularity();
+    void testTopWeighsMatch();
+
+private:
+    int addTrack(const QString& artist, const QString& song, int playedTimes,
+                 const QString& lastPlayed = QString());
+    QVariant rankScore(int id);
+
+    QSqlDatabase m_database;
+};
+
+#endif // TESTTRACKRANKING_H
@@ -0,0 +1,30 @@
+#include "TestATSPIBusWatcher.h"
+#include "../../../src/services/ATSPIBusWatcher.h"
+#include <QSignalSpy>
+
+void TestATSPIBusWatcher::testUnknownBeforeStart()
+{
+    ATSPIBusWatcher watcher;
+    QVERIFY(!watcher.isKnown());
+    QVERIFY(!watcher.isPresent());
+}
+
+void TestATSPIBusWatcher::testAnswersOnce()
+{
+    ATSPIBusWatcher watcher;
+    QSignalSpy spy(&watcher, &ATSPIBusWatcher::presenceChanged);
+
+    watcher.start();
+    QTRY_VERIFY(watcher.isKnown());
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(0).toBool(), watcher.isPresent());
+#ifndef XFB_HAVE_DBUS
+    QVERIFY(!watcher.isPresent());
+#endif
+
+    watcher.start();
+    QTest::qWait(50);
+    QCOMPARE(spy.count(), 1);
+}
+
+QTEST_MAIN(TestATSPIBusWatcher)
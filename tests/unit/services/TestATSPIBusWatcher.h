@@ -0,0 +1,24 @@
+#ifndef TESTATSPIBUSWATCHER_H
+#define TESTATSPIBUSWATCHER_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for ATSPIBusWatcher class
+ *
+ * Tests the AT-SPI presence check including:
+ * - Nothing known before start()
+ * - One answer after start(), absent without D-Bus
+ * - A second start() changing nothing
+ */
+class TestATSPIBusWatcher : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testUnknownBeforeStart();
+    void testAnswersOnce();
+};
+
+#endif // TESTATSPIBUSWATCHER_H
@@ -0,0 +1,67 @@
+#include "TestAccessibilityEventBatcher.h"
+#include "../../../src/services/AccessibilityEventBatcher.h"
+#include <QLocale>
+#include <QStandardItemModel>
+#include <QTableView>
+
+void TestAccessibilityEventBatcher::testSummarize()
+{
+    QLocale::setDefault(QLocale(QLocale::English, QLocale::UnitedStates));
+
+    QCOMPARE(AccessibilityEventBatcher::summarize(1250, 0, 0, "track", "tracks"),
+             QString("1,250 tracks added"));
+    QCOMPARE(AccessibilityEventBatcher::summarize(1, 0, 0, "track", "tracks"),
+             QString("1 track added"));
+    QCOMPARE(AccessibilityEventBatcher::summarize(40, 3, 12, "track", "tracks"),
+             QString("40 tracks added, 3 removed, 12 updated"));
+    QCOMPARE(AccessibilityEventBatcher::summarize(0, 0, 12, "track", "tracks"),
+             QString("12 tracks updated"));
+    QVERIFY(AccessibilityEventBatcher::summarize(0, 0, 0, "track", "tracks").isEmpty());
+
+    QLocale::setDefault(QLocale::system());
+}
+
+void TestAccessibilityEventBatcher::testNestedBatches()
+{
+    AccessibilityEventBatcher batcher;
+    QStandardItemModel model;
+    QVERIFY(!batcher.isBatching(&model));
+
+    batcher.beginBatch(&model);
+    batcher.beginBatch(&model);
+    QVERIFY(batcher.isBatching(&model));
+
+    batcher.endBatch(&model);
+    QVERIFY(batcher.isBatching(&model));
+    batcher.endBatch(&model);
+    QVERIFY(!batcher.isBatching(&model));
+
+    // An end without a begin is ignored
+    batcher.endBatch(&model);
+    QVERIFY(!batcher.isBatching(&model));
+    QVERIFY(batcher.summary(nullptr).isEmpty());
+}
+
+void TestAccessibilityEventBatcher::testViewFollowsModel()
+{
+    AccessibilityEventBatcher batcher;
+    QStandardItemModel model(3, 2);
+    QStandardItemModel other(3, 2);
+    QTableView view;
+    view.setModel(&model);
+
+    batcher.beginBatch(&other);
+    QVERIFY(!batcher.isBatchingView(&view));
+    batcher.beginBatch(&model);
+    QVERIFY(batcher.isBatchingView(&view));
+    QVERIFY(!batcher.isBatchingView(&model)); // Not a view
+
+    batcher.endBatch(&model, "3 tracks added");
+    batcher.endBatch(&other);
+    QVERIFY(!batcher.isBatchingView(&view));
+    // The summary is only given out while the batched event is sent
+    QVERIFY(batcher.summary(&view).isEmpty());
+    QCOMPARE(batcher.heldBackCount(), qint64(0));
+}
+
+QTEST_MAIN(TestAccessibilityEventBatcher)
@@ -0,0 +1,25 @@
+#ifndef TESTACCESSIBILITYEVENTBATCHER_H
+#define TESTACCESSIBILITYEVENTBATCHER_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for AccessibilityEventBatcher class
+ *
+ * Tests the folding of bulk table changes including:
+ * - The summary sentence and its number formatting
+ * - Nested batches, ended by the outermost endBatch()
+ * - Views found to be batching through their model
+ */
+class TestAccessibilityEventBatcher : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testSummarize();
+    void testNestedBatches();
+    void testViewFollowsModel();
+};
+
+#endif // TESTACCESSIBILITYEVENTBATCHER_H
@@ -20,6 +20,7 @@ private slots:
 
     // Test cases
     void testInitialization();
+    void testDeferredActivation();
     void testEnableDisableAccessibility();
     void testVerbosityLevels();
     void testWidgetRegistration();
@@ -76,6 +77,25 @@ void TestAccessibilityManager::testInitialization()
     QCOMPARE(m_accessibilityManager->verbosityLevel(), AccessibilityManager::VerbosityLevel::Normal);
 }
 
+void TestAccessibilityManager::testDeferredActivation()
+{
+    // Without an assistive technology nothing is built at start-up
+    if (!QAccessible::isActive()) {
+        QVERIFY(!m_accessibilityManager->isActive());
+        QVERIFY(m_accessibilityManager->backgroundOperationFeedback() == nullptr);
+    }
+    
+    const bool wasActive = m_accessibilityManager->isActive();
+    QSignalSpy spy(m_accessibilityManager, &AccessibilityManager::activated);
+    m_accessibilityManager->enableAccessibility(true);
+    QVERIFY(m_accessibilityManager->isActive());
+    QCOMPARE(spy.count(), wasActive ? 0 : 1);
+    
+    // Activating again changes nothing
+    m_accessibilityManager->activate();
+    QCOMPARE(spy.count(), wasActive ? 0 : 1);
+}
+
 void TestAccessibilityManager::testEnableDisableAccessibility()
 {
     QSignalSpy spy(m_accessibilityManager, &AccessibilityManager::accessibilityStateChanged);
@@ -0,0 +1,73 @@
+#include "TestAccessibilityPerformanceMonitor.h"
+#include "../../../src/services/AccessibilityPerformanceMonitor.h"
+#include <QThread>
+
+void TestAccessibilityPerformanceMonitor::testLatencyQuantiles()
+{
+    AccessibilityPerformanceMonitor monitor;
+    QCOMPARE(monitor.getStats(AccessibilityPerformanceMonitor::AnnouncementLatency).sampleCount, 0);
+
+    // 1 ms to 100 ms, one sample each
+    for (int ms = 1; ms <= 100; ++ms) {
+        monitor.onAnnouncementLatency(ms);
+    }
+
+    const AccessibilityPerformanceMonitor::PerformanceStats stats =
+        monitor.getStats(AccessibilityPerformanceMonitor::AnnouncementLatency);
+    QCOMPARE(stats.sampleCount, 100);
+    QCOMPARE(stats.averageLatency, 50.5);
+    QCOMPARE(stats.minLatency, 1.0);
+    QCOMPARE(stats.maxLatency, 100.0);
+    // Buckets are within 1/8 of their values
+    QVERIFY2(stats.p95Latency >= 95.0 && stats.p95Latency <= 95.0 * 1.125,
+             qPrintable(QString::number(stats.p95Latency)));
+    QVERIFY2(stats.p99Latency >= 99.0 && stats.p99Latency <= 100.0,
+             qPrintable(QString::number(stats.p99Latency)));
+    QVERIFY(stats.lastUpdated.isValid());
+
+    // Other metrics are kept apart
+    QCOMPARE(monitor.getStats(AccessibilityPerformanceMonitor::FocusChangeLatency).sampleCount, 0);
+}
+
+void TestAccessibilityPerformanceMonitor::testMeasurement()
+{
+    AccessibilityPerformanceMonitor monitor;
+    monitor.startMeasurement(AccessibilityPerformanceMonitor::InterfaceCreationTime, "table");
+    QThread::msleep(20);
+    monitor.endMeasurement(AccessibilityPerformanceMonitor::InterfaceCreationTime, "table");
+
+    // Ending one that was never started records nothing
+    monitor.endMeasurement(AccessibilityPerformanceMonitor::InterfaceCreationTime, "other");
+
+    const AccessibilityPerformanceMonitor::PerformanceStats stats =
+        monitor.getStats(AccessibilityPerformanceMonitor::InterfaceCreationTime);
+    QCOMPARE(stats.sampleCount, 1);
+    QVERIFY2(stats.maxLatency >= 20.0, qPrintable(QString::number(stats.maxLatency)));
+}
+
+void TestAccessibilityPerformanceMonitor::testDisabledAndReset()
+{
+    AccessibilityPerformanceMonitor monitor;
+    monitor.setMonitoringEnabled(AccessibilityPerformanceMonitor::FocusChangeLatency, false);
+    QVERIFY(!monitor.isMonitoringEnabled(AccessibilityPerformanceMonitor::FocusChangeLatency));
+    monitor.onFocusChangeLatency(10.0);
+    QCOMPARE(monitor.getStats(AccessibilityPerformanceMonitor::FocusChangeLatency).sampleCount, 0);
+
+    monitor.setMonitoringEnabled(AccessibilityPerformanceMonitor::FocusChangeLatency, true);
+    monitor.onFocusChangeLatency(10.0);
+    monitor.recordMemoryUsage(4096);
+    QCOMPARE(monitor.getStats(AccessibilityPerformanceMonitor::FocusChangeLatency).sampleCount, 1);
+    QCOMPARE(monitor.getStats(AccessibilityPerformanceMonitor::MemoryUsage).totalMemoryUsage,
+             qint64(4096));
+
+    monitor.resetStats();
+    const AccessibilityPerformanceMonitor::PerformanceStats stats =
+        monitor.getStats(AccessibilityPerformanceMonitor::FocusChangeLatency);
+    QCOMPARE(stats.sampleCount, 0);
+    QCOMPARE(stats.maxLatency, 0.0);
+    QCOMPARE(stats.p99Latency, 0.0);
+    QCOMPARE(monitor.getStats(AccessibilityPerformanceMonitor::MemoryUsage).totalMemoryUsage,
+             qint64(0));
+}
+
+QTEST_MAIN(TestAccessibilityPerformanceMonitor)
@@ -0,0 +1,25 @@
+#ifndef TESTACCESSIBILITYPERFORMANCEMONITOR_H
+#define TESTACCESSIBILITYPERFORMANCEMONITOR_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for AccessibilityPerformanceMonitor class
+ *
+ * Tests the latency statistics including:
+ * - Average, minimum, maximum and the p95 and p99 latencies
+ * - Measurements started and ended by operation id
+ * - Disabled metrics and resetting the statistics
+ */
+class TestAccessibilityPerformanceMonitor : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testLatencyQuantiles();
+    void testMeasurement();
+    void testDisabledAndReset();
+};
+
+#endif // TESTACCESSIBILITYPERFORMANCEMONITOR_H
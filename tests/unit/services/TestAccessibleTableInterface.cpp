@@ -0,0 +1,96 @@
+#include "TestAccessibleTableInterface.h"
+#include "../../../src/services/AccessibleTableInterface.h"
+#include <QStandardItemModel>
+#include <memory>
+
+namespace {
+
+constexpr int ROWS = 20000;
+constexpr int COLUMNS = 5;
+
+std::unique_ptr<QStandardItemModel> makeModel()
+{
+    auto model = std::make_unique<QStandardItemModel>(ROWS, COLUMNS);
+    for (int row = 0; row < ROWS; ++row) {
+        model->setItem(row, 0, new QStandardItem(QString("Song %1").arg(row)));
+    }
+    return model;
+}
+
+} // namespace
+
+void TestAccessibleTableInterface::testCellReused()
+{
+    auto model = makeModel();
+    QTableView view;
+    view.setModel(model.get());
+    AccessibleTableInterface table(&view);
+
+    QAccessibleInterface* cell = table.cellAt(3, 0);
+    QVERIFY(cell);
+    QCOMPARE(table.cellAt(3, 0), cell);
+    QCOMPARE(cell->text(QAccessible::Value), QString("Song 3"));
+    QCOMPARE(table.indexOfChild(cell), 3 * COLUMNS);
+    QCOMPARE(table.cachedCellCount(), 1);
+    QVERIFY(!table.cellAt(ROWS, 0));
+}
+
+void TestAccessibleTableInterface::testCacheBounded()
+{
+    auto model = makeModel();
+    QTableView view;
+    view.setModel(model.get());
+    AccessibleTableInterface table(&view);
+
+    // Cells handed out by one call stay valid until the event loop runs
+    QAccessibleInterface* first = table.child(0);
+    for (int index = 1; index < table.childCount(); ++index) {
+        QVERIFY(table.child(index));
+    }
+    QCOMPARE(first->text(QAccessible::Value), QString("Song 0"));
+    QCOMPARE(table.cachedCellCount(), ROWS * COLUMNS);
+
+    QTRY_VERIFY(table.cachedCellCount() <= AccessibleTableInterface::MAX_CACHED_CELLS);
+
+    // The most recent cells survive eviction
+    QAccessibleInterface* last = table.child(table.childCount() - 1);
+    QCOMPARE(table.child(table.childCount() - 1), last);
+    QCOMPARE(table.indexOfChild(last), table.childCount() - 1);
+}
+
+void TestAccessibleTableInterface::testVisibleRowsKept()
+{
+    auto model = makeModel();
+    QTableView view;
+    view.setModel(model.get());
+    AccessibleTableInterface table(&view);
+
+    QAccessibleInterface* visible = table.cellAt(0, 0);
+    for (int row = ROWS / 2; row < ROWS; ++row) {
+        table.cellAt(row, 0);
+    }
+    QTRY_VERIFY(table.cachedCellCount() <= AccessibleTableInterface::MAX_CACHED_CELLS);
+
+    // Used least recently, but on screen
+    QCOMPARE(table.cellAt(0, 0), visible);
+}
+
+void TestAccessibleTableInterface::testModelChangeClears()
+{
+    auto model = makeModel();
+    QTableView view;
+    view.setModel(model.get());
+    AccessibleTableInterface table(&view);
+
+    for (int row = 0; row < 10; ++row) {
+        table.cellAt(row, 1);
+    }
+    QCOMPARE(table.cachedCellCount(), 10);
+
+    QAccessibleTableModelChangeEvent event(&view, QAccessibleTableModelChangeEvent::ModelReset);
+    table.modelChange(&event);
+    QCOMPARE(table.cachedCellCount(), 0);
+    QVERIFY(table.cellAt(0, 1));
+}
+
+QTEST_MAIN(TestAccessibleTableInterface)
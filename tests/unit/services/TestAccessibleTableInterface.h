@@ -0,0 +1,27 @@
+#ifndef TESTACCESSIBLETABLEINTERFACE_H
+#define TESTACCESSIBLETABLEINTERFACE_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for AccessibleTableInterface class
+ *
+ * Tests the cache of cell interfaces including:
+ * - The same interface for a cell while it is cached
+ * - A bounded cache while every cell of a large table is walked
+ * - Cells of the visible rows kept through eviction
+ * - The cache emptied when the model changes
+ */
+class TestAccessibleTableInterface : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testCellReused();
+    void testCacheBounded();
+    void testVisibleRowsKept();
+    void testModelChangeClears();
+};
+
+#endif // TESTACCESSIBLETABLEINTERFACE_H
@@ -0,0 +1,238 @@
+#include "TestAdBreakPacker.h"
+#include "../../../src/services/AdBreakPacker.h"
+#include <QElapsedTimer>
+#include <QSet>
+#include <QSqlQuery>
+
+namespace {
+
+const char* CONNECTION_NAME = "test_ad_break_packer_connection";
+const QDateTime TEN(QDate(2024, 3, 4), QTime(10, 0));
+
+AdBreakPacker::Spot spot(const QString& name, const QString& customer, qint64 seconds)
+{
+    AdBreakPacker::Spot result;
+    result.path = QString("/pub/%1.mp3").arg(name);
+    result.customer = customer;
+    result.durationMs = seconds * 1000;
+    return result;
+}
+
+QString path(const QString& name)
+{
+    return QString("/pub/%1.mp3").arg(name);
+}
+
+} // namespace
+
+void TestAdBreakPacker::init()
+{
+    m_tempDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_tempDir->isValid());
+
+    m_database = QSqlDatabase::addDatabase("QSQLITE", CONNECTION_NAME);
+    m_database.setDatabaseName(m_tempDir->path() + "/pub.db");
+    QVERIFY(m_database.open());
+}
+
+void TestAdBreakPacker::cleanup()
+{
+    if (m_database.isOpen()) {
+        m_database.close();
+    }
+    m_database = QSqlDatabase();
+    QSqlDatabase::removeDatabase(CONNECTION_NAME);
+    m_tempDir.reset();
+}
+
+void TestAdBreakPacker::testFillsBreak()
+{
+    AdBreakPacker packer(m_database);
+    packer.setSpots({spot("a", "A", 60), spot("b", "B", 45), spot("c", "C", 30),
+                     spot("d", "D", 25), spot("e", "E", 20)});
+
+    // Only 45 + 30 + 25 fill the 100 s exactly
+    const AdBreakPacker::Break full = packer.pack({TEN, 100000, QString()});
+    QCOMPARE(full.at, TEN);
+    QCOMPARE(full.lengthMs, qint64(100000));
+    QCOMPARE(full.filledMs, qint64(100000));
+    QCOMPARE(full.paths, QStringList({path("b"), path("c"), path("d")}));
+
+    // Never over the length, even by a fraction of a step
+    const AdBreakPacker::Break tight = packer.pack({TEN, 59950, QString()});
+    QCOMPARE(tight.filledMs, qint64(55000));
+    QVERIFY(packer.pack({TEN, 19000, QString()}).paths.isEmpty());
+}
+
+void TestAdBreakPacker::testOneSpotPerCustomer()
+{
+    AdBreakPacker packer(m_database);
+    packer.setSpots({spot("acme1", "Acme", 50), spot("acme2", "Acme", 50), spot("b", "B", 40)});
+
+    const AdBreakPacker::Break result = packer.pack({TEN, 100000, QString()});
+    QCOMPARE(result.filledMs, qint64(90000));
+    QCOMPARE(result.paths, QStringList({path("acme1"), path("b")}));
+}
+
+void TestAdBreakPacker::testCustomerSeparation()
+{
+    AdBreakPacker packer(m_database);
+    packer.setCustomerSeparationMs(30 * 60 * 1000);
+    packer.setSpots({spot("a", "A", 40), spot("b", "B", 20), spot("c", "C", 15)});
+
+    // Given out of order, packed in time order
+    const QVector<AdBreakPacker::Break> day =
+        packer.packDay({{TEN.addSecs(40 * 60), 60000, QString()},
+                        {TEN, 60000, QString()},
+                        {TEN.addSecs(20 * 60), 60000, path("a")},
+                        {TEN.addSecs(10 * 60), 60000, QString()}});
+    QCOMPARE(day.size(), 4);
+    QCOMPARE(day[0].at, TEN);
+    QCOMPARE(day[0].paths, QStringList({path("a"), path("b")}));
+    QCOMPARE(day[1].paths, QStringList({path("c")}));
+    // A pinned spot airs against the rules, and keeps its customer out after it
+    QCOMPARE(day[2].paths, QStringList({path("a")}));
+    QCOMPARE(day[2].filledMs, qint64(40000));
+    QCOMPARE(day[3].paths, QStringList({path("b"), path("c")}));
+
+    // Packing is only planning: nothing was recorded as aired
+    QCOMPARE(packer.pack({TEN.addSecs(10 * 60), 60000, QString()}).paths,
+             QStringList({path("a"), path("b")}));
+}
+
+void TestAdBreakPacker::testDailyPlaysAndRotation()
+{
+    AdBreakPacker packer(m_database);
+    packer.setCustomerSeparationMs(0);
+    packer.setSpots({spot("p", "P", 30), spot("q", "Q", 30)});
+
+    // Spots of the same length take turns
+    const QVector<AdBreakPacker::Break> rotation =
+        packer.packDay({{TEN, 30000, QString()},
+                        {TEN.addSecs(3600), 30000, QString()},
+                        {TEN.addSecs(7200), 30000, QString()}});
+    QCOMPARE(rotation[0].paths, QStringList({path("p")}));
+    QCOMPARE(rotation[1].paths, QStringList({path("q")}));
+    QCOMPARE(rotation[2].paths, QStringList({path("p")}));
+
+    packer.setMaxDailyPlays(1);
+    const QVector<AdBreakPacker::Break> limited =
+        packer.packDay({{TEN, 30000, QString()},
+                        {TEN.addSecs(3600), 30000, QString()},
+                        {TEN.addSecs(7200), 30000, QString()},
+                        {TEN.addDays(1), 30000, QString()}});
+    QCOMPARE(limited[0].paths, QStringList({path("p")}));
+    QCOMPARE(limited[1].paths, QStringList({path("q")}));
+    QVERIFY(limited[2].paths.isEmpty());
+    QCOMPARE(limited[3].paths, QStringList({path("p")}));
+}
+
+void TestAdBreakPacker::testPinnedSpot()
+{
+    AdBreakPacker packer(m_database);
+    packer.setSpots({spot("acme1", "Acme", 30), spot("acme2", "Acme", 20), spot("b", "B", 30),
+                     spot("long", "L", 90)});
+
+    // The others fill what the pinned spot leaves, away from its customer
+    const AdBreakPacker::Break filled = packer.pack({TEN, 60000, path("acme1")});
+    QCOMPARE(filled.paths, QStringList({path("acme1"), path("b")}));
+    QCOMPARE(filled.filledMs, qint64(60000));
+
+    const AdBreakPacker::Break over = packer.pack({TEN, 60000, path("long")});
+    QCOMPARE(over.paths, QStringList({path("long")}));
+    QCOMPARE(over.filledMs, qint64(90000));
+
+    const AdBreakPacker::Break unknown = packer.pack({TEN, 60000, path("new")});
+    QCOMPARE(unknown.paths, QStringList({path("new")}));
+    QCOMPARE(unknown.filledMs, qint64(-1));
+}
+
+void TestAdBreakPacker::testReadsPubTable()
+{
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("CREATE TABLE pub (id INTEGER PRIMARY KEY AUTOINCREMENT, name TEXT, "
+                       "path TEXT)"));
+    QVERIFY(query.prepare("INSERT INTO pub (name, path) VALUES (?, ?)"));
+    const QList<QPair<QString, QString>> pubs = {{"Acme", path("acme1")},
+                                                 {"Acme", path("acme2")},
+                                                 {"Bakery", path("bakery")},
+                                                 {"", path("anonymous")}};
+    for (const auto& pub : pubs) {
+        query.addBindValue(pub.first);
+        query.addBindValue(pub.second);
+        QVERIFY(query.exec());
+    }
+
+    AdBreakPacker packer(m_database);
+    int lookups = 0;
+    packer.setDurationLookup([&lookups](const QString& filePath) -> qint64 {
+        ++lookups;
+        return filePath.contains("anonymous") ? -1 : 30000000;
+    });
+    QVERIFY(packer.reload());
+    QSqlQuery columns(m_database);
+    QVERIFY(columns.exec("SELECT customer FROM pub"));
+
+    const QVector<AdBreakPacker::Spot> spots = packer.spots();
+    QCOMPARE(spots.size(), 4);
+    QCOMPARE(spots[0].customer, QString("Acme"));
+    QCOMPARE(spots[1].customer, QString("Acme"));
+    QCOMPARE(spots[3].customer, path("anonymous"));
+    QCOMPARE(spots[0].durationMs, qint64(30000));
+    QCOMPARE(spots[3].durationMs, qint64(-1));
+
+    QCOMPARE(packer.pack({TEN, 90000, QString()}).paths,
+             QStringList({path("acme1"), path("bakery")}));
+
+    // The customer column wins over the name
+    QVERIFY(query.exec(QString("UPDATE pub SET customer = 'Corner shop' WHERE path = '%1'")
+                           .arg(path("acme2"))));
+    packer.invalidate();
+    QCOMPARE(packer.pack({TEN, 90000, QString()}).filledMs, qint64(90000));
+    QCOMPARE(lookups, 5);
+
+    // What aired keeps its customers out of the next breaks
+    packer.setCustomerSeparationMs(30 * 60 * 1000);
+    packer.markAired(TEN, {path("acme1")});
+    QCOMPARE(packer.pack({TEN.addSecs(300), 90000, QString()}).paths,
+             QStringList({path("acme2"), path("bakery")}));
+}
+
+void TestAdBreakPacker::testPacksDayQuickly()
+{
+    QVector<AdBreakPacker::Spot> spots;
+    for (int i = 0; i < 200; ++i) {
+        AdBreakPacker::Spot pub;
+        pub.path = QString("/pub/%1.mp3").arg(i);
+        pub.customer = QString("customer %1").arg(i % 40);
+        pub.durationMs = 10000 + (i * 7919) % 50000;
+        spots.append(pub);
+    }
+    AdBreakPacker packer(m_database);
+    packer.setSpots(spots);
+
+    QVector<AdBreakPacker::Slot> day;
+    for (int i = 0; i < 48; ++i) {
+        day.append({TEN.addSecs(i * 1800), 180000, QString()});
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    const QVector<AdBreakPacker::Break> breaks = packer.packDay(day);
+    const qint64 elapsedMs = timer.elapsed();
+    QVERIFY2(elapsedMs < 2000, qPrintable(QString("%1 ms").arg(elapsedMs)));
+
+    QCOMPARE(breaks.size(), 48);
+    for (const AdBreakPacker::Break& result : breaks) {
+        QVERIFY(result.filledMs <= result.lengthMs);
+        QVERIFY(result.filledMs > 170000);
+        QSet<QString> customers;
+        for (const QString& filePath : result.paths) {
+            const int row = filePath.section('/', -1).section('.', 0, 0).toInt();
+            QVERIFY(!customers.contains(spots[row].customer));
+            customers.insert(spots[row].customer);
+        }
+    }
+}
+
+QTEST_MAIN(TestAdBreakPacker)
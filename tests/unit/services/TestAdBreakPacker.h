@@ -0,0 +1,42 @@
+#ifndef TESTADBREAKPACKER_H
+#define TESTADBREAKPACKER_H
+
+#include <QObject>
+#include <QSqlDatabase>
+#include <QTemporaryDir>
+#include <QTest>
+#include <memory>
+
+/**
+ * @brief Unit tests for AdBreakPacker class
+ *
+ * Tests filling ad breaks from the pub pool including:
+ * - The fill closest to the length of the break, never over it
+ * - One spot per customer in a break, and customers kept apart across breaks
+ * - The daily play limit and rotating between spots of the same length
+ * - Pinned spots, of known and unknown length
+ * - Reading the pub table, with the customer column added when missing
+ * - Packing a whole day quickly
+ */
+class TestAdBreakPacker : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testFillsBreak();
+    void testOneSpotPerCustomer();
+    void testCustomerSeparation();
+    void testDailyPlaysAndRotation();
+    void testPinnedSpot();
+    void testReadsPubTable();
+    void testPacksDayQuickly();
+
+private:
+    std::unique_ptr<QTemporaryDir> m_tempDir;
+    QSqlDatabase m_database;
+};
+
+#endif // TESTADBREAKPACKER_H
@@ -0,0 +1,149 @@
+#include "TestAirCheckRecorder.h"
+#include "../../../src/services/AirCheckRecorder.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QSignalSpy>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+namespace {
+
+// Stands in for ffmpeg's segment muxer: copies stdin into one file named
+// by expanding the strftime pattern in the last argument
+const char* FAKE_FFMPEG = "#!/bin/sh\n"
+                          "for out; do :; done\n"
+                          "cat > \"$(date +\"$out\")\"\n";
+
+} // namespace
+
+void TestAirCheckRecorder::init()
+{
+    m_tempDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_tempDir->isValid());
+
+    m_fakeFfmpeg = m_tempDir->filePath("fake-ffmpeg");
+    QFile script(m_fakeFfmpeg);
+    QVERIFY(script.open(QIODevice::WriteOnly));
+    script.write(FAKE_FFMPEG);
+    script.close();
+    script.setPermissions(QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner);
+}
+
+void TestAirCheckRecorder::cleanup()
+{
+    m_tempDir.reset();
+}
+
+QString TestAirCheckRecorder::touch(const QString& name)
+{
+    const QString path = m_tempDir->filePath(name);
+    QFile file(path);
+    file.open(QIODevice::WriteOnly);
+    return path;
+}
+
+void TestAirCheckRecorder::testFileStart()
+{
+    QCOMPARE(AirCheckRecorder::fileStart("/air/aircheck-20261014-150000.opus"),
+             QDateTime(QDate(2026, 10, 14), QTime(15, 0, 0)));
+    QVERIFY(!AirCheckRecorder::fileStart("/air/show-20261014-150000.opus").isValid());
+    QVERIFY(!AirCheckRecorder::fileStart("/air/aircheck-20261014.tracks.txt").isValid());
+    QCOMPARE(AirCheckRecorder::indexFile("/air", QDate(2026, 10, 14)),
+             QString("/air/aircheck-20261014.tracks.txt"));
+}
+
+void TestAirCheckRecorder::testLocate()
+{
+    // A run started at 14:23:10 and was cut on the hour
+    const QString first = touch("aircheck-20261014-142310.opus");
+    const QString second = touch("aircheck-20261014-150000.opus");
+    const QDate day(2026, 10, 14);
+
+    AirCheckRecorder::Position position =
+        AirCheckRecorder::locate(m_tempDir->path(), "opus", QDateTime(day, QTime(14, 50, 0)));
+    QCOMPARE(position.file, first);
+    QCOMPARE(position.offsetMs, qint64((26 * 60 + 50) * 1000));
+
+    position =
+        AirCheckRecorder::locate(m_tempDir->path(), "opus", QDateTime(day, QTime(15, 10, 5)));
+    QCOMPARE(position.file, second);
+    QCOMPARE(position.offsetMs, qint64((10 * 60 + 5) * 1000));
+
+    // Before the run, and after the last file ended
+    QVERIFY(AirCheckRecorder::locate(m_tempDir->path(), "opus", QDateTime(day, QTime(14, 0, 0)))
+                .file.isEmpty());
+    QVERIFY(AirCheckRecorder::locate(m_tempDir->path(), "opus", QDateTime(day, QTime(16, 30, 0)))
+                .file.isEmpty());
+}
+
+void TestAirCheckRecorder::testRecordsAndIndexes()
+{
+    // Pulled on the encoder thread
+    const std::vector<float> block(960, 0.25f);
+    std::atomic<int> blocks{5};
+
+    AirCheckRecorder airCheck;
+    airCheck.setProgram(m_fakeFfmpeg);
+    airCheck.setDirectory(m_tempDir->path());
+    airCheck.setSource(
+        [&](float* data, int samples) {
+            if (blocks == 0) {
+                return 0;
+            }
+            --blocks;
+            const int count = std::min(samples, int(block.size()));
+            std::copy(block.begin(), block.begin() + count, data);
+            return count;
+        },
+        48000);
+    QSignalSpy written(&airCheck, &AirCheckRecorder::fileWritten);
+
+    QVERIFY(!airCheck.markTrack("before.mp3"));
+    QVERIFY(airCheck.start());
+    QVERIFY(airCheck.isRunning());
+
+    const QDateTime at = QDateTime::currentDateTime();
+    QVERIFY(airCheck.markTrack("first.mp3", at));
+    QVERIFY(airCheck.markTrack("second\ttitle.mp3", at.addSecs(1)));
+    QFile index(AirCheckRecorder::indexFile(m_tempDir->path(), at.date()));
+    QVERIFY(index.open(QIODevice::ReadOnly | QIODevice::Text));
+    const QString expected = QString("%1\tfirst.mp3\n%2\tsecond title.mp3\n")
+                                 .arg(at.toString("HH:mm:ss"), at.addSecs(1).toString("HH:mm:ss"));
+    QCOMPARE(QString::fromUtf8(index.readAll()), expected);
+
+    QTRY_COMPARE(blocks.load(), 0);
+    airCheck.stop();
+    QTRY_COMPARE(written.size(), 1);
+
+    const QString file = written.first().at(0).toString();
+    QVERIFY(AirCheckRecorder::fileStart(file).isValid());
+    QCOMPARE(QFileInfo(file).suffix(), QString("opus"));
+    QFile audio(file);
+    QVERIFY(audio.open(QIODevice::ReadOnly));
+    QCOMPARE(audio.size(), qint64(5 * block.size() * sizeof(float)));
+}
+
+void TestAirCheckRecorder::testPrune()
+{
+    const QString old = touch("aircheck-20261001-100000.opus");
+    const QString oldIndex = touch("aircheck-20261001.tracks.txt");
+    const QString recent = touch("aircheck-20261013-100000.opus");
+    const QString recentIndex = touch("aircheck-20261013.tracks.txt");
+    const QString other = touch("show-20261001-100000.opus");
+
+    AirCheckRecorder airCheck;
+    airCheck.setDirectory(m_tempDir->path());
+    const QDateTime now(QDate(2026, 10, 14), QTime(12, 0, 0));
+    QCOMPARE(airCheck.prune(now), 0);
+
+    airCheck.setRetentionDays(7);
+    QCOMPARE(airCheck.prune(now), 2);
+    QVERIFY(!QFile::exists(old));
+    QVERIFY(!QFile::exists(oldIndex));
+    QVERIFY(QFile::exists(recent));
+    QVERIFY(QFile::exists(recentIndex));
+    QVERIFY(QFile::exists(other));
+}
+
+QTEST_MAIN(TestAirCheckRecorder)
@@ -0,0 +1,38 @@
+#ifndef TESTAIRCHECKRECORDER_H
+#define TESTAIRCHECKRECORDER_H
+
+#include <QObject>
+#include <QTest>
+#include <QTemporaryDir>
+#include <memory>
+
+/**
+ * @brief Unit tests for AirCheckRecorder class
+ *
+ * Tests the around-the-clock recording of the output including:
+ * - Start times read from the file names
+ * - Finding the file and offset of a moment
+ * - Recording hourly files from a reader and logging tracks in the index
+ * - Removing files older than the retention period
+ */
+class TestAirCheckRecorder : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testFileStart();
+    void testLocate();
+    void testRecordsAndIndexes();
+    void testPrune();
+
+private:
+    QString touch(const QString& name);
+
+    std::unique_ptr<QTemporaryDir> m_tempDir;
+    QString m_fakeFfmpeg;
+};
+
+#endif // TESTAIRCHECKRECORDER_H
@@ -0,0 +1,245 @@
+#include "TestAnalysisIndex.h"
+#include "../../../src/services/AnalysisIndex.h"
+#include <QFile>
+#include <QSqlQuery>
+#include <QVariant>
+
+namespace {
+
+const char* CONNECTION_NAME = "test_analysis_index_connection";
+
+const QString HASH_A = "00000000000000a1";
+const QString HASH_B = "00000000000000b2";
+const QString HASH_C = "ffffffffffffff03";
+
+QVariant column(QSqlDatabase& database, const QString& path, const QString& name)
+{
+    QSqlQuery query(database);
+    query.prepare(QString("SELECT %1 FROM musics WHERE path = :path").arg(name));
+    query.bindValue(":path", path);
+    return query.exec() && query.next() ? query.value(0) : QVariant("missing");
+}
+
+bool insertTrack(QSqlDatabase& database, const QString& path, const QString& hash,
+                 const QVariant& cueIn = QVariant(), const QVariant& cueOut = QVariant(),
+                 const QVariant& lufs = QVariant())
+{
+    QSqlQuery query(database);
+    query.prepare("INSERT INTO musics (path, content_hash, cue_in_ms, cue_out_ms, loudness_lufs, "
+                  "true_peak_dbtp) VALUES (?, ?, ?, ?, ?, ?)");
+    query.addBindValue(path);
+    query.addBindValue(hash);
+    query.addBindValue(cueIn);
+    query.addBindValue(cueOut);
+    query.addBindValue(lufs);
+    query.addBindValue(lufs.isNull() ? QVariant() : QVariant(-1.5));
+    return query.exec();
+}
+
+} // namespace
+
+void TestAnalysisIndex::init()
+{
+    m_tempDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_tempDir->isValid());
+
+    m_database = QSqlDatabase::addDatabase("QSQLITE", CONNECTION_NAME);
+    m_database.setDatabaseName(m_tempDir->filePath("test.db"));
+    QVERIFY(m_database.open());
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("CREATE TABLE musics (id INTEGER PRIMARY KEY, path TEXT, "
+                       "content_hash TEXT, cue_in_ms INTEGER, cue_out_ms INTEGER, "
+                       "intro_ms INTEGER, fade_ms INTEGER, segue_ms INTEGER, "
+                       "loudness_lufs REAL, true_peak_dbtp REAL)"));
+}
+
+void TestAnalysisIndex::cleanup()
+{
+    if (m_database.isOpen()) {
+        m_database.close();
+    }
+    m_database = QSqlDatabase();
+    QSqlDatabase::removeDatabase(CONNECTION_NAME);
+    m_tempDir.reset();
+}
+
+QString TestAnalysisIndex::write(const QString& name, const QByteArray& data)
+{
+    const QString path = m_tempDir->filePath(name);
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size()) {
+        return QString();
+    }
+    return path;
+}
+
+void TestAnalysisIndex::testHashKey()
+{
+    QCOMPARE(AnalysisIndex::hashKey(HASH_A), quint64(0xa1));
+    QCOMPARE(AnalysisIndex::hashKey(HASH_C), quint64(0xffffffffffffff03ULL));
+    QCOMPARE(AnalysisIndex::hashKey(""), quint64(0));
+    QCOMPARE(AnalysisIndex::hashKey("a1"), quint64(0));
+    QCOMPARE(AnalysisIndex::hashKey("zzzzzzzzzzzzzzzz"), quint64(0));
+    QCOMPARE(AnalysisIndex::defaultPath("/music"), QString("/music/.xfb-analysis.index"));
+}
+
+void TestAnalysisIndex::testWriteAndFind()
+{
+    const QString peakPath = write("b.peak", QByteArray("XFBW peak data"));
+    QVERIFY(!peakPath.isEmpty());
+
+    // Written out of order, with a duplicate that is dropped
+    AnalysisIndex::Entry c;
+    c.hash = AnalysisIndex::hashKey(HASH_C);
+    c.content = AnalysisIndex::HasLoudness;
+    c.integratedLufs = -14.25;
+    c.truePeakDbtp = -0.5;
+    AnalysisIndex::Entry b;
+    b.hash = AnalysisIndex::hashKey(HASH_B);
+    b.content = AnalysisIndex::HasCuePoints | AnalysisIndex::HasPeaks;
+    b.cue.inMs = 120;
+    b.cue.outMs = 181000;
+    b.cue.segueMs = 175500;
+    b.peakPath = peakPath;
+    AnalysisIndex::Entry duplicate = c;
+    duplicate.integratedLufs = -30.0;
+
+    const QString indexPath = m_tempDir->filePath("library.index");
+    QString error;
+    QVERIFY2(AnalysisIndex::write(indexPath, {c, b, duplicate}, &error), qPrintable(error));
+
+    AnalysisIndex index;
+    QVERIFY(index.open(indexPath));
+    QCOMPARE(index.count(), 2);
+
+    AnalysisIndex::Entry found;
+    QVERIFY(index.find(b.hash, &found));
+    QCOMPARE(found.content, b.content);
+    QCOMPARE(found.cue, b.cue);
+    QCOMPARE(found.peaks, QByteArray("XFBW peak data"));
+
+    QVERIFY(index.find(c.hash, &found));
+    QCOMPARE(found.content, quint32(AnalysisIndex::HasLoudness));
+    QCOMPARE(found.integratedLufs, -14.25);
+    QCOMPARE(found.truePeakDbtp, -0.5);
+    QVERIFY(found.peaks.isEmpty());
+
+    QVERIFY(!index.find(AnalysisIndex::hashKey(HASH_A)));
+}
+
+void TestAnalysisIndex::testRejectsInvalidFiles()
+{
+    const QString indexPath = m_tempDir->filePath("valid.index");
+    AnalysisIndex::Entry entry;
+    entry.hash = 1;
+    entry.content = AnalysisIndex::HasLoudness;
+    QVERIFY(AnalysisIndex::write(indexPath, {entry}));
+    QFile file(indexPath);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QByteArray valid = file.readAll();
+    file.close();
+
+    AnalysisIndex index;
+    QVERIFY(!index.open(m_tempDir->filePath("missing.index")));
+    QVERIFY(!index.open(write("short.index", valid.left(AnalysisIndex::HEADER_SIZE - 1))));
+
+    QByteArray magic = valid;
+    magic[3] = 'W';
+    QVERIFY(!index.open(write("magic.index", magic)));
+
+    QByteArray version = valid;
+    version[4] = char(AnalysisIndex::VERSION + 1);
+    QVERIFY(!index.open(write("version.index", version)));
+
+    // The header counts an entry that is not in the file
+    QVERIFY(!index.open(write("truncated.index", valid.left(valid.size() - 1))));
+    QVERIFY(!index.isOpen());
+
+    QVERIFY(index.open(indexPath));
+    QVERIFY(index.find(1));
+}
+
+void TestAnalysisIndex::testExportsRoot()
+{
+    QVERIFY(insertTrack(m_database, "/music/a.ogg", HASH_A, 250, 200000, -11.0));
+    QVERIFY(insertTrack(m_database, "/music/sub/b.ogg", HASH_B));
+    QVERIFY(insertTrack(m_database, "/musicology/c.ogg", HASH_C, 100));
+    QVERIFY(insertTrack(m_database, "/music/unhashed.ogg", QString(), 100));
+
+    const QString peakPath = write("b.peak", QByteArray("peaks of b"));
+    const QString indexPath = m_tempDir->filePath("music.index");
+    QString error;
+    const int written = AnalysisIndex::exportLibrary(
+        m_database, "/music/", indexPath,
+        [&](const QString& path) { return path == "/music/sub/b.ogg" ? peakPath : QString(); },
+        &error);
+    QVERIFY2(written == 2, qPrintable(error));
+
+    AnalysisIndex index;
+    QVERIFY(index.open(indexPath));
+    QCOMPARE(index.count(), 2);
+    AnalysisIndex::Entry entry;
+    QVERIFY(index.find(AnalysisIndex::hashKey(HASH_A), &entry));
+    QCOMPARE(entry.content,
+             quint32(AnalysisIndex::HasCuePoints | AnalysisIndex::HasLoudness));
+    QCOMPARE(entry.cue.inMs, qint64(250));
+    QCOMPARE(entry.cue.outMs, qint64(200000));
+    QCOMPARE(entry.cue.introMs, qint64(-1));
+    QCOMPARE(entry.integratedLufs, -11.0);
+    QVERIFY(index.find(AnalysisIndex::hashKey(HASH_B), &entry));
+    QCOMPARE(entry.content, quint32(AnalysisIndex::HasPeaks));
+    QCOMPARE(entry.peaks, QByteArray("peaks of b"));
+    // Outside the root, only sharing its name
+    QVERIFY(!index.find(AnalysisIndex::hashKey(HASH_C)));
+}
+
+void TestAnalysisIndex::testImportFillsMissingAnalysis()
+{
+    QVERIFY(insertTrack(m_database, "/music/a.ogg", HASH_A, 250, 200000, -11.0));
+    QVERIFY(insertTrack(m_database, "/music/b.ogg", HASH_B, 500));
+    const QString peakPath = write("a.peak", QByteArray("peaks of a"));
+    const QString indexPath = m_tempDir->filePath("music.index");
+    const auto peaksOfA = [&](const QString& path) {
+        return path == "/music/a.ogg" ? peakPath : QString();
+    };
+    QCOMPARE(AnalysisIndex::exportLibrary(m_database, "/music", indexPath, peaksOfA), 2);
+
+    // The same files on another machine; b was already trimmed there
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("DELETE FROM musics"));
+    const QString renamed = "/mnt/music/renamed.ogg";
+    QVERIFY(insertTrack(m_database, renamed, HASH_A));
+    QVERIFY(insertTrack(m_database, "/mnt/music/b.ogg", HASH_B, 900));
+    QVERIFY(insertTrack(m_database, "/elsewhere/a.ogg", HASH_A));
+
+    AnalysisIndex index;
+    QVERIFY(index.open(indexPath));
+    const QString importedPeaks = m_tempDir->filePath("cache/renamed.peak");
+    const QList<AnalysisIndex::Imported> imported =
+        index.importInto(m_database, "/mnt/music", [&](const QString& path) {
+            return path == renamed ? importedPeaks : QString();
+        });
+
+    QCOMPARE(imported.size(), 1);
+    QCOMPARE(imported.first().path, renamed);
+    QCOMPARE(imported.first().content, quint32(AnalysisIndex::HasCuePoints
+                                                | AnalysisIndex::HasLoudness
+                                                | AnalysisIndex::HasPeaks));
+    QCOMPARE(column(m_database, renamed, "cue_in_ms").toLongLong(), qint64(250));
+    QCOMPARE(column(m_database, renamed, "cue_out_ms").toLongLong(), qint64(200000));
+    QVERIFY(column(m_database, renamed, "intro_ms").isNull());
+    QCOMPARE(column(m_database, renamed, "loudness_lufs").toDouble(), -11.0);
+    QCOMPARE(column(m_database, renamed, "true_peak_dbtp").toDouble(), -1.5);
+    QFile peaks(importedPeaks);
+    QVERIFY(peaks.open(QIODevice::ReadOnly));
+    QCOMPARE(peaks.readAll(), QByteArray("peaks of a"));
+
+    // Cue points of this machine are kept, and tracks outside the root left alone
+    QCOMPARE(column(m_database, "/mnt/music/b.ogg", "cue_in_ms").toLongLong(), qint64(900));
+    QVERIFY(column(m_database, "/elsewhere/a.ogg", "cue_in_ms").isNull());
+
+    // Nothing is left to take the second time
+    QVERIFY(index.importInto(m_database, "/mnt/music", {}).isEmpty());
+}
+
+QTEST_MAIN(TestAnalysisIndex)
@@ -0,0 +1,40 @@
+#ifndef TESTANALYSISINDEX_H
+#define TESTANALYSISINDEX_H
+
+#include <QObject>
+#include <QTest>
+#include <QSqlDatabase>
+#include <QTemporaryDir>
+#include <memory>
+
+/**
+ * @brief Unit tests for AnalysisIndex class
+ *
+ * Tests the portable analysis index of a library root including:
+ * - Writing entries and finding them by content hash in the mapped file
+ * - Refusing files that are not analysis indexes of this version
+ * - Exporting the analyzed tracks under a root only
+ * - Importing on a library mounted elsewhere without overwriting local analysis
+ */
+class TestAnalysisIndex : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testHashKey();
+    void testWriteAndFind();
+    void testRejectsInvalidFiles();
+    void testExportsRoot();
+    void testImportFillsMissingAnalysis();
+
+private:
+    QString write(const QString& name, const QByteArray& data);
+
+    std::unique_ptr<QTemporaryDir> m_tempDir;
+    QSqlDatabase m_database;
+};
+
+#endif // TESTANALYSISINDEX_H
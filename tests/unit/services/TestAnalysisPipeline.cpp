@@ -0,0 +1,195 @@
+#include "TestAnalysisPipeline.h"
+#include "../../../src/services/AnalysisPipeline.h"
+#include "../../../src/services/CuePointStore.h"
+#include "../../../src/services/ReplayGainStore.h"
+#include <QSignalSpy>
+#include <QSqlQuery>
+#include <QVector>
+#include <atomic>
+#include <cmath>
+
+namespace {
+
+const char* CONNECTION_NAME = "test_analysis_pipeline_connection";
+const char* TRACK_A = "/music/a.ogg";
+const char* TRACK_B = "/music/b.ogg";
+const char* BROKEN = "/music/broken.ogg";
+
+// Stands in for decoding: a second of silence, then three seconds of a stereo tone
+AnalysisPipeline::Decoder fakeDecoder(std::atomic<int>* decodes)
+{
+    return [decodes](const QString& filePath, int sampleRate, const PcmDecoder::Sink& sink,
+                     QString* error) {
+        ++*decodes;
+        if (filePath.contains("broken")) {
+            *error = "Invalid data";
+            return false;
+        }
+        const int channels = 2;
+        QVector<float> block(sampleRate / 10 * channels);
+        for (int i = 0; i < 40; ++i) {
+            for (int frame = 0; frame < block.size() / channels; ++frame) {
+                const float sample =
+                    i < 10 ? 0.0f
+                           : 0.5f * float(std::sin(2.0 * M_PI * 440.0 * frame / sampleRate));
+                block[frame * channels] = sample;
+                block[frame * channels + 1] = sample;
+            }
+            sink(block.constData(), block.size(), sampleRate, channels);
+        }
+        return true;
+    };
+}
+
+// Counts the samples it was fed and stores the count in a column of its own
+class CountingAnalyzer : public AnalysisPipeline::Analyzer
+{
+public:
+    CountingAnalyzer(const QString& column, QStringList* published)
+        : m_column(column)
+        , m_published(published)
+    {
+    }
+
+    void feed(const float*, qint64 count, int, int) override { m_samples += count; }
+    QVariantMap columns() const override { return {{m_column, m_samples}}; }
+    void publish(const QString& filePath) override { m_published->append(filePath); }
+
+private:
+    QString m_column;
+    QStringList* m_published;
+    qint64 m_samples = 0;
+};
+
+AnalysisPipeline::Factory counting(const QString& column, QStringList* published)
+{
+    return [column, published](const QString&) {
+        return std::make_unique<CountingAnalyzer>(column, published);
+    };
+}
+
+} // namespace
+
+void TestAnalysisPipeline::init()
+{
+    m_tempDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_tempDir->isValid());
+
+    m_database = QSqlDatabase::addDatabase("QSQLITE", CONNECTION_NAME);
+    m_database.setDatabaseName(m_tempDir->filePath("test.db"));
+    QVERIFY(m_database.open());
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("CREATE TABLE musics (id INTEGER PRIMARY KEY, path TEXT, "
+                       "first_count INTEGER, second_count INTEGER)"));
+    for (const char* path : {TRACK_A, TRACK_B, BROKEN}) {
+        query.prepare("INSERT INTO musics (path) VALUES (?)");
+        query.addBindValue(QString(path));
+        QVERIFY(query.exec());
+    }
+}
+
+void TestAnalysisPipeline::cleanup()
+{
+    if (m_database.isOpen()) {
+        m_database.close();
+    }
+    m_database = QSqlDatabase();
+    QSqlDatabase::removeDatabase(CONNECTION_NAME);
+    m_tempDir.reset();
+}
+
+void TestAnalysisPipeline::testDecodesOnce()
+{
+    ReplayGainStore replayGain(m_database);
+    QVERIFY(replayGain.initialize());
+    CuePointStore cuePoints(m_database);
+    QVERIFY(cuePoints.initialize());
+
+    std::atomic<int> decodes{0};
+    AnalysisPipeline pipeline(m_database);
+    pipeline.setDecoder(fakeDecoder(&decodes));
+    pipeline.addAnalyzer(AnalysisPipeline::loudness(&replayGain));
+    pipeline.addAnalyzer(AnalysisPipeline::cuePoints(&cuePoints));
+    QSignalSpy finished(&pipeline, &AnalysisPipeline::finished);
+    QSignalSpy analyzed(&pipeline, &AnalysisPipeline::trackAnalyzed);
+
+    QCOMPARE(pipeline.scan({TRACK_A, TRACK_B}), 2);
+    QVERIFY(finished.wait(5000));
+    QCOMPARE(decodes.load(), 2);
+    QCOMPARE(finished.at(0).at(0).toInt(), 2);
+    QCOMPARE(analyzed.count(), 2);
+
+    // Both stores know the results, and the table holds them
+    QVERIFY(replayGain.contains(TRACK_A));
+    QVERIFY(replayGain.loudness(TRACK_A).integratedLufs < 0.0);
+    QVERIFY(cuePoints.cuePoints(TRACK_B).inMs > 0);
+
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("SELECT loudness_lufs, cue_in_ms FROM musics WHERE path = '/music/a.ogg'"));
+    QVERIFY(query.next());
+    QVERIFY(!query.value(0).isNull());
+    QCOMPARE(query.value(1).toLongLong(), cuePoints.cuePoints(TRACK_A).inMs);
+}
+
+void TestAnalysisPipeline::testWritesAllColumns()
+{
+    std::atomic<int> decodes{0};
+    QStringList published;
+    AnalysisPipeline pipeline(m_database);
+    pipeline.setDecoder(fakeDecoder(&decodes));
+    pipeline.addAnalyzer(counting("first_count", &published));
+    pipeline.addAnalyzer(counting("second_count", &published));
+    QSignalSpy finished(&pipeline, &AnalysisPipeline::finished);
+
+    pipeline.scan({TRACK_A});
+    QVERIFY(finished.wait(5000));
+    QCOMPARE(published, QStringList({TRACK_A, TRACK_A}));
+
+    // Every analyzer saw the whole file from the one decode
+    const qint64 samples = 40 * (AnalysisPipeline::DEFAULT_SAMPLE_RATE / 10) * 2;
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("SELECT first_count, second_count FROM musics WHERE path = '/music/a.ogg'"));
+    QVERIFY(query.next());
+    QCOMPARE(query.value(0).toLongLong(), samples);
+    QCOMPARE(query.value(1).toLongLong(), samples);
+}
+
+void TestAnalysisPipeline::testFailedDecode()
+{
+    std::atomic<int> decodes{0};
+    QStringList published;
+    AnalysisPipeline pipeline(m_database);
+    pipeline.setDecoder(fakeDecoder(&decodes));
+    pipeline.addAnalyzer(counting("first_count", &published));
+    QSignalSpy finished(&pipeline, &AnalysisPipeline::finished);
+    QSignalSpy progress(&pipeline, &AnalysisPipeline::progressChanged);
+
+    pipeline.scan({TRACK_A, BROKEN});
+    QVERIFY(finished.wait(5000));
+    QCOMPARE(finished.at(0).at(0).toInt(), 1);
+    QCOMPARE(finished.at(0).at(1).toInt(), 1);
+    QCOMPARE(progress.last().at(0).toInt(), 2);
+    QCOMPARE(published, QStringList({TRACK_A}));
+
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("SELECT first_count FROM musics WHERE path = '/music/broken.ogg'"));
+    QVERIFY(query.next());
+    QVERIFY(query.value(0).isNull());
+}
+
+void TestAnalysisPipeline::testSkipsTracksNeedingNothing()
+{
+    std::atomic<int> decodes{0};
+    AnalysisPipeline pipeline(m_database);
+    pipeline.setDecoder(fakeDecoder(&decodes));
+    pipeline.addAnalyzer([](const QString&) { return nullptr; });
+    QSignalSpy finished(&pipeline, &AnalysisPipeline::finished);
+
+    QCOMPARE(pipeline.scan({TRACK_A, TRACK_B}), 2);
+    QCOMPARE(finished.count(), 1);
+    QCOMPARE(finished.at(0).at(0).toInt(), 2);
+    QCOMPARE(decodes.load(), 0);
+    QVERIFY(!pipeline.isRunning());
+}
+
+QTEST_MAIN(TestAnalysisPipeline)
@@ -0,0 +1,37 @@
+#ifndef TESTANALYSISPIPELINE_H
+#define TESTANALYSISPIPELINE_H
+
+#include <QObject>
+#include <QTest>
+#include <QSqlDatabase>
+#include <QTemporaryDir>
+#include <memory>
+
+/**
+ * @brief Unit tests for AnalysisPipeline class
+ *
+ * Tests the single-decode library analysis including:
+ * - Decoding each track once for all the analyzers
+ * - Writing the columns of every analyzer and publishing them afterwards
+ * - Counting tracks that cannot be decoded
+ * - Not decoding tracks that no analyzer needs
+ */
+class TestAnalysisPipeline : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testDecodesOnce();
+    void testWritesAllColumns();
+    void testFailedDecode();
+    void testSkipsTracksNeedingNothing();
+
+private:
+    std::unique_ptr<QTemporaryDir> m_tempDir;
+    QSqlDatabase m_database;
+};
+
+#endif // TESTANALYSISPIPELINE_H
@@ -0,0 +1,170 @@
+#include "TestAnnouncementBus.h"
+#include "../../../src/services/AnnouncementBus.h"
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QStringList>
+
+namespace {
+
+AnnouncementBus::Announcement make(QObject* context, QStringList* said, const QString& message,
+                                   const QString& region = QString(),
+                                   AnnouncementBus::Priority priority =
+                                       AnnouncementBus::Priority::Normal)
+{
+    AnnouncementBus::Announcement announcement;
+    announcement.region = region;
+    announcement.message = message;
+    announcement.priority = priority;
+    announcement.context = context;
+    announcement.deliver = [said](const AnnouncementBus::Announcement& a) { *said << a.message; };
+    return announcement;
+}
+
+} // namespace
+
+void TestAnnouncementBus::testIdleIsNotArmed()
+{
+    AnnouncementBus bus;
+    QObject context;
+    QStringList said;
+    QVERIFY(!bus.isArmed());
+
+    bus.post(make(&context, &said, "hello"));
+    QVERIFY(bus.isArmed());
+    QCOMPARE(bus.pendingCount(), 1);
+
+    QTRY_COMPARE(said, QStringList{"hello"});
+    QVERIFY(!bus.isArmed());
+    QCOMPARE(bus.pendingCount(), 0);
+}
+
+void TestAnnouncementBus::testCoalescesRegion()
+{
+    AnnouncementBus bus;
+    QObject context;
+    QStringList said;
+
+    bus.post(make(&context, &said, "10%", "progress"));
+    bus.post(make(&context, &said, "20%", "progress"));
+    bus.post(make(&context, &said, "30%", "progress"));
+    QCOMPARE(bus.pendingCount(), 1);
+
+    QTRY_COMPARE(said, QStringList{"30%"});
+    QCOMPARE(bus.statistics().coalesced, qint64(2));
+    QCOMPARE(bus.statistics().delivered, qint64(1));
+}
+
+void TestAnnouncementBus::testDropsDuplicates()
+{
+    AnnouncementBus bus;
+    QObject context;
+    QStringList said;
+
+    bus.post(make(&context, &said, "Saved"));
+    bus.post(make(&context, &said, "Saved"));
+    QCOMPARE(bus.pendingCount(), 1);
+    QTRY_COMPARE(said, QStringList{"Saved"});
+
+    // Said a moment ago
+    bus.post(make(&context, &said, "Saved"));
+    QCOMPARE(bus.pendingCount(), 0);
+    QCOMPARE(bus.statistics().duplicates, qint64(2));
+}
+
+void TestAnnouncementBus::testThrottlesRegion()
+{
+    AnnouncementBus bus;
+    QObject context;
+    QStringList said;
+
+    AnnouncementBus::Announcement first = make(&context, &said, "first", "clock");
+    first.throttleMs = 400;
+    bus.post(first);
+    QTRY_COMPARE(said.size(), 1);
+
+    QElapsedTimer elapsed;
+    elapsed.start();
+    AnnouncementBus::Announcement second = make(&context, &said, "second", "clock");
+    second.throttleMs = 400;
+    bus.post(second);
+
+    QTest::qWait(150);
+    QCOMPARE(said.size(), 1);
+    QTRY_COMPARE(said, (QStringList{"first", "second"}));
+    QVERIFY(elapsed.elapsed() >= 300);
+}
+
+void TestAnnouncementBus::testHoldsUntilNotBefore()
+{
+    AnnouncementBus bus;
+    QObject context;
+    QStringList said;
+
+    QElapsedTimer elapsed;
+    elapsed.start();
+    AnnouncementBus::Announcement later = make(&context, &said, "later");
+    later.notBefore = QDateTime::currentMSecsSinceEpoch() + 300;
+    bus.post(later);
+
+    QTest::qWait(100);
+    QVERIFY(said.isEmpty());
+    QVERIFY(bus.isArmed());
+    QTRY_COMPARE(said, QStringList{"later"});
+    QVERIFY(elapsed.elapsed() >= 250);
+}
+
+void TestAnnouncementBus::testPriorityOrder()
+{
+    AnnouncementBus bus;
+    QObject context;
+    QStringList said;
+
+    bus.post(make(&context, &said, "low", QString(), AnnouncementBus::Priority::Low));
+    bus.post(make(&context, &said, "normal", QString(), AnnouncementBus::Priority::Normal));
+    bus.post(make(&context, &said, "high", QString(), AnnouncementBus::Priority::High));
+
+    QTRY_COMPARE(said, (QStringList{"high", "normal", "low"}));
+}
+
+void TestAnnouncementBus::testCriticalIsImmediate()
+{
+    AnnouncementBus bus;
+    QObject context;
+    QStringList said;
+
+    bus.post(make(&context, &said, "waiting", "stream"));
+    bus.post(make(&context, &said, "Stream lost", "stream", AnnouncementBus::Priority::Critical));
+
+    // Said before post() returned, and the out-of-date message of its region is gone
+    QCOMPARE(said, QStringList{"Stream lost"});
+    QCOMPARE(bus.pendingCount(), 0);
+    QVERIFY(!bus.isArmed());
+}
+
+void TestAnnouncementBus::testClearAndDeadContext()
+{
+    AnnouncementBus bus;
+    QObject kept;
+    QStringList said;
+
+    bus.post(make(&kept, &said, "one"));
+    bus.post(make(&kept, &said, "alarm", QString(), AnnouncementBus::Priority::Critical));
+    bus.post(make(&kept, &said, "two", "region"));
+    QCOMPARE(bus.pendingCount(&kept), 2);
+    bus.clear(&kept, QStringLiteral("region"));
+    QCOMPARE(bus.pendingCount(&kept), 1);
+    bus.clear(&kept);
+    QCOMPARE(bus.pendingCount(), 0);
+    QVERIFY(!bus.isArmed());
+
+    auto* gone = new QObject;
+    bus.post(make(gone, &said, "never"));
+    QCOMPARE(bus.pendingCount(gone), 1);
+    delete gone;
+
+    QTest::qWait(AnnouncementBus::MIN_SPACING_MS * 3);
+    QCOMPARE(said, QStringList{"alarm"});
+    QVERIFY(!bus.isArmed());
+}
+
+QTEST_MAIN(TestAnnouncementBus)
@@ -0,0 +1,33 @@
+#ifndef TESTANNOUNCEMENTBUS_H
+#define TESTANNOUNCEMENTBUS_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for AnnouncementBus class
+ *
+ * Tests the shared announcement queue including:
+ * - No timer armed while nothing waits
+ * - Messages of one region merged into the latest
+ * - Duplicates dropped, waiting or just delivered
+ * - Regions throttled, and announcements held until notBefore
+ * - Delivery by priority, Critical at once
+ * - Announcements cleared or dropped with their poster
+ */
+class TestAnnouncementBus : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testIdleIsNotArmed();
+    void testCoalescesRegion();
+    void testDropsDuplicates();
+    void testThrottlesRegion();
+    void testHoldsUntilNotBefore();
+    void testPriorityOrder();
+    void testCriticalIsImmediate();
+    void testClearAndDeadContext();
+};
+
+#endif // TESTANNOUNCEMENTBUS_H
@@ -0,0 +1,181 @@
+#include "TestArchiveRetention.h"
+#include "../../../src/services/ArchiveRetention.h"
+#include <QDir>
+#include <QFile>
+#include <QSignalSpy>
+#include <QSqlQuery>
+
+namespace {
+
+const char* CONNECTION_NAME = "test_archive_retention_connection";
+
+QStringList names(const QList<QFileInfo>& files)
+{
+    QStringList result;
+    for (const QFileInfo& file : files) {
+        result << file.fileName();
+    }
+    return result;
+}
+
+} // namespace
+
+void TestArchiveRetention::init()
+{
+    m_tempDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_tempDir->isValid());
+    QVERIFY(QDir(m_tempDir->path()).mkpath("programs"));
+
+    m_database = QSqlDatabase::addDatabase("QSQLITE", CONNECTION_NAME);
+    m_database.setDatabaseName(m_tempDir->filePath("test.db"));
+    QVERIFY(m_database.open());
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("CREATE TABLE programs (id INTEGER PRIMARY KEY AUTOINCREMENT, "
+                       "name TEXT, path TEXT)"));
+}
+
+void TestArchiveRetention::cleanup()
+{
+    if (m_database.isOpen()) {
+        m_database.close();
+    }
+    m_database = QSqlDatabase();
+    QSqlDatabase::removeDatabase(CONNECTION_NAME);
+    m_tempDir.reset();
+}
+
+QString TestArchiveRetention::touch(const QString& name, int daysOld, int bytes)
+{
+    const QString path = m_tempDir->filePath("programs/" + name);
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return QString();
+    }
+    file.write(QByteArray(bytes, 'x'));
+    file.setFileTime(QDateTime::currentDateTime().addDays(-daysOld),
+                     QFileDevice::FileModificationTime);
+    file.close();
+
+    QSqlQuery query(m_database);
+    query.prepare("INSERT INTO programs (name, path) VALUES (?, ?)");
+    query.addBindValue(name);
+    query.addBindValue(path);
+    query.exec();
+    return path;
+}
+
+void TestArchiveRetention::testExpiredByAge()
+{
+    QList<QFileInfo> files;
+    files << QFileInfo(touch("new.ogg", 1)) << QFileInfo(touch("old.ogg", 40))
+          << QFileInfo(touch("older.ogg", 100));
+
+    ArchiveRetention::Policy policy;
+    policy.directory = m_tempDir->filePath("programs");
+    policy.maxAgeDays = 30;
+    QCOMPARE(names(ArchiveRetention::expired(files, policy, QDateTime::currentDateTime())),
+             QStringList({"older.ogg", "old.ogg"}));
+
+    policy.maxAgeDays = 0;
+    QVERIFY(ArchiveRetention::expired(files, policy, QDateTime::currentDateTime()).isEmpty());
+}
+
+void TestArchiveRetention::testExpiredByCountAndQuota()
+{
+    QList<QFileInfo> files;
+    for (int day = 1; day <= 5; ++day) {
+        files << QFileInfo(touch(QString("day%1.ogg").arg(day), day, 100));
+    }
+
+    ArchiveRetention::Policy policy;
+    policy.directory = m_tempDir->filePath("programs");
+    policy.maxCount = 3;
+    QCOMPARE(names(ArchiveRetention::expired(files, policy, QDateTime::currentDateTime())),
+             QStringList({"day5.ogg", "day4.ogg"}));
+
+    // The newest files that fit the quota stay
+    policy.maxCount = 0;
+    policy.maxBytes = 250;
+    QCOMPARE(names(ArchiveRetention::expired(files, policy, QDateTime::currentDateTime())),
+             QStringList({"day5.ogg", "day4.ogg", "day3.ogg"}));
+}
+
+void TestArchiveRetention::testRemovesFilesAndRows()
+{
+    const QString kept = touch("kept.ogg", 2);
+    const QString gone = touch("gone.ogg", 60);
+    const QString other = touch("notes.txt", 60);
+
+    ArchiveRetention retention(m_database);
+    ArchiveRetention::Policy policy;
+    policy.directory = m_tempDir->filePath("programs") + "/";
+    policy.nameFilters = QStringList{"*.ogg"};
+    policy.maxAgeDays = 30;
+    policy.table = "programs";
+    retention.setPolicies({policy});
+    QSignalSpy finished(&retention, &ArchiveRetention::finished);
+
+    QVERIFY(retention.start());
+    QVERIFY(retention.isRunning());
+    QVERIFY(!retention.start());
+    QVERIFY(finished.wait(5000));
+    QVERIFY(!retention.isRunning());
+
+    const auto report = finished.at(0).at(0).value<ArchiveRetention::Report>();
+    QCOMPARE(report.folders, 1);
+    QCOMPARE(report.files, 2);
+    QCOMPARE(report.removed, 1);
+    QCOMPARE(report.freedBytes, qint64(10));
+    QCOMPARE(report.rows, 1);
+
+    QVERIFY(QFile::exists(kept));
+    QVERIFY(!QFile::exists(gone));
+    QVERIFY(QFile::exists(other));
+
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("SELECT name FROM programs ORDER BY name"));
+    QStringList rows;
+    while (query.next()) {
+        rows << query.value(0).toString();
+    }
+    QCOMPARE(rows, QStringList({"kept.ogg", "notes.txt"}));
+}
+
+void TestArchiveRetention::testKeepsFilesInUse()
+{
+    const QString fresh = touch("fresh.ogg", 1);
+    const QString queued = touch("queued.ogg", 60);
+    const QString gone = touch("gone.ogg", 70);
+
+    ArchiveRetention retention(m_database);
+    ArchiveRetention::Policy policy;
+    policy.directory = m_tempDir->filePath("programs");
+    policy.maxCount = 1;
+    retention.setPolicies({policy});
+    retention.setInUse([queued]() { return QStringList{queued}; });
+    QSignalSpy finished(&retention, &ArchiveRetention::finished);
+
+    QVERIFY(retention.start());
+    QVERIFY(finished.wait(5000));
+    QVERIFY(QFile::exists(fresh));
+    QVERIFY(QFile::exists(queued));
+    QVERIFY(!QFile::exists(gone));
+
+    // Without a table nothing is deleted from the database
+    const auto report = finished.at(0).at(0).value<ArchiveRetention::Report>();
+    QCOMPARE(report.rows, 0);
+}
+
+void TestArchiveRetention::testNeedsAnEnabledPolicy()
+{
+    ArchiveRetention retention(m_database);
+    QVERIFY(!retention.start());
+
+    ArchiveRetention::Policy policy;
+    policy.directory = m_tempDir->filePath("programs");
+    retention.setPolicies({policy});
+    QVERIFY(!retention.start());
+    QVERIFY(!retention.isRunning());
+}
+
+QTEST_MAIN(TestArchiveRetention)
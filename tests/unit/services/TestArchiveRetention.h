@@ -0,0 +1,40 @@
+#ifndef TESTARCHIVERETENTION_H
+#define TESTARCHIVERETENTION_H
+
+#include <QObject>
+#include <QTest>
+#include <QSqlDatabase>
+#include <QTemporaryDir>
+#include <memory>
+
+/**
+ * @brief Unit tests for ArchiveRetention class
+ *
+ * Tests the retention of archive folders including:
+ * - Picking the files past the age, count and size limits
+ * - Removing them in the background and deleting their table rows
+ * - Keeping the files that are in use
+ * - Not starting without an enabled policy
+ */
+class TestArchiveRetention : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testExpiredByAge();
+    void testExpiredByCountAndQuota();
+    void testRemovesFilesAndRows();
+    void testKeepsFilesInUse();
+    void testNeedsAnEnabledPolicy();
+
+private:
+    QString touch(const QString& name, int daysOld, int bytes = 10);
+
+    std::unique_ptr<QTemporaryDir> m_tempDir;
+    QSqlDatabase m_database;
+};
+
+#endif // TESTARCHIVERETENTION_H
@@ -0,0 +1,142 @@
+#include "TestAudioBroadcastBuffer.h"
+#include "../../../src/services/AudioBroadcastBuffer.h"
+#include <QThread>
+#include <atomic>
+#include <vector>
+
+void TestAudioBroadcastBuffer::testReadersAreIndependent()
+{
+    AudioBroadcastBuffer buffer(16);
+    const int first = buffer.openReader();
+    const int second = buffer.openReader();
+    QVERIFY(first >= 0);
+    QVERIFY(second >= 0);
+    QVERIFY(first != second);
+
+    const float in[6] = {1, 2, 3, 4, 5, 6};
+    buffer.write(in, 6);
+    QCOMPARE(buffer.availableToRead(first), 6);
+    QCOMPARE(buffer.availableToRead(second), 6);
+
+    float out[6] = {};
+    QCOMPARE(buffer.read(first, out, 4), 4);
+    QCOMPARE(out[3], 4.0f);
+    QCOMPARE(buffer.availableToRead(first), 2);
+    QCOMPARE(buffer.availableToRead(second), 6);
+
+    QCOMPARE(buffer.read(second, out, 6), 6);
+    for (int i = 0; i < 6; ++i) {
+        QCOMPARE(out[i], in[i]);
+    }
+    QCOMPARE(buffer.read(first, out, 6), 2);
+    QCOMPARE(out[0], 5.0f);
+    QCOMPARE(buffer.read(first, out, 6), 0);
+}
+
+void TestAudioBroadcastBuffer::testOpenAndClose()
+{
+    AudioBroadcastBuffer buffer(8);
+    const float in[4] = {1, 2, 3, 4};
+    buffer.write(in, 4);
+
+    // A new reader only sees what is written after it opens
+    const int late = buffer.openReader();
+    QCOMPARE(buffer.availableToRead(late), 0);
+    buffer.write(in, 2);
+    QCOMPARE(buffer.availableToRead(late), 2);
+
+    std::vector<int> readers{late};
+    while (readers.size() < size_t(AudioBroadcastBuffer::MAX_READERS)) {
+        readers.push_back(buffer.openReader());
+        QVERIFY(readers.back() >= 0);
+    }
+    QCOMPARE(buffer.readerCount(), AudioBroadcastBuffer::MAX_READERS);
+    QCOMPARE(buffer.openReader(), -1);
+
+    buffer.closeReader(late);
+    float out[4] = {};
+    QCOMPARE(buffer.read(late, out, 4), 0);
+    QCOMPARE(buffer.openReader(), late);
+    QCOMPARE(buffer.availableToRead(late), 0);
+}
+
+void TestAudioBroadcastBuffer::testLappedReaderResyncs()
+{
+    // Stereo, 8 frames
+    AudioBroadcastBuffer buffer(16, 2);
+    const int slow = buffer.openReader();
+    const int fast = buffer.openReader();
+
+    std::vector<float> in(2);
+    std::vector<float> out(16);
+    for (int frame = 0; frame < 20; ++frame) {
+        in[0] = float(frame);
+        in[1] = -float(frame);
+        buffer.write(in.data(), 2);
+        QCOMPARE(buffer.read(fast, out.data(), 2), 2);
+        QCOMPARE(out[0], float(frame));
+    }
+
+    // The writer never waited; the slow reader lost the oldest 16 frames
+    QCOMPARE(buffer.availableToRead(slow), 16);
+    const int got = buffer.read(slow, out.data(), 16);
+    QCOMPARE(got, 8);
+    QCOMPARE(buffer.dropped(slow), qint64(32));
+    QCOMPARE(out[0], 16.0f);
+    QCOMPARE(out[1], -16.0f);
+    QCOMPARE(out[6], 19.0f);
+    QCOMPARE(buffer.dropped(fast), qint64(0));
+
+    // A partial frame is never handed out
+    buffer.write(in.data(), 2);
+    QCOMPARE(buffer.read(fast, out.data(), 3), 2);
+}
+
+void TestAudioBroadcastBuffer::testConcurrentReaders()
+{
+    const int total = 200000;
+    AudioBroadcastBuffer buffer(total);
+    const int first = buffer.openReader();
+    const int second = buffer.openReader();
+
+    QThread* writer = QThread::create([&buffer]() {
+        float chunk[64];
+        for (int next = 0; next < total; next += 64) {
+            const int count = qMin(64, total - next);
+            for (int i = 0; i < count; ++i) {
+                chunk[i] = float(next + i);
+            }
+            buffer.write(chunk, count);
+        }
+    });
+
+    std::atomic<bool> ordered{true};
+    auto drain = [&](int reader, int chunkSize) {
+        std::vector<float> chunk(chunkSize);
+        int expected = 0;
+        while (expected < total) {
+            const int got = buffer.read(reader, chunk.data(), chunkSize);
+            for (int i = 0; i < got; ++i) {
+                if (chunk[i] != float(expected + i)) {
+                    ordered = false;
+                }
+            }
+            expected += got;
+        }
+    };
+    QThread* reader = QThread::create([&]() { drain(second, 37); });
+
+    reader->start();
+    writer->start();
+    drain(first, 50);
+    writer->wait();
+    reader->wait();
+    delete writer;
+    delete reader;
+
+    QVERIFY(ordered);
+    QCOMPARE(buffer.dropped(first), qint64(0));
+    QCOMPARE(buffer.dropped(second), qint64(0));
+}
+
+QTEST_MAIN(TestAudioBroadcastBuffer)
@@ -0,0 +1,27 @@
+#ifndef TESTAUDIOBROADCASTBUFFER_H
+#define TESTAUDIOBROADCASTBUFFER_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for AudioBroadcastBuffer class
+ *
+ * Tests the one-writer, many-reader buffer behind the live capture:
+ * - Every reader sees every sample, at its own pace
+ * - Readers start at the newest sample and slots are reused
+ * - A lapped reader skips ahead by whole frames and counts the loss
+ * - Concurrent writer and readers keep the samples in order
+ */
+class TestAudioBroadcastBuffer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testReadersAreIndependent();
+    void testOpenAndClose();
+    void testLappedReaderResyncs();
+    void testConcurrentReaders();
+};
+
+#endif // TESTAUDIOBROADCASTBUFFER_H
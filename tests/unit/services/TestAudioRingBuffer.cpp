@@ -0,0 +1,113 @@
+#include "TestAudioRingBuffer.h"
+#include "../../../src/services/AudioRingBuffer.h"
+#include <QThread>
+#include <vector>
+
+void TestAudioRingBuffer::testWriteRead()
+{
+    AudioRingBuffer ring(16);
+    QCOMPARE(ring.capacity(), 16);
+    QCOMPARE(ring.availableToRead(), 0);
+    QCOMPARE(ring.availableToWrite(), 16);
+
+    const float in[4] = {0.1f, 0.2f, 0.3f, 0.4f};
+    QCOMPARE(ring.write(in, 4), 4);
+    QCOMPARE(ring.availableToRead(), 4);
+
+    float out[4] = {};
+    QCOMPARE(ring.read(out, 4), 4);
+    for (int i = 0; i < 4; ++i) {
+        QCOMPARE(out[i], in[i]);
+    }
+    QCOMPARE(ring.availableToRead(), 0);
+}
+
+void TestAudioRingBuffer::testWrapAround()
+{
+    AudioRingBuffer ring(8);
+    std::vector<float> in(6);
+    std::vector<float> out(6);
+
+    for (int round = 0; round < 5; ++round) {
+        for (int i = 0; i < 6; ++i) {
+            in[i] = float(round * 10 + i);
+        }
+        QCOMPARE(ring.write(in.data(), 6), 6);
+        QCOMPARE(ring.read(out.data(), 6), 6);
+        QCOMPARE(out, in);
+    }
+}
+
+void TestAudioRingBuffer::testOverflowAndUnderflow()
+{
+    AudioRingBuffer ring(4);
+    const float in[6] = {1, 2, 3, 4, 5, 6};
+
+    QCOMPARE(ring.write(in, 6), 4);
+    QCOMPARE(ring.availableToWrite(), 0);
+    QCOMPARE(ring.write(in, 1), 0);
+
+    float out[6] = {};
+    QCOMPARE(ring.read(out, 6), 4);
+    QCOMPARE(out[3], 4.0f);
+    QCOMPARE(ring.read(out, 1), 0);
+}
+
+void TestAudioRingBuffer::testSkipAndClear()
+{
+    AudioRingBuffer ring(8);
+    const float in[6] = {1, 2, 3, 4, 5, 6};
+    ring.write(in, 6);
+
+    QCOMPARE(ring.skip(2), 2);
+    float out = 0.0f;
+    QCOMPARE(ring.read(&out, 1), 1);
+    QCOMPARE(out, 3.0f);
+
+    ring.clear();
+    QCOMPARE(ring.availableToRead(), 0);
+    QCOMPARE(ring.skip(4), 0);
+}
+
+void TestAudioRingBuffer::testConcurrentProducerConsumer()
+{
+    const int total = 200000;
+    AudioRingBuffer ring(1024);
+
+    QThread* producer = QThread::create([&ring]() {
+        float chunk[64];
+        int next = 0;
+        while (next < total) {
+            int count = qMin(64, total - next);
+            for (int i = 0; i < count; ++i) {
+                chunk[i] = float(next + i);
+            }
+            int written = 0;
+            while (written < count) {
+                written += ring.write(chunk + written, count - written);
+            }
+            next += count;
+        }
+    });
+    producer->start();
+
+    bool ordered = true;
+    int expected = 0;
+    float chunk[50];
+    while (expected < total) {
+        int got = ring.read(chunk, 50);
+        for (int i = 0; i < got; ++i) {
+            if (chunk[i] != float(expected + i)) {
+                ordered = false;
+            }
+        }
+        expected += got;
+    }
+
+    producer->wait();
+    delete producer;
+    QVERIFY(ordered);
+    QCOMPARE(ring.availableToRead(), 0);
+}
+
+QTEST_MAIN(TestAudioRingBuffer)
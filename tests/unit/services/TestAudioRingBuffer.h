@@ -0,0 +1,29 @@
+#ifndef TESTAUDIORINGBUFFER_H
+#define TESTAUDIORINGBUFFER_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for AudioRingBuffer class
+ *
+ * Tests the lock-free sample ring used between decoders and the mixer:
+ * - Basic write/read ordering
+ * - Wrap-around at the end of the storage
+ * - Overflow and underflow limits
+ * - Skipping and clearing
+ * - Concurrent producer/consumer integrity
+ */
+class TestAudioRingBuffer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testWriteRead();
+    void testWrapAround();
+    void testOverflowAndUnderflow();
+    void testSkipAndClear();
+    void testConcurrentProducerConsumer();
+};
+
+#endif // TESTAUDIORINGBUFFER_H
@@ -1,5 +1,6 @@
 #include "TestAudioService.h"
 #include "../../../src/services/AudioService.h"
+#include "../../../src/services/AudioDeviceRegistry.h"
 #include <QStandardPaths>
 #include <QDir>
 #include <QFileInfo>
@@ -322,6 +323,26 @@ void TestAudioService::testInvalidInputDeviceHandling()
     QVERIFY(!m_audioService->setInputDevice(invalidDevice));
 }
 
+void TestAudioService::testDeviceLookup()
+{
+    AudioDeviceRegistry* registry = m_audioService->deviceRegistry();
+    QVERIFY(registry);
+    QCOMPARE(m_audioService->deviceRegistry(), registry);
+
+    // Every listed device is found by its id and by its description
+    for (const auto& device : registry->inputs()) {
+        QCOMPARE(registry->findInput(QString::fromUtf8(device.id())).id(), device.id());
+        QCOMPARE(registry->findInput(device.description()).description(), device.description());
+    }
+    for (const auto& device : registry->outputs()) {
+        QCOMPARE(registry->findOutput(QString::fromUtf8(device.id())).id(), device.id());
+    }
+
+    QVERIFY(registry->findInput("No such device").isNull());
+    QVERIFY(registry->findOutput(QString()).isNull());
+    QVERIFY(!m_audioService->setInputDevice(QString("No such device")));
+}
+
 void TestAudioService::testDeviceChangeHandling()
 {
     QSignalSpy deviceChangedSpy(m_audioService.get(), &AudioService::audioDevicesChanged);
@@ -48,6 +48,7 @@ private slots:
     void testInputDeviceEnumeration();
     void testInputDeviceSelection();
     void testInvalidInputDeviceHandling();
+    void testDeviceLookup();
     void testDeviceChangeHandling();
     
     // Error handling tests
@@ -0,0 +1,192 @@
+#include "TestAutomationClock.h"
+#include "../../../src/services/AutomationClock.h"
+#include <QThread>
+
+namespace {
+
+const QDateTime START(QDate(2024, 5, 13), QTime(0, 0));
+
+} // namespace
+
+void TestAutomationClock::testDeadlineOrder()
+{
+    SimulatedClock clock(START);
+    QCOMPARE(clock.now(), START);
+
+    QStringList fired;
+    QList<qint64> firedAt;
+    ClockTimer late(&clock);
+    ClockTimer first(&clock);
+    ClockTimer second(&clock);
+    const QList<QPair<ClockTimer*, QString>> timers = {
+        {&late, "late"}, {&first, "first"}, {&second, "second"}};
+    for (const auto& [timer, name] : timers) {
+        timer->setSingleShot(true);
+        connect(timer, &ClockTimer::timeout, this, [&, name = name]() {
+            fired << name;
+            firedAt << clock.nowMs();
+        });
+    }
+
+    late.start(300);
+    first.start(100);
+    second.start(100);
+    QCOMPARE(clock.armedTimers(), 3);
+    QCOMPARE(first.remainingTime(), qint64(100));
+
+    // Nothing moves until the clock is advanced
+    QCOMPARE(clock.advance(99), 0);
+    QVERIFY(fired.isEmpty());
+
+    QCOMPARE(clock.advance(1000), 3);
+    QCOMPARE(fired, QStringList({"first", "second", "late"}));
+    const qint64 startMs = START.toMSecsSinceEpoch();
+    QCOMPARE(firedAt, QList<qint64>({startMs + 100, startMs + 100, startMs + 300}));
+    QCOMPARE(clock.nowMs(), startMs + 1099);
+    QVERIFY(!first.isActive());
+    QCOMPARE(clock.armedTimers(), 0);
+}
+
+void TestAutomationClock::testRepeatingTimer()
+{
+    SimulatedClock clock(START);
+    ClockTimer timer(&clock);
+    int fired = 0;
+    connect(&timer, &ClockTimer::timeout, this, [&fired]() { ++fired; });
+
+    timer.setInterval(1000);
+    timer.start();
+    QCOMPARE(clock.advance(3500), 3);
+    QCOMPARE(fired, 3);
+    QVERIFY(timer.isActive());
+    QCOMPARE(timer.remainingTime(), qint64(500));
+
+    // An hour of a 25 s poll, as BroadcastWorker runs it
+    fired = 0;
+    timer.start(25000);
+    clock.advance(60 * 60 * 1000);
+    QCOMPARE(fired, 144);
+}
+
+void TestAutomationClock::testStop()
+{
+    SimulatedClock clock(START);
+    ClockTimer timer(&clock);
+    int fired = 0;
+    connect(&timer, &ClockTimer::timeout, this, [&fired]() { ++fired; });
+
+    timer.start(100);
+    timer.stop();
+    QVERIFY(!timer.isActive());
+    QCOMPARE(timer.remainingTime(), qint64(-1));
+    QCOMPARE(clock.armedTimers(), 0);
+    QCOMPARE(clock.advance(1000), 0);
+
+    // Restarting moves the deadline instead of adding one
+    timer.start(100);
+    timer.start(500);
+    QCOMPARE(clock.armedTimers(), 1);
+    clock.advance(200);
+    QCOMPARE(fired, 0);
+    clock.advance(300);
+    QCOMPARE(fired, 1);
+
+    // A handler that stops its own repeating timer
+    timer.start(10);
+    connect(&timer, &ClockTimer::timeout, &timer, &ClockTimer::stop);
+    clock.advance(100);
+    QCOMPARE(fired, 2);
+}
+
+void TestAutomationClock::testSingleShot()
+{
+    SimulatedClock clock(START);
+    QObject context;
+    int fired = 0;
+    ClockTimer::singleShot(&clock, 120000, &context, [&fired]() { ++fired; });
+    QCOMPARE(clock.armedTimers(), 1);
+    clock.advance(120000);
+    QCOMPARE(fired, 1);
+
+    auto gone = std::make_unique<QObject>();
+    ClockTimer::singleShot(&clock, 1000, gone.get(), [&fired]() { ++fired; });
+    gone.reset();
+    QCOMPARE(clock.armedTimers(), 0);
+    clock.advance(1000);
+    QCOMPARE(fired, 1);
+}
+
+void TestAutomationClock::testStep()
+{
+    SimulatedClock clock(START);
+    QCOMPARE(clock.nextDeadlineMs(), qint64(-1));
+    QVERIFY(!clock.step());
+
+    ClockTimer timer(&clock);
+    timer.setSingleShot(true);
+    timer.start(7 * 24 * 60 * 60 * 1000);
+    const qint64 deadline = START.addDays(7).toMSecsSinceEpoch();
+    QCOMPARE(clock.nextDeadlineMs(), deadline);
+
+    QVERIFY(clock.step());
+    QCOMPARE(clock.nowMs(), deadline);
+    QVERIFY(!timer.isActive());
+    QVERIFY(!clock.step());
+
+    // The clock never runs backwards
+    QCOMPARE(clock.advanceTo(START), 0);
+    QCOMPARE(clock.nowMs(), deadline);
+}
+
+void TestAutomationClock::testTimerOnAnotherThread()
+{
+    SimulatedClock clock(START);
+    QThread thread;
+    thread.start();
+
+    ClockTimer* timer = new ClockTimer(&clock);
+    timer->moveToThread(&thread);
+    QThread* firedOn = nullptr;
+    connect(
+        timer, &ClockTimer::timeout, timer,
+        [&firedOn]() { firedOn = QThread::currentThread(); }, Qt::DirectConnection);
+    QMetaObject::invokeMethod(timer, [timer]() { timer->start(1000); },
+                              Qt::BlockingQueuedConnection);
+
+    // advance() returns once the timer has fired on its thread
+    QCOMPARE(clock.advance(1000), 1);
+    QCOMPARE(firedOn, &thread);
+
+    QMetaObject::invokeMethod(timer, [timer]() { delete timer; }, Qt::BlockingQueuedConnection);
+    thread.quit();
+    QVERIFY(thread.wait(5000));
+}
+
+void TestAutomationClock::testWallClock()
+{
+    AutomationClock* wall = AutomationClock::wallClock();
+    QVERIFY(!wall->isSimulated());
+    QCOMPARE(AutomationClock::wallClock(), wall);
+    QVERIFY(qAbs(wall->nowMs() - QDateTime::currentMSecsSinceEpoch()) < 1000);
+
+    ClockTimer timer;
+    QCOMPARE(timer.clock(), wall);
+    timer.setSingleShot(true);
+    int fired = 0;
+    connect(&timer, &ClockTimer::timeout, this, [&fired]() { ++fired; });
+    timer.start(10);
+    QVERIFY(timer.isActive());
+    QTRY_COMPARE(fired, 1);
+    QVERIFY(!timer.isActive());
+
+    // Moved to a simulated clock, it waits for that clock
+    SimulatedClock clock(START);
+    timer.setClock(&clock);
+    timer.start(10);
+    QTest::qWait(50);
+    QCOMPARE(fired, 1);
+    clock.advance(10);
+    QCOMPARE(fired, 2);
+}
+
+QTEST_MAIN(TestAutomationClock)
@@ -0,0 +1,32 @@
+#ifndef TESTAUTOMATIONCLOCK_H
+#define TESTAUTOMATIONCLOCK_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for AutomationClock, SimulatedClock and ClockTimer classes
+ *
+ * Tests the automation clocks including:
+ * - Simulated timers fired in deadline order, then in the order they were armed
+ * - Repeating timers re-armed an interval after each deadline
+ * - Stopped timers, single shots and their context going away
+ * - Stepping to the next deadline
+ * - Timers of another thread fired on that thread
+ * - Timers on the wall clock
+ */
+class TestAutomationClock : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testDeadlineOrder();
+    void testRepeatingTimer();
+    void testStop();
+    void testSingleShot();
+    void testStep();
+    void testTimerOnAnotherThread();
+    void testWallClock();
+};
+
+#endif // TESTAUTOMATIONCLOCK_H
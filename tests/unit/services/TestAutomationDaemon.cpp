@@ -0,0 +1,114 @@
+#include "TestAutomationDaemon.h"
+#include "../../../src/daemon/AutomationDaemon.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSqlDatabase>
+#include <QStandardPaths>
+#include <vector>
+
+namespace {
+
+/// argv as main() receives it, without a terminating null pointer
+bool requested(QList<QByteArray> arguments)
+{
+    std::vector<char*> argv;
+    for (QByteArray& argument : arguments) {
+        argv.push_back(argument.data());
+    }
+    return AutomationDaemon::isRequested(int(argv.size()), argv.data());
+}
+
+QJsonObject statusOf(const AutomationDaemon& daemon)
+{
+    QJsonParseError error;
+    const QJsonDocument document = QJsonDocument::fromJson(daemon.statusJson(), &error);
+    return error.error == QJsonParseError::NoError ? document.object() : QJsonObject();
+}
+
+} // namespace
+
+void TestAutomationDaemon::initTestCase()
+{
+    // Keep the library and the logs out of the real application data
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+void TestAutomationDaemon::init()
+{
+    m_tempDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_tempDir->isValid());
+    // A library left behind by another run would let start() go on to the playout
+    QFile::remove(AutomationDaemon::defaultDatabaseFile());
+}
+
+void TestAutomationDaemon::cleanup()
+{
+    m_tempDir.reset();
+}
+
+void TestAutomationDaemon::testIsRequested()
+{
+    QVERIFY(!requested({"xfb"}));
+    QVERIFY(requested({"xfb", "--daemon"}));
+    QVERIFY(requested({"xfb", "--config", "/etc/xfb.conf", "--daemon"}));
+
+    // Only the exact option, and never the program name
+    QVERIFY(!requested({"xfb", "--daemons"}));
+    QVERIFY(!requested({"xfb", "-daemon"}));
+    QVERIFY(!requested({"xfb", "--config", "--daemon=1"}));
+    QVERIFY(!requested({"--daemon"}));
+    QVERIFY(!AutomationDaemon::isRequested(0, nullptr));
+}
+
+void TestAutomationDaemon::testStartWithoutConfig()
+{
+    AutomationDaemon daemon;
+    QVERIFY(!daemon.start(m_tempDir->filePath("missing/xfb.conf")));
+
+    // Nothing was opened or put on air
+    QVERIFY(!QSqlDatabase::contains("xfb_connection"));
+    QVERIFY(!statusOf(daemon).contains("state"));
+    daemon.stop();
+}
+
+void TestAutomationDaemon::testStartWithoutDatabase()
+{
+    const QString configPath = m_tempDir->filePath("xfb.conf");
+    QFile config(configPath);
+    QVERIFY(config.open(QIODevice::WriteOnly));
+    QVERIFY(config.write("[General]\nRole=Server\nMetricsPort=0\n") > 0);
+    config.close();
+    QVERIFY(!QFileInfo::exists(AutomationDaemon::defaultDatabaseFile()));
+
+    {
+        AutomationDaemon daemon;
+        QVERIFY(!daemon.start(configPath));
+        QVERIFY(!statusOf(daemon).contains("state"));
+    }
+
+    // The window sets the library up; the daemon never creates an empty one
+    QVERIFY(!QFileInfo::exists(AutomationDaemon::defaultDatabaseFile()));
+    QVERIFY(!QSqlDatabase::contains("xfb_connection"));
+}
+
+void TestAutomationDaemon::testStatusJson()
+{
+    AutomationDaemon daemon;
+    const QJsonObject status = statusOf(daemon);
+    QVERIFY(!status.isEmpty());
+
+    // Before the playout there is no engine and no scheduler to describe
+    QCOMPARE(status.keys(), QStringList({"role", "scheduled", "startedAt"}));
+    QVERIFY(status.value("role").isString());
+    QVERIFY(status.value("startedAt").isString());
+    QVERIFY(status.value("scheduled").isArray());
+    QVERIFY(status.value("scheduled").toArray().isEmpty());
+
+    // Compact, as served at /status.json
+    QVERIFY(!daemon.statusJson().contains('\n'));
+}
+
+QTEST_GUILESS_MAIN(TestAutomationDaemon)
@@ -0,0 +1,35 @@
+#ifndef TESTAUTOMATIONDAEMON_H
+#define TESTAUTOMATIONDAEMON_H
+
+#include <QObject>
+#include <QTest>
+#include <QTemporaryDir>
+#include <memory>
+
+/**
+ * @brief Unit tests for AutomationDaemon class
+ *
+ * Tests the parts of the headless automation that need no audio including:
+ * - Finding --daemon on a command line
+ * - Refusing to start without xfb.conf or without adb.db
+ * - The shape of the /status.json document
+ */
+class TestAutomationDaemon : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testIsRequested();
+    void testStartWithoutConfig();
+    void testStartWithoutDatabase();
+    void testStatusJson();
+
+private:
+    std::unique_ptr<QTemporaryDir> m_tempDir;
+};
+
+#endif // TESTAUTOMATIONDAEMON_H
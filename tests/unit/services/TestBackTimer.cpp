@@ -0,0 +1,190 @@
+#include "TestBackTimer.h"
+#include "../../../src/models/PlaylistQueueModel.h"
+#include "../../../src/services/BackTimer.h"
+
+namespace {
+
+const QDateTime NOW(QDate(2024, 3, 4), QTime(11, 50));
+
+// Durations in seconds are taken from the file name, "unknown" has none
+PlaylistQueueModel::Resolver resolver()
+{
+    return [](PlaylistQueueModel::Entry& entry) {
+        bool ok = false;
+        const qint64 seconds = entry.path.section('/', -1).section('.', 0, 0).toLongLong(&ok);
+        entry.durationUs = ok ? seconds * 1000000 : -1;
+    };
+}
+
+QStringList tracks(const QList<int>& seconds)
+{
+    QStringList paths;
+    for (int length : seconds) {
+        paths << QString("/m/%1.ogg").arg(length);
+    }
+    return paths;
+}
+
+} // namespace
+
+void TestBackTimer::testOnTimeAndCut()
+{
+    PlaylistQueueModel queue;
+    queue.setResolver(resolver());
+    queue.append(tracks({60, 60, 60}));
+    BackTimer backTimer(&queue);
+
+    // 30 s of the current track, then two entries end on the dot
+    BackTimer::Plan plan = backTimer.plan(NOW, 30000, NOW.addSecs(150));
+    QVERIFY(plan.valid);
+    QCOMPARE(plan.ending, BackTimer::Ending::OnTime);
+    QCOMPARE(plan.fitCount, 2);
+    QCOMPARE(plan.startsAt(), NOW.addSecs(150));
+
+    // The third one has played 50 s when it is cut
+    plan = backTimer.plan(NOW, 30000, NOW.addSecs(200));
+    QCOMPARE(plan.ending, BackTimer::Ending::Cut);
+    QCOMPARE(plan.fitCount, 2);
+    QCOMPARE(plan.cutRow, 2);
+    QCOMPARE(plan.cutAfterMs, qint64(50000));
+    QCOMPARE(plan.fillRow, -1);
+}
+
+void TestBackTimer::testCutsCurrentTrack()
+{
+    PlaylistQueueModel queue;
+    queue.setResolver(resolver());
+    queue.append(tracks({60}));
+    BackTimer backTimer(&queue);
+
+    const BackTimer::Plan plan = backTimer.plan(NOW, 300000, NOW.addSecs(100));
+    QCOMPARE(plan.ending, BackTimer::Ending::Cut);
+    QCOMPARE(plan.cutRow, -1);
+    QCOMPARE(plan.cutAfterMs, qint64(100000));
+    QCOMPARE(plan.fitCount, 0);
+    // Nothing of the queue had to be read
+    QCOMPARE(backTimer.entriesRead(), 0);
+}
+
+void TestBackTimer::testEarlyAndFill()
+{
+    PlaylistQueueModel queue;
+    queue.setResolver(resolver());
+    queue.append(tracks({60, 60, 200, 5, 12}));
+    BackTimer backTimer(&queue);
+
+    // 10 s are left after two entries: not worth starting the long one for
+    BackTimer::Plan plan = backTimer.plan(NOW, 0, NOW.addSecs(130));
+    QCOMPARE(plan.ending, BackTimer::Ending::Early);
+    QCOMPARE(plan.fitCount, 2);
+    QCOMPARE(plan.earlyMs, qint64(10000));
+    QCOMPARE(plan.startsAt(), NOW.addSecs(120));
+    // The 5 s entry fits in them, the 12 s one does not
+    QCOMPARE(plan.fillRow, 3);
+
+    QVERIFY(queue.move(3, 2));
+    plan = backTimer.plan(NOW, 0, NOW.addSecs(130));
+    QCOMPARE(plan.fitCount, 3);
+    QCOMPARE(plan.earlyMs, qint64(5000));
+    QCOMPARE(plan.fillRow, -1);
+
+    // With 20 s left the cut is long enough, and the 12 s entry would fill most of it
+    plan = backTimer.plan(NOW, 0, NOW.addSecs(145));
+    QCOMPARE(plan.ending, BackTimer::Ending::Cut);
+    QCOMPARE(plan.fitCount, 3);
+    QCOMPARE(plan.cutRow, 3);
+    QCOMPARE(plan.cutAfterMs, qint64(20000));
+    QCOMPARE(plan.fillRow, 4);
+}
+
+void TestBackTimer::testShortAndUnknown()
+{
+    PlaylistQueueModel queue;
+    queue.setResolver(resolver());
+    queue.append(tracks({60}));
+    BackTimer backTimer(&queue);
+
+    BackTimer::Plan plan = backTimer.plan(NOW, 0, NOW.addSecs(100));
+    QCOMPARE(plan.ending, BackTimer::Ending::Short);
+    QCOMPARE(plan.fitCount, 1);
+    QCOMPARE(plan.gapMs, qint64(40000));
+
+    queue.append(QStringList({"/m/unknown.ogg", "/m/60.ogg"}));
+    plan = backTimer.plan(NOW, 0, NOW.addSecs(100));
+    QCOMPARE(plan.ending, BackTimer::Ending::Unknown);
+    QCOMPARE(plan.fitCount, 1);
+    QCOMPARE(backTimer.startOffsetMs(1), qint64(60000));
+    QCOMPARE(backTimer.startOffsetMs(2), qint64(-1));
+
+    // Before the unknown entry the plan is still made
+    plan = backTimer.plan(NOW, 0, NOW.addSecs(40));
+    QCOMPARE(plan.ending, BackTimer::Ending::Cut);
+    QCOMPARE(plan.cutRow, 0);
+
+    // An unknown current track says nothing of when the queue starts
+    QCOMPARE(backTimer.plan(NOW, -1, NOW.addSecs(40)).ending, BackTimer::Ending::Unknown);
+}
+
+void TestBackTimer::testOverlap()
+{
+    PlaylistQueueModel queue;
+    queue.setResolver(resolver());
+    queue.append(tracks({60, 60}));
+    BackTimer backTimer(&queue);
+    backTimer.setOverlapMs(5000);
+
+    // The head comes in at 25 s, the second entry 55 s later
+    QCOMPARE(backTimer.startOffsetMs(1), qint64(55000));
+    const BackTimer::Plan plan = backTimer.plan(NOW, 30000, NOW.addSecs(80));
+    QCOMPARE(plan.ending, BackTimer::Ending::OnTime);
+    QCOMPARE(plan.fitCount, 1);
+}
+
+void TestBackTimer::testFollowsQueueIncrementally()
+{
+    PlaylistQueueModel queue;
+    queue.setResolver(resolver());
+    QList<int> hour;
+    for (int i = 0; i < 100; ++i) {
+        hour << 60;
+    }
+    queue.append(tracks(hour));
+    BackTimer backTimer(&queue);
+
+    // Only the entries up to the event are read
+    BackTimer::Plan plan = backTimer.plan(NOW, 0, NOW.addSecs(330));
+    QCOMPARE(plan.fitCount, 5);
+    const int read = backTimer.entriesRead();
+    QVERIFY(read <= 7);
+
+    // Airing the head, or queueing more at the end, reads nothing again
+    queue.takeFirst();
+    queue.append(tracks({60, 60, 60}));
+    plan = backTimer.plan(NOW.addSecs(60), 0, NOW.addSecs(330));
+    QCOMPARE(plan.fitCount, 4);
+    QCOMPARE(plan.cutRow, 4);
+    QCOMPARE(plan.cutAfterMs, qint64(30000));
+    QCOMPARE(backTimer.entriesRead(), read);
+
+    // An insert is read from its row on
+    queue.insert(2, "/m/30.ogg");
+    plan = backTimer.plan(NOW.addSecs(60), 0, NOW.addSecs(330));
+    QCOMPARE(plan.fitCount, 5);
+    QCOMPARE(plan.ending, BackTimer::Ending::OnTime);
+    QVERIFY(backTimer.entriesRead() - read <= 4);
+    QCOMPARE(backTimer.startOffsetMs(3), qint64(150000));
+
+    queue.clear();
+    QCOMPARE(backTimer.plan(NOW, 0, NOW.addSecs(60)).ending, BackTimer::Ending::Short);
+}
+
+void TestBackTimer::testPastEventIsInvalid()
+{
+    PlaylistQueueModel queue;
+    BackTimer backTimer(&queue);
+    QVERIFY(!backTimer.plan(NOW, 0, NOW.addSecs(-1)).valid);
+    QVERIFY(!backTimer.plan(NOW, 0, QDateTime()).valid);
+    QVERIFY(backTimer.plan(NOW, 0, NOW).valid);
+}
+
+QTEST_MAIN(TestBackTimer)
@@ -0,0 +1,33 @@
+#ifndef TESTBACKTIMER_H
+#define TESTBACKTIMER_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for BackTimer class
+ *
+ * Tests back-timing the queue to a hard-timed event including:
+ * - Entries that end right on the event, and the entry cut under it
+ * - Cutting the current track when the event comes first
+ * - Starting the event early rather than cutting a track short, and
+ *   pointing at an entry that fills the time left
+ * - Queues that end before the event or hold an unknown duration
+ * - The overlap of the crossfade
+ * - Reading only the entries a change touched
+ */
+class TestBackTimer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testOnTimeAndCut();
+    void testCutsCurrentTrack();
+    void testEarlyAndFill();
+    void testShortAndUnknown();
+    void testOverlap();
+    void testFollowsQueueIncrementally();
+    void testPastEventIsInvalid();
+};
+
+#endif // TESTBACKTIMER_H
@@ -0,0 +1,124 @@
+#include "TestBackgroundThrottle.h"
+#include "../../../src/services/BackgroundThrottle.h"
+#include <QElapsedTimer>
+#include <QSignalSpy>
+#include <atomic>
+
+using Level = BackgroundThrottle::Level;
+
+void TestBackgroundThrottle::testEvaluate()
+{
+    // Nothing on air and nothing scheduled
+    QCOMPARE(BackgroundThrottle::evaluate(-1, -1), Level::Full);
+    QCOMPARE(BackgroundThrottle::evaluate(100, -1), Level::Full);
+    QCOMPARE(BackgroundThrottle::evaluate(BackgroundThrottle::REDUCED_FILL_PERCENT, -1),
+             Level::Full);
+    QCOMPARE(BackgroundThrottle::evaluate(BackgroundThrottle::REDUCED_FILL_PERCENT - 1, -1),
+             Level::Reduced);
+    QCOMPARE(BackgroundThrottle::evaluate(BackgroundThrottle::PAUSED_FILL_PERCENT, -1),
+             Level::Reduced);
+    QCOMPARE(BackgroundThrottle::evaluate(BackgroundThrottle::PAUSED_FILL_PERCENT - 1, -1),
+             Level::Paused);
+
+    // A scheduled event close by pauses even with nothing on air
+    QCOMPARE(BackgroundThrottle::evaluate(-1, BackgroundThrottle::EVENT_GUARD_MS), Level::Paused);
+    QCOMPARE(BackgroundThrottle::evaluate(100, 0), Level::Paused);
+    QCOMPARE(BackgroundThrottle::evaluate(100, BackgroundThrottle::EVENT_GUARD_MS + 1),
+             Level::Full);
+}
+
+void TestBackgroundThrottle::testHold()
+{
+    int fill = 100;
+    BackgroundThrottle throttle;
+    throttle.setFillProvider([&fill]() { return fill; });
+    QSignalSpy changed(&throttle, &BackgroundThrottle::levelChanged);
+
+    throttle.setHoldMs(0);
+    throttle.update();
+    QCOMPARE(throttle.currentLevel(), Level::Full);
+    QCOMPARE(changed.count(), 0);
+
+    fill = 40;
+    throttle.update();
+    QCOMPARE(throttle.currentLevel(), Level::Paused);
+    QCOMPARE(BackgroundThrottle::level(), Level::Paused);
+    fill = 90;
+    throttle.update();
+    QCOMPARE(throttle.currentLevel(), Level::Full);
+    QCOMPARE(changed.count(), 2);
+
+    // Backing off is at once, going back up waits for the hold
+    throttle.setHoldMs(60 * 1000);
+    fill = 60;
+    throttle.update();
+    QCOMPARE(throttle.currentLevel(), Level::Reduced);
+    fill = 90;
+    throttle.update();
+    QCOMPARE(throttle.currentLevel(), Level::Reduced);
+    fill = 10;
+    throttle.update();
+    QCOMPARE(throttle.currentLevel(), Level::Paused);
+    QCOMPARE(changed.count(), 4);
+
+    // The next event counts as much as the buffer
+    throttle.setHoldMs(0);
+    fill = 100;
+    throttle.setEventProvider([]() { return QDateTime::currentDateTime().addSecs(30); });
+    throttle.update();
+    QCOMPARE(throttle.currentLevel(), Level::Paused);
+    throttle.setEventProvider([]() { return QDateTime(); });
+    throttle.update();
+    QCOMPARE(throttle.currentLevel(), Level::Full);
+}
+
+void TestBackgroundThrottle::testWorkerLimitAndPace()
+{
+    int fill = 100;
+    BackgroundThrottle throttle;
+    throttle.setHoldMs(0);
+    throttle.setFillProvider([&fill]() { return fill; });
+
+    throttle.update();
+    QCOMPARE(BackgroundThrottle::workerLimit(4), 4);
+    QElapsedTimer elapsed;
+    elapsed.start();
+    BackgroundThrottle::pace();
+    QVERIFY(elapsed.elapsed() < BackgroundThrottle::REDUCED_DELAY_MS);
+
+    fill = 60;
+    throttle.update();
+    QCOMPARE(BackgroundThrottle::workerLimit(4), 2);
+    QCOMPARE(BackgroundThrottle::workerLimit(1), 1);
+    elapsed.start();
+    BackgroundThrottle::pace();
+    QVERIFY(elapsed.elapsed() >= BackgroundThrottle::REDUCED_DELAY_MS - 5);
+
+    // Paused keeps one worker, and a cancelled task does not wait
+    fill = 10;
+    throttle.update();
+    QCOMPARE(BackgroundThrottle::workerLimit(4), 1);
+    QCOMPARE(BackgroundThrottle::workerLimit(0), 0);
+    const std::atomic_bool cancelled{true};
+    elapsed.start();
+    BackgroundThrottle::pace(&cancelled);
+    QVERIFY(elapsed.elapsed() < BackgroundThrottle::PAUSE_POLL_MS);
+}
+
+void TestBackgroundThrottle::testStopResetsLevel()
+{
+    BackgroundThrottle throttle;
+    throttle.setFillProvider([]() { return 10; });
+    throttle.start();
+    QVERIFY(throttle.isRunning());
+    QCOMPARE(BackgroundThrottle::level(), Level::Paused);
+
+    QSignalSpy changed(&throttle, &BackgroundThrottle::levelChanged);
+    throttle.stop();
+    QVERIFY(!throttle.isRunning());
+    QCOMPARE(throttle.currentLevel(), Level::Full);
+    QCOMPARE(BackgroundThrottle::level(), Level::Full);
+    QCOMPARE(changed.count(), 1);
+}
+
+QTEST_MAIN(TestBackgroundThrottle)
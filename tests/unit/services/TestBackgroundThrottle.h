@@ -0,0 +1,27 @@
+#ifndef TESTBACKGROUNDTHROTTLE_H
+#define TESTBACKGROUNDTHROTTLE_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for BackgroundThrottle class
+ *
+ * Tests the background work throttle including:
+ * - Levels for the on-air buffer fill and the time to the next event
+ * - Backing off at once and going back up only after the hold
+ * - Worker limits and pacing at each level
+ * - Background work back at Full once the throttle stops
+ */
+class TestBackgroundThrottle : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testEvaluate();
+    void testHold();
+    void testWorkerLimitAndPace();
+    void testStopResetsLevel();
+};
+
+#endif // TESTBACKGROUNDTHROTTLE_H
@@ -192,4 +192,77 @@ void TestBaseService::testInitializationTimeout()
     delete slowService;
 }
 
+void TestBaseService::testLifecycleTiming()
+{
+    QCOMPARE(m_service->initializeDurationMs(), -1);
+    m_service->setInitializeDelay(20);
+    QVERIFY(m_service->initialize());
+    QVERIFY(m_service->initializeDurationMs() >= 20);
+
+    MetricsRegistry& metrics = MetricsRegistry::instance();
+    MetricsRegistry::Gauge* initialize =
+        metrics.gauge("xfb_service_testable_service_initialize_milliseconds", QString());
+    QVERIFY(initialize);
+    QCOMPARE(initialize->value(), double(m_service->initializeDurationMs()));
+
+    m_service->shutdown();
+    QVERIFY(m_service->shutdownDurationMs() >= 0);
+    QVERIFY(metrics.toJson().contains("xfb_service_testable_service_shutdown_milliseconds"));
+}
+
+void TestBaseService::testHealthCheck()
+{
+    // Only a running service is checked
+    QVERIFY(!m_service->checkHealth());
+    QCOMPARE(m_service->healthCheckCount(), 0);
+    QCOMPARE(m_service->lastHealthCheckUs(), -1);
+
+    QVERIFY(m_service->initialize());
+    MetricsRegistry::Histogram* latency = MetricsRegistry::instance().histogram(
+        "xfb_service_testable_service_health_check_microseconds", QString());
+    const qint64 recorded = latency->count();
+    QSignalSpy healthSpy(m_service, &BaseService::healthChanged);
+
+    QVERIFY(m_service->checkHealth());
+    QVERIFY(m_service->isHealthy());
+    QVERIFY(m_service->lastHealthCheckUs() >= 0);
+    QCOMPARE(healthSpy.count(), 0);
+
+    m_service->setHealthy(false);
+    QVERIFY(!m_service->checkHealth());
+    QVERIFY(!m_service->isHealthy());
+    QCOMPARE(healthSpy.count(), 1);
+    QCOMPARE(healthSpy.at(0).at(0).toBool(), false);
+    QCOMPARE(latency->count(), recorded + 2);
+    QCOMPARE(MetricsRegistry::instance()
+                 .gauge("xfb_service_testable_service_healthy", QString())
+                 ->value(),
+             0.0);
+}
+
+void TestBaseService::testSharedHealthTimer()
+{
+    TestableService other(this);
+    QVERIFY(m_service->initialize());
+    QVERIFY(other.initialize());
+
+    BaseService::startHealthChecks(10);
+    QTRY_VERIFY(m_service->healthCheckCount() > 0 && other.healthCheckCount() > 0);
+
+    // A stopped service is no longer checked
+    m_service->shutdown();
+    const int checks = m_service->healthCheckCount();
+    QTRY_VERIFY(other.healthCheckCount() > 2);
+    QCOMPARE(m_service->healthCheckCount(), checks);
+    BaseService::stopHealthChecks();
+}
+
+void TestBaseService::testMetricName()
+{
+    QCOMPARE(BaseService::metricName("AudioService"), QString("audio_service"));
+    QCOMPARE(BaseService::metricName("AccessibilityManager"), QString("accessibility_manager"));
+    QCOMPARE(BaseService::metricName("ATSPIManager"), QString("atspi_manager"));
+    QCOMPARE(BaseService::metricName("Mp3 Decoder"), QString("mp3_decoder"));
+}
+
 QTEST_MAIN(TestBaseService)
\ No newline at end of file
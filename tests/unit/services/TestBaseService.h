@@ -21,6 +21,8 @@ public:
     void setInitializeDelay(int delayMs) { m_initializeDelay = delayMs; }
     bool wasInitializeCalled() const { return m_initializeCalled; }
     bool wasShutdownCalled() const { return m_shutdownCalled; }
+    void setHealthy(bool healthy) { m_healthy = healthy; }
+    int healthCheckCount() const { return m_healthChecks; }
 
 protected:
     bool doInitialize() override {
@@ -39,11 +41,18 @@ protected:
         return "TestableService";
     }
 
+    bool healthCheck() override {
+        ++m_healthChecks;
+        return m_healthy;
+    }
+
 private:
     bool m_initializeResult;
     int m_initializeDelay;
     bool m_initializeCalled = false;
     bool m_shutdownCalled = false;
+    bool m_healthy = true;
+    int m_healthChecks = 0;
 };
 
 /**
@@ -91,6 +100,10 @@ private slots:
     void testErrorHandling();
     void testSignalEmission();
     void testInitializationTimeout();
+    void testLifecycleTiming();
+    void testHealthCheck();
+    void testSharedHealthTimer();
+    void testMetricName();
 
 private:
     TestableService* m_service;
@@ -0,0 +1,84 @@
+#include "TestBrailleFrameBuffer.h"
+#include "../../../src/services/BrailleFrameBuffer.h"
+
+void TestBrailleFrameBuffer::testFirstUpdateSendsWholeLine()
+{
+    BrailleFrameBuffer frame(20);
+    const QVector<BrailleFrameBuffer::Span> spans = frame.update("Playing 00:41");
+    QCOMPARE(spans.size(), 1);
+    QCOMPARE(spans[0].start, 0);
+    QCOMPARE(spans[0].cells, QString("Playing 00:41").leftJustified(20, ' '));
+}
+
+void TestBrailleFrameBuffer::testUnchangedLineSendsNothing()
+{
+    BrailleFrameBuffer frame(20);
+    frame.update("Playing 00:41");
+    QVERIFY(frame.update("Playing 00:41").isEmpty());
+}
+
+void TestBrailleFrameBuffer::testChangedDigitSendsOneSpan()
+{
+    BrailleFrameBuffer frame(20);
+    frame.update("Playing 00:41");
+    const QVector<BrailleFrameBuffer::Span> spans = frame.update("Playing 00:42");
+    QCOMPARE(spans.size(), 1);
+    QCOMPARE(spans[0].start, 12);
+    QCOMPARE(spans[0].cells, QString("2"));
+    QCOMPARE(frame.cells(), QString("Playing 00:42").leftJustified(20, ' '));
+}
+
+void TestBrailleFrameBuffer::testNearRunsMergeFarRunsSplit()
+{
+    BrailleFrameBuffer frame(20);
+    frame.update("aaaaaaaaaaaaaaaaaaaa");
+
+    // Two changes MERGE_GAP cells apart go as one span
+    QVector<BrailleFrameBuffer::Span> spans = frame.update("baaaabaaaaaaaaaaaaaa");
+    QCOMPARE(spans.size(), 1);
+    QCOMPARE(spans[0].start, 0);
+    QCOMPARE(spans[0].cells, QString("baaaab"));
+
+    // Further apart they stay two
+    spans = frame.update("caaaabaaaaaaaaaaaaac");
+    QCOMPARE(spans.size(), 2);
+    QCOMPARE(spans[0].start, 0);
+    QCOMPARE(spans[0].cells, QString("c"));
+    QCOMPARE(spans[1].start, 19);
+    QCOMPARE(spans[1].cells, QString("c"));
+}
+
+void TestBrailleFrameBuffer::testLinesFitCellCount()
+{
+    BrailleFrameBuffer frame(8);
+    QVector<BrailleFrameBuffer::Span> spans = frame.update("Now playing a long title");
+    QCOMPARE(spans.size(), 1);
+    QCOMPARE(spans[0].cells, QString("Now play"));
+    QCOMPARE(frame.cells().size(), 8);
+
+    // A shorter line blanks what the longer one left behind
+    spans = frame.update("Now");
+    QCOMPARE(spans.size(), 1);
+    QCOMPARE(spans[0].start, 3);
+    QCOMPARE(spans[0].cells, QString("     "));
+}
+
+void TestBrailleFrameBuffer::testResetAndInvalidateRedraw()
+{
+    BrailleFrameBuffer frame(10);
+    frame.update("Stopped");
+
+    frame.invalidate();
+    QVector<BrailleFrameBuffer::Span> spans = frame.update("Stopped");
+    QCOMPARE(spans.size(), 1);
+    QCOMPARE(spans[0].cells.size(), 10);
+
+    frame.reset(12);
+    QCOMPARE(frame.cellCount(), 12);
+    spans = frame.update("Stopped");
+    QCOMPARE(spans.size(), 1);
+    QCOMPARE(spans[0].start, 0);
+    QCOMPARE(spans[0].cells, QString("Stopped").leftJustified(12, ' '));
+}
+
+QTEST_MAIN(TestBrailleFrameBuffer)
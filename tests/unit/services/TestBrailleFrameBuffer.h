@@ -0,0 +1,30 @@
+#ifndef TESTBRAILLEFRAMEBUFFER_H
+#define TESTBRAILLEFRAMEBUFFER_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for BrailleFrameBuffer class
+ *
+ * Tests the braille output diffing including:
+ * - The whole line on the first update, nothing for an unchanged one
+ * - One span for a changed digit
+ * - Nearby runs merged, distant runs kept apart
+ * - Lines cut or padded to the cell count
+ * - A full redraw after reset() and invalidate()
+ */
+class TestBrailleFrameBuffer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testFirstUpdateSendsWholeLine();
+    void testUnchangedLineSendsNothing();
+    void testChangedDigitSendsOneSpan();
+    void testNearRunsMergeFarRunsSplit();
+    void testLinesFitCellCount();
+    void testResetAndInvalidateRedraw();
+};
+
+#endif // TESTBRAILLEFRAMEBUFFER_H
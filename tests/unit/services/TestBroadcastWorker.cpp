@@ -0,0 +1,154 @@
+#include "TestBroadcastWorker.h"
+#include "../../../src/services/BroadcastWorker.h"
+#include <QDir>
+#include <QFile>
+#include <QSignalSpy>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+
+namespace {
+
+const char* CONNECTION = "test_broadcast_worker";
+
+/**
+ * @brief Create the tables the worker writes to, with a program that airs at 09:30
+ */
+void createDatabase(const QString& path)
+{
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", CONNECTION);
+        db.setDatabaseName(path);
+        QVERIFY(db.open());
+        QSqlQuery query(db);
+        QVERIFY(query.exec("create table programs (id INTEGER PRIMARY KEY, name TEXT, path TEXT)"));
+        QVERIFY(query.exec("create table hourprograms (name TEXT, hour TEXT, min TEXT)"));
+        QVERIFY(query.exec("create table scheduler (id, year, month, day, hour, min, enabled, "
+                           "c8, c9, c10, c11, c12, c13, c14, c15)"));
+        QVERIFY(query.exec("insert into hourprograms values ('Show', '09', '30')"));
+    }
+    QSqlDatabase::removeDatabase(CONNECTION);
+}
+
+QStringList scheduledRows(const QString& path)
+{
+    QStringList rows;
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", CONNECTION);
+        db.setDatabaseName(path);
+        if (db.open()) {
+            QSqlQuery query("select p.path, s.year, s.month, s.day, s.hour, s.min from scheduler "
+                            "s join programs p on p.id = s.id",
+                            db);
+            while (query.next()) {
+                QStringList fields;
+                for (int i = 0; i < 6; ++i) {
+                    fields << query.value(i).toString();
+                }
+                rows << fields.join(" ");
+            }
+        }
+    }
+    QSqlDatabase::removeDatabase(CONNECTION);
+    return rows;
+}
+
+void writeFile(const QString& path, const QByteArray& content)
+{
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(content);
+}
+
+} // namespace
+
+void TestBroadcastWorker::initTestCase()
+{
+    // Keep the program index out of the real application data
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+void TestBroadcastWorker::testUploadIsSortedAndScheduled()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString database = dir.filePath("adb.db");
+    const QString programs = dir.filePath("programs");
+    createDatabase(database);
+    QVERIFY(QDir().mkpath(programs + "/Show"));
+    writeFile(programs + "/Show_2026-10-14.ogg", "x");
+    writeFile(programs + "/Show_2026-10-15.ogg.part", "x");
+
+    BroadcastWorker worker;
+    QSignalSpy changedSpy(&worker, &BroadcastWorker::programsChanged);
+    worker.start(database, programs, dir.filePath("takeover"));
+    worker.scanPrograms();
+    QVERIFY(changedSpy.wait());
+    QCOMPARE(changedSpy.first().at(0).toInt(), 1);
+
+    // Partial downloads stay where they are
+    QVERIFY(QFile::exists(programs + "/Show/Show_2026-10-14.ogg"));
+    QVERIFY(QFile::exists(programs + "/Show_2026-10-15.ogg.part"));
+    QCOMPARE(scheduledRows(database),
+             QStringList({programs + "/Show/Show_2026-10-14.ogg 2026 10 14 09 30"}));
+}
+
+void TestBroadcastWorker::testDownloadedProgramIsScheduled()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString database = dir.filePath("adb.db");
+    createDatabase(database);
+
+    BroadcastWorker worker;
+    QSignalSpy changedSpy(&worker, &BroadcastWorker::programsChanged);
+    worker.start(database, dir.path(), dir.filePath("takeover"));
+    worker.addDownloadedProgram("Show_2026-11-02.mp3");
+    QVERIFY(changedSpy.wait());
+    QCOMPARE(scheduledRows(database),
+             QStringList({dir.filePath("Show_2026-11-02.mp3") + " 2026 11 02 09 30"}));
+}
+
+void TestBroadcastWorker::testTakeOverRequest()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    writeFile(dir.filePath("takeover.xml"),
+              "<?xml version=\"1.0\"?>\n<XFBClientTakeOver><www.netpack.pt>"
+              "<stream>http://203.0.113.7:8000/live</stream><ip>203.0.113.7</ip>"
+              "</www.netpack.pt></XFBClientTakeOver>\n");
+
+    BroadcastWorker worker;
+    QSignalSpy requestedSpy(&worker, &BroadcastWorker::takeOverRequested);
+    worker.start(dir.filePath("adb.db"), dir.path(), dir.path());
+    worker.checkTakeOver();
+    QVERIFY(requestedSpy.wait());
+
+    // The stream comes before the address in the file
+    QCOMPARE(requestedSpy.first().at(0).toString(), QString("203.0.113.7"));
+    QCOMPARE(requestedSpy.first().at(1).toString(), QString("http://203.0.113.7:8000/live"));
+    QVERIFY(!QFile::exists(dir.filePath("takeover.xml")));
+    QVERIFY(QFile::exists(dir.filePath("confirmtakeover.xml")));
+}
+
+void TestBroadcastWorker::testReturnTakeOver()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    writeFile(dir.filePath("returntakeover.xml"),
+              "<?xml version=\"1.0\"?>\n<XFBClientTakeOver><www.netpack.pt>"
+              "<ip>203.0.113.7</ip><cmd>returnTakeOver</cmd>"
+              "</www.netpack.pt></XFBClientTakeOver>\n");
+
+    BroadcastWorker worker;
+    QSignalSpy returnedSpy(&worker, &BroadcastWorker::takeOverReturned);
+    worker.start(dir.filePath("adb.db"), dir.path(), dir.path());
+    worker.checkTakeOver();
+    QVERIFY(returnedSpy.wait());
+    QCOMPARE(returnedSpy.first().at(0).toString(), QString("203.0.113.7"));
+    QCOMPARE(returnedSpy.first().at(1).toString(), QString("returnTakeOver"));
+    QVERIFY(!QFile::exists(dir.filePath("returntakeover.xml")));
+}
+
+QTEST_MAIN(TestBroadcastWorker)
@@ -0,0 +1,28 @@
+#ifndef TESTBROADCASTWORKER_H
+#define TESTBROADCASTWORKER_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for BroadcastWorker class
+ *
+ * Tests the server chores on the worker thread including:
+ * - Uploads sorted into their program's folder and scheduled
+ * - Programs fetched from the FTP server scheduled
+ * - TakeOver requests confirmed and reported
+ * - Return requests reported and removed
+ */
+class TestBroadcastWorker : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void testUploadIsSortedAndScheduled();
+    void testDownloadedProgramIsScheduled();
+    void testTakeOverRequest();
+    void testReturnTakeOver();
+};
+
+#endif // TESTBROADCASTWORKER_H
@@ -0,0 +1,113 @@
+#include "TestBulkTrackOperations.h"
+#include "../../../src/repositories/MusicRepository.h"
+#include "../../../src/services/BulkTrackOperations.h"
+#include <QFile>
+#include <QSignalSpy>
+#include <QSqlQuery>
+#include <QStringListModel>
+
+namespace {
+
+const char* CONNECTION_NAME = "test_bulk_track_operations_connection";
+
+} // namespace
+
+void TestBulkTrackOperations::init()
+{
+    m_tempDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_tempDir->isValid());
+
+    m_database = QSqlDatabase::addDatabase("QSQLITE", CONNECTION_NAME);
+    m_database.setDatabaseName(m_tempDir->filePath("library.db"));
+    QVERIFY(m_database.open());
+
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("CREATE TABLE musics (id INTEGER PRIMARY KEY AUTOINCREMENT, artist TEXT, "
+                       "song TEXT, genre1 TEXT, genre2 TEXT, country TEXT, published_date TEXT, "
+                       "path TEXT, time TEXT, played_times INTEGER DEFAULT 0, last_played TEXT)"));
+    m_repository = std::make_unique<MusicRepository>(m_database);
+}
+
+void TestBulkTrackOperations::cleanup()
+{
+    m_repository.reset();
+    if (m_database.isOpen()) {
+        m_database.close();
+    }
+    m_database = QSqlDatabase();
+    QSqlDatabase::removeDatabase(CONNECTION_NAME);
+    m_tempDir.reset();
+}
+
+int TestBulkTrackOperations::addTrack(const QString& path)
+{
+    QSqlQuery query(m_database);
+    query.prepare("INSERT INTO musics (artist, song, path) VALUES ('Artist', 'Song', ?)");
+    query.addBindValue(path);
+    return query.exec() ? query.lastInsertId().toInt() : -1;
+}
+
+void TestBulkTrackOperations::testUniqueRows()
+{
+    // The view selects whole rows, so each row comes once per column
+    QStringListModel model({"a", "b", "c", "d", "e"});
+    const QModelIndexList cells = {model.index(3), model.index(1), model.index(3),
+                                   model.index(1), model.index(0)};
+    QCOMPARE(BulkTrackOperations::uniqueRows(cells), QList<int>({0, 1, 3}));
+    QVERIFY(BulkTrackOperations::uniqueRows({}).isEmpty());
+}
+
+void TestBulkTrackOperations::testRemoveTracks()
+{
+    const int first = addTrack("/music/a.ogg");
+    const int second = addTrack("/music/b.ogg");
+    const int third = addTrack("/music/c.ogg");
+
+    BulkTrackOperations bulk(m_repository.get());
+    QSignalSpy removed(&bulk, &BulkTrackOperations::tracksRemoved);
+    QSignalSpy files(&bulk, &BulkTrackOperations::filesDeleted);
+
+    QCOMPARE(bulk.removeTracks({third, first, third}, false), 2);
+    QCOMPARE(removed.count(), 1);
+    QCOMPARE(removed.at(0).at(0).value<QList<int>>(), QList<int>({first, third}));
+    QVERIFY(!bulk.isDeletingFiles());
+    QCOMPARE(files.count(), 0);
+
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("SELECT id FROM musics") && query.next());
+    QCOMPARE(query.value(0).toInt(), second);
+    QVERIFY(!query.next());
+
+    // Nothing left to delete: no signal
+    QCOMPARE(bulk.removeTracks({first}, false), 0);
+    QCOMPARE(removed.count(), 1);
+}
+
+void TestBulkTrackOperations::testRemoveTracksWithFiles()
+{
+    const QString kept = m_tempDir->filePath("kept.ogg");
+    const QString gone = m_tempDir->filePath("gone.ogg");
+    for (const QString& path : {kept, gone}) {
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("audio");
+    }
+    const QString missing = m_tempDir->filePath("missing.ogg");
+    const int goneId = addTrack(gone);
+    const int missingId = addTrack(missing);
+    addTrack(kept);
+
+    BulkTrackOperations bulk(m_repository.get());
+    QSignalSpy files(&bulk, &BulkTrackOperations::filesDeleted);
+    QCOMPARE(bulk.removeTracks({goneId, missingId}, true), 2);
+    QVERIFY(files.wait());
+
+    const auto result = files.at(0).at(0).value<BulkTrackOperations::FileDeletion>();
+    QCOMPARE(result.deleted, QStringList({gone}));
+    QCOMPARE(result.missing, QStringList({missing}));
+    QVERIFY(result.failed.isEmpty());
+    QVERIFY(!QFile::exists(gone));
+    QVERIFY(QFile::exists(kept));
+}
+
+QTEST_MAIN(TestBulkTrackOperations)
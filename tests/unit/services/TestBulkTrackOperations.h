@@ -0,0 +1,40 @@
+#ifndef TESTBULKTRACKOPERATIONS_H
+#define TESTBULKTRACKOPERATIONS_H
+
+#include <QObject>
+#include <QTest>
+#include <QSqlDatabase>
+#include <QTemporaryDir>
+#include <memory>
+
+class MusicRepository;
+
+/**
+ * @brief Unit tests for BulkTrackOperations class
+ *
+ * Tests the multi-selection operations including:
+ * - One entry per selected row, whatever the number of cells
+ * - Deleting every selected track and reporting their IDs once
+ * - Removing the files in the background, with missing ones reported
+ */
+class TestBulkTrackOperations : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testUniqueRows();
+    void testRemoveTracks();
+    void testRemoveTracksWithFiles();
+
+private:
+    int addTrack(const QString& path);
+
+    std::unique_ptr<QTemporaryDir> m_tempDir;
+    QSqlDatabase m_database;
+    std::unique_ptr<MusicRepository> m_repository;
+};
+
+#endif // TESTBULKTRACKOPERATIONS_H
@@ -0,0 +1,167 @@
+#include "TestCartWall.h"
+#include "../../../src/services/CartWall.h"
+#include <vector>
+
+namespace {
+
+constexpr int RATE = 1000;
+
+std::vector<float> constant(int frames, float value)
+{
+    return std::vector<float>(size_t(frames) * CartWall::CHANNELS, value);
+}
+
+std::vector<float> render(CartWall& carts, int frames, float base = 0.0f, int rate = RATE)
+{
+    std::vector<float> out(size_t(frames) * CartWall::CHANNELS, base);
+    carts.render(out.data(), frames, rate);
+    return out;
+}
+
+} // namespace
+
+void TestCartWall::testRenderAddsToOutput()
+{
+    CartWall carts;
+    QVERIFY(carts.setCart(0, "/jingles/id.ogg", constant(100, 0.5f), RATE));
+    QCOMPARE(carts.slotOf("/jingles/id.ogg"), 0);
+    QCOMPARE(carts.durationMs(0), qint64(100));
+    QCOMPARE(carts.memoryBytes(), qint64(200 * sizeof(float)));
+
+    QVERIFY(carts.trigger(0));
+    QVERIFY(!carts.isIdle());
+
+    const std::vector<float> out = render(carts, 60, 0.25f);
+    QCOMPARE(out.front(), 0.75f);
+    QCOMPARE(out.back(), 0.75f);
+    QCOMPARE(carts.activeVoices(), 1);
+
+    // 40 frames are left; the rest of the block is the output as it was
+    const std::vector<float> tail = render(carts, 60, 0.25f);
+    QCOMPARE(tail[39 * CartWall::CHANNELS], 0.75f);
+    QCOMPARE(tail[40 * CartWall::CHANNELS], 0.25f);
+    QCOMPARE(carts.activeVoices(), 0);
+    QVERIFY(carts.isIdle());
+}
+
+void TestCartWall::testCartsOverlap()
+{
+    CartWall carts;
+    QVERIFY(carts.setCart(0, "/jingles/a.ogg", constant(100, 0.25f), RATE));
+    QVERIFY(carts.setCart(1, "/jingles/b.ogg", constant(100, 0.5f), RATE));
+
+    QVERIFY(carts.trigger(0));
+    QVERIFY(carts.trigger(1));
+    const std::vector<float> out = render(carts, 10);
+    QCOMPARE(out.front(), 0.75f);
+    QCOMPARE(carts.activeVoices(), 2);
+}
+
+void TestCartWall::testRetriggerStartsOver()
+{
+    CartWall carts;
+    QVERIFY(carts.setCart(0, "/jingles/id.ogg", constant(100, 0.5f), RATE));
+
+    QVERIFY(carts.trigger(0));
+    render(carts, 80);
+    QVERIFY(carts.trigger(0));
+
+    // Played once from the top, not twice at once
+    const std::vector<float> out = render(carts, 100);
+    QCOMPARE(out.back(), 0.5f);
+    QCOMPARE(carts.activeVoices(), 0);
+}
+
+void TestCartWall::testOldestVoiceGivesWay()
+{
+    CartWall carts;
+    for (int slot = 0; slot <= CartWall::MAX_VOICES; ++slot) {
+        QVERIFY(carts.setCart(slot, QString("/jingles/%1.ogg").arg(slot),
+                              constant(1000, 0.125f * (slot == 0 ? 2 : 1)), RATE));
+    }
+
+    for (int slot = 0; slot < CartWall::MAX_VOICES; ++slot) {
+        QVERIFY(carts.trigger(slot));
+        render(carts, 1);
+    }
+    QCOMPARE(carts.activeVoices(), CartWall::MAX_VOICES);
+
+    // Slot 0, the loudest and first fired, is the one replaced
+    QVERIFY(carts.trigger(CartWall::MAX_VOICES));
+    const std::vector<float> out = render(carts, 1);
+    QCOMPARE(carts.activeVoices(), CartWall::MAX_VOICES);
+    QCOMPARE(out.front(), 0.125f * CartWall::MAX_VOICES);
+}
+
+void TestCartWall::testResamplesToOutputRate()
+{
+    CartWall carts;
+    std::vector<float> ramp;
+    for (int frame = 0; frame < 200; ++frame) {
+        ramp.push_back(float(frame));
+        ramp.push_back(float(frame));
+    }
+    QVERIFY(carts.setCart(0, "/jingles/ramp.ogg", std::move(ramp), 2 * RATE));
+
+    // Twice the output rate: every other frame, done in half the frames
+    QVERIFY(carts.trigger(0));
+    const std::vector<float> out = render(carts, 100);
+    QCOMPARE(out[0], 0.0f);
+    QCOMPARE(out[10 * CartWall::CHANNELS], 20.0f);
+    QCOMPARE(out[99 * CartWall::CHANNELS + 1], 198.0f);
+    render(carts, 1);
+    QVERIFY(carts.isIdle());
+
+    // Half the output rate: halfway frames are interpolated
+    CartWall slow;
+    QVERIFY(slow.setCart(0, "/jingles/ramp.ogg", {0.0f, 0.0f, 1.0f, 1.0f, 2.0f, 2.0f}, RATE / 2));
+    QVERIFY(slow.trigger(0));
+    const std::vector<float> stretched = render(slow, 3);
+    QCOMPARE(stretched[1 * CartWall::CHANNELS], 0.5f);
+    QCOMPARE(stretched[2 * CartWall::CHANNELS], 1.0f);
+}
+
+void TestCartWall::testStopAndIdle()
+{
+    CartWall carts;
+    QVERIFY(carts.setCart(0, "/jingles/a.ogg", constant(1000, 0.5f), RATE));
+    QVERIFY(carts.setCart(1, "/jingles/b.ogg", constant(1000, 0.25f), RATE));
+    QVERIFY(carts.isIdle());
+
+    QVERIFY(carts.trigger(0));
+    QVERIFY(carts.trigger(1));
+    render(carts, 10);
+
+    carts.stop(0);
+    QCOMPARE(render(carts, 10).front(), 0.25f);
+    QCOMPARE(carts.activeVoices(), 1);
+
+    carts.stopAll();
+    QCOMPARE(render(carts, 10).front(), 0.0f);
+    QVERIFY(carts.isIdle());
+
+    // A cart unloaded while it plays finishes
+    QVERIFY(carts.trigger(0));
+    render(carts, 10);
+    carts.unload(0);
+    QVERIFY(!carts.isLoaded(0));
+    QVERIFY(!carts.trigger(0));
+    QCOMPARE(render(carts, 10).front(), 0.5f);
+}
+
+void TestCartWall::testRefusedCarts()
+{
+    CartWall carts;
+    QVERIFY(!carts.setCart(-1, "/jingles/a.ogg", constant(10, 0.5f), RATE));
+    QVERIFY(!carts.setCart(CartWall::MAX_CARTS, "/jingles/a.ogg", constant(10, 0.5f), RATE));
+    QVERIFY(!carts.setCart(0, "/jingles/a.ogg", {}, RATE));
+    QVERIFY(!carts.setCart(0, "/jingles/a.ogg", constant(10, 0.5f), 0));
+    QVERIFY(!carts.setCart(0, "/jingles/long.ogg",
+                           constant(CartWall::MAX_CART_SECONDS * RATE + 1, 0.5f), RATE));
+    QVERIFY(!carts.isLoaded(0));
+    QVERIFY(!carts.trigger(0));
+    QCOMPARE(carts.durationMs(0), qint64(-1));
+    QCOMPARE(carts.slotOf("/jingles/a.ogg"), -1);
+}
+
+QTEST_MAIN(TestCartWall)
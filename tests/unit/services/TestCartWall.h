@@ -0,0 +1,31 @@
+#ifndef TESTCARTWALL_H
+#define TESTCARTWALL_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for CartWall class
+ *
+ * Tests the in-memory jingle bus including:
+ * - Carts added on top of the output they are rendered into
+ * - Several carts overlapping, and a fired cart starting over
+ * - The oldest voice giving way when all are busy
+ * - Carts at another rate than the output
+ * - Stopping, idling and refused carts
+ */
+class TestCartWall : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testRenderAddsToOutput();
+    void testCartsOverlap();
+    void testRetriggerStartsOver();
+    void testOldestVoiceGivesWay();
+    void testResamplesToOutputRate();
+    void testStopAndIdle();
+    void testRefusedCarts();
+};
+
+#endif // TESTCARTWALL_H
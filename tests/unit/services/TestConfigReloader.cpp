@@ -0,0 +1,91 @@
+#include "TestConfigReloader.h"
+#include "../../../src/services/ConfigReloader.h"
+
+void TestConfigReloader::init()
+{
+    m_tempDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_tempDir->isValid());
+    m_settings =
+        std::make_unique<QSettings>(m_tempDir->filePath("xfb.conf"), QSettings::IniFormat);
+    m_settings->setValue("MetricsPort", 0);
+    m_settings->setValue("DeadAirSeconds", 10);
+    m_settings->setValue("DeadAirThresholdDb", -50.0);
+}
+
+void TestConfigReloader::cleanup()
+{
+    m_settings.reset();
+    m_tempDir.reset();
+}
+
+void TestConfigReloader::testFirstReloadOnlyRecords()
+{
+    ConfigReloader reloader;
+    int applied = 0;
+    reloader.subscribe("metrics", {"MetricsPort"}, [&applied]() { ++applied; });
+
+    QVERIFY(!reloader.isLoaded());
+    QVERIFY(reloader.reload(*m_settings).isEmpty());
+    QVERIFY(reloader.isLoaded());
+    QCOMPARE(applied, 0);
+
+    QVERIFY(reloader.reload(*m_settings).isEmpty());
+    QVERIFY(reloader.changedKeys().isEmpty());
+    QCOMPARE(applied, 0);
+}
+
+void TestConfigReloader::testRunsOnlyChangedSubscriptions()
+{
+    ConfigReloader reloader;
+    QStringList order;
+    reloader.subscribe("metrics", {"MetricsPort"}, [&order]() { order << "metrics"; });
+    reloader.subscribe("dead air", {"DeadAirSeconds", "DeadAirThresholdDb"},
+                       [&order]() { order << "dead air"; });
+    reloader.reload(*m_settings);
+
+    m_settings->setValue("DeadAirSeconds", 20);
+    m_settings->setValue("DeadAirThresholdDb", -40.0);
+    QCOMPARE(reloader.reload(*m_settings), QStringList{"dead air"});
+    QCOMPARE(order, QStringList{"dead air"});
+    QCOMPARE(reloader.changedKeys(), (QStringList{"DeadAirSeconds", "DeadAirThresholdDb"}));
+
+    m_settings->setValue("MetricsPort", 9100);
+    m_settings->setValue("DeadAirSeconds", 30);
+    QCOMPARE(reloader.reload(*m_settings), (QStringList{"metrics", "dead air"}));
+}
+
+void TestConfigReloader::testPrefixKeys()
+{
+    ConfigReloader reloader;
+    int applied = 0;
+    reloader.subscribe("dead air", {"DeadAir*"}, [&applied]() { ++applied; });
+    reloader.reload(*m_settings);
+
+    m_settings->setValue("MetricsPort", 9100);
+    reloader.reload(*m_settings);
+    QCOMPARE(applied, 0);
+
+    m_settings->setValue("DeadAirThresholdDb", -45.0);
+    reloader.reload(*m_settings);
+    QCOMPARE(applied, 1);
+}
+
+void TestConfigReloader::testAddedAndRemovedKeys()
+{
+    ConfigReloader reloader;
+    int applied = 0;
+    reloader.subscribe("remote control", {"RemotePort", "RemoteToken"},
+                       [&applied]() { ++applied; });
+    reloader.reload(*m_settings);
+
+    m_settings->setValue("RemoteToken", "secret");
+    reloader.reload(*m_settings);
+    QCOMPARE(applied, 1);
+
+    m_settings->remove("RemoteToken");
+    reloader.reload(*m_settings);
+    QCOMPARE(applied, 2);
+    QCOMPARE(reloader.changedKeys(), QStringList{"RemoteToken"});
+}
+
+QTEST_MAIN(TestConfigReloader)
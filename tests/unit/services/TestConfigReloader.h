@@ -0,0 +1,37 @@
+#ifndef TESTCONFIGRELOADER_H
+#define TESTCONFIGRELOADER_H
+
+#include <QObject>
+#include <QSettings>
+#include <QTemporaryDir>
+#include <QTest>
+#include <memory>
+
+/**
+ * @brief Unit tests for ConfigReloader class
+ *
+ * Tests the reload of changed settings including:
+ * - Recording the first settings without applying them
+ * - Running only the subscriptions whose keys changed, once each
+ * - Matching keys by prefix
+ * - Counting added and removed keys as changes
+ */
+class TestConfigReloader : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testFirstReloadOnlyRecords();
+    void testRunsOnlyChangedSubscriptions();
+    void testPrefixKeys();
+    void testAddedAndRemovedKeys();
+
+private:
+    std::unique_ptr<QTemporaryDir> m_tempDir;
+    std::unique_ptr<QSettings> m_settings;
+};
+
+#endif // TESTCONFIGRELOADER_H
@@ -0,0 +1,117 @@
+#include "TestConfigurationService.h"
+#include "../../../src/services/ConfigurationService.h"
+#include <QDir>
+#include <QFile>
+#include <QStandardPaths>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+void TestConfigurationService::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+void TestConfigurationService::init()
+{
+    const QString configPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QFile::remove(QDir(configPath).filePath("xfb.conf"));
+}
+
+void TestConfigurationService::testGetValueAndDefaults()
+{
+    ConfigurationService config;
+    QVERIFY(config.initialize());
+
+    QCOMPARE(config.getLanguage(), QString("en"));
+    QCOMPARE(config.getDefaultVolume(), 75);
+    QCOMPARE(config.getValue("missing/key", 42).toInt(), 42);
+    QVERIFY(!config.getValue("missing/key").isValid());
+
+    config.setValue("playout/mode", "auto");
+    QCOMPARE(config.getValue("playout/mode").toString(), QString("auto"));
+    config.setDefaultVolume(40);
+    QCOMPARE(config.getDefaultVolume(), 40);
+}
+
+void TestConfigurationService::testSnapshotIsImmutable()
+{
+    ConfigurationService config;
+    QVERIFY(config.initialize());
+    config.setValue("paths/music", "/srv/music");
+
+    const std::shared_ptr<const QVariantHash> before = config.snapshot();
+    config.setValue("paths/music", "/mnt/nas/music");
+    config.setValue("paths/jingles", "/mnt/nas/jingles");
+
+    QCOMPARE(before->value("paths/music").toString(), QString("/srv/music"));
+    QVERIFY(!before->contains("paths/jingles"));
+
+    const std::shared_ptr<const QVariantHash> after = config.snapshot();
+    QVERIFY(after != before);
+    QCOMPARE(after->value("paths/music").toString(), QString("/mnt/nas/music"));
+    QCOMPARE(after->value("paths/jingles").toString(), QString("/mnt/nas/jingles"));
+
+    // An unchanged value publishes nothing new
+    config.setValue("paths/music", "/mnt/nas/music");
+    QVERIFY(config.snapshot() == after);
+}
+
+void TestConfigurationService::testReadFromChangedSignal()
+{
+    ConfigurationService config;
+    QVERIFY(config.initialize());
+
+    QString seen;
+    connect(&config, &ConfigurationService::configurationChanged, this,
+            [&config, &seen](const QString& key, const QVariant&) {
+                seen = config.getValue(key).toString();
+            });
+    config.setValue("ui/language", "pt");
+    QCOMPARE(seen, QString("pt"));
+}
+
+void TestConfigurationService::testConcurrentReaders()
+{
+    ConfigurationService config;
+    QVERIFY(config.initialize());
+    config.setValue("stream/port", 1000);
+
+    std::atomic_bool stop(false);
+    std::atomic_int badReads(0);
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i) {
+        readers.emplace_back([&config, &stop, &badReads]() {
+            while (!stop.load()) {
+                const int port = config.getValue("stream/port").toInt();
+                if (port < 1000 || port >= 1200) {
+                    ++badReads;
+                }
+            }
+        });
+    }
+
+    for (int port = 1000; port < 1200; ++port) {
+        config.setValue("stream/port", port);
+    }
+    stop.store(true);
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+
+    QCOMPARE(badReads.load(), 0);
+    QCOMPARE(config.getValue("stream/port").toInt(), 1199);
+}
+
+void TestConfigurationService::testInvalidValueRejected()
+{
+    ConfigurationService config;
+    QVERIFY(config.initialize());
+
+    const std::shared_ptr<const QVariantHash> before = config.snapshot();
+    config.setValue("audio/defaultVolume", 150);
+    QCOMPARE(config.getDefaultVolume(), 75);
+    QVERIFY(config.snapshot() == before);
+}
+
+QTEST_MAIN(TestConfigurationService)
@@ -0,0 +1,32 @@
+#ifndef TESTCONFIGURATIONSERVICE_H
+#define TESTCONFIGURATIONSERVICE_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for ConfigurationService class
+ *
+ * Tests the configuration snapshot including:
+ * - Values and defaults read from the snapshot
+ * - Old snapshots left unchanged by later writes
+ * - Slots reading the configuration from configurationChanged
+ * - Readers on other threads while values change
+ * - Invalid values rejected without a new snapshot
+ */
+class TestConfigurationService : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void init();
+
+    void testGetValueAndDefaults();
+    void testSnapshotIsImmutable();
+    void testReadFromChangedSignal();
+    void testConcurrentReaders();
+    void testInvalidValueRejected();
+};
+
+#endif // TESTCONFIGURATIONSERVICE_H
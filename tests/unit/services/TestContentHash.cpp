@@ -0,0 +1,221 @@
+#include "TestContentHash.h"
+#include "../../../src/repositories/MusicRepository.h"
+#include "../../../src/services/ContentHash.h"
+#include "../../../src/services/ContentHashScanner.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QSignalSpy>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QtEndian>
+
+namespace {
+
+const char* CONNECTION_NAME = "test_content_hash_connection";
+
+// Bytes that look like nothing in particular, the same on every run
+QByteArray audio(int size, quint32 seed)
+{
+    QByteArray bytes(size, Qt::Uninitialized);
+    for (int i = 0; i < size; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        bytes[i] = char(seed >> 24);
+    }
+    return bytes;
+}
+
+QByteArray id3v2(int bodySize)
+{
+    QByteArray tag("ID3\x04\x00\x00", 6);
+    tag.append(char((bodySize >> 21) & 0x7F));
+    tag.append(char((bodySize >> 14) & 0x7F));
+    tag.append(char((bodySize >> 7) & 0x7F));
+    tag.append(char(bodySize & 0x7F));
+    tag.append(QByteArray(bodySize, 'T'));
+    return tag;
+}
+
+QByteArray id3v1(const QByteArray& title)
+{
+    const QByteArray tag = "TAG" + title;
+    return tag + QByteArray(128 - tag.size(), '\0');
+}
+
+// An APEv2 tag with a header; its size field counts the items and the footer
+QByteArray apeV2(const QByteArray& items)
+{
+    auto block = [&items](quint32 flags) {
+        QByteArray bytes("APETAGEX", 8);
+        QByteArray fields(24, '\0');
+        qToLittleEndian<quint32>(2000, fields.data());
+        qToLittleEndian<quint32>(quint32(items.size() + 32), fields.data() + 4);
+        qToLittleEndian<quint32>(1, fields.data() + 8);
+        qToLittleEndian<quint32>(flags, fields.data() + 12);
+        return bytes + fields;
+    };
+    return block(0xA0000000u) + items + block(0x80000000u);
+}
+
+QByteArray flacBlock(int type, bool last, const QByteArray& body)
+{
+    QByteArray block(4, '\0');
+    block[0] = char(type | (last ? 0x80 : 0));
+    block[1] = char(body.size() >> 16);
+    block[2] = char(body.size() >> 8);
+    block[3] = char(body.size());
+    return block + body;
+}
+
+} // namespace
+
+void TestContentHash::init()
+{
+    m_tempDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_tempDir->isValid());
+}
+
+QString TestContentHash::writeFile(const QString& name, const QByteArray& bytes)
+{
+    const QString path = m_tempDir->filePath(name);
+    QFile file(path);
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(bytes);
+    }
+    return path;
+}
+
+void TestContentHash::testXxh64()
+{
+    auto hash = [](const QByteArray& bytes) {
+        return ContentHash::xxh64(bytes.constData(), bytes.size());
+    };
+    QCOMPARE(hash(QByteArray()), Q_UINT64_C(0xEF46DB3751D8E999));
+    QCOMPARE(hash("a"), Q_UINT64_C(0xD24EC4F1A98C6E5B));
+    QCOMPARE(hash("abc"), Q_UINT64_C(0x44BC2CF5AD770999));
+    QCOMPARE(hash("Nobody inspects the spammish repetition"), Q_UINT64_C(0xFBCEA83C8A378BF1));
+}
+
+void TestContentHash::testIgnoresTags()
+{
+    // Long enough to be sampled, and short enough to be hashed whole
+    for (int size : {1000, 3 * ContentHash::SAMPLE_SIZE + 5000}) {
+        const QByteArray payload = audio(size, 7);
+        const QString plain = writeFile("plain.mp3", payload);
+        const QString tagged = writeFile("tagged.mp3", id3v2(3000) + payload + id3v1("Song"));
+        const QString retagged = writeFile(
+            "retagged.mp3", id3v2(120) + payload + apeV2(audio(200, 3)) + id3v1("Other Song"));
+
+        QString error;
+        const QString hash = ContentHash::ofFile(plain, &error);
+        QVERIFY2(!hash.isEmpty(), qPrintable(error));
+        QCOMPARE(hash.size(), 16);
+        QCOMPARE(ContentHash::ofFile(tagged), hash);
+        QCOMPARE(ContentHash::ofFile(retagged), hash);
+
+        QFile file(retagged);
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        const ContentHash::Range range = ContentHash::payloadRange(file);
+        QCOMPARE(range.offset, qint64(130));
+        QCOMPARE(range.length, qint64(size));
+    }
+}
+
+void TestContentHash::testSkipsFlacMetadata()
+{
+    const QByteArray frames = audio(50000, 11);
+    const QByteArray streamInfo = flacBlock(0, false, audio(34, 1));
+    const QString first = writeFile(
+        "first.flac", "fLaC" + streamInfo + flacBlock(4, true, "ARTIST=Somebody") + frames);
+    const QString second = writeFile("second.flac", "fLaC" + streamInfo +
+                                                        flacBlock(4, false, "ARTIST=Somebody Else") +
+                                                        flacBlock(6, true, audio(4000, 5)) + frames);
+
+    const QString hash = ContentHash::ofFile(first);
+    QVERIFY(!hash.isEmpty());
+    QCOMPARE(ContentHash::ofFile(second), hash);
+    QCOMPARE(ContentHash::ofFile(writeFile("frames.flac", frames)), hash);
+}
+
+void TestContentHash::testDetectsChanges()
+{
+    const QByteArray payload = audio(4 * ContentHash::SAMPLE_SIZE, 13);
+    const QString hash = ContentHash::ofFile(writeFile("original.mp3", payload));
+
+    QByteArray changed = payload;
+    changed[payload.size() / 2] = char(changed.at(payload.size() / 2) ^ 0x01);
+    QVERIFY(ContentHash::ofFile(writeFile("changed.mp3", changed)) != hash);
+    QVERIFY(ContentHash::ofFile(writeFile("cut.mp3", payload.left(payload.size() - 1))) != hash);
+    QVERIFY(ContentHash::ofFile(writeFile("other.mp3", audio(payload.size(), 17))) != hash);
+}
+
+void TestContentHash::testUnreadableFiles()
+{
+    QString error;
+    QVERIFY(ContentHash::ofFile(m_tempDir->filePath("missing.mp3"), &error).isEmpty());
+    QVERIFY(!error.isEmpty());
+
+    error.clear();
+    QVERIFY(ContentHash::ofFile(writeFile("tags.mp3", id3v2(500) + id3v1("Song")), &error).isEmpty());
+    QVERIFY(!error.isEmpty());
+}
+
+void TestContentHash::testScannerStoresHashes()
+{
+    {
+        QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", CONNECTION_NAME);
+        database.setDatabaseName(m_tempDir->filePath("test.db"));
+        QVERIFY(database.open());
+        QSqlQuery query(database);
+        QVERIFY2(query.exec("CREATE TABLE musics (id INTEGER PRIMARY KEY AUTOINCREMENT, "
+                            "artist TEXT, song TEXT, genre1 TEXT, genre2 TEXT, country TEXT, "
+                            "published_date TEXT, path TEXT, time TEXT, "
+                            "played_times INTEGER DEFAULT 0, last_played TEXT)"),
+                 qPrintable(query.lastError().text()));
+
+        const QByteArray payload = audio(20000, 19);
+        const QStringList paths = {
+            writeFile("one.mp3", payload), writeFile("two.mp3", id3v2(300) + payload),
+            writeFile("three.mp3", audio(20000, 23)), writeFile("gone.mp3", payload)
+        };
+        {
+            MusicRepository repository(database);
+            QList<MusicItem> tracks;
+            for (const QString& path : paths) {
+                MusicItem track;
+                track.artist = "Artist";
+                track.song = QFileInfo(path).baseName();
+                track.genre1 = "Pop";
+                track.path = path;
+                track.time = "0:00:01";
+                tracks.append(track);
+            }
+            QCOMPARE(repository.addMusicBatch(tracks), 4);
+            QCOMPARE(repository.getPathsWithoutContentHash(), paths);
+            QVERIFY(QFile::remove(paths.at(3)));
+
+            ContentHashScanner scanner(&repository);
+            QSignalSpy finishedSpy(&scanner, &ContentHashScanner::finished);
+            QSignalSpy progressSpy(&scanner, &ContentHashScanner::progressChanged);
+            scanner.setMaxWorkers(2);
+            QCOMPARE(scanner.scan(repository.getPathsWithoutContentHash()), 4);
+            QVERIFY(finishedSpy.wait(5000));
+            QCOMPARE(finishedSpy.first().at(0).toInt(), 3);
+            QCOMPARE(finishedSpy.first().at(1).toInt(), 1);
+            QCOMPARE(progressSpy.count(), 4);
+            QVERIFY(!scanner.isRunning());
+
+            QCOMPARE(repository.getPathsWithoutContentHash(), QStringList{paths.at(3)});
+            const QList<QList<MusicItem>> groups = repository.findContentDuplicates();
+            QCOMPARE(groups.size(), 1);
+            QCOMPARE(groups.first().size(), 2);
+            QCOMPARE(groups.first().at(0).path, paths.at(0));
+            QCOMPARE(groups.first().at(1).path, paths.at(1));
+            QCOMPARE(repository.findMusicByContentHash(ContentHash::ofFile(paths.at(2))).path,
+                     paths.at(2));
+        }
+        database.close();
+    }
+    QSqlDatabase::removeDatabase(CONNECTION_NAME);
+}
+
+QTEST_MAIN(TestContentHash)
@@ -0,0 +1,39 @@
+#ifndef TESTCONTENTHASH_H
+#define TESTCONTENTHASH_H
+
+#include <QObject>
+#include <QTemporaryDir>
+#include <QTest>
+#include <memory>
+
+/**
+ * @brief Unit tests for ContentHash and ContentHashScanner classes
+ *
+ * Tests the audio fingerprint behind duplicate detection including:
+ * - XXH64 against the reference values
+ * - Getting the same hash whatever the ID3v2, APEv2 and ID3v1 tags
+ * - Skipping FLAC metadata blocks
+ * - Telling apart files whose audio differs or was cut short
+ * - Reporting files that cannot be read or hold only tags
+ * - Hashing library tracks in the background and storing the hashes
+ */
+class TestContentHash : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void testXxh64();
+    void testIgnoresTags();
+    void testSkipsFlacMetadata();
+    void testDetectsChanges();
+    void testUnreadableFiles();
+    void testScannerStoresHashes();
+
+private:
+    QString writeFile(const QString& name, const QByteArray& bytes);
+
+    std::unique_ptr<QTemporaryDir> m_tempDir;
+};
+
+#endif // TESTCONTENTHASH_H
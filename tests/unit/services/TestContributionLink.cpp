@@ -0,0 +1,118 @@
+#include "TestContributionLink.h"
+#include "../../../src/services/ContributionLink.h"
+#include <QElapsedTimer>
+#include <cmath>
+#include <memory>
+
+namespace {
+
+#ifdef XFB_HAVE_OPUS
+// A 440 Hz tone at half scale, handed out at the pace of a sound card
+struct ToneSource {
+    QElapsedTimer clock;
+    qint64 produced = 0;
+
+    int read(float* data, int samples)
+    {
+        const qint64 due = clock.elapsed() * ContributionLink::SAMPLE_RATE / 1000;
+        const int frames = int(qMin<qint64>(due - produced, samples / 2));
+        for (int i = 0; i < frames; ++i) {
+            const double t = double(produced + i) / ContributionLink::SAMPLE_RATE;
+            data[i * 2] = data[i * 2 + 1] = float(0.5 * std::sin(2 * M_PI * 440 * t));
+        }
+        produced += frames;
+        return frames * 2;
+    }
+};
+#endif
+
+} // namespace
+
+void TestContributionLink::testPacketRoundTrip()
+{
+    ContributionLink::Packet packet;
+    packet.redundant = true;
+    packet.sequence = 65000;
+    packet.streamId = 42;
+    packet.primary = "abc";
+    packet.previous = "de";
+    const QByteArray datagram = ContributionLink::encodePacket(packet);
+    QCOMPARE(datagram.size(), ContributionLink::HEADER_BYTES + 5);
+    QVERIFY(datagram.startsWith("XC"));
+
+    ContributionLink::Packet read;
+    QVERIFY(ContributionLink::decodePacket(datagram, read));
+    QVERIFY(read.redundant);
+    QCOMPARE(read.sequence, quint16(65000));
+    QCOMPARE(read.streamId, quint16(42));
+    QCOMPARE(read.primary, QByteArray("abc"));
+    QCOMPARE(read.previous, QByteArray("de"));
+
+    // The first packet of a stream has nothing before it
+    packet.previous.clear();
+    QVERIFY(ContributionLink::decodePacket(ContributionLink::encodePacket(packet), read));
+    QVERIFY(!read.redundant);
+    QVERIFY(read.previous.isEmpty());
+    QCOMPARE(read.primary, QByteArray("abc"));
+}
+
+void TestContributionLink::testRejectsForeignDatagrams()
+{
+    ContributionLink::Packet packet;
+    packet.primary = "abc";
+    const QByteArray datagram = ContributionLink::encodePacket(packet);
+
+    ContributionLink::Packet read;
+    QVERIFY(!ContributionLink::decodePacket(QByteArray(), read));
+    QVERIFY(!ContributionLink::decodePacket("GET / HTTP/1.1\r\n", read));
+    const QByteArray cut = datagram.left(ContributionLink::HEADER_BYTES + 2);
+    QVERIFY(!ContributionLink::decodePacket(cut, read));
+
+    QByteArray other = datagram;
+    other[1] = 'D';
+    QVERIFY(!ContributionLink::decodePacket(other, read));
+    packet.primary.clear();
+    QVERIFY(!ContributionLink::decodePacket(ContributionLink::encodePacket(packet), read));
+}
+
+void TestContributionLink::testLoopback()
+{
+#ifndef XFB_HAVE_OPUS
+    QVERIFY(!ContributionLink::isAvailable());
+    QSKIP("Built without Opus");
+#else
+    ContributionLink receiver;
+    receiver.listen(0);
+    QTRY_VERIFY(receiver.localPort() != 0);
+
+    auto tone = std::make_shared<ToneSource>();
+    tone->clock.start();
+    ContributionLink sender;
+    sender.send(QHostAddress::LocalHost, receiver.localPort(),
+                [tone](float* data, int samples) { return tone->read(data, samples); },
+                ContributionLink::SAMPLE_RATE);
+    QTRY_VERIFY(receiver.isReceiving());
+
+    // Played out in real time, the tone comes through once the buffer fills
+    std::vector<float> frame(size_t(ContributionLink::FRAME_SAMPLES) * 2);
+    float peak = 0;
+    for (int i = 0; i < 50; ++i) {
+        QTest::qWait(ContributionLink::FRAME_MS);
+        QCOMPARE(receiver.read(frame.data(), int(frame.size())), int(frame.size()));
+        for (float sample : frame) {
+            peak = qMax(peak, std::abs(sample));
+        }
+    }
+    QVERIFY(peak > 0.3f);
+    QVERIFY(peak < 0.7f);
+    QVERIFY(sender.packetsSent() > 0);
+    const ContributionLink::Statistics statistics = receiver.statistics();
+    QVERIFY(statistics.network.received > 0);
+    QVERIFY(qAbs(statistics.drift) <= DriftResampler::MAX_DRIFT);
+
+    sender.stop();
+    QTRY_VERIFY_WITH_TIMEOUT(!receiver.isReceiving(), 3 * ContributionLink::RECEIVE_TIMEOUT_MS);
+#endif
+}
+
+QTEST_MAIN(TestContributionLink)
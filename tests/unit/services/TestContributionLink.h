@@ -0,0 +1,25 @@
+#ifndef TESTCONTRIBUTIONLINK_H
+#define TESTCONTRIBUTIONLINK_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for ContributionLink class
+ *
+ * Tests the contribution link including:
+ * - Datagrams written and read back
+ * - Datagrams that are not the link's
+ * - Audio sent and received over the loopback, when built with Opus
+ */
+class TestContributionLink : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testPacketRoundTrip();
+    void testRejectsForeignDatagrams();
+    void testLoopback();
+};
+
+#endif // TESTCONTRIBUTIONLINK_H
@@ -0,0 +1,149 @@
+#include "TestCuePointStore.h"
+#include "../../../src/services/CuePointStore.h"
+#include <QSqlQuery>
+#include <QStringList>
+#include <QVariant>
+
+namespace {
+
+const char* CONNECTION_NAME = "test_cue_point_store_connection";
+
+QVariant column(QSqlDatabase& database, const QString& path, const QString& name)
+{
+    QSqlQuery query(database);
+    query.prepare(QString("SELECT %1 FROM musics WHERE path = :path").arg(name));
+    query.bindValue(":path", path);
+    return query.exec() && query.next() ? query.value(0) : QVariant("missing");
+}
+
+} // namespace
+
+void TestCuePointStore::init()
+{
+    m_tempDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_tempDir->isValid());
+
+    m_database = QSqlDatabase::addDatabase("QSQLITE", CONNECTION_NAME);
+    m_database.setDatabaseName(m_tempDir->filePath("test.db"));
+    QVERIFY(m_database.open());
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("CREATE TABLE musics (id INTEGER PRIMARY KEY, path TEXT)"));
+    QVERIFY(query.exec("INSERT INTO musics (path) VALUES ('/music/a.ogg'), ('/music/b.ogg')"));
+}
+
+void TestCuePointStore::cleanup()
+{
+    if (m_database.isOpen()) {
+        m_database.close();
+    }
+    m_database = QSqlDatabase();
+    QSqlDatabase::removeDatabase(CONNECTION_NAME);
+    m_tempDir.reset();
+}
+
+void TestCuePointStore::testAddsColumns()
+{
+    {
+        CuePointStore store(m_database);
+        QVERIFY(store.initialize());
+    }
+    // Opening the upgraded table again leaves it alone
+    CuePointStore store(m_database);
+    QVERIFY(store.initialize());
+
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("PRAGMA table_info(musics)"));
+    QStringList columns;
+    while (query.next()) {
+        columns << query.value(1).toString();
+    }
+    QCOMPARE(columns, QStringList({"id", "path", "cue_in_ms", "cue_out_ms", "intro_ms",
+                                      "fade_ms", "segue_ms"}));
+    QCOMPARE(store.count(), 0);
+    QVERIFY(column(m_database, "/music/a.ogg", "cue_in_ms").isNull());
+
+    QSqlQuery drop(m_database);
+    QVERIFY(drop.exec("DROP TABLE musics"));
+    CuePointStore orphan(m_database);
+    QVERIFY(!orphan.initialize());
+}
+
+void TestCuePointStore::testStoresAndLoads()
+{
+    {
+        CuePointStore store(m_database);
+        QVERIFY(store.initialize());
+        store.setCuePoints("/music/a.ogg", CuePoints{480, 182250});
+        store.setCuePoints("/music/b.ogg", CuePoints{0, 90000});
+        QCOMPARE(store.cuePoints("/music/a.ogg"), (CuePoints{480, 182250}));
+        QVERIFY(!store.cuePoints("/music/other.ogg").isSet());
+        QVERIFY(store.flush());
+    }
+
+    QCOMPARE(column(m_database, "/music/a.ogg", "cue_in_ms").toLongLong(), qint64(480));
+    QCOMPARE(column(m_database, "/music/a.ogg", "cue_out_ms").toLongLong(), qint64(182250));
+    QVERIFY(column(m_database, "/music/b.ogg", "cue_in_ms").isNull());
+
+    CuePointStore store(m_database);
+    QVERIFY(store.initialize());
+    QCOMPARE(store.count(), 2);
+    QCOMPARE(store.cuePoints("/music/a.ogg"), (CuePoints{480, 182250}));
+    QCOMPARE(store.cuePoints("/music/b.ogg"), (CuePoints{0, 90000}));
+}
+
+void TestCuePointStore::testStoresSeguePoints()
+{
+    // A track with no silence to trim still keeps its intro and segue points
+    CuePoints cue;
+    cue.introMs = 1700;
+    cue.fadeMs = 24500;
+    cue.segueMs = 27300;
+    {
+        CuePointStore store(m_database);
+        QVERIFY(store.initialize());
+        store.setCuePoints("/music/a.ogg", cue);
+        QVERIFY(store.flush());
+    }
+
+    QVERIFY(column(m_database, "/music/a.ogg", "cue_in_ms").isNull());
+    QCOMPARE(column(m_database, "/music/a.ogg", "intro_ms").toLongLong(), qint64(1700));
+    QCOMPARE(column(m_database, "/music/a.ogg", "fade_ms").toLongLong(), qint64(24500));
+    QCOMPARE(column(m_database, "/music/a.ogg", "segue_ms").toLongLong(), qint64(27300));
+
+    CuePointStore store(m_database);
+    QVERIFY(store.initialize());
+    QCOMPARE(store.count(), 1);
+    QCOMPARE(store.cuePoints("/music/a.ogg"), cue);
+    QVERIFY(store.cuePoints("/music/a.ogg").hasSegue());
+}
+
+void TestCuePointStore::testClears()
+{
+    CuePointStore store(m_database);
+    QVERIFY(store.initialize());
+    store.setCuePoints("/music/a.ogg", CuePoints{480, 182250});
+    QVERIFY(store.flush());
+
+    store.setCuePoints("/music/a.ogg", CuePoints());
+    QCOMPARE(store.count(), 0);
+    // Written on the next event loop iteration without an explicit flush()
+    QTRY_VERIFY(column(m_database, "/music/a.ogg", "cue_in_ms").isNull());
+    QVERIFY(column(m_database, "/music/a.ogg", "cue_out_ms").isNull());
+}
+
+void TestCuePointStore::testRelocate()
+{
+    CuePointStore store(m_database);
+    QVERIFY(store.initialize());
+    store.setCuePoints("/music/a.mp3", CuePoints{300, -1});
+
+    store.relocate("/music/a.mp3", "/music/a.ogg");
+    QVERIFY(!store.cuePoints("/music/a.mp3").isSet());
+    QCOMPARE(store.cuePoints("/music/a.ogg").inMs, qint64(300));
+
+    // The pending write follows it to the row that now has the path
+    QVERIFY(store.flush());
+    QCOMPARE(column(m_database, "/music/a.ogg", "cue_in_ms").toLongLong(), qint64(300));
+}
+
+QTEST_MAIN(TestCuePointStore)
@@ -0,0 +1,39 @@
+#ifndef TESTCUEPOINTSTORE_H
+#define TESTCUEPOINTSTORE_H
+
+#include <QObject>
+#include <QTest>
+#include <QSqlDatabase>
+#include <QTemporaryDir>
+#include <memory>
+
+/**
+ * @brief Unit tests for CuePointStore class
+ *
+ * Tests the cue points kept in the musics table including:
+ * - Adding the cue columns to an existing musics table
+ * - Writing cue points back and loading them in a new store
+ * - Keeping intro, fade and segue points on tracks with nothing to trim
+ * - Clearing cue points to NULL
+ * - Following a track to its new path
+ */
+class TestCuePointStore : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testAddsColumns();
+    void testStoresAndLoads();
+    void testStoresSeguePoints();
+    void testClears();
+    void testRelocate();
+
+private:
+    std::unique_ptr<QTemporaryDir> m_tempDir;
+    QSqlDatabase m_database;
+};
+
+#endif // TESTCUEPOINTSTORE_H
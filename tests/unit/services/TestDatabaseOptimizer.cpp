@@ -125,6 +125,37 @@ void TestDatabaseOptimizer::testCreateOptimalIndexesWithExistingIndexes()
     QCOMPARE(firstCount, secondCount);
 }
 
+void TestDatabaseOptimizer::testCreateOptimalIndexesOnMusicsTable()
+{
+    QVERIFY(m_optimizer->initialize());
+    
+    // The application's table is "musics", and older libraries may hold duplicate paths
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("CREATE TABLE musics (id INTEGER PRIMARY KEY, artist TEXT, song TEXT, "
+                       "genre1 TEXT, genre2 TEXT, country TEXT, path TEXT, time TEXT, "
+                       "played_times INTEGER DEFAULT 0, last_played TEXT)"));
+    QVERIFY(query.exec("INSERT INTO musics (artist, song, path) VALUES ('A', 'One', '/dup.mp3')"));
+    QVERIFY(query.exec("INSERT INTO musics (artist, song, path) VALUES ('B', 'Two', '/dup.mp3')"));
+    
+    QVERIFY(m_optimizer->createOptimalIndexes());
+    
+    bool foundPathIndex = false;
+    bool foundLastPlayedIndex = false;
+    for (const auto& index : m_optimizer->getIndexInformation()) {
+        if (index.name == "idx_music_path") {
+            foundPathIndex = true;
+            QCOMPARE(index.tableName, QString("musics"));
+            QVERIFY(!index.isUnique);
+        }
+        if (index.name == "idx_music_last_played") {
+            foundLastPlayedIndex = true;
+            QCOMPARE(index.tableName, QString("musics"));
+        }
+    }
+    QVERIFY(foundPathIndex);
+    QVERIFY(foundLastPlayedIndex);
+}
+
 void TestDatabaseOptimizer::testDropUnusedIndexes()
 {
     QVERIFY(m_optimizer->initialize());
@@ -380,6 +411,36 @@ void TestDatabaseOptimizer::testClearQueryStatistics()
     QCOMPARE(stats.size(), 0);
 }
 
+void TestDatabaseOptimizer::testAutomaticQueryTiming()
+{
+    QVERIFY(m_optimizer->initialize());
+    m_optimizer->setAutomaticQueryTiming(true);
+    QVERIFY(m_optimizer->isAutomaticQueryTimingEnabled());
+    
+    // Nothing is recorded until monitoring starts
+    {
+        QueryTimer timer("SELECT * FROM music WHERE id = 1");
+    }
+    QCOMPARE(m_optimizer->getQueryStatistics().size(), 0);
+    
+    m_optimizer->startQueryMonitoring();
+    {
+        QueryTimer timer("SELECT * FROM music WHERE id = 1");
+    }
+    {
+        QueryTimer timer("SELECT * FROM music WHERE id = 2");
+    }
+    
+    // Both executions normalize to the same pattern
+    auto stats = m_optimizer->getQueryStatistics();
+    QCOMPARE(stats.size(), 1);
+    QCOMPARE(stats.first().executionCount, 2);
+    
+    m_optimizer->setAutomaticQueryTiming(false);
+    QVERIFY(!m_optimizer->isAutomaticQueryTimingEnabled());
+    QVERIFY(QueryTimer::sink() == nullptr);
+}
+
 void TestDatabaseOptimizer::testGetPerformanceMetrics()
 {
     QVERIFY(m_optimizer->initialize());
@@ -496,6 +557,36 @@ void TestDatabaseOptimizer::testRecommendationPriority()
     }
 }
 
+void TestDatabaseOptimizer::testIndexRecommendationFromQueryPlan()
+{
+    QVERIFY(m_optimizer->initialize());
+    m_optimizer->startQueryMonitoring();
+    
+    // published_date has no index, so this plan scans the table
+    for (int i = 0; i < 60; ++i) {
+        m_optimizer->recordQueryExecution("SELECT id FROM music WHERE published_date = '2020' ORDER BY artist", 2);
+    }
+    
+    DatabaseOptimizer::OptimizationRecommendation indexRec;
+    bool found = false;
+    for (const auto& rec : m_optimizer->getOptimizationRecommendations()) {
+        if (rec.type == DatabaseOptimizer::OptimizationRecommendation::CreateIndex) {
+            indexRec = rec;
+            found = true;
+            break;
+        }
+    }
+    QVERIFY(found);
+    QVERIFY(indexRec.sqlCommand.contains("published_date"));
+    
+    QVERIFY(m_optimizer->applyRecommendation(indexRec));
+    
+    // Once the index exists the plan no longer scans and nothing is recommended
+    for (const auto& rec : m_optimizer->getOptimizationRecommendations()) {
+        QVERIFY(rec.type != DatabaseOptimizer::OptimizationRecommendation::CreateIndex);
+    }
+}
+
 void TestDatabaseOptimizer::testAutoOptimizationEnabled()
 {
     QVERIFY(m_optimizer->initialize());
@@ -31,6 +31,7 @@ private slots:
     // Index management tests
     void testCreateOptimalIndexes();
     void testCreateOptimalIndexesWithExistingIndexes();
+    void testCreateOptimalIndexesOnMusicsTable();
     void testDropUnusedIndexes();
     void testIndexExists();
     void testCreateSingleIndex();
@@ -47,6 +48,7 @@ private slots:
     void testSlowQueryDetection();
     void testQueryStatistics();
     void testClearQueryStatistics();
+    void testAutomaticQueryTiming();
 
     // Performance metrics tests
     void testGetPerformanceMetrics();
@@ -57,6 +59,7 @@ private slots:
     void testGetOptimizationRecommendations();
     void testApplyRecommendation();
     void testRecommendationPriority();
+    void testIndexRecommendationFromQueryPlan();
 
     // Auto optimization tests
     void testAutoOptimizationEnabled();
@@ -0,0 +1,160 @@
+#include "TestDayLogGenerator.h"
+#include "../../../src/services/DayLogGenerator.h"
+#include <QElapsedTimer>
+#include <utility>
+
+namespace {
+
+const qint64 MINUTE_US = qint64(60) * 1000000;
+
+QVector<DayLogGenerator::Track> library(int songs, int artists, const QStringList& genres,
+                                        qint64 durationUs = 4 * MINUTE_US)
+{
+    QVector<DayLogGenerator::Track> tracks;
+    for (int i = 0; i < songs; ++i) {
+        DayLogGenerator::Track track;
+        track.id = i + 1;
+        track.path = QString("/music/%1.ogg").arg(i);
+        track.artist = QString("Artist %1").arg(i % artists);
+        track.title = QString("Song %1").arg(i);
+        track.genre = genres.at(i % genres.size());
+        track.durationUs = durationUs;
+        tracks.append(track);
+    }
+    return tracks;
+}
+
+} // namespace
+
+void TestDayLogGenerator::testFullDayKeepsSeparation()
+{
+    DayLogGenerator generator;
+    generator.setSeed(7);
+    generator.setLibrary(library(20000, 2000, {"Rock", "Pop"}, -1));
+
+    const QDateTime from(QDate(2026, 3, 2), QTime(6, 0));
+    const QDateTime to = from.addDays(1);
+    QElapsedTimer timer;
+    timer.start();
+    const QVector<DayLogGenerator::Item> log = generator.generate(from, to);
+    QVERIFY2(timer.elapsed() < 1000, qPrintable(QString::number(timer.elapsed())));
+
+    // Unknown durations count as the default length
+    const qint64 defaultMs = DayLogGenerator::DEFAULT_DURATION_US / 1000;
+    QCOMPARE(qint64(log.size()), (to.toMSecsSinceEpoch() - from.toMSecsSinceEpoch()) / defaultMs
+                                     + 1);
+    QCOMPARE(log.first().startsAt, from);
+    QVERIFY(log.last().startsAt < to);
+    QCOMPARE(generator.relaxedPicks(), 0);
+
+    QHash<int, QDateTime> artistAired;
+    for (const DayLogGenerator::Item& item : log) {
+        QCOMPARE(item.kind, DayLogGenerator::Kind::Song);
+        const int artist = (item.musicId - 1) % 2000;
+        const auto last = artistAired.constFind(artist);
+        if (last != artistAired.cend()) {
+            QVERIFY(last->secsTo(item.startsAt) >= 60 * 60);
+        }
+        artistAired.insert(artist, item.startsAt);
+    }
+}
+
+void TestDayLogGenerator::testFollowsHourClocks()
+{
+    QVector<DayLogGenerator::Track> jingles(2);
+    jingles[0].path = "/jingles/a.wav";
+    jingles[0].durationUs = 10 * 1000000;
+    jingles[1].path = "/jingles/b.wav";
+    jingles[1].durationUs = 10 * 1000000;
+
+    DayLogGenerator generator;
+    generator.setSeed(1);
+    generator.setLibrary(library(300, 100, {"Rock", "Jazz", "Folk"}));
+    generator.setJingles(jingles);
+
+    const QDateTime from(QDate(2026, 3, 2), QTime(10, 0));
+    const QVector<DayLogGenerator::Item> log =
+        generator.generate(from, from.addSecs(4 * 3600), [](const QDateTime& hourStart) {
+            const bool even = hourStart.time().hour() % 2 == 0;
+            return DayLogGenerator::HourClock{even ? "rock" : "Jazz", even ? 3 : 0};
+        });
+
+    int songsInRow = 0;
+    int lastHour = from.time().hour();
+    QString lastJingle;
+    for (const DayLogGenerator::Item& item : log) {
+        const int hour = item.startsAt.time().hour();
+        const bool even = hour % 2 == 0;
+        const bool hourChanged = std::exchange(lastHour, hour) != hour;
+        if (item.kind == DayLogGenerator::Kind::Jingle) {
+            QVERIFY(even);
+            // An hour with jingles opens with one after an hour without
+            QVERIFY(songsInRow == 3 || (hourChanged && songsInRow > 3));
+            QVERIFY(item.path != lastJingle);
+            lastJingle = item.path;
+            songsInRow = 0;
+            continue;
+        }
+        // Rock is every third track of the library, starting with the first
+        const int index = item.musicId - 1;
+        QCOMPARE(index % 3, even ? 0 : 1);
+        ++songsInRow;
+        if (even) {
+            QVERIFY(songsInRow <= 3);
+        }
+    }
+}
+
+void TestDayLogGenerator::testPlacesBreaks()
+{
+    DayLogGenerator generator;
+    generator.setLibrary(library(50, 50, {"Rock"}));
+
+    const QDateTime from(QDate(2026, 3, 2), QTime(12, 0));
+    QVector<DayLogGenerator::Break> breaks(2);
+    // Nearer the start of the song at 8 minutes than of the one at 12
+    breaks[0].at = from.addSecs(9 * 60);
+    breaks[0].path = "/pub/spot.mp3";
+    breaks[0].durationUs = MINUTE_US;
+    breaks[1].at = from.addSecs(-60);
+    breaks[1].path = "/programs/past.mp3";
+    breaks[1].isProgram = true;
+
+    const QVector<DayLogGenerator::Item> log =
+        generator.generate(from, from.addSecs(20 * 60), {}, breaks);
+
+    QCOMPARE(log.size(), 6);
+    QCOMPARE(log[2].kind, DayLogGenerator::Kind::Pub);
+    QCOMPARE(log[2].path, QString("/pub/spot.mp3"));
+    QCOMPARE(log[2].startsAt, from.addSecs(8 * 60));
+    QCOMPARE(log[3].startsAt, from.addSecs(9 * 60));
+    for (const DayLogGenerator::Item& item : log) {
+        QVERIFY(item.kind != DayLogGenerator::Kind::Program);
+    }
+}
+
+void TestDayLogGenerator::testRelaxesSmallGenres()
+{
+    DayLogGenerator generator;
+    generator.setLibrary(library(3, 1, {"Blues"}));
+
+    const QDateTime from(QDate(2026, 3, 2), QTime(0, 0));
+    const QVector<DayLogGenerator::Item> log = generator.generate(from, from.addSecs(3600));
+    QCOMPARE(log.size(), 15);
+    QCOMPARE(generator.relaxedPicks(), 14);
+    // Each pick takes the song that aired longest ago
+    for (int i = 3; i < log.size(); ++i) {
+        QCOMPARE(log[i].path, log[i - 3].path);
+    }
+}
+
+void TestDayLogGenerator::testParseDuration()
+{
+    QCOMPARE(DayLogGenerator::parseDuration("0:03:45"), qint64(225) * 1000000);
+    QCOMPARE(DayLogGenerator::parseDuration("1:00:00"), qint64(3600) * 1000000);
+    QCOMPARE(DayLogGenerator::parseDuration("04:05"), qint64(245) * 1000000);
+    QCOMPARE(DayLogGenerator::parseDuration(""), qint64(-1));
+    QCOMPARE(DayLogGenerator::parseDuration("3:xx"), qint64(-1));
+}
+
+QTEST_MAIN(TestDayLogGenerator)
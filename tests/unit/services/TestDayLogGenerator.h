@@ -0,0 +1,28 @@
+#ifndef TESTDAYLOGGENERATOR_H
+#define TESTDAYLOGGENERATOR_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for DayLogGenerator class
+ *
+ * Tests planning a day including:
+ * - A full day without artist or title repeats inside their separation
+ * - Genres and jingles following the hour clocks
+ * - Breaks going in at the boundary nearest their time
+ * - Genres too small for the rules, and durations read from the musics table
+ */
+class TestDayLogGenerator : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testFullDayKeepsSeparation();
+    void testFollowsHourClocks();
+    void testPlacesBreaks();
+    void testRelaxesSmallGenres();
+    void testParseDuration();
+};
+
+#endif // TESTDAYLOGGENERATOR_H
@@ -0,0 +1,126 @@
+#include "TestDeadAirDetector.h"
+#include "../../../src/services/DeadAirDetector.h"
+#include <QSignalSpy>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+using Source = DeadAirDetector::Source;
+
+// 1 kHz stereo keeps the frame counts readable: 1000 frames are one second
+constexpr int RATE = 1000;
+
+// One second of a square wave at the given level in dBFS
+std::vector<float> second(double db)
+{
+    const float level = db <= -200.0 ? 0.0f : float(std::pow(10.0, db / 20.0));
+    std::vector<float> samples(RATE * 2);
+    for (size_t i = 0; i < samples.size(); ++i) {
+        samples[i] = (i / 2) % 2 ? level : -level;
+    }
+    return samples;
+}
+
+} // namespace
+
+void TestDeadAirDetector::testThreshold()
+{
+    DeadAirDetector detector;
+    detector.setFormat(Source::Output, RATE, 2);
+    detector.setArmed(Source::Output, true);
+
+    const std::vector<float> quiet = second(-60.0);
+    detector.process(Source::Output, quiet.data(), int(quiet.size()));
+    QCOMPARE(detector.silentMs(Source::Output), qint64(1000));
+
+    // A quiet passage above the threshold is not silence
+    const std::vector<float> soft = second(-40.0);
+    detector.process(Source::Output, soft.data(), int(soft.size()));
+    QCOMPARE(detector.silentMs(Source::Output), qint64(0));
+
+    detector.setThresholdDb(-30.0);
+    detector.process(Source::Output, soft.data(), int(soft.size()));
+    QCOMPARE(detector.silentMs(Source::Output), qint64(1000));
+    QCOMPARE(detector.silentMs(Source::Input), qint64(0));
+}
+
+void TestDeadAirDetector::testAlarmAndRecovery()
+{
+    DeadAirDetector detector;
+    detector.setSilenceSeconds(2);
+    detector.setFormat(Source::Input, RATE, 2);
+    detector.setArmed(Source::Input, true);
+    QSignalSpy deadAir(&detector, &DeadAirDetector::deadAir);
+    QSignalSpy recovered(&detector, &DeadAirDetector::recovered);
+
+    const std::vector<float> silence = second(-300.0);
+    detector.process(Source::Input, silence.data(), int(silence.size()));
+    detector.check();
+    QCOMPARE(deadAir.size(), 0);
+
+    detector.process(Source::Input, silence.data(), int(silence.size()));
+    detector.check();
+    QCOMPARE(deadAir.size(), 1);
+    QCOMPARE(deadAir.first().at(0).value<DeadAirDetector::Source>(), Source::Input);
+    QCOMPARE(deadAir.first().at(1).toLongLong(), qint64(2000));
+    QVERIFY(detector.isDeadAir(Source::Input));
+
+    // Raised once, however long it lasts
+    detector.process(Source::Input, silence.data(), int(silence.size()));
+    detector.check();
+    QCOMPARE(deadAir.size(), 1);
+
+    const std::vector<float> music = second(-10.0);
+    detector.process(Source::Input, music.data(), int(music.size()));
+    detector.check();
+    QCOMPARE(recovered.size(), 1);
+    QCOMPARE(recovered.first().at(1).toLongLong(), qint64(3000));
+    QVERIFY(!detector.isDeadAir(Source::Input));
+}
+
+void TestDeadAirDetector::testArming()
+{
+    DeadAirDetector detector;
+    detector.setSilenceSeconds(1);
+    detector.setFormat(Source::Output, RATE, 2);
+    QSignalSpy deadAir(&detector, &DeadAirDetector::deadAir);
+
+    // A stopped player is silent on purpose
+    const std::vector<float> silence = second(-300.0);
+    detector.process(Source::Output, silence.data(), int(silence.size()));
+    detector.check();
+    QCOMPARE(detector.silentMs(Source::Output), qint64(0));
+    QCOMPARE(deadAir.size(), 0);
+
+    detector.setArmed(Source::Output, true);
+    detector.process(Source::Output, silence.data(), int(silence.size()));
+    detector.check();
+    QCOMPARE(deadAir.size(), 1);
+
+    detector.setArmed(Source::Output, false);
+    QVERIFY(!detector.isDeadAir(Source::Output));
+    detector.setArmed(Source::Output, true);
+    QCOMPARE(detector.silentMs(Source::Output), qint64(0));
+}
+
+void TestDeadAirDetector::testStalledSource()
+{
+    DeadAirDetector detector;
+    detector.setSilenceSeconds(1);
+    detector.setFormat(Source::Output, RATE, 2);
+    QSignalSpy deadAir(&detector, &DeadAirDetector::deadAir);
+
+    // Armed, but the sink stopped pulling: no block arrives at all
+    detector.setArmed(Source::Output, true);
+    QTRY_COMPARE_WITH_TIMEOUT(deadAir.size(), 1, 3000);
+    QVERIFY(detector.silentMs(Source::Output) >= 1000);
+
+    QSignalSpy recovered(&detector, &DeadAirDetector::recovered);
+    const std::vector<float> music = second(-10.0);
+    detector.process(Source::Output, music.data(), int(music.size()));
+    detector.check();
+    QCOMPARE(recovered.size(), 1);
+}
+
+QTEST_MAIN(TestDeadAirDetector)
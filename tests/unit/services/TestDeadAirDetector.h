@@ -0,0 +1,27 @@
+#ifndef TESTDEADAIRDETECTOR_H
+#define TESTDEADAIRDETECTOR_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for DeadAirDetector class
+ *
+ * Tests the dead-air alarm on the output and live input including:
+ * - Blocks below and above the RMS threshold
+ * - Raising the alarm once and reporting the recovery
+ * - Disarmed sources being ignored, and arming starting the count over
+ * - A source that stops delivering audio counting as silent
+ */
+class TestDeadAirDetector : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testThreshold();
+    void testAlarmAndRecovery();
+    void testArming();
+    void testStalledSource();
+};
+
+#endif // TESTDEADAIRDETECTOR_H
@@ -0,0 +1,67 @@
+#include "TestDeviceHotplugWatcher.h"
+#include "../../../src/services/DeviceHotplugWatcher.h"
+#include <QDir>
+#include <QFile>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+
+namespace {
+
+void touch(const QString& path)
+{
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+}
+
+const QStringList FILTERS = {QStringLiteral("ttyUSB*"), QStringLiteral("hidraw*")};
+
+} // namespace
+
+void TestDeviceHotplugWatcher::testListsExistingDevices()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    touch(dir.filePath("ttyUSB1"));
+    touch(dir.filePath("ttyUSB0"));
+
+    DeviceHotplugWatcher watcher({dir.path()}, FILTERS);
+    QCOMPARE(watcher.devices(), (QStringList{dir.filePath("ttyUSB0"), dir.filePath("ttyUSB1")}));
+}
+
+void TestDeviceHotplugWatcher::testReportsAddedAndRemoved()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    touch(dir.filePath("hidraw0"));
+
+    DeviceHotplugWatcher watcher({dir.path()}, FILTERS);
+    QSignalSpy added(&watcher, &DeviceHotplugWatcher::deviceAdded);
+    QSignalSpy removed(&watcher, &DeviceHotplugWatcher::deviceRemoved);
+    QSignalSpy changed(&watcher, &DeviceHotplugWatcher::devicesChanged);
+
+    touch(dir.filePath("ttyUSB0"));
+    QVERIFY(QFile::remove(dir.filePath("hidraw0")));
+
+    QTRY_COMPARE_WITH_TIMEOUT(changed.count(), 1, 5000);
+    QCOMPARE(added.count(), 1);
+    QCOMPARE(added.at(0).at(0).toString(), dir.filePath("ttyUSB0"));
+    QCOMPARE(removed.count(), 1);
+    QCOMPARE(removed.at(0).at(0).toString(), dir.filePath("hidraw0"));
+    QCOMPARE(watcher.devices(), QStringList{dir.filePath("ttyUSB0")});
+}
+
+void TestDeviceHotplugWatcher::testIgnoresOtherNames()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    DeviceHotplugWatcher watcher({dir.path()}, FILTERS);
+    QSignalSpy changed(&watcher, &DeviceHotplugWatcher::devicesChanged);
+
+    touch(dir.filePath("sda1"));
+    QTest::qWait(DeviceHotplugWatcher::SETTLE_MS * 3);
+    QCOMPARE(changed.count(), 0);
+    QVERIFY(watcher.devices().isEmpty());
+}
+
+QTEST_MAIN(TestDeviceHotplugWatcher)
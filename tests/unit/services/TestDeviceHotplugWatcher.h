@@ -0,0 +1,25 @@
+#ifndef TESTDEVICEHOTPLUGWATCHER_H
+#define TESTDEVICEHOTPLUGWATCHER_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for DeviceHotplugWatcher class
+ *
+ * Tests the device node watch including:
+ * - Nodes present at construction listed without signals
+ * - Added and removed nodes reported once the change settles
+ * - Names outside the filters ignored
+ */
+class TestDeviceHotplugWatcher : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testListsExistingDevices();
+    void testReportsAddedAndRemoved();
+    void testIgnoresOtherNames();
+};
+
+#endif // TESTDEVICEHOTPLUGWATCHER_H
@@ -0,0 +1,263 @@
+#include "TestDownloadQueue.h"
+#include "../../../src/services/DownloadQueue.h"
+#include <QDir>
+#include <QFile>
+#include <QSignalSpy>
+#include <QSqlError>
+#include <QSqlQuery>
+
+namespace {
+
+const char* CONNECTION_NAME = "test_download_queue_connection";
+
+// Stands in for yt-dlp: writes the -o file with the link's v= value as its
+// id and prints the info line. Links with "fail" always fail, links with
+// "flaky" fail the first time, and FAKE_YTDLP_DELAY makes it slow
+const char* FAKE_YTDLP = "#!/bin/sh\n"
+                         "while [ $# -gt 0 ]; do\n"
+                         "  case \"$1\" in\n"
+                         "    -o) template=\"$2\"; shift;;\n"
+                         "    --) url=\"$2\"; shift;;\n"
+                         "  esac\n"
+                         "  shift\n"
+                         "done\n"
+                         "id=\"${url##*=}\"\n"
+                         "dir=$(dirname \"$template\")\n"
+                         "echo x >> \"$dir/.$id.attempts\"\n"
+                         "case \"$url\" in *fail*)\n"
+                         "  echo \"ERROR: Video unavailable\"; exit 1;;\n"
+                         "esac\n"
+                         "case \"$url\" in *flaky*)\n"
+                         "  if [ $(wc -l < \"$dir/.$id.attempts\") -lt 2 ]; then\n"
+                         "    echo \"ERROR: Read timed out\"; exit 1\n"
+                         "  fi;;\n"
+                         "esac\n"
+                         "sleep \"${FAKE_YTDLP_DELAY:-0}\"\n"
+                         "out=$(printf '%s' \"$template\" | sed -e 's/%(ext)s/m4a/' "
+                         "-e \"s/%(id)s/$id/\" -e 's/%([^)]*)s/x/g')\n"
+                         "printf 'fake audio' > \"$out\"\n"
+                         "printf 'XFB-INFO\\t%s\\t\\tSome Channel\\t\\t%s\\n' \"$out\" "
+                         "\"Band - Tune $id\"\n";
+
+} // namespace
+
+void TestDownloadQueue::init()
+{
+    m_tempDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_tempDir->isValid());
+    m_musicDir = m_tempDir->filePath("music");
+
+    m_database = QSqlDatabase::addDatabase("QSQLITE", CONNECTION_NAME);
+    m_database.setDatabaseName(m_tempDir->filePath("test.db"));
+    QVERIFY(m_database.open());
+    QSqlQuery query(m_database);
+    QVERIFY2(query.exec("CREATE TABLE musics (id INTEGER PRIMARY KEY AUTOINCREMENT, "
+                        "artist VARCHAR(50) NOT NULL, song VARCHAR(25) NOT NULL, "
+                        "genre1 VARCHAR(25) NOT NULL, genre2 VARCHAR(25), country VARCHAR(25), "
+                        "published_date VARCHAR(25), path TEXT, time TEXT, "
+                        "played_times INTEGER DEFAULT 0, last_played TEXT)"),
+             qPrintable(query.lastError().text()));
+
+    m_fakeYtdlp = m_tempDir->filePath("fake-yt-dlp");
+    QFile script(m_fakeYtdlp);
+    QVERIFY(script.open(QIODevice::WriteOnly));
+    script.write(FAKE_YTDLP);
+    script.close();
+    script.setPermissions(QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner);
+    qunsetenv("FAKE_YTDLP_DELAY");
+}
+
+void TestDownloadQueue::cleanup()
+{
+    if (m_database.isOpen()) {
+        m_database.close();
+    }
+    m_database = QSqlDatabase();
+    QSqlDatabase::removeDatabase(CONNECTION_NAME);
+    m_tempDir.reset();
+}
+
+void TestDownloadQueue::testSplitUrls()
+{
+    const QString pasted = "https://a.example/watch?v=1&list=PL2\n"
+                           "  https://b.example/x\ta title https://a.example/watch?v=1&t=30\n"
+                           "www.c.example/y\n";
+    QCOMPARE(DownloadQueue::splitUrls(pasted),
+             QStringList({"https://a.example/watch?v=1", "https://b.example/x",
+                          "www.c.example/y"}));
+    QVERIFY(DownloadQueue::splitUrls(" \n\t").isEmpty());
+
+    DownloadQueue::Request details;
+    details.genre1 = "Pop";
+    const QList<DownloadQueue::Request> requests =
+        DownloadQueue::requestsFor({"https://b.example/x", "https://b.example/y"}, details);
+    QCOMPARE(requests.size(), 2);
+    QCOMPARE(requests.at(1).url, QString("https://b.example/y"));
+    QCOMPARE(requests.at(1).genre1, QString("Pop"));
+}
+
+void TestDownloadQueue::testDownloadsAndAdds()
+{
+    MusicRepository repository(m_database);
+    DownloadQueue queue(&repository);
+    configure(queue);
+    QSignalSpy finished(&queue, &DownloadQueue::finished);
+    QSignalSpy added(&queue, &DownloadQueue::tracksAdded);
+
+    DownloadQueue::Request named;
+    named.url = "https://video.example/watch?v=one";
+    named.artist = "Named Artist";
+    named.song = "Named Song";
+    named.genre1 = "Pop";
+    DownloadQueue::Request untitled = named;
+    untitled.url = "https://video.example/watch?v=two";
+    untitled.artist.clear();
+    untitled.song.clear();
+
+    QCOMPARE(queue.enqueue({named, untitled}), 2);
+    // A link is only queued once
+    QCOMPARE(queue.enqueue({named}), 0);
+    QVERIFY(queue.isRunning());
+    QVERIFY(finished.wait(5000));
+
+    QCOMPARE(finished.at(0).at(0).toInt(), 2);
+    QCOMPARE(finished.at(0).at(1).toInt(), 0);
+    // Both tracks went in with one addMusicBatch()
+    QCOMPARE(added.count(), 1);
+    QCOMPARE(added.at(0).at(0).toInt(), 2);
+    QVERIFY(!queue.isRunning());
+
+    const QDir dir(m_musicDir);
+    const QString namedPath = dir.filePath("Named Artist - Named Song.m4a");
+    QVERIFY(QFile::exists(namedPath));
+    QCOMPARE(column(namedPath, "artist").toString(), QString("Named Artist"));
+    QCOMPARE(column(namedPath, "genre1").toString(), QString("Pop"));
+    QCOMPARE(column(namedPath, "time").toString(), QString("-"));
+
+    // The title of an untagged video is split into artist and song
+    const QString untitledPath = dir.filePath("x - x [two].m4a");
+    QCOMPARE(column(untitledPath, "artist").toString(), QString("Band"));
+    QCOMPARE(column(untitledPath, "song").toString(), QString("Tune two"));
+}
+
+void TestDownloadQueue::testRetries()
+{
+    MusicRepository repository(m_database);
+    DownloadQueue queue(&repository);
+    configure(queue);
+    queue.setMaxAttempts(2);
+    queue.setRetryDelay(10);
+    QSignalSpy finished(&queue, &DownloadQueue::finished);
+    QSignalSpy jobs(&queue, &DownloadQueue::jobFinished);
+
+    DownloadQueue::Request details;
+    details.genre1 = "Pop";
+    queue.enqueue(DownloadQueue::requestsFor(
+        {"https://video.example/watch?v=flaky", "https://video.example/watch?v=fail"}, details));
+    QVERIFY(finished.wait(5000));
+
+    QCOMPARE(finished.at(0).at(0).toInt(), 1);
+    QCOMPARE(finished.at(0).at(1).toInt(), 1);
+    QCOMPARE(attempts("flaky"), 2);
+    QCOMPARE(attempts("fail"), 2);
+
+    // Each link failed once with a retry to come; then one made it and one was given up on
+    QCOMPARE(jobs.count(), 4);
+    int retries = 0;
+    int givenUp = 0;
+    for (const QList<QVariant>& job : jobs) {
+        retries += job.at(4).toBool() ? 1 : 0;
+        if (!job.at(2).toBool() && !job.at(4).toBool()) {
+            ++givenUp;
+            QCOMPARE(job.at(0).toString(), QString("https://video.example/watch?v=fail"));
+            QVERIFY(job.at(3).toString().contains("Video unavailable"));
+        }
+    }
+    QCOMPARE(retries, 2);
+    QCOMPARE(givenUp, 1);
+}
+
+void TestDownloadQueue::testWorkerLimit()
+{
+    qputenv("FAKE_YTDLP_DELAY", "0.2");
+    QStringList urls;
+    for (int i = 0; i < 6; ++i) {
+        urls << QString("https://video.example/watch?v=track%1").arg(i);
+    }
+
+    MusicRepository repository(m_database);
+    DownloadQueue queue(&repository);
+    configure(queue);
+    queue.setMaxWorkers(2);
+    QSignalSpy finished(&queue, &DownloadQueue::finished);
+
+    int mostRunning = 0;
+    connect(&queue, &DownloadQueue::progressChanged, this,
+            [&](const DownloadQueue::Progress& progress) {
+                mostRunning = qMax(mostRunning, progress.running);
+            });
+
+    DownloadQueue::Request details;
+    details.genre1 = "Pop";
+    queue.enqueue(DownloadQueue::requestsFor(urls, details));
+    QCOMPARE(queue.progress().running, 2);
+    QCOMPARE(queue.pendingCount(), 6);
+    QVERIFY(finished.wait(10000));
+
+    QCOMPARE(mostRunning, 2);
+    QCOMPARE(finished.at(0).at(0).toInt(), 6);
+}
+
+void TestDownloadQueue::testCancel()
+{
+    qputenv("FAKE_YTDLP_DELAY", "5");
+    MusicRepository repository(m_database);
+    DownloadQueue queue(&repository);
+    configure(queue);
+    queue.setMaxWorkers(1);
+    QSignalSpy finished(&queue, &DownloadQueue::finished);
+    QSignalSpy added(&queue, &DownloadQueue::tracksAdded);
+
+    DownloadQueue::Request details;
+    details.genre1 = "Pop";
+    queue.enqueue(DownloadQueue::requestsFor(
+        {"https://video.example/watch?v=a", "https://video.example/watch?v=b"}, details));
+    QCOMPARE(queue.progress().running, 1);
+
+    queue.cancel();
+    QCOMPARE(finished.count(), 1);
+    QCOMPARE(finished.at(0).at(0).toInt(), 0);
+    QVERIFY(!queue.isRunning());
+    QCOMPARE(queue.pendingCount(), 0);
+    QCOMPARE(added.count(), 0);
+
+    // The same links can be queued again
+    qunsetenv("FAKE_YTDLP_DELAY");
+    QCOMPARE(queue.enqueue(DownloadQueue::requestsFor({"https://video.example/watch?v=a"},
+                                                      details)),
+             1);
+    QVERIFY(finished.wait(5000));
+    QCOMPARE(finished.at(1).at(0).toInt(), 1);
+}
+
+void TestDownloadQueue::configure(DownloadQueue& queue)
+{
+    queue.setProgram(m_fakeYtdlp);
+    queue.setOutputDirectory(m_musicDir);
+}
+
+int TestDownloadQueue::attempts(const QString& id) const
+{
+    QFile file(QDir(m_musicDir).filePath("." + id + ".attempts"));
+    return file.open(QIODevice::ReadOnly) ? file.readAll().count('\n') : 0;
+}
+
+QVariant TestDownloadQueue::column(const QString& path, const QString& name)
+{
+    QSqlQuery query(m_database);
+    query.prepare(QString("SELECT %1 FROM musics WHERE path = :path").arg(name));
+    query.bindValue(":path", path);
+    return query.exec() && query.next() ? query.value(0) : QVariant("missing");
+}
+
+QTEST_MAIN(TestDownloadQueue)
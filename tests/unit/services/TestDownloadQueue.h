@@ -0,0 +1,47 @@
+#ifndef TESTDOWNLOADQUEUE_H
+#define TESTDOWNLOADQUEUE_H
+
+#include <QObject>
+#include <QTest>
+#include <QSqlDatabase>
+#include <QTemporaryDir>
+#include <memory>
+
+class DownloadQueue;
+
+/**
+ * @brief Unit tests for DownloadQueue class
+ *
+ * Tests the background yt-dlp downloads including:
+ * - Picking the links out of pasted text
+ * - Naming tracks from the request or the video's metadata and adding them in one batch
+ * - Trying failed downloads again and giving up after the last attempt
+ * - Bounding the number of workers
+ * - Cancelling a running queue
+ */
+class TestDownloadQueue : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testSplitUrls();
+    void testDownloadsAndAdds();
+    void testRetries();
+    void testWorkerLimit();
+    void testCancel();
+
+private:
+    void configure(DownloadQueue& queue);
+    int attempts(const QString& id) const;
+    QVariant column(const QString& path, const QString& name);
+
+    std::unique_ptr<QTemporaryDir> m_tempDir;
+    QSqlDatabase m_database;
+    QString m_fakeYtdlp;
+    QString m_musicDir;
+};
+
+#endif // TESTDOWNLOADQUEUE_H
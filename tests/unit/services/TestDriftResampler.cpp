@@ -0,0 +1,99 @@
+#include "TestDriftResampler.h"
+#include "../../../src/services/DriftResampler.h"
+#include <cmath>
+#include <vector>
+
+namespace {
+
+// Stereo ramp, the right channel the negative of the left
+std::vector<float> ramp(int frames, int from = 0)
+{
+    std::vector<float> samples;
+    for (int i = 0; i < frames; ++i) {
+        samples.push_back(float(from + i));
+        samples.push_back(-float(from + i));
+    }
+    return samples;
+}
+
+} // namespace
+
+void TestDriftResampler::testPassesThrough()
+{
+    DriftResampler resampler(2);
+    std::vector<float> input = ramp(100);
+    resampler.push(input.data(), 100);
+
+    // The last frame is held back to interpolate with the next one
+    std::vector<float> output(200);
+    QCOMPARE(resampler.pull(output.data(), 100), 99);
+    for (int i = 0; i < 99; ++i) {
+        QCOMPARE(output[size_t(i) * 2], float(i));
+        QCOMPARE(output[size_t(i) * 2 + 1], -float(i));
+    }
+    QCOMPARE(resampler.queued(), 1);
+
+    input = ramp(10, 100);
+    resampler.push(input.data(), 10);
+    QCOMPARE(resampler.pull(output.data(), 10), 10);
+    QCOMPARE(output[0], 99.0f);
+    QCOMPARE(output[18], 108.0f);
+}
+
+void TestDriftResampler::testSteersDrift()
+{
+    DriftResampler resampler(2);
+    // A buffer too full is played faster, but never noticeably so
+    for (int i = 0; i < 500; ++i) {
+        resampler.update(10, 2);
+    }
+    QCOMPARE(resampler.drift(), DriftResampler::MAX_DRIFT);
+
+    const int frames = 20000;
+    std::vector<float> input = ramp(frames);
+    std::vector<float> output(size_t(frames) * 2);
+    resampler.push(input.data(), frames);
+    const int written = resampler.pull(output.data(), frames);
+    QVERIFY(std::abs(written - frames / (1.0 + DriftResampler::MAX_DRIFT)) < 2);
+    // Still a ramp, a little steeper
+    QVERIFY(std::abs(output[2000] - 1000 * (1.0 + DriftResampler::MAX_DRIFT)) < 0.01);
+
+    for (int i = 0; i < 500; ++i) {
+        resampler.update(0, 10);
+    }
+    QCOMPARE(resampler.drift(), -DriftResampler::MAX_DRIFT);
+    for (int i = 0; i < 1000; ++i) {
+        resampler.update(2, 2);
+    }
+    QVERIFY(std::abs(resampler.drift()) < 0.0001);
+
+    resampler.reset();
+    QCOMPARE(resampler.drift(), 0.0);
+    QCOMPARE(resampler.queued(), 0);
+}
+
+void TestDriftResampler::testConvertsRates()
+{
+    DriftResampler resampler(2);
+    resampler.setRates(44100, 48000);
+    std::vector<float> input(4410 * 2);
+    for (int i = 0; i < 4410; ++i) {
+        input[size_t(i) * 2] = float(std::sin(2 * M_PI * 480 * i / 44100.0));
+        input[size_t(i) * 2 + 1] = input[size_t(i) * 2];
+    }
+    resampler.push(input.data(), 4410);
+
+    std::vector<float> output(6000 * 2);
+    const int written = resampler.pull(output.data(), 6000);
+    QVERIFY(std::abs(written - 4800) <= 2);
+    // A period of 480 Hz is 100 samples at 48 kHz
+    for (int i = 0; i < 100; ++i) {
+        QVERIFY(std::abs(output[size_t(i) * 2] - output[size_t(i + 100) * 2]) < 0.01f);
+    }
+
+    resampler.reset();
+    resampler.push(input.data(), 441);
+    QVERIFY(std::abs(resampler.pull(output.data(), 6000) - 480) <= 2);
+}
+
+QTEST_MAIN(TestDriftResampler)
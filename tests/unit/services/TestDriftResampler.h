@@ -0,0 +1,25 @@
+#ifndef TESTDRIFTRESAMPLER_H
+#define TESTDRIFTRESAMPLER_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for DriftResampler class
+ *
+ * Tests the resampler including:
+ * - The audio passing through unchanged without drift
+ * - Drift steered by the buffer depth, within its limit
+ * - Converting between two sample rates
+ */
+class TestDriftResampler : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testPassesThrough();
+    void testSteersDrift();
+    void testConvertsRates();
+};
+
+#endif // TESTDRIFTRESAMPLER_H
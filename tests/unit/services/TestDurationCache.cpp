@@ -0,0 +1,181 @@
+#include "TestDurationCache.h"
+#include "../../../src/services/DurationCache.h"
+#include <QFile>
+#include <QSqlQuery>
+#include <QtEndian>
+
+namespace {
+
+const char* CONNECTION_NAME = "test_duration_cache_connection";
+
+void appendLE16(QByteArray& data, quint16 value)
+{
+    char buf[2];
+    qToLittleEndian(value, buf);
+    data.append(buf, 2);
+}
+
+void appendLE32(QByteArray& data, quint32 value)
+{
+    char buf[4];
+    qToLittleEndian(value, buf);
+    data.append(buf, 4);
+}
+
+} // namespace
+
+void TestDurationCache::init()
+{
+    m_tempDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_tempDir->isValid());
+    openDatabase();
+}
+
+void TestDurationCache::cleanup()
+{
+    if (m_database.isOpen()) {
+        m_database.close();
+    }
+    m_database = QSqlDatabase();
+    QSqlDatabase::removeDatabase(CONNECTION_NAME);
+    m_tempDir.reset();
+}
+
+void TestDurationCache::testProbeAndHit()
+{
+    QString path = writeWav("one.wav", 2);
+
+    DurationCache cache(m_database);
+    QVERIFY(cache.initialize());
+
+    QCOMPARE(cache.durationUs(path), qint64(2000000));
+    QCOMPARE(cache.durationUs(path), qint64(2000000));
+
+    DurationCache::Statistics stats = cache.statistics();
+    QCOMPARE(stats.misses, 1);
+    QCOMPARE(stats.hits, 1);
+    QCOMPARE(stats.entries, 1);
+}
+
+void TestDurationCache::testChangedFileIsReprobed()
+{
+    QString path = writeWav("changing.wav", 1);
+
+    DurationCache cache(m_database);
+    QVERIFY(cache.initialize());
+    QCOMPARE(cache.durationUs(path), qint64(1000000));
+
+    writeWav("changing.wav", 3);
+    QCOMPARE(cache.durationUs(path), qint64(3000000));
+    QCOMPARE(cache.statistics().misses, 2);
+}
+
+void TestDurationCache::testPersistence()
+{
+    QString path = writeWav("persisted.wav", 2);
+
+    {
+        DurationCache cache(m_database);
+        QVERIFY(cache.initialize());
+        QCOMPARE(cache.durationUs(path), qint64(2000000));
+        QVERIFY(cache.flush());
+        QCOMPARE(cache.statistics().pendingWrites, 0);
+    }
+
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("SELECT COUNT(*) FROM duration_cache"));
+    QVERIFY(query.next());
+    QCOMPARE(query.value(0).toInt(), 1);
+
+    DurationCache reloaded(m_database);
+    QVERIFY(reloaded.initialize());
+    QCOMPARE(reloaded.statistics().entries, 1);
+    QCOMPARE(reloaded.durationUs(path), qint64(2000000));
+    QCOMPARE(reloaded.statistics().hits, 1);
+    QCOMPARE(reloaded.statistics().misses, 0);
+}
+
+void TestDurationCache::testInvalidate()
+{
+    QString path = writeWav("invalidated.wav", 1);
+
+    DurationCache cache(m_database);
+    QVERIFY(cache.initialize());
+    cache.durationUs(path);
+    QVERIFY(cache.flush());
+
+    cache.invalidate(path);
+    QCOMPARE(cache.statistics().entries, 0);
+    QVERIFY(cache.flush());
+
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("SELECT COUNT(*) FROM duration_cache"));
+    QVERIFY(query.next());
+    QCOMPARE(query.value(0).toInt(), 0);
+}
+
+void TestDurationCache::testStore()
+{
+    QString path = writeWav("stored.wav", 1);
+
+    DurationCache cache(m_database);
+    QVERIFY(cache.initialize());
+
+    // A duration found by an import is served without probing
+    cache.store(path, 1500000);
+    QCOMPARE(cache.durationUs(path), qint64(1500000));
+    QCOMPARE(cache.statistics().hits, 1);
+    QCOMPARE(cache.statistics().misses, 0);
+
+    cache.store(m_tempDir->path() + "/missing.wav", 1000000);
+    cache.store(path + ".unknown", -1);
+    QCOMPARE(cache.statistics().entries, 1);
+}
+
+void TestDurationCache::testMissingFile()
+{
+    DurationCache cache(m_database);
+    QVERIFY(cache.initialize());
+
+    QCOMPARE(cache.durationUs(m_tempDir->path() + "/missing.wav"), qint64(-1));
+    QCOMPARE(cache.statistics().entries, 0);
+}
+
+QString TestDurationCache::writeWav(const QString& name, int seconds)
+{
+    // 8 kHz 8-bit mono PCM keeps the files small
+    const quint32 dataSize = 8000 * seconds;
+
+    QByteArray wav;
+    wav.append("RIFF");
+    appendLE32(wav, 36 + dataSize);
+    wav.append("WAVE");
+    wav.append("fmt ");
+    appendLE32(wav, 16);
+    appendLE16(wav, 1);    // PCM
+    appendLE16(wav, 1);    // channels
+    appendLE32(wav, 8000); // sample rate
+    appendLE32(wav, 8000); // byte rate
+    appendLE16(wav, 1);    // block align
+    appendLE16(wav, 8);    // bits per sample
+    wav.append("data");
+    appendLE32(wav, dataSize);
+    wav.append(QByteArray(dataSize, 0));
+
+    QString path = m_tempDir->path() + "/" + name;
+    QFile file(path);
+    if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        file.write(wav);
+        file.close();
+    }
+    return path;
+}
+
+void TestDurationCache::openDatabase()
+{
+    m_database = QSqlDatabase::addDatabase("QSQLITE", CONNECTION_NAME);
+    m_database.setDatabaseName(m_tempDir->path() + "/cache.db");
+    QVERIFY(m_database.open());
+}
+
+QTEST_MAIN(TestDurationCache)
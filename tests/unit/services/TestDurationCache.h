@@ -0,0 +1,43 @@
+#ifndef TESTDURATIONCACHE_H
+#define TESTDURATIONCACHE_H
+
+#include <QObject>
+#include <QTest>
+#include <QSqlDatabase>
+#include <QTemporaryDir>
+#include <memory>
+
+/**
+ * @brief Unit tests for DurationCache class
+ *
+ * Tests the persistent duration cache including:
+ * - Cache hits for unchanged files
+ * - Re-probing after a file changes size
+ * - Persistence of entries across cache instances
+ * - Durations stored from elsewhere
+ * - Invalidation and missing file handling
+ */
+class TestDurationCache : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testProbeAndHit();
+    void testChangedFileIsReprobed();
+    void testPersistence();
+    void testInvalidate();
+    void testStore();
+    void testMissingFile();
+
+private:
+    QString writeWav(const QString& name, int seconds);
+    void openDatabase();
+
+    std::unique_ptr<QTemporaryDir> m_tempDir;
+    QSqlDatabase m_database;
+};
+
+#endif // TESTDURATIONCACHE_H
@@ -373,6 +373,102 @@ void TestErrorHandler::testMessageLoggedSignal()
     QCOMPARE(arguments.at(3).value<ErrorHandler::ErrorCategory>(), ErrorHandler::ErrorCategory::Network);
 }
 
+void TestErrorHandler::testMessageTemplate()
+{
+    QCOMPARE(ErrorHandler::messageTemplate("Cannot open /mnt/nas/track12.mp3"),
+             QString("Cannot open *"));
+    QCOMPARE(ErrorHandler::messageTemplate("Cannot open C:\\Music\\a.mp3 (error 5)"),
+             QString("Cannot open * (error #)"));
+    QCOMPARE(ErrorHandler::messageTemplate("Track 'Blue Monday' missing after 300 ms"),
+             QString("Track '*' missing after # ms"));
+    QCOMPARE(ErrorHandler::messageTemplate("Can't reach host"), QString("Can't reach host"));
+    QCOMPARE(ErrorHandler::messageTemplate(QString()), QString());
+}
+
+void TestErrorHandler::testRepeatedMessagesSuppressed()
+{
+    ErrorHandler& handler = ErrorHandler::instance();
+    handler.initialize(m_testLogDir);
+    handler.setLogLevel(ErrorHandler::ErrorSeverity::Info);
+    handler.setSuppressionWindow(60000);
+    handler.flushSummaries();   // Repeats of earlier tests
+
+    QSignalSpy logSpy(&handler, &ErrorHandler::messageLogged);
+
+    for (int i = 0; i < 100; ++i) {
+        ErrorHandler::logMessage(ErrorHandler::ErrorSeverity::Warning,
+                               "StormComponent",
+                               QString("Cannot read /nas/music/track%1.mp3").arg(i),
+                               ErrorHandler::ErrorCategory::File);
+    }
+    // Another severity is another error
+    ErrorHandler::logMessage(ErrorHandler::ErrorSeverity::Error,
+                           "StormComponent",
+                           "Cannot read /nas/music/track0.mp3",
+                           ErrorHandler::ErrorCategory::File);
+    QCOMPARE(logSpy.count(), 2);
+
+    logSpy.clear();
+    handler.flushSummaries();
+    QCOMPARE(logSpy.count(), 1);
+    const QString summary = logSpy.takeFirst().at(2).toString();
+    QVERIFY(summary.contains("Repeated 99 times"));
+    QVERIFY(summary.contains("/nas/music/track99.mp3"));
+
+    // Nothing more was counted, so nothing more to summarize
+    handler.flushSummaries();
+    QCOMPARE(logSpy.count(), 0);
+
+    handler.setSuppressionWindow(ErrorHandler::SUPPRESSION_WINDOW_MS);
+}
+
+void TestErrorHandler::testRepeatedErrorsStillSignalled()
+{
+    ErrorHandler& handler = ErrorHandler::instance();
+    handler.initialize(m_testLogDir);
+    handler.setUserDialogsEnabled(false);
+    handler.setSuppressionWindow(60000);
+    handler.flushSummaries();   // Repeats of earlier tests
+
+    QSignalSpy errorSpy(&handler, &ErrorHandler::errorOccurred);
+    QSignalSpy logSpy(&handler, &ErrorHandler::messageLogged);
+
+    for (int i = 0; i < 10; ++i) {
+        ErrorHandler::handleError(ErrorHandler::ErrorSeverity::Error,
+                                 "RepeatComponent",
+                                 QString("Stream dropped after %1 s").arg(i),
+                                 QString(),
+                                 ErrorHandler::ErrorCategory::Network);
+    }
+    QCOMPARE(errorSpy.count(), 10);
+
+    handler.flushSummaries();
+    QCOMPARE(logSpy.count(), 1);
+    QVERIFY(logSpy.takeFirst().at(2).toString().contains("Repeated 9 times"));
+
+    handler.setSuppressionWindow(ErrorHandler::SUPPRESSION_WINDOW_MS);
+}
+
+void TestErrorHandler::testSuppressionWindowDisabled()
+{
+    ErrorHandler& handler = ErrorHandler::instance();
+    handler.initialize(m_testLogDir);
+    handler.setLogLevel(ErrorHandler::ErrorSeverity::Info);
+    handler.setSuppressionWindow(0);
+    QCOMPARE(handler.suppressionWindow(), 0);
+
+    QSignalSpy logSpy(&handler, &ErrorHandler::messageLogged);
+
+    for (int i = 0; i < 5; ++i) {
+        ErrorHandler::logMessage(ErrorHandler::ErrorSeverity::Warning,
+                               "UnsuppressedComponent",
+                               "Same message every time");
+    }
+    QCOMPARE(logSpy.count(), 5);
+
+    handler.setSuppressionWindow(ErrorHandler::SUPPRESSION_WINDOW_MS);
+}
+
 void TestErrorHandler::testSetLogLevel()
 {
     ErrorHandler& handler = ErrorHandler::instance();
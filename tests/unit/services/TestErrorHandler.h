@@ -17,6 +17,7 @@ class ErrorHandler;
  * - Logging functionality with file rotation
  * - User dialog display
  * - Signal emission
+ * - Suppression of repeated errors
  * - Thread safety
  */
 class TestErrorHandler : public QObject
@@ -60,6 +61,12 @@ private slots:
     void testErrorOccurredSignal();
     void testMessageLoggedSignal();
 
+    // Repeat suppression tests
+    void testMessageTemplate();
+    void testRepeatedMessagesSuppressed();
+    void testRepeatedErrorsStillSignalled();
+    void testSuppressionWindowDisabled();
+
     // Configuration tests
     void testSetLogLevel();
     void testSetUserDialogsEnabled();
@@ -0,0 +1,111 @@
+#include "TestEventJournal.h"
+#include "../../../src/services/EventJournal.h"
+#include <QDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QTemporaryDir>
+
+namespace {
+
+QStringList journalFiles(const QString& directory)
+{
+    return QDir(directory).entryList(QStringList() << "events_*.jsonl", QDir::Files, QDir::Name);
+}
+
+} // namespace
+
+void TestEventJournal::testRecordsJsonLines()
+{
+    QTemporaryDir dir;
+    EventJournal journal;
+    QVERIFY(journal.open(dir.path()));
+
+    const QDateTime time = QDateTime::currentDateTime();
+    journal.record(EventJournal::Type::TrackStart, {{"path", "/music/song.ogg"}}, time);
+    journal.record(EventJournal::Type::TrackStop, {{"path", "/music/song.ogg"}, {"reason", "next"}},
+                   time.addSecs(1));
+    journal.flush();
+
+    const QStringList files = journalFiles(dir.path());
+    QCOMPARE(files.size(), 1);
+    QFile file(dir.filePath(files.first()));
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QList<QByteArray> lines = file.readAll().split('\n');
+
+    // Nothing but the events, the last one ending the file
+    QCOMPARE(lines.size(), 3);
+    QVERIFY(lines.last().isEmpty());
+    const QJsonObject first = QJsonDocument::fromJson(lines[0]).object();
+    QCOMPARE(first.value("type").toString(), QString("track_start"));
+    QCOMPARE(first.value("path").toString(), QString("/music/song.ogg"));
+    QCOMPARE(first.value("time").toString(), EventJournal::formatTime(time));
+    QCOMPARE(QJsonDocument::fromJson(lines[1]).object().value("reason").toString(),
+             QString("next"));
+}
+
+void TestEventJournal::testReadsTimeRange()
+{
+    QTemporaryDir dir;
+    EventJournal journal;
+    QVERIFY(journal.open(dir.path()));
+
+    const QDateTime start = QDateTime::currentDateTime();
+    for (int i = 0; i < 10; ++i) {
+        journal.record(EventJournal::Type::Scheduled, {{"item", i}}, start.addSecs(i * 60));
+    }
+    journal.flush();
+
+    const QList<EventJournal::Event> events =
+        EventJournal::read(dir.path(), start.addSecs(3 * 60), start.addSecs(6 * 60));
+    QCOMPARE(events.size(), 3);
+    for (int i = 0; i < events.size(); ++i) {
+        QCOMPARE(events[i].type, EventJournal::Type::Scheduled);
+        QCOMPARE(events[i].fields.value("item").toInt(), 3 + i);
+        QVERIFY(!events[i].fields.contains("time"));
+    }
+    QCOMPARE(events.first().time, start.addSecs(3 * 60));
+}
+
+void TestEventJournal::testSkipsDamagedLines()
+{
+    QTemporaryDir dir;
+    const QDateTime start = QDateTime::currentDateTime();
+    {
+        EventJournal journal;
+        QVERIFY(journal.open(dir.path()));
+        journal.record(EventJournal::Type::Error, {{"message", "before"}}, start);
+        journal.flush();
+    }
+
+    // What a crash in the middle of a write leaves behind
+    const QStringList files = journalFiles(dir.path());
+    QCOMPARE(files.size(), 1);
+    QFile file(dir.filePath(files.first()));
+    QVERIFY(file.open(QIODevice::Append));
+    file.write("{\"time\":\"2026-10-14T10:00:00.000+00:00\",\"type\":\"trac\n");
+    file.write("{\"time\":\"not a time\",\"type\":\"error\"}\n");
+    file.close();
+
+    const QList<EventJournal::Event> events =
+        EventJournal::read(dir.path(), start.addDays(-1), start.addDays(1));
+    QCOMPARE(events.size(), 1);
+    QCOMPARE(events.first().fields.value("message").toString(), QString("before"));
+}
+
+void TestEventJournal::testTypeNames()
+{
+    const EventJournal::Type types[] = {EventJournal::Type::TrackStart,
+                                        EventJournal::Type::TrackStop,
+                                        EventJournal::Type::Scheduled,
+                                        EventJournal::Type::TakeOver, EventJournal::Type::Error};
+    for (EventJournal::Type type : types) {
+        EventJournal::Type parsed = EventJournal::Type::Error;
+        QVERIFY(EventJournal::typeFromName(EventJournal::typeName(type), &parsed));
+        QCOMPARE(parsed, type);
+    }
+    EventJournal::Type unknown = EventJournal::Type::TrackStart;
+    QVERIFY(!EventJournal::typeFromName("track", &unknown));
+    QCOMPARE(unknown, EventJournal::Type::TrackStart);
+}
+
+QTEST_MAIN(TestEventJournal)
@@ -0,0 +1,27 @@
+#ifndef TESTEVENTJOURNAL_H
+#define TESTEVENTJOURNAL_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for EventJournal class
+ *
+ * Tests the as-run event journal including:
+ * - One compact JSON object per line, with the time and type fields
+ * - Reading the events of a time range back in order
+ * - Skipping lines cut short by a crash
+ * - Type names written to and read from the journal
+ */
+class TestEventJournal : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testRecordsJsonLines();
+    void testReadsTimeRange();
+    void testSkipsDamagedLines();
+    void testTypeNames();
+};
+
+#endif // TESTEVENTJOURNAL_H
@@ -0,0 +1,212 @@
+#include "TestExifToolPool.h"
+#include "../../../src/services/ExifToolPool.h"
+#include <QFile>
+#include <QSignalSpy>
+
+namespace {
+
+// Stands in for exiftool -stay_open True -@ -: reads arguments one per line
+// and, on -execute<id>, prints each asked tag with the contents of the file
+// as its value, then {ready<id>}. Files with "hang" in their name never
+// answer. Every start is logged to FAKE_EXIFTOOL_LOG
+const char* FAKE_EXIFTOOL = "#!/bin/sh\n"
+                            "echo $$ >> \"$FAKE_EXIFTOOL_LOG\"\n"
+                            "tags=''; file=''; stay=''\n"
+                            "while IFS= read -r line; do\n"
+                            "  case \"$line\" in\n"
+                            "    -stay_open) stay=1;;\n"
+                            "    False) [ -n \"$stay\" ] && exit 0;;\n"
+                            "    -execute*)\n"
+                            "      case \"$file\" in *hang*) sleep 5;; esac\n"
+                            "      if [ -f \"$file\" ]; then\n"
+                            "        for tag in $tags; do\n"
+                            "          printf '%s: %s\\n' \"$tag\" \"$(cat \"$file\")\"\n"
+                            "        done\n"
+                            "      else\n"
+                            "        printf 'Error: File not found - %s\\n' \"$file\" >&2\n"
+                            "      fi\n"
+                            "      printf '{ready%s}\\n' \"${line#-execute}\"\n"
+                            "      tags=''; file='';;\n"
+                            "    -S|-charset|filename=*) ;;\n"
+                            "    -*) tags=\"$tags ${line#-}\";;\n"
+                            "    *) file=\"$line\";;\n"
+                            "  esac\n"
+                            "done\n";
+
+} // namespace
+
+void TestExifToolPool::init()
+{
+    m_tempDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_tempDir->isValid());
+
+    m_fakeExiftool = m_tempDir->filePath("fake-exiftool");
+    QFile script(m_fakeExiftool);
+    QVERIFY(script.open(QIODevice::WriteOnly));
+    script.write(FAKE_EXIFTOOL);
+    script.close();
+    script.setPermissions(QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner);
+
+    m_log = m_tempDir->filePath("starts.log");
+    qputenv("FAKE_EXIFTOOL_LOG", m_log.toLocal8Bit());
+}
+
+void TestExifToolPool::cleanup()
+{
+    qunsetenv("FAKE_EXIFTOOL_LOG");
+    m_tempDir.reset();
+}
+
+void TestExifToolPool::testQueriesTags()
+{
+    ExifToolPool pool;
+    configure(pool);
+    const QString path = writeTrack("song.aac", "0:03:45 (approx)");
+
+    const ExifToolPool::Result result = pool.query(path, {"Duration", "Title"});
+    QVERIFY2(result.ok, qPrintable(result.error));
+    QCOMPARE(result.path, path);
+    QCOMPARE(result.value("Duration"), QString("0:03:45 (approx)"));
+    QCOMPARE(result.value("Title"), QString("0:03:45 (approx)"));
+
+    QCOMPARE(pool.duration(path), QString("0:03:45"));
+    QCOMPARE(pool.pendingCount(), 0);
+}
+
+void TestExifToolPool::testReusesProcess()
+{
+    ExifToolPool pool;
+    configure(pool);
+    pool.setWorkers(1);
+
+    for (int i = 0; i < 5; ++i) {
+        const QString path = writeTrack(QString("track%1.wma").arg(i), QByteArray::number(i));
+        QCOMPARE(pool.duration(path), QString::number(i));
+    }
+    QCOMPARE(pool.startedWorkers(), 1);
+    QCOMPARE(starts(), 1);
+    QCOMPARE(pool.runningWorkers(), 1);
+
+    pool.shutdown();
+    QCOMPARE(pool.runningWorkers(), 0);
+}
+
+void TestExifToolPool::testSpreadsOverWorkers()
+{
+    ExifToolPool pool;
+    configure(pool);
+    pool.setWorkers(2);
+    QSignalSpy finished(&pool, &ExifToolPool::finished);
+
+    QHash<QString, QString> answers;
+    for (int i = 0; i < 6; ++i) {
+        const QString path = writeTrack(QString("track%1.ape").arg(i), QByteArray::number(i * 10));
+        pool.request(path, {"Duration"}, this, [&answers](const ExifToolPool::Result& result) {
+            answers.insert(result.path, result.value("Duration"));
+        });
+    }
+    // Never answered from inside request()
+    QVERIFY(answers.isEmpty());
+    QCOMPARE(pool.pendingCount(), 6);
+    QCOMPARE(pool.runningWorkers(), 2);
+
+    QTRY_COMPARE_WITH_TIMEOUT(finished.count(), 6, 5000);
+    for (int i = 0; i < 6; ++i) {
+        QCOMPARE(answers.value(m_tempDir->filePath(QString("track%1.ape").arg(i))),
+                 QString::number(i * 10));
+    }
+    QCOMPARE(pool.startedWorkers(), 2);
+}
+
+void TestExifToolPool::testUnreadableFile()
+{
+    ExifToolPool pool;
+    configure(pool);
+
+    const ExifToolPool::Result result = pool.query(m_tempDir->filePath("missing.aac"),
+                                                   {"Duration"});
+    QVERIFY(!result.ok);
+    QVERIFY(result.error.contains("File not found"));
+    QVERIFY(result.tags.isEmpty());
+
+    // The process is still good for the next file
+    QCOMPARE(pool.duration(writeTrack("there.aac", "0:01:00")), QString("0:01:00"));
+    QCOMPARE(pool.startedWorkers(), 1);
+}
+
+void TestExifToolPool::testTimeoutRestartsProcess()
+{
+    ExifToolPool pool;
+    configure(pool);
+    pool.setWorkers(1);
+    pool.setTimeout(200);
+
+    const ExifToolPool::Result hung = pool.query(writeTrack("hang.aac", "0:02:00"), {"Duration"});
+    QVERIFY(!hung.ok);
+    QVERIFY(hung.error.contains("timed out"));
+
+    QCOMPARE(pool.duration(writeTrack("next.aac", "0:02:30")), QString("0:02:30"));
+    QCOMPARE(pool.startedWorkers(), 2);
+    QTRY_COMPARE(starts(), 2);
+}
+
+void TestExifToolPool::testWithoutProgram()
+{
+    ExifToolPool pool;
+    QVERIFY(pool.program().isEmpty());
+
+    const ExifToolPool::Result result = pool.query(writeTrack("song.aac", "0:03:00"), {"Duration"});
+    QVERIFY(!result.ok);
+    QVERIFY(result.error.contains("not installed"));
+    QVERIFY(pool.duration(m_tempDir->filePath("song.aac")).isEmpty());
+    QCOMPARE(pool.startedWorkers(), 0);
+
+    pool.setProgram(m_tempDir->filePath("no-such-exiftool"));
+    const ExifToolPool::Result missing = pool.query(m_tempDir->filePath("song.aac"), {"Duration"});
+    QVERIFY(!missing.ok);
+    QVERIFY(missing.error.contains("cannot start"));
+    QCOMPARE(pool.runningWorkers(), 0);
+}
+
+void TestExifToolPool::testDropsCallbackOfDestroyedContext()
+{
+    ExifToolPool pool;
+    configure(pool);
+    QSignalSpy finished(&pool, &ExifToolPool::finished);
+
+    bool called = false;
+    QObject* context = new QObject;
+    pool.request(writeTrack("song.aac", "0:04:00"), {"Duration"}, context,
+                 [&called](const ExifToolPool::Result&) { called = true; });
+    delete context;
+
+    QVERIFY(finished.wait(5000));
+    QVERIFY(!called);
+}
+
+void TestExifToolPool::configure(ExifToolPool& pool)
+{
+    pool.setProgram(m_fakeExiftool);
+    pool.setTimeout(5000);
+}
+
+QString TestExifToolPool::writeTrack(const QString& name, const QByteArray& duration)
+{
+    const QString path = m_tempDir->filePath(name);
+    QFile file(path);
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(duration);
+    }
+    return path;
+}
+
+int TestExifToolPool::starts() const
+{
+    QFile file(m_log);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+    return int(file.readAll().count('\n'));
+}
+
+QTEST_MAIN(TestExifToolPool)
@@ -0,0 +1,48 @@
+#ifndef TESTEXIFTOOLPOOL_H
+#define TESTEXIFTOOLPOOL_H
+
+#include <QObject>
+#include <QTest>
+#include <QTemporaryDir>
+#include <memory>
+
+class ExifToolPool;
+
+/**
+ * @brief Unit tests for ExifToolPool class
+ *
+ * Tests the resident exiftool processes including:
+ * - Reading tags with -execute and stripping the " (approx)" of durations
+ * - Keeping one process for many requests
+ * - Answering requests spread over several processes
+ * - Reporting files exiftool cannot read
+ * - Killing a process that hangs and starting another
+ * - Failing without exiftool and dropping callbacks whose context is gone
+ */
+class TestExifToolPool : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testQueriesTags();
+    void testReusesProcess();
+    void testSpreadsOverWorkers();
+    void testUnreadableFile();
+    void testTimeoutRestartsProcess();
+    void testWithoutProgram();
+    void testDropsCallbackOfDestroyedContext();
+
+private:
+    void configure(ExifToolPool& pool);
+    QString writeTrack(const QString& name, const QByteArray& duration);
+    int starts() const;
+
+    std::unique_ptr<QTemporaryDir> m_tempDir;
+    QString m_fakeExiftool;
+    QString m_log;
+};
+
+#endif // TESTEXIFTOOLPOOL_H
@@ -0,0 +1,126 @@
+#include "TestFailoverStandby.h"
+#include "../../../src/services/FailoverStandby.h"
+#include <QSignalSpy>
+#include <QStringList>
+
+namespace {
+
+void recordPrefetches(FailoverStandby& standby, QStringList& prefetched)
+{
+    standby.setPrefetcher([&prefetched](const QString& filePath) { prefetched.append(filePath); });
+}
+
+} // namespace
+
+void TestFailoverStandby::testPrefetchWhileArmed()
+{
+    FailoverStandby standby;
+    QStringList prefetched;
+    recordPrefetches(standby, prefetched);
+
+    // The playlist head changes all day; only a live TakeOver warms it up
+    standby.setStandbySource("/music/a.ogg");
+    QVERIFY(prefetched.isEmpty());
+    QVERIFY(!standby.isReady());
+
+    standby.arm();
+    QCOMPARE(prefetched, QStringList{"/music/a.ogg"});
+    QVERIFY(standby.isReady());
+
+    standby.setStandbySource("/music/a.ogg");
+    standby.setStandbySource("/music/b.ogg");
+    QCOMPARE(prefetched, QStringList({"/music/a.ogg", "/music/b.ogg"}));
+
+    standby.disarm();
+    standby.setStandbySource("/music/c.ogg");
+    QCOMPARE(prefetched.size(), 2);
+    QVERIFY(!standby.isReady());
+}
+
+void TestFailoverStandby::testStandbyMissing()
+{
+    FailoverStandby standby;
+    QSignalSpy missing(&standby, &FailoverStandby::standbyMissing);
+
+    standby.setStandbySource(QString());
+    QCOMPARE(missing.count(), 0);
+
+    standby.arm();
+    QCOMPARE(missing.count(), 1);
+    QVERIFY(!standby.isReady());
+
+    standby.setStandbySource("/music/a.ogg");
+    standby.setStandbySource(QString());
+    QCOMPARE(missing.count(), 2);
+}
+
+void TestFailoverStandby::testFailoverLatency()
+{
+    FailoverStandby standby;
+    QSignalSpy completed(&standby, &FailoverStandby::failoverCompleted);
+    standby.setStandbySource("/music/a.ogg");
+    standby.arm();
+
+    // Failed probes before arming are not part of any TakeOver outage
+    standby.probeFailed(1000);
+    QTest::qWait(100);
+    standby.probeFailed(1000);
+    standby.beginFailover();
+    QVERIFY(standby.isFailingOver());
+    QTest::qWait(50);
+    standby.completeFailover();
+    QVERIFY(!standby.isFailingOver());
+
+    QCOMPARE(completed.count(), 1);
+    const qint64 detectionMs = completed.at(0).at(0).toLongLong();
+    const qint64 switchMs = completed.at(0).at(1).toLongLong();
+    // The first probe's own timeout counts, the second one does not
+    QVERIFY2(detectionMs >= 1100 && detectionMs < 2000, qPrintable(QString::number(detectionMs)));
+    QVERIFY2(switchMs >= 50, qPrintable(QString::number(switchMs)));
+
+    const FailoverStandby::Statistics stats = standby.statistics();
+    QCOMPARE(stats.failovers, 1);
+    QCOMPARE(stats.coldStarts, 0);
+    QCOMPARE(stats.lastLatencyMs(), detectionMs + switchMs);
+    QCOMPARE(stats.worstLatencyMs, stats.lastLatencyMs());
+    QCOMPARE(stats.averageLatencyMs(), stats.lastLatencyMs());
+
+    // Tracks that start later are ordinary playback
+    standby.completeFailover();
+    QCOMPARE(completed.count(), 1);
+}
+
+void TestFailoverStandby::testProbeSuccessResetsDetection()
+{
+    FailoverStandby standby;
+    standby.arm();
+
+    standby.probeFailed(500);
+    standby.probeSucceeded();
+    standby.probeFailed(0);
+    standby.beginFailover();
+    standby.completeFailover();
+
+    QVERIFY(standby.statistics().lastDetectionMs < 500);
+}
+
+void TestFailoverStandby::testColdStartAndDisarm()
+{
+    FailoverStandby standby;
+    QSignalSpy completed(&standby, &FailoverStandby::failoverCompleted);
+    standby.arm();
+
+    standby.beginFailover();
+    standby.completeFailover();
+    QCOMPARE(standby.statistics().coldStarts, 1);
+
+    // A TakeOver returned before the local audio came up is not a failover
+    standby.setStandbySource("/music/a.ogg");
+    standby.beginFailover();
+    standby.disarm();
+    standby.completeFailover();
+    QCOMPARE(completed.count(), 1);
+    QCOMPARE(standby.statistics().failovers, 1);
+}
+
+QTEST_MAIN(TestFailoverStandby)
@@ -0,0 +1,28 @@
+#ifndef TESTFAILOVERSTANDBY_H
+#define TESTFAILOVERSTANDBY_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for FailoverStandby class
+ *
+ * Tests the TakeOver failover standby including:
+ * - Prefetching each new standby item only while armed
+ * - Reporting a missing standby item
+ * - Timing detection and switch of a failover
+ * - Counting cold starts and ignoring failovers that never reached the air
+ */
+class TestFailoverStandby : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testPrefetchWhileArmed();
+    void testStandbyMissing();
+    void testFailoverLatency();
+    void testProbeSuccessResetsDetection();
+    void testColdStartAndDisarm();
+};
+
+#endif // TESTFAILOVERSTANDBY_H
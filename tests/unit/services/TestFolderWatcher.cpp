@@ -0,0 +1,87 @@
+#include "TestFolderWatcher.h"
+#include "../../../src/services/FolderWatcher.h"
+#include <QDir>
+#include <QFile>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+
+namespace {
+
+void writeFile(const QString& path, const QByteArray& data, QIODevice::OpenMode mode = QIODevice::WriteOnly)
+{
+    QFile file(path);
+    QVERIFY(file.open(mode));
+    QCOMPARE(file.write(data), qint64(data.size()));
+}
+
+} // namespace
+
+void TestFolderWatcher::testFileCreated()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    FolderWatcher watcher;
+    watcher.setDebounceInterval(50);
+    QVERIFY(watcher.setPath(dir.path()));
+    QVERIFY(watcher.isWatching());
+    QCOMPARE(watcher.path(), dir.path());
+
+    QSignalSpy changedSpy(&watcher, &FolderWatcher::changed);
+    writeFile(QDir(dir.path()).filePath("takeover.xml"), "<XFBClientTakeOver/>");
+    QTRY_COMPARE_WITH_TIMEOUT(changedSpy.count(), 1, 5000);
+}
+
+void TestFolderWatcher::testWatchedFileWritten()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = QDir(dir.path()).filePath("takeover.xml");
+    writeFile(path, "<XFB");
+
+    FolderWatcher watcher;
+    watcher.setDebounceInterval(50);
+    watcher.setNameFilters({"*.xml"});
+    QVERIFY(watcher.setPath(dir.path()));
+
+    // Appending to a file changes the file, not the directory
+    QSignalSpy changedSpy(&watcher, &FolderWatcher::changed);
+    writeFile(path, "ClientTakeOver/>", QIODevice::Append);
+    QTRY_COMPARE_WITH_TIMEOUT(changedSpy.count(), 1, 5000);
+}
+
+void TestFolderWatcher::testBurstIsDebounced()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    FolderWatcher watcher;
+    watcher.setDebounceInterval(300);
+    watcher.setNameFilters({"*.ogg"});
+    QVERIFY(watcher.setPath(dir.path()));
+
+    QSignalSpy changedSpy(&watcher, &FolderWatcher::changed);
+    const QString path = QDir(dir.path()).filePath("show_2024-01-01.ogg");
+    writeFile(path, QByteArray(1024, 'a'));
+    for (int i = 0; i < 5; ++i) {
+        QTest::qWait(20);
+        writeFile(path, QByteArray(1024, 'b'), QIODevice::Append);
+    }
+
+    QTRY_COMPARE_WITH_TIMEOUT(changedSpy.count(), 1, 5000);
+    QTest::qWait(600);
+    QCOMPARE(changedSpy.count(), 1);
+}
+
+void TestFolderWatcher::testMissingDirectory()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    FolderWatcher watcher;
+    QVERIFY(!watcher.setPath(QDir(dir.path()).filePath("missing")));
+    QVERIFY(!watcher.isWatching());
+    QVERIFY(watcher.path().isEmpty());
+}
+
+QTEST_MAIN(TestFolderWatcher)
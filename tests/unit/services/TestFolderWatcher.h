@@ -0,0 +1,27 @@
+#ifndef TESTFOLDERWATCHER_H
+#define TESTFOLDERWATCHER_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for FolderWatcher class
+ *
+ * Tests debounced directory watching including:
+ * - Files created in the directory
+ * - Writes to files matching the name filters
+ * - Bursts of changes folded into a single signal
+ * - Directories that do not exist
+ */
+class TestFolderWatcher : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testFileCreated();
+    void testWatchedFileWritten();
+    void testBurstIsDebounced();
+    void testMissingDirectory();
+};
+
+#endif // TESTFOLDERWATCHER_H
@@ -0,0 +1,415 @@
+#include "TestFtpSyncEngine.h"
+#include "../../../src/services/FtpClient.h"
+#include "../../../src/services/FtpSyncEngine.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QHostAddress>
+#include <QSignalSpy>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+#include <functional>
+#include <memory>
+
+namespace {
+
+/// Just enough of an FTP server for the client: one "Programs" directory
+/// held in memory, passive data connections only.
+class FakeFtpServer
+{
+public:
+    FakeFtpServer()
+    {
+        m_server.listen(QHostAddress::LocalHost);
+        QObject::connect(&m_server, &QTcpServer::newConnection, &m_server, [this]() {
+            while (QTcpSocket* control = m_server.nextPendingConnection()) {
+                accept(control);
+            }
+        });
+    }
+
+    quint16 port() const { return m_server.serverPort(); }
+
+    QHash<QString, QByteArray> files;
+    QStringList commands;
+    bool supportsMlsd = true;
+    QString password = "secret";
+    /// Files whose next download stops after this many bytes
+    QHash<QString, qint64> dropAfter;
+
+private:
+    struct Session {
+        QTcpSocket* control = nullptr;
+        QTcpServer* passive = nullptr;
+        QTcpSocket* data = nullptr;
+        std::function<void()> pending;
+        qint64 rest = 0;
+        bool inPrograms = false;
+    };
+
+    void accept(QTcpSocket* control)
+    {
+        auto session = std::make_shared<Session>();
+        session->control = control;
+        reply(session, "220 Fake FTP ready");
+        QObject::connect(control, &QTcpSocket::readyRead, control, [this, session]() {
+            while (session->control->canReadLine()) {
+                const QString line = QString::fromUtf8(session->control->readLine()).trimmed();
+                handle(session, line);
+            }
+        });
+    }
+
+    void reply(const std::shared_ptr<Session>& session, const QString& text)
+    {
+        session->control->write(text.toUtf8() + "\r\n");
+    }
+
+    void openPassive(const std::shared_ptr<Session>& session)
+    {
+        delete session->passive;
+        session->passive = new QTcpServer(session->control);
+        session->passive->listen(QHostAddress::LocalHost);
+        session->data = nullptr;
+        QObject::connect(session->passive, &QTcpServer::newConnection, session->passive, [session]() {
+            session->data = session->passive->nextPendingConnection();
+            if (session->pending) {
+                auto run = session->pending;
+                session->pending = nullptr;
+                run();
+            }
+        });
+    }
+
+    void withData(const std::shared_ptr<Session>& session, std::function<void()> transfer)
+    {
+        if (session->data) {
+            transfer();
+        } else {
+            session->pending = transfer;
+        }
+    }
+
+    void sendData(const std::shared_ptr<Session>& session, const QByteArray& payload, bool complete)
+    {
+        reply(session, "150 Opening data connection");
+        session->data->write(payload);
+        session->data->disconnectFromHost();
+        session->data = nullptr;
+        reply(session, complete ? "226 Transfer complete" : "426 Connection closed; transfer aborted");
+    }
+
+    void handle(const std::shared_ptr<Session>& session, const QString& line)
+    {
+        commands.append(line);
+        const QString verb = line.section(' ', 0, 0).toUpper();
+        const QString argument = line.section(' ', 1);
+
+        if (verb == "USER") {
+            reply(session, "331 Password required");
+        } else if (verb == "PASS") {
+            reply(session, argument == password ? "230 Logged in" : "530 Login incorrect");
+        } else if (verb == "TYPE") {
+            reply(session, "200 Type set to I");
+        } else if (verb == "CWD") {
+            session->inPrograms = argument == "Programs";
+            reply(session, session->inPrograms ? "250 Directory changed" : "550 No such directory");
+        } else if (verb == "EPSV") {
+            openPassive(session);
+            reply(session, QString("229 Entering Extended Passive Mode (|||%1|)").arg(session->passive->serverPort()));
+        } else if (verb == "PASV") {
+            openPassive(session);
+            const quint16 port = session->passive->serverPort();
+            reply(session, QString("227 Entering Passive Mode (127,0,0,1,%1,%2)").arg(port / 256).arg(port % 256));
+        } else if (verb == "MLSD" && !supportsMlsd) {
+            reply(session, "500 Unknown command");
+        } else if (verb == "MLSD" || verb == "NLST") {
+            const bool facts = verb == "MLSD";
+            withData(session, [this, session, facts]() {
+                QByteArray listing;
+                if (facts) {
+                    listing += "type=cdir; .\r\n";
+                }
+                for (auto it = files.constBegin(); it != files.constEnd(); ++it) {
+                    listing += facts ? QString("type=file;size=%1; %2\r\n").arg(it.value().size()).arg(it.key()).toUtf8()
+                                     : it.key().toUtf8() + "\r\n";
+                }
+                sendData(session, listing, true);
+            });
+        } else if (verb == "REST") {
+            session->rest = argument.toLongLong();
+            reply(session, "350 Restarting");
+        } else if (verb == "RETR") {
+            if (!files.contains(argument)) {
+                reply(session, "550 No such file");
+                return;
+            }
+            const qint64 offset = session->rest;
+            session->rest = 0;
+            withData(session, [this, session, argument, offset]() {
+                QByteArray payload = files.value(argument).mid(offset);
+                const bool drop = dropAfter.contains(argument);
+                if (drop) {
+                    payload = payload.left(dropAfter.take(argument));
+                }
+                sendData(session, payload, !drop);
+            });
+        } else if (verb == "DELE") {
+            reply(session, files.remove(argument) ? "250 Deleted" : "550 No such file");
+        } else if (verb == "QUIT") {
+            reply(session, "221 Bye");
+            session->control->disconnectFromHost();
+        } else {
+            reply(session, "502 Not implemented");
+        }
+    }
+
+    QTcpServer m_server;
+};
+
+QString sha256Of(const QByteArray& data)
+{
+    return QString::fromLatin1(QCryptographicHash::hash(data, QCryptographicHash::Sha256).toHex());
+}
+
+QByteArray readFile(const QString& path)
+{
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+void configure(FtpSyncEngine& engine, const FakeFtpServer& server, const QString& localDirectory)
+{
+    engine.setServer("127.0.0.1", server.port(), "xfb", "secret");
+    engine.setRemoteDirectory("Programs");
+    engine.setLocalDirectory(localDirectory);
+    engine.setTimeout(5000);
+}
+
+} // namespace
+
+void TestFtpSyncEngine::testParsers()
+{
+    FtpClient::RemoteFile file;
+    QVERIFY(FtpClient::parseMlsdLine("type=file;size=1234;modify=20240101120000; show_2024-01-01.ogg", file));
+    QCOMPARE(file.name, QString("show_2024-01-01.ogg"));
+    QCOMPARE(file.size, qint64(1234));
+    QVERIFY(!file.isDirectory);
+
+    QVERIFY(FtpClient::parseMlsdLine("Type=dir;Modify=20240101120000; archive", file));
+    QVERIFY(file.isDirectory);
+    QCOMPARE(file.size, qint64(-1));
+    QVERIFY(!FtpClient::parseMlsdLine("nofacts", file));
+
+    QCOMPARE(FtpClient::parsePassivePort(229, "Entering Extended Passive Mode (|||6446|)"), quint16(6446));
+    QCOMPARE(FtpClient::parsePassivePort(227, "Entering Passive Mode (10,0,0,5,19,137)"), quint16(19 * 256 + 137));
+    QCOMPARE(FtpClient::parsePassivePort(227, "garbage"), quint16(0));
+
+    const QString hash = sha256Of("abc");
+    const QHash<QString, QString> checksums =
+        FtpSyncEngine::parseChecksums(hash.toUpper() + "  a.ogg\n" + hash + " *dir/b.ogg\nnot a checksum line\n");
+    QCOMPARE(checksums.size(), 2);
+    QCOMPARE(checksums.value("a.ogg"), hash);
+    QCOMPARE(checksums.value("b.ogg"), hash);
+}
+
+void TestFtpSyncEngine::testClientListAndRetrieve()
+{
+    FakeFtpServer server;
+    server.files.insert("one.ogg", QByteArray(3000, 'a'));
+    server.files.insert("two.ogg", "second");
+
+    FtpClient client;
+    client.setTimeout(5000);
+    bool loggedIn = false;
+    client.connectToHost("127.0.0.1", server.port(), "xfb", "secret",
+                         [&](bool ok, const QString&) { loggedIn = ok; });
+    client.changeDirectory("Programs", [](bool, const QString&) {});
+
+    QList<FtpClient::RemoteFile> listed;
+    bool listDone = false;
+    client.list([&](bool ok, const QList<FtpClient::RemoteFile>& files, const QString&) {
+        QVERIFY(ok);
+        listed = files;
+        listDone = true;
+    });
+
+    QByteArray content;
+    bool retrieved = false;
+    client.retrieve(
+        "one.ogg", 1000, [&](const QByteArray& chunk) { content += chunk; },
+        [&](bool ok, const QString&) { retrieved = ok; });
+
+    QTRY_VERIFY_WITH_TIMEOUT(retrieved, 5000);
+    QVERIFY(loggedIn);
+    QVERIFY(listDone);
+    QCOMPARE(listed.size(), 2);
+    for (const FtpClient::RemoteFile& file : std::as_const(listed)) {
+        QCOMPARE(file.size, server.files.value(file.name).size());
+    }
+    QCOMPARE(content, QByteArray(2000, 'a'));
+    QVERIFY(server.commands.contains("REST 1000"));
+
+    // Without MLSD the listing falls back to bare names
+    server.supportsMlsd = false;
+    listDone = false;
+    client.list([&](bool ok, const QList<FtpClient::RemoteFile>& files, const QString&) {
+        QVERIFY(ok);
+        listed = files;
+        listDone = true;
+    });
+    QTRY_VERIFY_WITH_TIMEOUT(listDone, 5000);
+    QCOMPARE(listed.size(), 2);
+    QCOMPARE(listed.first().size, qint64(-1));
+    QVERIFY(server.commands.contains("NLST"));
+}
+
+void TestFtpSyncEngine::testClientLoginFailure()
+{
+    FakeFtpServer server;
+    server.password = "other";
+
+    FtpClient client;
+    int loginCalls = 0;
+    bool loginOk = true;
+    bool cwdFailed = false;
+    client.connectToHost("127.0.0.1", server.port(), "xfb", "secret", [&](bool ok, const QString& error) {
+        ++loginCalls;
+        loginOk = ok;
+        QVERIFY(error.startsWith("530"));
+    });
+    client.changeDirectory("Programs", [&](bool ok, const QString&) { cwdFailed = !ok; });
+
+    QTRY_VERIFY_WITH_TIMEOUT(cwdFailed, 5000);
+    QCOMPARE(loginCalls, 1);
+    QVERIFY(!loginOk);
+    QVERIFY(!server.commands.contains("CWD Programs"));
+}
+
+void TestFtpSyncEngine::testSyncDownloadsNewFiles()
+{
+    QTemporaryDir local;
+    QVERIFY(local.isValid());
+
+    FakeFtpServer server;
+    const QByteArray first(200000, 'x');
+    const QByteArray second = "another program";
+    server.files.insert("first_2024-01-01.ogg", first);
+    server.files.insert("second_2024-01-02.ogg", second);
+    server.files.insert("notes.txt", "not a program");
+    server.files.insert(FtpSyncEngine::REMOTE_MANIFEST_NAME,
+                        (sha256Of(first) + "  first_2024-01-01.ogg\n").toUtf8());
+
+    FtpSyncEngine engine;
+    configure(engine, server, local.path());
+    engine.setMaxParallelDownloads(2);
+
+    QSignalSpy downloadedSpy(&engine, &FtpSyncEngine::fileDownloaded);
+    QSignalSpy finishedSpy(&engine, &FtpSyncEngine::syncFinished);
+    QVERIFY(engine.sync());
+    QVERIFY(engine.isRunning());
+    QVERIFY(!engine.sync());
+
+    QTRY_COMPARE_WITH_TIMEOUT(finishedSpy.count(), 1, 10000);
+    QCOMPARE(finishedSpy.first().at(0).toBool(), true);
+    QCOMPARE(finishedSpy.first().at(1).toInt(), 2);
+    QCOMPARE(finishedSpy.first().at(2).toInt(), 0);
+    QCOMPARE(downloadedSpy.count(), 2);
+
+    const QDir dir(local.path());
+    QCOMPARE(readFile(dir.filePath("first_2024-01-01.ogg")), first);
+    QCOMPARE(readFile(dir.filePath("second_2024-01-02.ogg")), second);
+    QVERIFY(!QFile::exists(dir.filePath("notes.txt")));
+    QVERIFY(!QFile::exists(dir.filePath("first_2024-01-01.ogg.part")));
+
+    // Fetched programs are removed from the server, the rest stays
+    QTRY_VERIFY_WITH_TIMEOUT(!server.files.contains("second_2024-01-02.ogg"), 5000);
+    QVERIFY(!server.files.contains("first_2024-01-01.ogg"));
+    QVERIFY(server.files.contains("notes.txt"));
+
+    const QHash<QString, FtpSyncEngine::ManifestEntry> manifest = FtpSyncEngine::readManifest(local.path());
+    QCOMPARE(manifest.size(), 2);
+    QCOMPARE(manifest.value("first_2024-01-01.ogg").sha256, sha256Of(first));
+    QCOMPARE(manifest.value("second_2024-01-02.ogg").size, qint64(second.size()));
+
+    // Delta sync: files already fetched are not fetched again
+    server.files.insert("first_2024-01-01.ogg", first);
+    server.files.insert("third_2024-01-03.ogg", "third");
+    engine.setDeleteRemoteAfterDownload(false);
+    downloadedSpy.clear();
+    QVERIFY(engine.sync());
+    QTRY_COMPARE_WITH_TIMEOUT(finishedSpy.count(), 2, 10000);
+    QCOMPARE(downloadedSpy.count(), 1);
+    QCOMPARE(downloadedSpy.first().at(0).toString(), QString("third_2024-01-03.ogg"));
+    QVERIFY(server.files.contains("third_2024-01-03.ogg"));
+}
+
+void TestFtpSyncEngine::testSyncResumesPartialDownload()
+{
+    QTemporaryDir local;
+    QVERIFY(local.isValid());
+
+    FakeFtpServer server;
+    QByteArray program;
+    for (int i = 0; i < 5000; ++i) {
+        program += QByteArray::number(i) + ',';
+    }
+    server.files.insert("show_2024-02-01.ogg", program);
+    server.files.insert(FtpSyncEngine::REMOTE_MANIFEST_NAME,
+                        (sha256Of(program) + "  show_2024-02-01.ogg\n").toUtf8());
+    server.dropAfter.insert("show_2024-02-01.ogg", 1000);
+
+    FtpSyncEngine engine;
+    configure(engine, server, local.path());
+
+    QSignalSpy failedSpy(&engine, &FtpSyncEngine::fileFailed);
+    QSignalSpy finishedSpy(&engine, &FtpSyncEngine::syncFinished);
+    QVERIFY(engine.sync());
+    QTRY_COMPARE_WITH_TIMEOUT(finishedSpy.count(), 1, 10000);
+    QCOMPARE(failedSpy.count(), 1);
+
+    const QString partPath = QDir(local.path()).filePath(QString("show_2024-02-01.ogg") + FtpSyncEngine::PARTIAL_SUFFIX);
+    QCOMPARE(QFileInfo(partPath).size(), qint64(1000));
+    QVERIFY(server.files.contains("show_2024-02-01.ogg"));
+
+    QSignalSpy downloadedSpy(&engine, &FtpSyncEngine::fileDownloaded);
+    QVERIFY(engine.sync());
+    QTRY_COMPARE_WITH_TIMEOUT(finishedSpy.count(), 2, 10000);
+    QCOMPARE(downloadedSpy.count(), 1);
+    QVERIFY(server.commands.contains("REST 1000"));
+    QCOMPARE(readFile(QDir(local.path()).filePath("show_2024-02-01.ogg")), program);
+    QVERIFY(!QFile::exists(partPath));
+}
+
+void TestFtpSyncEngine::testSyncRejectsBadChecksum()
+{
+    QTemporaryDir local;
+    QVERIFY(local.isValid());
+
+    FakeFtpServer server;
+    server.files.insert("bad_2024-03-01.ogg", "corrupted on the way");
+    server.files.insert(FtpSyncEngine::REMOTE_MANIFEST_NAME,
+                        (sha256Of("what was uploaded") + "  bad_2024-03-01.ogg\n").toUtf8());
+
+    FtpSyncEngine engine;
+    configure(engine, server, local.path());
+
+    QSignalSpy failedSpy(&engine, &FtpSyncEngine::fileFailed);
+    QSignalSpy finishedSpy(&engine, &FtpSyncEngine::syncFinished);
+    QVERIFY(engine.sync());
+    QTRY_COMPARE_WITH_TIMEOUT(finishedSpy.count(), 1, 10000);
+
+    QCOMPARE(failedSpy.count(), 1);
+    QVERIFY(failedSpy.first().at(1).toString().contains("Checksum mismatch"));
+    QCOMPARE(finishedSpy.first().at(1).toInt(), 0);
+    QCOMPARE(finishedSpy.first().at(2).toInt(), 1);
+
+    const QDir dir(local.path());
+    QVERIFY(!QFile::exists(dir.filePath("bad_2024-03-01.ogg")));
+    QVERIFY(!QFile::exists(dir.filePath(QString("bad_2024-03-01.ogg") + FtpSyncEngine::PARTIAL_SUFFIX)));
+    // A file that failed verification stays on the server
+    QVERIFY(server.files.contains("bad_2024-03-01.ogg"));
+}
+
+QTEST_MAIN(TestFtpSyncEngine)
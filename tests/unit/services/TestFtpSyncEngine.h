@@ -0,0 +1,30 @@
+#ifndef TESTFTPSYNCENGINE_H
+#define TESTFTPSYNCENGINE_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for FtpClient and FtpSyncEngine classes
+ *
+ * Runs against a small in-process FTP server and covers:
+ * - Reply, listing and checksum parsing
+ * - Login, MLSD listings and the NLST fallback
+ * - Parallel downloads straight into the local directory
+ * - Manifest-based delta sync
+ * - Resuming interrupted downloads and rejecting bad checksums
+ */
+class TestFtpSyncEngine : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testParsers();
+    void testClientListAndRetrieve();
+    void testClientLoginFailure();
+    void testSyncDownloadsNewFiles();
+    void testSyncResumesPartialDownload();
+    void testSyncRejectsBadChecksum();
+};
+
+#endif // TESTFTPSYNCENGINE_H
@@ -0,0 +1,149 @@
+#include "TestGainRamp.h"
+#include "../../../src/services/GainRamp.h"
+#include <QRandomGenerator>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+// Gain each frame of a block of ones ends up with
+std::vector<float> gains(GainRamp& ramp, int frames, int channels = 2)
+{
+    std::vector<float> samples(size_t(frames * channels), 1.0f);
+    ramp.process(samples.data(), frames, channels);
+    std::vector<float> result;
+    for (int i = 0; i < frames; ++i) {
+        result.push_back(samples[size_t(i * channels)]);
+        for (int channel = 1; channel < channels; ++channel) {
+            if (samples[size_t(i * channels + channel)] != result.back()) {
+                return {};
+            }
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+void TestGainRamp::testConstantGain()
+{
+    GainRamp ramp(0.5f);
+    QVERIFY(!ramp.isRamping());
+    for (float gain : gains(ramp, 10)) {
+        QCOMPARE(gain, 0.5f);
+    }
+
+    ramp.rampTo(0.25f, 0);
+    QVERIFY(!ramp.isRamping());
+    QCOMPARE(ramp.gain(), 0.25f);
+    QCOMPARE(gains(ramp, 3).front(), 0.25f);
+}
+
+void TestGainRamp::testLinearRamp()
+{
+    GainRamp ramp(0.0f);
+    ramp.rampTo(1.0f, 100);
+    QVERIFY(ramp.isRamping());
+
+    const std::vector<float> result = gains(ramp, 120);
+    QCOMPARE(int(result.size()), 120);
+    for (int i = 0; i < 100; ++i) {
+        QVERIFY(qAbs(result[size_t(i)] - float(i + 1) / 100.0f) < 1e-5f);
+    }
+    for (int i = 100; i < 120; ++i) {
+        QCOMPARE(result[size_t(i)], 1.0f);
+    }
+    QVERIFY(!ramp.isRamping());
+    QCOMPARE(ramp.gain(), 1.0f);
+}
+
+void TestGainRamp::testExponentialRamp()
+{
+    // 20 dB in 640 frames: every segment of 64 frames moves 2 dB
+    GainRamp ramp(1.0f);
+    ramp.rampTo(0.1f, 640, GainRamp::Curve::Exponential);
+    const std::vector<float> result = gains(ramp, 640);
+    QCOMPARE(int(result.size()), 640);
+
+    for (int segment = 1; segment <= 10; ++segment) {
+        const float expected = std::pow(10.0f, -2.0f * segment / 20.0f);
+        QVERIFY(qAbs(result[size_t(segment * GainRamp::SEGMENT_FRAMES - 1)] - expected) < 1e-4f);
+    }
+    for (size_t i = 1; i < result.size(); ++i) {
+        QVERIFY(result[i] < result[i - 1]);
+    }
+    QCOMPARE(ramp.gain(), 0.1f);
+}
+
+void TestGainRamp::testExponentialToSilence()
+{
+    GainRamp ramp(1.0f);
+    ramp.rampTo(0.0f, 1000, GainRamp::Curve::Exponential);
+    const std::vector<float> result = gains(ramp, 1000);
+    QCOMPARE(result.back(), 0.0f);
+    QVERIFY(result[size_t(999 - GainRamp::SEGMENT_FRAMES)] <= 0.001f);
+
+    // And back up from silence
+    ramp.rampTo(1.0f, 1000, GainRamp::Curve::Exponential);
+    const std::vector<float> up = gains(ramp, 1000);
+    QVERIFY(up.front() > 0.0f);
+    QVERIFY(up[size_t(GainRamp::SEGMENT_FRAMES)] < 0.001f);
+    QCOMPARE(up.back(), 1.0f);
+}
+
+void TestGainRamp::testRampAcrossBlocks()
+{
+    GainRamp whole(1.0f);
+    whole.rampTo(0.0f, 500);
+    const std::vector<float> expected = gains(whole, 500);
+
+    // The same ramp in blocks that do not line up with its segments
+    GainRamp split(1.0f);
+    split.rampTo(0.0f, 500);
+    std::vector<float> result;
+    for (int block : {37, 100, 1, 250, 112}) {
+        const std::vector<float> part = gains(split, block);
+        result.insert(result.end(), part.begin(), part.end());
+    }
+    QCOMPARE(int(result.size()), 500);
+    for (size_t i = 0; i < result.size(); ++i) {
+        QVERIFY(qAbs(result[i] - expected[i]) < 1e-5f);
+    }
+    QCOMPARE(result.back(), 0.0f);
+}
+
+void TestGainRamp::testMatchesScalar_data()
+{
+    QTest::addColumn<int>("channels");
+    QTest::addColumn<int>("frames");
+
+    for (int channels : {1, 2, 3, 4}) {
+        // Lengths that leave a tail after the last full vector
+        for (int frames : {1, 7, 9, 64, 4801}) {
+            QTest::addRow("%d channels, %d frames", channels, frames) << channels << frames;
+        }
+    }
+}
+
+void TestGainRamp::testMatchesScalar()
+{
+    QFETCH(int, channels);
+    QFETCH(int, frames);
+
+    QRandomGenerator random(42);
+    std::vector<float> vector(size_t(frames * channels));
+    for (float& sample : vector) {
+        sample = float(random.generateDouble() * 2.0 - 1.0);
+    }
+    std::vector<float> scalar = vector;
+
+    const float start = 0.9f;
+    const float step = -0.5f / float(frames);
+    GainRamp::apply(vector.data(), frames, channels, start, step);
+    GainRamp::applyScalar(scalar.data(), frames, channels, start, step);
+    for (size_t i = 0; i < vector.size(); ++i) {
+        QVERIFY(qAbs(vector[i] - scalar[i]) <= 1e-6f);
+    }
+}
+
+QTEST_MAIN(TestGainRamp)
@@ -0,0 +1,31 @@
+#ifndef TESTGAINRAMP_H
+#define TESTGAINRAMP_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for GainRamp class
+ *
+ * Tests the gain applied on the audio thread including:
+ * - Constant gains and jumps
+ * - Linear ramps moving a little on every frame and landing on the target
+ * - Exponential ramps moving evenly in decibels, to and from silence
+ * - Ramps spread over several blocks
+ * - The vector code matching the scalar loop
+ */
+class TestGainRamp : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testConstantGain();
+    void testLinearRamp();
+    void testExponentialRamp();
+    void testExponentialToSilence();
+    void testRampAcrossBlocks();
+    void testMatchesScalar_data();
+    void testMatchesScalar();
+};
+
+#endif // TESTGAINRAMP_H
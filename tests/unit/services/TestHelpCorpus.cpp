@@ -0,0 +1,201 @@
+#include "TestHelpCorpus.h"
+#include "../../../src/services/HelpCorpus.h"
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QTemporaryDir>
+
+namespace {
+
+QJsonObject manifest()
+{
+    return QJsonDocument::fromJson(R"({
+        "topics": [
+            { "id": "volume", "title": "Volume", "category": "PlayerControls", "priority": 50,
+              "keywords": ["loudness"], "contextWidget": "QSlider",
+              "content": "<p>Use <b>Ctrl+Up</b> &amp; Ctrl+Down to change the volume.</p>" },
+            { "id": "playback", "title": "Playback", "category": "PlayerControls", "priority": 90,
+              "keywords": ["play", "pause"],
+              "content": "<p>Space starts playback. The volume is kept.</p>" },
+            { "id": "library", "title": "Music Library", "category": "DatabaseManagement",
+              "priority": 70, "relatedTopics": ["playback"],
+              "content": "<p>Keys to browse the library.</p>" }
+        ],
+        "tutorials": [
+            { "id": "first", "title": "First steps", "category": "GettingStarted",
+              "steps": [ { "title": "Tab", "instruction": "Press Tab", "keys": "Tab",
+                           "waitForUserAction": true },
+                         { "title": "Help", "instruction": "Press F1", "keys": "F1" } ] }
+        ],
+        "contexts": [
+            { "contextId": "QTableView", "helpContentId": "library", "priority": 85,
+              "autoTrigger": true, "autoTriggerDelay": 2 },
+            { "contextId": "QLineEdit", "helpContentId": "text_input_help" }
+        ]
+    })").object();
+}
+
+QByteArray compiled()
+{
+    QString error;
+    const QByteArray data = HelpCorpus::compile(manifest(), QString(), &error);
+    if (data.isEmpty()) {
+        qWarning() << error;
+    }
+    return data;
+}
+
+} // namespace
+
+void TestHelpCorpus::testTopics()
+{
+    HelpCorpus corpus;
+    QVERIFY(corpus.openData(compiled()));
+    QCOMPARE(corpus.topicCount(), 3);
+
+    const HelpCorpus::Topic volume = corpus.topic("volume");
+    QCOMPARE(volume.title, QString("Volume"));
+    QCOMPARE(volume.category, int(HelpCorpus::categoryNames().indexOf("PlayerControls")));
+    QCOMPARE(volume.priority, 50);
+    QCOMPARE(volume.keywords, QStringList({"loudness"}));
+    QCOMPARE(volume.contextWidget, QString("QSlider"));
+    QVERIFY(volume.content.contains("<b>Ctrl+Up</b>"));
+
+    QCOMPARE(corpus.topic("library").relatedTopics, QStringList({"playback"}));
+    QVERIFY(corpus.topic("missing").id.isEmpty());
+    QVERIFY(corpus.topic(QString()).id.isEmpty());
+
+    // Kept sorted by id for the lookup
+    QCOMPARE(corpus.topicAt(0).id, QString("library"));
+    QCOMPARE(corpus.topicAt(2).id, QString("volume"));
+}
+
+void TestHelpCorpus::testTopicFromFile()
+{
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+    QDir(directory.path()).mkdir("topics");
+    QFile html(directory.filePath("topics/welcome.html"));
+    QVERIFY(html.open(QIODevice::WriteOnly));
+    html.write("<h1>Welcome</h1><p>Bienvenue \xc3\xa0 XFB</p>");
+    html.close();
+
+    QJsonObject topic{{"id", "welcome"},
+                      {"title", "Welcome"},
+                      {"category", "GettingStarted"},
+                      {"file", "topics/welcome.html"}};
+    QJsonObject withFile{{"topics", QJsonArray{topic}}};
+
+    HelpCorpus corpus;
+    QVERIFY(corpus.openData(HelpCorpus::compile(withFile, directory.path())));
+    QCOMPARE(corpus.topic("welcome").content,
+             QString::fromUtf8("<h1>Welcome</h1><p>Bienvenue à XFB</p>"));
+    QCOMPARE(corpus.search("bienvenue"), QStringList({"welcome"}));
+
+    topic["file"] = "topics/missing.html";
+    QString error;
+    const QJsonObject missing{{"topics", QJsonArray{topic}}};
+    QVERIFY(HelpCorpus::compile(missing, directory.path(), &error).isEmpty());
+    QVERIFY(error.contains("missing.html"));
+}
+
+void TestHelpCorpus::testSearch()
+{
+    HelpCorpus corpus;
+    QVERIFY(corpus.openData(compiled()));
+
+    // Both mention the volume; playback has the higher priority
+    QCOMPARE(corpus.search("volume"), QStringList({"playback", "volume"}));
+    // Matching both words beats priority
+    QCOMPARE(corpus.search("volume ctrl"), QStringList({"volume", "playback"}));
+    // Words match the terms they are a prefix of, whatever the case
+    QCOMPARE(corpus.search("LOUD"), QStringList({"volume"}));
+    QCOMPARE(corpus.search("libr"), QStringList({"library"}));
+    // Tags and entities are not words
+    QVERIFY(corpus.search("amp").isEmpty());
+    QVERIFY(corpus.search("nothing here").isEmpty());
+    QVERIFY(corpus.search("  ").isEmpty());
+
+    QCOMPARE(HelpCorpus::tokens("<p>Ctrl+Up &amp; Down</p>"), QStringList({"ctrl", "up", "down"}));
+}
+
+void TestHelpCorpus::testCategoriesAndContexts()
+{
+    HelpCorpus corpus;
+    QVERIFY(corpus.openData(compiled()));
+
+    const int playerControls = int(HelpCorpus::categoryNames().indexOf("PlayerControls"));
+    QCOMPARE(corpus.topicsInCategory(playerControls), QStringList({"playback", "volume"}));
+    const int advanced = int(HelpCorpus::categoryNames().indexOf("Advanced"));
+    QVERIFY(corpus.topicsInCategory(advanced).isEmpty());
+
+    QCOMPARE(corpus.contextTopic("QSlider"), QString("volume"));
+    QVERIFY(corpus.contextTopic("QTableView").isEmpty());
+}
+
+void TestHelpCorpus::testTutorialsAndContextMappings()
+{
+    HelpCorpus corpus;
+    QVERIFY(corpus.openData(compiled()));
+
+    const int gettingStarted = int(HelpCorpus::categoryNames().indexOf("GettingStarted"));
+    QCOMPARE(corpus.tutorialIds(gettingStarted), QStringList({"first"}));
+    const HelpCorpus::Tutorial tutorial = corpus.tutorial("first");
+    QCOMPARE(tutorial.title, QString("First steps"));
+    QCOMPARE(tutorial.steps.size(), 2);
+    QCOMPARE(tutorial.steps.at(0).keys, QString("Tab"));
+    QVERIFY(tutorial.steps.at(0).waitForUserAction);
+    QVERIFY(!tutorial.steps.at(1).waitForUserAction);
+    QVERIFY(corpus.tutorial("missing").id.isEmpty());
+
+    const QList<HelpCorpus::ContextMapping> mappings = corpus.contextMappings();
+    QCOMPARE(mappings.size(), 2);
+    QCOMPARE(mappings.at(0).contextId, QString("QTableView"));
+    QCOMPARE(mappings.at(0).helpContentId, QString("library"));
+    QVERIFY(mappings.at(0).autoTrigger);
+    QCOMPARE(mappings.at(0).autoTriggerDelay, 2);
+    QCOMPARE(mappings.at(1).autoTriggerDelay, 5);
+}
+
+void TestHelpCorpus::testRejectsBadData()
+{
+    const QByteArray data = compiled();
+    QVERIFY(!data.isEmpty());
+
+    HelpCorpus corpus;
+    QByteArray badMagic = data;
+    badMagic[0] = 'x';
+    QVERIFY(!corpus.openData(badMagic));
+    QVERIFY(!corpus.isOpen());
+    QVERIFY(!corpus.errorString().isEmpty());
+
+    QVERIFY(!corpus.openData(data.left(data.size() / 2)));
+    QVERIFY(!corpus.openData(QByteArray()));
+    QVERIFY(!corpus.open(QDir::temp().filePath("no-such-help.bin")));
+    QVERIFY(corpus.search("volume").isEmpty());
+    QVERIFY(corpus.topic("volume").id.isEmpty());
+
+    QString error;
+    QJsonObject unknown{{"topics", QJsonArray{QJsonObject{{"id", "x"}, {"category", "Nope"}}}}};
+    QVERIFY(HelpCorpus::compile(unknown, QString(), &error).isEmpty());
+    QVERIFY(!error.isEmpty());
+}
+
+void TestHelpCorpus::testShippedManifest()
+{
+    QFile file(QStringLiteral(XFB_HELP_SOURCE_DIR "/help.json"));
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QJsonObject shipped = QJsonDocument::fromJson(file.readAll()).object();
+
+    QString error;
+    HelpCorpus corpus;
+    QVERIFY2(corpus.openData(HelpCorpus::compile(shipped, XFB_HELP_SOURCE_DIR, &error)),
+             qPrintable(error));
+    QVERIFY(!corpus.topic("keyboard_shortcuts_reference").content.isEmpty());
+    QCOMPARE(corpus.contextTopic("player"), QString("player_controls_overview"));
+    QVERIFY(corpus.search("keyboard shortcuts").contains("keyboard_shortcuts_reference"));
+    QVERIFY(!corpus.tutorial("player_controls_tutorial").steps.isEmpty());
+}
+
+QTEST_MAIN(TestHelpCorpus)
@@ -0,0 +1,32 @@
+#ifndef TESTHELPCORPUS_H
+#define TESTHELPCORPUS_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for HelpCorpus class
+ *
+ * Tests the compiled help corpus including:
+ * - Topics compiled from a manifest, inline or from their files, found by id
+ * - Search by word prefixes, ranked by words matched then priority
+ * - Topics by category and context widget
+ * - Tutorials and context mappings read from the extras
+ * - Bad or truncated data refused
+ * - The shipped manifest compiling
+ */
+class TestHelpCorpus : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testTopics();
+    void testTopicFromFile();
+    void testSearch();
+    void testCategoriesAndContexts();
+    void testTutorialsAndContextMappings();
+    void testRejectsBadData();
+    void testShippedManifest();
+};
+
+#endif // TESTHELPCORPUS_H
@@ -0,0 +1,310 @@
+#include "TestHlsSegmenter.h"
+#include "../../../src/services/HlsSegmenter.h"
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QHostAddress>
+#include <QSignalSpy>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+#include <QtEndian>
+
+namespace {
+
+constexpr quint32 TIMESCALE = 48000;
+constexpr quint32 FRAME = 960;   // 20 ms
+
+QByteArray be32(quint32 value)
+{
+    char bytes[4];
+    qToBigEndian(value, bytes);
+    return QByteArray(bytes, 4);
+}
+
+QByteArray box(const char* type, const QByteArray& payload)
+{
+    return be32(quint32(8 + payload.size())) + QByteArray(type, 4) + payload;
+}
+
+QByteArray fullBox(const char* type, quint32 flags, const QByteArray& payload)
+{
+    return box(type, be32(flags & 0xffffff) + payload);
+}
+
+QByteArray init()
+{
+    const QByteArray mdhd = fullBox("mdhd", 0, be32(0) + be32(0) + be32(TIMESCALE) + be32(0)
+                                                   + be32(0));
+    const QByteArray trex = fullBox("trex", 0, be32(1) + be32(1) + be32(FRAME) + be32(0) + be32(0));
+    const QByteArray moov = box("moov", fullBox("mvhd", 0, QByteArray(96, '\0'))
+                                            + box("trak", box("mdia", mdhd))
+                                            + box("mvex", trex));
+    return box("ftyp", "iso6" + be32(0) + "iso6dash") + moov;
+}
+
+// A fragment of frames of FRAME ticks, from the trex default unless listed
+QByteArray fragment(int frames, const QList<quint32>& durations = {})
+{
+    QByteArray trun;
+    if (durations.isEmpty()) {
+        trun = fullBox("trun", 0x200, be32(quint32(frames)) + QByteArray(frames * 4, '\x10'));
+    } else {
+        QByteArray samples;
+        for (quint32 duration : durations) {
+            samples += be32(duration) + be32(16);
+        }
+        trun = fullBox("trun", 0x300, be32(quint32(durations.size())) + samples);
+    }
+    const QByteArray traf = box("traf", fullBox("tfhd", 0x020000, be32(1))
+                                            + fullBox("tfdt", 0, be32(0)) + trun);
+    const QByteArray moof = box("moof", fullBox("mfhd", 0, be32(1)) + traf);
+    return moof + box("mdat", QByteArray(frames * 16, 'a'));
+}
+
+// Write in small pieces, so boxes arrive split
+void feed(HlsSegmenter& hls, const QByteArray& data)
+{
+    for (qsizetype i = 0; i < data.size(); i += 37) {
+        hls.write(data.mid(i, 37));
+    }
+}
+
+QByteArray readFile(const QString& path)
+{
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+/// Takes PUT and DELETE requests and keeps them.
+class FakeOrigin
+{
+public:
+    struct Request {
+        QString method;
+        QString path;
+        QByteArray body;
+    };
+
+    FakeOrigin()
+    {
+        m_server.listen(QHostAddress::LocalHost);
+        QObject::connect(&m_server, &QTcpServer::newConnection, &m_server, [this]() {
+            while (QTcpSocket* socket = m_server.nextPendingConnection()) {
+                QObject::connect(socket, &QTcpSocket::readyRead, socket,
+                                 [this, socket]() { read(socket); });
+            }
+        });
+    }
+
+    quint16 port() const { return m_server.serverPort(); }
+
+    QList<Request> requests;
+
+private:
+    void read(QTcpSocket* socket)
+    {
+        QByteArray& buffer = m_buffers[socket];
+        buffer += socket->readAll();
+        for (;;) {
+            const qsizetype end = buffer.indexOf("\r\n\r\n");
+            if (end < 0) {
+                return;
+            }
+            const QStringList lines = QString::fromUtf8(buffer.left(end)).split("\r\n");
+            qsizetype length = 0;
+            for (const QString& line : lines) {
+                if (line.startsWith("Content-Length:", Qt::CaseInsensitive)) {
+                    length = line.section(':', 1).trimmed().toLongLong();
+                }
+            }
+            if (buffer.size() < end + 4 + length) {
+                return;
+            }
+            requests.append({lines.first().section(' ', 0, 0), lines.first().section(' ', 1, 1),
+                             buffer.mid(end + 4, length)});
+            buffer.remove(0, end + 4 + length);
+            socket->write("HTTP/1.1 201 Created\r\nContent-Length: 0\r\n\r\n");
+        }
+    }
+
+    QTcpServer m_server;
+    QHash<QTcpSocket*, QByteArray> m_buffers;
+};
+
+} // namespace
+
+void TestHlsSegmenter::testSegmentsAndPlaylist()
+{
+    QTemporaryDir dir;
+    HlsSegmenter hls;
+    QVERIFY(hls.setTarget(dir.filePath("hls")));
+    hls.setSegmentMs(2000);
+    QSignalSpy writtenSpy(&hls, &HlsSegmenter::segmentWritten);
+
+    // 50 frames of 20 ms are one second
+    const QByteArray head = init();
+    const QByteArray second = fragment(50);
+    feed(hls, head + second + second + second + second + second);
+
+    QCOMPARE(writtenSpy.count(), 2);
+    QCOMPARE(writtenSpy.first().at(0).toString(), QString("segment0.m4s"));
+    QCOMPARE(writtenSpy.first().at(1).toLongLong(), qint64(2000));
+    QCOMPARE(hls.nextSequence(), qint64(2));
+
+    const QDir out(dir.filePath("hls"));
+    QCOMPARE(readFile(out.filePath("init1.mp4")), head);
+    QCOMPARE(readFile(out.filePath("segment0.m4s")), second + second);
+    QCOMPARE(readFile(out.filePath("segment1.m4s")), second + second);
+    QVERIFY(!out.exists("segment2.m4s"));
+
+    const QString playlist = QString::fromUtf8(readFile(out.filePath("live.m3u8")));
+    QCOMPARE(playlist, hls.playlist());
+    QCOMPARE(playlist, QString("#EXTM3U\n#EXT-X-VERSION:7\n#EXT-X-TARGETDURATION:2\n"
+                               "#EXT-X-MEDIA-SEQUENCE:0\n#EXT-X-MAP:URI=\"init1.mp4\"\n"
+                               "#EXTINF:2.000,\nsegment0.m4s\n#EXTINF:2.000,\nsegment1.m4s\n"));
+
+    // The fifth second is cut once the sixth arrives
+    feed(hls, second);
+    QCOMPARE(writtenSpy.count(), 3);
+    QCOMPARE(readFile(out.filePath("segment2.m4s")), second + second);
+}
+
+void TestHlsSegmenter::testSampleDurations()
+{
+    QTemporaryDir dir;
+    HlsSegmenter hls;
+    QVERIFY(hls.setTarget(dir.path()));
+    hls.setSegmentMs(1000);
+    QSignalSpy writtenSpy(&hls, &HlsSegmenter::segmentWritten);
+
+    // 1.5 s in three samples, longer than the 20 ms default
+    feed(hls, init() + fragment(3, {24000, 24000, 24000}));
+    QCOMPARE(writtenSpy.count(), 1);
+    QCOMPARE(writtenSpy.first().at(1).toLongLong(), qint64(1500));
+    QVERIFY(hls.playlist().contains("#EXTINF:1.500,\nsegment0.m4s"));
+    QVERIFY(hls.playlist().contains("#EXT-X-TARGETDURATION:2\n"));
+}
+
+void TestHlsSegmenter::testRollingPlaylist()
+{
+    QTemporaryDir dir;
+    HlsSegmenter hls;
+    QVERIFY(hls.setTarget(dir.path()));
+    hls.setSegmentMs(1000);
+    hls.setPlaylistLength(2);
+
+    feed(hls, init());
+    for (int i = 0; i < 6; ++i) {
+        feed(hls, fragment(50));
+    }
+    QCOMPARE(hls.nextSequence(), qint64(6));
+
+    const QString playlist = hls.playlist();
+    QVERIFY(playlist.contains("#EXT-X-MEDIA-SEQUENCE:4\n"));
+    QVERIFY(!playlist.contains("segment3.m4s"));
+    QVERIFY(playlist.contains("segment4.m4s"));
+    QVERIFY(playlist.contains("segment5.m4s"));
+
+    // Two segments stay behind for players still fetching them
+    const QDir out(dir.path());
+    QVERIFY(!out.exists("segment0.m4s"));
+    QVERIFY(!out.exists("segment1.m4s"));
+    QVERIFY(out.exists("segment2.m4s"));
+    QVERIFY(out.exists("segment3.m4s"));
+    QVERIFY(out.exists("init1.mp4"));
+}
+
+void TestHlsSegmenter::testResetMarksDiscontinuity()
+{
+    QTemporaryDir dir;
+    HlsSegmenter hls;
+    QVERIFY(hls.setTarget(dir.path()));
+    hls.setSegmentMs(1000);
+    hls.setPlaylistLength(3);
+
+    feed(hls, init() + fragment(50) + fragment(50));
+    // Half a fragment of the old encoder is dropped
+    feed(hls, fragment(50).left(40));
+    hls.reset();
+    feed(hls, init() + fragment(50));
+
+    const QString playlist = hls.playlist();
+    QVERIFY(playlist.endsWith("segment1.m4s\n#EXT-X-DISCONTINUITY\n#EXT-X-MAP:URI=\"init2.mp4\"\n"
+                              "#EXTINF:1.000,\nsegment2.m4s\n"));
+    QVERIFY(QDir(dir.path()).exists("init2.mp4"));
+
+    // Once its segments are gone, so is the first init segment
+    for (int i = 0; i < 5; ++i) {
+        feed(hls, fragment(50));
+    }
+    QVERIFY(!hls.playlist().contains("DISCONTINUITY\n"));
+    QVERIFY(hls.playlist().contains("#EXT-X-DISCONTINUITY-SEQUENCE:1\n"));
+    QVERIFY(!QDir(dir.path()).exists("init1.mp4"));
+    QVERIFY(QDir(dir.path()).exists("init2.mp4"));
+}
+
+void TestHlsSegmenter::testRejectsOtherStreams()
+{
+    QTemporaryDir dir;
+    HlsSegmenter hls;
+    QVERIFY(hls.setTarget(dir.path()));
+    QSignalSpy errorSpy(&hls, &HlsSegmenter::operationError);
+
+    hls.write(QByteArray(4, '\0') + "ID3\x03" + QByteArray(64, 'x'));
+    QCOMPARE(errorSpy.count(), 1);
+    // Nothing more is looked at until the encoder is started again
+    hls.write(init() + fragment(400));
+    QCOMPARE(errorSpy.count(), 1);
+    QCOMPARE(hls.nextSequence(), qint64(0));
+
+    hls.reset();
+    hls.setSegmentMs(1000);
+    hls.write(init() + fragment(50));
+    QCOMPARE(hls.nextSequence(), qint64(1));
+}
+
+void TestHlsSegmenter::testUploads()
+{
+    FakeOrigin origin;
+    HlsSegmenter hls;
+    QVERIFY(hls.setTarget(QString("http://127.0.0.1:%1/radio/").arg(origin.port())));
+    hls.setSegmentMs(1000);
+    hls.setPlaylistLength(1);
+    QSignalSpy errorSpy(&hls, &HlsSegmenter::operationError);
+
+    const QByteArray second = fragment(50);
+    feed(hls, init() + second);
+    QTRY_COMPARE_WITH_TIMEOUT(origin.requests.size(), 3, 5000);
+    const auto find = [&origin](const QString& path) {
+        for (int i = 0; i < origin.requests.size(); ++i) {
+            if (origin.requests[i].path == path) {
+                return i;
+            }
+        }
+        return -1;
+    };
+    const int initRequest = find("/radio/init1.mp4");
+    const int segmentRequest = find("/radio/segment0.m4s");
+    const int playlistRequest = find("/radio/live.m3u8");
+    QVERIFY(initRequest >= 0 && segmentRequest >= 0);
+    QCOMPARE(origin.requests[initRequest].method, QString("PUT"));
+    QCOMPARE(origin.requests[initRequest].body, init());
+    QCOMPARE(origin.requests[segmentRequest].body, second);
+    // The playlist follows the segment it lists
+    QVERIFY(playlistRequest > segmentRequest);
+    QVERIFY(origin.requests[playlistRequest].body.contains("segment0.m4s"));
+
+    for (int i = 0; i < 3; ++i) {
+        feed(hls, second);
+    }
+    QTRY_VERIFY_WITH_TIMEOUT(hls.pendingUploads() == 0 && origin.requests.size() >= 10, 5000);
+    bool deleted = false;
+    for (const FakeOrigin::Request& request : std::as_const(origin.requests)) {
+        deleted = deleted || (request.method == "DELETE" && request.path == "/radio/segment0.m4s");
+    }
+    QVERIFY(deleted);
+    QCOMPARE(errorSpy.count(), 0);
+}
+
+QTEST_MAIN(TestHlsSegmenter)
@@ -0,0 +1,31 @@
+#ifndef TESTHLSSEGMENTER_H
+#define TESTHLSSEGMENTER_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for HlsSegmenter class
+ *
+ * Tests the HLS output including:
+ * - The init segment, segments and playlist written from fragmented MP4
+ * - Lengths read from sample durations and from the defaults
+ * - The rolling playlist and the deleting of old segments
+ * - A restarted encoder marked as a discontinuity
+ * - Output that is not fragmented MP4
+ * - Uploading to an HTTP target
+ */
+class TestHlsSegmenter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testSegmentsAndPlaylist();
+    void testSampleDurations();
+    void testRollingPlaylist();
+    void testResetMarksDiscontinuity();
+    void testRejectsOtherStreams();
+    void testUploads();
+};
+
+#endif // TESTHLSSEGMENTER_H
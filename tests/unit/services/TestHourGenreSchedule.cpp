@@ -0,0 +1,113 @@
+#include "TestHourGenreSchedule.h"
+#include "../../../src/services/HourGenreSchedule.h"
+#include <QSqlQuery>
+
+namespace {
+
+const char* CONNECTION_NAME = "test_hour_genre_connection";
+
+} // namespace
+
+void TestHourGenreSchedule::init()
+{
+    m_tempDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_tempDir->isValid());
+
+    m_database = QSqlDatabase::addDatabase("QSQLITE", CONNECTION_NAME);
+    m_database.setDatabaseName(m_tempDir->path() + "/hourgenre.db");
+    QVERIFY(m_database.open());
+
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("CREATE TABLE hourgenre (id INTEGER PRIMARY KEY AUTOINCREMENT, "
+                       "day TEXT, hour TEXT, genre TEXT)"));
+}
+
+void TestHourGenreSchedule::cleanup()
+{
+    if (m_database.isOpen()) {
+        m_database.close();
+    }
+    m_database = QSqlDatabase();
+    QSqlDatabase::removeDatabase(CONNECTION_NAME);
+    m_tempDir.reset();
+}
+
+void TestHourGenreSchedule::testLookup()
+{
+    insertRow("1", "0", "Jazz");
+    insertRow("5", "22", "Dance");
+
+    HourGenreSchedule schedule(m_database);
+    QCOMPARE(schedule.genreAt(1, 0), QString("Jazz"));
+    QCOMPARE(schedule.genreAt(5, 22), QString("Dance"));
+    QCOMPARE(schedule.genreAt(5, 21), QString());
+
+    // 2024-05-17 was a Friday
+    QCOMPARE(schedule.genreAt(QDateTime(QDate(2024, 5, 17), QTime(22, 45))), QString("Dance"));
+}
+
+void TestHourGenreSchedule::testLatestRowWins()
+{
+    insertRow("3", "8", "Rock");
+    insertRow("3", "8", "Pop");
+
+    HourGenreSchedule schedule(m_database);
+    QCOMPARE(schedule.genreAt(3, 8), QString("Pop"));
+}
+
+void TestHourGenreSchedule::testInvalidSlot()
+{
+    insertRow("9", "30", "Nonsense");
+
+    HourGenreSchedule schedule(m_database);
+    QVERIFY(schedule.reload());
+    QCOMPARE(schedule.genreAt(0, 10), QString());
+    QCOMPARE(schedule.genreAt(8, 10), QString());
+    QCOMPARE(schedule.genreAt(1, 24), QString());
+    QVERIFY(!schedule.setGenre(1, -1, "Rock"));
+}
+
+void TestHourGenreSchedule::testSetGenre()
+{
+    insertRow("2", "14", "Rock");
+    insertRow("2", "14", "Blues");
+
+    HourGenreSchedule schedule(m_database);
+    QVERIFY(schedule.setGenre(2, 14, "Reggae"));
+    QCOMPARE(schedule.genreAt(2, 14), QString("Reggae"));
+
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("SELECT COUNT(*) FROM hourgenre WHERE day = '2' AND hour = '14'"));
+    QVERIFY(query.next());
+    QCOMPARE(query.value(0).toInt(), 1);
+
+    QVERIFY(schedule.setGenre(2, 14, QString()));
+    QCOMPARE(schedule.genreAt(2, 14), QString());
+
+    HourGenreSchedule fresh(m_database);
+    QCOMPARE(fresh.genreAt(2, 14), QString());
+}
+
+void TestHourGenreSchedule::testInvalidate()
+{
+    HourGenreSchedule schedule(m_database);
+    QCOMPARE(schedule.genreAt(7, 20), QString());
+
+    insertRow("7", "20", "Classical");
+    QCOMPARE(schedule.genreAt(7, 20), QString());
+
+    schedule.invalidate();
+    QCOMPARE(schedule.genreAt(7, 20), QString("Classical"));
+}
+
+void TestHourGenreSchedule::insertRow(const QString& day, const QString& hour, const QString& genre)
+{
+    QSqlQuery query(m_database);
+    query.prepare("INSERT INTO hourgenre (day, hour, genre) VALUES (?, ?, ?)");
+    query.addBindValue(day);
+    query.addBindValue(hour);
+    query.addBindValue(genre);
+    QVERIFY(query.exec());
+}
+
+QTEST_MAIN(TestHourGenreSchedule)
@@ -0,0 +1,39 @@
+#ifndef TESTHOURGENRESCHEDULE_H
+#define TESTHOURGENRESCHEDULE_H
+
+#include <QObject>
+#include <QTest>
+#include <QSqlDatabase>
+#include <QTemporaryDir>
+#include <memory>
+
+/**
+ * @brief Unit tests for HourGenreSchedule class
+ *
+ * Tests the cached hour/day genre table including:
+ * - Slot lookups by day and hour, and by date/time
+ * - Duplicate rows for one slot and out of range slots
+ * - Writes through setGenre() and reloads after invalidate()
+ */
+class TestHourGenreSchedule : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testLookup();
+    void testLatestRowWins();
+    void testInvalidSlot();
+    void testSetGenre();
+    void testInvalidate();
+
+private:
+    void insertRow(const QString& day, const QString& hour, const QString& genre);
+
+    std::unique_ptr<QTemporaryDir> m_tempDir;
+    QSqlDatabase m_database;
+};
+
+#endif // TESTHOURGENRESCHEDULE_H
@@ -0,0 +1,182 @@
+#include "TestIcecastMetadata.h"
+#include "../../../src/services/IcecastMetadata.h"
+#include <QHash>
+#include <QHostAddress>
+#include <QList>
+#include <QSignalSpy>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QUrlQuery>
+
+namespace {
+
+/// Answers admin metadata requests the way Icecast does and keeps them.
+class FakeAdminServer
+{
+public:
+    struct Request {
+        QString path;
+        QUrlQuery query;
+        QString authorization;
+    };
+
+    FakeAdminServer()
+    {
+        m_server.listen(QHostAddress::LocalHost);
+        QObject::connect(&m_server, &QTcpServer::newConnection, &m_server, [this]() {
+            while (QTcpSocket* socket = m_server.nextPendingConnection()) {
+                ++connections;
+                QObject::connect(socket, &QTcpSocket::readyRead, socket,
+                                 [this, socket]() { read(socket); });
+            }
+        });
+    }
+
+    quint16 port() const { return m_server.serverPort(); }
+
+    QList<Request> requests;
+    int connections = 0;
+    bool accepts = true;
+
+private:
+    void read(QTcpSocket* socket)
+    {
+        QByteArray& buffer = m_buffers[socket];
+        buffer += socket->readAll();
+        qsizetype end;
+        while ((end = buffer.indexOf("\r\n\r\n")) >= 0) {
+            const QStringList lines = QString::fromUtf8(buffer.left(end)).split("\r\n");
+            buffer.remove(0, end + 4);
+
+            Request request;
+            const QString target = lines.first().section(' ', 1, 1);
+            request.path = target.section('?', 0, 0);
+            request.query = QUrlQuery(target.section('?', 1));
+            for (const QString& line : lines) {
+                if (line.startsWith("Authorization:", Qt::CaseInsensitive)) {
+                    request.authorization = line.section(':', 1).trimmed();
+                }
+            }
+            requests.append(request);
+
+            const QByteArray body =
+                accepts ? "<iceresponse><message>Metadata update successful</message>"
+                          "<return>1</return></iceresponse>"
+                        : "<iceresponse><message>Mountpoint will not accept URL updates</message>"
+                          "<return>0</return></iceresponse>";
+            socket->write("HTTP/1.1 200 OK\r\nContent-Type: text/xml\r\nContent-Length: "
+                          + QByteArray::number(body.size()) + "\r\n\r\n" + body);
+        }
+    }
+
+    QTcpServer m_server;
+    QHash<QTcpSocket*, QByteArray> m_buffers;
+};
+
+} // namespace
+
+void TestIcecastMetadata::testPushesTitle()
+{
+    FakeAdminServer server;
+    IcecastMetadata metadata;
+    metadata.setServer("127.0.0.1", server.port(), "hackme");
+    metadata.setMounts({"live.mp3", " /backup.mp3", "/live.mp3"});
+    QCOMPARE(metadata.mounts(), QStringList({"/live.mp3", "/backup.mp3"}));
+
+    QSignalSpy sentSpy(&metadata, &IcecastMetadata::titleSent);
+    metadata.setTitle("Simon + Garfunkel - The Boxer & more");
+    QVERIFY(metadata.isPending());
+    QTRY_COMPARE_WITH_TIMEOUT(sentSpy.count(), 2, 5000);
+    QVERIFY(!metadata.isPending());
+
+    QCOMPARE(server.requests.size(), 2);
+    const FakeAdminServer::Request request = server.requests.first();
+    QCOMPARE(request.path, QString("/admin/metadata"));
+    QCOMPARE(request.query.queryItemValue("mode"), QString("updinfo"));
+    QCOMPARE(request.query.queryItemValue("mount", QUrl::FullyDecoded), QString("/live.mp3"));
+    QCOMPARE(request.query.queryItemValue("song", QUrl::FullyDecoded),
+             QString("Simon + Garfunkel - The Boxer & more"));
+    QCOMPARE(request.authorization, QString("Basic " + QByteArray("source:hackme").toBase64()));
+    QCOMPARE(server.requests.last().query.queryItemValue("mount", QUrl::FullyDecoded),
+             QString("/backup.mp3"));
+
+    // The same title is not sent twice
+    metadata.setTitle("Simon + Garfunkel - The Boxer & more");
+    QVERIFY(!metadata.isPending());
+    QCOMPARE(metadata.requestsSent(), 2);
+}
+
+void TestIcecastMetadata::testCoalescesRapidChanges()
+{
+    FakeAdminServer server;
+    IcecastMetadata metadata;
+    metadata.setServer("127.0.0.1", server.port(), "hackme");
+    metadata.setMounts({"/live.mp3"});
+    metadata.setMinIntervalMs(200);
+
+    QSignalSpy sentSpy(&metadata, &IcecastMetadata::titleSent);
+    metadata.setTitle("One");
+    metadata.setTitle("Two");
+    metadata.setTitle("Three");
+    QCOMPARE(metadata.requestsSent(), 1);
+    QTRY_COMPARE_WITH_TIMEOUT(sentSpy.count(), 2, 5000);
+
+    QCOMPARE(server.requests.size(), 2);
+    QCOMPARE(server.requests[0].query.queryItemValue("song"), QString("One"));
+    QCOMPARE(server.requests[1].query.queryItemValue("song"), QString("Three"));
+    QCOMPARE(sentSpy.last().at(1).toString(), QString("Three"));
+
+    // Nothing is sent without a mount to send it to
+    metadata.setMounts({});
+    metadata.setTitle("Four");
+    QTest::qWait(300);
+    QCOMPARE(metadata.requestsSent(), 2);
+}
+
+void TestIcecastMetadata::testReusesConnection()
+{
+    FakeAdminServer server;
+    IcecastMetadata metadata;
+    metadata.setServer("127.0.0.1", server.port(), "hackme");
+    metadata.setMounts({"/live.mp3"});
+    metadata.setMinIntervalMs(0);
+
+    QSignalSpy sentSpy(&metadata, &IcecastMetadata::titleSent);
+    for (int i = 1; i <= 3; ++i) {
+        metadata.setTitle(QString("Track %1").arg(i));
+        QTRY_COMPARE_WITH_TIMEOUT(sentSpy.count(), i, 5000);
+    }
+    metadata.resend();
+    QTRY_COMPARE_WITH_TIMEOUT(sentSpy.count(), 4, 5000);
+    QCOMPARE(server.requests.size(), 4);
+    QCOMPARE(server.requests.last().query.queryItemValue("song"), QString("Track 3"));
+    QCOMPARE(server.connections, 1);
+}
+
+void TestIcecastMetadata::testRefusedUpdate()
+{
+    FakeAdminServer server;
+    server.accepts = false;
+    IcecastMetadata metadata;
+    metadata.setServer("127.0.0.1", server.port(), "hackme");
+    metadata.setMounts({"/live.ogg"});
+
+    QSignalSpy errorSpy(&metadata, &IcecastMetadata::operationError);
+    QSignalSpy sentSpy(&metadata, &IcecastMetadata::titleSent);
+    metadata.setTitle("Refused");
+    QTRY_COMPARE_WITH_TIMEOUT(errorSpy.count(), 1, 5000);
+    QCOMPARE(sentSpy.count(), 0);
+    QVERIFY(errorSpy.first().at(1).toString().contains("/live.ogg"));
+    QVERIFY(errorSpy.first().at(1).toString().contains("will not accept"));
+
+    // Nothing listens here
+    IcecastMetadata unreachable;
+    QSignalSpy unreachableSpy(&unreachable, &IcecastMetadata::operationError);
+    unreachable.setServer("127.0.0.1", 1, "hackme");
+    unreachable.setMounts({"/live.mp3"});
+    unreachable.setTitle("Lost");
+    QTRY_COMPARE_WITH_TIMEOUT(unreachableSpy.count(), 1, 10000);
+    QVERIFY(!unreachable.isPending());
+}
+
+QTEST_MAIN(TestIcecastMetadata)
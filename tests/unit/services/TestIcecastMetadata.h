@@ -0,0 +1,27 @@
+#ifndef TESTICECASTMETADATA_H
+#define TESTICECASTMETADATA_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for IcecastMetadata class
+ *
+ * Tests the Icecast metadata updates including:
+ * - The admin request, its credentials and the title's encoding
+ * - Folding rapid changes into the latest title
+ * - Keeping one connection across updates
+ * - Updates the server refuses
+ */
+class TestIcecastMetadata : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testPushesTitle();
+    void testCoalescesRapidChanges();
+    void testReusesConnection();
+    void testRefusedUpdate();
+};
+
+#endif // TESTICECASTMETADATA_H
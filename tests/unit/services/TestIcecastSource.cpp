@@ -0,0 +1,195 @@
+#include "TestIcecastSource.h"
+#include "../../../src/services/IcecastSource.h"
+#include <QHash>
+#include <QHostAddress>
+#include <QList>
+#include <QSignalSpy>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <memory>
+
+namespace {
+
+/// Accepts source connections the way Icecast does and keeps what they send.
+class FakeIcecastServer
+{
+public:
+    struct Request {
+        QString method;
+        QString mount;
+        QHash<QString, QString> headers;
+        QByteArray body;
+    };
+
+    FakeIcecastServer()
+    {
+        m_server.listen(QHostAddress::LocalHost);
+        QObject::connect(&m_server, &QTcpServer::newConnection, &m_server, [this]() {
+            while (QTcpSocket* socket = m_server.nextPendingConnection()) {
+                accept(socket);
+            }
+        });
+    }
+
+    quint16 port() const { return m_server.serverPort(); }
+
+    /// Close every source connection, as a restarting server would
+    void dropAll()
+    {
+        for (QTcpSocket* socket : m_sockets) {
+            socket->disconnectFromHost();
+        }
+        m_sockets.clear();
+    }
+
+    QList<std::shared_ptr<Request>> requests;
+    bool acceptsPut = true;
+    QString password = "hackme";
+
+private:
+    void accept(QTcpSocket* socket)
+    {
+        auto request = std::make_shared<Request>();
+        auto buffer = std::make_shared<QByteArray>();
+        m_sockets.append(socket);
+        QObject::connect(socket, &QTcpSocket::readyRead, socket, [this, socket, request, buffer]() {
+            if (!request->method.isEmpty()) {
+                request->body += socket->readAll();
+                return;
+            }
+            *buffer += socket->readAll();
+            const qsizetype end = buffer->indexOf("\r\n\r\n");
+            if (end < 0) {
+                return;
+            }
+
+            const QStringList lines = QString::fromUtf8(buffer->left(end)).split("\r\n");
+            const QStringList requestLine = lines.first().split(' ');
+            request->method = requestLine.value(0);
+            request->mount = requestLine.value(1);
+            for (int i = 1; i < lines.size(); ++i) {
+                const qsizetype colon = lines[i].indexOf(':');
+                request->headers.insert(lines[i].left(colon).toLower(), lines[i].mid(colon + 1).trimmed());
+            }
+            request->body = buffer->mid(end + 4);
+            requests.append(request);
+
+            const QByteArray expected = "Basic " + ("source:" + password).toUtf8().toBase64();
+            if (request->method == "PUT" && !acceptsPut) {
+                socket->write("HTTP/1.1 405 Method Not Allowed\r\n\r\n");
+                socket->disconnectFromHost();
+            } else if (request->headers.value("authorization").toUtf8() != expected) {
+                socket->write("HTTP/1.0 401 Authentication Required\r\n\r\n");
+                socket->disconnectFromHost();
+            } else if (request->method == "PUT") {
+                socket->write("HTTP/1.1 100 Continue\r\n\r\n");
+            } else {
+                socket->write("HTTP/1.0 200 OK\r\n\r\n");
+            }
+        });
+    }
+
+    QTcpServer m_server;
+    QList<QTcpSocket*> m_sockets;
+};
+
+} // namespace
+
+void TestIcecastSource::testPutHandshake()
+{
+    FakeIcecastServer server;
+    IcecastSource source;
+    source.setServer("127.0.0.1", server.port(), "live.mp3", "hackme");
+    source.setContentType("audio/mpeg");
+    IcecastSource::StreamInfo info;
+    info.name = "XFB Radio";
+    info.bitrateKbps = 128;
+    source.setStreamInfo(info);
+    QCOMPARE(source.mount(), QString("/live.mp3"));
+
+    QSignalSpy stateSpy(&source, &IcecastSource::stateChanged);
+    source.open();
+    QCOMPARE(source.state(), IcecastSource::State::Connecting);
+    QTRY_COMPARE_WITH_TIMEOUT(source.state(), IcecastSource::State::Streaming, 5000);
+    QCOMPARE(stateSpy.count(), 2);
+
+    QCOMPARE(server.requests.size(), 1);
+    const auto request = server.requests.first();
+    QCOMPARE(request->method, QString("PUT"));
+    QCOMPARE(request->mount, QString("/live.mp3"));
+    QCOMPARE(request->headers.value("content-type"), QString("audio/mpeg"));
+    QCOMPARE(request->headers.value("ice-name"), QString("XFB Radio"));
+    QCOMPARE(request->headers.value("ice-audio-info"), QString("bitrate=128"));
+    QCOMPARE(request->headers.value("expect"), QString("100-continue"));
+
+    source.write("frame-1");
+    source.write("frame-2");
+    QTRY_COMPARE_WITH_TIMEOUT(request->body, QByteArray("frame-1frame-2"), 5000);
+    QCOMPARE(source.bytesSent(), qint64(14));
+
+    source.close();
+    QCOMPARE(source.state(), IcecastSource::State::Disconnected);
+}
+
+void TestIcecastSource::testFallsBackToSourceMethod()
+{
+    FakeIcecastServer server;
+    server.acceptsPut = false;
+    IcecastSource source;
+    source.setServer("127.0.0.1", server.port(), "/live.ogg", "hackme");
+    source.open();
+
+    QTRY_COMPARE_WITH_TIMEOUT(source.state(), IcecastSource::State::Streaming, 5000);
+    QCOMPARE(server.requests.size(), 2);
+    QCOMPARE(server.requests[0]->method, QString("PUT"));
+    QCOMPARE(server.requests[1]->method, QString("SOURCE"));
+    QVERIFY(!server.requests[1]->headers.contains("expect"));
+}
+
+void TestIcecastSource::testWrongPassword()
+{
+    FakeIcecastServer server;
+    IcecastSource source;
+    source.setServer("127.0.0.1", server.port(), "/live.mp3", "wrong");
+
+    QSignalSpy errorSpy(&source, &IcecastSource::errorOccurred);
+    source.open();
+    QTRY_COMPARE_WITH_TIMEOUT(errorSpy.count(), 1, 5000);
+    QVERIFY(errorSpy.first().first().toString().contains("password"));
+
+    // It keeps trying until closed
+    QCOMPARE(source.state(), IcecastSource::State::Backoff);
+    source.close();
+    QCOMPARE(source.state(), IcecastSource::State::Disconnected);
+}
+
+void TestIcecastSource::testReconnectResendsHeader()
+{
+    FakeIcecastServer server;
+    IcecastSource source;
+    source.setServer("127.0.0.1", server.port(), "/live.ogg", "hackme");
+    source.setStreamHeader("OggS-header");
+    source.open();
+    QTRY_COMPARE_WITH_TIMEOUT(source.state(), IcecastSource::State::Streaming, 5000);
+    source.write("audio-1");
+    QTRY_COMPARE_WITH_TIMEOUT(server.requests.first()->body, QByteArray("OggS-headeraudio-1"), 5000);
+
+    server.dropAll();
+    QTRY_COMPARE_WITH_TIMEOUT(source.state(), IcecastSource::State::Backoff, 5000);
+    QTRY_COMPARE_WITH_TIMEOUT(source.state(), IcecastSource::State::Streaming,
+                              IcecastSource::MIN_RECONNECT_DELAY_MS + 5000);
+    QCOMPARE(server.requests.size(), 2);
+
+    source.write("audio-2");
+    QTRY_COMPARE_WITH_TIMEOUT(server.requests[1]->body, QByteArray("OggS-headeraudio-2"), 5000);
+}
+
+void TestIcecastSource::testDropsDataWhileDisconnected()
+{
+    IcecastSource source;
+    source.write("lost");
+    QCOMPARE(source.bytesSent(), qint64(0));
+    QCOMPARE(source.bytesDropped(), qint64(4));
+}
+
+QTEST_MAIN(TestIcecastSource)
@@ -0,0 +1,29 @@
+#ifndef TESTICECASTSOURCE_H
+#define TESTICECASTSOURCE_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for IcecastSource class
+ *
+ * Tests the Icecast source protocol including:
+ * - The PUT handshake and stream headers
+ * - Falling back to SOURCE for older servers
+ * - Refused credentials
+ * - Reconnecting and resending the stream header
+ * - Dropping data while not connected
+ */
+class TestIcecastSource : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testPutHandshake();
+    void testFallsBackToSourceMethod();
+    void testWrongPassword();
+    void testReconnectResendsHeader();
+    void testDropsDataWhileDisconnected();
+};
+
+#endif // TESTICECASTSOURCE_H
@@ -0,0 +1,153 @@
+#include "TestIngestIndex.h"
+#include "../../../src/services/IngestIndex.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QThread>
+
+namespace {
+
+const QStringList AUDIO_FILTERS = {"*.ogg", "*.mp3"};
+
+void touch(const QString& path)
+{
+    // Directory times may only have millisecond resolution
+    QThread::msleep(5);
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("x");
+}
+
+QStringList scanAll(IngestIndex& index, const QString& root)
+{
+    QStringList offered;
+    index.scan(root, AUDIO_FILTERS, [&offered](const QString& path) {
+        offered << path;
+        return true;
+    });
+    offered.sort();
+    return offered;
+}
+
+} // namespace
+
+void TestIngestIndex::testFirstScanOffersEveryFile()
+{
+    QTemporaryDir root;
+    QVERIFY(root.isValid());
+    const QDir dir(root.path());
+    touch(dir.filePath("news/news_2024-01-01.ogg"));
+    touch(dir.filePath("news/2023/news_2023-12-31.mp3"));
+    touch(dir.filePath("news/notes.txt"));
+    touch(dir.filePath("talk_2024-01-02.ogg")); // not sorted yet
+
+    IngestIndex index(dir.filePath("index"));
+    const QStringList offered = scanAll(index, root.path());
+    QCOMPARE(offered, QStringList({dir.filePath("news/2023/news_2023-12-31.mp3"),
+                                   dir.filePath("news/news_2024-01-01.ogg")}));
+    QVERIFY(index.isModified());
+    QVERIFY(index.contains(dir.filePath("news/news_2024-01-01.ogg")));
+    QVERIFY(!index.contains(dir.filePath("talk_2024-01-02.ogg")));
+    QCOMPARE(index.directoryCount(), 2);
+    QCOMPARE(index.fileCount(), 2);
+}
+
+void TestIngestIndex::testUnchangedTreeIsSkipped()
+{
+    QTemporaryDir root;
+    QVERIFY(root.isValid());
+    touch(QDir(root.path()).filePath("news/news_2024-01-01.ogg"));
+
+    IngestIndex index(QDir(root.path()).filePath("index"));
+    QCOMPARE(scanAll(index, root.path()).size(), 1);
+    QVERIFY(index.save());
+
+    QVERIFY(scanAll(index, root.path()).isEmpty());
+    QVERIFY(!index.isModified());
+}
+
+void TestIngestIndex::testNewFileOfferedOnce()
+{
+    QTemporaryDir root;
+    QVERIFY(root.isValid());
+    const QDir dir(root.path());
+    touch(dir.filePath("news/news_2024-01-01.ogg"));
+
+    IngestIndex index(dir.filePath("index"));
+    scanAll(index, root.path());
+
+    touch(dir.filePath("news/news_2024-01-02.ogg"));
+    QCOMPARE(scanAll(index, root.path()), QStringList({dir.filePath("news/news_2024-01-02.ogg")}));
+    QVERIFY(scanAll(index, root.path()).isEmpty());
+    QCOMPARE(index.fileCount(), 2);
+}
+
+void TestIngestIndex::testRejectedFileOfferedAgain()
+{
+    QTemporaryDir root;
+    QVERIFY(root.isValid());
+    const QString file = QDir(root.path()).filePath("news/news_2024-01-01.ogg");
+    touch(file);
+
+    IngestIndex index(QDir(root.path()).filePath("index"));
+    int offers = 0;
+    QCOMPARE(index.scan(root.path(), AUDIO_FILTERS, [&offers](const QString&) {
+        ++offers;
+        return false;
+    }), 0);
+    QCOMPARE(offers, 1);
+    QVERIFY(!index.contains(file));
+
+    // Nothing changed on disk, but the directory is listed again
+    QCOMPARE(scanAll(index, root.path()), QStringList({file}));
+    QVERIFY(index.contains(file));
+}
+
+void TestIngestIndex::testRemovedDirectoryDropped()
+{
+    QTemporaryDir root;
+    QVERIFY(root.isValid());
+    const QDir dir(root.path());
+    touch(dir.filePath("news/news_2024-01-01.ogg"));
+    touch(dir.filePath("talk/talk_2024-01-01.ogg"));
+
+    IngestIndex index(dir.filePath("index"));
+    scanAll(index, root.path());
+    QCOMPARE(index.directoryCount(), 2);
+
+    QVERIFY(QDir(dir.filePath("talk")).removeRecursively());
+    QVERIFY(scanAll(index, root.path()).isEmpty());
+    QCOMPARE(index.directoryCount(), 1);
+    QVERIFY(!index.contains(dir.filePath("talk/talk_2024-01-01.ogg")));
+}
+
+void TestIngestIndex::testSaveAndLoad()
+{
+    QTemporaryDir root;
+    QVERIFY(root.isValid());
+    const QDir dir(root.path());
+    touch(dir.filePath("news/news_2024-01-01.ogg"));
+    const QString indexFile = QDir(root.path() + "-index").filePath("programs.ingest-index");
+
+    {
+        IngestIndex index(indexFile);
+        QVERIFY(index.load()); // a missing file is an empty index
+        scanAll(index, root.path());
+        QVERIFY(index.save());
+        QVERIFY(!index.isModified());
+    }
+
+    IngestIndex reloaded(indexFile);
+    QVERIFY(reloaded.load());
+    QVERIFY(reloaded.contains(dir.filePath("news/news_2024-01-01.ogg")));
+    QVERIFY(scanAll(reloaded, root.path()).isEmpty());
+
+    touch(dir.filePath("news/news_2024-01-02.ogg"));
+    QCOMPARE(scanAll(reloaded, root.path()), QStringList({dir.filePath("news/news_2024-01-02.ogg")}));
+
+    QDir(root.path() + "-index").removeRecursively();
+}
+
+QTEST_MAIN(TestIngestIndex)
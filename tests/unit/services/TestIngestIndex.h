@@ -0,0 +1,30 @@
+#ifndef TESTINGESTINDEX_H
+#define TESTINGESTINDEX_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for IngestIndex class
+ *
+ * Tests incremental folder scanning including:
+ * - First scan offering every file
+ * - Unchanged directories skipped
+ * - New files offered once
+ * - Rejected files offered again
+ * - Saving and loading the index
+ */
+class TestIngestIndex : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testFirstScanOffersEveryFile();
+    void testUnchangedTreeIsSkipped();
+    void testNewFileOfferedOnce();
+    void testRejectedFileOfferedAgain();
+    void testRemovedDirectoryDropped();
+    void testSaveAndLoad();
+};
+
+#endif // TESTINGESTINDEX_H
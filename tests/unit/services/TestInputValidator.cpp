@@ -2,6 +2,7 @@
 #include "../../../src/services/InputValidator.h"
 #include <QDir>
 #include <QFile>
+#include <QRegularExpression>
 #include <QTextStream>
 
 void TestInputValidator::initTestCase()
@@ -453,6 +454,42 @@ void TestInputValidator::testSqlInjectionVariations()
     }
 }
 
+void TestInputValidator::testScannersMatchPatterns()
+{
+    // The regular expressions the character scanners replaced
+    const QRegularExpression traversal(R"((\.\.[\\/])|([\\\/]\.\.)|(^\.\.)|(\.\.$))");
+    const QRegularExpression sqlInjection(
+        R"((\b(SELECT|INSERT|UPDATE|DELETE|DROP|CREATE|ALTER|EXEC|UNION|SCRIPT)\b))"
+        R"(|(')|(--)|(;)|(\/\*))",
+        QRegularExpression::CaseInsensitiveOption);
+    const QRegularExpression filename(R"(^[a-zA-Z0-9._\-\s()]+$)");
+    const QRegularExpression controls(R"([\x00-\x08\x0B\x0C\x0E-\x1F\x7F])");
+
+    const QStringList inputs = {
+        "", ".", "..", "...", "a..b", "../x", "x/..", "x\\..\\y", "..\n", "x..\n", "a/...b",
+        "Safe text", "selected", "Select", "xUNION", "drop_table", "éDROP", "a-b", "a--b",
+        "/*", "a;b", "it's", "My Song (Live) - 01.mp3", "tab\there", "bad<name>", "caf\u00e9",
+        "line\nbreak", "del\x7f", "bell\x07\x01", "CR\r\nLF"
+    };
+    for (const QString& input : inputs) {
+        const QByteArray name = input.toUtf8();
+        const bool safePath = !input.isEmpty() && !traversal.match(input).hasMatch();
+        QVERIFY2(InputValidator::isPathSafe(input) == safePath, name.constData());
+        QVERIFY2(InputValidator::isSqlSafe(input) == !sqlInjection.match(input).hasMatch(),
+                 name.constData());
+
+        QString expected = input;
+        expected.remove(controls);
+        expected = expected.trimmed().replace(QRegularExpression(R"(\s+)"), " ");
+        QCOMPARE(InputValidator::sanitizeText(input), expected);
+
+        const auto type = InputValidator::TextType::Filename;
+        const auto result = InputValidator::validateText(input, type);
+        const QString cleaned = InputValidator::sanitizeText(input, type);
+        QCOMPARE(result.isValid, filename.match(cleaned).hasMatch());
+    }
+}
+
 void TestInputValidator::createTestFiles()
 {
     m_testAudioFile = createTestFile("mp3", "fake audio content");
@@ -90,6 +90,7 @@ private slots:
     void testUnicodeHandling();
     void testPathTraversalVariations();
     void testSqlInjectionVariations();
+    void testScannersMatchPatterns();
 
 private:
     void createTestFiles();
@@ -0,0 +1,115 @@
+#include "TestIntervalIndex.h"
+#include "../../../src/services/IntervalIndex.h"
+#include <QRandomGenerator>
+
+namespace {
+
+QList<qint64> ids(const QVector<IntervalIndex::Interval>& intervals)
+{
+    QList<qint64> result;
+    for (const IntervalIndex::Interval& interval : intervals) {
+        result << interval.id;
+    }
+    return result;
+}
+
+} // namespace
+
+void TestIntervalIndex::testOverlapping()
+{
+    IntervalIndex index;
+    QVERIFY(index.insert(30, 40, 3));
+    QVERIFY(index.insert(0, 10, 1));
+    QVERIFY(index.insert(5, 100, 2));
+    QVERIFY(index.insert(50, 60, 4));
+    QCOMPARE(index.size(), 4);
+
+    QCOMPARE(ids(index.overlapping(8, 35)), QList<qint64>({1, 2, 3}));
+    // Touching ends do not overlap
+    QCOMPARE(ids(index.overlapping(10, 30)), QList<qint64>({2}));
+    QCOMPARE(ids(index.overlapping(40, 50)), QList<qint64>({2}));
+    QCOMPARE(ids(index.overlapping(100, 200)), QList<qint64>());
+    QCOMPARE(ids(index.overlapping(-10, 1)), QList<qint64>({1}));
+
+    const QVector<IntervalIndex::Interval> found = index.overlapping(55, 56);
+    QCOMPARE(found.size(), 2);
+    QCOMPARE(found.last().start, qint64(50));
+    QCOMPARE(found.last().end, qint64(60));
+}
+
+void TestIntervalIndex::testRemove()
+{
+    IntervalIndex index;
+    index.insert(10, 20, 1);
+    index.insert(10, 30, 2);
+    index.insert(10, 25, 2);
+    index.insert(15, 16, 3);
+
+    QVERIFY(index.remove(10, 2));
+    QCOMPARE(index.size(), 3);
+    QCOMPARE(ids(index.overlapping(0, 100)), QList<qint64>({1, 2, 3}));
+    QVERIFY(index.remove(10, 2));
+    QVERIFY(!index.remove(10, 2));
+    QVERIFY(!index.remove(11, 1));
+    QCOMPARE(ids(index.overlapping(0, 100)), QList<qint64>({1, 3}));
+
+    // Freed nodes are reused
+    index.insert(40, 50, 5);
+    QCOMPARE(ids(index.overlapping(45, 46)), QList<qint64>({5}));
+    index.clear();
+    QVERIFY(index.isEmpty());
+    QVERIFY(index.overlapping(0, 100).isEmpty());
+}
+
+void TestIntervalIndex::testEmpty()
+{
+    IntervalIndex index;
+    QVERIFY(index.overlapping(0, 10).isEmpty());
+    QVERIFY(!index.remove(0, 0));
+    QVERIFY(!index.insert(5, 5, 1));
+    QVERIFY(!index.insert(6, 5, 1));
+    QVERIFY(index.isEmpty());
+
+    index.insert(0, 10, 1);
+    QVERIFY(index.overlapping(5, 5).isEmpty());
+}
+
+void TestIntervalIndex::testAgainstList()
+{
+    QRandomGenerator random(7);
+    IntervalIndex index;
+    QVector<IntervalIndex::Interval> list;
+
+    for (int step = 0; step < 20000; ++step) {
+        if (list.isEmpty() || random.bounded(3) < 2) {
+            const qint64 start = random.bounded(10000);
+            const qint64 end = start + 1 + random.bounded(300);
+            // Ids are unique, so the list knows which interval a removal takes
+            QVERIFY(index.insert(start, end, step));
+            list.append({start, end, step});
+        } else {
+            const int at = random.bounded(int(list.size()));
+            QVERIFY(index.remove(list[at].start, list[at].id));
+            list.remove(at);
+        }
+        QCOMPARE(index.size(), int(list.size()));
+
+        if (step % 50 == 0) {
+            const qint64 from = random.bounded(10300);
+            const qint64 to = from + 1 + random.bounded(500);
+            int expected = 0;
+            for (const IntervalIndex::Interval& interval : std::as_const(list)) {
+                if (interval.start < to && interval.end > from) {
+                    ++expected;
+                }
+            }
+            const QVector<IntervalIndex::Interval> found = index.overlapping(from, to);
+            QCOMPARE(int(found.size()), expected);
+            for (int i = 1; i < found.size(); ++i) {
+                QVERIFY(found[i - 1].start <= found[i].start);
+            }
+        }
+    }
+}
+
+QTEST_MAIN(TestIntervalIndex)
@@ -0,0 +1,27 @@
+#ifndef TESTINTERVALINDEX_H
+#define TESTINTERVALINDEX_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for IntervalIndex class
+ *
+ * Tests the interval tree including:
+ * - Overlap queries on half-open intervals, ordered by start
+ * - Removing one interval among those with the same start
+ * - Empty intervals and ranges
+ * - Random inserts, removals and queries against a plain list
+ */
+class TestIntervalIndex : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testOverlapping();
+    void testRemove();
+    void testEmpty();
+    void testAgainstList();
+};
+
+#endif // TESTINTERVALINDEX_H
@@ -0,0 +1,155 @@
+#include "TestJitterBuffer.h"
+#include "../../../src/services/JitterBuffer.h"
+
+namespace {
+
+constexpr int FRAME_MS = 20;
+
+QByteArray payload(int sequence)
+{
+    return QByteArray::number(sequence);
+}
+
+// Pushes a packet on time for its sequence
+bool push(JitterBuffer& buffer, quint16 sequence, qint64 offsetMs = 0)
+{
+    return buffer.push(sequence, payload(sequence), qint64(sequence) * FRAME_MS + offsetMs);
+}
+
+} // namespace
+
+void TestJitterBuffer::testBuffersBeforePlaying()
+{
+    JitterBuffer buffer(FRAME_MS);
+    QCOMPARE(buffer.targetDepth(), JitterBuffer::DEFAULT_MIN_DELAY_MS / FRAME_MS);
+    QCOMPARE(buffer.pop().kind, JitterBuffer::Frame::Empty);
+
+    QVERIFY(push(buffer, 10));
+    QCOMPARE(buffer.pop().kind, JitterBuffer::Frame::Empty);
+    QVERIFY(buffer.isBuffering());
+
+    QVERIFY(push(buffer, 11));
+    JitterBuffer::Frame frame = buffer.pop();
+    QCOMPARE(frame.kind, JitterBuffer::Frame::Packet);
+    QCOMPARE(frame.sequence, quint16(10));
+    QCOMPARE(frame.payload, payload(10));
+    QVERIFY(!buffer.isBuffering());
+    QCOMPARE(buffer.depth(), 1);
+    QCOMPARE(buffer.pop().sequence, quint16(11));
+}
+
+void TestJitterBuffer::testReorders()
+{
+    JitterBuffer buffer(FRAME_MS);
+    QVERIFY(push(buffer, 5));
+    QVERIFY(push(buffer, 7));
+    QVERIFY(push(buffer, 6, 20));
+    QVERIFY(!push(buffer, 6, 25));
+
+    for (quint16 sequence = 5; sequence <= 7; ++sequence) {
+        const JitterBuffer::Frame frame = buffer.pop();
+        QCOMPARE(frame.kind, JitterBuffer::Frame::Packet);
+        QCOMPARE(frame.sequence, sequence);
+        QCOMPARE(frame.payload, payload(sequence));
+    }
+
+    // Its frame was played already
+    QVERIFY(!push(buffer, 5, 100));
+    QCOMPARE(buffer.statistics().received, qint64(3));
+    QCOMPARE(buffer.statistics().duplicates, qint64(1));
+    QCOMPARE(buffer.statistics().late, qint64(1));
+    QCOMPARE(buffer.statistics().lost, qint64(0));
+}
+
+void TestJitterBuffer::testLostPacket()
+{
+    JitterBuffer buffer(FRAME_MS);
+    QVERIFY(push(buffer, 1));
+    QVERIFY(push(buffer, 2));
+    QVERIFY(push(buffer, 4));
+    QCOMPARE(buffer.pop().sequence, quint16(1));
+    QCOMPARE(buffer.pop().sequence, quint16(2));
+
+    // The packet after comes with the gap, to recover it from
+    JitterBuffer::Frame frame = buffer.pop();
+    QCOMPARE(frame.kind, JitterBuffer::Frame::Lost);
+    QCOMPARE(frame.sequence, quint16(3));
+    QCOMPARE(frame.payload, payload(4));
+    QCOMPARE(buffer.pop().kind, JitterBuffer::Frame::Packet);
+
+    // Two in a row: only the second has one after it
+    QVERIFY(push(buffer, 7));
+    frame = buffer.pop();
+    QCOMPARE(frame.kind, JitterBuffer::Frame::Lost);
+    QVERIFY(frame.payload.isEmpty());
+    frame = buffer.pop();
+    QCOMPARE(frame.kind, JitterBuffer::Frame::Lost);
+    QCOMPARE(frame.payload, payload(7));
+    QCOMPARE(buffer.pop().sequence, quint16(7));
+    QCOMPARE(buffer.statistics().lost, qint64(3));
+}
+
+void TestJitterBuffer::testUnderrun()
+{
+    JitterBuffer buffer(FRAME_MS);
+    QVERIFY(push(buffer, 1));
+    QVERIFY(push(buffer, 2));
+    QCOMPARE(buffer.pop().kind, JitterBuffer::Frame::Packet);
+    QCOMPARE(buffer.pop().kind, JitterBuffer::Frame::Packet);
+
+    QCOMPARE(buffer.pop().kind, JitterBuffer::Frame::Empty);
+    QVERIFY(buffer.isBuffering());
+    QCOMPARE(buffer.statistics().underruns, qint64(1));
+
+    // Nothing plays until the target depth is back
+    QVERIFY(push(buffer, 3));
+    QCOMPARE(buffer.pop().kind, JitterBuffer::Frame::Empty);
+    QVERIFY(push(buffer, 4));
+    QCOMPARE(buffer.pop().sequence, quint16(3));
+    QCOMPARE(buffer.statistics().underruns, qint64(1));
+}
+
+void TestJitterBuffer::testSequenceWraps()
+{
+    JitterBuffer buffer(FRAME_MS);
+    const QList<quint16> sequences = {65534, 65535, 0, 1};
+    for (quint16 sequence : sequences) {
+        QVERIFY(buffer.push(sequence, payload(sequence), 0));
+    }
+    for (quint16 sequence : sequences) {
+        const JitterBuffer::Frame frame = buffer.pop();
+        QCOMPARE(frame.kind, JitterBuffer::Frame::Packet);
+        QCOMPARE(frame.sequence, sequence);
+    }
+    QVERIFY(!buffer.push(65535, payload(65535), 0));
+
+    // A jump too far to wait for starts over from there
+    QVERIFY(push(buffer, 1000));
+    QVERIFY(push(buffer, 1001));
+    QCOMPARE(buffer.pop().sequence, quint16(1000));
+    QCOMPARE(buffer.statistics().lost, qint64(0));
+}
+
+void TestJitterBuffer::testAdaptsToJitter()
+{
+    JitterBuffer buffer(FRAME_MS);
+    for (quint16 sequence = 0; sequence < 200; ++sequence) {
+        QVERIFY(push(buffer, sequence, sequence % 2 ? 60 : 0));
+    }
+    QVERIFY(buffer.jitterMs() > 40);
+    QVERIFY(buffer.jitterMs() <= 60);
+    QVERIFY(buffer.targetDepth() >= 7);
+
+    buffer.setDelayRange(40, 100);
+    QCOMPARE(buffer.targetDepth(), 5);
+
+    // A steady network sinks back to the minimum
+    buffer.reset();
+    for (quint16 sequence = 0; sequence < 50; ++sequence) {
+        QVERIFY(push(buffer, sequence));
+    }
+    QCOMPARE(buffer.jitterMs(), 0.0);
+    QCOMPARE(buffer.targetDepth(), 2);
+}
+
+QTEST_MAIN(TestJitterBuffer)
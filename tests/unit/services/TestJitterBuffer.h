@@ -0,0 +1,31 @@
+#ifndef TESTJITTERBUFFER_H
+#define TESTJITTERBUFFER_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for JitterBuffer class
+ *
+ * Tests the playout buffer including:
+ * - Buffering to the target depth before playing
+ * - Reordering, duplicates and late packets
+ * - Lost packets handed out with the next one
+ * - Underruns and buffering again
+ * - Sequence numbers that wrap
+ * - A target depth that follows the jitter
+ */
+class TestJitterBuffer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testBuffersBeforePlaying();
+    void testReorders();
+    void testLostPacket();
+    void testUnderrun();
+    void testSequenceWraps();
+    void testAdaptsToJitter();
+};
+
+#endif // TESTJITTERBUFFER_H
@@ -0,0 +1,165 @@
+#include "TestKeyDispatcher.h"
+#include "../../../src/services/KeyDispatcher.h"
+#include <QKeyEvent>
+#include <QStringList>
+#include <QWidget>
+
+void TestKeyDispatcher::testKeyAndModifiers()
+{
+    KeyDispatcher keys;
+    QObject owner;
+    QStringList calls;
+    keys.add(Qt::Key_Space, Qt::NoModifier, QString(), &owner, [&calls](QWidget*, QKeyEvent*) {
+        calls << "space";
+        return true;
+    });
+    keys.add(QKeySequence(Qt::CTRL | Qt::Key_Space), QString(), &owner,
+             [&calls](QWidget*, QKeyEvent*) {
+        calls << "ctrl+space";
+        return true;
+    });
+    // Newer bindings go first; this one lets the key through
+    keys.add(Qt::Key_Space, Qt::NoModifier, QString(), &owner, [&calls](QWidget*, QKeyEvent*) {
+        calls << "watch";
+        return false;
+    });
+
+    QKeyEvent space(QEvent::KeyPress, Qt::Key_Space, Qt::NoModifier);
+    QVERIFY(keys.dispatch(nullptr, &space));
+    QCOMPARE(calls, QStringList({"watch", "space"}));
+
+    calls.clear();
+    QKeyEvent ctrlSpace(QEvent::KeyPress, Qt::Key_Space, Qt::ControlModifier | Qt::KeypadModifier);
+    QVERIFY(keys.dispatch(nullptr, &ctrlSpace));
+    QCOMPARE(calls, QStringList({"ctrl+space"}));
+
+    QKeyEvent altSpace(QEvent::KeyPress, Qt::Key_Space, Qt::AltModifier);
+    QVERIFY(!keys.dispatch(nullptr, &altSpace));
+
+    // Shift+Tab comes as Backtab, with Shift
+    bool back = false;
+    keys.add(Qt::Key_Backtab, Qt::NoModifier, QString(), &owner, [&back](QWidget*, QKeyEvent*) {
+        back = true;
+        return true;
+    });
+    QKeyEvent backtab(QEvent::KeyPress, Qt::Key_Backtab, Qt::ShiftModifier);
+    QVERIFY(keys.dispatch(nullptr, &backtab));
+    QVERIFY(back);
+    QCOMPARE(keys.bindingCount(), 4);
+}
+
+void TestKeyDispatcher::testFocusContexts()
+{
+    KeyDispatcher keys;
+    QWidget window;
+    QWidget* panel = new QWidget(&window);
+    QWidget* table = new QWidget(panel);
+    QWidget* outside = new QWidget(&window);
+    keys.setFocusContext(&window, "Player");
+    keys.setFocusContext(table, "Database");
+
+    QCOMPARE(keys.contextsFor(table), QStringList({"Database", "Player", "Global"}));
+    QCOMPARE(keys.contextsFor(outside), QStringList({"Player", "Global"}));
+    QCOMPARE(keys.contextsFor(nullptr), QStringList({"Global"}));
+
+    QObject owner;
+    QStringList calls;
+    QWidget* seen = nullptr;
+    for (const QString& context : {QString("Database"), QString("Player"), QString("Global")}) {
+        keys.add(Qt::Key_Up, Qt::ControlModifier, context, &owner,
+                 [&calls, &seen, context](QWidget* target, QKeyEvent*) {
+            calls << context;
+            seen = target;
+            return true;
+        });
+    }
+
+    QKeyEvent up(QEvent::KeyPress, Qt::Key_Up, Qt::ControlModifier);
+    QVERIFY(keys.dispatch(table, &up));
+    QVERIFY(keys.dispatch(outside, &up));
+    QVERIFY(keys.dispatch(nullptr, &up));
+    QCOMPARE(calls, QStringList({"Database", "Player", "Global"}));
+    QCOMPARE(seen, static_cast<QWidget*>(nullptr));
+
+    // Contexts changing after a lookup are seen by the next one
+    keys.setFocusContext(table, QString());
+    calls.clear();
+    QVERIFY(keys.dispatch(table, &up));
+    QCOMPARE(calls, QStringList({"Player"}));
+    QCOMPARE(seen, table);
+    QCOMPARE(keys.focusContext(&window), QString("Player"));
+}
+
+void TestKeyDispatcher::testAnyKey()
+{
+    KeyDispatcher keys;
+    QWidget table;
+    keys.setFocusContext(&table, "TableEditing");
+
+    QObject owner;
+    QList<int> typed;
+    keys.add(KeyDispatcher::ANY_KEY, Qt::ControlModifier, "TableEditing", &owner,
+             [&typed](QWidget*, QKeyEvent* event) {
+        typed << event->key();
+        return event->key() != Qt::Key_Escape;
+    });
+    bool escape = false;
+    keys.add(Qt::Key_Escape, Qt::NoModifier, QString(), &owner, [&escape](QWidget*, QKeyEvent*) {
+        escape = true;
+        return true;
+    });
+    bool f2 = false;
+    keys.add(Qt::Key_F2, Qt::NoModifier, "TableEditing", &owner, [&f2](QWidget*, QKeyEvent*) {
+        f2 = true;
+        return true;
+    });
+
+    // Any modifiers, after the bindings of the key in the same context
+    QKeyEvent a(QEvent::KeyPress, Qt::Key_A, Qt::ShiftModifier);
+    QKeyEvent key(QEvent::KeyPress, Qt::Key_F2, Qt::NoModifier);
+    QKeyEvent esc(QEvent::KeyPress, Qt::Key_Escape, Qt::NoModifier);
+    QVERIFY(keys.dispatch(&table, &a));
+    QVERIFY(keys.dispatch(&table, &key));
+    QVERIFY(keys.dispatch(&table, &esc));
+    QCOMPARE(typed, QList<int>({Qt::Key_A, Qt::Key_Escape}));
+    QVERIFY(f2);
+    QVERIFY(escape);
+
+    // Not outside the context
+    QKeyEvent b(QEvent::KeyPress, Qt::Key_B, Qt::NoModifier);
+    QVERIFY(!keys.dispatch(nullptr, &b));
+}
+
+void TestKeyDispatcher::testRemoval()
+{
+    KeyDispatcher keys;
+    QObject first;
+    QObject* second = new QObject;
+    const auto consume = [](QWidget*, QKeyEvent*) { return true; };
+    keys.add(Qt::Key_F5, Qt::NoModifier, QString(), &first, consume);
+    keys.add(Qt::Key_F5, Qt::NoModifier, QString(), second, consume);
+    keys.add(Qt::Key_F6, Qt::NoModifier, "Database", second, consume);
+    QCOMPARE(keys.bindingCount(), 3);
+
+    keys.remove(QKeySequence(Qt::Key_F5), QString(), &first);
+    QCOMPARE(keys.bindingCount(), 2);
+    QKeyEvent f5(QEvent::KeyPress, Qt::Key_F5, Qt::NoModifier);
+    QVERIFY(keys.dispatch(nullptr, &f5));
+
+    delete second;
+    QCOMPARE(keys.bindingCount(), 0);
+    QVERIFY(!keys.dispatch(nullptr, &f5));
+
+    QWidget* table = new QWidget;
+    keys.setFocusContext(table, "Database");
+    QCOMPARE(keys.contextsFor(table).size(), 2);
+    delete table;
+    QCOMPARE(keys.focusContext(table), QString());
+
+    keys.add(Qt::Key_F5, Qt::NoModifier, QString(), &first, consume);
+    keys.add(Qt::Key_F7, Qt::NoModifier, QString(), &first, consume);
+    keys.removeAll(&first);
+    QCOMPARE(keys.bindingCount(), 0);
+}
+
+QTEST_MAIN(TestKeyDispatcher)
@@ -0,0 +1,27 @@
+#ifndef TESTKEYDISPATCHER_H
+#define TESTKEYDISPATCHER_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for KeyDispatcher class
+ *
+ * Tests the application key table including:
+ * - Bindings found by key and modifiers, newest first, until one consumes the key
+ * - Focus contexts of a widget and its parents, nearest first, then the global one
+ * - Bindings of any key after those of the key
+ * - Bindings removed by owner, and when the owner or a widget is destroyed
+ */
+class TestKeyDispatcher : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testKeyAndModifiers();
+    void testFocusContexts();
+    void testAnyKey();
+    void testRemoval();
+};
+
+#endif // TESTKEYDISPATCHER_H
@@ -0,0 +1,173 @@
+#include "TestLevelMeter.h"
+#include "../../../src/services/LevelMeter.h"
+#include <QByteArray>
+#include <QRandomGenerator>
+#include <cmath>
+
+namespace {
+
+// Writes one value as a sample of the format; value is -1..1
+void appendSample(QByteArray& data, QAudioFormat::SampleFormat format, double value)
+{
+    switch (format) {
+    case QAudioFormat::UInt8: {
+        const quint8 sample = quint8(qBound(0L, std::lround(128.0 + value * 128.0), 255L));
+        data.append(reinterpret_cast<const char*>(&sample), sizeof(sample));
+        break;
+    }
+    case QAudioFormat::Int16: {
+        const qint16 sample = qint16(std::lround(value * 32767.0));
+        data.append(reinterpret_cast<const char*>(&sample), sizeof(sample));
+        break;
+    }
+    case QAudioFormat::Int32: {
+        const qint32 sample = qint32(std::llround(value * 2147483647.0));
+        data.append(reinterpret_cast<const char*>(&sample), sizeof(sample));
+        break;
+    }
+    default: {
+        const float sample = float(value);
+        data.append(reinterpret_cast<const char*>(&sample), sizeof(sample));
+        break;
+    }
+    }
+}
+
+// A second of 1 kHz at 48 kHz in every channel, channel c at amplitudes[c]
+QByteArray sine(QAudioFormat::SampleFormat format, const QList<double>& amplitudes)
+{
+    QByteArray data;
+    for (int i = 0; i < 48000; ++i) {
+        const double value = std::sin(2.0 * M_PI * 1000.0 * i / 48000.0);
+        for (double amplitude : amplitudes) {
+            appendSample(data, format, amplitude * value);
+        }
+    }
+    return data;
+}
+
+} // namespace
+
+void TestLevelMeter::testSine_data()
+{
+    QTest::addColumn<int>("format");
+    QTest::addColumn<double>("tolerance");
+
+    QTest::newRow("uint8") << int(QAudioFormat::UInt8) << 0.01;
+    QTest::newRow("int16") << int(QAudioFormat::Int16) << 0.001;
+    QTest::newRow("int32") << int(QAudioFormat::Int32) << 0.001;
+    QTest::newRow("float") << int(QAudioFormat::Float) << 0.001;
+}
+
+void TestLevelMeter::testSine()
+{
+    QFETCH(int, format);
+    QFETCH(double, tolerance);
+
+    const auto sampleFormat = QAudioFormat::SampleFormat(format);
+    const QByteArray data = sine(sampleFormat, {0.5});
+    const LevelMeter::Levels levels =
+        LevelMeter::measure(data.constData(), data.size(), sampleFormat, 1);
+
+    QCOMPARE(levels.channels, 1);
+    QVERIFY2(qAbs(levels.peak[0] - 0.5) <= tolerance, qPrintable(QString::number(levels.peak[0])));
+    QVERIFY2(qAbs(levels.rms[0] - 0.5 / std::sqrt(2.0)) <= tolerance,
+             qPrintable(QString::number(levels.rms[0])));
+}
+
+void TestLevelMeter::testChannels()
+{
+    // Silent left, quiet right: each comes out on its own
+    const QByteArray stereo = sine(QAudioFormat::Int16, {0.0, 0.25});
+    const LevelMeter::Levels levels =
+        LevelMeter::measure(stereo.constData(), stereo.size(), QAudioFormat::Int16, 2);
+    QCOMPARE(levels.channels, 2);
+    QCOMPARE(levels.peak[0], 0.0f);
+    QVERIFY(qAbs(levels.peak[1] - 0.25) <= 0.001);
+    QCOMPARE(levels.maxPeak(), levels.peak[1]);
+
+    // Six channels go through the scalar loop
+    const QByteArray surround = sine(QAudioFormat::Float, {0.1, 0.2, 0.3, 0.4, 0.5, 0.6});
+    const LevelMeter::Levels six =
+        LevelMeter::measure(surround.constData(), surround.size(), QAudioFormat::Float, 6);
+    QCOMPARE(six.channels, 6);
+    for (int channel = 0; channel < 6; ++channel) {
+        QVERIFY(qAbs(six.peak[channel] - 0.1 * (channel + 1)) <= 0.001);
+    }
+
+    // Unknown formats and buffers shorter than a frame measure nothing
+    QCOMPARE(LevelMeter::measure(stereo.constData(), 2, QAudioFormat::Int16, 2).channels, 0);
+    QCOMPARE(LevelMeter::measure(stereo.constData(), stereo.size(), QAudioFormat::Unknown, 2)
+                 .channels,
+             0);
+}
+
+void TestLevelMeter::testMatchesScalar_data()
+{
+    QTest::addColumn<int>("format");
+    QTest::addColumn<int>("channels");
+    QTest::addColumn<int>("frames");
+
+    for (int format : {int(QAudioFormat::Int16), int(QAudioFormat::Int32),
+                       int(QAudioFormat::Float)}) {
+        for (int channels : {1, 2, 4}) {
+            // Lengths that leave a tail after the last full vector
+            for (int frames : {1, 7, 9, 4801}) {
+                QTest::addRow("format %d, %d channels, %d frames", format, channels, frames)
+                    << format << channels << frames;
+            }
+        }
+    }
+}
+
+void TestLevelMeter::testMatchesScalar()
+{
+    QFETCH(int, format);
+    QFETCH(int, channels);
+    QFETCH(int, frames);
+
+    const auto sampleFormat = QAudioFormat::SampleFormat(format);
+    QRandomGenerator random(42);
+    QByteArray data;
+    for (int i = 0; i < frames * channels; ++i) {
+        appendSample(data, sampleFormat, random.generateDouble() * 2.0 - 1.0);
+    }
+
+    const LevelMeter::Levels vector =
+        LevelMeter::measure(data.constData(), data.size(), sampleFormat, channels);
+    const LevelMeter::Levels scalar =
+        LevelMeter::measureScalar(data.constData(), data.size(), sampleFormat, channels);
+    QCOMPARE(vector.channels, scalar.channels);
+    for (int channel = 0; channel < channels; ++channel) {
+        QCOMPARE(vector.peak[channel], scalar.peak[channel]);
+        QVERIFY(qAbs(vector.rms[channel] - scalar.rms[channel]) <= 1e-5f);
+    }
+}
+
+void TestLevelMeter::testPeakHold()
+{
+    QAudioFormat format;
+    format.setSampleFormat(QAudioFormat::Int16);
+    format.setChannelCount(2);
+    LevelMeter meter(format);
+    QCOMPARE(meter.channelCount(), 2);
+    QCOMPARE(meter.takePeak(), 0.0f);
+
+    // A loud buffer followed by a quiet one: the meter shows the last,
+    // the display still gets the loud one
+    const QByteArray loud = sine(QAudioFormat::Int16, {0.8, 0.8});
+    const QByteArray quiet = sine(QAudioFormat::Int16, {0.1, 0.1});
+    meter.process(loud.constData(), loud.size());
+    meter.process(quiet.constData(), quiet.size());
+    QVERIFY(qAbs(meter.peak() - 0.1) <= 0.001);
+    QVERIFY(qAbs(meter.rms(1) - 0.1 / std::sqrt(2.0)) <= 0.001);
+    QVERIFY(qAbs(meter.takePeak() - 0.8) <= 0.001);
+    QCOMPARE(meter.takePeak(), 0.0f);
+
+    meter.reset();
+    QCOMPARE(meter.peak(), 0.0f);
+    QCOMPARE(meter.rms(), 0.0f);
+    QCOMPARE(meter.peak(5), 0.0f);
+}
+
+QTEST_MAIN(TestLevelMeter)
@@ -0,0 +1,29 @@
+#ifndef TESTLEVELMETER_H
+#define TESTLEVELMETER_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for LevelMeter class
+ *
+ * Tests the input level meter including:
+ * - Peak and RMS of a sine in each sample format
+ * - Channels measured separately
+ * - The vector code against the scalar reference, with odd lengths
+ * - Peak hold between reads and reset
+ */
+class TestLevelMeter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testSine_data();
+    void testSine();
+    void testChannels();
+    void testMatchesScalar_data();
+    void testMatchesScalar();
+    void testPeakHold();
+};
+
+#endif // TESTLEVELMETER_H
@@ -0,0 +1,328 @@
+#include "TestLibraryChecker.h"
+#include "../../../src/services/LibraryChecker.h"
+#include <QFile>
+#include <QSignalSpy>
+#include <QSqlQuery>
+#include <QThread>
+#include <QtEndian>
+
+namespace {
+
+const char* CONNECTION_NAME = "test_library_checker_connection";
+
+// Stands in for MediaProbe: files with "bad" in the name cannot be read,
+// every other file lasts three minutes
+QString fakeProbe(const QString& filePath, QString* error)
+{
+    if (filePath.contains("bad")) {
+        *error = "Unrecognised container";
+        return QString();
+    }
+    return "0:03:00";
+}
+
+// One second of 8 kHz mono 16-bit silence
+QByteArray oneSecondWav()
+{
+    const quint32 dataSize = 16000;
+    QByteArray wav("RIFF");
+    auto append32 = [&wav](quint32 value) {
+        char bytes[4];
+        qToLittleEndian(value, bytes);
+        wav.append(bytes, 4);
+    };
+    auto append16 = [&wav](quint16 value) {
+        char bytes[2];
+        qToLittleEndian(value, bytes);
+        wav.append(bytes, 2);
+    };
+    append32(36 + dataSize);
+    wav.append("WAVEfmt ");
+    append32(16);
+    append16(1);
+    append16(1);
+    append32(8000);
+    append32(16000);
+    append16(2);
+    append16(16);
+    wav.append("data");
+    append32(dataSize);
+    wav.append(QByteArray(dataSize, '\0'));
+    return wav;
+}
+
+} // namespace
+
+void TestLibraryChecker::init()
+{
+    m_tempDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_tempDir->isValid());
+
+    m_database = QSqlDatabase::addDatabase("QSQLITE", CONNECTION_NAME);
+    m_database.setDatabaseName(m_tempDir->filePath("test.db"));
+    QVERIFY(m_database.open());
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("CREATE TABLE musics (id INTEGER PRIMARY KEY, path TEXT, time TEXT, "
+                       "played_times INTEGER DEFAULT 0)"));
+}
+
+void TestLibraryChecker::cleanup()
+{
+    if (m_database.isOpen()) {
+        m_database.close();
+    }
+    m_database = QSqlDatabase();
+    QSqlDatabase::removeDatabase(CONNECTION_NAME);
+    m_tempDir.reset();
+}
+
+void TestLibraryChecker::testChecksRecords()
+{
+    const QString changed = addRecord("changed.mp3", "audio", "0:00:00", 5);
+    const QString same = addRecord("same.mp3", "audio", "0:03:00", 3);
+    const QString empty = addRecord("empty.mp3", QByteArray(), "0:02:00", 1);
+    const QString bad = addRecord("bad.mp3", "noise", "0:01:00", 2);
+    const QString missing = m_tempDir->filePath("missing.mp3");
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec(QString("INSERT INTO musics (path, time) VALUES ('%1', '0:04:00')")
+                           .arg(missing)));
+
+    LibraryChecker checker(m_database);
+    checker.setProber(fakeProbe);
+    QSignalSpy problems(&checker, &LibraryChecker::problemFound);
+    QSignalSpy progress(&checker, &LibraryChecker::progressChanged);
+    QSignalSpy finished(&checker, &LibraryChecker::finished);
+
+    QVERIFY(checker.start());
+    QVERIFY(checker.isRunning());
+    QCOMPARE(checker.total(), 5);
+    QVERIFY(!checker.start());
+    QVERIFY(finished.wait(5000));
+    QVERIFY(!checker.isRunning());
+
+    const auto report = finished.at(0).at(0).value<LibraryChecker::Report>();
+    QCOMPARE(report.total, 5);
+    QCOMPARE(report.checked, 5);
+    QCOMPARE(report.updated, 1);
+    QCOMPARE(report.writeErrors, 0);
+    QCOMPARE(report.missing, QStringList{missing});
+    QCOMPARE(report.empty, QStringList{empty});
+    QCOMPARE(report.unreadable, QStringList{bad});
+    QCOMPARE(report.problems(), 3);
+    QVERIFY(!report.cancelled);
+
+    QCOMPARE(problems.count(), 3);
+    QCOMPARE(progress.count(), 5);
+    QCOMPARE(progress.last().at(0).toInt(), 5);
+    QCOMPARE(progress.last().at(1).toInt(), 5);
+
+    QCOMPARE(storedTime(changed), QString("0:03:00"));
+    QCOMPARE(playedTimes(changed), 0);
+    QCOMPARE(playedTimes(same), 0);
+    // Nothing is written for files with a problem, and nothing is removed
+    QCOMPARE(storedTime(bad), QString("0:01:00"));
+    QCOMPARE(playedTimes(bad), 2);
+    QCOMPARE(playedTimes(empty), 1);
+    QCOMPARE(recordCount(), 5);
+}
+
+void TestLibraryChecker::testBatchesWrites()
+{
+    const int count = LibraryChecker::BATCH_SIZE * 2 + 7;
+    QVERIFY(m_database.transaction());
+    for (int i = 0; i < count; ++i) {
+        addRecord(QString("track%1.mp3").arg(i), "audio", QString(), 1);
+    }
+    QVERIFY(m_database.commit());
+
+    LibraryChecker checker(m_database);
+    checker.setProber(fakeProbe);
+    checker.setMaxWorkers(4);
+    QSignalSpy finished(&checker, &LibraryChecker::finished);
+    QVERIFY(checker.start());
+    QVERIFY(finished.wait(20000));
+
+    const auto report = finished.at(0).at(0).value<LibraryChecker::Report>();
+    QCOMPARE(report.checked, count);
+    QCOMPARE(report.updated, count);
+    QCOMPARE(report.problems(), 0);
+
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("SELECT COUNT(*) FROM musics WHERE time = '0:03:00' AND played_times = 0"));
+    QVERIFY(query.next());
+    QCOMPARE(query.value(0).toInt(), count);
+}
+
+void TestLibraryChecker::testCancelKeepsResults()
+{
+    for (int i = 0; i < 20; ++i) {
+        addRecord(QString("track%1.mp3").arg(i), "audio", QString());
+    }
+
+    LibraryChecker checker(m_database);
+    checker.setMaxWorkers(1);
+    checker.setProber([](const QString& filePath, QString* error) {
+        QThread::msleep(20);
+        return fakeProbe(filePath, error);
+    });
+    QSignalSpy progress(&checker, &LibraryChecker::progressChanged);
+    QSignalSpy finished(&checker, &LibraryChecker::finished);
+    QVERIFY(checker.start());
+    QVERIFY(progress.wait(5000));
+    checker.cancel();
+
+    QCOMPARE(finished.count(), 1);
+    QVERIFY(!checker.isRunning());
+    const auto report = finished.at(0).at(0).value<LibraryChecker::Report>();
+    QVERIFY(report.cancelled);
+    QVERIFY(report.checked >= 1);
+    QVERIFY(report.checked < 20);
+    QCOMPARE(report.updated, report.checked);
+
+    // The file being probed when cancel() came is dropped
+    QTest::qWait(100);
+    QCOMPARE(finished.count(), 1);
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("SELECT COUNT(*) FROM musics WHERE time = '0:03:00'"));
+    QVERIFY(query.next());
+    QCOMPARE(query.value(0).toInt(), report.updated);
+}
+
+void TestLibraryChecker::testPauseAndResume()
+{
+    const QString bad = addRecord("bad0.mp3", "noise", QString());
+    for (int i = 0; i < 20; ++i) {
+        addRecord(QString("track%1.mp3").arg(i), "audio", QString());
+    }
+    auto slowProbe = [](const QString& filePath, QString* error) {
+        QThread::msleep(20);
+        return fakeProbe(filePath, error);
+    };
+
+    int pausedAt = 0;
+    {
+        LibraryChecker checker(m_database);
+        checker.setMaxWorkers(1);
+        checker.setProber(slowProbe);
+        QVERIFY(!checker.hasCheckpoint());
+        QSignalSpy progress(&checker, &LibraryChecker::progressChanged);
+        QSignalSpy paused(&checker, &LibraryChecker::paused);
+        QSignalSpy finished(&checker, &LibraryChecker::finished);
+        QVERIFY(checker.start());
+        QVERIFY(progress.wait(5000));
+        checker.pause();
+        checker.pause();
+        QVERIFY(checker.isPaused());
+        QTRY_COMPARE(paused.count(), 1);
+        pausedAt = paused.at(0).at(0).toInt();
+        QVERIFY(pausedAt >= 1);
+        QVERIFY(pausedAt < 21);
+
+        // Nothing more is looked at while paused
+        QTest::qWait(100);
+        QCOMPARE(progress.last().at(0).toInt(), pausedAt);
+        QCOMPARE(finished.count(), 0);
+        QVERIFY(checker.hasCheckpoint());
+    }
+
+    // A later run carries on from the checkpoint with the report so far
+    LibraryChecker checker(m_database);
+    checker.setProber(fakeProbe);
+    QVERIFY(checker.hasCheckpoint());
+    QSignalSpy progress(&checker, &LibraryChecker::progressChanged);
+    QSignalSpy finished(&checker, &LibraryChecker::finished);
+    QVERIFY(checker.resume());
+    QCOMPARE(checker.total(), 21);
+    QVERIFY(finished.wait(5000));
+    QCOMPARE(progress.count(), 21 - pausedAt);
+
+    const auto report = finished.at(0).at(0).value<LibraryChecker::Report>();
+    QVERIFY(!report.cancelled);
+    QCOMPARE(report.checked, 21);
+    QCOMPARE(report.updated, 20);
+    QCOMPARE(report.unreadable, QStringList{bad});
+    QVERIFY(!checker.hasCheckpoint());
+    QVERIFY(!checker.resume());
+
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("SELECT COUNT(*) FROM musics WHERE time = '0:03:00'"));
+    QVERIFY(query.next());
+    QCOMPARE(query.value(0).toInt(), 20);
+}
+
+void TestLibraryChecker::testRemoveRecords()
+{
+    const QString first = addRecord("first.mp3", "audio", QString());
+    const QString second = addRecord("second.mp3", "audio", QString());
+    const QString kept = addRecord("kept.mp3", "audio", QString());
+
+    LibraryChecker checker(m_database);
+    QCOMPARE(checker.removeRecords({}), 0);
+    QCOMPARE(checker.removeRecords({first, second, "/not/in/the/table.mp3"}), 2);
+    QCOMPARE(recordCount(), 1);
+    QCOMPARE(storedTime(kept), QString(""));
+
+    // The files themselves are left alone
+    QVERIFY(QFile::exists(first));
+}
+
+void TestLibraryChecker::testDefaultProber()
+{
+    const QString wav = addRecord("tone.wav", oneSecondWav(), "0:09:99");
+    const QString bad = addRecord("noise.dat", QByteArray(64, 'x'), "0:01:00");
+
+    LibraryChecker checker(m_database);
+    QSignalSpy problems(&checker, &LibraryChecker::problemFound);
+    QSignalSpy finished(&checker, &LibraryChecker::finished);
+    QVERIFY(checker.start());
+    QVERIFY(finished.wait(5000));
+
+    QCOMPARE(storedTime(wav), QString("0:00:01"));
+    QCOMPARE(problems.count(), 1);
+    QCOMPARE(problems.at(0).at(0).toString(), bad);
+    QCOMPARE(problems.at(0).at(1).value<LibraryChecker::Problem>(),
+             LibraryChecker::Problem::Unreadable);
+    QVERIFY(!problems.at(0).at(2).toString().isEmpty());
+}
+
+QString TestLibraryChecker::addRecord(const QString& name, const QByteArray& bytes,
+                                      const QString& time, int playedTimes)
+{
+    const QString path = m_tempDir->filePath(name);
+    QFile file(path);
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(bytes);
+    }
+
+    QSqlQuery query(m_database);
+    query.prepare("INSERT INTO musics (path, time, played_times) VALUES (?, ?, ?)");
+    query.addBindValue(path);
+    query.addBindValue(time);
+    query.addBindValue(playedTimes);
+    query.exec();
+    return path;
+}
+
+QString TestLibraryChecker::storedTime(const QString& path)
+{
+    QSqlQuery query(m_database);
+    query.prepare("SELECT time FROM musics WHERE path = ?");
+    query.addBindValue(path);
+    return query.exec() && query.next() ? query.value(0).toString() : QString("<none>");
+}
+
+int TestLibraryChecker::playedTimes(const QString& path)
+{
+    QSqlQuery query(m_database);
+    query.prepare("SELECT played_times FROM musics WHERE path = ?");
+    query.addBindValue(path);
+    return query.exec() && query.next() ? query.value(0).toInt() : -1;
+}
+
+int TestLibraryChecker::recordCount()
+{
+    QSqlQuery query(m_database);
+    return query.exec("SELECT COUNT(*) FROM musics") && query.next() ? query.value(0).toInt() : -1;
+}
+
+QTEST_MAIN(TestLibraryChecker)
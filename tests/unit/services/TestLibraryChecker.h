@@ -0,0 +1,50 @@
+#ifndef TESTLIBRARYCHECKER_H
+#define TESTLIBRARYCHECKER_H
+
+#include <QObject>
+#include <QSqlDatabase>
+#include <QTemporaryDir>
+#include <QTest>
+#include <memory>
+
+class LibraryChecker;
+
+/**
+ * @brief Unit tests for LibraryChecker class
+ *
+ * Tests the parallel check of the musics table including:
+ * - Reporting missing, empty and unreadable files as they are found
+ * - Updating changed durations and resetting play counts of readable files
+ * - Writing more records than fit in one batch
+ * - Keeping what was found when a check is cancelled
+ * - Pausing at a checkpoint and resuming from it in a later run
+ * - Removing records in one transaction
+ * - Reading durations with MediaProbe by default
+ */
+class TestLibraryChecker : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testChecksRecords();
+    void testBatchesWrites();
+    void testCancelKeepsResults();
+    void testPauseAndResume();
+    void testRemoveRecords();
+    void testDefaultProber();
+
+private:
+    QString addRecord(const QString& name, const QByteArray& bytes, const QString& time,
+                      int playedTimes = 0);
+    QString storedTime(const QString& path);
+    int playedTimes(const QString& path);
+    int recordCount();
+
+    std::unique_ptr<QTemporaryDir> m_tempDir;
+    QSqlDatabase m_database;
+};
+
+#endif // TESTLIBRARYCHECKER_H
@@ -0,0 +1,196 @@
+#include "TestLibraryIndex.h"
+#include "../../../src/services/LibraryIndex.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+void TestLibraryIndex::init()
+{
+    m_tempDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_tempDir->isValid());
+}
+
+void TestLibraryIndex::cleanup()
+{
+    m_tempDir.reset();
+}
+
+QString TestLibraryIndex::writeFile(const QString& name, const QByteArray& bytes)
+{
+    const QString path = m_tempDir->filePath("music/" + name);
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QFile file(path);
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(bytes);
+    }
+    return path;
+}
+
+void TestLibraryIndex::testFileNameFor()
+{
+    const QString name = LibraryIndex::fileNameFor("/srv/music");
+    QVERIFY(name.startsWith("library-"));
+    QVERIFY(name.endsWith(".index"));
+    QCOMPARE(LibraryIndex::fileNameFor("/srv/music/"), name);
+    QCOMPARE(LibraryIndex::fileNameFor("/srv/./music"), name);
+    QVERIFY(LibraryIndex::fileNameFor("/srv/jingles") != name);
+}
+
+void TestLibraryIndex::testWalk()
+{
+    const QString top = writeFile("a.mp3", "12345");
+    const QString nested = writeFile("rock/70s/b.ogg", "123");
+    writeFile("cover.jpg", "image");
+    writeFile("rock/notes.txt", "text");
+
+    const LibraryIndex::States states =
+        LibraryIndex::walk(m_tempDir->filePath("music"), {"*.mp3", "*.ogg"});
+    QCOMPARE(states.size(), 2);
+    QVERIFY(states.contains(top));
+    QVERIFY(states.contains(nested));
+    QCOMPARE(states.value(top).size, qint64(5));
+    QCOMPARE(states.value(nested).size, qint64(3));
+    QVERIFY(states.value(top).mtimeMs > 0);
+#ifdef Q_OS_UNIX
+    QVERIFY(states.value(top).inode != 0);
+    QVERIFY(states.value(top).inode != states.value(nested).inode);
+#endif
+
+    QCOMPARE(LibraryIndex::stat(top), states.value(top));
+    QCOMPARE(LibraryIndex::stat(m_tempDir->filePath("missing.mp3")).size, qint64(-1));
+    QCOMPARE(LibraryIndex::stat(m_tempDir->filePath("music")).size, qint64(-1));
+
+    std::atomic_bool cancelled{true};
+    QVERIFY(LibraryIndex::walk(m_tempDir->filePath("music"), {"*.mp3"}, &cancelled).isEmpty());
+}
+
+void TestLibraryIndex::testSaveAndLoad()
+{
+    const QString indexFile = m_tempDir->filePath("indexes/library.index");
+    const QString tabbed = writeFile("with\ttab.mp3", "1");
+
+    LibraryIndex index(indexFile);
+    QVERIFY(index.load());
+    QCOMPARE(index.fileCount(), 0);
+    QVERIFY(index.save());
+    QVERIFY(!QFile::exists(indexFile));
+
+    LibraryIndex::FileState state;
+    state.size = 1234;
+    state.mtimeMs = 1700000000123;
+    state.inode = 42;
+    index.insert("/srv/music/a.mp3", state);
+    index.insert(tabbed, LibraryIndex::stat(tabbed));
+    QVERIFY(index.isModified());
+    QVERIFY(index.save());
+    QVERIFY(!index.isModified());
+
+    LibraryIndex loaded(indexFile);
+    QVERIFY(loaded.load());
+    QCOMPARE(loaded.fileCount(), 2);
+    QCOMPARE(loaded.state("/srv/music/a.mp3"), state);
+    QVERIFY(loaded.contains(tabbed));
+
+    // Recording the same state again is not a change
+    loaded.insert("/srv/music/a.mp3", state);
+    QVERIFY(!loaded.isModified());
+    loaded.remove("/srv/music/missing.mp3");
+    QVERIFY(!loaded.isModified());
+    loaded.remove("/srv/music/a.mp3");
+    QVERIFY(loaded.isModified());
+}
+
+void TestLibraryIndex::testDiff()
+{
+    const QString root = m_tempDir->filePath("music");
+    const QString kept = writeFile("kept.mp3", "same");
+    const QString changed = writeFile("changed.mp3", "old");
+    const QString gone = writeFile("gone.mp3", "bye");
+
+    LibraryIndex index(m_tempDir->filePath("library.index"));
+    const LibraryIndex::States before = LibraryIndex::walk(root, {"*.mp3"});
+    for (auto it = before.cbegin(); it != before.cend(); ++it) {
+        index.insert(it.key(), it.value());
+    }
+    QVERIFY(index.diff(before).isEmpty());
+    QCOMPARE(index.diff(before).unchanged, 3);
+
+    writeFile("changed.mp3", "much longer");
+    QVERIFY(QFile::remove(gone));
+    const QString added = writeFile("added.mp3", "new file");
+
+    const LibraryIndex::Diff diff = index.diff(LibraryIndex::walk(root, {"*.mp3"}));
+    QCOMPARE(diff.added, QStringList{added});
+    QCOMPARE(diff.changed, QStringList{changed});
+    QCOMPARE(diff.removed, QStringList{gone});
+    QVERIFY(diff.renamed.isEmpty());
+    QCOMPARE(diff.unchanged, 1);
+    QVERIFY(index.contains(kept));
+
+    index.clear();
+    QCOMPARE(index.diff(LibraryIndex::walk(root, {"*.mp3"})).added.size(), 3);
+}
+
+void TestLibraryIndex::testDiffDetectsMoves()
+{
+    const QString root = m_tempDir->filePath("music");
+    const QString oldPath = writeFile("incoming/track.mp3", "audio bytes");
+    if (LibraryIndex::stat(oldPath).inode == 0) {
+        QSKIP("The platform reports no inodes");
+    }
+
+    LibraryIndex index(m_tempDir->filePath("library.index"));
+    index.insert(oldPath, LibraryIndex::stat(oldPath));
+
+    const QString newPath = m_tempDir->filePath("music/rock/track.mp3");
+    QVERIFY(QDir().mkpath(QFileInfo(newPath).absolutePath()));
+    QVERIFY(QFile::rename(oldPath, newPath));
+    const QString copy = writeFile("copy.mp3", "audio bytes");
+
+    const LibraryIndex::Diff diff = index.diff(LibraryIndex::walk(root, {"*.mp3"}));
+    QCOMPARE(diff.renamed.size(), 1);
+    QCOMPARE(diff.renamed.value(oldPath), newPath);
+    QCOMPARE(diff.added, QStringList{copy});
+    QVERIFY(diff.removed.isEmpty());
+    QVERIFY(diff.changed.isEmpty());
+}
+
+void TestLibraryIndex::testScanDirectory()
+{
+    const QString root = QDir::cleanPath(m_tempDir->filePath("music"));
+    const QString kept = writeFile("kept.mp3", "same");
+    const QString deep = writeFile("rock/70s/deep.mp3", "indexed");
+    const QString doomed = writeFile("doomed/a.mp3", "going");
+    writeFile("doomed/inner/b.mp3", "going too");
+
+    LibraryIndex index(m_tempDir->filePath("library.index"));
+    const LibraryIndex::States before = LibraryIndex::walk(root, {"*.mp3"});
+    for (auto it = before.cbegin(); it != before.cend(); ++it) {
+        index.insert(it.key(), it.value());
+    }
+    QCOMPARE(index.filesUnder(root + "/doomed").size(), 2);
+    QCOMPARE(index.filesUnder(root).size(), 4);
+
+    QVERIFY(QDir(QFileInfo(doomed).absolutePath()).removeRecursively());
+    const QString dropped = writeFile("new album/disc 1/track.mp3", "new");
+    const QString added = writeFile("added.mp3", "new too");
+
+    LibraryIndex::States known;
+    LibraryIndex::States current;
+    index.scanDirectory(root, {"*.mp3"}, &known, &current);
+
+    // rock/ is known and still there, so it is not looked into
+    QVERIFY(!known.contains(deep));
+    QVERIFY(!current.contains(deep));
+
+    const LibraryIndex::Diff diff = LibraryIndex::compare(known, current);
+    QStringList addedFiles = diff.added;
+    addedFiles.sort();
+    QCOMPARE(addedFiles, (QStringList{added, dropped}));
+    QCOMPARE(diff.removed.size(), 2);
+    QVERIFY(diff.removed.contains(doomed));
+    QCOMPARE(diff.unchanged, 1);
+    QVERIFY(index.contains(kept));
+}
+
+QTEST_MAIN(TestLibraryIndex)
@@ -0,0 +1,41 @@
+#ifndef TESTLIBRARYINDEX_H
+#define TESTLIBRARYINDEX_H
+
+#include <QObject>
+#include <QTemporaryDir>
+#include <QTest>
+#include <memory>
+
+/**
+ * @brief Unit tests for LibraryIndex class
+ *
+ * Tests the file-state index of a library root including:
+ * - Naming index files after their root
+ * - Walking a tree with name filters and stating files
+ * - Saving and loading, and not writing an unchanged index
+ * - Sorting files into added, changed, removed and unchanged
+ * - Recognising moved files by inode and size
+ * - Comparing single directories, with folders dropped in or deleted
+ */
+class TestLibraryIndex : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testFileNameFor();
+    void testWalk();
+    void testSaveAndLoad();
+    void testDiff();
+    void testDiffDetectsMoves();
+    void testScanDirectory();
+
+private:
+    QString writeFile(const QString& name, const QByteArray& bytes);
+
+    std::unique_ptr<QTemporaryDir> m_tempDir;
+};
+
+#endif // TESTLIBRARYINDEX_H
@@ -0,0 +1,381 @@
+#include "TestLibraryRescanner.h"
+#include "../../../src/repositories/MusicRepository.h"
+#include "../../../src/services/LibraryRescanner.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSignalSpy>
+#include <QSqlQuery>
+#include <atomic>
+
+namespace {
+
+const char* CONNECTION_NAME = "test_library_rescanner_connection";
+
+std::atomic_int s_reads{0};
+
+// Stands in for TagReader: files with "bad" in the name cannot be read,
+// files with "untagged" have no tags, and every other file is tagged with
+// its name and lasts as many seconds as it has bytes
+TagReader::Tags fakeTags(const QString& filePath, QString* error)
+{
+    ++s_reads;
+    TagReader::Tags tags;
+    if (filePath.contains("bad")) {
+        *error = "Permission denied";
+        return tags;
+    }
+    tags.durationUs = QFileInfo(filePath).size() * 1000000;
+    if (!filePath.contains("untagged")) {
+        tags.artist = "Artist";
+        tags.title = QFileInfo(filePath).completeBaseName();
+        tags.genre = "Rock";
+    }
+    return tags;
+}
+
+} // namespace
+
+void TestLibraryRescanner::init()
+{
+    m_tempDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_tempDir->isValid());
+    m_root = m_tempDir->filePath("music");
+    QVERIFY(QDir().mkpath(m_root));
+    s_reads = 0;
+
+    m_database = QSqlDatabase::addDatabase("QSQLITE", CONNECTION_NAME);
+    m_database.setDatabaseName(m_tempDir->filePath("test.db"));
+    QVERIFY(m_database.open());
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("CREATE TABLE musics (id INTEGER PRIMARY KEY AUTOINCREMENT, "
+                       "artist TEXT, song TEXT, genre1 TEXT, genre2 TEXT, country TEXT, "
+                       "published_date TEXT, path TEXT, time TEXT, "
+                       "played_times INTEGER DEFAULT 0, last_played TEXT)"));
+    m_repository = std::make_unique<MusicRepository>(m_database);
+}
+
+void TestLibraryRescanner::cleanup()
+{
+    m_repository.reset();
+    if (m_database.isOpen()) {
+        m_database.close();
+    }
+    m_database = QSqlDatabase();
+    QSqlDatabase::removeDatabase(CONNECTION_NAME);
+    m_tempDir.reset();
+}
+
+QString TestLibraryRescanner::writeFile(const QString& name, const QByteArray& bytes)
+{
+    const QString path = QDir(m_root).filePath(name);
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QFile file(path);
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(bytes);
+    }
+    return path;
+}
+
+std::unique_ptr<LibraryRescanner> TestLibraryRescanner::makeRescanner()
+{
+    auto rescanner = std::make_unique<LibraryRescanner>(m_repository.get());
+    rescanner->setRoots({m_root});
+    rescanner->setIndexDirectory(m_tempDir->filePath("indexes"));
+    rescanner->setNameFilters({"*.mp3"});
+    rescanner->setTagSource(fakeTags);
+    return rescanner;
+}
+
+bool TestLibraryRescanner::rescan(LibraryRescanner& rescanner)
+{
+    QSignalSpy finished(&rescanner, &LibraryRescanner::finished);
+    return rescanner.start() && finished.wait(10000);
+}
+
+int TestLibraryRescanner::trackCount()
+{
+    QSqlQuery query(m_database);
+    return query.exec("SELECT COUNT(*) FROM musics") && query.next() ? query.value(0).toInt() : -1;
+}
+
+int TestLibraryRescanner::trackId(const QString& path)
+{
+    QSqlQuery query(m_database);
+    query.prepare("SELECT id FROM musics WHERE path = ?");
+    query.addBindValue(path);
+    return query.exec() && query.next() ? query.value(0).toInt() : -1;
+}
+
+QString TestLibraryRescanner::storedField(const QString& path, const QString& column)
+{
+    QSqlQuery query(m_database);
+    query.prepare(QString("SELECT %1 FROM musics WHERE path = ?").arg(column));
+    query.addBindValue(path);
+    return query.exec() && query.next() ? query.value(0).toString() : QString();
+}
+
+void TestLibraryRescanner::testAddsNewFiles()
+{
+    const QString first = writeFile("first.mp3", QByteArray(5, 'a'));
+    const QString nested = writeFile("rock/second.mp3", QByteArray(7, 'b'));
+    const QString bad = writeFile("bad.mp3", "cannot open");
+    writeFile("cover.jpg", "image");
+
+    auto rescanner = makeRescanner();
+    QSignalSpy finished(rescanner.get(), &LibraryRescanner::finished);
+    QSignalSpy progress(rescanner.get(), &LibraryRescanner::progressChanged);
+    QVERIFY(rescanner->start());
+    QVERIFY(rescanner->isRunning());
+    QVERIFY(!rescanner->start());
+    QVERIFY(finished.wait(10000));
+    QVERIFY(!rescanner->isRunning());
+
+    const auto report = finished.at(0).at(0).value<LibraryRescanner::Report>();
+    QCOMPARE(report.roots, 1);
+    QCOMPARE(report.files, 3);
+    QCOMPARE(report.added, 2);
+    QCOMPARE(report.failed, 1);
+    QCOMPARE(report.unchanged, 0);
+    QVERIFY(!report.cancelled);
+    QCOMPARE(progress.count(), 3);
+    QCOMPARE(progress.last().at(0).toInt(), 3);
+    QCOMPARE(progress.last().at(1).toInt(), 3);
+
+    QCOMPARE(trackCount(), 2);
+    QCOMPARE(storedField(first, "song"), QString("first"));
+    QCOMPARE(storedField(nested, "genre1"), QString("Rock"));
+    QCOMPARE(storedField(nested, "time"), QString("0:00:07"));
+
+    // Only the written files are indexed, so the unreadable one is tried again
+    LibraryIndex index(QDir(m_tempDir->filePath("indexes")).filePath(
+        LibraryIndex::fileNameFor(m_root)));
+    QVERIFY(index.load());
+    QCOMPARE(index.fileCount(), 2);
+    QVERIFY(!index.contains(bad));
+
+    s_reads = 0;
+    QVERIFY(rescan(*rescanner));
+    QCOMPARE(s_reads.load(), 1);
+}
+
+void TestLibraryRescanner::testUnchangedReadsNothing()
+{
+    for (int i = 0; i < 20; ++i) {
+        writeFile(QString("track%1.mp3").arg(i), QByteArray(i + 1, 'x'));
+    }
+
+    auto rescanner = makeRescanner();
+    QVERIFY(rescan(*rescanner));
+    QCOMPARE(s_reads.load(), 20);
+    QCOMPARE(trackCount(), 20);
+
+    // A fresh rescanner reads the saved index
+    s_reads = 0;
+    auto next = makeRescanner();
+    QSignalSpy finished(next.get(), &LibraryRescanner::finished);
+    QSignalSpy progress(next.get(), &LibraryRescanner::progressChanged);
+    QVERIFY(next->start());
+    QVERIFY(finished.wait(10000));
+
+    const auto report = finished.at(0).at(0).value<LibraryRescanner::Report>();
+    QCOMPARE(report.files, 20);
+    QCOMPARE(report.unchanged, 20);
+    QCOMPARE(report.changes(), 0);
+    QCOMPARE(s_reads.load(), 0);
+    QCOMPARE(progress.count(), 0);
+}
+
+void TestLibraryRescanner::testRefreshesChangedFiles()
+{
+    const QString tagged = writeFile("tagged.mp3", QByteArray(3, 'a'));
+    const QString untagged = writeFile("untagged.mp3", QByteArray(4, 'b'));
+
+    auto rescanner = makeRescanner();
+    QVERIFY(rescan(*rescanner));
+    const int id = trackId(untagged);
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec(QString("UPDATE musics SET artist = 'Edited', played_times = 7 "
+                               "WHERE id = %1").arg(id)));
+
+    writeFile("tagged.mp3", QByteArray(30, 'a'));
+    writeFile("untagged.mp3", QByteArray(40, 'b'));
+
+    QSignalSpy finished(rescanner.get(), &LibraryRescanner::finished);
+    s_reads = 0;
+    QVERIFY(rescanner->start());
+    QVERIFY(finished.wait(10000));
+    const auto report = finished.at(0).at(0).value<LibraryRescanner::Report>();
+    QCOMPARE(report.updated, 2);
+    QCOMPARE(report.added, 0);
+    QCOMPARE(s_reads.load(), 2);
+
+    QCOMPARE(trackCount(), 2);
+    QCOMPARE(storedField(tagged, "time"), QString("0:00:30"));
+    QCOMPARE(storedField(untagged, "time"), QString("0:00:40"));
+    QCOMPARE(trackId(untagged), id);
+    QCOMPARE(storedField(untagged, "artist"), QString("Edited"));
+    QCOMPARE(storedField(untagged, "played_times"), QString("7"));
+}
+
+void TestLibraryRescanner::testMovesAndRemoves()
+{
+    const QString moving = writeFile("incoming/moving.mp3", QByteArray(6, 'm'));
+    const QString deleted = writeFile("deleted.mp3", QByteArray(8, 'd'));
+    writeFile("staying.mp3", QByteArray(9, 's'));
+
+    auto rescanner = makeRescanner();
+    QVERIFY(rescan(*rescanner));
+    QCOMPARE(trackCount(), 3);
+    const int id = trackId(moving);
+
+    const QString moved = QDir(m_root).filePath("rock/moving.mp3");
+    QVERIFY(QDir().mkpath(QFileInfo(moved).absolutePath()));
+    QVERIFY(QFile::rename(moving, moved));
+    QVERIFY(QFile::remove(deleted));
+
+    QSignalSpy finished(rescanner.get(), &LibraryRescanner::finished);
+    s_reads = 0;
+    QVERIFY(rescanner->start());
+    QVERIFY(finished.wait(10000));
+    const auto report = finished.at(0).at(0).value<LibraryRescanner::Report>();
+    QCOMPARE(report.removed, 1);
+    QCOMPARE(trackCount(), 2);
+    QCOMPARE(trackId(deleted), -1);
+
+    if (LibraryIndex::stat(moved).inode == 0) {
+        // Without inodes a move is a removal and an addition
+        QCOMPARE(report.added, 1);
+        return;
+    }
+    QCOMPARE(report.renamed, 1);
+    QCOMPARE(report.added, 0);
+    QCOMPARE(s_reads.load(), 0);
+    QCOMPARE(trackId(moved), id);
+    QCOMPARE(trackId(moving), -1);
+}
+
+void TestLibraryRescanner::testIndexesImportedFiles()
+{
+    const QString imported = writeFile("imported.mp3", QByteArray(5, 'i'));
+    const QString fresh = writeFile("fresh.mp3", QByteArray(5, 'f'));
+    QCOMPARE(m_repository->addMusicBatch({MusicRepository::itemFromTags(
+                 imported, fakeTags(imported, nullptr))}),
+             1);
+    s_reads = 0;
+
+    auto rescanner = makeRescanner();
+    QSignalSpy finished(rescanner.get(), &LibraryRescanner::finished);
+    QVERIFY(rescanner->start());
+    QVERIFY(finished.wait(10000));
+    const auto report = finished.at(0).at(0).value<LibraryRescanner::Report>();
+    QCOMPARE(report.added, 1);
+    QCOMPARE(report.unchanged, 1);
+    QCOMPARE(s_reads.load(), 1);
+    QCOMPARE(trackCount(), 2);
+    QVERIFY(trackId(fresh) > 0);
+}
+
+void TestLibraryRescanner::testSkipsUnmountedRoots()
+{
+    const QString track = writeFile("share/track.mp3", QByteArray(5, 't'));
+    const QString share = QFileInfo(track).absolutePath();
+
+    auto rescanner = makeRescanner();
+    rescanner->setRoots({share, m_tempDir->filePath("never-mounted")});
+    QVERIFY(rescan(*rescanner));
+    QCOMPARE(trackCount(), 1);
+
+    // An unmounted share leaves an empty mount point behind
+    QVERIFY(QFile::remove(track));
+    QSignalSpy finished(rescanner.get(), &LibraryRescanner::finished);
+    QVERIFY(rescanner->start());
+    QVERIFY(finished.wait(10000));
+    const auto report = finished.at(0).at(0).value<LibraryRescanner::Report>();
+    QCOMPARE(report.skippedRoots, 2);
+    QCOMPARE(report.roots, 0);
+    QCOMPARE(report.removed, 0);
+    QCOMPARE(trackCount(), 1);
+}
+
+void TestLibraryRescanner::testRescansDirectories()
+{
+    writeFile("rock/old.mp3", QByteArray(4, 'o'));
+    const QString untouched = writeFile("jazz/untouched.mp3", QByteArray(5, 'u'));
+    auto rescanner = makeRescanner();
+    QVERIFY(rescan(*rescanner));
+    QCOMPARE(trackCount(), 2);
+
+    // A file added in a directory that is not reported is left for later
+    const QString dropped = writeFile("rock/dropped.mp3", QByteArray(6, 'd'));
+    const QString unseen = writeFile("jazz/unseen.mp3", QByteArray(7, 'n'));
+    QVERIFY(QFile::remove(untouched));
+
+    QSignalSpy finished(rescanner.get(), &LibraryRescanner::finished);
+    s_reads = 0;
+    QVERIFY(!rescanner->rescanDirectories({m_tempDir->filePath("elsewhere")}));
+    QVERIFY(rescanner->rescanDirectories({QDir(m_root).filePath("rock")}));
+    QVERIFY(finished.wait(10000));
+    auto report = finished.at(0).at(0).value<LibraryRescanner::Report>();
+    QCOMPARE(report.added, 1);
+    QCOMPARE(report.removed, 0);
+    QCOMPARE(report.unchanged, 1);
+    QCOMPARE(s_reads.load(), 1);
+    QVERIFY(trackId(dropped) > 0);
+    QCOMPARE(trackId(unseen), -1);
+    QVERIFY(trackId(untouched) > 0);
+
+    // Directories reported during a rescan are done right after it, in one go
+    const QString late = writeFile("rock/late.mp3", QByteArray(8, 'l'));
+    QVERIFY(rescanner->start());
+    QVERIFY(rescanner->rescanDirectories({QDir(m_root).filePath("rock")}));
+    QVERIFY(rescanner->rescanDirectories({QDir(m_root).filePath("jazz")}));
+    QTRY_COMPARE_WITH_TIMEOUT(finished.count(), 3, 10000);
+    QVERIFY(!rescanner->isRunning());
+    QVERIFY(trackId(late) > 0);
+    QVERIFY(trackId(unseen) > 0);
+    QCOMPARE(trackId(untouched), -1);
+    report = finished.at(2).at(0).value<LibraryRescanner::Report>();
+    QCOMPARE(report.changes(), 0);
+}
+
+void TestLibraryRescanner::testBatchesWrites()
+{
+    const int count = LibraryRescanner::BATCH_SIZE + 25;
+    for (int i = 0; i < count; ++i) {
+        writeFile(QString("batch/track%1.mp3").arg(i), QByteArray::number(i));
+    }
+
+    auto rescanner = makeRescanner();
+    rescanner->setMaxWorkers(3);
+    QCOMPARE(rescanner->maxWorkers(), 3);
+    QSignalSpy finished(rescanner.get(), &LibraryRescanner::finished);
+    QVERIFY(rescanner->start());
+    QVERIFY(finished.wait(30000));
+    const auto report = finished.at(0).at(0).value<LibraryRescanner::Report>();
+    QCOMPARE(report.added, count);
+    QCOMPARE(trackCount(), count);
+}
+
+void TestLibraryRescanner::testCancel()
+{
+    for (int i = 0; i < 50; ++i) {
+        writeFile(QString("track%1.mp3").arg(i), QByteArray(i + 1, 'c'));
+    }
+
+    auto rescanner = makeRescanner();
+    QSignalSpy finished(rescanner.get(), &LibraryRescanner::finished);
+    QVERIFY(rescanner->start());
+    rescanner->cancel();
+    QCOMPARE(finished.count(), 1);
+    QVERIFY(!rescanner->isRunning());
+    QVERIFY(finished.at(0).at(0).value<LibraryRescanner::Report>().cancelled);
+
+    // Late results of the cancelled rescan are dropped, and a new one finishes the job
+    QTest::qWait(100);
+    QCOMPARE(finished.count(), 1);
+    QVERIFY(rescan(*rescanner));
+    QCOMPARE(trackCount(), 50);
+}
+
+QTEST_MAIN(TestLibraryRescanner)
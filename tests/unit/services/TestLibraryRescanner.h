@@ -0,0 +1,60 @@
+#ifndef TESTLIBRARYRESCANNER_H
+#define TESTLIBRARYRESCANNER_H
+
+#include <QObject>
+#include <QSqlDatabase>
+#include <QTemporaryDir>
+#include <QTest>
+#include <memory>
+
+class LibraryRescanner;
+class MusicRepository;
+
+/**
+ * @brief Unit tests for LibraryRescanner class
+ *
+ * Tests the incremental rescan of library roots including:
+ * - Adding the files of a new root and offering unreadable ones again
+ * - Reading nothing when nothing changed
+ * - Refreshing changed files without losing fields the tags leave out
+ * - Moving the tracks of moved files and removing those of deleted files
+ * - Indexing files that were imported before without reading them
+ * - Leaving missing and emptied roots alone
+ * - Rescanning only the directories that changed, and queueing them during a rescan
+ * - Writing more tracks than fit in one batch
+ * - Stopping on cancel()
+ */
+class TestLibraryRescanner : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testAddsNewFiles();
+    void testUnchangedReadsNothing();
+    void testRefreshesChangedFiles();
+    void testMovesAndRemoves();
+    void testIndexesImportedFiles();
+    void testSkipsUnmountedRoots();
+    void testRescansDirectories();
+    void testBatchesWrites();
+    void testCancel();
+
+private:
+    QString writeFile(const QString& name, const QByteArray& bytes);
+    std::unique_ptr<LibraryRescanner> makeRescanner();
+    bool rescan(LibraryRescanner& rescanner);
+    int trackCount();
+    int trackId(const QString& path);
+    QString storedField(const QString& path, const QString& column);
+
+    std::unique_ptr<QTemporaryDir> m_tempDir;
+    QSqlDatabase m_database;
+    std::unique_ptr<MusicRepository> m_repository;
+    QString m_root;
+    int m_reads = 0;
+};
+
+#endif // TESTLIBRARYRESCANNER_H
@@ -0,0 +1,199 @@
+#include "TestLibrarySnapshot.h"
+#include "../../../src/services/LibrarySnapshot.h"
+#include "../../../src/services/RotationEngine.h"
+#include <QSignalSpy>
+#include <QSqlQuery>
+
+namespace {
+
+const char* CONNECTION_NAME = "test_library_snapshot_connection";
+
+} // namespace
+
+void TestLibrarySnapshot::init()
+{
+    m_tempDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_tempDir->isValid());
+
+    m_database = QSqlDatabase::addDatabase("QSQLITE", CONNECTION_NAME);
+    m_database.setDatabaseName(m_tempDir->path() + "/library.db");
+    QVERIFY(m_database.open());
+
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("CREATE TABLE musics (id INTEGER PRIMARY KEY AUTOINCREMENT, artist TEXT, "
+                       "song TEXT, genre1 TEXT, genre2 TEXT, country TEXT, published_date TEXT, "
+                       "path TEXT, time TEXT, played_times INTEGER DEFAULT 0, last_played TEXT)"));
+    m_nextTrack = 1;
+}
+
+void TestLibrarySnapshot::cleanup()
+{
+    if (m_database.isOpen()) {
+        m_database.close();
+    }
+    m_database = QSqlDatabase();
+    QSqlDatabase::removeDatabase(CONNECTION_NAME);
+    m_tempDir.reset();
+}
+
+void TestLibrarySnapshot::addTrack(const QString& artist, const QString& song,
+                                   const QString& genre, const QString& time)
+{
+    QSqlQuery query(m_database);
+    query.prepare("INSERT INTO musics (artist, song, genre1, path, time) VALUES (?, ?, ?, ?, ?)");
+    query.addBindValue(artist);
+    query.addBindValue(song);
+    query.addBindValue(genre);
+    query.addBindValue(QString("/music/track%1.ogg").arg(m_nextTrack++));
+    query.addBindValue(time);
+    QVERIFY(query.exec());
+}
+
+void TestLibrarySnapshot::testFromRows()
+{
+    const LibrarySnapshot::Ptr library = LibrarySnapshot::fromRows({
+        {7, "/music/c.ogg", "Artist B", "Song C", "rock ", 3000000},
+        {2, "/music/a.ogg", "Artist A", "Song A", "Rock", 1000000},
+        {5, "/music/b.ogg", "artist a", "Song B", "", -1},
+        {9, "", "Artist C", "No Path", "Jazz", -1},
+    });
+
+    QCOMPARE(library->size(), 3);
+    QCOMPARE(library->ids(), QVector<int>({2, 5, 7}));
+    QCOMPARE(library->durationsUs(), QVector<qint64>({1000000, -1, 3000000}));
+
+    // Names are stored once, as first spelled, and an empty one has no id
+    QCOMPARE(library->genres(), QStringList({"Rock"}));
+    QCOMPARE(library->artists(), QStringList({"Artist A", "Artist B"}));
+    QCOMPARE(library->genre(1), QString());
+    QCOMPARE(library->artist(1), QString("Artist A"));
+    QCOMPARE(library->artist(2), QString("Artist B"));
+    QCOMPARE(library->genre(2), QString("Rock"));
+
+    QCOMPARE(library->genreId(" ROCK"), 0);
+    QCOMPARE(library->genreId("Jazz"), LibrarySnapshot::NONE);
+    QCOMPARE(library->artistId("artist b"), 1);
+    QCOMPARE(library->rowsOfGenre(0), QVector<int>({0, 2}));
+    QVERIFY(library->rowsOfGenre(LibrarySnapshot::NONE).isEmpty());
+
+    QCOMPARE(library->rowOf(5), 1);
+    QCOMPARE(library->rowOf(6), -1);
+    QCOMPARE(library->rowOfPath("/music/c.ogg"), 2);
+    QCOMPARE(library->rowOfPath("/music/none.ogg"), -1);
+    QCOMPARE(library->path(2), QString("/music/c.ogg"));
+    QCOMPARE(library->song(0), QString("Song A"));
+}
+
+void TestLibrarySnapshot::testLoad()
+{
+    addTrack("Artist A", "Song A", "Rock", "3:30");
+    addTrack("Artist B", "Song B", "Pop", "1:02:03");
+    addTrack("Artist C", "Song C", "Pop", "unknown");
+
+    QString error;
+    const LibrarySnapshot::Ptr library = LibrarySnapshot::load(m_database, &error);
+    QVERIFY2(library, qPrintable(error));
+    QCOMPARE(library->size(), 3);
+    QCOMPARE(library->durationsUs(), QVector<qint64>({210000000LL, 3723000000LL, -1}));
+    QCOMPARE(library->rowsOfGenre(library->genreId("pop")), QVector<int>({1, 2}));
+
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("DROP TABLE musics"));
+    QVERIFY(!LibrarySnapshot::load(m_database, &error));
+    QVERIFY(!error.isEmpty());
+}
+
+void TestLibrarySnapshot::testStoreRebuild()
+{
+    addTrack("Artist A", "Song A", "Rock", "3:00");
+    addTrack("Artist B", "Song B", "Rock", "4:00");
+
+    LibrarySnapshotStore store(m_database.databaseName());
+    QVERIFY(!store.current());
+    QSignalSpy rebuilt(&store, &LibrarySnapshotStore::rebuilt);
+
+    store.rebuild();
+    QVERIFY(store.isRebuilding());
+    QVERIFY(rebuilt.wait());
+    const LibrarySnapshot::Ptr library = store.current();
+    QVERIFY(library);
+    QCOMPARE(library->size(), 2);
+    QCOMPARE(store.generation(), 1);
+
+    // Rebuilds asked for while one runs are folded into one more
+    addTrack("Artist C", "Song C", "Jazz", "5:00");
+    store.rebuild();
+    store.rebuild();
+    store.rebuild();
+    QTRY_COMPARE(rebuilt.count(), 3);
+    QTest::qWait(50);
+    QCOMPARE(rebuilt.count(), 3);
+    QCOMPARE(store.current()->size(), 3);
+    QVERIFY(!store.isRebuilding());
+    // A reader keeps the snapshot it got
+    QCOMPARE(library->size(), 2);
+}
+
+void TestLibrarySnapshot::testRotationReadsSnapshot()
+{
+    addTrack("Artist A", "Song A", "Rock");
+    addTrack("Artist B", "Song B", "Rock");
+
+    LibrarySnapshotStore store(m_database.databaseName());
+    QSignalSpy rebuilt(&store, &LibrarySnapshotStore::rebuilt);
+    store.rebuild();
+    QVERIFY(rebuilt.wait());
+
+    // With the snapshot loaded the table is not read again
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("DELETE FROM musics"));
+
+    RotationEngine rotation(m_database);
+    rotation.setSnapshots(&store);
+    rotation.setSeparation(0);
+    QVERIFY(rotation.reload());
+    QCOMPARE(rotation.trackCount(), 2);
+    QVERIFY(rotation.nextTrack("rock").startsWith("/music/track"));
+
+    rotation.setSnapshots(nullptr);
+    QVERIFY(rotation.reload());
+    QCOMPARE(rotation.trackCount(), 0);
+}
+
+void TestLibrarySnapshot::testRebuildFailed()
+{
+    addTrack("Artist A", "Song A", "Rock");
+
+    LibrarySnapshotStore store(m_database.databaseName());
+    QSignalSpy rebuilt(&store, &LibrarySnapshotStore::rebuilt);
+    QSignalSpy failed(&store, &LibrarySnapshotStore::rebuildFailed);
+    store.rebuild();
+    QVERIFY(rebuilt.wait());
+    QVERIFY(!store.isStale());
+
+    RotationEngine rotation(m_database);
+    rotation.setSnapshots(&store);
+    // Wired as the player wires them
+    connect(&store, &LibrarySnapshotStore::rebuildFailed, &rotation, &RotationEngine::invalidate);
+    QVERIFY(rotation.reload());
+    QCOMPARE(rotation.trackCount(), 1);
+
+    // The snapshot can no longer read the table, the rotation still can
+    addTrack("Artist B", "Song B", "Rock");
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("ALTER TABLE musics RENAME COLUMN time TO length"));
+    store.rebuild();
+    QVERIFY(failed.wait());
+    QVERIFY(store.isStale());
+    QCOMPARE(store.current()->size(), 1);
+    QVERIFY(!rotation.nextTrack().isEmpty());
+    QCOMPARE(rotation.trackCount(), 2);
+
+    QVERIFY(query.exec("ALTER TABLE musics RENAME COLUMN length TO time"));
+    store.rebuild();
+    QVERIFY(rebuilt.wait());
+    QVERIFY(!store.isStale());
+    QCOMPARE(store.current()->size(), 2);
+}
+
+QTEST_MAIN(TestLibrarySnapshot)
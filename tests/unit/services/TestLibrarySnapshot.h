@@ -0,0 +1,44 @@
+#ifndef TESTLIBRARYSNAPSHOT_H
+#define TESTLIBRARYSNAPSHOT_H
+
+#include <QObject>
+#include <QTest>
+#include <QSqlDatabase>
+#include <QTemporaryDir>
+#include <memory>
+
+/**
+ * @brief Unit tests for LibrarySnapshot and LibrarySnapshotStore classes
+ *
+ * Tests the in-memory library including:
+ * - Columns in id order, with artists and genres stored once
+ * - Lookups by id, path and genre
+ * - Reading the musics table and its durations
+ * - Rebuilding in the background, and folding rebuilds asked for meanwhile
+ * - Auto mode picking from the snapshot instead of the table
+ * - Auto mode reading the table again after a failed rebuild
+ */
+class TestLibrarySnapshot : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testFromRows();
+    void testLoad();
+    void testStoreRebuild();
+    void testRotationReadsSnapshot();
+    void testRebuildFailed();
+
+private:
+    void addTrack(const QString& artist, const QString& song, const QString& genre,
+                  const QString& time = QString());
+
+    std::unique_ptr<QTemporaryDir> m_tempDir;
+    QSqlDatabase m_database;
+    int m_nextTrack = 1;
+};
+
+#endif // TESTLIBRARYSNAPSHOT_H
@@ -0,0 +1,169 @@
+#include "TestLibraryWatcher.h"
+#include "../../../src/services/LibraryWatcher.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSignalSpy>
+
+void TestLibraryWatcher::init()
+{
+    m_tempDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_tempDir->isValid());
+    m_root = QDir::cleanPath(m_tempDir->filePath("music"));
+    QVERIFY(QDir().mkpath(m_root));
+}
+
+void TestLibraryWatcher::cleanup()
+{
+    m_tempDir.reset();
+}
+
+QString TestLibraryWatcher::makeDirectory(const QString& name)
+{
+    const QString path = QDir(m_root).filePath(name);
+    QDir().mkpath(path);
+    return path;
+}
+
+QString TestLibraryWatcher::writeFile(const QString& name, const QByteArray& bytes)
+{
+    const QString path = QDir(m_root).filePath(name);
+    QFile file(path);
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(bytes);
+    }
+    return path;
+}
+
+std::unique_ptr<LibraryWatcher> TestLibraryWatcher::makeWatcher()
+{
+    auto watcher = std::make_unique<LibraryWatcher>();
+    watcher->setDebounceInterval(100);
+    watcher->setSettleInterval(0);
+    QSignalSpy ready(watcher.get(), &LibraryWatcher::ready);
+    watcher->setRoots({m_root});
+    if (!ready.wait(5000)) {
+        return nullptr;
+    }
+    return watcher;
+}
+
+void TestLibraryWatcher::testWatchesTree()
+{
+    makeDirectory("rock/70s");
+    makeDirectory("jazz");
+
+    auto watcher = std::make_unique<LibraryWatcher>();
+    QSignalSpy ready(watcher.get(), &LibraryWatcher::ready);
+    watcher->setRoots({m_root, m_root + "/"});
+    QCOMPARE(watcher->roots(), QStringList{m_root});
+    QCOMPARE(watcher->watchedDirectoryCount(), 0);
+    QVERIFY(ready.wait(5000));
+
+    QCOMPARE(ready.at(0).at(0).toInt(), 4);
+    QCOMPARE(ready.at(0).at(1).toInt(), 0);
+    QCOMPARE(watcher->watchedDirectoryCount(), 4);
+}
+
+void TestLibraryWatcher::testReportsNestedChange()
+{
+    const QString nested = makeDirectory("rock/70s");
+    auto watcher = makeWatcher();
+    QVERIFY(watcher);
+
+    QSignalSpy changed(watcher.get(), &LibraryWatcher::directoriesChanged);
+    writeFile("rock/70s/track.mp3", "audio");
+    QTRY_COMPARE_WITH_TIMEOUT(changed.count(), 1, 5000);
+    QCOMPARE(changed.at(0).at(0).toStringList(), QStringList{nested});
+    QVERIFY(!watcher->hasPendingChanges());
+}
+
+void TestLibraryWatcher::testWatchesNewDirectories()
+{
+    auto watcher = makeWatcher();
+    QVERIFY(watcher);
+    QCOMPARE(watcher->watchedDirectoryCount(), 1);
+
+    // A folder copied in, with a subfolder of its own
+    QSignalSpy changed(watcher.get(), &LibraryWatcher::directoriesChanged);
+    makeDirectory("new album/disc 1");
+    QTRY_COMPARE_WITH_TIMEOUT(changed.count(), 1, 5000);
+    QVERIFY(changed.at(0).at(0).toStringList().contains(m_root));
+    QCOMPARE(watcher->watchedDirectoryCount(), 3);
+
+    writeFile("new album/disc 1/track.mp3", "audio");
+    QTRY_VERIFY_WITH_TIMEOUT(changed.count() >= 2, 5000);
+    QVERIFY(changed.last().at(0).toStringList().contains(m_root + "/new album/disc 1"));
+}
+
+void TestLibraryWatcher::testBurstIsCoalesced()
+{
+    makeDirectory("a");
+    makeDirectory("b");
+    auto watcher = makeWatcher();
+    QVERIFY(watcher);
+    watcher->setDebounceInterval(300);
+
+    QSignalSpy changed(watcher.get(), &LibraryWatcher::directoriesChanged);
+    for (int i = 0; i < 10; ++i) {
+        writeFile(QString("a/track%1.mp3").arg(i), "audio");
+        writeFile(QString("b/track%1.mp3").arg(i), "audio");
+        QTest::qWait(20);
+    }
+    QTRY_COMPARE_WITH_TIMEOUT(changed.count(), 1, 5000);
+    QTest::qWait(500);
+    QCOMPARE(changed.count(), 1);
+
+    const QStringList expected{m_root + "/a", m_root + "/b"};
+    QCOMPARE(changed.at(0).at(0).toStringList(), expected);
+}
+
+void TestLibraryWatcher::testHoldsBackUnsettledFiles()
+{
+    auto watcher = makeWatcher();
+    QVERIFY(watcher);
+    watcher->setSettleInterval(1000);
+
+    QSignalSpy changed(watcher.get(), &LibraryWatcher::directoriesChanged);
+    writeFile("uploading.mp3", "audio");
+
+    // Reported once the file has been left alone for the settle interval
+    QTest::qWait(600);
+    QCOMPARE(changed.count(), 0);
+    QVERIFY(watcher->hasPendingChanges());
+    QTRY_COMPARE_WITH_TIMEOUT(changed.count(), 1, 5000);
+    QCOMPARE(changed.at(0).at(0).toStringList(), QStringList{m_root});
+}
+
+void TestLibraryWatcher::testReportsDeletedDirectories()
+{
+    const QString doomed = makeDirectory("doomed/inner");
+    auto watcher = makeWatcher();
+    QVERIFY(watcher);
+    QCOMPARE(watcher->watchedDirectoryCount(), 3);
+
+    QSignalSpy changed(watcher.get(), &LibraryWatcher::directoriesChanged);
+    QVERIFY(QDir(QFileInfo(doomed).absolutePath()).removeRecursively());
+    QTRY_VERIFY_WITH_TIMEOUT(changed.count() >= 1, 5000);
+    QTest::qWait(300);
+
+    QStringList reported;
+    for (const QList<QVariant>& arguments : std::as_const(changed)) {
+        reported += arguments.at(0).toStringList();
+    }
+    QVERIFY(reported.contains(m_root));
+    QCOMPARE(watcher->watchedDirectoryCount(), 1);
+}
+
+void TestLibraryWatcher::testMissingRoot()
+{
+    LibraryWatcher watcher;
+    QSignalSpy ready(&watcher, &LibraryWatcher::ready);
+    watcher.setRoots({m_tempDir->filePath("not-mounted")});
+    QCOMPARE(watcher.roots().size(), 1);
+    QTest::qWait(100);
+    QCOMPARE(ready.count(), 0);
+    QCOMPARE(watcher.watchedDirectoryCount(), 0);
+}
+
+QTEST_MAIN(TestLibraryWatcher)
@@ -0,0 +1,48 @@
+#ifndef TESTLIBRARYWATCHER_H
+#define TESTLIBRARYWATCHER_H
+
+#include <QObject>
+#include <QTemporaryDir>
+#include <QTest>
+#include <memory>
+
+class LibraryWatcher;
+
+/**
+ * @brief Unit tests for LibraryWatcher class
+ *
+ * Tests recursive, debounced watching of library roots including:
+ * - Watching every directory of a tree once it is listed
+ * - Reporting files created deep in the tree
+ * - Watching directories that appear after the listing
+ * - Folding a burst of changes into one report
+ * - Holding back directories whose files are still being written
+ * - Reporting deleted directories
+ * - Skipping roots that do not exist
+ */
+class TestLibraryWatcher : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testWatchesTree();
+    void testReportsNestedChange();
+    void testWatchesNewDirectories();
+    void testBurstIsCoalesced();
+    void testHoldsBackUnsettledFiles();
+    void testReportsDeletedDirectories();
+    void testMissingRoot();
+
+private:
+    QString makeDirectory(const QString& name);
+    QString writeFile(const QString& name, const QByteArray& bytes);
+    std::unique_ptr<LibraryWatcher> makeWatcher();
+
+    std::unique_ptr<QTemporaryDir> m_tempDir;
+    QString m_root;
+};
+
+#endif // TESTLIBRARYWATCHER_H
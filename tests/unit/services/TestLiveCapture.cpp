@@ -0,0 +1,88 @@
+#include "TestLiveCapture.h"
+#include "../../../src/services/LiveCapture.h"
+#include <QSignalSpy>
+#include <vector>
+
+void TestLiveCapture::testToStereo()
+{
+    const float mono[3] = {0.1f, 0.2f, 0.3f};
+    float out[6] = {};
+    QCOMPARE(LiveCapture::toStereo(mono, 3, 1, out), 6);
+    QCOMPARE(out[0], 0.1f);
+    QCOMPARE(out[1], 0.1f);
+    QCOMPARE(out[5], 0.3f);
+
+    // 4.0 surround keeps front left and right
+    const float quad[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    QCOMPARE(LiveCapture::toStereo(quad, 2, 4, out), 4);
+    QCOMPARE(out[0], 1.0f);
+    QCOMPARE(out[1], 2.0f);
+    QCOMPARE(out[2], 5.0f);
+    QCOMPARE(out[3], 6.0f);
+
+    QCOMPARE(LiveCapture::toStereo(quad, 0, 4, out), 0);
+}
+
+void TestLiveCapture::testReadersShareCapture()
+{
+    LiveCapture capture;
+    capture.setExternalSource(44100);
+    int heard = 0;
+    capture.addListener([&heard](const float*, int count) { heard += count; });
+
+    const int recorder = capture.openReader();
+    const int stream = capture.openReader();
+    QVERIFY(recorder >= 0);
+    QVERIFY(stream >= 0);
+    QVERIFY(capture.isCapturing());
+    QCOMPARE(capture.sampleRate(), 44100);
+
+    std::vector<float> block(480);
+    for (size_t i = 0; i < block.size(); i += 2) {
+        block[i] = 0.5f;
+        block[i + 1] = -0.25f;
+    }
+    capture.write(block.data(), int(block.size()));
+    QCOMPARE(heard, int(block.size()));
+    QCOMPARE(capture.meter().takePeak(), 0.5f);
+
+    std::vector<float> out(1024);
+    QCOMPARE(capture.read(recorder, out.data(), int(out.size())), int(block.size()));
+    QCOMPARE(out[1], -0.25f);
+
+    // The stream reads at its own pace, through the function handed to the sinks
+    SegmentRecorder::PcmReader reader = capture.reader(stream);
+    QCOMPARE(reader(out.data(), 100), 100);
+    QCOMPARE(reader(out.data(), int(out.size())), int(block.size()) - 100);
+    QCOMPARE(reader(out.data(), int(out.size())), 0);
+}
+
+void TestLiveCapture::testCaptureFollowsReaders()
+{
+    LiveCapture capture;
+    capture.setExternalSource(48000);
+    QSignalSpy changed(&capture, &LiveCapture::capturingChanged);
+
+    const float samples[2] = {0.1f, 0.1f};
+    capture.write(samples, 2);
+    QCOMPARE(capture.meter().takePeak(), 0.0f);
+
+    const int first = capture.openReader();
+    const int second = capture.openReader();
+    QCOMPARE(changed.size(), 1);
+    capture.closeReader(first);
+    QVERIFY(capture.isCapturing());
+    capture.closeReader(second);
+    QVERIFY(!capture.isCapturing());
+    QCOMPARE(changed.size(), 2);
+
+    // Started for the meter, the capture outlives its readers
+    QVERIFY(capture.start());
+    capture.closeReader(capture.openReader());
+    QVERIFY(capture.isCapturing());
+    capture.stop();
+    QVERIFY(!capture.isCapturing());
+    QCOMPARE(changed.size(), 4);
+}
+
+QTEST_MAIN(TestLiveCapture)
@@ -0,0 +1,25 @@
+#ifndef TESTLIVECAPTURE_H
+#define TESTLIVECAPTURE_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for LiveCapture class
+ *
+ * Tests the shared capture of the live input including:
+ * - Mono and multichannel input turned into stereo
+ * - Several readers, the meter and listeners fed from one capture
+ * - The capture following its readers and start()/stop()
+ */
+class TestLiveCapture : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testToStereo();
+    void testReadersShareCapture();
+    void testCaptureFollowsReaders();
+};
+
+#endif // TESTLIVECAPTURE_H
@@ -1,5 +1,6 @@
 #include "TestLogger.h"
 #include "../../../src/services/Logger.h"
+#include "../../../src/services/LogCategories.h"
 #include <QDir>
 #include <QFile>
 #include <QTextStream>
@@ -376,6 +377,84 @@ void TestLogger::testConcurrentLogging()
     QVERIFY(totalMessages >= (numThreads * messagesPerThread * 0.9)); // Allow 10% loss
 }
 
+void TestLogger::testFlushWritesQueuedInOrder()
+{
+    Logger logger;
+    logger.initialize(m_testLogDir);
+
+    // Info messages wait for a batch; flush() blocks until they are written
+    for (int i = 0; i < 500; ++i) {
+        logger.writeLog(Logger::LogLevel::Info, "Test", QString("Queued %1").arg(i));
+    }
+    logger.flush();
+
+    const QString content = getLogFileContent(logger.getCurrentLogFile());
+    QCOMPARE(content.count("Queued "), 500);
+    QVERIFY(content.indexOf("Queued 0\n") < content.indexOf("Queued 499\n"));
+    QVERIFY(content.indexOf("Logging system initialized") < content.indexOf("Queued 0\n"));
+}
+
+void TestLogger::testErrorsReachDiskWithoutFlush()
+{
+    Logger logger;
+    logger.initialize(m_testLogDir);
+
+    logger.writeLog(Logger::LogLevel::Info, "Test", "Before the error");
+    logger.writeLog(Logger::LogLevel::Error, "Test", "Urgent error");
+
+    // Within the flush interval, and everything queued before it too
+    QTRY_VERIFY_WITH_TIMEOUT(getLogFileContent(logger.getCurrentLogFile()).contains("Urgent error"),
+                             Logger::FLUSH_INTERVAL_MS * 20);
+    QVERIFY(getLogFileContent(logger.getCurrentLogFile()).contains("Before the error"));
+}
+
+void TestLogger::testRotatesOnWriterThread()
+{
+    Logger logger;
+    logger.initialize(m_testLogDir, 10, 1);
+    const QString firstFile = logger.getCurrentLogFile();
+
+    // Spread over two seconds, since file names have a one second resolution
+    writeLogsToFillFile(&logger, 3000);
+    QTest::qWait(1100);
+    writeLogsToFillFile(&logger, 3000);
+    logger.flush();
+    logger.rotateIfNeeded();
+
+    QTRY_VERIFY(logger.getCurrentLogFile() != firstFile);
+    QVERIFY(countLogFiles(m_testLogDir) >= 2);
+    QVERIFY(QFileInfo(firstFile).size() >= 1024 * 1024);
+}
+
+void TestLogger::testCapturesCategories()
+{
+    {
+        Logger logger;
+        logger.initialize(m_testLogDir);
+        logger.captureCategories("xfb.player");
+
+        qCInfo(xfbPlayer) << "Captured info";
+        qCWarning(xfbScheduler) << "Captured warning";
+        qCDebug(xfbPlayback) << "Debug is off by default";
+        qInfo() << "Default category";
+
+        QLoggingCategory::setFilterRules("xfb.player.playback.debug=true");
+        qCDebug(xfbPlayback) << "Debug turned on";
+        QLoggingCategory::setFilterRules(QString());
+        logger.flush();
+
+        const QString content = getLogFileContent(logger.getCurrentLogFile());
+        QVERIFY(content.contains("[INFO ] [Qt        ] [xfb.player     ] Captured info"));
+        QVERIFY(content.contains("[WARN ] [Qt        ] [xfb.player.scheduler] Captured warning"));
+        QVERIFY(content.contains("Debug turned on"));
+        QVERIFY(!content.contains("Debug is off by default"));
+        QVERIFY(!content.contains("Default category"));
+    }
+
+    // The handler went away with the logger
+    qCInfo(xfbPlayer) << "After the logger";
+}
+
 void TestLogger::testInvalidDirectory()
 {
     Logger logger;
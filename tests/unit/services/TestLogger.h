@@ -16,6 +16,8 @@ class Logger;
  * - File rotation based on size
  * - Log level filtering
  * - Thread safety
+ * - Queued writes, batched flushes and rotation on the writer thread
+ * - Capture of the Qt messages of the xfb.player categories
  * - File cleanup and maintenance
  */
 class TestLogger : public QObject
@@ -57,6 +59,10 @@ private slots:
 
     // Thread safety tests
     void testConcurrentLogging();
+    void testFlushWritesQueuedInOrder();
+    void testErrorsReachDiskWithoutFlush();
+    void testRotatesOnWriterThread();
+    void testCapturesCategories();
 
     // Error scenarios
     void testInvalidDirectory();
@@ -0,0 +1,117 @@
+#include "TestLoudnessMeter.h"
+#include "../../../src/services/LoudnessMeter.h"
+#include <QVector>
+#include <cmath>
+
+namespace {
+
+// Appends seconds of a stereo sine whose peak is at levelDb dBFS
+void append(QVector<float>& samples, int rate, double seconds, double frequency, double levelDb,
+            double phase = 0.0)
+{
+    const double amplitude = levelDb <= -120.0 ? 0.0 : std::pow(10.0, levelDb / 20.0);
+    const qint64 frames = qint64(seconds * rate);
+    for (qint64 i = 0; i < frames; ++i) {
+        const float value = float(amplitude * std::sin(2.0 * M_PI * frequency * i / rate + phase));
+        samples << value << value;
+    }
+}
+
+// Feeds in uneven chunks so blocks straddle calls
+LoudnessMeter::Result measure(const QVector<float>& samples, int rate)
+{
+    LoudnessMeter meter(rate, 2);
+    for (qint64 offset = 0; offset < samples.size(); offset += 3002) {
+        meter.feed(samples.constData() + offset, qMin<qint64>(3002, samples.size() - offset));
+    }
+    return meter.result();
+}
+
+} // namespace
+
+void TestLoudnessMeter::testReferenceTone_data()
+{
+    QTest::addColumn<int>("rate");
+    QTest::addColumn<double>("levelDb");
+
+    // EBU Tech 3341 cases 1 and 2: a stereo tone at -23 or -33 dBFS reads the same in LUFS
+    QTest::newRow("-23 dBFS at 48 kHz") << 48000 << -23.0;
+    QTest::newRow("-33 dBFS at 48 kHz") << 48000 << -33.0;
+    QTest::newRow("-23 dBFS at 44.1 kHz") << 44100 << -23.0;
+}
+
+void TestLoudnessMeter::testReferenceTone()
+{
+    QFETCH(int, rate);
+    QFETCH(double, levelDb);
+
+    QVector<float> samples;
+    append(samples, rate, 10.0, 1000.0, levelDb);
+    const LoudnessMeter::Result result = measure(samples, rate);
+
+    QVERIFY(result.valid);
+    QVERIFY(result.audible);
+    QCOMPARE(result.durationMs, qint64(10000));
+    QVERIFY2(qAbs(result.integratedLufs - levelDb) <= 0.1,
+             qPrintable(QString::number(result.integratedLufs)));
+    QVERIFY(qAbs(result.truePeakDbtp - levelDb) <= 0.1);
+}
+
+void TestLoudnessMeter::testGating()
+{
+    // EBU Tech 3341 case 3, shortened: the quiet parts fall under the relative gate
+    QVector<float> samples;
+    append(samples, 48000, 5.0, 1000.0, -36.0);
+    append(samples, 48000, 30.0, 1000.0, -23.0);
+    append(samples, 48000, 5.0, 1000.0, -36.0);
+    LoudnessMeter::Result result = measure(samples, 48000);
+    QVERIFY2(qAbs(result.integratedLufs + 23.0) <= 0.1,
+             qPrintable(QString::number(result.integratedLufs)));
+
+    // Silence falls under the absolute gate and does not pull the loudness down
+    samples.clear();
+    append(samples, 48000, 10.0, 1000.0, -20.0);
+    append(samples, 48000, 10.0, 1000.0, -200.0);
+    result = measure(samples, 48000);
+    QVERIFY2(qAbs(result.integratedLufs + 20.0) <= 0.2,
+             qPrintable(QString::number(result.integratedLufs)));
+}
+
+void TestLoudnessMeter::testTruePeak()
+{
+    // A quarter-rate sine sampled 45 degrees off its crests peaks 3 dB above its samples
+    QVector<float> samples;
+    append(samples, 48000, 2.0, 12000.0, -6.0, M_PI / 4.0);
+    float samplePeak = 0.0f;
+    for (float sample : samples) {
+        samplePeak = qMax(samplePeak, std::fabs(sample));
+    }
+    QVERIFY(20.0 * std::log10(samplePeak) < -8.9);
+
+    const LoudnessMeter::Result result = measure(samples, 48000);
+    QVERIFY2(qAbs(result.truePeakDbtp + 6.0) <= 0.2,
+             qPrintable(QString::number(result.truePeakDbtp)));
+}
+
+void TestLoudnessMeter::testSilenceAndShortAudio()
+{
+    QVector<float> samples;
+    append(samples, 48000, 5.0, 1000.0, -200.0);
+    LoudnessMeter::Result result = measure(samples, 48000);
+    QVERIFY(result.valid);
+    QVERIFY(!result.audible);
+    QCOMPARE(result.truePeakDbtp, -120.0);
+
+    // Less than one 400 ms block
+    samples.clear();
+    append(samples, 48000, 0.3, 1000.0, -6.0);
+    result = measure(samples, 48000);
+    QVERIFY(result.valid);
+    QVERIFY(!result.audible);
+    QVERIFY(result.truePeakDbtp > -7.0);
+
+    LoudnessMeter empty(48000, 2);
+    QVERIFY(!empty.result().valid);
+}
+
+QTEST_MAIN(TestLoudnessMeter)
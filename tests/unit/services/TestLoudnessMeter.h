@@ -0,0 +1,28 @@
+#ifndef TESTLOUDNESSMETER_H
+#define TESTLOUDNESSMETER_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for LoudnessMeter class
+ *
+ * Tests the EBU R128 measurement including:
+ * - The 1 kHz reference tones, at 48 kHz and 44.1 kHz
+ * - The absolute and relative gates
+ * - True peak between samples
+ * - Silence and audio shorter than one block
+ */
+class TestLoudnessMeter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testReferenceTone_data();
+    void testReferenceTone();
+    void testGating();
+    void testTruePeak();
+    void testSilenceAndShortAudio();
+};
+
+#endif // TESTLOUDNESSMETER_H
@@ -0,0 +1,137 @@
+#include "TestMaintenanceScheduler.h"
+#include "../../../src/services/MaintenanceScheduler.h"
+#include "../../../src/services/SchedulerEngine.h"
+#include <QSignalSpy>
+#include <QSqlQuery>
+
+namespace {
+
+const char* CONNECTION_NAME = "test_maintenance_scheduler_connection";
+
+} // namespace
+
+void TestMaintenanceScheduler::init()
+{
+    m_tempDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_tempDir->isValid());
+
+    m_database = QSqlDatabase::addDatabase("QSQLITE", CONNECTION_NAME);
+    m_database.setDatabaseName(m_tempDir->path() + "/maintenance.db");
+    QVERIFY(m_database.open());
+}
+
+void TestMaintenanceScheduler::cleanup()
+{
+    if (m_database.isOpen()) {
+        m_database.close();
+    }
+    m_database = QSqlDatabase();
+    QSqlDatabase::removeDatabase(CONNECTION_NAME);
+    m_tempDir.reset();
+}
+
+void TestMaintenanceScheduler::testSlicesRotateAndReportDuration()
+{
+    exec("CREATE TABLE musics (id INTEGER PRIMARY KEY, artist TEXT, song TEXT)");
+    exec("CREATE INDEX idx_musics_artist ON musics(artist)");
+    exec("INSERT INTO musics (artist, song) VALUES ('Artist', 'Song')");
+
+    MaintenanceScheduler maintenance(m_database);
+    QVERIFY(maintenance.start());
+    QVERIFY(maintenance.isRunning());
+
+    QSignalSpy sliceSpy(&maintenance, &MaintenanceScheduler::sliceCompleted);
+    QVERIFY(maintenance.runSlice());
+    QVERIFY(maintenance.runSlice());
+    QVERIFY(maintenance.runSlice());
+
+    QCOMPARE(sliceSpy.count(), 3);
+    QCOMPARE(sliceSpy.at(0).at(0).toString(), QString("incremental_vacuum"));
+    QCOMPARE(sliceSpy.at(1).at(0).toString(), QString("optimize"));
+    QCOMPARE(sliceSpy.at(2).at(0).toString(), QString("analyze"));
+    QVERIFY(sliceSpy.at(2).at(1).toLongLong() >= 0);
+
+    // The analyze slice covered the only table
+    QVERIFY(count("SELECT COUNT(*) FROM sqlite_stat1 WHERE tbl = 'musics'") > 0);
+
+    const MaintenanceScheduler::Statistics stats = maintenance.statistics();
+    QCOMPARE(stats.slicesRun, 3);
+    QCOMPARE(stats.slicesSkipped, 0);
+    QVERIFY(stats.longestSliceMs >= stats.lastSliceMs);
+
+    maintenance.stop();
+    QVERIFY(!maintenance.isRunning());
+}
+
+void TestMaintenanceScheduler::testIncrementalVacuumFreesPages()
+{
+    // An empty database switches to incremental auto vacuum immediately
+    MaintenanceScheduler maintenance(m_database);
+    QVERIFY(maintenance.start());
+    QCOMPARE(count("PRAGMA auto_vacuum"), 2);
+
+    exec("CREATE TABLE blobs (data BLOB)");
+    for (int i = 0; i < 200; ++i) {
+        exec("INSERT INTO blobs (data) VALUES (zeroblob(4096))");
+    }
+    exec("DELETE FROM blobs");
+    QVERIFY(count("PRAGMA freelist_count") > 0);
+
+    maintenance.setSliceBudget(10000);
+    QVERIFY(maintenance.runSlice());
+    QCOMPARE(count("PRAGMA freelist_count"), 0);
+}
+
+void TestMaintenanceScheduler::testSkipsSliceBeforeScheduledEvent()
+{
+    exec("CREATE TABLE pub (id INTEGER PRIMARY KEY AUTOINCREMENT, name TEXT, path TEXT)");
+    exec("CREATE TABLE programs (id INTEGER PRIMARY KEY AUTOINCREMENT, name TEXT, path TEXT)");
+    exec("CREATE TABLE scheduler (id INTEGER, ano INTEGER, mes INTEGER, dia INTEGER, hora INTEGER, "
+         "min INTEGER, tipo INTEGER, week_day TEXT, start_ano INTEGER, start_mes INTEGER, "
+         "start_dia INTEGER, end_ano INTEGER, end_mes INTEGER, end_dia INTEGER, is_program NULL)");
+    exec("INSERT INTO pub (id, name, path) VALUES (1, 'Ad', '/pub/ad.ogg')");
+
+    // An ad break one minute from now
+    const QDateTime adBreak = QDateTime::currentDateTime().addSecs(60);
+    exec(QString("INSERT INTO scheduler VALUES ('1', '%1', '%2', '%3', '%4', '%5', '1', NULL, NULL, NULL, "
+                 "NULL, NULL, NULL, NULL, '0')")
+             .arg(adBreak.date().year())
+             .arg(adBreak.date().month())
+             .arg(adBreak.date().day())
+             .arg(adBreak.time().hour())
+             .arg(adBreak.time().minute()));
+
+    SchedulerEngine engine(m_database);
+    QVERIFY(engine.reload());
+
+    MaintenanceScheduler maintenance(m_database);
+    maintenance.setSchedulerEngine(&engine);
+
+    QSignalSpy skippedSpy(&maintenance, &MaintenanceScheduler::sliceSkipped);
+    QSignalSpy sliceSpy(&maintenance, &MaintenanceScheduler::sliceCompleted);
+
+    const QDateTime now = QDateTime::currentDateTime();
+    QVERIFY(maintenance.blockingEvent(now).isValid());
+    QVERIFY(!maintenance.runSlice(now));
+    QCOMPARE(skippedSpy.count(), 1);
+    QCOMPARE(sliceSpy.count(), 0);
+    QCOMPARE(maintenance.statistics().slicesSkipped, 1);
+
+    // Once the break is over, maintenance resumes
+    QVERIFY(maintenance.runSlice(now.addSecs(MaintenanceScheduler::AIR_GUARD_SECS + 180)));
+    QCOMPARE(sliceSpy.count(), 1);
+}
+
+void TestMaintenanceScheduler::exec(const QString& sql)
+{
+    QSqlQuery query(m_database);
+    QVERIFY2(query.exec(sql), qPrintable(sql));
+}
+
+int TestMaintenanceScheduler::count(const QString& sql)
+{
+    QSqlQuery query(m_database);
+    return query.exec(sql) && query.next() ? query.value(0).toInt() : -1;
+}
+
+QTEST_MAIN(TestMaintenanceScheduler)
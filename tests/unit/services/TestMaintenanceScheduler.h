@@ -0,0 +1,38 @@
+#ifndef TESTMAINTENANCESCHEDULER_H
+#define TESTMAINTENANCESCHEDULER_H
+
+#include <QObject>
+#include <QTest>
+#include <QSqlDatabase>
+#include <QTemporaryDir>
+#include <memory>
+
+/**
+ * @brief Unit tests for MaintenanceScheduler class
+ *
+ * Tests the time-boxed maintenance slices including:
+ * - Rotation between vacuum, optimize and analyze slices
+ * - Freeing pages with incremental vacuum
+ * - Skipping slices right before a scheduled event
+ */
+class TestMaintenanceScheduler : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testSlicesRotateAndReportDuration();
+    void testIncrementalVacuumFreesPages();
+    void testSkipsSliceBeforeScheduledEvent();
+
+private:
+    void exec(const QString& sql);
+    int count(const QString& sql);
+
+    std::unique_ptr<QTemporaryDir> m_tempDir;
+    QSqlDatabase m_database;
+};
+
+#endif // TESTMAINTENANCESCHEDULER_H
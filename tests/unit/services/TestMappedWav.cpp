@@ -0,0 +1,193 @@
+#include "TestMappedWav.h"
+#include "../../../src/services/AudioDeck.h"
+#include "../../../src/services/MappedWav.h"
+#include <QFile>
+#include <QtEndian>
+#include <cstring>
+
+namespace {
+
+void append16(QByteArray& bytes, quint16 value)
+{
+    char le[2];
+    qToLittleEndian(value, le);
+    bytes.append(le, 2);
+}
+
+void append32(QByteArray& bytes, quint32 value)
+{
+    char le[4];
+    qToLittleEndian(value, le);
+    bytes.append(le, 4);
+}
+
+QByteArray chunk(const char* id, const QByteArray& body, qint64 declaredSize = -1)
+{
+    QByteArray bytes(id, 4);
+    append32(bytes, quint32(declaredSize < 0 ? body.size() : declaredSize));
+    bytes.append(body);
+    if (body.size() % 2) {
+        bytes.append('\0');
+    }
+    return bytes;
+}
+
+QByteArray formatChunk(quint16 code, int channels, int sampleRate, int bits,
+                       quint16 subformat = 0)
+{
+    QByteArray body;
+    append16(body, code);
+    append16(body, quint16(channels));
+    append32(body, quint32(sampleRate));
+    append32(body, quint32(sampleRate * channels * bits / 8));
+    append16(body, quint16(channels * bits / 8));
+    append16(body, quint16(bits));
+    if (code == 0xFFFE) {
+        append16(body, 22);
+        append16(body, quint16(bits));
+        append32(body, 0x3);
+        append16(body, subformat);
+        body.append(QByteArray(14, '\x11'));
+    }
+    return chunk("fmt ", body);
+}
+
+QByteArray riff(const QByteArray& chunks)
+{
+    QByteArray bytes("RIFF");
+    append32(bytes, quint32(chunks.size() + 4));
+    bytes.append("WAVE");
+    bytes.append(chunks);
+    return bytes;
+}
+
+QByteArray pcm16(const QVector<qint16>& samples)
+{
+    QByteArray body;
+    for (qint16 sample : samples) {
+        append16(body, quint16(sample));
+    }
+    return body;
+}
+
+} // namespace
+
+void TestMappedWav::init()
+{
+    m_tempDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_tempDir->isValid());
+}
+
+void TestMappedWav::cleanup()
+{
+    m_tempDir.reset();
+}
+
+QString TestMappedWav::write(const QString& name, const QByteArray& contents)
+{
+    const QString path = m_tempDir->filePath(name);
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(contents) != contents.size()) {
+        return QString();
+    }
+    return path;
+}
+
+void TestMappedWav::testPcm16()
+{
+    const QString path = write("stereo.wav",
+                               riff(formatChunk(1, 2, 44100, 16)
+                                    + chunk("data", pcm16({100, -100, 200, -200, 300, -300}))));
+    MappedWav wav;
+    QVERIFY(wav.open(path));
+    QCOMPARE(wav.format().sampleFormat(), QAudioFormat::Int16);
+    QCOMPARE(wav.format().channelCount(), 2);
+    QCOMPARE(wav.format().sampleRate(), 44100);
+    QCOMPARE(wav.frames(), qint64(3));
+
+    const qint16* frame = reinterpret_cast<const qint16*>(wav.frameData(2));
+    QCOMPARE(qFromLittleEndian(frame[0]), qint16(300));
+    QCOMPARE(qFromLittleEndian(frame[1]), qint16(-300));
+
+    wav.adviseAhead(0, 100);
+    wav.close();
+    QVERIFY(!wav.isOpen());
+}
+
+void TestMappedWav::testFloatExtensible()
+{
+    QByteArray samples;
+    for (float value : {0.25f, -0.5f}) {
+        quint32 bits;
+        memcpy(&bits, &value, sizeof(bits));
+        append32(samples, bits);
+    }
+    const QString path =
+        write("float.wav", riff(formatChunk(0xFFFE, 1, 48000, 32, 3) + chunk("data", samples)));
+    MappedWav wav;
+    QVERIFY(wav.open(path));
+    QCOMPARE(wav.format().sampleFormat(), QAudioFormat::Float);
+    QCOMPARE(wav.frames(), qint64(2));
+    QCOMPARE(wav.format().normalizedSampleValue(wav.frameData(1)), -0.5f);
+}
+
+void TestMappedWav::testSkipsChunksAndCutsData()
+{
+    // A LIST chunk of odd length before the data, whose size claims far more than is there
+    const QString path =
+        write("cut.wav", riff(formatChunk(1, 1, 8000, 16) + chunk("LIST", "abc")
+                              + chunk("data", pcm16({1, 2, 3, 4}), 1000000)));
+    MappedWav wav;
+    QVERIFY(wav.open(path));
+    QCOMPARE(wav.frames(), qint64(4));
+    QCOMPARE(qFromLittleEndian(reinterpret_cast<const qint16*>(wav.frameData(3))[0]),
+             qint16(4));
+}
+
+void TestMappedWav::testRejectsOtherFiles()
+{
+    MappedWav wav;
+    QVERIFY(!wav.open(m_tempDir->filePath("missing.wav")));
+    QVERIFY(!wav.open(write("text.wav", "not a wave file at all")));
+    // 24-bit PCM is left to the decoder
+    QVERIFY(!wav.open(write("24bit.wav", riff(formatChunk(1, 2, 48000, 24)
+                                              + chunk("data", QByteArray(12, '\0'))))));
+    // No fmt chunk before the data
+    QVERIFY(!wav.open(write("nofmt.wav", riff(chunk("data", pcm16({1, 2}))))));
+    QVERIFY(!wav.isOpen());
+}
+
+void TestMappedWav::testDeckPlaysMappedWav()
+{
+    // Mono at the engine rate goes to both channels, sample for sample
+    QVector<qint16> samples;
+    for (int i = 0; i < 1000; ++i) {
+        samples << qint16(i * 16);
+    }
+    const QString path =
+        write("cart.WAV", riff(formatChunk(1, 1, 8000, 16) + chunk("data", pcm16(samples))));
+
+    AudioDeck deck(8000);
+    deck.load(path);
+    QVERIFY(deck.isMapped());
+    QCOMPARE(deck.state(), AudioDeck::State::Ready);
+    QCOMPARE(deck.durationFrames(), qint64(1000));
+
+    float out[AudioDeck::CHANNELS * 4];
+    QCOMPARE(deck.read(out, 4), 4);
+    QCOMPARE(out[6], 48 / 32768.0f);
+    QCOMPARE(out[7], 48 / 32768.0f);
+
+    // 100 ms in is frame 800
+    deck.load(path, 100);
+    QVERIFY(deck.isMapped());
+    QCOMPARE(deck.read(out, 1), 1);
+    QCOMPARE(out[0], 800 * 16 / 32768.0f);
+
+    float rest[AudioDeck::CHANNELS * 400];
+    QCOMPARE(deck.read(rest, 400), 199);
+    QCOMPARE(deck.state(), AudioDeck::State::Drained);
+    QCOMPARE(deck.durationFrames(), qint64(1000));
+}
+
+QTEST_MAIN(TestMappedWav)
@@ -0,0 +1,39 @@
+#ifndef TESTMAPPEDWAV_H
+#define TESTMAPPEDWAV_H
+
+#include <QByteArray>
+#include <QObject>
+#include <QTemporaryDir>
+#include <QTest>
+#include <memory>
+
+/**
+ * @brief Unit tests for MappedWav class
+ *
+ * Tests the mapping of WAV files including:
+ * - Reading the format and samples of PCM, float and extensible files
+ * - Skipping unknown chunks and cutting a data chunk longer than the file
+ * - Refusing formats it does not read
+ * - Playing a mapped WAV from an AudioDeck, from the start and after a seek
+ */
+class TestMappedWav : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testPcm16();
+    void testFloatExtensible();
+    void testSkipsChunksAndCutsData();
+    void testRejectsOtherFiles();
+    void testDeckPlaysMappedWav();
+
+private:
+    QString write(const QString& name, const QByteArray& contents);
+
+    std::unique_ptr<QTemporaryDir> m_tempDir;
+};
+
+#endif // TESTMAPPEDWAV_H
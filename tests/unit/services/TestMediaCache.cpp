@@ -0,0 +1,216 @@
+#include "TestMediaCache.h"
+#include "../../../src/services/MediaCache.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSignalSpy>
+
+namespace {
+
+QByteArray readAll(const QString& path)
+{
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+} // namespace
+
+void TestMediaCache::init()
+{
+    m_tempDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_tempDir->isValid());
+    QVERIFY(QDir(m_tempDir->path()).mkpath("nas"));
+    QVERIFY(QDir(m_tempDir->path()).mkpath("local"));
+}
+
+void TestMediaCache::cleanup()
+{
+    m_tempDir.reset();
+}
+
+void TestMediaCache::testCopiesAndResolves()
+{
+    const QString source = writeFile("nas/song.mp3");
+
+    MediaCache cache(cacheDirectory());
+    QSignalSpy prepared(&cache, &MediaCache::prepared);
+
+    // Not copied yet: the deck gets the track itself and the copy is made
+    QCOMPARE(cache.resolve(source), source);
+    QCOMPARE(cache.pendingCount(), 1);
+    QVERIFY(prepared.wait(5000));
+    QCOMPARE(prepared.at(0).at(0).toString(), source);
+
+    const QString copy = cache.resolve(source);
+    QVERIFY(copy != source);
+    QVERIFY(copy.startsWith(cacheDirectory()));
+    QVERIFY(copy.endsWith(".mp3"));
+    QCOMPARE(readAll(copy), readAll(source));
+    QVERIFY(cache.isCached(source));
+
+    const MediaCache::Statistics stats = cache.statistics();
+    QCOMPARE(stats.hits, 1);
+    QCOMPARE(stats.misses, 1);
+    QCOMPARE(stats.copied, 1);
+    QCOMPARE(stats.entries, 1);
+    QCOMPARE(stats.bytes, qint64(4096));
+    QCOMPARE(stats.bytesCopied, qint64(4096));
+}
+
+void TestMediaCache::testSharesIdenticalAudio()
+{
+    const QString first = writeFile("nas/a/song.mp3", 4096, 'x');
+    const QString second = writeFile("nas/b/copy of song.mp3", 4096, 'x');
+
+    MediaCache cache(cacheDirectory());
+    QVERIFY(prepareAndWait(cache, first));
+    QVERIFY(prepareAndWait(cache, second));
+
+    QCOMPARE(cache.resolve(second), cache.resolve(first));
+    QCOMPARE(cache.statistics().copied, 1);
+    QCOMPARE(cache.statistics().shared, 1);
+    QCOMPARE(cache.statistics().entries, 1);
+}
+
+void TestMediaCache::testOnlyConfiguredPaths()
+{
+    const QString remote = writeFile("nas/song.mp3");
+    const QString local = writeFile("local/song.mp3");
+
+    MediaCache cache(cacheDirectory());
+    cache.setPaths({m_tempDir->filePath("nas")});
+    QVERIFY(cache.handles(remote));
+    QVERIFY(!cache.handles(local));
+
+    QCOMPARE(cache.prepare({remote, local, remote}), 1);
+    QCOMPARE(cache.resolve(local), local);
+    QCOMPARE(cache.statistics().misses, 0);
+}
+
+void TestMediaCache::testDisabled()
+{
+    const QString source = writeFile("nas/song.mp3");
+
+    MediaCache cache(cacheDirectory());
+    cache.setEnabled(false);
+    QCOMPARE(cache.prepare({source}), 0);
+    QCOMPARE(cache.resolve(source), source);
+    QCOMPARE(cache.statistics().misses, 0);
+}
+
+void TestMediaCache::testPlaysCopyOfUnreachableTrack()
+{
+    const QString source = writeFile("nas/song.mp3");
+
+    MediaCache cache(cacheDirectory());
+    QVERIFY(prepareAndWait(cache, source));
+
+    // The NAS is away: what is in the cache still goes on air
+    QVERIFY(QFile::remove(source));
+    const QString copy = cache.resolve(source);
+    QVERIFY(copy != source);
+    QVERIFY(QFileInfo::exists(copy));
+}
+
+void TestMediaCache::testCopiesChangedTrackAgain()
+{
+    const QString source = writeFile("nas/song.mp3", 4096, 'a');
+
+    MediaCache cache(cacheDirectory());
+    QVERIFY(prepareAndWait(cache, source));
+
+    writeFile("nas/song.mp3", 8192, 'b');
+    QVERIFY(!cache.isCached(source));
+    QSignalSpy prepared(&cache, &MediaCache::prepared);
+    QCOMPARE(cache.resolve(source), source);
+    QVERIFY(prepared.wait(5000));
+
+    QCOMPARE(readAll(cache.resolve(source)), readAll(source));
+    QCOMPARE(cache.statistics().copied, 2);
+}
+
+void TestMediaCache::testEvictsLeastRecentlyUsed()
+{
+    const QString first = writeFile("nas/first.mp3", 4096, 'f');
+    const QString second = writeFile("nas/second.mp3", 4096, 's');
+    const QString third = writeFile("nas/third.mp3", 4096, 't');
+
+    MediaCache cache(cacheDirectory());
+    QVERIFY(prepareAndWait(cache, first));
+    QVERIFY(prepareAndWait(cache, second));
+    QVERIFY(prepareAndWait(cache, third));
+
+    const QString firstCopy = cache.resolve(first);
+    QTest::qWait(20);
+    const QString thirdCopy = cache.resolve(third);
+    QTest::qWait(20);
+    const QString secondCopy = cache.resolve(second);
+
+    // first was played longest ago, and is no longer one of the pinned last two
+    cache.setMaxBytes(2 * 4096);
+    QCOMPARE(cache.statistics().entries, 2);
+    QCOMPARE(cache.statistics().evicted, 1);
+    QVERIFY(!QFileInfo::exists(firstCopy));
+    QVERIFY(QFileInfo::exists(secondCopy));
+    QVERIFY(QFileInfo::exists(thirdCopy));
+    QVERIFY(!cache.isCached(first));
+}
+
+void TestMediaCache::testLoadsExistingCopies()
+{
+    const QString source = writeFile("nas/song.mp3");
+    {
+        MediaCache cache(cacheDirectory());
+        QVERIFY(prepareAndWait(cache, source));
+    }
+    QFile part(QDir(cacheDirectory()).filePath("interrupted.mp3.part"));
+    QVERIFY(part.open(QIODevice::WriteOnly));
+    part.write("half");
+    part.close();
+
+    MediaCache cache(cacheDirectory());
+    QCOMPARE(cache.statistics().entries, 1);
+    QCOMPARE(cache.statistics().bytes, qint64(4096));
+    QVERIFY(!part.exists());
+
+    // Hashing the track finds its copy without copying it again
+    QVERIFY(prepareAndWait(cache, source));
+    QCOMPARE(cache.statistics().copied, 0);
+    QCOMPARE(cache.statistics().shared, 1);
+    QVERIFY(cache.resolve(source) != source);
+}
+
+QString TestMediaCache::writeFile(const QString& name, int bytes, char fill)
+{
+    const QString path = m_tempDir->filePath(name);
+    QDir().mkpath(QFileInfo(path).path());
+    QFile file(path);
+    if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        QByteArray data(bytes, fill);
+        // Different names give different audio unless a fill is given
+        if (fill == 0) {
+            for (int i = 0; i < bytes; ++i) {
+                data[i] = char((i * 31 + qHash(name)) & 0xFF);
+            }
+        }
+        file.write(data);
+    }
+    return path;
+}
+
+QString TestMediaCache::cacheDirectory() const
+{
+    return m_tempDir->filePath("cache");
+}
+
+bool TestMediaCache::prepareAndWait(MediaCache& cache, const QString& source)
+{
+    QSignalSpy prepared(&cache, &MediaCache::prepared);
+    QSignalSpy failed(&cache, &MediaCache::failed);
+    if (cache.prepare({source}) != 1) {
+        return false;
+    }
+    return prepared.wait(5000) && failed.isEmpty();
+}
+
+QTEST_MAIN(TestMediaCache)
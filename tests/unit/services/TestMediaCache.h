@@ -0,0 +1,47 @@
+#ifndef TESTMEDIACACHE_H
+#define TESTMEDIACACHE_H
+
+#include <QObject>
+#include <QTest>
+#include <QTemporaryDir>
+#include <memory>
+
+class MediaCache;
+
+/**
+ * @brief Unit tests for MediaCache class
+ *
+ * Tests the local cache of network media including:
+ * - Copying tracks and resolving them to their copies, with hits and misses
+ * - Keeping the same audio under two paths once
+ * - Copying only the configured directories, and nothing when disabled
+ * - Playing a copy when its track cannot be reached, but not when it changed
+ * - Removing the least recently played copies
+ * - Finding the copies of an earlier run again
+ */
+class TestMediaCache : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testCopiesAndResolves();
+    void testSharesIdenticalAudio();
+    void testOnlyConfiguredPaths();
+    void testDisabled();
+    void testPlaysCopyOfUnreachableTrack();
+    void testCopiesChangedTrackAgain();
+    void testEvictsLeastRecentlyUsed();
+    void testLoadsExistingCopies();
+
+private:
+    QString writeFile(const QString& name, int bytes = 4096, char fill = 0);
+    QString cacheDirectory() const;
+    bool prepareAndWait(MediaCache& cache, const QString& source);
+
+    std::unique_ptr<QTemporaryDir> m_tempDir;
+};
+
+#endif // TESTMEDIACACHE_H
@@ -0,0 +1,186 @@
+#include "TestMediaInfoLoader.h"
+#include "../../../src/services/MediaInfoLoader.h"
+#include "../../../src/services/MusicCache.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QSignalSpy>
+#include <QtEndian>
+
+namespace {
+
+void appendLE16(QByteArray& data, quint16 value)
+{
+    char buf[2];
+    qToLittleEndian(value, buf);
+    data.append(buf, 2);
+}
+
+void appendLE32(QByteArray& data, quint32 value)
+{
+    char buf[4];
+    qToLittleEndian(value, buf);
+    data.append(buf, 4);
+}
+
+MediaInfoLoader::Info loadedInfo(const QSignalSpy& spy, int index)
+{
+    return spy.at(index).at(0).value<MediaInfoLoader::Info>();
+}
+
+} // namespace
+
+void TestMediaInfoLoader::init()
+{
+    m_tempDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_tempDir->isValid());
+    m_cache = std::make_unique<MusicCache>();
+    m_cache->setWarmupStrategy(MusicCache::NoWarmup);
+}
+
+void TestMediaInfoLoader::cleanup()
+{
+    m_cache.reset();
+    m_tempDir.reset();
+}
+
+void TestMediaInfoLoader::testReadTagsAndStream()
+{
+    const QString path = writeWav("one.wav", 2, "The Band");
+
+    const MediaInfoLoader::Info info = MediaInfoLoader::read(path);
+    QVERIFY(info.isValid());
+    QVERIFY(info.hasTags());
+    QCOMPARE(info.artist, QString("The Band"));
+    QCOMPARE(info.duration, QString("0:00:02"));
+    QCOMPARE(info.tagFormat, QString("RIFF INFO"));
+    QVERIFY(!info.container.isEmpty());
+    QCOMPARE(info.size, QFileInfo(path).size());
+
+    // The cache round trip keeps every field
+    const MediaInfoLoader::Info copy = MediaInfoLoader::Info::fromVariant(info.toVariant());
+    QCOMPARE(copy.path, info.path);
+    QCOMPARE(copy.artist, info.artist);
+    QCOMPARE(copy.duration, info.duration);
+    QCOMPARE(copy.container, info.container);
+    QCOMPARE(copy.size, info.size);
+    QCOMPARE(copy.modified, info.modified);
+}
+
+void TestMediaInfoLoader::testCachedResultServedAgain()
+{
+    const QString path = writeWav("one.wav", 1, "Artist");
+    MediaInfoLoader loader(m_cache.get());
+    QSignalSpy spy(&loader, &MediaInfoLoader::loaded);
+
+    loader.request(path);
+    QCOMPARE(spy.count(), 0);
+    QTRY_COMPARE(spy.count(), 1);
+    QCOMPARE(loadedInfo(spy, 0).artist, QString("Artist"));
+    QCOMPARE(loader.readCount(), 1);
+
+    // Answered before request() returns, without a read
+    QVERIFY(loader.cached(path, nullptr));
+    loader.request(path);
+    QCOMPARE(spy.count(), 2);
+    QCOMPARE(loadedInfo(spy, 1).artist, QString("Artist"));
+    QCOMPARE(loader.readCount(), 1);
+}
+
+void TestMediaInfoLoader::testChangedFileReadAgain()
+{
+    const QString path = writeWav("one.wav", 1, "Before");
+    MediaInfoLoader loader(m_cache.get());
+    QSignalSpy spy(&loader, &MediaInfoLoader::loaded);
+    loader.request(path);
+    QTRY_COMPARE(spy.count(), 1);
+
+    writeWav("one.wav", 3, "After");
+    QVERIFY(!loader.cached(path, nullptr));
+    loader.request(path);
+    QTRY_COMPARE(spy.count(), 2);
+    QCOMPARE(loadedInfo(spy, 1).artist, QString("After"));
+    QCOMPARE(loadedInfo(spy, 1).duration, QString("0:00:03"));
+    QCOMPARE(loader.readCount(), 2);
+}
+
+void TestMediaInfoLoader::testSupersededRequests()
+{
+    const QString first = writeWav("first.wav", 1, "First");
+    const QString second = writeWav("second.wav", 1, "Second");
+    const QString third = writeWav("third.wav", 1, "Third");
+    MediaInfoLoader loader(m_cache.get());
+    QSignalSpy spy(&loader, &MediaInfoLoader::loaded);
+
+    // The first read starts; the second waits and is replaced by the third
+    loader.request(first);
+    loader.request(second);
+    loader.request(third);
+    QCOMPARE(loader.pendingPath(), third);
+
+    QTRY_COMPARE(spy.count(), 1);
+    QCOMPARE(loadedInfo(spy, 0).path, third);
+    QCOMPARE(loader.readCount(), 2);
+    QCOMPARE(loader.supersededCount(), 2);
+    QVERIFY(loader.pendingPath().isEmpty());
+
+    // The first read was not reported but still filled the cache
+    QVERIFY(loader.cached(first, nullptr));
+    QVERIFY(!loader.cached(second, nullptr));
+}
+
+void TestMediaInfoLoader::testMissingFile()
+{
+    const QString path = m_tempDir->path() + "/missing.wav";
+    MediaInfoLoader loader(m_cache.get());
+    QSignalSpy spy(&loader, &MediaInfoLoader::loaded);
+
+    loader.request(path);
+    QTRY_COMPARE(spy.count(), 1);
+    QVERIFY(!loadedInfo(spy, 0).isValid());
+    QVERIFY(!loadedInfo(spy, 0).error.isEmpty());
+    QVERIFY(!loader.cached(path, nullptr));
+}
+
+QString TestMediaInfoLoader::writeWav(const QString& name, int seconds, const QByteArray& artist)
+{
+    // 8 kHz 8-bit mono PCM keeps the files small
+    const quint32 dataSize = 8000 * seconds;
+
+    QByteArray value = artist + '\0';
+    if (value.size() & 1) {
+        value.append('\0');
+    }
+    QByteArray info("INFO");
+    info.append("IART");
+    appendLE32(info, value.size());
+    info.append(value);
+
+    QByteArray wav;
+    wav.append("RIFF");
+    appendLE32(wav, 36 + 8 + info.size() + dataSize);
+    wav.append("WAVE");
+    wav.append("fmt ");
+    appendLE32(wav, 16);
+    appendLE16(wav, 1);    // PCM
+    appendLE16(wav, 1);    // channels
+    appendLE32(wav, 8000); // sample rate
+    appendLE32(wav, 8000); // byte rate
+    appendLE16(wav, 1);    // block align
+    appendLE16(wav, 8);    // bits per sample
+    wav.append("LIST");
+    appendLE32(wav, info.size());
+    wav.append(info);
+    wav.append("data");
+    appendLE32(wav, dataSize);
+    wav.append(QByteArray(dataSize, 0));
+
+    QString path = m_tempDir->path() + "/" + name;
+    QFile file(path);
+    if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        file.write(wav);
+        file.close();
+    }
+    return path;
+}
+
+QTEST_MAIN(TestMediaInfoLoader)
@@ -0,0 +1,42 @@
+#ifndef TESTMEDIAINFOLOADER_H
+#define TESTMEDIAINFOLOADER_H
+
+#include <QObject>
+#include <QTemporaryDir>
+#include <QTest>
+#include <memory>
+
+class MusicCache;
+
+/**
+ * @brief Unit tests for MediaInfoLoader class
+ *
+ * Tests the background media info reads including:
+ * - Tags and stream details read from a file
+ * - Cached results answered without reading the file again
+ * - Changed files read again
+ * - Superseded requests dropped, only the latest one reported
+ * - Unreadable files reported and not cached
+ */
+class TestMediaInfoLoader : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testReadTagsAndStream();
+    void testCachedResultServedAgain();
+    void testChangedFileReadAgain();
+    void testSupersededRequests();
+    void testMissingFile();
+
+private:
+    QString writeWav(const QString& name, int seconds, const QByteArray& artist);
+
+    std::unique_ptr<QTemporaryDir> m_tempDir;
+    std::unique_ptr<MusicCache> m_cache;
+};
+
+#endif // TESTMEDIAINFOLOADER_H
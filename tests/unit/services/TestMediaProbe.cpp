@@ -0,0 +1,293 @@
+#include "TestMediaProbe.h"
+#include "../../../src/services/MediaProbe.h"
+#include <QFile>
+#include <QtEndian>
+
+namespace {
+
+void appendLE16(QByteArray& data, quint16 value)
+{
+    char buf[2];
+    qToLittleEndian(value, buf);
+    data.append(buf, 2);
+}
+
+void appendLE32(QByteArray& data, quint32 value)
+{
+    char buf[4];
+    qToLittleEndian(value, buf);
+    data.append(buf, 4);
+}
+
+void appendLE64(QByteArray& data, quint64 value)
+{
+    char buf[8];
+    qToLittleEndian(value, buf);
+    data.append(buf, 8);
+}
+
+void appendBE32(QByteArray& data, quint32 value)
+{
+    char buf[4];
+    qToBigEndian(value, buf);
+    data.append(buf, 4);
+}
+
+void appendBE64(QByteArray& data, quint64 value)
+{
+    char buf[8];
+    qToBigEndian(value, buf);
+    data.append(buf, 8);
+}
+
+} // namespace
+
+void TestMediaProbe::init()
+{
+    m_tempDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_tempDir->isValid());
+}
+
+void TestMediaProbe::cleanup()
+{
+    m_tempDir.reset();
+}
+
+void TestMediaProbe::testWavDuration()
+{
+    // 2 seconds of 44.1 kHz 16-bit stereo PCM
+    const quint32 dataSize = 44100 * 4 * 2;
+
+    QByteArray wav;
+    wav.append("RIFF");
+    appendLE32(wav, 36 + dataSize);
+    wav.append("WAVE");
+    wav.append("fmt ");
+    appendLE32(wav, 16);
+    appendLE16(wav, 1);      // PCM
+    appendLE16(wav, 2);      // channels
+    appendLE32(wav, 44100);  // sample rate
+    appendLE32(wav, 176400); // byte rate
+    appendLE16(wav, 4);      // block align
+    appendLE16(wav, 16);     // bits per sample
+    wav.append("data");
+    appendLE32(wav, dataSize);
+    wav.append(QByteArray(dataSize, 0));
+
+    MediaProbe::ProbeResult result = MediaProbe::probe(writeFile("test.wav", wav));
+    QVERIFY2(result.isValid, qPrintable(result.errorMessage));
+    QCOMPARE(result.container, MediaProbe::Container::Wav);
+    QCOMPARE(result.durationUs, qint64(2000000));
+    QCOMPARE(result.sampleRate, 44100);
+    QCOMPARE(result.channels, 2);
+}
+
+void TestMediaProbe::testFlacDuration()
+{
+    // 10 seconds at 44.1 kHz, stereo, 16 bits per sample
+    const quint64 totalSamples = 441000;
+    quint64 packed = (quint64(44100) << 44) | (quint64(1) << 41) | (quint64(15) << 36) | totalSamples;
+
+    QByteArray flac;
+    flac.append("fLaC");
+    flac.append(char(0x80)); // last block, STREAMINFO
+    flac.append(char(0x00));
+    flac.append(char(0x00));
+    flac.append(char(34));
+    flac.append(QByteArray::fromHex("10001000000000000000")); // block and frame sizes
+    appendBE64(flac, packed);
+    flac.append(QByteArray(16, 0)); // MD5
+    flac.append(QByteArray(4096, 0));
+
+    MediaProbe::ProbeResult result = MediaProbe::probe(writeFile("test.flac", flac));
+    QVERIFY2(result.isValid, qPrintable(result.errorMessage));
+    QCOMPARE(result.container, MediaProbe::Container::Flac);
+    QCOMPARE(result.durationUs, qint64(10000000));
+    QCOMPARE(result.sampleRate, 44100);
+    QCOMPARE(result.channels, 2);
+}
+
+void TestMediaProbe::testOggVorbisDuration()
+{
+    QByteArray idHeader;
+    idHeader.append("\x01vorbis", 7);
+    appendLE32(idHeader, 0);      // version
+    idHeader.append(char(2));     // channels
+    appendLE32(idHeader, 44100);  // sample rate
+    appendLE32(idHeader, 0);      // bitrate maximum
+    appendLE32(idHeader, 128000); // bitrate nominal
+    appendLE32(idHeader, 0);      // bitrate minimum
+    idHeader.append(char(0xB8));  // block sizes
+    idHeader.append(char(0x01));  // framing
+
+    QByteArray ogg = oggPage(0x1234, 0, idHeader);
+    ogg.append(oggPage(0x1234, 100000, QByteArray(200, 'a')));
+    ogg.append(oggPage(0x1234, 44100 * 5, QByteArray(200, 'b')));
+
+    MediaProbe::ProbeResult result = MediaProbe::probe(writeFile("test.ogg", ogg));
+    QVERIFY2(result.isValid, qPrintable(result.errorMessage));
+    QCOMPARE(result.container, MediaProbe::Container::Ogg);
+    QCOMPARE(result.codec, QString("vorbis"));
+    QCOMPARE(result.durationUs, qint64(5000000));
+    QCOMPARE(result.bitrateKbps, 128);
+}
+
+void TestMediaProbe::testOggOpusPreSkip()
+{
+    QByteArray opusHead;
+    opusHead.append("OpusHead");
+    opusHead.append(char(1));   // version
+    opusHead.append(char(2));   // channels
+    appendLE16(opusHead, 312);  // pre-skip
+    appendLE32(opusHead, 44100);
+    appendLE16(opusHead, 0);    // output gain
+    opusHead.append(char(0));   // mapping family
+
+    QByteArray ogg = oggPage(7, 0, opusHead);
+    ogg.append(oggPage(7, 48000 * 3 + 312, QByteArray(100, 'x')));
+
+    MediaProbe::ProbeResult result = MediaProbe::probe(writeFile("test.opus", ogg));
+    QVERIFY2(result.isValid, qPrintable(result.errorMessage));
+    QCOMPARE(result.codec, QString("opus"));
+    QCOMPARE(result.sampleRate, 48000);
+    QCOMPARE(result.durationUs, qint64(3000000));
+}
+
+void TestMediaProbe::testMp3CbrDuration()
+{
+    QByteArray mp3 = mp3Frames(100);
+
+    MediaProbe::ProbeResult result = MediaProbe::probe(writeFile("cbr.mp3", mp3));
+    QVERIFY2(result.isValid, qPrintable(result.errorMessage));
+    QCOMPARE(result.container, MediaProbe::Container::Mpeg);
+    QCOMPARE(result.bitrateKbps, 128);
+    QCOMPARE(result.sampleRate, 44100);
+    QCOMPARE(result.durationUs, qint64(100) * 417 * 8 * 1000 / 128);
+}
+
+void TestMediaProbe::testMp3XingDuration()
+{
+    QByteArray mp3 = mp3Frames(10);
+
+    // Info header for MPEG1 stereo lives 36 bytes into the first frame
+    QByteArray info;
+    info.append("Info");
+    appendBE32(info, 0x1);  // frame count present
+    appendBE32(info, 1000); // frames
+    mp3.replace(36, info.size(), info);
+
+    MediaProbe::ProbeResult result = MediaProbe::probe(writeFile("vbr.mp3", mp3));
+    QVERIFY2(result.isValid, qPrintable(result.errorMessage));
+    QCOMPARE(result.durationUs, qint64(26122448)); // 1000 * 1152 / 44100 s
+}
+
+void TestMediaProbe::testMp3WithId3Tag()
+{
+    QByteArray mp3;
+    mp3.append("ID3");
+    mp3.append(char(3));
+    mp3.append(char(0));
+    mp3.append(char(0));
+    mp3.append(QByteArray::fromHex("00000100")); // 128 bytes, syncsafe
+    mp3.append(QByteArray(128, 0));
+    mp3.append(mp3Frames(50));
+
+    MediaProbe::ProbeResult result = MediaProbe::probe(writeFile("tagged.mp3", mp3));
+    QVERIFY2(result.isValid, qPrintable(result.errorMessage));
+    QCOMPARE(result.durationUs, qint64(50) * 417 * 8 * 1000 / 128);
+}
+
+void TestMediaProbe::testMp4Duration()
+{
+    QByteArray mp4;
+    appendBE32(mp4, 16);
+    mp4.append("ftypM4A ");
+    appendBE32(mp4, 0);
+
+    QByteArray mvhd;
+    appendBE32(mvhd, 0);      // version 0, flags
+    appendBE32(mvhd, 0);      // creation time
+    appendBE32(mvhd, 0);      // modification time
+    appendBE32(mvhd, 1000);   // timescale
+    appendBE32(mvhd, 180000); // duration
+    mvhd.append(QByteArray(80, 0));
+
+    QByteArray moov;
+    appendBE32(moov, 8 + mvhd.size());
+    moov.append("mvhd");
+    moov.append(mvhd);
+
+    appendBE32(mp4, 8 + moov.size());
+    mp4.append("moov");
+    mp4.append(moov);
+
+    MediaProbe::ProbeResult result = MediaProbe::probe(writeFile("test.m4a", mp4));
+    QVERIFY2(result.isValid, qPrintable(result.errorMessage));
+    QCOMPARE(result.container, MediaProbe::Container::Mp4);
+    QCOMPARE(result.durationUs, qint64(180000000));
+    QCOMPARE(result.durationString(), QString("0:03:00"));
+}
+
+void TestMediaProbe::testUnknownFile()
+{
+    MediaProbe::ProbeResult result =
+        MediaProbe::probe(writeFile("notes.txt", QByteArray("just some text, not audio")));
+    QVERIFY(!result.isValid);
+    QCOMPARE(result.container, MediaProbe::Container::Unknown);
+    QVERIFY(!result.errorMessage.isEmpty());
+    QVERIFY(result.durationString().isEmpty());
+}
+
+void TestMediaProbe::testMissingFile()
+{
+    QCOMPARE(MediaProbe::durationUs(m_tempDir->path() + "/missing.ogg"), qint64(-1));
+}
+
+void TestMediaProbe::testFormatDuration()
+{
+    QCOMPARE(MediaProbe::formatDuration(0), QString("0:00:00"));
+    QCOMPARE(MediaProbe::formatDuration(225500000), QString("0:03:45"));
+    QCOMPARE(MediaProbe::formatDuration(qint64(3723) * 1000000), QString("1:02:03"));
+}
+
+QString TestMediaProbe::writeFile(const QString& name, const QByteArray& data)
+{
+    QString path = m_tempDir->path() + "/" + name;
+    QFile file(path);
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(data);
+        file.close();
+    }
+    return path;
+}
+
+QByteArray TestMediaProbe::oggPage(quint32 serial, quint64 granule, const QByteArray& packet)
+{
+    QByteArray page;
+    page.append("OggS");
+    page.append(char(0));                      // version
+    page.append(char(granule == 0 ? 0x02 : 0)); // header type
+    appendLE64(page, granule);
+    appendLE32(page, serial);
+    appendLE32(page, 0); // sequence
+    appendLE32(page, 0); // checksum (not verified by the probe)
+    page.append(char(1));
+    page.append(char(packet.size()));
+    page.append(packet);
+    return page;
+}
+
+QByteArray TestMediaProbe::mp3Frames(int count)
+{
+    // MPEG1 layer III, 128 kbps, 44.1 kHz, stereo: 417 byte frames
+    QByteArray frame = QByteArray::fromHex("FFFB9000");
+    frame.append(QByteArray(417 - 4, 0));
+
+    QByteArray data;
+    for (int i = 0; i < count; ++i) {
+        data.append(frame);
+    }
+    return data;
+}
+
+QTEST_MAIN(TestMediaProbe)
@@ -0,0 +1,48 @@
+#ifndef TESTMEDIAPROBE_H
+#define TESTMEDIAPROBE_H
+
+#include <QObject>
+#include <QTest>
+#include <QTemporaryDir>
+#include <memory>
+
+/**
+ * @brief Unit tests for MediaProbe class
+ *
+ * Tests the in-process duration probe against synthetic files including:
+ * - WAV fmt/data chunk parsing
+ * - FLAC STREAMINFO parsing
+ * - Ogg Vorbis and Opus granule positions
+ * - MPEG CBR estimation and Xing headers, with and without ID3v2 tags
+ * - MP4 mvhd parsing
+ * - Failure reporting for unknown or missing files
+ */
+class TestMediaProbe : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testWavDuration();
+    void testFlacDuration();
+    void testOggVorbisDuration();
+    void testOggOpusPreSkip();
+    void testMp3CbrDuration();
+    void testMp3XingDuration();
+    void testMp3WithId3Tag();
+    void testMp4Duration();
+    void testUnknownFile();
+    void testMissingFile();
+    void testFormatDuration();
+
+private:
+    QString writeFile(const QString& name, const QByteArray& data);
+    static QByteArray oggPage(quint32 serial, quint64 granule, const QByteArray& packet);
+    static QByteArray mp3Frames(int count);
+
+    std::unique_ptr<QTemporaryDir> m_tempDir;
+};
+
+#endif // TESTMEDIAPROBE_H
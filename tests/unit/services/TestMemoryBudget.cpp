@@ -0,0 +1,174 @@
+#include "TestMemoryBudget.h"
+#include "../../../src/services/MemoryBudget.h"
+#include <QSignalSpy>
+#include <QSqlDatabase>
+
+namespace {
+
+// A subsystem holding a settable number of bytes, and counting its shrinks
+struct FakeSubsystem {
+    QObject context;
+    qint64 bytes = 0;
+    int shrinks = 0;
+
+    bool add(MemoryBudget& budget, const QString& name, qint64 budgetBytes, bool shrinkable = true)
+    {
+        MemoryBudget::Shrink shrink;
+        if (shrinkable) {
+            shrink = [this](qint64 target) {
+                ++shrinks;
+                bytes = qMin(bytes, target);
+            };
+        }
+        return budget.addSubsystem(name, &context, budgetBytes, [this]() { return bytes; },
+                                   shrink);
+    }
+};
+
+} // namespace
+
+void TestMemoryBudget::testRefusesBadNames()
+{
+    MemoryBudget budget;
+    FakeSubsystem cache;
+    QVERIFY(!cache.add(budget, "Search Cache", 100));
+    QVERIFY(!cache.add(budget, "1cache", 100));
+    QVERIFY(!cache.add(budget, "", 100));
+    QVERIFY(!budget.addSubsystem("cache", nullptr, 100, []() { return qint64(0); }));
+    QVERIFY(!budget.addSubsystem("cache", &cache.context, 100, MemoryBudget::Usage()));
+    QVERIFY(budget.subsystems().isEmpty());
+
+    QVERIFY(cache.add(budget, "search_cache", 100));
+    QCOMPARE(budget.subsystems(), QStringList{"search_cache"});
+}
+
+void TestMemoryBudget::testShrinksOverBudget()
+{
+    MemoryBudget budget;
+    budget.setEnvelope(0);
+    FakeSubsystem cache;
+    QVERIFY(cache.add(budget, "cache", 1000));
+    QSignalSpy exceeded(&budget, &MemoryBudget::budgetExceeded);
+
+    cache.bytes = 1500;
+    QCOMPARE(budget.check(), 1);
+    QCOMPARE(cache.shrinks, 1);
+    QCOMPARE(cache.bytes, qint64(1000 * MemoryBudget::SHRINK_TARGET_PERCENT / 100));
+    QCOMPARE(exceeded.count(), 1);
+    QCOMPARE(exceeded.at(0).at(0).toString(), QString("cache"));
+    QCOMPARE(exceeded.at(0).at(1).toLongLong(), qint64(1500));
+    QCOMPARE(budget.report().at(0).shrinks, 1);
+
+    // A new budget applies to the next check
+    budget.setBudget("cache", 500);
+    QCOMPARE(budget.budget("cache"), qint64(500));
+    QCOMPARE(budget.check(), 1);
+    QCOMPARE(cache.bytes, qint64(500 * MemoryBudget::SHRINK_TARGET_PERCENT / 100));
+}
+
+void TestMemoryBudget::testWithinBudgetIsLeftAlone()
+{
+    MemoryBudget budget;
+    budget.setEnvelope(0);
+    FakeSubsystem cache;
+    FakeSubsystem buffers;
+    FakeSubsystem unbounded;
+    QVERIFY(cache.add(budget, "cache", 1000));
+    QVERIFY(buffers.add(budget, "buffers", 1000, false));
+    QVERIFY(unbounded.add(budget, "unbounded", 0));
+    QSignalSpy exceeded(&budget, &MemoryBudget::budgetExceeded);
+
+    cache.bytes = 1000;
+    buffers.bytes = 5000;
+    unbounded.bytes = 1 << 30;
+    QCOMPARE(budget.check(), 0);
+    QCOMPARE(cache.shrinks, 0);
+    QCOMPARE(unbounded.shrinks, 0);
+    QCOMPARE(buffers.bytes, qint64(5000));
+
+    // Over its budget but without a hook: reported only
+    QCOMPARE(exceeded.count(), 1);
+    QCOMPARE(exceeded.at(0).at(0).toString(), QString("buffers"));
+}
+
+void TestMemoryBudget::testEnvelopeRelievesAll()
+{
+    if (MemoryBudget::residentBytes() <= 0) {
+        QSKIP("Resident size is not known on this system");
+    }
+
+    MemoryBudget budget;
+    budget.setEnvelope(1);
+    FakeSubsystem cache;
+    FakeSubsystem models;
+    FakeSubsystem buffers;
+    QVERIFY(cache.add(budget, "cache", 1000));
+    QVERIFY(models.add(budget, "models", 0));
+    QVERIFY(buffers.add(budget, "buffers", 0, false));
+    QSignalSpy envelope(&budget, &MemoryBudget::envelopeExceeded);
+
+    cache.bytes = 800;
+    models.bytes = 600;
+    buffers.bytes = 400;
+    QCOMPARE(budget.check(), 2);
+    QCOMPARE(cache.bytes, qint64(400));
+    QCOMPARE(models.bytes, qint64(300));
+    QCOMPARE(buffers.bytes, qint64(400));
+    QCOMPARE(envelope.count(), 1);
+    QCOMPARE(envelope.at(0).at(1).toLongLong(), qint64(1));
+}
+
+void TestMemoryBudget::testContextDestroyedDropsSubsystem()
+{
+    MemoryBudget budget;
+    FakeSubsystem kept;
+    QVERIFY(kept.add(budget, "kept", 100));
+    {
+        FakeSubsystem gone;
+        QVERIFY(gone.add(budget, "gone", 100));
+        QCOMPARE(budget.subsystems().size(), 2);
+    }
+    QCOMPARE(budget.subsystems(), QStringList{"kept"});
+    QCOMPARE(budget.report().size(), 1);
+
+    budget.removeSubsystem("kept");
+    QVERIFY(budget.subsystems().isEmpty());
+    QCOMPARE(budget.accountedBytes(), qint64(0));
+}
+
+void TestMemoryBudget::testExportsGauges()
+{
+    MemoryBudget budget;
+    FakeSubsystem cache;
+    FakeSubsystem models;
+    QVERIFY(cache.add(budget, "cache", 1000));
+    QVERIFY(models.add(budget, "models", 0));
+    cache.bytes = 700;
+    models.bytes = 300;
+    QCOMPARE(budget.accountedBytes(), qint64(1000));
+
+    MetricsRegistry registry;
+    budget.exportTo(registry);
+    const QJsonObject json = registry.toJson();
+    QCOMPARE(json.value("xfb_memory_cache_bytes").toDouble(), 700.0);
+    QCOMPARE(json.value("xfb_memory_cache_budget_bytes").toDouble(), 1000.0);
+    QCOMPARE(json.value("xfb_memory_models_bytes").toDouble(), 300.0);
+    QVERIFY(!json.contains("xfb_memory_models_budget_bytes"));
+    QCOMPARE(json.value("xfb_memory_accounted_bytes").toDouble(), 1000.0);
+    QCOMPARE(json.value("xfb_memory_envelope_bytes").toDouble(),
+             double(MemoryBudget::DEFAULT_ENVELOPE_BYTES));
+    QVERIFY(json.contains("xfb_memory_resident_bytes"));
+}
+
+void TestMemoryBudget::testProcessFigures()
+{
+#ifdef Q_OS_LINUX
+    QVERIFY(MemoryBudget::residentBytes() > 0);
+#endif
+    // The library allocates on first use; a figure is there either way
+    QVERIFY(MemoryBudget::sqliteBytes() >= 0);
+    MemoryBudget::shrinkSqlite(0, QSqlDatabase());
+    QVERIFY(MemoryBudget::sqliteBytes() >= 0);
+}
+
+QTEST_MAIN(TestMemoryBudget)
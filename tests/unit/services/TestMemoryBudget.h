@@ -0,0 +1,33 @@
+#ifndef TESTMEMORYBUDGET_H
+#define TESTMEMORYBUDGET_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for MemoryBudget class
+ *
+ * Tests the per-subsystem memory accounting including:
+ * - Refusing names that cannot be metric names
+ * - Shrinking a subsystem over its budget to the shrink target
+ * - Leaving subsystems within budget, and those without a hook, alone
+ * - Halving every subsystem when the process is over the envelope
+ * - Dropping a subsystem when its context is destroyed
+ * - Exporting usage and budgets as gauges
+ * - Reading the resident size and the SQLite heap
+ */
+class TestMemoryBudget : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testRefusesBadNames();
+    void testShrinksOverBudget();
+    void testWithinBudgetIsLeftAlone();
+    void testEnvelopeRelievesAll();
+    void testContextDestroyedDropsSubsystem();
+    void testExportsGauges();
+    void testProcessFigures();
+};
+
+#endif // TESTMEMORYBUDGET_H
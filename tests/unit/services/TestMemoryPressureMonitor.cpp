@@ -0,0 +1,71 @@
+#include "TestMemoryPressureMonitor.h"
+#include "../../../src/services/MemoryPressureMonitor.h"
+#include <QFile>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+
+namespace {
+
+void writeEvents(const QString& path, int low, int high, int oom)
+{
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    file.write(QString("low %1\nhigh %2\nmax 0\noom %3\noom_kill 0\n")
+                   .arg(low).arg(high).arg(oom).toUtf8());
+}
+
+} // namespace
+
+void TestMemoryPressureMonitor::testPressureEventCount()
+{
+    QCOMPARE(MemoryPressureMonitor::pressureEventCount("low 7\nhigh 3\nmax 2\noom 1\noom_kill 9\n"),
+             qint64(6));
+    QCOMPARE(MemoryPressureMonitor::pressureEventCount(""), qint64(0));
+    QCOMPARE(MemoryPressureMonitor::pressureEventCount("garbage\nhigh\n"), qint64(0));
+}
+
+void TestMemoryPressureMonitor::testRisingCounterSignals()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("memory.events");
+    writeEvents(path, 0, 0, 0);
+
+    MemoryPressureMonitor monitor;
+    QVERIFY(monitor.watchCgroupEvents(path));
+    QCOMPARE(monitor.source(), MemoryPressureMonitor::Source::CgroupEvents);
+    QSignalSpy spy(&monitor, &MemoryPressureMonitor::pressureDetected);
+
+    writeEvents(path, 0, 1, 0);
+    QTRY_COMPARE(spy.count(), 1);
+
+    monitor.stop();
+    QCOMPARE(monitor.source(), MemoryPressureMonitor::Source::None);
+}
+
+void TestMemoryPressureMonitor::testOtherCountersAreQuiet()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("memory.events");
+    writeEvents(path, 0, 2, 0);
+
+    MemoryPressureMonitor monitor;
+    QVERIFY(monitor.watchCgroupEvents(path));
+    QSignalSpy spy(&monitor, &MemoryPressureMonitor::pressureDetected);
+
+    // "low" counts reclaim below the protection, not pressure
+    writeEvents(path, 5, 2, 0);
+    QTest::qWait(300);
+    QCOMPARE(spy.count(), 0);
+}
+
+void TestMemoryPressureMonitor::testMissingFileIsRefused()
+{
+    MemoryPressureMonitor monitor;
+    QVERIFY(!monitor.watchCgroupEvents(QString()));
+    QVERIFY(!monitor.watchCgroupEvents("/nonexistent/memory.events"));
+    QCOMPARE(monitor.source(), MemoryPressureMonitor::Source::None);
+}
+
+QTEST_MAIN(TestMemoryPressureMonitor)
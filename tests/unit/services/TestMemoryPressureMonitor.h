@@ -0,0 +1,27 @@
+#ifndef TESTMEMORYPRESSUREMONITOR_H
+#define TESTMEMORYPRESSUREMONITOR_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for MemoryPressureMonitor class
+ *
+ * Tests the memory pressure reporting including:
+ * - Counting the high, max and oom events of memory.events
+ * - A signal when a watched memory.events counter rises
+ * - No signal when other counters change
+ * - Refusing a memory.events file that cannot be read
+ */
+class TestMemoryPressureMonitor : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testPressureEventCount();
+    void testRisingCounterSignals();
+    void testOtherCountersAreQuiet();
+    void testMissingFileIsRefused();
+};
+
+#endif // TESTMEMORYPRESSUREMONITOR_H
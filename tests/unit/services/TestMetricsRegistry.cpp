@@ -0,0 +1,148 @@
+#include "TestMetricsRegistry.h"
+#include "../../../src/services/MetricsRegistry.h"
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <limits>
+#include <memory>
+
+void TestMetricsRegistry::testBucketBounds()
+{
+    using Histogram = MetricsRegistry::Histogram;
+    for (qint64 value : {0LL, 1LL, 7LL, 8LL, 15LL, 16LL, 17LL, 100LL, 1000LL, 123456LL,
+                         987654321LL, (1LL << 40) + 12345}) {
+        const int bucket = Histogram::bucketFor(value);
+        QVERIFY(bucket >= 0 && bucket < Histogram::BUCKET_COUNT);
+        const qint64 upper = Histogram::bucketUpperBound(bucket);
+        QVERIFY2(upper >= value, qPrintable(QString::number(value)));
+        QVERIFY2(bucket == 0 || Histogram::bucketUpperBound(bucket - 1) < value,
+                 qPrintable(QString::number(value)));
+        // Every value is within one sub-bucket of the bound reported for it
+        QVERIFY2(upper - value <= value / Histogram::SUB_BUCKETS,
+                 qPrintable(QString::number(value)));
+    }
+
+    // Buckets are in order and never overlap
+    for (int bucket = 1; bucket < Histogram::BUCKET_COUNT; ++bucket) {
+        QVERIFY(Histogram::bucketUpperBound(bucket) > Histogram::bucketUpperBound(bucket - 1));
+        QCOMPARE(Histogram::bucketFor(Histogram::bucketUpperBound(bucket)), bucket);
+    }
+    QCOMPARE(Histogram::bucketFor(std::numeric_limits<qint64>::max()),
+             Histogram::BUCKET_COUNT - 1);
+}
+
+void TestMetricsRegistry::testPercentiles()
+{
+    MetricsRegistry::Histogram histogram;
+    QCOMPARE(histogram.percentile(50), qint64(0));
+
+    for (qint64 value = 1; value <= 1000; ++value) {
+        histogram.record(value);
+    }
+    QCOMPARE(histogram.count(), qint64(1000));
+    QCOMPARE(histogram.sum(), qint64(500500));
+    QCOMPARE(histogram.max(), qint64(1000));
+
+    const qint64 median = histogram.percentile(50);
+    QVERIFY2(median >= 500 && median <= 500 + 500 / MetricsRegistry::Histogram::SUB_BUCKETS,
+             qPrintable(QString::number(median)));
+    const qint64 p99 = histogram.percentile(99);
+    QVERIFY2(p99 >= 990 && p99 <= 1000, qPrintable(QString::number(p99)));
+    QCOMPARE(histogram.percentile(100), qint64(1000));
+    QCOMPARE(histogram.percentile(0), qint64(1));
+
+    // A negative time from a clock step counts as 0 rather than breaking the sum
+    histogram.record(-5);
+    QCOMPARE(histogram.count(), qint64(1001));
+    QCOMPARE(histogram.sum(), qint64(500500));
+    QCOMPARE(histogram.percentile(0), qint64(0));
+
+    histogram.reset();
+    QCOMPARE(histogram.count(), qint64(0));
+    QCOMPARE(histogram.sum(), qint64(0));
+    QCOMPARE(histogram.max(), qint64(0));
+    QCOMPARE(histogram.percentile(50), qint64(0));
+    histogram.record(7);
+    QCOMPARE(histogram.percentile(100), qint64(7));
+}
+
+void TestMetricsRegistry::testNames()
+{
+    MetricsRegistry registry;
+    MetricsRegistry::Counter* counter = registry.counter("xfb_test_total", "Test counter");
+    QVERIFY(counter);
+    QCOMPARE(registry.counter("xfb_test_total", "Same counter"), counter);
+
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression("another type"));
+    QVERIFY(!registry.gauge("xfb_test_total", "Clash"));
+
+    QVERIFY(MetricsRegistry::isValidName("xfb:render_time_seconds"));
+    QVERIFY(!MetricsRegistry::isValidName(""));
+    QVERIFY(!MetricsRegistry::isValidName("9lives"));
+    QVERIFY(!MetricsRegistry::isValidName("xfb-render"));
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression("invalid metric name"));
+    QVERIFY(!registry.histogram("render time", "Spaces are not allowed"));
+}
+
+void TestMetricsRegistry::testPrometheusText()
+{
+    MetricsRegistry registry;
+    registry.counter("xfb_plays_total", "Tracks played")->add(3);
+    registry.gauge("xfb_cache_ratio", "Hit ratio\nof the cache")->set(0.25);
+    MetricsRegistry::Histogram* histogram = registry.histogram("xfb_render_us", "Render time");
+    histogram->record(4);
+    histogram->record(6);
+
+    const QByteArray text = registry.toPrometheus();
+    const QList<QByteArray> lines = text.split('\n');
+
+    // Sorted by name, each with its help and type
+    QVERIFY(text.endsWith('\n'));
+    QCOMPARE(lines.value(0), QByteArray("# HELP xfb_cache_ratio Hit ratio\\nof the cache"));
+    QCOMPARE(lines.value(1), QByteArray("# TYPE xfb_cache_ratio gauge"));
+    QCOMPARE(lines.value(2), QByteArray("xfb_cache_ratio 0.25"));
+    QCOMPARE(lines.value(3), QByteArray("# HELP xfb_plays_total Tracks played"));
+    QCOMPARE(lines.value(4), QByteArray("# TYPE xfb_plays_total counter"));
+    QCOMPARE(lines.value(5), QByteArray("xfb_plays_total 3"));
+    QCOMPARE(lines.value(7), QByteArray("# TYPE xfb_render_us summary"));
+    QCOMPARE(lines.value(8), QByteArray("xfb_render_us{quantile=\"0.5\"} 4"));
+    QVERIFY(lines.contains("xfb_render_us{quantile=\"1\"} 6"));
+    QVERIFY(lines.contains("xfb_render_us_sum 10"));
+    QVERIFY(lines.contains("xfb_render_us_count 2"));
+}
+
+void TestMetricsRegistry::testJson()
+{
+    MetricsRegistry registry;
+    registry.counter("xfb_plays_total", "Tracks played")->set(7);
+    registry.histogram("xfb_query_ms", "Query time")->record(12);
+
+    const QJsonObject json = registry.toJson();
+    QCOMPARE(json.value("xfb_plays_total").toInt(), 7);
+    const QJsonObject query = json.value("xfb_query_ms").toObject();
+    QCOMPARE(query.value("count").toInt(), 1);
+    QCOMPARE(query.value("sum").toInt(), 12);
+    QCOMPARE(query.value("max").toInt(), 12);
+    QCOMPARE(query.value("quantiles").toObject().value("0.99").toInt(), 12);
+}
+
+void TestMetricsRegistry::testCollectors()
+{
+    MetricsRegistry registry;
+    auto context = std::make_unique<QObject>();
+    int runs = 0;
+    registry.addCollector(context.get(), [&runs](MetricsRegistry& metrics) {
+        ++runs;
+        metrics.gauge("xfb_collected", "Set by a collector")->set(runs);
+    });
+
+    QVERIFY(registry.toPrometheus().contains("xfb_collected 1\n"));
+    QCOMPARE(registry.toJson().value("xfb_collected").toInt(), 2);
+
+    // The collector goes with its context; the metric it set stays
+    context.reset();
+    registry.toPrometheus();
+    QCOMPARE(runs, 2);
+    QVERIFY(registry.toJson().contains("xfb_collected"));
+}
+
+QTEST_MAIN(TestMetricsRegistry)
@@ -0,0 +1,30 @@
+#ifndef TESTMETRICSREGISTRY_H
+#define TESTMETRICSREGISTRY_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for MetricsRegistry class
+ *
+ * Tests the metrics registry including:
+ * - Histogram buckets staying within their relative error
+ * - Percentiles, capped at the largest value recorded, and reset
+ * - One metric per name, and refusing invalid names or a second type
+ * - The Prometheus text and JSON exports
+ * - Collectors running before each export until their context is gone
+ */
+class TestMetricsRegistry : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testBucketBounds();
+    void testPercentiles();
+    void testNames();
+    void testPrometheusText();
+    void testJson();
+    void testCollectors();
+};
+
+#endif // TESTMETRICSREGISTRY_H
@@ -0,0 +1,123 @@
+#include "TestMetricsServer.h"
+#include "../../../src/services/MetricsRegistry.h"
+#include "../../../src/services/MetricsServer.h"
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSignalSpy>
+#include <QTcpSocket>
+
+namespace {
+
+/// Send a raw request and return everything the server answers before it closes.
+/// The server runs on this thread, so this waits in the event loop rather than blocking.
+QByteArray fetch(quint16 port, const QByteArray& request)
+{
+    QTcpSocket socket;
+    QByteArray response;
+    QObject::connect(&socket, &QTcpSocket::connected, &socket,
+                     [&socket, request]() { socket.write(request); });
+    QObject::connect(&socket, &QTcpSocket::readyRead, &socket,
+                     [&socket, &response]() { response += socket.readAll(); });
+    QSignalSpy closed(&socket, &QTcpSocket::disconnected);
+    socket.connectToHost(QHostAddress::LocalHost, port);
+    closed.wait(5000);
+    response += socket.readAll();
+    return response;
+}
+
+QByteArray body(const QByteArray& response)
+{
+    const qsizetype end = response.indexOf("\r\n\r\n");
+    return end < 0 ? QByteArray() : response.mid(end + 4);
+}
+
+} // namespace
+
+void TestMetricsServer::testServesPrometheusText()
+{
+    MetricsRegistry registry;
+    registry.counter("xfb_plays_total", "Tracks played")->add(2);
+    MetricsServer server(&registry);
+    QVERIFY(server.listen(0, QHostAddress::LocalHost));
+    QVERIFY(server.port() > 0);
+
+    const QByteArray response = fetch(server.port(), "GET /metrics HTTP/1.1\r\nHost: x\r\n\r\n");
+    QVERIFY2(response.startsWith("HTTP/1.1 200 OK\r\n"), response.constData());
+    QVERIFY(response.contains("Content-Type: text/plain; version=0.0.4"));
+    QVERIFY(body(response).contains("xfb_plays_total 2\n"));
+}
+
+void TestMetricsServer::testServesJson()
+{
+    MetricsRegistry registry;
+    registry.gauge("xfb_cache_ratio", "Hit ratio")->set(0.5);
+    MetricsServer server(&registry);
+    QVERIFY(server.listen(0, QHostAddress::LocalHost));
+
+    const QByteArray response =
+        fetch(server.port(), "GET /metrics.json?pretty=0 HTTP/1.1\r\nHost: x\r\n\r\n");
+    QVERIFY2(response.startsWith("HTTP/1.1 200 OK\r\n"), response.constData());
+    QVERIFY(response.contains("Content-Type: application/json"));
+    const QJsonObject json = QJsonDocument::fromJson(body(response)).object();
+    QCOMPARE(json.value("xfb_cache_ratio").toDouble(), 0.5);
+}
+
+void TestMetricsServer::testHeadHasNoBody()
+{
+    MetricsRegistry registry;
+    registry.counter("xfb_plays_total", "Tracks played")->add(1);
+    MetricsServer server(&registry);
+    QVERIFY(server.listen(0, QHostAddress::LocalHost));
+
+    const QByteArray response = fetch(server.port(), "HEAD /metrics HTTP/1.1\r\n\r\n");
+    QVERIFY2(response.startsWith("HTTP/1.1 200 OK\r\n"), response.constData());
+    QVERIFY(!response.contains("Content-Length: 0\r\n"));
+    QVERIFY(body(response).isEmpty());
+}
+
+void TestMetricsServer::testServesAddedPaths()
+{
+    MetricsRegistry registry;
+    MetricsServer server(&registry);
+    int builds = 0;
+    server.addPath("/trace.json", "application/json", [&builds]() {
+        ++builds;
+        return QByteArray("{\"traceEvents\":[]}");
+    });
+    QVERIFY(server.listen(0, QHostAddress::LocalHost));
+
+    const QByteArray response = fetch(server.port(), "GET /trace.json HTTP/1.1\r\n\r\n");
+    QVERIFY2(response.startsWith("HTTP/1.1 200 OK\r\n"), response.constData());
+    QVERIFY(response.contains("Content-Type: application/json\r\n"));
+    QCOMPARE(body(response), QByteArray("{\"traceEvents\":[]}"));
+    QCOMPARE(builds, 1);
+}
+
+void TestMetricsServer::testRejectsOtherRequests()
+{
+    MetricsRegistry registry;
+    MetricsServer server(&registry);
+    QVERIFY(server.listen(0, QHostAddress::LocalHost));
+
+    QVERIFY(fetch(server.port(), "GET / HTTP/1.1\r\n\r\n").startsWith("HTTP/1.1 404"));
+    const QByteArray post = fetch(server.port(), "POST /metrics HTTP/1.1\r\n\r\n");
+    QVERIFY(post.startsWith("HTTP/1.1 405"));
+    QVERIFY(post.contains("Allow: GET, HEAD\r\n"));
+
+    server.close();
+    QVERIFY(!server.isListening());
+    QCOMPARE(server.port(), quint16(0));
+}
+
+void TestMetricsServer::testRejectsOversizedRequest()
+{
+    MetricsRegistry registry;
+    MetricsServer server(&registry);
+    QVERIFY(server.listen(0, QHostAddress::LocalHost));
+
+    const QByteArray request = "GET /metrics HTTP/1.1\r\nX-Padding: " +
+                               QByteArray(MetricsServer::MAX_REQUEST_BYTES, 'x');
+    QVERIFY(fetch(server.port(), request).startsWith("HTTP/1.1 431"));
+}
+
+QTEST_MAIN(TestMetricsServer)
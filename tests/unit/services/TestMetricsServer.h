@@ -0,0 +1,30 @@
+#ifndef TESTMETRICSSERVER_H
+#define TESTMETRICSSERVER_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for MetricsServer class
+ *
+ * Tests the metrics endpoint including:
+ * - Prometheus text on /metrics and JSON on /metrics.json
+ * - HEAD answered without a body
+ * - Documents added with addPath()
+ * - 404 for other paths and 405 for other methods
+ * - Dropping requests that grow past the size limit
+ */
+class TestMetricsServer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testServesPrometheusText();
+    void testServesJson();
+    void testHeadHasNoBody();
+    void testServesAddedPaths();
+    void testRejectsOtherRequests();
+    void testRejectsOversizedRequest();
+};
+
+#endif // TESTMETRICSSERVER_H
@@ -0,0 +1,109 @@
+#include "TestMicDucker.h"
+#include "../../../src/services/MicDucker.h"
+#include <cmath>
+#include <vector>
+
+namespace {
+
+constexpr int RATE = 48000;
+constexpr int CHANNELS = 2;
+
+// A block of the side chain at a constant level
+void feed(MicDucker& ducker, float level, int ms)
+{
+    std::vector<float> samples(size_t(RATE / 1000 * ms * CHANNELS), level);
+    ducker.processInput(samples.data(), int(samples.size()), CHANNELS, RATE);
+}
+
+// Gain the music had at the end of a block of ms milliseconds
+float duck(MicDucker& ducker, int ms)
+{
+    const int frames = RATE / 1000 * ms;
+    std::vector<float> samples(size_t(frames * CHANNELS), 1.0f);
+    ducker.process(samples.data(), frames, CHANNELS, RATE);
+    return samples.back();
+}
+
+float db(float gain)
+{
+    return 20.0f * std::log10(gain);
+}
+
+} // namespace
+
+void TestMicDucker::testDetectsSpeech()
+{
+    MicDucker ducker;
+    feed(ducker, 0.001f, 100);   // -60 dB, under the default threshold
+    QVERIFY(!ducker.isSpeaking());
+
+    feed(ducker, 0.1f, 20);      // -20 dB
+    QVERIFY(ducker.isSpeaking());
+}
+
+void TestMicDucker::testHoldsBetweenWords()
+{
+    MicDucker ducker;
+    feed(ducker, 0.1f, 20);
+    QVERIFY(ducker.isSpeaking());
+
+    // A pause shorter than the hold is still speech; a longer one is not
+    feed(ducker, 0.0f, MicDucker::HOLD_MS / 2);
+    QVERIFY(ducker.isSpeaking());
+    feed(ducker, 0.0f, MicDucker::HOLD_MS);
+    QVERIFY(!ducker.isSpeaking());
+}
+
+void TestMicDucker::testDucksOverAttack()
+{
+    MicDucker ducker;
+    ducker.setEnabled(true);
+    ducker.setDepthDb(-12.0);
+    ducker.setAttackMs(50);
+
+    QCOMPARE(duck(ducker, 10), 1.0f);
+    feed(ducker, 0.1f, 20);
+
+    const float halfway = duck(ducker, 25);
+    QVERIFY(qAbs(db(halfway) + 6.0f) < 0.1f);
+    QVERIFY(qAbs(db(duck(ducker, 25)) + 12.0f) < 0.01f);
+    QVERIFY(qAbs(db(duck(ducker, 100)) + 12.0f) < 0.01f);
+    QVERIFY(qAbs(db(ducker.gain()) + 12.0f) < 0.01f);
+}
+
+void TestMicDucker::testReleases()
+{
+    MicDucker ducker;
+    ducker.setEnabled(true);
+    ducker.setAttackMs(0);
+    ducker.setReleaseMs(400);
+
+    feed(ducker, 0.1f, 20);
+    QVERIFY(qAbs(db(duck(ducker, 10)) + 12.0f) < 0.01f);
+
+    feed(ducker, 0.0f, MicDucker::HOLD_MS * 2);
+    QVERIFY(!ducker.isSpeaking());
+    const float halfway = duck(ducker, 200);
+    QVERIFY(qAbs(db(halfway) + 6.0f) < 0.1f);
+    QCOMPARE(duck(ducker, 200), 1.0f);
+}
+
+void TestMicDucker::testDisabledAndReset()
+{
+    MicDucker ducker;
+    feed(ducker, 0.5f, 20);
+    QVERIFY(ducker.isSpeaking());
+    QCOMPARE(duck(ducker, 100), 1.0f);
+
+    ducker.setEnabled(true);
+    ducker.setAttackMs(0);
+    QVERIFY(duck(ducker, 10) < 0.5f);
+
+    // A stopped capture lets the music back up
+    ducker.reset();
+    QVERIFY(!ducker.isSpeaking());
+    ducker.setReleaseMs(0);
+    QCOMPARE(duck(ducker, 10), 1.0f);
+}
+
+QTEST_MAIN(TestMicDucker)
@@ -0,0 +1,28 @@
+#ifndef TESTMICDUCKER_H
+#define TESTMICDUCKER_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for MicDucker class
+ *
+ * Tests the side-chain ducker including:
+ * - Speech heard above the threshold, and held between words
+ * - The music going down by the depth over the attack time
+ * - The music coming back up over the release time
+ * - Disabled and reset duckers leaving the music alone
+ */
+class TestMicDucker : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testDetectsSpeech();
+    void testHoldsBetweenWords();
+    void testDucksOverAttack();
+    void testReleases();
+    void testDisabledAndReset();
+};
+
+#endif // TESTMICDUCKER_H
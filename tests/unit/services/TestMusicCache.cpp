@@ -1,7 +1,11 @@
 #include "TestMusicCache.h"
 #include "../../../src/services/MusicCache.h"
 #include "../../../src/repositories/MusicRepository.h"
+#include "../../../src/services/HourGenreSchedule.h"
 #include <QSignalSpy>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
 #include <QThread>
 #include <QJsonDocument>
 #include <QJsonObject>
@@ -11,6 +15,54 @@
 #include <QRandomGenerator>
 #include <QDebug>
 
+namespace {
+
+const char* WARMUP_CONNECTION = "test_music_cache_warmup";
+
+// Three tracks of equal size: 1 (Jazz, played once), 2 (Rock, played ten
+// times) and 3 (Jazz, played five times).
+bool createWarmupDatabase(QSqlDatabase& database, const QString& path)
+{
+    database = QSqlDatabase::addDatabase("QSQLITE", WARMUP_CONNECTION);
+    database.setDatabaseName(path);
+    if (!database.open()) {
+        return false;
+    }
+    
+    QSqlQuery query(database);
+    if (!query.exec("CREATE TABLE musics (id INTEGER PRIMARY KEY AUTOINCREMENT, "
+                    "artist VARCHAR(50) NOT NULL, song VARCHAR(25) NOT NULL, "
+                    "genre1 VARCHAR(25) NOT NULL, genre2 VARCHAR(25), country VARCHAR(25), "
+                    "published_date VARCHAR(25), path TEXT, time TEXT, "
+                    "played_times INTEGER DEFAULT 0, last_played TEXT)")
+        || !query.exec("CREATE TABLE hourgenre (id INTEGER PRIMARY KEY AUTOINCREMENT, "
+                       "day TEXT, hour TEXT, genre TEXT)")) {
+        qWarning() << query.lastError().text();
+        return false;
+    }
+    
+    const QStringList genres = {"Jazz", "Rock", "Jazz"};
+    const QList<int> playedTimes = {1, 10, 5};
+    query.prepare("INSERT INTO musics (artist, song, genre1, genre2, country, published_date, "
+                  "path, time, played_times, last_played) VALUES (?, ?, ?, '', 'PT', '2023', ?, '3:45', ?, ?)");
+    for (int i = 0; i < genres.size(); ++i) {
+        query.addBindValue(QString("Artist%1").arg(i + 1));
+        query.addBindValue(QString("Song%1").arg(i + 1));
+        query.addBindValue(genres.at(i));
+        query.addBindValue(QString("/music/%1.mp3").arg(i + 1));
+        query.addBindValue(playedTimes.at(i));
+        query.addBindValue(QString("2024-01-0%1T12:00:00").arg(i + 1));
+        if (!query.exec()) {
+            qWarning() << query.lastError().text();
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+} // namespace
+
 void TestMusicCache::initTestCase()
 {
     // Register metatypes for signal testing
@@ -531,6 +583,56 @@ void TestMusicCache::testInvalidateExpired()
     QVERIFY(!m_cache->contains(2));
 }
 
+void TestMusicCache::testInvalidateMusic()
+{
+    QVERIFY(m_cache->initialize());
+    
+    QSignalSpy evictionSpy(m_cache.get(), &MusicCache::entryEvicted);
+    
+    m_cache->put(1, createTestMusicItem(1));
+    m_cache->put(1, createTestMusicItem(1), "favorites");
+    m_cache->put(2, createTestMusicItem(2));
+    m_cache->putSearchResults("with one", createTestMusicList(3));  // IDs 0, 1, 2
+    QList<MusicItem> withoutOne;
+    withoutOne.append(createTestMusicItem(5));
+    m_cache->putSearchResults("without one", withoutOne);
+    
+    QCOMPARE(m_cache->invalidateMusic(1), 3);
+    
+    QVERIFY(!m_cache->contains(1));
+    QVERIFY(!m_cache->contains(1, "favorites"));
+    QVERIFY(!m_cache->containsSearchResults("with one"));
+    QVERIFY(m_cache->contains(2));
+    QVERIFY(m_cache->containsSearchResults("without one"));
+    QCOMPARE(m_cache->getStatistics().currentEntries, qint64(2));
+    
+    QCOMPARE(evictionSpy.count(), 3);
+    QCOMPARE(evictionSpy.first().at(2).toString(), QString("invalidated"));
+    
+    // A replaced search no longer depends on its old results
+    m_cache->putSearchResults("without one", createTestMusicList(1)); // ID 0
+    QCOMPARE(m_cache->invalidateMusic(5), 0);
+    QCOMPARE(m_cache->invalidateMusic(0), 1);
+    QCOMPARE(m_cache->invalidateMusic(0), 0);
+}
+
+void TestMusicCache::testInvalidateSearchResults()
+{
+    QVERIFY(m_cache->initialize());
+    
+    m_cache->put(1, createTestMusicItem(1));
+    m_cache->putSearchResults("first", createTestMusicList(2));
+    m_cache->putSearchResults("second", createTestMusicList(4));
+    
+    QCOMPARE(m_cache->invalidateSearchResults(), 2);
+    QVERIFY(!m_cache->containsSearchResults("first"));
+    QVERIFY(!m_cache->containsSearchResults("second"));
+    QVERIFY(m_cache->contains(1));
+    
+    // The dependency index went with them
+    QCOMPARE(m_cache->invalidateMusic(0), 0);
+}
+
 void TestMusicCache::testCleanup()
 {
     QVERIFY(m_cache->initialize());
@@ -538,16 +640,17 @@ void TestMusicCache::testCleanup()
     QSignalSpy cleanupSpy(m_cache.get(), &MusicCache::cleanupCompleted);
     
     // Set small memory limit
-    m_cache->setMaxMemoryUsage(1024); // 1KB
+    const qint64 itemSize = musicItemSize();
+    m_cache->setMaxMemoryUsage(5 * itemSize);
     
     // Add data that exceeds limit
     populateCacheWithTestData(20);
     
     qint64 initialMemory = m_cache->currentMemoryUsage();
-    QVERIFY(initialMemory > 1024);
+    QVERIFY(initialMemory > 2 * itemSize);
     
     // Force cleanup
-    m_cache->cleanup(512); // Target 512 bytes
+    m_cache->cleanup(2 * itemSize);
     
     // Verify memory usage decreased
     qint64 finalMemory = m_cache->currentMemoryUsage();
@@ -564,7 +667,7 @@ void TestMusicCache::testMemoryLimitEnforcement()
     QSignalSpy thresholdSpy(m_cache.get(), &MusicCache::memoryThresholdExceeded);
     
     // Set very small memory limit
-    m_cache->setMaxMemoryUsage(512); // 512 bytes
+    m_cache->setMaxMemoryUsage(3 * musicItemSize());
     
     // Add data that should trigger cleanup
     for (int i = 0; i < 10; i++) {
@@ -581,7 +684,7 @@ void TestMusicCache::testLRUEviction()
     QVERIFY(m_cache->initialize());
     
     // Set small memory limit to force eviction
-    m_cache->setMaxMemoryUsage(1024);
+    m_cache->setMaxMemoryUsage(8 * musicItemSize());
     
     // Add items
     for (int i = 0; i < 10; i++) {
@@ -618,7 +721,7 @@ void TestMusicCache::testPinnedEntriesNotEvicted()
     QVERIFY(m_cache->initialize());
     
     // Set small memory limit
-    m_cache->setMaxMemoryUsage(1024);
+    m_cache->setMaxMemoryUsage(4 * musicItemSize());
     
     // Add and pin an item
     MusicItem music = createTestMusicItem(100);
@@ -863,6 +966,86 @@ void TestMusicCache::testWarmupStrategies()
     QCOMPARE(m_cache->warmupStrategy(), MusicCache::RecentItemsWarmup);
 }
 
+void TestMusicCache::testRepositoryWarmup()
+{
+    QSqlDatabase database;
+    QVERIFY(createWarmupDatabase(database, m_tempDir->path() + "/warmup.db"));
+    
+    {
+        MusicRepository repository(database);
+        QVERIFY(m_cache->initialize());
+        m_cache->attachRepository(&repository);
+        
+        QSignalSpy warmupSpy(m_cache.get(), &MusicCache::warmupCompleted);
+        m_cache->setWarmupStrategy(MusicCache::PopularItemsWarmup);
+        m_cache->warmupCache();
+        QVERIFY(warmupSpy.wait(5000));
+        QCOMPARE(warmupSpy.count(), 1);
+        QCOMPARE(warmupSpy.first().at(0).toInt(), 3);
+        
+        QVERIFY(m_cache->contains(1));
+        QVERIFY(m_cache->contains(2));
+        QVERIFY(m_cache->contains(3));
+        QCOMPARE(m_cache->get(2)->song, QString("Song2"));
+        QVERIFY(m_cache->getStatistics().lastWarmup.isValid());
+        
+        m_cache->shutdown();
+    }
+    
+    database.close();
+    database = QSqlDatabase();
+    QSqlDatabase::removeDatabase(WARMUP_CONNECTION);
+}
+
+void TestMusicCache::testPredictiveWarmup()
+{
+    QSqlDatabase database;
+    QVERIFY(createWarmupDatabase(database, m_tempDir->path() + "/warmup.db"));
+    
+    // Jazz all day today and tomorrow, so the horizon never leaves it
+    QSqlQuery query(database);
+    query.prepare("INSERT INTO hourgenre (day, hour, genre) VALUES (?, ?, 'Jazz')");
+    const int today = QDate::currentDate().dayOfWeek();
+    for (int day : {today, today % 7 + 1}) {
+        for (int hour = 0; hour < 24; ++hour) {
+            query.addBindValue(QString::number(day));
+            query.addBindValue(QString::number(hour));
+            QVERIFY2(query.exec(), qPrintable(query.lastError().text()));
+        }
+    }
+    
+    {
+        MusicRepository repository(database);
+        HourGenreSchedule schedule(database);
+        QVERIFY(m_cache->initialize());
+        m_cache->attachRepository(&repository);
+        m_cache->setHourGenreSchedule(&schedule);
+        m_cache->setWarmupStrategy(MusicCache::PredictiveWarmup);
+        
+        QSignalSpy warmupSpy(m_cache.get(), &MusicCache::warmupCompleted);
+        m_cache->warmupCache();
+        QVERIFY(warmupSpy.wait(5000));
+        QCOMPARE(warmupSpy.last().at(0).toInt(), 3);
+        
+        // Room for a single track: the most played one of the upcoming genre
+        const qint64 itemSize = m_cache->currentMemoryUsage() / 3;
+        m_cache->clear();
+        m_cache->setMaxMemoryUsage(itemSize * 12 / 10);
+        m_cache->warmupCache();
+        QVERIFY(warmupSpy.wait(5000));
+        QCOMPARE(warmupSpy.last().at(0).toInt(), 1);
+        QVERIFY(m_cache->contains(3));
+        QVERIFY(!m_cache->contains(1));
+        QVERIFY(!m_cache->contains(2));
+        
+        m_cache->shutdown();
+    }
+    
+    database.close();
+    database = QSqlDatabase();
+    QSqlDatabase::removeDatabase(WARMUP_CONNECTION);
+}
+
 void TestMusicCache::testPinEntry()
 {
     QVERIFY(m_cache->initialize());
@@ -904,7 +1087,7 @@ void TestMusicCache::testPinnedEntryNotEvicted()
     QVERIFY(m_cache->initialize());
     
     // Set small memory limit
-    m_cache->setMaxMemoryUsage(1024);
+    m_cache->setMaxMemoryUsage(4 * musicItemSize());
     
     // Add and pin an entry
     MusicItem music = createTestMusicItem(100);
@@ -1080,6 +1263,67 @@ void TestMusicCache::testPersistenceWithExpiredEntries()
     QVERIFY(!m_cache->contains(1));
 }
 
+void TestMusicCache::testSnapshotRoundTrip()
+{
+    QVERIFY(m_cache->initialize());
+    
+    m_cache->put(1, createTestMusicItem(1, "Snapshot Artist", "Snapshot Song"));
+    m_cache->put(2, createTestMusicItem(2));
+    m_cache->pinEntry("2", "music");
+    m_cache->putSearchResults("snapshot search", createTestMusicList(3));
+    m_cache->putMetadata("genres", QStringList{"Rock", "Jazz"}, "stats");
+    
+    QString filePath = m_tempDir->filePath("cache.snapshot");
+    QVERIFY(m_cache->saveSnapshot(filePath));
+    
+    m_cache->clear();
+    QCOMPARE(m_cache->getStatistics().currentEntries, qint64(0));
+    
+    QVERIFY(m_cache->loadSnapshot(filePath));
+    QCOMPARE(m_cache->getStatistics().currentEntries, qint64(4));
+    QVERIFY(m_cache->currentMemoryUsage() > 0);
+    
+    auto music = m_cache->get(1);
+    QVERIFY(music != nullptr);
+    QCOMPARE(music->artist, QString("Snapshot Artist"));
+    QCOMPARE(music->song, QString("Snapshot Song"));
+    QCOMPARE(music->path, QString("/test/path/song1.mp3"));
+    QCOMPARE(music->playedTimes, 1);
+    
+    auto pinned = m_cache->getEntryInfo("2", "music");
+    QVERIFY(pinned != nullptr);
+    QVERIFY(pinned->isPinned);
+    
+    const QList<MusicItem> results = m_cache->getSearchResults("snapshot search");
+    QCOMPARE(results.size(), 3);
+    QCOMPARE(results.at(2).id, 2);
+    
+    QCOMPARE(m_cache->getMetadata("genres", "stats").toStringList(), QStringList({"Rock", "Jazz"}));
+}
+
+void TestMusicCache::testCorruptedSnapshot()
+{
+    QVERIFY(m_cache->initialize());
+    
+    populateCacheWithTestData(5);
+    QString filePath = m_tempDir->filePath("truncated.snapshot");
+    QVERIFY(m_cache->saveSnapshot(filePath));
+    
+    // Cut the file short
+    QFile file(filePath);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.resize(file.size() / 2));
+    file.close();
+    
+    m_cache->clear();
+    QVERIFY(!m_cache->loadSnapshot(filePath));
+    
+    // A JSON cache file is not a snapshot
+    QString jsonPath = m_tempDir->filePath("cache.json");
+    QVERIFY(m_cache->saveToFile(jsonPath));
+    QVERIFY(!m_cache->loadSnapshot(jsonPath));
+}
+
 void TestMusicCache::testExportStatistics()
 {
     QVERIFY(m_cache->initialize());
@@ -1156,6 +1400,39 @@ void TestMusicCache::testMemoryUsageCalculation()
     QCOMPARE(afterRemoveMemory, initialMemory);
 }
 
+void TestMusicCache::testMemoryUsageTracksCapacity()
+{
+    QVERIFY(m_cache->initialize());
+    
+    // A longer string is charged for its whole buffer
+    m_cache->put(1, createTestMusicItem(1));
+    const qint64 shortSize = m_cache->currentMemoryUsage();
+    
+    MusicItem longItem = createTestMusicItem(2);
+    longItem.path = QString(1000, QChar('x'));
+    m_cache->put(2, longItem);
+    const qint64 longSize = m_cache->currentMemoryUsage() - shortSize;
+    QVERIFY(longSize - shortSize >= 1000 * qint64(sizeof(QChar)));
+    
+    // Search results are charged per result
+    m_cache->putSearchResults("one", createTestMusicList(1));
+    m_cache->putSearchResults("ten", createTestMusicList(10));
+    const qint64 oneSize = m_cache->getEntryInfo("one", "search")->size;
+    const qint64 tenSize = m_cache->getEntryInfo("ten", "search")->size;
+    QVERIFY(tenSize > 5 * oneSize);
+    
+    // Category sizes add up to the total
+    const auto stats = m_cache->getStatistics();
+    qint64 categoryTotal = 0;
+    for (auto it = stats.categorySize.constBegin(); it != stats.categorySize.constEnd(); ++it) {
+        categoryTotal += it.value();
+    }
+    QCOMPARE(categoryTotal, m_cache->currentMemoryUsage());
+    
+    m_cache->clear();
+    QCOMPARE(m_cache->currentMemoryUsage(), qint64(0));
+}
+
 void TestMusicCache::testMemoryThresholdExceeded()
 {
     QVERIFY(m_cache->initialize());
@@ -1412,7 +1689,7 @@ void TestMusicCache::testMemoryExhaustion()
     QVERIFY(m_cache->initialize());
     
     // Set very small memory limit
-    m_cache->setMaxMemoryUsage(512); // 512 bytes
+    m_cache->setMaxMemoryUsage(3 * musicItemSize());
     
     // Try to add data that exceeds limit
     for (int i = 0; i < 100; i++) {
@@ -1541,6 +1818,13 @@ MusicItem TestMusicCache::createTestMusicItem(int id, const QString& artist, con
     return music;
 }
 
+qint64 TestMusicCache::musicItemSize()
+{
+    MusicCache cache;
+    cache.put(0, createTestMusicItem(0));
+    return cache.currentMemoryUsage();
+}
+
 QList<MusicItem> TestMusicCache::createTestMusicList(int count)
 {
     QList<MusicItem> list;
@@ -62,6 +62,8 @@ private slots:
     void testClear();
     void testClearCategory();
     void testInvalidateExpired();
+    void testInvalidateMusic();
+    void testInvalidateSearchResults();
     void testCleanup();
     void testMemoryLimitEnforcement();
 
@@ -85,6 +87,8 @@ private slots:
     // Cache warming tests
     void testWarmupCache();
     void testWarmupStrategies();
+    void testRepositoryWarmup();
+    void testPredictiveWarmup();
 
     // Pin/unpin tests
     void testPinEntry();
@@ -101,6 +105,8 @@ private slots:
     void testLoadFromFile();
     void testAutoPersistence();
     void testPersistenceWithExpiredEntries();
+    void testSnapshotRoundTrip();
+    void testCorruptedSnapshot();
 
     // Export/import tests
     void testExportStatistics();
@@ -108,6 +114,7 @@ private slots:
 
     // Memory management tests
     void testMemoryUsageCalculation();
+    void testMemoryUsageTracksCapacity();
     void testMemoryThresholdExceeded();
     void testCleanupTargetSize();
 
@@ -134,6 +141,7 @@ private slots:
 private:
     MusicItem createTestMusicItem(int id, const QString& artist = "TestArtist", const QString& song = "TestSong");
     QList<MusicItem> createTestMusicList(int count);
+    qint64 musicItemSize();
     void populateCacheWithTestData(int count = 10);
     void waitForSignal(QObject* sender, const char* signal, int timeout = 1000);
     
@@ -0,0 +1,70 @@
+#include "TestNativeAudioOutput.h"
+#include "../../../src/services/NativeAudioOutput.h"
+
+void TestNativeAudioOutput::testNormalized()
+{
+    NativeAudioOutput::Config config;
+    config.device = "  ";
+    config.sampleRate = 0;
+    config.periodFrames = 1;
+    config.periods = 0;
+    NativeAudioOutput::Config normalized = NativeAudioOutput::normalized(config);
+    QCOMPARE(normalized.device, QString("default"));
+    QCOMPARE(normalized.sampleRate, 48000);
+    QCOMPARE(normalized.periodFrames, NativeAudioOutput::MIN_PERIOD_FRAMES);
+    QCOMPARE(normalized.periods, 2);
+
+    config.device = "hw:0,0";
+    config.sampleRate = 44100;
+    config.periodFrames = 1 << 20;
+    config.periods = 100;
+    normalized = NativeAudioOutput::normalized(config);
+    QCOMPARE(normalized.device, QString("hw:0,0"));
+    QCOMPARE(normalized.sampleRate, 44100);
+    QCOMPARE(normalized.periodFrames, NativeAudioOutput::MAX_PERIOD_FRAMES);
+    QCOMPARE(normalized.periods, NativeAudioOutput::MAX_PERIODS);
+
+    // Sizes within the limits are kept as they are
+    config.periodFrames = 128;
+    config.periods = 3;
+    normalized = NativeAudioOutput::normalized(config);
+    QCOMPARE(normalized.periodFrames, 128);
+    QCOMPARE(normalized.periods, 3);
+}
+
+void TestNativeAudioOutput::testToInt16()
+{
+    const float in[] = {0.0f, 0.5f, -0.5f, 1.0f, -1.0f, 2.0f, -3.0f};
+    qint16 out[7] = {};
+    NativeAudioOutput::toInt16(in, out, 7);
+    QCOMPARE(out[0], qint16(0));
+    QCOMPARE(out[1], qint16(16384));
+    QCOMPARE(out[2], qint16(-16384));
+    QCOMPARE(out[3], qint16(32767));
+    QCOMPARE(out[4], qint16(-32767));
+    QCOMPARE(out[5], qint16(32767));
+    QCOMPARE(out[6], qint16(-32767));
+}
+
+void TestNativeAudioOutput::testOpenFails()
+{
+    NativeAudioOutput output;
+    NativeAudioOutput::Config config;
+    config.device = "xfb-no-such-device";
+    QVERIFY(!output.open(config));
+    QVERIFY(!output.isOpen());
+    QVERIFY(!output.errorString().isEmpty());
+    if (!NativeAudioOutput::isAvailable()) {
+        QCOMPARE(output.errorString(), QString("XFB was built without ALSA"));
+    }
+
+    // Nothing is written while it is closed
+    bool rendered = false;
+    QVERIFY(!output.writePeriod([&](float*, int) { rendered = true; }));
+    QVERIFY(!rendered);
+    QCOMPARE(output.statistics().periodsWritten, qint64(0));
+    output.drop();
+    output.close();
+}
+
+QTEST_MAIN(TestNativeAudioOutput)
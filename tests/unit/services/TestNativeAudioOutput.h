@@ -0,0 +1,25 @@
+#ifndef TESTNATIVEAUDIOOUTPUT_H
+#define TESTNATIVEAUDIOOUTPUT_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for NativeAudioOutput class
+ *
+ * Tests the native output including:
+ * - Configs brought within the limits
+ * - Float samples converted to 16 bit with clipping
+ * - A device that cannot be opened, and a build without ALSA
+ */
+class TestNativeAudioOutput : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testNormalized();
+    void testToInt16();
+    void testOpenFails();
+};
+
+#endif // TESTNATIVEAUDIOOUTPUT_H
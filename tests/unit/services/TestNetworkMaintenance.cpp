@@ -0,0 +1,236 @@
+#include "TestNetworkMaintenance.h"
+#include "../../../src/services/NetworkMaintenance.h"
+#include <QHostAddress>
+#include <QNetworkAccessManager>
+#include <QSignalSpy>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <memory>
+
+namespace {
+
+/// Answers every GET with a fixed body and keeps the request paths.
+class FakeHttpServer
+{
+public:
+    FakeHttpServer()
+    {
+        m_server.listen(QHostAddress::LocalHost);
+        QObject::connect(&m_server, &QTcpServer::newConnection, &m_server, [this]() {
+            while (QTcpSocket* socket = m_server.nextPendingConnection()) {
+                accept(socket);
+            }
+        });
+    }
+
+    QString url(const QString& path) const
+    {
+        return QString("http://127.0.0.1:%1%2").arg(m_server.serverPort()).arg(path);
+    }
+
+    QStringList paths;
+    QByteArray body = "127.0.0.1\n";
+    QByteArray updateBody = "good 127.0.0.1";
+
+private:
+    void accept(QTcpSocket* socket)
+    {
+        auto buffer = std::make_shared<QByteArray>();
+        QObject::connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        QObject::connect(socket, &QTcpSocket::readyRead, socket, [this, socket, buffer]() {
+            *buffer += socket->readAll();
+            if (!buffer->contains("\r\n\r\n")) {
+                return;
+            }
+            const QString path = QString::fromUtf8(buffer->left(buffer->indexOf("\r\n"))).section(' ', 1, 1);
+            buffer->clear();
+            paths.append(path);
+
+            const QByteArray reply = path.startsWith("/update") ? updateBody : body;
+            socket->write("HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nConnection: close\r\nContent-Length: " +
+                          QByteArray::number(reply.size()) + "\r\n\r\n" + reply);
+            socket->disconnectFromHost();
+        });
+    }
+
+    QTcpServer m_server;
+};
+
+int lookups(const FakeHttpServer& server)
+{
+    return int(server.paths.count("/ip"));
+}
+
+QHostAddress lookUp(NetworkMaintenance& network, bool force = false)
+{
+    QHostAddress result;
+    bool done = false;
+    network.publicAddress(
+        [&](const QHostAddress& address, const QString&) {
+            result = address;
+            done = true;
+        },
+        force);
+    QTRY_VERIFY(done);
+    return result;
+}
+
+} // namespace
+
+void TestNetworkMaintenance::testAddressIsCached()
+{
+    FakeHttpServer server;
+    NetworkMaintenance network;
+    network.setLookupUrl(QUrl(server.url("/ip")));
+
+    QCOMPARE(lookUp(network), QHostAddress(QHostAddress::LocalHost));
+    QCOMPARE(lookUp(network), QHostAddress(QHostAddress::LocalHost));
+    QCOMPARE(lookups(server), 1);
+
+    // Forced, or once the cache has expired, it is looked up again
+    lookUp(network, true);
+    QCOMPARE(lookups(server), 2);
+    network.setCacheTtl(0);
+    lookUp(network);
+    QCOMPARE(lookups(server), 3);
+}
+
+void TestNetworkMaintenance::testConcurrentLookupsShareOneRequest()
+{
+    FakeHttpServer server;
+    NetworkMaintenance network;
+    network.setLookupUrl(QUrl(server.url("/ip")));
+
+    int answered = 0;
+    for (int i = 0; i < 3; ++i) {
+        network.publicAddress([&](const QHostAddress& address, const QString& error) {
+            QVERIFY(error.isEmpty());
+            QCOMPARE(address, QHostAddress(QHostAddress::LocalHost));
+            ++answered;
+        });
+    }
+    QTRY_COMPARE(answered, 3);
+    QCOMPARE(lookups(server), 1);
+}
+
+void TestNetworkMaintenance::testUpdateOnlyWhenAddressChanges()
+{
+    FakeHttpServer server;
+    NetworkMaintenance network;
+    network.setLookupUrl(QUrl(server.url("/ip")));
+    network.setUpdateUrl(server.url("/update?myip=%IP%"));
+    QSignalSpy updated(&network, &NetworkMaintenance::ddnsUpdated);
+    QSignalSpy changed(&network, &NetworkMaintenance::publicAddressChanged);
+
+    network.refresh();
+    QTRY_COMPARE(updated.count(), 1);
+    QVERIFY(updated.first().at(0).toBool());
+    QVERIFY(server.paths.contains("/update?myip=127.0.0.1"));
+    QCOMPARE(changed.count(), 1);
+
+    // Same address: looked up, but the provider is left alone
+    network.refresh();
+    QTRY_COMPARE(lookups(server), 2);
+    QTest::qWait(100);
+    QCOMPARE(updated.count(), 1);
+    QCOMPARE(changed.count(), 1);
+
+    server.body = "127.0.0.2\n";
+    server.updateBody = "good 127.0.0.2";
+    network.refresh();
+    QTRY_COMPARE(updated.count(), 2);
+    QVERIFY(server.paths.contains("/update?myip=127.0.0.2"));
+    QCOMPARE(changed.count(), 2);
+    QCOMPARE(network.cachedAddress(), QHostAddress("127.0.0.2"));
+}
+
+void TestNetworkMaintenance::testUpdateRefused()
+{
+    FakeHttpServer server;
+    server.updateBody = "badauth";
+    NetworkMaintenance network;
+    network.setLookupUrl(QUrl(server.url("/ip")));
+    network.setUpdateUrl(server.url("/update?myip=%IP%"));
+    QSignalSpy updated(&network, &NetworkMaintenance::ddnsUpdated);
+
+    network.refresh();
+    QTRY_COMPARE(updated.count(), 1);
+    QVERIFY(!updated.first().at(0).toBool());
+    QCOMPARE(updated.first().at(1).toString(), QString("badauth"));
+
+    // Not published, so the next lookup tries again
+    network.refresh();
+    QTRY_COMPARE(updated.count(), 2);
+}
+
+void TestNetworkMaintenance::testLookupFailure()
+{
+    FakeHttpServer server;
+    server.body = "<html>busy</html>";
+    NetworkMaintenance network;
+    network.setLookupUrl(QUrl(server.url("/ip")));
+    QSignalSpy errors(&network, &NetworkMaintenance::operationError);
+
+    QString error;
+    bool done = false;
+    network.publicAddress([&](const QHostAddress& address, const QString& message) {
+        QVERIFY(address.isNull());
+        error = message;
+        done = true;
+    });
+    QTRY_VERIFY(done);
+    QVERIFY(!error.isEmpty());
+    QCOMPARE(errors.count(), 1);
+    QVERIFY(network.cachedAddress().isNull());
+}
+
+void TestNetworkMaintenance::testProbePorts()
+{
+    FakeHttpServer server;
+    QTcpServer open;
+    QVERIFY(open.listen(QHostAddress::LocalHost));
+    QTcpServer closed;
+    QVERIFY(closed.listen(QHostAddress::LocalHost));
+    const quint16 closedPort = closed.serverPort();
+    closed.close();
+
+    NetworkMaintenance network;
+    network.setLookupUrl(QUrl(server.url("/ip")));
+
+    QList<NetworkMaintenance::PortResult> results;
+    bool done = false;
+    auto probe = [&](bool force) {
+        done = false;
+        network.probePorts(
+            {open.serverPort(), closedPort}, 2000,
+            [&](const QHostAddress& address, const QList<NetworkMaintenance::PortResult>& found,
+                const QString& error) {
+                QVERIFY(error.isEmpty());
+                QCOMPARE(address, QHostAddress(QHostAddress::LocalHost));
+                results = found;
+                done = true;
+            },
+            force);
+    };
+
+    probe(false);
+    QTRY_VERIFY(done);
+    QCOMPARE(results.size(), 2);
+    QCOMPARE(results[0].port, open.serverPort());
+    QVERIFY(results[0].probe.reachable);
+    QCOMPARE(results[1].port, closedPort);
+    QVERIFY(!results[1].probe.reachable);
+
+    // A fresh result is reused without probing; the port is gone, yet it says open
+    open.close();
+    probe(false);
+    QVERIFY(done);
+    QVERIFY(results[0].probe.reachable);
+
+    probe(true);
+    QTRY_VERIFY(done);
+    QVERIFY(!results[0].probe.reachable);
+    QCOMPARE(lookups(server), 1);
+}
+
+QTEST_MAIN(TestNetworkMaintenance)
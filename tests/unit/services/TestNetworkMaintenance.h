@@ -0,0 +1,30 @@
+#ifndef TESTNETWORKMAINTENANCE_H
+#define TESTNETWORKMAINTENANCE_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for NetworkMaintenance class
+ *
+ * Tests the public address and DDNS service including:
+ * - Caching of the looked-up address
+ * - Sharing one lookup between concurrent callers
+ * - Sending the DDNS update only when the address changes
+ * - Reporting a provider's refusal
+ * - Parallel, cached port probes
+ */
+class TestNetworkMaintenance : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testAddressIsCached();
+    void testConcurrentLookupsShareOneRequest();
+    void testUpdateOnlyWhenAddressChanges();
+    void testUpdateRefused();
+    void testLookupFailure();
+    void testProbePorts();
+};
+
+#endif // TESTNETWORKMAINTENANCE_H
@@ -0,0 +1,183 @@
+#include "TestNowPlayingMonitor.h"
+#include "../../../src/repositories/NowPlayingStatus.h"
+#include "../../../src/services/NowPlayingMonitor.h"
+#include <QFile>
+#include <QSignalSpy>
+#include <QSqlQuery>
+
+namespace {
+
+const char* CONNECTION_NAME = "test_now_playing_connection";
+const char* READ_ONLY_CONNECTION_NAME = "test_now_playing_read_only";
+
+NowPlayingStatus::Entry entryFor(const QString& path, const QStringList& upcoming = {})
+{
+    NowPlayingStatus::Entry entry;
+    entry.path = path;
+    entry.title = NowPlayingStatus::titleOf(path);
+    entry.startedAt = QDateTime(QDate(2026, 10, 1), QTime(12, 0));
+    entry.durationMs = 180000;
+    entry.upcoming = upcoming;
+    return entry;
+}
+
+} // namespace
+
+void TestNowPlayingMonitor::init()
+{
+    m_tempDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_tempDir->isValid());
+
+    m_database = QSqlDatabase::addDatabase("QSQLITE", CONNECTION_NAME);
+    m_database.setDatabaseName(databasePath());
+    QVERIFY(m_database.open());
+}
+
+void TestNowPlayingMonitor::cleanup()
+{
+    if (m_database.isOpen()) {
+        m_database.close();
+    }
+    m_database = QSqlDatabase();
+    QSqlDatabase::removeDatabase(CONNECTION_NAME);
+    m_tempDir.reset();
+}
+
+void TestNowPlayingMonitor::testWriteAndRead()
+{
+    NowPlayingStatus status(m_database);
+    bool ok = true;
+    QVERIFY(status.read(&ok).isEmpty());
+    QVERIFY(!ok);
+
+    QVERIFY(status.ensureTable());
+    QVERIFY(status.ensureTable());
+    QVERIFY(status.read(&ok).isEmpty());
+    QVERIFY(ok);
+
+    const NowPlayingStatus::Entry entry =
+        entryFor("/music/Artist - Song.ogg",
+                 {"/music/1.ogg", "/music/2.ogg", "/music/3.ogg", "/music/4.ogg",
+                  "/music/5.ogg", "/music/6.ogg"});
+    QVERIFY(status.write(entry));
+    NowPlayingStatus::Entry read = status.read(&ok);
+    QVERIFY(ok);
+    QCOMPARE(read.path, entry.path);
+    QCOMPARE(read.title, QString("Artist - Song"));
+    QCOMPARE(read.startedAt, entry.startedAt);
+    QCOMPARE(read.durationMs, qint64(180000));
+    QCOMPARE(read.upcoming, entry.upcoming.mid(0, NowPlayingStatus::UPCOMING_LIMIT));
+
+    // One row, replaced by each write
+    QVERIFY(status.write(NowPlayingStatus::Entry()));
+    read = status.read();
+    QVERIFY(read.isEmpty());
+    QVERIFY(!read.startedAt.isValid());
+    QCOMPARE(read.durationMs, qint64(-1));
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("SELECT COUNT(*) FROM now_playing") && query.next());
+    QCOMPARE(query.value(0).toInt(), 1);
+}
+
+void TestNowPlayingMonitor::testReadOnlyConnection()
+{
+    QVERIFY(NowPlayingStatus(m_database).ensureTable());
+    {
+        QString error;
+        QSqlDatabase readOnly =
+            NowPlayingMonitor::openReadOnly(READ_ONLY_CONNECTION_NAME, databasePath(), &error);
+        QVERIFY2(readOnly.isOpen(), qPrintable(error));
+
+        QSqlQuery query(readOnly);
+        QVERIFY(query.exec("PRAGMA query_only") && query.next());
+        QCOMPARE(query.value(0).toInt(), 1);
+        QVERIFY(!NowPlayingStatus(readOnly).write(entryFor("/music/a.ogg")));
+        QVERIFY(!query.exec("CREATE TEMP TABLE scratch (x)"));
+        QVERIFY(NowPlayingStatus(readOnly).read().isEmpty());
+        readOnly.close();
+    }
+    QSqlDatabase::removeDatabase(READ_ONLY_CONNECTION_NAME);
+
+    // A missing file is reported, not created
+    const QString missing = m_tempDir->filePath("missing.db");
+    {
+        QString error;
+        QSqlDatabase readOnly =
+            NowPlayingMonitor::openReadOnly(READ_ONLY_CONNECTION_NAME, missing, &error);
+        QVERIFY(!readOnly.isOpen());
+        QVERIFY(!error.isEmpty());
+    }
+    QSqlDatabase::removeDatabase(READ_ONLY_CONNECTION_NAME);
+    QVERIFY(!QFile::exists(missing));
+}
+
+void TestNowPlayingMonitor::testPollFollowsDataVersion()
+{
+    NowPlayingStatus status(m_database);
+    QVERIFY(status.ensureTable());
+    QVERIFY(status.write(entryFor("/music/a.ogg", {"/music/b.ogg"})));
+
+    NowPlayingMonitor monitor(databasePath());
+    QSignalSpy changed(&monitor, &NowPlayingMonitor::changed);
+    QVERIFY(monitor.start());
+    QVERIFY(monitor.isRunning());
+    QCOMPARE(changed.count(), 1);
+    QCOMPARE(monitor.current().path, QString("/music/a.ogg"));
+    QCOMPARE(changed.at(0).at(0).value<NowPlayingStatus::Entry>().upcoming,
+             QStringList({"/music/b.ogg"}));
+
+    // Nothing committed since: the row is not read again
+    QVERIFY(!monitor.poll());
+
+    QVERIFY(status.write(entryFor("/music/b.ogg")));
+    QVERIFY(monitor.poll());
+    QCOMPARE(monitor.current().path, QString("/music/b.ogg"));
+    QCOMPARE(changed.count(), 2);
+
+    // A commit that leaves the row as it was is not a change
+    QVERIFY(status.write(entryFor("/music/b.ogg")));
+    QVERIFY(!monitor.poll());
+    QCOMPARE(changed.count(), 2);
+
+    // The timer picks up the next write by itself
+    monitor.setInterval(20);
+    QVERIFY(status.write(NowPlayingStatus::Entry()));
+    QTRY_COMPARE(changed.count(), 3);
+    QVERIFY(monitor.current().isEmpty());
+
+    monitor.stop();
+    QVERIFY(!monitor.isRunning());
+}
+
+void TestNowPlayingMonitor::testMissingDatabase()
+{
+    const QString path = m_tempDir->filePath("later.db");
+    NowPlayingMonitor monitor(path);
+    QSignalSpy failed(&monitor, &NowPlayingMonitor::connectionFailed);
+    QSignalSpy changed(&monitor, &NowPlayingMonitor::changed);
+
+    QVERIFY(!monitor.start());
+    QVERIFY(!monitor.poll());
+    QCOMPARE(failed.count(), 1);
+    QVERIFY(!QFile::exists(path));
+
+    // The station comes up after the display
+    const QString writerName = "test_now_playing_writer";
+    {
+        QSqlDatabase writer = QSqlDatabase::addDatabase("QSQLITE", writerName);
+        writer.setDatabaseName(path);
+        QVERIFY(writer.open());
+        NowPlayingStatus status(writer);
+        QVERIFY(status.ensureTable());
+        QVERIFY(status.write(entryFor("/music/a.ogg")));
+        writer.close();
+    }
+    QSqlDatabase::removeDatabase(writerName);
+
+    QVERIFY(monitor.poll());
+    QCOMPARE(changed.count(), 1);
+    QCOMPARE(monitor.current().title, QString("a"));
+    monitor.stop();
+}
+
+QTEST_MAIN(TestNowPlayingMonitor)
@@ -0,0 +1,39 @@
+#ifndef TESTNOWPLAYINGMONITOR_H
+#define TESTNOWPLAYINGMONITOR_H
+
+#include <QObject>
+#include <QTest>
+#include <QSqlDatabase>
+#include <QTemporaryDir>
+#include <memory>
+
+/**
+ * @brief Unit tests for NowPlayingMonitor and NowPlayingStatus classes
+ *
+ * Tests the secondary display feed including:
+ * - Writing and reading the now_playing row, and the upcoming limit
+ * - Read-only connections refusing writes and not creating files
+ * - Reading the row only when the data version changed
+ * - Waiting for a database that does not exist yet
+ */
+class TestNowPlayingMonitor : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testWriteAndRead();
+    void testReadOnlyConnection();
+    void testPollFollowsDataVersion();
+    void testMissingDatabase();
+
+private:
+    QString databasePath() const { return m_tempDir->filePath("library.db"); }
+
+    std::unique_ptr<QTemporaryDir> m_tempDir;
+    QSqlDatabase m_database;
+};
+
+#endif // TESTNOWPLAYINGMONITOR_H
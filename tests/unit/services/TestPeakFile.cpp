@@ -0,0 +1,204 @@
+#include "TestPeakFile.h"
+#include "../../../src/services/PeakFile.h"
+#include "../../../src/services/PeakFileGenerator.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QSignalSpy>
+#include <QThread>
+#include <QVector>
+#include <atomic>
+
+namespace {
+
+// Seconds of a stereo ramp from -1 to 1 on the left and silence on the right
+QVector<float> ramp(double seconds)
+{
+    const qint64 frames = qint64(seconds * PeakFile::SAMPLE_RATE);
+    QVector<float> samples;
+    samples.reserve(frames * 2);
+    for (qint64 i = 0; i < frames; ++i) {
+        samples << float(-1.0 + 2.0 * i / frames) << 0.0f;
+    }
+    return samples;
+}
+
+QByteArray build(const QVector<float>& samples, int chunk)
+{
+    PeakFile::Builder builder(PeakFile::SAMPLE_RATE, 2);
+    for (qsizetype offset = 0; offset < samples.size(); offset += chunk) {
+        builder.feed(samples.constData() + offset, qMin<qsizetype>(chunk, samples.size() - offset));
+    }
+    return builder.data();
+}
+
+} // namespace
+
+void TestPeakFile::init()
+{
+    m_tempDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_tempDir->isValid());
+}
+
+void TestPeakFile::cleanup()
+{
+    m_tempDir.reset();
+}
+
+QString TestPeakFile::write(const QString& name, const QByteArray& data)
+{
+    const QString path = m_tempDir->filePath(name);
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size()) {
+        return QString();
+    }
+    return path;
+}
+
+void TestPeakFile::testBuckets()
+{
+    // 2.5 buckets of a spike on the right channel only
+    QVector<float> samples(PeakFile::BASE_FRAMES_PER_BUCKET * 5, 0.0f);
+    samples[10 * 2 + 1] = 0.5f;
+    samples[300 * 2 + 1] = -1.5f;
+
+    // Fed in odd chunks, so buckets straddle calls
+    const QByteArray data = build(samples, 94);
+    QCOMPARE(build(samples, samples.size()), data);
+
+    PeakFile peaks;
+    QVERIFY(peaks.open(write("spikes.peak", data)));
+    QCOMPARE(peaks.sampleRate(), PeakFile::SAMPLE_RATE);
+    QCOMPARE(peaks.frames(), qint64(PeakFile::BASE_FRAMES_PER_BUCKET * 5 / 2));
+    QCOMPARE(peaks.levelCount(), 1);
+    QCOMPARE(peaks.bucketCount(0), qint64(3));
+
+    const PeakFile::Bucket* buckets = peaks.buckets(0);
+    QCOMPARE(int(buckets[0].min), 0);
+    QCOMPARE(int(buckets[0].max), 64);   // Rounded outwards from 63.5
+    QCOMPARE(int(buckets[1].min), -127); // Clipped
+    QCOMPARE(int(buckets[1].max), 0);
+    QCOMPARE(int(buckets[2].min), 0);
+    QCOMPARE(int(buckets[2].max), 0);
+}
+
+void TestPeakFile::testLevels()
+{
+    const QVector<float> samples = ramp(60.0);
+    PeakFile peaks;
+    QVERIFY(peaks.open(write("ramp.peak", build(samples, 4096))));
+    QCOMPARE(peaks.durationMs(), qint64(60000));
+
+    // 11250 buckets at level 0, then each level a quarter, down to 256 or fewer
+    QCOMPARE(peaks.levelCount(), 4);
+    QCOMPARE(peaks.bucketCount(0), qint64(11250));
+    QCOMPARE(peaks.bucketCount(1), qint64(2813));
+    QCOMPARE(peaks.bucketCount(3), qint64(176));
+    QCOMPARE(peaks.framesPerBucket(3), qint64(PeakFile::BASE_FRAMES_PER_BUCKET * 64));
+
+    // Every level spans the whole ramp, from its first bucket to its last
+    for (int level = 0; level < peaks.levelCount(); ++level) {
+        const PeakFile::Bucket* buckets = peaks.buckets(level);
+        QCOMPARE(int(buckets[0].min), -127);
+        QCOMPARE(int(buckets[peaks.bucketCount(level) - 1].max), 127);
+        QVERIFY(buckets[0].max < 0);
+    }
+
+    QCOMPARE(peaks.levelFor(1.0), 0);
+    QCOMPARE(peaks.levelFor(peaks.frames() / 1000.0), 1);
+    QCOMPARE(peaks.levelFor(peaks.frames() / 100.0), 3);
+}
+
+void TestPeakFile::testRejectsInvalidFiles()
+{
+    const QByteArray valid = build(ramp(1.0), 4096);
+    PeakFile peaks;
+    QVERIFY(peaks.open(write("valid.peak", valid)));
+
+    QVERIFY(!peaks.open(write("short.peak", valid.left(valid.size() - 1))));
+    QVERIFY(!peaks.isOpen());
+    QVERIFY(!peaks.open(write("long.peak", valid + "x")));
+
+    QByteArray version = valid;
+    version[4] = 9;
+    QVERIFY(!peaks.open(write("version.peak", version)));
+    QVERIFY(!peaks.open(write("text.peak", "not a peak file at all, but long enough")));
+    QVERIFY(!peaks.open(m_tempDir->filePath("missing.peak")));
+}
+
+void TestPeakFile::testGenerator()
+{
+    const QString good = write("good.ogg", "audio");
+    const QString broken = write("broken.ogg", "audio");
+    std::atomic<int> decoded{0};
+
+    PeakFileGenerator generator(m_tempDir->filePath("peaks"));
+    generator.setGenerator([&decoded](const QString& audioPath, const QString& peakPath,
+                                      QString* error) {
+        ++decoded;
+        if (audioPath.contains("broken")) {
+            *error = "Invalid data";
+            return false;
+        }
+        QFile file(peakPath);
+        return file.open(QIODevice::WriteOnly) && file.write("peaks") == 5;
+    });
+    QVERIFY(QDir().mkpath(generator.cacheDirectory()));
+    QCOMPARE(generator.peakPath(good), generator.peakPath(good));
+    QVERIFY(generator.peakPath(good) != generator.peakPath(broken));
+    QVERIFY(!generator.isCurrent(good));
+
+    QSignalSpy ready(&generator, &PeakFileGenerator::peaksReady);
+    QSignalSpy finished(&generator, &PeakFileGenerator::finished);
+    QCOMPARE(generator.generate({good, broken, good}), 2);
+    QVERIFY(finished.wait(5000));
+    QCOMPARE(finished.first().at(0).toInt(), 1);
+    QCOMPARE(finished.first().at(1).toInt(), 1);
+    QCOMPARE(ready.count(), 1);
+    QCOMPARE(ready.first().at(1).toString(), generator.peakPath(good));
+    QVERIFY(generator.isCurrent(good));
+
+    // A current peak file is reported without decoding again
+    finished.clear();
+    QCOMPARE(generator.generate({good}), 1);
+    QVERIFY(finished.wait(5000));
+    QCOMPARE(finished.first().at(0).toInt(), 0);
+    QCOMPARE(ready.count(), 2);
+    QCOMPARE(decoded.load(), 2);
+}
+
+void TestPeakFile::testUrgentTracksGoFirst()
+{
+    QMutex mutex;
+    QStringList order;
+    PeakFileGenerator generator(m_tempDir->path());
+    generator.setMaxWorkers(1);
+    generator.setGenerator([&](const QString& audioPath, const QString&, QString* error) {
+        QThread::msleep(20);
+        QMutexLocker locker(&mutex);
+        order << QFileInfo(audioPath).fileName();
+        *error = "Not decoded";
+        return false;
+    });
+    QSignalSpy progress(&generator, &PeakFileGenerator::progressChanged);
+    QSignalSpy finished(&generator, &PeakFileGenerator::finished);
+
+    QStringList queued;
+    for (int i = 0; i < 5; ++i) {
+        queued << m_tempDir->filePath(QString("%1.ogg").arg(i));
+    }
+    QCOMPARE(generator.generate(queued), 5);
+    // Already waiting: moved to the front and not counted again
+    QCOMPARE(generator.generate({queued.at(4)}, true), 0);
+    QCOMPARE(generator.generate({m_tempDir->filePath("on-air.ogg")}, true), 1);
+
+    QVERIFY(finished.wait(5000));
+    QCOMPARE(finished.first().at(1).toInt(), 6);
+    QCOMPARE(progress.last().at(1).toInt(), 6);
+    QVERIFY(!generator.isRunning());
+    // The first track was already being decoded
+    QCOMPARE(order, QStringList({"0.ogg", "on-air.ogg", "4.ogg", "1.ogg", "2.ogg", "3.ogg"}));
+}
+
+QTEST_MAIN(TestPeakFile)
@@ -0,0 +1,38 @@
+#ifndef TESTPEAKFILE_H
+#define TESTPEAKFILE_H
+
+#include <QObject>
+#include <QTest>
+#include <QTemporaryDir>
+#include <memory>
+
+/**
+ * @brief Unit tests for PeakFile and PeakFileGenerator classes
+ *
+ * Tests the waveform overviews including:
+ * - The min/max of each bucket, across channels and feed() calls
+ * - The levels of the pyramid and picking one for a width
+ * - Refusing files that are not valid peak files
+ * - Generating in the background, skipping current files and urgent tracks
+ */
+class TestPeakFile : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testBuckets();
+    void testLevels();
+    void testRejectsInvalidFiles();
+    void testGenerator();
+    void testUrgentTracksGoFirst();
+
+private:
+    QString write(const QString& name, const QByteArray& data);
+
+    std::unique_ptr<QTemporaryDir> m_tempDir;
+};
+
+#endif // TESTPEAKFILE_H
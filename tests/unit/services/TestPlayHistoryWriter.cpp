@@ -0,0 +1,209 @@
+#include "TestPlayHistoryWriter.h"
+#include "../../../src/services/PlayHistoryWriter.h"
+#include "../../../src/repositories/PlayHistory.h"
+#include "../../../src/repositories/ProofOfPlay.h"
+#include "../../../src/repositories/TrackRanking.h"
+#include <QFile>
+#include <QSignalSpy>
+#include <QSqlQuery>
+
+namespace {
+
+const char* CONNECTION_NAME = "test_play_history_connection";
+
+} // namespace
+
+void TestPlayHistoryWriter::init()
+{
+    m_tempDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_tempDir->isValid());
+
+    m_database = QSqlDatabase::addDatabase("QSQLITE", CONNECTION_NAME);
+    m_database.setDatabaseName(m_tempDir->path() + "/history.db");
+    QVERIFY(m_database.open());
+
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("CREATE TABLE musics (id INTEGER PRIMARY KEY AUTOINCREMENT, artist TEXT, "
+                       "song TEXT, genre1 TEXT, genre2 TEXT, country TEXT, published_date TEXT, "
+                       "path TEXT, time TEXT, played_times INTEGER DEFAULT 0, last_played TEXT)"));
+    QVERIFY(query.exec("INSERT INTO musics (artist, song, path) VALUES "
+                       "('Artist A', 'Song 1', '/music/one.ogg'), "
+                       "('Artist B', 'Song 2', '/music/two.ogg')"));
+}
+
+void TestPlayHistoryWriter::cleanup()
+{
+    if (m_database.isOpen()) {
+        m_database.close();
+    }
+    m_database = QSqlDatabase();
+    QSqlDatabase::removeDatabase(CONNECTION_NAME);
+    m_tempDir.reset();
+}
+
+void TestPlayHistoryWriter::testEventsAreDeferred()
+{
+    PlayHistoryWriter writer(m_database);
+    writer.recordPlay("/music/one.ogg");
+
+    QCOMPARE(writer.pendingCount(), 1);
+    QCOMPARE(playedTimes("/music/one.ogg"), 0);
+}
+
+void TestPlayHistoryWriter::testFlushUpdatesPlayCounts()
+{
+    PlayHistoryWriter writer(m_database);
+    const QDateTime playedAt(QDate(2024, 5, 17), QTime(14, 30, 5));
+
+    writer.recordPlay("/music/one.ogg", playedAt.addSecs(-600));
+    writer.recordPlay("/music/two.ogg", playedAt.addSecs(-300));
+    writer.recordPlay("/music/one.ogg", playedAt);
+
+    QCOMPARE(writer.flush(), 3);
+    QCOMPARE(writer.pendingCount(), 0);
+    QCOMPARE(playedTimes("/music/one.ogg"), 2);
+    QCOMPARE(playedTimes("/music/two.ogg"), 1);
+    QCOMPARE(lastPlayed("/music/one.ogg"), QString("2024-05-17 || 14:30:05"));
+}
+
+void TestPlayHistoryWriter::testUnknownPathIsSkipped()
+{
+    PlayHistoryWriter writer(m_database);
+    writer.recordPlay("/jingles/station-id.ogg");
+    writer.recordPlay("/music/two.ogg");
+
+    QCOMPARE(writer.flush(), 1);
+    QCOMPARE(writer.pendingCount(), 0);
+    QCOMPARE(playedTimes("/music/two.ogg"), 1);
+}
+
+void TestPlayHistoryWriter::testFlushWhenQueueIsFull()
+{
+    PlayHistoryWriter writer(m_database);
+    for (int i = 0; i < PlayHistoryWriter::MAX_PENDING; ++i) {
+        writer.recordPlay("/music/one.ogg");
+    }
+
+    QCOMPARE(writer.pendingCount(), 0);
+    QCOMPARE(playedTimes("/music/one.ogg"), PlayHistoryWriter::MAX_PENDING);
+}
+
+void TestPlayHistoryWriter::testDestructorFlushes()
+{
+    {
+        PlayHistoryWriter writer(m_database);
+        writer.recordPlay("/music/two.ogg");
+    }
+
+    QCOMPARE(playedTimes("/music/two.ogg"), 1);
+}
+
+void TestPlayHistoryWriter::testPlaysAreLogged()
+{
+    const QDateTime playedAt(QDate(2024, 5, 31), QTime(23, 58));
+    {
+        PlayHistoryWriter writer(m_database);
+        QCOMPARE(writer.historyDirectory(), m_tempDir->path() + "/history");
+        writer.recordPlay("/music/one.ogg", playedAt);
+        writer.recordPlay("/jingles/station-id.ogg", playedAt.addSecs(60));
+        writer.recordPlay("/music/two.ogg", playedAt.addSecs(120));
+        QCOMPARE(writer.flush(), 2);
+    }
+
+    PlayHistory history(m_database);
+    QCOMPARE(history.months(), QStringList({"2024-05", "2024-06"}));
+    const QList<PlayHistory::Play> plays = history.plays(playedAt, playedAt.addDays(1));
+    QCOMPARE(plays.size(), 3);
+    QCOMPARE(plays[0].song, QString("Song 1"));
+    QCOMPARE(plays[1].path, QString("/jingles/station-id.ogg"));
+    QCOMPARE(history.monthlySummary("2024-06").size(), 1);
+}
+
+void TestPlayHistoryWriter::testCountsWithoutHistory()
+{
+    // A file where the history directory should be
+    const QString blocked = m_tempDir->path() + "/blocked";
+    QFile file(blocked);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.close();
+
+    PlayHistoryWriter writer(m_database);
+    writer.setHistoryDirectory(blocked);
+    QSignalSpy errors(&writer, &PlayHistoryWriter::operationError);
+    writer.recordPlay("/music/one.ogg");
+    writer.recordPlay("/music/two.ogg");
+
+    QCOMPARE(writer.flush(), 2);
+    QCOMPARE(writer.pendingCount(), 0);
+    QCOMPARE(playedTimes("/music/one.ogg"), 1);
+    QCOMPARE(errors.count(), 1);
+}
+
+void TestPlayHistoryWriter::testRankScoresAreRefreshed()
+{
+    QVERIFY(TrackRanking(m_database).ensure());
+    const QDateTime playedAt(QDate(2024, 5, 17), QTime(14, 30, 5));
+
+    PlayHistoryWriter writer(m_database);
+    writer.recordPlay("/music/one.ogg", playedAt);
+    writer.recordPlay("/music/one.ogg", playedAt);
+    QCOMPARE(writer.flush(), 2);
+
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("SELECT path, rank_score FROM musics ORDER BY id"));
+    QVERIFY(query.next());
+    QCOMPARE(query.value(1).toDouble(),
+             TrackRanking::score(2, "2024-05-17 || 14:30:05").toDouble());
+    QVERIFY(query.next());
+    QVERIFY(query.value(1).isNull());
+}
+
+void TestPlayHistoryWriter::testAiringsAreProven()
+{
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("CREATE TABLE pub (id INTEGER PRIMARY KEY AUTOINCREMENT, name TEXT, "
+                       "path TEXT, customer TEXT)"));
+    QVERIFY(query.exec("INSERT INTO pub (name, path, customer) "
+                       "VALUES ('Spring sale', '/pubs/bakery.mp3', 'Bakery')"));
+    const QDateTime scheduled(QDate(2024, 5, 17), QTime(14, 0));
+
+    PlayHistoryWriter writer(m_database);
+    writer.expectAiring({ProofOfPlay::Kind::Pub, 1, "/pubs/bakery.mp3", scheduled});
+    QCOMPARE(writer.expectedCount(), 1);
+    QVERIFY(!writer.recordAiring("/music/one.ogg", scheduled, 180000));
+    QVERIFY(writer.recordAiring("/pubs/bakery.mp3", scheduled.addSecs(3), 30000));
+    QCOMPARE(writer.expectedCount(), 0);
+    QCOMPARE(writer.pendingCount(), 1);
+    QCOMPARE(writer.flush(), 0);
+    QCOMPARE(writer.pendingCount(), 0);
+
+    const QList<ProofOfPlay::CampaignEntry> summary =
+        ProofOfPlay(m_database).campaignSummary("2024-05");
+    QCOMPARE(summary.size(), 1);
+    QCOMPARE(summary[0].campaign, QString("Bakery"));
+    QCOMPARE(summary[0].airedMs, qint64(30000));
+    QCOMPARE(summary[0].lateMs, qint64(3000));
+
+    // An item that never aired is forgotten after a day
+    writer.expectAiring({ProofOfPlay::Kind::Pub, 1, "/pubs/bakery.mp3", scheduled});
+    writer.expectAiring({ProofOfPlay::Kind::Pub, 1, "/pubs/bakery.mp3", scheduled.addDays(2)});
+    QCOMPARE(writer.expectedCount(), 1);
+}
+
+int TestPlayHistoryWriter::playedTimes(const QString& path)
+{
+    QSqlQuery query(m_database);
+    query.prepare("SELECT played_times FROM musics WHERE path = ?");
+    query.addBindValue(path);
+    return query.exec() && query.next() ? query.value(0).toInt() : -1;
+}
+
+QString TestPlayHistoryWriter::lastPlayed(const QString& path)
+{
+    QSqlQuery query(m_database);
+    query.prepare("SELECT last_played FROM musics WHERE path = ?");
+    query.addBindValue(path);
+    return query.exec() && query.next() ? query.value(0).toString() : QString();
+}
+
+QTEST_MAIN(TestPlayHistoryWriter)
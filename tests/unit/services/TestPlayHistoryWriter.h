@@ -0,0 +1,49 @@
+#ifndef TESTPLAYHISTORYWRITER_H
+#define TESTPLAYHISTORYWRITER_H
+
+#include <QObject>
+#include <QTest>
+#include <QSqlDatabase>
+#include <QTemporaryDir>
+#include <memory>
+
+/**
+ * @brief Unit tests for PlayHistoryWriter class
+ *
+ * Tests the deferred play count writer including:
+ * - Events staying queued until flushed
+ * - Batched play count and last_played updates
+ * - Skipping paths that are not in the library
+ * - Flushing on size limit and on destruction
+ * - Logging every play, library or not, to the play history
+ * - Committing the play counts when the play history cannot be written
+ * - Refreshing the rank scores of the tracks played
+ * - Proof of play for the scheduled items that aired
+ */
+class TestPlayHistoryWriter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testEventsAreDeferred();
+    void testFlushUpdatesPlayCounts();
+    void testUnknownPathIsSkipped();
+    void testFlushWhenQueueIsFull();
+    void testDestructorFlushes();
+    void testPlaysAreLogged();
+    void testCountsWithoutHistory();
+    void testRankScoresAreRefreshed();
+    void testAiringsAreProven();
+
+private:
+    int playedTimes(const QString& path);
+    QString lastPlayed(const QString& path);
+
+    std::unique_ptr<QTemporaryDir> m_tempDir;
+    QSqlDatabase m_database;
+};
+
+#endif // TESTPLAYHISTORYWRITER_H
@@ -0,0 +1,81 @@
+#include "TestPlaybackClock.h"
+#include "../../../src/services/PlaybackClock.h"
+#include <QSignalSpy>
+
+void TestPlaybackClock::testFormats()
+{
+    QChar text[24];
+    QCOMPARE(QString(text, PlaybackClock::formatClock(0, text)), QString("00:00:00"));
+    QCOMPARE(QString(text, PlaybackClock::formatClock(3725, text)), QString("01:02:05"));
+    QCOMPARE(QString(text, PlaybackClock::formatClock(360000, text)), QString("100:00:00"));
+    QCOMPARE(QString(text, PlaybackClock::formatClock(-5, text)), QString("00:00:00"));
+
+    QCOMPARE(PlaybackClock::formatSpoken(225000), QString("3:45"));
+    QCOMPARE(PlaybackClock::formatSpoken(5025000), QString("1:23:45"));
+    QCOMPARE(PlaybackClock::formatSpoken(-1), QString("0:00"));
+}
+
+void TestPlaybackClock::testTicksCoalesce()
+{
+    PlaybackClock clock;
+    QSignalSpy positions(&clock, &PlaybackClock::positionChanged);
+
+    for (qint64 position = 0; position <= 90; position += 10) {
+        clock.setPosition(position);
+    }
+    QTRY_COMPARE(positions.count(), 1);
+    QCOMPARE(positions.at(0).at(0).toLongLong(), qint64(90));
+    QCOMPARE(clock.time().positionMs, qint64(90));
+}
+
+void TestPlaybackClock::testTimeFollowsWholeSeconds()
+{
+    PlaybackClock clock;
+    clock.setDuration(200000);
+    QSignalSpy times(&clock, &PlaybackClock::timeChanged);
+    QSignalSpy positions(&clock, &PlaybackClock::positionChanged);
+
+    clock.setPosition(41200);
+    QTRY_COMPARE(times.count(), 1);
+    QCOMPARE(clock.time().elapsed, QString("00:00:41"));
+    QCOMPARE(clock.time().duration, QString("00:03:20"));
+    QCOMPARE(clock.time().spokenRemaining, QString("2:38"));
+
+    // Within the same second only the position moves
+    clock.setPosition(41700);
+    QTRY_COMPARE(positions.count(), 2);
+    QCOMPARE(times.count(), 1);
+
+    clock.setPosition(42100);
+    QTRY_COMPARE(times.count(), 2);
+    QCOMPARE(clock.time().elapsed, QString("00:00:42"));
+}
+
+void TestPlaybackClock::testDurationRepublishes()
+{
+    PlaybackClock clock;
+    clock.setPosition(5000);
+    QSignalSpy times(&clock, &PlaybackClock::timeChanged);
+    QTRY_COMPARE(times.count(), 1);
+
+    clock.setDuration(60000);
+    QTRY_COMPARE(times.count(), 2);
+    QCOMPARE(clock.time().spokenDuration, QString("1:00"));
+    QCOMPARE(clock.time().spokenRemaining, QString("0:55"));
+}
+
+void TestPlaybackClock::testStillPositionIsQuiet()
+{
+    PlaybackClock clock;
+    QSignalSpy positions(&clock, &PlaybackClock::positionChanged);
+    clock.setPosition(1000);
+    QTRY_COMPARE(positions.count(), 1);
+
+    // A paused engine keeps reporting the same position
+    clock.setPosition(1000);
+    clock.setPosition(1000);
+    QTest::qWait(3 * PlaybackClock::PUBLISH_INTERVAL_MS);
+    QCOMPARE(positions.count(), 1);
+}
+
+QTEST_MAIN(TestPlaybackClock)
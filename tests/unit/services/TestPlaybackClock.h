@@ -0,0 +1,28 @@
+#ifndef TESTPLAYBACKCLOCK_H
+#define TESTPLAYBACKCLOCK_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for PlaybackClock class
+ *
+ * Tests the shared playback position including:
+ * - The clock and spoken time formats
+ * - A burst of ticks published as one position
+ * - Time strings rebuilt only when the second or the duration changes
+ * - Nothing published while the position stands still
+ */
+class TestPlaybackClock : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testFormats();
+    void testTicksCoalesce();
+    void testTimeFollowsWholeSeconds();
+    void testDurationRepublishes();
+    void testStillPositionIsQuiet();
+};
+
+#endif // TESTPLAYBACKCLOCK_H
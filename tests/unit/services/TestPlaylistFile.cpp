@@ -0,0 +1,124 @@
+#include "TestPlaylistFile.h"
+#include "../../../src/services/PlaylistFile.h"
+#include <QFile>
+#include <QTemporaryDir>
+
+namespace {
+
+void writeFile(const QString& fileName, const QByteArray& contents)
+{
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(contents);
+}
+
+} // namespace
+
+void TestPlaylistFile::testM3uRoundTrip()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.filePath("morning.m3u8");
+
+    const std::vector<PlaylistFile::Track> tracks = {
+        {"/music/Intro, part 1.ogg", 42, 183456000},
+        {"/music/Çà et là.mp3", -1, -1},
+        {"/music/jingle.wav", 7, 4000000},
+    };
+    QString error;
+    QVERIFY2(PlaylistFile::save(fileName, tracks, &error), qPrintable(error));
+
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QByteArray contents = file.readAll();
+    QVERIFY(contents.startsWith("#EXTM3U\n"));
+    QVERIFY(contents.contains("#EXTINF:183,Intro, part 1\n"));
+    QVERIFY(contents.contains("#XFB-TRACK:id=42,duration-us=183456000\n"));
+
+    const std::vector<PlaylistFile::Track> loaded = PlaylistFile::load(fileName, &error);
+    QVERIFY(error.isEmpty());
+    QCOMPARE(loaded.size(), tracks.size());
+    for (size_t i = 0; i < tracks.size(); ++i) {
+        QCOMPARE(loaded[i].path, tracks[i].path);
+        QCOMPARE(loaded[i].musicId, tracks[i].musicId);
+        QCOMPARE(loaded[i].durationUs, tracks[i].durationUs);
+    }
+}
+
+void TestPlaylistFile::testPlainM3u()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.filePath("other.m3u");
+    writeFile(fileName, "\xEF\xBB\xBF#EXTM3U\r\n"
+                        "#EXTINF:95,Artist - Title\r\n"
+                        "songs/one.mp3\r\n"
+                        "\r\n"
+                        "/abs/two.flac\r\n");
+
+    QString error;
+    const std::vector<PlaylistFile::Track> loaded = PlaylistFile::load(fileName, &error);
+    QVERIFY(error.isEmpty());
+    QCOMPARE(loaded.size(), size_t(2));
+    QCOMPARE(loaded[0].path, dir.filePath("songs/one.mp3"));
+    QCOMPARE(loaded[0].durationUs, qint64(95) * 1000000);
+    QCOMPARE(loaded[0].musicId, qint64(-1));
+    QCOMPARE(loaded[1].path, QString("/abs/two.flac"));
+    QCOMPARE(loaded[1].durationUs, qint64(-1));
+}
+
+void TestPlaylistFile::testLegacyXml()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.filePath("old.xml");
+    writeFile(fileName, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                        "<XFBPlaylist>\n"
+                        "    <www.netpack.pt>\n"
+                        "        <track>/music/a.ogg</track>\n"
+                        "        <track>/music/b &amp; c.ogg</track>\n"
+                        "    </www.netpack.pt>\n"
+                        "</XFBPlaylist>\n");
+
+    QString error;
+    std::vector<PlaylistFile::Track> loaded = PlaylistFile::load(fileName, &error);
+    QVERIFY(error.isEmpty());
+    QCOMPARE(loaded.size(), size_t(2));
+    QCOMPARE(loaded[1].path, QString("/music/b & c.ogg"));
+    QCOMPARE(loaded[1].durationUs, qint64(-1));
+
+    // Saving as .xml still writes what earlier versions read
+    const QString copy = dir.filePath("copy.xml");
+    QCOMPARE(PlaylistFile::formatFor(copy), PlaylistFile::Format::Xml);
+    QVERIFY(PlaylistFile::save(copy, loaded, &error));
+    loaded = PlaylistFile::load(copy, &error);
+    QCOMPARE(loaded.size(), size_t(2));
+    QCOMPARE(loaded[0].path, QString("/music/a.ogg"));
+}
+
+void TestPlaylistFile::testErrors()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    QString error;
+    QVERIFY(PlaylistFile::load(dir.filePath("missing.m3u8"), &error).empty());
+    QVERIFY(!error.isEmpty());
+
+    const QString notPlaylist = dir.filePath("page.xml");
+    writeFile(notPlaylist, "<html><body>hello</body></html>");
+    error.clear();
+    QVERIFY(PlaylistFile::load(notPlaylist, &error).empty());
+    QVERIFY(!error.isEmpty());
+
+    // Tracks before a broken element are kept
+    const QString truncated = dir.filePath("truncated.xml");
+    writeFile(truncated, "<XFBPlaylist><www.netpack.pt><track>/music/a.ogg</track><track>/mu");
+    error.clear();
+    QCOMPARE(PlaylistFile::load(truncated, &error).size(), size_t(1));
+    QVERIFY(!error.isEmpty());
+
+    QVERIFY(!PlaylistFile::save(dir.filePath("no/such/dir/list.m3u8"), {}, &error));
+}
+
+QTEST_MAIN(TestPlaylistFile)
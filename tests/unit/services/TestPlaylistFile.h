@@ -0,0 +1,27 @@
+#ifndef TESTPLAYLISTFILE_H
+#define TESTPLAYLISTFILE_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for PlaylistFile class
+ *
+ * Tests saved playlists including:
+ * - Ids and durations kept through an M3U8 round trip
+ * - Plain M3U from other players, with relative paths
+ * - XML playlists of earlier versions
+ * - Files that are not playlists
+ */
+class TestPlaylistFile : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testM3uRoundTrip();
+    void testPlainM3u();
+    void testLegacyXml();
+    void testErrors();
+};
+
+#endif // TESTPLAYLISTFILE_H
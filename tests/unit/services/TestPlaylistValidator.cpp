@@ -0,0 +1,169 @@
+#include "TestPlaylistValidator.h"
+#include "../../../src/models/PlaylistQueueModel.h"
+#include "../../../src/services/PlaylistValidator.h"
+#include <QFile>
+#include <QSignalSpy>
+#include <QtEndian>
+
+namespace {
+
+void appendLE16(QByteArray& data, quint16 value)
+{
+    char buf[2];
+    qToLittleEndian(value, buf);
+    data.append(buf, 2);
+}
+
+void appendLE32(QByteArray& data, quint32 value)
+{
+    char buf[4];
+    qToLittleEndian(value, buf);
+    data.append(buf, 4);
+}
+
+QString problemAt(const PlaylistQueueModel& queue, int row)
+{
+    return queue.data(queue.index(row), PlaylistQueueModel::ProblemRole).toString();
+}
+
+} // namespace
+
+void TestPlaylistValidator::init()
+{
+    m_tempDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_tempDir->isValid());
+}
+
+void TestPlaylistValidator::cleanup()
+{
+    m_tempDir.reset();
+}
+
+QString TestPlaylistValidator::writeFile(const QString& name, const QByteArray& contents)
+{
+    const QString filePath = m_tempDir->filePath(name);
+    QFile file(filePath);
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(contents);
+    }
+    return filePath;
+}
+
+QString TestPlaylistValidator::writeWav(const QString& name)
+{
+    // A tenth of a second of 8 kHz 8-bit mono PCM
+    const quint32 dataSize = 800;
+
+    QByteArray wav;
+    wav.append("RIFF");
+    appendLE32(wav, 36 + dataSize);
+    wav.append("WAVE");
+    wav.append("fmt ");
+    appendLE32(wav, 16);
+    appendLE16(wav, 1);      // PCM
+    appendLE16(wav, 1);      // channels
+    appendLE32(wav, 8000);   // sample rate
+    appendLE32(wav, 8000);   // byte rate
+    appendLE16(wav, 1);      // block align
+    appendLE16(wav, 8);      // bits per sample
+    wav.append("data");
+    appendLE32(wav, dataSize);
+    wav.append(QByteArray(dataSize, char(0x80)));
+    return writeFile(name, wav);
+}
+
+void TestPlaylistValidator::testCheck()
+{
+    using Problem = PlaylistValidator::Problem;
+
+    QCOMPARE(PlaylistValidator::check(writeWav("good.wav")).problem, Problem::None);
+    QCOMPARE(PlaylistValidator::check(m_tempDir->filePath("gone.wav")).problem,
+             Problem::Missing);
+    QCOMPARE(PlaylistValidator::check(writeFile("empty.ogg", QByteArray())).problem,
+             Problem::Empty);
+
+    const PlaylistValidator::Result broken =
+        PlaylistValidator::check(writeFile("broken.wav", QByteArray("RIFF\x04\0\0\0WAVE", 12)));
+    QCOMPARE(broken.problem, Problem::BadHeader);
+    QVERIFY(!broken.detail.isEmpty());
+
+    // Formats the probe does not know are left to the deck
+    QCOMPARE(PlaylistValidator::check(writeFile("voice.wma", "0&\xB2\x75 not probed")).problem,
+             Problem::None);
+
+    QVERIFY(PlaylistValidator::describe(Problem::None).isEmpty());
+    QVERIFY(PlaylistValidator::describe(Problem::Missing, "x").endsWith(": x"));
+}
+
+void TestPlaylistValidator::testReplacesBrokenEntries()
+{
+    const QString good = writeWav("good.wav");
+    const QString spare = writeWav("spare.wav");
+    const QString gone = m_tempDir->filePath("gone.wav");
+    const QString jingle = m_tempDir->filePath("jingle.wav");
+
+    PlaylistQueueModel queue;
+    PlaylistValidator validator(&queue);
+    // The first pick is the broken file itself, which is passed over
+    QStringList picks = {gone, spare};
+    int pickCalls = 0;
+    validator.setReplacementPicker([&](const PlaylistQueueModel::Entry& entry) {
+        ++pickCalls;
+        // Only library tracks have a genre to pick from
+        if (entry.musicId < 0 || picks.isEmpty()) {
+            return QString();
+        }
+        return picks.takeFirst();
+    });
+    QSignalSpy problemSpy(&validator, &PlaylistValidator::problemFound);
+    QSignalSpy replacedSpy(&validator, &PlaylistValidator::replaced);
+
+    std::vector<PlaylistQueueModel::Entry> entries(3);
+    entries[0].path = good;
+    entries[1].path = gone;
+    entries[1].musicId = 12;
+    entries[2].path = jingle;
+    queue.append(std::move(entries));
+
+    QTRY_COMPARE(queue.path(1), spare);
+    QCOMPARE(replacedSpy.count(), 1);
+    QCOMPARE(replacedSpy.first().at(0).toInt(), 1);
+    QCOMPARE(replacedSpy.first().at(1).toString(), gone);
+    QVERIFY(problemAt(queue, 1).isEmpty());
+
+    QTRY_VERIFY(!problemAt(queue, 2).isEmpty());
+    QCOMPARE(queue.path(2), jingle);
+    QVERIFY(problemAt(queue, 0).isEmpty());
+    QTRY_VERIFY(!validator.isBusy());
+    QCOMPARE(problemSpy.count(), 2);
+
+    // A marked entry is not offered to the picker again
+    const int callsBefore = pickCalls;
+    validator.validate();
+    QTest::qWait(50);
+    QCOMPARE(pickCalls, callsBefore);
+}
+
+void TestPlaylistValidator::testLookaheadAndRecheck()
+{
+    const QString good = writeWav("good.wav");
+    const QString late = m_tempDir->filePath("late.wav");
+
+    PlaylistQueueModel queue;
+    PlaylistValidator validator(&queue);
+    validator.setLookahead(2);
+    validator.setRecheckInterval(1000);
+    QSignalSpy problemSpy(&validator, &PlaylistValidator::problemFound);
+
+    queue.append(QStringList({good, late, m_tempDir->filePath("far.wav")}));
+    QTRY_VERIFY(!problemAt(queue, 1).isEmpty());
+    QVERIFY(problemAt(queue, 2).isEmpty());
+    QCOMPARE(problemSpy.count(), 1);
+
+    // The file turns up before its turn; the next check clears the mark
+    writeWav("late.wav");
+    QTRY_VERIFY_WITH_TIMEOUT(problemAt(queue, 1).isEmpty(), 5000);
+    QCOMPARE(queue.path(1), late);
+}
+
+QTEST_MAIN(TestPlaylistValidator)
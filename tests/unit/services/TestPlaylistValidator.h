@@ -0,0 +1,37 @@
+#ifndef TESTPLAYLISTVALIDATOR_H
+#define TESTPLAYLISTVALIDATOR_H
+
+#include <QObject>
+#include <QTemporaryDir>
+#include <QTest>
+#include <memory>
+
+/**
+ * @brief Unit tests for PlaylistValidator class
+ *
+ * Tests checking the next entries of the queue including:
+ * - Missing, empty, unopenable and undecodable files
+ * - Broken entries swapped for the pick of the replacement picker
+ * - Entries without a replacement left in the queue, marked
+ * - Entries past the lookahead left alone, and files that come back
+ */
+class TestPlaylistValidator : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testCheck();
+    void testReplacesBrokenEntries();
+    void testLookaheadAndRecheck();
+
+private:
+    QString writeFile(const QString& name, const QByteArray& contents);
+    QString writeWav(const QString& name);
+
+    std::unique_ptr<QTemporaryDir> m_tempDir;
+};
+
+#endif // TESTPLAYLISTVALIDATOR_H
@@ -0,0 +1,151 @@
+#include "TestProcessSupervisor.h"
+#include "../../../src/services/ProcessSupervisor.h"
+#include <QFile>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+
+namespace {
+
+bool waitForState(ProcessSupervisor& supervisor, const QString& name, ProcessSupervisor::State state)
+{
+    return QTest::qWaitFor([&]() { return supervisor.state(name) == state; }, 5000);
+}
+
+/// Whether a process exists and has not exited; a zombie counts as gone
+bool isAlive(qint64 pid)
+{
+    QFile stat(QString("/proc/%1/stat").arg(pid));
+    if (!stat.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const QByteArray line = stat.readAll();
+    const qsizetype end = line.lastIndexOf(')');
+    return end > 0 && line.mid(end + 2, 1) != "Z";
+}
+
+} // namespace
+
+void TestProcessSupervisor::testStartAndStop()
+{
+    ProcessSupervisor supervisor;
+    supervisor.addProcess("sleeper", "/bin/sh", {"-c", "sleep 30"});
+    QVERIFY(supervisor.hasProcess("sleeper"));
+    QCOMPARE(supervisor.state("sleeper"), ProcessSupervisor::State::Stopped);
+
+    QSignalSpy stateSpy(&supervisor, &ProcessSupervisor::stateChanged);
+    QSignalSpy restartSpy(&supervisor, &ProcessSupervisor::restartScheduled);
+
+    QVERIFY(supervisor.start("sleeper"));
+    QCOMPARE(supervisor.state("sleeper"), ProcessSupervisor::State::Starting);
+    QVERIFY(waitForState(supervisor, "sleeper", ProcessSupervisor::State::Running));
+    QVERIFY(supervisor.isRunning("sleeper"));
+
+    // Starting again is a no-op
+    QVERIFY(supervisor.start("sleeper"));
+    QVERIFY(supervisor.isRunning("sleeper"));
+
+    supervisor.stop("sleeper");
+    QCOMPARE(supervisor.state("sleeper"), ProcessSupervisor::State::Stopping);
+    QVERIFY(waitForState(supervisor, "sleeper", ProcessSupervisor::State::Stopped));
+
+    // Stopping is not a failure
+    QCOMPARE(restartSpy.count(), 0);
+    QCOMPARE(supervisor.restartCount("sleeper"), 0);
+
+    QList<ProcessSupervisor::State> states;
+    for (const QList<QVariant>& arguments : std::as_const(stateSpy)) {
+        states.append(arguments.at(1).value<ProcessSupervisor::State>());
+    }
+    QCOMPARE(states, QList<ProcessSupervisor::State>({ProcessSupervisor::State::Starting,
+                                                      ProcessSupervisor::State::Running,
+                                                      ProcessSupervisor::State::Stopping,
+                                                      ProcessSupervisor::State::Stopped}));
+}
+
+void TestProcessSupervisor::testRestartWithBackoff()
+{
+    ProcessSupervisor supervisor;
+    supervisor.setBackoff(20, 50);
+    supervisor.addProcess("flaky", "/bin/sh", {"-c", "exit 3"});
+
+    QSignalSpy restartSpy(&supervisor, &ProcessSupervisor::restartScheduled);
+    QVERIFY(supervisor.start("flaky"));
+
+    QTRY_VERIFY_WITH_TIMEOUT(restartSpy.count() >= 4, 5000);
+    QCOMPARE(restartSpy.at(0).at(0).toString(), QString("flaky"));
+    QCOMPARE(restartSpy.at(0).at(1).toInt(), 20);
+    QCOMPARE(restartSpy.at(1).at(1).toInt(), 40);
+    QCOMPARE(restartSpy.at(2).at(1).toInt(), 50); // Capped
+    QCOMPARE(restartSpy.at(3).at(1).toInt(), 50);
+    QVERIFY(supervisor.restartCount("flaky") >= 3);
+
+    // Stopping while backing off cancels the restart
+    supervisor.stop("flaky");
+    QVERIFY(waitForState(supervisor, "flaky", ProcessSupervisor::State::Stopped));
+    const int restarts = restartSpy.count();
+    QTest::qWait(150);
+    QCOMPARE(restartSpy.count(), restarts);
+    QCOMPARE(supervisor.state("flaky"), ProcessSupervisor::State::Stopped);
+}
+
+void TestProcessSupervisor::testFailedToStart()
+{
+    ProcessSupervisor supervisor;
+    supervisor.setBackoff(1000, 1000);
+    supervisor.addProcess("missing", "/nonexistent/xfb-helper");
+
+    QSignalSpy errorSpy(&supervisor, &ProcessSupervisor::processError);
+    QSignalSpy restartSpy(&supervisor, &ProcessSupervisor::restartScheduled);
+    QVERIFY(supervisor.start("missing"));
+
+    QTRY_COMPARE_WITH_TIMEOUT(errorSpy.count(), 1, 5000);
+    QCOMPARE(errorSpy.first().at(0).toString(), QString("missing"));
+    QCOMPARE(restartSpy.count(), 1);
+    QCOMPARE(supervisor.state("missing"), ProcessSupervisor::State::Backoff);
+
+    supervisor.stop("missing");
+    QCOMPARE(supervisor.state("missing"), ProcessSupervisor::State::Stopped);
+}
+
+void TestProcessSupervisor::testStopReachesProcessGroup()
+{
+#ifdef Q_OS_LINUX
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString pidFile = dir.filePath("child.pid");
+
+    // Like xvfb-run around butt: a wrapper that does not pass TERM on
+    ProcessSupervisor supervisor;
+    supervisor.setStopGracePeriod(5000);
+    supervisor.addProcess("wrapper", "/bin/sh",
+                          {"-c", QString("sleep 30 & echo $! > '%1'; wait").arg(pidFile)});
+    QVERIFY(supervisor.start("wrapper"));
+    QVERIFY(waitForState(supervisor, "wrapper", ProcessSupervisor::State::Running));
+    QVERIFY(supervisor.processId("wrapper") > 0);
+
+    QFile file(pidFile);
+    QTRY_VERIFY(file.exists() && file.size() > 0);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const qint64 child = file.readAll().trimmed().toLongLong();
+    QVERIFY(isAlive(child));
+
+    supervisor.stop("wrapper");
+    QVERIFY(waitForState(supervisor, "wrapper", ProcessSupervisor::State::Stopped));
+    QCOMPARE(supervisor.processId("wrapper"), qint64(0));
+    QTRY_VERIFY(!isAlive(child));
+#else
+    QSKIP("Reads /proc");
+#endif
+}
+
+void TestProcessSupervisor::testUnknownProcess()
+{
+    ProcessSupervisor supervisor;
+    QVERIFY(!supervisor.start("nothing"));
+    QCOMPARE(supervisor.state("nothing"), ProcessSupervisor::State::Stopped);
+    QCOMPARE(supervisor.restartCount("nothing"), 0);
+    supervisor.stop("nothing"); // Ignored
+    QVERIFY(!supervisor.hasProcess("nothing"));
+}
+
+QTEST_MAIN(TestProcessSupervisor)
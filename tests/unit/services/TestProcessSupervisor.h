@@ -0,0 +1,28 @@
+#ifndef TESTPROCESSSUPERVISOR_H
+#define TESTPROCESSSUPERVISOR_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for ProcessSupervisor class
+ *
+ * Tests child process supervision including:
+ * - Start and stop through QProcess signals
+ * - Restarting processes that exit, with doubling back-off
+ * - Programs that cannot be started
+ * - Signalling the whole process group on stop
+ */
+class TestProcessSupervisor : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testStartAndStop();
+    void testRestartWithBackoff();
+    void testFailedToStart();
+    void testStopReachesProcessGroup();
+    void testUnknownProcess();
+};
+
+#endif // TESTPROCESSSUPERVISOR_H
@@ -0,0 +1,203 @@
+#include "TestProgramBuilder.h"
+#include "../../../src/services/ProgramBuilder.h"
+#include <QFile>
+#include <QSignalSpy>
+#include <QtEndian>
+
+namespace {
+
+quint32 checksum(const QByteArray& page)
+{
+    QByteArray data = page;
+    qToLittleEndian<quint32>(0, data.data() + 22);
+    quint32 crc = 0;
+    for (char byte : data) {
+        crc ^= quint32(static_cast<uchar>(byte)) << 24;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 0x80000000u) ? (crc << 1) ^ 0x04c11db7u : crc << 1;
+        }
+    }
+    return crc;
+}
+
+QByteArray page(quint32 serial, uchar flags, qint64 granule, quint32 sequence, int bodySize)
+{
+    QByteArray header(27, '\0');
+    header.replace(0, 4, "OggS");
+    header[5] = static_cast<char>(flags);
+    qToLittleEndian<qint64>(granule, header.data() + 6);
+    qToLittleEndian<quint32>(serial, header.data() + 14);
+    qToLittleEndian<quint32>(sequence, header.data() + 18);
+
+    QByteArray lacing;
+    for (int left = bodySize; left >= 0; left -= 255) {
+        lacing.append(static_cast<char>(qMin(left, 255)));
+        if (left < 255) {
+            break;
+        }
+    }
+    header[26] = static_cast<char>(lacing.size());
+
+    QByteArray result = header + lacing + QByteArray(bodySize, static_cast<char>(serial));
+    qToLittleEndian<quint32>(checksum(result), result.data() + 22);
+    return result;
+}
+
+// A stream of one header page, some audio pages and an end page
+QByteArray stream(quint32 serial, int audioPages, bool closed = true)
+{
+    QByteArray data = page(serial, 0x02, 0, 0, 30);
+    for (int i = 1; i <= audioPages; ++i) {
+        const uchar flags = closed && i == audioPages ? 0x04 : 0x00;
+        data += page(serial, flags, i * 48000, quint32(i), 700 + i);
+    }
+    return data;
+}
+
+QList<QByteArray> pagesOf(const QByteArray& data)
+{
+    QList<QByteArray> pages;
+    qsizetype offset = 0;
+    while (offset + 27 <= data.size()) {
+        const int segments = static_cast<uchar>(data.at(offset + 26));
+        qsizetype size = 27 + segments;
+        for (int i = 0; i < segments; ++i) {
+            size += static_cast<uchar>(data.at(offset + 27 + i));
+        }
+        pages << data.mid(offset, size);
+        offset += size;
+    }
+    return pages;
+}
+
+QByteArray read(const QString& path)
+{
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+} // namespace
+
+void TestProgramBuilder::init()
+{
+    m_tempDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_tempDir->isValid());
+}
+
+void TestProgramBuilder::cleanup()
+{
+    m_tempDir.reset();
+}
+
+QString TestProgramBuilder::write(const QString& name, const QByteArray& data)
+{
+    const QString path = m_tempDir->filePath(name);
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size()) {
+        return QString();
+    }
+    return path;
+}
+
+void TestProgramBuilder::testCopiesDistinctStreams()
+{
+    const QByteArray first = stream(1, 3);
+    const QByteArray second = stream(2, 5);
+    const QString destination = m_tempDir->filePath("program.ogg");
+
+    QString error;
+    QVERIFY2(ProgramBuilder::concatenate({write("a.ogg", first), write("b.ogg", second)},
+                                         destination, &error),
+             qPrintable(error));
+    // Nothing needed changing, so the program is the sources back to back
+    QCOMPARE(read(destination), first + second);
+}
+
+void TestProgramBuilder::testRenumbersRepeatedSerials()
+{
+    const QString a = write("a.ogg", stream(7, 2));
+    const QString b = write("b.ogg", stream(8, 2));
+    const QString c = write("c.ogg", stream(7, 2));
+    const QString destination = m_tempDir->filePath("program.ogg");
+    QVERIFY(ProgramBuilder::concatenate({a, b, c, a}, destination));
+
+    const QList<QByteArray> pages = pagesOf(read(destination));
+    QCOMPARE(pages.size(), 12);
+    QList<quint32> serials;
+    for (const QByteArray& page : pages) {
+        QCOMPARE(qFromLittleEndian<quint32>(page.constData() + 22), checksum(page));
+        serials << qFromLittleEndian<quint32>(page.constData() + 14);
+    }
+    QCOMPARE(serials, QList<quint32>({7, 7, 7, 8, 8, 8, 9, 9, 9, 10, 10, 10}));
+    // Granule positions are left to each link
+    QCOMPARE(qFromLittleEndian<qint64>(pages.at(11).constData() + 6), qint64(96000));
+}
+
+void TestProgramBuilder::testClosesTruncatedStreams()
+{
+    const QString a = write("a.ogg", stream(1, 3, false));
+    const QString b = write("b.ogg", stream(2, 1));
+    const QString destination = m_tempDir->filePath("program.ogg");
+    QVERIFY(ProgramBuilder::concatenate({a, b}, destination));
+
+    const QList<QByteArray> pages = pagesOf(read(destination));
+    QCOMPARE(pages.size(), 6);
+    QCOMPARE(static_cast<uchar>(pages.at(2).at(5)), uchar(0x00));
+    QCOMPARE(static_cast<uchar>(pages.at(3).at(5)), uchar(0x04));
+    QCOMPARE(qFromLittleEndian<quint32>(pages.at(3).constData() + 22), checksum(pages.at(3)));
+}
+
+void TestProgramBuilder::testRejectsBadSources()
+{
+    const QString good = write("good.ogg", stream(1, 2));
+    const QString destination = write("program.ogg", "previous program");
+
+    QString error;
+    QVERIFY(!ProgramBuilder::concatenate({good, write("song.mp3", "ID3 not ogg")}, destination,
+                                         &error));
+    QVERIFY(error.contains("song.mp3"));
+
+    QByteArray damaged = stream(2, 2);
+    damaged.chop(100);
+    QVERIFY(!ProgramBuilder::concatenate({good, write("damaged.ogg", damaged)}, destination,
+                                         &error));
+    QVERIFY(error.contains("damaged"));
+
+    QVERIFY(!ProgramBuilder::concatenate({good, m_tempDir->filePath("missing.ogg")}, destination));
+    QVERIFY(!ProgramBuilder::concatenate({}, destination));
+
+    const std::atomic<bool> cancelled{true};
+    QVERIFY(!ProgramBuilder::concatenate({good, good}, destination, &error, {}, &cancelled));
+    QCOMPARE(error, QString("Cancelled"));
+
+    // A failed build leaves the old file in place
+    QCOMPARE(read(destination), QByteArray("previous program"));
+}
+
+void TestProgramBuilder::testBuildsInBackground()
+{
+    QStringList sources;
+    for (int i = 0; i < 20; ++i) {
+        sources << write(QString("%1.ogg").arg(i), stream(quint32(i), 50));
+    }
+    const QString destination = m_tempDir->filePath("program.ogg");
+
+    ProgramBuilder builder;
+    QSignalSpy progress(&builder, &ProgramBuilder::progressChanged);
+    QSignalSpy finished(&builder, &ProgramBuilder::finished);
+    QVERIFY(builder.start(sources, destination));
+    QVERIFY(builder.isRunning());
+    QVERIFY(!builder.start(sources, destination));
+
+    QVERIFY(finished.wait(5000));
+    QVERIFY(!builder.isRunning());
+    QCOMPARE(finished.first().at(0).toBool(), true);
+    QCOMPARE(finished.first().at(1).toString(), destination);
+    QVERIFY(!progress.isEmpty());
+    QCOMPARE(progress.last().at(0).toInt(), 1000);
+    QCOMPARE(pagesOf(read(destination)).size(), 20 * 51);
+
+    QVERIFY(!builder.start({}, destination));
+}
+
+QTEST_MAIN(TestProgramBuilder)
@@ -0,0 +1,39 @@
+#ifndef TESTPROGRAMBUILDER_H
+#define TESTPROGRAMBUILDER_H
+
+#include <QObject>
+#include <QTest>
+#include <QTemporaryDir>
+#include <memory>
+
+/**
+ * @brief Unit tests for ProgramBuilder class
+ *
+ * Tests joining Ogg files into one chained file including:
+ * - Copying the pages of distinct streams unchanged
+ * - Renumbering streams whose serial number was already used
+ * - Closing streams that were cut short
+ * - Refusing files that are not Ogg or are damaged, and cancelling
+ * - Building on a worker thread with progress
+ */
+class TestProgramBuilder : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testCopiesDistinctStreams();
+    void testRenumbersRepeatedSerials();
+    void testClosesTruncatedStreams();
+    void testRejectsBadSources();
+    void testBuildsInBackground();
+
+private:
+    QString write(const QString& name, const QByteArray& data);
+
+    std::unique_ptr<QTemporaryDir> m_tempDir;
+};
+
+#endif // TESTPROGRAMBUILDER_H
@@ -0,0 +1,50 @@
+#include "TestQmlHttpCache.h"
+#include "../../../src/services/QmlHttpCache.h"
+#include <QNetworkAccessManager>
+#include <QNetworkDiskCache>
+
+void TestQmlHttpCache::init()
+{
+    m_tempDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_tempDir->isValid());
+}
+
+void TestQmlHttpCache::cleanup()
+{
+    m_tempDir.reset();
+}
+
+void TestQmlHttpCache::testCreatesDiskCache()
+{
+    QmlHttpCache factory(m_tempDir->filePath("qml-http"), 8 * 1024 * 1024);
+    QObject parent;
+    QNetworkAccessManager* network = factory.create(&parent);
+    QVERIFY(network);
+    QCOMPARE(network->parent(), &parent);
+
+    auto* cache = qobject_cast<QNetworkDiskCache*>(network->cache());
+    QVERIFY(cache);
+    QCOMPARE(cache->maximumCacheSize(), qint64(8 * 1024 * 1024));
+    QVERIFY(cache->cacheDirectory().startsWith(m_tempDir->filePath("qml-http")));
+
+    // Too small a cache could not hold a banner
+    QmlHttpCache tiny(m_tempDir->filePath("tiny"), 10);
+    QCOMPARE(tiny.maxBytes(), qint64(1024 * 1024));
+}
+
+void TestQmlHttpCache::testSeparateDirectories()
+{
+    QmlHttpCache factory(m_tempDir->filePath("qml-http"));
+    QObject parent;
+    auto* first = qobject_cast<QNetworkDiskCache*>(factory.create(&parent)->cache());
+    auto* second = qobject_cast<QNetworkDiskCache*>(factory.create(&parent)->cache());
+    QVERIFY(first && second);
+    QVERIFY(first->cacheDirectory() != second->cacheDirectory());
+
+    // The first access manager of a new factory finds the same cache again
+    QmlHttpCache again(m_tempDir->filePath("qml-http"));
+    auto* reopened = qobject_cast<QNetworkDiskCache*>(again.create(&parent)->cache());
+    QCOMPARE(reopened->cacheDirectory(), first->cacheDirectory());
+}
+
+QTEST_MAIN(TestQmlHttpCache)
@@ -0,0 +1,31 @@
+#ifndef TESTQMLHTTPCACHE_H
+#define TESTQMLHTTPCACHE_H
+
+#include <QObject>
+#include <QTest>
+#include <QTemporaryDir>
+#include <memory>
+
+/**
+ * @brief Unit tests for QmlHttpCache class
+ *
+ * Tests the HTTP cache of a QML engine including:
+ * - Giving each access manager a disk cache of the configured size
+ * - A directory of its own for every access manager created
+ */
+class TestQmlHttpCache : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testCreatesDiskCache();
+    void testSeparateDirectories();
+
+private:
+    std::unique_ptr<QTemporaryDir> m_tempDir;
+};
+
+#endif // TESTQMLHTTPCACHE_H
@@ -0,0 +1,135 @@
+#include "TestQueueJournal.h"
+#include "../../../src/services/QueueJournal.h"
+#include <QFile>
+#include <QTemporaryDir>
+
+namespace {
+
+int lineCount(const QString& filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+    return int(file.readAll().count('\n'));
+}
+
+} // namespace
+
+void TestQueueJournal::testReadSkipsCutLine()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath(QueueJournal::FILE_NAME);
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("{\"paths\":[\"/a.ogg\",\"/b.ogg\"],\"time\":\"2026-10-14T12:00:00.000\","
+               "\"type\":\"queue\"}\n"
+               "{\"path\":\"/song.ogg\",\"time\":\"2026-10-14T12:00:01.000\",\"type\":\"track\"}\n"
+               "{\"ms\":61250,\"time\":\"2026-10-14T12:01:02.000\",\"type\":\"position\"}\n"
+               "{\"row\":7,\"fire_at\":\"2026-10-14T12:00:00.000\",\"time\":"
+               "\"2026-10-14T12:00:00.010\",\"type\":\"fired\"}\n"
+               "{\"ms\":62250,\"time\":\"2026-10-14T12:01:0");
+    file.close();
+
+    const QueueJournal::State state = QueueJournal::read(path);
+    QCOMPARE(state.queue, QStringList({"/a.ogg", "/b.ogg"}));
+    QCOMPARE(state.current, QString("/song.ogg"));
+    QCOMPARE(state.positionMs, qint64(61250));
+    QCOMPARE(state.fired.size(), 1);
+    QCOMPARE(state.fired.first().rowId, qint64(7));
+    QCOMPARE(state.fired.first().fireAt,
+             QDateTime::fromString("2026-10-14T12:00:00.000", Qt::ISODateWithMs));
+    QCOMPARE(state.savedAt, QDateTime::fromString("2026-10-14T12:01:02.000", Qt::ISODateWithMs));
+
+    QVERIFY(QueueJournal::read(dir.filePath("missing.jsonl")).isEmpty());
+}
+
+void TestQueueJournal::testRoundTrip()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath(QueueJournal::FILE_NAME);
+    QStringList queue = {"/a.ogg", "/b.ogg", "/c.ogg"};
+    const QDateTime fireAt = QDateTime::currentDateTime();
+
+    {
+        QueueJournal journal;
+        journal.setQueueSource([&queue]() { return queue; });
+        QVERIFY(journal.open(path));
+        QVERIFY(journal.restored().isEmpty());
+
+        journal.queueChanged();
+        journal.trackStarted("/song.ogg");
+        journal.setPosition(1000);
+        journal.setPosition(2500);
+        journal.scheduled(3, fireAt);
+        queue.removeFirst();
+        journal.queueChanged();
+        journal.flush();
+
+        // Written and synced before the journal goes away, as in a crash
+        const QueueJournal::State state = QueueJournal::read(path);
+        QCOMPARE(state.queue, QStringList({"/b.ogg", "/c.ogg"}));
+        QCOMPARE(state.current, QString("/song.ogg"));
+        QCOMPARE(state.positionMs, qint64(2500));
+        QCOMPARE(state.fired.size(), 1);
+    }
+
+    QueueJournal reopened;
+    QVERIFY(reopened.open(path));
+    const QueueJournal::State restored = reopened.restored();
+    QCOMPARE(restored.queue, QStringList({"/b.ogg", "/c.ogg"}));
+    QCOMPARE(restored.current, QString("/song.ogg"));
+    QCOMPARE(restored.positionMs, qint64(2500));
+    QCOMPARE(restored.fired.size(), 1);
+    QCOMPARE(restored.fired.first().rowId, qint64(3));
+    QCOMPARE(restored.fired.first().fireAt.toMSecsSinceEpoch(), fireAt.toMSecsSinceEpoch());
+}
+
+void TestQueueJournal::testStopClearsCurrent()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath(QueueJournal::FILE_NAME);
+
+    QueueJournal journal;
+    QVERIFY(journal.open(path));
+    journal.trackStarted("/song.ogg");
+    journal.setPosition(5000);
+    journal.stopped();
+    // Positions after a stop belong to nothing
+    journal.setPosition(6000);
+    journal.flush();
+
+    const QueueJournal::State state = QueueJournal::read(path);
+    QVERIFY(state.current.isEmpty());
+    QCOMPARE(state.positionMs, qint64(0));
+}
+
+void TestQueueJournal::testOpenCompacts()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath(QueueJournal::FILE_NAME);
+
+    {
+        QueueJournal journal;
+        QVERIFY(journal.open(path));
+        for (int i = 0; i < 50; ++i) {
+            journal.trackStarted(QString("/song%1.ogg").arg(i));
+            journal.setPosition(1000 + i);
+            journal.flush();
+        }
+    }
+    QCOMPARE(lineCount(path), 1 + 2 * 50);
+
+    // The queue, the track and its position are all that is left
+    QueueJournal reopened;
+    QVERIFY(reopened.open(path));
+    QCOMPARE(reopened.restored().current, QString("/song49.ogg"));
+    QCOMPARE(reopened.restored().positionMs, qint64(1049));
+    QCOMPARE(lineCount(path), 3);
+}
+
+QTEST_MAIN(TestQueueJournal)
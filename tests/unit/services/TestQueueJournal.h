@@ -0,0 +1,27 @@
+#ifndef TESTQUEUEJOURNAL_H
+#define TESTQUEUEJOURNAL_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for QueueJournal class
+ *
+ * Tests the queue journal including:
+ * - Replaying a file, with a line cut short by a crash
+ * - The queue, the track on air and its position written and read back
+ * - A stop leaving nothing to resume
+ * - Reopening, which compacts the file to the state alone
+ */
+class TestQueueJournal : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testReadSkipsCutLine();
+    void testRoundTrip();
+    void testStopClearsCurrent();
+    void testOpenCompacts();
+};
+
+#endif // TESTQUEUEJOURNAL_H
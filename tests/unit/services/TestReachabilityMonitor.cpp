@@ -0,0 +1,147 @@
+#include "TestReachabilityMonitor.h"
+#include "../../../src/services/ReachabilityMonitor.h"
+#include <QHostAddress>
+#include <QSignalSpy>
+#include <QTcpServer>
+
+namespace {
+
+// A port nothing listens on: grab one from the system and release it again
+quint16 closedPort()
+{
+    QTcpServer server;
+    if (!server.listen(QHostAddress::LocalHost)) {
+        return 0;
+    }
+    const quint16 port = server.serverPort();
+    server.close();
+    return port;
+}
+
+} // namespace
+
+void TestReachabilityMonitor::testProbeOnceOpenPort()
+{
+    QTcpServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+
+    ReachabilityMonitor monitor;
+    bool done = false;
+    ReachabilityMonitor::ProbeResult result;
+    monitor.probeOnce("127.0.0.1", server.serverPort(), 2000,
+                      [&](const ReachabilityMonitor::ProbeResult& probe) {
+                          result = probe;
+                          done = true;
+                      });
+
+    QTRY_VERIFY_WITH_TIMEOUT(done, 5000);
+    QVERIFY(result.reachable);
+    QVERIFY(result.rttMs >= 0);
+    QVERIFY(result.errorString.isEmpty());
+}
+
+void TestReachabilityMonitor::testProbeOnceClosedPort()
+{
+    const quint16 port = closedPort();
+    QVERIFY(port != 0);
+
+    ReachabilityMonitor monitor;
+    int calls = 0;
+    ReachabilityMonitor::ProbeResult result;
+    monitor.probeOnce("127.0.0.1", port, 2000, [&](const ReachabilityMonitor::ProbeResult& probe) {
+        result = probe;
+        ++calls;
+    });
+
+    QTRY_COMPARE_WITH_TIMEOUT(calls, 1, 5000);
+    QVERIFY(!result.reachable);
+    QCOMPARE(result.error, QAbstractSocket::ConnectionRefusedError);
+    QVERIFY(!result.errorString.isEmpty());
+
+    // The timeout must not report a second time
+    QTest::qWait(2200);
+    QCOMPARE(calls, 1);
+}
+
+void TestReachabilityMonitor::testOutageAndRecovery()
+{
+    QTcpServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+    const quint16 port = server.serverPort();
+
+    ReachabilityMonitor monitor;
+    monitor.setInterval(ReachabilityMonitor::RETRY_DELAY_MS);
+    monitor.setJitter(0);
+    monitor.setFailureThreshold(2);
+    monitor.addTarget("peer", "127.0.0.1", port);
+    QVERIFY(monitor.hasTarget("peer"));
+    QCOMPARE(monitor.status("peer"), ReachabilityMonitor::Status::Unknown);
+
+    QSignalSpy statusSpy(&monitor, &ReachabilityMonitor::statusChanged);
+    QSignalSpy probeSpy(&monitor, &ReachabilityMonitor::probeFinished);
+    QVERIFY(monitor.start("peer"));
+    QVERIFY(monitor.isMonitoring("peer"));
+
+    QTRY_COMPARE_WITH_TIMEOUT(monitor.status("peer"), ReachabilityMonitor::Status::Reachable, 5000);
+    QTRY_VERIFY_WITH_TIMEOUT(monitor.rttHistory("peer").size() >= 2, 5000);
+    QVERIFY(monitor.averageRtt("peer") >= 0.0);
+
+    // One failed probe is not an outage yet; the second one is
+    server.close();
+    QTRY_COMPARE_WITH_TIMEOUT(monitor.status("peer"), ReachabilityMonitor::Status::Unreachable, 5000);
+    QVERIFY(monitor.consecutiveFailures("peer") >= 2);
+
+    // Further failures do not report the outage again
+    const int failuresSeen = monitor.consecutiveFailures("peer");
+    QTRY_VERIFY_WITH_TIMEOUT(monitor.consecutiveFailures("peer") > failuresSeen, 5000);
+    QCOMPARE(statusSpy.count(), 2);
+
+    QVERIFY(server.listen(QHostAddress::LocalHost, port));
+    QTRY_COMPARE_WITH_TIMEOUT(monitor.status("peer"), ReachabilityMonitor::Status::Reachable, 5000);
+    QCOMPARE(monitor.consecutiveFailures("peer"), 0);
+
+    QList<ReachabilityMonitor::Status> statuses;
+    for (const QList<QVariant>& arguments : std::as_const(statusSpy)) {
+        statuses.append(arguments.at(1).value<ReachabilityMonitor::Status>());
+    }
+    QCOMPARE(statuses, QList<ReachabilityMonitor::Status>({ReachabilityMonitor::Status::Reachable,
+                                                          ReachabilityMonitor::Status::Unreachable,
+                                                          ReachabilityMonitor::Status::Reachable}));
+
+    monitor.stop("peer");
+    QVERIFY(!monitor.isMonitoring("peer"));
+    const int probes = probeSpy.count();
+    QTest::qWait(3 * ReachabilityMonitor::RETRY_DELAY_MS);
+    QCOMPARE(probeSpy.count(), probes);
+}
+
+void TestReachabilityMonitor::testJitteredDelay()
+{
+    QCOMPARE(ReachabilityMonitor::jitteredDelay(1000, 0), 1000);
+
+    bool varied = false;
+    for (int i = 0; i < 200; ++i) {
+        const int delay = ReachabilityMonitor::jitteredDelay(1000, 10);
+        QVERIFY(delay >= 900);
+        QVERIFY(delay <= 1100);
+        varied = varied || delay != 1000;
+    }
+    QVERIFY(varied);
+}
+
+void TestReachabilityMonitor::testUnknownTarget()
+{
+    ReachabilityMonitor monitor;
+    QVERIFY(!monitor.hasTarget("nobody"));
+    QVERIFY(!monitor.start("nobody"));
+    QVERIFY(!monitor.isMonitoring("nobody"));
+    QCOMPARE(monitor.status("nobody"), ReachabilityMonitor::Status::Unknown);
+    QVERIFY(monitor.rttHistory("nobody").isEmpty());
+    QCOMPARE(monitor.averageRtt("nobody"), -1.0);
+
+    // Stopping or removing an unknown target is harmless
+    monitor.stop("nobody");
+    monitor.removeTarget("nobody");
+}
+
+QTEST_MAIN(TestReachabilityMonitor)
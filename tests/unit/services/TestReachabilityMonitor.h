@@ -0,0 +1,28 @@
+#ifndef TESTREACHABILITYMONITOR_H
+#define TESTREACHABILITYMONITOR_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for ReachabilityMonitor class
+ *
+ * Tests TCP connect probing including:
+ * - One-off probes of open and closed ports
+ * - Reachable/unreachable transitions of a monitored target
+ * - Round trip time history
+ * - Probe interval jitter
+ */
+class TestReachabilityMonitor : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testProbeOnceOpenPort();
+    void testProbeOnceClosedPort();
+    void testOutageAndRecovery();
+    void testJitteredDelay();
+    void testUnknownTarget();
+};
+
+#endif // TESTREACHABILITYMONITOR_H
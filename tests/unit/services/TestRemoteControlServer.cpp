@@ -0,0 +1,484 @@
+#include "TestRemoteControlServer.h"
+#include "../../../src/services/RemoteControlServer.h"
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QRandomGenerator>
+#include <QSignalSpy>
+#include <QTcpSocket>
+#include <QtEndian>
+
+namespace {
+
+/// Send a raw request and return everything the server answers before it closes.
+/// The server runs on this thread, so this waits in the event loop rather than blocking.
+QByteArray fetch(quint16 port, const QByteArray& request)
+{
+    QTcpSocket socket;
+    QByteArray response;
+    QObject::connect(&socket, &QTcpSocket::connected, &socket,
+                     [&socket, request]() { socket.write(request); });
+    QObject::connect(&socket, &QTcpSocket::readyRead, &socket,
+                     [&socket, &response]() { response += socket.readAll(); });
+    QSignalSpy closed(&socket, &QTcpSocket::disconnected);
+    socket.connectToHost(QHostAddress::LocalHost, port);
+    closed.wait(5000);
+    response += socket.readAll();
+    return response;
+}
+
+QByteArray post(quint16 port, const QByteArray& path, const QByteArray& body)
+{
+    return fetch(port, "POST " + path + " HTTP/1.1\r\nContent-Length: "
+                           + QByteArray::number(body.size()) + "\r\n\r\n" + body);
+}
+
+QJsonObject json(const QByteArray& response)
+{
+    const qsizetype end = response.indexOf("\r\n\r\n");
+    return QJsonDocument::fromJson(end < 0 ? QByteArray() : response.mid(end + 4)).object();
+}
+
+/// A WebSocket client that waits in the event loop
+class WebSocketClient
+{
+public:
+    explicit WebSocketClient(quint16 port)
+    {
+        QObject::connect(&m_socket, &QTcpSocket::readyRead, &m_socket,
+                         [this]() { m_buffer += m_socket.readAll(); });
+        m_socket.connectToHost(QHostAddress::LocalHost, port);
+        // The kernel completes the connection; the server accepts it in the event loop
+        m_socket.waitForConnected(5000);
+        m_socket.write("GET /api/ws HTTP/1.1\r\n"
+                       "Host: localhost\r\n"
+                       "Upgrade: websocket\r\n"
+                       "Connection: Upgrade\r\n"
+                       "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+                       "Sec-WebSocket-Version: 13\r\n\r\n");
+        QTest::qWaitFor([this]() { return m_buffer.contains("\r\n\r\n"); }, 5000);
+        const qsizetype end = m_buffer.indexOf("\r\n\r\n");
+        m_head = m_buffer.left(end);
+        m_buffer.remove(0, end + 4);
+    }
+
+    QByteArray head() const { return m_head; }
+    QTcpSocket& socket() { return m_socket; }
+
+    void sendFrame(int opcode, const QByteArray& payload)
+    {
+        QByteArray frame;
+        frame.append(char(0x80 | opcode));
+        frame.append(char(0x80 | payload.size()));   // Short test payloads only
+        const char mask[4] = {0x12, 0x34, 0x56, 0x78};
+        frame.append(mask, 4);
+        for (qsizetype i = 0; i < payload.size(); ++i) {
+            frame.append(char(payload[i] ^ mask[i % 4]));
+        }
+        m_socket.write(frame);
+    }
+
+    void send(const QJsonObject& message)
+    {
+        sendFrame(0x1, QJsonDocument(message).toJson(QJsonDocument::Compact));
+    }
+
+    /// Wait for the next frame; false if none came in time
+    bool nextFrame(int* opcode, QByteArray* payload, int timeoutMs = 5000)
+    {
+        QTest::qWaitFor([this]() { return frameLength() > 0; }, timeoutMs);
+        const qsizetype length = frameLength();
+        if (length <= 0) {
+            return false;
+        }
+        const qsizetype header = length - payloadLength();
+        *opcode = quint8(m_buffer[0]) & 0x0F;
+        *payload = m_buffer.mid(header, payloadLength());
+        m_buffer.remove(0, length);
+        return true;
+    }
+
+    QJsonObject next(int timeoutMs = 5000)
+    {
+        int opcode = 0;
+        QByteArray payload;
+        if (!nextFrame(&opcode, &payload, timeoutMs) || opcode != 0x1) {
+            return {};
+        }
+        return QJsonDocument::fromJson(payload).object();
+    }
+
+private:
+    qsizetype payloadLength() const
+    {
+        const int length = quint8(m_buffer[1]) & 0x7F;
+        if (length == 126) {
+            return qFromBigEndian<quint16>(m_buffer.constData() + 2);
+        }
+        if (length == 127) {
+            return qsizetype(qFromBigEndian<quint64>(m_buffer.constData() + 2));
+        }
+        return length;
+    }
+
+    /// Size of the first whole frame in the buffer, 0 if there is none yet
+    qsizetype frameLength() const
+    {
+        if (m_buffer.size() < 2) {
+            return 0;
+        }
+        const int length = quint8(m_buffer[1]) & 0x7F;
+        const qsizetype header = length == 126 ? 4 : length == 127 ? 10 : 2;
+        if (m_buffer.size() < header) {
+            return 0;
+        }
+        const qsizetype total = header + payloadLength();
+        return m_buffer.size() < total ? 0 : total;
+    }
+
+    QTcpSocket m_socket;
+    QByteArray m_buffer;
+    QByteArray m_head;
+};
+
+QJsonArray paths(int count)
+{
+    QJsonArray result;
+    for (int i = 0; i < count; ++i) {
+        result.append(QString("/music/library/artist %1/track %1.mp3").arg(i));
+    }
+    return result;
+}
+
+} // namespace
+
+void TestRemoteControlServer::testSpliceDiff()
+{
+    const QJsonArray from{"a", "b", "c", "d"};
+
+    QJsonObject splice = RemoteControlServer::spliceDiff(from, {"a", "x", "c", "d"});
+    QCOMPARE(splice.value("index").toInt(), 1);
+    QCOMPARE(splice.value("remove").toInt(), 1);
+    QCOMPARE(splice.value("insert").toArray(), QJsonArray{"x"});
+
+    splice = RemoteControlServer::spliceDiff(from, from);
+    QCOMPARE(splice.value("remove").toInt(), 0);
+    QVERIFY(splice.value("insert").toArray().isEmpty());
+
+    // Repeated elements must not be counted twice by the head and the tail
+    const QList<QPair<QJsonArray, QJsonArray>> cases = {
+        {from, {"b", "c", "d"}},
+        {from, {"a", "b", "c", "d", "e"}},
+        {from, {"x", "a", "b", "c", "d"}},
+        {from, {}},
+        {{}, from},
+        {{"a", "a", "a"}, {"a", "a"}},
+        {{"a", "b", "a"}, {"a", "b", "b", "a"}},
+    };
+    for (const auto& [before, after] : cases) {
+        QCOMPARE(RemoteControlServer::applySplice(
+                     before, RemoteControlServer::spliceDiff(before, after)),
+                 after);
+    }
+
+    QRandomGenerator random(7);
+    for (int round = 0; round < 200; ++round) {
+        QJsonArray before;
+        QJsonArray after;
+        for (int i = int(random.bounded(8)); i > 0; --i) {
+            before.append(int(random.bounded(3)));
+        }
+        for (int i = int(random.bounded(8)); i > 0; --i) {
+            after.append(int(random.bounded(3)));
+        }
+        QCOMPARE(RemoteControlServer::applySplice(
+                     before, RemoteControlServer::spliceDiff(before, after)),
+                 after);
+    }
+}
+
+void TestRemoteControlServer::testAcceptKey()
+{
+    // The example of RFC 6455
+    QCOMPARE(RemoteControlServer::acceptKey("dGhlIHNhbXBsZSBub25jZQ=="),
+             QByteArray("s3pPLMBiTxaQ9kYGJzzpP1AWSPE="));
+}
+
+void TestRemoteControlServer::testRestState()
+{
+    RemoteControlServer server;
+    server.publish("transport", QJsonObject{{"state", "playing"}});
+    server.addDocument("metrics", []() { return QJsonObject{{"answer", 42}}; });
+    QVERIFY(server.listen(0, QHostAddress::LocalHost));
+
+    QByteArray response = fetch(server.port(), "GET /api/state HTTP/1.1\r\n\r\n");
+    QVERIFY(response.startsWith("HTTP/1.1 200"));
+    QVERIFY(response.contains("Content-Type: application/json"));
+    QCOMPARE(json(response).value("topics").toObject().value("transport").toObject().value(
+                 "state"),
+             QJsonValue("playing"));
+
+    response = fetch(server.port(), "GET /api/transport HTTP/1.1\r\n\r\n");
+    QCOMPARE(json(response).value("value").toObject().value("state"), QJsonValue("playing"));
+
+    response = fetch(server.port(), "GET /api/metrics HTTP/1.1\r\n\r\n");
+    QCOMPARE(json(response).value("value").toObject().value("answer").toInt(), 42);
+
+    server.addQuery("echo", [](const QJsonObject& args) { return QJsonValue(args); });
+    server.setToken("secret");
+    response = fetch(server.port(), "GET /api/echo?since=7&token=secret HTTP/1.1\r\n\r\n");
+    QCOMPARE(json(response).value("value").toObject(), QJsonObject({{"since", "7"}}));
+    server.setToken(QString());
+
+    QVERIFY(fetch(server.port(), "GET /api/nothing HTTP/1.1\r\n\r\n").startsWith("HTTP/1.1 404"));
+    QVERIFY(fetch(server.port(), "GET /index.html HTTP/1.1\r\n\r\n").startsWith("HTTP/1.1 404"));
+    QVERIFY(fetch(server.port(), "DELETE /api/state HTTP/1.1\r\n\r\n")
+                .startsWith("HTTP/1.1 405"));
+}
+
+void TestRemoteControlServer::testRestCommand()
+{
+    RemoteControlServer server;
+    QJsonObject received;
+    int calls = 0;
+    server.addCommand("next", [&](const QJsonObject& args) {
+        ++calls;
+        received = args;
+        return QString();
+    });
+    server.addCommand("fail", [](const QJsonObject&) { return QString("broken"); });
+    QVERIFY(server.listen(0, QHostAddress::LocalHost));
+
+    QByteArray response = post(server.port(), "/api/command/next", R"({"reason":"test"})");
+    QVERIFY(response.startsWith("HTTP/1.1 200"));
+    QVERIFY(json(response).value("ok").toBool());
+    QCOMPARE(calls, 1);
+    QCOMPARE(received.value("reason"), QJsonValue("test"));
+
+    QVERIFY(post(server.port(), "/api/command/next", QByteArray()).startsWith("HTTP/1.1 200"));
+    QCOMPARE(calls, 2);
+
+    response = post(server.port(), "/api/command/fail", "{}");
+    QVERIFY(response.startsWith("HTTP/1.1 400"));
+    QCOMPARE(json(response).value("error"), QJsonValue("broken"));
+
+    QVERIFY(post(server.port(), "/api/command/unknown", "{}").startsWith("HTTP/1.1 404"));
+    QVERIFY(post(server.port(), "/api/command/next", "[1, 2").startsWith("HTTP/1.1 400"));
+    QCOMPARE(calls, 2);
+}
+
+void TestRemoteControlServer::testCommandRateLimit()
+{
+    RemoteControlServer server;
+    int calls = 0;
+    server.addCommand("next", [&](const QJsonObject&) {
+        ++calls;
+        return QString();
+    });
+    QVERIFY(server.listen(0, QHostAddress::LocalHost));
+
+    for (int i = 0; i < RemoteControlServer::COMMAND_BURST; ++i) {
+        QVERIFY(post(server.port(), "/api/command/next", "{}").startsWith("HTTP/1.1 200"));
+    }
+    QVERIFY(post(server.port(), "/api/command/next", "{}").startsWith("HTTP/1.1 429"));
+    QCOMPARE(calls, RemoteControlServer::COMMAND_BURST);
+
+    // The bucket refills at COMMANDS_PER_SECOND
+    QTest::qWait(1000 / RemoteControlServer::COMMANDS_PER_SECOND + 50);
+    QVERIFY(post(server.port(), "/api/command/next", "{}").startsWith("HTTP/1.1 200"));
+}
+
+void TestRemoteControlServer::testToken()
+{
+    RemoteControlServer server;
+    server.setToken("secret");
+    QVERIFY(server.listen(0, QHostAddress::LocalHost));
+
+    QByteArray response = fetch(server.port(), "GET /api/state HTTP/1.1\r\n\r\n");
+    QVERIFY(response.startsWith("HTTP/1.1 401"));
+    QVERIFY(response.contains("WWW-Authenticate: Bearer"));
+    QVERIFY(fetch(server.port(), "GET /api/state HTTP/1.1\r\nAuthorization: Bearer wrong\r\n\r\n")
+                .startsWith("HTTP/1.1 401"));
+    QVERIFY(fetch(server.port(), "GET /api/state HTTP/1.1\r\nAuthorization: Bearer secret\r\n\r\n")
+                .startsWith("HTTP/1.1 200"));
+    QVERIFY(fetch(server.port(), "GET /api/state?token=secret HTTP/1.1\r\n\r\n")
+                .startsWith("HTTP/1.1 200"));
+}
+
+void TestRemoteControlServer::testWebSocketSnapshot()
+{
+    RemoteControlServer server;
+    server.publish("transport", QJsonObject{{"state", "playing"}});
+    QVERIFY(server.listen(0, QHostAddress::LocalHost));
+    QSignalSpy clients(&server, &RemoteControlServer::clientsChanged);
+
+    {
+        WebSocketClient client(server.port());
+        QVERIFY(client.head().startsWith("HTTP/1.1 101"));
+        QVERIFY(client.head().contains("Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGJzzpP1AWSPE="));
+
+        const QJsonObject snapshot = client.next();
+        QCOMPARE(snapshot.value("type"), QJsonValue("snapshot"));
+        QCOMPARE(snapshot.value("topics").toObject().value("transport").toObject().value(
+                     "state"),
+                 QJsonValue("playing"));
+        QCOMPARE(server.clientCount(), 1);
+    }
+
+    QTRY_COMPARE(server.clientCount(), 0);
+    QCOMPARE(clients.count(), 2);
+}
+
+void TestRemoteControlServer::testUpdatesAreCoalesced()
+{
+    RemoteControlServer server;
+    server.publish("transport", QJsonObject{{"positionMs", 0}});
+    QVERIFY(server.listen(0, QHostAddress::LocalHost));
+
+    WebSocketClient client(server.port());
+    QCOMPARE(client.next().value("type"), QJsonValue("snapshot"));
+
+    for (int position = 1; position <= 10; ++position) {
+        server.publish("transport", QJsonObject{{"positionMs", position}});
+    }
+    // Republishing the same value is no change
+    server.publish("transport", QJsonObject{{"positionMs", 10}});
+
+    const QJsonObject update = client.next();
+    QCOMPARE(update.value("type"), QJsonValue("update"));
+    QCOMPARE(update.value("topics").toObject().value("transport").toObject().value(
+                 "positionMs").toInt(),
+             10);
+    QVERIFY(client.next(RemoteControlServer::DEFAULT_PUSH_INTERVAL_MS * 2).isEmpty());
+
+    // After a quiet interval a change goes out at once; the ones right
+    // after it are held back until the interval is over
+    server.publish("transport", QJsonObject{{"positionMs", 11}});
+    QCOMPARE(client.next().value("topics").toObject().value("transport").toObject().value(
+                 "positionMs").toInt(),
+             11);
+    QElapsedTimer timer;
+    timer.start();
+    server.publish("transport", QJsonObject{{"positionMs", 12}});
+    QTest::qWait(10);
+    server.publish("transport", QJsonObject{{"positionMs", 13}});
+    QCOMPARE(client.next().value("topics").toObject().value("transport").toObject().value(
+                 "positionMs").toInt(),
+             13);
+    QVERIFY(timer.elapsed() >= RemoteControlServer::DEFAULT_PUSH_INTERVAL_MS - 50);
+}
+
+void TestRemoteControlServer::testArraysAreSpliced()
+{
+    RemoteControlServer server;
+    const QJsonArray queue = paths(20);
+    server.publish("queue", queue);
+    QVERIFY(server.listen(0, QHostAddress::LocalHost));
+
+    WebSocketClient client(server.port());
+    QJsonArray mirror = client.next().value("topics").toObject().value("queue").toArray();
+    QCOMPARE(mirror, queue);
+
+    QJsonArray changed = queue;
+    changed.insert(5, QString("/music/jingle.mp3"));
+    changed.removeAt(15);
+    server.publish("queue", changed);
+
+    const QJsonObject update = client.next();
+    QVERIFY(!update.value("topics").toObject().contains("queue"));
+    const QJsonObject splice = update.value("splices").toObject().value("queue").toObject();
+    QCOMPARE(splice.value("index").toInt(), 5);
+    mirror = RemoteControlServer::applySplice(mirror, splice);
+    QCOMPARE(mirror, changed);
+
+    // A queue replaced as a whole is cheaper to send as it is
+    server.publish("queue", QJsonArray{"/music/other.mp3"});
+    const QJsonObject replaced = client.next();
+    QCOMPARE(replaced.value("topics").toObject().value("queue").toArray(),
+             QJsonArray{"/music/other.mp3"});
+}
+
+void TestRemoteControlServer::testSubscribe()
+{
+    RemoteControlServer server;
+    server.publish("transport", QJsonObject{{"positionMs", 0}});
+    server.publish("queue", QJsonArray{"a"});
+    QVERIFY(server.listen(0, QHostAddress::LocalHost));
+
+    WebSocketClient client(server.port());
+    QCOMPARE(client.next().value("topics").toObject().size(), 2);
+
+    client.send({{"type", "subscribe"}, {"topics", QJsonArray{"queue"}}, {"intervalMs", 1}});
+    const QJsonObject snapshot = client.next();
+    QCOMPARE(snapshot.value("type"), QJsonValue("snapshot"));
+    QCOMPARE(snapshot.value("topics").toObject().keys(), QStringList{"queue"});
+
+    server.publish("transport", QJsonObject{{"positionMs", 1}});
+    QVERIFY(client.next(300).isEmpty());
+
+    QElapsedTimer timer;
+    timer.start();
+    server.publish("queue", QJsonArray{"b"});
+    QCOMPARE(client.next().value("topics").toObject().value("queue").toArray(), QJsonArray{"b"});
+    // The interval asked for is clamped to MIN_PUSH_INTERVAL_MS, not the default
+    QVERIFY(timer.elapsed() < RemoteControlServer::DEFAULT_PUSH_INTERVAL_MS);
+}
+
+void TestRemoteControlServer::testWebSocketCommand()
+{
+    RemoteControlServer server;
+    int calls = 0;
+    server.addCommand("next", [&](const QJsonObject&) {
+        ++calls;
+        return QString();
+    });
+    server.addDocument("metrics", []() { return QJsonObject{{"answer", 42}}; });
+    QVERIFY(server.listen(0, QHostAddress::LocalHost));
+
+    WebSocketClient client(server.port());
+    client.next();
+
+    client.send({{"type", "command"}, {"id", 7}, {"command", "next"}});
+    QJsonObject result = client.next();
+    QCOMPARE(result.value("type"), QJsonValue("result"));
+    QCOMPARE(result.value("id").toInt(), 7);
+    QVERIFY(result.value("ok").toBool());
+    QCOMPARE(calls, 1);
+
+    client.send({{"type", "command"}, {"id", 8}, {"command", "unknown"}});
+    result = client.next();
+    QCOMPARE(result.value("id").toInt(), 8);
+    QVERIFY(!result.value("ok").toBool());
+
+    client.send({{"type", "get"}, {"id", 9}, {"name", "metrics"}});
+    result = client.next();
+    QCOMPARE(result.value("value").toObject().value("answer").toInt(), 42);
+
+    client.sendFrame(0x1, "not json");
+    QCOMPARE(client.next().value("type"), QJsonValue("error"));
+}
+
+void TestRemoteControlServer::testPing()
+{
+    RemoteControlServer server;
+    QVERIFY(server.listen(0, QHostAddress::LocalHost));
+
+    WebSocketClient client(server.port());
+    client.next();
+
+    client.sendFrame(0x9, "hello");
+    int opcode = 0;
+    QByteArray payload;
+    QVERIFY(client.nextFrame(&opcode, &payload));
+    QCOMPARE(opcode, 0xA);
+    QCOMPARE(payload, QByteArray("hello"));
+
+    // Closing is answered with a close, and the connection ends
+    QSignalSpy closed(&client.socket(), &QTcpSocket::disconnected);
+    client.sendFrame(0x8, QByteArray("\x03\xe8", 2));
+    QVERIFY(client.nextFrame(&opcode, &payload));
+    QCOMPARE(opcode, 0x8);
+    QVERIFY(closed.count() > 0 || closed.wait(5000));
+    QTRY_COMPARE(server.clientCount(), 0);
+}
+
+QTEST_MAIN(TestRemoteControlServer)
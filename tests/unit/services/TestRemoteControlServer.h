@@ -0,0 +1,38 @@
+#ifndef TESTREMOTECONTROLSERVER_H
+#define TESTREMOTECONTROLSERVER_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for RemoteControlServer class
+ *
+ * Tests the remote API including:
+ * - Splices between arrays, and applying them
+ * - State, topics, documents and queries over REST
+ * - Commands over REST, their errors and the rate limit
+ * - The token check
+ * - The WebSocket handshake, snapshot and coalesced updates
+ * - Queue changes pushed as splices, and subscriptions with a push interval
+ * - Commands and pings over a WebSocket
+ */
+class TestRemoteControlServer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testSpliceDiff();
+    void testAcceptKey();
+    void testRestState();
+    void testRestCommand();
+    void testCommandRateLimit();
+    void testToken();
+    void testWebSocketSnapshot();
+    void testUpdatesAreCoalesced();
+    void testArraysAreSpliced();
+    void testSubscribe();
+    void testWebSocketCommand();
+    void testPing();
+};
+
+#endif // TESTREMOTECONTROLSERVER_H
@@ -0,0 +1,185 @@
+#include "TestReplayGainStore.h"
+#include "../../../src/services/LoudnessScanner.h"
+#include "../../../src/services/ReplayGainStore.h"
+#include <QSignalSpy>
+#include <QSqlQuery>
+#include <QStringList>
+#include <QVariant>
+
+namespace {
+
+const char* CONNECTION_NAME = "test_replay_gain_store_connection";
+
+QVariant column(QSqlDatabase& database, const QString& path, const QString& name)
+{
+    QSqlQuery query(database);
+    query.prepare(QString("SELECT %1 FROM musics WHERE path = :path").arg(name));
+    query.bindValue(":path", path);
+    return query.exec() && query.next() ? query.value(0) : QVariant("missing");
+}
+
+} // namespace
+
+void TestReplayGainStore::init()
+{
+    m_tempDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_tempDir->isValid());
+
+    m_database = QSqlDatabase::addDatabase("QSQLITE", CONNECTION_NAME);
+    m_database.setDatabaseName(m_tempDir->filePath("test.db"));
+    QVERIFY(m_database.open());
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("CREATE TABLE musics (id INTEGER PRIMARY KEY, path TEXT)"));
+    QVERIFY(query.exec("INSERT INTO musics (path) VALUES "
+                       "('/music/a.ogg'), ('/music/b.ogg'), ('/music/broken.ogg')"));
+}
+
+void TestReplayGainStore::cleanup()
+{
+    if (m_database.isOpen()) {
+        m_database.close();
+    }
+    m_database = QSqlDatabase();
+    QSqlDatabase::removeDatabase(CONNECTION_NAME);
+    m_tempDir.reset();
+}
+
+void TestReplayGainStore::testAddsColumns()
+{
+    {
+        ReplayGainStore store(m_database);
+        QVERIFY(store.initialize());
+    }
+    ReplayGainStore store(m_database);
+    QVERIFY(store.initialize());
+
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("PRAGMA table_info(musics)"));
+    QStringList columns;
+    while (query.next()) {
+        columns << query.value(1).toString();
+    }
+    QCOMPARE(columns, QStringList({"id", "path", "loudness_lufs", "true_peak_dbtp"}));
+    QCOMPARE(store.count(), 0);
+    QVERIFY(column(m_database, "/music/a.ogg", "loudness_lufs").isNull());
+
+    QSqlQuery drop(m_database);
+    QVERIFY(drop.exec("DROP TABLE musics"));
+    ReplayGainStore orphan(m_database);
+    QVERIFY(!orphan.initialize());
+}
+
+void TestReplayGainStore::testStoresAndLoads()
+{
+    {
+        ReplayGainStore store(m_database);
+        QVERIFY(store.initialize());
+        store.setLoudness("/music/a.ogg", -9.5, 0.3);
+        store.setLoudness("/music/b.ogg", -24.0, -7.5);
+        QVERIFY(store.contains("/music/a.ogg"));
+        QVERIFY(!store.contains("/music/other.ogg"));
+        QVERIFY(store.flush());
+    }
+
+    QCOMPARE(column(m_database, "/music/a.ogg", "loudness_lufs").toDouble(), -9.5);
+    QCOMPARE(column(m_database, "/music/a.ogg", "true_peak_dbtp").toDouble(), 0.3);
+    QVERIFY(column(m_database, "/music/broken.ogg", "loudness_lufs").isNull());
+
+    ReplayGainStore store(m_database);
+    QVERIFY(store.initialize());
+    QCOMPARE(store.count(), 2);
+    QCOMPARE(store.loudness("/music/b.ogg").integratedLufs, -24.0);
+    QCOMPARE(store.loudness("/music/b.ogg").truePeakDbtp, -7.5);
+}
+
+void TestReplayGainStore::testGain()
+{
+    ReplayGainStore store(m_database);
+    QVERIFY(store.initialize());
+
+    // Loud tracks are cut all the way to the target
+    store.setLoudness("/music/loud.ogg", -8.0, 0.5);
+    QCOMPARE(store.gainDb("/music/loud.ogg"), -10.0);
+
+    // Quiet tracks are boosted only as far as their peak allows
+    store.setLoudness("/music/quiet.ogg", -24.0, -10.0);
+    QCOMPARE(store.gainDb("/music/quiet.ogg"), 6.0);
+    store.setLoudness("/music/peaky.ogg", -24.0, -3.0);
+    QCOMPARE(store.gainDb("/music/peaky.ogg"), 2.0);
+    store.setLoudness("/music/clipped.ogg", -24.0, 0.0);
+    QCOMPARE(store.gainDb("/music/clipped.ogg"), 0.0);
+
+    // and never by more than MAX_BOOST_DB
+    store.setLoudness("/music/whisper.ogg", -45.0, -30.0);
+    QCOMPARE(store.gainDb("/music/whisper.ogg"), ReplayGainStore::MAX_BOOST_DB);
+
+    QCOMPARE(store.gainDb("/music/unknown.ogg"), 0.0);
+
+    store.setTargetLufs(-23.0);
+    store.setPeakCeilingDbtp(-2.0);
+    QCOMPARE(store.gainDb("/music/loud.ogg"), -15.0);
+    QCOMPARE(store.gainDb("/music/peaky.ogg"), 1.0);
+}
+
+void TestReplayGainStore::testClearsAndRelocates()
+{
+    ReplayGainStore store(m_database);
+    QVERIFY(store.initialize());
+    store.setLoudness("/music/a.ogg", -12.0, -1.0);
+    QVERIFY(store.flush());
+
+    store.clear("/music/a.ogg");
+    QCOMPARE(store.count(), 0);
+    // Written on the next event loop iteration without an explicit flush()
+    QTRY_VERIFY(column(m_database, "/music/a.ogg", "loudness_lufs").isNull());
+    QVERIFY(column(m_database, "/music/a.ogg", "true_peak_dbtp").isNull());
+
+    store.setLoudness("/music/b.mp3", -20.0, -4.0);
+    store.relocate("/music/b.mp3", "/music/b.ogg");
+    QVERIFY(!store.contains("/music/b.mp3"));
+    QCOMPARE(store.gainDb("/music/b.ogg"), 2.0);
+
+    // The pending write follows it to the row that now has the path
+    QVERIFY(store.flush());
+    QCOMPARE(column(m_database, "/music/b.ogg", "loudness_lufs").toDouble(), -20.0);
+}
+
+void TestReplayGainStore::testScannerFillsStore()
+{
+    ReplayGainStore store(m_database);
+    QVERIFY(store.initialize());
+    store.setLoudness("/music/b.ogg", -14.0, -1.0);
+
+    LoudnessScanner scanner(&store);
+    scanner.setAnalyzer([](const QString& filePath, QString* error) {
+        LoudnessMeter::Result result;
+        if (filePath.contains("broken")) {
+            *error = "Invalid data";
+            return result;
+        }
+        result.valid = true;
+        // b.ogg turned out to be silence, so any old measurement goes
+        result.audible = !filePath.contains("b.ogg");
+        result.integratedLufs = -21.0;
+        result.truePeakDbtp = -6.0;
+        return result;
+    });
+    QSignalSpy measured(&scanner, &LoudnessScanner::trackMeasured);
+    QSignalSpy finished(&scanner, &LoudnessScanner::finished);
+
+    QCOMPARE(scanner.scan({"/music/a.ogg", "/music/b.ogg", "/music/broken.ogg"}), 3);
+    QVERIFY(finished.wait(5000));
+    QCOMPARE(finished.first().at(0).toInt(), 2);
+    QCOMPARE(finished.first().at(1).toInt(), 1);
+    QCOMPARE(measured.count(), 2);
+    QVERIFY(!scanner.isRunning());
+
+    QCOMPARE(store.gainDb("/music/a.ogg"), 3.0);
+    QVERIFY(!store.contains("/music/b.ogg"));
+    QVERIFY(!store.contains("/music/broken.ogg"));
+    // The scanner flushes when it finishes
+    QCOMPARE(column(m_database, "/music/a.ogg", "loudness_lufs").toDouble(), -21.0);
+    QVERIFY(column(m_database, "/music/b.ogg", "loudness_lufs").isNull());
+}
+
+QTEST_MAIN(TestReplayGainStore)
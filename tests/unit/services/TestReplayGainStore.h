@@ -0,0 +1,39 @@
+#ifndef TESTREPLAYGAINSTORE_H
+#define TESTREPLAYGAINSTORE_H
+
+#include <QObject>
+#include <QTest>
+#include <QSqlDatabase>
+#include <QTemporaryDir>
+#include <memory>
+
+/**
+ * @brief Unit tests for ReplayGainStore and LoudnessScanner classes
+ *
+ * Tests the loudness kept in the musics table including:
+ * - Adding the loudness columns to an existing musics table
+ * - Writing measurements back and loading them in a new store
+ * - The gain towards the target, limited by the peak ceiling and maximum boost
+ * - Clearing measurements to NULL and following a track to its new path
+ * - Scanning tracks into the store
+ */
+class TestReplayGainStore : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testAddsColumns();
+    void testStoresAndLoads();
+    void testGain();
+    void testClearsAndRelocates();
+    void testScannerFillsStore();
+
+private:
+    std::unique_ptr<QTemporaryDir> m_tempDir;
+    QSqlDatabase m_database;
+};
+
+#endif // TESTREPLAYGAINSTORE_H
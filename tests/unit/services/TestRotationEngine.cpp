@@ -0,0 +1,334 @@
+#include "TestRotationEngine.h"
+#include "../../../src/repositories/MusicRepository.h"
+#include "../../../src/services/RotationEngine.h"
+#include <QSet>
+#include <QSqlQuery>
+
+namespace {
+
+const char* CONNECTION_NAME = "test_rotation_engine_connection";
+
+} // namespace
+
+void TestRotationEngine::init()
+{
+    m_tempDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_tempDir->isValid());
+
+    m_database = QSqlDatabase::addDatabase("QSQLITE", CONNECTION_NAME);
+    m_database.setDatabaseName(m_tempDir->path() + "/rotation.db");
+    QVERIFY(m_database.open());
+
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("CREATE TABLE musics (id INTEGER PRIMARY KEY AUTOINCREMENT, artist TEXT, "
+                       "song TEXT, genre1 TEXT, genre2 TEXT, country TEXT, published_date TEXT, "
+                       "path TEXT, time TEXT, played_times INTEGER DEFAULT 0, last_played TEXT)"));
+    m_nextTrack = 1;
+}
+
+void TestRotationEngine::cleanup()
+{
+    if (m_database.isOpen()) {
+        m_database.close();
+    }
+    m_database = QSqlDatabase();
+    QSqlDatabase::removeDatabase(CONNECTION_NAME);
+    m_tempDir.reset();
+}
+
+void TestRotationEngine::testFullCycleWithoutRepeats()
+{
+    addTracks("Rock", 30);
+
+    RotationEngine rotation(m_database);
+    rotation.setSeed(1);
+
+    QSet<QString> played;
+    for (int i = 0; i < 30; ++i) {
+        QString path = rotation.nextTrack();
+        QVERIFY(!path.isEmpty());
+        QVERIFY2(!played.contains(path), qPrintable(path));
+        played.insert(path);
+    }
+    QCOMPARE(rotation.trackCount(), 30);
+}
+
+void TestRotationEngine::testSeparationAcrossCycles()
+{
+    addTracks("Pop", 12);
+
+    RotationEngine rotation(m_database);
+    rotation.setSeed(7);
+    rotation.setSeparation(8);
+
+    QStringList history;
+    for (int i = 0; i < 200; ++i) {
+        QString path = rotation.nextTrack();
+        const int previous = history.lastIndexOf(path);
+        if (previous >= 0) {
+            QVERIFY2(history.size() - previous > 8, qPrintable(path));
+        }
+        history.append(path);
+    }
+}
+
+void TestRotationEngine::testGenrePools()
+{
+    addTracks("Rock", 5);
+    addTracks("Jazz", 5);
+
+    RotationEngine rotation(m_database);
+    for (int i = 0; i < 20; ++i) {
+        QVERIFY(rotation.nextTrack("jazz").startsWith("/music/Jazz"));
+    }
+    QVERIFY(rotation.nextTrack("Polka").isEmpty());
+}
+
+void TestRotationEngine::testUpcoming()
+{
+    addTracks("Rock", 10);
+    addTracks("Jazz", 5);
+
+    RotationEngine rotation(m_database);
+    rotation.setSeparation(0);
+    const QStringList upcoming = rotation.upcoming("rock", 3);
+    QCOMPARE(upcoming.size(), 3);
+    QCOMPARE(rotation.upcoming("rock", 3), upcoming);   // Nothing was taken
+
+    for (const QString& path : upcoming) {
+        QCOMPARE(rotation.nextTrack("Rock"), path);
+    }
+    QCOMPARE(rotation.upcoming("Jazz", 10).size(), 5);
+    QVERIFY(rotation.upcoming("Polka", 3).isEmpty());
+}
+
+void TestRotationEngine::testSmallPoolStillRotates()
+{
+    addTracks("Rock", 2);
+
+    RotationEngine rotation(m_database);
+    rotation.setSeparation(50);
+
+    QString previous = rotation.nextTrack();
+    for (int i = 0; i < 10; ++i) {
+        QString path = rotation.nextTrack();
+        QVERIFY(!path.isEmpty());
+        QVERIFY(path != previous);
+        previous = path;
+    }
+}
+
+void TestRotationEngine::testMarkPlayed()
+{
+    addTracks("Rock", 2);
+
+    RotationEngine rotation(m_database);
+    rotation.reload();
+    rotation.markPlayed("/music/Rock-1.ogg");
+
+    for (int i = 0; i < 10; ++i) {
+        QString expected = i % 2 == 0 ? "/music/Rock-2.ogg" : "/music/Rock-1.ogg";
+        QCOMPARE(rotation.nextTrack(), expected);
+    }
+}
+
+void TestRotationEngine::testAddAndRemoveTrack()
+{
+    addTracks("Rock", 3);
+
+    RotationEngine rotation(m_database);
+    rotation.reload();
+
+    MusicItem added;
+    added.id = 100;
+    added.path = "/music/new.ogg";
+    added.genre1 = "Rock";
+    rotation.addTrack(added);
+    QCOMPARE(rotation.trackCount(), 4);
+
+    rotation.removeTrack(1);
+    QCOMPARE(rotation.trackCount(), 3);
+
+    QSet<QString> played;
+    for (int i = 0; i < 9; ++i) {
+        played.insert(rotation.nextTrack("Rock"));
+    }
+    QVERIFY(played.contains("/music/new.ogg"));
+    QVERIFY(!played.contains("/music/Rock-1.ogg"));
+    QCOMPARE(played.size(), 3);
+}
+
+void TestRotationEngine::testInvalidateReloads()
+{
+    addTracks("Rock", 1);
+
+    RotationEngine rotation(m_database);
+    QCOMPARE(rotation.nextTrack("Jazz"), QString());
+
+    addTracks("Jazz", 1);
+    QCOMPARE(rotation.nextTrack("Jazz"), QString());
+
+    rotation.invalidate();
+    QCOMPARE(rotation.nextTrack("Jazz"), QString("/music/Jazz-2.ogg"));
+}
+
+void TestRotationEngine::testFollowsRepositorySignals()
+{
+    addTracks("Rock", 2);
+
+    MusicRepository repository(m_database);
+    RotationEngine rotation(m_database);
+    rotation.reload();
+    // Wired as the player wires them
+    connect(&repository, &MusicRepository::musicAdded, &rotation, &RotationEngine::addTrack);
+    connect(&repository, &MusicRepository::musicUpdated, &rotation,
+            &RotationEngine::updateTrack);
+    connect(&repository, &MusicRepository::musicDeleted, &rotation,
+            &RotationEngine::removeTrack);
+
+    MusicItem added;
+    added.id = 100;
+    added.path = "/music/new.ogg";
+    added.genre1 = "Jazz";
+    emit repository.musicAdded(added);
+    QCOMPARE(rotation.trackCount(), 3);
+    QCOMPARE(rotation.nextTrack("Jazz"), QString("/music/new.ogg"));
+
+    // Moved to another genre, the track leaves its old pool
+    added.genre1 = "Blues";
+    emit repository.musicUpdated(added);
+    QCOMPARE(rotation.trackCount(), 3);
+    QCOMPARE(rotation.nextTrack("Jazz"), QString());
+    QCOMPARE(rotation.nextTrack("Blues"), QString("/music/new.ogg"));
+
+    emit repository.musicDeleted(1);
+    QCOMPARE(rotation.trackCount(), 2);
+    QSet<QString> played;
+    for (int i = 0; i < 4; ++i) {
+        played.insert(rotation.nextTrack("Rock"));
+    }
+    QCOMPARE(played, QSet<QString>({"/music/Rock-2.ogg"}));
+}
+
+void TestRotationEngine::testArtistSeparation()
+{
+    addTrack("Artist A", "One");
+    addTrack("Artist A", "Two");
+    addTrack("Artist B", "Three");
+    addTrack("Artist C", "Four");
+    addTrack("Artist D", "Five");
+    addTrack("Artist E", "Six");
+
+    // Songs 20 minutes apart: an artist may only come back after two others
+    QDateTime at(QDate(2026, 10, 14), QTime(8, 0));
+    for (quint32 seed = 1; seed <= 20; ++seed) {
+        RotationEngine rotation(m_database);
+        rotation.setSeed(seed);
+        rotation.setSeparation(0);
+        rotation.setArtistSeparation(60);
+
+        QStringList artists;
+        for (int i = 0; i < 5; ++i, at = at.addSecs(20 * 60)) {
+            artists.append(rotation.nextTrack(QString(), at).section('/', 2, 2));
+        }
+        QCOMPARE(artists.size(), 5);
+        for (int i = 1; i < artists.size(); ++i) {
+            QVERIFY2(artists[i] != artists[i - 1], qPrintable(artists.join(',')));
+            QVERIFY2(i < 2 || artists[i] != artists[i - 2], qPrintable(artists.join(',')));
+        }
+        QCOMPARE(rotation.relaxedPicks(), 0);
+    }
+
+    // A song played by hand counts from when it aired
+    for (quint32 seed = 1; seed <= 10; ++seed) {
+        RotationEngine rotation(m_database);
+        rotation.setSeed(seed);
+        rotation.setSeparation(0);
+        rotation.setArtistSeparation(60);
+        rotation.reload();
+        const QStringList played = {"/music/Artist A/One.ogg", "/music/Artist A/Two.ogg",
+                                    "/music/Artist B/Three.ogg", "/music/Artist C/Four.ogg"};
+        for (const QString& path : played) {
+            rotation.markPlayed(path, at);
+        }
+        const QString path = rotation.nextTrack(QString(), at.addSecs(10 * 60));
+        QVERIFY2(path.contains("Artist D") || path.contains("Artist E"), qPrintable(path));
+    }
+}
+
+void TestRotationEngine::testArtistSeparationRelaxed()
+{
+    addTrack("Artist A", "One");
+    addTrack("Artist A", "Two");
+
+    RotationEngine rotation(m_database);
+    rotation.setSeparation(0);
+    rotation.setArtistSeparation(60);
+    rotation.setTitleSeparation(180);
+
+    // A one-artist pool still plays, always the song that aired longest ago
+    QDateTime at(QDate(2026, 10, 14), QTime(8, 0));
+    const QString first = rotation.nextTrack(QString(), at);
+    const QString second = rotation.nextTrack(QString(), at.addSecs(240));
+    const QString third = rotation.nextTrack(QString(), at.addSecs(480));
+    QVERIFY(!first.isEmpty());
+    QVERIFY(second != first);
+    QCOMPARE(third, first);
+    QCOMPARE(rotation.relaxedPicks(), 2);
+}
+
+void TestRotationEngine::testRelaxesOnlyAfterReshuffle()
+{
+    addTrack("Artist A", "One");
+    addTrack("Artist B", "Two");
+
+    RotationEngine rotation(m_database);
+    rotation.setSeparation(0);
+    rotation.setArtistSeparation(60);
+
+    // The rest of the cycle aired by hand just before, but the song taken
+    // first is spaced again once the cycle starts over
+    QDateTime at(QDate(2026, 10, 14), QTime(8, 0));
+    const QString first = rotation.nextTrack(QString(), at);
+    const QString other = first.contains("Artist A") ? QString("/music/Artist B/Two.ogg")
+                                                     : QString("/music/Artist A/One.ogg");
+    rotation.markPlayed(other, at.addSecs(50 * 60));
+    QCOMPARE(rotation.nextTrack(QString(), at.addSecs(61 * 60)), first);
+    QCOMPARE(rotation.relaxedPicks(), 0);
+
+    // Reported when it went on air, a pick still counts from when it was taken
+    rotation.markPlayed(first, at.addSecs(75 * 60));
+    QCOMPARE(rotation.nextTrack(QString(), at.addSecs(111 * 60)), other);
+    QCOMPARE(rotation.nextTrack(QString(), at.addSecs(122 * 60)), first);
+    QCOMPARE(rotation.relaxedPicks(), 0);
+}
+
+void TestRotationEngine::addTrack(const QString& artist, const QString& song)
+{
+    QSqlQuery query(m_database);
+    query.prepare("INSERT INTO musics (id, artist, song, genre1, path) VALUES (?, ?, ?, ?, ?)");
+    const int id = m_nextTrack++;
+    query.addBindValue(id);
+    query.addBindValue(artist);
+    query.addBindValue(song);
+    query.addBindValue("Pop");
+    query.addBindValue(QString("/music/%1/%2.ogg").arg(artist, song));
+    QVERIFY(query.exec());
+}
+
+void TestRotationEngine::addTracks(const QString& genre, int count)
+{
+    QSqlQuery query(m_database);
+    query.prepare("INSERT INTO musics (id, artist, song, genre1, path) VALUES (?, ?, ?, ?, ?)");
+    for (int i = 0; i < count; ++i) {
+        const int id = m_nextTrack++;
+        query.addBindValue(id);
+        query.addBindValue("Artist");
+        query.addBindValue(QString("Song %1").arg(id));
+        query.addBindValue(genre);
+        query.addBindValue(QString("/music/%1-%2.ogg").arg(genre).arg(id));
+        QVERIFY(query.exec());
+    }
+}
+
+QTEST_MAIN(TestRotationEngine)
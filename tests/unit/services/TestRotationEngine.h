@@ -0,0 +1,53 @@
+#ifndef TESTROTATIONENGINE_H
+#define TESTROTATIONENGINE_H
+
+#include <QObject>
+#include <QTest>
+#include <QSqlDatabase>
+#include <QTemporaryDir>
+#include <memory>
+
+/**
+ * @brief Unit tests for RotationEngine class
+ *
+ * Tests the auto mode rotation including:
+ * - Playing a whole pool before repeating
+ * - Honouring the separation window across reshuffles
+ * - Case-insensitive genre pools and unknown genres
+ * - Forecasting the next picks without taking them
+ * - Incremental additions, removals and reloads
+ * - Following the add, update and delete signals of MusicRepository
+ * - Keeping artists and titles apart by time, and relaxing when none is
+ * - Relaxing only when a reshuffled cycle holds no spaced song either
+ */
+class TestRotationEngine : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testFullCycleWithoutRepeats();
+    void testSeparationAcrossCycles();
+    void testGenrePools();
+    void testUpcoming();
+    void testSmallPoolStillRotates();
+    void testMarkPlayed();
+    void testAddAndRemoveTrack();
+    void testInvalidateReloads();
+    void testFollowsRepositorySignals();
+    void testArtistSeparation();
+    void testArtistSeparationRelaxed();
+    void testRelaxesOnlyAfterReshuffle();
+
+private:
+    void addTracks(const QString& genre, int count);
+    void addTrack(const QString& artist, const QString& song);
+
+    std::unique_ptr<QTemporaryDir> m_tempDir;
+    QSqlDatabase m_database;
+    int m_nextTrack = 1;
+};
+
+#endif // TESTROTATIONENGINE_H
@@ -0,0 +1,453 @@
+#include "TestSchedulerEngine.h"
+#include "../../../src/services/SchedulerEngine.h"
+#include <QElapsedTimer>
+#include <QSignalSpy>
+#include <QSqlQuery>
+
+namespace {
+
+const char* CONNECTION_NAME = "test_scheduler_engine_connection";
+
+QString weekdayName(const QDate& date)
+{
+    static const char* const names[] = {"Monday", "Tuesday", "Wednesday", "Thursday",
+                                        "Friday", "Saturday", "Sunday"};
+    return names[date.dayOfWeek() - 1];
+}
+
+// The show lasts two hours, every pub 30 s
+qint64 durationUs(const QString& filePath)
+{
+    return filePath.contains("show") ? qint64(2) * 3600 * 1000000 : 30 * 1000000;
+}
+
+ScheduleRule weekly(qint64 rowId, int dayOfWeek, int hour, int minute, bool isProgram)
+{
+    ScheduleRule rule;
+    rule.rowId = rowId;
+    rule.type = ScheduleRule::Type::Weekly;
+    rule.dayOfWeek = dayOfWeek;
+    rule.hour = hour;
+    rule.minute = minute;
+    rule.isProgram = isProgram;
+    rule.path = isProgram ? "/programs/show.ogg" : "/pub/ad.ogg";
+    return rule;
+}
+
+QList<qint64> rowIds(const QList<ScheduleRule>& rules)
+{
+    QList<qint64> ids;
+    for (const ScheduleRule& rule : rules) {
+        ids << rule.rowId;
+    }
+    return ids;
+}
+
+} // namespace
+
+void TestSchedulerEngine::init()
+{
+    m_tempDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_tempDir->isValid());
+
+    m_database = QSqlDatabase::addDatabase("QSQLITE", CONNECTION_NAME);
+    m_database.setDatabaseName(m_tempDir->path() + "/scheduler.db");
+    QVERIFY(m_database.open());
+
+    exec("CREATE TABLE pub (id INTEGER PRIMARY KEY AUTOINCREMENT, name TEXT, path TEXT)");
+    exec("CREATE TABLE programs (id INTEGER PRIMARY KEY AUTOINCREMENT, name TEXT, path TEXT)");
+    exec("CREATE TABLE scheduler (id INTEGER, ano INTEGER, mes INTEGER, dia INTEGER, hora INTEGER, "
+         "min INTEGER, tipo INTEGER, week_day TEXT, start_ano INTEGER, start_mes INTEGER, "
+         "start_dia INTEGER, end_ano INTEGER, end_mes INTEGER, end_dia INTEGER, is_program NULL)");
+    exec("INSERT INTO pub (id, name, path) VALUES (1, 'Ad', '/pub/ad.ogg')");
+    exec("INSERT INTO programs (id, name, path) VALUES (1, 'Show', '/programs/show.ogg')");
+}
+
+void TestSchedulerEngine::cleanup()
+{
+    if (m_database.isOpen()) {
+        m_database.close();
+    }
+    m_database = QSqlDatabase();
+    QSqlDatabase::removeDatabase(CONNECTION_NAME);
+    m_tempDir.reset();
+}
+
+void TestSchedulerEngine::testNextOccurrenceOnce()
+{
+    ScheduleRule rule;
+    rule.type = ScheduleRule::Type::Once;
+    rule.at = QDateTime(QDate(2024, 5, 17), QTime(14, 30));
+
+    QCOMPARE(SchedulerEngine::nextOccurrence(rule, QDateTime(QDate(2024, 5, 17), QTime(9, 0))), rule.at);
+    // Still due during its minute
+    QCOMPARE(SchedulerEngine::nextOccurrence(rule, QDateTime(QDate(2024, 5, 17), QTime(14, 30, 40))), rule.at);
+    QVERIFY(!SchedulerEngine::nextOccurrence(rule, QDateTime(QDate(2024, 5, 17), QTime(14, 31))).isValid());
+}
+
+void TestSchedulerEngine::testNextOccurrenceWeekly()
+{
+    ScheduleRule rule;
+    rule.type = ScheduleRule::Type::Weekly;
+    rule.dayOfWeek = Qt::Friday;
+    rule.hour = 8;
+    rule.minute = 15;
+
+    // 2024-05-15 is a Wednesday
+    const QDateTime wednesday(QDate(2024, 5, 15), QTime(12, 0));
+    QCOMPARE(SchedulerEngine::nextOccurrence(rule, wednesday), QDateTime(QDate(2024, 5, 17), QTime(8, 15)));
+
+    const QDateTime afterFriday(QDate(2024, 5, 17), QTime(8, 16));
+    QCOMPARE(SchedulerEngine::nextOccurrence(rule, afterFriday), QDateTime(QDate(2024, 5, 24), QTime(8, 15)));
+
+    rule.dayOfWeek = 0;
+    QVERIFY(!SchedulerEngine::nextOccurrence(rule, wednesday).isValid());
+}
+
+void TestSchedulerEngine::testLoadRules()
+{
+    const QDate tomorrow = QDate::currentDate().addDays(1);
+    exec(QString("INSERT INTO scheduler VALUES ('1', '%1', '%2', '%3', '10', '05', '1', NULL, NULL, NULL, "
+                 "NULL, NULL, NULL, NULL, '0')")
+             .arg(tomorrow.year())
+             .arg(tomorrow.month())
+             .arg(tomorrow.day()));
+    exec(QString("INSERT INTO scheduler VALUES ('1', NULL, NULL, NULL, '9', '0', '2', '%1', NULL, NULL, "
+                 "NULL, NULL, NULL, NULL, '1')")
+             .arg(weekdayName(tomorrow)));
+
+    SchedulerEngine engine(m_database);
+    QVERIFY(engine.reload());
+    QCOMPARE(engine.ruleCount(), 2);
+    QCOMPARE(engine.nextFireTime(), QDateTime(tomorrow, QTime(9, 0)));
+}
+
+void TestSchedulerEngine::testWeeklyEventFiresAndReschedules()
+{
+    // Due in the current minute, so it fires right away
+    const QDateTime now = QDateTime::currentDateTime();
+    exec(QString("INSERT INTO scheduler VALUES ('1', NULL, NULL, NULL, '%1', '%2', '2', '%3', NULL, NULL, "
+                 "NULL, NULL, NULL, NULL, '1')")
+             .arg(now.time().hour())
+             .arg(now.time().minute())
+             .arg(weekdayName(now.date())));
+
+    SchedulerEngine engine(m_database);
+    QSignalSpy spy(&engine, &SchedulerEngine::eventDue);
+    QVERIFY(engine.reload());
+
+    engine.processDue(now);
+    QCOMPARE(spy.count(), 1);
+    const ScheduledEvent event = spy.first().first().value<ScheduledEvent>();
+    QCOMPARE(event.rule.path, QString("/programs/show.ogg"));
+
+    const QDateTime fired = QDateTime(now.date(), QTime(now.time().hour(), now.time().minute()));
+    QCOMPARE(engine.nextFireTime(), fired.addDays(7));
+
+    engine.processDue(now);
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(count("SELECT COUNT(*) FROM scheduler"), 1);
+}
+
+void TestSchedulerEngine::testOnceEventRetiresPub()
+{
+    const QDateTime now = QDateTime::currentDateTime();
+    exec(QString("INSERT INTO scheduler VALUES ('1', '%1', '%2', '%3', '%4', '%5', '1', NULL, NULL, NULL, "
+                 "NULL, NULL, NULL, NULL, '0')")
+             .arg(now.date().year())
+             .arg(now.date().month())
+             .arg(now.date().day())
+             .arg(now.time().hour())
+             .arg(now.time().minute()));
+
+    SchedulerEngine engine(m_database);
+    QSignalSpy dueSpy(&engine, &SchedulerEngine::eventDue);
+    QSignalSpy removedSpy(&engine, &SchedulerEngine::pubRemoved);
+    QVERIFY(engine.reload());
+
+    engine.processDue(now);
+    QCOMPARE(dueSpy.count(), 1);
+    QCOMPARE(dueSpy.first().first().value<ScheduledEvent>().rule.path, QString("/pub/ad.ogg"));
+    QCOMPARE(removedSpy.count(), 1);
+    QCOMPARE(count("SELECT COUNT(*) FROM scheduler"), 0);
+    QCOMPARE(count("SELECT COUNT(*) FROM pub"), 0);
+    QCOMPARE(engine.ruleCount(), 0);
+    QVERIFY(!engine.nextFireTime().isValid());
+}
+
+void TestSchedulerEngine::testMarkFiredSkipsEvent()
+{
+    const QDateTime now = QDateTime::currentDateTime();
+    exec(QString("INSERT INTO scheduler VALUES ('1', NULL, NULL, NULL, '%1', '%2', '2', '%3', NULL, NULL, "
+                 "NULL, NULL, NULL, NULL, '1')")
+             .arg(now.time().hour())
+             .arg(now.time().minute())
+             .arg(weekdayName(now.date())));
+
+    SchedulerEngine engine(m_database);
+    QSignalSpy spy(&engine, &SchedulerEngine::eventDue);
+    QVERIFY(engine.reload());
+    const QList<ScheduledEvent> events = engine.upcomingEvents(now.addSecs(-60), now.addSecs(60));
+    QCOMPARE(events.size(), 1);
+    const qint64 rowId = events.first().rule.rowId;
+
+    // The journal of the run before the restart says it already played
+    const QDateTime fired = QDateTime(now.date(), QTime(now.time().hour(), now.time().minute()));
+    QVERIFY(!engine.markFired(rowId, fired.addSecs(-60)));
+    QVERIFY(engine.markFired(rowId, fired));
+    QVERIFY(!engine.markFired(rowId, fired));
+    QCOMPARE(engine.nextFireTime(), fired.addDays(7));
+
+    engine.processDue(now);
+    QCOMPARE(spy.count(), 0);
+}
+
+void TestSchedulerEngine::testReloadKeepsUnchangedRules()
+{
+    const QDateTime now = QDateTime::currentDateTime();
+    exec(QString("INSERT INTO scheduler VALUES ('1', NULL, NULL, NULL, '%1', '%2', '2', '%3', NULL, NULL, "
+                 "NULL, NULL, NULL, NULL, '0')")
+             .arg(now.time().hour())
+             .arg(now.time().minute())
+             .arg(weekdayName(now.date())));
+
+    SchedulerEngine engine(m_database);
+    QSignalSpy spy(&engine, &SchedulerEngine::eventDue);
+    QVERIFY(engine.reload());
+    engine.processDue(now);
+    QCOMPARE(spy.count(), 1);
+
+    // The weekly rule already fired this minute and must not fire again
+    QVERIFY(engine.reload());
+    engine.processDue(now);
+    QCOMPARE(spy.count(), 1);
+
+    // An edited rule is recomputed
+    exec("UPDATE scheduler SET hora = 23, min = 59, week_day = 'Sunday'");
+    QVERIFY(engine.reload());
+    QCOMPARE(engine.nextFireTime().time(), QTime(23, 59));
+    QCOMPARE(engine.nextFireTime().date().dayOfWeek(), int(Qt::Sunday));
+}
+
+void TestSchedulerEngine::testUpcomingEvents()
+{
+    const QDate tomorrow = QDate::currentDate().addDays(1);
+    exec(QString("INSERT INTO scheduler VALUES ('1', NULL, NULL, NULL, '9', '0', '2', '%1', NULL, NULL, "
+                 "NULL, NULL, NULL, NULL, '1')")
+             .arg(weekdayName(tomorrow)));
+    exec(QString("INSERT INTO scheduler VALUES ('1', '%1', '%2', '%3', '8', '30', '1', NULL, NULL, NULL, "
+                 "NULL, NULL, NULL, NULL, '0')")
+             .arg(tomorrow.year())
+             .arg(tomorrow.month())
+             .arg(tomorrow.day()));
+
+    SchedulerEngine engine(m_database);
+    QVERIFY(engine.reload());
+
+    const QDateTime from(QDate::currentDate(), QTime(0, 0));
+    const QList<ScheduledEvent> events = engine.upcomingEvents(QDateTime::currentDateTime(), from.addDays(16));
+    QCOMPARE(events.size(), 4);
+    QCOMPARE(events.at(0).fireAt, QDateTime(tomorrow, QTime(8, 30)));
+    QCOMPARE(events.at(0).rule.path, QString("/pub/ad.ogg"));
+    QCOMPARE(events.at(1).fireAt, QDateTime(tomorrow, QTime(9, 0)));
+    QCOMPARE(events.at(2).fireAt, QDateTime(tomorrow.addDays(7), QTime(9, 0)));
+    QCOMPARE(events.at(3).fireAt, QDateTime(tomorrow.addDays(14), QTime(9, 0)));
+
+    const QList<ScheduledEvent> morning =
+        engine.upcomingEvents(QDateTime(tomorrow, QTime(8, 0)), QDateTime(tomorrow, QTime(9, 0)));
+    QCOMPARE(morning.size(), 1);
+    QVERIFY(engine.upcomingEvents(from.addDays(2), from).isEmpty());
+}
+
+void TestSchedulerEngine::testUpcomingEventsSkipsFired()
+{
+    const QDateTime now = QDateTime::currentDateTime();
+    exec(QString("INSERT INTO scheduler VALUES ('1', NULL, NULL, NULL, '%1', '%2', '2', '%3', NULL, NULL, "
+                 "NULL, NULL, NULL, NULL, '1')")
+             .arg(now.time().hour())
+             .arg(now.time().minute())
+             .arg(weekdayName(now.date())));
+
+    SchedulerEngine engine(m_database);
+    QVERIFY(engine.reload());
+    QCOMPARE(engine.upcomingEvents(now, now.addDays(1)).size(), 1);
+
+    engine.processDue(now);
+    QVERIFY(engine.upcomingEvents(now, now.addDays(1)).isEmpty());
+    QCOMPARE(engine.upcomingEvents(now, now.addDays(8)).size(), 1);
+}
+
+void TestSchedulerEngine::testWeekOnSimulatedClock()
+{
+    // A pub on the hour and a program on the half hour, every day of the week
+    QVERIFY(m_database.transaction());
+    const QDate monday(2024, 5, 13);
+    for (int day = 0; day < 7; ++day) {
+        for (int hour = 0; hour < 24; ++hour) {
+            exec(QString("INSERT INTO scheduler VALUES ('1', NULL, NULL, NULL, '%1', '0', '2', '%2', "
+                         "NULL, NULL, NULL, NULL, NULL, NULL, '0')")
+                     .arg(hour)
+                     .arg(weekdayName(monday.addDays(day))));
+            exec(QString("INSERT INTO scheduler VALUES ('1', NULL, NULL, NULL, '%1', '30', '2', '%2', "
+                         "NULL, NULL, NULL, NULL, NULL, NULL, '1')")
+                     .arg(hour)
+                     .arg(weekdayName(monday.addDays(day))));
+        }
+    }
+    QVERIFY(m_database.commit());
+
+    // From the last minute of a Sunday, so the week holds each rule once
+    SimulatedClock clock(QDateTime(monday.addDays(-1), QTime(23, 59)));
+    SchedulerEngine engine(m_database);
+    engine.setClock(&clock);
+    QCOMPARE(engine.clock(), &clock);
+
+    int events = 0;
+    qint64 worstJitterMs = 0;
+    QDateTime last;
+    connect(&engine, &SchedulerEngine::eventDue, this, [&](const ScheduledEvent& event) {
+        ++events;
+        worstJitterMs = qMax(worstJitterMs, qAbs(clock.nowMs() - event.fireAt.toMSecsSinceEpoch()));
+        QVERIFY(!last.isValid() || event.fireAt > last);
+        last = event.fireAt;
+    });
+    QVERIFY(engine.start());
+
+    QElapsedTimer elapsed;
+    elapsed.start();
+    clock.advance(7 * 24 * 60 * 60 * 1000LL);
+    const qint64 elapsedMs = qMax<qint64>(1, elapsed.elapsed());
+
+    QCOMPARE(events, 7 * 24 * 2);
+    QCOMPARE(worstJitterMs, qint64(0));
+    QCOMPARE(last, QDateTime(monday.addDays(6), QTime(23, 30)));
+    QCOMPARE(engine.nextFireTime(), QDateTime(monday.addDays(7), QTime(0, 0)));
+    qDebug() << "A week of" << events << "events replayed in" << elapsedMs << "ms,"
+             << events * 1000 / elapsedMs << "events/s";
+}
+
+void TestSchedulerEngine::testConflicts()
+{
+    QDate friday = QDate::currentDate().addDays(1);
+    while (friday.dayOfWeek() != Qt::Friday) {
+        friday = friday.addDays(1);
+    }
+    addWeekly(1, "Friday", 20, 0, true);    // Until 22:00
+    addWeekly(1, "Friday", 21, 0, false);   // During the show
+    addWeekly(1, "Friday", 23, 0, false);   // After it
+    exec(QString("INSERT INTO scheduler VALUES ('1', '%1', '%2', '%3', '21', '30', '1', NULL, "
+                 "NULL, NULL, NULL, NULL, NULL, NULL, '0')")
+             .arg(friday.year())
+             .arg(friday.month())
+             .arg(friday.day()));
+    addWeekly(1, "Monday", 0, 30, false);
+
+    SchedulerEngine engine(m_database);
+    engine.setDurationLookup(durationUs);
+    QVERIFY(engine.reload());
+
+    QCOMPARE(rowIds(engine.conflicts(weekly(1, Qt::Friday, 20, 0, true))),
+             QList<qint64>({2, 4}));
+    QCOMPARE(rowIds(engine.conflicts(weekly(2, Qt::Friday, 21, 0, false))), QList<qint64>({1}));
+    QVERIFY(engine.conflicts(weekly(3, Qt::Friday, 23, 0, false)).isEmpty());
+
+    // A rule not added yet, running past Sunday night into the Monday pub
+    QCOMPARE(rowIds(engine.conflicts(weekly(-1, Qt::Sunday, 23, 30, true))), QList<qint64>({5}));
+
+    // A one-shot rule meets the weekly rules of its day and the one-shot rules of its date
+    ScheduleRule once;
+    once.type = ScheduleRule::Type::Once;
+    once.at = QDateTime(friday, QTime(21, 30));
+    once.path = "/pub/ad.ogg";
+    QCOMPARE(rowIds(engine.conflicts(once)), QList<qint64>({1, 4}));
+    once.at = once.at.addDays(7);
+    QCOMPARE(rowIds(engine.conflicts(once)), QList<qint64>({1}));
+
+    QCOMPARE(SchedulerEngine::describe(weekly(1, Qt::Friday, 20, 0, true)),
+             QString("Fridays at 20:00 (show.ogg)"));
+}
+
+void TestSchedulerEngine::testConflictsFollowReload()
+{
+    addWeekly(1, "Friday", 20, 0, true);
+    addWeekly(1, "Friday", 21, 0, false);
+    addWeekly(1, "Friday", 23, 0, false);
+
+    SchedulerEngine engine(m_database);
+    engine.setDurationLookup(durationUs);
+    QVERIFY(engine.reload());
+    const ScheduleRule show = weekly(1, Qt::Friday, 20, 0, true);
+    QCOMPARE(rowIds(engine.conflicts(show)), QList<qint64>({2}));
+
+    exec("UPDATE scheduler SET hora = 21, min = 45 WHERE rowid = 3");
+    exec("DELETE FROM scheduler WHERE rowid = 2");
+    QVERIFY(engine.reload());
+    QCOMPARE(rowIds(engine.conflicts(show)), QList<qint64>({3}));
+
+    // The show moved away from everything
+    exec("UPDATE scheduler SET week_day = 'Saturday' WHERE rowid = 1");
+    QVERIFY(engine.reload());
+    QVERIFY(engine.conflicts(weekly(3, Qt::Friday, 21, 45, false)).isEmpty());
+    QVERIFY(engine.conflicts(weekly(1, Qt::Saturday, 20, 0, true)).isEmpty());
+}
+
+void TestSchedulerEngine::testConflictsAtScale()
+{
+    // Without a duration lookup every rule takes its minute, so rules
+    // conflict exactly when they share day, hour and minute
+    const int rules = 5000;
+    QHash<int, int> perMinute;
+    m_database.transaction();
+    for (int i = 0; i < rules; ++i) {
+        const int dayOfWeek = 1 + i % 7;
+        const int hour = (i / 7) % 24;
+        const int minute = (i * 37) % 60;
+        addWeekly(1, weekdayName(QDate(2024, 5, 12).addDays(dayOfWeek)), hour, minute, false);
+        ++perMinute[(dayOfWeek * 24 + hour) * 60 + minute];
+    }
+    m_database.commit();
+
+    SchedulerEngine engine(m_database);
+    QVERIFY(engine.reload());
+    QCOMPARE(engine.ruleCount(), rules);
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < rules; ++i) {
+        const int dayOfWeek = 1 + i % 7;
+        const int hour = (i / 7) % 24;
+        const int minute = (i * 37) % 60;
+        const QList<ScheduleRule> found =
+            engine.conflicts(weekly(i + 1, dayOfWeek, hour, minute, false));
+        QCOMPARE(found.size(), perMinute.value((dayOfWeek * 24 + hour) * 60 + minute) - 1);
+    }
+    const qint64 elapsedMs = timer.elapsed();
+    QVERIFY2(elapsedMs < 2000, qPrintable(QString("%1 ms").arg(elapsedMs)));
+    qDebug() << rules << "conflict queries in" << elapsedMs << "ms";
+}
+
+void TestSchedulerEngine::exec(const QString& sql)
+{
+    QSqlQuery query(m_database);
+    QVERIFY2(query.exec(sql), qPrintable(sql));
+}
+
+void TestSchedulerEngine::addWeekly(int itemId, const QString& day, int hour, int minute,
+                                    bool isProgram)
+{
+    exec(QString("INSERT INTO scheduler VALUES ('%1', NULL, NULL, NULL, '%2', '%3', '2', '%4', "
+                 "NULL, NULL, NULL, NULL, NULL, NULL, '%5')")
+             .arg(itemId)
+             .arg(hour)
+             .arg(minute)
+             .arg(day)
+             .arg(isProgram ? 1 : 0));
+}
+
+int TestSchedulerEngine::count(const QString& sql)
+{
+    QSqlQuery query(m_database);
+    return query.exec(sql) && query.next() ? query.value(0).toInt() : -1;
+}
+
+QTEST_MAIN(TestSchedulerEngine)
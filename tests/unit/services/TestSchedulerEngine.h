@@ -0,0 +1,55 @@
+#ifndef TESTSCHEDULERENGINE_H
+#define TESTSCHEDULERENGINE_H
+
+#include <QObject>
+#include <QTest>
+#include <QSqlDatabase>
+#include <QTemporaryDir>
+#include <memory>
+
+/**
+ * @brief Unit tests for SchedulerEngine class
+ *
+ * Tests the heap based scheduler including:
+ * - Next occurrence of one-shot and weekly rules
+ * - Loading rules with their pub and program paths
+ * - Firing due events and rescheduling weekly rules
+ * - Retiring fired one-shot rules and their pubs
+ * - Firings already played before a restart, skipped
+ * - Keeping unchanged rules across reloads
+ * - Look-ahead expansion of rules into upcoming events
+ * - A week of events replayed on a simulated clock, each at its minute
+ * - Rules on air at the same time, following reloads, and at scale
+ */
+class TestSchedulerEngine : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testNextOccurrenceOnce();
+    void testNextOccurrenceWeekly();
+    void testLoadRules();
+    void testWeeklyEventFiresAndReschedules();
+    void testOnceEventRetiresPub();
+    void testMarkFiredSkipsEvent();
+    void testReloadKeepsUnchangedRules();
+    void testUpcomingEvents();
+    void testUpcomingEventsSkipsFired();
+    void testWeekOnSimulatedClock();
+    void testConflicts();
+    void testConflictsFollowReload();
+    void testConflictsAtScale();
+
+private:
+    void exec(const QString& sql);
+    void addWeekly(int itemId, const QString& day, int hour, int minute, bool isProgram);
+    int count(const QString& sql);
+
+    std::unique_ptr<QTemporaryDir> m_tempDir;
+    QSqlDatabase m_database;
+};
+
+#endif // TESTSCHEDULERENGINE_H
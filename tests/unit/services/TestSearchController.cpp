@@ -0,0 +1,195 @@
+#include "TestSearchController.h"
+#include "../../../src/services/MusicCache.h"
+#include "../../../src/services/SearchController.h"
+#include <QSignalSpy>
+#include <QSqlQuery>
+
+namespace {
+
+const char* CONNECTION_NAME = "test_search_controller_connection";
+
+SearchController::Result resultAt(const QSignalSpy& spy, int index)
+{
+    return spy.at(index).at(0).value<SearchController::Result>();
+}
+
+} // namespace
+
+void TestSearchController::init()
+{
+    qRegisterMetaType<SearchController::Result>();
+    m_tempDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_tempDir->isValid());
+
+    m_database = QSqlDatabase::addDatabase("QSQLITE", CONNECTION_NAME);
+    m_database.setDatabaseName(m_tempDir->path() + "/library.db");
+    QVERIFY(m_database.open());
+
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("CREATE TABLE musics (id INTEGER PRIMARY KEY AUTOINCREMENT, artist TEXT, "
+                       "song TEXT, genre1 TEXT, genre2 TEXT, country TEXT, published_date TEXT, "
+                       "path TEXT, time TEXT, played_times INTEGER DEFAULT 0, last_played TEXT)"));
+    m_fullText = MusicRepository::ensureFullTextIndex(m_database);
+
+    addTrack("The Beatles", "Yellow Submarine", "Pop");
+    addTrack("The Beatles", "Let It Be", "Pop");
+    addTrack("Beyoncé", "Halo", "R&B");
+    addTrack("AC/DC", "Back in Black", "Rock");
+}
+
+void TestSearchController::cleanup()
+{
+    if (m_database.isOpen()) {
+        m_database.close();
+    }
+    m_database = QSqlDatabase();
+    QSqlDatabase::removeDatabase(CONNECTION_NAME);
+    m_tempDir.reset();
+}
+
+void TestSearchController::addTrack(const QString& artist, const QString& song,
+                                    const QString& genre)
+{
+    QSqlQuery query(m_database);
+    query.prepare("INSERT INTO musics (artist, song, genre1, path) VALUES (?, ?, ?, ?)");
+    query.addBindValue(artist);
+    query.addBindValue(song);
+    query.addBindValue(genre);
+    query.addBindValue(QString("/music/%1 - %2.ogg").arg(artist, song));
+    QVERIFY(query.exec());
+}
+
+void TestSearchController::testCondition()
+{
+    QVariantList values;
+    QVERIFY(SearchController::condition("  ", true, values).isEmpty());
+    QVERIFY(values.isEmpty());
+
+    QVERIFY(SearchController::condition("beat yel", true, values).contains("MATCH ?"));
+    QCOMPARE(values, QVariantList({MusicRepository::fullTextQuery("beat yel")}));
+
+    // Without the index, or without a word to index, the text is a LIKE pattern
+    QCOMPARE(SearchController::condition("it's", false, values),
+             QString("artist LIKE ? OR song LIKE ?"));
+    QCOMPARE(values, QVariantList({"%it's%", "%it's%"}));
+    QCOMPARE(SearchController::condition("--", true, values),
+             QString("artist LIKE ? OR song LIKE ?"));
+}
+
+void TestSearchController::testIsRefinement()
+{
+    QVERIFY(SearchController::isRefinement("beat", "beatles", true));
+    QVERIFY(SearchController::isRefinement("beat", "Beatles yel", true));
+    QVERIFY(SearchController::isRefinement("ac", "ac/dc", true));
+    QVERIFY(SearchController::isRefinement("ac/d", "AC/DC back", true));
+    QVERIFY(!SearchController::isRefinement("beatles", "beat", true));
+    QVERIFY(!SearchController::isRefinement("beat yel", "beat", true));
+    QVERIFY(!SearchController::isRefinement("yel", "beat yel", true));
+    QVERIFY(!SearchController::isRefinement("", "beat", true));
+
+    QVERIFY(SearchController::isRefinement("bea", "the beat", false));
+    QVERIFY(!SearchController::isRefinement("bea", "be%t", false));
+    QVERIFY(!SearchController::isRefinement("beat", "bea", false));
+}
+
+void TestSearchController::testMatches()
+{
+    MusicItem item;
+    item.artist = "Beyoncé";
+    item.song = "Halo";
+    item.genre1 = "R&B";
+    item.path = "/music/Beyoncé - Halo.ogg";
+
+    QVERIFY(SearchController::matches(item, "beyonce", true));
+    QVERIFY(SearchController::matches(item, "halo bey", true));
+    QVERIFY(SearchController::matches(item, "r&b", true));
+    QVERIFY(SearchController::matches(item, "music", true));
+    QVERIFY(!SearchController::matches(item, "halos", true));
+    QVERIFY(!SearchController::matches(item, "beyonce - halo x", true));
+
+    QVERIFY(SearchController::matches(item, "yonc", false));
+    QVERIFY(!SearchController::matches(item, "r&b", false));
+}
+
+void TestSearchController::testSearch()
+{
+    if (!m_fullText) {
+        QSKIP("SQLite was built without FTS5");
+    }
+
+    MusicCache cache;
+    SearchController search(m_database.databaseName(), &cache);
+    search.setFullTextSearch(true);
+    QSignalSpy ready(&search, &SearchController::resultsReady);
+
+    search.searchNow("beat");
+    QVERIFY(ready.wait());
+    SearchController::Result result = resultAt(ready, 0);
+    QCOMPARE(result.source, SearchController::Source::Query);
+    QCOMPARE(result.keys, QList<qint64>({1, 2}));
+    QCOMPARE(result.fields.size(), 11);
+    QCOMPARE(result.rows.at(1).at(result.fields.indexOf("song")).toString(), QString("Let It Be"));
+
+    // Typing on narrows the matches already read
+    search.searchNow("beatles yel");
+    QVERIFY(ready.wait());
+    result = resultAt(ready, 1);
+    QCOMPARE(result.source, SearchController::Source::Refined);
+    QCOMPARE(result.keys, QList<qint64>({1}));
+    QCOMPARE(result.rows.at(0).at(result.fields.indexOf("artist")).toString(),
+             QString("The Beatles"));
+
+    // Going back to an earlier text takes its matches from the cache
+    search.searchNow("beat");
+    QVERIFY(ready.wait());
+    result = resultAt(ready, 2);
+    QCOMPARE(result.source, SearchController::Source::Cached);
+    QCOMPARE(result.keys, QList<qint64>({1, 2}));
+
+    // The condition finds the same rows as the search did
+    QSqlQuery query(m_database);
+    query.prepare("SELECT rowid FROM musics WHERE " + result.condition);
+    for (const QVariant& value : std::as_const(result.bindValues)) {
+        query.addBindValue(value);
+    }
+    QVERIFY(query.exec());
+    QList<qint64> keys;
+    while (query.next()) {
+        keys.append(query.value(0).toLongLong());
+    }
+    QCOMPARE(keys, result.keys);
+
+    // An empty text shows the whole library
+    search.searchNow(QString());
+    QVERIFY(ready.wait());
+    QCOMPARE(resultAt(ready, 3).keys.size(), 4);
+    QVERIFY(resultAt(ready, 3).condition.isEmpty());
+}
+
+void TestSearchController::testDebounce()
+{
+    SearchController search(m_database.databaseName(), nullptr);
+    search.setFullTextSearch(m_fullText);
+    QSignalSpy ready(&search, &SearchController::resultsReady);
+
+    // Only the text typing stopped on is searched
+    search.setText("h");
+    search.setText("ha");
+    search.setText("hal");
+    QCOMPARE(search.text(), QString("hal"));
+    QVERIFY(ready.isEmpty());
+    QVERIFY(ready.wait());
+    QTest::qWait(SearchController::DEBOUNCE_MS * 2);
+    QCOMPARE(ready.count(), 1);
+    QCOMPARE(resultAt(ready, 0).text, QString("hal"));
+    QCOMPARE(resultAt(ready, 0).keys, QList<qint64>({3}));
+
+    // A search asked for while one runs replaces it
+    search.searchNow("beat");
+    search.searchNow("back");
+    QTRY_VERIFY(!search.isSearching() && !ready.isEmpty()
+                && resultAt(ready, ready.count() - 1).text == "back");
+    QCOMPARE(resultAt(ready, ready.count() - 1).keys, QList<qint64>({4}));
+}
+
+QTEST_MAIN(TestSearchController)
@@ -0,0 +1,41 @@
+#ifndef TESTSEARCHCONTROLLER_H
+#define TESTSEARCHCONTROLLER_H
+
+#include <QObject>
+#include <QTest>
+#include <QSqlDatabase>
+#include <QTemporaryDir>
+#include <memory>
+
+/**
+ * @brief Unit tests for SearchController class
+ *
+ * Tests the search as the user types including:
+ * - Bound conditions for the full-text index and for LIKE
+ * - Recognising a text that only narrows the previous one
+ * - Matching tracks in memory as the index does
+ * - Debouncing, narrowing the previous matches and serving cached ones
+ */
+class TestSearchController : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testCondition();
+    void testIsRefinement();
+    void testMatches();
+    void testSearch();
+    void testDebounce();
+
+private:
+    void addTrack(const QString& artist, const QString& song, const QString& genre);
+
+    std::unique_ptr<QTemporaryDir> m_tempDir;
+    QSqlDatabase m_database;
+    bool m_fullText = false;
+};
+
+#endif // TESTSEARCHCONTROLLER_H
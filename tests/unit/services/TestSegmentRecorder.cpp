@@ -0,0 +1,210 @@
+#include "TestSegmentRecorder.h"
+#include "../../../src/services/SegmentRecorder.h"
+#include <QDir>
+#include <QFile>
+#include <QSignalSpy>
+#include <vector>
+
+namespace {
+
+// Stands in for ffmpeg: the segment muxer copies stdin into the first
+// segment, and the concat demuxer appends the listed files to the last
+// argument
+const char* FAKE_FFMPEG = "#!/bin/sh\n"
+                          "for out; do :; done\n"
+                          "case \" $* \" in\n"
+                          "  *\" concat \"*)\n"
+                          "    while [ $# -gt 0 ]; do\n"
+                          "      if [ \"$1\" = \"-i\" ]; then list=\"$2\"; fi\n"
+                          "      shift\n"
+                          "    done\n"
+                          "    : > \"$out\"\n"
+                          "    sed -n \"s/^file '\\(.*\\)'$/\\1/p\" \"$list\" |\n"
+                          "      while IFS= read -r f; do cat \"$f\" >> \"$out\"; done;;\n"
+                          "  *) cat > \"$(printf \"$out\" 0)\";;\n"
+                          "esac\n";
+
+QByteArray readFile(const QString& path)
+{
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+void writeFile(const QString& path, const QByteArray& data)
+{
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(data);
+}
+
+} // namespace
+
+void TestSegmentRecorder::init()
+{
+    m_tempDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_tempDir->isValid());
+
+    m_fakeFfmpeg = m_tempDir->filePath("fake-ffmpeg");
+    QFile script(m_fakeFfmpeg);
+    QVERIFY(script.open(QIODevice::WriteOnly));
+    script.write(FAKE_FFMPEG);
+    script.close();
+    script.setPermissions(QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner);
+}
+
+void TestSegmentRecorder::cleanup()
+{
+    m_tempDir.reset();
+}
+
+void TestSegmentRecorder::testEncoderArguments()
+{
+    const QStringList args =
+        SegmentRecorder::encoderArguments(QString(), 0, 48000, 2, 300, "/rec/segment-%05d.ogg");
+    QCOMPARE(args.at(args.indexOf("-f") + 1), QString("f32le"));
+    QCOMPARE(args.at(args.indexOf("-ar") + 1), QString("48000"));
+    QCOMPARE(args.at(args.indexOf("-ac") + 1), QString("2"));
+    QCOMPARE(args.at(args.indexOf("-c:a") + 1), QString("libvorbis"));
+    QCOMPARE(args.at(args.indexOf("-segment_time") + 1), QString("300"));
+    QVERIFY(!args.contains("-b:a"));
+    QCOMPARE(args.last(), QString("/rec/segment-%05d.ogg"));
+
+    const QStringList mp3 =
+        SegmentRecorder::encoderArguments(QString(), 128, 44100, 1, 60, "/rec/segment-%05d.mp3");
+    QCOMPARE(mp3.at(mp3.indexOf("-c:a") + 1), QString("libmp3lame"));
+    QCOMPARE(mp3.at(mp3.indexOf("-b:a") + 1), QString("128k"));
+
+    QVERIFY(!mp3.contains("-segment_atclocktime"));
+
+    const QStringList archive = SegmentRecorder::encoderArguments(
+        "libopus", 48, 48000, 2, 3600, "/air/aircheck-%Y%m%d-%H%M%S.opus", true);
+    QCOMPARE(archive.at(archive.indexOf("-segment_atclocktime") + 1), QString("1"));
+    QCOMPARE(archive.at(archive.indexOf("-strftime") + 1), QString("1"));
+    QCOMPARE(archive.last(), QString("/air/aircheck-%Y%m%d-%H%M%S.opus"));
+
+    QCOMPARE(SegmentRecorder::defaultCodec("OPUS"), QString("libopus"));
+    QCOMPARE(SegmentRecorder::defaultCodec("m4a"), QString("aac"));
+    QCOMPARE(SegmentRecorder::defaultCodec("wav"), QString("pcm_s16le"));
+}
+
+void TestSegmentRecorder::testConcatList()
+{
+    const QString list = m_tempDir->filePath("list.txt");
+    const QString quoted = m_tempDir->filePath("it's.ogg");
+    const QString plain = m_tempDir->filePath("b.ogg");
+    QVERIFY(SegmentRecorder::writeConcatList(list, {quoted, plain}));
+
+    const QString expected = QString("file '%1'\nfile '%2'\n")
+                                 .arg(m_tempDir->filePath("it'\\''s.ogg"), plain);
+    QCOMPARE(QString::fromUtf8(readFile(list)), expected);
+}
+
+void TestSegmentRecorder::testRecordsAndJoins()
+{
+    const QString output = m_tempDir->filePath("show.ogg");
+    SegmentRecorder recorder;
+    recorder.setProgram(m_fakeFfmpeg);
+    recorder.setExternalSource(8000, 1);
+    QSignalSpy finished(&recorder, &SegmentRecorder::finished);
+    QSignalSpy segments(&recorder, &SegmentRecorder::segmentWritten);
+
+    QVERIFY(recorder.start(output));
+    QVERIFY(recorder.isRecording());
+    QCOMPARE(recorder.start(output), false);
+
+    std::vector<float> samples(800);
+    for (size_t i = 0; i < samples.size(); ++i) {
+        samples[i] = float(i) / float(samples.size());
+    }
+    QCOMPARE(recorder.write(samples.data(), int(samples.size())), int(samples.size()));
+    QCOMPARE(recorder.recordedSamples(), qint64(samples.size()));
+    QCOMPARE(recorder.droppedSamples(), qint64(0));
+
+    recorder.stop();
+    QVERIFY(!recorder.isRecording());
+    QCOMPARE(recorder.write(samples.data(), 1), 0);
+    QVERIFY(finished.wait(5000));
+    QVERIFY(finished.first().at(1).toBool());
+    QCOMPARE(finished.first().at(0).toString(), output);
+    QVERIFY(!recorder.isFinishing());
+    QCOMPARE(segments.size(), 1);
+
+    const QByteArray expected(reinterpret_cast<const char*>(samples.data()),
+                              int(samples.size() * sizeof(float)));
+    QCOMPARE(readFile(output), expected);
+
+    // The segment directory goes once the recording is joined
+    const QStringList left = QDir(m_tempDir->path())
+        .entryList(QDir::Dirs | QDir::Hidden | QDir::NoDotAndDotDot);
+    QVERIFY(left.isEmpty());
+}
+
+void TestSegmentRecorder::testPauseDropsAudio()
+{
+    const QString output = m_tempDir->filePath("paused.wav");
+    SegmentRecorder recorder;
+    recorder.setProgram(m_fakeFfmpeg);
+    recorder.setExternalSource(8000, 2);
+    QSignalSpy finished(&recorder, &SegmentRecorder::finished);
+    QVERIFY(recorder.start(output));
+
+    const float live[4] = {0.5f, 0.5f, 0.25f, 0.25f};
+    const float muted[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+    recorder.write(live, 4);
+    recorder.setPaused(true);
+    QCOMPARE(recorder.write(muted, 4), 4);
+    recorder.setPaused(false);
+    recorder.write(live, 4);
+    QCOMPARE(recorder.recordedSamples(), qint64(8));
+
+    recorder.stop();
+    QVERIFY(finished.wait(5000));
+    QVERIFY(finished.first().at(1).toBool());
+    QByteArray expected(reinterpret_cast<const char*>(live), sizeof(live));
+    expected += expected;
+    QCOMPARE(readFile(output), expected);
+}
+
+void TestSegmentRecorder::testRecoversInterrupted()
+{
+    const QString segmentDirectory = SegmentRecorder::segmentDirectoryFor(
+        m_tempDir->filePath("show.ogg"), QDateTime(QDate(2026, 1, 2), QTime(20, 0, 0)));
+    QCOMPARE(segmentDirectory, m_tempDir->filePath(".show-20260102-200000.ogg.segments"));
+    QVERIFY(QDir().mkpath(segmentDirectory));
+    writeFile(segmentDirectory + "/segment-00000.ogg", "first ");
+    writeFile(segmentDirectory + "/segment-00001.ogg", "second");
+    QVERIFY(QDir().mkpath(m_tempDir->filePath(".empty-20260102-200000.ogg.segments")));
+
+    const QStringList interrupted = SegmentRecorder::interruptedRecordings(m_tempDir->path());
+    QCOMPARE(interrupted, QStringList{segmentDirectory});
+    const QString recovered = SegmentRecorder::recoveredFile(segmentDirectory);
+    QCOMPARE(recovered, m_tempDir->filePath("show-20260102-200000.ogg"));
+
+    SegmentRecorder recorder;
+    recorder.setProgram(m_fakeFfmpeg);
+    QSignalSpy finished(&recorder, &SegmentRecorder::finished);
+    QVERIFY(!recorder.recover(m_tempDir->filePath(".empty-20260102-200000.ogg.segments")));
+    QVERIFY(recorder.recover(segmentDirectory));
+    QVERIFY(recorder.isFinishing());
+    QVERIFY(finished.wait(5000));
+
+    QVERIFY(finished.first().at(1).toBool());
+    QCOMPARE(finished.first().at(0).toString(), recovered);
+    QCOMPARE(readFile(recovered), QByteArray("first second"));
+    QVERIFY(!QDir(segmentDirectory).exists());
+}
+
+void TestSegmentRecorder::testStartFailsWithoutEncoder()
+{
+    SegmentRecorder recorder;
+    recorder.setProgram(m_tempDir->filePath("missing-ffmpeg"));
+    recorder.setExternalSource(8000, 1);
+    QSignalSpy errors(&recorder, &SegmentRecorder::operationError);
+
+    QVERIFY(!recorder.start(m_tempDir->filePath("show.ogg")));
+    QVERIFY(!recorder.isRecording());
+    QCOMPARE(errors.size(), 1);
+    QCOMPARE(SegmentRecorder::interruptedRecordings(m_tempDir->path()).size(), 0);
+}
+
+QTEST_MAIN(TestSegmentRecorder)
@@ -0,0 +1,40 @@
+#ifndef TESTSEGMENTRECORDER_H
+#define TESTSEGMENTRECORDER_H
+
+#include <QObject>
+#include <QTest>
+#include <QTemporaryDir>
+#include <memory>
+
+/**
+ * @brief Unit tests for SegmentRecorder class
+ *
+ * Tests the crash-safe segmented recording including:
+ * - ffmpeg arguments of the segment muxer
+ * - Quoting of paths in the concat list
+ * - Recording samples fed by write() and joining the segments
+ * - Dropping audio while paused
+ * - Finding and recovering recordings left by a crash
+ * - Refusing to start without an encoder
+ */
+class TestSegmentRecorder : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testEncoderArguments();
+    void testConcatList();
+    void testRecordsAndJoins();
+    void testPauseDropsAudio();
+    void testRecoversInterrupted();
+    void testStartFailsWithoutEncoder();
+
+private:
+    std::unique_ptr<QTemporaryDir> m_tempDir;
+    QString m_fakeFfmpeg;
+};
+
+#endif // TESTSEGMENTRECORDER_H
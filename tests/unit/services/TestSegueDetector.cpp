@@ -0,0 +1,99 @@
+#include "TestSegueDetector.h"
+#include "../../../src/services/SegueDetector.h"
+#include <QVector>
+#include <cmath>
+
+namespace {
+
+const int RATE = 48000;
+const int CHANNELS = 2;
+
+// Appends ms of a stereo tone whose amplitude moves linearly from one value to another
+void append(QVector<float>& samples, int ms, float from, float to)
+{
+    const qint64 frames = qint64(ms) * RATE / 1000;
+    for (qint64 i = 0; i < frames; ++i) {
+        const float amplitude = from + (to - from) * float(i) / float(frames);
+        const float value = amplitude * std::sin(2.0 * M_PI * 440.0 * i / RATE);
+        samples << value << value;
+    }
+}
+
+SegueDetector::Result detect(const QVector<float>& samples, qint64 chunk)
+{
+    SegueDetector detector(RATE, CHANNELS);
+    for (qint64 offset = 0; offset < samples.size(); offset += chunk) {
+        detector.feed(samples.constData() + offset, qMin(chunk, samples.size() - offset));
+    }
+    return detector.result();
+}
+
+// 2 s build-up, 20 s at full level, 8 s fade to nothing and 1 s of silence
+QVector<float> rampedTrack()
+{
+    QVector<float> samples;
+    append(samples, 2000, 0.0f, 0.3f);
+    append(samples, 20000, 0.3f, 0.3f);
+    append(samples, 8000, 0.3f, 0.0f);
+    append(samples, 1000, 0.0f, 0.0f);
+    return samples;
+}
+
+} // namespace
+
+void TestSegueDetector::testRampAndFade()
+{
+    const SegueDetector::Result result = detect(rampedTrack(), 4800);
+    QVERIFY(result.valid);
+    QVERIFY(qAbs(result.bodyDb - 20.0 * std::log10(0.3 / M_SQRT2)) < 0.1);
+
+    // Full level is 3 dB down, about 71% of the amplitude, the segue point 9 dB down
+    QVERIFY(qAbs(result.introMs - 1700) <= 100);
+    QVERIFY(qAbs(result.fadeMs - 24500) <= 200);
+    QVERIFY(qAbs(result.segueMs - 27300) <= 200);
+    QVERIFY(result.introMs < result.fadeMs);
+    QVERIFY(result.fadeMs < result.segueMs);
+}
+
+void TestSegueDetector::testColdEnding()
+{
+    QVector<float> samples;
+    append(samples, 10000, 0.3f, 0.3f);
+
+    const SegueDetector::Result result = detect(samples, 4800);
+    QVERIFY(result.valid);
+    QCOMPARE(result.introMs, qint64(0));
+    QCOMPARE(result.fadeMs, qint64(10000));
+    QCOMPARE(result.segueMs, qint64(10000));
+}
+
+void TestSegueDetector::testSilentAndShort()
+{
+    QVector<float> samples;
+    append(samples, 5000, 0.0f, 0.0f);
+    SegueDetector::Result result = detect(samples, 4800);
+    QVERIFY(!result.valid);
+    QCOMPARE(result.segueMs, qint64(-1));
+
+    samples.clear();
+    append(samples, 300, 0.3f, 0.3f);
+    result = detect(samples, 4800);
+    QVERIFY(!result.valid);
+
+    SegueDetector empty(RATE, CHANNELS);
+    QVERIFY(!empty.result().valid);
+}
+
+void TestSegueDetector::testChunkSizes()
+{
+    // Blocks straddle calls and chunks are not a multiple of the SIMD lanes
+    const QVector<float> samples = rampedTrack();
+    const SegueDetector::Result whole = detect(samples, samples.size());
+    const SegueDetector::Result uneven = detect(samples, 1002);
+    QCOMPARE(uneven.introMs, whole.introMs);
+    QCOMPARE(uneven.fadeMs, whole.fadeMs);
+    QCOMPARE(uneven.segueMs, whole.segueMs);
+    QVERIFY(qAbs(uneven.bodyDb - whole.bodyDb) < 0.01);
+}
+
+QTEST_MAIN(TestSegueDetector)
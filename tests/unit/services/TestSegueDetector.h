@@ -0,0 +1,27 @@
+#ifndef TESTSEGUEDETECTOR_H
+#define TESTSEGUEDETECTOR_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for SegueDetector class
+ *
+ * Tests the energy scan behind the intro and segue points including:
+ * - A track that builds up, holds and fades out
+ * - A track that stops cold
+ * - Audio that is silent or shorter than one window
+ * - Getting the same points whatever the size of the fed chunks
+ */
+class TestSegueDetector : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testRampAndFade();
+    void testColdEnding();
+    void testSilentAndShort();
+    void testChunkSizes();
+};
+
+#endif // TESTSEGUEDETECTOR_H
@@ -0,0 +1,99 @@
+#include "TestServerPresenceCache.h"
+#include "../../../src/services/MusicCache.h"
+#include "../../../src/services/ServerPresenceCache.h"
+#include <QSignalSpy>
+
+using Presence = ServerPresenceCache::Presence;
+
+namespace {
+
+TransferQueue::Job listingJob(const QString& command)
+{
+    TransferQueue::Job job;
+    job.key = "check:listing";
+    job.description = "listing";
+    job.program = "/bin/sh";
+    job.arguments = {"-c", command};
+    job.maxAttempts = 1;
+    return job;
+}
+
+} // namespace
+
+void TestServerPresenceCache::testOneListingAnswersAll()
+{
+    MusicCache cache;
+    cache.setWarmupStrategy(MusicCache::NoWarmup);
+    TransferQueue transfers;
+    ServerPresenceCache presence(&cache, &transfers);
+    presence.setListingJob(listingJob("echo morning.mp3; echo news.ogg"));
+    QSignalSpy started(&transfers, &TransferQueue::jobStarted);
+    QSignalSpy changed(&presence, &ServerPresenceCache::presenceChanged);
+
+    QCOMPARE(presence.status("morning.mp3").presence, Presence::Unknown);
+    Presence answer = Presence::Unknown;
+    presence.refresh("morning.mp3",
+                     [&answer](Presence found, const TransferQueue::Result&) { answer = found; });
+    presence.refresh("evening.mp3");
+    QVERIFY(presence.isRefreshing("morning.mp3"));
+    QVERIFY(presence.isRefreshing("evening.mp3"));
+
+    QTRY_COMPARE(changed.count(), 2);
+    QCOMPARE(started.count(), 1);
+    QCOMPARE(answer, Presence::Present);
+    QVERIFY(!presence.isRefreshing("morning.mp3"));
+
+    const ServerPresenceCache::Status found = presence.status("morning.mp3");
+    QCOMPARE(found.presence, Presence::Present);
+    QVERIFY(found.checked.isValid());
+    QCOMPARE(presence.status("evening.mp3").presence, Presence::Missing);
+}
+
+void TestServerPresenceCache::testRefreshIfStale()
+{
+    MusicCache cache;
+    cache.setWarmupStrategy(MusicCache::NoWarmup);
+    TransferQueue transfers;
+    ServerPresenceCache presence(&cache, &transfers);
+    presence.setListingJob(listingJob("echo morning.mp3"));
+    QSignalSpy started(&transfers, &TransferQueue::jobStarted);
+
+    // A status just recorded is served from the cache
+    presence.record("morning.mp3", Presence::Present);
+    QVERIFY(!presence.refreshIfStale("morning.mp3"));
+    QCOMPARE(started.count(), 0);
+
+    // An unknown one is checked in the background
+    QVERIFY(presence.refreshIfStale("news.ogg"));
+    QCOMPARE(presence.status("news.ogg").presence, Presence::Unknown);
+    QTRY_VERIFY(!presence.isRefreshing("news.ogg"));
+    QCOMPARE(started.count(), 1);
+    QCOMPARE(presence.status("news.ogg").presence, Presence::Missing);
+
+    // Forgetting a file makes it unknown again
+    presence.record("morning.mp3", Presence::Unknown);
+    QCOMPARE(presence.status("morning.mp3").presence, Presence::Unknown);
+}
+
+void TestServerPresenceCache::testFailedListingKeepsStatus()
+{
+    MusicCache cache;
+    cache.setWarmupStrategy(MusicCache::NoWarmup);
+    TransferQueue transfers;
+    ServerPresenceCache presence(&cache, &transfers);
+    presence.setListingJob(listingJob("echo morning.mp3; exit 1"));
+    presence.record("morning.mp3", Presence::Missing);
+
+    bool called = false;
+    Presence answer = Presence::Present;
+    presence.refresh("morning.mp3", [&](Presence found, const TransferQueue::Result& result) {
+        QVERIFY(!result.ok);
+        answer = found;
+        called = true;
+    });
+    QTRY_VERIFY(called);
+    QCOMPARE(answer, Presence::Unknown);
+    QCOMPARE(presence.status("morning.mp3").presence, Presence::Missing);
+}
+
+QTEST_MAIN(TestServerPresenceCache)
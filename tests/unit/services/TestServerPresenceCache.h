@@ -0,0 +1,25 @@
+#ifndef TESTSERVERPRESENCECACHE_H
+#define TESTSERVERPRESENCECACHE_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for ServerPresenceCache class
+ *
+ * Tests the cached server presence including:
+ * - Files waiting for a check answered by one listing and cached
+ * - Fresh statuses served without a check, stale ones refreshed
+ * - A failed listing keeping the cached status
+ */
+class TestServerPresenceCache : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testOneListingAnswersAll();
+    void testRefreshIfStale();
+    void testFailedListingKeepsStatus();
+};
+
+#endif // TESTSERVERPRESENCECACHE_H
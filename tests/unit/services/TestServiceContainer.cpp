@@ -175,4 +175,119 @@ void TestServiceContainer::testSignalEmission()
     QCOMPARE(resolvedSpy.count(), 1);
 }
 
+void TestServiceContainer::testResolveAfterClear()
+{
+    m_container->registerSingleton<MockService>();
+    MockService* first = m_container->resolve<MockService>();
+    QVERIFY(first != nullptr);
+    QCOMPARE(m_container->resolve<MockService>(), first);
+
+    // A cleared singleton is no longer handed out, and a new registration makes a new one
+    m_container->clear();
+    QVERIFY(m_container->resolve<MockService>() == nullptr);
+
+    bool factoryCalled = false;
+    m_container->registerSingleton<MockService>([&factoryCalled](ServiceContainer*) -> IService* {
+        factoryCalled = true;
+        return new MockService();
+    });
+    QVERIFY(m_container->resolve<MockService>() != nullptr);
+    QVERIFY(factoryCalled);
+}
+
+void TestServiceContainer::testTypesResolveSeparately()
+{
+    m_container->registerSingleton<MockService>();
+    m_container->registerTransient<AnotherMockService>();
+    QVERIFY(m_container->initializeServices());
+
+    MockService* mock = m_container->resolve<MockService>();
+    AnotherMockService* another = m_container->resolve<AnotherMockService>();
+    QVERIFY(mock != nullptr);
+    QVERIFY(another != nullptr);
+    QVERIFY(static_cast<IService*>(mock) != static_cast<IService*>(another));
+    QCOMPARE(mock->state(), IService::ServiceState::Running);
+
+    // Transient services are still created on every call
+    AnotherMockService* second = m_container->resolve<AnotherMockService>();
+    QVERIFY(second != another);
+    delete another;
+    delete second;
+}
+
+void TestServiceContainer::testDependencyOrder()
+{
+    m_container->registerSingleton<MockService>();
+    m_container->registerSingleton<AnotherMockService>();
+    m_container->dependsOn<MockService, AnotherMockService>();
+
+    QStringList order;
+    connect(m_container->resolve<MockService>(), &IService::stateChanged, this,
+            [&order](IService::ServiceState state) {
+                if (state == IService::ServiceState::Running) {
+                    order.append("MockService");
+                }
+            });
+    connect(m_container->resolve<AnotherMockService>(), &IService::stateChanged, this,
+            [&order](IService::ServiceState state) {
+                if (state == IService::ServiceState::Running) {
+                    order.append("AnotherMockService");
+                }
+            });
+
+    QVERIFY(m_container->initializeServices());
+    QCOMPARE(order, QStringList({"AnotherMockService", "MockService"}));
+}
+
+void TestServiceContainer::testConcurrentInitialization()
+{
+    m_container->registerSingleton<MockService>();
+    m_container->registerSingleton<AnotherMockService>();
+    m_container->initializeConcurrently<MockService>();
+
+    // Only the requested service and what it depends on are initialized
+    QVERIFY(m_container->initializeServicesFor<MockService>());
+    MockService* service = m_container->resolve<MockService>();
+    QVERIFY(service->isRunning());
+    QVERIFY(service->initializeThread() != nullptr);
+    QVERIFY(service->initializeThread() != QThread::currentThread());
+    QCOMPARE(m_container->resolve<AnotherMockService>()->state(),
+             IService::ServiceState::Uninitialized);
+}
+
+void TestServiceContainer::testBackgroundInitialization()
+{
+    m_container->registerSingleton<MockService>();
+    m_container->registerSingleton<AnotherMockService>();
+    m_container->dependsOn<AnotherMockService, MockService>();
+
+    QSignalSpy initializedSpy(m_container, &ServiceContainer::servicesInitialized);
+    m_container->initializeServicesInBackground<AnotherMockService>();
+    QCOMPARE(initializedSpy.count(), 0);
+
+    QVERIFY(initializedSpy.wait());
+    QCOMPARE(initializedSpy.first().at(0).toBool(), true);
+    QVERIFY(m_container->resolve<MockService>()->isRunning());
+    QVERIFY(m_container->resolve<AnotherMockService>()->isRunning());
+}
+
+void TestServiceContainer::testFailedDependency()
+{
+    m_container->registerSingleton<MockService>([](ServiceContainer*) {
+        auto* service = new MockService();
+        service->setInitializeResult(false);
+        return service;
+    });
+    m_container->registerSingleton<AnotherMockService>();
+    m_container->dependsOn<AnotherMockService, MockService>();
+
+    QSignalSpy failedSpy(m_container, &ServiceContainer::serviceInitializationFailed);
+    QVERIFY(!m_container->initializeServices());
+
+    // The dependent service is not started on top of a failed one
+    QCOMPARE(failedSpy.count(), 2);
+    QCOMPARE(m_container->resolve<AnotherMockService>()->state(),
+             IService::ServiceState::Uninitialized);
+}
+
 QTEST_MAIN(TestServiceContainer)
\ No newline at end of file
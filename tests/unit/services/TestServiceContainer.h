@@ -4,6 +4,7 @@
 #include <QtTest/QtTest>
 #include <QObject>
 #include <QSignalSpy>
+#include <QThread>
 #include "../../../src/services/ServiceContainer.h"
 #include "../../../src/services/BaseService.h"
 
@@ -20,10 +21,12 @@ public:
     void setInitializeResult(bool result) { m_initializeResult = result; }
     bool wasInitializeCalled() const { return m_initializeCalled; }
     bool wasShutdownCalled() const { return m_shutdownCalled; }
+    QThread* initializeThread() const { return m_initializeThread; }
 
 protected:
     bool doInitialize() override {
         m_initializeCalled = true;
+        m_initializeThread = QThread::currentThread();
         return m_initializeResult;
     }
     
@@ -39,6 +42,7 @@ private:
     bool m_initializeResult;
     bool m_initializeCalled = false;
     bool m_shutdownCalled = false;
+    QThread* m_initializeThread = nullptr;
 };
 
 /**
@@ -83,6 +87,12 @@ private slots:
     void testClear();
     void testCustomFactory();
     void testSignalEmission();
+    void testResolveAfterClear();
+    void testTypesResolveSeparately();
+    void testDependencyOrder();
+    void testConcurrentInitialization();
+    void testBackgroundInitialization();
+    void testFailedDependency();
 
 private:
     ServiceContainer* m_container;
@@ -0,0 +1,152 @@
+#include "TestShutdownCoordinator.h"
+#include "../../../src/services/ShutdownCoordinator.h"
+#include <QElapsedTimer>
+#include <QProcess>
+#include <QStandardPaths>
+
+namespace {
+
+bool waitForRunning(ProcessSupervisor& supervisor, const QStringList& names)
+{
+    return QTest::qWaitFor(
+        [&]() {
+            for (const QString& name : names) {
+                if (!supervisor.isRunning(name)) {
+                    return false;
+                }
+            }
+            return true;
+        },
+        5000);
+}
+
+} // namespace
+
+void TestShutdownCoordinator::testParallelStop()
+{
+    ProcessSupervisor supervisor;
+    supervisor.setStopGracePeriod(3000);
+    // Each takes a second to leave after SIGTERM
+    const QString slowExit = "trap 'sleep 1; exit 0' TERM; while true; do sleep 0.1; done";
+    supervisor.addProcess("one", "/bin/sh", {"-c", slowExit});
+    supervisor.addProcess("two", "/bin/sh", {"-c", slowExit});
+    supervisor.addProcess("three", "/bin/sh", {"-c", slowExit});
+    const QStringList names = {"one", "two", "three"};
+    for (const QString& name : names) {
+        QVERIFY(supervisor.start(name));
+    }
+    QVERIFY(waitForRunning(supervisor, names));
+
+    ShutdownCoordinator shutdown(&supervisor);
+    ShutdownCoordinator::Report report;
+    bool done = false;
+    QElapsedTimer clock;
+    clock.start();
+    shutdown.stop(names, [&](const ShutdownCoordinator::Report& r) {
+        report = r;
+        done = true;
+    });
+    // Nothing waits in stop()
+    QVERIFY(clock.elapsed() < 500);
+    QVERIFY(!done);
+    QVERIFY(shutdown.isStopping());
+
+    QTRY_VERIFY_WITH_TIMEOUT(done, 5000);
+    QVERIFY(!shutdown.isStopping());
+    QStringList stopped = report.stopped;
+    stopped.sort();
+    QCOMPARE(stopped, QStringList({"one", "three", "two"}));
+    QVERIFY(report.forced.isEmpty());
+    QVERIFY(report.unresponsive.isEmpty());
+    // Three one-second exits side by side, not one after the other
+    QVERIFY2(report.elapsedMs < 2500, qPrintable(QString::number(report.elapsedMs)));
+}
+
+void TestShutdownCoordinator::testForcedKill()
+{
+    ProcessSupervisor supervisor;
+    supervisor.setStopGracePeriod(200);
+    supervisor.addProcess("stubborn", "/bin/sh", {"-c", "trap '' TERM; while true; do sleep 0.1; done"});
+    supervisor.addProcess("polite", "/bin/sh", {"-c", "sleep 30"});
+    QVERIFY(supervisor.start("stubborn"));
+    QVERIFY(supervisor.start("polite"));
+    QVERIFY(waitForRunning(supervisor, {"stubborn", "polite"}));
+
+    ShutdownCoordinator shutdown(&supervisor);
+    ShutdownCoordinator::Report report;
+    bool done = false;
+    shutdown.stop({"stubborn", "polite"}, [&](const ShutdownCoordinator::Report& r) {
+        report = r;
+        done = true;
+    });
+    QTRY_VERIFY_WITH_TIMEOUT(done, 5000);
+    QCOMPARE(report.stopped.size(), 2);
+    QCOMPARE(report.forced, QStringList({"stubborn"}));
+    QVERIFY(report.elapsedMs >= 200);
+    QCOMPARE(supervisor.state("stubborn"), ProcessSupervisor::State::Stopped);
+}
+
+void TestShutdownCoordinator::testAlreadyStopped()
+{
+    ProcessSupervisor supervisor;
+    supervisor.addProcess("idle", "/bin/sh", {"-c", "sleep 30"});
+
+    ShutdownCoordinator shutdown(&supervisor);
+    ShutdownCoordinator::Report report;
+    bool done = false;
+    shutdown.stop({"idle", "unknown"}, [&](const ShutdownCoordinator::Report& r) {
+        report = r;
+        done = true;
+    });
+    // Nothing to wait for, so it reports straight away
+    QVERIFY(done);
+    QCOMPARE(report.stopped, QStringList({"idle"}));
+
+    done = false;
+    shutdown.stop({}, [&](const ShutdownCoordinator::Report& r) {
+        report = r;
+        done = true;
+    });
+    QVERIFY(done);
+    QVERIFY(report.stopped.isEmpty());
+}
+
+void TestShutdownCoordinator::testKillByName()
+{
+#ifdef Q_OS_UNIX
+    if (QStandardPaths::findExecutable("pkill").isEmpty()) {
+        QSKIP("pkill is not installed");
+    }
+
+    // An odd duration makes the command line unique to this test
+    QProcess stray;
+    stray.start("sleep", {"31.4159"});
+    QVERIFY(stray.waitForStarted());
+
+    ProcessSupervisor supervisor;
+    ShutdownCoordinator shutdown(&supervisor);
+    bool done = false;
+    bool killed = false;
+    shutdown.killByName("sleep 31.4159", [&](bool success) {
+        killed = success;
+        done = true;
+    });
+    QVERIFY(!done);
+    QTRY_VERIFY(done);
+    QVERIFY(killed);
+    QTRY_COMPARE(stray.state(), QProcess::NotRunning);
+
+    // Nothing left to match
+    done = false;
+    shutdown.killByName("sleep 31.4159", [&](bool success) {
+        killed = success;
+        done = true;
+    });
+    QTRY_VERIFY(done);
+    QVERIFY(!killed);
+#else
+    QSKIP("Uses pkill");
+#endif
+}
+
+QTEST_MAIN(TestShutdownCoordinator)
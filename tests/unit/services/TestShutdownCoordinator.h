@@ -0,0 +1,27 @@
+#ifndef TESTSHUTDOWNCOORDINATOR_H
+#define TESTSHUTDOWNCOORDINATOR_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for ShutdownCoordinator class
+ *
+ * Tests non-blocking shutdown of helper processes including:
+ * - Stopping several supervised processes in parallel
+ * - Reporting processes that had to be killed
+ * - Processes that are already stopped or unknown
+ * - Killing unsupervised processes by name
+ */
+class TestShutdownCoordinator : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testParallelStop();
+    void testForcedKill();
+    void testAlreadyStopped();
+    void testKillByName();
+};
+
+#endif // TESTSHUTDOWNCOORDINATOR_H
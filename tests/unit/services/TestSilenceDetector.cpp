@@ -0,0 +1,100 @@
+#include "TestSilenceDetector.h"
+#include "../../../src/services/SilenceDetector.h"
+#include <QVector>
+#include <cmath>
+
+namespace {
+
+const int RATE = 44100;
+const int CHANNELS = 2;
+
+// Appends ms of a stereo tone, or of silence if amplitude is 0
+void append(QVector<float>& samples, int ms, float amplitude)
+{
+    const qint64 frames = qint64(ms) * RATE / 1000;
+    for (qint64 i = 0; i < frames; ++i) {
+        const float value = amplitude * std::sin(2.0 * M_PI * 440.0 * i / RATE);
+        samples << value << value;
+    }
+}
+
+// Feeds in uneven chunks so windows straddle calls
+SilenceDetector::Result detect(const QVector<float>& samples)
+{
+    SilenceDetector detector(RATE, CHANNELS);
+    for (qint64 offset = 0; offset < samples.size(); offset += 1001) {
+        detector.feed(samples.constData() + offset, qMin<qint64>(1001, samples.size() - offset));
+    }
+    return detector.result();
+}
+
+} // namespace
+
+void TestSilenceDetector::testFindsCuePoints()
+{
+    QVector<float> samples;
+    append(samples, 1000, 0.0f);
+    append(samples, 2000, 0.5f);
+    append(samples, 1500, 0.0f);
+
+    const SilenceDetector::Result result = detect(samples);
+    QVERIFY(result.valid);
+    QVERIFY(result.audible);
+    QCOMPARE(result.durationMs, qint64(4500));
+    QVERIFY(qAbs(result.peakDb - 20.0 * std::log10(0.5)) < 0.1);
+
+    const SilenceDetector::Settings defaults;
+    QCOMPARE(result.cue.inMs, 1000 - defaults.leadInMs);
+    QCOMPARE(result.cue.outMs, 3000 + defaults.tailMs);
+}
+
+void TestSilenceDetector::testKeepsShortSilence()
+{
+    QVector<float> samples;
+    append(samples, 50, 0.0f);
+    append(samples, 1000, 0.5f);
+    append(samples, 200, 0.0f);
+
+    // Neither gap is worth cutting once the margins are kept
+    const SilenceDetector::Result result = detect(samples);
+    QVERIFY(result.audible);
+    QVERIFY(!result.cue.isSet());
+}
+
+void TestSilenceDetector::testThresholds()
+{
+    // Hiss at -60 dBFS is silence, a tone at -40 dBFS is not
+    QVector<float> samples;
+    append(samples, 1000, 0.001f);
+    append(samples, 1000, 0.01f * float(M_SQRT2));
+    append(samples, 1000, 0.001f);
+    SilenceDetector::Result result = detect(samples);
+    QCOMPARE(result.cue.inMs, qint64(980));
+    QCOMPARE(result.cue.outMs, qint64(2250));
+
+    // A single loud sample counts, even though it barely moves the RMS
+    samples.clear();
+    append(samples, 500, 0.0f);
+    samples << 0.5f << 0.5f;
+    append(samples, 1500, 0.0f);
+    result = detect(samples);
+    QVERIFY(result.audible);
+    QCOMPARE(result.cue.inMs, qint64(480));
+}
+
+void TestSilenceDetector::testAllSilent()
+{
+    QVector<float> samples;
+    append(samples, 2000, 0.0f);
+
+    const SilenceDetector::Result result = detect(samples);
+    QVERIFY(result.valid);
+    QVERIFY(!result.audible);
+    QVERIFY(!result.cue.isSet());
+    QCOMPARE(result.peakDb, -120.0);
+
+    SilenceDetector empty(RATE, CHANNELS);
+    QVERIFY(!empty.result().valid);
+}
+
+QTEST_MAIN(TestSilenceDetector)
@@ -0,0 +1,27 @@
+#ifndef TESTSILENCEDETECTOR_H
+#define TESTSILENCEDETECTOR_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for SilenceDetector class
+ *
+ * Tests the level scan behind Auto-Trim including:
+ * - Cue points with their lead-in and tail margins
+ * - Leaving short silences in place
+ * - The RMS threshold against a noise floor and the peak threshold for transients
+ * - Tracks that are silent throughout
+ */
+class TestSilenceDetector : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testFindsCuePoints();
+    void testKeepsShortSilence();
+    void testThresholds();
+    void testAllSilent();
+};
+
+#endif // TESTSILENCEDETECTOR_H
@@ -0,0 +1,135 @@
+#include "TestSilenceScanner.h"
+#include "../../../src/services/CuePointStore.h"
+#include "../../../src/services/SilenceScanner.h"
+#include <QSignalSpy>
+#include <QSqlQuery>
+#include <QThread>
+#include <atomic>
+
+namespace {
+
+const char* CONNECTION_NAME = "test_silence_scanner_connection";
+
+// Stands in for decoding: "broken" files fail, the rest end at their name's length
+SilenceScanner::Analyzer fakeAnalyzer(int delayMs, std::atomic<int>* running = nullptr,
+                                      std::atomic<int>* mostRunning = nullptr)
+{
+    return [=](const QString& filePath, const SilenceDetector::Settings&, QString* error) {
+        if (running) {
+            const int now = ++*running;
+            int most = mostRunning->load();
+            while (now > most && !mostRunning->compare_exchange_weak(most, now)) {
+            }
+        }
+        QThread::msleep(delayMs);
+        if (running) {
+            --*running;
+        }
+
+        SilenceDetector::Result result;
+        if (filePath.contains("broken")) {
+            *error = "Invalid data";
+            return result;
+        }
+        result.valid = true;
+        result.audible = true;
+        result.cue.inMs = 500;
+        result.cue.outMs = filePath.size() * 1000;
+        return result;
+    };
+}
+
+} // namespace
+
+void TestSilenceScanner::init()
+{
+    m_tempDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_tempDir->isValid());
+
+    m_database = QSqlDatabase::addDatabase("QSQLITE", CONNECTION_NAME);
+    m_database.setDatabaseName(m_tempDir->filePath("test.db"));
+    QVERIFY(m_database.open());
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("CREATE TABLE musics (id INTEGER PRIMARY KEY, path TEXT)"));
+}
+
+void TestSilenceScanner::cleanup()
+{
+    if (m_database.isOpen()) {
+        m_database.close();
+    }
+    m_database = QSqlDatabase();
+    QSqlDatabase::removeDatabase(CONNECTION_NAME);
+    m_tempDir.reset();
+}
+
+void TestSilenceScanner::testStoresResults()
+{
+    CuePointStore store(m_database);
+    QVERIFY(store.initialize());
+    SilenceScanner scanner(&store);
+    scanner.setAnalyzer(fakeAnalyzer(0));
+    QSignalSpy finished(&scanner, &SilenceScanner::finished);
+    QSignalSpy progress(&scanner, &SilenceScanner::progressChanged);
+
+    QCOMPARE(scanner.scan({"/music/a.ogg", "/music/broken.ogg", "/music/long name.ogg"}), 3);
+    QVERIFY(scanner.isRunning());
+    QVERIFY(finished.wait(5000));
+
+    QCOMPARE(finished.at(0).at(0).toInt(), 2);
+    QCOMPARE(finished.at(0).at(1).toInt(), 1);
+    QCOMPARE(progress.count(), 3);
+    QCOMPARE(progress.last().at(0).toInt(), 3);
+    QCOMPARE(progress.last().at(1).toInt(), 3);
+    QVERIFY(!scanner.isRunning());
+
+    QCOMPARE(store.count(), 2);
+    QCOMPARE(store.cuePoints("/music/a.ogg"), (CuePoints{500, 12000}));
+    QVERIFY(!store.cuePoints("/music/broken.ogg").isSet());
+}
+
+void TestSilenceScanner::testWorkerLimit()
+{
+    std::atomic<int> running{0};
+    std::atomic<int> mostRunning{0};
+    SilenceScanner scanner(nullptr);
+    scanner.setMaxWorkers(2);
+    scanner.setAnalyzer(fakeAnalyzer(100, &running, &mostRunning));
+    QSignalSpy finished(&scanner, &SilenceScanner::finished);
+
+    QStringList paths;
+    for (int i = 0; i < 6; ++i) {
+        paths << QString("/music/track%1.ogg").arg(i);
+    }
+    // Tracks already waiting are not queued twice
+    QCOMPARE(scanner.scan(paths), 6);
+    QCOMPARE(scanner.scan(paths.mid(4)), 0);
+    QVERIFY(finished.wait(5000));
+
+    QCOMPARE(mostRunning.load(), 2);
+    QCOMPARE(finished.at(0).at(0).toInt(), 6);
+}
+
+void TestSilenceScanner::testCancel()
+{
+    CuePointStore store(m_database);
+    QVERIFY(store.initialize());
+    SilenceScanner scanner(&store);
+    scanner.setMaxWorkers(1);
+    scanner.setAnalyzer(fakeAnalyzer(200));
+    QSignalSpy finished(&scanner, &SilenceScanner::finished);
+    QSignalSpy analyzed(&scanner, &SilenceScanner::trackAnalyzed);
+
+    scanner.scan({"/music/a.ogg", "/music/b.ogg", "/music/c.ogg"});
+    scanner.cancel();
+    QVERIFY(!scanner.isRunning());
+    QCOMPARE(finished.count(), 1);
+    QCOMPARE(finished.at(0).at(0).toInt(), 0);
+
+    // The track that was being analyzed finishes, but its result is dropped
+    QTest::qWait(400);
+    QCOMPARE(analyzed.count(), 0);
+    QCOMPARE(store.count(), 0);
+}
+
+QTEST_MAIN(TestSilenceScanner)
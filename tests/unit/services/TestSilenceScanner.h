@@ -0,0 +1,35 @@
+#ifndef TESTSILENCESCANNER_H
+#define TESTSILENCESCANNER_H
+
+#include <QObject>
+#include <QTest>
+#include <QSqlDatabase>
+#include <QTemporaryDir>
+#include <memory>
+
+/**
+ * @brief Unit tests for SilenceScanner class
+ *
+ * Tests the parallel Auto-Trim scan including:
+ * - Storing the cue points found and counting failures
+ * - Bounding the number of files analyzed at once
+ * - Cancelling a scan and dropping late results
+ */
+class TestSilenceScanner : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testStoresResults();
+    void testWorkerLimit();
+    void testCancel();
+
+private:
+    std::unique_ptr<QTemporaryDir> m_tempDir;
+    QSqlDatabase m_database;
+};
+
+#endif // TESTSILENCESCANNER_H
@@ -0,0 +1,124 @@
+#include "TestSpotPool.h"
+#include "../../../src/services/SpotPool.h"
+#include <QSet>
+#include <QSqlQuery>
+
+namespace {
+
+const char* CONNECTION_NAME = "test_spot_pool_connection";
+
+} // namespace
+
+void TestSpotPool::init()
+{
+    m_tempDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_tempDir->isValid());
+
+    m_database = QSqlDatabase::addDatabase("QSQLITE", CONNECTION_NAME);
+    m_database.setDatabaseName(m_tempDir->path() + "/spots.db");
+    QVERIFY(m_database.open());
+
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("CREATE TABLE jingles (name TEXT, path TEXT)"));
+    m_nextJingle = 1;
+}
+
+void TestSpotPool::cleanup()
+{
+    if (m_database.isOpen()) {
+        m_database.close();
+    }
+    m_database = QSqlDatabase();
+    QSqlDatabase::removeDatabase(CONNECTION_NAME);
+    m_tempDir.reset();
+}
+
+void TestSpotPool::addJingles(int count)
+{
+    QSqlQuery query(m_database);
+    query.prepare("INSERT INTO jingles VALUES (?, ?)");
+    for (int i = 0; i < count; ++i, ++m_nextJingle) {
+        query.addBindValue(QString("Jingle %1").arg(m_nextJingle));
+        query.addBindValue(QString("/jingles/%1.wav").arg(m_nextJingle));
+        QVERIFY(query.exec());
+    }
+}
+
+void TestSpotPool::testRoundsWithoutRepeats()
+{
+    addJingles(5);
+
+    SpotPool pool(m_database, "jingles");
+    pool.setSeed(3);
+    QString previous;
+    for (int round = 0; round < 20; ++round) {
+        QSet<QString> played;
+        for (int i = 0; i < 5; ++i) {
+            const QString path = pool.peek().path;
+            const SpotPool::Spot spot = pool.next();
+            QCOMPARE(spot.path, path);
+            QVERIFY2(!played.contains(spot.path), qPrintable(spot.path));
+            QVERIFY(spot.path != previous);
+            played.insert(spot.path);
+            previous = spot.path;
+        }
+    }
+    QCOMPARE(pool.size(), 5);
+}
+
+void TestSpotPool::testWeights()
+{
+    addJingles(3);
+
+    SpotPool pool(m_database, "jingles");
+    pool.setSeed(5);
+    pool.setWeight("/jingles/1.wav", 2);
+    QCOMPARE(pool.size(), 3);
+
+    for (int round = 0; round < 10; ++round) {
+        QHash<QString, int> plays;
+        for (int i = 0; i < 4; ++i) {
+            ++plays[pool.next().path];
+        }
+        QCOMPARE(plays.value("/jingles/1.wav"), 2);
+        QCOMPARE(plays.value("/jingles/2.wav"), 1);
+        QCOMPARE(plays.value("/jingles/3.wav"), 1);
+    }
+}
+
+void TestSpotPool::testInvalidateReloads()
+{
+    addJingles(4);
+
+    QStringList probed;
+    SpotPool pool(m_database, "jingles");
+    pool.setDurationLookup([&probed](const QString& filePath) {
+        probed << filePath;
+        return qint64(5) * 1000000;
+    });
+    QCOMPARE(pool.size(), 4);
+    QCOMPARE(probed.size(), 4);
+    QCOMPARE(pool.next().durationUs, qint64(5) * 1000000);
+
+    // Read again only when told, and only new files are probed
+    addJingles(1);
+    QCOMPARE(pool.size(), 4);
+    pool.invalidate();
+    QCOMPARE(pool.size(), 5);
+    QCOMPARE(probed.size(), 5);
+    QCOMPARE(probed.last(), QString("/jingles/5.wav"));
+}
+
+void TestSpotPool::testEmptyTable()
+{
+    SpotPool pool(m_database, "jingles");
+    QCOMPARE(pool.size(), 0);
+    QVERIFY(pool.next().path.isEmpty());
+    QVERIFY(pool.peek().path.isEmpty());
+
+    SpotPool missing(m_database, "no_such_table");
+    QVERIFY(!missing.reload());
+    QVERIFY(missing.next().path.isEmpty());
+}
+
+QTEST_MAIN(TestSpotPool)
@@ -0,0 +1,40 @@
+#ifndef TESTSPOTPOOL_H
+#define TESTSPOTPOOL_H
+
+#include <QObject>
+#include <QSqlDatabase>
+#include <QTemporaryDir>
+#include <QTest>
+#include <memory>
+
+/**
+ * @brief Unit tests for SpotPool class
+ *
+ * Tests the jingle and pub rotation including:
+ * - Rounds that play every spot once, without a spot twice in a row
+ * - Weights giving a spot several plays per round
+ * - Reloads after invalidate() that probe only new files
+ * - Empty tables
+ */
+class TestSpotPool : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testRoundsWithoutRepeats();
+    void testWeights();
+    void testInvalidateReloads();
+    void testEmptyTable();
+
+private:
+    void addJingles(int count);
+
+    std::unique_ptr<QTemporaryDir> m_tempDir;
+    QSqlDatabase m_database;
+    int m_nextJingle = 1;
+};
+
+#endif // TESTSPOTPOOL_H
@@ -0,0 +1,95 @@
+#include "TestSpscQueue.h"
+#include "../../../src/services/SpscQueue.h"
+#include <QString>
+#include <QThread>
+#include <memory>
+
+void TestSpscQueue::testPushPopInOrder()
+{
+    SpscQueue<int> queue(8);
+    QVERIFY(queue.isEmpty());
+
+    for (int i = 0; i < 5; ++i) {
+        QVERIFY(queue.push(i));
+    }
+    QVERIFY(!queue.isEmpty());
+
+    int value = -1;
+    for (int i = 0; i < 5; ++i) {
+        QVERIFY(queue.pop(value));
+        QCOMPARE(value, i);
+    }
+    QVERIFY(!queue.pop(value));
+    QVERIFY(queue.isEmpty());
+}
+
+void TestSpscQueue::testFullQueueRefuses()
+{
+    SpscQueue<QString> queue(5);
+    QCOMPARE(queue.capacity(), 8);
+
+    for (int i = 0; i < 8; ++i) {
+        QVERIFY(queue.push(QString::number(i)));
+    }
+    QVERIFY(!queue.push("refused"));
+
+    // Taking one makes room for one, and the wrap keeps the order
+    QString value;
+    QVERIFY(queue.pop(value));
+    QCOMPARE(value, QString("0"));
+    QVERIFY(queue.push("8"));
+    for (int i = 1; i <= 8; ++i) {
+        QVERIFY(queue.pop(value));
+        QCOMPARE(value, QString::number(i));
+    }
+}
+
+void TestSpscQueue::testPopReleasesSlot()
+{
+    SpscQueue<std::shared_ptr<int>> queue(4);
+    auto owned = std::make_shared<int>(42);
+    QVERIFY(queue.push(owned));
+    QCOMPARE(owned.use_count(), 2L);
+
+    std::shared_ptr<int> taken;
+    QVERIFY(queue.pop(taken));
+    QCOMPARE(*taken, 42);
+    QCOMPARE(owned.use_count(), 2L);
+
+    taken.reset();
+    QCOMPARE(owned.use_count(), 1L);
+}
+
+void TestSpscQueue::testConcurrentProducerConsumer()
+{
+    const int total = 100000;
+    SpscQueue<int> queue(64);
+
+    QThread* producer = QThread::create([&queue]() {
+        for (int next = 0; next < total; ++next) {
+            while (!queue.push(next)) {
+                QThread::yieldCurrentThread();
+            }
+        }
+    });
+    producer->start();
+
+    bool ordered = true;
+    int expected = 0;
+    int value = 0;
+    while (expected < total) {
+        if (queue.pop(value)) {
+            if (value != expected) {
+                ordered = false;
+            }
+            ++expected;
+        }
+    }
+
+    producer->wait();
+    delete producer;
+    QVERIFY(ordered);
+    QVERIFY(queue.isEmpty());
+}
+
+QTEST_MAIN(TestSpscQueue)
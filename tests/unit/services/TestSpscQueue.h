@@ -0,0 +1,27 @@
+#ifndef TESTSPSCQUEUE_H
+#define TESTSPSCQUEUE_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for SpscQueue class
+ *
+ * Tests the message queue between the GUI and the audio thread including:
+ * - Messages taken in the order they were queued
+ * - Capacity rounded up, and pushes refused when full
+ * - Slots emptied by the consumer
+ * - One producer and one consumer thread running at once
+ */
+class TestSpscQueue : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testPushPopInOrder();
+    void testFullQueueRefuses();
+    void testPopReleasesSlot();
+    void testConcurrentProducerConsumer();
+};
+
+#endif // TESTSPSCQUEUE_H
@@ -0,0 +1,93 @@
+#include "TestStallWatchdog.h"
+#include "../../../src/services/StallWatchdog.h"
+#include <QRegularExpression>
+#include <QSignalSpy>
+#include <QThread>
+
+namespace {
+
+constexpr int THRESHOLD_MS = 150;
+
+// Kept out of line so the stack has a frame of its own to find
+Q_DECL_NOINLINE void blockEventLoop(int ms)
+{
+    TraceSpan span("test", "blockEventLoop");
+    QThread::msleep(ms);
+}
+
+} // namespace
+
+void TestStallWatchdog::testQuietWhileResponsive()
+{
+    StallWatchdog watchdog;
+    watchdog.setThresholdMs(THRESHOLD_MS);
+    QSignalSpy spy(&watchdog, &StallWatchdog::stalled);
+    watchdog.start();
+    QVERIFY(watchdog.isRunning());
+
+    QTest::qWait(4 * THRESHOLD_MS);
+    QCOMPARE(spy.count(), 0);
+}
+
+void TestStallWatchdog::testReportsStall()
+{
+    StallWatchdog watchdog;
+    watchdog.setThresholdMs(THRESHOLD_MS);
+    QSignalSpy spy(&watchdog, &StallWatchdog::stalled);
+    watchdog.start();
+    QTest::qWait(2 * StallWatchdog::HEARTBEAT_INTERVAL_MS);
+
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression("StallWatchdog: no answer for"));
+    const QDateTime before = QDateTime::currentDateTime();
+    blockEventLoop(3 * THRESHOLD_MS);
+
+    // Reported once the loop runs again, on this thread
+    QTRY_COMPARE(spy.count(), 1);
+    const StallWatchdog::Stall stall = spy.first().first().value<StallWatchdog::Stall>();
+    QVERIFY2(stall.durationMs >= 3 * THRESHOLD_MS, qPrintable(QString::number(stall.durationMs)));
+    QVERIFY(stall.started >= before.addMSecs(-2 * StallWatchdog::HEARTBEAT_INTERVAL_MS));
+    QCOMPARE(stall.spans, QStringList() << "test:blockEventLoop");
+
+    QTest::qWait(4 * THRESHOLD_MS);
+    QCOMPARE(spy.count(), 1);
+}
+
+void TestStallWatchdog::testCapturesStack()
+{
+    if (!StallWatchdog::canCaptureStack()) {
+        QSKIP("Call stacks are not taken on this platform");
+    }
+    StallWatchdog watchdog;
+    watchdog.setThresholdMs(THRESHOLD_MS);
+    QSignalSpy spy(&watchdog, &StallWatchdog::stalled);
+    watchdog.start();
+    QTest::qWait(2 * StallWatchdog::HEARTBEAT_INTERVAL_MS);
+
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression("StallWatchdog: no answer for"));
+    blockEventLoop(3 * THRESHOLD_MS);
+
+    QTRY_COMPARE(spy.count(), 1);
+    const StallWatchdog::Stall stall = spy.first().first().value<StallWatchdog::Stall>();
+    QVERIFY(!stall.stack.isEmpty());
+    QVERIFY(stall.stack.size() <= StallWatchdog::MAX_STACK_FRAMES);
+}
+
+void TestStallWatchdog::testStop()
+{
+    StallWatchdog watchdog;
+    watchdog.setThresholdMs(THRESHOLD_MS);
+    QSignalSpy spy(&watchdog, &StallWatchdog::stalled);
+    watchdog.start();
+    watchdog.stop();
+    QVERIFY(!watchdog.isRunning());
+
+    // Nobody is watching any more
+    blockEventLoop(2 * THRESHOLD_MS);
+    QTest::qWait(2 * StallWatchdog::HEARTBEAT_INTERVAL_MS);
+    QCOMPARE(spy.count(), 0);
+
+    watchdog.setThresholdMs(1);
+    QCOMPARE(watchdog.thresholdMs(), 2 * StallWatchdog::HEARTBEAT_INTERVAL_MS);
+}
+
+QTEST_MAIN(TestStallWatchdog)
@@ -0,0 +1,27 @@
+#ifndef TESTSTALLWATCHDOG_H
+#define TESTSTALLWATCHDOG_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for StallWatchdog class
+ *
+ * Tests the event loop watchdog including:
+ * - No stall while the event loop keeps running
+ * - A blocked thread reported once, with its duration and open spans
+ * - The call stack of the blocked thread where it can be taken
+ * - Stopping the watchdog thread
+ */
+class TestStallWatchdog : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testQuietWhileResponsive();
+    void testReportsStall();
+    void testCapturesStack();
+    void testStop();
+};
+
+#endif // TESTSTALLWATCHDOG_H
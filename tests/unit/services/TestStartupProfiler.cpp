@@ -0,0 +1,82 @@
+#include "TestStartupProfiler.h"
+#include "../../../src/services/StartupProfiler.h"
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QThread>
+
+void TestStartupProfiler::cleanup()
+{
+    Tracer::setEnabled(false);
+    Tracer::clear();
+}
+
+void TestStartupProfiler::testPhasesFollowEachOther()
+{
+    StartupProfiler profiler;
+    QVERIFY(!profiler.isRunning());
+    QCOMPARE(profiler.totalNs(), qint64(0));
+
+    profiler.begin("first");
+    QThread::msleep(20);
+    profiler.begin("second");
+    QVERIFY(profiler.isRunning());
+    QThread::msleep(10);
+    profiler.end();
+    QVERIFY(!profiler.isRunning());
+
+    const std::vector<StartupProfiler::Phase>& phases = profiler.phases();
+    QCOMPARE(phases.size(), size_t(2));
+    QCOMPARE(QByteArray(phases[0].name), QByteArray("first"));
+    QCOMPARE(QByteArray(phases[1].name), QByteArray("second"));
+    QVERIFY(phases[0].durationNs >= 20 * 1000000LL);
+    QVERIFY(phases[1].durationNs >= 10 * 1000000LL);
+    QVERIFY(phases[1].startNs >= phases[0].startNs + phases[0].durationNs);
+
+    // A second end() changes nothing
+    const qint64 total = profiler.totalNs();
+    profiler.end();
+    QCOMPARE(profiler.totalNs(), total);
+    QVERIFY(total >= phases[0].durationNs + phases[1].durationNs);
+}
+
+void TestStartupProfiler::testSummary()
+{
+    StartupProfiler profiler;
+    profiler.begin("ui");
+    QThread::msleep(5);
+    profiler.begin("database");
+    profiler.end();
+
+    const QString summary = profiler.summary();
+    QVERIFY2(summary.startsWith("ui "), qPrintable(summary));
+    QVERIFY2(summary.contains(", database "), qPrintable(summary));
+    QVERIFY2(summary.contains("(total "), qPrintable(summary));
+    QVERIFY2(summary.endsWith(" ms)"), qPrintable(summary));
+}
+
+void TestStartupProfiler::testRecordsTraceSpans()
+{
+    Tracer::clear();
+    Tracer::setEnabled(true);
+    {
+        StartupProfiler profiler;
+        profiler.begin("traced");
+        profiler.end();
+    }
+    Tracer::setEnabled(false);
+
+    const QJsonArray events =
+        QJsonDocument::fromJson(Tracer::toChromeTrace()).object().value("traceEvents").toArray();
+    bool found = false;
+    for (const QJsonValue& value : events) {
+        const QJsonObject event = value.toObject();
+        if (event.value("name").toString() == "traced") {
+            QCOMPARE(event.value("cat").toString(), QString("startup"));
+            found = true;
+        }
+    }
+    QVERIFY(found);
+}
+
+QTEST_MAIN(TestStartupProfiler)
@@ -0,0 +1,27 @@
+#ifndef TESTSTARTUPPROFILER_H
+#define TESTSTARTUPPROFILER_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for StartupProfiler class
+ *
+ * Tests the startup phase timing including:
+ * - Phases that follow one another, each ended by the next
+ * - The summary line and the total
+ * - Phases recorded as trace spans while tracing is on
+ */
+class TestStartupProfiler : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void cleanup();
+
+    void testPhasesFollowEachOther();
+    void testSummary();
+    void testRecordsTraceSpans();
+};
+
+#endif // TESTSTARTUPPROFILER_H
@@ -0,0 +1,203 @@
+#include "TestStreamOutput.h"
+#include "../../../src/services/StreamOutput.h"
+#include <QDir>
+#include <QHash>
+#include <QHostAddress>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+#include <QtEndian>
+#include <algorithm>
+#include <memory>
+
+namespace {
+
+/// Accepts every source connection and keeps each mount's stream body.
+class FakeIcecastServer
+{
+public:
+    FakeIcecastServer()
+    {
+        m_server.listen(QHostAddress::LocalHost);
+        QObject::connect(&m_server, &QTcpServer::newConnection, &m_server, [this]() {
+            while (QTcpSocket* socket = m_server.nextPendingConnection()) {
+                accept(socket);
+            }
+        });
+    }
+
+    quint16 port() const { return m_server.serverPort(); }
+
+    QHash<QString, QByteArray> received;
+
+private:
+    void accept(QTcpSocket* socket)
+    {
+        auto buffer = std::make_shared<QByteArray>();
+        auto mount = std::make_shared<QString>();
+        QObject::connect(socket, &QTcpSocket::readyRead, socket, [this, socket, buffer, mount]() {
+            if (!mount->isEmpty()) {
+                received[*mount] += socket->readAll();
+                return;
+            }
+            *buffer += socket->readAll();
+            const qsizetype end = buffer->indexOf("\r\n\r\n");
+            if (end < 0) {
+                return;
+            }
+            *mount = QString::fromUtf8(buffer->left(buffer->indexOf("\r\n"))).split(' ').value(1);
+            received[*mount] += buffer->mid(end + 4);
+            socket->write("HTTP/1.1 100 Continue\r\n\r\n");
+        });
+    }
+
+    QTcpServer m_server;
+};
+
+QByteArray oggPage(qint64 granule, const QByteArray& body)
+{
+    QByteArray page("OggS");
+    page += char(0);                       // version
+    page += char(0);                       // header type
+    char position[8];
+    qToLittleEndian<qint64>(granule, position);
+    page += QByteArray(position, 8);
+    page += QByteArray(12, '\0');          // serial, sequence, checksum
+    page += char(1);                       // one segment
+    page += char(body.size());
+    page += body;
+    return page;
+}
+
+} // namespace
+
+void TestStreamOutput::testParseMounts()
+{
+    QList<StreamOutput::Mount> mounts;
+    QVERIFY(StreamOutput::parseMounts("/live.ogg=opus:96, live.mp3 = MP3:128,", mounts));
+    QCOMPARE(mounts.size(), 2);
+    QCOMPARE(mounts[0].path, QString("/live.ogg"));
+    QCOMPARE(mounts[0].codec, StreamOutput::Codec::Opus);
+    QCOMPARE(mounts[0].bitrateKbps, 96);
+    QCOMPARE(mounts[1].path, QString("/live.mp3"));
+    QCOMPARE(mounts[1].codec, StreamOutput::Codec::Mp3);
+    QCOMPARE(mounts[1].bitrateKbps, 128);
+
+    QVERIFY(!StreamOutput::parseMounts("/live.aac=aac:128", mounts));
+    QVERIFY(!StreamOutput::parseMounts("/live.ogg=vorbis", mounts));
+    QVERIFY(!StreamOutput::parseMounts("/live.ogg=vorbis:0", mounts));
+    QVERIFY(!StreamOutput::parseMounts("", mounts));
+}
+
+void TestStreamOutput::testEncoderArguments()
+{
+    const QStringList opus = StreamOutput::encoderArguments(StreamOutput::Codec::Opus, 96, 44100);
+    QVERIFY(opus.contains("libopus"));
+    QVERIFY(opus.contains("96k"));
+    QVERIFY(opus.contains("48000"));
+    QCOMPARE(opus.at(opus.indexOf("-ar") + 1), QString("44100"));
+    QCOMPARE(opus.at(opus.indexOf("-f", opus.indexOf("-i")) + 1), QString("ogg"));
+    QCOMPARE(opus.last(), QString("pipe:1"));
+
+    const QStringList mp3 = StreamOutput::encoderArguments(StreamOutput::Codec::Mp3, 128, 48000);
+    QVERIFY(mp3.contains("libmp3lame"));
+    QVERIFY(mp3.contains("128k"));
+    QCOMPARE(mp3.at(mp3.indexOf("-f", mp3.indexOf("-i")) + 1), QString("mp3"));
+
+    const QStringList hls =
+        StreamOutput::hlsEncoderArguments(StreamOutput::Codec::Aac, 128, 44100, 6000);
+    QCOMPARE(hls.at(hls.indexOf("-c:a") + 1), QString("aac"));
+    QCOMPARE(hls.at(hls.indexOf("-f", hls.indexOf("-i")) + 1), QString("mp4"));
+    QVERIFY(hls.at(hls.indexOf("-movflags") + 1).contains("empty_moov"));
+    QCOMPARE(hls.at(hls.indexOf("-frag_duration") + 1), QString("6000000"));
+    QCOMPARE(hls.last(), QString("pipe:1"));
+
+    QCOMPARE(StreamOutput::contentType(StreamOutput::Codec::Vorbis), QString("audio/ogg"));
+    QCOMPARE(StreamOutput::contentType(StreamOutput::Codec::Mp3), QString("audio/mpeg"));
+}
+
+void TestStreamOutput::testOggHeaderLength()
+{
+    const QByteArray head = oggPage(0, "OpusHead");
+    const QByteArray tags = oggPage(0, "OpusTags");
+    const QByteArray audio = oggPage(960, "audio");
+
+    QCOMPARE(StreamOutput::oggHeaderLength(head + tags + audio), head.size() + tags.size());
+    // The last header page is only known once the first audio page shows up
+    QCOMPARE(StreamOutput::oggHeaderLength(head + tags), qsizetype(-1));
+    QCOMPARE(StreamOutput::oggHeaderLength(head + tags + audio.left(10)), qsizetype(-1));
+    QCOMPARE(StreamOutput::oggHeaderLength(head.left(5)), qsizetype(-1));
+    QCOMPARE(StreamOutput::oggHeaderLength(QByteArray("\xff\xfb\x90\x00 mp3 frame")), qsizetype(0));
+}
+
+void TestStreamOutput::testMountsShareEncoder()
+{
+    FakeIcecastServer server;
+
+    QList<StreamOutput::Mount> mounts;
+    QVERIFY(StreamOutput::parseMounts("/a.mp3=mp3:128, /b.mp3=mp3:128, /c.mp3=mp3:64", mounts));
+
+    StreamOutput output;
+    // cat stands in for ffmpeg, so what arrives is the PCM itself
+    output.setEncoder("cat", [](StreamOutput::Codec, int, int) { return QStringList(); });
+    output.setSource(
+        [](float* data, int samples) {
+            const int count = std::min(samples / 2, 64) / 2 * 2;
+            std::fill(data, data + count, 0.25f);
+            return count;
+        },
+        48000);
+    output.setServer("127.0.0.1", server.port(), "hackme");
+    output.setMounts(mounts);
+
+    QVERIFY(output.start());
+    QVERIFY(output.isRunning());
+    QCOMPARE(output.encoderCount(), 2);
+
+    QTRY_COMPARE_WITH_TIMEOUT(output.mountState("/a.mp3"), IcecastSource::State::Streaming, 5000);
+    QTRY_COMPARE_WITH_TIMEOUT(output.mountState("/b.mp3"), IcecastSource::State::Streaming, 5000);
+    QTRY_COMPARE_WITH_TIMEOUT(output.mountState("/c.mp3"), IcecastSource::State::Streaming, 5000);
+
+    QTRY_VERIFY_WITH_TIMEOUT(server.received.value("/a.mp3").size() >= 1024, 5000);
+    QTRY_VERIFY_WITH_TIMEOUT(server.received.value("/b.mp3").size() >= 1024, 5000);
+    QTRY_VERIFY_WITH_TIMEOUT(server.received.value("/c.mp3").size() >= 1024, 5000);
+
+    output.stop();
+    QVERIFY(!output.isRunning());
+    QCOMPARE(output.encoderCount(), 0);
+    QCOMPARE(output.mountState("/a.mp3"), IcecastSource::State::Disconnected);
+}
+
+void TestStreamOutput::testStartRequiresSource()
+{
+    StreamOutput output;
+    output.setServer("127.0.0.1", 8000, "hackme");
+    output.setMounts({{"/live.mp3", StreamOutput::Codec::Mp3, 128}});
+    QVERIFY(!output.start());
+    QVERIFY(!output.isRunning());
+}
+
+void TestStreamOutput::testHlsOutput()
+{
+    QTemporaryDir dir;
+    StreamOutput output;
+    output.setEncoder("cat", [](StreamOutput::Codec, int, int) { return QStringList(); });
+    output.setSource([](float*, int) { return 0; }, 48000);
+
+    StreamOutput::Hls hls;
+    hls.target = dir.filePath("hls");
+    hls.codec = StreamOutput::Codec::Mp3;
+    output.setHls(hls);
+    QVERIFY(!output.start());
+
+    // HLS alone needs no Icecast server
+    hls.codec = StreamOutput::Codec::Opus;
+    output.setHls(hls);
+    QVERIFY(output.start());
+    QCOMPARE(output.encoderCount(), 1);
+    QVERIFY(QDir(hls.target).exists());
+    output.stop();
+    QCOMPARE(output.encoderCount(), 0);
+}
+
+QTEST_MAIN(TestStreamOutput)
@@ -0,0 +1,31 @@
+#ifndef TESTSTREAMOUTPUT_H
+#define TESTSTREAMOUTPUT_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for StreamOutput class
+ *
+ * Tests the built-in streaming output including:
+ * - Parsing mount lists
+ * - ffmpeg command lines per codec
+ * - Finding the end of Ogg header pages
+ * - One encoder shared by mounts with the same encoding
+ * - Refusing to start without a source
+ * - An HLS output with or without mounts
+ */
+class TestStreamOutput : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testParseMounts();
+    void testEncoderArguments();
+    void testOggHeaderLength();
+    void testMountsShareEncoder();
+    void testStartRequiresSource();
+    void testHlsOutput();
+};
+
+#endif // TESTSTREAMOUTPUT_H
@@ -0,0 +1,227 @@
+#include "TestStreamingExporter.h"
+#include "../../../src/services/StreamingExporter.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSignalSpy>
+#include <QSqlQuery>
+
+namespace {
+
+const char* CONNECTION_NAME = "test_streaming_exporter_connection";
+
+StreamingExporter::Job itemsJob(const QString& databasePath, const QString& outputPath,
+                                StreamingExporter::Format format)
+{
+    StreamingExporter::Job job;
+    job.databasePath = databasePath;
+    job.query = "SELECT id, name, score, note FROM items ORDER BY id";
+    job.outputPath = outputPath;
+    job.format = format;
+    return job;
+}
+
+} // namespace
+
+void TestStreamingExporter::init()
+{
+    m_tempDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_tempDir->isValid());
+
+    m_database = QSqlDatabase::addDatabase("QSQLITE", CONNECTION_NAME);
+    m_database.setDatabaseName(m_tempDir->filePath("export.db"));
+    QVERIFY(m_database.open());
+
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("CREATE TABLE items (id INTEGER PRIMARY KEY, name TEXT, score REAL, "
+                       "note TEXT)"));
+}
+
+void TestStreamingExporter::cleanup()
+{
+    if (m_database.isOpen()) {
+        m_database.close();
+    }
+    m_database = QSqlDatabase();
+    QSqlDatabase::removeDatabase(CONNECTION_NAME);
+    m_tempDir.reset();
+}
+
+void TestStreamingExporter::addItems(int count)
+{
+    QVERIFY(m_database.transaction());
+    QSqlQuery query(m_database);
+    query.prepare("INSERT INTO items (name, score) VALUES (?, ?)");
+    for (int i = 0; i < count; ++i) {
+        query.addBindValue(QString("Item %1").arg(i));
+        query.addBindValue(i / 2.0);
+        QVERIFY(query.exec());
+    }
+    QVERIFY(m_database.commit());
+}
+
+QByteArray TestStreamingExporter::readFile(const QString& path) const
+{
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+void TestStreamingExporter::testCsvQuoting()
+{
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("INSERT INTO items VALUES (1, 'Plain', 1.5, NULL)"));
+    QVERIFY(query.exec("INSERT INTO items VALUES (2, 'Comma, inside', 2, 'Say \"hi\"')"));
+    QVERIFY(query.exec("INSERT INTO items VALUES (3, 'Two' || char(10) || 'lines', NULL, '')"));
+
+    const QString path = outputPath("items.csv");
+    const StreamingExporter::Result result = StreamingExporter::run(
+        itemsJob(m_database.databaseName(), path, StreamingExporter::Format::Csv));
+    QVERIFY2(result.succeeded(), qPrintable(result.error));
+    QCOMPARE(result.rows, qint64(3));
+    QCOMPARE(result.bytes, QFileInfo(path).size());
+
+    QCOMPARE(readFile(path), QByteArray("id,name,score,note\r\n"
+                                        "1,Plain,1.5,\r\n"
+                                        "2,\"Comma, inside\",2,\"Say \"\"hi\"\"\"\r\n"
+                                        "3,\"Two\nlines\",,\r\n"));
+    QVERIFY(!QFile::exists(path + ".part"));
+}
+
+void TestStreamingExporter::testJsonLines()
+{
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("INSERT INTO items VALUES (1, 'Tab\there \\ \"q\"', 0.25, NULL)"));
+    QVERIFY(query.exec("INSERT INTO items VALUES (2, 'Café', -3, 'x')"));
+
+    const QString path = outputPath("items.jsonl");
+    const StreamingExporter::Result result = StreamingExporter::run(
+        itemsJob(m_database.databaseName(), path, StreamingExporter::Format::JsonLines));
+    QVERIFY2(result.succeeded(), qPrintable(result.error));
+
+    const QList<QByteArray> lines = readFile(path).split('\n');
+    QCOMPARE(lines.size(), 3);
+    QVERIFY(lines.last().isEmpty());
+
+    // Keys stay in column order, which QJsonObject would not keep
+    QVERIFY(lines.at(0).startsWith("{\"id\":1,\"name\":"));
+
+    QJsonParseError error;
+    const QJsonObject first = QJsonDocument::fromJson(lines.at(0), &error).object();
+    QCOMPARE(error.error, QJsonParseError::NoError);
+    QCOMPARE(first.value("name").toString(), QString("Tab\there \\ \"q\""));
+    QCOMPARE(first.value("score").toDouble(), 0.25);
+    QVERIFY(first.value("note").isNull());
+
+    const QJsonObject second = QJsonDocument::fromJson(lines.at(1), &error).object();
+    QCOMPARE(error.error, QJsonParseError::NoError);
+    QCOMPARE(second.value("id").toInt(), 2);
+    QCOMPARE(second.value("name").toString(), QString("Café"));
+    QCOMPARE(second.value("score").toDouble(), -3.0);
+}
+
+void TestStreamingExporter::testLibraryJob()
+{
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("CREATE TABLE musics (id INTEGER PRIMARY KEY, artist TEXT, song TEXT, "
+                       "genre1 TEXT, genre2 TEXT, country TEXT, published_date TEXT, path TEXT, "
+                       "time TEXT, played_times INTEGER, last_played TEXT)"));
+    QVERIFY(query.exec("INSERT INTO musics VALUES (4, 'Artist', 'Song', 'Rock', '', 'PT', "
+                       "'2001', '/music/a.ogg', '3:30', 7, NULL)"));
+
+    const QString path = outputPath("library.csv");
+    const StreamingExporter::Result result = StreamingExporter::run(StreamingExporter::libraryJob(
+        m_database.databaseName(), path, StreamingExporter::Format::Csv));
+    QVERIFY2(result.succeeded(), qPrintable(result.error));
+    QCOMPARE(result.rows, qint64(1));
+    QCOMPARE(readFile(path).split('\n').at(1),
+             QByteArray("4,Artist,Song,Rock,,PT,2001,/music/a.ogg,3:30,7,\r"));
+}
+
+void TestStreamingExporter::testProgressAndCancel()
+{
+    addItems(2500);
+    const StreamingExporter::Job job = itemsJob(m_database.databaseName(), outputPath("items.csv"),
+                                                StreamingExporter::Format::Csv);
+
+    QVector<QPair<qint64, qint64>> calls;
+    StreamingExporter::Result result = StreamingExporter::run(
+        job, [&calls](qint64 rows, qint64 total) { calls.append({rows, total}); });
+    QVERIFY(result.succeeded());
+    QCOMPARE(calls, (QVector<QPair<qint64, qint64>>({{1000, 2500}, {2000, 2500}, {2500, 2500}})));
+    QCOMPARE(readFile(job.outputPath).count('\n'), 2501);
+
+    // A cancelled export leaves the previous file as it was
+    std::atomic_bool cancelled(false);
+    result = StreamingExporter::run(
+        job, [&cancelled](qint64, qint64) { cancelled = true; }, &cancelled);
+    QVERIFY(result.cancelled);
+    QVERIFY(!result.succeeded());
+    QCOMPARE(result.rows, qint64(StreamingExporter::PROGRESS_ROWS));
+    QCOMPARE(readFile(job.outputPath).count('\n'), 2501);
+    QVERIFY(!QFile::exists(job.outputPath + ".part"));
+}
+
+void TestStreamingExporter::testFailureLeavesNoFile()
+{
+    StreamingExporter::Job job = itemsJob(m_database.databaseName(), outputPath("items.csv"),
+                                          StreamingExporter::Format::Csv);
+    job.query = "SELECT missing FROM items";
+
+    StreamingExporter::Result result = StreamingExporter::run(job);
+    QVERIFY(!result.succeeded());
+    QVERIFY(!result.error.isEmpty());
+    QVERIFY(!QFile::exists(job.outputPath));
+    QVERIFY(!QFile::exists(job.outputPath + ".part"));
+
+    job = itemsJob(m_tempDir->filePath("none/missing.db"), outputPath("other.csv"),
+                   StreamingExporter::Format::Csv);
+    result = StreamingExporter::run(job);
+    QVERIFY(!result.succeeded());
+    QVERIFY(!QFile::exists(job.outputPath + ".part"));
+}
+
+void TestStreamingExporter::testGzip()
+{
+    addItems(3000);
+    StreamingExporter::Job job = itemsJob(m_database.databaseName(), outputPath("items.csv.gz"),
+                                          StreamingExporter::Format::Csv);
+    job.gzip = true;
+
+    const StreamingExporter::Result result = StreamingExporter::run(job);
+    if (!StreamingExporter::isGzipAvailable()) {
+        QVERIFY(!result.succeeded());
+        QVERIFY(!QFile::exists(job.outputPath));
+        QSKIP("Built without zlib");
+    }
+    QVERIFY2(result.succeeded(), qPrintable(result.error));
+    const QByteArray data = readFile(job.outputPath);
+    QVERIFY(data.startsWith("\x1f\x8b"));
+
+    job.gzip = false;
+    job.outputPath = outputPath("items.csv");
+    QVERIFY(StreamingExporter::run(job).succeeded());
+    QVERIFY(data.size() < QFileInfo(job.outputPath).size() / 2);
+}
+
+void TestStreamingExporter::testStart()
+{
+    addItems(1500);
+    StreamingExporter exporter;
+    QSignalSpy progress(&exporter, &StreamingExporter::progressChanged);
+    QSignalSpy finished(&exporter, &StreamingExporter::finished);
+
+    QVERIFY(exporter.start(itemsJob(m_database.databaseName(), outputPath("items.jsonl"),
+                                    StreamingExporter::Format::JsonLines)));
+    QVERIFY(finished.wait());
+    const auto result = finished.at(0).at(0).value<StreamingExporter::Result>();
+    QVERIFY2(result.succeeded(), qPrintable(result.error));
+    QCOMPARE(result.rows, qint64(1500));
+    QVERIFY(!exporter.isRunning());
+
+    // Queued from the worker before finished() was
+    QCOMPARE(progress.count(), 2);
+    QCOMPARE(progress.last().at(0).toLongLong(), qint64(1500));
+}
+
+QTEST_MAIN(TestStreamingExporter)
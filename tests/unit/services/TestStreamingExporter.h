@@ -0,0 +1,46 @@
+#ifndef TESTSTREAMINGEXPORTER_H
+#define TESTSTREAMINGEXPORTER_H
+
+#include <QObject>
+#include <QTest>
+#include <QSqlDatabase>
+#include <QTemporaryDir>
+#include <memory>
+
+/**
+ * @brief Unit tests for StreamingExporter class
+ *
+ * Tests the CSV and JSON lines export including:
+ * - CSV header and RFC 4180 quoting of commas, quotes and line breaks
+ * - JSON lines keeping column order, numbers and nulls
+ * - Progress every PROGRESS_ROWS rows and cancelling midway
+ * - No file, nor ".part" file, left by a failed export
+ * - gzip output where the build has zlib
+ * - Running in the background
+ */
+class TestStreamingExporter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testCsvQuoting();
+    void testJsonLines();
+    void testLibraryJob();
+    void testProgressAndCancel();
+    void testFailureLeavesNoFile();
+    void testGzip();
+    void testStart();
+
+private:
+    void addItems(int count);
+    QString outputPath(const QString& name) const { return m_tempDir->filePath(name); }
+    QByteArray readFile(const QString& path) const;
+
+    std::unique_ptr<QTemporaryDir> m_tempDir;
+    QSqlDatabase m_database;
+};
+
+#endif // TESTSTREAMINGEXPORTER_H
@@ -0,0 +1,100 @@
+#include "TestTableChangeBus.h"
+#include "../../../src/services/TableChangeBus.h"
+#include <QList>
+#include <QSignalSpy>
+#include <QThread>
+
+void TestTableChangeBus::testCoalescesPerTable()
+{
+    TableChangeBus bus;
+    QList<TableChangeBus::Change> changes;
+    connect(&bus, &TableChangeBus::tableChanged, this,
+            [&changes](const TableChangeBus::Change& change) { changes.append(change); });
+
+    bus.notifyChanged("musics", {7, 3});
+    bus.notifyChanged("jingles", {1});
+    bus.notifyChanged("musics", {3, 5});
+    bus.notifyRemoved("musics", {9});
+    bus.notifyChanged("musics", {});
+    QCOMPARE(bus.pendingTables(), QStringList({"musics", "jingles"}));
+    QVERIFY(changes.isEmpty());
+
+    QTRY_COMPARE(changes.size(), 2);
+    QCOMPARE(changes.at(0).table, QString("musics"));
+    QCOMPARE(changes.at(0).changed, QList<qint64>({3, 5, 7}));
+    QCOMPARE(changes.at(0).removed, QList<qint64>({9}));
+    QVERIFY(!changes.at(0).reset);
+    QCOMPARE(changes.at(1).table, QString("jingles"));
+    QCOMPARE(changes.at(1).changed, QList<qint64>({1}));
+    QVERIFY(bus.pendingTables().isEmpty());
+}
+
+void TestTableChangeBus::testLastPostWins()
+{
+    TableChangeBus bus;
+    QSignalSpy spy(&bus, &TableChangeBus::tableChanged);
+
+    bus.notifyChanged("musics", {1, 2});
+    bus.notifyRemoved("musics", {1, 3});
+    bus.notifyChanged("musics", {3});
+    bus.flush();
+
+    QCOMPARE(spy.count(), 1);
+    const auto change = spy.at(0).at(0).value<TableChangeBus::Change>();
+    QCOMPARE(change.changed, QList<qint64>({2, 3}));
+    QCOMPARE(change.removed, QList<qint64>({1}));
+
+    // Nothing waiting, nothing delivered
+    bus.flush();
+    QCOMPARE(spy.count(), 1);
+}
+
+void TestTableChangeBus::testReset()
+{
+    TableChangeBus bus;
+    QSignalSpy spy(&bus, &TableChangeBus::tableChanged);
+
+    bus.notifyChanged("pub", {1});
+    bus.notifyReset("pub");
+    bus.notifyRemoved("pub", {2});
+    bus.flush();
+    QCOMPARE(spy.count(), 1);
+    auto change = spy.at(0).at(0).value<TableChangeBus::Change>();
+    QVERIFY(change.reset);
+    QVERIFY(change.changed.isEmpty());
+    QVERIFY(change.removed.isEmpty());
+
+    QList<qint64> keys;
+    for (qint64 key = 1; key <= TableChangeBus::MAX_KEYS; ++key) {
+        keys.append(key);
+    }
+    bus.notifyChanged("musics", keys);
+    bus.flush();
+    change = spy.at(1).at(0).value<TableChangeBus::Change>();
+    QVERIFY(!change.reset);
+    QCOMPARE(change.changed.size(), TableChangeBus::MAX_KEYS);
+
+    bus.notifyChanged("musics", keys);
+    bus.notifyRemoved("musics", {TableChangeBus::MAX_KEYS + 1});
+    bus.flush();
+    change = spy.at(2).at(0).value<TableChangeBus::Change>();
+    QVERIFY(change.reset);
+    QVERIFY(change.changed.isEmpty());
+}
+
+void TestTableChangeBus::testPostFromOtherThread()
+{
+    TableChangeBus bus;
+    QSignalSpy spy(&bus, &TableChangeBus::tableChanged);
+
+    QThread* thread = QThread::create([&bus]() { bus.notifyChanged("musics", {42}); });
+    thread->start();
+    QVERIFY(thread->wait(5000));
+    delete thread;
+
+    QTRY_COMPARE(spy.count(), 1);
+    const auto change = spy.at(0).at(0).value<TableChangeBus::Change>();
+    QCOMPARE(change.changed, QList<qint64>({42}));
+}
+
+QTEST_MAIN(TestTableChangeBus)
@@ -0,0 +1,27 @@
+#ifndef TESTTABLECHANGEBUS_H
+#define TESTTABLECHANGEBUS_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for TableChangeBus class
+ *
+ * Tests the table change notifications including:
+ * - Posts delivered together from the event loop, one change per table
+ * - A row changed then removed delivered as removed, and the other way round
+ * - Resets, and too many rows turned into one
+ * - Posts from another thread queued to the bus
+ */
+class TestTableChangeBus : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testCoalescesPerTable();
+    void testLastPostWins();
+    void testReset();
+    void testPostFromOtherThread();
+};
+
+#endif // TESTTABLECHANGEBUS_H
@@ -0,0 +1,400 @@
+#include "TestTagReader.h"
+#include "../../../src/services/TagReader.h"
+#include <QFile>
+#include <QtEndian>
+
+namespace {
+
+void appendLE32(QByteArray& data, quint32 value)
+{
+    char buf[4];
+    qToLittleEndian(value, buf);
+    data.append(buf, 4);
+}
+
+void appendBE32(QByteArray& data, quint32 value)
+{
+    char buf[4];
+    qToBigEndian(value, buf);
+    data.append(buf, 4);
+}
+
+void appendSynchsafe(QByteArray& data, quint32 value)
+{
+    data.append(char((value >> 21) & 0x7F));
+    data.append(char((value >> 14) & 0x7F));
+    data.append(char((value >> 7) & 0x7F));
+    data.append(char(value & 0x7F));
+}
+
+QByteArray id3Frame(int major, const QByteArray& id, const QByteArray& payload)
+{
+    QByteArray frame(id);
+    if (major == 2) {
+        frame.append(char((payload.size() >> 16) & 0xFF));
+        frame.append(char((payload.size() >> 8) & 0xFF));
+        frame.append(char(payload.size() & 0xFF));
+    } else {
+        if (major == 3) {
+            appendBE32(frame, payload.size());
+        } else {
+            appendSynchsafe(frame, payload.size());
+        }
+        frame.append(2, '\0'); // flags
+    }
+    frame.append(payload);
+    return frame;
+}
+
+QByteArray id3Tag(int major, const QByteArray& frames)
+{
+    const int padding = 64;
+    QByteArray tag("ID3");
+    tag.append(char(major));
+    tag.append(char(0)); // revision
+    tag.append(char(0)); // flags
+    appendSynchsafe(tag, frames.size() + padding);
+    tag.append(frames);
+    tag.append(padding, '\0');
+    return tag;
+}
+
+QByteArray latin1Text(const QByteArray& text)
+{
+    return char(0) + text;
+}
+
+QByteArray utf8Text(const QString& text)
+{
+    return char(3) + text.toUtf8();
+}
+
+QByteArray utf16Text(const QString& text)
+{
+    QByteArray data;
+    data.append(char(1));
+    data.append("\xFF\xFE", 2);
+    for (const QChar c : text) {
+        data.append(char(c.unicode() & 0xFF));
+        data.append(char(c.unicode() >> 8));
+    }
+    return data;
+}
+
+QByteArray mp3Frames(int count)
+{
+    // MPEG1 layer III, 128 kbps, 44.1 kHz, stereo: 417 byte frames
+    QByteArray frame = QByteArray::fromHex("FFFB9000");
+    frame.append(QByteArray(417 - 4, 0));
+
+    QByteArray data;
+    for (int i = 0; i < count; ++i) {
+        data.append(frame);
+    }
+    return data;
+}
+
+QByteArray vorbisComment(const QList<QByteArray>& entries)
+{
+    QByteArray comment;
+    const QByteArray vendor("XFB test");
+    appendLE32(comment, vendor.size());
+    comment.append(vendor);
+    appendLE32(comment, entries.size());
+    for (const QByteArray& entry : entries) {
+        appendLE32(comment, entry.size());
+        comment.append(entry);
+    }
+    return comment;
+}
+
+QByteArray oggPage(quint32 serial, const QByteArray& data, bool continued, bool complete)
+{
+    // A packet that does not end on this page fills whole 255 byte segments
+    QByteArray lacing;
+    int left = data.size();
+    while (left >= 255) {
+        lacing.append(char(255));
+        left -= 255;
+    }
+    if (complete) {
+        lacing.append(char(left));
+    }
+
+    QByteArray page("OggS");
+    page.append(char(0));                  // version
+    page.append(char(continued ? 0x01 : 0)); // header type
+    page.append(8, '\0');                  // granule position
+    appendLE32(page, serial);
+    appendLE32(page, 0); // sequence
+    appendLE32(page, 0); // checksum (not verified by the reader)
+    page.append(char(lacing.size()));
+    page.append(lacing);
+    page.append(data);
+    return page;
+}
+
+QByteArray box(const QByteArray& type, const QByteArray& payload)
+{
+    QByteArray data;
+    appendBE32(data, 8 + payload.size());
+    data.append(type);
+    data.append(payload);
+    return data;
+}
+
+QByteArray dataBox(quint32 valueType, const QByteArray& value)
+{
+    QByteArray payload;
+    appendBE32(payload, valueType);
+    appendBE32(payload, 0); // locale
+    payload.append(value);
+    return box("data", payload);
+}
+
+QByteArray riffChunk(const QByteArray& id, const QByteArray& payload)
+{
+    QByteArray chunk(id);
+    appendLE32(chunk, payload.size());
+    chunk.append(payload);
+    if (payload.size() % 2) {
+        chunk.append('\0');
+    }
+    return chunk;
+}
+
+} // namespace
+
+void TestTagReader::init()
+{
+    m_tempDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_tempDir->isValid());
+}
+
+void TestTagReader::cleanup()
+{
+    m_tempDir.reset();
+}
+
+void TestTagReader::testId3v24()
+{
+    // Cover art ahead of the text frames is stepped over
+    QByteArray frames;
+    frames.append(id3Frame(4, "APIC", QByteArray(200000, 'x')));
+    frames.append(id3Frame(4, "TPE1", utf8Text(QString::fromUtf8("Sigur R\xC3\xB3s"))));
+    frames.append(id3Frame(4, "TIT2", utf8Text("Hoppipolla")));
+    frames.append(id3Frame(4, "TALB", utf8Text("Takk...")));
+    frames.append(id3Frame(4, "TCON", latin1Text("(17)")));
+    frames.append(id3Frame(4, "TDRC", latin1Text("2005-09-12")));
+
+    QString error;
+    const TagReader::Tags tags =
+        TagReader::read(writeFile("v24.mp3", id3Tag(4, frames) + mp3Frames(100)), &error);
+    QVERIFY(error.isEmpty());
+    QCOMPARE(tags.artist, QString::fromUtf8("Sigur R\xC3\xB3s"));
+    QCOMPARE(tags.title, QString("Hoppipolla"));
+    QCOMPARE(tags.album, QString("Takk..."));
+    QCOMPARE(tags.genre, QString("Rock"));
+    QCOMPARE(tags.year, QString("2005"));
+    QCOMPARE(tags.format, QString("ID3v2.4"));
+    QVERIFY(tags.durationUs > 0);
+    QVERIFY(!tags.durationString().isEmpty());
+}
+
+void TestTagReader::testId3v23Utf16()
+{
+    QByteArray frames;
+    frames.append(id3Frame(3, "TPE1", utf16Text(QString::fromUtf8("Bj\xC3\xB6rk"))));
+    frames.append(id3Frame(3, "TIT2", utf16Text("Joga")));
+    frames.append(id3Frame(3, "TCON", latin1Text("(131)Art Pop")));
+    frames.append(id3Frame(3, "TYER", latin1Text("1997")));
+
+    const TagReader::Tags tags =
+        TagReader::read(writeFile("v23.mp3", id3Tag(3, frames) + mp3Frames(10)));
+    QCOMPARE(tags.artist, QString::fromUtf8("Bj\xC3\xB6rk"));
+    QCOMPARE(tags.title, QString("Joga"));
+    QCOMPARE(tags.genre, QString("Art Pop"));
+    QCOMPARE(tags.year, QString("1997"));
+    QCOMPARE(tags.format, QString("ID3v2.3"));
+}
+
+void TestTagReader::testId3v22()
+{
+    QByteArray frames;
+    frames.append(id3Frame(2, "TP1", latin1Text("Old Artist")));
+    frames.append(id3Frame(2, "TT2", latin1Text("Old Song")));
+    frames.append(id3Frame(2, "TCO", latin1Text("8")));
+
+    const TagReader::Tags tags =
+        TagReader::read(writeFile("v22.mp3", id3Tag(2, frames) + mp3Frames(10)));
+    QCOMPARE(tags.artist, QString("Old Artist"));
+    QCOMPARE(tags.title, QString("Old Song"));
+    QCOMPARE(tags.genre, QString("Jazz"));
+    QCOMPARE(tags.format, QString("ID3v2.2"));
+}
+
+void TestTagReader::testId3v1Fallback()
+{
+    // The ID3v2 tag has only a title; ID3v1 fills the rest
+    QByteArray v1("TAG");
+    v1.append(QByteArray("Ignored Title").leftJustified(30, '\0'));
+    v1.append(QByteArray("Fallback Artist").leftJustified(30, '\0'));
+    v1.append(QByteArray("Fallback Album").leftJustified(30, '\0'));
+    v1.append("1984");
+    v1.append(QByteArray(30, '\0')); // comment
+    v1.append(char(13));             // Pop
+
+    const QByteArray v2 = id3Tag(3, id3Frame(3, "TIT2", latin1Text("Real Title")));
+    const TagReader::Tags tags =
+        TagReader::read(writeFile("v1.mp3", v2 + mp3Frames(10) + v1));
+    QCOMPARE(tags.title, QString("Real Title"));
+    QCOMPARE(tags.artist, QString("Fallback Artist"));
+    QCOMPARE(tags.album, QString("Fallback Album"));
+    QCOMPARE(tags.year, QString("1984"));
+    QCOMPARE(tags.genre, QString("Pop"));
+    QCOMPARE(tags.format, QString("ID3v2.3"));
+}
+
+void TestTagReader::testFlacVorbisComment()
+{
+    QByteArray flac("fLaC");
+    flac.append(char(0)); // STREAMINFO
+    flac.append(QByteArray::fromHex("000022"));
+    flac.append(QByteArray(34, '\0'));
+    flac.append(char(6)); // PICTURE, skipped
+    flac.append(QByteArray::fromHex("0003E8"));
+    flac.append(QByteArray(1000, '\0'));
+
+    const QByteArray comment = vorbisComment(
+        {"artist=Low", "TITLE=Words", "Album=I Could Live in Hope", "GENRE=Slowcore",
+         "DATE=1994"});
+    flac.append(char(0x84)); // last block, VORBIS_COMMENT
+    flac.append(char((comment.size() >> 16) & 0xFF));
+    flac.append(char((comment.size() >> 8) & 0xFF));
+    flac.append(char(comment.size() & 0xFF));
+    flac.append(comment);
+
+    const TagReader::Tags tags = TagReader::read(writeFile("tags.flac", flac));
+    QCOMPARE(tags.artist, QString("Low"));
+    QCOMPARE(tags.title, QString("Words"));
+    QCOMPARE(tags.album, QString("I Could Live in Hope"));
+    QCOMPARE(tags.genre, QString("Slowcore"));
+    QCOMPARE(tags.year, QString("1994"));
+    QCOMPARE(tags.format, QString("Vorbis comment"));
+}
+
+void TestTagReader::testOggCommentAcrossPages()
+{
+    // A long comment pushes the artist onto the second page of the packet
+    const QByteArray head = QByteArray("OpusHead") + QByteArray::fromHex("0102380180BB0000000000");
+    const QByteArray comment =
+        "OpusTags" + vorbisComment({"COMMENT=" + QByteArray(600, 'c'), "TITLE=Teardrop",
+                                    "ARTIST=Massive Attack"});
+    const int split = 510;
+
+    QByteArray ogg;
+    ogg.append(oggPage(1, head, false, true));
+    ogg.append(oggPage(1, comment.left(split), false, false));
+    ogg.append(oggPage(2, QByteArray("\x01vorbis", 7), false, true)); // another stream
+    ogg.append(oggPage(1, comment.mid(split), true, true));
+
+    const TagReader::Tags tags = TagReader::read(writeFile("tags.opus", ogg));
+    QCOMPARE(tags.title, QString("Teardrop"));
+    QCOMPARE(tags.artist, QString("Massive Attack"));
+    QCOMPARE(tags.format, QString("Vorbis comment"));
+}
+
+void TestTagReader::testMp4Items()
+{
+    QByteArray items;
+    items.append(box("covr", dataBox(13, QByteArray(100000, '\0'))));
+    items.append(box("\xA9" "ART", dataBox(1, "Portishead")));
+    items.append(box("\xA9nam", dataBox(1, "Roads")));
+    items.append(box("\xA9" "alb", dataBox(1, "Dummy")));
+    items.append(box("gnre", dataBox(0, QByteArray::fromHex("0009")))); // Jazz, plus one
+    items.append(box("\xA9" "day", dataBox(1, "1994-08-22T00:00:00Z")));
+
+    QByteArray handler(8, '\0');
+    handler.append("mdirappl");
+    handler.append(QByteArray(9, '\0'));
+    const QByteArray meta =
+        box("meta", QByteArray(4, '\0') + box("hdlr", handler) + box("ilst", items));
+
+    // moov after mdat, as many encoders write it
+    QByteArray mp4 = box("ftyp", QByteArray("M4A ") + QByteArray(4, '\0') + "M4A isom");
+    mp4.append(box("mdat", QByteArray(4096, '\0')));
+    mp4.append(box("moov", box("udta", meta)));
+
+    const TagReader::Tags tags = TagReader::read(writeFile("tags.m4a", mp4));
+    QCOMPARE(tags.artist, QString("Portishead"));
+    QCOMPARE(tags.title, QString("Roads"));
+    QCOMPARE(tags.album, QString("Dummy"));
+    QCOMPARE(tags.genre, QString("Jazz"));
+    QCOMPARE(tags.year, QString("1994"));
+    QCOMPARE(tags.format, QString("MP4 metadata"));
+}
+
+void TestTagReader::testWavInfo()
+{
+    QByteArray format;
+    format.append(QByteArray::fromHex("0100020044AC000010B1020004001000"));
+
+    QByteArray info("INFO");
+    info.append(riffChunk("IART", QByteArray("Boards of Canada", 17)));
+    info.append(riffChunk("INAM", QByteArray("Roygbiv", 8)));
+    info.append(riffChunk("ICRD", QByteArray("1998-04-20", 11)));
+
+    QByteArray body("WAVE");
+    body.append(riffChunk("fmt ", format));
+    body.append(riffChunk("data", QByteArray(44100 * 4, '\0')));
+    body.append(riffChunk("LIST", info));
+    QByteArray wav("RIFF");
+    appendLE32(wav, body.size());
+    wav.append(body);
+
+    const TagReader::Tags tags = TagReader::read(writeFile("tags.wav", wav));
+    QCOMPARE(tags.artist, QString("Boards of Canada"));
+    QCOMPARE(tags.title, QString("Roygbiv"));
+    QCOMPARE(tags.year, QString("1998"));
+    QCOMPARE(tags.format, QString("RIFF INFO"));
+    QCOMPARE(tags.durationUs, qint64(1000000));
+}
+
+void TestTagReader::testNoTags()
+{
+    const TagReader::Tags tags = TagReader::read(writeFile("junk.bin", QByteArray(2048, 'z')));
+    QVERIFY(!tags.hasTags());
+    QVERIFY(tags.format.isEmpty());
+    QCOMPARE(tags.durationUs, qint64(-1));
+    QVERIFY(tags.durationString().isEmpty());
+}
+
+void TestTagReader::testMissingFile()
+{
+    QString error;
+    const TagReader::Tags tags = TagReader::read(m_tempDir->path() + "/missing.mp3", &error);
+    QVERIFY(!tags.hasTags());
+    QVERIFY(!error.isEmpty());
+}
+
+void TestTagReader::testGenreName()
+{
+    QCOMPARE(TagReader::genreName(0), QString("Blues"));
+    QCOMPARE(TagReader::genreName(17), QString("Rock"));
+    QCOMPARE(TagReader::genreName(147), QString("Synthpop"));
+    QVERIFY(TagReader::genreName(-1).isEmpty());
+    QVERIFY(TagReader::genreName(255).isEmpty());
+}
+
+QString TestTagReader::writeFile(const QString& name, const QByteArray& data)
+{
+    QString path = m_tempDir->path() + "/" + name;
+    QFile file(path);
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(data);
+        file.close();
+    }
+    return path;
+}
+
+QTEST_MAIN(TestTagReader)
@@ -0,0 +1,46 @@
+#ifndef TESTTAGREADER_H
+#define TESTTAGREADER_H
+
+#include <QObject>
+#include <QTest>
+#include <QTemporaryDir>
+#include <memory>
+
+/**
+ * @brief Unit tests for TagReader class
+ *
+ * Tests the in-process tag reader against synthetic files including:
+ * - ID3v2.2, ID3v2.3 and ID3v2.4 text frames in each encoding
+ * - ID3v1 genre numbers and the ID3v1 fallback
+ * - Vorbis comments in FLAC and in Ogg packets spanning several pages
+ * - MP4 ilst items behind the media data
+ * - RIFF INFO lists in WAV
+ * - Files without tags and missing files
+ */
+class TestTagReader : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testId3v24();
+    void testId3v23Utf16();
+    void testId3v22();
+    void testId3v1Fallback();
+    void testFlacVorbisComment();
+    void testOggCommentAcrossPages();
+    void testMp4Items();
+    void testWavInfo();
+    void testNoTags();
+    void testMissingFile();
+    void testGenreName();
+
+private:
+    QString writeFile(const QString& name, const QByteArray& data);
+
+    std::unique_ptr<QTemporaryDir> m_tempDir;
+};
+
+#endif // TESTTAGREADER_H
@@ -0,0 +1,121 @@
+#include "TestTaskRunner.h"
+#include "../../../src/services/TaskRunner.h"
+#include <QSemaphore>
+#include <QSignalSpy>
+#include <QThread>
+
+namespace {
+
+// A task that holds its thread until the gate lets it through
+TaskRunner::Work waitFor(QSemaphore* gate)
+{
+    return [gate](TaskRunner::Context&, TaskRunner::Result&) { gate->acquire(); };
+}
+
+} // namespace
+
+void TestTaskRunner::testPriorities()
+{
+    TaskRunner runner(2);
+    QSignalSpy started(&runner, &TaskRunner::taskStarted);
+    QSemaphore gate;
+
+    const int first = runner.start("maintenance 1", TaskRunner::Priority::Maintenance,
+                                   waitFor(&gate));
+    const int second = runner.start("maintenance 2", TaskRunner::Priority::Maintenance,
+                                    waitFor(&gate));
+    QCOMPARE(runner.runningCount(), 1);
+    QCOMPARE(runner.waitingCount(), 1);
+
+    // The last thread is free for the broadcast however much upkeep waits
+    const int onAir = runner.start("on air", TaskRunner::Priority::OnAir, waitFor(&gate));
+    const int normal = runner.start("normal", TaskRunner::Priority::Normal, waitFor(&gate));
+    QCOMPARE(runner.runningCount(), 2);
+    QCOMPARE(runner.waitingCount(), 2);
+    QCOMPARE(started.count(), 2);
+    QCOMPARE(started.at(1).at(0).toInt(), onAir);
+
+    QSignalSpy finished(&runner, &TaskRunner::taskFinished);
+    gate.release(4);
+    QTRY_COMPARE(finished.count(), 4);
+    QCOMPARE(started.count(), 4);
+    QCOMPARE(started.at(0).at(0).toInt(), first);
+    QCOMPARE(started.at(2).at(0).toInt(), normal);
+    QCOMPARE(started.at(3).at(0).toInt(), second);
+    QCOMPARE(runner.runningCount(), 0);
+    QVERIFY(!runner.contains(first));
+}
+
+void TestTaskRunner::testCancel()
+{
+    TaskRunner runner(1);
+    QSignalSpy finished(&runner, &TaskRunner::taskFinished);
+
+    const int running = runner.start(
+        "loop", TaskRunner::Priority::Normal,
+        [](TaskRunner::Context& context, TaskRunner::Result& result) {
+            while (!context.isCancelled()) {
+                QThread::msleep(5);
+            }
+            result.message = "stopped";
+        });
+    bool doneCalled = false;
+    const int waiting = runner.start(
+        "never runs", TaskRunner::Priority::Normal,
+        [](TaskRunner::Context&, TaskRunner::Result& result) { result.error = "ran"; },
+        [&doneCalled](const TaskRunner::Result& result) { doneCalled = result.cancelled; });
+    QCOMPARE(runner.waitingCount(), 1);
+
+    // A waiting task ends at once, without running
+    runner.cancel(waiting);
+    QVERIFY(doneCalled);
+    QCOMPARE(finished.count(), 1);
+    TaskRunner::Result result = finished.at(0).at(0).value<TaskRunner::Result>();
+    QCOMPARE(result.id, waiting);
+    QVERIFY(result.cancelled);
+    QVERIFY(!result.succeeded());
+    QCOMPARE(runner.waitingCount(), 0);
+
+    // A running one is asked to stop and says so
+    runner.cancel(running);
+    QTRY_COMPARE(finished.count(), 2);
+    result = finished.at(1).at(0).value<TaskRunner::Result>();
+    QCOMPARE(result.id, running);
+    QCOMPARE(result.title, QString("loop"));
+    QCOMPARE(result.message, QString("stopped"));
+    QVERIFY(result.cancelled);
+}
+
+void TestTaskRunner::testProgressThrottled()
+{
+    TaskRunner runner(1);
+    QSignalSpy progress(&runner, &TaskRunner::progressChanged);
+    QSignalSpy finished(&runner, &TaskRunner::taskFinished);
+
+    constexpr int steps = 100;
+    const int id = runner.start(
+        "steps", TaskRunner::Priority::Maintenance,
+        [](TaskRunner::Context& context, TaskRunner::Result& result) {
+            for (int i = 1; i <= steps; ++i) {
+                context.setProgress(i, steps, i == 1 ? QString("stepping") : QString());
+                QThread::msleep(10);
+            }
+            result.value = steps;
+        });
+    QTRY_COMPARE_WITH_TIMEOUT(finished.count(), 1, 10000);
+
+    // About a second of steps makes a handful of updates, the last one complete
+    QVERIFY(progress.count() >= 2);
+    QVERIFY(progress.count() < steps / 4);
+    const QList<QVariant> last = progress.last();
+    QCOMPARE(last.at(0).toInt(), id);
+    QCOMPARE(last.at(1).toInt(), steps);
+    QCOMPARE(last.at(2).toInt(), steps);
+    QCOMPARE(last.at(3).toString(), QString("stepping"));
+
+    const TaskRunner::Result result = finished.at(0).at(0).value<TaskRunner::Result>();
+    QVERIFY(result.succeeded());
+    QCOMPARE(result.value.toInt(), steps);
+}
+
+QTEST_MAIN(TestTaskRunner)
@@ -0,0 +1,25 @@
+#ifndef TESTTASKRUNNER_H
+#define TESTTASKRUNNER_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for TaskRunner class
+ *
+ * Tests the shared task pool including:
+ * - Waiting tasks started by priority, with the last thread kept for OnAir
+ * - Waiting and running tasks cancelled
+ * - Progress reported at most every PROGRESS_INTERVAL_MS, ending with the last values
+ */
+class TestTaskRunner : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testPriorities();
+    void testCancel();
+    void testProgressThrottled();
+};
+
+#endif // TESTTASKRUNNER_H
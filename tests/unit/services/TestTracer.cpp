@@ -0,0 +1,143 @@
+#include "TestTracer.h"
+#include "../../../src/services/Tracer.h"
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <QThread>
+
+namespace {
+
+QJsonArray traceEvents()
+{
+    return QJsonDocument::fromJson(Tracer::toChromeTrace()).object().value("traceEvents").toArray();
+}
+
+/// Complete events with the given name
+QList<QJsonObject> spansNamed(const QJsonArray& events, const QString& name)
+{
+    QList<QJsonObject> spans;
+    for (const QJsonValue& value : events) {
+        const QJsonObject event = value.toObject();
+        if (event.value("ph").toString() == "X" && event.value("name").toString() == name) {
+            spans.append(event);
+        }
+    }
+    return spans;
+}
+
+/// Name given to a thread's track by its metadata event
+QString threadName(const QJsonArray& events, int tid)
+{
+    for (const QJsonValue& value : events) {
+        const QJsonObject event = value.toObject();
+        if (event.value("ph").toString() == "M" && event.value("tid").toInt() == tid) {
+            return event.value("args").toObject().value("name").toString();
+        }
+    }
+    return QString();
+}
+
+} // namespace
+
+void TestTracer::init()
+{
+    Tracer::clear();
+    Tracer::setEnabled(true);
+}
+
+void TestTracer::cleanup()
+{
+    Tracer::setEnabled(false);
+}
+
+void TestTracer::testDisabledRecordsNothing()
+{
+    Tracer::setEnabled(false);
+    {
+        TraceSpan span("test", "disabled");
+    }
+    QVERIFY(spansNamed(traceEvents(), "disabled").isEmpty());
+}
+
+void TestTracer::testRecordsNestedSpans()
+{
+    {
+        TraceSpan outer("test", "outer");
+        QThread::msleep(2);
+        {
+            TraceSpan inner("test", "inner");
+            QThread::msleep(2);
+        }
+    }
+
+    const QJsonArray events = traceEvents();
+    const QList<QJsonObject> outer = spansNamed(events, "outer");
+    const QList<QJsonObject> inner = spansNamed(events, "inner");
+    QCOMPARE(outer.size(), 1);
+    QCOMPARE(inner.size(), 1);
+    QCOMPARE(outer.first().value("cat").toString(), QString("test"));
+    QCOMPARE(outer.first().value("tid").toInt(), inner.first().value("tid").toInt());
+    QCOMPARE(threadName(events, outer.first().value("tid").toInt()), QString("main"));
+
+    // Microseconds, and the inner span lies within the outer one
+    const double outerStart = outer.first().value("ts").toDouble();
+    const double outerEnd = outerStart + outer.first().value("dur").toDouble();
+    const double innerStart = inner.first().value("ts").toDouble();
+    const double innerEnd = innerStart + inner.first().value("dur").toDouble();
+    QVERIFY(outer.first().value("dur").toDouble() >= 4000.0);
+    QVERIFY(innerStart >= outerStart);
+    QVERIFY(innerEnd <= outerEnd);
+}
+
+void TestTracer::testSeparatesThreads()
+{
+    {
+        TraceSpan span("test", "onMain");
+    }
+    QThread* worker = QThread::create([]() { TraceSpan span("test", "onWorker"); });
+    worker->setObjectName("prefetch worker");
+    worker->start();
+    QVERIFY(worker->wait(5000));
+    delete worker;
+
+    // The worker has ended, but its spans are still there
+    const QJsonArray events = traceEvents();
+    const QList<QJsonObject> onMain = spansNamed(events, "onMain");
+    const QList<QJsonObject> onWorker = spansNamed(events, "onWorker");
+    QCOMPARE(onMain.size(), 1);
+    QCOMPARE(onWorker.size(), 1);
+    const int workerTid = onWorker.first().value("tid").toInt();
+    QVERIFY(workerTid != onMain.first().value("tid").toInt());
+    QCOMPARE(threadName(events, workerTid), QString("prefetch worker"));
+}
+
+void TestTracer::testKeepsLatestSpans()
+{
+    const qint64 start = Tracer::now();
+    for (int i = 0; i < Tracer::EVENTS_PER_THREAD + 10; ++i) {
+        Tracer::record("test", i < 10 ? "oldest" : "latest", start + i * 1000, 500);
+    }
+
+    const QJsonArray events = traceEvents();
+    QVERIFY(spansNamed(events, "oldest").isEmpty());
+    QCOMPARE(spansNamed(events, "latest").size(), Tracer::EVENTS_PER_THREAD);
+}
+
+void TestTracer::testWritesFile()
+{
+    {
+        TraceSpan span("test", "saved");
+    }
+    QTemporaryDir dir;
+    const QString path = dir.filePath("traces/trace.json");
+    QVERIFY(Tracer::writeChromeTrace(path));
+
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QJsonObject trace = QJsonDocument::fromJson(file.readAll()).object();
+    QCOMPARE(spansNamed(trace.value("traceEvents").toArray(), "saved").size(), 1);
+}
+
+QTEST_MAIN(TestTracer)
@@ -0,0 +1,31 @@
+#ifndef TESTTRACER_H
+#define TESTTRACER_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for Tracer and TraceSpan
+ *
+ * Tests the trace flight recorder including:
+ * - Nothing recorded while tracing is off
+ * - Nested spans exported as Chrome trace complete events
+ * - A buffer and a named track per thread
+ * - Keeping only the latest spans of a thread
+ * - Saving the trace to a file
+ */
+class TestTracer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+    void testDisabledRecordsNothing();
+    void testRecordsNestedSpans();
+    void testSeparatesThreads();
+    void testKeepsLatestSpans();
+    void testWritesFile();
+};
+
+#endif // TESTTRACER_H
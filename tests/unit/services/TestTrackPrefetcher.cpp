@@ -0,0 +1,136 @@
+#include "TestTrackPrefetcher.h"
+#include "../../../src/services/TrackPrefetcher.h"
+#include <QFile>
+
+void TestTrackPrefetcher::init()
+{
+    m_tempDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_tempDir->isValid());
+}
+
+void TestTrackPrefetcher::cleanup()
+{
+    m_tempDir.reset();
+}
+
+void TestTrackPrefetcher::testHitAfterPrefetch()
+{
+    QString path = writeFile("next.bin", 4096);
+
+    TrackPrefetcher prefetcher;
+    prefetcher.prefetch(path);
+
+    std::unique_ptr<QIODevice> device;
+    QTRY_VERIFY((device = prefetcher.take(path)) != nullptr);
+    QCOMPARE(device->size(), qint64(4096));
+
+    QFile original(path);
+    QVERIFY(original.open(QIODevice::ReadOnly));
+    QCOMPARE(device->readAll(), original.readAll());
+
+    TrackPrefetcher::Statistics stats = prefetcher.statistics();
+    QCOMPARE(stats.requested, 1);
+    QCOMPARE(stats.hits, 1);
+    QCOMPARE(stats.bytesRead, qint64(4096));
+}
+
+void TestTrackPrefetcher::testMissWithoutPrefetch()
+{
+    QString path = writeFile("cold.bin", 1024);
+
+    TrackPrefetcher prefetcher;
+    QVERIFY(prefetcher.take(path) == nullptr);
+    QCOMPARE(prefetcher.statistics().misses, 1);
+    QCOMPARE(prefetcher.statistics().hitRate(), 0.0);
+}
+
+void TestTrackPrefetcher::testDeviceReadsPastHead()
+{
+    QString path = writeFile("split.bin", 10000);
+    QFile original(path);
+    QVERIFY(original.open(QIODevice::ReadOnly));
+    QByteArray content = original.readAll();
+
+    PrefetchedFileDevice device(path, content.left(3000), content.size());
+    QVERIFY(device.open(QIODevice::ReadOnly));
+
+    QCOMPARE(device.read(2000), content.mid(0, 2000));
+    QCOMPARE(device.read(2000), content.mid(2000, 2000)); // crosses the head boundary
+    QCOMPARE(device.readAll(), content.mid(4000));
+
+    QVERIFY(device.seek(100));
+    QCOMPARE(device.read(10), content.mid(100, 10));
+    QVERIFY(device.seek(9000));
+    QCOMPARE(device.read(10), content.mid(9000, 10));
+}
+
+void TestTrackPrefetcher::testEvictionCountsWasted()
+{
+    TrackPrefetcher prefetcher;
+    QString first = writeFile("a.bin", 512);
+    prefetcher.prefetch(first);
+    prefetcher.prefetch(writeFile("b.bin", 512));
+    prefetcher.prefetch(writeFile("c.bin", 512));
+
+    QCOMPARE(prefetcher.statistics().wasted, 1);
+    QVERIFY(prefetcher.take(first) == nullptr);
+}
+
+void TestTrackPrefetcher::testBorrowLeavesPrefetch()
+{
+    QString path = writeFile("cued.bin", 2048);
+
+    TrackPrefetcher prefetcher;
+    QVERIFY(prefetcher.borrow(path) == nullptr);
+    prefetcher.prefetch(path);
+
+    std::unique_ptr<QIODevice> cue;
+    QTRY_VERIFY((cue = prefetcher.borrow(path)) != nullptr);
+    std::unique_ptr<QIODevice> air = prefetcher.take(path);
+    QVERIFY(air != nullptr);
+    QCOMPARE(cue->readAll(), air->readAll());
+
+    TrackPrefetcher::Statistics stats = prefetcher.statistics();
+    QCOMPARE(stats.borrowed, 1);
+    QCOMPARE(stats.hits, 1);
+    QCOMPARE(stats.misses, 0);
+    QCOMPARE(stats.requested, 1);
+}
+
+void TestTrackPrefetcher::testShrinkDropsOldest()
+{
+    TrackPrefetcher prefetcher;
+    QString older = writeFile("older.bin", 1000);
+    QString newer = writeFile("newer.bin", 3000);
+    prefetcher.prefetch(older);
+    prefetcher.prefetch(newer);
+    QTRY_COMPARE(prefetcher.memoryUsage(), qint64(4000));
+
+    prefetcher.shrink(3000);
+    QCOMPARE(prefetcher.memoryUsage(), qint64(3000));
+    QCOMPARE(prefetcher.statistics().wasted, 1);
+    QVERIFY(prefetcher.borrow(older) == nullptr);
+    QVERIFY(prefetcher.borrow(newer) != nullptr);
+
+    prefetcher.shrink(0);
+    QCOMPARE(prefetcher.memoryUsage(), qint64(0));
+    QVERIFY(prefetcher.take(newer) == nullptr);
+}
+
+QString TestTrackPrefetcher::writeFile(const QString& name, int size)
+{
+    QByteArray data(size, Qt::Uninitialized);
+    for (int i = 0; i < size; ++i) {
+        data[i] = char(i * 31 + 7);
+    }
+
+    QString path = m_tempDir->path() + "/" + name;
+    QFile file(path);
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(data);
+        file.close();
+    }
+    return path;
+}
+
+QTEST_MAIN(TestTrackPrefetcher)
@@ -0,0 +1,40 @@
+#ifndef TESTTRACKPREFETCHER_H
+#define TESTTRACKPREFETCHER_H
+
+#include <QObject>
+#include <QTest>
+#include <QTemporaryDir>
+#include <memory>
+
+/**
+ * @brief Unit tests for TrackPrefetcher class
+ *
+ * Tests the next-track look-ahead loader including:
+ * - Hits for completed prefetches and misses for unknown files
+ * - Byte-exact reads through PrefetchedFileDevice, across the head boundary
+ * - Eviction of unused prefetches and the wasted counter
+ * - Borrowed reads that leave the prefetch for take()
+ * - Memory held by the heads, and shrinking it oldest first
+ */
+class TestTrackPrefetcher : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testHitAfterPrefetch();
+    void testMissWithoutPrefetch();
+    void testDeviceReadsPastHead();
+    void testEvictionCountsWasted();
+    void testBorrowLeavesPrefetch();
+    void testShrinkDropsOldest();
+
+private:
+    QString writeFile(const QString& name, int size);
+
+    std::unique_ptr<QTemporaryDir> m_tempDir;
+};
+
+#endif // TESTTRACKPREFETCHER_H
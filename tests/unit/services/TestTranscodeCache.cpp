@@ -0,0 +1,236 @@
+#include "TestTranscodeCache.h"
+#include "../../../src/services/TranscodeCache.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSignalSpy>
+
+namespace {
+
+// Stands in for ffmpeg: copies the -i file to the last argument. Inputs
+// with "fail" in the name fail
+const char* FAKE_FFMPEG = "#!/bin/sh\n"
+                          "for out; do :; done\n"
+                          "while [ $# -gt 0 ]; do\n"
+                          "  if [ \"$1\" = \"-i\" ]; then in=\"$2\"; fi\n"
+                          "  shift\n"
+                          "done\n"
+                          "case \"$in\" in *fail*) echo \"Invalid data\" >&2; exit 1;; esac\n"
+                          "cat \"$in\" > \"$out\"\n";
+
+QByteArray readAll(const QString& path)
+{
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+} // namespace
+
+void TestTranscodeCache::init()
+{
+    m_tempDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_tempDir->isValid());
+
+    m_fakeFfmpeg = m_tempDir->filePath("fake-ffmpeg");
+    QFile script(m_fakeFfmpeg);
+    QVERIFY(script.open(QIODevice::WriteOnly));
+    script.write(FAKE_FFMPEG);
+    script.close();
+    script.setPermissions(QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner);
+}
+
+void TestTranscodeCache::cleanup()
+{
+    m_tempDir.reset();
+}
+
+void TestTranscodeCache::testConvertsAndResolves()
+{
+    const QString source = writeFile("song.wma");
+
+    TranscodeCache cache(cacheDirectory());
+    configure(cache);
+    QSignalSpy prepared(&cache, &TranscodeCache::prepared);
+
+    // Not converted yet: the deck gets the track itself and the copy is made
+    QCOMPARE(cache.resolve(source), source);
+    QCOMPARE(cache.pendingCount(), 1);
+    QVERIFY(prepared.wait(5000));
+    QCOMPARE(prepared.at(0).at(0).toString(), source);
+    QCOMPARE(prepared.at(0).at(1).toString(), cache.cachePath(source));
+    QCOMPARE(cache.pendingCount(), 0);
+
+    const QString copy = cache.resolve(source);
+    QCOMPARE(copy, cache.cachePath(source));
+    QVERIFY(copy.startsWith(cacheDirectory()));
+    QCOMPARE(readAll(copy), readAll(source));
+    QVERIFY(QDir(cacheDirectory()).entryList({"*.part"}, QDir::Files).isEmpty());
+
+    // Asking again is a no-op
+    QCOMPARE(cache.prepare({source}), 0);
+
+    const TranscodeCache::Statistics stats = cache.statistics();
+    QCOMPARE(stats.hits, 1);
+    QCOMPARE(stats.misses, 1);
+    QCOMPARE(stats.transcoded, 1);
+    QCOMPARE(stats.entries, 1);
+    QCOMPARE(stats.bytes, qint64(100));
+    QCOMPARE(stats.hitRate(), 0.5);
+}
+
+void TestTranscodeCache::testSkipsNativeFormats()
+{
+    const QString source = writeFile("song.mp3");
+
+    TranscodeCache cache(cacheDirectory());
+    configure(cache);
+
+    QVERIFY(!cache.needsTranscode(source));
+    QVERIFY(cache.needsTranscode("/music/SONG.WMA"));
+    QCOMPARE(cache.prepare({source}), 0);
+    QCOMPARE(cache.resolve(source), source);
+    QCOMPARE(cache.statistics().hits, 0);
+    QCOMPARE(cache.statistics().misses, 0);
+
+    // Without ffmpeg nothing is queued and every track plays as it is
+    const QString other = writeFile("other.wma");
+    cache.setProgram(QString());
+    QCOMPARE(cache.prepare({other}), 0);
+    QCOMPARE(cache.resolve(other), other);
+}
+
+void TestTranscodeCache::testEvictsLeastRecentlyUsed()
+{
+    const QString first = writeFile("first.wma");
+    const QString second = writeFile("second.wma");
+    const QString third = writeFile("third.wma");
+
+    TranscodeCache cache(cacheDirectory());
+    configure(cache);
+    cache.setMaxBytes(250);
+
+    QVERIFY(prepareAndWait(cache, first));
+    QTest::qWait(20);
+    QVERIFY(prepareAndWait(cache, second));
+    QTest::qWait(20);
+    QVERIFY(prepareAndWait(cache, third));
+
+    QVERIFY(!cache.isCached(first));
+    QVERIFY(!QFile::exists(cache.cachePath(first)));
+    QVERIFY(cache.isCached(second));
+    QVERIFY(cache.isCached(third));
+    QCOMPARE(cache.statistics().evicted, 1);
+    QCOMPARE(cache.statistics().bytes, qint64(200));
+
+    // The tracks on air and queued stay, however small the cache becomes
+    QCOMPARE(cache.resolve(second), cache.cachePath(second));
+    QCOMPARE(cache.resolve(third), cache.cachePath(third));
+    cache.setMaxBytes(50);
+    QVERIFY(cache.isCached(second));
+    QVERIFY(cache.isCached(third));
+    QCOMPARE(cache.statistics().evicted, 1);
+}
+
+void TestTranscodeCache::testRedoesStaleCopies()
+{
+    const QString source = writeFile("song.wma");
+
+    TranscodeCache cache(cacheDirectory());
+    configure(cache);
+    QVERIFY(prepareAndWait(cache, source));
+    QVERIFY(cache.isCached(source));
+
+    // The track was edited after it was converted
+    QFile file(source);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.setFileTime(QDateTime::currentDateTime().addSecs(3600),
+                             QFileDevice::FileModificationTime));
+    file.close();
+
+    QVERIFY(!cache.isCached(source));
+    QCOMPARE(cache.resolve(source), source);
+    QCOMPARE(cache.statistics().misses, 1);
+    QCOMPARE(cache.pendingCount(), 1);
+}
+
+void TestTranscodeCache::testFailure()
+{
+    const QString broken = writeFile("fail.wma");
+    const QString missing = m_tempDir->filePath("missing.wma");
+
+    TranscodeCache cache(cacheDirectory());
+    configure(cache);
+    QSignalSpy failed(&cache, &TranscodeCache::failed);
+
+    QCOMPARE(cache.prepare({broken, missing}), 2);
+    QTRY_COMPARE_WITH_TIMEOUT(failed.count(), 2, 5000);
+
+    QCOMPARE(failed.at(0).at(0).toString(), broken);
+    QVERIFY(failed.at(0).at(1).toString().contains("Invalid data"));
+    QCOMPARE(failed.at(1).at(0).toString(), missing);
+    QVERIFY(!cache.isCached(broken));
+    QCOMPARE(cache.resolve(broken), broken);
+    QCOMPARE(cache.statistics().failed, 2);
+    QVERIFY(QDir(cacheDirectory()).entryList(QDir::Files).isEmpty());
+}
+
+void TestTranscodeCache::testLoadsExistingCopies()
+{
+    const QString source = writeFile("song.wma");
+    {
+        TranscodeCache cache(cacheDirectory());
+        configure(cache);
+        QVERIFY(prepareAndWait(cache, source));
+    }
+
+    // A conversion cut short by a crash
+    QFile part(QDir(cacheDirectory()).filePath("interrupted.wav.part"));
+    QVERIFY(part.open(QIODevice::WriteOnly));
+    part.write("half");
+    part.close();
+
+    TranscodeCache cache(cacheDirectory());
+    configure(cache);
+    QVERIFY(!QFile::exists(part.fileName()));
+    QVERIFY(cache.isCached(source));
+    QCOMPARE(cache.statistics().entries, 1);
+    QCOMPARE(cache.statistics().bytes, qint64(100));
+    QCOMPARE(cache.resolve(source), cache.cachePath(source));
+
+    // Copies over a smaller limit are removed on the spot
+    cache.setMaxBytes(10);
+    QCOMPARE(cache.statistics().entries, 1);
+    TranscodeCache smaller(cacheDirectory());
+    smaller.setMaxBytes(10);
+    QCOMPARE(smaller.statistics().entries, 0);
+}
+
+QString TestTranscodeCache::writeFile(const QString& name, int bytes)
+{
+    const QString path = m_tempDir->filePath(name);
+    QFile file(path);
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(QByteArray(bytes, name.at(0).toLatin1()));
+    }
+    return path;
+}
+
+QString TestTranscodeCache::cacheDirectory() const
+{
+    return m_tempDir->filePath("cache");
+}
+
+void TestTranscodeCache::configure(TranscodeCache& cache)
+{
+    cache.setProgram(m_fakeFfmpeg);
+    cache.setSuffixes({"WMA", "ape"});
+}
+
+bool TestTranscodeCache::prepareAndWait(TranscodeCache& cache, const QString& source)
+{
+    QSignalSpy prepared(&cache, &TranscodeCache::prepared);
+    return cache.prepare({source}) == 1 && prepared.wait(5000);
+}
+
+QTEST_MAIN(TestTranscodeCache)
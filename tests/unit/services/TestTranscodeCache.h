@@ -0,0 +1,47 @@
+#ifndef TESTTRANSCODECACHE_H
+#define TESTTRANSCODECACHE_H
+
+#include <QObject>
+#include <QTest>
+#include <QTemporaryDir>
+#include <memory>
+
+class TranscodeCache;
+
+/**
+ * @brief Unit tests for TranscodeCache class
+ *
+ * Tests the cache of converted tracks including:
+ * - Converting queued tracks and resolving them to their copies
+ * - Counting hits and misses
+ * - Leaving formats the decks open natively alone
+ * - Removing the least recently played copies, but never pinned ones
+ * - Converting again when the track is newer than its copy
+ * - Failed conversions and copies left by an earlier run
+ */
+class TestTranscodeCache : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testConvertsAndResolves();
+    void testSkipsNativeFormats();
+    void testEvictsLeastRecentlyUsed();
+    void testRedoesStaleCopies();
+    void testFailure();
+    void testLoadsExistingCopies();
+
+private:
+    QString writeFile(const QString& name, int bytes = 100);
+    QString cacheDirectory() const;
+    void configure(TranscodeCache& cache);
+    bool prepareAndWait(TranscodeCache& cache, const QString& source);
+
+    std::unique_ptr<QTemporaryDir> m_tempDir;
+    QString m_fakeFfmpeg;
+};
+
+#endif // TESTTRANSCODECACHE_H
@@ -0,0 +1,315 @@
+#include "TestTranscodeEngine.h"
+#include "../../../src/services/TranscodeEngine.h"
+#include <QDir>
+#include <QFile>
+#include <QSignalSpy>
+#include <QSqlQuery>
+
+namespace {
+
+const char* CONNECTION_NAME = "test_transcode_engine_connection";
+
+// Stands in for ffmpeg: copies the -i file to the last argument. Inputs
+// with "fail" in the name fail, and FAKE_FFMPEG_DELAY makes it slow
+const char* FAKE_FFMPEG = "#!/bin/sh\n"
+                          "for out; do :; done\n"
+                          "while [ $# -gt 0 ]; do\n"
+                          "  if [ \"$1\" = \"-i\" ]; then in=\"$2\"; fi\n"
+                          "  shift\n"
+                          "done\n"
+                          "case \"$in\" in *fail*) echo \"Invalid data\" >&2; exit 1;; esac\n"
+                          "sleep \"${FAKE_FFMPEG_DELAY:-0}\"\n"
+                          "echo out_time_us=500000\n"
+                          "cat \"$in\" > \"$out\"\n";
+
+int jobCount(QSqlDatabase& database, const QString& state)
+{
+    QSqlQuery query(database);
+    query.prepare("SELECT COUNT(*) FROM transcode_jobs WHERE state = :state");
+    query.bindValue(":state", state);
+    return query.exec() && query.next() ? query.value(0).toInt() : -1;
+}
+
+} // namespace
+
+void TestTranscodeEngine::init()
+{
+    m_tempDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_tempDir->isValid());
+
+    m_database = QSqlDatabase::addDatabase("QSQLITE", CONNECTION_NAME);
+    m_database.setDatabaseName(m_tempDir->filePath("test.db"));
+    QVERIFY(m_database.open());
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec("CREATE TABLE musics (id INTEGER PRIMARY KEY, path TEXT)"));
+
+    m_fakeFfmpeg = m_tempDir->filePath("fake-ffmpeg");
+    QFile script(m_fakeFfmpeg);
+    QVERIFY(script.open(QIODevice::WriteOnly));
+    script.write(FAKE_FFMPEG);
+    script.close();
+    script.setPermissions(QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner);
+    qunsetenv("FAKE_FFMPEG_DELAY");
+}
+
+void TestTranscodeEngine::cleanup()
+{
+    if (m_database.isOpen()) {
+        m_database.close();
+    }
+    m_database = QSqlDatabase();
+    QSqlDatabase::removeDatabase(CONNECTION_NAME);
+    m_tempDir.reset();
+}
+
+void TestTranscodeEngine::testTargetPath()
+{
+    QCOMPARE(TranscodeEngine::targetPath("/music/a.b.mp3", "ogg"), QString("/music/a.b.ogg"));
+    QCOMPARE(TranscodeEngine::targetPath("/music/song", "ogg"), QString("/music/song.ogg"));
+}
+
+void TestTranscodeEngine::testConvertsAndReplaces()
+{
+    const QString first = writeFile("first.mp3");
+    const QString second = writeFile("second.wav");
+
+    TranscodeEngine engine(m_database);
+    configure(engine);
+    QVERIFY(engine.initialize());
+    QSignalSpy finished(&engine, &TranscodeEngine::finished);
+    QSignalSpy jobs(&engine, &TranscodeEngine::jobFinished);
+
+    QCOMPARE(engine.enqueue({first, second}, "ogg"), 2);
+    QCOMPARE(engine.progress().total, 2);
+    engine.start();
+    QVERIFY(finished.wait(5000));
+
+    QCOMPARE(finished.at(0).at(0).toInt(), 2);
+    QCOMPARE(finished.at(0).at(1).toInt(), 0);
+    QCOMPARE(jobs.count(), 2);
+    QVERIFY(!engine.isRunning());
+
+    const QDir dir(m_tempDir->path());
+    QVERIFY(!QFile::exists(first));
+    QVERIFY(!QFile::exists(second));
+    QVERIFY(QFile::exists(dir.filePath("first.ogg")));
+    QVERIFY(QFile::exists(dir.filePath("second.ogg")));
+    QVERIFY(isInLibrary(dir.filePath("first.ogg")));
+    QVERIFY(!isInLibrary(first));
+    QVERIFY(dir.entryList({"*.xfb-part.*"}, QDir::Files | QDir::Hidden).isEmpty());
+
+    // Finished jobs are cleared away once the queue is empty
+    QCOMPARE(jobCount(m_database, "done"), 0);
+    QCOMPARE(engine.progress().total, 0);
+}
+
+void TestTranscodeEngine::testFailureKeepsSource()
+{
+    const QString broken = writeFile("fail.mp3");
+
+    TranscodeEngine engine(m_database);
+    configure(engine);
+    QSignalSpy finished(&engine, &TranscodeEngine::finished);
+    QSignalSpy jobs(&engine, &TranscodeEngine::jobFinished);
+
+    QCOMPARE(engine.enqueue({broken}, "ogg"), 1);
+    engine.start();
+    QVERIFY(finished.wait(5000));
+
+    QCOMPARE(finished.at(0).at(1).toInt(), 1);
+    QCOMPARE(jobs.at(0).at(2).toBool(), false);
+    QVERIFY(jobs.at(0).at(3).toString().contains("Invalid data"));
+    QVERIFY(QFile::exists(broken));
+    QVERIFY(isInLibrary(broken));
+    QVERIFY(!QFile::exists(TranscodeEngine::targetPath(broken, "ogg")));
+    QCOMPARE(jobCount(m_database, "failed"), 1);
+    QCOMPARE(engine.progress().failed, 1);
+
+    // Asking again retries it
+    QCOMPARE(engine.enqueue({broken}, "ogg"), 1);
+    QCOMPARE(jobCount(m_database, "pending"), 1);
+    QCOMPARE(engine.progress().failed, 0);
+}
+
+void TestTranscodeEngine::testSkipsNeedlessJobs()
+{
+    const QString alreadyOgg = writeFile("done.ogg");
+    const QString twin = writeFile("twin.mp3");
+    writeFile("twin.ogg");
+    const QString fresh = writeFile("fresh.flac");
+
+    TranscodeEngine engine(m_database);
+    configure(engine);
+
+    QCOMPARE(engine.enqueue({alreadyOgg, twin, fresh}, "ogg"), 1);
+    QCOMPARE(engine.pendingCount(), 1);
+    // A job is only added once
+    QCOMPARE(engine.enqueue({fresh}, "ogg"), 0);
+    // Without an encoder nothing can be queued
+    QCOMPARE(engine.enqueue({fresh}, "opus"), 0);
+}
+
+void TestTranscodeEngine::testWorkerLimit()
+{
+    qputenv("FAKE_FFMPEG_DELAY", "0.2");
+    QStringList sources;
+    for (int i = 0; i < 5; ++i) {
+        sources << writeFile(QString("track%1.mp3").arg(i));
+    }
+
+    TranscodeEngine engine(m_database);
+    configure(engine);
+    engine.setMaxWorkers(2);
+    QSignalSpy finished(&engine, &TranscodeEngine::finished);
+
+    int running = 0;
+    int mostRunning = 0;
+    connect(&engine, &TranscodeEngine::jobStarted, this, [&]() {
+        mostRunning = qMax(mostRunning, ++running);
+    });
+    connect(&engine, &TranscodeEngine::jobFinished, this, [&]() { --running; });
+
+    engine.enqueue(sources, "ogg");
+    engine.start();
+    QCOMPARE(engine.progress().running, 2);
+    QVERIFY(finished.wait(10000));
+
+    QCOMPARE(mostRunning, 2);
+    QCOMPARE(finished.at(0).at(0).toInt(), 5);
+}
+
+void TestTranscodeEngine::testEnqueueWhileRunning()
+{
+    qputenv("FAKE_FFMPEG_DELAY", "0.2");
+    const QString first = writeFile("first.mp3");
+    const QString second = writeFile("second.flac");
+    const QString third = writeFile("third.wav");
+
+    TranscodeEngine engine(m_database);
+    configure(engine);
+    engine.setEncoder("mp3", {"-b:a", "192k"});
+    engine.setMaxWorkers(1);
+    QSignalSpy finished(&engine, &TranscodeEngine::finished);
+
+    QCOMPARE(engine.enqueue({first, second}, "ogg"), 2);
+    engine.start();
+    QCOMPARE(engine.progress().running, 1);
+
+    // A selection overlapping the running batch only adds what is new, in
+    // its own format, and the run carries on with it
+    QCOMPARE(engine.enqueue({first, second, third}, "mp3"), 1);
+    QCOMPARE(engine.pendingCount(), 3);
+    QVERIFY(finished.wait(10000));
+
+    QCOMPARE(finished.count(), 1);
+    QCOMPARE(finished.at(0).at(0).toInt(), 3);
+    const QDir dir(m_tempDir->path());
+    QVERIFY(QFile::exists(dir.filePath("first.ogg")));
+    QVERIFY(QFile::exists(dir.filePath("second.ogg")));
+    QVERIFY(QFile::exists(dir.filePath("third.mp3")));
+    QVERIFY(!QFile::exists(dir.filePath("first.mp3")));
+}
+
+void TestTranscodeEngine::testResumeAfterCrash()
+{
+    const QString interrupted = writeFile("interrupted.mp3");
+    const QDir dir(m_tempDir->path());
+    const QString part = dir.filePath(".interrupted.xfb-part.ogg");
+    QFile partFile(part);
+    QVERIFY(partFile.open(QIODevice::WriteOnly));
+    partFile.write("half");
+    partFile.close();
+
+    // Converted and moved into the library, but the source was never removed
+    const QString leftover = writeFile("leftover.mp3", false);
+    const QString leftoverTarget = writeFile("leftover.ogg");
+
+    {
+        TranscodeEngine engine(m_database);
+        QVERIFY(engine.initialize());
+    }
+    QSqlQuery query(m_database);
+    QVERIFY(query.exec(QString("INSERT INTO transcode_jobs (source, target, state) VALUES "
+                               "('%1', '%2', 'running'), ('%3', '%4', 'done')")
+                           .arg(interrupted, TranscodeEngine::targetPath(interrupted, "ogg"),
+                                leftover, leftoverTarget)));
+
+    TranscodeEngine engine(m_database);
+    configure(engine);
+    QSignalSpy finished(&engine, &TranscodeEngine::finished);
+    QVERIFY(engine.initialize());
+
+    QVERIFY(!QFile::exists(part));
+    QVERIFY(!QFile::exists(leftover));
+    QVERIFY(QFile::exists(leftoverTarget));
+    QCOMPARE(engine.pendingCount(), 1);
+    // The earlier run's work counts towards the progress
+    QCOMPARE(engine.progress().total, 2);
+    QCOMPARE(engine.progress().permille, 500);
+
+    engine.start();
+    QVERIFY(finished.wait(5000));
+    QVERIFY(isInLibrary(TranscodeEngine::targetPath(interrupted, "ogg")));
+    QVERIFY(!QFile::exists(interrupted));
+}
+
+void TestTranscodeEngine::testStopRequeues()
+{
+    qputenv("FAKE_FFMPEG_DELAY", "5");
+    const QString first = writeFile("first.mp3");
+    const QString second = writeFile("second.mp3");
+
+    TranscodeEngine engine(m_database);
+    configure(engine);
+    engine.setMaxWorkers(1);
+    engine.enqueue({first, second}, "ogg");
+    engine.start();
+    QCOMPARE(engine.progress().running, 1);
+    QCOMPARE(jobCount(m_database, "running"), 1);
+
+    engine.stop();
+    QVERIFY(!engine.isRunning());
+    QCOMPARE(engine.pendingCount(), 2);
+    QCOMPARE(jobCount(m_database, "pending"), 2);
+    QVERIFY(QFile::exists(first));
+    QVERIFY(isInLibrary(first));
+
+    // A fresh engine picks up the same queue
+    TranscodeEngine resumed(m_database);
+    QVERIFY(resumed.initialize());
+    QCOMPARE(resumed.pendingCount(), 2);
+}
+
+QString TestTranscodeEngine::writeFile(const QString& name, bool inLibrary)
+{
+    const QString path = m_tempDir->filePath(name);
+    QFile file(path);
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write("audio of " + name.toUtf8());
+    }
+
+    if (inLibrary) {
+        QSqlQuery query(m_database);
+        query.prepare("INSERT INTO musics (path) VALUES (:path)");
+        query.bindValue(":path", path);
+        query.exec();
+    }
+    return path;
+}
+
+bool TestTranscodeEngine::isInLibrary(const QString& path)
+{
+    QSqlQuery query(m_database);
+    query.prepare("SELECT 1 FROM musics WHERE path = :path");
+    query.bindValue(":path", path);
+    return query.exec() && query.next();
+}
+
+void TestTranscodeEngine::configure(TranscodeEngine& engine)
+{
+    engine.setProgram(m_fakeFfmpeg);
+    engine.setEncoder("ogg", {"-c:a", "libvorbis"});
+    engine.setDurationProvider([](const QString&) { return qint64(1000000); });
+}
+
+QTEST_MAIN(TestTranscodeEngine)
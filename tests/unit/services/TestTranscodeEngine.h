@@ -0,0 +1,50 @@
+#ifndef TESTTRANSCODEENGINE_H
+#define TESTTRANSCODEENGINE_H
+
+#include <QObject>
+#include <QTest>
+#include <QSqlDatabase>
+#include <QTemporaryDir>
+#include <memory>
+
+class TranscodeEngine;
+
+/**
+ * @brief Unit tests for TranscodeEngine class
+ *
+ * Tests the resumable library conversion including:
+ * - Replacing sources and library paths once a conversion succeeds
+ * - Keeping sources of failed conversions and queueing them again
+ * - Skipping sources that need no conversion or would overwrite a track
+ * - Bounding the number of workers
+ * - Adding jobs, in another format, while a run is going
+ * - Resuming interrupted and stopped runs
+ */
+class TestTranscodeEngine : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testTargetPath();
+    void testConvertsAndReplaces();
+    void testFailureKeepsSource();
+    void testSkipsNeedlessJobs();
+    void testWorkerLimit();
+    void testEnqueueWhileRunning();
+    void testResumeAfterCrash();
+    void testStopRequeues();
+
+private:
+    QString writeFile(const QString& name, bool inLibrary = true);
+    bool isInLibrary(const QString& path);
+    void configure(TranscodeEngine& engine);
+
+    std::unique_ptr<QTemporaryDir> m_tempDir;
+    QSqlDatabase m_database;
+    QString m_fakeFfmpeg;
+};
+
+#endif // TESTTRANSCODEENGINE_H
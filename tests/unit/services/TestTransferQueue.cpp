@@ -0,0 +1,202 @@
+#include "TestTransferQueue.h"
+#include "../../../src/services/TransferQueue.h"
+#include <QSignalSpy>
+#include <QTemporaryDir>
+
+namespace {
+
+TransferQueue::Job shellJob(const QString& key, const QString& command)
+{
+    TransferQueue::Job job;
+    job.key = key;
+    job.description = key;
+    job.program = "/bin/sh";
+    job.arguments = {"-c", command};
+    return job;
+}
+
+} // namespace
+
+void TestTransferQueue::testConcurrencyLimit()
+{
+    TransferQueue queue;
+    queue.setMaxConcurrent(2);
+    QCOMPARE(queue.maxConcurrent(), 2);
+
+    int running = 0;
+    int peak = 0;
+    connect(&queue, &TransferQueue::jobStarted, this, [&]() { peak = qMax(peak, ++running); });
+    connect(&queue, &TransferQueue::jobFinished, this, [&]() { --running; });
+
+    int done = 0;
+    for (int i = 0; i < 5; ++i) {
+        queue.enqueue(shellJob(QString("job%1").arg(i), "sleep 0.1"),
+                      [&](const TransferQueue::Result& result) {
+                          QVERIFY(result.ok);
+                          ++done;
+                      });
+    }
+    QCOMPARE(queue.runningCount(), 2);
+    QCOMPARE(queue.pendingCount(), 5);
+
+    QTRY_COMPARE_WITH_TIMEOUT(done, 5, 10000);
+    QCOMPARE(peak, 2);
+    QCOMPARE(queue.pendingCount(), 0);
+}
+
+void TestTransferQueue::testDuplicateKeysRunOnce()
+{
+    TransferQueue queue;
+    QSignalSpy started(&queue, &TransferQueue::jobStarted);
+
+    int calls = 0;
+    const int first = queue.enqueue(shellJob("upload:a.mp3", "echo sent"),
+                                    [&](const TransferQueue::Result&) { ++calls; });
+    QVERIFY(queue.contains("upload:a.mp3"));
+    const int second = queue.enqueue(shellJob("upload:a.mp3", "echo sent"),
+                                     [&](const TransferQueue::Result& result) {
+                                         QCOMPARE(result.output, QString("sent"));
+                                         ++calls;
+                                     });
+    QCOMPARE(second, first);
+    QCOMPARE(queue.pendingCount(), 1);
+
+    QTRY_COMPARE(calls, 2);
+    QCOMPARE(started.count(), 1);
+    QVERIFY(!queue.contains("upload:a.mp3"));
+
+    // Once finished, the same key runs again
+    QVERIFY(queue.enqueue(shellJob("upload:a.mp3", "true")) != first);
+}
+
+void TestTransferQueue::testRetryUntilSuccess()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString marker = dir.filePath("tried");
+
+    TransferQueue queue;
+    queue.setRetryDelay(10);
+    QSignalSpy retrying(&queue, &TransferQueue::jobRetrying);
+
+    TransferQueue::Result result;
+    bool done = false;
+    queue.enqueue(shellJob("flaky", QString("test -f '%1' || { touch '%1'; exit 1; }").arg(marker)),
+                  [&](const TransferQueue::Result& r) {
+                      result = r;
+                      done = true;
+                  });
+    QTRY_VERIFY(done);
+    QVERIFY(result.ok);
+    QCOMPARE(result.attempts, 2);
+    QCOMPARE(retrying.count(), 1);
+}
+
+void TestTransferQueue::testRetryGivesUp()
+{
+    TransferQueue queue;
+    queue.setRetryDelay(10);
+    QSignalSpy retrying(&queue, &TransferQueue::jobRetrying);
+
+    TransferQueue::Job job = shellJob("broken", "exit 4");
+    job.maxAttempts = 3;
+    TransferQueue::Result result;
+    bool done = false;
+    queue.enqueue(job, [&](const TransferQueue::Result& r) {
+        result = r;
+        done = true;
+    });
+    QTRY_VERIFY(done);
+    QVERIFY(!result.ok);
+    QCOMPARE(result.attempts, 3);
+    QCOMPARE(result.exitCode, 4);
+    QVERIFY(result.error.contains("4"));
+    QCOMPARE(retrying.count(), 2);
+}
+
+void TestTransferQueue::testValidatorAndTimeout()
+{
+    TransferQueue queue;
+
+    TransferQueue::Job job = shellJob("validated", "echo nope");
+    job.maxAttempts = 1;
+    job.validate = [](const TransferQueue::Result& result) { return result.output.contains("Transfer complete"); };
+    TransferQueue::Result validated;
+    bool validatedDone = false;
+    queue.enqueue(job, [&](const TransferQueue::Result& r) {
+        validated = r;
+        validatedDone = true;
+    });
+
+    TransferQueue::Job slow = shellJob("slow", "sleep 30");
+    slow.maxAttempts = 1;
+    slow.timeoutMs = 100;
+    TransferQueue::Result timedOut;
+    bool timedOutDone = false;
+    queue.enqueue(slow, [&](const TransferQueue::Result& r) {
+        timedOut = r;
+        timedOutDone = true;
+    });
+
+    QTRY_VERIFY(validatedDone);
+    QVERIFY(!validated.ok);
+    QCOMPARE(validated.exitCode, 0);
+    QCOMPARE(validated.output, QString("nope"));
+
+    QTRY_VERIFY_WITH_TIMEOUT(timedOutDone, 5000);
+    QVERIFY(!timedOut.ok);
+    QVERIFY(timedOut.error.startsWith("Timed out"));
+}
+
+void TestTransferQueue::testFailedToStart()
+{
+    TransferQueue queue;
+    TransferQueue::Job job;
+    job.program = "/nonexistent/xfb-upload-script";
+    job.maxAttempts = 1;
+
+    TransferQueue::Result result;
+    bool done = false;
+    queue.enqueue(job, [&](const TransferQueue::Result& r) {
+        result = r;
+        done = true;
+    });
+    QTRY_VERIFY(done);
+    QVERIFY(!result.ok);
+    QVERIFY(!result.error.isEmpty());
+    QCOMPARE(queue.runningCount(), 0);
+}
+
+void TestTransferQueue::testBatchProgressAndCancel()
+{
+    TransferQueue queue;
+    queue.setMaxConcurrent(1);
+    QSignalSpy progress(&queue, &TransferQueue::progressChanged);
+    QSignalSpy drained(&queue, &TransferQueue::drained);
+
+    queue.enqueue(shellJob("one", "true"));
+    queue.enqueue(shellJob("two", "sleep 0.1"));
+    const int waiting = queue.enqueue(shellJob("three", "true"));
+    QCOMPARE(progress.last().at(1).toInt(), 3);
+
+    TransferQueue::Result cancelled;
+    queue.enqueue(shellJob("three", "true"), [&](const TransferQueue::Result& r) { cancelled = r; });
+    queue.cancel(waiting);
+    QVERIFY(!cancelled.ok);
+    QCOMPARE(cancelled.error, QString("Cancelled"));
+    QCOMPARE(cancelled.attempts, 0);
+
+    QTRY_COMPARE(drained.count(), 1);
+    QCOMPARE(drained.first().at(0).toInt(), 2);
+    QCOMPARE(drained.first().at(1).toInt(), 1);
+    QCOMPARE(progress.last().at(0).toInt(), 3);
+    QCOMPARE(progress.last().at(1).toInt(), 3);
+
+    // A new batch counts from zero
+    queue.enqueue(shellJob("four", "true"));
+    QCOMPARE(progress.last().at(0).toInt(), 0);
+    QCOMPARE(progress.last().at(1).toInt(), 1);
+    QTRY_COMPARE(drained.count(), 2);
+}
+
+QTEST_MAIN(TestTransferQueue)
@@ -0,0 +1,31 @@
+#ifndef TESTTRANSFERQUEUE_H
+#define TESTTRANSFERQUEUE_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for TransferQueue class
+ *
+ * Tests the bounded transfer job queue including:
+ * - The concurrency limit
+ * - Deduplication of jobs with the same key
+ * - Retries of failed jobs, up to the attempt limit
+ * - Output validation, timeouts and programs that do not start
+ * - Batch progress and cancellation
+ */
+class TestTransferQueue : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testConcurrencyLimit();
+    void testDuplicateKeysRunOnce();
+    void testRetryUntilSuccess();
+    void testRetryGivesUp();
+    void testValidatorAndTimeout();
+    void testFailedToStart();
+    void testBatchProgressAndCancel();
+};
+
+#endif // TESTTRANSFERQUEUE_H
@@ -0,0 +1,240 @@
+#include "TestSyntheticLibrary.h"
+#include "../../../src/tools/genlib/SyntheticLibrary.h"
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+#include <QtEndian>
+#include <algorithm>
+
+namespace {
+
+const char* CONNECTION_NAME = "test_synthetic_library";
+
+SyntheticLibrary::Options options(int tracks)
+{
+    SyntheticLibrary::Options options;
+    options.tracks = tracks;
+    options.root = "/library";
+    return options;
+}
+
+int count(QSqlDatabase& database, const QString& sql)
+{
+    QSqlQuery query(database);
+    return query.exec(sql) && query.next() ? query.value(0).toInt() : -1;
+}
+
+} // namespace
+
+void TestSyntheticLibrary::testDeterministic()
+{
+    const SyntheticLibrary first(options(1000));
+    const SyntheticLibrary second(options(1000));
+    for (int index : {0, 1, 499, 999}) {
+        const SyntheticLibrary::Track a = first.track(index);
+        const SyntheticLibrary::Track b = second.track(index);
+        QCOMPARE(a.artist, b.artist);
+        QCOMPARE(a.genre1, b.genre1);
+        QCOMPARE(a.path, b.path);
+        QCOMPARE(a.time, b.time);
+        QCOMPARE(a.playedTimes, b.playedTimes);
+    }
+    QCOMPARE(first.track(7).song, SyntheticLibrary::songName(7));
+
+    SyntheticLibrary::Options reseeded = options(1000);
+    reseeded.seed = 1;
+    const SyntheticLibrary other(reseeded);
+    int differing = 0;
+    for (int index = 0; index < 100; ++index) {
+        differing += other.track(index).genre1 != first.track(index).genre1 ? 1 : 0;
+    }
+    QVERIFY(differing > 20);
+}
+
+void TestSyntheticLibrary::testDistributions()
+{
+    const int tracks = 20000;
+    const SyntheticLibrary library(options(tracks));
+    QCOMPARE(library.artistCount(), tracks / SyntheticLibrary::TRACKS_PER_ARTIST);
+
+    QHash<QString, int> perArtist;
+    QHash<QString, int> perGenre;
+    int inArtistGenre = 0;
+    int untagged = 0;
+    for (int index = 0; index < tracks; ++index) {
+        const SyntheticLibrary::Track track = library.track(index);
+        ++perArtist[track.artist];
+        ++perGenre[track.genre1];
+        const int artist = track.artist.section(' ', 1).toInt();
+        inArtistGenre += track.genre1 == library.artistGenre(artist) ? 1 : 0;
+        untagged += track.tagged ? 0 : 1;
+        QVERIFY(track.path.startsWith("/library/music/" + track.genre1 + '/' + track.artist + '/'));
+        QVERIFY(!track.time.isEmpty());
+        QVERIFY(track.playedTimes >= 0 && track.playedTimes < SyntheticLibrary::MAX_PLAYS);
+        QCOMPARE(track.lastPlayed.isEmpty(), track.playedTimes == 0);
+    }
+
+    // Every artist has a track, and a few have most of them
+    QCOMPARE(perArtist.size(), library.artistCount());
+    QList<int> sizes = perArtist.values();
+    std::sort(sizes.begin(), sizes.end(), std::greater<int>());
+    QVERIFY(sizes.first() > 50 * sizes.at(sizes.size() / 2));
+
+    QCOMPARE(perGenre.size(), SyntheticLibrary::genres().size());
+    QVERIFY(inArtistGenre > tracks * 3 / 4);
+    QVERIFY(untagged > tracks / 20 && untagged < tracks * 3 / 20);
+
+    // Without skew the tracks spread evenly, and the genres follow their weights
+    SyntheticLibrary::Options even = options(tracks);
+    even.artistSkew = 0;
+    const SyntheticLibrary flat(even);
+    perArtist.clear();
+    perGenre.clear();
+    for (int index = 0; index < tracks; ++index) {
+        const SyntheticLibrary::Track track = flat.track(index);
+        ++perArtist[track.artist];
+        ++perGenre[track.genre1];
+    }
+    sizes = perArtist.values();
+    QVERIFY(*std::max_element(sizes.cbegin(), sizes.cend()) < 40);
+    QVERIFY(perGenre.value("Rock") + perGenre.value("Pop") > tracks * 3 / 10);
+    QVERIFY(perGenre.value("Rock") > 4 * perGenre.value("Punk"));
+}
+
+void TestSyntheticLibrary::testWriteMusic()
+{
+    {
+        QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", CONNECTION_NAME);
+        database.setDatabaseName(":memory:");
+        QVERIFY(database.open());
+        QSqlQuery query(database);
+        QVERIFY(query.exec("CREATE TABLE musics (id INTEGER PRIMARY KEY AUTOINCREMENT, "
+                           "artist TEXT, song TEXT, genre1 TEXT, genre2 TEXT, country TEXT, "
+                           "published_date TEXT, path TEXT, time TEXT, played_times INTEGER, "
+                           "last_played TEXT)"));
+        QVERIFY(query.exec("CREATE TABLE genres1 (id INTEGER PRIMARY KEY AUTOINCREMENT, "
+                           "name TEXT)"));
+        QVERIFY(query.exec("INSERT INTO genres1 (name) VALUES ('Rock')"));
+
+        const int tracks = SyntheticLibrary::COMMIT_ROWS + 500;
+        const SyntheticLibrary library(options(tracks));
+        QString error;
+        QVERIFY2(library.writeMusic(database, &error), qPrintable(error));
+
+        QCOMPARE(count(database, "SELECT COUNT(*) FROM musics"), tracks);
+        QCOMPARE(count(database, "SELECT COUNT(*) FROM genres1"),
+                 int(SyntheticLibrary::genres().size()));
+
+        QVERIFY(query.exec("SELECT artist, song, genre1, path, time, played_times FROM musics "
+                           "WHERE id = 10301"));
+        QVERIFY(query.next());
+        const SyntheticLibrary::Track track = library.track(10300);
+        QCOMPARE(query.value(0).toString(), track.artist);
+        QCOMPARE(query.value(1).toString(), track.song);
+        QCOMPARE(query.value(2).toString(), track.genre1);
+        QCOMPARE(query.value(3).toString(), track.path);
+        QCOMPARE(query.value(4).toString(), track.time);
+        QCOMPARE(query.value(5).toInt(), track.playedTimes);
+        database.close();
+    }
+    QSqlDatabase::removeDatabase(CONNECTION_NAME);
+}
+
+void TestSyntheticLibrary::testStubFiles()
+{
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+
+    SyntheticLibrary::Options mp3 = options(200);
+    mp3.root = directory.filePath("mp3");
+    const SyntheticLibrary library(mp3);
+    QString error;
+    QVERIFY2(library.writeFiles(&error), qPrintable(error));
+
+    const QByteArray audio = SyntheticLibrary::audioStub(SyntheticLibrary::Audio::Mp3, mp3.stubMs);
+    QCOMPARE(audio.size() % 417, 0);
+    QCOMPARE(audio.size() / 417, 39);   // 1152 samples at 44.1 kHz a frame, 1 s rounded up
+    for (int index : {0, 1, 2, 150}) {
+        const SyntheticLibrary::Track track = library.track(index);
+        QFile file(track.path);
+        QVERIFY2(file.open(QIODevice::ReadOnly), qPrintable(track.path));
+        const QByteArray bytes = file.readAll();
+        QVERIFY(bytes.startsWith(QByteArray::fromHex("fffb90")));
+        if (track.tagged) {
+            QCOMPARE(bytes.size(), audio.size() + 128);
+            QCOMPARE(bytes.mid(audio.size(), 3), QByteArray("TAG"));
+            QCOMPARE(bytes.mid(audio.size() + 33, track.artist.size()), track.artist.toLatin1());
+        } else {
+            QCOMPARE(bytes.size(), audio.size());
+            QVERIFY(track.path.endsWith(track.artist + " - " + track.song + ".mp3"));
+        }
+    }
+    QVERIFY(QFile::exists(QDir(mp3.root).filePath("pub/spot_20.mp3")));
+    QVERIFY(QFile::exists(QDir(mp3.root).filePath("programs/show_4.mp3")));
+
+    SyntheticLibrary::Options wav = options(10);
+    wav.root = directory.filePath("wav");
+    wav.audio = SyntheticLibrary::Audio::Wav;
+    wav.stubMs = 250;
+    const SyntheticLibrary wavLibrary(wav);
+    QVERIFY2(wavLibrary.writeFiles(&error), qPrintable(error));
+    QFile file(wavLibrary.track(3).path);
+    QVERIFY(file.fileName().endsWith(" - " + SyntheticLibrary::songName(3) + ".wav"));
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QByteArray bytes = file.readAll();
+    QCOMPARE(bytes.left(4), QByteArray("RIFF"));
+    QCOMPARE(qFromLittleEndian<quint32>(bytes.constData() + 4), quint32(bytes.size() - 8));
+    QCOMPARE(bytes.mid(8, 8), QByteArray("WAVEfmt "));
+    QCOMPARE(qFromLittleEndian<quint32>(bytes.constData() + 40), quint32(2000));
+
+    // Rows only
+    SyntheticLibrary::Options none = options(10);
+    none.root = directory.filePath("none");
+    none.audio = SyntheticLibrary::Audio::None;
+    QVERIFY(SyntheticLibrary(none).writeFiles());
+    QVERIFY(!QDir(none.root).exists());
+}
+
+void TestSyntheticLibrary::testScheduleAndHourGenres()
+{
+    {
+        QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", CONNECTION_NAME);
+        database.setDatabaseName(":memory:");
+        QVERIFY(database.open());
+        QSqlQuery query(database);
+        for (const char* table : {"pub", "programs"}) {
+            QVERIFY(query.exec(QString("CREATE TABLE %1 (id INTEGER PRIMARY KEY AUTOINCREMENT, "
+                                       "name TEXT, path TEXT)")
+                                   .arg(table)));
+        }
+        QVERIFY(query.exec("CREATE TABLE scheduler (id INTEGER, ano INTEGER, mes INTEGER, "
+                           "dia INTEGER, hora INTEGER, min INTEGER, tipo INTEGER, week_day TEXT, "
+                           "start_ano INTEGER, start_mes INTEGER, start_dia INTEGER, "
+                           "end_ano INTEGER, end_mes INTEGER, end_dia INTEGER, is_program NULL)"));
+        QVERIFY(query.exec("CREATE TABLE hourgenre (id INTEGER PRIMARY KEY AUTOINCREMENT, "
+                           "day TEXT, hour TEXT, genre TEXT)"));
+
+        const SyntheticLibrary library(options(100));
+        QString error;
+        QVERIFY2(library.writeSchedule(database, &error), qPrintable(error));
+        QCOMPARE(count(database, "SELECT COUNT(*) FROM pub"), 20);
+        QCOMPARE(count(database, "SELECT COUNT(*) FROM programs"), 4);
+        // Two pubs an hour and a program every third hour, every day
+        QCOMPARE(count(database, "SELECT COUNT(*) FROM scheduler"), 7 * (24 * 2 + 8));
+        QCOMPARE(count(database, "SELECT COUNT(*) FROM scheduler WHERE is_program = '1'"), 7 * 8);
+        QCOMPARE(count(database, "SELECT COUNT(*) FROM scheduler WHERE id NOT IN "
+                                 "(SELECT id FROM pub) AND is_program = '0'"), 0);
+
+        QVERIFY2(library.writeHourGenres(database, &error), qPrintable(error));
+        QVERIFY(library.writeHourGenres(database, &error));
+        QCOMPARE(count(database, "SELECT COUNT(*) FROM hourgenre"), 7 * 24);
+        QCOMPARE(count(database, "SELECT COUNT(DISTINCT day || ':' || hour) FROM hourgenre"),
+                 7 * 24);
+        database.close();
+    }
+    QSqlDatabase::removeDatabase(CONNECTION_NAME);
+}
+
+QTEST_MAIN(TestSyntheticLibrary)
@@ -0,0 +1,29 @@
+#ifndef TESTSYNTHETICLIBRARY_H
+#define TESTSYNTHETICLIBRARY_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for SyntheticLibrary class
+ *
+ * Tests the synthetic library generator including:
+ * - The same tracks from the same seed, other tracks from another
+ * - Every artist used, few artists with many tracks, genres by weight
+ * - Rows written to the musics table matching track()
+ * - MP3 and WAV stubs with valid headers, tagged and untagged
+ * - A week of scheduler rules and hour genres
+ */
+class TestSyntheticLibrary : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testDeterministic();
+    void testDistributions();
+    void testWriteMusic();
+    void testStubFiles();
+    void testScheduleAndHourGenres();
+};
+
+#endif // TESTSYNTHETICLIBRARY_H
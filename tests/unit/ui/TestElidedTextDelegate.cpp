@@ -0,0 +1,104 @@
+#include "TestElidedTextDelegate.h"
+#include "../../../src/ui/ElidedTextDelegate.h"
+#include <QHeaderView>
+#include <QImage>
+#include <QPainter>
+#include <QStandardItemModel>
+#include <QTableView>
+
+namespace {
+
+void paintCell(const ElidedTextDelegate& delegate, const QModelIndex& index, int width,
+               const QFont& font = QFont())
+{
+    QImage image(400, 40, QImage::Format_ARGB32_Premultiplied);
+    QPainter painter(&image);
+    QStyleOptionViewItem option;
+    option.rect = QRect(0, 0, width, 24);
+    option.font = font;
+    option.fontMetrics = QFontMetrics(font);
+    option.state = QStyle::State_Enabled | QStyle::State_Active;
+    delegate.paint(&painter, option, index);
+}
+
+} // namespace
+
+void TestElidedTextDelegate::testRepaintHitsCache()
+{
+    QStandardItemModel model(2, 2);
+    model.setData(model.index(0, 0), "Artist 000001");
+    model.setData(model.index(1, 1), "Song 42");
+    ElidedTextDelegate delegate;
+
+    paintCell(delegate, model.index(0, 0), 200);
+    paintCell(delegate, model.index(1, 1), 200);
+    QCOMPARE(delegate.statistics().misses, qint64(2));
+    QCOMPARE(delegate.cachedCells(), 2);
+
+    paintCell(delegate, model.index(0, 0), 200);
+    paintCell(delegate, model.index(1, 1), 200);
+    QCOMPARE(delegate.statistics().hits, qint64(2));
+    QCOMPARE(delegate.statistics().misses, qint64(2));
+
+    // Empty cells are drawn without a layout
+    paintCell(delegate, model.index(0, 1), 200);
+    QCOMPARE(delegate.cachedCells(), 2);
+}
+
+void TestElidedTextDelegate::testChangesLayOutAgain()
+{
+    QStandardItemModel model(1, 1);
+    model.setData(model.index(0, 0), "A title long enough to be elided in a narrow column");
+    ElidedTextDelegate delegate;
+
+    paintCell(delegate, model.index(0, 0), 300);
+    paintCell(delegate, model.index(0, 0), 60);
+    QCOMPARE(delegate.statistics().misses, qint64(2));
+
+    model.setData(model.index(0, 0), "Another title");
+    paintCell(delegate, model.index(0, 0), 60);
+    QCOMPARE(delegate.statistics().misses, qint64(3));
+
+    QFont bold;
+    bold.setBold(true);
+    paintCell(delegate, model.index(0, 0), 60, bold);
+    QCOMPARE(delegate.statistics().misses, qint64(4));
+    QCOMPARE(delegate.cachedCells(), 1);
+    QCOMPARE(delegate.statistics().hits, qint64(0));
+
+    delegate.clearCache();
+    QCOMPARE(delegate.cachedCells(), 0);
+}
+
+void TestElidedTextDelegate::testCacheIsBounded()
+{
+    const int rows = ElidedTextDelegate::MAX_CACHED_CELLS + 10;
+    QStandardItemModel model(rows, 1);
+    for (int row = 0; row < rows; ++row) {
+        model.setData(model.index(row, 0), QString("Song %1").arg(row));
+    }
+    ElidedTextDelegate delegate;
+
+    for (int row = 0; row < rows; ++row) {
+        paintCell(delegate, model.index(row, 0), 120);
+    }
+    QVERIFY(delegate.cachedCells() <= ElidedTextDelegate::MAX_CACHED_CELLS);
+    QCOMPARE(delegate.cachedCells(), 10);
+}
+
+void TestElidedTextDelegate::testInstallFixesRowHeight()
+{
+    QStandardItemModel model(3, 2);
+    QTableView view;
+    view.setModel(&model);
+    ElidedTextDelegate* delegate = ElidedTextDelegate::install(&view);
+
+    QCOMPARE(view.itemDelegate(), delegate);
+    QVERIFY(!view.wordWrap());
+    QCOMPARE(view.verticalHeader()->sectionResizeMode(0), QHeaderView::Fixed);
+    QCOMPARE(view.verticalHeader()->defaultSectionSize(),
+             ElidedTextDelegate::rowHeight(view.font()));
+    QCOMPARE(view.rowHeight(2), ElidedTextDelegate::rowHeight(view.font()));
+}
+
+QTEST_MAIN(TestElidedTextDelegate)
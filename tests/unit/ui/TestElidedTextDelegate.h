@@ -0,0 +1,27 @@
+#ifndef TESTELIDEDTEXTDELEGATE_H
+#define TESTELIDEDTEXTDELEGATE_H
+
+#include <QObject>
+#include <QTest>
+
+/**
+ * @brief Unit tests for ElidedTextDelegate class
+ *
+ * Tests the cached text layout delegate including:
+ * - Drawing a cell again from its cached layout
+ * - Laying a cell out again when its text, width or font changes
+ * - Emptying the cache once it holds MAX_CACHED_CELLS cells
+ * - Fixed, uniform row heights on an installed view
+ */
+class TestElidedTextDelegate : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testRepaintHitsCache();
+    void testChangesLayOutAgain();
+    void testCacheIsBounded();
+    void testInstallFixesRowHeight();
+};
+
+#endif // TESTELIDEDTEXTDELEGATE_H